@@ -129,6 +129,12 @@ REPOSITORY_LOCATIONS = dict(
         commit = "6a4fec616ec4b20f54d5fb530808b855cb664390",
         remote = "https://github.com/google/protobuf",
     ),
+    com_googlesource_code_re2 = dict(
+        # The archive is not verified until its sha256 is pinned here.
+        sha256 = "",
+        strip_prefix = "re2-2018-10-01",
+        urls = ["https://github.com/google/re2/archive/2018-10-01.tar.gz"],
+    ),
     grpc_httpjson_transcoding = dict(
         commit = "05a15e4ecd0244a981fdf0348a76658def62fa9c",  # 2018-05-30
         remote = "https://github.com/grpc-ecosystem/grpc-httpjson-transcoding",
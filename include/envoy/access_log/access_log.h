@@ -80,6 +80,18 @@ public:
                              const Http::HeaderMap& response_headers,
                              const Http::HeaderMap& response_trailers,
                              const RequestInfo::RequestInfo& request_info) const PURE;
+
+  /**
+   * Appends the formatted output to a buffer. Formatters should override it to write directly into
+   * the buffer rather than building an intermediate string.
+   * @param output supplies the buffer to append to.
+   */
+  virtual void formatTo(const Http::HeaderMap& request_headers,
+                        const Http::HeaderMap& response_headers,
+                        const Http::HeaderMap& response_trailers,
+                        const RequestInfo::RequestInfo& request_info, std::string& output) const {
+    output += format(request_headers, response_headers, response_trailers, request_info);
+  }
 };
 
 typedef std::unique_ptr<Formatter> FormatterPtr;
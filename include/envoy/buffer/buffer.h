@@ -46,6 +46,12 @@ protected:
   virtual ~BufferFragment() {}
 };
 
+/**
+ * An opaque reference that keeps the memory of a buffer slice alive, even after the slice's content
+ * has been drained from the buffer.
+ */
+typedef std::shared_ptr<const void> SliceReferenceSharedPtr;
+
 /**
  * A basic buffer abstraction.
  */
@@ -79,6 +85,15 @@ public:
    */
   virtual void add(const Instance& data) PURE;
 
+  /**
+   * Add the content of another buffer without copying it, by sharing the memory that holds it.
+   * The shared content becomes immutable in both buffers: content later added to either buffer is
+   * written to other memory. Content that can't be shared, such as that of buffer fragments, is
+   * copied.
+   * @param data supplies the buffer to share, which keeps its content.
+   */
+  virtual void addShared(Instance& data) PURE;
+
   /**
    * Prepend a string_view to the buffer.
    * @param data supplies the string_view to copy.
@@ -120,14 +135,7 @@ public:
    * @param out_size supplies the size of out.
    * @return the actual number of slices needed, which may be greater than out_size. Passing
    *         nullptr for out and 0 for out_size will just return the size of the array needed
-   *         to capture all of the slice data.
-   * TODO(mattklein123): WARNING: The underlying implementation of this function currently uses
-   * libevent's evbuffer. It has the infuriating property where calling getRawSlices(nullptr, 0)
-   * will return the slices that include all of the buffer data, but not any empty slices at the
-   * end. However, calling getRawSlices(iovec, SOME_CONST), WILL return potentially empty slices
-   * beyond the end of the buffer. Code that is trying to avoid stack overflow by limiting the
-   * number of returned slices needs to deal with this. When we get rid of evbuffer we can rework
-   * all of this.
+   *         to capture all of the slice data. Empty slices are never returned.
    */
   virtual uint64_t getRawSlices(RawSlice* out, uint64_t out_size) const PURE;
 
@@ -154,6 +162,17 @@ public:
    */
   virtual void move(Instance& rhs, uint64_t length) PURE;
 
+  /**
+   * Pin the memory holding a range of the buffer's content so that it stays valid after the range
+   * is drained. The memory stays writable by the buffer outside of the pinned content, so
+   * reserve() may continue to use any space left after it.
+   * @param data supplies the start of the range, which must come from getRawSlices().
+   * @param size supplies the length of the range.
+   * @return a reference that keeps the range alive, or nullptr if the range does not lie within
+   *         a single slice owned by the buffer.
+   */
+  virtual SliceReferenceSharedPtr pin(const void* data, uint64_t size) PURE;
+
   /**
    * Read from a file descriptor directly into the buffer.
    * @param fd supplies the descriptor to read from.
@@ -163,6 +182,13 @@ public:
    */
   virtual Api::SysCallIntResult read(int fd, uint64_t max_length) PURE;
 
+  /**
+   * Free the empty slices at the end of the buffer, which are otherwise kept so that later
+   * reservations and reads can reuse their storage. Must not be called while a reservation is
+   * outstanding.
+   */
+  virtual void releaseEmptySlices() PURE;
+
   /**
    * Reserve space in the buffer.
    * @param length supplies the amount of space to reserve.
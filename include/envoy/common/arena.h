@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include "envoy/common/pure.h"
+
+namespace Envoy {
+
+/**
+ * A region of memory that objects are allocated from and that is released all at once when the
+ * arena is destroyed. Individual allocations are never freed, so objects allocated from an arena must
+ * be destroyed before it.
+ */
+class Arena {
+public:
+  virtual ~Arena() {}
+
+  /**
+   * @param size supplies the number of bytes to allocate.
+   * @param alignment supplies the required alignment, which must be a power of two.
+   * @return void* the allocated memory, valid until the arena is destroyed.
+   */
+  virtual void* allocate(size_t size, size_t alignment) PURE;
+};
+
+/**
+ * Standard allocator backed by an Arena, e.g. for std::allocate_shared(). Deallocation is a no-op;
+ * the memory is released with the arena.
+ */
+template <class T> class ArenaAllocator {
+public:
+  typedef T value_type;
+
+  explicit ArenaAllocator(Arena& arena) : arena_(&arena) {}
+  template <class U> ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.arena_) {}
+
+  T* allocate(size_t n) { return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T))); }
+  void deallocate(T*, size_t) {}
+
+  template <class U> bool operator==(const ArenaAllocator<U>& other) const {
+    return arena_ == other.arena_;
+  }
+  template <class U> bool operator!=(const ArenaAllocator<U>& other) const {
+    return arena_ != other.arena_;
+  }
+
+private:
+  template <class U> friend class ArenaAllocator;
+
+  Arena* arena_;
+};
+
+/**
+ * @param arena supplies the arena to allocate from, or nullptr to allocate from the heap.
+ * @return std::shared_ptr<T> a new T, together with its control block, allocated from arena.
+ */
+template <class T, class... Args>
+std::shared_ptr<T> makeSharedInArena(Arena* arena, Args&&... args) {
+  if (arena == nullptr) {
+    return std::make_shared<T>(std::forward<Args>(args)...);
+  }
+  return std::allocate_shared<T>(ArenaAllocator<T>(*arena), std::forward<Args>(args)...);
+}
+
+} // namespace Envoy
@@ -23,6 +23,20 @@ public:
   virtual void onConfigUpdate(const Protobuf::RepeatedPtrField<ProtobufWkt::Any>& resources,
                               const std::string& version_info) PURE;
 
+  /**
+   * Called when an incremental configuration update is received, which only carries the resources
+   * that changed.
+   * @param added_resources vector of the resources that were added or updated.
+   * @param removed_resources names of the resources that were removed.
+   * @param system_version_info version of the update, for debugging purposes only.
+   * @throw EnvoyException with reason if the configuration is rejected. Otherwise the configuration
+   *        is accepted.
+   */
+  virtual void onIncrementalConfigUpdate(
+      const Protobuf::RepeatedPtrField<ProtobufWkt::Any>& added_resources,
+      const Protobuf::RepeatedPtrField<ProtobufTypes::String>& removed_resources,
+      const std::string& system_version_info) PURE;
+
   /**
    * Called when either the subscription is unable to fetch a config update or when onConfigUpdate
    * invokes an exception.
@@ -29,6 +29,21 @@ public:
   virtual void onConfigUpdate(const ResourceVector& resources,
                               const std::string& version_info) PURE;
 
+  /**
+   * Called when an incremental configuration update is received, which only carries the resources
+   * that changed since the previous update, rather than all the resources.
+   * @param added_resources vector of the resources that were added or updated.
+   * @param removed_resources names of the resources that were removed.
+   * @param system_version_info version of the update, as supplied by the xDS discovery response for
+   *        debugging purposes.
+   * @throw EnvoyException with reason if the configuration is rejected. Otherwise the configuration
+   *        is accepted.
+   */
+  virtual void onIncrementalConfigUpdate(
+      const ResourceVector& added_resources,
+      const Protobuf::RepeatedPtrField<ProtobufTypes::String>& removed_resources,
+      const std::string& system_version_info) PURE;
+
   /**
    * Called when either the Subscription is unable to fetch a config update or when onConfigUpdate
    * invokes an exception.
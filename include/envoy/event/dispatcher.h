@@ -1,7 +1,9 @@
 #pragma once
 
+#include <chrono>
 #include <cstdint>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <string>
 #include <vector>
@@ -17,10 +19,33 @@
 #include "envoy/network/listen_socket.h"
 #include "envoy/network/listener.h"
 #include "envoy/network/transport_socket.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
 
 namespace Envoy {
 namespace Event {
 
+/**
+ * All dispatcher stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_DISPATCHER_STATS(COUNTER, HISTOGRAM)                                                   \
+  COUNTER  (loop_stalls)                                                                           \
+  HISTOGRAM(loop_duration_us)                                                                      \
+  HISTOGRAM(post_callbacks_us)                                                                     \
+  HISTOGRAM(file_events_us)                                                                        \
+  HISTOGRAM(timers_us)                                                                             \
+  HISTOGRAM(deferred_delete_us)                                                                    \
+  HISTOGRAM(deferred_delete_queue_depth)
+// clang-format on
+
+/**
+ * Struct definition for all dispatcher stats. @see stats_macros.h
+ */
+struct DispatcherStats {
+  ALL_DISPATCHER_STATS(GENERATE_COUNTER_STRUCT, GENERATE_HISTOGRAM_STRUCT)
+};
+
 /**
  * Callback invoked when a dispatcher post() runs.
  */
@@ -38,6 +63,19 @@ public:
    */
   virtual TimeSystem& timeSystem() PURE;
 
+  /**
+   * Record how long each iteration of the event loop takes, and how much of it is spent in post
+   * callbacks, file events, timers and deferred deletion. Must be called before the dispatcher
+   * runs. File events and timers created before this is called are not accounted for.
+   * @param scope supplies the scope to create the stats in.
+   * @param prefix supplies the prefix of the stat names, e.g. "worker_0.".
+   * @param stall_threshold supplies the iteration duration above which an iteration is counted as
+   *        a stall and logged along with the callback that took the longest. Zero disables stall
+   *        detection.
+   */
+  virtual void initializeStats(Stats::Scope& scope, const std::string& prefix,
+                               std::chrono::milliseconds stall_threshold) PURE;
+
   /**
    * Clear any items in the deferred deletion queue.
    */
@@ -103,17 +141,33 @@ public:
    * @param bind_to_port controls whether the listener binds to a transport port or not.
    * @param hand_off_restored_destination_connections controls whether the listener searches for
    *        another listener after restoring the destination address of a new connection.
+   * @param max_accepts_per_wakeup supplies the maximum number of connections accepted each time
+   *        the listen socket becomes readable. Connections left in the accept queue are accepted
+   *        on the next event loop iteration.
    * @return Network::ListenerPtr a new listener that is owned by the caller.
    */
-  virtual Network::ListenerPtr createListener(Network::Socket& socket,
-                                              Network::ListenerCallbacks& cb, bool bind_to_port,
-                                              bool hand_off_restored_destination_connections) PURE;
+  virtual Network::ListenerPtr
+  createListener(Network::Socket& socket, Network::ListenerCallbacks& cb, bool bind_to_port,
+                 bool hand_off_restored_destination_connections,
+                 uint32_t max_accepts_per_wakeup = std::numeric_limits<uint32_t>::max()) PURE;
+
+  /**
+   * Create a listener on a bound datagram socket.
+   * @param socket supplies the socket to receive on.
+   * @param cb supplies the callbacks to invoke for listener events.
+   * @return Network::UdpListenerPtr a new listener that is owned by the caller.
+   */
+  virtual Network::UdpListenerPtr createUdpListener(Network::Socket& socket,
+                                                    Network::UdpListenerCallbacks& cb) PURE;
 
   /**
    * Allocate a timer. @see Timer for docs on how to use the timer.
    * @param cb supplies the callback to invoke when the timer fires.
+   * @param precision supplies how closely the timer needs to track its timeouts. Coarse timers
+   *        are only distinguished from precise ones when the dispatcher has a timer wheel.
    */
-  virtual Event::TimerPtr createTimer(TimerCb cb) PURE;
+  virtual Event::TimerPtr createTimer(TimerCb cb,
+                                      TimerPrecision precision = TimerPrecision::Precise) PURE;
 
   /**
    * Submit an item for deferred delete. @see DeferredDeletable.
@@ -141,6 +195,14 @@ public:
    */
   virtual void post(PostCb callback) PURE;
 
+  /**
+   * Post several functors to the dispatcher at once. This is safe cross thread. The functors run
+   * in order in the context of the dispatcher event loop, and the dispatcher is woken at most once
+   * for the whole batch.
+   * @param callbacks supplies the functors to run. The vector is left empty.
+   */
+  virtual void postBatch(std::vector<PostCb>&& callbacks) PURE;
+
   /**
    * Run the event loop. This will not return until exit() is called either from within a callback
    * or from a different thread.
@@ -19,6 +19,18 @@ class TimerCB;
  */
 typedef std::function<void()> TimerCb;
 
+/**
+ * How closely a timer needs to track its requested timeout.
+ */
+enum class TimerPrecision {
+  // The timer fires as soon as possible after its timeout expires.
+  Precise,
+  // The timer may fire up to the dispatcher's coarse timer resolution after its timeout expires,
+  // in exchange for cheaper arming and disarming. Suited to idle and request timeouts, which are
+  // re-armed often and rarely fire.
+  Coarse
+};
+
 /**
  * An abstract timer event. Free the timer to unregister any pending timeouts.
  */
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <chrono>
 #include <cstdint>
 #include <limits>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "envoy/buffer/buffer.h"
 #include "envoy/common/pure.h"
@@ -198,6 +201,15 @@ struct Http1Settings {
   bool accept_http_10_{false};
   // Set a default host if no Host: header is present for HTTP/1.0 requests.`
   std::string default_host_for_http_10_;
+  // Scan complete request header blocks with the vectorized header block scanner and only hand
+  // the request line and framing headers to http_parser. Server connections only.
+  bool fast_header_parsing_{false};
+  // The number of pipelined requests that are decoded and processed ahead of their responses on a
+  // downstream connection, including the one being responded to. 1 processes one at a time.
+  uint32_t max_pipelined_requests_{1};
+  // Hold back the response headers and body chunks which more of the response follows until the
+  // end of the dispatch or event loop iteration, so that they are written together with it.
+  bool coalesce_response_writes_{false};
 };
 
 /**
@@ -210,6 +222,20 @@ struct Http2Settings {
   uint32_t initial_stream_window_size_{DEFAULT_INITIAL_STREAM_WINDOW_SIZE};
   uint32_t initial_connection_window_size_{DEFAULT_INITIAL_CONNECTION_WINDOW_SIZE};
   bool allow_connect_{DEFAULT_ALLOW_CONNECT};
+  // Hold back writes to the connection until this many bytes are pending, so that frames written
+  // in quick succession reach the socket together. 0 disables write coalescing.
+  uint32_t max_coalesced_write_bytes_{0};
+  // The longest time coalesced writes are held back.
+  std::chrono::milliseconds max_coalesced_write_delay_{0};
+  // Lower case names of the headers which are encoded without being added to the HPACK dynamic
+  // table, typically ones whose values rarely repeat.
+  std::vector<std::string> hpack_never_index_headers_;
+  // The bytes written to a downstream connection but not yet to the socket above which streams
+  // wait for their turn to send DATA frames. 0 disables stream scheduling.
+  uint32_t max_outbound_data_bytes_{0};
+  enum class StreamSchedulingPolicy { Weighted, RoundRobin, SmallestFirst };
+  // The order in which scheduled streams take turns.
+  StreamSchedulingPolicy stream_scheduling_policy_{StreamSchedulingPolicy::Weighted};
 
   // disable HPACK compression
   static const uint32_t MIN_HPACK_TABLE_SIZE = 0;
@@ -95,6 +95,13 @@ public:
    */
   virtual void drainConnections() PURE;
 
+  /**
+   * Open connections ahead of demand, up to the minimum pool size of the cluster's prefetch
+   * policy. Pools also prefetch on their own as streams are created, so this is only needed to
+   * warm a pool before its first stream.
+   */
+  virtual void prefetch() PURE;
+
   /**
    * Create a new stream on the pool.
    * @param response_decoder supplies the decoder events to fire when the response is
@@ -6,6 +6,7 @@
 #include <string>
 
 #include "envoy/access_log/access_log.h"
+#include "envoy/common/arena.h"
 #include "envoy/event/dispatcher.h"
 #include "envoy/http/codec.h"
 #include "envoy/http/header_map.h"
@@ -299,6 +300,17 @@ public:
    * @return the buffer limit the filter should apply.
    */
   virtual uint32_t decoderBufferLimit() PURE;
+
+  /**
+   * This routine may be called to have the request data buffered for decoder filters spill to a
+   * temporary file once it grows past a threshold, so that large bodies buffered up to the buffer
+   * limit are backed by the file rather than by memory.
+   *
+   * @param threshold supplies the number of bytes kept in memory. 0 disables spilling.
+   * @param directory supplies the directory to create the file in.
+   */
+  virtual void setDecoderBufferSpillThreshold(uint32_t threshold,
+                                              const std::string& directory) PURE;
 };
 
 /**
@@ -531,6 +543,14 @@ public:
    * @param handler supplies the handler to add.
    */
   virtual void addAccessLogHandler(AccessLog::InstanceSharedPtr handler) PURE;
+
+  /**
+   * @return Arena* an arena that is released when the stream is destroyed, or nullptr if the
+   *         connection manager is not configured with one. Filters allocated from it (e.g. with
+   *         makeSharedInArena()) must not be referenced once the stream has been destroyed, so
+   *         they must not hand shared pointers to themselves to anything that outlives the stream.
+   */
+  virtual Arena* arena() PURE;
 };
 
 /**
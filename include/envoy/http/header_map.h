@@ -10,8 +10,10 @@
 #include <unordered_set>
 #include <vector>
 
+#include "envoy/buffer/buffer.h"
 #include "envoy/common/pure.h"
 
+#include "common/common/ascii.h"
 #include "common/common/hash.h"
 
 #include "absl/strings/string_view.h"
@@ -21,29 +23,40 @@ namespace Http {
 
 /**
  * Wrapper for a lower case string used in header operations to generally avoid needless case
- * insensitive compares.
+ * insensitive compares. The hash of the string is computed once at construction so that header
+ * lookups with long lived keys do not rehash them.
  */
 class LowerCaseString {
 public:
-  LowerCaseString(LowerCaseString&& rhs) : string_(std::move(rhs.string_)) {}
-  LowerCaseString(const LowerCaseString& rhs) : string_(rhs.string_) {}
-  explicit LowerCaseString(const std::string& new_string) : string_(new_string) { lower(); }
+  LowerCaseString(LowerCaseString&& rhs) : string_(std::move(rhs.string_)), hash_(rhs.hash_) {}
+  LowerCaseString(const LowerCaseString& rhs) : string_(rhs.string_), hash_(rhs.hash_) {}
+  explicit LowerCaseString(const std::string& new_string) : string_(new_string) {
+    lower();
+    hash_ = HashUtil::xxHash64(string_);
+  }
 
   const std::string& get() const { return string_; }
+
+  /**
+   * @return uint64_t the xxHash64 of the string.
+   */
+  uint64_t hash() const { return hash_; }
+
   bool operator==(const LowerCaseString& rhs) const { return string_ == rhs.string_; }
   bool operator!=(const LowerCaseString& rhs) const { return string_ != rhs.string_; }
 
 private:
-  void lower() { std::transform(string_.begin(), string_.end(), string_.begin(), tolower); }
+  void lower() { AsciiUtil::toLowerCase(string_); }
 
   std::string string_;
+  uint64_t hash_;
 };
 
 /**
  * Lower case string hasher.
  */
 struct LowerCaseStringHash {
-  size_t operator()(const LowerCaseString& value) const { return HashUtil::xxHash64(value.get()); }
+  size_t operator()(const LowerCaseString& value) const { return value.hash(); }
 };
 
 /**
@@ -60,7 +73,7 @@ typedef std::unordered_set<LowerCaseString, LowerCaseStringHash> LowerCaseStrUno
  */
 class HeaderString {
 public:
-  enum class Type { Inline, Reference, Dynamic };
+  enum class Type { Inline, Reference, Dynamic, Pinned };
 
   /**
    * Default constructor. Sets up for inline storage.
@@ -81,12 +94,21 @@ public:
    */
   explicit HeaderString(const std::string& ref_value);
 
+  /**
+   * Constructor for a string referencing memory kept alive by an owner. Codecs use this to refer
+   * to header values in pinned slices of the buffer they were parsed from rather than copying them.
+   * @param ref_value supplies the string, which MUST be followed by a null terminator.
+   * @param owner supplies the reference that keeps ref_value alive. The string holds on to it
+   *        until the string's value is changed or the string is destroyed.
+   */
+  HeaderString(absl::string_view ref_value, Envoy::Buffer::SliceReferenceSharedPtr owner);
+
   HeaderString(HeaderString&& move_value);
   ~HeaderString();
 
   /**
-   * Append data to an existing string. If the string is a reference string the reference data is
-   * not copied.
+   * Append data to an existing string. If the string is a reference or pinned string the
+   * referenced data is copied first.
    */
   void append(const char* data, uint32_t size);
 
@@ -108,8 +130,8 @@ public:
   }
 
   /**
-   * Return the string to a default state. Reference strings are not touched. Both inline/dynamic
-   * strings are reset to zero size.
+   * Return the string to a default state. Reference and pinned strings are not touched. Both
+   * inline/dynamic strings are reset to zero size.
    */
   void clear();
 
@@ -140,6 +162,12 @@ public:
    */
   void setReference(const std::string& ref_value);
 
+  /**
+   * Set the value of the string to a string referencing memory kept alive by an owner. See the
+   * pinned string constructor for the requirements on ref_value.
+   */
+  void setPinned(absl::string_view ref_value, Envoy::Buffer::SliceReferenceSharedPtr owner);
+
   /**
    * @return the size of the string, not including the null terminator.
    */
@@ -166,9 +194,12 @@ private:
     char inline_buffer_[128];
     // Since this is a union, this is only valid for type_ == Type::Dynamic.
     uint32_t dynamic_capacity_;
+    // Only constructed for type_ == Type::Pinned.
+    Envoy::Buffer::SliceReferenceSharedPtr owner_;
   };
 
   void freeDynamic();
+  Envoy::Buffer::SliceReferenceSharedPtr releaseOwner();
 
   uint32_t string_length_;
   Type type_;
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+
+#include "envoy/common/pure.h"
+#include "envoy/http/header_map.h"
+#include "envoy/http/query_params.h"
+
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+namespace Http {
+
+/**
+ * Attributes of a request that are parsed out of its headers, such as its cookies and query
+ * parameters. Each attribute is parsed on first use and kept for the rest of the stream, so that
+ * the router, its hash policies and the filters of a stream share a single parse of the same
+ * headers. An attribute is parsed again if the headers it comes from changed since, e.g. because a
+ * filter rewrote the path.
+ */
+class RequestAttributes {
+public:
+  virtual ~RequestAttributes() {}
+
+  /**
+   * @param headers supplies the headers of the request.
+   * @return the path of the request without its query string, or an empty view if it has no path.
+   *         The view is into the headers.
+   */
+  virtual absl::string_view pathWithoutQuery(const HeaderMap& headers) PURE;
+
+  /**
+   * @param headers supplies the headers of the request.
+   * @return the query parameters of the path of the request, as Utility::parseQueryString() would
+   *         parse them. The reference is valid until the next call.
+   */
+  virtual const Utility::QueryParams& queryParams(const HeaderMap& headers) PURE;
+
+  /**
+   * @param headers supplies the headers of the request.
+   * @param name supplies the name of a cookie.
+   * @return the value of the cookie in the request as Utility::parseCookieValue() would return it,
+   *         i.e. the empty string if there is none. The reference is valid until the next call.
+   */
+  virtual const std::string& cookieValue(const HeaderMap& headers, const std::string& name) PURE;
+};
+
+} // namespace Http
+} // namespace Envoy
@@ -19,6 +19,13 @@ public:
    * client when there are errors establishing a connection to upstream server.
    */
   virtual void sendHeadersOnlyResponse(HeaderMap& headers) PURE;
+
+  /**
+   * Called once the upstream connection is established and the upgrade request has been sent on
+   * it. From then on no HTTP is spoken on the downstream connection, so the HTTP state which only
+   * served the upgrade request (e.g. the codec) may be released.
+   */
+  virtual void onWebSocketTunnelEstablished() PURE;
 };
 
 /**
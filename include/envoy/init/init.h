@@ -1,6 +1,7 @@
 #pragma once
 
 #include <functional>
+#include <string>
 
 #include "envoy/common/pure.h"
 
@@ -20,6 +21,12 @@ public:
    *        initialization.
    */
   virtual void initialize(std::function<void()> callback) PURE;
+
+  /**
+   * @return std::string the name of the target, e.g. "rds route_config_name", which identifies it
+   *         in the startup timeline.
+   */
+  virtual std::string name() const PURE;
 };
 
 /**
@@ -148,6 +148,17 @@ public:
    */
   virtual const Ip* ip() const PURE;
 
+  /**
+   * @return const sockaddr* the platform socket address, for calls that take a destination address
+   *         such as sendmsg(). It is valid for as long as this instance.
+   */
+  virtual const sockaddr* sockAddr() const PURE;
+
+  /**
+   * @return socklen_t the length of the socket address returned by sockAddr().
+   */
+  virtual socklen_t sockAddrLen() const PURE;
+
   /**
    * Create a socket for this address.
    * @param type supplies the socket type to create.
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -181,11 +182,51 @@ public:
    */
   virtual const Ssl::Connection* ssl() const PURE;
 
+  /**
+   * @return int the file descriptor of the connection's socket if its transport socket passes data
+   *         through unmodified, or -1 otherwise (e.g. TLS). A filter may move data to and from the
+   *         descriptor directly, bypassing the connection's buffers and filters, as long as it keeps
+   *         reads disabled on the connection and the connection has no buffered data.
+   *         @see bufferedBytes().
+   */
+  virtual int passthroughFd() const PURE;
+
+  /**
+   * @return uint64_t the number of bytes held in the connection's buffers: read from the socket but
+   *         not yet consumed by the read filters, plus written but not yet flushed to the socket.
+   */
+  virtual uint64_t bufferedBytes() const PURE;
+
+  /**
+   * @return bool whether the connection is open, has no buffered data and all of its read filters
+   *         are idle for transfer, so that it could be closed without losing anything (e.g. an
+   *         HTTP/1 keep-alive connection between requests). @see ReadFilter::idleForTransfer().
+   */
+  virtual bool idle() PURE;
+
+  /**
+   * @return bool whether the connection is idle and has a passthrough fd, so that the fd could be
+   *         adopted by a new connection with a fresh filter chain. @see idle().
+   */
+  virtual bool idleForTransfer() PURE;
+
+  /**
+   * Free the storage the connection's read and write buffers keep for future reads and writes
+   * while they are empty. Connections that stay idle for long periods, such as proxied tunnels,
+   * may call this to shrink their memory to a minimum. Buffered data is left alone.
+   */
+  virtual void releaseBuffers() PURE;
+
   /**
    * @return requested server name (e.g. SNI in TLS), if any.
    */
   virtual absl::string_view requestedServerName() const PURE;
 
+  /**
+   * @return the dynamic metadata set on the connection's socket by listener filters, if any.
+   */
+  virtual const envoy::api::v2::core::Metadata& dynamicMetadata() const PURE;
+
   /**
    * @return State the current state of the connection.
    */
@@ -218,6 +259,28 @@ public:
    */
   virtual uint32_t bufferLimit() const PURE;
 
+  /**
+   * Coalesce small writes. Instead of flushing each write to the socket in the event loop
+   * iteration it was made in, data is flushed once max_bytes are pending or max_delay after the
+   * first write since the last flush, whichever comes first. A max_delay of zero flushes in the
+   * next event loop iteration. Writes with end_stream set and closes with
+   * ConnectionCloseType::FlushWrite are flushed immediately.
+   * @param max_bytes supplies the amount of pending data that is flushed immediately. Zero
+   *        disables coalescing.
+   * @param max_delay supplies the longest time pending data is held back.
+   */
+  virtual void setWriteCoalescing(uint64_t max_bytes, std::chrono::milliseconds max_delay) PURE;
+
+  /**
+   * Bound the data read from the socket each time it becomes readable. Once the budget is read,
+   * the connection yields and reads the rest on a later iteration of the event loop, after the
+   * events of other connections which are already pending, so that one busy connection can't
+   * monopolize its dispatcher.
+   * @param bytes supplies the budget. Zero reads until the socket is drained.
+   * @param yields supplies the counter incremented each time the connection yields.
+   */
+  virtual void setReadBudget(uint32_t bytes, Stats::Counter& yields) PURE;
+
   /**
    * @return boolean telling if the connection's local address has been restored to an original
    *         destination address, rather than the address the connection was accepted at.
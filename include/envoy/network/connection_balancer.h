@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "envoy/common/pure.h"
+#include "envoy/network/listen_socket.h"
+
+namespace Envoy {
+namespace Network {
+
+/**
+ * A connection handler that can be the target of connection balancing. Each worker has one of
+ * these per listener.
+ */
+class BalancedConnectionHandler {
+public:
+  virtual ~BalancedConnectionHandler() {}
+
+  /**
+   * @return uint64_t the number of active connections owned by the handler, including connections
+   *         that have been balanced to the handler but not delivered yet. Thread safe.
+   */
+  virtual uint64_t numConnections() const PURE;
+
+  /**
+   * Account for a connection that has been balanced to the handler. Thread safe.
+   */
+  virtual void incNumConnections() PURE;
+
+  /**
+   * Post an accepted socket to the handler's worker thread. The handler runs the listener filters
+   * and creates the connection there. Thread safe.
+   * @param socket supplies the accepted socket that is moved into the callee.
+   */
+  virtual void post(ConnectionSocketPtr&& socket) PURE;
+};
+
+/**
+ * Balances the connections accepted by a listener across the workers the listener is added to.
+ * All routines are thread safe.
+ */
+class ConnectionBalancer {
+public:
+  virtual ~ConnectionBalancer() {}
+
+  /**
+   * Register a handler that connections can be balanced to.
+   * @param handler supplies the handler to register.
+   */
+  virtual void registerHandler(BalancedConnectionHandler& handler) PURE;
+
+  /**
+   * Unregister a handler registered with registerHandler().
+   * @param handler supplies the handler to unregister.
+   */
+  virtual void unregisterHandler(BalancedConnectionHandler& handler) PURE;
+
+  /**
+   * Pick the handler that should own a connection accepted by a handler. If the picked handler is
+   * not the accepting handler, incNumConnections() has been called on it and the accepting handler
+   * must post() the socket to it.
+   * @param current_handler supplies the handler that accepted the connection.
+   * @return BalancedConnectionHandler& the handler that should own the connection.
+   */
+  virtual BalancedConnectionHandler&
+  pickTargetHandler(BalancedConnectionHandler& current_handler) PURE;
+};
+
+typedef std::unique_ptr<ConnectionBalancer> ConnectionBalancerPtr;
+
+} // namespace Network
+} // namespace Envoy
@@ -1,7 +1,10 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
+#include <list>
 #include <memory>
+#include <vector>
 
 #include "envoy/network/connection.h"
 #include "envoy/network/filter.h"
@@ -45,6 +48,19 @@ public:
    */
   virtual void removeListeners(uint64_t listener_tag) PURE;
 
+  /**
+   * Close the connections of a stopped listener which were created from the given filter chains,
+   * and remove the listener once its other connections are closed as well. This drains the filter
+   * chains that an update of the listener removed or changed, while the connections of the filter
+   * chains it kept run to completion.
+   * @param listener_tag supplies the tag passed to addListener().
+   * @param filter_chains supplies the filter chains whose connections are closed.
+   * @param completion supplies the completion called once the listener has been removed.
+   */
+  virtual void removeFilterChains(uint64_t listener_tag,
+                                  const std::list<const FilterChain*>& filter_chains,
+                                  std::function<void()> completion) PURE;
+
   /**
    * Stop listeners using the listener tag as a key. This will not close any connections and is used
    * for draining.
@@ -56,6 +72,39 @@ public:
    * Stop all listeners. This will not close any connections and is used for draining.
    */
   virtual void stopListeners() PURE;
+
+  /**
+   * Close all connections that are idle for transfer without notifying their peers, keeping their
+   * sockets open for another process to adopt. @see Connection::idleForTransfer().
+   * @return std::vector<int> duplicates of the socket fds of the closed connections. The caller
+   *         owns them.
+   */
+  virtual std::vector<int> releaseIdleConnections() PURE;
+
+  /**
+   * Scale the buffer limits of all connections, including the ones created later, relative to the
+   * per connection buffer limit of their listener. A limit is never scaled below a floor, so that
+   * connections keep making progress, nor is a limit of 0 (no limit) changed.
+   * @param scale supplies the scale between 0 and 1.
+   */
+  virtual void setBufferLimitScale(double scale) PURE;
+
+  /**
+   * Close a share of the idle connections of each listener, oldest first, to reclaim the memory
+   * held by their buffers and filters. @see Connection::idle().
+   * @param share supplies the share of idle connections to close between 0 and 1. At least one
+   *        connection is closed per listener with idle connections if the share is non-zero.
+   * @return uint64_t the number of connections closed.
+   */
+  virtual uint64_t closeIdleConnections(double share) PURE;
+
+  /**
+   * Create a connection for a socket released by another process. The socket skips the listener
+   * filters and gets a new network filter chain from the active listener bound to its local
+   * address. The socket is closed if there is no such listener.
+   * @param socket supplies the socket to adopt.
+   */
+  virtual void adoptConnection(ConnectionSocketPtr&& socket) PURE;
 };
 
 typedef std::unique_ptr<ConnectionHandler> ConnectionHandlerPtr;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <functional>
 #include <list>
 #include <memory>
@@ -51,6 +52,29 @@ public:
    */
   virtual ActiveDnsQuery* resolve(const std::string& dns_name, DnsLookupFamily dns_lookup_family,
                                   ResolveCb callback) PURE;
+
+  /**
+   * Called when a resolution attempt is complete.
+   * @param address_list supplies the list of resolved IP addresses. The list will be empty if
+   *                     the resolution failed.
+   * @param ttl supplies how long the addresses may be cached for, i.e. the lowest TTL of the
+   *            records they were resolved from.
+   */
+  typedef std::function<void(std::list<Address::InstanceConstSharedPtr>&& address_list,
+                             std::chrono::seconds ttl)>
+      ResolveWithTtlCb;
+
+  /**
+   * Initiate an async DNS resolution that also reports the TTL of the result.
+   * @param dns_name supplies the DNS name to lookup.
+   * @param dns_lookup_family the DNS IP version lookup policy.
+   * @param callback supplies the callback to invoke when the resolution is complete.
+   * @return if non-null, a handle that can be used to cancel the resolution.
+   *         This is only valid until the invocation of callback or ~DnsResolver().
+   */
+  virtual ActiveDnsQuery* resolveWithTtl(const std::string& dns_name,
+                                         DnsLookupFamily dns_lookup_family,
+                                         ResolveWithTtlCb callback) PURE;
 };
 
 typedef std::shared_ptr<DnsResolver> DnsResolverSharedPtr;
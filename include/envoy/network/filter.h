@@ -17,6 +17,8 @@ namespace Network {
 
 class Connection;
 class ConnectionSocket;
+class UdpListener;
+struct UdpRecvData;
 
 /**
  * Status codes returned by filters that can cause future filters to not get iterated to.
@@ -114,6 +116,13 @@ public:
    * @param callbacks supplies the callbacks.
    */
   virtual void initializeReadFilterCallbacks(ReadFilterCallbacks& callbacks) PURE;
+
+  /**
+   * @return bool whether the filter holds no state for the connection beyond its configuration,
+   *         so that the connection's socket could be handed to a fresh filter instance in another
+   *         process (e.g. an HTTP/1 connection between requests) without anything being lost.
+   */
+  virtual bool idleForTransfer() { return false; }
 };
 
 typedef std::shared_ptr<ReadFilter> ReadFilterSharedPtr;
@@ -239,6 +248,69 @@ public:
  */
 typedef std::function<void(ListenerFilterManager& filter_manager)> ListenerFilterFactoryCb;
 
+/**
+ * Callbacks used by individual UDP listener read filter instances to communicate with the listener.
+ */
+class UdpReadFilterCallbacks {
+public:
+  virtual ~UdpReadFilterCallbacks() {}
+
+  /**
+   * @return UdpListener& the listener the filter is installed on, which is used to send datagrams
+   *         back to downstream peers.
+   */
+  virtual UdpListener& udpListener() PURE;
+
+  /**
+   * @return Event::Dispatcher& the dispatcher of the worker the listener runs on.
+   */
+  virtual Event::Dispatcher& dispatcher() PURE;
+};
+
+/**
+ * A read filter of a UDP listener. Filters see every datagram received by the listener; there is
+ * no connection, so a filter that tracks peers keeps its own per peer state.
+ */
+class UdpListenerReadFilter {
+public:
+  virtual ~UdpListenerReadFilter() {}
+
+  /**
+   * Called for each datagram received by the listener.
+   * @param data supplies the datagram, whose buffer may be moved out by the filter.
+   * @return status used by the listener to decide whether to pass the datagram to further filters.
+   */
+  virtual FilterStatus onData(UdpRecvData& data) PURE;
+};
+
+typedef std::unique_ptr<UdpListenerReadFilter> UdpListenerReadFilterPtr;
+
+/**
+ * Interface for adding read filters to a UDP listener.
+ */
+class UdpListenerFilterManager {
+public:
+  virtual ~UdpListenerFilterManager() {}
+
+  /**
+   * Add a read filter to the listener. Filters are invoked in FIFO order (the filter added
+   * first is called first).
+   * @param filter supplies the filter being added.
+   */
+  virtual void addReadFilter(UdpListenerReadFilterPtr&& filter) PURE;
+};
+
+/**
+ * This function is used to wrap the creation of the filter chain of a UDP listener when the
+ * listener is added to a worker. Filter factories create the lambda at configuration
+ * initialization time, and then they are used at runtime.
+ * @param filter_manager supplies the filter manager for the listener to install filters to.
+ * @param callbacks supplies the callbacks the installed filters use to send datagrams.
+ */
+typedef std::function<void(UdpListenerFilterManager& filter_manager,
+                           UdpReadFilterCallbacks& callbacks)>
+    UdpListenerFilterFactoryCb;
+
 /**
  * Interface representing a single filter chain.
  */
@@ -299,6 +371,15 @@ public:
    * @return true if filter chain was created successfully. Otherwise false.
    */
   virtual bool createListenerFilterChain(ListenerFilterManager& listener) PURE;
+
+  /**
+   * Called to create the filter chain of a UDP listener.
+   * @param udp_listener supplies the listener to create the chain on.
+   * @param callbacks supplies the callbacks to initialize the filters with.
+   * @return true if filter chain was created successfully. Otherwise false.
+   */
+  virtual bool createUdpListenerFilterChain(UdpListenerFilterManager& udp_listener,
+                                            UdpReadFilterCallbacks& callbacks) PURE;
 };
 
 } // namespace Network
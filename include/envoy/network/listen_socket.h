@@ -1,12 +1,15 @@
 #pragma once
 
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "envoy/api/v2/core/base.pb.h"
 #include "envoy/common/pure.h"
 #include "envoy/network/address.h"
 
+#include "common/protobuf/protobuf.h"
+
 #include "absl/strings/string_view.h"
 
 namespace Envoy {
@@ -170,6 +173,19 @@ public:
    * @return requested server name (e.g. SNI in TLS), if any.
    */
   virtual absl::string_view requestedServerName() const PURE;
+
+  /**
+   * Set dynamic metadata learned about the connection by a listener filter (e.g. proxy protocol
+   * TLVs), which is copied to the dynamic metadata of the requests carried by the connection.
+   * @param name the namespace used in the metadata in reverse DNS format.
+   * @param value the struct to merge into the namespace.
+   */
+  virtual void setDynamicMetadata(const std::string& name, const ProtobufWkt::Struct& value) PURE;
+
+  /**
+   * @return the dynamic metadata set on the socket, if any.
+   */
+  virtual const envoy::api::v2::core::Metadata& dynamicMetadata() const PURE;
 };
 
 typedef std::unique_ptr<ConnectionSocket> ConnectionSocketPtr;
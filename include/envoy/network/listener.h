@@ -4,8 +4,10 @@
 #include <memory>
 #include <string>
 
+#include "envoy/buffer/buffer.h"
 #include "envoy/common/exception.h"
 #include "envoy/network/connection.h"
+#include "envoy/network/connection_balancer.h"
 #include "envoy/network/listen_socket.h"
 #include "envoy/network/transport_socket.h"
 #include "envoy/ssl/context.h"
@@ -74,6 +76,30 @@ public:
    * @return const std::string& the listener's name.
    */
   virtual const std::string& name() const PURE;
+
+  /**
+   * @return ConnectionBalancer& the balancer used to distribute the listener's accepted
+   *         connections across workers.
+   */
+  virtual ConnectionBalancer& connectionBalancer() PURE;
+
+  /**
+   * @return uint32_t the maximum number of connections to accept each time the listen socket
+   *         becomes readable.
+   */
+  virtual uint32_t maxAcceptsPerWakeup() const PURE;
+
+  /**
+   * @return uint32_t the most bytes read from a connection each time its socket becomes readable,
+   *         before it yields to other connections on the worker. Zero means no budget.
+   */
+  virtual uint32_t perConnectionReadBudgetBytes() const PURE;
+
+  /**
+   * @return Address::SocketType the type of the listen socket. Stream listeners accept connections
+   *         and run the network filter chains, datagram listeners run the UDP listener filters.
+   */
+  virtual Address::SocketType socketType() const PURE;
 };
 
 /**
@@ -98,6 +124,15 @@ public:
    * @param new_connection supplies the new connection that is moved into the callee.
    */
   virtual void onNewConnection(ConnectionPtr&& new_connection) PURE;
+
+  /**
+   * Called after the listener has finished accepting connections for a single wakeup of the
+   * listen socket.
+   * @param accepted supplies the number of connections accepted during the wakeup.
+   * @param limit_reached is true when accepting stopped because the per wakeup limit was reached
+   *        rather than because the accept queue was drained.
+   */
+  virtual void onAcceptBatch(uint32_t accepted, bool limit_reached) PURE;
 };
 
 /**
@@ -110,6 +145,73 @@ public:
 
 typedef std::unique_ptr<Listener> ListenerPtr;
 
+/**
+ * A datagram received by a UDP listener.
+ */
+struct UdpRecvData {
+  // The local address of the listener the datagram was received on.
+  Address::InstanceConstSharedPtr local_address_;
+  Address::InstanceConstSharedPtr peer_address_;
+  Buffer::InstancePtr buffer_;
+};
+
+/**
+ * A datagram to send from a UDP listener.
+ */
+struct UdpSendData {
+  const Address::Instance& peer_address_;
+  Buffer::Instance& buffer_;
+};
+
+/**
+ * Callbacks invoked by a UDP listener.
+ */
+class UdpListenerCallbacks {
+public:
+  virtual ~UdpListenerCallbacks() {}
+
+  /**
+   * Called for each datagram received on the listen socket.
+   * @param data supplies the datagram. The buffer may be moved out by the callee.
+   */
+  virtual void onData(UdpRecvData& data) PURE;
+
+  /**
+   * Called when reading from the listen socket failed, or a datagram was dropped because it was
+   * larger than the receive buffer.
+   * @param error supplies the errno of the failure, or EMSGSIZE for a truncated datagram.
+   */
+  virtual void onReceiveError(int error) PURE;
+
+  /**
+   * Called when a datagram queued by UdpListener::send() could not be written.
+   * @param error supplies the errno of the failure.
+   */
+  virtual void onSendError(int error) PURE;
+};
+
+/**
+ * A listener on a datagram socket. Free the listener to stop receiving on the socket.
+ */
+class UdpListener : public Listener {
+public:
+  /**
+   * @return const Address::InstanceConstSharedPtr& the local address of the listen socket.
+   */
+  virtual const Address::InstanceConstSharedPtr& localAddress() const PURE;
+
+  /**
+   * Queue a datagram to a peer. Queued datagrams are written together, with a single system call
+   * where the platform allows it, once the datagrams received in the current wakeup of the listen
+   * socket have been handled or on the next event loop iteration otherwise. As with any datagram,
+   * delivery is not guaranteed: a datagram that cannot be written is dropped.
+   * @param data supplies the peer address and the payload, which is drained from the buffer.
+   */
+  virtual void send(const UdpSendData& data) PURE;
+};
+
+typedef std::unique_ptr<UdpListener> UdpListenerPtr;
+
 /**
  * Thrown when there is a runtime error creating/binding a listener.
  */
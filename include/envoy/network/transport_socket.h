@@ -132,6 +132,13 @@ public:
    * @return the const SSL connection data if this is an SSL connection, or nullptr if it is not.
    */
   virtual const Ssl::Connection* ssl() const PURE;
+
+  /**
+   * @return bool whether the transport socket reads and writes connection data to the underlying
+   *         socket unmodified. If true, data may be moved to and from the socket directly (e.g.
+   *         with splice()) while reads are disabled on the connection.
+   */
+  virtual bool passthrough() const PURE;
 };
 
 typedef std::unique_ptr<TransportSocket> TransportSocketPtr;
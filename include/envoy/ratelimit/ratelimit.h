@@ -76,10 +76,12 @@ public:
    * @param domain specifies the rate limit domain.
    * @param descriptors specifies a list of descriptors to query.
    * @param parent_span source for generating an egress child span as part of the trace.
+   * @param hits_addend specifies the number of hits the request adds to the matched limits.
    *
    */
   virtual void limit(RequestCallbacks& callbacks, const std::string& domain,
-                     const std::vector<Descriptor>& descriptors, Tracing::Span& parent_span) PURE;
+                     const std::vector<Descriptor>& descriptors, Tracing::Span& parent_span,
+                     uint32_t hits_addend) PURE;
 };
 
 typedef std::unique_ptr<Client> ClientPtr;
@@ -8,6 +8,7 @@
 #include "envoy/common/pure.h"
 #include "envoy/common/time.h"
 #include "envoy/http/protocol.h"
+#include "envoy/http/request_attributes.h"
 #include "envoy/request_info/filter_state.h"
 #include "envoy/upstream/upstream.h"
 
@@ -313,6 +314,12 @@ public:
   virtual FilterState& perRequestState() PURE;
   virtual const FilterState& perRequestState() const PURE;
 
+  /**
+   * @return the attributes parsed out of the request headers, such as cookies and query
+   * parameters, which the router and the filters share instead of each parsing them again.
+   */
+  virtual Http::RequestAttributes& requestAttributes() PURE;
+
   /**
    * @param SNI value requested
    */
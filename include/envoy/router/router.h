@@ -9,12 +9,16 @@
 #include <string>
 
 #include "envoy/access_log/access_log.h"
+#include "envoy/buffer/buffer.h"
 #include "envoy/api/v2/core/base.pb.h"
+#include "envoy/common/regex.h"
 #include "envoy/http/codec.h"
 #include "envoy/http/codes.h"
 #include "envoy/http/header_map.h"
+#include "envoy/http/request_attributes.h"
 #include "envoy/http/websocket.h"
 #include "envoy/tracing/http_tracer.h"
+#include "envoy/upstream/cluster_name_handle.h"
 #include "envoy/upstream/resource_manager.h"
 
 #include "common/protobuf/protobuf.h"
@@ -76,6 +80,14 @@ public:
    */
   virtual const std::string& responseBody() const PURE;
 
+  /**
+   * Adds the response body to the buffer of a direct response. The body is not copied: the buffer
+   * references it and keeps it alive until the response is written, so that a body is stored once
+   * however many responses it is sent in.
+   * @param buffer supplies the buffer to add the response body to.
+   */
+  virtual void addResponseBody(Buffer::Instance& buffer) const PURE;
+
   /**
    * Do potentially destructive header transforms on Path header prior to redirection. For
    * example prefix rewriting for redirects etc. This should only be called ONCE
@@ -100,9 +112,9 @@ public:
   virtual const std::list<std::string>& allowOrigins() const PURE;
 
   /*
-   * @return std::list<std::regex>& regexes that match allowed origins.
+   * @return std::list<Regex::CompiledMatcherPtr>& regexes that match allowed origins.
    */
-  virtual const std::list<std::regex>& allowOriginRegexes() const PURE;
+  virtual const std::list<Regex::CompiledMatcherPtr>& allowOriginRegexes() const PURE;
 
   /**
    * @return std::string access-control-allow-methods value.
@@ -170,6 +182,26 @@ public:
   virtual uint32_t retryOn() const PURE;
 };
 
+/**
+ * Route level hedging policy.
+ */
+class HedgePolicy {
+public:
+  virtual ~HedgePolicy() {}
+
+  /**
+   * @return std::chrono::milliseconds how long to wait for the response to the initial attempt of
+   *         an idempotent request before sending a hedged attempt. Zero disables hedging.
+   */
+  virtual std::chrono::milliseconds delay() const PURE;
+
+  /**
+   * @return uint32_t the percentage of the requests in flight to the upstream cluster that may be
+   *         hedged attempts.
+   */
+  virtual uint32_t budgetPercent() const PURE;
+};
+
 /**
  * RetryStatus whether request should be retried or not.
  */
@@ -323,6 +355,7 @@ public:
    * @param downstream_address is the address of the connected client host, or nullptr if the
    * request is initiated from within this host
    * @param headers stores the HTTP headers for the stream
+   * @param request_attributes supplies the attributes parsed out of the headers, such as cookies
    * @param add_cookie is called to add a set-cookie header on the reply sent to the downstream
    * host
    * @return absl::optional<uint64_t> an optional hash value to route on. A hash value might not be
@@ -330,6 +363,7 @@ public:
    */
   virtual absl::optional<uint64_t>
   generateHash(const Network::Address::Instance* downstream_address, const Http::HeaderMap& headers,
+               Http::RequestAttributes& request_attributes,
                AddCookieCallback add_cookie) const PURE;
 };
 
@@ -365,6 +399,13 @@ public:
   virtual const std::vector<MetadataMatchCriterionConstSharedPtr>&
   metadataMatchCriteria() const PURE;
 
+  /**
+   * @return uint64_t the hash of the criteria, combining the name and value of each criterion in
+   * order with HashedValue::hashWithName(). It is computed once, so that load balancers can look
+   * up the subset matching the criteria without hashing them on each request.
+   */
+  virtual uint64_t hash() const PURE;
+
   /**
    * Creates a new MetadataMatchCriteria, merging existing
    * metadata criteria with the provided criteria. The result criteria is the
@@ -417,6 +458,12 @@ public:
    */
   virtual const std::string& clusterName() const PURE;
 
+  /**
+   * @return const Upstream::ClusterNameHandle* the interned name of the upstream cluster, to look
+   *         it up with instead of clusterName(), or nullptr if the name is only known per request.
+   */
+  virtual const Upstream::ClusterNameHandle* clusterNameHandle() const { return nullptr; }
+
   /**
    * Returns the HTTP status code to use when configured cluster is not found.
    * @return Http::Code to use when configured cluster is not found.
@@ -461,6 +508,12 @@ public:
    */
   virtual const RetryPolicy& retryPolicy() const PURE;
 
+  /**
+   * @return const HedgePolicy& the hedge policy for the route. All routes have a hedge policy even
+   *         if it is empty and does not allow hedging.
+   */
+  virtual const HedgePolicy& hedgePolicy() const PURE;
+
   /**
    * @return const ShadowPolicy& the shadow policy for the route. All routes have a shadow policy
    *         even if no shadowing takes place.
@@ -34,6 +34,29 @@ public:
 
 typedef std::unique_ptr<RandomGenerator> RandomGeneratorPtr;
 
+/**
+ * A runtime key interned to a process-wide index when it is registered, typically at
+ * configuration time. Snapshot reads through a handle index an array rather than hashing the key.
+ */
+class KeyHandle {
+public:
+  KeyHandle(const std::string& key, uint32_t index) : key_(key), index_(index) {}
+
+  /**
+   * @return const std::string& the runtime key.
+   */
+  const std::string& key() const { return key_; }
+
+  /**
+   * @return uint32_t the index the key was interned to.
+   */
+  uint32_t index() const { return index_; }
+
+private:
+  std::string key_;
+  uint32_t index_;
+};
+
 /**
  * A snapshot of runtime data.
  */
@@ -73,7 +96,7 @@ public:
     virtual const std::string& name() const PURE;
   };
 
-  typedef std::unique_ptr<const OverrideLayer> OverrideLayerConstPtr;
+  typedef std::shared_ptr<const OverrideLayer> OverrideLayerConstSharedPtr;
 
   /**
    * Test if a feature is enabled using the built in random generator. This is done by generating
@@ -119,6 +142,35 @@ public:
   virtual bool featureEnabled(const std::string& key, uint64_t default_value, uint64_t random_value,
                               uint64_t num_buckets) const PURE;
 
+  /**
+   * Test if a feature is enabled using the built in random generator. @see
+   * featureEnabled(const std::string&, uint64_t). Implementations may override this to avoid
+   * hashing the key.
+   * @param key supplies the handle of the feature key to lookup.
+   * @param default_value supplies the default value that will be used if either the feature key
+   *        does not exist or it is not an integer.
+   * @return true if the feature is enabled.
+   */
+  virtual bool featureEnabled(const KeyHandle& key, uint64_t default_value) const {
+    return featureEnabled(key.key(), default_value);
+  }
+
+  /**
+   * Test if a feature is enabled using a supplied stable random value. @see
+   * featureEnabled(const std::string&, uint64_t, uint64_t). Implementations may override this to
+   * avoid hashing the key.
+   * @param key supplies the handle of the feature key to lookup.
+   * @param default_value supplies the default value that will be used if either the feature key
+   *        does not exist or it is not an integer.
+   * @param random_value supplies the stable random value to use for determining whether the feature
+   *        is enabled.
+   * @return true if the feature is enabled.
+   */
+  virtual bool featureEnabled(const KeyHandle& key, uint64_t default_value,
+                              uint64_t random_value) const {
+    return featureEnabled(key.key(), default_value, random_value);
+  }
+
   /**
    * Fetch raw runtime data based on key.
    * @param key supplies the key to fetch.
@@ -135,14 +187,27 @@ public:
    */
   virtual uint64_t getInteger(const std::string& key, uint64_t default_value) const PURE;
 
+  /**
+   * Fetch an integer runtime key through its handle. Implementations may override this to avoid
+   * hashing the key.
+   * @param key supplies the handle of the key to fetch.
+   * @param default_value supplies the value to return if the key does not exist or it does not
+   *        contain an integer.
+   * @return uint64_t the runtime value or the default value.
+   */
+  virtual uint64_t getInteger(const KeyHandle& key, uint64_t default_value) const {
+    return getInteger(key.key(), default_value);
+  }
+
   /**
    * Fetch the OverrideLayers that provide values in this snapshot. Layers are ordered from bottom
    * to top; for instance, the second layer's entries override the first layer's entries, and so on.
    * Any layer can add a key in addition to overriding keys in layers below. The layer vector is
-   * safe only for the lifetime of the Snapshot.
-   * @return const std::vector<OverrideLayerConstPtr>& the raw map of loaded values.
+   * safe only for the lifetime of the Snapshot. Layers that did not change may be shared with
+   * other snapshots.
+   * @return const std::vector<OverrideLayerConstSharedPtr>& the raw map of loaded values.
    */
-  virtual const std::vector<OverrideLayerConstPtr>& getLayers() const PURE;
+  virtual const std::vector<OverrideLayerConstSharedPtr>& getLayers() const PURE;
 };
 
 /**
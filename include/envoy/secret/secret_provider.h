@@ -2,6 +2,7 @@
 
 #include <functional>
 
+#include "envoy/api/v2/auth/cert.pb.h"
 #include "envoy/common/callback.h"
 #include "envoy/common/pure.h"
 #include "envoy/ssl/certificate_validation_context_config.h"
@@ -40,5 +41,10 @@ typedef SecretProvider<Ssl::CertificateValidationContextConfig>
 typedef std::shared_ptr<CertificateValidationContextConfigProvider>
     CertificateValidationContextConfigProviderSharedPtr;
 
+typedef SecretProvider<envoy::api::v2::auth::TlsSessionTicketKeys>
+    TlsSessionTicketKeysConfigProvider;
+typedef std::shared_ptr<TlsSessionTicketKeysConfigProvider>
+    TlsSessionTicketKeysConfigProviderSharedPtr;
+
 } // namespace Secret
 } // namespace Envoy
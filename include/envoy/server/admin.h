@@ -44,6 +44,34 @@ public:
    * request.
    */
   virtual const Http::HeaderMap& getRequestHeaders() const PURE;
+
+  /**
+   * Callback producing the next part of a streamed response body.
+   * @param response supplies the buffer to append the next part of the body to.
+   * @return bool true once the body is complete, false if the callback should be invoked again.
+   */
+  typedef std::function<bool(Buffer::Instance& response)> ChunkCb;
+
+  /**
+   * Continue the response after the handler returns. Once the headers and whatever the handler
+   * wrote to its response buffer have been sent, cb is invoked once per dispatcher iteration, and
+   * each part it produces is sent before the next invocation, until it reports that the body is
+   * complete. Invocations are paused while the downstream connection is above its write buffer
+   * high watermark. This keeps handlers with very large responses from building the whole body
+   * in memory and from blocking the main thread while doing so.
+   * @param cb supplies the callback producing the rest of the body.
+   */
+  virtual void streamResponse(ChunkCb cb) PURE;
+
+  /**
+   * Like streamResponse(), except that cb is invoked on the admin render thread and only sending
+   * the parts it produces is left to the main thread, so that producing a large read-only response
+   * such as a stats scrape doesn't delay xDS updates or the stats flush. cb must only read state
+   * that is safe to read from another thread, and copy anything else while the handler runs. It
+   * is invoked on the main thread instead when there is no render thread.
+   * @param cb supplies the callback producing the rest of the body.
+   */
+  virtual void streamResponseOffThread(ChunkCb cb) PURE;
 };
 
 /**
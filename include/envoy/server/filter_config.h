@@ -181,6 +181,39 @@ public:
   virtual std::string name() PURE;
 };
 
+/**
+ * Implemented by each UDP listener filter and registered via Registry::registerFactory()
+ * or the convenience class RegisterFactory.
+ */
+class NamedUdpListenerFilterConfigFactory {
+public:
+  virtual ~NamedUdpListenerFilterConfigFactory() {}
+
+  /**
+   * Create a particular UDP listener filter factory implementation. If the implementation is
+   * unable to produce a factory with the provided parameters, it should throw an EnvoyException.
+   * The returned callback should always be initialized.
+   * @param config supplies the general protobuf configuration for the filter
+   * @param context supplies the filter's context.
+   * @return Network::UdpListenerFilterFactoryCb the factory creation function.
+   */
+  virtual Network::UdpListenerFilterFactoryCb
+  createFilterFactoryFromProto(const Protobuf::Message& config,
+                               ListenerFactoryContext& context) PURE;
+
+  /**
+   * @return ProtobufTypes::MessagePtr create empty config proto message. The filter config, which
+   *         arrives in an opaque message, will be parsed into this empty proto.
+   */
+  virtual ProtobufTypes::MessagePtr createEmptyConfigProto() PURE;
+
+  /**
+   * @return std::string the identifying name for a particular implementation of a UDP listener
+   * filter produced by the factory.
+   */
+  virtual std::string name() PURE;
+};
+
 /**
  * Implemented by filter factories that require more options to process the protocol used by the
  * upstream cluster.
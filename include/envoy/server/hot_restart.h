@@ -41,9 +41,18 @@ public:
    * Retrieve a listening socket on the specified address from the parent process. The socket will
    * be duplicated across process boundaries.
    * @param address supplies the address of the socket to duplicate, e.g. tcp://127.0.0.1:5000.
+   * @param worker_index supplies the index of the worker that will accept on the socket. This only
+   *        matters for listeners with reuse_port set, which have one socket per worker.
    * @return int the fd or -1 if there is no bound listen port in the parent.
    */
-  virtual int duplicateParentListenSocket(const std::string& address) PURE;
+  virtual int duplicateParentListenSocket(const std::string& address, uint32_t worker_index) PURE;
+
+  /**
+   * Take over the idle downstream connections of the parent process if enabled via cli flags. This
+   * must be called once workers have started. The sockets are duplicated across process boundaries
+   * and handed to the workers. @see ListenerManager::releaseIdleConnections().
+   */
+  virtual void transferParentConnections() PURE;
 
   /**
    * Retrieve stats from our parent process.
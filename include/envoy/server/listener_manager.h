@@ -52,6 +52,34 @@ public:
   createListenSocket(Network::Address::InstanceConstSharedPtr address,
                      const Network::Socket::OptionsSharedPtr& options, bool bind_to_port) PURE;
 
+  /**
+   * Creates a bound socket for a single worker of a listener with reuse_port set.
+   * @param address supplies the socket's address.
+   * @param options to be set on the created socket just before calling 'bind()'. These must
+   *        include SO_REUSEPORT so that the sockets of all workers can bind the same address.
+   * @param worker_index supplies the index of the worker that will accept on the socket.
+   * @return Network::SocketSharedPtr an initialized and bound socket.
+   */
+  virtual Network::SocketSharedPtr
+  createReusePortListenSocket(Network::Address::InstanceConstSharedPtr address,
+                              const Network::Socket::OptionsSharedPtr& options,
+                              uint32_t worker_index) PURE;
+
+  /**
+   * Creates a bound datagram socket for a single worker of a UDP listener. Every worker of a UDP
+   * listener receives on its own socket so that the datagrams of a peer are handled by the same
+   * worker.
+   * @param address supplies the socket's address.
+   * @param options to be set on the created socket just before calling 'bind()'. These must
+   *        include SO_REUSEPORT so that the sockets of all workers can bind the same address.
+   * @param worker_index supplies the index of the worker that will receive on the socket.
+   * @return Network::SocketSharedPtr an initialized and bound socket.
+   */
+  virtual Network::SocketSharedPtr
+  createUdpListenSocket(Network::Address::InstanceConstSharedPtr address,
+                        const Network::Socket::OptionsSharedPtr& options,
+                        uint32_t worker_index) PURE;
+
   /**
    * Creates a list of filter factories.
    * @param filters supplies the proto configuration.
@@ -72,6 +100,16 @@ public:
       const Protobuf::RepeatedPtrField<envoy::api::v2::listener::ListenerFilter>& filters,
       Configuration::ListenerFactoryContext& context) PURE;
 
+  /**
+   * Creates a list of UDP listener filter factories.
+   * @param filters supplies the proto configuration.
+   * @param context supplies the factory creation context.
+   * @return std::vector<Network::UdpListenerFilterFactoryCb> the list of filter factories.
+   */
+  virtual std::vector<Network::UdpListenerFilterFactoryCb> createUdpListenerFilterFactoryList(
+      const Protobuf::RepeatedPtrField<envoy::api::v2::listener::ListenerFilter>& filters,
+      Configuration::ListenerFactoryContext& context) PURE;
+
   /**
    * @return DrainManagerPtr a new drain manager.
    * @param drain_type supplies the type of draining to do for the owning listener.
@@ -125,11 +163,37 @@ public:
    */
   virtual std::vector<std::reference_wrapper<Network::ListenerConfig>> listeners() PURE;
 
+  /**
+   * Find the listen socket of an active listener for handing it to a hot restarted child process.
+   * @param address supplies the bound address of the listener.
+   * @param worker_index supplies the index of the worker whose socket is wanted. Listeners without
+   *        reuse_port share a single socket between all workers and ignore this.
+   * @return int the fd of the socket or -1 if there is no such socket.
+   */
+  virtual int listenSocketFd(const Network::Address::Instance& address,
+                             uint32_t worker_index) PURE;
+
   /**
    * @return uint64_t the total number of connections owned by all listeners across all workers.
    */
   virtual uint64_t numConnections() PURE;
 
+  /**
+   * Release the idle connections of all workers for a hot restarted child process to adopt. This
+   * blocks until every worker has released its connections.
+   * @see Network::ConnectionHandler::releaseIdleConnections().
+   * @return std::vector<int> the fds of the released connections. The caller owns them.
+   */
+  virtual std::vector<int> releaseIdleConnections() PURE;
+
+  /**
+   * Create a connection for a socket released by the parent process, handing sockets to the
+   * workers in turn.
+   * @see Network::ConnectionHandler::adoptConnection().
+   * @param socket supplies the socket to adopt.
+   */
+  virtual void adoptConnection(Network::ConnectionSocketPtr&& socket) PURE;
+
   /**
    * Remove a listener by name.
    * @param name supplies the listener name to remove.
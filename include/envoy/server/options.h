@@ -3,6 +3,7 @@
 #include <chrono>
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "envoy/common/pure.h"
 #include "envoy/network/address.h"
@@ -107,6 +108,12 @@ public:
    */
   virtual const std::string& logPath() const PURE;
 
+  /**
+   * @return uint32_t the size in bytes of the ring buffer each thread buffers its log messages in
+   *         when logging asynchronously. Zero logs synchronously.
+   */
+  virtual uint32_t logAsyncBufferSize() const PURE;
+
   /**
    * @return the number of seconds that envoy will wait before shutting down the parent envoy during
    *         a host restart. Generally this will be longer than the drainTime() option.
@@ -159,6 +166,58 @@ public:
    * @return bool indicating whether the hot restart functionality has been disabled via cli flags.
    */
   virtual bool hotRestartDisabled() const PURE;
+
+  /**
+   * @return bool whether a hot restarted server takes over the idle downstream connections of its
+   *         parent instead of leaving them to drain in the parent.
+   */
+  virtual bool hotRestartTransferConnections() const PURE;
+
+  /**
+   * @return bool indicating whether the experimental io_uring backend has been enabled via cli
+   *         flags.
+   */
+  virtual bool ioUringEnabled() const PURE;
+
+  /**
+   * @return std::chrono::milliseconds the resolution of the per thread timer wheel serving idle
+   *         and request timeouts. Zero means that every timer uses the libevent timer heap.
+   */
+  virtual std::chrono::milliseconds coarseTimerResolution() const PURE;
+
+  /**
+   * @return const std::vector<uint32_t>& the CPUs that workers are pinned to. Worker i runs on the
+   *         CPU at index i modulo the size of the list. Empty means that workers are not pinned.
+   */
+  virtual const std::vector<uint32_t>& workerCpus() const PURE;
+
+  /**
+   * @return bool whether workers allocate memory from the NUMA node they run on.
+   */
+  virtual bool workerNumaLocalMemory() const PURE;
+
+  /**
+   * @return bool whether each worker's reuse_port listen sockets prefer connections received on
+   *         the CPU the worker is pinned to.
+   */
+  virtual bool reusePortIncomingCpu() const PURE;
+
+  /**
+   * @return bool whether the main thread and worker dispatchers record event loop stats.
+   */
+  virtual bool dispatcherStatsEnabled() const PURE;
+
+  /**
+   * @return std::chrono::milliseconds the event loop iteration duration above which dispatchers
+   *         that record stats log a stall. Zero disables stall detection.
+   */
+  virtual std::chrono::milliseconds dispatcherStallThreshold() const PURE;
+
+  /**
+   * @return uint32_t the number of MiB of huge page backed memory to prefault for load balancer
+   *         tables and stats at startup. Zero disables the huge page arena.
+   */
+  virtual uint32_t hugePageArenaSizeMb() const PURE;
 };
 
 } // namespace Server
@@ -1,10 +1,14 @@
 #pragma once
 
+#include <atomic>
 #include <unordered_map>
 
 #include "envoy/common/pure.h"
+#include "envoy/event/dispatcher.h"
 #include "envoy/thread_local/thread_local.h"
 
+#include "common/singleton/const_singleton.h"
+
 namespace Envoy {
 namespace Server {
 
@@ -24,6 +28,27 @@ enum class OverloadActionState {
  */
 typedef std::function<void(OverloadActionState)> OverloadActionCb;
 
+/**
+ * Callback invoked with the scaled value of an overload action. @see OverloadActionValue.
+ */
+typedef std::function<void(double)> OverloadActionValueCb;
+
+/**
+ * Well-known overload action names.
+ */
+class OverloadActionNameValues {
+public:
+  // Lowers the buffer limits of downstream connections in proportion to the action's value, down
+  // to a floor once the action is fully active.
+  const std::string ReduceBufferLimits = "envoy.overload_actions.reduce_buffer_limits";
+
+  // Closes a share of the idle downstream connections proportional to the action's value, oldest
+  // first, every time the action's resources are updated.
+  const std::string CloseIdleConnections = "envoy.overload_actions.close_idle_connections";
+};
+
+typedef ConstSingleton<OverloadActionNameValues> OverloadActionNames;
+
 /**
  * Thread-local copy of the state of each configured overload action.
  */
@@ -50,6 +75,20 @@ private:
   std::unordered_map<std::string, OverloadActionState> actions_;
 };
 
+/**
+ * The scaled value of an overload action, between 0 when it is inactive and 1 once it is fully
+ * active. It is updated by the main thread and can be read from any thread without posting to
+ * it, so that workers can shed a share of their load proportional to the value.
+ */
+class OverloadActionValue {
+public:
+  double value() const { return value_.load(std::memory_order_relaxed); }
+  void setValue(double value) { value_.store(value, std::memory_order_relaxed); }
+
+private:
+  std::atomic<double> value_{0};
+};
+
 /**
  * The OverloadManager protects the Envoy instance from being overwhelmed by client
  * requests. It monitors a set of resources and notifies registered listeners if
@@ -76,11 +115,30 @@ public:
   virtual void registerForAction(const std::string& action, Event::Dispatcher& dispatcher,
                                  OverloadActionCb callback) PURE;
 
+  /**
+   * Register a callback to be invoked with the scaled value of the specified overload action
+   * whenever the resources triggering it are updated, as long as the value is non-zero or has
+   * just dropped to zero. Must be called before the start method is called.
+   * @param action const std::string& the name of the overload action to register for
+   * @param dispatcher Event::Dispatcher& the dispatcher on which callbacks will be posted
+   * @param callback OverloadActionValueCb the callback to post with the value of the action
+   */
+  virtual void registerForActionValue(const std::string& action, Event::Dispatcher& dispatcher,
+                                      OverloadActionValueCb callback) PURE;
+
   /**
    * Get the thread-local overload action states. Lookups in this object can be used as
    * an alternative to registering a callback for overload action state changes.
    */
   virtual ThreadLocalOverloadState& getThreadLocalOverloadState() PURE;
+
+  /**
+   * Get the scaled value of an overload action, which is always 0 if the action isn't configured.
+   * @param action const std::string& the name of the overload action.
+   * @return const OverloadActionValue& the value, which remains valid for the lifetime of the
+   *         overload manager and can be read from any thread.
+   */
+  virtual const OverloadActionValue& getActionValue(const std::string& action) PURE;
 };
 
 } // namespace Server
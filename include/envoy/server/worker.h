@@ -1,8 +1,13 @@
 #pragma once
 
 #include <functional>
+#include <list>
+#include <vector>
 
+#include "envoy/network/filter.h"
+#include "envoy/network/listen_socket.h"
 #include "envoy/server/guarddog.h"
+#include "envoy/server/overload_manager.h"
 
 namespace Envoy {
 namespace Server {
@@ -56,6 +61,19 @@ public:
   virtual void removeListener(Network::ListenerConfig& listener,
                               std::function<void()> completion) PURE;
 
+  /**
+   * Close the connections of a stopped listener which were created from some of its filter chains,
+   * and remove the listener once its other connections are gone.
+   * @see Network::ConnectionHandler::removeFilterChains().
+   * @param listener supplies the listener.
+   * @param filter_chains supplies the filter chains whose connections are closed.
+   * @param completion supplies the completion to be called when the listener has been removed.
+   *        This completion is called on the worker thread. No locking is performed by the worker.
+   */
+  virtual void removeFilterChains(Network::ListenerConfig& listener,
+                                  const std::list<const Network::FilterChain*>& filter_chains,
+                                  std::function<void()> completion) PURE;
+
   /**
    * Stop a listener from accepting new connections. This is used for server draining.
    * @param listener supplies the listener to stop.
@@ -70,6 +88,21 @@ public:
    * TODO(mattklein123): Same comment about the addition of a completion as stopListener().
    */
   virtual void stopListeners() PURE;
+
+  /**
+   * Release the worker's idle connections for another process to adopt.
+   * @see Network::ConnectionHandler::releaseIdleConnections().
+   * @param completion supplies the completion to be called with the released fds. This completion
+   *        is called on the worker thread. No locking is performed by the worker.
+   */
+  virtual void releaseIdleConnections(std::function<void(std::vector<int>&&)> completion) PURE;
+
+  /**
+   * Create a connection on the worker for a socket released by another process.
+   * @see Network::ConnectionHandler::adoptConnection().
+   * @param socket supplies the socket to adopt.
+   */
+  virtual void adoptConnection(Network::ConnectionSocketPtr&& socket) PURE;
 };
 
 typedef std::unique_ptr<Worker> WorkerPtr;
@@ -82,9 +115,11 @@ public:
   virtual ~WorkerFactory() {}
 
   /**
+   * @param overload_manager supplies the overload manager the worker registers its overload
+   *        actions with.
    * @return WorkerPtr a new worker.
    */
-  virtual WorkerPtr createWorker() PURE;
+  virtual WorkerPtr createWorker(OverloadManager& overload_manager) PURE;
 };
 
 } // namespace Server
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <functional>
+#include <memory>
+#include <string>
 
 #include "envoy/ssl/context.h"
 #include "envoy/ssl/context_config.h"
@@ -9,6 +11,16 @@
 namespace Envoy {
 namespace Ssl {
 
+/**
+ * Trusted CA certificates parsed ahead of the creation of the contexts that trust them.
+ */
+class TrustedCa {
+public:
+  virtual ~TrustedCa() {}
+};
+
+typedef std::shared_ptr<const TrustedCa> TrustedCaConstSharedPtr;
+
 /**
  * Manages all of the SSL contexts in the process
  */
@@ -38,6 +50,17 @@ public:
    * Iterate through all currently allocated contexts.
    */
   virtual void iterateContexts(std::function<void(const Context&)> callback) PURE;
+
+  /**
+   * Parse trusted CA certificates ahead of the creation of the contexts that trust them, which
+   * reuse the parse instead of doing it again for as long as it, or any of them, is alive. Unlike
+   * the other methods, this may be called from any thread, so that certificates can be parsed in
+   * parallel.
+   * @param ca_cert supplies the PEM encoded certificates.
+   * @return TrustedCaConstSharedPtr the parsed certificates. Parse errors are reported when
+   *         creating the contexts.
+   */
+  virtual TrustedCaConstSharedPtr prepareTrustedCa(const std::string& ca_cert) PURE;
 };
 
 } // namespace Ssl
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <memory>
+
+#include "envoy/common/pure.h"
+#include "envoy/event/dispatcher.h"
+
+#include "openssl/ssl.h"
+
+namespace Envoy {
+namespace Ssl {
+
+/**
+ * Callbacks of a connection waiting for an asynchronous private key operation.
+ */
+class PrivateKeyConnectionCallbacks {
+public:
+  virtual ~PrivateKeyConnectionCallbacks() {}
+
+  /**
+   * Called on the dispatcher of the connection once the pending private key operation has
+   * completed, successfully or not. The connection is expected to resume its handshake, which
+   * collects the result of the operation.
+   */
+  virtual void onPrivateKeyMethodComplete() PURE;
+};
+
+/**
+ * A provider of private key operations, such as signing with the private key of a certificate
+ * during a TLS handshake. Providers may perform the operations asynchronously, e.g. on a thread
+ * pool or a hardware accelerator, so that the handshake does not block the worker thread. The
+ * operations are exposed to BoringSSL as an SSL_PRIVATE_KEY_METHOD.
+ */
+class PrivateKeyMethodProvider {
+public:
+  virtual ~PrivateKeyMethodProvider() {}
+
+  /**
+   * Associate a connection with the provider. Must be called before the handshake of the
+   * connection starts.
+   * @param ssl supplies the SSL object of the connection.
+   * @param callbacks supplies the callbacks notified when an asynchronous operation completes.
+   * @param dispatcher supplies the dispatcher of the connection, on which the callbacks are called.
+   */
+  virtual void registerPrivateKeyMethod(SSL* ssl, PrivateKeyConnectionCallbacks& callbacks,
+                                        Event::Dispatcher& dispatcher) PURE;
+
+  /**
+   * Dissociate a connection from the provider. Pending operations of the connection are abandoned
+   * and its callbacks are not called anymore. It is safe to call this more than once.
+   * @param ssl supplies the SSL object of the connection.
+   */
+  virtual void unregisterPrivateKeyMethod(SSL* ssl) PURE;
+
+  /**
+   * @return the BoringSSL private key method of the provider, installed on the SSL contexts
+   *         whose certificate uses the provider. It must outlive the contexts.
+   */
+  virtual const SSL_PRIVATE_KEY_METHOD* getBoringSslPrivateKeyMethod() const PURE;
+};
+
+typedef std::shared_ptr<PrivateKeyMethodProvider> PrivateKeyMethodProviderSharedPtr;
+
+} // namespace Ssl
+} // namespace Envoy
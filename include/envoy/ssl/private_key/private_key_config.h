@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+
+#include "envoy/common/pure.h"
+#include "envoy/ssl/private_key/private_key.h"
+
+#include "common/protobuf/protobuf.h"
+
+namespace Envoy {
+namespace Ssl {
+
+/**
+ * Implemented by each private key method provider and registered via Registry::registerFactory()
+ * or the convenience class RegisterFactory.
+ */
+class PrivateKeyMethodProviderInstanceFactory {
+public:
+  virtual ~PrivateKeyMethodProviderInstanceFactory() {}
+
+  /**
+   * Create a private key method provider for a certificate. May throw EnvoyException on invalid
+   * configuration.
+   * @param config supplies the configuration of the provider.
+   * @param private_key supplies the PEM encoded private key of the certificate, which may be empty
+   *        for providers that do not need it, e.g. because the key is held by a hardware device.
+   * @return PrivateKeyMethodProviderSharedPtr the provider.
+   */
+  virtual PrivateKeyMethodProviderSharedPtr
+  createPrivateKeyMethodProviderInstance(const ProtobufWkt::Struct& config,
+                                         const std::string& private_key) PURE;
+
+  /**
+   * @return std::string the identifying name of the provider, as referenced by the
+   *         provider_name of a certificate's private_key_provider.
+   */
+  virtual std::string name() const PURE;
+};
+
+} // namespace Ssl
+} // namespace Envoy
@@ -4,6 +4,7 @@
 #include <string>
 
 #include "envoy/common/pure.h"
+#include "envoy/ssl/private_key/private_key.h"
 
 namespace Envoy {
 namespace Ssl {
@@ -33,6 +34,12 @@ public:
    * if the private key was inlined.
    */
   virtual const std::string& privateKeyPath() const PURE;
+
+  /**
+   * @return the provider of the private key operations, or nullptr if BoringSSL uses the private
+   * key directly.
+   */
+  virtual PrivateKeyMethodProviderSharedPtr privateKeyMethod() const PURE;
 };
 
 typedef std::unique_ptr<TlsCertificateConfig> TlsCertificateConfigPtr;
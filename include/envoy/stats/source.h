@@ -45,6 +45,24 @@ public:
    */
   virtual const std::vector<ParentHistogramSharedPtr>& cachedHistograms() PURE;
 
+  /**
+   * Returns the counters that have been incremented since the cache was last cleared, at the time
+   * of the first call after clearCache(). Later calls, and calls for other sinks during the same
+   * flush, return the same set. Sinks that only report deltas can use this instead of
+   * cachedCounters() to skip idle counters.
+   * @return std::vector<CounterSharedPtr>& counters changed since the previous flush. Note:
+   * reference may not be valid after clearCache() is called.
+   */
+  virtual const std::vector<CounterSharedPtr>& cachedChangedCounters() PURE;
+
+  /**
+   * Returns the gauges that have been updated since the cache was last cleared, with the same
+   * caching behavior as cachedChangedCounters().
+   * @return std::vector<GaugeSharedPtr>& gauges changed since the previous flush. Note: reference
+   * may not be valid after clearCache() is called.
+   */
+  virtual const std::vector<GaugeSharedPtr>& cachedChangedGauges() PURE;
+
   /**
    * Resets the cache so that any future calls to get cached metrics will refresh the set.
    */
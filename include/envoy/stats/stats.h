@@ -54,6 +54,12 @@ public:
   virtual uint64_t latch() PURE;
   virtual void reset() PURE;
   virtual uint64_t value() const PURE;
+
+  /**
+   * @return bool whether the counter has been incremented since the last call, which also clears
+   *         the indication.
+   */
+  virtual bool latchChanged() PURE;
 };
 
 typedef std::shared_ptr<Counter> CounterSharedPtr;
@@ -71,6 +77,12 @@ public:
   virtual void set(uint64_t value) PURE;
   virtual void sub(uint64_t amount) PURE;
   virtual uint64_t value() const PURE;
+
+  /**
+   * @return bool whether the gauge has been updated since the last call, which also clears the
+   *         indication.
+   */
+  virtual bool latchChanged() PURE;
 };
 
 typedef std::shared_ptr<Gauge> GaugeSharedPtr;
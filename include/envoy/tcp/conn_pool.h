@@ -174,6 +174,13 @@ public:
    */
   virtual void drainConnections() PURE;
 
+  /**
+   * Open connections ahead of demand, up to the minimum pool size of the cluster's prefetch
+   * policy. Pools also prefetch on their own as connections are requested, so this is only needed
+   * to warm a pool before its first request.
+   */
+  virtual void prefetch() PURE;
+
   /**
    * Create a new connection on the pool.
    * @param cb supplies the callbacks to invoke when the connection is ready or has failed. The
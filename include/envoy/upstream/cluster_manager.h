@@ -20,6 +20,7 @@
 #include "envoy/ssl/context_manager.h"
 #include "envoy/stats/store.h"
 #include "envoy/tcp/conn_pool.h"
+#include "envoy/upstream/cluster_name_handle.h"
 #include "envoy/upstream/health_checker.h"
 #include "envoy/upstream/load_balancer.h"
 #include "envoy/upstream/thread_local_cluster.h"
@@ -62,6 +63,17 @@ public:
 
 typedef std::unique_ptr<ClusterUpdateCallbacksHandle> ClusterUpdateCallbacksHandlePtr;
 
+/**
+ * OnDemandClusterHandle is a RAII wrapper for a pending on-demand cluster load. Deleting the
+ * OnDemandClusterHandle cancels the callback of the load, but not the load itself.
+ */
+class OnDemandClusterHandle {
+public:
+  virtual ~OnDemandClusterHandle() {}
+};
+
+typedef std::unique_ptr<OnDemandClusterHandle> OnDemandClusterHandlePtr;
+
 class ClusterManagerFactory;
 
 /**
@@ -110,6 +122,26 @@ public:
    */
   virtual ThreadLocalCluster* get(const std::string& cluster) PURE;
 
+  /**
+   * Like get(const std::string&), for a cluster name interned ahead of time. Implementations may
+   * resolve the handle without hashing the name.
+   */
+  virtual ThreadLocalCluster* get(const ClusterNameHandle& cluster) { return get(cluster.name()); }
+
+  /**
+   * Load a cluster that is only known by name until it is first used. This is *per-thread*: the
+   * callback is called on the calling thread once the cluster is available via get(), or once
+   * loading it failed, e.g. because it was removed in the meantime.
+   *
+   * @param cluster supplies the name of the cluster to load.
+   * @param callback supplies the callback to call when the load is complete.
+   * @return OnDemandClusterHandlePtr a RAII that must be kept until the callback is called, or
+   *         nullptr if there is nothing to wait for, because the cluster is already available or
+   *         because it is not an on-demand cluster. In that case the callback is never called.
+   */
+  virtual OnDemandClusterHandlePtr loadOnDemandCluster(const std::string& cluster,
+                                                       std::function<void()> callback) PURE;
+
   /**
    * Allocate a load balanced HTTP connection pool for a cluster. This is *per-thread* so that
    * callers do not need to worry about per thread synchronization. The load balancing policy that
@@ -123,6 +155,16 @@ public:
                                                                  Http::Protocol protocol,
                                                                  LoadBalancerContext* context) PURE;
 
+  /**
+   * Like httpConnPoolForCluster(const std::string&, ...), for a cluster name interned ahead of
+   * time. Implementations may resolve the handle without hashing the name.
+   */
+  virtual Http::ConnectionPool::Instance*
+  httpConnPoolForCluster(const ClusterNameHandle& cluster, ResourcePriority priority,
+                         Http::Protocol protocol, LoadBalancerContext* context) {
+    return httpConnPoolForCluster(cluster.name(), priority, protocol, context);
+  }
+
   /**
    * Allocate a load balanced TCP connection pool for a cluster. This is *per-thread* so that
    * callers do not need to worry about per thread synchronization. The load balancing policy that
@@ -244,6 +286,17 @@ public:
 
 typedef std::unique_ptr<CdsApi> CdsApiPtr;
 
+/**
+ * Work done ahead of the creation of a cluster, kept alive until the cluster is created. See
+ * ClusterManagerFactory::prepareCluster().
+ */
+class ClusterPreparation {
+public:
+  virtual ~ClusterPreparation() {}
+};
+
+typedef std::unique_ptr<ClusterPreparation> ClusterPreparationPtr;
+
 /**
  * Factory for objects needed during cluster manager operation.
  */
@@ -287,6 +340,16 @@ public:
                                             AccessLog::AccessLogManager& log_manager,
                                             bool added_via_api) PURE;
 
+  /**
+   * Do the work of allocating a cluster that doesn't touch thread local state or the dispatcher,
+   * such as parsing its trusted CA certificates, ahead of clusterFromProto(). Unlike the other
+   * methods, this may be called from any thread, so that many clusters can be prepared in
+   * parallel. Errors are not reported here but when the cluster is allocated.
+   * @return ClusterPreparationPtr the prepared work, to keep alive until the cluster is allocated,
+   *         or nullptr if there is nothing to prepare.
+   */
+  virtual ClusterPreparationPtr prepareCluster(const envoy::api::v2::Cluster& cluster) PURE;
+
   /**
    * Create a CDS API provider from configuration proto.
    */
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace Envoy {
+namespace Upstream {
+
+/**
+ * A cluster name interned to a process-wide index, typically at configuration time. The cluster
+ * manager resolves a handle to its thread local cluster by indexing an array rather than hashing
+ * the name.
+ */
+class ClusterNameHandle {
+public:
+  ClusterNameHandle(const std::string& name, uint32_t index) : name_(name), index_(index) {}
+
+  /**
+   * @return const std::string& the cluster name.
+   */
+  const std::string& name() const { return name_; }
+
+  /**
+   * @return uint32_t the index the name was interned to.
+   */
+  uint32_t index() const { return index_; }
+
+private:
+  std::string name_;
+  uint32_t index_;
+};
+
+} // namespace Upstream
+} // namespace Envoy
@@ -1,9 +1,11 @@
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <string>
 
 #include "envoy/api/v2/core/base.pb.h"
+#include "envoy/common/time.h"
 #include "envoy/network/address.h"
 #include "envoy/stats/stats_macros.h"
 #include "envoy/upstream/health_check_host_monitor.h"
@@ -40,6 +42,30 @@ struct HostStats {
 
 class ClusterInfo;
 
+/**
+ * Estimates the response time of a host from the response times of its requests, for use by
+ * latency aware load balancers.
+ */
+class LatencyEstimator {
+public:
+  virtual ~LatencyEstimator() {}
+
+  /**
+   * Record the response time of a request.
+   * @param response_time supplies the time between the request being sent and its response being
+   *        received.
+   * @param now supplies the time at which the response was received.
+   */
+  virtual void putResponseTime(std::chrono::microseconds response_time, MonotonicTime now) PURE;
+
+  /**
+   * @param now supplies the current time.
+   * @return double the estimated response time of the host in microseconds, or 0 if no response
+   *         time has been recorded.
+   */
+  virtual double estimate(MonotonicTime now) const PURE;
+};
+
 /**
  * A description of an upstream host.
  */
@@ -82,6 +108,11 @@ public:
    */
   virtual HealthCheckHostMonitor& healthChecker() const PURE;
 
+  /**
+   * @return the host's response time estimator.
+   */
+  virtual LatencyEstimator& latencyEstimator() const PURE;
+
   /**
    * @return the hostname associated with the host if any.
    * Empty string "" indicates that hostname is not a DNS name.
@@ -14,7 +14,16 @@ namespace Upstream {
 /**
  * Type of load balancing to perform.
  */
-enum class LoadBalancerType { RoundRobin, LeastRequest, Random, RingHash, OriginalDst, Maglev };
+enum class LoadBalancerType {
+  RoundRobin,
+  LeastRequest,
+  Random,
+  RingHash,
+  OriginalDst,
+  Maglev,
+  BoundedLoadRingHash,
+  PeakEwma
+};
 
 /**
  * Load Balancer subset configuration.
@@ -124,7 +124,7 @@ public:
 
 typedef std::shared_ptr<Detector> DetectorSharedPtr;
 
-enum class EjectionType { Consecutive5xx, SuccessRate, ConsecutiveGatewayFailure };
+enum class EjectionType { Consecutive5xx, SuccessRate, ConsecutiveGatewayFailure, Latency };
 
 /**
  * Sink for outlier detection event logs.
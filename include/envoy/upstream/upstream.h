@@ -237,6 +237,13 @@ public:
    */
   virtual const HostsPerLocality& healthyHostsPerLocality() const PURE;
 
+  /**
+   * @return HostsPerLocalityConstSharedPtr the healthyHostsPerLocality() object itself. It is
+   *         replaced rather than modified on update, and shared by the host sets of all workers,
+   *         so it can be used to recognize the same update across workers.
+   */
+  virtual HostsPerLocalityConstSharedPtr healthyHostsPerLocalityPtr() const PURE;
+
   /**
    * @return weights for each locality in the host set.
    */
@@ -316,9 +323,19 @@ public:
 
 /**
  * All cluster stats. @see stats_macros.h
+ *
+ * The stats touched by every request come first, so that they are allocated next to each other.
  */
 // clang-format off
 #define ALL_CLUSTER_STATS(COUNTER, GAUGE, HISTOGRAM)                                               \
+  COUNTER  (upstream_rq_total)                                                                     \
+  GAUGE    (upstream_rq_active)                                                                    \
+  COUNTER  (upstream_rq_pending_total)                                                             \
+  GAUGE    (upstream_rq_pending_active)                                                            \
+  COUNTER  (upstream_cx_rx_bytes_total)                                                            \
+  GAUGE    (upstream_cx_rx_bytes_buffered)                                                         \
+  COUNTER  (upstream_cx_tx_bytes_total)                                                            \
+  GAUGE    (upstream_cx_tx_bytes_buffered)                                                         \
   COUNTER  (lb_healthy_panic)                                                                      \
   COUNTER  (lb_local_cluster_not_ok)                                                               \
   COUNTER  (lb_recalculate_zone_structures)                                                        \
@@ -352,20 +369,12 @@ public:
   COUNTER  (upstream_cx_destroy_local_with_active_rq)                                              \
   COUNTER  (upstream_cx_destroy_remote_with_active_rq)                                             \
   COUNTER  (upstream_cx_close_notify)                                                              \
-  COUNTER  (upstream_cx_rx_bytes_total)                                                            \
-  GAUGE    (upstream_cx_rx_bytes_buffered)                                                         \
-  COUNTER  (upstream_cx_tx_bytes_total)                                                            \
-  GAUGE    (upstream_cx_tx_bytes_buffered)                                                         \
   COUNTER  (upstream_cx_protocol_error)                                                            \
   COUNTER  (upstream_cx_max_requests)                                                              \
   COUNTER  (upstream_cx_none_healthy)                                                              \
-  COUNTER  (upstream_rq_total)                                                                     \
-  GAUGE    (upstream_rq_active)                                                                    \
   COUNTER  (upstream_rq_completed)                                                                 \
-  COUNTER  (upstream_rq_pending_total)                                                             \
   COUNTER  (upstream_rq_pending_overflow)                                                          \
   COUNTER  (upstream_rq_pending_failure_eject)                                                     \
-  GAUGE    (upstream_rq_pending_active)                                                            \
   COUNTER  (upstream_rq_cancelled)                                                                 \
   COUNTER  (upstream_rq_maintenance_mode)                                                          \
   COUNTER  (upstream_rq_timeout)                                                                   \
@@ -375,6 +384,11 @@ public:
   COUNTER  (upstream_rq_retry)                                                                     \
   COUNTER  (upstream_rq_retry_success)                                                             \
   COUNTER  (upstream_rq_retry_overflow)                                                            \
+  COUNTER  (upstream_rq_retry_budget_exhausted)                                                    \
+  COUNTER  (upstream_rq_hedged)                                                                    \
+  COUNTER  (upstream_rq_hedge_won)                                                                 \
+  COUNTER  (upstream_rq_hedge_overflow)                                                            \
+  GAUGE    (upstream_rq_hedge_active)                                                              \
   COUNTER  (upstream_flow_control_paused_reading_total)                                            \
   COUNTER  (upstream_flow_control_resumed_reading_total)                                           \
   COUNTER  (upstream_flow_control_backed_up_total)                                                 \
@@ -428,6 +442,51 @@ public:
 };
 typedef std::shared_ptr<const ProtocolOptionsConfig> ProtocolOptionsConfigConstSharedPtr;
 
+/**
+ * Request counts of the hosts of a cluster in one locality, used for load reporting. They are
+ * updated as requests to the hosts start and complete, so that building a load report scales with
+ * the number of localities rather than the number of hosts.
+ */
+class LocalityLoadStats {
+public:
+  virtual ~LocalityLoadStats() {}
+
+  struct Snapshot {
+    uint64_t rq_success_;
+    uint64_t rq_error_;
+    uint64_t rq_active_;
+  };
+
+  /**
+   * @return the locality. Hosts in the locality refer to it rather than keeping a copy of it.
+   */
+  virtual const envoy::api::v2::core::Locality& locality() const PURE;
+
+  /**
+   * Record requests to a host of the locality that completed successfully.
+   */
+  virtual void addSuccess(uint64_t amount) PURE;
+
+  /**
+   * Record requests to a host of the locality that failed.
+   */
+  virtual void addError(uint64_t amount) PURE;
+
+  /**
+   * Record requests to a host of the locality that started (positive amount) or completed
+   * (negative amount).
+   */
+  virtual void addActive(int64_t amount) PURE;
+
+  /**
+   * @return the requests that succeeded and failed since the previous call, and the requests
+   *         currently in progress. Only called on the main thread.
+   */
+  virtual Snapshot latch() PURE;
+};
+
+typedef std::shared_ptr<LocalityLoadStats> LocalityLoadStatsSharedPtr;
+
 /**
  * Information about a given upstream cluster.
  */
@@ -441,6 +500,8 @@ public:
     static const uint64_t USE_DOWNSTREAM_PROTOCOL = 0x2;
     // Whether connections should be immediately closed upon health failure.
     static const uint64_t CLOSE_CONNECTIONS_ON_HOST_HEALTH_FAILURE = 0x4;
+    // Whether HTTP/2 connection pools are shared across workers.
+    static const uint64_t SHARE_HTTP2_CONNECTIONS_ACROSS_WORKERS = 0x8;
   };
 
   virtual ~ClusterInfo() {}
@@ -519,6 +580,36 @@ public:
   virtual const absl::optional<envoy::api::v2::Cluster::OriginalDstLbConfig>&
   lbOriginalDstConfig() const PURE;
 
+  /**
+   * @return const absl::optional<envoy::api::v2::Cluster::MaglevLbConfig>& the configuration for
+   *         the Maglev load balancing policy, only used if type is set to MAGLEV.
+   */
+  virtual const absl::optional<envoy::api::v2::Cluster::MaglevLbConfig>&
+  lbMaglevConfig() const PURE;
+
+  /**
+   * @return const absl::optional<envoy::api::v2::Cluster::BoundedLoadRingHashLbConfig>& the
+   *         configuration for the bounded load ring hash load balancing policy, only used if type
+   *         is set to BOUNDED_LOAD_RING_HASH.
+   */
+  virtual const absl::optional<envoy::api::v2::Cluster::BoundedLoadRingHashLbConfig>&
+  lbBoundedLoadRingHashConfig() const PURE;
+
+  /**
+   * @return const absl::optional<envoy::api::v2::Cluster::LeastRequestLbConfig>& the configuration
+   *         for the least request load balancing policy, only used if type is set to
+   *         LEAST_REQUEST.
+   */
+  virtual const absl::optional<envoy::api::v2::Cluster::LeastRequestLbConfig>&
+  lbLeastRequestConfig() const PURE;
+
+  /**
+   * @return const absl::optional<envoy::api::v2::Cluster::PeakEwmaLbConfig>& the configuration for
+   *         the peak EWMA load balancing policy, only used if type is set to PEAK_EWMA.
+   */
+  virtual const absl::optional<envoy::api::v2::Cluster::PeakEwmaLbConfig>&
+  lbPeakEwmaConfig() const PURE;
+
   /**
    * @return Whether the cluster is currently in maintenance mode and should not be routed to.
    *         Different filters may handle this situation in different ways. The implementation
@@ -534,6 +625,25 @@ public:
    */
   virtual uint64_t maxRequestsPerConnection() const PURE;
 
+  /**
+   * @return uint64_t the maximum number of concurrent streams that the HTTP/2 connection pool
+   *         will place on each upstream connection before opening another connection to the
+   *         same host. 0 indicates no maximum, in which case a single connection is used.
+   */
+  virtual uint64_t maxConcurrentStreamsPerConnection() const PURE;
+
+  /**
+   * @return double the number of connections that the HTTP/1.1 and TCP connection pools keep per
+   *         active request. Values above 1 open spare connections ahead of demand.
+   */
+  virtual double prefetchRatio() const PURE;
+
+  /**
+   * @return uint32_t the minimum number of connections that each connection pool keeps open to
+   *         its host. 0 indicates that connections are only opened on demand.
+   */
+  virtual uint32_t prefetchMinConnections() const PURE;
+
   /**
    * @return the human readable name of the cluster.
    */
@@ -567,6 +677,13 @@ public:
    */
   virtual ClusterLoadReportStats& loadReportStats() const PURE;
 
+  /**
+   * @return the load stats shared by the hosts of this cluster in a locality. This may be called
+   *         from any thread.
+   */
+  virtual LocalityLoadStatsSharedPtr
+  localityLoadStats(const envoy::api::v2::core::Locality& locality) const PURE;
+
   /**
    * Returns an optional source address for upstream connections to bind to.
    *
@@ -45,6 +45,27 @@ std::string AccessLogFormatUtils::durationToString(const std::chrono::nanosecond
   return fmt::FormatInt(std::chrono::duration_cast<std::chrono::milliseconds>(time).count()).str();
 }
 
+void AccessLogFormatUtils::appendDuration(const absl::optional<std::chrono::nanoseconds>& time,
+                                          std::string& output) {
+  if (time) {
+    appendDuration(time.value(), output);
+  } else {
+    output += UnspecifiedValueString;
+  }
+}
+
+void AccessLogFormatUtils::appendDuration(const std::chrono::nanoseconds& time,
+                                          std::string& output) {
+  const fmt::FormatInt formatted(
+      std::chrono::duration_cast<std::chrono::milliseconds>(time).count());
+  output.append(formatted.data(), formatted.size());
+}
+
+void AccessLogFormatUtils::appendInt(uint64_t value, std::string& output) {
+  const fmt::FormatInt formatted(value);
+  output.append(formatted.data(), formatted.size());
+}
+
 const std::string&
 AccessLogFormatUtils::protocolToString(const absl::optional<Http::Protocol>& protocol) {
   if (protocol) {
@@ -57,19 +78,34 @@ FormatterImpl::FormatterImpl(const std::string& format) {
   formatters_ = AccessLogFormatParser::parse(format);
 }
 
+std::string FormatterBase::format(const Http::HeaderMap& request_headers,
+                                  const Http::HeaderMap& response_headers,
+                                  const Http::HeaderMap& response_trailers,
+                                  const RequestInfo::RequestInfo& request_info) const {
+  std::string output;
+  formatTo(request_headers, response_headers, response_trailers, request_info, output);
+  return output;
+}
+
 std::string FormatterImpl::format(const Http::HeaderMap& request_headers,
                                   const Http::HeaderMap& response_headers,
                                   const Http::HeaderMap& response_trailers,
                                   const RequestInfo::RequestInfo& request_info) const {
   std::string log_line;
   log_line.reserve(256);
+  formatTo(request_headers, response_headers, response_trailers, request_info, log_line);
+  return log_line;
+}
 
+void FormatterImpl::formatTo(const Http::HeaderMap& request_headers,
+                             const Http::HeaderMap& response_headers,
+                             const Http::HeaderMap& response_trailers,
+                             const RequestInfo::RequestInfo& request_info,
+                             std::string& output) const {
   for (const FormatterPtr& formatter : formatters_) {
-    log_line +=
-        formatter->format(request_headers, response_headers, response_trailers, request_info);
+    formatter->formatTo(request_headers, response_headers, response_trailers, request_info,
+                        output);
   }
-
-  return log_line;
 }
 
 void AccessLogFormatParser::parseCommandHeader(const std::string& token, const size_t start,
@@ -216,97 +252,98 @@ std::vector<FormatterPtr> AccessLogFormatParser::parse(const std::string& format
 RequestInfoFormatter::RequestInfoFormatter(const std::string& field_name) {
 
   if (field_name == "REQUEST_DURATION") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      return AccessLogFormatUtils::durationToString(request_info.lastDownstreamRxByteReceived());
+    field_extractor_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      AccessLogFormatUtils::appendDuration(request_info.lastDownstreamRxByteReceived(), output);
     };
   } else if (field_name == "RESPONSE_DURATION") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      return AccessLogFormatUtils::durationToString(request_info.firstUpstreamRxByteReceived());
+    field_extractor_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      AccessLogFormatUtils::appendDuration(request_info.firstUpstreamRxByteReceived(), output);
     };
   } else if (field_name == "RESPONSE_TX_DURATION") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
+    field_extractor_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
       auto downstream = request_info.lastDownstreamTxByteSent();
       auto upstream = request_info.firstUpstreamRxByteReceived();
 
       if (downstream && upstream) {
         auto val = downstream.value() - upstream.value();
-        return AccessLogFormatUtils::durationToString(val);
+        AccessLogFormatUtils::appendDuration(val, output);
+      } else {
+        output += UnspecifiedValueString;
       }
-
-      return UnspecifiedValueString;
     };
   } else if (field_name == "BYTES_RECEIVED") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      return fmt::FormatInt(request_info.bytesReceived()).str();
+    field_extractor_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      AccessLogFormatUtils::appendInt(request_info.bytesReceived(), output);
     };
   } else if (field_name == "PROTOCOL") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      return AccessLogFormatUtils::protocolToString(request_info.protocol());
+    field_extractor_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      output += AccessLogFormatUtils::protocolToString(request_info.protocol());
     };
   } else if (field_name == "RESPONSE_CODE") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      return request_info.responseCode() ? fmt::FormatInt(request_info.responseCode().value()).str()
-                                         : "0";
+    field_extractor_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      AccessLogFormatUtils::appendInt(
+          request_info.responseCode() ? request_info.responseCode().value() : 0, output);
     };
   } else if (field_name == "BYTES_SENT") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      return fmt::FormatInt(request_info.bytesSent()).str();
+    field_extractor_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      AccessLogFormatUtils::appendInt(request_info.bytesSent(), output);
     };
   } else if (field_name == "DURATION") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      return AccessLogFormatUtils::durationToString(request_info.requestComplete());
+    field_extractor_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      AccessLogFormatUtils::appendDuration(request_info.requestComplete(), output);
     };
   } else if (field_name == "RESPONSE_FLAGS") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      return RequestInfo::ResponseFlagUtils::toShortString(request_info);
+    field_extractor_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      output += RequestInfo::ResponseFlagUtils::toShortString(request_info);
     };
   } else if (field_name == "UPSTREAM_HOST") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
+    field_extractor_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
       if (request_info.upstreamHost()) {
-        return request_info.upstreamHost()->address()->asString();
+        output += request_info.upstreamHost()->address()->asString();
       } else {
-        return UnspecifiedValueString;
+        output += UnspecifiedValueString;
       }
     };
   } else if (field_name == "UPSTREAM_CLUSTER") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      std::string upstream_cluster_name;
-      if (nullptr != request_info.upstreamHost()) {
-        upstream_cluster_name = request_info.upstreamHost()->cluster().name();
+    field_extractor_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      if (nullptr != request_info.upstreamHost() &&
+          !request_info.upstreamHost()->cluster().name().empty()) {
+        output += request_info.upstreamHost()->cluster().name();
+      } else {
+        output += UnspecifiedValueString;
       }
-
-      return upstream_cluster_name.empty() ? UnspecifiedValueString : upstream_cluster_name;
     };
   } else if (field_name == "UPSTREAM_LOCAL_ADDRESS") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      return request_info.upstreamLocalAddress() != nullptr
-                 ? request_info.upstreamLocalAddress()->asString()
-                 : UnspecifiedValueString;
+    field_extractor_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      output += request_info.upstreamLocalAddress() != nullptr
+                    ? request_info.upstreamLocalAddress()->asString()
+                    : UnspecifiedValueString;
     };
   } else if (field_name == "DOWNSTREAM_LOCAL_ADDRESS") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      return request_info.downstreamLocalAddress()->asString();
+    field_extractor_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      output += request_info.downstreamLocalAddress()->asString();
     };
   } else if (field_name == "DOWNSTREAM_LOCAL_ADDRESS_WITHOUT_PORT") {
-    field_extractor_ = [](const Envoy::RequestInfo::RequestInfo& request_info) {
-      return RequestInfo::Utility::formatDownstreamAddressNoPort(
+    field_extractor_ = [](const Envoy::RequestInfo::RequestInfo& request_info,
+                          std::string& output) {
+      output += RequestInfo::Utility::formatDownstreamAddressNoPort(
           *request_info.downstreamLocalAddress());
     };
   } else if (field_name == "DOWNSTREAM_REMOTE_ADDRESS") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      return request_info.downstreamRemoteAddress()->asString();
+    field_extractor_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      output += request_info.downstreamRemoteAddress()->asString();
     };
   } else if (field_name == "DOWNSTREAM_REMOTE_ADDRESS_WITHOUT_PORT") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      return RequestInfo::Utility::formatDownstreamAddressNoPort(
+    field_extractor_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      output += RequestInfo::Utility::formatDownstreamAddressNoPort(
           *request_info.downstreamRemoteAddress());
     };
   } else if (field_name == "REQUESTED_SERVER_NAME") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
+    field_extractor_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
       if (!request_info.requestedServerName().empty()) {
-        return request_info.requestedServerName();
+        output += request_info.requestedServerName();
       } else {
-        return UnspecifiedValueString;
+        output += UnspecifiedValueString;
       }
     };
   } else {
@@ -314,18 +351,19 @@ RequestInfoFormatter::RequestInfoFormatter(const std::string& field_name) {
   }
 }
 
-std::string RequestInfoFormatter::format(const Http::HeaderMap&, const Http::HeaderMap&,
-                                         const Http::HeaderMap&,
-                                         const RequestInfo::RequestInfo& request_info) const {
-  return field_extractor_(request_info);
+void RequestInfoFormatter::formatTo(const Http::HeaderMap&, const Http::HeaderMap&,
+                                    const Http::HeaderMap&,
+                                    const RequestInfo::RequestInfo& request_info,
+                                    std::string& output) const {
+  field_extractor_(request_info, output);
 }
 
 PlainStringFormatter::PlainStringFormatter(const std::string& str) : str_(str) {}
 
-std::string PlainStringFormatter::format(const Http::HeaderMap&, const Http::HeaderMap&,
-                                         const Http::HeaderMap&,
-                                         const RequestInfo::RequestInfo&) const {
-  return str_;
+void PlainStringFormatter::formatTo(const Http::HeaderMap&, const Http::HeaderMap&,
+                                    const Http::HeaderMap&, const RequestInfo::RequestInfo&,
+                                    std::string& output) const {
+  output += str_;
 }
 
 HeaderFormatter::HeaderFormatter(const std::string& main_header,
@@ -333,25 +371,20 @@ HeaderFormatter::HeaderFormatter(const std::string& main_header,
                                  absl::optional<size_t> max_length)
     : main_header_(main_header), alternative_header_(alternative_header), max_length_(max_length) {}
 
-std::string HeaderFormatter::format(const Http::HeaderMap& headers) const {
+void HeaderFormatter::appendHeader(const Http::HeaderMap& headers, std::string& output) const {
   const Http::HeaderEntry* header = headers.get(main_header_);
 
   if (!header && !alternative_header_.get().empty()) {
     header = headers.get(alternative_header_);
   }
 
-  std::string header_value_string;
-  if (!header) {
-    header_value_string = UnspecifiedValueString;
+  const absl::string_view header_value =
+      header ? header->value().getStringView() : absl::string_view(UnspecifiedValueString);
+  if (max_length_ && header_value.length() > max_length_.value()) {
+    output.append(header_value.data(), max_length_.value());
   } else {
-    header_value_string = header->value().c_str();
-  }
-
-  if (max_length_ && header_value_string.length() > max_length_.value()) {
-    return header_value_string.substr(0, max_length_.value());
+    output.append(header_value.data(), header_value.size());
   }
-
-  return header_value_string;
 }
 
 ResponseHeaderFormatter::ResponseHeaderFormatter(const std::string& main_header,
@@ -359,11 +392,11 @@ ResponseHeaderFormatter::ResponseHeaderFormatter(const std::string& main_header,
                                                  absl::optional<size_t> max_length)
     : HeaderFormatter(main_header, alternative_header, max_length) {}
 
-std::string ResponseHeaderFormatter::format(const Http::HeaderMap&,
-                                            const Http::HeaderMap& response_headers,
-                                            const Http::HeaderMap&,
-                                            const RequestInfo::RequestInfo&) const {
-  return HeaderFormatter::format(response_headers);
+void ResponseHeaderFormatter::formatTo(const Http::HeaderMap&,
+                                       const Http::HeaderMap& response_headers,
+                                       const Http::HeaderMap&, const RequestInfo::RequestInfo&,
+                                       std::string& output) const {
+  appendHeader(response_headers, output);
 }
 
 RequestHeaderFormatter::RequestHeaderFormatter(const std::string& main_header,
@@ -371,10 +404,10 @@ RequestHeaderFormatter::RequestHeaderFormatter(const std::string& main_header,
                                                absl::optional<size_t> max_length)
     : HeaderFormatter(main_header, alternative_header, max_length) {}
 
-std::string RequestHeaderFormatter::format(const Http::HeaderMap& request_headers,
-                                           const Http::HeaderMap&, const Http::HeaderMap&,
-                                           const RequestInfo::RequestInfo&) const {
-  return HeaderFormatter::format(request_headers);
+void RequestHeaderFormatter::formatTo(const Http::HeaderMap& request_headers,
+                                      const Http::HeaderMap&, const Http::HeaderMap&,
+                                      const RequestInfo::RequestInfo&, std::string& output) const {
+  appendHeader(request_headers, output);
 }
 
 ResponseTrailerFormatter::ResponseTrailerFormatter(const std::string& main_header,
@@ -382,10 +415,11 @@ ResponseTrailerFormatter::ResponseTrailerFormatter(const std::string& main_heade
                                                    absl::optional<size_t> max_length)
     : HeaderFormatter(main_header, alternative_header, max_length) {}
 
-std::string ResponseTrailerFormatter::format(const Http::HeaderMap&, const Http::HeaderMap&,
-                                             const Http::HeaderMap& response_trailers,
-                                             const RequestInfo::RequestInfo&) const {
-  return HeaderFormatter::format(response_trailers);
+void ResponseTrailerFormatter::formatTo(const Http::HeaderMap&, const Http::HeaderMap&,
+                                        const Http::HeaderMap& response_trailers,
+                                        const RequestInfo::RequestInfo&,
+                                        std::string& output) const {
+  appendHeader(response_trailers, output);
 }
 
 MetadataFormatter::MetadataFormatter(const std::string& filter_namespace,
@@ -393,18 +427,21 @@ MetadataFormatter::MetadataFormatter(const std::string& filter_namespace,
                                      absl::optional<size_t> max_length)
     : filter_namespace_(filter_namespace), path_(path), max_length_(max_length) {}
 
-std::string MetadataFormatter::format(const envoy::api::v2::core::Metadata& metadata) const {
+void MetadataFormatter::appendMetadata(const envoy::api::v2::core::Metadata& metadata,
+                                       std::string& output) const {
   const Protobuf::Message* data;
   if (path_.empty()) {
     const auto filter_it = metadata.filter_metadata().find(filter_namespace_);
     if (filter_it == metadata.filter_metadata().end()) {
-      return UnspecifiedValueString;
+      output += UnspecifiedValueString;
+      return;
     }
     data = &(filter_it->second);
   } else {
     const ProtobufWkt::Value& val = Metadata::metadataValue(metadata, filter_namespace_, path_);
     if (val.kind_case() == ProtobufWkt::Value::KindCase::KIND_NOT_SET) {
-      return UnspecifiedValueString;
+      output += UnspecifiedValueString;
+      return;
     }
     data = &val;
   }
@@ -412,9 +449,10 @@ std::string MetadataFormatter::format(const envoy::api::v2::core::Metadata& meta
   const auto status = Protobuf::util::MessageToJsonString(*data, &json);
   RELEASE_ASSERT(status.ok(), "");
   if (max_length_ && json.length() > max_length_.value()) {
-    return json.substr(0, max_length_.value());
+    output.append(json, 0, max_length_.value());
+  } else {
+    output += json;
   }
-  return json;
 }
 
 // TODO(glicht): Consider adding support for route/listener/cluster metadata as suggested by @htuch.
@@ -424,21 +462,23 @@ DynamicMetadataFormatter::DynamicMetadataFormatter(const std::string& filter_nam
                                                    absl::optional<size_t> max_length)
     : MetadataFormatter(filter_namespace, path, max_length) {}
 
-std::string DynamicMetadataFormatter::format(const Http::HeaderMap&, const Http::HeaderMap&,
-                                             const Http::HeaderMap&,
-                                             const RequestInfo::RequestInfo& request_info) const {
-  return MetadataFormatter::format(request_info.dynamicMetadata());
+void DynamicMetadataFormatter::formatTo(const Http::HeaderMap&, const Http::HeaderMap&,
+                                        const Http::HeaderMap&,
+                                        const RequestInfo::RequestInfo& request_info,
+                                        std::string& output) const {
+  appendMetadata(request_info.dynamicMetadata(), output);
 }
 
 StartTimeFormatter::StartTimeFormatter(const std::string& format) : date_formatter_(format) {}
 
-std::string StartTimeFormatter::format(const Http::HeaderMap&, const Http::HeaderMap&,
-                                       const Http::HeaderMap&,
-                                       const RequestInfo::RequestInfo& request_info) const {
+void StartTimeFormatter::formatTo(const Http::HeaderMap&, const Http::HeaderMap&,
+                                  const Http::HeaderMap&,
+                                  const RequestInfo::RequestInfo& request_info,
+                                  std::string& output) const {
   if (date_formatter_.formatString().empty()) {
-    return AccessLogDateTimeFormatter::fromTime(request_info.startTime());
+    AccessLogDateTimeFormatter::appendTime(request_info.startTime(), output);
   } else {
-    return date_formatter_.fromTime(request_info.startTime());
+    date_formatter_.appendTime(request_info.startTime(), output);
   }
 }
 
@@ -74,6 +74,10 @@ public:
   static const std::string& protocolToString(const absl::optional<Http::Protocol>& protocol);
   static std::string durationToString(const absl::optional<std::chrono::nanoseconds>& time);
   static std::string durationToString(const std::chrono::nanoseconds& time);
+  static void appendDuration(const absl::optional<std::chrono::nanoseconds>& time,
+                             std::string& output);
+  static void appendDuration(const std::chrono::nanoseconds& time, std::string& output);
+  static void appendInt(uint64_t value, std::string& output);
 
 private:
   AccessLogFormatUtils();
@@ -81,18 +85,38 @@ private:
   static const std::string DEFAULT_FORMAT;
 };
 
+/**
+ * Base of the formatters which write directly into the output buffer, format() being implemented
+ * on top of formatTo().
+ */
+class FormatterBase : public Formatter {
+public:
+  // Formatter
+  std::string format(const Http::HeaderMap& request_headers,
+                     const Http::HeaderMap& response_headers,
+                     const Http::HeaderMap& response_trailers,
+                     const RequestInfo::RequestInfo& request_info) const override;
+  void formatTo(const Http::HeaderMap& request_headers, const Http::HeaderMap& response_headers,
+                const Http::HeaderMap& response_trailers,
+                const RequestInfo::RequestInfo& request_info,
+                std::string& output) const override PURE;
+};
+
 /**
  * Composite formatter implementation.
  */
-class FormatterImpl : public Formatter {
+class FormatterImpl : public FormatterBase {
 public:
   FormatterImpl(const std::string& format);
 
-  // Formatter::format
+  // Formatter
   std::string format(const Http::HeaderMap& request_headers,
                      const Http::HeaderMap& response_headers,
                      const Http::HeaderMap& response_trailers,
                      const RequestInfo::RequestInfo& request_info) const override;
+  void formatTo(const Http::HeaderMap& request_headers, const Http::HeaderMap& response_headers,
+                const Http::HeaderMap& response_trailers,
+                const RequestInfo::RequestInfo& request_info, std::string& output) const override;
 
 private:
   std::vector<FormatterPtr> formatters_;
@@ -102,13 +126,13 @@ private:
  * Formatter for string literal. It ignores headers and request info and returns string by which it
  * was initialized.
  */
-class PlainStringFormatter : public Formatter {
+class PlainStringFormatter : public FormatterBase {
 public:
   PlainStringFormatter(const std::string& str);
 
-  // Formatter::format
-  std::string format(const Http::HeaderMap&, const Http::HeaderMap&, const Http::HeaderMap&,
-                     const RequestInfo::RequestInfo&) const override;
+  // Formatter::formatTo
+  void formatTo(const Http::HeaderMap&, const Http::HeaderMap&, const Http::HeaderMap&,
+                const RequestInfo::RequestInfo&, std::string& output) const override;
 
 private:
   std::string str_;
@@ -119,7 +143,7 @@ public:
   HeaderFormatter(const std::string& main_header, const std::string& alternative_header,
                   absl::optional<size_t> max_length);
 
-  std::string format(const Http::HeaderMap& headers) const;
+  void appendHeader(const Http::HeaderMap& headers, std::string& output) const;
 
 private:
   Http::LowerCaseString main_header_;
@@ -130,56 +154,59 @@ private:
 /**
  * Formatter based on request header.
  */
-class RequestHeaderFormatter : public Formatter, HeaderFormatter {
+class RequestHeaderFormatter : public FormatterBase, HeaderFormatter {
 public:
   RequestHeaderFormatter(const std::string& main_header, const std::string& alternative_header,
                          absl::optional<size_t> max_length);
 
-  // Formatter::format
-  std::string format(const Http::HeaderMap& request_headers, const Http::HeaderMap&,
-                     const Http::HeaderMap&, const RequestInfo::RequestInfo&) const override;
+  // Formatter::formatTo
+  void formatTo(const Http::HeaderMap& request_headers, const Http::HeaderMap&,
+                const Http::HeaderMap&, const RequestInfo::RequestInfo&,
+                std::string& output) const override;
 };
 
 /**
  * Formatter based on the response header.
  */
-class ResponseHeaderFormatter : public Formatter, HeaderFormatter {
+class ResponseHeaderFormatter : public FormatterBase, HeaderFormatter {
 public:
   ResponseHeaderFormatter(const std::string& main_header, const std::string& alternative_header,
                           absl::optional<size_t> max_length);
 
-  // Formatter::format
-  std::string format(const Http::HeaderMap&, const Http::HeaderMap& response_headers,
-                     const Http::HeaderMap&, const RequestInfo::RequestInfo&) const override;
+  // Formatter::formatTo
+  void formatTo(const Http::HeaderMap&, const Http::HeaderMap& response_headers,
+                const Http::HeaderMap&, const RequestInfo::RequestInfo&,
+                std::string& output) const override;
 };
 
 /**
  * Formatter based on the response trailer.
  */
-class ResponseTrailerFormatter : public Formatter, HeaderFormatter {
+class ResponseTrailerFormatter : public FormatterBase, HeaderFormatter {
 public:
   ResponseTrailerFormatter(const std::string& main_header, const std::string& alternative_header,
                            absl::optional<size_t> max_length);
 
-  // Formatter::format
-  std::string format(const Http::HeaderMap&, const Http::HeaderMap&,
-                     const Http::HeaderMap& response_trailers,
-                     const RequestInfo::RequestInfo&) const override;
+  // Formatter::formatTo
+  void formatTo(const Http::HeaderMap&, const Http::HeaderMap&,
+                const Http::HeaderMap& response_trailers, const RequestInfo::RequestInfo&,
+                std::string& output) const override;
 };
 
 /**
  * Formatter based on the RequestInfo field.
  */
-class RequestInfoFormatter : public Formatter {
+class RequestInfoFormatter : public FormatterBase {
 public:
   RequestInfoFormatter(const std::string& field_name);
 
-  // Formatter::format
-  std::string format(const Http::HeaderMap&, const Http::HeaderMap&, const Http::HeaderMap&,
-                     const RequestInfo::RequestInfo& request_info) const override;
+  // Formatter::formatTo
+  void formatTo(const Http::HeaderMap&, const Http::HeaderMap&, const Http::HeaderMap&,
+                const RequestInfo::RequestInfo& request_info, std::string& output) const override;
 
 private:
-  std::function<std::string(const RequestInfo::RequestInfo&)> field_extractor_;
+  // Appends the field to the output.
+  std::function<void(const RequestInfo::RequestInfo&, std::string&)> field_extractor_;
 };
 
 /**
@@ -190,7 +217,7 @@ public:
   MetadataFormatter(const std::string& filter_namespace, const std::vector<std::string>& path,
                     absl::optional<size_t> max_length);
 
-  std::string format(const envoy::api::v2::core::Metadata& metadata) const;
+  void appendMetadata(const envoy::api::v2::core::Metadata& metadata, std::string& output) const;
 
 private:
   std::string filter_namespace_;
@@ -201,24 +228,26 @@ private:
 /**
  * Formatter based on the DynamicMetadata from RequestInfo.
  */
-class DynamicMetadataFormatter : public Formatter, MetadataFormatter {
+class DynamicMetadataFormatter : public FormatterBase, MetadataFormatter {
 public:
   DynamicMetadataFormatter(const std::string& filter_namespace,
                            const std::vector<std::string>& path, absl::optional<size_t> max_length);
 
-  // Formatter::format
-  std::string format(const Http::HeaderMap&, const Http::HeaderMap&, const Http::HeaderMap&,
-                     const RequestInfo::RequestInfo& request_info) const override;
+  // Formatter::formatTo
+  void formatTo(const Http::HeaderMap&, const Http::HeaderMap&, const Http::HeaderMap&,
+                const RequestInfo::RequestInfo& request_info, std::string& output) const override;
 };
 
 /**
  * Formatter
  */
-class StartTimeFormatter : public Formatter {
+class StartTimeFormatter : public FormatterBase {
 public:
   StartTimeFormatter(const std::string& format);
-  std::string format(const Http::HeaderMap&, const Http::HeaderMap&, const Http::HeaderMap&,
-                     const RequestInfo::RequestInfo&) const override;
+
+  // Formatter::formatTo
+  void formatTo(const Http::HeaderMap&, const Http::HeaderMap&, const Http::HeaderMap&,
+                const RequestInfo::RequestInfo& request_info, std::string& output) const override;
 
 private:
   const Envoy::DateFormatter date_formatter_;
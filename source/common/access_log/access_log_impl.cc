@@ -106,6 +106,7 @@ RuntimeFilter::RuntimeFilter(const envoy::config::filter::accesslog::v2::Runtime
                              Runtime::Loader& runtime, Runtime::RandomGenerator& random)
     : runtime_(runtime), random_(random), runtime_key_(config.runtime_key()),
       percent_(config.percent_sampled()),
+      denominator_(ProtobufPercentHelper::fractionalPercentDenominatorToInt(percent_)),
       use_independent_randomness_(config.use_independent_randomness()) {}
 
 bool RuntimeFilter::evaluate(const RequestInfo::RequestInfo&,
@@ -113,14 +114,12 @@ bool RuntimeFilter::evaluate(const RequestInfo::RequestInfo&,
   const Http::HeaderEntry* uuid = request_header.RequestId();
   uint64_t random_value;
   if (use_independent_randomness_ || uuid == nullptr ||
-      !UuidUtils::uuidModBy(uuid->value().c_str(), random_value,
-                            ProtobufPercentHelper::fractionalPercentDenominatorToInt(percent_))) {
+      !UuidUtils::uuidModBy(uuid->value().getStringView(), random_value, denominator_)) {
     random_value = random_.random();
   }
 
-  return runtime_.snapshot().featureEnabled(
-      runtime_key_, percent_.numerator(), random_value,
-      ProtobufPercentHelper::fractionalPercentDenominatorToInt(percent_));
+  return runtime_.snapshot().featureEnabled(runtime_key_, percent_.numerator(), random_value,
+                                            denominator_);
 }
 
 OperatorFilter::OperatorFilter(const Protobuf::RepeatedPtrField<
@@ -147,6 +147,7 @@ private:
   Runtime::RandomGenerator& random_;
   const std::string runtime_key_;
   const envoy::type::FractionalPercent percent_;
+  const uint64_t denominator_;
   const bool use_independent_randomness_;
 };
 
@@ -10,11 +10,20 @@ namespace Envoy {
 namespace Api {
 
 Event::DispatcherPtr Impl::allocateDispatcher(Event::TimeSystem& time_system) {
-  return Event::DispatcherPtr{new Event::DispatcherImpl(time_system)};
+  auto dispatcher = std::make_unique<Event::DispatcherImpl>(time_system);
+  if (io_uring_enabled_) {
+    dispatcher->enableIoUring();
+  }
+  if (coarse_timer_resolution_.count() > 0) {
+    dispatcher->enableTimerWheel(coarse_timer_resolution_);
+  }
+  return dispatcher;
 }
 
-Impl::Impl(std::chrono::milliseconds file_flush_interval_msec)
-    : file_flush_interval_msec_(file_flush_interval_msec) {}
+Impl::Impl(std::chrono::milliseconds file_flush_interval_msec, bool io_uring_enabled,
+           std::chrono::milliseconds coarse_timer_resolution)
+    : file_flush_interval_msec_(file_flush_interval_msec), io_uring_enabled_(io_uring_enabled),
+      coarse_timer_resolution_(coarse_timer_resolution) {}
 
 Filesystem::FileSharedPtr Impl::createFile(const std::string& path, Event::Dispatcher& dispatcher,
                                            Thread::BasicLockable& lock, Stats::Store& stats_store) {
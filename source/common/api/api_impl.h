@@ -15,7 +15,8 @@ namespace Api {
  */
 class Impl : public Api::Api {
 public:
-  Impl(std::chrono::milliseconds file_flush_interval_msec);
+  Impl(std::chrono::milliseconds file_flush_interval_msec, bool io_uring_enabled = false,
+       std::chrono::milliseconds coarse_timer_resolution = std::chrono::milliseconds(0));
 
   // Api::Api
   Event::DispatcherPtr allocateDispatcher(Event::TimeSystem& time_system) override;
@@ -27,6 +28,8 @@ public:
 
 private:
   std::chrono::milliseconds file_flush_interval_msec_;
+  const bool io_uring_enabled_;
+  const std::chrono::milliseconds coarse_timer_resolution_;
 };
 
 } // namespace Api
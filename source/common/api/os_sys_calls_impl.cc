@@ -5,6 +5,8 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include "common/common/macros.h"
+
 namespace Envoy {
 namespace Api {
 
@@ -91,5 +93,29 @@ SysCallIntResult OsSysCallsImpl::socket(int domain, int type, int protocol) {
   return {rc, errno};
 }
 
+SysCallIntResult OsSysCallsImpl::pipe2(int pipefd[2], int flags) {
+#ifdef __linux__
+  const int rc = ::pipe2(pipefd, flags);
+  return {rc, errno};
+#else
+  UNREFERENCED_PARAMETER(pipefd);
+  UNREFERENCED_PARAMETER(flags);
+  return {-1, ENOSYS};
+#endif
+}
+
+SysCallSizeResult OsSysCallsImpl::splice(int fd_in, int fd_out, size_t len, unsigned int flags) {
+#ifdef __linux__
+  const ssize_t rc = ::splice(fd_in, nullptr, fd_out, nullptr, len, flags);
+  return {rc, errno};
+#else
+  UNREFERENCED_PARAMETER(fd_in);
+  UNREFERENCED_PARAMETER(fd_out);
+  UNREFERENCED_PARAMETER(len);
+  UNREFERENCED_PARAMETER(flags);
+  return {-1, ENOSYS};
+#endif
+}
+
 } // namespace Api
 } // namespace Envoy
@@ -1,37 +1,110 @@
 #include "common/buffer/buffer_impl.h"
 
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "common/api/os_sys_calls_impl.h"
 #include "common/common/assert.h"
 
-#include "event2/buffer.h"
-
 namespace Envoy {
 namespace Buffer {
 
-// RawSlice is the same structure as evbuffer_iovec. This was put into place to avoid leaking
-// libevent into most code since we will likely replace evbuffer with our own implementation at
-// some point. However, we can avoid a bunch of copies since the structure is the same.
-static_assert(sizeof(RawSlice) == sizeof(evbuffer_iovec), "RawSlice != evbuffer_iovec");
-static_assert(offsetof(RawSlice, mem_) == offsetof(evbuffer_iovec, iov_base),
-              "RawSlice != evbuffer_iovec");
-static_assert(offsetof(RawSlice, len_) == offsetof(evbuffer_iovec, iov_len),
-              "RawSlice != evbuffer_iovec");
+constexpr uint64_t OwnedImpl::CopyThreshold;
+constexpr uint64_t OwnedImpl::ReserveSliceSize;
+constexpr uint64_t OwnedImpl::MaxReadSlices;
+constexpr uint64_t OwnedImpl::SpillSliceSize;
+
+SlicePtr OwnedSlice::create(uint64_t capacity) {
+  const uint64_t block_size = blockSize(capacity);
+  return SlicePtr(new (block_size)
+                      OwnedSlice(block_size - SlicePool::BlockOverhead - sizeof(OwnedSlice)));
+}
 
-void OwnedImpl::add(const void* data, uint64_t size) { evbuffer_add(buffer_.get(), data, size); }
+uint64_t OwnedSlice::blockSize(uint64_t data_size) {
+  const uint64_t overhead = SlicePool::BlockOverhead + sizeof(OwnedSlice);
+  return ((data_size + overhead + SlicePool::PageSize - 1) / SlicePool::PageSize) *
+         SlicePool::PageSize;
+}
 
-void OwnedImpl::addBufferFragment(BufferFragment& fragment) {
-  evbuffer_add_reference(
-      buffer_.get(), fragment.data(), fragment.size(),
-      [](const void*, size_t, void* arg) { static_cast<BufferFragment*>(arg)->done(); }, &fragment);
+void* OwnedSlice::operator new(size_t object_size, uint64_t block_size) {
+  ASSERT(object_size == sizeof(OwnedSlice));
+  return SlicePool::allocate(block_size);
+}
+
+namespace {
+
+uint64_t systemPageSize() {
+  static const uint64_t page_size = ::sysconf(_SC_PAGESIZE);
+  return page_size;
+}
+
+} // namespace
+
+SpillFileSharedPtr SpillFile::create(const std::string& directory) {
+  std::string path = directory + "/envoy_buffer_XXXXXX";
+  const int fd = ::mkstemp(&path[0]);
+  if (fd == -1) {
+    return nullptr;
+  }
+  ::unlink(path.c_str());
+  return SpillFileSharedPtr{new SpillFile(fd)};
+}
+
+SpillFile::~SpillFile() { Api::OsSysCallsSingleton::get().close(fd_); }
+
+uint8_t* SpillFile::map(uint64_t size) {
+  ASSERT(size % systemPageSize() == 0);
+  auto& os_syscalls = Api::OsSysCallsSingleton::get();
+  if (os_syscalls.ftruncate(fd_, size_ + size).rc_ != 0) {
+    return nullptr;
+  }
+  const Api::SysCallPtrResult result =
+      os_syscalls.mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, size_);
+  if (result.rc_ == MAP_FAILED) {
+    return nullptr;
+  }
+  size_ += size;
+  return static_cast<uint8_t*>(result.rc_);
 }
 
-void OwnedImpl::add(const std::string& data) {
-  evbuffer_add(buffer_.get(), data.c_str(), data.size());
+SlicePtr MappedSlice::create(const SpillFileSharedPtr& file, uint64_t capacity) {
+  const uint64_t page_size = systemPageSize();
+  capacity = ((capacity + page_size - 1) / page_size) * page_size;
+  uint8_t* base = file->map(capacity);
+  if (base == nullptr) {
+    return nullptr;
+  }
+  return SlicePtr{new MappedSlice(file, base, capacity)};
 }
 
+MappedSlice::~MappedSlice() { ::munmap(base_, capacity_); }
+
+void OwnedImpl::add(const void* data, uint64_t size) {
+  const uint8_t* src = static_cast<const uint8_t*>(data);
+  if (!slices_.empty()) {
+    const uint64_t copy_size = slices_.back()->append(src, size);
+    src += copy_size;
+    size -= copy_size;
+    length_ += copy_size;
+  }
+  if (size != 0) {
+    slices_.emplace_back(OwnedSlice::create(src, size));
+    length_ += size;
+  }
+}
+
+void OwnedImpl::addBufferFragment(BufferFragment& fragment) {
+  length_ += fragment.size();
+  slices_.emplace_back(std::make_unique<UnownedSlice>(fragment));
+}
+
+void OwnedImpl::add(const std::string& data) { add(data.data(), data.size()); }
+
 void OwnedImpl::add(const Instance& data) {
   uint64_t num_slices = data.getRawSlices(nullptr, 0);
   RawSlice slices[num_slices];
@@ -41,78 +114,263 @@ void OwnedImpl::add(const Instance& data) {
   }
 }
 
+void OwnedImpl::addShared(Instance& data) {
+  // See move() below for why we do the static cast here.
+  OwnedImpl& other = static_cast<OwnedImpl&>(data);
+  ASSERT(&other != this);
+  for (size_t i = 0; i < other.slices_.size(); i++) {
+    SlicePtr& slice = other.slices_[i];
+    const uint64_t slice_size = slice->dataSize();
+    if (slice_size == 0) {
+      continue;
+    }
+    std::shared_ptr<Slice> owner;
+    const SharedSlice* shared = dynamic_cast<const SharedSlice*>(slice.get());
+    if (shared != nullptr) {
+      owner = shared->owner();
+      if (!shared->immutable()) {
+        // Freeze the content of a pinned slice in both buffers, like that of owned slices below.
+        slice = std::make_unique<SharedSlice>(owner, slice->data(), slice_size);
+      }
+    } else if (dynamic_cast<const OwnedSlice*>(slice.get()) != nullptr) {
+      // Hand the slice's storage over to a shared owner, and freeze its content in both buffers.
+      owner = std::move(slice);
+      slice = std::make_unique<SharedSlice>(owner, owner->data(), slice_size);
+    } else {
+      // Fragment memory belongs to whoever added it, so it can't outlive the other buffer.
+      add(slice->data(), slice_size);
+      continue;
+    }
+    slices_.emplace_back(std::make_unique<SharedSlice>(owner, slice->data(), slice_size));
+    length_ += slice_size;
+  }
+}
+
 void OwnedImpl::prepend(absl::string_view data) {
-  evbuffer_prepend(buffer_.get(), data.data(), data.size());
+  uint64_t size = data.size();
+  if (!slices_.empty() && slices_.front()->dataSize() != 0) {
+    const uint64_t copy_size = slices_.front()->prepend(data.data(), size);
+    size -= copy_size;
+    length_ += copy_size;
+  }
+  if (size != 0) {
+    SlicePtr slice = OwnedSlice::create(size);
+    slice->prepend(data.data(), size);
+    slices_.emplace_front(std::move(slice));
+    length_ += size;
+  }
 }
 
 void OwnedImpl::prepend(Instance& data) {
-  int rc =
-      evbuffer_prepend_buffer(buffer_.get(), static_cast<LibEventInstance&>(data).buffer().get());
-  ASSERT(rc == 0);
-  ASSERT(data.length() == 0);
-  static_cast<LibEventInstance&>(data).postProcess();
+  // See move() below for why we do the static cast here.
+  OwnedImpl& other = static_cast<OwnedImpl&>(data);
+  while (!other.slices_.empty()) {
+    const uint64_t slice_size = other.slices_.back()->dataSize();
+    if (slice_size != 0) {
+      slices_.emplace_front(std::move(other.slices_.back()));
+      length_ += slice_size;
+      other.length_ -= slice_size;
+    }
+    other.slices_.pop_back();
+  }
+  ASSERT(other.length() == 0);
+  other.postProcess();
 }
 
 void OwnedImpl::commit(RawSlice* iovecs, uint64_t num_iovecs) {
-  int rc =
-      evbuffer_commit_space(buffer_.get(), reinterpret_cast<evbuffer_iovec*>(iovecs), num_iovecs);
-  ASSERT(rc == 0);
+  if (num_iovecs == 0 || slices_.empty()) {
+    return;
+  }
+  // Reservations are made from the back of the buffer and out-of-order commits aren't supported,
+  // so the first iovec must correspond either to the last slice containing any content or to one
+  // of the empty slices after it. Scan backward to find that starting point.
+  size_t slice_index = slices_.size() - 1;
+  while (slice_index > 0 && slices_[slice_index]->dataSize() == 0) {
+    slice_index--;
+  }
+  // Then scan forward, matching the slices against the iovecs in order.
+  uint64_t num_slices_committed = 0;
+  while (num_slices_committed < num_iovecs && slice_index < slices_.size()) {
+    if (slices_[slice_index]->commit(iovecs[num_slices_committed])) {
+      length_ += iovecs[num_slices_committed].len_;
+      num_slices_committed++;
+    }
+    slice_index++;
+  }
+  ASSERT(num_slices_committed == num_iovecs);
 }
 
 void OwnedImpl::copyOut(size_t start, uint64_t size, void* data) const {
   ASSERT(start + size <= length());
 
-  evbuffer_ptr start_ptr;
-  int rc = evbuffer_ptr_set(buffer_.get(), &start_ptr, start, EVBUFFER_PTR_SET);
-  ASSERT(rc != -1);
-
-  ev_ssize_t copied = evbuffer_copyout_from(buffer_.get(), &start_ptr, data, size);
-  ASSERT(static_cast<uint64_t>(copied) == size);
+  uint8_t* dest = static_cast<uint8_t*>(data);
+  for (size_t i = 0; i < slices_.size() && size != 0; i++) {
+    const auto& slice = slices_[i];
+    uint64_t data_size = slice->dataSize();
+    if (data_size <= start) {
+      start -= data_size;
+      continue;
+    }
+    const uint64_t copy_size = std::min(size, data_size - start);
+    memcpy(dest, static_cast<const uint8_t*>(slice->data()) + start, copy_size);
+    size -= copy_size;
+    dest += copy_size;
+    start = 0;
+  }
+  ASSERT(size == 0);
 }
 
 void OwnedImpl::drain(uint64_t size) {
   ASSERT(size <= length());
-  int rc = evbuffer_drain(buffer_.get(), size);
-  ASSERT(rc == 0);
+  while (size != 0 && !slices_.empty()) {
+    const uint64_t slice_size = slices_.front()->dataSize();
+    if (slice_size <= size) {
+      slices_.pop_front();
+      length_ -= slice_size;
+      size -= slice_size;
+    } else {
+      slices_.front()->drain(size);
+      length_ -= size;
+      size = 0;
+    }
+  }
+  // Release any empty slices left at the front of the buffer, except for a trailing slice which
+  // may still hold an outstanding reservation.
+  while (slices_.size() > 1 && slices_.front()->dataSize() == 0) {
+    slices_.pop_front();
+  }
 }
 
 uint64_t OwnedImpl::getRawSlices(RawSlice* out, uint64_t out_size) const {
-  return evbuffer_peek(buffer_.get(), -1, nullptr, reinterpret_cast<evbuffer_iovec*>(out),
-                       out_size);
+  uint64_t num_slices = 0;
+  for (size_t i = 0; i < slices_.size(); i++) {
+    const auto& slice = slices_[i];
+    if (slice->dataSize() == 0) {
+      continue;
+    }
+    if (num_slices < out_size) {
+      out[num_slices].mem_ = const_cast<void*>(slice->data());
+      out[num_slices].len_ = slice->dataSize();
+    }
+    // Per the definition of getRawSlices in include/envoy/buffer/buffer.h, we need to return
+    // the total number of slices needed to access all the data in the buffer, which can be
+    // larger than out_size. So we keep iterating and counting non-empty slices here, even if
+    // all the caller-supplied slices have been filled.
+    num_slices++;
+  }
+  return num_slices;
 }
 
-uint64_t OwnedImpl::length() const { return evbuffer_get_length(buffer_.get()); }
+uint64_t OwnedImpl::length() const { return length_; }
 
 void* OwnedImpl::linearize(uint32_t size) {
   ASSERT(size <= length());
-  return evbuffer_pullup(buffer_.get(), size);
+  if (slices_.empty()) {
+    return nullptr;
+  }
+  // Skip over any empty slices at the front so that the common case of the first slice already
+  // holding all of the requested data doesn't copy.
+  while (slices_.size() > 1 && slices_.front()->dataSize() == 0) {
+    slices_.pop_front();
+  }
+  if (slices_.front()->dataSize() < size) {
+    SlicePtr new_slice = OwnedSlice::create(size);
+    RawSlice reservation = new_slice->reserve(size);
+    ASSERT(reservation.mem_ != nullptr);
+    ASSERT(reservation.len_ == size);
+    copyOut(0, size, reservation.mem_);
+    new_slice->commit(reservation);
+    // Drain the copied bytes without running any post-processing logic of subclasses, since the
+    // total length of the buffer is unchanged.
+    OwnedImpl::drain(size);
+    slices_.emplace_front(std::move(new_slice));
+    length_ += size;
+  }
+  return slices_.front()->data();
+}
+
+void OwnedImpl::appendSliceOrCopy(SlicePtr&& slice) {
+  const uint64_t slice_size = slice->dataSize();
+  if (slice_size == 0) {
+    return;
+  }
+  if (slice_size <= CopyThreshold && !slices_.empty() &&
+      slices_.back()->reservableSize() >= slice_size) {
+    // Copying a small slice into the tail of this buffer is cheaper than fragmenting the buffer
+    // with a chain of tiny slices.
+    slices_.back()->append(slice->data(), slice_size);
+  } else {
+    slices_.emplace_back(std::move(slice));
+  }
+  length_ += slice_size;
 }
 
 void OwnedImpl::move(Instance& rhs) {
   // We do the static cast here because in practice we only have one buffer implementation right
-  // now and this is safe. Using the evbuffer move routines require having access to both evbuffers.
-  // This is a reasonable compromise in a high performance path where we want to maintain an
-  // abstraction in case we get rid of evbuffer later.
-  int rc = evbuffer_add_buffer(buffer_.get(), static_cast<LibEventInstance&>(rhs).buffer().get());
-  ASSERT(rc == 0);
-  static_cast<LibEventInstance&>(rhs).postProcess();
+  // now and this is safe. Moving slices requires access to the internals of both buffers. This
+  // is a reasonable compromise in a high performance path where we want to maintain the
+  // Buffer::Instance abstraction.
+  OwnedImpl& other = static_cast<OwnedImpl&>(rhs);
+  while (!other.slices_.empty()) {
+    appendSliceOrCopy(std::move(other.slices_.front()));
+    other.slices_.pop_front();
+  }
+  other.length_ = 0;
+  other.postProcess();
 }
 
 void OwnedImpl::move(Instance& rhs, uint64_t length) {
   // See move() above for why we do the static cast.
-  int rc = evbuffer_remove_buffer(static_cast<LibEventInstance&>(rhs).buffer().get(), buffer_.get(),
-                                  length);
-  ASSERT(static_cast<uint64_t>(rc) == length);
-  static_cast<LibEventInstance&>(rhs).postProcess();
+  OwnedImpl& other = static_cast<OwnedImpl&>(rhs);
+  ASSERT(length <= other.length_);
+  while (length != 0 && !other.slices_.empty()) {
+    const uint64_t slice_size = other.slices_.front()->dataSize();
+    if (slice_size <= length) {
+      appendSliceOrCopy(std::move(other.slices_.front()));
+      other.slices_.pop_front();
+      other.length_ -= slice_size;
+      length -= slice_size;
+    } else {
+      // Only part of this slice is being moved, so copy it.
+      add(other.slices_.front()->data(), length);
+      other.slices_.front()->drain(length);
+      other.length_ -= length;
+      length = 0;
+    }
+  }
+  other.postProcess();
+}
+
+SliceReferenceSharedPtr OwnedImpl::pin(const void* data, uint64_t size) {
+  const uint8_t* start = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < slices_.size(); i++) {
+    SlicePtr& slice = slices_[i];
+    const uint8_t* slice_start = static_cast<const uint8_t*>(slice->data());
+    if (start < slice_start || start + size > slice_start + slice->dataSize()) {
+      continue;
+    }
+    const SharedSlice* shared = dynamic_cast<const SharedSlice*>(slice.get());
+    if (shared != nullptr) {
+      return shared->owner();
+    }
+    if (dynamic_cast<const OwnedSlice*>(slice.get()) == nullptr) {
+      // Fragment memory belongs to whoever added it, so it can't outlive the buffer.
+      return nullptr;
+    }
+    // Hand the slice's storage over to a shared owner and keep using it through a SharedSlice.
+    std::shared_ptr<Slice> owner(std::move(slice));
+    slice = std::make_unique<SharedSlice>(owner);
+    return owner;
+  }
+  return nullptr;
 }
 
 Api::SysCallIntResult OwnedImpl::read(int fd, uint64_t max_length) {
   if (max_length == 0) {
     return {0, 0};
   }
-  constexpr uint64_t MaxSlices = 2;
-  RawSlice slices[MaxSlices];
-  const uint64_t num_slices = reserve(max_length, slices, MaxSlices);
+  RawSlice slices[MaxReadSlices];
+  const uint64_t num_slices = reserve(max_length, slices, MaxReadSlices);
   struct iovec iov[num_slices];
   uint64_t num_slices_to_read = 0;
   uint64_t num_bytes_to_read = 0;
@@ -123,7 +381,7 @@ Api::SysCallIntResult OwnedImpl::read(int fd, uint64_t max_length) {
     iov[num_slices_to_read].iov_len = slice_length;
     num_bytes_to_read += slice_length;
   }
-  ASSERT(num_slices_to_read <= MaxSlices);
+  ASSERT(num_slices_to_read <= MaxReadSlices);
   ASSERT(num_bytes_to_read <= max_length);
   auto& os_syscalls = Api::OsSysCallsSingleton::get();
   const Api::SysCallSizeResult result =
@@ -146,22 +404,175 @@ Api::SysCallIntResult OwnedImpl::read(int fd, uint64_t max_length) {
   return {static_cast<int>(result.rc_), result.errno_};
 }
 
+void OwnedImpl::spill(uint64_t memory_bytes, const SpillFileSharedPtr& file) {
+  // The last slice with content, and any empty slices after it, may hold outstanding reservations.
+  size_t last_content_slice = slices_.size();
+  while (last_content_slice > 0 && slices_[last_content_slice - 1]->dataSize() == 0) {
+    last_content_slice--;
+  }
+
+  // Rotate every slice through the deque, replacing the runs of content to spill with mapped
+  // slices on the way.
+  const size_t num_slices = slices_.size();
+  uint64_t offset = 0;
+  SlicePtr mapped;
+  bool file_full = false;
+  for (size_t i = 0; i < num_slices; i++) {
+    SlicePtr slice = std::move(slices_.front());
+    slices_.pop_front();
+    const uint64_t slice_start = offset;
+    offset += slice->dataSize();
+    if (slice_start < memory_bytes || i + 1 >= last_content_slice || slice->dataSize() == 0 ||
+        slice->fileBacked() || file_full) {
+      if (mapped != nullptr) {
+        slices_.emplace_back(std::move(mapped));
+      }
+      slices_.emplace_back(std::move(slice));
+      continue;
+    }
+    while (slice->dataSize() > 0) {
+      if (mapped == nullptr || mapped->reservableSize() == 0) {
+        if (mapped != nullptr) {
+          slices_.emplace_back(std::move(mapped));
+        }
+        mapped = MappedSlice::create(file, std::max(SpillSliceSize, slice->dataSize()));
+        if (mapped == nullptr) {
+          file_full = true;
+          break;
+        }
+      }
+      slice->drain(mapped->append(slice->data(), slice->dataSize()));
+    }
+    if (slice->dataSize() > 0) {
+      slices_.emplace_back(std::move(slice));
+    }
+  }
+  ASSERT(mapped == nullptr);
+}
+
+void OwnedImpl::releaseEmptySlices() {
+  while (!slices_.empty() && slices_.back()->dataSize() == 0) {
+    slices_.pop_back();
+  }
+}
+
 uint64_t OwnedImpl::reserve(uint64_t length, RawSlice* iovecs, uint64_t num_iovecs) {
-  uint64_t ret = evbuffer_reserve_space(buffer_.get(), length,
-                                        reinterpret_cast<evbuffer_iovec*>(iovecs), num_iovecs);
-  ASSERT(ret >= 1);
-  return ret;
+  if (num_iovecs == 0 || length == 0) {
+    return 0;
+  }
+  // Find the sequence of slices with reservable space at the back of the buffer: the last slice
+  // containing any content, followed by any empty slices left over from earlier reservations.
+  size_t first_reservable_slice = slices_.size();
+  while (first_reservable_slice > 0) {
+    if (slices_[first_reservable_slice - 1]->reservableSize() == 0) {
+      break;
+    }
+    first_reservable_slice--;
+    if (slices_[first_reservable_slice]->dataSize() != 0) {
+      // There is content in this slice, so any slices in front of it are not reservable.
+      break;
+    }
+  }
+
+  // Reserve as much space as possible from each of those slices.
+  uint64_t num_slices_used = 0;
+  uint64_t bytes_remaining = length;
+  size_t slice_index = first_reservable_slice;
+  while (slice_index < slices_.size() && bytes_remaining != 0 && num_slices_used < num_iovecs) {
+    auto& slice = slices_[slice_index];
+    const uint64_t reservation_size = std::min(slice->reservableSize(), bytes_remaining);
+    if (num_slices_used + 1 == num_iovecs && reservation_size < bytes_remaining) {
+      // There is only one iovec left and this slice can't complete the reservation. Leave the
+      // last iovec for the new slice allocated below.
+      break;
+    }
+    iovecs[num_slices_used] = slice->reserve(reservation_size);
+    bytes_remaining -= iovecs[num_slices_used].len_;
+    num_slices_used++;
+    slice_index++;
+  }
+
+  // If needed, allocate more slices at the end to provide the remainder of the reservation. The
+  // last iovec always takes whatever is left, so the reservation is complete.
+  while (bytes_remaining != 0) {
+    const uint64_t slice_size = num_slices_used + 1 == num_iovecs
+                                    ? bytes_remaining
+                                    : std::min(bytes_remaining, ReserveSliceSize);
+    slices_.emplace_back(OwnedSlice::create(slice_size));
+    iovecs[num_slices_used] = slices_.back()->reserve(slice_size);
+    bytes_remaining -= iovecs[num_slices_used].len_;
+    num_slices_used++;
+  }
+
+  ASSERT(num_slices_used <= num_iovecs);
+  ASSERT(bytes_remaining == 0);
+  return num_slices_used;
 }
 
 ssize_t OwnedImpl::search(const void* data, uint64_t size, size_t start) const {
-  evbuffer_ptr start_ptr;
-  if (-1 == evbuffer_ptr_set(buffer_.get(), &start_ptr, start, EVBUFFER_PTR_SET)) {
+  // This implementation uses the same search algorithm as evbuffer_search(), a naive
+  // scan that requires O(M*N) comparisons in the worst case.
+  if (start > length_) {
     return -1;
   }
-
-  evbuffer_ptr result_ptr =
-      evbuffer_search(buffer_.get(), static_cast<const char*>(data), size, &start_ptr);
-  return result_ptr.pos;
+  if (size == 0) {
+    return start;
+  }
+  const uint8_t* needle = static_cast<const uint8_t*>(data);
+  uint64_t offset = 0;
+  const size_t num_slices = slices_.size();
+  for (size_t slice_index = 0; slice_index < num_slices; slice_index++) {
+    const auto& slice = slices_[slice_index];
+    const uint64_t slice_size = slice->dataSize();
+    if (slice_size <= start) {
+      start -= slice_size;
+      offset += slice_size;
+      continue;
+    }
+    const uint8_t* slice_start = static_cast<const uint8_t*>(slice->data());
+    const uint8_t* haystack = slice_start + start;
+    const uint8_t* haystack_end = slice_start + slice_size;
+    while (haystack < haystack_end) {
+      // Search within this slice for the first byte of the needle.
+      const void* first_byte_match = memchr(haystack, needle[0], haystack_end - haystack);
+      if (first_byte_match == nullptr) {
+        break;
+      }
+      haystack = static_cast<const uint8_t*>(first_byte_match);
+      // After finding a match for the first byte of the needle, check whether the following
+      // bytes in the buffer match the remainder of the needle. Note that the match can span
+      // two or more slices.
+      uint64_t i = 1;
+      size_t match_index = slice_index;
+      const uint8_t* match_next = haystack + 1;
+      const uint8_t* match_end = haystack_end;
+      while (i < size) {
+        if (match_next >= match_end) {
+          if (++match_index == num_slices) {
+            // We've hit the end of the buffer.
+            return -1;
+          }
+          const auto& match_slice = slices_[match_index];
+          match_next = static_cast<const uint8_t*>(match_slice->data());
+          match_end = match_next + match_slice->dataSize();
+          continue;
+        }
+        if (*match_next++ != needle[i]) {
+          break;
+        }
+        i++;
+      }
+      if (i == size) {
+        // Successful match of the entire needle.
+        return offset + (haystack - slice_start);
+      }
+      // If this wasn't a successful match, start scanning again at the next byte.
+      haystack++;
+    }
+    start = 0;
+    offset += slice_size;
+  }
+  return -1;
 }
 
 Api::SysCallIntResult OwnedImpl::write(int fd) {
@@ -188,7 +599,7 @@ Api::SysCallIntResult OwnedImpl::write(int fd) {
   return {static_cast<int>(result.rc_), result.errno_};
 }
 
-OwnedImpl::OwnedImpl() : buffer_(evbuffer_new()) {}
+OwnedImpl::OwnedImpl() {}
 
 OwnedImpl::OwnedImpl(const std::string& data) : OwnedImpl() { add(data); }
 
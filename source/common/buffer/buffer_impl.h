@@ -1,12 +1,16 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
+#include <memory>
 #include <string>
 
 #include "envoy/buffer/buffer.h"
 
+#include "common/buffer/slice_pool.h"
+#include "common/common/assert.h"
 #include "common/common/non_copyable.h"
-#include "common/event/libevent.h"
 
 namespace Envoy {
 namespace Buffer {
@@ -46,32 +50,462 @@ private:
   const std::function<void(const void*, size_t, const BufferFragmentImpl*)> releasor_;
 };
 
-class LibEventInstance : public Instance {
+/**
+ * A Slice manages a contiguous block of bytes.
+ * The block is arranged like this:
+ *                   |<- dataSize() ->|<- reservableSize() ->|
+ * +-----------------+----------------+----------------------+
+ * | Drained         | Data           | Reservable           |
+ * | Unused space    | Usable content | New content can be   |
+ * | that formerly   |                | added here with      |
+ * | was in the Data |                | reserve()/commit()   |
+ * | section         |                |                      |
+ * +-----------------+----------------+----------------------+
+ *                   ^
+ *                   |
+ *                   data()
+ */
+class Slice {
 public:
-  // Allows access into the underlying buffer for move() optimizations.
-  virtual Event::Libevent::BufferPtr& buffer() PURE;
-  // Called after accessing the memory in buffer() directly to allow any post-processing.
-  virtual void postProcess() PURE;
+  virtual ~Slice() {}
+
+  /**
+   * @return a pointer to the start of the usable content.
+   */
+  const void* data() const { return base_ + data_; }
+
+  /**
+   * @return a pointer to the start of the usable content.
+   */
+  void* data() { return base_ + data_; }
+
+  /**
+   * @return the size in bytes of the usable content.
+   */
+  uint64_t dataSize() const { return reservable_ - data_; }
+
+  /**
+   * Remove the first size bytes of usable content. Runs in O(1) time.
+   * @param size number of bytes to remove. If greater than data_size(), the result is undefined.
+   */
+  void drain(uint64_t size) {
+    ASSERT(data_ + size <= reservable_);
+    data_ += size;
+  }
+
+  /**
+   * @return the number of bytes available to be reserved.
+   * @note Read-only implementations of Slice should return zero from this method.
+   */
+  uint64_t reservableSize() const {
+    ASSERT(capacity_ >= reservable_);
+    return capacity_ - reservable_;
+  }
+
+  /**
+   * Reserve `size` bytes that the caller can populate with content. The caller SHOULD then
+   * call commit() to add the newly populated content from the Reserved section to the Data
+   * section.
+   * @note If there is already an outstanding reservation (i.e., a reservation obtained
+   *       from reserve() that has not been released by calling commit()), this method will
+   *       return a new reservation that replaces it.
+   * @param size the number of bytes to reserve. The Slice implementation MAY reserve
+   *        fewer bytes than requested (for example, if it doesn't have enough room in the
+   *        Reservable section to fulfill the whole request).
+   * @return a tuple containing the address of the start of resulting reservation and the
+   *         reservation size in bytes. If the address is null, the reservation failed.
+   */
+  RawSlice reserve(uint64_t size) {
+    if (size == 0) {
+      return {nullptr, 0};
+    }
+    const uint64_t available_size = capacity_ - reservable_;
+    if (available_size == 0) {
+      return {nullptr, 0};
+    }
+    const uint64_t reservation_size = std::min(size, available_size);
+    void* reservation = &(base_[reservable_]);
+    return {reservation, static_cast<size_t>(reservation_size)};
+  }
+
+  /**
+   * Commit a Reservation that was previously obtained from a call to reserve().
+   * The Reservation's size is added to the Data section.
+   * @param reservation a reservation obtained from a previous call to reserve().
+   *        If the reservation is not from this Slice, commit() will return false.
+   *        If the caller is committing fewer bytes than provided by reserve(), it
+   *        should change the len_ field of the reservation before calling commit().
+   *        For example, if a caller reserve()s 4KB to do a nonblocking socket read,
+   *        and the read only returns two bytes, the caller should set
+   *        reservation.len_ = 2 and then call `commit(reservation)`.
+   * @return whether the Reservation was successfully committed to the Slice.
+   */
+  bool commit(const RawSlice& reservation) {
+    if (static_cast<const uint8_t*>(reservation.mem_) != base_ + reservable_ ||
+        reservable_ + reservation.len_ > capacity_ || reservable_ >= capacity_) {
+      // The reservation is not from this OwnedSlice.
+      return false;
+    }
+    reservable_ += reservation.len_;
+    return true;
+  }
+
+  /**
+   * Copy as much of the supplied data as possible to the end of the slice.
+   * @param data start of the data to copy.
+   * @param size number of bytes to copy.
+   * @return number of bytes copied (may be a smaller than size, may even be zero).
+   */
+  uint64_t append(const void* data, uint64_t size) {
+    uint64_t copy_size = std::min(size, reservableSize());
+    uint8_t* dest = base_ + reservable_;
+    reservable_ += copy_size;
+    // NOLINTNEXTLINE(clang-analyzer-core.NullDereference)
+    memcpy(dest, data, copy_size);
+    return copy_size;
+  }
+
+  /**
+   * Copy as much of the supplied data as possible to the front of the slice.
+   * If only part of the data will fit in the slice, the bytes from the _end_ are
+   * copied.
+   * @param data start of the data to copy.
+   * @param size number of bytes to copy.
+   * @return number of bytes copied (may be a smaller than size, may even be zero).
+   */
+  uint64_t prepend(const void* data, uint64_t size) {
+    const uint8_t* src = static_cast<const uint8_t*>(data);
+    uint64_t copy_size;
+    if (dataSize() == 0) {
+      // There is nothing in the slice, so put the data at the very end in case the caller
+      // later tries to prepend anything else in front of it.
+      copy_size = std::min(size, reservableSize());
+      reservable_ = capacity_;
+      data_ = capacity_ - copy_size;
+    } else {
+      if (data_ == 0 || shared_) {
+        // There is content in the slice, and no space in front of it to write anything. The
+        // drained space of shared storage may still be referenced, e.g. by pinned header values.
+        return 0;
+      }
+      // Write into the space in front of the slice's current content.
+      copy_size = std::min(size, data_);
+      data_ -= copy_size;
+    }
+    memcpy(base_ + data_, src + size - copy_size, copy_size);
+    return copy_size;
+  }
+
+  /**
+   * @return whether the storage of the slice maps a SpillFile rather than memory.
+   */
+  bool fileBacked() const { return file_backed_; }
+
+protected:
+  Slice(uint64_t data, uint64_t reservable, uint64_t capacity)
+      : data_(data), reservable_(reservable), capacity_(capacity) {}
+
+  /** Start of the slice - subclasses must set this */
+  uint8_t* base_{nullptr};
+
+  /** Offset in bytes from the start of the slice to the start of the Data section */
+  uint64_t data_;
+
+  /** Offset in bytes from the start of the slice to the start of the Reservable section */
+  uint64_t reservable_;
+
+  /** Total number of bytes in the slice */
+  uint64_t capacity_;
+
+  /** Whether the slice is a read-only view, which never writes to its storage */
+  bool immutable_{false};
+
+  /** Whether the storage is shared, so that its drained space must not be reused by prepend() */
+  bool shared_{false};
+
+  /** Whether the storage maps a SpillFile */
+  bool file_backed_{false};
+};
+
+typedef std::unique_ptr<Slice> SlicePtr;
+
+/**
+ * A Slice that owns its storage. The storage is allocated in the same block of memory as the
+ * slice object itself, so creating a slice costs a single allocation. Blocks of the common small
+ * sizes are recycled through a per-thread free list rather than being returned to the heap.
+ */
+class OwnedSlice : public Slice {
+public:
+  /**
+   * Create an empty OwnedSlice.
+   * @param capacity number of bytes of space the slice should have.
+   * @return an OwnedSlice with at least the specified capacity.
+   */
+  static SlicePtr create(uint64_t capacity);
+
+  /**
+   * Create an OwnedSlice and initialize it with a copy of the supplied data.
+   * @param data the content to copy into the slice.
+   * @param size length of the content.
+   * @return an OwnedSlice containing a copy of the content, which may (dependent on
+   *         the internal implementation) have a nonzero amount of reservable space at the end.
+   */
+  static SlicePtr create(const void* data, uint64_t size) {
+    SlicePtr slice = create(size);
+    slice->append(data, size);
+    return slice;
+  }
+
+  // Returns the block backing the slice to the SlicePool.
+  static void operator delete(void* address) { SlicePool::free(address); }
+
+private:
+  // The storage of the slice immediately follows the slice object in its block.
+  OwnedSlice(uint64_t capacity) : Slice(0, 0, capacity) {
+    base_ = reinterpret_cast<uint8_t*>(this + 1);
+  }
+
+  // Placement allocation of a block of block_size bytes holding the slice and its storage.
+  static void* operator new(size_t object_size, uint64_t block_size);
+  static void operator delete(void* address, uint64_t) { SlicePool::free(address); }
+
+  /**
+   * Compute the allocation size of a block big enough to hold a slice with the specified amount
+   * of storage.
+   * @param data_size the minimum amount of data the slice must be able to store, in bytes.
+   * @return the recommended block size, in bytes.
+   */
+  static uint64_t blockSize(uint64_t data_size);
+};
+
+/**
+ * A Slice that refers to externally owned data supplied by a BufferFragment. When the slice is
+ * destroyed, the fragment's done() method is called.
+ */
+class UnownedSlice : public Slice {
+public:
+  UnownedSlice(BufferFragment& fragment)
+      : Slice(0, fragment.size(), fragment.size()), fragment_(fragment) {
+    base_ = static_cast<uint8_t*>(const_cast<void*>(fragment.data()));
+  }
+
+  ~UnownedSlice() override { fragment_.done(); }
+
+private:
+  BufferFragment& fragment_;
 };
 
 /**
- * Wraps an allocated and owned evbuffer.
+ * A Slice that shares the storage of another slice. The storage is released once every slice
+ * sharing it and every reference returned by owner() are gone.
+ */
+class SharedSlice : public Slice {
+public:
+  /**
+   * Create the slice that takes over the storage of a pinned slice. It keeps appending to the
+   * space left after the content.
+   * @param owner supplies the pinned slice.
+   */
+  SharedSlice(std::shared_ptr<Slice> owner)
+      : Slice(0, owner->dataSize(), owner->dataSize() + owner->reservableSize()),
+        owner_(std::move(owner)) {
+    base_ = static_cast<uint8_t*>(owner_->data());
+    shared_ = true;
+  }
+
+  /**
+   * Create an immutable view of content held by a shared slice. The view has no reservable space
+   * and never writes to the storage.
+   * @param owner supplies the slice owning the storage.
+   * @param data supplies the start of the content, which must lie within the owner's storage.
+   * @param size supplies the length of the content.
+   */
+  SharedSlice(std::shared_ptr<Slice> owner, const void* data, uint64_t size)
+      : Slice(0, size, size), owner_(std::move(owner)) {
+    base_ = static_cast<uint8_t*>(const_cast<void*>(data));
+    immutable_ = true;
+    shared_ = true;
+  }
+
+  const std::shared_ptr<Slice>& owner() const { return owner_; }
+  bool immutable() const { return immutable_; }
+
+private:
+  const std::shared_ptr<Slice> owner_;
+};
+
+/**
+ * An unlinked temporary file that buffers spill their content to. Its space is released once the
+ * file and every slice mapping it are gone.
+ */
+class SpillFile : NonCopyable {
+public:
+  /**
+   * Create a file in a directory.
+   * @param directory supplies the directory to create the file in.
+   * @return the file, or nullptr if it could not be created.
+   */
+  static std::shared_ptr<SpillFile> create(const std::string& directory);
+
+  ~SpillFile();
+
+  /**
+   * Extend the file and map the new space.
+   * @param size supplies the number of bytes to map, which must be a multiple of the page size.
+   * @return the start of the mapping, or nullptr if the file could not be extended or mapped.
+   */
+  uint8_t* map(uint64_t size);
+
+private:
+  SpillFile(int fd) : fd_(fd) {}
+
+  const int fd_;
+  uint64_t size_{0};
+};
+
+typedef std::shared_ptr<SpillFile> SpillFileSharedPtr;
+
+/**
+ * A Slice whose storage is a shared mapping of space in a SpillFile. Its pages belong to the page
+ * cache, so the kernel writes them back to the file and reclaims them under memory pressure, and
+ * reads them back in on access.
+ */
+class MappedSlice : public Slice {
+public:
+  /**
+   * Create an empty MappedSlice.
+   * @param file supplies the file to map space of.
+   * @param capacity supplies the number of bytes of space the slice should have, rounded up to a
+   *        multiple of the page size.
+   * @return the slice, or nullptr if the space could not be mapped.
+   */
+  static SlicePtr create(const SpillFileSharedPtr& file, uint64_t capacity);
+
+  ~MappedSlice() override;
+
+private:
+  MappedSlice(SpillFileSharedPtr file, uint8_t* base, uint64_t capacity)
+      : Slice(0, 0, capacity), file_(std::move(file)) {
+    base_ = base;
+    file_backed_ = true;
+  }
+
+  const SpillFileSharedPtr file_;
+};
+
+/**
+ * Queue of SlicePtr that supports efficient read and write access to both
+ * the front and the back of the queue.
+ * @note This class has similar properties to std::deque<T>. The reason for using
+ *       a custom deque implementation is that benchmark testing during development
+ *       revealed that std::deque was too slow to reach performance parity with the
+ *       prior evbuffer-based buffer implementation.
+ */
+class SliceDeque : NonCopyable {
+public:
+  SliceDeque() : ring_(inline_ring_), capacity_(InlineRingCapacity) {}
+
+  void emplace_back(SlicePtr&& slice) {
+    growRing();
+    size_t index = internalIndex(size_);
+    ring_[index] = std::move(slice);
+    size_++;
+  }
+
+  void emplace_front(SlicePtr&& slice) {
+    growRing();
+    start_ = (start_ == 0) ? capacity_ - 1 : start_ - 1;
+    ring_[start_] = std::move(slice);
+    size_++;
+  }
+
+  bool empty() const { return size() == 0; }
+  size_t size() const { return size_; }
+
+  SlicePtr& front() { return ring_[start_]; }
+  const SlicePtr& front() const { return ring_[start_]; }
+  SlicePtr& back() { return ring_[internalIndex(size_ - 1)]; }
+  const SlicePtr& back() const { return ring_[internalIndex(size_ - 1)]; }
+
+  SlicePtr& operator[](size_t i) { return ring_[internalIndex(i)]; }
+  const SlicePtr& operator[](size_t i) const { return ring_[internalIndex(i)]; }
+
+  void pop_front() {
+    if (size() == 0) {
+      return;
+    }
+    front().reset();
+    size_--;
+    start_++;
+    if (start_ == capacity_) {
+      start_ = 0;
+    }
+  }
+
+  void pop_back() {
+    if (size() == 0) {
+      return;
+    }
+    back().reset();
+    size_--;
+  }
+
+private:
+  constexpr static size_t InlineRingCapacity = 8;
+
+  size_t internalIndex(size_t index) const {
+    size_t internal_index = start_ + index;
+    if (internal_index >= capacity_) {
+      internal_index -= capacity_;
+      ASSERT(internal_index < capacity_);
+    }
+    return internal_index;
+  }
+
+  void growRing() {
+    if (size_ < capacity_) {
+      return;
+    }
+    const size_t new_capacity = capacity_ * 2;
+    auto new_ring = std::make_unique<SlicePtr[]>(new_capacity);
+    for (size_t i = 0; i < size_; i++) {
+      new_ring[i] = std::move(ring_[internalIndex(i)]);
+    }
+    external_ring_ = std::move(new_ring);
+    ring_ = external_ring_.get();
+    start_ = 0;
+    capacity_ = new_capacity;
+  }
+
+  SlicePtr inline_ring_[InlineRingCapacity];
+  std::unique_ptr<SlicePtr[]> external_ring_;
+  SlicePtr* ring_; // points to start of either inline or external ring.
+  size_t start_{0};
+  size_t size_{0};
+  size_t capacity_;
+};
+
+/**
+ * An implementation of Buffer::Instance built from a queue of slices. Data added to the buffer is
+ * copied into owned slices, while move() and prepend(Instance&) transfer whole slices between
+ * buffers without copying, and addShared() makes both buffers refer to the same slice storage.
  *
- * Note that due to the internals of move() accessing buffer(), OwnedImpl is not
- * compatible with non-LibEventInstance buffers.
+ * Note that due to the internals of move() accessing the slices of the source buffer, OwnedImpl
+ * is not compatible with non-OwnedImpl buffers.
  */
-class OwnedImpl : public LibEventInstance {
+class OwnedImpl : public Instance {
 public:
   OwnedImpl();
   OwnedImpl(const std::string& data);
   OwnedImpl(const Instance& data);
   OwnedImpl(const void* data, uint64_t size);
 
-  // LibEventInstance
+  // Buffer::Instance
   void add(const void* data, uint64_t size) override;
   void addBufferFragment(BufferFragment& fragment) override;
   void add(const std::string& data) override;
   void add(const Instance& data) override;
+  void addShared(Instance& data) override;
   void prepend(absl::string_view data) override;
   void prepend(Instance& data) override;
   void commit(RawSlice* iovecs, uint64_t num_iovecs) override;
@@ -82,17 +516,53 @@ public:
   void* linearize(uint32_t size) override;
   void move(Instance& rhs) override;
   void move(Instance& rhs, uint64_t length) override;
+  SliceReferenceSharedPtr pin(const void* data, uint64_t size) override;
   Api::SysCallIntResult read(int fd, uint64_t max_length) override;
+  void releaseEmptySlices() override;
   uint64_t reserve(uint64_t length, RawSlice* iovecs, uint64_t num_iovecs) override;
   ssize_t search(const void* data, uint64_t size, size_t start) const override;
   Api::SysCallIntResult write(int fd) override;
-  void postProcess() override {}
   std::string toString() const override;
 
-  Event::Libevent::BufferPtr& buffer() override { return buffer_; }
+  // Called after the content of this buffer has been drained directly by move() or prepend() on
+  // another buffer, to allow any post-processing (e.g. watermark checks).
+  virtual void postProcess() {}
+
+  // Slices smaller than this are copied rather than moved by move() when the tail of the
+  // destination buffer has room for them, to avoid building up long chains of tiny slices.
+  static constexpr uint64_t CopyThreshold = 512;
+
+  // reserve() spreads large reservations over slices of at most this size when it has spare
+  // iovecs, so that the slices stay within the SlicePool's pooled block sizes.
+  static constexpr uint64_t ReserveSliceSize = 16384;
+
+  // Maximum number of slices read() fills with a single readv().
+  static constexpr uint64_t MaxReadSlices = 8;
+
+  // The size of the slices spill() copies content to.
+  static constexpr uint64_t SpillSliceSize = 1024 * 1024;
+
+protected:
+  /**
+   * Move the content past the first memory_bytes bytes into slices mapping a file, so that it no
+   * longer takes up memory. The last slice is left in memory, since the content added next goes
+   * there. If the file runs out of space, the rest of the content stays in memory.
+   * @param memory_bytes supplies the number of bytes at the front of the buffer to keep in memory.
+   * @param file supplies the file to map.
+   */
+  void spill(uint64_t memory_bytes, const SpillFileSharedPtr& file);
 
 private:
-  Event::Libevent::BufferPtr buffer_;
+  /**
+   * Append a slice to the end of the buffer, dropping it if it has no content.
+   */
+  void appendSliceOrCopy(SlicePtr&& slice);
+
+  /** Ring buffer of slices. */
+  SliceDeque slices_;
+
+  /** Sum of the dataSize of all slices. */
+  uint64_t length_{0};
 };
 
 } // namespace Buffer
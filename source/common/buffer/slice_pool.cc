@@ -0,0 +1,206 @@
+#include "common/buffer/slice_pool.h"
+
+#include <new>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Buffer {
+
+// Header stored at the start of every block. The header is padded to BlockOverhead bytes to keep
+// the usable part of the block suitably aligned.
+struct alignas(16) SlicePool::BlockHeader {
+  // The pool that owns the block, or nullptr if the block was allocated from the heap.
+  SlicePool* pool_;
+  // Size of the block including the header.
+  uint64_t size_;
+  // Link for the free lists and the return queue.
+  BlockHeader* next_;
+};
+
+constexpr uint64_t SlicePool::PageSize;
+constexpr uint64_t SlicePool::MaxPooledPages;
+constexpr uint64_t SlicePool::SlabSize;
+constexpr uint64_t SlicePool::MaxSlabBytesPerThread;
+constexpr uint64_t SlicePool::BlockOverhead;
+
+namespace {
+
+// The pool of the calling thread, if it has been created and not yet orphaned. This is trivially
+// destructible so that it remains safe to read during thread shutdown.
+thread_local SlicePool* current_pool = nullptr;
+
+// Set once the calling thread's pool has been orphaned during thread exit.
+thread_local bool current_pool_orphaned = false;
+
+uint64_t sizeClass(uint64_t size) { return size / SlicePool::PageSize - 1; }
+
+} // namespace
+
+// Orphans the thread's pool when the thread exits.
+struct ThreadPoolHolder {
+  ~ThreadPoolHolder() {
+    if (pool_ != nullptr) {
+      pool_->orphan();
+    }
+  }
+
+  SlicePool* pool_{nullptr};
+};
+
+SlicePool::~SlicePool() {
+  for (void* slab : slabs_) {
+    ::operator delete(slab);
+  }
+}
+
+SlicePool* SlicePool::threadPool() {
+  if (current_pool != nullptr) {
+    return current_pool;
+  }
+  if (current_pool_orphaned) {
+    return nullptr;
+  }
+  static thread_local ThreadPoolHolder holder;
+  holder.pool_ = new SlicePool();
+  current_pool = holder.pool_;
+  return current_pool;
+}
+
+void* SlicePool::allocate(uint64_t size) {
+  ASSERT(size % PageSize == 0);
+  ASSERT(size > BlockOverhead);
+  if (size <= MaxPooledPages * PageSize) {
+    SlicePool* pool = threadPool();
+    if (pool != nullptr) {
+      void* memory = pool->allocateLocal(size);
+      if (memory != nullptr) {
+        return memory;
+      }
+    }
+  }
+  return heapAllocate(size);
+}
+
+void* SlicePool::heapAllocate(uint64_t size) {
+  static_assert(sizeof(BlockHeader) == BlockOverhead, "unexpected BlockHeader size");
+  BlockHeader* block = static_cast<BlockHeader*>(::operator new(size));
+  block->pool_ = nullptr;
+  block->size_ = size;
+  return block + 1;
+}
+
+void SlicePool::free(void* memory) {
+  BlockHeader* block = static_cast<BlockHeader*>(memory) - 1;
+  SlicePool* pool = block->pool_;
+  if (pool == nullptr) {
+    ::operator delete(block);
+  } else if (pool == current_pool) {
+    pool->freeLocal(block);
+  } else {
+    pool->freeRemote(block);
+  }
+}
+
+SlicePool::ThreadStats SlicePool::threadStats() {
+  SlicePool* pool = threadPool();
+  if (pool == nullptr) {
+    return {0, 0, 0};
+  }
+  return {pool->free_blocks_, pool->slab_bytes_, pool->remote_frees_.load()};
+}
+
+void* SlicePool::allocateLocal(uint64_t size) {
+  BlockHeader*& free_list = free_lists_[sizeClass(size)];
+  if (free_list == nullptr) {
+    drainReturnQueue();
+  }
+  if (free_list == nullptr && !carveSlab(size)) {
+    return nullptr;
+  }
+  BlockHeader* block = free_list;
+  free_list = block->next_;
+  free_blocks_--;
+  return block + 1;
+}
+
+void SlicePool::freeLocal(BlockHeader* block) {
+  BlockHeader*& free_list = free_lists_[sizeClass(block->size_)];
+  block->next_ = free_list;
+  free_list = block;
+  free_blocks_++;
+}
+
+void SlicePool::freeRemote(BlockHeader* block) {
+  // Hold a reference while touching the pool, since once the block is on the return queue
+  // another thread may return it and drop the pool's last reference.
+  refs_++;
+  remote_frees_++;
+  BlockHeader* head = return_queue_.load();
+  do {
+    block->next_ = head;
+  } while (!return_queue_.compare_exchange_weak(head, block));
+  if (orphaned_.load()) {
+    // The owner has exited, so nobody else will drain the queue.
+    releaseReturnQueue();
+  }
+  release(1);
+}
+
+bool SlicePool::carveSlab(uint64_t size) {
+  if (slab_bytes_ + SlabSize > MaxSlabBytesPerThread) {
+    return false;
+  }
+  uint8_t* slab = static_cast<uint8_t*>(::operator new(SlabSize));
+  slabs_.push_back(slab);
+  slab_bytes_ += SlabSize;
+  const uint64_t num_blocks = SlabSize / size;
+  for (uint64_t i = 0; i < num_blocks; i++) {
+    BlockHeader* block = reinterpret_cast<BlockHeader*>(slab + i * size);
+    block->pool_ = this;
+    block->size_ = size;
+    freeLocal(block);
+  }
+  refs_ += num_blocks;
+  return true;
+}
+
+void SlicePool::drainReturnQueue() {
+  BlockHeader* block = return_queue_.exchange(nullptr);
+  while (block != nullptr) {
+    BlockHeader* next = block->next_;
+    freeLocal(block);
+    block = next;
+  }
+}
+
+void SlicePool::releaseReturnQueue() {
+  BlockHeader* block = return_queue_.exchange(nullptr);
+  uint64_t count = 0;
+  while (block != nullptr) {
+    block = block->next_;
+    count++;
+  }
+  if (count != 0) {
+    release(count);
+  }
+}
+
+void SlicePool::release(uint64_t count) {
+  if (refs_.fetch_sub(count) == count) {
+    delete this;
+  }
+}
+
+void SlicePool::orphan() {
+  current_pool = nullptr;
+  current_pool_orphaned = true;
+  // Any block pushed onto the return queue after this store is released by the thread that
+  // pushed it. Blocks pushed before it are collected here.
+  orphaned_.store(true);
+  drainReturnQueue();
+  release(1 + free_blocks_);
+}
+
+} // namespace Buffer
+} // namespace Envoy
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+namespace Buffer {
+
+/**
+ * A per-thread slab allocator for the memory blocks backing buffer slices.
+ *
+ * Each thread that allocates slices lazily creates its own pool. Blocks of up to MaxPooledPages
+ * pages are carved out of larger slabs and recycled through per-size free lists owned by that
+ * thread, so the common read/write path never touches the general purpose allocator. Larger
+ * blocks, and blocks requested once a thread's slab budget is exhausted, come from the heap.
+ *
+ * A block that is freed on a thread other than the one that allocated it (for example when a
+ * buffer is moved to a file flush thread) is pushed onto a lock-free multi-producer return queue
+ * of the owning pool. The owner drains the queue into its free lists the next time a free list
+ * runs dry. When the owning thread exits, its pool is orphaned and destroyed, along with its slabs,
+ * once the last outstanding block has been returned.
+ */
+class SlicePool : NonCopyable {
+public:
+  /**
+   * Allocate a block.
+   * @param size supplies the size of the block in bytes, including BlockOverhead. This must be a
+   *        multiple of PageSize.
+   * @return a pointer to the size - BlockOverhead usable bytes of the block.
+   */
+  static void* allocate(uint64_t size);
+
+  /**
+   * Free a block previously returned by allocate(). This may be called from any thread.
+   * @param memory supplies the pointer returned by allocate().
+   */
+  static void free(void* memory);
+
+  /**
+   * Statistics about the calling thread's pool.
+   */
+  struct ThreadStats {
+    // Number of blocks in the thread's free lists.
+    uint64_t free_blocks_;
+    // Bytes of slab memory owned by the thread's pool.
+    uint64_t slab_bytes_;
+    // Number of blocks returned to the thread's pool from other threads.
+    uint64_t remote_frees_;
+  };
+
+  /**
+   * @return ThreadStats for the calling thread's pool, creating the pool if needed.
+   */
+  static ThreadStats threadStats();
+
+  // The granularity of block sizes.
+  static constexpr uint64_t PageSize = 4096;
+
+  // Blocks of at most this many pages are served from slabs. This covers the 16KiB slices
+  // reserved by socket reads.
+  static constexpr uint64_t MaxPooledPages = 5;
+
+  // Size of each slab carved into blocks.
+  static constexpr uint64_t SlabSize = 64 * 1024;
+
+  // Maximum amount of slab memory each thread's pool may own.
+  static constexpr uint64_t MaxSlabBytesPerThread = 16 * 1024 * 1024;
+
+  // Bytes at the start of each block used for bookkeeping.
+  static constexpr uint64_t BlockOverhead = 32;
+
+private:
+  struct BlockHeader;
+
+  SlicePool() {}
+  ~SlicePool();
+
+  // @return the pool of the calling thread, or nullptr if the thread's pool has already been
+  //         orphaned during thread exit.
+  static SlicePool* threadPool();
+
+  static void* heapAllocate(uint64_t size);
+
+  void* allocateLocal(uint64_t size);
+  void freeLocal(BlockHeader* block);
+  void freeRemote(BlockHeader* block);
+  bool carveSlab(uint64_t size);
+  void drainReturnQueue();
+  void releaseReturnQueue();
+  void release(uint64_t count);
+  void orphan();
+
+  // The following are only accessed by the owning thread, or by whichever thread destroys the
+  // pool once all references are gone.
+  BlockHeader* free_lists_[MaxPooledPages]{};
+  std::vector<void*> slabs_;
+  uint64_t slab_bytes_{0};
+  uint64_t free_blocks_{0};
+
+  // Blocks freed by other threads, as an intrusive stack.
+  std::atomic<BlockHeader*> return_queue_{nullptr};
+  // One reference for the owning thread, one for each block carved from the slabs, and
+  // temporary references held by threads pushing onto the return queue.
+  std::atomic<uint64_t> refs_{1};
+  // Set once the owning thread has exited.
+  std::atomic<bool> orphaned_{false};
+  std::atomic<uint64_t> remote_frees_{0};
+
+  friend struct ThreadPoolHolder;
+};
+
+} // namespace Buffer
+} // namespace Envoy
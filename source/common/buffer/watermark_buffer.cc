@@ -20,6 +20,11 @@ void WatermarkBuffer::add(const Instance& data) {
   checkHighWatermark();
 }
 
+void WatermarkBuffer::addShared(Instance& data) {
+  OwnedImpl::addShared(data);
+  checkHighWatermark();
+}
+
 void WatermarkBuffer::prepend(absl::string_view data) {
   OwnedImpl::prepend(data);
   checkHighWatermark();
@@ -38,6 +43,7 @@ void WatermarkBuffer::commit(RawSlice* iovecs, uint64_t num_iovecs) {
 void WatermarkBuffer::drain(uint64_t size) {
   OwnedImpl::drain(size);
   checkLowWatermark();
+  next_spill_length_ = std::min(next_spill_length_, OwnedImpl::length() + SpillSliceSize);
 }
 
 void WatermarkBuffer::move(Instance& rhs) {
@@ -76,6 +82,30 @@ void WatermarkBuffer::setWatermarks(uint32_t low_watermark, uint32_t high_waterm
   checkLowWatermark();
 }
 
+void WatermarkBuffer::setSpillThreshold(uint32_t threshold, const std::string& directory) {
+  spill_threshold_ = threshold;
+  spill_directory_ = directory;
+  next_spill_length_ = static_cast<uint64_t>(threshold) + SpillSliceSize;
+  checkSpill();
+}
+
+void WatermarkBuffer::checkSpill() {
+  if (spill_threshold_ == 0 || OwnedImpl::length() < next_spill_length_) {
+    return;
+  }
+
+  if (spill_file_ == nullptr) {
+    spill_file_ = SpillFile::create(spill_directory_);
+    if (spill_file_ == nullptr) {
+      // Keep the content in memory, within the limits of the watermarks.
+      spill_threshold_ = 0;
+      return;
+    }
+  }
+  spill(spill_threshold_, spill_file_);
+  next_spill_length_ = OwnedImpl::length() + SpillSliceSize;
+}
+
 void WatermarkBuffer::checkLowWatermark() {
   if (!above_high_watermark_called_ ||
       (high_watermark_ != 0 && OwnedImpl::length() >= low_watermark_)) {
@@ -87,6 +117,7 @@ void WatermarkBuffer::checkLowWatermark() {
 }
 
 void WatermarkBuffer::checkHighWatermark() {
+  checkSpill();
   if (above_high_watermark_called_ || high_watermark_ == 0 ||
       OwnedImpl::length() <= high_watermark_) {
     return;
@@ -24,6 +24,7 @@ public:
   void add(const void* data, uint64_t size) override;
   void add(const std::string& data) override;
   void add(const Instance& data) override;
+  void addShared(Instance& data) override;
   void prepend(absl::string_view data) override;
   void prepend(Instance& data) override;
   void commit(RawSlice* iovecs, uint64_t num_iovecs) override;
@@ -39,9 +40,19 @@ public:
   void setWatermarks(uint32_t low_watermark, uint32_t high_watermark);
   uint32_t highWatermark() const { return high_watermark_; }
 
+  /**
+   * Spill the content past the first threshold bytes to a temporary file, so that large content
+   * held by the buffer is backed by the file rather than by memory. The file is created on the
+   * first spill. A threshold of 0 disables spilling.
+   * @param threshold supplies the number of bytes kept in memory.
+   * @param directory supplies the directory to create the file in.
+   */
+  void setSpillThreshold(uint32_t threshold, const std::string& directory);
+
 private:
   void checkHighWatermark();
   void checkLowWatermark();
+  void checkSpill();
 
   std::function<void()> below_low_watermark_;
   std::function<void()> above_high_watermark_;
@@ -54,6 +65,13 @@ private:
   // True between the time above_high_watermark_ has been called until above_high_watermark_ has
   // been called.
   bool above_high_watermark_called_{false};
+
+  uint32_t spill_threshold_{0};
+  std::string spill_directory_;
+  // The content is spilled once the buffer grows to this length, so that every spill copies at
+  // least about a whole SpillSliceSize.
+  uint64_t next_spill_length_{0};
+  SpillFileSharedPtr spill_file_;
 };
 
 typedef std::unique_ptr<WatermarkBuffer> WatermarkBufferPtr;
@@ -0,0 +1,44 @@
+#include "common/common/arena_impl.h"
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+
+namespace {
+uint8_t* alignUp(uint8_t* ptr, size_t alignment) {
+  return reinterpret_cast<uint8_t*>((reinterpret_cast<uintptr_t>(ptr) + alignment - 1) &
+                                    ~(alignment - 1));
+}
+} // namespace
+
+constexpr uint64_t ArenaImpl::DefaultBlockSize;
+
+void* ArenaImpl::allocate(size_t size, size_t alignment) {
+  ASSERT(alignment != 0 && (alignment & (alignment - 1)) == 0);
+  if (next_ != nullptr) {
+    uint8_t* aligned = alignUp(next_, alignment);
+    if (aligned + size <= end_) {
+      next_ = aligned + size;
+      return aligned;
+    }
+  }
+
+  // Blocks come from operator new[] and so are aligned for any fundamental type; padding for larger
+  // alignments is included in the block size.
+  const uint64_t needed = size + alignment - 1;
+  if (needed > block_size_) {
+    // Give large allocations a block of their own and keep filling the current block.
+    blocks_.emplace_back(new uint8_t[needed]);
+    bytes_reserved_ += needed;
+    return alignUp(blocks_.back().get(), alignment);
+  }
+
+  blocks_.emplace_back(new uint8_t[block_size_]);
+  bytes_reserved_ += block_size_;
+  uint8_t* aligned = alignUp(blocks_.back().get(), alignment);
+  next_ = aligned + size;
+  end_ = blocks_.back().get() + block_size_;
+  return aligned;
+}
+
+} // namespace Envoy
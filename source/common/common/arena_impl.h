@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "envoy/common/arena.h"
+
+namespace Envoy {
+
+/**
+ * Bump pointer Arena that allocates from a list of heap blocks (not thread-safe). No memory is
+ * allocated until the first allocation.
+ */
+class ArenaImpl : public Arena {
+public:
+  /**
+   * @param block_size supplies the size of each block. Allocations larger than this get a block of
+   * their own.
+   */
+  explicit ArenaImpl(uint64_t block_size = DefaultBlockSize) : block_size_(block_size) {}
+
+  // Arena
+  void* allocate(size_t size, size_t alignment) override;
+
+  /**
+   * @return uint64_t the total size of the blocks allocated so far.
+   */
+  uint64_t bytesReserved() const { return bytes_reserved_; }
+
+  static constexpr uint64_t DefaultBlockSize = 4096;
+
+private:
+  const uint64_t block_size_;
+  std::vector<std::unique_ptr<uint8_t[]>> blocks_;
+  uint8_t* next_{};
+  uint8_t* end_{};
+  uint64_t bytes_reserved_{};
+};
+
+} // namespace Envoy
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+
+/**
+ * ASCII case conversion and comparison which work on 8 bytes at a time (SWAR). Bytes outside of
+ * ASCII are left alone, as in the C locale. Header names are short, so this avoids the setup cost
+ * of vector instructions while still being several times faster than converting byte by byte.
+ */
+class AsciiUtil {
+public:
+  /**
+   * Convert a buffer to lower case in place.
+   * @param buffer supplies the start of the buffer.
+   * @param size supplies the size of the buffer.
+   */
+  static void toLowerCase(char* buffer, size_t size) {
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+      uint64_t word;
+      memcpy(&word, buffer + i, sizeof(word));
+      word = toLowerWord(word);
+      memcpy(buffer + i, &word, sizeof(word));
+    }
+    for (; i < size; i++) {
+      buffer[i] = absl::ascii_tolower(buffer[i]);
+    }
+  }
+
+  /**
+   * Convert a string to lower case in place.
+   * @param string supplies the string to convert.
+   */
+  static void toLowerCase(std::string& string) { toLowerCase(&string[0], string.size()); }
+
+  /**
+   * @return bool whether two strings are equal ignoring ASCII case.
+   */
+  static bool caseEqual(absl::string_view lhs, absl::string_view rhs) {
+    if (lhs.size() != rhs.size()) {
+      return false;
+    }
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= lhs.size(); i += sizeof(uint64_t)) {
+      uint64_t lhs_word;
+      uint64_t rhs_word;
+      memcpy(&lhs_word, lhs.data() + i, sizeof(lhs_word));
+      memcpy(&rhs_word, rhs.data() + i, sizeof(rhs_word));
+      if (lhs_word != rhs_word && toLowerWord(lhs_word) != toLowerWord(rhs_word)) {
+        return false;
+      }
+    }
+    for (; i < lhs.size(); i++) {
+      if (absl::ascii_tolower(lhs[i]) != absl::ascii_tolower(rhs[i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @return uint64_t the 8 bytes of a word converted to lower case.
+   */
+  static uint64_t toLowerWord(uint64_t word) {
+    constexpr uint64_t Ones = 0x0101010101010101;
+    // The low 7 bits of each byte plus these constants set the byte's top bit when it is above
+    // 'Z', respectively at least 'A', without carrying into the next byte.
+    const uint64_t heptets = word & (0x7f * Ones);
+    const uint64_t above_z = heptets + ((0x7f - 'Z') * Ones);
+    const uint64_t from_a = heptets + ((0x80 - 'A') * Ones);
+    const uint64_t upper = ~word & (from_a ^ above_z) & (0x80 * Ones);
+    // 0x80 >> 2 is the 0x20 which tells lower from upper case letters.
+    return word | (upper >> 2);
+  }
+};
+
+} // namespace Envoy
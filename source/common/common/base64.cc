@@ -1,8 +1,10 @@
 #include "common/common/base64.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <string>
 
+#include "common/common/assert.h"
 #include "common/common/empty_string.h"
 
 namespace Envoy {
@@ -137,8 +139,179 @@ inline void encodeLast(uint64_t pos, uint8_t last_char, std::string& ret,
   }
 }
 
+// Encodes 3 bytes into 4 characters.
+inline char* encodeGroup(const uint8_t* input, char* output, const char* const char_table) {
+  const uint32_t group = (input[0] << 16) | (input[1] << 8) | input[2];
+  output[0] = char_table[group >> 18];
+  output[1] = char_table[(group >> 12) & 0x3f];
+  output[2] = char_table[(group >> 6) & 0x3f];
+  output[3] = char_table[group & 0x3f];
+  return output + 4;
+}
+
+// Decodes 4 characters, the last two of which may be padding, and returns the number of bytes
+// written or -1 if the characters are not valid base64.
+inline int decodeGroup(const uint8_t* input, uint8_t* output,
+                       const unsigned char* const reverse_lookup_table) {
+  const unsigned char a = reverse_lookup_table[input[0]];
+  const unsigned char b = reverse_lookup_table[input[1]];
+  const unsigned char c = reverse_lookup_table[input[2]];
+  const unsigned char d = reverse_lookup_table[input[3]];
+  // Invalid characters are all mapped to 64, which has a bit no valid character has.
+  if (((a | b | c | d) & 64) == 0) {
+    output[0] = (a << 2) | (b >> 4);
+    output[1] = (b << 4) | (c >> 2);
+    output[2] = (c << 6) | d;
+    return 3;
+  }
+
+  if (((a | b) & 64) != 0 || input[3] != '=') {
+    return -1;
+  }
+  if (input[2] == '=') {
+    // The unused bits must be zero.
+    if ((b & 0b1111) != 0) {
+      return -1;
+    }
+    output[0] = (a << 2) | (b >> 4);
+    return 1;
+  }
+  if ((c & 64) != 0 || (c & 0b11) != 0) {
+    return -1;
+  }
+  output[0] = (a << 2) | (b >> 4);
+  output[1] = (b << 4) | (c >> 2);
+  return 2;
+}
+
 } // namespace
 
+bool Base64::decode(Buffer::Instance& input, Buffer::Instance& output) {
+  const uint64_t length = input.length() / 4 * 4;
+  if (length == 0) {
+    return true;
+  }
+
+  Buffer::RawSlice decoded;
+  output.reserve(length / 4 * 3, &decoded, 1);
+  ASSERT(decoded.len_ >= length / 4 * 3);
+  uint8_t* current = static_cast<uint8_t*>(decoded.mem_);
+
+  const uint64_t num_slices = input.getRawSlices(nullptr, 0);
+  Buffer::RawSlice slices[num_slices];
+  input.getRawSlices(slices, num_slices);
+
+  // The groups split across slices are gathered here.
+  uint8_t group[4];
+  uint64_t group_length = 0;
+  uint64_t remaining = length;
+  for (const Buffer::RawSlice& slice : slices) {
+    const uint8_t* slice_mem = static_cast<const uint8_t*>(slice.mem_);
+    uint64_t slice_length = std::min<uint64_t>(slice.len_, remaining);
+    remaining -= slice_length;
+
+    while (group_length > 0 && slice_length > 0) {
+      group[group_length++] = *slice_mem++;
+      slice_length--;
+      if (group_length == 4) {
+        const int written = decodeGroup(group, current, REVERSE_LOOKUP_TABLE);
+        if (written < 0) {
+          return false;
+        }
+        current += written;
+        group_length = 0;
+      }
+    }
+
+    for (; slice_length >= 4; slice_mem += 4, slice_length -= 4) {
+      const int written = decodeGroup(slice_mem, current, REVERSE_LOOKUP_TABLE);
+      if (written < 0) {
+        return false;
+      }
+      current += written;
+    }
+
+    while (slice_length > 0) {
+      group[group_length++] = *slice_mem++;
+      slice_length--;
+    }
+
+    if (remaining == 0) {
+      break;
+    }
+  }
+  ASSERT(group_length == 0);
+
+  decoded.len_ = current - static_cast<uint8_t*>(decoded.mem_);
+  output.commit(&decoded, 1);
+  input.drain(length);
+  return true;
+}
+
+void Base64::encode(const Buffer::Instance& buffer, uint64_t length, Buffer::Instance& output) {
+  length = std::min(length, buffer.length());
+  if (length == 0) {
+    return;
+  }
+
+  const uint64_t output_length = (length + 2) / 3 * 4;
+  Buffer::RawSlice encoded;
+  output.reserve(output_length, &encoded, 1);
+  ASSERT(encoded.len_ >= output_length);
+  char* current = static_cast<char*>(encoded.mem_);
+
+  const uint64_t num_slices = buffer.getRawSlices(nullptr, 0);
+  Buffer::RawSlice slices[num_slices];
+  buffer.getRawSlices(slices, num_slices);
+
+  // The groups split across slices, and the last incomplete group, are gathered here.
+  uint8_t group[3];
+  uint64_t group_length = 0;
+  uint64_t remaining = length;
+  for (const Buffer::RawSlice& slice : slices) {
+    const uint8_t* slice_mem = static_cast<const uint8_t*>(slice.mem_);
+    uint64_t slice_length = std::min<uint64_t>(slice.len_, remaining);
+    remaining -= slice_length;
+
+    while (group_length > 0 && slice_length > 0) {
+      group[group_length++] = *slice_mem++;
+      slice_length--;
+      if (group_length == 3) {
+        current = encodeGroup(group, current, CHAR_TABLE);
+        group_length = 0;
+      }
+    }
+
+    for (; slice_length >= 3; slice_mem += 3, slice_length -= 3) {
+      current = encodeGroup(slice_mem, current, CHAR_TABLE);
+    }
+
+    while (slice_length > 0) {
+      group[group_length++] = *slice_mem++;
+      slice_length--;
+    }
+
+    if (remaining == 0) {
+      break;
+    }
+  }
+
+  if (group_length > 0) {
+    // Pads the last group with zero bytes, whose characters are then replaced with padding.
+    for (uint64_t i = group_length; i < 3; i++) {
+      group[i] = 0;
+    }
+    current = encodeGroup(group, current, CHAR_TABLE);
+    for (uint64_t i = group_length; i < 3; i++) {
+      *(current - 3 + i) = '=';
+    }
+  }
+
+  ASSERT(static_cast<uint64_t>(current - static_cast<char*>(encoded.mem_)) == output_length);
+  encoded.len_ = output_length;
+  output.commit(&encoded, 1);
+}
+
 std::string Base64::decode(const std::string& input) {
   if (input.length() % 4 || input.empty()) {
     return EMPTY_STRING;
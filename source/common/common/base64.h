@@ -27,6 +27,27 @@ public:
    */
   static std::string encode(const char* input, uint64_t length);
 
+  /**
+   * Base64 encode an input buffer into another buffer. The input is read slice by slice and the
+   * output is written into space reserved in the output buffer, so nothing is linearized or copied
+   * in between.
+   * @param buffer supplies the buffer to encode.
+   * @param length supplies the length to encode which may be <= the buffer length.
+   * @param output supplies the buffer to append the encoded data to.
+   */
+  static void encode(const Buffer::Instance& buffer, uint64_t length, Buffer::Instance& output);
+
+  /**
+   * Base64 decode the complete 4 character groups at the front of an input buffer into another
+   * buffer, and drain them from the input. Fewer than 4 characters are left in the input, so that
+   * the data of a stream can be decoded as it arrives. Every group may end with padding, so that
+   * the concatenation of several padded encodings is decoded as well.
+   * @param input supplies the buffer to decode.
+   * @param output supplies the buffer to append the decoded data to.
+   * @return false if the input is not valid base64, in which case neither buffer is modified.
+   */
+  static bool decode(Buffer::Instance& input, Buffer::Instance& output);
+
   /**
    * Base64 decode an input string. Padding is required.
    * @param input supplies the input to decode.
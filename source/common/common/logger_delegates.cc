@@ -1,10 +1,15 @@
 #include "common/common/logger_delegates.h"
 
+#include <algorithm>
 #include <cassert> // use direct system-assert to avoid cyclic dependency.
 #include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <string>
 
+#include "common/common/fmt.h"
+#include "common/common/lock_guard.h"
+
 #include "spdlog/spdlog.h"
 
 namespace Envoy {
@@ -27,5 +32,131 @@ void FileSinkDelegate::flush() {
   log_file_->flush();
 }
 
+constexpr std::chrono::milliseconds AsyncSinkDelegate::DrainInterval;
+
+namespace {
+
+std::atomic<uint64_t> next_async_sink_generation{1};
+
+// The ring buffer of the current thread, cached for the AsyncSinkDelegate of a generation.
+struct ThreadRingBuffer {
+  uint64_t generation_{};
+  void* ring_buffer_{};
+};
+
+thread_local ThreadRingBuffer thread_ring_buffer;
+
+} // namespace
+
+bool AsyncSinkDelegate::RingBuffer::push(absl::string_view msg) {
+  const uint32_t length = msg.size();
+  const uint64_t needed = sizeof(length) + length;
+  const uint64_t head = head_.load(std::memory_order_relaxed);
+  const uint64_t tail = tail_.load(std::memory_order_acquire);
+  if (needed > size_ - (head - tail)) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  copyIn(head, &length, sizeof(length));
+  copyIn(head + sizeof(length), msg.data(), length);
+  head_.store(head + needed, std::memory_order_release);
+  return true;
+}
+
+void AsyncSinkDelegate::RingBuffer::drain(const std::function<void(absl::string_view)>& cb) {
+  const uint64_t head = head_.load(std::memory_order_acquire);
+  uint64_t tail = tail_.load(std::memory_order_relaxed);
+  while (tail != head) {
+    uint32_t length;
+    copyOut(tail, &length, sizeof(length));
+    scratch_.resize(length);
+    copyOut(tail + sizeof(length), &scratch_[0], length);
+    tail += sizeof(length) + length;
+    // Free the space before writing, which may be slow, so the owning thread can log meanwhile.
+    tail_.store(tail, std::memory_order_release);
+    cb(scratch_);
+  }
+}
+
+void AsyncSinkDelegate::RingBuffer::copyIn(uint64_t position, const void* data, uint64_t length) {
+  const uint64_t offset = position % size_;
+  const uint64_t first = std::min(length, size_ - offset);
+  memcpy(data_.get() + offset, data, first);
+  memcpy(data_.get(), static_cast<const char*>(data) + first, length - first);
+}
+
+void AsyncSinkDelegate::RingBuffer::copyOut(uint64_t position, void* data, uint64_t length) const {
+  const uint64_t offset = position % size_;
+  const uint64_t first = std::min(length, size_ - offset);
+  memcpy(data, data_.get() + offset, first);
+  memcpy(static_cast<char*>(data) + first, data_.get(), length - first);
+}
+
+AsyncSinkDelegate::AsyncSinkDelegate(uint32_t buffer_size, DelegatingLogSinkPtr log_sink)
+    : SinkDelegate(log_sink), buffer_size_(buffer_size),
+      generation_(next_async_sink_generation++), delegate_(*previous_delegate()) {
+  thread_ = std::make_unique<Thread::Thread>([this]() -> void { threadRoutine(); });
+}
+
+AsyncSinkDelegate::~AsyncSinkDelegate() {
+  {
+    Thread::LockGuard lock(drain_lock_);
+    shutdown_ = true;
+    drain_cond_.notifyOne();
+  }
+  thread_->join();
+  flush();
+}
+
+void AsyncSinkDelegate::log(absl::string_view msg) { threadRingBuffer().push(msg); }
+
+void AsyncSinkDelegate::flush() {
+  Thread::LockGuard lock(drain_lock_);
+  drain();
+  delegate_.flush();
+}
+
+uint64_t AsyncSinkDelegate::droppedMessages() const {
+  Thread::LockGuard lock(rings_lock_);
+  uint64_t dropped = 0;
+  for (const RingBufferPtr& ring : rings_) {
+    dropped += ring->dropped_.load(std::memory_order_relaxed);
+  }
+  return dropped;
+}
+
+AsyncSinkDelegate::RingBuffer& AsyncSinkDelegate::threadRingBuffer() {
+  if (thread_ring_buffer.generation_ != generation_) {
+    Thread::LockGuard lock(rings_lock_);
+    rings_.emplace_back(new RingBuffer(buffer_size_));
+    thread_ring_buffer.generation_ = generation_;
+    thread_ring_buffer.ring_buffer_ = rings_.back().get();
+  }
+  return *static_cast<RingBuffer*>(thread_ring_buffer.ring_buffer_);
+}
+
+void AsyncSinkDelegate::drain() {
+  Thread::LockGuard lock(rings_lock_);
+  for (const RingBufferPtr& ring : rings_) {
+    ring->drain([this](absl::string_view msg) -> void { delegate_.log(msg); });
+    const uint64_t dropped = ring->dropped_.load(std::memory_order_relaxed);
+    if (dropped != ring->dropped_reported_) {
+      delegate_.log(fmt::format("[{} log messages dropped by async logging]\n",
+                                dropped - ring->dropped_reported_));
+      ring->dropped_reported_ = dropped;
+    }
+  }
+}
+
+void AsyncSinkDelegate::threadRoutine() {
+  Thread::LockGuard lock(drain_lock_);
+  while (!shutdown_) {
+    drain();
+    // Waiting also lets flush() in between drains.
+    drain_cond_.waitFor(drain_lock_, DrainInterval);
+  }
+}
+
 } // namespace Logger
 } // namespace Envoy
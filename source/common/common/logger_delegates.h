@@ -1,14 +1,19 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "envoy/access_log/access_log.h"
 #include "envoy/filesystem/filesystem.h"
 
 #include "common/common/logger.h"
 #include "common/common/macros.h"
+#include "common/common/thread.h"
 
 #include "absl/strings/string_view.h"
 
@@ -34,6 +39,92 @@ private:
   Filesystem::FileSharedPtr log_file_;
 };
 
+/**
+ * SinkDelegate that takes logging off the threads that log. Each thread copies its formatted
+ * messages into a ring buffer of its own, without taking any lock, and a background thread writes
+ * them to the delegate that was active when this one was created. Messages that do not fit in
+ * their thread's ring buffer are dropped and counted, and the background thread reports how many
+ * were dropped in the log. Messages of different threads may be written out of order.
+ *
+ * flush() writes out every buffered message before flushing the previous delegate, so messages
+ * at the level loggers flush on, e.g. those of ASSERT and PANIC, are still written synchronously.
+ */
+class AsyncSinkDelegate : public SinkDelegate {
+public:
+  AsyncSinkDelegate(uint32_t buffer_size, DelegatingLogSinkPtr log_sink);
+  ~AsyncSinkDelegate();
+
+  // SinkDelegate
+  void log(absl::string_view msg) override;
+  void flush() override;
+
+  /**
+   * @return uint64_t the number of messages dropped since construction because the ring buffer of
+   *         their thread was full.
+   */
+  uint64_t droppedMessages() const;
+
+  // How long the background thread waits between writing out the buffered messages.
+  static constexpr std::chrono::milliseconds DrainInterval{1};
+
+private:
+  /**
+   * A single producer, single consumer ring buffer of length prefixed messages.
+   */
+  class RingBuffer {
+  public:
+    RingBuffer(uint32_t size) : data_(new char[size]), size_(size) {}
+
+    /**
+     * Called by the owning thread.
+     * @return bool whether the message fit in the buffer.
+     */
+    bool push(absl::string_view msg);
+
+    /**
+     * Called by the background thread, passing every buffered message to cb.
+     */
+    void drain(const std::function<void(absl::string_view)>& cb);
+
+    std::atomic<uint64_t> dropped_{};
+    // The number of dropped messages already reported, touched only while draining.
+    uint64_t dropped_reported_{};
+
+  private:
+    void copyIn(uint64_t position, const void* data, uint64_t length);
+    void copyOut(uint64_t position, void* data, uint64_t length) const;
+
+    const std::unique_ptr<char[]> data_;
+    const uint64_t size_;
+    // Monotonic positions: head_ is only written by the owning thread and tail_ only by the
+    // background thread.
+    std::atomic<uint64_t> head_{};
+    std::atomic<uint64_t> tail_{};
+    // Messages are copied here when draining, so a message that wraps is passed in one piece.
+    std::string scratch_;
+  };
+
+  typedef std::unique_ptr<RingBuffer> RingBufferPtr;
+
+  RingBuffer& threadRingBuffer();
+  // Writes out every buffered message. Called with drain_lock_ held.
+  void drain();
+  void threadRoutine();
+
+  const uint32_t buffer_size_;
+  // Tells apart the ring buffers threads cache for different instances.
+  const uint64_t generation_;
+  SinkDelegate& delegate_;
+
+  mutable Thread::MutexBasicLockable rings_lock_;
+  std::vector<RingBufferPtr> rings_ GUARDED_BY(rings_lock_);
+
+  Thread::MutexBasicLockable drain_lock_;
+  Thread::CondVar drain_cond_;
+  bool shutdown_ GUARDED_BY(drain_lock_){};
+  Thread::ThreadPtr thread_;
+};
+
 } // namespace Logger
 
 } // namespace Envoy
@@ -73,7 +73,8 @@ bool StringMatcher::match(const std::string& value) const {
   case envoy::type::matcher::StringMatcher::kSuffix:
     return absl::EndsWith(value, matcher_.suffix());
   case envoy::type::matcher::StringMatcher::kRegex:
-    return std::regex_match(value, regex_);
+  case envoy::type::matcher::StringMatcher::kSafeRegex:
+    return regex_->match(value);
   default:
     NOT_REACHED_GCOVR_EXCL_LINE;
   }
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+
+#include "common/common/assert.h"
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+
+/**
+ * Mixin for objects that can be linked into an MpscQueue. The queue does not own its nodes; the
+ * consumer takes ownership of each node it pops.
+ */
+class MpscQueueNode {
+public:
+  MpscQueueNode() : next_(nullptr) {}
+
+private:
+  std::atomic<MpscQueueNode*> next_;
+
+  template <class T> friend class MpscQueue;
+};
+
+/**
+ * Intrusive, unbounded, lock-free multi-producer single-consumer queue (D. Vyukov's algorithm).
+ * push() and pushChain() may be called from any thread and cost a single atomic exchange. pop()
+ * must only be called from the consumer thread.
+ *
+ * While a producer is between its exchange and the store that links its node, pop() can report the
+ * queue empty even though the node has been published. Callers must therefore use some other
+ * signal (e.g. a flag that the producer sets after pushing) to learn that they have to pop again.
+ */
+template <class T> class MpscQueue : NonCopyable {
+public:
+  MpscQueue() : head_(&stub_), tail_(&stub_) {}
+  ~MpscQueue() { ASSERT(tail_ == &stub_ && head_.load() == &stub_); }
+
+  /**
+   * Append a single node. Safe to call from any thread.
+   */
+  void push(T* node) { pushChain(node, node); }
+
+  /**
+   * Append a chain of nodes that the caller has already linked with link(). The whole chain
+   * becomes visible to the consumer at once, in order. Safe to call from any thread.
+   * @param first supplies the first node of the chain.
+   * @param last supplies the last node of the chain.
+   */
+  void pushChain(T* first, T* last) {
+    static_cast<MpscQueueNode*>(last)->next_.store(nullptr, std::memory_order_relaxed);
+    MpscQueueNode* prev = head_.exchange(last, std::memory_order_acq_rel);
+    prev->next_.store(first, std::memory_order_release);
+  }
+
+  /**
+   * Link two nodes of a chain that has not been pushed yet.
+   */
+  static void link(T* node, T* next) {
+    static_cast<MpscQueueNode*>(node)->next_.store(next, std::memory_order_relaxed);
+  }
+
+  /**
+   * Remove the oldest node. Consumer thread only.
+   * @return T* the node, or nullptr if the queue is empty or a push is still in progress.
+   */
+  T* pop() {
+    MpscQueueNode* tail = tail_;
+    MpscQueueNode* next = tail->next_.load(std::memory_order_acquire);
+    if (tail == &stub_) {
+      if (next == nullptr) {
+        return nullptr;
+      }
+      tail_ = next;
+      tail = next;
+      next = next->next_.load(std::memory_order_acquire);
+    }
+
+    if (next != nullptr) {
+      tail_ = next;
+      return static_cast<T*>(tail);
+    }
+
+    if (tail != head_.load(std::memory_order_acquire)) {
+      // A producer has swapped head_ but not linked its node yet.
+      return nullptr;
+    }
+
+    // tail is the only node left. Push the stub behind it so tail can be detached.
+    stub_.next_.store(nullptr, std::memory_order_relaxed);
+    MpscQueueNode* prev = head_.exchange(&stub_, std::memory_order_acq_rel);
+    prev->next_.store(&stub_, std::memory_order_release);
+
+    next = tail->next_.load(std::memory_order_acquire);
+    if (next != nullptr) {
+      tail_ = next;
+      return static_cast<T*>(tail);
+    }
+    return nullptr;
+  }
+
+private:
+  std::atomic<MpscQueueNode*> head_;
+  MpscQueueNode* tail_;
+  MpscQueueNode stub_;
+};
+
+} // namespace Envoy
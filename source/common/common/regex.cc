@@ -0,0 +1,82 @@
+#include "common/common/regex.h"
+
+#include <algorithm>
+
+#include "envoy/common/exception.h"
+
+#include "common/common/assert.h"
+#include "common/common/fmt.h"
+#include "common/common/utility.h"
+#include "common/protobuf/utility.h"
+
+namespace Envoy {
+namespace Regex {
+
+namespace {
+
+re2::RE2::Options googleReOptions() {
+  re2::RE2::Options options;
+  options.set_log_errors(false);
+  return options;
+}
+
+} // namespace
+
+CompiledGoogleReMatcher::CompiledGoogleReMatcher(const envoy::type::matcher::RegexMatcher& config)
+    : regex_(config.regex(), googleReOptions()) {
+  if (!regex_.ok()) {
+    throw EnvoyException(fmt::format("Invalid regex '{}': {}", config.regex(), regex_.error()));
+  }
+
+  const uint32_t max_program_size =
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.google_re2(), max_program_size, 100);
+  if (static_cast<uint32_t>(regex_.ProgramSize()) > max_program_size) {
+    throw EnvoyException(fmt::format("regex '{}' RE2 program size of {} > max program size of {}",
+                                     config.regex(), regex_.ProgramSize(), max_program_size));
+  }
+}
+
+CompiledStdMatcher::CompiledStdMatcher(const std::string& regex, std::regex::flag_type flags)
+    : regex_(RegexUtil::parseRegex(regex, flags)) {}
+
+GoogleReMatcherSet::GoogleReMatcherSet() : set_(googleReOptions(), re2::RE2::ANCHOR_BOTH) {}
+
+void GoogleReMatcherSet::add(const envoy::type::matcher::RegexMatcher& config) {
+  // Compile the regex on its own first, to report errors and enforce the max program size.
+  CompiledGoogleReMatcher matcher(config);
+  std::string error;
+  const int index = set_.Add(config.regex(), &error);
+  if (index < 0) {
+    throw EnvoyException(fmt::format("Invalid regex '{}': {}", config.regex(), error));
+  }
+}
+
+void GoogleReMatcherSet::compile() {
+  if (!set_.Compile()) {
+    throw EnvoyException("unable to compile regex set: out of memory");
+  }
+}
+
+void GoogleReMatcherSet::match(absl::string_view value, std::vector<int>& matches) const {
+  matches.clear();
+  if (set_.Match(re2::StringPiece(value.data(), value.size()), &matches)) {
+    std::sort(matches.begin(), matches.end());
+  }
+}
+
+CompiledMatcherPtr Utility::parseRegex(const envoy::type::matcher::RegexMatcher& matcher) {
+  switch (matcher.engine_type_case()) {
+  case envoy::type::matcher::RegexMatcher::kGoogleRe2:
+    return CompiledMatcherPtr{new CompiledGoogleReMatcher(matcher)};
+  default:
+    NOT_REACHED_GCOVR_EXCL_LINE;
+  }
+}
+
+CompiledMatcherPtr Utility::parseStdRegexAsCompiledMatcher(const std::string& regex,
+                                                           std::regex::flag_type flags) {
+  return CompiledMatcherPtr{new CompiledStdMatcher(regex, flags)};
+}
+
+} // namespace Regex
+} // namespace Envoy
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "envoy/common/regex.h"
+#include "envoy/type/matcher/regex.pb.h"
+
+#include "re2/re2.h"
+#include "re2/set.h"
+
+namespace Envoy {
+namespace Regex {
+
+/**
+ * Regex matcher using Google's RE2 engine, which matches in time linear in the input and without
+ * recursion.
+ */
+class CompiledGoogleReMatcher : public CompiledMatcher {
+public:
+  CompiledGoogleReMatcher(const envoy::type::matcher::RegexMatcher& config);
+
+  // Regex::CompiledMatcher
+  bool match(absl::string_view value) const override {
+    return re2::RE2::FullMatch(re2::StringPiece(value.data(), value.size()), regex_);
+  }
+
+private:
+  const re2::RE2 regex_;
+};
+
+/**
+ * Regex matcher using std::regex, for the legacy configuration fields whose grammar is ECMAScript.
+ */
+class CompiledStdMatcher : public CompiledMatcher {
+public:
+  CompiledStdMatcher(const std::string& regex, std::regex::flag_type flags);
+
+  // Regex::CompiledMatcher
+  bool match(absl::string_view value) const override {
+    return std::regex_match(value.begin(), value.end(), regex_);
+  }
+
+private:
+  const std::regex regex_;
+};
+
+/**
+ * A list of RE2 regexes compiled into a single program, so that a value is matched against all of
+ * them in one pass rather than one regex at a time.
+ */
+class GoogleReMatcherSet {
+public:
+  GoogleReMatcherSet();
+
+  /**
+   * Add a regex to the set. Regexes are identified by the order in which they are added.
+   * @throw EnvoyException if the regex is invalid.
+   */
+  void add(const envoy::type::matcher::RegexMatcher& config);
+
+  /**
+   * Compile the set. Must be called once all the regexes have been added and before matching.
+   * @throw EnvoyException if the set cannot be compiled.
+   */
+  void compile();
+
+  /**
+   * @param value supplies the value to match. The entire value must match a regex.
+   * @param matches receives the indices of the regexes that match the value, in increasing order.
+   */
+  void match(absl::string_view value, std::vector<int>& matches) const;
+
+private:
+  re2::RE2::Set set_;
+};
+
+class Utility {
+public:
+  /**
+   * Compile a regex matcher with the engine it specifies.
+   * @throw EnvoyException if the regex is invalid.
+   */
+  static CompiledMatcherPtr parseRegex(const envoy::type::matcher::RegexMatcher& matcher);
+
+  /**
+   * Compile a std::regex as a matcher, for the legacy configuration fields.
+   * @throw EnvoyException if the regex is invalid.
+   */
+  static CompiledMatcherPtr
+  parseStdRegexAsCompiledMatcher(const std::string& regex,
+                                 std::regex::flag_type flags = std::regex::optimize);
+};
+
+} // namespace Regex
+} // namespace Envoy
@@ -0,0 +1,560 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "envoy/common/exception.h"
+#include "envoy/common/pure.h"
+#include "envoy/stats/stats_options.h"
+
+#include "common/common/assert.h"
+#include "common/common/fmt.h"
+#include "common/common/logger.h"
+
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+
+/**
+ * Initialization parameters for SegmentedMemoryHashSet. The options are duplicated to the
+ * control block after init, to aid with sanity checking when attaching an existing set.
+ */
+struct SegmentedMemoryHashSetOptions {
+  std::string toString() const {
+    return fmt::format("capacity={}, initial_segment_bytes={}, max_segment_bytes={}, "
+                       "max_segments={}",
+                       capacity, initial_segment_bytes, max_segment_bytes, max_segments);
+  }
+  bool operator==(const SegmentedMemoryHashSetOptions& that) const {
+    return capacity == that.capacity && initial_segment_bytes == that.initial_segment_bytes &&
+           max_segment_bytes == that.max_segment_bytes && max_segments == that.max_segments;
+  }
+  bool operator!=(const SegmentedMemoryHashSetOptions& that) const { return !(*this == that); }
+
+  uint64_t initial_segment_bytes; // size of the first segment; each next one is twice as large.
+  uint64_t max_segment_bytes;     // size beyond which segments stop growing.
+  uint32_t capacity;              // how many values can be stored.
+  uint32_t max_segments;          // how many segments the set may grow to.
+};
+
+/**
+ * Provides the memory segments a SegmentedMemoryHashSet grows into, such as shared memory regions
+ * that other processes can attach to.
+ */
+class MemorySegmentMapper {
+public:
+  virtual ~MemorySegmentMapper() {}
+
+  /**
+   * Map a segment into the address space of the calling process.
+   * @param index supplies the index of the segment. Segments are created in order of their index.
+   * @param size supplies the size of the segment in bytes.
+   * @param create supplies whether the segment is new, in which case its memory must be zeroed,
+   *        or was created earlier, possibly by another process sharing the set.
+   * @return uint8_t* the segment memory, which must stay mapped for the lifetime of the set, or
+   *         nullptr if it could not be mapped.
+   */
+  virtual uint8_t* mapSegment(uint32_t index, uint64_t size, bool create) PURE;
+};
+
+/**
+ * Implements hash_set<Value> without using pointers, suitable for use in shared memory, like
+ * BlockMemoryHashSet. Instead of committing to capacity and key size upfront, values are stored in
+ * cells sized to their key, carved from a chain of memory segments that are only mapped as the set
+ * grows. Each segment is twice as large as the previous one, up to a maximum size, and indexes the
+ * values it holds in its own hash table, so a lookup probes one slot per segment. Removed cells
+ * are kept on free lists by size and reused for keys of the same size.
+ *
+ * The control block, which holds the options, size, segment count and free lists, lives in memory
+ * supplied by the caller. The segments are obtained from a MemorySegmentMapper, and processes
+ * attached to the same set map the segments added by the others on their next access.
+ *
+ * Value must provide these methods:
+ *    absl::string_view Value::key()
+ *    void Value::initialize(absl::string_view key, const Stats::StatsOptions& stats_options)
+ *    static uint64_t Value::structSize(uint64_t key_size)
+ *    static uint64_t Value::structSizeWithOptions(const Stats::StatsOptions& stats_options)
+ *    static uint64_t Value::hash(absl::string_view key)
+ *
+ * Note that no locking of any kind is done by this class; this must be done at the call-site to
+ * support concurrent access, across all the processes sharing the set. The exception is
+ * getUnlocked(), which may run concurrently with the other methods: slot and cell links are
+ * published with release stores only once the cell they point to is initialized.
+ */
+template <class Value> class SegmentedMemoryHashSet : public Logger::Loggable<Logger::Id::config> {
+public:
+  /**
+   * Sentinal used for cell references to indicate end-of-list.
+   */
+  static const uint64_t Sentinal = 0xffffffffffffffff;
+
+  /** Type used by insert() to indicate the value at a key, and whether it was created */
+  typedef std::pair<Value*, bool> ValueCreatedPair;
+
+  /**
+   * Constructs a set control structure given a set of options, which cannot be changed.
+   * @param hash_set_options describes the parameters controlling set layout.
+   * @param init true if the control memory should be initialized on construction. If false, the
+   *             set will be sanity checked, and an exception thrown if it is incoherent or
+   *             mismatches the passed-in options.
+   * @param memory the memory buffer for the control block, of numBytes() bytes.
+   * @param mapper supplies the memory segments holding the values.
+   * @param stats_options a reference to the top-level StatsOptions struct containing
+   *                      information about max allowable stat name lengths.
+   */
+  SegmentedMemoryHashSet(const SegmentedMemoryHashSetOptions& hash_set_options, bool init,
+                         uint8_t* memory, MemorySegmentMapper& mapper,
+                         const Stats::StatsOptions& stats_options)
+      : control_(reinterpret_cast<Control*>(memory)), mapper_(mapper),
+        stats_options_(stats_options) {
+    RELEASE_ASSERT(hash_set_options.max_segment_bytes <= MaxSegmentBytes, "");
+    RELEASE_ASSERT(hash_set_options.initial_segment_bytes <= hash_set_options.max_segment_bytes,
+                   "");
+    RELEASE_ASSERT(segmentHeaderBytes(hash_set_options.initial_segment_bytes) +
+                           maxCellSize(stats_options) <=
+                       hash_set_options.initial_segment_bytes,
+                   "");
+    // getUnlocked() walks segments_ while it grows, so it must never be reallocated.
+    segments_.reserve(hash_set_options.max_segments);
+    if (init) {
+      initialize(hash_set_options);
+    } else if (!attach(hash_set_options)) {
+      throw EnvoyException("SegmentedMemoryHashSet: Incompatible memory block");
+    }
+  }
+
+  /**
+   * Returns the number of bytes required for the control block, which must be used to allocate
+   * the memory passed to the constructor. The segments are sized separately.
+   */
+  static uint64_t numBytes(const Stats::StatsOptions& stats_options) {
+    return sizeof(Control) + numSizeClasses(stats_options) * sizeof(uint64_t);
+  }
+
+  /** Examines the data structures to see if they are sane, assert-failing on any trouble. */
+  void sanityCheck() {
+    mapNewSegments();
+    RELEASE_ASSERT(control_->size <= control_->hash_set_options.capacity, "");
+
+    // Every cell carved from a segment is either reachable from the slots of its segment, or on
+    // the free list of its size. Walk the cells of each segment in address order, the slot
+    // chains, and the free lists, and make sure they all agree. Avoid infinite loops if there is
+    // a cycle by stopping once more cells than exist have been seen.
+    uint64_t num_cells = 0;
+    for (uint32_t index = 0; index < segments_.size(); ++index) {
+      Segment& segment = *segments_[index];
+      RELEASE_ASSERT(segment.num_bytes == segmentBytes(control_->hash_set_options, index), "");
+      RELEASE_ASSERT(segment.end <= segment.num_bytes, "");
+      for (uint64_t offset = segmentHeaderBytes(segment.num_bytes); offset < segment.end;) {
+        const uint32_t cell_size = cellAt(index, offset).size;
+        RELEASE_ASSERT(cell_size > 0 && cell_size % Alignment == 0, "");
+        offset += cell_size;
+        RELEASE_ASSERT(offset <= segment.end, "");
+        ++num_cells;
+      }
+    }
+
+    uint64_t num_values = 0;
+    for (uint32_t index = 0; index < segments_.size(); ++index) {
+      Segment& segment = *segments_[index];
+      for (uint32_t slot = 0; slot < segment.num_slots; ++slot) {
+        for (uint64_t ref = segment.slots[slot]; ref != Sentinal && num_values <= num_cells;
+             ref = getCell(ref).next) {
+          RELEASE_ASSERT(segmentIndex(ref) == index, "");
+          Cell& cell = getCell(ref);
+          absl::string_view key = cell.value.key();
+          RELEASE_ASSERT(cellSize(key.size()) == cell.size, "");
+          RELEASE_ASSERT(Value::hash(key) % segment.num_slots == slot, "");
+          ++num_values;
+        }
+      }
+    }
+    RELEASE_ASSERT(num_values == control_->size, "");
+
+    uint64_t num_free_cells = 0;
+    for (uint32_t size_class = 0; size_class < control_->num_size_classes; ++size_class) {
+      for (uint64_t ref = control_->free_cells[size_class];
+           ref != Sentinal && num_free_cells <= num_cells; ref = getCell(ref).next) {
+        RELEASE_ASSERT(getCell(ref).size == size_class * Alignment, "");
+        ++num_free_cells;
+      }
+    }
+    RELEASE_ASSERT(num_values + num_free_cells == num_cells, "");
+  }
+
+  /**
+   * Inserts a value into the set. If successful (e.g. the set has capacity and a segment could
+   * be mapped if needed) then insert returns a pointer to the value object, which the caller can
+   * then write. Returns {nullptr, false} if the key was too large, or the capacity of the set has
+   * been exceeded.
+   *
+   * If the value was already present in the set, then {value, false} is returned.
+   *
+   * If the value is newly allocated, then {value, true} is returned.
+   *
+   * @return a pair with the value-pointer (or nullptr), and a bool indicating
+   *         whether the value is newly allocated.
+   */
+  ValueCreatedPair insert(absl::string_view key) {
+    Value* value = get(key);
+    if (value != nullptr) {
+      return ValueCreatedPair(value, false);
+    }
+    const uint64_t cell_size = cellSize(key.size());
+    if (control_->size >= control_->hash_set_options.capacity ||
+        cell_size > maxCellSize(stats_options_)) {
+      return ValueCreatedPair(nullptr, false);
+    }
+
+    uint64_t ref = control_->free_cells[cell_size / Alignment];
+    if (ref != Sentinal) {
+      control_->free_cells[cell_size / Alignment] = getCell(ref).next;
+    } else {
+      ref = carveCell(cell_size);
+      if (ref == Sentinal) {
+        return ValueCreatedPair(nullptr, false);
+      }
+    }
+
+    Cell& cell = getCell(ref);
+    ASSERT(cell.size == cell_size);
+    Segment& segment = *segments_[segmentIndex(ref)];
+    const uint32_t slot = Value::hash(key) % segment.num_slots;
+    value = &cell.value;
+    value->initialize(key, stats_options_);
+    storeRef(cell.next, segment.slots[slot]);
+    storeRef(segment.slots[slot], ref);
+    ++control_->size;
+    return ValueCreatedPair(value, true);
+  }
+
+  /**
+   * Removes the specified key from the set, returning true if the key was found. The memory of
+   * the value is not cleared; callers reusing it must reset the value themselves.
+   * @param key the key to remove
+   */
+  bool remove(absl::string_view key) {
+    mapNewSegments();
+    const uint64_t hash = Value::hash(key);
+    for (Segment* segment : segments_) {
+      uint64_t* next = nullptr;
+      for (uint64_t* ref = &segment->slots[hash % segment->num_slots]; *ref != Sentinal;
+           ref = next) {
+        const uint64_t cell_ref = *ref;
+        Cell& cell = getCell(cell_ref);
+        if (cell.value.key() == key) {
+          // Splice current cell out of slot-chain.
+          storeRef(*ref, cell.next);
+
+          // Splice current cell into the free list of its size.
+          storeRef(cell.next, control_->free_cells[cell.size / Alignment]);
+          control_->free_cells[cell.size / Alignment] = cell_ref;
+
+          --control_->size;
+          return true;
+        }
+        next = &cell.next;
+      }
+    }
+    return false;
+  }
+
+  /** Returns the number of key/values stored in the set. */
+  uint32_t size() const { return control_->size; }
+
+  /** Returns the number of segments the set has grown to. */
+  uint32_t numSegments() const { return control_->num_segments; }
+
+  /**
+   * Gets the value associated with a key, returning nullptr if the value was not found.
+   * @param key
+   */
+  Value* get(absl::string_view key) {
+    mapNewSegments();
+    const uint64_t hash = Value::hash(key);
+    for (Segment* segment : segments_) {
+      for (uint64_t ref = segment->slots[hash % segment->num_slots]; ref != Sentinal;
+           ref = getCell(ref).next) {
+        Cell& cell = getCell(ref);
+        if (cell.value.key() == key) {
+          return &cell.value;
+        }
+      }
+    }
+    return nullptr;
+  }
+
+  /**
+   * Gets the value associated with a key without requiring the lock serializing the other
+   * methods, which may run concurrently in this or another process. Only the segments already
+   * mapped by this process are searched, and the value may be removed, and its memory reused for
+   * another key, at any time. A nullptr result therefore doesn't prove that the key is absent,
+   * and a value returned must be pinned, e.g. by reference counting, and its key checked again
+   * before it is used.
+   * @param key
+   */
+  Value* getUnlocked(absl::string_view key) {
+    const uint32_t num_segments = num_mapped_segments_.load(std::memory_order_acquire);
+    const uint64_t hash = Value::hash(key);
+    // A cell removed and reused while it is visited can lead the walk into another list, which
+    // may in turn cycle; give up once more cells than the set can hold have been visited.
+    uint64_t max_cells = control_->hash_set_options.capacity;
+    for (uint32_t index = 0; index < num_segments; ++index) {
+      Segment& segment = *segments_[index];
+      for (uint64_t ref = loadRef(segment.slots[hash % segment.num_slots]); ref != Sentinal;
+           ref = loadRef(getCell(ref).next)) {
+        // Free lists link cells across segments, including some not mapped here yet.
+        if (max_cells-- == 0 || segmentIndex(ref) >= num_segments) {
+          return nullptr;
+        }
+        Cell& cell = getCell(ref);
+        if (cell.value.key() == key) {
+          return &cell.value;
+        }
+      }
+    }
+    return nullptr;
+  }
+
+  /**
+   * Computes a version signature based on the options and the hash function.
+   */
+  static std::string version(const SegmentedMemoryHashSetOptions& hash_set_options,
+                             const Stats::StatsOptions& stats_options) {
+    return fmt::format("options={} hash={} size={}", hash_set_options.toString(),
+                       Value::hash(signatureStringToHash()), numBytes(stats_options));
+  }
+
+  /**
+   * Returns the size of a segment, which only depends on the options and its index.
+   */
+  static uint64_t segmentBytes(const SegmentedMemoryHashSetOptions& hash_set_options,
+                               uint32_t index) {
+    uint64_t bytes = hash_set_options.initial_segment_bytes;
+    for (uint32_t i = 0; i < index && bytes < hash_set_options.max_segment_bytes; ++i) {
+      bytes *= 2;
+    }
+    return std::min(bytes, hash_set_options.max_segment_bytes);
+  }
+
+private:
+  friend class SegmentedMemoryHashSetTest;
+
+  /**
+   * Represents control-values for the hash-set.
+   */
+  struct Control {
+    SegmentedMemoryHashSetOptions hash_set_options; // Options established at set construction.
+    uint64_t hash_signature;                        // Hash of a constant signature string.
+    uint64_t num_bytes;                             // Bytes of the control block.
+    uint32_t size;                                  // Number of values currently stored.
+    uint32_t num_segments;                          // Number of segments created so far.
+    uint32_t num_size_classes;                      // Number of entries in free_cells.
+    uint32_t unused;
+    uint64_t free_cells[];                          // Free list heads, by cell size / Alignment.
+  };
+
+  /**
+   * Represents the header of a segment, which is followed by its slots and then its cells.
+   */
+  struct Segment {
+    uint64_t num_bytes; // Size of the segment, including this header.
+    uint64_t end;       // Offset of the first byte not carved into cells yet.
+    uint32_t num_slots; // Number of entries in slots.
+    uint32_t unused;
+    uint64_t slots[]; // Heads of the lists of cells, terminated with Sentinal.
+  };
+
+  /**
+   * Represents a value-cell, which is stored in a linked-list from a slot of its segment, or in
+   * a free list once removed.
+   */
+  struct Cell {
+    uint64_t next; // Reference to the next cell in the list, terminated with Sentinal.
+    uint32_t size; // Size of the cell in bytes, including this header.
+    uint32_t unused;
+    Value value; // Templated value field.
+  };
+
+  static constexpr uint64_t Alignment = alignof(Cell);
+  // Cell offsets are stored in the low 32 bits of a reference.
+  static constexpr uint64_t MaxSegmentBytes = 1ULL << 31;
+  // Expected bytes of cells per slot, which sets the size of the slot table of each segment.
+  static constexpr uint64_t BytesPerSlot = 128;
+
+  static uint64_t align(uint64_t size) { return (size + Alignment - 1) & ~(Alignment - 1); }
+
+  /**
+   * Returns the size of the cell holding a key of the given size. sizeof(Cell) includes
+   * 'sizeof Value' which may not be accurate, so subtract that off, and add the template
+   * method's view of the actual value-size.
+   */
+  static uint64_t cellSize(uint64_t key_size) {
+    return align(sizeof(Cell) + Value::structSize(key_size) - sizeof(Value));
+  }
+
+  static uint64_t maxCellSize(const Stats::StatsOptions& stats_options) {
+    return align(sizeof(Cell) + Value::structSizeWithOptions(stats_options) - sizeof(Value));
+  }
+
+  static uint32_t numSizeClasses(const Stats::StatsOptions& stats_options) {
+    return maxCellSize(stats_options) / Alignment + 1;
+  }
+
+  static uint32_t numSlots(uint64_t segment_bytes) {
+    // An odd number of slots, so that the modulus uses all the bits of the hash.
+    return (segment_bytes / BytesPerSlot) | 1;
+  }
+
+  static uint64_t segmentHeaderBytes(uint64_t segment_bytes) {
+    return align(sizeof(Segment) + numSlots(segment_bytes) * sizeof(uint64_t));
+  }
+
+  static uint64_t makeRef(uint32_t index, uint64_t offset) {
+    return (static_cast<uint64_t>(index) << 32) | offset;
+  }
+  static uint32_t segmentIndex(uint64_t ref) { return ref >> 32; }
+  static uint64_t segmentOffset(uint64_t ref) { return ref & 0xffffffff; }
+
+  // Slot and cell links are shared with getUnlocked(), possibly in another process, so they are
+  // accessed atomically on the raw shared memory.
+  static uint64_t loadRef(const uint64_t& link) { return __atomic_load_n(&link, __ATOMIC_ACQUIRE); }
+  static void storeRef(uint64_t& link, uint64_t ref) {
+    __atomic_store_n(&link, ref, __ATOMIC_RELEASE);
+  }
+
+  /**
+   * Computes a signature string, composed of all the non-zero 8-bit characters.
+   * This is used for detecting if the hash algorithm changes, which invalidates
+   * any saved stats-set.
+   */
+  static std::string signatureStringToHash() {
+    std::string signature_string;
+    signature_string.resize(255);
+    for (int i = 1; i <= 255; ++i) {
+      signature_string[i - 1] = i;
+    }
+    return signature_string;
+  }
+
+  /**
+   * Initializes the control block. Segments are only created once values are inserted.
+   */
+  void initialize(const SegmentedMemoryHashSetOptions& hash_set_options) {
+    control_->hash_set_options = hash_set_options;
+    control_->hash_signature = Value::hash(signatureStringToHash());
+    control_->num_bytes = numBytes(stats_options_);
+    control_->size = 0;
+    control_->num_segments = 0;
+    control_->num_size_classes = numSizeClasses(stats_options_);
+    for (uint32_t size_class = 0; size_class < control_->num_size_classes; ++size_class) {
+      control_->free_cells[size_class] = Sentinal;
+    }
+  }
+
+  /**
+   * Attempts to attach to an existing set. Makes sure the options copied to the control block
+   * match, maps the existing segments, and checks that the slot, cell, and free list structures
+   * look sane.
+   */
+  bool attach(const SegmentedMemoryHashSetOptions& hash_set_options) {
+    if (numBytes(stats_options_) != control_->num_bytes) {
+      ENVOY_LOG(error, "SegmentedMemoryHashSet unexpected memory size {} != {}",
+                numBytes(stats_options_), control_->num_bytes);
+      return false;
+    }
+    if (hash_set_options != control_->hash_set_options) {
+      ENVOY_LOG(error, "SegmentedMemoryHashSet options mismatch {} != {}",
+                hash_set_options.toString(), control_->hash_set_options.toString());
+      return false;
+    }
+    if (Value::hash(signatureStringToHash()) != control_->hash_signature) {
+      ENVOY_LOG(error, "SegmentedMemoryHashSet hash signature mismatch.");
+      return false;
+    }
+    sanityCheck();
+    return true;
+  }
+
+  /**
+   * Maps the segments created since the last access, by this or another process.
+   */
+  void mapNewSegments() {
+    while (segments_.size() < control_->num_segments) {
+      const uint32_t index = segments_.size();
+      uint8_t* memory =
+          mapper_.mapSegment(index, segmentBytes(control_->hash_set_options, index), false);
+      RELEASE_ASSERT(memory != nullptr, "");
+      segments_.push_back(reinterpret_cast<Segment*>(memory));
+      num_mapped_segments_.store(segments_.size(), std::memory_order_release);
+    }
+  }
+
+  /**
+   * Carves a new cell from the end of the last segment, or from a new segment if it is full.
+   * @return the reference of the cell, or Sentinal if no segment could be added.
+   */
+  uint64_t carveCell(uint64_t cell_size) {
+    if (!segments_.empty()) {
+      Segment& last = *segments_.back();
+      if (last.end + cell_size <= last.num_bytes) {
+        const uint64_t ref = makeRef(segments_.size() - 1, last.end);
+        last.end += cell_size;
+        getCell(ref).size = cell_size;
+        return ref;
+      }
+    }
+
+    // The tail of the last segment, if any, is left unused.
+    const uint32_t index = segments_.size();
+    if (index >= control_->hash_set_options.max_segments) {
+      return Sentinal;
+    }
+    const uint64_t num_bytes = segmentBytes(control_->hash_set_options, index);
+    uint8_t* memory = mapper_.mapSegment(index, num_bytes, true);
+    if (memory == nullptr) {
+      ENVOY_LOG(error, "SegmentedMemoryHashSet unable to map segment {} of {} bytes", index,
+                num_bytes);
+      return Sentinal;
+    }
+    Segment& segment = *reinterpret_cast<Segment*>(memory);
+    segment.num_bytes = num_bytes;
+    segment.num_slots = numSlots(num_bytes);
+    for (uint32_t slot = 0; slot < segment.num_slots; ++slot) {
+      segment.slots[slot] = Sentinal;
+    }
+    segment.end = segmentHeaderBytes(num_bytes) + cell_size;
+    segments_.push_back(&segment);
+    num_mapped_segments_.store(segments_.size(), std::memory_order_release);
+    ++control_->num_segments;
+
+    const uint64_t ref = makeRef(index, segmentHeaderBytes(num_bytes));
+    getCell(ref).size = cell_size;
+    return ref;
+  }
+
+  Cell& cellAt(uint32_t index, uint64_t offset) {
+    uint8_t* ptr = reinterpret_cast<uint8_t*>(segments_[index]) + offset;
+    RELEASE_ASSERT((reinterpret_cast<uint64_t>(ptr) & (Alignment - 1)) == 0, "");
+    return *reinterpret_cast<Cell*>(ptr);
+  }
+
+  /**
+   * Returns a reference to the Cell at the specified reference.
+   */
+  Cell& getCell(uint64_t ref) { return cellAt(segmentIndex(ref), segmentOffset(ref)); }
+
+  Control* control_;
+  MemorySegmentMapper& mapper_;
+  const Stats::StatsOptions& stats_options_;
+  // The segments mapped by this process, in order of their index.
+  std::vector<Segment*> segments_;
+  // The size of segments_, for getUnlocked().
+  std::atomic<uint32_t> num_mapped_segments_{0};
+};
+
+} // namespace Envoy
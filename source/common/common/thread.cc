@@ -1,12 +1,17 @@
 #include "common/common/thread.h"
 
 #ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sched.h>
 #include <sys/syscall.h>
 #elif defined(__APPLE__)
 #include <pthread.h>
 #endif
 
+#include <algorithm>
+#include <exception>
 #include <functional>
+#include <thread>
 
 #include "common/common/assert.h"
 #include "common/common/macros.h"
@@ -37,10 +42,84 @@ int32_t Thread::currentThreadId() {
 #endif
 }
 
+bool Thread::pinCurrentThread(uint32_t cpu) {
+#ifdef __linux__
+  if (cpu >= CPU_SETSIZE) {
+    return false;
+  }
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(cpu, &cpus);
+  return pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+#else
+  UNREFERENCED_PARAMETER(cpu);
+  return false;
+#endif
+}
+
+std::vector<uint32_t> Thread::allowedCpus() {
+  std::vector<uint32_t> allowed;
+#ifdef __linux__
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  if (pthread_getaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0) {
+    for (uint32_t cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+      if (CPU_ISSET(cpu, &cpus)) {
+        allowed.push_back(cpu);
+      }
+    }
+  }
+#endif
+  return allowed;
+}
+
+bool Thread::useLocalMemoryPolicy() {
+#if defined(__linux__) && defined(MPOL_LOCAL)
+  // glibc has no wrapper, and libnuma is not worth a dependency for a single call.
+  return syscall(SYS_set_mempolicy, MPOL_LOCAL, nullptr, 0) == 0;
+#else
+  return false;
+#endif
+}
+
 void Thread::join() {
   int rc = pthread_join(thread_id_, nullptr);
   RELEASE_ASSERT(rc == 0, "");
 }
 
+void parallelFor(size_t count, size_t min_per_thread, const std::function<void(size_t)>& fn) {
+  const size_t max_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+  const size_t shards =
+      std::max<size_t>(1, std::min(max_threads, count / std::max<size_t>(1, min_per_thread)));
+  // The ranges are contiguous and in order, so the first exception of the first failed shard is
+  // the one of the lowest index.
+  std::vector<std::exception_ptr> errors(shards);
+  auto run_shard = [&](size_t shard) {
+    for (size_t i = count * shard / shards; i < count * (shard + 1) / shards; i++) {
+      try {
+        fn(i);
+      } catch (...) {
+        errors[shard] = std::current_exception();
+        return;
+      }
+    }
+  };
+
+  std::vector<ThreadPtr> helpers;
+  for (size_t shard = 1; shard < shards; shard++) {
+    helpers.emplace_back(new Thread([&run_shard, shard]() { run_shard(shard); }));
+  }
+  run_shard(0);
+  for (ThreadPtr& helper : helpers) {
+    helper->join();
+  }
+
+  for (const std::exception_ptr& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
 } // namespace Thread
 } // namespace Envoy
@@ -2,6 +2,7 @@
 
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include "envoy/thread/thread.h"
 
@@ -25,6 +26,26 @@ public:
    */
   static ThreadId currentThreadId();
 
+  /**
+   * Restrict the calling thread to a single CPU.
+   * @param cpu supplies the index of the CPU.
+   * @return bool whether the thread was pinned. Always false on platforms other than Linux.
+   */
+  static bool pinCurrentThread(uint32_t cpu);
+
+  /**
+   * @return std::vector<uint32_t> the CPUs the calling thread may run on, in ascending order.
+   *         Empty on platforms other than Linux.
+   */
+  static std::vector<uint32_t> allowedCpus();
+
+  /**
+   * Make memory allocated by the calling thread come from the NUMA node of the CPU it runs on,
+   * overriding any process wide policy such as interleaving.
+   * @return bool whether the policy was applied. Always false on platforms other than Linux.
+   */
+  static bool useLocalMemoryPolicy();
+
   /**
    * Join on thread exit.
    */
@@ -37,6 +58,15 @@ private:
 
 typedef std::unique_ptr<Thread> ThreadPtr;
 
+/**
+ * Run fn(i) for each i in [0, count) on the calling thread and up to one helper thread per
+ * hardware thread, giving each thread a contiguous range of at least min_per_thread indexes.
+ * Returns once all the calls are done. The helper threads aren't registered with thread local
+ * storage, so fn must not touch thread local state (e.g. stats or dispatchers). If calls throw,
+ * the exception of the lowest index is rethrown once all the threads have joined.
+ */
+void parallelFor(size_t count, size_t min_per_thread, const std::function<void(size_t)>& fn);
+
 /**
  * Implementation of BasicLockable
  */
@@ -9,13 +9,15 @@ TokenBucketImpl::TokenBucketImpl(uint64_t max_tokens, TimeSource& time_source, d
       last_fill_(time_source.monotonicTime()), time_source_(time_source) {}
 
 bool TokenBucketImpl::consume(uint64_t tokens) {
+  // The time of the last fill is updated even when the bucket is full, otherwise the time it spent
+  // full would refill it as soon as it is consumed.
+  const auto time_now = time_source_.monotonicTime();
   if (tokens_ < max_tokens_) {
-    const auto time_now = time_source_.monotonicTime();
     tokens_ = std::min((std::chrono::duration<double>(time_now - last_fill_).count() * fill_rate_) +
                            tokens_,
                        max_tokens_);
-    last_fill_ = time_now;
   }
+  last_fill_ = time_now;
 
   if (tokens_ < tokens) {
     return false;
@@ -1,6 +1,8 @@
 #include "common/common/utility.h"
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <chrono>
 #include <cmath>
 #include <cstdint>
@@ -9,6 +11,7 @@
 
 #include "envoy/common/exception.h"
 
+#include "common/common/ascii.h"
 #include "common/common/assert.h"
 #include "common/common/fmt.h"
 #include "common/common/hash.h"
@@ -36,29 +39,32 @@ typedef ConstSingleton<SpecifierConstantValues> SpecifierConstants;
 } // namespace
 
 std::string DateFormatter::fromTime(const SystemTime& time) const {
-  struct CachedTime {
-    // The string length of a number of seconds since the Epoch. E.g. for "1528270093", the length
-    // is 10.
-    size_t seconds_length;
-
-    // A container object to hold a strftime'd string, its timestamp (in seconds) and a list of
-    // position offsets for each specifier found in a format string.
-    struct Formatted {
-      // The resulted string after format string is passed to strftime at a given point in time.
-      std::string str;
-
-      // A timestamp (in seconds) when this object is created.
-      std::chrono::seconds epoch_time_seconds;
-
-      // List of offsets for each specifier found in a format string. This is needed to compensate
-      // the position of each recorded specifier due to the possible size change of the previous
-      // segment (after strftime'd).
-      SpecifierOffsets specifier_offsets;
-    };
-    // A map is used to keep different formatted format strings at a given second.
-    std::unordered_map<std::string, const Formatted> formatted;
+  std::string formatted;
+  appendTime(time, formatted);
+  return formatted;
+}
+
+void DateFormatter::appendTime(const SystemTime& time, std::string& output) const {
+  // A strftime'd string for a format at a given second, and a list of position offsets for each
+  // specifier found in the format string.
+  struct Formatted {
+    // The id of the formatter whose format string was used.
+    uint64_t formatter_id;
+
+    // A timestamp (in seconds) when this object is created.
+    std::chrono::seconds epoch_time_seconds;
+
+    // The resulted string after format string is passed to strftime at a given point in time.
+    std::string str;
+
+    // List of offsets for each specifier found in a format string. This is needed to compensate
+    // the position of each recorded specifier due to the possible size change of the previous
+    // segment (after strftime'd).
+    SpecifierOffsets specifier_offsets;
   };
-  static thread_local CachedTime cached_time;
+  // The formats used on a thread are few, so they are looked up by formatter id in a vector rather
+  // than by hashing the format string on every call.
+  static thread_local std::vector<Formatted> cached_formats;
 
   const std::chrono::nanoseconds epoch_time_ns =
       std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch());
@@ -66,43 +72,45 @@ std::string DateFormatter::fromTime(const SystemTime& time) const {
   const std::chrono::seconds epoch_time_seconds =
       std::chrono::duration_cast<std::chrono::seconds>(epoch_time_ns);
 
-  const auto& item = cached_time.formatted.find(format_string_);
-  if (item == cached_time.formatted.end() ||
-      item->second.epoch_time_seconds != epoch_time_seconds) {
-    // Remove all the expired cached items.
-    for (auto it = cached_time.formatted.cbegin(); it != cached_time.formatted.cend();) {
-      if (it->second.epoch_time_seconds != epoch_time_seconds) {
-        it = cached_time.formatted.erase(it);
-      } else {
-        it++;
-      }
+  auto item = std::find_if(cached_formats.begin(), cached_formats.end(),
+                           [this](const Formatted& cached) { return cached.formatter_id == id_; });
+  if (item == cached_formats.end() || item->epoch_time_seconds != epoch_time_seconds) {
+    if (item == cached_formats.end()) {
+      // Remove all the expired cached items, which include the formats of destroyed formatters.
+      cached_formats.erase(std::remove_if(cached_formats.begin(), cached_formats.end(),
+                                          [epoch_time_seconds](const Formatted& cached) {
+                                            return cached.epoch_time_seconds != epoch_time_seconds;
+                                          }),
+                           cached_formats.end());
+      cached_formats.emplace_back();
+      item = cached_formats.end() - 1;
+      item->formatter_id = id_;
     }
 
-    const time_t current_time = std::chrono::system_clock::to_time_t(time);
-
     // Build a new formatted format string at current time.
-    CachedTime::Formatted formatted;
+    const time_t current_time = std::chrono::system_clock::to_time_t(time);
     const std::string seconds_str = fmt::FormatInt(epoch_time_seconds.count()).str();
-    formatted.str =
-        fromTimeAndPrepareSpecifierOffsets(current_time, formatted.specifier_offsets, seconds_str);
-    cached_time.seconds_length = seconds_str.size();
+    item->specifier_offsets.clear();
+    item->str = fromTimeAndPrepareSpecifierOffsets(current_time, item->specifier_offsets,
+                                                   seconds_str);
 
-    // Stamp the formatted string using the current epoch time in seconds, and then cache it in.
-    formatted.epoch_time_seconds = epoch_time_seconds;
-    cached_time.formatted.emplace(std::make_pair(format_string_, formatted));
+    // Stamp the formatted string using the current epoch time in seconds.
+    item->epoch_time_seconds = epoch_time_seconds;
   }
 
-  const auto& formatted = cached_time.formatted.at(format_string_);
+  const Formatted& formatted = *item;
   ASSERT(specifiers_.size() == formatted.specifier_offsets.size());
 
-  // Copy the current cached formatted format string, then replace its subseconds part (when it has
-  // non-zero width) by correcting its position using prepared subseconds offsets.
-  std::string formatted_str = formatted.str;
-  std::string nanoseconds = fmt::FormatInt(epoch_time_ns.count()).str();
-  // Special case handling for beginning of time, we should never need to do this outside of
-  // tests or a time machine.
-  if (nanoseconds.size() < 10) {
-    nanoseconds = std::string(10 - nanoseconds.size(), '0') + nanoseconds;
+  // Append the current cached formatted format string, then replace its subseconds part (when it
+  // has non-zero width) by correcting its position using prepared subseconds offsets. The
+  // subseconds are the leading digits of the nine digit nanoseconds within the second.
+  const size_t start = output.size();
+  output += formatted.str;
+  uint64_t subsecond_ns = (epoch_time_ns - epoch_time_seconds).count();
+  char subseconds[9];
+  for (size_t i = sizeof(subseconds); i > 0; --i) {
+    subseconds[i - 1] = '0' + subsecond_ns % 10;
+    subsecond_ns /= 10;
   }
 
   for (size_t i = 0; i < specifiers_.size(); ++i) {
@@ -111,64 +119,14 @@ std::string DateFormatter::fromTime(const SystemTime& time) const {
     // When specifier.width_ is zero, skip the replacement. This is the last segment or it has no
     // specifier.
     if (specifier.width_ > 0 && !specifier.second_) {
-      ASSERT(specifier.position_ + formatted.specifier_offsets.at(i) < formatted_str.size());
-      formatted_str.replace(specifier.position_ + formatted.specifier_offsets.at(i),
-                            specifier.width_,
-                            nanoseconds.substr(cached_time.seconds_length, specifier.width_));
+      const size_t position = start + specifier.position_ + formatted.specifier_offsets.at(i);
+      ASSERT(position < output.size());
+      ASSERT(specifier.width_ <= sizeof(subseconds));
+      output.replace(position, specifier.width_, subseconds, specifier.width_);
     }
   }
 
-  ASSERT(formatted_str.size() == formatted.str.size());
-  return formatted_str;
-}
-
-std::string DateFormatter::parse(const std::string& format_string) {
-  std::string new_format_string = format_string;
-  std::smatch matched;
-  size_t step = 0;
-  while (regex_search(new_format_string, matched, SpecifierConstants::get().PATTERN)) {
-    // The std::smatch matched for (%([1-9])?f)|(%s): [all, subsecond-specifier, subsecond-specifier
-    // width, second-specifier].
-    const std::string& width_specifier = matched[2];
-    const std::string& second_specifier = matched[3];
-
-    // In the template string to be used in runtime substitution, the width is the number of
-    // characters to be replaced.
-    const size_t width = width_specifier.empty() ? 9 : width_specifier.at(0) - '0';
-    new_format_string.replace(matched.position(), matched.length(),
-                              std::string(second_specifier.empty() ? width : 2, '?'));
-
-    ASSERT(step < new_format_string.size());
-
-    // This records matched position, the width of current subsecond pattern, and also the string
-    // segment before the matched position. These values will be used later at data path.
-    specifiers_.emplace_back(
-        second_specifier.empty()
-            ? Specifier(matched.position(), width,
-                        new_format_string.substr(step, matched.position() - step))
-            : Specifier(matched.position(),
-                        new_format_string.substr(step, matched.position() - step)));
-
-    step = specifiers_.back().position_ + specifiers_.back().width_;
-  }
-
-  // To capture the segment after the last specifier pattern of a format string by creating a zero
-  // width specifier. E.g. %3f-this-is-the-last-%s-segment-%Y-until-this.
-  if (step < new_format_string.size()) {
-    Specifier specifier(step, 0, new_format_string.substr(step));
-    specifiers_.emplace_back(specifier);
-  }
-
-  return new_format_string;
-}
-
-std::string DateFormatter::fromTime(time_t time) const {
-  tm current_tm;
-  gmtime_r(&time, &current_tm);
-
-  std::array<char, 1024> buf;
-  const size_t len = strftime(&buf[0], buf.size(), format_string_.c_str(), &current_tm);
-  return std::string(&buf[0], len);
+  ASSERT(output.size() - start == formatted.str.size());
 }
 
 std::string
@@ -308,23 +266,23 @@ bool StringUtil::findToken(absl::string_view source, absl::string_view delimiter
 
 bool StringUtil::caseFindToken(absl::string_view source, absl::string_view delimiters,
                                absl::string_view key_token, bool trim_whitespace) {
-  const auto tokens = splitToken(source, delimiters, trim_whitespace);
-  std::function<bool(absl::string_view)> predicate;
-
-  if (trim_whitespace) {
-    predicate = [&](absl::string_view token) { return caseCompare(key_token, trim(token)); };
-  } else {
-    predicate = [&](absl::string_view token) { return caseCompare(key_token, token); };
+  // This runs for headers like Connection on every request, so the tokens are visited as they are
+  // split rather than collected in a vector.
+  for (absl::string_view token : absl::StrSplit(source, absl::ByAnyChar(delimiters))) {
+    if (trim_whitespace) {
+      token = trim(token);
+    } else if (token.empty()) {
+      continue;
+    }
+    if (caseCompare(key_token, token)) {
+      return true;
+    }
   }
-
-  return std::find_if(tokens.begin(), tokens.end(), predicate) != tokens.end();
+  return false;
 }
 
 bool StringUtil::caseCompare(absl::string_view lhs, absl::string_view rhs) {
-  if (rhs.size() != lhs.size()) {
-    return false;
-  }
-  return absl::StartsWithIgnoreCase(rhs, lhs);
+  return AsciiUtil::caseEqual(lhs, rhs);
 }
 
 absl::string_view StringUtil::cropRight(absl::string_view source, absl::string_view delimiter) {
@@ -422,6 +380,12 @@ std::string StringUtil::escape(const std::string& source) {
 }
 
 std::string AccessLogDateTimeFormatter::fromTime(const SystemTime& time) {
+  std::string formatted;
+  appendTime(time, formatted);
+  return formatted;
+}
+
+void AccessLogDateTimeFormatter::appendTime(const SystemTime& time, std::string& output) {
   static const char DefaultDateFormat[] = "%Y-%m-%dT%H:%M:%S.000Z";
 
   struct CachedTime {
@@ -461,7 +425,7 @@ std::string AccessLogDateTimeFormatter::fromTime(const SystemTime& time) {
   msec %= 10;
   cached_time.formatted_time[offset++] = ('0' + msec);
 
-  return cached_time.formatted_time;
+  output.append(cached_time.formatted_time, cached_time.formatted_time_length);
 }
 
 bool StringUtil::endsWith(const std::string& source, const std::string& end) {
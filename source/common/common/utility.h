@@ -25,13 +25,22 @@ namespace Envoy {
  */
 class DateFormatter {
 public:
-  DateFormatter(const std::string& format_string) : format_string_(parse(format_string)) {}
+  DateFormatter(const std::string& format_string)
+      : format_string_(parse(format_string)), id_(nextId()) {}
 
   /**
    * @return std::string representing the GMT/UTC time based on the input time.
    */
   std::string fromTime(const SystemTime& time) const;
 
+  /**
+   * Appends the GMT/UTC time based on the input time to a string. The string formatted for the
+   * second of the time is cached per thread, so that only its subseconds are formatted again.
+   * @param time supplies the time.
+   * @param output supplies the string to append to.
+   */
+  void appendTime(const SystemTime& time, std::string& output) const;
+
   /**
    * @return std::string representing the GMT/UTC time based on the input time.
    */
@@ -49,6 +58,7 @@ public:
 
 private:
   std::string parse(const std::string& format_string);
+  static uint64_t nextId();
 
   typedef std::vector<int32_t> SpecifierOffsets;
   std::string fromTimeAndPrepareSpecifierOffsets(time_t time, SpecifierOffsets& specifier_offsets,
@@ -85,6 +95,9 @@ private:
   std::vector<Specifier> specifiers_;
 
   const std::string format_string_;
+
+  // Identifies the format in the per-thread cache of formatted seconds. Copies share it.
+  const uint64_t id_;
 };
 
 /**
@@ -93,6 +106,13 @@ private:
 class AccessLogDateTimeFormatter {
 public:
   static std::string fromTime(const SystemTime& time);
+
+  /**
+   * Appends the time to a string, without building an intermediate string.
+   * @param time supplies the time.
+   * @param output supplies the string to append to.
+   */
+  static void appendTime(const SystemTime& time, std::string& output);
 };
 
 /**
@@ -29,6 +29,22 @@ void ZlibCompressorImpl::init(CompressionLevel comp_level, CompressionStrategy c
                                   window_bits, memory_level, static_cast<uint64_t>(comp_strategy));
   RELEASE_ASSERT(result >= 0, "");
   initialized_ = true;
+  strategy_ = comp_strategy;
+}
+
+void ZlibCompressorImpl::reset() {
+  ASSERT(initialized_);
+  const int result = deflateReset(zstream_ptr_.get());
+  RELEASE_ASSERT(result == Z_OK, "");
+  zstream_ptr_->avail_out = chunk_size_;
+  zstream_ptr_->next_out = chunk_char_ptr_.get();
+}
+
+void ZlibCompressorImpl::setCompressionLevel(CompressionLevel comp_level) {
+  ASSERT(initialized_);
+  const int result = deflateParams(zstream_ptr_.get(), static_cast<int64_t>(comp_level),
+                                   static_cast<uint64_t>(strategy_));
+  RELEASE_ASSERT(result == Z_OK, "");
 }
 
 uint64_t ZlibCompressorImpl::checksum() { return zstream_ptr_->adler; }
@@ -86,9 +102,9 @@ void ZlibCompressorImpl::process(Buffer::Instance& output_buffer, int64_t flush_
 void ZlibCompressorImpl::updateOutput(Buffer::Instance& output_buffer) {
   const uint64_t n_output = chunk_size_ - zstream_ptr_->avail_out;
   if (n_output > 0) {
+    // The output is copied into the buffer, so the chunk is reused for the next output.
     output_buffer.add(static_cast<void*>(chunk_char_ptr_.get()), n_output);
   }
-  chunk_char_ptr_.reset(new unsigned char[chunk_size_]);
   zstream_ptr_->avail_out = chunk_size_;
   zstream_ptr_->next_out = chunk_char_ptr_.get();
 }
@@ -64,6 +64,20 @@ public:
   void init(CompressionLevel level, CompressionStrategy strategy, int64_t window_bits,
             uint64_t memory_level);
 
+  /**
+   * Resets an initialized compressor so that it can compress a new stream with the same
+   * parameters, keeping the memory allocated by init rather than freeing and allocating it again.
+   * Any data of the previous stream which has not been output yet is discarded.
+   */
+  void reset();
+
+  /**
+   * Changes the compression level of an initialized compressor. It should be called before
+   * compressing any data of a stream, i.e. right after init or reset.
+   * @param level @see CompressionLevel enum
+   */
+  void setCompressionLevel(CompressionLevel level);
+
   /**
    * It returns the checksum of all output produced so far. Compressor's checksum at the end of the
    * stream has to match decompressor's checksum produced at the end of the decompression.
@@ -82,10 +96,13 @@ private:
 
   const uint64_t chunk_size_;
   bool initialized_;
+  CompressionStrategy strategy_{CompressionStrategy::Standard};
 
   std::unique_ptr<unsigned char[]> chunk_char_ptr_;
   std::unique_ptr<z_stream, std::function<void(z_stream*)>> zstream_ptr_;
 };
 
+typedef std::unique_ptr<ZlibCompressorImpl> ZlibCompressorImplPtr;
+
 } // namespace Compressor
 } // namespace Envoy
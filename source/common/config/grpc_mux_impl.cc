@@ -1,7 +1,19 @@
 #include "common/config/grpc_mux_impl.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
 #include <unordered_set>
 
+#include "common/common/cleanup.h"
 #include "common/common/token_bucket_impl.h"
 #include "common/config/utility.h"
 #include "common/protobuf/protobuf.h"
@@ -9,16 +21,31 @@
 namespace Envoy {
 namespace Config {
 
+namespace {
+
+// The snapshot file starts with this magic, which includes the version of the format, followed by
+// the length delimited node that wrote it and the length delimited responses of each API.
+constexpr char SnapshotMagic[] = "ENVOY_ADS_SNAPSHOT_1";
+constexpr size_t SnapshotMagicSize = sizeof(SnapshotMagic) - 1;
+
+} // namespace
+
 GrpcMuxImpl::GrpcMuxImpl(const LocalInfo::LocalInfo& local_info, Grpc::AsyncClientPtr async_client,
                          Event::Dispatcher& dispatcher,
                          const Protobuf::MethodDescriptor& service_method,
-                         Runtime::RandomGenerator& random)
+                         Runtime::RandomGenerator& random, const std::string& snapshot_path)
     : local_info_(local_info), async_client_(std::move(async_client)),
-      service_method_(service_method), random_(random), time_source_(dispatcher.timeSystem()) {
+      service_method_(service_method), random_(random), time_source_(dispatcher.timeSystem()),
+      snapshot_path_(snapshot_path) {
   Config::Utility::checkLocalInfo("ads", local_info);
   retry_timer_ = dispatcher.createTimer([this]() -> void { establishNewStream(); });
   backoff_strategy_ = std::make_unique<JitteredBackOffStrategy>(RETRY_INITIAL_DELAY_MS,
                                                                 RETRY_MAX_DELAY_MS, random_);
+  if (!snapshot_path_.empty()) {
+    snapshot_replay_timer_ = dispatcher.createTimer([this]() -> void { replaySnapshot(); });
+    snapshot_write_timer_ = dispatcher.createTimer([this]() -> void { writeSnapshot(); });
+    loadSnapshot();
+  }
 }
 
 GrpcMuxImpl::~GrpcMuxImpl() {
@@ -126,6 +153,12 @@ GrpcMuxWatchPtr GrpcMuxImpl::subscribe(const std::string& type_url,
   // only send a single RDS/EDS update after the CDS/LDS update.
   sendDiscoveryRequest(type_url);
 
+  if (loaded_snapshot_.count(type_url) > 0) {
+    // The snapshot is replayed once the caller is done subscribing rather than from within
+    // subscribe(), and until the server sends the resources of this API.
+    snapshot_replay_timer_->enableTimer(std::chrono::milliseconds(0));
+  }
+
   return watch;
 }
 
@@ -189,44 +222,14 @@ void GrpcMuxImpl::onReceiveMessage(std::unique_ptr<envoy::api::v2::DiscoveryResp
     return;
   }
   try {
-    // To avoid O(n^2) explosion (e.g. when we have 1000s of EDS watches), we
-    // build a map here from resource name to resource and then walk watches_.
-    // We have to walk all watches (and need an efficient map as a result) to
-    // ensure we deliver empty config updates when a resource is dropped.
-    std::unordered_map<std::string, ProtobufWkt::Any> resources;
-    GrpcMuxCallbacks& callbacks = api_state_[type_url].watches_.front()->callbacks_;
-    for (const auto& resource : message->resources()) {
-      if (type_url != resource.type_url()) {
-        throw EnvoyException(fmt::format("{} does not match {} type URL is DiscoveryResponse {}",
-                                         resource.type_url(), type_url, message->DebugString()));
-      }
-      const std::string resource_name = callbacks.resourceName(resource);
-      resources.emplace(resource_name, resource);
-    }
-    for (auto watch : api_state_[type_url].watches_) {
-      // onConfigUpdate should be called in all cases for single watch xDS (Cluster and Listener)
-      // even if the message does not have resources so that update_empty stat is properly
-      // incremented and state-of-the-world semantics are maintained.
-      if (watch->resources_.empty()) {
-        watch->callbacks_.onConfigUpdate(message->resources(), message->version_info());
-        continue;
-      }
-      Protobuf::RepeatedPtrField<ProtobufWkt::Any> found_resources;
-      for (auto watched_resource_name : watch->resources_) {
-        auto it = resources.find(watched_resource_name);
-        if (it != resources.end()) {
-          found_resources.Add()->MergeFrom(it->second);
-        }
-      }
-      // onConfigUpdate should be called only on watches(clusters/routes) that have updates in the
-      // message.
-      if (found_resources.size() > 0) {
-        watch->callbacks_.onConfigUpdate(found_resources, message->version_info());
-      }
-    }
+    ResourceMap resources = resourcesByName(*message);
+    dispatchResources(*message, resources, false);
     // TODO(mattklein123): In the future if we start tracking per-resource versions, we would do
     // that tracking here.
     api_state_[type_url].request_.set_version_info(message->version_info());
+    if (!snapshot_path_.empty()) {
+      updateSnapshot(type_url, message->version_info(), std::move(resources));
+    }
   } catch (const EnvoyException& e) {
     ENVOY_LOG(warn, "gRPC config for {} update rejected: {}", message->type_url(), e.what());
     for (auto watch : api_state_[type_url].watches_) {
@@ -240,6 +243,212 @@ void GrpcMuxImpl::onReceiveMessage(std::unique_ptr<envoy::api::v2::DiscoveryResp
   sendDiscoveryRequest(type_url);
 }
 
+GrpcMuxImpl::ResourceMap
+GrpcMuxImpl::resourcesByName(const envoy::api::v2::DiscoveryResponse& message) {
+  // To avoid O(n^2) explosion (e.g. when we have 1000s of EDS watches), we
+  // build a map here from resource name to resource and then walk watches_.
+  // We have to walk all watches (and need an efficient map as a result) to
+  // ensure we deliver empty config updates when a resource is dropped.
+  const std::string& type_url = message.type_url();
+  ResourceMap resources;
+  GrpcMuxCallbacks& callbacks = api_state_[type_url].watches_.front()->callbacks_;
+  for (const auto& resource : message.resources()) {
+    if (type_url != resource.type_url()) {
+      throw EnvoyException(fmt::format("{} does not match {} type URL is DiscoveryResponse {}",
+                                       resource.type_url(), type_url, message.DebugString()));
+    }
+    const std::string resource_name = callbacks.resourceName(resource);
+    resources.emplace(resource_name, resource);
+  }
+  return resources;
+}
+
+void GrpcMuxImpl::dispatchResources(const envoy::api::v2::DiscoveryResponse& message,
+                                    const ResourceMap& resources, bool new_watches_only) {
+  for (auto watch : api_state_[message.type_url()].watches_) {
+    if (new_watches_only && watch->updated_) {
+      continue;
+    }
+    // onConfigUpdate should be called in all cases for single watch xDS (Cluster and Listener)
+    // even if the message does not have resources so that update_empty stat is properly
+    // incremented and state-of-the-world semantics are maintained.
+    if (watch->resources_.empty()) {
+      watch->updated_ = true;
+      watch->callbacks_.onConfigUpdate(message.resources(), message.version_info());
+      continue;
+    }
+    Protobuf::RepeatedPtrField<ProtobufWkt::Any> found_resources;
+    for (auto watched_resource_name : watch->resources_) {
+      auto it = resources.find(watched_resource_name);
+      if (it != resources.end()) {
+        found_resources.Add()->MergeFrom(it->second);
+      }
+    }
+    // onConfigUpdate should be called only on watches(clusters/routes) that have updates in the
+    // message.
+    if (found_resources.size() > 0) {
+      watch->updated_ = true;
+      watch->callbacks_.onConfigUpdate(found_resources, message.version_info());
+    }
+  }
+}
+
+void GrpcMuxImpl::updateSnapshot(const std::string& type_url, const std::string& version_info,
+                                 ResourceMap&& resources) {
+  const std::list<GrpcMuxWatchImpl*>& watches = api_state_[type_url].watches_;
+  SnapshotEntry& entry = snapshot_[type_url];
+  auto loaded = loaded_snapshot_.find(type_url);
+  if (std::any_of(watches.begin(), watches.end(),
+                  [](const GrpcMuxWatchImpl* watch) { return watch->resources_.empty(); })) {
+    // The response has all the resources of the API.
+    entry.resources_.clear();
+  } else {
+    // The response may only have some of the watched resources, so the others are kept, including
+    // those of the loaded snapshot, as long as they are watched.
+    if (loaded != loaded_snapshot_.end()) {
+      try {
+        for (auto& resource : resourcesByName(loaded->second)) {
+          entry.resources_.emplace(resource.first, std::move(resource.second));
+        }
+      } catch (const EnvoyException& e) {
+        ENVOY_LOG(warn, "ADS snapshot for {} dropped: {}", type_url, e.what());
+      }
+    }
+    std::unordered_set<std::string> watched_resources;
+    for (const auto* watch : watches) {
+      watched_resources.insert(watch->resources_.begin(), watch->resources_.end());
+    }
+    for (auto it = entry.resources_.begin(); it != entry.resources_.end();) {
+      it = watched_resources.count(it->first) > 0 ? std::next(it) : entry.resources_.erase(it);
+    }
+  }
+  if (loaded != loaded_snapshot_.end()) {
+    loaded_snapshot_.erase(loaded);
+  }
+  entry.version_info_ = version_info;
+  for (auto& resource : resources) {
+    entry.resources_[resource.first] = std::move(resource.second);
+  }
+
+  if (!snapshot_write_pending_) {
+    snapshot_write_pending_ = true;
+    snapshot_write_timer_->enableTimer(std::chrono::milliseconds(SNAPSHOT_WRITE_DELAY_MS));
+  }
+}
+
+void GrpcMuxImpl::loadSnapshot() {
+  const int fd = ::open(snapshot_path_.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    ENVOY_LOG(info, "no ADS snapshot found at {}", snapshot_path_);
+    return;
+  }
+  struct stat file_stat;
+  void* data = MAP_FAILED;
+  if (::fstat(fd, &file_stat) == 0 && file_stat.st_size > 0 &&
+      file_stat.st_size <= std::numeric_limits<int>::max()) {
+    data = ::mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    ENVOY_LOG(warn, "unable to map ADS snapshot {}", snapshot_path_);
+    return;
+  }
+  const size_t size = file_stat.st_size;
+  Cleanup unmap([data, size]() { ::munmap(data, size); });
+
+  const char* bytes = static_cast<const char*>(data);
+  if (size < SnapshotMagicSize || ::memcmp(bytes, SnapshotMagic, SnapshotMagicSize) != 0) {
+    ENVOY_LOG(warn, "ignoring ADS snapshot {} of an unknown format", snapshot_path_);
+    return;
+  }
+  Protobuf::io::ArrayInputStream stream(bytes + SnapshotMagicSize, size - SnapshotMagicSize);
+  bool clean_eof;
+  envoy::api::v2::core::Node node;
+  if (!ProtobufUtil::ParseDelimitedFromZeroCopyStream(&node, &stream, &clean_eof)) {
+    ENVOY_LOG(warn, "ignoring truncated ADS snapshot {}", snapshot_path_);
+    return;
+  }
+  // Snapshots written for another node may not apply to this one.
+  if (node.id() != local_info_.nodeName() || node.cluster() != local_info_.clusterName()) {
+    ENVOY_LOG(info, "ignoring ADS snapshot {} of node {} in cluster {}", snapshot_path_, node.id(),
+              node.cluster());
+    return;
+  }
+
+  std::unordered_map<std::string, envoy::api::v2::DiscoveryResponse> loaded_snapshot;
+  while (true) {
+    envoy::api::v2::DiscoveryResponse response;
+    if (!ProtobufUtil::ParseDelimitedFromZeroCopyStream(&response, &stream, &clean_eof)) {
+      if (clean_eof) {
+        break;
+      }
+      ENVOY_LOG(warn, "ignoring truncated ADS snapshot {}", snapshot_path_);
+      return;
+    }
+    const std::string type_url = response.type_url();
+    loaded_snapshot[type_url] = std::move(response);
+  }
+  ENVOY_LOG(info, "loaded ADS snapshot {} with resources of {} APIs", snapshot_path_,
+            loaded_snapshot.size());
+  loaded_snapshot_ = std::move(loaded_snapshot);
+}
+
+void GrpcMuxImpl::replaySnapshot() {
+  // Replaying resources may subscribe to other APIs, e.g. clusters subscribe to their endpoints.
+  // These are appended to subscriptions_ and replayed in the same pass.
+  for (const std::string& type_url : subscriptions_) {
+    auto loaded = loaded_snapshot_.find(type_url);
+    if (loaded == loaded_snapshot_.end() || api_state_[type_url].watches_.empty()) {
+      continue;
+    }
+    ENVOY_LOG(debug, "Replaying ADS snapshot for {} at version {}", type_url,
+              loaded->second.version_info());
+    try {
+      dispatchResources(loaded->second, resourcesByName(loaded->second), true);
+    } catch (const EnvoyException& e) {
+      ENVOY_LOG(warn, "ADS snapshot for {} rejected: {}", type_url, e.what());
+      loaded_snapshot_.erase(type_url);
+    }
+  }
+}
+
+void GrpcMuxImpl::writeSnapshot() {
+  snapshot_write_pending_ = false;
+  // The snapshot is written to a temporary file which is then renamed, so that a restarting Envoy
+  // never sees it partially written.
+  const std::string temporary_path = snapshot_path_ + ".tmp";
+  {
+    std::ofstream stream(temporary_path, std::ios::binary | std::ios::trunc);
+    stream.write(SnapshotMagic, SnapshotMagicSize);
+    ProtobufUtil::SerializeDelimitedToOstream(local_info_.node(), &stream);
+    for (const std::string& type_url : subscriptions_) {
+      const auto entry = snapshot_.find(type_url);
+      if (entry == snapshot_.end()) {
+        const auto loaded = loaded_snapshot_.find(type_url);
+        if (loaded != loaded_snapshot_.end()) {
+          ProtobufUtil::SerializeDelimitedToOstream(loaded->second, &stream);
+        }
+        continue;
+      }
+      envoy::api::v2::DiscoveryResponse response;
+      response.set_type_url(type_url);
+      response.set_version_info(entry->second.version_info_);
+      for (const auto& resource : entry->second.resources_) {
+        response.add_resources()->CopyFrom(resource.second);
+      }
+      ProtobufUtil::SerializeDelimitedToOstream(response, &stream);
+    }
+    stream.flush();
+    if (!stream) {
+      ENVOY_LOG(warn, "unable to write ADS snapshot {}", temporary_path);
+      return;
+    }
+  }
+  if (::rename(temporary_path.c_str(), snapshot_path_.c_str()) != 0) {
+    ENVOY_LOG(warn, "unable to replace ADS snapshot {}: {}", snapshot_path_, strerror(errno));
+  }
+}
+
 void GrpcMuxImpl::onReceiveTrailingMetadata(Http::HeaderMapPtr&& metadata) {
   UNREFERENCED_PARAMETER(metadata);
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <map>
 #include <unordered_map>
 
 #include "envoy/common/time.h"
@@ -26,7 +27,7 @@ class GrpcMuxImpl : public GrpcMux,
 public:
   GrpcMuxImpl(const LocalInfo::LocalInfo& local_info, Grpc::AsyncClientPtr async_client,
               Event::Dispatcher& dispatcher, const Protobuf::MethodDescriptor& service_method,
-              Runtime::RandomGenerator& random);
+              Runtime::RandomGenerator& random, const std::string& snapshot_path);
   ~GrpcMuxImpl();
 
   void start() override;
@@ -45,12 +46,24 @@ public:
   // TODO(htuch): Make this configurable or some static.
   const uint32_t RETRY_INITIAL_DELAY_MS = 500;
   const uint32_t RETRY_MAX_DELAY_MS = 30000; // Do not cross more than 30s
+  const uint32_t SNAPSHOT_WRITE_DELAY_MS = 1000;
 
 private:
+  // Resources of a type by name.
+  typedef std::unordered_map<std::string, ProtobufWkt::Any> ResourceMap;
+
   void setRetryTimer();
   void establishNewStream();
   void sendDiscoveryRequest(const std::string& type_url);
   void handleFailure();
+  ResourceMap resourcesByName(const envoy::api::v2::DiscoveryResponse& message);
+  void dispatchResources(const envoy::api::v2::DiscoveryResponse& message,
+                         const ResourceMap& resources, bool new_watches_only);
+  void updateSnapshot(const std::string& type_url, const std::string& version_info,
+                      ResourceMap&& resources);
+  void loadSnapshot();
+  void replaySnapshot();
+  void writeSnapshot();
 
   struct GrpcMuxWatchImpl : public GrpcMuxWatch {
     GrpcMuxWatchImpl(const std::vector<std::string>& resources, GrpcMuxCallbacks& callbacks,
@@ -74,6 +87,8 @@ private:
     GrpcMuxImpl& parent_;
     std::list<GrpcMuxWatchImpl*>::iterator entry_;
     bool inserted_;
+    // Has the watch been given resources, either by the server or from the snapshot?
+    bool updated_{};
   };
 
   // Per muxed API state.
@@ -105,6 +120,20 @@ private:
   Runtime::RandomGenerator& random_;
   TimeSource& time_source_;
   BackOffStrategyPtr backoff_strategy_;
+
+  // The last accepted resources of each API, saved to snapshot_path_ if it is set.
+  struct SnapshotEntry {
+    std::string version_info_;
+    std::map<std::string, ProtobufWkt::Any> resources_;
+  };
+
+  const std::string snapshot_path_;
+  std::unordered_map<std::string, SnapshotEntry> snapshot_;
+  // Responses loaded from snapshot_path_ that were not replayed yet, by type URL.
+  std::unordered_map<std::string, envoy::api::v2::DiscoveryResponse> loaded_snapshot_;
+  Event::TimerPtr snapshot_replay_timer_;
+  Event::TimerPtr snapshot_write_timer_;
+  bool snapshot_write_pending_{};
 };
 
 class NullGrpcMuxImpl : public GrpcMux {
@@ -6,6 +6,7 @@
 
 #include "common/common/assert.h"
 #include "common/common/logger.h"
+#include "common/config/utility.h"
 #include "common/grpc/common.h"
 #include "common/protobuf/protobuf.h"
 #include "common/protobuf/utility.h"
@@ -44,10 +45,8 @@ public:
   // Config::GrpcMuxCallbacks
   void onConfigUpdate(const Protobuf::RepeatedPtrField<ProtobufWkt::Any>& resources,
                       const std::string& version_info) override {
-    Protobuf::RepeatedPtrField<ResourceType> typed_resources;
-    std::transform(resources.cbegin(), resources.cend(),
-                   Protobuf::RepeatedPtrFieldBackInserter(&typed_resources),
-                   MessageUtil::anyConvert<ResourceType>);
+    const Protobuf::RepeatedPtrField<ResourceType> typed_resources =
+        Utility::unpackResources<ResourceType>(resources);
     // TODO(mattklein123): In the future if we start tracking per-resource versions, we need to
     // supply those versions to onConfigUpdate() along with the xDS response ("system")
     // version_info. This way, both types of versions can be tracked and exposed for debugging by
@@ -60,6 +59,21 @@ public:
               resources.size(), RepeatedPtrUtil::debugString(typed_resources));
   }
 
+  void onIncrementalConfigUpdate(
+      const Protobuf::RepeatedPtrField<ProtobufWkt::Any>& added_resources,
+      const Protobuf::RepeatedPtrField<ProtobufTypes::String>& removed_resources,
+      const std::string& system_version_info) override {
+    const Protobuf::RepeatedPtrField<ResourceType> typed_resources =
+        Utility::unpackResources<ResourceType>(added_resources);
+    callbacks_->onIncrementalConfigUpdate(typed_resources, removed_resources, system_version_info);
+    stats_.update_success_.inc();
+    stats_.update_attempt_.inc();
+    stats_.version_.set(HashUtil::xxHash64(system_version_info));
+    ENVOY_LOG(debug, "gRPC config for {} accepted with {} added and {} removed resources: {}",
+              type_url_, added_resources.size(), removed_resources.size(),
+              RepeatedPtrUtil::debugString(typed_resources));
+  }
+
   void onConfigUpdateFailed(const EnvoyException* e) override {
     // TODO(htuch): Less fragile signal that this is failure vs. reject.
     if (e == nullptr) {
@@ -7,11 +7,16 @@
 
 #include "common/config/grpc_mux_impl.h"
 #include "common/config/grpc_mux_subscription_impl.h"
+#include "common/config/incremental_grpc_mux_impl.h"
 
 namespace Envoy {
 namespace Config {
 
-template <class ResourceType>
+/**
+ * gRPC subscription over a dedicated stream. MuxType is GrpcMuxImpl for the state-of-the-world
+ * protocol, or IncrementalGrpcMuxImpl for incremental xDS.
+ */
+template <class ResourceType, class MuxType = GrpcMuxImpl>
 class GrpcSubscriptionImpl : public Config::Subscription<ResourceType> {
 public:
   GrpcSubscriptionImpl(const LocalInfo::LocalInfo& local_info, Grpc::AsyncClientPtr async_client,
@@ -32,10 +37,10 @@ public:
     grpc_mux_subscription_.updateResources(resources);
   }
 
-  GrpcMuxImpl& grpcMux() { return grpc_mux_; }
+  MuxType& grpcMux() { return grpc_mux_; }
 
 private:
-  GrpcMuxImpl grpc_mux_;
+  MuxType grpc_mux_;
   GrpcMuxSubscriptionImpl<ResourceType> grpc_mux_subscription_;
 };
 
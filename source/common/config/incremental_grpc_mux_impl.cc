@@ -0,0 +1,273 @@
+#include "common/config/incremental_grpc_mux_impl.h"
+
+#include <algorithm>
+
+#include "common/common/token_bucket_impl.h"
+#include "common/config/utility.h"
+#include "common/protobuf/protobuf.h"
+
+namespace Envoy {
+namespace Config {
+
+IncrementalGrpcMuxImpl::IncrementalGrpcMuxImpl(const LocalInfo::LocalInfo& local_info,
+                                               Grpc::AsyncClientPtr async_client,
+                                               Event::Dispatcher& dispatcher,
+                                               const Protobuf::MethodDescriptor& service_method,
+                                               Runtime::RandomGenerator& random)
+    : local_info_(local_info), async_client_(std::move(async_client)),
+      service_method_(service_method), random_(random), time_source_(dispatcher.timeSystem()) {
+  Config::Utility::checkLocalInfo("incremental xds", local_info);
+  request_.mutable_node()->MergeFrom(local_info_.node());
+  // TODO(gsagula): move TokenBucketImpl params to a config.
+  // Bucket contains 100 tokens maximum and refills at 5 tokens/sec.
+  limit_request_ = std::make_unique<TokenBucketImpl>(100, time_source_, 5);
+  // Bucket contains 1 token maximum and refills 1 token on every ~5 seconds.
+  limit_log_ = std::make_unique<TokenBucketImpl>(1, time_source_, 0.2);
+  retry_timer_ = dispatcher.createTimer([this]() -> void { establishNewStream(); });
+  backoff_strategy_ = std::make_unique<JitteredBackOffStrategy>(RETRY_INITIAL_DELAY_MS,
+                                                                RETRY_MAX_DELAY_MS, random_);
+}
+
+IncrementalGrpcMuxImpl::~IncrementalGrpcMuxImpl() {
+  for (auto watch : watches_) {
+    watch->inserted_ = false;
+  }
+}
+
+void IncrementalGrpcMuxImpl::start() { establishNewStream(); }
+
+void IncrementalGrpcMuxImpl::setRetryTimer() {
+  retry_timer_->enableTimer(std::chrono::milliseconds(backoff_strategy_->nextBackOffMs()));
+}
+
+void IncrementalGrpcMuxImpl::establishNewStream() {
+  ENVOY_LOG(debug, "Establishing new gRPC bidi stream for {}", service_method_.DebugString());
+  stream_ = async_client_->start(service_method_, *this);
+  if (stream_ == nullptr) {
+    ENVOY_LOG(warn, "Unable to establish new stream");
+    handleFailure();
+    return;
+  }
+
+  if (type_url_.empty()) {
+    return;
+  }
+  // The management server knows nothing about a new stream, so all the watched resources are
+  // subscribed to again, along with the versions of the ones we already have.
+  resource_names_.clear();
+  request_.clear_response_nonce();
+  request_.clear_error_detail();
+  auto& initial_resource_versions = *request_.mutable_initial_resource_versions();
+  for (const auto& resource_version : resource_versions_) {
+    initial_resource_versions[resource_version.first] = resource_version.second;
+  }
+  sendDiscoveryRequest();
+}
+
+void IncrementalGrpcMuxImpl::sendDiscoveryRequest() {
+  if (stream_ == nullptr) {
+    ENVOY_LOG(debug, "No stream available to sendDiscoveryRequest for {}", type_url_);
+    return;
+  }
+
+  if (paused_) {
+    ENVOY_LOG(trace, "API {} paused during sendDiscoveryRequest(), setting pending.", type_url_);
+    pending_ = true;
+    return;
+  }
+
+  if (!limit_request_->consume() && limit_log_->consume()) {
+    ENVOY_LOG(warn, "{}", fmt::format("Too many sendDiscoveryRequest calls for {}", type_url_));
+  }
+
+  // Only the changes to the set of watched resources are sent. Watching all the resources is done
+  // by not subscribing to any resource in particular.
+  std::unordered_set<std::string> resource_names;
+  bool all_resources = false;
+  for (const auto* watch : watches_) {
+    all_resources |= watch->resources_.empty();
+    resource_names.insert(watch->resources_.begin(), watch->resources_.end());
+  }
+  if (all_resources) {
+    resource_names.clear();
+  }
+  for (const std::string& resource_name : resource_names) {
+    if (resource_names_.count(resource_name) == 0) {
+      request_.add_resource_names_subscribe(resource_name);
+    }
+  }
+  for (const std::string& resource_name : resource_names_) {
+    if (resource_names.count(resource_name) == 0) {
+      request_.add_resource_names_unsubscribe(resource_name);
+      resource_versions_.erase(resource_name);
+    }
+  }
+  resource_names_ = std::move(resource_names);
+  // Sorted, so that requests don't depend on the iteration order of the name sets.
+  std::sort(request_.mutable_resource_names_subscribe()->begin(),
+            request_.mutable_resource_names_subscribe()->end());
+  std::sort(request_.mutable_resource_names_unsubscribe()->begin(),
+            request_.mutable_resource_names_unsubscribe()->end());
+
+  ENVOY_LOG(trace, "Sending IncrementalDiscoveryRequest for {}: {}", type_url_,
+            request_.DebugString());
+  stream_->sendMessage(request_, false);
+
+  // Only the node and the type URL are carried over to the next request.
+  request_.clear_resource_names_subscribe();
+  request_.clear_resource_names_unsubscribe();
+  request_.clear_initial_resource_versions();
+  request_.clear_response_nonce();
+  request_.clear_error_detail();
+}
+
+void IncrementalGrpcMuxImpl::handleFailure() {
+  for (auto watch : watches_) {
+    watch->callbacks_.onConfigUpdateFailed(nullptr);
+  }
+  setRetryTimer();
+}
+
+GrpcMuxWatchPtr IncrementalGrpcMuxImpl::subscribe(const std::string& type_url,
+                                                  const std::vector<std::string>& resources,
+                                                  GrpcMuxCallbacks& callbacks) {
+  if (type_url_.empty()) {
+    type_url_ = type_url;
+    request_.set_type_url(type_url);
+  } else if (type_url != type_url_) {
+    throw EnvoyException(
+        fmt::format("Incremental xDS stream for {} cannot subscribe to {}", type_url_, type_url));
+  }
+
+  auto watch = std::unique_ptr<GrpcMuxWatch>(new GrpcMuxWatchImpl(resources, callbacks, *this));
+  ENVOY_LOG(debug, "Incremental gRPC mux subscribe for " + type_url);
+  sendDiscoveryRequest();
+  return watch;
+}
+
+void IncrementalGrpcMuxImpl::pause(const std::string& type_url) {
+  // Only the resource type of the stream has discovery requests to pause.
+  if (type_url != type_url_) {
+    return;
+  }
+  ENVOY_LOG(debug, "Pausing discovery requests for {}", type_url);
+  ASSERT(!paused_);
+  ASSERT(!pending_);
+  paused_ = true;
+}
+
+void IncrementalGrpcMuxImpl::resume(const std::string& type_url) {
+  if (type_url != type_url_) {
+    return;
+  }
+  ENVOY_LOG(debug, "Resuming discovery requests for {}", type_url);
+  ASSERT(paused_);
+  paused_ = false;
+
+  if (pending_) {
+    sendDiscoveryRequest();
+    pending_ = false;
+  }
+}
+
+void IncrementalGrpcMuxImpl::onCreateInitialMetadata(Http::HeaderMap& metadata) {
+  UNREFERENCED_PARAMETER(metadata);
+}
+
+void IncrementalGrpcMuxImpl::onReceiveInitialMetadata(Http::HeaderMapPtr&& metadata) {
+  UNREFERENCED_PARAMETER(metadata);
+}
+
+void IncrementalGrpcMuxImpl::onReceiveMessage(
+    std::unique_ptr<envoy::api::v2::IncrementalDiscoveryResponse>&& message) {
+  // Reset here so that it starts with fresh backoff interval on next disconnect.
+  backoff_strategy_->reset();
+
+  ENVOY_LOG(debug, "Received incremental gRPC message for {} at version {}", type_url_,
+            message->system_version_info());
+  request_.set_response_nonce(message->nonce());
+  if (watches_.empty()) {
+    // The management server may send resources we didn't ask for, which are ignored.
+    ENVOY_LOG(debug, "Ignoring unwatched type URL {}", type_url_);
+    sendDiscoveryRequest();
+    return;
+  }
+
+  try {
+    // As in GrpcMuxImpl, we build a map here from resource name to resource and then walk
+    // watches_, so that each watch only gets the changes to the resources it watches.
+    std::unordered_map<std::string, const envoy::api::v2::Resource*> resources;
+    GrpcMuxCallbacks& callbacks = watches_.front()->callbacks_;
+    for (const auto& resource : message->resources()) {
+      if (type_url_ != resource.resource().type_url()) {
+        throw EnvoyException(fmt::format(
+            "{} does not match {} type URL is IncrementalDiscoveryResponse {}",
+            resource.resource().type_url(), type_url_, message->DebugString()));
+      }
+      resources.emplace(callbacks.resourceName(resource.resource()), &resource);
+    }
+    const std::unordered_set<std::string> removed_resources(message->removed_resources().begin(),
+                                                            message->removed_resources().end());
+
+    for (auto watch : watches_) {
+      // Watches of all the resources get all the changes. They are called even when there are no
+      // changes, as onConfigUpdate() would be in the state-of-the-world protocol.
+      if (watch->resources_.empty()) {
+        Protobuf::RepeatedPtrField<ProtobufWkt::Any> added_resources;
+        for (const auto& resource : message->resources()) {
+          added_resources.Add()->MergeFrom(resource.resource());
+        }
+        watch->callbacks_.onIncrementalConfigUpdate(added_resources, message->removed_resources(),
+                                                    message->system_version_info());
+        continue;
+      }
+      Protobuf::RepeatedPtrField<ProtobufWkt::Any> found_resources;
+      Protobuf::RepeatedPtrField<ProtobufTypes::String> found_removed_resources;
+      for (const auto& watched_resource_name : watch->resources_) {
+        auto it = resources.find(watched_resource_name);
+        if (it != resources.end()) {
+          found_resources.Add()->MergeFrom(it->second->resource());
+        }
+        if (removed_resources.count(watched_resource_name) != 0) {
+          *found_removed_resources.Add() = watched_resource_name;
+        }
+      }
+      // onIncrementalConfigUpdate should be called only on watches that have changes in the
+      // message.
+      if (found_resources.size() > 0 || found_removed_resources.size() > 0) {
+        watch->callbacks_.onIncrementalConfigUpdate(found_resources, found_removed_resources,
+                                                    message->system_version_info());
+      }
+    }
+
+    for (const auto& resource : resources) {
+      resource_versions_[resource.first] = resource.second->version();
+    }
+    for (const auto& resource_name : removed_resources) {
+      resource_versions_.erase(resource_name);
+    }
+  } catch (const EnvoyException& e) {
+    ENVOY_LOG(warn, "Incremental gRPC config for {} update rejected: {}", type_url_, e.what());
+    for (auto watch : watches_) {
+      watch->callbacks_.onConfigUpdateFailed(&e);
+    }
+    ::google::rpc::Status* error_detail = request_.mutable_error_detail();
+    error_detail->set_code(Grpc::Status::GrpcStatus::Internal);
+    error_detail->set_message(e.what());
+  }
+  sendDiscoveryRequest();
+}
+
+void IncrementalGrpcMuxImpl::onReceiveTrailingMetadata(Http::HeaderMapPtr&& metadata) {
+  UNREFERENCED_PARAMETER(metadata);
+}
+
+void IncrementalGrpcMuxImpl::onRemoteClose(Grpc::Status::GrpcStatus status,
+                                           const std::string& message) {
+  ENVOY_LOG(warn, "Incremental gRPC config stream closed: {}, {}", status, message);
+  stream_ = nullptr;
+  setRetryTimer();
+}
+
+} // namespace Config
+} // namespace Envoy
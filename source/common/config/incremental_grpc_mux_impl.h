@@ -0,0 +1,118 @@
+#pragma once
+
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "envoy/api/v2/discovery.pb.h"
+#include "envoy/common/time.h"
+#include "envoy/common/token_bucket.h"
+#include "envoy/config/grpc_mux.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/grpc/async_client.h"
+#include "envoy/grpc/status.h"
+#include "envoy/local_info/local_info.h"
+#include "envoy/runtime/runtime.h"
+
+#include "common/common/backoff_strategy.h"
+#include "common/common/logger.h"
+
+namespace Envoy {
+namespace Config {
+
+/**
+ * Incremental xDS API implementation that fetches via gRPC. Requests only carry the changes to the
+ * set of watched resources, and responses only carry the resources that were added, updated or
+ * removed, along with their versions.
+ *
+ * Incremental discovery responses don't carry a type URL, so a stream carries a single resource
+ * type, which is the type of the first subscription. This rules out using it for ADS.
+ */
+class IncrementalGrpcMuxImpl
+    : public GrpcMux,
+      Grpc::TypedAsyncStreamCallbacks<envoy::api::v2::IncrementalDiscoveryResponse>,
+      Logger::Loggable<Logger::Id::upstream> {
+public:
+  IncrementalGrpcMuxImpl(const LocalInfo::LocalInfo& local_info,
+                         Grpc::AsyncClientPtr async_client, Event::Dispatcher& dispatcher,
+                         const Protobuf::MethodDescriptor& service_method,
+                         Runtime::RandomGenerator& random);
+  ~IncrementalGrpcMuxImpl();
+
+  void start() override;
+  GrpcMuxWatchPtr subscribe(const std::string& type_url, const std::vector<std::string>& resources,
+                            GrpcMuxCallbacks& callbacks) override;
+  void pause(const std::string& type_url) override;
+  void resume(const std::string& type_url) override;
+
+  // Grpc::AsyncStreamCallbacks
+  void onCreateInitialMetadata(Http::HeaderMap& metadata) override;
+  void onReceiveInitialMetadata(Http::HeaderMapPtr&& metadata) override;
+  void onReceiveMessage(
+      std::unique_ptr<envoy::api::v2::IncrementalDiscoveryResponse>&& message) override;
+  void onReceiveTrailingMetadata(Http::HeaderMapPtr&& metadata) override;
+  void onRemoteClose(Grpc::Status::GrpcStatus status, const std::string& message) override;
+
+  // TODO(htuch): Make this configurable or some static.
+  const uint32_t RETRY_INITIAL_DELAY_MS = 500;
+  const uint32_t RETRY_MAX_DELAY_MS = 30000; // Do not cross more than 30s
+
+private:
+  void setRetryTimer();
+  void establishNewStream();
+  void sendDiscoveryRequest();
+  void handleFailure();
+
+  struct GrpcMuxWatchImpl : public GrpcMuxWatch {
+    GrpcMuxWatchImpl(const std::vector<std::string>& resources, GrpcMuxCallbacks& callbacks,
+                     IncrementalGrpcMuxImpl& parent)
+        : resources_(resources), callbacks_(callbacks), parent_(parent), inserted_(true) {
+      entry_ = parent.watches_.emplace(parent.watches_.begin(), this);
+    }
+    ~GrpcMuxWatchImpl() override {
+      if (inserted_) {
+        parent_.watches_.erase(entry_);
+        if (!resources_.empty()) {
+          parent_.sendDiscoveryRequest();
+        }
+      }
+    }
+    std::vector<std::string> resources_;
+    GrpcMuxCallbacks& callbacks_;
+    IncrementalGrpcMuxImpl& parent_;
+    std::list<GrpcMuxWatchImpl*>::iterator entry_;
+    bool inserted_;
+  };
+
+  const LocalInfo::LocalInfo& local_info_;
+  Grpc::AsyncClientPtr async_client_;
+  Grpc::AsyncStream* stream_{};
+  const Protobuf::MethodDescriptor& service_method_;
+  // Type URL of the resources of the stream, set by the first subscription.
+  std::string type_url_;
+  // Watches on the returned resources.
+  std::list<GrpcMuxWatchImpl*> watches_;
+  // Next IncrementalDiscoveryRequest. The subscription changes, the ACK/NACK and the initial
+  // resource versions are cleared once it is sent.
+  envoy::api::v2::IncrementalDiscoveryRequest request_;
+  // Names of the resources the management server was asked for on the current stream.
+  std::unordered_set<std::string> resource_names_;
+  // Versions of the accepted resources, by name, which are sent as the initial resource versions of
+  // a new stream so that only the resources that changed in the meantime are sent back.
+  std::unordered_map<std::string, std::string> resource_versions_;
+  // Paused via pause()?
+  bool paused_{};
+  // Was a IncrementalDiscoveryRequest elided during a pause?
+  bool pending_{};
+  // Detects when Envoy is making too many requests.
+  TokenBucketPtr limit_request_;
+  // Limits warning messages when too many requests is detected.
+  TokenBucketPtr limit_log_;
+  Event::TimerPtr retry_timer_;
+  Runtime::RandomGenerator& random_;
+  TimeSource& time_source_;
+  BackOffStrategyPtr backoff_strategy_;
+};
+
+} // namespace Config
+} // namespace Envoy
@@ -34,13 +34,16 @@ public:
    *        description).
    * @param grpc_method fully qualified name of v2 gRPC API bidi streaming method (as per protobuf
    *        service description).
+   * @param incremental_grpc_method fully qualified name of v2 incremental gRPC API bidi streaming
+   *        method (as per protobuf service description), or empty if the API has none.
    */
   template <class ResourceType>
   static std::unique_ptr<Subscription<ResourceType>> subscriptionFromConfigSource(
       const envoy::api::v2::core::ConfigSource& config, const LocalInfo::LocalInfo& local_info,
       Event::Dispatcher& dispatcher, Upstream::ClusterManager& cm, Runtime::RandomGenerator& random,
       Stats::Scope& scope, std::function<Subscription<ResourceType>*()> rest_legacy_constructor,
-      const std::string& rest_method, const std::string& grpc_method) {
+      const std::string& rest_method, const std::string& grpc_method,
+      const std::string& incremental_grpc_method) {
     std::unique_ptr<Subscription<ResourceType>> result;
     SubscriptionStats stats = Utility::generateStats(scope);
     switch (config.config_source_specifier_case()) {
@@ -74,6 +77,21 @@ public:
             *Protobuf::DescriptorPool::generated_pool()->FindMethodByName(grpc_method), stats));
         break;
       }
+      case envoy::api::v2::core::ApiConfigSource::INCREMENTAL_GRPC: {
+        if (incremental_grpc_method.empty()) {
+          throw EnvoyException(fmt::format("{} does not support incremental xDS",
+                                           ResourceType().GetDescriptor()->full_name()));
+        }
+        result.reset(new GrpcSubscriptionImpl<ResourceType, IncrementalGrpcMuxImpl>(
+            local_info,
+            Config::Utility::factoryForGrpcApiConfigSource(cm.grpcAsyncClientManager(),
+                                                           config.api_config_source(), scope)
+                ->create(),
+            dispatcher, random,
+            *Protobuf::DescriptorPool::generated_pool()->FindMethodByName(incremental_grpc_method),
+            stats));
+        break;
+      }
       default:
         NOT_REACHED_GCOVR_EXCL_LINE;
       }
@@ -88,7 +88,8 @@ void Utility::checkFilesystemSubscriptionBackingPath(const std::string& path) {
 void Utility::checkApiConfigSourceNames(
     const envoy::api::v2::core::ApiConfigSource& api_config_source) {
   const bool is_grpc =
-      (api_config_source.api_type() == envoy::api::v2::core::ApiConfigSource::GRPC);
+      (api_config_source.api_type() == envoy::api::v2::core::ApiConfigSource::GRPC ||
+       api_config_source.api_type() == envoy::api::v2::core::ApiConfigSource::INCREMENTAL_GRPC);
 
   if (api_config_source.cluster_names().empty() && api_config_source.grpc_services().empty()) {
     throw EnvoyException(
@@ -140,7 +141,8 @@ void Utility::checkApiConfigSourceSubscriptionBackingCluster(
   Utility::checkApiConfigSourceNames(api_config_source);
 
   const bool is_grpc =
-      (api_config_source.api_type() == envoy::api::v2::core::ApiConfigSource::GRPC);
+      (api_config_source.api_type() == envoy::api::v2::core::ApiConfigSource::GRPC ||
+       api_config_source.api_type() == envoy::api::v2::core::ApiConfigSource::INCREMENTAL_GRPC);
 
   if (!api_config_source.cluster_names().empty()) {
     // All API configs of type REST and REST_LEGACY should have cluster names.
@@ -235,9 +237,11 @@ Grpc::AsyncClientFactoryPtr Utility::factoryForGrpcApiConfigSource(
     const envoy::api::v2::core::ApiConfigSource& api_config_source, Stats::Scope& scope) {
   Utility::checkApiConfigSourceNames(api_config_source);
 
-  if (api_config_source.api_type() != envoy::api::v2::core::ApiConfigSource::GRPC) {
-    throw EnvoyException(fmt::format("envoy::api::v2::core::ConfigSource type must be GRPC: {}",
-                                     api_config_source.DebugString()));
+  if (api_config_source.api_type() != envoy::api::v2::core::ApiConfigSource::GRPC &&
+      api_config_source.api_type() != envoy::api::v2::core::ApiConfigSource::INCREMENTAL_GRPC) {
+    throw EnvoyException(
+        fmt::format("envoy::api::v2::core::ConfigSource type must be GRPC or INCREMENTAL_GRPC: {}",
+                    api_config_source.DebugString()));
   }
 
   envoy::api::v2::core::GrpcService grpc_service;
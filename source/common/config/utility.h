@@ -17,6 +17,7 @@
 #include "common/common/assert.h"
 #include "common/common/hash.h"
 #include "common/common/hex.h"
+#include "common/common/thread.h"
 #include "common/grpc/common.h"
 #include "common/protobuf/protobuf.h"
 #include "common/protobuf/utility.h"
@@ -50,14 +51,33 @@ public:
   template <class ResourceType>
   static Protobuf::RepeatedPtrField<ResourceType>
   getTypedResources(const envoy::api::v2::DiscoveryResponse& response) {
+    return unpackResources<ResourceType>(response.resources());
+  }
+
+  /**
+   * Unpack typed resources. Large batches are unpacked in parallel, and the typed resources keep
+   * the order of the given resources.
+   * @param resources supplies the resources to unpack.
+   * @return Protobuf::RepatedPtrField<ResourceType> vector of typed resources.
+   * @throw EnvoyException if a resource is not a ResourceType or has unknown fields. If several
+   *        resources are invalid, the error is the one of the first.
+   */
+  template <class ResourceType>
+  static Protobuf::RepeatedPtrField<ResourceType>
+  unpackResources(const Protobuf::RepeatedPtrField<ProtobufWkt::Any>& resources) {
     Protobuf::RepeatedPtrField<ResourceType> typed_resources;
-    for (const auto& resource : response.resources()) {
-      auto* typed_resource = typed_resources.Add();
+    typed_resources.Reserve(resources.size());
+    for (int i = 0; i < resources.size(); ++i) {
+      typed_resources.Add();
+    }
+    Thread::parallelFor(resources.size(), ResourcesPerUnpackThread, [&](size_t i) {
+      const ProtobufWkt::Any& resource = resources.Get(i);
+      ResourceType* typed_resource = typed_resources.Mutable(i);
       if (!resource.UnpackTo(typed_resource)) {
         throw EnvoyException("Unable to unpack " + resource.DebugString());
       }
       MessageUtil::checkUnknownFields(*typed_resource);
-    }
+    });
     return typed_resources;
   }
 
@@ -331,6 +351,11 @@ public:
    */
   static envoy::api::v2::ClusterLoadAssignment
   translateClusterHosts(const Protobuf::RepeatedPtrField<envoy::api::v2::core::Address>& hosts);
+
+private:
+  // Unpacking a resource is cheap compared to starting a thread, so only batches of this many
+  // resources per thread are unpacked in parallel.
+  static constexpr size_t ResourcesPerUnpackThread = 64;
 };
 
 } // namespace Config
@@ -86,17 +86,19 @@ public:
   TagNameValues();
 
   /**
-   * Represents a tag extraction. This structure may be extended to
-   * allow for an faster pattern-matching engine to be used as an
-   * alternative to regexes, on an individual tag basis. Some of the
-   * tags, such as "_rq_(\\d)xx$", will probably stay as regexes.
+   * Represents a tag extraction. Tags that are a single token in a fixed position also have an
+   * equivalent token pattern (see Stats::TagExtractorTokensImpl), which is used in place of the
+   * regex as it is much faster to match. Some of the tags, such as "_rq_(\\d)xx$", will probably
+   * stay as regexes.
    */
   struct Descriptor {
-    Descriptor(const std::string& name, const std::string& regex, const std::string& substr = "")
-        : name_(name), regex_(regex), substr_(substr) {}
+    Descriptor(const std::string& name, const std::string& regex, const std::string& substr = "",
+               const std::string& tokens = "")
+        : name_(name), regex_(regex), substr_(substr), tokens_(tokens) {}
     const std::string name_;
     const std::string regex_;
     const std::string substr_;
+    const std::string tokens_;
   };
 
   // Cluster name tag
@@ -154,6 +156,7 @@ public:
 
 private:
   void addRegex(const std::string& name, const std::string& regex, const std::string& substr = "");
+  void addTokenized(const std::string& name, const std::string& regex, const std::string& tokens);
 
   // Collection of tag descriptors.
   std::vector<Descriptor> descriptor_vec_;
@@ -29,6 +29,15 @@ void ZlibDecompressorImpl::init(int64_t window_bits) {
   initialized_ = true;
 }
 
+void ZlibDecompressorImpl::reset() {
+  ASSERT(initialized_);
+  const int result = inflateReset(zstream_ptr_.get());
+  RELEASE_ASSERT(result == Z_OK, "");
+  decompression_error_ = false;
+  zstream_ptr_->avail_out = chunk_size_;
+  zstream_ptr_->next_out = chunk_char_ptr_.get();
+}
+
 uint64_t ZlibDecompressorImpl::checksum() { return zstream_ptr_->adler; }
 
 void ZlibDecompressorImpl::decompress(const Buffer::Instance& input_buffer,
@@ -38,23 +47,30 @@ void ZlibDecompressorImpl::decompress(const Buffer::Instance& input_buffer,
   input_buffer.getRawSlices(slices, num_slices);
 
   for (const Buffer::RawSlice& input_slice : slices) {
+    if (decompression_error_) {
+      return;
+    }
     zstream_ptr_->avail_in = input_slice.len_;
     zstream_ptr_->next_in = static_cast<Bytef*>(input_slice.mem_);
     while (inflateNext()) {
       if (zstream_ptr_->avail_out == 0) {
-        output_buffer.add(static_cast<void*>(chunk_char_ptr_.get()),
-                          chunk_size_ - zstream_ptr_->avail_out);
-        chunk_char_ptr_.reset(new unsigned char[chunk_size_]);
-        zstream_ptr_->avail_out = chunk_size_;
-        zstream_ptr_->next_out = chunk_char_ptr_.get();
+        updateOutput(output_buffer);
       }
     }
   }
 
+  updateOutput(output_buffer);
+}
+
+void ZlibDecompressorImpl::updateOutput(Buffer::Instance& output_buffer) {
   const uint64_t n_output{chunk_size_ - zstream_ptr_->avail_out};
   if (n_output > 0) {
+    // The output is copied into the buffer, so the chunk is reused for the next output, including
+    // by the next call to decompress.
     output_buffer.add(static_cast<void*>(chunk_char_ptr_.get()), n_output);
   }
+  zstream_ptr_->avail_out = chunk_size_;
+  zstream_ptr_->next_out = chunk_char_ptr_.get();
 }
 
 bool ZlibDecompressorImpl::inflateNext() {
@@ -70,6 +86,12 @@ bool ZlibDecompressorImpl::inflateNext() {
     return false; // This means that zlib needs more input, so stop here.
   }
 
+  if (result == Z_DATA_ERROR || result == Z_NEED_DICT) {
+    // The input, which may come from the network, is not valid compressed data.
+    decompression_error_ = true;
+    return false;
+  }
+
   RELEASE_ASSERT(result == Z_OK, "");
   return true;
 }
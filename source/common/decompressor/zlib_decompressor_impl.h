@@ -32,6 +32,18 @@ public:
    */
   void init(int64_t window_bits);
 
+  /**
+   * Resets an initialized decompressor so that it can decompress a new stream, keeping the memory
+   * allocated by init rather than freeing and allocating it again.
+   */
+  void reset();
+
+  /**
+   * @return bool whether the data decompressed so far was not valid compressed data, in which
+   * case the decompressor doesn't output anything more until it is reset.
+   */
+  bool decompressionError() const { return decompression_error_; }
+
   /**
    * It returns the checksum of all output produced so far. Decompressor's checksum at the end of
    * the stream has to match compressor's checksum produced at the end of the compression.
@@ -45,13 +57,17 @@ public:
 
 private:
   bool inflateNext();
+  void updateOutput(Buffer::Instance& output_buffer);
 
   const uint64_t chunk_size_;
   bool initialized_;
+  bool decompression_error_{};
 
   std::unique_ptr<unsigned char[]> chunk_char_ptr_;
   std::unique_ptr<z_stream, std::function<void(z_stream*)>> zstream_ptr_;
 };
 
+typedef std::unique_ptr<ZlibDecompressorImpl> ZlibDecompressorImplPtr;
+
 } // namespace Decompressor
 } // namespace Envoy
@@ -3,6 +3,7 @@
 #include <chrono>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -10,19 +11,29 @@
 #include "envoy/network/listener.h"
 
 #include "common/buffer/buffer_impl.h"
-#include "common/common/lock_guard.h"
 #include "common/event/file_event_impl.h"
 #include "common/event/signal_impl.h"
 #include "common/filesystem/watcher_impl.h"
 #include "common/network/connection_impl.h"
 #include "common/network/dns_impl.h"
 #include "common/network/listener_impl.h"
+#include "common/network/udp_listener_impl.h"
 
 #include "event2/event.h"
 
 namespace Envoy {
 namespace Event {
 
+namespace {
+// Each listener has at most one accept or poll in flight. The ring is submitted early when the
+// submission queue fills up, so this only bounds how much work is batched per submission.
+constexpr uint32_t IoUringEntries = 256;
+
+uint64_t toMicroseconds(MonotonicTime::duration duration) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+} // namespace
+
 DispatcherImpl::DispatcherImpl(TimeSystem& time_system)
     : DispatcherImpl(time_system, Buffer::WatermarkFactoryPtr{new Buffer::WatermarkBufferFactory}) {
   // The dispatcher won't work as expected if libevent hasn't been configured to use threads.
@@ -32,13 +43,56 @@ DispatcherImpl::DispatcherImpl(TimeSystem& time_system)
 DispatcherImpl::DispatcherImpl(TimeSystem& time_system, Buffer::WatermarkFactoryPtr&& factory)
     : time_system_(time_system), buffer_factory_(std::move(factory)), base_(event_base_new()),
       scheduler_(time_system_.createScheduler(base_)),
-      deferred_delete_timer_(createTimer([this]() -> void { clearDeferredDeleteList(); })),
-      post_timer_(createTimer([this]() -> void { runPostCallbacks(); })),
+      deferred_delete_timer_(scheduler_->createTimer([this]() -> void {
+        runTracked(CallbackSource::DeferredDelete, [this]() -> void { clearDeferredDeleteList(); });
+      })),
+      post_timer_(scheduler_->createTimer([this]() -> void {
+        runTracked(CallbackSource::PostCallback, [this]() -> void { runPostCallbacks(); });
+      })),
       current_to_delete_(&to_delete_1_) {
   RELEASE_ASSERT(Libevent::Global::initialized(), "");
 }
 
-DispatcherImpl::~DispatcherImpl() {}
+DispatcherImpl::~DispatcherImpl() {
+  // Callbacks that never ran are destroyed without being invoked, as before.
+  while (PostCallback* callback = post_callbacks_.pop()) {
+    delete callback;
+  }
+}
+
+bool DispatcherImpl::enableIoUring() { return enableIoUring(IoUringImpl::create(IoUringEntries)); }
+
+bool DispatcherImpl::enableIoUring(IoUringImplPtr&& io_uring) {
+  ASSERT(io_uring_ == nullptr);
+  if (io_uring == nullptr) {
+    ENVOY_LOG(warn, "io_uring is not available, using readiness events for all socket I/O");
+    return false;
+  }
+
+  io_uring_ = std::move(io_uring);
+  // Rings without an eventfd are serviced by whoever completes their operations.
+  if (io_uring_->eventFd() >= 0) {
+    io_uring_event_ =
+        createFileEvent(io_uring_->eventFd(), [this](uint32_t) { io_uring_->processCompletions(); },
+                        FileTriggerType::Level, FileReadyType::Read);
+  }
+  return true;
+}
+
+void DispatcherImpl::enableTimerWheel(std::chrono::milliseconds resolution) {
+  ASSERT(timer_wheel_ == nullptr);
+  timer_wheel_ = std::make_unique<TimerWheelImpl>(*scheduler_, time_system_, resolution);
+}
+
+void DispatcherImpl::initializeStats(Stats::Scope& scope, const std::string& prefix,
+                                     std::chrono::milliseconds stall_threshold) {
+  ASSERT(loop_stats_ == nullptr);
+  const std::string final_prefix = prefix + "dispatcher.";
+  loop_stats_ = std::make_unique<LoopStats>(
+      DispatcherStats{ALL_DISPATCHER_STATS(POOL_COUNTER_PREFIX(scope, final_prefix),
+                                           POOL_HISTOGRAM_PREFIX(scope, final_prefix))},
+      stall_threshold);
+}
 
 void DispatcherImpl::clearDeferredDeleteList() {
   ASSERT(isThreadSafe());
@@ -50,6 +104,9 @@ void DispatcherImpl::clearDeferredDeleteList() {
   }
 
   ENVOY_LOG(trace, "clearing deferred deletion list (size={})", num_to_delete);
+  if (loop_stats_ != nullptr) {
+    loop_stats_->stats_.deferred_delete_queue_depth_.recordValue(num_to_delete);
+  }
 
   // Swap the current deletion vector so that if we do deferred delete while we are deleting, we
   // use the other vector. We will get another callback to delete that vector.
@@ -99,6 +156,11 @@ Network::DnsResolverSharedPtr DispatcherImpl::createDnsResolver(
 FileEventPtr DispatcherImpl::createFileEvent(int fd, FileReadyCb cb, FileTriggerType trigger,
                                              uint32_t events) {
   ASSERT(isThreadSafe());
+  if (loop_stats_ != nullptr) {
+    cb = [this, cb](uint32_t ready_events) -> void {
+      runTracked(CallbackSource::FileEvent, [&cb, ready_events]() -> void { cb(ready_events); });
+    };
+  }
   return FileEventPtr{new FileEventImpl(*this, fd, cb, trigger, events)};
 }
 
@@ -109,14 +171,28 @@ Filesystem::WatcherPtr DispatcherImpl::createFilesystemWatcher() {
 
 Network::ListenerPtr
 DispatcherImpl::createListener(Network::Socket& socket, Network::ListenerCallbacks& cb,
-                               bool bind_to_port, bool hand_off_restored_destination_connections) {
+                               bool bind_to_port, bool hand_off_restored_destination_connections,
+                               uint32_t max_accepts_per_wakeup) {
   ASSERT(isThreadSafe());
   return Network::ListenerPtr{new Network::ListenerImpl(*this, socket, cb, bind_to_port,
-                                                        hand_off_restored_destination_connections)};
+                                                        hand_off_restored_destination_connections,
+                                                        max_accepts_per_wakeup)};
+}
+
+Network::UdpListenerPtr DispatcherImpl::createUdpListener(Network::Socket& socket,
+                                                          Network::UdpListenerCallbacks& cb) {
+  ASSERT(isThreadSafe());
+  return std::make_unique<Network::UdpListenerImpl>(*this, socket, cb);
 }
 
-TimerPtr DispatcherImpl::createTimer(TimerCb cb) {
+TimerPtr DispatcherImpl::createTimer(TimerCb cb, TimerPrecision precision) {
   ASSERT(isThreadSafe());
+  if (loop_stats_ != nullptr) {
+    cb = [this, cb]() -> void { runTracked(CallbackSource::Timer, cb); };
+  }
+  if (precision == TimerPrecision::Coarse && timer_wheel_ != nullptr) {
+    return timer_wheel_->createTimer(cb);
+  }
   return scheduler_->createTimer(cb);
 }
 
@@ -137,14 +213,32 @@ SignalEventPtr DispatcherImpl::listenForSignal(int signal_num, SignalCb cb) {
 }
 
 void DispatcherImpl::post(std::function<void()> callback) {
-  bool do_post;
-  {
-    Thread::LockGuard lock(post_lock_);
-    do_post = post_callbacks_.empty();
-    post_callbacks_.push_back(callback);
+  post_callbacks_.push(new PostCallback(std::move(callback)));
+  schedulePostCallbacks();
+}
+
+void DispatcherImpl::postBatch(std::vector<PostCb>&& callbacks) {
+  if (callbacks.empty()) {
+    return;
+  }
+
+  PostCallback* first = new PostCallback(std::move(callbacks[0]));
+  PostCallback* last = first;
+  for (size_t i = 1; i < callbacks.size(); i++) {
+    PostCallback* next = new PostCallback(std::move(callbacks[i]));
+    MpscQueue<PostCallback>::link(last, next);
+    last = next;
   }
+  callbacks.clear();
+
+  post_callbacks_.pushChain(first, last);
+  schedulePostCallbacks();
+}
 
-  if (do_post) {
+void DispatcherImpl::schedulePostCallbacks() {
+  // The flag must be set after the push: runPostCallbacks() clears it before draining, so either
+  // the drain sees our callbacks or we see the cleared flag and wake the dispatcher again.
+  if (!post_scheduled_.exchange(true)) {
     post_timer_->enableTimer(std::chrono::milliseconds(0));
   }
 }
@@ -158,27 +252,91 @@ void DispatcherImpl::run(RunType type) {
   // event_base_once() before some other event, the other event might get called first.
   runPostCallbacks();
 
+  if (loop_stats_ != nullptr) {
+    runLoopWithStats(type);
+    return;
+  }
   event_base_loop(base_.get(), type == RunType::NonBlock ? EVLOOP_NONBLOCK : 0);
 }
 
+void DispatcherImpl::runLoopWithStats(RunType type) {
+  if (type == RunType::NonBlock) {
+    event_base_loop(base_.get(), EVLOOP_NONBLOCK);
+    onLoopIterationDone();
+    return;
+  }
+
+  // Hand control back after each iteration so that it can be accounted for. This stops in the
+  // same cases as a single blocking event_base_loop() call: on exit() or once no events are left.
+  while (true) {
+    const int rc = event_base_loop(base_.get(), EVLOOP_ONCE);
+    onLoopIterationDone();
+    if (rc != 0 || event_base_got_exit(base_.get()) || event_base_got_break(base_.get())) {
+      return;
+    }
+  }
+}
+
+void DispatcherImpl::onCallbackDone(CallbackSource source, MonotonicTime::duration duration) {
+  const size_t index = static_cast<size_t>(source);
+  loop_stats_->source_time_[index] += duration;
+  loop_stats_->source_ran_[index] = true;
+  if (duration > loop_stats_->slowest_time_) {
+    loop_stats_->slowest_time_ = duration;
+    loop_stats_->slowest_source_ = source;
+  }
+}
+
+void DispatcherImpl::onLoopIterationDone() {
+  LoopStats& loop_stats = *loop_stats_;
+  if (!loop_stats.iteration_start_) {
+    // Woke up without running anything, e.g. for an event that was deleted in the meantime.
+    return;
+  }
+
+  const MonotonicTime::duration duration =
+      time_system_.monotonicTime() - loop_stats.iteration_start_.value();
+  loop_stats.stats_.loop_duration_us_.recordValue(toMicroseconds(duration));
+  Stats::Histogram* const source_histograms[NumCallbackSources] = {
+      &loop_stats.stats_.post_callbacks_us_, &loop_stats.stats_.file_events_us_,
+      &loop_stats.stats_.timers_us_, &loop_stats.stats_.deferred_delete_us_};
+  for (size_t i = 0; i < NumCallbackSources; i++) {
+    if (loop_stats.source_ran_[i]) {
+      source_histograms[i]->recordValue(toMicroseconds(loop_stats.source_time_[i]));
+    }
+  }
+
+  if (loop_stats.stall_threshold_.count() > 0 && duration >= loop_stats.stall_threshold_) {
+    static const char* const source_names[NumCallbackSources] = {"post callback", "file event",
+                                                                 "timer", "deferred delete"};
+    loop_stats.stats_.loop_stalls_.inc();
+    ENVOY_LOG(warn,
+              "event loop stall: iteration took {}us, slowest callback was a {} taking {}us "
+              "(post callbacks {}us, file events {}us, timers {}us, deferred deletes {}us)",
+              toMicroseconds(duration),
+              source_names[static_cast<size_t>(loop_stats.slowest_source_)],
+              toMicroseconds(loop_stats.slowest_time_), toMicroseconds(loop_stats.source_time_[0]),
+              toMicroseconds(loop_stats.source_time_[1]),
+              toMicroseconds(loop_stats.source_time_[2]),
+              toMicroseconds(loop_stats.source_time_[3]));
+  }
+
+  loop_stats.iteration_start_.reset();
+  loop_stats.source_time_.fill(MonotonicTime::duration(0));
+  loop_stats.source_ran_.fill(false);
+  loop_stats.slowest_time_ = MonotonicTime::duration(0);
+}
+
 void DispatcherImpl::runPostCallbacks() {
+  post_scheduled_.store(false);
   while (true) {
-    // It is important that this declaration is inside the body of the loop so that the callback is
-    // destructed while post_lock_ is not held. If callback is declared outside the loop and reused
-    // for each iteration, the previous iteration's callback is destructed when callback is
-    // re-assigned, which happens while holding the lock. This can lead to a deadlock (via
-    // recursive mutex acquisition) if destroying the callback runs a destructor, which through some
-    // callstack calls post() on this dispatcher.
-    std::function<void()> callback;
-    {
-      Thread::LockGuard lock(post_lock_);
-      if (post_callbacks_.empty()) {
-        return;
-      }
-      callback = post_callbacks_.front();
-      post_callbacks_.pop_front();
+    // The callback is destroyed before the next one runs. No lock is held here, so a destructor
+    // that posts to this dispatcher is fine.
+    std::unique_ptr<PostCallback> callback(post_callbacks_.pop());
+    if (callback == nullptr) {
+      return;
     }
-    callback();
+    callback->cb_();
   }
 }
 
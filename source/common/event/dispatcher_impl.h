@@ -1,8 +1,10 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <functional>
-#include <list>
 #include <vector>
 
 #include "envoy/common/time.h"
@@ -11,8 +13,13 @@
 #include "envoy/network/connection_handler.h"
 
 #include "common/common/logger.h"
+#include "common/common/mpsc_queue.h"
 #include "common/common/thread.h"
+#include "common/event/io_uring_impl.h"
 #include "common/event/libevent.h"
+#include "common/event/timer_wheel_impl.h"
+
+#include "absl/types/optional.h"
 
 namespace Envoy {
 namespace Event {
@@ -31,8 +38,38 @@ public:
    */
   event_base& base() { return *base_; }
 
+  /**
+   * Service socket accepts of listeners created by this dispatcher through an io_uring. This is
+   * experimental and only available on Linux.
+   * @return bool whether the ring was set up. The dispatcher keeps using readiness events for
+   *         everything when it returns false.
+   */
+  bool enableIoUring();
+
+  /**
+   * Service socket accepts through the given ring, e.g. one which tests complete operations of.
+   * @param io_uring supplies the ring, or nullptr if none could be created.
+   * @return bool whether the dispatcher uses the ring.
+   */
+  bool enableIoUring(IoUringImplPtr&& io_uring);
+
+  /**
+   * @return IoUringImpl* the dispatcher's ring, or nullptr if enableIoUring() has not succeeded.
+   */
+  IoUringImpl* ioUring() { return io_uring_.get(); }
+
+  /**
+   * Serve timers created with TimerPrecision::Coarse from a timer wheel instead of the libevent
+   * timer heap.
+   * @param resolution supplies the tick length of the wheel. Coarse timers fire up to this much
+   *        later than requested.
+   */
+  void enableTimerWheel(std::chrono::milliseconds resolution);
+
   // Event::Dispatcher
   TimeSystem& timeSystem() override { return time_system_; }
+  void initializeStats(Stats::Scope& scope, const std::string& prefix,
+                       std::chrono::milliseconds stall_threshold) override;
   void clearDeferredDeleteList() override;
   Network::ConnectionPtr
   createServerConnection(Network::ConnectionSocketPtr&& socket,
@@ -47,18 +84,69 @@ public:
   FileEventPtr createFileEvent(int fd, FileReadyCb cb, FileTriggerType trigger,
                                uint32_t events) override;
   Filesystem::WatcherPtr createFilesystemWatcher() override;
-  Network::ListenerPtr createListener(Network::Socket& socket, Network::ListenerCallbacks& cb,
-                                      bool bind_to_port,
-                                      bool hand_off_restored_destination_connections) override;
-  TimerPtr createTimer(TimerCb cb) override;
+  Network::ListenerPtr
+  createListener(Network::Socket& socket, Network::ListenerCallbacks& cb, bool bind_to_port,
+                 bool hand_off_restored_destination_connections,
+                 uint32_t max_accepts_per_wakeup = std::numeric_limits<uint32_t>::max()) override;
+  Network::UdpListenerPtr createUdpListener(Network::Socket& socket,
+                                            Network::UdpListenerCallbacks& cb) override;
+  TimerPtr createTimer(TimerCb cb, TimerPrecision precision = TimerPrecision::Precise) override;
   void deferredDelete(DeferredDeletablePtr&& to_delete) override;
   void exit() override;
   SignalEventPtr listenForSignal(int signal_num, SignalCb cb) override;
   void post(std::function<void()> callback) override;
+  void postBatch(std::vector<PostCb>&& callbacks) override;
   void run(RunType type) override;
   Buffer::WatermarkFactory& getWatermarkFactory() override { return *buffer_factory_; }
 
 private:
+  struct PostCallback : public MpscQueueNode {
+    explicit PostCallback(PostCb&& cb) : cb_(std::move(cb)) {}
+
+    PostCb cb_;
+  };
+
+  // What a callback run by the event loop was registered as.
+  enum class CallbackSource { PostCallback, FileEvent, Timer, DeferredDelete };
+  static constexpr size_t NumCallbackSources = 4;
+
+  // Time spent in callbacks during the current iteration of the event loop.
+  struct LoopStats {
+    LoopStats(const DispatcherStats& stats, std::chrono::milliseconds stall_threshold)
+        : stats_(stats), stall_threshold_(stall_threshold) {}
+
+    DispatcherStats stats_;
+    const std::chrono::milliseconds stall_threshold_;
+    // Set when the first callback of the iteration runs, i.e. once the loop has woken up.
+    absl::optional<MonotonicTime> iteration_start_;
+    std::array<MonotonicTime::duration, NumCallbackSources> source_time_{};
+    std::array<bool, NumCallbackSources> source_ran_{};
+    MonotonicTime::duration slowest_time_{};
+    CallbackSource slowest_source_{};
+  };
+
+  /**
+   * Run a callback, accounting the time it takes to the current loop iteration when stats are
+   * enabled. The callback may destroy the object that owns it, so nothing belonging to that
+   * object is touched once it returns.
+   */
+  template <class Callback> void runTracked(CallbackSource source, const Callback& callback) {
+    if (loop_stats_ == nullptr) {
+      callback();
+      return;
+    }
+    const MonotonicTime start = time_system_.monotonicTime();
+    if (!loop_stats_->iteration_start_) {
+      loop_stats_->iteration_start_ = start;
+    }
+    callback();
+    onCallbackDone(source, time_system_.monotonicTime() - start);
+  }
+
+  void onCallbackDone(CallbackSource source, MonotonicTime::duration duration);
+  void onLoopIterationDone();
+  void runLoopWithStats(RunType type);
+  void schedulePostCallbacks();
   void runPostCallbacks();
 
   // Validate that an operation is thread safe, i.e. it's invoked on the same thread that the
@@ -72,15 +160,21 @@ private:
   Thread::ThreadId run_tid_{};
   Buffer::WatermarkFactoryPtr buffer_factory_;
   Libevent::BasePtr base_;
+  IoUringImplPtr io_uring_;
+  FileEventPtr io_uring_event_;
   SchedulerPtr scheduler_;
+  TimerWheelImplPtr timer_wheel_;
   TimerPtr deferred_delete_timer_;
   TimerPtr post_timer_;
   std::vector<DeferredDeletablePtr> to_delete_1_;
   std::vector<DeferredDeletablePtr> to_delete_2_;
   std::vector<DeferredDeletablePtr>* current_to_delete_;
-  Thread::MutexBasicLockable post_lock_;
-  std::list<std::function<void()>> post_callbacks_ GUARDED_BY(post_lock_);
+  MpscQueue<PostCallback> post_callbacks_;
+  // Set by the first post() after the consumer last started draining post_callbacks_, so that
+  // concurrent posters arm post_timer_ only once per drain.
+  std::atomic<bool> post_scheduled_{false};
   bool deferred_deleting_{};
+  std::unique_ptr<LoopStats> loop_stats_;
 };
 
 } // namespace Event
@@ -0,0 +1,307 @@
+#include "common/event/io_uring_impl.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "common/common/assert.h"
+#include "common/common/fmt.h"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+// Probing, accept and cancellation all need the 5.6 uapi header.
+#if defined(IO_URING_OP_SUPPORTED) && defined(__NR_io_uring_setup)
+#define ENVOY_IO_URING_SUPPORTED 1
+#endif
+
+namespace Envoy {
+namespace Event {
+
+#ifdef ENVOY_IO_URING_SUPPORTED
+
+namespace {
+
+int ioUringSetup(uint32_t entries, io_uring_params& params) {
+  return syscall(__NR_io_uring_setup, entries, &params);
+}
+
+int ioUringEnter(int fd, uint32_t to_submit) {
+  return syscall(__NR_io_uring_enter, fd, to_submit, 0, 0, nullptr, 0);
+}
+
+int ioUringRegister(int fd, unsigned opcode, void* arg, unsigned nr_args) {
+  return syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+// Operations the ring is used for. The kernel must support all of them.
+constexpr uint8_t RequiredOps[] = {IORING_OP_ACCEPT, IORING_OP_POLL_ADD, IORING_OP_ASYNC_CANCEL};
+
+} // namespace
+
+IoUringImplPtr IoUringImpl::create(uint32_t entries) {
+  IoUringImplPtr ring(new IoUringImpl());
+  if (!ring->initialize(entries)) {
+    return nullptr;
+  }
+  return ring;
+}
+
+bool IoUringImpl::initialize(uint32_t entries) {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  ring_fd_ = ioUringSetup(entries, params);
+  if (ring_fd_ < 0) {
+    ENVOY_LOG(warn, "io_uring: setup failed: {}", strerror(errno));
+    return false;
+  }
+
+  std::vector<uint8_t> probe_storage(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op));
+  io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(probe_storage.data());
+  if (ioUringRegister(ring_fd_, IORING_REGISTER_PROBE, probe, 256) < 0) {
+    ENVOY_LOG(warn, "io_uring: kernel does not support operation probing");
+    return false;
+  }
+  for (const uint8_t op : RequiredOps) {
+    if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+      ENVOY_LOG(warn, "io_uring: kernel does not support operation {}", op);
+      return false;
+    }
+  }
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+  sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                  ring_fd_, IORING_OFF_SQ_RING);
+  if (sq_ring_ == MAP_FAILED) {
+    sq_ring_ = nullptr;
+    return false;
+  }
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    cq_ring_ = sq_ring_;
+  } else {
+    cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    ring_fd_, IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+      cq_ring_ = nullptr;
+      return false;
+    }
+  }
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+               IORING_OFF_SQES);
+  if (sqes_ == MAP_FAILED) {
+    sqes_ = nullptr;
+    return false;
+  }
+
+  uint8_t* sq = static_cast<uint8_t*>(sq_ring_);
+  sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+  sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+  sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+  sq_entries_ = params.sq_entries;
+  uint8_t* cq = static_cast<uint8_t*>(cq_ring_);
+  cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+  cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+  cqes_ = cq + params.cq_off.cqes;
+
+  event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (event_fd_ < 0 || ioUringRegister(ring_fd_, IORING_REGISTER_EVENTFD, &event_fd_, 1) < 0) {
+    ENVOY_LOG(warn, "io_uring: unable to register completion eventfd: {}", strerror(errno));
+    return false;
+  }
+
+  return true;
+}
+
+IoUringImpl::~IoUringImpl() {
+  // Closing the ring cancels everything still in flight.
+  if (sqes_ != nullptr) {
+    munmap(sqes_, sqes_size_);
+  }
+  if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  if (sq_ring_ != nullptr) {
+    munmap(sq_ring_, sq_ring_size_);
+  }
+  if (event_fd_ >= 0) {
+    ::close(event_fd_);
+  }
+  if (ring_fd_ >= 0) {
+    ::close(ring_fd_);
+  }
+}
+
+void* IoUringImpl::getSqe() {
+  unsigned tail = *sq_tail_;
+  if (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_) {
+    // The submission queue is full. Hand what we have to the kernel to make room.
+    submit();
+    tail = *sq_tail_;
+    RELEASE_ASSERT(tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) < sq_entries_, "");
+  }
+
+  const unsigned index = tail & *sq_mask_;
+  io_uring_sqe* sqe = static_cast<io_uring_sqe*>(sqes_) + index;
+  memset(sqe, 0, sizeof(*sqe));
+  sq_array_[index] = index;
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  to_submit_++;
+  return sqe;
+}
+
+void IoUringImpl::prepareAccept(int fd, sockaddr_storage& remote_addr, socklen_t& remote_addr_len,
+                                IoUringRequest& request) {
+  io_uring_sqe* sqe = static_cast<io_uring_sqe*>(getSqe());
+  sqe->opcode = IORING_OP_ACCEPT;
+  sqe->fd = fd;
+  sqe->addr = reinterpret_cast<uint64_t>(&remote_addr);
+  sqe->addr2 = reinterpret_cast<uint64_t>(&remote_addr_len);
+  sqe->accept_flags = SOCK_NONBLOCK;
+  sqe->user_data = reinterpret_cast<uint64_t>(&request);
+}
+
+void IoUringImpl::preparePoll(int fd, uint32_t events, IoUringRequest& request) {
+  io_uring_sqe* sqe = static_cast<io_uring_sqe*>(getSqe());
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = fd;
+  sqe->poll_events = events;
+  sqe->user_data = reinterpret_cast<uint64_t>(&request);
+}
+
+void IoUringImpl::prepareCancel(IoUringRequest& request) {
+  io_uring_sqe* sqe = static_cast<io_uring_sqe*>(getSqe());
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->fd = -1;
+  sqe->addr = reinterpret_cast<uint64_t>(&request);
+  sqe->user_data = 0;
+}
+
+void IoUringImpl::submit() {
+  while (to_submit_ > 0) {
+    const int rc = ioUringEnter(ring_fd_, to_submit_);
+    if (rc == 0) {
+      return;
+    }
+    if (rc < 0) {
+      // EAGAIN and EBUSY mean the kernel is short on resources or the completion queue needs
+      // draining. Entries that were not consumed are submitted on the next call.
+      RELEASE_ASSERT(errno == EINTR || errno == EAGAIN || errno == EBUSY,
+                     fmt::format("io_uring_enter failed: {}", strerror(errno)));
+      return;
+    }
+    to_submit_ -= rc;
+  }
+}
+
+bool IoUringImpl::popCompletion(IoUringRequest*& request, int32_t& result) {
+  const unsigned head = *cq_head_;
+  if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+    return false;
+  }
+  const io_uring_cqe& cqe = static_cast<io_uring_cqe*>(cqes_)[head & *cq_mask_];
+  request = reinterpret_cast<IoUringRequest*>(cqe.user_data);
+  result = cqe.res;
+  // Release the slot before running the callback, which may queue more work.
+  __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+#else
+
+IoUringImplPtr IoUringImpl::create(uint32_t) {
+  ENVOY_LOG(warn, "io_uring: not supported on this platform");
+  return nullptr;
+}
+
+bool IoUringImpl::initialize(uint32_t) { NOT_REACHED_GCOVR_EXCL_LINE; }
+IoUringImpl::~IoUringImpl() {}
+void* IoUringImpl::getSqe() { NOT_REACHED_GCOVR_EXCL_LINE; }
+void IoUringImpl::prepareAccept(int, sockaddr_storage&, socklen_t&, IoUringRequest&) {
+  NOT_REACHED_GCOVR_EXCL_LINE;
+}
+void IoUringImpl::preparePoll(int, uint32_t, IoUringRequest&) { NOT_REACHED_GCOVR_EXCL_LINE; }
+void IoUringImpl::prepareCancel(IoUringRequest&) { NOT_REACHED_GCOVR_EXCL_LINE; }
+void IoUringImpl::submit() { NOT_REACHED_GCOVR_EXCL_LINE; }
+bool IoUringImpl::popCompletion(IoUringRequest*&, int32_t&) { NOT_REACHED_GCOVR_EXCL_LINE; }
+
+#endif
+
+void IoUringImpl::cancel(IoUringRequestPtr&& request) {
+  IoUringRequest& key = *request;
+  canceled_.emplace(&key, std::move(request));
+  prepareCancel(key);
+  // Submit right away so that the kernel drops its reference to the file being operated on.
+  submit();
+}
+
+void IoUringImpl::release(IoUringRequest& request) {
+  ASSERT(canceled_.count(&request) == 0);
+  // The end of the batch may be being delivered, so leave a hole rather than shift the list.
+  std::replace(batch_requests_.begin(), batch_requests_.end(), &request,
+               static_cast<IoUringRequest*>(nullptr));
+}
+
+void IoUringImpl::processCompletions() {
+  if (event_fd_ >= 0) {
+    uint64_t value;
+    // The eventfd only wakes up the loop. Every available completion is drained below.
+    while (::read(event_fd_, &value, sizeof(value)) == sizeof(value)) {
+    }
+  }
+
+  // Operations queued by the callbacks often complete inline during submission, e.g. an accept
+  // when more connections are already queued, so keep going until there is nothing left to do.
+  bool delivered;
+  do {
+    delivered = drainCompletions();
+    submit();
+  } while (delivered);
+
+  // A callback may release another request of the batch, which clears its entry.
+  for (size_t i = 0; i < batch_requests_.size(); i++) {
+    if (batch_requests_[i] != nullptr) {
+      batch_requests_[i]->onCompletionBatchDone();
+    }
+  }
+  batch_requests_.clear();
+}
+
+bool IoUringImpl::drainCompletions() {
+  bool delivered = false;
+  IoUringRequest* request;
+  int32_t result;
+  while (popCompletion(request, result)) {
+    delivered = true;
+    if (request == nullptr) {
+      continue;
+    }
+    request->onCompletion(result);
+    // A canceled request never queues another operation, so this was its last completion. The
+    // request may also have been canceled from within its own callback.
+    if (canceled_.erase(request) > 0) {
+      batch_requests_.erase(std::remove(batch_requests_.begin(), batch_requests_.end(), request),
+                            batch_requests_.end());
+    } else if (std::find(batch_requests_.begin(), batch_requests_.end(), request) ==
+               batch_requests_.end()) {
+      batch_requests_.push_back(request);
+    }
+  }
+  return delivered;
+}
+
+} // namespace Event
+} // namespace Envoy
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <sys/socket.h>
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "envoy/common/pure.h"
+
+#include "common/common/logger.h"
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+namespace Event {
+
+/**
+ * An operation submitted to an io_uring. Each request has at most one operation in flight at a
+ * time, and is told about its completion from the dispatcher thread that owns the ring.
+ */
+class IoUringRequest {
+public:
+  virtual ~IoUringRequest() {}
+
+  /**
+   * Called when the operation in flight for this request completes.
+   * @param result supplies the result of the operation. Negative values are -errno.
+   */
+  virtual void onCompletion(int32_t result) PURE;
+
+  /**
+   * Called once every completion available when the ring was serviced has been delivered, for
+   * each request that received at least one of them.
+   */
+  virtual void onCompletionBatchDone() PURE;
+};
+
+typedef std::unique_ptr<IoUringRequest> IoUringRequestPtr;
+
+class IoUringImpl;
+typedef std::unique_ptr<IoUringImpl> IoUringImplPtr;
+
+/**
+ * Minimal Linux io_uring submission and completion ring, driven through the raw system calls.
+ * Completions are signalled through an eventfd so that the ring can be serviced from the libevent
+ * loop of the owning dispatcher. Not thread safe.
+ *
+ * The operations that touch the kernel ring are virtual so that tests can queue and complete
+ * requests without one. The ownership of canceled requests and the delivery of completions and
+ * batches do not depend on the kernel.
+ */
+class IoUringImpl : Logger::Loggable<Logger::Id::main>, NonCopyable {
+public:
+  virtual ~IoUringImpl();
+
+  /**
+   * Create a ring.
+   * @param entries supplies the number of submission queue entries.
+   * @return IoUringImplPtr the ring, or nullptr if the platform or the running kernel does not
+   *         support the operations used by Envoy.
+   */
+  static IoUringImplPtr create(uint32_t entries);
+
+  /**
+   * @return int the eventfd that becomes readable when completions are available.
+   */
+  int eventFd() const { return event_fd_; }
+
+  /**
+   * Queue an accept of a non-blocking socket from a listen socket.
+   * @param fd supplies the listen socket.
+   * @param remote_addr supplies storage for the peer address, which must outlive the operation.
+   * @param remote_addr_len supplies the size of remote_addr and receives the size of the peer
+   *        address. Must outlive the operation.
+   * @param request supplies the request to notify on completion.
+   */
+  virtual void prepareAccept(int fd, sockaddr_storage& remote_addr, socklen_t& remote_addr_len,
+                             IoUringRequest& request);
+
+  /**
+   * Queue a one shot readiness poll.
+   * @param fd supplies the file descriptor to poll.
+   * @param events supplies the poll(2) events to wait for.
+   * @param request supplies the request to notify on completion.
+   */
+  virtual void preparePoll(int fd, uint32_t events, IoUringRequest& request);
+
+  /**
+   * Cancel the operation in flight for a request and take ownership of the request. The request
+   * receives a final onCompletion() once the kernel has released the operation and is then
+   * destroyed. The request must not queue further operations. It must either have an operation in
+   * flight, or be canceled from within its own onCompletion(), in which case it is destroyed once
+   * that returns.
+   * @param request supplies the request whose owner is going away.
+   */
+  void cancel(IoUringRequestPtr&& request);
+
+  /**
+   * Forget a request which has no operation in flight and is about to be destroyed by its owner,
+   * so that it is not told about the end of the batch being processed.
+   * @param request supplies the request.
+   */
+  void release(IoUringRequest& request);
+
+  /**
+   * Hand every queued operation to the kernel.
+   */
+  virtual void submit();
+
+  /**
+   * Deliver every available completion to its request and submit the operations queued by the
+   * completion callbacks, until no more completions are available.
+   */
+  void processCompletions();
+
+protected:
+  IoUringImpl() {}
+
+  /**
+   * Queue the cancellation of the operation in flight for a request. The completion of the
+   * cancellation itself carries no request.
+   * @param request supplies the request.
+   */
+  virtual void prepareCancel(IoUringRequest& request);
+
+  /**
+   * Take the oldest available completion off the ring.
+   * @param request receives the request of the completed operation, or nullptr if the operation
+   *        carries none.
+   * @param result receives the result of the operation.
+   * @return bool whether a completion was available.
+   */
+  virtual bool popCompletion(IoUringRequest*& request, int32_t& result);
+
+private:
+  bool initialize(uint32_t entries);
+  void* getSqe();
+  bool drainCompletions();
+
+  int ring_fd_{-1};
+  int event_fd_{-1};
+  void* sq_ring_{};
+  size_t sq_ring_size_{};
+  void* cq_ring_{};
+  size_t cq_ring_size_{};
+  void* sqes_{};
+  size_t sqes_size_{};
+  uint32_t sq_entries_{};
+  unsigned* sq_head_{};
+  unsigned* sq_tail_{};
+  unsigned* sq_mask_{};
+  unsigned* sq_array_{};
+  unsigned* cq_head_{};
+  unsigned* cq_tail_{};
+  unsigned* cq_mask_{};
+  void* cqes_{};
+  uint32_t to_submit_{};
+  std::unordered_map<IoUringRequest*, IoUringRequestPtr> canceled_;
+  // Requests that received a completion in the batch being processed.
+  std::vector<IoUringRequest*> batch_requests_;
+};
+
+} // namespace Event
+} // namespace Envoy
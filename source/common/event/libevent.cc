@@ -3,7 +3,9 @@
 #include <signal.h>
 
 #include "common/common/assert.h"
+#include "common/memory/accounting.h"
 
+#include "event2/event.h"
 #include "event2/thread.h"
 
 namespace Envoy {
@@ -13,6 +15,16 @@ namespace Libevent {
 bool Global::initialized_ = false;
 
 void Global::initialize() {
+  // Account libevent's memory, mostly buffer chains. This must happen before libevent allocates
+  // anything, and only once, since blocks must be freed by the functions which allocated them.
+  if (!initialized_) {
+    event_set_mem_functions(
+        [](size_t size) -> void* { return Memory::Accounting::malloc(Memory::Tag::Buffers, size); },
+        [](void* memory, size_t size) -> void* {
+          return Memory::Accounting::realloc(Memory::Tag::Buffers, memory, size);
+        },
+        [](void* memory) -> void { Memory::Accounting::free(Memory::Tag::Buffers, memory); });
+  }
   evthread_use_pthreads();
 
   // Ignore SIGPIPE and allow errors to propagate through error codes.
@@ -17,11 +17,6 @@ extern "C" {
 void bufferevent_free(bufferevent*);
 }
 
-struct evconnlistener;
-extern "C" {
-void evconnlistener_free(evconnlistener*);
-}
-
 namespace Envoy {
 namespace Event {
 namespace Libevent {
@@ -46,7 +41,6 @@ private:
 typedef CSmartPtr<event_base, event_base_free> BasePtr;
 typedef CSmartPtr<evbuffer, evbuffer_free> BufferPtr;
 typedef CSmartPtr<bufferevent, bufferevent_free> BufferEventPtr;
-typedef CSmartPtr<evconnlistener, evconnlistener_free> ListenerPtr;
 
 } // namespace Libevent
 } // namespace Event
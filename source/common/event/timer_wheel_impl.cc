@@ -0,0 +1,186 @@
+#include "common/event/timer_wheel_impl.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Event {
+
+TimerWheelImpl::TimerWheelImpl(Scheduler& scheduler, TimeSource& time_source,
+                               std::chrono::milliseconds resolution)
+    : time_source_(time_source), resolution_(resolution), start_(time_source_.monotonicTime()),
+      tick_timer_(scheduler.createTimer([this]() -> void { onTick(); })) {
+  ASSERT(resolution.count() > 0);
+}
+
+TimerPtr TimerWheelImpl::createTimer(TimerCb cb) {
+  ASSERT(cb);
+  return std::make_unique<WheelTimer>(*this, cb);
+}
+
+TimerWheelImpl::WheelTimer::~WheelTimer() { disableTimer(); }
+
+void TimerWheelImpl::WheelTimer::disableTimer() { wheel_.disable(*this); }
+
+void TimerWheelImpl::WheelTimer::enableTimer(const std::chrono::milliseconds& d) {
+  wheel_.enable(*this, d);
+}
+
+void TimerWheelImpl::enable(WheelTimer& timer, std::chrono::milliseconds d) {
+  const MonotonicTime now = time_source_.monotonicTime();
+  if (timer.list_ != nullptr) {
+    unlink(timer);
+  } else if (armed_timers_++ == 0 && !running_) {
+    // Nothing is on the wheel, so catch up with the clock instead of walking the idle ticks.
+    current_tick_ = std::max(current_tick_, ticksSinceStart(now));
+  }
+
+  if (d.count() == 0) {
+    link(ready_, timer);
+  } else {
+    // Round the deadline up to a tick boundary so that the timer never fires early.
+    const MonotonicTime::duration until_deadline = now + d - start_;
+    timer.expiry_tick_ = std::max<uint64_t>(
+        current_tick_ + 1,
+        (until_deadline + resolution_ - MonotonicTime::duration(1)) / resolution_);
+    insert(timer);
+  }
+  scheduleTick();
+}
+
+void TimerWheelImpl::disable(WheelTimer& timer) {
+  // The tick timer is left alone. If nothing else is armed it fires once and is not re-armed.
+  if (timer.list_ != nullptr) {
+    unlink(timer);
+    armed_timers_--;
+  }
+}
+
+void TimerWheelImpl::insert(WheelTimer& timer) {
+  ASSERT(timer.expiry_tick_ >= current_tick_);
+  const uint64_t slot_tick = std::min<uint64_t>(timer.expiry_tick_, current_tick_ + MaxTicks - 1);
+  const uint64_t delta = slot_tick - current_tick_;
+  uint32_t level = 0;
+  while (delta >= (SlotsPerLevel << (SlotBits * level))) {
+    level++;
+  }
+  link(slots_[level][(slot_tick >> (SlotBits * level)) & SlotMask], timer);
+}
+
+void TimerWheelImpl::link(WheelTimer*& list, WheelTimer& timer) {
+  timer.list_ = &list;
+  timer.prev_ = nullptr;
+  timer.next_ = list;
+  if (list != nullptr) {
+    list->prev_ = &timer;
+  }
+  list = &timer;
+}
+
+void TimerWheelImpl::unlink(WheelTimer& timer) {
+  if (timer.prev_ != nullptr) {
+    timer.prev_->next_ = timer.next_;
+  } else {
+    *timer.list_ = timer.next_;
+  }
+  if (timer.next_ != nullptr) {
+    timer.next_->prev_ = timer.prev_;
+  }
+  timer.list_ = nullptr;
+  timer.prev_ = nullptr;
+  timer.next_ = nullptr;
+}
+
+void TimerWheelImpl::cascade(uint32_t level) {
+  // Every timer in the slot expires before the slot comes around again, so re-hash them all into
+  // the finer levels. Timers beyond the range of the wheel may land back in this same slot.
+  WheelTimer*& slot = slots_[level][(current_tick_ >> (SlotBits * level)) & SlotMask];
+  WheelTimer* timer = slot;
+  slot = nullptr;
+  while (timer != nullptr) {
+    WheelTimer* next = timer->next_;
+    insert(*timer);
+    timer = next;
+  }
+}
+
+void TimerWheelImpl::expire(WheelTimer*& list) {
+  // Take the whole list first, so that timers re-armed by the callbacks wait for a later tick.
+  WheelTimer* expired = list;
+  list = nullptr;
+  for (WheelTimer* timer = expired; timer != nullptr; timer = timer->next_) {
+    timer->list_ = &expired;
+  }
+  while (expired != nullptr) {
+    WheelTimer& timer = *expired;
+    unlink(timer);
+    armed_timers_--;
+    // The callback may disable, re-arm or destroy any timer, including this one.
+    timer.cb_();
+  }
+}
+
+void TimerWheelImpl::onTick() {
+  tick_armed_ = false;
+  tick_immediate_ = false;
+  running_ = true;
+
+  expire(ready_);
+  const uint64_t now_tick = ticksSinceStart(time_source_.monotonicTime());
+  while (current_tick_ < now_tick) {
+    if (armed_timers_ == 0) {
+      current_tick_ = now_tick;
+      break;
+    }
+    current_tick_++;
+    for (uint32_t level = Levels - 1; level > 0; level--) {
+      if ((current_tick_ & ((1ULL << (SlotBits * level)) - 1)) == 0) {
+        cascade(level);
+      }
+    }
+    expire(slots_[0][current_tick_ & SlotMask]);
+  }
+
+  running_ = false;
+  scheduleTick();
+}
+
+void TimerWheelImpl::scheduleTick() {
+  // While the wheel is running, the tick timer is re-armed once it is done.
+  if (running_ || armed_timers_ == 0) {
+    return;
+  }
+
+  if (ready_ != nullptr) {
+    if (!tick_immediate_) {
+      tick_timer_->enableTimer(std::chrono::milliseconds(0));
+      tick_armed_ = true;
+      tick_immediate_ = true;
+    }
+    return;
+  }
+
+  if (tick_armed_) {
+    return;
+  }
+  const MonotonicTime next_tick =
+      start_ + resolution_ * static_cast<MonotonicTime::duration::rep>(current_tick_ + 1);
+  const MonotonicTime now = time_source_.monotonicTime();
+  std::chrono::milliseconds delay(0);
+  if (next_tick > now) {
+    // Round up, as waking up before the tick boundary would not make any progress.
+    delay = std::chrono::duration_cast<std::chrono::milliseconds>(
+        next_tick - now + std::chrono::milliseconds(1) - MonotonicTime::duration(1));
+  }
+  tick_timer_->enableTimer(delay);
+  tick_armed_ = true;
+}
+
+uint64_t TimerWheelImpl::ticksSinceStart(MonotonicTime time) const {
+  return (time - start_) / resolution_;
+}
+
+} // namespace Event
+} // namespace Envoy
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+#include "envoy/common/time.h"
+#include "envoy/event/timer.h"
+
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+namespace Event {
+
+/**
+ * Hierarchical hashed timer wheel for timeouts that tolerate being rounded up to a fixed
+ * resolution, such as idle and request timeouts. Arming, re-arming and disabling a timer are O(1),
+ * compared to O(log n) for the libevent timer heap. The wheel is driven by a single timer from the
+ * underlying scheduler, which fires once per tick while any wheel timer is armed. Wheel timers
+ * never fire early, and fire at most one resolution late on a loop that is not otherwise busy.
+ * Not thread safe; must be used from the thread running the owning dispatcher.
+ */
+class TimerWheelImpl : NonCopyable {
+public:
+  /**
+   * @param scheduler supplies the scheduler used to create the timer that drives the wheel.
+   * @param time_source supplies the monotonic clock that deadlines are computed against.
+   * @param resolution supplies the length of a tick. Must be at least one millisecond.
+   */
+  TimerWheelImpl(Scheduler& scheduler, TimeSource& time_source,
+                 std::chrono::milliseconds resolution);
+
+  /**
+   * Allocate a timer on the wheel. The timer must be destroyed before the wheel.
+   * @param cb supplies the callback to invoke when the timer fires.
+   */
+  TimerPtr createTimer(TimerCb cb);
+
+  /**
+   * @return uint64_t the number of wheel timers currently armed.
+   */
+  uint64_t armedTimers() const { return armed_timers_; }
+
+private:
+  class WheelTimer : public Timer {
+  public:
+    WheelTimer(TimerWheelImpl& wheel, TimerCb cb) : wheel_(wheel), cb_(cb) {}
+    ~WheelTimer();
+
+    // Timer
+    void disableTimer() override;
+    void enableTimer(const std::chrono::milliseconds& d) override;
+
+    TimerWheelImpl& wheel_;
+    const TimerCb cb_;
+    // Intrusive links into the slot holding the timer. list_ is null when the timer is disarmed.
+    WheelTimer** list_{};
+    WheelTimer* prev_{};
+    WheelTimer* next_{};
+    uint64_t expiry_tick_{};
+  };
+
+  // 4 levels of 64 slots cover 2^24 ticks, e.g. 46 hours at a 10ms resolution. Timers further out
+  // are parked in the last level and re-hashed each time that slot comes around.
+  static constexpr uint32_t SlotBits = 6;
+  static constexpr uint64_t SlotsPerLevel = 1 << SlotBits;
+  static constexpr uint64_t SlotMask = SlotsPerLevel - 1;
+  static constexpr uint32_t Levels = 4;
+  static constexpr uint64_t MaxTicks = 1ULL << (SlotBits * Levels);
+
+  void enable(WheelTimer& timer, std::chrono::milliseconds d);
+  void disable(WheelTimer& timer);
+  void insert(WheelTimer& timer);
+  void link(WheelTimer*& list, WheelTimer& timer);
+  void unlink(WheelTimer& timer);
+  void cascade(uint32_t level);
+  void expire(WheelTimer*& list);
+  void onTick();
+  void scheduleTick();
+  uint64_t ticksSinceStart(MonotonicTime time) const;
+
+  TimeSource& time_source_;
+  const MonotonicTime::duration resolution_;
+  const MonotonicTime start_;
+  TimerPtr tick_timer_;
+  std::array<std::array<WheelTimer*, SlotsPerLevel>, Levels> slots_{};
+  // Timers armed with a zero timeout, which run on the next loop iteration as with libevent.
+  WheelTimer* ready_{};
+  // The last tick that has been processed.
+  uint64_t current_tick_{};
+  uint64_t armed_timers_{};
+  bool tick_armed_{};
+  bool tick_immediate_{};
+  bool running_{};
+};
+
+typedef std::unique_ptr<TimerWheelImpl> TimerWheelImplPtr;
+
+} // namespace Event
+} // namespace Envoy
@@ -2,7 +2,9 @@
 
 #include <dirent.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 
+#include <atomic>
 #include <chrono>
 #include <cstdint>
 #include <fstream>
@@ -25,6 +27,18 @@
 namespace Envoy {
 namespace Filesystem {
 
+namespace {
+
+// Returns the index of the calling thread, used to pick its write shard. Threads are numbered in
+// turn, so that the workers spread evenly over the shards.
+size_t threadIndex() {
+  static std::atomic<size_t> next_thread_index{0};
+  static thread_local const size_t thread_index = next_thread_index++;
+  return thread_index;
+}
+
+} // namespace
+
 bool fileExists(const std::string& path) {
   std::ifstream input_file(path);
   return input_file.is_open();
@@ -131,8 +145,9 @@ FileImpl::~FileImpl() {
 
   // Flush any remaining data. If file was not opened for some reason, skip flushing part.
   if (fd_ != -1) {
-    if (flush_buffer_.length() > 0) {
-      doWrite(flush_buffer_);
+    gatherWriteShards();
+    if (about_to_write_buffer_.length() > 0) {
+      doWrite(about_to_write_buffer_);
     }
 
     os_sys_calls_.close(fd_);
@@ -140,10 +155,6 @@ FileImpl::~FileImpl() {
 }
 
 void FileImpl::doWrite(Buffer::Instance& buffer) {
-  uint64_t num_slices = buffer.getRawSlices(nullptr, 0);
-  Buffer::RawSlice slices[num_slices];
-  buffer.getRawSlices(slices, num_slices);
-
   // We must do the actual writes to disk under lock, so that we don't intermix chunks from
   // different FileImpl pointing to the same underlying file. This can happen either via hot
   // restart or if calling code opens the same underlying file into a different FileImpl in the
@@ -154,17 +165,47 @@ void FileImpl::doWrite(Buffer::Instance& buffer) {
   //            process lock or had multiple locks.
   {
     Thread::LockGuard lock(file_lock_);
-    for (Buffer::RawSlice& slice : slices) {
-      const Api::SysCallSizeResult result = os_sys_calls_.write(fd_, slice.mem_, slice.len_);
-      ASSERT(result.rc_ == static_cast<ssize_t>(slice.len_));
+    while (buffer.length() > 0) {
+      Buffer::RawSlice slices[MAX_WRITE_SLICES];
+      uint64_t num_slices = buffer.getRawSlices(slices, MAX_WRITE_SLICES);
+      if (num_slices > MAX_WRITE_SLICES) {
+        num_slices = MAX_WRITE_SLICES;
+      }
+      Api::SysCallSizeResult result;
+      if (num_slices == 1) {
+        result = os_sys_calls_.write(fd_, slices[0].mem_, slices[0].len_);
+      } else {
+        // The slices gathered from the write shards are written by a single system call.
+        iovec iov[MAX_WRITE_SLICES];
+        for (uint64_t i = 0; i < num_slices; i++) {
+          iov[i].iov_base = slices[i].mem_;
+          iov[i].iov_len = slices[i].len_;
+        }
+        result = os_sys_calls_.writev(fd_, iov, num_slices);
+      }
+      if (result.rc_ <= 0) {
+        stats_.write_failed_.inc();
+        break;
+      }
       stats_.write_completed_.inc();
+      stats_.write_total_buffered_.sub(result.rc_);
+      buffer.drain(result.rc_);
     }
   }
 
+  // The data which couldn't be written is dropped.
   stats_.write_total_buffered_.sub(buffer.length());
   buffer.drain(buffer.length());
 }
 
+void FileImpl::gatherWriteShards() {
+  for (WriteShard& shard : write_shards_) {
+    Thread::LockGuard lock(shard.lock_);
+    flush_buffer_length_ -= shard.buffer_.length();
+    about_to_write_buffer_.move(shard.buffer_);
+  }
+}
+
 void FileImpl::flushThreadFunc() {
 
   while (true) {
@@ -173,9 +214,9 @@ void FileImpl::flushThreadFunc() {
     {
       Thread::LockGuard write_lock(write_lock_);
 
-      // flush_event_ can be woken up either by large enough flush_buffer or by timer.
-      // In case it was timer, flush_buffer_ can be empty.
-      while (flush_buffer_.length() == 0 && !flush_thread_exit_) {
+      // flush_event_ can be woken up either by large enough write shards or by timer.
+      // In case it was timer, the write shards can be empty.
+      while (flush_buffer_length_ == 0 && !flush_thread_exit_) {
         // CondVar::wait() does not throw, so it's safe to pass the mutex rather than the guard.
         flush_event_.wait(write_lock_);
       }
@@ -185,9 +226,12 @@ void FileImpl::flushThreadFunc() {
       }
 
       flush_lock = std::unique_lock<Thread::BasicLockable>(flush_lock_);
-      ASSERT(flush_buffer_.length() > 0);
-      about_to_write_buffer_.move(flush_buffer_);
-      ASSERT(flush_buffer_.length() == 0);
+    }
+
+    gatherWriteShards();
+    if (about_to_write_buffer_.length() == 0) {
+      // A synchronous flush wrote the data first.
+      continue;
     }
 
     // if we failed to open file before (-1 == fd_), then simply ignore
@@ -208,40 +252,52 @@ void FileImpl::flushThreadFunc() {
 }
 
 void FileImpl::flush() {
-  std::unique_lock<Thread::BasicLockable> flush_buffer_lock;
-
-  {
-    Thread::LockGuard write_lock(write_lock_);
-
-    // flush_lock_ must be held while checking this or else it is
-    // possible that flushThreadFunc() has already moved data from
-    // flush_buffer_ to about_to_write_buffer_, has unlocked write_lock_,
-    // but has not yet completed doWrite(). This would allow flush() to
-    // return before the pending data has actually been written to disk.
-    flush_buffer_lock = std::unique_lock<Thread::BasicLockable>(flush_lock_);
-
-    if (flush_buffer_.length() == 0) {
-      return;
-    }
-
-    about_to_write_buffer_.move(flush_buffer_);
-    ASSERT(flush_buffer_.length() == 0);
+  // flush_lock_ must be held while gathering the write shards or else it is possible that
+  // flushThreadFunc() has already moved data from them to about_to_write_buffer_, but has not yet
+  // completed doWrite(). This would allow flush() to return before the pending data has actually
+  // been written to disk.
+  Thread::LockGuard flush_lock(flush_lock_);
+
+  gatherWriteShards();
+  if (about_to_write_buffer_.length() == 0) {
+    return;
   }
 
   doWrite(about_to_write_buffer_);
 }
 
 void FileImpl::write(absl::string_view data) {
-  Thread::LockGuard lock(write_lock_);
-
-  if (flush_thread_ == nullptr) {
-    createFlushStructures();
+  bool started_flush_thread = false;
+  if (!flush_thread_started_) {
+    Thread::LockGuard lock(write_lock_);
+    if (flush_thread_ == nullptr) {
+      createFlushStructures();
+      flush_thread_started_ = true;
+      started_flush_thread = true;
+    }
   }
 
   stats_.write_buffered_.inc();
   stats_.write_total_buffered_.add(data.length());
-  flush_buffer_.add(data.data(), data.size());
-  if (flush_buffer_.length() > MIN_FLUSH_SIZE) {
+  uint64_t flush_buffer_length;
+  {
+    WriteShard& shard = write_shards_[threadIndex() % NUM_WRITE_SHARDS];
+    Thread::LockGuard lock(shard.lock_);
+    shard.buffer_.add(data.data(), data.size());
+    // The total length is updated under the lock of the shard, so that gatherWriteShards() never
+    // subtracts a length which wasn't added yet.
+    flush_buffer_length = flush_buffer_length_ += data.size();
+  }
+
+  // The flush thread is told to flush once, when the write shards reach the flush size. The first
+  // write is flushed right away.
+  const bool reached_flush_size = flush_buffer_length > MIN_FLUSH_SIZE &&
+                                  flush_buffer_length - data.size() <= MIN_FLUSH_SIZE;
+  if (reached_flush_size || started_flush_thread) {
+    Thread::LockGuard lock(write_lock_);
+    if (reached_flush_size) {
+      stats_.flushed_by_size_.inc();
+    }
     flush_event_.notifyOne();
   }
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <cstdint>
@@ -21,7 +22,9 @@ namespace Envoy {
   COUNTER(write_buffered)                                                                          \
   COUNTER(write_completed)                                                                         \
   COUNTER(flushed_by_timer)                                                                        \
+  COUNTER(flushed_by_size)                                                                         \
   COUNTER(reopen_failed)                                                                           \
+  COUNTER(write_failed)                                                                            \
   GAUGE  (write_total_buffered)
 // clang-format on
 
@@ -78,6 +81,10 @@ bool illegalPath(const std::string& path);
  * This implementation uses a flush thread per file, with the idea there there aren't that many
  * files. If this turns out to be a good implementation we can potentially have a single flush
  * thread that flushes all files, but we will start with this.
+ *
+ * Writes are buffered in shards picked by the writing thread, so that the workers writing to the
+ * same file don't contend on a single lock. The flush thread gathers the shards and writes them
+ * with a single writev().
  */
 class FileImpl : public File {
 public:
@@ -100,13 +107,26 @@ public:
   void flush() override;
 
 private:
+  // A buffer written to by a subset of the threads.
+  struct WriteShard {
+    Thread::MutexBasicLockable lock_;
+    Buffer::OwnedImpl buffer_ GUARDED_BY(lock_);
+  };
+
   void doWrite(Buffer::Instance& buffer);
   void flushThreadFunc();
   void open();
   void createFlushStructures();
+  // Moves the data of all of the shards to about_to_write_buffer_. flush_lock_ must be held.
+  void gatherWriteShards();
 
   // Minimum size before the flush thread will be told to flush.
   static const uint64_t MIN_FLUSH_SIZE = 1024 * 64;
+  // The number of write shards. Threads are assigned to shards in turn, so that up to this many
+  // workers write to a file without contending.
+  static const size_t NUM_WRITE_SHARDS = 16;
+  // The maximum number of slices written by a single writev().
+  static const uint64_t MAX_WRITE_SLICES = 64;
 
   int fd_;
   std::string path_;
@@ -125,17 +145,19 @@ private:
                                           // and all other data used during flushing and file
                                           // re-opening.
   Thread::MutexBasicLockable
-      write_lock_; // The lock is used when filling the flush buffer. It allows
-                   // multiple threads to write to the same file at relatively
-                   // high performance. It is always local to the process.
+      write_lock_; // The lock is used to wait for and signal flush_event_, and to start the flush
+                   // thread. Writes only acquire it when the flush buffers reach the flush size.
+                   // It is always local to the process.
   Thread::ThreadPtr flush_thread_;
+  std::atomic<bool> flush_thread_started_{};
   Thread::CondVar flush_event_;
   std::atomic<bool> flush_thread_exit_{};
   std::atomic<bool> reopen_file_{};
-  Buffer::OwnedImpl
-      flush_buffer_ GUARDED_BY(write_lock_); // This buffer is used by multiple threads. It gets
-                                             // filled and then flushed either when max size is
-                                             // reached or when a timer fires.
+  std::array<WriteShard, NUM_WRITE_SHARDS>
+      write_shards_; // These buffers are used by multiple threads. They get filled and then
+                     // flushed either when their total size reaches the flush size or when a
+                     // timer fires.
+  std::atomic<uint64_t> flush_buffer_length_{}; // The total length of the write shards.
   // TODO(jmarantz): this should be GUARDED_BY(flush_lock_) but the analysis cannot poke through
   // the std::make_unique assignment. I do not believe it's possible to annotate this properly now
   // due to limitations in the clang thread annotation analysis.
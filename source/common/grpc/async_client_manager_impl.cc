@@ -31,12 +31,23 @@ AsyncClientFactoryImpl::AsyncClientFactoryImpl(Upstream::ClusterManager& cm,
 }
 
 AsyncClientManagerImpl::AsyncClientManagerImpl(Upstream::ClusterManager& cm,
-                                               ThreadLocal::Instance& tls, TimeSource& time_source)
+                                               ThreadLocal::Instance& tls, TimeSource& time_source,
+                                               uint32_t google_grpc_completion_threads)
     : cm_(cm), tls_(tls), time_source_(time_source) {
 #ifdef ENVOY_GOOGLE_GRPC
+  // The channels, and optionally the completion queues, are shared by the workers, which keep
+  // them alive until they are all done with them.
+  GoogleChannelCacheSharedPtr channel_cache = std::make_shared<GoogleChannelCache>();
+  GoogleCompletionQueuePoolSharedPtr cq_pool;
+  if (google_grpc_completion_threads > 0) {
+    cq_pool = std::make_shared<GoogleCompletionQueuePool>(google_grpc_completion_threads);
+  }
   google_tls_slot_ = tls.allocateSlot();
-  google_tls_slot_->set(
-      [](Event::Dispatcher&) { return std::make_shared<GoogleAsyncClientThreadLocal>(); });
+  google_tls_slot_->set([channel_cache, cq_pool](Event::Dispatcher&) {
+    return std::make_shared<GoogleAsyncClientThreadLocal>(channel_cache, cq_pool);
+  });
+#else
+  UNREFERENCED_PARAMETER(google_grpc_completion_threads);
 #endif
 }
 
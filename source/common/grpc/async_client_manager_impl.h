@@ -40,8 +40,13 @@ private:
 
 class AsyncClientManagerImpl : public AsyncClientManager {
 public:
+  /**
+   * @param google_grpc_completion_threads supplies the number of threads draining the completion
+   *        queues of the Google gRPC clients of all the workers, or 0 for each worker to run its
+   *        own completion thread.
+   */
   AsyncClientManagerImpl(Upstream::ClusterManager& cm, ThreadLocal::Instance& tls,
-                         TimeSource& time_source);
+                         TimeSource& time_source, uint32_t google_grpc_completion_threads = 0);
 
   // Grpc::AsyncClientManager
   AsyncClientFactoryPtr factoryForGrpcService(const envoy::api::v2::core::GrpcService& config,
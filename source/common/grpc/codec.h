@@ -39,7 +39,8 @@ public:
   // Decodes the given buffer with GRPC data frame. Drains the input buffer when
   // decoding succeeded (returns true). If the input is not sufficient to make a
   // complete GRPC data frame, it will be buffered in the decoder. If a decoding
-  // error happened, the input buffer remains unchanged.
+  // error happened, the input buffer starts with the invalid frame. The payloads
+  // of the frames are moved out of the input buffer rather than copied.
   // @param input supplies the binary octets wrapped in a GRPC data frame.
   // @param output supplies the buffer to store the decoded data.
   // @return bool whether the decoding succeeded or not.
@@ -86,6 +87,9 @@ private:
     DATA,
   };
 
+  // Decodes a byte of the header of a frame, returning false if the flags are invalid.
+  bool decodeHeaderByte(uint8_t c);
+
   State state_;
   Frame frame_;
 };
@@ -13,10 +13,77 @@
 namespace Envoy {
 namespace Grpc {
 
-GoogleAsyncClientThreadLocal::GoogleAsyncClientThreadLocal()
-    : completion_thread_(new Thread::Thread([this] { completionThread(); })) {}
+std::shared_ptr<grpc::Channel>
+GoogleChannelCache::channel(const envoy::api::v2::core::GrpcService& config) {
+  // The stat prefix is the only field which doesn't affect the channel.
+  envoy::api::v2::core::GrpcService::GoogleGrpc key_config = config.google_grpc();
+  key_config.clear_stat_prefix();
+  const std::string key = key_config.SerializeAsString();
+
+  Thread::LockGuard lock(lock_);
+  std::shared_ptr<grpc::Channel> channel = channels_[key].lock();
+  if (channel == nullptr) {
+    std::shared_ptr<grpc::ChannelCredentials> creds = getGoogleGrpcChannelCredentials(config);
+    channel = CreateChannel(config.google_grpc().target_uri(), creds);
+    channels_[key] = channel;
+  }
+  // Forget the channels which are no longer used, so that the cache doesn't grow with the
+  // configurations seen over time.
+  for (auto it = channels_.begin(); it != channels_.end();) {
+    if (it->second.expired()) {
+      it = channels_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  return channel;
+}
+
+GoogleCompletionQueuePool::GoogleCompletionQueuePool(uint32_t num_threads) {
+  ASSERT(num_threads > 0);
+  for (uint32_t i = 0; i < num_threads; ++i) {
+    cqs_.emplace_back(new grpc::CompletionQueue());
+    grpc::CompletionQueue& cq = *cqs_.back();
+    completion_threads_.emplace_back(
+        new Thread::Thread([&cq] { GoogleAsyncClientThreadLocal::completionThread(cq); }));
+  }
+}
+
+GoogleCompletionQueuePool::~GoogleCompletionQueuePool() {
+  // The pool is only destroyed once all the silos using it are, so no tags are pending anymore.
+  for (auto& cq : cqs_) {
+    cq->Shutdown();
+  }
+  ENVOY_LOG(debug, "Joining completionThreads");
+  for (auto& completion_thread : completion_threads_) {
+    completion_thread->join();
+  }
+  ENVOY_LOG(debug, "Joined completionThreads");
+}
+
+grpc::CompletionQueue& GoogleCompletionQueuePool::nextCompletionQueue() {
+  return *cqs_[next_cq_++ % cqs_.size()];
+}
+
+GoogleAsyncClientThreadLocal::GoogleAsyncClientThreadLocal(
+    GoogleChannelCacheSharedPtr channel_cache, GoogleCompletionQueuePoolSharedPtr cq_pool)
+    : channel_cache_(channel_cache != nullptr ? channel_cache
+                                              : std::make_shared<GoogleChannelCache>()),
+      cq_pool_(cq_pool) {
+  if (cq_pool_ != nullptr) {
+    cq_ = &cq_pool_->nextCompletionQueue();
+  } else {
+    owned_cq_ = std::make_unique<grpc::CompletionQueue>();
+    cq_ = owned_cq_.get();
+    completion_thread_ = std::make_unique<Thread::Thread>([this] { completionThread(*cq_); });
+  }
+}
 
 GoogleAsyncClientThreadLocal::~GoogleAsyncClientThreadLocal() {
+  {
+    Thread::LockGuard lock(completed_ops_lock_);
+    shutdown_ = true;
+  }
   // Force streams to shutdown and invoke TryCancel() to start the drain of
   // pending op. If we don't do this, Shutdown() below can jam on pending ops.
   // This is also required to satisfy the contract that once Shutdown is called,
@@ -27,43 +94,78 @@ GoogleAsyncClientThreadLocal::~GoogleAsyncClientThreadLocal() {
     // we point to the next one first.
     (*it++)->resetStream();
   }
-  cq_.Shutdown();
-  ENVOY_LOG(debug, "Joining completionThread");
-  completion_thread_->join();
-  ENVOY_LOG(debug, "Joined completionThread");
-  // Ensure that we have cleaned up all orphan streams, now that CQ is gone.
+  if (owned_cq_ != nullptr) {
+    owned_cq_->Shutdown();
+    ENVOY_LOG(debug, "Joining completionThread");
+    completion_thread_->join();
+    ENVOY_LOG(debug, "Joined completionThread");
+  }
+  // Ensure that we have cleaned up all orphan streams. The silo dispatcher no longer runs, so the
+  // remaining completions are handled here as they arrive.
   while (!streams_.empty()) {
-    (*streams_.begin())->onCompletedOps();
+    CompletedOps completed_ops;
+    {
+      Thread::LockGuard lock(completed_ops_lock_);
+      while (completed_ops_.empty()) {
+        // CondVar::wait() does not throw, so it's safe to pass the mutex rather than the guard.
+        completed_ops_event_.wait(completed_ops_lock_);
+      }
+      completed_ops_.swap(completed_ops);
+    }
+    for (const auto& completed_op : completed_ops) {
+      std::get<0>(completed_op)
+          ->handleOpCompletion(std::get<1>(completed_op), std::get<2>(completed_op));
+    }
   }
 }
 
-void GoogleAsyncClientThreadLocal::completionThread() {
+void GoogleAsyncClientThreadLocal::completionThread(grpc::CompletionQueue& cq) {
   ENVOY_LOG(debug, "completionThread running");
   void* tag;
   bool ok;
-  while (cq_.Next(&tag, &ok)) {
+  while (cq.Next(&tag, &ok)) {
     const auto& google_async_tag = *reinterpret_cast<GoogleAsyncTag*>(tag);
     const GoogleAsyncTag::Operation op = google_async_tag.op_;
     GoogleAsyncStreamImpl& stream = google_async_tag.stream_;
     ENVOY_LOG(trace, "completionThread CQ event {} {}", op, ok);
-    Thread::LockGuard lock(stream.completed_ops_lock_);
-
-    // It's an invariant that there must only be one pending post for arbitrary
-    // length completed_ops_, otherwise we can race in stream destruction, where
-    // we process multiple events in onCompletedOps() but have only partially
-    // consumed the posts on the dispatcher.
-    // TODO(htuch): This may result in unbounded processing on the silo thread
-    // in onCompletedOps() in extreme cases, when we emplace_back() in
-    // completionThread() at a high rate, consider bounding the length of such
-    // sequences if this behavior becomes an issue.
-    if (stream.completed_ops_.empty()) {
-      stream.dispatcher_.post([&stream] { stream.onCompletedOps(); });
-    }
-    stream.completed_ops_.emplace_back(op, ok);
+    stream.tls_.onCompletedOp(stream, op, ok);
   }
   ENVOY_LOG(debug, "completionThread exiting");
 }
 
+void GoogleAsyncClientThreadLocal::onCompletedOp(GoogleAsyncStreamImpl& stream,
+                                                 GoogleAsyncTag::Operation op, bool ok) {
+  Thread::LockGuard lock(completed_ops_lock_);
+  // It's an invariant that there must only be one pending post for arbitrary
+  // length completed_ops_, otherwise we can race in stream destruction, where
+  // we process multiple events in onCompletedOps() but have only partially
+  // consumed the posts on the dispatcher. This also batches the completions of
+  // all the streams of the silo into a single post.
+  // TODO(htuch): This may result in unbounded processing on the silo thread
+  // in onCompletedOps() in extreme cases, when we emplace_back() in
+  // completionThread() at a high rate, consider bounding the length of such
+  // sequences if this behavior becomes an issue.
+  if (completed_ops_.empty() && !shutdown_) {
+    stream.dispatcher_.post([this] { onCompletedOps(); });
+  }
+  completed_ops_.emplace_back(&stream, op, ok);
+  completed_ops_event_.notifyOne();
+}
+
+void GoogleAsyncClientThreadLocal::onCompletedOps() {
+  CompletedOps completed_ops;
+  {
+    Thread::LockGuard lock(completed_ops_lock_);
+    completed_ops_.swap(completed_ops);
+  }
+  // A stream is only deleted once all its operations have completed, and its deletion is
+  // deferred, so the streams of the operations queued behind are still alive.
+  for (const auto& completed_op : completed_ops) {
+    std::get<0>(completed_op)
+        ->handleOpCompletion(std::get<1>(completed_op), std::get<2>(completed_op));
+  }
+}
+
 GoogleAsyncClientImpl::GoogleAsyncClientImpl(Event::Dispatcher& dispatcher,
                                              GoogleAsyncClientThreadLocal& tls,
                                              GoogleStubFactory& stub_factory,
@@ -71,13 +173,9 @@ GoogleAsyncClientImpl::GoogleAsyncClientImpl(Event::Dispatcher& dispatcher,
                                              const envoy::api::v2::core::GrpcService& config)
     : dispatcher_(dispatcher), tls_(tls), stat_prefix_(config.google_grpc().stat_prefix()),
       initial_metadata_(config.initial_metadata()), scope_(scope) {
-  // We rebuild the channel each time we construct the channel. It appears that the gRPC library is
-  // smart enough to do connection pooling and reuse with identical channel args, so this should
-  // have comparable overhead to what we are doing in Grpc::AsyncClientImpl, i.e. no expensive
-  // new connection implied.
-  std::shared_ptr<grpc::ChannelCredentials> creds = getGoogleGrpcChannelCredentials(config);
-  std::shared_ptr<grpc::Channel> channel = CreateChannel(config.google_grpc().target_uri(), creds);
-  stub_ = stub_factory.createStub(channel);
+  // The clients with the same target and credentials share their channel, rather than relying on
+  // the gRPC library to share the connections of identical channels.
+  stub_ = stub_factory.createStub(tls_.channelCache().channel(config));
   // Initialize client stats.
   stats_.streams_total_ = &scope_->counter("streams_total");
   for (uint32_t i = 0; i <= Status::GrpcStatus::MaximumValid; ++i) {
@@ -227,17 +325,6 @@ void GoogleAsyncStreamImpl::writeQueued() {
   ENVOY_LOG(trace, "Write op dispatched");
 }
 
-void GoogleAsyncStreamImpl::onCompletedOps() {
-  Thread::LockGuard lock(completed_ops_lock_);
-  while (!completed_ops_.empty()) {
-    GoogleAsyncTag::Operation op;
-    bool ok;
-    std::tie(op, ok) = completed_ops_.front();
-    completed_ops_.pop_front();
-    handleOpCompletion(op, ok);
-  }
-}
-
 void GoogleAsyncStreamImpl::handleOpCompletion(GoogleAsyncTag::Operation op, bool ok) {
   ENVOY_LOG(trace, "handleOpCompletion op={} ok={} inflight={}", op, ok, inflight_tags_);
   ASSERT(inflight_tags_ > 0);
@@ -1,6 +1,11 @@
 #pragma once
 
+#include <atomic>
+#include <deque>
 #include <queue>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
 
 #include "envoy/grpc/async_client.h"
 #include "envoy/stats/scope.h"
@@ -59,13 +64,64 @@ struct GoogleAsyncTag {
   }
 };
 
+/**
+ * Channels shared by all the clients, and all the workers, whose Google gRPC configurations only
+ * differ by their stat prefix. A channel is released once none of the clients use it anymore.
+ */
+class GoogleChannelCache {
+public:
+  std::shared_ptr<grpc::Channel> channel(const envoy::api::v2::core::GrpcService& config);
+
+private:
+  Thread::MutexBasicLockable lock_;
+  std::unordered_map<std::string, std::weak_ptr<grpc::Channel>> channels_ GUARDED_BY(lock_);
+};
+
+typedef std::shared_ptr<GoogleChannelCache> GoogleChannelCacheSharedPtr;
+
+/**
+ * A fixed number of completion queues, each drained by its own thread, shared by the workers in
+ * place of their own completion queue and thread.
+ */
+class GoogleCompletionQueuePool : Logger::Loggable<Logger::Id::grpc> {
+public:
+  GoogleCompletionQueuePool(uint32_t num_threads);
+  ~GoogleCompletionQueuePool();
+
+  /**
+   * @return the completion queue for a new worker, chosen in a round robin fashion.
+   */
+  grpc::CompletionQueue& nextCompletionQueue();
+
+private:
+  std::vector<std::unique_ptr<grpc::CompletionQueue>> cqs_;
+  std::vector<Thread::ThreadPtr> completion_threads_;
+  std::atomic<uint32_t> next_cq_{};
+};
+
+typedef std::shared_ptr<GoogleCompletionQueuePool> GoogleCompletionQueuePoolSharedPtr;
+
 class GoogleAsyncClientThreadLocal : public ThreadLocal::ThreadLocalObject,
                                      Logger::Loggable<Logger::Id::grpc> {
 public:
-  GoogleAsyncClientThreadLocal();
+  /**
+   * @param channel_cache supplies the channels shared with the other workers, or nullptr for this
+   *        worker to only share channels between its own clients.
+   * @param cq_pool supplies the completion queues shared with the other workers, or nullptr for
+   *        this worker to run its own completion queue and thread.
+   */
+  GoogleAsyncClientThreadLocal(GoogleChannelCacheSharedPtr channel_cache = nullptr,
+                               GoogleCompletionQueuePoolSharedPtr cq_pool = nullptr);
   ~GoogleAsyncClientThreadLocal();
 
-  grpc::CompletionQueue& completionQueue() { return cq_; }
+  grpc::CompletionQueue& completionQueue() { return *cq_; }
+  GoogleChannelCache& channelCache() { return *channel_cache_; }
+
+  /**
+   * Drains a completion queue until it is shut down, handing the completed operations to the
+   * workers of their streams.
+   */
+  static void completionThread(grpc::CompletionQueue& cq);
 
   void registerStream(GoogleAsyncStreamImpl* stream) {
     ASSERT(streams_.find(stream) == streams_.end());
@@ -79,11 +135,21 @@ public:
   }
 
 private:
-  void completionThread();
+  // Queue an operation completed on the completion thread, to be handled on the silo thread.
+  void onCompletedOp(GoogleAsyncStreamImpl& stream, GoogleAsyncTag::Operation op, bool ok);
+  // Process queued events in completed_ops_ with handleOpCompletion() on the silo thread.
+  void onCompletedOps();
 
-  // The CompletionQueue for in-flight operations. This must precede completion_thread_ to ensure it
-  // is constructed before the thread runs.
-  grpc::CompletionQueue cq_;
+  typedef std::deque<std::tuple<GoogleAsyncStreamImpl*, GoogleAsyncTag::Operation, bool>>
+      CompletedOps;
+
+  const GoogleChannelCacheSharedPtr channel_cache_;
+  const GoogleCompletionQueuePoolSharedPtr cq_pool_;
+  // The CompletionQueue owned by this silo when there is no pool. This must precede
+  // completion_thread_ to ensure it is constructed before the thread runs.
+  std::unique_ptr<grpc::CompletionQueue> owned_cq_;
+  // The CompletionQueue for in-flight operations, either owned_cq_ or one from cq_pool_.
+  grpc::CompletionQueue* cq_;
   // The threading model for the Google gRPC C++ library is not directly compatible with Envoy's
   // siloed model. We resolve this by issuing non-blocking asynchronous
   // operations on the GoogleAsyncClientImpl silo thread, and then synchronously
@@ -91,12 +157,21 @@ private:
   // are delivered, we cross-post to the silo dispatcher to continue the
   // operation.
   //
-  // We have an independent completion thread for each TLS silo (i.e. one per worker and
-  // also one for the main thread).
+  // Without a pool, we have an independent completion thread for each TLS silo (i.e. one per
+  // worker and also one for the main thread).
   Thread::ThreadPtr completion_thread_;
   // Track all streams that are currently using this CQ, so we can notify them
   // on shutdown.
   std::unordered_set<GoogleAsyncStreamImpl*> streams_;
+  // Queue of completed (stream, op, ok) passed from completionThread() to handleOpCompletion().
+  // All the operations completed while a post to the silo dispatcher is pending are handled by
+  // that single post.
+  CompletedOps completed_ops_ GUARDED_BY(completed_ops_lock_);
+  // Set once the silo dispatcher no longer runs, after which the completed operations are waited
+  // for and handled by the destructor.
+  bool shutdown_ GUARDED_BY(completed_ops_lock_){};
+  Thread::MutexBasicLockable completed_ops_lock_;
+  Thread::CondVar completed_ops_event_;
 };
 
 // Google gRPC client stats. TODO(htuch): consider how a wider set of stats collected by the
@@ -168,9 +243,6 @@ public:
   TimeSource& timeSource() { return dispatcher_.timeSystem(); }
 
 private:
-  static std::shared_ptr<grpc::Channel>
-  createChannel(const envoy::api::v2::core::GrpcService::GoogleGrpc& config);
-
   Event::Dispatcher& dispatcher_;
   GoogleAsyncClientThreadLocal& tls_;
   // This is shared with child streams, so that they can cleanup independent of
@@ -210,9 +282,6 @@ protected:
   bool call_failed() const { return call_failed_; }
 
 private:
-  // Process queued events in completed_ops_ with handleOpCompletion() on
-  // GoogleAsyncClient silo thread.
-  void onCompletedOps();
   // Handle Operation completion on GoogleAsyncClient silo thread. This is posted by
   // GoogleAsyncClientThreadLocal::completionThread() when a message is received on cq_.
   void handleOpCompletion(GoogleAsyncTag::Operation op, bool ok);
@@ -290,11 +359,6 @@ private:
   // Count of the tags in-flight. This must hit zero before the stream can be
   // freed.
   uint32_t inflight_tags_{};
-  // Queue of completed (op, ok) passed from completionThread() to
-  // handleOpCompletion().
-  std::deque<std::pair<GoogleAsyncTag::Operation, bool>>
-      completed_ops_ GUARDED_BY(completed_ops_lock_);
-  Thread::MutexBasicLockable completed_ops_lock_;
 
   friend class GoogleAsyncClientImpl;
   friend class GoogleAsyncClientThreadLocal;
@@ -90,7 +90,7 @@ private:
   struct NullCorsPolicy : public Router::CorsPolicy {
     // Router::CorsPolicy
     const std::list<std::string>& allowOrigins() const override { return allow_origin_; };
-    const std::list<std::regex>& allowOriginRegexes() const override {
+    const std::list<Regex::CompiledMatcherPtr>& allowOriginRegexes() const override {
       return allow_origin_regex_;
     };
     const std::string& allowMethods() const override { return EMPTY_STRING; };
@@ -101,7 +101,7 @@ private:
     bool enabled() const override { return false; };
 
     static const std::list<std::string> allow_origin_;
-    static const std::list<std::regex> allow_origin_regex_;
+    static const std::list<Regex::CompiledMatcherPtr> allow_origin_regex_;
     static const absl::optional<bool> allow_credentials_;
   };
 
@@ -126,6 +126,12 @@ private:
     uint32_t retryOn() const override { return 0; }
   };
 
+  struct NullHedgePolicy : public Router::HedgePolicy {
+    // Router::HedgePolicy
+    std::chrono::milliseconds delay() const override { return std::chrono::milliseconds(0); }
+    uint32_t budgetPercent() const override { return 0; }
+  };
+
   struct NullShadowPolicy : public Router::ShadowPolicy {
     // Router::ShadowPolicy
     const std::string& cluster() const override { return EMPTY_STRING; }
@@ -187,6 +193,7 @@ private:
     }
     const Router::RateLimitPolicy& rateLimitPolicy() const override { return rate_limit_policy_; }
     const Router::RetryPolicy& retryPolicy() const override { return retry_policy_; }
+    const Router::HedgePolicy& hedgePolicy() const override { return hedge_policy_; }
     const Router::ShadowPolicy& shadowPolicy() const override { return shadow_policy_; }
     std::chrono::milliseconds timeout() const override {
       if (timeout_) {
@@ -226,6 +233,7 @@ private:
 
     static const NullRateLimitPolicy rate_limit_policy_;
     static const NullRetryPolicy retry_policy_;
+    static const NullHedgePolicy hedge_policy_;
     static const NullShadowPolicy shadow_policy_;
     static const NullVirtualHost virtual_host_;
     static const std::multimap<std::string, std::string> opaque_config_;
@@ -296,6 +304,7 @@ private:
   void removeDownstreamWatermarkCallbacks(DownstreamWatermarkCallbacks&) override {}
   void setDecoderBufferLimit(uint32_t) override {}
   uint32_t decoderBufferLimit() override { return 0; }
+  void setDecoderBufferSpillThreshold(uint32_t, const std::string&) override {}
 
   AsyncClient::StreamCallbacks& stream_callbacks_;
   const uint64_t stream_id_;
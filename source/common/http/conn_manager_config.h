@@ -82,7 +82,8 @@ struct ConnectionManagerStats {
   COUNTER(service_forced)                                                                          \
   COUNTER(client_enabled)                                                                          \
   COUNTER(not_traceable)                                                                           \
-  COUNTER(health_check)
+  COUNTER(health_check)                                                                            \
+  COUNTER(tail_sampled)
 // clang-format on
 
 /**
@@ -97,12 +98,23 @@ struct ConnectionManagerTracingStats {
  * Http Tracing can be enabled/disabled on a per connection manager basis.
  * Here we specify some specific for connection manager settings.
  */
+/**
+ * Configuration for tail sampling, which traces the requests not traced when they started once
+ * they complete, if they failed, were slower than a latency threshold, or are randomly sampled.
+ */
+struct TailSamplingConfig {
+  absl::optional<std::chrono::milliseconds> latency_threshold_;
+  bool errors_;
+  uint64_t random_sampling_;
+};
+
 struct TracingConnectionManagerConfig {
   Tracing::OperationName operation_name_;
   std::vector<Http::LowerCaseString> request_headers_for_tags_;
   uint64_t client_sampling_;
   uint64_t random_sampling_;
   uint64_t overall_sampling_;
+  absl::optional<TailSamplingConfig> tail_sampling_{};
 };
 
 typedef std::unique_ptr<TracingConnectionManagerConfig> TracingConnectionManagerConfigPtr;
@@ -292,6 +304,11 @@ public:
    * @return supplies the http1 settings.
    */
   virtual const Http::Http1Settings& http1Settings() const PURE;
+
+  /**
+   * @return bool whether each stream has an arena that filter factories may allocate from.
+   */
+  virtual bool perStreamArena() const PURE;
 };
 } // namespace Http
 } // namespace Envoy
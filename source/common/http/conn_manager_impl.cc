@@ -83,7 +83,7 @@ void ConnectionManagerImpl::initializeReadFilterCallbacks(Network::ReadFilterCal
 
   if (config_.idleTimeout()) {
     idle_timer_ = read_callbacks_->connection().dispatcher().createTimer(
-        [this]() -> void { onIdleTimeout(); });
+        [this]() -> void { onIdleTimeout(); }, Event::TimerPrecision::Coarse);
     idle_timer_->enableTimer(config_.idleTimeout().value());
   }
 
@@ -100,15 +100,14 @@ ConnectionManagerImpl::~ConnectionManagerImpl() {
     stats_.named_.downstream_cx_ssl_active_.dec();
   }
 
-  if (codec_) {
+  // The codec of a WebSocket connection may already have been released.
+  if (isOldStyleWebSocketConnection()) {
+    stats_.named_.downstream_cx_websocket_active_.dec();
+  } else if (codec_) {
     if (codec_->protocol() == Protocol::Http2) {
       stats_.named_.downstream_cx_http2_active_.dec();
     } else {
-      if (isOldStyleWebSocketConnection()) {
-        stats_.named_.downstream_cx_websocket_active_.dec();
-      } else {
-        stats_.named_.downstream_cx_http1_active_.dec();
-      }
+      stats_.named_.downstream_cx_http1_active_.dec();
     }
   }
 
@@ -117,7 +116,8 @@ ConnectionManagerImpl::~ConnectionManagerImpl() {
 }
 
 void ConnectionManagerImpl::checkForDeferredClose() {
-  if (drain_state_ == DrainState::Closing && streams_.empty() && !codec_->wantsToWrite()) {
+  if (drain_state_ == DrainState::Closing && streams_.empty() &&
+      (codec_ == nullptr || !codec_->wantsToWrite())) {
     read_callbacks_->connection().close(Network::ConnectionCloseType::FlushWrite);
   }
 }
@@ -226,8 +226,11 @@ Network::FilterStatus ConnectionManagerImpl::onData(Buffer::Instance& data, bool
     redispatch = false;
 
     try {
+      codec_dispatching_ = true;
       codec_->dispatch(data);
+      codec_dispatching_ = false;
     } catch (const CodecProtocolException& e) {
+      codec_dispatching_ = false;
       // HTTP/1.1 codec has already sent a 400 response if possible. HTTP/2 codec has already sent
       // GOAWAY.
       ENVOY_CONN_LOG(debug, "dispatch error: {}", read_callbacks_->connection(), e.what());
@@ -246,25 +249,54 @@ Network::FilterStatus ConnectionManagerImpl::onData(Buffer::Instance& data, bool
     checkForDeferredClose();
 
     // The HTTP/1 codec will pause dispatch after a single message is complete. We want to
-    // either redispatch if there are no streams and we have more data. If we have a single
-    // complete non-WebSocket stream but have not responded yet we will pause socket reads
-    // to apply back pressure.
+    // redispatch if we have more data and fewer complete streams than the allowed pipeline depth,
+    // so that pipelined requests are processed concurrently. Once that many complete
+    // non-WebSocket streams have not been responded to yet we will pause socket reads to apply
+    // back pressure. Streams are added to the front of the list, so the front stream is the last
+    // request received.
     if (codec_->protocol() != Protocol::Http2) {
+      const uint64_t max_pipelined_requests = config_.http1Settings().max_pipelined_requests_;
+      const bool last_request_complete =
+          streams_.empty() || streams_.front()->state_.remote_complete_;
       if (read_callbacks_->connection().state() == Network::Connection::State::Open &&
-          data.length() > 0 && streams_.empty()) {
+          data.length() > 0 && last_request_complete &&
+          (streams_.empty() ||
+           (streams_.size() < max_pipelined_requests && drain_state_ == DrainState::NotDraining))) {
         redispatch = true;
       }
 
-      if (!streams_.empty() && streams_.front()->state_.remote_complete_ &&
+      if (!streams_.empty() && streams_.front()->state_.remote_complete_ && !redispatch &&
+          (streams_.size() >= max_pipelined_requests || data.length() > 0) &&
           !isOldStyleWebSocketConnection()) {
         read_callbacks_->connection().readDisable(true);
       }
     }
   } while (redispatch);
 
+  maybeReleaseWebSocketCodec();
   return Network::FilterStatus::StopIteration;
 }
 
+void ConnectionManagerImpl::maybeReleaseWebSocketCodec() {
+  // The WebSocket handler proxies the upgrade response and all data that follows, so the codec,
+  // with its parser state and buffers, is never used again.
+  if (websocket_tunnel_established_ && codec_ != nullptr && !codec_dispatching_) {
+    ENVOY_CONN_LOG(debug, "websocket tunnel established, releasing codec",
+                   read_callbacks_->connection());
+    codec_.reset();
+  }
+}
+
+bool ConnectionManagerImpl::idleForTransfer() {
+  // An HTTP/1 connection between requests carries no state that the next request depends on. A
+  // connection that has not received any data yet hasn't even picked its codec.
+  if (isOldStyleWebSocketConnection() || !streams_.empty() ||
+      drain_state_ != DrainState::NotDraining) {
+    return false;
+  }
+  return codec_ == nullptr || (codec_->protocol() != Protocol::Http2 && !codec_->wantsToWrite());
+}
+
 void ConnectionManagerImpl::resetAllStreams() {
   while (!streams_.empty()) {
     // Mimic a downstream reset in this case.
@@ -376,11 +408,16 @@ ConnectionManagerImpl::ActiveStream::ActiveStream(ConnectionManagerImpl& connect
   if (connection_manager_.config_.streamIdleTimeout().count()) {
     idle_timeout_ms_ = connection_manager_.config_.streamIdleTimeout();
     idle_timer_ = connection_manager_.read_callbacks_->connection().dispatcher().createTimer(
-        [this]() -> void { onIdleTimeout(); });
+        [this]() -> void { onIdleTimeout(); }, Event::TimerPrecision::Coarse);
     resetIdleTimer();
   }
   request_info_.setRequestedServerName(
       connection_manager_.read_callbacks_->connection().requestedServerName());
+  // Carry over what listener filters learned about the connection, e.g. proxy protocol TLVs.
+  for (const auto& metadata :
+       connection_manager_.read_callbacks_->connection().dynamicMetadata().filter_metadata()) {
+    request_info_.setDynamicMetadata(metadata.first, metadata.second);
+  }
 }
 
 ConnectionManagerImpl::ActiveStream::~ActiveStream() {
@@ -401,6 +438,14 @@ ConnectionManagerImpl::ActiveStream::~ActiveStream() {
   }
 
   if (active_span_) {
+    const auto& tail_sampling = connection_manager_.config_.tracingConfig()->tail_sampling_;
+    if (tail_sampling_candidate_ && !request_info_.healthCheck() &&
+        ConnectionManagerUtility::isTailSampled(request_info_, tail_sampling.value(),
+                                                connection_manager_.runtime_,
+                                                connection_manager_.random_generator_)) {
+      connection_manager_.config_.tracingStats().tail_sampled_.inc();
+      active_span_->setSampled(true);
+    }
     Tracing::HttpTracerUtility::finalizeSpan(*active_span_, request_headers_.get(), request_info_,
                                              *this);
   }
@@ -628,7 +673,7 @@ void ConnectionManagerImpl::ActiveStream::decodeHeaders(HeaderMapPtr&& headers,
         // If we have a route-level idle timeout but no global stream idle timeout, create a timer.
         if (idle_timer_ == nullptr) {
           idle_timer_ = connection_manager_.read_callbacks_->connection().dispatcher().createTimer(
-              [this]() -> void { onIdleTimeout(); });
+              [this]() -> void { onIdleTimeout(); }, Event::TimerPrecision::Coarse);
         }
       } else if (idle_timer_ != nullptr) {
         // If we had a global stream idle timeout but the route-level idle timeout is set to zero
@@ -658,6 +703,9 @@ void ConnectionManagerImpl::ActiveStream::traceRequest() {
 
   active_span_ = connection_manager_.tracer_.startSpan(*this, *request_headers_, request_info_,
                                                        tracing_decision);
+  tail_sampling_candidate_ = !tracing_decision.traced &&
+                             tracing_decision.reason != Tracing::Reason::HealthCheck &&
+                             connection_manager_.config_.tracingConfig()->tail_sampling_;
 
   if (!active_span_) {
     return;
@@ -1218,6 +1266,18 @@ void ConnectionManagerImpl::ActiveStream::maybeEndEncode(bool end_stream) {
   }
 }
 
+void ConnectionManagerImpl::ActiveStream::onWebSocketTunnelEstablished() {
+  // The tunnel is covered by the idle timeout of the WebSocket handler rather than by the stream's,
+  // and the response encoder goes away with the codec.
+  if (idle_timer_ != nullptr) {
+    idle_timer_->disableTimer();
+    idle_timer_ = nullptr;
+  }
+  response_encoder_ = nullptr;
+  connection_manager_.websocket_tunnel_established_ = true;
+  connection_manager_.maybeReleaseWebSocketCodec();
+}
+
 void ConnectionManagerImpl::ActiveStream::onResetStream(StreamResetReason) {
   // NOTE: This function gets called in all of the following cases:
   //       1) We TX an app level reset
@@ -1272,6 +1332,15 @@ void ConnectionManagerImpl::ActiveStream::setBufferLimit(uint32_t new_limit) {
   }
 }
 
+void ConnectionManagerImpl::ActiveStream::setBufferSpillThreshold(uint32_t threshold,
+                                                                  const std::string& directory) {
+  buffer_spill_threshold_ = threshold;
+  buffer_spill_directory_ = directory;
+  if (buffered_request_data_) {
+    buffered_request_data_->setSpillThreshold(buffer_spill_threshold_, buffer_spill_directory_);
+  }
+}
+
 bool ConnectionManagerImpl::ActiveStream::createFilterChain() {
   bool upgrade_rejected = false;
   auto upgrade = request_headers_->Upgrade();
@@ -1462,6 +1531,9 @@ Buffer::WatermarkBufferPtr ConnectionManagerImpl::ActiveStreamDecoderFilter::cre
       new Buffer::WatermarkBuffer([this]() -> void { this->requestDataDrained(); },
                                   [this]() -> void { this->requestDataTooLarge(); })};
   buffer->setWatermarks(parent_.buffer_limit_);
+  if (parent_.buffer_spill_threshold_ != 0) {
+    buffer->setSpillThreshold(parent_.buffer_spill_threshold_, parent_.buffer_spill_directory_);
+  }
   return buffer;
 }
 
@@ -25,11 +25,13 @@
 #include "envoy/upstream/upstream.h"
 
 #include "common/buffer/watermark_buffer.h"
+#include "common/common/arena_impl.h"
 #include "common/common/linked_object.h"
 #include "common/grpc/common.h"
 #include "common/http/conn_manager_config.h"
 #include "common/http/user_agent.h"
 #include "common/http/utility.h"
+#include "common/memory/recycler.h"
 #include "common/request_info/request_info_impl.h"
 #include "common/tracing/http_tracer_impl.h"
 
@@ -65,6 +67,7 @@ public:
   Network::FilterStatus onData(Buffer::Instance& data, bool end_stream) override;
   Network::FilterStatus onNewConnection() override { return Network::FilterStatus::Continue; }
   void initializeReadFilterCallbacks(Network::ReadFilterCallbacks& callbacks) override;
+  bool idleForTransfer() override;
 
   // Http::ConnectionCallbacks
   void onGoAway() override;
@@ -76,10 +79,14 @@ public:
   void onEvent(Network::ConnectionEvent event) override;
   // Pass connection watermark events on to all the streams associated with that connection.
   void onAboveWriteBufferHighWatermark() override {
-    codec_->onUnderlyingConnectionAboveWriteBufferHighWatermark();
+    if (codec_) {
+      codec_->onUnderlyingConnectionAboveWriteBufferHighWatermark();
+    }
   }
   void onBelowWriteBufferLowWatermark() override {
-    codec_->onUnderlyingConnectionBelowWriteBufferLowWatermark();
+    if (codec_) {
+      codec_->onUnderlyingConnectionBelowWriteBufferLowWatermark();
+    }
   }
 
 private:
@@ -185,6 +192,9 @@ private:
     removeDownstreamWatermarkCallbacks(DownstreamWatermarkCallbacks& watermark_callbacks) override;
     void setDecoderBufferLimit(uint32_t limit) override { parent_.setBufferLimit(limit); }
     uint32_t decoderBufferLimit() override { return parent_.buffer_limit_; }
+    void setDecoderBufferSpillThreshold(uint32_t threshold, const std::string& directory) override {
+      parent_.setBufferSpillThreshold(threshold, directory);
+    }
 
     // Each decoder filter instance checks if the request passed to the filter is gRPC
     // so that we can issue gRPC local responses to gRPC requests. Filter's decodeHeaders()
@@ -256,6 +266,7 @@ private:
    */
   struct ActiveStream : LinkedObject<ActiveStream>,
                         public Event::DeferredDeletable,
+                        public Memory::Recyclable<ActiveStream>,
                         public StreamCallbacks,
                         public StreamDecoder,
                         public FilterChainFactoryCallbacks,
@@ -311,11 +322,15 @@ private:
       addStreamEncoderFilterWorker(filter, true);
     }
     void addAccessLogHandler(AccessLog::InstanceSharedPtr handler) override;
+    Arena* arena() override {
+      return connection_manager_.config_.perStreamArena() ? &arena_ : nullptr;
+    }
 
     // Http::WebSocketProxyCallbacks
     void sendHeadersOnlyResponse(HeaderMap& headers) override {
       encodeHeaders(nullptr, headers, true);
     }
+    void onWebSocketTunnelEstablished() override;
 
     // Tracing::TracingConfig
     virtual Tracing::OperationName operationName() const override;
@@ -370,6 +385,8 @@ private:
 
     // Possibly increases buffer_limit_ to the value of limit.
     void setBufferLimit(uint32_t limit);
+    // Sets the spill threshold of buffered_request_data_.
+    void setBufferSpillThreshold(uint32_t threshold, const std::string& directory);
     // Set up the Encoder/Decoder filter chain.
     bool createFilterChain();
     // Per-stream idle timeout callback.
@@ -378,6 +395,9 @@ private:
     void resetIdleTimer();
 
     ConnectionManagerImpl& connection_manager_;
+    // Declared first so that it is destroyed after the filters that may be allocated from it. It
+    // allocates no memory unless it is used.
+    ArenaImpl arena_;
     Router::ConfigConstSharedPtr snapped_route_config_;
     Tracing::SpanPtr active_span_;
     const uint64_t stream_id_;
@@ -401,12 +421,16 @@ private:
     absl::optional<Router::RouteConstSharedPtr> cached_route_;
     DownstreamWatermarkCallbacks* watermark_callbacks_{nullptr};
     uint32_t buffer_limit_{0};
+    uint32_t buffer_spill_threshold_{0};
+    std::string buffer_spill_directory_;
     uint32_t high_watermark_count_{0};
     const std::string* decorated_operation_{nullptr};
     // By default, we will assume there are no 100-Continue headers. If encode100ContinueHeaders
     // is ever called, this is set to true so commonContinue resumes processing the 100-Continue.
     bool has_continue_headers_{};
     bool is_head_request_{false};
+    // Whether the request was not traced when it started, so that its span may be tail sampled.
+    bool tail_sampling_candidate_{};
   };
 
   typedef std::unique_ptr<ActiveStream> ActiveStreamPtr;
@@ -434,6 +458,9 @@ private:
   void startDrainSequence();
 
   bool isOldStyleWebSocketConnection() const { return ws_connection_ != nullptr; }
+  // Frees the codec once the WebSocket tunnel of the connection is established, unless the codec
+  // is dispatching, in which case this is done when the dispatch returns.
+  void maybeReleaseWebSocketCodec();
 
   enum class DrainState { NotDraining, Draining, Closing };
 
@@ -454,6 +481,8 @@ private:
   const LocalInfo::LocalInfo& local_info_;
   Upstream::ClusterManager& cluster_manager_;
   WebSocketProxyPtr ws_connection_;
+  bool websocket_tunnel_established_{};
+  bool codec_dispatching_{};
   Network::ReadFilterCallbacks* read_callbacks_{};
   ConnectionManagerListenerStats& listener_stats_;
 };
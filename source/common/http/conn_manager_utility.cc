@@ -7,6 +7,7 @@
 #include "common/access_log/access_log_formatter.h"
 #include "common/common/empty_string.h"
 #include "common/common/utility.h"
+#include "common/http/codes.h"
 #include "common/http/headers.h"
 #include "common/http/utility.h"
 #include "common/network/utility.h"
@@ -189,34 +190,43 @@ void ConnectionManagerUtility::mutateTracingRequestHeader(Http::HeaderMap& reque
     return;
   }
 
-  std::string x_request_id = request_headers.RequestId()->value().c_str();
+  const absl::string_view x_request_id = request_headers.RequestId()->value().getStringView();
   uint64_t result;
   // Skip if x-request-id is corrupted.
   if (!UuidUtils::uuidModBy(x_request_id, result, 10000)) {
     return;
   }
 
+  // The decision is made on the parsed uuid and its trace status, and the header is only copied
+  // and rewritten when the status changes.
+  const UuidTraceStatus current_status = UuidUtils::isTraceableUuid(x_request_id);
+  UuidTraceStatus status = current_status;
+
   // Do not apply tracing transformations if we are currently tracing.
-  if (UuidTraceStatus::NoTrace == UuidUtils::isTraceableUuid(x_request_id)) {
+  if (UuidTraceStatus::NoTrace == current_status) {
     if (request_headers.ClientTraceId() &&
         runtime.snapshot().featureEnabled("tracing.client_enabled",
                                           config.tracingConfig()->client_sampling_)) {
-      UuidUtils::setTraceableUuid(x_request_id, UuidTraceStatus::Client);
+      status = UuidTraceStatus::Client;
     } else if (request_headers.EnvoyForceTrace()) {
-      UuidUtils::setTraceableUuid(x_request_id, UuidTraceStatus::Forced);
+      status = UuidTraceStatus::Forced;
     } else if (runtime.snapshot().featureEnabled("tracing.random_sampling",
                                                  config.tracingConfig()->random_sampling_, result,
                                                  10000)) {
-      UuidUtils::setTraceableUuid(x_request_id, UuidTraceStatus::Sampled);
+      status = UuidTraceStatus::Sampled;
     }
   }
 
   if (!runtime.snapshot().featureEnabled("tracing.global_enabled",
                                          config.tracingConfig()->overall_sampling_, result)) {
-    UuidUtils::setTraceableUuid(x_request_id, UuidTraceStatus::NoTrace);
+    status = UuidTraceStatus::NoTrace;
   }
 
-  request_headers.RequestId()->value(x_request_id);
+  if (status != current_status) {
+    std::string traceable_request_id(x_request_id);
+    UuidUtils::setTraceableUuid(traceable_request_id, status);
+    request_headers.RequestId()->value(traceable_request_id);
+  }
 }
 
 void ConnectionManagerUtility::mutateXfccRequestHeader(Http::HeaderMap& request_headers,
@@ -328,5 +338,23 @@ void ConnectionManagerUtility::mutateResponseHeaders(Http::HeaderMap& response_h
   }
 }
 
+bool ConnectionManagerUtility::isTailSampled(const RequestInfo::RequestInfo& request_info,
+                                             const TailSamplingConfig& config,
+                                             Runtime::Loader& runtime,
+                                             Runtime::RandomGenerator& random) {
+  if (config.errors_ && (!request_info.responseCode() ||
+                         Http::CodeUtility::is5xx(request_info.responseCode().value()))) {
+    return true;
+  }
+
+  if (config.latency_threshold_ && request_info.requestComplete() &&
+      request_info.requestComplete().value() > config.latency_threshold_.value()) {
+    return true;
+  }
+
+  return runtime.snapshot().featureEnabled("tracing.tail_random_sampling", config.random_sampling_,
+                                           random.random(), 10000);
+}
+
 } // namespace Http
 } // namespace Envoy
@@ -36,6 +36,18 @@ public:
   static void mutateResponseHeaders(Http::HeaderMap& response_headers,
                                     const Http::HeaderMap* request_headers, const std::string& via);
 
+  /**
+   * Decides whether a completed request which was not traced when it started is tail sampled.
+   * @param request_info supplies the request info of the completed request.
+   * @param config supplies the tail sampling configuration.
+   * @param runtime supplies the runtime used for the random sampling.
+   * @param random supplies the random generator used for the random sampling.
+   * @return bool whether the span of the request should be reported.
+   */
+  static bool isTailSampled(const RequestInfo::RequestInfo& request_info,
+                            const TailSamplingConfig& config, Runtime::Loader& runtime,
+                            Runtime::RandomGenerator& random);
+
 private:
   /**
    * Mutate request headers if request needs to be traced.
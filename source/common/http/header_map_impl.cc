@@ -16,6 +16,8 @@ namespace Http {
 
 namespace {
 constexpr size_t MinDynamicCapacity{32};
+// Initial number of HeaderIndex slots. Must be a power of 2 and at least twice IndexMinHeaders.
+constexpr size_t InitialIndexSlots{32};
 // This includes the NULL (StringUtil::itoa technically only needs 21).
 constexpr size_t MaxIntegerLength{32};
 
@@ -23,6 +25,8 @@ uint64_t newCapacity(uint32_t existing_capacity, uint32_t size_to_append) {
   return (static_cast<uint64_t>(existing_capacity) + size_to_append) * 2;
 }
 
+typedef Buffer::SliceReferenceSharedPtr SliceReference;
+
 void validateCapacity(uint64_t new_capacity) {
   // If the resizing will cause buffer overflow due to hitting uint32_t::max, an OOM is likely
   // imminent. Fast-fail rather than allow a buffer overflow attack (issue #1421)
@@ -50,6 +54,14 @@ HeaderString::HeaderString(const std::string& ref_value) : type_(Type::Reference
   string_length_ = ref_value.size();
 }
 
+HeaderString::HeaderString(absl::string_view ref_value, SliceReference owner)
+    : type_(Type::Pinned) {
+  ASSERT(ref_value.data()[ref_value.size()] == 0);
+  buffer_.ref_ = ref_value.data();
+  string_length_ = ref_value.size();
+  new (&owner_) SliceReference(std::move(owner));
+}
+
 HeaderString::HeaderString(HeaderString&& move_value) {
   type_ = move_value.type_;
   string_length_ = move_value.string_length_;
@@ -58,6 +70,16 @@ HeaderString::HeaderString(HeaderString&& move_value) {
     buffer_.ref_ = move_value.buffer_.ref_;
     break;
   }
+  case Type::Pinned: {
+    // The owner moves along with the reference, so the moved header goes back to its default
+    // state (inline) rather than referencing memory it no longer keeps alive.
+    buffer_.ref_ = move_value.buffer_.ref_;
+    new (&owner_) SliceReference(move_value.releaseOwner());
+    move_value.type_ = Type::Inline;
+    move_value.buffer_.dynamic_ = move_value.inline_buffer_;
+    move_value.clear();
+    break;
+  }
   case Type::Dynamic: {
     // When we move a dynamic header, we switch the moved header back to its default state (inline).
     buffer_.dynamic_ = move_value.buffer_.dynamic_;
@@ -77,7 +99,10 @@ HeaderString::HeaderString(HeaderString&& move_value) {
   }
 }
 
-HeaderString::~HeaderString() { freeDynamic(); }
+HeaderString::~HeaderString() {
+  freeDynamic();
+  releaseOwner();
+}
 
 void HeaderString::freeDynamic() {
   if (type_ == Type::Dynamic) {
@@ -85,8 +110,21 @@ void HeaderString::freeDynamic() {
   }
 }
 
+SliceReference HeaderString::releaseOwner() {
+  if (type_ != Type::Pinned) {
+    return nullptr;
+  }
+  // This only destroys the owner's storage; the caller is responsible for changing type_.
+  SliceReference owner = std::move(owner_);
+  owner_.~SliceReference();
+  return owner;
+}
+
 void HeaderString::append(const char* data, uint32_t size) {
+  // Keep pinned memory alive until the copy below is done, in case data points into it.
+  const SliceReference owner = releaseOwner();
   switch (type_) {
+  case Type::Pinned:
   case Type::Reference: {
     // Rather than be too clever and optimize this uncommon case, we dynamically
     // allocate and copy.
@@ -146,6 +184,7 @@ void HeaderString::append(const char* data, uint32_t size) {
 
 void HeaderString::clear() {
   switch (type_) {
+  case Type::Pinned:
   case Type::Reference: {
     break;
   }
@@ -160,7 +199,10 @@ void HeaderString::clear() {
 }
 
 void HeaderString::setCopy(const char* data, uint32_t size) {
+  // Keep pinned memory alive until the copy below is done, in case data points into it.
+  const SliceReference owner = releaseOwner();
   switch (type_) {
+  case Type::Pinned:
   case Type::Reference: {
     // Switch back to inline and fall through.
     type_ = Type::Inline;
@@ -205,7 +247,9 @@ void HeaderString::setCopy(const char* data, uint32_t size) {
 }
 
 void HeaderString::setInteger(uint64_t value) {
+  releaseOwner();
   switch (type_) {
+  case Type::Pinned:
   case Type::Reference: {
     // Switch back to inline and fall through.
     type_ = Type::Inline;
@@ -231,11 +275,23 @@ void HeaderString::setInteger(uint64_t value) {
 
 void HeaderString::setReference(const std::string& ref_value) {
   freeDynamic();
+  releaseOwner();
   type_ = Type::Reference;
   buffer_.ref_ = ref_value.c_str();
   string_length_ = ref_value.size();
 }
 
+void HeaderString::setPinned(absl::string_view ref_value, SliceReference owner) {
+  ASSERT(ref_value.data()[ref_value.size()] == 0);
+  freeDynamic();
+  // The previous owner may also be keeping ref_value alive, so release it last.
+  const SliceReference previous_owner = releaseOwner();
+  type_ = Type::Pinned;
+  buffer_.ref_ = ref_value.data();
+  string_length_ = ref_value.size();
+  new (&owner_) SliceReference(std::move(owner));
+}
+
 // Specialization needed for HeaderMapImpl::HeaderList::insert() when key is LowerCaseString.
 // A fully specialized template must be defined once in the program, hence this may not be in
 // a header file.
@@ -308,6 +364,82 @@ HeaderMapImpl::StaticLookupTable::find(const char* key) const {
   return current->cb_;
 }
 
+constexpr size_t HeaderMapImpl::IndexMinHeaders;
+
+HeaderMapImpl::HeaderEntryImpl* HeaderMapImpl::HeaderIndex::find(absl::string_view key,
+                                                                 uint64_t hash) const {
+  ASSERT(active());
+  const size_t mask = slots_.size() - 1;
+  for (size_t i = hash & mask; slots_[i] != nullptr; i = (i + 1) & mask) {
+    if (slots_[i]->hash_ == hash && slots_[i]->key().getStringView() == key) {
+      return slots_[i];
+    }
+  }
+
+  return nullptr;
+}
+
+void HeaderMapImpl::HeaderIndex::insert(HeaderEntryImpl& entry) {
+  // Keep the load factor at or below 1/2 so that probe runs stay short.
+  if ((used_ + 1) * 2 > slots_.size()) {
+    grow();
+  }
+
+  const size_t mask = slots_.size() - 1;
+  size_t i = entry.hash_ & mask;
+  for (; slots_[i] != nullptr; i = (i + 1) & mask) {
+    if (slots_[i]->hash_ == entry.hash_ &&
+        slots_[i]->key().getStringView() == entry.key().getStringView()) {
+      return;
+    }
+  }
+
+  slots_[i] = &entry;
+  used_++;
+}
+
+void HeaderMapImpl::HeaderIndex::erase(absl::string_view key, uint64_t hash) {
+  const size_t mask = slots_.size() - 1;
+  size_t i = hash & mask;
+  while (true) {
+    if (slots_[i] == nullptr) {
+      return;
+    }
+    if (slots_[i]->hash_ == hash && slots_[i]->key().getStringView() == key) {
+      break;
+    }
+    i = (i + 1) & mask;
+  }
+
+  // Move later members of the probe run back into the hole so that find() does not stop early. An
+  // entry may move to the hole if the hole is no closer to it than its home slot.
+  for (size_t j = (i + 1) & mask; slots_[j] != nullptr; j = (j + 1) & mask) {
+    const size_t home = slots_[j]->hash_ & mask;
+    if (((j - home) & mask) >= ((j - i) & mask)) {
+      slots_[i] = slots_[j];
+      i = j;
+    }
+  }
+
+  slots_[i] = nullptr;
+  used_--;
+}
+
+void HeaderMapImpl::HeaderIndex::grow() {
+  std::vector<HeaderEntryImpl*> old_slots = std::move(slots_);
+  slots_.assign(old_slots.empty() ? InitialIndexSlots : old_slots.size() * 2, nullptr);
+  const size_t mask = slots_.size() - 1;
+  for (HeaderEntryImpl* entry : old_slots) {
+    if (entry != nullptr) {
+      size_t i = entry->hash_ & mask;
+      while (slots_[i] != nullptr) {
+        i = (i + 1) & mask;
+      }
+      slots_[i] = entry;
+    }
+  }
+}
+
 void HeaderMapImpl::appendToHeader(HeaderString& header, absl::string_view data) {
   if (data.empty()) {
     return;
@@ -362,6 +494,25 @@ bool HeaderMapImpl::operator==(const HeaderMapImpl& rhs) const {
   return true;
 }
 
+void HeaderMapImpl::onInsert(HeaderEntryImpl& entry) {
+  if (index_.active()) {
+    entry.hash_ = HashUtil::xxHash64(entry.key().getStringView());
+    index_.insert(entry);
+  } else if (headers_.size() >= IndexMinHeaders) {
+    // Index in list order so that the first entry for each name wins.
+    for (HeaderEntryImpl& header : headers_) {
+      header.hash_ = HashUtil::xxHash64(header.key().getStringView());
+      index_.insert(header);
+    }
+  }
+}
+
+void HeaderMapImpl::onRemove(const HeaderEntryImpl& entry) {
+  if (index_.active()) {
+    index_.erase(entry.key().getStringView(), entry.hash_);
+  }
+}
+
 void HeaderMapImpl::insertByKey(HeaderString&& key, HeaderString&& value) {
   StaticLookupEntry::EntryCb cb = ConstSingleton<StaticLookupTable>::get().find(key.c_str());
   if (cb) {
@@ -376,6 +527,7 @@ void HeaderMapImpl::insertByKey(HeaderString&& key, HeaderString&& value) {
   } else {
     std::list<HeaderEntryImpl>::iterator i = headers_.insert(std::move(key), std::move(value));
     i->entry_ = i;
+    onInsert(*i);
   }
 }
 
@@ -473,6 +625,10 @@ uint64_t HeaderMapImpl::byteSize() const {
 }
 
 const HeaderEntry* HeaderMapImpl::get(const LowerCaseString& key) const {
+  if (index_.active()) {
+    return index_.find(key.get(), key.hash());
+  }
+
   for (const HeaderEntryImpl& header : headers_) {
     if (header.key() == key.get().c_str()) {
       return &header;
@@ -483,6 +639,10 @@ const HeaderEntry* HeaderMapImpl::get(const LowerCaseString& key) const {
 }
 
 HeaderEntry* HeaderMapImpl::get(const LowerCaseString& key) {
+  if (index_.active()) {
+    return index_.find(key.get(), key.hash());
+  }
+
   for (HeaderEntryImpl& header : headers_) {
     if (header.key() == key.get().c_str()) {
       return &header;
@@ -536,6 +696,21 @@ void HeaderMapImpl::remove(const LowerCaseString& key) {
   if (cb) {
     StaticLookupResponse ref_lookup_response = cb(*this);
     removeInline(ref_lookup_response.entry_);
+  } else if (index_.active()) {
+    HeaderEntryImpl* entry = index_.find(key.get(), key.hash());
+    if (entry == nullptr) {
+      return;
+    }
+
+    onRemove(*entry);
+    // Entries with the same name as the first one can only follow it in the list.
+    for (auto i = entry->entry_; i != headers_.end();) {
+      if (i->key() == key.get().c_str()) {
+        i = headers_.erase(i);
+      } else {
+        ++i;
+      }
+    }
   } else {
     for (auto i = headers_.begin(); i != headers_.end();) {
       if (i->key() == key.get().c_str()) {
@@ -551,6 +726,7 @@ void HeaderMapImpl::removePrefix(const LowerCaseString& prefix) {
   headers_.remove_if([&](const HeaderEntryImpl& entry) {
     bool to_remove = absl::StartsWith(entry.key().getStringView(), prefix.get());
     if (to_remove) {
+      onRemove(entry);
       // If this header should be removed, make sure any references in the
       // static lookup table are cleared as well.
       StaticLookupEntry::EntryCb cb =
@@ -575,6 +751,7 @@ HeaderMapImpl::HeaderEntryImpl& HeaderMapImpl::maybeCreateInline(HeaderEntryImpl
   std::list<HeaderEntryImpl>::iterator i = headers_.insert(key);
   i->entry_ = i;
   *entry = &(*i);
+  onInsert(*i);
   return **entry;
 }
 
@@ -589,6 +766,7 @@ HeaderMapImpl::HeaderEntryImpl& HeaderMapImpl::maybeCreateInline(HeaderEntryImpl
   std::list<HeaderEntryImpl>::iterator i = headers_.insert(key, std::move(value));
   i->entry_ = i;
   *entry = &(*i);
+  onInsert(*i);
   return **entry;
 }
 
@@ -608,6 +786,7 @@ void HeaderMapImpl::removeInline(HeaderEntryImpl** ptr_to_entry) {
 
   HeaderEntryImpl* entry = *ptr_to_entry;
   *ptr_to_entry = nullptr;
+  onRemove(*entry);
   headers_.erase(entry->entry_);
 }
 
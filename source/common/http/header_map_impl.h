@@ -5,6 +5,7 @@
 #include <list>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "envoy/http/header_map.h"
 
@@ -32,8 +33,9 @@ public:
  * Implementation of Http::HeaderMap. This is heavily optimized for performance. Roughly, when
  * headers are added to the map, we do a hash lookup to see if it's one of the O(1) headers.
  * If it is, we store a reference to it that can be accessed later directly. Most high performance
- * paths use O(1) direct access. In general, we try to copy as little as possible and allocate as
- * little as possible in any of the paths.
+ * paths use O(1) direct access. Once a map holds enough headers, the other headers are found
+ * through a hash index rather than by walking the list. In general, we try to copy as little as
+ * possible and allocate as little as possible in any of the paths.
  */
 class HeaderMapImpl : public HeaderMap, NonCopyable {
 public:
@@ -102,6 +104,8 @@ protected:
     HeaderString key_;
     HeaderString value_;
     std::list<HeaderEntryImpl>::iterator entry_;
+    // Hash of key_, only set once the entry has been added to a HeaderIndex.
+    uint64_t hash_{};
   };
 
   struct StaticLookupResponse {
@@ -193,6 +197,34 @@ protected:
     std::list<HeaderEntryImpl>::iterator pseudo_headers_end_;
   };
 
+  /**
+   * Open addressed (linear probing) index from header name to the first entry in the list with
+   * that name. On maps with many headers this replaces the list walk in get() and remove(). Every
+   * removal path removes all entries with a given name at once, so only the first entry for each
+   * name is indexed.
+   */
+  class HeaderIndex : NonCopyable {
+  public:
+    bool active() const { return !slots_.empty(); }
+    HeaderEntryImpl* find(absl::string_view key, uint64_t hash) const;
+    // Indexes entry unless an entry with the same name is already indexed.
+    void insert(HeaderEntryImpl& entry);
+    // Drops the entry indexed for key, which the caller has removed with all its duplicates.
+    void erase(absl::string_view key, uint64_t hash);
+
+  private:
+    void grow();
+
+    std::vector<HeaderEntryImpl*> slots_;
+    size_t used_{};
+  };
+
+  // Maps with at least this many headers are indexed. Smaller maps are searched linearly, which
+  // is faster than hashing.
+  static constexpr size_t IndexMinHeaders = 8;
+
+  void onInsert(HeaderEntryImpl& entry);
+  void onRemove(const HeaderEntryImpl& entry);
   void insertByKey(HeaderString&& key, HeaderString&& value);
   HeaderEntryImpl& maybeCreateInline(HeaderEntryImpl** entry, const LowerCaseString& key);
   HeaderEntryImpl& maybeCreateInline(HeaderEntryImpl** entry, const LowerCaseString& key,
@@ -203,6 +235,7 @@ protected:
 
   AllInlineHeaders inline_headers_;
   HeaderList headers_;
+  HeaderIndex index_;
 
   ALL_INLINE_HEADERS(DEFINE_INLINE_HEADER_FUNCS)
 };
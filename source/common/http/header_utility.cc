@@ -1,5 +1,6 @@
 #include "common/http/header_utility.h"
 
+#include "common/common/regex.h"
 #include "common/common/utility.h"
 #include "common/config/rds_json.h"
 #include "common/http/header_map_impl.h"
@@ -31,7 +32,11 @@ HeaderUtility::HeaderData::HeaderData(const envoy::api::v2::route::HeaderMatcher
     break;
   case envoy::api::v2::route::HeaderMatcher::kRegexMatch:
     header_match_type_ = HeaderMatchType::Regex;
-    regex_pattern_ = RegexUtil::parseRegex(config.regex_match());
+    regex_ = Regex::Utility::parseStdRegexAsCompiledMatcher(config.regex_match());
+    break;
+  case envoy::api::v2::route::HeaderMatcher::kSafeRegexMatch:
+    header_match_type_ = HeaderMatchType::Regex;
+    regex_ = Regex::Utility::parseRegex(config.safe_regex_match());
     break;
   case envoy::api::v2::route::HeaderMatcher::kRangeMatch:
     header_match_type_ = HeaderMatchType::Range;
@@ -92,7 +97,7 @@ bool HeaderUtility::matchHeaders(const Http::HeaderMap& request_headers,
     match = header_data.value_.empty() || header->value() == header_data.value_.c_str();
     break;
   case HeaderMatchType::Regex:
-    match = std::regex_match(header->value().c_str(), header_data.regex_pattern_);
+    match = header_data.regex_->match(header->value().getStringView());
     break;
   case HeaderMatchType::Range: {
     int64_t header_value = 0;
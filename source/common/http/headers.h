@@ -24,6 +24,7 @@ public:
   const LowerCaseString AccessControlExposeHeaders{"access-control-expose-headers"};
   const LowerCaseString AccessControlMaxAge{"access-control-max-age"};
   const LowerCaseString AccessControlAllowCredentials{"access-control-allow-credentials"};
+  const LowerCaseString Age{"age"};
   const LowerCaseString Authorization{"authorization"};
   const LowerCaseString CacheControl{"cache-control"};
   const LowerCaseString ClientTraceId{"x-client-trace-id"};
@@ -68,6 +69,7 @@ public:
   const LowerCaseString GrpcAcceptEncoding{"grpc-accept-encoding"};
   const LowerCaseString Host{":authority"};
   const LowerCaseString HostLegacy{"host"};
+  const LowerCaseString IfNoneMatch{"if-none-match"};
   const LowerCaseString KeepAlive{"keep-alive"};
   const LowerCaseString LastModified{"last-modified"};
   const LowerCaseString Location{"location"};
@@ -125,6 +127,7 @@ public:
     const std::string GrpcWebText{"application/grpc-web-text"};
     const std::string GrpcWebTextProto{"application/grpc-web-text+proto"};
     const std::string Json{"application/json"};
+    const std::string Protobuf{"application/x-protobuf"};
   } ContentTypeValues;
 
   struct {
@@ -164,6 +167,9 @@ public:
     const std::string Head{"HEAD"};
     const std::string Post{"POST"};
     const std::string Options{"OPTIONS"};
+    const std::string Put{"PUT"};
+    const std::string Delete{"DELETE"};
+    const std::string Trace{"TRACE"};
   } MethodValues;
 
   struct {
@@ -210,6 +216,7 @@ public:
   } AcceptEncodingValues;
 
   struct {
+    const std::string Deflate{"deflate"};
     const std::string Gzip{"gzip"};
   } ContentEncodingValues;
 
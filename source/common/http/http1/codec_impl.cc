@@ -7,6 +7,7 @@
 #include "envoy/http/header_map.h"
 #include "envoy/network/connection.h"
 
+#include "common/common/ascii.h"
 #include "common/common/enum_to_int.h"
 #include "common/common/fmt.h"
 #include "common/common/utility.h"
@@ -18,6 +19,22 @@ namespace Envoy {
 namespace Http {
 namespace Http1 {
 
+namespace {
+
+// The headers whose values http_parser uses to frame the body and control the connection.
+bool isFramingHeader(absl::string_view name) {
+  return AsciiUtil::caseEqual(name, "content-length") ||
+         AsciiUtil::caseEqual(name, "transfer-encoding") ||
+         AsciiUtil::caseEqual(name, "connection") ||
+         AsciiUtil::caseEqual(name, "proxy-connection") || AsciiUtil::caseEqual(name, "upgrade");
+}
+
+// Header values of a scanned header block that are at least this long are pinned in the read
+// buffer. Shorter values fit the inline storage of their HeaderString and are cheaper to copy.
+constexpr size_t MinPinnedHeaderValueSize{128};
+
+} // namespace
+
 const std::string StreamEncoderImpl::CRLF = "\r\n";
 const std::string StreamEncoderImpl::LAST_CHUNK = "0\r\n\r\n";
 
@@ -119,7 +136,7 @@ void StreamEncoderImpl::encodeHeaders(const HeaderMap& headers, bool end_stream)
   if (end_stream) {
     endEncode();
   } else {
-    connection_.flushOutput();
+    flushOutput(false);
   }
 }
 
@@ -141,7 +158,7 @@ void StreamEncoderImpl::encodeData(Buffer::Instance& data, bool end_stream) {
   if (end_stream) {
     endEncode();
   } else {
-    connection_.flushOutput();
+    flushOutput(false);
   }
 }
 
@@ -152,21 +169,69 @@ void StreamEncoderImpl::endEncode() {
     connection_.buffer().add(LAST_CHUNK);
   }
 
-  connection_.flushOutput();
-  connection_.onEncodeComplete();
+  flushOutput(true);
+  onEncodeComplete();
 }
 
-void ConnectionImpl::flushOutput() {
+void StreamEncoderImpl::flushOutput(bool end_of_message) {
+  if (end_of_message) {
+    connection_.flushOutput();
+  } else {
+    connection_.flushOutputSoon();
+  }
+}
+
+void StreamEncoderImpl::onEncodeComplete() { connection_.onEncodeComplete(); }
+
+void ConnectionImpl::commitReservedBuffer() {
   if (reserved_current_) {
     reserved_iovec_.len_ = reserved_current_ - static_cast<char*>(reserved_iovec_.mem_);
     output_buffer_.commit(&reserved_iovec_, 1);
     reserved_current_ = nullptr;
   }
+}
 
+void ConnectionImpl::flushOutput() {
+  commitReservedBuffer();
+  if (flush_pending_) {
+    flush_pending_ = false;
+    flush_timer_->disableTimer();
+  }
   connection().write(output_buffer_, false);
   ASSERT(0UL == output_buffer_.length());
 }
 
+void ConnectionImpl::flushOutputSoon() {
+  // Past this, holding the output back saves little next to the memory it takes.
+  static const uint64_t MaxCoalescedOutputBytes = 16384;
+
+  commitReservedBuffer();
+  if (!coalesce_writes_ || output_buffer_.length() >= MaxCoalescedOutputBytes) {
+    flushOutput();
+    return;
+  }
+
+  if (!flush_pending_) {
+    flush_pending_ = true;
+    if (flush_timer_ == nullptr) {
+      flush_timer_ = connection_.dispatcher().createTimer([this]() -> void { onFlushTimer(); });
+    }
+    flush_timer_->enableTimer(std::chrono::milliseconds(0));
+  }
+}
+
+void ConnectionImpl::onFlushTimer() {
+  flush_pending_ = false;
+  if (connection_.state() == Network::Connection::State::Open) {
+    flushOutput();
+  }
+}
+
+void ConnectionImpl::flushOutput(Buffer::Instance& output) {
+  commitReservedBuffer();
+  output.move(output_buffer_);
+}
+
 void ConnectionImpl::addCharToBuffer(char c) {
   ASSERT(bufferRemainingSize() >= 1);
   *reserved_current_++ = c;
@@ -236,6 +301,42 @@ void ResponseStreamEncoderImpl::encodeHeaders(const HeaderMap& headers, bool end
   StreamEncoderImpl::encodeHeaders(headers, end_stream);
 }
 
+void ResponseStreamEncoderImpl::resumeOutput() {
+  ASSERT(deferred_output_ != nullptr);
+  std::unique_ptr<Buffer::OwnedImpl> output = std::move(deferred_output_);
+  connection_.connection().write(*output, false);
+  if (deferred_above_high_watermark_) {
+    deferred_above_high_watermark_ = false;
+    runLowWatermarkCallbacks();
+  }
+}
+
+void ResponseStreamEncoderImpl::flushOutput(bool end_of_message) {
+  if (deferred_output_ == nullptr) {
+    StreamEncoderImpl::flushOutput(end_of_message);
+    return;
+  }
+
+  connection_.flushOutput(*deferred_output_);
+  // Push back on a held back response that grows past the connection's buffer limit, as the
+  // connection would if the response had been written to it.
+  const uint32_t limit = bufferLimit();
+  if (limit > 0 && deferred_output_->length() > limit && !deferred_above_high_watermark_) {
+    deferred_above_high_watermark_ = true;
+    runHighWatermarkCallbacks();
+  }
+}
+
+void ResponseStreamEncoderImpl::onEncodeComplete() {
+  encode_complete_ = true;
+  // The stream may go away while its response is held back, so its watermark callbacks must not run
+  // any more. Reset callbacks still run if the request is still being received.
+  local_end_stream_ = true;
+  if (deferred_output_ == nullptr) {
+    StreamEncoderImpl::onEncodeComplete();
+  }
+}
+
 static const char REQUEST_POSTFIX[] = " HTTP/1.1\r\n";
 
 void RequestStreamEncoderImpl::encodeHeaders(const HeaderMap& headers, bool end_stream) {
@@ -290,11 +391,6 @@ http_parser_settings ConnectionImpl::settings_{
     nullptr  // on_chunk_complete
 };
 
-const ToLowerTable& ConnectionImpl::toLowerTable() {
-  static ToLowerTable* table = new ToLowerTable();
-  return *table;
-}
-
 ConnectionImpl::ConnectionImpl(Network::Connection& connection, http_parser_type type)
     : connection_(connection), output_buffer_([&]() -> void { this->onBelowLowWatermark(); },
                                               [&]() -> void { this->onAboveHighWatermark(); }) {
@@ -307,7 +403,7 @@ void ConnectionImpl::completeLastHeader() {
   ENVOY_CONN_LOG(trace, "completed header: key={} value={}", connection_,
                  current_header_field_.c_str(), current_header_value_.c_str());
   if (!current_header_field_.empty()) {
-    toLowerTable().toLowerCase(current_header_field_.buffer(), current_header_field_.size());
+    AsciiUtil::toLowerCase(current_header_field_.buffer(), current_header_field_.size());
     current_header_map_->addViaMove(std::move(current_header_field_),
                                     std::move(current_header_value_));
   }
@@ -347,6 +443,7 @@ void ConnectionImpl::dispatch(Buffer::Instance& data) {
   http_parser_pause(&parser_, 0);
 
   ssize_t total_parsed = 0;
+  dispatch_buffer_ = &data;
   if (data.length() > 0) {
     uint64_t num_slices = data.getRawSlices(nullptr, 0);
     Buffer::RawSlice slices[num_slices];
@@ -357,6 +454,7 @@ void ConnectionImpl::dispatch(Buffer::Instance& data) {
   } else {
     dispatchSlice(nullptr, 0);
   }
+  dispatch_buffer_ = nullptr;
 
   ENVOY_CONN_LOG(trace, "parsed {} bytes", connection_, total_parsed);
   data.drain(total_parsed);
@@ -364,22 +462,79 @@ void ConnectionImpl::dispatch(Buffer::Instance& data) {
   // If an upgrade has been handled and there is body data or early upgrade
   // payload to send on, send it on.
   maybeDirectDispatch(data);
+
+  // Output encoded while dispatching, e.g. a local reply, needn't wait for the event loop.
+  if (flush_pending_) {
+    flushOutput();
+  }
 }
 
 size_t ConnectionImpl::dispatchSlice(const char* slice, size_t len) {
-  ssize_t rc = http_parser_execute(&parser_, &settings_, slice, len);
+  size_t parsed = 0;
+  do {
+    size_t rc = 0;
+    if (fast_header_parsing_ && at_message_start_ && !handling_upgrade_) {
+      rc = dispatchHeaderBlock(slice + parsed, len - parsed);
+    }
+    if (rc == 0) {
+      rc = http_parser_execute(&parser_, &settings_, slice + parsed, len - parsed);
+      checkParserError();
+    }
+    parsed += rc;
+
+    // With fast header parsing the parser stops after every message so that the next header block
+    // can be scanned. Any other pause ends the slice.
+    if (!paused_at_message_end_) {
+      break;
+    }
+    paused_at_message_end_ = false;
+    http_parser_pause(&parser_, 0);
+  } while (parsed < len);
+
+  return parsed;
+}
+
+size_t ConnectionImpl::dispatchHeaderBlock(const char* data, size_t len) {
+  size_t request_line_length;
+  const size_t block_length = HeaderBlockScanner::scan(
+      absl::string_view(data, std::min<size_t>(len, HTTP_MAX_HEADER_SIZE)), request_line_length,
+      header_block_);
+  if (block_length == 0) {
+    return 0;
+  }
+
+  header_block_data_ = absl::string_view(data, block_length);
+  header_block_framing_.assign(data, request_line_length);
+  for (const HeaderBlockScanner::Header& header : header_block_) {
+    if (isFramingHeader(header.name_)) {
+      header_block_framing_.append(header.line_.data(), header.line_.size());
+    }
+  }
+  header_block_framing_.append("\r\n");
+
+  ENVOY_CONN_LOG(trace, "scanned header block of {} bytes", connection_, block_length);
+  dispatching_header_block_ = true;
+  const size_t rc = http_parser_execute(&parser_, &settings_, header_block_framing_.data(),
+                                        header_block_framing_.size());
+  dispatching_header_block_ = false;
+  checkParserError();
+  // The parser only pauses once the headers are complete, so the whole block has been consumed.
+  ASSERT(rc == header_block_framing_.size() || HTTP_PARSER_ERRNO(&parser_) == HPE_PAUSED);
+  UNREFERENCED_PARAMETER(rc);
+  return block_length;
+}
+
+void ConnectionImpl::checkParserError() {
   if (HTTP_PARSER_ERRNO(&parser_) != HPE_OK && HTTP_PARSER_ERRNO(&parser_) != HPE_PAUSED) {
     sendProtocolError();
     throw CodecProtocolException("http/1.1 protocol error: " +
                                  std::string(http_errno_name(HTTP_PARSER_ERRNO(&parser_))));
   }
-
-  return rc;
 }
 
 void ConnectionImpl::onHeaderField(const char* data, size_t length) {
-  if (header_parsing_state_ == HeaderParsingState::Done) {
-    // Ignore trailers.
+  if (header_parsing_state_ == HeaderParsingState::Done || dispatching_header_block_) {
+    // Ignore trailers, and the framing headers of a scanned header block.
     return;
   }
 
@@ -391,8 +546,8 @@ void ConnectionImpl::onHeaderField(const char* data, size_t length) {
 }
 
 void ConnectionImpl::onHeaderValue(const char* data, size_t length) {
-  if (header_parsing_state_ == HeaderParsingState::Done) {
-    // Ignore trailers.
+  if (header_parsing_state_ == HeaderParsingState::Done || dispatching_header_block_) {
+    // Ignore trailers, and the framing headers of a scanned header block.
     return;
   }
 
@@ -402,7 +557,32 @@ void ConnectionImpl::onHeaderValue(const char* data, size_t length) {
 
 int ConnectionImpl::onHeadersCompleteBase() {
   ENVOY_CONN_LOG(trace, "headers complete", connection_);
-  completeLastHeader();
+  if (dispatching_header_block_) {
+    // http_parser has only seen the framing headers; add every header of the block in order.
+    Buffer::SliceReferenceSharedPtr pin;
+    bool pin_attempted = false;
+    for (const HeaderBlockScanner::Header& header : header_block_) {
+      current_header_field_.setCopy(header.name_.data(), header.name_.size());
+      if (header.value_.size() >= MinPinnedHeaderValueSize && !pin_attempted) {
+        pin = dispatch_buffer_->pin(header_block_data_.data(), header_block_data_.size());
+        pin_attempted = true;
+      }
+      if (header.value_.size() >= MinPinnedHeaderValueSize && pin != nullptr) {
+        // Reference the value in the read buffer. The scanner has already checked the CR that
+        // ends it, and http_parser only looks at the framing copy, so the CR can be overwritten
+        // to null terminate the value in place.
+        const_cast<char*>(header.value_.data())[header.value_.size()] = '\0';
+        current_header_value_.setPinned(header.value_, pin);
+      } else {
+        current_header_value_.setCopy(header.value_.data(), header.value_.size());
+      }
+      header_parsing_state_ = HeaderParsingState::Value;
+      completeLastHeader();
+    }
+    dispatching_header_block_ = false;
+  } else {
+    completeLastHeader();
+  }
   if (!(parser_.http_major == 1 && parser_.http_minor == 1)) {
     // This is not necessarily true, but it's good enough since higher layers only care if this is
     // HTTP/1.1 or not.
@@ -432,6 +612,14 @@ void ConnectionImpl::onMessageCompleteBase() {
     return;
   }
   onMessageComplete();
+  at_message_start_ = true;
+  // If onMessageComplete() paused the parser, dispatch must stop here rather than go on to the next
+  // message.
+  if (fast_header_parsing_ && HTTP_PARSER_ERRNO(&parser_) != HPE_PAUSED) {
+    ENVOY_CONN_LOG(trace, "Pausing parser at message end.", connection_);
+    paused_at_message_end_ = true;
+    http_parser_pause(&parser_, 1);
+  }
 }
 
 void ConnectionImpl::onMessageBeginBase() {
@@ -439,6 +627,7 @@ void ConnectionImpl::onMessageBeginBase() {
   ASSERT(!current_header_map_);
   current_header_map_.reset(new HeaderMapImpl());
   header_parsing_state_ = HeaderParsingState::Field;
+  at_message_start_ = false;
   onMessageBegin();
 }
 
@@ -451,15 +640,38 @@ void ConnectionImpl::onResetStreamBase(StreamResetReason reason) {
 ServerConnectionImpl::ServerConnectionImpl(Network::Connection& connection,
                                            ServerConnectionCallbacks& callbacks,
                                            Http1Settings settings)
-    : ConnectionImpl(connection, HTTP_REQUEST), callbacks_(callbacks), codec_settings_(settings) {}
+    : ConnectionImpl(connection, HTTP_REQUEST), callbacks_(callbacks), codec_settings_(settings) {
+  fast_header_parsing_ = codec_settings_.fast_header_parsing_;
+  // Pipelined responses are encoded into the same output buffer while the responses before them
+  // are written, so output can only be held back when responses are encoded one at a time.
+  coalesce_writes_ =
+      codec_settings_.coalesce_response_writes_ && codec_settings_.max_pipelined_requests_ == 1;
+}
 
 void ServerConnectionImpl::onEncodeComplete() {
-  ASSERT(active_request_);
-  if (active_request_->remote_complete_) {
-    // Only do this if remote is complete. If we are replying before the request is complete the
-    // only logical thing to do is for higher level code to reset() / close the connection so we
-    // leave the request around so that it can fire reset callbacks.
-    active_request_.reset();
+  ASSERT(!active_requests_.empty());
+  if (!active_requests_.front()->remote_complete_) {
+    // Only remove the request if remote is complete. If we are replying before the request is
+    // complete the only logical thing to do is for higher level code to reset() / close the
+    // connection so we leave the request around so that it can fire reset callbacks.
+    return;
+  }
+  active_requests_.pop_front();
+
+  // Write the held back responses to pipelined requests, up to the first one still being encoded.
+  while (!active_requests_.empty()) {
+    ActiveRequest& request = *active_requests_.front();
+    // Writing may take the connection over its high watermark, which is then raised on this
+    // response since it is now the first.
+    const bool above_high_watermark = above_high_watermark_;
+    request.response_encoder_.resumeOutput();
+    if (!request.response_encoder_.encodeComplete() || !request.remote_complete_) {
+      if (above_high_watermark) {
+        request.response_encoder_.runHighWatermarkCallbacks();
+      }
+      return;
+    }
+    active_requests_.pop_front();
   }
 }
 
@@ -469,28 +681,28 @@ void ServerConnectionImpl::handlePath(HeaderMapImpl& headers, unsigned int metho
   bool is_connect = (method == HTTP_CONNECT);
 
   // The url is relative or a wildcard when the method is OPTIONS. Nothing to do here.
-  if (active_request_->request_url_.c_str()[0] == '/' ||
-      ((method == HTTP_OPTIONS) && active_request_->request_url_.c_str()[0] == '*')) {
-    headers.addViaMove(std::move(path), std::move(active_request_->request_url_));
+  if (decoding_request_->request_url_.c_str()[0] == '/' ||
+      ((method == HTTP_OPTIONS) && decoding_request_->request_url_.c_str()[0] == '*')) {
+    headers.addViaMove(std::move(path), std::move(decoding_request_->request_url_));
     return;
   }
 
   // If absolute_urls and/or connect are not going be handled, copy the url and return.
   // This forces the behavior to be backwards compatible with the old codec behavior.
   if (!codec_settings_.allow_absolute_url_) {
-    headers.addViaMove(std::move(path), std::move(active_request_->request_url_));
+    headers.addViaMove(std::move(path), std::move(decoding_request_->request_url_));
     return;
   }
 
   if (is_connect) {
-    headers.addViaMove(std::move(path), std::move(active_request_->request_url_));
+    headers.addViaMove(std::move(path), std::move(decoding_request_->request_url_));
     return;
   }
 
   struct http_parser_url u;
   http_parser_url_init(&u);
-  int result = http_parser_parse_url(active_request_->request_url_.buffer(),
-                                     active_request_->request_url_.size(), is_connect, &u);
+  int result = http_parser_parse_url(decoding_request_->request_url_.buffer(),
+                                     decoding_request_->request_url_.size(), is_connect, &u);
 
   if (result != 0) {
     sendProtocolError();
@@ -514,7 +726,7 @@ void ServerConnectionImpl::handlePath(HeaderMapImpl& headers, unsigned int metho
       }
 
       // Insert the host header, this will later be converted to :authority
-      std::string new_host(active_request_->request_url_.c_str() + u.field_data[UF_HOST].off,
+      std::string new_host(decoding_request_->request_url_.c_str() + u.field_data[UF_HOST].off,
                            authority_len);
 
       headers.insertHost().value(new_host);
@@ -523,8 +735,8 @@ void ServerConnectionImpl::handlePath(HeaderMapImpl& headers, unsigned int metho
       // must start with /
       if ((u.field_set & (1 << UF_PATH)) == (1 << UF_PATH) && u.field_data[UF_PATH].len > 0) {
         HeaderString new_path;
-        new_path.setCopy(active_request_->request_url_.c_str() + u.field_data[UF_PATH].off,
-                         active_request_->request_url_.size() - u.field_data[UF_PATH].off);
+        new_path.setCopy(decoding_request_->request_url_.c_str() + u.field_data[UF_PATH].off,
+                         decoding_request_->request_url_.size() - u.field_data[UF_PATH].off);
         headers.addViaMove(std::move(path), std::move(new_path));
       } else {
         HeaderString new_path;
@@ -532,7 +744,7 @@ void ServerConnectionImpl::handlePath(HeaderMapImpl& headers, unsigned int metho
         headers.addViaMove(std::move(path), std::move(new_path));
       }
 
-      active_request_->request_url_.clear();
+      decoding_request_->request_url_.clear();
       return;
     }
     sendProtocolError();
@@ -544,17 +756,17 @@ int ServerConnectionImpl::onHeadersComplete(HeaderMapImplPtr&& headers) {
   // Handle the case where response happens prior to request complete. It's up to upper layer code
   // to disconnect the connection but we shouldn't fire any more events since it doesn't make
   // sense.
-  if (active_request_) {
+  if (decoding_request_ != nullptr) {
     const char* method_string = http_method_str(static_cast<http_method>(parser_.method));
 
     // Inform the response encoder about any HEAD method, so it can set content
     // length and transfer encoding headers correctly.
-    active_request_->response_encoder_.isResponseToHeadRequest(parser_.method == HTTP_HEAD);
+    decoding_request_->response_encoder_.isResponseToHeadRequest(parser_.method == HTTP_HEAD);
 
     // Currently, CONNECT is not supported, however; http_parser_parse_url needs to know about
     // CONNECT
     handlePath(*headers, parser_.method);
-    ASSERT(active_request_->request_url_.empty());
+    ASSERT(decoding_request_->request_url_.empty());
 
     headers->insertMethod().value(method_string, strlen(method_string));
 
@@ -566,7 +778,7 @@ int ServerConnectionImpl::onHeadersComplete(HeaderMapImplPtr&& headers) {
     // encoding because end stream with zero body length has not yet been indicated.
     if (parser_.flags & F_CHUNKED ||
         (parser_.content_length > 0 && parser_.content_length != ULLONG_MAX) || handling_upgrade_) {
-      active_request_->request_decoder_->decodeHeaders(std::move(headers), false);
+      decoding_request_->request_decoder_->decodeHeaders(std::move(headers), false);
 
       // If the connection has been closed (or is closing) after decoding headers, pause the parser
       // so we return control to the caller.
@@ -584,38 +796,45 @@ int ServerConnectionImpl::onHeadersComplete(HeaderMapImplPtr&& headers) {
 
 void ServerConnectionImpl::onMessageBegin() {
   if (!resetStreamCalled()) {
-    ASSERT(!active_request_);
-    active_request_.reset(new ActiveRequest(*this));
-    active_request_->request_decoder_ = &callbacks_.newStream(active_request_->response_encoder_);
+    ASSERT(decoding_request_ == nullptr);
+    active_requests_.emplace_back(new ActiveRequest(*this));
+    ActiveRequest& request = *active_requests_.back();
+    if (active_requests_.size() > 1) {
+      request.response_encoder_.deferOutput();
+    }
+    decoding_request_ = &request;
+    request.request_decoder_ = &callbacks_.newStream(request.response_encoder_);
   }
 }
 
 void ServerConnectionImpl::onUrl(const char* data, size_t length) {
-  if (active_request_) {
-    active_request_->request_url_.append(data, length);
+  if (decoding_request_ != nullptr) {
+    decoding_request_->request_url_.append(data, length);
   }
 }
 
 void ServerConnectionImpl::onBody(const char* data, size_t length) {
   ASSERT(!deferred_end_stream_headers_);
-  if (active_request_) {
+  if (decoding_request_ != nullptr) {
     ENVOY_CONN_LOG(trace, "body size={}", connection_, length);
     Buffer::OwnedImpl buffer(data, length);
-    active_request_->request_decoder_->decodeData(buffer, false);
+    decoding_request_->request_decoder_->decodeData(buffer, false);
   }
 }
 
 void ServerConnectionImpl::onMessageComplete() {
-  if (active_request_) {
+  if (decoding_request_ != nullptr) {
+    // Completing the request may complete its response too, which removes the request.
+    ActiveRequest& request = *decoding_request_;
+    decoding_request_ = nullptr;
     Buffer::OwnedImpl buffer;
-    active_request_->remote_complete_ = true;
+    request.remote_complete_ = true;
 
     if (deferred_end_stream_headers_) {
-      active_request_->request_decoder_->decodeHeaders(std::move(deferred_end_stream_headers_),
-                                                       true);
+      request.request_decoder_->decodeHeaders(std::move(deferred_end_stream_headers_), true);
       deferred_end_stream_headers_.reset();
     } else {
-      active_request_->request_decoder_->decodeData(buffer, true);
+      request.request_decoder_->decodeData(buffer, true);
     }
   }
 
@@ -626,9 +845,16 @@ void ServerConnectionImpl::onMessageComplete() {
 }
 
 void ServerConnectionImpl::onResetStream(StreamResetReason reason) {
-  ASSERT(active_request_);
-  active_request_->response_encoder_.runResetCallbacks(reason);
-  active_request_.reset();
+  ASSERT(!active_requests_.empty());
+  // A reset ends the connection, so it resets every request still in progress along with it.
+  // Requests that were completely received and responded to have already gone away.
+  for (const auto& request : active_requests_) {
+    if (!request->response_encoder_.encodeComplete() || !request->remote_complete_) {
+      request->response_encoder_.runResetCallbacks(reason);
+    }
+  }
+  active_requests_.clear();
+  decoding_request_ = nullptr;
 }
 
 void ServerConnectionImpl::sendProtocolError() {
@@ -636,7 +862,10 @@ void ServerConnectionImpl::sendProtocolError() {
   // layers can only operate on streams, so there is no coherent way to allow them to send an error
   // "out of band." On one hand this is kind of a hack but on the other hand it normalizes HTTP/1.1
   // to look more like HTTP/2 to higher layers.
-  if (!active_request_ || !active_request_->response_encoder_.startedResponse()) {
+  // The error response can't be written ahead of the responses to pipelined requests.
+  if (active_requests_.empty() ||
+      (active_requests_.size() == 1 &&
+       !active_requests_.front()->response_encoder_.startedResponse())) {
     Buffer::OwnedImpl bad_request_response(
         fmt::format("HTTP/1.1 {} {}\r\ncontent-length: 0\r\nconnection: close\r\n\r\n",
                     std::to_string(enumToInt(error_code_)), CodeUtility::toString(error_code_)));
@@ -646,13 +875,15 @@ void ServerConnectionImpl::sendProtocolError() {
 }
 
 void ServerConnectionImpl::onAboveHighWatermark() {
-  if (active_request_) {
-    active_request_->response_encoder_.runHighWatermarkCallbacks();
+  above_high_watermark_ = true;
+  if (!active_requests_.empty()) {
+    active_requests_.front()->response_encoder_.runHighWatermarkCallbacks();
   }
 }
 void ServerConnectionImpl::onBelowLowWatermark() {
-  if (active_request_) {
-    active_request_->response_encoder_.runLowWatermarkCallbacks();
+  above_high_watermark_ = false;
+  if (!active_requests_.empty()) {
+    active_requests_.front()->response_encoder_.runLowWatermarkCallbacks();
   }
 }
 
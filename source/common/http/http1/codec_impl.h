@@ -7,16 +7,18 @@
 #include <list>
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "envoy/event/timer.h"
 #include "envoy/http/codec.h"
 #include "envoy/network/connection.h"
 
 #include "common/buffer/watermark_buffer.h"
 #include "common/common/assert.h"
-#include "common/common/to_lower_table.h"
 #include "common/http/codec_helper.h"
 #include "common/http/codes.h"
 #include "common/http/header_map_impl.h"
+#include "common/http/http1/header_block_scanner.h"
 
 namespace Envoy {
 namespace Http {
@@ -54,6 +56,18 @@ protected:
   static const std::string CRLF;
   static const std::string LAST_CHUNK;
 
+  /**
+   * Send what has been encoded so far.
+   * @param end_of_message supplies whether the message has been completely encoded. If not, the
+   *        output may be held back to go out together with the output that follows.
+   */
+  virtual void flushOutput(bool end_of_message);
+
+  /**
+   * Called once the stream has been completely encoded.
+   */
+  virtual void onEncodeComplete();
+
   ConnectionImpl& connection_;
 
 private:
@@ -84,12 +98,33 @@ public:
   ResponseStreamEncoderImpl(ConnectionImpl& connection) : StreamEncoderImpl(connection) {}
 
   bool startedResponse() { return started_response_; }
+  bool encodeComplete() { return encode_complete_; }
+
+  /**
+   * Hold the response back, buffering it as it is encoded, until resumeOutput() is called. This is
+   * used for pipelined requests, whose responses must follow the responses to earlier requests.
+   */
+  void deferOutput() { deferred_output_ = std::make_unique<Buffer::OwnedImpl>(); }
+
+  /**
+   * Write the response encoded so far to the connection, and the rest as it is encoded.
+   */
+  void resumeOutput();
 
   // Http::StreamEncoder
   void encodeHeaders(const HeaderMap& headers, bool end_stream) override;
 
+protected:
+  // StreamEncoderImpl
+  void flushOutput(bool end_of_message) override;
+  void onEncodeComplete() override;
+
 private:
   bool started_response_{};
+  bool encode_complete_{};
+  std::unique_ptr<Buffer::OwnedImpl> deferred_output_;
+  // Whether the held back response has exceeded the connection's buffer limit.
+  bool deferred_above_high_watermark_{};
 };
 
 /**
@@ -139,6 +174,19 @@ public:
    */
   void flushOutput();
 
+  /**
+   * Flush all pending output from encoding, unless writes are coalesced. Then the output is held
+   * back until the end of the current dispatch or event loop iteration, or until enough of it
+   * builds up, so that output encoded in the meantime goes out in the same write.
+   */
+  void flushOutputSoon();
+
+  /**
+   * Move all pending output from encoding to a buffer rather than writing it to the connection.
+   * @param output supplies the buffer to move the output to.
+   */
+  void flushOutput(Buffer::Instance& output);
+
   void addCharToBuffer(char c);
   void addIntToBuffer(uint64_t i);
   Buffer::WatermarkBuffer& buffer() { return output_buffer_; }
@@ -171,10 +219,24 @@ protected:
   HeaderMapPtr deferred_end_stream_headers_;
   Http::Code error_code_{Http::Code::BadRequest};
   bool handling_upgrade_{};
+  // Whether complete header blocks are split with HeaderBlockScanner rather than by http_parser.
+  bool fast_header_parsing_{};
+  // Whether flushOutputSoon() holds output back.
+  bool coalesce_writes_{};
 
 private:
   enum class HeaderParsingState { Field, Value, Done };
 
+  /**
+   * Commit the part of the output buffer reservation that has been written to.
+   */
+  void commitReservedBuffer();
+
+  /**
+   * Flush output held back by flushOutputSoon(), if the connection is still open.
+   */
+  void onFlushTimer();
+
   /**
    * Called in order to complete an in progress header decode.
    */
@@ -187,6 +249,22 @@ private:
    */
   size_t dispatchSlice(const char* slice, size_t len);
 
+  /**
+   * Dispatch a header block at the start of a message with HeaderBlockScanner. http_parser is
+   * only given the request line and the headers that frame the body; the other headers are added
+   * to the header map directly.
+   * @param data supplies the start address.
+   * @param len supplies the length of the span.
+   * @return size_t the number of bytes consumed, or 0 if the span does not start with a complete
+   *         header block that the scanner accepts and http_parser must parse it.
+   */
+  size_t dispatchHeaderBlock(const char* data, size_t len);
+
+  /**
+   * Send a protocol error and throw if http_parser has failed.
+   */
+  void checkParserError();
+
   /**
    * Called when a request/response is beginning. A base routine happens first then a virtual
    * dispatch is invoked.
@@ -259,17 +337,27 @@ private:
   virtual void onBelowLowWatermark() PURE;
 
   static http_parser_settings settings_;
-  static const ToLowerTable& toLowerTable();
 
   HeaderMapImplPtr current_header_map_;
   HeaderParsingState header_parsing_state_{HeaderParsingState::Field};
   HeaderString current_header_field_;
   HeaderString current_header_value_;
+  std::vector<HeaderBlockScanner::Header> header_block_;
+  absl::string_view header_block_data_;
+  std::string header_block_framing_;
+  // The buffer being dispatched, which large header values of a scanned block are pinned in.
+  Buffer::Instance* dispatch_buffer_{};
+  bool dispatching_header_block_{};
+  bool at_message_start_{true};
+  bool paused_at_message_end_{};
   bool reset_stream_called_{};
   Buffer::WatermarkBuffer output_buffer_;
   Buffer::RawSlice reserved_iovec_;
   char* reserved_current_{};
   Protocol protocol_{Protocol::Http11};
+  // Flushes output held back by flushOutputSoon() at the end of the event loop iteration.
+  Event::TimerPtr flush_timer_;
+  bool flush_pending_{};
 };
 
 /**
@@ -319,8 +407,14 @@ private:
   void onBelowLowWatermark() override;
 
   ServerConnectionCallbacks& callbacks_;
-  std::unique_ptr<ActiveRequest> active_request_;
+  // Requests in the order they were received. Only the response to the first one is written to the
+  // connection as it is encoded. The others are pipelined requests, whose responses are held back
+  // until the responses before them have been written.
+  std::list<std::unique_ptr<ActiveRequest>> active_requests_;
+  // The request whose message is being decoded, if any.
+  ActiveRequest* decoding_request_{};
   Http1Settings codec_settings_;
+  bool above_high_watermark_{};
 };
 
 /**
@@ -1,5 +1,7 @@
 #include "common/http/http1/conn_pool.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <list>
 
@@ -88,6 +90,7 @@ ConnectionPool::Cancellable* ConnPoolImpl::newStream(StreamDecoder& response_dec
     ready_clients_.front()->moveBetweenLists(ready_clients_, busy_clients_);
     ENVOY_CONN_LOG(debug, "using existing connection", *busy_clients_.front()->codec_client_);
     attachRequestToClient(*busy_clients_.front(), response_decoder, callbacks);
+    prefetchConnections();
     return nullptr;
   }
 
@@ -106,6 +109,7 @@ ConnectionPool::Cancellable* ConnPoolImpl::newStream(StreamDecoder& response_dec
     ENVOY_LOG(debug, "queueing request due to no available connections");
     PendingRequestPtr pending_request(new PendingRequest(*this, response_decoder, callbacks));
     pending_request->moveIntoList(std::move(pending_request), pending_requests_);
+    prefetchConnections();
     return pending_requests_.front().get();
   } else {
     ENVOY_LOG(debug, "max pending requests overflow");
@@ -180,6 +184,7 @@ void ConnPoolImpl::onConnectionEvent(ActiveClient& client, Network::ConnectionEv
   if (client.connect_timer_) {
     client.connect_timer_->disableTimer();
     client.connect_timer_.reset();
+    connecting_clients_--;
   }
 
   // Note that the order in this function is important. Concretely, we must destroy the connect
@@ -238,6 +243,28 @@ void ConnPoolImpl::onUpstreamReady() {
   }
 }
 
+void ConnPoolImpl::prefetchConnections() {
+  const Upstream::ClusterInfo& cluster = host_->cluster();
+  if ((cluster.prefetchRatio() <= 1.0 && cluster.prefetchMinConnections() == 0) ||
+      !drained_callbacks_.empty()) {
+    return;
+  }
+
+  // Busy clients that are not connecting have a request attached. Keep ratio connections per
+  // attached and pending request, and never fewer than the minimum pool size. Prefetching only
+  // happens when a request comes in or the pool is warmed, never on disconnect, so that an
+  // unreachable host does not make the pool reconnect in a loop.
+  const uint64_t requests = busy_clients_.size() - connecting_clients_ + pending_requests_.size();
+  const uint64_t wanted =
+      std::max<uint64_t>(cluster.prefetchMinConnections(),
+                         static_cast<uint64_t>(std::ceil(requests * cluster.prefetchRatio())));
+  while (ready_clients_.size() + busy_clients_.size() < wanted &&
+         cluster.resourceManager(priority_).connections().canCreate()) {
+    ENVOY_LOG(debug, "prefetching a connection");
+    createNewConnection();
+  }
+}
+
 void ConnPoolImpl::processIdleClient(ActiveClient& client, bool delay) {
   client.stream_wrapper_.reset();
   if (pending_requests_.empty() || delay) {
@@ -312,6 +339,7 @@ ConnPoolImpl::ActiveClient::ActiveClient(ConnPoolImpl& parent)
       connect_timer_(parent_.dispatcher_.createTimer([this]() -> void { onConnectTimeout(); })),
       remaining_requests_(parent_.host_->cluster().maxRequestsPerConnection()) {
 
+  parent_.connecting_clients_++;
   parent_.conn_connect_ms_.reset(
       new Stats::Timespan(parent_.host_->cluster().stats().upstream_cx_connect_ms_));
   Upstream::Host::CreateConnectionData data =
@@ -14,6 +14,7 @@
 #include "common/common/linked_object.h"
 #include "common/http/codec_client.h"
 #include "common/http/codec_wrappers.h"
+#include "common/memory/recycler.h"
 
 #include "absl/types/optional.h"
 
@@ -39,6 +40,7 @@ public:
   Http::Protocol protocol() const override { return Http::Protocol::Http11; }
   void addDrainedCallback(DrainedCb cb) override;
   void drainConnections() override;
+  void prefetch() override { prefetchConnections(); }
   ConnectionPool::Cancellable* newStream(StreamDecoder& response_decoder,
                                          ConnectionPool::Callbacks& callbacks) override;
 
@@ -74,7 +76,8 @@ protected:
 
   struct ActiveClient : LinkedObject<ActiveClient>,
                         public Network::ConnectionCallbacks,
-                        public Event::DeferredDeletable {
+                        public Event::DeferredDeletable,
+                        public Memory::Recyclable<ActiveClient> {
     ActiveClient(ConnPoolImpl& parent);
     ~ActiveClient();
 
@@ -123,6 +126,7 @@ protected:
   void onPendingRequestCancel(PendingRequest& request);
   void onResponseComplete(ActiveClient& client);
   void onUpstreamReady();
+  void prefetchConnections();
   void processIdleClient(ActiveClient& client, bool delay);
 
   Stats::TimespanPtr conn_connect_ms_;
@@ -132,6 +136,8 @@ protected:
   std::list<ActiveClientPtr> busy_clients_;
   std::list<PendingRequestPtr> pending_requests_;
   std::list<DrainedCb> drained_callbacks_;
+  // Clients in busy_clients_ that are still connecting and so have no request attached.
+  uint64_t connecting_clients_{};
   Upstream::ResourcePriority priority_;
   const Network::ConnectionSocket::OptionsSharedPtr socket_options_;
   Event::TimerPtr upstream_ready_timer_;
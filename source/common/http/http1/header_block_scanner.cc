@@ -0,0 +1,135 @@
+#include "common/http/http1/header_block_scanner.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+
+namespace {
+
+// RFC 7230 tchar.
+bool isTokenChar(uint8_t c) {
+  static const struct TokenTable {
+    TokenTable() {
+      for (const char* c = "!#$%&'*+-.^_`|~"; *c != 0; c++) {
+        table_[static_cast<uint8_t>(*c)] = true;
+      }
+      for (int c = 0; c < 256; c++) {
+        if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
+          table_[c] = true;
+        }
+      }
+    }
+    bool table_[256]{};
+  } tokens;
+  return tokens.table_[c];
+}
+
+bool isControlChar(uint8_t c) { return (c < 0x20 && c != '\t') || c == 0x7f; }
+
+} // namespace
+
+const char* HeaderBlockScanner::findLineFeed(const char* begin, const char* end) {
+#if defined(__AVX2__)
+  const __m256i lf32 = _mm256_set1_epi8('\n');
+  for (; end - begin >= 32; begin += 32) {
+    const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+    const uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, lf32));
+    if (mask != 0) {
+      return begin + __builtin_ctz(mask);
+    }
+  }
+#endif
+#if defined(__SSE2__)
+  const __m128i lf16 = _mm_set1_epi8('\n');
+  for (; end - begin >= 16; begin += 16) {
+    const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+    const uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, lf16));
+    if (mask != 0) {
+      return begin + __builtin_ctz(mask);
+    }
+  }
+#endif
+  const void* lf = memchr(begin, '\n', end - begin);
+  return lf != nullptr ? static_cast<const char*>(lf) : end;
+}
+
+bool HeaderBlockScanner::hasControlChar(const char* begin, const char* end) {
+#if defined(__SSE2__)
+  const __m128i max_control = _mm_set1_epi8(0x1f);
+  const __m128i tab = _mm_set1_epi8('\t');
+  const __m128i del = _mm_set1_epi8(0x7f);
+  for (; end - begin >= 16; begin += 16) {
+    const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+    // Unsigned chunk <= 0x1f, except HTAB, or DEL.
+    const __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(chunk, max_control), chunk);
+    const __m128i invalid = _mm_or_si128(_mm_andnot_si128(_mm_cmpeq_epi8(chunk, tab), control),
+                                         _mm_cmpeq_epi8(chunk, del));
+    if (_mm_movemask_epi8(invalid) != 0) {
+      return true;
+    }
+  }
+#endif
+  for (; begin != end; begin++) {
+    if (isControlChar(*begin)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t HeaderBlockScanner::scan(absl::string_view data, size_t& request_line_length,
+                                std::vector<Header>& headers) {
+  headers.clear();
+  const char* const begin = data.data();
+  const char* const end = begin + data.size();
+
+  // Leading empty lines are tolerated by http_parser; leave them to it.
+  const char* lf = findLineFeed(begin, end);
+  if (lf == end || lf == begin || lf[-1] != '\r' || begin[0] == '\r') {
+    return 0;
+  }
+  request_line_length = lf + 1 - begin;
+
+  for (const char* line = lf + 1;; line = lf + 1) {
+    lf = findLineFeed(line, end);
+    if (lf == end || lf == line || lf[-1] != '\r') {
+      return 0;
+    }
+
+    const char* const cr = lf - 1;
+    if (cr == line) {
+      return lf + 1 - begin;
+    }
+
+    // A line starting with whitespace (obs-fold) fails here too.
+    const char* colon = line;
+    while (colon < cr && isTokenChar(*colon)) {
+      colon++;
+    }
+    if (colon == line || colon == cr || *colon != ':') {
+      return 0;
+    }
+
+    const char* value = colon + 1;
+    while (value < cr && (*value == ' ' || *value == '\t')) {
+      value++;
+    }
+    if (hasControlChar(value, cr)) {
+      return 0;
+    }
+
+    headers.push_back({absl::string_view(line, colon - line), absl::string_view(value, cr - value),
+                       absl::string_view(line, lf + 1 - line)});
+  }
+}
+
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
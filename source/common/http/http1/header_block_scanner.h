@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+
+/**
+ * Splits an HTTP/1 request header block that is complete in one span of memory into its request
+ * line and header lines. Line ends are searched for 32 or 16 bytes at a time when built for AVX2
+ * or SSE2, with a scalar fallback otherwise. Only strictly formed blocks are accepted; anything
+ * else (obs-fold, bare LF, control characters, non-token header names, ...) is left for
+ * http_parser to parse and reject if needed.
+ */
+class HeaderBlockScanner {
+public:
+  struct Header {
+    absl::string_view name_;
+    // The value without the leading whitespace and the CRLF.
+    absl::string_view value_;
+    // The whole line including the CRLF.
+    absl::string_view line_;
+  };
+
+  /**
+   * @param data supplies the bytes to scan, starting at the request line.
+   * @param request_line_length receives the length of the request line including its CRLF. The
+   *        request line itself is not validated.
+   * @param headers receives the header lines in order.
+   * @return size_t the length of the header block including the empty line ending it, or 0 if
+   *         data does not start with a complete, strictly formed header block.
+   */
+  static size_t scan(absl::string_view data, size_t& request_line_length,
+                     std::vector<Header>& headers);
+
+  /**
+   * @return const char* the first LF in [begin, end), or end if there is none.
+   */
+  static const char* findLineFeed(const char* begin, const char* end);
+
+  /**
+   * @return bool whether [begin, end) contains a control character other than HTAB, or DEL.
+   */
+  static bool hasControlChar(const char* begin, const char* end);
+};
+
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
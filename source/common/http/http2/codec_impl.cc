@@ -1,7 +1,10 @@
 #include "common/http/http2/codec_impl.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "envoy/event/dispatcher.h"
@@ -17,10 +20,38 @@
 #include "common/http/codes.h"
 #include "common/http/exception.h"
 #include "common/http/headers.h"
+#include "common/memory/accounting.h"
 
 namespace Envoy {
 namespace Http {
 namespace Http2 {
+namespace {
+
+// Accounts the memory of sessions, their streams and their HPACK tables.
+nghttp2_mem* accountedMemory() {
+  static nghttp2_mem memory = {
+      nullptr,
+      [](size_t size, void*) -> void* {
+        return Memory::Accounting::malloc(Memory::Tag::Http2Sessions, size);
+      },
+      [](void* ptr, void*) -> void { Memory::Accounting::free(Memory::Tag::Http2Sessions, ptr); },
+      [](size_t count, size_t size, void*) -> void* {
+        if (size != 0 && count > SIZE_MAX / size) {
+          return nullptr;
+        }
+        void* ptr = Memory::Accounting::malloc(Memory::Tag::Http2Sessions, count * size);
+        if (ptr != nullptr) {
+          memset(ptr, 0, count * size);
+        }
+        return ptr;
+      },
+      [](void* ptr, size_t size, void*) -> void* {
+        return Memory::Accounting::realloc(Memory::Tag::Http2Sessions, ptr, size);
+      }};
+  return &memory;
+}
+
+} // namespace
 
 bool Utility::reconstituteCrumbledCookies(const HeaderString& key, const HeaderString& value,
                                           HeaderString& cookies) {
@@ -57,7 +88,8 @@ ConnectionImpl::StreamImpl::StreamImpl(ConnectionImpl& parent, uint32_t buffer_l
   }
 }
 
-static void insertHeader(std::vector<nghttp2_nv>& headers, const HeaderEntry& header) {
+static void insertHeader(std::vector<nghttp2_nv>& headers, const HeaderEntry& header,
+                         const std::vector<std::string>& never_index_headers) {
   uint8_t flags = 0;
   if (header.key().type() == HeaderString::Type::Reference) {
     flags |= NGHTTP2_NV_FLAG_NO_COPY_NAME;
@@ -65,21 +97,58 @@ static void insertHeader(std::vector<nghttp2_nv>& headers, const HeaderEntry& he
   if (header.value().type() == HeaderString::Type::Reference) {
     flags |= NGHTTP2_NV_FLAG_NO_COPY_VALUE;
   }
+  // The list is expected to be short enough that a linear scan beats hashing every header name.
+  if (!never_index_headers.empty()) {
+    const absl::string_view key = header.key().getStringView();
+    for (const std::string& name : never_index_headers) {
+      if (key == name) {
+        flags |= NGHTTP2_NV_FLAG_NO_INDEX;
+        break;
+      }
+    }
+  }
   headers.push_back({remove_const<uint8_t>(header.key().c_str()),
                      remove_const<uint8_t>(header.value().c_str()), header.key().size(),
                      header.value().size(), flags});
 }
 
-void ConnectionImpl::StreamImpl::buildHeaders(std::vector<nghttp2_nv>& final_headers,
-                                              const HeaderMap& headers) {
-  final_headers.reserve(headers.size());
+static bool headerNameEquals(const nghttp2_nv& header, const LowerCaseString& name) {
+  return header.namelen == name.get().size() &&
+         memcmp(header.name, name.get().data(), header.namelen) == 0;
+}
+
+/**
+ * Points a built header at a value which outlives the frame, so that nghttp2 needn't copy it.
+ */
+static void setStaticValue(nghttp2_nv& header, const std::string& value) {
+  header.value = remove_const<uint8_t>(value.c_str());
+  header.valuelen = value.size();
+  header.flags |= NGHTTP2_NV_FLAG_NO_COPY_VALUE;
+}
+
+/**
+ * Drops the HTTP/1 upgrade headers, which are connection specific, from built headers.
+ */
+static void removeUpgradeHeaders(std::vector<nghttp2_nv>& final_headers) {
+  final_headers.erase(std::remove_if(final_headers.begin(), final_headers.end(),
+                                     [](const nghttp2_nv& header) -> bool {
+                                       return headerNameEquals(header, Headers::get().Upgrade) ||
+                                              headerNameEquals(header, Headers::get().Connection);
+                                     }),
+                      final_headers.end());
+}
+
+std::vector<nghttp2_nv>& ConnectionImpl::buildHeaders(const HeaderMap& headers) {
+  final_headers_.clear();
+  final_headers_.reserve(headers.size() + 1);
   headers.iterate(
       [](const HeaderEntry& header, void* context) -> HeaderMap::Iterate {
-        std::vector<nghttp2_nv>* final_headers = static_cast<std::vector<nghttp2_nv>*>(context);
-        insertHeader(*final_headers, header);
+        ConnectionImpl* connection = static_cast<ConnectionImpl*>(context);
+        insertHeader(connection->final_headers_, header, connection->never_index_headers_);
         return HeaderMap::Iterate::Continue;
       },
-      &final_headers);
+      this);
+  return final_headers_;
 }
 
 void ConnectionImpl::StreamImpl::encode100ContinueHeaders(const HeaderMap& headers) {
@@ -88,15 +157,9 @@ void ConnectionImpl::StreamImpl::encode100ContinueHeaders(const HeaderMap& heade
 }
 
 void ConnectionImpl::StreamImpl::encodeHeaders(const HeaderMap& headers, bool end_stream) {
-  std::vector<nghttp2_nv> final_headers;
-
-  Http::HeaderMapPtr modified_headers;
+  std::vector<nghttp2_nv>& final_headers = parent_.buildHeaders(headers);
   if (Http::Utility::isUpgrade(headers)) {
-    modified_headers = std::make_unique<Http::HeaderMapImpl>(headers);
-    transformUpgradeFromH1toH2(*modified_headers);
-    buildHeaders(final_headers, *modified_headers);
-  } else {
-    buildHeaders(final_headers, headers);
+    transformUpgradeFromH1toH2(headers, final_headers);
   }
 
   nghttp2_data_provider provider;
@@ -184,8 +247,7 @@ void ConnectionImpl::StreamImpl::saveHeader(HeaderString&& name, HeaderString&&
 }
 
 void ConnectionImpl::StreamImpl::submitTrailers(const HeaderMap& trailers) {
-  std::vector<nghttp2_nv> final_headers;
-  buildHeaders(final_headers, trailers);
+  std::vector<nghttp2_nv>& final_headers = parent_.buildHeaders(trailers);
   int rc =
       nghttp2_submit_trailer(parent_.session_, stream_id_, &final_headers[0], final_headers.size());
   ASSERT(rc == 0);
@@ -196,7 +258,18 @@ ssize_t ConnectionImpl::StreamImpl::onDataSourceRead(uint64_t length, uint32_t*
     ASSERT(!data_deferred_);
     data_deferred_ = true;
     return NGHTTP2_ERR_DEFERRED;
+  } else if (parent_.max_outbound_data_bytes_ > 0 && pending_send_data_.length() > 0 &&
+             send_quantum_ == 0) {
+    // The stream has used up its turn, and waits for the scheduler to give it another.
+    ASSERT(!data_deferred_);
+    data_deferred_ = true;
+    parent_.scheduleStream(*this);
+    return NGHTTP2_ERR_DEFERRED;
   } else {
+    if (parent_.max_outbound_data_bytes_ > 0) {
+      length = std::min(length, send_quantum_);
+      send_quantum_ -= std::min(length, pending_send_data_.length());
+    }
     *data_flags |= NGHTTP2_DATA_FLAG_NO_COPY;
     if (local_end_stream_ && pending_send_data_.length() <= length) {
       *data_flags |= NGHTTP2_DATA_FLAG_EOF;
@@ -218,9 +291,8 @@ int ConnectionImpl::StreamImpl::onDataSourceSend(const uint8_t* framehd, size_t
   // https://nghttp2.org/documentation/types.html#c.nghttp2_send_data_callback
   static const uint64_t FRAME_HEADER_SIZE = 9;
 
-  Buffer::OwnedImpl output(framehd, FRAME_HEADER_SIZE);
-  output.move(pending_send_data_, length);
-  parent_.connection_.write(output, false);
+  parent_.outbound_frames_.add(framehd, FRAME_HEADER_SIZE);
+  parent_.outbound_frames_.move(pending_send_data_, length);
   return 0;
 }
 
@@ -232,6 +304,42 @@ void ConnectionImpl::ClientStreamImpl::submitHeaders(const std::vector<nghttp2_n
   ASSERT(stream_id_ > 0);
 }
 
+void ConnectionImpl::ClientStreamImpl::transformUpgradeFromH1toH2(
+    const HeaderMap& headers, std::vector<nghttp2_nv>& final_headers) {
+  // Like Utility::transformUpgradeRequestFromH1toH2(), without copying the headers to rewrite them.
+  upgrade_type_ = headers.Upgrade()->value().c_str();
+  removeUpgradeHeaders(final_headers);
+  auto pseudo_headers_end = std::find_if(final_headers.begin(), final_headers.end(),
+                                         [](const nghttp2_nv& header) -> bool {
+                                           return header.namelen == 0 || header.name[0] != ':';
+                                         });
+  for (auto header = final_headers.begin(); header != pseudo_headers_end; ++header) {
+    if (headerNameEquals(*header, Headers::get().Method)) {
+      setStaticValue(*header, Headers::get().MethodValues.Connect);
+    }
+  }
+  const std::string& protocol = Headers::get().Protocol.get();
+  final_headers.insert(pseudo_headers_end,
+                       {remove_const<uint8_t>(protocol.c_str()),
+                        remove_const<uint8_t>(upgrade_type_.c_str()), protocol.size(),
+                        upgrade_type_.size(), NGHTTP2_NV_FLAG_NO_COPY_NAME});
+}
+
+void ConnectionImpl::ServerStreamImpl::transformUpgradeFromH1toH2(
+    const HeaderMap& headers, std::vector<nghttp2_nv>& final_headers) {
+  // Like Utility::transformUpgradeResponseFromH1toH2(), without copying the headers to rewrite
+  // them.
+  static const std::string UpgradedStatus = "200";
+  removeUpgradeHeaders(final_headers);
+  if (Http::Utility::getResponseStatus(headers) == 101) {
+    for (nghttp2_nv& header : final_headers) {
+      if (headerNameEquals(header, Headers::get().Status)) {
+        setStaticValue(header, UpgradedStatus);
+      }
+    }
+  }
+}
+
 void ConnectionImpl::ServerStreamImpl::submitHeaders(const std::vector<nghttp2_nv>& final_headers,
                                                      nghttp2_data_provider* provider) {
   ASSERT(stream_id_ != -1);
@@ -244,7 +352,11 @@ void ConnectionImpl::StreamImpl::encodeData(Buffer::Instance& data, bool end_str
   ASSERT(!local_end_stream_);
   local_end_stream_ = end_stream;
   pending_send_data_.move(data);
-  if (data_deferred_) {
+  if (data_deferred_ && parent_.max_outbound_data_bytes_ > 0 && pending_send_data_.length() > 0 &&
+      send_quantum_ == 0) {
+    // Leave the stream deferred until the scheduler gives it a turn.
+    parent_.scheduleStream(*this);
+  } else if (data_deferred_) {
     int rc = nghttp2_session_resume_data(parent_.session_, stream_id_);
     ASSERT(rc == 0);
 
@@ -501,8 +613,7 @@ int ConnectionImpl::onInvalidFrame(int32_t stream_id, int error_code) {
 
 ssize_t ConnectionImpl::onSend(const uint8_t* data, size_t length) {
   ENVOY_CONN_LOG(trace, "send data: bytes={}", connection_, length);
-  Buffer::OwnedImpl buffer(data, length);
-  connection_.write(buffer, false);
+  outbound_frames_.add(data, length);
   return length;
 }
 
@@ -529,6 +640,7 @@ int ConnectionImpl::onStreamClose(int32_t stream_id, uint32_t error_code) {
       stream->runResetCallbacks(reason);
     }
 
+    unscheduleStream(*stream);
     connection_.dispatcher().deferredDelete(stream->removeFromList(active_streams_));
     // Any unconsumed data must be consumed before the stream is deleted.
     // nghttp2 does not appear to track this internally, and any stream deleted
@@ -571,6 +683,23 @@ void ConnectionImpl::sendPendingFrames() {
   }
 
   int rc = nghttp2_session_send(session_);
+  // Give the scheduled streams their turns while the connection is within the budget, counting the
+  // frames produced so far.
+  while (rc == 0 && !scheduled_streams_.empty() &&
+         outbound_bytes_ + outbound_frames_.length() < max_outbound_data_bytes_) {
+    StreamImpl& stream = nextScheduledStream();
+    stream.data_deferred_ = false;
+    // This fails if the stream has been reset and its DATA frames dropped, which is harmless.
+    nghttp2_session_resume_data(session_, stream.stream_id_);
+    rc = nghttp2_session_send(session_);
+  }
+  // Write everything nghttp2 produced at once, including the frames sent before any failure.
+  if (outbound_frames_.length() > 0) {
+    if (max_outbound_data_bytes_ > 0) {
+      outbound_bytes_ += outbound_frames_.length();
+    }
+    connection_.write(outbound_frames_, false);
+  }
   if (rc != 0) {
     ASSERT(rc == NGHTTP2_ERR_CALLBACK_FAILURE);
     throw CodecProtocolException(fmt::format("{}", nghttp2_strerror(rc)));
@@ -599,6 +728,62 @@ void ConnectionImpl::sendPendingFrames() {
   }
 }
 
+void ConnectionImpl::enableStreamScheduling(const Http2Settings& http2_settings) {
+  if (http2_settings.max_outbound_data_bytes_ == 0) {
+    return;
+  }
+  max_outbound_data_bytes_ = http2_settings.max_outbound_data_bytes_;
+  stream_scheduling_policy_ = http2_settings.stream_scheduling_policy_;
+  connection_.addBytesSentCallback([this](uint64_t bytes) -> void { onBytesSent(bytes); });
+}
+
+void ConnectionImpl::onBytesSent(uint64_t bytes) {
+  outbound_bytes_ -= std::min(outbound_bytes_, bytes);
+  if (!scheduled_streams_.empty() && outbound_bytes_ < max_outbound_data_bytes_) {
+    sendPendingFrames();
+  }
+}
+
+void ConnectionImpl::scheduleStream(StreamImpl& stream) {
+  if (!stream.scheduled_) {
+    stream.scheduled_ = scheduled_streams_.insert(scheduled_streams_.end(), &stream);
+  }
+}
+
+void ConnectionImpl::unscheduleStream(StreamImpl& stream) {
+  if (stream.scheduled_) {
+    scheduled_streams_.erase(stream.scheduled_.value());
+    stream.scheduled_.reset();
+  }
+}
+
+ConnectionImpl::StreamImpl& ConnectionImpl::nextScheduledStream() {
+  // The turn of a stream at the default weight, as much as fits in a DATA frame of the default
+  // maximum size.
+  static const uint64_t DefaultQuantum = 16 * 1024;
+
+  auto next = scheduled_streams_.begin();
+  if (stream_scheduling_policy_ == Http2Settings::StreamSchedulingPolicy::SmallestFirst) {
+    for (auto it = scheduled_streams_.begin(); it != scheduled_streams_.end(); ++it) {
+      if ((*it)->pending_send_data_.length() < (*next)->pending_send_data_.length()) {
+        next = it;
+      }
+    }
+  }
+  StreamImpl& stream = **next;
+  unscheduleStream(stream);
+
+  stream.send_quantum_ = DefaultQuantum;
+  if (stream_scheduling_policy_ == Http2Settings::StreamSchedulingPolicy::Weighted) {
+    nghttp2_stream* nghttp2_stream = nghttp2_session_find_stream(session_, stream.stream_id_);
+    if (nghttp2_stream != nullptr) {
+      stream.send_quantum_ =
+          DefaultQuantum * nghttp2_stream_get_weight(nghttp2_stream) / NGHTTP2_DEFAULT_WEIGHT;
+    }
+  }
+  return stream;
+}
+
 void ConnectionImpl::sendSettings(const Http2Settings& http2_settings, bool disable_push) {
   ASSERT(http2_settings.hpack_table_size_ <= Http2Settings::MAX_HPACK_TABLE_SIZE);
   ASSERT(Http2Settings::MIN_MAX_CONCURRENT_STREAMS <= http2_settings.max_concurrent_streams_ &&
@@ -768,8 +953,8 @@ ClientConnectionImpl::ClientConnectionImpl(Network::Connection& connection,
                                            Stats::Scope& stats, const Http2Settings& http2_settings)
     : ConnectionImpl(connection, stats, http2_settings), callbacks_(callbacks) {
   ClientHttp2Options client_http2_options(http2_settings);
-  nghttp2_session_client_new2(&session_, http2_callbacks_.callbacks(), base(),
-                              client_http2_options.options());
+  nghttp2_session_client_new3(&session_, http2_callbacks_.callbacks(), base(),
+                              client_http2_options.options(), accountedMemory());
   sendSettings(http2_settings, true);
 }
 
@@ -814,9 +999,10 @@ ServerConnectionImpl::ServerConnectionImpl(Network::Connection& connection,
                                            Stats::Scope& scope, const Http2Settings& http2_settings)
     : ConnectionImpl(connection, scope, http2_settings), callbacks_(callbacks) {
   Http2Options http2_options(http2_settings);
-  nghttp2_session_server_new2(&session_, http2_callbacks_.callbacks(), base(),
-                              http2_options.options());
+  nghttp2_session_server_new3(&session_, http2_callbacks_.callbacks(), base(),
+                              http2_options.options(), accountedMemory());
   sendSettings(http2_settings, false);
+  enableStreamScheduling(http2_settings);
 }
 
 int ServerConnectionImpl::onBeginHeaders(const nghttp2_frame* frame) {
@@ -77,8 +77,14 @@ public:
                  const Http2Settings& http2_settings)
       : stats_{ALL_HTTP2_CODEC_STATS(POOL_COUNTER_PREFIX(stats, "http2."))},
         connection_(connection),
-        per_stream_buffer_limit_(http2_settings.initial_stream_window_size_), dispatching_(false),
-        raised_goaway_(false), pending_deferred_reset_(false) {}
+        per_stream_buffer_limit_(http2_settings.initial_stream_window_size_),
+        never_index_headers_(http2_settings.hpack_never_index_headers_), dispatching_(false),
+        raised_goaway_(false), pending_deferred_reset_(false) {
+    if (http2_settings.max_coalesced_write_bytes_ > 0) {
+      connection_.setWriteCoalescing(http2_settings.max_coalesced_write_bytes_,
+                                     http2_settings.max_coalesced_write_delay_);
+    }
+  }
 
   ~ConnectionImpl();
 
@@ -149,7 +155,6 @@ protected:
     ssize_t onDataSourceRead(uint64_t length, uint32_t* data_flags);
     int onDataSourceSend(const uint8_t* framehd, size_t length);
     void resetStreamWorker(StreamResetReason reason);
-    static void buildHeaders(std::vector<nghttp2_nv>& final_headers, const HeaderMap& headers);
     void saveHeader(HeaderString&& name, HeaderString&& value);
     virtual void submitHeaders(const std::vector<nghttp2_nv>& final_headers,
                                nghttp2_data_provider* provider) PURE;
@@ -192,7 +197,9 @@ protected:
     // to the decoder_.
     void decodeHeaders();
 
-    virtual void transformUpgradeFromH1toH2(HeaderMap& headers) PURE;
+    // Rewrites the headers built for an HTTP/1 upgrade into an HTTP/2 extended CONNECT.
+    virtual void transformUpgradeFromH1toH2(const HeaderMap& headers,
+                                            std::vector<nghttp2_nv>& final_headers) PURE;
     virtual void maybeTransformUpgradeFromH2ToH1() PURE;
 
     bool buffers_overrun() const { return read_disable_count_ > 0; }
@@ -212,6 +219,11 @@ protected:
     HeaderMapPtr pending_trailers_;
     absl::optional<StreamResetReason> deferred_reset_;
     HeaderString cookies_;
+    // With stream scheduling, the bytes of DATA frames the stream may still send in its turn.
+    uint64_t send_quantum_{0};
+    // With stream scheduling, the position of the stream in ConnectionImpl::scheduled_streams_
+    // while it waits for a turn.
+    absl::optional<std::list<StreamImpl*>::iterator> scheduled_;
     bool local_end_stream_sent_ : 1;
     bool remote_end_stream_ : 1;
     bool data_deferred_ : 1;
@@ -232,10 +244,8 @@ protected:
     // StreamImpl
     void submitHeaders(const std::vector<nghttp2_nv>& final_headers,
                        nghttp2_data_provider* provider) override;
-    void transformUpgradeFromH1toH2(HeaderMap& headers) override {
-      upgrade_type_ = headers.Upgrade()->value().c_str();
-      Http::Utility::transformUpgradeRequestFromH1toH2(headers);
-    }
+    void transformUpgradeFromH1toH2(const HeaderMap& headers,
+                                    std::vector<nghttp2_nv>& final_headers) override;
     void maybeTransformUpgradeFromH2ToH1() override {
       if (!upgrade_type_.empty() && headers_->Status()) {
         Http::Utility::transformUpgradeResponseFromH2toH1(*headers_, upgrade_type_);
@@ -258,9 +268,8 @@ protected:
     }
     void submitHeaders(const std::vector<nghttp2_nv>& final_headers,
                        nghttp2_data_provider* provider) override;
-    void transformUpgradeFromH1toH2(HeaderMap& headers) override {
-      Http::Utility::transformUpgradeResponseFromH1toH2(headers);
-    }
+    void transformUpgradeFromH1toH2(const HeaderMap& headers,
+                                    std::vector<nghttp2_nv>& final_headers) override;
     void maybeTransformUpgradeFromH2ToH1() override {
       if (Http::Utility::isH2UpgradeRequest(*headers_)) {
         Http::Utility::transformUpgradeRequestFromH2toH1(*headers_);
@@ -271,8 +280,20 @@ protected:
   ConnectionImpl* base() { return this; }
   StreamImpl* getStream(int32_t stream_id);
   int saveHeader(const nghttp2_frame* frame, HeaderString&& name, HeaderString&& value);
+  /**
+   * Build the nghttp2 header list of a header map in final_headers_, which is reused by every
+   * HEADERS frame of the connection since nghttp2 copies the list when a frame is submitted.
+   * @return std::vector<nghttp2_nv>& the header list, valid until the next call.
+   */
+  std::vector<nghttp2_nv>& buildHeaders(const HeaderMap& headers);
   void sendPendingFrames();
   void sendSettings(const Http2Settings& http2_settings, bool disable_push);
+  /**
+   * Schedule the DATA frames of the streams, so that streams take turns at sending according to
+   * the policy of the settings, and only while the bytes written to the connection but not yet to
+   * the socket are within the budget of the settings.
+   */
+  void enableStreamScheduling(const Http2Settings& http2_settings);
 
   static Http2Callbacks http2_callbacks_;
 
@@ -280,7 +301,12 @@ protected:
   nghttp2_session* session_{};
   CodecStats stats_;
   Network::Connection& connection_;
+  // Frames produced by one nghttp2_session_send(), written to the connection together.
+  Buffer::OwnedImpl outbound_frames_;
   uint32_t per_stream_buffer_limit_;
+  // Header names which are encoded as never indexed. @see Http2Settings.
+  const std::vector<std::string> never_index_headers_;
+  std::vector<nghttp2_nv> final_headers_;
 
 private:
   virtual ConnectionCallbacks& callbacks() PURE;
@@ -292,7 +318,19 @@ private:
   int onInvalidFrame(int32_t stream_id, int error_code);
   ssize_t onSend(const uint8_t* data, size_t length);
   int onStreamClose(int32_t stream_id, uint32_t error_code);
-
+  void onBytesSent(uint64_t bytes);
+  void scheduleStream(StreamImpl& stream);
+  void unscheduleStream(StreamImpl& stream);
+  // Removes the stream whose turn is next from scheduled_streams_ and grants it its quantum.
+  StreamImpl& nextScheduledStream();
+
+  // The budget of stream scheduling, 0 if it is disabled. @see Http2Settings.
+  uint64_t max_outbound_data_bytes_{0};
+  Http2Settings::StreamSchedulingPolicy stream_scheduling_policy_{};
+  // The bytes written to the connection but not yet to the socket, with stream scheduling.
+  uint64_t outbound_bytes_{0};
+  // The streams with data pending which have used up their quantum, in the order they did.
+  std::list<StreamImpl*> scheduled_streams_;
   bool dispatching_ : 1;
   bool raised_goaway_ : 1;
   bool pending_deferred_reset_ : 1;
@@ -0,0 +1,80 @@
+#include "common/http/request_attributes_impl.h"
+
+#include "common/common/empty_string.h"
+#include "common/http/headers.h"
+#include "common/http/utility.h"
+
+namespace Envoy {
+namespace Http {
+
+absl::string_view RequestAttributesImpl::pathWithoutQuery(const HeaderMap& headers) {
+  if (headers.Path() == nullptr) {
+    return {};
+  }
+  const HeaderString& path = headers.Path()->value();
+  return absl::string_view(path.c_str(), Utility::findQueryStringStart(path) - path.c_str());
+}
+
+const Utility::QueryParams& RequestAttributesImpl::queryParams(const HeaderMap& headers) {
+  const absl::string_view path = headers.Path() != nullptr
+                                     ? absl::string_view(headers.Path()->value().c_str(),
+                                                         headers.Path()->value().size())
+                                     : absl::string_view();
+  if (!query_params_path_ || query_params_path_.value() != path) {
+    query_params_ = Utility::parseQueryString(path);
+    query_params_path_ = std::string(path);
+  }
+  return query_params_;
+}
+
+const std::string& RequestAttributesImpl::cookieValue(const HeaderMap& headers,
+                                                      const std::string& name) {
+  if (cookieHeadersChanged(headers)) {
+    cookies_ = Utility::parseCookies(headers);
+    cookie_headers_.emplace();
+    headers.iterate(
+        [](const HeaderEntry& header, void* context) -> HeaderMap::Iterate {
+          if (header.key() == Headers::get().Cookie.get().c_str()) {
+            static_cast<std::vector<std::string>*>(context)->emplace_back(header.value().c_str(),
+                                                                          header.value().size());
+          }
+          return HeaderMap::Iterate::Continue;
+        },
+        &cookie_headers_.value());
+  }
+
+  auto it = cookies_.find(name);
+  return it != cookies_.end() ? it->second : EMPTY_STRING;
+}
+
+bool RequestAttributesImpl::cookieHeadersChanged(const HeaderMap& headers) const {
+  if (!cookie_headers_) {
+    return true;
+  }
+
+  struct State {
+    const std::vector<std::string>& previous_;
+    size_t index_;
+    bool changed_;
+  };
+  State state{cookie_headers_.value(), 0, false};
+  headers.iterate(
+      [](const HeaderEntry& header, void* context) -> HeaderMap::Iterate {
+        if (header.key() != Headers::get().Cookie.get().c_str()) {
+          return HeaderMap::Iterate::Continue;
+        }
+        State* state = static_cast<State*>(context);
+        if (state->index_ == state->previous_.size() ||
+            state->previous_[state->index_] != header.value().c_str()) {
+          state->changed_ = true;
+          return HeaderMap::Iterate::Break;
+        }
+        state->index_++;
+        return HeaderMap::Iterate::Continue;
+      },
+      &state);
+  return state.changed_ || state.index_ != cookie_headers_.value().size();
+}
+
+} // namespace Http
+} // namespace Envoy
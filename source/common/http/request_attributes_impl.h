@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "envoy/http/request_attributes.h"
+
+#include "absl/types/optional.h"
+
+namespace Envoy {
+namespace Http {
+
+/**
+ * Implementation of RequestAttributes that keeps, with each parsed attribute, the header values it
+ * was parsed from. Checking that they did not change is a comparison, much cheaper than parsing
+ * them again.
+ */
+class RequestAttributesImpl : public RequestAttributes {
+public:
+  // Http::RequestAttributes
+  absl::string_view pathWithoutQuery(const HeaderMap& headers) override;
+  const Utility::QueryParams& queryParams(const HeaderMap& headers) override;
+  const std::string& cookieValue(const HeaderMap& headers, const std::string& name) override;
+
+private:
+  bool cookieHeadersChanged(const HeaderMap& headers) const;
+
+  // The path that query_params_ were parsed from, if they were.
+  absl::optional<std::string> query_params_path_;
+  Utility::QueryParams query_params_;
+  // The values of the cookie headers that cookies_ were parsed from, in order, if they were.
+  absl::optional<std::vector<std::string>> cookie_headers_;
+  std::unordered_map<std::string, std::string> cookies_;
+};
+
+} // namespace Http
+} // namespace Envoy
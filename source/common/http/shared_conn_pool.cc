@@ -0,0 +1,345 @@
+#include "common/http/shared_conn_pool.h"
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <vector>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/common/assert.h"
+#include "common/http/header_map_impl.h"
+
+namespace Envoy {
+namespace Http {
+
+ConnectionPool::InstancePtr SharedConnPoolRegistry::pool(const Upstream::HostDescription& host,
+                                                         const std::vector<uint8_t>& key,
+                                                         Event::Dispatcher& dispatcher,
+                                                         const PoolFactory& factory) {
+  const Key entry_key{&host, key};
+  Thread::LockGuard lock(lock_);
+  Entry& entry = entries_[entry_key];
+  // The weak pointer is never locked here since the last strong reference must only be dropped
+  // on the owner's dispatcher. A pool that expires right after this check fails the streams handed
+  // to it, and the next pool lookup for the host creates a new owner.
+  if (entry.pool_.expired()) {
+    SharedConnPoolSharedPtr shared_pool = std::make_shared<SharedConnPool>(factory());
+    entry.dispatcher_ = &dispatcher;
+    entry.pool_ = shared_pool;
+    entry.protocol_ = shared_pool->pool_->protocol();
+    return std::make_unique<OwnerConnPool>(shared_from_this(), entry_key, shared_pool);
+  }
+
+  return std::make_unique<CrossThreadConnPool>(dispatcher, *entry.dispatcher_, entry.pool_,
+                                               entry.protocol_);
+}
+
+void SharedConnPoolRegistry::remove(const Key& key, const SharedConnPoolSharedPtr& pool) {
+  Thread::LockGuard lock(lock_);
+  auto it = entries_.find(key);
+  // A new owner may already have replaced the entry if the pool was drained.
+  if (it != entries_.end() && !it->second.pool_.owner_before(pool) &&
+      !pool.owner_before(it->second.pool_)) {
+    entries_.erase(it);
+  }
+}
+
+OwnerConnPool::~OwnerConnPool() { registry_->remove(key_, pool_); }
+
+void OwnerConnPool::addDrainedCallback(DrainedCb cb) {
+  pool_->draining_ = true;
+  pool_->pool_->addDrainedCallback(cb);
+}
+
+CrossThreadStream::CrossThreadStream(CrossThreadConnPool& parent, StreamDecoder& decoder,
+                                     ConnectionPool::Callbacks& callbacks)
+    : dispatcher_(parent.dispatcher_), owner_dispatcher_(parent.owner_dispatcher_),
+      pool_(parent.pool_), parent_(&parent), decoder_(&decoder), callbacks_(&callbacks) {}
+
+void CrossThreadStream::start() {
+  postToOwner([](CrossThreadStream& stream) {
+    SharedConnPoolSharedPtr pool = stream.pool_.lock();
+    if (pool == nullptr || pool->draining_) {
+      stream.onPoolFailure(ConnectionPool::PoolFailureReason::ConnectionFailure, nullptr);
+      return;
+    }
+
+    ConnectionPool::Cancellable* handle = pool->pool_->newStream(stream, stream);
+    if (handle != nullptr) {
+      stream.owner_handle_ = handle;
+    }
+  });
+}
+
+void CrossThreadStream::abandon() {
+  ASSERT(!worker_done_);
+  worker_done_ = true;
+  parent_ = nullptr;
+  postCancelToOwner();
+}
+
+void CrossThreadStream::cancel() {
+  CrossThreadStreamSharedPtr self = shared_from_this();
+  postCancelToOwner();
+  onWorkerDone();
+}
+
+void CrossThreadStream::encodeHeaders(const HeaderMap& headers, bool end_stream) {
+  local_end_stream_ = end_stream;
+  std::shared_ptr<HeaderMapImpl> copy = std::make_shared<HeaderMapImpl>(headers);
+  postToOwner([copy, end_stream](CrossThreadStream& stream) {
+    if (stream.owner_encoder_ != nullptr) {
+      stream.owner_encoder_->encodeHeaders(*copy, end_stream);
+      if (end_stream) {
+        stream.onOwnerLocalComplete();
+      }
+    }
+  });
+}
+
+void CrossThreadStream::encodeData(Buffer::Instance& data, bool end_stream) {
+  local_end_stream_ = end_stream;
+  std::shared_ptr<Buffer::OwnedImpl> buffer = std::make_shared<Buffer::OwnedImpl>();
+  buffer->move(data);
+  postToOwner([buffer, end_stream](CrossThreadStream& stream) {
+    if (stream.owner_encoder_ != nullptr) {
+      stream.owner_encoder_->encodeData(*buffer, end_stream);
+      if (end_stream) {
+        stream.onOwnerLocalComplete();
+      }
+    }
+  });
+}
+
+void CrossThreadStream::encodeTrailers(const HeaderMap& trailers) {
+  local_end_stream_ = true;
+  std::shared_ptr<HeaderMapImpl> copy = std::make_shared<HeaderMapImpl>(trailers);
+  postToOwner([copy](CrossThreadStream& stream) {
+    if (stream.owner_encoder_ != nullptr) {
+      stream.owner_encoder_->encodeTrailers(*copy);
+      stream.onOwnerLocalComplete();
+    }
+  });
+}
+
+void CrossThreadStream::resetStream(StreamResetReason reason) {
+  CrossThreadStreamSharedPtr self = shared_from_this();
+  runResetCallbacks(reason);
+  postToOwner([reason](CrossThreadStream& stream) {
+    if (stream.owner_encoder_ != nullptr) {
+      stream.owner_encoder_->getStream().resetStream(reason);
+    }
+  });
+  onWorkerDone();
+}
+
+void CrossThreadStream::readDisable(bool disable) {
+  postToOwner([disable](CrossThreadStream& stream) {
+    if (stream.owner_encoder_ != nullptr) {
+      stream.owner_encoder_->getStream().readDisable(disable);
+    }
+  });
+}
+
+void CrossThreadStream::decode100ContinueHeaders(HeaderMapPtr&& headers) {
+  std::shared_ptr<HeaderMapPtr> holder = std::make_shared<HeaderMapPtr>(std::move(headers));
+  postToWorker([holder](CrossThreadStream& stream) {
+    stream.decoder_->decode100ContinueHeaders(std::move(*holder));
+  });
+}
+
+void CrossThreadStream::decodeHeaders(HeaderMapPtr&& headers, bool end_stream) {
+  if (end_stream) {
+    onOwnerRemoteComplete();
+  }
+  std::shared_ptr<HeaderMapPtr> holder = std::make_shared<HeaderMapPtr>(std::move(headers));
+  postToWorker([holder, end_stream](CrossThreadStream& stream) {
+    stream.worker_remote_complete_ = end_stream;
+    stream.decoder_->decodeHeaders(std::move(*holder), end_stream);
+    stream.onWorkerRemoteComplete();
+  });
+}
+
+void CrossThreadStream::decodeData(Buffer::Instance& data, bool end_stream) {
+  if (end_stream) {
+    onOwnerRemoteComplete();
+  }
+  std::shared_ptr<Buffer::OwnedImpl> buffer = std::make_shared<Buffer::OwnedImpl>();
+  buffer->move(data);
+  postToWorker([buffer, end_stream](CrossThreadStream& stream) {
+    stream.worker_remote_complete_ = end_stream;
+    stream.decoder_->decodeData(*buffer, end_stream);
+    stream.onWorkerRemoteComplete();
+  });
+}
+
+void CrossThreadStream::decodeTrailers(HeaderMapPtr&& trailers) {
+  onOwnerRemoteComplete();
+  std::shared_ptr<HeaderMapPtr> holder = std::make_shared<HeaderMapPtr>(std::move(trailers));
+  postToWorker([holder](CrossThreadStream& stream) {
+    stream.worker_remote_complete_ = true;
+    stream.decoder_->decodeTrailers(std::move(*holder));
+    stream.onWorkerRemoteComplete();
+  });
+}
+
+void CrossThreadStream::onResetStream(StreamResetReason reason) {
+  owner_encoder_ = nullptr;
+  postToWorker([reason](CrossThreadStream& stream) {
+    stream.runResetCallbacks(reason);
+    stream.onWorkerDone();
+  });
+}
+
+void CrossThreadStream::onAboveWriteBufferHighWatermark() {
+  postToWorker([](CrossThreadStream& stream) { stream.runHighWatermarkCallbacks(); });
+}
+
+void CrossThreadStream::onBelowWriteBufferLowWatermark() {
+  postToWorker([](CrossThreadStream& stream) { stream.runLowWatermarkCallbacks(); });
+}
+
+void CrossThreadStream::onPoolFailure(ConnectionPool::PoolFailureReason reason,
+                                      Upstream::HostDescriptionConstSharedPtr host) {
+  owner_handle_ = nullptr;
+  postToWorker([reason, host](CrossThreadStream& stream) {
+    ConnectionPool::Callbacks& callbacks = *stream.callbacks_;
+    stream.onWorkerDone();
+    callbacks.onPoolFailure(reason, host);
+  });
+}
+
+void CrossThreadStream::onPoolReady(StreamEncoder& encoder,
+                                    Upstream::HostDescriptionConstSharedPtr host) {
+  owner_handle_ = nullptr;
+  owner_encoder_ = &encoder;
+  encoder.getStream().addCallbacks(*this);
+  const uint32_t buffer_limit = encoder.getStream().bufferLimit();
+  postToWorker([host, buffer_limit](CrossThreadStream& stream) {
+    stream.buffer_limit_ = buffer_limit;
+    stream.callbacks_->onPoolReady(stream, host);
+  });
+}
+
+void CrossThreadStream::postCancelToOwner() {
+  postToOwner([](CrossThreadStream& stream) {
+    if (stream.owner_handle_ != nullptr) {
+      stream.owner_handle_->cancel();
+      stream.owner_handle_ = nullptr;
+    } else if (stream.owner_encoder_ != nullptr) {
+      // The stream became ready on the owner before the cancellation arrived.
+      stream.owner_encoder_->getStream().resetStream(StreamResetReason::LocalReset);
+    }
+  });
+}
+
+void CrossThreadStream::postToOwner(std::function<void(CrossThreadStream&)> cb) {
+  CrossThreadStreamSharedPtr self = shared_from_this();
+  owner_dispatcher_.post([self, cb]() { cb(*self); });
+}
+
+void CrossThreadStream::postToWorker(std::function<void(CrossThreadStream&)> cb) {
+  CrossThreadStreamSharedPtr self = shared_from_this();
+  dispatcher_.post([self, cb]() {
+    // Events that arrive after the worker reset, cancelled or completed the stream are dropped.
+    if (!self->worker_done_) {
+      cb(*self);
+    }
+  });
+}
+
+void CrossThreadStream::onOwnerLocalComplete() {
+  owner_local_complete_ = true;
+  if (owner_remote_complete_) {
+    // The codec destroys the stream once both directions are complete.
+    owner_encoder_ = nullptr;
+  }
+}
+
+void CrossThreadStream::onOwnerRemoteComplete() {
+  owner_remote_complete_ = true;
+  if (owner_local_complete_) {
+    owner_encoder_ = nullptr;
+  }
+}
+
+void CrossThreadStream::onWorkerRemoteComplete() {
+  if (worker_remote_complete_ && local_end_stream_) {
+    onWorkerDone();
+  }
+}
+
+void CrossThreadStream::onWorkerDone() {
+  if (worker_done_) {
+    return;
+  }
+
+  worker_done_ = true;
+  decoder_ = nullptr;
+  callbacks_ = nullptr;
+  CrossThreadConnPool* parent = parent_;
+  parent_ = nullptr;
+  parent->onStreamDone(*this);
+}
+
+CrossThreadConnPool::CrossThreadConnPool(Event::Dispatcher& dispatcher,
+                                         Event::Dispatcher& owner_dispatcher,
+                                         SharedConnPoolWeakPtr pool, Protocol protocol)
+    : dispatcher_(dispatcher), owner_dispatcher_(owner_dispatcher), pool_(pool),
+      protocol_(protocol) {}
+
+CrossThreadConnPool::~CrossThreadConnPool() {
+  for (auto& stream : streams_) {
+    stream.second->abandon();
+  }
+}
+
+void CrossThreadConnPool::addDrainedCallback(DrainedCb cb) {
+  drained_callbacks_.push_back(cb);
+  checkForDrained();
+}
+
+void CrossThreadConnPool::drainConnections() {
+  SharedConnPoolWeakPtr weak_pool = pool_;
+  owner_dispatcher_.post([weak_pool]() {
+    SharedConnPoolSharedPtr pool = weak_pool.lock();
+    if (pool != nullptr) {
+      pool->pool_->drainConnections();
+    }
+  });
+}
+
+void CrossThreadConnPool::prefetch() {
+  SharedConnPoolWeakPtr weak_pool = pool_;
+  owner_dispatcher_.post([weak_pool]() {
+    SharedConnPoolSharedPtr pool = weak_pool.lock();
+    if (pool != nullptr && !pool->draining_) {
+      pool->pool_->prefetch();
+    }
+  });
+}
+
+ConnectionPool::Cancellable* CrossThreadConnPool::newStream(StreamDecoder& response_decoder,
+                                                            ConnectionPool::Callbacks& callbacks) {
+  CrossThreadStreamSharedPtr stream =
+      std::make_shared<CrossThreadStream>(*this, response_decoder, callbacks);
+  streams_.emplace(stream.get(), stream);
+  stream->start();
+  return stream.get();
+}
+
+void CrossThreadConnPool::onStreamDone(CrossThreadStream& stream) {
+  streams_.erase(&stream);
+  checkForDrained();
+}
+
+void CrossThreadConnPool::checkForDrained() {
+  if (!drained_callbacks_.empty() && streams_.empty()) {
+    for (const DrainedCb& cb : drained_callbacks_) {
+      cb();
+    }
+  }
+}
+
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "envoy/event/dispatcher.h"
+#include "envoy/http/codec.h"
+#include "envoy/http/conn_pool.h"
+#include "envoy/upstream/upstream.h"
+
+#include "common/common/lock_guard.h"
+#include "common/common/thread.h"
+#include "common/http/codec_helper.h"
+
+namespace Envoy {
+namespace Http {
+
+/**
+ * State shared between the worker that owns a shared connection pool and the workers that use it.
+ * The pool itself is only ever touched on the owner's dispatcher.
+ */
+struct SharedConnPool {
+  SharedConnPool(ConnectionPool::InstancePtr&& pool) : pool_(std::move(pool)) {}
+
+  ConnectionPool::InstancePtr pool_;
+  // Set once the owner starts draining the pool. Streams handed over afterwards fail, since a
+  // draining pool must not be given new streams.
+  bool draining_{};
+};
+
+typedef std::shared_ptr<SharedConnPool> SharedConnPoolSharedPtr;
+typedef std::weak_ptr<SharedConnPool> SharedConnPoolWeakPtr;
+
+class SharedConnPoolRegistry;
+typedef std::shared_ptr<SharedConnPoolRegistry> SharedConnPoolRegistrySharedPtr;
+
+/**
+ * Process wide registry of HTTP connection pools shared across workers. The first worker to ask
+ * for a pool to a host creates and owns it; every other worker gets a proxy that hands its streams
+ * to the owner's dispatcher.
+ */
+class SharedConnPoolRegistry : public std::enable_shared_from_this<SharedConnPoolRegistry> {
+public:
+  typedef std::function<ConnectionPool::InstancePtr()> PoolFactory;
+  typedef std::pair<const Upstream::HostDescription*, std::vector<uint8_t>> Key;
+
+  /**
+   * Return a pool for the given host and pool key to be used on the calling worker.
+   * @param host supplies the host the pool connects to.
+   * @param key supplies the key of the pool within the host, e.g. protocol and priority.
+   * @param dispatcher supplies the dispatcher of the calling worker.
+   * @param factory creates the real pool if the calling worker becomes its owner.
+   */
+  ConnectionPool::InstancePtr pool(const Upstream::HostDescription& host,
+                                   const std::vector<uint8_t>& key, Event::Dispatcher& dispatcher,
+                                   const PoolFactory& factory);
+
+private:
+  struct Entry {
+    Event::Dispatcher* dispatcher_;
+    SharedConnPoolWeakPtr pool_;
+    Protocol protocol_;
+  };
+
+  void remove(const Key& key, const SharedConnPoolSharedPtr& pool);
+
+  Thread::MutexBasicLockable lock_;
+  std::map<Key, Entry> entries_ GUARDED_BY(lock_);
+
+  friend class OwnerConnPool;
+};
+
+/**
+ * The pool handed to the owning worker. It holds the only strong reference to the shared pool so
+ * the real pool is destroyed on the owner's dispatcher.
+ */
+class OwnerConnPool : public ConnectionPool::Instance {
+public:
+  OwnerConnPool(SharedConnPoolRegistrySharedPtr registry, const SharedConnPoolRegistry::Key& key,
+                SharedConnPoolSharedPtr pool)
+      : registry_(registry), key_(key), pool_(pool) {}
+  ~OwnerConnPool();
+
+  // ConnectionPool::Instance
+  Protocol protocol() const override { return pool_->pool_->protocol(); }
+  void addDrainedCallback(DrainedCb cb) override;
+  void drainConnections() override { pool_->pool_->drainConnections(); }
+  void prefetch() override { pool_->pool_->prefetch(); }
+  ConnectionPool::Cancellable* newStream(StreamDecoder& response_decoder,
+                                         ConnectionPool::Callbacks& callbacks) override {
+    return pool_->pool_->newStream(response_decoder, callbacks);
+  }
+
+private:
+  SharedConnPoolRegistrySharedPtr registry_;
+  const SharedConnPoolRegistry::Key key_;
+  SharedConnPoolSharedPtr pool_;
+};
+
+class CrossThreadConnPool;
+
+/**
+ * A stream started on one worker and running on the owner's pool. Worker side methods (the
+ * encoder, the stream and the cancellable handed to the caller) only run on the worker's
+ * dispatcher; owner side methods (the decoder, stream callbacks and pool callbacks handed to the
+ * real pool) only run on the owner's dispatcher. Each side posts events to the other and drops the
+ * ones that arrive after it is done with the stream.
+ */
+class CrossThreadStream : public std::enable_shared_from_this<CrossThreadStream>,
+                          public ConnectionPool::Cancellable,
+                          public StreamEncoder,
+                          public Stream,
+                          public StreamCallbackHelper,
+                          public StreamDecoder,
+                          public StreamCallbacks,
+                          public ConnectionPool::Callbacks {
+public:
+  CrossThreadStream(CrossThreadConnPool& parent, StreamDecoder& decoder,
+                    ConnectionPool::Callbacks& callbacks);
+
+  /**
+   * Hand the stream to the owner's pool.
+   */
+  void start();
+
+  /**
+   * Called when the worker side pool goes away before the stream completes.
+   */
+  void abandon();
+
+  // ConnectionPool::Cancellable
+  void cancel() override;
+
+  // Http::StreamEncoder
+  void encode100ContinueHeaders(const HeaderMap&) override { NOT_REACHED_GCOVR_EXCL_LINE; }
+  void encodeHeaders(const HeaderMap& headers, bool end_stream) override;
+  void encodeData(Buffer::Instance& data, bool end_stream) override;
+  void encodeTrailers(const HeaderMap& trailers) override;
+  Stream& getStream() override { return *this; }
+
+  // Http::Stream
+  void addCallbacks(StreamCallbacks& callbacks) override { addCallbacks_(callbacks); }
+  void removeCallbacks(StreamCallbacks& callbacks) override { removeCallbacks_(callbacks); }
+  void resetStream(StreamResetReason reason) override;
+  void readDisable(bool disable) override;
+  uint32_t bufferLimit() override { return buffer_limit_; }
+
+  // Http::StreamDecoder
+  void decode100ContinueHeaders(HeaderMapPtr&& headers) override;
+  void decodeHeaders(HeaderMapPtr&& headers, bool end_stream) override;
+  void decodeData(Buffer::Instance& data, bool end_stream) override;
+  void decodeTrailers(HeaderMapPtr&& trailers) override;
+
+  // Http::StreamCallbacks
+  void onResetStream(StreamResetReason reason) override;
+  void onAboveWriteBufferHighWatermark() override;
+  void onBelowWriteBufferLowWatermark() override;
+
+  // ConnectionPool::Callbacks
+  void onPoolFailure(ConnectionPool::PoolFailureReason reason,
+                     Upstream::HostDescriptionConstSharedPtr host) override;
+  void onPoolReady(StreamEncoder& encoder, Upstream::HostDescriptionConstSharedPtr host) override;
+
+private:
+  void postCancelToOwner();
+  void postToOwner(std::function<void(CrossThreadStream&)> cb);
+  void postToWorker(std::function<void(CrossThreadStream&)> cb);
+  void onOwnerLocalComplete();
+  void onOwnerRemoteComplete();
+  void onWorkerRemoteComplete();
+  void onWorkerDone();
+
+  Event::Dispatcher& dispatcher_;
+  Event::Dispatcher& owner_dispatcher_;
+  const SharedConnPoolWeakPtr pool_;
+
+  // Only used on the worker's dispatcher.
+  CrossThreadConnPool* parent_;
+  StreamDecoder* decoder_;
+  ConnectionPool::Callbacks* callbacks_;
+  uint32_t buffer_limit_{};
+  bool worker_remote_complete_{};
+  bool worker_done_{};
+
+  // Only used on the owner's dispatcher.
+  ConnectionPool::Cancellable* owner_handle_{};
+  StreamEncoder* owner_encoder_{};
+  bool owner_local_complete_{};
+  bool owner_remote_complete_{};
+};
+
+typedef std::shared_ptr<CrossThreadStream> CrossThreadStreamSharedPtr;
+
+/**
+ * The pool handed to workers other than the owner. Streams are started on the owner's pool and
+ * their events are posted between the two dispatchers. The pool is drained once the streams
+ * started through it have completed.
+ */
+class CrossThreadConnPool : public ConnectionPool::Instance {
+public:
+  CrossThreadConnPool(Event::Dispatcher& dispatcher, Event::Dispatcher& owner_dispatcher,
+                      SharedConnPoolWeakPtr pool, Protocol protocol);
+  ~CrossThreadConnPool();
+
+  // ConnectionPool::Instance
+  Protocol protocol() const override { return protocol_; }
+  void addDrainedCallback(DrainedCb cb) override;
+  void drainConnections() override;
+  void prefetch() override;
+  ConnectionPool::Cancellable* newStream(StreamDecoder& response_decoder,
+                                         ConnectionPool::Callbacks& callbacks) override;
+
+  void onStreamDone(CrossThreadStream& stream);
+
+private:
+  void checkForDrained();
+
+  Event::Dispatcher& dispatcher_;
+  Event::Dispatcher& owner_dispatcher_;
+  const SharedConnPoolWeakPtr pool_;
+  const Protocol protocol_;
+  std::unordered_map<CrossThreadStream*, CrossThreadStreamSharedPtr> streams_;
+  std::list<DrainedCb> drained_callbacks_;
+
+  friend class CrossThreadStream;
+};
+
+} // namespace Http
+} // namespace Envoy
@@ -88,6 +88,41 @@ const char* Utility::findQueryStringStart(const HeaderString& path) {
   return std::find(path.c_str(), path.c_str() + path.size(), '?');
 }
 
+namespace {
+
+/**
+ * Calls cb(name, value) for each cookie of the value of a cookie header, in order, until it
+ * returns false.
+ * @return false if cb returned false.
+ */
+template <class Callback> bool forEachCookie(absl::string_view header_value, Callback cb) {
+  // Split the cookie header into individual cookies.
+  for (const auto s : StringUtil::splitToken(header_value, ";")) {
+    // Find the key part of the cookie (i.e. the name of the cookie).
+    size_t first_non_space = s.find_first_not_of(" ");
+    size_t equals_index = s.find('=');
+    if (equals_index == std::string::npos) {
+      // The cookie is malformed if it does not have an `=`. Continue
+      // checking other cookies in this header.
+      continue;
+    }
+    const absl::string_view k = s.substr(first_non_space, equals_index - first_non_space);
+    absl::string_view v = s.substr(equals_index + 1, s.size() - 1);
+
+    // Cookie values may be wrapped in double quotes.
+    // https://tools.ietf.org/html/rfc6265#section-4.1.1
+    if (v.size() >= 2 && v.back() == '"' && v[0] == '"') {
+      v = v.substr(1, v.size() - 2);
+    }
+    if (!cb(k, v)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
 std::string Utility::parseCookieValue(const HeaderMap& headers, const std::string& key) {
 
   struct State {
@@ -102,30 +137,18 @@ std::string Utility::parseCookieValue(const HeaderMap& headers, const std::strin
       [](const HeaderEntry& header, void* context) -> HeaderMap::Iterate {
         // Find the cookie headers in the request (typically, there's only one).
         if (header.key() == Http::Headers::get().Cookie.get().c_str()) {
-          // Split the cookie header into individual cookies.
-          for (const auto s : StringUtil::splitToken(header.value().c_str(), ";")) {
-            // Find the key part of the cookie (i.e. the name of the cookie).
-            size_t first_non_space = s.find_first_not_of(" ");
-            size_t equals_index = s.find('=');
-            if (equals_index == std::string::npos) {
-              // The cookie is malformed if it does not have an `=`. Continue
-              // checking other cookies in this header.
-              continue;
-            }
-            const absl::string_view k = s.substr(first_non_space, equals_index - first_non_space);
-            State* state = static_cast<State*>(context);
-            // If the key matches, parse the value from the rest of the cookie string.
-            if (k == state->key_) {
-              absl::string_view v = s.substr(equals_index + 1, s.size() - 1);
-
-              // Cookie values may be wrapped in double quotes.
-              // https://tools.ietf.org/html/rfc6265#section-4.1.1
-              if (v.size() >= 2 && v.back() == '"' && v[0] == '"') {
-                v = v.substr(1, v.size() - 2);
-              }
-              state->ret_ = std::string{v};
-              return HeaderMap::Iterate::Break;
-            }
+          State* state = static_cast<State*>(context);
+          const bool found = !forEachCookie(header.value().c_str(),
+                                            [state](absl::string_view k, absl::string_view v) {
+                                              // If the key matches, keep its value.
+                                              if (k == state->key_) {
+                                                state->ret_ = std::string{v};
+                                                return false;
+                                              }
+                                              return true;
+                                            });
+          if (found) {
+            return HeaderMap::Iterate::Break;
           }
         }
         return HeaderMap::Iterate::Continue;
@@ -135,6 +158,26 @@ std::string Utility::parseCookieValue(const HeaderMap& headers, const std::strin
   return state.ret_;
 }
 
+std::unordered_map<std::string, std::string> Utility::parseCookies(const HeaderMap& headers) {
+  std::unordered_map<std::string, std::string> cookies;
+  headers.iterateReverse(
+      [](const HeaderEntry& header, void* context) -> HeaderMap::Iterate {
+        if (header.key() == Http::Headers::get().Cookie.get().c_str()) {
+          auto* cookies = static_cast<std::unordered_map<std::string, std::string>*>(context);
+          // As with parseCookieValue(), the first cookie of a name in the last cookie header that
+          // has it wins, which emplace() gives when iterating in reverse.
+          forEachCookie(header.value().c_str(),
+                        [cookies](absl::string_view k, absl::string_view v) {
+                          cookies->emplace(std::string(k), std::string(v));
+                          return true;
+                        });
+        }
+        return HeaderMap::Iterate::Continue;
+      },
+      &cookies);
+  return cookies;
+}
+
 std::string Utility::makeSetCookieValue(const std::string& key, const std::string& value,
                                         const std::string& path, const std::chrono::seconds max_age,
                                         bool httponly) {
@@ -234,6 +277,26 @@ Utility::parseHttp2Settings(const envoy::api::v2::core::Http2ProtocolOptions& co
       PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, initial_connection_window_size,
                                       Http::Http2Settings::DEFAULT_INITIAL_CONNECTION_WINDOW_SIZE);
   ret.allow_connect_ = config.allow_connect();
+  ret.max_coalesced_write_bytes_ =
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, max_coalesced_write_bytes, 0);
+  ret.max_coalesced_write_delay_ =
+      std::chrono::milliseconds(PROTOBUF_GET_MS_OR_DEFAULT(config, max_coalesced_write_delay, 0));
+  for (const auto& header : config.hpack_never_index_headers()) {
+    ret.hpack_never_index_headers_.push_back(LowerCaseString(header).get());
+  }
+  ret.max_outbound_data_bytes_ =
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, max_outbound_data_bytes, 0);
+  switch (config.stream_scheduling_policy()) {
+  case envoy::api::v2::core::Http2ProtocolOptions::ROUND_ROBIN:
+    ret.stream_scheduling_policy_ = Http2Settings::StreamSchedulingPolicy::RoundRobin;
+    break;
+  case envoy::api::v2::core::Http2ProtocolOptions::SMALLEST_FIRST:
+    ret.stream_scheduling_policy_ = Http2Settings::StreamSchedulingPolicy::SmallestFirst;
+    break;
+  default:
+    ret.stream_scheduling_policy_ = Http2Settings::StreamSchedulingPolicy::Weighted;
+    break;
+  }
   return ret;
 }
 
@@ -243,6 +306,9 @@ Utility::parseHttp1Settings(const envoy::api::v2::core::Http1ProtocolOptions& co
   ret.allow_absolute_url_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, allow_absolute_url, false);
   ret.accept_http_10_ = config.accept_http_10();
   ret.default_host_for_http_10_ = config.default_host_for_http_10();
+  ret.fast_header_parsing_ = config.fast_header_parsing();
+  ret.max_pipelined_requests_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, max_pipelined_requests, 1);
+  ret.coalesce_response_writes_ = config.coalesce_response_writes();
   return ret;
 }
 
@@ -263,6 +329,16 @@ void Utility::sendLocalReply(
     bool is_grpc, std::function<void(HeaderMapPtr&& headers, bool end_stream)> encode_headers,
     std::function<void(Buffer::Instance& data, bool end_stream)> encode_data, const bool& is_reset,
     Code response_code, const std::string& body_text, bool is_head_request) {
+  sendLocalReply(is_grpc, encode_headers, encode_data, is_reset, response_code, body_text,
+                 [&body_text](Buffer::Instance& buffer) -> void { buffer.add(body_text); },
+                 is_head_request);
+}
+
+void Utility::sendLocalReply(
+    bool is_grpc, std::function<void(HeaderMapPtr&& headers, bool end_stream)> encode_headers,
+    std::function<void(Buffer::Instance& data, bool end_stream)> encode_data, const bool& is_reset,
+    Code response_code, const std::string& body_text,
+    const std::function<void(Buffer::Instance& buffer)>& add_body, bool is_head_request) {
   // encode_headers() may reset the stream, so the stream must not be reset before calling it.
   ASSERT(!is_reset);
   // Respond with a gRPC trailers-only response if the request is gRPC
@@ -284,7 +360,8 @@ void Utility::sendLocalReply(
       new HeaderMapImpl{{Headers::get().Status, std::to_string(enumToInt(response_code))}}};
   if (!body_text.empty()) {
     response_headers->insertContentLength().value(body_text.size());
-    response_headers->insertContentType().value(Headers::get().ContentTypeValues.Text);
+    response_headers->insertContentType().value().setReference(
+        Headers::get().ContentTypeValues.Text);
   }
 
   if (is_head_request) {
@@ -295,7 +372,8 @@ void Utility::sendLocalReply(
   encode_headers(std::move(response_headers), body_text.empty());
   // encode_headers()) may have changed the referenced is_reset so we need to test it
   if (!body_text.empty() && !is_reset) {
-    Buffer::OwnedImpl buffer(body_text);
+    Buffer::OwnedImpl buffer;
+    add_body(buffer);
     encode_data(buffer, true);
   }
 }
@@ -3,6 +3,7 @@
 #include <chrono>
 #include <cstdint>
 #include <string>
+#include <unordered_map>
 
 #include "envoy/api/v2/core/http_uri.pb.h"
 #include "envoy/api/v2/core/protocol.pb.h"
@@ -64,6 +65,14 @@ const char* findQueryStringStart(const HeaderString& path);
  **/
 std::string parseCookieValue(const HeaderMap& headers, const std::string& key);
 
+/**
+ * Parse all the cookies of a request at once.
+ * @param headers supplies the headers to get the cookies from.
+ * @return std::unordered_map<std::string, std::string> the cookies by name, each with the value
+ *         that parseCookieValue() would return for its name.
+ **/
+std::unordered_map<std::string, std::string> parseCookies(const HeaderMap& headers);
+
 /**
  * Check whether a Set-Cookie header for the given cookie name exists
  * @param headers supplies the headers to search for the cookie
@@ -159,6 +168,29 @@ void sendLocalReply(bool is_grpc,
                     const bool& is_reset, Code response_code, const std::string& body_text,
                     bool is_head_request = false);
 
+/**
+ * Create a locally generated response using the provided lambdas, whose body is added to the
+ * response buffer by add_body rather than copied from body_text. This lets a body which is sent
+ * in many responses be stored once and referenced by each of them.
+ * @param is_grpc tells if this is a response to a gRPC request.
+ * @param encode_headers supplies the function to encode response headers.
+ * @param encode_data supplies the function to encode the response body.
+ * @param is_reset boolean reference that indicates whether a stream has been reset. It is the
+ *                 responsibility of the caller to ensure that this is set to false if onDestroy()
+ *                 is invoked in the context of sendLocalReply().
+ * @param response_code supplies the HTTP response code.
+ * @param body_text supplies the optional body text which is sent using the text/plain content
+ *                  type. It is only read for the content length and for gRPC responses.
+ * @param add_body supplies the function which adds the body to the response buffer.
+ * @param is_head_request tells if this is a response to a HEAD request
+ */
+void sendLocalReply(bool is_grpc,
+                    std::function<void(HeaderMapPtr&& headers, bool end_stream)> encode_headers,
+                    std::function<void(Buffer::Instance& data, bool end_stream)> encode_data,
+                    const bool& is_reset, Code response_code, const std::string& body_text,
+                    const std::function<void(Buffer::Instance& buffer)>& add_body,
+                    bool is_head_request);
+
 struct GetLastAddressFromXffInfo {
   // Last valid address pulled from the XFF header.
   Network::Address::InstanceConstSharedPtr address_;
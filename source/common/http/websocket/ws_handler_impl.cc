@@ -38,6 +38,10 @@ TcpProxy::ConfigSharedPtr Config(const envoy::api::v2::route::RouteAction& route
     if (ws_config.has_max_connect_attempts()) {
       *tcp_config.mutable_max_connect_attempts() = ws_config.max_connect_attempts();
     }
+
+    if (ws_config.has_buffer_release_timeout()) {
+      *tcp_config.mutable_buffer_release_timeout() = ws_config.buffer_release_timeout();
+    }
   }
   return std::make_shared<TcpProxy::Config>(tcp_config, factory_context);
 }
@@ -142,6 +146,9 @@ void WsHandlerImpl::onConnectionSuccess() {
     TcpProxy::Filter::onData(queued_data_, queued_end_stream_);
     ASSERT(queued_data_.length() == 0);
   }
+
+  // Everything from here on is proxied as is, so the connection manager can drop its HTTP state.
+  ws_callbacks_.onWebSocketTunnelEstablished();
 }
 
 RequestInfo::RequestInfo& WsHandlerImpl::getRequestInfo() { return request_info_; }
@@ -0,0 +1,155 @@
+#include "common/memory/accounting.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <unordered_set>
+
+#include "common/common/lock_guard.h"
+#include "common/common/thread.h"
+#include "common/common/thread_annotations.h"
+
+namespace Envoy {
+namespace Memory {
+namespace {
+
+// Blocks of malloc() carry their size in a header which keeps them aligned like malloc's.
+const size_t HeaderSize = alignof(std::max_align_t);
+static_assert(HeaderSize >= sizeof(size_t), "the header must hold the size");
+
+typedef std::array<std::atomic<int64_t>, Accounting::NumTags> Counters;
+
+uint64_t tagIndex(Tag tag) { return static_cast<uint64_t>(tag); }
+
+struct ThreadCounters;
+
+struct Registry {
+  void add(ThreadCounters* counters) {
+    Thread::LockGuard lock(mutex_);
+    threads_.insert(counters);
+  }
+
+  void remove(ThreadCounters* counters);
+
+  int64_t sum(Tag tag);
+
+  // The counts of the threads which have exited.
+  Counters retired_{};
+
+  Thread::MutexBasicLockable mutex_;
+  std::unordered_set<ThreadCounters*> threads_ GUARDED_BY(mutex_);
+};
+
+// Never destroyed, so that memory can be freed by static destructors and exiting threads.
+Registry& registry() {
+  static Registry* registry = new Registry();
+  return *registry;
+}
+
+// Trivially destructible, so that it remains safe to read during thread exit.
+thread_local bool thread_counters_destroyed = false;
+
+struct ThreadCounters {
+  ThreadCounters() { registry().add(this); }
+
+  ~ThreadCounters() {
+    thread_counters_destroyed = true;
+    registry().remove(this);
+  }
+
+  // Only written by the owning thread, and atomic for the readers of the sums.
+  Counters bytes_{};
+};
+
+void Registry::remove(ThreadCounters* counters) {
+  Thread::LockGuard lock(mutex_);
+  threads_.erase(counters);
+  for (uint64_t i = 0; i < Accounting::NumTags; i++) {
+    retired_[i] += counters->bytes_[i].load(std::memory_order_relaxed);
+  }
+}
+
+int64_t Registry::sum(Tag tag) {
+  Thread::LockGuard lock(mutex_);
+  int64_t sum = retired_[tagIndex(tag)];
+  for (const ThreadCounters* counters : threads_) {
+    sum += counters->bytes_[tagIndex(tag)].load(std::memory_order_relaxed);
+  }
+  return sum;
+}
+
+void add(Tag tag, int64_t bytes) {
+  if (thread_counters_destroyed) {
+    registry().retired_[tagIndex(tag)] += bytes;
+    return;
+  }
+  static thread_local ThreadCounters thread_counters;
+  std::atomic<int64_t>& counter = thread_counters.bytes_[tagIndex(tag)];
+  counter.store(counter.load(std::memory_order_relaxed) + bytes, std::memory_order_relaxed);
+}
+
+size_t& blockSize(void* block) { return *static_cast<size_t*>(block); }
+
+} // namespace
+
+void Accounting::allocated(Tag tag, uint64_t bytes) { add(tag, bytes); }
+
+void Accounting::freed(Tag tag, uint64_t bytes) { add(tag, -static_cast<int64_t>(bytes)); }
+
+uint64_t Accounting::bytes(Tag tag) {
+  // Frees may be counted before the allocations they match on other threads.
+  const int64_t sum = registry().sum(tag);
+  return sum > 0 ? sum : 0;
+}
+
+const std::string& Accounting::name(Tag tag) {
+  static const std::array<std::string, NumTags>* names = new std::array<std::string, NumTags>(
+      {{"buffers", "http2_sessions", "hosts", "route_tables", "stats"}});
+  return (*names)[tagIndex(tag)];
+}
+
+void* Accounting::malloc(Tag tag, size_t size) {
+  if (size > SIZE_MAX - HeaderSize) {
+    return nullptr;
+  }
+  void* block = ::malloc(HeaderSize + size);
+  if (block == nullptr) {
+    return nullptr;
+  }
+  blockSize(block) = size;
+  allocated(tag, size);
+  return static_cast<char*>(block) + HeaderSize;
+}
+
+void* Accounting::realloc(Tag tag, void* memory, size_t size) {
+  if (memory == nullptr) {
+    return malloc(tag, size);
+  }
+  if (size > SIZE_MAX - HeaderSize) {
+    return nullptr;
+  }
+  void* old_block = static_cast<char*>(memory) - HeaderSize;
+  const size_t old_size = blockSize(old_block);
+  void* block = ::realloc(old_block, HeaderSize + size);
+  if (block == nullptr) {
+    return nullptr;
+  }
+  blockSize(block) = size;
+  freed(tag, old_size);
+  allocated(tag, size);
+  return static_cast<char*>(block) + HeaderSize;
+}
+
+void Accounting::free(Tag tag, void* memory) {
+  if (memory == nullptr) {
+    return;
+  }
+  void* block = static_cast<char*>(memory) - HeaderSize;
+  freed(tag, blockSize(block));
+  ::free(block);
+}
+
+} // namespace Memory
+} // namespace Envoy
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Envoy {
+namespace Memory {
+
+/**
+ * The subsystems whose heap memory is accounted.
+ */
+enum class Tag {
+  // Every allocation made by libevent, which are mostly the chains of buffers.
+  Buffers,
+  // Every allocation made by nghttp2 for HTTP/2 sessions and their streams.
+  Http2Sessions,
+  // Upstream host objects, not counting what they point to.
+  Hosts,
+  // Route entries and virtual hosts, not counting what they point to.
+  RouteTables,
+  // The slabs of heap allocated stats.
+  Stats,
+};
+
+/**
+ * Always-on accounting of the heap bytes held by subsystems, for telling which one is responsible
+ * when the process grows without taking a heap profile. Subsystems report their allocations and
+ * frees under their tag, either directly, through the malloc style functions below which C
+ * libraries can be pointed at, or through the Accounted mixin.
+ *
+ * Counts are kept per thread, so that an allocation costs an uncontended relaxed update of a
+ * thread local counter. Reading sums the counters of all threads and is meant for stats flushes
+ * and the admin endpoint rather than hot paths. Memory freed on another thread than the one that
+ * allocated it is accounted correctly, since only the sums are meaningful.
+ */
+class Accounting {
+public:
+  static const uint64_t NumTags = static_cast<uint64_t>(Tag::Stats) + 1;
+
+  /**
+   * Records an allocation.
+   * @param tag supplies the subsystem the memory belongs to.
+   * @param bytes supplies the size of the allocation.
+   */
+  static void allocated(Tag tag, uint64_t bytes);
+
+  /**
+   * Records a free of memory recorded by allocated().
+   * @param tag supplies the subsystem the memory belongs to.
+   * @param bytes supplies the size the memory was allocated with.
+   */
+  static void freed(Tag tag, uint64_t bytes);
+
+  /**
+   * @param tag supplies the subsystem.
+   * @return uint64_t the number of bytes the subsystem currently holds.
+   */
+  static uint64_t bytes(Tag tag);
+
+  /**
+   * @param tag supplies the subsystem.
+   * @return const std::string& the name of the subsystem, as used in stat names.
+   */
+  static const std::string& name(Tag tag);
+
+  /**
+   * Accounted replacements of malloc(), realloc() and free() for C libraries, which free memory
+   * without telling its size. Blocks carry their size in a header, and must only be passed to
+   * realloc() and free() of the same tag.
+   */
+  static void* malloc(Tag tag, size_t size);
+  static void* realloc(Tag tag, void* memory, size_t size);
+  static void free(Tag tag, void* memory);
+};
+
+/**
+ * Mixin which accounts the instances of a class under a tag. Only the size of the instances is
+ * accounted, not the memory they own.
+ *
+ * Usage:
+ *   class Foo : public Memory::Accounted<Memory::Tag::Hosts> { ... };
+ *
+ * Instances must be destroyed through a virtual destructor or as their most derived type, so that
+ * the size freed is the size allocated. Instances created by std::make_shared are not accounted.
+ */
+template <Tag tag> class Accounted {
+public:
+  static void* operator new(size_t size) {
+    void* memory = ::operator new(size);
+    Accounting::allocated(tag, size);
+    return memory;
+  }
+
+  static void operator delete(void* memory, size_t size) {
+    Accounting::freed(tag, size);
+    ::operator delete(memory);
+  }
+};
+
+} // namespace Memory
+} // namespace Envoy
@@ -0,0 +1,240 @@
+#include "common/memory/huge_page_arena.h"
+
+#include <sys/mman.h>
+
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "common/common/lock_guard.h"
+#include "common/common/thread.h"
+#include "common/common/thread_annotations.h"
+
+namespace Envoy {
+namespace Memory {
+namespace {
+
+// Blocks are rounded up to a power of two between MinBlockSize and MaxBlockSize. Larger blocks get
+// chunks of their own.
+const uint64_t MinBlockSize = 64;
+const uint64_t MaxBlockSize = HugePageArena::ChunkSize / 2;
+const uint64_t NumBlockSizes = 15;
+static_assert(MinBlockSize << (NumBlockSizes - 1) == MaxBlockSize, "one free list per size");
+
+uint64_t blockSizeIndex(size_t size) {
+  uint64_t index = 0;
+  while ((MinBlockSize << index) < size) {
+    index++;
+  }
+  return index;
+}
+
+uint64_t roundUpToChunks(uint64_t size) {
+  return (size + HugePageArena::ChunkSize - 1) & ~(HugePageArena::ChunkSize - 1);
+}
+
+struct FreeBlock {
+  FreeBlock* next_;
+};
+
+struct Arena {
+  // Maps size bytes aligned to ChunkSize, from the huge page pool if it has pages reserved.
+  // Throws std::bad_alloc on failure, like operator new.
+  char* map(uint64_t size, bool& huge_tlb) {
+#ifdef MAP_HUGETLB
+    // Huge page mappings are aligned to the huge page size, which may be larger than ChunkSize.
+    void* memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (memory != MAP_FAILED) {
+      huge_tlb = true;
+      return static_cast<char*>(memory);
+    }
+#endif
+    // Over-map by a chunk and trim the ends, so that the mapping is aligned for the kernel to back
+    // it with transparent huge pages.
+    huge_tlb = false;
+    void* memory_with_slack = ::mmap(nullptr, size + HugePageArena::ChunkSize,
+                                     PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory_with_slack == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+    const uintptr_t start = reinterpret_cast<uintptr_t>(memory_with_slack);
+    const uintptr_t aligned = roundUpToChunks(start);
+    if (aligned != start) {
+      ::munmap(memory_with_slack, aligned - start);
+    }
+    ::munmap(reinterpret_cast<void*>(aligned + size), start + HugePageArena::ChunkSize - aligned);
+#ifdef MADV_HUGEPAGE
+    ::madvise(reinterpret_cast<void*>(aligned), size, MADV_HUGEPAGE);
+#endif
+    return reinterpret_cast<char*>(aligned);
+  }
+
+  char* mapChunk() EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    bool huge_tlb;
+    char* chunk = map(HugePageArena::ChunkSize, huge_tlb);
+    chunks_.insert(reinterpret_cast<uintptr_t>(chunk));
+    bytes_mapped_ += HugePageArena::ChunkSize;
+    if (huge_tlb) {
+      bytes_mapped_huge_tlb_ += HugePageArena::ChunkSize;
+    }
+    return chunk;
+  }
+
+  void prefault(uint64_t size) {
+    Thread::LockGuard lock(mutex_);
+    for (uint64_t i = 0; i < roundUpToChunks(size) / HugePageArena::ChunkSize; i++) {
+      char* chunk = mapChunk();
+      memset(chunk, 0, HugePageArena::ChunkSize);
+      spare_chunks_.push_back(chunk);
+    }
+  }
+
+  void pushFreeBlock(char* memory, uint64_t index) EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    FreeBlock* block = reinterpret_cast<FreeBlock*>(memory);
+    block->next_ = free_blocks_[index];
+    free_blocks_[index] = block;
+  }
+
+  // Carves a block of the given size out of the current chunk, aligned to its size. The unaligned
+  // head of the free part of the chunk is split into smaller aligned blocks, which go to their
+  // free lists. The end of a chunk is aligned to ChunkSize, so a block always fits once aligned.
+  char* carveBlock(uint64_t size) EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    while (true) {
+      if (current_ == current_end_) {
+        if (!spare_chunks_.empty()) {
+          current_ = spare_chunks_.back();
+          spare_chunks_.pop_back();
+        } else {
+          current_ = mapChunk();
+        }
+        current_end_ = current_ + HugePageArena::ChunkSize;
+      }
+      const uintptr_t position = reinterpret_cast<uintptr_t>(current_);
+      if ((position & (size - 1)) == 0) {
+        char* block = current_;
+        current_ += size;
+        return block;
+      }
+      const uint64_t piece = position & -position;
+      pushFreeBlock(current_, blockSizeIndex(piece));
+      current_ += piece;
+    }
+  }
+
+  void* allocate(size_t size) {
+    Thread::LockGuard lock(mutex_);
+    if (size > MaxBlockSize) {
+      const uint64_t mapped_size = roundUpToChunks(size);
+      bool huge_tlb;
+      char* memory = map(mapped_size, huge_tlb);
+      large_blocks_.emplace(reinterpret_cast<uintptr_t>(memory), huge_tlb);
+      bytes_mapped_ += mapped_size;
+      if (huge_tlb) {
+        bytes_mapped_huge_tlb_ += mapped_size;
+      }
+      bytes_allocated_ += mapped_size;
+      return memory;
+    }
+
+    const uint64_t index = blockSizeIndex(size);
+    bytes_allocated_ += MinBlockSize << index;
+    FreeBlock* block = free_blocks_[index];
+    if (block != nullptr) {
+      free_blocks_[index] = block->next_;
+      return block;
+    }
+    return carveBlock(MinBlockSize << index);
+  }
+
+  void deallocate(void* memory, size_t size) {
+    const uintptr_t address = reinterpret_cast<uintptr_t>(memory);
+    Thread::LockGuard lock(mutex_);
+    if (size > MaxBlockSize) {
+      auto it = large_blocks_.find(address);
+      if (it == large_blocks_.end()) {
+        ::operator delete(memory);
+        return;
+      }
+      const uint64_t mapped_size = roundUpToChunks(size);
+      ::munmap(memory, mapped_size);
+      bytes_mapped_ -= mapped_size;
+      if (it->second) {
+        bytes_mapped_huge_tlb_ -= mapped_size;
+      }
+      bytes_allocated_ -= mapped_size;
+      large_blocks_.erase(it);
+      return;
+    }
+
+    if (chunks_.count(address & ~(HugePageArena::ChunkSize - 1)) == 0) {
+      ::operator delete(memory);
+      return;
+    }
+    const uint64_t index = blockSizeIndex(size);
+    bytes_allocated_ -= MinBlockSize << index;
+    pushFreeBlock(static_cast<char*>(memory), index);
+  }
+
+  std::atomic<bool> enabled_{};
+  std::atomic<uint64_t> bytes_mapped_{};
+  std::atomic<uint64_t> bytes_mapped_huge_tlb_{};
+  std::atomic<uint64_t> bytes_allocated_{};
+
+  Thread::MutexBasicLockable mutex_;
+  // The start of every shared chunk, to tell blocks of the arena from blocks of the heap.
+  std::unordered_set<uintptr_t> chunks_ GUARDED_BY(mutex_);
+  // The start of every large block, and whether it comes from the huge page pool.
+  std::unordered_map<uintptr_t, bool> large_blocks_ GUARDED_BY(mutex_);
+  // Prefaulted chunks which blocks have not been carved out of yet.
+  std::vector<char*> spare_chunks_ GUARDED_BY(mutex_);
+  // The part of the current chunk which blocks have not been carved out of yet.
+  char* current_ GUARDED_BY(mutex_){};
+  char* current_end_ GUARDED_BY(mutex_){};
+  std::array<FreeBlock*, NumBlockSizes> free_blocks_ GUARDED_BY(mutex_){};
+};
+
+// Never destroyed, so that blocks can be freed by static destructors.
+Arena& arena() {
+  static Arena* arena = new Arena();
+  return *arena;
+}
+
+} // namespace
+
+void HugePageArena::enable(uint64_t prefault_bytes) {
+  arena().prefault(prefault_bytes);
+  arena().enabled_ = true;
+}
+
+bool HugePageArena::enabled() { return arena().enabled_; }
+
+void* HugePageArena::allocate(size_t size) {
+  if (!enabled()) {
+    return ::operator new(size);
+  }
+  return arena().allocate(size);
+}
+
+void HugePageArena::deallocate(void* memory, size_t size) {
+  if (memory == nullptr) {
+    return;
+  }
+  if (!enabled()) {
+    ::operator delete(memory);
+    return;
+  }
+  arena().deallocate(memory, size);
+}
+
+uint64_t HugePageArena::bytesMapped() { return arena().bytes_mapped_; }
+
+uint64_t HugePageArena::bytesMappedHugeTlb() { return arena().bytes_mapped_huge_tlb_; }
+
+uint64_t HugePageArena::bytesAllocated() { return arena().bytes_allocated_; }
+
+} // namespace Memory
+} // namespace Envoy
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Envoy {
+namespace Memory {
+
+/**
+ * Process wide arena for large and long-lived structures, such as load balancer tables and stat
+ * slabs, whose accesses are spread over more 4 KiB pages than the TLB covers. Memory is mapped in
+ * chunks of ChunkSize bytes, aligned to ChunkSize, from the kernel's huge page pool when it has
+ * pages reserved and otherwise as regular memory which the kernel is asked to back with
+ * transparent huge pages.
+ *
+ * Blocks up to half a chunk are rounded up to a power of two and carved out of shared chunks.
+ * Their memory is reused for blocks of the same size once freed, but is never returned to the
+ * kernel. Larger blocks get chunks of their own, which are unmapped when the block is freed.
+ *
+ * The arena is disabled until enable() is called, and allocate() and deallocate() then use the
+ * heap. Blocks allocated from the heap before the arena was enabled may still be passed to
+ * deallocate(), which returns them to the heap.
+ */
+class HugePageArena {
+public:
+  // The size of a huge page on x86-64 and of a transparent huge page on most architectures.
+  static const uint64_t ChunkSize = 2 * 1024 * 1024;
+
+  /**
+   * Enables the arena. Subsequent allocations come from huge page chunks. The arena cannot be
+   * disabled again.
+   * @param prefault_bytes supplies the number of bytes of chunks to map and fault in at once,
+   *        rounded up to whole chunks, so that the page faults are taken at startup rather than
+   *        under the first traffic. The arena maps further chunks on demand.
+   */
+  static void enable(uint64_t prefault_bytes);
+
+  /**
+   * @return bool whether the arena is enabled.
+   */
+  static bool enabled();
+
+  /**
+   * @param size supplies the size of the block.
+   * @return void* a block of at least size bytes. When the arena is enabled, blocks are aligned to
+   *         their rounded size, up to ChunkSize.
+   */
+  static void* allocate(size_t size);
+
+  /**
+   * Frees a block returned by allocate().
+   * @param memory supplies the block.
+   * @param size supplies the size the block was allocated with.
+   */
+  static void deallocate(void* memory, size_t size);
+
+  /**
+   * @return uint64_t the number of bytes of chunks mapped by the arena.
+   */
+  static uint64_t bytesMapped();
+
+  /**
+   * @return uint64_t the number of bytes of the chunks mapped from the kernel's huge page pool.
+   *         The rest of the chunks are backed by transparent huge pages at the kernel's discretion.
+   */
+  static uint64_t bytesMappedHugeTlb();
+
+  /**
+   * @return uint64_t the number of bytes of blocks currently allocated from the arena, after
+   *         rounding their sizes.
+   */
+  static uint64_t bytesAllocated();
+};
+
+/**
+ * STL allocator which allocates from the HugePageArena.
+ */
+template <class T> class HugePageAllocator {
+public:
+  typedef T value_type;
+
+  HugePageAllocator() = default;
+  template <class U> HugePageAllocator(const HugePageAllocator<U>&) {}
+
+  T* allocate(size_t n) { return static_cast<T*>(HugePageArena::allocate(n * sizeof(T))); }
+  void deallocate(T* memory, size_t n) { HugePageArena::deallocate(memory, n * sizeof(T)); }
+};
+
+template <class T, class U>
+bool operator==(const HugePageAllocator<T>&, const HugePageAllocator<U>&) {
+  return true;
+}
+
+template <class T, class U>
+bool operator!=(const HugePageAllocator<T>&, const HugePageAllocator<U>&) {
+  return false;
+}
+
+template <class T> using HugePageVector = std::vector<T, HugePageAllocator<T>>;
+
+} // namespace Memory
+} // namespace Envoy
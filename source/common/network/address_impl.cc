@@ -24,21 +24,21 @@ namespace {
 
 // Validate that IPv4 is supported on this platform, raise an exception for the
 // given address if not.
-void validateIpv4Supported(const std::string& address) {
+void validateIpv4Supported(const Network::Address::Instance& address) {
   static const bool supported = Network::Address::ipFamilySupported(AF_INET);
   if (!supported) {
     throw EnvoyException(
-        fmt::format("IPv4 addresses are not supported on this machine: {}", address));
+        fmt::format("IPv4 addresses are not supported on this machine: {}", address.asString()));
   }
 }
 
 // Validate that IPv6 is supported on this platform, raise an exception for the
 // given address if not.
-void validateIpv6Supported(const std::string& address) {
+void validateIpv6Supported(const Network::Address::Instance& address) {
   static const bool supported = Network::Address::ipFamilySupported(AF_INET6);
   if (!supported) {
     throw EnvoyException(
-        fmt::format("IPv6 addresses are not supported on this machine: {}", address));
+        fmt::format("IPv6 addresses are not supported on this machine: {}", address.asString()));
   }
 }
 
@@ -175,11 +175,7 @@ int InstanceBase::socketFromSocketType(SocketType socketType) const {
 
 Ipv4Instance::Ipv4Instance(const sockaddr_in* address) : InstanceBase(Type::Ip) {
   ip_.ipv4_.address_ = *address;
-  char str[INET_ADDRSTRLEN];
-  inet_ntop(AF_INET, &address->sin_addr, str, INET_ADDRSTRLEN);
-  friendly_name_ = fmt::format("{}:{}", str, ntohs(address->sin_port));
-  ip_.friendly_address_ = str;
-  validateIpv4Supported(friendly_name_);
+  validateIpv4Supported(*this);
 }
 
 Ipv4Instance::Ipv4Instance(const std::string& address) : Ipv4Instance(address, 0) {}
@@ -193,9 +189,7 @@ Ipv4Instance::Ipv4Instance(const std::string& address, uint32_t port) : Instance
     throw EnvoyException(fmt::format("invalid ipv4 address '{}'", address));
   }
 
-  friendly_name_ = fmt::format("{}:{}", address, port);
-  validateIpv4Supported(friendly_name_);
-  ip_.friendly_address_ = address;
+  validateIpv4Supported(*this);
 }
 
 Ipv4Instance::Ipv4Instance(uint32_t port) : InstanceBase(Type::Ip) {
@@ -203,9 +197,16 @@ Ipv4Instance::Ipv4Instance(uint32_t port) : InstanceBase(Type::Ip) {
   ip_.ipv4_.address_.sin_family = AF_INET;
   ip_.ipv4_.address_.sin_port = htons(port);
   ip_.ipv4_.address_.sin_addr.s_addr = INADDR_ANY;
-  friendly_name_ = fmt::format("0.0.0.0:{}", port);
-  validateIpv4Supported(friendly_name_);
-  ip_.friendly_address_ = "0.0.0.0";
+  validateIpv4Supported(*this);
+}
+
+void Ipv4Instance::IpHelper::formatFriendlyNames() const {
+  absl::call_once(friendly_names_once_, [this]() {
+    char str[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &ipv4_.address_.sin_addr, str, INET_ADDRSTRLEN);
+    friendly_address_ = str;
+    friendly_name_ = fmt::format("{}:{}", str, port());
+  });
 }
 
 bool Ipv4Instance::operator==(const Instance& rhs) const {
@@ -247,10 +248,8 @@ std::string Ipv6Instance::Ipv6Helper::makeFriendlyAddress() const {
 
 Ipv6Instance::Ipv6Instance(const sockaddr_in6& address, bool v6only) : InstanceBase(Type::Ip) {
   ip_.ipv6_.address_ = address;
-  ip_.friendly_address_ = ip_.ipv6_.makeFriendlyAddress();
   ip_.v6only_ = v6only;
-  friendly_name_ = fmt::format("[{}]:{}", ip_.friendly_address_, ip_.port());
-  validateIpv6Supported(friendly_name_);
+  validateIpv6Supported(*this);
 }
 
 Ipv6Instance::Ipv6Instance(const std::string& address) : Ipv6Instance(address, 0) {}
@@ -265,14 +264,20 @@ Ipv6Instance::Ipv6Instance(const std::string& address, uint32_t port) : Instance
   } else {
     ip_.ipv6_.address_.sin6_addr = in6addr_any;
   }
-  // Just in case address is in a non-canonical format, format from network address.
-  ip_.friendly_address_ = ip_.ipv6_.makeFriendlyAddress();
-  friendly_name_ = fmt::format("[{}]:{}", ip_.friendly_address_, ip_.port());
-  validateIpv6Supported(friendly_name_);
+  validateIpv6Supported(*this);
 }
 
 Ipv6Instance::Ipv6Instance(uint32_t port) : Ipv6Instance("", port) {}
 
+void Ipv6Instance::IpHelper::formatFriendlyNames() const {
+  // The names are formatted from the network address, in case the address was given in a
+  // non-canonical format.
+  absl::call_once(friendly_names_once_, [this]() {
+    friendly_address_ = ipv6_.makeFriendlyAddress();
+    friendly_name_ = fmt::format("[{}]:{}", friendly_address_, port());
+  });
+}
+
 bool Ipv6Instance::operator==(const Instance& rhs) const {
   const Ipv6Instance* rhs_casted = dynamic_cast<const Ipv6Instance*>(&rhs);
   return (rhs_casted && (ip_.ipv6_.address() == rhs_casted->ip_.ipv6_.address()) &&
@@ -362,6 +367,13 @@ Api::SysCallIntResult PipeInstance::connect(int fd) const {
   return {rc, errno};
 }
 
+socklen_t PipeInstance::sockAddrLen() const {
+  if (abstract_namespace_) {
+    return offsetof(struct sockaddr_un, sun_path) + address_length_;
+  }
+  return sizeof(address_);
+}
+
 int PipeInstance::socket(SocketType type) const { return socketFromSocketType(type); }
 
 } // namespace Address
@@ -11,6 +11,8 @@
 
 #include "envoy/network/address.h"
 
+#include "absl/base/call_once.h"
+
 namespace Envoy {
 namespace Network {
 namespace Address {
@@ -54,7 +56,6 @@ InstanceConstSharedPtr peerAddressFromFd(int fd);
 class InstanceBase : public Instance {
 public:
   // Network::Address::Instance
-  const std::string& asString() const override { return friendly_name_; }
   // Default logical name is the human-readable name.
   const std::string& logicalName() const override { return asString(); }
   Type type() const override { return type_; }
@@ -63,8 +64,6 @@ protected:
   InstanceBase(Type type) : type_(type) {}
   int socketFromSocketType(SocketType type) const;
 
-  std::string friendly_name_;
-
 private:
   const Type type_;
 };
@@ -96,10 +95,15 @@ public:
   explicit Ipv4Instance(uint32_t port);
 
   // Network::Address::Instance
+  const std::string& asString() const override { return ip_.friendlyName(); }
   bool operator==(const Instance& rhs) const override;
   Api::SysCallIntResult bind(int fd) const override;
   Api::SysCallIntResult connect(int fd) const override;
   const Ip* ip() const override { return &ip_; }
+  const sockaddr* sockAddr() const override {
+    return reinterpret_cast<const sockaddr*>(&ip_.ipv4_.address_);
+  }
+  socklen_t sockAddrLen() const override { return sizeof(sockaddr_in); }
   int socket(SocketType type) const override;
 
 private:
@@ -110,7 +114,10 @@ private:
   };
 
   struct IpHelper : public Ip {
-    const std::string& addressAsString() const override { return friendly_address_; }
+    const std::string& addressAsString() const override {
+      formatFriendlyNames();
+      return friendly_address_;
+    }
     bool isAnyAddress() const override { return ipv4_.address_.sin_addr.s_addr == INADDR_ANY; }
     bool isUnicastAddress() const override {
       return !isAnyAddress() && (ipv4_.address_.sin_addr.s_addr != INADDR_BROADCAST) &&
@@ -122,8 +129,17 @@ private:
     uint32_t port() const override { return ntohs(ipv4_.address_.sin_port); }
     IpVersion version() const override { return IpVersion::v4; }
 
+    const std::string& friendlyName() const {
+      formatFriendlyNames();
+      return friendly_name_;
+    }
+    void formatFriendlyNames() const;
+
     Ipv4Helper ipv4_;
-    std::string friendly_address_;
+    // The names are formatted on first use, since those of most accepted connections never are.
+    mutable absl::once_flag friendly_names_once_;
+    mutable std::string friendly_address_;
+    mutable std::string friendly_name_;
   };
 
   IpHelper ip_;
@@ -156,10 +172,15 @@ public:
   explicit Ipv6Instance(uint32_t port);
 
   // Network::Address::Instance
+  const std::string& asString() const override { return ip_.friendlyName(); }
   bool operator==(const Instance& rhs) const override;
   Api::SysCallIntResult bind(int fd) const override;
   Api::SysCallIntResult connect(int fd) const override;
   const Ip* ip() const override { return &ip_; }
+  const sockaddr* sockAddr() const override {
+    return reinterpret_cast<const sockaddr*>(&ip_.ipv6_.address_);
+  }
+  socklen_t sockAddrLen() const override { return sizeof(sockaddr_in6); }
   int socket(SocketType type) const override;
 
 private:
@@ -174,7 +195,10 @@ private:
   };
 
   struct IpHelper : public Ip {
-    const std::string& addressAsString() const override { return friendly_address_; }
+    const std::string& addressAsString() const override {
+      formatFriendlyNames();
+      return friendly_address_;
+    }
     bool isAnyAddress() const override {
       return 0 == memcmp(&ipv6_.address_.sin6_addr, &in6addr_any, sizeof(struct in6_addr));
     }
@@ -186,8 +210,17 @@ private:
     uint32_t port() const override { return ipv6_.port(); }
     IpVersion version() const override { return IpVersion::v6; }
 
+    const std::string& friendlyName() const {
+      formatFriendlyNames();
+      return friendly_name_;
+    }
+    void formatFriendlyNames() const;
+
     Ipv6Helper ipv6_;
-    std::string friendly_address_;
+    // The names are formatted on first use, since those of most accepted connections never are.
+    mutable absl::once_flag friendly_names_once_;
+    mutable std::string friendly_address_;
+    mutable std::string friendly_name_;
     // Is IPv4 compatibility (https://tools.ietf.org/html/rfc3493#page-11) disabled?
     // Default initialized to true to preserve extant Envoy behavior where we don't explicitly set
     // this in the constructor.
@@ -213,13 +246,17 @@ public:
   explicit PipeInstance(const std::string& pipe_path);
 
   // Network::Address::Instance
+  const std::string& asString() const override { return friendly_name_; }
   bool operator==(const Instance& rhs) const override;
   Api::SysCallIntResult bind(int fd) const override;
   Api::SysCallIntResult connect(int fd) const override;
   const Ip* ip() const override { return nullptr; }
+  const sockaddr* sockAddr() const override { return reinterpret_cast<const sockaddr*>(&address_); }
+  socklen_t sockAddrLen() const override;
   int socket(SocketType type) const override;
 
 private:
+  std::string friendly_name_;
   sockaddr_un address_;
   // For abstract namespaces.
   bool abstract_namespace_{false};
@@ -0,0 +1,52 @@
+#include "common/network/connection_balancer_impl.h"
+
+#include <algorithm>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Network {
+
+void ExactConnectionBalancerImpl::registerHandler(BalancedConnectionHandler& handler) {
+  absl::MutexLock lock(&lock_);
+  handlers_.push_back(&handler);
+}
+
+void ExactConnectionBalancerImpl::unregisterHandler(BalancedConnectionHandler& handler) {
+  absl::MutexLock lock(&lock_);
+  // This could be made O(1) by tracking the index of each handler, but there are only as many
+  // handlers as workers and this is only done when a listener is added to or removed from a worker.
+  const auto it = std::find(handlers_.begin(), handlers_.end(), &handler);
+  ASSERT(it != handlers_.end());
+  handlers_.erase(it);
+}
+
+BalancedConnectionHandler&
+ExactConnectionBalancerImpl::pickTargetHandler(BalancedConnectionHandler& current_handler) {
+  BalancedConnectionHandler* min_connection_handler = nullptr;
+  {
+    absl::MutexLock lock(&lock_);
+    for (BalancedConnectionHandler* handler : handlers_) {
+      if (min_connection_handler == nullptr ||
+          handler->numConnections() < min_connection_handler->numConnections()) {
+        min_connection_handler = handler;
+      }
+    }
+
+    // The current handler wins ties so that a connection is only posted to another worker if
+    // that actually evens out the load.
+    if (min_connection_handler == nullptr ||
+        current_handler.numConnections() <= min_connection_handler->numConnections()) {
+      return current_handler;
+    }
+
+    // Account for the connection while still holding the lock, so that concurrent picks on other
+    // workers see it before it has been delivered.
+    min_connection_handler->incNumConnections();
+  }
+
+  return *min_connection_handler;
+}
+
+} // namespace Network
+} // namespace Envoy
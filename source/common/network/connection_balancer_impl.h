@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+
+#include "envoy/network/connection_balancer.h"
+
+#include "absl/synchronization/mutex.h"
+
+namespace Envoy {
+namespace Network {
+
+/**
+ * Balancer that keeps every connection on the worker that accepted it.
+ */
+class NopConnectionBalancerImpl : public ConnectionBalancer {
+public:
+  // Network::ConnectionBalancer
+  void registerHandler(BalancedConnectionHandler&) override {}
+  void unregisterHandler(BalancedConnectionHandler&) override {}
+  BalancedConnectionHandler& pickTargetHandler(BalancedConnectionHandler& current_handler) override {
+    return current_handler;
+  }
+};
+
+/**
+ * Balancer that hands every accepted connection to the handler with the fewest connections. The
+ * pick is done under a lock that is shared by all workers of the listener, so this is only worth
+ * it for listeners whose connections are long lived relative to the accept rate.
+ */
+class ExactConnectionBalancerImpl : public ConnectionBalancer {
+public:
+  // Network::ConnectionBalancer
+  void registerHandler(BalancedConnectionHandler& handler) override;
+  void unregisterHandler(BalancedConnectionHandler& handler) override;
+  BalancedConnectionHandler& pickTargetHandler(BalancedConnectionHandler& current_handler) override;
+
+private:
+  absl::Mutex lock_;
+  std::vector<BalancedConnectionHandler*> handlers_ GUARDED_BY(lock_);
+};
+
+} // namespace Network
+} // namespace Envoy
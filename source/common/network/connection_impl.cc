@@ -291,6 +291,18 @@ void ConnectionImpl::raiseEvent(ConnectionEvent event) {
 
 bool ConnectionImpl::readEnabled() const { return read_enabled_; }
 
+bool ConnectionImpl::idle() {
+  return state() == State::Open && !connecting_ && read_buffer_.length() == 0 &&
+         write_buffer_->length() == 0 && filter_manager_.idleForTransfer();
+}
+
+bool ConnectionImpl::idleForTransfer() { return passthroughFd() != -1 && idle(); }
+
+void ConnectionImpl::releaseBuffers() {
+  read_buffer_.releaseEmptySlices();
+  write_buffer_->releaseEmptySlices();
+}
+
 void ConnectionImpl::addConnectionCallbacks(ConnectionCallbacks& cb) { callbacks_.push_back(&cb); }
 
 void ConnectionImpl::addBytesSentCallback(BytesSentCb cb) {
@@ -336,11 +348,45 @@ void ConnectionImpl::write(Buffer::Instance& data, bool end_stream) {
     // doWriteReady into thinking the socket is connected. On OS X, the underlying write may fail
     // with a connection error if a call to write(2) occurs before the connection is completed.
     if (!connecting_) {
-      file_event_->activate(Event::FileReadyType::Write);
+      if (write_coalescing_timer_ != nullptr && !end_stream &&
+          write_buffer_->length() < write_coalescing_max_bytes_) {
+        if (!write_coalescing_pending_) {
+          write_coalescing_pending_ = true;
+          write_coalescing_timer_->enableTimer(write_coalescing_max_delay_);
+        }
+      } else {
+        file_event_->activate(Event::FileReadyType::Write);
+      }
+    }
+  }
+}
+
+void ConnectionImpl::setWriteCoalescing(uint64_t max_bytes, std::chrono::milliseconds max_delay) {
+  write_coalescing_max_bytes_ = max_bytes;
+  write_coalescing_max_delay_ = max_delay;
+  if (max_bytes == 0) {
+    if (write_coalescing_pending_) {
+      onWriteCoalescingTimeout();
     }
+    write_coalescing_timer_.reset();
+  } else if (write_coalescing_timer_ == nullptr) {
+    write_coalescing_timer_ =
+        dispatcher_.createTimer([this]() -> void { onWriteCoalescingTimeout(); });
+  }
+}
+
+void ConnectionImpl::onWriteCoalescingTimeout() {
+  write_coalescing_pending_ = false;
+  if (state() == State::Open) {
+    file_event_->activate(Event::FileReadyType::Write);
   }
 }
 
+void ConnectionImpl::setReadBudget(uint32_t bytes, Stats::Counter& yields) {
+  read_budget_ = bytes;
+  read_yields_ = &yields;
+}
+
 void ConnectionImpl::setBufferLimits(uint32_t limit) {
   read_buffer_limit_ = limit;
 
@@ -428,9 +474,13 @@ void ConnectionImpl::onReadReady() {
 
   ASSERT(!connecting_);
 
+  read_start_length_ = read_buffer_.length();
   IoResult result = transport_socket_->doRead(read_buffer_);
   uint64_t new_buffer_size = read_buffer_.length();
   updateReadBufferStats(result.bytes_processed_, new_buffer_size);
+  if (readBudgetExhausted()) {
+    read_yields_->inc();
+  }
 
   // If this connection doesn't have half-close semantics, translate end_stream into
   // a connection close.
@@ -478,6 +528,12 @@ void ConnectionImpl::onWriteReady() {
     }
   }
 
+  if (write_coalescing_pending_) {
+    // Everything pending is about to be written anyway.
+    write_coalescing_pending_ = false;
+    write_coalescing_timer_->disableTimer();
+  }
+
   IoResult result = transport_socket_->doWrite(*write_buffer_, write_end_stream_);
   ASSERT(!result.end_stream_read_); // The interface guarantees that only read operations set this.
   uint64_t new_buffer_size = write_buffer_->length();
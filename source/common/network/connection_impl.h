@@ -13,6 +13,7 @@
 #include "common/buffer/watermark_buffer.h"
 #include "common/common/logger.h"
 #include "common/event/libevent.h"
+#include "common/memory/recycler.h"
 #include "common/network/filter_manager_impl.h"
 #include "common/ssl/ssl_socket.h"
 
@@ -46,6 +47,7 @@ public:
 class ConnectionImpl : public virtual Connection,
                        public BufferSource,
                        public TransportSocketCallbacks,
+                       public Memory::Recyclable<ConnectionImpl>,
                        protected Logger::Loggable<Logger::Id::connection> {
 public:
   ConnectionImpl(Event::Dispatcher& dispatcher, ConnectionSocketPtr&& socket,
@@ -79,16 +81,28 @@ public:
   }
   void setConnectionStats(const ConnectionStats& stats) override;
   const Ssl::Connection* ssl() const override { return transport_socket_->ssl(); }
+  int passthroughFd() const override { return transport_socket_->passthrough() ? fd() : -1; }
+  uint64_t bufferedBytes() const override {
+    return read_buffer_.length() + write_buffer_->length();
+  }
+  bool idle() override;
+  bool idleForTransfer() override;
+  void releaseBuffers() override;
   State state() const override;
   void write(Buffer::Instance& data, bool end_stream) override;
   void setBufferLimits(uint32_t limit) override;
   uint32_t bufferLimit() const override { return read_buffer_limit_; }
+  void setWriteCoalescing(uint64_t max_bytes, std::chrono::milliseconds max_delay) override;
+  void setReadBudget(uint32_t bytes, Stats::Counter& yields) override;
   bool localAddressRestored() const override { return socket_->localAddressRestored(); }
   bool aboveHighWatermark() const override { return above_high_watermark_; }
   const ConnectionSocket::OptionsSharedPtr& socketOptions() const override {
     return socket_->options();
   }
   absl::string_view requestedServerName() const override { return socket_->requestedServerName(); }
+  const envoy::api::v2::core::Metadata& dynamicMetadata() const override {
+    return socket_->dynamicMetadata();
+  }
 
   // Network::BufferSource
   BufferSource::StreamBuffer getReadBuffer() override { return {read_buffer_, read_end_stream_}; }
@@ -102,13 +116,12 @@ public:
   void raiseEvent(ConnectionEvent event) override;
   // Should the read buffer be drained?
   bool shouldDrainReadBuffer() override {
-    return read_buffer_limit_ > 0 && read_buffer_.length() >= read_buffer_limit_;
+    return (read_buffer_limit_ > 0 && read_buffer_.length() >= read_buffer_limit_) ||
+           readBudgetExhausted();
   }
   // Mark read buffer ready to read in the event loop. This is used when yielding following
-  // shouldDrainReadBuffer().
-  // TODO(htuch): While this is the basis for also yielding to other connections to provide some
-  // fair sharing of CPU resources, the underlying event loop does not make any fairness guarantees.
-  // Reconsider how to make fairness happen.
+  // shouldDrainReadBuffer(). The activated event runs after the events already pending, which
+  // is what lets other connections on the dispatcher make progress past a read budget.
   void setReadBufferReady() override { file_event_->activate(Event::FileReadyType::Read); }
 
   // Obtain global next connection ID. This should only be used in tests.
@@ -140,6 +153,10 @@ private:
   void onRead(uint64_t read_buffer_size);
   void onReadReady();
   void onWriteReady();
+  void onWriteCoalescingTimeout();
+  bool readBudgetExhausted() const {
+    return read_budget_ > 0 && read_buffer_.length() - read_start_length_ >= read_budget_;
+  }
   void updateReadBufferStats(uint64_t num_read, uint64_t new_size);
   void updateWriteBufferStats(uint64_t num_written, uint64_t new_size);
 
@@ -165,6 +182,15 @@ private:
   uint64_t last_read_buffer_size_{};
   uint64_t last_write_buffer_size_{};
   std::unique_ptr<ConnectionStats> connection_stats_;
+  // Only created while write coalescing is enabled.
+  Event::TimerPtr write_coalescing_timer_;
+  uint64_t write_coalescing_max_bytes_{};
+  std::chrono::milliseconds write_coalescing_max_delay_{};
+  bool write_coalescing_pending_{};
+  uint32_t read_budget_{};
+  Stats::Counter* read_yields_{};
+  // The read buffer length when the current read started, to tell what it has read so far.
+  uint64_t read_start_length_{};
   // Tracks the number of times reads have been disabled. If N different components call
   // readDisabled(true) this allows the connection to only resume reads when readDisabled(false)
   // has been called N times.
@@ -0,0 +1,145 @@
+#include "common/network/dns_cache_impl.h"
+
+#include <algorithm>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <string>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Network {
+
+DnsCacheImpl::DnsCacheImpl(DnsResolverSharedPtr resolver, Event::Dispatcher& dispatcher,
+                           Stats::Scope& scope, std::chrono::seconds min_ttl,
+                           std::chrono::seconds max_ttl)
+    : resolver_(resolver), dispatcher_(dispatcher),
+      stats_{ALL_DNS_CACHE_STATS(POOL_COUNTER_PREFIX(scope, "dns_cache."),
+                                 POOL_GAUGE_PREFIX(scope, "dns_cache."))},
+      min_ttl_(min_ttl), max_ttl_(std::max(min_ttl, max_ttl)) {}
+
+DnsCacheImpl::~DnsCacheImpl() {
+  for (const auto& entry : entries_) {
+    if (entry.second->active_query_ != nullptr) {
+      entry.second->active_query_->cancel();
+    }
+  }
+}
+
+ActiveDnsQuery* DnsCacheImpl::resolve(const std::string& dns_name,
+                                      DnsLookupFamily dns_lookup_family, ResolveCb callback) {
+  return resolveWithTtl(dns_name, dns_lookup_family,
+                        [callback](std::list<Address::InstanceConstSharedPtr>&& address_list,
+                                   std::chrono::seconds) { callback(std::move(address_list)); });
+}
+
+ActiveDnsQuery* DnsCacheImpl::resolveWithTtl(const std::string& dns_name,
+                                             DnsLookupFamily dns_lookup_family,
+                                             ResolveWithTtlCb callback) {
+  const Key key{dns_name, dns_lookup_family};
+  auto it = entries_.find(key);
+  if (it != entries_.end() && it->second->resolved_) {
+    Entry& entry = *it->second;
+    stats_.cache_hit_.inc();
+    entry.used_ = true;
+    const auto remaining = std::chrono::duration_cast<std::chrono::seconds>(
+        entry.expiry_time_ - dispatcher_.timeSystem().monotonicTime());
+    std::list<Address::InstanceConstSharedPtr> address_list = entry.address_list_;
+    callback(std::move(address_list), std::max(remaining, std::chrono::seconds(0)));
+    return nullptr;
+  }
+
+  if (it == entries_.end()) {
+    stats_.cache_miss_.inc();
+    it = entries_.emplace(key, EntryPtr{new Entry(*this, key)}).first;
+  } else {
+    ASSERT(it->second->resolving_);
+    stats_.query_coalesced_.inc();
+  }
+
+  Entry& entry = *it->second;
+  entry.pending_resolutions_.emplace_back(new PendingResolution(callback));
+  PendingResolution* pending_resolution = entry.pending_resolutions_.back().get();
+  if (!entry.resolving_) {
+    entry.startResolve();
+  }
+
+  // The resolver may have completed synchronously, e.g. for names in the hosts file.
+  return entry.resolving_ ? pending_resolution : nullptr;
+}
+
+void DnsCacheImpl::removeEntry(Entry& entry) {
+  auto it = entries_.find(entry.key_);
+  ASSERT(it != entries_.end() && it->second.get() == &entry);
+  // The entry may be removed from within its own callbacks.
+  dispatcher_.deferredDelete(std::move(it->second));
+  entries_.erase(it);
+  stats_.entries_.dec();
+}
+
+DnsCacheImpl::Entry::Entry(DnsCacheImpl& parent, const Key& key)
+    : parent_(parent), key_(key),
+      expiry_timer_(parent.dispatcher_.createTimer([this]() -> void { onExpiry(); })) {
+  parent_.stats_.entries_.inc();
+}
+
+void DnsCacheImpl::Entry::startResolve() {
+  ENVOY_LOG(debug, "starting cached DNS resolution for {}", key_.first);
+  resolving_ = true;
+  ActiveDnsQuery* active_query = parent_.resolver_->resolveWithTtl(
+      key_.first, key_.second,
+      [this](std::list<Address::InstanceConstSharedPtr>&& address_list,
+             std::chrono::seconds ttl) -> void {
+        active_query_ = nullptr;
+        resolving_ = false;
+        onResolveComplete(std::move(address_list), ttl);
+      });
+  if (resolving_) {
+    active_query_ = active_query;
+  }
+}
+
+void DnsCacheImpl::Entry::onResolveComplete(
+    std::list<Address::InstanceConstSharedPtr>&& address_list, std::chrono::seconds ttl) {
+  ENVOY_LOG(debug, "cached DNS resolution complete for {}", key_.first);
+  std::list<PendingResolutionPtr> pending_resolutions = std::move(pending_resolutions_);
+  pending_resolutions_.clear();
+
+  if (address_list.empty()) {
+    // Failed resolutions are not cached, the next resolution of the name queries again.
+    resolved_ = false;
+    address_list_.clear();
+    expiry_timer_->disableTimer();
+    parent_.removeEntry(*this);
+  } else {
+    ttl = std::min(std::max(ttl, parent_.min_ttl_), parent_.max_ttl_);
+    resolved_ = true;
+    used_ = false;
+    address_list_ = address_list;
+    expiry_time_ = parent_.dispatcher_.timeSystem().monotonicTime() + ttl;
+    expiry_timer_->enableTimer(std::chrono::duration_cast<std::chrono::milliseconds>(ttl));
+  }
+
+  for (const PendingResolutionPtr& pending_resolution : pending_resolutions) {
+    if (!pending_resolution->cancelled_) {
+      std::list<Address::InstanceConstSharedPtr> pending_address_list = address_list;
+      pending_resolution->callback_(std::move(pending_address_list), ttl);
+    }
+  }
+}
+
+void DnsCacheImpl::Entry::onExpiry() {
+  ASSERT(resolved_ && !resolving_);
+  if (used_) {
+    parent_.stats_.refresh_.inc();
+    startResolve();
+  } else {
+    ENVOY_LOG(debug, "evicting cached DNS resolution for {}", key_.first);
+    parent_.stats_.eviction_.inc();
+    parent_.removeEntry(*this);
+  }
+}
+
+} // namespace Network
+} // namespace Envoy
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <chrono>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "envoy/common/time.h"
+#include "envoy/event/deferred_deletable.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/event/timer.h"
+#include "envoy/network/dns.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "common/common/logger.h"
+
+namespace Envoy {
+namespace Network {
+
+/**
+ * All DNS cache stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_DNS_CACHE_STATS(COUNTER, GAUGE)                                                        \
+  COUNTER(cache_hit)                                                                               \
+  COUNTER(cache_miss)                                                                              \
+  COUNTER(query_coalesced)                                                                         \
+  COUNTER(refresh)                                                                                 \
+  COUNTER(eviction)                                                                                \
+  GAUGE  (entries)
+// clang-format on
+
+/**
+ * Struct definition for all DNS cache stats. @see stats_macros.h
+ */
+struct DnsCacheStats {
+  ALL_DNS_CACHE_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
+};
+
+/**
+ * A DnsResolver that caches the results of another resolver by name and lookup family, so that
+ * every cluster resolving the same name shares a single lookup:
+ * - Results are cached for the TTL of their records, bounded by min_ttl and max_ttl. Cache hits
+ *   complete synchronously.
+ * - Concurrent resolutions of a name that is not cached yet wait for a single query.
+ * - Once a result expires it is refreshed in the background if it was used since it was last
+ *   resolved, and evicted otherwise. The expired result keeps being served during the refresh.
+ * - Failed resolutions are not cached.
+ * All calls and callbacks happen on the thread that owns the dispatcher.
+ */
+class DnsCacheImpl : public DnsResolver, protected Logger::Loggable<Logger::Id::upstream> {
+public:
+  DnsCacheImpl(DnsResolverSharedPtr resolver, Event::Dispatcher& dispatcher, Stats::Scope& scope,
+               std::chrono::seconds min_ttl, std::chrono::seconds max_ttl);
+  ~DnsCacheImpl();
+
+  // Network::DnsResolver
+  ActiveDnsQuery* resolve(const std::string& dns_name, DnsLookupFamily dns_lookup_family,
+                          ResolveCb callback) override;
+  ActiveDnsQuery* resolveWithTtl(const std::string& dns_name, DnsLookupFamily dns_lookup_family,
+                                 ResolveWithTtlCb callback) override;
+
+private:
+  typedef std::pair<std::string, DnsLookupFamily> Key;
+
+  struct PendingResolution : public ActiveDnsQuery {
+    PendingResolution(ResolveWithTtlCb callback) : callback_(callback) {}
+
+    // Network::ActiveDnsQuery
+    void cancel() override { cancelled_ = true; }
+
+    const ResolveWithTtlCb callback_;
+    bool cancelled_{};
+  };
+
+  typedef std::unique_ptr<PendingResolution> PendingResolutionPtr;
+
+  struct Entry : public Event::DeferredDeletable {
+    Entry(DnsCacheImpl& parent, const Key& key);
+
+    void startResolve();
+    void onResolveComplete(std::list<Address::InstanceConstSharedPtr>&& address_list,
+                           std::chrono::seconds ttl);
+    void onExpiry();
+
+    DnsCacheImpl& parent_;
+    const Key key_;
+    Event::TimerPtr expiry_timer_;
+    ActiveDnsQuery* active_query_{};
+    bool resolving_{};
+    // Resolutions waiting for the first result of the entry.
+    std::list<PendingResolutionPtr> pending_resolutions_;
+    // Only valid once the entry has been resolved.
+    std::list<Address::InstanceConstSharedPtr> address_list_;
+    MonotonicTime expiry_time_;
+    bool resolved_{};
+    // Whether the entry was hit since it was last resolved.
+    bool used_{};
+  };
+
+  typedef std::unique_ptr<Entry> EntryPtr;
+
+  void removeEntry(Entry& entry);
+
+  const DnsResolverSharedPtr resolver_;
+  Event::Dispatcher& dispatcher_;
+  DnsCacheStats stats_;
+  const std::chrono::seconds min_ttl_;
+  const std::chrono::seconds max_ttl_;
+  std::map<Key, EntryPtr> entries_;
+};
+
+} // namespace Network
+} // namespace Envoy
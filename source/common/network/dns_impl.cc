@@ -1,9 +1,12 @@
 #include "common/network/dns_impl.h"
 
+#include <arpa/inet.h>
+#include <arpa/nameser.h>
 #include <netdb.h>
 #include <netinet/ip.h>
 #include <sys/socket.h>
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <list>
@@ -20,6 +23,15 @@
 namespace Envoy {
 namespace Network {
 
+namespace {
+
+// TTL reported for literal addresses and names in the hosts file.
+const std::chrono::seconds NoTtl = std::chrono::seconds::max();
+// Number of answers to take into account for the TTL of a response.
+const int MaxAddrTtls = 64;
+
+} // namespace
+
 DnsResolverImpl::DnsResolverImpl(
     Event::Dispatcher& dispatcher,
     const std::vector<Network::Address::InstanceConstSharedPtr>& resolvers)
@@ -75,7 +87,8 @@ void DnsResolverImpl::initializeChannel(ares_options* options, int optmask) {
 }
 
 void DnsResolverImpl::PendingResolution::onAresHostCallback(int status, int timeouts,
-                                                            hostent* hostent) {
+                                                            hostent* hostent,
+                                                            std::chrono::seconds ttl) {
   // We receive ARES_EDESTRUCTION when destructing with pending queries.
   if (status == ARES_EDESTRUCTION) {
     ASSERT(owned_);
@@ -121,7 +134,7 @@ void DnsResolverImpl::PendingResolution::onAresHostCallback(int status, int time
   if (completed_) {
     if (!cancelled_) {
       try {
-        callback_(std::move(address_list));
+        callback_(std::move(address_list), ttl);
       } catch (const EnvoyException& e) {
         ENVOY_LOG(critical, "EnvoyException in c-ares callback");
         dispatcher_.post([e] { throw e; });
@@ -148,6 +161,34 @@ void DnsResolverImpl::PendingResolution::onAresHostCallback(int status, int time
   }
 }
 
+void DnsResolverImpl::PendingResolution::onAresSearchCallback(int status, int timeouts,
+                                                              unsigned char* abuf, int alen) {
+  hostent* hostent = nullptr;
+  std::chrono::seconds ttl = NoTtl;
+  if (status == ARES_SUCCESS) {
+    int naddrttls = MaxAddrTtls;
+    if (family_ == AF_INET) {
+      ares_addrttl addrttls[MaxAddrTtls];
+      status = ares_parse_a_reply(abuf, alen, &hostent, addrttls, &naddrttls);
+      for (int i = 0; status == ARES_SUCCESS && i < naddrttls; ++i) {
+        ttl = std::min(ttl, std::chrono::seconds(std::max(addrttls[i].ttl, 0)));
+      }
+    } else {
+      ares_addr6ttl addrttls[MaxAddrTtls];
+      status = ares_parse_aaaa_reply(abuf, alen, &hostent, addrttls, &naddrttls);
+      for (int i = 0; status == ARES_SUCCESS && i < naddrttls; ++i) {
+        ttl = std::min(ttl, std::chrono::seconds(std::max(addrttls[i].ttl, 0)));
+      }
+    }
+  }
+
+  onAresHostCallback(status, timeouts, hostent, ttl);
+  // Note: this object may have been deleted by onAresHostCallback().
+  if (hostent != nullptr) {
+    ares_free_hostent(hostent);
+  }
+}
+
 void DnsResolverImpl::updateAresTimer() {
   // Update the timeout for events.
   timeval timeout;
@@ -192,9 +233,16 @@ void DnsResolverImpl::onAresSocketStateChange(int fd, int read, int write) {
 
 ActiveDnsQuery* DnsResolverImpl::resolve(const std::string& dns_name,
                                          DnsLookupFamily dns_lookup_family, ResolveCb callback) {
-  // TODO(hennna): Add DNS caching which will allow testing the edge case of a
-  // failed intial call to getHostbyName followed by a synchronous IPv4
-  // resolution.
+  return resolveWithTtl(dns_name, dns_lookup_family,
+                        [callback](std::list<Address::InstanceConstSharedPtr>&& address_list,
+                                   std::chrono::seconds) { callback(std::move(address_list)); });
+}
+
+ActiveDnsQuery* DnsResolverImpl::resolveWithTtl(const std::string& dns_name,
+                                                DnsLookupFamily dns_lookup_family,
+                                                ResolveWithTtlCb callback) {
+  // TODO(hennna): Add tests for the edge case of a failed intial call to getHostbyName followed
+  // by a synchronous IPv4 resolution.
   std::unique_ptr<PendingResolution> pending_resolution(
       new PendingResolution(callback, dispatcher_, channel_, dns_name));
   if (dns_lookup_family == DnsLookupFamily::Auto) {
@@ -223,12 +271,35 @@ ActiveDnsQuery* DnsResolverImpl::resolve(const std::string& dns_name,
 }
 
 void DnsResolverImpl::PendingResolution::getHostByName(int family) {
-  ares_gethostbyname(channel_, dns_name_.c_str(), family,
-                     [](void* arg, int status, int timeouts, hostent* hostent) {
-                       static_cast<PendingResolution*>(arg)->onAresHostCallback(status, timeouts,
-                                                                                hostent);
-                     },
-                     this);
+  family_ = family;
+
+  // ares_gethostbyname() answers literal addresses synchronously.
+  in6_addr literal;
+  if (inet_pton(AF_INET, dns_name_.c_str(), &literal) == 1 ||
+      inet_pton(AF_INET6, dns_name_.c_str(), &literal) == 1) {
+    ares_gethostbyname(channel_, dns_name_.c_str(), family,
+                       [](void* arg, int status, int timeouts, hostent* hostent) {
+                         static_cast<PendingResolution*>(arg)->onAresHostCallback(
+                             status, timeouts, hostent, NoTtl);
+                       },
+                       this);
+    return;
+  }
+
+  hostent* hostent;
+  if (ares_gethostbyname_file(channel_, dns_name_.c_str(), family, &hostent) == ARES_SUCCESS) {
+    onAresHostCallback(ARES_SUCCESS, 0, hostent, NoTtl);
+    // Note: this object may have been deleted by onAresHostCallback().
+    ares_free_hostent(hostent);
+    return;
+  }
+
+  ares_search(channel_, dns_name_.c_str(), C_IN, family == AF_INET ? T_A : T_AAAA,
+              [](void* arg, int status, int timeouts, unsigned char* abuf, int alen) {
+                static_cast<PendingResolution*>(arg)->onAresSearchCallback(status, timeouts, abuf,
+                                                                           alen);
+              },
+              this);
 }
 
 } // namespace Network
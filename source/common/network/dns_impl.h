@@ -2,6 +2,7 @@
 
 #include <netdb.h>
 
+#include <chrono>
 #include <cstdint>
 #include <string>
 #include <unordered_map>
@@ -34,13 +35,15 @@ public:
   // Network::DnsResolver
   ActiveDnsQuery* resolve(const std::string& dns_name, DnsLookupFamily dns_lookup_family,
                           ResolveCb callback) override;
+  ActiveDnsQuery* resolveWithTtl(const std::string& dns_name, DnsLookupFamily dns_lookup_family,
+                                 ResolveWithTtlCb callback) override;
 
 private:
   friend class DnsResolverImplPeer;
   struct PendingResolution : public ActiveDnsQuery {
     // Network::ActiveDnsQuery
-    PendingResolution(ResolveCb callback, Event::Dispatcher& dispatcher, ares_channel channel,
-                      const std::string& dns_name)
+    PendingResolution(ResolveWithTtlCb callback, Event::Dispatcher& dispatcher,
+                      ares_channel channel, const std::string& dns_name)
         : callback_(callback), dispatcher_(dispatcher), channel_(channel), dns_name_(dns_name) {}
 
     void cancel() override {
@@ -50,20 +53,31 @@ private:
     }
 
     /**
-     * c-ares ares_gethostbyname() query callback.
-     * @param status return status of call to ares_gethostbyname.
+     * Completes a lookup of a single address family.
+     * @param status return status of the lookup.
      * @param timeouts the number of times the request timed out.
      * @param hostent structure that stores information about a given host.
+     * @param ttl the lowest TTL of the records the addresses in hostent were resolved from.
      */
-    void onAresHostCallback(int status, int timeouts, hostent* hostent);
+    void onAresHostCallback(int status, int timeouts, hostent* hostent, std::chrono::seconds ttl);
     /**
-     * wrapper function of call to ares_gethostbyname.
+     * c-ares ares_search() query callback.
+     * @param status return status of call to ares_search.
+     * @param timeouts the number of times the request timed out.
+     * @param abuf the DNS response.
+     * @param alen the length of abuf.
+     */
+    void onAresSearchCallback(int status, int timeouts, unsigned char* abuf, int alen);
+    /**
+     * Looks up the addresses of a single address family. Literal addresses and names in the hosts
+     * file are resolved without a query and have no TTL. Everything else is queried with
+     * ares_search() rather than ares_gethostbyname() so the TTLs of the answers are known.
      * @param family currently AF_INET and AF_INET6 are supported.
      */
     void getHostByName(int family);
 
     // Caller supplied callback to invoke on query completion or error.
-    const ResolveCb callback_;
+    const ResolveWithTtlCb callback_;
     // Dispatcher to post any callback_ exceptions to.
     Event::Dispatcher& dispatcher_;
     // Does the object own itself? Resource reclamation occurs via self-deleting
@@ -76,6 +90,8 @@ private:
     // If dns_lookup_family is "fallback", fallback to v4 address if v6
     // resolution failed.
     bool fallback_if_failed_ = false;
+    // The address family currently being looked up.
+    int family_ = AF_UNSPEC;
     const ares_channel channel_;
     const std::string dns_name_;
   };
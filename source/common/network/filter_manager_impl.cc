@@ -1,5 +1,6 @@
 #include "common/network/filter_manager_impl.h"
 
+#include <algorithm>
 #include <list>
 
 #include "envoy/network/connection.h"
@@ -34,6 +35,17 @@ bool FilterManagerImpl::initializeReadFilters() {
   return true;
 }
 
+bool FilterManagerImpl::idleForTransfer() const {
+  if (upstream_filters_.empty()) {
+    return false;
+  }
+  // A filter that has not seen onNewConnection() yet is still setting up the connection.
+  return std::all_of(upstream_filters_.begin(), upstream_filters_.end(),
+                     [](const ActiveReadFilterPtr& filter) {
+                       return filter->initialized_ && filter->filter_->idleForTransfer();
+                     });
+}
+
 void FilterManagerImpl::onContinueReading(ActiveReadFilter* filter) {
   std::list<ActiveReadFilterPtr>::iterator entry;
   if (!filter) {
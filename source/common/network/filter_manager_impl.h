@@ -45,6 +45,7 @@ public:
   void addFilter(FilterSharedPtr filter);
   void addReadFilter(ReadFilterSharedPtr filter);
   bool initializeReadFilters();
+  bool idleForTransfer() const;
   void onRead();
   FilterStatus onWrite();
 
@@ -23,10 +23,10 @@ namespace LcTrie {
 
 /**
  * Maximum number of nodes an LC trie can hold.
- * @note If the size of LcTrieInternal::LcNode::address_ ever changes, this constant
- *       should be changed to match.
+ * @note LcTrieInternal::LcNode::address_ must be able to index this many nodes, plus the largest
+ *       block of 2^31 children that can be allocated before a node beyond the limit is set.
  */
-constexpr size_t MaxLcTrieNodes = (1 << 20);
+constexpr size_t MaxLcTrieNodes = (1 << 30);
 
 /**
  * Level Compressed Trie for associating data with CIDR ranges. Both IPv4 and IPv6 addresses are
@@ -57,8 +57,8 @@ public:
   LcTrie(const std::vector<std::pair<T, std::vector<Address::CidrRange>>>& data,
          bool exclusive = false, double fill_factor = 0.5, uint32_t root_branching_factor = 0) {
 
-    // The LcTrie implementation uses 20-bit "pointers" in its compact internal representation,
-    // so it cannot hold more than 2^20 nodes. But the number of nodes can be greater than the
+    // The LcTrie implementation uses 32-bit "pointers" in its compact internal representation,
+    // and holds at most 2^30 nodes. But the number of nodes can be greater than the
     // number of supported prefixes. Given N prefixes in the data input list, step 2 below can
     // produce a new list of up to 2*N prefixes to insert in the LC trie. And the LC trie can
     // use up to 2*N/fill_factor nodes.
@@ -407,7 +407,7 @@ private:
    * 'http://www.csc.kth.se/~snilsson/software/router/C/' were used as reference during
    * implementation.
    *
-   * Note: The trie can only support up 524288(2^19) prefixes with a fill_factor of 1 and
+   * Note: The trie can only support up to 536870912(2^29) prefixes with a fill_factor of 1 and
    * root_branching_factor not set. Refer to LcTrieInternal::build() method for more details.
    */
   template <class IpType, uint32_t address_size = CHAR_BIT * sizeof(IpType)> class LcTrieInternal {
@@ -656,7 +656,7 @@ private:
     }
 
     /**
-     * LcNode is a uint32_t. A wrapper is provided to simplify getting/setting the branch, the
+     * LcNode is a uint64_t. A wrapper is provided to simplify getting/setting the branch, the
      * skip and the address values held within the structure.
      *
      * The LcNode has three parts to it
@@ -665,17 +665,17 @@ private:
      * 2, so there can be at most 2^31 descendant nodes.
      * - Skip: the next 7 bits represent the number of bits to skip when looking at an IP address.
      * This value can be between 0 and 127, so IPv6 is supported.
-     * - Address: the remaining 20 bits represent an index either into the trie_ or the
+     * - Address: the next 32 bits represent an index either into the trie_ or the
      * ip_prefixes_. If branch_ != 0, the index is for the trie_. If branch == zero, the index is
      * for the ip_prefixes_.
      *
-     * Note: If more than 2^19-1 CIDR ranges are to be stored in trie_, uint64_t should be used
-     * instead.
+     * Note: A 32-bit node with a 20-bit address limited the trie to 2^20 nodes, too few for
+     * large geo-IP or threat intelligence datasets. The remaining 20 bits are unused.
      */
     struct LcNode {
-      uint32_t branch_ : 5;
-      uint32_t skip_ : 7;
-      uint32_t address_ : 20; // If this 20-bit size changes, please change MaxLcTrieNodes too.
+      uint64_t branch_ : 5;
+      uint64_t skip_ : 7;
+      uint64_t address_ : 32; // If this 32-bit size changes, please change MaxLcTrieNodes too.
     };
 
     // The CIDR range and data needs to be maintained separately from the LC-Trie. A LC-Trie skips
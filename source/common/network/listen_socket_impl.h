@@ -73,6 +73,15 @@ public:
 
 typedef std::unique_ptr<TcpListenSocket> TcpListenSocketPtr;
 
+/**
+ * Wraps a bound datagram socket.
+ */
+class UdpListenSocket : public ListenSocketImpl {
+public:
+  UdpListenSocket(const Address::InstanceConstSharedPtr& address,
+                  const Network::Socket::OptionsSharedPtr& options, bool bind_to_port);
+};
+
 class UdsListenSocket : public ListenSocketImpl {
 public:
   UdsListenSocket(const Address::InstanceConstSharedPtr& address);
@@ -117,12 +126,24 @@ public:
   }
   absl::string_view requestedServerName() const override { return server_name_; }
 
+  void setDynamicMetadata(const std::string& name, const ProtobufWkt::Struct& value) override {
+    if (metadata_ == nullptr) {
+      metadata_ = std::make_unique<envoy::api::v2::core::Metadata>();
+    }
+    (*metadata_->mutable_filter_metadata())[name].MergeFrom(value);
+  }
+  const envoy::api::v2::core::Metadata& dynamicMetadata() const override {
+    return metadata_ != nullptr ? *metadata_ : envoy::api::v2::core::Metadata::default_instance();
+  }
+
 protected:
   Address::InstanceConstSharedPtr remote_address_;
   bool local_address_restored_{false};
   std::string transport_protocol_;
   std::vector<std::string> application_protocols_;
   std::string server_name_;
+  // Only allocated once a listener filter sets metadata, which most connections don't have.
+  std::unique_ptr<envoy::api::v2::core::Metadata> metadata_;
 };
 
 // ConnectionSocket used with server connections.
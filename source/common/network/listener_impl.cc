@@ -1,6 +1,9 @@
 #include "common/network/listener_impl.h"
 
+#include <poll.h>
+#include <sys/socket.h>
 #include <sys/un.h>
+#include <unistd.h>
 
 #include "envoy/common/exception.h"
 
@@ -11,22 +14,63 @@
 #include "common/event/file_event_impl.h"
 #include "common/network/address_impl.h"
 
-#include "event2/listener.h"
+#include "event2/util.h"
 
 namespace Envoy {
 namespace Network {
 
+namespace {
+// Backlog passed to listen() for every bound listener.
+constexpr int ListenBacklog = 128;
+} // namespace
+
 Address::InstanceConstSharedPtr ListenerImpl::getLocalAddress(int fd) {
   return Address::addressFromFd(fd);
 }
 
-void ListenerImpl::listenCallback(evconnlistener*, evutil_socket_t fd, sockaddr* remote_addr,
-                                  int remote_addr_len, void* arg) {
-  ListenerImpl* listener = static_cast<ListenerImpl*>(arg);
+int ListenerImpl::acceptSocket(int fd, sockaddr_storage& remote_addr, socklen_t& remote_addr_len) {
+#if defined(__APPLE__)
+  const int accepted_fd = ::accept(fd, reinterpret_cast<sockaddr*>(&remote_addr), &remote_addr_len);
+  if (accepted_fd >= 0) {
+    // Cannot pass SOCK_NONBLOCK to accept().
+    RELEASE_ASSERT(evutil_make_socket_nonblocking(accepted_fd) != -1, "");
+  }
+  return accepted_fd;
+#else
+  return ::accept4(fd, reinterpret_cast<sockaddr*>(&remote_addr), &remote_addr_len, SOCK_NONBLOCK);
+#endif
+}
+
+void ListenerImpl::onSocketEvent() {
+  uint32_t accepted = 0;
+  bool limit_reached = true;
+  while (accepted < max_accepts_per_wakeup_) {
+    sockaddr_storage remote_addr;
+    socklen_t remote_addr_len = sizeof(remote_addr);
+    const int fd = acceptSocket(socket_.fd(), remote_addr, remote_addr_len);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        limit_reached = false;
+        break;
+      }
+      errorCallback();
+    }
+    accepted++;
+    onAccepted(fd, remote_addr, remote_addr_len);
+  }
+
+  cb_.onAcceptBatch(accepted, limit_reached);
+}
+
+void ListenerImpl::onAccepted(int fd, const sockaddr_storage& remote_addr,
+                              socklen_t remote_addr_len) {
   // Get the local address from the new socket if the listener is listening on IP ANY
   // (e.g., 0.0.0.0 for IPv4) (local_address_ is nullptr in this case).
   const Address::InstanceConstSharedPtr& local_address =
-      listener->local_address_ ? listener->local_address_ : listener->getLocalAddress(fd);
+      local_address_ ? local_address_ : getLocalAddress(fd);
   // The accept() call that filled in remote_addr doesn't fill in more than the sa_family field
   // for Unix domain sockets; apparently there isn't a mechanism in the kernel to get the
   // sockaddr_un associated with the client socket when starting from the server socket.
@@ -35,20 +79,97 @@ void ListenerImpl::listenCallback(evconnlistener*, evutil_socket_t fd, sockaddr*
   // if the socket is a v4 socket, but for v6 sockets this will create an IPv4 remote address if an
   // IPv4 local_address was created from an IPv6 mapped IPv4 address.
   const Address::InstanceConstSharedPtr& remote_address =
-      (remote_addr->sa_family == AF_UNIX)
+      (remote_addr.ss_family == AF_UNIX)
           ? Address::peerAddressFromFd(fd)
-          : Address::addressFromSockAddr(*reinterpret_cast<const sockaddr_storage*>(remote_addr),
-                                         remote_addr_len,
+          : Address::addressFromSockAddr(remote_addr, remote_addr_len,
                                          local_address->ip()->version() == Address::IpVersion::v6);
-  listener->cb_.onAccept(std::make_unique<AcceptedSocketImpl>(fd, local_address, remote_address),
-                         listener->hand_off_restored_destination_connections_);
+  cb_.onAccept(std::make_unique<AcceptedSocketImpl>(fd, local_address, remote_address),
+               hand_off_restored_destination_connections_);
+}
+
+ListenerImpl::IoUringAcceptor::IoUringAcceptor(ListenerImpl& parent, Event::IoUringImpl& ring)
+    : parent_(&parent), ring_(ring) {}
+
+void ListenerImpl::IoUringAcceptor::prepareAccept() {
+  polling_ = false;
+  remote_addr_len_ = sizeof(remote_addr_);
+  ring_.prepareAccept(parent_->socket_.fd(), remote_addr_, remote_addr_len_, *this);
+}
+
+void ListenerImpl::IoUringAcceptor::preparePoll() {
+  polling_ = true;
+  ring_.preparePoll(parent_->socket_.fd(), POLLIN, *this);
+}
+
+void ListenerImpl::IoUringAcceptor::onCompletion(int32_t result) {
+  if (parent_ == nullptr) {
+    // The listener is gone. Close a connection that was accepted before the cancellation landed.
+    if (!polling_ && result >= 0) {
+      ::close(result);
+    }
+    return;
+  }
+
+  if (polling_) {
+    prepareAccept();
+    return;
+  }
+
+  if (result >= 0) {
+    accepted_++;
+    parent_->onAccepted(result, remote_addr_, remote_addr_len_);
+    if (parent_ == nullptr) {
+      // The listener was destroyed by the accept callback.
+      return;
+    }
+    if (accepted_ < parent_->max_accepts_per_wakeup_) {
+      prepareAccept();
+    } else {
+      // Let the rest of the loop run before accepting more. An accept or poll queued now would
+      // complete inline and be handled in this same wakeup.
+      const uint32_t accepted = accepted_;
+      accepted_ = 0;
+      parent_->io_uring_resume_timer_->enableTimer(std::chrono::milliseconds(0));
+      parent_->cb_.onAcceptBatch(accepted, true);
+      // The listener may have been destroyed by the batch callback, in which case it handed this
+      // acceptor to the ring, which destroys it once this returns.
+      if (parent_ != nullptr) {
+        waiting_for_resume_ = true;
+      }
+    }
+    return;
+  }
+
+  switch (-result) {
+  case EAGAIN:
+    // Older kernels fail accepts on a non-blocking socket instead of waiting for a connection.
+    preparePoll();
+    break;
+  case EINTR:
+  case ECONNABORTED:
+    prepareAccept();
+    break;
+  default:
+    errno = -result;
+    errorCallback();
+  }
+}
+
+void ListenerImpl::IoUringAcceptor::onCompletionBatchDone() {
+  // Everything that was queued has been accepted.
+  if (parent_ != nullptr && accepted_ > 0) {
+    parent_->cb_.onAcceptBatch(accepted_, false);
+    accepted_ = 0;
+  }
 }
 
 ListenerImpl::ListenerImpl(Event::DispatcherImpl& dispatcher, Socket& socket, ListenerCallbacks& cb,
-                           bool bind_to_port, bool hand_off_restored_destination_connections)
+                           bool bind_to_port, bool hand_off_restored_destination_connections,
+                           uint32_t max_accepts_per_wakeup)
     : local_address_(nullptr), cb_(cb),
       hand_off_restored_destination_connections_(hand_off_restored_destination_connections),
-      listener_(nullptr) {
+      socket_(socket), max_accepts_per_wakeup_(max_accepts_per_wakeup) {
+  ASSERT(max_accepts_per_wakeup_ > 0);
   const auto ip = socket.localAddress()->ip();
 
   // Only use the listen socket's local address for new connections if it is not the all hosts
@@ -58,10 +179,9 @@ ListenerImpl::ListenerImpl(Event::DispatcherImpl& dispatcher, Socket& socket, Li
   }
 
   if (bind_to_port) {
-    listener_.reset(
-        evconnlistener_new(&dispatcher.base(), listenCallback, this, 0, -1, socket.fd()));
-
-    if (!listener_) {
+    // The accept loop relies on accept() failing with EAGAIN once the queue is drained.
+    if (evutil_make_socket_nonblocking(socket.fd()) == -1 ||
+        ::listen(socket.fd(), ListenBacklog) == -1) {
       throw CreateListenerException(
           fmt::format("cannot listen on socket: {}", socket.localAddress()->asString()));
     }
@@ -72,13 +192,42 @@ ListenerImpl::ListenerImpl(Event::DispatcherImpl& dispatcher, Socket& socket, Li
           "cannot set post-listen socket option on socket: {}", socket.localAddress()->asString()));
     }
 
-    evconnlistener_set_error_cb(listener_.get(), errorCallback);
+    io_uring_ = dispatcher.ioUring();
+    if (io_uring_ != nullptr) {
+      io_uring_acceptor_ = std::make_unique<IoUringAcceptor>(*this, *io_uring_);
+      io_uring_resume_timer_ = dispatcher.createTimer([this]() -> void {
+        io_uring_acceptor_->waiting_for_resume_ = false;
+        io_uring_acceptor_->prepareAccept();
+        io_uring_->submit();
+      });
+      io_uring_acceptor_->prepareAccept();
+      io_uring_->submit();
+    } else {
+      file_event_ = dispatcher.createFileEvent(
+          socket.fd(), [this](uint32_t) -> void { onSocketEvent(); },
+          Event::FileTriggerType::Level, Event::FileReadyType::Read);
+    }
+  }
+}
+
+ListenerImpl::~ListenerImpl() {
+  if (io_uring_acceptor_ == nullptr) {
+    return;
+  }
+  if (io_uring_acceptor_->waiting_for_resume_) {
+    // Nothing is in flight, but the acceptor may still be due to hear about the end of a batch.
+    io_uring_->release(*io_uring_acceptor_);
+    return;
   }
+  // The ring owns the acceptor until the kernel is done with the operation in flight, or until
+  // the completion being delivered to it returns.
+  io_uring_acceptor_->parent_ = nullptr;
+  io_uring_->cancel(std::move(io_uring_acceptor_));
 }
 
-void ListenerImpl::errorCallback(evconnlistener*, void*) {
-  // We should never get an error callback. This can happen if we run out of FDs or memory. In those
-  // cases just crash.
+void ListenerImpl::errorCallback() {
+  // We should never get an accept error other than the retriable ones handled by the accept loop.
+  // This can happen if we run out of FDs or memory. In those cases just crash.
   PANIC(fmt::format("listener accept failure: {}", strerror(errno)));
 }
 
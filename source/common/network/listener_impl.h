@@ -1,23 +1,27 @@
 #pragma once
 
+#include "envoy/event/file_event.h"
+#include "envoy/event/timer.h"
 #include "envoy/network/listener.h"
 
 #include "common/event/dispatcher_impl.h"
+#include "common/event/io_uring_impl.h"
 #include "common/event/libevent.h"
 #include "common/network/listen_socket_impl.h"
 
-#include "event2/event.h"
-
 namespace Envoy {
 namespace Network {
 
 /**
- * libevent implementation of Network::Listener.
+ * Implementation of Network::Listener that accepts connections directly from the listen socket
+ * when it becomes readable.
  */
 class ListenerImpl : public Listener {
 public:
   ListenerImpl(Event::DispatcherImpl& dispatcher, Socket& socket, ListenerCallbacks& cb,
-               bool bind_to_port, bool hand_off_restored_destination_connections);
+               bool bind_to_port, bool hand_off_restored_destination_connections,
+               uint32_t max_accepts_per_wakeup);
+  ~ListenerImpl();
 
 protected:
   virtual Address::InstanceConstSharedPtr getLocalAddress(int fd);
@@ -27,11 +31,44 @@ protected:
   const bool hand_off_restored_destination_connections_;
 
 private:
-  static void errorCallback(evconnlistener* listener, void* context);
-  static void listenCallback(evconnlistener*, evutil_socket_t fd, sockaddr* remote_addr,
-                             int remote_addr_len, void* arg);
+  /**
+   * Accepts connections through the dispatcher's io_uring. One accept, or a readiness poll when the
+   * kernel reports an empty accept queue instead of waiting, is in flight at a time.
+   */
+  class IoUringAcceptor : public Event::IoUringRequest {
+  public:
+    IoUringAcceptor(ListenerImpl& parent, Event::IoUringImpl& ring);
+
+    // Event::IoUringRequest
+    void onCompletion(int32_t result) override;
+    void onCompletionBatchDone() override;
+
+    void prepareAccept();
+    void preparePoll();
+
+    // Cleared when the listener is destroyed while an operation is still in flight.
+    ListenerImpl* parent_;
+    Event::IoUringImpl& ring_;
+    bool polling_{};
+    // Set while nothing is in flight because the accept limit was reached.
+    bool waiting_for_resume_{};
+    uint32_t accepted_{};
+    sockaddr_storage remote_addr_;
+    socklen_t remote_addr_len_;
+  };
+
+  static void errorCallback();
+  static int acceptSocket(int fd, sockaddr_storage& remote_addr, socklen_t& remote_addr_len);
+  void onSocketEvent();
+  void onAccepted(int fd, const sockaddr_storage& remote_addr, socklen_t remote_addr_len);
 
-  Event::Libevent::ListenerPtr listener_;
+  Socket& socket_;
+  const uint32_t max_accepts_per_wakeup_;
+  Event::FileEventPtr file_event_;
+  Event::IoUringImpl* io_uring_{};
+  std::unique_ptr<IoUringAcceptor> io_uring_acceptor_;
+  // Resumes io_uring accepts on the next loop iteration after max_accepts_per_wakeup_ is reached.
+  Event::TimerPtr io_uring_resume_timer_;
 };
 
 } // namespace Network
@@ -0,0 +1,83 @@
+#include "common/network/quic_connection_id_routing_socket_option_impl.h"
+
+#include <sys/socket.h>
+
+#include <cstring>
+
+#include "common/common/assert.h"
+#include "common/common/macros.h"
+#include "common/network/socket_option_impl.h"
+
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+#include <linux/filter.h>
+#endif
+
+namespace Envoy {
+namespace Network {
+
+namespace {
+
+std::string buildProgram(uint32_t sockets) {
+  ASSERT(sockets > 0);
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+  // The destination connection ID follows the first byte of a short header packet. Long header
+  // packets, whose first bit is set, carry a version and the connection ID length in between.
+  const sock_filter program[] = {
+      // A = packet[0]
+      BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 0),
+      // if (!(A & 0x80)) goto short_header
+      BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x80, 0, 2),
+      // A = packet[6..9]
+      BPF_STMT(BPF_LD | BPF_W | BPF_ABS, 6),
+      // goto select
+      BPF_JUMP(BPF_JMP | BPF_JA, 1, 0, 0),
+      // short_header: A = packet[1..4]
+      BPF_STMT(BPF_LD | BPF_W | BPF_ABS, 1),
+      // select: return A % sockets
+      BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, sockets),
+      BPF_STMT(BPF_RET | BPF_A, 0),
+  };
+  return std::string(reinterpret_cast<const char*>(program), sizeof(program));
+#else
+  UNREFERENCED_PARAMETER(sockets);
+  return "";
+#endif
+}
+
+} // namespace
+
+QuicConnectionIdRoutingSocketOptionImpl::QuicConnectionIdRoutingSocketOptionImpl(uint32_t sockets)
+    : program_(buildProgram(sockets)) {}
+
+bool QuicConnectionIdRoutingSocketOptionImpl::setOption(
+    Socket& socket, envoy::api::v2::core::SocketOption::SocketState state) const {
+  // The socket must be in its SO_REUSEPORT group, which it joins when bound.
+  if (state != envoy::api::v2::core::SocketOption::STATE_BOUND) {
+    return true;
+  }
+
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+  sock_fprog fprog;
+  fprog.len = program_.size() / sizeof(sock_filter);
+  fprog.filter = reinterpret_cast<sock_filter*>(const_cast<char*>(program_.data()));
+  const Api::SysCallIntResult result = SocketOptionImpl::setSocketOption(
+      socket, ENVOY_SOCKET_SO_ATTACH_REUSEPORT_CBPF,
+      absl::string_view(reinterpret_cast<const char*>(&fprog), sizeof(fprog)));
+#else
+  const Api::SysCallIntResult result =
+      SocketOptionImpl::setSocketOption(socket, ENVOY_SOCKET_SO_ATTACH_REUSEPORT_CBPF, "");
+#endif
+  if (result.rc_ != 0) {
+    ENVOY_LOG(warn, "Attaching the QUIC connection ID routing program failed: {}",
+              strerror(result.errno_));
+    return false;
+  }
+  return true;
+}
+
+bool QuicConnectionIdRoutingSocketOptionImpl::isSupported() const {
+  return ENVOY_SOCKET_SO_ATTACH_REUSEPORT_CBPF.has_value();
+}
+
+} // namespace Network
+} // namespace Envoy
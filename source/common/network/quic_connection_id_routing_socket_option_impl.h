@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "envoy/network/listen_socket.h"
+
+#include "common/common/logger.h"
+
+namespace Envoy {
+namespace Network {
+
+/**
+ * Attaches a classic BPF program to the SO_REUSEPORT group of a bound UDP socket, which makes the
+ * kernel pick the socket of a datagram from the QUIC destination connection ID it carries rather
+ * than from a hash of the peer's address. The first 4 bytes of the connection ID, modulo the
+ * number of sockets, select the socket in the order the sockets were bound. The datagrams of a
+ * QUIC connection thus stay on the same socket when the peer's address changes, and a server
+ * which picks its connection IDs accordingly decides which socket receives their datagrams.
+ * Datagrams too short to carry 4 bytes of connection ID go to the first socket.
+ *
+ * The program only applies to the sockets bound to the address by this process if they are the
+ * only ones in the group, which is not the case during a hot restart.
+ */
+class QuicConnectionIdRoutingSocketOptionImpl : public Socket::Option,
+                                                Logger::Loggable<Logger::Id::connection> {
+public:
+  /**
+   * @param sockets supplies the number of sockets in the group, which must be at least 1.
+   */
+  QuicConnectionIdRoutingSocketOptionImpl(uint32_t sockets);
+
+  // Socket::Option
+  bool setOption(Socket& socket,
+                 envoy::api::v2::core::SocketOption::SocketState state) const override;
+  // The option only applies to listen sockets, which don't require a hash key.
+  void hashKey(std::vector<uint8_t>&) const override {}
+
+  bool isSupported() const;
+
+private:
+  // The BPF program, as the array of sock_filter instructions setsockopt(2) expects.
+  const std::string program_;
+};
+
+} // namespace Network
+} // namespace Envoy
@@ -1,5 +1,7 @@
 #include "common/network/raw_buffer_socket.h"
 
+#include <algorithm>
+
 #include "common/common/assert.h"
 #include "common/common/empty_string.h"
 #include "common/http/headers.h"
@@ -7,6 +9,16 @@
 namespace Envoy {
 namespace Network {
 
+constexpr uint64_t ReadSizing::DefaultReadSize;
+
+RawBufferSocket::RawBufferSocket(const ReadSizing& read_sizing)
+    : read_sizing_(read_sizing),
+      read_size_(std::min(std::max(ReadSizing::DefaultReadSize, read_sizing.min_read_size_),
+                          read_sizing.max_read_size_)) {
+  ASSERT(read_sizing_.min_read_size_ > 0);
+  ASSERT(read_sizing_.min_read_size_ <= read_sizing_.max_read_size_);
+}
+
 void RawBufferSocket::setTransportSocketCallbacks(TransportSocketCallbacks& callbacks) {
   callbacks_ = &callbacks;
 }
@@ -16,8 +28,7 @@ IoResult RawBufferSocket::doRead(Buffer::Instance& buffer) {
   uint64_t bytes_read = 0;
   bool end_stream = false;
   do {
-    // 16K read is arbitrary. TODO(mattklein123) PERF: Tune the read size.
-    Api::SysCallIntResult result = buffer.read(callbacks_->fd(), 16384);
+    Api::SysCallIntResult result = buffer.read(callbacks_->fd(), read_size_);
     ENVOY_CONN_LOG(trace, "read returns: {}", callbacks_->connection(), result.rc_);
 
     if (result.rc_ == 0) {
@@ -33,6 +44,7 @@ IoResult RawBufferSocket::doRead(Buffer::Instance& buffer) {
       break;
     } else {
       bytes_read += result.rc_;
+      updateReadSize(result.rc_);
       if (callbacks_->shouldDrainReadBuffer()) {
         callbacks_->setReadBufferReady();
         break;
@@ -43,6 +55,15 @@ IoResult RawBufferSocket::doRead(Buffer::Instance& buffer) {
   return {action, bytes_read, end_stream};
 }
 
+void RawBufferSocket::updateReadSize(uint64_t bytes_read) {
+  if (bytes_read >= read_size_) {
+    // The socket had at least as much data as was asked for; read more at a time.
+    read_size_ = std::min(read_size_ * 2, read_sizing_.max_read_size_);
+  } else if (bytes_read < read_size_ / 4) {
+    read_size_ = std::max(read_size_ / 2, read_sizing_.min_read_size_);
+  }
+}
+
 IoResult RawBufferSocket::doWrite(Buffer::Instance& buffer, bool end_stream) {
   PostIoAction action;
   uint64_t bytes_written = 0;
@@ -83,7 +104,7 @@ std::string RawBufferSocket::protocol() const { return EMPTY_STRING; }
 void RawBufferSocket::onConnected() { callbacks_->raiseEvent(ConnectionEvent::Connected); }
 
 TransportSocketPtr RawBufferSocketFactory::createTransportSocket() const {
-  return std::make_unique<RawBufferSocket>();
+  return std::make_unique<RawBufferSocket>(read_sizing_);
 }
 
 bool RawBufferSocketFactory::implementsSecureTransport() const { return false; }
@@ -9,8 +9,21 @@
 namespace Envoy {
 namespace Network {
 
+/**
+ * Bounds for the adaptive read size of a RawBufferSocket. The default bounds give a fixed read
+ * size of DefaultReadSize.
+ */
+struct ReadSizing {
+  static constexpr uint64_t DefaultReadSize = 16384;
+
+  uint64_t min_read_size_{DefaultReadSize};
+  uint64_t max_read_size_{DefaultReadSize};
+};
+
 class RawBufferSocket : public TransportSocket, protected Logger::Loggable<Logger::Id::connection> {
 public:
+  RawBufferSocket(const ReadSizing& read_sizing = {});
+
   // Network::TransportSocket
   void setTransportSocketCallbacks(TransportSocketCallbacks& callbacks) override;
   std::string protocol() const override;
@@ -20,17 +33,33 @@ public:
   IoResult doRead(Buffer::Instance& buffer) override;
   IoResult doWrite(Buffer::Instance& buffer, bool end_stream) override;
   const Ssl::Connection* ssl() const override { return nullptr; }
+  bool passthrough() const override { return true; }
+
+  /**
+   * @return the number of bytes that will be requested by the next read.
+   */
+  uint64_t readSize() const { return read_size_; }
 
 private:
+  // Adjusts read_size_ based on how much of the last read request was filled.
+  void updateReadSize(uint64_t bytes_read);
+
+  const ReadSizing read_sizing_;
+  uint64_t read_size_;
   TransportSocketCallbacks* callbacks_{};
   bool shutdown_{};
 };
 
 class RawBufferSocketFactory : public TransportSocketFactory {
 public:
+  RawBufferSocketFactory(const ReadSizing& read_sizing = {}) : read_sizing_(read_sizing) {}
+
   // Network::TransportSocketFactory
   TransportSocketPtr createTransportSocket() const override;
   bool implementsSecureTransport() const override;
+
+private:
+  const ReadSizing read_sizing_;
 };
 
 } // namespace Network
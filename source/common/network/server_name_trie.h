@@ -0,0 +1,169 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "common/common/non_copyable.h"
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+namespace Network {
+
+/**
+ * Trie associating data with server names (i.e. "www.example.com") and wildcard domains
+ * (i.e. "*.example.com"), as used to match the name requested through SNI. Names are split into
+ * labels which are inserted in reverse order, from the top-level domain down, so that a single
+ * walk of the trie finds both the exact match and the most specific wildcard match. Lookups don't
+ * build any string nor allocate, and their cost depends on the number of labels of the name rather
+ * than on the number of names in the trie. Labels are compared ignoring case.
+ */
+template <class T> class ServerNameTrie : NonCopyable {
+public:
+  ServerNameTrie() : nodes_(1) {}
+
+  /**
+   * @param name supplies a server name or a wildcard domain.
+   * @return whether the name is a wildcard domain, i.e. "*.example.com".
+   */
+  static bool isWildcard(absl::string_view name) { return absl::StartsWith(name, "*."); }
+
+  /**
+   * Returns the data associated with a server name or a wildcard domain, which is default
+   * constructed by the first call for the name.
+   * @param name supplies a server name, or a wildcard domain. A wildcard domain matches the
+   *        names with at least one more label, i.e. "*.example.com" matches "www.example.com" and
+   *        "www.eu.example.com", but not "example.com".
+   * @return T& the data, whose address is stable for the lifetime of the trie.
+   */
+  T& emplace(absl::string_view name) {
+    const bool wildcard = isWildcard(name);
+    if (wildcard) {
+      name.remove_prefix(2);
+    }
+
+    Node* node = &nodes_.front();
+    size_t end = name.size();
+    while (true) {
+      const size_t dot = previousDot(name, end);
+      const size_t begin = dot == absl::string_view::npos ? 0 : dot + 1;
+      const absl::string_view label = name.substr(begin, end - begin);
+      const auto child = node->children_.find(label);
+      if (child != node->children_.end()) {
+        node = child->second;
+      } else {
+        // Nodes are never moved by the deque, so their labels can key the map of their parent.
+        nodes_.emplace_back(label);
+        Node* new_node = &nodes_.back();
+        node->children_.emplace(new_node->label_, new_node);
+        node = new_node;
+      }
+      if (dot == absl::string_view::npos) {
+        break;
+      }
+      end = dot;
+    }
+
+    std::unique_ptr<T>& data = wildcard ? node->wildcard_ : node->exact_;
+    if (data == nullptr) {
+      data = std::make_unique<T>();
+    }
+    return *data;
+  }
+
+  /**
+   * Finds the data of the most specific match of a server name.
+   * @param name supplies the server name.
+   * @return const T* the data associated with the name itself, otherwise the data associated with
+   *         the longest wildcard domain matching the name, or nullptr if there is none.
+   */
+  const T* find(absl::string_view name) const {
+    if (name.empty()) {
+      return nullptr;
+    }
+
+    const T* wildcard_match = nullptr;
+    const Node* node = &nodes_.front();
+    size_t end = name.size();
+    while (true) {
+      const size_t dot = previousDot(name, end);
+      const size_t begin = dot == absl::string_view::npos ? 0 : dot + 1;
+      node = node->child(name.substr(begin, end - begin));
+      if (node == nullptr) {
+        return wildcard_match;
+      }
+      if (dot == absl::string_view::npos) {
+        return node->exact_ != nullptr ? node->exact_.get() : wildcard_match;
+      }
+      // There is at least one more label, which a wildcard domain ending here matches.
+      if (node->wildcard_ != nullptr) {
+        wildcard_match = node->wildcard_.get();
+      }
+      end = dot;
+    }
+  }
+
+private:
+  // Case insensitive hashing and comparison of labels, inlined in the lookups unlike the ones of
+  // StringUtil.
+  struct LabelHash {
+    size_t operator()(absl::string_view label) const {
+      size_t hash = 5381;
+      for (const char c : label) {
+        hash = ((hash << 5) + hash) + static_cast<unsigned char>(absl::ascii_tolower(c));
+      }
+      return hash;
+    }
+  };
+
+  struct LabelEqual {
+    bool operator()(absl::string_view lhs, absl::string_view rhs) const {
+      if (lhs.size() != rhs.size()) {
+        return false;
+      }
+      for (size_t i = 0; i < lhs.size(); i++) {
+        if (absl::ascii_tolower(lhs[i]) != absl::ascii_tolower(rhs[i])) {
+          return false;
+        }
+      }
+      return true;
+    }
+  };
+
+  struct Node {
+    Node() {}
+    Node(absl::string_view label) : label_(label) {}
+
+    const Node* child(absl::string_view label) const {
+      // Nodes often have a single child, i.e. for the domains shared by all the names of a tenant,
+      // whose label is cheaper to compare than to hash.
+      if (children_.size() == 1) {
+        const Node* only_child = children_.begin()->second;
+        return LabelEqual()(only_child->label_, label) ? only_child : nullptr;
+      }
+      const auto it = children_.find(label);
+      return it != children_.end() ? it->second : nullptr;
+    }
+
+    const std::string label_;
+    std::unordered_map<absl::string_view, Node*, LabelHash, LabelEqual> children_;
+    std::unique_ptr<T> exact_;
+    std::unique_ptr<T> wildcard_;
+  };
+
+  // Returns the position of the dot preceding the label which ends at end, or npos if the label
+  // is the first one of the name.
+  static size_t previousDot(absl::string_view name, size_t end) {
+    return end == 0 ? absl::string_view::npos : name.rfind('.', end - 1);
+  }
+
+  // The first node is the root, which holds no label.
+  std::deque<Node> nodes_;
+};
+
+} // namespace Network
+} // namespace Envoy
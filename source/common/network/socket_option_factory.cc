@@ -1,6 +1,7 @@
 #include "common/network/socket_option_factory.h"
 
 #include "common/network/addr_family_aware_socket_option_impl.h"
+#include "common/network/quic_connection_id_routing_socket_option_impl.h"
 #include "common/network/socket_option_impl.h"
 
 namespace Envoy {
@@ -85,5 +86,26 @@ SocketOptionFactory::buildTcpFastOpenOptions(uint32_t queue_length) {
   return options;
 }
 
+std::unique_ptr<Socket::Options> SocketOptionFactory::buildReusePortOptions() {
+  std::unique_ptr<Socket::Options> options = absl::make_unique<Socket::Options>();
+  options->push_back(std::make_shared<Network::SocketOptionImpl>(
+      envoy::api::v2::core::SocketOption::STATE_PREBIND, ENVOY_SOCKET_SO_REUSEPORT, 1));
+  return options;
+}
+
+std::unique_ptr<Socket::Options> SocketOptionFactory::buildIncomingCpuOptions(uint32_t cpu) {
+  std::unique_ptr<Socket::Options> options = absl::make_unique<Socket::Options>();
+  options->push_back(std::make_shared<Network::SocketOptionImpl>(
+      envoy::api::v2::core::SocketOption::STATE_PREBIND, ENVOY_SOCKET_SO_INCOMING_CPU, cpu));
+  return options;
+}
+
+std::unique_ptr<Socket::Options>
+SocketOptionFactory::buildQuicConnectionIdRoutingOptions(uint32_t sockets) {
+  std::unique_ptr<Socket::Options> options = absl::make_unique<Socket::Options>();
+  options->push_back(std::make_shared<Network::QuicConnectionIdRoutingSocketOptionImpl>(sockets));
+  return options;
+}
+
 } // namespace Network
 } // namespace Envoy
@@ -0,0 +1,190 @@
+#include "common/network/udp_listener_impl.h"
+
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "common/common/assert.h"
+#include "common/network/address_impl.h"
+
+namespace Envoy {
+namespace Network {
+
+UdpListenerImpl::UdpListenerImpl(Event::DispatcherImpl& dispatcher, Socket& socket,
+                                 UdpListenerCallbacks& cb)
+    : socket_(socket), cb_(cb),
+      v6only_(socket.localAddress()->ip() != nullptr &&
+              socket.localAddress()->ip()->version() == Address::IpVersion::v6),
+      receive_buffer_(new uint8_t[BatchSize * MaxDatagramSize]) {
+  file_event_ = dispatcher.createFileEvent(
+      socket.fd(), [this](uint32_t) -> void { onSocketEvent(); }, Event::FileTriggerType::Level,
+      Event::FileReadyType::Read);
+  flush_timer_ = dispatcher.createTimer([this]() -> void { flushSends(); });
+}
+
+void UdpListenerImpl::onSocketEvent() {
+  receiving_ = true;
+  for (uint32_t i = 0; i < MaxBatchesPerWakeup; i++) {
+    if (receiveBatch() < BatchSize) {
+      break;
+    }
+  }
+  receiving_ = false;
+
+  // Replies sent by the filters while handling the batch go out together.
+  flushSends();
+}
+
+uint32_t UdpListenerImpl::receiveBatch() {
+  sockaddr_storage peer_addresses[BatchSize];
+  iovec iovs[BatchSize];
+  for (uint32_t i = 0; i < BatchSize; i++) {
+    iovs[i].iov_base = receive_buffer_.get() + i * MaxDatagramSize;
+    iovs[i].iov_len = MaxDatagramSize;
+  }
+
+#if defined(__linux__)
+  mmsghdr messages[BatchSize];
+  memset(messages, 0, sizeof(messages));
+  for (uint32_t i = 0; i < BatchSize; i++) {
+    messages[i].msg_hdr.msg_name = &peer_addresses[i];
+    messages[i].msg_hdr.msg_namelen = sizeof(peer_addresses[i]);
+    messages[i].msg_hdr.msg_iov = &iovs[i];
+    messages[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  const int rc = ::recvmmsg(socket_.fd(), messages, BatchSize, MSG_DONTWAIT, nullptr);
+  if (rc < 0) {
+    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+      cb_.onReceiveError(errno);
+    }
+    return 0;
+  }
+
+  for (int i = 0; i < rc; i++) {
+    if (messages[i].msg_hdr.msg_flags & MSG_TRUNC) {
+      cb_.onReceiveError(EMSGSIZE);
+      continue;
+    }
+    onDatagram(static_cast<const uint8_t*>(iovs[i].iov_base), messages[i].msg_len,
+               peer_addresses[i], messages[i].msg_hdr.msg_namelen);
+  }
+  return rc;
+#else
+  // Every datagram is read into the first slot since it is handled before the next one is read.
+  for (uint32_t i = 0; i < BatchSize; i++) {
+    msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_name = &peer_addresses[0];
+    message.msg_namelen = sizeof(peer_addresses[0]);
+    message.msg_iov = &iovs[0];
+    message.msg_iovlen = 1;
+
+    const ssize_t rc = ::recvmsg(socket_.fd(), &message, MSG_DONTWAIT);
+    if (rc < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        cb_.onReceiveError(errno);
+      }
+      return i;
+    }
+    if (message.msg_flags & MSG_TRUNC) {
+      cb_.onReceiveError(EMSGSIZE);
+      continue;
+    }
+    onDatagram(static_cast<const uint8_t*>(iovs[0].iov_base), rc, peer_addresses[0],
+               message.msg_namelen);
+  }
+  return BatchSize;
+#endif
+}
+
+void UdpListenerImpl::onDatagram(const uint8_t* data, uint64_t length,
+                                 const sockaddr_storage& peer_address, socklen_t peer_address_len) {
+  UdpRecvData recv_data{socket_.localAddress(),
+                        Address::addressFromSockAddr(peer_address, peer_address_len, v6only_),
+                        std::make_unique<Buffer::OwnedImpl>(data, length)};
+  cb_.onData(recv_data);
+}
+
+void UdpListenerImpl::send(const UdpSendData& data) {
+  ASSERT(data.peer_address_.sockAddrLen() <= sizeof(sockaddr_storage));
+  pending_sends_.emplace_back();
+  PendingSend& pending = pending_sends_.back();
+  memcpy(&pending.peer_address_, data.peer_address_.sockAddr(), data.peer_address_.sockAddrLen());
+  pending.peer_address_len_ = data.peer_address_.sockAddrLen();
+  pending.buffer_.move(data.buffer_);
+
+  if (pending_sends_.size() >= BatchSize) {
+    flushSends();
+  } else if (!receiving_) {
+    flush_timer_->enableTimer(std::chrono::milliseconds(0));
+  }
+}
+
+void UdpListenerImpl::flushSends() {
+  flush_timer_->disableTimer();
+  while (!pending_sends_.empty()) {
+    const uint32_t done = sendBatch();
+    pending_sends_.erase(pending_sends_.begin(), pending_sends_.begin() + done);
+  }
+}
+
+uint32_t UdpListenerImpl::sendBatch() {
+  const uint32_t count = std::min<size_t>(pending_sends_.size(), BatchSize);
+  iovec iovs[BatchSize];
+  for (uint32_t i = 0; i < count; i++) {
+    Buffer::OwnedImpl& buffer = pending_sends_[i].buffer_;
+    iovs[i].iov_len = buffer.length();
+    iovs[i].iov_base = buffer.length() > 0 ? buffer.linearize(buffer.length()) : nullptr;
+  }
+
+#if defined(__linux__)
+  mmsghdr messages[BatchSize];
+  memset(messages, 0, sizeof(messages));
+  for (uint32_t i = 0; i < count; i++) {
+    messages[i].msg_hdr.msg_name = &pending_sends_[i].peer_address_;
+    messages[i].msg_hdr.msg_namelen = pending_sends_[i].peer_address_len_;
+    messages[i].msg_hdr.msg_iov = &iovs[i];
+    messages[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  const int rc = ::sendmmsg(socket_.fd(), messages, count, MSG_DONTWAIT);
+  if (rc > 0) {
+    return rc;
+  }
+  const int error = rc < 0 ? errno : EAGAIN;
+#else
+  uint32_t sent = 0;
+  for (; sent < count; sent++) {
+    msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_name = &pending_sends_[sent].peer_address_;
+    message.msg_namelen = pending_sends_[sent].peer_address_len_;
+    message.msg_iov = &iovs[sent];
+    message.msg_iovlen = 1;
+    if (::sendmsg(socket_.fd(), &message, MSG_DONTWAIT) < 0) {
+      break;
+    }
+  }
+  if (sent > 0) {
+    return sent;
+  }
+  const int error = errno;
+#endif
+
+  if (error == EINTR) {
+    return 0;
+  }
+  // There is no point in retrying the rest of the queue while the socket buffer is full. Any other
+  // error is specific to the first datagram, which is dropped.
+  const uint32_t dropped = (error == EAGAIN || error == EWOULDBLOCK) ? pending_sends_.size() : 1;
+  for (uint32_t i = 0; i < dropped; i++) {
+    cb_.onSendError(error);
+  }
+  return dropped;
+}
+
+} // namespace Network
+} // namespace Envoy
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <sys/socket.h>
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+
+#include "envoy/event/file_event.h"
+#include "envoy/event/timer.h"
+#include "envoy/network/listener.h"
+
+#include "common/buffer/buffer_impl.h"
+#include "common/event/dispatcher_impl.h"
+
+namespace Envoy {
+namespace Network {
+
+/**
+ * Implementation of Network::UdpListener that reads datagrams from the listen socket in batches
+ * with recvmmsg() and writes the datagrams queued by send() in batches with sendmmsg(). Platforms
+ * without these calls read and write one datagram per system call.
+ */
+class UdpListenerImpl : public UdpListener {
+public:
+  UdpListenerImpl(Event::DispatcherImpl& dispatcher, Socket& socket, UdpListenerCallbacks& cb);
+
+  // Network::UdpListener
+  const Address::InstanceConstSharedPtr& localAddress() const override {
+    return socket_.localAddress();
+  }
+  void send(const UdpSendData& data) override;
+
+  // The number of datagrams read or written with a single system call.
+  static constexpr uint32_t BatchSize = 16;
+  // The number of batches read each time the socket becomes readable. The socket event is level
+  // triggered, so datagrams left in the socket are read on the next event loop iteration.
+  static constexpr uint32_t MaxBatchesPerWakeup = 4;
+  // Datagrams with a larger payload, which would need IP fragmentation even with jumbo frames, are
+  // dropped.
+  static constexpr uint32_t MaxDatagramSize = 9000;
+
+private:
+  struct PendingSend {
+    sockaddr_storage peer_address_;
+    socklen_t peer_address_len_;
+    Buffer::OwnedImpl buffer_;
+  };
+
+  void onSocketEvent();
+  /**
+   * Read a batch of datagrams from the socket and pass them to the callbacks.
+   * @return uint32_t the number of datagrams read, including truncated ones.
+   */
+  uint32_t receiveBatch();
+  void onDatagram(const uint8_t* data, uint64_t length, const sockaddr_storage& peer_address,
+                  socklen_t peer_address_len);
+  void flushSends();
+  /**
+   * Write a batch of the pending datagrams to the socket.
+   * @return uint32_t the number of pending datagrams that were written or dropped.
+   */
+  uint32_t sendBatch();
+
+  Socket& socket_;
+  UdpListenerCallbacks& cb_;
+  const bool v6only_;
+  Event::FileEventPtr file_event_;
+  // Flushes datagrams queued outside of a socket wakeup on the next event loop iteration.
+  Event::TimerPtr flush_timer_;
+  std::unique_ptr<uint8_t[]> receive_buffer_;
+  // Datagrams queued by send(). Those still queued when the listener is destroyed are dropped.
+  std::deque<PendingSend> pending_sends_;
+  bool receiving_{};
+};
+
+} // namespace Network
+} // namespace Envoy
@@ -41,6 +41,38 @@ MissingFieldException::MissingFieldException(const std::string& field_name,
     : EnvoyException(
           fmt::format("Field '{}' is missing in: {}", field_name, message.DebugString())) {}
 
+HashingOutputStream::HashingOutputStream() : state_(XXH64_createState()) {
+  XXH64_reset(state_, 0);
+}
+
+HashingOutputStream::~HashingOutputStream() { XXH64_freeState(state_); }
+
+uint64_t HashingOutputStream::digest() {
+  flush();
+  return XXH64_digest(state_);
+}
+
+bool HashingOutputStream::Next(void** data, int* size) {
+  flush();
+  *data = buffer_.data();
+  *size = buffer_.size();
+  pending_ = buffer_.size();
+  return true;
+}
+
+void HashingOutputStream::BackUp(int count) {
+  ASSERT(count >= 0 && count <= pending_);
+  pending_ -= count;
+}
+
+void HashingOutputStream::flush() {
+  if (pending_ > 0) {
+    XXH64_update(state_, buffer_.data(), pending_);
+    byte_count_ += pending_;
+    pending_ = 0;
+  }
+}
+
 ProtoValidationException::ProtoValidationException(const std::string& validation_error,
                                                    const Protobuf::Message& message)
     : EnvoyException(fmt::format("Proto constraint validation failed ({}): {}", validation_error,
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <numeric>
 
 #include "envoy/common/exception.h"
@@ -99,6 +100,37 @@ public:
   MissingFieldException(const std::string& field_name, const Protobuf::Message& message);
 };
 
+/**
+ * An output stream that digests what is written to it with xxHash64 rather than storing it, so
+ * that messages can be hashed without materializing their serialization. The digest is the same
+ * as HashUtil::xxHash64() of the serialized bytes.
+ */
+class HashingOutputStream : public Protobuf::io::ZeroCopyOutputStream {
+public:
+  HashingOutputStream();
+  ~HashingOutputStream();
+
+  /**
+   * @return uint64_t the digest of the bytes written so far. Any CodedOutputStream writing to this
+   *         stream must have been destroyed, so that it returned the bytes it did not use.
+   */
+  uint64_t digest();
+
+  // Protobuf::io::ZeroCopyOutputStream
+  bool Next(void** data, int* size) override;
+  void BackUp(int count) override;
+  Protobuf::int64 ByteCount() const override { return byte_count_ + pending_; }
+
+private:
+  void flush();
+
+  XXH64_state_t* const state_;
+  std::array<char, 4096> buffer_;
+  // Bytes of buffer_ handed out by Next() that are not digested yet.
+  int pending_{};
+  Protobuf::int64 byte_count_{};
+};
+
 class RepeatedPtrUtil {
 public:
   static std::string join(const Protobuf::RepeatedPtrField<ProtobufTypes::String>& source,
@@ -123,18 +155,17 @@ public:
   static std::size_t hash(const Protobuf::RepeatedPtrField<ProtoType>& source) {
     // Use Protobuf::io::CodedOutputStream to force deterministic serialization, so that the same
     // message doesn't hash to different values.
-    ProtobufTypes::String text;
+    HashingOutputStream hash_stream;
     {
-      // For memory safety, the StringOutputStream needs to be destroyed before
-      // we read the string.
-      Protobuf::io::StringOutputStream string_stream(&text);
-      Protobuf::io::CodedOutputStream coded_stream(&string_stream);
+      // The CodedOutputStream needs to be destroyed before the digest is read, so that it returns
+      // the bytes it did not use.
+      Protobuf::io::CodedOutputStream coded_stream(&hash_stream);
       coded_stream.SetSerializationDeterministic(true);
       for (const auto& message : source) {
         message.SerializeToCodedStream(&coded_stream);
       }
     }
-    return HashUtil::xxHash64(text);
+    return hash_stream.digest();
   }
 };
 
@@ -157,17 +188,16 @@ public:
 
   static std::size_t hash(const Protobuf::Message& message) {
     // Use Protobuf::io::CodedOutputStream to force deterministic serialization, so that the same
-    // message doesn't hash to different values.
-    ProtobufTypes::String text;
+    // message doesn't hash to different values. The serialization is digested as it is produced.
+    HashingOutputStream hash_stream;
     {
-      // For memory safety, the StringOutputStream needs to be destroyed before
-      // we read the string.
-      Protobuf::io::StringOutputStream string_stream(&text);
-      Protobuf::io::CodedOutputStream coded_stream(&string_stream);
+      // The CodedOutputStream needs to be destroyed before the digest is read, so that it returns
+      // the bytes it did not use.
+      Protobuf::io::CodedOutputStream coded_stream(&hash_stream);
       coded_stream.SetSerializationDeterministic(true);
       message.SerializeToCodedStream(&coded_stream);
     }
-    return HashUtil::xxHash64(text);
+    return hash_stream.digest();
   }
 
   static ProtoUnknownFieldsMode proto_unknown_fields;
@@ -307,6 +337,18 @@ public:
   const ProtobufWkt::Value& value() const { return value_; }
   std::size_t hash() const { return hash_; }
 
+  /**
+   * Hashes a name and this value, e.g. a metadata key and its value, combined with the hash of the
+   * preceding pairs of a list. Lists of pairs sorted the same way, such as metadata match criteria
+   * and the metadata of subsets, then have the same hash when they are equal.
+   * @param name supplies the name of the value.
+   * @param seed supplies the hash of the preceding pairs, or 0 for the first pair.
+   * @return uint64_t the combined hash.
+   */
+  uint64_t hashWithName(const std::string& name, uint64_t seed) const {
+    return HashUtil::xxHash64(name, seed ^ hash_);
+  }
+
   bool operator==(const HashedValue& rhs) const {
     return hash_ == rhs.hash_ && ValueUtil::equal(value_, rhs.value_);
   }
@@ -46,12 +46,14 @@ public:
   ~GrpcClientImpl();
 
   static void createRequest(envoy::service::ratelimit::v2::RateLimitRequest& request,
-                            const std::string& domain, const std::vector<Descriptor>& descriptors);
+                            const std::string& domain, const std::vector<Descriptor>& descriptors,
+                            uint32_t hits_addend);
 
   // RateLimit::Client
   void cancel() override;
   void limit(RequestCallbacks& callbacks, const std::string& domain,
-             const std::vector<Descriptor>& descriptors, Tracing::Span& parent_span) override;
+             const std::vector<Descriptor>& descriptors, Tracing::Span& parent_span,
+             uint32_t hits_addend) override;
 
   // Grpc::AsyncRequestCallbacks
   void onCreateInitialMetadata(Http::HeaderMap&) override {}
@@ -86,7 +88,7 @@ public:
   // RateLimit::Client
   void cancel() override {}
   void limit(RequestCallbacks& callbacks, const std::string&, const std::vector<Descriptor>&,
-             Tracing::Span&) override {
+             Tracing::Span&, uint32_t) override {
     callbacks.complete(LimitStatus::OK, nullptr);
   }
 };
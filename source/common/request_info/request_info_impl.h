@@ -2,10 +2,12 @@
 
 #include <chrono>
 #include <cstdint>
+#include <memory>
 
 #include "envoy/request_info/request_info.h"
 
 #include "common/common/assert.h"
+#include "common/http/request_attributes_impl.h"
 #include "common/request_info/filter_state_impl.h"
 
 namespace Envoy {
@@ -173,15 +175,27 @@ struct RequestInfoImpl : public RequestInfo {
 
   const Router::RouteEntry* routeEntry() const override { return route_entry_; }
 
-  const envoy::api::v2::core::Metadata& dynamicMetadata() const override { return metadata_; };
+  const envoy::api::v2::core::Metadata& dynamicMetadata() const override {
+    return metadata_ != nullptr ? *metadata_ : envoy::api::v2::core::Metadata::default_instance();
+  };
 
   void setDynamicMetadata(const std::string& name, const ProtobufWkt::Struct& value) override {
-    (*metadata_.mutable_filter_metadata())[name].MergeFrom(value);
+    if (metadata_ == nullptr) {
+      metadata_ = std::make_unique<envoy::api::v2::core::Metadata>();
+    }
+    (*metadata_->mutable_filter_metadata())[name].MergeFrom(value);
   };
 
   FilterState& perRequestState() override { return per_request_state_; }
   const FilterState& perRequestState() const override { return per_request_state_; }
 
+  Http::RequestAttributes& requestAttributes() override {
+    if (request_attributes_ == nullptr) {
+      request_attributes_ = std::make_unique<Http::RequestAttributesImpl>();
+    }
+    return *request_attributes_;
+  }
+
   void setRequestedServerName(absl::string_view requested_server_name) override {
     requested_server_name_ = std::string(requested_server_name);
   }
@@ -206,10 +220,15 @@ struct RequestInfoImpl : public RequestInfo {
   Upstream::HostDescriptionConstSharedPtr upstream_host_{};
   bool hc_request_{};
   const Router::RouteEntry* route_entry_{};
-  envoy::api::v2::core::Metadata metadata_{};
   FilterStateImpl per_request_state_{};
 
 private:
+  // Created when first written or used. Most requests, in particular health checks and local
+  // replies, never set dynamic metadata nor parse request attributes, and an empty metadata proto
+  // allocates its map on construction.
+  std::unique_ptr<envoy::api::v2::core::Metadata> metadata_;
+  std::unique_ptr<Http::RequestAttributesImpl> request_attributes_;
+
   uint64_t bytes_received_{};
   uint64_t bytes_sent_{};
   Network::Address::InstanceConstSharedPtr upstream_local_address_;
@@ -14,6 +14,7 @@
 #include "envoy/upstream/cluster_manager.h"
 #include "envoy/upstream/upstream.h"
 
+#include "common/buffer/buffer_impl.h"
 #include "common/common/assert.h"
 #include "common/common/empty_string.h"
 #include "common/common/fmt.h"
@@ -28,6 +29,7 @@
 #include "common/http/websocket/ws_handler_impl.h"
 #include "common/protobuf/utility.h"
 #include "common/router/retry_state_impl.h"
+#include "common/runtime/key_registry.h"
 
 #include "extensions/filters/http/well_known_names.h"
 
@@ -50,12 +52,25 @@ RetryPolicyImpl::RetryPolicyImpl(const envoy::api::v2::route::RouteAction& confi
   retry_on_ |= RetryStateImpl::parseRetryGrpcOn(config.retry_policy().retry_on());
 }
 
+HedgePolicyImpl::HedgePolicyImpl(const envoy::api::v2::route::RouteAction& config) {
+  if (!config.has_hedge_policy()) {
+    return;
+  }
+
+  delay_ = std::chrono::milliseconds(PROTOBUF_GET_MS_REQUIRED(config.hedge_policy(), delay));
+  budget_percent_ =
+      PROTOBUF_PERCENT_TO_ROUNDED_INTEGER_OR_DEFAULT(config.hedge_policy(), budget, 100, 10);
+}
+
 CorsPolicyImpl::CorsPolicyImpl(const envoy::api::v2::route::CorsPolicy& config) {
   for (const auto& origin : config.allow_origin()) {
     allow_origin_.push_back(origin);
   }
   for (const auto& regex : config.allow_origin_regex()) {
-    allow_origin_regex_.push_back(RegexUtil::parseRegex(regex));
+    allow_origin_regex_.push_back(Regex::Utility::parseStdRegexAsCompiledMatcher(regex));
+  }
+  for (const auto& regex : config.allow_origin_safe_regex()) {
+    allow_origin_regex_.push_back(Regex::Utility::parseRegex(regex));
   }
   allow_methods_ = config.allow_methods();
   allow_headers_ = config.allow_headers();
@@ -92,7 +107,7 @@ public:
       : HashMethodImplBase(terminal), header_name_(header_name) {}
 
   absl::optional<uint64_t> evaluate(const Network::Address::Instance*,
-                                    const Http::HeaderMap& headers,
+                                    const Http::HeaderMap& headers, Http::RequestAttributes&,
                                     const HashPolicy::AddCookieCallback) const override {
     absl::optional<uint64_t> hash;
 
@@ -115,12 +130,12 @@ public:
 
   absl::optional<uint64_t> evaluate(const Network::Address::Instance*,
                                     const Http::HeaderMap& headers,
+                                    Http::RequestAttributes& request_attributes,
                                     const HashPolicy::AddCookieCallback add_cookie) const override {
     absl::optional<uint64_t> hash;
-    std::string value = Http::Utility::parseCookieValue(headers, key_);
+    const std::string& value = request_attributes.cookieValue(headers, key_);
     if (value.empty() && ttl_.has_value()) {
-      value = add_cookie(key_, path_, ttl_.value());
-      hash = HashUtil::xxHash64(value);
+      hash = HashUtil::xxHash64(add_cookie(key_, path_, ttl_.value()));
 
     } else if (!value.empty()) {
       hash = HashUtil::xxHash64(value);
@@ -139,7 +154,7 @@ public:
   IpHashMethod(bool terminal) : HashMethodImplBase(terminal) {}
 
   absl::optional<uint64_t> evaluate(const Network::Address::Instance* downstream_addr,
-                                    const Http::HeaderMap&,
+                                    const Http::HeaderMap&, Http::RequestAttributes&,
                                     const HashPolicy::AddCookieCallback) const override {
     if (downstream_addr == nullptr) {
       return absl::nullopt;
@@ -192,11 +207,12 @@ HashPolicyImpl::HashPolicyImpl(
 absl::optional<uint64_t>
 HashPolicyImpl::generateHash(const Network::Address::Instance* downstream_addr,
                              const Http::HeaderMap& headers,
+                             Http::RequestAttributes& request_attributes,
                              const AddCookieCallback add_cookie) const {
   absl::optional<uint64_t> hash;
   for (const HashMethodPtr& hash_impl : hash_impls_) {
     const absl::optional<uint64_t> new_hash =
-        hash_impl->evaluate(downstream_addr, headers, add_cookie);
+        hash_impl->evaluate(downstream_addr, headers, request_attributes, add_cookie);
     if (new_hash) {
       // Rotating the old value prevents duplicate hash rules from cancelling each other out
       // and preserves all of the entropy
@@ -273,6 +289,10 @@ RouteEntryImplBase::RouteEntryImplBase(const VirtualHostImpl& vhost,
                    : nullptr;
       }()),
       cluster_name_(route.route().cluster()), cluster_header_name_(route.route().cluster_header()),
+      cluster_handle_(cluster_name_.empty()
+                          ? absl::nullopt
+                          : absl::make_optional(
+                                Upstream::ClusterNameRegistry::registerName(cluster_name_))),
       cluster_not_found_response_code_(ConfigUtility::parseClusterNotFoundResponseCode(
           route.route().cluster_not_found_response_code())),
       timeout_(PROTOBUF_GET_MS_OR_DEFAULT(route.route(), timeout, DEFAULT_ROUTE_TIMEOUT_MS)),
@@ -284,6 +304,7 @@ RouteEntryImplBase::RouteEntryImplBase(const VirtualHostImpl& vhost,
       https_redirect_(route.redirect().https_redirect()),
       prefix_rewrite_redirect_(route.redirect().prefix_rewrite()),
       strip_query_(route.redirect().strip_query()), retry_policy_(route.route()),
+      hedge_policy_(route.route()),
       rate_limit_policy_(route.route().rate_limits()), shadow_policy_(route.route()),
       priority_(ConfigUtility::parsePriority(route.route().priority())),
       total_cluster_weight_(
@@ -297,7 +318,8 @@ RouteEntryImplBase::RouteEntryImplBase(const VirtualHostImpl& vhost,
                                                        route.response_headers_to_remove())),
       opaque_config_(parseOpaqueConfig(route)), decorator_(parseDecorator(route)),
       direct_response_code_(ConfigUtility::parseDirectResponseCode(route)),
-      direct_response_body_(ConfigUtility::parseDirectResponseBody(route)),
+      direct_response_body_(
+          std::make_shared<const std::string>(ConfigUtility::parseDirectResponseBody(route))),
       per_filter_configs_(route.per_filter_config(), factory_context) {
   if (route.route().has_metadata_match()) {
     const auto filter_it = route.route().metadata_match().filter_metadata().find(
@@ -423,10 +445,8 @@ absl::optional<RouteEntryImplBase::RuntimeData>
 RouteEntryImplBase::loadRuntimeData(const envoy::api::v2::route::RouteMatch& route_match) {
   absl::optional<RuntimeData> runtime;
   if (route_match.has_runtime()) {
-    RuntimeData data;
-    data.key_ = route_match.runtime().runtime_key();
-    data.default_ = route_match.runtime().default_value();
-    runtime = data;
+    runtime = RuntimeData{Runtime::KeyRegistry::registerKey(route_match.runtime().runtime_key()),
+                          route_match.runtime().default_value()};
   }
 
   return runtime;
@@ -448,6 +468,19 @@ void RouteEntryImplBase::finalizePathHeader(Http::HeaderMap& headers,
   headers.Path()->value(path.replace(0, matched_path.size(), rewrite));
 }
 
+void RouteEntryImplBase::addResponseBody(Buffer::Instance& buffer) const {
+  if (direct_response_body_->empty()) {
+    return;
+  }
+  // The fragment keeps the body alive, as the buffer may outlive the route configuration.
+  std::shared_ptr<const std::string> body = direct_response_body_;
+  buffer.addBufferFragment(*new Buffer::BufferFragmentImpl(
+      body->data(), body->size(),
+      [body](const void*, size_t, const Buffer::BufferFragmentImpl* fragment) -> void {
+        delete fragment;
+      }));
+}
+
 std::string RouteEntryImplBase::newPath(const Http::HeaderMap& headers) const {
   ASSERT(isDirectResponse());
 
@@ -606,7 +639,9 @@ RouteEntryImplBase::WeightedClusterEntry::WeightedClusterEntry(
     const RouteEntryImplBase* parent, const std::string runtime_key,
     Server::Configuration::FactoryContext& factory_context,
     const envoy::api::v2::route::WeightedCluster_ClusterWeight& cluster)
-    : DynamicRouteEntry(parent, cluster.name()), runtime_key_(runtime_key),
+    : DynamicRouteEntry(parent, cluster.name()),
+      cluster_handle_(Upstream::ClusterNameRegistry::registerName(cluster.name())),
+      runtime_key_(Runtime::KeyRegistry::registerKey(runtime_key)),
       loader_(factory_context.runtime()),
       cluster_weight_(PROTOBUF_GET_WRAPPED_REQUIRED(cluster, weight)),
       request_headers_parser_(HeaderParser::configure(cluster.request_headers_to_add())),
@@ -694,8 +729,11 @@ RegexRouteEntryImpl::RegexRouteEntryImpl(const VirtualHostImpl& vhost,
                                          const envoy::api::v2::route::Route& route,
                                          Server::Configuration::FactoryContext& factory_context)
     : RouteEntryImplBase(vhost, route, factory_context),
-      regex_(RegexUtil::parseRegex(route.match().regex().c_str())),
-      regex_str_(route.match().regex()) {}
+      regex_(route.match().has_safe_regex()
+                 ? Regex::Utility::parseRegex(route.match().safe_regex())
+                 : Regex::Utility::parseStdRegexAsCompiledMatcher(route.match().regex())),
+      regex_str_(route.match().has_safe_regex() ? route.match().safe_regex().regex()
+                                                : route.match().regex()) {}
 
 void RegexRouteEntryImpl::rewritePathHeader(Http::HeaderMap& headers,
                                             bool insert_envoy_original_path) const {
@@ -703,7 +741,7 @@ void RegexRouteEntryImpl::rewritePathHeader(Http::HeaderMap& headers,
   const char* query_string_start = Http::Utility::findQueryStringStart(path);
   // TODO(yuval-k): This ASSERT can happen if the path was changed by a filter without clearing the
   // route cache. We should consider if ASSERT-ing is the desired behavior in this case.
-  ASSERT(std::regex_match(path.c_str(), query_string_start, regex_));
+  ASSERT(regex_->match(absl::string_view(path.c_str(), query_string_start - path.c_str())));
   std::string matched_path(path.c_str(), query_string_start);
 
   finalizePathHeader(headers, matched_path, insert_envoy_original_path);
@@ -714,19 +752,40 @@ RouteConstSharedPtr RegexRouteEntryImpl::matches(const Http::HeaderMap& headers,
   if (RouteEntryImplBase::matchRoute(headers, random_value)) {
     const Http::HeaderString& path = headers.Path()->value();
     const char* query_string_start = Http::Utility::findQueryStringStart(path);
-    if (std::regex_match(path.c_str(), query_string_start, regex_)) {
+    if (regex_->match(absl::string_view(path.c_str(), query_string_start - path.c_str()))) {
       return clusterEntry(headers, random_value);
     }
   }
   return nullptr;
 }
 
+GlobalRouteConfigImpl::GlobalRouteConfigImpl(const envoy::api::v2::RouteConfiguration& config)
+    : name_(config.name()),
+      request_headers_parser_(HeaderParser::configure(config.request_headers_to_add())),
+      response_headers_parser_(HeaderParser::configure(config.response_headers_to_add(),
+                                                       config.response_headers_to_remove())) {
+  for (const std::string& header : config.internal_only_headers()) {
+    internal_only_headers_.push_back(Http::LowerCaseString(header));
+  }
+
+  // Only hash the fields held here, rather than the whole route configuration with its virtual
+  // hosts, which may be large.
+  envoy::api::v2::RouteConfiguration global_config;
+  global_config.set_name(config.name());
+  global_config.mutable_internal_only_headers()->CopyFrom(config.internal_only_headers());
+  global_config.mutable_request_headers_to_add()->CopyFrom(config.request_headers_to_add());
+  global_config.mutable_response_headers_to_add()->CopyFrom(config.response_headers_to_add());
+  global_config.mutable_response_headers_to_remove()->CopyFrom(
+      config.response_headers_to_remove());
+  hash_ = MessageUtil::hash(global_config);
+}
+
 VirtualHostImpl::VirtualHostImpl(const envoy::api::v2::route::VirtualHost& virtual_host,
-                                 const ConfigImpl& global_route_config,
+                                 GlobalRouteConfigImplConstSharedPtr global_route_config,
                                  Server::Configuration::FactoryContext& factory_context,
                                  bool validate_clusters)
     : name_(virtual_host.name()), rate_limit_policy_(virtual_host.rate_limits()),
-      global_route_config_(global_route_config),
+      global_route_config_(std::move(global_route_config)),
       request_headers_parser_(HeaderParser::configure(virtual_host.request_headers_to_add())),
       response_headers_parser_(HeaderParser::configure(virtual_host.response_headers_to_add(),
                                                        virtual_host.response_headers_to_remove())),
@@ -751,29 +810,41 @@ VirtualHostImpl::VirtualHostImpl(const envoy::api::v2::route::VirtualHost& virtu
     const bool has_path =
         route.match().path_specifier_case() == envoy::api::v2::route::RouteMatch::kPath;
     const bool has_regex =
-        route.match().path_specifier_case() == envoy::api::v2::route::RouteMatch::kRegex;
+        route.match().path_specifier_case() == envoy::api::v2::route::RouteMatch::kRegex ||
+        route.match().path_specifier_case() == envoy::api::v2::route::RouteMatch::kSafeRegex;
+    const bool case_sensitive =
+        PROTOBUF_GET_WRAPPED_OR_DEFAULT(route.match(), case_sensitive, true);
+    const uint32_t ordinal = routes_.size();
     if (has_prefix) {
       routes_.emplace_back(new PrefixRouteEntryImpl(*this, route, factory_context));
+      route_index_.addPrefix(route.match().prefix(), case_sensitive, ordinal);
     } else if (has_path) {
       routes_.emplace_back(new PathRouteEntryImpl(*this, route, factory_context));
+      route_index_.addPath(route.match().path(), case_sensitive, ordinal);
     } else {
       ASSERT(has_regex);
       routes_.emplace_back(new RegexRouteEntryImpl(*this, route, factory_context));
+      route_index_.addUnindexed(ordinal);
     }
+  }
 
-    if (validate_clusters) {
-      routes_.back()->validateClusters(factory_context.clusterManager());
-      if (!routes_.back()->shadowPolicy().cluster().empty()) {
-        if (!factory_context.clusterManager().get(routes_.back()->shadowPolicy().cluster())) {
-          throw EnvoyException(fmt::format("route: unknown shadow cluster '{}'",
-                                           routes_.back()->shadowPolicy().cluster()));
-        }
-      }
-    }
+  route_index_.finalize();
+
+  if (validate_clusters) {
+    validateClusters(factory_context.clusterManager());
   }
 
+  bool all_google_re2 = virtual_host.virtual_clusters_size() > 1;
   for (const auto& virtual_cluster : virtual_host.virtual_clusters()) {
     virtual_clusters_.push_back(VirtualClusterEntry(virtual_cluster));
+    all_google_re2 &= virtual_cluster.safe_pattern().has_google_re2();
+  }
+  if (all_google_re2) {
+    virtual_cluster_patterns_.reset(new Regex::GoogleReMatcherSet());
+    for (const auto& virtual_cluster : virtual_host.virtual_clusters()) {
+      virtual_cluster_patterns_->add(virtual_cluster.safe_pattern());
+    }
+    virtual_cluster_patterns_->compile();
   }
 
   if (virtual_host.has_cors()) {
@@ -787,44 +858,60 @@ VirtualHostImpl::VirtualClusterEntry::VirtualClusterEntry(
     method_ = envoy::api::v2::core::RequestMethod_Name(virtual_cluster.method());
   }
 
-  const std::string pattern = virtual_cluster.pattern();
-  pattern_ = RegexUtil::parseRegex(pattern);
+  if (virtual_cluster.has_safe_pattern()) {
+    pattern_ = Regex::Utility::parseRegex(virtual_cluster.safe_pattern());
+  } else if (!virtual_cluster.pattern().empty()) {
+    pattern_ = Regex::Utility::parseStdRegexAsCompiledMatcher(virtual_cluster.pattern());
+  } else {
+    throw EnvoyException(fmt::format("virtual cluster '{}' must specify a pattern or safe_pattern",
+                                     virtual_cluster.name()));
+  }
   name_ = virtual_cluster.name();
 }
 
-const Config& VirtualHostImpl::routeConfig() const { return global_route_config_; }
+void VirtualHostImpl::validateClusters(Upstream::ClusterManager& cm) const {
+  for (const auto& route : routes_) {
+    route->validateClusters(cm);
+    if (!route->shadowPolicy().cluster().empty()) {
+      if (!cm.get(route->shadowPolicy().cluster())) {
+        throw EnvoyException(
+            fmt::format("route: unknown shadow cluster '{}'", route->shadowPolicy().cluster()));
+      }
+    }
+  }
+}
+
+const Config& VirtualHostImpl::routeConfig() const { return *global_route_config_; }
 
 const RouteSpecificFilterConfig* VirtualHostImpl::perFilterConfig(const std::string& name) const {
   return per_filter_configs_.get(name);
 }
 
-const VirtualHostImpl* RouteMatcher::findWildcardVirtualHost(const std::string& host) const {
-  // We do a longest wildcard suffix match against the host that's passed in.
-  // (e.g. foo-bar.baz.com should match *-bar.baz.com before matching *.baz.com)
-  // This is done by scanning the length => wildcards map looking for every
-  // wildcard whose size is < length.
-  for (const auto& iter : wildcard_virtual_host_suffixes_) {
-    const uint32_t wildcard_length = iter.first;
-    const auto& wildcard_map = iter.second;
-    // >= because *.foo.com shouldn't match .foo.com.
-    if (wildcard_length >= host.size()) {
-      continue;
-    }
-    const auto& match = wildcard_map.find(host.substr(host.size() - wildcard_length));
-    if (match != wildcard_map.end()) {
-      return match->second.get();
-    }
-  }
-  return nullptr;
-}
-
 RouteMatcher::RouteMatcher(const envoy::api::v2::RouteConfiguration& route_config,
-                           const ConfigImpl& global_route_config,
+                           GlobalRouteConfigImplConstSharedPtr global_route_config,
                            Server::Configuration::FactoryContext& factory_context,
-                           bool validate_clusters) {
+                           bool validate_clusters, const RouteMatcher* previous_route_matcher) {
   for (const auto& virtual_host_config : route_config.virtual_hosts()) {
-    VirtualHostSharedPtr virtual_host(new VirtualHostImpl(virtual_host_config, global_route_config,
-                                                          factory_context, validate_clusters));
+    const uint64_t hash = MessageUtil::hash(virtual_host_config);
+    VirtualHostSharedPtr virtual_host;
+    if (previous_route_matcher != nullptr) {
+      const auto previous = previous_route_matcher->virtual_hosts_by_hash_.find(hash);
+      if (previous != previous_route_matcher->virtual_hosts_by_hash_.end()) {
+        virtual_host = previous->second;
+        // The clusters may have changed since the virtual host was built.
+        if (validate_clusters) {
+          virtual_host->validateClusters(factory_context.clusterManager());
+        }
+      }
+    }
+    if (virtual_host == nullptr) {
+      virtual_host.reset(new VirtualHostImpl(virtual_host_config, global_route_config,
+                                             factory_context, validate_clusters));
+    }
+    virtual_hosts_by_hash_.emplace(hash, virtual_host);
+
+    const uint32_t ordinal = virtual_hosts_.size();
+    virtual_hosts_.push_back(virtual_host);
     for (const std::string& domain_name : virtual_host_config.domains()) {
       const std::string domain = Http::LowerCaseString(domain_name).get();
       if ("*" == domain) {
@@ -833,14 +920,10 @@ RouteMatcher::RouteMatcher(const envoy::api::v2::RouteConfiguration& route_confi
         }
         default_virtual_host_ = virtual_host;
       } else if (domain.size() > 0 && '*' == domain[0]) {
-        wildcard_virtual_host_suffixes_[domain.size() - 1].emplace(domain.substr(1), virtual_host);
-      } else {
-        if (virtual_hosts_.find(domain) != virtual_hosts_.end()) {
-          throw EnvoyException(fmt::format(
-              "Only unique values for domains are permitted. Duplicate entry of domain {}",
-              domain));
-        }
-        virtual_hosts_.emplace(domain, virtual_host);
+        domain_index_.addWildcardSuffix(domain.substr(1), ordinal);
+      } else if (!domain_index_.addExact(domain, ordinal)) {
+        throw EnvoyException(fmt::format(
+            "Only unique values for domains are permitted. Duplicate entry of domain {}", domain));
       }
     }
   }
@@ -856,9 +939,16 @@ RouteConstSharedPtr VirtualHostImpl::getRouteFromEntries(const Http::HeaderMap&
     return SSL_REDIRECT_ROUTE;
   }
 
-  // Check for a route that matches the request.
-  for (const RouteEntryImplBaseConstSharedPtr& route : routes_) {
-    RouteConstSharedPtr route_entry = route->matches(headers, random_value);
+  // Check for a route that matches the request. Only the routes whose path matcher may match the
+  // path are checked, in configuration order.
+  const Http::HeaderString& path = headers.Path()->value();
+  const char* query_string_start = Http::Utility::findQueryStringStart(path);
+  const size_t path_length =
+      query_string_start != nullptr ? query_string_start - path.c_str() : path.size();
+  RouteIndex::Candidates candidates =
+      route_index_.candidates(absl::string_view(path.c_str(), path.size()), path_length);
+  for (absl::optional<uint32_t> ordinal = candidates.next(); ordinal; ordinal = candidates.next()) {
+    RouteConstSharedPtr route_entry = routes_[ordinal.value()]->matches(headers, random_value);
     if (nullptr != route_entry) {
       return route_entry;
     }
@@ -869,22 +959,18 @@ RouteConstSharedPtr VirtualHostImpl::getRouteFromEntries(const Http::HeaderMap&
 
 const VirtualHostImpl* RouteMatcher::findVirtualHost(const Http::HeaderMap& headers) const {
   // Fast path the case where we only have a default virtual host.
-  if (virtual_hosts_.empty() && wildcard_virtual_host_suffixes_.empty() && default_virtual_host_) {
+  if (domain_index_.empty()) {
     return default_virtual_host_.get();
   }
 
   // TODO (@rshriram) Match Origin header in WebSocket
   // request with VHost, using wildcard match
-  const std::string host = Http::LowerCaseString(headers.Host()->value().c_str()).get();
-  const auto& iter = virtual_hosts_.find(host);
-  if (iter != virtual_hosts_.end()) {
-    return iter->second.get();
-  }
-  if (!wildcard_virtual_host_suffixes_.empty()) {
-    const VirtualHostImpl* vhost = findWildcardVirtualHost(host);
-    if (vhost != nullptr) {
-      return vhost;
-    }
+  // Exact domains take precedence over the longest matching wildcard suffix.
+  const Http::HeaderString& host = headers.Host()->value();
+  const absl::optional<uint32_t> ordinal =
+      domain_index_.find(absl::string_view(host.c_str(), host.size()));
+  if (ordinal) {
+    return virtual_hosts_[ordinal.value()].get();
   }
   return default_virtual_host_.get();
 }
@@ -906,12 +992,25 @@ const std::shared_ptr<const SslRedirectRoute> VirtualHostImpl::SSL_REDIRECT_ROUT
 
 const VirtualCluster*
 VirtualHostImpl::virtualClusterFromEntries(const Http::HeaderMap& headers) const {
-  for (const VirtualClusterEntry& entry : virtual_clusters_) {
-    bool method_matches =
-        !entry.method_ || headers.Method()->value().c_str() == entry.method_.value();
+  const absl::string_view path(headers.Path()->value().c_str(), headers.Path()->value().size());
+  if (virtual_cluster_patterns_ != nullptr) {
+    // Only the entries whose pattern matches need their method checked, in order.
+    std::vector<int> matches;
+    virtual_cluster_patterns_->match(path, matches);
+    for (int index : matches) {
+      const VirtualClusterEntry& entry = virtual_clusters_[index];
+      if (!entry.method_ || headers.Method()->value().c_str() == entry.method_.value()) {
+        return &entry;
+      }
+    }
+  } else {
+    for (const VirtualClusterEntry& entry : virtual_clusters_) {
+      bool method_matches =
+          !entry.method_ || headers.Method()->value().c_str() == entry.method_.value();
 
-    if (method_matches && std::regex_match(headers.Path()->value().c_str(), entry.pattern_)) {
-      return &entry;
+      if (method_matches && entry.pattern_->match(path)) {
+        return &entry;
+      }
     }
   }
 
@@ -924,19 +1023,20 @@ VirtualHostImpl::virtualClusterFromEntries(const Http::HeaderMap& headers) const
 
 ConfigImpl::ConfigImpl(const envoy::api::v2::RouteConfiguration& config,
                        Server::Configuration::FactoryContext& factory_context,
-                       bool validate_clusters_default)
-    : name_(config.name()) {
-  route_matcher_.reset(new RouteMatcher(
-      config, *this, factory_context,
-      PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, validate_clusters, validate_clusters_default)));
-
-  for (const std::string& header : config.internal_only_headers()) {
-    internal_only_headers_.push_back(Http::LowerCaseString(header));
+                       bool validate_clusters_default, const ConfigImpl* previous_config)
+    : global_route_config_(std::make_shared<const GlobalRouteConfigImpl>(config)) {
+  // Virtual hosts refer to the global configuration, so they can only be reused along with it.
+  const RouteMatcher* previous_route_matcher = nullptr;
+  if (previous_config != nullptr &&
+      previous_config->global_route_config_->hash() == global_route_config_->hash()) {
+    global_route_config_ = previous_config->global_route_config_;
+    previous_route_matcher = previous_config->route_matcher_.get();
   }
 
-  request_headers_parser_ = HeaderParser::configure(config.request_headers_to_add());
-  response_headers_parser_ = HeaderParser::configure(config.response_headers_to_add(),
-                                                     config.response_headers_to_remove());
+  route_matcher_.reset(new RouteMatcher(
+      config, global_route_config_, factory_context,
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, validate_clusters, validate_clusters_default),
+      previous_route_matcher));
 }
 
 PerFilterConfigs::PerFilterConfigs(
@@ -17,13 +17,18 @@
 #include "envoy/server/filter_config.h"
 #include "envoy/upstream/cluster_manager.h"
 
+#include "common/common/regex.h"
 #include "common/http/header_utility.h"
+#include "common/memory/accounting.h"
 #include "common/router/config_utility.h"
+#include "common/router/domain_index.h"
 #include "common/router/header_formatter.h"
 #include "common/router/header_parser.h"
 #include "common/router/metadatamatchcriteria_impl.h"
+#include "common/router/route_index.h"
 #include "common/router/router_ratelimit.h"
 #include "common/tcp_proxy/tcp_proxy.h"
+#include "common/upstream/cluster_name_registry.h"
 
 #include "absl/types/optional.h"
 
@@ -73,6 +78,7 @@ public:
   void rewritePathHeader(Http::HeaderMap&, bool) const override {}
   Http::Code responseCode() const override { return Http::Code::MovedPermanently; }
   const std::string& responseBody() const override { return EMPTY_STRING; }
+  void addResponseBody(Buffer::Instance&) const override {}
 };
 
 class SslRedirectRoute : public Route {
@@ -98,7 +104,9 @@ public:
 
   // Router::CorsPolicy
   const std::list<std::string>& allowOrigins() const override { return allow_origin_; };
-  const std::list<std::regex>& allowOriginRegexes() const override { return allow_origin_regex_; }
+  const std::list<Regex::CompiledMatcherPtr>& allowOriginRegexes() const override {
+    return allow_origin_regex_;
+  }
   const std::string& allowMethods() const override { return allow_methods_; };
   const std::string& allowHeaders() const override { return allow_headers_; };
   const std::string& exposeHeaders() const override { return expose_headers_; };
@@ -108,7 +116,7 @@ public:
 
 private:
   std::list<std::string> allow_origin_;
-  std::list<std::regex> allow_origin_regex_;
+  std::list<Regex::CompiledMatcherPtr> allow_origin_regex_;
   std::string allow_methods_;
   std::string allow_headers_;
   std::string expose_headers_;
@@ -117,20 +125,60 @@ private:
   bool enabled_;
 };
 
-class ConfigImpl;
+/**
+ * The parts of a route configuration that apply to all of its virtual hosts. Virtual hosts refer
+ * to this rather than to the ConfigImpl that owns them, so that a virtual host whose configuration
+ * did not change can be shared by the ConfigImpls of successive updates of a route configuration.
+ */
+class GlobalRouteConfigImpl : public Config {
+public:
+  GlobalRouteConfigImpl(const envoy::api::v2::RouteConfiguration& config);
+
+  const HeaderParser& requestHeaderParser() const { return *request_headers_parser_; };
+  const HeaderParser& responseHeaderParser() const { return *response_headers_parser_; };
+
+  /**
+   * @return uint64_t a hash of the configuration held, i.e. of the route configuration without
+   *         its virtual hosts.
+   */
+  uint64_t hash() const { return hash_; }
+
+  // Router::Config
+  // Routes are selected by the ConfigImpl that owns the virtual hosts.
+  RouteConstSharedPtr route(const Http::HeaderMap&, uint64_t) const override { return nullptr; }
+  const std::list<Http::LowerCaseString>& internalOnlyHeaders() const override {
+    return internal_only_headers_;
+  }
+  const std::string& name() const override { return name_; }
+
+private:
+  const std::string name_;
+  std::list<Http::LowerCaseString> internal_only_headers_;
+  HeaderParserPtr request_headers_parser_;
+  HeaderParserPtr response_headers_parser_;
+  uint64_t hash_;
+};
+
+typedef std::shared_ptr<const GlobalRouteConfigImpl> GlobalRouteConfigImplConstSharedPtr;
+
 /**
  * Holds all routing configuration for an entire virtual host.
  */
-class VirtualHostImpl : public VirtualHost {
+class VirtualHostImpl : public VirtualHost, public Memory::Accounted<Memory::Tag::RouteTables> {
 public:
   VirtualHostImpl(const envoy::api::v2::route::VirtualHost& virtual_host,
-                  const ConfigImpl& global_route_config,
+                  GlobalRouteConfigImplConstSharedPtr global_route_config,
                   Server::Configuration::FactoryContext& factory_context, bool validate_clusters);
 
   RouteConstSharedPtr getRouteFromEntries(const Http::HeaderMap& headers,
                                           uint64_t random_value) const;
   const VirtualCluster* virtualClusterFromEntries(const Http::HeaderMap& headers) const;
-  const ConfigImpl& globalRouteConfig() const { return global_route_config_; }
+  const GlobalRouteConfigImpl& globalRouteConfig() const { return *global_route_config_; }
+
+  /**
+   * Throws an EnvoyException if a route refers to a cluster that the cluster manager does not know.
+   */
+  void validateClusters(Upstream::ClusterManager& cm) const;
   const HeaderParser& requestHeaderParser() const { return *request_headers_parser_; };
   const HeaderParser& responseHeaderParser() const { return *response_headers_parser_; };
 
@@ -150,7 +198,7 @@ private:
     // Router::VirtualCluster
     const std::string& name() const override { return name_; }
 
-    std::regex pattern_;
+    Regex::CompiledMatcherPtr pattern_;
     absl::optional<std::string> method_;
     std::string name_;
   };
@@ -167,12 +215,15 @@ private:
 
   const std::string name_;
   std::vector<RouteEntryImplBaseConstSharedPtr> routes_;
+  // Indexes routes_ by path.
+  RouteIndex route_index_;
   std::vector<VirtualClusterEntry> virtual_clusters_;
+  // The patterns of virtual_clusters_ compiled into a single program, when they all use RE2.
+  std::unique_ptr<Regex::GoogleReMatcherSet> virtual_cluster_patterns_;
   SslRequirements ssl_requirements_;
   const RateLimitPolicyImpl rate_limit_policy_;
   std::unique_ptr<const CorsPolicyImpl> cors_policy_;
-  const ConfigImpl& global_route_config_; // See note in RouteEntryImplBase::clusterEntry() on why
-                                          // raw ref to the top level config is currently safe.
+  const GlobalRouteConfigImplConstSharedPtr global_route_config_;
   HeaderParserPtr request_headers_parser_;
   HeaderParserPtr response_headers_parser_;
   PerFilterConfigs per_filter_configs_;
@@ -198,6 +249,22 @@ private:
   uint32_t retry_on_{};
 };
 
+/**
+ * Implementation of HedgePolicy that reads from the proto route config.
+ */
+class HedgePolicyImpl : public HedgePolicy {
+public:
+  HedgePolicyImpl(const envoy::api::v2::route::RouteAction& config);
+
+  // Router::HedgePolicy
+  std::chrono::milliseconds delay() const override { return delay_; }
+  uint32_t budgetPercent() const override { return budget_percent_; }
+
+private:
+  std::chrono::milliseconds delay_{0};
+  uint32_t budget_percent_{};
+};
+
 /**
  * Implementation of ShadowPolicy that reads from the proto route config.
  */
@@ -226,6 +293,7 @@ public:
   // Router::HashPolicy
   absl::optional<uint64_t> generateHash(const Network::Address::Instance* downstream_addr,
                                         const Http::HeaderMap& headers,
+                                        Http::RequestAttributes& request_attributes,
                                         const AddCookieCallback add_cookie) const override;
 
   class HashMethod {
@@ -233,6 +301,7 @@ public:
     virtual ~HashMethod() {}
     virtual absl::optional<uint64_t> evaluate(const Network::Address::Instance* downstream_addr,
                                               const Http::HeaderMap& headers,
+                                              Http::RequestAttributes& request_attributes,
                                               const AddCookieCallback add_cookie) const PURE;
 
     // If the method is a terminal method, ignore rest of the hash policy chain.
@@ -270,6 +339,7 @@ class RouteEntryImplBase : public RouteEntry,
                            public DirectResponseEntry,
                            public Route,
                            public PathMatchCriterion,
+                           public Memory::Accounted<Memory::Tag::RouteTables>,
                            public std::enable_shared_from_this<RouteEntryImplBase> {
 public:
   /**
@@ -292,6 +362,9 @@ public:
 
   // Router::RouteEntry
   const std::string& clusterName() const override;
+  const Upstream::ClusterNameHandle* clusterNameHandle() const override {
+    return cluster_handle_ ? &cluster_handle_.value() : nullptr;
+  }
   Http::Code clusterNotFoundResponseCode() const override {
     return cluster_not_found_response_code_;
   }
@@ -309,6 +382,7 @@ public:
   Upstream::ResourcePriority priority() const override { return priority_; }
   const RateLimitPolicy& rateLimitPolicy() const override { return rate_limit_policy_; }
   const RetryPolicy& retryPolicy() const override { return retry_policy_; }
+  const HedgePolicy& hedgePolicy() const override { return hedge_policy_; }
   const ShadowPolicy& shadowPolicy() const override { return shadow_policy_; }
   const VirtualCluster* virtualCluster(const Http::HeaderMap& headers) const override {
     return vhost_.virtualClusterFromEntries(headers);
@@ -337,7 +411,8 @@ public:
   std::string newPath(const Http::HeaderMap& headers) const override;
   void rewritePathHeader(Http::HeaderMap&, bool) const override {}
   Http::Code responseCode() const override { return direct_response_code_.value(); }
-  const std::string& responseBody() const override { return direct_response_body_; }
+  const std::string& responseBody() const override { return *direct_response_body_; }
+  void addResponseBody(Buffer::Instance& buffer) const override;
 
   // Router::Route
   const DirectResponseEntry* directResponseEntry() const override;
@@ -365,8 +440,8 @@ protected:
 
 private:
   struct RuntimeData {
-    std::string key_{};
-    uint64_t default_{};
+    Runtime::KeyHandle key_;
+    uint64_t default_;
   };
 
   class DynamicRouteEntry : public RouteEntry, public Route {
@@ -395,6 +470,7 @@ private:
     Upstream::ResourcePriority priority() const override { return parent_->priority(); }
     const RateLimitPolicy& rateLimitPolicy() const override { return parent_->rateLimitPolicy(); }
     const RetryPolicy& retryPolicy() const override { return parent_->retryPolicy(); }
+    const HedgePolicy& hedgePolicy() const override { return parent_->hedgePolicy(); }
     const ShadowPolicy& shadowPolicy() const override { return parent_->shadowPolicy(); }
     std::chrono::milliseconds timeout() const override { return parent_->timeout(); }
     absl::optional<std::chrono::milliseconds> idleTimeout() const override {
@@ -464,6 +540,10 @@ private:
       return loader_.snapshot().getInteger(runtime_key_, cluster_weight_);
     }
 
+    const Upstream::ClusterNameHandle* clusterNameHandle() const override {
+      return &cluster_handle_;
+    }
+
     const MetadataMatchCriteria* metadataMatchCriteria() const override {
       if (cluster_metadata_match_criteria_) {
         return cluster_metadata_match_criteria_.get();
@@ -486,7 +566,8 @@ private:
     const RouteSpecificFilterConfig* perFilterConfig(const std::string& name) const override;
 
   private:
-    const std::string runtime_key_;
+    const Upstream::ClusterNameHandle cluster_handle_;
+    const Runtime::KeyHandle runtime_key_;
     Runtime::Loader& loader_;
     const uint64_t cluster_weight_;
     MetadataMatchCriteriaConstPtr cluster_metadata_match_criteria_;
@@ -515,6 +596,8 @@ private:
   const TcpProxy::ConfigSharedPtr websocket_config_;
   const std::string cluster_name_;
   const Http::LowerCaseString cluster_header_name_;
+  // Only set for routes to a single cluster given by name.
+  const absl::optional<Upstream::ClusterNameHandle> cluster_handle_;
   const Http::Code cluster_not_found_response_code_;
   const std::chrono::milliseconds timeout_;
   const absl::optional<std::chrono::milliseconds> idle_timeout_;
@@ -527,6 +610,7 @@ private:
   const std::string prefix_rewrite_redirect_;
   const bool strip_query_;
   const RetryPolicyImpl retry_policy_;
+  const HedgePolicyImpl hedge_policy_;
   const RateLimitPolicyImpl rate_limit_policy_;
   const ShadowPolicyImpl shadow_policy_;
   const Upstream::ResourcePriority priority_;
@@ -547,7 +631,8 @@ private:
 
   const DecoratorConstPtr decorator_;
   const absl::optional<Http::Code> direct_response_code_;
-  std::string direct_response_body_;
+  // Shared with the buffers of the direct responses it was added to.
+  const std::shared_ptr<const std::string> direct_response_body_;
   PerFilterConfigs per_filter_configs_;
 };
 
@@ -614,7 +699,7 @@ public:
   void rewritePathHeader(Http::HeaderMap& headers, bool insert_envoy_original_path) const override;
 
 private:
-  const std::regex regex_;
+  const Regex::CompiledMatcherPtr regex_;
   const std::string regex_str_;
 };
 
@@ -624,28 +709,28 @@ private:
  */
 class RouteMatcher {
 public:
+  /**
+   * @param previous_route_matcher supplies the route matcher of the previous version of the route
+   *        configuration, if any. Its virtual hosts whose configuration did not change are reused
+   *        rather than built again. They must share global_route_config.
+   */
   RouteMatcher(const envoy::api::v2::RouteConfiguration& config,
-               const ConfigImpl& global_http_config,
-               Server::Configuration::FactoryContext& factory_context, bool validate_clusters);
+               GlobalRouteConfigImplConstSharedPtr global_route_config,
+               Server::Configuration::FactoryContext& factory_context, bool validate_clusters,
+               const RouteMatcher* previous_route_matcher);
 
   RouteConstSharedPtr route(const Http::HeaderMap& headers, uint64_t random_value) const;
 
 private:
   const VirtualHostImpl* findVirtualHost(const Http::HeaderMap& headers) const;
-  const VirtualHostImpl* findWildcardVirtualHost(const std::string& host) const;
-
-  std::unordered_map<std::string, VirtualHostSharedPtr> virtual_hosts_;
-  // std::greater as a minor optimization to iterate from more to less specific
-  //
-  // A note on using an unordered_map versus a vector of (string, VirtualHostSharedPtr) pairs:
-  //
-  // Based on local benchmarks, each vector entry costs around 20ns for recall and (string)
-  // comparison with a fixed cost of about 25ns. For unordered_map, the empty map costs about 65ns
-  // and climbs to about 110ns once there are any entries.
-  //
-  // The break-even is 4 entries.
-  std::map<int64_t, std::unordered_map<std::string, VirtualHostSharedPtr>, std::greater<int64_t>>
-      wildcard_virtual_host_suffixes_;
+
+  // All the virtual hosts, by the hash of their configuration.
+  std::unordered_map<uint64_t, VirtualHostSharedPtr> virtual_hosts_by_hash_;
+
+  // All the virtual hosts, in configuration order.
+  std::vector<VirtualHostSharedPtr> virtual_hosts_;
+  // Indexes virtual_hosts_ by exact and wildcard domain.
+  DomainIndex domain_index_;
   VirtualHostSharedPtr default_virtual_host_;
 };
 
@@ -654,12 +739,21 @@ private:
  */
 class ConfigImpl : public Config {
 public:
+  /**
+   * @param previous_config supplies the previous version of the route configuration, if any. The
+   *        virtual hosts whose configuration did not change are shared with it rather than built
+   *        again, provided that the rest of the route configuration did not change either.
+   */
   ConfigImpl(const envoy::api::v2::RouteConfiguration& config,
              Server::Configuration::FactoryContext& factory_context,
-             bool validate_clusters_default);
+             bool validate_clusters_default, const ConfigImpl* previous_config = nullptr);
 
-  const HeaderParser& requestHeaderParser() const { return *request_headers_parser_; };
-  const HeaderParser& responseHeaderParser() const { return *response_headers_parser_; };
+  const HeaderParser& requestHeaderParser() const {
+    return global_route_config_->requestHeaderParser();
+  };
+  const HeaderParser& responseHeaderParser() const {
+    return global_route_config_->responseHeaderParser();
+  };
 
   // Router::Config
   RouteConstSharedPtr route(const Http::HeaderMap& headers, uint64_t random_value) const override {
@@ -667,17 +761,14 @@ public:
   }
 
   const std::list<Http::LowerCaseString>& internalOnlyHeaders() const override {
-    return internal_only_headers_;
+    return global_route_config_->internalOnlyHeaders();
   }
 
-  const std::string& name() const override { return name_; }
+  const std::string& name() const override { return global_route_config_->name(); }
 
 private:
+  GlobalRouteConfigImplConstSharedPtr global_route_config_;
   std::unique_ptr<RouteMatcher> route_matcher_;
-  std::list<Http::LowerCaseString> internal_only_headers_;
-  HeaderParserPtr request_headers_parser_;
-  HeaderParserPtr response_headers_parser_;
-  const std::string name_;
 };
 
 /**
@@ -0,0 +1,113 @@
+#include "common/router/domain_index.h"
+
+#include <algorithm>
+
+namespace Envoy {
+namespace Router {
+
+bool DomainIndex::addExact(const std::string& domain, uint32_t ordinal) {
+  Node& node = insert(domain);
+  if (node.exact_) {
+    return false;
+  }
+  node.exact_ = ordinal;
+  return true;
+}
+
+void DomainIndex::addWildcardSuffix(const std::string& suffix, uint32_t ordinal) {
+  Node& node = insert(suffix);
+  if (!node.wildcard_) {
+    node.wildcard_ = ordinal;
+  }
+}
+
+absl::optional<uint32_t> DomainIndex::find(absl::string_view host) const {
+  // Walk the host from its end. Longer wildcard suffixes are deeper in the tree, so the last one
+  // met wins.
+  const size_t size = host.size();
+  const Node* node = &root_;
+  absl::optional<uint32_t> wildcard;
+  size_t depth = 0;
+  while (depth < size) {
+    const Node* child = node->findChild(fold(host[size - 1 - depth]));
+    if (child == nullptr || child->label_.size() > size - depth) {
+      break;
+    }
+
+    bool matches = true;
+    for (size_t i = 1; i < child->label_.size(); i++) {
+      if (fold(host[size - 1 - depth - i]) != child->label_[i]) {
+        matches = false;
+        break;
+      }
+    }
+    if (!matches) {
+      break;
+    }
+
+    node = child;
+    depth += child->label_.size();
+    // A wildcard does not match an empty prefix, e.g. *.foo.com does not match .foo.com.
+    if (depth < size && node->wildcard_) {
+      wildcard = node->wildcard_;
+    }
+  }
+
+  if (depth == size && node->exact_) {
+    return node->exact_;
+  }
+  return wildcard;
+}
+
+const DomainIndex::Node* DomainIndex::Node::findChild(char c) const {
+  auto it = std::lower_bound(children_.begin(), children_.end(), c,
+                             [](const NodePtr& child, char c) { return child->label_[0] < c; });
+  return it != children_.end() && (*it)->label_[0] == c ? it->get() : nullptr;
+}
+
+DomainIndex::Node& DomainIndex::insert(const std::string& domain) {
+  empty_ = false;
+  std::string key(domain.rbegin(), domain.rend());
+  std::transform(key.begin(), key.end(), key.begin(), fold);
+
+  Node* node = &root_;
+  absl::string_view remaining(key);
+  while (!remaining.empty()) {
+    auto it = std::lower_bound(
+        node->children_.begin(), node->children_.end(), remaining[0],
+        [](const NodePtr& child, char c) { return child->label_[0] < c; });
+    if (it == node->children_.end() || (*it)->label_[0] != remaining[0]) {
+      it = node->children_.emplace(it, new Node());
+      (*it)->label_ = std::string(remaining);
+      return **it;
+    }
+
+    const std::string& label = (*it)->label_;
+    const size_t common =
+        std::mismatch(label.begin(), label.begin() + std::min(label.size(), remaining.size()),
+                      remaining.begin())
+            .first -
+        label.begin();
+    if (common < label.size()) {
+      // Split the edge so that the key ends on a node.
+      NodePtr middle(new Node());
+      middle->label_ = label.substr(0, common);
+      (*it)->label_ = label.substr(common);
+      middle->children_.push_back(std::move(*it));
+      *it = std::move(middle);
+    }
+
+    node = it->get();
+    remaining.remove_prefix(common);
+  }
+
+  return *node;
+}
+
+char DomainIndex::fold(char c) {
+  // Matches the ASCII case folding of Http::LowerCaseString.
+  return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+}
+
+} // namespace Router
+} // namespace Envoy
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+
+namespace Envoy {
+namespace Router {
+
+/**
+ * Index of the domains of the virtual hosts of a route configuration. Exact domains and wildcard
+ * domain suffixes are held in a radix tree keyed by the reversed domain, so that the virtual host
+ * of a request is found by walking its host once from the end, without allocating. Virtual hosts
+ * are identified by their ordinal in the route configuration. Domains are compared ignoring ASCII
+ * case.
+ */
+class DomainIndex {
+public:
+  /**
+   * Add an exact domain.
+   * @return false if the domain was already added, in which case the index is unchanged.
+   */
+  bool addExact(const std::string& domain, uint32_t ordinal);
+
+  /**
+   * Add a wildcard domain, given the suffix that follows the leading '*'. A suffix that was already
+   * added keeps its first ordinal.
+   */
+  void addWildcardSuffix(const std::string& suffix, uint32_t ordinal);
+
+  /**
+   * @return true if no domain was added.
+   */
+  bool empty() const { return empty_; }
+
+  /**
+   * @param host supplies the host of a request.
+   * @return the ordinal of the exact domain that is the host, or else that of the longest wildcard
+   *         suffix that is a proper suffix of the host, or nullopt if there is none.
+   */
+  absl::optional<uint32_t> find(absl::string_view host) const;
+
+private:
+  struct Node;
+  typedef std::unique_ptr<Node> NodePtr;
+
+  struct Node {
+    const Node* findChild(char c) const;
+
+    // The reversed label of the edge from the parent, never empty except for the root.
+    std::string label_;
+    // Sorted by the first character of their label.
+    std::vector<NodePtr> children_;
+    // The ordinals of the exact domain and wildcard suffix whose reversal is the key of the node.
+    absl::optional<uint32_t> exact_;
+    absl::optional<uint32_t> wildcard_;
+  };
+
+  Node& insert(const std::string& domain);
+  static char fold(char c);
+
+  Node root_;
+  bool empty_{true};
+};
+
+} // namespace Router
+} // namespace Envoy
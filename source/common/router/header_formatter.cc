@@ -1,6 +1,8 @@
 #include "common/router/header_formatter.h"
 
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "envoy/router/string_accessor.h"
 
@@ -185,18 +187,16 @@ RequestInfoHeaderFormatter::RequestInfoHeaderFormatter(absl::string_view field_n
           *request_info.downstreamLocalAddress());
     };
   } else if (field_name.find("START_TIME") == 0) {
-    const std::string pattern = fmt::format("%{}%", field_name);
-    if (start_time_formatters_.find(pattern) == start_time_formatters_.end()) {
-      start_time_formatters_.emplace(
-          std::make_pair(pattern, AccessLog::AccessLogFormatParser::parse(pattern)));
-    }
-    field_extractor_ = [this, pattern](const Envoy::RequestInfo::RequestInfo& request_info) {
-      const auto& formatters = start_time_formatters_.at(pattern);
-      Http::HeaderMapImpl empty_map;
+    // The pattern is parsed once; the formatters are shared by the copies of the extractor.
+    std::shared_ptr<const std::vector<AccessLog::FormatterPtr>> formatters =
+        std::make_shared<const std::vector<AccessLog::FormatterPtr>>(
+            AccessLog::AccessLogFormatParser::parse(fmt::format("%{}%", field_name)));
+    field_extractor_ = [formatters](const Envoy::RequestInfo::RequestInfo& request_info) {
+      static const Http::HeaderMapImpl* empty_map = new Http::HeaderMapImpl();
       std::string formatted;
-      for (const auto& formatter : formatters) {
+      for (const auto& formatter : *formatters) {
         absl::StrAppend(&formatted,
-                        formatter->format(empty_map, empty_map, empty_map, request_info));
+                        formatter->format(*empty_map, *empty_map, *empty_map, request_info));
       }
       return formatted;
     };
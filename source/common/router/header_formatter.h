@@ -20,6 +20,15 @@ public:
 
   virtual const std::string format(const Envoy::RequestInfo::RequestInfo& request_info) const PURE;
 
+  /**
+   * Append the formatted value to a buffer, so that compound values are formatted without a
+   * temporary string per part.
+   * @param request_info supplies the request info to format.
+   * @param buffer supplies the buffer to append to.
+   */
+  virtual void formatInto(const Envoy::RequestInfo::RequestInfo& request_info,
+                          std::string& buffer) const PURE;
+
   /**
    * @return bool indicating whether the formatted header should be appended to the existing
    *              headers
@@ -38,12 +47,15 @@ public:
 
   // HeaderFormatter::format
   const std::string format(const Envoy::RequestInfo::RequestInfo& request_info) const override;
+  void formatInto(const Envoy::RequestInfo::RequestInfo& request_info,
+                  std::string& buffer) const override {
+    buffer.append(field_extractor_(request_info));
+  }
   bool append() const override { return append_; }
 
 private:
   std::function<std::string(const Envoy::RequestInfo::RequestInfo&)> field_extractor_;
   const bool append_;
-  std::unordered_map<std::string, std::vector<AccessLog::FormatterPtr>> start_time_formatters_;
 };
 
 /**
@@ -58,8 +70,16 @@ public:
   const std::string format(const Envoy::RequestInfo::RequestInfo&) const override {
     return static_value_;
   };
+  void formatInto(const Envoy::RequestInfo::RequestInfo&, std::string& buffer) const override {
+    buffer.append(static_value_);
+  }
   bool append() const override { return append_; }
 
+  /**
+   * @return const std::string& the static value, which lives as long as the formatter.
+   */
+  const std::string& value() const { return static_value_; }
+
 private:
   const std::string static_value_;
   const bool append_;
@@ -76,11 +96,15 @@ public:
   // HeaderFormatter::format
   const std::string format(const Envoy::RequestInfo::RequestInfo& request_info) const override {
     std::string buf;
-    for (const auto& formatter : formatters_) {
-      buf += formatter->format(request_info);
-    }
+    formatInto(request_info, buf);
     return buf;
   };
+  void formatInto(const Envoy::RequestInfo::RequestInfo& request_info,
+                  std::string& buffer) const override {
+    for (const auto& formatter : formatters_) {
+      formatter->formatInto(request_info, buffer);
+    }
+  }
   bool append() const override { return append_; }
 
 private:
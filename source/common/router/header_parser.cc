@@ -226,9 +226,14 @@ HeaderParserPtr HeaderParser::configure(
 
   for (const auto& header_value_option : headers_to_add) {
     HeaderFormatterPtr header_formatter = parseInternal(header_value_option);
-
-    header_parser->headers_to_add_.emplace_back(
-        Http::LowerCaseString(header_value_option.header().key()), std::move(header_formatter));
+    const PlainHeaderFormatter* plain_formatter =
+        dynamic_cast<const PlainHeaderFormatter*>(header_formatter.get());
+    const std::string* static_value =
+        plain_formatter != nullptr ? &plain_formatter->value() : nullptr;
+
+    header_parser->headers_to_add_.push_back(
+        {Http::LowerCaseString(header_value_option.header().key()), std::move(header_formatter),
+         static_value});
   }
 
   return header_parser;
@@ -248,13 +253,29 @@ HeaderParserPtr HeaderParser::configure(
 
 void HeaderParser::evaluateHeaders(Http::HeaderMap& headers,
                                    const RequestInfo::RequestInfo& request_info) const {
-  for (const auto& formatter : headers_to_add_) {
-    const std::string value = formatter.second->format(request_info);
-    if (!value.empty()) {
-      if (formatter.second->append()) {
-        headers.addReferenceKey(formatter.first, value);
+  // Dynamic values are formatted into this buffer, which keeps its capacity across headers. Their
+  // copy into the header map fits the inline buffer of a HeaderString when short.
+  std::string buffer;
+  for (const HeaderToAdd& header : headers_to_add_) {
+    if (header.static_value_ != nullptr) {
+      // The value lives as long as the route configuration, which outlives the request.
+      if (!header.static_value_->empty()) {
+        if (header.formatter_->append()) {
+          headers.addReference(header.key_, *header.static_value_);
+        } else {
+          headers.setReference(header.key_, *header.static_value_);
+        }
+      }
+      continue;
+    }
+
+    buffer.clear();
+    header.formatter_->formatInto(request_info, buffer);
+    if (!buffer.empty()) {
+      if (header.formatter_->append()) {
+        headers.addReferenceKey(header.key_, buffer);
       } else {
-        headers.setReferenceKey(formatter.first, value);
+        headers.setReferenceKey(header.key_, buffer);
       }
     }
   }
@@ -19,7 +19,8 @@ typedef std::unique_ptr<HeaderParser> HeaderParserPtr;
 /**
  * HeaderParser manipulates Http::HeaderMap instances. Headers to be added are pre-parsed to select
  * between a constant value implementation and a dynamic value implementation based on
- * RequestInfo::RequestInfo fields.
+ * RequestInfo::RequestInfo fields. Constant values are added by reference, without copying them,
+ * and dynamic values are formatted into a buffer shared by all the headers of an evaluation.
  */
 class HeaderParser {
 public:
@@ -46,7 +47,14 @@ protected:
   HeaderParser() {}
 
 private:
-  std::vector<std::pair<Http::LowerCaseString, HeaderFormatterPtr>> headers_to_add_;
+  struct HeaderToAdd {
+    Http::LowerCaseString key_;
+    HeaderFormatterPtr formatter_;
+    // The value of the header if it has no variables, owned by formatter_.
+    const std::string* static_value_;
+  };
+
+  std::vector<HeaderToAdd> headers_to_add_;
   std::vector<Http::LowerCaseString> headers_to_remove_;
 };
 
@@ -11,7 +11,8 @@ typedef std::unique_ptr<const MetadataMatchCriteriaImpl> MetadataMatchCriteriaIm
 class MetadataMatchCriteriaImpl : public MetadataMatchCriteria {
 public:
   MetadataMatchCriteriaImpl(const ProtobufWkt::Struct& metadata_matches)
-      : metadata_match_criteria_(extractMetadataMatchCriteria(nullptr, metadata_matches)){};
+      : metadata_match_criteria_(extractMetadataMatchCriteria(nullptr, metadata_matches)),
+        hash_(hashCriteria(metadata_match_criteria_)){};
 
   MetadataMatchCriteriaConstPtr
   mergeMatchCriteria(const ProtobufWkt::Struct& metadata_matches) const override {
@@ -23,16 +24,29 @@ public:
   const std::vector<MetadataMatchCriterionConstSharedPtr>& metadataMatchCriteria() const override {
     return metadata_match_criteria_;
   }
+  uint64_t hash() const override { return hash_; }
+
+  /**
+   * @return uint64_t the hash of the given criteria, as returned by hash().
+   */
+  static uint64_t hashCriteria(const std::vector<MetadataMatchCriterionConstSharedPtr>& criteria) {
+    uint64_t hash = 0;
+    for (const auto& criterion : criteria) {
+      hash = criterion->value().hashWithName(criterion->name(), hash);
+    }
+    return hash;
+  }
 
 private:
   MetadataMatchCriteriaImpl(const std::vector<MetadataMatchCriterionConstSharedPtr>& criteria)
-      : metadata_match_criteria_(criteria){};
+      : metadata_match_criteria_(criteria), hash_(hashCriteria(metadata_match_criteria_)){};
 
   static std::vector<MetadataMatchCriterionConstSharedPtr>
   extractMetadataMatchCriteria(const MetadataMatchCriteriaImpl* parent,
                                const ProtobufWkt::Struct& metadata_matches);
 
   const std::vector<MetadataMatchCriterionConstSharedPtr> metadata_match_criteria_;
+  const uint64_t hash_;
 };
 
 class MetadataMatchCriterionImpl : public MetadataMatchCriterion {
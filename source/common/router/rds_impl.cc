@@ -80,7 +80,8 @@ RdsRouteConfigSubscription::RdsRouteConfigSubscription(
                                    factory_context.scope());
       },
       "envoy.api.v2.RouteDiscoveryService.FetchRoutes",
-      "envoy.api.v2.RouteDiscoveryService.StreamRoutes");
+      "envoy.api.v2.RouteDiscoveryService.StreamRoutes",
+      "envoy.api.v2.RouteDiscoveryService.IncrementalRoutes");
 }
 
 RdsRouteConfigSubscription::~RdsRouteConfigSubscription() {
@@ -130,6 +131,14 @@ void RdsRouteConfigSubscription::onConfigUpdate(const ResourceVector& resources,
   runInitializeCallbackIfAny();
 }
 
+void RdsRouteConfigSubscription::onIncrementalConfigUpdate(
+    const ResourceVector& added_resources, const Protobuf::RepeatedPtrField<ProtobufTypes::String>&,
+    const std::string& system_version_info) {
+  // The only watched resource is the route configuration itself, so an update that doesn't add it
+  // removes it, which is handled as a missing route configuration.
+  onConfigUpdate(added_resources, system_version_info);
+}
+
 void RdsRouteConfigSubscription::onConfigUpdateFailed(const EnvoyException*) {
   // We need to allow server startup to continue, even if we have a bad
   // config.
@@ -151,17 +160,16 @@ RdsRouteConfigProviderImpl::RdsRouteConfigProviderImpl(
     RdsRouteConfigSubscriptionSharedPtr&& subscription,
     Server::Configuration::FactoryContext& factory_context)
     : subscription_(std::move(subscription)), factory_context_(factory_context),
-      tls_(factory_context.threadLocal().allocateSlot()) {
+      config_(factory_context.threadLocal()) {
   ConfigConstSharedPtr initial_config;
   if (subscription_->config_info_.has_value()) {
-    initial_config =
+    last_config_ =
         std::make_shared<ConfigImpl>(subscription_->route_config_proto_, factory_context_, false);
+    initial_config = last_config_;
   } else {
     initial_config = std::make_shared<NullConfigImpl>();
   }
-  tls_->set([initial_config](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
-    return std::make_shared<ThreadLocalConfig>(initial_config);
-  });
+  config_.publish(std::move(initial_config));
   subscription_->route_config_providers_.insert(this);
 }
 
@@ -170,7 +178,7 @@ RdsRouteConfigProviderImpl::~RdsRouteConfigProviderImpl() {
 }
 
 Router::ConfigConstSharedPtr RdsRouteConfigProviderImpl::config() {
-  return tls_->getTyped<ThreadLocalConfig>().config_;
+  return config_.get();
 }
 
 absl::optional<RouteConfigProvider::ConfigInfo> RdsRouteConfigProviderImpl::configInfo() const {
@@ -183,10 +191,10 @@ absl::optional<RouteConfigProvider::ConfigInfo> RdsRouteConfigProviderImpl::conf
 }
 
 void RdsRouteConfigProviderImpl::onConfigUpdate() {
-  ConfigConstSharedPtr new_config(
-      new ConfigImpl(subscription_->route_config_proto_, factory_context_, false));
-  tls_->runOnAllThreads(
-      [this, new_config]() -> void { tls_->getTyped<ThreadLocalConfig>().config_ = new_config; });
+  std::shared_ptr<const ConfigImpl> new_config = std::make_shared<ConfigImpl>(
+      subscription_->route_config_proto_, factory_context_, false, last_config_.get());
+  last_config_ = new_config;
+  config_.publish(std::move(new_config));
 }
 
 RouteConfigProviderManagerImpl::RouteConfigProviderManagerImpl(Server::Admin& admin) {
@@ -24,6 +24,8 @@
 
 #include "common/common/logger.h"
 #include "common/protobuf/utility.h"
+#include "common/router/config_impl.h"
+#include "common/thread_local/snapshot_slot.h"
 
 namespace Envoy {
 namespace Router {
@@ -105,9 +107,14 @@ public:
     initialize_callback_ = callback;
     subscription_->start({route_config_name_}, *this);
   }
+  std::string name() const override { return "rds " + route_config_name_; }
 
   // Config::SubscriptionCallbacks
   void onConfigUpdate(const ResourceVector& resources, const std::string& version_info) override;
+  void onIncrementalConfigUpdate(
+      const ResourceVector& added_resources,
+      const Protobuf::RepeatedPtrField<ProtobufTypes::String>& removed_resources,
+      const std::string& system_version_info) override;
   void onConfigUpdateFailed(const EnvoyException* e) override;
   std::string resourceName(const ProtobufWkt::Any& resource) override {
     return MessageUtil::anyConvert<envoy::api::v2::RouteConfiguration>(resource).name();
@@ -165,18 +172,14 @@ public:
   SystemTime lastUpdated() const override { return subscription_->last_updated_; }
 
 private:
-  struct ThreadLocalConfig : public ThreadLocal::ThreadLocalObject {
-    ThreadLocalConfig(ConfigConstSharedPtr initial_config) : config_(initial_config) {}
-
-    ConfigConstSharedPtr config_;
-  };
-
   RdsRouteConfigProviderImpl(RdsRouteConfigSubscriptionSharedPtr&& subscription,
                              Server::Configuration::FactoryContext& factory_context);
 
   RdsRouteConfigSubscriptionSharedPtr subscription_;
   Server::Configuration::FactoryContext& factory_context_;
-  ThreadLocal::SlotPtr tls_;
+  ThreadLocal::SnapshotSlot<const Config> config_;
+  // The config last published, whose unchanged virtual hosts are reused by the next update.
+  std::shared_ptr<const ConfigImpl> last_config_;
 
   friend class RouteConfigProviderManagerImpl;
 };
@@ -11,10 +11,24 @@
 #include "common/http/codes.h"
 #include "common/http/headers.h"
 #include "common/http/utility.h"
+#include "common/runtime/key_registry.h"
+#include "common/singleton/const_singleton.h"
 
 namespace Envoy {
 namespace Router {
 
+namespace {
+
+struct RuntimeKeyValues {
+  const Runtime::KeyHandle BaseRetryBackoffMs{
+      Runtime::KeyRegistry::registerKey("upstream.base_retry_backoff_ms")};
+  const Runtime::KeyHandle UseRetry{Runtime::KeyRegistry::registerKey("upstream.use_retry")};
+};
+
+typedef ConstSingleton<RuntimeKeyValues> RuntimeKeys;
+
+} // namespace
+
 // These are defined in envoy/router/router.h, however during certain cases the compiler is
 // refusing to use the header version so allocate space here.
 const uint32_t RetryPolicy::RETRY_ON_5XX;
@@ -71,7 +85,7 @@ RetryStateImpl::RetryStateImpl(const RetryPolicy& route_policy, Http::HeaderMap&
   // Merge in the route policy.
   retry_on_ |= route_policy.retryOn();
   retries_remaining_ = std::max(retries_remaining_, route_policy.numRetries());
-  const uint32_t base = runtime_.snapshot().getInteger("upstream.base_retry_backoff_ms", 25);
+  const uint32_t base = runtime_.snapshot().getInteger(RuntimeKeys::get().BaseRetryBackoffMs, 25);
   // Cap the max interval to 10 times the base interval to ensure reasonable backoff intervals.
   backoff_strategy_ = std::make_unique<JitteredBackOffStrategy>(base, base * 10, random_);
 }
@@ -156,7 +170,7 @@ RetryStatus RetryStateImpl::shouldRetry(const Http::HeaderMap* response_headers,
     return RetryStatus::NoOverflow;
   }
 
-  if (!runtime_.snapshot().featureEnabled("upstream.use_retry", 100)) {
+  if (!runtime_.snapshot().featureEnabled(RuntimeKeys::get().UseRetry, 100)) {
     return RetryStatus::No;
   }
 
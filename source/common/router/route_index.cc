@@ -0,0 +1,163 @@
+#include "common/router/route_index.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Router {
+
+absl::optional<uint32_t> RouteIndex::Candidates::next() {
+  Span* min_span = nullptr;
+  for (uint32_t i = 0; i < num_spans_; i++) {
+    Span& span = spans_[i];
+    if (span.begin_ != span.end_ && (min_span == nullptr || *span.begin_ < *min_span->begin_)) {
+      min_span = &span;
+    }
+  }
+
+  if (min_span == nullptr) {
+    return absl::nullopt;
+  }
+  return *min_span->begin_++;
+}
+
+void RouteIndex::Candidates::add(const std::vector<uint32_t>& ordinals) {
+  if (!ordinals.empty()) {
+    ASSERT(num_spans_ < spans_.size());
+    spans_[num_spans_++] = {ordinals.data(), ordinals.data() + ordinals.size()};
+  }
+}
+
+void RouteIndex::addPrefix(const std::string& prefix, bool case_sensitive, uint32_t ordinal) {
+  Tree& tree = case_sensitive ? case_sensitive_tree_ : case_insensitive_tree_;
+  tree.insert(prefix).prefix_routes_.push_back(ordinal);
+}
+
+void RouteIndex::addPath(const std::string& path, bool case_sensitive, uint32_t ordinal) {
+  Tree& tree = case_sensitive ? case_sensitive_tree_ : case_insensitive_tree_;
+  tree.insert(path).path_routes_.push_back(ordinal);
+}
+
+void RouteIndex::addUnindexed(uint32_t ordinal) { unindexed_routes_.push_back(ordinal); }
+
+void RouteIndex::finalize() {
+  case_sensitive_tree_.root_.finalize({});
+  case_insensitive_tree_.root_.finalize({});
+}
+
+RouteIndex::Candidates RouteIndex::candidates(absl::string_view path, size_t path_length) const {
+  Candidates candidates;
+  case_sensitive_tree_.lookup(path, path_length, candidates);
+  case_insensitive_tree_.lookup(path, path_length, candidates);
+  candidates.add(unindexed_routes_);
+  return candidates;
+}
+
+const RouteIndex::Node* RouteIndex::Node::findChild(char c) const {
+  auto it = std::lower_bound(children_.begin(), children_.end(), c,
+                             [](const NodePtr& child, char c) { return child->label_[0] < c; });
+  return it != children_.end() && (*it)->label_[0] == c ? it->get() : nullptr;
+}
+
+void RouteIndex::Node::finalize(const std::vector<uint32_t>& parent_prefix_routes) {
+  if (!parent_prefix_routes.empty()) {
+    std::vector<uint32_t> prefix_routes;
+    prefix_routes.reserve(parent_prefix_routes.size() + prefix_routes_.size());
+    std::merge(parent_prefix_routes.begin(), parent_prefix_routes.end(), prefix_routes_.begin(),
+               prefix_routes_.end(), std::back_inserter(prefix_routes));
+    prefix_routes_ = std::move(prefix_routes);
+  }
+
+  for (const NodePtr& child : children_) {
+    child->finalize(prefix_routes_);
+  }
+}
+
+RouteIndex::Node& RouteIndex::Tree::insert(const std::string& key) {
+  empty_ = false;
+  std::string folded_key(key);
+  std::transform(folded_key.begin(), folded_key.end(), folded_key.begin(),
+                 [this](char c) { return fold(c); });
+
+  Node* node = &root_;
+  absl::string_view remaining(folded_key);
+  while (!remaining.empty()) {
+    auto it = std::lower_bound(
+        node->children_.begin(), node->children_.end(), remaining[0],
+        [](const NodePtr& child, char c) { return child->label_[0] < c; });
+    if (it == node->children_.end() || (*it)->label_[0] != remaining[0]) {
+      it = node->children_.emplace(it, new Node());
+      (*it)->label_ = std::string(remaining);
+      return **it;
+    }
+
+    const std::string& label = (*it)->label_;
+    const size_t common =
+        std::mismatch(label.begin(), label.begin() + std::min(label.size(), remaining.size()),
+                      remaining.begin())
+            .first -
+        label.begin();
+    if (common < label.size()) {
+      // Split the edge so that the key ends on a node.
+      NodePtr middle(new Node());
+      middle->label_ = label.substr(0, common);
+      (*it)->label_ = label.substr(common);
+      middle->children_.push_back(std::move(*it));
+      *it = std::move(middle);
+    }
+
+    node = it->get();
+    remaining.remove_prefix(common);
+  }
+
+  return *node;
+}
+
+void RouteIndex::Tree::lookup(absl::string_view path, size_t path_length,
+                              Candidates& candidates) const {
+  if (empty_) {
+    return;
+  }
+
+  const Node* node = &root_;
+  const Node* path_node = path_length == 0 ? node : nullptr;
+  size_t depth = 0;
+  while (depth < path.size()) {
+    const Node* child = node->findChild(fold(path[depth]));
+    if (child == nullptr || child->label_.size() > path.size() - depth) {
+      break;
+    }
+
+    bool matches = true;
+    for (size_t i = 0; i < child->label_.size(); i++) {
+      if (fold(path[depth + i]) != child->label_[i]) {
+        matches = false;
+        break;
+      }
+    }
+    if (!matches) {
+      break;
+    }
+
+    node = child;
+    depth += child->label_.size();
+    if (depth == path_length) {
+      path_node = node;
+    }
+  }
+
+  candidates.add(node->prefix_routes_);
+  if (path_node != nullptr) {
+    candidates.add(path_node->path_routes_);
+  }
+}
+
+char RouteIndex::Tree::fold(char c) const {
+  // Matches the ASCII case folding of strncasecmp() in the C locale.
+  return !case_sensitive_ && c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+}
+
+} // namespace Router
+} // namespace Envoy
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+
+namespace Envoy {
+namespace Router {
+
+/**
+ * Index of the path matchers of the routes of a virtual host. Prefix and exact path matchers are
+ * held in radix trees, so that the routes whose path matcher may match a request are found by
+ * walking the path once instead of comparing it with every route. Routes are identified by their
+ * ordinal in the virtual host and candidates are produced in increasing ordinal order, so that the
+ * first route to match a request wins as with a linear scan. Routes that cannot be indexed, such as
+ * regex routes, are candidates for every path.
+ *
+ * A candidate is not necessarily a match: its path matcher may match while its header, query
+ * parameter or runtime matchers do not, so candidates must still be matched against the request.
+ */
+class RouteIndex {
+public:
+  /**
+   * Candidate route ordinals for a path, in increasing order.
+   */
+  class Candidates {
+  public:
+    /**
+     * @return the next candidate ordinal, or nullopt once all the candidates have been produced.
+     */
+    absl::optional<uint32_t> next();
+
+  private:
+    friend class RouteIndex;
+
+    struct Span {
+      const uint32_t* begin_;
+      const uint32_t* end_;
+    };
+
+    void add(const std::vector<uint32_t>& ordinals);
+
+    // Prefix and exact path routes of both trees, and the routes that are not indexed.
+    std::array<Span, 5> spans_;
+    uint32_t num_spans_{};
+  };
+
+  /**
+   * Add a route with a prefix path matcher. Ordinals must be added in increasing order.
+   */
+  void addPrefix(const std::string& prefix, bool case_sensitive, uint32_t ordinal);
+
+  /**
+   * Add a route with an exact path matcher. Ordinals must be added in increasing order.
+   */
+  void addPath(const std::string& path, bool case_sensitive, uint32_t ordinal);
+
+  /**
+   * Add a route that is a candidate for every path. Ordinals must be added in increasing order.
+   */
+  void addUnindexed(uint32_t ordinal);
+
+  /**
+   * Prepare the index for lookups. Must be called once all the routes have been added.
+   */
+  void finalize();
+
+  /**
+   * @param path supplies the path of a request, including its query string.
+   * @param path_length supplies the length of the path without its query string.
+   * @return the candidate routes for the path. The index must outlive the candidates.
+   */
+  Candidates candidates(absl::string_view path, size_t path_length) const;
+
+private:
+  struct Node;
+  typedef std::unique_ptr<Node> NodePtr;
+
+  struct Node {
+    const Node* findChild(char c) const;
+    void finalize(const std::vector<uint32_t>& parent_prefix_routes);
+
+    // The label of the edge from the parent, never empty except for the root.
+    std::string label_;
+    // Sorted by the first character of their label.
+    std::vector<NodePtr> children_;
+    // Ordinals of the prefix routes whose prefix is the key of the node. Once finalized, also
+    // includes those of the ancestors of the node, i.e. all the prefixes of the key.
+    std::vector<uint32_t> prefix_routes_;
+    // Ordinals of the exact path routes whose path is the key of the node.
+    std::vector<uint32_t> path_routes_;
+  };
+
+  /**
+   * Radix tree of the routes that compare paths either case sensitively or not.
+   */
+  struct Tree {
+    Tree(bool case_sensitive) : case_sensitive_(case_sensitive) {}
+
+    Node& insert(const std::string& key);
+    void lookup(absl::string_view path, size_t path_length, Candidates& candidates) const;
+    char fold(char c) const;
+
+    const bool case_sensitive_;
+    Node root_;
+    bool empty_{true};
+  };
+
+  Tree case_sensitive_tree_{true};
+  Tree case_insensitive_tree_{false};
+  std::vector<uint32_t> unindexed_routes_;
+};
+
+} // namespace Router
+} // namespace Envoy
@@ -1,5 +1,6 @@
 #include "common/router/router.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <string>
@@ -56,6 +57,18 @@ bool FilterUtility::shouldShadow(const ShadowPolicy& policy, Runtime::Loader& ru
   return true;
 }
 
+bool FilterUtility::shouldHedge(const HedgePolicy& policy, const Http::HeaderMap& request_headers) {
+  if (policy.delay().count() == 0 || !request_headers.Method()) {
+    return false;
+  }
+
+  const Http::HeaderString& method = request_headers.Method()->value();
+  const auto& methods = Http::Headers::get().MethodValues;
+  return method == methods.Get.c_str() || method == methods.Head.c_str() ||
+         method == methods.Options.c_str() || method == methods.Put.c_str() ||
+         method == methods.Delete.c_str() || method == methods.Trace.c_str();
+}
+
 FilterUtility::TimeoutData
 FilterUtility::finalTimeout(const RouteEntry& route, Http::HeaderMap& request_headers,
                             bool insert_envoy_expected_request_timeout_ms, bool grpc_request) {
@@ -117,6 +130,7 @@ FilterUtility::finalTimeout(const RouteEntry& route, Http::HeaderMap& request_he
 Filter::~Filter() {
   // Upstream resources should already have been cleaned.
   ASSERT(!upstream_request_);
+  ASSERT(!hedge_request_);
   ASSERT(!retry_state_);
 }
 
@@ -220,22 +234,36 @@ Http::FilterHeadersStatus Filter::decodeHeaders(Http::HeaderMap& headers, bool e
   if (direct_response != nullptr) {
     config_.stats_.rq_direct_response_.inc();
     direct_response->rewritePathHeader(headers, !config_.suppress_envoy_headers_);
-    callbacks_->sendLocalReply(
-        direct_response->responseCode(), direct_response->responseBody(),
-        [this, direct_response,
-         &request_headers = headers](Http::HeaderMap& response_headers) -> void {
+    // The response is encoded here rather than through sendLocalReply(), so that its body is added
+    // by reference instead of being copied into every response.
+    Http::Utility::sendLocalReply(
+        grpc_request_,
+        [this, direct_response, &request_headers = headers](Http::HeaderMapPtr&& response_headers,
+                                                            bool end_stream) -> void {
           const auto new_path = direct_response->newPath(request_headers);
           if (!new_path.empty()) {
-            response_headers.addReferenceKey(Http::Headers::get().Location, new_path);
+            response_headers->addReferenceKey(Http::Headers::get().Location, new_path);
           }
-          direct_response->finalizeResponseHeaders(response_headers, callbacks_->requestInfo());
-        });
+          direct_response->finalizeResponseHeaders(*response_headers, callbacks_->requestInfo());
+          callbacks_->encodeHeaders(std::move(response_headers), end_stream);
+        },
+        [this](Buffer::Instance& data, bool end_stream) -> void {
+          callbacks_->encodeData(data, end_stream);
+        },
+        stream_destroyed_, direct_response->responseCode(), direct_response->responseBody(),
+        [direct_response](Buffer::Instance& buffer) -> void {
+          direct_response->addResponseBody(buffer);
+        },
+        Http::Headers::get().MethodValues.Head == headers.Method()->value().c_str());
     return Http::FilterHeadersStatus::StopIteration;
   }
 
   // A route entry matches for the request.
   route_entry_ = route_->routeEntry();
-  Upstream::ThreadLocalCluster* cluster = config_.cm_.get(route_entry_->clusterName());
+  const Upstream::ClusterNameHandle* cluster_handle = route_entry_->clusterNameHandle();
+  Upstream::ThreadLocalCluster* cluster = cluster_handle != nullptr
+                                              ? config_.cm_.get(*cluster_handle)
+                                              : config_.cm_.get(route_entry_->clusterName());
   if (!cluster) {
     config_.stats_.no_cluster_.inc();
     ENVOY_STREAM_LOG(debug, "unknown cluster '{}'", *callbacks_, route_entry_->clusterName());
@@ -299,6 +327,7 @@ Http::FilterHeadersStatus Filter::decodeHeaders(Http::HeaderMap& headers, bool e
                        config_.random_, callbacks_->dispatcher(), route_entry_->priority());
   do_shadowing_ = FilterUtility::shouldShadow(route_entry_->shadowPolicy(), config_.runtime_,
                                               callbacks_->streamId());
+  do_hedging_ = FilterUtility::shouldHedge(route_entry_->hedgePolicy(), headers);
 
   ENVOY_STREAM_LOG(debug, "router decoding headers:\n{}", *callbacks_, headers);
 
@@ -323,6 +352,11 @@ Http::ConnectionPool::Instance* Filter::getConnPool() {
     protocol = (features & Upstream::ClusterInfo::Features::HTTP2) ? Http::Protocol::Http2
                                                                    : Http::Protocol::Http11;
   }
+  const Upstream::ClusterNameHandle* cluster_handle = route_entry_->clusterNameHandle();
+  if (cluster_handle != nullptr) {
+    return config_.cm_.httpConnPoolForCluster(*cluster_handle, route_entry_->priority(), protocol,
+                                              this);
+  }
   return config_.cm_.httpConnPoolForCluster(route_entry_->clusterName(), route_entry_->priority(),
                                             protocol, this);
 }
@@ -334,20 +368,25 @@ void Filter::sendNoHealthyUpstreamResponse() {
 }
 
 Http::FilterDataStatus Filter::decodeData(Buffer::Instance& data, bool end_stream) {
-  bool buffering = (retry_state_ && retry_state_->enabled()) || do_shadowing_;
+  bool buffering = (retry_state_ && retry_state_->enabled()) || do_shadowing_ || do_hedging_;
   if (buffering && buffer_limit_ > 0 &&
       getLength(callbacks_->decodingBuffer()) + data.length() > buffer_limit_) {
-    // The request is larger than we should buffer. Give up on the retry/shadow
+    // The request is larger than we should buffer. Give up on the retry/shadow/hedge
     cluster_->stats().retry_or_shadow_abandoned_.inc();
     retry_state_.reset();
     buffering = false;
     do_shadowing_ = false;
+    do_hedging_ = false;
+    shared_request_body_.drain(shared_request_body_.length());
   }
 
-  // If we are going to buffer for retries or shadowing, we need to make a copy before encoding
-  // since it's all moves from here on.
+  // If we are going to buffer for retries, shadowing or hedging, we need a copy of the data
+  // before encoding since it's all moves from here on. The copy shares the data's memory, as do
+  // the copies made for later attempts.
   if (buffering) {
-    Buffer::OwnedImpl copy(data);
+    Buffer::OwnedImpl copy;
+    copy.addShared(data);
+    shared_request_body_.addShared(data);
     upstream_request_->encodeData(copy, end_stream);
   } else {
     upstream_request_->encodeData(data, end_stream);
@@ -357,7 +396,7 @@ Http::FilterDataStatus Filter::decodeData(Buffer::Instance& data, bool end_strea
     onRequestComplete();
   }
 
-  // If we are potentially going to retry or shadow this request we need to buffer.
+  // If we are potentially going to retry, shadow or hedge this request we need to buffer.
   // This will not cause the connection manager to 413 because before we hit the
   // buffer limit we give up on retries and buffering.
   return buffering ? Http::FilterDataStatus::StopIterationAndBuffer
@@ -381,11 +420,19 @@ void Filter::setDecoderFilterCallbacks(Http::StreamDecoderFilterCallbacks& callb
 
 void Filter::cleanup() {
   upstream_request_.reset();
+  if (hedge_request_) {
+    hedge_request_->resetStream();
+    hedge_request_.reset();
+  }
   retry_state_.reset();
   if (response_timeout_) {
     response_timeout_->disableTimer();
     response_timeout_.reset();
   }
+  if (hedge_timeout_) {
+    hedge_timeout_->disableTimer();
+    hedge_timeout_.reset();
+  }
 }
 
 void Filter::maybeDoShadowing() {
@@ -397,7 +444,8 @@ void Filter::maybeDoShadowing() {
   Http::MessagePtr request(new Http::RequestMessageImpl(
       Http::HeaderMapPtr{new Http::HeaderMapImpl(*downstream_headers_)}));
   if (callbacks_->decodingBuffer()) {
-    request->body().reset(new Buffer::OwnedImpl(*callbacks_->decodingBuffer()));
+    request->body().reset(new Buffer::OwnedImpl());
+    request->body()->addShared(shared_request_body_);
   }
   if (downstream_trailers_) {
     request->trailers(Http::HeaderMapPtr{new Http::HeaderMapImpl(*downstream_trailers_)});
@@ -420,12 +468,120 @@ void Filter::onRequestComplete() {
     upstream_request_->setupPerTryTimeout();
     if (timeout_.global_timeout_.count() > 0) {
       response_timeout_ =
-          callbacks_->dispatcher().createTimer([this]() -> void { onResponseTimeout(); });
+          callbacks_->dispatcher().createTimer([this]() -> void { onResponseTimeout(); },
+                                               Event::TimerPrecision::Coarse);
       response_timeout_->enableTimer(timeout_.global_timeout_);
     }
+
+    if (do_hedging_) {
+      hedge_timeout_ = callbacks_->dispatcher().createTimer([this]() -> void { onHedgeTimeout(); });
+      hedge_timeout_->enableTimer(route_entry_->hedgePolicy().delay());
+    }
   }
 }
 
+void Filter::onHedgeTimeout() {
+  // The request is only hedged once, and not while waiting for a retry or once the response has
+  // started.
+  if (!upstream_request_ || hedge_request_ || downstream_response_started_) {
+    return;
+  }
+
+  if (!hedgeBudgetAvailable()) {
+    ENVOY_STREAM_LOG(debug, "not hedging, hedge budget exhausted", *callbacks_);
+    cluster_->stats().upstream_rq_hedge_overflow_.inc();
+    return;
+  }
+
+  // Ask the load balancer for another host than the one of the initial attempt.
+  hedge_excluded_host_ = upstream_request_->upstream_host_.get();
+  hedge_same_host_ = false;
+  Http::ConnectionPool::Instance* conn_pool = getConnPool();
+  hedge_excluded_host_ = nullptr;
+  if (!conn_pool || hedge_same_host_) {
+    ENVOY_STREAM_LOG(debug, "not hedging, no other upstream host", *callbacks_);
+    return;
+  }
+
+  ENVOY_STREAM_LOG(debug, "hedging request", *callbacks_);
+  cluster_->stats().upstream_rq_hedged_.inc();
+  hedge_request_.reset(new UpstreamRequest(*this, *conn_pool));
+  hedge_request_->hedge_ = true;
+  cluster_->resourceManager(route_entry_->priority()).retries().inc();
+  cluster_->stats().upstream_rq_hedge_active_.inc();
+
+  hedge_request_->encodeHeaders(!callbacks_->decodingBuffer() && !downstream_trailers_);
+  // It's possible we got immediately reset.
+  if (hedge_request_) {
+    if (callbacks_->decodingBuffer()) {
+      Buffer::OwnedImpl copy;
+      copy.addShared(shared_request_body_);
+      hedge_request_->encodeData(copy, !downstream_trailers_);
+    }
+
+    if (downstream_trailers_) {
+      hedge_request_->encodeTrailers(*downstream_trailers_);
+    }
+
+    hedge_request_->setupPerTryTimeout();
+  }
+}
+
+bool Filter::hedgeBudgetAvailable() {
+  if (!cluster_->resourceManager(route_entry_->priority()).retries().canCreate()) {
+    return false;
+  }
+
+  const uint64_t budget =
+      std::max<uint64_t>(1, cluster_->stats().upstream_rq_active_.value() *
+                                route_entry_->hedgePolicy().budgetPercent() / 100);
+  return cluster_->stats().upstream_rq_hedge_active_.value() < budget;
+}
+
+void Filter::onHedgedAttemptFailure(UpstreamRequest& attempt, uint64_t response_code) {
+  ENVOY_STREAM_LOG(debug, "hedged attempt failed, waiting for the other attempt", *callbacks_);
+  if (attempt.upstream_host_) {
+    attempt.upstream_host_->outlierDetector().putHttpResponseCode(response_code);
+    attempt.upstream_host_->stats().rq_error_.inc();
+  }
+
+  // Destroys the failed attempt, the other attempt carries on alone.
+  if (&attempt == upstream_request_.get()) {
+    upstream_request_ = std::move(hedge_request_);
+  } else {
+    ASSERT(&attempt == hedge_request_.get());
+    hedge_request_.reset();
+  }
+  if (upstream_request_->upstream_host_) {
+    callbacks_->requestInfo().onUpstreamHostSelected(upstream_request_->upstream_host_);
+  }
+}
+
+bool Filter::onHedgedUpstreamHeaders(UpstreamRequest& attempt, uint64_t response_code,
+                                     bool end_stream) {
+  ASSERT(hedge_request_);
+  if (Http::CodeUtility::is5xx(response_code)) {
+    if (!end_stream) {
+      attempt.resetStream();
+    }
+    onHedgedAttemptFailure(attempt, response_code);
+    return false;
+  }
+
+  // The first attempt to respond wins, the other attempt is cancelled.
+  if (&attempt == hedge_request_.get()) {
+    ENVOY_STREAM_LOG(debug, "hedged attempt won", *callbacks_);
+    cluster_->stats().upstream_rq_hedge_won_.inc();
+    upstream_request_->resetStream();
+    upstream_request_ = std::move(hedge_request_);
+    callbacks_->requestInfo().onUpstreamHostSelected(upstream_request_->upstream_host_);
+  } else {
+    hedge_request_->resetStream();
+    hedge_request_.reset();
+  }
+  return true;
+}
+
 void Filter::onDestroy() {
   if (upstream_request_) {
     upstream_request_->resetStream();
@@ -676,6 +832,17 @@ void Filter::onUpstreamComplete() {
     upstream_request_->resetStream();
   }
 
+  // Only the peak EWMA load balancer uses the latency estimates, so they are not updated for the
+  // other load balancers.
+  if (cluster_->lbType() == Upstream::LoadBalancerType::PeakEwma &&
+      DateUtil::timePointValid(downstream_request_complete_time_)) {
+    const MonotonicTime now = std::chrono::steady_clock::now();
+    upstream_request_->upstream_host_->latencyEstimator().putResponseTime(
+        std::chrono::duration_cast<std::chrono::microseconds>(now -
+                                                              downstream_request_complete_time_),
+        now);
+  }
+
   if (config_.emit_dynamic_stats_ && !callbacks_->requestInfo().healthCheck() &&
       DateUtil::timePointValid(downstream_request_complete_time_)) {
     std::chrono::milliseconds response_time = std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -758,8 +925,9 @@ void Filter::doRetry() {
   // It's possible we got immediately reset.
   if (upstream_request_) {
     if (callbacks_->decodingBuffer()) {
-      // If we are doing a retry we need to make a copy.
-      Buffer::OwnedImpl copy(*callbacks_->decodingBuffer());
+      // If we are doing a retry we need to make a copy, which shares the body's memory.
+      Buffer::OwnedImpl copy;
+      copy.addShared(shared_request_body_);
       upstream_request_->encodeData(copy, !downstream_trailers_);
     }
 
@@ -774,7 +942,7 @@ void Filter::doRetry() {
 Filter::UpstreamRequest::UpstreamRequest(Filter& parent, Http::ConnectionPool::Instance& pool)
     : parent_(parent), conn_pool_(pool), grpc_rq_success_deferred_(false),
       request_info_(pool.protocol()), calling_encode_headers_(false), upstream_canary_(false),
-      encode_complete_(false), encode_trailers_(false) {
+      encode_complete_(false), encode_trailers_(false), hedge_(false) {
 
   if (parent_.config_.start_child_span_) {
     span_ = parent_.callbacks_->activeSpan().spawnChild(
@@ -796,6 +964,10 @@ Filter::UpstreamRequest::~UpstreamRequest() {
     per_try_timeout_->disableTimer();
   }
   clearRequestEncoder();
+  if (hedge_) {
+    parent_.cluster_->resourceManager(parent_.route_entry_->priority()).retries().dec();
+    parent_.cluster_->stats().upstream_rq_hedge_active_.dec();
+  }
 
   request_info_.onRequestComplete();
   for (const auto& upstream_log : parent_.config_.upstream_logs_) {
@@ -806,6 +978,10 @@ Filter::UpstreamRequest::~UpstreamRequest() {
 
 void Filter::UpstreamRequest::decode100ContinueHeaders(Http::HeaderMapPtr&& headers) {
   ASSERT(100 == Http::Utility::getResponseStatus(*headers));
+  // A hedged request has been received entirely, so there is nothing to continue.
+  if (parent_.hedge_request_) {
+    return;
+  }
   parent_.onUpstream100ContinueHeaders(std::move(headers));
 }
 
@@ -815,9 +991,13 @@ void Filter::UpstreamRequest::decodeHeaders(Http::HeaderMapPtr&& headers, bool e
   parent_.callbacks_->requestInfo().onFirstUpstreamRxByteReceived();
   maybeEndDecode(end_stream);
 
-  upstream_headers_ = headers.get();
   const uint64_t response_code = Http::Utility::getResponseStatus(*headers);
   request_info_.response_code_ = static_cast<uint32_t>(response_code);
+  if (parent_.hedge_request_ &&
+      !parent_.onHedgedUpstreamHeaders(*this, response_code, end_stream)) {
+    return;
+  }
+  upstream_headers_ = headers.get();
   parent_.onUpstreamHeaders(response_code, std::move(headers), end_stream);
 }
 
@@ -897,6 +1077,10 @@ void Filter::UpstreamRequest::onResetStream(Http::StreamResetReason reason) {
   clearRequestEncoder();
   if (!calling_encode_headers_) {
     request_info_.setResponseFlag(parent_.streamResetReasonToResponseFlag(reason));
+    if (parent_.hedge_request_) {
+      parent_.onHedgedAttemptFailure(*this, enumToInt(Http::Code::ServiceUnavailable));
+      return;
+    }
     parent_.onUpstreamReset(UpstreamResetType::Reset,
                             absl::optional<Http::StreamResetReason>(reason));
   } else {
@@ -923,7 +1107,8 @@ void Filter::UpstreamRequest::setupPerTryTimeout() {
   ASSERT(!per_try_timeout_);
   if (parent_.timeout_.per_try_timeout_.count() > 0) {
     per_try_timeout_ =
-        parent_.callbacks_->dispatcher().createTimer([this]() -> void { onPerTryTimeout(); });
+        parent_.callbacks_->dispatcher().createTimer([this]() -> void { onPerTryTimeout(); },
+                                                     Event::TimerPrecision::Coarse);
     per_try_timeout_->enableTimer(parent_.timeout_.per_try_timeout_);
   }
 }
@@ -939,6 +1124,10 @@ void Filter::UpstreamRequest::onPerTryTimeout() {
     }
     resetStream();
     request_info_.setResponseFlag(RequestInfo::ResponseFlag::UpstreamRequestTimeout);
+    if (parent_.hedge_request_) {
+      parent_.onHedgedAttemptFailure(*this, enumToInt(parent_.timeout_response_code_));
+      return;
+    }
     parent_.onUpstreamReset(
         UpstreamResetType::PerTryTimeout,
         absl::optional<Http::StreamResetReason>(Http::StreamResetReason::LocalReset));
@@ -24,6 +24,7 @@
 #include "common/common/logger.h"
 #include "common/config/well_known_names.h"
 #include "common/http/utility.h"
+#include "common/memory/recycler.h"
 #include "common/request_info/request_info_impl.h"
 #include "common/router/config_impl.h"
 
@@ -75,6 +76,14 @@ public:
   static bool shouldShadow(const ShadowPolicy& policy, Runtime::Loader& runtime,
                            uint64_t stable_random);
 
+  /**
+   * Determine whether a request may be hedged.
+   * @param policy supplies the route's hedge policy.
+   * @param request_headers supplies the request headers.
+   * @return TRUE if hedging is enabled for the route and the request method is idempotent.
+   */
+  static bool shouldHedge(const HedgePolicy& policy, const Http::HeaderMap& request_headers);
+
   /**
    * Determine the final timeout to use based on the route as well as the request headers.
    * @param route supplies the request route.
@@ -147,7 +156,7 @@ class Filter : Logger::Loggable<Logger::Id::router>,
 public:
   Filter(FilterConfig& config)
       : config_(config), downstream_response_started_(false), downstream_end_stream_(false),
-        do_shadowing_(false) {}
+        do_shadowing_(false), do_hedging_(false), hedge_same_host_(false) {}
 
   ~Filter();
 
@@ -167,6 +176,7 @@ public:
       if (hash_policy) {
         return hash_policy->generateHash(
             callbacks_->requestInfo().downstreamRemoteAddress().get(), *downstream_headers_,
+            callbacks_->requestInfo().requestAttributes(),
             [this](const std::string& key, const std::string& path, std::chrono::seconds max_age) {
               return addDownstreamSetCookie(key, path, max_age);
             });
@@ -203,6 +213,14 @@ public:
     return callbacks_->connection();
   }
   const Http::HeaderMap* downstreamHeaders() const override { return downstream_headers_; }
+  bool shouldSelectAnotherHost(const Upstream::Host& host) override {
+    // Only set while choosing the host of a hedged attempt.
+    hedge_same_host_ = hedge_excluded_host_ != nullptr && &host == hedge_excluded_host_;
+    return hedge_same_host_;
+  }
+  uint32_t hostSelectionRetryCount() const override {
+    return hedge_excluded_host_ != nullptr ? HedgeHostSelectionRetries : 0;
+  }
 
   /**
    * Set a computed cookie to be sent with the downstream headers.
@@ -234,7 +252,8 @@ protected:
 private:
   struct UpstreamRequest : public Http::StreamDecoder,
                            public Http::StreamCallbacks,
-                           public Http::ConnectionPool::Callbacks {
+                           public Http::ConnectionPool::Callbacks,
+                           public Memory::Recyclable<UpstreamRequest> {
     UpstreamRequest(Filter& parent, Http::ConnectionPool::Instance& pool);
     ~UpstreamRequest();
 
@@ -313,12 +332,18 @@ private:
     bool upstream_canary_ : 1;
     bool encode_complete_ : 1;
     bool encode_trailers_ : 1;
+    // Whether this is a hedged attempt, which holds a retry resource of the route's priority.
+    bool hedge_ : 1;
   };
 
   typedef std::unique_ptr<UpstreamRequest> UpstreamRequestPtr;
 
   enum class UpstreamResetType { Reset, GlobalTimeout, PerTryTimeout };
 
+  // How many times the load balancer may pick another host than the one of the initial attempt for
+  // a hedged attempt.
+  enum { HedgeHostSelectionRetries = 3 };
+
   RequestInfo::ResponseFlag streamResetReasonToResponseFlag(Http::StreamResetReason reset_reason);
 
   static const std::string upstreamZone(Upstream::HostDescriptionConstSharedPtr upstream_host);
@@ -337,6 +362,14 @@ private:
   void maybeDoShadowing();
   void onRequestComplete();
   void onResponseTimeout();
+  void onHedgeTimeout();
+  bool hedgeBudgetAvailable();
+  // Called when an attempt fails while another attempt of the hedged request is in flight.
+  void onHedgedAttemptFailure(UpstreamRequest& attempt, uint64_t response_code);
+  // Called when an attempt receives response headers while another attempt of the hedged request
+  // is in flight. Returns false if the response is discarded, in which case the attempt has been
+  // destroyed.
+  bool onHedgedUpstreamHeaders(UpstreamRequest& attempt, uint64_t response_code, bool end_stream);
   void onUpstream100ContinueHeaders(Http::HeaderMapPtr&& headers);
   void onUpstreamHeaders(uint64_t response_code, Http::HeaderMapPtr&& headers, bool end_stream);
   void onUpstreamData(Buffer::Instance& data, bool end_stream);
@@ -363,9 +396,17 @@ private:
   FilterUtility::TimeoutData timeout_;
   Http::Code timeout_response_code_ = Http::Code::GatewayTimeout;
   UpstreamRequestPtr upstream_request_;
+  // The hedged attempt, while both it and the initial attempt are in flight. The attempt that wins
+  // becomes upstream_request_.
+  UpstreamRequestPtr hedge_request_;
+  Event::TimerPtr hedge_timeout_;
+  const Upstream::HostDescription* hedge_excluded_host_{};
   bool grpc_request_{};
   Http::HeaderMap* downstream_headers_{};
   Http::HeaderMap* downstream_trailers_{};
+  // Shares the storage of the request body that the connection manager buffers for retries,
+  // hedging and shadowing, so that every attempt refers to the body rather than copying it.
+  Buffer::OwnedImpl shared_request_body_;
   MonotonicTime downstream_request_complete_time_;
   uint32_t buffer_limit_{0};
   bool stream_destroyed_{};
@@ -377,6 +418,8 @@ private:
   bool downstream_response_started_ : 1;
   bool downstream_end_stream_ : 1;
   bool do_shadowing_ : 1;
+  bool do_hedging_ : 1;
+  bool hedge_same_host_ : 1;
 };
 
 class ProdFilter : public Filter {
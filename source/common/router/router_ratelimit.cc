@@ -87,7 +87,13 @@ bool HeaderValueMatchAction::populateDescriptor(const Router::RouteEntry&,
 RateLimitPolicyEntryImpl::RateLimitPolicyEntryImpl(const envoy::api::v2::route::RateLimit& config)
     : disable_key_(config.disable_key()),
       stage_(static_cast<uint64_t>(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, stage, 0))) {
+  RateLimit::Descriptor static_descriptor;
+  bool is_static = true;
   for (const auto& action : config.actions()) {
+    if (action.action_specifier_case() !=
+        envoy::api::v2::route::RateLimit::Action::kGenericKey) {
+      is_static = false;
+    }
     switch (action.action_specifier_case()) {
     case envoy::api::v2::route::RateLimit::Action::kSourceCluster:
       actions_.emplace_back(new SourceClusterAction());
@@ -101,9 +107,12 @@ RateLimitPolicyEntryImpl::RateLimitPolicyEntryImpl(const envoy::api::v2::route::
     case envoy::api::v2::route::RateLimit::Action::kRemoteAddress:
       actions_.emplace_back(new RemoteAddressAction());
       break;
-    case envoy::api::v2::route::RateLimit::Action::kGenericKey:
-      actions_.emplace_back(new GenericKeyAction(action.generic_key()));
+    case envoy::api::v2::route::RateLimit::Action::kGenericKey: {
+      GenericKeyAction* generic_key_action = new GenericKeyAction(action.generic_key());
+      actions_.emplace_back(generic_key_action);
+      static_descriptor.entries_.push_back(generic_key_action->descriptorEntry());
       break;
+    }
     case envoy::api::v2::route::RateLimit::Action::kHeaderValueMatch:
       actions_.emplace_back(new HeaderValueMatchAction(action.header_value_match()));
       break;
@@ -111,24 +120,30 @@ RateLimitPolicyEntryImpl::RateLimitPolicyEntryImpl(const envoy::api::v2::route::
       NOT_REACHED_GCOVR_EXCL_LINE;
     }
   }
+  if (is_static) {
+    static_descriptor_ = std::move(static_descriptor);
+  }
 }
 
 void RateLimitPolicyEntryImpl::populateDescriptors(
     const Router::RouteEntry& route, std::vector<RateLimit::Descriptor>& descriptors,
     const std::string& local_service_cluster, const Http::HeaderMap& headers,
     const Network::Address::Instance& remote_address) const {
-  RateLimit::Descriptor descriptor;
-  bool result = true;
-  for (const RateLimitActionPtr& action : actions_) {
-    result = result && action->populateDescriptor(route, descriptor, local_service_cluster, headers,
-                                                  remote_address);
-    if (!result) {
-      break;
-    }
+  if (static_descriptor_.has_value()) {
+    descriptors.push_back(static_descriptor_.value());
+    return;
   }
 
-  if (result) {
-    descriptors.emplace_back(descriptor);
+  // The descriptor is built in place, and removed if one of the actions doesn't populate it.
+  descriptors.emplace_back();
+  RateLimit::Descriptor& descriptor = descriptors.back();
+  descriptor.entries_.reserve(actions_.size());
+  for (const RateLimitActionPtr& action : actions_) {
+    if (!action->populateDescriptor(route, descriptor, local_service_cluster, headers,
+                                    remote_address)) {
+      descriptors.pop_back();
+      return;
+    }
   }
 }
 
@@ -11,6 +11,8 @@
 #include "common/config/rds_json.h"
 #include "common/http/header_utility.h"
 
+#include "absl/types/optional.h"
+
 namespace Envoy {
 namespace Router {
 
@@ -73,6 +75,11 @@ public:
   GenericKeyAction(const envoy::api::v2::route::RateLimit::Action::GenericKey& action)
       : descriptor_value_(action.descriptor_value()) {}
 
+  /**
+   * @return the entry appended by the action, which doesn't depend on the request.
+   */
+  RateLimit::DescriptorEntry descriptorEntry() const { return {"generic_key", descriptor_value_}; }
+
   // Router::RateLimitAction
   bool populateDescriptor(const Router::RouteEntry& route, RateLimit::Descriptor& descriptor,
                           const std::string& local_service_cluster, const Http::HeaderMap& headers,
@@ -119,6 +126,9 @@ private:
   const std::string disable_key_;
   uint64_t stage_;
   std::vector<RateLimitActionPtr> actions_;
+  // The descriptor of an entry whose actions don't depend on the request, which is built when the
+  // configuration is loaded rather than for each request.
+  absl::optional<RateLimit::Descriptor> static_descriptor_;
 };
 
 /**
@@ -0,0 +1,32 @@
+#include "common/runtime/key_registry.h"
+
+#include "common/common/assert.h"
+#include "common/common/lock_guard.h"
+
+namespace Envoy {
+namespace Runtime {
+
+KeyHandle KeyRegistry::registerKey(const std::string& key) { return KeyHandle(key, index(key)); }
+
+uint32_t KeyRegistry::index(const std::string& key) { return get().intern(key); }
+
+KeyRegistry& KeyRegistry::get() {
+  static KeyRegistry* registry = new KeyRegistry();
+  return *registry;
+}
+
+uint32_t KeyRegistry::intern(const std::string& key) {
+  Thread::LockGuard lock(lock_);
+  auto it = indexes_.find(key);
+  if (it != indexes_.end()) {
+    return it->second;
+  }
+
+  ASSERT(indexes_.size() < UINT32_MAX);
+  const uint32_t index = indexes_.size();
+  indexes_.emplace(key, index);
+  return index;
+}
+
+} // namespace Runtime
+} // namespace Envoy
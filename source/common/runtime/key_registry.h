@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "envoy/runtime/runtime.h"
+
+#include "common/common/thread.h"
+#include "common/common/thread_annotations.h"
+
+namespace Envoy {
+namespace Runtime {
+
+/**
+ * Process-wide table interning runtime keys to dense indexes. Handles are registered for the keys
+ * read on hot paths, and snapshots intern every key they hold, so that a snapshot can resolve a
+ * handle with a single array index: a key registered after a snapshot was built is necessarily
+ * absent from it. Interned keys are never removed.
+ */
+class KeyRegistry {
+public:
+  /**
+   * Intern a key, returning its existing index if it was already interned.
+   * @param key supplies the runtime key.
+   * @return KeyHandle the handle to read the key from snapshots.
+   */
+  static KeyHandle registerKey(const std::string& key);
+
+  /**
+   * @param key supplies the runtime key.
+   * @return uint32_t the index the key is interned to, interning it if necessary.
+   */
+  static uint32_t index(const std::string& key);
+
+private:
+  static KeyRegistry& get();
+
+  uint32_t intern(const std::string& key);
+
+  Thread::MutexBasicLockable lock_;
+  std::unordered_map<std::string, uint32_t> indexes_ GUARDED_BY(lock_);
+};
+
+} // namespace Runtime
+} // namespace Envoy
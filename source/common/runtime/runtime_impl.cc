@@ -15,6 +15,7 @@
 #include "common/common/fmt.h"
 #include "common/common/utility.h"
 #include "common/filesystem/filesystem_impl.h"
+#include "common/runtime/key_registry.h"
 
 #include "openssl/rand.h"
 
@@ -147,12 +148,30 @@ std::string RandomGeneratorImpl::uuid() {
 
 bool SnapshotImpl::featureEnabled(const std::string& key, uint64_t default_value,
                                   uint64_t random_value, uint64_t num_buckets) const {
-  return random_value % num_buckets < std::min(getInteger(key, default_value), num_buckets);
+  return featureEnabledForValue(getInteger(key, default_value), random_value, num_buckets);
 }
 
 bool SnapshotImpl::featureEnabled(const std::string& key, uint64_t default_value) const {
+  return featureEnabledForValue(getInteger(key, default_value));
+}
+
+bool SnapshotImpl::featureEnabled(const std::string& key, uint64_t default_value,
+                                  uint64_t random_value) const {
+  return featureEnabledForValue(getInteger(key, default_value), random_value, 100);
+}
+
+bool SnapshotImpl::featureEnabled(const KeyHandle& key, uint64_t default_value) const {
+  return featureEnabledForValue(getInteger(key, default_value));
+}
+
+bool SnapshotImpl::featureEnabled(const KeyHandle& key, uint64_t default_value,
+                                  uint64_t random_value) const {
+  return featureEnabledForValue(getInteger(key, default_value), random_value, 100);
+}
+
+bool SnapshotImpl::featureEnabledForValue(uint64_t value) const {
   // Avoid PNRG if we know we don't need it.
-  uint64_t cutoff = std::min(getInteger(key, default_value), static_cast<uint64_t>(100));
+  uint64_t cutoff = std::min(value, static_cast<uint64_t>(100));
   if (cutoff == 0) {
     return false;
   } else if (cutoff == 100) {
@@ -162,9 +181,9 @@ bool SnapshotImpl::featureEnabled(const std::string& key, uint64_t default_value
   }
 }
 
-bool SnapshotImpl::featureEnabled(const std::string& key, uint64_t default_value,
-                                  uint64_t random_value) const {
-  return featureEnabled(key, default_value, random_value, 100);
+bool SnapshotImpl::featureEnabledForValue(uint64_t value, uint64_t random_value,
+                                          uint64_t num_buckets) {
+  return random_value % num_buckets < std::min(value, num_buckets);
 }
 
 const std::string& SnapshotImpl::get(const std::string& key) const {
@@ -172,31 +191,49 @@ const std::string& SnapshotImpl::get(const std::string& key) const {
   if (entry == values_.end()) {
     return EMPTY_STRING;
   } else {
-    return entry->second.string_value_;
+    return entry->second->string_value_;
   }
 }
 
 uint64_t SnapshotImpl::getInteger(const std::string& key, uint64_t default_value) const {
   auto entry = values_.find(key);
-  if (entry == values_.end() || !entry->second.uint_value_) {
+  return integerValue(entry == values_.end() ? nullptr : entry->second, default_value);
+}
+
+uint64_t SnapshotImpl::getInteger(const KeyHandle& key, uint64_t default_value) const {
+  // Every key in this snapshot was interned when it was built, so a handle with a larger index
+  // refers to a key that is absent.
+  const Snapshot::Entry* entry =
+      key.index() < values_by_index_.size() ? values_by_index_[key.index()] : nullptr;
+  return integerValue(entry, default_value);
+}
+
+uint64_t SnapshotImpl::integerValue(const Snapshot::Entry* entry, uint64_t default_value) {
+  if (entry == nullptr || !entry->uint_value_) {
     return default_value;
   } else {
-    return entry->second.uint_value_.value();
+    return entry->uint_value_.value();
   }
 }
 
-const std::vector<Snapshot::OverrideLayerConstPtr>& SnapshotImpl::getLayers() const {
+const std::vector<Snapshot::OverrideLayerConstSharedPtr>& SnapshotImpl::getLayers() const {
   return layers_;
 }
 
 SnapshotImpl::SnapshotImpl(RandomGenerator& generator, RuntimeStats& stats,
-                           std::vector<OverrideLayerConstPtr>&& layers)
+                           std::vector<OverrideLayerConstSharedPtr>&& layers)
     : layers_{std::move(layers)}, generator_{generator} {
   for (const auto& layer : layers_) {
     for (const auto& kv : layer->values()) {
-      values_.erase(kv.first);
-      values_.emplace(kv.first, kv.second);
+      values_[kv.first] = &kv.second;
+    }
+  }
+  for (const auto& kv : values_) {
+    const uint32_t index = KeyRegistry::index(kv.first);
+    if (index >= values_by_index_.size()) {
+      values_by_index_.resize(index + 1, nullptr);
     }
+    values_by_index_[index] = kv.second;
   }
   stats.num_keys_.set(values_.size());
 }
@@ -222,13 +259,35 @@ void AdminLayer::mergeValues(const std::unordered_map<std::string, std::string>&
   stats_.admin_overrides_active_.set(values_.empty() ? 0 : 1);
 }
 
+DiskLayer::FileStat::FileStat(const struct stat& stat_result)
+    : dev_(stat_result.st_dev), ino_(stat_result.st_ino), size_(stat_result.st_size) {
+#ifdef __APPLE__
+  mtime_ = stat_result.st_mtimespec;
+  ctime_ = stat_result.st_ctimespec;
+#else
+  mtime_ = stat_result.st_mtim;
+  ctime_ = stat_result.st_ctim;
+#endif
+}
+
+bool DiskLayer::FileStat::operator==(const FileStat& rhs) const {
+  return dev_ == rhs.dev_ && ino_ == rhs.ino_ && size_ == rhs.size_ &&
+         mtime_.tv_sec == rhs.mtime_.tv_sec && mtime_.tv_nsec == rhs.mtime_.tv_nsec &&
+         ctime_.tv_sec == rhs.ctime_.tv_sec && ctime_.tv_nsec == rhs.ctime_.tv_nsec;
+}
+
 DiskLayer::DiskLayer(const std::string& name, const std::string& path,
-                     Api::OsSysCalls& os_sys_calls)
+                     Api::OsSysCalls& os_sys_calls, const DiskLayer* previous)
     : OverrideLayerImpl{name}, os_sys_calls_(os_sys_calls) {
-  walkDirectory(path, "", 1);
+  walkDirectory(path, "", 1, previous);
+  unchanged_ = previous != nullptr && reused_files_ == file_stats_.size() &&
+               file_stats_.size() == previous->file_stats_.size();
+  ENVOY_LOG(debug, "loaded {} runtime files from {}, {} unchanged", file_stats_.size(), path,
+            reused_files_);
 }
 
-void DiskLayer::walkDirectory(const std::string& path, const std::string& prefix, uint32_t depth) {
+void DiskLayer::walkDirectory(const std::string& path, const std::string& prefix, uint32_t depth,
+                              const DiskLayer* previous) {
   ENVOY_LOG(debug, "walking directory: {}", path);
   if (depth > MaxWalkDepth) {
     throw EnvoyException(fmt::format("Walk recursion depth exceded {}", MaxWalkDepth));
@@ -265,8 +324,25 @@ void DiskLayer::walkDirectory(const std::string& path, const std::string& prefix
 
     if (S_ISDIR(stat_result.st_mode) && std::string(entry->d_name) != "." &&
         std::string(entry->d_name) != "..") {
-      walkDirectory(full_path, full_prefix, depth + 1);
+      walkDirectory(full_path, full_prefix, depth + 1, previous);
     } else if (S_ISREG(stat_result.st_mode)) {
+      const FileStat file_stat(stat_result);
+      file_stats_.erase(full_prefix);
+      file_stats_.emplace(full_prefix, file_stat);
+
+      // The previous value still holds if the very same file was not modified since it was read.
+      if (previous != nullptr) {
+        const auto previous_stat = previous->file_stats_.find(full_prefix);
+        const auto previous_value = previous->values_.find(full_prefix);
+        if (previous_stat != previous->file_stats_.end() && previous_stat->second == file_stat &&
+            previous_value != previous->values_.end()) {
+          values_.erase(full_prefix);
+          values_.insert({full_prefix, previous_value->second});
+          reused_files_++;
+          continue;
+        }
+      }
+
       // Suck the file into a string. This is not very efficient but it should be good enough
       // for small files. Also, as noted elsewhere, none of this is non-blocking which could
       // theoretically lead to issues.
@@ -305,25 +381,30 @@ LoaderImpl::LoaderImpl(RandomGenerator& generator, Stats::Store& store,
 LoaderImpl::LoaderImpl(DoNotLoadSnapshot /* unused */, RandomGenerator& generator,
                        Stats::Store& store, ThreadLocal::SlotAllocator& tls)
     : generator_(generator), stats_(generateStats(store)), admin_layer_(stats_),
-      tls_(tls.allocateSlot()) {}
+      snapshot_(tls) {}
 
 std::unique_ptr<SnapshotImpl> LoaderImpl::createNewSnapshot() {
-  std::vector<Snapshot::OverrideLayerConstPtr> layers;
-  layers.emplace_back(std::make_unique<const AdminLayer>(admin_layer_));
+  std::vector<Snapshot::OverrideLayerConstSharedPtr> layers;
+  layers.emplace_back(adminLayerSnapshot());
   return std::make_unique<SnapshotImpl>(generator_, stats_, std::move(layers));
 }
 
+Snapshot::OverrideLayerConstSharedPtr LoaderImpl::adminLayerSnapshot() {
+  if (admin_layer_snapshot_ == nullptr) {
+    admin_layer_snapshot_ = std::make_shared<const AdminLayer>(admin_layer_);
+  }
+  return admin_layer_snapshot_;
+}
+
 void LoaderImpl::loadNewSnapshot() {
-  ThreadLocal::ThreadLocalObjectSharedPtr ptr = createNewSnapshot();
-  tls_->set([ptr = std::move(ptr)](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
-    return ptr;
-  });
+  snapshot_.publish(createNewSnapshot());
 }
 
-Snapshot& LoaderImpl::snapshot() { return tls_->getTyped<Snapshot>(); }
+Snapshot& LoaderImpl::snapshot() { return *snapshot_.get(); }
 
 void LoaderImpl::mergeValues(const std::unordered_map<std::string, std::string>& values) {
   admin_layer_.mergeValues(values);
+  admin_layer_snapshot_.reset();
   loadNewSnapshot();
 }
 
@@ -352,23 +433,36 @@ RuntimeStats LoaderImpl::generateStats(Stats::Store& store) {
 }
 
 std::unique_ptr<SnapshotImpl> DiskBackedLoaderImpl::createNewSnapshot() {
-  std::vector<Snapshot::OverrideLayerConstPtr> layers;
+  std::vector<Snapshot::OverrideLayerConstSharedPtr> layers;
   try {
-    layers.push_back(std::make_unique<DiskLayer>("root", root_path_, *os_sys_calls_));
+    root_layer_ = loadDiskLayer("root", root_path_, root_layer_);
+    layers.push_back(root_layer_);
     if (Filesystem::directoryExists(override_path_)) {
-      layers.push_back(std::make_unique<DiskLayer>("override", override_path_, *os_sys_calls_));
+      override_layer_ = loadDiskLayer("override", override_path_, override_layer_);
+      layers.push_back(override_layer_);
       stats_.override_dir_exists_.inc();
     } else {
+      override_layer_.reset();
       stats_.override_dir_not_exists_.inc();
     }
   } catch (EnvoyException& e) {
     layers.clear();
+    root_layer_.reset();
+    override_layer_.reset();
     stats_.load_error_.inc();
     ENVOY_LOG(debug, "error loading runtime values from disk: {}", e.what());
   }
-  layers.push_back(std::make_unique<AdminLayer>(admin_layer_));
+  layers.push_back(adminLayerSnapshot());
   return std::make_unique<SnapshotImpl>(generator_, stats_, std::move(layers));
 }
 
+std::shared_ptr<const DiskLayer>
+DiskBackedLoaderImpl::loadDiskLayer(const std::string& name, const std::string& path,
+                                    const std::shared_ptr<const DiskLayer>& previous) {
+  auto layer = std::make_shared<const DiskLayer>(name, path, *os_sys_calls_, previous.get());
+  // Keep sharing the previous layer, and its entries, with the new snapshot if nothing changed.
+  return layer->unchanged() ? previous : layer;
+}
+
 } // namespace Runtime
 } // namespace Envoy
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <dirent.h>
+#include <sys/stat.h>
 
 #include <cstdint>
 #include <memory>
@@ -17,6 +18,7 @@
 #include "common/common/empty_string.h"
 #include "common/common/logger.h"
 #include "common/common/thread.h"
+#include "common/thread_local/snapshot_slot.h"
 
 #include "spdlog/spdlog.h"
 
@@ -57,12 +59,13 @@ struct RuntimeStats {
 };
 
 /**
- * Implementation of Snapshot whose source is the vector of layers passed to the constructor.
+ * Implementation of Snapshot whose source is the vector of layers passed to the constructor. The
+ * snapshot references the entries of its layers rather than copying them.
  */
 class SnapshotImpl : public Snapshot, public ThreadLocal::ThreadLocalObject {
 public:
   SnapshotImpl(RandomGenerator& generator, RuntimeStats& stats,
-               std::vector<OverrideLayerConstPtr>&& layers);
+               std::vector<OverrideLayerConstSharedPtr>&& layers);
 
   // Runtime::Snapshot
   bool featureEnabled(const std::string& key, uint64_t default_value, uint64_t random_value,
@@ -70,15 +73,26 @@ public:
   bool featureEnabled(const std::string& key, uint64_t default_value) const override;
   bool featureEnabled(const std::string& key, uint64_t default_value,
                       uint64_t random_value) const override;
+  bool featureEnabled(const KeyHandle& key, uint64_t default_value) const override;
+  bool featureEnabled(const KeyHandle& key, uint64_t default_value,
+                      uint64_t random_value) const override;
   const std::string& get(const std::string& key) const override;
   uint64_t getInteger(const std::string& key, uint64_t default_value) const override;
-  const std::vector<OverrideLayerConstPtr>& getLayers() const override;
+  uint64_t getInteger(const KeyHandle& key, uint64_t default_value) const override;
+  const std::vector<OverrideLayerConstSharedPtr>& getLayers() const override;
 
   static Entry createEntry(const std::string& value);
 
 private:
-  const std::vector<OverrideLayerConstPtr> layers_;
-  std::unordered_map<std::string, const Snapshot::Entry> values_;
+  bool featureEnabledForValue(uint64_t value) const;
+  static bool featureEnabledForValue(uint64_t value, uint64_t random_value, uint64_t num_buckets);
+  static uint64_t integerValue(const Snapshot::Entry* entry, uint64_t default_value);
+
+  const std::vector<OverrideLayerConstSharedPtr> layers_;
+  // The entry of each key in the topmost layer that has it.
+  std::unordered_map<std::string, const Snapshot::Entry*> values_;
+  // Entries of values_ by the index their key is interned to in the KeyRegistry, or nullptr.
+  std::vector<const Snapshot::Entry*> values_by_index_;
   RandomGenerator& generator_;
 };
 
@@ -128,9 +142,33 @@ private:
  */
 class DiskLayer : public OverrideLayerImpl, Logger::Loggable<Logger::Id::runtime> {
 public:
-  DiskLayer(const std::string& name, const std::string& path, Api::OsSysCalls& os_sys_calls);
+  /**
+   * @param previous supplies the layer previously loaded with the same name, if any. Files whose
+   *        stat is unchanged since then keep their previous value without being read again.
+   */
+  DiskLayer(const std::string& name, const std::string& path, Api::OsSysCalls& os_sys_calls,
+            const DiskLayer* previous = nullptr);
+
+  /**
+   * @return bool whether the layer holds the same files as the previous layer it was loaded with,
+   *         none of which changed.
+   */
+  bool unchanged() const { return unchanged_; }
 
 private:
+  // The stat identity of a file as of its last read.
+  struct FileStat {
+    explicit FileStat(const struct stat& stat_result);
+
+    bool operator==(const FileStat& rhs) const;
+
+    dev_t dev_;
+    ino_t ino_;
+    off_t size_;
+    struct timespec mtime_;
+    struct timespec ctime_;
+  };
+
   struct Directory {
     Directory(const std::string& path) {
       dir_ = opendir(path.c_str());
@@ -144,10 +182,14 @@ private:
     DIR* dir_;
   };
 
-  void walkDirectory(const std::string& path, const std::string& prefix, uint32_t depth);
+  void walkDirectory(const std::string& path, const std::string& prefix, uint32_t depth,
+                     const DiskLayer* previous);
 
   const std::string path_;
   Api::OsSysCalls& os_sys_calls_;
+  std::unordered_map<std::string, FileStat> file_stats_;
+  uint64_t reused_files_{};
+  bool unchanged_{};
   // Maximum recursion depth for walkDirectory().
   const uint32_t MaxWalkDepth = 16;
 };
@@ -176,8 +218,10 @@ protected:
 
   // Create a new Snapshot
   virtual std::unique_ptr<SnapshotImpl> createNewSnapshot();
-  // Load a new Snapshot into TLS
+  // Publish a new Snapshot to all threads
   void loadNewSnapshot();
+  // A copy of the admin layer, shared by the snapshots until the next mergeValues().
+  Snapshot::OverrideLayerConstSharedPtr adminLayerSnapshot();
 
   RandomGenerator& generator_;
   RuntimeStats stats_;
@@ -186,7 +230,9 @@ protected:
 private:
   RuntimeStats generateStats(Stats::Store& store);
 
-  ThreadLocal::SlotPtr tls_;
+  Snapshot::OverrideLayerConstSharedPtr admin_layer_snapshot_;
+
+  ThreadLocal::SnapshotSlot<Snapshot> snapshot_;
 };
 
 /**
@@ -202,11 +248,16 @@ public:
 
 private:
   std::unique_ptr<SnapshotImpl> createNewSnapshot() override;
+  std::shared_ptr<const DiskLayer> loadDiskLayer(const std::string& name, const std::string& path,
+                                                 const std::shared_ptr<const DiskLayer>& previous);
 
   const Filesystem::WatcherPtr watcher_;
   const std::string root_path_;
   const std::string override_path_;
   const Api::OsSysCallsPtr os_sys_calls_;
+  // The disk layers of the current snapshot, reused by the next one when unchanged.
+  std::shared_ptr<const DiskLayer> root_layer_;
+  std::shared_ptr<const DiskLayer> override_layer_;
 };
 
 } // namespace Runtime
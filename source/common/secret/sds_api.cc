@@ -35,7 +35,8 @@ void SdsApi::initialize(std::function<void()> callback) {
       sds_config_, local_info_, dispatcher_, cluster_manager_, random_, stats_,
       /* rest_legacy_constructor */ nullptr,
       "envoy.service.discovery.v2.SecretDiscoveryService.FetchSecrets",
-      "envoy.service.discovery.v2.SecretDiscoveryService.StreamSecrets");
+      "envoy.service.discovery.v2.SecretDiscoveryService.StreamSecrets",
+      /* incremental_grpc_method */ "");
   Config::Utility::checkLocalInfo("sds", local_info_);
 
   subscription_->start({sds_config_name_}, *this);
@@ -60,11 +61,9 @@ void SdsApi::onConfigUpdate(const ResourceVector& resources, const std::string&)
   }
 
   const uint64_t new_hash = MessageUtil::hash(secret);
-  if (new_hash != secret_hash_ &&
-      secret.type_case() == envoy::api::v2::auth::Secret::TypeCase::kTlsCertificate) {
+  if (new_hash != secret_hash_ && secret.type_case() == secretType()) {
     secret_hash_ = new_hash;
-    tls_certificate_secrets_ =
-        std::make_unique<Ssl::TlsCertificateConfigImpl>(secret.tls_certificate());
+    setSecret(secret);
 
     update_callback_manager_.runCallbacks();
   }
@@ -72,6 +71,13 @@ void SdsApi::onConfigUpdate(const ResourceVector& resources, const std::string&)
   runInitializeCallbackIfAny();
 }
 
+void SdsApi::onIncrementalConfigUpdate(
+    const ResourceVector&, const Protobuf::RepeatedPtrField<ProtobufTypes::String>&,
+    const std::string&) {
+  // There is no incremental xDS API for this resource type, see SubscriptionFactory.
+  NOT_REACHED_GCOVR_EXCL_LINE;
+}
+
 void SdsApi::onConfigUpdateFailed(const EnvoyException*) {
   // We need to allow server startup to continue, even if we have a bad config.
   runInitializeCallbackIfAny();
@@ -84,5 +90,15 @@ void SdsApi::runInitializeCallbackIfAny() {
   }
 }
 
+void TlsCertificateSdsApi::setSecret(const envoy::api::v2::auth::Secret& secret) {
+  tls_certificate_secrets_ =
+      std::make_unique<Ssl::TlsCertificateConfigImpl>(secret.tls_certificate());
+}
+
+void TlsSessionTicketKeysSdsApi::setSecret(const envoy::api::v2::auth::Secret& secret) {
+  session_ticket_keys_ =
+      std::make_unique<envoy::api::v2::auth::TlsSessionTicketKeys>(secret.session_ticket_keys());
+}
+
 } // namespace Secret
 } // namespace Envoy
@@ -21,10 +21,10 @@ namespace Envoy {
 namespace Secret {
 
 /**
- * SDS API implementation that fetches secrets from SDS server via Subscription.
+ * SDS API implementation that fetches secrets from SDS server via Subscription. Subclasses hold
+ * the secret of each kind.
  */
 class SdsApi : public Init::Target,
-               public TlsCertificateConfigProvider,
                public Config::SubscriptionCallbacks<envoy::api::v2::auth::Secret> {
 public:
   SdsApi(const LocalInfo::LocalInfo& local_info, Event::Dispatcher& dispatcher,
@@ -32,25 +32,35 @@ public:
          Upstream::ClusterManager& cluster_manager, Init::Manager& init_manager,
          const envoy::api::v2::core::ConfigSource& sds_config, std::string sds_config_name,
          std::function<void()> destructor_cb);
+  virtual ~SdsApi() {}
 
   // Init::Target
   void initialize(std::function<void()> callback) override;
+  std::string name() const override { return "sds " + sds_config_name_; }
 
   // Config::SubscriptionCallbacks
   void onConfigUpdate(const ResourceVector& resources, const std::string& version_info) override;
+  void onIncrementalConfigUpdate(
+      const ResourceVector& added_resources,
+      const Protobuf::RepeatedPtrField<ProtobufTypes::String>& removed_resources,
+      const std::string& system_version_info) override;
   void onConfigUpdateFailed(const EnvoyException* e) override;
   std::string resourceName(const ProtobufWkt::Any& resource) override {
     return MessageUtil::anyConvert<envoy::api::v2::auth::Secret>(resource).name();
   }
 
-  // SecretProvider
-  const Ssl::TlsCertificateConfig* secret() const override {
-    return tls_certificate_secrets_.get();
-  }
+protected:
+  /**
+   * @return the kind of secret held by the subclass. Secrets of other kinds are ignored.
+   */
+  virtual envoy::api::v2::auth::Secret::TypeCase secretType() const PURE;
 
-  Common::CallbackHandle* addUpdateCallback(std::function<void()> callback) override {
-    return update_callback_manager_.add(callback);
-  }
+  /**
+   * Replace the held secret with that of an updated secret of the kind of the subclass.
+   */
+  virtual void setSecret(const envoy::api::v2::auth::Secret& secret) PURE;
+
+  Common::CallbackManager<> update_callback_manager_;
 
 private:
   void runInitializeCallbackIfAny();
@@ -68,11 +78,60 @@ private:
 
   uint64_t secret_hash_;
   Cleanup clean_up_;
+};
+
+/**
+ * SDS API implementation for TLS certificates.
+ */
+class TlsCertificateSdsApi : public SdsApi, public TlsCertificateConfigProvider {
+public:
+  using SdsApi::SdsApi;
+
+  // SecretProvider
+  const Ssl::TlsCertificateConfig* secret() const override {
+    return tls_certificate_secrets_.get();
+  }
+  Common::CallbackHandle* addUpdateCallback(std::function<void()> callback) override {
+    return update_callback_manager_.add(callback);
+  }
+
+protected:
+  // SdsApi
+  envoy::api::v2::auth::Secret::TypeCase secretType() const override {
+    return envoy::api::v2::auth::Secret::TypeCase::kTlsCertificate;
+  }
+  void setSecret(const envoy::api::v2::auth::Secret& secret) override;
+
+private:
   Ssl::TlsCertificateConfigPtr tls_certificate_secrets_;
-  Common::CallbackManager<> update_callback_manager_;
 };
 
-typedef std::unique_ptr<SdsApi> SdsApiPtr;
+/**
+ * SDS API implementation for TLS session ticket keys, so that the keys can be rotated without
+ * restarting and shared by the instances resuming each other's sessions.
+ */
+class TlsSessionTicketKeysSdsApi : public SdsApi, public TlsSessionTicketKeysConfigProvider {
+public:
+  using SdsApi::SdsApi;
+
+  // SecretProvider
+  const envoy::api::v2::auth::TlsSessionTicketKeys* secret() const override {
+    return session_ticket_keys_.get();
+  }
+  Common::CallbackHandle* addUpdateCallback(std::function<void()> callback) override {
+    return update_callback_manager_.add(callback);
+  }
+
+protected:
+  // SdsApi
+  envoy::api::v2::auth::Secret::TypeCase secretType() const override {
+    return envoy::api::v2::auth::Secret::TypeCase::kSessionTicketKeys;
+  }
+  void setSecret(const envoy::api::v2::auth::Secret& secret) override;
+
+private:
+  std::unique_ptr<envoy::api::v2::auth::TlsSessionTicketKeys> session_ticket_keys_;
+};
 
 } // namespace Secret
 } // namespace Envoy
@@ -23,6 +23,9 @@ public:
   CertificateValidationContextConfigProviderSharedPtr
   findStaticCertificateValidationContextProvider(const std::string& name) const override;
 
+  TlsSessionTicketKeysConfigProviderSharedPtr
+  findStaticTlsSessionTicketKeysProvider(const std::string& name) const override;
+
   TlsCertificateConfigProviderSharedPtr createInlineTlsCertificateProvider(
       const envoy::api::v2::auth::TlsCertificate& tls_certificate) override;
 
@@ -35,9 +38,17 @@ public:
       const envoy::api::v2::core::ConfigSource& config_source, const std::string& config_name,
       Server::Configuration::TransportSocketFactoryContext& secret_provider_context) override;
 
+  TlsSessionTicketKeysConfigProviderSharedPtr findOrCreateTlsSessionTicketKeysProvider(
+      const envoy::api::v2::core::ConfigSource& config_source, const std::string& config_name,
+      Server::Configuration::TransportSocketFactoryContext& secret_provider_context) override;
+
 private:
-  // Remove dynamic secret provider which has been deleted.
-  void removeDynamicSecretProvider(const std::string& map_key);
+  // Find or create the SdsApi of a kind of secret, tracked by providers.
+  template <class SdsApiType, class ProviderType>
+  std::shared_ptr<ProviderType> findOrCreateDynamicSecretProvider(
+      std::unordered_map<std::string, std::weak_ptr<ProviderType>>& providers,
+      const envoy::api::v2::core::ConfigSource& sds_config_source, const std::string& config_name,
+      Server::Configuration::TransportSocketFactoryContext& secret_provider_context);
 
   // Manages pairs of secret name and TlsCertificateConfigProviderSharedPtr.
   std::unordered_map<std::string, TlsCertificateConfigProviderSharedPtr>
@@ -47,9 +58,15 @@ private:
   std::unordered_map<std::string, CertificateValidationContextConfigProviderSharedPtr>
       static_certificate_validation_context_providers_;
 
+  // Manages pairs of secret name and TlsSessionTicketKeysConfigProviderSharedPtr.
+  std::unordered_map<std::string, TlsSessionTicketKeysConfigProviderSharedPtr>
+      static_session_ticket_keys_providers_;
+
   // map hash code of SDS config source and SdsApi object.
   std::unordered_map<std::string, std::weak_ptr<TlsCertificateConfigProvider>>
-      dynamic_secret_providers_;
+      dynamic_tls_certificate_providers_;
+  std::unordered_map<std::string, std::weak_ptr<TlsSessionTicketKeysConfigProvider>>
+      dynamic_session_ticket_keys_providers_;
 };
 
 } // namespace Secret
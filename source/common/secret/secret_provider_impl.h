@@ -38,5 +38,21 @@ private:
   Ssl::CertificateValidationContextConfigPtr certificate_validation_context_;
 };
 
+class TlsSessionTicketKeysConfigProviderImpl : public TlsSessionTicketKeysConfigProvider {
+public:
+  TlsSessionTicketKeysConfigProviderImpl(
+      const envoy::api::v2::auth::TlsSessionTicketKeys& session_ticket_keys)
+      : session_ticket_keys_(session_ticket_keys) {}
+
+  const envoy::api::v2::auth::TlsSessionTicketKeys* secret() const override {
+    return &session_ticket_keys_;
+  }
+
+  Common::CallbackHandle* addUpdateCallback(std::function<void()>) override { return nullptr; }
+
+private:
+  const envoy::api::v2::auth::TlsSessionTicketKeys session_ticket_keys_;
+};
+
 } // namespace Secret
 } // namespace Envoy
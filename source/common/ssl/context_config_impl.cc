@@ -70,6 +70,34 @@ getCertificateValidationContextConfigProvider(
   return nullptr;
 }
 
+Secret::TlsSessionTicketKeysConfigProviderSharedPtr getTlsSessionTicketKeysConfigProvider(
+    const envoy::api::v2::auth::DownstreamTlsContext& config,
+    Server::Configuration::TransportSocketFactoryContext& factory_context) {
+  switch (config.session_ticket_keys_type_case()) {
+  case envoy::api::v2::auth::DownstreamTlsContext::kSessionTicketKeys:
+  case envoy::api::v2::auth::DownstreamTlsContext::SESSION_TICKET_KEYS_TYPE_NOT_SET:
+    return nullptr;
+  case envoy::api::v2::auth::DownstreamTlsContext::kSessionTicketKeysSdsSecretConfig: {
+    const auto& sds_secret_config = config.session_ticket_keys_sds_secret_config();
+    if (!sds_secret_config.has_sds_config()) {
+      // static secret
+      auto secret_provider = factory_context.secretManager().findStaticTlsSessionTicketKeysProvider(
+          sds_secret_config.name());
+      if (!secret_provider) {
+        throw EnvoyException(
+            fmt::format("Unknown static session ticket keys: {}", sds_secret_config.name()));
+      }
+      return secret_provider;
+    }
+    return factory_context.secretManager().findOrCreateTlsSessionTicketKeysProvider(
+        sds_secret_config.sds_config(), sds_secret_config.name(), factory_context);
+  }
+  default:
+    throw EnvoyException(fmt::format("Unexpected case for oneof session_ticket_keys: {}",
+                                     config.session_ticket_keys_type_case()));
+  }
+}
+
 } // namespace
 
 const std::string ContextConfigImpl::DEFAULT_CIPHER_SUITES =
@@ -166,32 +194,61 @@ ServerContextConfigImpl::ServerContextConfigImpl(
     : ContextConfigImpl(config.common_tls_context(), factory_context),
       require_client_certificate_(
           PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, require_client_certificate, false)),
-      session_ticket_keys_([&config] {
-        std::vector<SessionTicketKey> ret;
-
-        switch (config.session_ticket_keys_type_case()) {
-        case envoy::api::v2::auth::DownstreamTlsContext::kSessionTicketKeys:
-          for (const auto& datasource : config.session_ticket_keys().keys()) {
-            validateAndAppendKey(ret, Config::DataSource::read(datasource, false));
-          }
-          break;
-        case envoy::api::v2::auth::DownstreamTlsContext::kSessionTicketKeysSdsSecretConfig:
-          throw EnvoyException("SDS not supported yet");
-          break;
-        case envoy::api::v2::auth::DownstreamTlsContext::SESSION_TICKET_KEYS_TYPE_NOT_SET:
-          break;
-        default:
-          throw EnvoyException(fmt::format("Unexpected case for oneof session_ticket_keys: {}",
-                                           config.session_ticket_keys_type_case()));
-        }
-
-        return ret;
-      }()) {
+      session_ticket_keys_provider_(
+          getTlsSessionTicketKeysConfigProvider(config, factory_context)) {
   // TODO(PiotrSikora): Support multiple TLS certificates.
   if ((config.common_tls_context().tls_certificates().size() +
        config.common_tls_context().tls_certificate_sds_secret_configs().size()) != 1) {
     throw EnvoyException("A single TLS certificate is required for server contexts");
   }
+
+  if (config.has_session_ticket_keys()) {
+    session_ticket_keys_ = getSessionTicketKeys(config.session_ticket_keys());
+  } else if (session_ticket_keys_provider_ != nullptr) {
+    if (session_ticket_keys_provider_->secret() != nullptr) {
+      session_ticket_keys_ = getSessionTicketKeys(*session_ticket_keys_provider_->secret());
+    }
+    // Registered ahead of the callback of setSecretUpdateCallback(), so that contexts created
+    // upon an update use the updated keys.
+    session_ticket_keys_update_callback_handle_ =
+        session_ticket_keys_provider_->addUpdateCallback([this]() {
+          session_ticket_keys_ = getSessionTicketKeys(*session_ticket_keys_provider_->secret());
+        });
+  }
+}
+
+ServerContextConfigImpl::~ServerContextConfigImpl() {
+  if (session_ticket_keys_update_callback_handle_) {
+    session_ticket_keys_update_callback_handle_->remove();
+  }
+  if (session_ticket_keys_secret_update_callback_handle_) {
+    session_ticket_keys_secret_update_callback_handle_->remove();
+  }
+}
+
+bool ServerContextConfigImpl::isReady() const {
+  return ContextConfigImpl::isReady() &&
+         (!session_ticket_keys_provider_ || session_ticket_keys_provider_->secret() != nullptr);
+}
+
+void ServerContextConfigImpl::setSecretUpdateCallback(std::function<void()> callback) {
+  ContextConfigImpl::setSecretUpdateCallback(callback);
+  if (session_ticket_keys_provider_) {
+    if (session_ticket_keys_secret_update_callback_handle_) {
+      session_ticket_keys_secret_update_callback_handle_->remove();
+    }
+    session_ticket_keys_secret_update_callback_handle_ =
+        session_ticket_keys_provider_->addUpdateCallback(callback);
+  }
+}
+
+std::vector<ServerContextConfig::SessionTicketKey> ServerContextConfigImpl::getSessionTicketKeys(
+    const envoy::api::v2::auth::TlsSessionTicketKeys& keys) {
+  std::vector<SessionTicketKey> ret;
+  for (const auto& datasource : keys.keys()) {
+    validateAndAppendKey(ret, Config::DataSource::read(datasource, false));
+  }
+  return ret;
 }
 
 ServerContextConfigImpl::ServerContextConfigImpl(
@@ -102,6 +102,11 @@ public:
   explicit ServerContextConfigImpl(
       const Json::Object& config,
       Server::Configuration::TransportSocketFactoryContext& secret_provider_context);
+  ~ServerContextConfigImpl() override;
+
+  // Ssl::ContextConfig
+  bool isReady() const override;
+  void setSecretUpdateCallback(std::function<void()> callback) override;
 
   // Ssl::ServerContextConfig
   bool requireClientCertificate() const override { return require_client_certificate_; }
@@ -111,8 +116,15 @@ public:
 
 private:
   const bool require_client_certificate_;
-  const std::vector<SessionTicketKey> session_ticket_keys_;
-
+  // Session ticket keys delivered by SDS or a static secret, so that they can be rotated and
+  // shared across Envoy instances. nullptr if the keys are inline.
+  Secret::TlsSessionTicketKeysConfigProviderSharedPtr session_ticket_keys_provider_;
+  Common::CallbackHandle* session_ticket_keys_update_callback_handle_{};
+  Common::CallbackHandle* session_ticket_keys_secret_update_callback_handle_{};
+  std::vector<SessionTicketKey> session_ticket_keys_;
+
+  static std::vector<SessionTicketKey>
+  getSessionTicketKeys(const envoy::api::v2::auth::TlsSessionTicketKeys& keys);
   static void validateAndAppendKey(std::vector<ServerContextConfig::SessionTicketKey>& keys,
                                    const std::string& key_data);
 };
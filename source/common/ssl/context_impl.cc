@@ -11,13 +11,16 @@
 
 #include "common/common/assert.h"
 #include "common/common/base64.h"
+#include "common/common/empty_string.h"
 #include "common/common/fmt.h"
 #include "common/common/hex.h"
+#include "common/common/lock_guard.h"
 #include "common/common/utility.h"
 #include "common/ssl/utility.h"
 
 #include "openssl/hmac.h"
 #include "openssl/rand.h"
+#include "openssl/sha.h"
 #include "openssl/x509v3.h"
 
 namespace Envoy {
@@ -25,72 +28,132 @@ namespace Ssl {
 
 int ContextImpl::sslContextIndex() {
   CONSTRUCT_ON_FIRST_USE(int, []() -> int {
-    int ssl_context_index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+    int ssl_context_index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
     RELEASE_ASSERT(ssl_context_index >= 0, "");
     return ssl_context_index;
   }());
 }
 
-ContextImpl::ContextImpl(Stats::Scope& scope, const ContextConfig& config)
-    : ctx_(SSL_CTX_new(TLS_method())), scope_(scope), stats_(generateStats(scope)) {
-  RELEASE_ASSERT(ctx_, "");
+TrustedCaImpl::TrustedCaImpl(const std::string& ca_cert) {
+  bssl::UniquePtr<BIO> bio(BIO_new_mem_buf(const_cast<char*>(ca_cert.data()), ca_cert.size()));
+  RELEASE_ASSERT(bio != nullptr, "");
+  // Based on BoringSSL's X509_load_cert_crl_file().
+  items_.reset(PEM_X509_INFO_read_bio(bio.get(), nullptr, nullptr, nullptr));
+  if (items_ == nullptr) {
+    return;
+  }
 
-  int rc = SSL_CTX_set_ex_data(ctx_.get(), sslContextIndex(), this);
-  RELEASE_ASSERT(rc == 1, "");
+  store_.reset(X509_STORE_new());
+  RELEASE_ASSERT(store_ != nullptr, "");
+  addToStore(store_.get());
+}
 
-  rc = SSL_CTX_set_min_proto_version(ctx_.get(), config.minProtocolVersion());
-  RELEASE_ASSERT(rc == 1, "");
+void TrustedCaImpl::addToStore(X509_STORE* store) const {
+  // The store takes its own references, so the parsed certificates can be shared.
+  for (const X509_INFO* item : items_.get()) {
+    if (item->x509) {
+      X509_STORE_add_cert(store, item->x509);
+    }
+    if (item->crl) {
+      X509_STORE_add_crl(store, item->crl);
+    }
+  }
+}
 
-  rc = SSL_CTX_set_max_proto_version(ctx_.get(), config.maxProtocolVersion());
-  RELEASE_ASSERT(rc == 1, "");
+std::string CertificateVerificationCache::fingerprint(X509* cert, const STACK_OF(X509) * chain) {
+  SHA256_CTX sha256;
+  SHA256_Init(&sha256);
+  const auto update = [&sha256](X509* x509) {
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+    unsigned int n;
+    X509_digest(x509, EVP_sha256(), digest, &n);
+    RELEASE_ASSERT(n == sizeof(digest), "");
+    SHA256_Update(&sha256, digest, n);
+  };
+
+  if (cert != nullptr) {
+    update(cert);
+  }
+  if (chain != nullptr) {
+    for (X509* x509 : chain) {
+      update(x509);
+    }
+  }
 
-  if (!SSL_CTX_set_strict_cipher_list(ctx_.get(), config.cipherSuites().c_str())) {
-    std::vector<absl::string_view> ciphers =
-        StringUtil::splitToken(config.cipherSuites(), ":+-![|]", false);
-    std::vector<std::string> bad_ciphers;
-    for (const auto& cipher : ciphers) {
-      std::string cipher_str(cipher);
-      if (!SSL_CTX_set_strict_cipher_list(ctx_.get(), cipher_str.c_str())) {
-        bad_ciphers.push_back(cipher_str);
+  std::string fingerprint(SHA256_DIGEST_LENGTH, 0);
+  SHA256_Final(reinterpret_cast<uint8_t*>(&fingerprint[0]), &sha256);
+  return fingerprint;
+}
+
+bool CertificateVerificationCache::lookup(const std::string& fingerprint) {
+  Thread::LockGuard lock(lock_);
+  auto it = index_.find(fingerprint);
+  if (it == index_.end()) {
+    return false;
+  }
+
+  if (X509_cmp_current_time(X509_get_notAfter(it->second->first_to_expire_.get())) <= 0) {
+    entries_.erase(it->second);
+    index_.erase(it);
+    return false;
+  }
+
+  entries_.splice(entries_.begin(), entries_, it->second);
+  return true;
+}
+
+void CertificateVerificationCache::insert(const std::string& fingerprint, X509* cert,
+                                          const STACK_OF(X509) * verified_chain) {
+  X509* first_to_expire = cert;
+  if (verified_chain != nullptr) {
+    for (X509* x509 : verified_chain) {
+      int days, seconds;
+      if (first_to_expire == nullptr ||
+          (ASN1_TIME_diff(&days, &seconds, X509_get_notAfter(first_to_expire),
+                          X509_get_notAfter(x509)) &&
+           (days < 0 || seconds < 0))) {
+        first_to_expire = x509;
       }
     }
-    throw EnvoyException(fmt::format("Failed to initialize cipher suites {}. The following "
-                                     "ciphers were rejected when tried individually: {}",
-                                     config.cipherSuites(), StringUtil::join(bad_ciphers, ", ")));
   }
 
-  if (!SSL_CTX_set1_curves_list(ctx_.get(), config.ecdhCurves().c_str())) {
-    throw EnvoyException(fmt::format("Failed to initialize ECDH curves {}", config.ecdhCurves()));
+  // Chains which are accepted while expired, as allowed by the config, are not cached.
+  if (first_to_expire == nullptr ||
+      X509_cmp_current_time(X509_get_notAfter(first_to_expire)) <= 0) {
+    return;
+  }
+
+  Thread::LockGuard lock(lock_);
+  if (index_.find(fingerprint) != index_.end()) {
+    return;
   }
 
+  X509_up_ref(first_to_expire);
+  entries_.push_front({fingerprint, bssl::UniquePtr<X509>(first_to_expire)});
+  index_[fingerprint] = entries_.begin();
+  if (entries_.size() > max_entries_) {
+    index_.erase(entries_.back().fingerprint_);
+    entries_.pop_back();
+  }
+}
+
+ContextImpl::ContextImpl(Stats::Scope& scope, const ContextConfig& config,
+                         TrustedCaImplConstSharedPtr trusted_ca, bssl::UniquePtr<SSL_CTX> ctx)
+    : ctx_(std::move(ctx)), shared_ctx_(ctx_ != nullptr), scope_(scope),
+      stats_(generateStats(scope)), trusted_ca_(trusted_ca) {
   int verify_mode = SSL_VERIFY_NONE;
   if (config.certificateValidationContext() != nullptr &&
       !config.certificateValidationContext()->caCert().empty()) {
     ca_file_path_ = config.certificateValidationContext()->caCertPath();
-    bssl::UniquePtr<BIO> bio(
-        BIO_new_mem_buf(const_cast<char*>(config.certificateValidationContext()->caCert().data()),
-                        config.certificateValidationContext()->caCert().size()));
-    RELEASE_ASSERT(bio != nullptr, "");
-    // Based on BoringSSL's X509_load_cert_crl_file().
-    bssl::UniquePtr<STACK_OF(X509_INFO)> list(
-        PEM_X509_INFO_read_bio(bio.get(), nullptr, nullptr, nullptr));
-    if (list == nullptr) {
-      throw EnvoyException(fmt::format("Failed to load trusted CA certificates from {}",
-                                       config.certificateValidationContext()->caCertPath()));
-    }
-
-    X509_STORE* store = SSL_CTX_get_cert_store(ctx_.get());
-    for (const X509_INFO* item : list.get()) {
-      if (item->x509) {
-        X509_STORE_add_cert(store, item->x509);
-        if (ca_cert_ == nullptr) {
+    ASSERT(trusted_ca_ != nullptr);
+    if (trusted_ca_->items() != nullptr) {
+      for (const X509_INFO* item : trusted_ca_->items()) {
+        if (item->x509) {
           X509_up_ref(item->x509);
           ca_cert_.reset(item->x509);
+          break;
         }
       }
-      if (item->crl) {
-        X509_STORE_add_crl(store, item->crl);
-      }
     }
     if (ca_cert_ == nullptr) {
       throw EnvoyException(fmt::format("Failed to load trusted CA certificates from {}",
@@ -98,41 +161,7 @@ ContextImpl::ContextImpl(Stats::Scope& scope, const ContextConfig& config)
     }
     verify_mode = SSL_VERIFY_PEER;
     verify_trusted_ca_ = true;
-
-    // NOTE: We're using SSL_CTX_set_cert_verify_callback() instead of X509_verify_cert()
-    // directly. However, our new callback is still calling X509_verify_cert() under
-    // the hood. Therefore, to ignore cert expiration, we need to set the callback
-    // for X509_verify_cert to ignore that error.
-    if (config.certificateValidationContext()->allowExpiredCertificate()) {
-      X509_STORE_set_verify_cb(store, ContextImpl::ignoreCertificateExpirationCallback);
-    }
-  }
-
-  if (config.certificateValidationContext() != nullptr &&
-      !config.certificateValidationContext()->certificateRevocationList().empty()) {
-    bssl::UniquePtr<BIO> bio(BIO_new_mem_buf(
-        const_cast<char*>(
-            config.certificateValidationContext()->certificateRevocationList().data()),
-        config.certificateValidationContext()->certificateRevocationList().size()));
-    RELEASE_ASSERT(bio != nullptr, "");
-
-    // Based on BoringSSL's X509_load_cert_crl_file().
-    bssl::UniquePtr<STACK_OF(X509_INFO)> list(
-        PEM_X509_INFO_read_bio(bio.get(), nullptr, nullptr, nullptr));
-    if (list == nullptr) {
-      throw EnvoyException(
-          fmt::format("Failed to load CRL from {}",
-                      config.certificateValidationContext()->certificateRevocationListPath()));
-    }
-
-    X509_STORE* store = SSL_CTX_get_cert_store(ctx_.get());
-    for (const X509_INFO* item : list.get()) {
-      if (item->crl) {
-        X509_STORE_add_crl(store, item->crl);
-      }
-    }
-
-    X509_STORE_set_flags(store, X509_V_FLAG_CRL_CHECK | X509_V_FLAG_CRL_CHECK_ALL);
+    allow_expired_certificate_ = config.certificateValidationContext()->allowExpiredCertificate();
   }
 
   if (config.certificateValidationContext() != nullptr &&
@@ -171,15 +200,100 @@ ContextImpl::ContextImpl(Stats::Scope& scope, const ContextConfig& config)
     verify_mode = SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT;
   }
 
+  if (config.tlsCertificate() != nullptr) {
+    cert_chain_file_path_ = config.tlsCertificate()->certificateChainPath();
+    private_key_method_ = config.tlsCertificate()->privateKeyMethod();
+  }
+
+  parsed_alpn_protocols_ = parseAlpnProtocols(config.alpnProtocols());
+
+  if (shared_ctx_) {
+    // The SSL_CTX was built by another context with the same canonical configuration, see
+    // ContextManagerImpl. It is immutable, so only the per-context state above is set up.
+    X509* cert = SSL_CTX_get0_certificate(ctx_.get());
+    if (cert != nullptr) {
+      X509_up_ref(cert);
+      cert_chain_.reset(cert);
+    }
+    return;
+  }
+
+  ctx_.reset(SSL_CTX_new(TLS_method()));
+  RELEASE_ASSERT(ctx_, "");
+  initializeSslCtx(config, verify_mode);
+}
+
+void ContextImpl::initializeSslCtx(const ContextConfig& config, int verify_mode) {
+  int rc = SSL_CTX_set_min_proto_version(ctx_.get(), config.minProtocolVersion());
+  RELEASE_ASSERT(rc == 1, "");
+
+  rc = SSL_CTX_set_max_proto_version(ctx_.get(), config.maxProtocolVersion());
+  RELEASE_ASSERT(rc == 1, "");
+
+  if (!SSL_CTX_set_strict_cipher_list(ctx_.get(), config.cipherSuites().c_str())) {
+    std::vector<absl::string_view> ciphers =
+        StringUtil::splitToken(config.cipherSuites(), ":+-![|]", false);
+    std::vector<std::string> bad_ciphers;
+    for (const auto& cipher : ciphers) {
+      std::string cipher_str(cipher);
+      if (!SSL_CTX_set_strict_cipher_list(ctx_.get(), cipher_str.c_str())) {
+        bad_ciphers.push_back(cipher_str);
+      }
+    }
+    throw EnvoyException(fmt::format("Failed to initialize cipher suites {}. The following "
+                                     "ciphers were rejected when tried individually: {}",
+                                     config.cipherSuites(), StringUtil::join(bad_ciphers, ", ")));
+  }
+
+  if (!SSL_CTX_set1_curves_list(ctx_.get(), config.ecdhCurves().c_str())) {
+    throw EnvoyException(fmt::format("Failed to initialize ECDH curves {}", config.ecdhCurves()));
+  }
+
+  if (config.certificateValidationContext() != nullptr &&
+      !config.certificateValidationContext()->certificateRevocationList().empty()) {
+    bssl::UniquePtr<BIO> bio(BIO_new_mem_buf(
+        const_cast<char*>(
+            config.certificateValidationContext()->certificateRevocationList().data()),
+        config.certificateValidationContext()->certificateRevocationList().size()));
+    RELEASE_ASSERT(bio != nullptr, "");
+
+    // Based on BoringSSL's X509_load_cert_crl_file().
+    bssl::UniquePtr<STACK_OF(X509_INFO)> list(
+        PEM_X509_INFO_read_bio(bio.get(), nullptr, nullptr, nullptr));
+    if (list == nullptr) {
+      throw EnvoyException(
+          fmt::format("Failed to load CRL from {}",
+                      config.certificateValidationContext()->certificateRevocationListPath()));
+    }
+
+    // The revocation list is specific to this configuration, so the trusted CA certificates are
+    // added to the own store of the SSL_CTX rather than sharing the store of the bundle.
+    X509_STORE* store = SSL_CTX_get_cert_store(ctx_.get());
+    if (trusted_ca_ != nullptr) {
+      trusted_ca_->addToStore(store);
+    }
+    for (const X509_INFO* item : list.get()) {
+      if (item->crl) {
+        X509_STORE_add_crl(store, item->crl);
+      }
+    }
+
+    X509_STORE_set_flags(store, X509_V_FLAG_CRL_CHECK | X509_V_FLAG_CRL_CHECK_ALL);
+  } else if (trusted_ca_ != nullptr) {
+    // The store of the bundle is never modified after it is built, so it is shared by all the
+    // SSL_CTXs trusting the bundle. SSL_CTX_set_cert_store() takes ownership of a reference.
+    X509_STORE_up_ref(trusted_ca_->store());
+    SSL_CTX_set_cert_store(ctx_.get(), trusted_ca_->store());
+  }
+
   if (verify_mode != SSL_VERIFY_NONE) {
     SSL_CTX_set_verify(ctx_.get(), verify_mode, nullptr);
-    SSL_CTX_set_cert_verify_callback(ctx_.get(), ContextImpl::verifyCallback, this);
+    SSL_CTX_set_cert_verify_callback(ctx_.get(), ContextImpl::verifyCallback, nullptr);
   }
 
   if (config.tlsCertificate() != nullptr) {
     // Load certificate chain.
     const auto& tls_certificate = *config.tlsCertificate();
-    cert_chain_file_path_ = tls_certificate.certificateChainPath();
     bssl::UniquePtr<BIO> bio(
         BIO_new_mem_buf(const_cast<char*>(tls_certificate.certificateChain().data()),
                         tls_certificate.certificateChain().size()));
@@ -211,21 +325,27 @@ ContextImpl::ContextImpl(Stats::Scope& scope, const ContextConfig& config)
           fmt::format("Failed to load certificate chain from {}", cert_chain_file_path_));
     }
 
-    // Load private key.
-    bio.reset(BIO_new_mem_buf(const_cast<char*>(tls_certificate.privateKey().data()),
-                              tls_certificate.privateKey().size()));
-    RELEASE_ASSERT(bio != nullptr, "");
-    bssl::UniquePtr<EVP_PKEY> pkey(PEM_read_bio_PrivateKey(bio.get(), nullptr, nullptr, nullptr));
-    if (pkey == nullptr || !SSL_CTX_use_PrivateKey(ctx_.get(), pkey.get())) {
-      throw EnvoyException(
-          fmt::format("Failed to load private key from {}", tls_certificate.privateKeyPath()));
+    if (private_key_method_ != nullptr) {
+      // The private key operations are delegated to the provider, which may complete them
+      // asynchronously. See SslSocket::onPrivateKeyMethodComplete().
+      SSL_CTX_set_private_key_method(ctx_.get(),
+                                     private_key_method_->getBoringSslPrivateKeyMethod());
+    } else {
+      // Load private key.
+      bio.reset(BIO_new_mem_buf(const_cast<char*>(tls_certificate.privateKey().data()),
+                                tls_certificate.privateKey().size()));
+      RELEASE_ASSERT(bio != nullptr, "");
+      bssl::UniquePtr<EVP_PKEY> pkey(
+          PEM_read_bio_PrivateKey(bio.get(), nullptr, nullptr, nullptr));
+      if (pkey == nullptr || !SSL_CTX_use_PrivateKey(ctx_.get(), pkey.get())) {
+        throw EnvoyException(
+            fmt::format("Failed to load private key from {}", tls_certificate.privateKeyPath()));
+      }
     }
   }
 
   // use the server's cipher list preferences
   SSL_CTX_set_options(ctx_.get(), SSL_OP_CIPHER_SERVER_PREFERENCE);
-
-  parsed_alpn_protocols_ = parseAlpnProtocols(config.alpnProtocols());
 }
 
 int ServerContextImpl::alpnSelectCallback(const unsigned char** out, unsigned char* outlen,
@@ -275,7 +395,16 @@ std::vector<uint8_t> ContextImpl::parseAlpnProtocols(const std::string& alpn_pro
 }
 
 bssl::UniquePtr<SSL> ContextImpl::newSsl() const {
-  return bssl::UniquePtr<SSL>(SSL_new(ctx_.get()));
+  bssl::UniquePtr<SSL> ssl(SSL_new(ctx_.get()));
+  RELEASE_ASSERT(ssl != nullptr, "");
+  int rc = SSL_set_ex_data(ssl.get(), sslContextIndex(), const_cast<ContextImpl*>(this));
+  RELEASE_ASSERT(rc == 1, "");
+  return ssl;
+}
+
+bssl::UniquePtr<SSL_CTX> ContextImpl::sslCtx() const {
+  SSL_CTX_up_ref(ctx_.get());
+  return bssl::UniquePtr<SSL_CTX>(ctx_.get());
 }
 
 int ContextImpl::ignoreCertificateExpirationCallback(int ok, X509_STORE_CTX* ctx) {
@@ -289,10 +418,31 @@ int ContextImpl::ignoreCertificateExpirationCallback(int ok, X509_STORE_CTX* ctx
   return ok;
 }
 
-int ContextImpl::verifyCallback(X509_STORE_CTX* store_ctx, void* arg) {
-  ContextImpl* impl = reinterpret_cast<ContextImpl*>(arg);
+int ContextImpl::verifyCallback(X509_STORE_CTX* store_ctx, void*) {
+  SSL* ssl = reinterpret_cast<SSL*>(
+      X509_STORE_CTX_get_ex_data(store_ctx, SSL_get_ex_data_X509_STORE_CTX_idx()));
+  // The SSL_CTX may be shared by several contexts, so the context is looked up from the
+  // connection.
+  ContextImpl* impl = static_cast<ContextImpl*>(SSL_get_ex_data(ssl, sslContextIndex()));
+  bssl::UniquePtr<X509> cert(SSL_get_peer_certificate(ssl));
+
+  std::string fingerprint;
+  if (impl->verification_cache_ != nullptr) {
+    fingerprint =
+        CertificateVerificationCache::fingerprint(cert.get(), SSL_get_peer_cert_chain(ssl));
+    if (impl->verification_cache_->lookup(fingerprint)) {
+      return 1;
+    }
+  }
 
   if (impl->verify_trusted_ca_) {
+    // NOTE: We're using SSL_CTX_set_cert_verify_callback() instead of X509_verify_cert()
+    // directly. However, our new callback is still calling X509_verify_cert() under
+    // the hood. Therefore, to ignore cert expiration, we need to set the callback
+    // for X509_verify_cert to ignore that error.
+    if (impl->allow_expired_certificate_) {
+      X509_STORE_CTX_set_verify_cb(store_ctx, ContextImpl::ignoreCertificateExpirationCallback);
+    }
     int ret = X509_verify_cert(store_ctx);
     if (ret <= 0) {
       impl->stats_.fail_verify_error_.inc();
@@ -300,10 +450,14 @@ int ContextImpl::verifyCallback(X509_STORE_CTX* store_ctx, void* arg) {
     }
   }
 
-  SSL* ssl = reinterpret_cast<SSL*>(
-      X509_STORE_CTX_get_ex_data(store_ctx, SSL_get_ex_data_X509_STORE_CTX_idx()));
-  bssl::UniquePtr<X509> cert(SSL_get_peer_certificate(ssl));
-  return impl->verifyCertificate(cert.get());
+  const int ret = impl->verifyCertificate(cert.get());
+  if (ret == 1 && impl->verification_cache_ != nullptr) {
+    // The trusted CA certificates of the verified chain may expire before the peer certificates.
+    impl->verification_cache_->insert(
+        fingerprint, cert.get(),
+        impl->verify_trusted_ca_ ? X509_STORE_CTX_get_chain(store_ctx) : nullptr);
+  }
+  return ret;
 }
 
 int ContextImpl::verifyCertificate(X509* cert) {
@@ -476,16 +630,71 @@ std::string ContextImpl::getCertChainInformation() const {
                      getDaysUntilExpiration(cert_chain_.get()));
 }
 
-ClientContextImpl::ClientContextImpl(Stats::Scope& scope, const ClientContextConfig& config)
-    : ContextImpl(scope, config), server_name_indication_(config.serverNameIndication()),
+ClientContextImpl::ClientContextImpl(Stats::Scope& scope, const ClientContextConfig& config,
+                                     TrustedCaImplConstSharedPtr trusted_ca,
+                                     bssl::UniquePtr<SSL_CTX> ctx)
+    : ContextImpl(scope, config, trusted_ca, std::move(ctx)),
+      server_name_indication_(config.serverNameIndication()),
       allow_renegotiation_(config.allowRenegotiation()) {
-  if (!parsed_alpn_protocols_.empty()) {
+  verification_cache_ = std::make_unique<CertificateVerificationCache>(MaxCachedVerifications);
+
+  if (!shared_ctx_ && !parsed_alpn_protocols_.empty()) {
     int rc = SSL_CTX_set_alpn_protos(ctx_.get(), &parsed_alpn_protocols_[0],
                                      parsed_alpn_protocols_.size());
     RELEASE_ASSERT(rc == 0, "");
   }
 }
 
+std::string ClientContextImpl::sslCtxKey(const ClientContextConfig& config) {
+  // The constructor above only adds the ALPN protocols, which the common key covers.
+  return ContextImpl::sslCtxKey(config, {});
+}
+
+std::string ContextImpl::sslCtxKey(const ContextConfig& config,
+                                   const std::vector<std::string>& extra_fields) {
+  // Hash everything that ContextImpl::initializeSslCtx() puts in the SSL_CTX. Each field is
+  // prefixed with its length so that different configurations cannot hash the same input. Hashing
+  // also avoids keeping a copy of the private key in the key.
+  SHA256_CTX sha256;
+  SHA256_Init(&sha256);
+  const auto update = [&sha256](const std::string& field) {
+    const uint64_t length = field.size();
+    SHA256_Update(&sha256, &length, sizeof(length));
+    SHA256_Update(&sha256, field.data(), field.size());
+  };
+
+  update(fmt::format("{}-{}", config.minProtocolVersion(), config.maxProtocolVersion()));
+  update(config.cipherSuites());
+  update(config.ecdhCurves());
+  update(config.alpnProtocols());
+
+  const CertificateValidationContextConfig* validation = config.certificateValidationContext();
+  update(validation != nullptr ? validation->caCert() : EMPTY_STRING);
+  update(validation != nullptr ? validation->certificateRevocationList() : EMPTY_STRING);
+  // Only whether these are set changes the verify mode, they are checked per context.
+  update(validation != nullptr
+             ? fmt::format("{}{}{}", !validation->verifySubjectAltNameList().empty(),
+                           !validation->verifyCertificateHashList().empty(),
+                           !validation->verifyCertificateSpkiList().empty())
+             : EMPTY_STRING);
+
+  const TlsCertificateConfig* tls_certificate = config.tlsCertificate();
+  update(tls_certificate != nullptr ? tls_certificate->certificateChain() : EMPTY_STRING);
+  update(tls_certificate != nullptr ? tls_certificate->privateKey() : EMPTY_STRING);
+  // A provider is only ever shared by the contexts of the same certificate config.
+  const void* private_key_method =
+      tls_certificate != nullptr ? tls_certificate->privateKeyMethod().get() : nullptr;
+  update(fmt::format("{}", private_key_method));
+
+  for (const std::string& field : extra_fields) {
+    update(field);
+  }
+
+  uint8_t hash[SHA256_DIGEST_LENGTH];
+  SHA256_Final(hash, &sha256);
+  return Hex::encode(hash, sizeof(hash));
+}
+
 bssl::UniquePtr<SSL> ClientContextImpl::newSsl() const {
   bssl::UniquePtr<SSL> ssl_con(ContextImpl::newSsl());
 
@@ -502,13 +711,24 @@ bssl::UniquePtr<SSL> ClientContextImpl::newSsl() const {
 }
 
 ServerContextImpl::ServerContextImpl(Stats::Scope& scope, const ServerContextConfig& config,
+                                     TrustedCaImplConstSharedPtr trusted_ca,
                                      const std::vector<std::string>& server_names,
-                                     Runtime::Loader& runtime)
-    : ContextImpl(scope, config), runtime_(runtime),
+                                     Runtime::Loader& runtime, bssl::UniquePtr<SSL_CTX> ctx)
+    : ContextImpl(scope, config, trusted_ca, std::move(ctx)), runtime_(runtime),
       session_ticket_keys_(config.sessionTicketKeys()) {
   if (config.tlsCertificate() == nullptr) {
     throw EnvoyException("Server TlsCertificates must have a certificate specified");
   }
+
+  parsed_alt_alpn_protocols_ = parseAlpnProtocols(config.altAlpnProtocols());
+
+  if (shared_ctx_) {
+    // The client CA list, the callbacks and the session ID context, which hashes all of the
+    // verification settings and the server names, are covered by sslCtxKey(). The callbacks find
+    // this context through the SSL, so they serve every context sharing the SSL_CTX.
+    return;
+  }
+
   if (config.certificateValidationContext() != nullptr &&
       !config.certificateValidationContext()->caCert().empty()) {
     bssl::UniquePtr<BIO> bio(
@@ -555,16 +775,18 @@ ServerContextImpl::ServerContextImpl(Stats::Scope& scope, const ServerContextCon
     }
   }
 
-  parsed_alt_alpn_protocols_ = parseAlpnProtocols(config.altAlpnProtocols());
-
   if (!parsed_alpn_protocols_.empty()) {
-    SSL_CTX_set_alpn_select_cb(ctx_.get(),
-                               [](SSL*, const unsigned char** out, unsigned char* outlen,
-                                  const unsigned char* in, unsigned int inlen, void* arg) -> int {
-                                 return static_cast<ServerContextImpl*>(arg)->alpnSelectCallback(
-                                     out, outlen, in, inlen);
-                               },
-                               this);
+    SSL_CTX_set_alpn_select_cb(
+        ctx_.get(),
+        [](SSL* ssl, const unsigned char** out, unsigned char* outlen, const unsigned char* in,
+           unsigned int inlen, void*) -> int {
+          ContextImpl* context_impl =
+              static_cast<ContextImpl*>(SSL_get_ex_data(ssl, sslContextIndex()));
+          ServerContextImpl* server_context_impl = dynamic_cast<ServerContextImpl*>(context_impl);
+          RELEASE_ASSERT(server_context_impl != nullptr, ""); // for Coverity
+          return server_context_impl->alpnSelectCallback(out, outlen, in, inlen);
+        },
+        nullptr);
   }
 
   if (!session_ticket_keys_.empty()) {
@@ -572,8 +794,8 @@ ServerContextImpl::ServerContextImpl(Stats::Scope& scope, const ServerContextCon
         ctx_.get(),
         [](SSL* ssl, uint8_t* key_name, uint8_t* iv, EVP_CIPHER_CTX* ctx, HMAC_CTX* hmac_ctx,
            int encrypt) -> int {
-          ContextImpl* context_impl = static_cast<ContextImpl*>(
-              SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), sslContextIndex()));
+          ContextImpl* context_impl =
+              static_cast<ContextImpl*>(SSL_get_ex_data(ssl, sslContextIndex()));
           ServerContextImpl* server_context_impl = dynamic_cast<ServerContextImpl*>(context_impl);
           RELEASE_ASSERT(server_context_impl != nullptr, ""); // for Coverity
           return server_context_impl->sessionTicketProcess(ssl, key_name, iv, ctx, hmac_ctx,
@@ -670,6 +892,24 @@ ServerContextImpl::ServerContextImpl(Stats::Scope& scope, const ServerContextCon
   RELEASE_ASSERT(rc == 1, "");
 }
 
+std::string ServerContextImpl::sslCtxKey(const ServerContextConfig& config,
+                                         const std::vector<std::string>& server_names) {
+  // Besides the common fields, the constructor above puts in the SSL_CTX whether client
+  // certificates are required, whether there are ALPN protocols and session ticket keys to set up
+  // the callbacks for, and a session ID context which hashes the verification settings and the
+  // server names. The ALPN protocols and the session ticket keys themselves are per context.
+  std::vector<std::string> fields{
+      fmt::format("{}{}", config.requireClientCertificate(), !config.sessionTicketKeys().empty())};
+  const CertificateValidationContextConfig* validation = config.certificateValidationContext();
+  if (validation != nullptr) {
+    fields.push_back(StringUtil::join(validation->verifySubjectAltNameList(), "\n"));
+    fields.push_back(StringUtil::join(validation->verifyCertificateHashList(), "\n"));
+    fields.push_back(StringUtil::join(validation->verifyCertificateSpkiList(), "\n"));
+  }
+  fields.push_back(StringUtil::join(server_names, "\n"));
+  return ContextImpl::sslCtxKey(config, fields);
+}
+
 int ServerContextImpl::sessionTicketProcess(SSL*, uint8_t* key_name, uint8_t* iv,
                                             EVP_CIPHER_CTX* ctx, HMAC_CTX* hmac_ctx, int encrypt) {
   const EVP_MD* hmac = EVP_sha256();
@@ -1,14 +1,19 @@
 #pragma once
 
+#include <list>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "envoy/runtime/runtime.h"
 #include "envoy/ssl/context.h"
 #include "envoy/ssl/context_config.h"
+#include "envoy/ssl/private_key/private_key.h"
 #include "envoy/stats/scope.h"
 #include "envoy/stats/stats_macros.h"
 
+#include "common/common/thread.h"
+#include "common/common/thread_annotations.h"
 #include "common/ssl/context_impl.h"
 #include "common/ssl/context_manager_impl.h"
 
@@ -40,6 +45,85 @@ struct SslStats {
   ALL_SSL_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT, GENERATE_HISTOGRAM_STRUCT)
 };
 
+/**
+ * Trusted CA certificates and CRLs parsed from a PEM bundle, shared by the contexts trusting the
+ * same bundle. See ContextManagerImpl.
+ */
+class TrustedCaImpl : public TrustedCa {
+public:
+  TrustedCaImpl(const std::string& ca_cert);
+
+  /**
+   * @return the parsed certificates and CRLs, or nullptr if the bundle failed to parse.
+   */
+  const STACK_OF(X509_INFO) * items() const { return items_.get(); }
+
+  /**
+   * @return a certificate store holding the parsed certificates and CRLs, or nullptr if the bundle
+   * failed to parse. The store must not be modified, as it is shared by the SSL_CTXs trusting the
+   * bundle.
+   */
+  X509_STORE* store() const { return store_.get(); }
+
+  /**
+   * Adds the parsed certificates and CRLs to a store.
+   * @param store the store to add to.
+   */
+  void addToStore(X509_STORE* store) const;
+
+private:
+  bssl::UniquePtr<STACK_OF(X509_INFO)> items_;
+  bssl::UniquePtr<X509_STORE> store_;
+};
+
+/**
+ * Bounded cache of the peer certificate chains which passed the verification of a context, so that
+ * connections presenting a chain again, as is typical of the connections to the hosts of an
+ * upstream cluster, skip the verification. An entry expires with the first certificate of the
+ * verified chain to expire. The trusted CAs, CRLs and verification settings of a context never
+ * change, as the context is created again when they do, so entries are not invalidated otherwise.
+ * The least recently used entry is evicted when the cache is full. The cache is thread safe, as a
+ * context is used by all the workers.
+ */
+class CertificateVerificationCache {
+public:
+  CertificateVerificationCache(size_t max_entries) : max_entries_(max_entries) {}
+
+  /**
+   * @param cert the peer certificate.
+   * @param chain the certificate chain sent by the peer, or nullptr.
+   * @return the SHA-256 fingerprint of the certificates, used as the cache key.
+   */
+  static std::string fingerprint(X509* cert, const STACK_OF(X509) * chain);
+
+  /**
+   * @param fingerprint the fingerprint of a peer certificate chain.
+   * @return whether the chain passed verification, and none of its certificates expired since.
+   */
+  bool lookup(const std::string& fingerprint);
+
+  /**
+   * Records that a peer certificate chain passed verification.
+   * @param fingerprint the fingerprint of the chain.
+   * @param cert the peer certificate.
+   * @param verified_chain the chain built by the verification, up to the trusted CA, or nullptr if
+   * the chain was not verified against trusted CAs.
+   */
+  void insert(const std::string& fingerprint, X509* cert, const STACK_OF(X509) * verified_chain);
+
+private:
+  struct Entry {
+    std::string fingerprint_;
+    bssl::UniquePtr<X509> first_to_expire_;
+  };
+
+  const size_t max_entries_;
+  Thread::MutexBasicLockable lock_;
+  // Most recently used first.
+  std::list<Entry> entries_ GUARDED_BY(lock_);
+  std::unordered_map<std::string, std::list<Entry>::iterator> index_ GUARDED_BY(lock_);
+};
+
 class ContextImpl : public virtual Context {
 public:
   virtual bssl::UniquePtr<SSL> newSsl() const;
@@ -69,20 +153,40 @@ public:
 
   SslStats& stats() { return stats_; }
 
+  /**
+   * @return the provider of the private key operations of the certificate, or nullptr if
+   * BoringSSL uses the private key directly.
+   */
+  const PrivateKeyMethodProviderSharedPtr& privateKeyMethod() const { return private_key_method_; }
+
+  /**
+   * @return a new reference to the SSL_CTX of this context, for sharing it with another context of
+   * the same canonical configuration.
+   */
+  bssl::UniquePtr<SSL_CTX> sslCtx() const;
+
   // Ssl::Context
   size_t daysUntilFirstCertExpires() const override;
   std::string getCaCertInformation() const override;
   std::string getCertChainInformation() const override;
 
 protected:
-  ContextImpl(Stats::Scope& scope, const ContextConfig& config);
+  /**
+   * @param ctx an SSL_CTX built by a context with the same canonical configuration, or nullptr to
+   * build a new one.
+   */
+  ContextImpl(Stats::Scope& scope, const ContextConfig& config,
+              TrustedCaImplConstSharedPtr trusted_ca, bssl::UniquePtr<SSL_CTX> ctx);
 
   /**
    * The global SSL-library index used for storing a pointer to the context
-   * in the SSL instance, for retrieval in callbacks.
+   * in the SSL instance, for retrieval in callbacks. The SSL_CTX is not used for this, as it may
+   * be shared by several contexts.
    */
   static int sslContextIndex();
 
+  void initializeSslCtx(const ContextConfig& config, int verify_mode);
+
   // A X509_STORE_CTX_verify_cb callback for ignoring cert expiration in X509_verify_cert().
   static int ignoreCertificateExpirationCallback(int ok, X509_STORE_CTX* store_ctx);
 
@@ -113,6 +217,15 @@ protected:
   static bool verifyCertificateSpkiList(X509* cert,
                                         const std::vector<std::vector<uint8_t>>& expected_hashes);
 
+  /**
+   * @param config the config of a context.
+   * @param extra_fields the parts of the config which determine the SSL_CTX of a context besides
+   * those common to client and server contexts.
+   * @return the hash of the parts of a config which determine the SSL_CTX of a context.
+   */
+  static std::string sslCtxKey(const ContextConfig& config,
+                               const std::vector<std::string>& extra_fields);
+
   std::vector<uint8_t> parseAlpnProtocols(const std::string& alpn_protocols);
   static SslStats generateStats(Stats::Scope& scope);
 
@@ -123,27 +236,44 @@ protected:
   std::string getCertChainFileName() const { return cert_chain_file_path_; };
 
   bssl::UniquePtr<SSL_CTX> ctx_;
+  // Whether ctx_ was built by another context, in which case it must not be modified.
+  const bool shared_ctx_;
   bool verify_trusted_ca_{false};
+  bool allow_expired_certificate_{false};
   std::vector<std::string> verify_subject_alt_name_list_;
   std::vector<std::vector<uint8_t>> verify_certificate_hash_list_;
   std::vector<std::vector<uint8_t>> verify_certificate_spki_list_;
   Stats::Scope& scope_;
   SslStats stats_;
   std::vector<uint8_t> parsed_alpn_protocols_;
+  TrustedCaImplConstSharedPtr trusted_ca_;
   bssl::UniquePtr<X509> ca_cert_;
   bssl::UniquePtr<X509> cert_chain_;
   std::string ca_file_path_;
   std::string cert_chain_file_path_;
+  PrivateKeyMethodProviderSharedPtr private_key_method_;
+  // Set by the contexts which cache the results of the peer certificate verification.
+  std::unique_ptr<CertificateVerificationCache> verification_cache_;
 };
 
 typedef std::shared_ptr<ContextImpl> ContextImplSharedPtr;
 
 class ClientContextImpl : public ContextImpl, public ClientContext {
 public:
-  ClientContextImpl(Stats::Scope& scope, const ClientContextConfig& config);
+  ClientContextImpl(Stats::Scope& scope, const ClientContextConfig& config,
+                    TrustedCaImplConstSharedPtr trusted_ca, bssl::UniquePtr<SSL_CTX> ctx);
+
+  /**
+   * @return the hash of the parts of a config which determine the SSL_CTX of a client context.
+   * Client contexts whose configs have the same key may share their SSL_CTX.
+   */
+  static std::string sslCtxKey(const ClientContextConfig& config);
 
   bssl::UniquePtr<SSL> newSsl() const override;
 
+  // The number of verified upstream certificate chains cached by each client context.
+  static constexpr size_t MaxCachedVerifications = 1024;
+
 private:
   const std::string server_name_indication_;
   const bool allow_renegotiation_;
@@ -152,7 +282,17 @@ private:
 class ServerContextImpl : public ContextImpl, public ServerContext {
 public:
   ServerContextImpl(Stats::Scope& scope, const ServerContextConfig& config,
-                    const std::vector<std::string>& server_names, Runtime::Loader& runtime);
+                    TrustedCaImplConstSharedPtr trusted_ca,
+                    const std::vector<std::string>& server_names, Runtime::Loader& runtime,
+                    bssl::UniquePtr<SSL_CTX> ctx);
+
+  /**
+   * @return the hash of the parts of a config and server names which determine the SSL_CTX of a
+   * server context. Server contexts whose configs and server names have the same key may share
+   * their SSL_CTX.
+   */
+  static std::string sslCtxKey(const ServerContextConfig& config,
+                               const std::vector<std::string>& server_names);
 
 private:
   int alpnSelectCallback(const unsigned char** out, unsigned char* outlen, const unsigned char* in,
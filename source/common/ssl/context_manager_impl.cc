@@ -5,6 +5,7 @@
 #include "envoy/stats/scope.h"
 
 #include "common/common/assert.h"
+#include "common/common/lock_guard.h"
 #include "common/ssl/context_impl.h"
 
 namespace Envoy {
@@ -17,6 +18,66 @@ ContextManagerImpl::~ContextManagerImpl() {
 
 void ContextManagerImpl::removeEmptyContexts() {
   contexts_.remove_if([](const std::weak_ptr<Context>& n) { return n.expired(); });
+  for (auto it = client_contexts_.begin(); it != client_contexts_.end();) {
+    if (it->second.expired()) {
+      it = client_contexts_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  for (auto it = server_contexts_.begin(); it != server_contexts_.end();) {
+    if (it->second.expired()) {
+      it = server_contexts_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  Thread::LockGuard lock(trusted_cas_lock_);
+  for (auto it = trusted_cas_.begin(); it != trusted_cas_.end();) {
+    if (it->second.expired()) {
+      it = trusted_cas_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+TrustedCaImplConstSharedPtr ContextManagerImpl::trustedCa(const ContextConfig& config) {
+  if (config.certificateValidationContext() == nullptr ||
+      config.certificateValidationContext()->caCert().empty()) {
+    return nullptr;
+  }
+  return trustedCa(config.certificateValidationContext()->caCert());
+}
+
+TrustedCaImplConstSharedPtr ContextManagerImpl::trustedCa(const std::string& ca_cert) {
+  {
+    Thread::LockGuard lock(trusted_cas_lock_);
+    auto it = trusted_cas_.find(ca_cert);
+    if (it != trusted_cas_.end()) {
+      TrustedCaImplConstSharedPtr trusted_ca = it->second.lock();
+      if (trusted_ca != nullptr) {
+        return trusted_ca;
+      }
+    }
+  }
+
+  // Parse outside of the lock, so that different bundles prepared from several threads are parsed
+  // in parallel. If the same bundle was parsed meanwhile, that parse wins.
+  TrustedCaImplConstSharedPtr parsed = std::make_shared<const TrustedCaImpl>(ca_cert);
+  Thread::LockGuard lock(trusted_cas_lock_);
+  std::weak_ptr<const TrustedCaImpl>& entry = trusted_cas_[ca_cert];
+  TrustedCaImplConstSharedPtr trusted_ca = entry.lock();
+  if (trusted_ca == nullptr) {
+    entry = parsed;
+    trusted_ca = parsed;
+  }
+  return trusted_ca;
+}
+
+TrustedCaConstSharedPtr ContextManagerImpl::prepareTrustedCa(const std::string& ca_cert) {
+  return trustedCa(ca_cert);
 }
 
 ClientContextSharedPtr
@@ -25,8 +86,20 @@ ContextManagerImpl::createSslClientContext(Stats::Scope& scope, const ClientCont
     return nullptr;
   }
 
-  ClientContextSharedPtr context = std::make_shared<ClientContextImpl>(scope, config);
   removeEmptyContexts();
+  const std::string key = ClientContextImpl::sslCtxKey(config);
+  bssl::UniquePtr<SSL_CTX> ctx;
+  auto it = client_contexts_.find(key);
+  if (it != client_contexts_.end()) {
+    std::shared_ptr<const ClientContextImpl> existing = it->second.lock();
+    if (existing != nullptr) {
+      ctx = existing->sslCtx();
+    }
+  }
+
+  std::shared_ptr<ClientContextImpl> context =
+      std::make_shared<ClientContextImpl>(scope, config, trustedCa(config), std::move(ctx));
+  client_contexts_[key] = context;
   contexts_.emplace_back(context);
   return context;
 }
@@ -38,9 +111,20 @@ ContextManagerImpl::createSslServerContext(Stats::Scope& scope, const ServerCont
     return nullptr;
   }
 
-  ServerContextSharedPtr context =
-      std::make_shared<ServerContextImpl>(scope, config, server_names, runtime_);
   removeEmptyContexts();
+  const std::string key = ServerContextImpl::sslCtxKey(config, server_names);
+  bssl::UniquePtr<SSL_CTX> ctx;
+  auto it = server_contexts_.find(key);
+  if (it != server_contexts_.end()) {
+    std::shared_ptr<const ServerContextImpl> existing = it->second.lock();
+    if (existing != nullptr) {
+      ctx = existing->sslCtx();
+    }
+  }
+
+  std::shared_ptr<ServerContextImpl> context = std::make_shared<ServerContextImpl>(
+      scope, config, trustedCa(config), server_names, runtime_, std::move(ctx));
+  server_contexts_[key] = context;
   contexts_.emplace_back(context);
   return context;
 }
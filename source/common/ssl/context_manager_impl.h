@@ -2,20 +2,42 @@
 
 #include <functional>
 #include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
 
 #include "envoy/runtime/runtime.h"
 #include "envoy/ssl/context_manager.h"
 #include "envoy/stats/scope.h"
 
+#include "common/common/thread.h"
+#include "common/common/thread_annotations.h"
+
 namespace Envoy {
 namespace Ssl {
 
+class TrustedCaImpl;
+typedef std::shared_ptr<const TrustedCaImpl> TrustedCaImplConstSharedPtr;
+class ClientContextImpl;
+class ServerContextImpl;
+
 /**
  * The SSL context manager has the following threading model:
  * Contexts can be allocated via any thread (through in practice they are only allocated on the main
  * thread). They can be released from any thread (and in practice are since cluster information can
  * be released from any thread). Context allocation/free is a very uncommon thing so we just do a
  * global lock to protect it all.
+ *
+ * Parsed trusted CA certificates are cached by content, so that contexts trusting the same bundle,
+ * as is typical of many upstream clusters, share a single parse. The cache has its own lock as
+ * certificates may be prepared from any thread.
+ *
+ * Client and server contexts are interned by the hash of the parts of their config which
+ * determine their SSL_CTX, so that the many upstream clusters or listeners with the same TLS config
+ * share a single immutable SSL_CTX and trust store. The contexts themselves are not shared, as
+ * their stats are per cluster or listener. In particular, when SDS rotates a certificate used by
+ * many of them, the first context created for the new certificate builds the SSL_CTX and the
+ * others reuse it, instead of each parsing the certificate and key and building its own.
  */
 class ContextManagerImpl final : public ContextManager {
 public:
@@ -30,11 +52,22 @@ public:
                          const std::vector<std::string>& server_names) override;
   size_t daysUntilFirstCertExpires() const override;
   void iterateContexts(std::function<void(const Context&)> callback) override;
+  TrustedCaConstSharedPtr prepareTrustedCa(const std::string& ca_cert) override;
 
 private:
   void removeEmptyContexts();
+  TrustedCaImplConstSharedPtr trustedCa(const ContextConfig& config);
+  TrustedCaImplConstSharedPtr trustedCa(const std::string& ca_cert);
+
   Runtime::Loader& runtime_;
   std::list<std::weak_ptr<Context>> contexts_;
+  // The most recently created client context for each SSL_CTX key.
+  std::unordered_map<std::string, std::weak_ptr<const ClientContextImpl>> client_contexts_;
+  // The most recently created server context for each SSL_CTX key.
+  std::unordered_map<std::string, std::weak_ptr<const ServerContextImpl>> server_contexts_;
+  Thread::MutexBasicLockable trusted_cas_lock_;
+  std::unordered_map<std::string, std::weak_ptr<const TrustedCaImpl>>
+      trusted_cas_ GUARDED_BY(trusted_cas_lock_);
 };
 
 } // namespace Ssl
@@ -18,6 +18,37 @@ namespace Envoy {
 namespace Ssl {
 
 namespace {
+
+// Plaintext length of TLS records which fit in a single TCP segment, including the TLS record
+// overhead and TCP options.
+constexpr uint64_t SmallRecordSize = 1300;
+
+// Records are small until this many bytes have been written on a connection, so that the peer can
+// decrypt the first bytes of a response as soon as they arrive while the TCP congestion window is
+// still small, and full sized afterwards so that bulk transfers pay for fewer records.
+constexpr uint64_t DynamicRecordSizingThreshold = 128 * 1024;
+
+// Encrypted bytes buffered before they are written to the socket.
+constexpr uint64_t EncryptedBufferHighWatermark = 64 * 1024;
+
+int encryptedBufferBioWrite(BIO* bio, const char* data, int length) {
+  static_cast<Buffer::Instance*>(BIO_get_data(bio))->add(data, length);
+  return length;
+}
+
+long encryptedBufferBioCtrl(BIO*, int cmd, long, void*) {
+  // SSL flushes its write BIO after each flight. The buffer is written to the socket by SslSocket.
+  return cmd == BIO_CTRL_FLUSH ? 1 : 0;
+}
+
+const BIO_METHOD encrypted_buffer_bio_method = {
+    BIO_TYPE_MEM,            "envoy_encrypted_buffer",
+    encryptedBufferBioWrite, nullptr /* read */,
+    nullptr /* puts */,      nullptr /* gets */,
+    encryptedBufferBioCtrl,  nullptr /* create */,
+    nullptr /* destroy */,   nullptr /* callback_ctrl */,
+};
+
 // This SslSocket will be used when SSL secret is not fetched from SDS server.
 class NotReadySslSocket : public Network::TransportSocket {
 public:
@@ -32,6 +63,7 @@ public:
   }
   void onConnected() override {}
   const Ssl::Connection* ssl() const override { return nullptr; }
+  bool passthrough() const override { return false; }
 };
 } // namespace
 
@@ -45,12 +77,40 @@ SslSocket::SslSocket(ContextSharedPtr ctx, InitialState state)
   }
 }
 
+SslSocket::~SslSocket() { unregisterPrivateKeyMethod(); }
+
 void SslSocket::setTransportSocketCallbacks(Network::TransportSocketCallbacks& callbacks) {
   ASSERT(!callbacks_);
   callbacks_ = &callbacks;
 
-  BIO* bio = BIO_new_socket(callbacks_->fd(), 0);
-  SSL_set_bio(ssl_.get(), bio, bio);
+  BIO* rbio = BIO_new_socket(callbacks_->fd(), 0);
+  BIO* wbio = BIO_new(&encrypted_buffer_bio_method);
+  BIO_set_data(wbio, &encrypted_buffer_);
+  BIO_set_init(wbio, 1);
+  SSL_set_bio(ssl_.get(), rbio, wbio);
+
+  if (ctx_->privateKeyMethod() != nullptr) {
+    ctx_->privateKeyMethod()->registerPrivateKeyMethod(ssl_.get(), *this,
+                                                       callbacks_->connection().dispatcher());
+  }
+}
+
+void SslSocket::onPrivateKeyMethodComplete() {
+  if (handshake_complete_) {
+    return;
+  }
+
+  // Resume the handshake, which collects the result of the private key operation.
+  ENVOY_CONN_LOG(debug, "private key operation complete", callbacks_->connection());
+  if (doHandshake() == PostIoAction::Close) {
+    callbacks_->connection().close(Network::ConnectionCloseType::NoFlush);
+  }
+}
+
+void SslSocket::unregisterPrivateKeyMethod() {
+  if (ctx_->privateKeyMethod() != nullptr) {
+    ctx_->privateKeyMethod()->unregisterPrivateKeyMethod(ssl_.get());
+  }
 }
 
 Network::IoResult SslSocket::doRead(Buffer::Instance& read_buffer) {
@@ -110,12 +170,20 @@ Network::IoResult SslSocket::doRead(Buffer::Instance& read_buffer) {
     }
   }
 
+  // Reads may produce output, such as alerts and post-handshake messages.
+  if (flushPendingOutput() == PostIoAction::Close) {
+    action = PostIoAction::Close;
+  }
+
   return {action, bytes_read, end_stream};
 }
 
 PostIoAction SslSocket::doHandshake() {
   ASSERT(!handshake_complete_);
   int rc = SSL_do_handshake(ssl_.get());
+  if (flushPendingOutput() == PostIoAction::Close) {
+    return PostIoAction::Close;
+  }
   if (rc == 1) {
     ENVOY_CONN_LOG(debug, "handshake complete", callbacks_->connection());
     handshake_complete_ = true;
@@ -133,6 +201,9 @@ PostIoAction SslSocket::doHandshake() {
     case SSL_ERROR_WANT_READ:
     case SSL_ERROR_WANT_WRITE:
       return PostIoAction::KeepOpen;
+    case SSL_ERROR_WANT_PRIVATE_KEY_OPERATION:
+      // The handshake is resumed by onPrivateKeyMethodComplete().
+      return PostIoAction::KeepOpen;
     default:
       drainErrorQueue();
       return PostIoAction::Close;
@@ -164,7 +235,9 @@ void SslSocket::drainErrorQueue() {
 }
 
 Network::IoResult SslSocket::doWrite(Buffer::Instance& write_buffer, bool end_stream) {
-  ASSERT(!shutdown_sent_ || write_buffer.length() == 0);
+  // Nothing is written after close_notify, besides the records which were encrypted before it.
+  ASSERT(!shutdown_sent_ ||
+         write_buffer.length() == pending_plaintext_length_ + shutdown_plaintext_flushed_);
   if (!handshake_complete_) {
     PostIoAction action = doHandshake();
     if (action == PostIoAction::Close || !handshake_complete_) {
@@ -172,52 +245,152 @@ Network::IoResult SslSocket::doWrite(Buffer::Instance& write_buffer, bool end_st
     }
   }
 
-  uint64_t bytes_to_write;
-  if (bytes_to_retry_) {
-    bytes_to_write = bytes_to_retry_;
-    bytes_to_retry_ = 0;
-  } else {
-    bytes_to_write = std::min(write_buffer.length(), static_cast<uint64_t>(16384));
+  uint64_t total_bytes_written = 0;
+  if (shutdown_plaintext_flushed_ > 0) {
+    write_buffer.drain(shutdown_plaintext_flushed_);
+    total_bytes_written = shutdown_plaintext_flushed_;
+    shutdown_plaintext_flushed_ = 0;
   }
 
-  uint64_t total_bytes_written = 0;
-  while (bytes_to_write > 0) {
+  do {
     // TODO(mattklein123): As it relates to our fairness efforts, we might want to limit the number
     // of iterations of this loop, either by pure iterations, bytes written, etc.
+    if (!encryptWriteBuffer(write_buffer)) {
+      return {PostIoAction::Close, total_bytes_written, false};
+    }
 
-    // SSL_write() requires that if a previous call returns SSL_ERROR_WANT_WRITE, we need to call
-    // it again with the same parameters. This is done by tracking last write size, but not write
-    // data, since linearize() will return the same undrained data anyway.
-    ASSERT(bytes_to_write <= write_buffer.length());
-    int rc = SSL_write(ssl_.get(), write_buffer.linearize(bytes_to_write), bytes_to_write);
-    ENVOY_CONN_LOG(trace, "ssl write returns: {}", callbacks_->connection(), rc);
-    if (rc > 0) {
-      ASSERT(rc == static_cast<int>(bytes_to_write));
-      total_bytes_written += rc;
-      write_buffer.drain(rc);
-      bytes_to_write = std::min(write_buffer.length(), static_cast<uint64_t>(16384));
+    uint64_t bytes_written;
+    const PostIoAction action = flushEncryptedBuffer(bytes_written);
+    if (bytes_written > 0) {
+      write_buffer.drain(bytes_written);
+      pending_plaintext_length_ -= bytes_written;
+      total_bytes_written += bytes_written;
+    }
+    if (action == PostIoAction::Close) {
+      return {PostIoAction::Close, total_bytes_written, false};
+    }
+    // Stop once the socket is full or everything has been written.
+  } while (encrypted_buffer_.length() == 0 && write_buffer.length() > 0);
+
+  if (write_buffer.length() == 0 && end_stream) {
+    shutdownSsl();
+  }
+
+  return {PostIoAction::KeepOpen, total_bytes_written, false};
+}
+
+bool SslSocket::encryptWriteBuffer(Buffer::Instance& write_buffer) {
+  const uint64_t num_slices = write_buffer.getRawSlices(nullptr, 0);
+  Buffer::RawSlice slices[num_slices];
+  write_buffer.getRawSlices(slices, num_slices);
+
+  // Encrypt the plaintext following that which is already encrypted, a record at a time.
+  uint64_t offset = pending_plaintext_length_;
+  uint64_t slice_index = 0;
+  uint64_t slice_offset = offset;
+  while (slice_index < num_slices && slice_offset >= slices[slice_index].len_) {
+    slice_offset -= slices[slice_index].len_;
+    slice_index++;
+  }
+
+  while (offset < write_buffer.length() &&
+         encrypted_buffer_.length() < EncryptedBufferHighWatermark) {
+    const uint64_t record_size =
+        std::min(write_buffer.length() - offset,
+                 total_plaintext_encrypted_ < DynamicRecordSizingThreshold
+                     ? SmallRecordSize
+                     : static_cast<uint64_t>(SSL3_RT_MAX_PLAIN_LENGTH));
+
+    // Records are encrypted straight from the slices of the write buffer, unless they span
+    // several slices, in which case they are gathered first so that records are full sized.
+    uint8_t record[SSL3_RT_MAX_PLAIN_LENGTH];
+    const void* data;
+    if (slices[slice_index].len_ - slice_offset >= record_size) {
+      data = static_cast<const uint8_t*>(slices[slice_index].mem_) + slice_offset;
     } else {
-      int err = SSL_get_error(ssl_.get(), rc);
-      switch (err) {
-      case SSL_ERROR_WANT_WRITE:
-        bytes_to_retry_ = bytes_to_write;
-        break;
-      case SSL_ERROR_WANT_READ:
-      // Renegotiation has started. We don't handle renegotiation so just fall through.
-      default:
-        drainErrorQueue();
-        return {PostIoAction::Close, total_bytes_written, false};
+      write_buffer.copyOut(offset, record_size, record);
+      data = record;
+    }
+
+    int rc = SSL_write(ssl_.get(), data, record_size);
+    ENVOY_CONN_LOG(trace, "ssl write returns: {}", callbacks_->connection(), rc);
+    if (rc <= 0) {
+      // The write BIO never blocks, so there is nothing to retry. SSL_ERROR_WANT_READ means that
+      // renegotiation has started, which we don't handle.
+      drainErrorQueue();
+      return false;
+    }
+    ASSERT(rc == static_cast<int>(record_size));
+    addPendingRecord(record_size);
+    pending_plaintext_length_ += record_size;
+    total_plaintext_encrypted_ += record_size;
+    offset += record_size;
+
+    uint64_t remaining = record_size;
+    while (remaining > 0) {
+      const uint64_t length = std::min(remaining, slices[slice_index].len_ - slice_offset);
+      remaining -= length;
+      slice_offset += length;
+      if (slice_offset == slices[slice_index].len_) {
+        slice_index++;
+        slice_offset = 0;
       }
+    }
+  }
+
+  return true;
+}
+
+void SslSocket::addPendingRecord(uint64_t plaintext_length) {
+  const uint64_t encrypted_length = encrypted_buffer_.length() - pending_encrypted_length_;
+  if (encrypted_length > 0 || plaintext_length > 0) {
+    pending_records_.push_back({encrypted_length, plaintext_length});
+    pending_encrypted_length_ += encrypted_length;
+  }
+}
+
+PostIoAction SslSocket::flushEncryptedBuffer(uint64_t& plaintext_flushed) {
+  plaintext_flushed = 0;
+  // Account for the output of handshakes, reads and shutdowns.
+  addPendingRecord(0);
+
+  while (encrypted_buffer_.length() > 0) {
+    Api::SysCallIntResult result = encrypted_buffer_.write(callbacks_->fd());
+    ENVOY_CONN_LOG(trace, "write returns: {}", callbacks_->connection(), result.rc_);
+    if (result.rc_ == -1) {
+      ENVOY_CONN_LOG(trace, "write error: {} ({})", callbacks_->connection(), result.errno_,
+                     strerror(result.errno_));
+      return result.errno_ == EAGAIN ? PostIoAction::KeepOpen : PostIoAction::Close;
+    }
 
-      break;
+    uint64_t bytes_written = result.rc_;
+    pending_encrypted_length_ -= bytes_written;
+    while (bytes_written > 0) {
+      PendingRecord& record = pending_records_.front();
+      if (bytes_written < record.encrypted_length_) {
+        record.encrypted_length_ -= bytes_written;
+        break;
+      }
+      bytes_written -= record.encrypted_length_;
+      plaintext_flushed += record.plaintext_length_;
+      pending_records_.pop_front();
     }
   }
 
-  if (write_buffer.length() == 0 && end_stream) {
-    shutdownSsl();
+  return PostIoAction::KeepOpen;
+}
+
+PostIoAction SslSocket::flushPendingOutput() {
+  if (pending_plaintext_length_ > 0) {
+    // Records of the write buffer could not be written to the socket, so doWrite() flushes the
+    // output once the socket is writable again.
+    return PostIoAction::KeepOpen;
   }
 
-  return {PostIoAction::KeepOpen, total_bytes_written, false};
+  uint64_t plaintext_flushed;
+  const PostIoAction action = flushEncryptedBuffer(plaintext_flushed);
+  ASSERT(plaintext_flushed == 0);
+  return action;
 }
 
 void SslSocket::onConnected() { ASSERT(!handshake_complete_); }
@@ -228,6 +401,15 @@ void SslSocket::shutdownSsl() {
     int rc = SSL_shutdown(ssl_.get());
     ENVOY_CONN_LOG(debug, "SSL shutdown: rc={}", callbacks_->connection(), rc);
     drainErrorQueue();
+    // close_notify is queued behind the pending records of the write buffer, if any, and all of
+    // them are written now since the socket is usually closed next. doWrite() drains the plaintext
+    // of the records written here, and flushes whatever did not fit on the socket.
+    // Ignore the result. This can only fail if the connection failed. In that case, the error will
+    // be detected on the next read, and dealt with appropriately.
+    uint64_t plaintext_flushed;
+    flushEncryptedBuffer(plaintext_flushed);
+    pending_plaintext_length_ -= plaintext_flushed;
+    shutdown_plaintext_flushed_ += plaintext_flushed;
     shutdown_sent_ = true;
   }
 }
@@ -345,6 +527,10 @@ std::vector<std::string> SslSocket::getDnsSansFromCertificate(X509* cert) const
 }
 
 void SslSocket::closeSocket(Network::ConnectionEvent) {
+  // Abandon any pending private key operation, so that its completion is not delivered to a closed
+  // connection.
+  unregisterPrivateKeyMethod();
+
   // Attempt to send a shutdown before closing the socket. It's possible this won't go out if
   // there is no room on the socket. We can extend the state machine to handle this at some point
   // if needed.
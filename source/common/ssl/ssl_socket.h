@@ -1,14 +1,17 @@
 #pragma once
 
 #include <cstdint>
+#include <deque>
 #include <string>
 
 #include "envoy/network/connection.h"
 #include "envoy/network/transport_socket.h"
 #include "envoy/secret/secret_callbacks.h"
+#include "envoy/ssl/private_key/private_key.h"
 #include "envoy/stats/scope.h"
 #include "envoy/stats/stats_macros.h"
 
+#include "common/buffer/buffer_impl.h"
 #include "common/common/logger.h"
 #include "common/ssl/context_impl.h"
 
@@ -36,9 +39,11 @@ enum class InitialState { Client, Server };
 
 class SslSocket : public Network::TransportSocket,
                   public Connection,
+                  public PrivateKeyConnectionCallbacks,
                   protected Logger::Loggable<Logger::Id::connection> {
 public:
   SslSocket(ContextSharedPtr ctx, InitialState state);
+  ~SslSocket();
 
   // Ssl::Connection
   bool peerCertificatePresented() const override;
@@ -61,13 +66,39 @@ public:
   Network::IoResult doWrite(Buffer::Instance& write_buffer, bool end_stream) override;
   void onConnected() override;
   const Ssl::Connection* ssl() const override { return this; }
+  bool passthrough() const override { return false; }
+
+  // Ssl::PrivateKeyConnectionCallbacks
+  void onPrivateKeyMethodComplete() override;
 
   SSL* rawSslForTest() const { return ssl_.get(); }
 
+  /**
+   * Accessors for transport sockets which take over the connection once the handshake is complete.
+   */
+  SSL* rawSsl() const { return ssl_.get(); }
+  bool handshakeComplete() const { return handshake_complete_; }
+  // Whether output of SSL has not been written to the socket yet.
+  bool hasPendingOutput() const { return encrypted_buffer_.length() > 0; }
+
 private:
+  /**
+   * Encrypted output of SSL that has not been written to the socket yet, along with the length of
+   * the plaintext of the write buffer that it carries.
+   */
+  struct PendingRecord {
+    uint64_t encrypted_length_;
+    uint64_t plaintext_length_;
+  };
+
   Network::PostIoAction doHandshake();
   void drainErrorQueue();
   void shutdownSsl();
+  void unregisterPrivateKeyMethod();
+  bool encryptWriteBuffer(Buffer::Instance& write_buffer);
+  void addPendingRecord(uint64_t plaintext_length);
+  Network::PostIoAction flushEncryptedBuffer(uint64_t& plaintext_flushed);
+  Network::PostIoAction flushPendingOutput();
 
   // TODO: Move helper functions to the `Ssl::Utility` namespace.
   std::string getUriSanFromCertificate(X509* cert) const;
@@ -79,7 +110,20 @@ private:
   bssl::UniquePtr<SSL> ssl_;
   bool handshake_complete_{};
   bool shutdown_sent_{};
-  uint64_t bytes_to_retry_{};
+  // The write BIO of ssl_ appends the encrypted output to this buffer, so that the records of
+  // several writes are written to the socket with a single writev().
+  Buffer::OwnedImpl encrypted_buffer_;
+  std::deque<PendingRecord> pending_records_;
+  // Sum of the encrypted lengths of pending_records_.
+  uint64_t pending_encrypted_length_{};
+  // Length of the plaintext at the front of the write buffer which has been encrypted, but whose
+  // records have not been written to the socket yet. It is drained from the write buffer once they
+  // are, so that the connection keeps track of the data that is not written yet.
+  uint64_t pending_plaintext_length_{};
+  // Length of the plaintext at the front of the write buffer whose records were written to the
+  // socket by shutdownSsl(), which doWrite() drains.
+  uint64_t shutdown_plaintext_flushed_{};
+  uint64_t total_plaintext_encrypted_{};
   mutable std::string cached_sha_256_peer_certificate_digest_;
   mutable std::string cached_url_encoded_pem_encoded_peer_certificate_;
 };
@@ -1,10 +1,12 @@
 #include "common/ssl/tls_certificate_config_impl.h"
 
 #include "envoy/common/exception.h"
+#include "envoy/ssl/private_key/private_key_config.h"
 
 #include "common/common/empty_string.h"
 #include "common/common/fmt.h"
 #include "common/config/datasource.h"
+#include "common/config/utility.h"
 
 namespace Envoy {
 namespace Ssl {
@@ -21,7 +23,16 @@ TlsCertificateConfigImpl::TlsCertificateConfigImpl(
       private_key_path_(Config::DataSource::getPath(config.private_key())
                             .value_or(private_key_.empty() ? EMPTY_STRING : INLINE_STRING)) {
 
-  if (certificate_chain_.empty() || private_key_.empty()) {
+  if (config.has_private_key_provider()) {
+    const auto& provider = config.private_key_provider();
+    auto& factory = Config::Utility::getAndCheckFactory<PrivateKeyMethodProviderInstanceFactory>(
+        provider.provider_name());
+    private_key_method_ =
+        factory.createPrivateKeyMethodProviderInstance(provider.config(), private_key_);
+  }
+
+  // The private key may be held by the private key provider.
+  if (certificate_chain_.empty() || (private_key_.empty() && private_key_method_ == nullptr)) {
     throw EnvoyException(fmt::format("Failed to load incomplete certificate from {}, {}",
                                      certificate_chain_path_, private_key_path_));
   }
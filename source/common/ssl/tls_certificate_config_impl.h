@@ -16,12 +16,16 @@ public:
   const std::string& certificateChainPath() const override { return certificate_chain_path_; }
   const std::string& privateKey() const override { return private_key_; }
   const std::string& privateKeyPath() const override { return private_key_path_; }
+  PrivateKeyMethodProviderSharedPtr privateKeyMethod() const override {
+    return private_key_method_;
+  }
 
 private:
   const std::string certificate_chain_;
   const std::string certificate_chain_path_;
   const std::string private_key_;
   const std::string private_key_path_;
+  PrivateKeyMethodProviderSharedPtr private_key_method_;
 };
 
 } // namespace Ssl
@@ -2,45 +2,75 @@
 
 #include "common/common/lock_guard.h"
 #include "common/common/thread.h"
+#include "common/memory/accounting.h"
+#include "common/memory/huge_page_arena.h"
 
 namespace Envoy {
 namespace Stats {
 
-HeapStatData::HeapStatData(absl::string_view key) : name_(key.data(), key.size()) {}
-
 HeapStatDataAllocator::HeapStatDataAllocator() {}
 
-HeapStatDataAllocator::~HeapStatDataAllocator() { ASSERT(stats_.empty()); }
+HeapStatDataAllocator::~HeapStatDataAllocator() {
+  ASSERT(stats_.empty());
+  for (Slot* slab : slabs_) {
+    Memory::HugePageArena::deallocate(slab, SlabSize * sizeof(Slot));
+    Memory::Accounting::freed(Memory::Tag::Stats, SlabSize * sizeof(Slot));
+  }
+}
 
 HeapStatData* HeapStatDataAllocator::alloc(absl::string_view name) {
   // Any expected truncation of name is done at the callsite. No truncation is
-  // required to use this allocator.
-  auto data = std::make_unique<HeapStatData>(name);
-  Thread::ReleasableLockGuard lock(mutex_);
-  auto ret = stats_.insert(data.get());
-  HeapStatData* existing_data = *ret.first;
-  lock.release();
-
-  if (ret.second) {
-    return data.release();
+  // required to use this allocator. The name is looked up with data on the stack, so that a slot
+  // is only taken by a new stat.
+  HeapStatData lookup(symbol_table_.encodeInline(name));
+  Thread::LockGuard lock(mutex_);
+  auto it = stats_.find(&lookup);
+  if (it != stats_.end()) {
+    // The reference is taken under the lock, so that free() cannot delete the data in between.
+    // The lookup data releases its references to the symbols it shares with the existing data.
+    ++(*it)->ref_count_;
+    return *it;
   }
-  ++existing_data->ref_count_;
-  return existing_data;
+  HeapStatData* data = newData(std::move(lookup.name_));
+  stats_.insert(data);
+  return data;
 }
 
 void HeapStatDataAllocator::free(HeapStatData& data) {
-  ASSERT(data.ref_count_ > 0);
-  if (--data.ref_count_ > 0) {
-    return;
-  }
-
   {
+    // Stats are freed from any thread, so the last reference must be dropped under the same lock
+    // that alloc() takes references under.
     Thread::LockGuard lock(mutex_);
+    ASSERT(data.ref_count_ > 0);
+    if (--data.ref_count_ > 0) {
+      return;
+    }
     size_t key_removed = stats_.erase(&data);
     ASSERT(key_removed == 1);
+    deleteData(data);
   }
+}
+
+HeapStatData* HeapStatDataAllocator::newData(StatNameImpl&& name) {
+  Slot* slot;
+  if (!free_slots_.empty()) {
+    slot = free_slots_.back();
+    free_slots_.pop_back();
+  } else {
+    if (next_slot_ == SlabSize) {
+      slabs_.push_back(
+          static_cast<Slot*>(Memory::HugePageArena::allocate(SlabSize * sizeof(Slot))));
+      Memory::Accounting::allocated(Memory::Tag::Stats, SlabSize * sizeof(Slot));
+      next_slot_ = 0;
+    }
+    slot = slabs_.back() + next_slot_++;
+  }
+  return new (slot) HeapStatData(std::move(name));
+}
 
-  delete &data;
+void HeapStatDataAllocator::deleteData(HeapStatData& data) {
+  data.~HeapStatData();
+  free_slots_.push_back(reinterpret_cast<Slot*>(&data));
 }
 
 template class StatDataAllocatorImpl<HeapStatData>;
@@ -25,10 +25,11 @@ const std::vector<double>& HistogramStatisticsImpl::supportedQuantiles() const {
 std::string HistogramStatisticsImpl::summary() const {
   std::vector<std::string> summary;
   const std::vector<double>& supported_quantiles_ref = supportedQuantiles();
+  const std::vector<double>& computed_quantiles_ref = computedQuantiles();
   summary.reserve(supported_quantiles_ref.size());
   for (size_t i = 0; i < supported_quantiles_ref.size(); ++i) {
     summary.push_back(
-        fmt::format("P{}: {}", 100 * supported_quantiles_ref[i], computed_quantiles_[i]));
+        fmt::format("P{}: {}", 100 * supported_quantiles_ref[i], computed_quantiles_ref[i]));
   }
   return absl::StrJoin(summary, ", ");
 }
@@ -37,9 +38,22 @@ std::string HistogramStatisticsImpl::summary() const {
  * Clears the old computed values and refreshes it with values computed from passed histogram.
  */
 void HistogramStatisticsImpl::refresh(const histogram_t* new_histogram_ptr) {
+  pending_histogram_ = nullptr;
+  computeQuantiles(new_histogram_ptr);
+}
+
+const std::vector<double>& HistogramStatisticsImpl::computedQuantiles() const {
+  if (pending_histogram_ != nullptr) {
+    computeQuantiles(pending_histogram_);
+    pending_histogram_ = nullptr;
+  }
+  return computed_quantiles_;
+}
+
+void HistogramStatisticsImpl::computeQuantiles(const histogram_t* histogram_ptr) const {
   std::fill(computed_quantiles_.begin(), computed_quantiles_.end(), 0.0);
   ASSERT(supportedQuantiles().size() == computed_quantiles_.size());
-  hist_approx_quantile(new_histogram_ptr, supportedQuantiles().data(), supportedQuantiles().size(),
+  hist_approx_quantile(histogram_ptr, supportedQuantiles().data(), supportedQuantiles().size(),
                        computed_quantiles_.data());
 }
 
@@ -30,13 +30,26 @@ public:
 
   void refresh(const histogram_t* new_histogram_ptr);
 
+  /**
+   * Like refresh(), but the quantiles are only computed when they are first read, if at all.
+   * @param new_histogram_ptr pointer to the histogram for which stats will be calculated. It must
+   * remain valid and unchanged until the quantiles are read, or until the next refresh.
+   */
+  void refreshLazily(const histogram_t* new_histogram_ptr) {
+    pending_histogram_ = new_histogram_ptr;
+  }
+
   // HistogramStatistics
   std::string summary() const override;
   const std::vector<double>& supportedQuantiles() const override;
-  const std::vector<double>& computedQuantiles() const override { return computed_quantiles_; }
+  const std::vector<double>& computedQuantiles() const override;
 
 private:
-  std::vector<double> computed_quantiles_;
+  void computeQuantiles(const histogram_t* histogram_ptr) const;
+
+  // Computed on demand when a lazy refresh is pending.
+  mutable std::vector<double> computed_quantiles_;
+  mutable const histogram_t* pending_histogram_{};
 };
 
 /**
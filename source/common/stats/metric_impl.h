@@ -27,10 +27,12 @@ public:
 
 protected:
   /**
-   * Flags used by all stats types to figure out whether they have been used.
+   * Flags used by all stats types to figure out whether they have been used, and whether they
+   * have been updated since the last flush.
    */
   struct Flags {
     static const uint8_t Used = 0x1;
+    static const uint8_t Changed = 0x2;
   };
 
 private:
@@ -36,9 +36,10 @@ uint64_t RawStatData::structSizeWithOptions(const StatsOptions& stats_options) {
 void RawStatData::initialize(absl::string_view key, const StatsOptions& stats_options) {
   ASSERT(!initialized());
   ASSERT(key.size() <= stats_options.maxNameLength());
-  ref_count_ = 1;
   memcpy(name_, key.data(), key.size());
   name_[key.size()] = '\0';
+  // Set last, so that a reference taken on a stat found without the lock covers its whole name.
+  ref_count_ = 1;
 }
 
 template class StatDataAllocatorImpl<RawStatData>;
@@ -47,7 +47,7 @@ struct RawStatData {
 
   /**
    * Wrapper for structSize, taking a StatsOptions struct.
-   * Required by BlockMemoryHashSet, which has the context to supply StatsOptions.
+   * Required by the shared memory hash sets, which have the context to supply StatsOptions.
    */
   static uint64_t structSizeWithOptions(const StatsOptions& stats_options);
 
@@ -60,7 +60,7 @@ struct RawStatData {
   void initialize(absl::string_view key, const StatsOptions& stats_options);
 
   /**
-   * Returns a hash of the key. This is required by BlockMemoryHashSet.
+   * Returns a hash of the key. This is required by the shared memory hash sets.
    */
   static uint64_t hash(absl::string_view key) { return HashUtil::xxHash64(key); }
 
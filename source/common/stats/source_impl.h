@@ -17,6 +17,8 @@ public:
   std::vector<CounterSharedPtr>& cachedCounters() override;
   std::vector<GaugeSharedPtr>& cachedGauges() override;
   std::vector<ParentHistogramSharedPtr>& cachedHistograms() override;
+  std::vector<CounterSharedPtr>& cachedChangedCounters() override;
+  std::vector<GaugeSharedPtr>& cachedChangedGauges() override;
   void clearCache() override;
 
 private:
@@ -24,6 +26,8 @@ private:
   absl::optional<std::vector<CounterSharedPtr>> counters_;
   absl::optional<std::vector<GaugeSharedPtr>> gauges_;
   absl::optional<std::vector<ParentHistogramSharedPtr>> histograms_;
+  absl::optional<std::vector<CounterSharedPtr>> changed_counters_;
+  absl::optional<std::vector<GaugeSharedPtr>> changed_gauges_;
 };
 
 } // namespace Stats
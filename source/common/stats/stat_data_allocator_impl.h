@@ -73,7 +73,7 @@ public:
   void add(uint64_t amount) override {
     data_.value_ += amount;
     data_.pending_increment_ += amount;
-    data_.flags_ |= Flags::Used;
+    data_.flags_ |= Flags::Used | Flags::Changed;
   }
 
   void inc() override { add(1); }
@@ -81,6 +81,9 @@ public:
   void reset() override { data_.value_ = 0; }
   bool used() const override { return data_.flags_ & Flags::Used; }
   uint64_t value() const override { return data_.value_; }
+  bool latchChanged() override {
+    return data_.flags_.fetch_and(static_cast<uint16_t>(~Flags::Changed)) & Flags::Changed;
+  }
 
 private:
   StatData& data_;
@@ -103,21 +106,25 @@ public:
   // Stats::Gauge
   virtual void add(uint64_t amount) override {
     data_.value_ += amount;
-    data_.flags_ |= Flags::Used;
+    data_.flags_ |= Flags::Used | Flags::Changed;
   }
   virtual void dec() override { sub(1); }
   virtual void inc() override { add(1); }
   virtual void set(uint64_t value) override {
     data_.value_ = value;
-    data_.flags_ |= Flags::Used;
+    data_.flags_ |= Flags::Used | Flags::Changed;
   }
   virtual void sub(uint64_t amount) override {
     ASSERT(data_.value_ >= amount);
     ASSERT(used());
     data_.value_ -= amount;
+    data_.flags_ |= Flags::Changed;
   }
   virtual uint64_t value() const override { return data_.value_; }
   bool used() const override { return data_.flags_ & Flags::Used; }
+  bool latchChanged() override {
+    return data_.flags_.fetch_and(static_cast<uint16_t>(~Flags::Changed)) & Flags::Changed;
+  }
 
 private:
   StatData& data_;
@@ -9,28 +9,72 @@
 namespace Envoy {
 namespace Stats {
 
+namespace {
+
+// Symbols are small integers, most of which fit in one or two bytes as varints.
+size_t varintSize(uint64_t value) {
+  size_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    size++;
+  }
+  return size;
+}
+
+uint8_t* writeVarint(uint64_t value, uint8_t* out) {
+  while (value >= 0x80) {
+    *out++ = static_cast<uint8_t>(value | 0x80);
+    value >>= 7;
+  }
+  *out++ = static_cast<uint8_t>(value);
+  return out;
+}
+
+const uint8_t* readVarint(const uint8_t* in, uint64_t& value) {
+  value = 0;
+  uint32_t shift = 0;
+  while (*in & 0x80) {
+    value |= static_cast<uint64_t>(*in++ & 0x7f) << shift;
+    shift += 7;
+  }
+  value |= static_cast<uint64_t>(*in++) << shift;
+  return in;
+}
+
+} // namespace
+
 // TODO(ambuc): There is a possible performance optimization here for avoiding the encoding of IPs,
 // if they appear in stat names. We don't want to waste time symbolizing an integer as an integer,
 // if we can help it.
 StatNamePtr SymbolTableImpl::encode(const absl::string_view name) {
+  return std::make_unique<StatNameImpl>(encodeInline(name));
+}
+
+StatNameImpl SymbolTableImpl::encodeInline(const absl::string_view name) {
   SymbolVec symbol_vec;
   std::vector<absl::string_view> name_vec = absl::StrSplit(name, '.');
   symbol_vec.reserve(name_vec.size());
-  std::transform(name_vec.begin(), name_vec.end(), std::back_inserter(symbol_vec),
-                 [this](absl::string_view x) { return toSymbol(x); });
+  {
+    Thread::LockGuard lock(lock_);
+    std::transform(name_vec.begin(), name_vec.end(), std::back_inserter(symbol_vec),
+                   [this](absl::string_view x) { return toSymbol(x); });
+  }
 
-  return std::make_unique<StatNameImpl>(symbol_vec, *this);
+  return StatNameImpl(symbol_vec, *this);
 }
 
 std::string SymbolTableImpl::decode(const SymbolVec& symbol_vec) const {
   std::vector<absl::string_view> name;
   name.reserve(symbol_vec.size());
+  // The segments are joined under the lock, as the views point into the table.
+  Thread::LockGuard lock(lock_);
   std::transform(symbol_vec.begin(), symbol_vec.end(), std::back_inserter(name),
                  [this](Symbol x) { return fromSymbol(x); });
   return absl::StrJoin(name, ".");
 }
 
 void SymbolTableImpl::free(const SymbolVec& symbol_vec) {
+  Thread::LockGuard lock(lock_);
   for (const Symbol symbol : symbol_vec) {
     auto decode_search = decode_map_.find(symbol);
     ASSERT(decode_search != decode_map_.end());
@@ -82,5 +126,44 @@ absl::string_view SymbolTableImpl::fromSymbol(const Symbol symbol) const {
   return search->second;
 }
 
+StatNameImpl::StatNameImpl(const SymbolVec& symbol_vec, SymbolTableImpl& symbol_table)
+    : symbol_table_(symbol_table) {
+  size_t encoding_size = 0;
+  for (const Symbol symbol : symbol_vec) {
+    encoding_size += varintSize(symbol);
+  }
+  storage_ = std::make_unique<uint8_t[]>(varintSize(encoding_size) + encoding_size);
+  uint8_t* out = writeVarint(encoding_size, storage_.get());
+  for (const Symbol symbol : symbol_vec) {
+    out = writeVarint(symbol, out);
+  }
+}
+
+StatNameImpl::~StatNameImpl() {
+  // Nothing to free if the name was moved away.
+  if (storage_ != nullptr) {
+    symbol_table_.free(symbolVec());
+  }
+}
+
+absl::string_view StatNameImpl::encoding() const {
+  uint64_t encoding_size;
+  const uint8_t* encoding = readVarint(storage_.get(), encoding_size);
+  return absl::string_view(reinterpret_cast<const char*>(encoding), encoding_size);
+}
+
+SymbolVec StatNameImpl::symbolVec() const {
+  SymbolVec symbol_vec;
+  const absl::string_view encoding = this->encoding();
+  const uint8_t* in = reinterpret_cast<const uint8_t*>(encoding.data());
+  const uint8_t* end = in + encoding.size();
+  while (in < end) {
+    uint64_t symbol;
+    in = readVarint(in, symbol);
+    symbol_vec.push_back(static_cast<Symbol>(symbol));
+  }
+  return symbol_vec;
+}
+
 } // namespace Stats
 } // namespace Envoy
@@ -11,6 +11,9 @@
 #include "envoy/stats/symbol_table.h"
 
 #include "common/common/assert.h"
+#include "common/common/lock_guard.h"
+#include "common/common/thread.h"
+#include "common/common/thread_annotations.h"
 #include "common/common/utility.h"
 
 #include "absl/strings/str_join.h"
@@ -22,6 +25,8 @@ namespace Stats {
 using Symbol = uint32_t;
 using SymbolVec = std::vector<Symbol>;
 
+class StatNameImpl;
+
 /**
  * Underlying SymbolTableImpl implementation which manages per-symbol reference counting.
  *
@@ -29,13 +34,25 @@ using SymbolVec = std::vector<Symbol>;
  * effect of the non-monotonically-increasing symbol counter is that if a string is encoded, the
  * resulting stat is destroyed, and then that same string is re-encoded, it may or may not encode to
  * the same underlying symbol.
+ *
+ * The table is thread safe, as stats are created and destroyed from all threads.
  */
 class SymbolTableImpl : public SymbolTable {
 public:
   StatNamePtr encode(absl::string_view name) override;
 
+  /**
+   * Like encode(), but returns the name by value so that callers can embed it in their own
+   * storage rather than pay for a separate allocation.
+   *
+   * @param name the stat name to encode.
+   * @return StatNameImpl the encoded name.
+   */
+  StatNameImpl encodeInline(absl::string_view name);
+
   // For testing purposes only.
   size_t size() const override {
+    Thread::LockGuard lock(lock_);
     ASSERT(encode_map_.size() == decode_map_.size());
     return encode_map_.size();
   }
@@ -74,7 +91,7 @@ private:
    * @param sv the individual string to be encoded as a symbol.
    * @return Symbol the encoded string.
    */
-  Symbol toSymbol(absl::string_view sv);
+  Symbol toSymbol(absl::string_view sv) EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
   /**
    * Convenience function for decode(), decoding one symbol at a time.
@@ -82,10 +99,10 @@ private:
    * @param symbol the individual symbol to be decoded.
    * @return absl::string_view the decoded string.
    */
-  absl::string_view fromSymbol(Symbol symbol) const;
+  absl::string_view fromSymbol(Symbol symbol) const EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
   // Stages a new symbol for use. To be called after a successful insertion.
-  void newSymbol() {
+  void newSymbol() EXCLUSIVE_LOCKS_REQUIRED(lock_) {
     if (pool_.empty()) {
       next_symbol_ = ++monotonic_counter_;
     } else {
@@ -96,42 +113,58 @@ private:
     ASSERT(monotonic_counter_ != 0);
   }
 
-  Symbol monotonicCounter() { return monotonic_counter_; }
+  Symbol monotonicCounter() {
+    Thread::LockGuard lock(lock_);
+    return monotonic_counter_;
+  }
+
+  mutable Thread::MutexBasicLockable lock_;
 
   // Stores the symbol to be used at next insertion. This should exist ahead of insertion time so
   // that if insertion succeeds, the value written is the correct one.
-  Symbol next_symbol_ = 0;
+  Symbol next_symbol_ GUARDED_BY(lock_) = 0;
 
   // If the free pool is exhausted, we monotonically increase this counter.
-  Symbol monotonic_counter_ = 0;
+  Symbol monotonic_counter_ GUARDED_BY(lock_) = 0;
 
   // Bimap implementation.
   // The encode map stores both the symbol and the ref count of that symbol.
   // Using absl::string_view lets us only store the complete string once, in the decode map.
-  std::unordered_map<absl::string_view, SharedSymbol, StringViewHash> encode_map_;
-  std::unordered_map<Symbol, std::string> decode_map_;
+  std::unordered_map<absl::string_view, SharedSymbol, StringViewHash> encode_map_ GUARDED_BY(lock_);
+  std::unordered_map<Symbol, std::string> decode_map_ GUARDED_BY(lock_);
 
   // Free pool of symbols for re-use.
   // TODO(ambuc): There might be an optimization here relating to storing ranges of freed symbols
   // using an Envoy::IntervalSet.
-  std::stack<Symbol> pool_;
+  std::stack<Symbol> pool_ GUARDED_BY(lock_);
 };
 
 /**
  * Implements RAII for Symbols, since the StatName destructor does the work of freeing its component
- * symbols.
+ * symbols. The symbols are stored as varints in a single allocation, so that a name made of
+ * commonly used segments costs a few bytes rather than a copy of the string.
  */
 class StatNameImpl : public StatName {
 public:
-  StatNameImpl(SymbolVec symbol_vec, SymbolTableImpl& symbol_table)
-      : symbol_vec_(symbol_vec), symbol_table_(symbol_table) {}
-  ~StatNameImpl() override { symbol_table_.free(symbol_vec_); }
-  std::string toString() const override { return symbol_table_.decode(symbol_vec_); }
+  StatNameImpl(const SymbolVec& symbol_vec, SymbolTableImpl& symbol_table);
+  StatNameImpl(StatNameImpl&& src) noexcept
+      : storage_(std::move(src.storage_)), symbol_table_(src.symbol_table_) {}
+  ~StatNameImpl() override;
+  std::string toString() const override { return symbol_table_.decode(symbolVec()); }
+
+  /**
+   * @return absl::string_view the encoded symbols. While both names are alive, two names from the
+   *         same table have the same encoding if and only if they are equal, so the encoding can
+   *         be hashed and compared in place of the name.
+   */
+  absl::string_view encoding() const;
 
 private:
   friend class StatNameTest;
-  SymbolVec symbolVec() { return symbol_vec_; }
-  SymbolVec symbol_vec_;
+  SymbolVec symbolVec() const;
+
+  // A varint holding the size of the encoding, followed by the encoding: one varint per symbol.
+  std::unique_ptr<uint8_t[]> storage_;
   SymbolTableImpl& symbol_table_;
 };
 
@@ -2,15 +2,18 @@
 
 #include <string.h>
 
+#include <algorithm>
 #include <string>
 
 #include "envoy/common/exception.h"
 
+#include "common/common/assert.h"
 #include "common/common/perf_annotation.h"
 #include "common/common/utility.h"
 
 #include "absl/strings/ascii.h"
 #include "absl/strings/match.h"
+#include "absl/strings/str_split.h"
 
 namespace Envoy {
 namespace Stats {
@@ -103,5 +106,73 @@ bool TagExtractorImpl::extractTag(const std::string& stat_name, std::vector<Tag>
   return false;
 }
 
+TagExtractorTokensImpl::TagExtractorTokensImpl(const std::string& name, const std::string& pattern)
+    : name_(name), pattern_(absl::StrSplit(pattern, '.')),
+      prefix_(pattern_[0] == "$" || pattern_[0] == "*" || pattern_[0] == "**" ? "" : pattern_[0]) {
+  ASSERT(!name.empty());
+  ASSERT(std::count(pattern_.begin(), pattern_.end(), "$") == 1);
+}
+
+bool TagExtractorTokensImpl::extractTag(const std::string& stat_name, std::vector<Tag>& tags,
+                                        IntervalSet<size_t>& remove_characters) const {
+  PERF_OPERATION(perf);
+
+  size_t value_start;
+  if (!match(stat_name, 0, 0, value_start)) {
+    PERF_RECORD(perf, "tokens-miss", name_);
+    return false;
+  }
+
+  // The value is never the last token, so there is always a dot after it, which is removed too.
+  const size_t value_end = stat_name.find('.', value_start);
+  tags.emplace_back();
+  Tag& tag = tags.back();
+  tag.name_ = name_;
+  tag.value_ = stat_name.substr(value_start, value_end - value_start);
+  remove_characters.insert(value_start, value_end + 1);
+  PERF_RECORD(perf, "tokens-match", name_);
+  return true;
+}
+
+bool TagExtractorTokensImpl::match(absl::string_view stat_name, size_t pos, size_t pattern_index,
+                                   size_t& value_start) const {
+  for (; pattern_index < pattern_.size(); ++pattern_index) {
+    const std::string& pattern_token = pattern_[pattern_index];
+    if (pattern_token == "**") {
+      if (pattern_index + 1 == pattern_.size()) {
+        return true;
+      }
+      // Try the rest of the pattern after skipping as few tokens as possible.
+      while (!match(stat_name, pos, pattern_index + 1, value_start)) {
+        if (pos == absl::string_view::npos) {
+          return false;
+        }
+        pos = nextToken(stat_name, pos);
+      }
+      return true;
+    }
+
+    if (pos == absl::string_view::npos) {
+      return false;
+    }
+    const size_t end = stat_name.find('.', pos);
+    if (pattern_token == "$") {
+      if (end == absl::string_view::npos) {
+        return false;
+      }
+      value_start = pos;
+    } else if (pattern_token != "*" && pattern_token != stat_name.substr(pos, end - pos)) {
+      return false;
+    }
+    pos = nextToken(stat_name, pos);
+  }
+  return pos == absl::string_view::npos;
+}
+
+size_t TagExtractorTokensImpl::nextToken(absl::string_view stat_name, size_t pos) {
+  const size_t end = stat_name.find('.', pos);
+  return end == absl::string_view::npos ? end : end + 1;
+}
+
 } // namespace Stats
 } // namespace Envoy
@@ -49,6 +49,14 @@ private:
    */
   void addExtractor(TagExtractorPtr extractor);
 
+  /**
+   * Creates the extractor for one of the default tags, using its token pattern if it has one, and
+   * its regex otherwise.
+   * @param desc the default tag.
+   * @return TagExtractorPtr the extractor.
+   */
+  static TagExtractorPtr createDefaultExtractor(const Config::TagNameValues::Descriptor& desc);
+
   /**
    * Adds all default extractors matching the specified tag name. In this model,
    * more than one TagExtractor can be used to generate a given tag. The default
@@ -1,5 +1,6 @@
 #include "common/stats/thread_local_store.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <list>
@@ -21,6 +22,15 @@
 namespace Envoy {
 namespace Stats {
 
+namespace {
+
+// Histograms merged per helper thread. Smaller sets are merged on the main thread alone, as
+// starting a thread would cost more than it saves.
+constexpr size_t HistogramsPerMergeThread = 4096;
+constexpr size_t MaxMergeThreads = 4;
+
+} // namespace
+
 ThreadLocalStoreImpl::ThreadLocalStoreImpl(const StatsOptions& stats_options,
                                            StatDataAllocator& alloc)
     : stats_options_(stats_options), alloc_(alloc), default_scope_(createScope("")),
@@ -36,9 +46,10 @@ ThreadLocalStoreImpl::~ThreadLocalStoreImpl() {
 std::vector<CounterSharedPtr> ThreadLocalStoreImpl::counters() const {
   // Handle de-dup due to overlapping scopes.
   std::vector<CounterSharedPtr> ret;
-  std::unordered_set<std::string> names;
+  std::unordered_set<absl::string_view, StringViewHash> names;
   Thread::LockGuard lock(lock_);
   for (ScopeImpl* scope : scopes_) {
+    Thread::LockGuard scope_lock(scope->central_cache_lock_);
     for (auto& counter : scope->central_cache_.counters_) {
       if (names.insert(counter.first).second) {
         ret.push_back(counter.second);
@@ -59,9 +70,10 @@ ScopePtr ThreadLocalStoreImpl::createScope(const std::string& name) {
 std::vector<GaugeSharedPtr> ThreadLocalStoreImpl::gauges() const {
   // Handle de-dup due to overlapping scopes.
   std::vector<GaugeSharedPtr> ret;
-  std::unordered_set<std::string> names;
+  std::unordered_set<absl::string_view, StringViewHash> names;
   Thread::LockGuard lock(lock_);
   for (ScopeImpl* scope : scopes_) {
+    Thread::LockGuard scope_lock(scope->central_cache_lock_);
     for (auto& gauge : scope->central_cache_.gauges_) {
       if (names.insert(gauge.first).second) {
         ret.push_back(gauge.second);
@@ -81,6 +93,7 @@ std::vector<ParentHistogramSharedPtr> ThreadLocalStoreImpl::histograms() const {
   // in histograms with duplicate names, but until shared storage is implemented it's ultimately
   // less confusing for users who have such configs.
   for (ScopeImpl* scope : scopes_) {
+    Thread::LockGuard scope_lock(scope->central_cache_lock_);
     for (const auto& name_histogram_pair : scope->central_cache_.histograms_) {
       const ParentHistogramSharedPtr& parent_hist = name_histogram_pair.second;
       ret.push_back(parent_hist);
@@ -127,14 +140,33 @@ void ThreadLocalStoreImpl::mergeHistograms(PostMergeCb merge_complete_cb) {
 
 void ThreadLocalStoreImpl::mergeInternal(PostMergeCb merge_complete_cb) {
   if (!shutting_down_) {
-    for (const ParentHistogramSharedPtr& histogram : histograms()) {
-      histogram->merge();
+    // Histograms merge independently of each other, so large sets are split between the main
+    // thread and a few helper threads, which are joined before the sinks run.
+    const std::vector<ParentHistogramSharedPtr> histograms = this->histograms();
+    const size_t shards =
+        std::min(MaxMergeThreads, histograms.size() / HistogramsPerMergeThread) + 1;
+    std::vector<Thread::ThreadPtr> helpers;
+    for (size_t shard = 1; shard < shards; shard++) {
+      helpers.emplace_back(new Thread::Thread(
+          [&histograms, shard, shards]() -> void { mergeShard(histograms, shard, shards); }));
     }
+    mergeShard(histograms, 0, shards);
+    for (Thread::ThreadPtr& helper : helpers) {
+      helper->join();
+    }
+
     merge_complete_cb();
     merge_in_progress_ = false;
   }
 }
 
+void ThreadLocalStoreImpl::mergeShard(const std::vector<ParentHistogramSharedPtr>& histograms,
+                                      size_t shard, size_t shards) {
+  for (size_t i = shard; i < histograms.size(); i += shards) {
+    histograms[i]->merge();
+  }
+}
+
 void ThreadLocalStoreImpl::releaseScopeCrossThread(ScopeImpl* scope) {
   Thread::LockGuard lock(lock_);
   ASSERT(scopes_.count(scope) == 1);
@@ -191,55 +223,72 @@ template <class StatType>
 StatType& ThreadLocalStoreImpl::ScopeImpl::safeMakeStat(
     const std::string& name,
     std::unordered_map<std::string, std::shared_ptr<StatType>>& central_cache_map,
-    MakeStatFn<StatType> make_stat, std::shared_ptr<StatType>* tls_ref) {
+    MakeStatFn<StatType> make_stat, TlsStatMap<std::shared_ptr<StatType>>* tls_cache) {
 
   // If we have a valid cache entry, return it.
-  if (tls_ref && *tls_ref) {
-    return **tls_ref;
+  if (tls_cache) {
+    auto tls_iter = tls_cache->find(name);
+    if (tls_iter != tls_cache->end()) {
+      return *tls_iter->second;
+    }
   }
 
-  // We must now look in the central store so we must be locked. We grab a reference to the
-  // central store location. It might contain nothing. In this case, we allocate a new stat.
-  Thread::LockGuard lock(parent_.lock_);
-  std::shared_ptr<StatType>& central_ref = central_cache_map[name];
-  if (!central_ref) {
-    std::vector<Tag> tags;
-
-    // Tag extraction occurs on the original, untruncated name so the extraction
-    // can complete properly, even if the tag values are partially truncated.
-    std::string tag_extracted_name = parent_.getTagsForName(name, tags);
-    absl::string_view truncated_name = parent_.truncateStatNameIfNeeded(name);
-    std::shared_ptr<StatType> stat =
-        make_stat(parent_.alloc_, truncated_name, std::move(tag_extracted_name), std::move(tags));
-    if (stat == nullptr) {
-      parent_.num_last_resort_stats_.inc();
-      stat = make_stat(parent_.heap_allocator_, truncated_name, std::move(tag_extracted_name),
-                       std::move(tags));
-      ASSERT(stat != nullptr);
+  // We must now look in the central store, which is shared by all threads, so we must be locked.
+  // The scope's lock is only held for lookups and insertions. Workers creating stats of other
+  // scopes do not contend for it at all.
+  {
+    Thread::LockGuard lock(central_cache_lock_);
+    auto central_iter = central_cache_map.find(name);
+    if (central_iter != central_cache_map.end()) {
+      // If we have a TLS cache to store the stat into, do it. The key refers to the name held by
+      // the central cache.
+      if (tls_cache) {
+        tls_cache->emplace(central_iter->first, central_iter->second);
+      }
+      return *central_iter->second;
     }
-    central_ref = stat;
   }
 
-  // If we have a TLS location to store or allocation into, do it.
-  if (tls_ref) {
-    *tls_ref = central_ref;
+  // The stat does not exist yet. Tag extraction and allocation are comparatively expensive, so
+  // they happen outside the lock. Tag extraction occurs on the original, untruncated name so the
+  // extraction can complete properly, even if the tag values are partially truncated.
+  std::vector<Tag> tags;
+  std::string tag_extracted_name = parent_.getTagsForName(name, tags);
+  absl::string_view truncated_name = parent_.truncateStatNameIfNeeded(name);
+  std::shared_ptr<StatType> stat =
+      make_stat(parent_.alloc_, truncated_name, std::move(tag_extracted_name), std::move(tags));
+  const bool last_resort = (stat == nullptr);
+  if (last_resort) {
+    stat = make_stat(parent_.heap_allocator_, truncated_name, std::move(tag_extracted_name),
+                     std::move(tags));
+    ASSERT(stat != nullptr);
+  }
+
+  // Another thread may have created the same stat in the meantime, in which case ours is dropped
+  // in favor of it. Allocators hand out the same backing data for the same name, so nothing that
+  // was recorded is lost.
+  Thread::LockGuard lock(central_cache_lock_);
+  auto inserted = central_cache_map.emplace(name, std::move(stat));
+  if (inserted.second && last_resort) {
+    parent_.num_last_resort_stats_.inc();
+  }
+  if (tls_cache) {
+    tls_cache->emplace(inserted.first->first, inserted.first->second);
   }
 
   // Finally we return the reference.
-  return *central_ref;
+  return *inserted.first->second;
 }
 
 Counter& ThreadLocalStoreImpl::ScopeImpl::counter(const std::string& name) {
   // Determine the final name based on the prefix and the passed name.
   std::string final_name = prefix_ + name;
 
-  // We now try to acquire a *reference* to the TLS cache shared pointer. This might remain null
-  // if we don't have TLS initialized currently. The de-referenced pointer might be null if there
-  // is no cache entry.
-  CounterSharedPtr* tls_ref = nullptr;
+  // We now try to acquire a pointer to the TLS cache. This might remain null if we don't have TLS
+  // initialized currently.
+  TlsStatMap<CounterSharedPtr>* tls_cache = nullptr;
   if (!parent_.shutting_down_ && parent_.tls_) {
-    tls_ref =
-        &parent_.tls_->getTyped<TlsCache>().scope_cache_[this->scope_id_].counters_[final_name];
+    tls_cache = &parent_.tls_->getTyped<TlsCache>().scope_cache_[this->scope_id_].counters_;
   }
 
   return safeMakeStat<Counter>(
@@ -248,7 +297,7 @@ Counter& ThreadLocalStoreImpl::ScopeImpl::counter(const std::string& name) {
          std::vector<Tag>&& tags) -> CounterSharedPtr {
         return allocator.makeCounter(name, std::move(tag_extracted_name), std::move(tags));
       },
-      tls_ref);
+      tls_cache);
 }
 
 void ThreadLocalStoreImpl::ScopeImpl::deliverHistogramToSinks(const Histogram& histogram,
@@ -271,9 +320,9 @@ Gauge& ThreadLocalStoreImpl::ScopeImpl::gauge(const std::string& name) {
   // See comments in counter(). There is no super clean way (via templates or otherwise) to
   // share this code so I'm leaving it largely duplicated for now.
   std::string final_name = prefix_ + name;
-  GaugeSharedPtr* tls_ref = nullptr;
+  TlsStatMap<GaugeSharedPtr>* tls_cache = nullptr;
   if (!parent_.shutting_down_ && parent_.tls_) {
-    tls_ref = &parent_.tls_->getTyped<TlsCache>().scope_cache_[this->scope_id_].gauges_[final_name];
+    tls_cache = &parent_.tls_->getTyped<TlsCache>().scope_cache_[this->scope_id_].gauges_;
   }
 
   return safeMakeStat<Gauge>(
@@ -282,38 +331,45 @@ Gauge& ThreadLocalStoreImpl::ScopeImpl::gauge(const std::string& name) {
          std::vector<Tag>&& tags) -> GaugeSharedPtr {
         return allocator.makeGauge(name, std::move(tag_extracted_name), std::move(tags));
       },
-      tls_ref);
+      tls_cache);
 }
 
 Histogram& ThreadLocalStoreImpl::ScopeImpl::histogram(const std::string& name) {
   // See comments in counter(). There is no super clean way (via templates or otherwise) to
   // share this code so I'm leaving it largely duplicated for now.
   std::string final_name = prefix_ + name;
-  ParentHistogramSharedPtr* tls_ref = nullptr;
-
+  TlsStatMap<ParentHistogramSharedPtr>* tls_cache = nullptr;
   if (!parent_.shutting_down_ && parent_.tls_) {
-    tls_ref = &parent_.tls_->getTyped<TlsCache>()
-                   .scope_cache_[this->scope_id_]
-                   .parent_histograms_[final_name];
-  }
-
-  if (tls_ref && *tls_ref) {
-    return **tls_ref;
+    tls_cache =
+        &parent_.tls_->getTyped<TlsCache>().scope_cache_[this->scope_id_].parent_histograms_;
+    auto tls_iter = tls_cache->find(final_name);
+    if (tls_iter != tls_cache->end()) {
+      return *tls_iter->second;
+    }
   }
 
-  Thread::LockGuard lock(parent_.lock_);
-  ParentHistogramImplSharedPtr& central_ref = central_cache_.histograms_[final_name];
-  if (!central_ref) {
-    std::vector<Tag> tags;
-    std::string tag_extracted_name = parent_.getTagsForName(final_name, tags);
-    central_ref.reset(new ParentHistogramImpl(final_name, parent_, *this,
-                                              std::move(tag_extracted_name), std::move(tags)));
+  {
+    Thread::LockGuard lock(central_cache_lock_);
+    auto central_iter = central_cache_.histograms_.find(final_name);
+    if (central_iter != central_cache_.histograms_.end()) {
+      if (tls_cache) {
+        tls_cache->emplace(central_iter->first, central_iter->second);
+      }
+      return *central_iter->second;
+    }
   }
 
-  if (tls_ref) {
-    *tls_ref = central_ref;
+  std::vector<Tag> tags;
+  std::string tag_extracted_name = parent_.getTagsForName(final_name, tags);
+  ParentHistogramImplSharedPtr stat = std::make_shared<ParentHistogramImpl>(
+      final_name, parent_, *this, std::move(tag_extracted_name), std::move(tags));
+
+  Thread::LockGuard lock(central_cache_lock_);
+  auto inserted = central_cache_.histograms_.emplace(final_name, std::move(stat));
+  if (tls_cache) {
+    tls_cache->emplace(inserted.first->first, inserted.first->second);
   }
-  return *central_ref;
+  return *inserted.first->second;
 }
 
 Histogram& ThreadLocalStoreImpl::ScopeImpl::tlsHistogram(const std::string& name,
@@ -322,13 +378,13 @@ Histogram& ThreadLocalStoreImpl::ScopeImpl::tlsHistogram(const std::string& name
 
   // Here prefix will not be considered because, by the time ParentHistogram calls this method
   // during recordValue, the prefix is already attached to the name.
-  TlsHistogramSharedPtr* tls_ref = nullptr;
+  TlsStatMap<TlsHistogramSharedPtr>* tls_cache = nullptr;
   if (!parent_.shutting_down_ && parent_.tls_) {
-    tls_ref = &parent_.tls_->getTyped<TlsCache>().scope_cache_[this->scope_id_].histograms_[name];
-  }
-
-  if (tls_ref && *tls_ref) {
-    return **tls_ref;
+    tls_cache = &parent_.tls_->getTyped<TlsCache>().scope_cache_[this->scope_id_].histograms_;
+    auto tls_iter = tls_cache->find(name);
+    if (tls_iter != tls_cache->end()) {
+      return *tls_iter->second;
+    }
   }
 
   std::vector<Tag> tags;
@@ -338,8 +394,8 @@ Histogram& ThreadLocalStoreImpl::ScopeImpl::tlsHistogram(const std::string& name
 
   parent.addTlsHistogram(hist_tls_ptr);
 
-  if (tls_ref) {
-    *tls_ref = hist_tls_ptr;
+  if (tls_cache) {
+    tls_cache->emplace(name, hist_tls_ptr);
   }
   return *hist_tls_ptr;
 }
@@ -360,14 +416,38 @@ ThreadLocalHistogramImpl::~ThreadLocalHistogramImpl() {
 
 void ThreadLocalHistogramImpl::recordValue(uint64_t value) {
   ASSERT(std::this_thread::get_id() == created_thread_id_);
-  hist_insert_intscale(histograms_[current_active_], value, 0, 1);
+  buffered_values_[num_buffered_values_++] = value;
+  if (num_buffered_values_ == MaxBufferedValues) {
+    flushBufferedValues();
+  }
+  has_values_[current_active_] = true;
   flags_ |= Flags::Used;
 }
 
-void ThreadLocalHistogramImpl::merge(histogram_t* target) {
-  histogram_t** other_histogram = &histograms_[otherHistogramIndex()];
+void ThreadLocalHistogramImpl::flushBufferedValues() {
+  // Sorting brings equal values together, so that each is inserted once with its count.
+  std::sort(buffered_values_.begin(), buffered_values_.begin() + num_buffered_values_);
+  for (size_t i = 0; i < num_buffered_values_;) {
+    const uint64_t value = buffered_values_[i];
+    const size_t first = i;
+    while (i < num_buffered_values_ && buffered_values_[i] == value) {
+      ++i;
+    }
+    hist_insert_intscale(histograms_[current_active_], value, 0, i - first);
+  }
+  num_buffered_values_ = 0;
+}
+
+bool ThreadLocalHistogramImpl::merge(histogram_t* target) {
+  const uint64_t other_index = otherHistogramIndex();
+  if (!has_values_[other_index]) {
+    return false;
+  }
+  histogram_t** other_histogram = &histograms_[other_index];
   hist_accumulate(target, other_histogram, 1);
   hist_clear(*other_histogram);
+  has_values_[other_index] = false;
+  return true;
 }
 
 ParentHistogramImpl::ParentHistogramImpl(const std::string& name, Store& parent,
@@ -384,7 +464,7 @@ ParentHistogramImpl::~ParentHistogramImpl() {
 }
 
 void ParentHistogramImpl::recordValue(uint64_t value) {
-  Histogram& tls_histogram = tls_scope_.tlsHistogram(name(), *this);
+  Histogram& tls_histogram = tls_scope_.tlsHistogram(name_, *this);
   tls_histogram.recordValue(value);
   parent_.deliverHistogramToSinks(*this, value);
 }
@@ -397,19 +477,29 @@ bool ParentHistogramImpl::used() const {
 void ParentHistogramImpl::merge() {
   Thread::ReleasableLockGuard lock(merge_lock_);
   if (merged_ || usedLockHeld()) {
-    hist_clear(interval_histogram_);
+    if (interval_has_values_) {
+      hist_clear(interval_histogram_);
+    }
     // Here we could copy all the pointers to TLS histograms in the tls_histogram_ list,
     // then release the lock before we do the actual merge. However it is not a big deal
     // because the tls_histogram merge is not that expensive as it is a single histogram
     // merge and adding TLS histograms is rare.
+    bool has_values = false;
     for (const TlsHistogramSharedPtr& tls_histogram : tls_histograms_) {
-      tls_histogram->merge(interval_histogram_);
+      has_values |= tls_histogram->merge(interval_histogram_);
     }
     // Since TLS merge is done, we can release the lock here.
     lock.release();
-    hist_accumulate(cumulative_histogram_, &interval_histogram_, 1);
-    cumulative_statistics_.refresh(cumulative_histogram_);
-    interval_statistics_.refresh(interval_histogram_);
+    // Without new values, the cumulative histogram is unchanged and the interval one is empty.
+    // Quantiles are only computed once a sink or admin reads them.
+    if (has_values) {
+      hist_accumulate(cumulative_histogram_, &interval_histogram_, 1);
+      cumulative_statistics_.refreshLazily(cumulative_histogram_);
+    }
+    if (has_values || interval_has_values_ || !merged_) {
+      interval_statistics_.refreshLazily(interval_histogram_);
+    }
+    interval_has_values_ = has_values;
     merged_ = true;
   }
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <cstdint>
@@ -10,6 +11,7 @@
 
 #include "envoy/thread_local/thread_local.h"
 
+#include "common/common/utility.h"
 #include "common/stats/heap_stat_data.h"
 #include "common/stats/histogram_impl.h"
 #include "common/stats/source_impl.h"
@@ -23,7 +25,9 @@ namespace Stats {
 /**
  * A histogram that is stored in TLS and used to record values per thread. This holds two
  * histograms, one to collect the values and other as backup that is used for merge process. The
- * swap happens during the merge process.
+ * swap happens during the merge process. Recorded values are first appended to a small buffer,
+ * which is folded into the collecting histogram when it fills up and at the start of each merge,
+ * so that repeated values, which are common for timings, are inserted once with their count.
  */
 class ThreadLocalHistogramImpl : public Histogram, public MetricImpl {
 public:
@@ -31,7 +35,12 @@ public:
                            std::vector<Tag>&& tags);
   ~ThreadLocalHistogramImpl();
 
-  void merge(histogram_t* target);
+  /**
+   * Merge the values collected before the last beginMerge() into target.
+   * @param target supplies the histogram to merge into.
+   * @return bool whether there were any values to merge.
+   */
+  bool merge(histogram_t* target);
 
   /**
    * Called in the beginning of merge process. Swaps the histogram used for collection so that we do
@@ -40,6 +49,7 @@ public:
   void beginMerge() {
     // This switches the current_active_ between 1 and 0.
     ASSERT(std::this_thread::get_id() == created_thread_id_);
+    flushBufferedValues();
     current_active_ = otherHistogramIndex();
   }
 
@@ -51,9 +61,19 @@ public:
   const std::string name() const override { return name_; }
 
 private:
+  static constexpr size_t MaxBufferedValues = 32;
+
   uint64_t otherHistogramIndex() const { return 1 - current_active_; }
+  void flushBufferedValues();
+
   uint64_t current_active_;
   histogram_t* histograms_[2];
+  // Values recorded since the last flush, which belong to the active histogram.
+  std::array<uint64_t, MaxBufferedValues> buffered_values_;
+  size_t num_buffered_values_{};
+  // Whether each of histograms_ holds values that have not been merged yet. Written by the owning
+  // thread for the active histogram, and by the merge for the other one.
+  bool has_values_[2]{};
   std::atomic<uint16_t> flags_;
   std::thread::id created_thread_id_;
   const std::string name_;
@@ -105,6 +125,7 @@ private:
   mutable Thread::MutexBasicLockable merge_lock_;
   std::list<TlsHistogramSharedPtr> tls_histograms_ GUARDED_BY(merge_lock_);
   bool merged_;
+  bool interval_has_values_{};
   const std::string name_;
 };
 
@@ -120,7 +141,8 @@ public:
   // TODO(ramaraochavali): Allow direct TLS access for the advanced consumers.
   /**
    * @return a ThreadLocalHistogram within the scope's namespace.
-   * @param name name of the histogram with scope prefix attached.
+   * @param name name of the histogram with scope prefix attached. Must be owned by the parent
+   *             histogram, as it may be referenced by the thread local cache.
    */
   virtual Histogram& tlsHistogram(const std::string& name, ParentHistogramImpl& parent) PURE;
 };
@@ -141,6 +163,9 @@ public:
  * - Scopes can be deleted from any thread, and they are in practice as scopes are likely to be
  *   shared across all worker threads.
  * - Per thread caches are checked, and if empty, they are populated from the central cache.
+ * - Each scope's central cache has its own lock, which is only held to look up and insert stats.
+ *   Tag extraction and allocation of new stats happen outside of it, and if two threads race to
+ *   create the same stat, the first one to insert it wins.
  * - Scopes are entirely owned by the caller. The store only keeps weak pointers.
  * - When a scope is destroyed, a cache flush operation is run on all threads to flush any cached
  *   data owned by the destroyed scope.
@@ -211,11 +236,18 @@ public:
   const Stats::StatsOptions& statsOptions() const override { return stats_options_; }
 
 private:
+  // The TLS caches are keyed by views of the names held by the central cache, or by the parent
+  // histogram in the case of TLS histograms, so that each worker does not keep its own copy of
+  // every name. The keys are only looked at while the scope, and with it the central cache, is
+  // alive. Once the scope is destroyed, its TLS entries are flushed without any further lookups.
+  template <class StatType>
+  using TlsStatMap = std::unordered_map<absl::string_view, StatType, StringViewHash>;
+
   struct TlsCacheEntry {
-    std::unordered_map<std::string, CounterSharedPtr> counters_;
-    std::unordered_map<std::string, GaugeSharedPtr> gauges_;
-    std::unordered_map<std::string, TlsHistogramSharedPtr> histograms_;
-    std::unordered_map<std::string, ParentHistogramSharedPtr> parent_histograms_;
+    TlsStatMap<CounterSharedPtr> counters_;
+    TlsStatMap<GaugeSharedPtr> gauges_;
+    TlsStatMap<TlsHistogramSharedPtr> histograms_;
+    TlsStatMap<ParentHistogramSharedPtr> parent_histograms_;
   };
 
   struct CentralCacheEntry {
@@ -255,20 +287,25 @@ private:
      * @param name the full name of the stat (not tag extracted).
      * @param central_cache_map a map from name to the desired object in the central cache.
      * @param make_stat a function to generate the stat object, called if it's not in cache.
-     * @param tls_ref possibly null reference to a cache entry for this stat, which will be
-     *     used if non-empty, or filled in if empty (and non-null).
+     * @param tls_cache possibly null TLS cache for this kind of stat, which will be used if it
+     *     holds the stat, or filled in if it does not (and is non-null).
      */
     template <class StatType>
     StatType&
     safeMakeStat(const std::string& name,
                  std::unordered_map<std::string, std::shared_ptr<StatType>>& central_cache_map,
-                 MakeStatFn<StatType> make_stat, std::shared_ptr<StatType>* tls_ref);
+                 MakeStatFn<StatType> make_stat,
+                 TlsStatMap<std::shared_ptr<StatType>>* tls_cache);
 
     static std::atomic<uint64_t> next_scope_id_;
 
     const uint64_t scope_id_;
     ThreadLocalStoreImpl& parent_;
     const std::string prefix_;
+    // Guards central_cache_, so that TLS cache misses in different scopes proceed in parallel.
+    // Taken after the store's lock_ when both are needed. The maps are handed to safeMakeStat()
+    // by reference, so the guard is not expressed as a thread safety annotation.
+    mutable Thread::MutexBasicLockable central_cache_lock_;
     CentralCacheEntry central_cache_;
   };
 
@@ -287,6 +324,8 @@ private:
   void clearScopeFromCaches(uint64_t scope_id);
   void releaseScopeCrossThread(ScopeImpl* scope);
   void mergeInternal(PostMergeCb mergeCb);
+  static void mergeShard(const std::vector<ParentHistogramSharedPtr>& histograms, size_t shard,
+                         size_t shards);
   absl::string_view truncateStatNameIfNeeded(absl::string_view name);
 
   const Stats::StatsOptions& stats_options_;
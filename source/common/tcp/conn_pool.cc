@@ -1,5 +1,8 @@
 #include "common/tcp/conn_pool.h"
 
+#include <algorithm>
+#include <cmath>
+
 #include "envoy/event/dispatcher.h"
 #include "envoy/event/timer.h"
 #include "envoy/upstream/upstream.h"
@@ -74,6 +77,7 @@ ConnectionPool::Cancellable* ConnPoolImpl::newConnection(ConnectionPool::Callbac
     ready_conns_.front()->moveBetweenLists(ready_conns_, busy_conns_);
     ENVOY_CONN_LOG(debug, "using existing connection", *busy_conns_.front()->conn_);
     assignConnection(*busy_conns_.front(), callbacks);
+    prefetchConnections();
     return nullptr;
   }
 
@@ -92,6 +96,7 @@ ConnectionPool::Cancellable* ConnPoolImpl::newConnection(ConnectionPool::Callbac
     ENVOY_LOG(debug, "queueing request due to no available connections");
     PendingRequestPtr pending_request(new PendingRequest(*this, callbacks));
     pending_request->moveIntoList(std::move(pending_request), pending_requests_);
+    prefetchConnections();
     return pending_requests_.front().get();
   } else {
     ENVOY_LOG(debug, "max pending requests overflow");
@@ -180,6 +185,7 @@ void ConnPoolImpl::onConnectionEvent(ActiveConn& conn, Network::ConnectionEvent
   if (conn.connect_timer_) {
     conn.connect_timer_->disableTimer();
     conn.connect_timer_.reset();
+    connecting_conns_--;
   }
 
   // Note that the order in this function is important. Concretely, we must destroy the connect
@@ -232,6 +238,27 @@ void ConnPoolImpl::onUpstreamReady() {
   }
 }
 
+void ConnPoolImpl::prefetchConnections() {
+  const Upstream::ClusterInfo& cluster = host_->cluster();
+  if ((cluster.prefetchRatio() <= 1.0 && cluster.prefetchMinConnections() == 0) ||
+      !drained_callbacks_.empty()) {
+    return;
+  }
+
+  // Busy connections that are not connecting have been handed out. Keep ratio connections per
+  // handed out and pending request, and never fewer than the minimum pool size. As in the HTTP/1.1
+  // pool, disconnects do not prefetch so that an unreachable host is not reconnected in a loop.
+  const uint64_t requests = busy_conns_.size() - connecting_conns_ + pending_requests_.size();
+  const uint64_t wanted =
+      std::max<uint64_t>(cluster.prefetchMinConnections(),
+                         static_cast<uint64_t>(std::ceil(requests * cluster.prefetchRatio())));
+  while (ready_conns_.size() + busy_conns_.size() < wanted &&
+         cluster.resourceManager(priority_).connections().canCreate()) {
+    ENVOY_LOG(debug, "prefetching a connection");
+    createNewConnection();
+  }
+}
+
 void ConnPoolImpl::processIdleConnection(ActiveConn& conn, bool delay) {
   if (conn.wrapper_) {
     conn.wrapper_->invalidate();
@@ -309,6 +336,7 @@ ConnPoolImpl::ActiveConn::ActiveConn(ConnPoolImpl& parent)
       connect_timer_(parent_.dispatcher_.createTimer([this]() -> void { onConnectTimeout(); })),
       remaining_requests_(parent_.host_->cluster().maxRequestsPerConnection()), timed_out_(false) {
 
+  parent_.connecting_conns_++;
   parent_.conn_connect_ms_.reset(
       new Stats::Timespan(parent_.host_->cluster().stats().upstream_cx_connect_ms_));
 
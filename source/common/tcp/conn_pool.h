@@ -29,6 +29,7 @@ public:
   // ConnectionPool::Instance
   void addDrainedCallback(DrainedCb cb) override;
   void drainConnections() override;
+  void prefetch() override { prefetchConnections(); }
   ConnectionPool::Cancellable* newConnection(ConnectionPool::Callbacks& callbacks) override;
 
 protected:
@@ -139,6 +140,7 @@ protected:
   virtual void onConnReleased(ActiveConn& conn);
   virtual void onConnDestroyed(ActiveConn& conn);
   void onUpstreamReady();
+  void prefetchConnections();
   void processIdleConnection(ActiveConn& conn, bool delay);
   void checkForDrained();
 
@@ -151,6 +153,8 @@ protected:
   std::list<ActiveConnPtr> busy_conns_;
   std::list<PendingRequestPtr> pending_requests_;
   std::list<DrainedCb> drained_callbacks_;
+  // Connections in busy_conns_ that are still connecting and so have not been handed out.
+  uint64_t connecting_conns_{};
   Stats::TimespanPtr conn_connect_ms_;
   Event::TimerPtr upstream_ready_timer_;
   bool upstream_ready_enabled_{false};
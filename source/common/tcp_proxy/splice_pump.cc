@@ -0,0 +1,128 @@
+#include "common/tcp_proxy/splice_pump.h"
+
+#include <errno.h>
+#include <fcntl.h>
+
+#include <cstring>
+
+#include "common/api/os_sys_calls_impl.h"
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace TcpProxy {
+
+namespace {
+#ifdef __linux__
+constexpr unsigned int SpliceFlags = SPLICE_F_MOVE | SPLICE_F_NONBLOCK;
+#else
+constexpr unsigned int SpliceFlags = 0;
+#endif
+} // namespace
+
+constexpr uint64_t SplicePump::PipeCapacity;
+
+std::unique_ptr<SplicePump> SplicePump::create(Event::Dispatcher& dispatcher, int downstream_fd,
+                                               int upstream_fd, SplicePumpCallbacks& callbacks) {
+  std::unique_ptr<SplicePump> pump(new SplicePump(downstream_fd, upstream_fd, callbacks));
+  auto& os_syscalls = Api::OsSysCallsSingleton::get();
+  for (Direction* direction : {&pump->downstream_to_upstream_, &pump->upstream_to_downstream_}) {
+    const Api::SysCallIntResult result =
+        os_syscalls.pipe2(direction->pipe_, O_NONBLOCK | O_CLOEXEC);
+    if (result.rc_ != 0) {
+      ENVOY_LOG(debug, "cannot create splice pipe: {}", strerror(result.errno_));
+      return nullptr;
+    }
+  }
+
+  // Both sockets may already have data waiting; an edge triggered event fires for the current
+  // state when it is added.
+  pump->downstream_event_ = dispatcher.createFileEvent(
+      downstream_fd, [pump = pump.get()](uint32_t) { pump->onFileEvent(); },
+      Event::FileTriggerType::Edge, Event::FileReadyType::Read | Event::FileReadyType::Write);
+  pump->upstream_event_ = dispatcher.createFileEvent(
+      upstream_fd, [pump = pump.get()](uint32_t) { pump->onFileEvent(); },
+      Event::FileTriggerType::Edge, Event::FileReadyType::Read | Event::FileReadyType::Write);
+  return pump;
+}
+
+SplicePump::SplicePump(int downstream_fd, int upstream_fd, SplicePumpCallbacks& callbacks)
+    : callbacks_(callbacks), downstream_to_upstream_(downstream_fd, upstream_fd, true),
+      upstream_to_downstream_(upstream_fd, downstream_fd, false) {}
+
+SplicePump::~SplicePump() {
+  auto& os_syscalls = Api::OsSysCallsSingleton::get();
+  for (Direction* direction : {&downstream_to_upstream_, &upstream_to_downstream_}) {
+    for (int fd : direction->pipe_) {
+      if (fd != -1) {
+        os_syscalls.close(fd);
+      }
+    }
+  }
+}
+
+void SplicePump::stop() { stopped_ = true; }
+
+void SplicePump::onFileEvent() {
+  // An event on either socket can unblock either direction: readable or writable sockets let data
+  // into or out of the pipes, and a drained pipe lets more data in.
+  if (stopped_ || !pump(downstream_to_upstream_)) {
+    return;
+  }
+  pump(upstream_to_downstream_);
+}
+
+bool SplicePump::pump(Direction& direction) {
+  auto& os_syscalls = Api::OsSysCallsSingleton::get();
+  bool progress = true;
+  while (progress) {
+    progress = false;
+
+    // Edge triggered events require reading until EAGAIN, or until the pipe is full, in which case
+    // the destination becoming writable will bring us back here.
+    if (!direction.end_stream_read_ && direction.bytes_in_pipe_ < PipeCapacity) {
+      const Api::SysCallSizeResult result =
+          os_syscalls.splice(direction.from_fd_, direction.pipe_[1],
+                             PipeCapacity - direction.bytes_in_pipe_, SpliceFlags);
+      if (result.rc_ > 0) {
+        direction.bytes_in_pipe_ += result.rc_;
+        progress = true;
+      } else if (result.rc_ == 0) {
+        direction.end_stream_read_ = true;
+        progress = true;
+      } else if (result.errno_ != EAGAIN) {
+        stopped_ = true;
+        callbacks_.onSpliceError(result.errno_);
+        return false;
+      }
+    }
+
+    if (direction.bytes_in_pipe_ > 0) {
+      const Api::SysCallSizeResult result = os_syscalls.splice(
+          direction.pipe_[0], direction.to_fd_, direction.bytes_in_pipe_, SpliceFlags);
+      if (result.rc_ > 0) {
+        ASSERT(static_cast<uint64_t>(result.rc_) <= direction.bytes_in_pipe_);
+        direction.bytes_in_pipe_ -= result.rc_;
+        progress = true;
+        callbacks_.onSpliced(direction.to_upstream_, result.rc_);
+        if (stopped_) {
+          return false;
+        }
+      } else if (result.rc_ < 0 && result.errno_ != EAGAIN) {
+        stopped_ = true;
+        callbacks_.onSpliceError(result.errno_);
+        return false;
+      }
+    }
+
+    if (direction.end_stream_read_ && direction.bytes_in_pipe_ == 0 &&
+        !direction.end_stream_raised_) {
+      direction.end_stream_raised_ = true;
+      callbacks_.onSpliceEndStream(direction.to_upstream_);
+      return !stopped_;
+    }
+  }
+  return !stopped_;
+}
+
+} // namespace TcpProxy
+} // namespace Envoy
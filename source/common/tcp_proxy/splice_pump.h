@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "envoy/common/pure.h"
+#include "envoy/event/deferred_deletable.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/event/file_event.h"
+
+#include "common/common/logger.h"
+
+namespace Envoy {
+namespace TcpProxy {
+
+/**
+ * Callbacks used by a SplicePump to report progress to its owner.
+ */
+class SplicePumpCallbacks {
+public:
+  virtual ~SplicePumpCallbacks() {}
+
+  /**
+   * Called when bytes have been moved from one socket to the other.
+   * @param to_upstream supplies whether the bytes moved from the downstream to the upstream socket.
+   * @param bytes supplies the number of bytes moved.
+   */
+  virtual void onSpliced(bool to_upstream, uint64_t bytes) PURE;
+
+  /**
+   * Called once per direction when end of stream has been read from the source socket and all
+   * data read before it has been written to the destination socket. The owner should half-close
+   * the destination.
+   * @param to_upstream supplies whether it is the downstream socket that reached end of stream.
+   */
+  virtual void onSpliceEndStream(bool to_upstream) PURE;
+
+  /**
+   * Called when moving data fails. No further callbacks are made.
+   * @param error supplies the errno of the failed splice().
+   */
+  virtual void onSpliceError(int error) PURE;
+};
+
+/**
+ * Moves data in both directions between a downstream and an upstream socket with splice(2),
+ * through a pipe per direction, without copying it into userspace buffers. The sockets' owners
+ * must keep reads disabled on their connections while the pump is running. Callbacks may stop()
+ * the pump, which must then be deferred deleted rather than destroyed in place.
+ */
+class SplicePump : public Event::DeferredDeletable, Logger::Loggable<Logger::Id::filter> {
+public:
+  /**
+   * @return std::unique_ptr<SplicePump> a running pump, or nullptr if the pipes could not be
+   *         created (e.g. splice() is not supported on the platform).
+   */
+  static std::unique_ptr<SplicePump> create(Event::Dispatcher& dispatcher, int downstream_fd,
+                                            int upstream_fd, SplicePumpCallbacks& callbacks);
+
+  ~SplicePump();
+
+  /**
+   * Stop moving data. No further callbacks are made.
+   */
+  void stop();
+
+  /**
+   * @return bool whether end of stream has been read and flushed in both directions.
+   */
+  bool endStreamBothDirections() const {
+    return downstream_to_upstream_.end_stream_raised_ && upstream_to_downstream_.end_stream_raised_;
+  }
+
+  // The capacity of a Linux pipe unless raised with F_SETPIPE_SZ.
+  static constexpr uint64_t PipeCapacity = 65536;
+
+private:
+  struct Direction {
+    Direction(int from_fd, int to_fd, bool to_upstream)
+        : from_fd_(from_fd), to_fd_(to_fd), to_upstream_(to_upstream) {}
+
+    const int from_fd_;
+    const int to_fd_;
+    const bool to_upstream_;
+    int pipe_[2]{-1, -1};
+    uint64_t bytes_in_pipe_{};
+    bool end_stream_read_{};
+    bool end_stream_raised_{};
+  };
+
+  SplicePump(int downstream_fd, int upstream_fd, SplicePumpCallbacks& callbacks);
+
+  void onFileEvent();
+  // Moves as much data as possible in one direction. Returns false if the pump was stopped.
+  bool pump(Direction& direction);
+
+  SplicePumpCallbacks& callbacks_;
+  Direction downstream_to_upstream_;
+  Direction upstream_to_downstream_;
+  Event::FileEventPtr downstream_event_;
+  Event::FileEventPtr upstream_event_;
+  bool stopped_{};
+};
+
+typedef std::unique_ptr<SplicePump> SplicePumpPtr;
+
+} // namespace TcpProxy
+} // namespace Envoy
@@ -1,6 +1,7 @@
 #include "common/tcp_proxy/tcp_proxy.h"
 
 #include <cstdint>
+#include <cstring>
 #include <string>
 
 #include "envoy/buffer/buffer.h"
@@ -12,12 +13,16 @@
 #include "envoy/upstream/upstream.h"
 
 #include "common/access_log/access_log_impl.h"
+#include "common/buffer/buffer_impl.h"
 #include "common/common/assert.h"
 #include "common/common/empty_string.h"
 #include "common/common/fmt.h"
+#include "common/common/hash.h"
 #include "common/config/well_known_names.h"
 #include "common/router/metadatamatchcriteria_impl.h"
 
+#include "extensions/filters/network/well_known_names.h"
+
 namespace Envoy {
 namespace TcpProxy {
 
@@ -37,6 +42,18 @@ Config::Route::Route(
   }
 }
 
+ProtocolOptionsConfig::ProtocolOptionsConfig(
+    const envoy::config::filter::network::tcp_proxy::v2::TcpProxyProtocolOptions& config) {
+  if (config.has_idle_timeout()) {
+    idle_timeout_ =
+        std::chrono::milliseconds(DurationUtil::durationToMilliseconds(config.idle_timeout()));
+  }
+  if (config.has_buffer_release_timeout()) {
+    buffer_release_timeout_ = std::chrono::milliseconds(
+        DurationUtil::durationToMilliseconds(config.buffer_release_timeout()));
+  }
+}
+
 Config::SharedConfig::SharedConfig(
     const envoy::config::filter::network::tcp_proxy::v2::TcpProxy& config,
     Server::Configuration::FactoryContext& context)
@@ -51,8 +68,15 @@ Config::SharedConfig::SharedConfig(
 Config::Config(const envoy::config::filter::network::tcp_proxy::v2::TcpProxy& config,
                Server::Configuration::FactoryContext& context)
     : max_connect_attempts_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, max_connect_attempts, 1)),
+      splice_passthrough_(config.splice_passthrough()),
       upstream_drain_manager_slot_(context.threadLocal().allocateSlot()),
-      shared_config_(std::make_shared<SharedConfig>(config, context)) {
+      shared_config_(std::make_shared<SharedConfig>(config, context)),
+      hash_policy_(config.hash_policy().policy_specifier_case()),
+      random_generator_(context.random()) {
+  if (config.has_buffer_release_timeout()) {
+    buffer_release_timeout_ = std::chrono::milliseconds(
+        DurationUtil::durationToMilliseconds(config.buffer_release_timeout()));
+  }
 
   upstream_drain_manager_slot_->set([](Event::Dispatcher&) {
     return ThreadLocal::ThreadLocalObjectSharedPtr(new UpstreamDrainManager());
@@ -71,6 +95,11 @@ Config::Config(const envoy::config::filter::network::tcp_proxy::v2::TcpProxy& co
     routes_.emplace_back(default_route);
   }
 
+  for (const auto& cluster_weight : config.weighted_clusters().clusters()) {
+    weighted_clusters_.emplace_back(cluster_weight);
+    total_cluster_weight_ += cluster_weight.weight();
+  }
+
   if (config.has_metadata_match()) {
     const auto& filter_metadata = config.metadata_match().filter_metadata();
 
@@ -114,10 +143,40 @@ const std::string& Config::getRouteFromEntries(Network::Connection& connection)
     return route.cluster_name_;
   }
 
+  if (!weighted_clusters_.empty()) {
+    uint64_t selected_value = random_generator_.random() % total_cluster_weight_;
+    for (const WeightedClusterEntry& cluster : weighted_clusters_) {
+      if (selected_value < cluster.cluster_weight_) {
+        return cluster.cluster_name_;
+      }
+      selected_value -= cluster.cluster_weight_;
+    }
+    NOT_REACHED_GCOVR_EXCL_LINE;
+  }
+
   // no match, no more routes to try
   return EMPTY_STRING;
 }
 
+absl::optional<uint64_t> Config::hashKey(const Network::Connection& connection) const {
+  switch (hash_policy_) {
+  case envoy::config::filter::network::tcp_proxy::v2::TcpProxy::HashPolicy::kSourceIp: {
+    const Network::Address::Ip* source_ip = connection.remoteAddress()->ip();
+    if (source_ip == nullptr) {
+      return absl::nullopt;
+    }
+    return HashUtil::xxHash64(source_ip->addressAsString());
+  }
+  case envoy::config::filter::network::tcp_proxy::v2::TcpProxy::HashPolicy::kRequestedServerName:
+    if (connection.requestedServerName().empty()) {
+      return absl::nullopt;
+    }
+    return HashUtil::xxHash64(connection.requestedServerName());
+  default:
+    return absl::nullopt;
+  }
+}
+
 UpstreamDrainManager& Config::drainManager() {
   return upstream_drain_manager_slot_->getTyped<UpstreamDrainManager>();
 }
@@ -403,6 +462,11 @@ Network::FilterStatus Filter::onData(Buffer::Instance& data, bool end_stream) {
 }
 
 void Filter::onDownstreamEvent(Network::ConnectionEvent event) {
+  if (event == Network::ConnectionEvent::RemoteClose ||
+      event == Network::ConnectionEvent::LocalClose) {
+    stopSplicing();
+  }
+
   if (upstream_conn_data_) {
     if (event == Network::ConnectionEvent::RemoteClose) {
       upstream_conn_data_->connection().close(Network::ConnectionCloseType::FlushWrite);
@@ -412,9 +476,11 @@ void Filter::onDownstreamEvent(Network::ConnectionEvent event) {
 
       if (upstream_conn_data_ != nullptr) {
         if (upstream_conn_data_->connection().state() != Network::Connection::State::Closed) {
+          // The buffer release timer calls into this filter, so it does not outlive it.
+          buffer_release_timer_.reset();
           config_->drainManager().add(config_->sharedConfig(), std::move(upstream_conn_data_),
                                       std::move(upstream_callbacks_), std::move(idle_timer_),
-                                      read_callbacks_->upstreamHost());
+                                      idle_timeout_, read_callbacks_->upstreamHost());
         } else {
           upstream_conn_data_.reset();
         }
@@ -450,6 +516,7 @@ void Filter::onUpstreamEvent(Network::ConnectionEvent event) {
 
   if (event == Network::ConnectionEvent::RemoteClose ||
       event == Network::ConnectionEvent::LocalClose) {
+    stopSplicing();
     upstream_conn_data_.reset();
     disableIdleTimer();
 
@@ -468,33 +535,138 @@ void Filter::onUpstreamEvent(Network::ConnectionEvent event) {
     }
   } else if (event == Network::ConnectionEvent::Connected) {
     // Re-enable downstream reads now that the upstream connection is established
-    // so we have a place to send downstream data to.
-    read_callbacks_->connection().readDisable(false);
+    // so we have a place to send downstream data to, unless data is spliced between the sockets
+    // instead.
+    if (!config_->splicePassthrough() || !startSplicing()) {
+      read_callbacks_->connection().readDisable(false);
+    }
 
     read_callbacks_->upstreamHost()->outlierDetector().putResult(
         Upstream::Outlier::Result::SUCCESS);
     onConnectionSuccess();
 
     getRequestInfo().setRequestedServerName(read_callbacks_->connection().requestedServerName());
+    for (const auto& metadata : read_callbacks_->connection().dynamicMetadata().filter_metadata()) {
+      getRequestInfo().setDynamicMetadata(metadata.first, metadata.second);
+    }
     ENVOY_LOG(debug, "TCP:onUpstreamEvent(), requestedServerName: {}",
               getRequestInfo().requestedServerName());
 
-    if (config_->idleTimeout()) {
+    // The cluster can override the timeouts of the filter.
+    idle_timeout_ = config_->idleTimeout();
+    buffer_release_timeout_ = config_->bufferReleaseTimeout();
+    const auto cluster_options =
+        read_callbacks_->upstreamHost()
+            ->cluster()
+            .extensionProtocolOptionsTyped<ProtocolOptionsConfig>(
+                Extensions::NetworkFilters::NetworkFilterNames::get().TcpProxy);
+    if (cluster_options != nullptr) {
+      if (cluster_options->idleTimeout()) {
+        idle_timeout_ = cluster_options->idleTimeout();
+      }
+      if (cluster_options->bufferReleaseTimeout()) {
+        buffer_release_timeout_ = cluster_options->bufferReleaseTimeout();
+      }
+    }
+
+    if (buffer_release_timeout_) {
+      buffer_release_timer_ = read_callbacks_->connection().dispatcher().createTimer(
+          [this]() { onBufferReleaseTimeout(); }, Event::TimerPrecision::Coarse);
+    }
+
+    if (idle_timeout_) {
       // The idle_timer_ can be moved to a Drainer, so related callbacks call into
       // the UpstreamCallbacks, which has the same lifetime as the timer, and can dispatch
       // the call to either TcpProxy or to Drainer, depending on the current state.
       idle_timer_ = read_callbacks_->connection().dispatcher().createTimer(
-          [upstream_callbacks = upstream_callbacks_]() { upstream_callbacks->onIdleTimeout(); });
-      resetIdleTimer();
+          [upstream_callbacks = upstream_callbacks_]() { upstream_callbacks->onIdleTimeout(); },
+          Event::TimerPrecision::Coarse);
       read_callbacks_->connection().addBytesSentCallback([this](uint64_t) { resetIdleTimer(); });
       upstream_conn_data_->connection().addBytesSentCallback(
           [upstream_callbacks = upstream_callbacks_](uint64_t) {
             upstream_callbacks->onBytesSent();
           });
     }
+    resetIdleTimer();
+  }
+}
+
+bool Filter::startSplicing() {
+  Network::Connection& downstream = read_callbacks_->connection();
+  Network::ClientConnection& upstream = upstream_conn_data_->connection();
+
+  // Fall back to proxying through the connection buffers if either transport socket transforms
+  // the data (e.g. TLS).
+  const int downstream_fd = downstream.passthroughFd();
+  const int upstream_fd = upstream.passthroughFd();
+  if (downstream_fd == -1 || upstream_fd == -1) {
+    ENVOY_CONN_LOG(debug, "not splicing: connection is not a plaintext passthrough", downstream);
+    return false;
+  }
+  // Also fall back if either connection has data buffered, e.g. written by another filter or read
+  // downstream before a filter stopped iteration. That data would have to go through the buffers
+  // while the pump writes to the same sockets, reordering the stream.
+  if (downstream.bufferedBytes() != 0 || upstream.bufferedBytes() != 0) {
+    ENVOY_CONN_LOG(debug, "not splicing: connection has buffered data", downstream);
+    return false;
+  }
+
+  splice_pump_ = SplicePump::create(downstream.dispatcher(), downstream_fd, upstream_fd, *this);
+  if (splice_pump_ == nullptr) {
+    return false;
+  }
+
+  ENVOY_CONN_LOG(debug, "splicing data between downstream and upstream sockets", downstream);
+  config_->stats().downstream_cx_splice_total_.inc();
+  // Downstream reads are still disabled from initialize(); the upstream connection must stop
+  // reading too so that only the pump consumes data from the sockets.
+  upstream.readDisable(true);
+  return true;
+}
+
+void Filter::stopSplicing() {
+  if (splice_pump_ != nullptr) {
+    // This may be called from a pump callback, so the pump cannot be destroyed in place.
+    splice_pump_->stop();
+    read_callbacks_->connection().dispatcher().deferredDelete(std::move(splice_pump_));
+  }
+}
+
+void Filter::onSpliced(bool to_upstream, uint64_t bytes) {
+  if (to_upstream) {
+    getRequestInfo().addBytesReceived(bytes);
+    config_->stats().downstream_cx_rx_bytes_total_.add(bytes);
+    read_callbacks_->upstreamHost()->cluster().stats().upstream_cx_tx_bytes_total_.add(bytes);
+  } else {
+    getRequestInfo().addBytesSent(bytes);
+    config_->stats().downstream_cx_tx_bytes_total_.add(bytes);
+    read_callbacks_->upstreamHost()->cluster().stats().upstream_cx_rx_bytes_total_.add(bytes);
+  }
+  resetIdleTimer();
+}
+
+void Filter::onSpliceEndStream(bool to_upstream) {
+  ENVOY_CONN_LOG(trace, "{} end of stream spliced", read_callbacks_->connection(),
+                 to_upstream ? "downstream" : "upstream");
+  Buffer::OwnedImpl empty;
+  if (to_upstream) {
+    upstream_conn_data_->connection().write(empty, true);
+  } else {
+    read_callbacks_->connection().write(empty, true);
+  }
+
+  if (splice_pump_->endStreamBothDirections()) {
+    // Both sides are half-closed and nothing is buffered. This also closes the upstream connection.
+    read_callbacks_->connection().close(Network::ConnectionCloseType::FlushWrite);
   }
 }
 
+void Filter::onSpliceError(int error) {
+  ENVOY_CONN_LOG(debug, "splice failed: {}", read_callbacks_->connection(), strerror(error));
+  // This also closes the upstream connection.
+  read_callbacks_->connection().close(Network::ConnectionCloseType::NoFlush);
+}
+
 void Filter::onIdleTimeout() {
   ENVOY_CONN_LOG(debug, "Session timed out", read_callbacks_->connection());
   config_->stats().idle_timeout_.inc();
@@ -503,10 +675,23 @@ void Filter::onIdleTimeout() {
   read_callbacks_->connection().close(Network::ConnectionCloseType::NoFlush);
 }
 
+void Filter::onBufferReleaseTimeout() {
+  ENVOY_CONN_LOG(debug, "releasing buffers of idle connection", read_callbacks_->connection());
+  config_->stats().buffers_released_.inc();
+  read_callbacks_->connection().releaseBuffers();
+  if (upstream_conn_data_ != nullptr) {
+    upstream_conn_data_->connection().releaseBuffers();
+  }
+}
+
 void Filter::resetIdleTimer() {
   if (idle_timer_ != nullptr) {
-    ASSERT(config_->idleTimeout());
-    idle_timer_->enableTimer(config_->idleTimeout().value());
+    ASSERT(idle_timeout_);
+    idle_timer_->enableTimer(idle_timeout_.value());
+  }
+  if (buffer_release_timer_ != nullptr) {
+    ASSERT(buffer_release_timeout_);
+    buffer_release_timer_->enableTimer(buffer_release_timeout_.value());
   }
 }
 
@@ -515,6 +700,10 @@ void Filter::disableIdleTimer() {
     idle_timer_->disableTimer();
     idle_timer_.reset();
   }
+  if (buffer_release_timer_ != nullptr) {
+    buffer_release_timer_->disableTimer();
+    buffer_release_timer_.reset();
+  }
 }
 
 UpstreamDrainManager::~UpstreamDrainManager() {
@@ -535,9 +724,10 @@ void UpstreamDrainManager::add(const Config::SharedConfigSharedPtr& config,
                                Tcp::ConnectionPool::ConnectionDataPtr&& upstream_conn_data,
                                const std::shared_ptr<Filter::UpstreamCallbacks>& callbacks,
                                Event::TimerPtr&& idle_timer,
+                               const absl::optional<std::chrono::milliseconds>& idle_timeout,
                                const Upstream::HostDescriptionConstSharedPtr& upstream_host) {
   DrainerPtr drainer(new Drainer(*this, config, callbacks, std::move(upstream_conn_data),
-                                 std::move(idle_timer), upstream_host));
+                                 std::move(idle_timer), idle_timeout, upstream_host));
   callbacks->drain(*drainer);
 
   // Use temporary to ensure we get the pointer before we move it out of drainer
@@ -555,9 +745,11 @@ void UpstreamDrainManager::remove(Drainer& drainer, Event::Dispatcher& dispatche
 Drainer::Drainer(UpstreamDrainManager& parent, const Config::SharedConfigSharedPtr& config,
                  const std::shared_ptr<Filter::UpstreamCallbacks>& callbacks,
                  Tcp::ConnectionPool::ConnectionDataPtr&& conn_data, Event::TimerPtr&& idle_timer,
+                 const absl::optional<std::chrono::milliseconds>& idle_timeout,
                  const Upstream::HostDescriptionConstSharedPtr& upstream_host)
     : parent_(parent), callbacks_(callbacks), upstream_conn_data_(std::move(conn_data)),
-      timer_(std::move(idle_timer)), upstream_host_(upstream_host), config_(config) {
+      timer_(std::move(idle_timer)), idle_timeout_(idle_timeout), upstream_host_(upstream_host),
+      config_(config) {
   config_->stats().upstream_flush_total_.inc();
   config_->stats().upstream_flush_active_.inc();
 }
@@ -590,7 +782,7 @@ void Drainer::onIdleTimeout() {
 
 void Drainer::onBytesSent() {
   if (timer_ != nullptr) {
-    timer_->enableTimer(config_->idleTimeout().value());
+    timer_->enableTimer(idle_timeout_.value());
   }
 }
 
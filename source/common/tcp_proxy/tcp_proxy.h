@@ -11,6 +11,7 @@
 #include "envoy/event/timer.h"
 #include "envoy/network/connection.h"
 #include "envoy/network/filter.h"
+#include "envoy/runtime/runtime.h"
 #include "envoy/server/filter_config.h"
 #include "envoy/stats/scope.h"
 #include "envoy/stats/stats_macros.h"
@@ -24,6 +25,7 @@
 #include "common/network/filter_impl.h"
 #include "common/network/utility.h"
 #include "common/request_info/request_info_impl.h"
+#include "common/tcp_proxy/splice_pump.h"
 #include "common/upstream/load_balancer_impl.h"
 
 namespace Envoy {
@@ -42,7 +44,9 @@ namespace TcpProxy {
   COUNTER(downstream_cx_no_route)                                                                  \
   COUNTER(downstream_flow_control_paused_reading_total)                                            \
   COUNTER(downstream_flow_control_resumed_reading_total)                                           \
+  COUNTER(downstream_cx_splice_total)                                                              \
   COUNTER(idle_timeout)                                                                            \
+  COUNTER(buffers_released)                                                                        \
   COUNTER(upstream_flush_total)                                                                    \
   GAUGE  (upstream_flush_active)
 // clang-format on
@@ -57,6 +61,24 @@ struct TcpProxyStats {
 class Drainer;
 class UpstreamDrainManager;
 
+/**
+ * Per cluster options, which override those of the filter for connections to the cluster.
+ */
+class ProtocolOptionsConfig : public Upstream::ProtocolOptionsConfig {
+public:
+  ProtocolOptionsConfig(
+      const envoy::config::filter::network::tcp_proxy::v2::TcpProxyProtocolOptions& config);
+
+  const absl::optional<std::chrono::milliseconds>& idleTimeout() const { return idle_timeout_; }
+  const absl::optional<std::chrono::milliseconds>& bufferReleaseTimeout() const {
+    return buffer_release_timeout_;
+  }
+
+private:
+  absl::optional<std::chrono::milliseconds> idle_timeout_;
+  absl::optional<std::chrono::milliseconds> buffer_release_timeout_;
+};
+
 /**
  * Filter configuration.
  *
@@ -101,12 +123,24 @@ public:
    */
   const std::string& getRouteFromEntries(Network::Connection& connection);
 
+  /**
+   * Compute the hash key of a downstream connection for consistent hashing load balancers.
+   * @param connection supplies the downstream connection.
+   * @return the hash key under the configured hash policy, or nothing if there is no policy or
+   * the connection lacks what it hashes on.
+   */
+  absl::optional<uint64_t> hashKey(const Network::Connection& connection) const;
+
   const TcpProxyStats& stats() { return shared_config_->stats(); }
   const std::vector<AccessLog::InstanceSharedPtr>& accessLogs() { return access_logs_; }
   uint32_t maxConnectAttempts() const { return max_connect_attempts_; }
+  bool splicePassthrough() const { return splice_passthrough_; }
   const absl::optional<std::chrono::milliseconds>& idleTimeout() {
     return shared_config_->idleTimeout();
   }
+  const absl::optional<std::chrono::milliseconds>& bufferReleaseTimeout() const {
+    return buffer_release_timeout_;
+  }
   UpstreamDrainManager& drainManager();
   SharedConfigSharedPtr sharedConfig() { return shared_config_; }
   const Router::MetadataMatchCriteria* metadataMatchCriteria() {
@@ -125,12 +159,28 @@ private:
     std::string cluster_name_;
   };
 
+  struct WeightedClusterEntry {
+    WeightedClusterEntry(const envoy::config::filter::network::tcp_proxy::v2::TcpProxy::
+                             WeightedCluster::ClusterWeight& config)
+        : cluster_name_(config.name()), cluster_weight_(config.weight()) {}
+
+    const std::string cluster_name_;
+    const uint64_t cluster_weight_;
+  };
+
   std::vector<Route> routes_;
+  std::vector<WeightedClusterEntry> weighted_clusters_;
+  uint64_t total_cluster_weight_{};
   std::vector<AccessLog::InstanceSharedPtr> access_logs_;
   const uint32_t max_connect_attempts_;
+  const bool splice_passthrough_;
+  absl::optional<std::chrono::milliseconds> buffer_release_timeout_;
   ThreadLocal::SlotPtr upstream_drain_manager_slot_;
   SharedConfigSharedPtr shared_config_;
   std::unique_ptr<const Router::MetadataMatchCriteria> cluster_metadata_match_criteria_;
+  const envoy::config::filter::network::tcp_proxy::v2::TcpProxy::HashPolicy::PolicySpecifierCase
+      hash_policy_;
+  Runtime::RandomGenerator& random_generator_;
 };
 
 typedef std::shared_ptr<Config> ConfigSharedPtr;
@@ -143,6 +193,7 @@ typedef std::shared_ptr<Config> ConfigSharedPtr;
 class Filter : public Network::ReadFilter,
                public Upstream::LoadBalancerContextBase,
                Tcp::ConnectionPool::Callbacks,
+               SplicePumpCallbacks,
                protected Logger::Loggable<Logger::Id::filter> {
 public:
   Filter(ConfigSharedPtr config, Upstream::ClusterManager& cluster_manager);
@@ -159,6 +210,11 @@ public:
   void onPoolReady(Tcp::ConnectionPool::ConnectionDataPtr&& conn_data,
                    Upstream::HostDescriptionConstSharedPtr host) override;
 
+  // TcpProxy::SplicePumpCallbacks
+  void onSpliced(bool to_upstream, uint64_t bytes) override;
+  void onSpliceEndStream(bool to_upstream) override;
+  void onSpliceError(int error) override;
+
   // Upstream::LoadBalancerContext
   const Router::MetadataMatchCriteria* metadataMatchCriteria() override {
     return config_->metadataMatchCriteria();
@@ -168,6 +224,10 @@ public:
     return &read_callbacks_->connection();
   }
 
+  absl::optional<uint64_t> computeHashKey() override {
+    return config_->hashKey(read_callbacks_->connection());
+  }
+
   // These two functions allow enabling/disabling reads on the upstream and downstream connections.
   // They are called by the Downstream/Upstream Watermark callbacks to limit buffering.
   void readDisableUpstream(bool disable);
@@ -241,6 +301,9 @@ protected:
   void onIdleTimeout();
   void resetIdleTimer();
   void disableIdleTimer();
+  void onBufferReleaseTimeout();
+  bool startSplicing();
+  void stopSplicing();
 
   const ConfigSharedPtr config_;
   Upstream::ClusterManager& cluster_manager_;
@@ -248,10 +311,16 @@ protected:
   Tcp::ConnectionPool::Cancellable* upstream_handle_{};
   Tcp::ConnectionPool::ConnectionDataPtr upstream_conn_data_;
   DownstreamCallbacks downstream_callbacks_;
+  // The idle and buffer release timeouts of the filter, or of the upstream cluster if it
+  // overrides them, set once the upstream connection is established.
+  absl::optional<std::chrono::milliseconds> idle_timeout_;
+  absl::optional<std::chrono::milliseconds> buffer_release_timeout_;
   Event::TimerPtr idle_timer_;
+  Event::TimerPtr buffer_release_timer_;
   std::shared_ptr<UpstreamCallbacks> upstream_callbacks_; // shared_ptr required for passing as a
                                                           // read filter.
   RequestInfo::RequestInfoImpl request_info_;
+  SplicePumpPtr splice_pump_;
   uint32_t connect_attempts_{};
   bool connecting_{};
 };
@@ -264,6 +333,7 @@ public:
   Drainer(UpstreamDrainManager& parent, const Config::SharedConfigSharedPtr& config,
           const std::shared_ptr<Filter::UpstreamCallbacks>& callbacks,
           Tcp::ConnectionPool::ConnectionDataPtr&& conn_data, Event::TimerPtr&& idle_timer,
+          const absl::optional<std::chrono::milliseconds>& idle_timeout,
           const Upstream::HostDescriptionConstSharedPtr& upstream_host);
 
   void onEvent(Network::ConnectionEvent event);
@@ -277,6 +347,7 @@ private:
   std::shared_ptr<Filter::UpstreamCallbacks> callbacks_;
   Tcp::ConnectionPool::ConnectionDataPtr upstream_conn_data_;
   Event::TimerPtr timer_;
+  const absl::optional<std::chrono::milliseconds> idle_timeout_;
   Upstream::HostDescriptionConstSharedPtr upstream_host_;
   Config::SharedConfigSharedPtr config_;
 };
@@ -290,6 +361,7 @@ public:
            Tcp::ConnectionPool::ConnectionDataPtr&& upstream_conn_data,
            const std::shared_ptr<Filter::UpstreamCallbacks>& callbacks,
            Event::TimerPtr&& idle_timer,
+           const absl::optional<std::chrono::milliseconds>& idle_timeout,
            const Upstream::HostDescriptionConstSharedPtr& upstream_host);
   void remove(Drainer& drainer, Event::Dispatcher& dispatcher);
 
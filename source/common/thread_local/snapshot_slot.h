@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+#include "envoy/event/deferred_deletable.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "common/common/lock_guard.h"
+#include "common/common/non_copyable.h"
+#include "common/common/thread.h"
+
+namespace Envoy {
+namespace ThreadLocal {
+
+/**
+ * A TLS slot holding a single immutable object that is shared by all threads and replaced
+ * wholesale by the main thread, such as a runtime snapshot or a route table. Publishing a new
+ * object does not post anything to the workers. It bumps a version, and each thread picks up the
+ * new object the first time it asks for it afterwards, at the cost of one uncontended lock per
+ * thread per update. Until then, and in between updates, get() only reads an atomic and the
+ * thread's cached pointer.
+ *
+ * The object previously cached by a thread is released at the end of that thread's current event
+ * loop iteration, so references returned by get() stay valid for the rest of the iteration, the
+ * same guarantee Slot::set() gives.
+ */
+template <class T> class SnapshotSlot : NonCopyable {
+public:
+  /**
+   * @param tls supplies the allocator for the underlying slot. Threads must have been registered
+   *            with it already, as with Slot::set().
+   * @param initial supplies the object to start with, if it is already known.
+   */
+  SnapshotSlot(SlotAllocator& tls, std::shared_ptr<T> initial = nullptr)
+      : current_(std::move(initial)), slot_(tls.allocateSlot()) {
+    slot_->set([](Event::Dispatcher& dispatcher) -> ThreadLocalObjectSharedPtr {
+      return std::make_shared<ThreadCache>(dispatcher);
+    });
+  }
+
+  /**
+   * Make a new object visible to all threads. Must be called from the main thread.
+   * @param object supplies the new object.
+   */
+  void publish(std::shared_ptr<T> object) {
+    {
+      Thread::LockGuard lock(lock_);
+      current_.swap(object);
+    }
+    version_.fetch_add(1, std::memory_order_release);
+    // The previous object, now in object, is released here unless a thread still caches it.
+  }
+
+  /**
+   * @return const std::shared_ptr<T>& the latest published object, as seen by the calling thread.
+   */
+  const std::shared_ptr<T>& get() {
+    ThreadCache& cache = slot_->getTyped<ThreadCache>();
+    const uint64_t version = version_.load(std::memory_order_acquire);
+    if (cache.version_ != version) {
+      std::shared_ptr<T> latest;
+      {
+        Thread::LockGuard lock(lock_);
+        latest = current_;
+      }
+      if (cache.snapshot_ != nullptr) {
+        cache.dispatcher_.deferredDelete(
+            std::make_unique<RetiredSnapshot>(std::move(cache.snapshot_)));
+      }
+      cache.snapshot_ = std::move(latest);
+      cache.version_ = version;
+    }
+    return cache.snapshot_;
+  }
+
+private:
+  struct ThreadCache : public ThreadLocalObject {
+    ThreadCache(Event::Dispatcher& dispatcher) : dispatcher_(dispatcher) {}
+
+    Event::Dispatcher& dispatcher_;
+    // Never matches a published version, so the first get() on each thread fills the cache.
+    uint64_t version_{std::numeric_limits<uint64_t>::max()};
+    std::shared_ptr<T> snapshot_;
+  };
+
+  struct RetiredSnapshot : public Event::DeferredDeletable {
+    RetiredSnapshot(std::shared_ptr<T>&& snapshot) : snapshot_(std::move(snapshot)) {}
+
+    std::shared_ptr<T> snapshot_;
+  };
+
+  Thread::MutexBasicLockable lock_;
+  std::shared_ptr<T> current_ GUARDED_BY(lock_);
+  std::atomic<uint64_t> version_{0};
+  SlotPtr slot_;
+};
+
+} // namespace ThreadLocal
+} // namespace Envoy
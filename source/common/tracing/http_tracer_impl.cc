@@ -64,9 +64,8 @@ Decision HttpTracerUtility::isTracing(const RequestInfo::RequestInfo& request_in
     return {Reason::NotTraceableRequestId, false};
   }
 
-  // TODO PERF: Avoid copy.
   UuidTraceStatus trace_status =
-      UuidUtils::isTraceableUuid(request_headers.RequestId()->value().c_str());
+      UuidUtils::isTraceableUuid(request_headers.RequestId()->value().getStringView());
 
   switch (trace_status) {
   case UuidTraceStatus::Client:
@@ -0,0 +1,68 @@
+#include "common/upstream/bounded_load_ring_hash_lb.h"
+
+#include <cmath>
+
+#include "common/protobuf/utility.h"
+
+namespace Envoy {
+namespace Upstream {
+
+BoundedLoadRingHashLoadBalancer::BoundedLoadRingHashLoadBalancer(
+    const PrioritySet& priority_set, ClusterStats& stats, Runtime::Loader& runtime,
+    Runtime::RandomGenerator& random,
+    const absl::optional<envoy::api::v2::Cluster::BoundedLoadRingHashLbConfig>& config,
+    const envoy::api::v2::Cluster::CommonLbConfig& common_config)
+    : ThreadAwareLoadBalancerBase(priority_set, stats, runtime, random, common_config),
+      min_ring_size_(
+          config ? PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.value(), minimum_ring_size, 1024) : 1024),
+      balance_factor_(
+          (config ? PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.value(), balance_factor, 125) : 125) /
+          100.0) {}
+
+ThreadAwareLoadBalancerBase::HashingLoadBalancerSharedPtr
+BoundedLoadRingHashLoadBalancer::createLoadBalancer(const HostSet& host_set) {
+  // Note that we only compute global panic on host set refresh. Given that the runtime setting
+  // will rarely change, this is a reasonable compromise to avoid creating extra LBs when we only
+  // need to create one per priority level.
+  return std::make_shared<BoundedLoadRing>(isGlobalPanic(host_set) ? host_set.hosts()
+                                                                   : host_set.healthyHosts(),
+                                           min_ring_size_, balance_factor_);
+}
+
+BoundedLoadRingHashLoadBalancer::BoundedLoadRing::BoundedLoadRing(const HostVector& hosts,
+                                                                  uint64_t min_ring_size,
+                                                                  double balance_factor)
+    : ring_(hosts, min_ring_size, false), balance_factor_(balance_factor) {}
+
+HostConstSharedPtr
+BoundedLoadRingHashLoadBalancer::BoundedLoadRing::chooseHost(uint64_t hash) const {
+  const HostVector& hosts = ring_.hosts_;
+  if (hosts.empty()) {
+    return nullptr;
+  }
+
+  // The active requests of a host are counted across all the workers, so the bound holds for the
+  // whole process. The counts may change while the ring is walked, which only makes the bound
+  // slightly off.
+  uint64_t total_active = 0;
+  for (const auto& host : hosts) {
+    total_active += host->stats().rq_active_.value();
+  }
+  const uint64_t max_active =
+      static_cast<uint64_t>(std::ceil(balance_factor_ * (total_active + 1) / hosts.size()));
+
+  // The bound is above the average load, so there always is a host below it and the walk ends
+  // before wrapping around.
+  const uint64_t ring_size = ring_.hashes_.size();
+  const uint64_t start = ring_.position(hash);
+  for (uint64_t i = 0; i < ring_size; i++) {
+    const HostConstSharedPtr& host = hosts[ring_.host_indexes_[(start + i) % ring_size]];
+    if (host->stats().rq_active_.value() < max_active) {
+      return host;
+    }
+  }
+  return hosts[ring_.host_indexes_[start]];
+}
+
+} // namespace Upstream
+} // namespace Envoy
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "common/upstream/ring_hash_lb.h"
+
+namespace Envoy {
+namespace Upstream {
+
+/**
+ * A ring hash load balancer that implements consistent hashing with bounded loads as described in:
+ * https://arxiv.org/abs/1608.01350
+ * A host is only picked while its number of active requests is below
+ * ceil(balance_factor * (total active requests + 1) / number of hosts), where the balance factor
+ * is at least 1. Otherwise the ring is walked clockwise until a host below that bound is found.
+ * Requests for a hot key thus spill over to the next hosts of the ring instead of overloading
+ * the host owning the key, while all the other keys keep their host.
+ */
+class BoundedLoadRingHashLoadBalancer : public ThreadAwareLoadBalancerBase {
+public:
+  BoundedLoadRingHashLoadBalancer(
+      const PrioritySet& priority_set, ClusterStats& stats, Runtime::Loader& runtime,
+      Runtime::RandomGenerator& random,
+      const absl::optional<envoy::api::v2::Cluster::BoundedLoadRingHashLbConfig>& config,
+      const envoy::api::v2::Cluster::CommonLbConfig& common_config);
+
+  /**
+   * A ring which skips the hosts that are over the load bound.
+   */
+  struct BoundedLoadRing : public HashingLoadBalancer {
+    BoundedLoadRing(const HostVector& hosts, uint64_t min_ring_size, double balance_factor);
+
+    // ThreadAwareLoadBalancerBase::HashingLoadBalancer
+    HostConstSharedPtr chooseHost(uint64_t hash) const override;
+
+    const RingHashLoadBalancer::Ring ring_;
+    const double balance_factor_;
+  };
+
+private:
+  // ThreadAwareLoadBalancerBase
+  HashingLoadBalancerSharedPtr createLoadBalancer(const HostSet& host_set) override;
+
+  const uint64_t min_ring_size_;
+  const double balance_factor_;
+};
+
+} // namespace Upstream
+} // namespace Envoy
@@ -7,6 +7,7 @@
 #include "envoy/stats/scope.h"
 
 #include "common/common/cleanup.h"
+#include "common/common/thread.h"
 #include "common/config/resources.h"
 #include "common/config/subscription_factory.h"
 #include "common/config/utility.h"
@@ -43,7 +44,8 @@ CdsApiImpl::CdsApiImpl(const envoy::api::v2::core::ConfigSource& cds_config,
                                        scope.statsOptions());
           },
           "envoy.api.v2.ClusterDiscoveryService.FetchClusters",
-          "envoy.api.v2.ClusterDiscoveryService.StreamClusters");
+          "envoy.api.v2.ClusterDiscoveryService.StreamClusters",
+          "envoy.api.v2.ClusterDiscoveryService.IncrementalClusters");
 }
 
 void CdsApiImpl::onConfigUpdate(const ResourceVector& resources, const std::string& version_info) {
@@ -56,11 +58,13 @@ void CdsApiImpl::onConfigUpdate(const ResourceVector& resources, const std::stri
       throw EnvoyException(fmt::format("duplicate cluster {} found", cluster.name()));
     }
   }
-  for (const auto& cluster : resources) {
-    MessageUtil::validate(cluster);
+  const std::vector<ClusterPreparationPtr> preparations = validateAndPrepare(resources);
+  // We need to keep track of which clusters we might need to remove. On-demand clusters that aren't
+  // loaded aren't in cm_.clusters(), so the clusters of the previous update are also considered.
+  std::unordered_set<std::string> clusters_to_remove = cluster_names_;
+  for (const auto& cluster : cm_.clusters()) {
+    clusters_to_remove.insert(cluster.first);
   }
-  // We need to keep track of which clusters we might need to remove.
-  ClusterManager::ClusterInfoMap clusters_to_remove = cm_.clusters();
   for (auto& cluster : resources) {
     const std::string cluster_name = cluster.name();
     clusters_to_remove.erase(cluster_name);
@@ -69,17 +73,63 @@ void CdsApiImpl::onConfigUpdate(const ResourceVector& resources, const std::stri
     }
   }
 
-  for (auto cluster : clusters_to_remove) {
-    const std::string cluster_name = cluster.first;
+  for (const std::string& cluster_name : clusters_to_remove) {
     if (cm_.removeCluster(cluster_name)) {
       ENVOY_LOG(debug, "cds: remove cluster '{}'", cluster_name);
     }
   }
 
+  cluster_names_ = std::move(cluster_names);
   version_info_ = version_info;
   runInitializeCallbackIfAny();
 }
 
+std::vector<ClusterPreparationPtr>
+CdsApiImpl::validateAndPrepare(const ResourceVector& resources) {
+  // Clusters known from previous updates are typically unchanged, so only the new ones are
+  // prepared.
+  std::vector<ClusterPreparationPtr> preparations(resources.size());
+  Thread::parallelFor(resources.size(), ClustersPerPrepareThread, [&](size_t i) {
+    MessageUtil::validate(resources[i]);
+    if (cluster_names_.count(resources[i].name()) == 0) {
+      preparations[i] = cm_.clusterManagerFactory().prepareCluster(resources[i]);
+    }
+  });
+  return preparations;
+}
+
+void CdsApiImpl::onIncrementalConfigUpdate(
+    const ResourceVector& added_resources,
+    const Protobuf::RepeatedPtrField<ProtobufTypes::String>& removed_resources,
+    const std::string& system_version_info) {
+  cm_.adsMux().pause(Config::TypeUrl::get().ClusterLoadAssignment);
+  Cleanup eds_resume([this] { cm_.adsMux().resume(Config::TypeUrl::get().ClusterLoadAssignment); });
+
+  std::unordered_set<std::string> cluster_names;
+  for (const auto& cluster : added_resources) {
+    if (!cluster_names.insert(cluster.name()).second) {
+      throw EnvoyException(fmt::format("duplicate cluster {} found", cluster.name()));
+    }
+  }
+  const std::vector<ClusterPreparationPtr> preparations = validateAndPrepare(added_resources);
+  // Only the clusters that changed are sent, so the clusters that aren't mentioned are kept.
+  for (const auto& cluster : added_resources) {
+    if (cm_.addOrUpdateCluster(cluster, system_version_info)) {
+      ENVOY_LOG(debug, "cds: add/update cluster '{}'", cluster.name());
+    }
+    cluster_names_.insert(cluster.name());
+  }
+  for (const auto& cluster_name : removed_resources) {
+    if (cm_.removeCluster(cluster_name)) {
+      ENVOY_LOG(debug, "cds: remove cluster '{}'", cluster_name);
+    }
+    cluster_names_.erase(cluster_name);
+  }
+
+  version_info_ = system_version_info;
+  runInitializeCallbackIfAny();
+}
+
 void CdsApiImpl::onConfigUpdateFailed(const EnvoyException*) {
   // We need to allow server startup to continue, even if we have a bad
   // config.
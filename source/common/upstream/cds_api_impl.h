@@ -1,6 +1,9 @@
 #pragma once
 
 #include <functional>
+#include <string>
+#include <unordered_set>
+#include <vector>
 
 #include "envoy/api/v2/cds.pb.h"
 #include "envoy/config/subscription.h"
@@ -36,6 +39,10 @@ public:
 
   // Config::SubscriptionCallbacks
   void onConfigUpdate(const ResourceVector& resources, const std::string& version_info) override;
+  void onIncrementalConfigUpdate(
+      const ResourceVector& added_resources,
+      const Protobuf::RepeatedPtrField<ProtobufTypes::String>& removed_resources,
+      const std::string& system_version_info) override;
   void onConfigUpdateFailed(const EnvoyException* e) override;
   std::string resourceName(const ProtobufWkt::Any& resource) override {
     return MessageUtil::anyConvert<envoy::api::v2::Cluster>(resource).name();
@@ -47,10 +54,17 @@ private:
              ClusterManager& cm, Event::Dispatcher& dispatcher, Runtime::RandomGenerator& random,
              const LocalInfo::LocalInfo& local_info, Stats::Scope& scope);
   void runInitializeCallbackIfAny();
+  std::vector<ClusterPreparationPtr> validateAndPrepare(const ResourceVector& resources);
+
+  // Updates typically carry many clusters, so they are validated, and the new ones prepared, in
+  // parallel batches of at least this many clusters.
+  static constexpr size_t ClustersPerPrepareThread = 16;
 
   ClusterManager& cm_;
   std::unique_ptr<Config::Subscription<envoy::api::v2::Cluster>> subscription_;
   std::string version_info_;
+  // Names of the clusters of the last update.
+  std::unordered_set<std::string> cluster_names_;
   std::function<void()> initialize_callback_;
   Stats::ScopePtr scope_;
 };
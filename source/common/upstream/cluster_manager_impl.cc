@@ -15,8 +15,10 @@
 
 #include "common/common/enum_to_int.h"
 #include "common/common/fmt.h"
+#include "common/common/thread.h"
 #include "common/common/utility.h"
 #include "common/config/cds_json.h"
+#include "common/config/datasource.h"
 #include "common/config/utility.h"
 #include "common/filesystem/filesystem_impl.h"
 #include "common/grpc/async_client_manager_impl.h"
@@ -24,12 +26,15 @@
 #include "common/http/http1/conn_pool.h"
 #include "common/http/http2/conn_pool.h"
 #include "common/json/config_schemas.h"
+#include "common/network/dns_cache_impl.h"
 #include "common/network/resolver_impl.h"
 #include "common/network/utility.h"
 #include "common/protobuf/utility.h"
 #include "common/router/shadow_writer_impl.h"
 #include "common/tcp/conn_pool.h"
+#include "common/upstream/bounded_load_ring_hash_lb.h"
 #include "common/upstream/cds_api_impl.h"
+#include "common/upstream/cluster_name_registry.h"
 #include "common/upstream/load_balancer_impl.h"
 #include "common/upstream/maglev_lb.h"
 #include "common/upstream/original_dst_cluster.h"
@@ -175,13 +180,15 @@ ClusterManagerImpl::ClusterManagerImpl(const envoy::config::bootstrap::v2::Boots
                                        Server::Admin& admin)
     : factory_(factory), runtime_(runtime), stats_(stats), tls_(tls.allocateSlot()),
       random_(random), log_manager_(log_manager),
+      on_demand_(bootstrap.cluster_manager().has_on_demand_clusters()),
       bind_config_(bootstrap.cluster_manager().upstream_bind_config()), local_info_(local_info),
       cm_stats_(generateStats(stats)),
       init_helper_([this](Cluster& cluster) { onClusterInit(cluster); }),
       config_tracker_entry_(
           admin.getConfigTracker().add("clusters", [this] { return dumpClusterConfigs(); })),
       time_source_(main_thread_dispatcher.timeSystem()), dispatcher_(main_thread_dispatcher) {
-  async_client_manager_ = std::make_unique<Grpc::AsyncClientManagerImpl>(*this, tls, time_source_);
+  async_client_manager_ = std::make_unique<Grpc::AsyncClientManagerImpl>(
+      *this, tls, time_source_, bootstrap.cluster_manager().google_grpc_completion_threads());
   const auto& cm_config = bootstrap.cluster_manager();
   if (cm_config.has_outlier_detection()) {
     const std::string event_log_file_path = cm_config.outlier_detection().event_log_path();
@@ -195,6 +202,23 @@ ClusterManagerImpl::ClusterManagerImpl(const envoy::config::bootstrap::v2::Boots
     eds_config_ = bootstrap.dynamic_resources().deprecated_v1().sds_config();
   }
 
+  if (cm_config.on_demand_clusters().has_idle_timeout()) {
+    on_demand_idle_timeout_ = std::chrono::milliseconds(
+        DurationUtil::durationToMilliseconds(cm_config.on_demand_clusters().idle_timeout()));
+    on_demand_idle_timer_ = main_thread_dispatcher.createTimer([this]() -> void {
+      onOnDemandIdleTimer();
+      on_demand_idle_timer_->enableTimer(on_demand_idle_timeout_);
+    });
+    on_demand_idle_timer_->enableTimer(on_demand_idle_timeout_);
+  }
+
+  // The work of allocating the static clusters that doesn't touch thread local state or the
+  // dispatcher, such as parsing TLS certificates, is done in parallel ahead of loading them.
+  std::vector<ClusterPreparationPtr> preparations(bootstrap.static_resources().clusters().size());
+  Thread::parallelFor(preparations.size(), ClustersPerPrepareThread, [&](size_t i) {
+    preparations[i] = factory_.prepareCluster(bootstrap.static_resources().clusters(i));
+  });
+
   // Cluster loading happens in two phases: first all the primary clusters are loaded, and then all
   // the secondary clusters are loaded. As it currently stands all non-EDS clusters are primary and
   // only EDS clusters are secondary. This two phase loading is done because in v2 configuration
@@ -203,12 +227,18 @@ ClusterManagerImpl::ClusterManagerImpl(const envoy::config::bootstrap::v2::Boots
   for (const auto& cluster : bootstrap.static_resources().clusters()) {
     // First load all the primary clusters.
     if (cluster.type() != envoy::api::v2::Cluster::EDS) {
-      loadCluster(cluster, "", false, active_clusters_);
+      loadCluster(cluster, MessageUtil::hash(cluster), "", false, active_clusters_);
     }
   }
 
   // Now setup ADS if needed, this might rely on a primary cluster.
   if (bootstrap.dynamic_resources().has_ads_config()) {
+    // Incremental discovery responses don't carry the type of their resources, which ADS needs to
+    // tell the multiplexed APIs apart.
+    if (bootstrap.dynamic_resources().ads_config().api_type() ==
+        envoy::api::v2::core::ApiConfigSource::INCREMENTAL_GRPC) {
+      throw EnvoyException("ADS does not support incremental xDS");
+    }
     ads_mux_.reset(new Config::GrpcMuxImpl(
         local_info,
         Config::Utility::factoryForGrpcApiConfigSource(
@@ -217,7 +247,7 @@ ClusterManagerImpl::ClusterManagerImpl(const envoy::config::bootstrap::v2::Boots
         main_thread_dispatcher,
         *Protobuf::DescriptorPool::generated_pool()->FindMethodByName(
             "envoy.service.discovery.v2.AggregatedDiscoveryService.StreamAggregatedResources"),
-        random_));
+        random_, bootstrap.dynamic_resources().ads_snapshot_path()));
   } else {
     ads_mux_.reset(new Config::NullGrpcMuxImpl());
   }
@@ -226,10 +256,12 @@ ClusterManagerImpl::ClusterManagerImpl(const envoy::config::bootstrap::v2::Boots
   for (const auto& cluster : bootstrap.static_resources().clusters()) {
     // Now load all the secondary clusters.
     if (cluster.type() == envoy::api::v2::Cluster::EDS) {
-      loadCluster(cluster, "", false, active_clusters_);
+      loadCluster(cluster, MessageUtil::hash(cluster), "", false, active_clusters_);
     }
   }
 
+  preparations.clear();
+
   cm_stats_.cluster_added_.add(bootstrap.static_resources().clusters().size());
   updateGauges();
 
@@ -369,6 +401,12 @@ void ClusterManagerImpl::onClusterInit(Cluster& cluster) {
     }
     postThreadLocalClusterUpdate(cluster, host_set->priority(), host_set->hosts(), HostVector{});
   }
+
+  // On-demand clusters are loaded because some thread is waiting for them. The host updates above
+  // are posted first, so that the waiting requests don't find an empty cluster.
+  if (on_demand_clusters_.count(cluster.info()->name()) > 0) {
+    postOnDemandClusterReady(cluster.info()->name());
+  }
 }
 
 bool ClusterManagerImpl::scheduleUpdate(const Cluster& cluster, uint32_t priority, bool mergeable) {
@@ -465,8 +503,35 @@ bool ClusterManagerImpl::addOrUpdateCluster(const envoy::api::v2::Cluster& clust
     return false;
   }
 
-  if (existing_active_cluster != active_clusters_.end() ||
-      existing_warming_cluster != warming_clusters_.end()) {
+  // In on-demand mode, the config of CDS clusters is kept until they are first used. Clusters that
+  // are already loaded are updated as usual.
+  const bool loaded = existing_active_cluster != active_clusters_.end() ||
+                      existing_warming_cluster != warming_clusters_.end();
+  if (on_demand_) {
+    auto on_demand_cluster = on_demand_clusters_.find(cluster_name);
+    if (on_demand_cluster == on_demand_clusters_.end()) {
+      ASSERT(!loaded);
+      ENVOY_LOG(info, "add on-demand cluster {}", cluster_name);
+      on_demand_clusters_.emplace(cluster_name, OnDemandCluster{cluster, new_hash, version_info});
+      tls_->runOnAllThreads([this, cluster_name]() -> void {
+        tls_->getTyped<ThreadLocalClusterManagerImpl>().on_demand_clusters_.insert(cluster_name);
+      });
+      cm_stats_.cluster_added_.inc();
+      updateGauges();
+      return true;
+    }
+    if (on_demand_cluster->second.config_hash_ == new_hash) {
+      return false;
+    }
+    on_demand_cluster->second = OnDemandCluster{cluster, new_hash, version_info};
+    if (!loaded) {
+      ENVOY_LOG(info, "update on-demand cluster {}", cluster_name);
+      cm_stats_.cluster_modified_.inc();
+      return true;
+    }
+  }
+
+  if (loaded) {
     // The following init manager remove call is a NOP in the case we are already initialized. It's
     // just kept here to avoid additional logic.
     init_helper_.removeCluster(*existing_active_cluster->second->cluster_);
@@ -475,6 +540,15 @@ bool ClusterManagerImpl::addOrUpdateCluster(const envoy::api::v2::Cluster& clust
     cm_stats_.cluster_added_.inc();
   }
 
+  loadOrUpdateCluster(cluster, new_hash, version_info);
+  return true;
+}
+
+void ClusterManagerImpl::loadOrUpdateCluster(const envoy::api::v2::Cluster& cluster,
+                                             uint64_t config_hash,
+                                             const std::string& version_info) {
+  const std::string cluster_name = cluster.name();
+
   // There are two discrete paths here depending on when we are adding/updating a cluster.
   // 1) During initial server load we use the init manager which handles complex logic related to
   //    primary/secondary init, static/CDS init, warming all clusters, etc.
@@ -487,7 +561,8 @@ bool ClusterManagerImpl::addOrUpdateCluster(const envoy::api::v2::Cluster& clust
   //       and easy to understand.
   const bool use_active_map =
       init_helper_.state() != ClusterManagerInitHelper::State::AllClustersInitialized;
-  loadCluster(cluster, version_info, true, use_active_map ? active_clusters_ : warming_clusters_);
+  loadCluster(cluster, config_hash, version_info, true,
+              use_active_map ? active_clusters_ : warming_clusters_);
 
   if (use_active_map) {
     ENVOY_LOG(info, "add/update cluster {} during init", cluster_name);
@@ -516,12 +591,13 @@ bool ClusterManagerImpl::addOrUpdateCluster(const envoy::api::v2::Cluster& clust
   }
 
   updateGauges();
-  return true;
 }
 
 void ClusterManagerImpl::createOrUpdateThreadLocalCluster(ClusterData& cluster) {
   tls_->runOnAllThreads([this, new_cluster = cluster.cluster_->info(),
-                         thread_aware_lb_factory = cluster.loadBalancerFactory()]() -> void {
+                         thread_aware_lb_factory = cluster.loadBalancerFactory(),
+                         locality_routing_table_cache =
+                             cluster.locality_routing_table_cache_]() -> void {
     ThreadLocalClusterManagerImpl& cluster_manager =
         tls_->getTyped<ThreadLocalClusterManagerImpl>();
 
@@ -531,9 +607,10 @@ void ClusterManagerImpl::createOrUpdateThreadLocalCluster(ClusterData& cluster)
       ENVOY_LOG(debug, "adding TLS cluster {}", new_cluster->name());
     }
 
-    auto thread_local_cluster = new ThreadLocalClusterManagerImpl::ClusterEntry(
-        cluster_manager, new_cluster, thread_aware_lb_factory);
-    cluster_manager.thread_local_clusters_[new_cluster->name()].reset(thread_local_cluster);
+    auto thread_local_cluster = cluster_manager.setCluster(
+        new_cluster->name(), std::make_unique<ThreadLocalClusterManagerImpl::ClusterEntry>(
+                                 cluster_manager, new_cluster, thread_aware_lb_factory,
+                                 locality_routing_table_cache));
     for (auto& cb : cluster_manager.update_callbacks_) {
       cb->onClusterAddOrUpdate(*thread_local_cluster);
     }
@@ -541,6 +618,31 @@ void ClusterManagerImpl::createOrUpdateThreadLocalCluster(ClusterData& cluster)
 }
 
 bool ClusterManagerImpl::removeCluster(const std::string& cluster_name) {
+  bool removed = removeLoadedCluster(cluster_name);
+
+  auto on_demand_cluster = on_demand_clusters_.find(cluster_name);
+  if (on_demand_cluster != on_demand_clusters_.end()) {
+    removed = true;
+    on_demand_clusters_.erase(on_demand_cluster);
+    ENVOY_LOG(info, "removing on-demand cluster {}", cluster_name);
+    tls_->runOnAllThreads([this, cluster_name]() -> void {
+      ThreadLocalClusterManagerImpl& cluster_manager =
+          tls_->getTyped<ThreadLocalClusterManagerImpl>();
+      cluster_manager.on_demand_clusters_.erase(cluster_name);
+      // Whatever was waiting for the cluster to load won't get it.
+      cluster_manager.onOnDemandClusterReady(cluster_name);
+    });
+    updateGauges();
+  }
+
+  if (removed) {
+    cm_stats_.cluster_removed_.inc();
+  }
+
+  return removed;
+}
+
+bool ClusterManagerImpl::removeLoadedCluster(const std::string& cluster_name) {
   bool removed = false;
   auto existing_active_cluster = active_clusters_.find(cluster_name);
   if (existing_active_cluster != active_clusters_.end() &&
@@ -556,7 +658,7 @@ bool ClusterManagerImpl::removeCluster(const std::string& cluster_name) {
 
       ASSERT(cluster_manager.thread_local_clusters_.count(cluster_name) == 1);
       ENVOY_LOG(debug, "removing TLS cluster {}", cluster_name);
-      cluster_manager.thread_local_clusters_.erase(cluster_name);
+      cluster_manager.eraseCluster(cluster_name);
       for (auto& cb : cluster_manager.update_callbacks_) {
         cb->onClusterRemoval(cluster_name);
       }
@@ -572,7 +674,6 @@ bool ClusterManagerImpl::removeCluster(const std::string& cluster_name) {
   }
 
   if (removed) {
-    cm_stats_.cluster_removed_.inc();
     updateGauges();
     // Cancel any pending merged updates.
     updates_map_.erase(cluster_name);
@@ -581,9 +682,60 @@ bool ClusterManagerImpl::removeCluster(const std::string& cluster_name) {
   return removed;
 }
 
+void ClusterManagerImpl::loadOnDemandClusterOnMainThread(const std::string& cluster_name) {
+  if (warming_clusters_.count(cluster_name) > 0) {
+    // The waiting threads are told once the cluster finishes warming.
+    return;
+  }
+
+  auto on_demand_cluster = on_demand_clusters_.find(cluster_name);
+  if (active_clusters_.count(cluster_name) > 0 || on_demand_cluster == on_demand_clusters_.end()) {
+    // The cluster became ready, or was removed, while the request to load it was in flight.
+    postOnDemandClusterReady(cluster_name);
+    return;
+  }
+
+  ENVOY_LOG(info, "loading on-demand cluster {}", cluster_name);
+  cm_stats_.cluster_on_demand_loaded_.inc();
+  loadOrUpdateCluster(on_demand_cluster->second.cluster_config_,
+                      on_demand_cluster->second.config_hash_,
+                      on_demand_cluster->second.version_info_);
+}
+
+void ClusterManagerImpl::postOnDemandClusterReady(const std::string& cluster_name) {
+  tls_->runOnAllThreads([this, cluster_name]() -> void {
+    tls_->getTyped<ThreadLocalClusterManagerImpl>().onOnDemandClusterReady(cluster_name);
+  });
+}
+
+void ClusterManagerImpl::onOnDemandIdleTimer() {
+  // A loaded on-demand cluster is idle if it has no active upstream requests or connections, and
+  // has made no new ones since the last check.
+  std::vector<std::string> idle_clusters;
+  for (auto& cluster : active_clusters_) {
+    if (on_demand_clusters_.count(cluster.first) == 0) {
+      continue;
+    }
+    const ClusterStats& stats = cluster.second->cluster_->info()->stats();
+    const uint64_t activity = stats.upstream_rq_total_.value() + stats.upstream_cx_total_.value();
+    if (cluster.second->on_demand_activity_ == activity && stats.upstream_rq_active_.value() == 0 &&
+        stats.upstream_cx_active_.value() == 0) {
+      idle_clusters.push_back(cluster.first);
+    } else {
+      cluster.second->on_demand_activity_ = activity;
+    }
+  }
+
+  for (const std::string& cluster_name : idle_clusters) {
+    ENVOY_LOG(info, "unloading idle on-demand cluster {}", cluster_name);
+    removeLoadedCluster(cluster_name);
+    cm_stats_.cluster_on_demand_unloaded_.inc();
+  }
+}
+
 void ClusterManagerImpl::loadCluster(const envoy::api::v2::Cluster& cluster,
-                                     const std::string& version_info, bool added_via_api,
-                                     ClusterMap& cluster_map) {
+                                     uint64_t config_hash, const std::string& version_info,
+                                     bool added_via_api, ClusterMap& cluster_map) {
   ClusterSharedPtr new_cluster =
       factory_.clusterFromProto(cluster, *this, outlier_event_logger_, log_manager_, added_via_api);
 
@@ -614,7 +766,7 @@ void ClusterManagerImpl::loadCluster(const envoy::api::v2::Cluster& cluster,
   }
 
   cluster_map[cluster_reference.info()->name()] = std::make_unique<ClusterData>(
-      cluster, version_info, added_via_api, std::move(new_cluster), time_source_);
+      cluster, config_hash, version_info, added_via_api, std::move(new_cluster), time_source_);
   const auto cluster_entry_it = cluster_map.find(cluster_reference.info()->name());
 
   // If an LB is thread aware, create it here. The LB is not initialized until cluster pre-init
@@ -626,6 +778,12 @@ void ClusterManagerImpl::loadCluster(const envoy::api::v2::Cluster& cluster,
   } else if (cluster_reference.info()->lbType() == LoadBalancerType::Maglev) {
     cluster_entry_it->second->thread_aware_lb_ = std::make_unique<MaglevLoadBalancer>(
         cluster_reference.prioritySet(), cluster_reference.info()->stats(), runtime_, random_,
+        cluster_reference.info()->lbConfig(),
+        MaglevLoadBalancer::tableSize(cluster_reference.info()->lbMaglevConfig()));
+  } else if (cluster_reference.info()->lbType() == LoadBalancerType::BoundedLoadRingHash) {
+    cluster_entry_it->second->thread_aware_lb_ = std::make_unique<BoundedLoadRingHashLoadBalancer>(
+        cluster_reference.prioritySet(), cluster_reference.info()->stats(), runtime_, random_,
+        cluster_reference.info()->lbBoundedLoadRingHashConfig(),
         cluster_reference.info()->lbConfig());
   }
 
@@ -634,9 +792,29 @@ void ClusterManagerImpl::loadCluster(const envoy::api::v2::Cluster& cluster,
 
 void ClusterManagerImpl::updateGauges() {
   cm_stats_.active_clusters_.set(active_clusters_.size());
+  cm_stats_.on_demand_clusters_.set(on_demand_clusters_.size());
   cm_stats_.warming_clusters_.set(warming_clusters_.size());
 }
 
+OnDemandClusterHandlePtr ClusterManagerImpl::loadOnDemandCluster(const std::string& cluster,
+                                                                 std::function<void()> callback) {
+  ThreadLocalClusterManagerImpl& cluster_manager = tls_->getTyped<ThreadLocalClusterManagerImpl>();
+
+  if (cluster_manager.thread_local_clusters_.count(cluster) > 0 ||
+      cluster_manager.on_demand_clusters_.count(cluster) == 0) {
+    return nullptr;
+  }
+
+  // Only the first waiter on this thread asks the main thread to load the cluster.
+  auto& pending = cluster_manager.pending_on_demand_clusters_[cluster];
+  const bool first = pending.empty();
+  auto handle = std::make_unique<OnDemandClusterHandleImpl>(callback, pending);
+  if (first) {
+    dispatcher_.post([this, cluster]() -> void { loadOnDemandClusterOnMainThread(cluster); });
+  }
+  return std::move(handle);
+}
+
 ThreadLocalCluster* ClusterManagerImpl::get(const std::string& cluster) {
   ThreadLocalClusterManagerImpl& cluster_manager = tls_->getTyped<ThreadLocalClusterManagerImpl>();
 
@@ -648,6 +826,10 @@ ThreadLocalCluster* ClusterManagerImpl::get(const std::string& cluster) {
   }
 }
 
+ThreadLocalCluster* ClusterManagerImpl::get(const ClusterNameHandle& cluster) {
+  return tls_->getTyped<ThreadLocalClusterManagerImpl>().clusterByHandle(cluster);
+}
+
 Http::ConnectionPool::Instance*
 ClusterManagerImpl::httpConnPoolForCluster(const std::string& cluster, ResourcePriority priority,
                                            Http::Protocol protocol, LoadBalancerContext* context) {
@@ -662,6 +844,19 @@ ClusterManagerImpl::httpConnPoolForCluster(const std::string& cluster, ResourceP
   return entry->second->connPool(priority, protocol, context);
 }
 
+Http::ConnectionPool::Instance*
+ClusterManagerImpl::httpConnPoolForCluster(const ClusterNameHandle& cluster,
+                                           ResourcePriority priority, Http::Protocol protocol,
+                                           LoadBalancerContext* context) {
+  ThreadLocalClusterManagerImpl::ClusterEntry* entry =
+      tls_->getTyped<ThreadLocalClusterManagerImpl>().clusterByHandle(cluster);
+  if (entry == nullptr) {
+    return nullptr;
+  }
+
+  return entry->connPool(priority, protocol, context);
+}
+
 Tcp::ConnectionPool::Instance*
 ClusterManagerImpl::tcpConnPoolForCluster(const std::string& cluster, ResourcePriority priority,
                                           LoadBalancerContext* context) {
@@ -789,6 +984,18 @@ ClusterManagerImpl::ClusterUpdateCallbacksHandleImpl::~ClusterUpdateCallbacksHan
   list.erase(entry);
 }
 
+ClusterManagerImpl::OnDemandClusterHandleImpl::OnDemandClusterHandleImpl(
+    std::function<void()> callback, std::list<OnDemandClusterHandleImpl*>& parent)
+    : callback_(callback), list_(parent) {
+  entry_ = parent.emplace(parent.end(), this);
+}
+
+ClusterManagerImpl::OnDemandClusterHandleImpl::~OnDemandClusterHandleImpl() {
+  if (inserted_) {
+    list_.erase(entry_);
+  }
+}
+
 ClusterManagerImpl::ThreadLocalClusterManagerImpl::ThreadLocalClusterManagerImpl(
     ClusterManagerImpl& parent, Event::Dispatcher& dispatcher,
     const absl::optional<std::string>& local_cluster_name)
@@ -797,14 +1004,14 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ThreadLocalClusterManagerImpl
   if (local_cluster_name) {
     ENVOY_LOG(debug, "adding TLS local cluster {}", local_cluster_name.value());
     auto& local_cluster = parent.active_clusters_.at(local_cluster_name.value());
-    thread_local_clusters_[local_cluster_name.value()].reset(new ClusterEntry(
-        *this, local_cluster->cluster_->info(), local_cluster->loadBalancerFactory()));
+    local_priority_set_ =
+        &setCluster(local_cluster_name.value(),
+                    std::make_unique<ClusterEntry>(*this, local_cluster->cluster_->info(),
+                                                   local_cluster->loadBalancerFactory(),
+                                                   local_cluster->locality_routing_table_cache_))
+             ->priority_set_;
   }
 
-  local_priority_set_ = local_cluster_name
-                            ? &thread_local_clusters_[local_cluster_name.value()]->priority_set_
-                            : nullptr;
-
   for (auto& cluster : parent.active_clusters_) {
     // If local cluster name is set then we already initialized this cluster.
     if (local_cluster_name && local_cluster_name.value() == cluster.first) {
@@ -813,8 +1020,10 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ThreadLocalClusterManagerImpl
 
     ENVOY_LOG(debug, "adding TLS initial cluster {}", cluster.first);
     ASSERT(thread_local_clusters_.count(cluster.first) == 0);
-    thread_local_clusters_[cluster.first].reset(new ClusterEntry(
-        *this, cluster.second->cluster_->info(), cluster.second->loadBalancerFactory()));
+    setCluster(cluster.first,
+               std::make_unique<ClusterEntry>(*this, cluster.second->cluster_->info(),
+                                              cluster.second->loadBalancerFactory(),
+                                              cluster.second->locality_routing_table_cache_));
   }
 }
 
@@ -827,6 +1036,7 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::~ThreadLocalClusterManagerImp
   //                     redis/conn_pool_impl.cc. Will fix at the same time.
   ENVOY_LOG(debug, "shutting down thread local cluster manager");
   destroying_ = true;
+  clusters_by_index_.clear();
   host_http_conn_pool_map_.clear();
   host_tcp_conn_pool_map_.clear();
   ASSERT(host_tcp_conn_map_.empty());
@@ -836,6 +1046,52 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::~ThreadLocalClusterManagerImp
     }
   }
   thread_local_clusters_.clear();
+  for (auto& pending : pending_on_demand_clusters_) {
+    for (OnDemandClusterHandleImpl* handle : pending.second) {
+      handle->inserted_ = false;
+    }
+  }
+}
+
+void ClusterManagerImpl::ThreadLocalClusterManagerImpl::onOnDemandClusterReady(
+    const std::string& name) {
+  auto pending = pending_on_demand_clusters_.find(name);
+  if (pending == pending_on_demand_clusters_.end()) {
+    return;
+  }
+
+  // The handles are taken off the list one at a time, as a callback may destroy the handles of
+  // other waiters, which then remove themselves from the list.
+  std::list<OnDemandClusterHandleImpl*>& handles = pending->second;
+  while (!handles.empty()) {
+    OnDemandClusterHandleImpl* handle = handles.front();
+    handles.pop_front();
+    handle->inserted_ = false;
+    // Copied, as the callback may destroy the handle.
+    const std::function<void()> callback = handle->callback_;
+    callback();
+  }
+  pending_on_demand_clusters_.erase(name);
+}
+
+ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry*
+ClusterManagerImpl::ThreadLocalClusterManagerImpl::setCluster(const std::string& name,
+                                                              ClusterEntryPtr&& cluster) {
+  const uint32_t index = ClusterNameRegistry::index(name);
+  if (index >= clusters_by_index_.size()) {
+    clusters_by_index_.resize(index + 1);
+  }
+  clusters_by_index_[index] = cluster.get();
+  ClusterEntryPtr& entry = thread_local_clusters_[name];
+  entry = std::move(cluster);
+  return entry.get();
+}
+
+void ClusterManagerImpl::ThreadLocalClusterManagerImpl::eraseCluster(const std::string& name) {
+  const uint32_t index = ClusterNameRegistry::index(name);
+  ASSERT(index < clusters_by_index_.size());
+  clusters_by_index_[index] = nullptr;
+  thread_local_clusters_.erase(name);
 }
 
 void ClusterManagerImpl::ThreadLocalClusterManagerImpl::drainConnPools(const HostVector& hosts) {
@@ -1014,7 +1270,8 @@ void ClusterManagerImpl::ThreadLocalClusterManagerImpl::onHostHealthFailure(
 
 ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::ClusterEntry(
     ThreadLocalClusterManagerImpl& parent, ClusterInfoConstSharedPtr cluster,
-    const LoadBalancerFactorySharedPtr& lb_factory)
+    const LoadBalancerFactorySharedPtr& lb_factory,
+    const LocalityRoutingTableCacheSharedPtr& locality_routing_table_cache)
     : parent_(parent), lb_factory_(lb_factory), cluster_info_(cluster),
       http_async_client_(*cluster, parent.parent_.stats_, parent.thread_local_dispatcher_,
                          parent.parent_.local_info_, parent.parent_, parent.parent_.runtime_,
@@ -1028,32 +1285,47 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::ClusterEntry(
     lb_.reset(new SubsetLoadBalancer(cluster->lbType(), priority_set_, parent_.local_priority_set_,
                                      cluster->stats(), parent.parent_.runtime_,
                                      parent.parent_.random_, cluster->lbSubsetInfo(),
-                                     cluster->lbRingHashConfig(), cluster->lbConfig()));
+                                     cluster->lbRingHashConfig(), cluster->lbMaglevConfig(),
+                                     cluster->lbBoundedLoadRingHashConfig(),
+                                     cluster->lbLeastRequestConfig(), cluster->lbConfig(),
+                                     parent.parent_.time_source_));
   } else {
     switch (cluster->lbType()) {
     case LoadBalancerType::LeastRequest: {
       ASSERT(lb_factory_ == nullptr);
-      lb_.reset(new LeastRequestLoadBalancer(priority_set_, parent_.local_priority_set_,
-                                             cluster->stats(), parent.parent_.runtime_,
-                                             parent.parent_.random_, cluster->lbConfig()));
+      lb_.reset(new LeastRequestLoadBalancer(
+          priority_set_, parent_.local_priority_set_, cluster->stats(), parent.parent_.runtime_,
+          parent.parent_.random_, cluster->lbConfig(), cluster->lbLeastRequestConfig(),
+          locality_routing_table_cache));
+      break;
+    }
+    case LoadBalancerType::PeakEwma: {
+      ASSERT(lb_factory_ == nullptr);
+      lb_.reset(new PeakEwmaLoadBalancer(priority_set_, parent_.local_priority_set_,
+                                         cluster->stats(), parent.parent_.runtime_,
+                                         parent.parent_.random_, cluster->lbConfig(),
+                                         parent.parent_.time_source_,
+                                         locality_routing_table_cache));
       break;
     }
     case LoadBalancerType::Random: {
       ASSERT(lb_factory_ == nullptr);
       lb_.reset(new RandomLoadBalancer(priority_set_, parent_.local_priority_set_, cluster->stats(),
                                        parent.parent_.runtime_, parent.parent_.random_,
-                                       cluster->lbConfig()));
+                                       cluster->lbConfig(), locality_routing_table_cache));
       break;
     }
     case LoadBalancerType::RoundRobin: {
       ASSERT(lb_factory_ == nullptr);
       lb_.reset(new RoundRobinLoadBalancer(priority_set_, parent_.local_priority_set_,
                                            cluster->stats(), parent.parent_.runtime_,
-                                           parent.parent_.random_, cluster->lbConfig()));
+                                           parent.parent_.random_, cluster->lbConfig(),
+                                           locality_routing_table_cache));
       break;
     }
     case LoadBalancerType::RingHash:
-    case LoadBalancerType::Maglev: {
+    case LoadBalancerType::Maglev:
+    case LoadBalancerType::BoundedLoadRingHash: {
       ASSERT(lb_factory_ != nullptr);
       lb_ = lb_factory_->create();
       break;
@@ -1069,11 +1341,12 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::ClusterEntry(
   }
 
   priority_set_.addMemberUpdateCb(
-      [this](uint32_t, const HostVector&, const HostVector& hosts_removed) -> void {
+      [this](uint32_t, const HostVector& hosts_added, const HostVector& hosts_removed) -> void {
         // We need to go through and purge any connection pools for hosts that got deleted.
         // Even if two hosts actually point to the same address this will be safe, since if a
         // host is readded it will be a different physical HostSharedPtr.
         parent_.drainConnPools(hosts_removed);
+        prefetchConnPools(hosts_added);
       });
 }
 
@@ -1089,6 +1362,28 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::~ClusterEntry()
   }
 }
 
+void ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::prefetchConnPools(
+    const HostVector& hosts) {
+  if (cluster_info_->prefetchMinConnections() == 0) {
+    return;
+  }
+
+  // Warm the pool that requests without socket options use at the default priority. The initial
+  // hosts of a cluster also arrive here, so this covers cluster creation as well.
+  const Http::Protocol protocol = (cluster_info_->features() & ClusterInfo::Features::HTTP2)
+                                      ? Http::Protocol::Http2
+                                      : Http::Protocol::Http11;
+  const std::vector<uint8_t> hash_key = {uint8_t(protocol), uint8_t(ResourcePriority::Default)};
+  for (const HostSharedPtr& host : hosts) {
+    ConnPoolsContainer& container = parent_.host_http_conn_pool_map_[host];
+    if (!container.pools_[hash_key]) {
+      container.pools_[hash_key] =
+          allocateConnPool(host, ResourcePriority::Default, protocol, hash_key, nullptr);
+    }
+    container.pools_[hash_key]->prefetch();
+  }
+}
+
 Http::ConnectionPool::Instance*
 ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::connPool(
     ResourcePriority priority, Http::Protocol protocol, LoadBalancerContext* context) {
@@ -1119,14 +1414,35 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::connPool(
 
   ConnPoolsContainer& container = parent_.host_http_conn_pool_map_[host];
   if (!container.pools_[hash_key]) {
-    container.pools_[hash_key] = parent_.parent_.factory_.allocateConnPool(
-        parent_.thread_local_dispatcher_, host, priority, protocol,
+    container.pools_[hash_key] = allocateConnPool(
+        host, priority, protocol, hash_key,
         have_options ? context->downstreamConnection()->socketOptions() : nullptr);
   }
 
   return container.pools_[hash_key].get();
 }
 
+Http::ConnectionPool::InstancePtr
+ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::allocateConnPool(
+    HostConstSharedPtr host, ResourcePriority priority, Http::Protocol protocol,
+    const std::vector<uint8_t>& hash_key,
+    const Network::ConnectionSocket::OptionsSharedPtr& options) {
+  auto factory = [this, host, priority, protocol, &options]() {
+    return parent_.parent_.factory_.allocateConnPool(parent_.thread_local_dispatcher_, host,
+                                                     priority, protocol, options);
+  };
+
+  // Connections that inherit downstream socket options are specific to the downstream
+  // connection, so their pools are never shared.
+  if (protocol == Http::Protocol::Http2 && options == nullptr &&
+      (cluster_info_->features() & ClusterInfo::Features::SHARE_HTTP2_CONNECTIONS_ACROSS_WORKERS)) {
+    return parent_.parent_.shared_http_conn_pools_->pool(*host, hash_key,
+                                                         parent_.thread_local_dispatcher_, factory);
+  }
+
+  return factory();
+}
+
 Tcp::ConnectionPool::Instance*
 ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::tcpConnPool(
     ResourcePriority priority, LoadBalancerContext* context) {
@@ -1170,6 +1486,17 @@ ClusterManagerPtr ProdClusterManagerFactory::clusterManagerFromProto(
     ThreadLocal::Instance& tls, Runtime::Loader& runtime, Runtime::RandomGenerator& random,
     const LocalInfo::LocalInfo& local_info, AccessLog::AccessLogManager& log_manager,
     Server::Admin& admin) {
+  if (bootstrap.cluster_manager().has_dns_cache()) {
+    // Every cluster using the default resolver shares the cache.
+    const auto& dns_cache = bootstrap.cluster_manager().dns_cache();
+    dns_resolver_ = std::make_shared<Network::DnsCacheImpl>(
+        dns_resolver_, main_thread_dispatcher_, stats,
+        std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::milliseconds(PROTOBUF_GET_MS_OR_DEFAULT(dns_cache, min_ttl, 5000))),
+        std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::milliseconds(PROTOBUF_GET_MS_OR_DEFAULT(dns_cache, max_ttl, 300000))));
+  }
+
   return ClusterManagerPtr{new ClusterManagerImpl(bootstrap, *this, stats, tls, runtime, random,
                                                   local_info, log_manager, main_thread_dispatcher_,
                                                   admin)};
@@ -1204,6 +1531,28 @@ ClusterSharedPtr ProdClusterManagerFactory::clusterFromProto(
                                  local_info_, outlier_event_logger, added_via_api);
 }
 
+ClusterPreparationPtr
+ProdClusterManagerFactory::prepareCluster(const envoy::api::v2::Cluster& cluster) {
+  // Only the trusted CA of a TLS context is prepared. SDS secrets and custom transport sockets are
+  // only resolved when the cluster is allocated.
+  if (cluster.has_transport_socket() || !cluster.has_tls_context() ||
+      !cluster.tls_context().common_tls_context().has_validation_context()) {
+    return nullptr;
+  }
+  std::string ca_cert;
+  try {
+    ca_cert = Config::DataSource::read(
+        cluster.tls_context().common_tls_context().validation_context().trusted_ca(), true);
+  } catch (const EnvoyException&) {
+    // Reported when allocating the cluster.
+    return nullptr;
+  }
+  if (ca_cert.empty()) {
+    return nullptr;
+  }
+  return std::make_unique<TrustedCaPreparation>(ssl_context_manager_.prepareTrustedCa(ca_cert));
+}
+
 CdsApiPtr ProdClusterManagerFactory::createCds(
     const envoy::api::v2::core::ConfigSource& cds_config,
     const absl::optional<envoy::api::v2::core::ConfigSource>& eds_config, ClusterManager& cm) {
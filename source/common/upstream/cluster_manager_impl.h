@@ -7,6 +7,8 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "envoy/config/bootstrap/v2/bootstrap.pb.h"
@@ -21,6 +23,8 @@
 
 #include "common/config/grpc_mux_impl.h"
 #include "common/http/async_client_impl.h"
+#include "common/http/shared_conn_pool.h"
+#include "common/upstream/load_balancer_impl.h"
 #include "common/upstream/load_stats_reporter.h"
 #include "common/upstream/upstream_impl.h"
 
@@ -62,6 +66,7 @@ public:
                                     Outlier::EventLoggerSharedPtr outlier_event_logger,
                                     AccessLog::AccessLogManager& log_manager,
                                     bool added_via_api) override;
+  ClusterPreparationPtr prepareCluster(const envoy::api::v2::Cluster& cluster) override;
   CdsApiPtr createCds(const envoy::api::v2::core::ConfigSource& cds_config,
                       const absl::optional<envoy::api::v2::core::ConfigSource>& eds_config,
                       ClusterManager& cm) override;
@@ -71,6 +76,12 @@ protected:
   Event::Dispatcher& main_thread_dispatcher_;
 
 private:
+  struct TrustedCaPreparation : public ClusterPreparation {
+    TrustedCaPreparation(Ssl::TrustedCaConstSharedPtr trusted_ca) : trusted_ca_(trusted_ca) {}
+
+    const Ssl::TrustedCaConstSharedPtr trusted_ca_;
+  };
+
   Runtime::Loader& runtime_;
   Stats::Store& stats_;
   ThreadLocal::Instance& tls_;
@@ -138,12 +149,15 @@ private:
 #define ALL_CLUSTER_MANAGER_STATS(COUNTER, GAUGE)                                                  \
   COUNTER(cluster_added)                                                                           \
   COUNTER(cluster_modified)                                                                        \
+  COUNTER(cluster_on_demand_loaded)                                                                \
+  COUNTER(cluster_on_demand_unloaded)                                                              \
   COUNTER(cluster_removed)                                                                         \
   COUNTER(cluster_updated)                                                                         \
   COUNTER(cluster_updated_via_merge)                                                               \
   COUNTER(update_merge_cancelled)                                                                  \
   COUNTER(update_out_of_merge_window)                                                              \
   GAUGE  (active_clusters)                                                                         \
+  GAUGE  (on_demand_clusters)                                                                      \
   GAUGE  (warming_clusters)
 // clang-format on
 
@@ -183,10 +197,17 @@ public:
     return clusters_map;
   }
   ThreadLocalCluster* get(const std::string& cluster) override;
+  ThreadLocalCluster* get(const ClusterNameHandle& cluster) override;
+  OnDemandClusterHandlePtr loadOnDemandCluster(const std::string& cluster,
+                                               std::function<void()> callback) override;
   Http::ConnectionPool::Instance* httpConnPoolForCluster(const std::string& cluster,
                                                          ResourcePriority priority,
                                                          Http::Protocol protocol,
                                                          LoadBalancerContext* context) override;
+  Http::ConnectionPool::Instance* httpConnPoolForCluster(const ClusterNameHandle& cluster,
+                                                         ResourcePriority priority,
+                                                         Http::Protocol protocol,
+                                                         LoadBalancerContext* context) override;
   Tcp::ConnectionPool::Instance* tcpConnPoolForCluster(const std::string& cluster,
                                                        ResourcePriority priority,
                                                        LoadBalancerContext* context) override;
@@ -198,6 +219,7 @@ public:
     cds_api_.reset();
     ads_mux_.reset();
     active_clusters_.clear();
+    on_demand_idle_timer_.reset();
   }
 
   const envoy::api::v2::core::BindConfig& bindConfig() const override { return bind_config_; }
@@ -219,6 +241,8 @@ protected:
                                             const HostVector& hosts_removed);
 
 private:
+  struct OnDemandClusterHandleImpl;
+
   /**
    * Thread local cached cluster data. Each thread local cluster gets updates from the parent
    * central dynamic cluster (if applicable). It maintains load balancer state and any created
@@ -268,7 +292,8 @@ private:
 
     struct ClusterEntry : public ThreadLocalCluster {
       ClusterEntry(ThreadLocalClusterManagerImpl& parent, ClusterInfoConstSharedPtr cluster,
-                   const LoadBalancerFactorySharedPtr& lb_factory);
+                   const LoadBalancerFactorySharedPtr& lb_factory,
+                   const LocalityRoutingTableCacheSharedPtr& locality_routing_table_cache);
       ~ClusterEntry();
 
       Http::ConnectionPool::Instance* connPool(ResourcePriority priority, Http::Protocol protocol,
@@ -276,6 +301,11 @@ private:
 
       Tcp::ConnectionPool::Instance* tcpConnPool(ResourcePriority priority,
                                                  LoadBalancerContext* context);
+      void prefetchConnPools(const HostVector& hosts);
+      Http::ConnectionPool::InstancePtr
+      allocateConnPool(HostConstSharedPtr host, ResourcePriority priority, Http::Protocol protocol,
+                       const std::vector<uint8_t>& hash_key,
+                       const Network::ConnectionSocket::OptionsSharedPtr& options);
 
       // Upstream::ThreadLocalCluster
       const PrioritySet& prioritySet() override { return priority_set_; }
@@ -312,10 +342,21 @@ private:
                                         const HostVector& hosts_added,
                                         const HostVector& hosts_removed, ThreadLocal::Slot& tls);
     static void onHostHealthFailure(const HostSharedPtr& host, ThreadLocal::Slot& tls);
+    void onOnDemandClusterReady(const std::string& name);
+    // Add or replace a cluster, keeping clusters_by_index_ in step with thread_local_clusters_.
+    ClusterEntry* setCluster(const std::string& name, ClusterEntryPtr&& cluster);
+    void eraseCluster(const std::string& name);
+    ClusterEntry* clusterByHandle(const ClusterNameHandle& handle) const {
+      return handle.index() < clusters_by_index_.size() ? clusters_by_index_[handle.index()]
+                                                        : nullptr;
+    }
 
     ClusterManagerImpl& parent_;
     Event::Dispatcher& thread_local_dispatcher_;
     std::unordered_map<std::string, ClusterEntryPtr> thread_local_clusters_;
+    // The entries of thread_local_clusters_ by the index their name is interned to in the
+    // ClusterNameRegistry, or nullptr for names without a cluster on this thread.
+    std::vector<ClusterEntry*> clusters_by_index_;
 
     // These maps are owned by the ThreadLocalClusterManagerImpl instead of the ClusterEntry
     // to prevent lifetime/ownership issues when a cluster is dynamically removed.
@@ -324,14 +365,20 @@ private:
     std::unordered_map<HostConstSharedPtr, TcpConnectionsMap> host_tcp_conn_map_;
 
     std::list<Envoy::Upstream::ClusterUpdateCallbacks*> update_callbacks_;
+    // Names of the on-demand clusters, which are only in thread_local_clusters_ when loaded.
+    std::unordered_set<std::string> on_demand_clusters_;
+    // Loads of on-demand clusters waited for on this thread, by cluster name.
+    std::unordered_map<std::string, std::list<OnDemandClusterHandleImpl*>>
+        pending_on_demand_clusters_;
     const PrioritySet* local_priority_set_{};
     bool destroying_{};
   };
 
   struct ClusterData {
-    ClusterData(const envoy::api::v2::Cluster& cluster_config, const std::string& version_info,
-                bool added_via_api, ClusterSharedPtr&& cluster, TimeSource& time_source)
-        : cluster_config_(cluster_config), config_hash_(MessageUtil::hash(cluster_config)),
+    ClusterData(const envoy::api::v2::Cluster& cluster_config, uint64_t config_hash,
+                const std::string& version_info, bool added_via_api, ClusterSharedPtr&& cluster,
+                TimeSource& time_source)
+        : cluster_config_(cluster_config), config_hash_(config_hash),
           version_info_(version_info), added_via_api_(added_via_api), cluster_(std::move(cluster)),
           last_updated_(time_source.systemTime()) {}
 
@@ -352,7 +399,21 @@ private:
     ClusterSharedPtr cluster_;
     // Optional thread aware LB depending on the LB type. Not all clusters have one.
     ThreadAwareLoadBalancerPtr thread_aware_lb_;
+    // Shared by the zone aware LBs of the cluster on all workers.
+    const LocalityRoutingTableCacheSharedPtr locality_routing_table_cache_{
+        std::make_shared<LocalityRoutingTableCache>()};
     SystemTime last_updated_;
+    // Upstream requests and connections made by an on-demand cluster as of the last idle check.
+    absl::optional<uint64_t> on_demand_activity_;
+  };
+
+  /**
+   * The config of a CDS cluster in on-demand mode, which is kept whether or not it is loaded.
+   */
+  struct OnDemandCluster {
+    envoy::api::v2::Cluster cluster_config_;
+    uint64_t config_hash_;
+    std::string version_info_;
   };
 
   struct ClusterUpdateCallbacksHandleImpl : public ClusterUpdateCallbacksHandle {
@@ -365,6 +426,17 @@ private:
     std::list<ClusterUpdateCallbacks*>& list;
   };
 
+  struct OnDemandClusterHandleImpl : public OnDemandClusterHandle {
+    OnDemandClusterHandleImpl(std::function<void()> callback,
+                              std::list<OnDemandClusterHandleImpl*>& parent);
+    ~OnDemandClusterHandleImpl() override;
+
+    std::function<void()> callback_;
+    std::list<OnDemandClusterHandleImpl*>::iterator entry_;
+    std::list<OnDemandClusterHandleImpl*>& list_;
+    bool inserted_{true};
+  };
+
   typedef std::unique_ptr<ClusterData> ClusterDataPtr;
   // This map is ordered so that config dumping is consistent.
   typedef std::map<std::string, ClusterDataPtr> ClusterMap;
@@ -408,12 +480,21 @@ private:
   void createOrUpdateThreadLocalCluster(ClusterData& cluster);
   ProtobufTypes::MessagePtr dumpClusterConfigs();
   static ClusterManagerStats generateStats(Stats::Scope& scope);
-  void loadCluster(const envoy::api::v2::Cluster& cluster, const std::string& version_info,
-                   bool added_via_api, ClusterMap& cluster_map);
+  void loadCluster(const envoy::api::v2::Cluster& cluster, uint64_t config_hash,
+                   const std::string& version_info, bool added_via_api, ClusterMap& cluster_map);
+  void loadOrUpdateCluster(const envoy::api::v2::Cluster& cluster, uint64_t config_hash,
+                           const std::string& version_info);
+  void loadOnDemandClusterOnMainThread(const std::string& cluster_name);
   void onClusterInit(Cluster& cluster);
+  void onOnDemandIdleTimer();
+  void postOnDemandClusterReady(const std::string& cluster_name);
   void postThreadLocalHealthFailure(const HostSharedPtr& host);
+  bool removeLoadedCluster(const std::string& cluster_name);
   void updateGauges();
 
+  // Static clusters are prepared in parallel batches of at least this many clusters.
+  static constexpr size_t ClustersPerPrepareThread = 16;
+
   ClusterManagerFactory& factory_;
   Runtime::Loader& runtime_;
   Stats::Store& stats_;
@@ -422,6 +503,11 @@ private:
   AccessLog::AccessLogManager& log_manager_;
   ClusterMap active_clusters_;
   ClusterMap warming_clusters_;
+  // CDS clusters are only loaded when first used if on-demand mode is enabled.
+  const bool on_demand_;
+  std::unordered_map<std::string, OnDemandCluster> on_demand_clusters_;
+  std::chrono::milliseconds on_demand_idle_timeout_{};
+  Event::TimerPtr on_demand_idle_timer_;
   absl::optional<envoy::api::v2::core::ConfigSource> eds_config_;
   envoy::api::v2::core::BindConfig bind_config_;
   Outlier::EventLoggerSharedPtr outlier_event_logger_;
@@ -438,6 +524,9 @@ private:
   TimeSource& time_source_;
   ClusterUpdatesMap updates_map_;
   Event::Dispatcher& dispatcher_;
+  // HTTP/2 connection pools shared across workers, for clusters that opt into sharing them.
+  Http::SharedConnPoolRegistrySharedPtr shared_http_conn_pools_{
+      std::make_shared<Http::SharedConnPoolRegistry>()};
 };
 
 } // namespace Upstream
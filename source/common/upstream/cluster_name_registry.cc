@@ -0,0 +1,34 @@
+#include "common/upstream/cluster_name_registry.h"
+
+#include "common/common/assert.h"
+#include "common/common/lock_guard.h"
+
+namespace Envoy {
+namespace Upstream {
+
+ClusterNameHandle ClusterNameRegistry::registerName(const std::string& name) {
+  return ClusterNameHandle(name, index(name));
+}
+
+uint32_t ClusterNameRegistry::index(const std::string& name) { return get().intern(name); }
+
+ClusterNameRegistry& ClusterNameRegistry::get() {
+  static ClusterNameRegistry* registry = new ClusterNameRegistry();
+  return *registry;
+}
+
+uint32_t ClusterNameRegistry::intern(const std::string& name) {
+  Thread::LockGuard lock(lock_);
+  auto it = indexes_.find(name);
+  if (it != indexes_.end()) {
+    return it->second;
+  }
+
+  ASSERT(indexes_.size() < UINT32_MAX);
+  const uint32_t index = indexes_.size();
+  indexes_.emplace(name, index);
+  return index;
+}
+
+} // namespace Upstream
+} // namespace Envoy
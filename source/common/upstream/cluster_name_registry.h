@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "envoy/upstream/cluster_name_handle.h"
+
+#include "common/common/thread.h"
+#include "common/common/thread_annotations.h"
+
+namespace Envoy {
+namespace Upstream {
+
+/**
+ * Process-wide table interning cluster names to dense indexes. Routes register handles for the
+ * clusters they name, and the cluster manager indexes its thread local clusters by the same
+ * indexes, so that a handle resolves to its cluster with a single array index whatever the
+ * clusters added or removed since. Interned names are never removed.
+ */
+class ClusterNameRegistry {
+public:
+  /**
+   * Intern a cluster name, returning its existing index if it was already interned.
+   * @param name supplies the cluster name.
+   * @return ClusterNameHandle the handle to look the cluster up with.
+   */
+  static ClusterNameHandle registerName(const std::string& name);
+
+  /**
+   * @param name supplies the cluster name.
+   * @return uint32_t the index the name is interned to, interning it if necessary.
+   */
+  static uint32_t index(const std::string& name);
+
+private:
+  static ClusterNameRegistry& get();
+
+  uint32_t intern(const std::string& name);
+
+  Thread::MutexBasicLockable lock_;
+  std::unordered_map<std::string, uint32_t> indexes_ GUARDED_BY(lock_);
+};
+
+} // namespace Upstream
+} // namespace Envoy
@@ -1,8 +1,16 @@
+#pragma once
+
 #include <cstdint>
+#include <limits>
+#include <memory>
 #include <queue>
+#include <utility>
+#include <vector>
 
 #include "common/common/assert.h"
 
+#include "absl/types/optional.h"
+
 namespace Envoy {
 namespace Upstream {
 
@@ -71,6 +79,12 @@ public:
    */
   bool empty() const { return queue_.empty(); }
 
+  /**
+   * Implements size() on the internal queue. Does not attempt to discard expired elements.
+   * @return size_t the number of entries in the internal queue, including the expired ones.
+   */
+  size_t size() const { return queue_.size(); }
+
 private:
   struct EdfEntry {
     double deadline_;
@@ -98,6 +112,170 @@ private:
   std::priority_queue<EdfEntry> queue_;
 };
 
+// EDF scheduler over entries identified by a dense index, i.e. an index into a vector of entries
+// kept by the caller. Unlike EdfScheduler, the entries stay scheduled when they are picked, and
+// their weights can be updated and the entries removed in place. The schedule is an indexed binary
+// heap, so picks, weight updates, insertions and removals are O(log n) and picks don't allocate.
+class IndexedEdfScheduler {
+public:
+  /**
+   * Schedule an entry with a given weight, or update the weight of a scheduled entry. A new entry
+   * has its deadline at current_time_ + 1 / weight. The time left until the deadline of a scheduled
+   * entry is scaled by its old weight / weight, so that it keeps its progress towards its next
+   * pick.
+   * @param index of the entry.
+   * @param weight floating point weight.
+   */
+  void set(uint32_t index, double weight) {
+    ASSERT(weight > 0);
+    if (index >= positions_.size()) {
+      positions_.resize(index + 1, NotScheduled);
+    }
+    uint32_t position = positions_[index];
+    if (position == NotScheduled) {
+      position = heap_.size();
+      heap_.push_back({current_time_ + 1.0 / weight, order_offset_++, weight, index});
+      positions_[index] = position;
+      siftUp(position);
+      return;
+    }
+
+    HeapEntry& entry = heap_[position];
+    if (entry.weight_ == weight) {
+      return;
+    }
+    const double old_deadline = entry.deadline_;
+    entry.deadline_ = current_time_ + (old_deadline - current_time_) * entry.weight_ / weight;
+    entry.weight_ = weight;
+    EDF_TRACE("Weight update of {} to {}, deadline {}.", index, weight, entry.deadline_);
+    if (entry.deadline_ < old_deadline) {
+      siftUp(position);
+    } else {
+      siftDown(position);
+    }
+  }
+
+  /**
+   * Remove an entry from the schedule. This is a no-op if the entry isn't scheduled.
+   * @param index of the entry.
+   */
+  void remove(uint32_t index) {
+    if (index >= positions_.size() || positions_[index] == NotScheduled) {
+      return;
+    }
+    const uint32_t position = positions_[index];
+    positions_[index] = NotScheduled;
+    if (position + 1 == heap_.size()) {
+      heap_.pop_back();
+      return;
+    }
+    heap_[position] = heap_.back();
+    heap_.pop_back();
+    positions_[heap_[position].index_] = position;
+    // The entry moved from the end of the heap may belong on either side of its new position.
+    siftUp(position);
+    siftDown(positions_[heap_[position].index_]);
+  }
+
+  /**
+   * Pick the entry with the earliest deadline. The entry stays scheduled, with its next deadline
+   * at the current time + 1 / weight.
+   * @return absl::optional<uint32_t> the index of the picked entry, or nothing if the schedule is
+   *         empty.
+   */
+  absl::optional<uint32_t> pick() {
+    if (heap_.empty()) {
+      return absl::nullopt;
+    }
+    HeapEntry& entry = heap_.front();
+    ASSERT(entry.deadline_ >= current_time_);
+    current_time_ = entry.deadline_;
+    entry.deadline_ = current_time_ + 1.0 / entry.weight_;
+    entry.order_offset_ = order_offset_++;
+    const uint32_t index = entry.index_;
+    siftDown(0);
+    EDF_TRACE("Picked {}, current_time_={}.", index, current_time_);
+    return index;
+  }
+
+  /**
+   * @return bool whether an entry is scheduled.
+   */
+  bool contains(uint32_t index) const {
+    return index < positions_.size() && positions_[index] != NotScheduled;
+  }
+
+  /**
+   * @return double the weight of a scheduled entry.
+   */
+  double weight(uint32_t index) const {
+    ASSERT(contains(index));
+    return heap_[positions_[index]].weight_;
+  }
+
+  bool empty() const { return heap_.empty(); }
+  size_t size() const { return heap_.size(); }
+
+private:
+  struct HeapEntry {
+    double deadline_;
+    // Tie breaker for entries with the same deadline. This is used to provide FIFO behavior.
+    uint64_t order_offset_;
+    double weight_;
+    uint32_t index_;
+
+    bool operator<(const HeapEntry& other) const {
+      return deadline_ < other.deadline_ ||
+             (deadline_ == other.deadline_ && order_offset_ < other.order_offset_);
+    }
+  };
+
+  // Position of the entries that are not scheduled. An enumerator needs no out of line definition.
+  enum : uint32_t { NotScheduled = std::numeric_limits<uint32_t>::max() };
+
+  void siftUp(uint32_t position) {
+    while (position > 0) {
+      const uint32_t parent = (position - 1) / 2;
+      if (!(heap_[position] < heap_[parent])) {
+        break;
+      }
+      swap(position, parent);
+      position = parent;
+    }
+  }
+
+  void siftDown(uint32_t position) {
+    while (true) {
+      const uint32_t left = 2 * position + 1;
+      if (left >= heap_.size()) {
+        break;
+      }
+      const uint32_t right = left + 1;
+      const uint32_t child = right < heap_.size() && heap_[right] < heap_[left] ? right : left;
+      if (!(heap_[child] < heap_[position])) {
+        break;
+      }
+      swap(position, child);
+      position = child;
+    }
+  }
+
+  void swap(uint32_t a, uint32_t b) {
+    std::swap(heap_[a], heap_[b]);
+    positions_[heap_[a].index_] = a;
+    positions_[heap_[b].index_] = b;
+  }
+
+  // Current time in EDF scheduler.
+  double current_time_{};
+  // Offset used to break ties between entries with the same deadline, in FIFO order.
+  uint64_t order_offset_{};
+  // Min heap of the scheduled entries, ordered by deadline.
+  std::vector<HeapEntry> heap_;
+  // Position of each entry in heap_, by index, or NotScheduled.
+  std::vector<uint32_t> positions_;
+};
+
 #undef EDF_DEBUG
 
 } // namespace Upstream
@@ -43,7 +43,8 @@ EdsClusterImpl::EdsClusterImpl(
         return new SdsSubscription(info_->stats(), eds_config, cm, dispatcher, random);
       },
       "envoy.api.v2.EndpointDiscoveryService.FetchEndpoints",
-      "envoy.api.v2.EndpointDiscoveryService.StreamEndpoints");
+      "envoy.api.v2.EndpointDiscoveryService.StreamEndpoints",
+      "envoy.api.v2.EndpointDiscoveryService.IncrementalEndpoints");
 }
 
 void EdsClusterImpl::startPreInit() { subscription_->start({cluster_name_}, *this); }
@@ -163,6 +164,14 @@ bool EdsClusterImpl::updateHostsPerLocality(
   return false;
 }
 
+void EdsClusterImpl::onIncrementalConfigUpdate(
+    const ResourceVector& added_resources, const Protobuf::RepeatedPtrField<ProtobufTypes::String>&,
+    const std::string& system_version_info) {
+  // The only watched resource is the cluster's own assignment, so an update that doesn't add it
+  // removes it, which is handled as a missing assignment.
+  onConfigUpdate(added_resources, system_version_info);
+}
+
 void EdsClusterImpl::onConfigUpdateFailed(const EnvoyException* e) {
   UNREFERENCED_PARAMETER(e);
   // We need to allow server startup to continue, even if we have a bad config.
@@ -3,6 +3,8 @@
 #include "envoy/data/core/v2alpha/health_check_event.pb.h"
 #include "envoy/stats/scope.h"
 
+#include "common/common/lock_guard.h"
+#include "common/protobuf/utility.h"
 #include "common/router/router.h"
 
 namespace Envoy {
@@ -30,6 +32,11 @@ HealthCheckerImplBase::HealthCheckerImplBase(const Cluster& cluster,
           PROTOBUF_GET_MS_OR_DEFAULT(config, unhealthy_edge_interval, unhealthy_interval_.count())),
       healthy_edge_interval_(
           PROTOBUF_GET_MS_OR_DEFAULT(config, healthy_edge_interval, interval_.count())) {
+  if (config.share_across_clusters()) {
+    shared_key_ =
+        fmt::format("{}|{}|{}", static_cast<const void*>(&dispatcher), MessageUtil::hash(config),
+                    cluster.info()->transportSocketFactory().implementsSecureTransport());
+  }
   cluster_.prioritySet().addMemberUpdateCb(
       [this](uint32_t, const HostVector& hosts_added, const HostVector& hosts_removed) -> void {
         onClusterMemberUpdate(hosts_added, hosts_removed);
@@ -174,6 +181,18 @@ void HealthCheckerImplBase::setUnhealthyCrossThread(const HostSharedPtr& host) {
   });
 }
 
+std::unordered_map<std::string, HealthCheckerImplBase::SharedSessionList>&
+HealthCheckerImplBase::sharedSessions() {
+  // Leaked, like the other process wide singletons, to avoid destruction order issues at exit.
+  static auto* shared_sessions = new std::unordered_map<std::string, SharedSessionList>();
+  return *shared_sessions;
+}
+
+Thread::MutexBasicLockable& HealthCheckerImplBase::sharedSessionsLock() {
+  static auto* lock = new Thread::MutexBasicLockable();
+  return *lock;
+}
+
 void HealthCheckerImplBase::start() {
   for (auto& host_set : cluster_.prioritySet().hostSetsPerPriority()) {
     addHosts(host_set->hosts());
@@ -183,8 +202,10 @@ void HealthCheckerImplBase::start() {
 HealthCheckerImplBase::ActiveHealthCheckSession::ActiveHealthCheckSession(
     HealthCheckerImplBase& parent, HostSharedPtr host)
     : host_(host), parent_(parent),
-      interval_timer_(parent.dispatcher_.createTimer([this]() -> void { onIntervalBase(); })),
-      timeout_timer_(parent.dispatcher_.createTimer([this]() -> void { onTimeoutBase(); })) {
+      interval_timer_(parent.dispatcher_.createTimer([this]() -> void { onIntervalBase(); },
+                                                     Event::TimerPrecision::Coarse)),
+      timeout_timer_(parent.dispatcher_.createTimer([this]() -> void { onTimeoutBase(); },
+                                                    Event::TimerPrecision::Coarse)) {
 
   if (!host->healthFlagGet(Host::HealthFlag::FAILED_ACTIVE_HC)) {
     parent.incHealthy();
@@ -195,9 +216,57 @@ HealthCheckerImplBase::ActiveHealthCheckSession::~ActiveHealthCheckSession() {
   if (!host_->healthFlagGet(Host::HealthFlag::FAILED_ACTIVE_HC)) {
     parent_.decHealthy();
   }
+
+  if (shared_sessions_ != nullptr) {
+    Thread::LockGuard lock(sharedSessionsLock());
+    const bool probing = shared_sessions_->front() == this;
+    shared_sessions_->erase(shared_session_);
+    if (shared_sessions_->empty()) {
+      sharedSessions().erase(shared_key_);
+    } else if (probing) {
+      // Another cluster's session takes over the probing. Its first probe is only scheduled, as
+      // this may run while the health checker of that session is being destroyed.
+      shared_sessions_->front()->interval_timer_->enableTimer(std::chrono::milliseconds(0));
+    }
+  }
+}
+
+void HealthCheckerImplBase::ActiveHealthCheckSession::start() {
+  if (!parent_.shared_key_.empty()) {
+    shared_key_ =
+        fmt::format("{}|{}", parent_.shared_key_, host_->healthCheckAddress()->asString());
+    Thread::LockGuard lock(sharedSessionsLock());
+    shared_sessions_ = &sharedSessions()[shared_key_];
+    shared_session_ = shared_sessions_->insert(shared_sessions_->end(), this);
+    if (shared_sessions_->front() != this) {
+      // The host is already probed on behalf of another cluster.
+      return;
+    }
+  }
+
+  onIntervalBase();
+}
+
+std::vector<HealthCheckerImplBase::ActiveHealthCheckSession*>
+HealthCheckerImplBase::ActiveHealthCheckSession::followers() const {
+  if (shared_sessions_ == nullptr) {
+    return {};
+  }
+  // A copy, as the callbacks run for the results may change the list.
+  return {std::next(shared_sessions_->begin()), shared_sessions_->end()};
 }
 
 void HealthCheckerImplBase::ActiveHealthCheckSession::handleSuccess() {
+  HealthTransition changed_state = setHealthy();
+  for (ActiveHealthCheckSession* follower : followers()) {
+    follower->setHealthy();
+  }
+
+  timeout_timer_->disableTimer();
+  interval_timer_->enableTimer(parent_.interval(HealthState::Healthy, changed_state));
+}
+
+HealthTransition HealthCheckerImplBase::ActiveHealthCheckSession::setHealthy() {
   // If we are healthy, reset the # of unhealthy to zero.
   num_unhealthy_ = 0;
 
@@ -221,9 +290,7 @@ void HealthCheckerImplBase::ActiveHealthCheckSession::handleSuccess() {
   parent_.stats_.success_.inc();
   first_check_ = false;
   parent_.runCallbacks(host_, changed_state);
-
-  timeout_timer_->disableTimer();
-  interval_timer_->enableTimer(parent_.interval(HealthState::Healthy, changed_state));
+  return changed_state;
 }
 
 HealthTransition HealthCheckerImplBase::ActiveHealthCheckSession::setUnhealthy(
@@ -261,6 +328,10 @@ HealthTransition HealthCheckerImplBase::ActiveHealthCheckSession::setUnhealthy(
 void HealthCheckerImplBase::ActiveHealthCheckSession::handleFailure(
     envoy::data::core::v2alpha::HealthCheckFailureType type) {
   HealthTransition changed_state = setUnhealthy(type);
+  for (ActiveHealthCheckSession* follower : followers()) {
+    follower->setUnhealthy(type);
+  }
+
   timeout_timer_->disableTimer();
   interval_timer_->enableTimer(parent_.interval(HealthState::Unhealthy, changed_state));
 }
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include "envoy/access_log/access_log.h"
 #include "envoy/api/v2/core/health_check.pb.h"
 #include "envoy/event/timer.h"
@@ -8,6 +13,7 @@
 #include "envoy/upstream/health_checker.h"
 
 #include "common/common/logger.h"
+#include "common/common/thread.h"
 
 namespace Envoy {
 namespace Upstream {
@@ -45,11 +51,14 @@ public:
   void start() override;
 
 protected:
+  class ActiveHealthCheckSession;
+  typedef std::list<ActiveHealthCheckSession*> SharedSessionList;
+
   class ActiveHealthCheckSession {
   public:
     virtual ~ActiveHealthCheckSession();
     HealthTransition setUnhealthy(envoy::data::core::v2alpha::HealthCheckFailureType type);
-    void start() { onIntervalBase(); }
+    void start();
 
   protected:
     ActiveHealthCheckSession(HealthCheckerImplBase& parent, HostSharedPtr host);
@@ -64,6 +73,8 @@ protected:
     void onIntervalBase();
     virtual void onTimeout() PURE;
     void onTimeoutBase();
+    HealthTransition setHealthy();
+    std::vector<ActiveHealthCheckSession*> followers() const;
 
     HealthCheckerImplBase& parent_;
     Event::TimerPtr interval_timer_;
@@ -71,6 +82,11 @@ protected:
     uint32_t num_unhealthy_{};
     uint32_t num_healthy_{};
     bool first_check_{true};
+    // Set when the health checker is shared across clusters. The first session of the list probes
+    // the host and fans its results in to the others, which don't probe.
+    std::string shared_key_;
+    SharedSessionList* shared_sessions_{};
+    SharedSessionList::iterator shared_session_;
   };
 
   typedef std::unique_ptr<ActiveHealthCheckSession> ActiveHealthCheckSessionPtr;
@@ -92,6 +108,9 @@ protected:
   Runtime::RandomGenerator& random_;
   const bool reuse_connection_;
   HealthCheckEventLoggerPtr event_logger_;
+  // Sessions of shared health checkers are shared by hosts of the same address in the clusters of
+  // the same key. Empty if the health checker isn't shared.
+  std::string shared_key_;
 
 private:
   struct HealthCheckHostMonitorImpl : public HealthCheckHostMonitor {
@@ -118,6 +137,12 @@ private:
 
   static const std::chrono::milliseconds NO_TRAFFIC_INTERVAL;
 
+  // The sessions of shared health checkers, by shared key and host address. The keys include the
+  // dispatcher, so each list is only used from a single thread, but the map is guarded for the
+  // processes that run several main threads, such as tests.
+  static std::unordered_map<std::string, SharedSessionList>& sharedSessions();
+  static Thread::MutexBasicLockable& sharedSessionsLock();
+
   std::list<HostStatusCb> callbacks_;
   const std::chrono::milliseconds interval_;
   const std::chrono::milliseconds no_traffic_interval_;
@@ -95,6 +95,10 @@ HttpHealthCheckerImpl::HttpHealthCheckerImpl(const Cluster& cluster,
   if (!config.http_health_check().service_name().empty()) {
     service_name_ = config.http_health_check().service_name();
   }
+  // The Host header defaults to the name of the cluster, which no other cluster can probe with.
+  if (host_value_.empty()) {
+    shared_key_.clear();
+  }
 }
 
 HttpHealthCheckerImpl::HttpActiveHealthCheckSession::HttpActiveHealthCheckSession(
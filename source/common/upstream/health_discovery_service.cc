@@ -56,6 +56,9 @@ void HdsDelegate::establishNewStream() {
     return;
   }
 
+  // The management server knows nothing of the health reported on a previous stream.
+  reported_health_.clear();
+
   ENVOY_LOG(debug, "Sending HealthCheckRequest {} ", health_check_request_.DebugString());
   stream_->sendMessage(health_check_request_, false);
   stats_.responses_.inc();
@@ -74,24 +77,18 @@ HdsDelegate::sendResponse() {
   for (const auto& cluster : hds_clusters_) {
     for (const auto& hosts : cluster->prioritySet().hostSetsPerPriority()) {
       for (const auto& host : hosts->hosts()) {
+        const envoy::api::v2::core::HealthStatus health_status = healthStatus(*host);
+        auto reported = reported_health_.emplace(host, health_status);
+        if (!reported.second) {
+          if (report_changes_only_ && reported.first->second == health_status) {
+            continue;
+          }
+          reported.first->second = health_status;
+        }
         auto* endpoint = response.mutable_endpoint_health_response()->add_endpoints_health();
         Network::Utility::addressToProtobufAddress(
             *host->address(), *endpoint->mutable_endpoint()->mutable_address());
-        // TODO(lilika): Add support for more granular options of envoy::api::v2::core::HealthStatus
-        if (host->healthy()) {
-          endpoint->set_health_status(envoy::api::v2::core::HealthStatus::HEALTHY);
-        } else {
-          if (host->getActiveHealthFailureType() == Host::ActiveHealthFailureType::TIMEOUT) {
-            endpoint->set_health_status(envoy::api::v2::core::HealthStatus::TIMEOUT);
-          } else if (host->getActiveHealthFailureType() ==
-                     Host::ActiveHealthFailureType::UNHEALTHY) {
-            endpoint->set_health_status(envoy::api::v2::core::HealthStatus::UNHEALTHY);
-          } else if (host->getActiveHealthFailureType() == Host::ActiveHealthFailureType::UNKNOWN) {
-            endpoint->set_health_status(envoy::api::v2::core::HealthStatus::UNHEALTHY);
-          } else {
-            NOT_REACHED_GCOVR_EXCL_LINE;
-          }
-        }
+        endpoint->set_health_status(health_status);
       }
     }
   }
@@ -102,6 +99,21 @@ HdsDelegate::sendResponse() {
   return response;
 }
 
+envoy::api::v2::core::HealthStatus HdsDelegate::healthStatus(const Host& host) {
+  // TODO(lilika): Add support for more granular options of envoy::api::v2::core::HealthStatus
+  if (host.healthy()) {
+    return envoy::api::v2::core::HealthStatus::HEALTHY;
+  }
+  switch (host.getActiveHealthFailureType()) {
+  case Host::ActiveHealthFailureType::TIMEOUT:
+    return envoy::api::v2::core::HealthStatus::TIMEOUT;
+  case Host::ActiveHealthFailureType::UNHEALTHY:
+  case Host::ActiveHealthFailureType::UNKNOWN:
+    return envoy::api::v2::core::HealthStatus::UNHEALTHY;
+  }
+  NOT_REACHED_GCOVR_EXCL_LINE;
+}
+
 void HdsDelegate::onCreateInitialMetadata(Http::HeaderMap& metadata) {
   UNREFERENCED_PARAMETER(metadata);
 }
@@ -114,6 +126,15 @@ void HdsDelegate::processMessage(
     std::unique_ptr<envoy::service::discovery::v2::HealthCheckSpecifier>&& message) {
   ENVOY_LOG(debug, "New health check response message {} ", message->DebugString());
   ASSERT(message);
+  report_changes_only_ = message->report_changes_only();
+
+  // Clusters whose config is unchanged keep their hosts and health checkers, so that a specifier
+  // which only touches some clusters neither restarts nor re-reports the others.
+  std::unordered_map<std::string, HdsClusterPtr> existing_clusters;
+  for (auto& cluster : hds_clusters_) {
+    existing_clusters.emplace(cluster->config().name(), std::move(cluster));
+  }
+  hds_clusters_.clear();
 
   for (const auto& cluster_health_check : message->cluster_health_checks()) {
     // Create HdsCluster config
@@ -139,6 +160,16 @@ void HdsDelegate::processMessage(
       cluster_config.add_health_checks()->MergeFrom(health_check);
     }
 
+    auto existing_cluster = existing_clusters.find(cluster_config.name());
+    if (existing_cluster != existing_clusters.end() &&
+        Protobuf::util::MessageDifferencer::Equivalent(existing_cluster->second->config(),
+                                                       cluster_config)) {
+      ENVOY_LOG(debug, "Keeping unchanged HdsCluster {}", cluster_config.name());
+      hds_clusters_.push_back(std::move(existing_cluster->second));
+      existing_clusters.erase(existing_cluster);
+      continue;
+    }
+
     ENVOY_LOG(debug, "New HdsCluster config {} ", cluster_config.DebugString());
 
     // Create HdsCluster
@@ -148,18 +179,22 @@ void HdsDelegate::processMessage(
 
     hds_clusters_.back()->startHealthchecks(access_log_manager_, runtime_, random_, dispatcher_);
   }
+
+  // Forget the health reported for the hosts of removed or replaced clusters.
+  for (const auto& cluster : existing_clusters) {
+    for (const auto& hosts : cluster.second->prioritySet().hostSetsPerPriority()) {
+      for (const auto& host : hosts->hosts()) {
+        reported_health_.erase(host);
+      }
+    }
+  }
 }
 
-// TODO(lilika): Add support for subsequent HealthCheckSpecifier messages that
-// might modify the HdsClusters
 void HdsDelegate::onReceiveMessage(
     std::unique_ptr<envoy::service::discovery::v2::HealthCheckSpecifier>&& message) {
   stats_.requests_.inc();
   ENVOY_LOG(debug, "New health check response message {} ", message->DebugString());
 
-  // Reset
-  hds_clusters_.clear();
-
   // Process the HealthCheckSpecifier message
   processMessage(std::move(message));
 
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <unordered_map>
+
 #include "envoy/event/dispatcher.h"
 #include "envoy/server/transport_socket_config.h"
 #include "envoy/service/discovery/v2/hds.pb.h"
@@ -60,6 +62,9 @@ public:
   const Outlier::Detector* outlierDetector() const override { return outlier_detector_.get(); }
   void initialize(std::function<void()> callback) override;
 
+  // The config the cluster was created from.
+  const envoy::api::v2::Cluster& config() const { return cluster_; }
+
   // Creates and starts healthcheckers to its endpoints
   void startHealthchecks(AccessLog::AccessLogManager& access_log_manager, Runtime::Loader& runtime,
                          Runtime::RandomGenerator& random, Event::Dispatcher& dispatcher);
@@ -78,7 +83,7 @@ private:
   std::function<void()> initialization_complete_callback_;
 
   Runtime::Loader& runtime_;
-  const envoy::api::v2::Cluster& cluster_;
+  const envoy::api::v2::Cluster cluster_;
   const envoy::api::v2::core::BindConfig& bind_config_;
   Stats::Store& stats_;
   Ssl::ContextManager& ssl_context_manager_;
@@ -147,6 +152,8 @@ private:
   void establishNewStream();
   void
   processMessage(std::unique_ptr<envoy::service::discovery::v2::HealthCheckSpecifier>&& message);
+  // The health status reported for a host
+  static envoy::api::v2::core::HealthStatus healthStatus(const Host& host);
 
   HdsDelegateStats stats_;
   const Protobuf::MethodDescriptor& service_method_;
@@ -169,6 +176,11 @@ private:
   std::vector<std::string> clusters_;
   std::vector<HdsClusterPtr> hds_clusters_;
 
+  // Whether responses only list the endpoints whose health changed since the previous response
+  bool report_changes_only_{};
+  // The health last reported on the stream for each host of hds_clusters_
+  std::unordered_map<HostSharedPtr, envoy::api::v2::core::HealthStatus> reported_health_;
+
   Event::TimerPtr hds_stream_response_timer_;
   Event::TimerPtr hds_retry_timer_;
   BackOffStrategyPtr backoff_strategy_;
@@ -0,0 +1,122 @@
+#include "common/upstream/host_stats_impl.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Upstream {
+
+namespace {
+
+// The names of all the host stats, shared by every host.
+const std::vector<std::string>& hostStatNames() {
+#define HOST_STAT_NAME(X) #X,
+  static const std::vector<std::string>* names =
+      new std::vector<std::string>{ALL_HOST_STATS(HOST_STAT_NAME, HOST_STAT_NAME)};
+#undef HOST_STAT_NAME
+  return *names;
+}
+
+const std::string* internHostStatName(const std::string& name) {
+  for (const std::string& host_stat_name : hostStatNames()) {
+    if (host_stat_name == name) {
+      return &host_stat_name;
+    }
+  }
+  NOT_REACHED_GCOVR_EXCL_LINE;
+}
+
+} // namespace
+
+Stats::Counter& HostStatsStore::counter(const std::string& name) {
+  RELEASE_ASSERT(num_counters_ < NumCounters, "");
+  HostCounter& counter = counters_[num_counters_++];
+  counter.name_ = internHostStatName(name);
+  if (locality_load_stats_ != nullptr) {
+    if (name == "rq_success") {
+      counter.locality_load_stats_ = locality_load_stats_.get();
+      counter.locality_load_add_ = &LocalityLoadStats::addSuccess;
+    } else if (name == "rq_error") {
+      counter.locality_load_stats_ = locality_load_stats_.get();
+      counter.locality_load_add_ = &LocalityLoadStats::addError;
+    }
+  }
+  return counter;
+}
+
+Stats::Gauge& HostStatsStore::gauge(const std::string& name) {
+  RELEASE_ASSERT(num_gauges_ < NumGauges, "");
+  HostGauge& gauge = gauges_[num_gauges_++];
+  gauge.name_ = internHostStatName(name);
+  if (name == "rq_active") {
+    gauge.locality_load_stats_ = locality_load_stats_.get();
+  }
+  return gauge;
+}
+
+std::vector<Stats::CounterSharedPtr> HostStatsStore::counters() {
+  // The counters share the ownership of the store.
+  std::shared_ptr<HostStatsStore> self = shared_from_this();
+  std::vector<Stats::CounterSharedPtr> counters;
+  counters.reserve(num_counters_);
+  for (size_t i = 0; i < num_counters_; ++i) {
+    counters.emplace_back(self, &counters_[i]);
+  }
+  return counters;
+}
+
+std::vector<Stats::GaugeSharedPtr> HostStatsStore::gauges() {
+  std::shared_ptr<HostStatsStore> self = shared_from_this();
+  std::vector<Stats::GaugeSharedPtr> gauges;
+  gauges.reserve(num_gauges_);
+  for (size_t i = 0; i < num_gauges_; ++i) {
+    gauges.emplace_back(self, &gauges_[i]);
+  }
+  return gauges;
+}
+
+const std::vector<Stats::Tag>& HostStatsStore::HostMetric::tags() const {
+  static const std::vector<Stats::Tag>* tags = new std::vector<Stats::Tag>();
+  return *tags;
+}
+
+void HostStatsStore::HostCounter::add(uint64_t amount) {
+  value_ += amount;
+  pending_increment_ += amount;
+  flags_ |= Flags::Used | Flags::Changed;
+  if (locality_load_stats_ != nullptr) {
+    (locality_load_stats_->*locality_load_add_)(amount);
+  }
+}
+
+void HostStatsStore::HostGauge::add(uint64_t amount) {
+  value_ += amount;
+  flags_ |= Flags::Used | Flags::Changed;
+  if (locality_load_stats_ != nullptr) {
+    locality_load_stats_->addActive(amount);
+  }
+}
+
+void HostStatsStore::HostGauge::set(uint64_t value) {
+  const uint64_t old_value = value_.exchange(value);
+  flags_ |= Flags::Used | Flags::Changed;
+  if (locality_load_stats_ != nullptr) {
+    locality_load_stats_->addActive(static_cast<int64_t>(value - old_value));
+  }
+}
+
+void HostStatsStore::HostGauge::sub(uint64_t amount) {
+  ASSERT(value_ >= amount);
+  ASSERT(used());
+  value_ -= amount;
+  flags_ |= Flags::Changed;
+  if (locality_load_stats_ != nullptr) {
+    locality_load_stats_->addActive(-static_cast<int64_t>(amount));
+  }
+}
+
+} // namespace Upstream
+} // namespace Envoy
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/stats/stats.h"
+#include "envoy/upstream/host_description.h"
+#include "envoy/upstream/upstream.h"
+
+namespace Envoy {
+namespace Upstream {
+
+/**
+ * The stats of a host, for use with POOL_COUNTER() and POOL_GAUGE(). Hosts are numerous and all
+ * have the same fixed set of stats, so instead of a stats store of their own, their stats are held
+ * inline in a single allocation and named after process wide strings. The request counts used for
+ * load reporting are also added to the load stats of the host's locality.
+ */
+class HostStatsStore : public std::enable_shared_from_this<HostStatsStore> {
+public:
+  HostStatsStore(LocalityLoadStatsSharedPtr locality_load_stats)
+      : locality_load_stats_(locality_load_stats) {}
+
+  /**
+   * @return the next counter of the store, which must be one of the ALL_HOST_STATS() counters.
+   */
+  Stats::Counter& counter(const std::string& name);
+
+  /**
+   * @return the next gauge of the store, which must be one of the ALL_HOST_STATS() gauges.
+   */
+  Stats::Gauge& gauge(const std::string& name);
+
+  std::vector<Stats::CounterSharedPtr> counters();
+  std::vector<Stats::GaugeSharedPtr> gauges();
+
+private:
+  struct Flags {
+    static const uint8_t Used = 0x1;
+    static const uint8_t Changed = 0x2;
+  };
+
+  class HostMetric : public virtual Stats::Metric {
+  public:
+    // Stats::Metric
+    const std::string name() const override { return *name_; }
+    const std::vector<Stats::Tag>& tags() const override;
+    const std::string& tagExtractedName() const override { return *name_; }
+    bool used() const override { return flags_ & Flags::Used; }
+
+    const std::string* name_{};
+    std::atomic<uint16_t> flags_{0};
+    std::atomic<uint64_t> value_{0};
+  };
+
+  class HostCounter : public Stats::Counter, public HostMetric {
+  public:
+    typedef void (LocalityLoadStats::*AddFn)(uint64_t);
+
+    // Stats::Counter
+    void add(uint64_t amount) override;
+    void inc() override { add(1); }
+    uint64_t latch() override { return pending_increment_.exchange(0); }
+    void reset() override { value_ = 0; }
+    uint64_t value() const override { return value_; }
+    bool latchChanged() override {
+      return flags_.fetch_and(static_cast<uint16_t>(~Flags::Changed)) & Flags::Changed;
+    }
+
+    std::atomic<uint64_t> pending_increment_{0};
+    LocalityLoadStats* locality_load_stats_{};
+    AddFn locality_load_add_{};
+  };
+
+  class HostGauge : public Stats::Gauge, public HostMetric {
+  public:
+    // Stats::Gauge
+    void add(uint64_t amount) override;
+    void dec() override { sub(1); }
+    void inc() override { add(1); }
+    void set(uint64_t value) override;
+    void sub(uint64_t amount) override;
+    uint64_t value() const override { return value_; }
+    bool latchChanged() override {
+      return flags_.fetch_and(static_cast<uint16_t>(~Flags::Changed)) & Flags::Changed;
+    }
+
+    // Set if the gauge counts the active requests of the host.
+    LocalityLoadStats* locality_load_stats_{};
+  };
+
+#define HOST_STATS_COUNT(X) +1
+#define HOST_STATS_IGNORE(X)
+  static const size_t NumCounters = 0 ALL_HOST_STATS(HOST_STATS_COUNT, HOST_STATS_IGNORE);
+  static const size_t NumGauges = 0 ALL_HOST_STATS(HOST_STATS_IGNORE, HOST_STATS_COUNT);
+#undef HOST_STATS_COUNT
+#undef HOST_STATS_IGNORE
+
+  const LocalityLoadStatsSharedPtr locality_load_stats_;
+  HostCounter counters_[NumCounters];
+  HostGauge gauges_[NumGauges];
+  size_t num_counters_{};
+  size_t num_gauges_{};
+};
+
+typedef std::shared_ptr<HostStatsStore> HostStatsStoreSharedPtr;
+
+} // namespace Upstream
+} // namespace Envoy
@@ -0,0 +1,45 @@
+#include "common/upstream/latency_estimator_impl.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "common/protobuf/utility.h"
+
+namespace Envoy {
+namespace Upstream {
+
+PeakEwmaLatencyEstimator::PeakEwmaLatencyEstimator(
+    const absl::optional<envoy::api::v2::Cluster::PeakEwmaLbConfig>& config)
+    : decay_time_ns_(1000000.0 *
+                     (config ? PROTOBUF_GET_MS_OR_DEFAULT(config.value(), decay_time,
+                                                          DefaultDecayTimeMs)
+                             : DefaultDecayTimeMs)) {}
+
+double PeakEwmaLatencyEstimator::decay(MonotonicTime now) const {
+  const int64_t elapsed_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count() -
+      last_update_ns_.load(std::memory_order_relaxed);
+  return std::exp(-std::max<int64_t>(elapsed_ns, 0) / decay_time_ns_);
+}
+
+void PeakEwmaLatencyEstimator::putResponseTime(std::chrono::microseconds response_time,
+                                               MonotonicTime now) {
+  const double sample = response_time.count();
+  const double average = average_.load(std::memory_order_relaxed);
+  if (sample > average) {
+    average_.store(sample, std::memory_order_relaxed);
+  } else {
+    const double weight = decay(now);
+    average_.store(average * weight + sample * (1 - weight), std::memory_order_relaxed);
+  }
+  last_update_ns_.store(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count(),
+      std::memory_order_relaxed);
+}
+
+double PeakEwmaLatencyEstimator::estimate(MonotonicTime now) const {
+  return average_.load(std::memory_order_relaxed) * decay(now);
+}
+
+} // namespace Upstream
+} // namespace Envoy
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "envoy/api/v2/cds.pb.h"
+#include "envoy/upstream/host_description.h"
+
+#include "absl/types/optional.h"
+
+namespace Envoy {
+namespace Upstream {
+
+/**
+ * Peak exponentially weighted moving average of response times, as used by Finagle's and
+ * Linkerd's peak EWMA load balancers. A response time above the average replaces it, so that the
+ * estimate reacts immediately to latency spikes, while lower response times are averaged in with
+ * a weight that grows with the time elapsed since the last one. The estimate also decays towards 0
+ * while no response is received, so that hosts that were slow are eventually tried again.
+ *
+ * The state is made of two relaxed atomics, so that it can be updated from all workers without
+ * locking. Concurrent updates may overwrite each other, which only loses a sample.
+ */
+class PeakEwmaLatencyEstimator : public LatencyEstimator {
+public:
+  PeakEwmaLatencyEstimator(const absl::optional<envoy::api::v2::Cluster::PeakEwmaLbConfig>& config);
+
+  // Upstream::LatencyEstimator
+  void putResponseTime(std::chrono::microseconds response_time, MonotonicTime now) override;
+  double estimate(MonotonicTime now) const override;
+
+  // Decay time used when the cluster does not configure one, as in Finagle.
+  static const uint64_t DefaultDecayTimeMs = 10000;
+
+private:
+  /**
+   * @return double the weight of the current average after the time elapsed since the last update.
+   */
+  double decay(MonotonicTime now) const;
+
+  const double decay_time_ns_;
+  // Average in microseconds.
+  std::atomic<double> average_{0};
+  // Time of the last update, in nanoseconds since the steady clock epoch.
+  std::atomic<int64_t> last_update_ns_{0};
+};
+
+} // namespace Upstream
+} // namespace Envoy
@@ -17,6 +17,8 @@ namespace {
 static const std::string RuntimeZoneEnabled = "upstream.zone_routing.enabled";
 static const std::string RuntimeMinClusterSize = "upstream.zone_routing.min_cluster_size";
 static const std::string RuntimePanicThreshold = "upstream.healthy_panic_threshold";
+// Cost of a busy host with no latency estimate, above any cost computed from an estimate.
+static const double NoEstimatePenalty = 1e12;
 } // namespace
 
 uint32_t LoadBalancerBase::choosePriority(uint64_t hash,
@@ -109,16 +111,30 @@ HostSet& LoadBalancerBase::chooseHostSet(LoadBalancerContext* context) {
   return *priority_set_.hostSetsPerPriority()[priority];
 }
 
+LocalityRoutingTableConstSharedPtr LocalityRoutingTableCache::get(
+    const HostsPerLocalityConstSharedPtr& upstream, const HostsPerLocalityConstSharedPtr& local,
+    const std::function<LocalityRoutingTableConstSharedPtr()>& compute) {
+  Thread::LockGuard lock(lock_);
+  if (table_ == nullptr || upstream_ != upstream || local_ != local) {
+    upstream_ = upstream;
+    local_ = local;
+    table_ = compute();
+  }
+  return table_;
+}
+
 ZoneAwareLoadBalancerBase::ZoneAwareLoadBalancerBase(
     const PrioritySet& priority_set, const PrioritySet* local_priority_set, ClusterStats& stats,
     Runtime::Loader& runtime, Runtime::RandomGenerator& random,
-    const envoy::api::v2::Cluster::CommonLbConfig& common_config)
+    const envoy::api::v2::Cluster::CommonLbConfig& common_config,
+    const LocalityRoutingTableCacheSharedPtr& locality_routing_table_cache)
     : LoadBalancerBase(priority_set, stats, runtime, random, common_config),
       local_priority_set_(local_priority_set),
       routing_enabled_(PROTOBUF_PERCENT_TO_ROUNDED_INTEGER_OR_DEFAULT(
           common_config.zone_aware_lb_config(), routing_enabled, 100, 100)),
       min_cluster_size_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(common_config.zone_aware_lb_config(),
-                                                        min_cluster_size, 6U)) {
+                                                        min_cluster_size, 6U)),
+      locality_routing_table_cache_(locality_routing_table_cache) {
   ASSERT(!priority_set.hostSetsPerPriority().empty());
   resizePerPriorityState();
   priority_set_.addMemberUpdateCb(
@@ -166,12 +182,35 @@ void ZoneAwareLoadBalancerBase::regenerateLocalityRoutingStructures() {
   // params.
   if (earlyExitNonLocalityRouting()) {
     state.locality_routing_state_ = LocalityRoutingState::NoLocalityRouting;
+    state.locality_routing_table_.reset();
     return;
   }
   HostSet& host_set = *priority_set_.hostSetsPerPriority()[priority];
   ASSERT(host_set.healthyHostsPerLocality().hasLocalLocality());
-  const size_t num_localities = host_set.healthyHostsPerLocality().get().size();
+
+  // The table only depends on the healthy hosts per locality, which the workers share, so it is
+  // only computed by the first worker to apply an update.
+  if (locality_routing_table_cache_ != nullptr) {
+    const HostsPerLocalityConstSharedPtr upstream = host_set.healthyHostsPerLocalityPtr();
+    const HostsPerLocalityConstSharedPtr local = localHostSet().healthyHostsPerLocalityPtr();
+    state.locality_routing_table_ =
+        locality_routing_table_cache_->get(upstream, local, [&upstream, &local]() {
+          return calculateLocalityRoutingTable(*upstream, *local);
+        });
+  } else {
+    state.locality_routing_table_ = calculateLocalityRoutingTable(
+        host_set.healthyHostsPerLocality(), localHostSet().healthyHostsPerLocality());
+  }
+  state.locality_routing_state_ = state.locality_routing_table_->state_;
+}
+
+LocalityRoutingTableConstSharedPtr
+ZoneAwareLoadBalancerBase::calculateLocalityRoutingTable(const HostsPerLocality& upstream,
+                                                         const HostsPerLocality& local) {
+  const size_t num_localities = upstream.get().size();
   ASSERT(num_localities > 0);
+  ASSERT(local.get().size() == num_localities);
+  auto table = std::make_shared<LocalityRoutingTable>();
 
   // It is worth noting that all of the percentages calculated are orthogonal from
   // how much load this priority level receives, percentageLoad(priority).
@@ -183,23 +222,23 @@ void ZoneAwareLoadBalancerBase::regenerateLocalityRoutingStructures() {
   // Basically, fariness across localities within a priority is guaranteed. Fairness across
   // localities across priorities is not.
   uint64_t local_percentage[num_localities];
-  calculateLocalityPercentage(localHostSet().healthyHostsPerLocality(), local_percentage);
+  calculateLocalityPercentage(local, local_percentage);
   uint64_t upstream_percentage[num_localities];
-  calculateLocalityPercentage(host_set.healthyHostsPerLocality(), upstream_percentage);
+  calculateLocalityPercentage(upstream, upstream_percentage);
 
   // If we have lower percent of hosts in the local cluster in the same locality,
   // we can push all of the requests directly to upstream cluster in the same locality.
   if (upstream_percentage[0] >= local_percentage[0]) {
-    state.locality_routing_state_ = LocalityRoutingState::LocalityDirect;
-    return;
+    table->state_ = LocalityRoutingState::LocalityDirect;
+    return table;
   }
 
-  state.locality_routing_state_ = LocalityRoutingState::LocalityResidual;
+  table->state_ = LocalityRoutingState::LocalityResidual;
 
   // If we cannot route all requests to the same locality, calculate what percentage can be routed.
   // For example, if local percentage is 20% and upstream is 10%
   // we can route only 50% of requests directly.
-  state.local_percent_to_route_ = upstream_percentage[0] * 10000 / local_percentage[0];
+  table->local_percent_to_route_ = upstream_percentage[0] * 10000 / local_percentage[0];
 
   // Local locality does not have additional capacity (we have already routed what we could).
   // Now we need to figure out how much traffic we can route cross locality and to which exact
@@ -217,21 +256,23 @@ void ZoneAwareLoadBalancerBase::regenerateLocalityRoutingStructures() {
   // residual_capacity: 0 10000 15000
   // Now to find a locality to route (bucket) we could simply iterate over residual_capacity
   // searching where sampled value is placed.
-  state.residual_capacity_.resize(num_localities);
+  std::vector<uint64_t>& residual_capacity = table->residual_capacity_;
+  residual_capacity.resize(num_localities);
 
   // Local locality (index 0) does not have residual capacity as we have routed all we could.
-  state.residual_capacity_[0] = 0;
+  residual_capacity[0] = 0;
   for (size_t i = 1; i < num_localities; ++i) {
     // Only route to the localities that have additional capacity.
     if (upstream_percentage[i] > local_percentage[i]) {
-      state.residual_capacity_[i] =
-          state.residual_capacity_[i - 1] + upstream_percentage[i] - local_percentage[i];
+      residual_capacity[i] =
+          residual_capacity[i - 1] + upstream_percentage[i] - local_percentage[i];
     } else {
       // Locality with index "i" does not have residual capacity, but we keep accumulating previous
       // values to make search easier on the next step.
-      state.residual_capacity_[i] = state.residual_capacity_[i - 1];
+      residual_capacity[i] = residual_capacity[i - 1];
     }
   }
+  return table;
 }
 
 void ZoneAwareLoadBalancerBase::resizePerPriorityState() {
@@ -324,6 +365,7 @@ void ZoneAwareLoadBalancerBase::calculateLocalityPercentage(
 uint32_t ZoneAwareLoadBalancerBase::tryChooseLocalLocalityHosts(const HostSet& host_set) {
   PerPriorityState& state = *per_priority_state_[host_set.priority()];
   ASSERT(state.locality_routing_state_ != LocalityRoutingState::NoLocalityRouting);
+  const LocalityRoutingTable& table = *state.locality_routing_table_;
 
   // At this point it's guaranteed to be at least 2 localities & local exists.
   const size_t number_of_localities = host_set.healthyHostsPerLocality().get().size();
@@ -340,7 +382,7 @@ uint32_t ZoneAwareLoadBalancerBase::tryChooseLocalLocalityHosts(const HostSet& h
 
   // If we cannot route all requests to the same locality, we already calculated how much we can
   // push to the local locality, check if we can push to local locality on current iteration.
-  if (random_.random() % 10000 < state.local_percent_to_route_) {
+  if (random_.random() % 10000 < table.local_percent_to_route_) {
     stats_.lb_zone_routing_sampled_.inc();
     return 0;
   }
@@ -350,21 +392,21 @@ uint32_t ZoneAwareLoadBalancerBase::tryChooseLocalLocalityHosts(const HostSet& h
 
   // This is *extremely* unlikely but possible due to rounding errors when calculating
   // locality percentages. In this case just select random locality.
-  if (state.residual_capacity_[number_of_localities - 1] == 0) {
+  if (table.residual_capacity_[number_of_localities - 1] == 0) {
     stats_.lb_zone_no_capacity_left_.inc();
     return random_.random() % number_of_localities;
   }
 
   // Random sampling to select specific locality for cross locality traffic based on the additional
   // capacity in localities.
-  uint64_t threshold = random_.random() % state.residual_capacity_[number_of_localities - 1];
+  uint64_t threshold = random_.random() % table.residual_capacity_[number_of_localities - 1];
 
   // This potentially can be optimized to be O(log(N)) where N is the number of localities.
   // Linear scan should be faster for smaller N, in most of the scenarios N will be small.
   // TODO(htuch): is there a bug here when threshold == 0? Seems like we pick
   // local locality in that situation. Probably should start iterating at 1.
   int i = 0;
-  while (threshold > state.residual_capacity_[i]) {
+  while (threshold > table.residual_capacity_[i]) {
     i++;
   }
 
@@ -436,15 +478,17 @@ const HostVector& ZoneAwareLoadBalancerBase::hostSourceToHosts(HostsSource hosts
 EdfLoadBalancerBase::EdfLoadBalancerBase(
     const PrioritySet& priority_set, const PrioritySet* local_priority_set, ClusterStats& stats,
     Runtime::Loader& runtime, Runtime::RandomGenerator& random,
-    const envoy::api::v2::Cluster::CommonLbConfig& common_config)
+    const envoy::api::v2::Cluster::CommonLbConfig& common_config,
+    const LocalityRoutingTableCacheSharedPtr& locality_routing_table_cache)
     : ZoneAwareLoadBalancerBase(priority_set, local_priority_set, stats, runtime, random,
-                                common_config),
+                                common_config, locality_routing_table_cache),
       seed_(random_.random()) {
-  // We fully recompute the schedulers for a given host set here on membership change, which is
-  // consistent with what other LB implementations do (e.g. thread aware).
-  // The downside of a full recompute is that time complexity is O(n * log n),
-  // so we will need to do better at delta tracking to scale (see
-  // https://github.com/envoyproxy/envoy/issues/2874).
+  // Only the hosts that joined or left a host source, or whose weight changed, are updated in its
+  // schedule on membership change, in O(log n) time each, rather than recomputing the schedule in
+  // O(n * log n) time, which also keeps the position of the other hosts in the schedule. Finding
+  // these hosts is still O(n), as host sets only report the hosts added to or removed from the
+  // whole priority, and not the changes to the healthy hosts
+  // (see https://github.com/envoyproxy/envoy/issues/2874).
   priority_set.addMemberUpdateCb(
       [this](uint32_t priority, const HostVector&, const HostVector&) { refresh(priority); });
 }
@@ -456,46 +500,84 @@ void EdfLoadBalancerBase::initialize() {
 }
 
 void EdfLoadBalancerBase::refresh(uint32_t priority) {
-  const auto add_hosts_source = [this](HostsSource source, const HostVector& hosts) {
-    // Nuke existing scheduler if it exists.
-    auto& scheduler = scheduler_[source] = Scheduler{};
+  const auto refresh_hosts_source = [this](HostsSource source, const HostVector& hosts) {
     refreshHostSource(source);
+    auto scheduler_it = scheduler_.find(source);
+    const bool new_source = scheduler_it == scheduler_.end();
+    Scheduler& scheduler = new_source ? scheduler_[source] : scheduler_it->second;
 
-    // Populate scheduler with host list.
+    // Populate scheduler with the hosts that are not scheduled yet.
     // TODO(mattklein123): We must build the EDF schedule even if all of the hosts are currently
     // weighted 1. This is because currently we don't refresh host sets if only weights change.
     // We should probably change this to refresh at all times. See the comment in
     // BaseDynamicClusterImpl::updateDynamicHostList about this.
+    const uint64_t generation = ++scheduler.generation_;
     for (const auto& host : hosts) {
-      // We use a fixed weight here. While the weight may change without
-      // notification, this will only be stale until this host is next picked,
-      // at which point it is reinserted into the EdfScheduler with its new
-      // weight in chooseHost().
-      scheduler.edf_.add(hostWeight(*host), host);
+      auto index_it = scheduler.entry_indexes_.find(host.get());
+      if (index_it == scheduler.entry_indexes_.end()) {
+        uint32_t index;
+        if (scheduler.free_entries_.empty()) {
+          index = scheduler.entries_.size();
+          scheduler.entries_.emplace_back();
+        } else {
+          index = scheduler.free_entries_.back();
+          scheduler.free_entries_.pop_back();
+        }
+        scheduler.entries_[index].host_ = host;
+        index_it = scheduler.entry_indexes_.emplace(host.get(), index).first;
+      }
+      // The weight of a host may also change without notification, in which case it is only
+      // stale until the host is next picked, at which point it is updated in chooseHost().
+      scheduler.edf_.set(index_it->second, hostWeight(*host));
+      scheduler.entries_[index_it->second].generation_ = generation;
+    }
+
+    // Drop the hosts that left the source from the schedule.
+    for (auto it = scheduler.entry_indexes_.begin(); it != scheduler.entry_indexes_.end();) {
+      HostEntry& entry = scheduler.entries_[it->second];
+      if (entry.generation_ != generation) {
+        scheduler.edf_.remove(it->second);
+        entry.host_ = nullptr;
+        scheduler.free_entries_.push_back(it->second);
+        it = scheduler.entry_indexes_.erase(it);
+      } else {
+        ++it;
+      }
     }
 
     // Cycle through hosts to achieve the intended offset behavior.
     // TODO(htuch): Consider how we can avoid biasing towards earlier hosts in the schedule across
     // refreshes for the weighted case.
-    if (!hosts.empty()) {
+    if (new_source && !hosts.empty()) {
       for (uint32_t i = 0; i < seed_ % hosts.size(); ++i) {
-        auto host = scheduler.edf_.pick();
-        scheduler.edf_.add(hostWeight(*host), host);
+        scheduler.edf_.pick();
       }
     }
   };
 
   // Populate EdfSchedulers for each valid HostsSource value for the host set at this priority.
   const auto& host_set = priority_set_.hostSetsPerPriority()[priority];
-  add_hosts_source(HostsSource(priority, HostsSource::SourceType::AllHosts), host_set->hosts());
-  add_hosts_source(HostsSource(priority, HostsSource::SourceType::HealthyHosts),
-                   host_set->healthyHosts());
-  for (uint32_t locality_index = 0;
-       locality_index < host_set->healthyHostsPerLocality().get().size(); ++locality_index) {
-    add_hosts_source(
+  refresh_hosts_source(HostsSource(priority, HostsSource::SourceType::AllHosts), host_set->hosts());
+  refresh_hosts_source(HostsSource(priority, HostsSource::SourceType::HealthyHosts),
+                       host_set->healthyHosts());
+  const uint32_t num_localities = host_set->healthyHostsPerLocality().get().size();
+  for (uint32_t locality_index = 0; locality_index < num_localities; ++locality_index) {
+    refresh_hosts_source(
         HostsSource(priority, HostsSource::SourceType::LocalityHealthyHosts, locality_index),
         host_set->healthyHostsPerLocality().get()[locality_index]);
   }
+
+  // The schedules own their hosts, so the schedules of the localities that no longer exist are
+  // removed.
+  for (auto it = scheduler_.begin(); it != scheduler_.end();) {
+    if (it->first.priority_ == priority &&
+        it->first.source_type_ == HostsSource::SourceType::LocalityHealthyHosts &&
+        it->first.locality_index_ >= num_localities) {
+      it = scheduler_.erase(it);
+    } else {
+      ++it;
+    }
+  }
 }
 
 HostConstSharedPtr EdfLoadBalancerBase::chooseHostOnce(LoadBalancerContext* context) {
@@ -512,12 +594,14 @@ HostConstSharedPtr EdfLoadBalancerBase::chooseHostOnce(LoadBalancerContext* cont
   // TODO(mattklein123): As commented elsewhere, this is wasteful, and we should just refresh the
   // host set if any weights change. Additionally, it has the property that if all weights are
   // the same but not 1 (like 42), we will use the EDF schedule not the unweighted pick. This is
-  // not optimal. If this is fixed, remove the note in the arch overview docs for the LR LB.
+  // not optimal.
   if (stats_.max_host_weight_.value() != 1) {
-    auto host = scheduler.edf_.pick();
-    if (host != nullptr) {
-      scheduler.edf_.add(hostWeight(*host), host);
+    const absl::optional<uint32_t> index = scheduler.edf_.pick();
+    if (!index.has_value()) {
+      return nullptr;
     }
+    const HostConstSharedPtr& host = scheduler.entries_[index.value()].host_;
+    scheduler.edf_.set(index.value(), hostWeight(*host));
     return host;
   } else {
     const HostVector& hosts_to_use = hostSourceToHosts(hosts_source);
@@ -528,16 +612,59 @@ HostConstSharedPtr EdfLoadBalancerBase::chooseHostOnce(LoadBalancerContext* cont
   }
 }
 
-HostConstSharedPtr LeastRequestLoadBalancer::unweightedHostPick(const HostVector& hosts_to_use,
-                                                                const HostsSource&) {
-  // This is just basic unweighted P2C.
-  const HostSharedPtr host1 = hosts_to_use[random_.random() % hosts_to_use.size()];
-  const HostSharedPtr host2 = hosts_to_use[random_.random() % hosts_to_use.size()];
-  if (host1->stats().rq_active_.value() < host2->stats().rq_active_.value()) {
-    return host1;
-  } else {
-    return host2;
+LeastRequestLoadBalancer::LeastRequestLoadBalancer(
+    const PrioritySet& priority_set, const PrioritySet* local_priority_set, ClusterStats& stats,
+    Runtime::Loader& runtime, Runtime::RandomGenerator& random,
+    const envoy::api::v2::Cluster::CommonLbConfig& common_config,
+    const absl::optional<envoy::api::v2::Cluster::LeastRequestLbConfig>& least_request_config,
+    const LocalityRoutingTableCacheSharedPtr& locality_routing_table_cache)
+    : ZoneAwareLoadBalancerBase(priority_set, local_priority_set, stats, runtime, random,
+                                common_config, locality_routing_table_cache),
+      choice_count_(least_request_config
+                        ? PROTOBUF_GET_WRAPPED_OR_DEFAULT(least_request_config.value(),
+                                                          choice_count, DefaultChoiceCount)
+                        : DefaultChoiceCount) {}
+
+HostConstSharedPtr LeastRequestLoadBalancer::chooseHostOnce(LoadBalancerContext* context) {
+  const HostVector& hosts_to_use = hostSourceToHosts(hostSourceToUse(context));
+  if (hosts_to_use.empty()) {
+    return nullptr;
+  }
+
+  // The loads (active + 1) / weight of two hosts are compared by cross multiplying them, which is
+  // exact. On a tie the host picked last is kept.
+  const HostSharedPtr* candidate = &hosts_to_use[random_.random() % hosts_to_use.size()];
+  uint64_t candidate_active = (*candidate)->stats().rq_active_.value() + 1;
+  for (uint32_t i = 1; i < choice_count_; ++i) {
+    const HostSharedPtr& host = hosts_to_use[random_.random() % hosts_to_use.size()];
+    const uint64_t active = host->stats().rq_active_.value() + 1;
+    if (active * (*candidate)->weight() <= candidate_active * host->weight()) {
+      candidate = &host;
+      candidate_active = active;
+    }
+  }
+  return *candidate;
+}
+
+HostConstSharedPtr PeakEwmaLoadBalancer::chooseHostOnce(LoadBalancerContext* context) {
+  const HostVector& hosts_to_use = hostSourceToHosts(hostSourceToUse(context));
+  if (hosts_to_use.empty()) {
+    return nullptr;
+  }
+
+  const MonotonicTime now = time_source_.monotonicTime();
+  const HostSharedPtr& host1 = hosts_to_use[random_.random() % hosts_to_use.size()];
+  const HostSharedPtr& host2 = hosts_to_use[random_.random() % hosts_to_use.size()];
+  return cost(*host1, now) < cost(*host2, now) ? host1 : host2;
+}
+
+double PeakEwmaLoadBalancer::cost(const Host& host, MonotonicTime now) const {
+  const uint64_t active = host.stats().rq_active_.value();
+  const double estimate = host.latencyEstimator().estimate(now);
+  if (estimate == 0) {
+    return active == 0 ? 0 : NoEstimatePenalty + active;
   }
+  return estimate * (active + 1);
 }
 
 HostConstSharedPtr RandomLoadBalancer::chooseHostOnce(LoadBalancerContext* context) {
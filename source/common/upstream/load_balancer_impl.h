@@ -1,15 +1,20 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
+#include <memory>
 #include <queue>
 #include <set>
 #include <vector>
 
 #include "envoy/api/v2/cds.pb.h"
+#include "envoy/common/time.h"
 #include "envoy/runtime/runtime.h"
 #include "envoy/upstream/load_balancer.h"
 #include "envoy/upstream/upstream.h"
 
+#include "common/common/lock_guard.h"
+#include "common/common/thread.h"
 #include "common/upstream/edf_scheduler.h"
 
 namespace Envoy {
@@ -101,16 +106,72 @@ public:
   uint32_t hostSelectionRetryCount() const override { return 0; }
 };
 
+enum class LocalityRoutingState {
+  // Locality based routing is off.
+  NoLocalityRouting,
+  // All queries can be routed to the local locality.
+  LocalityDirect,
+  // The local locality can not handle the anticipated load. Residual load will be spread across
+  // various other localities.
+  LocalityResidual
+};
+
+/**
+ * How requests to P=0 of a cluster are spread over its localities by zone aware routing. It only
+ * depends on the healthy hosts per locality of the cluster and of the local cluster.
+ */
+struct LocalityRoutingTable {
+  // LocalityDirect or LocalityResidual.
+  LocalityRoutingState state_{LocalityRoutingState::LocalityDirect};
+  // The percent of requests which can be routed to the local locality.
+  uint64_t local_percent_to_route_{};
+  // When state_ == LocalityResidual this tracks the capacity for each of the non-local localities
+  // to determine what traffic should be routed where.
+  std::vector<uint64_t> residual_capacity_;
+};
+
+typedef std::shared_ptr<const LocalityRoutingTable> LocalityRoutingTableConstSharedPtr;
+
+/**
+ * Shares the LocalityRoutingTable of a cluster between the load balancers of all workers, so that
+ * it is computed once per host update rather than once per worker. The workers apply the same
+ * update one after the other, so only the last table is kept.
+ */
+class LocalityRoutingTableCache {
+public:
+  /**
+   * @param upstream the healthy hosts per locality of the cluster.
+   * @param local the healthy hosts per locality of the local cluster.
+   * @param compute computes the table of upstream and local, when it is not cached.
+   * @return LocalityRoutingTableConstSharedPtr the table of upstream and local.
+   */
+  LocalityRoutingTableConstSharedPtr
+  get(const HostsPerLocalityConstSharedPtr& upstream, const HostsPerLocalityConstSharedPtr& local,
+      const std::function<LocalityRoutingTableConstSharedPtr()>& compute);
+
+private:
+  Thread::MutexBasicLockable lock_;
+  // The hosts per locality are held so that the cached table can not be mistaken for the table of
+  // new ones allocated at the same address.
+  HostsPerLocalityConstSharedPtr upstream_ GUARDED_BY(lock_);
+  HostsPerLocalityConstSharedPtr local_ GUARDED_BY(lock_);
+  LocalityRoutingTableConstSharedPtr table_ GUARDED_BY(lock_);
+};
+
+typedef std::shared_ptr<LocalityRoutingTableCache> LocalityRoutingTableCacheSharedPtr;
+
 /**
  * Base class for zone aware load balancers
  */
 class ZoneAwareLoadBalancerBase : public LoadBalancerBase {
 protected:
-  // Both priority_set and local_priority_set if non-null must have at least one host set.
-  ZoneAwareLoadBalancerBase(const PrioritySet& priority_set, const PrioritySet* local_priority_set,
-                            ClusterStats& stats, Runtime::Loader& runtime,
-                            Runtime::RandomGenerator& random,
-                            const envoy::api::v2::Cluster::CommonLbConfig& common_config);
+  // Both priority_set and local_priority_set if non-null must have at least one host set. The
+  // locality routing tables are shared through locality_routing_table_cache if non-null.
+  ZoneAwareLoadBalancerBase(
+      const PrioritySet& priority_set, const PrioritySet* local_priority_set, ClusterStats& stats,
+      Runtime::Loader& runtime, Runtime::RandomGenerator& random,
+      const envoy::api::v2::Cluster::CommonLbConfig& common_config,
+      const LocalityRoutingTableCacheSharedPtr& locality_routing_table_cache = nullptr);
   ~ZoneAwareLoadBalancerBase();
 
   // When deciding which hosts to use on an LB decision, we need to know how to index into the
@@ -175,16 +236,6 @@ protected:
   const HostVector& hostSourceToHosts(HostsSource hosts_source);
 
 private:
-  enum class LocalityRoutingState {
-    // Locality based routing is off.
-    NoLocalityRouting,
-    // All queries can be routed to the local locality.
-    LocalityDirect,
-    // The local locality can not handle the anticipated load. Residual load will be spread across
-    // various other localities.
-    LocalityResidual
-  };
-
   /**
    * Increase per_priority_state_ to at least priority_set.hostSetsPerPriority().size()
    */
@@ -207,7 +258,15 @@ private:
    * The result is stored as integer number and scaled by 10000 multiplier for better precision.
    * Caller is responsible for allocation/de-allocation of ret.
    */
-  void calculateLocalityPercentage(const HostsPerLocality& hosts_per_locality, uint64_t* ret);
+  static void calculateLocalityPercentage(const HostsPerLocality& hosts_per_locality,
+                                          uint64_t* ret);
+
+  /**
+   * Compute the locality routing table of the given healthy hosts per locality of P=0 and of the
+   * local cluster, which are known to allow locality routing.
+   */
+  static LocalityRoutingTableConstSharedPtr
+  calculateLocalityRoutingTable(const HostsPerLocality& upstream, const HostsPerLocality& local);
 
   /**
    * Regenerate locality aware routing structures for fast decisions on upstream locality selection.
@@ -222,15 +281,13 @@ private:
   const uint32_t routing_enabled_;
   const uint64_t min_cluster_size_;
 
+  const LocalityRoutingTableCacheSharedPtr locality_routing_table_cache_;
+
   struct PerPriorityState {
-    // The percent of requests which can be routed to the local locality.
-    uint64_t local_percent_to_route_{};
     // Tracks the current state of locality based routing.
     LocalityRoutingState locality_routing_state_{LocalityRoutingState::NoLocalityRouting};
-    // When locality_routing_state_ == LocalityResidual this tracks the capacity
-    // for each of the non-local localities to determine what traffic should be
-    // routed where.
-    std::vector<uint64_t> residual_capacity_;
+    // Set unless locality_routing_state_ == NoLocalityRouting.
+    LocalityRoutingTableConstSharedPtr locality_routing_table_;
   };
   typedef std::unique_ptr<PerPriorityState> PerPriorityStatePtr;
   // Routing state broken out for each priority level in priority_set_.
@@ -240,12 +297,12 @@ private:
 
 /**
  * Base implementation of LoadBalancer that performs weighted RR selection across the hosts in the
- * cluster. This scheduler respects host weighting and utilizes an EdfScheduler to achieve O(log
- * n) pick and insertion time complexity, O(n) memory use. The key insight is that if we schedule
- * with 1 / weight deadline, we will achieve the desired pick frequency for weighted RR in a given
- * interval. Naive implementations of weighted RR are either O(n) pick time or O(m * n) memory use,
- * where m is the weight range. We also explicitly check for the unweighted special case and use a
- * simple index to acheive O(1) scheduling in that case.
+ * cluster. This scheduler respects host weighting and utilizes an IndexedEdfScheduler to achieve
+ * O(log n) pick, insertion, removal and weight update time complexity, O(n) memory use. The key
+ * insight is that if we schedule with 1 / weight deadline, we will achieve the desired pick
+ * frequency for weighted RR in a given interval. Naive implementations of weighted RR are either
+ * O(n) pick time or O(m * n) memory use, where m is the weight range. We also explicitly check for
+ * the unweighted special case and use a simple index to acheive O(1) scheduling in that case.
  * TODO(htuch): We use EDF at Google, but the EDF scheduler may be overkill if we don't want to
  * support large ranges of weights or arbitrary precision floating weights, we could construct an
  * explicit schedule, since m will be a small constant factor in O(m * n). This
@@ -257,18 +314,33 @@ private:
  */
 class EdfLoadBalancerBase : public ZoneAwareLoadBalancerBase {
 public:
-  EdfLoadBalancerBase(const PrioritySet& priority_set, const PrioritySet* local_priority_set,
-                      ClusterStats& stats, Runtime::Loader& runtime,
-                      Runtime::RandomGenerator& random,
-                      const envoy::api::v2::Cluster::CommonLbConfig& common_config);
+  EdfLoadBalancerBase(
+      const PrioritySet& priority_set, const PrioritySet* local_priority_set, ClusterStats& stats,
+      Runtime::Loader& runtime, Runtime::RandomGenerator& random,
+      const envoy::api::v2::Cluster::CommonLbConfig& common_config,
+      const LocalityRoutingTableCacheSharedPtr& locality_routing_table_cache = nullptr);
 
   // Upstream::LoadBalancerBase
   HostConstSharedPtr chooseHostOnce(LoadBalancerContext* context) override;
 
 protected:
+  // A host in the schedule of a HostsSource.
+  struct HostEntry {
+    HostConstSharedPtr host_;
+    // The last refresh of the schedule in which the host was part of the source.
+    uint64_t generation_{};
+  };
+
   struct Scheduler {
-    // EdfScheduler for weighted LB.
-    EdfScheduler<const Host> edf_;
+    // EDF schedule for weighted LB, by index in entries_.
+    IndexedEdfScheduler edf_;
+    // The hosts in the source. Entries of hosts that left the source are reused by the next hosts
+    // joining it.
+    std::vector<HostEntry> entries_;
+    std::vector<uint32_t> free_entries_;
+    // The index of the entry of each host in the source.
+    std::unordered_map<const Host*, uint32_t> entry_indexes_;
+    uint64_t generation_{};
   };
 
   void initialize();
@@ -297,12 +369,13 @@ private:
  */
 class RoundRobinLoadBalancer : public EdfLoadBalancerBase {
 public:
-  RoundRobinLoadBalancer(const PrioritySet& priority_set, const PrioritySet* local_priority_set,
-                         ClusterStats& stats, Runtime::Loader& runtime,
-                         Runtime::RandomGenerator& random,
-                         const envoy::api::v2::Cluster::CommonLbConfig& common_config)
-      : EdfLoadBalancerBase(priority_set, local_priority_set, stats, runtime, random,
-                            common_config) {
+  RoundRobinLoadBalancer(
+      const PrioritySet& priority_set, const PrioritySet* local_priority_set, ClusterStats& stats,
+      Runtime::Loader& runtime, Runtime::RandomGenerator& random,
+      const envoy::api::v2::Cluster::CommonLbConfig& common_config,
+      const LocalityRoutingTableCacheSharedPtr& locality_routing_table_cache = nullptr)
+      : EdfLoadBalancerBase(priority_set, local_priority_set, stats, runtime, random, common_config,
+                            locality_routing_table_cache) {
     initialize();
   }
 
@@ -329,48 +402,62 @@ private:
 /**
  * Weighted Least Request load balancer.
  *
- * In a normal setup when all hosts have the same weight of 1 it randomly picks up two healthy hosts
- * and compares number of active requests. Technique is based on
- * http://www.eecs.harvard.edu/~michaelm/postscripts/mythesis.pdf and is known as P2C (power of
- * two choices).
+ * It randomly picks a number of healthy hosts, two by default, and selects the one with the
+ * lowest load. Technique is based on http://www.eecs.harvard.edu/~michaelm/postscripts/mythesis.pdf
+ * and is known as P2C (power of two choices).
  *
- * When any hosts have a weight that is not 1, an RR EDF schedule is used. Host weight is scaled
- * by the number of active requests at pick/insert time. Thus, hosts will never fully drain as
- * they would in normal P2C, though they will get picked less and less often. In the future, we
- * can consider two alternate algorithms:
- * 1) Expand out all hosts by weight (using more memory) and do standard P2C.
- * 2) Use a weighted Maglev table, and perform P2C on two random hosts selected from the table.
- *    The benefit of the Maglev table is at the expense of resolution, memory usage is capped.
- *    Additionally, the Maglev table can be shared amongst all threads.
+ * The load of a host is its number of active requests divided by its weight, so that weighted
+ * hosts are balanced by load as well. 1 is added to the number of active requests, which makes
+ * the weights still count among idle hosts. When all hosts have the same weight, this is the same
+ * as comparing the number of active requests.
  */
-class LeastRequestLoadBalancer : public EdfLoadBalancerBase {
+class LeastRequestLoadBalancer : public ZoneAwareLoadBalancerBase {
 public:
-  LeastRequestLoadBalancer(const PrioritySet& priority_set, const PrioritySet* local_priority_set,
-                           ClusterStats& stats, Runtime::Loader& runtime,
-                           Runtime::RandomGenerator& random,
-                           const envoy::api::v2::Cluster::CommonLbConfig& common_config)
-      : EdfLoadBalancerBase(priority_set, local_priority_set, stats, runtime, random,
-                            common_config) {
-    initialize();
-  }
+  LeastRequestLoadBalancer(
+      const PrioritySet& priority_set, const PrioritySet* local_priority_set, ClusterStats& stats,
+      Runtime::Loader& runtime, Runtime::RandomGenerator& random,
+      const envoy::api::v2::Cluster::CommonLbConfig& common_config,
+      const absl::optional<envoy::api::v2::Cluster::LeastRequestLbConfig>& least_request_config =
+          absl::nullopt,
+      const LocalityRoutingTableCacheSharedPtr& locality_routing_table_cache = nullptr);
+
+  // Upstream::LoadBalancerBase
+  HostConstSharedPtr chooseHostOnce(LoadBalancerContext* context) override;
+
+  static const uint32_t DefaultChoiceCount = 2;
 
 private:
-  void refreshHostSource(const HostsSource&) override {}
-  double hostWeight(const Host& host) override {
-    // Here we scale host weight by the number of active requests at the time we do the pick. We
-    // always add 1 to avoid division by 0. Note that if all weights are 1, the EDF schedule is
-    // unlikely to yield the same result as P2C given the lack of randomness as well as the fact
-    // that hosts are always picked, regardless of their current request load at the time of pick.
-    // It might be posible to do better by picking two hosts off of the schedule, and selecting
-    // the one with fewer active requests at the time of selection.
-    // TODO(mattklein123): @htuch brings up the point that how we are scaling weight here might not
-    // be the only/best way of doing this. Essentially, it makes weight and active requests equally
-    // important. Are they equally important in practice? There is no right answer here and we might
-    // want to iterate on this as we gain more experience.
-    return static_cast<double>(host.weight()) / (host.stats().rq_active_.value() + 1);
-  }
-  HostConstSharedPtr unweightedHostPick(const HostVector& hosts_to_use,
-                                        const HostsSource& source) override;
+  const uint32_t choice_count_;
+};
+
+/**
+ * Peak EWMA load balancer.
+ *
+ * Like the least request load balancer it randomly picks two hosts, but it selects the one with
+ * the lowest expected latency for a new request, which is the peak EWMA latency estimate of the
+ * host (see PeakEwmaLatencyEstimator) multiplied by its number of active requests plus one. This
+ * favors the hosts that have been answering quickly, and reacts immediately to a host slowing
+ * down. Hosts that have no estimate yet, e.g. new hosts, are preferred when idle so that they are
+ * probed, and are otherwise picked only over hosts with the same number of active requests.
+ */
+class PeakEwmaLoadBalancer : public ZoneAwareLoadBalancerBase {
+public:
+  PeakEwmaLoadBalancer(
+      const PrioritySet& priority_set, const PrioritySet* local_priority_set, ClusterStats& stats,
+      Runtime::Loader& runtime, Runtime::RandomGenerator& random,
+      const envoy::api::v2::Cluster::CommonLbConfig& common_config, TimeSource& time_source,
+      const LocalityRoutingTableCacheSharedPtr& locality_routing_table_cache = nullptr)
+      : ZoneAwareLoadBalancerBase(priority_set, local_priority_set, stats, runtime, random,
+                                  common_config, locality_routing_table_cache),
+        time_source_(time_source) {}
+
+  // Upstream::LoadBalancerBase
+  HostConstSharedPtr chooseHostOnce(LoadBalancerContext* context) override;
+
+private:
+  double cost(const Host& host, MonotonicTime now) const;
+
+  TimeSource& time_source_;
 };
 
 /**
@@ -378,12 +465,13 @@ private:
  */
 class RandomLoadBalancer : public ZoneAwareLoadBalancerBase {
 public:
-  RandomLoadBalancer(const PrioritySet& priority_set, const PrioritySet* local_priority_set,
-                     ClusterStats& stats, Runtime::Loader& runtime,
-                     Runtime::RandomGenerator& random,
-                     const envoy::api::v2::Cluster::CommonLbConfig& common_config)
+  RandomLoadBalancer(
+      const PrioritySet& priority_set, const PrioritySet* local_priority_set, ClusterStats& stats,
+      Runtime::Loader& runtime, Runtime::RandomGenerator& random,
+      const envoy::api::v2::Cluster::CommonLbConfig& common_config,
+      const LocalityRoutingTableCacheSharedPtr& locality_routing_table_cache = nullptr)
       : ZoneAwareLoadBalancerBase(priority_set, local_priority_set, stats, runtime, random,
-                                  common_config) {}
+                                  common_config, locality_routing_table_cache) {}
 
   // Upstream::LoadBalancerBase
   HostConstSharedPtr chooseHostOnce(LoadBalancerContext* context) override;
@@ -1,8 +1,11 @@
 #include "common/upstream/load_stats_reporter.h"
 
+#include <unordered_set>
+
 #include "envoy/stats/scope.h"
 
 #include "common/protobuf/protobuf.h"
+#include "common/upstream/locality.h"
 
 namespace Envoy {
 namespace Upstream {
@@ -42,9 +45,9 @@ void LoadStatsReporter::establishNewStream() {
 
 void LoadStatsReporter::sendLoadStatsRequest() {
   request_.mutable_cluster_stats()->Clear();
+  auto cluster_info_map = cm_.clusters();
   for (const auto& cluster_name_and_timestamp : clusters_) {
     const std::string& cluster_name = cluster_name_and_timestamp.first;
-    auto cluster_info_map = cm_.clusters();
     auto it = cluster_info_map.find(cluster_name);
     if (it == cluster_info_map.end()) {
       ENVOY_LOG(debug, "Cluster {} does not exist", cluster_name);
@@ -53,25 +56,27 @@ void LoadStatsReporter::sendLoadStatsRequest() {
     auto& cluster = it->second.get();
     auto* cluster_stats = request_.add_cluster_stats();
     cluster_stats->set_cluster_name(cluster_name);
+    // The load of a locality is aggregated by its hosts as requests complete, so the report only
+    // latches one set of counters per locality. A locality is reported at the first priority it
+    // has hosts in.
+    std::unordered_set<envoy::api::v2::core::Locality, LocalityHash, LocalityEqualTo> localities;
     for (auto& host_set : cluster.prioritySet().hostSetsPerPriority()) {
       ENVOY_LOG(trace, "Load report locality count {}", host_set->hostsPerLocality().get().size());
       for (auto& hosts : host_set->hostsPerLocality().get()) {
         ASSERT(hosts.size() > 0);
-        uint64_t rq_success = 0;
-        uint64_t rq_error = 0;
-        uint64_t rq_active = 0;
-        for (auto host : hosts) {
-          rq_success += host->stats().rq_success_.latch();
-          rq_error += host->stats().rq_error_.latch();
-          rq_active += host->stats().rq_active_.value();
+        const envoy::api::v2::core::Locality& locality = hosts[0]->locality();
+        if (!localities.insert(locality).second) {
+          continue;
         }
-        if (rq_success + rq_error + rq_active != 0) {
+        const LocalityLoadStats::Snapshot load =
+            cluster.info()->localityLoadStats(locality)->latch();
+        if (load.rq_success_ + load.rq_error_ + load.rq_active_ != 0) {
           auto* locality_stats = cluster_stats->add_upstream_locality_stats();
-          locality_stats->mutable_locality()->MergeFrom(hosts[0]->locality());
+          locality_stats->mutable_locality()->MergeFrom(locality);
           locality_stats->set_priority(host_set->priority());
-          locality_stats->set_total_successful_requests(rq_success);
-          locality_stats->set_total_error_requests(rq_error);
-          locality_stats->set_total_requests_in_progress(rq_active);
+          locality_stats->set_total_successful_requests(load.rq_success_);
+          locality_stats->set_total_error_requests(load.rq_error_);
+          locality_stats->set_total_requests_in_progress(load.rq_active_);
         }
       }
     }
@@ -132,12 +137,12 @@ void LoadStatsReporter::startLoadReportPeriod() {
     }
   }
   clusters_.clear();
-  // Reset stats for all hosts in clusters we are tracking.
+  // Reset stats for all localities in clusters we are tracking.
+  auto cluster_info_map = cm_.clusters();
   for (const std::string& cluster_name : message_->clusters()) {
     clusters_.emplace(cluster_name, existing_clusters.count(cluster_name) > 0
                                         ? existing_clusters[cluster_name]
                                         : time_source_.monotonicTime().time_since_epoch());
-    auto cluster_info_map = cm_.clusters();
     auto it = cluster_info_map.find(cluster_name);
     if (it == cluster_info_map.end()) {
       continue;
@@ -148,9 +153,9 @@ void LoadStatsReporter::startLoadReportPeriod() {
     }
     auto& cluster = it->second.get();
     for (auto& host_set : cluster.prioritySet().hostSetsPerPriority()) {
-      for (auto host : host_set->hosts()) {
-        host->stats().rq_success_.latch();
-        host->stats().rq_error_.latch();
+      for (auto& hosts : host_set->hostsPerLocality().get()) {
+        ASSERT(hosts.size() > 0);
+        cluster.info()->localityLoadStats(hosts[0]->locality())->latch();
       }
     }
     cluster.info()->loadReportStats().upstream_rq_dropped_.latch();
@@ -0,0 +1,49 @@
+#include "common/upstream/locality_load_stats.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace Envoy {
+namespace Upstream {
+
+namespace {
+
+// Assigns threads to shards round robin, the first time they update load stats.
+std::atomic<uint32_t> next_shard_{0};
+
+} // namespace
+
+LocalityLoadStatsImpl::Shard& LocalityLoadStatsImpl::shard() {
+  static thread_local const uint32_t index = next_shard_++ % NumShards;
+  return shards_[index];
+}
+
+LocalityLoadStats::Snapshot LocalityLoadStatsImpl::latch() {
+  uint64_t rq_success = 0;
+  uint64_t rq_error = 0;
+  int64_t rq_active = 0;
+  for (const Shard& shard : shards_) {
+    rq_success += shard.rq_success_;
+    rq_error += shard.rq_error_;
+    rq_active += shard.rq_active_;
+  }
+
+  Snapshot snapshot{rq_success - latched_success_, rq_error - latched_error_,
+                    rq_active > 0 ? static_cast<uint64_t>(rq_active) : 0};
+  latched_success_ = rq_success;
+  latched_error_ = rq_error;
+  return snapshot;
+}
+
+LocalityLoadStatsSharedPtr
+LocalityLoadStatsMap::get(const envoy::api::v2::core::Locality& locality) {
+  Thread::LockGuard lock(lock_);
+  LocalityLoadStatsSharedPtr& stats = stats_[locality];
+  if (stats == nullptr) {
+    stats = std::make_shared<LocalityLoadStatsImpl>(locality);
+  }
+  return stats;
+}
+
+} // namespace Upstream
+} // namespace Envoy
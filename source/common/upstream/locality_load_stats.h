@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+#include "envoy/api/v2/core/base.pb.h"
+#include "envoy/upstream/upstream.h"
+
+#include "common/common/lock_guard.h"
+#include "common/common/thread.h"
+#include "common/upstream/locality.h"
+
+namespace Envoy {
+namespace Upstream {
+
+/**
+ * Implementation of LocalityLoadStats. Counts are kept in per thread shards so that workers
+ * updating the same locality do not contend on a cache line, and are summed when latched.
+ */
+class LocalityLoadStatsImpl : public LocalityLoadStats {
+public:
+  LocalityLoadStatsImpl(const envoy::api::v2::core::Locality& locality) : locality_(locality) {}
+
+  // Upstream::LocalityLoadStats
+  const envoy::api::v2::core::Locality& locality() const override { return locality_; }
+  void addSuccess(uint64_t amount) override { shard().rq_success_ += amount; }
+  void addError(uint64_t amount) override { shard().rq_error_ += amount; }
+  void addActive(int64_t amount) override { shard().rq_active_ += amount; }
+  Snapshot latch() override;
+
+  static const uint32_t NumShards = 16;
+
+private:
+  struct Shard {
+    std::atomic<uint64_t> rq_success_{0};
+    std::atomic<uint64_t> rq_error_{0};
+    std::atomic<int64_t> rq_active_{0};
+    // Keep shards on separate cache lines.
+    char padding_[64 - 3 * sizeof(uint64_t)];
+  };
+
+  Shard& shard();
+
+  const envoy::api::v2::core::Locality locality_;
+  Shard shards_[NumShards];
+  // Totals as of the previous latch(). Only used on the main thread.
+  uint64_t latched_success_{};
+  uint64_t latched_error_{};
+};
+
+/**
+ * The load stats of the localities of a cluster. The hosts of the cluster refer to the locality
+ * held by the load stats of their locality.
+ */
+class LocalityLoadStatsMap {
+public:
+  /**
+   * @return the load stats of a locality, created on first use. This may be called from any thread.
+   */
+  LocalityLoadStatsSharedPtr get(const envoy::api::v2::core::Locality& locality);
+
+private:
+  Thread::MutexBasicLockable lock_;
+  std::unordered_map<envoy::api::v2::core::Locality, LocalityLoadStatsSharedPtr, LocalityHash,
+                     LocalityEqualTo>
+      stats_ GUARDED_BY(lock_);
+};
+
+} // namespace Upstream
+} // namespace Envoy
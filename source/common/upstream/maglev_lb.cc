@@ -1,57 +1,42 @@
 #include "common/upstream/maglev_lb.h"
 
+#include <algorithm>
+#include <limits>
+
 namespace Envoy {
 namespace Upstream {
 
 MaglevTable::MaglevTable(const HostsPerLocality& hosts_per_locality,
                          const LocalityWeightsConstSharedPtr& locality_weights, uint64_t table_size)
     : table_size_(table_size) {
-  // TODO(mattklein123): The Maglev table must have a size that is a prime number for the algorithm
-  // to work. Currently, the table size is not user configurable. In the future, if the table size
-  // is made user configurable, we will need proper error checking that the user cannot configure a
-  // size that is not prime (the result is going to be an infinite loop with some inputs which is
-  // not good!).
+  // The Maglev table must have a size that is a prime number for the algorithm to work, otherwise
+  // building it may never terminate. Configured sizes are checked by ClusterInfoImpl.
   ASSERT(Primes::isPrime(table_size));
 
-  // Compute host weight combined with locality weight where applicable.
-  const auto effective_weight = [&locality_weights](uint32_t host_weight,
-                                                    uint32_t locality_index) -> uint32_t {
-    if (locality_weights == nullptr || locality_weights->empty()) {
-      return host_weight;
-    } else {
-      return host_weight * (*locality_weights)[locality_index];
-    }
-  };
-
-  // Compute maximum host weight. If this is zero, we are doing unweighted Maglev.
-  uint32_t max_host_weight = 0;
-  uint32_t total_hosts = 0;
-  for (uint32_t i = 0; i < hosts_per_locality.get().size(); ++i) {
-    for (const auto& host : hosts_per_locality.get()[i]) {
-      max_host_weight = std::max(effective_weight(host->weight(), i), max_host_weight);
-      ++total_hosts;
-    }
-  }
+  flattenHosts(hosts_per_locality, locality_weights, hosts_, weights_);
 
   // We can't do anything sensible with no hosts.
-  if (total_hosts == 0) {
+  if (hosts_.empty()) {
     return;
   }
 
+  // Compute maximum host weight. If this is zero, we are doing unweighted Maglev.
+  const uint32_t max_host_weight = *std::max_element(weights_.begin(), weights_.end());
+
   // Implementation of pseudocode listing 1 in the paper (see header file for more info).
   std::vector<TableBuildEntry> table_build_entries;
-  table_build_entries.reserve(total_hosts);
-  for (uint32_t i = 0; i < hosts_per_locality.get().size(); ++i) {
-    for (const auto& host : hosts_per_locality.get()[i]) {
-      const std::string& address = host->address()->asString();
-      table_build_entries.emplace_back(host, HashUtil::xxHash64(address) % table_size_,
-                                       (HashUtil::xxHash64(address, 1) % (table_size_ - 1)) + 1,
-                                       max_host_weight > 0 ? effective_weight(host->weight(), i)
-                                                           : 0);
-    }
+  table_build_entries.reserve(hosts_.size());
+  for (uint32_t i = 0; i < hosts_.size(); ++i) {
+    const std::string& address = hosts_[i]->address()->asString();
+    table_build_entries.emplace_back(HashUtil::xxHash64(address) % table_size_,
+                                     (HashUtil::xxHash64(address, 1) % (table_size_ - 1)) + 1,
+                                     weights_[i]);
   }
 
-  table_.resize(table_size_);
+  // The table refers to hosts by their index, which makes filling it cheaper than copying a
+  // shared pointer into each entry, and makes it a quarter of the size.
+  const uint32_t empty = std::numeric_limits<uint32_t>::max();
+  table_.resize(table_size_, empty);
   uint64_t table_index = 0;
   uint32_t iteration = 1;
   while (true) {
@@ -70,18 +55,19 @@ MaglevTable::MaglevTable(const HostsPerLocality& hosts_per_locality,
         entry.counts_ += max_host_weight;
       }
       uint64_t c = permutation(entry);
-      while (table_[c] != nullptr) {
+      while (table_[c] != empty) {
         entry.next_++;
         c = permutation(entry);
       }
 
-      table_[c] = entry.host_;
+      table_[c] = i;
       entry.next_++;
       table_index++;
       if (table_index == table_size_) {
         if (ENVOY_LOG_CHECK_LEVEL(trace)) {
           for (uint64_t i = 0; i < table_.size(); i++) {
-            ENVOY_LOG(trace, "maglev: i={} host={}", i, table_[i]->address()->asString());
+            ENVOY_LOG(trace, "maglev: i={} host={}", i,
+                      hosts_[table_[i]]->address()->asString());
           }
         }
         return;
@@ -91,17 +77,74 @@ MaglevTable::MaglevTable(const HostsPerLocality& hosts_per_locality,
   }
 }
 
+void MaglevTable::flattenHosts(const HostsPerLocality& hosts_per_locality,
+                               const LocalityWeightsConstSharedPtr& locality_weights,
+                               HostVector& hosts, std::vector<uint32_t>& weights) {
+  // Compute host weight combined with locality weight where applicable.
+  const auto effective_weight = [&locality_weights](uint32_t host_weight,
+                                                    uint32_t locality_index) -> uint32_t {
+    if (locality_weights == nullptr || locality_weights->empty()) {
+      return host_weight;
+    } else {
+      return host_weight * (*locality_weights)[locality_index];
+    }
+  };
+
+  for (uint32_t i = 0; i < hosts_per_locality.get().size(); ++i) {
+    for (const auto& host : hosts_per_locality.get()[i]) {
+      hosts.push_back(host);
+      weights.push_back(effective_weight(host->weight(), i));
+    }
+  }
+}
+
+bool MaglevTable::sameHosts(const HostsPerLocality& hosts_per_locality,
+                            const LocalityWeightsConstSharedPtr& locality_weights) const {
+  // Host weights may be updated in place, so the weights are compared as well as the hosts.
+  HostVector hosts;
+  std::vector<uint32_t> weights;
+  flattenHosts(hosts_per_locality, locality_weights, hosts, weights);
+  return hosts == hosts_ && weights == weights_;
+}
+
 HostConstSharedPtr MaglevTable::chooseHost(uint64_t hash) const {
   if (table_.empty()) {
     return nullptr;
   }
 
-  return table_[hash % table_size_];
+  return hosts_[table_[hash % table_size_]];
 }
 
 uint64_t MaglevTable::permutation(const TableBuildEntry& entry) {
   return (entry.offset_ + (entry.skip_ * entry.next_)) % table_size_;
 }
 
+ThreadAwareLoadBalancerBase::HashingLoadBalancerSharedPtr
+MaglevLoadBalancer::createLoadBalancer(const HostSet& host_set) {
+  // Note that we only compute global panic on host set refresh. Given that the runtime setting
+  // will rarely change, this is a reasonable compromise to avoid creating extra LBs when we only
+  // need to create one per priority level.
+  const bool has_locality =
+      host_set.localityWeights() != nullptr && !host_set.localityWeights()->empty();
+  const bool global_panic = isGlobalPanic(host_set);
+  const HostsPerLocalityImpl all_hosts(global_panic ? host_set.hosts() : host_set.healthyHosts(),
+                                       false);
+  const HostsPerLocality& hosts_per_locality =
+      !has_locality ? all_hosts
+                    : (global_panic ? host_set.hostsPerLocality()
+                                    : host_set.healthyHostsPerLocality());
+  const LocalityWeightsConstSharedPtr locality_weights =
+      has_locality ? host_set.localityWeights() : nullptr;
+
+  if (tables_.size() <= host_set.priority()) {
+    tables_.resize(host_set.priority() + 1);
+  }
+  MaglevTableSharedPtr& table = tables_[host_set.priority()];
+  if (table == nullptr || !table->sameHosts(hosts_per_locality, locality_weights)) {
+    table = std::make_shared<MaglevTable>(hosts_per_locality, locality_weights, table_size_);
+  }
+  return table;
+}
+
 } // namespace Upstream
 } // namespace Envoy
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "common/memory/huge_page_arena.h"
+#include "common/protobuf/utility.h"
 #include "common/upstream/thread_aware_lb_impl.h"
 #include "common/upstream/upstream_impl.h"
 
@@ -10,7 +12,7 @@ namespace Upstream {
  * This is an implementation of Maglev consistent hashing as described in:
  * https://static.googleusercontent.com/media/research.google.com/en//pubs/archive/44824.pdf
  * section 3.4. Specifically, the algorithm shown in pseudocode listening 1 is implemented
- * with a fixed table size of 65537. This is the recommended table size in section 5.3.
+ * with a default table size of 65537. This is the recommended table size in section 5.3.
  */
 class MaglevTable : public ThreadAwareLoadBalancerBase::HashingLoadBalancer,
                     Logger::Loggable<Logger::Id::upstream> {
@@ -22,15 +24,21 @@ public:
   // ThreadAwareLoadBalancerBase::HashingLoadBalancer
   HostConstSharedPtr chooseHost(uint64_t hash) const override;
 
+  /**
+   * @return bool whether a table built from the given hosts and weights would be the same as this
+   *         one, in which case this one can be used instead.
+   */
+  bool sameHosts(const HostsPerLocality& hosts_per_locality,
+                 const LocalityWeightsConstSharedPtr& locality_weights) const;
+
   // Recommended table size in section 5.3 of the paper.
   static const uint64_t DefaultTableSize = 65537;
 
 private:
   struct TableBuildEntry {
-    TableBuildEntry(const HostSharedPtr& host, uint64_t offset, uint64_t skip, uint64_t weight)
-        : host_(host), offset_(offset), skip_(skip), weight_(weight) {}
+    TableBuildEntry(uint64_t offset, uint64_t skip, uint64_t weight)
+        : offset_(offset), skip_(skip), weight_(weight) {}
 
-    HostSharedPtr host_;
     const uint64_t offset_;
     const uint64_t skip_;
     const uint64_t weight_;
@@ -38,12 +46,26 @@ private:
     uint64_t next_{};
   };
 
+  /**
+   * Flattens the hosts of all localities, along with their weights combined with the weight of
+   * their locality.
+   */
+  static void flattenHosts(const HostsPerLocality& hosts_per_locality,
+                           const LocalityWeightsConstSharedPtr& locality_weights,
+                           HostVector& hosts, std::vector<uint32_t>& weights);
+
   uint64_t permutation(const TableBuildEntry& entry);
 
   const uint64_t table_size_;
-  HostVector table_;
+  // The hosts the table was built from, and their effective weights.
+  HostVector hosts_;
+  std::vector<uint32_t> weights_;
+  // The index in hosts_ of the host owning each table entry.
+  Memory::HugePageVector<uint32_t> table_;
 };
 
+typedef std::shared_ptr<MaglevTable> MaglevTableSharedPtr;
+
 /**
  * Thread aware load balancer implementation for Maglev.
  */
@@ -56,34 +78,25 @@ public:
       : ThreadAwareLoadBalancerBase(priority_set, stats, runtime, random, common_config),
         table_size_(table_size) {}
 
+  /**
+   * @return uint64_t the table size set by the given configuration, or the default one.
+   */
+  static uint64_t
+  tableSize(const absl::optional<envoy::api::v2::Cluster::MaglevLbConfig>& config) {
+    return config ? PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.value(), table_size,
+                                                    MaglevTable::DefaultTableSize)
+                  : MaglevTable::DefaultTableSize;
+  }
+
 private:
   // ThreadAwareLoadBalancerBase
-  HashingLoadBalancerSharedPtr createLoadBalancer(const HostSet& host_set) override {
-    // Note that we only compute global panic on host set refresh. Given that the runtime setting
-    // will rarely change, this is a reasonable compromise to avoid creating extra LBs when we only
-    // need to create one per priority level.
-    const bool has_locality =
-        host_set.localityWeights() != nullptr && !host_set.localityWeights()->empty();
-    if (isGlobalPanic(host_set)) {
-      if (!has_locality) {
-        return std::make_shared<MaglevTable>(HostsPerLocalityImpl(host_set.hosts(), false), nullptr,
-                                             table_size_);
-      } else {
-        return std::make_shared<MaglevTable>(host_set.hostsPerLocality(),
-                                             host_set.localityWeights(), table_size_);
-      }
-    } else {
-      if (!has_locality) {
-        return std::make_shared<MaglevTable>(HostsPerLocalityImpl(host_set.healthyHosts(), false),
-                                             nullptr, table_size_);
-      } else {
-        return std::make_shared<MaglevTable>(host_set.healthyHostsPerLocality(),
-                                             host_set.localityWeights(), table_size_);
-      }
-    }
-  }
+  HashingLoadBalancerSharedPtr createLoadBalancer(const HostSet& host_set) override;
 
   const uint64_t table_size_;
+  // The last table built for each priority. All the priorities are refreshed on any host set
+  // change, and the healthy hosts of a priority often stay the same, e.g. when the new hosts are
+  // waiting for their first health check, in which case the table is reused.
+  std::vector<MaglevTableSharedPtr> tables_;
 };
 
 } // namespace Upstream
@@ -1,12 +1,15 @@
 #include "common/upstream/original_dst_cluster.h"
 
+#include <algorithm>
 #include <chrono>
 #include <list>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include "envoy/stats/scope.h"
 
+#include "common/common/hash.h"
 #include "common/http/headers.h"
 #include "common/network/address_impl.h"
 #include "common/network/utility.h"
@@ -22,27 +25,53 @@ namespace Upstream {
 // OriginalDstCluster::LoadBalancer is never configured with any other type of cluster,
 // and throws an exception otherwise.
 
+OriginalDstCluster::HostMap::Shard&
+OriginalDstCluster::HostMap::shard(const std::string& address) {
+  return shards_[HashUtil::xxHash64(address) % Shards];
+}
+
+const OriginalDstCluster::HostMap::Shard&
+OriginalDstCluster::HostMap::shard(const std::string& address) const {
+  return shards_[HashUtil::xxHash64(address) % Shards];
+}
+
+HostSharedPtr OriginalDstCluster::HostMap::find(const std::string& address) const {
+  const Shard& address_shard = shard(address);
+  absl::ReaderMutexLock lock(&address_shard.mutex_);
+  const auto it = address_shard.hosts_.find(address);
+  return it != address_shard.hosts_.end() ? it->second : nullptr;
+}
+
+HostSharedPtr OriginalDstCluster::HostMap::insert(const HostSharedPtr& host) {
+  const std::string& address = host->address()->asString();
+  Shard& address_shard = shard(address);
+  absl::MutexLock lock(&address_shard.mutex_);
+  return address_shard.hosts_.emplace(address, host).first->second;
+}
+
+void OriginalDstCluster::HostMap::removeUnused(HostVector& removed) {
+  for (Shard& map_shard : shards_) {
+    absl::MutexLock lock(&map_shard.mutex_);
+    for (auto it = map_shard.hosts_.begin(); it != map_shard.hosts_.end();) {
+      if (it->second->used()) {
+        ENVOY_LOG(debug, "Keeping active host {}.", it->first);
+        it->second->used(false); // Mark to be removed during the next round.
+        ++it;
+      } else {
+        ENVOY_LOG(debug, "Removing stale host {}.", it->first);
+        removed.emplace_back(std::move(it->second));
+        it = map_shard.hosts_.erase(it);
+      }
+    }
+  }
+}
+
 OriginalDstCluster::LoadBalancer::LoadBalancer(
-    PrioritySet& priority_set, ClusterSharedPtr& parent,
+    PrioritySet&, ClusterSharedPtr& parent,
     const absl::optional<envoy::api::v2::Cluster::OriginalDstLbConfig>& config)
-    : priority_set_(priority_set), parent_(std::static_pointer_cast<OriginalDstCluster>(parent)),
-      info_(parent->info()), use_http_header_(config ? config.value().use_http_header() : false) {
-  // priority_set_ is initially empty.
-  priority_set_.addMemberUpdateCb(
-      [this](uint32_t, const HostVector& hosts_added, const HostVector& hosts_removed) -> void {
-        // Update the hosts map
-        // TODO(ramaraochavali): use cluster stats and move the log lines to debug.
-        for (const HostSharedPtr& host : hosts_removed) {
-          ENVOY_LOG(debug, "Removing host {}.", host->address()->asString());
-          host_map_.remove(host);
-        }
-        for (const HostSharedPtr& host : hosts_added) {
-          if (host_map_.insert(host)) {
-            ENVOY_LOG(debug, "Adding host {}.", host->address()->asString());
-          }
-        }
-      });
-}
+    : parent_(std::static_pointer_cast<OriginalDstCluster>(parent)), info_(parent->info()),
+      use_http_header_(config ? config.value().use_http_header() : false),
+      host_map_(std::static_pointer_cast<OriginalDstCluster>(parent)->host_map_) {}
 
 HostConstSharedPtr OriginalDstCluster::LoadBalancer::chooseHost(LoadBalancerContext* context) {
   if (context) {
@@ -64,8 +93,8 @@ HostConstSharedPtr OriginalDstCluster::LoadBalancer::chooseHost(LoadBalancerCont
     if (dst_host) {
       const Network::Address::Instance& dst_addr = *dst_host.get();
 
-      // Check if a host with the destination address is already in the host set.
-      HostSharedPtr host = host_map_.find(dst_addr);
+      // Check if a host with the destination address was already added by any thread.
+      HostSharedPtr host = host_map_->find(dst_addr.asString());
       if (host) {
         ENVOY_LOG(debug, "Using existing host {}.", host->address()->asString());
         host->used(true); // Mark as used.
@@ -83,18 +112,24 @@ HostConstSharedPtr OriginalDstCluster::LoadBalancer::chooseHost(LoadBalancerCont
             envoy::api::v2::core::Locality().default_instance(),
             envoy::api::v2::endpoint::Endpoint::HealthCheckConfig().default_instance()));
 
+        // Another thread may have added a host for the destination since the lookup above, in which
+        // case that one is used and the new one dropped.
+        HostSharedPtr inserted_host = host_map_->insert(host);
+        if (inserted_host != host) {
+          ENVOY_LOG(debug, "Using host {} added concurrently.", host->address()->asString());
+          inserted_host->used(true);
+          return std::move(inserted_host);
+        }
         ENVOY_LOG(debug, "Created host {}.", host->address()->asString());
-        // Add the new host to the map. We just failed to find it in
-        // our local map above, so insert without checking (2nd arg == false).
-        host_map_.insert(host, false);
 
-        if (std::shared_ptr<OriginalDstCluster> parent = parent_.lock()) {
+        std::shared_ptr<OriginalDstCluster> parent = parent_.lock();
+        if (parent && parent->queueHost(host)) {
           // lambda cannot capture a member by value.
           std::weak_ptr<OriginalDstCluster> post_parent = parent_;
-          parent->dispatcher_.post([post_parent, host]() mutable {
+          parent->dispatcher_.post([post_parent]() -> void {
             // The main cluster may have disappeared while this post was queued.
             if (std::shared_ptr<OriginalDstCluster> parent = post_parent.lock()) {
-              parent->addHost(host);
+              parent->addQueuedHosts();
             }
           });
         }
@@ -137,45 +172,70 @@ OriginalDstCluster::OriginalDstCluster(
       dispatcher_(factory_context.dispatcher()),
       cleanup_interval_ms_(
           std::chrono::milliseconds(PROTOBUF_GET_MS_OR_DEFAULT(config, cleanup_interval, 5000))),
-      cleanup_timer_(dispatcher_.createTimer([this]() -> void { cleanup(); })) {
+      cleanup_timer_(dispatcher_.createTimer([this]() -> void { cleanup(); })),
+      host_map_(std::make_shared<HostMap>()) {
 
   cleanup_timer_->enableTimer(cleanup_interval_ms_);
 }
 
-void OriginalDstCluster::addHost(HostSharedPtr& host) {
+bool OriginalDstCluster::queueHost(const HostSharedPtr& host) {
+  absl::MutexLock lock(&queued_hosts_mutex_);
+  queued_hosts_.emplace_back(host);
+  return queued_hosts_.size() == 1;
+}
+
+void OriginalDstCluster::addQueuedHosts() {
+  HostVector hosts_added;
+  {
+    absl::MutexLock lock(&queued_hosts_mutex_);
+    hosts_added.swap(queued_hosts_);
+  }
+  // A host may have been cleaned up from the map before it got here, in which case it is dropped.
+  hosts_added.erase(std::remove_if(hosts_added.begin(), hosts_added.end(),
+                                   [this](const HostSharedPtr& host) -> bool {
+                                     return host_map_->find(host->address()->asString()) != host;
+                                   }),
+                    hosts_added.end());
+  if (hosts_added.empty()) {
+    return;
+  }
+
   // Given the current config, only EDS clusters support multiple priorities.
   ASSERT(priority_set_.hostSetsPerPriority().size() == 1);
   auto& first_host_set = priority_set_.getOrCreateHostSet(0);
   HostVectorSharedPtr new_hosts(new HostVector(first_host_set.hosts()));
-  new_hosts->emplace_back(host);
+  new_hosts->insert(new_hosts->end(), hosts_added.begin(), hosts_added.end());
   first_host_set.updateHosts(new_hosts, createHealthyHostList(*new_hosts),
                              HostsPerLocalityImpl::empty(), HostsPerLocalityImpl::empty(), {},
-                             {std::move(host)}, {}, absl::nullopt);
+                             hosts_added, {}, absl::nullopt);
 }
 
 void OriginalDstCluster::cleanup() {
-  HostVectorSharedPtr new_hosts(new HostVector);
-  HostVector to_be_removed;
-  // Given the current config, only EDS clusters support multiple priorities.
-  ASSERT(priority_set_.hostSetsPerPriority().size() == 1);
-  auto& host_set = priority_set_.getOrCreateHostSet(0);
-
   ENVOY_LOG(debug, "Cleaning up stale original dst hosts.");
-  for (const HostSharedPtr& host : host_set.hosts()) {
-    if (host->used()) {
-      ENVOY_LOG(debug, "Keeping active host {}.", host->address()->asString());
-      new_hosts->emplace_back(host);
-      host->used(false); // Mark to be removed during the next round.
-    } else {
-      ENVOY_LOG(debug, "Removing stale host {}.", host->address()->asString());
-      to_be_removed.emplace_back(host);
+  HostVector removed_from_map;
+  host_map_->removeUnused(removed_from_map);
+
+  if (!removed_from_map.empty()) {
+    // Given the current config, only EDS clusters support multiple priorities.
+    ASSERT(priority_set_.hostSetsPerPriority().size() == 1);
+    auto& host_set = priority_set_.getOrCreateHostSet(0);
+    const std::unordered_set<HostSharedPtr> stale_hosts(removed_from_map.begin(),
+                                                        removed_from_map.end());
+    HostVectorSharedPtr new_hosts(new HostVector);
+    HostVector to_be_removed;
+    for (const HostSharedPtr& host : host_set.hosts()) {
+      if (stale_hosts.count(host) > 0) {
+        to_be_removed.emplace_back(host);
+      } else {
+        new_hosts->emplace_back(host);
+      }
     }
-  }
 
-  if (to_be_removed.size() > 0) {
-    host_set.updateHosts(new_hosts, createHealthyHostList(*new_hosts),
-                         HostsPerLocalityImpl::empty(), HostsPerLocalityImpl::empty(), {}, {},
-                         to_be_removed, absl::nullopt);
+    if (!to_be_removed.empty()) {
+      host_set.updateHosts(new_hosts, createHealthyHostList(*new_hosts),
+                           HostsPerLocalityImpl::empty(), HostsPerLocalityImpl::empty(), {}, {},
+                           to_be_removed, absl::nullopt);
+    }
   }
 
   cleanup_timer_->enableTimer(cleanup_interval_ms_);
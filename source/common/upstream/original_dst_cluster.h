@@ -1,7 +1,9 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <string>
 #include <unordered_map>
 
@@ -14,6 +16,8 @@
 #include "common/common/logger.h"
 #include "common/upstream/upstream_impl.h"
 
+#include "absl/synchronization/mutex.h"
+
 namespace Envoy {
 namespace Upstream {
 
@@ -32,19 +36,62 @@ public:
   // Upstream::Cluster
   InitializePhase initializePhase() const override { return InitializePhase::Primary; }
 
+  /**
+   * Map from a host IP address/port to its host, shared by the cluster and the load balancers of
+   * all threads. The map is split into shards with a lock each, so that threads looking up or
+   * adding different destinations rarely contend.
+   */
+  class HostMap {
+  public:
+    /**
+     * @param address supplies the address string of the host.
+     * @return HostSharedPtr the host with the address, or nullptr if there is none.
+     */
+    HostSharedPtr find(const std::string& address) const;
+
+    /**
+     * Insert a host, unless another thread already inserted one with the same address.
+     * @param host supplies the host to insert.
+     * @return HostSharedPtr the host in the map for the address, which is the supplied host if it
+     *         was inserted.
+     */
+    HostSharedPtr insert(const HostSharedPtr& host);
+
+    /**
+     * Remove the hosts which were not used since the previous call and mark the others as unused.
+     * Only one shard is locked at a time, so lookups in the other shards proceed meanwhile.
+     * @param removed supplies the vector the removed hosts are appended to.
+     */
+    void removeUnused(HostVector& removed);
+
+  private:
+    static constexpr size_t Shards = 16;
+
+    struct Shard {
+      mutable absl::Mutex mutex_;
+      std::unordered_map<std::string, HostSharedPtr> hosts_;
+    };
+
+    Shard& shard(const std::string& address);
+    const Shard& shard(const std::string& address) const;
+
+    std::array<Shard, Shards> shards_;
+  };
+
+  typedef std::shared_ptr<HostMap> HostMapSharedPtr;
+
   /**
    * Special Load Balancer for Original Dst Cluster.
    *
    * Load balancer gets called with the downstream context which can be used to make sure the
-   * Original Dst cluster has a Host for the original destination. Normally load balancers can't
-   * modify clusters, but in this case we access a singleton OriginalDstCluster that we can ask to
-   * add hosts on demand. Additions are synced with all other threads so that the host set in the
-   * cluster remains (eventually) consistent. If multiple threads add a host to the same upstream
-   * address then two distinct HostSharedPtr's (with the same upstream IP address) will be added,
-   * and both of them will eventually time out.
+   * Original Dst cluster has a Host for the original destination. Hosts are looked up and added
+   * in the HostMap the cluster shares with the load balancers of all threads, so a host created
+   * by one thread is used right away by all others. New hosts are also queued to be added to the
+   * host set of the cluster on the main thread, which keeps it (eventually) consistent.
    */
   class LoadBalancer : public Upstream::LoadBalancer {
   public:
+    // The thread local priority set is not used, since hosts are looked up in the HostMap.
     LoadBalancer(PrioritySet& priority_set, ClusterSharedPtr& parent,
                  const absl::optional<envoy::api::v2::Cluster::OriginalDstLbConfig>& config);
 
@@ -52,60 +99,22 @@ public:
     HostConstSharedPtr chooseHost(LoadBalancerContext* context) override;
 
   private:
-    /**
-     * Map from an host IP address/port to a HostSharedPtr. Due to races multiple distinct host
-     * objects with the same address can be created, so we need to use a multimap.
-     */
-    class HostMap {
-    public:
-      bool insert(const HostSharedPtr& host, bool check = true) {
-        if (check) {
-          auto range = map_.equal_range(host->address()->asString());
-          auto it = std::find_if(
-              range.first, range.second,
-              [&host](const decltype(map_)::value_type pair) { return pair.second == host; });
-          if (it != range.second) {
-            return false; // 'host' already in the map, no need to insert.
-          }
-        }
-        map_.emplace(host->address()->asString(), host);
-        return true;
-      }
-
-      void remove(const HostSharedPtr& host) {
-        auto range = map_.equal_range(host->address()->asString());
-        auto it =
-            std::find_if(range.first, range.second, [&host](const decltype(map_)::value_type pair) {
-              return pair.second == host;
-            });
-        ASSERT(it != range.second);
-        map_.erase(it);
-      }
-
-      HostSharedPtr find(const Network::Address::Instance& address) {
-        auto it = map_.find(address.asString());
-
-        if (it != map_.end()) {
-          return it->second;
-        }
-        return nullptr;
-      }
-
-    private:
-      std::unordered_multimap<std::string, HostSharedPtr> map_;
-    };
-
     Network::Address::InstanceConstSharedPtr requestOverrideHost(LoadBalancerContext* context);
 
-    PrioritySet& priority_set_;                // Thread local priority set.
     std::weak_ptr<OriginalDstCluster> parent_; // Primary cluster managed by the main thread.
     ClusterInfoConstSharedPtr info_;
     const bool use_http_header_;
-    HostMap host_map_;
+    const HostMapSharedPtr host_map_;
   };
 
 private:
-  void addHost(HostSharedPtr&);
+  /**
+   * Queue a host for addition to the host set. May be called from any thread.
+   * @return bool true if the queue was empty, in which case the caller posts addQueuedHosts() to
+   *         the main thread.
+   */
+  bool queueHost(const HostSharedPtr& host);
+  void addQueuedHosts();
   void cleanup();
 
   // ClusterImplBase
@@ -114,6 +123,9 @@ private:
   Event::Dispatcher& dispatcher_;
   const std::chrono::milliseconds cleanup_interval_ms_;
   Event::TimerPtr cleanup_timer_;
+  const HostMapSharedPtr host_map_;
+  absl::Mutex queued_hosts_mutex_;
+  HostVector queued_hosts_ GUARDED_BY(queued_hosts_mutex_);
 };
 
 } // namespace Upstream
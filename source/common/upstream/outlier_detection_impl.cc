@@ -1,9 +1,11 @@
 #include "common/upstream/outlier_detection_impl.h"
 
 #include <chrono>
+#include <cmath>
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "envoy/event/dispatcher.h"
@@ -12,14 +14,31 @@
 #include "common/common/assert.h"
 #include "common/common/enum_to_int.h"
 #include "common/common/fmt.h"
+#include "common/common/hash.h"
 #include "common/common/utility.h"
 #include "common/http/codes.h"
 #include "common/protobuf/utility.h"
+#include "common/runtime/key_registry.h"
+#include "common/singleton/const_singleton.h"
 
 namespace Envoy {
 namespace Upstream {
 namespace Outlier {
 
+namespace {
+
+// Keys read for every 5xx response. The keys read by the periodic sweep are looked up by name.
+struct RuntimeKeyValues {
+  const Runtime::KeyHandle Consecutive5xx{
+      Runtime::KeyRegistry::registerKey("outlier_detection.consecutive_5xx")};
+  const Runtime::KeyHandle ConsecutiveGatewayFailure{
+      Runtime::KeyRegistry::registerKey("outlier_detection.consecutive_gateway_failure")};
+};
+
+typedef ConstSingleton<RuntimeKeyValues> RuntimeKeys;
+
+} // namespace
+
 DetectorSharedPtr DetectorImplFactory::createForCluster(
     Cluster& cluster, const envoy::api::v2::Cluster& cluster_config, Event::Dispatcher& dispatcher,
     Runtime::Loader& runtime, EventLoggerSharedPtr event_logger) {
@@ -46,6 +65,12 @@ void DetectorHostMonitorImpl::updateCurrentSuccessRateBucket() {
   success_rate_accumulator_bucket_.store(success_rate_accumulator_.updateCurrentWriter());
 }
 
+void DetectorHostMonitorImpl::putResponseTime(std::chrono::milliseconds response_time) {
+  SuccessRateAccumulatorBucket* bucket = success_rate_accumulator_bucket_.load();
+  bucket->response_time_counter_++;
+  bucket->response_time_total_ms_ += response_time.count();
+}
+
 void DetectorHostMonitorImpl::putHttpResponseCode(uint64_t response_code) {
   success_rate_accumulator_bucket_.load()->total_request_counter_++;
   if (Http::CodeUtility::is5xx(response_code)) {
@@ -55,9 +80,10 @@ void DetectorHostMonitorImpl::putHttpResponseCode(uint64_t response_code) {
       return;
     }
     if (Http::CodeUtility::isGatewayError(response_code)) {
-      if (++consecutive_gateway_failure_ == detector->runtime().snapshot().getInteger(
-                                                "outlier_detection.consecutive_gateway_failure",
-                                                detector->config().consecutiveGatewayFailure())) {
+      if (++consecutive_gateway_failure_ ==
+          detector->runtime().snapshot().getInteger(
+              RuntimeKeys::get().ConsecutiveGatewayFailure,
+              detector->config().consecutiveGatewayFailure())) {
         detector->onConsecutiveGatewayFailure(host_.lock());
       }
     } else {
@@ -65,7 +91,7 @@ void DetectorHostMonitorImpl::putHttpResponseCode(uint64_t response_code) {
     }
 
     if (++consecutive_5xx_ ==
-        detector->runtime().snapshot().getInteger("outlier_detection.consecutive_5xx",
+        detector->runtime().snapshot().getInteger(RuntimeKeys::get().Consecutive5xx,
                                                   detector->config().consecutive5xx())) {
       detector->onConsecutive5xx(host_.lock());
     }
@@ -125,7 +151,12 @@ DetectorConfig::DetectorConfig(const envoy::api::v2::cluster::OutlierDetection&
       enforcing_consecutive_gateway_failure_(static_cast<uint64_t>(
           PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, enforcing_consecutive_gateway_failure, 0))),
       enforcing_success_rate_(static_cast<uint64_t>(
-          PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, enforcing_success_rate, 100))) {}
+          PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, enforcing_success_rate, 100))),
+      stagger_interval_(config.stagger_interval()),
+      latency_stdev_factor_(static_cast<uint64_t>(
+          PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, latency_stdev_factor, 1900))),
+      enforcing_latency_(static_cast<uint64_t>(
+          PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, enforcing_latency, 0))) {}
 
 DetectorImpl::DetectorImpl(const Cluster& cluster,
                            const envoy::api::v2::cluster::OutlierDetection& config,
@@ -180,7 +211,17 @@ void DetectorImpl::initialize(const Cluster& cluster) {
         }
       });
 
-  armIntervalTimer();
+  if (config_.staggerInterval()) {
+    // Clusters created together would otherwise run their sweeps at the same time. Delay the first
+    // sweep by a per-cluster offset so that the sweeps spread over the interval.
+    const uint64_t interval_ms =
+        runtime_.snapshot().getInteger("outlier_detection.interval_ms", config_.intervalMs());
+    const uint64_t offset_ms =
+        interval_ms > 0 ? HashUtil::xxHash64(cluster.info()->name()) % interval_ms : 0;
+    interval_timer_->enableTimer(std::chrono::milliseconds(interval_ms + offset_ms));
+  } else {
+    armIntervalTimer();
+  }
 }
 
 void DetectorImpl::addHostMonitor(HostSharedPtr host) {
@@ -233,6 +274,9 @@ bool DetectorImpl::enforceEjection(EjectionType type) {
   case EjectionType::SuccessRate:
     return runtime_.snapshot().featureEnabled("outlier_detection.enforcing_success_rate",
                                               config_.enforcingSuccessRate());
+  case EjectionType::Latency:
+    return runtime_.snapshot().featureEnabled("outlier_detection.enforcing_latency",
+                                              config_.enforcingLatency());
   }
 
   NOT_REACHED_GCOVR_EXCL_LINE;
@@ -250,6 +294,9 @@ void DetectorImpl::updateEnforcedEjectionStats(EjectionType type) {
   case EjectionType::ConsecutiveGatewayFailure:
     stats_.ejections_enforced_consecutive_gateway_failure_.inc();
     break;
+  case EjectionType::Latency:
+    stats_.ejections_enforced_latency_.inc();
+    break;
   }
 }
 
@@ -343,13 +390,42 @@ void DetectorImpl::onConsecutiveErrorWorker(HostSharedPtr host, EjectionType typ
     host_monitors_[host]->resetConsecutiveGatewayFailure();
     break;
   case EjectionType::SuccessRate:
+  case EjectionType::Latency:
     NOT_REACHED_GCOVR_EXCL_LINE;
   }
 }
 
-Utility::EjectionPair Utility::successRateEjectionThreshold(
-    double success_rate_sum, const std::vector<HostSuccessRatePair>& valid_success_rate_hosts,
-    double success_rate_stdev_factor) {
+namespace {
+
+struct MeanAndStdev {
+  double mean_;
+  double stdev_;
+};
+
+MeanAndStdev meanAndStdev(const std::vector<double>& data) {
+  // Both passes run over a contiguous array of doubles with no calls in the loop bodies, which
+  // keeps them cheap for clusters with many hosts.
+  double sum = 0;
+  for (const double value : data) {
+    sum += value;
+  }
+  const double mean = sum / data.size();
+
+  double variance = 0;
+  for (const double value : data) {
+    const double difference = value - mean;
+    variance += difference * difference;
+  }
+  variance /= data.size();
+
+  return {mean, std::sqrt(variance)};
+}
+
+} // namespace
+
+Utility::EjectionPair
+Utility::successRateEjectionThreshold(const std::vector<double>& success_rates,
+                                      double success_rate_stdev_factor) {
   // This function is using mean and standard deviation as statistical measures for outlier
   // detection. First the mean is calculated by dividing the sum of success rate data over the
   // number of data points. Then variance is calculated by taking the mean of the
@@ -365,86 +441,123 @@ Utility::EjectionPair Utility::successRateEjectionThreshold(
   // variance = 400
   // stdev = 20
   // threshold returned = 52
-  double mean = success_rate_sum / valid_success_rate_hosts.size();
-  double variance = 0;
-  std::for_each(valid_success_rate_hosts.begin(), valid_success_rate_hosts.end(),
-                [&variance, mean](HostSuccessRatePair v) {
-                  variance += std::pow(v.success_rate_ - mean, 2);
-                });
-  variance /= valid_success_rate_hosts.size();
-  double stdev = std::sqrt(variance);
+  const MeanAndStdev stats = meanAndStdev(success_rates);
+  return {stats.mean_, stats.mean_ - (success_rate_stdev_factor * stats.stdev_)};
+}
 
-  return {mean, (mean - (success_rate_stdev_factor * stdev))};
+Utility::EjectionPair Utility::latencyEjectionThreshold(const std::vector<double>& latencies,
+                                                        double latency_stdev_factor) {
+  // Same as the success rate threshold, except that slow hosts are the outliers so the threshold
+  // is above the mean.
+  const MeanAndStdev stats = meanAndStdev(latencies);
+  return {stats.mean_, stats.mean_ + (latency_stdev_factor * stats.stdev_)};
 }
 
 void DetectorImpl::processSuccessRateEjections() {
-  uint64_t success_rate_minimum_hosts = runtime_.snapshot().getInteger(
-      "outlier_detection.success_rate_minimum_hosts", config_.successRateMinimumHosts());
-  uint64_t success_rate_request_volume = runtime_.snapshot().getInteger(
-      "outlier_detection.success_rate_request_volume", config_.successRateRequestVolume());
-  std::vector<HostSuccessRatePair> valid_success_rate_hosts;
-  double success_rate_sum = 0;
-
   // Reset the Detector's success rate mean and stdev.
   success_rate_average_ = -1;
   success_rate_ejection_threshold_ = -1;
 
-  // Exit early if there are not enough hosts.
-  if (host_monitors_.size() < success_rate_minimum_hosts) {
+  uint64_t success_rate_minimum_hosts = runtime_.snapshot().getInteger(
+      "outlier_detection.success_rate_minimum_hosts", config_.successRateMinimumHosts());
+  if (success_rates_.empty() || success_rates_.size() < success_rate_minimum_hosts) {
     return;
   }
 
-  // reserve upper bound of vector size to avoid reallocation.
-  valid_success_rate_hosts.reserve(host_monitors_.size());
-
-  for (const auto& host : host_monitors_) {
-    // Don't do work if the host is already ejected.
-    if (!host.first->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK)) {
-      absl::optional<double> host_success_rate =
-          host.second->successRateAccumulator().getSuccessRate(success_rate_request_volume);
-
-      if (host_success_rate) {
-        valid_success_rate_hosts.emplace_back(
-            HostSuccessRatePair(host.first, host_success_rate.value()));
-        success_rate_sum += host_success_rate.value();
-        host.second->successRate(host_success_rate.value());
-      }
+  double success_rate_stdev_factor =
+      runtime_.snapshot().getInteger("outlier_detection.success_rate_stdev_factor",
+                                     config_.successRateStdevFactor()) /
+      1000.0;
+  Utility::EjectionPair ejection_pair =
+      Utility::successRateEjectionThreshold(success_rates_, success_rate_stdev_factor);
+  success_rate_average_ = ejection_pair.average_;
+  success_rate_ejection_threshold_ = ejection_pair.ejection_threshold_;
+  for (size_t i = 0; i < success_rates_.size(); i++) {
+    if (success_rates_[i] < success_rate_ejection_threshold_) {
+      stats_.ejections_success_rate_.inc(); // Deprecated.
+      stats_.ejections_detected_success_rate_.inc();
+      ejectHost(success_rate_hosts_[i], EjectionType::SuccessRate);
     }
   }
+}
 
-  if (valid_success_rate_hosts.size() >= success_rate_minimum_hosts) {
-    double success_rate_stdev_factor =
-        runtime_.snapshot().getInteger("outlier_detection.success_rate_stdev_factor",
-                                       config_.successRateStdevFactor()) /
-        1000.0;
-    Utility::EjectionPair ejection_pair = Utility::successRateEjectionThreshold(
-        success_rate_sum, valid_success_rate_hosts, success_rate_stdev_factor);
-    success_rate_average_ = ejection_pair.success_rate_average_;
-    success_rate_ejection_threshold_ = ejection_pair.ejection_threshold_;
-    for (const auto& host_success_rate_pair : valid_success_rate_hosts) {
-      if (host_success_rate_pair.success_rate_ < success_rate_ejection_threshold_) {
-        stats_.ejections_success_rate_.inc(); // Deprecated.
-        stats_.ejections_detected_success_rate_.inc();
-        ejectHost(host_success_rate_pair.host_, EjectionType::SuccessRate);
-      }
+void DetectorImpl::processLatencyEjections() {
+  uint64_t success_rate_minimum_hosts = runtime_.snapshot().getInteger(
+      "outlier_detection.success_rate_minimum_hosts", config_.successRateMinimumHosts());
+  if (latencies_.empty() || latencies_.size() < success_rate_minimum_hosts) {
+    return;
+  }
+
+  double latency_stdev_factor =
+      runtime_.snapshot().getInteger("outlier_detection.latency_stdev_factor",
+                                     config_.latencyStdevFactor()) /
+      1000.0;
+  Utility::EjectionPair ejection_pair =
+      Utility::latencyEjectionThreshold(latencies_, latency_stdev_factor);
+  for (size_t i = 0; i < latencies_.size(); i++) {
+    // The host may have been ejected by success rate outlier detection in this interval.
+    if (latencies_[i] > ejection_pair.ejection_threshold_ &&
+        !latency_hosts_[i]->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK)) {
+      stats_.ejections_detected_latency_.inc();
+      ejectHost(latency_hosts_[i], EjectionType::Latency);
     }
   }
 }
 
 void DetectorImpl::onIntervalTimer() {
   MonotonicTime now = time_source_.monotonicTime();
+  uint64_t success_rate_minimum_hosts = runtime_.snapshot().getInteger(
+      "outlier_detection.success_rate_minimum_hosts", config_.successRateMinimumHosts());
+  uint64_t success_rate_request_volume = runtime_.snapshot().getInteger(
+      "outlier_detection.success_rate_request_volume", config_.successRateRequestVolume());
+  // Skip collecting per host statistics if there are not enough hosts to use them.
+  const bool collect = host_monitors_.size() >= success_rate_minimum_hosts;
+
+  success_rate_hosts_.clear();
+  success_rates_.clear();
+  latency_hosts_.clear();
+  latencies_.clear();
+  if (collect) {
+    // Reserve the upper bound of the vector sizes to avoid reallocation.
+    success_rate_hosts_.reserve(host_monitors_.size());
+    success_rates_.reserve(host_monitors_.size());
+    latency_hosts_.reserve(host_monitors_.size());
+    latencies_.reserve(host_monitors_.size());
+  }
 
-  for (auto host : host_monitors_) {
+  for (const auto& host : host_monitors_) {
     checkHostForUneject(host.first, host.second, now);
 
     // Need to update the writer bucket to keep the data valid.
     host.second->updateCurrentSuccessRateBucket();
     // Refresh host success rate stat for the /clusters endpoint. If there is a new valid value, it
-    // will get updated in processSuccessRateEjections().
+    // will get updated below.
     host.second->successRate(-1);
+
+    // Don't do work if the host is already ejected.
+    if (!collect || host.first->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK)) {
+      continue;
+    }
+
+    SuccessRateAccumulator& accumulator = host.second->successRateAccumulator();
+    absl::optional<double> host_success_rate =
+        accumulator.getSuccessRate(success_rate_request_volume);
+    if (host_success_rate) {
+      success_rate_hosts_.push_back(host.first);
+      success_rates_.push_back(host_success_rate.value());
+      host.second->successRate(host_success_rate.value());
+    }
+
+    absl::optional<double> host_latency =
+        accumulator.getAverageResponseTime(success_rate_request_volume);
+    if (host_latency) {
+      latency_hosts_.push_back(host.first);
+      latencies_.push_back(host_latency.value());
+    }
   }
 
   processSuccessRateEjections();
+  processLatencyEjections();
 
   armIntervalTimer();
 }
@@ -492,6 +605,7 @@ void EventLoggerImpl::logEject(HostDescriptionConstSharedPtr host, Detector& det
   switch (type) {
   case EjectionType::Consecutive5xx:
   case EjectionType::ConsecutiveGatewayFailure:
+  case EjectionType::Latency:
     file_->write(fmt::format(
         json_5xx, AccessLogDateTimeFormatter::fromTime(now),
         secsSinceLastAction(host->outlierDetector().lastUnejectionTime(), monotonic_now),
@@ -538,6 +652,8 @@ std::string EventLoggerImpl::typeToString(EjectionType type) {
     return "GatewayFailure";
   case EjectionType::SuccessRate:
     return "SuccessRate";
+  case EjectionType::Latency:
+    return "Latency";
   }
 
   NOT_REACHED_GCOVR_EXCL_LINE;
@@ -555,10 +671,12 @@ SuccessRateAccumulatorBucket* SuccessRateAccumulator::updateCurrentWriter() {
   // Right now current is being written to and backup is not. Flush the backup and swap.
   backup_success_rate_bucket_->success_request_counter_ = 0;
   backup_success_rate_bucket_->total_request_counter_ = 0;
+  backup_success_rate_bucket_->response_time_counter_ = 0;
+  backup_success_rate_bucket_->response_time_total_ms_ = 0;
 
-  current_success_rate_bucket_.swap(backup_success_rate_bucket_);
+  std::swap(current_success_rate_bucket_, backup_success_rate_bucket_);
 
-  return current_success_rate_bucket_.get();
+  return current_success_rate_bucket_;
 }
 
 absl::optional<double>
@@ -571,6 +689,18 @@ SuccessRateAccumulator::getSuccessRate(uint64_t success_rate_request_volume) {
                                 backup_success_rate_bucket_->total_request_counter_);
 }
 
+absl::optional<double>
+SuccessRateAccumulator::getAverageResponseTime(uint64_t request_volume) {
+  const uint64_t response_time_counter = backup_success_rate_bucket_->response_time_counter_;
+  if (response_time_counter == 0 || response_time_counter < request_volume) {
+    return absl::optional<double>();
+  }
+
+  return absl::optional<double>(
+      static_cast<double>(backup_success_rate_bucket_->response_time_total_ms_) /
+      response_time_counter);
+}
+
 } // namespace Outlier
 } // namespace Upstream
 } // namespace Envoy
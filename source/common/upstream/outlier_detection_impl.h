@@ -52,19 +52,11 @@ public:
                                             EventLoggerSharedPtr event_logger);
 };
 
-/**
- * Thin struct to facilitate calculations for success rate outlier detection.
- */
-struct HostSuccessRatePair {
-  HostSuccessRatePair(HostSharedPtr host, double success_rate)
-      : host_(host), success_rate_(success_rate) {}
-  HostSharedPtr host_;
-  double success_rate_;
-};
-
 struct SuccessRateAccumulatorBucket {
-  std::atomic<uint64_t> success_request_counter_;
-  std::atomic<uint64_t> total_request_counter_;
+  std::atomic<uint64_t> success_request_counter_{0};
+  std::atomic<uint64_t> total_request_counter_{0};
+  std::atomic<uint64_t> response_time_counter_{0};
+  std::atomic<uint64_t> response_time_total_ms_{0};
 };
 
 /**
@@ -74,10 +66,6 @@ struct SuccessRateAccumulatorBucket {
  */
 class SuccessRateAccumulator {
 public:
-  SuccessRateAccumulator()
-      : current_success_rate_bucket_(new SuccessRateAccumulatorBucket()),
-        backup_success_rate_bucket_(new SuccessRateAccumulatorBucket()) {}
-
   /**
    * This function updates the bucket to write data to.
    * @return a pointer to the SuccessRateAccumulatorBucket.
@@ -93,10 +81,21 @@ public:
    * requests, an invalid absl::optional<double> is returned.
    */
   absl::optional<double> getSuccessRate(uint64_t success_rate_request_volume);
+  /**
+   * This function returns the average response time of a host over the same window of time as
+   * getSuccessRate() if enough response times were recorded.
+   * @param request_volume the threshold of response times an accumulator has to have in order to
+   *                       be able to return a significant average.
+   * @return a valid absl::optional<double> with the average response time in milliseconds. If
+   * there were not enough responses, an invalid absl::optional<double> is returned.
+   */
+  absl::optional<double> getAverageResponseTime(uint64_t request_volume);
 
 private:
-  std::unique_ptr<SuccessRateAccumulatorBucket> current_success_rate_bucket_;
-  std::unique_ptr<SuccessRateAccumulatorBucket> backup_success_rate_bucket_;
+  // The buckets are stored inline to avoid two allocations per host.
+  SuccessRateAccumulatorBucket buckets_[2];
+  SuccessRateAccumulatorBucket* current_success_rate_bucket_{&buckets_[0]};
+  SuccessRateAccumulatorBucket* backup_success_rate_bucket_{&buckets_[1]};
 };
 
 class DetectorImpl;
@@ -125,7 +124,7 @@ public:
   uint32_t numEjections() override { return num_ejections_; }
   void putHttpResponseCode(uint64_t response_code) override;
   void putResult(Result result) override;
-  void putResponseTime(std::chrono::milliseconds) override {}
+  void putResponseTime(std::chrono::milliseconds response_time) override;
   const absl::optional<MonotonicTime>& lastEjectionTime() override { return last_ejection_time_; }
   const absl::optional<MonotonicTime>& lastUnejectionTime() override {
     return last_unejection_time_;
@@ -161,7 +160,9 @@ private:
   COUNTER(ejections_detected_success_rate)                                                         \
   COUNTER(ejections_enforced_success_rate)                                                         \
   COUNTER(ejections_detected_consecutive_gateway_failure)                                          \
-  COUNTER(ejections_enforced_consecutive_gateway_failure)
+  COUNTER(ejections_enforced_consecutive_gateway_failure)                                          \
+  COUNTER(ejections_detected_latency)                                                              \
+  COUNTER(ejections_enforced_latency)
 // clang-format on
 
 /**
@@ -189,6 +190,9 @@ public:
   uint64_t enforcingConsecutive5xx() { return enforcing_consecutive_5xx_; }
   uint64_t enforcingConsecutiveGatewayFailure() { return enforcing_consecutive_gateway_failure_; }
   uint64_t enforcingSuccessRate() { return enforcing_success_rate_; }
+  bool staggerInterval() { return stagger_interval_; }
+  uint64_t latencyStdevFactor() { return latency_stdev_factor_; }
+  uint64_t enforcingLatency() { return enforcing_latency_; }
 
 private:
   const uint64_t interval_ms_;
@@ -202,6 +206,9 @@ private:
   const uint64_t enforcing_consecutive_5xx_;
   const uint64_t enforcing_consecutive_gateway_failure_;
   const uint64_t enforcing_success_rate_;
+  const bool stagger_interval_;
+  const uint64_t latency_stdev_factor_;
+  const uint64_t enforcing_latency_;
 };
 
 /**
@@ -245,6 +252,7 @@ private:
   bool enforceEjection(EjectionType type);
   void updateEnforcedEjectionStats(EjectionType type);
   void processSuccessRateEjections();
+  void processLatencyEjections();
 
   DetectorConfig config_;
   Event::Dispatcher& dispatcher_;
@@ -257,6 +265,13 @@ private:
   EventLoggerSharedPtr event_logger_;
   double success_rate_average_;
   double success_rate_ejection_threshold_;
+  // Hosts with enough request volume in the last interval and their success rates and average
+  // response times, kept as parallel arrays that are reused across intervals so the aggregation
+  // runs over contiguous data without allocating.
+  std::vector<HostSharedPtr> success_rate_hosts_;
+  std::vector<double> success_rates_;
+  std::vector<HostSharedPtr> latency_hosts_;
+  std::vector<double> latencies_;
 };
 
 class EventLoggerImpl : public EventLogger {
@@ -284,7 +299,7 @@ private:
 class Utility {
 public:
   struct EjectionPair {
-    double success_rate_average_;
+    double average_;
     double ejection_threshold_;
   };
 
@@ -292,15 +307,25 @@ public:
    * This function returns an EjectionPair for success rate outlier detection. The pair contains
    * the average success rate of all valid hosts in the cluster and the ejection threshold.
    * If a host's success rate is under this threshold, the host is an outlier.
-   * @param success_rate_sum is the sum of the data in the success_rate_data vector.
-   * @param valid_success_rate_hosts is the vector containing the individual success rate data
-   *        points.
+   * @param success_rates is the vector containing the individual success rate data points.
+   * @param success_rate_stdev_factor is the number of standard deviations below the average at
+   *        which the threshold is placed.
+   * @return EjectionPair.
+   */
+  static EjectionPair successRateEjectionThreshold(const std::vector<double>& success_rates,
+                                                   double success_rate_stdev_factor);
+
+  /**
+   * This function returns an EjectionPair for latency outlier detection. The pair contains the
+   * mean of the average response times of all valid hosts in the cluster and the ejection
+   * threshold. If a host's average response time is above this threshold, the host is an outlier.
+   * @param latencies is the vector containing the individual average response times.
+   * @param latency_stdev_factor is the number of standard deviations above the average at which
+   *        the threshold is placed.
    * @return EjectionPair.
    */
-  static EjectionPair
-  successRateEjectionThreshold(double success_rate_sum,
-                               const std::vector<HostSuccessRatePair>& valid_success_rate_hosts,
-                               double success_rate_stdev_factor);
+  static EjectionPair latencyEjectionThreshold(const std::vector<double>& latencies,
+                                               double latency_stdev_factor);
 };
 
 } // namespace Outlier
@@ -0,0 +1,123 @@
+#include "common/upstream/resource_manager_impl.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+namespace Envoy {
+namespace Upstream {
+
+namespace {
+
+// Assigns threads to shards round robin, the first time they lease resources.
+std::atomic<uint32_t> next_shard_{0};
+
+} // namespace
+
+ResourceManagerImpl::ResourceImpl::~ResourceImpl() {
+  Shard* shards = shards_.load();
+  if (shards != nullptr) {
+    for (uint32_t i = 0; i < NumShards; i++) {
+      current_ -= shards[i].spare_;
+    }
+    delete[] shards;
+  }
+  ASSERT(current_ == 0);
+}
+
+ResourceManagerImpl::ResourceImpl::Shard* ResourceManagerImpl::ResourceImpl::shard() {
+  Shard* shards = shards_.load(std::memory_order_acquire);
+  if (shards == nullptr) {
+    return nullptr;
+  }
+  static thread_local const uint32_t index = next_shard_++ % NumShards;
+  return &shards[index];
+}
+
+bool ResourceManagerImpl::ResourceImpl::takeSpare(Shard& shard) {
+  uint64_t spare = shard.spare_.load(std::memory_order_relaxed);
+  while (spare > 0) {
+    if (shard.spare_.compare_exchange_weak(spare, spare - 1, std::memory_order_relaxed)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ResourceManagerImpl::ResourceImpl::canCreate() {
+  Shard* shard = this->shard();
+  if (shard != nullptr && shard->spare_.load(std::memory_order_relaxed) > 0) {
+    return true;
+  }
+  return current_ < max();
+}
+
+void ResourceManagerImpl::ResourceImpl::inc() {
+  Shard* shard = this->shard();
+  if (shard != nullptr && takeSpare(*shard)) {
+    return;
+  }
+
+  // Lease a batch of resources, as long as that leaves the shared count within the maximum.
+  const auto& snapshot = runtime_.snapshot();
+  const uint64_t lease_percent =
+      std::min<uint64_t>(snapshot.getInteger(lease_percent_key_, 0), 100);
+  uint64_t lease_size = 1;
+  if (lease_percent > 0) {
+    const uint64_t max = snapshot.getInteger(runtime_key_, max_);
+    lease_size = std::max<uint64_t>(max * lease_percent / 100 / NumShards, 1);
+    if (current_.load(std::memory_order_relaxed) + lease_size > max) {
+      lease_size = 1;
+    }
+  }
+  lease_size_.store(lease_size, std::memory_order_relaxed);
+  current_ += lease_size;
+  if (lease_size == 1) {
+    return;
+  }
+
+  if (shard == nullptr) {
+    Shard* shards = new Shard[NumShards];
+    Shard* expected = nullptr;
+    if (!shards_.compare_exchange_strong(expected, shards, std::memory_order_acq_rel)) {
+      delete[] shards;
+    }
+    shard = this->shard();
+  }
+  shard->spare_ += lease_size - 1;
+}
+
+void ResourceManagerImpl::ResourceImpl::dec() {
+  Shard* shard = this->shard();
+  if (shard == nullptr) {
+    ASSERT(current_ > 0);
+    current_--;
+    return;
+  }
+
+  // Keep the resource for reuse, and return the spares to the shared count once there are a whole
+  // lease of them.
+  if (shard->spare_.fetch_add(1, std::memory_order_relaxed) + 1 >=
+      lease_size_.load(std::memory_order_relaxed)) {
+    const uint64_t spare = shard->spare_.exchange(0, std::memory_order_relaxed);
+    ASSERT(current_ >= spare);
+    current_ -= spare;
+  }
+}
+
+bool ResourceManagerImpl::RetryBudgetImpl::canCreate() {
+  if (current_ < max()) {
+    return true;
+  }
+  budget_.exhausted_.inc();
+  return false;
+}
+
+uint64_t ResourceManagerImpl::RetryBudgetImpl::max() {
+  const uint64_t active = pending_requests_.count() + requests_.count();
+  return std::max<uint64_t>(active * budget_.budget_percent_ / 100,
+                            budget_.min_retry_concurrency_);
+}
+
+} // namespace Upstream
+} // namespace Envoy
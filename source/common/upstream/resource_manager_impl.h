@@ -6,9 +6,13 @@
 #include <string>
 
 #include "envoy/runtime/runtime.h"
+#include "envoy/stats/stats.h"
 #include "envoy/upstream/resource_manager.h"
 
 #include "common/common/assert.h"
+#include "common/runtime/key_registry.h"
+
+#include "absl/types/optional.h"
 
 namespace Envoy {
 namespace Upstream {
@@ -21,48 +25,129 @@ namespace Upstream {
  *    occur during high contention.
  * 2) Though atomics are used, it is possible for resources to temporarily go above the supplied
  *    maximums. This should not effect overall behavior.
+ * 3) If the <runtime_key>lease_percent runtime key is set, threads lease the resources they create
+ *    from the shared count in batches and keep the ones they release for reuse, so that most
+ *    inc() and dec() calls only touch a per thread shard instead of contending on the shared
+ *    count. Up to about lease_percent of the maximum may then sit unused in the shards, which
+ *    makes the limit that much stricter. By default the count is exact.
+ * 4) If a retry budget is given, it bounds the active retries instead of the retries maximum. The
+ *    budget is taken of the active and pending request counts, which include the resources leased
+ *    by the shards, so it can be more lenient by as much as the lease percent.
  */
 class ResourceManagerImpl : public ResourceManager {
 public:
+  struct RetryBudget {
+    // The active retries allowed, as a percentage of the active and pending requests.
+    double budget_percent_;
+    // The active retries allowed whatever the active and pending requests.
+    uint32_t min_retry_concurrency_;
+    // Incremented whenever a retry is denied by the budget.
+    Stats::Counter& exhausted_;
+  };
+
   ResourceManagerImpl(Runtime::Loader& runtime, const std::string& runtime_key,
                       uint64_t max_connections, uint64_t max_pending_requests,
-                      uint64_t max_requests, uint64_t max_retries)
-      : connections_(max_connections, runtime, runtime_key + "max_connections"),
-        pending_requests_(max_pending_requests, runtime, runtime_key + "max_pending_requests"),
-        requests_(max_requests, runtime, runtime_key + "max_requests"),
-        retries_(max_retries, runtime, runtime_key + "max_retries") {}
+                      uint64_t max_requests, uint64_t max_retries,
+                      const absl::optional<RetryBudget>& retry_budget = absl::nullopt)
+      : lease_percent_key_(Runtime::KeyRegistry::registerKey(runtime_key + "lease_percent")),
+        connections_(max_connections, runtime, runtime_key + "max_connections",
+                     lease_percent_key_),
+        pending_requests_(max_pending_requests, runtime, runtime_key + "max_pending_requests",
+                          lease_percent_key_),
+        requests_(max_requests, runtime, runtime_key + "max_requests", lease_percent_key_),
+        retries_(max_retries, runtime, runtime_key + "max_retries", lease_percent_key_) {
+    if (retry_budget) {
+      retry_budget_ =
+          std::make_unique<RetryBudgetImpl>(retry_budget.value(), pending_requests_, requests_);
+    }
+  }
 
   // Upstream::ResourceManager
   Resource& connections() override { return connections_; }
   Resource& pendingRequests() override { return pending_requests_; }
   Resource& requests() override { return requests_; }
-  Resource& retries() override { return retries_; }
+  Resource& retries() override {
+    if (retry_budget_) {
+      return *retry_budget_;
+    }
+    return retries_;
+  }
+
+  static const uint32_t NumShards = 16;
 
 private:
   struct ResourceImpl : public Resource {
-    ResourceImpl(uint64_t max, Runtime::Loader& runtime, const std::string& runtime_key)
-        : max_(max), runtime_(runtime), runtime_key_(runtime_key) {}
-    ~ResourceImpl() { ASSERT(current_ == 0); }
+    ResourceImpl(uint64_t max, Runtime::Loader& runtime, const std::string& runtime_key,
+                 const Runtime::KeyHandle& lease_percent_key)
+        : max_(max), runtime_(runtime),
+          runtime_key_(Runtime::KeyRegistry::registerKey(runtime_key)),
+          lease_percent_key_(lease_percent_key) {}
+    ~ResourceImpl();
 
     // Upstream::Resource
-    bool canCreate() override { return current_ < max(); }
+    bool canCreate() override;
+    void inc() override;
+    void dec() override;
+    uint64_t max() override { return runtime_.snapshot().getInteger(runtime_key_, max_); }
+
+    // The resources in use, plus the spare ones leased by the shards.
+    uint64_t count() const { return current_.load(std::memory_order_relaxed); }
+
+    struct Shard {
+      // Resources leased from current_ which are not in use.
+      std::atomic<uint64_t> spare_{0};
+      // Keep shards on separate cache lines.
+      char padding_[64 - sizeof(uint64_t)];
+    };
+
+    // The shard of the calling thread, or nullptr if no thread leased resources yet.
+    Shard* shard();
+    // Takes a spare resource of a shard, if it has one.
+    static bool takeSpare(Shard& shard);
+
+    const uint64_t max_;
+    // Resources in use, plus the spare ones leased by the shards.
+    std::atomic<uint64_t> current_{};
+    // The number of resources leased at once, as of the last lease.
+    std::atomic<uint64_t> lease_size_{1};
+    // Allocated by the first lease of more than one resource, since most clusters never need them.
+    std::atomic<Shard*> shards_{};
+    Runtime::Loader& runtime_;
+    const Runtime::KeyHandle runtime_key_;
+    const Runtime::KeyHandle& lease_percent_key_;
+  };
+
+  /**
+   * Active retries bounded by a share of the active and pending requests. Retries are few next to
+   * requests, so they are counted exactly.
+   */
+  struct RetryBudgetImpl : public Resource {
+    RetryBudgetImpl(const RetryBudget& budget, const ResourceImpl& pending_requests,
+                    const ResourceImpl& requests)
+        : budget_(budget), pending_requests_(pending_requests), requests_(requests) {}
+    ~RetryBudgetImpl() { ASSERT(current_ == 0); }
+
+    // Upstream::Resource
+    bool canCreate() override;
     void inc() override { current_++; }
     void dec() override {
       ASSERT(current_ > 0);
       current_--;
     }
-    uint64_t max() override { return runtime_.snapshot().getInteger(runtime_key_, max_); }
+    uint64_t max() override;
 
-    const uint64_t max_;
+    const RetryBudget budget_;
+    const ResourceImpl& pending_requests_;
+    const ResourceImpl& requests_;
     std::atomic<uint64_t> current_{};
-    Runtime::Loader& runtime_;
-    const std::string runtime_key_;
   };
 
+  const Runtime::KeyHandle lease_percent_key_;
   ResourceImpl connections_;
   ResourceImpl pending_requests_;
   ResourceImpl requests_;
   ResourceImpl retries_;
+  std::unique_ptr<RetryBudgetImpl> retry_budget_;
 };
 
 typedef std::unique_ptr<ResourceManagerImpl> ResourceManagerImplPtr;
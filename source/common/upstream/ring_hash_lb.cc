@@ -1,8 +1,11 @@
 #include "common/upstream/ring_hash_lb.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <iostream>
+#include <limits>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "common/common/assert.h"
@@ -21,62 +24,56 @@ RingHashLoadBalancer::RingHashLoadBalancer(
     : ThreadAwareLoadBalancerBase(priority_set, stats, runtime, random, common_config),
       config_(config) {}
 
+RingHashLoadBalancer::HashingLoadBalancerSharedPtr
+RingHashLoadBalancer::createLoadBalancer(const HostSet& host_set) {
+  // Currently we specify the minimum size of the ring, and determine the replication factor
+  // based on the number of hosts. It's possible we might want to support more sophisticated
+  // configuration in the future.
+  const uint64_t min_ring_size =
+      config_ ? PROTOBUF_GET_WRAPPED_OR_DEFAULT(config_.value(), minimum_ring_size, 1024) : 1024;
+  const bool use_std_hash =
+      config_ ? PROTOBUF_GET_WRAPPED_OR_DEFAULT(config_.value().deprecated_v1(), use_std_hash, true)
+              : true;
+
+  // Note that we only compute global panic on host set refresh. Given that the runtime setting
+  // will rarely change, this is a reasonable compromise to avoid creating extra LBs when we only
+  // need to create one per priority level.
+  return std::make_shared<Ring>(isGlobalPanic(host_set) ? host_set.hosts()
+                                                        : host_set.healthyHosts(),
+                                min_ring_size, use_std_hash);
+}
+
 HostConstSharedPtr RingHashLoadBalancer::Ring::chooseHost(uint64_t h) const {
-  if (ring_.empty()) {
+  if (hashes_.empty()) {
     return nullptr;
   }
 
-  // Ported from https://github.com/RJ/ketama/blob/master/libketama/ketama.c (ketama_get_server)
-  // I've generally kept the variable names to make the code easier to compare.
-  // NOTE: The algorithm depends on using signed integers for lowp, midp, and highp. Do not
-  //       change them!
-  int64_t lowp = 0;
-  int64_t highp = ring_.size();
-  while (true) {
-    int64_t midp = (lowp + highp) / 2;
-
-    if (midp == static_cast<int64_t>(ring_.size())) {
-      return ring_[0].host_;
-    }
-
-    uint64_t midval = ring_[midp].hash_;
-    uint64_t midval1 = midp == 0 ? 0 : ring_[midp - 1].hash_;
-
-    if (h <= midval && h > midval1) {
-      return ring_[midp].host_;
-    }
-
-    if (midval < h) {
-      lowp = midp + 1;
-    } else {
-      highp = midp - 1;
-    }
+  return hosts_[host_indexes_[position(h)]];
+}
 
-    if (lowp > highp) {
-      return ring_[0].host_;
-    }
-  }
+uint64_t RingHashLoadBalancer::Ring::position(uint64_t h) const {
+  // As in ketama, pick the first entry whose hash is at least h, wrapping around to the first
+  // entry. All the hashes before the bucket of h are smaller and all the hashes after it are
+  // larger, so that entry is in the bucket or is the first entry of the next one.
+  const uint64_t bucket = index_bits_ == 0 ? 0 : h >> (64 - index_bits_);
+  const auto first = hashes_.begin() + index_[bucket];
+  const auto last = hashes_.begin() + index_[bucket + 1];
+  const uint64_t entry = std::lower_bound(first, last, h) - hashes_.begin();
+  return entry == hashes_.size() ? 0 : entry;
 }
 
-RingHashLoadBalancer::Ring::Ring(
-    const absl::optional<envoy::api::v2::Cluster::RingHashLbConfig>& config,
-    const HostVector& hosts) {
+RingHashLoadBalancer::Ring::Ring(const HostVector& hosts, uint64_t min_ring_size,
+                                 bool use_std_hash) {
   ENVOY_LOG(trace, "ring hash: building ring");
   if (hosts.empty()) {
     return;
   }
 
-  // Currently we specify the minimum size of the ring, and determine the replication factor
-  // based on the number of hosts. It's possible we might want to support more sophisticated
-  // configuration in the future.
   // NOTE: Currently we keep a ring for healthy hosts and unhealthy hosts, and this is done per
   //       thread. This is the simplest implementation, but it's expensive from a memory
   //       standpoint and duplicates the regeneration computation. In the future we might want
   //       to generate the rings centrally and then just RCU them out to each thread. This is
   //       sufficient for getting started.
-  const uint64_t min_ring_size =
-      config ? PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.value(), minimum_ring_size, 1024) : 1024;
-
   uint64_t hashes_per_host = 1;
   if (hosts.size() < min_ring_size) {
     hashes_per_host = min_ring_size / hosts.size();
@@ -86,15 +83,18 @@ RingHashLoadBalancer::Ring::Ring(
   }
 
   ENVOY_LOG(info, "ring hash: min_ring_size={} hashes_per_host={}", min_ring_size, hashes_per_host);
-  ring_.reserve(hosts.size() * hashes_per_host);
+  const uint64_t ring_size = hosts.size() * hashes_per_host;
+  RELEASE_ASSERT(ring_size <= std::numeric_limits<uint32_t>::max(), "");
+  hosts_ = hosts;
 
-  const bool use_std_hash =
-      config ? PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.value().deprecated_v1(), use_std_hash, true)
-             : true;
+  // Build and sort plain (hash, host index) pairs, which are cheap to move around, and only then
+  // split them into the lookup arrays.
+  std::vector<std::pair<uint64_t, uint32_t>> ring;
+  ring.reserve(ring_size);
 
   char hash_key_buffer[196];
-  for (const auto& host : hosts) {
-    const std::string& address_string = host->address()->asString();
+  for (uint32_t host_index = 0; host_index < hosts.size(); host_index++) {
+    const std::string& address_string = hosts[host_index]->address()->asString();
     uint64_t offset_start = address_string.size();
 
     // Currently, we support both IP and UDS addresses. The UDS max path length is ~108 on all Unix
@@ -119,19 +119,40 @@ RingHashLoadBalancer::Ring::Ring(
       const uint64_t hash = use_std_hash ? std::hash<std::string>()(std::string(hash_key))
                                          : HashUtil::xxHash64(hash_key);
       ENVOY_LOG(trace, "ring hash: hash_key={} hash={}", hash_key.data(), hash);
-      ring_.push_back({hash, host});
+      ring.push_back({hash, host_index});
     }
   }
 
-  std::sort(ring_.begin(), ring_.end(), [](const RingEntry& lhs, const RingEntry& rhs) -> bool {
-    return lhs.hash_ < rhs.hash_;
-  });
+  std::sort(ring.begin(), ring.end());
+  hashes_.reserve(ring_size);
+  host_indexes_.reserve(ring_size);
+  for (const auto& entry : ring) {
+    hashes_.push_back(entry.first);
+    host_indexes_.push_back(entry.second);
+  }
   if (ENVOY_LOG_CHECK_LEVEL(trace)) {
-    for (const auto& entry : ring_) {
-      ENVOY_LOG(trace, "ring hash: host={} hash={}", entry.host_->address()->asString(),
-                entry.hash_);
+    for (const auto& entry : ring) {
+      ENVOY_LOG(trace, "ring hash: host={} hash={}", hosts_[entry.second]->address()->asString(),
+                entry.first);
+    }
+  }
+
+  // Size the index to the largest power of two number of buckets that keeps the expected number
+  // of entries per bucket.
+  while (index_bits_ < 32 && (ring_size >> (index_bits_ + 1)) >= EntriesPerBucket) {
+    index_bits_++;
+  }
+  const uint64_t num_buckets = 1ULL << index_bits_;
+  index_.reserve(num_buckets + 1);
+  uint64_t position = 0;
+  for (uint64_t bucket = 0; bucket < num_buckets; bucket++) {
+    while (position < ring_size && index_bits_ != 0 &&
+           (hashes_[position] >> (64 - index_bits_)) < bucket) {
+      position++;
     }
+    index_.push_back(position);
   }
+  index_.push_back(ring_size);
 }
 
 } // namespace Upstream
@@ -5,6 +5,7 @@
 #include "envoy/runtime/runtime.h"
 
 #include "common/common/logger.h"
+#include "common/memory/huge_page_arena.h"
 #include "common/upstream/thread_aware_lb_impl.h"
 
 namespace Envoy {
@@ -17,7 +18,7 @@ namespace Upstream {
  * In the future it would be nice to support:
  * 1) Weighting.
  * 2) Per-zone rings and optional zone aware routing (not all applications will want this).
- * 3) Max request fallback to support hot shards (not all applications will want this).
+ * Falling back to other hosts to support hot shards is done by BoundedLoadRingHashLoadBalancer.
  */
 class RingHashLoadBalancer : public ThreadAwareLoadBalancerBase,
                              Logger::Loggable<Logger::Id::upstream> {
@@ -27,34 +28,39 @@ public:
                        const absl::optional<envoy::api::v2::Cluster::RingHashLbConfig>& config,
                        const envoy::api::v2::Cluster::CommonLbConfig& common_config);
 
-private:
-  struct RingEntry {
-    uint64_t hash_;
-    HostConstSharedPtr host_;
-  };
-
+  /**
+   * The ring is kept as a sorted array of hashes, with the index of the host owning each hash in a
+   * parallel array, so that lookups only touch the hashes. A small index of where each range of
+   * hashes starts, keyed by their top bits, narrows the search to a few adjacent cache lines.
+   */
   struct Ring : public HashingLoadBalancer {
-    Ring(const absl::optional<envoy::api::v2::Cluster::RingHashLbConfig>& config,
-         const HostVector& hosts);
+    Ring(const HostVector& hosts, uint64_t min_ring_size, bool use_std_hash);
 
     // ThreadAwareLoadBalancerBase::HashingLoadBalancer
     HostConstSharedPtr chooseHost(uint64_t hash) const override;
 
-    std::vector<RingEntry> ring_;
+    /**
+     * @return uint64_t the position in the ring of the entry owning the given hash. The ring must
+     *         not be empty.
+     */
+    uint64_t position(uint64_t hash) const;
+
+    // Expected number of ring entries per index bucket.
+    static constexpr uint64_t EntriesPerBucket = 8;
+
+    HostVector hosts_;
+    Memory::HugePageVector<uint64_t> hashes_;
+    Memory::HugePageVector<uint32_t> host_indexes_;
+    // For each bucket i, the position of the first hash whose top index_bits_ bits are at least
+    // i, followed by the size of the ring.
+    Memory::HugePageVector<uint32_t> index_;
+    uint32_t index_bits_{};
   };
   typedef std::shared_ptr<const Ring> RingConstSharedPtr;
 
+private:
   // ThreadAwareLoadBalancerBase
-  HashingLoadBalancerSharedPtr createLoadBalancer(const HostSet& host_set) override {
-    // Note that we only compute global panic on host set refresh. Given that the runtime setting
-    // will rarely change, this is a reasonable compromise to avoid creating extra LBs when we only
-    // need to create one per priority level.
-    if (isGlobalPanic(host_set)) {
-      return std::make_shared<Ring>(config_, host_set.hosts());
-    } else {
-      return std::make_shared<Ring>(config_, host_set.healthyHosts());
-    }
-  }
+  HashingLoadBalancerSharedPtr createLoadBalancer(const HostSet& host_set) override;
 
   const absl::optional<envoy::api::v2::Cluster::RingHashLbConfig>& config_;
 };
@@ -1,5 +1,6 @@
 #include "common/upstream/subset_lb.h"
 
+#include <algorithm>
 #include <unordered_set>
 
 #include "envoy/api/v2/cds.pb.h"
@@ -9,6 +10,7 @@
 #include "common/config/metadata.h"
 #include "common/config/well_known_names.h"
 #include "common/protobuf/utility.h"
+#include "common/upstream/bounded_load_ring_hash_lb.h"
 #include "common/upstream/load_balancer_impl.h"
 #include "common/upstream/maglev_lb.h"
 #include "common/upstream/ring_hash_lb.h"
@@ -21,9 +23,18 @@ SubsetLoadBalancer::SubsetLoadBalancer(
     ClusterStats& stats, Runtime::Loader& runtime, Runtime::RandomGenerator& random,
     const LoadBalancerSubsetInfo& subsets,
     const absl::optional<envoy::api::v2::Cluster::RingHashLbConfig>& lb_ring_hash_config,
-    const envoy::api::v2::Cluster::CommonLbConfig& common_config)
-    : lb_type_(lb_type), lb_ring_hash_config_(lb_ring_hash_config), common_config_(common_config),
-      stats_(stats), runtime_(runtime), random_(random), fallback_policy_(subsets.fallbackPolicy()),
+    const absl::optional<envoy::api::v2::Cluster::MaglevLbConfig>& lb_maglev_config,
+    const absl::optional<envoy::api::v2::Cluster::BoundedLoadRingHashLbConfig>&
+        lb_bounded_load_ring_hash_config,
+    const absl::optional<envoy::api::v2::Cluster::LeastRequestLbConfig>& lb_least_request_config,
+    const envoy::api::v2::Cluster::CommonLbConfig& common_config, TimeSource& time_source)
+    : lb_type_(lb_type), lb_ring_hash_config_(lb_ring_hash_config),
+      lb_maglev_config_(lb_maglev_config),
+      lb_bounded_load_ring_hash_config_(lb_bounded_load_ring_hash_config),
+      lb_least_request_config_(lb_least_request_config),
+      common_config_(common_config),
+      stats_(stats), runtime_(runtime), random_(random), time_source_(time_source),
+      fallback_policy_(subsets.fallbackPolicy()),
       default_subset_metadata_(subsets.defaultSubset().fields().begin(),
                                subsets.defaultSubset().fields().end()),
       subset_keys_(subsets.subsetKeys()), original_priority_set_(priority_set),
@@ -43,9 +54,9 @@ SubsetLoadBalancer::SubsetLoadBalancer(
           // the right subsets.
           //
           // Note, note, note: if metadata for existing endpoints changed _and_ hosts were also
-          // added or removed, we don't need to hit this path. That's fine, given that
-          // findOrCreateSubset() will be called from processSubsets because it'll be triggered by
-          // either hosts_added or hosts_removed. That's where the new subsets will be created.
+          // added or removed, we don't need to hit this path. That's fine, given that update()
+          // matches all the hosts of the priority against the subset keys. That's where the new
+          // subsets will be created.
           refreshSubsets(priority);
         } else {
           // This is a regular update with deltas.
@@ -58,7 +69,7 @@ SubsetLoadBalancer::~SubsetLoadBalancer() {
   original_priority_set_callback_handle_->remove();
 
   // Ensure gauges reflect correct values.
-  forEachSubset(subsets_, [&](LbSubsetEntryPtr entry) {
+  forEachSubset([&](LbSubsetEntryPtr entry) {
     if (entry->initialized() && entry->active()) {
       stats_.lb_subsets_removed_.inc();
       stats_.lb_subsets_active_.dec();
@@ -109,7 +120,7 @@ HostConstSharedPtr SubsetLoadBalancer::tryChooseHostFromContext(LoadBalancerCont
   }
 
   // Route has metadata match criteria defined, see if we have a matching subset.
-  LbSubsetEntryPtr entry = findSubset(match_criteria->metadataMatchCriteria());
+  LbSubsetEntryPtr entry = findSubset(*match_criteria);
   if (entry == nullptr || !entry->active()) {
     // No matching subset or subset not active: use fallback policy.
     return nullptr;
@@ -120,40 +131,15 @@ HostConstSharedPtr SubsetLoadBalancer::tryChooseHostFromContext(LoadBalancerCont
   return entry->priority_subset_->lb_->chooseHost(context);
 }
 
-// Iterates over the given metadata match criteria (which must be lexically sorted by key) and find
-// a matching LbSubsetEnryPtr, if any.
-SubsetLoadBalancer::LbSubsetEntryPtr SubsetLoadBalancer::findSubset(
-    const std::vector<Router::MetadataMatchCriterionConstSharedPtr>& match_criteria) {
-  const LbSubsetMap* subsets = &subsets_;
-
-  // Because the match_criteria and the host metadata used to populate subsets_ are sorted in the
-  // same order, we can iterate over the criteria and perform a lookup for each key and value,
-  // starting with the root LbSubsetMap and using the previous iteration's LbSubsetMap thereafter
-  // (tracked in subsets). If ever a criterion's key or value is not found, there is no subset for
-  // this criteria. If we reach the last criterion, we've found the LbSubsetEntry for the criteria,
-  // which may or may not have a subset attached to it.
-  for (uint32_t i = 0; i < match_criteria.size(); i++) {
-    const Router::MetadataMatchCriterion& match_criterion = *match_criteria[i];
-    const auto& subset_it = subsets->find(match_criterion.name());
-    if (subset_it == subsets->end()) {
-      // No subsets with this key (at this level in the hierarchy).
-      break;
-    }
-
-    const ValueSubsetMap& vs_map = subset_it->second;
-    const auto& vs_it = vs_map.find(match_criterion.value());
-    if (vs_it == vs_map.end()) {
-      // No subsets with this value.
-      break;
-    }
-
-    const LbSubsetEntryPtr& entry = vs_it->second;
-    if (i + 1 == match_criteria.size()) {
-      // We've reached the end of the criteria, and they all matched.
-      return entry;
+// Finds the subset matching the given metadata match criteria (which must be lexically sorted by
+// key), if any. The hash of the criteria is computed along with them, so this is a single lookup.
+SubsetLoadBalancer::LbSubsetEntryPtr
+SubsetLoadBalancer::findSubset(const Router::MetadataMatchCriteria& match_criteria) {
+  const auto range = subsets_.equal_range(match_criteria.hash());
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second->matches(match_criteria.metadataMatchCriteria())) {
+      return it->second;
     }
-
-    subsets = &entry->children_;
   }
 
   return nullptr;
@@ -191,96 +177,129 @@ void SubsetLoadBalancer::updateFallbackSubset(uint32_t priority, const HostVecto
   fallback_subset_->priority_subset_->update(priority, hosts_added, hosts_removed);
 }
 
-// Iterates over the added and removed hosts, looking up an LbSubsetEntryPtr for each. For every
-// unique LbSubsetEntryPtr found, it either invokes new_cb or update_cb depending on whether the
-// LbSubsetEntryPtr is already initialized (update_cb) or not (new_cb). In addition, update_cb is
-// invoked for any otherwise unmodified but active and initialized LbSubsetEntryPtr to allow host
-// health to be updated.
-void SubsetLoadBalancer::processSubsets(
-    const HostVector& hosts_added, const HostVector& hosts_removed,
-    std::function<void(LbSubsetEntryPtr)> update_cb,
-    std::function<void(LbSubsetEntryPtr, HostPredicate, const SubsetMetadata&, bool)> new_cb) {
-  std::unordered_set<LbSubsetEntryPtr> subsets_modified;
-
-  std::pair<const HostVector&, bool> steps[] = {{hosts_added, true}, {hosts_removed, false}};
-  for (const auto& step : steps) {
-    const auto& hosts = step.first;
-    const bool adding_hosts = step.second;
-
-    for (const auto& host : hosts) {
-      for (const auto& keys : subset_keys_) {
-        // For each host, for each subset key, attempt to extract the metadata corresponding to the
-        // key from the host.
-        SubsetMetadata kvs = extractSubsetMetadata(keys, *host);
-        if (!kvs.empty()) {
-          // The host has metadata for each key, find or create its subset.
-          LbSubsetEntryPtr entry = findOrCreateSubset(subsets_, kvs, 0);
-          if (subsets_modified.find(entry) != subsets_modified.end()) {
-            // We've already invoked the callback for this entry.
-            continue;
-          }
-          subsets_modified.emplace(entry);
-
-          if (entry->initialized()) {
-            update_cb(entry);
-          } else {
-            HostPredicate predicate =
-                std::bind(&SubsetLoadBalancer::hostMatches, this, kvs, std::placeholders::_1);
-
-            new_cb(entry, predicate, kvs, adding_hosts);
-          }
+// Given the addition and/or removal of hosts, update all subsets for this priority level, creating
+// new subsets as necessary. Each host of the priority is matched against the subset keys once,
+// which gives the hosts of every subset, rather than filtering all the hosts for each subset.
+void SubsetLoadBalancer::update(uint32_t priority, const HostVector& hosts_added,
+                                const HostVector& hosts_removed) {
+  updateFallbackSubset(priority, hosts_added, hosts_removed);
+
+  const HostSet& host_set = *original_priority_set_.hostSetsPerPriority()[priority];
+  std::unordered_map<LbSubsetEntryPtr, SubsetHosts> subset_hosts;
+  std::unordered_map<HostSharedPtr, std::vector<LbSubsetEntryPtr>> host_subsets;
+
+  for (const auto& host : host_set.hosts()) {
+    std::vector<LbSubsetEntryPtr>& subsets = host_subsets[host];
+    subsets = hostSubsets(*host, true);
+    for (const auto& entry : subsets) {
+      SubsetHosts& hosts = subset_hosts[entry];
+      hosts.hosts_->emplace_back(host);
+      if (host->healthy()) {
+        hosts.healthy_hosts_->emplace_back(host);
+      }
+    }
+  }
+
+  // Hosts are grouped by locality only when there are several localities, see
+  // HostSubsetImpl::update().
+  const std::vector<HostVector>& localities = host_set.hostsPerLocality().get();
+  if (localities.size() > 1) {
+    for (uint32_t i = 0; i < localities.size(); i++) {
+      for (const auto& host : localities[i]) {
+        const auto it = host_subsets.find(host);
+        if (it == host_subsets.end()) {
+          continue;
+        }
+        for (const auto& entry : it->second) {
+          std::vector<HostVector>& hosts_per_locality = subset_hosts[entry].hosts_per_locality_;
+          hosts_per_locality.resize(localities.size());
+          hosts_per_locality[i].emplace_back(host);
         }
       }
     }
   }
 
-  forEachSubset(subsets_, [&](LbSubsetEntryPtr entry) {
-    if (subsets_modified.find(entry) != subsets_modified.end()) {
-      // Already handled due to hosts being added or removed.
+  for (const auto& host : hosts_added) {
+    const auto it = host_subsets.find(host);
+    if (it == host_subsets.end()) {
+      continue;
+    }
+    for (const auto& entry : it->second) {
+      subset_hosts[entry].hosts_added_.emplace_back(host);
+    }
+  }
+
+  // Removed hosts are only looked up, they don't create subsets.
+  for (const auto& host : hosts_removed) {
+    for (const auto& entry : hostSubsets(*host, false)) {
+      subset_hosts[entry].hosts_removed_.emplace_back(host);
+    }
+  }
+
+  forEachSubset([&](LbSubsetEntryPtr entry) {
+    const auto it = subset_hosts.find(entry);
+    if (!entry->initialized()) {
+      if (it == subset_hosts.end() || it->second.hosts_->empty()) {
+        // An uninitialized entry with only removed hosts is a degenerate case and we leave the
+        // entry uninitialized.
+        return;
+      }
+
+      SubsetMetadata kvs;
+      for (const auto& kv : entry->kvs_) {
+        kvs.emplace_back(kv.first, kv.second.value());
+      }
+      ENVOY_LOG(debug, "subset lb: creating load balancer for {}", describeMetadata(kvs));
+
+      // Initialize new entry with hosts and update stats.
+      HostPredicate predicate =
+          std::bind(&SubsetLoadBalancer::hostMatches, this, kvs, std::placeholders::_1);
+      entry->priority_subset_.reset(
+          new PrioritySubsetImpl(*this, predicate, locality_weight_aware_));
+      stats_.lb_subsets_active_.inc();
+      stats_.lb_subsets_created_.inc();
       return;
     }
 
-    if (entry->initialized() && entry->active()) {
-      update_cb(entry);
+    if (it == subset_hosts.end() && !entry->active()) {
+      // Nothing to update.
+      return;
+    }
+
+    const bool active_before = entry->active();
+    SubsetHosts no_hosts;
+    entry->priority_subset_->update(priority, it != subset_hosts.end() ? it->second : no_hosts);
+
+    if (active_before && !entry->active()) {
+      stats_.lb_subsets_active_.dec();
+      stats_.lb_subsets_removed_.inc();
+    } else if (!active_before && entry->active()) {
+      stats_.lb_subsets_active_.inc();
+      stats_.lb_subsets_created_.inc();
     }
   });
 }
 
-// Given the addition and/or removal of hosts, update all subsets for this priority level, creating
-// new subsets as necessary.
-void SubsetLoadBalancer::update(uint32_t priority, const HostVector& hosts_added,
-                                const HostVector& hosts_removed) {
-  updateFallbackSubset(priority, hosts_added, hosts_removed);
+std::vector<SubsetLoadBalancer::LbSubsetEntryPtr>
+SubsetLoadBalancer::hostSubsets(const Host& host, bool create) {
+  std::vector<LbSubsetEntryPtr> subsets;
+  for (const auto& keys : subset_keys_) {
+    // For each subset key, attempt to extract the metadata corresponding to the key from the
+    // host.
+    SubsetMetadata kvs = extractSubsetMetadata(keys, host);
+    if (kvs.empty()) {
+      continue;
+    }
 
-  processSubsets(hosts_added, hosts_removed,
-                 [&](LbSubsetEntryPtr entry) {
-                   const bool active_before = entry->active();
-                   entry->priority_subset_->update(priority, hosts_added, hosts_removed);
-
-                   if (active_before && !entry->active()) {
-                     stats_.lb_subsets_active_.dec();
-                     stats_.lb_subsets_removed_.inc();
-                   } else if (!active_before && entry->active()) {
-                     stats_.lb_subsets_active_.inc();
-                     stats_.lb_subsets_created_.inc();
-                   }
-                 },
-                 [&](LbSubsetEntryPtr entry, HostPredicate predicate, const SubsetMetadata& kvs,
-                     bool adding_host) {
-                   UNREFERENCED_PARAMETER(kvs);
-                   if (adding_host) {
-                     ENVOY_LOG(debug, "subset lb: creating load balancer for {}",
-                               describeMetadata(kvs));
-
-                     // Initialize new entry with hosts and update stats. (An uninitialized entry
-                     // with only removed hosts is a degenerate case and we leave the entry
-                     // uninitialized.)
-                     entry->priority_subset_.reset(
-                         new PrioritySubsetImpl(*this, predicate, locality_weight_aware_));
-                     stats_.lb_subsets_active_.inc();
-                     stats_.lb_subsets_created_.inc();
-                   }
-                 });
+    // The host has metadata for each key, find or create its subset. The same keys may be
+    // listed more than once.
+    LbSubsetEntryPtr entry = findOrCreateSubset(kvs, create);
+    if (entry != nullptr && std::find(subsets.begin(), subsets.end(), entry) == subsets.end()) {
+      subsets.emplace_back(entry);
+    }
+  }
+
+  return subsets;
 }
 
 bool SubsetLoadBalancer::hostMatches(const SubsetMetadata& kvs, const Host& host) {
@@ -358,58 +377,69 @@ std::string SubsetLoadBalancer::describeMetadata(const SubsetLoadBalancer::Subse
   return buf.str();
 }
 
-// Given a vector of key-values (from extractSubsetMetadata), recursively finds the matching
-// LbSubsetEntryPtr.
+// Given a vector of key-values (from extractSubsetMetadata), finds the matching LbSubsetEntryPtr,
+// creating an uninitialized one if there is none and create is true.
 SubsetLoadBalancer::LbSubsetEntryPtr
-SubsetLoadBalancer::findOrCreateSubset(LbSubsetMap& subsets, const SubsetMetadata& kvs,
-                                       uint32_t idx) {
-  ASSERT(idx < kvs.size());
-
-  const std::string& name = kvs[idx].first;
-  const ProtobufWkt::Value& pb_value = kvs[idx].second;
-  const HashedValue value(pb_value);
-  LbSubsetEntryPtr entry;
-
-  const auto& kv_it = subsets.find(name);
-  if (kv_it != subsets.end()) {
-    ValueSubsetMap& value_subset_map = kv_it->second;
-    const auto vs_it = value_subset_map.find(value);
-    if (vs_it != value_subset_map.end()) {
-      entry = vs_it->second;
-    }
+SubsetLoadBalancer::findOrCreateSubset(const SubsetMetadata& kvs, bool create) {
+  HashedSubsetMetadata hashed_kvs;
+  hashed_kvs.reserve(kvs.size());
+  uint64_t hash = 0;
+  for (const auto& kv : kvs) {
+    hashed_kvs.emplace_back(kv.first, HashedValue(kv.second));
+    hash = hashed_kvs.back().second.hashWithName(kv.first, hash);
   }
 
-  if (!entry) {
-    // Not found. Create an uninitialized entry.
-    entry.reset(new LbSubsetEntry());
-    if (kv_it != subsets.end()) {
-      ValueSubsetMap& value_subset_map = kv_it->second;
-      value_subset_map.emplace(value, entry);
-    } else {
-      ValueSubsetMap value_subset_map = {{value, entry}};
-      subsets.emplace(name, value_subset_map);
+  const auto range = subsets_.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second->matches(hashed_kvs)) {
+      return it->second;
     }
   }
 
-  idx++;
-  if (idx == kvs.size()) {
-    // We've matched all the key-values, return the entry.
-    return entry;
+  if (!create) {
+    return nullptr;
   }
 
-  return findOrCreateSubset(entry->children_, kvs, idx);
+  // Not found. Create an uninitialized entry.
+  LbSubsetEntryPtr entry = std::make_shared<LbSubsetEntry>(std::move(hashed_kvs));
+  subsets_.emplace(hash, entry);
+  return entry;
 }
 
-// Invokes cb for each LbSubsetEntryPtr in subsets.
-void SubsetLoadBalancer::forEachSubset(LbSubsetMap& subsets,
-                                       std::function<void(LbSubsetEntryPtr)> cb) {
-  for (auto& vsm : subsets) {
-    for (auto& em : vsm.second) {
-      LbSubsetEntryPtr entry = em.second;
-      cb(entry);
-      forEachSubset(entry->children_, cb);
+// Invokes cb for each LbSubsetEntryPtr.
+void SubsetLoadBalancer::forEachSubset(std::function<void(LbSubsetEntryPtr)> cb) {
+  for (const auto& it : subsets_) {
+    cb(it.second);
+  }
+}
+
+bool SubsetLoadBalancer::LbSubsetEntry::matches(
+    const std::vector<Router::MetadataMatchCriterionConstSharedPtr>& criteria) const {
+  if (criteria.size() != kvs_.size()) {
+    return false;
+  }
+
+  for (uint32_t i = 0; i < kvs_.size(); i++) {
+    if (kvs_[i].first != criteria[i]->name() || kvs_[i].second != criteria[i]->value()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool SubsetLoadBalancer::LbSubsetEntry::matches(const HashedSubsetMetadata& kvs) const {
+  if (kvs.size() != kvs_.size()) {
+    return false;
+  }
+
+  for (uint32_t i = 0; i < kvs_.size(); i++) {
+    if (kvs_[i].first != kvs[i].first || kvs_[i].second != kvs[i].second) {
+      return false;
     }
   }
+
+  return true;
 }
 
 // Initialize a new HostSubsetImpl and LoadBalancer from the SubsetLoadBalancer, filtering hosts
@@ -430,9 +460,15 @@ SubsetLoadBalancer::PrioritySubsetImpl::PrioritySubsetImpl(const SubsetLoadBalan
 
   switch (subset_lb.lb_type_) {
   case LoadBalancerType::LeastRequest:
-    lb_.reset(new LeastRequestLoadBalancer(*this, subset_lb.original_local_priority_set_,
-                                           subset_lb.stats_, subset_lb.runtime_, subset_lb.random_,
-                                           subset_lb.common_config_));
+    lb_.reset(new LeastRequestLoadBalancer(
+        *this, subset_lb.original_local_priority_set_, subset_lb.stats_, subset_lb.runtime_,
+        subset_lb.random_, subset_lb.common_config_, subset_lb.lb_least_request_config_));
+    break;
+
+  case LoadBalancerType::PeakEwma:
+    lb_.reset(new PeakEwmaLoadBalancer(*this, subset_lb.original_local_priority_set_,
+                                       subset_lb.stats_, subset_lb.runtime_, subset_lb.random_,
+                                       subset_lb.common_config_, subset_lb.time_source_));
     break;
 
   case LoadBalancerType::Random:
@@ -462,8 +498,18 @@ SubsetLoadBalancer::PrioritySubsetImpl::PrioritySubsetImpl(const SubsetLoadBalan
     // TODO(mattklein123): The Maglev LB is thread aware, but currently the subset LB is not.
     // We should make the subset LB thread aware since the calculations are costly, and then we
     // can also use a thread aware sub-LB properly. The following works fine but is not optimal.
-    thread_aware_lb_.reset(new MaglevLoadBalancer(*this, subset_lb.stats_, subset_lb.runtime_,
-                                                  subset_lb.random_, subset_lb.common_config_));
+    thread_aware_lb_.reset(new MaglevLoadBalancer(
+        *this, subset_lb.stats_, subset_lb.runtime_, subset_lb.random_, subset_lb.common_config_,
+        MaglevLoadBalancer::tableSize(subset_lb.lb_maglev_config_)));
+    thread_aware_lb_->initialize();
+    lb_ = thread_aware_lb_->factory()->create();
+    break;
+
+  case LoadBalancerType::BoundedLoadRingHash:
+    // The load of the hosts is bounded relative to the other hosts of the subset.
+    thread_aware_lb_.reset(new BoundedLoadRingHashLoadBalancer(
+        *this, subset_lb.stats_, subset_lb.runtime_, subset_lb.random_,
+        subset_lb.lb_bounded_load_ring_hash_config_, subset_lb.common_config_));
     thread_aware_lb_->initialize();
     lb_ = thread_aware_lb_->factory()->create();
     break;
@@ -531,16 +577,41 @@ void SubsetLoadBalancer::HostSubsetImpl::update(const HostVector& hosts_added,
     hosts_per_locality = original_host_set_.hostsPerLocality().filter(predicate);
   }
 
+  updateHosts(hosts, healthy_hosts, hosts_per_locality, filtered_added, filtered_removed);
+}
+
+// Updates the underlying HostSet with hosts computed by SubsetLoadBalancer::update(). The hosts
+// grouped by locality are moved out of subset_hosts.
+void SubsetLoadBalancer::HostSubsetImpl::update(SubsetHosts& subset_hosts) {
+  const HostsPerLocality& original_hosts_per_locality = original_host_set_.hostsPerLocality();
+  HostsPerLocalityConstSharedPtr hosts_per_locality;
+  if (original_hosts_per_locality.get().size() == 1) {
+    hosts_per_locality.reset(new HostsPerLocalityImpl(
+        *subset_hosts.hosts_, original_hosts_per_locality.hasLocalLocality()));
+  } else {
+    subset_hosts.hosts_per_locality_.resize(original_hosts_per_locality.get().size());
+    hosts_per_locality.reset(
+        new HostsPerLocalityImpl(std::move(subset_hosts.hosts_per_locality_),
+                                 original_hosts_per_locality.hasLocalLocality()));
+  }
+
+  updateHosts(subset_hosts.hosts_, subset_hosts.healthy_hosts_, hosts_per_locality,
+              subset_hosts.hosts_added_, subset_hosts.hosts_removed_);
+}
+
+void SubsetLoadBalancer::HostSubsetImpl::updateHosts(
+    HostVectorSharedPtr hosts, HostVectorSharedPtr healthy_hosts,
+    HostsPerLocalityConstSharedPtr hosts_per_locality, const HostVector& hosts_added,
+    const HostVector& hosts_removed) {
   HostsPerLocalityConstSharedPtr healthy_hosts_per_locality =
       hosts_per_locality->filter([](const Host& host) { return host.healthy(); });
 
   if (locality_weight_aware_) {
     HostSetImpl::updateHosts(hosts, healthy_hosts, hosts_per_locality, healthy_hosts_per_locality,
-                             original_host_set_.localityWeights(), filtered_added,
-                             filtered_removed);
+                             original_host_set_.localityWeights(), hosts_added, hosts_removed);
   } else {
     HostSetImpl::updateHosts(hosts, healthy_hosts, hosts_per_locality, healthy_hosts_per_locality,
-                             {}, filtered_added, filtered_removed);
+                             {}, hosts_added, hosts_removed);
   }
 }
 
@@ -561,8 +632,17 @@ void SubsetLoadBalancer::PrioritySubsetImpl::update(uint32_t priority,
                                                     const HostVector& hosts_removed) {
   HostSubsetImpl* host_subset = getOrCreateHostSubset(priority);
   host_subset->update(hosts_added, hosts_removed, predicate_);
+  onHostsUpdated(*host_subset);
+}
+
+void SubsetLoadBalancer::PrioritySubsetImpl::update(uint32_t priority, SubsetHosts& subset_hosts) {
+  HostSubsetImpl* host_subset = getOrCreateHostSubset(priority);
+  host_subset->update(subset_hosts);
+  onHostsUpdated(*host_subset);
+}
 
-  if (host_subset->hosts().empty() != empty_) {
+void SubsetLoadBalancer::PrioritySubsetImpl::onHostsUpdated(const HostSubsetImpl& host_subset) {
+  if (host_subset.hosts().empty() != empty_) {
     empty_ = true;
     for (auto& host_set : hostSetsPerPriority()) {
       empty_ &= host_set->hosts().empty();
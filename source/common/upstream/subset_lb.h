@@ -6,6 +6,7 @@
 #include <string>
 #include <unordered_map>
 
+#include "envoy/common/time.h"
 #include "envoy/runtime/runtime.h"
 #include "envoy/upstream/load_balancer.h"
 
@@ -26,7 +27,11 @@ public:
       ClusterStats& stats, Runtime::Loader& runtime, Runtime::RandomGenerator& random,
       const LoadBalancerSubsetInfo& subsets,
       const absl::optional<envoy::api::v2::Cluster::RingHashLbConfig>& lb_ring_hash_config,
-      const envoy::api::v2::Cluster::CommonLbConfig& common_config);
+      const absl::optional<envoy::api::v2::Cluster::MaglevLbConfig>& lb_maglev_config,
+      const absl::optional<envoy::api::v2::Cluster::BoundedLoadRingHashLbConfig>&
+          lb_bounded_load_ring_hash_config,
+      const absl::optional<envoy::api::v2::Cluster::LeastRequestLbConfig>& lb_least_request_config,
+      const envoy::api::v2::Cluster::CommonLbConfig& common_config, TimeSource& time_source);
   ~SubsetLoadBalancer();
 
   // Upstream::LoadBalancer
@@ -35,6 +40,17 @@ public:
 private:
   typedef std::function<bool(const Host&)> HostPredicate;
 
+  // The hosts of a subset for a priority, as computed by matching each host of the priority against
+  // the subset keys once.
+  struct SubsetHosts {
+    HostVectorSharedPtr hosts_{new HostVector()};
+    HostVectorSharedPtr healthy_hosts_{new HostVector()};
+    // Only used when the priority has several localities.
+    std::vector<HostVector> hosts_per_locality_;
+    HostVector hosts_added_;
+    HostVector hosts_removed_;
+  };
+
   // Represents a subset of an original HostSet.
   class HostSubsetImpl : public HostSetImpl {
   public:
@@ -44,11 +60,16 @@ private:
 
     void update(const HostVector& hosts_added, const HostVector& hosts_removed,
                 HostPredicate predicate);
+    void update(SubsetHosts& subset_hosts);
 
     void triggerCallbacks() { HostSetImpl::runUpdateCallbacks({}, {}); }
     bool empty() { return hosts().empty(); }
 
   private:
+    void updateHosts(HostVectorSharedPtr hosts, HostVectorSharedPtr healthy_hosts,
+                     HostsPerLocalityConstSharedPtr hosts_per_locality,
+                     const HostVector& hosts_added, const HostVector& hosts_removed);
+
     const HostSet& original_host_set_;
     const bool locality_weight_aware_;
   };
@@ -60,6 +81,7 @@ private:
                        bool locality_weight_aware);
 
     void update(uint32_t priority, const HostVector& hosts_added, const HostVector& hosts_removed);
+    void update(uint32_t priority, SubsetHosts& subset_hosts);
 
     bool empty() { return empty_; }
 
@@ -83,6 +105,8 @@ private:
                                  absl::optional<uint32_t> overprovisioning_factor) override;
 
   private:
+    void onHostsUpdated(const HostSubsetImpl& host_subset);
+
     const PrioritySet& original_priority_set_;
     const HostPredicate predicate_;
     const bool locality_weight_aware_;
@@ -93,23 +117,36 @@ private:
   typedef std::shared_ptr<PrioritySubsetImpl> PrioritySubsetImplPtr;
 
   typedef std::vector<std::pair<std::string, ProtobufWkt::Value>> SubsetMetadata;
+  typedef std::vector<std::pair<std::string, HashedValue>> HashedSubsetMetadata;
 
   class LbSubsetEntry;
   typedef std::shared_ptr<LbSubsetEntry> LbSubsetEntryPtr;
-  typedef std::unordered_map<HashedValue, LbSubsetEntryPtr> ValueSubsetMap;
-  typedef std::unordered_map<std::string, ValueSubsetMap> LbSubsetMap;
+  // Subsets indexed by the hash of their metadata (see HashedValue::hashWithName()). Colliding
+  // subsets share a hash, and are told apart by comparing their metadata.
+  typedef std::unordered_multimap<uint64_t, LbSubsetEntryPtr> LbSubsetMap;
 
-  // Entry in the subset hierarchy.
+  // A subset, identified by the metadata of its hosts.
   class LbSubsetEntry {
   public:
     LbSubsetEntry() {}
+    LbSubsetEntry(HashedSubsetMetadata&& kvs) : kvs_(std::move(kvs)) {}
 
     bool initialized() const { return priority_subset_ != nullptr; }
     bool active() const { return initialized() && !priority_subset_->empty(); }
 
-    LbSubsetMap children_;
+    /**
+     * @return whether the subset is the one for the given metadata match criteria.
+     */
+    bool matches(const std::vector<Router::MetadataMatchCriterionConstSharedPtr>& criteria) const;
+    /**
+     * @return whether the subset is the one for the given metadata.
+     */
+    bool matches(const HashedSubsetMetadata& kvs) const;
+
+    // The metadata of the hosts of the subset, sorted by key.
+    const HashedSubsetMetadata kvs_;
 
-    // Only initialized if a match exists at this level.
+    // Only initialized once a host of the subset has been added.
     PrioritySubsetImplPtr priority_subset_;
   };
 
@@ -122,31 +159,38 @@ private:
 
   void updateFallbackSubset(uint32_t priority, const HostVector& hosts_added,
                             const HostVector& hosts_removed);
-  void processSubsets(
-      const HostVector& hosts_added, const HostVector& hosts_removed,
-      std::function<void(LbSubsetEntryPtr)> update_cb,
-      std::function<void(LbSubsetEntryPtr, HostPredicate, const SubsetMetadata&, bool)> cb);
 
   HostConstSharedPtr tryChooseHostFromContext(LoadBalancerContext* context, bool& host_chosen);
 
   bool hostMatches(const SubsetMetadata& kvs, const Host& host);
 
-  LbSubsetEntryPtr
-  findSubset(const std::vector<Router::MetadataMatchCriterionConstSharedPtr>& matches);
+  LbSubsetEntryPtr findSubset(const Router::MetadataMatchCriteria& match_criteria);
+
+  /**
+   * @return the subset for the given metadata, or nullptr if there is none and create is false.
+   */
+  LbSubsetEntryPtr findOrCreateSubset(const SubsetMetadata& kvs, bool create);
+  void forEachSubset(std::function<void(LbSubsetEntryPtr)> cb);
 
-  LbSubsetEntryPtr findOrCreateSubset(LbSubsetMap& subsets, const SubsetMetadata& kvs,
-                                      uint32_t idx);
-  void forEachSubset(LbSubsetMap& subsets, std::function<void(LbSubsetEntryPtr)> cb);
+  /**
+   * @return the subsets of the given host, one for each subset keys it has values for.
+   */
+  std::vector<LbSubsetEntryPtr> hostSubsets(const Host& host, bool create);
 
   SubsetMetadata extractSubsetMetadata(const std::set<std::string>& subset_keys, const Host& host);
   std::string describeMetadata(const SubsetMetadata& kvs);
 
   const LoadBalancerType lb_type_;
   const absl::optional<envoy::api::v2::Cluster::RingHashLbConfig> lb_ring_hash_config_;
+  const absl::optional<envoy::api::v2::Cluster::MaglevLbConfig> lb_maglev_config_;
+  const absl::optional<envoy::api::v2::Cluster::BoundedLoadRingHashLbConfig>
+      lb_bounded_load_ring_hash_config_;
+  const absl::optional<envoy::api::v2::Cluster::LeastRequestLbConfig> lb_least_request_config_;
   const envoy::api::v2::Cluster::CommonLbConfig common_config_;
   ClusterStats& stats_;
   Runtime::Loader& runtime_;
   Runtime::RandomGenerator& random_;
+  TimeSource& time_source_;
 
   const envoy::api::v2::Cluster::LbSubsetConfig::LbSubsetFallbackPolicy fallback_policy_;
   const SubsetMetadata default_subset_metadata_;
@@ -158,7 +202,7 @@ private:
 
   LbSubsetEntryPtr fallback_subset_;
 
-  // Forms a trie-like structure. Requires lexically sorted Host and Route metadata.
+  // Requires lexically sorted Host and Route metadata, so that equal metadata have equal hashes.
   LbSubsetMap subsets_;
 
   const bool locality_weight_aware_;
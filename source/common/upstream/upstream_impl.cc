@@ -1,7 +1,9 @@
 #include "common/upstream/upstream_impl.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
+#include <limits>
 #include <list>
 #include <memory>
 #include <string>
@@ -30,6 +32,7 @@
 #include "common/network/socket_option_factory.h"
 #include "common/protobuf/protobuf.h"
 #include "common/protobuf/utility.h"
+#include "common/runtime/key_registry.h"
 #include "common/upstream/eds.h"
 #include "common/upstream/health_checker_impl.h"
 #include "common/upstream/logical_dns_cluster.h"
@@ -70,6 +73,9 @@ uint64_t parseFeatures(const envoy::api::v2::Cluster& config) {
   if (config.close_connections_on_host_health_failure()) {
     features |= ClusterInfoImpl::Features::CLOSE_CONNECTIONS_ON_HOST_HEALTH_FAILURE;
   }
+  if (config.has_http2_protocol_options() && config.share_http2_connections_across_workers()) {
+    features |= ClusterInfoImpl::Features::SHARE_HTTP2_CONNECTIONS_ACROSS_WORKERS;
+  }
   return features;
 }
 
@@ -146,6 +152,17 @@ parseExtensionProtocolOptions(const envoy::api::v2::Cluster& config) {
 
 } // namespace
 
+std::shared_ptr<envoy::api::v2::core::Metadata>
+HostDescriptionImpl::internMetadata(const envoy::api::v2::core::Metadata& metadata) {
+  static const std::shared_ptr<envoy::api::v2::core::Metadata>* empty_metadata =
+      new std::shared_ptr<envoy::api::v2::core::Metadata>(
+          std::make_shared<envoy::api::v2::core::Metadata>());
+  if (metadata.filter_metadata().empty()) {
+    return *empty_metadata;
+  }
+  return std::make_shared<envoy::api::v2::core::Metadata>(metadata);
+}
+
 Host::CreateConnectionData
 HostImpl::createConnection(Event::Dispatcher& dispatcher,
                            const Network::ConnectionSocket::OptionsSharedPtr& options) const {
@@ -220,52 +237,44 @@ void HostSetImpl::updateHosts(HostVectorConstSharedPtr hosts,
   hosts_per_locality_ = std::move(hosts_per_locality);
   healthy_hosts_per_locality_ = std::move(healthy_hosts_per_locality);
   locality_weights_ = std::move(locality_weights);
-  // Rebuild the locality scheduler by computing the effective weight of each
-  // locality in this priority. The scheduler is reset by default, and is rebuilt only if we have
-  // locality weights (i.e. using EDS) and there is at least one healthy host in this priority.
+  // Update the locality scheduler by computing the effective weight of each
+  // locality in this priority. The schedule is empty by default, and localities are only scheduled
+  // if we have locality weights (i.e. using EDS) and there is at least one healthy host in this
+  // priority.
   //
-  // We omit building a scheduler when there are zero healthy hosts in the priority as all
+  // We omit scheduling localities when there are zero healthy hosts in the priority as all
   // the localities will have zero effective weight. At selection time, we'll only ever try
   // to select a host from such a priority if all priorities have zero healthy hosts. At
   // that point we'll rely on other mechanisms such as panic mode to select a host,
   // none of which rely on the scheduler.
   //
-  // TODO(htuch): if the underlying locality index ->
-  // envoy::api::v2::core::Locality hasn't changed in hosts_/healthy_hosts_, we
-  // could just update locality_weight_ without rebuilding. Similar to how host
-  // level WRR works, we would age out the existing entries via picks and lazily
-  // apply the new weights.
-  locality_scheduler_ = nullptr;
+  // The effective weights are updated in place in the scheduler, in O(log n) time per locality
+  // whose weight changed. Each locality keeps its progress towards its next pick, and the
+  // effective weights usually stay the same when a few hosts change, since the health ratio of a
+  // locality is capped by the overprovisioning factor.
+  uint32_t num_localities = 0;
   if (hosts_per_locality_ != nullptr && locality_weights_ != nullptr &&
       !locality_weights_->empty() && !healthy_hosts_->empty()) {
-    locality_scheduler_ = std::make_unique<EdfScheduler<LocalityEntry>>();
-    locality_entries_.clear();
-    for (uint32_t i = 0; i < hosts_per_locality_->get().size(); ++i) {
-      const double effective_weight = effectiveLocalityWeight(i);
-      if (effective_weight > 0) {
-        locality_entries_.emplace_back(std::make_shared<LocalityEntry>(i, effective_weight));
-        locality_scheduler_->add(effective_weight, locality_entries_.back());
-      }
-    }
-    // If all effective weights were zero, reset the scheduler.
-    if (locality_scheduler_->empty()) {
-      locality_scheduler_ = nullptr;
+    num_localities = hosts_per_locality_->get().size();
+  }
+  for (uint32_t i = 0; i < num_localities; ++i) {
+    const double effective_weight = effectiveLocalityWeight(i);
+    if (effective_weight > 0) {
+      locality_scheduler_.set(i, effective_weight);
+    } else {
+      locality_scheduler_.remove(i);
     }
   }
+  for (uint32_t i = num_localities; i < num_localities_; ++i) {
+    locality_scheduler_.remove(i);
+  }
+  num_localities_ = num_localities;
   runUpdateCallbacks(hosts_added, hosts_removed);
 }
 
 absl::optional<uint32_t> HostSetImpl::chooseLocality() {
-  if (locality_scheduler_ == nullptr) {
-    return {};
-  }
-  const std::shared_ptr<LocalityEntry> locality = locality_scheduler_->pick();
-  // We don't build a schedule if there are no weighted localities, so we should always succeed.
-  ASSERT(locality != nullptr);
-  // If we picked it before, its weight must have been positive.
-  ASSERT(locality->effective_weight_ > 0);
-  locality_scheduler_->add(locality->effective_weight_, locality);
-  return locality->index_;
+  // The schedule is empty if there are no weighted localities.
+  return locality_scheduler_.pick();
 }
 
 double HostSetImpl::effectiveLocalityWeight(uint32_t index) const {
@@ -314,6 +323,12 @@ ClusterInfoImpl::ClusterInfoImpl(const envoy::api::v2::Cluster& config,
     : runtime_(runtime), name_(config.name()), type_(config.type()),
       max_requests_per_connection_(
           PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, max_requests_per_connection, 0)),
+      max_concurrent_streams_per_connection_(
+          PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, max_concurrent_streams_per_connection, 0)),
+      prefetch_ratio_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.prefetch_policy(),
+                                                      per_upstream_prefetch_ratio, 1.0)),
+      prefetch_min_connections_(
+          PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.prefetch_policy(), min_connections_per_host, 0)),
       connect_timeout_(
           std::chrono::milliseconds(PROTOBUF_GET_MS_REQUIRED(config, connect_timeout))),
       per_connection_buffer_limit_bytes_(
@@ -324,11 +339,17 @@ ClusterInfoImpl::ClusterInfoImpl(const envoy::api::v2::Cluster& config,
       features_(parseFeatures(config)),
       http2_settings_(Http::Utility::parseHttp2Settings(config.http2_protocol_options())),
       extension_protocol_options_(parseExtensionProtocolOptions(config)),
-      resource_managers_(config, runtime, name_),
-      maintenance_mode_runtime_key_(fmt::format("upstream.maintenance_mode.{}", name_)),
+      resource_managers_(config, runtime, name_, stats_),
+      maintenance_mode_runtime_key_(
+          Runtime::KeyRegistry::registerKey(fmt::format("upstream.maintenance_mode.{}", name_))),
       source_address_(getSourceAddress(config, bind_config)),
       lb_ring_hash_config_(config.ring_hash_lb_config()),
-      lb_original_dst_config_(config.original_dst_lb_config()), added_via_api_(added_via_api),
+      lb_original_dst_config_(config.original_dst_lb_config()),
+      lb_maglev_config_(config.maglev_lb_config()),
+      lb_bounded_load_ring_hash_config_(config.bounded_load_ring_hash_lb_config()),
+      lb_least_request_config_(config.least_request_lb_config()),
+      lb_peak_ewma_config_(config.peak_ewma_lb_config()),
+      added_via_api_(added_via_api),
       lb_subset_(LoadBalancerSubsetInfoImpl(config.lb_subset_config())),
       metadata_(config.metadata()), common_lb_config_(config.common_lb_config()),
       cluster_socket_options_(parseClusterSocketOptions(config, bind_config)),
@@ -355,8 +376,23 @@ ClusterInfoImpl::ClusterInfoImpl(const envoy::api::v2::Cluster& config,
     lb_type_ = LoadBalancerType::OriginalDst;
     break;
   case envoy::api::v2::Cluster::MAGLEV:
+    if (config.maglev_lb_config().has_table_size()) {
+      // The table size must be prime, otherwise building the table may never terminate.
+      const uint64_t table_size = config.maglev_lb_config().table_size().value();
+      if (table_size < 3 || table_size > std::numeric_limits<uint32_t>::max() ||
+          !Primes::isPrime(table_size)) {
+        throw EnvoyException(
+            fmt::format("cluster: Maglev table size {} is not a prime number", table_size));
+      }
+    }
     lb_type_ = LoadBalancerType::Maglev;
     break;
+  case envoy::api::v2::Cluster::BOUNDED_LOAD_RING_HASH:
+    lb_type_ = LoadBalancerType::BoundedLoadRingHash;
+    break;
+  case envoy::api::v2::Cluster::PEAK_EWMA:
+    lb_type_ = LoadBalancerType::PeakEwma;
+    break;
   default:
     NOT_REACHED_GCOVR_EXCL_LINE;
   }
@@ -678,21 +714,24 @@ ClusterImplBase::resolveProtoAddress(const envoy::api::v2::core::Address& addres
 
 ClusterInfoImpl::ResourceManagers::ResourceManagers(const envoy::api::v2::Cluster& config,
                                                     Runtime::Loader& runtime,
-                                                    const std::string& cluster_name) {
+                                                    const std::string& cluster_name,
+                                                    ClusterStats& stats) {
   managers_[enumToInt(ResourcePriority::Default)] =
-      load(config, runtime, cluster_name, envoy::api::v2::core::RoutingPriority::DEFAULT);
+      load(config, runtime, cluster_name, envoy::api::v2::core::RoutingPriority::DEFAULT, stats);
   managers_[enumToInt(ResourcePriority::High)] =
-      load(config, runtime, cluster_name, envoy::api::v2::core::RoutingPriority::HIGH);
+      load(config, runtime, cluster_name, envoy::api::v2::core::RoutingPriority::HIGH, stats);
 }
 
 ResourceManagerImplPtr
 ClusterInfoImpl::ResourceManagers::load(const envoy::api::v2::Cluster& config,
                                         Runtime::Loader& runtime, const std::string& cluster_name,
-                                        const envoy::api::v2::core::RoutingPriority& priority) {
+                                        const envoy::api::v2::core::RoutingPriority& priority,
+                                        ClusterStats& stats) {
   uint64_t max_connections = 1024;
   uint64_t max_pending_requests = 1024;
   uint64_t max_requests = 1024;
   uint64_t max_retries = 3;
+  absl::optional<ResourceManagerImpl::RetryBudget> retry_budget;
 
   std::string priority_name;
   switch (priority) {
@@ -721,9 +760,17 @@ ClusterInfoImpl::ResourceManagers::load(const envoy::api::v2::Cluster& config,
         PROTOBUF_GET_WRAPPED_OR_DEFAULT(*it, max_pending_requests, max_pending_requests);
     max_requests = PROTOBUF_GET_WRAPPED_OR_DEFAULT(*it, max_requests, max_requests);
     max_retries = PROTOBUF_GET_WRAPPED_OR_DEFAULT(*it, max_retries, max_retries);
+    if (it->has_retry_budget()) {
+      const auto& budget = it->retry_budget();
+      retry_budget.emplace(ResourceManagerImpl::RetryBudget{
+          budget.has_budget_percent() ? budget.budget_percent().value() : 20.0,
+          PROTOBUF_GET_WRAPPED_OR_DEFAULT(budget, min_retry_concurrency, 3),
+          stats.upstream_rq_retry_budget_exhausted_});
+    }
   }
-  return ResourceManagerImplPtr{new ResourceManagerImpl(
-      runtime, runtime_prefix, max_connections, max_pending_requests, max_requests, max_retries)};
+  return ResourceManagerImplPtr{new ResourceManagerImpl(runtime, runtime_prefix, max_connections,
+                                                        max_pending_requests, max_requests,
+                                                        max_retries, retry_budget)};
 }
 
 PriorityStateManager::PriorityStateManager(ClusterImplBase& cluster,
@@ -1132,7 +1179,8 @@ StrictDnsClusterImpl::ResolveTarget::ResolveTarget(
     const envoy::api::v2::endpoint::LbEndpoint& lb_endpoint)
     : parent_(parent), dns_address_(Network::Utility::hostFromTcpUrl(url)),
       port_(Network::Utility::portFromTcpUrl(url)),
-      resolve_timer_(dispatcher.createTimer([this]() -> void { startResolve(); })),
+      resolve_timer_(dispatcher.createTimer([this]() -> void { startResolve(); },
+                                            Event::TimerPrecision::Coarse)),
       locality_lb_endpoint_(locality_lb_endpoint), lb_endpoint_(lb_endpoint) {}
 
 StrictDnsClusterImpl::ResolveTarget::~ResolveTarget() {
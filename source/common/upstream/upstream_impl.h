@@ -32,10 +32,14 @@
 #include "common/common/logger.h"
 #include "common/config/metadata.h"
 #include "common/config/well_known_names.h"
+#include "common/memory/accounting.h"
 #include "common/network/utility.h"
 #include "common/stats/isolated_store_impl.h"
+#include "common/upstream/host_stats_impl.h"
+#include "common/upstream/latency_estimator_impl.h"
 #include "common/upstream/load_balancer_impl.h"
 #include "common/upstream/locality.h"
+#include "common/upstream/locality_load_stats.h"
 #include "common/upstream/outlier_detection_impl.h"
 #include "common/upstream/resource_manager_impl.h"
 
@@ -74,9 +78,13 @@ public:
         canary_(Config::Metadata::metadataValue(metadata, Config::MetadataFilters::get().ENVOY_LB,
                                                 Config::MetadataEnvoyLbKeys::get().CANARY)
                     .bool_value()),
-        metadata_(std::make_shared<envoy::api::v2::core::Metadata>(metadata)),
-        locality_(locality), stats_{ALL_HOST_STATS(POOL_COUNTER(stats_store_),
-                                                   POOL_GAUGE(stats_store_))} {}
+        metadata_(internMetadata(metadata)),
+        locality_load_stats_(cluster->localityLoadStats(locality)),
+        stats_store_(std::make_shared<HostStatsStore>(locality_load_stats_)),
+        stats_{ALL_HOST_STATS(POOL_COUNTER(*stats_store_), POOL_GAUGE(*stats_store_))},
+        latency_estimator_(cluster->lbPeakEwmaConfig()) {
+    ASSERT(locality_load_stats_ != nullptr);
+  }
 
   // Upstream::HostDescription
   bool canary() const override { return canary_; }
@@ -97,7 +105,7 @@ public:
   }
   virtual void metadata(const envoy::api::v2::core::Metadata& new_metadata) override {
     absl::WriterMutexLock lock(&metadata_mutex_);
-    metadata_ = std::make_shared<envoy::api::v2::core::Metadata>(new_metadata);
+    metadata_ = internMetadata(new_metadata);
   }
 
   const ClusterInfo& cluster() const override { return *cluster_; }
@@ -119,6 +127,7 @@ public:
       return *null_outlier_detector;
     }
   }
+  LatencyEstimator& latencyEstimator() const override { return latency_estimator_; }
   const HostStats& stats() const override { return stats_; }
   const std::string& hostname() const override { return hostname_; }
   Network::Address::InstanceConstSharedPtr address() const override { return address_; }
@@ -127,9 +136,15 @@ public:
   }
   // Setting health check address is usually done at initialization. This is NOP by default.
   void setHealthCheckAddress(Network::Address::InstanceConstSharedPtr) override {}
-  const envoy::api::v2::core::Locality& locality() const override { return locality_; }
+  const envoy::api::v2::core::Locality& locality() const override {
+    return locality_load_stats_->locality();
+  }
 
 protected:
+  // Most hosts have no metadata, these hosts share a single empty metadata object.
+  static std::shared_ptr<envoy::api::v2::core::Metadata>
+  internMetadata(const envoy::api::v2::core::Metadata& metadata);
+
   ClusterInfoConstSharedPtr cluster_;
   const std::string hostname_;
   Network::Address::InstanceConstSharedPtr address_;
@@ -137,9 +152,11 @@ protected:
   std::atomic<bool> canary_;
   mutable absl::Mutex metadata_mutex_;
   std::shared_ptr<envoy::api::v2::core::Metadata> metadata_ GUARDED_BY(metadata_mutex_);
-  const envoy::api::v2::core::Locality locality_;
-  Stats::IsolatedStoreImpl stats_store_;
+  // Also holds the locality of the host, shared by the hosts of the cluster in the locality.
+  const LocalityLoadStatsSharedPtr locality_load_stats_;
+  const HostStatsStoreSharedPtr stats_store_;
   HostStats stats_;
+  mutable PeakEwmaLatencyEstimator latency_estimator_;
   Outlier::DetectorHostMonitorPtr outlier_detector_;
   HealthCheckHostMonitorPtr health_checker_;
 };
@@ -149,6 +166,7 @@ protected:
  */
 class HostImpl : public HostDescriptionImpl,
                  public Host,
+                 public Memory::Accounted<Memory::Tag::Hosts>,
                  public std::enable_shared_from_this<HostImpl> {
 public:
   HostImpl(ClusterInfoConstSharedPtr cluster, const std::string& hostname,
@@ -162,12 +180,14 @@ public:
   }
 
   // Upstream::Host
-  std::vector<Stats::CounterSharedPtr> counters() const override { return stats_store_.counters(); }
+  std::vector<Stats::CounterSharedPtr> counters() const override {
+    return stats_store_->counters();
+  }
   CreateConnectionData
   createConnection(Event::Dispatcher& dispatcher,
                    const Network::ConnectionSocket::OptionsSharedPtr& options) const override;
   CreateConnectionData createHealthCheckConnection(Event::Dispatcher& dispatcher) const override;
-  std::vector<Stats::GaugeSharedPtr> gauges() const override { return stats_store_.gauges(); }
+  std::vector<Stats::GaugeSharedPtr> gauges() const override { return stats_store_->gauges(); }
   void healthFlagClear(HealthFlag flag) override { health_flags_ &= ~enumToInt(flag); }
   bool healthFlagGet(HealthFlag flag) const override { return health_flags_ & enumToInt(flag); }
   void healthFlagSet(HealthFlag flag) override { health_flags_ |= enumToInt(flag); }
@@ -271,6 +291,9 @@ public:
   const HostsPerLocality& healthyHostsPerLocality() const override {
     return *healthy_hosts_per_locality_;
   }
+  HostsPerLocalityConstSharedPtr healthyHostsPerLocalityPtr() const override {
+    return healthy_hosts_per_locality_;
+  }
   LocalityWeightsConstSharedPtr localityWeights() const override { return locality_weights_; }
   absl::optional<uint32_t> chooseLocality() override;
   uint32_t priority() const override { return priority_; }
@@ -296,15 +319,11 @@ private:
       member_update_cb_helper_;
   // Locality weights (used to build WRR locality_scheduler_);
   LocalityWeightsConstSharedPtr locality_weights_;
-  // WRR locality scheduler state.
-  struct LocalityEntry {
-    LocalityEntry(uint32_t index, double effective_weight)
-        : index_(index), effective_weight_(effective_weight) {}
-    const uint32_t index_;
-    const double effective_weight_;
-  };
-  std::vector<std::shared_ptr<LocalityEntry>> locality_entries_;
-  std::unique_ptr<EdfScheduler<LocalityEntry>> locality_scheduler_;
+  // WRR locality scheduler, by locality index. Only the localities with a positive effective
+  // weight are scheduled.
+  IndexedEdfScheduler locality_scheduler_;
+  // The number of localities considered by the last update of locality_scheduler_.
+  uint32_t num_localities_{};
 };
 
 typedef std::unique_ptr<HostSetImpl> HostSetImplPtr;
@@ -387,8 +406,28 @@ public:
   lbOriginalDstConfig() const override {
     return lb_original_dst_config_;
   }
+  const absl::optional<envoy::api::v2::Cluster::MaglevLbConfig>& lbMaglevConfig() const override {
+    return lb_maglev_config_;
+  }
+  const absl::optional<envoy::api::v2::Cluster::BoundedLoadRingHashLbConfig>&
+  lbBoundedLoadRingHashConfig() const override {
+    return lb_bounded_load_ring_hash_config_;
+  }
+  const absl::optional<envoy::api::v2::Cluster::LeastRequestLbConfig>&
+  lbLeastRequestConfig() const override {
+    return lb_least_request_config_;
+  }
+  const absl::optional<envoy::api::v2::Cluster::PeakEwmaLbConfig>&
+  lbPeakEwmaConfig() const override {
+    return lb_peak_ewma_config_;
+  }
   bool maintenanceMode() const override;
   uint64_t maxRequestsPerConnection() const override { return max_requests_per_connection_; }
+  uint64_t maxConcurrentStreamsPerConnection() const override {
+    return max_concurrent_streams_per_connection_;
+  }
+  double prefetchRatio() const override { return prefetch_ratio_; }
+  uint32_t prefetchMinConnections() const override { return prefetch_min_connections_; }
   const std::string& name() const override { return name_; }
   ResourceManager& resourceManager(ResourcePriority priority) const override;
   Network::TransportSocketFactory& transportSocketFactory() const override {
@@ -397,6 +436,10 @@ public:
   ClusterStats& stats() const override { return stats_; }
   Stats::Scope& statsScope() const override { return *stats_scope_; }
   ClusterLoadReportStats& loadReportStats() const override { return load_report_stats_; }
+  LocalityLoadStatsSharedPtr
+  localityLoadStats(const envoy::api::v2::core::Locality& locality) const override {
+    return locality_load_stats_.get(locality);
+  }
   const Network::Address::InstanceConstSharedPtr& sourceAddress() const override {
     return source_address_;
   };
@@ -412,10 +455,11 @@ public:
 private:
   struct ResourceManagers {
     ResourceManagers(const envoy::api::v2::Cluster& config, Runtime::Loader& runtime,
-                     const std::string& cluster_name);
+                     const std::string& cluster_name, ClusterStats& stats);
     ResourceManagerImplPtr load(const envoy::api::v2::Cluster& config, Runtime::Loader& runtime,
                                 const std::string& cluster_name,
-                                const envoy::api::v2::core::RoutingPriority& priority);
+                                const envoy::api::v2::core::RoutingPriority& priority,
+                                ClusterStats& stats);
 
     typedef std::array<ResourceManagerImplPtr, NumResourcePriorities> Managers;
 
@@ -426,6 +470,9 @@ private:
   const std::string name_;
   const envoy::api::v2::Cluster::DiscoveryType type_;
   const uint64_t max_requests_per_connection_;
+  const uint64_t max_concurrent_streams_per_connection_;
+  const double prefetch_ratio_;
+  const uint32_t prefetch_min_connections_;
   const std::chrono::milliseconds connect_timeout_;
   absl::optional<std::chrono::milliseconds> idle_timeout_;
   const uint32_t per_connection_buffer_limit_bytes_;
@@ -434,15 +481,21 @@ private:
   mutable ClusterStats stats_;
   Stats::IsolatedStoreImpl load_report_stats_store_;
   mutable ClusterLoadReportStats load_report_stats_;
+  mutable LocalityLoadStatsMap locality_load_stats_;
   const uint64_t features_;
   const Http::Http2Settings http2_settings_;
   const std::map<std::string, ProtocolOptionsConfigConstSharedPtr> extension_protocol_options_;
   mutable ResourceManagers resource_managers_;
-  const std::string maintenance_mode_runtime_key_;
+  const Runtime::KeyHandle maintenance_mode_runtime_key_;
   const Network::Address::InstanceConstSharedPtr source_address_;
   LoadBalancerType lb_type_;
   absl::optional<envoy::api::v2::Cluster::RingHashLbConfig> lb_ring_hash_config_;
   absl::optional<envoy::api::v2::Cluster::OriginalDstLbConfig> lb_original_dst_config_;
+  absl::optional<envoy::api::v2::Cluster::MaglevLbConfig> lb_maglev_config_;
+  absl::optional<envoy::api::v2::Cluster::BoundedLoadRingHashLbConfig>
+      lb_bounded_load_ring_hash_config_;
+  absl::optional<envoy::api::v2::Cluster::LeastRequestLbConfig> lb_least_request_config_;
+  absl::optional<envoy::api::v2::Cluster::PeakEwmaLbConfig> lb_peak_ewma_config_;
   const bool added_via_api_;
   LoadBalancerSubsetInfoImpl lb_subset_;
   const envoy::api::v2::core::Metadata metadata_;
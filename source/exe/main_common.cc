@@ -6,6 +6,7 @@
 #include "common/common/compiler_requirements.h"
 #include "common/common/perf_annotation.h"
 #include "common/event/libevent.h"
+#include "common/memory/huge_page_arena.h"
 #include "common/network/utility.h"
 #include "common/stats/thread_local_store.h"
 
@@ -46,6 +47,10 @@ MainCommonBase::MainCommonBase(OptionsImpl& options) : options_(options) {
   switch (options_.mode()) {
   case Server::Mode::InitOnly:
   case Server::Mode::Serve: {
+    // Enabled before anything allocates from the arena, starting with the stats.
+    if (options_.hugePageArenaSizeMb() > 0) {
+      Memory::HugePageArena::enable(uint64_t(options_.hugePageArenaSizeMb()) * 1024 * 1024);
+    }
 #ifdef ENVOY_HOT_RESTART
     if (!options.hotRestartDisabled()) {
       restarter_.reset(new Server::HotRestartImpl(options_));
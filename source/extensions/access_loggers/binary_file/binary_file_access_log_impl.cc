@@ -0,0 +1,61 @@
+#include "extensions/access_loggers/binary_file/binary_file_access_log_impl.h"
+
+#include "envoy/data/accesslog/v2/accesslog.pb.h"
+
+#include "common/http/header_map_impl.h"
+#include "common/protobuf/protobuf.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace BinaryFile {
+
+BinaryFileAccessLog::BinaryFileAccessLog(
+    const envoy::config::accesslog::v2::BinaryFileAccessLog& config, AccessLog::FilterPtr&& filter,
+    AccessLog::AccessLogManager& log_manager)
+    : log_file_(log_manager.createAccessLog(config.path())), filter_(std::move(filter)),
+      entry_builder_(config.additional_request_headers_to_log(),
+                     config.additional_response_headers_to_log(),
+                     config.additional_response_trailers_to_log()) {}
+
+void BinaryFileAccessLog::log(const Http::HeaderMap* request_headers,
+                              const Http::HeaderMap* response_headers,
+                              const Http::HeaderMap* response_trailers,
+                              const RequestInfo::RequestInfo& request_info) {
+  static Http::HeaderMapImpl empty_headers;
+  if (!request_headers) {
+    request_headers = &empty_headers;
+  }
+  if (!response_headers) {
+    response_headers = &empty_headers;
+  }
+  if (!response_trailers) {
+    response_trailers = &empty_headers;
+  }
+
+  if (filter_) {
+    if (!filter_->evaluate(request_info, *request_headers)) {
+      return;
+    }
+  }
+
+  // The entry and its serialization are reused by the logs of the thread. The file buffers the
+  // records written by each thread, and writes them in batches.
+  static thread_local envoy::data::accesslog::v2::HTTPAccessLogEntry log_entry;
+  static thread_local std::string log_record;
+  log_entry.Clear();
+  entry_builder_.build(*request_headers, *response_headers, *response_trailers, request_info,
+                       log_entry);
+
+  log_record.clear();
+  {
+    Protobuf::io::StringOutputStream stream(&log_record);
+    ProtobufUtil::SerializeDelimitedToZeroCopyStream(log_entry, &stream);
+  }
+  log_file_->write(log_record);
+}
+
+} // namespace BinaryFile
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "envoy/access_log/access_log.h"
+#include "envoy/config/accesslog/v2/binary_file.pb.h"
+
+#include "extensions/access_loggers/common/http_access_log_entry.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace BinaryFile {
+
+/**
+ * Access log Instance that writes HTTP logs to a file as length delimited HTTPAccessLogEntry
+ * messages.
+ */
+class BinaryFileAccessLog : public AccessLog::Instance {
+public:
+  BinaryFileAccessLog(const envoy::config::accesslog::v2::BinaryFileAccessLog& config,
+                      AccessLog::FilterPtr&& filter, AccessLog::AccessLogManager& log_manager);
+
+  // AccessLog::Instance
+  void log(const Http::HeaderMap* request_headers, const Http::HeaderMap* response_headers,
+           const Http::HeaderMap* response_trailers,
+           const RequestInfo::RequestInfo& request_info) override;
+
+private:
+  Filesystem::FileSharedPtr log_file_;
+  AccessLog::FilterPtr filter_;
+  const Common::HttpAccessLogEntryBuilder entry_builder_;
+};
+
+} // namespace BinaryFile
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
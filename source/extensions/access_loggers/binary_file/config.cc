@@ -0,0 +1,42 @@
+#include "extensions/access_loggers/binary_file/config.h"
+
+#include "envoy/config/accesslog/v2/binary_file.pb.validate.h"
+#include "envoy/registry/registry.h"
+#include "envoy/server/filter_config.h"
+
+#include "common/protobuf/protobuf.h"
+
+#include "extensions/access_loggers/binary_file/binary_file_access_log_impl.h"
+#include "extensions/access_loggers/well_known_names.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace BinaryFile {
+
+AccessLog::InstanceSharedPtr BinaryFileAccessLogFactory::createAccessLogInstance(
+    const Protobuf::Message& config, AccessLog::FilterPtr&& filter,
+    Server::Configuration::FactoryContext& context) {
+  const auto& proto_config = MessageUtil::downcastAndValidate<
+      const envoy::config::accesslog::v2::BinaryFileAccessLog&>(config);
+  return std::make_shared<BinaryFileAccessLog>(proto_config, std::move(filter),
+                                               context.accessLogManager());
+}
+
+ProtobufTypes::MessagePtr BinaryFileAccessLogFactory::createEmptyConfigProto() {
+  return ProtobufTypes::MessagePtr{new envoy::config::accesslog::v2::BinaryFileAccessLog()};
+}
+
+std::string BinaryFileAccessLogFactory::name() const { return AccessLogNames::get().BinaryFile; }
+
+/**
+ * Static registration for the binary file access log. @see RegisterFactory.
+ */
+static Registry::RegisterFactory<BinaryFileAccessLogFactory,
+                                 Server::Configuration::AccessLogInstanceFactory>
+    register_;
+
+} // namespace BinaryFile
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
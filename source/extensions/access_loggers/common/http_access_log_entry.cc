@@ -0,0 +1,268 @@
+#include "extensions/access_loggers/common/http_access_log_entry.h"
+
+#include "common/network/utility.h"
+#include "common/protobuf/protobuf.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace Common {
+
+HttpAccessLogEntryBuilder::HttpAccessLogEntryBuilder(
+    const Protobuf::RepeatedPtrField<ProtobufTypes::String>& request_headers_to_log,
+    const Protobuf::RepeatedPtrField<ProtobufTypes::String>& response_headers_to_log,
+    const Protobuf::RepeatedPtrField<ProtobufTypes::String>& response_trailers_to_log) {
+  for (const auto& header : request_headers_to_log) {
+    request_headers_to_log_.emplace_back(header);
+  }
+
+  for (const auto& header : response_headers_to_log) {
+    response_headers_to_log_.emplace_back(header);
+  }
+
+  for (const auto& header : response_trailers_to_log) {
+    response_trailers_to_log_.emplace_back(header);
+  }
+}
+
+void HttpAccessLogEntryBuilder::responseFlagsToAccessLogResponseFlags(
+    envoy::data::accesslog::v2::AccessLogCommon& common_access_log,
+    const RequestInfo::RequestInfo& request_info) {
+
+  static_assert(RequestInfo::ResponseFlag::LastFlag == 0x2000,
+                "A flag has been added. Fix this code.");
+
+  if (request_info.hasResponseFlag(RequestInfo::ResponseFlag::FailedLocalHealthCheck)) {
+    common_access_log.mutable_response_flags()->set_failed_local_healthcheck(true);
+  }
+
+  if (request_info.hasResponseFlag(RequestInfo::ResponseFlag::NoHealthyUpstream)) {
+    common_access_log.mutable_response_flags()->set_no_healthy_upstream(true);
+  }
+
+  if (request_info.hasResponseFlag(RequestInfo::ResponseFlag::UpstreamRequestTimeout)) {
+    common_access_log.mutable_response_flags()->set_upstream_request_timeout(true);
+  }
+
+  if (request_info.hasResponseFlag(RequestInfo::ResponseFlag::LocalReset)) {
+    common_access_log.mutable_response_flags()->set_local_reset(true);
+  }
+
+  if (request_info.hasResponseFlag(RequestInfo::ResponseFlag::UpstreamRemoteReset)) {
+    common_access_log.mutable_response_flags()->set_upstream_remote_reset(true);
+  }
+
+  if (request_info.hasResponseFlag(RequestInfo::ResponseFlag::UpstreamConnectionFailure)) {
+    common_access_log.mutable_response_flags()->set_upstream_connection_failure(true);
+  }
+
+  if (request_info.hasResponseFlag(RequestInfo::ResponseFlag::UpstreamConnectionTermination)) {
+    common_access_log.mutable_response_flags()->set_upstream_connection_termination(true);
+  }
+
+  if (request_info.hasResponseFlag(RequestInfo::ResponseFlag::UpstreamOverflow)) {
+    common_access_log.mutable_response_flags()->set_upstream_overflow(true);
+  }
+
+  if (request_info.hasResponseFlag(RequestInfo::ResponseFlag::NoRouteFound)) {
+    common_access_log.mutable_response_flags()->set_no_route_found(true);
+  }
+
+  if (request_info.hasResponseFlag(RequestInfo::ResponseFlag::DelayInjected)) {
+    common_access_log.mutable_response_flags()->set_delay_injected(true);
+  }
+
+  if (request_info.hasResponseFlag(RequestInfo::ResponseFlag::FaultInjected)) {
+    common_access_log.mutable_response_flags()->set_fault_injected(true);
+  }
+
+  if (request_info.hasResponseFlag(RequestInfo::ResponseFlag::RateLimited)) {
+    common_access_log.mutable_response_flags()->set_rate_limited(true);
+  }
+
+  if (request_info.hasResponseFlag(RequestInfo::ResponseFlag::UnauthorizedExternalService)) {
+    common_access_log.mutable_response_flags()->mutable_unauthorized_details()->set_reason(
+        envoy::data::accesslog::v2::ResponseFlags_Unauthorized_Reason::
+            ResponseFlags_Unauthorized_Reason_EXTERNAL_SERVICE);
+  }
+
+  if (request_info.hasResponseFlag(RequestInfo::ResponseFlag::RateLimitServiceError)) {
+    common_access_log.mutable_response_flags()->set_rate_limit_service_error(true);
+  }
+}
+
+void HttpAccessLogEntryBuilder::build(
+    const Http::HeaderMap& request_headers, const Http::HeaderMap& response_headers,
+    const Http::HeaderMap& response_trailers, const RequestInfo::RequestInfo& request_info,
+    envoy::data::accesslog::v2::HTTPAccessLogEntry& log_entry) const {
+  // Common log properties.
+  // TODO(mattklein123): Populate sample_rate field.
+  // TODO(mattklein123): Populate tls_properties field.
+  // TODO(mattklein123): Populate metadata field and wire up to filters.
+  auto* common_properties = log_entry.mutable_common_properties();
+
+  if (request_info.downstreamRemoteAddress() != nullptr) {
+    Network::Utility::addressToProtobufAddress(
+        *request_info.downstreamRemoteAddress(),
+        *common_properties->mutable_downstream_remote_address());
+  }
+  if (request_info.downstreamLocalAddress() != nullptr) {
+    Network::Utility::addressToProtobufAddress(
+        *request_info.downstreamLocalAddress(),
+        *common_properties->mutable_downstream_local_address());
+  }
+  common_properties->mutable_start_time()->MergeFrom(
+      Protobuf::util::TimeUtil::NanosecondsToTimestamp(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              request_info.startTime().time_since_epoch())
+              .count()));
+
+  absl::optional<std::chrono::nanoseconds> dur = request_info.lastDownstreamRxByteReceived();
+  if (dur) {
+    common_properties->mutable_time_to_last_rx_byte()->MergeFrom(
+        Protobuf::util::TimeUtil::NanosecondsToDuration(dur.value().count()));
+  }
+
+  dur = request_info.firstUpstreamTxByteSent();
+  if (dur) {
+    common_properties->mutable_time_to_first_upstream_tx_byte()->MergeFrom(
+        Protobuf::util::TimeUtil::NanosecondsToDuration(dur.value().count()));
+  }
+
+  dur = request_info.lastUpstreamTxByteSent();
+  if (dur) {
+    common_properties->mutable_time_to_last_upstream_tx_byte()->MergeFrom(
+        Protobuf::util::TimeUtil::NanosecondsToDuration(dur.value().count()));
+  }
+
+  dur = request_info.firstUpstreamRxByteReceived();
+  if (dur) {
+    common_properties->mutable_time_to_first_upstream_rx_byte()->MergeFrom(
+        Protobuf::util::TimeUtil::NanosecondsToDuration(dur.value().count()));
+  }
+
+  dur = request_info.lastUpstreamRxByteReceived();
+  if (dur) {
+    common_properties->mutable_time_to_last_upstream_rx_byte()->MergeFrom(
+        Protobuf::util::TimeUtil::NanosecondsToDuration(dur.value().count()));
+  }
+
+  dur = request_info.firstDownstreamTxByteSent();
+  if (dur) {
+    common_properties->mutable_time_to_first_downstream_tx_byte()->MergeFrom(
+        Protobuf::util::TimeUtil::NanosecondsToDuration(dur.value().count()));
+  }
+
+  dur = request_info.lastDownstreamTxByteSent();
+  if (dur) {
+    common_properties->mutable_time_to_last_downstream_tx_byte()->MergeFrom(
+        Protobuf::util::TimeUtil::NanosecondsToDuration(dur.value().count()));
+  }
+
+  if (request_info.upstreamHost() != nullptr) {
+    Network::Utility::addressToProtobufAddress(
+        *request_info.upstreamHost()->address(),
+        *common_properties->mutable_upstream_remote_address());
+    common_properties->set_upstream_cluster(request_info.upstreamHost()->cluster().name());
+  }
+  if (request_info.upstreamLocalAddress() != nullptr) {
+    Network::Utility::addressToProtobufAddress(
+        *request_info.upstreamLocalAddress(), *common_properties->mutable_upstream_local_address());
+  }
+  responseFlagsToAccessLogResponseFlags(*common_properties, request_info);
+
+  if (request_info.protocol()) {
+    switch (request_info.protocol().value()) {
+    case Http::Protocol::Http10:
+      log_entry.set_protocol_version(envoy::data::accesslog::v2::HTTPAccessLogEntry::HTTP10);
+      break;
+    case Http::Protocol::Http11:
+      log_entry.set_protocol_version(envoy::data::accesslog::v2::HTTPAccessLogEntry::HTTP11);
+      break;
+    case Http::Protocol::Http2:
+      log_entry.set_protocol_version(envoy::data::accesslog::v2::HTTPAccessLogEntry::HTTP2);
+      break;
+    }
+  }
+
+  // HTTP request properties.
+  // TODO(mattklein123): Populate port field.
+  auto* request_properties = log_entry.mutable_request();
+  if (request_headers.Scheme() != nullptr) {
+    request_properties->set_scheme(request_headers.Scheme()->value().c_str());
+  }
+  if (request_headers.Host() != nullptr) {
+    request_properties->set_authority(request_headers.Host()->value().c_str());
+  }
+  if (request_headers.Path() != nullptr) {
+    request_properties->set_path(request_headers.Path()->value().c_str());
+  }
+  if (request_headers.UserAgent() != nullptr) {
+    request_properties->set_user_agent(request_headers.UserAgent()->value().c_str());
+  }
+  if (request_headers.Referer() != nullptr) {
+    request_properties->set_referer(request_headers.Referer()->value().c_str());
+  }
+  if (request_headers.ForwardedFor() != nullptr) {
+    request_properties->set_forwarded_for(request_headers.ForwardedFor()->value().c_str());
+  }
+  if (request_headers.RequestId() != nullptr) {
+    request_properties->set_request_id(request_headers.RequestId()->value().c_str());
+  }
+  if (request_headers.EnvoyOriginalPath() != nullptr) {
+    request_properties->set_original_path(request_headers.EnvoyOriginalPath()->value().c_str());
+  }
+  request_properties->set_request_headers_bytes(request_headers.byteSize());
+  request_properties->set_request_body_bytes(request_info.bytesReceived());
+  if (request_headers.Method() != nullptr) {
+    envoy::api::v2::core::RequestMethod method =
+        envoy::api::v2::core::RequestMethod::METHOD_UNSPECIFIED;
+    envoy::api::v2::core::RequestMethod_Parse(
+        std::string(request_headers.Method()->value().c_str()), &method);
+    request_properties->set_request_method(method);
+  }
+  if (!request_headers_to_log_.empty()) {
+    auto* logged_headers = request_properties->mutable_request_headers();
+
+    for (const auto& header : request_headers_to_log_) {
+      const Http::HeaderEntry* entry = request_headers.get(header);
+      if (entry != nullptr) {
+        logged_headers->insert({header.get(), ProtobufTypes::String(entry->value().c_str())});
+      }
+    }
+  }
+
+  // HTTP response properties.
+  auto* response_properties = log_entry.mutable_response();
+  if (request_info.responseCode()) {
+    response_properties->mutable_response_code()->set_value(request_info.responseCode().value());
+  }
+  response_properties->set_response_headers_bytes(response_headers.byteSize());
+  response_properties->set_response_body_bytes(request_info.bytesSent());
+  if (!response_headers_to_log_.empty()) {
+    auto* logged_headers = response_properties->mutable_response_headers();
+
+    for (const auto& header : response_headers_to_log_) {
+      const Http::HeaderEntry* entry = response_headers.get(header);
+      if (entry != nullptr) {
+        logged_headers->insert({header.get(), ProtobufTypes::String(entry->value().c_str())});
+      }
+    }
+  }
+
+  if (!response_trailers_to_log_.empty()) {
+    auto* logged_headers = response_properties->mutable_response_trailers();
+
+    for (const auto& header : response_trailers_to_log_) {
+      const Http::HeaderEntry* entry = response_trailers.get(header);
+      if (entry != nullptr) {
+        logged_headers->insert({header.get(), ProtobufTypes::String(entry->value().c_str())});
+      }
+    }
+  }
+}
+
+} // namespace Common
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+
+#include "envoy/data/accesslog/v2/accesslog.pb.h"
+#include "envoy/http/header_map.h"
+#include "envoy/request_info/request_info.h"
+
+#include "common/protobuf/protobuf.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace Common {
+
+/**
+ * Builds the HTTPAccessLogEntry of a request, which the access logs writing HTTP logs as protobuf
+ * share.
+ */
+class HttpAccessLogEntryBuilder {
+public:
+  /**
+   * @param request_headers_to_log supplies the additional request headers to log.
+   * @param response_headers_to_log supplies the additional response headers to log.
+   * @param response_trailers_to_log supplies the additional response trailers to log.
+   */
+  HttpAccessLogEntryBuilder(
+      const Protobuf::RepeatedPtrField<ProtobufTypes::String>& request_headers_to_log,
+      const Protobuf::RepeatedPtrField<ProtobufTypes::String>& response_headers_to_log,
+      const Protobuf::RepeatedPtrField<ProtobufTypes::String>& response_trailers_to_log);
+
+  static void responseFlagsToAccessLogResponseFlags(
+      envoy::data::accesslog::v2::AccessLogCommon& common_access_log,
+      const RequestInfo::RequestInfo& request_info);
+
+  /**
+   * Fills the log entry of a request.
+   * @param log_entry supplies the entry to fill, which is expected to be empty.
+   */
+  void build(const Http::HeaderMap& request_headers, const Http::HeaderMap& response_headers,
+             const Http::HeaderMap& response_trailers, const RequestInfo::RequestInfo& request_info,
+             envoy::data::accesslog::v2::HTTPAccessLogEntry& log_entry) const;
+
+private:
+  std::vector<Http::LowerCaseString> request_headers_to_log_;
+  std::vector<Http::LowerCaseString> response_headers_to_log_;
+  std::vector<Http::LowerCaseString> response_trailers_to_log_;
+};
+
+} // namespace Common
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
@@ -35,8 +35,13 @@ void FileAccessLog::log(const Http::HeaderMap* request_headers,
     }
   }
 
-  log_file_->write(
-      formatter_->format(*request_headers, *response_headers, *response_trailers, request_info));
+  // The log line is formatted into a buffer reused by the logs of the thread, which the file
+  // copies.
+  static thread_local std::string log_line;
+  log_line.clear();
+  formatter_->formatTo(*request_headers, *response_headers, *response_trailers, request_info,
+                       log_line);
+  log_file_->write(log_line);
 }
 
 } // namespace File
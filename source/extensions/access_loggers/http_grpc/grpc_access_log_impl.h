@@ -1,24 +1,42 @@
 #pragma once
 
 #include <unordered_map>
-#include <vector>
 
 #include "envoy/access_log/access_log.h"
 #include "envoy/config/accesslog/v2/als.pb.h"
 #include "envoy/config/filter/accesslog/v2/accesslog.pb.h"
+#include "envoy/event/timer.h"
 #include "envoy/grpc/async_client.h"
 #include "envoy/grpc/async_client_manager.h"
 #include "envoy/local_info/local_info.h"
 #include "envoy/service/accesslog/v2/als.pb.h"
 #include "envoy/singleton/instance.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
 #include "envoy/thread_local/thread_local.h"
 
+#include "extensions/access_loggers/common/http_access_log_entry.h"
+
 namespace Envoy {
 namespace Extensions {
 namespace AccessLoggers {
 namespace HttpGrpc {
 
-// TODO(mattklein123): Stats
+/**
+ * All HTTP gRPC access log stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_HTTP_GRPC_ACCESS_LOG_STATS(COUNTER)                                                    \
+  COUNTER(logs_written)                                                                            \
+  COUNTER(logs_dropped)
+// clang-format on
+
+/**
+ * Struct definition for all HTTP gRPC access log stats. @see stats_macros.h
+ */
+struct HttpGrpcAccessLogStats {
+  ALL_HTTP_GRPC_ACCESS_LOG_STATS(GENERATE_COUNTER_STRUCT)
+};
 
 /**
  * Interface for an access log streamer. The streamer deals with threading and sends access logs
@@ -32,8 +50,9 @@ public:
    * Send an access log.
    * @param message supplies the access log to send.
    * @param log_name supplies the name of the log stream to send on.
+   * @return bool whether the message was sent, which fails if the stream couldn't be started.
    */
-  virtual void send(envoy::service::accesslog::v2::StreamAccessLogsMessage& message,
+  virtual bool send(envoy::service::accesslog::v2::StreamAccessLogsMessage& message,
                     const std::string& log_name) PURE;
 };
 
@@ -49,9 +68,9 @@ public:
                             const LocalInfo::LocalInfo& local_info);
 
   // GrpcAccessLogStreamer
-  void send(envoy::service::accesslog::v2::StreamAccessLogsMessage& message,
+  bool send(envoy::service::accesslog::v2::StreamAccessLogsMessage& message,
             const std::string& log_name) override {
-    tls_slot_->getTyped<ThreadLocalStreamer>().send(message, log_name);
+    return tls_slot_->getTyped<ThreadLocalStreamer>().send(message, log_name);
   }
 
 private:
@@ -97,7 +116,7 @@ private:
    */
   struct ThreadLocalStreamer : public ThreadLocal::ThreadLocalObject {
     ThreadLocalStreamer(const SharedStateSharedPtr& shared_state);
-    void send(envoy::service::accesslog::v2::StreamAccessLogsMessage& message,
+    bool send(envoy::service::accesslog::v2::StreamAccessLogsMessage& message,
               const std::string& log_name);
 
     Grpc::AsyncClientPtr client_;
@@ -109,17 +128,15 @@ private:
 };
 
 /**
- * Access log Instance that streams HTTP logs over gRPC.
+ * Access log Instance that streams HTTP logs over gRPC. The logs of each worker are buffered and
+ * sent in batches, when their size reaches the configured limit or by a timer.
  */
 class HttpGrpcAccessLog : public AccessLog::Instance {
 public:
   HttpGrpcAccessLog(AccessLog::FilterPtr&& filter,
                     const envoy::config::accesslog::v2::HttpGrpcAccessLogConfig& config,
-                    GrpcAccessLogStreamerSharedPtr grpc_access_log_streamer);
-
-  static void responseFlagsToAccessLogResponseFlags(
-      envoy::data::accesslog::v2::AccessLogCommon& common_access_log,
-      const RequestInfo::RequestInfo& request_info);
+                    GrpcAccessLogStreamerSharedPtr grpc_access_log_streamer,
+                    ThreadLocal::SlotAllocator& tls, Stats::Scope& scope);
 
   // AccessLog::Instance
   void log(const Http::HeaderMap* request_headers, const Http::HeaderMap* response_headers,
@@ -127,12 +144,47 @@ public:
            const RequestInfo::RequestInfo& request_info) override;
 
 private:
+  /**
+   * Shared state that is owned by the per-thread loggers. This allows the access log to be
+   * destroyed while the loggers hold onto the shared state.
+   */
+  struct SharedState {
+    SharedState(GrpcAccessLogStreamerSharedPtr grpc_access_log_streamer,
+                const std::string& log_name, uint64_t buffer_size_bytes,
+                std::chrono::milliseconds buffer_flush_interval,
+                const HttpGrpcAccessLogStats& stats)
+        : grpc_access_log_streamer_(grpc_access_log_streamer), log_name_(log_name),
+          buffer_size_bytes_(buffer_size_bytes), buffer_flush_interval_(buffer_flush_interval),
+          stats_(stats) {}
+
+    GrpcAccessLogStreamerSharedPtr grpc_access_log_streamer_;
+    const std::string log_name_;
+    const uint64_t buffer_size_bytes_;
+    const std::chrono::milliseconds buffer_flush_interval_;
+    HttpGrpcAccessLogStats stats_;
+  };
+
+  typedef std::shared_ptr<SharedState> SharedStateSharedPtr;
+
+  /**
+   * Per-thread buffer of log entries. The message is cleared rather than destroyed once sent, so
+   * that the entries allocated by a batch are reused by the next one.
+   */
+  struct ThreadLocalLogger : public ThreadLocal::ThreadLocalObject {
+    ThreadLocalLogger(const SharedStateSharedPtr& shared_state, Event::Dispatcher& dispatcher);
+    void flush();
+
+    SharedStateSharedPtr shared_state_;
+    envoy::service::accesslog::v2::StreamAccessLogsMessage message_;
+    uint64_t approximate_message_size_bytes_{};
+    Event::TimerPtr flush_timer_;
+  };
+
   AccessLog::FilterPtr filter_;
   const envoy::config::accesslog::v2::HttpGrpcAccessLogConfig config_;
-  GrpcAccessLogStreamerSharedPtr grpc_access_log_streamer_;
-  std::vector<Http::LowerCaseString> request_headers_to_log_;
-  std::vector<Http::LowerCaseString> response_headers_to_log_;
-  std::vector<Http::LowerCaseString> response_trailers_to_log_;
+  const Common::HttpAccessLogEntryBuilder entry_builder_;
+  SharedStateSharedPtr shared_state_;
+  ThreadLocal::SlotPtr tls_slot_;
 };
 
 } // namespace HttpGrpc
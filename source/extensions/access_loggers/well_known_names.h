@@ -14,6 +14,8 @@ class AccessLogNameValues {
 public:
   // File access log
   const std::string File = "envoy.file_access_log";
+  // Binary file access log
+  const std::string BinaryFile = "envoy.access_loggers.binary_file";
   // HTTP gRPC access log
   const std::string HttpGrpc = "envoy.http_grpc_access_log";
 };
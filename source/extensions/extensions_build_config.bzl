@@ -4,6 +4,7 @@ EXTENSIONS = {
     # Access loggers
     #
 
+    "envoy.access_loggers.binary_file":                 "//source/extensions/access_loggers/binary_file:config",
     "envoy.access_loggers.file":                        "//source/extensions/access_loggers/file:config",
     "envoy.access_loggers.http_grpc":                   "//source/extensions/access_loggers/http_grpc:config",
 
@@ -23,9 +24,14 @@ EXTENSIONS = {
     # HTTP filters
     #
 
+    "envoy.filters.http.adaptive_concurrency":          "//source/extensions/filters/http/adaptive_concurrency:config",
     "envoy.filters.http.buffer":                        "//source/extensions/filters/http/buffer:config",
+    "envoy.filters.http.cache":                         "//source/extensions/filters/http/cache:config",
     "envoy.filters.http.cors":                          "//source/extensions/filters/http/cors:config",
+    "envoy.filters.http.decompressor":                  "//source/extensions/filters/http/decompressor:config",
     "envoy.filters.http.dynamo":                        "//source/extensions/filters/http/dynamo:config",
+    "envoy.filters.http.dynamic_forward_proxy":         "//source/extensions/filters/http/dynamic_forward_proxy:config",
+    "envoy.filters.http.dynamic_module":                "//source/extensions/filters/http/dynamic_module:config",
     "envoy.filters.http.ext_authz":                     "//source/extensions/filters/http/ext_authz:config",
     "envoy.filters.http.fault":                         "//source/extensions/filters/http/fault:config",
     "envoy.filters.http.grpc_http1_bridge":             "//source/extensions/filters/http/grpc_http1_bridge:config",
@@ -36,9 +42,12 @@ EXTENSIONS = {
     "envoy.filters.http.health_check":                  "//source/extensions/filters/http/health_check:config",
     "envoy.filters.http.ip_tagging":                    "//source/extensions/filters/http/ip_tagging:config",
     "envoy.filters.http.jwt_authn":                     "//source/extensions/filters/http/jwt_authn:config",
+    "envoy.filters.http.local_ratelimit":               "//source/extensions/filters/http/local_ratelimit:config",
     "envoy.filters.http.lua":                           "//source/extensions/filters/http/lua:config",
+    "envoy.filters.http.on_demand_cluster":             "//source/extensions/filters/http/on_demand_cluster:config",
     "envoy.filters.http.ratelimit":                     "//source/extensions/filters/http/ratelimit:config",
     "envoy.filters.http.rbac":                          "//source/extensions/filters/http/rbac:config",
+    "envoy.filters.http.request_coalescing":            "//source/extensions/filters/http/request_coalescing:config",
     "envoy.filters.http.router":                        "//source/extensions/filters/http/router:config",
     "envoy.filters.http.squash":                        "//source/extensions/filters/http/squash:config",
 
@@ -61,9 +70,11 @@ EXTENSIONS = {
     #
 
     "envoy.filters.network.client_ssl_auth":            "//source/extensions/filters/network/client_ssl_auth:config",
+    "envoy.filters.network.dynamic_module":             "//source/extensions/filters/network/dynamic_module:config",
     "envoy.filters.network.echo":                       "//source/extensions/filters/network/echo:config",
     "envoy.filters.network.ext_authz":                  "//source/extensions/filters/network/ext_authz:config",
     "envoy.filters.network.http_connection_manager":    "//source/extensions/filters/network/http_connection_manager:config",
+    "envoy.filters.network.local_ratelimit":            "//source/extensions/filters/network/local_ratelimit:config",
     "envoy.filters.network.mongo_proxy":                "//source/extensions/filters/network/mongo_proxy:config",
     "envoy.filters.network.ratelimit":                  "//source/extensions/filters/network/ratelimit:config",
     "envoy.filters.network.rbac":                       "//source/extensions/filters/network/rbac:config",
@@ -71,10 +82,23 @@ EXTENSIONS = {
     "envoy.filters.network.tcp_proxy":                  "//source/extensions/filters/network/tcp_proxy:config",
     "envoy.filters.network.thrift_proxy":               "//source/extensions/filters/network/thrift_proxy:config",
 
+    #
+    # UDP listener filters
+    #
+
+    "envoy.filters.udp_listener.udp_proxy":             "//source/extensions/filters/udp/udp_proxy:config",
+
+    #
+    # Private key providers
+    #
+
+    "envoy.private_key_providers.thread_pool":          "//source/extensions/private_key_providers/thread_pool:config",
+
     #
     # Resource monitors
     #
 
+    "envoy.resource_monitors.cpu_utilization":          "//source/extensions/resource_monitors/cpu_utilization:config",
     "envoy.resource_monitors.fixed_heap":               "//source/extensions/resource_monitors/fixed_heap:config",
     "envoy.resource_monitors.injected_resource":        "//source/extensions/resource_monitors/injected_resource:config",
 
@@ -108,6 +132,7 @@ EXTENSIONS = {
     # TODO(lizan): switch to config target once a transport socket exists
     "envoy.transport_sockets.alts":                     "//source/extensions/transport_sockets/alts:tsi_handshaker",
     "envoy.transport_sockets.capture":                  "//source/extensions/transport_sockets/capture:config",
+    "envoy.transport_sockets.ktls":                     "//source/extensions/transport_sockets/ktls:config",
 }
 
 WINDOWS_EXTENSIONS = {
@@ -115,6 +140,7 @@ WINDOWS_EXTENSIONS = {
     # Access loggers
     #
 
+    "envoy.access_loggers.binary_file":                 "//source/extensions/access_loggers/binary_file:config",
     "envoy.access_loggers.file":                        "//source/extensions/access_loggers/file:config",
     #"envoy.access_loggers.http_grpc":                   "//source/extensions/access_loggers/http_grpc:config",
 
@@ -146,6 +172,7 @@ WINDOWS_EXTENSIONS = {
     #"envoy.filters.http.health_check":                  "//source/extensions/filters/http/health_check:config",
     #"envoy.filters.http.ip_tagging":                    "//source/extensions/filters/http/ip_tagging:config",
     #"envoy.filters.http.lua":                           "//source/extensions/filters/http/lua:config",
+    #"envoy.filters.http.on_demand_cluster":             "//source/extensions/filters/http/on_demand_cluster:config",
     #"envoy.filters.http.ratelimit":                     "//source/extensions/filters/http/ratelimit:config",
     #"envoy.filters.http.rbac":                          "//source/extensions/filters/http/rbac:config",
     #"envoy.filters.http.router":                        "//source/extensions/filters/http/router:config",
@@ -179,6 +206,12 @@ WINDOWS_EXTENSIONS = {
     "envoy.filters.network.tcp_proxy":                  "//source/extensions/filters/network/tcp_proxy:config",
     #"envoy.filters.network.thrift_proxy":               "//source/extensions/filters/network/thrift_proxy:config",
 
+    #
+    # UDP listener filters
+    #
+
+    #"envoy.filters.udp_listener.udp_proxy":             "//source/extensions/filters/udp/udp_proxy:config",
+
     #
     # Stat sinks
     #
@@ -200,4 +233,5 @@ WINDOWS_EXTENSIONS = {
     #
 
     #"envoy.transport_sockets.capture":                  "//source/extensions/transport_sockets/capture:config",
+    #"envoy.transport_sockets.ktls":                     "//source/extensions/transport_sockets/ktls:config",
 }
@@ -0,0 +1,143 @@
+#pragma once
+
+/**
+ * C ABI between Envoy and the dynamic modules, which are shared objects compiled ahead of time
+ * from any language able to export C functions. This header is included by the modules, so it must
+ * remain valid C and must not include any Envoy header.
+ *
+ * A module is loaded once per filter configuration, and its code is shared by all the workers:
+ * 1) envoy_dynamic_module_on_init() is called on the main thread with the configuration of the
+ *    module, and returns the context of the module.
+ * 2) envoy_dynamic_module_on_worker_init() is then called on each worker with the context of the
+ *    module, and returns the context of the worker. Modules keep their per worker state there, so
+ *    that the streams and connections never need to synchronize with each other.
+ * 3) The streams and connections handled by a worker create their own context from the context of
+ *    the worker, and give it back to the module in every callback along with a host handle. The
+ *    host handle is only valid for the duration of the callback, and is passed to the functions of
+ *    envoy_dynamic_module_host_api to access the stream or connection.
+ *
+ * The headers and data are given to the modules without any copy: the buffers returned by the host
+ * API point into the memory of Envoy, and are only valid until the end of the callback or until
+ * they are modified, whichever comes first.
+ *
+ * Only envoy_dynamic_module_abi_version() and envoy_dynamic_module_on_init() must be exported. The
+ * callbacks which a module doesn't export are skipped.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * The version of the ABI, which is increased by every incompatible change. Modules must return it
+ * from envoy_dynamic_module_abi_version().
+ */
+#define ENVOY_DYNAMIC_MODULE_ABI_VERSION 1
+
+/**
+ * A contiguous slice of memory owned by Envoy.
+ */
+typedef struct {
+  const char* data;
+  size_t length;
+} envoy_dynamic_module_buffer;
+
+/**
+ * The functions which modules call to access the streams and the connections. The host handle is
+ * the one given to the callback being run.
+ */
+typedef struct {
+  /**
+   * Finds a header of the headers given to the current callback.
+   * @param host supplies the host handle.
+   * @param key supplies the name of the header, compared ignoring case.
+   * @param value receives the value of the header.
+   * @return 1 if the header was found, 0 otherwise.
+   */
+  int (*get_header)(void* host, const char* key, size_t key_length,
+                    envoy_dynamic_module_buffer* value);
+
+  /**
+   * Sets a header of the headers given to the current callback, replacing its existing values.
+   */
+  void (*set_header)(void* host, const char* key, size_t key_length, const char* value,
+                     size_t value_length);
+
+  /**
+   * Removes a header of the headers given to the current callback.
+   */
+  void (*remove_header)(void* host, const char* key, size_t key_length);
+
+  /**
+   * Gets the slices of the data given to the current callback.
+   * @param host supplies the host handle.
+   * @param slices receives up to max_slices slices.
+   * @param max_slices supplies the capacity of slices.
+   * @return the number of slices of the data, which may be larger than max_slices.
+   */
+  size_t (*get_data_slices)(void* host, envoy_dynamic_module_buffer* slices, size_t max_slices);
+
+  /**
+   * Sends a local reply to the downstream of an HTTP stream, which stops the stream. Only honored
+   * in the request callbacks, as the response may already be on its way downstream afterwards.
+   */
+  void (*send_local_reply)(void* host, uint32_t status_code, const char* body, size_t body_length);
+
+  /**
+   * Closes the connection of a network filter, which stops the data from being forwarded.
+   */
+  void (*close_connection)(void* host);
+} envoy_dynamic_module_host_api;
+
+/**
+ * The functions exported by the modules, named after their type without the "_fn" suffix:
+ * - envoy_dynamic_module_abi_version
+ * - envoy_dynamic_module_on_init, envoy_dynamic_module_on_destroy
+ * - envoy_dynamic_module_on_worker_init, envoy_dynamic_module_on_worker_destroy
+ * - envoy_dynamic_module_on_http_stream_create, envoy_dynamic_module_on_http_stream_destroy
+ * - envoy_dynamic_module_on_http_request_headers, envoy_dynamic_module_on_http_request_data,
+ *   envoy_dynamic_module_on_http_response_headers, envoy_dynamic_module_on_http_response_data,
+ *   of type envoy_dynamic_module_on_http_fn
+ * - envoy_dynamic_module_on_network_connection_create,
+ *   envoy_dynamic_module_on_network_connection_destroy
+ * - envoy_dynamic_module_on_network_read, envoy_dynamic_module_on_network_write, of type
+ *   envoy_dynamic_module_on_network_data_fn
+ * When a module doesn't export envoy_dynamic_module_on_worker_init(), the context of the workers
+ * is the context of the module, and likewise for the contexts of the streams and connections.
+ */
+typedef uint32_t (*envoy_dynamic_module_abi_version_fn)(void);
+
+/**
+ * @param config supplies the configuration of the module.
+ * @param host_api supplies the host API, which remains valid until the module is destroyed.
+ * @return the context of the module, or NULL if the configuration is rejected.
+ */
+typedef void* (*envoy_dynamic_module_on_init_fn)(const char* config, size_t config_length,
+                                                 const envoy_dynamic_module_host_api* host_api);
+typedef void (*envoy_dynamic_module_on_destroy_fn)(void* module);
+
+typedef void* (*envoy_dynamic_module_on_worker_init_fn)(void* module);
+typedef void (*envoy_dynamic_module_on_worker_destroy_fn)(void* worker);
+
+typedef void* (*envoy_dynamic_module_on_http_stream_create_fn)(void* worker);
+typedef void (*envoy_dynamic_module_on_http_stream_destroy_fn)(void* stream);
+/**
+ * The HTTP callbacks, in which the module may inspect and modify the headers, inspect the data,
+ * and stop the stream with a local reply.
+ */
+typedef void (*envoy_dynamic_module_on_http_fn)(void* stream, void* host, int end_stream);
+
+typedef void* (*envoy_dynamic_module_on_network_connection_create_fn)(void* worker);
+typedef void (*envoy_dynamic_module_on_network_connection_destroy_fn)(void* connection);
+/**
+ * The network callbacks, in which the module may inspect the data and close the connection.
+ */
+typedef void (*envoy_dynamic_module_on_network_data_fn)(void* connection, void* host,
+                                                        int end_stream);
+
+#ifdef __cplusplus
+}
+#endif
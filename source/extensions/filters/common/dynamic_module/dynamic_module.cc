@@ -0,0 +1,168 @@
+#include "extensions/filters/common/dynamic_module/dynamic_module.h"
+
+#include <dlfcn.h>
+
+#include "envoy/common/exception.h"
+
+#include "common/common/assert.h"
+#include "common/common/fmt.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Filters {
+namespace Common {
+namespace DynamicModule {
+
+namespace {
+
+HostContext& hostContext(void* host) { return *static_cast<HostContext*>(host); }
+
+int getHeader(void* host, const char* key, size_t key_length, envoy_dynamic_module_buffer* value) {
+  Http::HeaderMap* headers = hostContext(host).headers();
+  if (headers == nullptr) {
+    return 0;
+  }
+  const Http::HeaderEntry* entry =
+      headers->get(Http::LowerCaseString(std::string(key, key_length)));
+  if (entry == nullptr) {
+    return 0;
+  }
+  const absl::string_view header_value = entry->value().getStringView();
+  value->data = header_value.data();
+  value->length = header_value.size();
+  return 1;
+}
+
+void setHeader(void* host, const char* key, size_t key_length, const char* value,
+               size_t value_length) {
+  Http::HeaderMap* headers = hostContext(host).headers();
+  if (headers != nullptr) {
+    const Http::LowerCaseString lower_key(std::string(key, key_length));
+    headers->remove(lower_key);
+    headers->addCopy(lower_key, std::string(value, value_length));
+  }
+}
+
+void removeHeader(void* host, const char* key, size_t key_length) {
+  Http::HeaderMap* headers = hostContext(host).headers();
+  if (headers != nullptr) {
+    headers->remove(Http::LowerCaseString(std::string(key, key_length)));
+  }
+}
+
+size_t getDataSlices(void* host, envoy_dynamic_module_buffer* slices, size_t max_slices) {
+  Buffer::Instance* data = hostContext(host).data();
+  if (data == nullptr) {
+    return 0;
+  }
+  const uint64_t num_slices = data->getRawSlices(nullptr, 0);
+  Buffer::RawSlice raw_slices[num_slices];
+  data->getRawSlices(raw_slices, num_slices);
+  for (uint64_t i = 0; i < num_slices && i < max_slices; i++) {
+    slices[i].data = static_cast<const char*>(raw_slices[i].mem_);
+    slices[i].length = raw_slices[i].len_;
+  }
+  return num_slices;
+}
+
+void sendLocalReply(void* host, uint32_t status_code, const char* body, size_t body_length) {
+  hostContext(host).sendLocalReply(static_cast<Http::Code>(status_code),
+                                   absl::string_view(body, body_length));
+}
+
+void closeConnection(void* host) { hostContext(host).closeConnection(); }
+
+} // namespace
+
+const envoy_dynamic_module_host_api& Library::hostApi() {
+  static const envoy_dynamic_module_host_api host_api{
+      getHeader, setHeader, removeHeader, getDataSlices, sendLocalReply, closeConnection};
+  return host_api;
+}
+
+Library::Library(const std::string& path, const std::string& config) {
+  // The symbols of the module are kept local, so that modules exporting the same functions can be
+  // loaded side by side.
+  handle_ = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (handle_ == nullptr) {
+    throw EnvoyException(fmt::format("unable to load dynamic module {}: {}", path, dlerror()));
+  }
+
+  try {
+    const auto abi_version =
+        reinterpret_cast<envoy_dynamic_module_abi_version_fn>(symbol("abi_version"));
+    const auto on_init = reinterpret_cast<envoy_dynamic_module_on_init_fn>(symbol("on_init"));
+    if (abi_version == nullptr || on_init == nullptr) {
+      throw EnvoyException(fmt::format("dynamic module {} doesn't export the required functions",
+                                       path));
+    }
+    if (abi_version() != ENVOY_DYNAMIC_MODULE_ABI_VERSION) {
+      throw EnvoyException(fmt::format("dynamic module {} implements ABI version {}, expected {}",
+                                       path, abi_version(), ENVOY_DYNAMIC_MODULE_ABI_VERSION));
+    }
+
+#define LOAD_CALLBACK(name)                                                                        \
+  callbacks_.name##_ = reinterpret_cast<decltype(callbacks_.name##_)>(symbol(#name))
+    LOAD_CALLBACK(on_destroy);
+    LOAD_CALLBACK(on_worker_init);
+    LOAD_CALLBACK(on_worker_destroy);
+    LOAD_CALLBACK(on_http_stream_create);
+    LOAD_CALLBACK(on_http_stream_destroy);
+    LOAD_CALLBACK(on_http_request_headers);
+    LOAD_CALLBACK(on_http_request_data);
+    LOAD_CALLBACK(on_http_response_headers);
+    LOAD_CALLBACK(on_http_response_data);
+    LOAD_CALLBACK(on_network_connection_create);
+    LOAD_CALLBACK(on_network_connection_destroy);
+    LOAD_CALLBACK(on_network_read);
+    LOAD_CALLBACK(on_network_write);
+#undef LOAD_CALLBACK
+
+    context_ = on_init(config.data(), config.size(), &hostApi());
+    if (context_ == nullptr) {
+      throw EnvoyException(fmt::format("dynamic module {} rejected its configuration", path));
+    }
+  } catch (const EnvoyException&) {
+    dlclose(handle_);
+    throw;
+  }
+
+  ENVOY_LOG(debug, "loaded dynamic module {}", path);
+}
+
+Library::~Library() {
+  if (callbacks_.on_destroy_ != nullptr) {
+    callbacks_.on_destroy_(context_);
+  }
+  dlclose(handle_);
+}
+
+void* Library::symbol(const std::string& name) {
+  return dlsym(handle_, ("envoy_dynamic_module_" + name).c_str());
+}
+
+Module::Module(const std::string& path, const std::string& config, ThreadLocal::SlotAllocator& tls)
+    : library_(std::make_shared<Library>(path, config)), tls_slot_(tls.allocateSlot()) {
+  LibrarySharedPtr library = library_;
+  tls_slot_->set([library](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<WorkerContext>(library);
+  });
+}
+
+Module::WorkerContext::WorkerContext(LibrarySharedPtr library)
+    : library_(library),
+      context_(library->callbacks().on_worker_init_ != nullptr
+                   ? library->callbacks().on_worker_init_(library->context())
+                   : library->context()) {}
+
+Module::WorkerContext::~WorkerContext() {
+  if (library_->callbacks().on_worker_destroy_ != nullptr) {
+    library_->callbacks().on_worker_destroy_(context_);
+  }
+}
+
+} // namespace DynamicModule
+} // namespace Common
+} // namespace Filters
+} // namespace Extensions
+} // namespace Envoy
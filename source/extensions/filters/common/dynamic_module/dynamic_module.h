@@ -0,0 +1,144 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "envoy/buffer/buffer.h"
+#include "envoy/http/codes.h"
+#include "envoy/http/header_map.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "common/common/logger.h"
+
+#include "extensions/filters/common/dynamic_module/abi.h"
+
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Filters {
+namespace Common {
+namespace DynamicModule {
+
+/**
+ * The stream or connection behind the host handle given to the callbacks of a module. The host API
+ * only accesses the headers and data which the filter sets for the callback being run.
+ */
+class HostContext {
+public:
+  virtual ~HostContext() {}
+
+  /**
+   * @return the headers given to the current callback, or nullptr if there are none.
+   */
+  virtual Http::HeaderMap* headers() { return nullptr; }
+
+  /**
+   * @return the data given to the current callback, or nullptr if there is none.
+   */
+  virtual Buffer::Instance* data() { return nullptr; }
+
+  /**
+   * Sends a local reply to the downstream of an HTTP stream.
+   */
+  virtual void sendLocalReply(Http::Code, absl::string_view) {}
+
+  /**
+   * Closes the connection of a network filter.
+   */
+  virtual void closeConnection() {}
+
+  /**
+   * @return the host handle given to the module.
+   */
+  void* handle() { return this; }
+};
+
+/**
+ * The functions exported by a module, which are null when the module doesn't export them.
+ */
+struct ModuleCallbacks {
+  envoy_dynamic_module_on_destroy_fn on_destroy_{};
+  envoy_dynamic_module_on_worker_init_fn on_worker_init_{};
+  envoy_dynamic_module_on_worker_destroy_fn on_worker_destroy_{};
+  envoy_dynamic_module_on_http_stream_create_fn on_http_stream_create_{};
+  envoy_dynamic_module_on_http_stream_destroy_fn on_http_stream_destroy_{};
+  envoy_dynamic_module_on_http_fn on_http_request_headers_{};
+  envoy_dynamic_module_on_http_fn on_http_request_data_{};
+  envoy_dynamic_module_on_http_fn on_http_response_headers_{};
+  envoy_dynamic_module_on_http_fn on_http_response_data_{};
+  envoy_dynamic_module_on_network_connection_create_fn on_network_connection_create_{};
+  envoy_dynamic_module_on_network_connection_destroy_fn on_network_connection_destroy_{};
+  envoy_dynamic_module_on_network_data_fn on_network_read_{};
+  envoy_dynamic_module_on_network_data_fn on_network_write_{};
+};
+
+/**
+ * A shared object loaded and initialized as a module. It is unloaded once destroyed, after the
+ * contexts of all the workers, which hold a reference to it.
+ */
+class Library : Logger::Loggable<Logger::Id::filter> {
+public:
+  /**
+   * Loads a module and initializes it with its configuration.
+   * @param path supplies the path of the shared object.
+   * @param config supplies the configuration of the module.
+   * @throw EnvoyException if the shared object can't be loaded, doesn't implement the ABI of this
+   *        version of Envoy, or rejects its configuration.
+   */
+  Library(const std::string& path, const std::string& config);
+  ~Library();
+
+  const ModuleCallbacks& callbacks() const { return callbacks_; }
+  void* context() const { return context_; }
+
+  /**
+   * The host API given to all the modules.
+   */
+  static const envoy_dynamic_module_host_api& hostApi();
+
+private:
+  void* symbol(const std::string& name);
+
+  void* handle_{};
+  void* context_{};
+  ModuleCallbacks callbacks_;
+};
+
+typedef std::shared_ptr<Library> LibrarySharedPtr;
+
+/**
+ * A module loaded for a filter configuration. The shared object is loaded and initialized once on
+ * the main thread, and each worker then initializes its own context of the module.
+ */
+class Module {
+public:
+  Module(const std::string& path, const std::string& config, ThreadLocal::SlotAllocator& tls);
+
+  const ModuleCallbacks& callbacks() const { return library_->callbacks(); }
+
+  /**
+   * @return the context of the module for the current worker.
+   */
+  void* workerContext() { return tls_slot_->getTyped<WorkerContext>().context_; }
+
+private:
+  struct WorkerContext : public ThreadLocal::ThreadLocalObject {
+    WorkerContext(LibrarySharedPtr library);
+    ~WorkerContext();
+
+    const LibrarySharedPtr library_;
+    void* context_;
+  };
+
+  LibrarySharedPtr library_;
+  ThreadLocal::SlotPtr tls_slot_;
+};
+
+typedef std::shared_ptr<Module> ModuleSharedPtr;
+
+} // namespace DynamicModule
+} // namespace Common
+} // namespace Filters
+} // namespace Extensions
+} // namespace Envoy
@@ -74,7 +74,8 @@ std::string CheckRequestUtils::getHeaderStr(const Envoy::Http::HeaderEntry* entr
 void CheckRequestUtils::setHttpRequest(
     ::envoy::service::auth::v2alpha::AttributeContext_HttpRequest& httpreq,
     const Envoy::Http::StreamDecoderFilterCallbacks* callbacks,
-    const Envoy::Http::HeaderMap& headers) {
+    const Envoy::Http::HeaderMap& headers,
+    const Envoy::Http::LowerCaseStrUnorderedSet& allowed_headers) {
 
   // Set id
   // The streamId is not qualified as a const. Although it is as it does not modify the object.
@@ -103,6 +104,15 @@ void CheckRequestUtils::setHttpRequest(
 
   // Fill in the headers
   auto mutable_headers = httpreq.mutable_headers();
+  if (!allowed_headers.empty()) {
+    for (const auto& allowed_header : allowed_headers) {
+      const Envoy::Http::HeaderEntry* entry = headers.get(allowed_header);
+      if (entry != nullptr) {
+        (*mutable_headers)[allowed_header.get()] = std::string(entry->value().getStringView());
+      }
+    }
+    return;
+  }
   headers.iterate(
       [](const Envoy::Http::HeaderEntry& e, void* ctx) {
         Envoy::Protobuf::Map<Envoy::ProtobufTypes::String, Envoy::ProtobufTypes::String>*
@@ -119,13 +129,16 @@ void CheckRequestUtils::setHttpRequest(
 void CheckRequestUtils::setAttrContextRequest(
     ::envoy::service::auth::v2alpha::AttributeContext_Request& req,
     const Envoy::Http::StreamDecoderFilterCallbacks* callbacks,
-    const Envoy::Http::HeaderMap& headers) {
-  setHttpRequest(*req.mutable_http(), callbacks, headers);
+    const Envoy::Http::HeaderMap& headers,
+    const Envoy::Http::LowerCaseStrUnorderedSet& allowed_headers) {
+  setHttpRequest(*req.mutable_http(), callbacks, headers, allowed_headers);
 }
 
-void CheckRequestUtils::createHttpCheck(const Envoy::Http::StreamDecoderFilterCallbacks* callbacks,
-                                        const Envoy::Http::HeaderMap& headers,
-                                        envoy::service::auth::v2alpha::CheckRequest& request) {
+void CheckRequestUtils::createHttpCheck(
+    const Envoy::Http::StreamDecoderFilterCallbacks* callbacks,
+    const Envoy::Http::HeaderMap& headers,
+    const Envoy::Http::LowerCaseStrUnorderedSet& allowed_headers,
+    envoy::service::auth::v2alpha::CheckRequest& request) {
 
   auto attrs = request.mutable_attributes();
 
@@ -136,7 +149,7 @@ void CheckRequestUtils::createHttpCheck(const Envoy::Http::StreamDecoderFilterCa
 
   setAttrContextPeer(*attrs->mutable_source(), *cb->connection(), service, false);
   setAttrContextPeer(*attrs->mutable_destination(), *cb->connection(), "", true);
-  setAttrContextRequest(*attrs->mutable_request(), callbacks, headers);
+  setAttrContextRequest(*attrs->mutable_request(), callbacks, headers, allowed_headers);
 }
 
 void CheckRequestUtils::createTcpCheck(const Network::ReadFilterCallbacks* callbacks,
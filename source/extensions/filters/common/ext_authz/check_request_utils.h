@@ -42,11 +42,14 @@ public:
    * @param callbacks supplies the Http stream context from which data can be extracted.
    * @param headers supplies the header map with http headers that will be used to create the
    *        check request.
+   * @param allowed_headers supplies the headers copied into the check request when present. All
+   *        the headers are copied when empty.
    * @param request is the reference to the check request that will be filled up.
    *
    */
   static void createHttpCheck(const Envoy::Http::StreamDecoderFilterCallbacks* callbacks,
                               const Envoy::Http::HeaderMap& headers,
+                              const Envoy::Http::LowerCaseStrUnorderedSet& allowed_headers,
                               envoy::service::auth::v2alpha::CheckRequest& request);
 
   /**
@@ -65,10 +68,12 @@ private:
                                  const bool local);
   static void setHttpRequest(::envoy::service::auth::v2alpha::AttributeContext_HttpRequest& httpreq,
                              const Envoy::Http::StreamDecoderFilterCallbacks* callbacks,
-                             const Envoy::Http::HeaderMap& headers);
+                             const Envoy::Http::HeaderMap& headers,
+                             const Envoy::Http::LowerCaseStrUnorderedSet& allowed_headers);
   static void setAttrContextRequest(::envoy::service::auth::v2alpha::AttributeContext_Request& req,
                                     const Envoy::Http::StreamDecoderFilterCallbacks* callbacks,
-                                    const Envoy::Http::HeaderMap& headers);
+                                    const Envoy::Http::HeaderMap& headers,
+                                    const Envoy::Http::LowerCaseStrUnorderedSet& allowed_headers);
   static std::string getHeaderStr(const Envoy::Http::HeaderEntry* entry);
   static Envoy::Http::HeaderMap::Iterate fillHttpHeaders(const Envoy::Http::HeaderEntry&, void*);
 };
@@ -0,0 +1,38 @@
+#include "extensions/filters/common/local_ratelimit/local_ratelimit.h"
+
+#include <chrono>
+
+#include "common/common/lock_guard.h"
+#include "common/protobuf/utility.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Filters {
+namespace Common {
+namespace LocalRateLimit {
+
+namespace {
+
+// The number of tokens added per second.
+double fillRate(const envoy::type::TokenBucket& config) {
+  const double tokens_per_fill = PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, tokens_per_fill, 1);
+  const std::chrono::milliseconds fill_interval(PROTOBUF_GET_MS_REQUIRED(config, fill_interval));
+  return tokens_per_fill * 1000 / fill_interval.count();
+}
+
+} // namespace
+
+SharedTokenBucket::SharedTokenBucket(const envoy::type::TokenBucket& config,
+                                     TimeSource& time_source)
+    : bucket_(config.max_tokens(), time_source, fillRate(config)) {}
+
+bool SharedTokenBucket::consume() {
+  Thread::LockGuard lock(lock_);
+  return bucket_.consume();
+}
+
+} // namespace LocalRateLimit
+} // namespace Common
+} // namespace Filters
+} // namespace Extensions
+} // namespace Envoy
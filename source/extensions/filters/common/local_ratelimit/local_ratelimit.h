@@ -0,0 +1,43 @@
+#pragma once
+
+#include <memory>
+
+#include "envoy/common/time.h"
+#include "envoy/type/token_bucket.pb.h"
+
+#include "common/common/thread.h"
+#include "common/common/thread_annotations.h"
+#include "common/common/token_bucket_impl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Filters {
+namespace Common {
+namespace LocalRateLimit {
+
+/**
+ * Token bucket shared by all the workers, which consume its tokens under a lock. The lock is only
+ * held for the few arithmetic operations of a consumption, so that a bucket shared by the workers
+ * enforces the configured rate exactly, rather than each worker enforcing a fraction of it.
+ */
+class SharedTokenBucket {
+public:
+  SharedTokenBucket(const envoy::type::TokenBucket& config, TimeSource& time_source);
+
+  /**
+   * @return bool whether a token was consumed, false if the bucket is empty.
+   */
+  bool consume();
+
+private:
+  Thread::MutexBasicLockable lock_;
+  TokenBucketImpl bucket_ GUARDED_BY(lock_);
+};
+
+typedef std::unique_ptr<SharedTokenBucket> SharedTokenBucketPtr;
+
+} // namespace LocalRateLimit
+} // namespace Common
+} // namespace Filters
+} // namespace Extensions
+} // namespace Envoy
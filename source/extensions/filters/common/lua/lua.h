@@ -306,6 +306,17 @@ public:
   lua_State* luaState() { return coroutine_state_.get(); }
   State state() { return state_; }
 
+  /**
+   * @return whether the coroutine can be started again, which is the case once it finished without
+   *         error.
+   */
+  bool reusable() const { return state_ == State::Finished && !failed_; }
+
+  /**
+   * Clears the stack of a reusable coroutine so that it can be started again.
+   */
+  void reset();
+
   /**
    * Start a coroutine.
    * @param function_ref supplies the previously registered function to call. Registered with
@@ -327,6 +338,7 @@ public:
 private:
   LuaRef<lua_State> coroutine_state_;
   State state_{State::NotStarted};
+  bool failed_{};
 };
 
 typedef std::unique_ptr<Coroutine> CoroutinePtr;
@@ -341,10 +353,19 @@ public:
   ThreadLocalState(const std::string& code, ThreadLocal::SlotAllocator& tls);
 
   /**
-   * @return CoroutinePtr a new coroutine.
+   * @return CoroutinePtr a new coroutine, which reuses the Lua thread of a coroutine previously
+   *         released by the worker if there is one.
    */
   CoroutinePtr createCoroutine();
 
+  /**
+   * Releases a coroutine which is no longer used, so that createCoroutine() can reuse its Lua
+   * thread rather than create a new one. Must be called on the worker which created it. The
+   * coroutines which didn't finish, or finished with an error, are destroyed instead.
+   * @param coroutine supplies the coroutine.
+   */
+  void releaseCoroutine(CoroutinePtr&& coroutine);
+
   /**
    * @return a global reference previously registered via registerGlobal(). This may return
    *         LUA_REFNIL if there was no such global.
@@ -385,10 +406,12 @@ public:
 
 private:
   struct LuaThreadLocal : public ThreadLocal::ThreadLocalObject {
-    LuaThreadLocal(const std::string& code);
+    LuaThreadLocal(const std::string& bytecode, const std::string& chunk_name);
 
     CSmartPtr<lua_State, lua_close> state_;
     std::vector<int> global_slots_;
+    // Destroyed before the state, which they reference.
+    std::vector<CoroutinePtr> coroutine_pool_;
   };
 
   ThreadLocal::SlotPtr tls_slot_;
@@ -1,5 +1,8 @@
 #include "extensions/filters/common/rbac/engine_impl.h"
 
+#include <algorithm>
+#include <map>
+
 #include "common/http/header_map_impl.h"
 
 namespace Envoy {
@@ -8,26 +11,168 @@ namespace Filters {
 namespace Common {
 namespace RBAC {
 
+namespace {
+
+bool isExactHeader(const envoy::api::v2::route::HeaderMatcher& header) {
+  // An empty exact value matches any value of the header.
+  return header.header_match_specifier_case() ==
+             envoy::api::v2::route::HeaderMatcher::kExactMatch &&
+         !header.exact_match().empty() && !header.invert_match();
+}
+
+std::vector<const envoy::api::v2::route::HeaderMatcher*>
+exactHeaders(const Protobuf::RepeatedPtrField<envoy::config::rbac::v2alpha::Permission>& rules) {
+  std::vector<const envoy::api::v2::route::HeaderMatcher*> headers;
+  for (const auto& rule : rules) {
+    if (rule.rule_case() != envoy::config::rbac::v2alpha::Permission::RuleCase::kHeader ||
+        !isExactHeader(rule.header())) {
+      return {};
+    }
+    headers.push_back(&rule.header());
+  }
+  return headers;
+}
+
+std::vector<const envoy::api::v2::route::HeaderMatcher*>
+exactHeaders(const Protobuf::RepeatedPtrField<envoy::config::rbac::v2alpha::Principal>& ids) {
+  std::vector<const envoy::api::v2::route::HeaderMatcher*> headers;
+  for (const auto& id : ids) {
+    if (id.identifier_case() != envoy::config::rbac::v2alpha::Principal::IdentifierCase::kHeader ||
+        !isExactHeader(id.header())) {
+      return {};
+    }
+    headers.push_back(&id.header());
+  }
+  return headers;
+}
+
+// Sets indexable if the principals are all source IP ranges, in which case it returns their valid
+// ranges.
+std::vector<Network::Address::CidrRange>
+sourceIpRanges(const Protobuf::RepeatedPtrField<envoy::config::rbac::v2alpha::Principal>& ids,
+               bool& indexable) {
+  std::vector<Network::Address::CidrRange> ranges;
+  indexable = false;
+  for (const auto& id : ids) {
+    if (id.identifier_case() !=
+        envoy::config::rbac::v2alpha::Principal::IdentifierCase::kSourceIp) {
+      return {};
+    }
+    Network::Address::CidrRange range = Network::Address::CidrRange::create(id.source_ip());
+    // An invalid range never matches.
+    if (range.isValid()) {
+      ranges.push_back(std::move(range));
+    }
+  }
+  indexable = !ids.empty();
+  return ranges;
+}
+
+} // namespace
+
+void RoleBasedAccessControlEngineImpl::HeaderIndex::add(const std::string& value, size_t policy) {
+  auto it = values_.find(value);
+  if (it == values_.end()) {
+    it = values_.emplace(value, std::vector<size_t>()).first;
+    // The nodes of values_ are never moved, so its keys can key lookup_.
+    lookup_.emplace(it->first, &it->second);
+  }
+  // A policy may match several values of the header, and must be found once for each of them.
+  if (it->second.empty() || it->second.back() != policy) {
+    it->second.push_back(policy);
+  }
+}
+
 RoleBasedAccessControlEngineImpl::RoleBasedAccessControlEngineImpl(
     const envoy::config::rbac::v2alpha::RBAC& rules)
     : allowed_if_matched_(rules.action() ==
                           envoy::config::rbac::v2alpha::RBAC_Action::RBAC_Action_ALLOW) {
+  std::map<std::string, const envoy::config::rbac::v2alpha::Policy*> ordered_policies;
   for (const auto& policy : rules.policies()) {
-    policies_.insert(std::make_pair(policy.first, policy.second));
+    ordered_policies.emplace(policy.first, &policy.second);
   }
+
+  policies_.reserve(ordered_policies.size());
+  std::vector<std::pair<size_t, std::vector<Network::Address::CidrRange>>> source_ip_ranges;
+  for (const auto& policy : ordered_policies) {
+    const size_t index = policies_.size();
+    policies_.emplace_back(policy.first, *policy.second);
+
+    bool source_ip_indexable;
+    std::vector<Network::Address::CidrRange> ranges =
+        sourceIpRanges(policy.second->principals(), source_ip_indexable);
+    if (source_ip_indexable) {
+      // A policy without any valid range never matches, and doesn't need to be indexed.
+      if (!ranges.empty()) {
+        source_ip_ranges.emplace_back(index, std::move(ranges));
+      }
+    } else if (!indexHeaderValues(exactHeaders(policy.second->permissions()), index) &&
+               !indexHeaderValues(exactHeaders(policy.second->principals()), index)) {
+      unindexed_policies_.push_back(index);
+    }
+  }
+
+  if (!source_ip_ranges.empty()) {
+    source_ip_policies_ = std::make_unique<Network::LcTrie::LcTrie<size_t>>(source_ip_ranges);
+  }
+}
+
+bool RoleBasedAccessControlEngineImpl::indexHeaderValues(
+    const std::vector<const envoy::api::v2::route::HeaderMatcher*>& headers, size_t policy) {
+  if (headers.empty()) {
+    return false;
+  }
+  const Http::LowerCaseString name(headers.front()->name());
+  for (const auto* header : headers) {
+    if (Http::LowerCaseString(header->name()) != name) {
+      return false;
+    }
+  }
+
+  auto index = std::find_if(header_policies_.begin(), header_policies_.end(),
+                            [&name](const HeaderIndexPtr& index) { return index->name_ == name; });
+  if (index == header_policies_.end()) {
+    header_policies_.emplace_back(std::make_unique<HeaderIndex>(name.get()));
+    index = header_policies_.end() - 1;
+  }
+  for (const auto* header : headers) {
+    (*index)->add(header->exact_match(), policy);
+  }
+  return true;
 }
 
 bool RoleBasedAccessControlEngineImpl::allowed(const Network::Connection& connection,
                                                const Envoy::Http::HeaderMap& headers,
                                                const envoy::api::v2::core::Metadata& metadata,
                                                std::string* effective_policy_id) const {
-  bool matched = false;
+  std::vector<size_t> candidates(unindexed_policies_);
+  if (source_ip_policies_ != nullptr && connection.remoteAddress()->ip() != nullptr) {
+    const std::vector<size_t> policies = source_ip_policies_->getData(connection.remoteAddress());
+    candidates.insert(candidates.end(), policies.begin(), policies.end());
+  }
+  for (const auto& index : header_policies_) {
+    const Http::HeaderEntry* header = headers.get(index->name_);
+    if (header == nullptr) {
+      continue;
+    }
+    const auto policies = index->lookup_.find(header->value().getStringView());
+    if (policies != index->lookup_.end()) {
+      candidates.insert(candidates.end(), policies->second->begin(), policies->second->end());
+    }
+  }
 
-  for (auto it = policies_.begin(); it != policies_.end(); it++) {
-    if (it->second.matches(connection, headers, metadata)) {
+  // The candidates are evaluated in the order of the names of their policies, as the policies
+  // would be without indexes.
+  std::sort(candidates.begin(), candidates.end());
+  candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+  bool matched = false;
+  for (const size_t candidate : candidates) {
+    const Policy& policy = policies_[candidate];
+    if (policy.matcher_.matches(connection, headers, metadata)) {
       matched = true;
       if (effective_policy_id != nullptr) {
-        *effective_policy_id = it->first;
+        *effective_policy_id = policy.name_;
       }
       break;
     }
@@ -1,16 +1,36 @@
 #pragma once
 
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include "envoy/config/filter/http/rbac/v2/rbac.pb.h"
+#include "envoy/http/header_map.h"
+
+#include "common/common/utility.h"
+#include "common/network/lc_trie.h"
 
 #include "extensions/filters/common/rbac/engine.h"
 #include "extensions/filters/common/rbac/matchers.h"
 
+#include "absl/strings/string_view.h"
+
 namespace Envoy {
 namespace Extensions {
 namespace Filters {
 namespace Common {
 namespace RBAC {
 
+/**
+ * Evaluates the policies in the order of their names, the first matching one being the effective
+ * policy. So that the cost of an evaluation doesn't grow with the number of policies, the
+ * policies whose principals are all source IP ranges are indexed in an LC trie, and the ones whose
+ * permissions (or principals) all match exact values of a same header, such as `:path`, are
+ * indexed by these values. Each indexed header is fetched once per evaluation, and only the
+ * policies found through the indexes are evaluated along with the ones which can't be indexed.
+ * The indexes only select candidates, which are still fully evaluated by their matchers.
+ */
 class RoleBasedAccessControlEngineImpl : public RoleBasedAccessControlEngine {
 public:
   RoleBasedAccessControlEngineImpl(const envoy::config::rbac::v2alpha::RBAC& rules);
@@ -22,9 +42,41 @@ public:
   bool allowed(const Network::Connection& connection) const override;
 
 private:
-  const bool allowed_if_matched_;
+  struct Policy {
+    Policy(const std::string& name, const envoy::config::rbac::v2alpha::Policy& policy)
+        : name_(name), matcher_(policy) {}
+
+    const std::string name_;
+    const PolicyMatcher matcher_;
+  };
+
+  // The policies matching exact values of a header, indexed by value.
+  struct HeaderIndex {
+    HeaderIndex(const std::string& name) : name_(name) {}
 
-  std::map<std::string, PolicyMatcher> policies_;
+    void add(const std::string& value, size_t policy);
+
+    const Http::LowerCaseString name_;
+    std::unordered_map<std::string, std::vector<size_t>> values_;
+    // Keys point into values_, so that header values are looked up without being copied.
+    std::unordered_map<absl::string_view, const std::vector<size_t>*, StringViewHash> lookup_;
+  };
+
+  typedef std::unique_ptr<HeaderIndex> HeaderIndexPtr;
+
+  // Indexes a policy by the header values it matches, if they are all exact values of a same
+  // header.
+  bool indexHeaderValues(const std::vector<const envoy::api::v2::route::HeaderMatcher*>& headers,
+                         size_t policy);
+
+  const bool allowed_if_matched_;
+  // The policies ordered by name.
+  std::vector<Policy> policies_;
+  // The policies which can't be indexed, evaluated for every connection or request.
+  std::vector<size_t> unindexed_policies_;
+  // The policies whose principals are all source IP ranges, indexed by these ranges.
+  std::unique_ptr<Network::LcTrie::LcTrie<size_t>> source_ip_policies_;
+  std::vector<HeaderIndexPtr> header_policies_;
 };
 
 } // namespace RBAC
@@ -0,0 +1,80 @@
+#include "extensions/filters/http/adaptive_concurrency/adaptive_concurrency_filter.h"
+
+#include "envoy/router/router.h"
+
+#include "common/common/fmt.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace AdaptiveConcurrency {
+
+AdaptiveConcurrencyFilterConfig::AdaptiveConcurrencyFilterConfig(
+    const envoy::config::filter::http::adaptive_concurrency::v2alpha::AdaptiveConcurrency&
+        proto_config,
+    const std::string& stats_prefix, Stats::Scope& scope, TimeSource& time_source)
+    : controller_config_(proto_config.gradient_controller_config()),
+      stats_prefix_(stats_prefix + "adaptive_concurrency."), scope_(scope),
+      time_source_(time_source) {}
+
+GradientController& AdaptiveConcurrencyFilterConfig::controller(const std::string& cluster_name) {
+  Thread::LockGuard lock(lock_);
+  std::unique_ptr<GradientController>& controller = controllers_[cluster_name];
+  if (controller == nullptr) {
+    const std::string final_prefix = fmt::format("{}{}.", stats_prefix_, cluster_name);
+    controller = std::make_unique<GradientController>(
+        controller_config_, time_source_,
+        AdaptiveConcurrencyStats{ALL_ADAPTIVE_CONCURRENCY_STATS(
+            POOL_COUNTER_PREFIX(scope_, final_prefix), POOL_GAUGE_PREFIX(scope_, final_prefix))});
+  }
+  return *controller;
+}
+
+void AdaptiveConcurrencyFilter::onDestroy() {
+  if (controller_ != nullptr) {
+    controller_->release();
+    controller_ = nullptr;
+  }
+}
+
+Http::FilterHeadersStatus AdaptiveConcurrencyFilter::decodeHeaders(Http::HeaderMap&, bool) {
+  Router::RouteConstSharedPtr route = decoder_callbacks_->route();
+  if (route == nullptr || route->routeEntry() == nullptr) {
+    return Http::FilterHeadersStatus::Continue;
+  }
+
+  GradientController& controller = config_->controller(route->routeEntry()->clusterName());
+  if (!controller.tryAcquire()) {
+    decoder_callbacks_->requestInfo().setResponseFlag(
+        RequestInfo::ResponseFlag::UpstreamOverflow);
+    decoder_callbacks_->sendLocalReply(Http::Code::ServiceUnavailable,
+                                       "reached concurrency limit", nullptr);
+    return Http::FilterHeadersStatus::StopIteration;
+  }
+
+  controller_ = &controller;
+  return Http::FilterHeadersStatus::Continue;
+}
+
+Http::FilterHeadersStatus AdaptiveConcurrencyFilter::encodeHeaders(Http::HeaderMap&, bool) {
+  if (controller_ == nullptr) {
+    return Http::FilterHeadersStatus::Continue;
+  }
+
+  // Sample the time to the first byte of the response. Requests that timed out have no response
+  // but are the strongest sign of overload, so they are sampled as well.
+  RequestInfo::RequestInfo& request_info = decoder_callbacks_->requestInfo();
+  const absl::optional<std::chrono::nanoseconds> rtt = request_info.firstUpstreamRxByteReceived();
+  if (rtt) {
+    controller_->recordLatency(rtt.value());
+  } else if (request_info.hasResponseFlag(RequestInfo::ResponseFlag::UpstreamRequestTimeout)) {
+    controller_->recordLatency(config_->timeSource().monotonicTime() -
+                               request_info.startTimeMonotonic());
+  }
+  return Http::FilterHeadersStatus::Continue;
+}
+
+} // namespace AdaptiveConcurrency
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
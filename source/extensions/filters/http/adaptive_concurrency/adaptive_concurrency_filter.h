@@ -0,0 +1,101 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "envoy/common/time.h"
+#include "envoy/config/filter/http/adaptive_concurrency/v2alpha/adaptive_concurrency.pb.h"
+#include "envoy/http/filter.h"
+#include "envoy/stats/scope.h"
+
+#include "common/common/lock_guard.h"
+#include "common/common/thread.h"
+
+#include "extensions/filters/http/adaptive_concurrency/gradient_controller.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace AdaptiveConcurrency {
+
+/**
+ * Configuration for the adaptive concurrency filter, which owns the controllers of the upstream
+ * clusters that requests are routed to.
+ */
+class AdaptiveConcurrencyFilterConfig {
+public:
+  AdaptiveConcurrencyFilterConfig(
+      const envoy::config::filter::http::adaptive_concurrency::v2alpha::AdaptiveConcurrency&
+          proto_config,
+      const std::string& stats_prefix, Stats::Scope& scope, TimeSource& time_source);
+
+  /**
+   * @return the controller of an upstream cluster, created on first use. This may be called from
+   *         any thread.
+   */
+  GradientController& controller(const std::string& cluster_name);
+
+  TimeSource& timeSource() { return time_source_; }
+
+private:
+  const GradientControllerConfig controller_config_;
+  const std::string stats_prefix_;
+  Stats::Scope& scope_;
+  TimeSource& time_source_;
+  Thread::MutexBasicLockable lock_;
+  std::unordered_map<std::string, std::unique_ptr<GradientController>>
+      controllers_ GUARDED_BY(lock_);
+};
+
+typedef std::shared_ptr<AdaptiveConcurrencyFilterConfig> AdaptiveConcurrencyFilterConfigSharedPtr;
+
+/**
+ * A filter that limits the requests in flight to each upstream cluster to an adaptive limit, and
+ * samples the round trip time of the requests it admits to adjust the limit. Requests above the
+ * limit are rejected with a 503.
+ * See docs/configuration/http_filters/adaptive_concurrency_filter.rst
+ */
+class AdaptiveConcurrencyFilter : public Http::StreamFilter {
+public:
+  AdaptiveConcurrencyFilter(AdaptiveConcurrencyFilterConfigSharedPtr config) : config_(config) {}
+
+  // Http::StreamFilterBase
+  void onDestroy() override;
+
+  // Http::StreamDecoderFilter
+  Http::FilterHeadersStatus decodeHeaders(Http::HeaderMap& headers, bool end_stream) override;
+  Http::FilterDataStatus decodeData(Buffer::Instance&, bool) override {
+    return Http::FilterDataStatus::Continue;
+  }
+  Http::FilterTrailersStatus decodeTrailers(Http::HeaderMap&) override {
+    return Http::FilterTrailersStatus::Continue;
+  }
+  void setDecoderFilterCallbacks(Http::StreamDecoderFilterCallbacks& callbacks) override {
+    decoder_callbacks_ = &callbacks;
+  }
+
+  // Http::StreamEncoderFilter
+  Http::FilterHeadersStatus encode100ContinueHeaders(Http::HeaderMap&) override {
+    return Http::FilterHeadersStatus::Continue;
+  }
+  Http::FilterHeadersStatus encodeHeaders(Http::HeaderMap& headers, bool end_stream) override;
+  Http::FilterDataStatus encodeData(Buffer::Instance&, bool) override {
+    return Http::FilterDataStatus::Continue;
+  }
+  Http::FilterTrailersStatus encodeTrailers(Http::HeaderMap&) override {
+    return Http::FilterTrailersStatus::Continue;
+  }
+  void setEncoderFilterCallbacks(Http::StreamEncoderFilterCallbacks&) override {}
+
+private:
+  AdaptiveConcurrencyFilterConfigSharedPtr config_;
+  Http::StreamDecoderFilterCallbacks* decoder_callbacks_{};
+  // The controller of the cluster of the request, while the request is admitted.
+  GradientController* controller_{};
+};
+
+} // namespace AdaptiveConcurrency
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,39 @@
+#include "extensions/filters/http/adaptive_concurrency/config.h"
+
+#include <string>
+
+#include "envoy/config/filter/http/adaptive_concurrency/v2alpha/adaptive_concurrency.pb.validate.h"
+#include "envoy/registry/registry.h"
+
+#include "extensions/filters/http/adaptive_concurrency/adaptive_concurrency_filter.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace AdaptiveConcurrency {
+
+Http::FilterFactoryCb AdaptiveConcurrencyFilterFactory::createFilterFactoryFromProtoTyped(
+    const envoy::config::filter::http::adaptive_concurrency::v2alpha::AdaptiveConcurrency&
+        proto_config,
+    const std::string& stats_prefix, Server::Configuration::FactoryContext& context) {
+  AdaptiveConcurrencyFilterConfigSharedPtr filter_config(
+      std::make_shared<AdaptiveConcurrencyFilterConfig>(proto_config, stats_prefix,
+                                                        context.scope(), context.timeSource()));
+
+  return [filter_config](Http::FilterChainFactoryCallbacks& callbacks) -> void {
+    callbacks.addStreamFilter(
+        Http::StreamFilterSharedPtr{new AdaptiveConcurrencyFilter(filter_config)});
+  };
+}
+
+/**
+ * Static registration for the adaptive concurrency filter. @see RegisterFactory.
+ */
+static Registry::RegisterFactory<AdaptiveConcurrencyFilterFactory,
+                                 Server::Configuration::NamedHttpFilterConfigFactory>
+    register_;
+
+} // namespace AdaptiveConcurrency
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
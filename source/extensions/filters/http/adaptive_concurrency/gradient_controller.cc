@@ -0,0 +1,115 @@
+#include "extensions/filters/http/adaptive_concurrency/gradient_controller.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "common/common/assert.h"
+#include "common/protobuf/utility.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace AdaptiveConcurrency {
+
+namespace {
+
+// Bounds of the gradient applied to the limit by a single update.
+constexpr double MinGradient = 0.5;
+constexpr double MaxGradient = 1.0;
+
+} // namespace
+
+GradientControllerConfig::GradientControllerConfig(
+    const envoy::config::filter::http::adaptive_concurrency::v2alpha::AdaptiveConcurrency::
+        GradientControllerConfig& proto_config)
+    : sample_aggregate_percentile_(proto_config.has_sample_aggregate_percentile()
+                                       ? proto_config.sample_aggregate_percentile().value() / 100
+                                       : 0.5),
+      concurrency_update_interval_(
+          PROTOBUF_GET_MS_OR_DEFAULT(proto_config, concurrency_update_interval, 100)),
+      min_samples_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(proto_config, min_samples, 10)),
+      min_concurrency_limit_(
+          PROTOBUF_GET_WRAPPED_OR_DEFAULT(proto_config, min_concurrency_limit, 3)),
+      max_concurrency_limit_(std::max(
+          min_concurrency_limit_,
+          PROTOBUF_GET_WRAPPED_OR_DEFAULT(proto_config, max_concurrency_limit, 1000))),
+      min_rtt_calc_interval_(
+          PROTOBUF_GET_MS_OR_DEFAULT(proto_config, min_rtt_calc_interval, 60000)),
+      sample_rtt_buffer_(proto_config.has_sample_rtt_buffer()
+                             ? proto_config.sample_rtt_buffer().value() / 100
+                             : 0.25) {}
+
+GradientController::GradientController(const GradientControllerConfig& config,
+                                       TimeSource& time_source, AdaptiveConcurrencyStats&& stats)
+    : config_(config), time_source_(time_source), stats_(std::move(stats)),
+      limit_(config.minConcurrencyLimit()), limit_estimate_(config.minConcurrencyLimit()),
+      last_update_(time_source.monotonicTime()), min_rtt_period_start_(last_update_) {
+  stats_.concurrency_limit_.set(limit_);
+}
+
+bool GradientController::tryAcquire() {
+  uint32_t in_flight = in_flight_.load();
+  do {
+    if (in_flight >= limit_.load()) {
+      stats_.rq_blocked_.inc();
+      return false;
+    }
+  } while (!in_flight_.compare_exchange_weak(in_flight, in_flight + 1));
+  return true;
+}
+
+void GradientController::release() {
+  ASSERT(in_flight_ > 0);
+  in_flight_--;
+}
+
+void GradientController::recordLatency(std::chrono::nanoseconds rtt) {
+  Thread::LockGuard lock(lock_);
+  samples_.push_back(rtt);
+  const MonotonicTime now = time_source_.monotonicTime();
+  if (samples_.size() >= config_.minSamples() &&
+      now - last_update_ >= config_.concurrencyUpdateInterval()) {
+    updateLimit(now);
+  }
+}
+
+void GradientController::updateLimit(MonotonicTime now) {
+  const size_t index = std::min<size_t>(
+      samples_.size() - 1, std::floor(config_.sampleAggregatePercentile() * samples_.size()));
+  std::nth_element(samples_.begin(), samples_.begin() + index, samples_.end());
+  const std::chrono::nanoseconds sample_rtt =
+      std::max(samples_[index], std::chrono::nanoseconds(1));
+  samples_.clear();
+  last_update_ = now;
+
+  if (now - min_rtt_period_start_ >= config_.minRttCalcInterval()) {
+    previous_min_rtt_ = current_min_rtt_;
+    current_min_rtt_ = std::chrono::nanoseconds(0);
+    min_rtt_period_start_ = now;
+  }
+  if (current_min_rtt_.count() == 0 || sample_rtt < current_min_rtt_) {
+    current_min_rtt_ = sample_rtt;
+  }
+  const std::chrono::nanoseconds min_rtt = previous_min_rtt_.count() == 0
+                                               ? current_min_rtt_
+                                               : std::min(previous_min_rtt_, current_min_rtt_);
+
+  // Requests within the buffer above the minimum round trip time don't reduce the limit.
+  const double gradient = std::max(
+      MinGradient, std::min(MaxGradient, min_rtt.count() * (1 + config_.sampleRttBuffer()) /
+                                             sample_rtt.count()));
+  const double limit = limit_estimate_ * gradient + std::sqrt(limit_estimate_);
+  limit_estimate_ = std::max<double>(config_.minConcurrencyLimit(),
+                                     std::min<double>(config_.maxConcurrencyLimit(), limit));
+  limit_ = std::lround(limit_estimate_);
+
+  stats_.concurrency_limit_.set(limit_);
+  stats_.min_rtt_msecs_.set(std::chrono::duration_cast<std::chrono::milliseconds>(min_rtt).count());
+  stats_.sample_rtt_msecs_.set(
+      std::chrono::duration_cast<std::chrono::milliseconds>(sample_rtt).count());
+}
+
+} // namespace AdaptiveConcurrency
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
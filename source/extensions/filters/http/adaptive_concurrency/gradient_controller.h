@@ -0,0 +1,128 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "envoy/common/time.h"
+#include "envoy/config/filter/http/adaptive_concurrency/v2alpha/adaptive_concurrency.pb.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "common/common/lock_guard.h"
+#include "common/common/thread.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace AdaptiveConcurrency {
+
+/**
+ * All stats for the adaptive concurrency filter, per upstream cluster. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_ADAPTIVE_CONCURRENCY_STATS(COUNTER, GAUGE)                                             \
+  COUNTER(rq_blocked)                                                                              \
+  GAUGE(concurrency_limit)                                                                         \
+  GAUGE(min_rtt_msecs)                                                                             \
+  GAUGE(sample_rtt_msecs)
+// clang-format on
+
+/**
+ * Struct definition for the adaptive concurrency stats of a cluster. @see stats_macros.h
+ */
+struct AdaptiveConcurrencyStats {
+  ALL_ADAPTIVE_CONCURRENCY_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
+};
+
+/**
+ * Parameters of the gradient controllers of the filter, with their defaults applied.
+ */
+class GradientControllerConfig {
+public:
+  GradientControllerConfig(const envoy::config::filter::http::adaptive_concurrency::v2alpha::
+                               AdaptiveConcurrency::GradientControllerConfig& proto_config);
+
+  double sampleAggregatePercentile() const { return sample_aggregate_percentile_; }
+  std::chrono::milliseconds concurrencyUpdateInterval() const {
+    return concurrency_update_interval_;
+  }
+  uint32_t minSamples() const { return min_samples_; }
+  uint32_t minConcurrencyLimit() const { return min_concurrency_limit_; }
+  uint32_t maxConcurrencyLimit() const { return max_concurrency_limit_; }
+  std::chrono::milliseconds minRttCalcInterval() const { return min_rtt_calc_interval_; }
+  double sampleRttBuffer() const { return sample_rtt_buffer_; }
+
+private:
+  // Fractions in [0, 1].
+  const double sample_aggregate_percentile_;
+  const std::chrono::milliseconds concurrency_update_interval_;
+  const uint32_t min_samples_;
+  const uint32_t min_concurrency_limit_;
+  const uint32_t max_concurrency_limit_;
+  const std::chrono::milliseconds min_rtt_calc_interval_;
+  const double sample_rtt_buffer_;
+};
+
+/**
+ * Adaptive limit of the requests in flight to an upstream cluster, shared by all the workers.
+ *
+ * The limit follows the gradient between the minimum round trip time of the cluster, measured
+ * while it is lightly loaded, and the round trip time of recent requests: as long as requests take
+ * no longer than the minimum, the limit grows by its square root at each update, which lets
+ * requests queue a little to probe for more throughput. Once requests slow down, the cluster is
+ * past its throughput peak and the limit shrinks in proportion, by at most half per update.
+ */
+class GradientController {
+public:
+  GradientController(const GradientControllerConfig& config, TimeSource& time_source,
+                     AdaptiveConcurrencyStats&& stats);
+
+  /**
+   * Admit a request if the cluster is below its concurrency limit, or count it as blocked.
+   * @return whether the request is admitted, in which case release() must be called once it
+   *         completes.
+   */
+  bool tryAcquire();
+
+  /**
+   * Release an admitted request.
+   */
+  void release();
+
+  /**
+   * Sample the round trip time of a request, updating the concurrency limit once enough samples
+   * were taken since the previous update.
+   * @param rtt supplies the time from the start of the request to its response.
+   */
+  void recordLatency(std::chrono::nanoseconds rtt);
+
+  uint32_t concurrencyLimit() const { return limit_; }
+
+private:
+  void updateLimit(MonotonicTime now) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  const GradientControllerConfig& config_;
+  TimeSource& time_source_;
+  AdaptiveConcurrencyStats stats_;
+  std::atomic<uint32_t> in_flight_{0};
+  std::atomic<uint32_t> limit_;
+
+  Thread::MutexBasicLockable lock_;
+  // Round trip times sampled since the previous update.
+  std::vector<std::chrono::nanoseconds> samples_ GUARDED_BY(lock_);
+  // The limit before rounding, so that small updates accumulate.
+  double limit_estimate_ GUARDED_BY(lock_);
+  MonotonicTime last_update_ GUARDED_BY(lock_);
+  // The minimum of the aggregated round trip times of the previous and current periods, zero
+  // until measured.
+  std::chrono::nanoseconds previous_min_rtt_ GUARDED_BY(lock_){0};
+  std::chrono::nanoseconds current_min_rtt_ GUARDED_BY(lock_){0};
+  MonotonicTime min_rtt_period_start_ GUARDED_BY(lock_);
+};
+
+} // namespace AdaptiveConcurrency
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -19,12 +19,20 @@ namespace Extensions {
 namespace HttpFilters {
 namespace BufferFilter {
 
+namespace {
+constexpr char DefaultSpillDirectory[] = "/tmp";
+} // namespace
+
 BufferFilterSettings::BufferFilterSettings(
     const envoy::config::filter::http::buffer::v2::Buffer& proto_config)
     : disabled_(false),
       max_request_bytes_(static_cast<uint64_t>(proto_config.max_request_bytes().value())),
       max_request_time_(
-          std::chrono::seconds(PROTOBUF_GET_SECONDS_REQUIRED(proto_config, max_request_time))) {}
+          std::chrono::seconds(PROTOBUF_GET_SECONDS_REQUIRED(proto_config, max_request_time))),
+      spill_threshold_bytes_(
+          PROTOBUF_GET_WRAPPED_OR_DEFAULT(proto_config, spill_threshold_bytes, 0)),
+      spill_directory_(proto_config.spill_directory().empty() ? DefaultSpillDirectory
+                                                              : proto_config.spill_directory()) {}
 
 BufferFilterSettings::BufferFilterSettings(
     const envoy::config::filter::http::buffer::v2::BufferPerRoute& proto_config)
@@ -36,7 +44,12 @@ BufferFilterSettings::BufferFilterSettings(
       max_request_time_(std::chrono::seconds(
           proto_config.has_buffer()
               ? PROTOBUF_GET_SECONDS_REQUIRED(proto_config.buffer(), max_request_time)
-              : 0)) {}
+              : 0)),
+      spill_threshold_bytes_(
+          PROTOBUF_GET_WRAPPED_OR_DEFAULT(proto_config.buffer(), spill_threshold_bytes, 0)),
+      spill_directory_(proto_config.buffer().spill_directory().empty()
+                           ? DefaultSpillDirectory
+                           : proto_config.buffer().spill_directory()) {}
 
 BufferFilterConfig::BufferFilterConfig(
     const envoy::config::filter::http::buffer::v2::Buffer& proto_config,
@@ -81,6 +94,10 @@ Http::FilterHeadersStatus BufferFilter::decodeHeaders(Http::HeaderMap&, bool end
   }
 
   callbacks_->setDecoderBufferLimit(settings_->maxRequestBytes());
+  if (settings_->spillThresholdBytes() != 0) {
+    callbacks_->setDecoderBufferSpillThreshold(settings_->spillThresholdBytes(),
+                                               settings_->spillDirectory());
+  }
   request_timeout_ = callbacks_->dispatcher().createTimer([this]() -> void { onRequestTimeout(); });
   request_timeout_->enableTimer(settings_->maxRequestTime());
 
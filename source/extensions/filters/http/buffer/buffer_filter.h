@@ -40,11 +40,15 @@ public:
   bool disabled() const { return disabled_; }
   uint64_t maxRequestBytes() const { return max_request_bytes_; }
   std::chrono::seconds maxRequestTime() const { return max_request_time_; }
+  uint32_t spillThresholdBytes() const { return spill_threshold_bytes_; }
+  const std::string& spillDirectory() const { return spill_directory_; }
 
 private:
   bool disabled_;
   uint64_t max_request_bytes_;
   std::chrono::seconds max_request_time_;
+  uint32_t spill_threshold_bytes_;
+  std::string spill_directory_;
 };
 
 /**
@@ -0,0 +1,241 @@
+#include "extensions/filters/http/cache/cache_filter.h"
+
+#include "common/http/header_map_impl.h"
+#include "common/http/headers.h"
+#include "common/http/utility.h"
+#include "common/protobuf/utility.h"
+
+#include "extensions/filters/http/cache/cache_utility.h"
+#include "extensions/filters/http/cache/lru_http_cache.h"
+
+#include "absl/strings/numbers.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+
+namespace {
+
+// The status codes of responses that are cacheable by default, per RFC 7231 section 6.1.
+bool cacheableStatus(uint64_t status) {
+  switch (status) {
+  case 200:
+  case 203:
+  case 204:
+  case 300:
+  case 301:
+  case 404:
+  case 405:
+  case 410:
+  case 414:
+  case 501:
+    return true;
+  default:
+    return false;
+  }
+}
+
+} // namespace
+
+CacheFilterConfig::CacheFilterConfig(
+    const envoy::config::filter::http::cache::v2alpha::Cache& proto_config,
+    const std::string& stats_prefix, Stats::Scope& scope, TimeSource& time_source)
+    : stats_{ALL_CACHE_FILTER_STATS(POOL_COUNTER_PREFIX(scope, stats_prefix + "cache."))},
+      time_source_(time_source),
+      max_body_bytes_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(proto_config, max_body_bytes, 1024 * 1024)),
+      cache_(new LruHttpCache(
+          PROTOBUF_GET_WRAPPED_OR_DEFAULT(proto_config, shards, 16),
+          PROTOBUF_GET_WRAPPED_OR_DEFAULT(proto_config, max_size_bytes, 64 * 1024 * 1024),
+          LruHttpCacheStats{ALL_LRU_HTTP_CACHE_STATS(
+              POOL_COUNTER_PREFIX(scope, stats_prefix + "cache."),
+              POOL_GAUGE_PREFIX(scope, stats_prefix + "cache."))})) {}
+
+Http::FilterHeadersStatus CacheFilter::decodeHeaders(Http::HeaderMap& headers, bool end_stream) {
+  // Only GET requests without a body or credentials are served from or stored in the cache.
+  if (!end_stream || headers.Method() == nullptr ||
+      headers.Method()->value() != Http::Headers::get().MethodValues.Get.c_str() ||
+      headers.Host() == nullptr || headers.Path() == nullptr ||
+      headers.Authorization() != nullptr) {
+    return Http::FilterHeadersStatus::Continue;
+  }
+
+  CacheControl request_cache_control;
+  if (headers.CacheControl() != nullptr) {
+    request_cache_control = Utility::parseCacheControl(headers.CacheControl()->value().c_str());
+  }
+  if (request_cache_control.no_store_) {
+    return Http::FilterHeadersStatus::Continue;
+  }
+
+  // Header values cannot contain NUL, which separates the parts of the key.
+  key_.assign(headers.Host()->value().c_str(), headers.Host()->value().size());
+  key_.push_back('\0');
+  key_.append(headers.Path()->value().c_str(), headers.Path()->value().size());
+  request_headers_ = &headers;
+  may_insert_ = true;
+
+  // A request may ask for a response fresher than the cached one, which then gets replaced.
+  if (request_cache_control.no_cache_ ||
+      (request_cache_control.max_age_ &&
+       request_cache_control.max_age_.value() == std::chrono::seconds(0))) {
+    config_->stats().rq_miss_.inc();
+    return Http::FilterHeadersStatus::Continue;
+  }
+
+  CachedResponseConstSharedPtr response = config_->cache().lookup(key_);
+  if (response == nullptr || !response->fresh(config_->timeSource().monotonicTime()) ||
+      !response->varyMatches(headers)) {
+    config_->stats().rq_miss_.inc();
+    return Http::FilterHeadersStatus::Continue;
+  }
+
+  may_insert_ = false;
+  serve(*response);
+  return Http::FilterHeadersStatus::StopIteration;
+}
+
+void CacheFilter::serve(const CachedResponse& response) {
+  const std::string age =
+      std::to_string(response.age(config_->timeSource().monotonicTime()).count());
+  const Http::HeaderEntry* etag = response.headers().Etag();
+  const Http::HeaderEntry* if_none_match = request_headers_->get(Http::Headers::get().IfNoneMatch);
+  if (etag != nullptr && if_none_match != nullptr &&
+      Utility::ifNoneMatch(if_none_match->value().c_str(), etag->value().c_str())) {
+    config_->stats().rq_not_modified_.inc();
+    Http::HeaderMapPtr headers{new Http::HeaderMapImpl{
+        {Http::Headers::get().Status, std::to_string(enumToInt(Http::Code::NotModified))},
+        {Http::Headers::get().Etag, etag->value().c_str()},
+        {Http::Headers::get().Age, age}}};
+    // RFC 7232 section 4.1: these would have been sent in a 200 response to the same request.
+    for (const Http::LowerCaseString* name :
+         {&Http::Headers::get().CacheControl, &Http::Headers::get().Vary,
+          &Http::Headers::get().Date}) {
+      const Http::HeaderEntry* entry = response.headers().get(*name);
+      if (entry != nullptr) {
+        headers->addCopy(*name, entry->value().c_str());
+      }
+    }
+    decoder_callbacks_->encodeHeaders(std::move(headers), true);
+    return;
+  }
+
+  config_->stats().rq_hit_.inc();
+  Http::HeaderMapPtr headers{new Http::HeaderMapImpl(response.headers())};
+  headers->remove(Http::Headers::get().Age);
+  headers->addCopy(Http::Headers::get().Age, age);
+  const bool has_body = response.bodyLength() > 0;
+  decoder_callbacks_->encodeHeaders(std::move(headers), !has_body);
+  // Encoding the headers may have reset the stream.
+  if (has_body && !destroyed_) {
+    Buffer::OwnedImpl body;
+    response.copyBody(body);
+    decoder_callbacks_->encodeData(body, true);
+  }
+}
+
+Http::FilterHeadersStatus CacheFilter::encodeHeaders(Http::HeaderMap& headers, bool end_stream) {
+  if (!may_insert_) {
+    return Http::FilterHeadersStatus::Continue;
+  }
+  may_insert_ = false;
+
+  absl::optional<std::chrono::seconds> freshness_lifetime = freshnessLifetime(headers);
+  if (!freshness_lifetime) {
+    return Http::FilterHeadersStatus::Continue;
+  }
+  uint64_t content_length;
+  if (headers.ContentLength() != nullptr &&
+      (!absl::SimpleAtoi(headers.ContentLength()->value().c_str(), &content_length) ||
+       content_length > config_->maxBodyBytes())) {
+    return Http::FilterHeadersStatus::Continue;
+  }
+
+  response_headers_.reset(new Http::HeaderMapImpl(headers));
+  freshness_lifetime_ = freshness_lifetime.value();
+  if (end_stream) {
+    insert();
+  }
+  return Http::FilterHeadersStatus::Continue;
+}
+
+Http::FilterDataStatus CacheFilter::encodeData(Buffer::Instance& data, bool end_stream) {
+  if (response_headers_ == nullptr) {
+    return Http::FilterDataStatus::Continue;
+  }
+
+  if (response_body_.length() + data.length() > config_->maxBodyBytes()) {
+    response_headers_.reset();
+    response_body_.drain(response_body_.length());
+    return Http::FilterDataStatus::Continue;
+  }
+
+  // Shares the memory of the body with the downstream connection instead of copying it.
+  response_body_.addShared(data);
+  if (end_stream) {
+    insert();
+  }
+  return Http::FilterDataStatus::Continue;
+}
+
+Http::FilterTrailersStatus CacheFilter::encodeTrailers(Http::HeaderMap&) {
+  // Responses with trailers are not cached.
+  response_headers_.reset();
+  response_body_.drain(response_body_.length());
+  return Http::FilterTrailersStatus::Continue;
+}
+
+absl::optional<std::chrono::seconds>
+CacheFilter::freshnessLifetime(const Http::HeaderMap& headers) const {
+  if (!cacheableStatus(Http::Utility::getResponseStatus(headers)) ||
+      headers.CacheControl() == nullptr ||
+      headers.get(Http::Headers::get().SetCookie) != nullptr) {
+    return absl::nullopt;
+  }
+  const Http::HeaderEntry* vary = headers.get(Http::Headers::get().Vary);
+  if (vary != nullptr && Utility::parseVary(vary->value().c_str()) ==
+                             std::vector<std::string>{Http::Headers::get().VaryValues.Wildcard}) {
+    return absl::nullopt;
+  }
+
+  // Responses are only cached with an explicit freshness lifetime, as stale ones are not
+  // revalidated.
+  const CacheControl cache_control =
+      Utility::parseCacheControl(headers.CacheControl()->value().c_str());
+  if (cache_control.no_store_ || cache_control.no_cache_ || cache_control.private_) {
+    return absl::nullopt;
+  }
+  const absl::optional<std::chrono::seconds>& lifetime =
+      cache_control.s_maxage_ ? cache_control.s_maxage_ : cache_control.max_age_;
+  if (!lifetime || lifetime.value() == std::chrono::seconds(0)) {
+    return absl::nullopt;
+  }
+  return lifetime;
+}
+
+void CacheFilter::insert() {
+  CachedResponse::VaryValues vary_values;
+  const Http::HeaderEntry* vary = response_headers_->get(Http::Headers::get().Vary);
+  if (vary != nullptr) {
+    for (const std::string& name : Utility::parseVary(vary->value().c_str())) {
+      Http::LowerCaseString header(name);
+      const Http::HeaderEntry* entry = request_headers_->get(header);
+      vary_values.emplace_back(std::move(header),
+                               entry != nullptr ? absl::optional<std::string>(
+                                                      std::string(entry->value().c_str()))
+                                                : absl::nullopt);
+    }
+  }
+
+  config_->cache().insert(key_, std::make_shared<const CachedResponse>(
+                                    *response_headers_, response_body_,
+                                    config_->timeSource().monotonicTime(), freshness_lifetime_,
+                                    std::move(vary_values)));
+  response_headers_.reset();
+  response_body_.drain(response_body_.length());
+}
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
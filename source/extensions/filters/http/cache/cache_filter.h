@@ -0,0 +1,118 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "envoy/common/time.h"
+#include "envoy/config/filter/http/cache/v2alpha/cache.pb.h"
+#include "envoy/http/filter.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "common/buffer/buffer_impl.h"
+
+#include "extensions/filters/http/cache/http_cache.h"
+
+#include "absl/types/optional.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+
+/**
+ * All cache filter stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_CACHE_FILTER_STATS(COUNTER)                                                            \
+  COUNTER(rq_hit)                                                                                  \
+  COUNTER(rq_miss)                                                                                 \
+  COUNTER(rq_not_modified)
+// clang-format on
+
+/**
+ * Struct definition for all cache filter stats. @see stats_macros.h
+ */
+struct CacheFilterStats {
+  ALL_CACHE_FILTER_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * Configuration for the cache filter, which owns the cache shared by the workers.
+ */
+class CacheFilterConfig {
+public:
+  CacheFilterConfig(const envoy::config::filter::http::cache::v2alpha::Cache& proto_config,
+                    const std::string& stats_prefix, Stats::Scope& scope,
+                    TimeSource& time_source);
+
+  HttpCache& cache() { return *cache_; }
+  CacheFilterStats& stats() { return stats_; }
+  TimeSource& timeSource() { return time_source_; }
+  uint32_t maxBodyBytes() const { return max_body_bytes_; }
+
+private:
+  CacheFilterStats stats_;
+  TimeSource& time_source_;
+  const uint32_t max_body_bytes_;
+  HttpCachePtr cache_;
+};
+
+typedef std::shared_ptr<CacheFilterConfig> CacheFilterConfigSharedPtr;
+
+/**
+ * A filter that serves GET requests from the responses cached for them, and caches the responses
+ * that a shared cache may store, as told by their Cache-Control, Vary and Set-Cookie headers.
+ * See docs/configuration/http_filters/cache_filter.rst
+ */
+class CacheFilter : public Http::StreamFilter {
+public:
+  CacheFilter(CacheFilterConfigSharedPtr config) : config_(config) {}
+
+  // Http::StreamFilterBase
+  void onDestroy() override { destroyed_ = true; }
+
+  // Http::StreamDecoderFilter
+  Http::FilterHeadersStatus decodeHeaders(Http::HeaderMap& headers, bool end_stream) override;
+  Http::FilterDataStatus decodeData(Buffer::Instance&, bool) override {
+    return Http::FilterDataStatus::Continue;
+  }
+  Http::FilterTrailersStatus decodeTrailers(Http::HeaderMap&) override {
+    return Http::FilterTrailersStatus::Continue;
+  }
+  void setDecoderFilterCallbacks(Http::StreamDecoderFilterCallbacks& callbacks) override {
+    decoder_callbacks_ = &callbacks;
+  }
+
+  // Http::StreamEncoderFilter
+  Http::FilterHeadersStatus encode100ContinueHeaders(Http::HeaderMap&) override {
+    return Http::FilterHeadersStatus::Continue;
+  }
+  Http::FilterHeadersStatus encodeHeaders(Http::HeaderMap& headers, bool end_stream) override;
+  Http::FilterDataStatus encodeData(Buffer::Instance& data, bool end_stream) override;
+  Http::FilterTrailersStatus encodeTrailers(Http::HeaderMap&) override;
+  void setEncoderFilterCallbacks(Http::StreamEncoderFilterCallbacks&) override {}
+
+private:
+  void serve(const CachedResponse& response);
+  absl::optional<std::chrono::seconds> freshnessLifetime(const Http::HeaderMap& headers) const;
+  void insert();
+
+  CacheFilterConfigSharedPtr config_;
+  Http::StreamDecoderFilterCallbacks* decoder_callbacks_{};
+  const Http::HeaderMap* request_headers_{};
+  std::string key_;
+  // Whether the response to the request may be cached, until it is known whether it may.
+  bool may_insert_{};
+  // Set while the body of a response to be cached is being received.
+  Http::HeaderMapPtr response_headers_;
+  std::chrono::seconds freshness_lifetime_{};
+  Buffer::OwnedImpl response_body_;
+  bool destroyed_{};
+};
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
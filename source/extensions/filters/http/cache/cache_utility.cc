@@ -0,0 +1,91 @@
+#include "extensions/filters/http/cache/cache_utility.h"
+
+#include <cstdint>
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+namespace Utility {
+
+namespace {
+
+std::chrono::seconds parseSeconds(absl::string_view value) {
+  uint64_t seconds;
+  if (!absl::SimpleAtoi(value, &seconds)) {
+    return std::chrono::seconds(0);
+  }
+  return std::chrono::seconds(seconds);
+}
+
+absl::string_view stripWeakPrefix(absl::string_view etag) {
+  etag = absl::StripAsciiWhitespace(etag);
+  if (absl::StartsWith(etag, "W/")) {
+    etag.remove_prefix(2);
+  }
+  return etag;
+}
+
+} // namespace
+
+CacheControl parseCacheControl(absl::string_view value) {
+  CacheControl cache_control;
+  for (absl::string_view directive : absl::StrSplit(value, ',', absl::SkipWhitespace())) {
+    absl::string_view argument;
+    const size_t equals = directive.find('=');
+    if (equals != absl::string_view::npos) {
+      argument = absl::StripAsciiWhitespace(directive.substr(equals + 1));
+      if (argument.size() >= 2 && argument.front() == '"' && argument.back() == '"') {
+        argument = argument.substr(1, argument.size() - 2);
+      }
+      directive = directive.substr(0, equals);
+    }
+    const std::string name = absl::AsciiStrToLower(absl::StripAsciiWhitespace(directive));
+
+    // no-cache and private with field names are taken as applying to the whole response.
+    if (name == "no-store") {
+      cache_control.no_store_ = true;
+    } else if (name == "no-cache") {
+      cache_control.no_cache_ = true;
+    } else if (name == "private") {
+      cache_control.private_ = true;
+    } else if (name == "max-age") {
+      cache_control.max_age_ = parseSeconds(argument);
+    } else if (name == "s-maxage") {
+      cache_control.s_maxage_ = parseSeconds(argument);
+    }
+  }
+  return cache_control;
+}
+
+std::vector<std::string> parseVary(absl::string_view value) {
+  std::vector<std::string> names;
+  for (absl::string_view name : absl::StrSplit(value, ',', absl::SkipWhitespace())) {
+    names.push_back(absl::AsciiStrToLower(absl::StripAsciiWhitespace(name)));
+  }
+  return names;
+}
+
+bool ifNoneMatch(absl::string_view if_none_match, absl::string_view etag) {
+  if (absl::StripAsciiWhitespace(if_none_match) == "*") {
+    return true;
+  }
+  const absl::string_view opaque_tag = stripWeakPrefix(etag);
+  for (absl::string_view tag : absl::StrSplit(if_none_match, ',', absl::SkipWhitespace())) {
+    if (stripWeakPrefix(tag) == opaque_tag) {
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace Utility
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
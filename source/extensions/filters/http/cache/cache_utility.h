@@ -0,0 +1,52 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+
+/**
+ * The directives of a Cache-Control header that matter to a shared cache.
+ */
+struct CacheControl {
+  bool no_store_{};
+  bool no_cache_{};
+  bool private_{};
+  absl::optional<std::chrono::seconds> max_age_;
+  absl::optional<std::chrono::seconds> s_maxage_;
+};
+
+namespace Utility {
+
+/**
+ * @param value supplies the value of a Cache-Control header.
+ * @return the directives of the header. A max-age or s-maxage directive whose value is not a number
+ *         of seconds is taken as 0, so that the response is stale.
+ */
+CacheControl parseCacheControl(absl::string_view value);
+
+/**
+ * @param value supplies the value of a Vary header.
+ * @return the lowercase names of the headers in the value.
+ */
+std::vector<std::string> parseVary(absl::string_view value);
+
+/**
+ * @param if_none_match supplies the value of an If-None-Match header.
+ * @param etag supplies the entity tag of a response.
+ * @return true if the header matches the entity tag with the weak comparison of RFC 7232.
+ */
+bool ifNoneMatch(absl::string_view if_none_match, absl::string_view etag);
+
+} // namespace Utility
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
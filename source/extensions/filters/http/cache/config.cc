@@ -0,0 +1,36 @@
+#include "extensions/filters/http/cache/config.h"
+
+#include <string>
+
+#include "envoy/config/filter/http/cache/v2alpha/cache.pb.validate.h"
+#include "envoy/registry/registry.h"
+
+#include "extensions/filters/http/cache/cache_filter.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+
+Http::FilterFactoryCb CacheFilterFactory::createFilterFactoryFromProtoTyped(
+    const envoy::config::filter::http::cache::v2alpha::Cache& proto_config,
+    const std::string& stats_prefix, Server::Configuration::FactoryContext& context) {
+  CacheFilterConfigSharedPtr filter_config(std::make_shared<CacheFilterConfig>(
+      proto_config, stats_prefix, context.scope(), context.timeSource()));
+
+  return [filter_config](Http::FilterChainFactoryCallbacks& callbacks) -> void {
+    callbacks.addStreamFilter(Http::StreamFilterSharedPtr{new CacheFilter(filter_config)});
+  };
+}
+
+/**
+ * Static registration for the cache filter. @see RegisterFactory.
+ */
+static Registry::RegisterFactory<CacheFilterFactory,
+                                 Server::Configuration::NamedHttpFilterConfigFactory>
+    register_;
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,49 @@
+#include "extensions/filters/http/cache/http_cache.h"
+
+#include "common/http/header_map_impl.h"
+#include "common/http/headers.h"
+
+#include "absl/strings/numbers.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+
+CachedResponse::CachedResponse(const Http::HeaderMap& headers, Buffer::Instance& body,
+                               MonotonicTime response_time,
+                               std::chrono::seconds freshness_lifetime, VaryValues&& vary_values)
+    : headers_(new Http::HeaderMapImpl(headers)), response_time_(response_time),
+      freshness_lifetime_(freshness_lifetime), vary_values_(std::move(vary_values)) {
+  // The body only holds owned or shared slices, whose views are immutable.
+  body_.addShared(body);
+
+  const Http::HeaderEntry* age = headers.get(Http::Headers::get().Age);
+  uint64_t age_seconds;
+  if (age != nullptr && absl::SimpleAtoi(age->value().c_str(), &age_seconds)) {
+    initial_age_ = std::chrono::seconds(age_seconds);
+  }
+}
+
+std::chrono::seconds CachedResponse::age(MonotonicTime now) const {
+  return initial_age_ + std::chrono::duration_cast<std::chrono::seconds>(now - response_time_);
+}
+
+bool CachedResponse::varyMatches(const Http::HeaderMap& request_headers) const {
+  for (const auto& vary_value : vary_values_) {
+    const Http::HeaderEntry* entry = request_headers.get(vary_value.first);
+    if (entry == nullptr) {
+      if (vary_value.second) {
+        return false;
+      }
+    } else if (!vary_value.second || vary_value.second.value() != entry->value().c_str()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
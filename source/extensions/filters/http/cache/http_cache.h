@@ -0,0 +1,111 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "envoy/buffer/buffer.h"
+#include "envoy/common/pure.h"
+#include "envoy/common/time.h"
+#include "envoy/http/header_map.h"
+
+#include "common/buffer/buffer_impl.h"
+
+#include "absl/types/optional.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+
+/**
+ * A response held by a cache. It is immutable, so that it can be served by several workers at once.
+ */
+class CachedResponse {
+public:
+  /**
+   * The names of the request headers that the response varies on, with the values they had in
+   * the request of the response.
+   */
+  typedef std::vector<std::pair<Http::LowerCaseString, absl::optional<std::string>>> VaryValues;
+
+  /**
+   * @param headers supplies the headers of the response.
+   * @param body supplies the body of the response, whose memory is shared. It must be a buffer that
+   *        was only filled with Buffer::Instance::addShared().
+   * @param response_time supplies the time the response was received.
+   * @param freshness_lifetime supplies the time the response stays fresh for, from its age.
+   * @param vary_values supplies the request headers that the response varies on.
+   */
+  CachedResponse(const Http::HeaderMap& headers, Buffer::Instance& body,
+                 MonotonicTime response_time, std::chrono::seconds freshness_lifetime,
+                 VaryValues&& vary_values);
+
+  const Http::HeaderMap& headers() const { return *headers_; }
+  uint64_t bodyLength() const { return body_.length(); }
+
+  /**
+   * Add the body of the response to a buffer, sharing its memory.
+   */
+  void copyBody(Buffer::Instance& buffer) const { buffer.addShared(body_); }
+
+  /**
+   * @return the age of the response at a time, including the age it had when it was received.
+   */
+  std::chrono::seconds age(MonotonicTime now) const;
+
+  /**
+   * @return true if the response is fresh at a time.
+   */
+  bool fresh(MonotonicTime now) const { return age(now) < freshness_lifetime_; }
+
+  /**
+   * @return true if the response can be served for a request, given the headers it varies on.
+   */
+  bool varyMatches(const Http::HeaderMap& request_headers) const;
+
+  /**
+   * @return the approximate memory used by the response, in bytes.
+   */
+  uint64_t byteSize() const { return headers_->byteSize() + body_.length(); }
+
+private:
+  const Http::HeaderMapPtr headers_;
+  // Only holds immutable shared slices, so that addShared() from it does not modify it.
+  mutable Buffer::OwnedImpl body_;
+  const MonotonicTime response_time_;
+  std::chrono::seconds initial_age_{};
+  const std::chrono::seconds freshness_lifetime_;
+  const VaryValues vary_values_;
+};
+
+typedef std::shared_ptr<const CachedResponse> CachedResponseConstSharedPtr;
+
+/**
+ * The storage of the responses of a cache filter, by key. It is shared by all the workers, so
+ * implementations must be thread safe.
+ */
+class HttpCache {
+public:
+  virtual ~HttpCache() {}
+
+  /**
+   * @return the response cached under a key, or nullptr if there is none.
+   */
+  virtual CachedResponseConstSharedPtr lookup(const std::string& key) PURE;
+
+  /**
+   * Cache a response under a key, replacing any response already cached under it. The cache may
+   * evict other responses to make room for it, or not cache it at all.
+   */
+  virtual void insert(const std::string& key, CachedResponseConstSharedPtr&& response) PURE;
+};
+
+typedef std::unique_ptr<HttpCache> HttpCachePtr;
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,74 @@
+#include "extensions/filters/http/cache/lru_http_cache.h"
+
+#include <functional>
+#include <iterator>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+
+LruHttpCache::LruHttpCache(uint32_t num_shards, uint64_t max_size_bytes,
+                           const LruHttpCacheStats& stats)
+    : max_shard_size_bytes_(max_size_bytes / num_shards), stats_(stats) {
+  ASSERT(num_shards > 0);
+  for (uint32_t i = 0; i < num_shards; i++) {
+    shards_.emplace_back(new Shard());
+  }
+}
+
+CachedResponseConstSharedPtr LruHttpCache::lookup(const std::string& key) {
+  Shard& shard = this->shard(key);
+  Thread::LockGuard lock(shard.lock_);
+  auto it = shard.index_.find(key);
+  if (it == shard.index_.end()) {
+    return nullptr;
+  }
+  shard.entries_.splice(shard.entries_.begin(), shard.entries_, it->second);
+  return it->second->response_;
+}
+
+void LruHttpCache::insert(const std::string& key, CachedResponseConstSharedPtr&& response) {
+  const uint64_t size_bytes = key.size() + response->byteSize();
+  if (size_bytes > max_shard_size_bytes_) {
+    return;
+  }
+
+  Shard& shard = this->shard(key);
+  Thread::LockGuard lock(shard.lock_);
+  auto it = shard.index_.find(key);
+  if (it != shard.index_.end()) {
+    erase(shard, it->second);
+  }
+
+  shard.entries_.push_front({key, std::move(response), size_bytes});
+  shard.index_.emplace(shard.entries_.front().key_, shard.entries_.begin());
+  shard.size_bytes_ += size_bytes;
+  stats_.insert_.inc();
+  stats_.entries_.inc();
+  stats_.size_bytes_.add(size_bytes);
+
+  while (shard.size_bytes_ > max_shard_size_bytes_) {
+    erase(shard, std::prev(shard.entries_.end()));
+    stats_.eviction_.inc();
+  }
+}
+
+LruHttpCache::Shard& LruHttpCache::shard(const std::string& key) {
+  return *shards_[std::hash<std::string>()(key) % shards_.size()];
+}
+
+void LruHttpCache::erase(Shard& shard, EntryList::iterator entry) {
+  shard.size_bytes_ -= entry->size_bytes_;
+  stats_.entries_.dec();
+  stats_.size_bytes_.sub(entry->size_bytes_);
+  shard.index_.erase(entry->key_);
+  shard.entries_.erase(entry);
+}
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
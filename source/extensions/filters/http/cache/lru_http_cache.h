@@ -0,0 +1,87 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "common/common/lock_guard.h"
+#include "common/common/thread.h"
+#include "common/common/utility.h"
+
+#include "extensions/filters/http/cache/http_cache.h"
+
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+
+/**
+ * All LRU HTTP cache stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_LRU_HTTP_CACHE_STATS(COUNTER, GAUGE)                                                   \
+  COUNTER(insert)                                                                                  \
+  COUNTER(eviction)                                                                                \
+  GAUGE  (entries)                                                                                 \
+  GAUGE  (size_bytes)
+// clang-format on
+
+/**
+ * Struct definition for all LRU HTTP cache stats. @see stats_macros.h
+ */
+struct LruHttpCacheStats {
+  ALL_LRU_HTTP_CACHE_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
+};
+
+/**
+ * An in memory HttpCache that evicts the least recently used responses beyond a total size. Keys
+ * are spread over shards, each with its own lock, list and share of the total size, so that
+ * workers seldom contend.
+ */
+class LruHttpCache : public HttpCache {
+public:
+  LruHttpCache(uint32_t num_shards, uint64_t max_size_bytes, const LruHttpCacheStats& stats);
+
+  // HttpCache
+  CachedResponseConstSharedPtr lookup(const std::string& key) override;
+  void insert(const std::string& key, CachedResponseConstSharedPtr&& response) override;
+
+private:
+  struct Entry {
+    std::string key_;
+    CachedResponseConstSharedPtr response_;
+    uint64_t size_bytes_;
+  };
+
+  typedef std::list<Entry> EntryList;
+
+  struct Shard {
+    Thread::MutexBasicLockable lock_;
+    // Most recently used first.
+    EntryList entries_ GUARDED_BY(lock_);
+    // Keys are views of the keys of entries_.
+    std::unordered_map<absl::string_view, EntryList::iterator, StringViewHash>
+        index_ GUARDED_BY(lock_);
+    uint64_t size_bytes_ GUARDED_BY(lock_){};
+  };
+
+  Shard& shard(const std::string& key);
+  void erase(Shard& shard, EntryList::iterator entry) EXCLUSIVE_LOCKS_REQUIRED(shard.lock_);
+
+  const uint64_t max_shard_size_bytes_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  LruHttpCacheStats stats_;
+};
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,36 @@
+#include "extensions/filters/http/decompressor/config.h"
+
+#include <string>
+
+#include "envoy/config/filter/http/decompressor/v2alpha/decompressor.pb.validate.h"
+#include "envoy/registry/registry.h"
+
+#include "extensions/filters/http/decompressor/decompressor_filter.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Decompressor {
+
+Http::FilterFactoryCb DecompressorFilterFactory::createFilterFactoryFromProtoTyped(
+    const envoy::config::filter::http::decompressor::v2alpha::Decompressor& proto_config,
+    const std::string& stats_prefix, Server::Configuration::FactoryContext& context) {
+  DecompressorFilterConfigSharedPtr filter_config(std::make_shared<DecompressorFilterConfig>(
+      proto_config, stats_prefix, context.scope(), context.runtime(), context.threadLocal()));
+
+  return [filter_config](Http::FilterChainFactoryCallbacks& callbacks) -> void {
+    callbacks.addStreamFilter(std::make_shared<DecompressorFilter>(filter_config));
+  };
+}
+
+/**
+ * Static registration for the decompressor filter. @see RegisterFactory.
+ */
+static Registry::RegisterFactory<DecompressorFilterFactory,
+                                 Server::Configuration::NamedHttpFilterConfigFactory>
+    register_;
+
+} // namespace Decompressor
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
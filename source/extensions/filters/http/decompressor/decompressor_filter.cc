@@ -0,0 +1,154 @@
+#include "extensions/filters/http/decompressor/decompressor_filter.h"
+
+#include "common/buffer/buffer_impl.h"
+#include "common/common/utility.h"
+#include "common/http/headers.h"
+#include "common/protobuf/utility.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Decompressor {
+
+namespace {
+// Default window bits, which accept the bodies compressed with any window.
+const uint64_t DefaultWindowBits = 15;
+
+// When summed to window bits, this lets zlib detect whether the data has a gzip or a zlib header,
+// matching the gzip and deflate content encodings.
+const uint64_t AutomaticHeaderDetectionValue = 32;
+
+// Maximum number of idle decompressors kept by each worker.
+const uint64_t MaxIdleDecompressors = 16;
+} // namespace
+
+DecompressorFilterConfig::DecompressorFilterConfig(
+    const envoy::config::filter::http::decompressor::v2alpha::Decompressor& proto_config,
+    const std::string& stats_prefix, Stats::Scope& scope, Runtime::Loader& runtime,
+    ThreadLocal::SlotAllocator& tls)
+    : decompress_requests_(
+          PROTOBUF_GET_WRAPPED_OR_DEFAULT(proto_config, decompress_requests, true)),
+      decompress_responses_(
+          PROTOBUF_GET_WRAPPED_OR_DEFAULT(proto_config, decompress_responses, false)),
+      window_bits_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(proto_config, window_bits, DefaultWindowBits)),
+      stats_(generateStats(stats_prefix + "decompressor.", scope)), runtime_(runtime),
+      tls_(tls.allocateSlot()) {
+  tls_->set([](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<ThreadLocalDecompressorPool>();
+  });
+}
+
+Envoy::Decompressor::ZlibDecompressorImplPtr DecompressorFilterConfig::acquireDecompressor() {
+  auto& idle_decompressors = tls_->getTyped<ThreadLocalDecompressorPool>().idle_decompressors_;
+  if (idle_decompressors.empty()) {
+    auto decompressor = std::make_unique<Envoy::Decompressor::ZlibDecompressorImpl>();
+    decompressor->init(window_bits_ | AutomaticHeaderDetectionValue);
+    return decompressor;
+  }
+
+  Envoy::Decompressor::ZlibDecompressorImplPtr decompressor = std::move(idle_decompressors.back());
+  idle_decompressors.pop_back();
+  return decompressor;
+}
+
+void DecompressorFilterConfig::releaseDecompressor(
+    Envoy::Decompressor::ZlibDecompressorImplPtr&& decompressor) {
+  auto& idle_decompressors = tls_->getTyped<ThreadLocalDecompressorPool>().idle_decompressors_;
+  if (idle_decompressors.size() < MaxIdleDecompressors) {
+    decompressor->reset();
+    idle_decompressors.push_back(std::move(decompressor));
+  }
+}
+
+DecompressorFilter::DecompressorFilter(const DecompressorFilterConfigSharedPtr& config)
+    : config_(config) {}
+
+void DecompressorFilter::onDestroy() {
+  if (request_decompressor_ != nullptr) {
+    config_->releaseDecompressor(std::move(request_decompressor_));
+  }
+  if (response_decompressor_ != nullptr) {
+    config_->releaseDecompressor(std::move(response_decompressor_));
+  }
+}
+
+Http::FilterHeadersStatus DecompressorFilter::decodeHeaders(Http::HeaderMap& headers,
+                                                           bool end_stream) {
+  if (config_->decompressRequests()) {
+    request_decompressor_ = maybeDecompress(headers, end_stream);
+    if (request_decompressor_ != nullptr) {
+      config_->stats().request_decompressed_.inc();
+    }
+  }
+  return Http::FilterHeadersStatus::Continue;
+}
+
+Http::FilterDataStatus DecompressorFilter::decodeData(Buffer::Instance& data, bool) {
+  if (request_decompressor_ != nullptr && !decompress(*request_decompressor_, data)) {
+    decoder_callbacks_->resetStream();
+    return Http::FilterDataStatus::StopIterationNoBuffer;
+  }
+  return Http::FilterDataStatus::Continue;
+}
+
+Http::FilterHeadersStatus DecompressorFilter::encodeHeaders(Http::HeaderMap& headers,
+                                                           bool end_stream) {
+  if (config_->decompressResponses()) {
+    response_decompressor_ = maybeDecompress(headers, end_stream);
+    if (response_decompressor_ != nullptr) {
+      config_->stats().response_decompressed_.inc();
+    }
+  }
+  return Http::FilterHeadersStatus::Continue;
+}
+
+Http::FilterDataStatus DecompressorFilter::encodeData(Buffer::Instance& data, bool) {
+  if (response_decompressor_ != nullptr && !decompress(*response_decompressor_, data)) {
+    encoder_callbacks_->resetStream();
+    return Http::FilterDataStatus::StopIterationNoBuffer;
+  }
+  return Http::FilterDataStatus::Continue;
+}
+
+Envoy::Decompressor::ZlibDecompressorImplPtr
+DecompressorFilter::maybeDecompress(Http::HeaderMap& headers, bool end_stream) {
+  const Http::HeaderEntry* content_encoding = headers.ContentEncoding();
+  if (end_stream || content_encoding == nullptr ||
+      !config_->runtime().snapshot().featureEnabled("decompressor.filter_enabled", 100)) {
+    return nullptr;
+  }
+
+  // Only a body encoded once is decompressed, i.e. not with "gzip, br".
+  const absl::string_view encoding = StringUtil::trim(content_encoding->value().getStringView());
+  if (!StringUtil::caseCompare(encoding, Http::Headers::get().ContentEncodingValues.Gzip) &&
+      !StringUtil::caseCompare(encoding, Http::Headers::get().ContentEncodingValues.Deflate)) {
+    return nullptr;
+  }
+
+  headers.removeContentEncoding();
+  headers.removeContentLength();
+  return config_->acquireDecompressor();
+}
+
+bool DecompressorFilter::decompress(Envoy::Decompressor::ZlibDecompressorImpl& decompressor,
+                                    Buffer::Instance& data) {
+  config_->stats().total_compressed_bytes_.add(data.length());
+  // The data is decompressed as it arrives rather than buffered, so a stream never holds more than
+  // the decompressed content of a single data frame.
+  Buffer::OwnedImpl decompressed_data;
+  decompressor.decompress(data, decompressed_data);
+  data.drain(data.length());
+  data.move(decompressed_data);
+  config_->stats().total_decompressed_bytes_.add(data.length());
+
+  if (decompressor.decompressionError()) {
+    config_->stats().decompression_error_.inc();
+    return false;
+  }
+  return true;
+}
+
+} // namespace Decompressor
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
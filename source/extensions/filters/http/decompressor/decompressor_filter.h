@@ -0,0 +1,142 @@
+#pragma once
+
+#include <vector>
+
+#include "envoy/config/filter/http/decompressor/v2alpha/decompressor.pb.h"
+#include "envoy/http/filter.h"
+#include "envoy/runtime/runtime.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "common/decompressor/zlib_decompressor_impl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Decompressor {
+
+/**
+ * All decompressor filter stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_DECOMPRESSOR_STATS(COUNTER)                                                            \
+  COUNTER(request_decompressed)                                                                    \
+  COUNTER(response_decompressed)                                                                   \
+  COUNTER(total_compressed_bytes)                                                                  \
+  COUNTER(total_decompressed_bytes)                                                                \
+  COUNTER(decompression_error)
+// clang-format on
+
+/**
+ * Struct definition for all decompressor filter stats. @see stats_macros.h
+ */
+struct DecompressorStats {
+  ALL_DECOMPRESSOR_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * Configuration for the decompressor filter.
+ */
+class DecompressorFilterConfig {
+public:
+  DecompressorFilterConfig(
+      const envoy::config::filter::http::decompressor::v2alpha::Decompressor& proto_config,
+      const std::string& stats_prefix, Stats::Scope& scope, Runtime::Loader& runtime,
+      ThreadLocal::SlotAllocator& tls);
+
+  /**
+   * Returns a decompressor ready for a new stream, reusing one released on this worker when
+   * possible.
+   * @return Envoy::Decompressor::ZlibDecompressorImplPtr the decompressor.
+   */
+  Envoy::Decompressor::ZlibDecompressorImplPtr acquireDecompressor();
+
+  /**
+   * Returns a decompressor to the pool of this worker once its stream is done with it.
+   * @param decompressor supplies the decompressor.
+   */
+  void releaseDecompressor(Envoy::Decompressor::ZlibDecompressorImplPtr&& decompressor);
+
+  Runtime::Loader& runtime() { return runtime_; }
+  DecompressorStats& stats() { return stats_; }
+  bool decompressRequests() const { return decompress_requests_; }
+  bool decompressResponses() const { return decompress_responses_; }
+  uint64_t windowBits() const { return window_bits_; }
+
+private:
+  // The decompressors of a worker which are not decompressing any stream, kept to avoid allocating
+  // and initializing the state of zlib for every stream.
+  struct ThreadLocalDecompressorPool : public ThreadLocal::ThreadLocalObject {
+    std::vector<Envoy::Decompressor::ZlibDecompressorImplPtr> idle_decompressors_;
+  };
+
+  static DecompressorStats generateStats(const std::string& prefix, Stats::Scope& scope) {
+    return DecompressorStats{ALL_DECOMPRESSOR_STATS(POOL_COUNTER_PREFIX(scope, prefix))};
+  }
+
+  const bool decompress_requests_;
+  const bool decompress_responses_;
+  const uint64_t window_bits_;
+  DecompressorStats stats_;
+  Runtime::Loader& runtime_;
+  ThreadLocal::SlotPtr tls_;
+};
+
+typedef std::shared_ptr<DecompressorFilterConfig> DecompressorFilterConfigSharedPtr;
+
+/**
+ * A filter decompressing the bodies encoded with gzip or deflate as they stream through, so that
+ * clients can send compressed bodies to upstreams which don't support them, and the other way
+ * around for the responses.
+ */
+class DecompressorFilter : public Http::StreamFilter {
+public:
+  DecompressorFilter(const DecompressorFilterConfigSharedPtr& config);
+
+  // Http::StreamFilterBase
+  void onDestroy() override;
+
+  // Http::StreamDecoderFilter
+  Http::FilterHeadersStatus decodeHeaders(Http::HeaderMap& headers, bool end_stream) override;
+  Http::FilterDataStatus decodeData(Buffer::Instance& data, bool end_stream) override;
+  Http::FilterTrailersStatus decodeTrailers(Http::HeaderMap&) override {
+    return Http::FilterTrailersStatus::Continue;
+  }
+  void setDecoderFilterCallbacks(Http::StreamDecoderFilterCallbacks& callbacks) override {
+    decoder_callbacks_ = &callbacks;
+  }
+
+  // Http::StreamEncoderFilter
+  Http::FilterHeadersStatus encode100ContinueHeaders(Http::HeaderMap&) override {
+    return Http::FilterHeadersStatus::Continue;
+  }
+  Http::FilterHeadersStatus encodeHeaders(Http::HeaderMap& headers, bool end_stream) override;
+  Http::FilterDataStatus encodeData(Buffer::Instance& data, bool end_stream) override;
+  Http::FilterTrailersStatus encodeTrailers(Http::HeaderMap&) override {
+    return Http::FilterTrailersStatus::Continue;
+  }
+  void setEncoderFilterCallbacks(Http::StreamEncoderFilterCallbacks& callbacks) override {
+    encoder_callbacks_ = &callbacks;
+  }
+
+private:
+  // Returns a decompressor if the body of the message is to be decompressed, after removing the
+  // headers describing the compressed body.
+  Envoy::Decompressor::ZlibDecompressorImplPtr maybeDecompress(Http::HeaderMap& headers,
+                                                               bool end_stream);
+  // Replaces the data with its decompressed content. Returns false if the data is not valid
+  // compressed data.
+  bool decompress(Envoy::Decompressor::ZlibDecompressorImpl& decompressor, Buffer::Instance& data);
+
+  DecompressorFilterConfigSharedPtr config_;
+  Envoy::Decompressor::ZlibDecompressorImplPtr request_decompressor_;
+  Envoy::Decompressor::ZlibDecompressorImplPtr response_decompressor_;
+  Http::StreamDecoderFilterCallbacks* decoder_callbacks_{};
+  Http::StreamEncoderFilterCallbacks* encoder_callbacks_{};
+};
+
+} // namespace Decompressor
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,49 @@
+#include "extensions/filters/http/dynamic_forward_proxy/config.h"
+
+#include <string>
+
+#include "envoy/config/filter/http/dynamic_forward_proxy/v2alpha/dynamic_forward_proxy.pb.validate.h"
+#include "envoy/registry/registry.h"
+#include "envoy/singleton/manager.h"
+
+#include "extensions/filters/http/dynamic_forward_proxy/dns_cache.h"
+#include "extensions/filters/http/dynamic_forward_proxy/proxy_filter.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace DynamicForwardProxy {
+
+// Singleton registration via macro defined in envoy/singleton/manager.h. All the dynamic forward
+// proxy filters of the server share one DNS cache.
+SINGLETON_MANAGER_REGISTRATION(dynamic_forward_proxy_dns_cache);
+
+Http::FilterFactoryCb DynamicForwardProxyFilterFactory::createFilterFactoryFromProtoTyped(
+    const envoy::config::filter::http::dynamic_forward_proxy::v2alpha::DynamicForwardProxy&
+        proto_config,
+    const std::string& stats_prefix, Server::Configuration::FactoryContext& context) {
+  DnsCacheSharedPtr dns_cache = context.singletonManager().getTyped<DnsCache>(
+      SINGLETON_MANAGER_REGISTERED_NAME(dynamic_forward_proxy_dns_cache), [&context] {
+        return std::make_shared<DnsCache>(context.dispatcher().createDnsResolver({}),
+                                          context.dispatcher(), context.threadLocal(),
+                                          context.scope());
+      });
+  ProxyFilterConfigSharedPtr filter_config(std::make_shared<ProxyFilterConfig>(
+      proto_config, dns_cache, context.clusterManager(), stats_prefix, context.scope()));
+
+  return [filter_config](Http::FilterChainFactoryCallbacks& callbacks) -> void {
+    callbacks.addStreamDecoderFilter(std::make_shared<ProxyFilter>(filter_config));
+  };
+}
+
+/**
+ * Static registration for the dynamic forward proxy filter. @see RegisterFactory.
+ */
+static Registry::RegisterFactory<DynamicForwardProxyFilterFactory,
+                                 Server::Configuration::NamedHttpFilterConfigFactory>
+    register_;
+
+} // namespace DynamicForwardProxy
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
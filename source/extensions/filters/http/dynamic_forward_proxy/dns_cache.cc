@@ -0,0 +1,135 @@
+#include "extensions/filters/http/dynamic_forward_proxy/dns_cache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <string>
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace DynamicForwardProxy {
+
+namespace {
+
+// The bounds of the TTLs of the results, as for the DNS cache of the cluster manager.
+const std::chrono::seconds MinTtl{5};
+const std::chrono::seconds MaxTtl{300};
+
+// A result past its TTL is still served on the main thread while it is refreshed. The workers
+// keep it for this long so they don't all ask for it again on every request meanwhile.
+const std::chrono::seconds MinWorkerTtl{1};
+
+} // namespace
+
+DnsCache::DnsCache(Network::DnsResolverSharedPtr resolver,
+                   Event::Dispatcher& main_thread_dispatcher, ThreadLocal::SlotAllocator& tls,
+                   Stats::Scope& scope)
+    : scope_(scope.createScope("dynamic_forward_proxy.")),
+      cache_(resolver, main_thread_dispatcher, *scope_, MinTtl, MaxTtl),
+      main_thread_dispatcher_(main_thread_dispatcher), tls_(tls.allocateSlot()) {
+  tls_->set([](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<ThreadLocalDnsCache>();
+  });
+}
+
+const DnsCache::AddressList* DnsCache::find(const std::string& host,
+                                            Network::DnsLookupFamily dns_lookup_family) {
+  ThreadLocalDnsCache& tls_cache = tls_->getTyped<ThreadLocalDnsCache>();
+  auto entry = tls_cache.entries_.find(Key{host, dns_lookup_family});
+  if (entry == tls_cache.entries_.end()) {
+    return nullptr;
+  }
+  if (entry->second.expiry_time_ <= main_thread_dispatcher_.timeSystem().monotonicTime()) {
+    tls_cache.entries_.erase(entry);
+    return nullptr;
+  }
+  return &entry->second.address_list_;
+}
+
+DnsCache::HandlePtr DnsCache::resolve(const std::string& host,
+                                      Network::DnsLookupFamily dns_lookup_family,
+                                      ResolveCb callback) {
+  const Key key{host, dns_lookup_family};
+  auto& pending = tls_->getTyped<ThreadLocalDnsCache>().pending_[key];
+  const bool first = pending.empty();
+  auto handle = std::make_unique<HandleImpl>(callback, pending);
+  if (first) {
+    // The cache may be gone by the time the main thread gets to it.
+    std::weak_ptr<DnsCache> weak_this = shared_from_this();
+    main_thread_dispatcher_.post([weak_this, key]() -> void {
+      std::shared_ptr<DnsCache> cache = weak_this.lock();
+      if (cache != nullptr) {
+        cache->resolveOnMainThread(key);
+      }
+    });
+  }
+  return std::move(handle);
+}
+
+void DnsCache::resolveOnMainThread(const Key& key) {
+  cache_.resolveWithTtl(
+      key.first, key.second,
+      [this, key](AddressList&& address_list, std::chrono::seconds ttl) -> void {
+        ENVOY_LOG(debug, "dynamic forward proxy resolved {} to {} addresses", key.first,
+                  address_list.size());
+        const MonotonicTime now = main_thread_dispatcher_.timeSystem().monotonicTime();
+        const MonotonicTime expiry_time = now + std::max(ttl, MinWorkerTtl);
+        auto shared_address_list = std::make_shared<const AddressList>(std::move(address_list));
+        tls_->runOnAllThreads([this, key, shared_address_list, now, expiry_time]() -> void {
+          tls_->getTyped<ThreadLocalDnsCache>().onResolved(key, *shared_address_list, now,
+                                                           expiry_time);
+        });
+      });
+}
+
+void DnsCache::ThreadLocalDnsCache::onResolved(const Key& key, const AddressList& address_list,
+                                               MonotonicTime now, MonotonicTime expiry_time) {
+  // The names that are no longer asked for would otherwise stay in the cache forever.
+  for (auto entry = entries_.begin(); entry != entries_.end();) {
+    if (entry->second.expiry_time_ <= now) {
+      entry = entries_.erase(entry);
+    } else {
+      ++entry;
+    }
+  }
+  // Failed resolutions are not cached, the next request for the name resolves it again.
+  if (!address_list.empty()) {
+    entries_[key] = Entry{address_list, expiry_time};
+  }
+
+  auto pending = pending_.find(key);
+  if (pending == pending_.end()) {
+    return;
+  }
+
+  // The handles are taken off the list one at a time, as a callback may destroy the handles of
+  // other waiters, which then remove themselves from the list, or add new ones.
+  std::list<HandleImpl*>& handles = pending->second;
+  while (!handles.empty()) {
+    HandleImpl* handle = handles.front();
+    handles.pop_front();
+    handle->inserted_ = false;
+    // Copied, as the callback may destroy the handle.
+    const ResolveCb callback = handle->callback_;
+    callback(address_list);
+  }
+  pending_.erase(pending);
+}
+
+DnsCache::HandleImpl::HandleImpl(ResolveCb callback, std::list<HandleImpl*>& list)
+    : callback_(callback), list_(list) {
+  entry_ = list.emplace(list.end(), this);
+}
+
+DnsCache::HandleImpl::~HandleImpl() {
+  if (inserted_) {
+    list_.erase(entry_);
+  }
+}
+
+} // namespace DynamicForwardProxy
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "envoy/common/time.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/network/dns.h"
+#include "envoy/singleton/instance.h"
+#include "envoy/stats/scope.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "common/common/logger.h"
+#include "common/network/dns_cache_impl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace DynamicForwardProxy {
+
+/**
+ * The addresses of host names, shared by all workers and all dynamic forward proxy filters. Each
+ * worker looks up the names it was told about in its own copy of the cache, without locking. The
+ * names it doesn't know, or whose addresses expired, are resolved on the main thread through a
+ * Network::DnsCacheImpl, which bounds the TTLs of the results and coalesces the concurrent
+ * resolutions of a name. Every worker is then told about the result.
+ */
+class DnsCache : public Singleton::Instance,
+                 public std::enable_shared_from_this<DnsCache>,
+                 Logger::Loggable<Logger::Id::upstream> {
+public:
+  typedef std::list<Network::Address::InstanceConstSharedPtr> AddressList;
+
+  /**
+   * Called on the worker that asked for a resolution once it is complete.
+   * @param address_list supplies the addresses of the name, which are empty if the resolution
+   *                     failed.
+   */
+  typedef std::function<void(const AddressList& address_list)> ResolveCb;
+
+  /**
+   * A resolution in progress. Destroying it cancels the callback.
+   */
+  class Handle {
+  public:
+    virtual ~Handle() {}
+  };
+
+  typedef std::unique_ptr<Handle> HandlePtr;
+
+  /**
+   * @param resolver supplies the resolver used on the main thread.
+   * @param main_thread_dispatcher supplies the dispatcher of the main thread.
+   * @param tls supplies the slot allocator of the workers' copies of the cache.
+   * @param scope supplies the scope of the stats of the resolutions on the main thread.
+   */
+  DnsCache(Network::DnsResolverSharedPtr resolver, Event::Dispatcher& main_thread_dispatcher,
+           ThreadLocal::SlotAllocator& tls, Stats::Scope& scope);
+
+  /**
+   * Looks up the addresses of a name in the calling worker's copy of the cache.
+   * @param host supplies the name.
+   * @param dns_lookup_family supplies the DNS IP version lookup policy.
+   * @return the addresses of the name, or nullptr if the name has to be resolved. The addresses
+   *         are only valid until the next call into the cache on the worker.
+   */
+  const AddressList* find(const std::string& host, Network::DnsLookupFamily dns_lookup_family);
+
+  /**
+   * Resolves a name on the main thread. Only the first of the concurrent resolutions of a name on
+   * a worker asks the main thread.
+   * @param host supplies the name.
+   * @param dns_lookup_family supplies the DNS IP version lookup policy.
+   * @param callback supplies the callback invoked on the calling worker with the result.
+   * @return HandlePtr the resolution in progress.
+   */
+  HandlePtr resolve(const std::string& host, Network::DnsLookupFamily dns_lookup_family,
+                    ResolveCb callback);
+
+private:
+  typedef std::pair<std::string, Network::DnsLookupFamily> Key;
+
+  struct HandleImpl : public Handle {
+    HandleImpl(ResolveCb callback, std::list<HandleImpl*>& list);
+    ~HandleImpl();
+
+    const ResolveCb callback_;
+    std::list<HandleImpl*>& list_;
+    std::list<HandleImpl*>::iterator entry_;
+    bool inserted_{true};
+  };
+
+  struct ThreadLocalDnsCache : public ThreadLocal::ThreadLocalObject {
+    struct Entry {
+      AddressList address_list_;
+      MonotonicTime expiry_time_;
+    };
+
+    void onResolved(const Key& key, const AddressList& address_list, MonotonicTime now,
+                    MonotonicTime expiry_time);
+
+    std::map<Key, Entry> entries_;
+    // The resolutions waiting for the main thread, by name.
+    std::map<Key, std::list<HandleImpl*>> pending_;
+  };
+
+  void resolveOnMainThread(const Key& key);
+
+  Stats::ScopePtr scope_;
+  Network::DnsCacheImpl cache_;
+  Event::Dispatcher& main_thread_dispatcher_;
+  ThreadLocal::SlotPtr tls_;
+};
+
+typedef std::shared_ptr<DnsCache> DnsCacheSharedPtr;
+
+} // namespace DynamicForwardProxy
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
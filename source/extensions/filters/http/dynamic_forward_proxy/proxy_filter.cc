@@ -0,0 +1,153 @@
+#include "extensions/filters/http/dynamic_forward_proxy/proxy_filter.h"
+
+#include <string>
+
+#include "envoy/common/exception.h"
+#include "envoy/router/router.h"
+#include "envoy/upstream/load_balancer_type.h"
+
+#include "common/common/assert.h"
+#include "common/http/codes.h"
+#include "common/http/headers.h"
+#include "common/network/utility.h"
+
+#include "absl/strings/numbers.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace DynamicForwardProxy {
+
+namespace {
+
+Network::DnsLookupFamily dnsLookupFamily(envoy::api::v2::Cluster::DnsLookupFamily family) {
+  switch (family) {
+  case envoy::api::v2::Cluster::V6_ONLY:
+    return Network::DnsLookupFamily::V6Only;
+  case envoy::api::v2::Cluster::V4_ONLY:
+    return Network::DnsLookupFamily::V4Only;
+  case envoy::api::v2::Cluster::AUTO:
+    return Network::DnsLookupFamily::Auto;
+  default:
+    NOT_REACHED_GCOVR_EXCL_LINE;
+  }
+}
+
+} // namespace
+
+ProxyFilterConfig::ProxyFilterConfig(
+    const envoy::config::filter::http::dynamic_forward_proxy::v2alpha::DynamicForwardProxy&
+        proto_config,
+    DnsCacheSharedPtr dns_cache, Upstream::ClusterManager& cluster_manager,
+    const std::string& stats_prefix, Stats::Scope& scope)
+    : dns_cache_(dns_cache), cluster_manager_(cluster_manager),
+      dns_lookup_family_(dnsLookupFamily(proto_config.dns_lookup_family())),
+      stats_{ALL_DYNAMIC_FORWARD_PROXY_STATS(
+          POOL_COUNTER_PREFIX(scope, stats_prefix + "dynamic_forward_proxy."))} {}
+
+Http::FilterHeadersStatus ProxyFilter::decodeHeaders(Http::HeaderMap& headers, bool) {
+  if (!proxiedCluster() || headers.Host() == nullptr) {
+    return Http::FilterHeadersStatus::Continue;
+  }
+  headers_ = &headers;
+
+  // The host is a name or an IP literal, with an optional port. IPv6 literals are bracketed.
+  const absl::string_view authority = headers.Host()->value().getStringView();
+  absl::string_view host = authority;
+  absl::string_view port;
+  const size_t colon = authority.rfind(':');
+  if (colon != absl::string_view::npos && authority.find(']', colon) == absl::string_view::npos) {
+    host = authority.substr(0, colon);
+    port = authority.substr(colon + 1);
+  }
+  if (host.size() > 1 && host.front() == '[' && host.back() == ']') {
+    host = host.substr(1, host.size() - 2);
+  }
+
+  if (port.empty()) {
+    Upstream::ThreadLocalCluster* cluster =
+        config_->clusterManager().get(callbacks_->route()->routeEntry()->clusterName());
+    port_ = cluster->info()->transportSocketFactory().implementsSecureTransport() ? 443 : 80;
+  } else if (!absl::SimpleAtoi(port, &port_) || port_ == 0 || port_ > 65535 || host.empty()) {
+    config_->stats().invalid_host_.inc();
+    callbacks_->sendLocalReply(Http::Code::BadRequest, "invalid host", nullptr);
+    return Http::FilterHeadersStatus::StopIteration;
+  }
+
+  const std::string host_name(host);
+  Network::Address::InstanceConstSharedPtr address;
+  try {
+    address = Network::Utility::parseInternetAddress(host_name, port_);
+  } catch (const EnvoyException&) {
+  }
+  if (address != nullptr) {
+    setOriginalDstHost(*address);
+    return Http::FilterHeadersStatus::Continue;
+  }
+
+  const DnsCache::AddressList* address_list =
+      config_->dnsCache().find(host_name, config_->dnsLookupFamily());
+  if (address_list != nullptr) {
+    config_->stats().dns_cache_hit_.inc();
+    setOriginalDstHost(*address_list->front());
+    return Http::FilterHeadersStatus::Continue;
+  }
+
+  config_->stats().dns_cache_miss_.inc();
+  handle_ = config_->dnsCache().resolve(
+      host_name, config_->dnsLookupFamily(),
+      [this](const DnsCache::AddressList& address_list) -> void { onResolved(address_list); });
+  return Http::FilterHeadersStatus::StopIteration;
+}
+
+Http::FilterDataStatus ProxyFilter::decodeData(Buffer::Instance&, bool) {
+  return handle_ == nullptr ? Http::FilterDataStatus::Continue
+                            : Http::FilterDataStatus::StopIterationAndWatermark;
+}
+
+Http::FilterTrailersStatus ProxyFilter::decodeTrailers(Http::HeaderMap&) {
+  return handle_ == nullptr ? Http::FilterTrailersStatus::Continue
+                            : Http::FilterTrailersStatus::StopIteration;
+}
+
+void ProxyFilter::onDestroy() { handle_.reset(); }
+
+bool ProxyFilter::proxiedCluster() {
+  Router::RouteConstSharedPtr route = callbacks_->route();
+  if (route == nullptr || route->routeEntry() == nullptr) {
+    return false;
+  }
+  Upstream::ThreadLocalCluster* cluster =
+      config_->clusterManager().get(route->routeEntry()->clusterName());
+  if (cluster == nullptr) {
+    return false;
+  }
+  // Only original destination clusters which take their hosts from the header are proxied to.
+  const Upstream::ClusterInfo& info = *cluster->info();
+  return info.lbType() == Upstream::LoadBalancerType::OriginalDst &&
+         info.lbOriginalDstConfig().has_value() &&
+         info.lbOriginalDstConfig().value().use_http_header();
+}
+
+void ProxyFilter::onResolved(const DnsCache::AddressList& address_list) {
+  handle_.reset();
+  if (address_list.empty()) {
+    config_->stats().dns_resolution_failure_.inc();
+    callbacks_->sendLocalReply(Http::Code::ServiceUnavailable, "DNS resolution failure", nullptr);
+    return;
+  }
+  setOriginalDstHost(*address_list.front());
+  callbacks_->continueDecoding();
+}
+
+void ProxyFilter::setOriginalDstHost(const Network::Address::Instance& address) {
+  const Network::Address::InstanceConstSharedPtr address_with_port =
+      Network::Utility::getAddressWithPort(address, port_);
+  headers_->setReferenceKey(Http::Headers::get().EnvoyOriginalDstHost,
+                            address_with_port->asString());
+}
+
+} // namespace DynamicForwardProxy
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
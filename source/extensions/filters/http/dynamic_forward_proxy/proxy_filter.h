@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "envoy/config/filter/http/dynamic_forward_proxy/v2alpha/dynamic_forward_proxy.pb.h"
+#include "envoy/http/filter.h"
+#include "envoy/network/dns.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/upstream/cluster_manager.h"
+
+#include "extensions/filters/http/dynamic_forward_proxy/dns_cache.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace DynamicForwardProxy {
+
+/**
+ * All dynamic forward proxy filter stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_DYNAMIC_FORWARD_PROXY_STATS(COUNTER)                                                   \
+  COUNTER(dns_cache_hit)                                                                           \
+  COUNTER(dns_cache_miss)                                                                          \
+  COUNTER(dns_resolution_failure)                                                                  \
+  COUNTER(invalid_host)
+// clang-format on
+
+/**
+ * Struct definition for all dynamic forward proxy filter stats. @see stats_macros.h
+ */
+struct DynamicForwardProxyStats {
+  ALL_DYNAMIC_FORWARD_PROXY_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * Configuration for the dynamic forward proxy filter.
+ */
+class ProxyFilterConfig {
+public:
+  ProxyFilterConfig(
+      const envoy::config::filter::http::dynamic_forward_proxy::v2alpha::DynamicForwardProxy&
+          proto_config,
+      DnsCacheSharedPtr dns_cache, Upstream::ClusterManager& cluster_manager,
+      const std::string& stats_prefix, Stats::Scope& scope);
+
+  DnsCache& dnsCache() { return *dns_cache_; }
+  Upstream::ClusterManager& clusterManager() { return cluster_manager_; }
+  Network::DnsLookupFamily dnsLookupFamily() const { return dns_lookup_family_; }
+  DynamicForwardProxyStats& stats() { return stats_; }
+
+private:
+  const DnsCacheSharedPtr dns_cache_;
+  Upstream::ClusterManager& cluster_manager_;
+  const Network::DnsLookupFamily dns_lookup_family_;
+  DynamicForwardProxyStats stats_;
+};
+
+typedef std::shared_ptr<ProxyFilterConfig> ProxyFilterConfigSharedPtr;
+
+/**
+ * Resolves the host of requests routed to an original destination cluster which takes its
+ * destinations from the x-envoy-original-dst-host header, and sets the header to the resolved
+ * address. Requests for hosts that are not cached yet wait for the resolution.
+ * See docs/configuration/http_filters/dynamic_forward_proxy_filter.rst
+ */
+class ProxyFilter : public Http::StreamDecoderFilter {
+public:
+  ProxyFilter(ProxyFilterConfigSharedPtr config) : config_(config) {}
+
+  // Http::StreamFilterBase
+  void onDestroy() override;
+
+  // Http::StreamDecoderFilter
+  Http::FilterHeadersStatus decodeHeaders(Http::HeaderMap& headers, bool end_stream) override;
+  Http::FilterDataStatus decodeData(Buffer::Instance& data, bool end_stream) override;
+  Http::FilterTrailersStatus decodeTrailers(Http::HeaderMap& trailers) override;
+  void setDecoderFilterCallbacks(Http::StreamDecoderFilterCallbacks& callbacks) override {
+    callbacks_ = &callbacks;
+  }
+
+private:
+  bool proxiedCluster();
+  void onResolved(const DnsCache::AddressList& address_list);
+  void setOriginalDstHost(const Network::Address::Instance& address);
+
+  const ProxyFilterConfigSharedPtr config_;
+  Http::StreamDecoderFilterCallbacks* callbacks_{};
+  // The request headers and the port of their host, once the filter proxies the request.
+  Http::HeaderMap* headers_{};
+  uint32_t port_{};
+  // Set while the host is resolved.
+  DnsCache::HandlePtr handle_;
+};
+
+} // namespace DynamicForwardProxy
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,36 @@
+#include "extensions/filters/http/dynamic_module/config.h"
+
+#include <string>
+
+#include "envoy/config/filter/http/dynamic_module/v2alpha/dynamic_module.pb.validate.h"
+#include "envoy/registry/registry.h"
+
+#include "extensions/filters/http/dynamic_module/dynamic_module_filter.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace DynamicModuleFilter {
+
+Http::FilterFactoryCb DynamicModuleFilterConfig::createFilterFactoryFromProtoTyped(
+    const envoy::config::filter::http::dynamic_module::v2alpha::DynamicModule& proto_config,
+    const std::string&, Server::Configuration::FactoryContext& context) {
+  Filters::Common::DynamicModule::ModuleSharedPtr module =
+      std::make_shared<Filters::Common::DynamicModule::Module>(
+          proto_config.path(), proto_config.config(), context.threadLocal());
+  return [module](Http::FilterChainFactoryCallbacks& callbacks) -> void {
+    callbacks.addStreamFilter(std::make_shared<Filter>(module));
+  };
+}
+
+/**
+ * Static registration for the dynamic module filter. @see RegisterFactory.
+ */
+static Registry::RegisterFactory<DynamicModuleFilterConfig,
+                                 Server::Configuration::NamedHttpFilterConfigFactory>
+    register_;
+
+} // namespace DynamicModuleFilter
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "envoy/config/filter/http/dynamic_module/v2alpha/dynamic_module.pb.h"
+
+#include "extensions/filters/http/common/factory_base.h"
+#include "extensions/filters/http/well_known_names.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace DynamicModuleFilter {
+
+/**
+ * Config registration for the dynamic module filter. @see NamedHttpFilterConfigFactory.
+ */
+class DynamicModuleFilterConfig
+    : public Common::FactoryBase<
+          envoy::config::filter::http::dynamic_module::v2alpha::DynamicModule> {
+public:
+  DynamicModuleFilterConfig() : FactoryBase(HttpFilterNames::get().DynamicModule) {}
+
+private:
+  Http::FilterFactoryCb createFilterFactoryFromProtoTyped(
+      const envoy::config::filter::http::dynamic_module::v2alpha::DynamicModule& proto_config,
+      const std::string& stats_prefix, Server::Configuration::FactoryContext& context) override;
+};
+
+} // namespace DynamicModuleFilter
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
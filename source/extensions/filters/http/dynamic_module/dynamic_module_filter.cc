@@ -0,0 +1,76 @@
+#include "extensions/filters/http/dynamic_module/dynamic_module_filter.h"
+
+#include <string>
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace DynamicModuleFilter {
+
+Filter::Filter(Filters::Common::DynamicModule::ModuleSharedPtr module)
+    : module_(module), stream_(module->callbacks().on_http_stream_create_ != nullptr
+                                   ? module->callbacks().on_http_stream_create_(
+                                         module->workerContext())
+                                   : module->workerContext()) {}
+
+void Filter::onDestroy() {
+  ASSERT(!destroyed_);
+  destroyed_ = true;
+  if (module_->callbacks().on_http_stream_destroy_ != nullptr) {
+    module_->callbacks().on_http_stream_destroy_(stream_);
+  }
+}
+
+void Filter::sendLocalReply(Http::Code code, absl::string_view body) {
+  if (!decoding_ || local_reply_sent_) {
+    ENVOY_LOG(debug, "dynamic module: ignoring local reply sent outside of the request flow");
+    return;
+  }
+  local_reply_sent_ = true;
+  decoder_callbacks_->sendLocalReply(code, std::string(body), nullptr);
+}
+
+bool Filter::run(envoy_dynamic_module_on_http_fn callback, Http::HeaderMap* headers,
+                 Buffer::Instance* data, bool end_stream) {
+  // The module doesn't see the local reply it sent, which is encoded while its callback runs.
+  if (callback == nullptr || local_reply_sent_) {
+    return local_reply_sent_;
+  }
+  headers_ = headers;
+  data_ = data;
+  callback(stream_, handle(), end_stream);
+  headers_ = nullptr;
+  data_ = nullptr;
+  return local_reply_sent_;
+}
+
+Http::FilterHeadersStatus Filter::decodeHeaders(Http::HeaderMap& headers, bool end_stream) {
+  decoding_ = true;
+  const bool stopped =
+      run(module_->callbacks().on_http_request_headers_, &headers, nullptr, end_stream);
+  decoding_ = false;
+  return stopped ? Http::FilterHeadersStatus::StopIteration : Http::FilterHeadersStatus::Continue;
+}
+
+Http::FilterDataStatus Filter::decodeData(Buffer::Instance& data, bool end_stream) {
+  decoding_ = true;
+  const bool stopped = run(module_->callbacks().on_http_request_data_, nullptr, &data, end_stream);
+  decoding_ = false;
+  return stopped ? Http::FilterDataStatus::StopIterationNoBuffer
+                 : Http::FilterDataStatus::Continue;
+}
+
+Http::FilterHeadersStatus Filter::encodeHeaders(Http::HeaderMap& headers, bool end_stream) {
+  run(module_->callbacks().on_http_response_headers_, &headers, nullptr, end_stream);
+  return Http::FilterHeadersStatus::Continue;
+}
+
+Http::FilterDataStatus Filter::encodeData(Buffer::Instance& data, bool end_stream) {
+  run(module_->callbacks().on_http_response_data_, nullptr, &data, end_stream);
+  return Http::FilterDataStatus::Continue;
+}
+
+} // namespace DynamicModuleFilter
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string>
+
+#include "envoy/http/filter.h"
+
+#include "common/common/logger.h"
+
+#include "extensions/filters/common/dynamic_module/dynamic_module.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace DynamicModuleFilter {
+
+/**
+ * HTTP dynamic module filter. Each stream creates its own context of the module on the worker,
+ * and runs the request and response headers and data through the callbacks of the module.
+ */
+class Filter : public Http::StreamFilter,
+               public Filters::Common::DynamicModule::HostContext,
+               Logger::Loggable<Logger::Id::filter> {
+public:
+  Filter(Filters::Common::DynamicModule::ModuleSharedPtr module);
+
+  // Filters::Common::DynamicModule::HostContext
+  Http::HeaderMap* headers() override { return headers_; }
+  Buffer::Instance* data() override { return data_; }
+  void sendLocalReply(Http::Code code, absl::string_view body) override;
+
+  // Http::StreamFilterBase
+  void onDestroy() override;
+
+  // Http::StreamDecoderFilter
+  Http::FilterHeadersStatus decodeHeaders(Http::HeaderMap& headers, bool end_stream) override;
+  Http::FilterDataStatus decodeData(Buffer::Instance& data, bool end_stream) override;
+  Http::FilterTrailersStatus decodeTrailers(Http::HeaderMap&) override {
+    return Http::FilterTrailersStatus::Continue;
+  }
+  void setDecoderFilterCallbacks(Http::StreamDecoderFilterCallbacks& callbacks) override {
+    decoder_callbacks_ = &callbacks;
+  }
+
+  // Http::StreamEncoderFilter
+  Http::FilterHeadersStatus encode100ContinueHeaders(Http::HeaderMap&) override {
+    return Http::FilterHeadersStatus::Continue;
+  }
+  Http::FilterHeadersStatus encodeHeaders(Http::HeaderMap& headers, bool end_stream) override;
+  Http::FilterDataStatus encodeData(Buffer::Instance& data, bool end_stream) override;
+  Http::FilterTrailersStatus encodeTrailers(Http::HeaderMap&) override {
+    return Http::FilterTrailersStatus::Continue;
+  }
+  void setEncoderFilterCallbacks(Http::StreamEncoderFilterCallbacks& callbacks) override {
+    encoder_callbacks_ = &callbacks;
+  }
+
+private:
+  // Runs a callback of the module, which can only access the given headers or data. Returns
+  // whether the module sent a local reply.
+  bool run(envoy_dynamic_module_on_http_fn callback, Http::HeaderMap* headers,
+           Buffer::Instance* data, bool end_stream);
+
+  const Filters::Common::DynamicModule::ModuleSharedPtr module_;
+  void* stream_;
+  Http::StreamDecoderFilterCallbacks* decoder_callbacks_{};
+  Http::StreamEncoderFilterCallbacks* encoder_callbacks_{};
+  Http::HeaderMap* headers_{};
+  Buffer::Instance* data_{};
+  bool decoding_{};
+  bool local_reply_sent_{};
+  bool destroyed_{};
+};
+
+} // namespace DynamicModuleFilter
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
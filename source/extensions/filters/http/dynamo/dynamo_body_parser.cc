@@ -0,0 +1,77 @@
+#include "extensions/filters/http/dynamo/dynamo_body_parser.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Dynamo {
+
+// The table of a single table operation is in TableName, and the tables of a batch operation are
+// the keys of RequestItems.
+RequestBodyParser::RequestBodyParser(const std::string& operation)
+    : single_table_(RequestParser::isSingleTableOperation(operation)),
+      batch_(RequestParser::isBatchOperation(operation)), parser_(*this, batch_ ? 2 : 1) {}
+
+bool RequestBodyParser::onValue(const std::vector<std::string>& path,
+                                JsonStreamParser::ValueType type) {
+  if (single_table_) {
+    return path.size() == 1 && path[0] == "TableName" &&
+           type == JsonStreamParser::ValueType::String;
+  }
+
+  if (batch_ && path.size() == 2 && path[0] == "RequestItems" && table_.is_single_table) {
+    if (table_.table_name.empty()) {
+      table_.table_name = path[1];
+    } else if (table_.table_name != path[1]) {
+      table_.table_name = "";
+      table_.is_single_table = false;
+    }
+  }
+  return false;
+}
+
+void RequestBodyParser::onScalar(const std::vector<std::string>&, JsonStreamParser::ValueType,
+                                 const std::string& value) {
+  table_.table_name = value;
+}
+
+// The partitions are in ConsumedCapacity.Partitions, which is the deepest path of interest.
+ResponseBodyParser::ResponseBodyParser() : parser_(*this, 3) {}
+
+bool ResponseBodyParser::onValue(const std::vector<std::string>& path,
+                                 JsonStreamParser::ValueType type) {
+  if (path.size() == 1) {
+    return path[0] == "__type" && type == JsonStreamParser::ValueType::String;
+  } else if (path.size() == 2) {
+    if (path[0] == "UnprocessedKeys") {
+      unprocessed_tables_.push_back(path[1]);
+    }
+  } else if (path.size() == 3) {
+    return path[0] == "ConsumedCapacity" && path[1] == "Partitions" &&
+           type == JsonStreamParser::ValueType::Number;
+  }
+  return false;
+}
+
+void ResponseBodyParser::onScalar(const std::vector<std::string>& path,
+                                  JsonStreamParser::ValueType, const std::string& value) {
+  if (path.size() == 1) {
+    error_type_ = value;
+  } else {
+    // For a given partition id, the amount of capacity used is returned in the body as a double.
+    // Stats counter only increments by whole numbers, capacity is round up to the nearest integer
+    // to account for this.
+    partitions_.emplace_back(path[2],
+                             static_cast<uint64_t>(std::ceil(std::strtod(value.c_str(), nullptr))));
+  }
+}
+
+} // namespace Dynamo
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "extensions/filters/http/dynamo/dynamo_request_parser.h"
+#include "extensions/filters/http/dynamo/json_stream_parser.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Dynamo {
+
+/**
+ * Extracts the table of a dynamodb request while its body is being streamed, in the same way as
+ * RequestParser::parseTable(). Fields of an unexpected type are ignored.
+ */
+class RequestBodyParser : public JsonStreamParser::Callbacks {
+public:
+  RequestBodyParser(const std::string& operation);
+
+  /**
+   * Parse the next chunk of the body.
+   * @return false if the body is not valid JSON.
+   */
+  bool parse(const Buffer::Instance& data) { return parser_.parse(data); }
+
+  /**
+   * Signal the end of the body.
+   * @return true if the body is a complete JSON document.
+   */
+  bool finish() { return parser_.finish(); }
+
+  /**
+   * @return true if the body is empty.
+   */
+  bool empty() const { return parser_.empty(); }
+
+  const RequestParser::TableDescriptor& table() const { return table_; }
+
+  // JsonStreamParser::Callbacks
+  bool onValue(const std::vector<std::string>& path, JsonStreamParser::ValueType type) override;
+  void onScalar(const std::vector<std::string>& path, JsonStreamParser::ValueType type,
+                const std::string& value) override;
+
+private:
+  const bool single_table_;
+  const bool batch_;
+  RequestParser::TableDescriptor table_{"", true};
+  JsonStreamParser parser_;
+};
+
+/**
+ * Extracts the error type, the unprocessed tables and the consumed capacity per partition of a
+ * dynamodb response while its body is being streamed, in the same way as the RequestParser
+ * functions. Fields of an unexpected type are ignored.
+ */
+class ResponseBodyParser : public JsonStreamParser::Callbacks {
+public:
+  ResponseBodyParser();
+
+  bool parse(const Buffer::Instance& data) { return parser_.parse(data); }
+  bool finish() { return parser_.finish(); }
+  bool empty() const { return parser_.empty(); }
+
+  /**
+   * @return the supported error type of the response, or an empty string if there is none.
+   */
+  std::string errorType() const { return RequestParser::matchErrorType(error_type_); }
+  const std::vector<std::string>& unprocessedTables() const { return unprocessed_tables_; }
+  const std::vector<RequestParser::PartitionDescriptor>& partitions() const { return partitions_; }
+
+  // JsonStreamParser::Callbacks
+  bool onValue(const std::vector<std::string>& path, JsonStreamParser::ValueType type) override;
+  void onScalar(const std::vector<std::string>& path, JsonStreamParser::ValueType type,
+                const std::string& value) override;
+
+private:
+  std::string error_type_;
+  std::vector<std::string> unprocessed_tables_;
+  std::vector<RequestParser::PartitionDescriptor> partitions_;
+  JsonStreamParser parser_;
+};
+
+} // namespace Dynamo
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -1,14 +1,14 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <string>
 
 #include "envoy/http/filter.h"
 #include "envoy/runtime/runtime.h"
 #include "envoy/stats/scope.h"
 
-#include "common/json/json_loader.h"
-
+#include "extensions/filters/http/dynamo/dynamo_body_parser.h"
 #include "extensions/filters/http/dynamo/dynamo_request_parser.h"
 
 namespace Envoy {
@@ -21,6 +21,7 @@ namespace Dynamo {
  * It captures RPS/latencies:
  *  1) Per table per response code (and group of response codes, e.g., 2xx/3xx/etc)
  *  2) Per operation per response code (and group of response codes, e.g., 2xx/3xx/etc)
+ * The bodies are parsed incrementally as they stream through the filter, which never buffers them.
  */
 class DynamoFilter : public Http::StreamFilter {
 public:
@@ -52,15 +53,14 @@ public:
   }
 
 private:
-  void onDecodeComplete(const Buffer::Instance& data);
-  void onEncodeComplete(const Buffer::Instance& data);
-  std::string buildBody(const Buffer::Instance* buffered, const Buffer::Instance& last);
+  void onDecodeComplete();
+  void onEncodeComplete();
   void chargeBasicStats(uint64_t status);
   void chargeStatsPerEntity(const std::string& entity, const std::string& entity_type,
                             uint64_t status);
-  void chargeFailureSpecificStats(const Json::Object& json_body);
-  void chargeUnProcessedKeysStats(const Json::Object& json_body);
-  void chargeTablePartitionIdStats(const Json::Object& json_body);
+  void chargeFailureSpecificStats();
+  void chargeUnProcessedKeysStats();
+  void chargeTablePartitionIdStats();
 
   Runtime::Loader& runtime_;
   std::string stat_prefix_;
@@ -69,6 +69,8 @@ private:
   bool enabled_{};
   std::string operation_{};
   RequestParser::TableDescriptor table_descriptor_{"", true};
+  std::unique_ptr<RequestBodyParser> request_parser_;
+  std::unique_ptr<ResponseBodyParser> response_parser_;
   std::string error_type_{};
   MonotonicTime start_decode_;
   Http::HeaderMap* response_headers_;
@@ -71,11 +71,9 @@ RequestParser::TableDescriptor RequestParser::parseTable(const std::string& oper
   TableDescriptor table{"", true};
 
   // Simple operations on a single table, have "TableName" explicitly specified.
-  if (find(SINGLE_TABLE_OPERATIONS.begin(), SINGLE_TABLE_OPERATIONS.end(), operation) !=
-      SINGLE_TABLE_OPERATIONS.end()) {
+  if (isSingleTableOperation(operation)) {
     table.table_name = json_data.getString("TableName", "");
-  } else if (find(BATCH_OPERATIONS.begin(), BATCH_OPERATIONS.end(), operation) !=
-             BATCH_OPERATIONS.end()) {
+  } else if (isBatchOperation(operation)) {
     Json::ObjectSharedPtr tables = json_data.getObject("RequestItems", true);
     tables->iterate([&table](const std::string& key, const Json::Object&) {
       if (table.table_name.empty()) {
@@ -104,7 +102,10 @@ std::vector<std::string> RequestParser::parseBatchUnProcessedKeys(const Json::Ob
   return unprocessed_tables;
 }
 std::string RequestParser::parseErrorType(const Json::Object& json_data) {
-  std::string error_type = json_data.getString("__type", "");
+  return matchErrorType(json_data.getString("__type", ""));
+}
+
+std::string RequestParser::matchErrorType(const std::string& error_type) {
   if (error_type.empty()) {
     return "";
   }
@@ -118,6 +119,11 @@ std::string RequestParser::parseErrorType(const Json::Object& json_data) {
   return "";
 }
 
+bool RequestParser::isSingleTableOperation(const std::string& operation) {
+  return find(SINGLE_TABLE_OPERATIONS.begin(), SINGLE_TABLE_OPERATIONS.end(), operation) !=
+         SINGLE_TABLE_OPERATIONS.end();
+}
+
 bool RequestParser::isBatchOperation(const std::string& operation) {
   return find(BATCH_OPERATIONS.begin(), BATCH_OPERATIONS.end(), operation) !=
          BATCH_OPERATIONS.end();
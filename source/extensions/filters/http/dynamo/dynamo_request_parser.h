@@ -70,6 +70,12 @@ public:
    */
   static std::string parseErrorType(const Json::Object& json_data);
 
+  /**
+   * @return the supported error type which the __type field of an error response ends with, or an
+   * empty string if there is none.
+   */
+  static std::string matchErrorType(const std::string& type);
+
   /**
    * Parse unprocessed keys for batch operation results.
    * @return empty set if there are no unprocessed keys or a set of table names that did not get
@@ -77,6 +83,11 @@ public:
    */
   static std::vector<std::string> parseBatchUnProcessedKeys(const Json::Object& json_data);
 
+  /**
+   * @return true if the operation is in the set of supported SINGLE_TABLE_OPERATIONS
+   */
+  static bool isSingleTableOperation(const std::string& operation);
+
   /**
    * @return true if the operation is in the set of supported BATCH_OPERATIONS
    */
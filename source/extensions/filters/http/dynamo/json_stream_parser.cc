@@ -0,0 +1,345 @@
+#include "extensions/filters/http/dynamo/json_stream_parser.h"
+
+#include "common/common/macros.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Dynamo {
+
+namespace {
+
+bool isWhitespace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+int hexValue(char c) {
+  if (isDigit(c)) {
+    return c - '0';
+  } else if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  } else if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+// Checks a number against the JSON grammar: -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+bool validNumber(const std::string& text) {
+  size_t i = 0;
+  const auto digits = [&text, &i]() -> bool {
+    const size_t start = i;
+    while (i < text.size() && isDigit(text[i])) {
+      i++;
+    }
+    return i > start;
+  };
+
+  if (i < text.size() && text[i] == '-') {
+    i++;
+  }
+  if (i < text.size() && text[i] == '0') {
+    i++;
+  } else if (!digits()) {
+    return false;
+  }
+  if (i < text.size() && text[i] == '.') {
+    i++;
+    if (!digits()) {
+      return false;
+    }
+  }
+  if (i < text.size() && (text[i] == 'e' || text[i] == 'E')) {
+    i++;
+    if (i < text.size() && (text[i] == '+' || text[i] == '-')) {
+      i++;
+    }
+    if (!digits()) {
+      return false;
+    }
+  }
+  return i == text.size();
+}
+
+// Appends a code point of the basic multilingual plane as UTF-8. Surrogate pairs are appended as
+// two separate code points, which is enough for the names matched by the callbacks.
+void appendUtf8(std::string& text, uint32_t code_point) {
+  if (code_point < 0x80) {
+    text.push_back(static_cast<char>(code_point));
+  } else if (code_point < 0x800) {
+    text.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+    text.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  } else {
+    text.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+    text.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+    text.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  }
+}
+
+} // namespace
+
+bool JsonStreamParser::parse(const Buffer::Instance& data) {
+  if (state_ == State::Error) {
+    return false;
+  }
+
+  const uint64_t num_slices = data.getRawSlices(nullptr, 0);
+  Buffer::RawSlice slices[num_slices];
+  data.getRawSlices(slices, num_slices);
+  for (const Buffer::RawSlice& slice : slices) {
+    const char* mem = static_cast<const char*>(slice.mem_);
+    for (uint64_t i = 0; i < slice.len_; i++) {
+      empty_ = false;
+      if (!parseChar(mem[i])) {
+        state_ = State::Error;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool JsonStreamParser::finish() {
+  // A number is only known to be complete at the next character, which a root number lacks.
+  if (state_ == State::Number && !endNumber()) {
+    state_ = State::Error;
+  }
+  return state_ == State::End;
+}
+
+bool JsonStreamParser::parseChar(char c) {
+  switch (state_) {
+  case State::String:
+    if (c == '"') {
+      return endString();
+    } else if (c == '\\') {
+      state_ = State::StringEscape;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      return false;
+    } else if (capture_) {
+      text_.push_back(c);
+    }
+    return true;
+
+  case State::StringEscape: {
+    char unescaped;
+    switch (c) {
+    case '"':
+    case '\\':
+    case '/':
+      unescaped = c;
+      break;
+    case 'b':
+      unescaped = '\b';
+      break;
+    case 'f':
+      unescaped = '\f';
+      break;
+    case 'n':
+      unescaped = '\n';
+      break;
+    case 'r':
+      unescaped = '\r';
+      break;
+    case 't':
+      unescaped = '\t';
+      break;
+    case 'u':
+      unicode_ = 0;
+      unicode_digits_ = 0;
+      state_ = State::StringUnicode;
+      return true;
+    default:
+      return false;
+    }
+    if (capture_) {
+      text_.push_back(unescaped);
+    }
+    state_ = State::String;
+    return true;
+  }
+
+  case State::StringUnicode: {
+    const int value = hexValue(c);
+    if (value < 0) {
+      return false;
+    }
+    unicode_ = unicode_ * 16 + value;
+    if (++unicode_digits_ == 4) {
+      if (capture_) {
+        appendUtf8(text_, unicode_);
+      }
+      state_ = State::String;
+    }
+    return true;
+  }
+
+  case State::Number:
+    if (isDigit(c) || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E') {
+      text_.push_back(c);
+      return true;
+    }
+    // The character following the number is parsed in the state following the number.
+    return endNumber() && parseChar(c);
+
+  case State::Literal:
+    if (c != literal_[literal_position_]) {
+      return false;
+    }
+    if (literal_[++literal_position_] == '\0') {
+      endValue();
+    }
+    return true;
+
+  case State::Error:
+    return false;
+
+  default:
+    break;
+  }
+
+  if (isWhitespace(c)) {
+    return true;
+  }
+
+  switch (state_) {
+  case State::Value:
+    return startValue(c);
+
+  case State::ArrayFirstValue:
+    return c == ']' ? endContainer() : startValue(c);
+
+  case State::ObjectFirstKey:
+    if (c == '}') {
+      return endContainer();
+    }
+    FALLTHRU;
+
+  case State::Key:
+    if (c != '"') {
+      return false;
+    }
+    key_ = true;
+    capture_ = reported();
+    text_.clear();
+    state_ = State::String;
+    return true;
+
+  case State::Colon:
+    if (c != ':') {
+      return false;
+    }
+    state_ = State::Value;
+    return true;
+
+  case State::CommaOrEnd: {
+    const bool object = containers_.back();
+    if (c == ',') {
+      if (object && hasKey()) {
+        path_.pop_back();
+      }
+      state_ = object ? State::Key : State::Value;
+      return true;
+    } else if (c == (object ? '}' : ']')) {
+      return endContainer();
+    }
+    return false;
+  }
+
+  default:
+    // Only whitespace may follow the root value.
+    return false;
+  }
+}
+
+bool JsonStreamParser::startValue(char c) {
+  ValueType type;
+  if (c == '{') {
+    type = ValueType::Object;
+  } else if (c == '[') {
+    type = ValueType::Array;
+  } else if (c == '"') {
+    type = ValueType::String;
+  } else if (c == '-' || isDigit(c)) {
+    type = ValueType::Number;
+  } else if (c == 't' || c == 'f' || c == 'n') {
+    type = ValueType::Literal;
+  } else {
+    return false;
+  }
+
+  const bool capture = reported() && callbacks_.onValue(path_, type);
+  switch (type) {
+  case ValueType::Object:
+    containers_.push_back(true);
+    state_ = State::ObjectFirstKey;
+    break;
+  case ValueType::Array:
+    containers_.push_back(false);
+    arrays_++;
+    state_ = State::ArrayFirstValue;
+    break;
+  case ValueType::String:
+    key_ = false;
+    capture_ = capture;
+    text_.clear();
+    state_ = State::String;
+    break;
+  case ValueType::Number:
+    capture_ = capture;
+    text_.assign(1, c);
+    state_ = State::Number;
+    break;
+  case ValueType::Literal:
+    literal_ = c == 't' ? "true" : (c == 'f' ? "false" : "null");
+    literal_position_ = 1;
+    state_ = State::Literal;
+    break;
+  }
+  return true;
+}
+
+bool JsonStreamParser::endString() {
+  if (key_) {
+    if (capture_) {
+      path_.push_back(std::move(text_));
+      text_.clear();
+    }
+    state_ = State::Colon;
+  } else {
+    if (capture_) {
+      callbacks_.onScalar(path_, ValueType::String, text_);
+    }
+    endValue();
+  }
+  return true;
+}
+
+bool JsonStreamParser::endNumber() {
+  if (!validNumber(text_)) {
+    return false;
+  }
+  if (capture_) {
+    callbacks_.onScalar(path_, ValueType::Number, text_);
+  }
+  endValue();
+  return true;
+}
+
+bool JsonStreamParser::endContainer() {
+  if (containers_.back()) {
+    if (hasKey()) {
+      path_.pop_back();
+    }
+  } else {
+    arrays_--;
+  }
+  containers_.pop_back();
+  endValue();
+  return true;
+}
+
+} // namespace Dynamo
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "envoy/buffer/buffer.h"
+#include "envoy/common/pure.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Dynamo {
+
+/**
+ * Incremental JSON parser, which is fed with a body as it arrives and reports the values found in
+ * the first levels of nested objects, without building a document or waiting for the end of the
+ * body. The whole body is validated, but only the values whose path is made of at most max_depth
+ * object keys are reported; the contents of the arrays are never reported. The memory used is
+ * bounded by the nesting of the body and the length of the captured strings, not by its size.
+ */
+class JsonStreamParser {
+public:
+  enum class ValueType { Object, Array, String, Number, Literal };
+
+  class Callbacks {
+  public:
+    virtual ~Callbacks() {}
+
+    /**
+     * Called when a value starts.
+     * @param path supplies the keys of the objects leading to the value, which is empty for the
+     *        root value.
+     * @param type supplies the type of the value.
+     * @return true to receive the text of a string or number value with onScalar().
+     */
+    virtual bool onValue(const std::vector<std::string>& path, ValueType type) PURE;
+
+    /**
+     * Called when a string or number value for which onValue() returned true is complete.
+     * @param path supplies the keys of the objects leading to the value.
+     * @param type supplies the type of the value.
+     * @param value supplies the unescaped string, or the text of the number.
+     */
+    virtual void onScalar(const std::vector<std::string>& path, ValueType type,
+                          const std::string& value) PURE;
+  };
+
+  JsonStreamParser(Callbacks& callbacks, uint32_t max_depth)
+      : callbacks_(callbacks), max_depth_(max_depth) {}
+
+  /**
+   * Parse the next chunk of the body.
+   * @return false if the body is not valid JSON, after which the data is ignored.
+   */
+  bool parse(const Buffer::Instance& data);
+
+  /**
+   * Signal the end of the body.
+   * @return true if the body is a complete JSON document.
+   */
+  bool finish();
+
+  /**
+   * @return true if no data has been parsed.
+   */
+  bool empty() const { return empty_; }
+
+private:
+  enum class State {
+    Value,
+    ArrayFirstValue,
+    ObjectFirstKey,
+    Key,
+    Colon,
+    CommaOrEnd,
+    String,
+    StringEscape,
+    StringUnicode,
+    Number,
+    Literal,
+    End,
+    Error
+  };
+
+  bool parseChar(char c);
+  bool startValue(char c);
+  bool endString();
+  bool endNumber();
+  bool endContainer();
+  void endValue() { state_ = containers_.empty() ? State::End : State::CommaOrEnd; }
+  // Whether a value, or the key of a value, at the current position is reported.
+  bool reported() const { return arrays_ == 0 && containers_.size() <= max_depth_; }
+  // Whether the key of the current object is the last element of path_.
+  bool hasKey() const { return path_.size() == containers_.size(); }
+
+  Callbacks& callbacks_;
+  const uint32_t max_depth_;
+  State state_{State::Value};
+  bool empty_{true};
+  // The open containers, true for the objects and false for the arrays.
+  std::vector<bool> containers_;
+  uint32_t arrays_{};
+  // The keys leading to the current value, only kept while the value is reported.
+  std::vector<std::string> path_;
+  // Whether the current string is a key rather than a value.
+  bool key_{};
+  // Whether the text of the current string or number is kept.
+  bool capture_{};
+  std::string text_;
+  uint32_t unicode_{};
+  uint32_t unicode_digits_{};
+  const char* literal_{};
+  uint32_t literal_position_{};
+};
+
+} // namespace Dynamo
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,50 @@
+#include "extensions/filters/http/ext_authz/decision_cache.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace ExtAuthz {
+
+const Filters::Common::ExtAuthz::Response* DecisionCache::find(absl::string_view key,
+                                                               MonotonicTime now) {
+  const auto it = map_.find(key);
+  if (it == map_.end()) {
+    return nullptr;
+  }
+
+  const EntryList::iterator entry = it->second;
+  if (entry->expiration_ <= now) {
+    erase(entry);
+    return nullptr;
+  }
+
+  entries_.splice(entries_.begin(), entries_, entry);
+  return &entry->response_;
+}
+
+void DecisionCache::insert(const std::string& key,
+                           const Filters::Common::ExtAuthz::Response& response,
+                           MonotonicTime expiration) {
+  if (max_entries_ == 0) {
+    return;
+  }
+
+  const auto it = map_.find(key);
+  if (it != map_.end()) {
+    erase(it->second);
+  } else if (map_.size() >= max_entries_) {
+    erase(std::prev(entries_.end()));
+  }
+  entries_.emplace_front(key, response, expiration);
+  map_.emplace(entries_.front().key_, entries_.begin());
+}
+
+void DecisionCache::erase(EntryList::iterator entry) {
+  map_.erase(entry->key_);
+  entries_.erase(entry);
+}
+
+} // namespace ExtAuthz
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
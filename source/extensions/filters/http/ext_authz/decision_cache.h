@@ -0,0 +1,76 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "envoy/common/time.h"
+
+#include "common/common/utility.h"
+
+#include "extensions/filters/common/ext_authz/ext_authz.h"
+
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace ExtAuthz {
+
+/**
+ * LRU cache of the decisions of the authorization service, keyed by the attributes of the
+ * requests they were taken for. Decisions are evicted once expired.
+ */
+class DecisionCache {
+public:
+  /**
+   * @param max_entries supplies the maximum number of decisions cached.
+   */
+  DecisionCache(uint64_t max_entries) : max_entries_(max_entries) {}
+
+  /**
+   * Looks up a decision.
+   * @param key supplies the attributes of the request.
+   * @param now supplies the current time, to evict an expired decision.
+   * @return const Response* the decision, valid until the cache is next modified, or nullptr if
+   *         it is not cached.
+   */
+  const Filters::Common::ExtAuthz::Response* find(absl::string_view key, MonotonicTime now);
+
+  /**
+   * Caches a decision, replacing the one cached for the same attributes if any.
+   * @param key supplies the attributes of the request.
+   * @param response supplies the decision.
+   * @param expiration supplies the time at which the decision expires.
+   */
+  void insert(const std::string& key, const Filters::Common::ExtAuthz::Response& response,
+              MonotonicTime expiration);
+
+  uint64_t size() const { return map_.size(); }
+
+private:
+  struct Entry {
+    Entry(const std::string& key, const Filters::Common::ExtAuthz::Response& response,
+          MonotonicTime expiration)
+        : key_(key), response_(response), expiration_(expiration) {}
+
+    const std::string key_;
+    const Filters::Common::ExtAuthz::Response response_;
+    const MonotonicTime expiration_;
+  };
+  typedef std::list<Entry> EntryList;
+
+  void erase(EntryList::iterator entry);
+
+  const uint64_t max_entries_;
+  // The entries from the most to the least recently used.
+  EntryList entries_;
+  // The entries are never moved by the list, so their keys can key the map.
+  std::unordered_map<absl::string_view, EntryList::iterator, StringViewHash> map_;
+};
+
+} // namespace ExtAuthz
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
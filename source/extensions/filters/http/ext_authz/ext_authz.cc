@@ -1,8 +1,14 @@
 #include "extensions/filters/http/ext_authz/ext_authz.h"
 
+#include <algorithm>
+
+#include "envoy/ssl/connection.h"
+
 #include "common/common/assert.h"
 #include "common/common/enum_to_int.h"
+#include "common/common/utility.h"
 #include "common/http/codes.h"
+#include "common/protobuf/utility.h"
 #include "common/router/config_impl.h"
 
 namespace Envoy {
@@ -10,6 +16,121 @@ namespace Extensions {
 namespace HttpFilters {
 namespace ExtAuthz {
 
+namespace {
+constexpr uint64_t DefaultDecisionCacheMaxEntries = 1000;
+} // namespace
+
+FilterConfig::FilterConfig(const envoy::config::filter::http::ext_authz::v2alpha::ExtAuthz& config,
+                           const LocalInfo::LocalInfo& local_info, Stats::Scope& scope,
+                           Runtime::Loader& runtime, Upstream::ClusterManager& cm,
+                           ThreadLocal::SlotAllocator& tls, TimeSource& time_source)
+    : local_info_(local_info), scope_(scope), runtime_(runtime), cm_(cm),
+      cluster_name_(config.grpc_service().envoy_grpc().cluster_name()),
+      allowed_authorization_headers_(
+          toHeaders(config.http_service().allowed_authorization_headers())),
+      allowed_request_headers_(toRequestHeaders(config.http_service().allowed_request_headers())),
+      allowed_headers_(toHeaders(config.allowed_headers())),
+      failure_mode_allow_(config.failure_mode_allow()), time_source_(time_source) {
+  if (!config.has_decision_cache()) {
+    return;
+  }
+
+  const auto& cache_config = config.decision_cache();
+  decision_ttl_ = std::chrono::milliseconds(PROTOBUF_GET_MS_REQUIRED(cache_config, ttl));
+  key_principal_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(cache_config, key_principal, true);
+  key_method_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(cache_config, key_method, true);
+  key_path_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(cache_config, key_path, true);
+  for (const auto& header : cache_config.key_headers()) {
+    key_headers_.emplace_back(header);
+  }
+  if (!cache_config.ttl_header().empty()) {
+    ttl_header_.emplace(cache_config.ttl_header());
+  }
+
+  const uint64_t max_entries =
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(cache_config, max_entries, DefaultDecisionCacheMaxEntries);
+  tls_ = tls.allocateSlot();
+  tls_->set([max_entries](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<ThreadLocalDecisionCache>(max_entries);
+  });
+}
+
+std::string FilterConfig::decisionKey(const Http::HeaderMap& headers,
+                                      const Network::Connection& connection) const {
+  // Each attribute is terminated by a NUL character, which HTTP header values can't hold, and
+  // the headers are prefixed by whether they are present.
+  std::string key;
+  if (key_principal_ && connection.ssl() != nullptr) {
+    std::string principal = connection.ssl()->uriSanPeerCertificate();
+    key.append(principal.empty() ? connection.ssl()->subjectPeerCertificate() : principal);
+  }
+  key.push_back('\0');
+  if (key_method_ && headers.Method() != nullptr) {
+    const absl::string_view method = headers.Method()->value().getStringView();
+    key.append(method.data(), method.size());
+  }
+  key.push_back('\0');
+  if (key_path_ && headers.Path() != nullptr) {
+    const absl::string_view path = headers.Path()->value().getStringView();
+    key.append(path.data(), path.size());
+  }
+  key.push_back('\0');
+  for (const Http::LowerCaseString& name : key_headers_) {
+    const Http::HeaderEntry* header = headers.get(name);
+    if (header != nullptr) {
+      const absl::string_view value = header->value().getStringView();
+      key.push_back('+');
+      key.append(value.data(), value.size());
+    } else {
+      key.push_back('-');
+    }
+    key.push_back('\0');
+  }
+  return key;
+}
+
+const Filters::Common::ExtAuthz::Response* FilterConfig::findDecision(const std::string& key) {
+  return tls_->getTyped<ThreadLocalDecisionCache>().cache_.find(key,
+                                                                time_source_.monotonicTime());
+}
+
+void FilterConfig::cacheDecision(const std::string& key,
+                                 Filters::Common::ExtAuthz::Response& response) {
+  std::chrono::milliseconds ttl = decision_ttl_;
+  if (ttl_header_.has_value()) {
+    absl::optional<uint64_t> seconds;
+    const auto is_ttl_header = [this, &seconds](const Http::HeaderVector::value_type& header) {
+      if (header.first == ttl_header_.value()) {
+        uint64_t value;
+        if (StringUtil::atoul(header.second.c_str(), value)) {
+          seconds = value;
+        }
+        return true;
+      }
+      return false;
+    };
+    auto& headers_to_add = response.headers_to_add;
+    headers_to_add.erase(
+        std::remove_if(headers_to_add.begin(), headers_to_add.end(), is_ttl_header),
+        headers_to_add.end());
+    auto& headers_to_append = response.headers_to_append;
+    headers_to_append.erase(
+        std::remove_if(headers_to_append.begin(), headers_to_append.end(), is_ttl_header),
+        headers_to_append.end());
+
+    // Without the header, or with an invalid one, the decision isn't cached.
+    if (!seconds.has_value()) {
+      return;
+    }
+    ttl = std::min(ttl, std::chrono::milliseconds(std::chrono::seconds(seconds.value())));
+  }
+
+  if (ttl.count() > 0) {
+    tls_->getTyped<ThreadLocalDecisionCache>().cache_.insert(
+        key, response, time_source_.monotonicTime() + ttl);
+  }
+}
+
 void Filter::initiateCall(const Http::HeaderMap& headers) {
   Router::RouteConstSharedPtr route = callbacks_->route();
   if (route == nullptr || route->routeEntry() == nullptr) {
@@ -23,8 +144,25 @@ void Filter::initiateCall(const Http::HeaderMap& headers) {
   }
   cluster_ = cluster->info();
 
-  Filters::Common::ExtAuthz::CheckRequestUtils::createHttpCheck(callbacks_, headers,
-                                                                check_request_);
+  if (config_->decisionCacheEnabled()) {
+    std::string key = config_->decisionKey(headers, *callbacks_->connection());
+    const Filters::Common::ExtAuthz::Response* decision = config_->findDecision(key);
+    if (decision != nullptr) {
+      cluster_->statsScope().counter("ext_authz.cache_hit").inc();
+      ENVOY_STREAM_LOG(trace, "Ext_authz found the decision in the cache", *callbacks_);
+      state_ = State::Calling;
+      filter_return_ = FilterReturn::StopDecoding;
+      initiating_call_ = true;
+      onComplete(std::make_unique<Filters::Common::ExtAuthz::Response>(*decision));
+      initiating_call_ = false;
+      return;
+    }
+    cache_decision_ = true;
+    decision_key_ = std::move(key);
+  }
+
+  Filters::Common::ExtAuthz::CheckRequestUtils::createHttpCheck(
+      callbacks_, headers, config_->allowedHeaders(), check_request_);
 
   state_ = State::Calling;
   // Don't let the filter chain continue as we are going to invoke check call.
@@ -70,6 +208,10 @@ void Filter::onComplete(Filters::Common::ExtAuthz::ResponsePtr&& response) {
 
   using Filters::Common::ExtAuthz::CheckStatus;
 
+  if (cache_decision_ && response->status != CheckStatus::Error) {
+    config_->cacheDecision(decision_key_, *response);
+  }
+
   switch (response->status) {
   case CheckStatus::OK:
     cluster_->statsScope().counter("ext_authz.ok").inc();
@@ -5,11 +5,13 @@
 #include <string>
 #include <vector>
 
+#include "envoy/common/time.h"
 #include "envoy/config/filter/http/ext_authz/v2alpha/ext_authz.pb.h"
 #include "envoy/http/filter.h"
 #include "envoy/local_info/local_info.h"
 #include "envoy/runtime/runtime.h"
 #include "envoy/stats/scope.h"
+#include "envoy/thread_local/thread_local.h"
 #include "envoy/upstream/cluster_manager.h"
 
 #include "common/common/assert.h"
@@ -18,6 +20,9 @@
 
 #include "extensions/filters/common/ext_authz/ext_authz.h"
 #include "extensions/filters/common/ext_authz/ext_authz_grpc_impl.h"
+#include "extensions/filters/http/ext_authz/decision_cache.h"
+
+#include "absl/types/optional.h"
 
 namespace Envoy {
 namespace Extensions {
@@ -36,13 +41,8 @@ class FilterConfig {
 public:
   FilterConfig(const envoy::config::filter::http::ext_authz::v2alpha::ExtAuthz& config,
                const LocalInfo::LocalInfo& local_info, Stats::Scope& scope,
-               Runtime::Loader& runtime, Upstream::ClusterManager& cm)
-      : local_info_(local_info), scope_(scope), runtime_(runtime), cm_(cm),
-        cluster_name_(config.grpc_service().envoy_grpc().cluster_name()),
-        allowed_authorization_headers_(
-            toAuthorizationHeaders(config.http_service().allowed_authorization_headers())),
-        allowed_request_headers_(toRequestHeaders(config.http_service().allowed_request_headers())),
-        failure_mode_allow_(config.failure_mode_allow()) {}
+               Runtime::Loader& runtime, Upstream::ClusterManager& cm,
+               ThreadLocal::SlotAllocator& tls, TimeSource& time_source);
 
   const LocalInfo::LocalInfo& localInfo() const { return local_info_; }
   Runtime::Loader& runtime() { return runtime_; }
@@ -53,9 +53,41 @@ public:
     return allowed_authorization_headers_;
   }
   const Http::LowerCaseStrUnorderedSet& allowedRequestHeaders() { return allowed_request_headers_; }
+  // The request headers sent to the gRPC authorization service, all of them when empty.
+  const Http::LowerCaseStrUnorderedSet& allowedHeaders() const { return allowed_headers_; }
 
   bool failureModeAllow() const { return failure_mode_allow_; }
 
+  /**
+   * @return whether the decisions of the authorization service are cached.
+   */
+  bool decisionCacheEnabled() const { return tls_ != nullptr; }
+
+  /**
+   * Builds the key of the decisions from the attributes of a request.
+   * @param headers supplies the request headers.
+   * @param connection supplies the downstream connection.
+   * @return std::string the key.
+   */
+  std::string decisionKey(const Http::HeaderMap& headers,
+                          const Network::Connection& connection) const;
+
+  /**
+   * Looks up a decision in the cache of the worker.
+   * @param key supplies the key of the decision.
+   * @return const Response* the decision, valid until the cache is next modified, or nullptr if
+   *         it is not cached.
+   */
+  const Filters::Common::ExtAuthz::Response* findDecision(const std::string& key);
+
+  /**
+   * Caches a decision in the cache of the worker, unless the authorization service directed not
+   * to. The header directing the caching is removed from the response.
+   * @param key supplies the key of the decision.
+   * @param response supplies the decision.
+   */
+  void cacheDecision(const std::string& key, Filters::Common::ExtAuthz::Response& response);
+
 private:
   static Http::LowerCaseStrUnorderedSet toRequestHeaders(
       const Protobuf::RepeatedPtrField<Envoy::ProtobufTypes::String>& request_headers) {
@@ -70,14 +102,14 @@ private:
     return headers;
   }
 
-  static Http::LowerCaseStrUnorderedSet toAuthorizationHeaders(
-      const Protobuf::RepeatedPtrField<Envoy::ProtobufTypes::String>& response_headers) {
-    Http::LowerCaseStrUnorderedSet headers;
-    headers.reserve(response_headers.size());
-    for (const auto& header : response_headers) {
-      headers.emplace(header);
+  static Http::LowerCaseStrUnorderedSet
+  toHeaders(const Protobuf::RepeatedPtrField<Envoy::ProtobufTypes::String>& headers) {
+    Http::LowerCaseStrUnorderedSet result;
+    result.reserve(headers.size());
+    for (const auto& header : headers) {
+      result.emplace(header);
     }
-    return headers;
+    return result;
   }
 
   const LocalInfo::LocalInfo& local_info_;
@@ -87,8 +119,24 @@ private:
   std::string cluster_name_;
   Http::LowerCaseStrUnorderedSet allowed_authorization_headers_;
   Http::LowerCaseStrUnorderedSet allowed_request_headers_;
+  const Http::LowerCaseStrUnorderedSet allowed_headers_;
   bool failure_mode_allow_;
-};
+
+  struct ThreadLocalDecisionCache : public ThreadLocal::ThreadLocalObject {
+    ThreadLocalDecisionCache(uint64_t max_entries) : cache_(max_entries) {}
+
+    DecisionCache cache_;
+  };
+
+  TimeSource& time_source_;
+  std::chrono::milliseconds decision_ttl_{};
+  bool key_principal_{};
+  bool key_method_{};
+  bool key_path_{};
+  std::vector<Http::LowerCaseString> key_headers_;
+  absl::optional<Http::LowerCaseString> ttl_header_;
+  // Only allocated when the decision cache is enabled.
+  ThreadLocal::SlotPtr tls_;
 
 typedef std::shared_ptr<FilterConfig> FilterConfigSharedPtr;
 
@@ -136,6 +184,9 @@ private:
   Upstream::ClusterInfoConstSharedPtr cluster_;
   // Used to identify if the callback to onComplete() is synchronous (on the stack) or asynchronous.
   bool initiating_call_{};
+  // Whether the decision of the authorization service is to be cached under decision_key_.
+  bool cache_decision_{};
+  std::string decision_key_;
   envoy::service::auth::v2alpha::CheckRequest check_request_{};
 };
 
@@ -101,7 +101,11 @@ JsonTranscoderConfig::JsonTranscoderConfig(
     }
   }
 
-  PathMatcherBuilder<const Protobuf::MethodDescriptor*> pmb;
+  type_helper_.reset(
+      new google::grpc::transcoding::TypeHelper(Protobuf::util::NewTypeResolverForDescriptorPool(
+          Grpc::Common::typeUrlPrefix(), &descriptor_pool_)));
+
+  PathMatcherBuilder<const MethodInfo*> pmb;
 
   for (const auto& service_name : proto_config.services()) {
     auto service = descriptor_pool_.FindServiceByName(service_name);
@@ -111,8 +115,14 @@ JsonTranscoderConfig::JsonTranscoderConfig(
     }
     for (int i = 0; i < service->method_count(); ++i) {
       auto method = service->method(i);
+      // The types are resolved here, so that the requests only go through the path matcher.
+      methods_.emplace_back(new MethodInfo{
+          method,
+          type_helper_->Info()->GetTypeByTypeUrl(
+              Grpc::Common::typeUrl(method->input_type()->full_name())),
+          Grpc::Common::typeUrl(method->output_type()->full_name())});
       if (!PathMatcherUtility::RegisterByHttpRule(
-              pmb, method->options().GetExtension(google::api::http), method)) {
+              pmb, method->options().GetExtension(google::api::http), methods_.back().get())) {
         throw EnvoyException("transcoding_filter: Cannot register '" + method->full_name() +
                              "' to path matcher");
       }
@@ -121,10 +131,6 @@ JsonTranscoderConfig::JsonTranscoderConfig(
 
   path_matcher_ = pmb.Build();
 
-  type_helper_.reset(
-      new google::grpc::transcoding::TypeHelper(Protobuf::util::NewTypeResolverForDescriptorPool(
-          Grpc::Common::typeUrlPrefix(), &descriptor_pool_)));
-
   const auto print_config = proto_config.print_options();
   print_options_.add_whitespace = print_config.add_whitespace();
   print_options_.always_print_primitive_fields = print_config.always_print_primitive_fields();
@@ -132,6 +138,7 @@ JsonTranscoderConfig::JsonTranscoderConfig(
   print_options_.preserve_proto_field_names = print_config.preserve_proto_field_names();
 
   match_incoming_request_route_ = proto_config.match_incoming_request_route();
+  stream_unary_responses_ = proto_config.stream_unary_responses();
 }
 
 bool JsonTranscoderConfig::matchIncomingRequestInfo() const {
@@ -158,13 +165,14 @@ ProtobufUtil::Status JsonTranscoderConfig::createTranscoder(
 
   struct RequestInfo request_info;
   std::vector<VariableBinding> variable_bindings;
-  method_descriptor =
+  const MethodInfo* method_info =
       path_matcher_->Lookup(method, path, args, &variable_bindings, &request_info.body_field_path);
-  if (!method_descriptor) {
+  if (!method_info) {
     return ProtobufUtil::Status(Code::NOT_FOUND, "Could not resolve " + path + " to a method");
   }
+  method_descriptor = method_info->descriptor_;
 
-  auto status = methodToRequestInfo(method_descriptor, &request_info);
+  auto status = methodToRequestInfo(*method_info, &request_info);
   if (!status.ok()) {
     return status;
   }
@@ -186,11 +194,9 @@ ProtobufUtil::Status JsonTranscoderConfig::createTranscoder(
       new JsonRequestTranslator(type_helper_->Resolver(), &request_input, request_info,
                                 method_descriptor->client_streaming(), true)};
 
-  const auto response_type_url =
-      Grpc::Common::typeUrl(method_descriptor->output_type()->full_name());
   std::unique_ptr<ResponseToJsonTranslator> response_translator{new ResponseToJsonTranslator(
-      type_helper_->Resolver(), response_type_url, method_descriptor->server_streaming(),
-      &response_input, print_options_)};
+      type_helper_->Resolver(), method_info->response_type_url_,
+      method_descriptor->server_streaming(), &response_input, print_options_)};
 
   transcoder.reset(
       new TranscoderImpl(std::move(request_translator), std::move(response_translator)));
@@ -198,14 +204,13 @@ ProtobufUtil::Status JsonTranscoderConfig::createTranscoder(
 }
 
 ProtobufUtil::Status
-JsonTranscoderConfig::methodToRequestInfo(const Protobuf::MethodDescriptor* method,
+JsonTranscoderConfig::methodToRequestInfo(const MethodInfo& method,
                                           google::grpc::transcoding::RequestInfo* info) {
-  auto request_type_url = Grpc::Common::typeUrl(method->input_type()->full_name());
-  info->message_type = type_helper_->Info()->GetTypeByTypeUrl(request_type_url);
+  info->message_type = method.request_type_;
   if (info->message_type == nullptr) {
-    ENVOY_LOG(debug, "Cannot resolve input-type: {}", method->input_type()->full_name());
-    return ProtobufUtil::Status(Code::NOT_FOUND,
-                                "Could not resolve type: " + method->input_type()->full_name());
+    const std::string& input_type = method.descriptor_->input_type()->full_name();
+    ENVOY_LOG(debug, "Cannot resolve input-type: {}", input_type);
+    return ProtobufUtil::Status(Code::NOT_FOUND, "Could not resolve type: " + input_type);
   }
 
   return ProtobufUtil::Status();
@@ -330,9 +335,11 @@ Http::FilterHeadersStatus JsonTranscoderFilter::encodeHeaders(Http::HeaderMap& h
   }
 
   headers.insertContentType().value().setReference(Http::Headers::get().ContentTypeValues.Json);
-  if (!method_->server_streaming()) {
+  if (!streamResponse()) {
     return Http::FilterHeadersStatus::StopIteration;
   }
+  // The content length of the gRPC response doesn't apply to its JSON.
+  headers.removeContentLength();
 
   return Http::FilterHeadersStatus::Continue;
 }
@@ -356,7 +363,7 @@ Http::FilterDataStatus JsonTranscoderFilter::encodeData(Buffer::Instance& data,
 
   readToBuffer(*transcoder_->ResponseOutput(), data);
 
-  if (!method_->server_streaming() && !end_stream) {
+  if (!streamResponse() && !end_stream) {
     // Buffer until the response is complete.
     return Http::FilterDataStatus::StopIterationAndBuffer;
   }
@@ -379,8 +386,9 @@ Http::FilterTrailersStatus JsonTranscoderFilter::encodeTrailers(Http::HeaderMap&
     encoder_callbacks_->addEncodedData(data, true);
   }
 
-  if (method_->server_streaming()) {
-    // For streaming case, the headers are already sent, so just continue here.
+  if (method_->server_streaming() || (streamResponse() && &trailers != response_headers_)) {
+    // For streaming case, the headers are already sent, so just continue here. The headers of the
+    // trailers-only unary responses are not sent yet, so their status is still converted.
     return Http::FilterTrailersStatus::Continue;
   }
 
@@ -39,6 +39,19 @@ struct VariableBinding {
   ProtobufTypes::String value;
 };
 
+/**
+ * A method of the transcoded services, along with the types it uses, which are resolved once when
+ * the configuration is loaded rather than for every request.
+ */
+struct MethodInfo {
+  const Protobuf::MethodDescriptor* descriptor_;
+  // The type of the request message, or nullptr if the type resolver doesn't know it.
+  const Protobuf::Type* request_type_;
+  const std::string response_type_url_;
+};
+
+typedef std::unique_ptr<MethodInfo> MethodInfoPtr;
+
 /**
  * Global configuration for the gRPC JSON transcoder filter. Factory for the Transcoder interface.
  */
@@ -73,20 +86,28 @@ public:
    */
   bool matchIncomingRequestInfo() const;
 
+  /**
+   * If true, the JSON of the unary responses is sent downstream as it is transcoded rather than
+   * once the response is complete.
+   */
+  bool streamUnaryResponses() const { return stream_unary_responses_; }
+
 private:
   /**
-   * Convert method descriptor to RequestInfo that needed for transcoding library
+   * Convert method to RequestInfo that needed for transcoding library
    */
-  ProtobufUtil::Status methodToRequestInfo(const Protobuf::MethodDescriptor* method,
+  ProtobufUtil::Status methodToRequestInfo(const MethodInfo& method,
                                            google::grpc::transcoding::RequestInfo* info);
 
 private:
   Protobuf::DescriptorPool descriptor_pool_;
-  google::grpc::transcoding::PathMatcherPtr<const Protobuf::MethodDescriptor*> path_matcher_;
+  std::vector<MethodInfoPtr> methods_;
+  google::grpc::transcoding::PathMatcherPtr<const MethodInfo*> path_matcher_;
   std::unique_ptr<google::grpc::transcoding::TypeHelper> type_helper_;
   Protobuf::util::JsonPrintOptions print_options_;
 
   bool match_incoming_request_route_{false};
+  bool stream_unary_responses_{false};
 };
 
 typedef std::shared_ptr<JsonTranscoderConfig> JsonTranscoderConfigSharedPtr;
@@ -120,6 +141,12 @@ private:
   bool readToBuffer(Protobuf::io::ZeroCopyInputStream& stream, Buffer::Instance& data);
   void buildResponseFromHttpBodyOutput(Http::HeaderMap& response_headers, Buffer::Instance& data);
   bool hasHttpBodyAsOutputType();
+  // Whether the response is sent downstream as it is transcoded. The HttpBody responses set their
+  // headers from the message, so they are always buffered.
+  bool streamResponse() const {
+    return method_->server_streaming() ||
+           (config_.streamUnaryResponses() && !has_http_body_output_);
+  }
 
   JsonTranscoderConfig& config_;
   std::unique_ptr<google::grpc::transcoding::Transcoder> transcoder_;
@@ -2,6 +2,8 @@
 
 #include <arpa/inet.h>
 
+#include <cstring>
+
 #include "common/common/assert.h"
 #include "common/common/base64.h"
 #include "common/common/empty_string.h"
@@ -86,40 +88,23 @@ Http::FilterDataStatus GrpcWebFilter::decodeData(Buffer::Instance& data, bool en
     return Http::FilterDataStatus::Continue;
   }
 
-  // Parse application/grpc-web-text format.
-  const uint64_t available = data.length() + decoding_buffer_.length();
-  if (end_stream) {
-    if (available == 0) {
-      return Http::FilterDataStatus::Continue;
-    }
-    if (available % 4 != 0) {
-      // Client end stream with invalid base64. Note, base64 padding is mandatory.
-      decoder_callbacks_->sendLocalReply(Http::Code::BadRequest,
-                                         "Bad gRPC-web request, invalid base64 data.", nullptr);
-      return Http::FilterDataStatus::StopIterationNoBuffer;
-    }
-  } else if (available < 4) {
-    decoding_buffer_.move(data);
-    return Http::FilterDataStatus::StopIterationNoBuffer;
-  }
-
-  const uint64_t needed = available / 4 * 4 - decoding_buffer_.length();
-  decoding_buffer_.move(data, needed);
-  const std::string decoded = Base64::decode(
-      std::string(static_cast<const char*>(decoding_buffer_.linearize(decoding_buffer_.length())),
-                  decoding_buffer_.length()));
-  if (decoded.empty()) {
+  // Parse application/grpc-web-text format. The data is moved behind the leftover of the previous
+  // frames without any copy, and decoded slice by slice back into the data.
+  decoding_buffer_.move(data);
+  // Note, base64 padding is mandatory, so the client must end the stream on a complete group.
+  if ((end_stream && decoding_buffer_.length() % 4 != 0) ||
+      !Base64::decode(decoding_buffer_, data)) {
     // Error happened when decoding base64.
     decoder_callbacks_->sendLocalReply(Http::Code::BadRequest,
                                        "Bad gRPC-web request, invalid base64 data.", nullptr);
     return Http::FilterDataStatus::StopIterationNoBuffer;
   }
 
-  decoding_buffer_.drain(decoding_buffer_.length());
-  decoding_buffer_.move(data);
-  data.add(decoded);
   // Any block of 4 bytes or more should have been decoded and passed through.
   ASSERT(decoding_buffer_.length() < 4);
+  if (data.length() == 0 && !end_stream) {
+    return Http::FilterDataStatus::StopIterationNoBuffer;
+  }
   return Http::FilterDataStatus::Continue;
 }
 
@@ -162,16 +147,16 @@ Http::FilterDataStatus GrpcWebFilter::encodeData(Buffer::Instance& data, bool) {
     return Http::FilterDataStatus::StopIterationNoBuffer;
   }
 
-  // Encodes the decoded gRPC frames with base64.
+  // Encodes the decoded gRPC frames with base64, directly from their slices into the data.
   for (auto& frame : frames) {
     Buffer::OwnedImpl temp;
     temp.add(&frame.flags_, 1);
     const uint32_t length = htonl(frame.length_);
     temp.add(&length, 4);
     if (frame.length_ > 0) {
-      temp.add(*frame.data_);
+      temp.move(*frame.data_);
     }
-    data.add(Base64::encode(temp, temp.length()));
+    Base64::encode(temp, temp.length(), data);
   }
   return Http::FilterDataStatus::Continue;
 }
@@ -186,27 +171,47 @@ Http::FilterTrailersStatus GrpcWebFilter::encodeTrailers(Http::HeaderMap& traile
   }
 
   // Trailers are expected to come all in once, and will be encoded into one single trailers frame.
-  // Trailers in the trailers frame are separated by CRLFs.
-  Buffer::OwnedImpl temp;
+  // Trailers in the trailers frame are separated by CRLFs. The frame is sized first, so that it is
+  // written at once into space reserved in the buffer.
+  uint64_t frame_length = 0;
   trailers.iterate(
       [](const Http::HeaderEntry& header, void* context) -> Http::HeaderMap::Iterate {
-        Buffer::Instance* temp = static_cast<Buffer::Instance*>(context);
-        temp->add(header.key().c_str(), header.key().size());
-        temp->add(":");
-        temp->add(header.value().c_str(), header.value().size());
-        temp->add("\r\n");
+        *static_cast<uint64_t*>(context) += header.key().size() + header.value().size() + 3;
         return Http::HeaderMap::Iterate::Continue;
       },
-      &temp);
+      &frame_length);
+
   Buffer::OwnedImpl buffer;
+  Buffer::RawSlice slice;
+  buffer.reserve(frame_length + 5, &slice, 1);
+  ASSERT(slice.len_ >= frame_length + 5);
+  char* current = static_cast<char*>(slice.mem_);
   // Adds the trailers frame head.
-  buffer.add(&GRPC_WEB_TRAILER, 1);
+  *current++ = GRPC_WEB_TRAILER;
   // Adds the trailers frame length.
-  const uint32_t length = htonl(temp.length());
-  buffer.add(&length, 4);
-  buffer.move(temp);
+  const uint32_t length = htonl(frame_length);
+  memcpy(current, &length, 4);
+  current += 4;
+  trailers.iterate(
+      [](const Http::HeaderEntry& header, void* context) -> Http::HeaderMap::Iterate {
+        char*& current = *static_cast<char**>(context);
+        memcpy(current, header.key().c_str(), header.key().size());
+        current += header.key().size();
+        *current++ = ':';
+        memcpy(current, header.value().c_str(), header.value().size());
+        current += header.value().size();
+        *current++ = '\r';
+        *current++ = '\n';
+        return Http::HeaderMap::Iterate::Continue;
+      },
+      &current);
+  ASSERT(current == static_cast<char*>(slice.mem_) + frame_length + 5);
+  slice.len_ = frame_length + 5;
+  buffer.commit(&slice, 1);
+
   if (is_text_response_) {
-    Buffer::OwnedImpl encoded(Base64::encode(buffer, buffer.length()));
+    Buffer::OwnedImpl encoded;
+    Base64::encode(buffer, buffer.length(), encoded);
     encoder_callbacks_->addEncodedData(encoded, true);
   } else {
     encoder_callbacks_->addEncodedData(buffer, true);
@@ -26,6 +26,9 @@ const uint64_t MinimumContentLength = 30;
 // When summed to window bits, this sets a gzip header and trailer around the compressed data.
 const uint64_t GzipHeaderValue = 16;
 
+// Maximum number of idle compressors kept by each worker.
+const uint64_t MaxIdleCompressors = 16;
+
 // Used for verifying accept-encoding values.
 const char ZeroQvalueString[] = "q=0";
 
@@ -41,7 +44,7 @@ const std::vector<std::string>& defaultContentEncoding() {
 
 GzipFilterConfig::GzipFilterConfig(const envoy::config::filter::http::gzip::v2::Gzip& gzip,
                                    const std::string& stats_prefix, Stats::Scope& scope,
-                                   Runtime::Loader& runtime)
+                                   Runtime::Loader& runtime, ThreadLocal::SlotAllocator& tls)
     : compression_level_(compressionLevelEnum(gzip.compression_level())),
       compression_strategy_(compressionStrategyEnum(gzip.compression_strategy())),
       content_length_(contentLengthUint(gzip.content_length().value())),
@@ -50,7 +53,41 @@ GzipFilterConfig::GzipFilterConfig(const envoy::config::filter::http::gzip::v2::
       content_type_values_(contentTypeSet(gzip.content_type())),
       disable_on_etag_header_(gzip.disable_on_etag_header()),
       remove_accept_encoding_header_(gzip.remove_accept_encoding_header()),
-      stats_(generateStats(stats_prefix + "gzip.", scope)), runtime_(runtime) {}
+      stats_(generateStats(stats_prefix + "gzip.", scope)), runtime_(runtime),
+      tls_(tls.allocateSlot()) {
+  tls_->set([](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<ThreadLocalCompressorPool>();
+  });
+}
+
+Compressor::ZlibCompressorImplPtr GzipFilterConfig::acquireCompressor() {
+  Compressor::ZlibCompressorImpl::CompressionLevel level = compression_level_;
+  if (runtime_.snapshot().featureEnabled("gzip.reduce_compression_level", 0)) {
+    level = Compressor::ZlibCompressorImpl::CompressionLevel::Speed;
+    stats_.reduced_compression_level_.inc();
+  }
+
+  auto& idle_compressors = tls_->getTyped<ThreadLocalCompressorPool>().idle_compressors_;
+  if (idle_compressors.empty()) {
+    auto compressor = std::make_unique<Compressor::ZlibCompressorImpl>();
+    compressor->init(level, compression_strategy_, window_bits_, memory_level_);
+    return compressor;
+  }
+
+  Compressor::ZlibCompressorImplPtr compressor = std::move(idle_compressors.back());
+  idle_compressors.pop_back();
+  // The level of a compressor reused may have been lowered for its previous stream.
+  compressor->setCompressionLevel(level);
+  return compressor;
+}
+
+void GzipFilterConfig::releaseCompressor(Compressor::ZlibCompressorImplPtr&& compressor) {
+  auto& idle_compressors = tls_->getTyped<ThreadLocalCompressorPool>().idle_compressors_;
+  if (idle_compressors.size() < MaxIdleCompressors) {
+    compressor->reset();
+    idle_compressors.push_back(std::move(compressor));
+  }
+}
 
 Compressor::ZlibCompressorImpl::CompressionLevel GzipFilterConfig::compressionLevelEnum(
     envoy::config::filter::http::gzip::v2::Gzip_CompressionLevel_Enum compression_level) {
@@ -105,6 +142,12 @@ uint64_t GzipFilterConfig::windowBitsUint(Protobuf::uint32 window_bits) {
 GzipFilter::GzipFilter(const GzipFilterConfigSharedPtr& config)
     : skip_compression_{true}, compressed_data_(), compressor_(), config_(config) {}
 
+void GzipFilter::onDestroy() {
+  if (compressor_ != nullptr) {
+    config_->releaseCompressor(std::move(compressor_));
+  }
+}
+
 Http::FilterHeadersStatus GzipFilter::decodeHeaders(Http::HeaderMap& headers, bool) {
   if (config_->runtime().snapshot().featureEnabled("gzip.filter_enabled", 100) &&
       isAcceptEncodingAllowed(headers)) {
@@ -127,8 +170,7 @@ Http::FilterHeadersStatus GzipFilter::encodeHeaders(Http::HeaderMap& headers, bo
     insertVaryHeader(headers);
     headers.removeContentLength();
     headers.insertContentEncoding().value(Http::Headers::get().ContentEncodingValues.Gzip);
-    compressor_.init(config_->compressionLevel(), config_->compressionStrategy(),
-                     config_->windowBits(), config_->memoryLevel());
+    compressor_ = config_->acquireCompressor();
     config_->stats().compressed_.inc();
   } else if (!skip_compression_) {
     skip_compression_ = true;
@@ -140,7 +182,7 @@ Http::FilterHeadersStatus GzipFilter::encodeHeaders(Http::HeaderMap& headers, bo
 Http::FilterDataStatus GzipFilter::encodeData(Buffer::Instance& data, bool end_stream) {
   if (!skip_compression_) {
     config_->stats().total_uncompressed_bytes_.add(data.length());
-    compressor_.compress(data, end_stream ? Compressor::State::Finish : Compressor::State::Flush);
+    compressor_->compress(data, end_stream ? Compressor::State::Finish : Compressor::State::Flush);
     config_->stats().total_compressed_bytes_.add(data.length());
   }
   return Http::FilterDataStatus::Continue;
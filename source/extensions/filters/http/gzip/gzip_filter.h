@@ -7,6 +7,7 @@
 #include "envoy/runtime/runtime.h"
 #include "envoy/stats/scope.h"
 #include "envoy/stats/stats_macros.h"
+#include "envoy/thread_local/thread_local.h"
 
 #include "common/buffer/buffer_impl.h"
 #include "common/compressor/zlib_compressor_impl.h"
@@ -43,6 +44,7 @@ namespace Gzip {
   COUNTER(total_compressed_bytes)  \
   COUNTER(content_length_too_small)\
   COUNTER(not_compressed_etag)     \
+  COUNTER(reduced_compression_level)\
 // clang-format on
 
 /**
@@ -60,7 +62,22 @@ class GzipFilterConfig {
 public:
   GzipFilterConfig(const envoy::config::filter::http::gzip::v2::Gzip& gzip,
                    const std::string& stats_prefix,
-                   Stats::Scope& scope, Runtime::Loader& runtime);
+                   Stats::Scope& scope, Runtime::Loader& runtime,
+                   ThreadLocal::SlotAllocator& tls);
+
+  /**
+   * Returns a compressor initialized with the configured parameters, reusing one released on this
+   * worker when possible. The compression level is lowered to the fastest one for the percentage
+   * of the streams given by the gzip.reduce_compression_level runtime key.
+   * @return Compressor::ZlibCompressorImplPtr the compressor.
+   */
+  Compressor::ZlibCompressorImplPtr acquireCompressor();
+
+  /**
+   * Returns a compressor to the pool of this worker once its stream is done with it.
+   * @param compressor supplies the compressor.
+   */
+  void releaseCompressor(Compressor::ZlibCompressorImplPtr&& compressor);
 
   Compressor::ZlibCompressorImpl::CompressionLevel compressionLevel() const {
     return compression_level_;
@@ -79,6 +96,12 @@ public:
   uint64_t windowBits() const { return window_bits_; }
 
 private:
+  // The compressors of a worker which are not compressing any stream, kept to avoid allocating and
+  // initializing the state of zlib for every stream.
+  struct ThreadLocalCompressorPool : public ThreadLocal::ThreadLocalObject {
+    std::vector<Compressor::ZlibCompressorImplPtr> idle_compressors_;
+  };
+
   static Compressor::ZlibCompressorImpl::CompressionLevel compressionLevelEnum(
       envoy::config::filter::http::gzip::v2::Gzip_CompressionLevel_Enum compression_level);
   static Compressor::ZlibCompressorImpl::CompressionStrategy compressionStrategyEnum(
@@ -106,6 +129,7 @@ private:
   bool remove_accept_encoding_header_;
   GzipStats stats_;
   Runtime::Loader& runtime_;
+  ThreadLocal::SlotPtr tls_;
 };
 typedef std::shared_ptr<GzipFilterConfig> GzipFilterConfigSharedPtr;
 
@@ -117,7 +141,7 @@ public:
   GzipFilter(const GzipFilterConfigSharedPtr& config);
 
   // Http::StreamFilterBase
-  void onDestroy() override{};
+  void onDestroy() override;
 
   // Http::StreamDecoderFilter
   Http::FilterHeadersStatus decodeHeaders(Http::HeaderMap& headers, bool end_stream) override;
@@ -161,7 +185,7 @@ private:
 
   bool skip_compression_;
   Buffer::OwnedImpl compressed_data_;
-  Compressor::ZlibCompressorImpl compressor_;
+  Compressor::ZlibCompressorImplPtr compressor_;
   GzipFilterConfigSharedPtr config_;
 
   Http::StreamDecoderFilterCallbacks* decoder_callbacks_{nullptr};
@@ -1,7 +1,16 @@
 #include "extensions/filters/http/ip_tagging/ip_tagging_filter.h"
 
+#include <netinet/in.h>
+
+#include <cstring>
+
+#include "common/common/fmt.h"
+#include "common/config/datasource.h"
 #include "common/http/header_map_impl.h"
 #include "common/http/headers.h"
+#include "common/network/address_impl.h"
+
+#include "extensions/filters/http/well_known_names.h"
 
 #include "absl/strings/str_join.h"
 
@@ -10,6 +19,145 @@ namespace Extensions {
 namespace HttpFilters {
 namespace IpTagging {
 
+namespace {
+
+const char DatabaseMagic[] = "ENVOYIPT";
+const uint32_t DatabaseVersion = 1;
+
+/**
+ * Reads the fields of an IP tags database, in network byte order.
+ */
+class DatabaseReader {
+public:
+  DatabaseReader(const std::string& data) : data_(data) {}
+
+  const char* readBytes(size_t size) {
+    if (data_.size() - offset_ < size) {
+      throw EnvoyException("ip_tags_database is truncated");
+    }
+    const char* bytes = data_.data() + offset_;
+    offset_ += size;
+    return bytes;
+  }
+
+  uint64_t readInteger(size_t size) {
+    const char* bytes = readBytes(size);
+    uint64_t value = 0;
+    for (size_t i = 0; i < size; i++) {
+      value = (value << 8) | static_cast<uint8_t>(bytes[i]);
+    }
+    return value;
+  }
+
+  bool done() const { return offset_ == data_.size(); }
+
+private:
+  const std::string& data_;
+  size_t offset_{};
+};
+
+} // namespace
+
+IpTaggingFilterConfig::IpTaggingFilterConfig(
+    const envoy::config::filter::http::ip_tagging::v2::IPTagging& config,
+    const std::string& stat_prefix, Stats::Scope& scope, Runtime::Loader& runtime)
+    : request_type_(requestTypeEnum(config.request_type())), scope_(scope), runtime_(runtime),
+      stats_prefix_(stat_prefix + "ip_tagging.") {
+  if (config.ip_tags().empty() && !config.has_ip_tags_database()) {
+    throw EnvoyException(
+        "HTTP IP Tagging Filter requires ip_tags or ip_tags_database to be specified.");
+  }
+
+  TagData tag_data;
+  for (const auto& ip_tag : config.ip_tags()) {
+    std::vector<Network::Address::CidrRange> cidr_set;
+    for (const envoy::api::v2::core::CidrRange& entry : ip_tag.ip_list()) {
+
+      // Currently, CidrRange::create doesn't guarantee that the CidrRanges are valid.
+      Network::Address::CidrRange cidr_entry = Network::Address::CidrRange::create(entry);
+      if (cidr_entry.isValid()) {
+        cidr_set.emplace_back(cidr_entry);
+      } else {
+        throw EnvoyException(
+            fmt::format("invalid ip/mask combo '{}/{}' (format is <ip>/<# mask bits>)",
+                        entry.address_prefix(), entry.prefix_len().value()));
+      }
+    }
+    tag_data.emplace_back(tagId(ip_tag.ip_tag_name()), std::move(cidr_set));
+  }
+  if (config.has_ip_tags_database()) {
+    parseDatabase(Config::DataSource::read(config.ip_tags_database(), false), tag_data);
+  }
+  trie_ = std::make_unique<Network::LcTrie::LcTrie<uint32_t>>(tag_data);
+}
+
+uint32_t IpTaggingFilterConfig::tagId(const std::string& tag_name) {
+  auto result = tag_ids_.emplace(tag_name, tag_names_.size());
+  if (result.second) {
+    tag_names_.push_back(tag_name);
+  }
+  return result.first->second;
+}
+
+void IpTaggingFilterConfig::parseDatabase(const std::string& database, TagData& tag_data) {
+  DatabaseReader reader(database);
+  if (memcmp(reader.readBytes(sizeof(DatabaseMagic) - 1), DatabaseMagic,
+             sizeof(DatabaseMagic) - 1) != 0) {
+    throw EnvoyException("ip_tags_database is not an IP tags database");
+  }
+  const uint32_t version = reader.readInteger(4);
+  if (version != DatabaseVersion) {
+    throw EnvoyException(fmt::format("ip_tags_database has unsupported version {}", version));
+  }
+
+  // The prefixes of each tag of the database are appended to tag_data at the offset of its index.
+  const size_t first_tag = tag_data.size();
+  const uint32_t num_tags = reader.readInteger(4);
+  for (uint32_t i = 0; i < num_tags; i++) {
+    const size_t name_length = reader.readInteger(2);
+    tag_data.emplace_back(tagId(std::string(reader.readBytes(name_length), name_length)),
+                          std::vector<Network::Address::CidrRange>());
+  }
+
+  const uint32_t num_prefixes = reader.readInteger(4);
+  for (uint32_t i = 0; i < num_prefixes; i++) {
+    const uint32_t tag_index = reader.readInteger(4);
+    const int prefix_length = reader.readInteger(1);
+    const size_t address_length = reader.readInteger(1);
+    if (tag_index >= num_tags) {
+      throw EnvoyException(fmt::format("ip_tags_database has an invalid tag index {}", tag_index));
+    }
+
+    Network::Address::InstanceConstSharedPtr address;
+    if (address_length == 4) {
+      sockaddr_in ipv4{};
+      ipv4.sin_family = AF_INET;
+      memcpy(&ipv4.sin_addr, reader.readBytes(address_length), address_length);
+      address = std::make_shared<Network::Address::Ipv4Instance>(&ipv4);
+    } else if (address_length == 16) {
+      sockaddr_in6 ipv6{};
+      ipv6.sin6_family = AF_INET6;
+      memcpy(&ipv6.sin6_addr, reader.readBytes(address_length), address_length);
+      address = std::make_shared<Network::Address::Ipv6Instance>(ipv6);
+    } else {
+      throw EnvoyException(
+          fmt::format("ip_tags_database has an invalid address length {}", address_length));
+    }
+
+    // CidrRange::create() would clamp the length to the address size.
+    if (prefix_length > static_cast<int>(address_length * 8)) {
+      throw EnvoyException(fmt::format("ip_tags_database has an invalid prefix '{}/{}'",
+                                       address->ip()->addressAsString(), prefix_length));
+    }
+    tag_data[first_tag + tag_index].second.emplace_back(
+        Network::Address::CidrRange::create(address, prefix_length));
+  }
+
+  if (!reader.done()) {
+    throw EnvoyException("ip_tags_database has trailing data");
+  }
+}
+
 IpTaggingFilter::IpTaggingFilter(IpTaggingFilterConfigSharedPtr config) : config_(config) {}
 
 IpTaggingFilter::~IpTaggingFilter() {}
@@ -27,12 +175,23 @@ Http::FilterHeadersStatus IpTaggingFilter::decodeHeaders(Http::HeaderMap& header
     return Http::FilterHeadersStatus::Continue;
   }
 
-  std::vector<std::string> tags =
+  const std::vector<uint32_t> tag_ids =
       config_->trie().getData(callbacks_->requestInfo().downstreamRemoteAddress());
 
-  if (!tags.empty()) {
+  if (!tag_ids.empty()) {
+    std::vector<absl::string_view> tags;
+    tags.reserve(tag_ids.size());
+    ProtobufWkt::Struct metadata;
+    ProtobufWkt::ListValue& tag_list = *(*metadata.mutable_fields())["tags"].mutable_list_value();
+    for (const uint32_t tag_id : tag_ids) {
+      tags.push_back(config_->tagName(tag_id));
+      tag_list.add_values()->set_string_value(config_->tagName(tag_id));
+    }
+
     const std::string tags_join = absl::StrJoin(tags, ",");
     Http::HeaderMapImpl::appendToHeader(headers.insertEnvoyIpTags().value(), tags_join);
+    // Expose the tags to the filters and access logs that follow, without parsing the header.
+    callbacks_->requestInfo().setDynamicMetadata(HttpFilterNames::get().IpTagging, metadata);
 
     // We must clear the route cache or else we can't match on x-envoy-ip-tags.
     // TODO(rgs): this should either be configurable, because it's expensive, or optimized.
@@ -41,7 +200,7 @@ Http::FilterHeadersStatus IpTaggingFilter::decodeHeaders(Http::HeaderMap& header
     // For a large number(ex > 1000) of tags, stats cardinality will be an issue.
     // If there are use cases with a large set of tags, a way to opt into these stats
     // should be exposed and other observability options like logging tags need to be implemented.
-    for (const std::string& tag : tags) {
+    for (const absl::string_view tag : tags) {
       config_->scope().counter(fmt::format("{}{}.hit", config_->statsPrefix(), tag)).inc();
     }
   } else {
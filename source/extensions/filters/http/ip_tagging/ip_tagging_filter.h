@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "envoy/common/exception.h"
@@ -31,52 +32,21 @@ class IpTaggingFilterConfig {
 public:
   IpTaggingFilterConfig(const envoy::config::filter::http::ip_tagging::v2::IPTagging& config,
                         const std::string& stat_prefix, Stats::Scope& scope,
-                        Runtime::Loader& runtime)
-      : request_type_(requestTypeEnum(config.request_type())), scope_(scope), runtime_(runtime),
-        stats_prefix_(stat_prefix + "ip_tagging.") {
-
-    // Once loading IP tags from a file system is supported, the restriction on the size
-    // of the set should be removed and observability into what tags are loaded needs
-    // to be implemented.
-    // TODO(ccaraman): Remove size check once file system support is implemented.
-    // Work is tracked by issue https://github.com/envoyproxy/envoy/issues/2695.
-    if (config.ip_tags().empty()) {
-      throw EnvoyException("HTTP IP Tagging Filter requires ip_tags to be specified.");
-    }
-
-    // TODO(ccaraman): Reduce the amount of copies operations performed to build the
-    // IP tag data set and passing it to the LcTrie constructor.
-    std::vector<std::pair<std::string, std::vector<Network::Address::CidrRange>>> tag_data;
-    for (const auto& ip_tag : config.ip_tags()) {
-      std::pair<std::string, std::vector<Network::Address::CidrRange>> ip_tag_pair;
-      ip_tag_pair.first = ip_tag.ip_tag_name();
-
-      std::vector<Network::Address::CidrRange> cidr_set;
-      for (const envoy::api::v2::core::CidrRange& entry : ip_tag.ip_list()) {
-
-        // Currently, CidrRange::create doesn't guarantee that the CidrRanges are valid.
-        Network::Address::CidrRange cidr_entry = Network::Address::CidrRange::create(entry);
-        if (cidr_entry.isValid()) {
-          cidr_set.emplace_back(cidr_entry);
-        } else {
-          throw EnvoyException(
-              fmt::format("invalid ip/mask combo '{}/{}' (format is <ip>/<# mask bits>)",
-                          entry.address_prefix(), entry.prefix_len().value()));
-        }
-      }
-      ip_tag_pair.second = cidr_set;
-      tag_data.emplace_back(ip_tag_pair);
-    }
-    trie_.reset(new Network::LcTrie::LcTrie<std::string>(tag_data));
-  }
+                        Runtime::Loader& runtime);
 
   Runtime::Loader& runtime() { return runtime_; }
   Stats::Scope& scope() { return scope_; }
   FilterRequestType requestType() const { return request_type_; }
-  const Network::LcTrie::LcTrie<std::string>& trie() const { return *trie_; }
+  const Network::LcTrie::LcTrie<uint32_t>& trie() const { return *trie_; }
+  const std::string& tagName(uint32_t tag_id) const { return tag_names_[tag_id]; }
   const std::string& statsPrefix() const { return stats_prefix_; }
 
 private:
+  typedef std::vector<std::pair<uint32_t, std::vector<Network::Address::CidrRange>>> TagData;
+
+  uint32_t tagId(const std::string& tag_name);
+  void parseDatabase(const std::string& database, TagData& tag_data);
+
   static FilterRequestType requestTypeEnum(
       envoy::config::filter::http::ip_tagging::v2::IPTagging::RequestType request_type) {
     switch (request_type) {
@@ -95,7 +65,11 @@ private:
   Stats::Scope& scope_;
   Runtime::Loader& runtime_;
   const std::string stats_prefix_;
-  std::unique_ptr<Network::LcTrie::LcTrie<std::string>> trie_;
+  // The trie holds tag ids rather than names, so that each name is only stored once however many
+  // prefixes it applies to.
+  std::vector<std::string> tag_names_;
+  std::unordered_map<std::string, uint32_t> tag_ids_;
+  std::unique_ptr<Network::LcTrie::LcTrie<uint32_t>> trie_;
 };
 
 typedef std::shared_ptr<IpTaggingFilterConfig> IpTaggingFilterConfigSharedPtr;
@@ -58,8 +58,10 @@ private:
 
   // The token data
   JwtLocationConstPtr token_;
-  // The JWT object.
-  ::google::jwt_verify::Jwt jwt_;
+  // The JWT object, which is shared with the token cache.
+  JwtConstSharedPtr jwt_;
+  // Whether the signature of the JWT was verified when it was cached.
+  bool verified_{};
   // The JWKS data object
   JwksCache::JwksData* jwks_data_{};
 
@@ -102,37 +104,49 @@ void AuthenticatorImpl::verify(Http::HeaderMap& headers, Authenticator::Callback
   // Only process the first token for now.
   token_.swap(tokens[0]);
 
-  const Status status = jwt_.parseFromString(token_->token());
-  if (status != Status::Ok) {
-    doneWithStatus(status);
-    return;
+  const auto unix_timestamp = std::chrono::duration_cast<std::chrono::seconds>(
+                                  std::chrono::system_clock::now().time_since_epoch())
+                                  .count();
+
+  // A token whose signature was verified before is neither parsed nor verified again. The other
+  // checks still apply, since they depend on the location of the token and on the time.
+  jwt_ = config_->getCache().getTokenCache().find(token_->token(), unix_timestamp);
+  verified_ = jwt_ != nullptr;
+  if (verified_) {
+    config_->stats().token_cache_hit_.inc();
+  } else {
+    auto jwt = std::make_shared<::google::jwt_verify::Jwt>();
+    const Status status = jwt->parseFromString(token_->token());
+    if (status != Status::Ok) {
+      doneWithStatus(status);
+      return;
+    }
+    jwt_ = jwt;
   }
 
   // Check if token is extracted from the location specified by the issuer.
-  if (!token_->isIssuerSpecified(jwt_.iss_)) {
-    ENVOY_LOG(debug, "Jwt for issuer {} is not extracted from the specified locations", jwt_.iss_);
+  if (!token_->isIssuerSpecified(jwt_->iss_)) {
+    ENVOY_LOG(debug, "Jwt for issuer {} is not extracted from the specified locations",
+              jwt_->iss_);
     doneWithStatus(Status::JwtUnknownIssuer);
     return;
   }
 
   // Check "exp" claim.
-  const auto unix_timestamp = std::chrono::duration_cast<std::chrono::seconds>(
-                                  std::chrono::system_clock::now().time_since_epoch())
-                                  .count();
   // NOTE: Service account tokens generally don't have an expiration time (due to being long lived)
   // and defaulted to 0 by google::jwt_verify library but are still valid.
-  if (jwt_.exp_ > 0 && jwt_.exp_ < unix_timestamp) {
+  if (jwt_->exp_ > 0 && jwt_->exp_ < unix_timestamp) {
     doneWithStatus(Status::JwtExpired);
     return;
   }
 
   // Check the issuer is configured or not.
-  jwks_data_ = config_->getCache().getJwksCache().findByIssuer(jwt_.iss_);
+  jwks_data_ = config_->getCache().getJwksCache().findByIssuer(jwt_->iss_);
   // isIssuerSpecified() check already make sure the issuer is in the cache.
   ASSERT(jwks_data_ != nullptr);
 
   // Check if audience is allowed
-  if (!jwks_data_->areAudiencesAllowed(jwt_.audiences_)) {
+  if (!jwks_data_->areAudiencesAllowed(jwt_->audiences_)) {
     doneWithStatus(Status::JwtAudienceNotAllowed);
     return;
   }
@@ -208,23 +222,29 @@ void AuthenticatorImpl::onFetchRemoteJwksDone(const std::string& jwks_str) {
   if (status != Status::Ok) {
     doneWithStatus(status);
   } else {
+    // The tokens cached were verified with the previous keys, which may have been revoked.
+    config_->getCache().getTokenCache().clear();
+    verified_ = false;
     verifyKey();
   }
 }
 
 // Verify with a specific public key.
 void AuthenticatorImpl::verifyKey() {
-  const Status status = ::google::jwt_verify::verifyJwt(jwt_, *jwks_data_->getJwksObj());
-  if (status != Status::Ok) {
-    doneWithStatus(status);
-    return;
+  if (!verified_) {
+    const Status status = ::google::jwt_verify::verifyJwt(*jwt_, *jwks_data_->getJwksObj());
+    if (status != Status::Ok) {
+      doneWithStatus(status);
+      return;
+    }
+    config_->getCache().getTokenCache().insert(token_->token(), jwt_);
   }
 
   // Forward the payload
   const auto& provider = jwks_data_->getJwtProvider();
   if (!provider.forward_payload_header().empty()) {
     headers_->addCopy(Http::LowerCaseString(provider.forward_payload_header()),
-                      jwt_.payload_str_base64url_);
+                      jwt_->payload_str_base64url_);
   }
 
   if (!provider.forward()) {
@@ -6,9 +6,12 @@
 #include "envoy/thread_local/thread_local.h"
 
 #include "common/common/logger.h"
+#include "common/protobuf/utility.h"
 
 #include "extensions/filters/http/jwt_authn/extractor.h"
+#include "extensions/filters/http/jwt_authn/jwks_async_fetcher.h"
 #include "extensions/filters/http/jwt_authn/jwks_cache.h"
+#include "extensions/filters/http/jwt_authn/token_cache.h"
 
 namespace Envoy {
 namespace Extensions {
@@ -17,8 +20,7 @@ namespace JwtAuthn {
 
 /**
  * Making cache as a thread local object, its read/write operations don't need to be protected.
- * Now it only has jwks_cache, but in the future, it will have token cache: to cache the tokens
- * with their verification results.
+ * It has the jwks_cache and the token cache of the tokens with a verified signature.
  */
 class ThreadLocalCache : public ThreadLocal::ThreadLocalObject {
 public:
@@ -26,14 +28,33 @@ public:
   ThreadLocalCache(
       const ::envoy::config::filter::http::jwt_authn::v2alpha::JwtAuthentication& config) {
     jwks_cache_ = JwksCache::create(config);
+    token_cache_ = std::make_unique<TokenCache>(
+        PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, token_cache_size, DefaultTokenCacheSize));
   }
 
   // Get the JwksCache object.
   JwksCache& getJwksCache() { return *jwks_cache_; }
 
+  // Get the TokenCache object.
+  TokenCache& getTokenCache() { return *token_cache_; }
+
+  // Set the Jwks of an issuer fetched in the background.
+  void setRemoteJwks(const std::string& issuer, JwksConstSharedPtr jwks) {
+    JwksCache::JwksData* jwks_data = jwks_cache_->findByIssuer(issuer);
+    ASSERT(jwks_data != nullptr);
+    jwks_data->setRemoteJwks(std::move(jwks));
+    // The tokens cached were verified with the previous keys, which may have been revoked.
+    token_cache_->clear();
+  }
+
 private:
+  // The default number of tokens cached by each worker.
+  static const uint64_t DefaultTokenCacheSize = 100;
+
   // The JwksCache object.
   JwksCachePtr jwks_cache_;
+  // The TokenCache object.
+  TokenCachePtr token_cache_;
 };
 
 /**
@@ -43,7 +64,10 @@ private:
 // clang-format off
 #define ALL_JWT_AUTHN_FILTER_STATS(COUNTER)                                                        \
   COUNTER(allowed)                                                                                 \
-  COUNTER(denied)
+  COUNTER(denied)                                                                                  \
+  COUNTER(token_cache_hit)                                                                         \
+  COUNTER(jwks_fetch_success)                                                                      \
+  COUNTER(jwks_fetch_failed)
 // clang-format on
 
 /**
@@ -68,6 +92,16 @@ public:
       return std::make_shared<ThreadLocalCache>(proto_config_);
     });
     extractor_ = Extractor::create(proto_config_);
+
+    for (const auto& it : proto_config_.providers()) {
+      const auto& provider = it.second;
+      if (provider.has_remote_jwks() && provider.remote_jwks().async_fetch()) {
+        const std::string issuer = provider.issuer();
+        jwks_fetchers_.emplace_back(new JwksAsyncFetcher(
+            provider.remote_jwks(), cm_, context.dispatcher(),
+            [this, issuer](JwksConstSharedPtr jwks) -> void { onJwksFetched(issuer, jwks); }));
+      }
+    }
   }
 
   JwtAuthnFilterStats& stats() { return stats_; }
@@ -87,6 +121,18 @@ public:
   const Extractor& getExtractor() const { return *extractor_; }
 
 private:
+  // Distribute a Jwks fetched in the background to the workers.
+  void onJwksFetched(const std::string& issuer, JwksConstSharedPtr jwks) {
+    if (jwks == nullptr) {
+      stats_.jwks_fetch_failed_.inc();
+      return;
+    }
+    stats_.jwks_fetch_success_.inc();
+    tls_->runOnAllThreads([this, issuer, jwks]() -> void {
+      tls_->getTyped<ThreadLocalCache>().setRemoteJwks(issuer, jwks);
+    });
+  }
+
   JwtAuthnFilterStats generateStats(const std::string& prefix, Stats::Scope& scope) {
     const std::string final_prefix = prefix + "jwt_authn.";
     return {ALL_JWT_AUTHN_FILTER_STATS(POOL_COUNTER_PREFIX(scope, final_prefix))};
@@ -102,6 +148,8 @@ private:
   Upstream::ClusterManager& cm_;
   // The object to extract tokens.
   ExtractorConstPtr extractor_;
+  // The fetchers of the remote Jwks fetched in the background.
+  std::vector<JwksAsyncFetcherPtr> jwks_fetchers_;
 };
 typedef std::shared_ptr<FilterConfig> FilterConfigSharedPtr;
 
@@ -0,0 +1,98 @@
+#include "extensions/filters/http/jwt_authn/jwks_async_fetcher.h"
+
+#include "common/common/enum_to_int.h"
+#include "common/http/headers.h"
+#include "common/http/utility.h"
+#include "common/protobuf/utility.h"
+
+using ::google::jwt_verify::Jwks;
+using ::google::jwt_verify::Status;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace JwtAuthn {
+namespace {
+
+// Default refresh interval, which is the default cache duration of a remote JWKS.
+constexpr std::chrono::seconds DefaultRefreshInterval(600);
+
+// Interval after which a failed fetch is retried.
+constexpr std::chrono::seconds FailedFetchRetryInterval(1);
+
+} // namespace
+
+JwksAsyncFetcher::JwksAsyncFetcher(
+    const ::envoy::config::filter::http::jwt_authn::v2alpha::RemoteJwks& remote_jwks,
+    Upstream::ClusterManager& cm, Event::Dispatcher& dispatcher, JwksFetchedCb fetched_cb)
+    : remote_jwks_(remote_jwks), cm_(cm), fetched_cb_(fetched_cb),
+      refresh_interval_(
+          remote_jwks.has_cache_duration()
+              ? std::chrono::milliseconds(
+                    DurationUtil::durationToMilliseconds(remote_jwks.cache_duration()))
+              : DefaultRefreshInterval),
+      refresh_timer_(dispatcher.createTimer([this]() -> void { fetch(); })) {
+  // The first fetch waits for the event loop, once the clusters are created.
+  refresh_timer_->enableTimer(std::chrono::milliseconds(0));
+}
+
+JwksAsyncFetcher::~JwksAsyncFetcher() {
+  if (request_ != nullptr) {
+    request_->cancel();
+  }
+}
+
+void JwksAsyncFetcher::fetch() {
+  const auto& http_uri = remote_jwks_.http_uri();
+  if (cm_.get(http_uri.cluster()) == nullptr) {
+    ENVOY_LOG(debug, "fetch pubkey from [uri = {}]: unknown cluster", http_uri.uri());
+    onFetchDone(nullptr);
+    return;
+  }
+
+  ENVOY_LOG(debug, "fetch pubkey from [uri = {}] in background: start", http_uri.uri());
+  Http::MessagePtr message = Http::Utility::prepareHeaders(http_uri);
+  message->headers().insertMethod().value().setReference(Http::Headers::get().MethodValues.Get);
+  request_ = cm_.httpAsyncClientForCluster(http_uri.cluster())
+                 .send(std::move(message), *this,
+                       std::chrono::milliseconds(
+                           DurationUtil::durationToMilliseconds(http_uri.timeout())));
+}
+
+void JwksAsyncFetcher::onSuccess(Http::MessagePtr&& response) {
+  request_ = nullptr;
+  const uint64_t status_code = Http::Utility::getResponseStatus(response->headers());
+  if (status_code != enumToInt(Http::Code::OK) || !response->body()) {
+    ENVOY_LOG(debug, "fetch pubkey [uri = {}]: response status code {}",
+              remote_jwks_.http_uri().uri(), status_code);
+    onFetchDone(nullptr);
+    return;
+  }
+
+  auto jwks = Jwks::createFrom(response->body()->toString(), Jwks::JWKS);
+  if (jwks->getStatus() != Status::Ok) {
+    ENVOY_LOG(debug, "fetch pubkey [uri = {}]: invalid jwks: {}", remote_jwks_.http_uri().uri(),
+              ::google::jwt_verify::getStatusString(jwks->getStatus()));
+    onFetchDone(nullptr);
+    return;
+  }
+  onFetchDone(std::move(jwks));
+}
+
+void JwksAsyncFetcher::onFailure(Http::AsyncClient::FailureReason) {
+  request_ = nullptr;
+  ENVOY_LOG(debug, "fetch pubkey [uri = {}]: failed", remote_jwks_.http_uri().uri());
+  onFetchDone(nullptr);
+}
+
+void JwksAsyncFetcher::onFetchDone(JwksConstSharedPtr jwks) {
+  refresh_timer_->enableTimer(jwks != nullptr
+                                  ? refresh_interval_
+                                  : std::chrono::milliseconds(FailedFetchRetryInterval));
+  fetched_cb_(std::move(jwks));
+}
+
+} // namespace JwtAuthn
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
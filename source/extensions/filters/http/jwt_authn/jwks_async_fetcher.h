@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+
+#include "envoy/config/filter/http/jwt_authn/v2alpha/config.pb.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/event/timer.h"
+#include "envoy/http/async_client.h"
+#include "envoy/upstream/cluster_manager.h"
+
+#include "common/common/logger.h"
+
+#include "extensions/filters/http/jwt_authn/jwks_cache.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace JwtAuthn {
+
+/**
+ * Fetches a remote JWKS from the main thread as soon as the main thread runs its event loop, then
+ * refreshes it every cache duration, so that the workers always have a JWKS to verify the tokens
+ * with rather than fetching it on the request path once it expires. A failed fetch is retried
+ * every second, while the workers keep using the previous JWKS.
+ */
+class JwksAsyncFetcher : public Logger::Loggable<Logger::Id::filter>,
+                         public Http::AsyncClient::Callbacks {
+public:
+  // Called with each JWKS fetched, or nullptr if the fetch failed.
+  typedef std::function<void(JwksConstSharedPtr jwks)> JwksFetchedCb;
+
+  JwksAsyncFetcher(const ::envoy::config::filter::http::jwt_authn::v2alpha::RemoteJwks& remote_jwks,
+                   Upstream::ClusterManager& cm, Event::Dispatcher& dispatcher,
+                   JwksFetchedCb fetched_cb);
+  ~JwksAsyncFetcher();
+
+  // Http::AsyncClient::Callbacks
+  void onSuccess(Http::MessagePtr&& response) override;
+  void onFailure(Http::AsyncClient::FailureReason reason) override;
+
+private:
+  void fetch();
+  void onFetchDone(JwksConstSharedPtr jwks);
+
+  const ::envoy::config::filter::http::jwt_authn::v2alpha::RemoteJwks& remote_jwks_;
+  Upstream::ClusterManager& cm_;
+  const JwksFetchedCb fetched_cb_;
+  const std::chrono::milliseconds refresh_interval_;
+  Event::TimerPtr refresh_timer_;
+  Http::AsyncClient::Request* request_{};
+};
+
+typedef std::unique_ptr<JwksAsyncFetcher> JwksAsyncFetcherPtr;
+
+} // namespace JwtAuthn
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -58,6 +58,11 @@ public:
     return setKey(jwks_str, getRemoteJwksExpirationTime());
   }
 
+  void setRemoteJwks(JwksConstSharedPtr jwks) override {
+    jwks_obj_ = std::move(jwks);
+    expiration_time_ = std::chrono::steady_clock::time_point::max();
+  }
+
 private:
   // Get the expiration time for a remote Jwks
   std::chrono::steady_clock::time_point getRemoteJwksExpirationTime() const {
@@ -87,7 +92,7 @@ private:
   // Check audience object
   ::google::jwt_verify::CheckAudiencePtr audiences_;
   // The generated jwks object.
-  ::google::jwt_verify::JwksPtr jwks_obj_;
+  JwksConstSharedPtr jwks_obj_;
   // The pubkey expiration time.
   std::chrono::steady_clock::time_point expiration_time_;
 };
@@ -13,6 +13,9 @@ namespace JwtAuthn {
 class JwksCache;
 typedef std::unique_ptr<JwksCache> JwksCachePtr;
 
+// A parsed Jwks is only read once created, so it can be shared by the workers.
+typedef std::shared_ptr<const ::google::jwt_verify::Jwks> JwksConstSharedPtr;
+
 /**
  * Interface to access all configured Jwt rules and their cached Jwks objects.
  * It only caches Jwks specified in the config.
@@ -55,6 +58,10 @@ public:
 
     // Set a remote Jwks string.
     virtual ::google::jwt_verify::Status setRemoteJwks(const std::string& jwks_str) PURE;
+
+    // Set a remote Jwks fetched in the background, which never expires since it is refreshed
+    // before its cache duration.
+    virtual void setRemoteJwks(JwksConstSharedPtr jwks) PURE;
   };
 
   // Lookup issuer cache map. The cache only stores Jwks specified in the config.
@@ -0,0 +1,48 @@
+#include "extensions/filters/http/jwt_authn/token_cache.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace JwtAuthn {
+
+JwtConstSharedPtr TokenCache::find(absl::string_view token, int64_t now) {
+  const auto it = map_.find(token);
+  if (it == map_.end()) {
+    return nullptr;
+  }
+
+  const EntryList::iterator entry = it->second;
+  const JwtConstSharedPtr jwt = entry->jwt_;
+  // Tokens without an expiration time don't expire.
+  if (jwt->exp_ > 0 && static_cast<int64_t>(jwt->exp_) < now) {
+    map_.erase(it);
+    entries_.erase(entry);
+    return nullptr;
+  }
+
+  entries_.splice(entries_.begin(), entries_, entry);
+  return jwt;
+}
+
+void TokenCache::insert(const std::string& token, const JwtConstSharedPtr& jwt) {
+  if (max_size_ == 0 || map_.find(token) != map_.end()) {
+    return;
+  }
+
+  if (map_.size() >= max_size_) {
+    map_.erase(entries_.back().token_);
+    entries_.pop_back();
+  }
+  entries_.emplace_front(token, jwt);
+  map_.emplace(entries_.front().token_, entries_.begin());
+}
+
+void TokenCache::clear() {
+  map_.clear();
+  entries_.clear();
+}
+
+} // namespace JwtAuthn
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "common/common/utility.h"
+
+#include "absl/strings/string_view.h"
+#include "jwt_verify_lib/jwt.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace JwtAuthn {
+
+typedef std::shared_ptr<const ::google::jwt_verify::Jwt> JwtConstSharedPtr;
+
+/**
+ * LRU cache of the tokens whose signature a worker verified, with their parsed JWT, so that the
+ * tokens sent again and again by the clients are neither parsed nor verified again. The cache is
+ * keyed by the whole token rather than by a hash of it, so that a token can never match the entry
+ * of another one. Tokens are evicted once expired.
+ */
+class TokenCache {
+public:
+  /**
+   * @param max_size supplies the maximum number of tokens cached. The cache is disabled when 0.
+   */
+  TokenCache(uint64_t max_size) : max_size_(max_size) {}
+
+  /**
+   * Looks up a verified token.
+   * @param token supplies the token.
+   * @param now supplies the current time in seconds since the epoch, to evict an expired token.
+   * @return JwtConstSharedPtr the JWT parsed from the token, or nullptr if it is not cached.
+   */
+  JwtConstSharedPtr find(absl::string_view token, int64_t now);
+
+  /**
+   * Caches a token whose signature was verified.
+   * @param token supplies the token.
+   * @param jwt supplies the JWT parsed from the token.
+   */
+  void insert(const std::string& token, const JwtConstSharedPtr& jwt);
+
+  /**
+   * Evicts all the tokens, i.e. once the keys which verified them change.
+   */
+  void clear();
+
+  uint64_t size() const { return map_.size(); }
+
+private:
+  struct Entry {
+    Entry(const std::string& token, const JwtConstSharedPtr& jwt) : token_(token), jwt_(jwt) {}
+
+    const std::string token_;
+    const JwtConstSharedPtr jwt_;
+  };
+  typedef std::list<Entry> EntryList;
+
+  const uint64_t max_size_;
+  // The entries from the most to the least recently used.
+  EntryList entries_;
+  // The entries are never moved by the list, so their tokens can key the map.
+  std::unordered_map<absl::string_view, EntryList::iterator, StringViewHash> map_;
+};
+
+typedef std::unique_ptr<TokenCache> TokenCachePtr;
+
+} // namespace JwtAuthn
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
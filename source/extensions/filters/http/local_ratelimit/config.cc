@@ -0,0 +1,36 @@
+#include "extensions/filters/http/local_ratelimit/config.h"
+
+#include <string>
+
+#include "envoy/config/filter/http/local_rate_limit/v2alpha/local_rate_limit.pb.validate.h"
+#include "envoy/registry/registry.h"
+
+#include "extensions/filters/http/local_ratelimit/local_ratelimit.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace LocalRateLimitFilter {
+
+Http::FilterFactoryCb LocalRateLimitFilterConfig::createFilterFactoryFromProtoTyped(
+    const envoy::config::filter::http::local_rate_limit::v2alpha::LocalRateLimit& proto_config,
+    const std::string& stats_prefix, Server::Configuration::FactoryContext& context) {
+  FilterConfigSharedPtr filter_config =
+      std::make_shared<FilterConfig>(proto_config, stats_prefix, context.scope(),
+                                     context.localInfo(), context.runtime(), context.timeSource());
+  return [filter_config](Http::FilterChainFactoryCallbacks& callbacks) -> void {
+    callbacks.addStreamDecoderFilter(std::make_shared<Filter>(filter_config));
+  };
+}
+
+/**
+ * Static registration for the local rate limit filter. @see RegisterFactory.
+ */
+static Registry::RegisterFactory<LocalRateLimitFilterConfig,
+                                 Server::Configuration::NamedHttpFilterConfigFactory>
+    register_;
+
+} // namespace LocalRateLimitFilter
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
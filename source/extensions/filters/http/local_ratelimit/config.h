@@ -0,0 +1,31 @@
+#pragma once
+
+#include "envoy/config/filter/http/local_rate_limit/v2alpha/local_rate_limit.pb.h"
+
+#include "extensions/filters/http/common/factory_base.h"
+#include "extensions/filters/http/well_known_names.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace LocalRateLimitFilter {
+
+/**
+ * Config registration for the local rate limit filter. @see NamedHttpFilterConfigFactory.
+ */
+class LocalRateLimitFilterConfig
+    : public Common::FactoryBase<
+          envoy::config::filter::http::local_rate_limit::v2alpha::LocalRateLimit> {
+public:
+  LocalRateLimitFilterConfig() : FactoryBase(HttpFilterNames::get().LocalRateLimit) {}
+
+private:
+  Http::FilterFactoryCb createFilterFactoryFromProtoTyped(
+      const envoy::config::filter::http::local_rate_limit::v2alpha::LocalRateLimit& proto_config,
+      const std::string& stats_prefix, Server::Configuration::FactoryContext& context) override;
+};
+
+} // namespace LocalRateLimitFilter
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,127 @@
+#include "extensions/filters/http/local_ratelimit/local_ratelimit.h"
+
+#include <string>
+#include <vector>
+
+#include "envoy/http/codes.h"
+
+#include "common/common/fmt.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace LocalRateLimitFilter {
+
+namespace {
+
+// The keys and the values of the entries of a descriptor, each followed by a '\0' which they can't
+// hold, so that distinct descriptors have distinct keys.
+void appendDescriptorEntry(std::string& key, const std::string& entry_key,
+                           const std::string& entry_value) {
+  key.append(entry_key);
+  key.push_back('\0');
+  key.append(entry_value);
+  key.push_back('\0');
+}
+
+} // namespace
+
+FilterConfig::FilterConfig(
+    const envoy::config::filter::http::local_rate_limit::v2alpha::LocalRateLimit& config,
+    const std::string& stats_prefix, Stats::Scope& scope, const LocalInfo::LocalInfo& local_info,
+    Runtime::Loader& runtime, TimeSource& time_source)
+    : local_info_(local_info), runtime_(runtime),
+      stats_(generateStats(stats_prefix + "local_ratelimit.", scope)), stage_(config.stage()),
+      token_bucket_(config.has_token_bucket()
+                        ? std::make_unique<Filters::Common::LocalRateLimit::SharedTokenBucket>(
+                              config.token_bucket(), time_source)
+                        : nullptr) {
+  for (const auto& descriptor : config.descriptors()) {
+    std::string key;
+    for (const auto& entry : descriptor.descriptor().entries()) {
+      appendDescriptorEntry(key, entry.key(), entry.value());
+    }
+    descriptor_buckets_[key] = std::make_unique<Filters::Common::LocalRateLimit::SharedTokenBucket>(
+        descriptor.token_bucket(), time_source);
+  }
+}
+
+LocalRateLimitStats FilterConfig::generateStats(const std::string& prefix, Stats::Scope& scope) {
+  return {ALL_LOCAL_RATE_LIMIT_STATS(POOL_COUNTER_PREFIX(scope, prefix))};
+}
+
+Filters::Common::LocalRateLimit::SharedTokenBucket*
+FilterConfig::descriptorTokenBucket(const RateLimit::Descriptor& descriptor) const {
+  std::string key;
+  for (const RateLimit::DescriptorEntry& entry : descriptor.entries_) {
+    appendDescriptorEntry(key, entry.key_, entry.value_);
+  }
+  const auto it = descriptor_buckets_.find(key);
+  return it != descriptor_buckets_.end() ? it->second.get() : nullptr;
+}
+
+Http::FilterHeadersStatus Filter::decodeHeaders(Http::HeaderMap& headers, bool) {
+  if (!config_->runtime().snapshot().featureEnabled("local_ratelimit.http_filter_enabled", 100)) {
+    return Http::FilterHeadersStatus::Continue;
+  }
+
+  if (consumeTokens(headers)) {
+    config_->stats().ok_.inc();
+    return Http::FilterHeadersStatus::Continue;
+  }
+
+  config_->stats().rate_limited_.inc();
+  if (!config_->runtime().snapshot().featureEnabled("local_ratelimit.http_filter_enforcing",
+                                                    100)) {
+    return Http::FilterHeadersStatus::Continue;
+  }
+  callbacks_->sendLocalReply(Http::Code::TooManyRequests, "", nullptr);
+  callbacks_->requestInfo().setResponseFlag(RequestInfo::ResponseFlag::RateLimited);
+  return Http::FilterHeadersStatus::StopIteration;
+}
+
+bool Filter::consumeTokens(const Http::HeaderMap& headers) {
+  if (config_->hasDescriptors()) {
+    Router::RouteConstSharedPtr route = callbacks_->route();
+    if (route && route->routeEntry()) {
+      const Router::RouteEntry& route_entry = *route->routeEntry();
+      std::vector<RateLimit::Descriptor> descriptors;
+      populateDescriptors(route_entry.rateLimitPolicy(), descriptors, route_entry, headers);
+      if (route_entry.includeVirtualHostRateLimits()) {
+        populateDescriptors(route_entry.virtualHost().rateLimitPolicy(), descriptors, route_entry,
+                            headers);
+      }
+      for (const RateLimit::Descriptor& descriptor : descriptors) {
+        Filters::Common::LocalRateLimit::SharedTokenBucket* bucket =
+            config_->descriptorTokenBucket(descriptor);
+        if (bucket != nullptr && !bucket->consume()) {
+          return false;
+        }
+      }
+    }
+  }
+
+  return config_->tokenBucket() == nullptr || config_->tokenBucket()->consume();
+}
+
+void Filter::populateDescriptors(const Router::RateLimitPolicy& rate_limit_policy,
+                                 std::vector<RateLimit::Descriptor>& descriptors,
+                                 const Router::RouteEntry& route_entry,
+                                 const Http::HeaderMap& headers) {
+  for (const Router::RateLimitPolicyEntry& rate_limit :
+       rate_limit_policy.getApplicableRateLimit(config_->stage())) {
+    const std::string& disable_key = rate_limit.disableKey();
+    if (!disable_key.empty() &&
+        !config_->runtime().snapshot().featureEnabled(
+            fmt::format("local_ratelimit.{}.http_filter_enabled", disable_key), 100)) {
+      continue;
+    }
+    rate_limit.populateDescriptors(route_entry, descriptors, config_->localInfo().clusterName(),
+                                   headers, *callbacks_->requestInfo().downstreamRemoteAddress());
+  }
+}
+
+} // namespace LocalRateLimitFilter
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "envoy/common/time.h"
+#include "envoy/config/filter/http/local_rate_limit/v2alpha/local_rate_limit.pb.h"
+#include "envoy/http/filter.h"
+#include "envoy/local_info/local_info.h"
+#include "envoy/ratelimit/ratelimit.h"
+#include "envoy/router/router_ratelimit.h"
+#include "envoy/runtime/runtime.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "extensions/filters/common/local_ratelimit/local_ratelimit.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace LocalRateLimitFilter {
+
+/**
+ * All local rate limit stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_LOCAL_RATE_LIMIT_STATS(COUNTER)                                                        \
+  COUNTER(ok)                                                                                      \
+  COUNTER(rate_limited)
+// clang-format on
+
+/**
+ * Struct definition for all local rate limit stats. @see stats_macros.h
+ */
+struct LocalRateLimitStats {
+  ALL_LOCAL_RATE_LIMIT_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * Global configuration for the HTTP local rate limit filter, which holds the token buckets shared
+ * by all the workers.
+ */
+class FilterConfig {
+public:
+  FilterConfig(const envoy::config::filter::http::local_rate_limit::v2alpha::LocalRateLimit& config,
+               const std::string& stats_prefix, Stats::Scope& scope,
+               const LocalInfo::LocalInfo& local_info, Runtime::Loader& runtime,
+               TimeSource& time_source);
+
+  const LocalInfo::LocalInfo& localInfo() const { return local_info_; }
+  Runtime::Loader& runtime() { return runtime_; }
+  LocalRateLimitStats& stats() { return stats_; }
+  uint64_t stage() const { return stage_; }
+  bool hasDescriptors() const { return !descriptor_buckets_.empty(); }
+
+  /**
+   * @return the bucket applied to all the requests, or nullptr if there is none.
+   */
+  Filters::Common::LocalRateLimit::SharedTokenBucket* tokenBucket() const {
+    return token_bucket_.get();
+  }
+
+  /**
+   * @param descriptor supplies a descriptor produced for a request.
+   * @return the bucket of the descriptor, or nullptr if there is none.
+   */
+  Filters::Common::LocalRateLimit::SharedTokenBucket*
+  descriptorTokenBucket(const RateLimit::Descriptor& descriptor) const;
+
+private:
+  static LocalRateLimitStats generateStats(const std::string& prefix, Stats::Scope& scope);
+
+  const LocalInfo::LocalInfo& local_info_;
+  Runtime::Loader& runtime_;
+  LocalRateLimitStats stats_;
+  const uint64_t stage_;
+  const Filters::Common::LocalRateLimit::SharedTokenBucketPtr token_bucket_;
+  // Keyed by the keys and the values of the entries of the descriptors.
+  std::unordered_map<std::string, Filters::Common::LocalRateLimit::SharedTokenBucketPtr>
+      descriptor_buckets_;
+};
+
+typedef std::shared_ptr<FilterConfig> FilterConfigSharedPtr;
+
+/**
+ * HTTP local rate limit filter. Each request consumes a token of the bucket applied to all the
+ * requests, and of the buckets of the descriptors which the rate limit actions of its route
+ * produce. The request is rejected with a 429 when one of them is empty.
+ */
+class Filter : public Http::StreamDecoderFilter {
+public:
+  Filter(FilterConfigSharedPtr config) : config_(config) {}
+
+  // Http::StreamFilterBase
+  void onDestroy() override {}
+
+  // Http::StreamDecoderFilter
+  Http::FilterHeadersStatus decodeHeaders(Http::HeaderMap& headers, bool end_stream) override;
+  Http::FilterDataStatus decodeData(Buffer::Instance&, bool) override {
+    return Http::FilterDataStatus::Continue;
+  }
+  Http::FilterTrailersStatus decodeTrailers(Http::HeaderMap&) override {
+    return Http::FilterTrailersStatus::Continue;
+  }
+  void setDecoderFilterCallbacks(Http::StreamDecoderFilterCallbacks& callbacks) override {
+    callbacks_ = &callbacks;
+  }
+
+private:
+  // Consumes the tokens of the request, returning false if one of its buckets is empty.
+  bool consumeTokens(const Http::HeaderMap& headers);
+  void populateDescriptors(const Router::RateLimitPolicy& rate_limit_policy,
+                           std::vector<RateLimit::Descriptor>& descriptors,
+                           const Router::RouteEntry& route_entry, const Http::HeaderMap& headers);
+
+  FilterConfigSharedPtr config_;
+  Http::StreamDecoderFilterCallbacks* callbacks_{};
+};
+
+} // namespace LocalRateLimitFilter
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -210,8 +210,10 @@ void StreamHandleWrapper::onSuccess(Http::MessagePtr&& response) {
   response->headers().iterate(
       [](const Http::HeaderEntry& header, void* context) -> Http::HeaderMap::Iterate {
         lua_State* state = static_cast<lua_State*>(context);
-        lua_pushstring(state, header.key().c_str());
-        lua_pushstring(state, header.value().c_str());
+        const absl::string_view key = header.key().getStringView();
+        const absl::string_view value = header.value().getStringView();
+        lua_pushlstring(state, key.data(), key.size());
+        lua_pushlstring(state, value.data(), value.size());
         lua_settable(state, -3);
         return Http::HeaderMap::Iterate::Continue;
       },
@@ -219,7 +221,8 @@ void StreamHandleWrapper::onSuccess(Http::MessagePtr&& response) {
 
   // TODO(mattklein123): Avoid double copy here.
   if (response->body() != nullptr) {
-    lua_pushstring(coroutine_.luaState(), response->bodyAsString().c_str());
+    const std::string body = response->bodyAsString();
+    lua_pushlstring(coroutine_.luaState(), body.data(), body.size());
   } else {
     lua_pushnil(coroutine_.luaState());
   }
@@ -515,6 +518,19 @@ Http::FilterTrailersStatus Filter::doTrailers(StreamHandleRef& handle, Http::Hea
   return status;
 }
 
+Filter::~Filter() {
+  // The stream handles are released first. The coroutines which finished still hold them on their
+  // stack, which is cleared when they are released for reuse.
+  request_stream_wrapper_.reset();
+  response_stream_wrapper_.reset();
+  if (request_coroutine_ != nullptr) {
+    config_->releaseCoroutine(std::move(request_coroutine_));
+  }
+  if (response_coroutine_ != nullptr) {
+    config_->releaseCoroutine(std::move(response_coroutine_));
+  }
+}
+
 void Filter::scriptError(const Filters::Common::Lua::LuaException& e) {
   scriptLog(spdlog::level::err, e.what());
   request_stream_wrapper_.reset();
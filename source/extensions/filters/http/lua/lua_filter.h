@@ -260,6 +260,9 @@ public:
   FilterConfig(const std::string& lua_code, ThreadLocal::SlotAllocator& tls,
                Upstream::ClusterManager& cluster_manager);
   Filters::Common::Lua::CoroutinePtr createCoroutine() { return lua_state_.createCoroutine(); }
+  void releaseCoroutine(Filters::Common::Lua::CoroutinePtr&& coroutine) {
+    lua_state_.releaseCoroutine(std::move(coroutine));
+  }
   int requestFunctionRef() { return lua_state_.getGlobalRef(request_function_slot_); }
   int responseFunctionRef() { return lua_state_.getGlobalRef(response_function_slot_); }
   uint64_t runtimeBytesUsed() { return lua_state_.runtimeBytesUsed(); }
@@ -283,6 +286,7 @@ typedef std::shared_ptr<FilterConfig> FilterConfigConstSharedPtr;
 class Filter : public Http::StreamFilter, Logger::Loggable<Logger::Id::lua> {
 public:
   Filter(FilterConfigConstSharedPtr config) : config_(config) {}
+  ~Filter();
 
   Upstream::ClusterManager& clusterManager() { return config_->cluster_manager_; }
   void scriptError(const Filters::Common::Lua::LuaException& e);
@@ -25,8 +25,10 @@ int HeaderMapIterator::luaPairsIterator(lua_State* state) {
     parent_.iterator_.reset();
     return 0;
   } else {
-    lua_pushstring(state, entries_[current_]->key().c_str());
-    lua_pushstring(state, entries_[current_]->value().c_str());
+    const absl::string_view key = entries_[current_]->key().getStringView();
+    const absl::string_view value = entries_[current_]->value().getStringView();
+    lua_pushlstring(state, key.data(), key.size());
+    lua_pushlstring(state, value.data(), value.size());
     current_++;
     return 2;
   }
@@ -45,7 +47,8 @@ int HeaderMapWrapper::luaGet(lua_State* state) {
   const char* key = luaL_checkstring(state, 2);
   const Http::HeaderEntry* entry = headers_.get(Http::LowerCaseString(key));
   if (entry != nullptr) {
-    lua_pushstring(state, entry->value().c_str());
+    const absl::string_view value = entry->value().getStringView();
+    lua_pushlstring(state, value.data(), value.size());
     return 1;
   } else {
     return 0;
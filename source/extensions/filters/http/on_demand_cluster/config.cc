@@ -0,0 +1,31 @@
+#include "extensions/filters/http/on_demand_cluster/config.h"
+
+#include "envoy/registry/registry.h"
+
+#include "extensions/filters/http/on_demand_cluster/on_demand_cluster_filter.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace OnDemandCluster {
+
+Http::FilterFactoryCb
+OnDemandClusterFilterConfig::createFilter(const std::string&,
+                                          Server::Configuration::FactoryContext& context) {
+  return [&context](Http::FilterChainFactoryCallbacks& callbacks) -> void {
+    callbacks.addStreamDecoderFilter(
+        std::make_shared<OnDemandClusterFilter>(context.clusterManager()));
+  };
+}
+
+/**
+ * Static registration for the on-demand cluster filter. @see RegisterFactory.
+ */
+static Registry::RegisterFactory<OnDemandClusterFilterConfig,
+                                 Server::Configuration::NamedHttpFilterConfigFactory>
+    register_;
+
+} // namespace OnDemandCluster
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
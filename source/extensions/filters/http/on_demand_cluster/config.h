@@ -0,0 +1,25 @@
+#pragma once
+
+#include "envoy/server/filter_config.h"
+
+#include "extensions/filters/http/common/empty_http_filter_config.h"
+#include "extensions/filters/http/well_known_names.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace OnDemandCluster {
+
+class OnDemandClusterFilterConfig : public Common::EmptyHttpFilterConfig {
+public:
+  OnDemandClusterFilterConfig()
+      : Common::EmptyHttpFilterConfig(HttpFilterNames::get().OnDemandCluster) {}
+
+  Http::FilterFactoryCb createFilter(const std::string&,
+                                     Server::Configuration::FactoryContext& context) override;
+};
+
+} // namespace OnDemandCluster
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,43 @@
+#include "extensions/filters/http/on_demand_cluster/on_demand_cluster_filter.h"
+
+#include "envoy/router/router.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace OnDemandCluster {
+
+Http::FilterHeadersStatus OnDemandClusterFilter::decodeHeaders(Http::HeaderMap&, bool) {
+  Router::RouteConstSharedPtr route = callbacks_->route();
+  if (route == nullptr || route->routeEntry() == nullptr) {
+    return Http::FilterHeadersStatus::Continue;
+  }
+
+  handle_ = cm_.loadOnDemandCluster(route->routeEntry()->clusterName(),
+                                    [this]() -> void { onClusterLoaded(); });
+  return handle_ == nullptr ? Http::FilterHeadersStatus::Continue
+                            : Http::FilterHeadersStatus::StopIteration;
+}
+
+Http::FilterDataStatus OnDemandClusterFilter::decodeData(Buffer::Instance&, bool) {
+  return handle_ == nullptr ? Http::FilterDataStatus::Continue
+                            : Http::FilterDataStatus::StopIterationAndWatermark;
+}
+
+Http::FilterTrailersStatus OnDemandClusterFilter::decodeTrailers(Http::HeaderMap&) {
+  return handle_ == nullptr ? Http::FilterTrailersStatus::Continue
+                            : Http::FilterTrailersStatus::StopIteration;
+}
+
+void OnDemandClusterFilter::onDestroy() { handle_.reset(); }
+
+void OnDemandClusterFilter::onClusterLoaded() {
+  // Whether or not the cluster could be loaded, the router takes it from here.
+  handle_.reset();
+  callbacks_->continueDecoding();
+}
+
+} // namespace OnDemandCluster
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
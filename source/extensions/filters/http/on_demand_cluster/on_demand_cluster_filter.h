@@ -0,0 +1,42 @@
+#pragma once
+
+#include "envoy/http/filter.h"
+#include "envoy/upstream/cluster_manager.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace OnDemandCluster {
+
+/**
+ * Holds requests until the on-demand cluster they are routed to is loaded.
+ * See docs/configuration/http_filters/on_demand_cluster_filter.rst
+ */
+class OnDemandClusterFilter : public Http::StreamDecoderFilter {
+public:
+  OnDemandClusterFilter(Upstream::ClusterManager& cm) : cm_(cm) {}
+
+  // Http::StreamFilterBase
+  void onDestroy() override;
+
+  // Http::StreamDecoderFilter
+  Http::FilterHeadersStatus decodeHeaders(Http::HeaderMap& headers, bool end_stream) override;
+  Http::FilterDataStatus decodeData(Buffer::Instance& data, bool end_stream) override;
+  Http::FilterTrailersStatus decodeTrailers(Http::HeaderMap& trailers) override;
+  void setDecoderFilterCallbacks(Http::StreamDecoderFilterCallbacks& callbacks) override {
+    callbacks_ = &callbacks;
+  }
+
+private:
+  void onClusterLoaded();
+
+  Upstream::ClusterManager& cm_;
+  Http::StreamDecoderFilterCallbacks* callbacks_{};
+  // Set while the cluster is loading.
+  Upstream::OnDemandClusterHandlePtr handle_;
+};
+
+} // namespace OnDemandCluster
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
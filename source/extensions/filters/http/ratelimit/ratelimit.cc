@@ -10,6 +10,7 @@
 #include "common/common/fmt.h"
 #include "common/http/codes.h"
 #include "common/http/header_utility.h"
+#include "common/protobuf/utility.h"
 #include "common/router/config_impl.h"
 
 namespace Envoy {
@@ -17,6 +18,81 @@ namespace Extensions {
 namespace HttpFilters {
 namespace RateLimitFilter {
 
+namespace {
+constexpr uint64_t DefaultMaxLeases = 1000;
+} // namespace
+
+FilterConfig::FilterConfig(const envoy::config::filter::http::rate_limit::v2::RateLimit& config,
+                           const LocalInfo::LocalInfo& local_info, Stats::Scope& scope,
+                           Runtime::Loader& runtime, Upstream::ClusterManager& cm,
+                           ThreadLocal::SlotAllocator& tls, TimeSource& time_source)
+    : domain_(config.domain()), stage_(static_cast<uint64_t>(config.stage())),
+      request_type_(config.request_type().empty() ? stringToType("both")
+                                                  : stringToType(config.request_type())),
+      local_info_(local_info), scope_(scope), runtime_(runtime), cm_(cm),
+      failure_mode_deny_(config.failure_mode_deny()), time_source_(time_source) {
+  if (!config.has_quota_lease()) {
+    return;
+  }
+
+  const auto& lease_config = config.quota_lease();
+  lease_hits_ = lease_config.hits();
+  lease_ttl_ = std::chrono::milliseconds(PROTOBUF_GET_MS_REQUIRED(lease_config, ttl));
+  max_leases_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(lease_config, max_leases, DefaultMaxLeases);
+  tls_ = tls.allocateSlot();
+  tls_->set([](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<ThreadLocalLeases>();
+  });
+}
+
+std::string FilterConfig::leaseKey(const std::vector<RateLimit::Descriptor>& descriptors) {
+  // Each key and value is terminated by a NUL character, which HTTP header values can't hold, and
+  // each descriptor by another one.
+  std::string key;
+  for (const RateLimit::Descriptor& descriptor : descriptors) {
+    for (const RateLimit::DescriptorEntry& entry : descriptor.entries_) {
+      key.append(entry.key_);
+      key.push_back('\0');
+      key.append(entry.value_);
+      key.push_back('\0');
+    }
+    key.push_back('\0');
+  }
+  return key;
+}
+
+bool FilterConfig::useLeasedHit(const std::string& key) {
+  auto& leases = tls_->getTyped<ThreadLocalLeases>().leases_;
+  auto it = leases.find(key);
+  if (it == leases.end()) {
+    return false;
+  }
+  if (it->second.expiration_ <= time_source_.monotonicTime()) {
+    leases.erase(it);
+    return false;
+  }
+  if (--it->second.remaining_hits_ == 0) {
+    leases.erase(it);
+  }
+  return true;
+}
+
+void FilterConfig::addLease(const std::string& key) {
+  auto& leases = tls_->getTyped<ThreadLocalLeases>().leases_;
+  if (leases.size() >= max_leases_) {
+    // Make room by dropping the expired leases, which are otherwise only dropped when used.
+    const MonotonicTime now = time_source_.monotonicTime();
+    for (auto it = leases.begin(); it != leases.end();) {
+      it = it->second.expiration_ <= now ? leases.erase(it) : std::next(it);
+    }
+    if (leases.size() >= max_leases_ && leases.find(key) == leases.end()) {
+      return;
+    }
+  }
+  // The first hit of the lease was used by the request which obtained it.
+  leases[key] = {lease_hits_ - 1, time_source_.monotonicTime() + lease_ttl_};
+}
+
 void Filter::initiateCall(const Http::HeaderMap& headers) {
   bool is_internal_request =
       headers.EnvoyInternalRequest() && (headers.EnvoyInternalRequest()->value() == "true");
@@ -50,12 +126,26 @@ void Filter::initiateCall(const Http::HeaderMap& headers) {
                                  route_entry, headers);
   }
 
-  if (!descriptors.empty()) {
-    state_ = State::Calling;
-    initiating_call_ = true;
-    client_->limit(*this, config_->domain(), descriptors, callbacks_->activeSpan());
-    initiating_call_ = false;
+  if (descriptors.empty()) {
+    return;
+  }
+
+  if (config_->quotaLeaseEnabled()) {
+    std::string lease_key = FilterConfig::leaseKey(descriptors);
+    if (config_->useLeasedHit(lease_key)) {
+      cluster_->statsScope().counter("ratelimit.ok").inc();
+      cluster_->statsScope().counter("ratelimit.leased_hit").inc();
+      state_ = State::Complete;
+      return;
+    }
+    lease_key_ = std::move(lease_key);
   }
+
+  state_ = State::Calling;
+  initiating_call_ = true;
+  client_->limit(*this, config_->domain(), descriptors, callbacks_->activeSpan(),
+                 config_->hitsAddend());
+  initiating_call_ = false;
 }
 
 Http::FilterHeadersStatus Filter::decodeHeaders(Http::HeaderMap& headers, bool) {
@@ -121,6 +211,9 @@ void Filter::complete(RateLimit::LimitStatus status, Http::HeaderMapPtr&& header
   switch (status) {
   case RateLimit::LimitStatus::OK:
     cluster_->statsScope().counter("ratelimit.ok").inc();
+    if (!lease_key_.empty()) {
+      config_->addLease(lease_key_);
+    }
     break;
   case RateLimit::LimitStatus::Error:
     cluster_->statsScope().counter("ratelimit.error").inc();
@@ -1,16 +1,20 @@
 #pragma once
 
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "envoy/common/time.h"
 #include "envoy/config/filter/http/rate_limit/v2/rate_limit.pb.h"
 #include "envoy/http/filter.h"
 #include "envoy/local_info/local_info.h"
 #include "envoy/ratelimit/ratelimit.h"
 #include "envoy/runtime/runtime.h"
 #include "envoy/stats/scope.h"
+#include "envoy/thread_local/thread_local.h"
 #include "envoy/upstream/cluster_manager.h"
 
 #include "common/common/assert.h"
@@ -33,12 +37,8 @@ class FilterConfig {
 public:
   FilterConfig(const envoy::config::filter::http::rate_limit::v2::RateLimit& config,
                const LocalInfo::LocalInfo& local_info, Stats::Scope& scope,
-               Runtime::Loader& runtime, Upstream::ClusterManager& cm)
-      : domain_(config.domain()), stage_(static_cast<uint64_t>(config.stage())),
-        request_type_(config.request_type().empty() ? stringToType("both")
-                                                    : stringToType(config.request_type())),
-        local_info_(local_info), scope_(scope), runtime_(runtime), cm_(cm),
-        failure_mode_deny_(config.failure_mode_deny()) {}
+               Runtime::Loader& runtime, Upstream::ClusterManager& cm,
+               ThreadLocal::SlotAllocator& tls, TimeSource& time_source);
   const std::string& domain() const { return domain_; }
   const LocalInfo::LocalInfo& localInfo() const { return local_info_; }
   uint64_t stage() const { return stage_; }
@@ -49,7 +49,42 @@ public:
 
   bool failureModeAllow() const { return !failure_mode_deny_; }
 
+  /**
+   * @return the number of hits requested from the rate limit service for a request, which is more
+   *         than one when the hits are leased.
+   */
+  uint32_t hitsAddend() const { return lease_hits_ > 1 ? lease_hits_ : 1; }
+  bool quotaLeaseEnabled() const { return tls_ != nullptr; }
+
+  /**
+   * @param descriptors supplies the descriptors of a request.
+   * @return the key of the lease of the descriptors.
+   */
+  static std::string leaseKey(const std::vector<RateLimit::Descriptor>& descriptors);
+
+  /**
+   * Uses a hit of the lease of the worker for a key.
+   * @param key supplies the key of the lease.
+   * @return bool whether a hit was used, false if the worker has no lease with remaining hits.
+   */
+  bool useLeasedHit(const std::string& key);
+
+  /**
+   * Keeps the hits remaining from a lease obtained for the request which used the first one.
+   * @param key supplies the key of the lease.
+   */
+  void addLease(const std::string& key);
+
 private:
+  struct Lease {
+    uint32_t remaining_hits_;
+    MonotonicTime expiration_;
+  };
+
+  struct ThreadLocalLeases : public ThreadLocal::ThreadLocalObject {
+    std::unordered_map<std::string, Lease> leases_;
+  };
+
   static FilterRequestType stringToType(const std::string& request_type) {
     if (request_type == "internal") {
       return FilterRequestType::Internal;
@@ -69,6 +104,12 @@ private:
   Runtime::Loader& runtime_;
   Upstream::ClusterManager& cm_;
   const bool failure_mode_deny_;
+  TimeSource& time_source_;
+  uint32_t lease_hits_{};
+  std::chrono::milliseconds lease_ttl_{};
+  uint64_t max_leases_{};
+  // Only allocated when the quota lease is enabled.
+  ThreadLocal::SlotPtr tls_;
 };
 
 typedef std::shared_ptr<FilterConfig> FilterConfigSharedPtr;
@@ -118,6 +159,8 @@ private:
   Upstream::ClusterInfoConstSharedPtr cluster_;
   bool initiating_call_{};
   Http::HeaderMapPtr headers_to_add_;
+  // The key of the lease requested by the call to the rate limit service, if any.
+  std::string lease_key_;
 };
 
 } // namespace RateLimitFilter
@@ -0,0 +1,39 @@
+#include "extensions/filters/http/request_coalescing/config.h"
+
+#include <string>
+
+#include "envoy/config/filter/http/request_coalescing/v2alpha/request_coalescing.pb.validate.h"
+#include "envoy/registry/registry.h"
+
+#include "extensions/filters/http/request_coalescing/request_coalescing_filter.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace RequestCoalescing {
+
+Http::FilterFactoryCb RequestCoalescingFilterFactory::createFilterFactoryFromProtoTyped(
+    const envoy::config::filter::http::request_coalescing::v2alpha::RequestCoalescing&
+        proto_config,
+    const std::string& stats_prefix, Server::Configuration::FactoryContext& context) {
+  RequestCoalescingFilterConfigSharedPtr filter_config(
+      std::make_shared<RequestCoalescingFilterConfig>(proto_config, stats_prefix, context.scope(),
+                                                      context.threadLocal()));
+
+  return [filter_config](Http::FilterChainFactoryCallbacks& callbacks) -> void {
+    callbacks.addStreamFilter(
+        Http::StreamFilterSharedPtr{new RequestCoalescingFilter(filter_config)});
+  };
+}
+
+/**
+ * Static registration for the request coalescing filter. @see RegisterFactory.
+ */
+static Registry::RegisterFactory<RequestCoalescingFilterFactory,
+                                 Server::Configuration::NamedHttpFilterConfigFactory>
+    register_;
+
+} // namespace RequestCoalescing
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
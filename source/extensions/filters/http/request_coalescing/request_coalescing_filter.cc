@@ -0,0 +1,201 @@
+#include "extensions/filters/http/request_coalescing/request_coalescing_filter.h"
+
+#include "common/buffer/buffer_impl.h"
+#include "common/http/header_map_impl.h"
+#include "common/http/headers.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace RequestCoalescing {
+
+RequestCoalescingFilterConfig::RequestCoalescingFilterConfig(
+    const envoy::config::filter::http::request_coalescing::v2alpha::RequestCoalescing&
+        proto_config,
+    const std::string& stats_prefix, Stats::Scope& scope, ThreadLocal::SlotAllocator& tls)
+    : stats_{ALL_REQUEST_COALESCING_STATS(
+          POOL_COUNTER_PREFIX(scope, stats_prefix + "request_coalescing."))},
+      tls_(tls.allocateSlot()) {
+  for (const std::string& header : proto_config.key_headers()) {
+    key_headers_.emplace_back(header);
+    key_has_authorization_ |= key_headers_.back().get() == Http::Headers::get().Authorization.get();
+    key_has_cookie_ |= key_headers_.back().get() == Http::Headers::get().Cookie.get();
+  }
+
+  tls_->set([](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<ThreadLocalCoalescedRequests>();
+  });
+}
+
+absl::optional<std::string>
+RequestCoalescingFilterConfig::key(const Http::HeaderMap& headers) const {
+  if (headers.Method() == nullptr ||
+      headers.Method()->value() != Http::Headers::get().MethodValues.Get.c_str() ||
+      headers.Host() == nullptr || headers.Path() == nullptr) {
+    return absl::nullopt;
+  }
+  // The response to a request with credentials may be private.
+  if ((!key_has_authorization_ && headers.Authorization() != nullptr) ||
+      (!key_has_cookie_ && headers.get(Http::Headers::get().Cookie) != nullptr)) {
+    return absl::nullopt;
+  }
+
+  // Header values cannot contain NUL, which separates the parts of the key.
+  std::string key(headers.Host()->value().c_str(), headers.Host()->value().size());
+  key.push_back('\0');
+  key.append(headers.Path()->value().c_str(), headers.Path()->value().size());
+  for (const Http::LowerCaseString& header : key_headers_) {
+    key.push_back('\0');
+    const Http::HeaderEntry* entry = headers.get(header);
+    if (entry != nullptr) {
+      // Distinguishes an empty value from a missing header.
+      key.push_back('=');
+      key.append(entry->value().c_str(), entry->value().size());
+    }
+  }
+  return key;
+}
+
+void RequestCoalescingFilter::onDestroy() {
+  if (waiter_ != nullptr) {
+    waiter_->active_ = false;
+    waiter_.reset();
+  }
+
+  if (group_ != nullptr) {
+    // The response to the leader did not complete.
+    closeGroup();
+    releaseWaiters();
+  }
+}
+
+Http::FilterHeadersStatus RequestCoalescingFilter::decodeHeaders(Http::HeaderMap& headers,
+                                                                 bool end_stream) {
+  // Only requests without a body are coalesced.
+  if (!end_stream) {
+    return Http::FilterHeadersStatus::Continue;
+  }
+  absl::optional<std::string> key = config_->key(headers);
+  if (!key) {
+    return Http::FilterHeadersStatus::Continue;
+  }
+
+  auto& groups = config_->groups();
+  auto it = groups.find(key.value());
+  if (it != groups.end()) {
+    waiter_ = std::make_shared<Waiter>(*decoder_callbacks_);
+    it->second->waiters_.push_back(waiter_);
+    config_->stats().rq_coalesced_.inc();
+    return Http::FilterHeadersStatus::StopIteration;
+  }
+
+  group_ = std::make_shared<CoalescedRequests>();
+  key_ = std::move(key.value());
+  groups.emplace(key_, group_);
+  config_->stats().rq_leader_.inc();
+  return Http::FilterHeadersStatus::Continue;
+}
+
+Http::FilterHeadersStatus RequestCoalescingFilter::encodeHeaders(Http::HeaderMap& headers,
+                                                                 bool end_stream) {
+  if (group_ == nullptr) {
+    return Http::FilterHeadersStatus::Continue;
+  }
+
+  // Later requests must not miss the start of the response, so they start a new group.
+  closeGroup();
+  if (headers.get(Http::Headers::get().SetCookie) != nullptr) {
+    // The response is specific to the leader, so the other requests are sent on their own.
+    releaseWaiters();
+    return Http::FilterHeadersStatus::Continue;
+  }
+
+  // Waiters are copied, as sending the response to a waiter may destroy other streams.
+  const std::vector<WaiterSharedPtr> waiters = group_->waiters_;
+  if (end_stream) {
+    group_.reset();
+  }
+  for (const WaiterSharedPtr& waiter : waiters) {
+    if (waiter->active_) {
+      waiter->responding_ = true;
+      waiter->callbacks_.encodeHeaders(Http::HeaderMapPtr{new Http::HeaderMapImpl(headers)},
+                                       end_stream);
+    }
+  }
+  return Http::FilterHeadersStatus::Continue;
+}
+
+Http::FilterDataStatus RequestCoalescingFilter::encodeData(Buffer::Instance& data,
+                                                           bool end_stream) {
+  if (group_ == nullptr) {
+    return Http::FilterDataStatus::Continue;
+  }
+
+  const std::vector<WaiterSharedPtr> waiters = group_->waiters_;
+  if (end_stream) {
+    group_.reset();
+  }
+  for (const WaiterSharedPtr& waiter : waiters) {
+    if (waiter->active_) {
+      Buffer::OwnedImpl copy;
+      copy.addShared(data);
+      waiter->callbacks_.encodeData(copy, end_stream);
+    }
+  }
+  return Http::FilterDataStatus::Continue;
+}
+
+Http::FilterTrailersStatus RequestCoalescingFilter::encodeTrailers(Http::HeaderMap& trailers) {
+  if (group_ == nullptr) {
+    return Http::FilterTrailersStatus::Continue;
+  }
+
+  const std::vector<WaiterSharedPtr> waiters = group_->waiters_;
+  group_.reset();
+  for (const WaiterSharedPtr& waiter : waiters) {
+    if (waiter->active_) {
+      waiter->callbacks_.encodeTrailers(Http::HeaderMapPtr{new Http::HeaderMapImpl(trailers)});
+    }
+  }
+  return Http::FilterTrailersStatus::Continue;
+}
+
+void RequestCoalescingFilter::closeGroup() {
+  auto& groups = config_->groups();
+  auto it = groups.find(key_);
+  if (it != groups.end() && it->second == group_) {
+    groups.erase(it);
+  }
+}
+
+void RequestCoalescingFilter::releaseWaiters() {
+  // Waiters which did not get any of the response continue on their own, the others are reset.
+  // This is done from the dispatcher rather than from the stream of the leader, which may be being
+  // destroyed.
+  std::vector<WaiterSharedPtr> waiters = std::move(group_->waiters_);
+  group_.reset();
+  if (waiters.empty()) {
+    return;
+  }
+
+  RequestCoalescingFilterConfigSharedPtr config = config_;
+  decoder_callbacks_->dispatcher().post([config, waiters]() -> void {
+    for (const WaiterSharedPtr& waiter : waiters) {
+      if (!waiter->active_) {
+        continue;
+      }
+      if (waiter->responding_) {
+        config->stats().rq_reset_.inc();
+        waiter->callbacks_.resetStream();
+      } else {
+        config->stats().rq_released_.inc();
+        waiter->callbacks_.continueDecoding();
+      }
+    }
+  });
+}
+
+} // namespace RequestCoalescing
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
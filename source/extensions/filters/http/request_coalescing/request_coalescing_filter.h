@@ -0,0 +1,156 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "envoy/config/filter/http/request_coalescing/v2alpha/request_coalescing.pb.h"
+#include "envoy/http/filter.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "absl/types/optional.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace RequestCoalescing {
+
+/**
+ * All request coalescing filter stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_REQUEST_COALESCING_STATS(COUNTER)                                                      \
+  COUNTER(rq_leader)                                                                               \
+  COUNTER(rq_coalesced)                                                                            \
+  COUNTER(rq_released)                                                                             \
+  COUNTER(rq_reset)
+// clang-format on
+
+/**
+ * Struct definition for all request coalescing filter stats. @see stats_macros.h
+ */
+struct RequestCoalescingStats {
+  ALL_REQUEST_COALESCING_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * A request that waits on the response to the request of its leader.
+ */
+struct Waiter {
+  Waiter(Http::StreamDecoderFilterCallbacks& callbacks) : callbacks_(callbacks) {}
+
+  Http::StreamDecoderFilterCallbacks& callbacks_;
+  // False once the stream of the request is destroyed.
+  bool active_{true};
+  // True once the response of the leader started to be sent to the request.
+  bool responding_{false};
+};
+
+typedef std::shared_ptr<Waiter> WaiterSharedPtr;
+
+/**
+ * The requests that wait on the response to the request of a leader. Requests join the group
+ * until the leader receives its response headers.
+ */
+struct CoalescedRequests {
+  std::vector<WaiterSharedPtr> waiters_;
+};
+
+typedef std::shared_ptr<CoalescedRequests> CoalescedRequestsSharedPtr;
+
+/**
+ * The groups of coalesced requests of a worker, by key.
+ */
+struct ThreadLocalCoalescedRequests : public ThreadLocal::ThreadLocalObject {
+  std::unordered_map<std::string, CoalescedRequestsSharedPtr> groups_;
+};
+
+/**
+ * Configuration for the request coalescing filter.
+ */
+class RequestCoalescingFilterConfig {
+public:
+  RequestCoalescingFilterConfig(
+      const envoy::config::filter::http::request_coalescing::v2alpha::RequestCoalescing&
+          proto_config,
+      const std::string& stats_prefix, Stats::Scope& scope, ThreadLocal::SlotAllocator& tls);
+
+  /**
+   * @return the key of a request, which is the same for the requests that may be coalesced, or
+   *         nullopt if the request must not be coalesced.
+   */
+  absl::optional<std::string> key(const Http::HeaderMap& headers) const;
+
+  /**
+   * @return the groups of coalesced requests of the calling worker, by key.
+   */
+  std::unordered_map<std::string, CoalescedRequestsSharedPtr>& groups() {
+    return tls_->getTyped<ThreadLocalCoalescedRequests>().groups_;
+  }
+
+  RequestCoalescingStats& stats() { return stats_; }
+
+private:
+  std::vector<Http::LowerCaseString> key_headers_;
+  bool key_has_authorization_{};
+  bool key_has_cookie_{};
+  RequestCoalescingStats stats_;
+  ThreadLocal::SlotPtr tls_;
+};
+
+typedef std::shared_ptr<RequestCoalescingFilterConfig> RequestCoalescingFilterConfigSharedPtr;
+
+/**
+ * A filter that coalesces the concurrent GET requests of a worker that have the same key into the
+ * request of a leader, which is the only one to continue. The response to the leader is sent to
+ * the other requests of its group as well, sharing the body buffers.
+ * See docs/configuration/http_filters/request_coalescing_filter.rst
+ */
+class RequestCoalescingFilter : public Http::StreamFilter {
+public:
+  RequestCoalescingFilter(RequestCoalescingFilterConfigSharedPtr config) : config_(config) {}
+
+  // Http::StreamFilterBase
+  void onDestroy() override;
+
+  // Http::StreamDecoderFilter
+  Http::FilterHeadersStatus decodeHeaders(Http::HeaderMap& headers, bool end_stream) override;
+  Http::FilterDataStatus decodeData(Buffer::Instance&, bool) override {
+    return Http::FilterDataStatus::Continue;
+  }
+  Http::FilterTrailersStatus decodeTrailers(Http::HeaderMap&) override {
+    return Http::FilterTrailersStatus::Continue;
+  }
+  void setDecoderFilterCallbacks(Http::StreamDecoderFilterCallbacks& callbacks) override {
+    decoder_callbacks_ = &callbacks;
+  }
+
+  // Http::StreamEncoderFilter
+  Http::FilterHeadersStatus encode100ContinueHeaders(Http::HeaderMap&) override {
+    return Http::FilterHeadersStatus::Continue;
+  }
+  Http::FilterHeadersStatus encodeHeaders(Http::HeaderMap& headers, bool end_stream) override;
+  Http::FilterDataStatus encodeData(Buffer::Instance& data, bool end_stream) override;
+  Http::FilterTrailersStatus encodeTrailers(Http::HeaderMap& trailers) override;
+  void setEncoderFilterCallbacks(Http::StreamEncoderFilterCallbacks&) override {}
+
+private:
+  void closeGroup();
+  void releaseWaiters();
+
+  RequestCoalescingFilterConfigSharedPtr config_;
+  Http::StreamDecoderFilterCallbacks* decoder_callbacks_{};
+  // Set while this request leads a group whose response is not complete.
+  CoalescedRequestsSharedPtr group_;
+  std::string key_;
+  // Set while this request waits on a leader.
+  WaiterSharedPtr waiter_;
+};
+
+} // namespace RequestCoalescing
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -21,7 +21,8 @@ Http::FilterFactoryCb RouterFilterConfig::createFilterFactoryFromProtoTyped(
       proto_config));
 
   return [filter_config](Http::FilterChainFactoryCallbacks& callbacks) -> void {
-    callbacks.addStreamDecoderFilter(std::make_shared<Router::ProdFilter>(*filter_config));
+    callbacks.addStreamDecoderFilter(
+        makeSharedInArena<Router::ProdFilter>(callbacks.arena(), *filter_config));
   };
 }
 
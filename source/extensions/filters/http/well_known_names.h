@@ -48,6 +48,22 @@ public:
   const std::string JwtAuthn = "envoy.filters.http.jwt_authn";
   // Header to metadata filter
   const std::string HeaderToMetadata = "envoy.filters.http.header_to_metadata";
+  // On-demand cluster filter
+  const std::string OnDemandCluster = "envoy.filters.http.on_demand_cluster";
+  // Adaptive concurrency filter
+  const std::string AdaptiveConcurrency = "envoy.filters.http.adaptive_concurrency";
+  // Request coalescing filter
+  const std::string RequestCoalescing = "envoy.filters.http.request_coalescing";
+  // Cache filter
+  const std::string Cache = "envoy.filters.http.cache";
+  // Decompressor filter
+  const std::string Decompressor = "envoy.filters.http.decompressor";
+  // Local rate limit filter
+  const std::string LocalRateLimit = "envoy.filters.http.local_ratelimit";
+  // Dynamic module filter
+  const std::string DynamicModule = "envoy.filters.http.dynamic_module";
+  // Dynamic forward proxy filter
+  const std::string DynamicForwardProxy = "envoy.filters.http.dynamic_forward_proxy";
 
   // Converts names from v1 to v2
   const Config::V1Converter v1_converter_;
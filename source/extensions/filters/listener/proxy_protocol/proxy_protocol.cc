@@ -21,6 +21,8 @@
 #include "common/network/address_impl.h"
 #include "common/network/utility.h"
 
+#include "extensions/filters/listener/well_known_names.h"
+
 namespace Envoy {
 namespace Extensions {
 namespace ListenerFilters {
@@ -86,6 +88,7 @@ void Filter::onReadWorker() {
       socket.setLocalAddress(proxy_protocol_header_.value().local_address_, true);
     }
     socket.setRemoteAddress(proxy_protocol_header_.value().remote_address_);
+    parseTlvs();
   }
 
   // Release the file event so that we do not interfere with the connection read events.
@@ -234,10 +237,9 @@ void Filter::parseV1Header(char* buf, size_t len) {
 }
 
 bool Filter::parseExtensions(int fd) {
-  // If we ever implement extensions elsewhere, be sure to
-  // continue to skip and ignore those for LOCAL.
+  // The extensions are read in full, but only used for connections on behalf of a client. If we
+  // ever implement extensions elsewhere, be sure to continue to skip and ignore those for LOCAL.
   while (proxy_protocol_header_.value().extensions_length_) {
-    // buf_ is no longer in use so we re-use it to read/discard
     int bytes_avail;
     auto& os_syscalls = Api::OsSysCallsSingleton::get();
     if (os_syscalls.ioctl(fd, FIONREAD, &bytes_avail).rc_ < 0) {
@@ -246,9 +248,14 @@ bool Filter::parseExtensions(int fd) {
     if (bytes_avail == 0) {
       return false;
     }
-    bytes_avail = std::min(size_t(bytes_avail), sizeof(buf_));
+    if (extensions_.empty()) {
+      extensions_.reserve(proxy_protocol_header_.value().extensions_length_);
+    }
     bytes_avail = std::min(size_t(bytes_avail), proxy_protocol_header_.value().extensions_length_);
-    const Api::SysCallSizeResult recv_result = os_syscalls.recv(fd, buf_, bytes_avail, 0);
+    const size_t offset = extensions_.size();
+    extensions_.resize(offset + bytes_avail);
+    const Api::SysCallSizeResult recv_result =
+        os_syscalls.recv(fd, &extensions_[offset], bytes_avail, 0);
     if (recv_result.rc_ != bytes_avail) {
       throw EnvoyException("failed to read proxy protocol extension");
     }
@@ -257,6 +264,46 @@ bool Filter::parseExtensions(int fd) {
   return true;
 }
 
+void Filter::parseTlvs() {
+  ProtobufWkt::Struct metadata;
+  auto& fields = *metadata.mutable_fields();
+  size_t offset = 0;
+  // TLVs are ignored from the first malformed one on, as they were before they were parsed.
+  while (extensions_.size() - offset >= PROXY_PROTO_V2_TLV_HEADER_LEN) {
+    const uint8_t type = extensions_[offset];
+    const size_t length = (extensions_[offset + 1] << 8) + extensions_[offset + 2];
+    offset += PROXY_PROTO_V2_TLV_HEADER_LEN;
+    if (extensions_.size() - offset < length) {
+      break;
+    }
+
+    const char* value = reinterpret_cast<const char*>(&extensions_[offset]);
+    switch (type) {
+    case PROXY_PROTO_V2_TLV_TYPE_ALPN:
+      fields["alpn"].set_string_value(value, length);
+      break;
+    case PROXY_PROTO_V2_TLV_TYPE_AUTHORITY:
+      fields["authority"].set_string_value(value, length);
+      break;
+    case PROXY_PROTO_V2_TLV_TYPE_NETNS:
+      fields["netns"].set_string_value(value, length);
+      break;
+    case PROXY_PROTO_V2_TLV_TYPE_AWS:
+      if (length > 1 && extensions_[offset] == PROXY_PROTO_V2_TLV_SUBTYPE_AWS_VPCE_ID) {
+        fields["aws_vpce_id"].set_string_value(value + 1, length - 1);
+      }
+      break;
+    default:
+      break;
+    }
+    offset += length;
+  }
+
+  if (!fields.empty()) {
+    cb_->socket().setDynamicMetadata(ListenerFilterNames::get().ProxyProtocol, metadata);
+  }
+}
+
 bool Filter::readProxyHeader(int fd) {
   while (buf_off_ < MAX_PROXY_PROTO_LEN_V2) {
     int bytes_avail;
@@ -295,7 +342,17 @@ bool Filter::readProxyHeader(int fd) {
       if (((ver_cmd & 0xf0) >> 4) != PROXY_PROTO_V2_VERSION) {
         throw EnvoyException("Unsupported V2 proxy protocol version");
       }
-      if (buf_off_ < PROXY_PROTO_V2_HEADER_LEN) {
+      // The header has been peeked, so the address length is known. If the addresses have been
+      // peeked too, which is the common case, the header and addresses are read with one recv.
+      ssize_t addr_len = lenV2Address(buf_);
+      uint8_t upper_byte = buf_[PROXY_PROTO_V2_HEADER_LEN - 2];
+      uint8_t lower_byte = buf_[PROXY_PROTO_V2_HEADER_LEN - 1];
+      ssize_t hdr_addr_len = (upper_byte << 8) + lower_byte;
+      if (hdr_addr_len < addr_len) {
+        throw EnvoyException("failed to read proxy protocol (insufficient data)");
+      }
+      if (buf_off_ < PROXY_PROTO_V2_HEADER_LEN &&
+          ssize_t(buf_off_) + nread < PROXY_PROTO_V2_HEADER_LEN + addr_len) {
         ssize_t exp = PROXY_PROTO_V2_HEADER_LEN - buf_off_;
         const Api::SysCallSizeResult read_result = os_syscalls.recv(fd, buf_ + buf_off_, exp, 0);
         if (read_result.rc_ != exp) {
@@ -304,13 +361,6 @@ bool Filter::readProxyHeader(int fd) {
         buf_off_ += read_result.rc_;
         nread -= read_result.rc_;
       }
-      ssize_t addr_len = lenV2Address(buf_);
-      uint8_t upper_byte = buf_[PROXY_PROTO_V2_HEADER_LEN - 2];
-      uint8_t lower_byte = buf_[PROXY_PROTO_V2_HEADER_LEN - 1];
-      ssize_t hdr_addr_len = (upper_byte << 8) + lower_byte;
-      if (hdr_addr_len < addr_len) {
-        throw EnvoyException("failed to read proxy protocol (insufficient data)");
-      }
       if (ssize_t(buf_off_) + nread >= PROXY_PROTO_V2_HEADER_LEN + addr_len) {
         ssize_t missing = (PROXY_PROTO_V2_HEADER_LEN + addr_len) - buf_off_;
         const Api::SysCallSizeResult read_result =
@@ -320,8 +370,8 @@ bool Filter::readProxyHeader(int fd) {
         }
         buf_off_ += read_result.rc_;
         parseV2Header(buf_);
-        // The TLV remain, they are read/discard in parseExtensions() which is called from the
-        // parent (if needed).
+        // The TLV remain, they are read in parseExtensions() which is called from the parent (if
+        // needed).
         return true;
       } else {
         const Api::SysCallSizeResult result = os_syscalls.recv(fd, buf_ + buf_off_, nread, 0);
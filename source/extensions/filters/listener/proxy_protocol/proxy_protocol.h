@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstdint>
+#include <vector>
+
 #include "envoy/event/file_event.h"
 #include "envoy/network/filter.h"
 #include "envoy/stats/scope.h"
@@ -51,7 +54,7 @@ enum ProxyProtocolVersion { Unknown = -1, InProgress = -2, V1 = 1, V2 = 2 };
  * and Proxy Protocol v2 (TCP/UDP, v4/v6).
  *
  * Non INET (AF_UNIX) address family in v2 is not supported, will throw an error.
- * Extensions (TLV) in v2 are skipped over.
+ * Known extensions (TLV) in v2 are set as dynamic metadata of the socket, others are skipped over.
  */
 class Filter : public Network::ListenerFilter, Logger::Loggable<Logger::Id::filter> {
 public:
@@ -77,10 +80,16 @@ private:
   bool readProxyHeader(int fd);
 
   /**
-   * Parse (and discard unknown) header extensions (until hdr.extensions_length == 0)
+   * Read the header extensions (until hdr.extensions_length == 0)
    */
   bool parseExtensions(int fd);
 
+  /**
+   * Set the known TLVs of the extensions that have been read as dynamic metadata on the socket,
+   * discarding the others.
+   */
+  void parseTlvs();
+
   /**
    * Given a char * & len, parse the header as per spec
    */
@@ -105,6 +114,9 @@ private:
   ConfigSharedPtr config_;
 
   absl::optional<WireHeader> proxy_protocol_header_;
+
+  // The extensions read so far.
+  std::vector<uint8_t> extensions_;
 };
 
 } // namespace ProxyProtocol
@@ -49,6 +49,16 @@ constexpr uint32_t PROXY_PROTO_V2_ADDR_LEN_UNIX = 216;
 constexpr uint8_t PROXY_PROTO_V2_TRANSPORT_STREAM = 0x1;
 constexpr uint8_t PROXY_PROTO_V2_TRANSPORT_DGRAM = 0x2;
 
+// TLV (type, 2 byte length, value) extensions exposed as dynamic metadata.
+constexpr uint32_t PROXY_PROTO_V2_TLV_HEADER_LEN = 3;
+constexpr uint8_t PROXY_PROTO_V2_TLV_TYPE_ALPN = 0x01;
+constexpr uint8_t PROXY_PROTO_V2_TLV_TYPE_AUTHORITY = 0x02;
+constexpr uint8_t PROXY_PROTO_V2_TLV_TYPE_NETNS = 0x30;
+// AWS TLVs start with a subtype byte. The VPC endpoint id subtype holds the id of the endpoint the
+// connection came through.
+constexpr uint8_t PROXY_PROTO_V2_TLV_TYPE_AWS = 0xea;
+constexpr uint8_t PROXY_PROTO_V2_TLV_SUBTYPE_AWS_VPCE_ID = 0x01;
+
 } // namespace ProxyProtocol
 } // namespace ListenerFilters
 } // namespace Extensions
@@ -0,0 +1,272 @@
+#include "extensions/filters/listener/tls_inspector/client_hello_parser.h"
+
+#include <algorithm>
+
+#include "common/common/assert.h"
+
+#include "openssl/ssl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace ListenerFilters {
+namespace TlsInspector {
+
+ClientHelloParser::Result ClientHelloParser::parse(const uint8_t* data, size_t len) {
+  while (result_ == Result::NeedMoreData && parseRecordHeaders(data, len) &&
+         parseElement(data, len)) {
+  }
+  return result_;
+}
+
+bool ClientHelloParser::parseRecordHeaders(const uint8_t* data, size_t len) {
+  // Only the records holding the ClientHello are parsed, as a client may send other records right
+  // after it, such as early data.
+  while (fragments_length_ < handshake_length_ && next_record_ + RecordHeaderSize <= len) {
+    CBS header;
+    CBS_init(&header, data + next_record_, RecordHeaderSize);
+    uint8_t type;
+    uint16_t version;
+    uint16_t length;
+    if (!CBS_get_u8(&header, &type) || !CBS_get_u16(&header, &version) ||
+        !CBS_get_u16(&header, &length) || type != SSL3_RT_HANDSHAKE ||
+        (version >> 8) != SSL3_VERSION_MAJOR || length == 0 ||
+        length > SSL3_RT_MAX_PLAIN_LENGTH) {
+      return finish(Result::NotClientHello);
+    }
+
+    const uint64_t begin = next_record_ + RecordHeaderSize;
+    fragments_.push_back({begin, begin + length});
+    fragments_length_ += length;
+    next_record_ = begin + length;
+  }
+  return true;
+}
+
+bool ClientHelloParser::read(const uint8_t* data, size_t len, uint64_t length, CBS& out) {
+  if (offset_ + length > handshake_length_) {
+    // The element overflows the handshake message.
+    return finish(Result::NotClientHello);
+  }
+  if (length == 0) {
+    CBS_init(&out, nullptr, 0);
+    return true;
+  }
+
+  // Find the fragment holding the start of the element. It almost always holds the whole element,
+  // which is then used in place.
+  uint64_t fragment_offset = 0;
+  for (const Fragment& fragment : fragments_) {
+    const uint64_t fragment_length = fragment.end_ - fragment.begin_;
+    if (offset_ < fragment_offset + fragment_length) {
+      if (offset_ + length > fragment_offset + fragment_length) {
+        break;
+      }
+      const uint64_t begin = fragment.begin_ + offset_ - fragment_offset;
+      if (begin + length > len) {
+        return false;
+      }
+      CBS_init(&out, data + begin, length);
+      return true;
+    }
+    fragment_offset += fragment_length;
+  }
+
+  // The element is split between records, or its records were not received yet.
+  reassembled_.clear();
+  fragment_offset = 0;
+  for (const Fragment& fragment : fragments_) {
+    const uint64_t fragment_length = fragment.end_ - fragment.begin_;
+    const uint64_t next = offset_ + reassembled_.size();
+    if (next < fragment_offset + fragment_length) {
+      const uint64_t begin = fragment.begin_ + next - fragment_offset;
+      const uint64_t end =
+          std::min<uint64_t>(fragment.end_, begin + length - reassembled_.size());
+      if (end > len) {
+        return false;
+      }
+      reassembled_.insert(reassembled_.end(), data + begin, data + end);
+      if (reassembled_.size() == length) {
+        CBS_init(&out, reassembled_.data(), length);
+        return true;
+      }
+    }
+    fragment_offset += fragment_length;
+  }
+  return false;
+}
+
+bool ClientHelloParser::parseElement(const uint8_t* data, size_t len) {
+  CBS element;
+  switch (state_) {
+  case State::HandshakeHeader: {
+    uint8_t type;
+    uint32_t length;
+    if (!read(data, len, HandshakeHeaderSize, element)) {
+      return false;
+    }
+    if (!CBS_get_u8(&element, &type) || !CBS_get_u24(&element, &length) ||
+        type != SSL3_MT_CLIENT_HELLO) {
+      return finish(Result::NotClientHello);
+    }
+    handshake_length_ = HandshakeHeaderSize + length;
+    return advance(HandshakeHeaderSize, State::Random);
+  }
+
+  case State::Random:
+    // The legacy_version and random fields are not needed.
+    return advance(2 + SSL3_RANDOM_SIZE, State::SessionId);
+
+  case State::SessionId:
+  case State::CompressionMethods: {
+    // Both are short vectors with an 8 bit length, which are read whole.
+    if (!read(data, len, 1, element)) {
+      return false;
+    }
+    const uint8_t length = CBS_data(&element)[0];
+    if ((state_ == State::SessionId && length > SSL_MAX_SSL_SESSION_ID_LENGTH) ||
+        (state_ == State::CompressionMethods && length == 0)) {
+      return finish(Result::NotClientHello);
+    }
+    if (!read(data, len, 1 + length, element)) {
+      return false;
+    }
+    return advance(1 + length, state_ == State::SessionId ? State::CipherSuites
+                                                          : State::ExtensionsLength);
+  }
+
+  case State::CipherSuites: {
+    uint16_t length;
+    if (!read(data, len, 2, element)) {
+      return false;
+    }
+    if (!CBS_get_u16(&element, &length) || length < 2 || length % 2 != 0) {
+      return finish(Result::NotClientHello);
+    }
+    return advance(2 + length, State::CompressionMethods);
+  }
+
+  case State::ExtensionsLength: {
+    if (offset_ == handshake_length_) {
+      // A ClientHello without extensions.
+      return finish(Result::ClientHello);
+    }
+    uint16_t length;
+    if (!read(data, len, 2, element)) {
+      return false;
+    }
+    if (!CBS_get_u16(&element, &length) || offset_ + 2 + length != handshake_length_) {
+      return finish(Result::NotClientHello);
+    }
+    extensions_end_ = handshake_length_;
+    return advance(2, State::ExtensionHeader);
+  }
+
+  case State::ExtensionHeader: {
+    if (offset_ == extensions_end_) {
+      return finish(Result::ClientHello);
+    }
+    uint16_t type;
+    uint16_t length;
+    if (!read(data, len, 4, element)) {
+      return false;
+    }
+    if (!CBS_get_u16(&element, &type) || !CBS_get_u16(&element, &length) ||
+        offset_ + 4 + length > extensions_end_) {
+      return finish(Result::NotClientHello);
+    }
+    if (type != TLSEXT_TYPE_server_name &&
+        type != TLSEXT_TYPE_application_layer_protocol_negotiation) {
+      return advance(4 + length, State::ExtensionHeader);
+    }
+    extension_type_ = type;
+    extension_length_ = length;
+    return advance(4, State::Extension);
+  }
+
+  case State::Extension: {
+    if (!read(data, len, extension_length_, element)) {
+      return false;
+    }
+    if (extension_type_ == TLSEXT_TYPE_server_name) {
+      if (server_name_parsed_ || !parseServerName(element)) {
+        return finish(Result::NotClientHello);
+      }
+      server_name_parsed_ = true;
+    } else {
+      if (alpn_parsed_) {
+        return finish(Result::NotClientHello);
+      }
+      parseApplicationProtocols(element);
+      alpn_parsed_ = true;
+    }
+    if (server_name_parsed_ && alpn_parsed_) {
+      // The other extensions are of no interest.
+      offset_ += extension_length_;
+      return finish(Result::ClientHello);
+    }
+    return advance(extension_length_, State::ExtensionHeader);
+  }
+
+  case State::Done:
+    break;
+  }
+
+  NOT_REACHED_GCOVR_EXCL_LINE;
+}
+
+bool ClientHelloParser::advance(uint64_t length, State next) {
+  if (offset_ + length > handshake_length_) {
+    return finish(Result::NotClientHello);
+  }
+  offset_ += length;
+  state_ = next;
+  return true;
+}
+
+bool ClientHelloParser::finish(Result result) {
+  result_ = result;
+  state_ = State::Done;
+  return false;
+}
+
+bool ClientHelloParser::parseServerName(CBS& extension) {
+  // As BoringSSL, only accept a single host name.
+  CBS server_name_list;
+  uint8_t name_type;
+  CBS host_name;
+  if (!CBS_get_u16_length_prefixed(&extension, &server_name_list) || CBS_len(&extension) != 0 ||
+      !CBS_get_u8(&server_name_list, &name_type) ||
+      !CBS_get_u16_length_prefixed(&server_name_list, &host_name) ||
+      CBS_len(&server_name_list) != 0 || name_type != TLSEXT_NAMETYPE_host_name ||
+      CBS_len(&host_name) == 0 || CBS_len(&host_name) > TLSEXT_MAXLEN_host_name ||
+      CBS_contains_zero_byte(&host_name)) {
+    return false;
+  }
+  server_name_.assign(reinterpret_cast<const char*>(CBS_data(&host_name)), CBS_len(&host_name));
+  return true;
+}
+
+void ClientHelloParser::parseApplicationProtocols(CBS& extension) {
+  CBS list;
+  if (!CBS_get_u16_length_prefixed(&extension, &list) || CBS_len(&extension) != 0 ||
+      CBS_len(&list) < 2) {
+    // Don't produce errors, let the real TLS stack do it.
+    return;
+  }
+  std::vector<std::string> protocols;
+  while (CBS_len(&list) > 0) {
+    CBS name;
+    if (!CBS_get_u8_length_prefixed(&list, &name) || CBS_len(&name) == 0) {
+      // Don't produce errors, let the real TLS stack do it.
+      return;
+    }
+    protocols.emplace_back(reinterpret_cast<const char*>(CBS_data(&name)), CBS_len(&name));
+  }
+  application_protocols_ = std::move(protocols);
+  alpn_found_ = true;
+}
+
+} // namespace TlsInspector
+} // namespace ListenerFilters
+} // namespace Extensions
+} // namespace Envoy
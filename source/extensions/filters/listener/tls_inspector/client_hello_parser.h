@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "openssl/bytestring.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace ListenerFilters {
+namespace TlsInspector {
+
+/**
+ * Incremental parser of the TLS records carrying a ClientHello, which only extracts the Server Name
+ * Indication and the Application-Layer Protocol Negotiation list. It is fed the bytes received
+ * from the start of the connection every time more of them are available, as they are peeked
+ * rather than read, and resumes where it stopped on the previous call. Parsing stops as soon as
+ * both extensions are found, and the extensions it doesn't need are skipped without being
+ * validated, which is left to the TLS stack terminating the connection.
+ *
+ * The handshake message is not copied unless it is fragmented over several records.
+ */
+class ClientHelloParser {
+public:
+  enum class Result {
+    // The data ends before the parsing is complete.
+    NeedMoreData,
+    // The data starts with a ClientHello.
+    ClientHello,
+    // The data is not a TLS ClientHello.
+    NotClientHello
+  };
+
+  /**
+   * Parses the data received so far.
+   * @param data the data received from the start of the connection. Data passed to previous calls
+   *        must be a prefix of it.
+   * @param len the length of the data.
+   * @return Result the outcome of the parsing. Once it is not NeedMoreData, further calls return
+   *         the same outcome.
+   */
+  Result parse(const uint8_t* data, size_t len);
+
+  /**
+   * @return the server name of the SNI extension, or an empty string if there was none.
+   */
+  const std::string& serverName() const { return server_name_; }
+
+  /**
+   * @return whether a well formed ALPN extension was found.
+   */
+  bool alpnFound() const { return alpn_found_; }
+
+  /**
+   * @return the protocols of the ALPN extension.
+   */
+  const std::vector<std::string>& applicationProtocols() const { return application_protocols_; }
+
+  /**
+   * @return the number of bytes of the handshake message which were parsed.
+   */
+  uint64_t bytesParsed() const { return offset_; }
+
+  static constexpr size_t RecordHeaderSize = 5;
+  static constexpr size_t HandshakeHeaderSize = 4;
+
+private:
+  enum class State {
+    HandshakeHeader,
+    Random,
+    SessionId,
+    CipherSuites,
+    CompressionMethods,
+    ExtensionsLength,
+    ExtensionHeader,
+    Extension,
+    Done
+  };
+
+  // A part of the handshake message, in the fragment of a record.
+  struct Fragment {
+    uint64_t begin_;
+    uint64_t end_;
+  };
+
+  // Each of these returns whether the parsing can go on. When it can't, result_ is set if the
+  // parsing is over, otherwise more data is needed.
+  bool parseRecordHeaders(const uint8_t* data, size_t len);
+  bool parseElement(const uint8_t* data, size_t len);
+  bool read(const uint8_t* data, size_t len, uint64_t length, CBS& out);
+  bool advance(uint64_t length, State next);
+  bool finish(Result result);
+
+  bool parseServerName(CBS& extension);
+  void parseApplicationProtocols(CBS& extension);
+
+  State state_{State::HandshakeHeader};
+  Result result_{Result::NeedMoreData};
+  // The offset in the handshake message of the next element to parse.
+  uint64_t offset_{0};
+  // The length of the handshake message, or of its header until it is parsed.
+  uint64_t handshake_length_{HandshakeHeaderSize};
+  uint64_t extensions_end_{0};
+  uint16_t extension_type_{0};
+  uint64_t extension_length_{0};
+  // The parts of the handshake message in the record fragments whose header was parsed.
+  std::vector<Fragment> fragments_;
+  uint64_t next_record_{0};
+  uint64_t fragments_length_{0};
+  // Holds the elements split between two records.
+  std::vector<uint8_t> reassembled_;
+
+  bool server_name_parsed_{false};
+  std::string server_name_;
+  bool alpn_found_{false};
+  bool alpn_parsed_{false};
+  std::vector<std::string> application_protocols_;
+};
+
+} // namespace TlsInspector
+} // namespace ListenerFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,34 @@
+#include "extensions/filters/network/dynamic_module/config.h"
+
+#include "envoy/config/filter/network/dynamic_module/v2alpha/dynamic_module.pb.validate.h"
+#include "envoy/registry/registry.h"
+
+#include "extensions/filters/network/dynamic_module/dynamic_module_filter.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace NetworkFilters {
+namespace DynamicModuleFilter {
+
+Network::FilterFactoryCb DynamicModuleConfigFactory::createFilterFactoryFromProtoTyped(
+    const envoy::config::filter::network::dynamic_module::v2alpha::DynamicModule& proto_config,
+    Server::Configuration::FactoryContext& context) {
+  Filters::Common::DynamicModule::ModuleSharedPtr module =
+      std::make_shared<Filters::Common::DynamicModule::Module>(
+          proto_config.path(), proto_config.config(), context.threadLocal());
+  return [module](Network::FilterManager& filter_manager) -> void {
+    filter_manager.addFilter(std::make_shared<Filter>(module));
+  };
+}
+
+/**
+ * Static registration for the dynamic module filter. @see RegisterFactory.
+ */
+static Registry::RegisterFactory<DynamicModuleConfigFactory,
+                                 Server::Configuration::NamedNetworkFilterConfigFactory>
+    registered_;
+
+} // namespace DynamicModuleFilter
+} // namespace NetworkFilters
+} // namespace Extensions
+} // namespace Envoy
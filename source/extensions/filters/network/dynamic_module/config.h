@@ -0,0 +1,31 @@
+#pragma once
+
+#include "envoy/config/filter/network/dynamic_module/v2alpha/dynamic_module.pb.h"
+
+#include "extensions/filters/network/common/factory_base.h"
+#include "extensions/filters/network/well_known_names.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace NetworkFilters {
+namespace DynamicModuleFilter {
+
+/**
+ * Config registration for the dynamic module filter. @see NamedNetworkFilterConfigFactory.
+ */
+class DynamicModuleConfigFactory
+    : public Common::FactoryBase<
+          envoy::config::filter::network::dynamic_module::v2alpha::DynamicModule> {
+public:
+  DynamicModuleConfigFactory() : FactoryBase(NetworkFilterNames::get().DynamicModule) {}
+
+private:
+  Network::FilterFactoryCb createFilterFactoryFromProtoTyped(
+      const envoy::config::filter::network::dynamic_module::v2alpha::DynamicModule& proto_config,
+      Server::Configuration::FactoryContext& context) override;
+};
+
+} // namespace DynamicModuleFilter
+} // namespace NetworkFilters
+} // namespace Extensions
+} // namespace Envoy
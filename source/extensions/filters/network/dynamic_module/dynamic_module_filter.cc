@@ -0,0 +1,54 @@
+#include "extensions/filters/network/dynamic_module/dynamic_module_filter.h"
+
+#include "envoy/network/connection.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace NetworkFilters {
+namespace DynamicModuleFilter {
+
+Filter::Filter(Filters::Common::DynamicModule::ModuleSharedPtr module)
+    : module_(module), connection_(module->callbacks().on_network_connection_create_ != nullptr
+                                       ? module->callbacks().on_network_connection_create_(
+                                             module->workerContext())
+                                       : module->workerContext()) {}
+
+Filter::~Filter() {
+  if (module_->callbacks().on_network_connection_destroy_ != nullptr) {
+    module_->callbacks().on_network_connection_destroy_(connection_);
+  }
+}
+
+void Filter::closeConnection() {
+  if (!closed_) {
+    closed_ = true;
+    read_callbacks_->connection().close(Network::ConnectionCloseType::NoFlush);
+  }
+}
+
+bool Filter::run(envoy_dynamic_module_on_network_data_fn callback, Buffer::Instance& data,
+                 bool end_stream) {
+  if (callback != nullptr && !closed_) {
+    data_ = &data;
+    callback(connection_, handle(), end_stream);
+    data_ = nullptr;
+  }
+  return closed_;
+}
+
+Network::FilterStatus Filter::onData(Buffer::Instance& data, bool end_stream) {
+  return run(module_->callbacks().on_network_read_, data, end_stream)
+             ? Network::FilterStatus::StopIteration
+             : Network::FilterStatus::Continue;
+}
+
+Network::FilterStatus Filter::onWrite(Buffer::Instance& data, bool end_stream) {
+  return run(module_->callbacks().on_network_write_, data, end_stream)
+             ? Network::FilterStatus::StopIteration
+             : Network::FilterStatus::Continue;
+}
+
+} // namespace DynamicModuleFilter
+} // namespace NetworkFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "envoy/network/filter.h"
+
+#include "extensions/filters/common/dynamic_module/dynamic_module.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace NetworkFilters {
+namespace DynamicModuleFilter {
+
+/**
+ * Network dynamic module filter. Each connection creates its own context of the module on the
+ * worker, and runs the data read and written through the callbacks of the module.
+ */
+class Filter : public Network::Filter, public Filters::Common::DynamicModule::HostContext {
+public:
+  Filter(Filters::Common::DynamicModule::ModuleSharedPtr module);
+  ~Filter();
+
+  // Filters::Common::DynamicModule::HostContext
+  Buffer::Instance* data() override { return data_; }
+  void closeConnection() override;
+
+  // Network::ReadFilter
+  Network::FilterStatus onData(Buffer::Instance& data, bool end_stream) override;
+  Network::FilterStatus onNewConnection() override { return Network::FilterStatus::Continue; }
+  void initializeReadFilterCallbacks(Network::ReadFilterCallbacks& callbacks) override {
+    read_callbacks_ = &callbacks;
+  }
+
+  // Network::WriteFilter
+  Network::FilterStatus onWrite(Buffer::Instance& data, bool end_stream) override;
+
+private:
+  // Runs a callback of the module, which can only access the given data. Returns whether the
+  // module closed the connection.
+  bool run(envoy_dynamic_module_on_network_data_fn callback, Buffer::Instance& data,
+           bool end_stream);
+
+  const Filters::Common::DynamicModule::ModuleSharedPtr module_;
+  void* connection_;
+  Network::ReadFilterCallbacks* read_callbacks_{};
+  Buffer::Instance* data_{};
+  bool closed_{};
+};
+
+} // namespace DynamicModuleFilter
+} // namespace NetworkFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -29,7 +29,7 @@ namespace NetworkFilters {
 namespace HttpConnectionManager {
 namespace {
 
-typedef std::list<Http::FilterFactoryCb> FilterFactoriesList;
+typedef std::list<HttpFilterFactory> FilterFactoriesList;
 typedef std::map<std::string, std::unique_ptr<FilterFactoriesList>> FilterFactoryMap;
 
 FilterFactoryMap::const_iterator findUpgradeCaseInsensitive(const FilterFactoryMap& upgrade_map,
@@ -136,7 +136,13 @@ HttpConnectionManagerConfig::HttpConnectionManagerConfig(
       date_provider_(date_provider),
       listener_stats_(Http::ConnectionManagerImpl::generateListenerStats(stats_prefix_,
                                                                          context_.listenerScope())),
-      proxy_100_continue_(config.proxy_100_continue()) {
+      proxy_100_continue_(config.proxy_100_continue()),
+      per_stream_arena_(config.per_stream_arena()),
+      filter_timing_sampling_(config.has_filter_timing_sampling()
+                                  ? absl::optional<uint64_t>(
+                                        PROTOBUF_PERCENT_TO_ROUNDED_INTEGER_OR_DEFAULT(
+                                            config, filter_timing_sampling, 10000, 0))
+                                  : absl::nullopt) {
 
   route_config_provider_ = Router::RouteConfigProviderUtil::create(config, context_, stats_prefix_,
                                                                    route_config_provider_manager_);
@@ -213,9 +219,19 @@ HttpConnectionManagerConfig::HttpConnectionManagerConfig(
     uint64_t overall_sampling{
         PROTOBUF_PERCENT_TO_ROUNDED_INTEGER_OR_DEFAULT(tracing_config, overall_sampling, 100, 100)};
 
+    absl::optional<Http::TailSamplingConfig> tail_sampling;
+    if (tracing_config.has_tail_sampling()) {
+      const auto& tail_sampling_config = tracing_config.tail_sampling();
+      tail_sampling = Http::TailSamplingConfig{
+          PROTOBUF_GET_OPTIONAL_MS(tail_sampling_config, latency_threshold),
+          PROTOBUF_GET_WRAPPED_OR_DEFAULT(tail_sampling_config, errors, true),
+          PROTOBUF_PERCENT_TO_ROUNDED_INTEGER_OR_DEFAULT(tail_sampling_config, random_sampling,
+                                                         10000, 0)};
+    }
+
     tracing_config_.reset(new Http::TracingConnectionManagerConfig(
         {tracing_operation_name, request_headers_for_tags, client_sampling, random_sampling,
-         overall_sampling}));
+         overall_sampling, tail_sampling}));
   }
 
   for (const auto& access_log : config.access_log()) {
@@ -271,7 +287,7 @@ HttpConnectionManagerConfig::HttpConnectionManagerConfig(
 
 void HttpConnectionManagerConfig::processFilter(
     const envoy::config::filter::network::http_connection_manager::v2::HttpFilter& proto_config,
-    int i, absl::string_view prefix, std::list<Http::FilterFactoryCb>& filter_factories) {
+    int i, absl::string_view prefix, FilterFactoriesList& filter_factories) {
   const ProtobufTypes::String& string_name = proto_config.name();
 
   ENVOY_LOG(debug, "    {} filter #{}", prefix, i);
@@ -294,7 +310,12 @@ void HttpConnectionManagerConfig::processFilter(
         Config::Utility::translateToFactoryConfig(proto_config, factory);
     callback = factory.createFilterFactoryFromProto(*message, stats_prefix_, context_);
   }
-  filter_factories.push_back(callback);
+  FilterTimingStatsSharedPtr timing_stats;
+  if (filter_timing_sampling_) {
+    timing_stats = generateFilterTimingStats(
+        fmt::format("{}filter_timing.{}.", stats_prefix_, string_name), context_.scope());
+  }
+  filter_factories.push_back({callback, timing_stats});
 }
 
 Http::ServerConnectionPtr
@@ -323,8 +344,25 @@ HttpConnectionManagerConfig::createCodec(Network::Connection& connection,
 }
 
 void HttpConnectionManagerConfig::createFilterChain(Http::FilterChainFactoryCallbacks& callbacks) {
-  for (const Http::FilterFactoryCb& factory : filter_factories_) {
-    factory(callbacks);
+  createFilterChain(filter_factories_, callbacks);
+}
+
+void HttpConnectionManagerConfig::createFilterChain(const FilterFactoriesList& filter_factories,
+                                                    Http::FilterChainFactoryCallbacks& callbacks) {
+  if (filter_timing_sampling_ &&
+      context_.runtime().snapshot().featureEnabled(
+          "http_connection_manager.filter_timing_sampling", filter_timing_sampling_.value(),
+          context_.random().random(), 10000)) {
+    TimedFilterChainFactoryCallbacks timed_callbacks(callbacks, context_.timeSource());
+    for (const HttpFilterFactory& factory : filter_factories) {
+      timed_callbacks.setStats(*factory.timing_stats_);
+      factory.callback_(timed_callbacks);
+    }
+    return;
+  }
+
+  for (const HttpFilterFactory& factory : filter_factories) {
+    factory.callback_(callbacks);
   }
 }
 
@@ -338,9 +376,7 @@ bool HttpConnectionManagerConfig::createUpgradeFilterChain(
     } else {
       filters_to_use = &filter_factories_;
     }
-    for (const Http::FilterFactoryCb& factory : *filters_to_use) {
-      factory(callbacks);
-    }
+    createFilterChain(*filters_to_use, callbacks);
     return true;
   }
   return false;
@@ -16,6 +16,7 @@
 #include "common/json/json_loader.h"
 
 #include "extensions/filters/network/common/factory_base.h"
+#include "extensions/filters/network/http_connection_manager/filter_timing.h"
 #include "extensions/filters/network/well_known_names.h"
 
 namespace Envoy {
@@ -60,6 +61,15 @@ public:
                                            const Buffer::Instance& data);
 };
 
+/**
+ * The factory of an HTTP filter configuration, along with the timing stats of the filters it
+ * creates if filter timing is enabled.
+ */
+struct HttpFilterFactory {
+  Http::FilterFactoryCb callback_;
+  FilterTimingStatsSharedPtr timing_stats_;
+};
+
 /**
  * Maps proto config to runtime config for an HTTP connection manager network filter.
  */
@@ -109,13 +119,16 @@ public:
   Http::ConnectionManagerListenerStats& listenerStats() override { return listener_stats_; }
   bool proxy100Continue() const override { return proxy_100_continue_; }
   const Http::Http1Settings& http1Settings() const override { return http1_settings_; }
+  bool perStreamArena() const override { return per_stream_arena_; }
 
 private:
-  typedef std::list<Http::FilterFactoryCb> FilterFactoriesList;
+  typedef std::list<HttpFilterFactory> FilterFactoriesList;
   enum class CodecType { HTTP1, HTTP2, AUTO };
   void processFilter(
       const envoy::config::filter::network::http_connection_manager::v2::HttpFilter& proto_config,
       int i, absl::string_view prefix, FilterFactoriesList& filter_factories);
+  void createFilterChain(const FilterFactoriesList& filter_factories,
+                         Http::FilterChainFactoryCallbacks& callbacks);
 
   Server::Configuration::FactoryContext& context_;
   FilterFactoriesList filter_factories_;
@@ -145,6 +158,9 @@ private:
   Http::DateProvider& date_provider_;
   Http::ConnectionManagerListenerStats listener_stats_;
   const bool proxy_100_continue_;
+  const bool per_stream_arena_;
+  // Set if a sample of the streams record the time spent in their filters, in 0.01% increments.
+  const absl::optional<uint64_t> filter_timing_sampling_;
 
   // Default idle timeout is 5 minutes if nothing is specified in the HCM config.
   static const uint64_t StreamIdleTimeoutMs = 5 * 60 * 1000;
@@ -0,0 +1,82 @@
+#include "extensions/filters/network/http_connection_manager/filter_timing.h"
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace NetworkFilters {
+namespace HttpConnectionManager {
+
+void TimedStreamFilter::onDestroy() {
+  if (decoder_filter_ != nullptr) {
+    decoder_filter_->onDestroy();
+  } else {
+    encoder_filter_->onDestroy();
+  }
+}
+
+Http::FilterHeadersStatus TimedStreamFilter::decodeHeaders(Http::HeaderMap& headers,
+                                                           bool end_stream) {
+  return timed(stats_.decode_time_us_,
+               [&]() { return decoder_filter_->decodeHeaders(headers, end_stream); });
+}
+
+Http::FilterDataStatus TimedStreamFilter::decodeData(Buffer::Instance& data, bool end_stream) {
+  return timed(stats_.decode_time_us_,
+               [&]() { return decoder_filter_->decodeData(data, end_stream); });
+}
+
+Http::FilterTrailersStatus TimedStreamFilter::decodeTrailers(Http::HeaderMap& trailers) {
+  return timed(stats_.decode_time_us_, [&]() { return decoder_filter_->decodeTrailers(trailers); });
+}
+
+Http::FilterHeadersStatus TimedStreamFilter::encode100ContinueHeaders(Http::HeaderMap& headers) {
+  return timed(stats_.encode_time_us_,
+               [&]() { return encoder_filter_->encode100ContinueHeaders(headers); });
+}
+
+Http::FilterHeadersStatus TimedStreamFilter::encodeHeaders(Http::HeaderMap& headers,
+                                                           bool end_stream) {
+  return timed(stats_.encode_time_us_,
+               [&]() { return encoder_filter_->encodeHeaders(headers, end_stream); });
+}
+
+Http::FilterDataStatus TimedStreamFilter::encodeData(Buffer::Instance& data, bool end_stream) {
+  return timed(stats_.encode_time_us_,
+               [&]() { return encoder_filter_->encodeData(data, end_stream); });
+}
+
+Http::FilterTrailersStatus TimedStreamFilter::encodeTrailers(Http::HeaderMap& trailers) {
+  return timed(stats_.encode_time_us_, [&]() { return encoder_filter_->encodeTrailers(trailers); });
+}
+
+void TimedFilterChainFactoryCallbacks::addStreamDecoderFilter(
+    Http::StreamDecoderFilterSharedPtr filter) {
+  ASSERT(stats_ != nullptr);
+  callbacks_.addStreamDecoderFilter(
+      std::make_shared<TimedStreamFilter>(filter, nullptr, *stats_, time_source_));
+}
+
+void TimedFilterChainFactoryCallbacks::addStreamEncoderFilter(
+    Http::StreamEncoderFilterSharedPtr filter) {
+  ASSERT(stats_ != nullptr);
+  callbacks_.addStreamEncoderFilter(
+      std::make_shared<TimedStreamFilter>(nullptr, filter, *stats_, time_source_));
+}
+
+void TimedFilterChainFactoryCallbacks::addStreamFilter(Http::StreamFilterSharedPtr filter) {
+  ASSERT(stats_ != nullptr);
+  callbacks_.addStreamFilter(
+      std::make_shared<TimedStreamFilter>(filter, filter, *stats_, time_source_));
+}
+
+FilterTimingStatsSharedPtr generateFilterTimingStats(const std::string& prefix,
+                                                     Stats::Scope& scope) {
+  return std::make_shared<FilterTimingStats>(
+      FilterTimingStats{ALL_HTTP_FILTER_TIMING_STATS(POOL_HISTOGRAM_PREFIX(scope, prefix))});
+}
+
+} // namespace HttpConnectionManager
+} // namespace NetworkFilters
+} // namespace Extensions
+} // namespace Envoy
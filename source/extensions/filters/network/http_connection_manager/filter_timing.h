@@ -0,0 +1,127 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+
+#include "envoy/common/time.h"
+#include "envoy/http/filter.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace NetworkFilters {
+namespace HttpConnectionManager {
+
+/**
+ * All the timing stats of an HTTP filter. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_HTTP_FILTER_TIMING_STATS(HISTOGRAM)                                                    \
+  HISTOGRAM(decode_time_us)                                                                        \
+  HISTOGRAM(encode_time_us)
+// clang-format on
+
+/**
+ * Struct definition for all the timing stats of an HTTP filter. @see stats_macros.h
+ */
+struct FilterTimingStats {
+  ALL_HTTP_FILTER_TIMING_STATS(GENERATE_HISTOGRAM_STRUCT)
+};
+
+typedef std::shared_ptr<FilterTimingStats> FilterTimingStatsSharedPtr;
+
+/**
+ * Wraps a filter of a stream sampled for filter timing, recording the time spent in each of its
+ * decoding and encoding callbacks. The filter is given the callbacks of the stream directly, so
+ * that only the calls from the connection manager go through the wrapper.
+ */
+class TimedStreamFilter : public Http::StreamFilter {
+public:
+  TimedStreamFilter(Http::StreamDecoderFilterSharedPtr decoder_filter,
+                    Http::StreamEncoderFilterSharedPtr encoder_filter, FilterTimingStats& stats,
+                    TimeSource& time_source)
+      : decoder_filter_(decoder_filter), encoder_filter_(encoder_filter), stats_(stats),
+        time_source_(time_source) {}
+
+  // Http::StreamFilterBase
+  void onDestroy() override;
+
+  // Http::StreamDecoderFilter
+  Http::FilterHeadersStatus decodeHeaders(Http::HeaderMap& headers, bool end_stream) override;
+  Http::FilterDataStatus decodeData(Buffer::Instance& data, bool end_stream) override;
+  Http::FilterTrailersStatus decodeTrailers(Http::HeaderMap& trailers) override;
+  void setDecoderFilterCallbacks(Http::StreamDecoderFilterCallbacks& callbacks) override {
+    decoder_filter_->setDecoderFilterCallbacks(callbacks);
+  }
+
+  // Http::StreamEncoderFilter
+  Http::FilterHeadersStatus encode100ContinueHeaders(Http::HeaderMap& headers) override;
+  Http::FilterHeadersStatus encodeHeaders(Http::HeaderMap& headers, bool end_stream) override;
+  Http::FilterDataStatus encodeData(Buffer::Instance& data, bool end_stream) override;
+  Http::FilterTrailersStatus encodeTrailers(Http::HeaderMap& trailers) override;
+  void setEncoderFilterCallbacks(Http::StreamEncoderFilterCallbacks& callbacks) override {
+    encoder_filter_->setEncoderFilterCallbacks(callbacks);
+  }
+
+private:
+  template <class Call> auto timed(Stats::Histogram& histogram, Call call) -> decltype(call()) {
+    const MonotonicTime start = time_source_.monotonicTime();
+    const auto status = call();
+    histogram.recordValue(std::chrono::duration_cast<std::chrono::microseconds>(
+                              time_source_.monotonicTime() - start)
+                              .count());
+    return status;
+  }
+
+  // Either filter may be null, or both may be the same filter.
+  const Http::StreamDecoderFilterSharedPtr decoder_filter_;
+  const Http::StreamEncoderFilterSharedPtr encoder_filter_;
+  FilterTimingStats& stats_;
+  TimeSource& time_source_;
+};
+
+/**
+ * Filter chain factory callbacks of a stream sampled for filter timing, which wrap the filters
+ * added to the stream in TimedStreamFilters recording their time in the stats of the filter
+ * configuration which created them.
+ */
+class TimedFilterChainFactoryCallbacks : public Http::FilterChainFactoryCallbacks {
+public:
+  TimedFilterChainFactoryCallbacks(Http::FilterChainFactoryCallbacks& callbacks,
+                                   TimeSource& time_source)
+      : callbacks_(callbacks), time_source_(time_source) {}
+
+  /**
+   * @param stats supplies the stats of the filters added next, i.e. the ones of the filter
+   *        configuration whose factory is about to be called.
+   */
+  void setStats(FilterTimingStats& stats) { stats_ = &stats; }
+
+  // Http::FilterChainFactoryCallbacks
+  void addStreamDecoderFilter(Http::StreamDecoderFilterSharedPtr filter) override;
+  void addStreamEncoderFilter(Http::StreamEncoderFilterSharedPtr filter) override;
+  void addStreamFilter(Http::StreamFilterSharedPtr filter) override;
+  void addAccessLogHandler(AccessLog::InstanceSharedPtr handler) override {
+    callbacks_.addAccessLogHandler(handler);
+  }
+  Arena* arena() override { return callbacks_.arena(); }
+
+private:
+  Http::FilterChainFactoryCallbacks& callbacks_;
+  TimeSource& time_source_;
+  FilterTimingStats* stats_{};
+};
+
+/**
+ * @return FilterTimingStatsSharedPtr the timing stats of an HTTP filter.
+ * @param prefix supplies the prefix of the stats, including the name of the filter.
+ * @param scope supplies the scope of the stats.
+ */
+FilterTimingStatsSharedPtr generateFilterTimingStats(const std::string& prefix,
+                                                     Stats::Scope& scope);
+
+} // namespace HttpConnectionManager
+} // namespace NetworkFilters
+} // namespace Extensions
+} // namespace Envoy
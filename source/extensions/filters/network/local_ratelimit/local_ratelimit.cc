@@ -0,0 +1,47 @@
+#include "extensions/filters/network/local_ratelimit/local_ratelimit.h"
+
+#include <string>
+
+#include "envoy/network/connection.h"
+
+#include "common/common/fmt.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace NetworkFilters {
+namespace LocalRateLimitFilter {
+
+Config::Config(
+    const envoy::config::filter::network::local_rate_limit::v2alpha::LocalRateLimit& config,
+    Stats::Scope& scope, Runtime::Loader& runtime, TimeSource& time_source)
+    : runtime_(runtime),
+      stats_(generateStats(fmt::format("local_ratelimit.{}.", config.stat_prefix()), scope)),
+      token_bucket_(config.token_bucket(), time_source) {}
+
+LocalRateLimitStats Config::generateStats(const std::string& prefix, Stats::Scope& scope) {
+  return {ALL_TCP_LOCAL_RATE_LIMIT_STATS(POOL_COUNTER_PREFIX(scope, prefix))};
+}
+
+Network::FilterStatus Filter::onNewConnection() {
+  if (!config_->runtime().snapshot().featureEnabled("local_ratelimit.tcp_filter_enabled", 100)) {
+    return Network::FilterStatus::Continue;
+  }
+
+  if (config_->consume()) {
+    config_->stats().ok_.inc();
+    return Network::FilterStatus::Continue;
+  }
+
+  config_->stats().rate_limited_.inc();
+  if (!config_->runtime().snapshot().featureEnabled("local_ratelimit.tcp_filter_enforcing",
+                                                    100)) {
+    return Network::FilterStatus::Continue;
+  }
+  read_callbacks_->connection().close(Network::ConnectionCloseType::NoFlush);
+  return Network::FilterStatus::StopIteration;
+}
+
+} // namespace LocalRateLimitFilter
+} // namespace NetworkFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "envoy/common/time.h"
+#include "envoy/config/filter/network/local_rate_limit/v2alpha/local_rate_limit.pb.h"
+#include "envoy/network/filter.h"
+#include "envoy/runtime/runtime.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "extensions/filters/common/local_ratelimit/local_ratelimit.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace NetworkFilters {
+namespace LocalRateLimitFilter {
+
+/**
+ * All tcp local rate limit stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_TCP_LOCAL_RATE_LIMIT_STATS(COUNTER)                                                    \
+  COUNTER(ok)                                                                                      \
+  COUNTER(rate_limited)
+// clang-format on
+
+/**
+ * Struct definition for all tcp local rate limit stats. @see stats_macros.h
+ */
+struct LocalRateLimitStats {
+  ALL_TCP_LOCAL_RATE_LIMIT_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * Global configuration for the TCP local rate limit filter, which holds the token bucket shared by
+ * all the workers.
+ */
+class Config {
+public:
+  Config(const envoy::config::filter::network::local_rate_limit::v2alpha::LocalRateLimit& config,
+         Stats::Scope& scope, Runtime::Loader& runtime, TimeSource& time_source);
+
+  Runtime::Loader& runtime() { return runtime_; }
+  LocalRateLimitStats& stats() { return stats_; }
+
+  /**
+   * @return bool whether a token of the bucket was consumed, false if the bucket is empty.
+   */
+  bool consume() { return token_bucket_.consume(); }
+
+private:
+  static LocalRateLimitStats generateStats(const std::string& prefix, Stats::Scope& scope);
+
+  Runtime::Loader& runtime_;
+  LocalRateLimitStats stats_;
+  Filters::Common::LocalRateLimit::SharedTokenBucket token_bucket_;
+};
+
+typedef std::shared_ptr<Config> ConfigSharedPtr;
+
+/**
+ * TCP local rate limit filter. Each new connection consumes a token of the bucket, and is closed
+ * without any further filters being called when the bucket is empty.
+ */
+class Filter : public Network::ReadFilter {
+public:
+  Filter(ConfigSharedPtr config) : config_(config) {}
+
+  // Network::ReadFilter
+  Network::FilterStatus onData(Buffer::Instance&, bool) override {
+    return Network::FilterStatus::Continue;
+  }
+  Network::FilterStatus onNewConnection() override;
+  void initializeReadFilterCallbacks(Network::ReadFilterCallbacks& callbacks) override {
+    read_callbacks_ = &callbacks;
+  }
+
+private:
+  ConfigSharedPtr config_;
+  Network::ReadFilterCallbacks* read_callbacks_{};
+};
+
+} // namespace LocalRateLimitFilter
+} // namespace NetworkFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -152,6 +152,18 @@ public:
   virtual void numberReturned(int32_t number_returned) PURE;
   virtual const std::list<Bson::DocumentSharedPtr>& documents() const PURE;
   virtual std::list<Bson::DocumentSharedPtr>& documents() PURE;
+
+  /**
+   * @return uint32_t the number of documents in the reply. This is valid even if the decoder
+   *         skipped the document bodies, in which case documents() is empty.
+   */
+  virtual uint32_t documentCount() const PURE;
+
+  /**
+   * @return uint64_t the total encoded size of the documents in the reply. This is valid even if
+   *         the decoder skipped the document bodies.
+   */
+  virtual uint64_t documentsByteSize() const PURE;
 };
 
 typedef std::unique_ptr<ReplyMessage> ReplyMessagePtr;
@@ -183,14 +183,32 @@ std::string QueryMessageImpl::toString(bool full) const {
       return_fields_selector_ ? return_fields_selector_->toString() : "{}");
 }
 
-void ReplyMessageImpl::fromBuffer(uint32_t, Buffer::Instance& data) {
+void ReplyMessageImpl::fromBuffer(uint32_t message_length, Buffer::Instance& data) {
   ENVOY_LOG(trace, "decoding reply message");
+  const uint64_t original_data_length = data.length();
+  ASSERT(data.length() >= message_length);
+
   flags_ = Bson::BufferHelper::removeInt32(data);
   cursor_id_ = Bson::BufferHelper::removeInt64(data);
   starting_from_ = Bson::BufferHelper::removeInt32(data);
   number_returned_ = Bson::BufferHelper::removeInt32(data);
   for (int32_t i = 0; i < number_returned_; i++) {
-    documents_.emplace_back(Bson::DocumentImpl::create(data));
+    if (!skip_documents_) {
+      documents_.emplace_back(Bson::DocumentImpl::create(data));
+      continue;
+    }
+
+    // Only the length prefix is read. The smallest document is the length plus the terminator.
+    const int32_t document_length = Bson::BufferHelper::peekInt32(data);
+    const uint64_t message_bytes_remaining =
+        data.length() - (original_data_length - message_length);
+    if (document_length < 5 || static_cast<uint64_t>(document_length) > message_bytes_remaining) {
+      throw EnvoyException("invalid BSON message length");
+    }
+
+    data.drain(document_length);
+    skipped_document_count_++;
+    skipped_documents_byte_size_ += document_length;
   }
 
   ENVOY_LOG(trace, "{}", toString(true));
@@ -219,7 +237,25 @@ std::string ReplyMessageImpl::toString(bool full) const {
       R"EOF({{"opcode": "OP_REPLY", "id": {}, "response_to": {}, "flags": "{:#x}", "cursor": "{}", )EOF"
       R"EOF("from": {}, "returned": {}, "documents": {}}})EOF",
       request_id_, response_to_, flags_, cursor_id_, starting_from_, number_returned_,
-      full ? documentListToString(documents_) : std::to_string(documents_.size()));
+      full && !skip_documents_ ? documentListToString(documents_)
+                               : std::to_string(documentCount()));
+}
+
+uint32_t ReplyMessageImpl::documentCount() const {
+  return skip_documents_ ? skipped_document_count_ : documents_.size();
+}
+
+uint64_t ReplyMessageImpl::documentsByteSize() const {
+  if (skip_documents_) {
+    return skipped_documents_byte_size_;
+  }
+
+  uint64_t byte_size = 0;
+  for (const Bson::DocumentSharedPtr& document : documents_) {
+    byte_size += document->byteSize();
+  }
+
+  return byte_size;
 }
 
 /*
@@ -368,6 +404,9 @@ bool DecoderImpl::decode(Buffer::Instance& data) {
   switch (op_code) {
   case Message::OpCode::OP_REPLY: {
     std::unique_ptr<ReplyMessageImpl> message(new ReplyMessageImpl(request_id, response_to));
+    if (skip_reply_documents_) {
+      message->skipDocuments();
+    }
     message->fromBuffer(message_length, data);
     callbacks_.decodeReply(std::move(message));
     break;
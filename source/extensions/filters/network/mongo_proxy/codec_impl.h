@@ -178,6 +178,14 @@ public:
   void numberReturned(int32_t number_returned) override { number_returned_ = number_returned; }
   const std::list<Bson::DocumentSharedPtr>& documents() const override { return documents_; }
   std::list<Bson::DocumentSharedPtr>& documents() override { return documents_; }
+  uint32_t documentCount() const override;
+  uint64_t documentsByteSize() const override;
+
+  /**
+   * Skip the document bodies when decoding from a buffer, only recording their number and size
+   * from the BSON length prefixes. Used when the documents themselves are never inspected.
+   */
+  void skipDocuments() { skip_documents_ = true; }
 
 private:
   int32_t flags_{};
@@ -185,6 +193,9 @@ private:
   int32_t starting_from_{};
   int32_t number_returned_{};
   std::list<Bson::DocumentSharedPtr> documents_;
+  bool skip_documents_{};
+  uint32_t skipped_document_count_{};
+  uint64_t skipped_documents_byte_size_{};
 };
 
 // OP_COMMAND message.
@@ -251,7 +262,13 @@ private:
 
 class DecoderImpl : public Decoder, Logger::Loggable<Logger::Id::mongo> {
 public:
-  DecoderImpl(DecoderCallbacks& callbacks) : callbacks_(callbacks) {}
+  /**
+   * @param callbacks supplies the callbacks receiving decoded messages.
+   * @param skip_reply_documents supplies whether OP_REPLY document bodies are skipped rather than
+   *        decoded, for callers that only use their count and size.
+   */
+  DecoderImpl(DecoderCallbacks& callbacks, bool skip_reply_documents = false)
+      : callbacks_(callbacks), skip_reply_documents_(skip_reply_documents) {}
 
   // Mongo::Decoder
   void onData(Buffer::Instance& data) override;
@@ -260,6 +277,7 @@ private:
   bool decode(Buffer::Instance& data);
 
   DecoderCallbacks& callbacks_;
+  const bool skip_reply_documents_;
 };
 
 class EncoderImpl : public Encoder, Logger::Loggable<Logger::Id::mongo> {
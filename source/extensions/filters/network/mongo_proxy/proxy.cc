@@ -231,14 +231,8 @@ void ProxyFilter::onDrainClose() {
 
 void ProxyFilter::chargeReplyStats(ActiveQuery& active_query, const std::string& prefix,
                                    const ReplyMessage& message) {
-  uint64_t reply_documents_byte_size = 0;
-  for (const Bson::DocumentSharedPtr& document : message.documents()) {
-    reply_documents_byte_size += document->byteSize();
-  }
-
-  scope_.histogram(fmt::format("{}.reply_num_docs", prefix))
-      .recordValue(message.documents().size());
-  scope_.histogram(fmt::format("{}.reply_size", prefix)).recordValue(reply_documents_byte_size);
+  scope_.histogram(fmt::format("{}.reply_num_docs", prefix)).recordValue(message.documentCount());
+  scope_.histogram(fmt::format("{}.reply_size", prefix)).recordValue(message.documentsByteSize());
   scope_.histogram(fmt::format("{}.reply_time_ms", prefix))
       .recordValue(std::chrono::duration_cast<std::chrono::milliseconds>(
                        std::chrono::steady_clock::now() - active_query.start_time_)
@@ -311,7 +305,8 @@ Network::FilterStatus ProxyFilter::onWrite(Buffer::Instance& data, bool) {
 }
 
 DecoderPtr ProdProxyFilter::createDecoder(DecoderCallbacks& callbacks) {
-  return DecoderPtr{new DecoderImpl(callbacks)};
+  // Reply documents are only counted and sized for stats, so their bodies are never decoded.
+  return DecoderPtr{new DecoderImpl(callbacks, true)};
 }
 
 absl::optional<uint64_t> ProxyFilter::delayDuration() {
@@ -48,7 +48,8 @@ Network::FilterStatus Filter::onNewConnection() {
     config_->stats().active_.inc();
     config_->stats().total_.inc();
     calling_limit_ = true;
-    client_->limit(*this, config_->domain(), config_->descriptors(), Tracing::NullSpan::instance());
+    client_->limit(*this, config_->domain(), config_->descriptors(), Tracing::NullSpan::instance(),
+                   1);
     calling_limit_ = false;
   }
 
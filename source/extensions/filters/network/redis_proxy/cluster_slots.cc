@@ -0,0 +1,158 @@
+#include "extensions/filters/network/redis_proxy/cluster_slots.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/common/assert.h"
+#include "common/common/fmt.h"
+#include "common/common/utility.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace NetworkFilters {
+namespace RedisProxy {
+
+namespace {
+
+// CRC16-CCITT (XMODEM) lookup table, which is the CRC used by Redis Cluster.
+std::array<uint16_t, 256> buildCrc16Table() {
+  std::array<uint16_t, 256> table;
+  for (uint32_t i = 0; i < table.size(); i++) {
+    uint16_t crc = i << 8;
+    for (uint32_t bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    table[i] = crc;
+  }
+  return table;
+}
+
+uint16_t crc16(absl::string_view data) {
+  static const std::array<uint16_t, 256> table = buildCrc16Table();
+  uint16_t crc = 0;
+  for (const char c : data) {
+    crc = (crc << 8) ^ table[((crc >> 8) ^ static_cast<uint8_t>(c)) & 0xff];
+  }
+  return crc;
+}
+
+std::string formatAddress(absl::string_view ip, uint64_t port) {
+  // IPv6 addresses are bracketed like Network::Address::Ipv6Instance::asString() does.
+  return ip.find(':') != absl::string_view::npos ? fmt::format("[{}]:{}", ip, port)
+                                                 : fmt::format("{}:{}", ip, port);
+}
+
+} // namespace
+
+constexpr uint16_t ClusterSlotMap::NumSlots;
+const uint16_t ClusterSlotMap::UnknownNode;
+
+ClusterSlotMap::ClusterSlotMap() : slots_(NumSlots, UnknownNode) {}
+
+uint16_t ClusterSlotMap::keySlot(absl::string_view key) {
+  // Only the part of the key between the first { and the next } is hashed if it isn't empty, so
+  // that related keys can be placed in the same slot.
+  const size_t start = key.find('{');
+  if (start != absl::string_view::npos) {
+    const size_t end = key.find('}', start + 1);
+    if (end != absl::string_view::npos && end != start + 1) {
+      key = key.substr(start + 1, end - start - 1);
+    }
+  }
+  return crc16(key) & (NumSlots - 1);
+}
+
+bool ClusterSlotMap::parseRedirection(absl::string_view error, ClusterRedirection& redirection) {
+  // The errors look like: MOVED 3999 127.0.0.1:6381
+  const std::vector<absl::string_view> tokens = StringUtil::splitToken(error, " ");
+  if (tokens.size() != 3 || (tokens[0] != "MOVED" && tokens[0] != "ASK")) {
+    return false;
+  }
+
+  uint64_t slot;
+  if (!StringUtil::atoul(std::string(tokens[1]).c_str(), slot) || slot >= NumSlots) {
+    return false;
+  }
+
+  const size_t colon = tokens[2].rfind(':');
+  uint64_t port;
+  if (colon == absl::string_view::npos || colon == 0 ||
+      !StringUtil::atoul(std::string(tokens[2].substr(colon + 1)).c_str(), port)) {
+    return false;
+  }
+
+  redirection.ask_ = tokens[0] == "ASK";
+  redirection.slot_ = slot;
+  redirection.address_ = formatAddress(tokens[2].substr(0, colon), port);
+  return true;
+}
+
+bool ClusterSlotMap::update(const RespValue& response) {
+  if (response.type() != RespType::Array) {
+    return false;
+  }
+
+  // Each range looks like: [start, end, [ip, port, id], replicas...]
+  ClusterSlotMap updated;
+  for (const RespValue& range : response.asArray()) {
+    if (range.type() != RespType::Array || range.asArray().size() < 3 ||
+        range.asArray()[0].type() != RespType::Integer ||
+        range.asArray()[1].type() != RespType::Integer ||
+        range.asArray()[2].type() != RespType::Array) {
+      return false;
+    }
+    const int64_t start = range.asArray()[0].asInteger();
+    const int64_t end = range.asArray()[1].asInteger();
+    const std::vector<RespValue>& primary = range.asArray()[2].asArray();
+    if (start < 0 || start > end || end >= NumSlots || primary.size() < 2 ||
+        primary[0].type() != RespType::BulkString || primary[1].type() != RespType::Integer ||
+        primary[1].asInteger() < 0) {
+      return false;
+    }
+
+    const absl::string_view ip = primary[0].asStringView();
+    if (ip.empty()) {
+      continue;
+    }
+    const uint16_t node = updated.nodeIndex(formatAddress(ip, primary[1].asInteger()));
+    std::fill(updated.slots_.begin() + start, updated.slots_.begin() + end + 1, node);
+  }
+
+  slots_.swap(updated.slots_);
+  nodes_.swap(updated.nodes_);
+  updated_ = true;
+  return true;
+}
+
+void ClusterSlotMap::update(uint16_t slot, const std::string& address) {
+  ASSERT(slot < NumSlots);
+  slots_[slot] = nodeIndex(address);
+  updated_ = true;
+}
+
+const std::string* ClusterSlotMap::address(uint16_t slot) const {
+  ASSERT(slot < NumSlots);
+  return slots_[slot] != UnknownNode ? &nodes_[slots_[slot]] : nullptr;
+}
+
+uint16_t ClusterSlotMap::nodeIndex(const std::string& address) {
+  for (size_t i = 0; i < nodes_.size(); i++) {
+    if (nodes_[i] == address) {
+      return i;
+    }
+  }
+  if (nodes_.size() == UnknownNode) {
+    // Far more nodes than a cluster may have, whose slots are simply left unknown.
+    return UnknownNode;
+  }
+  nodes_.push_back(address);
+  return nodes_.size() - 1;
+}
+
+} // namespace RedisProxy
+} // namespace NetworkFilters
+} // namespace Extensions
+} // namespace Envoy
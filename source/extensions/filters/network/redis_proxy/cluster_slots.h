@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "extensions/filters/network/redis_proxy/codec.h"
+
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace NetworkFilters {
+namespace RedisProxy {
+
+/**
+ * A MOVED or ASK redirection returned by a Redis Cluster node.
+ */
+struct ClusterRedirection {
+  // True for ASK, which only redirects the current request, false for MOVED.
+  bool ask_{};
+  uint16_t slot_{};
+  // The address of the node to redirect to, formatted like Network::Address::Instance::asString().
+  std::string address_;
+};
+
+/**
+ * The map of the hash slots of a Redis Cluster to the addresses of the primary nodes serving them.
+ * See https://redis.io/topics/cluster-spec.
+ */
+class ClusterSlotMap {
+public:
+  static constexpr uint16_t NumSlots = 16384;
+
+  ClusterSlotMap();
+
+  /**
+   * @return the hash slot of a key, which is the CRC16 of its hash tag if it has one, or of the
+   *         whole key otherwise, modulo the number of slots.
+   */
+  static uint16_t keySlot(absl::string_view key);
+
+  /**
+   * Parse a MOVED or ASK error.
+   * @param error supplies the error returned by a node.
+   * @param redirection receives the redirection.
+   * @return true if the error is a valid redirection.
+   */
+  static bool parseRedirection(absl::string_view error, ClusterRedirection& redirection);
+
+  /**
+   * Replace the whole map with the response to a CLUSTER SLOTS command. The ranges whose primary
+   * doesn't report its IP are left unknown.
+   * @param response supplies the response.
+   * @return false if the response is malformed, in which case the map is left unchanged.
+   */
+  bool update(const RespValue& response);
+
+  /**
+   * Assign a single slot to a node, as a MOVED redirection does.
+   */
+  void update(uint16_t slot, const std::string& address);
+
+  /**
+   * @return the address of the node serving a slot, or nullptr if it is unknown.
+   */
+  const std::string* address(uint16_t slot) const;
+
+  /**
+   * @return true if the map was never updated.
+   */
+  bool empty() const { return !updated_; }
+
+private:
+  static const uint16_t UnknownNode = UINT16_MAX;
+
+  uint16_t nodeIndex(const std::string& address);
+
+  // The index in nodes_ of the node serving each slot. Indexes keep the map small compared to
+  // holding the addresses per slot.
+  std::vector<uint16_t> slots_;
+  std::vector<std::string> nodes_;
+  bool updated_{};
+};
+
+} // namespace RedisProxy
+} // namespace NetworkFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -7,6 +7,8 @@
 #include "envoy/buffer/buffer.h"
 #include "envoy/common/exception.h"
 
+#include "absl/strings/string_view.h"
+
 namespace Envoy {
 namespace Extensions {
 namespace NetworkFilters {
@@ -24,8 +26,14 @@ enum class RespType { Null, SimpleString, BulkString, Integer, Error, Array };
 class RespValue {
 public:
   RespValue() : type_(RespType::Null) {}
+  RespValue(const RespValue& other);
   ~RespValue() { cleanup(); }
 
+  /**
+   * Deep copy a RESP value. A pinned bulk string is copied by sharing its pinned memory.
+   */
+  RespValue& operator=(const RespValue& other);
+
   /**
    * Convert a RESP value to a string for debugging purposes.
    */
@@ -33,12 +41,34 @@ public:
 
   /**
    * The following are getters and setters for the internal value. A RespValue starts as null,
-   * and must change type via type() before the following methods can be used.
+   * and must change type via type() before the following methods can be used. asString() copies
+   * the value of a pinned bulk string into the string first, which then stops being pinned.
    */
   std::vector<RespValue>& asArray();
   const std::vector<RespValue>& asArray() const;
   std::string& asString();
   const std::string& asString() const;
+
+  /**
+   * @return the value of a string, without copying the value of a pinned bulk string.
+   */
+  absl::string_view asStringView() const;
+
+  /**
+   * Set the value of a bulk string to memory kept alive by an owner. Decoders use this to refer to
+   * large bulk strings in pinned slices of the buffer they were decoded from rather than copying
+   * them, and encoders to write them without copying them either.
+   * @param value supplies the value of the string.
+   * @param owner supplies the reference that keeps value alive until the type or the value of the
+   *        string is changed, or the string is destroyed.
+   */
+  void pinString(absl::string_view value, Buffer::SliceReferenceSharedPtr owner);
+
+  /**
+   * @return the reference keeping the value of a pinned bulk string alive, or nullptr if the value
+   *         is held by the string.
+   */
+  const Buffer::SliceReferenceSharedPtr& pinnedOwner() const;
   int64_t& asInteger();
   int64_t asInteger() const;
 
@@ -56,9 +86,17 @@ private:
     int64_t integer_;
   };
 
+  struct PinnedString {
+    absl::string_view value_;
+    Buffer::SliceReferenceSharedPtr owner_;
+  };
+
   void cleanup();
+  void unpin() const;
 
   RespType type_;
+  // Only set for pinned bulk strings, whose string_ is empty until they are unpinned.
+  mutable std::unique_ptr<PinnedString> pinned_;
 };
 
 typedef std::unique_ptr<RespValue> RespValuePtr;
@@ -1,6 +1,7 @@
 #include "extensions/filters/network/redis_proxy/codec_impl.h"
 
 #include <cstdint>
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -13,6 +14,33 @@ namespace Extensions {
 namespace NetworkFilters {
 namespace RedisProxy {
 
+namespace {
+
+// Bulk strings decoded at least this long are pinned in the decoded buffer if they lie within one
+// of its slices. Shorter strings are cheaper to copy than to pin and reference.
+constexpr uint64_t MinPinnedBulkStringSize{1024};
+
+/**
+ * Buffer fragment referencing the value of a pinned bulk string, which is kept alive until the
+ * buffer written to is done with it.
+ */
+class PinnedStringFragment : public Buffer::BufferFragment {
+public:
+  PinnedStringFragment(absl::string_view value, Buffer::SliceReferenceSharedPtr owner)
+      : value_(value), owner_(std::move(owner)) {}
+
+  // Buffer::BufferFragment
+  const void* data() const override { return value_.data(); }
+  size_t size() const override { return value_.size(); }
+  void done() override { delete this; }
+
+private:
+  const absl::string_view value_;
+  const Buffer::SliceReferenceSharedPtr owner_;
+};
+
+} // namespace
+
 std::string RespValue::toString() const {
   switch (type_) {
   case RespType::Array: {
@@ -28,7 +56,7 @@ std::string RespValue::toString() const {
   case RespType::SimpleString:
   case RespType::BulkString:
   case RespType::Error:
-    return fmt::format("\"{}\"", asString());
+    return fmt::format("\"{}\"", asStringView());
   case RespType::Null:
     return "null";
   case RespType::Integer:
@@ -38,6 +66,64 @@ std::string RespValue::toString() const {
   NOT_REACHED_GCOVR_EXCL_LINE;
 }
 
+RespValue::RespValue(const RespValue& other) : type_(RespType::Null) {
+  type(other.type());
+  switch (type_) {
+  case RespType::Array: {
+    array_ = other.array_;
+    break;
+  }
+  case RespType::SimpleString:
+  case RespType::BulkString:
+  case RespType::Error: {
+    if (other.pinned_ != nullptr) {
+      pinned_.reset(new PinnedString(*other.pinned_));
+    } else {
+      string_ = other.string_;
+    }
+    break;
+  }
+  case RespType::Integer: {
+    integer_ = other.integer_;
+    break;
+  }
+  case RespType::Null: {
+    break;
+  }
+  }
+}
+
+RespValue& RespValue::operator=(const RespValue& other) {
+  if (&other == this) {
+    return *this;
+  }
+
+  // Copy first, as other may be an element of this value.
+  RespValue copy(other);
+  type(copy.type());
+  switch (type_) {
+  case RespType::Array: {
+    array_.swap(copy.array_);
+    break;
+  }
+  case RespType::SimpleString:
+  case RespType::BulkString:
+  case RespType::Error: {
+    string_.swap(copy.string_);
+    pinned_.swap(copy.pinned_);
+    break;
+  }
+  case RespType::Integer: {
+    integer_ = copy.integer_;
+    break;
+  }
+  case RespType::Null: {
+    break;
+  }
+  }
+  return *this;
+}
+
 std::vector<RespValue>& RespValue::asArray() {
   ASSERT(type_ == RespType::Array);
   return array_;
@@ -51,15 +137,43 @@ const std::vector<RespValue>& RespValue::asArray() const {
 std::string& RespValue::asString() {
   ASSERT(type_ == RespType::BulkString || type_ == RespType::Error ||
          type_ == RespType::SimpleString);
+  unpin();
   return string_;
 }
 
 const std::string& RespValue::asString() const {
   ASSERT(type_ == RespType::BulkString || type_ == RespType::Error ||
          type_ == RespType::SimpleString);
+  unpin();
   return string_;
 }
 
+absl::string_view RespValue::asStringView() const {
+  ASSERT(type_ == RespType::BulkString || type_ == RespType::Error ||
+         type_ == RespType::SimpleString);
+  return pinned_ != nullptr ? pinned_->value_ : absl::string_view(string_);
+}
+
+void RespValue::pinString(absl::string_view value, Buffer::SliceReferenceSharedPtr owner) {
+  ASSERT(type_ == RespType::BulkString);
+  string_.clear();
+  pinned_.reset(new PinnedString{value, std::move(owner)});
+}
+
+const Buffer::SliceReferenceSharedPtr& RespValue::pinnedOwner() const {
+  static const Buffer::SliceReferenceSharedPtr not_pinned;
+  return pinned_ != nullptr ? pinned_->owner_ : not_pinned;
+}
+
+void RespValue::unpin() const {
+  // The string is only modified when it is pinned, in which case it is empty. Values are only
+  // accessed by the thread which decoded them, so this is safe to do behind a const accessor.
+  if (pinned_ != nullptr) {
+    const_cast<std::string&>(string_).assign(pinned_->value_.data(), pinned_->value_.size());
+    pinned_.reset();
+  }
+}
+
 int64_t& RespValue::asInteger() {
   ASSERT(type_ == RespType::Integer);
   return integer_;
@@ -71,6 +185,8 @@ int64_t RespValue::asInteger() const {
 }
 
 void RespValue::cleanup() {
+  pinned_.reset();
+
   // Need to manually delete because of the union.
   switch (type_) {
   case RespType::Array: {
@@ -118,13 +234,13 @@ void DecoderImpl::decode(Buffer::Instance& data) {
   Buffer::RawSlice slices[num_slices];
   data.getRawSlices(slices, num_slices);
   for (const Buffer::RawSlice& slice : slices) {
-    parseSlice(slice);
+    parseSlice(slice, data);
   }
 
   data.drain(data.length());
 }
 
-void DecoderImpl::parseSlice(const Buffer::RawSlice& slice) {
+void DecoderImpl::parseSlice(const Buffer::RawSlice& slice, Buffer::Instance& data) {
   const char* buffer = reinterpret_cast<const char*>(slice.mem_);
   uint64_t remaining = slice.len_;
 
@@ -257,16 +373,31 @@ void DecoderImpl::parseSlice(const Buffer::RawSlice& slice) {
 
     case State::BulkStringBody: {
       ASSERT(!pending_integer_.negative_);
+      RespValue& value = *pending_value_stack_.front().value_;
+      if (pending_integer_.integer_ >= MinPinnedBulkStringSize &&
+          pending_integer_.integer_ <= remaining && value.asStringView().empty()) {
+        // The whole string is in this slice, so it can be referenced rather than copied.
+        Buffer::SliceReferenceSharedPtr owner = data.pin(buffer, pending_integer_.integer_);
+        if (owner != nullptr) {
+          value.pinString(absl::string_view(buffer, pending_integer_.integer_), std::move(owner));
+          remaining -= pending_integer_.integer_;
+          buffer += pending_integer_.integer_;
+          pending_integer_.integer_ = 0;
+          ENVOY_LOG(trace, "parse slice: BulkStringBody pinned");
+          state_ = State::CR;
+          break;
+        }
+      }
+
       uint64_t length_to_copy =
           std::min(static_cast<uint64_t>(pending_integer_.integer_), remaining);
-      pending_value_stack_.front().value_->asString().append(buffer, length_to_copy);
+      value.asString().append(buffer, length_to_copy);
       pending_integer_.integer_ -= length_to_copy;
       remaining -= length_to_copy;
       buffer += length_to_copy;
 
       if (pending_integer_.integer_ == 0) {
-        ENVOY_LOG(trace, "parse slice: BulkStringBody complete: {}",
-                  pending_value_stack_.front().value_->asString());
+        ENVOY_LOG(trace, "parse slice: BulkStringBody complete: {}", value.asStringView());
         state_ = State::CR;
       }
 
@@ -298,15 +429,19 @@ void DecoderImpl::parseSlice(const Buffer::RawSlice& slice) {
     }
 
     case State::SimpleString: {
-      ENVOY_LOG(trace, "parse slice: SimpleString: {}", buffer[0]);
-      if (buffer[0] == '\r') {
+      // Copy everything up to the carriage return at once, which may be in a later slice.
+      const char* end = static_cast<const char*>(memchr(buffer, '\r', remaining));
+      const uint64_t length = end != nullptr ? end - buffer : remaining;
+      pending_value_stack_.front().value_->asString().append(buffer, length);
+      ENVOY_LOG(trace, "parse slice: SimpleString: {} bytes", length);
+      if (end != nullptr) {
         state_ = State::LF;
+        remaining -= length + 1;
+        buffer += length + 1;
       } else {
-        pending_value_stack_.front().value_->asString().push_back(buffer[0]);
+        remaining -= length;
+        buffer += length;
       }
-
-      remaining--;
-      buffer++;
       break;
     }
 
@@ -345,7 +480,7 @@ void EncoderImpl::encode(const RespValue& value, Buffer::Instance& out) {
     break;
   }
   case RespType::BulkString: {
-    encodeBulkString(value.asString(), out);
+    encodeBulkString(value, out);
     break;
   }
   case RespType::Error: {
@@ -376,7 +511,8 @@ void EncoderImpl::encodeArray(const std::vector<RespValue>& array, Buffer::Insta
   }
 }
 
-void EncoderImpl::encodeBulkString(const std::string& string, Buffer::Instance& out) {
+void EncoderImpl::encodeBulkString(const RespValue& value, Buffer::Instance& out) {
+  const absl::string_view string = value.asStringView();
   char buffer[32];
   char* current = buffer;
   *current++ = '$';
@@ -384,7 +520,12 @@ void EncoderImpl::encodeBulkString(const std::string& string, Buffer::Instance&
   *current++ = '\r';
   *current++ = '\n';
   out.add(buffer, current - buffer);
-  out.add(string);
+  if (value.pinnedOwner() != nullptr) {
+    // The fragment shares the pinned slice, and deletes itself once the output is done with it.
+    out.addBufferFragment(*new PinnedStringFragment(string, value.pinnedOwner()));
+  } else {
+    out.add(string.data(), string.size());
+  }
   out.add("\r\n", 2);
 }
 
@@ -55,7 +55,7 @@ private:
     uint64_t current_array_element_;
   };
 
-  void parseSlice(const Buffer::RawSlice& slice);
+  void parseSlice(const Buffer::RawSlice& slice, Buffer::Instance& data);
 
   DecoderCallbacks& callbacks_;
   State state_{State::ValueRootStart};
@@ -85,7 +85,7 @@ public:
 
 private:
   void encodeArray(const std::vector<RespValue>& array, Buffer::Instance& out);
-  void encodeBulkString(const std::string& string, Buffer::Instance& out);
+  void encodeBulkString(const RespValue& value, Buffer::Instance& out);
   void encodeError(const std::string& string, Buffer::Instance& out);
   void encodeInteger(int64_t integer, Buffer::Instance& out);
   void encodeSimpleString(const std::string& string, Buffer::Instance& out);
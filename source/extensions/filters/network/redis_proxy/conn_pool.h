@@ -94,6 +94,18 @@ public:
    * passive healthcheck operations.
    */
   virtual bool disableOutlierEvents() const PURE;
+
+  /**
+   * @return uint32_t the size in bytes of the encoded requests above which they are written to the
+   *         connection. Requests are written as soon as they are made when this is 0.
+   */
+  virtual uint32_t maxBufferSizeBeforeFlush() const PURE;
+
+  /**
+   * @return std::chrono::milliseconds the time after which the encoded requests are written to the
+   *         connection even if maxBufferSizeBeforeFlush() hasn't been reached.
+   */
+  virtual std::chrono::milliseconds bufferFlushTimeoutInMs() const PURE;
 };
 
 /**
@@ -1,11 +1,13 @@
 #include "extensions/filters/network/redis_proxy/conn_pool_impl.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "common/common/assert.h"
+#include "common/common/macros.h"
 
 namespace Envoy {
 namespace Extensions {
@@ -13,9 +15,46 @@ namespace NetworkFilters {
 namespace RedisProxy {
 namespace ConnPool {
 
+namespace {
+
+// Drops the responses to the ASKING commands sent ahead of the requests redirected by ASK.
+struct NoOpPoolCallbacks : public PoolCallbacks {
+  // RedisProxy::ConnPool::PoolCallbacks
+  void onResponse(RespValuePtr&&) override {}
+  void onFailure() override {}
+};
+
+NoOpPoolCallbacks no_op_callbacks;
+
+RespValue makeCommand(const std::vector<std::string>& args) {
+  RespValue command;
+  command.type(RespType::Array);
+  command.asArray().resize(args.size());
+  for (size_t i = 0; i < args.size(); i++) {
+    command.asArray()[i].type(RespType::BulkString);
+    command.asArray()[i].asString() = args[i];
+  }
+  return command;
+}
+
+const RespValue& askingCommand() { CONSTRUCT_ON_FIRST_USE(RespValue, makeCommand({"asking"})); }
+
+const RespValue& clusterSlotsCommand() {
+  CONSTRUCT_ON_FIRST_USE(RespValue, makeCommand({"cluster", "slots"}));
+}
+
+} // namespace
+
+const uint32_t InstanceImpl::MaxClusterRedirections;
+
 ConfigImpl::ConfigImpl(
     const envoy::config::filter::network::redis_proxy::v2::RedisProxy::ConnPoolSettings& config)
-    : op_timeout_(PROTOBUF_GET_MS_REQUIRED(config, op_timeout)) {}
+    : op_timeout_(PROTOBUF_GET_MS_REQUIRED(config, op_timeout)),
+      max_buffer_size_before_flush_(config.max_buffer_size_before_flush()),
+      buffer_flush_timeout_(PROTOBUF_GET_MS_OR_DEFAULT(config, buffer_flush_timeout, 3)),
+      max_connections_per_host_(
+          PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, max_connections_per_host, 1)),
+      enable_cluster_mode_(config.enable_cluster_mode()) {}
 
 ClientPtr ClientImpl::create(Upstream::HostConstSharedPtr host, Event::Dispatcher& dispatcher,
                              EncoderPtr&& encoder, DecoderFactory& decoder_factory,
@@ -35,6 +74,9 @@ ClientImpl::ClientImpl(Upstream::HostConstSharedPtr host, Event::Dispatcher& dis
                        EncoderPtr&& encoder, DecoderFactory& decoder_factory, const Config& config)
     : host_(host), encoder_(std::move(encoder)), decoder_(decoder_factory.create(*this)),
       config_(config),
+      flush_timer_(config.maxBufferSizeBeforeFlush() > 0
+                       ? dispatcher.createTimer([this]() -> void { flushBuffer(); })
+                       : nullptr),
       connect_or_op_timer_(dispatcher.createTimer([this]() -> void { onConnectOrOpTimeout(); })) {
   host->cluster().stats().upstream_cx_total_.inc();
   host->stats().cx_total_.inc();
@@ -57,7 +99,15 @@ PoolRequest* ClientImpl::makeRequest(const RespValue& request, PoolCallbacks& ca
 
   pending_requests_.emplace_back(*this, callbacks);
   encoder_->encode(request, encoder_buffer_);
-  connection_->write(encoder_buffer_, false);
+
+  // The requests are batched into the encoder buffer, which is written once it is large enough or
+  // once the flush timer started by the first request of the batch fires.
+  if (flush_timer_ == nullptr || encoder_buffer_.length() >= config_.maxBufferSizeBeforeFlush()) {
+    flushBuffer();
+  } else if (!flush_pending_) {
+    flush_pending_ = true;
+    flush_timer_->enableTimer(config_.bufferFlushTimeoutInMs());
+  }
 
   // Only boost the op timeout if:
   // - We are not already connected. Otherwise, we are governed by the connect timeout and the timer
@@ -85,6 +135,16 @@ void ClientImpl::onConnectOrOpTimeout() {
   connection_->close(Network::ConnectionCloseType::NoFlush);
 }
 
+void ClientImpl::flushBuffer() {
+  if (flush_pending_) {
+    flush_pending_ = false;
+    flush_timer_->disableTimer();
+  }
+  if (encoder_buffer_.length() > 0) {
+    connection_->write(encoder_buffer_, false);
+  }
+}
+
 void ClientImpl::onData(Buffer::Instance& data) {
   try {
     decoder_->decode(data);
@@ -127,6 +187,10 @@ void ClientImpl::onEvent(Network::ConnectionEvent event) {
     }
 
     connect_or_op_timer_->disableTimer();
+    if (flush_pending_) {
+      flush_pending_ = false;
+      flush_timer_->disableTimer();
+    }
   } else if (event == Network::ConnectionEvent::Connected) {
     connected_ = true;
     ASSERT(!pending_requests_.empty());
@@ -213,27 +277,62 @@ InstanceImpl::ThreadLocalPool::ThreadLocalPool(InstanceImpl& parent, Event::Disp
   //                     safely clean things up and fail requests.
   ASSERT(!cluster_->info()->addedViaApi());
   local_host_set_member_update_cb_handle_ = cluster_->prioritySet().addMemberUpdateCb(
-      [this](uint32_t, const std::vector<Upstream::HostSharedPtr>&,
+      [this](uint32_t, const std::vector<Upstream::HostSharedPtr>& hosts_added,
              const std::vector<Upstream::HostSharedPtr>& hosts_removed) -> void {
-        onHostsRemoved(hosts_removed);
+        onHostsChanged(hosts_added, hosts_removed);
       });
+
+  if (parent_.config_.enableClusterMode()) {
+    for (const auto& host_set : cluster_->prioritySet().hostSetsPerPriority()) {
+      onHostsChanged(host_set->hosts(), {});
+    }
+  }
 }
 
 InstanceImpl::ThreadLocalPool::~ThreadLocalPool() {
   local_host_set_member_update_cb_handle_->remove();
+  if (cluster_slots_request_ != nullptr) {
+    cluster_slots_request_->cancel();
+    cluster_slots_request_ = nullptr;
+  }
   while (!client_map_.empty()) {
-    client_map_.begin()->second->redis_client_->close();
+    closeClients(client_map_.begin()->second);
+  }
+}
+
+void InstanceImpl::ThreadLocalPool::closeClients(const ThreadLocalActiveClients& clients) {
+  // Closing the last client of a host removes the host from the client map, which destroys the
+  // clients, so the clients to close are collected first. The closed clients are deferred deleted.
+  std::vector<Client*> to_close;
+  for (const ThreadLocalActiveClientPtr& client : clients) {
+    if (client) {
+      to_close.push_back(client->redis_client_.get());
+    }
+  }
+  for (Client* client : to_close) {
+    client->close();
   }
 }
 
-void InstanceImpl::ThreadLocalPool::onHostsRemoved(
+void InstanceImpl::ThreadLocalPool::onHostsChanged(
+    const std::vector<Upstream::HostSharedPtr>& hosts_added,
     const std::vector<Upstream::HostSharedPtr>& hosts_removed) {
+  if (parent_.config_.enableClusterMode()) {
+    // The nodes are known by their address in the slot map and in the redirections.
+    for (const auto& host : hosts_removed) {
+      hosts_by_address_.erase(host->address()->asString());
+    }
+    for (const auto& host : hosts_added) {
+      hosts_by_address_[host->address()->asString()] = host;
+    }
+  }
+
   for (const auto& host : hosts_removed) {
     auto it = client_map_.find(host);
     if (it != client_map_.end()) {
       // We don't currently support any type of draining for redis connections. If a host is gone,
-      // we just close the connection. This will fail any pending requests.
-      it->second->redis_client_->close();
+      // we just close the connections. This will fail any pending requests.
+      closeClients(it->second);
     }
   }
 }
@@ -241,30 +340,169 @@ void InstanceImpl::ThreadLocalPool::onHostsRemoved(
 PoolRequest* InstanceImpl::ThreadLocalPool::makeRequest(const std::string& hash_key,
                                                         const RespValue& request,
                                                         PoolCallbacks& callbacks) {
+  if (parent_.config_.enableClusterMode()) {
+    return makeClusterRequest(hash_key, request, callbacks);
+  }
+
   LbContextImpl lb_context(hash_key);
   Upstream::HostConstSharedPtr host = cluster_->loadBalancer().chooseHost(&lb_context);
   if (!host) {
     return nullptr;
   }
 
-  ThreadLocalActiveClientPtr& client = client_map_[host];
+  return getClient(host, lb_context.hash_key_.value()).makeRequest(request, callbacks);
+}
+
+PoolRequest* InstanceImpl::ThreadLocalPool::makeClusterRequest(const std::string& hash_key,
+                                                               const RespValue& request,
+                                                               PoolCallbacks& callbacks) {
+  LbContextImpl lb_context(hash_key);
+  if (slot_map_.empty()) {
+    refreshClusterSlots();
+  }
+
+  // Until the slots are known, the requests are sent to the hosts chosen by the load balancer,
+  // whose redirections are then followed.
+  Upstream::HostConstSharedPtr host;
+  const std::string* address = slot_map_.address(ClusterSlotMap::keySlot(hash_key));
+  if (address != nullptr) {
+    auto it = hosts_by_address_.find(*address);
+    if (it != hosts_by_address_.end()) {
+      host = it->second;
+    }
+  }
+  if (!host) {
+    host = cluster_->loadBalancer().chooseHost(&lb_context);
+    if (!host) {
+      return nullptr;
+    }
+  }
+
+  ClusterRequestPtr cluster_request(
+      new ClusterRequest(*this, lb_context.hash_key_.value(), request, callbacks));
+  cluster_request->handle_ = getClient(host, cluster_request->hash_key_)
+                                 .makeRequest(cluster_request->request_, *cluster_request);
+  if (!cluster_request->handle_) {
+    return nullptr;
+  }
+
+  cluster_request->moveIntoList(std::move(cluster_request), cluster_requests_);
+  return cluster_requests_.front().get();
+}
+
+Client& InstanceImpl::ThreadLocalPool::getClient(const Upstream::HostConstSharedPtr& host,
+                                                 uint64_t hash_key) {
+  ThreadLocalActiveClients& clients = client_map_[host];
+  if (clients.empty()) {
+    clients.resize(parent_.config_.maxConnectionsPerHost());
+  }
+
+  // The requests for a key always use the same connection, so that they are executed in order.
+  const uint32_t index = hash_key % clients.size();
+  ThreadLocalActiveClientPtr& client = clients[index];
   if (!client) {
     client.reset(new ThreadLocalActiveClient(*this));
     client->host_ = host;
+    client->index_ = index;
     client->redis_client_ = parent_.client_factory_.create(host, dispatcher_, parent_.config_);
     client->redis_client_->addConnectionCallbacks(*client);
   }
 
-  return client->redis_client_->makeRequest(request, callbacks);
+  return *client->redis_client_;
+}
+
+bool InstanceImpl::ThreadLocalPool::redirect(ClusterRequest& request,
+                                             const ClusterRedirection& redirection) {
+  if (!redirection.ask_) {
+    // A MOVED redirection means that the slot map is out of date, so besides moving the slot the
+    // whole map is refreshed in case other slots have moved as well.
+    slot_map_.update(redirection.slot_, redirection.address_);
+    refreshClusterSlots();
+  }
+
+  auto it = hosts_by_address_.find(redirection.address_);
+  if (it == hosts_by_address_.end()) {
+    ENVOY_LOG(debug, "redis: redirection to unknown node {}", redirection.address_);
+    return false;
+  }
+
+  // An ASK redirection only applies to the request, which must follow an ASKING command on the
+  // same connection.
+  Client& client = getClient(it->second, request.hash_key_);
+  if (redirection.ask_ && client.makeRequest(askingCommand(), no_op_callbacks) == nullptr) {
+    return false;
+  }
+
+  request.handle_ = client.makeRequest(request.request_, request);
+  request.redirections_++;
+  return request.handle_ != nullptr;
+}
+
+void InstanceImpl::ThreadLocalPool::refreshClusterSlots() {
+  if (cluster_slots_request_ != nullptr) {
+    return;
+  }
+
+  // Any node knows the whole map, so the node asked is left to the load balancer.
+  Upstream::HostConstSharedPtr host = cluster_->loadBalancer().chooseHost(nullptr);
+  if (host) {
+    ENVOY_LOG(debug, "redis: refreshing cluster slots from {}", host->address()->asString());
+    cluster_slots_request_ = getClient(host, 0).makeRequest(clusterSlotsCommand(), *this);
+  }
+}
+
+void InstanceImpl::ThreadLocalPool::onResponse(RespValuePtr&& value) {
+  cluster_slots_request_ = nullptr;
+  if (!slot_map_.update(*value)) {
+    ENVOY_LOG(debug, "redis: invalid cluster slots response: {}", value->toString());
+  }
+}
+
+void InstanceImpl::ThreadLocalPool::onFailure() { cluster_slots_request_ = nullptr; }
+
+void InstanceImpl::ClusterRequest::cancel() {
+  handle_->cancel();
+  handle_ = nullptr;
+  finish();
+}
+
+void InstanceImpl::ClusterRequest::onResponse(RespValuePtr&& value) {
+  handle_ = nullptr;
+  ClusterRedirection redirection;
+  if (value->type() == RespType::Error && redirections_ < MaxClusterRedirections &&
+      ClusterSlotMap::parseRedirection(value->asStringView(), redirection) &&
+      parent_.redirect(*this, redirection)) {
+    return;
+  }
+
+  callbacks_.onResponse(std::move(value));
+  finish();
+}
+
+void InstanceImpl::ClusterRequest::onFailure() {
+  handle_ = nullptr;
+  callbacks_.onFailure();
+  finish();
+}
+
+void InstanceImpl::ClusterRequest::finish() {
+  parent_.dispatcher_.deferredDelete(removeFromList(parent_.cluster_requests_));
 }
 
 void InstanceImpl::ThreadLocalActiveClient::onEvent(Network::ConnectionEvent event) {
   if (event == Network::ConnectionEvent::RemoteClose ||
       event == Network::ConnectionEvent::LocalClose) {
-    auto client_to_delete = parent_.client_map_.find(host_);
-    ASSERT(client_to_delete != parent_.client_map_.end());
-    parent_.dispatcher_.deferredDelete(std::move(client_to_delete->second->redis_client_));
-    parent_.client_map_.erase(client_to_delete);
+    ThreadLocalPool& parent = parent_;
+    auto clients = parent.client_map_.find(host_);
+    ASSERT(clients != parent.client_map_.end());
+    ASSERT(clients->second[index_].get() == this);
+    parent.dispatcher_.deferredDelete(std::move(redis_client_));
+    // This destroys the active client, whose members must not be used afterwards.
+    clients->second[index_].reset();
+    if (std::all_of(clients->second.begin(), clients->second.end(),
+                    [](const ThreadLocalActiveClientPtr& client) { return client == nullptr; })) {
+      parent.client_map_.erase(clients);
+    }
   }
 }
 
@@ -13,10 +13,13 @@
 #include "envoy/upstream/cluster_manager.h"
 
 #include "common/buffer/buffer_impl.h"
+#include "common/common/linked_object.h"
+#include "common/common/logger.h"
 #include "common/network/filter_impl.h"
 #include "common/protobuf/utility.h"
 #include "common/upstream/load_balancer_impl.h"
 
+#include "extensions/filters/network/redis_proxy/cluster_slots.h"
 #include "extensions/filters/network/redis_proxy/codec_impl.h"
 #include "extensions/filters/network/redis_proxy/conn_pool.h"
 
@@ -36,9 +39,27 @@ public:
 
   bool disableOutlierEvents() const override { return false; }
   std::chrono::milliseconds opTimeout() const override { return op_timeout_; }
+  uint32_t maxBufferSizeBeforeFlush() const override { return max_buffer_size_before_flush_; }
+  std::chrono::milliseconds bufferFlushTimeoutInMs() const override {
+    return buffer_flush_timeout_;
+  }
+
+  /**
+   * @return uint32_t the number of connections opened to each host by each worker.
+   */
+  uint32_t maxConnectionsPerHost() const { return max_connections_per_host_; }
+
+  /**
+   * @return bool whether the requests are routed by the hash slots of a Redis Cluster.
+   */
+  bool enableClusterMode() const { return enable_cluster_mode_; }
 
 private:
   const std::chrono::milliseconds op_timeout_;
+  const uint32_t max_buffer_size_before_flush_;
+  const std::chrono::milliseconds buffer_flush_timeout_;
+  const uint32_t max_connections_per_host_;
+  const bool enable_cluster_mode_;
 };
 
 class ClientImpl : public Client, public DecoderCallbacks, public Network::ConnectionCallbacks {
@@ -84,6 +105,7 @@ private:
   ClientImpl(Upstream::HostConstSharedPtr host, Event::Dispatcher& dispatcher, EncoderPtr&& encoder,
              DecoderFactory& decoder_factory, const Config& config);
   void onConnectOrOpTimeout();
+  void flushBuffer();
   void onData(Buffer::Instance& data);
   void putOutlierEvent(Upstream::Outlier::Result result);
 
@@ -102,8 +124,11 @@ private:
   DecoderPtr decoder_;
   const Config& config_;
   std::list<PendingRequest> pending_requests_;
+  // Only created when the requests are batched, before the connect or op timer.
+  Event::TimerPtr flush_timer_;
   Event::TimerPtr connect_or_op_timer_;
   bool connected_{};
+  bool flush_pending_{};
 };
 
 class ClientFactoryImpl : public ClientFactory {
@@ -118,7 +143,7 @@ private:
   DecoderFactoryImpl decoder_factory_;
 };
 
-class InstanceImpl : public Instance {
+class InstanceImpl : public Instance, Logger::Loggable<Logger::Id::redis> {
 public:
   InstanceImpl(
       const std::string& cluster_name, Upstream::ClusterManager& cm, ClientFactory& client_factory,
@@ -142,24 +167,76 @@ private:
 
     ThreadLocalPool& parent_;
     Upstream::HostConstSharedPtr host_;
+    // The index of the client among the clients of the host.
+    uint32_t index_{};
     ClientPtr redis_client_;
   };
 
   typedef std::unique_ptr<ThreadLocalActiveClient> ThreadLocalActiveClientPtr;
+  // The clients of a host, which are created on demand up to the maximum connections per host.
+  typedef std::vector<ThreadLocalActiveClientPtr> ThreadLocalActiveClients;
+
+  /**
+   * A request made in cluster mode, which follows the MOVED and ASK redirections returned by the
+   * nodes. It keeps a copy of the request to send it again when it is redirected.
+   */
+  struct ClusterRequest : public PoolRequest,
+                          public PoolCallbacks,
+                          public LinkedObject<ClusterRequest>,
+                          public Event::DeferredDeletable {
+    ClusterRequest(ThreadLocalPool& parent, uint64_t hash_key, const RespValue& request,
+                   PoolCallbacks& callbacks)
+        : parent_(parent), hash_key_(hash_key), request_(request), callbacks_(callbacks) {}
+
+    // RedisProxy::ConnPool::PoolRequest
+    void cancel() override;
+
+    // RedisProxy::ConnPool::PoolCallbacks
+    void onResponse(RespValuePtr&& value) override;
+    void onFailure() override;
 
-  struct ThreadLocalPool : public ThreadLocal::ThreadLocalObject {
+    void finish();
+
+    ThreadLocalPool& parent_;
+    const uint64_t hash_key_;
+    const RespValue request_;
+    PoolCallbacks& callbacks_;
+    PoolRequest* handle_{};
+    uint32_t redirections_{};
+  };
+
+  typedef std::unique_ptr<ClusterRequest> ClusterRequestPtr;
+
+  struct ThreadLocalPool : public ThreadLocal::ThreadLocalObject, public PoolCallbacks {
     ThreadLocalPool(InstanceImpl& parent, Event::Dispatcher& dispatcher,
                     const std::string& cluster_name);
     ~ThreadLocalPool();
     PoolRequest* makeRequest(const std::string& hash_key, const RespValue& request,
                              PoolCallbacks& callbacks);
-    void onHostsRemoved(const std::vector<Upstream::HostSharedPtr>& hosts_removed);
+    PoolRequest* makeClusterRequest(const std::string& hash_key, const RespValue& request,
+                                    PoolCallbacks& callbacks);
+    Client& getClient(const Upstream::HostConstSharedPtr& host, uint64_t hash_key);
+    bool redirect(ClusterRequest& request, const ClusterRedirection& redirection);
+    void refreshClusterSlots();
+    void onHostsChanged(const std::vector<Upstream::HostSharedPtr>& hosts_added,
+                        const std::vector<Upstream::HostSharedPtr>& hosts_removed);
+    void closeClients(const ThreadLocalActiveClients& clients);
+
+    // RedisProxy::ConnPool::PoolCallbacks, for the CLUSTER SLOTS requests.
+    void onResponse(RespValuePtr&& value) override;
+    void onFailure() override;
 
     InstanceImpl& parent_;
     Event::Dispatcher& dispatcher_;
     Upstream::ThreadLocalCluster* cluster_;
-    std::unordered_map<Upstream::HostConstSharedPtr, ThreadLocalActiveClientPtr> client_map_;
+    std::unordered_map<Upstream::HostConstSharedPtr, ThreadLocalActiveClients> client_map_;
     Envoy::Common::CallbackHandle* local_host_set_member_update_cb_handle_;
+    // The following are only used in cluster mode. Each worker discovers the slots on its own, so
+    // that routing never needs to synchronize with the other workers.
+    ClusterSlotMap slot_map_;
+    std::unordered_map<std::string, Upstream::HostConstSharedPtr> hosts_by_address_;
+    std::list<ClusterRequestPtr> cluster_requests_;
+    PoolRequest* cluster_slots_request_{};
   };
 
   struct LbContextImpl : public Upstream::LoadBalancerContextBase {
@@ -171,6 +248,10 @@ private:
     const absl::optional<uint64_t> hash_key_;
   };
 
+  // The redirections followed by a request in cluster mode before the error is returned, which
+  // allows for a MOVED followed by an ASK while the slot is being migrated.
+  static const uint32_t MaxClusterRedirections = 2;
+
   Upstream::ClusterManager& cm_;
   ClientFactory& client_factory_;
   ThreadLocal::SlotPtr tls_;
@@ -34,6 +34,11 @@ Network::FilterFactoryCb ConfigFactory::createFilterFactoryFromProtoTyped(
   };
 }
 
+Upstream::ProtocolOptionsConfigConstSharedPtr ConfigFactory::createProtocolOptionsTyped(
+    const envoy::config::filter::network::tcp_proxy::v2::TcpProxyProtocolOptions& proto_config) {
+  return std::make_shared<Envoy::TcpProxy::ProtocolOptionsConfig>(proto_config);
+}
+
 /**
  * Static registration for the tcp_proxy filter. @see RegisterFactory.
  */
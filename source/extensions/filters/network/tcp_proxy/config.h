@@ -14,7 +14,9 @@ namespace TcpProxy {
  * Config registration for the tcp proxy filter. @see NamedNetworkFilterConfigFactory.
  */
 class ConfigFactory
-    : public Common::FactoryBase<envoy::config::filter::network::tcp_proxy::v2::TcpProxy> {
+    : public Common::FactoryBase<
+          envoy::config::filter::network::tcp_proxy::v2::TcpProxy,
+          envoy::config::filter::network::tcp_proxy::v2::TcpProxyProtocolOptions> {
 public:
   ConfigFactory() : FactoryBase(NetworkFilterNames::get().TcpProxy) {}
 
@@ -27,6 +29,10 @@ private:
   Network::FilterFactoryCb createFilterFactoryFromProtoTyped(
       const envoy::config::filter::network::tcp_proxy::v2::TcpProxy& proto_config,
       Server::Configuration::FactoryContext& context) override;
+
+  Upstream::ProtocolOptionsConfigConstSharedPtr createProtocolOptionsTyped(
+      const envoy::config::filter::network::tcp_proxy::v2::TcpProxyProtocolOptions& proto_config)
+      override;
 };
 
 } // namespace TcpProxy
@@ -79,6 +79,28 @@ bool BinaryProtocolImpl::readStructEnd(Buffer::Instance& buffer) {
   return true;
 }
 
+bool BinaryProtocolImpl::peekReplyPayload(Buffer::Instance& buffer, ReplyType& reply_type) {
+  // Binary protocol structs have no header, so the reply starts with the first field header.
+  // FieldType::Stop is encoded as 1 byte.
+  if (buffer.length() < 1) {
+    return false;
+  }
+
+  FieldType type = static_cast<FieldType>(BufferHelper::peekI8(buffer));
+  if (type == FieldType::Stop) {
+    reply_type = ReplyType::Error;
+    return true;
+  }
+
+  // FieldType followed by 2 bytes of field id
+  if (buffer.length() < 3) {
+    return false;
+  }
+
+  reply_type = BufferHelper::peekI16(buffer, 1) == 0 ? ReplyType::Success : ReplyType::Error;
+  return true;
+}
+
 bool BinaryProtocolImpl::readFieldBegin(Buffer::Instance& buffer, std::string& name,
                                         FieldType& field_type, int16_t& field_id) {
   // FieldType::Stop is encoded as 1 byte.
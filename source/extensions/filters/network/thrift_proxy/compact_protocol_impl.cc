@@ -105,6 +105,41 @@ bool CompactProtocolImpl::readStructEnd(Buffer::Instance& buffer) {
   return true;
 }
 
+bool CompactProtocolImpl::peekReplyPayload(Buffer::Instance& buffer, ReplyType& reply_type) {
+  // Compact protocol structs have no header, so the reply starts with the first field header.
+  // FieldType::Stop is encoded as 1 byte.
+  if (buffer.length() < 1) {
+    return false;
+  }
+
+  uint8_t delta_and_type = BufferHelper::peekI8(buffer);
+  if ((delta_and_type & 0x0f) == 0) {
+    reply_type = ReplyType::Error;
+    return true;
+  }
+
+  if ((delta_and_type >> 4) != 0) {
+    // Short form field header: the first field's id is its non-zero delta from 0, so the reply
+    // carries an exception.
+    reply_type = ReplyType::Error;
+    return true;
+  }
+
+  // Long-form field header, followed by zig-zag field id.
+  if (buffer.length() < 2) {
+    return false;
+  }
+
+  int id_size = 0;
+  int32_t id = BufferHelper::peekZigZagI32(buffer, 1, id_size);
+  if (id_size < 0) {
+    return false;
+  }
+
+  reply_type = id == 0 ? ReplyType::Success : ReplyType::Error;
+  return true;
+}
+
 bool CompactProtocolImpl::readFieldBegin(Buffer::Instance& buffer, std::string& name,
                                          FieldType& field_type, int16_t& field_id) {
   // Minimum size: FieldType::Stop is encoded as 1 byte.
@@ -90,7 +90,8 @@ lookupProtocol(envoy::config::filter::network::thrift_proxy::v2alpha1::ProtocolT
 ProtocolOptionsConfigImpl::ProtocolOptionsConfigImpl(
     const envoy::config::filter::network::thrift_proxy::v2alpha1::ThriftProtocolOptions& config)
     : transport_(lookupTransport(config.transport())),
-      protocol_(lookupProtocol(config.protocol())) {}
+      protocol_(lookupProtocol(config.protocol())),
+      multiplex_requests_(config.multiplex_requests()) {}
 
 TransportType ProtocolOptionsConfigImpl::transport(TransportType downstream_transport) const {
   return (transport_ == TransportType::Auto) ? downstream_transport : transport_;
@@ -124,7 +125,8 @@ ConfigImpl::ConfigImpl(
     : context_(context), stats_prefix_(fmt::format("thrift.{}.", config.stat_prefix())),
       stats_(ThriftFilterStats::generateStats(stats_prefix_, context_.scope())),
       transport_(lookupTransport(config.transport())), proto_(lookupProtocol(config.protocol())),
-      route_matcher_(new Router::RouteMatcher(config.route_config())) {
+      route_matcher_(new Router::RouteMatcher(config.route_config())),
+      payload_passthrough_(config.payload_passthrough()) {
 
   // Construct the only Thrift DecoderFilter: the Router
   auto& factory =
@@ -127,6 +127,15 @@ DecoderEventHandler& ConnectionManager::newDecoderEventHandler() {
   return **rpcs_.begin();
 }
 
+bool ConnectionManager::passthroughEnabled() const {
+  if (!config_.payloadPassthrough() || rpcs_.empty()) {
+    return false;
+  }
+
+  // The message being decoded belongs to the most recently created rpc.
+  return (*rpcs_.begin())->passthroughSupported();
+}
+
 bool ConnectionManager::ResponseDecoder::onData(Buffer::Instance& data) {
   upstream_buffer_.move(data);
 
@@ -140,9 +149,25 @@ FilterStatus ConnectionManager::ResponseDecoder::messageBegin(MessageMetadataSha
   metadata_ = metadata;
   first_reply_field_ =
       (metadata->hasMessageType() && metadata->messageType() == MessageType::Reply);
+
+  // The upstream sequence id differs from the downstream one if the upstream connection is shared.
+  metadata->setSequenceId(parent_.metadata_->sequenceId());
   return ProtocolConverter::messageBegin(metadata);
 }
 
+FilterStatus ConnectionManager::ResponseDecoder::passthroughData(Buffer::Instance& data) {
+  if (first_reply_field_) {
+    ReplyType reply_type;
+    if (protocol_.peekReplyPayload(data, reply_type)) {
+      success_ = reply_type == ReplyType::Success;
+    }
+    first_reply_field_ = false;
+  }
+
+  parent_.parent_.stats_.response_passthrough_.inc();
+  return ProtocolConverter::passthroughData(data);
+}
+
 FilterStatus ConnectionManager::ResponseDecoder::fieldBegin(absl::string_view name,
                                                             FieldType field_type,
                                                             int16_t field_id) {
@@ -157,6 +182,13 @@ FilterStatus ConnectionManager::ResponseDecoder::fieldBegin(absl::string_view na
   return ProtocolConverter::fieldBegin(name, field_type, field_id);
 }
 
+bool ConnectionManager::ResponseDecoder::passthroughEnabled() const {
+  // The response body is copied to the downstream connection as is, so it must be encoded with
+  // the downstream protocol.
+  return parent_.parent_.config_.payloadPassthrough() &&
+         protocol_.type() == parent_.parent_.protocol_->type();
+}
+
 FilterStatus ConnectionManager::ResponseDecoder::transportEnd() {
   ASSERT(metadata_ != nullptr);
 
@@ -252,10 +284,21 @@ FilterStatus ConnectionManager::ActiveRpc::messageBegin(MessageMetadataSharedPtr
   return event_handler_->messageBegin(metadata);
 }
 
+FilterStatus ConnectionManager::ActiveRpc::passthroughData(Buffer::Instance& data) {
+  parent_.stats_.request_passthrough_.inc();
+  return event_handler_->passthroughData(data);
+}
+
 void ConnectionManager::ActiveRpc::createFilterChain() {
   parent_.config_.filterFactory().createFilterChain(*this);
 }
 
+bool ConnectionManager::ActiveRpc::passthroughSupported() const {
+  // Protocol upgrade requests are decoded by the protocol's own event handler.
+  return metadata_ != nullptr && !metadata_->isProtocolUpgradeMessage() &&
+         decoder_filter_ != nullptr && decoder_filter_->passthroughSupported();
+}
+
 void ConnectionManager::ActiveRpc::onReset() {
   // TODO(zuercher): e.g., parent_.stats_.named_.downstream_rq_rx_reset_.inc();
   parent_.doDeferredRpcDestroy(*this);
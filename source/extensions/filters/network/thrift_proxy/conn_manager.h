@@ -35,6 +35,11 @@ public:
   virtual TransportPtr createTransport() PURE;
   virtual ProtocolPtr createProtocol() PURE;
   virtual Router::Config& routerConfig() PURE;
+
+  /**
+   * @return bool true if message bodies may be forwarded without being decoded.
+   */
+  virtual bool payloadPassthrough() const PURE;
 };
 
 /**
@@ -46,6 +51,11 @@ public:
 
   virtual TransportType transport(TransportType downstream_transport) const PURE;
   virtual ProtocolType protocol(ProtocolType downstream_protocol) const PURE;
+
+  /**
+   * @return bool true if requests may share upstream connections with other outstanding requests.
+   */
+  virtual bool multiplexRequests() const PURE;
 };
 
 /**
@@ -71,14 +81,16 @@ public:
 
   // DecoderCallbacks
   DecoderEventHandler& newDecoderEventHandler() override;
+  bool passthroughEnabled() const override;
 
 private:
   struct ActiveRpc;
 
   struct ResponseDecoder : public DecoderCallbacks, public ProtocolConverter {
     ResponseDecoder(ActiveRpc& parent, Transport& transport, Protocol& protocol)
-        : parent_(parent), decoder_(std::make_unique<Decoder>(transport, protocol, *this)),
-          complete_(false), first_reply_field_(false) {
+        : parent_(parent), protocol_(protocol),
+          decoder_(std::make_unique<Decoder>(transport, protocol, *this)), complete_(false),
+          first_reply_field_(false) {
       initProtocolConverter(*parent_.parent_.protocol_, parent_.response_buffer_);
     }
 
@@ -86,6 +98,7 @@ private:
 
     // ProtocolConverter
     FilterStatus messageBegin(MessageMetadataSharedPtr metadata) override;
+    FilterStatus passthroughData(Buffer::Instance& data) override;
     FilterStatus fieldBegin(absl::string_view name, FieldType field_type,
                             int16_t field_id) override;
     FilterStatus transportBegin(MessageMetadataSharedPtr metadata) override {
@@ -96,8 +109,10 @@ private:
 
     // DecoderCallbacks
     DecoderEventHandler& newDecoderEventHandler() override { return *this; }
+    bool passthroughEnabled() const override;
 
     ActiveRpc& parent_;
+    Protocol& protocol_;
     DecoderPtr decoder_;
     Buffer::OwnedImpl upstream_buffer_;
     MessageMetadataSharedPtr metadata_;
@@ -130,6 +145,7 @@ private:
     // DecoderEventHandler
     FilterStatus transportEnd() override;
     FilterStatus messageBegin(MessageMetadataSharedPtr metadata) override;
+    FilterStatus passthroughData(Buffer::Instance& data) override;
 
     // ThriftFilters::DecoderFilterCallbacks
     uint64_t streamId() const override { return stream_id_; }
@@ -156,6 +172,7 @@ private:
     }
 
     void createFilterChain();
+    bool passthroughSupported() const;
     void onReset();
     void onError(const std::string& what);
 
@@ -4,6 +4,7 @@
 
 #include "envoy/common/exception.h"
 
+#include "common/buffer/buffer_impl.h"
 #include "common/common/assert.h"
 #include "common/common/macros.h"
 
@@ -14,8 +15,10 @@ namespace Extensions {
 namespace NetworkFilters {
 namespace ThriftProxy {
 
-// MessageBegin -> StructBegin
+// MessageBegin -> StructBegin, or
+// MessageBegin -> PassthroughData
 DecoderStateMachine::DecoderStatus DecoderStateMachine::messageBegin(Buffer::Instance& buffer) {
+  const uint64_t available = buffer.length();
   if (!proto_.readMessageBegin(buffer, *metadata_)) {
     return DecoderStatus(ProtocolState::WaitForData);
   }
@@ -23,7 +26,21 @@ DecoderStateMachine::DecoderStatus DecoderStateMachine::messageBegin(Buffer::Ins
   stack_.clear();
   stack_.emplace_back(Frame(ProtocolState::MessageEnd));
 
-  return DecoderStatus(ProtocolState::StructBegin, handler_.messageBegin(metadata_));
+  FilterStatus status = handler_.messageBegin(metadata_);
+
+  // The size of the message body is only known if the transport reports the frame size.
+  if (metadata_->hasFrameSize() && callbacks_.passthroughEnabled()) {
+    const uint64_t header_bytes = available - buffer.length();
+    if (header_bytes > metadata_->frameSize()) {
+      throw EnvoyException(fmt::format("message header size {} exceeds frame size {}",
+                                       header_bytes, metadata_->frameSize()));
+    }
+
+    body_bytes_ = metadata_->frameSize() - header_bytes;
+    return DecoderStatus(ProtocolState::PassthroughData, status);
+  }
+
+  return DecoderStatus(ProtocolState::StructBegin, status);
 }
 
 // MessageEnd -> Done
@@ -35,6 +52,17 @@ DecoderStateMachine::DecoderStatus DecoderStateMachine::messageEnd(Buffer::Insta
   return DecoderStatus(ProtocolState::Done, handler_.messageEnd());
 }
 
+// PassthroughData -> MessageEnd
+DecoderStateMachine::DecoderStatus DecoderStateMachine::passthroughData(Buffer::Instance& buffer) {
+  if (buffer.length() < body_bytes_) {
+    return DecoderStatus(ProtocolState::WaitForData);
+  }
+
+  Buffer::OwnedImpl body;
+  body.move(buffer, body_bytes_);
+  return DecoderStatus(ProtocolState::MessageEnd, handler_.passthroughData(body));
+}
+
 // StructBegin -> FieldBegin
 DecoderStateMachine::DecoderStatus DecoderStateMachine::structBegin(Buffer::Instance& buffer) {
   std::string name;
@@ -288,6 +316,8 @@ DecoderStateMachine::DecoderStatus DecoderStateMachine::handleState(Buffer::Inst
   switch (state_) {
   case ProtocolState::MessageBegin:
     return messageBegin(buffer);
+  case ProtocolState::PassthroughData:
+    return passthroughData(buffer);
   case ProtocolState::StructBegin:
     return structBegin(buffer);
   case ProtocolState::StructEnd:
@@ -409,7 +439,7 @@ FilterStatus Decoder::onData(Buffer::Instance& data, bool& buffer_underflow) {
     request_ = std::make_unique<ActiveRequest>(callbacks_.newDecoderEventHandler());
     frame_started_ = true;
     state_machine_ =
-        std::make_unique<DecoderStateMachine>(protocol_, metadata_, request_->handler_);
+        std::make_unique<DecoderStateMachine>(protocol_, metadata_, request_->handler_, callbacks_);
 
     if (request_->handler_.transportBegin(metadata_) == FilterStatus::StopIteration) {
       return FilterStatus::StopIteration;
@@ -19,6 +19,7 @@ namespace ThriftProxy {
   FUNCTION(WaitForData)                                                                            \
   FUNCTION(MessageBegin)                                                                           \
   FUNCTION(MessageEnd)                                                                             \
+  FUNCTION(PassthroughData)                                                                        \
   FUNCTION(StructBegin)                                                                            \
   FUNCTION(StructEnd)                                                                              \
   FUNCTION(FieldBegin)                                                                             \
@@ -56,6 +57,23 @@ private:
   }
 };
 
+class DecoderCallbacks {
+public:
+  virtual ~DecoderCallbacks() {}
+
+  /**
+   * @return DecoderEventHandler& a new DecoderEventHandler for a message.
+   */
+  virtual DecoderEventHandler& newDecoderEventHandler() PURE;
+
+  /**
+   * Called once the header of a message has been passed to its DecoderEventHandler.
+   * @return bool true if the message body should be delivered undecoded via passthroughData
+   *         instead of as struct events.
+   */
+  virtual bool passthroughEnabled() const PURE;
+};
+
 /**
  * DecoderStateMachine is the Thrift message state machine as described in
  * source/extensions/filters/network/thrift_proxy/docs.
@@ -63,9 +81,9 @@ private:
 class DecoderStateMachine : public Logger::Loggable<Logger::Id::thrift> {
 public:
   DecoderStateMachine(Protocol& proto, MessageMetadataSharedPtr& metadata,
-                      DecoderEventHandler& handler)
-      : proto_(proto), metadata_(metadata), handler_(handler), state_(ProtocolState::MessageBegin) {
-  }
+                      DecoderEventHandler& handler, DecoderCallbacks& callbacks)
+      : proto_(proto), metadata_(metadata), handler_(handler), callbacks_(callbacks),
+        state_(ProtocolState::MessageBegin) {}
 
   /**
    * Consumes as much data from the configured Buffer as possible and executes the decoding state
@@ -131,6 +149,7 @@ private:
   // or ProtocolState::WaitForData if more data is required.
   DecoderStatus messageBegin(Buffer::Instance& buffer);
   DecoderStatus messageEnd(Buffer::Instance& buffer);
+  DecoderStatus passthroughData(Buffer::Instance& buffer);
   DecoderStatus structBegin(Buffer::Instance& buffer);
   DecoderStatus structEnd(Buffer::Instance& buffer);
   DecoderStatus fieldBegin(Buffer::Instance& buffer);
@@ -165,22 +184,15 @@ private:
   Protocol& proto_;
   MessageMetadataSharedPtr metadata_;
   DecoderEventHandler& handler_;
+  DecoderCallbacks& callbacks_;
   ProtocolState state_;
   std::vector<Frame> stack_;
+  // Size of the message body following the message header, in passthrough mode.
+  uint64_t body_bytes_{};
 };
 
 typedef std::unique_ptr<DecoderStateMachine> DecoderStateMachinePtr;
 
-class DecoderCallbacks {
-public:
-  virtual ~DecoderCallbacks() {}
-
-  /**
-   * @return DecoderEventHandler& a new DecoderEventHandler for a message.
-   */
-  virtual DecoderEventHandler& newDecoderEventHandler() PURE;
-};
-
 /**
  * Decoder encapsulates a configured Transport and Protocol and provides the ability to decode
  * Thrift messages.
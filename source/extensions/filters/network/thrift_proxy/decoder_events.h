@@ -1,5 +1,7 @@
 #pragma once
 
+#include "envoy/buffer/buffer.h"
+
 #include "extensions/filters/network/thrift_proxy/metadata.h"
 #include "extensions/filters/network/thrift_proxy/thrift.h"
 
@@ -48,6 +50,14 @@ public:
    */
   virtual FilterStatus messageEnd() PURE;
 
+  /**
+   * Indicates that the body of a Thrift protocol message was received without being decoded. It
+   * replaces the struct events between messageBegin and messageEnd.
+   * @param data the message body, which may be drained
+   * @return FilterStatus to indicate if filter chain iteration should continue
+   */
+  virtual FilterStatus passthroughData(Buffer::Instance& data) PURE;
+
   /**
    * Indicates that the start of a Thrift protocol struct was detected.
    * @param name the name of the struct, if available
@@ -149,6 +159,9 @@ public:
     return event_handler_->messageBegin(metadata);
   };
   FilterStatus messageEnd() override { return event_handler_->messageEnd(); }
+  FilterStatus passthroughData(Buffer::Instance& data) override {
+    return event_handler_->passthroughData(data);
+  }
   FilterStatus structBegin(absl::string_view name) override {
     return event_handler_->structBegin(name);
   }
@@ -114,6 +114,13 @@ public:
    * Resets the upstream connection.
    */
   virtual void resetUpstreamConnection() PURE;
+
+  /**
+   * Called once a message header has been decoded, to determine whether the message body may be
+   * delivered via passthroughData instead of being decoded into struct events.
+   * @return bool true if the filter accepts an undecoded message body.
+   */
+  virtual bool passthroughSupported() const PURE;
 };
 
 typedef std::shared_ptr<DecoderFilter> DecoderFilterSharedPtr;
@@ -73,6 +73,16 @@ public:
    */
   virtual bool readMessageEnd(Buffer::Instance& buffer) PURE;
 
+  /**
+   * Peeks at the start of a reply message's struct to determine whether the reply carries the call
+   * result or an IDL exception. The buffer is not modified.
+   * @param buffer the buffer to read from, starting after the message header
+   * @param reply_type updated with the type of reply on success only
+   * @return true if the reply type was determined, false if more data is required
+   * @throw EnvoyException if the data is not a valid field header
+   */
+  virtual bool peekReplyPayload(Buffer::Instance& buffer, ReplyType& reply_type) PURE;
+
   /**
    * Reads the start of a Thrift struct from the buffer and updates the name parameter with the
    * value from the struct header. If successful, the struct header is removed from the buffer.
@@ -35,6 +35,11 @@ public:
     return FilterStatus::Continue;
   }
 
+  FilterStatus passthroughData(Buffer::Instance& data) override {
+    buffer_->move(data);
+    return FilterStatus::Continue;
+  }
+
   FilterStatus structBegin(absl::string_view name) override {
     proto_->writeStructBegin(*buffer_, std::string(name));
     return FilterStatus::Continue;
@@ -1,7 +1,9 @@
 #include "extensions/filters/network/thrift_proxy/router/config.h"
 
 #include "envoy/registry/registry.h"
+#include "envoy/singleton/manager.h"
 
+#include "extensions/filters/network/thrift_proxy/router/multiplexed_conn_pool_impl.h"
 #include "extensions/filters/network/thrift_proxy/router/router_impl.h"
 
 namespace Envoy {
@@ -10,14 +12,25 @@ namespace NetworkFilters {
 namespace ThriftProxy {
 namespace Router {
 
+// Singleton registration via macro defined in envoy/singleton/manager.h
+SINGLETON_MANAGER_REGISTRATION(thrift_multiplexed_conn_pool);
+
 ThriftFilters::FilterFactoryCb RouterFilterConfig::createFilterFactoryFromProtoTyped(
     const envoy::config::filter::network::thrift_proxy::v2alpha1::router::Router& proto_config,
     const std::string& stat_prefix, Server::Configuration::FactoryContext& context) {
   UNREFERENCED_PARAMETER(proto_config);
   UNREFERENCED_PARAMETER(stat_prefix);
 
-  return [&context](ThriftFilters::FilterChainFactoryCallbacks& callbacks) -> void {
-    callbacks.addDecoderFilter(std::make_shared<Router>(context.clusterManager()));
+  std::shared_ptr<MultiplexedConnPoolImpl> multiplexed_conn_pool =
+      context.singletonManager().getTyped<MultiplexedConnPoolImpl>(
+          SINGLETON_MANAGER_REGISTERED_NAME(thrift_multiplexed_conn_pool), [&context] {
+            return std::make_shared<MultiplexedConnPoolImpl>(context.threadLocal());
+          });
+
+  return [&context, multiplexed_conn_pool](ThriftFilters::FilterChainFactoryCallbacks& callbacks)
+             -> void {
+    callbacks.addDecoderFilter(
+        std::make_shared<Router>(context.clusterManager(), multiplexed_conn_pool.get()));
   };
 }
 
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "envoy/common/pure.h"
+#include "envoy/network/connection.h"
+#include "envoy/tcp/conn_pool.h"
+#include "envoy/upstream/upstream.h"
+
+#include "extensions/filters/network/thrift_proxy/thrift.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace NetworkFilters {
+namespace ThriftProxy {
+namespace Router {
+
+/**
+ * A request sent over an upstream connection shared with other outstanding requests. Destroying
+ * the request stops waiting for its response.
+ */
+class MultiplexedRequest {
+public:
+  virtual ~MultiplexedRequest() {}
+
+  /**
+   * @return int32_t the sequence id identifying the request and its response on the shared
+   *         connection, which must replace the downstream sequence id in the upstream request.
+   */
+  virtual int32_t sequenceId() const PURE;
+
+  /**
+   * @return Network::ClientConnection& the shared connection to write the request to.
+   */
+  virtual Network::ClientConnection& connection() PURE;
+
+  /**
+   * Set the callbacks receiving the response. The complete response frame is delivered in a single
+   * onUpstreamData call with end_stream set, since no further data follows for the request.
+   * onEvent is called instead if the shared connection is closed before the response arrives.
+   * @param callbacks supplies the callbacks.
+   */
+  virtual void addUpstreamCallbacks(Tcp::ConnectionPool::UpstreamCallbacks& callbacks) PURE;
+
+  /**
+   * Indicates that the request is oneway, so that no response is expected. Otherwise, destroying
+   * the request before its response arrives prevents the shared connection from being reused.
+   */
+  virtual void setOneway() PURE;
+};
+
+typedef std::unique_ptr<MultiplexedRequest> MultiplexedRequestPtr;
+
+/**
+ * Pool callbacks invoked in the context of a MultiplexedConnPool::newRequest() call, either
+ * synchronously or asynchronously.
+ */
+class MultiplexedConnPoolCallbacks {
+public:
+  virtual ~MultiplexedConnPoolCallbacks() {}
+
+  /**
+   * Called when a shared connection could not be established.
+   * @param reason supplies the failure reason.
+   * @param host supplies the description of the host that caused the failure. This may be nullptr
+   *             if no host was involved in the failure (for example overflow).
+   */
+  virtual void onPoolFailure(Tcp::ConnectionPool::PoolFailureReason reason,
+                             Upstream::HostDescriptionConstSharedPtr host) PURE;
+
+  /**
+   * Called when a shared connection is available to send the request.
+   * @param request supplies the request.
+   * @param host supplies the description of the host that will carry the request.
+   */
+  virtual void onPoolReady(MultiplexedRequestPtr&& request,
+                           Upstream::HostDescriptionConstSharedPtr host) PURE;
+};
+
+/**
+ * A per-worker pool of upstream connections shared by requests whose transport delimits frames,
+ * so that responses can be matched to their requests by sequence id.
+ */
+class MultiplexedConnPool {
+public:
+  virtual ~MultiplexedConnPool() {}
+
+  /**
+   * Assign a shared connection to a request, establishing it from conn_pool if necessary.
+   * @param conn_pool supplies the pool of the selected upstream host.
+   * @param transport supplies the upstream transport, which must be framed or header.
+   * @param protocol supplies the upstream protocol, which must not require an upgrade.
+   * @param callbacks supplies the callbacks to invoke when a connection is ready or has failed.
+   * @return a handle to cancel the request if it is pending, or nullptr if the callbacks were
+   *         already invoked.
+   */
+  virtual Tcp::ConnectionPool::Cancellable*
+  newRequest(Tcp::ConnectionPool::Instance& conn_pool, TransportType transport,
+             ProtocolType protocol, MultiplexedConnPoolCallbacks& callbacks) PURE;
+};
+
+} // namespace Router
+} // namespace ThriftProxy
+} // namespace NetworkFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,330 @@
+#include "extensions/filters/network/thrift_proxy/router/multiplexed_conn_pool_impl.h"
+
+#include <vector>
+
+#include "envoy/common/exception.h"
+
+#include "common/common/assert.h"
+#include "common/common/fmt.h"
+
+#include "extensions/filters/network/thrift_proxy/buffer_helper.h"
+#include "extensions/filters/network/thrift_proxy/framed_transport_impl.h"
+#include "extensions/filters/network/thrift_proxy/header_transport_impl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace NetworkFilters {
+namespace ThriftProxy {
+namespace Router {
+
+namespace {
+
+// Both framed and header transport frames start with their size, not including the size itself.
+constexpr uint64_t FrameSizeLength = 4;
+
+// Offset of the sequence id in a header transport frame, after the frame size, magic and flags.
+constexpr uint64_t HeaderSequenceIdOffset = 8;
+
+} // namespace
+
+MultiplexedConnPoolImpl::MultiplexedConnPoolImpl(ThreadLocal::SlotAllocator& tls)
+    : tls_(tls.allocateSlot()) {
+  tls_->set([](Event::Dispatcher& dispatcher) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<ThreadLocalPool>(dispatcher);
+  });
+}
+
+Tcp::ConnectionPool::Cancellable*
+MultiplexedConnPoolImpl::newRequest(Tcp::ConnectionPool::Instance& conn_pool,
+                                    TransportType transport, ProtocolType protocol,
+                                    MultiplexedConnPoolCallbacks& callbacks) {
+  return tls_->getTyped<ThreadLocalPool>().newRequest(conn_pool, transport, protocol, callbacks);
+}
+
+Tcp::ConnectionPool::Cancellable* MultiplexedConnPoolImpl::ThreadLocalPool::newRequest(
+    Tcp::ConnectionPool::Instance& conn_pool, TransportType transport, ProtocolType protocol,
+    MultiplexedConnPoolCallbacks& callbacks) {
+  ASSERT(transport == TransportType::Framed || transport == TransportType::Header);
+
+  const SharedConnection::Key key(&conn_pool, transport, protocol);
+  auto it = connections_.find(key);
+  if (it == connections_.end()) {
+    it = connections_.emplace(key, std::make_unique<SharedConnection>(*this, key)).first;
+  }
+
+  return it->second->newRequest(callbacks);
+}
+
+void MultiplexedConnPoolImpl::ThreadLocalPool::onConnectionIdle(SharedConnection& connection) {
+  auto it = connections_.find(connection.key_);
+  if (it == connections_.end() || it->second.get() != &connection) {
+    // Already removed.
+    return;
+  }
+
+  // Connections are removed once idle, so that none outlives the Tcp connection pool it refers to.
+  dispatcher_.deferredDelete(std::move(it->second));
+  connections_.erase(it);
+}
+
+MultiplexedConnPoolImpl::SharedConnection::SharedConnection(ThreadLocalPool& parent,
+                                                            const Key& key)
+    : parent_(parent), key_(key), conn_pool_(*std::get<0>(key)), transport_type_(std::get<1>(key)),
+      protocol_(NamedProtocolConfigFactory::getFactory(std::get<2>(key)).createProtocol()) {}
+
+MultiplexedConnPoolImpl::SharedConnection::~SharedConnection() {
+  ASSERT(pending_requests_.empty() && active_requests_.empty());
+
+  if (conn_pool_handle_ != nullptr) {
+    conn_pool_handle_->cancel();
+  }
+}
+
+Tcp::ConnectionPool::Cancellable*
+MultiplexedConnPoolImpl::SharedConnection::newRequest(MultiplexedConnPoolCallbacks& callbacks) {
+  if (conn_data_ != nullptr) {
+    assignRequest(callbacks);
+    return nullptr;
+  }
+
+  PendingRequestPtr pending_request(new PendingRequest(*this, callbacks));
+  PendingRequest* handle = pending_request.get();
+  pending_request->moveIntoList(std::move(pending_request), pending_requests_);
+
+  if (conn_pool_handle_ == nullptr) {
+    Tcp::ConnectionPool::Cancellable* conn_pool_handle = conn_pool_.newConnection(*this);
+    if (conn_pool_handle == nullptr) {
+      // The Tcp connection pool invoked our callbacks, which handled the request.
+      return nullptr;
+    }
+
+    conn_pool_handle_ = conn_pool_handle;
+  }
+
+  return handle;
+}
+
+void MultiplexedConnPoolImpl::SharedConnection::onPoolFailure(
+    Tcp::ConnectionPool::PoolFailureReason reason, Upstream::HostDescriptionConstSharedPtr host) {
+  conn_pool_handle_ = nullptr;
+
+  while (!pending_requests_.empty()) {
+    PendingRequestPtr request = pending_requests_.front()->removeFromList(pending_requests_);
+    request->callbacks_.onPoolFailure(reason, host);
+  }
+
+  checkForIdle();
+}
+
+void MultiplexedConnPoolImpl::SharedConnection::onPoolReady(
+    Tcp::ConnectionPool::ConnectionDataPtr&& conn_data,
+    Upstream::HostDescriptionConstSharedPtr host) {
+  conn_pool_handle_ = nullptr;
+  conn_data_ = std::move(conn_data);
+  conn_data_->addUpstreamCallbacks(*this);
+  host_ = host;
+
+  while (!pending_requests_.empty() && conn_data_ != nullptr) {
+    PendingRequestPtr request = pending_requests_.front()->removeFromList(pending_requests_);
+    assignRequest(request->callbacks_);
+  }
+
+  checkForIdle();
+}
+
+void MultiplexedConnPoolImpl::SharedConnection::onUpstreamData(Buffer::Instance& data,
+                                                               bool end_stream) {
+  response_buffer_.move(data);
+
+  dispatching_ = true;
+  try {
+    while (conn_data_ != nullptr && dispatchResponse()) {
+    }
+  } catch (const EnvoyException& ex) {
+    ENVOY_LOG(debug, "thrift: invalid response on shared upstream connection: {}", ex.what());
+    end_stream = true;
+  }
+  dispatching_ = false;
+
+  if (end_stream && conn_data_ != nullptr) {
+    // Outstanding requests can't be completed.
+    conn_data_->connection().close(Network::ConnectionCloseType::NoFlush);
+  }
+
+  checkForIdle();
+}
+
+void MultiplexedConnPoolImpl::SharedConnection::onEvent(Network::ConnectionEvent event) {
+  if (conn_data_ == nullptr) {
+    // The connection was closed by checkForIdle().
+    return;
+  }
+
+  switch (event) {
+  case Network::ConnectionEvent::RemoteClose:
+  case Network::ConnectionEvent::LocalClose:
+    conn_data_.reset();
+    response_buffer_.drain(response_buffer_.length());
+    close_on_idle_ = false;
+    closeRequests(event);
+
+    // Requests that were still waiting for the connection fail as if it couldn't be established.
+    onPoolFailure(event == Network::ConnectionEvent::RemoteClose
+                      ? Tcp::ConnectionPool::PoolFailureReason::RemoteConnectionFailure
+                      : Tcp::ConnectionPool::PoolFailureReason::LocalConnectionFailure,
+                  host_);
+    break;
+  default:
+    // Connected is consumed by the connection pool.
+    NOT_REACHED_GCOVR_EXCL_LINE;
+  }
+}
+
+void MultiplexedConnPoolImpl::SharedConnection::PendingRequest::cancel() {
+  SharedConnection& parent = parent_;
+  removeFromList(parent.pending_requests_);
+
+  if (parent.pending_requests_.empty() && parent.conn_pool_handle_ != nullptr) {
+    parent.conn_pool_handle_->cancel();
+    parent.conn_pool_handle_ = nullptr;
+    parent.checkForIdle();
+  }
+}
+
+MultiplexedConnPoolImpl::SharedConnection::ActiveRequest::~ActiveRequest() {
+  parent_.onRequestReleased(*this);
+}
+
+Network::ClientConnection& MultiplexedConnPoolImpl::SharedConnection::ActiveRequest::connection() {
+  ASSERT(!closed_ && parent_.conn_data_ != nullptr);
+  return parent_.conn_data_->connection();
+}
+
+void MultiplexedConnPoolImpl::SharedConnection::assignRequest(
+    MultiplexedConnPoolCallbacks& callbacks) {
+  const int32_t sequence_id = nextSequenceId();
+  MultiplexedRequestPtr request(new ActiveRequest(*this, sequence_id));
+  active_requests_.emplace(sequence_id, static_cast<ActiveRequest*>(request.get()));
+
+  callbacks.onPoolReady(std::move(request), host_);
+}
+
+int32_t MultiplexedConnPoolImpl::SharedConnection::nextSequenceId() {
+  // Skip the sequence ids of requests still outstanding after the counter wrapped around.
+  while (active_requests_.count(static_cast<int32_t>(next_sequence_id_)) > 0) {
+    next_sequence_id_++;
+  }
+  return static_cast<int32_t>(next_sequence_id_++);
+}
+
+bool MultiplexedConnPoolImpl::SharedConnection::dispatchResponse() {
+  if (response_buffer_.length() < FrameSizeLength) {
+    return false;
+  }
+
+  const int32_t frame_size = BufferHelper::peekI32(response_buffer_);
+  const int32_t max_frame_size = transport_type_ == TransportType::Header
+                                     ? HeaderTransportImpl::MaxFrameSize
+                                     : FramedTransportImpl::MaxFrameSize;
+  if (frame_size <= 0 || frame_size > max_frame_size ||
+      (transport_type_ == TransportType::Header &&
+       static_cast<uint64_t>(frame_size) < HeaderSequenceIdOffset)) {
+    throw EnvoyException(fmt::format("invalid thrift frame size {}", frame_size));
+  }
+
+  if (response_buffer_.length() < FrameSizeLength + frame_size) {
+    return false;
+  }
+
+  Buffer::OwnedImpl frame;
+  frame.move(response_buffer_, FrameSizeLength + frame_size);
+
+  const int32_t sequence_id = transport_type_ == TransportType::Header
+                                  ? BufferHelper::peekI32(frame, HeaderSequenceIdOffset)
+                                  : messageSequenceId(frame);
+
+  auto it = active_requests_.find(sequence_id);
+  if (it == active_requests_.end() || it->second->callbacks_ == nullptr) {
+    ENVOY_LOG(debug, "thrift: dropping response with unknown sequence id {}", sequence_id);
+    return true;
+  }
+
+  ActiveRequest& request = *it->second;
+  request.response_complete_ = true;
+  request.callbacks_->onUpstreamData(frame, true);
+  return true;
+}
+
+int32_t MultiplexedConnPoolImpl::SharedConnection::messageSequenceId(Buffer::Instance& frame) {
+  // Framed transport only carries the sequence id in the message, which is decoded from a copy of
+  // the frame so that the frame is delivered intact.
+  Buffer::OwnedImpl message;
+  message.add(frame);
+  message.drain(FrameSizeLength);
+
+  MessageMetadata metadata;
+  if (!protocol_->readMessageBegin(message, metadata) || !metadata.hasSequenceId()) {
+    throw EnvoyException("invalid thrift response message");
+  }
+
+  return metadata.sequenceId();
+}
+
+void MultiplexedConnPoolImpl::SharedConnection::onRequestReleased(ActiveRequest& request) {
+  if (!request.oneway_ && !request.response_complete_ && !request.closed_) {
+    close_on_idle_ = true;
+  }
+
+  active_requests_.erase(request.sequence_id_);
+  checkForIdle();
+}
+
+void MultiplexedConnPoolImpl::SharedConnection::closeRequests(Network::ConnectionEvent event) {
+  // Callbacks may release any request, so they are looked up again before each call.
+  std::vector<int32_t> sequence_ids;
+  for (const auto& entry : active_requests_) {
+    if (!entry.second->closed_) {
+      sequence_ids.push_back(entry.first);
+    }
+  }
+
+  for (const int32_t sequence_id : sequence_ids) {
+    auto it = active_requests_.find(sequence_id);
+    if (it == active_requests_.end()) {
+      continue;
+    }
+
+    ActiveRequest& request = *it->second;
+    request.closed_ = true;
+
+    Tcp::ConnectionPool::UpstreamCallbacks* callbacks = request.callbacks_;
+    request.callbacks_ = nullptr;
+    if (callbacks != nullptr) {
+      callbacks->onEvent(event);
+    }
+  }
+}
+
+void MultiplexedConnPoolImpl::SharedConnection::checkForIdle() {
+  if (dispatching_ || conn_pool_handle_ != nullptr || !pending_requests_.empty() ||
+      !active_requests_.empty()) {
+    return;
+  }
+
+  if (conn_data_ != nullptr) {
+    Tcp::ConnectionPool::ConnectionDataPtr conn_data = std::move(conn_data_);
+    if (close_on_idle_) {
+      // A response to a released request may still arrive, so the connection can't be reused.
+      conn_data->connection().close(Network::ConnectionCloseType::NoFlush);
+    }
+    // Otherwise, destroying the connection data returns the connection to the Tcp connection pool.
+  }
+
+  parent_.onConnectionIdle(*this);
+}
+
+} // namespace Router
+} // namespace ThriftProxy
+} // namespace NetworkFilters
+} // namespace Extensions
+} // namespace Envoy
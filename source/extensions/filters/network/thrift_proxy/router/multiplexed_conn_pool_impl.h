@@ -0,0 +1,150 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <unordered_map>
+
+#include "envoy/event/deferred_deletable.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/singleton/instance.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "common/buffer/buffer_impl.h"
+#include "common/common/linked_object.h"
+#include "common/common/logger.h"
+
+#include "extensions/filters/network/thrift_proxy/protocol.h"
+#include "extensions/filters/network/thrift_proxy/router/multiplexed_conn_pool.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace NetworkFilters {
+namespace ThriftProxy {
+namespace Router {
+
+class MultiplexedConnPoolImpl : public MultiplexedConnPool, public Singleton::Instance {
+public:
+  MultiplexedConnPoolImpl(ThreadLocal::SlotAllocator& tls);
+
+  // Router::MultiplexedConnPool
+  Tcp::ConnectionPool::Cancellable* newRequest(Tcp::ConnectionPool::Instance& conn_pool,
+                                               TransportType transport, ProtocolType protocol,
+                                               MultiplexedConnPoolCallbacks& callbacks) override;
+
+private:
+  struct ThreadLocalPool;
+
+  /**
+   * An upstream connection taken from a Tcp connection pool and shared by the requests to its
+   * host. It is returned to the Tcp connection pool once no request is outstanding.
+   */
+  struct SharedConnection : public Tcp::ConnectionPool::Callbacks,
+                            public Tcp::ConnectionPool::UpstreamCallbacks,
+                            public Event::DeferredDeletable,
+                            Logger::Loggable<Logger::Id::thrift> {
+    typedef std::tuple<Tcp::ConnectionPool::Instance*, TransportType, ProtocolType> Key;
+
+    SharedConnection(ThreadLocalPool& parent, const Key& key);
+    ~SharedConnection();
+
+    Tcp::ConnectionPool::Cancellable* newRequest(MultiplexedConnPoolCallbacks& callbacks);
+
+    // Tcp::ConnectionPool::Callbacks
+    void onPoolFailure(Tcp::ConnectionPool::PoolFailureReason reason,
+                       Upstream::HostDescriptionConstSharedPtr host) override;
+    void onPoolReady(Tcp::ConnectionPool::ConnectionDataPtr&& conn_data,
+                     Upstream::HostDescriptionConstSharedPtr host) override;
+
+    // Tcp::ConnectionPool::UpstreamCallbacks
+    void onUpstreamData(Buffer::Instance& data, bool end_stream) override;
+    void onEvent(Network::ConnectionEvent event) override;
+    void onAboveWriteBufferHighWatermark() override {}
+    void onBelowWriteBufferLowWatermark() override {}
+
+    struct PendingRequest : LinkedObject<PendingRequest>, public Tcp::ConnectionPool::Cancellable {
+      PendingRequest(SharedConnection& parent, MultiplexedConnPoolCallbacks& callbacks)
+          : parent_(parent), callbacks_(callbacks) {}
+
+      // Tcp::ConnectionPool::Cancellable
+      void cancel() override;
+
+      SharedConnection& parent_;
+      MultiplexedConnPoolCallbacks& callbacks_;
+    };
+
+    typedef std::unique_ptr<PendingRequest> PendingRequestPtr;
+
+    struct ActiveRequest : public MultiplexedRequest {
+      ActiveRequest(SharedConnection& parent, int32_t sequence_id)
+          : parent_(parent), sequence_id_(sequence_id) {}
+      ~ActiveRequest();
+
+      // Router::MultiplexedRequest
+      int32_t sequenceId() const override { return sequence_id_; }
+      Network::ClientConnection& connection() override;
+      void addUpstreamCallbacks(Tcp::ConnectionPool::UpstreamCallbacks& callbacks) override {
+        callbacks_ = &callbacks;
+      }
+      void setOneway() override { oneway_ = true; }
+
+      SharedConnection& parent_;
+      const int32_t sequence_id_;
+      Tcp::ConnectionPool::UpstreamCallbacks* callbacks_{};
+      bool oneway_{};
+      bool response_complete_{};
+      // Set once the connection carrying the request is closed.
+      bool closed_{};
+    };
+
+    void assignRequest(MultiplexedConnPoolCallbacks& callbacks);
+    int32_t nextSequenceId();
+    bool dispatchResponse();
+    int32_t messageSequenceId(Buffer::Instance& frame);
+    void onRequestReleased(ActiveRequest& request);
+    void closeRequests(Network::ConnectionEvent event);
+    void checkForIdle();
+
+    ThreadLocalPool& parent_;
+    const Key key_;
+    Tcp::ConnectionPool::Instance& conn_pool_;
+    const TransportType transport_type_;
+    ProtocolPtr protocol_;
+    Tcp::ConnectionPool::Cancellable* conn_pool_handle_{};
+    Tcp::ConnectionPool::ConnectionDataPtr conn_data_;
+    Upstream::HostDescriptionConstSharedPtr host_;
+    std::list<PendingRequestPtr> pending_requests_;
+    // Requests by sequence id, kept until released even if the connection closes since the router
+    // owns them.
+    std::unordered_map<int32_t, ActiveRequest*> active_requests_;
+    Buffer::OwnedImpl response_buffer_;
+    uint32_t next_sequence_id_{};
+    bool dispatching_{};
+    // Set when a request is released while its response may still arrive.
+    bool close_on_idle_{};
+  };
+
+  typedef std::unique_ptr<SharedConnection> SharedConnectionPtr;
+
+  struct ThreadLocalPool : public ThreadLocal::ThreadLocalObject {
+    ThreadLocalPool(Event::Dispatcher& dispatcher) : dispatcher_(dispatcher) {}
+
+    Tcp::ConnectionPool::Cancellable* newRequest(Tcp::ConnectionPool::Instance& conn_pool,
+                                                 TransportType transport, ProtocolType protocol,
+                                                 MultiplexedConnPoolCallbacks& callbacks);
+    void onConnectionIdle(SharedConnection& connection);
+
+    Event::Dispatcher& dispatcher_;
+    std::map<SharedConnection::Key, SharedConnectionPtr> connections_;
+  };
+
+  ThreadLocal::SlotPtr tls_;
+};
+
+} // namespace Router
+} // namespace ThriftProxy
+} // namespace NetworkFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -15,6 +15,34 @@ namespace NetworkFilters {
 namespace ThriftProxy {
 namespace Router {
 
+namespace {
+
+// Replaces the downstream sequence id in the request metadata with the one identifying the request
+// on a shared upstream connection while the request is encoded. The downstream sequence id is kept
+// otherwise, since it is used for the response and local replies.
+class ScopedUpstreamSequenceId {
+public:
+  ScopedUpstreamSequenceId(MessageMetadata& metadata, const MultiplexedRequest* request)
+      : metadata_(metadata) {
+    if (request != nullptr) {
+      downstream_sequence_id_ = metadata_.sequenceId();
+      metadata_.setSequenceId(request->sequenceId());
+    }
+  }
+
+  ~ScopedUpstreamSequenceId() {
+    if (downstream_sequence_id_.has_value()) {
+      metadata_.setSequenceId(downstream_sequence_id_.value());
+    }
+  }
+
+private:
+  MessageMetadata& metadata_;
+  absl::optional<int32_t> downstream_sequence_id_;
+};
+
+} // namespace
+
 RouteEntryImplBase::RouteEntryImplBase(
     const envoy::config::filter::network::thrift_proxy::v2alpha1::Route& route)
     : cluster_name_(route.route().cluster()) {
@@ -235,8 +263,9 @@ FilterStatus Router::messageBegin(MessageMetadataSharedPtr metadata) {
                                       : callbacks_->downstreamTransportType();
   ASSERT(transport != TransportType::Auto);
 
-  const ProtocolType protocol = options ? options->protocol(callbacks_->downstreamProtocolType())
-                                        : callbacks_->downstreamProtocolType();
+  const ProtocolType downstream_protocol = callbacks_->downstreamProtocolType();
+  const ProtocolType protocol =
+      options ? options->protocol(downstream_protocol) : downstream_protocol;
   ASSERT(protocol != ProtocolType::Auto);
 
   Tcp::ConnectionPool::Instance* conn_pool = cluster_manager_.tcpConnPoolForCluster(
@@ -248,9 +277,20 @@ FilterStatus Router::messageBegin(MessageMetadataSharedPtr metadata) {
     return FilterStatus::StopIteration;
   }
 
+  // Requests may share upstream connections if their responses can be delimited to be matched by
+  // sequence id, which requires framed or header transport.
+  MultiplexedConnPool* multiplexed_conn_pool =
+      options && options->multiplexRequests() &&
+              (transport == TransportType::Framed || transport == TransportType::Header)
+          ? multiplexed_conn_pool_
+          : nullptr;
+
+  passthrough_supported_ = protocol == downstream_protocol;
+
   ENVOY_STREAM_LOG(debug, "router decoding request", *callbacks_);
 
-  upstream_request_.reset(new UpstreamRequest(*this, *conn_pool, metadata, transport, protocol));
+  upstream_request_.reset(new UpstreamRequest(*this, *conn_pool, multiplexed_conn_pool, metadata,
+                                              transport, protocol));
   return upstream_request_->start();
 }
 
@@ -261,9 +301,13 @@ FilterStatus Router::messageEnd() {
 
   upstream_request_->metadata_->setProtocol(upstream_request_->protocol_->type());
 
-  upstream_request_->transport_->encodeFrame(transport_buffer, *upstream_request_->metadata_,
-                                             upstream_request_buffer_);
-  upstream_request_->conn_data_->connection().write(transport_buffer, false);
+  {
+    ScopedUpstreamSequenceId sequence_id(*upstream_request_->metadata_,
+                                         upstream_request_->multiplexed_request_.get());
+    upstream_request_->transport_->encodeFrame(transport_buffer, *upstream_request_->metadata_,
+                                               upstream_request_buffer_);
+  }
+  upstream_request_->connection().write(transport_buffer, false);
   upstream_request_->onRequestComplete();
   return FilterStatus::Continue;
 }
@@ -341,9 +385,10 @@ void Router::convertMessageBegin(MessageMetadataSharedPtr metadata) {
 void Router::cleanup() { upstream_request_.reset(); }
 
 Router::UpstreamRequest::UpstreamRequest(Router& parent, Tcp::ConnectionPool::Instance& pool,
+                                         MultiplexedConnPool* multiplexed_pool,
                                          MessageMetadataSharedPtr& metadata,
                                          TransportType transport_type, ProtocolType protocol_type)
-    : parent_(parent), conn_pool_(pool), metadata_(metadata),
+    : parent_(parent), conn_pool_(pool), multiplexed_pool_(multiplexed_pool), metadata_(metadata),
       transport_(NamedTransportConfigFactory::getFactory(transport_type).createTransport()),
       protocol_(NamedProtocolConfigFactory::getFactory(protocol_type).createProtocol()),
       request_complete_(false), response_started_(false), response_complete_(false) {}
@@ -351,7 +396,15 @@ Router::UpstreamRequest::UpstreamRequest(Router& parent, Tcp::ConnectionPool::In
 Router::UpstreamRequest::~UpstreamRequest() {}
 
 FilterStatus Router::UpstreamRequest::start() {
-  Tcp::ConnectionPool::Cancellable* handle = conn_pool_.newConnection(*this);
+  if (protocol_->supportsUpgrade()) {
+    // Protocol upgrades are negotiated per connection before any request is sent.
+    multiplexed_pool_ = nullptr;
+  }
+
+  Tcp::ConnectionPool::Cancellable* handle =
+      multiplexed_pool_ != nullptr
+          ? multiplexed_pool_->newRequest(conn_pool_, transport_->type(), protocol_->type(), *this)
+          : conn_pool_.newConnection(*this);
   if (handle) {
     // Pause while we wait for a connection.
     conn_pool_handle_ = handle;
@@ -375,6 +428,14 @@ void Router::UpstreamRequest::resetStream() {
     conn_data_->connection().close(Network::ConnectionCloseType::NoFlush);
     conn_data_.reset();
   }
+
+  // A shared connection is left to the other requests.
+  multiplexed_request_.reset();
+}
+
+Network::ClientConnection& Router::UpstreamRequest::connection() {
+  return multiplexed_request_ != nullptr ? multiplexed_request_->connection()
+                                         : conn_data_->connection();
 }
 
 void Router::UpstreamRequest::onPoolFailure(Tcp::ConnectionPool::PoolFailureReason reason,
@@ -414,11 +475,29 @@ void Router::UpstreamRequest::onPoolReady(Tcp::ConnectionPool::ConnectionDataPtr
   onRequestStart(continue_decoding);
 }
 
+void Router::UpstreamRequest::onPoolReady(MultiplexedRequestPtr&& request,
+                                          Upstream::HostDescriptionConstSharedPtr host) {
+  // Only invoke continueDecoding if we'd previously stopped the filter chain.
+  bool continue_decoding = conn_pool_handle_ != nullptr;
+
+  onUpstreamHostSelected(host);
+  multiplexed_request_ = std::move(request);
+  multiplexed_request_->addUpstreamCallbacks(parent_);
+  if (metadata_->messageType() == MessageType::Oneway) {
+    multiplexed_request_->setOneway();
+  }
+  conn_pool_handle_ = nullptr;
+
+  onRequestStart(continue_decoding);
+}
+
 void Router::UpstreamRequest::onRequestStart(bool continue_decoding) {
   parent_.initProtocolConverter(*protocol_, parent_.upstream_request_buffer_);
 
-  // TODO(zuercher): need to use an upstream-connection-specific sequence id
-  parent_.convertMessageBegin(metadata_);
+  {
+    ScopedUpstreamSequenceId sequence_id(*metadata_, multiplexed_request_.get());
+    parent_.convertMessageBegin(metadata_);
+  }
 
   if (continue_decoding) {
     parent_.callbacks_->continueDecoding();
@@ -430,6 +509,7 @@ void Router::UpstreamRequest::onRequestComplete() { request_complete_ = true; }
 void Router::UpstreamRequest::onResponseComplete() {
   response_complete_ = true;
   conn_data_.reset();
+  multiplexed_request_.reset();
 }
 
 void Router::UpstreamRequest::onUpstreamHostSelected(Upstream::HostDescriptionConstSharedPtr host) {
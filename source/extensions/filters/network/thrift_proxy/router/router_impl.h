@@ -14,6 +14,7 @@
 
 #include "extensions/filters/network/thrift_proxy/conn_manager.h"
 #include "extensions/filters/network/thrift_proxy/filters/filter.h"
+#include "extensions/filters/network/thrift_proxy/router/multiplexed_conn_pool.h"
 #include "extensions/filters/network/thrift_proxy/router/router.h"
 #include "extensions/filters/network/thrift_proxy/thrift_object.h"
 
@@ -121,7 +122,9 @@ class Router : public Tcp::ConnectionPool::UpstreamCallbacks,
                public ThriftFilters::DecoderFilter,
                Logger::Loggable<Logger::Id::thrift> {
 public:
-  Router(Upstream::ClusterManager& cluster_manager) : cluster_manager_(cluster_manager) {}
+  Router(Upstream::ClusterManager& cluster_manager,
+         MultiplexedConnPool* multiplexed_conn_pool = nullptr)
+      : cluster_manager_(cluster_manager), multiplexed_conn_pool_(multiplexed_conn_pool) {}
 
   ~Router() {}
 
@@ -129,6 +132,7 @@ public:
   void onDestroy() override;
   void setDecoderFilterCallbacks(ThriftFilters::DecoderFilterCallbacks& callbacks) override;
   void resetUpstreamConnection() override;
+  bool passthroughSupported() const override { return passthrough_supported_; }
 
   // ProtocolConverter
   FilterStatus transportBegin(MessageMetadataSharedPtr metadata) override;
@@ -146,21 +150,27 @@ public:
   void onBelowWriteBufferLowWatermark() override {}
 
 private:
-  struct UpstreamRequest : public Tcp::ConnectionPool::Callbacks {
+  struct UpstreamRequest : public Tcp::ConnectionPool::Callbacks,
+                           public MultiplexedConnPoolCallbacks {
     UpstreamRequest(Router& parent, Tcp::ConnectionPool::Instance& pool,
-                    MessageMetadataSharedPtr& metadata, TransportType transport_type,
-                    ProtocolType protocol_type);
+                    MultiplexedConnPool* multiplexed_pool, MessageMetadataSharedPtr& metadata,
+                    TransportType transport_type, ProtocolType protocol_type);
     ~UpstreamRequest();
 
     FilterStatus start();
     void resetStream();
+    Network::ClientConnection& connection();
 
-    // Tcp::ConnectionPool::Callbacks
+    // Tcp::ConnectionPool::Callbacks and MultiplexedConnPoolCallbacks
     void onPoolFailure(Tcp::ConnectionPool::PoolFailureReason reason,
                        Upstream::HostDescriptionConstSharedPtr host) override;
     void onPoolReady(Tcp::ConnectionPool::ConnectionDataPtr&& conn,
                      Upstream::HostDescriptionConstSharedPtr host) override;
 
+    // MultiplexedConnPoolCallbacks
+    void onPoolReady(MultiplexedRequestPtr&& request,
+                     Upstream::HostDescriptionConstSharedPtr host) override;
+
     void onRequestStart(bool continue_decoding);
     void onRequestComplete();
     void onResponseComplete();
@@ -169,10 +179,13 @@ private:
 
     Router& parent_;
     Tcp::ConnectionPool::Instance& conn_pool_;
+    // Set if the request may share an upstream connection with other requests.
+    MultiplexedConnPool* multiplexed_pool_;
     MessageMetadataSharedPtr metadata_;
 
     Tcp::ConnectionPool::Cancellable* conn_pool_handle_{};
     Tcp::ConnectionPool::ConnectionDataPtr conn_data_;
+    MultiplexedRequestPtr multiplexed_request_;
     Upstream::HostDescriptionConstSharedPtr upstream_host_;
     TransportPtr transport_;
     ProtocolPtr protocol_;
@@ -187,6 +200,7 @@ private:
   void cleanup();
 
   Upstream::ClusterManager& cluster_manager_;
+  MultiplexedConnPool* multiplexed_conn_pool_;
 
   ThriftFilters::DecoderFilterCallbacks* callbacks_{};
   RouteConstSharedPtr route_{};
@@ -195,6 +209,9 @@ private:
 
   std::unique_ptr<UpstreamRequest> upstream_request_;
   Buffer::OwnedImpl upstream_request_buffer_;
+  // Set if the request body can be forwarded as is, because the upstream protocol matches the
+  // downstream protocol.
+  bool passthrough_supported_{};
 };
 
 } // namespace Router
@@ -21,6 +21,7 @@ namespace ThriftProxy {
   COUNTER(request_invalid_type)                                                                    \
   GAUGE(request_active)                                                                            \
   COUNTER(request_decoding_error)                                                                  \
+  COUNTER(request_passthrough)                                                                     \
   HISTOGRAM(request_time_ms)                                                                       \
   COUNTER(response)                                                                                \
   COUNTER(response_reply)                                                                          \
@@ -29,6 +30,7 @@ namespace ThriftProxy {
   COUNTER(response_exception)                                                                      \
   COUNTER(response_invalid_type)                                                                   \
   COUNTER(response_decoding_error)                                                                 \
+  COUNTER(response_passthrough)                                                                    \
   COUNTER(cx_destroy_local_with_active_rq)                                                         \
   COUNTER(cx_destroy_remote_with_active_rq)
 // clang-format on
@@ -112,6 +112,15 @@ enum class MessageType {
   LastMessageType = Oneway,
 };
 
+/**
+ * Outcome of a Thrift reply message: the reply struct's first field is either the call result
+ * (field 0) or an IDL exception.
+ */
+enum class ReplyType {
+  Success,
+  Error,
+};
+
 /**
  * Thrift protocol struct field types.
  * See https://github.com/apache/thrift/blob/master/lib/cpp/src/thrift/protocol/TProtocol.h
@@ -25,6 +25,7 @@ public:
   FilterStatus transportEnd() override { return FilterStatus::Continue; }
   FilterStatus messageBegin(MessageMetadataSharedPtr) override { return FilterStatus::Continue; }
   FilterStatus messageEnd() override { return FilterStatus::Continue; }
+  FilterStatus passthroughData(Buffer::Instance&) override { NOT_REACHED_GCOVR_EXCL_LINE; }
   FilterStatus structBegin(absl::string_view name) override;
   FilterStatus structEnd() override;
   FilterStatus fieldBegin(absl::string_view name, FieldType field_type, int16_t field_id) override;
@@ -240,6 +241,7 @@ public:
 
   // DecoderCallbacks
   DecoderEventHandler& newDecoderEventHandler() override { return *this; }
+  bool passthroughEnabled() const override { return false; }
   FilterStatus transportEnd() override {
     complete_ = true;
     return FilterStatus::Continue;
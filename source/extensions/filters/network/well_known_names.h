@@ -32,6 +32,10 @@ public:
   const std::string ThriftProxy = "envoy.filters.network.thrift_proxy";
   // Role based access control filter
   const std::string Rbac = "envoy.filters.network.rbac";
+  // Local rate limit filter
+  const std::string LocalRateLimit = "envoy.filters.network.local_ratelimit";
+  // Dynamic module filter
+  const std::string DynamicModule = "envoy.filters.network.dynamic_module";
 
   // Converts names from v1 to v2
   const Config::V1Converter v1_converter_;
@@ -0,0 +1,37 @@
+#include "extensions/filters/udp/udp_proxy/config.h"
+
+#include "envoy/config/filter/udp/udp_proxy/v2alpha/udp_proxy.pb.validate.h"
+#include "envoy/registry/registry.h"
+
+#include "common/protobuf/utility.h"
+
+#include "extensions/filters/udp/udp_proxy/udp_proxy_filter.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace UdpFilters {
+namespace UdpProxy {
+
+Network::UdpListenerFilterFactoryCb UdpProxyFilterConfigFactory::createFilterFactoryFromProto(
+    const Protobuf::Message& config, Server::Configuration::ListenerFactoryContext& context) {
+  const auto& proto_config = MessageUtil::downcastAndValidate<
+      const envoy::config::filter::udp::udp_proxy::v2alpha::UdpProxyConfig&>(config);
+  UdpProxyFilterConfigSharedPtr filter_config = std::make_shared<const UdpProxyFilterConfig>(
+      proto_config, context.clusterManager(), context.scope());
+  return [filter_config](Network::UdpListenerFilterManager& filter_manager,
+                         Network::UdpReadFilterCallbacks& callbacks) -> void {
+    filter_manager.addReadFilter(std::make_unique<UdpProxyFilter>(callbacks, filter_config));
+  };
+}
+
+/**
+ * Static registration for the UDP proxy filter. @see RegisterFactory.
+ */
+static Registry::RegisterFactory<UdpProxyFilterConfigFactory,
+                                 Server::Configuration::NamedUdpListenerFilterConfigFactory>
+    registered_;
+
+} // namespace UdpProxy
+} // namespace UdpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "envoy/config/filter/udp/udp_proxy/v2alpha/udp_proxy.pb.h"
+#include "envoy/server/filter_config.h"
+
+#include "extensions/filters/udp/well_known_names.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace UdpFilters {
+namespace UdpProxy {
+
+/**
+ * Config registration for the UDP proxy filter. @see NamedUdpListenerFilterConfigFactory.
+ */
+class UdpProxyFilterConfigFactory
+    : public Server::Configuration::NamedUdpListenerFilterConfigFactory {
+public:
+  // NamedUdpListenerFilterConfigFactory
+  Network::UdpListenerFilterFactoryCb
+  createFilterFactoryFromProto(const Protobuf::Message& config,
+                               Server::Configuration::ListenerFactoryContext& context) override;
+
+  ProtobufTypes::MessagePtr createEmptyConfigProto() override {
+    return std::make_unique<envoy::config::filter::udp::udp_proxy::v2alpha::UdpProxyConfig>();
+  }
+
+  std::string name() override { return UdpFilterNames::get().UdpProxy; }
+};
+
+} // namespace UdpProxy
+} // namespace UdpFilters
+} // namespace Extensions
+} // namespace Envoy
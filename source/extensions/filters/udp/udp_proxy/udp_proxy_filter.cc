@@ -0,0 +1,182 @@
+#include "extensions/filters/udp/udp_proxy/udp_proxy_filter.h"
+
+#include <cerrno>
+
+#include "envoy/api/os_sys_calls.h"
+#include "envoy/event/dispatcher.h"
+
+#include "common/api/os_sys_calls_impl.h"
+#include "common/buffer/buffer_impl.h"
+#include "common/protobuf/utility.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace UdpFilters {
+namespace UdpProxy {
+
+UdpProxyFilterConfig::UdpProxyFilterConfig(
+    const envoy::config::filter::udp::udp_proxy::v2alpha::UdpProxyConfig& config,
+    Upstream::ClusterManager& cluster_manager, Stats::Scope& scope)
+    : cluster_manager_(cluster_manager), cluster_(config.cluster()),
+      session_timeout_(PROTOBUF_GET_MS_OR_DEFAULT(config, idle_timeout, 60 * 1000)),
+      stats_(generateStats(config.stat_prefix(), scope)) {}
+
+UdpProxyFilter::UdpProxyFilter(Network::UdpReadFilterCallbacks& callbacks,
+                               const UdpProxyFilterConfigSharedPtr& config)
+    : callbacks_(callbacks), config_(config) {}
+
+Network::FilterStatus UdpProxyFilter::onData(Network::UdpRecvData& data) {
+  ActiveSession* session;
+  const auto existing_session = sessions_.find(data.peer_address_->asString());
+  if (existing_session != sessions_.end()) {
+    session = existing_session->second.get();
+  } else {
+    session = createSession(std::move(data.peer_address_));
+    if (session == nullptr) {
+      return Network::FilterStatus::StopIteration;
+    }
+  }
+
+  config_->stats().downstream_sess_rx_datagrams_.inc();
+  session->write(*data.buffer_);
+  return Network::FilterStatus::StopIteration;
+}
+
+UdpProxyFilter::ActiveSession*
+UdpProxyFilter::createSession(Network::Address::InstanceConstSharedPtr&& peer_address) {
+  Upstream::ThreadLocalCluster* cluster = config_->clusterManager().get(config_->cluster());
+  if (cluster == nullptr) {
+    ENVOY_LOG(debug, "udp_proxy: no cluster {} for peer {}", config_->cluster(),
+              peer_address->asString());
+    config_->stats().downstream_sess_no_route_.inc();
+    return nullptr;
+  }
+
+  // Each session holds a socket to its host, so sessions are bounded by the cluster's connection
+  // circuit breaker.
+  Upstream::ClusterInfoConstSharedPtr cluster_info = cluster->info();
+  if (!cluster_info->resourceManager(Upstream::ResourcePriority::Default)
+           .connections()
+           .canCreate()) {
+    cluster_info->stats().upstream_cx_overflow_.inc();
+    return nullptr;
+  }
+
+  LoadBalancerContext lb_context(*peer_address);
+  Upstream::HostConstSharedPtr host = cluster->loadBalancer().chooseHost(&lb_context);
+  if (host == nullptr) {
+    cluster_info->stats().upstream_cx_none_healthy_.inc();
+    return nullptr;
+  }
+
+  const int fd = host->address()->socket(Network::Address::SocketType::Datagram);
+  const Api::SysCallIntResult result = host->address()->connect(fd);
+  if (result.rc_ != 0) {
+    ENVOY_LOG(debug, "udp_proxy: cannot connect to {}: {}", host->address()->asString(),
+              strerror(result.errno_));
+    Api::OsSysCallsSingleton::get().close(fd);
+    host->stats().cx_connect_fail_.inc();
+    cluster_info->stats().upstream_cx_connect_fail_.inc();
+    return nullptr;
+  }
+
+  const std::string key = peer_address->asString();
+  ActiveSessionPtr new_session =
+      std::make_unique<ActiveSession>(*this, std::move(peer_address), cluster_info, host, fd);
+  ActiveSession* session = new_session.get();
+  sessions_.emplace(key, std::move(new_session));
+  return session;
+}
+
+void UdpProxyFilter::removeSession(ActiveSession& session) {
+  const auto it = sessions_.find(session.peerAddress()->asString());
+  ASSERT(it != sessions_.end() && it->second.get() == &session);
+  callbacks_.dispatcher().deferredDelete(std::move(it->second));
+  sessions_.erase(it);
+}
+
+UdpProxyFilter::ActiveSession::ActiveSession(
+    UdpProxyFilter& parent, Network::Address::InstanceConstSharedPtr&& peer_address,
+    Upstream::ClusterInfoConstSharedPtr cluster_info, const Upstream::HostConstSharedPtr& host,
+    int fd)
+    : parent_(parent), config_(parent.config_), peer_address_(std::move(peer_address)),
+      cluster_info_(std::move(cluster_info)), host_(host), fd_(fd) {
+  ENVOY_LOG(debug, "udp_proxy: new session from {} to {}", peer_address_->asString(),
+            host_->address()->asString());
+
+  read_event_ = parent_.callbacks_.dispatcher().createFileEvent(
+      fd_, [this](uint32_t) -> void { onReadReady(); }, Event::FileTriggerType::Level,
+      Event::FileReadyType::Read);
+  idle_timer_ = parent_.callbacks_.dispatcher().createTimer([this]() -> void { onIdleTimeout(); });
+  idle_timer_->enableTimer(config_->sessionTimeout());
+
+  config_->stats().downstream_sess_total_.inc();
+  config_->stats().downstream_sess_active_.inc();
+  cluster_info_->stats().upstream_cx_total_.inc();
+  cluster_info_->stats().upstream_cx_active_.inc();
+  cluster_info_->resourceManager(Upstream::ResourcePriority::Default).connections().inc();
+  host_->stats().cx_total_.inc();
+  host_->stats().cx_active_.inc();
+}
+
+UdpProxyFilter::ActiveSession::~ActiveSession() {
+  read_event_.reset();
+  Api::OsSysCallsSingleton::get().close(fd_);
+
+  config_->stats().downstream_sess_active_.dec();
+  cluster_info_->stats().upstream_cx_active_.dec();
+  cluster_info_->resourceManager(Upstream::ResourcePriority::Default).connections().dec();
+  host_->stats().cx_active_.dec();
+}
+
+void UdpProxyFilter::ActiveSession::write(Buffer::Instance& buffer) {
+  idle_timer_->enableTimer(config_->sessionTimeout());
+
+  const uint64_t length = buffer.length();
+  const Api::SysCallSizeResult result = Api::OsSysCallsSingleton::get().write(
+      fd_, length > 0 ? buffer.linearize(length) : nullptr, length);
+  if (result.rc_ < 0) {
+    ENVOY_LOG(trace, "udp_proxy: cannot write to {}: {}", host_->address()->asString(),
+              strerror(result.errno_));
+    config_->stats().upstream_sess_tx_errors_.inc();
+  }
+}
+
+void UdpProxyFilter::ActiveSession::onReadReady() {
+  idle_timer_->enableTimer(config_->sessionTimeout());
+
+  // One extra byte tells datagrams larger than MaxDatagramSize from those of exactly that size.
+  uint8_t data[MaxDatagramSize + 1];
+  for (uint32_t i = 0; i < MaxReadsPerWakeup; i++) {
+    const Api::SysCallSizeResult result =
+        Api::OsSysCallsSingleton::get().recv(fd_, data, sizeof(data), 0);
+    if (result.rc_ < 0) {
+      // A host that is not listening shows up as ECONNREFUSED on the connected socket.
+      if (result.errno_ != EAGAIN && result.errno_ != EWOULDBLOCK && result.errno_ != EINTR) {
+        config_->stats().upstream_sess_rx_errors_.inc();
+      }
+      return;
+    }
+    if (static_cast<uint64_t>(result.rc_) > MaxDatagramSize) {
+      config_->stats().upstream_sess_rx_errors_.inc();
+      continue;
+    }
+
+    Buffer::OwnedImpl buffer(data, result.rc_);
+    parent_.callbacks_.udpListener().send({*peer_address_, buffer});
+    config_->stats().downstream_sess_tx_datagrams_.inc();
+  }
+}
+
+void UdpProxyFilter::ActiveSession::onIdleTimeout() {
+  ENVOY_LOG(debug, "udp_proxy: session from {} timed out", peer_address_->asString());
+  config_->stats().idle_timeout_.inc();
+  // Stop reading since the session may outlive the filter until it is deleted.
+  read_event_.reset();
+  parent_.removeSession(*this);
+}
+
+} // namespace UdpProxy
+} // namespace UdpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "envoy/config/filter/udp/udp_proxy/v2alpha/udp_proxy.pb.h"
+#include "envoy/event/deferred_deletable.h"
+#include "envoy/event/file_event.h"
+#include "envoy/event/timer.h"
+#include "envoy/network/filter.h"
+#include "envoy/network/listener.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/upstream/cluster_manager.h"
+
+#include "common/common/hash.h"
+#include "common/common/logger.h"
+#include "common/upstream/load_balancer_impl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace UdpFilters {
+namespace UdpProxy {
+
+/**
+ * All UDP proxy stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_UDP_PROXY_STATS(COUNTER, GAUGE)                                                        \
+  COUNTER(downstream_sess_total)                                                                   \
+  GAUGE  (downstream_sess_active)                                                                  \
+  COUNTER(downstream_sess_no_route)                                                                \
+  COUNTER(downstream_sess_rx_datagrams)                                                            \
+  COUNTER(downstream_sess_tx_datagrams)                                                            \
+  COUNTER(upstream_sess_rx_errors)                                                                 \
+  COUNTER(upstream_sess_tx_errors)                                                                 \
+  COUNTER(idle_timeout)
+// clang-format on
+
+/**
+ * Struct definition for all UDP proxy stats. @see stats_macros.h
+ */
+struct UdpProxyStats {
+  ALL_UDP_PROXY_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
+};
+
+/**
+ * Configuration shared by the UDP proxy filters of a listener on all workers.
+ */
+class UdpProxyFilterConfig {
+public:
+  UdpProxyFilterConfig(
+      const envoy::config::filter::udp::udp_proxy::v2alpha::UdpProxyConfig& config,
+      Upstream::ClusterManager& cluster_manager, Stats::Scope& scope);
+
+  Upstream::ClusterManager& clusterManager() const { return cluster_manager_; }
+  const std::string& cluster() const { return cluster_; }
+  std::chrono::milliseconds sessionTimeout() const { return session_timeout_; }
+  UdpProxyStats& stats() const { return stats_; }
+
+private:
+  static UdpProxyStats generateStats(const std::string& prefix, Stats::Scope& scope) {
+    const std::string final_prefix = fmt::format("udp.{}.", prefix);
+    return {ALL_UDP_PROXY_STATS(POOL_COUNTER_PREFIX(scope, final_prefix),
+                                POOL_GAUGE_PREFIX(scope, final_prefix))};
+  }
+
+  Upstream::ClusterManager& cluster_manager_;
+  const std::string cluster_;
+  const std::chrono::milliseconds session_timeout_;
+  mutable UdpProxyStats stats_;
+};
+
+typedef std::shared_ptr<const UdpProxyFilterConfig> UdpProxyFilterConfigSharedPtr;
+
+/**
+ * A UDP listener filter that proxies the datagrams of each downstream peer to a host of the
+ * configured cluster. A peer is bound to its host by a session, which owns a connected datagram
+ * socket to the host: datagrams from the host arrive on that socket and are sent back to the peer
+ * through the listener. Sessions end after the configured idle timeout.
+ */
+class UdpProxyFilter : public Network::UdpListenerReadFilter,
+                       Logger::Loggable<Logger::Id::filter> {
+public:
+  UdpProxyFilter(Network::UdpReadFilterCallbacks& callbacks,
+                 const UdpProxyFilterConfigSharedPtr& config);
+
+  // Network::UdpListenerReadFilter
+  Network::FilterStatus onData(Network::UdpRecvData& data) override;
+
+  // The largest datagram read from an upstream host. Larger datagrams are dropped.
+  static constexpr uint64_t MaxDatagramSize = 9000;
+  // The number of datagrams read from an upstream host each time its socket becomes readable.
+  static constexpr uint32_t MaxReadsPerWakeup = 64;
+
+private:
+  /**
+   * The state of a downstream peer. Sessions are deferred deleted and may outlive the filter, so
+   * the destructor only touches the session's own members.
+   */
+  class ActiveSession : public Event::DeferredDeletable {
+  public:
+    ActiveSession(UdpProxyFilter& parent, Network::Address::InstanceConstSharedPtr&& peer_address,
+                  Upstream::ClusterInfoConstSharedPtr cluster_info,
+                  const Upstream::HostConstSharedPtr& host, int fd);
+    ~ActiveSession();
+
+    const Network::Address::InstanceConstSharedPtr& peerAddress() const { return peer_address_; }
+    void write(Buffer::Instance& buffer);
+
+  private:
+    void onReadReady();
+    void onIdleTimeout();
+
+    UdpProxyFilter& parent_;
+    const UdpProxyFilterConfigSharedPtr config_;
+    const Network::Address::InstanceConstSharedPtr peer_address_;
+    const Upstream::ClusterInfoConstSharedPtr cluster_info_;
+    const Upstream::HostConstSharedPtr host_;
+    const int fd_;
+    Event::FileEventPtr read_event_;
+    Event::TimerPtr idle_timer_;
+  };
+
+  typedef std::unique_ptr<ActiveSession> ActiveSessionPtr;
+
+  /**
+   * Picks the upstream host of a new session. The hash of the peer address keeps peers on the same
+   * host with the hash based load balancers.
+   */
+  class LoadBalancerContext : public Upstream::LoadBalancerContextBase {
+  public:
+    LoadBalancerContext(const Network::Address::Instance& peer_address)
+        : hash_(HashUtil::xxHash64(peer_address.asString())) {}
+
+    // Upstream::LoadBalancerContext
+    absl::optional<uint64_t> computeHashKey() override { return hash_; }
+
+  private:
+    const uint64_t hash_;
+  };
+
+  ActiveSession* createSession(Network::Address::InstanceConstSharedPtr&& peer_address);
+  void removeSession(ActiveSession& session);
+
+  Network::UdpReadFilterCallbacks& callbacks_;
+  const UdpProxyFilterConfigSharedPtr config_;
+  // Sessions keyed by the address of their downstream peer.
+  std::unordered_map<std::string, ActiveSessionPtr> sessions_;
+};
+
+} // namespace UdpProxy
+} // namespace UdpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -57,6 +57,11 @@ private:
       // Allow the main HC infra to control timeout.
       return parent_.timeout_ * 2;
     }
+    // The health check requests are written as soon as they are made.
+    uint32_t maxBufferSizeBeforeFlush() const override { return 0; }
+    std::chrono::milliseconds bufferFlushTimeoutInMs() const override {
+      return std::chrono::milliseconds(0);
+    }
 
     // Extensions::NetworkFilters::RedisProxy::ConnPool::PoolCallbacks
     void onResponse(Extensions::NetworkFilters::RedisProxy::RespValuePtr&& value) override;
@@ -0,0 +1,53 @@
+#include "extensions/private_key_providers/thread_pool/config.h"
+
+#include "envoy/common/exception.h"
+#include "envoy/config/private_key_provider/thread_pool/v2alpha/thread_pool.pb.validate.h"
+#include "envoy/registry/registry.h"
+
+#include "common/common/assert.h"
+#include "common/protobuf/utility.h"
+
+#include "extensions/private_key_providers/thread_pool/thread_pool_private_key_method.h"
+#include "extensions/private_key_providers/well_known_names.h"
+
+#include "openssl/pem.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace PrivateKeyProviders {
+namespace ThreadPool {
+
+Ssl::PrivateKeyMethodProviderSharedPtr
+ThreadPoolPrivateKeyMethodFactory::createPrivateKeyMethodProviderInstance(
+    const ProtobufWkt::Struct& config, const std::string& private_key) {
+  envoy::config::private_key_provider::thread_pool::v2alpha::ThreadPool proto_config;
+  MessageUtil::jsonConvert(config, proto_config);
+  MessageUtil::validate(proto_config);
+
+  bssl::UniquePtr<BIO> bio(
+      BIO_new_mem_buf(const_cast<char*>(private_key.data()), private_key.size()));
+  RELEASE_ASSERT(bio != nullptr, "");
+  bssl::UniquePtr<EVP_PKEY> pkey(PEM_read_bio_PrivateKey(bio.get(), nullptr, nullptr, nullptr));
+  if (pkey == nullptr) {
+    throw EnvoyException("Failed to load private key for the thread pool private key provider");
+  }
+
+  return std::make_shared<ThreadPoolPrivateKeyMethodProvider>(
+      std::move(pkey), PROTOBUF_GET_WRAPPED_OR_DEFAULT(proto_config, threads, 1));
+}
+
+std::string ThreadPoolPrivateKeyMethodFactory::name() const {
+  return PrivateKeyProviderNames::get().ThreadPool;
+}
+
+/**
+ * Static registration for the thread pool private key provider. @see RegisterFactory.
+ */
+static Registry::RegisterFactory<ThreadPoolPrivateKeyMethodFactory,
+                                 Ssl::PrivateKeyMethodProviderInstanceFactory>
+    registered_;
+
+} // namespace ThreadPool
+} // namespace PrivateKeyProviders
+} // namespace Extensions
+} // namespace Envoy
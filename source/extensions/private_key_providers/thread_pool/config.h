@@ -0,0 +1,26 @@
+#pragma once
+
+#include "envoy/ssl/private_key/private_key_config.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace PrivateKeyProviders {
+namespace ThreadPool {
+
+/**
+ * Config registration for the thread pool private key provider. @see
+ * PrivateKeyMethodProviderInstanceFactory.
+ */
+class ThreadPoolPrivateKeyMethodFactory : public Ssl::PrivateKeyMethodProviderInstanceFactory {
+public:
+  // Ssl::PrivateKeyMethodProviderInstanceFactory
+  Ssl::PrivateKeyMethodProviderSharedPtr
+  createPrivateKeyMethodProviderInstance(const ProtobufWkt::Struct& config,
+                                         const std::string& private_key) override;
+  std::string name() const override;
+};
+
+} // namespace ThreadPool
+} // namespace PrivateKeyProviders
+} // namespace Extensions
+} // namespace Envoy
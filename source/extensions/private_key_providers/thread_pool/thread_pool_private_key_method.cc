@@ -0,0 +1,227 @@
+#include "extensions/private_key_providers/thread_pool/thread_pool_private_key_method.h"
+
+#include <cstring>
+
+#include "common/common/assert.h"
+#include "common/common/lock_guard.h"
+#include "common/common/macros.h"
+
+#include "openssl/err.h"
+#include "openssl/evp.h"
+#include "openssl/rsa.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace PrivateKeyProviders {
+namespace ThreadPool {
+
+namespace {
+
+bool signWithKey(EVP_PKEY* pkey, uint16_t signature_algorithm, const std::vector<uint8_t>& in,
+                 std::vector<uint8_t>& out) {
+  if (SSL_get_signature_algorithm_key_type(signature_algorithm) != EVP_PKEY_id(pkey)) {
+    return false;
+  }
+
+  bssl::ScopedEVP_MD_CTX ctx;
+  EVP_PKEY_CTX* pctx;
+  const EVP_MD* md = SSL_get_signature_algorithm_digest(signature_algorithm);
+  if (!EVP_DigestSignInit(ctx.get(), &pctx, md, nullptr, pkey)) {
+    return false;
+  }
+  if (SSL_is_signature_algorithm_rsa_pss(signature_algorithm) &&
+      (!EVP_PKEY_CTX_set_rsa_padding(pctx, RSA_PKCS1_PSS_PADDING) ||
+       !EVP_PKEY_CTX_set_rsa_pss_saltlen(pctx, -1))) {
+    return false;
+  }
+
+  size_t out_len;
+  if (!EVP_DigestSign(ctx.get(), nullptr, &out_len, in.data(), in.size())) {
+    return false;
+  }
+  out.resize(out_len);
+  if (!EVP_DigestSign(ctx.get(), out.data(), &out_len, in.data(), in.size())) {
+    return false;
+  }
+  out.resize(out_len);
+  return true;
+}
+
+bool decryptWithKey(EVP_PKEY* pkey, const std::vector<uint8_t>& in, std::vector<uint8_t>& out) {
+  RSA* rsa = EVP_PKEY_get0_RSA(pkey);
+  if (rsa == nullptr) {
+    return false;
+  }
+
+  // BoringSSL checks the padding of the decrypted premaster secret itself.
+  out.resize(RSA_size(rsa));
+  size_t out_len;
+  if (!RSA_decrypt(rsa, &out_len, out.data(), out.size(), in.data(), in.size(), RSA_NO_PADDING)) {
+    return false;
+  }
+  out.resize(out_len);
+  return true;
+}
+
+} // namespace
+
+ThreadPoolPrivateKeyMethodProvider::ThreadPoolPrivateKeyMethodProvider(
+    bssl::UniquePtr<EVP_PKEY> pkey, uint32_t threads)
+    : pkey_(std::move(pkey)) {
+  ASSERT(threads > 0);
+  method_.sign = sign;
+  method_.decrypt = decrypt;
+  method_.complete = complete;
+
+  for (uint32_t i = 0; i < threads; i++) {
+    threads_.emplace_back(new Thread::Thread([this]() -> void { threadRoutine(); }));
+  }
+}
+
+ThreadPoolPrivateKeyMethodProvider::~ThreadPoolPrivateKeyMethodProvider() {
+  {
+    Thread::LockGuard guard(lock_);
+    shutdown_ = true;
+  }
+  queue_cv_.notifyAll();
+  for (const Thread::ThreadPtr& thread : threads_) {
+    thread->join();
+  }
+}
+
+void ThreadPoolPrivateKeyMethodProvider::registerPrivateKeyMethod(
+    SSL* ssl, Ssl::PrivateKeyConnectionCallbacks& callbacks, Event::Dispatcher& dispatcher) {
+  ASSERT(connectionState(ssl) == nullptr);
+  SSL_set_ex_data(ssl, connectionIndex(), new ConnectionState(*this, callbacks, dispatcher));
+}
+
+void ThreadPoolPrivateKeyMethodProvider::unregisterPrivateKeyMethod(SSL* ssl) {
+  ConnectionState* state = connectionState(ssl);
+  if (state == nullptr) {
+    return;
+  }
+
+  if (state->pending_ != nullptr) {
+    // The pool thread may still post the completion of the operation.
+    state->pending_->callbacks_ = nullptr;
+  }
+  SSL_set_ex_data(ssl, connectionIndex(), nullptr);
+  delete state;
+}
+
+void ThreadPoolPrivateKeyMethodProvider::perform(EVP_PKEY* pkey, PrivateKeyOperation& operation) {
+  switch (operation.type_) {
+  case PrivateKeyOperation::Type::Sign:
+    operation.success_ =
+        signWithKey(pkey, operation.signature_algorithm_, operation.input_, operation.output_);
+    break;
+  case PrivateKeyOperation::Type::Decrypt:
+    operation.success_ = decryptWithKey(pkey, operation.input_, operation.output_);
+    break;
+  }
+
+  // Errors are reported to the handshake through the success of the operation.
+  ERR_clear_error();
+}
+
+int ThreadPoolPrivateKeyMethodProvider::connectionIndex() {
+  CONSTRUCT_ON_FIRST_USE(int, []() -> int {
+    int connection_index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+    RELEASE_ASSERT(connection_index >= 0, "");
+    return connection_index;
+  }());
+}
+
+ThreadPoolPrivateKeyMethodProvider::ConnectionState*
+ThreadPoolPrivateKeyMethodProvider::connectionState(SSL* ssl) {
+  return static_cast<ConnectionState*>(SSL_get_ex_data(ssl, connectionIndex()));
+}
+
+ssl_private_key_result_t
+ThreadPoolPrivateKeyMethodProvider::sign(SSL* ssl, uint8_t*, size_t*, size_t,
+                                         uint16_t signature_algorithm, const uint8_t* in,
+                                         size_t in_len) {
+  return start(ssl, PrivateKeyOperation::Type::Sign, signature_algorithm, in, in_len);
+}
+
+ssl_private_key_result_t ThreadPoolPrivateKeyMethodProvider::decrypt(SSL* ssl, uint8_t*, size_t*,
+                                                                     size_t, const uint8_t* in,
+                                                                     size_t in_len) {
+  return start(ssl, PrivateKeyOperation::Type::Decrypt, 0, in, in_len);
+}
+
+ssl_private_key_result_t ThreadPoolPrivateKeyMethodProvider::complete(SSL* ssl, uint8_t* out,
+                                                                      size_t* out_len,
+                                                                      size_t max_out) {
+  ConnectionState* state = connectionState(ssl);
+  if (state == nullptr || state->pending_ == nullptr) {
+    return ssl_private_key_failure;
+  }
+  if (!state->pending_->complete_) {
+    return ssl_private_key_retry;
+  }
+
+  PrivateKeyOperationSharedPtr operation = std::move(state->pending_);
+  state->pending_ = nullptr;
+  if (!operation->success_ || operation->output_.size() > max_out) {
+    return ssl_private_key_failure;
+  }
+  memcpy(out, operation->output_.data(), operation->output_.size());
+  *out_len = operation->output_.size();
+  return ssl_private_key_success;
+}
+
+ssl_private_key_result_t
+ThreadPoolPrivateKeyMethodProvider::start(SSL* ssl, PrivateKeyOperation::Type type,
+                                          uint16_t signature_algorithm, const uint8_t* in,
+                                          size_t in_len) {
+  ConnectionState* state = connectionState(ssl);
+  if (state == nullptr || state->pending_ != nullptr) {
+    return ssl_private_key_failure;
+  }
+
+  state->pending_ =
+      std::make_shared<PrivateKeyOperation>(type, state->callbacks_, state->dispatcher_);
+  state->pending_->signature_algorithm_ = signature_algorithm;
+  state->pending_->input_.assign(in, in + in_len);
+  state->provider_.enqueue(state->pending_);
+  return ssl_private_key_retry;
+}
+
+void ThreadPoolPrivateKeyMethodProvider::enqueue(const PrivateKeyOperationSharedPtr& operation) {
+  {
+    Thread::LockGuard guard(lock_);
+    queue_.push(operation);
+  }
+  queue_cv_.notifyOne();
+}
+
+void ThreadPoolPrivateKeyMethodProvider::threadRoutine() {
+  while (true) {
+    PrivateKeyOperationSharedPtr operation;
+    {
+      Thread::LockGuard guard(lock_);
+      while (queue_.empty() && !shutdown_) {
+        queue_cv_.wait(lock_);
+      }
+      if (shutdown_) {
+        return;
+      }
+      operation = std::move(queue_.front());
+      queue_.pop();
+    }
+
+    perform(pkey_.get(), *operation);
+    operation->dispatcher_.post([operation]() -> void {
+      operation->complete_ = true;
+      if (operation->callbacks_ != nullptr) {
+        operation->callbacks_->onPrivateKeyMethodComplete();
+      }
+    });
+  }
+}
+
+} // namespace ThreadPool
+} // namespace PrivateKeyProviders
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <queue>
+#include <vector>
+
+#include "envoy/event/dispatcher.h"
+#include "envoy/ssl/private_key/private_key.h"
+
+#include "common/common/thread.h"
+#include "common/common/thread_annotations.h"
+
+#include "openssl/ssl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace PrivateKeyProviders {
+namespace ThreadPool {
+
+/**
+ * A private key operation of a connection, performed on the thread pool.
+ */
+struct PrivateKeyOperation {
+  enum class Type { Sign, Decrypt };
+
+  PrivateKeyOperation(Type type, Ssl::PrivateKeyConnectionCallbacks& callbacks,
+                      Event::Dispatcher& dispatcher)
+      : type_(type), callbacks_(&callbacks), dispatcher_(dispatcher) {}
+
+  const Type type_;
+  uint16_t signature_algorithm_{};
+  std::vector<uint8_t> input_;
+
+  // Written by the pool thread before the completion is posted to the dispatcher.
+  std::vector<uint8_t> output_;
+  bool success_{};
+
+  // Only accessed on the dispatcher thread of the connection. The callbacks are reset once the
+  // connection is unregistered.
+  Ssl::PrivateKeyConnectionCallbacks* callbacks_;
+  Event::Dispatcher& dispatcher_;
+  bool complete_{};
+};
+
+typedef std::shared_ptr<PrivateKeyOperation> PrivateKeyOperationSharedPtr;
+
+/**
+ * A private key method provider which signs and decrypts with a private key on a pool of threads,
+ * so that the worker threads keep serving other connections while a handshake waits for its
+ * private key operation. The result is posted to the dispatcher of the connection, which resumes
+ * the handshake.
+ */
+class ThreadPoolPrivateKeyMethodProvider : public Ssl::PrivateKeyMethodProvider {
+public:
+  ThreadPoolPrivateKeyMethodProvider(bssl::UniquePtr<EVP_PKEY> pkey, uint32_t threads);
+  ~ThreadPoolPrivateKeyMethodProvider();
+
+  // Ssl::PrivateKeyMethodProvider
+  void registerPrivateKeyMethod(SSL* ssl, Ssl::PrivateKeyConnectionCallbacks& callbacks,
+                                Event::Dispatcher& dispatcher) override;
+  void unregisterPrivateKeyMethod(SSL* ssl) override;
+  const SSL_PRIVATE_KEY_METHOD* getBoringSslPrivateKeyMethod() const override { return &method_; }
+
+  /**
+   * Perform a private key operation synchronously, setting its output and success.
+   * @param pkey supplies the private key.
+   * @param operation supplies the operation.
+   */
+  static void perform(EVP_PKEY* pkey, PrivateKeyOperation& operation);
+
+private:
+  struct ConnectionState {
+    ConnectionState(ThreadPoolPrivateKeyMethodProvider& provider,
+                    Ssl::PrivateKeyConnectionCallbacks& callbacks, Event::Dispatcher& dispatcher)
+        : provider_(provider), callbacks_(callbacks), dispatcher_(dispatcher) {}
+
+    ThreadPoolPrivateKeyMethodProvider& provider_;
+    Ssl::PrivateKeyConnectionCallbacks& callbacks_;
+    Event::Dispatcher& dispatcher_;
+    // The operation in progress, until its result is collected by complete().
+    PrivateKeyOperationSharedPtr pending_;
+  };
+
+  static int connectionIndex();
+  static ConnectionState* connectionState(SSL* ssl);
+
+  // SSL_PRIVATE_KEY_METHOD
+  static ssl_private_key_result_t sign(SSL* ssl, uint8_t* out, size_t* out_len, size_t max_out,
+                                       uint16_t signature_algorithm, const uint8_t* in,
+                                       size_t in_len);
+  static ssl_private_key_result_t decrypt(SSL* ssl, uint8_t* out, size_t* out_len,
+                                          size_t max_out, const uint8_t* in, size_t in_len);
+  static ssl_private_key_result_t complete(SSL* ssl, uint8_t* out, size_t* out_len,
+                                           size_t max_out);
+
+  static ssl_private_key_result_t start(SSL* ssl, PrivateKeyOperation::Type type,
+                                        uint16_t signature_algorithm, const uint8_t* in,
+                                        size_t in_len);
+  void enqueue(const PrivateKeyOperationSharedPtr& operation);
+  void threadRoutine();
+
+  const bssl::UniquePtr<EVP_PKEY> pkey_;
+  SSL_PRIVATE_KEY_METHOD method_{};
+  Thread::MutexBasicLockable lock_;
+  Thread::CondVar queue_cv_;
+  std::queue<PrivateKeyOperationSharedPtr> queue_ GUARDED_BY(lock_);
+  bool shutdown_ GUARDED_BY(lock_){};
+  std::vector<Thread::ThreadPtr> threads_;
+};
+
+} // namespace ThreadPool
+} // namespace PrivateKeyProviders
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "common/singleton/const_singleton.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace PrivateKeyProviders {
+
+/**
+ * Well-known private key provider names.
+ * NOTE: New private key providers should use the well known name: envoy.private_key_providers.name.
+ */
+class PrivateKeyProviderNameValues {
+public:
+  // Private key operations on a dedicated thread pool.
+  const std::string ThreadPool = "envoy.private_key_providers.thread_pool";
+};
+
+typedef ConstSingleton<PrivateKeyProviderNameValues> PrivateKeyProviderNames;
+
+} // namespace PrivateKeyProviders
+} // namespace Extensions
+} // namespace Envoy
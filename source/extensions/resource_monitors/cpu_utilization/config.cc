@@ -0,0 +1,30 @@
+#include "extensions/resource_monitors/cpu_utilization/config.h"
+
+#include "envoy/registry/registry.h"
+
+#include "common/protobuf/utility.h"
+
+#include "extensions/resource_monitors/cpu_utilization/cpu_utilization_monitor.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace ResourceMonitors {
+namespace CpuUtilizationMonitor {
+
+Server::ResourceMonitorPtr CpuUtilizationMonitorFactory::createResourceMonitorFromProtoTyped(
+    const envoy::config::resource_monitor::cpu_utilization::v2alpha::CpuUtilizationConfig& config,
+    Server::Configuration::ResourceMonitorFactoryContext& /*unused_context*/) {
+  return std::make_unique<CpuUtilizationMonitor>(config);
+}
+
+/**
+ * Static registration for the CPU utilization resource monitor factory. @see RegistryFactory.
+ */
+static Registry::RegisterFactory<CpuUtilizationMonitorFactory,
+                                 Server::Configuration::ResourceMonitorFactory>
+    registered_;
+
+} // namespace CpuUtilizationMonitor
+} // namespace ResourceMonitors
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "envoy/config/resource_monitor/cpu_utilization/v2alpha/cpu_utilization.pb.validate.h"
+#include "envoy/server/resource_monitor_config.h"
+
+#include "extensions/resource_monitors/common/factory_base.h"
+#include "extensions/resource_monitors/well_known_names.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace ResourceMonitors {
+namespace CpuUtilizationMonitor {
+
+class CpuUtilizationMonitorFactory
+    : public Common::FactoryBase<
+          envoy::config::resource_monitor::cpu_utilization::v2alpha::CpuUtilizationConfig> {
+public:
+  CpuUtilizationMonitorFactory() : FactoryBase(ResourceMonitorNames::get().CpuUtilization) {}
+
+private:
+  Server::ResourceMonitorPtr createResourceMonitorFromProtoTyped(
+      const envoy::config::resource_monitor::cpu_utilization::v2alpha::CpuUtilizationConfig& config,
+      Server::Configuration::ResourceMonitorFactoryContext& context) override;
+};
+
+} // namespace CpuUtilizationMonitor
+} // namespace ResourceMonitors
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,59 @@
+#include "extensions/resource_monitors/cpu_utilization/cpu_utilization_monitor.h"
+
+#include <sys/resource.h>
+
+#include "envoy/common/exception.h"
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace ResourceMonitors {
+namespace CpuUtilizationMonitor {
+
+std::chrono::microseconds CpuStatsReader::processCpuTime() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    throw EnvoyException("unable to get the CPU time of the process");
+  }
+  return std::chrono::seconds(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+         std::chrono::microseconds(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+}
+
+MonotonicTime CpuStatsReader::monotonicTime() { return std::chrono::steady_clock::now(); }
+
+CpuUtilizationMonitor::CpuUtilizationMonitor(
+    const envoy::config::resource_monitor::cpu_utilization::v2alpha::CpuUtilizationConfig& config,
+    std::unique_ptr<CpuStatsReader> stats)
+    : cpu_count_(config.cpu_count()), stats_(std::move(stats)),
+      last_cpu_time_(stats_->processCpuTime()), last_time_(stats_->monotonicTime()) {
+  ASSERT(cpu_count_ > 0);
+}
+
+void CpuUtilizationMonitor::updateResourceUsage(Server::ResourceMonitor::Callbacks& callbacks) {
+  std::chrono::microseconds cpu_time;
+  try {
+    cpu_time = stats_->processCpuTime();
+  } catch (const EnvoyException& error) {
+    callbacks.onFailure(error);
+    return;
+  }
+  const MonotonicTime now = stats_->monotonicTime();
+
+  const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - last_time_);
+  if (elapsed.count() > 0) {
+    last_pressure_ = (cpu_time - last_cpu_time_).count() /
+                     (static_cast<double>(elapsed.count()) * cpu_count_);
+    last_cpu_time_ = cpu_time;
+    last_time_ = now;
+  }
+
+  Server::ResourceUsage usage;
+  usage.resource_pressure_ = last_pressure_;
+  callbacks.onSuccess(usage);
+}
+
+} // namespace CpuUtilizationMonitor
+} // namespace ResourceMonitors
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <chrono>
+
+#include "envoy/common/time.h"
+#include "envoy/config/resource_monitor/cpu_utilization/v2alpha/cpu_utilization.pb.validate.h"
+#include "envoy/server/resource_monitor.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace ResourceMonitors {
+namespace CpuUtilizationMonitor {
+
+/**
+ * Helper class for getting the CPU time of the process.
+ */
+class CpuStatsReader {
+public:
+  CpuStatsReader() {}
+  virtual ~CpuStatsReader() {}
+
+  // CPU time used by all the threads of the process, in user and system mode.
+  virtual std::chrono::microseconds processCpuTime();
+  // Time elapsed, against which the CPU time is measured.
+  virtual MonotonicTime monotonicTime();
+};
+
+/**
+ * CPU utilization monitor with a statically configured number of CPUs.
+ */
+class CpuUtilizationMonitor : public Server::ResourceMonitor {
+public:
+  CpuUtilizationMonitor(
+      const envoy::config::resource_monitor::cpu_utilization::v2alpha::CpuUtilizationConfig&
+          config,
+      std::unique_ptr<CpuStatsReader> stats = std::make_unique<CpuStatsReader>());
+
+  void updateResourceUsage(Server::ResourceMonitor::Callbacks& callbacks) override;
+
+private:
+  const uint32_t cpu_count_;
+  std::unique_ptr<CpuStatsReader> stats_;
+  std::chrono::microseconds last_cpu_time_;
+  MonotonicTime last_time_;
+  // Reported again if no time elapsed since the previous update.
+  double last_pressure_{};
+};
+
+} // namespace CpuUtilizationMonitor
+} // namespace ResourceMonitors
+} // namespace Extensions
+} // namespace Envoy
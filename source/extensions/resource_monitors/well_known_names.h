@@ -12,6 +12,9 @@ namespace ResourceMonitors {
  */
 class ResourceMonitorNameValues {
 public:
+  // CPU utilization monitor with a statically configured number of CPUs.
+  const std::string CpuUtilization = "envoy.resource_monitors.cpu_utilization";
+
   // Heap monitor with statically configured max.
   const std::string FixedHeap = "envoy.resource_monitors.fixed_heap";
 
@@ -1,8 +1,12 @@
 #include "extensions/stat_sinks/common/statsd/statsd.h"
 
+#include <sys/socket.h>
+
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "envoy/common/exception.h"
 #include "envoy/event/dispatcher.h"
@@ -38,6 +42,69 @@ void Writer::write(const std::string& message) {
   ::send(fd_, message.c_str(), message.size(), MSG_DONTWAIT);
 }
 
+void Writer::writeBatch(const std::vector<std::string>& datagrams, size_t count) {
+  ASSERT(count <= datagrams.size());
+#ifdef __linux__
+  // Sent in chunks so that the message headers fit on the stack.
+  constexpr size_t MaxMessages = 64;
+  iovec iovecs[MaxMessages];
+  mmsghdr messages[MaxMessages];
+  size_t sent = 0;
+  while (sent < count) {
+    const size_t chunk = std::min(count - sent, MaxMessages);
+    for (size_t i = 0; i < chunk; i++) {
+      const std::string& datagram = datagrams[sent + i];
+      iovecs[i].iov_base = const_cast<char*>(datagram.data());
+      iovecs[i].iov_len = datagram.size();
+      messages[i] = {};
+      messages[i].msg_hdr.msg_iov = &iovecs[i];
+      messages[i].msg_hdr.msg_iovlen = 1;
+    }
+    const int rc = ::sendmmsg(fd_, messages, static_cast<unsigned int>(chunk), MSG_DONTWAIT);
+    if (rc <= 0) {
+      // As with write(), whatever the socket does not take right away is dropped.
+      return;
+    }
+    sent += rc;
+  }
+#else
+  for (size_t i = 0; i < count; i++) {
+    write(datagrams[i]);
+  }
+#endif
+}
+
+DatagramBatcher::DatagramBatcher(Writer& writer, uint64_t max_datagram_bytes)
+    : writer_(writer), max_datagram_bytes_(max_datagram_bytes), datagrams_(MaxBatchDatagrams) {}
+
+void DatagramBatcher::add(absl::string_view head, uint64_t value, absl::string_view tail) {
+  char value_buffer[StringUtil::MIN_ITOA_OUT_LEN];
+  const uint32_t value_length = StringUtil::itoa(value_buffer, sizeof(value_buffer), value);
+  const uint64_t line_length = head.size() + value_length + tail.size();
+
+  if (used_ == 0 || datagrams_[used_ - 1].size() + 1 + line_length > max_datagram_bytes_) {
+    if (used_ == datagrams_.size()) {
+      flush();
+    }
+    datagrams_[used_++].clear();
+  }
+
+  std::string& datagram = datagrams_[used_ - 1];
+  if (!datagram.empty()) {
+    datagram.push_back('\n');
+  }
+  datagram.append(head.data(), head.size());
+  datagram.append(value_buffer, value_length);
+  datagram.append(tail.data(), tail.size());
+}
+
+void DatagramBatcher::flush() {
+  if (used_ > 0) {
+    writer_.writeBatch(datagrams_, used_);
+    used_ = 0;
+  }
+}
+
 UdpStatsdSink::UdpStatsdSink(ThreadLocal::SlotAllocator& tls,
                              Network::Address::InstanceConstSharedPtr address, const bool use_tag,
                              const std::string& prefix)
@@ -49,23 +116,45 @@ UdpStatsdSink::UdpStatsdSink(ThreadLocal::SlotAllocator& tls,
 }
 
 void UdpStatsdSink::flush(Stats::Source& source) {
-  Writer& writer = tls_->getTyped<Writer>();
-  for (const Stats::CounterSharedPtr& counter : source.cachedCounters()) {
-    if (counter->used()) {
-      uint64_t delta = counter->latch();
-      writer.write(fmt::format("{}.{}:{}|c{}", prefix_, getName(*counter), delta,
-                               buildTagStr(counter->tags())));
-    }
+  DatagramBatcher batcher(tls_->getTyped<Writer>(), MaxDatagramBytes);
+  // statsd keeps the last value of each gauge, and a counter that was not incremented has nothing
+  // to report, so only the stats that changed since the previous flush are sent.
+  for (const Stats::CounterSharedPtr& counter : source.cachedChangedCounters()) {
+    const FormattedMetric& formatted_counter = formatted(counter, "c");
+    batcher.add(formatted_counter.head_, counter->latch(), formatted_counter.tail_);
   }
 
-  for (const Stats::GaugeSharedPtr& gauge : source.cachedGauges()) {
-    if (gauge->used()) {
-      writer.write(fmt::format("{}.{}:{}|g{}", prefix_, getName(*gauge), gauge->value(),
-                               buildTagStr(gauge->tags())));
+  for (const Stats::GaugeSharedPtr& gauge : source.cachedChangedGauges()) {
+    const FormattedMetric& formatted_gauge = formatted(gauge, "g");
+    batcher.add(formatted_gauge.head_, gauge->value(), formatted_gauge.tail_);
+  }
+  batcher.flush();
+
+  // Drop the entries of stats that have been destroyed, once there are more entries than stats.
+  if (formatted_metrics_.size() > source.cachedCounters().size() + source.cachedGauges().size()) {
+    for (auto it = formatted_metrics_.begin(); it != formatted_metrics_.end();) {
+      if (it->second.metric_.expired()) {
+        it = formatted_metrics_.erase(it);
+      } else {
+        ++it;
+      }
     }
   }
 }
 
+template <class MetricSharedPtr>
+const UdpStatsdSink::FormattedMetric& UdpStatsdSink::formatted(const MetricSharedPtr& metric,
+                                                               absl::string_view type) {
+  FormattedMetric& entry = formatted_metrics_[metric.get()];
+  // A new entry, or one left behind by a destroyed stat whose address has been reused.
+  if (entry.metric_.expired()) {
+    entry.metric_ = metric;
+    entry.head_ = fmt::format("{}.{}:", prefix_, getName(*metric));
+    entry.tail_ = fmt::format("|{}{}", type, buildTagStr(metric->tags()));
+  }
+  return entry;
+}
+
 void UdpStatsdSink::onHistogramComplete(const Stats::Histogram& histogram, uint64_t value) {
   // For statsd histograms are all timers.
   const std::string message(fmt::format("{}.{}:{}|ms{}", prefix_, getName(histogram),
@@ -113,16 +202,12 @@ TcpStatsdSink::TcpStatsdSink(const LocalInfo::LocalInfo& local_info,
 void TcpStatsdSink::flush(Stats::Source& source) {
   TlsSink& tls_sink = tls_->getTyped<TlsSink>();
   tls_sink.beginFlush(true);
-  for (const Stats::CounterSharedPtr& counter : source.cachedCounters()) {
-    if (counter->used()) {
-      tls_sink.flushCounter(counter->name(), counter->latch());
-    }
+  for (const Stats::CounterSharedPtr& counter : source.cachedChangedCounters()) {
+    tls_sink.flushCounter(counter->name(), counter->latch());
   }
 
-  for (const Stats::GaugeSharedPtr& gauge : source.cachedGauges()) {
-    if (gauge->used()) {
-      tls_sink.flushGauge(gauge->name(), gauge->value());
-    }
+  for (const Stats::GaugeSharedPtr& gauge : source.cachedChangedGauges()) {
+    tls_sink.flushGauge(gauge->name(), gauge->value());
   }
   tls_sink.endFlush(true);
 }
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include "envoy/local_info/local_info.h"
 #include "envoy/network/connection.h"
 #include "envoy/stats/histogram.h"
@@ -14,6 +19,8 @@
 #include "common/buffer/buffer_impl.h"
 #include "common/common/macros.h"
 
+#include "absl/strings/string_view.h"
+
 namespace Envoy {
 namespace Extensions {
 namespace StatSinks {
@@ -33,6 +40,15 @@ public:
   virtual ~Writer();
 
   virtual void write(const std::string& message);
+
+  /**
+   * Send several datagrams at once, with a single system call where the platform supports it.
+   * Like write(), this never blocks, and datagrams the socket cannot take are dropped.
+   * @param datagrams supplies the datagrams to send.
+   * @param count supplies the number of leading entries of datagrams to send.
+   */
+  virtual void writeBatch(const std::vector<std::string>& datagrams, size_t count);
+
   // Called in unit test to validate address.
   int getFdForTests() const { return fd_; };
 
@@ -40,6 +56,35 @@ private:
   int fd_;
 };
 
+/**
+ * Packs statsd lines, separated by newlines, into datagrams of a bounded size and hands them to a
+ * Writer a batch at a time. Lines longer than the bound are sent in a datagram of their own.
+ */
+class DatagramBatcher {
+public:
+  DatagramBatcher(Writer& writer, uint64_t max_datagram_bytes);
+
+  /**
+   * Add the line head + value + tail, formatting the value in place.
+   */
+  void add(absl::string_view head, uint64_t value, absl::string_view tail);
+
+  /**
+   * Send the datagrams added so far. Must be called once all lines have been added.
+   */
+  void flush();
+
+private:
+  // Datagrams handed to the writer in each call.
+  static constexpr size_t MaxBatchDatagrams = 64;
+
+  Writer& writer_;
+  const uint64_t max_datagram_bytes_;
+  // The strings are reused across batches so that their storage is only allocated once.
+  std::vector<std::string> datagrams_;
+  size_t used_{};
+};
+
 /**
  * Implementation of Sink that writes to a UDP statsd address.
  */
@@ -65,7 +110,25 @@ public:
   bool getUseTagForTest() { return use_tag_; }
   const std::string& getPrefix() { return prefix_; }
 
+  // Payload bytes per datagram, which keeps each datagram within a 1500 byte MTU.
+  static constexpr uint64_t MaxDatagramBytes = 1432;
+
 private:
+  /**
+   * The parts of a stat's line around its value, kept between flushes as the name and tags of a
+   * stat do not change.
+   */
+  struct FormattedMetric {
+    // Tells whether the entry still belongs to the stat at this address.
+    std::weak_ptr<const Stats::Metric> metric_;
+    // <prefix>.<name>:
+    std::string head_;
+    // |<type>|#<tags>
+    std::string tail_;
+  };
+
+  template <class MetricSharedPtr>
+  const FormattedMetric& formatted(const MetricSharedPtr& metric, absl::string_view type);
   const std::string getName(const Stats::Metric& metric);
   const std::string buildTagStr(const std::vector<Stats::Tag>& tags);
 
@@ -74,6 +137,8 @@ private:
   const bool use_tag_;
   // Prefix for all flushed stats.
   const std::string prefix_;
+  // Only used by flush(), which runs on the main thread.
+  std::unordered_map<const Stats::Metric*, FormattedMetric> formatted_metrics_;
 };
 
 /**
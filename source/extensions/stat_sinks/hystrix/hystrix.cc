@@ -21,6 +21,28 @@ namespace Extensions {
 namespace StatSinks {
 namespace Hystrix {
 
+namespace {
+
+/**
+ * Buffer fragment referencing the event stream of a flush, which is shared by the buffers of all
+ * the connected dashboards and kept alive until the last of them is done with it.
+ */
+class EventStreamFragment : public Buffer::BufferFragment {
+public:
+  EventStreamFragment(std::shared_ptr<const std::string> event_stream)
+      : event_stream_(std::move(event_stream)) {}
+
+  // Buffer::BufferFragment
+  const void* data() const override { return event_stream_->data(); }
+  size_t size() const override { return event_stream_->size(); }
+  void done() override { delete this; }
+
+private:
+  const std::shared_ptr<const std::string> event_stream_;
+};
+
+} // namespace
+
 const uint64_t HystrixSink::DEFAULT_NUM_BUCKETS;
 ClusterStatsCache::ClusterStatsCache(const std::string& cluster_name)
     : cluster_name_(cluster_name) {}
@@ -35,7 +57,8 @@ void ClusterStatsCache::printToStream(std::stringstream& out_str) {
   printRollingWindow(absl::StrCat(cluster_name_prefix, "total"), total_, out_str);
 }
 
-void ClusterStatsCache::printRollingWindow(absl::string_view name, RollingWindow rolling_window,
+void ClusterStatsCache::printRollingWindow(absl::string_view name,
+                                           const RollingWindow& rolling_window,
                                            std::stringstream& out_str) {
   out_str << name << " | ";
   for (auto specific_stat_vec_itr = rolling_window.begin();
@@ -67,7 +90,7 @@ void HystrixSink::pushNewValue(RollingWindow& rolling_window, uint64_t value) {
   }
 }
 
-uint64_t HystrixSink::getRollingValue(RollingWindow rolling_window) {
+uint64_t HystrixSink::getRollingValue(const RollingWindow& rolling_window) {
 
   if (rolling_window.empty()) {
     return 0;
@@ -81,11 +104,21 @@ uint64_t HystrixSink::getRollingValue(RollingWindow rolling_window) {
   }
 }
 
-void HystrixSink::updateRollingWindowMap(const Upstream::ClusterInfo& cluster_info,
+void HystrixSink::updateRollingWindowMap(const Upstream::ClusterInfoConstSharedPtr& cluster_info,
                                          ClusterStatsCache& cluster_stats_cache) {
-  const std::string cluster_name = cluster_info.name();
-  Upstream::ClusterStats& cluster_stats = cluster_info.stats();
-  Stats::Scope& cluster_stats_scope = cluster_info.statsScope();
+  if (cluster_stats_cache.cluster_info_ != cluster_info) {
+    Stats::Scope& cluster_stats_scope = cluster_info->statsScope();
+    cluster_stats_cache.upstream_rq_2xx_ = &cluster_stats_scope.counter("upstream_rq_2xx");
+    cluster_stats_cache.upstream_rq_4xx_ = &cluster_stats_scope.counter("upstream_rq_4xx");
+    cluster_stats_cache.retry_upstream_rq_4xx_ =
+        &cluster_stats_scope.counter("retry.upstream_rq_4xx");
+    cluster_stats_cache.upstream_rq_5xx_ = &cluster_stats_scope.counter("upstream_rq_5xx");
+    cluster_stats_cache.retry_upstream_rq_5xx_ =
+        &cluster_stats_scope.counter("retry.upstream_rq_5xx");
+    cluster_stats_cache.membership_total_ = &cluster_stats_scope.gauge("membership_total");
+    cluster_stats_cache.cluster_info_ = cluster_info;
+  }
+  Upstream::ClusterStats& cluster_stats = cluster_info->stats();
 
   // Combining timeouts+retries - retries are counted  as separate requests
   // (alternative: each request including the retries counted as 1).
@@ -98,15 +131,15 @@ void HystrixSink::updateRollingWindowMap(const Upstream::ClusterInfo& cluster_in
   // (alternative: each request including the retries counted as 1)
   // since timeouts are 504 (or 408), deduce them from here ("-" sign).
   // Timeout retries were not counted here anyway.
-  uint64_t errors = cluster_stats_scope.counter("upstream_rq_5xx").value() +
-                    cluster_stats_scope.counter("retry.upstream_rq_5xx").value() +
-                    cluster_stats_scope.counter("upstream_rq_4xx").value() +
-                    cluster_stats_scope.counter("retry.upstream_rq_4xx").value() -
+  uint64_t errors = cluster_stats_cache.upstream_rq_5xx_->value() +
+                    cluster_stats_cache.retry_upstream_rq_5xx_->value() +
+                    cluster_stats_cache.upstream_rq_4xx_->value() +
+                    cluster_stats_cache.retry_upstream_rq_4xx_->value() -
                     cluster_stats.upstream_rq_timeout_.value();
 
   pushNewValue(cluster_stats_cache.errors_, errors);
 
-  uint64_t success = cluster_stats_scope.counter("upstream_rq_2xx").value();
+  uint64_t success = cluster_stats_cache.upstream_rq_2xx_->value();
   pushNewValue(cluster_stats_cache.success_, success);
 
   uint64_t rejected = cluster_stats.upstream_rq_pending_overflow_.value();
@@ -155,17 +188,47 @@ void HystrixSink::addHystrixCommand(ClusterStatsCache& cluster_stats_cache,
 
   std::time_t currentTime = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
 
-  ss << "data: {";
-  addStringToStream("type", "HystrixCommand", ss, true);
-  addStringToStream("name", cluster_name, ss);
-  addStringToStream("group", "NA", ss);
-  addIntToStream("currentTime", static_cast<uint64_t>(currentTime), ss);
-  addInfoToStream("isCircuitBreakerOpen", "false", ss);
+  if (cluster_stats_cache.command_prefix_.empty()) {
+    std::stringstream prefix;
+    prefix << "data: {";
+    addStringToStream("type", "HystrixCommand", prefix, true);
+    addStringToStream("name", cluster_name, prefix);
+    addStringToStream("group", "NA", prefix);
+    prefix << ", \"currentTime\": ";
+    cluster_stats_cache.command_prefix_ = prefix.str();
+  }
 
   uint64_t errors = getRollingValue(cluster_stats_cache.errors_);
   uint64_t timeouts = getRollingValue(cluster_stats_cache.timeouts_);
   uint64_t rejected = getRollingValue(cluster_stats_cache.rejected_);
   uint64_t total = getRollingValue(cluster_stats_cache.total_);
+  uint64_t success = getRollingValue(cluster_stats_cache.success_);
+
+  const ClusterStatsCache::CommandValues values{
+      {errors, timeouts, rejected, total, success, max_concurrent_requests, reporting_hosts,
+       static_cast<uint64_t>(rolling_window_ms.count())}};
+  if (cluster_stats_cache.command_suffix_.empty() ||
+      values != cluster_stats_cache.command_values_ ||
+      histogram != cluster_stats_cache.command_histogram_) {
+    cluster_stats_cache.command_suffix_ =
+        formatHystrixCommand(errors, timeouts, rejected, total, success, max_concurrent_requests,
+                             reporting_hosts, rolling_window_ms, histogram);
+    cluster_stats_cache.command_values_ = values;
+    cluster_stats_cache.command_histogram_ = histogram;
+  }
+
+  ss << cluster_stats_cache.command_prefix_ << static_cast<uint64_t>(currentTime)
+     << cluster_stats_cache.command_suffix_;
+}
+
+std::string HystrixSink::formatHystrixCommand(uint64_t errors, uint64_t timeouts,
+                                              uint64_t rejected, uint64_t total, uint64_t success,
+                                              uint64_t max_concurrent_requests,
+                                              uint64_t reporting_hosts,
+                                              std::chrono::milliseconds rolling_window_ms,
+                                              const QuantileLatencyMap& histogram) {
+  std::stringstream ss;
+  addInfoToStream("isCircuitBreakerOpen", "false", ss);
 
   uint64_t error_rate = total == 0 ? 0 : (100 * (errors + timeouts + rejected)) / total;
 
@@ -188,7 +251,7 @@ void HystrixSink::addHystrixCommand(ClusterStatsCache& cluster_stats_cache,
   // there is no parallel counter in Envoy since as a result of errors (outlier detection)
   // requests are not rejected, but rather the node is removed from load balancer healthy pool.
   addIntToStream("rollingCountShortCircuited", 0, ss);
-  addIntToStream("rollingCountSuccess", getRollingValue(cluster_stats_cache.success_), ss);
+  addIntToStream("rollingCountSuccess", success, ss);
   addIntToStream("rollingCountThreadPoolRejected", 0, ss);
   addIntToStream("rollingCountTimeout", timeouts, ss);
   addIntToStream("rollingCountBadRequests", 0, ss);
@@ -213,13 +276,23 @@ void HystrixSink::addHystrixCommand(ClusterStatsCache& cluster_stats_cache,
                  rolling_window_ms.count(), ss);
 
   ss << "}" << std::endl << std::endl;
+  return ss.str();
 }
 
-void HystrixSink::addHystrixThreadPool(absl::string_view cluster_name, uint64_t queue_size,
+void HystrixSink::addHystrixThreadPool(ClusterStatsCache& cluster_stats_cache,
+                                       absl::string_view cluster_name, uint64_t queue_size,
                                        uint64_t reporting_hosts,
                                        std::chrono::milliseconds rolling_window_ms,
-                                       std::stringstream& ss) {
+                                       std::stringstream& out) {
+  const ClusterStatsCache::ThreadPoolValues values{
+      {queue_size, reporting_hosts, static_cast<uint64_t>(rolling_window_ms.count())}};
+  if (!cluster_stats_cache.thread_pool_.empty() &&
+      values == cluster_stats_cache.thread_pool_values_) {
+    out << cluster_stats_cache.thread_pool_;
+    return;
+  }
 
+  std::stringstream ss;
   ss << "data: {";
   addIntToStream("currentPoolSize", 0, ss, true);
   addIntToStream("rollingMaxActiveThreads", 0, ss);
@@ -239,6 +312,9 @@ void HystrixSink::addHystrixThreadPool(absl::string_view cluster_name, uint64_t
   addIntToStream("currentMaximumPoolSize", 0, ss);
 
   ss << "}" << std::endl << std::endl;
+  cluster_stats_cache.thread_pool_ = ss.str();
+  cluster_stats_cache.thread_pool_values_ = values;
+  out << cluster_stats_cache.thread_pool_;
 }
 
 void HystrixSink::addClusterStatsToStream(ClusterStatsCache& cluster_stats_cache,
@@ -251,8 +327,8 @@ void HystrixSink::addClusterStatsToStream(ClusterStatsCache& cluster_stats_cache
 
   addHystrixCommand(cluster_stats_cache, cluster_name, max_concurrent_requests, reporting_hosts,
                     rolling_window_ms, histogram, ss);
-  addHystrixThreadPool(cluster_name, max_concurrent_requests, reporting_hosts, rolling_window_ms,
-                       ss);
+  addHystrixThreadPool(cluster_stats_cache, cluster_name, max_concurrent_requests, reporting_hosts,
+                       rolling_window_ms, ss);
 }
 
 const std::string HystrixSink::printRollingWindows() {
@@ -366,19 +442,21 @@ void HystrixSink::flush(Stats::Source& source) {
     }
 
     // update rolling window with cluster stats
-    updateRollingWindowMap(*cluster_info, *cluster_stats_cache_ptr);
+    updateRollingWindowMap(cluster_info, *cluster_stats_cache_ptr);
 
     // append it to stream to be sent
     addClusterStatsToStream(
         *cluster_stats_cache_ptr, cluster_info->name(),
         cluster_info->resourceManager(Upstream::ResourcePriority::Default).pendingRequests().max(),
-        cluster_info->statsScope().gauge("membership_total").value(), server_.statsFlushInterval(),
+        cluster_stats_cache_ptr->membership_total_->value(), server_.statsFlushInterval(),
         time_histograms[cluster_info->name()], ss);
   }
 
-  Buffer::OwnedImpl data;
+  // The event stream is only formatted once, and referenced by the buffers of all the dashboards.
+  const auto event_stream = std::make_shared<const std::string>(ss.str());
   for (auto callbacks : callbacks_list_) {
-    data.add(ss.str());
+    Buffer::OwnedImpl data;
+    data.addBufferFragment(*new EventStreamFragment(event_stream));
     callbacks->encodeData(data, false);
   }
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <map>
 #include <memory>
 #include <vector>
@@ -30,7 +31,7 @@ struct ClusterStatsCache {
   ClusterStatsCache(const std::string& cluster_name);
 
   void printToStream(std::stringstream& out_str);
-  void printRollingWindow(absl::string_view name, RollingWindow rolling_window,
+  void printRollingWindow(absl::string_view name, const RollingWindow& rolling_window,
                           std::stringstream& out_str);
   std::string cluster_name_;
 
@@ -40,6 +41,28 @@ struct ClusterStatsCache {
   RollingWindow total_;
   RollingWindow timeouts_;
   RollingWindow rejected_;
+
+  // The stats read on every flush, looked up by name once per cluster info. Holding the cluster
+  // info keeps them alive.
+  Upstream::ClusterInfoConstSharedPtr cluster_info_;
+  Stats::Counter* upstream_rq_2xx_{};
+  Stats::Counter* upstream_rq_4xx_{};
+  Stats::Counter* retry_upstream_rq_4xx_{};
+  Stats::Counter* upstream_rq_5xx_{};
+  Stats::Counter* retry_upstream_rq_5xx_{};
+  Stats::Gauge* membership_total_{};
+
+  // The event stream entries of the cluster. Only the current time changes from flush to flush
+  // while the cluster has no traffic, so the rest of the entries is kept formatted, along with the
+  // values it was formatted with, and only formatted again when they change.
+  typedef std::array<uint64_t, 8> CommandValues;
+  typedef std::array<uint64_t, 3> ThreadPoolValues;
+  std::string command_prefix_;
+  std::string command_suffix_;
+  CommandValues command_values_{};
+  QuantileLatencyMap command_histogram_;
+  std::string thread_pool_;
+  ThreadPoolValues thread_pool_values_{};
 };
 
 typedef std::unique_ptr<ClusterStatsCache> ClusterStatsCachePtr;
@@ -84,7 +107,7 @@ public:
   /**
    * Calculate values needed to create the stream and write into the map.
    */
-  void updateRollingWindowMap(const Upstream::ClusterInfo& cluster_info,
+  void updateRollingWindowMap(const Upstream::ClusterInfoConstSharedPtr& cluster_info,
                               ClusterStatsCache& cluster_stats_cache);
   /**
    * Clear map.
@@ -99,7 +122,7 @@ public:
   /**
    * Get the statistic's value change over the rolling window time frame.
    */
-  uint64_t getRollingValue(RollingWindow rolling_window);
+  uint64_t getRollingValue(const RollingWindow& rolling_window);
 
   /**
    * Format the given key and value to "key"=value, and adding to the stringstream.
@@ -140,12 +163,22 @@ private:
                          std::chrono::milliseconds rolling_window_ms,
                          const QuantileLatencyMap& histogram, std::stringstream& ss);
 
+  /**
+   * Format the part of a HystrixCommand event which follows the current time.
+   */
+  static std::string formatHystrixCommand(uint64_t errors, uint64_t timeouts, uint64_t rejected,
+                                          uint64_t total, uint64_t success,
+                                          uint64_t max_concurrent_requests,
+                                          uint64_t reporting_hosts,
+                                          std::chrono::milliseconds rolling_window_ms,
+                                          const QuantileLatencyMap& histogram);
+
   /**
    * Generate HystrixThreadPool event stream.
    */
-  void addHystrixThreadPool(absl::string_view cluster_name, uint64_t queue_size,
-                            uint64_t reporting_hosts, std::chrono::milliseconds rolling_window_ms,
-                            std::stringstream& ss);
+  void addHystrixThreadPool(ClusterStatsCache& cluster_stats_cache, absl::string_view cluster_name,
+                            uint64_t queue_size, uint64_t reporting_hosts,
+                            std::chrono::milliseconds rolling_window_ms, std::stringstream& ss);
 
   std::vector<Http::StreamDecoderFilterCallbacks*> callbacks_list_;
   Server::Instance& server_;
@@ -1,11 +1,14 @@
 #include "extensions/stat_sinks/metrics_service/config.h"
 
+#include <limits>
+
 #include "envoy/config/metrics/v2/metrics_service.pb.h"
 #include "envoy/config/metrics/v2/metrics_service.pb.validate.h"
 #include "envoy/registry/registry.h"
 
 #include "common/grpc/async_client_impl.h"
 #include "common/network/resolver_impl.h"
+#include "common/protobuf/utility.h"
 
 #include "extensions/stat_sinks/metrics_service/grpc_metrics_service_impl.h"
 #include "extensions/stat_sinks/well_known_names.h"
@@ -29,7 +32,11 @@ Stats::SinkPtr MetricsServiceSinkFactory::createStatsSink(const Protobuf::Messag
               grpc_service, server.stats(), false),
           server.threadLocal(), server.localInfo());
 
-  return std::make_unique<MetricsServiceSink>(grpc_metrics_streamer, server.timeSystem());
+  return std::make_unique<MetricsServiceSink>(
+      grpc_metrics_streamer, server.timeSystem(),
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(sink_config, max_metrics_per_message,
+                                      std::numeric_limits<uint32_t>::max()),
+      sink_config.report_counters_as_deltas());
 }
 
 ProtobufTypes::MessagePtr MetricsServiceSinkFactory::createEmptyConfigProto() {
@@ -1,5 +1,8 @@
 #include "extensions/stat_sinks/metrics_service/grpc_metrics_service_impl.h"
 
+#include <algorithm>
+#include <chrono>
+
 #include "envoy/common/exception.h"
 #include "envoy/event/dispatcher.h"
 #include "envoy/stats/histogram.h"
@@ -62,40 +65,41 @@ void GrpcMetricsStreamerImpl::ThreadLocalStreamer::send(
 }
 
 MetricsServiceSink::MetricsServiceSink(const GrpcMetricsStreamerSharedPtr& grpc_metrics_streamer,
-                                       Event::TimeSystem& time_system)
-    : grpc_metrics_streamer_(grpc_metrics_streamer), time_system_(time_system) {}
+                                       Event::TimeSystem& time_system,
+                                       uint32_t max_metrics_per_message,
+                                       bool report_counters_as_deltas)
+    : grpc_metrics_streamer_(grpc_metrics_streamer), time_system_(time_system),
+      max_metrics_per_message_(max_metrics_per_message),
+      report_counters_as_deltas_(report_counters_as_deltas) {
+  ASSERT(max_metrics_per_message_ > 0);
+}
 
-void MetricsServiceSink::flushCounter(const Stats::Counter& counter) {
+io::prometheus::client::Metric*
+MetricsServiceSink::addMetric(const std::string& name, io::prometheus::client::MetricType type) {
+  if (static_cast<uint32_t>(message_.envoy_metrics_size()) >= max_metrics_per_message_) {
+    sendMessage();
+  }
   io::prometheus::client::MetricFamily* metrics_family = message_.add_envoy_metrics();
-  metrics_family->set_type(io::prometheus::client::MetricType::COUNTER);
-  metrics_family->set_name(counter.name());
-  auto* metric = metrics_family->add_metric();
-  metric->set_timestamp_ms(std::chrono::duration_cast<std::chrono::milliseconds>(
-                               time_system_.systemTime().time_since_epoch())
-                               .count());
+  metrics_family->set_type(type);
+  metrics_family->set_name(name);
+  io::prometheus::client::Metric* metric = metrics_family->add_metric();
+  metric->set_timestamp_ms(timestamp_ms_);
+  return metric;
+}
+
+void MetricsServiceSink::flushCounter(const Stats::Counter& counter, uint64_t value) {
+  auto* metric = addMetric(counter.name(), io::prometheus::client::MetricType::COUNTER);
   auto* counter_metric = metric->mutable_counter();
-  counter_metric->set_value(counter.value());
+  counter_metric->set_value(value);
 }
 
 void MetricsServiceSink::flushGauge(const Stats::Gauge& gauge) {
-  io::prometheus::client::MetricFamily* metrics_family = message_.add_envoy_metrics();
-  metrics_family->set_type(io::prometheus::client::MetricType::GAUGE);
-  metrics_family->set_name(gauge.name());
-  auto* metric = metrics_family->add_metric();
-  metric->set_timestamp_ms(std::chrono::duration_cast<std::chrono::milliseconds>(
-                               time_system_.systemTime().time_since_epoch())
-                               .count());
+  auto* metric = addMetric(gauge.name(), io::prometheus::client::MetricType::GAUGE);
   auto* gauage_metric = metric->mutable_gauge();
   gauage_metric->set_value(gauge.value());
 }
 void MetricsServiceSink::flushHistogram(const Stats::ParentHistogram& histogram) {
-  io::prometheus::client::MetricFamily* metrics_family = message_.add_envoy_metrics();
-  metrics_family->set_type(io::prometheus::client::MetricType::SUMMARY);
-  metrics_family->set_name(histogram.name());
-  auto* metric = metrics_family->add_metric();
-  metric->set_timestamp_ms(std::chrono::duration_cast<std::chrono::milliseconds>(
-                               time_system_.systemTime().time_since_epoch())
-                               .count());
+  auto* metric = addMetric(histogram.name(), io::prometheus::client::MetricType::SUMMARY);
   auto* summary_metric = metric->mutable_summary();
   const Stats::HistogramStatistics& hist_stats = histogram.intervalStatistics();
   for (size_t i = 0; i < hist_stats.supportedQuantiles().size(); i++) {
@@ -105,18 +109,54 @@ void MetricsServiceSink::flushHistogram(const Stats::ParentHistogram& histogram)
   }
 }
 
+uint64_t MetricsServiceSink::counterDelta(const Stats::CounterSharedPtr& counter) {
+  CounterValue& previous = counter_values_[counter.get()];
+  // A new entry, or one left behind by a destroyed counter whose address has been reused.
+  if (previous.counter_.expired()) {
+    previous.counter_ = counter;
+    previous.value_ = 0;
+  }
+  const uint64_t value = counter->value();
+  // The counter may have been reset since the previous flush.
+  const uint64_t delta = value >= previous.value_ ? value - previous.value_ : value;
+  previous.value_ = value;
+  return delta;
+}
+
+void MetricsServiceSink::sendMessage() {
+  grpc_metrics_streamer_->send(message_);
+  messages_sent_++;
+  // for perf reasons, clear the identifer after the first flush.
+  if (message_.has_identifier()) {
+    message_.clear_identifier();
+  }
+  message_.clear_envoy_metrics();
+}
+
 void MetricsServiceSink::flush(Stats::Source& source) {
   message_.clear_envoy_metrics();
+  messages_sent_ = 0;
+  timestamp_ms_ = std::chrono::duration_cast<std::chrono::milliseconds>(
+                      time_system_.systemTime().time_since_epoch())
+                      .count();
   const std::vector<Stats::CounterSharedPtr>& counters = source.cachedCounters();
   const std::vector<Stats::GaugeSharedPtr>& gauges = source.cachedGauges();
   const std::vector<Stats::ParentHistogramSharedPtr>& histograms = source.cachedHistograms();
   // TODO(mrice32): there's probably some more sophisticated preallocation we can do here where we
   // actually preallocate the submessages and then pass ownership to the proto (rather than just
   // preallocating the pointer array).
-  message_.mutable_envoy_metrics()->Reserve(counters.size() + gauges.size() + histograms.size());
-  for (const Stats::CounterSharedPtr& counter : counters) {
-    if (counter->used()) {
-      flushCounter(*counter);
+  message_.mutable_envoy_metrics()->Reserve(
+      std::min<uint64_t>(counters.size() + gauges.size() + histograms.size(),
+                         max_metrics_per_message_));
+  if (report_counters_as_deltas_) {
+    for (const Stats::CounterSharedPtr& counter : source.cachedChangedCounters()) {
+      flushCounter(*counter, counterDelta(counter));
+    }
+  } else {
+    for (const Stats::CounterSharedPtr& counter : counters) {
+      if (counter->used()) {
+        flushCounter(*counter, counter->value());
+      }
     }
   }
 
@@ -132,10 +172,21 @@ void MetricsServiceSink::flush(Stats::Source& source) {
     }
   }
 
-  grpc_metrics_streamer_->send(message_);
-  // for perf reasons, clear the identifer after the first flush.
-  if (message_.has_identifier()) {
-    message_.clear_identifier();
+  // Every flush sends at least one message, even if it has no metrics.
+  if (message_.envoy_metrics_size() > 0 || messages_sent_ == 0) {
+    sendMessage();
+  }
+
+  // Drop the values of counters that have been destroyed, once there are more entries than
+  // counters.
+  if (counter_values_.size() > counters.size()) {
+    for (auto it = counter_values_.begin(); it != counter_values_.end();) {
+      if (it->second.counter_.expired()) {
+        it = counter_values_.erase(it);
+      } else {
+        ++it;
+      }
+    }
   }
 }
 
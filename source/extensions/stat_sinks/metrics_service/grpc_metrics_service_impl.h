@@ -1,5 +1,11 @@
 #pragma once
 
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
 #include "envoy/grpc/async_client.h"
 #include "envoy/local_info/local_info.h"
 #include "envoy/network/connection.h"
@@ -112,18 +118,43 @@ class MetricsServiceSink : public Stats::Sink {
 public:
   // MetricsService::Sink
   MetricsServiceSink(const GrpcMetricsStreamerSharedPtr& grpc_metrics_streamer,
-                     Event::TimeSystem& time_system);
+                     Event::TimeSystem& time_system,
+                     uint32_t max_metrics_per_message = std::numeric_limits<uint32_t>::max(),
+                     bool report_counters_as_deltas = false);
   void flush(Stats::Source& source) override;
   void onHistogramComplete(const Stats::Histogram&, uint64_t) override {}
 
-  void flushCounter(const Stats::Counter& counter);
+  void flushCounter(const Stats::Counter& counter, uint64_t value);
   void flushGauge(const Stats::Gauge& gauge);
   void flushHistogram(const Stats::ParentHistogram& histogram);
 
 private:
+  /**
+   * The value of a counter as of the previous flush, for reporting deltas.
+   */
+  struct CounterValue {
+    // Tells whether the entry still belongs to the counter at this address.
+    std::weak_ptr<const Stats::Counter> counter_;
+    uint64_t value_{};
+  };
+
+  io::prometheus::client::Metric* addMetric(const std::string& name,
+                                            io::prometheus::client::MetricType type);
+  uint64_t counterDelta(const Stats::CounterSharedPtr& counter);
+  void sendMessage();
+
   GrpcMetricsStreamerSharedPtr grpc_metrics_streamer_;
+  // Reused across messages and flushes. Clearing the metric families keeps the cleared objects
+  // around, so that once the first message has been built, later ones are built in place without
+  // allocating.
   envoy::service::metrics::v2::StreamMetricsMessage message_;
   Event::TimeSystem& time_system_;
+  const uint32_t max_metrics_per_message_;
+  const bool report_counters_as_deltas_;
+  // Timestamp of all the metrics of the current flush.
+  int64_t timestamp_ms_{};
+  uint64_t messages_sent_{};
+  std::unordered_map<const Stats::Counter*, CounterValue> counter_values_;
 };
 
 } // namespace MetricsService
@@ -24,8 +24,14 @@ public:
   opentracing::expected<void> Set(opentracing::string_view key,
                                   opentracing::string_view value) const override {
     Http::LowerCaseString lowercase_key{key};
-    request_headers_.remove(lowercase_key);
-    request_headers_.addCopy(std::move(lowercase_key), value);
+    // A header already carrying a span context, i.e. propagated from downstream, is overwritten in
+    // place rather than removed and added back.
+    Http::HeaderEntry* entry = request_headers_.get(lowercase_key);
+    if (entry != nullptr) {
+      entry->value(value.data(), value.size());
+    } else {
+      request_headers_.addCopy(std::move(lowercase_key), value);
+    }
     return {};
   }
 
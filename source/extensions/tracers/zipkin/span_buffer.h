@@ -36,11 +36,11 @@ public:
   /**
    * Adds the given Zipkin span to the buffer.
    *
-   * @param span The span to be added to the buffer.
+   * @param span The span to be moved into the buffer.
    *
    * @return true if the span was successfully added, or false if the buffer was full.
    */
-  bool addSpan(const Span& span);
+  bool addSpan(Span&& span);
 
   /**
    * Empties the buffer. This method is supposed to be called when all buffered spans
@@ -31,9 +31,9 @@ public:
    * Method that a concrete Reporter class must implement to handle finished spans.
    * For example, a span-buffer management policy could be implemented.
    *
-   * @param span The span that needs action.
+   * @param span The span that needs action, which the reporter may take over.
    */
-  virtual void reportSpan(const Span& span) PURE;
+  virtual void reportSpan(Span&& span) PURE;
 };
 
 typedef std::unique_ptr<Reporter> ReporterPtr;
@@ -28,7 +28,12 @@ Endpoint& Endpoint::operator=(const Endpoint& ep) {
 
 const std::string Endpoint::toJson() {
   rapidjson::StringBuffer s;
-  rapidjson::Writer<rapidjson::StringBuffer> writer(s);
+  JsonWriter writer(s);
+  writeJson(writer);
+  return s.GetString();
+}
+
+void Endpoint::writeJson(JsonWriter& writer) {
   writer.StartObject();
   if (!address_) {
     writer.Key(ZipkinJsonFieldNames::get().ENDPOINT_IPV4.c_str());
@@ -43,16 +48,14 @@ const std::string Endpoint::toJson() {
       // IPv6
       writer.Key(ZipkinJsonFieldNames::get().ENDPOINT_IPV6.c_str());
     }
-    writer.String(address_->ip()->addressAsString().c_str());
+    const std::string& address = address_->ip()->addressAsString();
+    writer.String(address.c_str(), address.size());
     writer.Key(ZipkinJsonFieldNames::get().ENDPOINT_PORT.c_str());
     writer.Uint(address_->ip()->port());
   }
   writer.Key(ZipkinJsonFieldNames::get().ENDPOINT_SERVICE_NAME.c_str());
-  writer.String(service_name_.c_str());
+  writer.String(service_name_.c_str(), service_name_.size());
   writer.EndObject();
-  std::string json_string = s.GetString();
-
-  return json_string;
 }
 
 Annotation::Annotation(const Annotation& ann) {
@@ -81,22 +84,22 @@ void Annotation::changeEndpointServiceName(const std::string& service_name) {
 
 const std::string Annotation::toJson() {
   rapidjson::StringBuffer s;
-  rapidjson::Writer<rapidjson::StringBuffer> writer(s);
+  JsonWriter writer(s);
+  writeJson(writer);
+  return s.GetString();
+}
+
+void Annotation::writeJson(JsonWriter& writer) {
   writer.StartObject();
   writer.Key(ZipkinJsonFieldNames::get().ANNOTATION_TIMESTAMP.c_str());
   writer.Uint64(timestamp_);
   writer.Key(ZipkinJsonFieldNames::get().ANNOTATION_VALUE.c_str());
-  writer.String(value_.c_str());
-  writer.EndObject();
-
-  std::string json_string = s.GetString();
-
+  writer.String(value_.c_str(), value_.size());
   if (endpoint_) {
-    Util::mergeJsons(json_string, static_cast<Endpoint>(endpoint_.value()).toJson(),
-                     ZipkinJsonFieldNames::get().ANNOTATION_ENDPOINT.c_str());
+    writer.Key(ZipkinJsonFieldNames::get().ANNOTATION_ENDPOINT.c_str());
+    endpoint_.value().writeJson(writer);
   }
-
-  return json_string;
+  writer.EndObject();
 }
 
 BinaryAnnotation::BinaryAnnotation(const BinaryAnnotation& ann) {
@@ -121,22 +124,22 @@ BinaryAnnotation& BinaryAnnotation::operator=(const BinaryAnnotation& ann) {
 
 const std::string BinaryAnnotation::toJson() {
   rapidjson::StringBuffer s;
-  rapidjson::Writer<rapidjson::StringBuffer> writer(s);
+  JsonWriter writer(s);
+  writeJson(writer);
+  return s.GetString();
+}
+
+void BinaryAnnotation::writeJson(JsonWriter& writer) {
   writer.StartObject();
   writer.Key(ZipkinJsonFieldNames::get().BINARY_ANNOTATION_KEY.c_str());
-  writer.String(key_.c_str());
+  writer.String(key_.c_str(), key_.size());
   writer.Key(ZipkinJsonFieldNames::get().BINARY_ANNOTATION_VALUE.c_str());
-  writer.String(value_.c_str());
-  writer.EndObject();
-
-  std::string json_string = s.GetString();
-
+  writer.String(value_.c_str(), value_.size());
   if (endpoint_) {
-    Util::mergeJsons(json_string, static_cast<Endpoint>(endpoint_.value()).toJson(),
-                     ZipkinJsonFieldNames::get().BINARY_ANNOTATION_ENDPOINT.c_str());
+    writer.Key(ZipkinJsonFieldNames::get().BINARY_ANNOTATION_ENDPOINT.c_str());
+    endpoint_.value().writeJson(writer);
   }
-
-  return json_string;
+  writer.EndObject();
 }
 
 const std::string Span::EMPTY_HEX_STRING_ = "0000000000000000";
@@ -173,12 +176,17 @@ void Span::setServiceName(const std::string& service_name) {
 
 const std::string Span::toJson() {
   rapidjson::StringBuffer s;
-  rapidjson::Writer<rapidjson::StringBuffer> writer(s);
+  JsonWriter writer(s);
+  writeJson(writer);
+  return s.GetString();
+}
+
+void Span::writeJson(JsonWriter& writer) {
   writer.StartObject();
   writer.Key(ZipkinJsonFieldNames::get().SPAN_TRACE_ID.c_str());
   writer.String(traceIdAsHexString().c_str());
   writer.Key(ZipkinJsonFieldNames::get().SPAN_NAME.c_str());
-  writer.String(name_.c_str());
+  writer.String(name_.c_str(), name_.size());
   writer.Key(ZipkinJsonFieldNames::get().SPAN_ID.c_str());
   writer.String(Hex::uint64ToHex(id_).c_str());
 
@@ -197,26 +205,21 @@ const std::string Span::toJson() {
     writer.Int64(duration_.value());
   }
 
-  writer.EndObject();
-
-  std::string json_string = s.GetString();
-
-  std::vector<std::string> annotation_json_vector;
-
-  for (auto it = annotations_.begin(); it != annotations_.end(); it++) {
-    annotation_json_vector.push_back(it->toJson());
+  writer.Key(ZipkinJsonFieldNames::get().SPAN_ANNOTATIONS.c_str());
+  writer.StartArray();
+  for (Annotation& annotation : annotations_) {
+    annotation.writeJson(writer);
   }
-  Util::addArrayToJson(json_string, annotation_json_vector,
-                       ZipkinJsonFieldNames::get().SPAN_ANNOTATIONS.c_str());
+  writer.EndArray();
 
-  std::vector<std::string> binary_annotation_json_vector;
-  for (auto it = binary_annotations_.begin(); it != binary_annotations_.end(); it++) {
-    binary_annotation_json_vector.push_back(it->toJson());
+  writer.Key(ZipkinJsonFieldNames::get().SPAN_BINARY_ANNOTATIONS.c_str());
+  writer.StartArray();
+  for (BinaryAnnotation& binary_annotation : binary_annotations_) {
+    binary_annotation.writeJson(writer);
   }
-  Util::addArrayToJson(json_string, binary_annotation_json_vector,
-                       ZipkinJsonFieldNames::get().SPAN_BINARY_ANNOTATIONS.c_str());
+  writer.EndArray();
 
-  return json_string;
+  writer.EndObject();
 }
 
 void Span::finish() {
@@ -12,12 +12,16 @@
 #include "extensions/tracers/zipkin/util.h"
 
 #include "absl/types/optional.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
 
 namespace Envoy {
 namespace Extensions {
 namespace Tracers {
 namespace Zipkin {
 
+typedef rapidjson::Writer<rapidjson::StringBuffer> JsonWriter;
+
 /**
  * Base class to be inherited by all classes that represent Zipkin-related concepts, namely:
  * endpoint, annotation, binary annotation, and span.
@@ -34,6 +38,12 @@ public:
    * the corresponding abstraction to a Zipkin-compliant JSON.
    */
   virtual const std::string toJson() PURE;
+
+  /**
+   * Writes the Zipkin-compliant JSON of the abstraction, so that nested abstractions and the
+   * spans of a batch are serialized into a single buffer.
+   */
+  virtual void writeJson(JsonWriter& writer) PURE;
 };
 
 /**
@@ -51,6 +61,8 @@ public:
    * Assignment operator.
    */
   Endpoint& operator=(const Endpoint&);
+  Endpoint(Endpoint&&) = default;
+  Endpoint& operator=(Endpoint&&) = default;
 
   /**
    * Default constructor. Creates an empty Endpoint.
@@ -93,6 +105,8 @@ public:
    */
   const std::string toJson() override;
 
+  void writeJson(JsonWriter& writer) override;
+
 private:
   std::string service_name_;
   Network::Address::InstanceConstSharedPtr address_;
@@ -113,6 +127,8 @@ public:
    * Assignment operator.
    */
   Annotation& operator=(const Annotation&);
+  Annotation(Annotation&&) = default;
+  Annotation& operator=(Annotation&&) = default;
 
   /**
    * Default constructor. Creates an empty annotation.
@@ -185,6 +201,8 @@ public:
    */
   const std::string toJson() override;
 
+  void writeJson(JsonWriter& writer) override;
+
 private:
   uint64_t timestamp_;
   std::string value_;
@@ -212,6 +230,8 @@ public:
    * Assignment operator.
    */
   BinaryAnnotation& operator=(const BinaryAnnotation&);
+  BinaryAnnotation(BinaryAnnotation&&) = default;
+  BinaryAnnotation& operator=(BinaryAnnotation&&) = default;
 
   /**
    * Default constructor. Creates an empty binary annotation.
@@ -283,6 +303,8 @@ public:
    */
   const std::string toJson() override;
 
+  void writeJson(JsonWriter& writer) override;
+
 private:
   std::string key_;
   std::string value_;
@@ -302,6 +324,11 @@ public:
    */
   Span(const Span&);
 
+  /**
+   * Move constructor, used to hand finished spans to the reporter without copying them.
+   */
+  Span(Span&&) = default;
+
   /**
    * Default constructor. Creates an empty span.
    */
@@ -515,6 +542,8 @@ public:
    */
   const std::string toJson() override;
 
+  void writeJson(JsonWriter& writer) override;
+
   /**
    * Associates a Tracer object with the span. The tracer's reportSpan() method is invoked
    * by the span's finish() method so that the tracer can decide what to do with the span
@@ -16,33 +16,51 @@ TsiFrameProtector::TsiFrameProtector(CFrameProtectorPtr&& frame_protector)
 tsi_result TsiFrameProtector::protect(Buffer::Instance& input, Buffer::Instance& output) {
   ASSERT(frame_protector_);
 
-  unsigned char protected_buffer[BUFFER_SIZE];
+  // The input is protected slice by slice rather than linearized, and the frames are written
+  // straight into space reserved in the output. Space reserved but not filled by a call is reused
+  // by the next reservation. All of the input goes through as many full frames as it takes before
+  // the single flush of the last partial frame.
   while (input.length() > 0) {
-    auto* message_bytes = reinterpret_cast<unsigned char*>(input.linearize(input.length()));
-    size_t protected_buffer_size = BUFFER_SIZE;
-    size_t processed_message_size = input.length();
-    tsi_result result =
-        tsi_frame_protector_protect(frame_protector_.get(), message_bytes, &processed_message_size,
-                                    protected_buffer, &protected_buffer_size);
-    if (result != TSI_OK) {
-      ASSERT(result != TSI_INVALID_ARGUMENT && result != TSI_UNIMPLEMENTED);
-      return result;
+    Buffer::RawSlice slice;
+    input.getRawSlices(&slice, 1);
+    const auto* message_bytes = static_cast<const unsigned char*>(slice.mem_);
+    size_t message_size = slice.len_;
+    while (message_size > 0) {
+      Buffer::RawSlice protected_slice;
+      output.reserve(BUFFER_SIZE, &protected_slice, 1);
+      size_t protected_buffer_size = protected_slice.len_;
+      size_t processed_message_size = message_size;
+      tsi_result result = tsi_frame_protector_protect(
+          frame_protector_.get(), message_bytes, &processed_message_size,
+          static_cast<unsigned char*>(protected_slice.mem_), &protected_buffer_size);
+      if (result != TSI_OK) {
+        ASSERT(result != TSI_INVALID_ARGUMENT && result != TSI_UNIMPLEMENTED);
+        input.drain(slice.len_ - message_size);
+        return result;
+      }
+      protected_slice.len_ = protected_buffer_size;
+      output.commit(&protected_slice, 1);
+      message_bytes += processed_message_size;
+      message_size -= processed_message_size;
     }
-    output.add(protected_buffer, protected_buffer_size);
-    input.drain(processed_message_size);
+    input.drain(slice.len_);
   }
 
-  // TSI may buffer some of the input internally. Flush its buffer to protected_buffer.
+  // TSI may buffer some of the input internally. Flush its buffer to the output.
   size_t still_pending_size;
   do {
-    size_t protected_buffer_size = BUFFER_SIZE;
+    Buffer::RawSlice protected_slice;
+    output.reserve(BUFFER_SIZE, &protected_slice, 1);
+    size_t protected_buffer_size = protected_slice.len_;
     tsi_result result = tsi_frame_protector_protect_flush(
-        frame_protector_.get(), protected_buffer, &protected_buffer_size, &still_pending_size);
+        frame_protector_.get(), static_cast<unsigned char*>(protected_slice.mem_),
+        &protected_buffer_size, &still_pending_size);
     if (result != TSI_OK) {
       ASSERT(result != TSI_INVALID_ARGUMENT && result != TSI_UNIMPLEMENTED);
       return result;
     }
-    output.add(protected_buffer, protected_buffer_size);
+    protected_slice.len_ = protected_buffer_size;
+    output.commit(&protected_slice, 1);
   } while (still_pending_size > 0);
 
   return TSI_OK;
@@ -51,21 +69,34 @@ tsi_result TsiFrameProtector::protect(Buffer::Instance& input, Buffer::Instance&
 tsi_result TsiFrameProtector::unprotect(Buffer::Instance& input, Buffer::Instance& output) {
   ASSERT(frame_protector_);
 
-  unsigned char unprotected_buffer[BUFFER_SIZE];
-
   while (input.length() > 0) {
-    auto* message_bytes = reinterpret_cast<unsigned char*>(input.linearize(input.length()));
-    size_t unprotected_buffer_size = BUFFER_SIZE;
-    size_t processed_message_size = input.length();
-    tsi_result result = tsi_frame_protector_unprotect(frame_protector_.get(), message_bytes,
-                                                      &processed_message_size, unprotected_buffer,
-                                                      &unprotected_buffer_size);
-    if (result != TSI_OK) {
-      ASSERT(result != TSI_INVALID_ARGUMENT && result != TSI_UNIMPLEMENTED);
-      return result;
-    }
-    output.add(unprotected_buffer, unprotected_buffer_size);
-    input.drain(processed_message_size);
+    Buffer::RawSlice slice;
+    input.getRawSlices(&slice, 1);
+    const auto* message_bytes = static_cast<const unsigned char*>(slice.mem_);
+    size_t message_size = slice.len_;
+    bool output_full;
+    // Once the slice is processed, keep on going while the output space was filled, as TSI may
+    // still hold unprotected data of the last frame.
+    do {
+      Buffer::RawSlice unprotected_slice;
+      output.reserve(BUFFER_SIZE, &unprotected_slice, 1);
+      size_t unprotected_buffer_size = unprotected_slice.len_;
+      size_t processed_message_size = message_size;
+      tsi_result result = tsi_frame_protector_unprotect(
+          frame_protector_.get(), message_bytes, &processed_message_size,
+          static_cast<unsigned char*>(unprotected_slice.mem_), &unprotected_buffer_size);
+      if (result != TSI_OK) {
+        ASSERT(result != TSI_INVALID_ARGUMENT && result != TSI_UNIMPLEMENTED);
+        input.drain(slice.len_ - message_size);
+        return result;
+      }
+      output_full = unprotected_buffer_size == unprotected_slice.len_;
+      unprotected_slice.len_ = unprotected_buffer_size;
+      output.commit(&unprotected_slice, 1);
+      message_bytes += processed_message_size;
+      message_size -= processed_message_size;
+    } while (message_size > 0 || output_full);
+    input.drain(slice.len_);
   }
 
   return TSI_OK;
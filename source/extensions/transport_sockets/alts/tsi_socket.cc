@@ -135,16 +135,24 @@ Network::PostIoAction TsiSocket::doHandshakeNextDone(NextResultPtr&& next_result
     return Network::PostIoAction::Close;
   }
 
-  if (raw_read_buffer_.length() > 0) {
-    callbacks_->setReadBufferReady();
-  }
-
   // Try to write raw buffer when next call is done, even this is not in do[Read|Write] stack.
+  Network::PostIoAction action = Network::PostIoAction::KeepOpen;
   if (raw_write_buffer_.length() > 0) {
-    return raw_buffer_socket_->doWrite(raw_write_buffer_, false).action_;
+    action = raw_buffer_socket_->doWrite(raw_write_buffer_, false).action_;
   }
 
-  return Network::PostIoAction::KeepOpen;
+  if (raw_read_buffer_.length() > 0) {
+    if (!handshake_complete_ && action == Network::PostIoAction::KeepOpen) {
+      // The peer sent more handshake data while the handshaker was busy. Hand it over right away
+      // rather than on the next read event, so that the next handshaker call is issued without a
+      // round trip through the dispatcher.
+      doHandshakeNext();
+    } else {
+      callbacks_->setReadBufferReady();
+    }
+  }
+
+  return action;
 }
 
 Network::IoResult TsiSocket::doRead(Buffer::Instance& buffer) {
@@ -59,6 +59,7 @@ public:
   std::string protocol() const override;
   bool canFlushClose() override { return handshake_complete_; }
   const Envoy::Ssl::Connection* ssl() const override { return nullptr; }
+  bool passthrough() const override { return false; }
   Network::IoResult doWrite(Buffer::Instance& buffer, bool end_stream) override;
   void closeSocket(Network::ConnectionEvent event) override;
   Network::IoResult doRead(Buffer::Instance& buffer) override;
@@ -1,21 +1,23 @@
 #include "extensions/transport_sockets/capture/capture.h"
 
-#include "common/buffer/buffer_impl.h"
+#include <algorithm>
+#include <limits>
+
 #include "common/common/assert.h"
 #include "common/common/fmt.h"
 #include "common/network/utility.h"
 #include "common/protobuf/protobuf.h"
+#include "common/protobuf/utility.h"
 
 namespace Envoy {
 namespace Extensions {
 namespace TransportSockets {
 namespace Capture {
 
-CaptureSocket::CaptureSocket(
-    const std::string& path_prefix,
-    envoy::config::transport_socket::capture::v2alpha::FileSink::Format format,
-    Network::TransportSocketPtr&& transport_socket)
-    : path_prefix_(path_prefix), format_(format), transport_socket_(std::move(transport_socket)) {}
+CaptureSocket::CaptureSocket(const CaptureConfig& config,
+                             Network::TransportSocketPtr&& transport_socket)
+    : config_(config), trace_(std::make_unique<envoy::data::tap::v2alpha::Trace>()),
+      transport_socket_(std::move(transport_socket)) {}
 
 void CaptureSocket::setTransportSocketCallbacks(Network::TransportSocketCallbacks& callbacks) {
   callbacks_ = &callbacks;
@@ -27,62 +29,41 @@ std::string CaptureSocket::protocol() const { return transport_socket_->protocol
 bool CaptureSocket::canFlushClose() { return transport_socket_->canFlushClose(); }
 
 void CaptureSocket::closeSocket(Network::ConnectionEvent event) {
-  // The caller should have invoked setTransportSocketCallbacks() prior to this.
-  ASSERT(callbacks_ != nullptr);
-  auto* connection = trace_.mutable_connection();
-  connection->set_id(callbacks_->connection().id());
-  Network::Utility::addressToProtobufAddress(*callbacks_->connection().localAddress(),
-                                             *connection->mutable_local_address());
-  Network::Utility::addressToProtobufAddress(*callbacks_->connection().remoteAddress(),
-                                             *connection->mutable_remote_address());
-  const bool text_format =
-      format_ == envoy::config::transport_socket::capture::v2alpha::FileSink::PROTO_TEXT;
-  const std::string path = fmt::format("{}_{}.{}", path_prefix_, callbacks_->connection().id(),
-                                       text_format ? "pb_text" : "pb");
-  ENVOY_LOG_MISC(debug, "Writing socket trace for [C{}] to {}", callbacks_->connection().id(),
-                 path);
-  ENVOY_LOG_MISC(trace, "Socket trace for [C{}]: {}", callbacks_->connection().id(),
-                 trace_.DebugString());
-  std::ofstream proto_stream(path);
-  if (text_format) {
-    proto_stream << trace_.DebugString();
-  } else {
-    trace_.SerializeToOstream(&proto_stream);
-  }
+  submitTrace(true);
   transport_socket_->closeSocket(event);
 }
 
 Network::IoResult CaptureSocket::doRead(Buffer::Instance& buffer) {
   Network::IoResult result = transport_socket_->doRead(buffer);
-  if (result.bytes_processed_ > 0) {
-    // TODO(htuch): avoid linearizing
-    char* data = static_cast<char*>(buffer.linearize(buffer.length())) +
-                 (buffer.length() - result.bytes_processed_);
-    auto* event = trace_.add_events();
-    event->mutable_timestamp()->MergeFrom(Protobuf::util::TimeUtil::NanosecondsToTimestamp(
-        std::chrono::duration_cast<std::chrono::nanoseconds>(
-            std::chrono::system_clock::now().time_since_epoch())
-            .count()));
-    event->mutable_read()->set_data(data, result.bytes_processed_);
+  if (result.bytes_processed_ > 0 && !truncated_) {
+    const uint64_t length = captureLength(result.bytes_processed_);
+    auto* read = addEvent(length).mutable_read();
+    // The data read was appended to the buffer, and is copied without linearizing it.
+    std::string* data = read->mutable_data();
+    data->resize(length);
+    buffer.copyOut(buffer.length() - result.bytes_processed_, length, &(*data)[0]);
+    read->set_truncated(truncated_);
+    maybeStreamTrace();
   }
-
   return result;
 }
 
 Network::IoResult CaptureSocket::doWrite(Buffer::Instance& buffer, bool end_stream) {
-  // TODO(htuch): avoid copy.
-  Buffer::OwnedImpl copy(buffer);
+  // The written data is drained from the buffer, so the part of it which can be captured is copied
+  // beforehand.
+  std::string data;
+  if (!truncated_) {
+    data.resize(std::min(buffer.length(), remainingLength()));
+    buffer.copyOut(0, data.size(), &data[0]);
+  }
   Network::IoResult result = transport_socket_->doWrite(buffer, end_stream);
-  if (result.bytes_processed_ > 0) {
-    // TODO(htuch): avoid linearizing.
-    char* data = static_cast<char*>(copy.linearize(result.bytes_processed_));
-    auto* event = trace_.add_events();
-    event->mutable_timestamp()->MergeFrom(Protobuf::util::TimeUtil::NanosecondsToTimestamp(
-        std::chrono::duration_cast<std::chrono::nanoseconds>(
-            std::chrono::system_clock::now().time_since_epoch())
-            .count()));
-    event->mutable_write()->set_data(data, result.bytes_processed_);
-    event->mutable_write()->set_end_stream(end_stream);
+  if (result.bytes_processed_ > 0 && !truncated_) {
+    data.resize(captureLength(result.bytes_processed_));
+    auto* write = addEvent(data.size()).mutable_write();
+    write->set_data(std::move(data));
+    write->set_end_stream(end_stream);
+    write->set_truncated(truncated_);
+    maybeStreamTrace();
   }
   return result;
 }
@@ -91,15 +72,89 @@ void CaptureSocket::onConnected() { transport_socket_->onConnected(); }
 
 const Ssl::Connection* CaptureSocket::ssl() const { return transport_socket_->ssl(); }
 
+uint64_t CaptureSocket::remainingLength() const {
+  return config_.max_bytes_per_connection_ == 0
+             ? std::numeric_limits<uint64_t>::max()
+             : config_.max_bytes_per_connection_ - captured_bytes_;
+}
+
+uint64_t CaptureSocket::captureLength(uint64_t length) {
+  const uint64_t remaining = remainingLength();
+  if (length > remaining) {
+    truncated_ = true;
+    config_.stats_.truncated_.inc();
+    return remaining;
+  }
+  return length;
+}
+
+envoy::data::tap::v2alpha::Event& CaptureSocket::addEvent(uint64_t length) {
+  trace_bytes_ += length;
+  captured_bytes_ += length;
+  auto* event = trace_->add_events();
+  event->mutable_timestamp()->MergeFrom(Protobuf::util::TimeUtil::NanosecondsToTimestamp(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count()));
+  return *event;
+}
+
+void CaptureSocket::maybeStreamTrace() {
+  if (trace_bytes_ >= STREAMED_TRACE_BYTES &&
+      config_.format_ == envoy::config::transport_socket::capture::v2alpha::FileSink::
+                             PROTO_BINARY_LENGTH_DELIMITED) {
+    submitTrace(false);
+  }
+}
+
+void CaptureSocket::submitTrace(bool last) {
+  // The caller should have invoked setTransportSocketCallbacks() prior to this.
+  ASSERT(callbacks_ != nullptr);
+  auto* connection = trace_->mutable_connection();
+  connection->set_id(callbacks_->connection().id());
+  Network::Utility::addressToProtobufAddress(*callbacks_->connection().localAddress(),
+                                             *connection->mutable_local_address());
+  Network::Utility::addressToProtobufAddress(*callbacks_->connection().remoteAddress(),
+                                             *connection->mutable_remote_address());
+
+  std::string extension;
+  switch (config_.format_) {
+  case envoy::config::transport_socket::capture::v2alpha::FileSink::PROTO_TEXT:
+    extension = "pb_text";
+    break;
+  case envoy::config::transport_socket::capture::v2alpha::FileSink::PROTO_BINARY_LENGTH_DELIMITED:
+    extension = "pb_length";
+    break;
+  default:
+    extension = "pb";
+    break;
+  }
+  config_.writer_->write(
+      fmt::format("{}_{}.{}", config_.path_prefix_, callbacks_->connection().id(), extension),
+      config_.format_, std::move(trace_), trace_bytes_, last);
+  trace_ = std::make_unique<envoy::data::tap::v2alpha::Trace>();
+  trace_bytes_ = 0;
+}
+
 CaptureSocketFactory::CaptureSocketFactory(
-    const std::string& path_prefix,
-    envoy::config::transport_socket::capture::v2alpha::FileSink::Format format,
-    Network::TransportSocketFactoryPtr&& transport_socket_factory)
-    : path_prefix_(path_prefix), format_(format),
-      transport_socket_factory_(std::move(transport_socket_factory)) {}
+    const envoy::config::transport_socket::capture::v2alpha::Capture& config, Stats::Scope& scope,
+    Runtime::RandomGenerator& random, Network::TransportSocketFactoryPtr&& transport_socket_factory)
+    : config_(createConfig(config, scope)),
+      sampling_numerator_(config.has_sampling() ? config.sampling().numerator() : 1),
+      sampling_denominator_(
+          config.has_sampling()
+              ? ProtobufPercentHelper::fractionalPercentDenominatorToInt(config.sampling())
+              : 1),
+      random_(random), transport_socket_factory_(std::move(transport_socket_factory)) {}
 
 Network::TransportSocketPtr CaptureSocketFactory::createTransportSocket() const {
-  return std::make_unique<CaptureSocket>(path_prefix_, format_,
+  if (sampling_numerator_ < sampling_denominator_ &&
+      random_.random() % sampling_denominator_ >= sampling_numerator_) {
+    config_.stats_.not_sampled_.inc();
+    return transport_socket_factory_->createTransportSocket();
+  }
+  config_.stats_.sampled_.inc();
+  return std::make_unique<CaptureSocket>(config_,
                                          transport_socket_factory_->createTransportSocket());
 }
 
@@ -107,6 +162,19 @@ bool CaptureSocketFactory::implementsSecureTransport() const {
   return transport_socket_factory_->implementsSecureTransport();
 }
 
+CaptureConfig CaptureSocketFactory::createConfig(
+    const envoy::config::transport_socket::capture::v2alpha::Capture& config,
+    Stats::Scope& scope) {
+  CaptureStats stats{ALL_CAPTURE_STATS(POOL_COUNTER_PREFIX(scope, "capture."))};
+  return CaptureConfig{
+      config.file_sink().path_prefix(), config.file_sink().format(),
+      config.max_bytes_per_connection(), stats,
+      std::make_shared<CaptureWriter>(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.file_sink(),
+                                                                      max_pending_bytes,
+                                                                      DEFAULT_MAX_PENDING_BYTES),
+                                      stats)};
+}
+
 } // namespace Capture
 } // namespace TransportSockets
 } // namespace Extensions
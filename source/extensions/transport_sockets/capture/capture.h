@@ -1,21 +1,36 @@
 #pragma once
 
-#include <fstream>
+#include <memory>
+#include <string>
 
 #include "envoy/config/transport_socket/capture/v2alpha/capture.pb.h"
 #include "envoy/data/tap/v2alpha/capture.pb.h"
 #include "envoy/network/transport_socket.h"
+#include "envoy/runtime/runtime.h"
+#include "envoy/stats/scope.h"
+
+#include "extensions/transport_sockets/capture/capture_writer.h"
 
 namespace Envoy {
 namespace Extensions {
 namespace TransportSockets {
 namespace Capture {
 
+/**
+ * Configuration shared by the capture sockets of a factory.
+ */
+struct CaptureConfig {
+  const std::string path_prefix_;
+  const envoy::config::transport_socket::capture::v2alpha::FileSink::Format format_;
+  // Zero means no limit.
+  const uint64_t max_bytes_per_connection_;
+  CaptureStats stats_;
+  const CaptureWriterSharedPtr writer_;
+};
+
 class CaptureSocket : public Network::TransportSocket {
 public:
-  CaptureSocket(const std::string& path_prefix,
-                envoy::config::transport_socket::capture::v2alpha::FileSink::Format format,
-                Network::TransportSocketPtr&& transport_socket);
+  CaptureSocket(const CaptureConfig& config, Network::TransportSocketPtr&& transport_socket);
 
   // Network::TransportSocket
   void setTransportSocketCallbacks(Network::TransportSocketCallbacks& callbacks) override;
@@ -26,32 +41,58 @@ public:
   Network::IoResult doWrite(Buffer::Instance& buffer, bool end_stream) override;
   void onConnected() override;
   const Ssl::Connection* ssl() const override;
+  // Data moved around the socket would not be captured.
+  bool passthrough() const override { return false; }
+
+  // With the PROTO_BINARY_LENGTH_DELIMITED format, the trace is handed to the writer each time it
+  // holds this many bytes of data.
+  static constexpr uint64_t STREAMED_TRACE_BYTES = 64 * 1024;
 
 private:
-  const std::string& path_prefix_;
-  const envoy::config::transport_socket::capture::v2alpha::FileSink::Format format_;
-  // TODO(htuch): Buffering the entire trace until socket close won't scale to
-  // long lived connections or large transfers. We could emit multiple capture
-  // files with bounded size, with identical connection ID to allow later
-  // reassembly.
-  envoy::data::tap::v2alpha::Trace trace_;
+  // Returns the number of bytes of data which can still be captured.
+  uint64_t remainingLength() const;
+  // Returns the number of bytes of data which are captured out of length, the rest being
+  // truncated.
+  uint64_t captureLength(uint64_t length);
+  envoy::data::tap::v2alpha::Event& addEvent(uint64_t length);
+  // Hands the trace to the writer once it holds enough data, when it is streamed.
+  void maybeStreamTrace();
+  // Hands the trace to the writer.
+  void submitTrace(bool last);
+
+  const CaptureConfig& config_;
+  TracePtr trace_;
+  // The bytes of data held by trace_, and captured in total.
+  uint64_t trace_bytes_{};
+  uint64_t captured_bytes_{};
+  bool truncated_{};
   Network::TransportSocketPtr transport_socket_;
   Network::TransportSocketCallbacks* callbacks_{};
 };
 
 class CaptureSocketFactory : public Network::TransportSocketFactory {
 public:
-  CaptureSocketFactory(const std::string& path_prefix,
-                       envoy::config::transport_socket::capture::v2alpha::FileSink::Format format,
+  CaptureSocketFactory(const envoy::config::transport_socket::capture::v2alpha::Capture& config,
+                       Stats::Scope& scope, Runtime::RandomGenerator& random,
                        Network::TransportSocketFactoryPtr&& transport_socket_factory);
 
   // Network::TransportSocketFactory
   Network::TransportSocketPtr createTransportSocket() const override;
   bool implementsSecureTransport() const override;
 
+  // The default of FileSink.max_pending_bytes.
+  static constexpr uint64_t DEFAULT_MAX_PENDING_BYTES = 16 * 1024 * 1024;
+
 private:
-  const std::string path_prefix_;
-  const envoy::config::transport_socket::capture::v2alpha::FileSink::Format format_;
+  static CaptureConfig
+  createConfig(const envoy::config::transport_socket::capture::v2alpha::Capture& config,
+               Stats::Scope& scope);
+
+  const CaptureConfig config_;
+  // A socket is captured when a random number modulo the denominator is below the numerator.
+  const uint64_t sampling_numerator_;
+  const uint64_t sampling_denominator_;
+  Runtime::RandomGenerator& random_;
   Network::TransportSocketFactoryPtr transport_socket_factory_;
 };
 
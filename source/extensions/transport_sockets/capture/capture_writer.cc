@@ -0,0 +1,119 @@
+#include "extensions/transport_sockets/capture/capture_writer.h"
+
+#include <cstdio>
+
+#include "common/common/assert.h"
+#include "common/common/lock_guard.h"
+#include "common/common/logger.h"
+#include "common/protobuf/protobuf.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Capture {
+
+CaptureWriter::CaptureWriter(uint64_t max_pending_bytes, const CaptureStats& stats)
+    : max_pending_bytes_(max_pending_bytes), stats_(stats),
+      thread_(new Thread::Thread([this]() -> void { writeThreadFunc(); })) {}
+
+CaptureWriter::~CaptureWriter() {
+  {
+    Thread::LockGuard lock(lock_);
+    exit_ = true;
+    write_event_.notifyOne();
+  }
+  thread_->join();
+}
+
+bool CaptureWriter::write(
+    const std::string& path,
+    envoy::config::transport_socket::capture::v2alpha::FileSink::Format format, TracePtr&& trace,
+    uint64_t size, bool last) {
+  Thread::LockGuard lock(lock_);
+  if (pending_bytes_ + size > max_pending_bytes_) {
+    stats_.traces_dropped_.inc();
+    return false;
+  }
+  pending_.push_back({path, format, std::move(trace), size, last});
+  pending_traces_++;
+  pending_bytes_ += size;
+  write_event_.notifyOne();
+  return true;
+}
+
+void CaptureWriter::flush() {
+  Thread::LockGuard lock(lock_);
+  while (pending_traces_ > 0) {
+    // CondVar::wait() does not throw, so it's safe to pass the mutex rather than the guard.
+    written_event_.wait(lock_);
+  }
+}
+
+void CaptureWriter::writeThreadFunc() {
+  while (true) {
+    PendingTrace pending;
+    {
+      Thread::LockGuard lock(lock_);
+      while (pending_.empty() && !exit_) {
+        // CondVar::wait() does not throw, so it's safe to pass the mutex rather than the guard.
+        write_event_.wait(lock_);
+      }
+      // The traces queued before exiting are still written.
+      if (pending_.empty()) {
+        return;
+      }
+      pending = std::move(pending_.front());
+      pending_.pop_front();
+    }
+
+    doWrite(pending);
+
+    {
+      Thread::LockGuard lock(lock_);
+      pending_traces_--;
+      pending_bytes_ -= pending.size_;
+      written_event_.notifyAll();
+    }
+  }
+}
+
+void CaptureWriter::doWrite(PendingTrace& pending) {
+  ENVOY_LOG_MISC(debug, "Writing socket trace for [C{}] to {}", pending.trace_->connection().id(),
+                 pending.path_);
+  ENVOY_LOG_MISC(trace, "Socket trace for [C{}]: {}", pending.trace_->connection().id(),
+                 pending.trace_->DebugString());
+
+  if (pending.format_ ==
+      envoy::config::transport_socket::capture::v2alpha::FileSink::PROTO_BINARY_LENGTH_DELIMITED) {
+    auto& stream = streams_[pending.path_];
+    if (stream == nullptr) {
+      stream = std::make_unique<std::ofstream>(pending.path_, std::ios::binary | std::ios::app);
+    }
+    ProtobufUtil::SerializeDelimitedToOstream(*pending.trace_, stream.get());
+    stream->flush();
+    if (pending.last_) {
+      streams_.erase(pending.path_);
+    }
+  } else {
+    // The trace is written to a temporary file which is then renamed, so that the file is never
+    // seen partially written.
+    ASSERT(pending.last_);
+    const std::string temporary_path = pending.path_ + ".tmp";
+    {
+      std::ofstream proto_stream(temporary_path, std::ios::binary);
+      if (pending.format_ ==
+          envoy::config::transport_socket::capture::v2alpha::FileSink::PROTO_TEXT) {
+        proto_stream << pending.trace_->DebugString();
+      } else {
+        pending.trace_->SerializeToOstream(&proto_stream);
+      }
+    }
+    ::rename(temporary_path.c_str(), pending.path_.c_str());
+  }
+  stats_.traces_written_.inc();
+}
+
+} // namespace Capture
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "envoy/config/transport_socket/capture/v2alpha/capture.pb.h"
+#include "envoy/data/tap/v2alpha/capture.pb.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "common/common/thread.h"
+#include "common/common/thread_annotations.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Capture {
+
+/**
+ * All capture transport socket stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_CAPTURE_STATS(COUNTER)                                                                 \
+  COUNTER(sampled)                                                                                 \
+  COUNTER(not_sampled)                                                                             \
+  COUNTER(truncated)                                                                               \
+  COUNTER(traces_written)                                                                          \
+  COUNTER(traces_dropped)
+// clang-format on
+
+/**
+ * Struct definition for all capture transport socket stats. @see stats_macros.h
+ */
+struct CaptureStats {
+  ALL_CAPTURE_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+typedef std::unique_ptr<envoy::data::tap::v2alpha::Trace> TracePtr;
+
+/**
+ * Writes the capture traces of sockets to files from a background thread, so that serializing and
+ * writing them doesn't block the workers. Traces wait to be written in a queue bounded in bytes,
+ * and the ones which don't fit are dropped.
+ */
+class CaptureWriter {
+public:
+  CaptureWriter(uint64_t max_pending_bytes, const CaptureStats& stats);
+  ~CaptureWriter();
+
+  /**
+   * Queues a trace to be written.
+   * @param path supplies the path of the file. With the PROTO_BINARY_LENGTH_DELIMITED format, the
+   *        traces written to a path are appended to it until the last one.
+   * @param format supplies the format of the file.
+   * @param trace supplies the trace.
+   * @param size supplies the number of bytes of data held by the trace.
+   * @param last supplies whether this is the last trace of the file.
+   * @return bool whether the trace was queued rather than dropped.
+   */
+  bool write(const std::string& path,
+             envoy::config::transport_socket::capture::v2alpha::FileSink::Format format,
+             TracePtr&& trace, uint64_t size, bool last);
+
+  /**
+   * Blocks until the traces queued so far are written.
+   */
+  void flush();
+
+private:
+  struct PendingTrace {
+    std::string path_;
+    envoy::config::transport_socket::capture::v2alpha::FileSink::Format format_;
+    TracePtr trace_;
+    uint64_t size_;
+    bool last_;
+  };
+
+  void writeThreadFunc();
+  void doWrite(PendingTrace& pending);
+
+  const uint64_t max_pending_bytes_;
+  CaptureStats stats_;
+  Thread::MutexBasicLockable lock_;
+  Thread::CondVar write_event_;
+  Thread::CondVar written_event_;
+  std::deque<PendingTrace> pending_ GUARDED_BY(lock_);
+  // The number and the bytes of the traces queued or being written.
+  uint64_t pending_traces_ GUARDED_BY(lock_){};
+  uint64_t pending_bytes_ GUARDED_BY(lock_){};
+  bool exit_ GUARDED_BY(lock_){};
+  // The streams of the files written in the PROTO_BINARY_LENGTH_DELIMITED format, which are kept
+  // open until their last trace. Only used by the writer thread.
+  std::unordered_map<std::string, std::unique_ptr<std::ofstream>> streams_;
+  Thread::ThreadPtr thread_;
+};
+
+typedef std::shared_ptr<CaptureWriter> CaptureWriterSharedPtr;
+
+} // namespace Capture
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
@@ -26,9 +26,8 @@ Network::TransportSocketFactoryPtr UpstreamCaptureSocketConfigFactory::createTra
       outer_config.transport_socket(), inner_config_factory);
   auto inner_transport_factory =
       inner_config_factory.createTransportSocketFactory(*inner_factory_config, context);
-  return std::make_unique<CaptureSocketFactory>(outer_config.file_sink().path_prefix(),
-                                                outer_config.file_sink().format(),
-                                                std::move(inner_transport_factory));
+  return std::make_unique<CaptureSocketFactory>(
+      outer_config, context.statsScope(), context.random(), std::move(inner_transport_factory));
 }
 
 Network::TransportSocketFactoryPtr
@@ -44,9 +43,8 @@ DownstreamCaptureSocketConfigFactory::createTransportSocketFactory(
       outer_config.transport_socket(), inner_config_factory);
   auto inner_transport_factory = inner_config_factory.createTransportSocketFactory(
       *inner_factory_config, context, server_names);
-  return std::make_unique<CaptureSocketFactory>(outer_config.file_sink().path_prefix(),
-                                                outer_config.file_sink().format(),
-                                                std::move(inner_transport_factory));
+  return std::make_unique<CaptureSocketFactory>(
+      outer_config, context.statsScope(), context.random(), std::move(inner_transport_factory));
 }
 
 ProtobufTypes::MessagePtr CaptureSocketConfigFactory::createEmptyConfigProto() {
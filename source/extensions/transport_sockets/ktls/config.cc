@@ -0,0 +1,79 @@
+#include "extensions/transport_sockets/ktls/config.h"
+
+#include "envoy/config/transport_socket/ktls/v2alpha/ktls.pb.h"
+#include "envoy/config/transport_socket/ktls/v2alpha/ktls.pb.validate.h"
+#include "envoy/registry/registry.h"
+
+#include "common/common/fmt.h"
+#include "common/config/utility.h"
+#include "common/protobuf/utility.h"
+
+#include "extensions/transport_sockets/ktls/ktls.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Ktls {
+
+namespace {
+
+void validateTransportSocketName(const std::string& name) {
+  if (name != TransportSocketNames::get().Tls) {
+    throw EnvoyException(
+        fmt::format("kTLS transport socket must wrap a '{}' transport socket, not '{}'",
+                    TransportSocketNames::get().Tls, name));
+  }
+}
+
+} // namespace
+
+Network::TransportSocketFactoryPtr UpstreamKtlsSocketConfigFactory::createTransportSocketFactory(
+    const Protobuf::Message& message,
+    Server::Configuration::TransportSocketFactoryContext& context) {
+  const auto& outer_config = MessageUtil::downcastAndValidate<
+      const envoy::config::transport_socket::ktls::v2alpha::Ktls&>(message);
+  validateTransportSocketName(outer_config.transport_socket().name());
+  auto& inner_config_factory = Config::Utility::getAndCheckFactory<
+      Server::Configuration::UpstreamTransportSocketConfigFactory>(
+      outer_config.transport_socket().name());
+  ProtobufTypes::MessagePtr inner_factory_config = Config::Utility::translateToFactoryConfig(
+      outer_config.transport_socket(), inner_config_factory);
+  auto inner_transport_factory =
+      inner_config_factory.createTransportSocketFactory(*inner_factory_config, context);
+  return std::make_unique<KtlsSocketFactory>(std::move(inner_transport_factory),
+                                             context.statsScope());
+}
+
+Network::TransportSocketFactoryPtr DownstreamKtlsSocketConfigFactory::createTransportSocketFactory(
+    const Protobuf::Message& message, Server::Configuration::TransportSocketFactoryContext& context,
+    const std::vector<std::string>& server_names) {
+  const auto& outer_config = MessageUtil::downcastAndValidate<
+      const envoy::config::transport_socket::ktls::v2alpha::Ktls&>(message);
+  validateTransportSocketName(outer_config.transport_socket().name());
+  auto& inner_config_factory = Config::Utility::getAndCheckFactory<
+      Server::Configuration::DownstreamTransportSocketConfigFactory>(
+      outer_config.transport_socket().name());
+  ProtobufTypes::MessagePtr inner_factory_config = Config::Utility::translateToFactoryConfig(
+      outer_config.transport_socket(), inner_config_factory);
+  auto inner_transport_factory = inner_config_factory.createTransportSocketFactory(
+      *inner_factory_config, context, server_names);
+  return std::make_unique<KtlsSocketFactory>(std::move(inner_transport_factory),
+                                             context.statsScope());
+}
+
+ProtobufTypes::MessagePtr KtlsSocketConfigFactory::createEmptyConfigProto() {
+  return std::make_unique<envoy::config::transport_socket::ktls::v2alpha::Ktls>();
+}
+
+static Registry::RegisterFactory<UpstreamKtlsSocketConfigFactory,
+                                 Server::Configuration::UpstreamTransportSocketConfigFactory>
+    upstream_registered_;
+
+static Registry::RegisterFactory<DownstreamKtlsSocketConfigFactory,
+                                 Server::Configuration::DownstreamTransportSocketConfigFactory>
+    downstream_registered_;
+
+} // namespace Ktls
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
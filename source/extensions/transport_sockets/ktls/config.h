@@ -0,0 +1,45 @@
+#pragma once
+
+#include "envoy/server/transport_socket_config.h"
+
+#include "extensions/transport_sockets/well_known_names.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Ktls {
+
+/**
+ * Config registration for the kTLS wrapper for the TLS transport socket factory.
+ * @see TransportSocketConfigFactory.
+ */
+class KtlsSocketConfigFactory : public virtual Server::Configuration::TransportSocketConfigFactory {
+public:
+  virtual ~KtlsSocketConfigFactory() {}
+  std::string name() const override { return TransportSocketNames::get().Ktls; }
+  ProtobufTypes::MessagePtr createEmptyConfigProto() override;
+};
+
+class UpstreamKtlsSocketConfigFactory
+    : public Server::Configuration::UpstreamTransportSocketConfigFactory,
+      public KtlsSocketConfigFactory {
+public:
+  Network::TransportSocketFactoryPtr createTransportSocketFactory(
+      const Protobuf::Message& config,
+      Server::Configuration::TransportSocketFactoryContext& context) override;
+};
+
+class DownstreamKtlsSocketConfigFactory
+    : public Server::Configuration::DownstreamTransportSocketConfigFactory,
+      public KtlsSocketConfigFactory {
+public:
+  Network::TransportSocketFactoryPtr
+  createTransportSocketFactory(const Protobuf::Message& config,
+                               Server::Configuration::TransportSocketFactoryContext& context,
+                               const std::vector<std::string>& server_names) override;
+};
+
+} // namespace Ktls
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,338 @@
+#include "extensions/transport_sockets/ktls/ktls.h"
+
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include "envoy/api/os_sys_calls.h"
+
+#include "common/api/os_sys_calls_impl.h"
+#include "common/common/assert.h"
+
+#include "openssl/ssl.h"
+
+#if defined(__linux__) && __has_include(<linux/tls.h>)
+#include <linux/tls.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#endif
+
+// The receive option and its control messages need the 4.17 uapi header.
+#if defined(TLS_RX) && defined(TLS_SET_RECORD_TYPE)
+#define ENVOY_KTLS_SUPPORTED 1
+#endif
+
+#ifdef ENVOY_KTLS_SUPPORTED
+// Older libc headers lack these.
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+#endif
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Ktls {
+
+namespace {
+
+#ifdef ENVOY_KTLS_SUPPORTED
+
+// Length of the implicit part of the AES-GCM nonce of TLS 1.2 records.
+constexpr size_t FixedIvLength = 4;
+// TLS content type of alerts.
+constexpr uint8_t AlertRecordType = 21;
+
+void writeSequence(uint64_t sequence, unsigned char* out) {
+  for (int i = 7; i >= 0; i--) {
+    out[i] = sequence & 0xff;
+    sequence >>= 8;
+  }
+}
+
+/**
+ * Fill in the kTLS parameters of one direction of a TLS 1.2 AES-GCM connection. The explicit part
+ * of the nonce of each record is its sequence number, as chosen by BoringSSL.
+ */
+template <class CryptoInfo>
+CryptoInfo cryptoInfo(uint16_t cipher_type, const uint8_t* key, const uint8_t* fixed_iv,
+                      uint64_t sequence) {
+  CryptoInfo info;
+  memset(&info, 0, sizeof(info));
+  info.info.version = TLS_1_2_VERSION;
+  info.info.cipher_type = cipher_type;
+  memcpy(info.key, key, sizeof(info.key));
+  memcpy(info.salt, fixed_iv, sizeof(info.salt));
+  writeSequence(sequence, info.iv);
+  writeSequence(sequence, info.rec_seq);
+  return info;
+}
+
+template <class CryptoInfo>
+bool installKeys(int fd, SSL* ssl, uint16_t cipher_type, const std::vector<uint8_t>& key_block) {
+  const size_t key_length = sizeof(CryptoInfo::key);
+  // The key block holds the client and server write keys, followed by their fixed IVs. The MAC
+  // keys of AEAD ciphers are empty.
+  if (key_block.size() != 2 * (key_length + FixedIvLength)) {
+    return false;
+  }
+  const uint8_t* client_key = key_block.data();
+  const uint8_t* server_key = client_key + key_length;
+  const uint8_t* client_iv = server_key + key_length;
+  const uint8_t* server_iv = client_iv + FixedIvLength;
+  const bool is_server = SSL_is_server(ssl);
+
+  auto& os_syscalls = Api::OsSysCallsSingleton::get();
+  const CryptoInfo rx_info =
+      cryptoInfo<CryptoInfo>(cipher_type, is_server ? client_key : server_key,
+                             is_server ? client_iv : server_iv, SSL_get_read_sequence(ssl));
+  if (os_syscalls.setsockopt(fd, SOL_TLS, TLS_RX, &rx_info, sizeof(rx_info)).rc_ != 0) {
+    return false;
+  }
+  const CryptoInfo tx_info =
+      cryptoInfo<CryptoInfo>(cipher_type, is_server ? server_key : client_key,
+                             is_server ? server_iv : client_iv, SSL_get_write_sequence(ssl));
+  // The receive option is newer than the transmit one, so this only fails if the connection is
+  // broken, in which case the next I/O fails.
+  return os_syscalls.setsockopt(fd, SOL_TLS, TLS_TX, &tx_info, sizeof(tx_info)).rc_ == 0;
+}
+
+#endif
+
+} // namespace
+
+KtlsSocket::KtlsSocket(Network::TransportSocketPtr&& transport_socket, const KtlsStats& stats)
+    : transport_socket_(std::move(transport_socket)),
+      ssl_socket_(dynamic_cast<Ssl::SslSocket*>(transport_socket_.get())), stats_(stats),
+      state_(ssl_socket_ != nullptr && isSupported() ? State::Handshaking : State::NotOffloaded) {}
+
+bool KtlsSocket::isSupported() {
+#ifdef ENVOY_KTLS_SUPPORTED
+  return true;
+#else
+  return false;
+#endif
+}
+
+void KtlsSocket::setTransportSocketCallbacks(Network::TransportSocketCallbacks& callbacks) {
+  callbacks_ = &callbacks;
+  transport_socket_->setTransportSocketCallbacks(callbacks);
+}
+
+std::string KtlsSocket::protocol() const { return transport_socket_->protocol(); }
+
+bool KtlsSocket::canFlushClose() { return transport_socket_->canFlushClose(); }
+
+void KtlsSocket::closeSocket(Network::ConnectionEvent event) {
+  if (state_ == State::Offloaded) {
+    sendCloseNotify();
+    return;
+  }
+  transport_socket_->closeSocket(event);
+}
+
+Network::IoResult KtlsSocket::doRead(Buffer::Instance& buffer) {
+  if (state_ == State::Offloaded) {
+    return doOffloadedRead(buffer);
+  }
+  Network::IoResult result = transport_socket_->doRead(buffer);
+  if (result.action_ == Network::PostIoAction::KeepOpen && !result.end_stream_read_) {
+    maybeOffload();
+  }
+  return result;
+}
+
+Network::IoResult KtlsSocket::doWrite(Buffer::Instance& buffer, bool end_stream) {
+  if (state_ == State::Offloaded) {
+    return doOffloadedWrite(buffer, end_stream);
+  }
+  Network::IoResult result = transport_socket_->doWrite(buffer, end_stream);
+  if (result.action_ == Network::PostIoAction::KeepOpen) {
+    maybeOffload();
+  }
+  return result;
+}
+
+void KtlsSocket::onConnected() { transport_socket_->onConnected(); }
+
+const Ssl::Connection* KtlsSocket::ssl() const { return transport_socket_->ssl(); }
+
+void KtlsSocket::maybeOffload() {
+  if (state_ != State::Handshaking || !ssl_socket_->handshakeComplete() ||
+      ssl_socket_->hasPendingOutput()) {
+    return;
+  }
+
+  SSL* ssl = ssl_socket_->rawSsl();
+  if (SSL_pending(ssl) > 0 || SSL_has_pending(ssl)) {
+    // Records were read from the socket but not consumed yet, so the read sequence number of SSL
+    // is ahead of the socket. Retry after the next read.
+    return;
+  }
+
+  if (SSL_get_shutdown(ssl) == 0 && offload(ssl)) {
+    ENVOY_CONN_LOG(debug, "TLS keys offloaded to the kernel", callbacks_->connection());
+    state_ = State::Offloaded;
+    stats_.offloaded_.inc();
+  } else {
+    ENVOY_CONN_LOG(debug, "TLS keys not offloaded to the kernel", callbacks_->connection());
+    state_ = State::NotOffloaded;
+    stats_.not_offloaded_.inc();
+  }
+}
+
+bool KtlsSocket::offload(SSL* ssl) {
+#ifdef ENVOY_KTLS_SUPPORTED
+  if (SSL_version(ssl) != TLS1_2_VERSION) {
+    return false;
+  }
+  const int cipher_nid = SSL_CIPHER_get_cipher_nid(SSL_get_current_cipher(ssl));
+  if (cipher_nid != NID_aes_128_gcm && cipher_nid != NID_aes_256_gcm) {
+    return false;
+  }
+#ifndef TLS_CIPHER_AES_GCM_256
+  if (cipher_nid == NID_aes_256_gcm) {
+    return false;
+  }
+#endif
+
+  std::vector<uint8_t> key_block(SSL_get_key_block_len(ssl));
+  if (!SSL_generate_key_block(ssl, key_block.data(), key_block.size())) {
+    return false;
+  }
+
+  const int fd = callbacks_->fd();
+  static const char ulp_name[] = "tls";
+  if (Api::OsSysCallsSingleton::get()
+          .setsockopt(fd, SOL_TCP, TCP_ULP, ulp_name, sizeof(ulp_name))
+          .rc_ != 0) {
+    // The tls module is not available. The socket is unchanged.
+    return false;
+  }
+
+  // Until keys are installed, the tls upper layer protocol passes data through unchanged, so the
+  // wrapped socket can carry on if the kernel lacks the receive option.
+  bool installed;
+  if (cipher_nid == NID_aes_128_gcm) {
+    installed = installKeys<tls12_crypto_info_aes_gcm_128>(fd, ssl, TLS_CIPHER_AES_GCM_128,
+                                                           key_block);
+  } else {
+#ifdef TLS_CIPHER_AES_GCM_256
+    installed = installKeys<tls12_crypto_info_aes_gcm_256>(fd, ssl, TLS_CIPHER_AES_GCM_256,
+                                                           key_block);
+#else
+    NOT_REACHED_GCOVR_EXCL_LINE;
+#endif
+  }
+  OPENSSL_cleanse(key_block.data(), key_block.size());
+  return installed;
+#else
+  UNREFERENCED_PARAMETER(ssl);
+  return false;
+#endif
+}
+
+Network::IoResult KtlsSocket::doOffloadedRead(Buffer::Instance& buffer) {
+  Network::PostIoAction action = Network::PostIoAction::KeepOpen;
+  uint64_t bytes_read = 0;
+  bool end_stream = false;
+  do {
+    Api::SysCallIntResult result = buffer.read(callbacks_->fd(), 16384);
+    ENVOY_CONN_LOG(trace, "ktls read returns: {}", callbacks_->connection(), result.rc_);
+
+    if (result.rc_ == 0) {
+      // Remote close.
+      end_stream = true;
+      break;
+    } else if (result.rc_ == -1) {
+      ENVOY_CONN_LOG(trace, "ktls read error: {}", callbacks_->connection(), result.errno_);
+      if (result.errno_ == EIO) {
+        // The kernel only hands application data to read(). Any other record, normally the
+        // close_notify alert, ends the stream.
+        end_stream = true;
+      } else if (result.errno_ != EAGAIN) {
+        action = Network::PostIoAction::Close;
+      }
+      break;
+    } else {
+      bytes_read += result.rc_;
+      if (callbacks_->shouldDrainReadBuffer()) {
+        callbacks_->setReadBufferReady();
+        break;
+      }
+    }
+  } while (true);
+
+  return {action, bytes_read, end_stream};
+}
+
+Network::IoResult KtlsSocket::doOffloadedWrite(Buffer::Instance& buffer, bool end_stream) {
+  ASSERT(!close_notify_sent_ || buffer.length() == 0);
+  uint64_t bytes_written = 0;
+  while (buffer.length() > 0) {
+    Api::SysCallIntResult result = buffer.write(callbacks_->fd());
+    ENVOY_CONN_LOG(trace, "ktls write returns: {}", callbacks_->connection(), result.rc_);
+    if (result.rc_ == -1) {
+      ENVOY_CONN_LOG(trace, "ktls write error: {} ({})", callbacks_->connection(), result.errno_,
+                     strerror(result.errno_));
+      return {result.errno_ == EAGAIN ? Network::PostIoAction::KeepOpen
+                                      : Network::PostIoAction::Close,
+              bytes_written, false};
+    }
+    bytes_written += result.rc_;
+  }
+
+  if (end_stream) {
+    sendCloseNotify();
+  }
+  return {Network::PostIoAction::KeepOpen, bytes_written, false};
+}
+
+void KtlsSocket::sendCloseNotify() {
+  if (close_notify_sent_) {
+    return;
+  }
+  close_notify_sent_ = true;
+
+#ifdef ENVOY_KTLS_SUPPORTED
+  // A warning level close_notify alert, sent as an alert record.
+  uint8_t alert[] = {1, 0};
+  iovec iov{alert, sizeof(alert)};
+  char control[CMSG_SPACE(sizeof(uint8_t))];
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_TLS;
+  cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(uint8_t));
+  *CMSG_DATA(cmsg) = AlertRecordType;
+  // Ignore the result. This can only fail if the connection failed. In that case, the error will
+  // be detected on the next read, and dealt with appropriately.
+  ::sendmsg(callbacks_->fd(), &msg, MSG_NOSIGNAL);
+#endif
+}
+
+KtlsSocketFactory::KtlsSocketFactory(Network::TransportSocketFactoryPtr&& transport_socket_factory,
+                                     Stats::Scope& scope)
+    : transport_socket_factory_(std::move(transport_socket_factory)),
+      stats_({ALL_KTLS_STATS(POOL_COUNTER_PREFIX(scope, "ktls."))}) {}
+
+Network::TransportSocketPtr KtlsSocketFactory::createTransportSocket() const {
+  return std::make_unique<KtlsSocket>(transport_socket_factory_->createTransportSocket(), stats_);
+}
+
+bool KtlsSocketFactory::implementsSecureTransport() const {
+  return transport_socket_factory_->implementsSecureTransport();
+}
+
+} // namespace Ktls
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
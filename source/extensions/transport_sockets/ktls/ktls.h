@@ -0,0 +1,96 @@
+#pragma once
+
+#include "envoy/network/transport_socket.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "common/common/logger.h"
+#include "common/ssl/ssl_socket.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Ktls {
+
+/**
+ * All kTLS transport socket stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_KTLS_STATS(COUNTER)                                                                    \
+  COUNTER(offloaded)                                                                               \
+  COUNTER(not_offloaded)
+// clang-format on
+
+/**
+ * Struct definition for all kTLS transport socket stats. @see stats_macros.h
+ */
+struct KtlsStats {
+  ALL_KTLS_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * Transport socket which wraps a TLS transport socket, and installs the keys negotiated by its
+ * handshake in the kernel TLS socket options, so that records are encrypted and decrypted by the
+ * kernel. Once the keys are offloaded, the connection is read and written like a raw socket.
+ * Connections whose cipher, protocol version or kernel does not support the offload keep on
+ * using the wrapped socket.
+ */
+class KtlsSocket : public Network::TransportSocket,
+                   protected Logger::Loggable<Logger::Id::connection> {
+public:
+  KtlsSocket(Network::TransportSocketPtr&& transport_socket, const KtlsStats& stats);
+
+  // Network::TransportSocket
+  void setTransportSocketCallbacks(Network::TransportSocketCallbacks& callbacks) override;
+  std::string protocol() const override;
+  bool canFlushClose() override;
+  void closeSocket(Network::ConnectionEvent event) override;
+  Network::IoResult doRead(Buffer::Instance& buffer) override;
+  Network::IoResult doWrite(Buffer::Instance& buffer, bool end_stream) override;
+  void onConnected() override;
+  const Ssl::Connection* ssl() const override;
+  bool passthrough() const override { return false; }
+
+  bool offloaded() const { return state_ == State::Offloaded; }
+
+  /**
+   * @return whether this build and the kernel headers it was built with support kTLS.
+   */
+  static bool isSupported();
+
+private:
+  enum class State { Handshaking, Offloaded, NotOffloaded };
+
+  void maybeOffload();
+  bool offload(SSL* ssl);
+  Network::IoResult doOffloadedRead(Buffer::Instance& buffer);
+  Network::IoResult doOffloadedWrite(Buffer::Instance& buffer, bool end_stream);
+  void sendCloseNotify();
+
+  Network::TransportSocketPtr transport_socket_;
+  // The wrapped socket, if it is a TLS socket.
+  Ssl::SslSocket* ssl_socket_;
+  KtlsStats stats_;
+  Network::TransportSocketCallbacks* callbacks_{};
+  State state_;
+  bool close_notify_sent_{};
+};
+
+class KtlsSocketFactory : public Network::TransportSocketFactory {
+public:
+  KtlsSocketFactory(Network::TransportSocketFactoryPtr&& transport_socket_factory,
+                    Stats::Scope& scope);
+
+  // Network::TransportSocketFactory
+  Network::TransportSocketPtr createTransportSocket() const override;
+  bool implementsSecureTransport() const override;
+
+private:
+  Network::TransportSocketFactoryPtr transport_socket_factory_;
+  const KtlsStats stats_;
+};
+
+} // namespace Ktls
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
@@ -1,27 +1,47 @@
 #include "extensions/transport_sockets/raw_buffer/config.h"
 
+#include "envoy/common/exception.h"
+#include "envoy/config/transport_socket/raw_buffer/v2alpha/raw_buffer.pb.validate.h"
 #include "envoy/registry/registry.h"
 
-#include "common/network/raw_buffer_socket.h"
+#include "common/protobuf/utility.h"
 
 namespace Envoy {
 namespace Extensions {
 namespace TransportSockets {
 namespace RawBuffer {
 
+Network::ReadSizing RawBufferSocketFactory::readSizing(const Protobuf::Message& config) {
+  const auto& proto_config = MessageUtil::downcastAndValidate<
+      const envoy::config::transport_socket::raw_buffer::v2alpha::RawBuffer&>(config);
+  Network::ReadSizing read_sizing;
+  if (proto_config.has_read_sizing()) {
+    const auto& sizing = proto_config.read_sizing();
+    read_sizing.min_read_size_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(
+        sizing, min_read_size, Network::ReadSizing::DefaultReadSize);
+    read_sizing.max_read_size_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(
+        sizing, max_read_size, Network::ReadSizing::DefaultReadSize);
+    if (read_sizing.min_read_size_ > read_sizing.max_read_size_) {
+      throw EnvoyException(fmt::format("raw_buffer: min_read_size ({}) exceeds max_read_size ({})",
+                                       read_sizing.min_read_size_, read_sizing.max_read_size_));
+    }
+  }
+  return read_sizing;
+}
+
 Network::TransportSocketFactoryPtr UpstreamRawBufferSocketFactory::createTransportSocketFactory(
-    const Protobuf::Message&, Server::Configuration::TransportSocketFactoryContext&) {
-  return std::make_unique<Network::RawBufferSocketFactory>();
+    const Protobuf::Message& config, Server::Configuration::TransportSocketFactoryContext&) {
+  return std::make_unique<Network::RawBufferSocketFactory>(readSizing(config));
 }
 
 Network::TransportSocketFactoryPtr DownstreamRawBufferSocketFactory::createTransportSocketFactory(
-    const Protobuf::Message&, Server::Configuration::TransportSocketFactoryContext&,
+    const Protobuf::Message& config, Server::Configuration::TransportSocketFactoryContext&,
     const std::vector<std::string>&) {
-  return std::make_unique<Network::RawBufferSocketFactory>();
+  return std::make_unique<Network::RawBufferSocketFactory>(readSizing(config));
 }
 
 ProtobufTypes::MessagePtr RawBufferSocketFactory::createEmptyConfigProto() {
-  return std::make_unique<ProtobufWkt::Empty>();
+  return std::make_unique<envoy::config::transport_socket::raw_buffer::v2alpha::RawBuffer>();
 }
 
 static Registry::RegisterFactory<UpstreamRawBufferSocketFactory,
@@ -2,6 +2,8 @@
 
 #include "envoy/server/transport_socket_config.h"
 
+#include "common/network/raw_buffer_socket.h"
+
 #include "extensions/transport_sockets/well_known_names.h"
 
 namespace Envoy {
@@ -18,6 +20,13 @@ public:
   virtual ~RawBufferSocketFactory() {}
   std::string name() const override { return TransportSocketNames::get().RawBuffer; }
   ProtobufTypes::MessagePtr createEmptyConfigProto() override;
+
+protected:
+  /**
+   * @return Network::ReadSizing the read sizing specified by a RawBuffer config proto.
+   * @throw EnvoyException if the config is invalid.
+   */
+  static Network::ReadSizing readSizing(const Protobuf::Message& config);
 };
 
 class UpstreamRawBufferSocketFactory
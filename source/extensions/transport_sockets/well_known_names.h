@@ -13,6 +13,7 @@ namespace TransportSockets {
 class TransportSocketNameValues {
 public:
   const std::string Capture = "envoy.transport_sockets.capture";
+  const std::string Ktls = "envoy.transport_sockets.ktls";
   const std::string RawBuffer = "raw_buffer";
   const std::string Tls = "tls";
 };
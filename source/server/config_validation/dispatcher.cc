@@ -22,7 +22,13 @@ Network::DnsResolverSharedPtr ValidationDispatcher::createDnsResolver(
 }
 
 Network::ListenerPtr ValidationDispatcher::createListener(Network::Socket&,
-                                                          Network::ListenerCallbacks&, bool, bool) {
+                                                          Network::ListenerCallbacks&, bool, bool,
+                                                          uint32_t) {
+  NOT_IMPLEMENTED_GCOVR_EXCL_LINE;
+}
+
+Network::UdpListenerPtr ValidationDispatcher::createUdpListener(Network::Socket&,
+                                                                Network::UdpListenerCallbacks&) {
   NOT_IMPLEMENTED_GCOVR_EXCL_LINE;
 }
 
@@ -22,6 +22,7 @@
 #include "server/config_validation/dns.h"
 #include "server/http/admin.h"
 #include "server/listener_manager_impl.h"
+#include "server/overload_manager_impl.h"
 #include "server/server.h"
 
 #include "absl/types/optional.h"
@@ -85,7 +86,7 @@ public:
   void shutdown() override;
   void shutdownAdmin() override { NOT_IMPLEMENTED_GCOVR_EXCL_LINE; }
   Singleton::Manager& singletonManager() override { return *singleton_manager_; }
-  OverloadManager& overloadManager() override { NOT_IMPLEMENTED_GCOVR_EXCL_LINE; }
+  OverloadManager& overloadManager() override { return overload_manager_; }
   bool healthCheckFailed() override { NOT_IMPLEMENTED_GCOVR_EXCL_LINE; }
   Options& options() override { return options_; }
   time_t startTimeCurrentEpoch() override { NOT_IMPLEMENTED_GCOVR_EXCL_LINE; }
@@ -115,6 +116,11 @@ public:
       Configuration::ListenerFactoryContext& context) override {
     return ProdListenerComponentFactory::createListenerFilterFactoryList_(filters, context);
   }
+  std::vector<Network::UdpListenerFilterFactoryCb> createUdpListenerFilterFactoryList(
+      const Protobuf::RepeatedPtrField<envoy::api::v2::listener::ListenerFilter>& filters,
+      Configuration::ListenerFactoryContext& context) override {
+    return ProdListenerComponentFactory::createUdpListenerFilterFactoryList_(filters, context);
+  }
   Network::SocketSharedPtr createListenSocket(Network::Address::InstanceConstSharedPtr,
                                               const Network::Socket::OptionsSharedPtr&,
                                               bool) override {
@@ -122,13 +128,23 @@ public:
     // validation mock.
     return nullptr;
   }
+  Network::SocketSharedPtr createReusePortListenSocket(Network::Address::InstanceConstSharedPtr,
+                                                       const Network::Socket::OptionsSharedPtr&,
+                                                       uint32_t) override {
+    return nullptr;
+  }
+  Network::SocketSharedPtr createUdpListenSocket(Network::Address::InstanceConstSharedPtr,
+                                                 const Network::Socket::OptionsSharedPtr&,
+                                                 uint32_t) override {
+    return nullptr;
+  }
   DrainManagerPtr createDrainManager(envoy::api::v2::Listener::DrainType) override {
     return nullptr;
   }
   uint64_t nextListenerTag() override { return 0; }
 
   // Server::WorkerFactory
-  WorkerPtr createWorker() override {
+  WorkerPtr createWorker(OverloadManager&) override {
     // Returned workers are not currently used so we can return nothing here safely vs. a
     // validation mock.
     return nullptr;
@@ -154,6 +170,8 @@ private:
   AccessLog::AccessLogManagerImpl access_log_manager_;
   std::unique_ptr<Upstream::ValidationClusterManagerFactory> cluster_manager_factory_;
   InitManagerImpl init_manager_;
+  // The workers register for overload actions with an overload manager that is never started.
+  OverloadManagerImpl overload_manager_;
   ListenerManagerImpl listener_manager_;
   std::unique_ptr<Secret::SecretManager> secret_manager_;
 };
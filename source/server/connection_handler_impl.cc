@@ -1,5 +1,11 @@
 #include "server/connection_handler_impl.h"
 
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
 #include "envoy/event/dispatcher.h"
 #include "envoy/event/timer.h"
 #include "envoy/network/filter.h"
@@ -14,10 +20,21 @@
 namespace Envoy {
 namespace Server {
 
+namespace {
+
+// Buffer limits aren't scaled below this, unless the configured limit is lower already.
+constexpr uint32_t MinScaledBufferLimit = 16 * 1024;
+
+} // namespace
+
 ConnectionHandlerImpl::ConnectionHandlerImpl(spdlog::logger& logger, Event::Dispatcher& dispatcher)
     : logger_(logger), dispatcher_(dispatcher) {}
 
 void ConnectionHandlerImpl::addListener(Network::ListenerConfig& config) {
+  if (config.socketType() == Network::Address::SocketType::Datagram) {
+    udp_listeners_.emplace_back(std::make_unique<ActiveUdpListener>(*this, config));
+    return;
+  }
   ActiveListenerPtr l(new ActiveListener(*this, config));
   listeners_.emplace_back(config.socket().localAddress(), std::move(l));
 }
@@ -30,20 +47,151 @@ void ConnectionHandlerImpl::removeListeners(uint64_t listener_tag) {
       ++listener;
     }
   }
+  udp_listeners_.remove_if([listener_tag](const ActiveUdpListenerPtr& listener) -> bool {
+    return listener->listener_tag_ == listener_tag;
+  });
+}
+
+void ConnectionHandlerImpl::removeFilterChains(
+    uint64_t listener_tag, const std::list<const Network::FilterChain*>& filter_chains,
+    std::function<void()> completion) {
+  ActiveListener* listener = findActiveListenerByTag(listener_tag);
+  if (listener == nullptr) {
+    completion();
+    return;
+  }
+
+  for (auto it = listener->connections_.begin(); it != listener->connections_.end();) {
+    // Closing the connection removes it from the list.
+    ActiveConnection& connection = **it++;
+    if (std::find(filter_chains.begin(), filter_chains.end(), connection.filter_chain_) !=
+        filter_chains.end()) {
+      connection.connection_->close(Network::ConnectionCloseType::NoFlush);
+    }
+  }
+
+  listener->removal_completion_ = completion;
+  listener->removeIfIdle();
 }
 
 void ConnectionHandlerImpl::stopListeners(uint64_t listener_tag) {
   for (auto& listener : listeners_) {
     if (listener.second->listener_tag_ == listener_tag) {
-      listener.second->listener_.reset();
+      listener.second->stop();
+    }
+  }
+  for (auto& listener : udp_listeners_) {
+    if (listener->listener_tag_ == listener_tag) {
+      listener->stop();
     }
   }
 }
 
 void ConnectionHandlerImpl::stopListeners() {
   for (auto& listener : listeners_) {
-    listener.second->listener_.reset();
+    listener.second->stop();
+  }
+  for (auto& listener : udp_listeners_) {
+    listener->stop();
+  }
+}
+
+std::vector<int> ConnectionHandlerImpl::releaseIdleConnections() {
+  // Closing a connection removes it from its listener, so the idle ones are collected first.
+  std::vector<std::pair<ActiveListener*, Network::Connection*>> idle_connections;
+  for (auto& listener : listeners_) {
+    for (auto& active_connection : listener.second->connections_) {
+      if (active_connection->connection_->idleForTransfer()) {
+        idle_connections.emplace_back(listener.second.get(), active_connection->connection_.get());
+      }
+    }
+  }
+
+  std::vector<int> fds;
+  fds.reserve(idle_connections.size());
+  for (const auto& idle_connection : idle_connections) {
+    // The duplicate keeps the socket open after the connection closes its own fd. Nothing is
+    // written or shut down on the socket, so the peer doesn't notice.
+    const int fd = dup(idle_connection.second->passthroughFd());
+    if (fd == -1) {
+      continue;
+    }
+    ENVOY_CONN_LOG_TO_LOGGER(logger_, debug, "releasing idle connection", *idle_connection.second);
+    fds.push_back(fd);
+    idle_connection.first->stats_.downstream_cx_transferred_.inc();
+    idle_connection.second->close(Network::ConnectionCloseType::NoFlush);
+  }
+  return fds;
+}
+
+void ConnectionHandlerImpl::adoptConnection(Network::ConnectionSocketPtr&& socket) {
+  ActiveListener* listener = findActiveListenerByAddress(*socket->localAddress());
+  if (listener == nullptr) {
+    ENVOY_LOG_TO_LOGGER(logger_, debug, "closing adopted connection: no listener for {}",
+                        socket->localAddress()->asString());
+    socket->close();
+    return;
+  }
+
+  // The listener filters already ran in the process that accepted the socket, so the transport
+  // protocol is set the way they would have for a passthrough connection.
+  socket->setDetectedTransportProtocol(
+      Extensions::TransportSockets::TransportSocketNames::get().RawBuffer);
+  listener->newConnection(std::move(socket));
+}
+
+void ConnectionHandlerImpl::setBufferLimitScale(double scale) {
+  ASSERT(scale >= 0 && scale <= 1);
+  if (scale == buffer_limit_scale_) {
+    return;
+  }
+  buffer_limit_scale_ = scale;
+  for (auto& listener : listeners_) {
+    const uint32_t limit =
+        scaledBufferLimit(listener.second->config_.perConnectionBufferLimitBytes());
+    for (auto& active_connection : listener.second->connections_) {
+      active_connection->connection_->setBufferLimits(limit);
+    }
+  }
+}
+
+uint64_t ConnectionHandlerImpl::closeIdleConnections(double share) {
+  ASSERT(share >= 0 && share <= 1);
+  if (share == 0) {
+    return 0;
+  }
+
+  // Closing a connection removes it from its listener, so the connections to close are collected
+  // first. New connections are added to the front of the list, so the oldest are at its back.
+  std::vector<std::pair<ActiveListener*, Network::Connection*>> idle_connections;
+  for (auto& listener : listeners_) {
+    const size_t listener_begin = idle_connections.size();
+    for (auto it = listener.second->connections_.rbegin();
+         it != listener.second->connections_.rend(); ++it) {
+      if ((*it)->connection_->idle()) {
+        idle_connections.emplace_back(listener.second.get(), (*it)->connection_.get());
+      }
+    }
+    const size_t num_idle = idle_connections.size() - listener_begin;
+    const size_t num_to_close = std::ceil(share * num_idle);
+    idle_connections.resize(listener_begin + num_to_close);
+  }
+
+  for (const auto& idle_connection : idle_connections) {
+    ENVOY_CONN_LOG_TO_LOGGER(logger_, debug, "closing idle connection under memory pressure",
+                             *idle_connection.second);
+    idle_connection.first->stats_.downstream_cx_overload_idle_close_.inc();
+    idle_connection.second->close(Network::ConnectionCloseType::NoFlush);
   }
+  return idle_connections.size();
+}
+
+uint32_t ConnectionHandlerImpl::scaledBufferLimit(uint32_t limit) const {
+  // A limit of 0 disables the watermarks altogether, which a scale can't express.
+  if (limit == 0) {
+    return 0;
+  }
+  return std::max<uint32_t>(limit * buffer_limit_scale_, std::min(limit, MinScaledBufferLimit));
 }
 
 void ConnectionHandlerImpl::ActiveListener::removeConnection(ActiveConnection& connection) {
@@ -53,6 +201,24 @@ void ConnectionHandlerImpl::ActiveListener::removeConnection(ActiveConnection& c
   parent_.dispatcher_.deferredDelete(std::move(removed));
   ASSERT(parent_.num_connections_ > 0);
   parent_.num_connections_--;
+  ASSERT(num_listener_connections_ > 0);
+  num_listener_connections_--;
+  removeIfIdle();
+}
+
+void ConnectionHandlerImpl::ActiveListener::removeIfIdle() {
+  if (removal_completion_ == nullptr || !connections_.empty()) {
+    return;
+  }
+
+  std::function<void()> completion = std::move(removal_completion_);
+  removal_completion_ = nullptr;
+  ConnectionHandlerImpl& parent = parent_;
+  const uint64_t listener_tag = listener_tag_;
+  parent_.dispatcher_.post([&parent, listener_tag, completion]() -> void {
+    parent.removeListeners(listener_tag);
+    completion();
+  });
 }
 
 ConnectionHandlerImpl::ActiveListener::ActiveListener(ConnectionHandlerImpl& parent,
@@ -60,7 +226,8 @@ ConnectionHandlerImpl::ActiveListener::ActiveListener(ConnectionHandlerImpl& par
     : ActiveListener(
           parent,
           parent.dispatcher_.createListener(config.socket(), *this, config.bindToPort(),
-                                            config.handOffRestoredDestinationConnections()),
+                                            config.handOffRestoredDestinationConnections(),
+                                            config.maxAcceptsPerWakeup()),
           config) {}
 
 ConnectionHandlerImpl::ActiveListener::ActiveListener(ConnectionHandlerImpl& parent,
@@ -68,9 +235,15 @@ ConnectionHandlerImpl::ActiveListener::ActiveListener(ConnectionHandlerImpl& par
                                                       Network::ListenerConfig& config)
     : parent_(parent), listener_(std::move(listener)),
       stats_(generateStats(config.listenerScope())), listener_tag_(config.listenerTag()),
-      config_(config) {}
+      config_(config) {
+  config_.connectionBalancer().registerHandler(*this);
+}
 
 ConnectionHandlerImpl::ActiveListener::~ActiveListener() {
+  if (listener_ != nullptr) {
+    config_.connectionBalancer().unregisterHandler(*this);
+  }
+
   // Purge sockets that have not progressed to connections. This should only happen when
   // a listener filter stops iteration and never resumes.
   while (!sockets_.empty()) {
@@ -85,6 +258,14 @@ ConnectionHandlerImpl::ActiveListener::~ActiveListener() {
   parent_.dispatcher_.clearDeferredDeleteList();
 }
 
+void ConnectionHandlerImpl::ActiveListener::stop() {
+  // The listener stays registered with the balancer for as long as it accepts connections.
+  if (listener_ != nullptr) {
+    config_.connectionBalancer().unregisterHandler(*this);
+    listener_.reset();
+  }
+}
+
 Network::Listener*
 ConnectionHandlerImpl::findListenerByAddress(const Network::Address::Instance& address) {
   ActiveListener* listener = findActiveListenerByAddress(address);
@@ -120,6 +301,16 @@ ConnectionHandlerImpl::findActiveListenerByAddress(const Network::Address::Insta
   return (listener_it != listeners_.end()) ? listener_it->second.get() : nullptr;
 }
 
+ConnectionHandlerImpl::ActiveListener*
+ConnectionHandlerImpl::findActiveListenerByTag(uint64_t listener_tag) {
+  for (auto& listener : listeners_) {
+    if (listener.second->listener_tag_ == listener_tag) {
+      return listener.second.get();
+    }
+  }
+  return nullptr;
+}
+
 void ConnectionHandlerImpl::ActiveSocket::continueFilterChain(bool success) {
   if (success) {
     if (iter_ == accept_filters_.end()) {
@@ -148,8 +339,8 @@ void ConnectionHandlerImpl::ActiveSocket::continueFilterChain(bool success) {
     if (new_listener != nullptr) {
       // Hands off connections redirected by iptables to the listener associated with the
       // original destination address. Pass 'hand_off_restored_destionations' as false to
-      // prevent further redirection.
-      new_listener->onAccept(std::move(socket_), false);
+      // prevent further redirection. The socket has already been balanced to this worker.
+      new_listener->onAcceptWorker(std::move(socket_), false, true);
     } else {
       // Set default transport protocol if none of the listener filters did it.
       if (socket_->detectedTransportProtocol().empty()) {
@@ -170,7 +361,21 @@ void ConnectionHandlerImpl::ActiveSocket::continueFilterChain(bool success) {
 
 void ConnectionHandlerImpl::ActiveListener::onAccept(
     Network::ConnectionSocketPtr&& socket, bool hand_off_restored_destination_connections) {
-  Network::Address::InstanceConstSharedPtr local_address = socket->localAddress();
+  onAcceptWorker(std::move(socket), hand_off_restored_destination_connections, false);
+}
+
+void ConnectionHandlerImpl::ActiveListener::onAcceptWorker(
+    Network::ConnectionSocketPtr&& socket, bool hand_off_restored_destination_connections,
+    bool rebalanced) {
+  if (!rebalanced) {
+    Network::BalancedConnectionHandler& target_handler =
+        config_.connectionBalancer().pickTargetHandler(*this);
+    if (&target_handler != this) {
+      target_handler.post(std::move(socket));
+      return;
+    }
+  }
+
   auto active_socket = std::make_unique<ActiveSocket>(*this, std::move(socket),
                                                       hand_off_restored_destination_connections);
 
@@ -185,6 +390,26 @@ void ConnectionHandlerImpl::ActiveListener::onAccept(
   }
 }
 
+void ConnectionHandlerImpl::ActiveListener::post(Network::ConnectionSocketPtr&& socket) {
+  // This runs on the worker that accepted the socket. The listener may be removed from this
+  // handler before the socket is delivered, so it is looked up by tag on delivery. If it is gone,
+  // the socket is closed when the callback is destroyed.
+  ConnectionHandlerImpl& parent = parent_;
+  const uint64_t listener_tag = listener_tag_;
+  auto socket_to_post = std::make_shared<Network::ConnectionSocketPtr>(std::move(socket));
+  parent_.dispatcher_.post([&parent, listener_tag, socket_to_post]() -> void {
+    ActiveListener* listener = parent.findActiveListenerByTag(listener_tag);
+    if (listener == nullptr) {
+      return;
+    }
+    // Release the connection accounted for by the balancer. newConnection() accounts for it again
+    // if it gets that far.
+    --listener->num_listener_connections_;
+    listener->onAcceptWorker(std::move(*socket_to_post),
+                             listener->config_.handOffRestoredDestinationConnections(), true);
+  });
+}
+
 void ConnectionHandlerImpl::ActiveListener::newConnection(Network::ConnectionSocketPtr&& socket) {
   // Find matching filter chain.
   const auto filter_chain = config_.filterChainManager().findFilterChain(*socket);
@@ -199,7 +424,12 @@ void ConnectionHandlerImpl::ActiveListener::newConnection(Network::ConnectionSoc
   auto transport_socket = filter_chain->transportSocketFactory().createTransportSocket();
   Network::ConnectionPtr new_connection =
       parent_.dispatcher_.createServerConnection(std::move(socket), std::move(transport_socket));
-  new_connection->setBufferLimits(config_.perConnectionBufferLimitBytes());
+  new_connection->setBufferLimits(
+      parent_.scaledBufferLimit(config_.perConnectionBufferLimitBytes()));
+  if (config_.perConnectionReadBudgetBytes() > 0) {
+    new_connection->setReadBudget(config_.perConnectionReadBudgetBytes(),
+                                  stats_.downstream_cx_read_yield_);
+  }
 
   const bool empty_filter_chain = !config_.filterChainFactory().createNetworkFilterChain(
       *new_connection, filter_chain->networkFilterFactories());
@@ -210,24 +440,39 @@ void ConnectionHandlerImpl::ActiveListener::newConnection(Network::ConnectionSoc
     return;
   }
 
-  onNewConnection(std::move(new_connection));
+  addConnection(std::move(new_connection), filter_chain);
 }
 
 void ConnectionHandlerImpl::ActiveListener::onNewConnection(
     Network::ConnectionPtr&& new_connection) {
+  addConnection(std::move(new_connection), nullptr);
+}
+
+void ConnectionHandlerImpl::ActiveListener::addConnection(
+    Network::ConnectionPtr&& new_connection, const Network::FilterChain* filter_chain) {
   ENVOY_CONN_LOG_TO_LOGGER(parent_.logger_, debug, "new connection", *new_connection);
 
   // If the connection is already closed, we can just let this connection immediately die.
   if (new_connection->state() != Network::Connection::State::Closed) {
-    ActiveConnectionPtr active_connection(new ActiveConnection(*this, std::move(new_connection)));
+    ActiveConnectionPtr active_connection(
+        new ActiveConnection(*this, std::move(new_connection), filter_chain));
     active_connection->moveIntoList(std::move(active_connection), connections_);
     parent_.num_connections_++;
+    num_listener_connections_++;
+  }
+}
+
+void ConnectionHandlerImpl::ActiveListener::onAcceptBatch(uint32_t accepted, bool limit_reached) {
+  stats_.downstream_cx_accepted_per_wakeup_.recordValue(accepted);
+  if (limit_reached) {
+    stats_.downstream_cx_accept_queue_overflow_.inc();
   }
 }
 
-ConnectionHandlerImpl::ActiveConnection::ActiveConnection(ActiveListener& listener,
-                                                          Network::ConnectionPtr&& new_connection)
-    : listener_(listener), connection_(std::move(new_connection)),
+ConnectionHandlerImpl::ActiveConnection::ActiveConnection(
+    ActiveListener& listener, Network::ConnectionPtr&& new_connection,
+    const Network::FilterChain* filter_chain)
+    : listener_(listener), connection_(std::move(new_connection)), filter_chain_(filter_chain),
       conn_length_(new Stats::Timespan(listener_.stats_.downstream_cx_length_ms_)) {
   // We just universally set no delay on connections. Theoretically we might at some point want
   // to make this configurable.
@@ -243,9 +488,46 @@ ConnectionHandlerImpl::ActiveConnection::~ActiveConnection() {
   conn_length_->complete();
 }
 
+ConnectionHandlerImpl::ActiveUdpListener::ActiveUdpListener(ConnectionHandlerImpl& parent,
+                                                            Network::ListenerConfig& config)
+    : parent_(parent), udp_listener_(parent.dispatcher_.createUdpListener(config.socket(), *this)),
+      stats_(generateUdpStats(config.listenerScope())), listener_tag_(config.listenerTag()) {
+  config.filterChainFactory().createUdpListenerFilterChain(*this, *this);
+}
+
+void ConnectionHandlerImpl::ActiveUdpListener::onData(Network::UdpRecvData& data) {
+  stats_.downstream_rx_datagram_total_.inc();
+  for (auto& filter : read_filters_) {
+    if (filter->onData(data) == Network::FilterStatus::StopIteration) {
+      return;
+    }
+  }
+}
+
+void ConnectionHandlerImpl::ActiveUdpListener::onReceiveError(int error) {
+  ENVOY_LOG_TO_LOGGER(parent_.logger_, debug, "udp listener {}: receive error: {}",
+                      udp_listener_->localAddress()->asString(), strerror(error));
+  stats_.downstream_rx_datagram_error_.inc();
+}
+
+void ConnectionHandlerImpl::ActiveUdpListener::onSendError(int error) {
+  ENVOY_LOG_TO_LOGGER(parent_.logger_, debug, "udp listener {}: send error: {}",
+                      udp_listener_->localAddress()->asString(), strerror(error));
+  stats_.downstream_tx_datagram_error_.inc();
+}
+
+void ConnectionHandlerImpl::ActiveUdpListener::stop() {
+  read_filters_.clear();
+  udp_listener_.reset();
+}
+
 ListenerStats ConnectionHandlerImpl::generateStats(Stats::Scope& scope) {
   return {ALL_LISTENER_STATS(POOL_COUNTER(scope), POOL_GAUGE(scope), POOL_HISTOGRAM(scope))};
 }
 
+UdpListenerStats ConnectionHandlerImpl::generateUdpStats(Stats::Scope& scope) {
+  return {ALL_UDP_LISTENER_STATS(POOL_COUNTER(scope))};
+}
+
 } // namespace Server
 } // namespace Envoy
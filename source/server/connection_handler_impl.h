@@ -2,12 +2,15 @@
 
 #include <atomic>
 #include <cstdint>
+#include <functional>
 #include <list>
 #include <memory>
+#include <vector>
 
 #include "envoy/common/time.h"
 #include "envoy/event/deferred_deletable.h"
 #include "envoy/network/connection.h"
+#include "envoy/network/connection_balancer.h"
 #include "envoy/network/connection_handler.h"
 #include "envoy/network/filter.h"
 #include "envoy/network/listen_socket.h"
@@ -30,6 +33,11 @@ namespace Server {
   COUNTER  (downstream_cx_destroy)                                                                 \
   GAUGE    (downstream_cx_active)                                                                  \
   HISTOGRAM(downstream_cx_length_ms)                                                               \
+  HISTOGRAM(downstream_cx_accepted_per_wakeup)                                                     \
+  COUNTER  (downstream_cx_accept_queue_overflow)                                                   \
+  COUNTER  (downstream_cx_transferred)                                                             \
+  COUNTER  (downstream_cx_overload_idle_close)                                                     \
+  COUNTER  (downstream_cx_read_yield)                                                              \
   COUNTER  (no_filter_chain_match)
 // clang-format on
 
@@ -40,6 +48,20 @@ struct ListenerStats {
   ALL_LISTENER_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT, GENERATE_HISTOGRAM_STRUCT)
 };
 
+// clang-format off
+#define ALL_UDP_LISTENER_STATS(COUNTER)                                                            \
+  COUNTER(downstream_rx_datagram_total)                                                            \
+  COUNTER(downstream_rx_datagram_error)                                                            \
+  COUNTER(downstream_tx_datagram_error)
+// clang-format on
+
+/**
+ * Wrapper struct for UDP listener stats. @see stats_macros.h
+ */
+struct UdpListenerStats {
+  ALL_UDP_LISTENER_STATS(GENERATE_COUNTER_STRUCT)
+};
+
 /**
  * Server side connection handler. This is used both by workers as well as the
  * main thread for non-threaded listeners.
@@ -52,14 +74,23 @@ public:
   uint64_t numConnections() override { return num_connections_; }
   void addListener(Network::ListenerConfig& config) override;
   void removeListeners(uint64_t listener_tag) override;
+  void removeFilterChains(uint64_t listener_tag,
+                          const std::list<const Network::FilterChain*>& filter_chains,
+                          std::function<void()> completion) override;
   void stopListeners(uint64_t listener_tag) override;
   void stopListeners() override;
+  std::vector<int> releaseIdleConnections() override;
+  void adoptConnection(Network::ConnectionSocketPtr&& socket) override;
+  void setBufferLimitScale(double scale) override;
+  uint64_t closeIdleConnections(double share) override;
 
   Network::Listener* findListenerByAddress(const Network::Address::Instance& address) override;
 
 private:
   struct ActiveListener;
   ActiveListener* findActiveListenerByAddress(const Network::Address::Instance& address);
+  ActiveListener* findActiveListenerByTag(uint64_t listener_tag);
+  uint32_t scaledBufferLimit(uint32_t limit) const;
 
   struct ActiveConnection;
   typedef std::unique_ptr<ActiveConnection> ActiveConnectionPtr;
@@ -69,7 +100,8 @@ private:
   /**
    * Wrapper for an active listener owned by this handler.
    */
-  struct ActiveListener : public Network::ListenerCallbacks {
+  struct ActiveListener : public Network::ListenerCallbacks,
+                          public Network::BalancedConnectionHandler {
     ActiveListener(ConnectionHandlerImpl& parent, Network::ListenerConfig& config);
 
     ActiveListener(ConnectionHandlerImpl& parent, Network::ListenerPtr&& listener,
@@ -81,6 +113,28 @@ private:
     void onAccept(Network::ConnectionSocketPtr&& socket,
                   bool hand_off_restored_destination_connections) override;
     void onNewConnection(Network::ConnectionPtr&& new_connection) override;
+    void onAcceptBatch(uint32_t accepted, bool limit_reached) override;
+
+    // Network::BalancedConnectionHandler
+    uint64_t numConnections() const override { return num_listener_connections_; }
+    void incNumConnections() override { ++num_listener_connections_; }
+    void post(Network::ConnectionSocketPtr&& socket) override;
+
+    /**
+     * Run the listener filters and create a connection for an accepted socket.
+     * @param socket supplies the accepted socket.
+     * @param hand_off_restored_destination_connections supplies whether the socket may be handed
+     *        off to the listener of its original destination address.
+     * @param rebalanced supplies whether the socket has already been through the connection
+     *        balancer, in which case it stays on this listener.
+     */
+    void onAcceptWorker(Network::ConnectionSocketPtr&& socket,
+                        bool hand_off_restored_destination_connections, bool rebalanced);
+
+    /**
+     * Stop accepting new connections and stop being a target of the connection balancer.
+     */
+    void stop();
 
     /**
      * Remove and destroy an active connection.
@@ -93,6 +147,19 @@ private:
      */
     void newConnection(Network::ConnectionSocketPtr&& socket);
 
+    /**
+     * Take ownership of a connection.
+     * @param filter_chain supplies the filter chain the connection was created from, if any.
+     */
+    void addConnection(Network::ConnectionPtr&& new_connection,
+                       const Network::FilterChain* filter_chain);
+
+    /**
+     * Remove the listener if it is pending removal and has no connections left. The removal is
+     * posted, since the last connection is removed from one of its own callbacks.
+     */
+    void removeIfIdle();
+
     ConnectionHandlerImpl& parent_;
     Network::ListenerPtr listener_;
     ListenerStats stats_;
@@ -100,17 +167,62 @@ private:
     std::list<ActiveConnectionPtr> connections_;
     const uint64_t listener_tag_;
     Network::ListenerConfig& config_;
+    // Connections owned by this listener plus connections balanced to it that are still being
+    // posted. Read by the connection balancer from other workers.
+    std::atomic<uint64_t> num_listener_connections_{};
+    // Set by removeFilterChains(), called once the listener is removed.
+    std::function<void()> removal_completion_;
   };
 
   typedef std::unique_ptr<ActiveListener> ActiveListenerPtr;
 
+  /**
+   * Wrapper for an active UDP listener owned by this handler. The listener's filters are created
+   * when it is added and see every datagram it receives.
+   */
+  struct ActiveUdpListener : public Network::UdpListenerCallbacks,
+                             public Network::UdpListenerFilterManager,
+                             public Network::UdpReadFilterCallbacks {
+    ActiveUdpListener(ConnectionHandlerImpl& parent, Network::ListenerConfig& config);
+
+    // Network::UdpListenerCallbacks
+    void onData(Network::UdpRecvData& data) override;
+    void onReceiveError(int error) override;
+    void onSendError(int error) override;
+
+    // Network::UdpListenerFilterManager
+    void addReadFilter(Network::UdpListenerReadFilterPtr&& filter) override {
+      read_filters_.emplace_back(std::move(filter));
+    }
+
+    // Network::UdpReadFilterCallbacks
+    Network::UdpListener& udpListener() override { return *udp_listener_; }
+    Event::Dispatcher& dispatcher() override { return parent_.dispatcher_; }
+
+    /**
+     * Stop receiving datagrams. The filters are destroyed first since they send through the
+     * listener.
+     */
+    void stop();
+
+    ConnectionHandlerImpl& parent_;
+    Network::UdpListenerPtr udp_listener_;
+    UdpListenerStats stats_;
+    // Declared after the listener so that the filters are destroyed first.
+    std::list<Network::UdpListenerReadFilterPtr> read_filters_;
+    const uint64_t listener_tag_;
+  };
+
+  typedef std::unique_ptr<ActiveUdpListener> ActiveUdpListenerPtr;
+
   /**
    * Wrapper for an active connection owned by this handler.
    */
   struct ActiveConnection : LinkedObject<ActiveConnection>,
                             public Event::DeferredDeletable,
                             public Network::ConnectionCallbacks {
-    ActiveConnection(ActiveListener& listener, Network::ConnectionPtr&& new_connection);
+    ActiveConnection(ActiveListener& listener, Network::ConnectionPtr&& new_connection,
+                     const Network::FilterChain* filter_chain);
     ~ActiveConnection();
 
     // Network::ConnectionCallbacks
@@ -126,6 +238,8 @@ private:
 
     ActiveListener& listener_;
     Network::ConnectionPtr connection_;
+    // Null for connections that were not created from a filter chain of the listener.
+    const Network::FilterChain* const filter_chain_;
     Stats::TimespanPtr conn_length_;
   };
 
@@ -161,11 +275,15 @@ private:
   };
 
   static ListenerStats generateStats(Stats::Scope& scope);
+  static UdpListenerStats generateUdpStats(Stats::Scope& scope);
 
   spdlog::logger& logger_;
   Event::Dispatcher& dispatcher_;
   std::list<std::pair<Network::Address::InstanceConstSharedPtr, ActiveListenerPtr>> listeners_;
+  // UDP listeners are kept apart since connections are never accepted or handed off to them.
+  std::list<ActiveUdpListenerPtr> udp_listeners_;
   std::atomic<uint64_t> num_connections_{};
+  double buffer_limit_scale_{1};
 };
 
 } // namespace Server
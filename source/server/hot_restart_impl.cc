@@ -4,7 +4,9 @@
 #include <sys/prctl.h>
 #include <sys/types.h>
 #include <sys/un.h>
+#include <unistd.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <string>
 
@@ -17,6 +19,8 @@
 #include "common/common/fmt.h"
 #include "common/common/lock_guard.h"
 #include "common/common/utility.h"
+#include "common/network/address_impl.h"
+#include "common/network/listen_socket_impl.h"
 #include "common/network/utility.h"
 #include "common/stats/raw_stat_data.h"
 #include "common/stats/stats_options_impl.h"
@@ -28,17 +32,32 @@ namespace Server {
 
 // Increment this whenever there is a shared memory / RPC change that will prevent a hot restart
 // from working. Operations code can then cope with this and do a full restart.
-const uint64_t SharedMemory::VERSION = 10;
+const uint64_t SharedMemory::VERSION = 13;
 
-static BlockMemoryHashSetOptions blockMemHashOptions(uint64_t max_stats) {
-  BlockMemoryHashSetOptions hash_set_options;
+constexpr uint32_t HotRestartImpl::MaxFdsPerTransfer;
+
+static SegmentedMemoryHashSetOptions statsSetOptions(uint64_t max_stats) {
+  SegmentedMemoryHashSetOptions hash_set_options;
   hash_set_options.capacity = max_stats;
 
-  // https://stackoverflow.com/questions/3980117/hash-table-why-size-should-be-prime
-  hash_set_options.num_slots = Primes::findPrimeLargerThan(hash_set_options.capacity / 2);
+  // Stats are only given shared memory as they are created, in segments starting small enough for
+  // a minimal configuration, and doubling up to a size that bounds the unused tail of the last
+  // segment.
+  hash_set_options.initial_segment_bytes = 256 * 1024;
+  hash_set_options.max_segment_bytes = 64 * 1024 * 1024;
+  hash_set_options.max_segments = 256;
   return hash_set_options;
 }
 
+// Takes a reference to a stat found without the lock, unless its last reference was dropped, in
+// which case it is about to be removed.
+static bool addRefIfReferenced(Stats::RawStatData& data) {
+  uint16_t ref_count = data.ref_count_;
+  while (ref_count > 0 && !data.ref_count_.compare_exchange_weak(ref_count, ref_count + 1)) {
+  }
+  return ref_count > 0;
+}
+
 SharedMemory& SharedMemory::initialize(uint64_t stats_set_size, Options& options) {
   Api::OsSysCalls& os_sys_calls = Api::OsSysCallsSingleton::get();
 
@@ -121,9 +140,8 @@ std::string SharedMemory::version(uint64_t max_num_stats,
 }
 
 HotRestartImpl::HotRestartImpl(Options& options)
-    : options_(options), stats_set_options_(blockMemHashOptions(options.maxStats())),
-      shmem_(SharedMemory::initialize(
-          RawStatDataSet::numBytes(stats_set_options_, options_.statsOptions()), options_)),
+    : options_(options), stats_set_options_(statsSetOptions(options.maxStats())),
+      shmem_(SharedMemory::initialize(RawStatDataSet::numBytes(options_.statsOptions()), options_)),
       log_lock_(shmem_.log_lock_), access_log_lock_(shmem_.access_log_lock_),
       stat_lock_(shmem_.stat_lock_), init_lock_(shmem_.init_lock_) {
   {
@@ -131,7 +149,7 @@ HotRestartImpl::HotRestartImpl(Options& options)
     // because it might be actively written to while we sanityCheck it.
     Thread::LockGuard lock(stat_lock_);
     stats_set_.reset(new RawStatDataSet(stats_set_options_, options.restartEpoch() == 0,
-                                        shmem_.stats_set_data_, options_.statsOptions()));
+                                        shmem_.stats_set_data_, *this, options_.statsOptions()));
   }
   my_domain_socket_ = bindDomainSocket(options.restartEpoch());
   child_address_ = createDomainSocketAddress((options.restartEpoch() + 1));
@@ -147,20 +165,33 @@ HotRestartImpl::HotRestartImpl(Options& options)
 }
 
 Stats::RawStatData* HotRestartImpl::alloc(absl::string_view name) {
-  // Try to find the existing slot in shared memory, otherwise allocate a new one.
-  Thread::LockGuard lock(stat_lock_);
   // In production, the name is truncated in ThreadLocalStore before this
   // is called. This is just a sanity check to make sure that actually happens;
   // it is coded as an if/return-null to facilitate testing.
   ASSERT(name.length() <= options_.statsOptions().maxNameLength());
+
+  // Most stats already exist, e.g. all of those recreated by a hot restarted child, so first try
+  // to reference the existing slot without contending for the lock shared with the other process.
+  Stats::RawStatData* data = stats_set_->getUnlocked(name);
+  if (data != nullptr && addRefIfReferenced(*data)) {
+    if (data->key() == name) {
+      return data;
+    }
+    // The slot was released and reused for another stat before the reference was taken.
+    free(*data);
+  }
+
+  // Otherwise find the existing slot in shared memory under the lock, or allocate a new one.
+  Thread::LockGuard lock(stat_lock_);
   auto value_created = stats_set_->insert(name);
-  Stats::RawStatData* data = value_created.first;
+  data = value_created.first;
   if (data == nullptr) {
     return nullptr;
   }
-  // For new entries (value-created.second==true), BlockMemoryHashSet calls Value::initialize()
+  // For new entries (value-created.second==true), SegmentedMemoryHashSet calls Value::initialize()
   // automatically, but on recycled entries (value-created.second==false) we need to bump the
-  // ref-count.
+  // ref-count. This may revive an entry whose last reference was just dropped, in which case
+  // free() leaves it in place.
   if (!value_created.second) {
     ++data->ref_count_;
   }
@@ -168,16 +199,56 @@ Stats::RawStatData* HotRestartImpl::alloc(absl::string_view name) {
 }
 
 void HotRestartImpl::free(Stats::RawStatData& data) {
-  // We must hold the lock since the reference decrement can race with an initialize above.
-  Thread::LockGuard lock(stat_lock_);
   ASSERT(data.ref_count_ > 0);
   if (--data.ref_count_ > 0) {
     return;
   }
+  // Only the removal needs the lock. By the time it is held, alloc() may have revived the entry,
+  // or another free() of a revived reference may have removed it already.
+  Thread::LockGuard lock(stat_lock_);
+  if (data.ref_count_ > 0 || !data.initialized()) {
+    return;
+  }
+  // The entry is sized to its name, and may be reused for a stat with a name of the same length.
+  const uint64_t size = Stats::RawStatData::structSize(data.key().size());
   bool key_removed = stats_set_->remove(data.key());
   ASSERT(key_removed);
-  memset(static_cast<void*>(&data), 0,
-         Stats::RawStatData::structSizeWithOptions(options_.statsOptions()));
+  memset(static_cast<void*>(&data), 0, size);
+}
+
+uint8_t* HotRestartImpl::mapSegment(uint32_t index, uint64_t size, bool create) {
+  Api::OsSysCalls& os_sys_calls = Api::OsSysCallsSingleton::get();
+  const std::string shmem_name =
+      fmt::format("/envoy_shared_memory_{}_{}", options_.baseId(), index);
+
+  int flags = O_RDWR;
+  if (create) {
+    flags |= O_CREAT | O_EXCL;
+
+    // A segment left behind by a previous instance is stale, as its stats set was reinitialized.
+    os_sys_calls.shmUnlink(shmem_name.c_str());
+  }
+
+  const Api::SysCallIntResult result =
+      os_sys_calls.shmOpen(shmem_name.c_str(), flags, S_IRUSR | S_IWUSR);
+  if (result.rc_ == -1) {
+    ENVOY_LOG(error, "cannot open shared memory region {}: {}", shmem_name,
+              strerror(result.errno_));
+    return nullptr;
+  }
+
+  // A new segment is zero-filled by ftruncate(). The mapping outlives the descriptor.
+  void* segment = MAP_FAILED;
+  if (!create || os_sys_calls.ftruncate(result.rc_, size).rc_ != -1) {
+    segment = os_sys_calls.mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, result.rc_, 0)
+                  .rc_;
+  }
+  os_sys_calls.close(result.rc_);
+  if (segment == MAP_FAILED) {
+    ENVOY_LOG(error, "cannot map shared memory region {} of {} bytes", shmem_name, size);
+    return nullptr;
+  }
+  return static_cast<uint8_t*>(segment);
 }
 
 int HotRestartImpl::bindDomainSocket(uint64_t id) {
@@ -228,7 +299,8 @@ void HotRestartImpl::drainParentListeners() {
   shmem_.flags_ &= ~SharedMemory::Flags::INITIALIZING;
 }
 
-int HotRestartImpl::duplicateParentListenSocket(const std::string& address) {
+int HotRestartImpl::duplicateParentListenSocket(const std::string& address,
+                                                uint32_t worker_index) {
   if (options_.restartEpoch() == 0 || parent_terminated_) {
     return -1;
   }
@@ -236,12 +308,59 @@ int HotRestartImpl::duplicateParentListenSocket(const std::string& address) {
   RpcGetListenSocketRequest rpc;
   ASSERT(address.length() < sizeof(rpc.address_));
   StringUtil::strlcpy(rpc.address_, address.c_str(), sizeof(rpc.address_));
+  rpc.worker_index_ = worker_index;
   sendMessage(parent_address_, rpc);
   RpcGetListenSocketReply* reply =
       receiveTypedRpc<RpcGetListenSocketReply, RpcMessageType::GetListenSocketReply>();
   return reply->fd_;
 }
 
+void HotRestartImpl::transferParentConnections() {
+  // See large comment in getParentStats() on why this operation is locked.
+  Thread::LockGuard lock(init_lock_);
+  if (options_.restartEpoch() == 0 || parent_terminated_ ||
+      !options_.hotRestartTransferConnections()) {
+    return;
+  }
+
+  uint64_t num_transferred = 0;
+  while (true) {
+    RpcBase rpc(RpcMessageType::TransferConnectionsRequest);
+    sendMessage(parent_address_, rpc);
+    RpcBase* base_reply = receiveRpc(true);
+    if (base_reply->type_ == RpcMessageType::UnknownRequestReply) {
+      ENVOY_LOG(warn, "parent does not support transferring connections");
+      return;
+    }
+    RELEASE_ASSERT(base_reply->length_ == sizeof(RpcTransferConnectionsReply), "");
+    RELEASE_ASSERT(base_reply->type_ == RpcMessageType::TransferConnectionsReply, "");
+    RpcTransferConnectionsReply* reply =
+        reinterpret_cast<RpcTransferConnectionsReply*>(base_reply);
+    if (reply->num_fds_ == 0) {
+      break;
+    }
+
+    for (uint32_t i = 0; i < reply->num_fds_; i++) {
+      const int fd = reply->fds_[i];
+      Network::Address::InstanceConstSharedPtr local_address;
+      Network::Address::InstanceConstSharedPtr remote_address;
+      try {
+        local_address = Network::Address::addressFromFd(fd);
+        remote_address = Network::Address::peerAddressFromFd(fd);
+      } catch (const EnvoyException& e) {
+        // The peer may have closed the connection while it was being transferred.
+        ENVOY_LOG(debug, "dropping transferred connection: {}", e.what());
+        ::close(fd);
+        continue;
+      }
+      server_->listenerManager().adoptConnection(
+          std::make_unique<Network::AcceptedSocketImpl>(fd, local_address, remote_address));
+      num_transferred++;
+    }
+  }
+  ENVOY_LOG(info, "took over {} idle connections from the parent", num_transferred);
+}
+
 void HotRestartImpl::getParentStats(GetParentStatsInfo& info) {
   // There exists a race condition during hot restart involving fetching parent stats. It looks like
   // this:
@@ -296,16 +415,17 @@ HotRestartImpl::RpcBase* HotRestartImpl::receiveRpc(bool block) {
   iov[0].iov_base = &rpc_buffer_[0];
   iov[0].iov_len = rpc_buffer_.size();
 
-  // We always setup to receive an FD even though most messages do not pass one.
-  uint8_t control_buffer[CMSG_SPACE(sizeof(int))];
-  memset(control_buffer, 0, CMSG_SPACE(sizeof(int)));
+  // We always setup to receive as many FDs as a TransferConnectionsReply carries even though most
+  // messages do not pass any.
+  uint8_t control_buffer[CMSG_SPACE(sizeof(int) * MaxFdsPerTransfer)];
+  memset(control_buffer, 0, sizeof(control_buffer));
 
   msghdr message;
   memset(&message, 0, sizeof(message));
   message.msg_iov = iov;
   message.msg_iovlen = 1;
   message.msg_control = control_buffer;
-  message.msg_controllen = CMSG_SPACE(sizeof(int));
+  message.msg_controllen = sizeof(control_buffer);
 
   int rc = recvmsg(my_domain_socket_, &message, 0);
   if (!block && rc == -1 && errno == EAGAIN) {
@@ -324,9 +444,9 @@ HotRestartImpl::RpcBase* HotRestartImpl::receiveRpc(bool block) {
   RpcBase* rpc = reinterpret_cast<RpcBase*>(&rpc_buffer_[0]);
   RELEASE_ASSERT(static_cast<uint64_t>(rc) == rpc->length_, "");
 
-  // We should only get control data in a GetListenSocketReply. If that's the case, pull the
-  // cloned fd out of the control data and stick it into the RPC so that higher level code does
-  // need to deal with any of this.
+  // We should only get control data in a GetListenSocketReply or a TransferConnectionsReply. If
+  // that's the case, pull the cloned fds out of the control data and stick them into the RPC so
+  // that higher level code does need to deal with any of this.
   for (cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr;
        cmsg = CMSG_NXTHDR(&message, cmsg)) {
 
@@ -335,6 +455,16 @@ HotRestartImpl::RpcBase* HotRestartImpl::receiveRpc(bool block) {
 
       reinterpret_cast<RpcGetListenSocketReply*>(rpc)->fd_ =
           *reinterpret_cast<int*>(CMSG_DATA(cmsg));
+    } else if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+               rpc->type_ == RpcMessageType::TransferConnectionsReply) {
+
+      RpcTransferConnectionsReply* reply = reinterpret_cast<RpcTransferConnectionsReply*>(rpc);
+      const size_t num_fds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+      RELEASE_ASSERT(num_fds == reply->num_fds_, "");
+      const int* fds = reinterpret_cast<int*>(CMSG_DATA(cmsg));
+      for (size_t i = 0; i < num_fds; i++) {
+        reply->fds_[i] = fds[i];
+      }
     } else {
       RELEASE_ASSERT(false, "");
     }
@@ -358,50 +488,75 @@ void HotRestartImpl::sendMessage(sockaddr_un& address, RpcBase& rpc) {
   RELEASE_ASSERT(rc != -1, "");
 }
 
+void HotRestartImpl::sendMessageWithFds(sockaddr_un& address, RpcBase& rpc, const int* fds,
+                                        uint32_t num_fds) {
+  ASSERT(num_fds > 0 && num_fds <= MaxFdsPerTransfer);
+  iovec iov[1];
+  iov[0].iov_base = &rpc;
+  iov[0].iov_len = rpc.length_;
+
+  uint8_t control_buffer[CMSG_SPACE(sizeof(int) * MaxFdsPerTransfer)];
+  memset(control_buffer, 0, sizeof(control_buffer));
+
+  msghdr message;
+  memset(&message, 0, sizeof(message));
+  message.msg_name = &address;
+  message.msg_namelen = sizeof(address);
+  message.msg_iov = iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control_buffer;
+  message.msg_controllen = CMSG_SPACE(sizeof(int) * num_fds);
+
+  cmsghdr* control_message = CMSG_FIRSTHDR(&message);
+  control_message->cmsg_level = SOL_SOCKET;
+  control_message->cmsg_type = SCM_RIGHTS;
+  control_message->cmsg_len = CMSG_LEN(sizeof(int) * num_fds);
+  memcpy(CMSG_DATA(control_message), fds, sizeof(int) * num_fds);
+
+  int rc = sendmsg(my_domain_socket_, &message, 0);
+  RELEASE_ASSERT(rc != -1, "");
+}
+
 void HotRestartImpl::onGetListenSocket(RpcGetListenSocketRequest& rpc) {
   RpcGetListenSocketReply reply;
-  reply.fd_ = -1;
-
   Network::Address::InstanceConstSharedPtr addr =
       Network::Utility::resolveUrl(std::string(rpc.address_));
-  for (const auto& listener : server_->listenerManager().listeners()) {
-    if (*listener.get().socket().localAddress() == *addr) {
-      reply.fd_ = listener.get().socket().fd();
-      break;
-    }
-  }
+  reply.fd_ = server_->listenerManager().listenSocketFd(*addr, rpc.worker_index_);
 
   if (reply.fd_ == -1) {
     // In this case there is no fd to duplicate so we just send a normal message.
     sendMessage(child_address_, reply);
   } else {
-    iovec iov[1];
-    iov[0].iov_base = &reply;
-    iov[0].iov_len = reply.length_;
-
-    uint8_t control_buffer[CMSG_SPACE(sizeof(int))];
-    memset(control_buffer, 0, CMSG_SPACE(sizeof(int)));
-
-    msghdr message;
-    memset(&message, 0, sizeof(message));
-    message.msg_name = &child_address_;
-    message.msg_namelen = sizeof(child_address_);
-    message.msg_iov = iov;
-    message.msg_iovlen = 1;
-    message.msg_control = control_buffer;
-    message.msg_controllen = CMSG_SPACE(sizeof(int));
-
-    cmsghdr* control_message = CMSG_FIRSTHDR(&message);
-    control_message->cmsg_level = SOL_SOCKET;
-    control_message->cmsg_type = SCM_RIGHTS;
-    control_message->cmsg_len = CMSG_LEN(sizeof(int));
-    *reinterpret_cast<int*>(CMSG_DATA(control_message)) = reply.fd_;
-
-    int rc = sendmsg(my_domain_socket_, &message, 0);
-    RELEASE_ASSERT(rc != -1, "");
+    const int fd = reply.fd_;
+    sendMessageWithFds(child_address_, reply, &fd, 1);
   }
 }
 
+void HotRestartImpl::onTransferConnections() {
+  // The child asks repeatedly until it gets an empty reply, so the connections are only released
+  // on its first request.
+  if (!connections_released_) {
+    released_connection_fds_ = server_->listenerManager().releaseIdleConnections();
+    connections_released_ = true;
+  }
+
+  RpcTransferConnectionsReply reply;
+  reply.num_fds_ = std::min<size_t>(released_connection_fds_.size(), MaxFdsPerTransfer);
+  if (reply.num_fds_ == 0) {
+    sendMessage(child_address_, reply);
+    return;
+  }
+
+  // The fds in the reply are filled in from the control data by the child.
+  sendMessageWithFds(child_address_, reply, released_connection_fds_.data(), reply.num_fds_);
+  // The child has its own copies now.
+  for (uint32_t i = 0; i < reply.num_fds_; i++) {
+    ::close(released_connection_fds_[i]);
+  }
+  released_connection_fds_.erase(released_connection_fds_.begin(),
+                                 released_connection_fds_.begin() + reply.num_fds_);
+}
+
 void HotRestartImpl::onSocketEvent() {
   while (true) {
     RpcBase* base_message = receiveRpc(false);
@@ -435,6 +590,11 @@ void HotRestartImpl::onSocketEvent() {
       break;
     }
 
+    case RpcMessageType::TransferConnectionsRequest: {
+      onTransferConnections();
+      break;
+    }
+
     case RpcMessageType::DrainListenersRequest: {
       server_->drainListeners();
       break;
@@ -483,30 +643,20 @@ void HotRestartImpl::shutdown() { socket_event_.reset(); }
 
 std::string HotRestartImpl::version() {
   Thread::LockGuard lock(stat_lock_);
-  return versionHelper(shmem_.maxStats(), options_.statsOptions(), *stats_set_);
+  return versionHelper(shmem_.maxStats(), options_.statsOptions());
 }
 
-// Called from envoy --hot-restart-version -- needs to instantiate a RawStatDataSet so it
-// can generate the version string.
+// Called from envoy --hot-restart-version, which doesn't create the stats set.
 std::string HotRestartImpl::hotRestartVersion(uint64_t max_num_stats, uint64_t max_stat_name_len) {
   Stats::StatsOptionsImpl stats_options;
   stats_options.max_obj_name_length_ = max_stat_name_len - stats_options.maxStatSuffixLength();
-
-  const BlockMemoryHashSetOptions hash_set_options = blockMemHashOptions(max_num_stats);
-  const uint64_t bytes = RawStatDataSet::numBytes(hash_set_options, stats_options);
-  std::unique_ptr<uint8_t[]> mem_buffer_for_dry_run_(new uint8_t[bytes]);
-
-  RawStatDataSet stats_set(hash_set_options, true /* init */, mem_buffer_for_dry_run_.get(),
-                           stats_options);
-
-  return versionHelper(max_num_stats, stats_options, stats_set);
+  return versionHelper(max_num_stats, stats_options);
 }
 
 std::string HotRestartImpl::versionHelper(uint64_t max_num_stats,
-                                          const Stats::StatsOptions& stats_options,
-                                          RawStatDataSet& stats_set) {
+                                          const Stats::StatsOptions& stats_options) {
   return SharedMemory::version(max_num_stats, stats_options) + "." +
-         stats_set.version(stats_options);
+         RawStatDataSet::version(statsSetOptions(max_num_stats), stats_options);
 }
 
 } // namespace Server
@@ -7,19 +7,20 @@
 #include <atomic>
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "envoy/server/hot_restart.h"
 #include "envoy/server/options.h"
 #include "envoy/stats/stats_options.h"
 
 #include "common/common/assert.h"
-#include "common/common/block_memory_hash_set.h"
+#include "common/common/segmented_memory_hash_set.h"
 #include "common/stats/raw_stat_data.h"
 
 namespace Envoy {
 namespace Server {
 
-typedef BlockMemoryHashSet<Stats::RawStatData> RawStatDataSet;
+typedef SegmentedMemoryHashSet<Stats::RawStatData> RawStatDataSet;
 
 /**
  * Shared memory segment. This structure is laid directly into shared memory and is used amongst
@@ -65,7 +66,9 @@ private:
   pthread_mutex_t access_log_lock_;
   pthread_mutex_t stat_lock_;
   pthread_mutex_t init_lock_;
-  alignas(BlockMemoryHashSet<Stats::RawStatData>) uint8_t stats_set_data_[];
+  // Control block of the stats set. The stats themselves live in separate shared memory segments,
+  // which are created as the set grows.
+  alignas(RawStatDataSet) uint8_t stats_set_data_[];
 
   friend class HotRestartImpl;
 };
@@ -116,13 +119,15 @@ private:
  */
 class HotRestartImpl : public HotRestart,
                        public Stats::RawStatDataAllocator,
+                       public MemorySegmentMapper,
                        Logger::Loggable<Logger::Id::main> {
 public:
   HotRestartImpl(Options& options);
 
   // Server::HotRestart
   void drainParentListeners() override;
-  int duplicateParentListenSocket(const std::string& address) override;
+  int duplicateParentListenSocket(const std::string& address, uint32_t worker_index) override;
+  void transferParentConnections() override;
   void getParentStats(GetParentStatsInfo& info) override;
   void initialize(Event::Dispatcher& dispatcher, Server::Instance& server) override;
   void shutdownParentAdmin(ShutdownParentAdminInfo& info) override;
@@ -143,6 +148,9 @@ public:
   Stats::RawStatData* alloc(absl::string_view name) override;
   void free(Stats::RawStatData& data) override;
 
+  // MemorySegmentMapper
+  uint8_t* mapSegment(uint32_t index, uint64_t size, bool create) override;
+
 private:
   enum class RpcMessageType {
     DrainListenersRequest = 1,
@@ -153,9 +161,15 @@ private:
     TerminateRequest = 6,
     UnknownRequestReply = 7,
     GetStatsRequest = 8,
-    GetStatsReply = 9
+    GetStatsReply = 9,
+    TransferConnectionsRequest = 10,
+    TransferConnectionsReply = 11
   };
 
+  // The number of connection fds passed in a single TransferConnectionsReply, well below the
+  // SCM_RIGHTS limit of the kernel.
+  static constexpr uint32_t MaxFdsPerTransfer = 64;
+
   struct RpcBase {
     RpcBase(RpcMessageType type, uint64_t length = sizeof(RpcBase))
         : type_(type), length_(length) {}
@@ -168,6 +182,7 @@ private:
     RpcGetListenSocketRequest() : RpcBase(RpcMessageType::GetListenSocketRequest, sizeof(*this)) {}
 
     char address_[256]{0};
+    uint32_t worker_index_{0};
   } __attribute__((packed));
 
   struct RpcGetListenSocketReply : public RpcBase {
@@ -190,6 +205,15 @@ private:
     uint64_t unused_[16]{0};
   } __attribute__((packed));
 
+  struct RpcTransferConnectionsReply : public RpcBase {
+    RpcTransferConnectionsReply()
+        : RpcBase(RpcMessageType::TransferConnectionsReply, sizeof(*this)) {}
+
+    // Zero once the parent has no more connections to hand over.
+    uint32_t num_fds_{0};
+    int fds_[MaxFdsPerTransfer]{};
+  } __attribute__((packed));
+
   template <class rpc_class, RpcMessageType rpc_type> rpc_class* receiveTypedRpc() {
     RpcBase* base_message = receiveRpc(true);
     RELEASE_ASSERT(base_message->length_ == sizeof(rpc_class), "");
@@ -201,14 +225,16 @@ private:
   void initDomainSocketAddress(sockaddr_un* address);
   sockaddr_un createDomainSocketAddress(uint64_t id);
   void onGetListenSocket(RpcGetListenSocketRequest& rpc);
+  void onTransferConnections();
   void onSocketEvent();
   RpcBase* receiveRpc(bool block);
   void sendMessage(sockaddr_un& address, RpcBase& rpc);
-  static std::string versionHelper(uint64_t max_num_stats, const Stats::StatsOptions& stats_options,
-                                   RawStatDataSet& stats_set);
+  void sendMessageWithFds(sockaddr_un& address, RpcBase& rpc, const int* fds, uint32_t num_fds);
+  static std::string versionHelper(uint64_t max_num_stats,
+                                   const Stats::StatsOptions& stats_options);
 
   Options& options_;
-  BlockMemoryHashSetOptions stats_set_options_;
+  SegmentedMemoryHashSetOptions stats_set_options_;
   SharedMemory& shmem_;
   std::unique_ptr<RawStatDataSet> stats_set_ GUARDED_BY(stat_lock_);
   ProcessSharedMutex log_lock_;
@@ -222,6 +248,9 @@ private:
   std::array<uint8_t, 4096> rpc_buffer_;
   Server::Instance* server_{};
   bool parent_terminated_{};
+  // Connections released for the child that have not been sent to it yet.
+  std::vector<int> released_connection_fds_;
+  bool connections_released_{};
 };
 
 } // namespace Server
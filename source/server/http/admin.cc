@@ -1,8 +1,13 @@
 #include "server/http/admin.h"
 
 #include <algorithm>
+#include <cctype>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
+#include <limits>
+#include <memory>
+#include <regex>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -28,6 +33,7 @@
 #include "common/common/assert.h"
 #include "common/common/enum_to_int.h"
 #include "common/common/fmt.h"
+#include "common/common/lock_guard.h"
 #include "common/common/utility.h"
 #include "common/common/version.h"
 #include "common/html/utility.h"
@@ -36,6 +42,7 @@
 #include "common/http/headers.h"
 #include "common/http/http1/codec_impl.h"
 #include "common/json/json_loader.h"
+#include "common/memory/accounting.h"
 #include "common/memory/stats.h"
 #include "common/network/listen_socket_impl.h"
 #include "common/network/utility.h"
@@ -46,9 +53,11 @@
 
 #include "extensions/access_loggers/file/file_access_log_impl.h"
 
+#include "absl/strings/match.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_replace.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 
 // TODO(mattklein123): Switch to JSON interface methods and remove rapidjson dependency.
 #include "rapidjson/document.h"
@@ -147,6 +156,267 @@ void populateFallbackResponseHeaders(Http::Code code, Http::HeaderMap& header_ma
   header_map.addReference(headers.XContentTypeOptions, headers.XContentTypeOptionValues.Nosniff);
 }
 
+// Number of stats formatted per dispatcher iteration when streaming stats output.
+constexpr uint64_t StatsPerChunk = 1000;
+
+/**
+ * Filter on stat names from the filter= query parameter of the stats handlers. The filter is a
+ * regular expression that may match anywhere in the name. Filters that are just a literal,
+ * possibly anchored with '^', are matched as a substring or prefix instead, which avoids running
+ * the regex engine over every stat for the common case of selecting a subtree.
+ */
+class StatsFilter {
+public:
+  /**
+   * @param filter supplies the regular expression.
+   * @throw EnvoyException if filter is not a valid regular expression.
+   */
+  StatsFilter(const std::string& filter) {
+    prefix_ = absl::StartsWith(filter, "^");
+    for (size_t i = prefix_ ? 1 : 0; i < filter.size(); i++) {
+      if (filter[i] == '\\' && i + 1 < filter.size() &&
+          std::ispunct(static_cast<unsigned char>(filter[i + 1]))) {
+        literal_.push_back(filter[++i]);
+      } else if (std::strchr("^$\\.*+?()[]{}|", filter[i]) != nullptr) {
+        regex_ = RegexUtil::parseRegex(filter);
+        return;
+      } else {
+        literal_.push_back(filter[i]);
+      }
+    }
+  }
+
+  bool matches(const std::string& name) const {
+    if (regex_.has_value()) {
+      return std::regex_search(name, regex_.value());
+    }
+    return prefix_ ? absl::StartsWith(name, literal_) : absl::StrContains(name, literal_);
+  }
+
+private:
+  absl::optional<std::regex> regex_;
+  std::string literal_;
+  bool prefix_{};
+};
+
+/**
+ * Parse the filter= query parameter of the stats handlers, if present.
+ * @return bool false, after writing an error to response, if the filter is not valid.
+ */
+bool parseStatsFilter(const Http::Utility::QueryParams& params,
+                      absl::optional<StatsFilter>& filter, Buffer::Instance& response) {
+  const auto it = params.find("filter");
+  if (it == params.end()) {
+    return true;
+  }
+  try {
+    filter.emplace(it->second);
+  } catch (const EnvoyException& e) {
+    response.add(fmt::format("{}\n", e.what()));
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Parse an optional non-negative integer query parameter, leaving value untouched if the parameter
+ * is absent.
+ * @return bool false, after writing an error to response, if the parameter is not a number.
+ */
+bool parseUintParam(const Http::Utility::QueryParams& params, const std::string& name,
+                    uint64_t& value, Buffer::Instance& response) {
+  const auto it = params.find(name);
+  if (it != params.end() && !StringUtil::atoul(it->second.c_str(), value)) {
+    response.add(fmt::format("invalid {}: {}\n", name, it->second));
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Split a comma separated query parameter into its values.
+ */
+std::vector<std::string> parseListParam(const Http::Utility::QueryParams& params,
+                                        const std::string& name) {
+  std::vector<std::string> values;
+  const auto it = params.find(name);
+  if (it != params.end()) {
+    for (absl::string_view value : StringUtil::splitToken(it->second, ",")) {
+      values.emplace_back(value);
+    }
+  }
+  return values;
+}
+
+/**
+ * Clear the fields of a message that are not selected by a field mask. Each path is a dot
+ * separated list of field names, and selects the named field along with everything below it.
+ * Unlike Protobuf::util::FieldMaskUtil, paths descend into repeated message fields, applying to
+ * each element, since most of the interesting parts of a config dump are repeated.
+ */
+void trimMessage(Protobuf::Message& message, const std::vector<absl::string_view>& paths) {
+  // The paths below each selected field. A field selected as a whole has an empty path below it.
+  std::unordered_map<absl::string_view, std::vector<absl::string_view>, StringViewHash> children;
+  for (absl::string_view path : paths) {
+    const size_t dot = path.find('.');
+    if (dot == absl::string_view::npos) {
+      children[path].emplace_back();
+    } else {
+      children[path.substr(0, dot)].push_back(path.substr(dot + 1));
+    }
+  }
+
+  const Protobuf::Descriptor* descriptor = message.GetDescriptor();
+  const Protobuf::Reflection* reflection = message.GetReflection();
+  for (int i = 0; i < descriptor->field_count(); i++) {
+    const Protobuf::FieldDescriptor* field = descriptor->field(i);
+    const auto it = children.find(field->name());
+    if (it == children.end()) {
+      reflection->ClearField(&message, field);
+      continue;
+    }
+    const std::vector<absl::string_view>& sub_paths = it->second;
+    if (field->cpp_type() != Protobuf::FieldDescriptor::CPPTYPE_MESSAGE ||
+        std::find(sub_paths.begin(), sub_paths.end(), absl::string_view()) != sub_paths.end()) {
+      continue;
+    }
+    if (field->is_repeated()) {
+      for (int j = 0; j < reflection->FieldSize(message, field); j++) {
+        trimMessage(*reflection->MutableRepeatedMessage(&message, field, j), sub_paths);
+      }
+    } else if (reflection->HasField(message, field)) {
+      trimMessage(*reflection->MutableMessage(&message, field), sub_paths);
+    }
+  }
+}
+
+template <class StatType>
+std::vector<std::shared_ptr<StatType>> filterStats(std::vector<std::shared_ptr<StatType>>&& stats,
+                                                   const absl::optional<StatsFilter>& filter) {
+  if (filter.has_value()) {
+    stats.erase(std::remove_if(stats.begin(), stats.end(),
+                               [&filter](const std::shared_ptr<StatType>& stat) {
+                                 return !filter->matches(stat->name());
+                               }),
+                stats.end());
+  }
+  return std::move(stats);
+}
+
+/**
+ * Collect the names and values of the counters and gauges selected by a /stats request. Stats are
+ * filtered before anything is formatted, so that a narrow filter keeps the cost of the request
+ * proportional to its output. This is safe to call from any thread.
+ */
+void collectStats(Stats::Store& store, bool show_all, const absl::optional<StatsFilter>& filter,
+                  std::vector<std::pair<std::string, uint64_t>>& stats) {
+  for (const Stats::CounterSharedPtr& counter : store.counters()) {
+    if (show_all || counter->used()) {
+      std::string name = counter->name();
+      if (!filter.has_value() || filter->matches(name)) {
+        stats.emplace_back(std::move(name), counter->value());
+      }
+    }
+  }
+
+  for (const Stats::GaugeSharedPtr& gauge : store.gauges()) {
+    if (show_all || gauge->used()) {
+      std::string name = gauge->name();
+      if (!filter.has_value() || filter->matches(name)) {
+        stats.emplace_back(std::move(name), gauge->value());
+      }
+    }
+  }
+}
+
+/**
+ * The stats selected by a /stats request, formatted as plain text a chunk at a time. The counters
+ * and gauges are collected along with the first chunk, possibly on the render thread. Histogram
+ * summaries are taken when the request is handled instead, since the main thread merges them.
+ */
+struct StatsSnapshot {
+  StatsSnapshot(Stats::Store& store, bool show_all, const absl::optional<StatsFilter>& filter,
+                bool sorted)
+      : store_(store), show_all_(show_all), filter_(filter), sorted_(sorted) {}
+
+  bool nextPlainChunk(Buffer::Instance& response) {
+    if (!collected_) {
+      collectStats(store_, show_all_, filter_, stats_);
+      // Sorting millions of stats is a noticeable part of the cost of the request, so clients
+      // that do not need the output in order can skip it.
+      if (sorted_) {
+        std::sort(stats_.begin(), stats_.end());
+      }
+      collected_ = true;
+    }
+
+    for (uint64_t i = 0; i < StatsPerChunk; i++) {
+      if (next_stat_ < stats_.size()) {
+        const auto& stat = stats_[next_stat_++];
+        response.add(fmt::format("{}: {}\n", stat.first, stat.second));
+      } else if (next_histogram_ < histograms_.size()) {
+        const auto& histogram = histograms_[next_histogram_++];
+        response.add(fmt::format("{}: {}\n", histogram.first, histogram.second));
+      } else {
+        return true;
+      }
+    }
+    return next_stat_ == stats_.size() && next_histogram_ == histograms_.size();
+  }
+
+  Stats::Store& store_;
+  const bool show_all_;
+  const absl::optional<StatsFilter> filter_;
+  const bool sorted_;
+  bool collected_{};
+  std::vector<std::pair<std::string, uint64_t>> stats_;
+  // Histogram names and summaries.
+  std::vector<std::pair<std::string, std::string>> histograms_;
+  size_t next_stat_{};
+  size_t next_histogram_{};
+};
+
+/**
+ * The stats selected by a Prometheus scrape, formatted a chunk at a time. The stats are collected
+ * along with the first chunk, possibly on the render thread.
+ */
+struct PrometheusStatsSnapshot {
+  PrometheusStatsSnapshot(Stats::Store& store, const absl::optional<StatsFilter>& filter)
+      : store_(store), filter_(filter) {}
+
+  bool nextChunk(Buffer::Instance& response) {
+    if (!collected_) {
+      counters_ = filterStats(store_.counters(), filter_);
+      gauges_ = filterStats(store_.gauges(), filter_);
+      collected_ = true;
+    }
+
+    for (uint64_t i = 0; i < StatsPerChunk; i++) {
+      if (next_counter_ < counters_.size()) {
+        const Stats::Counter& counter = *counters_[next_counter_++];
+        PrometheusStatsFormatter::formatMetric(counter, counter.value(), "counter",
+                                               metric_type_tracker_, response);
+      } else if (next_gauge_ < gauges_.size()) {
+        const Stats::Gauge& gauge = *gauges_[next_gauge_++];
+        PrometheusStatsFormatter::formatMetric(gauge, gauge.value(), "gauge", metric_type_tracker_,
+                                               response);
+      } else {
+        return true;
+      }
+    }
+    return next_counter_ == counters_.size() && next_gauge_ == gauges_.size();
+  }
+
+  Stats::Store& store_;
+  const absl::optional<StatsFilter> filter_;
+  bool collected_{};
+  std::vector<Stats::CounterSharedPtr> counters_;
+  std::vector<Stats::GaugeSharedPtr> gauges_;
+  std::unordered_set<std::string> metric_type_tracker_;
+  size_t next_counter_{};
+  size_t next_gauge_{};
+};
+
 } // namespace
 
 AdminFilter::AdminFilter(AdminImpl& parent) : parent_(parent) {}
@@ -174,6 +444,18 @@ Http::FilterTrailersStatus AdminFilter::decodeTrailers(Http::HeaderMap&) {
 }
 
 void AdminFilter::onDestroy() {
+  if (next_chunk_ != nullptr && chunk_timer_ != nullptr) {
+    // The stream went away before a streamed response was complete.
+    next_chunk_ = nullptr;
+    chunk_timer_->disableTimer();
+    callbacks_->removeDownstreamWatermarkCallbacks(*this);
+  }
+  if (off_thread_response_ != nullptr) {
+    // A chunk may still be rendering. It is dropped when it gets back to the main thread.
+    off_thread_response_->filter_ = nullptr;
+    off_thread_response_ = nullptr;
+    callbacks_->removeDownstreamWatermarkCallbacks(*this);
+  }
   for (const auto& callback : on_destroy_callbacks_) {
     callback();
   }
@@ -264,13 +546,13 @@ void AdminImpl::addCircuitSettings(const std::string& cluster_name, const std::s
                            resource_manager.retries().max()));
 }
 
-void AdminImpl::writeClustersAsJson(Buffer::Instance& response) {
-  envoy::admin::v2alpha::Clusters clusters;
-  for (auto& cluster_pair : server_.clusterManager().clusters()) {
-    const Upstream::Cluster& cluster = cluster_pair.second.get();
+void AdminImpl::writeClustersAsProto(const std::vector<const Upstream::Cluster*>& clusters,
+                                     envoy::admin::v2alpha::Clusters& response) {
+  for (const Upstream::Cluster* cluster_ptr : clusters) {
+    const Upstream::Cluster& cluster = *cluster_ptr;
     Upstream::ClusterInfoConstSharedPtr cluster_info = cluster.info();
 
-    envoy::admin::v2alpha::ClusterStatus& cluster_status = *clusters.add_cluster_statuses();
+    envoy::admin::v2alpha::ClusterStatus& cluster_status = *response.add_cluster_statuses();
     cluster_status.set_name(cluster_info->name());
 
     const Upstream::Outlier::Detector* outlier_detector = cluster.outlierDetector();
@@ -336,25 +618,23 @@ void AdminImpl::writeClustersAsJson(Buffer::Instance& response) {
       }
     }
   }
-  response.add(MessageUtil::getJsonStringFromMessage(clusters, true)); // pretty-print
 }
 
-void AdminImpl::writeClustersAsText(Buffer::Instance& response) {
-  for (auto& cluster : server_.clusterManager().clusters()) {
-    addOutlierInfo(cluster.second.get().info()->name(), cluster.second.get().outlierDetector(),
-                   response);
-
-    addCircuitSettings(
-        cluster.second.get().info()->name(), "default",
-        cluster.second.get().info()->resourceManager(Upstream::ResourcePriority::Default),
-        response);
-    addCircuitSettings(
-        cluster.second.get().info()->name(), "high",
-        cluster.second.get().info()->resourceManager(Upstream::ResourcePriority::High), response);
-
-    response.add(fmt::format("{}::added_via_api::{}\n", cluster.second.get().info()->name(),
-                             cluster.second.get().info()->addedViaApi()));
-    for (auto& host_set : cluster.second.get().prioritySet().hostSetsPerPriority()) {
+void AdminImpl::writeClustersAsText(const std::vector<const Upstream::Cluster*>& clusters,
+                                    Buffer::Instance& response) {
+  for (const Upstream::Cluster* cluster : clusters) {
+    addOutlierInfo(cluster->info()->name(), cluster->outlierDetector(), response);
+
+    addCircuitSettings(cluster->info()->name(), "default",
+                       cluster->info()->resourceManager(Upstream::ResourcePriority::Default),
+                       response);
+    addCircuitSettings(cluster->info()->name(), "high",
+                       cluster->info()->resourceManager(Upstream::ResourcePriority::High),
+                       response);
+
+    response.add(fmt::format("{}::added_via_api::{}\n", cluster->info()->name(),
+                             cluster->info()->addedViaApi()));
+    for (auto& host_set : cluster->prioritySet().hostSetsPerPriority()) {
       for (auto& host : host_set->hosts()) {
         std::map<std::string, uint64_t> all_stats;
         for (const Stats::CounterSharedPtr& counter : host->counters()) {
@@ -366,24 +646,24 @@ void AdminImpl::writeClustersAsText(Buffer::Instance& response) {
         }
 
         for (auto stat : all_stats) {
-          response.add(fmt::format("{}::{}::{}::{}\n", cluster.second.get().info()->name(),
+          response.add(fmt::format("{}::{}::{}::{}\n", cluster->info()->name(),
                                    host->address()->asString(), stat.first, stat.second));
         }
 
-        response.add(fmt::format("{}::{}::health_flags::{}\n", cluster.second.get().info()->name(),
+        response.add(fmt::format("{}::{}::health_flags::{}\n", cluster->info()->name(),
                                  host->address()->asString(),
                                  Upstream::HostUtility::healthFlagsToString(*host)));
-        response.add(fmt::format("{}::{}::weight::{}\n", cluster.second.get().info()->name(),
+        response.add(fmt::format("{}::{}::weight::{}\n", cluster->info()->name(),
                                  host->address()->asString(), host->weight()));
-        response.add(fmt::format("{}::{}::region::{}\n", cluster.second.get().info()->name(),
+        response.add(fmt::format("{}::{}::region::{}\n", cluster->info()->name(),
                                  host->address()->asString(), host->locality().region()));
-        response.add(fmt::format("{}::{}::zone::{}\n", cluster.second.get().info()->name(),
+        response.add(fmt::format("{}::{}::zone::{}\n", cluster->info()->name(),
                                  host->address()->asString(), host->locality().zone()));
-        response.add(fmt::format("{}::{}::sub_zone::{}\n", cluster.second.get().info()->name(),
+        response.add(fmt::format("{}::{}::sub_zone::{}\n", cluster->info()->name(),
                                  host->address()->asString(), host->locality().sub_zone()));
-        response.add(fmt::format("{}::{}::canary::{}\n", cluster.second.get().info()->name(),
+        response.add(fmt::format("{}::{}::canary::{}\n", cluster->info()->name(),
                                  host->address()->asString(), host->canary()));
-        response.add(fmt::format("{}::{}::success_rate::{}\n", cluster.second.get().info()->name(),
+        response.add(fmt::format("{}::{}::success_rate::{}\n", cluster->info()->name(),
                                  host->address()->asString(),
                                  host->outlierDetector().successRate()));
       }
@@ -393,37 +673,95 @@ void AdminImpl::writeClustersAsText(Buffer::Instance& response) {
 
 Http::Code AdminImpl::handlerClusters(absl::string_view url, Http::HeaderMap& response_headers,
                                       Buffer::Instance& response, AdminStream&) {
-  Http::Utility::QueryParams query_params = Http::Utility::parseQueryString(url);
-  auto it = query_params.find("format");
+  const Http::Utility::QueryParams query_params = Http::Utility::parseQueryString(url);
+  absl::optional<StatsFilter> filter;
+  uint64_t offset = 0;
+  uint64_t limit = std::numeric_limits<uint64_t>::max();
+  if (!parseStatsFilter(query_params, filter, response) ||
+      !parseUintParam(query_params, "offset", offset, response) ||
+      !parseUintParam(query_params, "limit", limit, response)) {
+    return Http::Code::BadRequest;
+  }
 
-  if (it != query_params.end() && it->second == "json") {
-    writeClustersAsJson(response);
-    response_headers.insertContentType().value().setReference(
-        Http::Headers::get().ContentTypeValues.Json);
+  // Clusters are paged through in name order, so that pages don't overlap as long as the set of
+  // clusters doesn't change.
+  std::vector<const Upstream::Cluster*> clusters;
+  for (auto& cluster_pair : server_.clusterManager().clusters()) {
+    if (!filter.has_value() || filter->matches(cluster_pair.first)) {
+      clusters.push_back(&cluster_pair.second.get());
+    }
+  }
+  std::sort(clusters.begin(), clusters.end(),
+            [](const Upstream::Cluster* a, const Upstream::Cluster* b) -> bool {
+              return a->info()->name() < b->info()->name();
+            });
+  clusters.erase(clusters.begin(), clusters.begin() + std::min<uint64_t>(offset, clusters.size()));
+  if (clusters.size() > limit) {
+    clusters.erase(clusters.begin() + limit, clusters.end());
+  }
+
+  const auto it = query_params.find("format");
+  if (it != query_params.end() && (it->second == "json" || it->second == "proto")) {
+    envoy::admin::v2alpha::Clusters clusters_proto;
+    writeClustersAsProto(clusters, clusters_proto);
+    writeMessage(clusters_proto, it->second == "proto", response_headers, response);
   } else {
-    writeClustersAsText(response);
+    writeClustersAsText(clusters, response);
   }
 
   return Http::Code::OK;
 }
 
-// TODO(jsedgwick) Use query params to list available dumps, selectively dump, etc
-Http::Code AdminImpl::handlerConfigDump(absl::string_view, Http::HeaderMap& response_headers,
+Http::Code AdminImpl::handlerConfigDump(absl::string_view url, Http::HeaderMap& response_headers,
                                         Buffer::Instance& response, AdminStream&) const {
+  const Http::Utility::QueryParams query_params = Http::Utility::parseQueryString(url);
+  const std::vector<std::string> resources = parseListParam(query_params, "resource");
+  const std::vector<std::string> mask = parseListParam(query_params, "mask");
+  const std::vector<absl::string_view> mask_paths(mask.begin(), mask.end());
+
+  const ConfigTracker::CbsMap& callbacks_map = config_tracker_.getCallbacksMap();
+  for (const std::string& resource : resources) {
+    if (callbacks_map.find(resource) == callbacks_map.end()) {
+      response.add(fmt::format("unknown resource: {}\n", resource));
+      return Http::Code::NotFound;
+    }
+  }
+
+  // Only the selected dumps are produced, since some of them are expensive to build.
   envoy::admin::v2alpha::ConfigDump dump;
-  for (const auto& key_callback_pair : config_tracker_.getCallbacksMap()) {
+  for (const auto& key_callback_pair : callbacks_map) {
+    if (!resources.empty() &&
+        std::find(resources.begin(), resources.end(), key_callback_pair.first) == resources.end()) {
+      continue;
+    }
     ProtobufTypes::MessagePtr message = key_callback_pair.second();
     RELEASE_ASSERT(message, "");
+    if (!mask_paths.empty()) {
+      trimMessage(*message, mask_paths);
+    }
     auto& any_message = *(dump.add_configs());
     any_message.PackFrom(*message);
   }
 
-  response_headers.insertContentType().value().setReference(
-      Http::Headers::get().ContentTypeValues.Json);
-  response.add(MessageUtil::getJsonStringFromMessage(dump, true)); // pretty-print
+  const auto it = query_params.find("format");
+  writeMessage(dump, it != query_params.end() && it->second == "proto", response_headers,
+               response);
   return Http::Code::OK;
 }
 
+void AdminImpl::writeMessage(const Protobuf::Message& message, bool binary,
+                             Http::HeaderMap& response_headers, Buffer::Instance& response) {
+  if (binary) {
+    response_headers.insertContentType().value().setReference(
+        Http::Headers::get().ContentTypeValues.Protobuf);
+    response.add(message.SerializeAsString());
+  } else {
+    response_headers.insertContentType().value().setReference(
+        Http::Headers::get().ContentTypeValues.Json);
+    response.add(MessageUtil::getJsonStringFromMessage(message, true)); // pretty-print
+  }
+}
+
 Http::Code AdminImpl::handlerCpuProfiler(absl::string_view url, Http::HeaderMap&,
                                          Buffer::Instance& response, AdminStream&) {
   Http::Utility::QueryParams query_params = Http::Utility::parseQueryString(url);
@@ -500,6 +838,10 @@ Http::Code AdminImpl::handlerMemory(absl::string_view, Http::HeaderMap&, Buffer:
   envoy::admin::v2alpha::Memory memory;
   memory.set_allocated(Memory::Stats::totalCurrentlyAllocated());
   memory.set_heap_size(Memory::Stats::totalCurrentlyReserved());
+  for (uint64_t i = 0; i < Memory::Accounting::NumTags; i++) {
+    const Memory::Tag tag = static_cast<Memory::Tag>(i);
+    (*memory.mutable_accounted())[Memory::Accounting::name(tag)] = Memory::Accounting::bytes(tag);
+  }
   response.add(MessageUtil::getJsonStringFromMessage(memory, true)); // pretty-print
   return Http::Code::OK;
 }
@@ -532,17 +874,22 @@ Http::Code AdminImpl::handlerStats(absl::string_view url, Http::HeaderMap& respo
 
   const bool show_all = params.find("usedonly") == params.end();
   const bool has_format = !(params.find("format") == params.end());
+  absl::optional<StatsFilter> filter;
+  if (!parseStatsFilter(params, filter, response)) {
+    return Http::Code::BadRequest;
+  }
 
-  std::map<std::string, uint64_t> all_stats;
-  for (const Stats::CounterSharedPtr& counter : server_.stats().counters()) {
-    if (show_all || counter->used()) {
-      all_stats.emplace(counter->name(), counter->value());
-    }
+  if (has_format && params.at("format") == "prometheus") {
+    return handlerPrometheusStats(url, response_headers, response, admin_stream);
   }
 
-  for (const Stats::GaugeSharedPtr& gauge : server_.stats().gauges()) {
-    if (show_all || gauge->used()) {
-      all_stats.emplace(gauge->name(), gauge->value());
+  std::vector<std::pair<std::string, Stats::ParentHistogramSharedPtr>> histograms;
+  for (const Stats::ParentHistogramSharedPtr& histogram : server_.stats().histograms()) {
+    if (show_all || histogram->used()) {
+      std::string name = histogram->name();
+      if (!filter.has_value() || filter->matches(name)) {
+        histograms.emplace_back(std::move(name), histogram);
+      }
     }
   }
 
@@ -551,38 +898,54 @@ Http::Code AdminImpl::handlerStats(absl::string_view url, Http::HeaderMap& respo
     if (format_value == "json") {
       response_headers.insertContentType().value().setReference(
           Http::Headers::get().ContentTypeValues.Json);
-      response.add(AdminImpl::statsAsJson(all_stats, server_.stats().histograms(), show_all));
-    } else if (format_value == "prometheus") {
-      return handlerPrometheusStats(url, response_headers, response, admin_stream);
+      std::vector<std::pair<std::string, uint64_t>> stats;
+      collectStats(server_.stats(), show_all, filter, stats);
+      const std::map<std::string, uint64_t> all_stats(stats.begin(), stats.end());
+      std::vector<Stats::ParentHistogramSharedPtr> all_histograms;
+      for (const auto& histogram : histograms) {
+        all_histograms.push_back(histogram.second);
+      }
+      response.add(AdminImpl::statsAsJson(all_stats, all_histograms, show_all));
     } else {
       response.add("usage: /stats?format=json  or /stats?format=prometheus \n");
       response.add("\n");
       rc = Http::Code::NotFound;
     }
   } else { // Display plain stats if format query param is not there.
-    for (auto stat : all_stats) {
-      response.add(fmt::format("{}: {}\n", stat.first, stat.second));
-    }
-    // TOOD(ramaraochavali): See the comment in ThreadLocalStoreImpl::histograms() for why we use a
-    // multimap here. This makes sure that duplicate histograms get output. When shared storage is
-    // implemented this can be switched back to a normal map.
-    std::multimap<std::string, std::string> all_histograms;
-    for (const Stats::ParentHistogramSharedPtr& histogram : server_.stats().histograms()) {
-      if (show_all || histogram->used()) {
-        all_histograms.emplace(histogram->name(), histogram->summary());
-      }
+    const bool sorted = params.find("unsorted") == params.end();
+    auto snapshot = std::make_shared<StatsSnapshot>(server_.stats(), show_all, filter, sorted);
+    if (sorted) {
+      // TODO(ramaraochavali): See the comment in ThreadLocalStoreImpl::histograms() for why
+      // duplicate histograms are kept here. When shared storage is implemented they can be
+      // dropped.
+      std::stable_sort(
+          histograms.begin(), histograms.end(),
+          [](const std::pair<std::string, Stats::ParentHistogramSharedPtr>& a,
+             const std::pair<std::string, Stats::ParentHistogramSharedPtr>& b) -> bool {
+            return a.first < b.first;
+          });
     }
-    for (auto histogram : all_histograms) {
-      response.add(fmt::format("{}: {}\n", histogram.first, histogram.second));
+    for (const auto& histogram : histograms) {
+      snapshot->histograms_.emplace_back(histogram.first, histogram.second->summary());
     }
+    admin_stream.streamResponseOffThread(
+        [snapshot](Buffer::Instance& chunk) -> bool { return snapshot->nextPlainChunk(chunk); });
   }
   return rc;
 }
 
-Http::Code AdminImpl::handlerPrometheusStats(absl::string_view, Http::HeaderMap&,
-                                             Buffer::Instance& response, AdminStream&) {
-  PrometheusStatsFormatter::statsAsPrometheus(server_.stats().counters(), server_.stats().gauges(),
-                                              response);
+Http::Code AdminImpl::handlerPrometheusStats(absl::string_view path_and_query, Http::HeaderMap&,
+                                             Buffer::Instance& response,
+                                             AdminStream& admin_stream) {
+  const Http::Utility::QueryParams params = Http::Utility::parseQueryString(path_and_query);
+  absl::optional<StatsFilter> filter;
+  if (!parseStatsFilter(params, filter, response)) {
+    return Http::Code::BadRequest;
+  }
+
+  auto snapshot = std::make_shared<PrometheusStatsSnapshot>(server_.stats(), filter);
+  admin_stream.streamResponseOffThread(
+      [snapshot](Buffer::Instance& chunk) -> bool { return snapshot->nextChunk(chunk); });
   return Http::Code::OK;
 }
 
@@ -608,6 +971,18 @@ std::string PrometheusStatsFormatter::metricName(const std::string& extractedNam
   return fmt::format("envoy_{0}", sanitizeName(extractedName));
 }
 
+void PrometheusStatsFormatter::formatMetric(const Stats::Metric& metric, uint64_t value,
+                                            absl::string_view type,
+                                            std::unordered_set<std::string>& metric_type_tracker,
+                                            Buffer::Instance& response) {
+  const std::string tags = formattedTags(metric.tags());
+  const std::string metric_name = metricName(metric.tagExtractedName());
+  if (metric_type_tracker.insert(metric_name).second) {
+    response.add(fmt::format("# TYPE {0} {1}\n", metric_name, type));
+  }
+  response.add(fmt::format("{0}{{{1}}} {2}\n", metric_name, tags, value));
+}
+
 // TODO(ramaraochavali): Add summary histogram output for Prometheus.
 uint64_t
 PrometheusStatsFormatter::statsAsPrometheus(const std::vector<Stats::CounterSharedPtr>& counters,
@@ -615,23 +990,11 @@ PrometheusStatsFormatter::statsAsPrometheus(const std::vector<Stats::CounterShar
                                             Buffer::Instance& response) {
   std::unordered_set<std::string> metric_type_tracker;
   for (const auto& counter : counters) {
-    const std::string tags = formattedTags(counter->tags());
-    const std::string metric_name = metricName(counter->tagExtractedName());
-    if (metric_type_tracker.find(metric_name) == metric_type_tracker.end()) {
-      metric_type_tracker.insert(metric_name);
-      response.add(fmt::format("# TYPE {0} counter\n", metric_name));
-    }
-    response.add(fmt::format("{0}{{{1}}} {2}\n", metric_name, tags, counter->value()));
+    formatMetric(*counter, counter->value(), "counter", metric_type_tracker, response);
   }
 
   for (const auto& gauge : gauges) {
-    const std::string tags = formattedTags(gauge->tags());
-    const std::string metric_name = metricName(gauge->tagExtractedName());
-    if (metric_type_tracker.find(metric_name) == metric_type_tracker.end()) {
-      metric_type_tracker.insert(metric_name);
-      response.add(fmt::format("# TYPE {0} gauge\n", metric_name));
-    }
-    response.add(fmt::format("{0}{{{1}}} {2}\n", metric_name, tags, gauge->value()));
+    formatMetric(*gauge, gauge->value(), "gauge", metric_type_tracker, response);
   }
   return metric_type_tracker.size();
 }
@@ -868,6 +1231,8 @@ Http::Code AdminImpl::handlerRuntimeModify(absl::string_view url, Http::HeaderMa
 
 ConfigTracker& AdminImpl::getConfigTracker() { return config_tracker_; }
 
+void AdminImpl::startRenderThread() { render_thread_.reset(new AdminRenderThread()); }
+
 void AdminFilter::onComplete() {
   absl::string_view path = request_headers_->Path()->value().getStringView();
   ENVOY_STREAM_LOG(debug, "request complete: path: {}", *callbacks_, path);
@@ -877,11 +1242,143 @@ void AdminFilter::onComplete() {
   RELEASE_ASSERT(request_headers_, "");
   Http::Code code = parent_.runCallback(path, *header_map, response, *this);
   populateFallbackResponseHeaders(code, *header_map);
-  callbacks_->encodeHeaders(std::move(header_map),
-                            end_stream_on_complete_ && response.length() == 0);
+  const bool end_stream =
+      end_stream_on_complete_ && next_chunk_ == nullptr && off_thread_response_ == nullptr;
+  callbacks_->encodeHeaders(std::move(header_map), end_stream && response.length() == 0);
 
   if (response.length() > 0) {
-    callbacks_->encodeData(response, end_stream_on_complete_);
+    callbacks_->encodeData(response, end_stream);
+  }
+
+  if (next_chunk_ != nullptr) {
+    chunk_timer_ = callbacks_->dispatcher().createTimer([this]() -> void { onNextChunk(); });
+    callbacks_->addDownstreamWatermarkCallbacks(*this);
+    if (!above_high_watermark_) {
+      chunk_timer_->enableTimer(std::chrono::milliseconds(0));
+    }
+  } else if (off_thread_response_ != nullptr) {
+    callbacks_->addDownstreamWatermarkCallbacks(*this);
+    if (!above_high_watermark_) {
+      renderNextChunk();
+    }
+  }
+}
+
+void AdminFilter::streamResponseOffThread(ChunkCb cb) {
+  if (parent_.renderThread() == nullptr) {
+    streamResponse(cb);
+    return;
+  }
+  off_thread_response_ = std::make_shared<OffThreadResponse>(cb, *this);
+}
+
+void AdminFilter::renderNextChunk() {
+  ASSERT(!render_pending_);
+  render_pending_ = true;
+  OffThreadResponseSharedPtr response = off_thread_response_;
+  Event::Dispatcher& dispatcher = callbacks_->dispatcher();
+  parent_.renderThread()->post([response, &dispatcher]() -> void {
+    auto chunk = std::make_shared<Buffer::OwnedImpl>();
+    const bool complete = response->next_chunk_(*chunk);
+    dispatcher.post([response, chunk, complete]() -> void {
+      if (response->filter_ != nullptr) {
+        response->filter_->onChunkRendered(*chunk, complete);
+      }
+    });
+  });
+}
+
+void AdminFilter::onChunkRendered(Buffer::Instance& chunk, bool complete) {
+  render_pending_ = false;
+  if (complete) {
+    off_thread_response_ = nullptr;
+    callbacks_->removeDownstreamWatermarkCallbacks(*this);
+    callbacks_->encodeData(chunk, end_stream_on_complete_);
+    return;
+  }
+
+  callbacks_->encodeData(chunk, false);
+  // Sending may have pushed the connection over its high watermark, or reset the stream.
+  if (off_thread_response_ != nullptr && !above_high_watermark_) {
+    renderNextChunk();
+  }
+}
+
+void AdminFilter::onNextChunk() {
+  Buffer::OwnedImpl chunk;
+  if (next_chunk_(chunk)) {
+    next_chunk_ = nullptr;
+    callbacks_->removeDownstreamWatermarkCallbacks(*this);
+    callbacks_->encodeData(chunk, end_stream_on_complete_);
+    return;
+  }
+
+  callbacks_->encodeData(chunk, false);
+  // Sending may have pushed the connection over its high watermark, or reset the stream.
+  if (next_chunk_ != nullptr && !above_high_watermark_) {
+    chunk_timer_->enableTimer(std::chrono::milliseconds(0));
+  }
+}
+
+void AdminFilter::onAboveWriteBufferHighWatermark() { above_high_watermark_ = true; }
+
+void AdminFilter::onBelowWriteBufferLowWatermark() {
+  above_high_watermark_ = false;
+  if (next_chunk_ != nullptr) {
+    chunk_timer_->enableTimer(std::chrono::milliseconds(0));
+  } else if (off_thread_response_ != nullptr && !render_pending_) {
+    renderNextChunk();
+  }
+}
+
+void AdminFilter::finishResponse(Buffer::Instance& response) {
+  if (next_chunk_ != nullptr) {
+    while (!next_chunk_(response)) {
+    }
+    next_chunk_ = nullptr;
+  }
+  if (off_thread_response_ != nullptr) {
+    while (!off_thread_response_->next_chunk_(response)) {
+    }
+    off_thread_response_ = nullptr;
+  }
+}
+
+AdminRenderThread::AdminRenderThread()
+    : thread_(new Thread::Thread([this]() -> void { threadRoutine(); })) {}
+
+AdminRenderThread::~AdminRenderThread() {
+  {
+    Thread::LockGuard lock(lock_);
+    shutdown_ = true;
+  }
+  queue_cv_.notifyAll();
+  thread_->join();
+}
+
+void AdminRenderThread::post(std::function<void()> task) {
+  {
+    Thread::LockGuard lock(lock_);
+    queue_.push(std::move(task));
+  }
+  queue_cv_.notifyOne();
+}
+
+void AdminRenderThread::threadRoutine() {
+  while (true) {
+    std::function<void()> task;
+    {
+      Thread::LockGuard lock(lock_);
+      while (queue_.empty() && !shutdown_) {
+        queue_cv_.wait(lock_);
+      }
+      if (shutdown_) {
+        return;
+      }
+      task = std::move(queue_.front());
+      queue_.pop();
+    }
+    task();
   }
 }
 
@@ -1133,6 +1630,7 @@ Http::Code AdminImpl::request(absl::string_view path_and_query, absl::string_vie
   Buffer::OwnedImpl response;
 
   Http::Code code = runCallback(path_and_query, response_headers, response, filter);
+  filter.finishResponse(response);
   populateFallbackResponseHeaders(code, response_headers);
   body = response.toString();
   return code;
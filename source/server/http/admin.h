@@ -1,13 +1,19 @@
 #pragma once
 
 #include <chrono>
+#include <limits>
 #include <list>
+#include <memory>
+#include <queue>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "envoy/admin/v2alpha/clusters.pb.h"
+#include "envoy/event/timer.h"
+#include "envoy/http/codec.h"
 #include "envoy/http/filter.h"
 #include "envoy/network/filter.h"
 #include "envoy/network/listen_socket.h"
@@ -22,11 +28,15 @@
 #include "common/common/empty_string.h"
 #include "common/common/logger.h"
 #include "common/common/macros.h"
+#include "common/common/thread.h"
+#include "common/common/thread_annotations.h"
 #include "common/http/conn_manager_impl.h"
 #include "common/http/date_provider_impl.h"
 #include "common/http/default_server_string.h"
 #include "common/http/utility.h"
+#include "common/network/connection_balancer_impl.h"
 #include "common/network/raw_buffer_socket.h"
+#include "common/protobuf/protobuf.h"
 #include "common/stats/isolated_store_impl.h"
 
 #include "server/http/config_tracker_impl.h"
@@ -36,6 +46,32 @@
 namespace Envoy {
 namespace Server {
 
+/**
+ * A thread producing the bodies of read-only admin responses, so that the main thread only has to
+ * send them. @see AdminStream::streamResponseOffThread().
+ */
+class AdminRenderThread {
+public:
+  AdminRenderThread();
+  ~AdminRenderThread();
+
+  /**
+   * Run a task on the render thread. Tasks run one at a time in the order they are posted. Tasks
+   * still queued when the thread is destroyed are dropped.
+   * @param task supplies the task.
+   */
+  void post(std::function<void()> task);
+
+private:
+  void threadRoutine();
+
+  Thread::MutexBasicLockable lock_;
+  Thread::CondVar queue_cv_;
+  std::queue<std::function<void()>> queue_ GUARDED_BY(lock_);
+  bool shutdown_ GUARDED_BY(lock_){};
+  Thread::ThreadPtr thread_;
+};
+
 /**
  * Implementation of Server::Admin.
  */
@@ -56,6 +92,17 @@ public:
   Network::Socket& mutable_socket() { return *socket_; }
   Network::ListenerConfig& listener() { return listener_; }
 
+  /**
+   * Start the render thread producing streamed read-only responses. Until it is started, they are
+   * produced on the main thread.
+   */
+  void startRenderThread();
+
+  /**
+   * @return AdminRenderThread* the render thread, or nullptr if it hasn't been started.
+   */
+  AdminRenderThread* renderThread() { return render_thread_.get(); }
+
   // Server::Admin
   // TODO(jsedgwick) These can be managed with a generic version of ConfigTracker.
   // Wins would be no manual removeHandler() and code reuse.
@@ -76,6 +123,10 @@ public:
   createNetworkFilterChain(Network::Connection& connection,
                            const std::vector<Network::FilterFactoryCb>& filter_factories) override;
   bool createListenerFilterChain(Network::ListenerFilterManager&) override { return true; }
+  bool createUdpListenerFilterChain(Network::UdpListenerFilterManager&,
+                                    Network::UdpReadFilterCallbacks&) override {
+    return true;
+  }
 
   // Http::FilterChainFactory
   void createFilterChain(Http::FilterChainFactoryCallbacks& callbacks) override;
@@ -114,6 +165,7 @@ public:
   Http::ConnectionManagerListenerStats& listenerStats() override { return listener_.stats_; }
   bool proxy100Continue() const override { return false; }
   const Http::Http1Settings& http1Settings() const override { return http1_settings_; }
+  bool perStreamArena() const override { return false; }
   Http::Code request(absl::string_view path_and_query, absl::string_view method,
                      Http::HeaderMap& response_headers, std::string& body) override;
 
@@ -161,8 +213,16 @@ private:
   void addOutlierInfo(const std::string& cluster_name,
                       const Upstream::Outlier::Detector* outlier_detector,
                       Buffer::Instance& response);
-  void writeClustersAsJson(Buffer::Instance& response);
-  void writeClustersAsText(Buffer::Instance& response);
+  void writeClustersAsProto(const std::vector<const Upstream::Cluster*>& clusters,
+                            envoy::admin::v2alpha::Clusters& response);
+  void writeClustersAsText(const std::vector<const Upstream::Cluster*>& clusters,
+                           Buffer::Instance& response);
+
+  /**
+   * Write a message to an admin response, as pretty-printed JSON or in the protobuf binary format.
+   */
+  static void writeMessage(const Protobuf::Message& message, bool binary,
+                           Http::HeaderMap& response_headers, Buffer::Instance& response);
 
   static std::string statsAsJson(const std::map<std::string, uint64_t>& all_stats,
                                  const std::vector<Stats::ParentHistogramSharedPtr>& all_histograms,
@@ -240,11 +300,18 @@ private:
     Stats::Scope& listenerScope() override { return *scope_; }
     uint64_t listenerTag() const override { return 0; }
     const std::string& name() const override { return name_; }
+    Network::ConnectionBalancer& connectionBalancer() override { return connection_balancer_; }
+    uint32_t maxAcceptsPerWakeup() const override { return std::numeric_limits<uint32_t>::max(); }
+    uint32_t perConnectionReadBudgetBytes() const override { return 0; }
+    Network::Address::SocketType socketType() const override {
+      return Network::Address::SocketType::Stream;
+    }
 
     AdminImpl& parent_;
     const std::string name_;
     Stats::ScopePtr scope_;
     Http::ConnectionManagerListenerStats stats_;
+    Network::NopConnectionBalancerImpl connection_balancer_;
   };
 
   class AdminFilterChain : public Network::FilterChain {
@@ -284,12 +351,15 @@ private:
   Http::Http1Settings http1_settings_;
   ConfigTrackerImpl config_tracker_;
   const Network::FilterChainSharedPtr admin_filter_chain_;
+  // Declared last so that the thread is joined before anything its tasks may use is destroyed.
+  std::unique_ptr<AdminRenderThread> render_thread_;
 };
 
 /**
  * A terminal HTTP filter that implements server admin functionality.
  */
 class AdminFilter : public Http::StreamDecoderFilter,
+                    public Http::DownstreamWatermarkCallbacks,
                     public AdminStream,
                     Logger::Loggable<Logger::Id::admin> {
 public:
@@ -311,6 +381,19 @@ public:
   void addOnDestroyCallback(std::function<void()> cb) override;
   Http::StreamDecoderFilterCallbacks& getDecoderFilterCallbacks() const override;
   const Http::HeaderMap& getRequestHeaders() const override;
+  void streamResponse(ChunkCb cb) override { next_chunk_ = cb; }
+  void streamResponseOffThread(ChunkCb cb) override;
+
+  // Http::DownstreamWatermarkCallbacks
+  void onAboveWriteBufferHighWatermark() override;
+  void onBelowWriteBufferLowWatermark() override;
+
+  /**
+   * Produce the rest of a streamed response at once, for callers that need the whole body.
+   * Does nothing if the handler did not stream its response.
+   * @param response supplies the buffer to append the rest of the body to.
+   */
+  void finishResponse(Buffer::Instance& response);
 
 private:
   /**
@@ -318,6 +401,39 @@ private:
    */
   void onComplete();
 
+  /**
+   * Sends the next part of a streamed response, and schedules the one after it unless the body is
+   * complete or the downstream connection is backed up.
+   */
+  void onNextChunk();
+
+  /**
+   * A response produced on the render thread. The chunk callback is only invoked on the render
+   * thread, one chunk at a time, while the filter is only accessed on the main thread and is
+   * cleared when the stream is destroyed.
+   */
+  struct OffThreadResponse {
+    OffThreadResponse(ChunkCb next_chunk, AdminFilter& filter)
+        : next_chunk_(next_chunk), filter_(&filter) {}
+
+    ChunkCb next_chunk_;
+    AdminFilter* filter_;
+  };
+
+  typedef std::shared_ptr<OffThreadResponse> OffThreadResponseSharedPtr;
+
+  /**
+   * Asks the render thread for the next part of the off thread response.
+   */
+  void renderNextChunk();
+
+  /**
+   * Sends a part of the off thread response produced by the render thread.
+   * @param chunk supplies the part.
+   * @param complete supplies whether the body is complete.
+   */
+  void onChunkRendered(Buffer::Instance& chunk, bool complete);
+
   AdminImpl& parent_;
   // Handlers relying on the reference should use addOnDestroyCallback()
   // to add a callback that will notify them when the reference is no
@@ -326,6 +442,11 @@ private:
   Http::HeaderMap* request_headers_{};
   std::list<std::function<void()>> on_destroy_callbacks_;
   bool end_stream_on_complete_ = true;
+  ChunkCb next_chunk_;
+  Event::TimerPtr chunk_timer_;
+  OffThreadResponseSharedPtr off_thread_response_;
+  bool render_pending_{};
+  bool above_high_watermark_{};
 };
 
 /**
@@ -343,6 +464,15 @@ public:
   static uint64_t statsAsPrometheus(const std::vector<Stats::CounterSharedPtr>& counters,
                                     const std::vector<Stats::GaugeSharedPtr>& gauges,
                                     Buffer::Instance& response);
+  /**
+   * Append a counter or gauge to the response buffer, preceded by a TYPE line the first time its
+   * metric name is seen.
+   * @param type supplies the Prometheus metric type.
+   * @param metric_type_tracker supplies the metric names seen so far, and is updated.
+   */
+  static void formatMetric(const Stats::Metric& metric, uint64_t value, absl::string_view type,
+                           std::unordered_set<std::string>& metric_type_tracker,
+                           Buffer::Instance& response);
   /**
    * Format the given tags, returning a string as a comma-separated list
    * of <tag_name>="<tag_value>" pairs.
@@ -26,8 +26,15 @@ void InitManagerImpl::initialize(std::function<void()> callback) {
 }
 
 void InitManagerImpl::initializeTarget(Init::Target& target) {
-  target.initialize([this, &target]() -> void {
+  absl::optional<uint64_t> phase;
+  if (startup_timeline_ != nullptr) {
+    phase = startup_timeline_->startPhase("init_target." + target.name());
+  }
+  target.initialize([this, &target, phase]() -> void {
     ASSERT(std::find(targets_.begin(), targets_.end(), &target) != targets_.end());
+    if (phase.has_value()) {
+      startup_timeline_->endPhase(phase.value());
+    }
     targets_.remove(&target);
     if (targets_.empty()) {
       state_ = State::Initialized;
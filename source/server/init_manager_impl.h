@@ -4,6 +4,8 @@
 
 #include "envoy/init/init.h"
 
+#include "server/startup_timeline.h"
+
 namespace Envoy {
 namespace Server {
 
@@ -15,6 +17,13 @@ class InitManagerImpl : public Init::Manager {
 public:
   void initialize(std::function<void()> callback);
 
+  /**
+   * Records the initialization of every target as a phase of a startup timeline, named
+   * "init_target." followed by the name of the target.
+   * @param timeline supplies the timeline, which must outlive the manager.
+   */
+  void setStartupTimeline(StartupTimeline& timeline) { startup_timeline_ = &timeline; }
+
   // Init::Manager
   void registerTarget(Init::Target& target) override;
 
@@ -26,6 +35,7 @@ private:
   std::list<Init::Target*> targets_;
   State state_{State::NotInitialized};
   std::function<void()> callback_;
+  StartupTimeline* startup_timeline_{};
 };
 
 } // namespace Server
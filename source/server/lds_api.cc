@@ -7,6 +7,7 @@
 #include "envoy/stats/scope.h"
 
 #include "common/common/cleanup.h"
+#include "common/common/thread.h"
 #include "common/config/resources.h"
 #include "common/config/subscription_factory.h"
 #include "common/config/utility.h"
@@ -32,7 +33,8 @@ LdsApiImpl::LdsApiImpl(const envoy::api::v2::core::ConfigSource& lds_config,
                                        dispatcher, random, local_info, scope.statsOptions());
           },
           "envoy.api.v2.ListenerDiscoveryService.FetchListeners",
-          "envoy.api.v2.ListenerDiscoveryService.StreamListeners");
+          "envoy.api.v2.ListenerDiscoveryService.StreamListeners",
+          /* incremental_grpc_method */ "");
   Config::Utility::checkLocalInfo("lds", local_info);
   init_manager.registerTarget(*this);
 }
@@ -51,9 +53,8 @@ void LdsApiImpl::onConfigUpdate(const ResourceVector& resources, const std::stri
       throw EnvoyException(fmt::format("duplicate listener {} found", listener.name()));
     }
   }
-  for (const auto& listener : resources) {
-    MessageUtil::validate(listener);
-  }
+  Thread::parallelFor(resources.size(), ListenersPerValidateThread,
+                      [&resources](size_t i) { MessageUtil::validate(resources[i]); });
   // We need to keep track of which listeners we might need to remove.
   std::unordered_map<std::string, std::reference_wrapper<Network::ListenerConfig>>
       listeners_to_remove;
@@ -91,6 +92,13 @@ void LdsApiImpl::onConfigUpdate(const ResourceVector& resources, const std::stri
   runInitializeCallbackIfAny();
 }
 
+void LdsApiImpl::onIncrementalConfigUpdate(
+    const ResourceVector&, const Protobuf::RepeatedPtrField<ProtobufTypes::String>&,
+    const std::string&) {
+  // There is no incremental xDS API for this resource type, see SubscriptionFactory.
+  NOT_REACHED_GCOVR_EXCL_LINE;
+}
+
 void LdsApiImpl::onConfigUpdateFailed(const EnvoyException*) {
   // We need to allow server startup to continue, even if we have a bad
   // config.
@@ -31,9 +31,14 @@ public:
 
   // Init::Target
   void initialize(std::function<void()> callback) override;
+  std::string name() const override { return "lds"; }
 
   // Config::SubscriptionCallbacks
   void onConfigUpdate(const ResourceVector& resources, const std::string& version_info) override;
+  void onIncrementalConfigUpdate(
+      const ResourceVector& added_resources,
+      const Protobuf::RepeatedPtrField<ProtobufTypes::String>& removed_resources,
+      const std::string& system_version_info) override;
   void onConfigUpdateFailed(const EnvoyException* e) override;
   std::string resourceName(const ProtobufWkt::Any& resource) override {
     return MessageUtil::anyConvert<envoy::api::v2::Listener>(resource).name();
@@ -42,6 +47,10 @@ public:
 private:
   void runInitializeCallbackIfAny();
 
+  // Updates may carry many listeners, so they are validated in parallel batches of at least this
+  // many listeners.
+  static constexpr size_t ListenersPerValidateThread = 16;
+
   std::unique_ptr<Config::Subscription<envoy::api::v2::Listener>> subscription_;
   std::string version_info_;
   ListenerManager& listener_manager_;
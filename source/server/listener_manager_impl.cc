@@ -1,5 +1,9 @@
 #include "server/listener_manager_impl.h"
 
+#include <limits>
+#include <list>
+#include <unordered_set>
+
 #include "envoy/admin/v2alpha/config_dump.pb.h"
 #include "envoy/registry/registry.h"
 #include "envoy/server/transport_socket_config.h"
@@ -9,7 +13,10 @@
 #include "common/common/assert.h"
 #include "common/common/empty_string.h"
 #include "common/common/fmt.h"
+#include "common/common/lock_guard.h"
+#include "common/common/thread.h"
 #include "common/config/utility.h"
+#include "common/network/connection_balancer_impl.h"
 #include "common/network/listen_socket_impl.h"
 #include "common/network/resolver_impl.h"
 #include "common/network/socket_option_factory.h"
@@ -24,8 +31,6 @@
 #include "extensions/filters/network/well_known_names.h"
 #include "extensions/transport_sockets/well_known_names.h"
 
-#include "absl/strings/match.h"
-
 namespace Envoy {
 namespace Server {
 
@@ -83,6 +88,25 @@ ProdListenerComponentFactory::createListenerFilterFactoryList_(
   return ret;
 }
 
+std::vector<Network::UdpListenerFilterFactoryCb>
+ProdListenerComponentFactory::createUdpListenerFilterFactoryList_(
+    const Protobuf::RepeatedPtrField<envoy::api::v2::listener::ListenerFilter>& filters,
+    Configuration::ListenerFactoryContext& context) {
+  std::vector<Network::UdpListenerFilterFactoryCb> ret;
+  for (ssize_t i = 0; i < filters.size(); i++) {
+    const auto& proto_config = filters[i];
+    ENVOY_LOG(debug, "  udp filter #{}:", i);
+    ENVOY_LOG(debug, "    name: {}", proto_config.name());
+
+    auto& factory =
+        Config::Utility::getAndCheckFactory<Configuration::NamedUdpListenerFilterConfigFactory>(
+            proto_config.name());
+    auto message = Config::Utility::translateToFactoryConfig(proto_config, factory);
+    ret.push_back(factory.createFilterFactoryFromProto(*message, context));
+  }
+  return ret;
+}
+
 Network::SocketSharedPtr
 ProdListenerComponentFactory::createListenSocket(Network::Address::InstanceConstSharedPtr address,
                                                  const Network::Socket::OptionsSharedPtr& options,
@@ -94,7 +118,7 @@ ProdListenerComponentFactory::createListenSocket(Network::Address::InstanceConst
   // First we try to get the socket from our parent if applicable.
   if (address->type() == Network::Address::Type::Pipe) {
     const std::string addr = fmt::format("unix://{}", address->asString());
-    const int fd = server_.hotRestart().duplicateParentListenSocket(addr);
+    const int fd = server_.hotRestart().duplicateParentListenSocket(addr, 0);
     if (fd != -1) {
       ENVOY_LOG(debug, "obtained socket for address {} from parent", addr);
       return std::make_shared<Network::UdsListenSocket>(fd, address);
@@ -103,7 +127,7 @@ ProdListenerComponentFactory::createListenSocket(Network::Address::InstanceConst
   }
 
   const std::string addr = fmt::format("tcp://{}", address->asString());
-  const int fd = server_.hotRestart().duplicateParentListenSocket(addr);
+  const int fd = server_.hotRestart().duplicateParentListenSocket(addr, 0);
   if (fd != -1) {
     ENVOY_LOG(debug, "obtained socket for address {} from parent", addr);
     return std::make_shared<Network::TcpListenSocket>(fd, address, options);
@@ -111,6 +135,31 @@ ProdListenerComponentFactory::createListenSocket(Network::Address::InstanceConst
   return std::make_shared<Network::TcpListenSocket>(address, options, bind_to_port);
 }
 
+Network::SocketSharedPtr ProdListenerComponentFactory::createReusePortListenSocket(
+    Network::Address::InstanceConstSharedPtr address,
+    const Network::Socket::OptionsSharedPtr& options, uint32_t worker_index) {
+  ASSERT(address->type() == Network::Address::Type::Ip);
+
+  // Each worker takes over the socket of the parent's worker with the same index, if any.
+  const std::string addr = fmt::format("tcp://{}", address->asString());
+  const int fd = server_.hotRestart().duplicateParentListenSocket(addr, worker_index);
+  if (fd != -1) {
+    ENVOY_LOG(debug, "obtained socket for address {} worker {} from parent", addr, worker_index);
+    return std::make_shared<Network::TcpListenSocket>(fd, address, options);
+  }
+  return std::make_shared<Network::TcpListenSocket>(address, options, true);
+}
+
+Network::SocketSharedPtr ProdListenerComponentFactory::createUdpListenSocket(
+    Network::Address::InstanceConstSharedPtr address,
+    const Network::Socket::OptionsSharedPtr& options, uint32_t) {
+  ASSERT(address->type() == Network::Address::Type::Ip);
+
+  // Datagram sockets are not taken over from the parent process during a hot restart. The new
+  // sockets bind next to the parent's sockets, which keep receiving until the parent exits.
+  return std::make_shared<Network::UdpListenSocket>(address, options, true);
+}
+
 DrainManagerPtr
 ProdListenerComponentFactory::createDrainManager(envoy::api::v2::Listener::DrainType drain_type) {
   return DrainManagerPtr{new DrainManagerImpl(server_, drain_type)};
@@ -123,15 +172,34 @@ ListenerImpl::ListenerImpl(const envoy::api::v2::Listener& config, const std::st
       global_scope_(parent_.server_.stats().createScope("")),
       listener_scope_(
           parent_.server_.stats().createScope(fmt::format("listener.{}.", address_->asString()))),
+      socket_type_(config.address().has_socket_address() &&
+                           config.address().socket_address().protocol() ==
+                               envoy::api::v2::core::SocketAddress::UDP
+                       ? Network::Address::SocketType::Datagram
+                       : Network::Address::SocketType::Stream),
       bind_to_port_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.deprecated_v1(), bind_to_port, true)),
+      reuse_port_((config.reuse_port() || socket_type_ == Network::Address::SocketType::Datagram) &&
+                  bind_to_port_ && address_->type() == Network::Address::Type::Ip),
       hand_off_restored_destination_connections_(
           PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, use_original_dst, false)),
       per_connection_buffer_limit_bytes_(
           PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, per_connection_buffer_limit_bytes, 1024 * 1024)),
+      max_accepts_per_wakeup_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(
+          config, max_accepts_per_wakeup, std::numeric_limits<uint32_t>::max())),
+      per_connection_read_budget_bytes_(
+          PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, per_connection_read_budget_bytes, 0)),
       listener_tag_(parent_.factory_.nextListenerTag()), name_(name), modifiable_(modifiable),
       workers_started_(workers_started), hash_(hash),
       local_drain_manager_(parent.factory_.createDrainManager(config.drain_type())),
       config_(config), version_info_(version_info) {
+  if (config.has_connection_balance_config()) {
+    // There is only one balancer type today, which the proto validation requires to be set.
+    ASSERT(config.connection_balance_config().has_exact_balance());
+    connection_balancer_ = std::make_unique<Network::ExactConnectionBalancerImpl>();
+  } else {
+    connection_balancer_ = std::make_unique<Network::NopConnectionBalancerImpl>();
+  }
+
   if (config.has_transparent()) {
     addListenSocketOptions(Network::SocketOptionFactory::buildIpTransparentOptions());
   }
@@ -143,11 +211,51 @@ ListenerImpl::ListenerImpl(const envoy::api::v2::Listener& config, const std::st
         config.tcp_fast_open_queue_length().value()));
   }
 
+  if (reuse_port_) {
+    addListenSocketOptions(Network::SocketOptionFactory::buildReusePortOptions());
+  }
+
   if (config.socket_options().size() > 0) {
     addListenSocketOptions(
         Network::SocketOptionFactory::buildLiteralOptions(config.socket_options()));
   }
 
+  if (socket_type_ == Network::Address::SocketType::Datagram) {
+    // UDP listeners have no connections, so everything below that configures what happens to an
+    // accepted connection doesn't apply. The listener filters are UDP listener filters instead.
+    if (!bind_to_port_) {
+      throw EnvoyException(
+          fmt::format("error adding listener '{}': UDP listeners must bind to their port",
+                      address_->asString()));
+    }
+    if (!config.filter_chains().empty()) {
+      throw EnvoyException(fmt::format(
+          "error adding listener '{}': UDP listeners do not support filter chains, configure UDP "
+          "listener filters instead",
+          address_->asString()));
+    }
+    if (config.udp_worker_routing() == envoy::api::v2::Listener::QUIC_CONNECTION_ID) {
+      // The workers' sockets are bound in the order of the workers, so the index of a socket in
+      // the SO_REUSEPORT group is the index of its worker.
+      addListenSocketOptions(Network::SocketOptionFactory::buildQuicConnectionIdRoutingOptions(
+          parent_.server_.options().concurrency()));
+    }
+    udp_listener_filter_factories_ =
+        parent_.factory_.createUdpListenerFilterFactoryList(config.listener_filters(), *this);
+    return;
+  }
+
+  if (config.udp_worker_routing() != envoy::api::v2::Listener::PEER_ADDRESS) {
+    throw EnvoyException(fmt::format(
+        "error adding listener '{}': udp_worker_routing only applies to UDP listeners",
+        address_->asString()));
+  }
+
+  if (config.filter_chains().empty()) {
+    throw EnvoyException(fmt::format("error adding listener '{}': no filter chains specified",
+                                     address_->asString()));
+  }
+
   if (!config.listener_filters().empty()) {
     listener_filter_factories_ =
         parent_.factory_.createListenerFilterFactoryList(config.listener_filters(), *this);
@@ -232,11 +340,15 @@ ListenerImpl::ListenerImpl(const envoy::api::v2::Listener& config, const std::st
         parent_.server_.localInfo(), parent_.server_.dispatcher(), parent_.server_.random(),
         parent_.server_.stats());
     factory_context.setInitManager(initManager());
+    auto filter_chain_factory_context = std::make_unique<FilterChainFactoryContextImpl>(*this);
+    std::vector<Network::FilterFactoryCb> filters_factory =
+        parent_.factory_.createNetworkFilterFactoryList(filter_chain.filters(),
+                                                        *filter_chain_factory_context);
     addFilterChain(
         PROTOBUF_GET_WRAPPED_OR_DEFAULT(filter_chain_match, destination_port, 0), destination_ips,
         server_names, filter_chain_match.transport_protocol(), application_protocols,
         config_factory.createTransportSocketFactory(*message, factory_context, server_names),
-        parent_.factory_.createNetworkFilterFactoryList(filter_chain.filters(), *this));
+        std::move(filters_factory), std::move(filter_chain_factory_context));
 
     need_tls_inspector |= filter_chain_match.transport_protocol() == "tls" ||
                           (filter_chain_match.transport_protocol().empty() &&
@@ -279,21 +391,23 @@ ListenerImpl::~ListenerImpl() {
   // vector for clarity.
   initialize_canceled_ = true;
   destination_ports_map_.clear();
+  filter_chains_.clear();
 }
 
 bool ListenerImpl::isWildcardServerName(const std::string& name) {
-  return absl::StartsWith(name, "*.");
-}
-
-void ListenerImpl::addFilterChain(uint16_t destination_port,
-                                  const std::vector<std::string>& destination_ips,
-                                  const std::vector<std::string>& server_names,
-                                  const std::string& transport_protocol,
-                                  const std::vector<std::string>& application_protocols,
-                                  Network::TransportSocketFactoryPtr&& transport_socket_factory,
-                                  std::vector<Network::FilterFactoryCb> filters_factory) {
-  const auto filter_chain = std::make_shared<FilterChainImpl>(std::move(transport_socket_factory),
-                                                              std::move(filters_factory));
+  return Network::ServerNameTrie<TransportProtocolsMap>::isWildcard(name);
+}
+
+void ListenerImpl::addFilterChain(
+    uint16_t destination_port, const std::vector<std::string>& destination_ips,
+    const std::vector<std::string>& server_names, const std::string& transport_protocol,
+    const std::vector<std::string>& application_protocols,
+    Network::TransportSocketFactoryPtr&& transport_socket_factory,
+    std::vector<Network::FilterFactoryCb> filters_factory,
+    std::unique_ptr<FilterChainFactoryContextImpl>&& factory_context) {
+  const auto filter_chain = std::make_shared<FilterChainImpl>(
+      std::move(transport_socket_factory), std::move(filters_factory), std::move(factory_context));
+  filter_chains_.push_back(filter_chain);
   addFilterChainForDestinationPorts(destination_ports_map_, destination_port, destination_ips,
                                     server_names, transport_protocol, application_protocols,
                                     filter_chain);
@@ -319,34 +433,41 @@ void ListenerImpl::addFilterChainForDestinationIPs(
     const std::vector<std::string>& application_protocols,
     const Network::FilterChainSharedPtr& filter_chain) {
   if (destination_ips.empty()) {
-    addFilterChainForServerNames(destination_ips_map[EMPTY_STRING], server_names,
+    addFilterChainForServerNames(serverNamesIndex(destination_ips_map, EMPTY_STRING), server_names,
                                  transport_protocol, application_protocols, filter_chain);
   } else {
     for (const auto& destination_ip : destination_ips) {
-      addFilterChainForServerNames(destination_ips_map[destination_ip], server_names,
-                                   transport_protocol, application_protocols, filter_chain);
+      addFilterChainForServerNames(serverNamesIndex(destination_ips_map, destination_ip),
+                                   server_names, transport_protocol, application_protocols,
+                                   filter_chain);
     }
   }
 }
 
+ListenerImpl::ServerNamesIndex&
+ListenerImpl::serverNamesIndex(DestinationIPsMap& destination_ips_map,
+                               const std::string& destination_ip) {
+  auto& server_names_index = destination_ips_map[destination_ip];
+  if (server_names_index == nullptr) {
+    server_names_index = std::make_shared<ServerNamesIndex>();
+  }
+  return *server_names_index;
+}
+
 void ListenerImpl::addFilterChainForServerNames(
-    ServerNamesMap& server_names_map, const std::vector<std::string>& server_names,
+    ServerNamesIndex& server_names_index, const std::vector<std::string>& server_names,
     const std::string& transport_protocol, const std::vector<std::string>& application_protocols,
     const Network::FilterChainSharedPtr& filter_chain) {
   if (server_names.empty()) {
-    addFilterChainForApplicationProtocols(server_names_map[EMPTY_STRING][transport_protocol],
-                                          application_protocols, filter_chain);
+    addFilterChainForApplicationProtocols(
+        server_names_index.any_server_name_[transport_protocol], application_protocols,
+        filter_chain);
   } else {
     for (const auto& server_name : server_names) {
-      if (isWildcardServerName(server_name)) {
-        // Add mapping for the wildcard domain, i.e. ".example.com" for "*.example.com".
-        addFilterChainForApplicationProtocols(
-            server_names_map[server_name.substr(1)][transport_protocol], application_protocols,
-            filter_chain);
-      } else {
-        addFilterChainForApplicationProtocols(server_names_map[server_name][transport_protocol],
-                                              application_protocols, filter_chain);
-      }
+      // Both exact server names and wildcard domains (i.e. "*.example.com") are indexed.
+      addFilterChainForApplicationProtocols(
+          server_names_index.server_names_.emplace(server_name)[transport_protocol],
+          application_protocols, filter_chain);
     }
   }
 }
@@ -368,7 +489,8 @@ void ListenerImpl::convertDestinationIPsMapToTrie() {
   for (auto& port : destination_ports_map_) {
     auto& destination_ips_pair = port.second;
     auto& destination_ips_map = destination_ips_pair.first;
-    std::vector<std::pair<ServerNamesMapSharedPtr, std::vector<Network::Address::CidrRange>>> list;
+    std::vector<std::pair<ServerNamesIndexSharedPtr, std::vector<Network::Address::CidrRange>>>
+        list;
     for (const auto& entry : destination_ips_map) {
       std::vector<Network::Address::CidrRange> subnets;
       if (entry.first == EMPTY_STRING) {
@@ -381,9 +503,10 @@ void ListenerImpl::convertDestinationIPsMapToTrie() {
       } else {
         subnets.push_back(Network::Address::CidrRange::create(entry.first));
       }
+      // The index is shared with the trie rather than copied, as the server name trie can't be.
       list.push_back(
-          std::make_pair<ServerNamesMapSharedPtr, std::vector<Network::Address::CidrRange>>(
-              std::make_shared<ServerNamesMap>(entry.second),
+          std::make_pair<ServerNamesIndexSharedPtr, std::vector<Network::Address::CidrRange>>(
+              ServerNamesIndexSharedPtr(entry.second),
               std::vector<Network::Address::CidrRange>(subnets)));
     }
     destination_ips_pair.second = std::make_unique<DestinationIPsTrie>(list, true);
@@ -433,31 +556,19 @@ ListenerImpl::findFilterChainForDestinationIP(const DestinationIPsTrie& destinat
 }
 
 const Network::FilterChain*
-ListenerImpl::findFilterChainForServerName(const ServerNamesMap& server_names_map,
+ListenerImpl::findFilterChainForServerName(const ServerNamesIndex& server_names_index,
                                            const Network::ConnectionSocket& socket) const {
-  const std::string server_name(socket.requestedServerName());
-
-  // Match on exact server name, i.e. "www.example.com" for "www.example.com".
-  const auto server_name_exact_match = server_names_map.find(server_name);
-  if (server_name_exact_match != server_names_map.end()) {
-    return findFilterChainForTransportProtocol(server_name_exact_match->second, socket);
-  }
-
-  // Match on all wildcard domains, i.e. ".example.com" and ".com" for "www.example.com".
-  size_t pos = server_name.find('.', 1);
-  while (pos < server_name.size() - 1 && pos != std::string::npos) {
-    const std::string wildcard = server_name.substr(pos);
-    const auto server_name_wildcard_match = server_names_map.find(wildcard);
-    if (server_name_wildcard_match != server_names_map.end()) {
-      return findFilterChainForTransportProtocol(server_name_wildcard_match->second, socket);
-    }
-    pos = server_name.find('.', pos + 1);
+  // Match on exact server name, i.e. "www.example.com" for "www.example.com", otherwise on the
+  // most specific wildcard domain, i.e. "*.example.com" then "*.com" for "www.example.com".
+  const TransportProtocolsMap* server_name_match =
+      server_names_index.server_names_.find(socket.requestedServerName());
+  if (server_name_match != nullptr) {
+    return findFilterChainForTransportProtocol(*server_name_match, socket);
   }
 
   // Match on a filter chain without server name requirements.
-  const auto server_name_catchall_match = server_names_map.find(EMPTY_STRING);
-  if (server_name_catchall_match != server_names_map.end()) {
-    return findFilterChainForTransportProtocol(server_name_catchall_match->second, socket);
+  if (!server_names_index.any_server_name_.empty()) {
+    return findFilterChainForTransportProtocol(server_names_index.any_server_name_, socket);
   }
 
   return nullptr;
@@ -513,6 +624,12 @@ bool ListenerImpl::createListenerFilterChain(Network::ListenerFilterManager& man
   return Configuration::FilterChainUtility::buildFilterChain(manager, listener_filter_factories_);
 }
 
+bool ListenerImpl::createUdpListenerFilterChain(Network::UdpListenerFilterManager& udp_listener,
+                                                Network::UdpReadFilterCallbacks& callbacks) {
+  return Configuration::FilterChainUtility::buildFilterChain(udp_listener, callbacks,
+                                                             udp_listener_filter_factories_);
+}
+
 bool ListenerImpl::drainClose() const {
   // When a listener is draining, the "drain close" decision is the union of the per-listener drain
   // manager and the server wide drain manager. This allows individual listeners to be drained and
@@ -520,6 +637,38 @@ bool ListenerImpl::drainClose() const {
   return local_drain_manager_->drainClose() || parent_.server_.drainManager().drainClose();
 }
 
+absl::optional<std::list<const Network::FilterChain*>>
+ListenerImpl::keepFilterChains(const ListenerImpl& new_listener) {
+  // Listener filters, socket options and the like apply to all connections, so nothing is kept if
+  // any of them changed.
+  Protobuf::util::MessageDifferencer differencer;
+  differencer.IgnoreField(envoy::api::v2::Listener::descriptor()->FindFieldByName("filter_chains"));
+  if (!differencer.Compare(config_, new_listener.config_)) {
+    return absl::nullopt;
+  }
+
+  std::unordered_set<uint64_t> new_filter_chains;
+  for (const auto& filter_chain : new_listener.config_.filter_chains()) {
+    new_filter_chains.insert(MessageUtil::hash(filter_chain));
+  }
+
+  ASSERT(filter_chains_.size() == static_cast<size_t>(config_.filter_chains().size()));
+  std::list<const Network::FilterChain*> drained_filter_chains;
+  bool kept = false;
+  for (size_t i = 0; i < filter_chains_.size(); i++) {
+    if (new_filter_chains.count(MessageUtil::hash(config_.filter_chains(i))) > 0) {
+      filter_chains_[i]->factoryContext().keep();
+      kept = true;
+    } else {
+      drained_filter_chains.push_back(filter_chains_[i].get());
+    }
+  }
+  if (!kept) {
+    return absl::nullopt;
+  }
+  return drained_filter_chains;
+}
+
 void ListenerImpl::debugLog(const std::string& message) {
   UNREFERENCED_PARAMETER(message);
   ENVOY_LOG(debug, "{}: name={}, hash={}, address={}", message, name_, hash_, address_->asString());
@@ -548,13 +697,18 @@ Init::Manager& ListenerImpl::initManager() {
   }
 }
 
-void ListenerImpl::setSocket(const Network::SocketSharedPtr& socket) {
-  ASSERT(!socket_);
-  socket_ = socket;
-  // Server config validation sets nullptr sockets.
-  if (socket_ && listen_socket_options_) {
+void ListenerImpl::setSockets(const std::vector<Network::SocketSharedPtr>& sockets) {
+  ASSERT(sockets_.empty());
+  ASSERT(!sockets.empty());
+  sockets_ = sockets;
+  for (const auto& socket : sockets_) {
+    // Server config validation sets nullptr sockets.
+    if (!socket || !listen_socket_options_) {
+      continue;
+    }
+
     // 'pre_bind = false' as bind() is never done after this.
-    bool ok = Network::Socket::applyOptions(listen_socket_options_, *socket_,
+    bool ok = Network::Socket::applyOptions(listen_socket_options_, *socket,
                                             envoy::api::v2::core::SocketOption::STATE_BOUND);
     const std::string message =
         fmt::format("{}: Setting socket options {}", name_, ok ? "succeeded" : "failed");
@@ -565,10 +719,31 @@ void ListenerImpl::setSocket(const Network::SocketSharedPtr& socket) {
       ENVOY_LOG(debug, "{}", message);
     }
 
-    // Add the options to the socket_ so that STATE_LISTENING options can be
-    // set in the worker after listen()/evconnlistener_new() is called.
-    socket_->addOptions(listen_socket_options_);
+    // Add the options to the socket so that STATE_LISTENING options can be
+    // set in the worker after listen() is called.
+    socket->addOptions(listen_socket_options_);
+  }
+
+  if (reuse_port_) {
+    for (uint32_t i = 0; i < sockets_.size(); i++) {
+      worker_listener_configs_.emplace_back(std::make_unique<WorkerListenerConfig>(*this, i));
+    }
+  }
+}
+
+Network::ListenerConfig& ListenerImpl::workerListenerConfig(uint32_t worker_index) {
+  if (!reuse_port_) {
+    return *this;
   }
+  ASSERT(worker_index < worker_listener_configs_.size());
+  return *worker_listener_configs_[worker_index];
+}
+
+int ListenerImpl::listenSocketFd(uint32_t worker_index) const {
+  if (reuse_port_) {
+    return worker_index < sockets_.size() ? sockets_[worker_index]->fd() : -1;
+  }
+  return sockets_[0]->fd();
 }
 
 ListenerManagerImpl::ListenerManagerImpl(Instance& server,
@@ -579,8 +754,9 @@ ListenerManagerImpl::ListenerManagerImpl(Instance& server,
       config_tracker_entry_(server.admin().getConfigTracker().add(
           "listeners", [this] { return dumpListenerConfigs(); })) {
   for (uint32_t i = 0; i < server.options().concurrency(); i++) {
-    workers_.emplace_back(worker_factory.createWorker());
+    workers_.emplace_back(worker_factory.createWorker(server.overloadManager()));
   }
+  next_adopting_worker_ = workers_.begin();
 }
 
 ProtobufTypes::MessagePtr ListenerManagerImpl::dumpListenerConfigs() {
@@ -669,17 +845,57 @@ bool ListenerManagerImpl::addOrUpdateListener(const envoy::api::v2::Listener& co
     throw EnvoyException(message);
   }
 
+  // The sockets of the existing listener can only be taken over if they have the type the new
+  // listener's protocol requires.
+  if ((existing_warming_listener != warming_listeners_.end() &&
+       (*existing_warming_listener)->socketType() != new_listener->socketType()) ||
+      (existing_active_listener != active_listeners_.end() &&
+       (*existing_active_listener)->socketType() != new_listener->socketType())) {
+    const std::string message = fmt::format(
+        "error updating listener: '{}' has a different protocol from existing listener", name);
+    ENVOY_LOG(warn, "{}", message);
+    throw EnvoyException(message);
+  }
+
+  // Workers of a reuse_port listener each own a socket, so the sockets of the existing listener
+  // can only be taken over if the setting did not change.
+  if ((existing_warming_listener != warming_listeners_.end() &&
+       (*existing_warming_listener)->reusePort() != new_listener->reusePort()) ||
+      (existing_active_listener != active_listeners_.end() &&
+       (*existing_active_listener)->reusePort() != new_listener->reusePort())) {
+    const std::string message = fmt::format(
+        "error updating listener: '{}' has a different reuse_port setting from existing listener",
+        name);
+    ENVOY_LOG(warn, "{}", message);
+    throw EnvoyException(message);
+  }
+
+  // The worker routing of a UDP listener is attached to its sockets when they are bound.
+  if ((existing_warming_listener != warming_listeners_.end() &&
+       (*existing_warming_listener)->config().udp_worker_routing() !=
+           new_listener->config().udp_worker_routing()) ||
+      (existing_active_listener != active_listeners_.end() &&
+       (*existing_active_listener)->config().udp_worker_routing() !=
+           new_listener->config().udp_worker_routing())) {
+    const std::string message = fmt::format(
+        "error updating listener: '{}' has a different udp_worker_routing setting from existing "
+        "listener",
+        name);
+    ENVOY_LOG(warn, "{}", message);
+    throw EnvoyException(message);
+  }
+
   bool added = false;
   if (existing_warming_listener != warming_listeners_.end()) {
     // In this case we can just replace inline.
     ASSERT(workers_started_);
     new_listener->debugLog("update warming listener");
-    new_listener->setSocket((*existing_warming_listener)->getSocket());
+    new_listener->setSockets((*existing_warming_listener)->getSockets());
     *existing_warming_listener = std::move(new_listener);
   } else if (existing_active_listener != active_listeners_.end()) {
     // In this case we have no warming listener, so what we do depends on whether workers
     // have been started or not. Either way we get the socket from the existing listener.
-    new_listener->setSocket((*existing_active_listener)->getSocket());
+    new_listener->setSockets((*existing_active_listener)->getSockets());
     if (workers_started_) {
       new_listener->debugLog("add warming listener");
       warming_listeners_.emplace_back(std::move(new_listener));
@@ -708,21 +924,20 @@ bool ListenerManagerImpl::addOrUpdateListener(const envoy::api::v2::Listener& co
     // to see if there is a listener that has a socket bound to the address we are configured for.
     // This is an edge case, but may happen if a listener is removed and then added back with a same
     // or different name and intended to listen on the same address. This should work and not fail.
-    Network::SocketSharedPtr draining_listener_socket;
+    // The draining sockets are only usable if they match the new listener's reuse_port setting.
     auto existing_draining_listener = std::find_if(
         draining_listeners_.cbegin(), draining_listeners_.cend(),
         [&new_listener](const DrainingListener& listener) {
-          return *new_listener->address() == *listener.listener_->socket().localAddress();
+          return *new_listener->address() == *listener.listener_->socket().localAddress() &&
+                 new_listener->socketType() == listener.listener_->socketType() &&
+                 new_listener->reusePort() == listener.listener_->reusePort() &&
+                 new_listener->config().udp_worker_routing() ==
+                     listener.listener_->config().udp_worker_routing();
         });
-    if (existing_draining_listener != draining_listeners_.cend()) {
-      draining_listener_socket = existing_draining_listener->listener_->getSocket();
-    }
 
-    new_listener->setSocket(draining_listener_socket
-                                ? draining_listener_socket
-                                : factory_.createListenSocket(new_listener->address(),
-                                                              new_listener->listenSocketOptions(),
-                                                              new_listener->bindToPort()));
+    new_listener->setSockets(existing_draining_listener != draining_listeners_.cend()
+                                 ? existing_draining_listener->listener_->getSockets()
+                                 : createListenSockets(*new_listener));
     if (workers_started_) {
       new_listener->debugLog("add warming listener");
       warming_listeners_.emplace_back(std::move(new_listener));
@@ -755,10 +970,12 @@ bool ListenerManagerImpl::hasListenerWithAddress(const ListenerList& list,
   return false;
 }
 
-void ListenerManagerImpl::drainListener(ListenerImplPtr&& listener) {
+void ListenerManagerImpl::drainListener(
+    ListenerImplPtr&& listener,
+    const absl::optional<std::list<const Network::FilterChain*>>& drained_filter_chains) {
   // First add the listener to the draining list.
   std::list<DrainingListener>::iterator draining_it = draining_listeners_.emplace(
-      draining_listeners_.begin(), std::move(listener), workers_.size());
+      draining_listeners_.begin(), std::move(listener), workers_.size(), drained_filter_chains);
 
   // Using set() avoids a multiple modifiers problem during the multiple processes phase of hot
   // restart. Same below inside the lambda.
@@ -775,12 +992,10 @@ void ListenerManagerImpl::drainListener(ListenerImplPtr&& listener) {
   draining_it->listener_->localDrainManager().startDrainSequence([this, draining_it]() -> void {
     draining_it->listener_->debugLog("removing listener");
     for (const auto& worker : workers_) {
-      // Once the drain time has completed via the drain manager's timer, we tell the workers to
-      // remove the listener.
-      worker->removeListener(*draining_it->listener_, [this, draining_it]() -> void {
-        // The remove listener completion is called on the worker thread. We post back to the main
-        // thread to avoid locking. This makes sure that we don't destroy the listener while filters
-        // might still be using its context (stats, etc.).
+      // The remove listener completion is called on the worker thread. We post back to the main
+      // thread to avoid locking. This makes sure that we don't destroy the listener while filters
+      // might still be using its context (stats, etc.).
+      auto completion = [this, draining_it]() -> void {
         server_.dispatcher().post([this, draining_it]() -> void {
           if (--draining_it->workers_pending_removal_ == 0) {
             draining_it->listener_->debugLog("listener removal complete");
@@ -788,7 +1003,16 @@ void ListenerManagerImpl::drainListener(ListenerImplPtr&& listener) {
             stats_.total_listeners_draining_.set(draining_listeners_.size());
           }
         });
-      });
+      };
+      // Once the drain time has completed via the drain manager's timer, we tell the workers to
+      // remove the listener, or only the connections of the drained filter chains if some were
+      // kept. The listener is then removed once the connections of the kept ones are gone.
+      if (draining_it->drained_filter_chains_.has_value()) {
+        worker->removeFilterChains(*draining_it->listener_,
+                                   draining_it->drained_filter_chains_.value(), completion);
+      } else {
+        worker->removeListener(*draining_it->listener_, completion);
+      }
     }
   });
 
@@ -809,6 +1033,54 @@ ListenerManagerImpl::getListenerByName(ListenerList& listeners, const std::strin
   return ret;
 }
 
+std::vector<Network::SocketSharedPtr>
+ListenerManagerImpl::createListenSockets(ListenerImpl& listener) {
+  if (!listener.reusePort()) {
+    return {factory_.createListenSocket(listener.address(), listener.listenSocketOptions(),
+                                        listener.bindToPort())};
+  }
+
+  // Every worker gets its own socket bound to the listener's address. If the configured port is
+  // zero, the sockets after the first one bind to the port the kernel picked for the first one.
+  std::vector<Network::SocketSharedPtr> sockets;
+  Network::Address::InstanceConstSharedPtr address = listener.address();
+  const std::vector<uint32_t>& cpus = server_.options().workerCpus();
+  const bool incoming_cpu = server_.options().reusePortIncomingCpu() && !cpus.empty();
+  for (uint32_t i = 0; i < workers_.size(); i++) {
+    Network::Socket::OptionsSharedPtr options = listener.listenSocketOptions();
+    if (incoming_cpu) {
+      // Prefer handing connections to the worker pinned to the CPU that processed their SYN, which
+      // keeps them on the NUMA node of the NIC queue they arrived on. The listener's options always
+      // hold at least SO_REUSEPORT here.
+      options = std::make_shared<Network::Socket::Options>(*options);
+      Network::Socket::appendOptions(
+          options, Network::SocketOptionFactory::buildIncomingCpuOptions(cpus[i % cpus.size()]));
+    }
+    sockets.emplace_back(
+        listener.socketType() == Network::Address::SocketType::Datagram
+            ? factory_.createUdpListenSocket(address, options, i)
+            : factory_.createReusePortListenSocket(address, options, i));
+    // Server config validation returns nullptr sockets.
+    if (i == 0 && sockets[0] && address->ip()->port() == 0) {
+      address = sockets[0]->localAddress();
+    }
+  }
+  return sockets;
+}
+
+int ListenerManagerImpl::listenSocketFd(const Network::Address::Instance& address,
+                                        uint32_t worker_index) {
+  for (const auto& listener : active_listeners_) {
+    // The sockets of UDP listeners are never handed to the child process, which only asks for
+    // the sockets of stream listeners.
+    if (listener->socketType() == Network::Address::SocketType::Stream &&
+        *listener->socket().localAddress() == address) {
+      return listener->listenSocketFd(worker_index);
+    }
+  }
+  return -1;
+}
+
 std::vector<std::reference_wrapper<Network::ListenerConfig>> ListenerManagerImpl::listeners() {
   std::vector<std::reference_wrapper<Network::ListenerConfig>> ret;
   ret.reserve(active_listeners_.size());
@@ -818,8 +1090,10 @@ std::vector<std::reference_wrapper<Network::ListenerConfig>> ListenerManagerImpl
   return ret;
 }
 
-void ListenerManagerImpl::addListenerToWorker(Worker& worker, ListenerImpl& listener) {
-  worker.addListener(listener, [this, &listener](bool success) -> void {
+void ListenerManagerImpl::addListenerToWorker(Worker& worker, uint32_t worker_index,
+                                              ListenerImpl& listener) {
+  Network::ListenerConfig& worker_config = listener.workerListenerConfig(worker_index);
+  worker.addListener(worker_config, [this, &listener](bool success) -> void {
     // The add listener completion runs on the worker thread. Post back to the main thread to
     // avoid locking.
     server_.dispatcher().post([this, success, &listener]() -> void {
@@ -847,15 +1121,19 @@ void ListenerManagerImpl::addListenerToWorker(Worker& worker, ListenerImpl& list
 void ListenerManagerImpl::onListenerWarmed(ListenerImpl& listener) {
   // The warmed listener should be added first so that the worker will accept new connections
   // when it stops listening on the old listener.
+  uint32_t worker_index = 0;
   for (const auto& worker : workers_) {
-    addListenerToWorker(*worker, listener);
+    addListenerToWorker(*worker, worker_index++, listener);
   }
 
   auto existing_active_listener = getListenerByName(active_listeners_, listener.name());
   auto existing_warming_listener = getListenerByName(warming_listeners_, listener.name());
   (*existing_warming_listener)->debugLog("warm complete. updating active listener");
   if (existing_active_listener != active_listeners_.end()) {
-    drainListener(std::move(*existing_active_listener));
+    // Connections of the filter chains the update did not change are not drained.
+    const absl::optional<std::list<const Network::FilterChain*>> drained_filter_chains =
+        (*existing_active_listener)->keepFilterChains(**existing_warming_listener);
+    drainListener(std::move(*existing_active_listener), drained_filter_chains);
     *existing_active_listener = std::move(*existing_warming_listener);
   } else {
     active_listeners_.emplace_back(std::move(*existing_warming_listener));
@@ -874,6 +1152,43 @@ uint64_t ListenerManagerImpl::numConnections() {
   return num_connections;
 }
 
+std::vector<int> ListenerManagerImpl::releaseIdleConnections() {
+  std::vector<int> fds;
+  if (!workers_started_) {
+    return fds;
+  }
+
+  // The workers keep running while the main thread waits for them, and closing a connection does
+  // not involve the main thread.
+  Thread::MutexBasicLockable lock;
+  Thread::CondVar released;
+  size_t workers_pending = workers_.size();
+  for (const auto& worker : workers_) {
+    worker->releaseIdleConnections([&](std::vector<int>&& worker_fds) -> void {
+      Thread::LockGuard guard(lock);
+      fds.insert(fds.end(), worker_fds.begin(), worker_fds.end());
+      if (--workers_pending == 0) {
+        released.notifyOne();
+      }
+    });
+  }
+
+  Thread::LockGuard guard(lock);
+  while (workers_pending > 0) {
+    released.wait(lock);
+  }
+  ENVOY_LOG(info, "released {} idle connections", fds.size());
+  return fds;
+}
+
+void ListenerManagerImpl::adoptConnection(Network::ConnectionSocketPtr&& socket) {
+  ASSERT(workers_started_);
+  if (next_adopting_worker_ == workers_.end()) {
+    next_adopting_worker_ = workers_.begin();
+  }
+  (*next_adopting_worker_++)->adoptConnection(std::move(socket));
+}
+
 bool ListenerManagerImpl::removeListener(const std::string& name) {
   ENVOY_LOG(debug, "begin remove listener: name={}", name);
 
@@ -908,12 +1223,14 @@ void ListenerManagerImpl::startWorkers(GuardDog& guard_dog) {
   ENVOY_LOG(info, "all dependencies initialized. starting workers");
   ASSERT(!workers_started_);
   workers_started_ = true;
+  uint32_t worker_index = 0;
   for (const auto& worker : workers_) {
     ASSERT(warming_listeners_.empty());
     for (const auto& listener : active_listeners_) {
-      addListenerToWorker(*worker, *listener);
+      addListenerToWorker(*worker, worker_index, *listener);
     }
     worker->start(guard_dog);
+    worker_index++;
   }
 }
 
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <list>
 #include <memory>
 
 #include "envoy/api/v2/listener/listener.pb.h"
@@ -14,10 +16,13 @@
 #include "common/common/logger.h"
 #include "common/network/cidr_range.h"
 #include "common/network/lc_trie.h"
+#include "common/network/server_name_trie.h"
 
 #include "server/init_manager_impl.h"
 #include "server/lds_api.h"
 
+#include "absl/types/optional.h"
+
 namespace Envoy {
 namespace Server {
 
@@ -43,6 +48,12 @@ public:
   static std::vector<Network::ListenerFilterFactoryCb> createListenerFilterFactoryList_(
       const Protobuf::RepeatedPtrField<envoy::api::v2::listener::ListenerFilter>& filters,
       Configuration::ListenerFactoryContext& context);
+  /**
+   * Static worker for createUdpListenerFilterFactoryList() that can be used directly in tests.
+   */
+  static std::vector<Network::UdpListenerFilterFactoryCb> createUdpListenerFilterFactoryList_(
+      const Protobuf::RepeatedPtrField<envoy::api::v2::listener::ListenerFilter>& filters,
+      Configuration::ListenerFactoryContext& context);
 
   // Server::ListenerComponentFactory
   LdsApiPtr createLdsApi(const envoy::api::v2::core::ConfigSource& lds_config) override {
@@ -60,9 +71,21 @@ public:
       Configuration::ListenerFactoryContext& context) override {
     return createListenerFilterFactoryList_(filters, context);
   }
+  std::vector<Network::UdpListenerFilterFactoryCb> createUdpListenerFilterFactoryList(
+      const Protobuf::RepeatedPtrField<envoy::api::v2::listener::ListenerFilter>& filters,
+      Configuration::ListenerFactoryContext& context) override {
+    return createUdpListenerFilterFactoryList_(filters, context);
+  }
   Network::SocketSharedPtr createListenSocket(Network::Address::InstanceConstSharedPtr address,
                                               const Network::Socket::OptionsSharedPtr& options,
                                               bool bind_to_port) override;
+  Network::SocketSharedPtr
+  createReusePortListenSocket(Network::Address::InstanceConstSharedPtr address,
+                              const Network::Socket::OptionsSharedPtr& options,
+                              uint32_t worker_index) override;
+  Network::SocketSharedPtr createUdpListenSocket(Network::Address::InstanceConstSharedPtr address,
+                                                 const Network::Socket::OptionsSharedPtr& options,
+                                                 uint32_t worker_index) override;
   DrainManagerPtr createDrainManager(envoy::api::v2::Listener::DrainType drain_type) override;
   uint64_t nextListenerTag() override { return next_listener_tag_++; }
 
@@ -73,6 +96,8 @@ private:
 
 class ListenerImpl;
 typedef std::unique_ptr<ListenerImpl> ListenerImplPtr;
+class FilterChainFactoryContextImpl;
+class FilterChainImpl;
 
 /**
  * All listener manager stats. @see stats_macros.h
@@ -114,7 +139,10 @@ public:
     lds_api_ = factory_.createLdsApi(lds_config);
   }
   std::vector<std::reference_wrapper<Network::ListenerConfig>> listeners() override;
+  int listenSocketFd(const Network::Address::Instance& address, uint32_t worker_index) override;
   uint64_t numConnections() override;
+  std::vector<int> releaseIdleConnections() override;
+  void adoptConnection(Network::ConnectionSocketPtr&& socket) override;
   bool removeListener(const std::string& listener_name) override;
   void startWorkers(GuardDog& guard_dog) override;
   void stopListeners() override;
@@ -128,14 +156,26 @@ private:
   typedef std::list<ListenerImplPtr> ListenerList;
 
   struct DrainingListener {
-    DrainingListener(ListenerImplPtr&& listener, uint64_t workers_pending_removal)
-        : listener_(std::move(listener)), workers_pending_removal_(workers_pending_removal) {}
+    DrainingListener(
+        ListenerImplPtr&& listener, uint64_t workers_pending_removal,
+        const absl::optional<std::list<const Network::FilterChain*>>& drained_filter_chains)
+        : listener_(std::move(listener)), workers_pending_removal_(workers_pending_removal),
+          drained_filter_chains_(drained_filter_chains) {}
 
     ListenerImplPtr listener_;
     uint64_t workers_pending_removal_;
+    // Set when the listener was updated and some of its filter chains kept, to the filter chains
+    // whose connections are drained. The others run to completion.
+    const absl::optional<std::list<const Network::FilterChain*>> drained_filter_chains_;
   };
 
-  void addListenerToWorker(Worker& worker, ListenerImpl& listener);
+  void addListenerToWorker(Worker& worker, uint32_t worker_index, ListenerImpl& listener);
+  /**
+   * Create the listen sockets of a listener that does not take over the sockets of an existing
+   * listener: a single socket, or one socket per worker if reuse_port is set.
+   * @param listener supplies the listener to create the sockets for.
+   */
+  std::vector<Network::SocketSharedPtr> createListenSockets(ListenerImpl& listener);
   ProtobufTypes::MessagePtr dumpListenerConfigs();
   static ListenerManagerStats generateStats(Stats::Scope& scope);
   static bool hasListenerWithAddress(const ListenerList& list,
@@ -151,8 +191,13 @@ private:
    * Mark a listener for draining. The listener will no longer be considered active but will remain
    * present to allow connection draining.
    * @param listener supplies the listener to drain.
+   * @param drained_filter_chains supplies, when the listener was updated and some of its filter
+   *        chains kept, the filter chains whose connections are drained. The connections of the
+   *        others run to completion before the listener is removed.
    */
-  void drainListener(ListenerImplPtr&& listener);
+  void drainListener(ListenerImplPtr&& listener,
+                     const absl::optional<std::list<const Network::FilterChain*>>&
+                         drained_filter_chains = absl::nullopt);
 
   /**
    * Get a listener by name. This routine is used because listeners have inherent order in static
@@ -175,6 +220,8 @@ private:
   std::list<DrainingListener> draining_listeners_;
   std::list<WorkerPtr> workers_;
   bool workers_started_{};
+  // The worker that adopts the next connection released by the parent process.
+  std::list<WorkerPtr>::iterator next_adopting_worker_;
   ListenerManagerStats stats_;
   ConfigTracker::EntryOwnerPtr config_tracker_entry_;
   LdsApiPtr lds_api_;
@@ -227,19 +274,45 @@ public:
 
   Network::Address::InstanceConstSharedPtr address() const { return address_; }
   const envoy::api::v2::Listener& config() { return config_; }
-  const Network::SocketSharedPtr& getSocket() const { return socket_; }
+  /**
+   * @return the listen sockets of the listener. This is a single socket shared by all workers
+   *         unless reuse_port is set, in which case there is one socket per worker. UDP listeners
+   *         always have one socket per worker.
+   */
+  const std::vector<Network::SocketSharedPtr>& getSockets() const { return sockets_; }
   void debugLog(const std::string& message);
   void initialize();
   DrainManager& localDrainManager() const { return *local_drain_manager_; }
-  void setSocket(const Network::SocketSharedPtr& socket);
-  void setSocketAndOptions(const Network::SocketSharedPtr& socket);
+  void setSockets(const std::vector<Network::SocketSharedPtr>& sockets);
+  bool reusePort() const { return reuse_port_; }
+  /**
+   * @param worker_index supplies the index of a worker.
+   * @return Network::ListenerConfig& the config to add to the worker. This is the listener itself
+   *         unless reuse_port is set, in which case it is a view that uses the worker's socket.
+   */
+  Network::ListenerConfig& workerListenerConfig(uint32_t worker_index);
+  /**
+   * @param worker_index supplies the index of a worker.
+   * @return int the fd of the socket the worker accepts on, or -1 if the worker has none.
+   */
+  int listenSocketFd(uint32_t worker_index) const;
   const Network::Socket::OptionsSharedPtr& listenSocketOptions() { return listen_socket_options_; }
   const std::string& versionInfo() { return version_info_; }
+  /**
+   * Keep the connections of the filter chains which an update of the listener left unchanged from
+   * draining with the listener. Filter chains are only kept if nothing else in the listener
+   * changed.
+   * @param new_listener supplies the listener that replaces this one.
+   * @return the filter chains which were not kept, unless no filter chain was kept.
+   */
+  absl::optional<std::list<const Network::FilterChain*>>
+  keepFilterChains(const ListenerImpl& new_listener);
+  bool serverDrainClose() const { return parent_.server_.drainManager().drainClose(); }
 
   // Network::ListenerConfig
   Network::FilterChainManager& filterChainManager() override { return *this; }
   Network::FilterChainFactory& filterChainFactory() override { return *this; }
-  Network::Socket& socket() override { return *socket_; }
+  Network::Socket& socket() override { return *sockets_[0]; }
   bool bindToPort() override { return bind_to_port_; }
   bool handOffRestoredDestinationConnections() const override {
     return hand_off_restored_destination_connections_;
@@ -248,6 +321,12 @@ public:
   Stats::Scope& listenerScope() override { return *listener_scope_; }
   uint64_t listenerTag() const override { return listener_tag_; }
   const std::string& name() const override { return name_; }
+  Network::ConnectionBalancer& connectionBalancer() override { return *connection_balancer_; }
+  uint32_t maxAcceptsPerWakeup() const override { return max_accepts_per_wakeup_; }
+  uint32_t perConnectionReadBudgetBytes() const override {
+    return per_connection_read_budget_bytes_;
+  }
+  Network::Address::SocketType socketType() const override { return socket_type_; }
 
   // Server::Configuration::ListenerFactoryContext
   AccessLog::AccessLogManager& accessLogManager() override {
@@ -300,19 +379,63 @@ public:
   bool createNetworkFilterChain(Network::Connection& connection,
                                 const std::vector<Network::FilterFactoryCb>& factories) override;
   bool createListenerFilterChain(Network::ListenerFilterManager& manager) override;
+  bool createUdpListenerFilterChain(Network::UdpListenerFilterManager& udp_listener,
+                                    Network::UdpReadFilterCallbacks& callbacks) override;
 
   SystemTime last_updated_;
 
 private:
+  /**
+   * The view of a reuse_port listener that is added to a single worker. Everything except the
+   * listen socket is forwarded to the owning listener.
+   */
+  class WorkerListenerConfig : public Network::ListenerConfig {
+  public:
+    WorkerListenerConfig(ListenerImpl& parent, uint32_t worker_index)
+        : parent_(parent), worker_index_(worker_index) {}
+
+    // Network::ListenerConfig
+    Network::FilterChainManager& filterChainManager() override { return parent_; }
+    Network::FilterChainFactory& filterChainFactory() override { return parent_; }
+    Network::Socket& socket() override { return *parent_.sockets_[worker_index_]; }
+    bool bindToPort() override { return parent_.bindToPort(); }
+    bool handOffRestoredDestinationConnections() const override {
+      return parent_.handOffRestoredDestinationConnections();
+    }
+    uint32_t perConnectionBufferLimitBytes() override {
+      return parent_.perConnectionBufferLimitBytes();
+    }
+    Stats::Scope& listenerScope() override { return parent_.listenerScope(); }
+    uint64_t listenerTag() const override { return parent_.listenerTag(); }
+    const std::string& name() const override { return parent_.name(); }
+    Network::ConnectionBalancer& connectionBalancer() override {
+      return parent_.connectionBalancer();
+    }
+    uint32_t maxAcceptsPerWakeup() const override { return parent_.maxAcceptsPerWakeup(); }
+    uint32_t perConnectionReadBudgetBytes() const override {
+      return parent_.perConnectionReadBudgetBytes();
+    }
+    Network::Address::SocketType socketType() const override { return parent_.socketType(); }
+
+  private:
+    ListenerImpl& parent_;
+    const uint32_t worker_index_;
+  };
+
+  typedef std::unique_ptr<WorkerListenerConfig> WorkerListenerConfigPtr;
+
   typedef std::unordered_map<std::string, Network::FilterChainSharedPtr> ApplicationProtocolsMap;
   typedef std::unordered_map<std::string, ApplicationProtocolsMap> TransportProtocolsMap;
-  // Both exact server names and wildcard domains are part of the same map, in which wildcard
-  // domains are prefixed with "." (i.e. ".example.com" for "*.example.com") to differentiate
-  // between exact and wildcard entries.
-  typedef std::unordered_map<std::string, TransportProtocolsMap> ServerNamesMap;
-  typedef std::unordered_map<std::string, ServerNamesMap> DestinationIPsMap;
-  typedef std::shared_ptr<ServerNamesMap> ServerNamesMapSharedPtr;
-  typedef Network::LcTrie::LcTrie<ServerNamesMapSharedPtr> DestinationIPsTrie;
+  // Exact server names and wildcard domains are indexed by a trie over their labels, which is
+  // looked up without building any string. Filter chains without server name requirements are
+  // kept apart.
+  struct ServerNamesIndex {
+    Network::ServerNameTrie<TransportProtocolsMap> server_names_;
+    TransportProtocolsMap any_server_name_;
+  };
+  typedef std::shared_ptr<ServerNamesIndex> ServerNamesIndexSharedPtr;
+  typedef std::unordered_map<std::string, ServerNamesIndexSharedPtr> DestinationIPsMap;
+  typedef Network::LcTrie::LcTrie<ServerNamesIndexSharedPtr> DestinationIPsTrie;
   typedef std::unique_ptr<DestinationIPsTrie> DestinationIPsTriePtr;
   typedef std::unordered_map<uint16_t, std::pair<DestinationIPsMap, DestinationIPsTriePtr>>
       DestinationPortsMap;
@@ -322,7 +445,8 @@ private:
                       const std::string& transport_protocol,
                       const std::vector<std::string>& application_protocols,
                       Network::TransportSocketFactoryPtr&& transport_socket_factory,
-                      std::vector<Network::FilterFactoryCb> filters_factory);
+                      std::vector<Network::FilterFactoryCb> filters_factory,
+                      std::unique_ptr<FilterChainFactoryContextImpl>&& factory_context);
   void addFilterChainForDestinationPorts(DestinationPortsMap& destination_ports_map,
                                          uint16_t destination_port,
                                          const std::vector<std::string>& destination_ips,
@@ -336,7 +460,9 @@ private:
                                        const std::string& transport_protocol,
                                        const std::vector<std::string>& application_protocols,
                                        const Network::FilterChainSharedPtr& filter_chain);
-  void addFilterChainForServerNames(ServerNamesMap& server_names_map,
+  static ServerNamesIndex& serverNamesIndex(DestinationIPsMap& destination_ips_map,
+                                            const std::string& destination_ip);
+  void addFilterChainForServerNames(ServerNamesIndex& server_names_index,
                                     const std::vector<std::string>& server_names,
                                     const std::string& transport_protocol,
                                     const std::vector<std::string>& application_protocols,
@@ -351,7 +477,7 @@ private:
   findFilterChainForDestinationIP(const DestinationIPsTrie& destination_ips_trie,
                                   const Network::ConnectionSocket& socket) const;
   const Network::FilterChain*
-  findFilterChainForServerName(const ServerNamesMap& server_names_map,
+  findFilterChainForServerName(const ServerNamesIndex& server_names_index,
                                const Network::ConnectionSocket& socket) const;
   const Network::FilterChain*
   findFilterChainForTransportProtocol(const TransportProtocolsMap& transport_protocols_map,
@@ -365,15 +491,22 @@ private:
   // Mapping of FilterChain's configured destination ports, IPs, server names, transport protocols
   // and application protocols, using structures defined above.
   DestinationPortsMap destination_ports_map_;
+  // The filter chains in the order of config_.filter_chains().
+  std::vector<std::shared_ptr<FilterChainImpl>> filter_chains_;
 
   ListenerManagerImpl& parent_;
   Network::Address::InstanceConstSharedPtr address_;
-  Network::SocketSharedPtr socket_;
+  std::vector<Network::SocketSharedPtr> sockets_;
+  std::vector<WorkerListenerConfigPtr> worker_listener_configs_;
   Stats::ScopePtr global_scope_;   // Stats with global named scope, but needed for LDS cleanup.
   Stats::ScopePtr listener_scope_; // Stats with listener named scope.
+  const Network::Address::SocketType socket_type_;
   const bool bind_to_port_;
+  const bool reuse_port_;
   const bool hand_off_restored_destination_connections_;
   const uint32_t per_connection_buffer_limit_bytes_;
+  const uint32_t max_accepts_per_wakeup_;
+  const uint32_t per_connection_read_budget_bytes_;
   const uint64_t listener_tag_;
   const std::string name_;
   const bool modifiable_;
@@ -382,20 +515,79 @@ private:
   InitManagerImpl dynamic_init_manager_;
   bool initialize_canceled_{};
   std::vector<Network::ListenerFilterFactoryCb> listener_filter_factories_;
+  std::vector<Network::UdpListenerFilterFactoryCb> udp_listener_filter_factories_;
   DrainManagerPtr local_drain_manager_;
   bool saw_listener_create_failure_{};
   const envoy::api::v2::Listener config_;
   const std::string version_info_;
   Network::Socket::OptionsSharedPtr listen_socket_options_;
+  Network::ConnectionBalancerPtr connection_balancer_;
+};
+
+/**
+ * The factory context of the network filters of a filter chain. Everything but the drain decision
+ * is the listener's, so that the connections of a filter chain which an update of the listener
+ * kept do not drain with the listener.
+ */
+class FilterChainFactoryContextImpl : public Configuration::FactoryContext,
+                                      public Network::DrainDecision {
+public:
+  FilterChainFactoryContextImpl(ListenerImpl& parent) : parent_(parent) {}
+
+  /**
+   * Keep the connections of the filter chain from draining with the listener. Called on the main
+   * thread while workers may be reading drainClose().
+   */
+  void keep() { kept_ = true; }
+
+  // Configuration::FactoryContext
+  AccessLog::AccessLogManager& accessLogManager() override { return parent_.accessLogManager(); }
+  Upstream::ClusterManager& clusterManager() override { return parent_.clusterManager(); }
+  Event::Dispatcher& dispatcher() override { return parent_.dispatcher(); }
+  Network::DrainDecision& drainDecision() override { return *this; }
+  bool healthCheckFailed() override { return parent_.healthCheckFailed(); }
+  Tracing::HttpTracer& httpTracer() override { return parent_.httpTracer(); }
+  Init::Manager& initManager() override { return parent_.initManager(); }
+  const LocalInfo::LocalInfo& localInfo() const override { return parent_.localInfo(); }
+  Envoy::Runtime::RandomGenerator& random() override { return parent_.random(); }
+  RateLimit::ClientPtr
+  rateLimitClient(const absl::optional<std::chrono::milliseconds>& timeout) override {
+    return parent_.rateLimitClient(timeout);
+  }
+  Envoy::Runtime::Loader& runtime() override { return parent_.runtime(); }
+  Stats::Scope& scope() override { return parent_.scope(); }
+  Singleton::Manager& singletonManager() override { return parent_.singletonManager(); }
+  ThreadLocal::Instance& threadLocal() override { return parent_.threadLocal(); }
+  Admin& admin() override { return parent_.admin(); }
+  Stats::Scope& listenerScope() override { return parent_.listenerScope(); }
+  const envoy::api::v2::core::Metadata& listenerMetadata() const override {
+    return parent_.listenerMetadata();
+  }
+  TimeSource& timeSource() override { return parent_.timeSource(); }
+
+  // Network::DrainDecision
+  bool drainClose() const override {
+    // New connections of a kept filter chain go to the listener that replaced this one, so its
+    // connections only drain with the server.
+    return kept_ ? parent_.serverDrainClose() : parent_.drainClose();
+  }
+
+private:
+  ListenerImpl& parent_;
+  std::atomic<bool> kept_{};
 };
 
 class FilterChainImpl : public Network::FilterChain {
 public:
   FilterChainImpl(Network::TransportSocketFactoryPtr&& transport_socket_factory,
-                  std::vector<Network::FilterFactoryCb> filters_factory)
-      : transport_socket_factory_(std::move(transport_socket_factory)),
+                  std::vector<Network::FilterFactoryCb> filters_factory,
+                  std::unique_ptr<FilterChainFactoryContextImpl>&& factory_context)
+      : factory_context_(std::move(factory_context)),
+        transport_socket_factory_(std::move(transport_socket_factory)),
         filters_factory_(std::move(filters_factory)) {}
 
+  FilterChainFactoryContextImpl& factoryContext() { return *factory_context_; }
+
   // Network::FilterChain
   const Network::TransportSocketFactory& transportSocketFactory() const override {
     return *transport_socket_factory_;
@@ -406,6 +598,8 @@ public:
   }
 
 private:
+  // Declared first so that it outlives the filter factories created with it.
+  const std::unique_ptr<FilterChainFactoryContextImpl> factory_context_;
   const Network::TransportSocketFactoryPtr transport_socket_factory_;
   const std::vector<Network::FilterFactoryCb> filters_factory_;
 };
@@ -4,13 +4,17 @@
 #include <cstdint>
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include "common/common/fmt.h"
 #include "common/common/logger.h"
 #include "common/common/macros.h"
+#include "common/common/thread.h"
 #include "common/common/version.h"
 #include "common/protobuf/utility.h"
 
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
 #include "spdlog/spdlog.h"
 #include "tclap/CmdLine.h"
 
@@ -31,6 +35,35 @@
 #endif
 
 namespace Envoy {
+namespace {
+
+// Parses a CPU list in the format taskset(1) accepts, e.g. "0-3,8,10-11". "auto" selects every CPU
+// the process may run on.
+std::vector<uint32_t> parseCpuList(const std::string& list) {
+  if (list == "auto") {
+    return Thread::Thread::allowedCpus();
+  }
+
+  std::vector<uint32_t> cpus;
+  for (absl::string_view range : absl::StrSplit(list, ',')) {
+    const std::vector<absl::string_view> bounds = absl::StrSplit(range, absl::MaxSplits('-', 1));
+    uint32_t first;
+    uint32_t last;
+    if (!absl::SimpleAtoi(bounds[0], &first) ||
+        !absl::SimpleAtoi(bounds.size() == 2 ? bounds[1] : bounds[0], &last) || last < first) {
+      const std::string message = fmt::format("error: invalid CPU list '{}'", list);
+      std::cerr << message << std::endl;
+      throw MalformedArgvException(message);
+    }
+    for (uint32_t cpu = first; cpu <= last; cpu++) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+} // namespace
+
 OptionsImpl::OptionsImpl(int argc, const char* const* argv,
                          const HotRestartVersionCb& hot_restart_version_cb,
                          spdlog::level::level_enum default_log_level) {
@@ -81,6 +114,10 @@ OptionsImpl::OptionsImpl(int argc, const char* const* argv,
                                           Logger::Logger::DEFAULT_LOG_FORMAT, "string", cmd);
   TCLAP::ValueArg<std::string> log_path("", "log-path", "Path to logfile", false, "", "string",
                                         cmd);
+  TCLAP::ValueArg<uint32_t> log_async_buffer_bytes(
+      "", "log-async-buffer-bytes",
+      "Size in bytes of each thread's log buffer when logging asynchronously (0 disables it)",
+      false, 0, "uint32_t", cmd);
   TCLAP::ValueArg<uint32_t> restart_epoch("", "restart-epoch", "hot restart epoch #", false, 0,
                                           "uint32_t", cmd);
   TCLAP::SwitchArg hot_restart_version_option("", "hot-restart-version",
@@ -115,6 +152,38 @@ OptionsImpl::OptionsImpl(int argc, const char* const* argv,
                                              cmd);
   TCLAP::SwitchArg disable_hot_restart("", "disable-hot-restart",
                                        "Disable hot restart functionality", cmd, false);
+  TCLAP::SwitchArg hot_restart_transfer_connections(
+      "", "hot-restart-transfer-connections",
+      "Take over idle downstream connections from the parent process on hot restart", cmd, false);
+  TCLAP::SwitchArg experimental_io_uring(
+      "", "experimental-io-uring", "Use io_uring for listener accepts where the kernel supports it",
+      cmd, false);
+  TCLAP::ValueArg<uint32_t> coarse_timer_resolution_ms(
+      "", "coarse-timer-resolution-ms",
+      "Resolution in msec of the timer wheel serving idle and request timeouts (0 disables it)",
+      false, 0, "uint32_t", cmd);
+  TCLAP::ValueArg<std::string> worker_cpu_affinity(
+      "", "worker-cpu-affinity",
+      "CPUs to pin workers to, e.g. '0-3,8', or 'auto' for every CPU Envoy may run on", false, "",
+      "string", cmd);
+  TCLAP::SwitchArg worker_numa_local_memory("", "worker-numa-local-memory",
+                                            "Allocate worker memory from the worker's NUMA node",
+                                            cmd, false);
+  TCLAP::SwitchArg reuse_port_incoming_cpu(
+      "", "reuse-port-incoming-cpu",
+      "Steer reuse_port connections to the worker pinned to the CPU that received them", cmd,
+      false);
+  TCLAP::SwitchArg dispatcher_stats("", "dispatcher-stats",
+                                    "Record event loop stats for the main thread and workers", cmd,
+                                    false);
+  TCLAP::ValueArg<uint32_t> dispatcher_stall_threshold_ms(
+      "", "dispatcher-stall-threshold-ms",
+      "Event loop iteration duration in msec above which a stall is logged (0 disables it)",
+      false, 0, "uint32_t", cmd);
+  TCLAP::ValueArg<uint32_t> huge_page_arena_mb(
+      "", "huge-page-arena-mb",
+      "MiB of huge page memory to prefault for LB tables and stats (0 disables the arena)", false,
+      0, "uint32_t", cmd);
 
   cmd.setExceptionHandling(false);
   try {
@@ -149,6 +218,8 @@ OptionsImpl::OptionsImpl(int argc, const char* const* argv,
   // TODO(jmarantz): should we also multiply these to bound the total amount of memory?
 
   hot_restart_disabled_ = disable_hot_restart.getValue();
+  hot_restart_transfer_connections_ = hot_restart_transfer_connections.getValue();
+  io_uring_enabled_ = experimental_io_uring.getValue();
 
   log_level_ = default_log_level;
   for (size_t i = 0; i < ARRAY_SIZE(spdlog::level::level_names); i++) {
@@ -193,11 +264,22 @@ OptionsImpl::OptionsImpl(int argc, const char* const* argv,
   }
   admin_address_path_ = admin_address_path.getValue();
   log_path_ = log_path.getValue();
+  log_async_buffer_size_ = log_async_buffer_bytes.getValue();
   restart_epoch_ = restart_epoch.getValue();
   service_cluster_ = service_cluster.getValue();
   service_node_ = service_node.getValue();
   service_zone_ = service_zone.getValue();
   file_flush_interval_msec_ = std::chrono::milliseconds(file_flush_interval_msec.getValue());
+  coarse_timer_resolution_ = std::chrono::milliseconds(coarse_timer_resolution_ms.getValue());
+  if (!worker_cpu_affinity.getValue().empty()) {
+    worker_cpus_ = parseCpuList(worker_cpu_affinity.getValue());
+  }
+  worker_numa_local_memory_ = worker_numa_local_memory.getValue();
+  reuse_port_incoming_cpu_ = reuse_port_incoming_cpu.getValue();
+  dispatcher_stats_enabled_ = dispatcher_stats.getValue();
+  dispatcher_stall_threshold_ =
+      std::chrono::milliseconds(dispatcher_stall_threshold_ms.getValue());
+  huge_page_arena_size_mb_ = huge_page_arena_mb.getValue();
   drain_time_ = std::chrono::seconds(drain_time_s.getValue());
   parent_shutdown_time_ = std::chrono::seconds(parent_shutdown_time_s.getValue());
   max_stats_ = max_stats.getValue();
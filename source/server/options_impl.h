@@ -3,6 +3,7 @@
 #include <chrono>
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "envoy/common/exception.h"
 #include "envoy/server/options.h"
@@ -49,6 +50,9 @@ public:
   void setLogLevel(spdlog::level::level_enum log_level) { log_level_ = log_level; }
   void setLogFormat(const std::string& log_format) { log_format_ = log_format; }
   void setLogPath(const std::string& log_path) { log_path_ = log_path; }
+  void setLogAsyncBufferSize(uint32_t log_async_buffer_size) {
+    log_async_buffer_size_ = log_async_buffer_size;
+  }
   void setParentShutdownTime(std::chrono::seconds parent_shutdown_time) {
     parent_shutdown_time_ = parent_shutdown_time;
   }
@@ -67,6 +71,29 @@ public:
   void setHotRestartDisabled(bool hot_restart_disabled) {
     hot_restart_disabled_ = hot_restart_disabled;
   }
+  void setHotRestartTransferConnections(bool hot_restart_transfer_connections) {
+    hot_restart_transfer_connections_ = hot_restart_transfer_connections;
+  }
+  void setIoUringEnabled(bool io_uring_enabled) { io_uring_enabled_ = io_uring_enabled; }
+  void setCoarseTimerResolution(std::chrono::milliseconds coarse_timer_resolution) {
+    coarse_timer_resolution_ = coarse_timer_resolution;
+  }
+  void setWorkerCpus(const std::vector<uint32_t>& worker_cpus) { worker_cpus_ = worker_cpus; }
+  void setWorkerNumaLocalMemory(bool worker_numa_local_memory) {
+    worker_numa_local_memory_ = worker_numa_local_memory;
+  }
+  void setReusePortIncomingCpu(bool reuse_port_incoming_cpu) {
+    reuse_port_incoming_cpu_ = reuse_port_incoming_cpu;
+  }
+  void setDispatcherStatsEnabled(bool dispatcher_stats_enabled) {
+    dispatcher_stats_enabled_ = dispatcher_stats_enabled;
+  }
+  void setDispatcherStallThreshold(std::chrono::milliseconds dispatcher_stall_threshold) {
+    dispatcher_stall_threshold_ = dispatcher_stall_threshold;
+  }
+  void setHugePageArenaSizeMb(uint32_t huge_page_arena_size_mb) {
+    huge_page_arena_size_mb_ = huge_page_arena_size_mb;
+  }
 
   // Server::Options
   uint64_t baseId() const override { return base_id_; }
@@ -82,6 +109,7 @@ public:
   spdlog::level::level_enum logLevel() const override { return log_level_; }
   const std::string& logFormat() const override { return log_format_; }
   const std::string& logPath() const override { return log_path_; }
+  uint32_t logAsyncBufferSize() const override { return log_async_buffer_size_; }
   std::chrono::seconds parentShutdownTime() const override { return parent_shutdown_time_; }
   uint64_t restartEpoch() const override { return restart_epoch_; }
   Server::Mode mode() const override { return mode_; }
@@ -94,6 +122,21 @@ public:
   uint64_t maxStats() const override { return max_stats_; }
   const Stats::StatsOptions& statsOptions() const override { return stats_options_; }
   bool hotRestartDisabled() const override { return hot_restart_disabled_; }
+  bool hotRestartTransferConnections() const override {
+    return hot_restart_transfer_connections_;
+  }
+  bool ioUringEnabled() const override { return io_uring_enabled_; }
+  std::chrono::milliseconds coarseTimerResolution() const override {
+    return coarse_timer_resolution_;
+  }
+  const std::vector<uint32_t>& workerCpus() const override { return worker_cpus_; }
+  bool workerNumaLocalMemory() const override { return worker_numa_local_memory_; }
+  bool reusePortIncomingCpu() const override { return reuse_port_incoming_cpu_; }
+  bool dispatcherStatsEnabled() const override { return dispatcher_stats_enabled_; }
+  std::chrono::milliseconds dispatcherStallThreshold() const override {
+    return dispatcher_stall_threshold_;
+  }
+  uint32_t hugePageArenaSizeMb() const override { return huge_page_arena_size_mb_; }
 
 private:
   uint64_t base_id_;
@@ -106,6 +149,7 @@ private:
   spdlog::level::level_enum log_level_;
   std::string log_format_;
   std::string log_path_;
+  uint32_t log_async_buffer_size_;
   uint64_t restart_epoch_;
   std::string service_cluster_;
   std::string service_node_;
@@ -117,6 +161,15 @@ private:
   uint64_t max_stats_;
   Stats::StatsOptionsImpl stats_options_;
   bool hot_restart_disabled_;
+  bool hot_restart_transfer_connections_;
+  bool io_uring_enabled_;
+  std::chrono::milliseconds coarse_timer_resolution_;
+  std::vector<uint32_t> worker_cpus_;
+  bool worker_numa_local_memory_;
+  bool reuse_port_incoming_cpu_;
+  bool dispatcher_stats_enabled_;
+  std::chrono::milliseconds dispatcher_stall_threshold_;
+  uint32_t huge_page_arena_size_mb_;
 };
 
 /**
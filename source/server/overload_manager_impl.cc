@@ -20,19 +20,45 @@ public:
   ThresholdTriggerImpl(const envoy::config::overload::v2alpha::ThresholdTrigger& config)
       : threshold_(config.value()) {}
 
-  bool updateValue(double value) {
-    const bool fired = isFired();
-    value_ = value;
-    return fired != isFired();
-  }
+  void updateValue(double value) override { value_ = value; }
 
-  bool isFired() const { return value_.has_value() && value_ >= threshold_; }
+  double actionValue() const override {
+    return value_.has_value() && value_ >= threshold_ ? 1 : 0;
+  }
 
 private:
   const double threshold_;
   absl::optional<double> value_;
 };
 
+class ScaledTriggerImpl : public OverloadAction::Trigger {
+public:
+  ScaledTriggerImpl(const envoy::config::overload::v2alpha::ScaledTrigger& config)
+      : scaling_threshold_(config.scaling_threshold()),
+        saturation_threshold_(config.saturation_threshold()) {
+    if (scaling_threshold_ >= saturation_threshold_) {
+      throw EnvoyException("scaling_threshold must be less than saturation_threshold");
+    }
+  }
+
+  void updateValue(double value) override { value_ = value; }
+
+  double actionValue() const override {
+    if (!value_.has_value() || value_ < scaling_threshold_) {
+      return 0;
+    }
+    if (value_ >= saturation_threshold_) {
+      return 1;
+    }
+    return (value_.value() - scaling_threshold_) / (saturation_threshold_ - scaling_threshold_);
+  }
+
+private:
+  const double scaling_threshold_;
+  const double saturation_threshold_;
+  absl::optional<double> value_;
+};
+
 std::string StatsName(const std::string& a, const std::string& b) {
   return absl::StrCat("overload.", a, b);
 }
@@ -41,7 +67,8 @@ std::string StatsName(const std::string& a, const std::string& b) {
 
 OverloadAction::OverloadAction(const envoy::config::overload::v2alpha::OverloadAction& config,
                                Stats::Scope& stats_scope)
-    : active_gauge_(stats_scope.gauge(StatsName(config.name(), ".active"))) {
+    : active_gauge_(stats_scope.gauge(StatsName(config.name(), ".active"))),
+      scale_percent_gauge_(stats_scope.gauge(StatsName(config.name(), ".scale_percent"))) {
   for (const auto& trigger_config : config.triggers()) {
     TriggerPtr trigger;
 
@@ -49,6 +76,9 @@ OverloadAction::OverloadAction(const envoy::config::overload::v2alpha::OverloadA
     case envoy::config::overload::v2alpha::Trigger::kThreshold:
       trigger = std::make_unique<ThresholdTriggerImpl>(trigger_config.threshold());
       break;
+    case envoy::config::overload::v2alpha::Trigger::kScaled:
+      trigger = std::make_unique<ScaledTriggerImpl>(trigger_config.scaled());
+      break;
     default:
       NOT_REACHED_GCOVR_EXCL_LINE;
     }
@@ -65,22 +95,20 @@ bool OverloadAction::updateResourcePressure(const std::string& name, double pres
 
   auto it = triggers_.find(name);
   ASSERT(it != triggers_.end());
-  if (it->second->updateValue(pressure)) {
-    if (it->second->isFired()) {
-      active_gauge_.set(1);
-      const auto result = fired_triggers_.insert(name);
-      ASSERT(result.second);
-    } else {
-      active_gauge_.set(0);
-      const auto result = fired_triggers_.erase(name);
-      ASSERT(result == 1);
-    }
+  it->second->updateValue(pressure);
+
+  double value = 0;
+  for (const auto& trigger : triggers_) {
+    value = std::max(value, trigger.second->actionValue());
   }
+  value_.setValue(value);
+  active_gauge_.set(isActive() ? 1 : 0);
+  scale_percent_gauge_.set(value * 100);
 
   return active != isActive();
 }
 
-bool OverloadAction::isActive() const { return !fired_triggers_.empty(); }
+bool OverloadAction::isActive() const { return value_.value() >= 1; }
 
 OverloadManagerImpl::OverloadManagerImpl(
     Event::Dispatcher& dispatcher, Stats::Scope& stats_scope,
@@ -126,15 +154,18 @@ OverloadManagerImpl::OverloadManagerImpl(
       resource_to_actions_.insert(std::make_pair(resource, name));
     }
   }
-
-  tls_->set([](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
-    return std::make_shared<ThreadLocalOverloadState>();
-  });
 }
 
 void OverloadManagerImpl::start() {
   ASSERT(!started_);
   started_ = true;
+
+  // The thread local state is set once the workers have registered for thread local updates,
+  // since they are created after the overload manager so that they can register for actions.
+  tls_->set([](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<ThreadLocalOverloadState>();
+  });
+
   if (resources_.empty()) {
     return;
   }
@@ -162,10 +193,32 @@ void OverloadManagerImpl::registerForAction(const std::string& action,
                                std::forward_as_tuple(dispatcher, callback));
 }
 
+void OverloadManagerImpl::registerForActionValue(const std::string& action,
+                                                 Event::Dispatcher& dispatcher,
+                                                 OverloadActionValueCb callback) {
+  ASSERT(!started_);
+
+  if (actions_.find(action) == actions_.end()) {
+    ENVOY_LOG(debug, "No overload action configured for {}.", action);
+    return;
+  }
+
+  action_to_value_callbacks_.emplace(std::piecewise_construct, std::forward_as_tuple(action),
+                                     std::forward_as_tuple(dispatcher, callback));
+}
+
 ThreadLocalOverloadState& OverloadManagerImpl::getThreadLocalOverloadState() {
   return tls_->getTyped<ThreadLocalOverloadState>();
 }
 
+const OverloadActionValue& OverloadManagerImpl::getActionValue(const std::string& action) {
+  auto it = actions_.find(action);
+  if (it == actions_.end()) {
+    return inactive_action_value_;
+  }
+  return it->second.value();
+}
+
 void OverloadManagerImpl::updateResourcePressure(const std::string& resource, double pressure) {
   auto action_range = resource_to_actions_.equal_range(resource);
   std::for_each(action_range.first, action_range.second,
@@ -173,7 +226,20 @@ void OverloadManagerImpl::updateResourcePressure(const std::string& resource, do
                   const std::string& action = entry.second;
                   auto action_it = actions_.find(action);
                   ASSERT(action_it != actions_.end());
-                  if (action_it->second.updateResourcePressure(resource, pressure)) {
+                  const double previous_value = action_it->second.value().value();
+                  const bool state_changed =
+                      action_it->second.updateResourcePressure(resource, pressure);
+                  const double value = action_it->second.value().value();
+                  if (value > 0 || value != previous_value) {
+                    auto value_callback_range = action_to_value_callbacks_.equal_range(action);
+                    std::for_each(value_callback_range.first, value_callback_range.second,
+                                  [&](ActionToValueCallbackMap::value_type& cb_entry) {
+                                    OverloadActionValueCb callback = cb_entry.second.callback_;
+                                    cb_entry.second.dispatcher_.post(
+                                        [callback, value]() { callback(value); });
+                                  });
+                  }
+                  if (state_changed) {
                     const bool is_active = action_it->second.isActive();
                     const auto state =
                         is_active ? OverloadActionState::Active : OverloadActionState::Inactive;
@@ -2,7 +2,6 @@
 
 #include <chrono>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 #include "envoy/config/overload/v2alpha/overload.pb.validate.h"
@@ -30,22 +29,26 @@ public:
   // Returns whether the action is currently active or not.
   bool isActive() const;
 
+  // Returns the scaled value of the action.
+  const OverloadActionValue& value() const { return value_; }
+
   class Trigger {
   public:
     virtual ~Trigger() {}
 
-    // Updates the current value of the metric and returns whether the trigger has changed state.
-    virtual bool updateValue(double value) PURE;
+    // Updates the current value of the metric.
+    virtual void updateValue(double value) PURE;
 
-    // Returns whether the trigger is currently fired or not.
-    virtual bool isFired() const PURE;
+    // Returns the value the trigger contributes to its action, between 0 and 1.
+    virtual double actionValue() const PURE;
   };
   typedef std::unique_ptr<Trigger> TriggerPtr;
 
 private:
   std::unordered_map<std::string, TriggerPtr> triggers_;
-  std::unordered_set<std::string> fired_triggers_;
+  OverloadActionValue value_;
   Stats::Gauge& active_gauge_;
+  Stats::Gauge& scale_percent_gauge_;
 };
 
 class OverloadManagerImpl : Logger::Loggable<Logger::Id::main>, public OverloadManager {
@@ -58,7 +61,10 @@ public:
   void start() override;
   void registerForAction(const std::string& action, Event::Dispatcher& dispatcher,
                          OverloadActionCb callback) override;
+  void registerForActionValue(const std::string& action, Event::Dispatcher& dispatcher,
+                              OverloadActionValueCb callback) override;
   ThreadLocalOverloadState& getThreadLocalOverloadState() override;
+  const OverloadActionValue& getActionValue(const std::string& action) override;
 
 private:
   class Resource : public ResourceMonitor::Callbacks {
@@ -89,6 +95,13 @@ private:
     OverloadActionCb callback_;
   };
 
+  struct ActionValueCallback {
+    ActionValueCallback(Event::Dispatcher& dispatcher, OverloadActionValueCb callback)
+        : dispatcher_(dispatcher), callback_(callback) {}
+    Event::Dispatcher& dispatcher_;
+    OverloadActionValueCb callback_;
+  };
+
   void updateResourcePressure(const std::string& resource, double pressure);
 
   bool started_;
@@ -98,12 +111,17 @@ private:
   Event::TimerPtr timer_;
   std::unordered_map<std::string, Resource> resources_;
   std::unordered_map<std::string, OverloadAction> actions_;
+  // The value of the actions that aren't configured.
+  const OverloadActionValue inactive_action_value_;
 
   typedef std::unordered_multimap<std::string, std::string> ResourceToActionMap;
   ResourceToActionMap resource_to_actions_;
 
   typedef std::unordered_multimap<std::string, ActionCallback> ActionToCallbackMap;
   ActionToCallbackMap action_to_callbacks_;
+
+  typedef std::unordered_multimap<std::string, ActionValueCallback> ActionToValueCallbackMap;
+  ActionToValueCallbackMap action_to_value_callbacks_;
 };
 
 } // namespace Server
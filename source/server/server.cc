@@ -25,6 +25,8 @@
 #include "common/config/resources.h"
 #include "common/config/utility.h"
 #include "common/local_info/local_info_impl.h"
+#include "common/memory/accounting.h"
+#include "common/memory/huge_page_arena.h"
 #include "common/memory/stats.h"
 #include "common/network/address_impl.h"
 #include "common/protobuf/utility.h"
@@ -50,16 +52,23 @@ InstanceImpl::InstanceImpl(Options& options, Event::TimeSystem& time_system,
                            Runtime::RandomGeneratorPtr&& random_generator,
                            ThreadLocal::Instance& tls)
     : options_(options), time_system_(time_system), restarter_(restarter),
-      start_time_(time(nullptr)), original_start_time_(start_time_), stats_store_(store),
-      thread_local_(tls), api_(new Api::Impl(options.fileFlushIntervalMsec())),
+      start_time_(time(nullptr)), original_start_time_(start_time_),
+      startup_timeline_(time_system), stats_store_(store),
+      thread_local_(tls), api_(new Api::Impl(options.fileFlushIntervalMsec(),
+                                             options.ioUringEnabled(),
+                                             options.coarseTimerResolution())),
       dispatcher_(api_->allocateDispatcher(time_system)),
       singleton_manager_(new Singleton::ManagerImpl()),
       handler_(new ConnectionHandlerImpl(ENVOY_LOGGER(), *dispatcher_)),
       random_generator_(std::move(random_generator)),
       secret_manager_(std::make_unique<Secret::SecretManagerImpl>()),
-      listener_component_factory_(*this), worker_factory_(thread_local_, *api_, hooks, time_system),
+      listener_component_factory_(*this),
+      worker_factory_(thread_local_, *api_, hooks, time_system, options, store),
       dns_resolver_(dispatcher_->createDnsResolver({})),
       access_log_manager_(*api_, *dispatcher_, access_log_lock, store), terminated_(false) {
+  if (options.dispatcherStatsEnabled()) {
+    dispatcher_->initializeStats(stats_store_, "main_thread.", options.dispatcherStallThreshold());
+  }
 
   try {
     if (!options.logPath().empty()) {
@@ -71,6 +80,10 @@ InstanceImpl::InstanceImpl(Options& options, Event::TimeSystem& time_system,
             fmt::format("Failed to open log-file '{}'. e.what(): {}", options.logPath(), e.what()));
       }
     }
+    if (options.logAsyncBufferSize() > 0) {
+      async_logger_ = std::make_unique<Logger::AsyncSinkDelegate>(options.logAsyncBufferSize(),
+                                                                  Logger::Registry::getSink());
+    }
 
     restarter_.initialize(*dispatcher_, *this);
     drain_manager_ = component_factory.createDrainManager(*this);
@@ -96,6 +109,7 @@ InstanceImpl::~InstanceImpl() {
 
   // Stop logging to file before all the AccessLogManager and its dependencies are
   // destructed to avoid crashing at shutdown.
+  async_logger_.reset();
   file_logger_.reset();
 
   // Destruct the ListenerManager explicitly, before InstanceImpl's local init_manager_ is
@@ -146,10 +160,24 @@ void InstanceImpl::flushStats() {
     server_stats_->memory_allocated_.set(Memory::Stats::totalCurrentlyAllocated() +
                                          info.memory_allocated_);
     server_stats_->memory_heap_size_.set(Memory::Stats::totalCurrentlyReserved());
+    server_stats_->memory_huge_page_arena_mapped_.set(Memory::HugePageArena::bytesMapped());
+    server_stats_->memory_huge_page_arena_huge_tlb_.set(
+        Memory::HugePageArena::bytesMappedHugeTlb());
+    server_stats_->memory_huge_page_arena_allocated_.set(Memory::HugePageArena::bytesAllocated());
+    server_stats_->memory_accounted_buffers_.set(Memory::Accounting::bytes(Memory::Tag::Buffers));
+    server_stats_->memory_accounted_http2_sessions_.set(
+        Memory::Accounting::bytes(Memory::Tag::Http2Sessions));
+    server_stats_->memory_accounted_hosts_.set(Memory::Accounting::bytes(Memory::Tag::Hosts));
+    server_stats_->memory_accounted_route_tables_.set(
+        Memory::Accounting::bytes(Memory::Tag::RouteTables));
+    server_stats_->memory_accounted_stats_.set(Memory::Accounting::bytes(Memory::Tag::Stats));
     server_stats_->parent_connections_.set(info.num_connections_);
     server_stats_->total_connections_.set(numConnections() + info.num_connections_);
     server_stats_->days_until_first_cert_expiring_.set(
         sslContextManager().daysUntilFirstCertExpires());
+    if (async_logger_ != nullptr) {
+      server_stats_->log_messages_dropped_.set(async_logger_->droppedMessages());
+    }
     InstanceUtil::flushMetricsToSinks(config_->statsSinks(), stats_store_.source());
     // TODO(ramaraochavali): consider adding different flush interval for histograms.
     if (stat_flush_timer_ != nullptr) {
@@ -225,7 +253,9 @@ void InstanceImpl::initialize(Options& options,
                 Configuration::UpstreamTransportSocketConfigFactory>::allFactoryNames());
 
   // Handle configuration that needs to take place prior to the main configuration load.
+  uint64_t phase = startup_timeline_.startPhase("bootstrap_load");
   InstanceUtil::loadBootstrapConfig(bootstrap_, options);
+  startup_timeline_.endPhase(phase);
   bootstrap_config_update_time_ = time_system_.systemTime();
 
   // Needs to happen as early as possible in the instantiation to preempt the objects that require
@@ -263,12 +293,26 @@ void InstanceImpl::initialize(Options& options,
                              initial_config.admin().profilePath(), options.adminAddressPath(),
                              initial_config.admin().address(), *this,
                              stats_store_.createScope("listener.admin.")));
+  admin_->startRenderThread();
   config_tracker_entry_ =
       admin_->getConfigTracker().add("bootstrap", [this] { return dumpBootstrapConfig(); });
+  admin_->addHandler("/startup", "print the startup timeline",
+                     [this](absl::string_view, Http::HeaderMap&, Buffer::Instance& response,
+                            AdminStream&) -> Http::Code {
+                       response.add(MessageUtil::getJsonStringFromMessage(
+                           startup_timeline_.toProto(), true)); // pretty-print
+                       return Http::Code::OK;
+                     },
+                     false, false);
   handler_->addListener(admin_->listener());
 
   loadServerFlags(initial_config.flagsPath());
 
+  // Initialize the overload manager early so other modules, including the workers, can register
+  // for actions.
+  overload_manager_.reset(
+      new OverloadManagerImpl(dispatcher(), stats(), threadLocal(), bootstrap_.overload_manager()));
+
   // Workers get created first so they register for thread local updates.
   listener_manager_.reset(
       new ListenerManagerImpl(*this, listener_component_factory_, worker_factory_, time_system_));
@@ -277,16 +321,16 @@ void InstanceImpl::initialize(Options& options,
   // whether it runs on the main thread or on workers can still use TLS.
   thread_local_.registerThread(*dispatcher_, true);
 
-  // Initialize the overload manager early so other modules can register for actions.
-  overload_manager_.reset(
-      new OverloadManagerImpl(dispatcher(), stats(), threadLocal(), bootstrap_.overload_manager()));
-
   // We can now initialize stats for threading.
   stats_store_.initializeThreading(*dispatcher_, thread_local_);
+  startup_timeline_.initializeStats(stats_store_);
+  init_manager_.setStartupTimeline(startup_timeline_);
 
   // Runtime gets initialized before the main configuration since during main configuration
   // load things may grab a reference to the loader for later use.
+  phase = startup_timeline_.startPhase("runtime_init");
   runtime_loader_ = component_factory.createRuntime(*this, initial_config);
+  startup_timeline_.endPhase(phase);
 
   // Once we have runtime we can initialize the SSL context manager.
   ssl_context_manager_.reset(new Ssl::ContextManagerImpl(*runtime_loader_));
@@ -299,7 +343,9 @@ void InstanceImpl::initialize(Options& options,
   // per above. See MainImpl::initialize() for why we do this pointer dance.
   Configuration::MainImpl* main_config = new Configuration::MainImpl();
   config_.reset(main_config);
+  phase = startup_timeline_.startPhase("main_config_load");
   main_config->initialize(bootstrap_, *this, *cluster_manager_factory_);
+  startup_timeline_.endPhase(phase);
 
   // Instruct the listener manager to create the LDS provider if needed. This must be done later
   // because various items do not yet exist when the listener manager is created.
@@ -310,7 +356,8 @@ void InstanceImpl::initialize(Options& options,
   if (bootstrap_.has_hds_config()) {
     const auto& hds_config = bootstrap_.hds_config();
     async_client_manager_ = std::make_unique<Grpc::AsyncClientManagerImpl>(
-        clusterManager(), thread_local_, time_system_);
+        clusterManager(), thread_local_, time_system_,
+        bootstrap_.cluster_manager().google_grpc_completion_threads());
     hds_delegate_.reset(new Upstream::HdsDelegate(
         bootstrap_.node(), stats(),
         Config::Utility::factoryForGrpcApiConfigSource(*async_client_manager_, hds_config, stats())
@@ -334,11 +381,15 @@ void InstanceImpl::initialize(Options& options,
 }
 
 void InstanceImpl::startWorkers() {
+  const uint64_t phase = startup_timeline_.startPhase("workers_start");
   listener_manager_->startWorkers(*guard_dog_);
+  startup_timeline_.endPhase(phase);
+  startup_timeline_.complete();
 
   // At this point we are ready to take traffic and all listening ports are up. Notify our parent
   // if applicable that they can stop listening and drain.
   restarter_.drainParentListeners();
+  restarter_.transferParentConnections();
   drain_manager_->startParentShutdownSequence();
 }
 
@@ -380,7 +431,7 @@ uint64_t InstanceImpl::numConnections() { return listener_manager_->numConnectio
 RunHelper::RunHelper(Event::Dispatcher& dispatcher, Upstream::ClusterManager& cm,
                      HotRestart& hot_restart, AccessLog::AccessLogManager& access_log_manager,
                      InitManagerImpl& init_manager, OverloadManager& overload_manager,
-                     std::function<void()> workers_start_cb) {
+                     StartupTimeline& startup_timeline, std::function<void()> workers_start_cb) {
 
   // Setup signals.
   sigterm_ = dispatcher.listenForSignal(SIGTERM, [this, &hot_restart, &dispatcher]() {
@@ -402,7 +453,12 @@ RunHelper::RunHelper(Event::Dispatcher& dispatcher, Upstream::ClusterManager& cm
   // this can fire immediately if all clusters have already initialized. Also note that we need
   // to guard against shutdown at two different levels since SIGTERM can come in once the run loop
   // starts.
-  cm.setInitializedCb([this, &init_manager, &cm, workers_start_cb]() {
+  // The cluster manager initializes the clusters which need it, e.g. those with DNS resolution or
+  // health checks, and then the secondary clusters, e.g. those from CDS, once the run loop runs.
+  const uint64_t cluster_manager_phase = startup_timeline.startPhase("cluster_manager_init");
+  cm.setInitializedCb([this, &init_manager, &cm, &startup_timeline, cluster_manager_phase,
+                       workers_start_cb]() {
+    startup_timeline.endPhase(cluster_manager_phase);
     if (shutdown_) {
       return;
     }
@@ -413,7 +469,9 @@ RunHelper::RunHelper(Event::Dispatcher& dispatcher, Upstream::ClusterManager& cm
     cm.adsMux().pause(Config::TypeUrl::get().RouteConfiguration);
 
     ENVOY_LOG(info, "all clusters initialized. initializing init manager");
-    init_manager.initialize([this, workers_start_cb]() {
+    const uint64_t init_manager_phase = startup_timeline.startPhase("init_manager");
+    init_manager.initialize([this, &startup_timeline, init_manager_phase, workers_start_cb]() {
+      startup_timeline.endPhase(init_manager_phase);
       if (shutdown_) {
         return;
       }
@@ -440,6 +498,7 @@ void InstanceImpl::run() {
   // we save it as a member variable.
   run_helper_ = std::make_unique<RunHelper>(*dispatcher_, clusterManager(), restarter_,
                                             access_log_manager_, init_manager_, overloadManager(),
+                                            startup_timeline_,
                                             [this]() -> void { startWorkers(); });
 
   // Run the main dispatch loop waiting to exit.
@@ -28,6 +28,7 @@
 #include "server/init_manager_impl.h"
 #include "server/listener_manager_impl.h"
 #include "server/overload_manager_impl.h"
+#include "server/startup_timeline.h"
 #include "server/test_hooks.h"
 #include "server/worker_impl.h"
 
@@ -45,12 +46,21 @@ namespace Server {
   GAUGE(concurrency)                                                                               \
   GAUGE(memory_allocated)                                                                          \
   GAUGE(memory_heap_size)                                                                          \
+  GAUGE(memory_huge_page_arena_mapped)                                                             \
+  GAUGE(memory_huge_page_arena_huge_tlb)                                                           \
+  GAUGE(memory_huge_page_arena_allocated)                                                          \
+  GAUGE(memory_accounted_buffers)                                                                  \
+  GAUGE(memory_accounted_http2_sessions)                                                           \
+  GAUGE(memory_accounted_hosts)                                                                    \
+  GAUGE(memory_accounted_route_tables)                                                             \
+  GAUGE(memory_accounted_stats)                                                                    \
   GAUGE(live)                                                                                      \
   GAUGE(parent_connections)                                                                        \
   GAUGE(total_connections)                                                                         \
   GAUGE(version)                                                                                   \
   GAUGE(days_until_first_cert_expiring)                                                            \
-  GAUGE(hot_restart_epoch)
+  GAUGE(hot_restart_epoch)                                                                         \
+  GAUGE(log_messages_dropped)
 // clang-format on
 
 struct ServerStats {
@@ -115,7 +125,8 @@ class RunHelper : Logger::Loggable<Logger::Id::main> {
 public:
   RunHelper(Event::Dispatcher& dispatcher, Upstream::ClusterManager& cm, HotRestart& hot_restart,
             AccessLog::AccessLogManager& access_log_manager, InitManagerImpl& init_manager,
-            OverloadManager& overload_manager, std::function<void()> workers_start_cb);
+            OverloadManager& overload_manager, StartupTimeline& startup_timeline,
+            std::function<void()> workers_start_cb);
 
   // Helper function to inititate a shutdown. This can be triggered either by catching SIGTERM
   // or be called from ServerImpl::shutdown().
@@ -201,6 +212,7 @@ private:
   HotRestart& restarter_;
   const time_t start_time_;
   time_t original_start_time_;
+  StartupTimeline startup_timeline_;
   Stats::StoreRoot& stats_store_;
   std::unique_ptr<ServerStats> server_stats_;
   ThreadLocal::Instance& thread_local_;
@@ -227,6 +239,8 @@ private:
   std::unique_ptr<Server::GuardDog> guard_dog_;
   bool terminated_;
   std::unique_ptr<Logger::FileSinkDelegate> file_logger_;
+  // Declared after file_logger_, as it writes to it until destroyed.
+  std::unique_ptr<Logger::AsyncSinkDelegate> async_logger_;
   envoy::config::bootstrap::v2::Bootstrap bootstrap_;
   ConfigTracker::EntryOwnerPtr config_tracker_entry_;
   SystemTime bootstrap_config_update_time_;
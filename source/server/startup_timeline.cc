@@ -0,0 +1,89 @@
+#include "server/startup_timeline.h"
+
+#include "common/common/assert.h"
+#include "common/protobuf/protobuf.h"
+
+namespace Envoy {
+namespace Server {
+namespace {
+
+uint64_t toMilliseconds(MonotonicTime::duration duration) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+}
+
+ProtobufWkt::Duration toDuration(MonotonicTime::duration duration) {
+  return Protobuf::util::TimeUtil::MicrosecondsToDuration(
+      std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+}
+
+} // namespace
+
+StartupTimeline::StartupTimeline(TimeSource& time_source)
+    : time_source_(time_source), start_(time_source.monotonicTime()) {}
+
+uint64_t StartupTimeline::startPhase(const std::string& name) {
+  phases_.push_back({name, time_source_.monotonicTime(), absl::nullopt});
+  return phases_.size() - 1;
+}
+
+void StartupTimeline::endPhase(uint64_t id) {
+  ASSERT(id < phases_.size());
+  Phase& phase = phases_[id];
+  ASSERT(!phase.end_.has_value());
+  phase.end_ = time_source_.monotonicTime();
+  if (stats_ != nullptr) {
+    recordPhase(phase);
+  }
+}
+
+void StartupTimeline::initializeStats(Stats::Scope& scope) {
+  ASSERT(stats_ == nullptr);
+  stats_.reset(
+      new StartupStats{ALL_STARTUP_STATS(POOL_HISTOGRAM_PREFIX(scope, "server.startup."))});
+#define MAP_HISTOGRAM(NAME) histograms_[#NAME] = &stats_->NAME##_;
+  ALL_STARTUP_STATS(MAP_HISTOGRAM)
+#undef MAP_HISTOGRAM
+
+  for (const Phase& phase : phases_) {
+    if (phase.end_.has_value()) {
+      recordPhase(phase);
+    }
+  }
+  if (end_.has_value()) {
+    stats_->total_ms_.recordValue(toMilliseconds(end_.value() - start_));
+  }
+}
+
+void StartupTimeline::complete() {
+  ASSERT(!end_.has_value());
+  end_ = time_source_.monotonicTime();
+  if (stats_ != nullptr) {
+    stats_->total_ms_.recordValue(toMilliseconds(end_.value() - start_));
+  }
+}
+
+envoy::admin::v2alpha::StartupTimeline StartupTimeline::toProto() const {
+  envoy::admin::v2alpha::StartupTimeline timeline;
+  for (const Phase& phase : phases_) {
+    auto* phase_proto = timeline.add_phases();
+    phase_proto->set_name(phase.name_);
+    *phase_proto->mutable_start() = toDuration(phase.start_ - start_);
+    if (phase.end_.has_value()) {
+      *phase_proto->mutable_duration() = toDuration(phase.end_.value() - phase.start_);
+    }
+  }
+  if (end_.has_value()) {
+    *timeline.mutable_total() = toDuration(end_.value() - start_);
+  }
+  return timeline;
+}
+
+void StartupTimeline::recordPhase(const Phase& phase) {
+  auto it = histograms_.find(phase.name_.substr(0, phase.name_.find('.')) + "_ms");
+  if (it != histograms_.end()) {
+    it->second->recordValue(toMilliseconds(phase.end_.value() - phase.start_));
+  }
+}
+
+} // namespace Server
+} // namespace Envoy
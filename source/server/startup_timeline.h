@@ -0,0 +1,105 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "envoy/admin/v2alpha/startup.pb.h"
+#include "envoy/common/time.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "absl/types/optional.h"
+
+namespace Envoy {
+namespace Server {
+
+/**
+ * All startup stats, in ms. @see stats_macros.h. A phase is recorded to the histogram named after
+ * the part of its name before the first dot, e.g. "init_target.lds" to init_target_ms.
+ */
+// clang-format off
+#define ALL_STARTUP_STATS(HISTOGRAM)                                                               \
+  HISTOGRAM(bootstrap_load_ms)                                                                     \
+  HISTOGRAM(runtime_init_ms)                                                                       \
+  HISTOGRAM(main_config_load_ms)                                                                   \
+  HISTOGRAM(cluster_manager_init_ms)                                                               \
+  HISTOGRAM(init_manager_ms)                                                                       \
+  HISTOGRAM(init_target_ms)                                                                        \
+  HISTOGRAM(workers_start_ms)                                                                      \
+  HISTOGRAM(total_ms)
+// clang-format on
+
+/**
+ * Struct definition for all startup stats. @see stats_macros.h
+ */
+struct StartupStats {
+  ALL_STARTUP_STATS(GENERATE_HISTOGRAM_STRUCT)
+};
+
+/**
+ * Records how long each phase of startup takes, from the construction of the server until its
+ * workers are started. Phases may be nested in or overlap each other, e.g. the targets of the init
+ * manager initialize concurrently within the init_manager phase. Only used on the main thread.
+ */
+class StartupTimeline {
+public:
+  StartupTimeline(TimeSource& time_source);
+
+  /**
+   * Starts a phase.
+   * @param name supplies the name of the phase.
+   * @return uint64_t the id of the phase, to pass to endPhase().
+   */
+  uint64_t startPhase(const std::string& name);
+
+  /**
+   * Ends a phase and records its duration to its histogram, or once initializeStats() is called
+   * if the stats do not exist yet.
+   * @param id supplies the id returned by startPhase().
+   */
+  void endPhase(uint64_t id);
+
+  /**
+   * Creates the startup histograms in a scope and records the phases which already ended.
+   * @param scope supplies the scope, to which "server.startup." is prepended.
+   */
+  void initializeStats(Stats::Scope& scope);
+
+  /**
+   * Ends the timeline and records the total duration of startup. Phases which have not ended
+   * may still end later.
+   */
+  void complete();
+
+  /**
+   * @return bool whether complete() was called.
+   */
+  bool completed() const { return end_.has_value(); }
+
+  /**
+   * @return envoy::admin::v2alpha::StartupTimeline the phases so far.
+   */
+  envoy::admin::v2alpha::StartupTimeline toProto() const;
+
+private:
+  struct Phase {
+    std::string name_;
+    MonotonicTime start_;
+    absl::optional<MonotonicTime> end_;
+  };
+
+  void recordPhase(const Phase& phase);
+
+  TimeSource& time_source_;
+  const MonotonicTime start_;
+  std::vector<Phase> phases_;
+  absl::optional<MonotonicTime> end_;
+  std::unique_ptr<StartupStats> stats_;
+  // The histograms of stats_, by the name of the phases recorded to them.
+  std::unordered_map<std::string, Stats::Histogram*> histograms_;
+};
+
+} // namespace Server
+} // namespace Envoy
@@ -7,6 +7,7 @@
 #include "envoy/server/configuration.h"
 #include "envoy/thread_local/thread_local.h"
 
+#include "common/common/fmt.h"
 #include "common/common/thread.h"
 
 #include "server/connection_handler_impl.h"
@@ -14,17 +15,39 @@
 namespace Envoy {
 namespace Server {
 
-WorkerPtr ProdWorkerFactory::createWorker() {
+WorkerPtr ProdWorkerFactory::createWorker(OverloadManager& overload_manager) {
+  const std::vector<uint32_t>& cpus = options_.workerCpus();
+  const uint32_t index = next_worker_index_++;
+  absl::optional<uint32_t> cpu;
+  if (!cpus.empty()) {
+    cpu = cpus[index % cpus.size()];
+  }
+
   Event::DispatcherPtr dispatcher(api_.allocateDispatcher(time_system_));
+  if (options_.dispatcherStatsEnabled()) {
+    dispatcher->initializeStats(stats_scope_, fmt::format("worker_{}.", index),
+                                options_.dispatcherStallThreshold());
+  }
   return WorkerPtr{new WorkerImpl(
       tls_, hooks_, std::move(dispatcher),
-      Network::ConnectionHandlerPtr{new ConnectionHandlerImpl(ENVOY_LOGGER(), *dispatcher)})};
+      Network::ConnectionHandlerPtr{new ConnectionHandlerImpl(ENVOY_LOGGER(), *dispatcher)},
+      overload_manager, cpu, options_.workerNumaLocalMemory())};
 }
 
 WorkerImpl::WorkerImpl(ThreadLocal::Instance& tls, TestHooks& hooks,
-                       Event::DispatcherPtr&& dispatcher, Network::ConnectionHandlerPtr handler)
-    : tls_(tls), hooks_(hooks), dispatcher_(std::move(dispatcher)), handler_(std::move(handler)) {
+                       Event::DispatcherPtr&& dispatcher, Network::ConnectionHandlerPtr handler,
+                       OverloadManager& overload_manager, absl::optional<uint32_t> cpu,
+                       bool numa_local_memory)
+    : tls_(tls), hooks_(hooks), dispatcher_(std::move(dispatcher)), handler_(std::move(handler)),
+      cpu_(cpu), numa_local_memory_(numa_local_memory) {
   tls_.registerThread(*dispatcher_, false);
+  // The callbacks are posted to the worker's dispatcher, so they run on the worker thread.
+  overload_manager.registerForActionValue(
+      OverloadActionNames::get().ReduceBufferLimits, *dispatcher_,
+      [this](double value) -> void { handler_->setBufferLimitScale(1 - value); });
+  overload_manager.registerForActionValue(
+      OverloadActionNames::get().CloseIdleConnections, *dispatcher_,
+      [this](double value) -> void { handler_->closeIdleConnections(value); });
 }
 
 void WorkerImpl::addListener(Network::ListenerConfig& listener, AddListenerCompletion completion) {
@@ -62,6 +85,33 @@ void WorkerImpl::removeListener(Network::ListenerConfig& listener,
   });
 }
 
+void WorkerImpl::removeFilterChains(Network::ListenerConfig& listener,
+                                    const std::list<const Network::FilterChain*>& filter_chains,
+                                    std::function<void()> completion) {
+  ASSERT(thread_);
+  const uint64_t listener_tag = listener.listenerTag();
+  dispatcher_->post([this, listener_tag, filter_chains, completion]() -> void {
+    handler_->removeFilterChains(listener_tag, filter_chains, [this, completion]() -> void {
+      completion();
+      hooks_.onWorkerListenerRemoved();
+    });
+  });
+}
+
+void WorkerImpl::releaseIdleConnections(std::function<void(std::vector<int>&&)> completion) {
+  ASSERT(thread_);
+  dispatcher_->post(
+      [this, completion]() -> void { completion(handler_->releaseIdleConnections()); });
+}
+
+void WorkerImpl::adoptConnection(Network::ConnectionSocketPtr&& socket) {
+  ASSERT(thread_);
+  // Posted callbacks must be copyable, so the socket is closed with the callback if it never runs.
+  auto socket_to_post = std::make_shared<Network::ConnectionSocketPtr>(std::move(socket));
+  dispatcher_->post(
+      [this, socket_to_post]() -> void { handler_->adoptConnection(std::move(*socket_to_post)); });
+}
+
 void WorkerImpl::start(GuardDog& guard_dog) {
   ASSERT(!thread_);
   thread_.reset(new Thread::Thread([this, &guard_dog]() -> void { threadRoutine(guard_dog); }));
@@ -88,6 +138,19 @@ void WorkerImpl::stopListeners() {
 }
 
 void WorkerImpl::threadRoutine(GuardDog& guard_dog) {
+  // Placement is set up before anything else runs on the thread, so that the memory the worker
+  // allocates from here on is local to where it runs.
+  if (cpu_.has_value()) {
+    if (Thread::Thread::pinCurrentThread(cpu_.value())) {
+      ENVOY_LOG(debug, "worker pinned to cpu {}", cpu_.value());
+    } else {
+      ENVOY_LOG(warn, "unable to pin worker to cpu {}", cpu_.value());
+    }
+  }
+  if (numa_local_memory_ && !Thread::Thread::useLocalMemoryPolicy()) {
+    ENVOY_LOG(warn, "unable to set the local NUMA memory policy for worker");
+  }
+
   ENVOY_LOG(debug, "worker entering dispatch loop");
   auto watchdog = guard_dog.createWatchDog(Thread::Thread::currentThreadId());
   watchdog->startWatchdog(*dispatcher_);
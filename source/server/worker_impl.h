@@ -2,12 +2,16 @@
 
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include "envoy/api/api.h"
 #include "envoy/network/connection_handler.h"
 #include "envoy/server/guarddog.h"
 #include "envoy/server/listener_manager.h"
+#include "envoy/server/options.h"
+#include "envoy/server/overload_manager.h"
 #include "envoy/server/worker.h"
+#include "envoy/stats/scope.h"
 #include "envoy/thread_local/thread_local.h"
 
 #include "common/common/logger.h"
@@ -15,23 +19,30 @@
 
 #include "server/test_hooks.h"
 
+#include "absl/types/optional.h"
+
 namespace Envoy {
 namespace Server {
 
 class ProdWorkerFactory : public WorkerFactory, Logger::Loggable<Logger::Id::main> {
 public:
   ProdWorkerFactory(ThreadLocal::Instance& tls, Api::Api& api, TestHooks& hooks,
-                    Event::TimeSystem& time_system)
-      : tls_(tls), api_(api), hooks_(hooks), time_system_(time_system) {}
+                    Event::TimeSystem& time_system, const Options& options,
+                    Stats::Scope& stats_scope)
+      : tls_(tls), api_(api), hooks_(hooks), time_system_(time_system), options_(options),
+        stats_scope_(stats_scope) {}
 
   // Server::WorkerFactory
-  WorkerPtr createWorker() override;
+  WorkerPtr createWorker(OverloadManager& overload_manager) override;
 
 private:
   ThreadLocal::Instance& tls_;
   Api::Api& api_;
   TestHooks& hooks_;
   Event::TimeSystem& time_system_;
+  const Options& options_;
+  Stats::Scope& stats_scope_;
+  uint32_t next_worker_index_{};
 };
 
 /**
@@ -39,17 +50,30 @@ private:
  */
 class WorkerImpl : public Worker, Logger::Loggable<Logger::Id::main> {
 public:
+  /**
+   * @param overload_manager supplies the overload manager to register the worker's overload
+   *        actions with.
+   * @param cpu supplies the CPU to pin the worker thread to, if any.
+   * @param numa_local_memory supplies whether the worker thread allocates memory from the NUMA
+   *        node it runs on.
+   */
   WorkerImpl(ThreadLocal::Instance& tls, TestHooks& hooks, Event::DispatcherPtr&& dispatcher,
-             Network::ConnectionHandlerPtr handler);
+             Network::ConnectionHandlerPtr handler, OverloadManager& overload_manager,
+             absl::optional<uint32_t> cpu = absl::nullopt, bool numa_local_memory = false);
 
   // Server::Worker
   void addListener(Network::ListenerConfig& listener, AddListenerCompletion completion) override;
   uint64_t numConnections() override;
   void removeListener(Network::ListenerConfig& listener, std::function<void()> completion) override;
+  void removeFilterChains(Network::ListenerConfig& listener,
+                          const std::list<const Network::FilterChain*>& filter_chains,
+                          std::function<void()> completion) override;
   void start(GuardDog& guard_dog) override;
   void stop() override;
   void stopListener(Network::ListenerConfig& listener) override;
   void stopListeners() override;
+  void releaseIdleConnections(std::function<void(std::vector<int>&&)> completion) override;
+  void adoptConnection(Network::ConnectionSocketPtr&& socket) override;
 
 private:
   void threadRoutine(GuardDog& guard_dog);
@@ -58,6 +82,8 @@ private:
   TestHooks& hooks_;
   Event::DispatcherPtr dispatcher_;
   Network::ConnectionHandlerPtr handler_;
+  const absl::optional<uint32_t> cpu_;
+  const bool numa_local_memory_;
   Thread::ThreadPtr thread_;
 };
 
@@ -29,6 +29,45 @@ static void BM_AccessLogFormatter(benchmark::State& state) {
 }
 BENCHMARK(BM_AccessLogFormatter);
 
+// Formats into a buffer reused across log lines, as the file access log does.
+static void BM_AccessLogFormatterTo(benchmark::State& state) {
+  size_t output_bytes = 0;
+  Http::TestHeaderMapImpl request_headers;
+  Http::TestHeaderMapImpl response_headers;
+  Http::TestHeaderMapImpl response_trailers;
+  std::string log_line;
+  for (auto _ : state) {
+    log_line.clear();
+    formatter->formatTo(request_headers, response_headers, response_trailers, *request_info,
+                        log_line);
+    output_bytes += log_line.length();
+  }
+  benchmark::DoNotOptimize(output_bytes);
+}
+BENCHMARK(BM_AccessLogFormatterTo);
+
+static void BM_DefaultAccessLogFormatterTo(benchmark::State& state) {
+  AccessLog::FormatterPtr default_formatter =
+      AccessLog::AccessLogFormatUtils::defaultAccessLogFormatter();
+  size_t output_bytes = 0;
+  Http::TestHeaderMapImpl request_headers{{":method", "GET"},
+                                          {":path", "/"},
+                                          {":authority", "example.com"},
+                                          {"user-agent", "curl/7.54.0"},
+                                          {"x-request-id", "3e1ff8b6-0a1e-4a2d-8d3b-6b6c1ac2e9e5"}};
+  Http::TestHeaderMapImpl response_headers;
+  Http::TestHeaderMapImpl response_trailers;
+  std::string log_line;
+  for (auto _ : state) {
+    log_line.clear();
+    default_formatter->formatTo(request_headers, response_headers, response_trailers,
+                                *request_info, log_line);
+    output_bytes += log_line.length();
+  }
+  benchmark::DoNotOptimize(output_bytes);
+}
+BENCHMARK(BM_DefaultAccessLogFormatterTo);
+
 } // namespace Envoy
 
 // Boilerplate main(), which discovers benchmarks in the same file and runs them.
@@ -498,6 +498,25 @@ TEST(AccessLogFormatterTest, CompositeFormatterSuccess) {
   }
 }
 
+TEST(AccessLogFormatterTest, CompositeFormatterTo) {
+  RequestInfo::MockRequestInfo request_info;
+  Http::TestHeaderMapImpl request_header{{"first", "GET"}, {":path", "/"}};
+  Http::TestHeaderMapImpl response_header{{"second", "PUT"}};
+  Http::TestHeaderMapImpl response_trailer;
+  EXPECT_CALL(request_info, bytesSent()).WillRepeatedly(Return(1024));
+  const SystemTime start_time(std::chrono::microseconds(1522796769123456));
+  EXPECT_CALL(request_info, startTime()).WillRepeatedly(Return(start_time));
+
+  FormatterImpl formatter("%REQ(first)% %RESP(second):2% %BYTES_SENT% %START_TIME(%s.%3f)% "
+                          "%START_TIME% %DURATION%");
+  // The output is appended to the buffer.
+  std::string output = "prefix ";
+  formatter.formatTo(request_header, response_header, response_trailer, request_info, output);
+  EXPECT_EQ("prefix GET PU 1024 1522796769.123 2018-04-03T23:06:09.123Z -", output);
+  EXPECT_EQ("GET PU 1024 1522796769.123 2018-04-03T23:06:09.123Z -",
+            formatter.format(request_header, response_header, response_trailer, request_info));
+}
+
 TEST(AccessLogFormatterTest, ParserFailures) {
   AccessLogFormatParser parser;
 
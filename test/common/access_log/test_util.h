@@ -3,6 +3,7 @@
 #include "envoy/request_info/request_info.h"
 
 #include "common/common/assert.h"
+#include "common/http/request_attributes_impl.h"
 #include "common/request_info/filter_state_impl.h"
 
 namespace Envoy {
@@ -162,6 +163,8 @@ public:
   }
   Envoy::RequestInfo::FilterState& perRequestState() override { return per_request_state_; }
 
+  Http::RequestAttributes& requestAttributes() override { return request_attributes_; }
+
   void setRequestedServerName(const absl::string_view requested_server_name) override {
     requested_server_name_ = std::string(requested_server_name);
   }
@@ -191,6 +194,7 @@ public:
   const Router::RouteEntry* route_entry_{};
   envoy::api::v2::core::Metadata metadata_{};
   Envoy::RequestInfo::FilterStateImpl per_request_state_{};
+  Http::RequestAttributesImpl request_attributes_;
   std::string requested_server_name_;
 };
 
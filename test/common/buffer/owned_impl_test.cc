@@ -9,6 +9,7 @@
 #include "gtest/gtest.h"
 
 using testing::_;
+using testing::Invoke;
 using testing::Return;
 
 namespace Envoy {
@@ -188,6 +189,369 @@ TEST_F(OwnedImplTest, ToString) {
   EXPECT_EQ(absl::StrCat("Hello, world!" + long_string), buffer.toString());
 }
 
+TEST_F(OwnedImplTest, ReserveCommit) {
+  Buffer::OwnedImpl buffer;
+  buffer.add("a");
+  // The reservation spans the reservable space at the end of the existing slice and a new slice.
+  const uint64_t first_reservable = SlicePool::PageSize;
+  RawSlice iovecs[2];
+  uint64_t num_iovecs = buffer.reserve(first_reservable * 2, iovecs, 2);
+  EXPECT_EQ(2, num_iovecs);
+  EXPECT_EQ(first_reservable * 2, iovecs[0].len_ + iovecs[1].len_);
+  EXPECT_EQ(1, buffer.length());
+
+  // Commit only part of what was reserved.
+  memset(iovecs[0].mem_, 'b', iovecs[0].len_);
+  iovecs[1].len_ = 3;
+  memset(iovecs[1].mem_, 'c', 3);
+  const uint64_t first_len = iovecs[0].len_;
+  buffer.commit(iovecs, 2);
+  EXPECT_EQ(1 + first_len + 3, buffer.length());
+  EXPECT_EQ(absl::StrCat("a", std::string(first_len, 'b'), "ccc"), buffer.toString());
+  EXPECT_EQ(2, buffer.getRawSlices(nullptr, 0));
+
+  // A single iovec reservation is always satisfied in full.
+  num_iovecs = buffer.reserve(first_reservable * 4, iovecs, 1);
+  EXPECT_EQ(1, num_iovecs);
+  EXPECT_EQ(first_reservable * 4, iovecs[0].len_);
+  iovecs[0].len_ = 0;
+  buffer.commit(iovecs, 1);
+  EXPECT_EQ(1 + first_len + 3, buffer.length());
+
+  // Empty slices left over by an uncommitted reservation are not reported.
+  EXPECT_EQ(2, buffer.getRawSlices(nullptr, 0));
+  buffer.add("d");
+  EXPECT_EQ(absl::StrCat("a", std::string(first_len, 'b'), "cccd"), buffer.toString());
+}
+
+TEST_F(OwnedImplTest, CommitZeroIovecs) {
+  Buffer::OwnedImpl buffer;
+  RawSlice iovec;
+  EXPECT_EQ(1, buffer.reserve(100, &iovec, 1));
+  buffer.commit(&iovec, 0);
+  EXPECT_EQ(0, buffer.length());
+  EXPECT_EQ(0, buffer.getRawSlices(nullptr, 0));
+  EXPECT_EQ(0, buffer.reserve(100, &iovec, 0));
+  EXPECT_EQ(0, buffer.reserve(0, &iovec, 1));
+}
+
+TEST_F(OwnedImplTest, CopyOutAcrossSlices) {
+  char input[] = "fragment";
+  BufferFragmentImpl frag(input, 8, nullptr);
+  Buffer::OwnedImpl buffer;
+  buffer.add("hello ");
+  buffer.addBufferFragment(frag);
+  buffer.add(" world");
+  EXPECT_EQ(3, buffer.getRawSlices(nullptr, 0));
+
+  char output[12];
+  buffer.copyOut(3, 12, output);
+  EXPECT_EQ("lo fragment ", std::string(output, 12));
+}
+
+TEST_F(OwnedImplTest, Linearize) {
+  char input[] = "fragment";
+  BufferFragmentImpl frag(input, 8, nullptr);
+  Buffer::OwnedImpl buffer;
+  buffer.addBufferFragment(frag);
+  buffer.add(" tail");
+  EXPECT_EQ(2, buffer.getRawSlices(nullptr, 0));
+
+  // Linearizing within the first slice doesn't copy.
+  EXPECT_EQ(static_cast<void*>(input), buffer.linearize(4));
+  EXPECT_EQ(2, buffer.getRawSlices(nullptr, 0));
+
+  // Linearizing across slices pulls the data into a new slice at the front.
+  void* data = buffer.linearize(10);
+  EXPECT_EQ("fragment t", std::string(static_cast<char*>(data), 10));
+  EXPECT_EQ(13, buffer.length());
+  EXPECT_EQ("fragment tail", buffer.toString());
+}
+
+TEST_F(OwnedImplTest, MoveSlices) {
+  Buffer::OwnedImpl source;
+  const std::string large(OwnedImpl::CopyThreshold * 4, 'l');
+  source.add(large);
+  Buffer::OwnedImpl destination;
+  destination.add("small");
+  const void* large_data = source.linearize(large.size());
+
+  destination.move(source);
+  EXPECT_EQ(0, source.length());
+  EXPECT_EQ(0, source.getRawSlices(nullptr, 0));
+  EXPECT_EQ(large.size() + 5, destination.length());
+
+  // The large slice was moved rather than copied.
+  RawSlice slices[2];
+  EXPECT_EQ(2, destination.getRawSlices(slices, 2));
+  EXPECT_EQ(large_data, slices[1].mem_);
+  EXPECT_EQ("small" + large, destination.toString());
+}
+
+TEST_F(OwnedImplTest, MoveCoalescesSmallSlices) {
+  Buffer::OwnedImpl destination;
+  destination.add("a");
+  for (int i = 0; i < 10; i++) {
+    Buffer::OwnedImpl source("b");
+    destination.move(source);
+  }
+  EXPECT_EQ(1, destination.getRawSlices(nullptr, 0));
+  EXPECT_EQ("abbbbbbbbbb", destination.toString());
+}
+
+TEST_F(OwnedImplTest, MovePartial) {
+  char input[] = "fragment";
+  BufferFragmentImpl frag(input, 8, [this](const void*, size_t, const BufferFragmentImpl*) {
+    release_callback_called_ = true;
+  });
+  Buffer::OwnedImpl source;
+  source.add("hello ");
+  source.addBufferFragment(frag);
+
+  Buffer::OwnedImpl destination;
+  destination.move(source, 10);
+  EXPECT_EQ("hello frag", destination.toString());
+  EXPECT_EQ("ment", source.toString());
+  EXPECT_FALSE(release_callback_called_);
+
+  destination.move(source, 4);
+  EXPECT_EQ(0, source.length());
+  EXPECT_EQ("hello fragment", destination.toString());
+  EXPECT_TRUE(release_callback_called_);
+}
+
+TEST_F(OwnedImplTest, Search) {
+  char input[] = "abcdab";
+  BufferFragmentImpl frag(input, 6, nullptr);
+  Buffer::OwnedImpl buffer;
+  EXPECT_EQ(-1, buffer.search("a", 1, 0));
+  EXPECT_EQ(0, buffer.search("", 0, 0));
+
+  buffer.add("xxab");
+  buffer.addBufferFragment(frag);
+  buffer.add("cdx");
+  // xxababcdabcdx
+  EXPECT_EQ(3, buffer.getRawSlices(nullptr, 0));
+  EXPECT_EQ(2, buffer.search("ab", 2, 0));
+  EXPECT_EQ(4, buffer.search("abcd", 4, 0));
+  EXPECT_EQ(8, buffer.search("abcd", 4, 5));
+  EXPECT_EQ(8, buffer.search("abcdx", 5, 0));
+  EXPECT_EQ(-1, buffer.search("abcdy", 5, 0));
+  EXPECT_EQ(-1, buffer.search("dxx", 3, 0));
+  EXPECT_EQ(12, buffer.search("x", 1, 5));
+  EXPECT_EQ(-1, buffer.search("x", 1, 14));
+}
+
+TEST_F(OwnedImplTest, ReadFillsMultipleSlices) {
+  Api::MockOsSysCalls os_sys_calls;
+  TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls(&os_sys_calls);
+
+  Buffer::OwnedImpl buffer;
+  buffer.add("a");
+  EXPECT_CALL(os_sys_calls, readv(_, _, 2))
+      .WillOnce(Invoke([](int, const iovec* iov, int) -> Api::SysCallSizeResult {
+        const size_t size = iov[0].iov_len + 10;
+        memset(iov[0].iov_base, 'b', iov[0].iov_len);
+        memset(iov[1].iov_base, 'c', 10);
+        return {static_cast<ssize_t>(size), 0};
+      }));
+  Api::SysCallIntResult result = buffer.read(-1, 16384);
+  EXPECT_EQ(2, buffer.getRawSlices(nullptr, 0));
+  EXPECT_EQ(result.rc_ + 1, buffer.length());
+  EXPECT_EQ(std::string(10, 'c'), buffer.toString().substr(buffer.length() - 10));
+}
+
+TEST_F(OwnedImplTest, LargeReadSpreadsOverSlices) {
+  Api::MockOsSysCalls os_sys_calls;
+  TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls(&os_sys_calls);
+
+  Buffer::OwnedImpl buffer;
+  const uint64_t read_size = 4 * OwnedImpl::ReserveSliceSize;
+  EXPECT_CALL(os_sys_calls, readv(_, _, 4))
+      .WillOnce(Invoke([](int, const iovec* iov, int iovcnt) -> Api::SysCallSizeResult {
+        ssize_t size = 0;
+        for (int i = 0; i < iovcnt; i++) {
+          EXPECT_EQ(OwnedImpl::ReserveSliceSize, iov[i].iov_len);
+          memset(iov[i].iov_base, 'a', iov[i].iov_len);
+          size += iov[i].iov_len;
+        }
+        return {size, 0};
+      }));
+  Api::SysCallIntResult result = buffer.read(-1, read_size);
+  EXPECT_EQ(read_size, result.rc_);
+  EXPECT_EQ(read_size, buffer.length());
+  EXPECT_EQ(4, buffer.getRawSlices(nullptr, 0));
+}
+
+TEST_F(OwnedImplTest, SlicePoolReuse) {
+  {
+    Buffer::OwnedImpl buffer;
+    buffer.add(std::string(100, 'a'));
+  }
+  const uint64_t initial_free = SlicePool::threadStats().free_blocks_;
+  EXPECT_LT(0, initial_free);
+  {
+    // Reusing a pooled block takes it off the free list.
+    Buffer::OwnedImpl buffer;
+    buffer.add(std::string(100, 'a'));
+    EXPECT_EQ(initial_free - 1, SlicePool::threadStats().free_blocks_);
+  }
+  {
+    // Large slices bypass the pool.
+    Buffer::OwnedImpl buffer;
+    buffer.add(std::string(SlicePool::PageSize * SlicePool::MaxPooledPages, 'a'));
+  }
+  EXPECT_EQ(initial_free, SlicePool::threadStats().free_blocks_);
+}
+
+TEST_F(OwnedImplTest, ReleaseEmptySlices) {
+  Buffer::OwnedImpl buffer;
+  buffer.add(std::string(100, 'a'));
+  buffer.drain(100);
+  // The drained slice is kept for later additions until released.
+  const uint64_t initial_free = SlicePool::threadStats().free_blocks_;
+  buffer.releaseEmptySlices();
+  EXPECT_EQ(initial_free + 1, SlicePool::threadStats().free_blocks_);
+  EXPECT_EQ(0, buffer.length());
+
+  // Slices holding data are kept, and the buffer is still usable.
+  buffer.add("b");
+  buffer.releaseEmptySlices();
+  EXPECT_EQ("b", buffer.toString());
+  buffer.add("c");
+  EXPECT_EQ("bc", buffer.toString());
+}
+
+TEST_F(OwnedImplTest, Pin) {
+  { Buffer::OwnedImpl warm_up("hello world"); }
+  const uint64_t initial_free = SlicePool::threadStats().free_blocks_;
+  SliceReferenceSharedPtr pin;
+  {
+    Buffer::OwnedImpl buffer("hello world");
+    RawSlice slice;
+    EXPECT_EQ(1, buffer.getRawSlices(&slice, 1));
+    const char* data = static_cast<const char*>(slice.mem_);
+
+    // Ranges outside of the buffer's slices can't be pinned.
+    EXPECT_EQ(nullptr, buffer.pin(data + 6, 6));
+    pin = buffer.pin(data + 6, 5);
+    ASSERT_NE(nullptr, pin);
+    // Pinning the same slice again returns the same reference.
+    EXPECT_EQ(pin, buffer.pin(data, 5));
+
+    // The buffer keeps appending to the pinned slice.
+    buffer.add("!");
+    EXPECT_EQ(1, buffer.getRawSlices(nullptr, 0));
+    EXPECT_EQ("hello world!", buffer.toString());
+
+    buffer.drain(buffer.length());
+    EXPECT_EQ(0, buffer.length());
+    EXPECT_EQ(0, memcmp("world", data + 6, 5));
+  }
+  // The slice's block is only returned to the pool once the pin is released.
+  EXPECT_EQ(initial_free - 1, SlicePool::threadStats().free_blocks_);
+  pin.reset();
+  EXPECT_EQ(initial_free, SlicePool::threadStats().free_blocks_);
+}
+
+// Prepending in front of a pinned slice must not overwrite the drained content it still shares.
+TEST_F(OwnedImplTest, PinDrainPrepend) {
+  Buffer::OwnedImpl buffer("hello world");
+  RawSlice slice;
+  EXPECT_EQ(1, buffer.getRawSlices(&slice, 1));
+  const char* data = static_cast<const char*>(slice.mem_);
+  SliceReferenceSharedPtr pin = buffer.pin(data, 5);
+  ASSERT_NE(nullptr, pin);
+
+  buffer.drain(6);
+  buffer.prepend("HELLO ");
+  EXPECT_EQ("HELLO world", buffer.toString());
+  EXPECT_EQ(2, buffer.getRawSlices(nullptr, 0));
+  EXPECT_EQ(0, memcmp("hello world", data, 11));
+}
+
+TEST_F(OwnedImplTest, PinFragment) {
+  char input[] = "hello world";
+  BufferFragmentImpl frag(input, 11, nullptr);
+  Buffer::OwnedImpl buffer;
+  buffer.addBufferFragment(frag);
+  EXPECT_EQ(nullptr, buffer.pin(input, 5));
+}
+
+TEST_F(OwnedImplTest, AddShared) {
+  { Buffer::OwnedImpl warm_up("hello world"); }
+  const uint64_t initial_free = SlicePool::threadStats().free_blocks_;
+  {
+    Buffer::OwnedImpl buffer("hello world");
+    buffer.drain(6);
+    RawSlice slice;
+    EXPECT_EQ(1, buffer.getRawSlices(&slice, 1));
+
+    Buffer::OwnedImpl shared;
+    shared.addShared(buffer);
+    EXPECT_EQ("world", buffer.toString());
+    EXPECT_EQ("world", shared.toString());
+    RawSlice shared_slice;
+    EXPECT_EQ(1, shared.getRawSlices(&shared_slice, 1));
+    EXPECT_EQ(slice.mem_, shared_slice.mem_);
+    // No storage was allocated for the shared content.
+    EXPECT_EQ(initial_free - 1, SlicePool::threadStats().free_blocks_);
+
+    // Content added to either buffer goes to new slices.
+    buffer.add("!");
+    buffer.prepend("hello ");
+    shared.add("?");
+    shared.prepend("hi ");
+    EXPECT_EQ("hello world!", buffer.toString());
+    EXPECT_EQ("hi world?", shared.toString());
+
+    // Sharing again shares the same storage.
+    Buffer::OwnedImpl shared_again;
+    shared_again.addShared(shared);
+    EXPECT_EQ("hi world?", shared_again.toString());
+    EXPECT_EQ(3, shared_again.getRawSlices(nullptr, 0));
+
+    // The shared storage outlives the buffer it came from.
+    buffer.drain(buffer.length());
+    shared_again.drain(3);
+    EXPECT_EQ("world?", shared_again.toString());
+    shared.drain(shared.length());
+    EXPECT_EQ("world?", shared_again.toString());
+  }
+  EXPECT_EQ(initial_free, SlicePool::threadStats().free_blocks_);
+}
+
+TEST_F(OwnedImplTest, AddSharedPinned) {
+  Buffer::OwnedImpl buffer("hello world");
+  RawSlice slice;
+  EXPECT_EQ(1, buffer.getRawSlices(&slice, 1));
+  SliceReferenceSharedPtr pin = buffer.pin(slice.mem_, 5);
+  buffer.drain(6);
+
+  Buffer::OwnedImpl shared;
+  shared.addShared(buffer);
+  EXPECT_EQ("world", shared.toString());
+  // The pinned slice no longer writes to the shared storage.
+  buffer.prepend("hello ");
+  EXPECT_EQ(0, memcmp("hello world", slice.mem_, 11));
+  EXPECT_EQ("hello world", buffer.toString());
+  EXPECT_EQ(pin, shared.pin(static_cast<const char*>(slice.mem_) + 6, 5));
+}
+
+TEST_F(OwnedImplTest, AddSharedFragment) {
+  char input[] = "hello world";
+  BufferFragmentImpl frag(input, 11, nullptr);
+  Buffer::OwnedImpl buffer;
+  buffer.addBufferFragment(frag);
+
+  // Fragment content is copied.
+  Buffer::OwnedImpl shared;
+  shared.addShared(buffer);
+  input[0] = 'j';
+  EXPECT_EQ("hello world", shared.toString());
+  EXPECT_EQ("jello world", buffer.toString());
+}
+
 } // namespace
 } // namespace Buffer
 } // namespace Envoy
@@ -0,0 +1,121 @@
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "common/buffer/slice_pool.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Buffer {
+namespace {
+
+TEST(SlicePoolTest, ReuseLocal) {
+  void* first = SlicePool::allocate(SlicePool::PageSize);
+  const SlicePool::ThreadStats stats = SlicePool::threadStats();
+  EXPECT_LE(SlicePool::SlabSize, stats.slab_bytes_);
+  SlicePool::free(first);
+  EXPECT_EQ(stats.free_blocks_ + 1, SlicePool::threadStats().free_blocks_);
+
+  // The most recently freed block is handed out first.
+  void* second = SlicePool::allocate(SlicePool::PageSize);
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(stats.slab_bytes_, SlicePool::threadStats().slab_bytes_);
+  SlicePool::free(second);
+}
+
+TEST(SlicePoolTest, SizeClasses) {
+  std::vector<void*> blocks;
+  for (uint64_t pages = 1; pages <= SlicePool::MaxPooledPages + 1; pages++) {
+    void* block = SlicePool::allocate(pages * SlicePool::PageSize);
+    // The usable part of the block must be writable in full.
+    memset(block, 'a', pages * SlicePool::PageSize - SlicePool::BlockOverhead);
+    blocks.push_back(block);
+  }
+  const uint64_t free_blocks = SlicePool::threadStats().free_blocks_;
+  for (void* block : blocks) {
+    SlicePool::free(block);
+  }
+  // All but the oversized block went back to the pool.
+  EXPECT_EQ(free_blocks + SlicePool::MaxPooledPages, SlicePool::threadStats().free_blocks_);
+}
+
+TEST(SlicePoolTest, RemoteFree) {
+  const uint64_t block_size = 3 * SlicePool::PageSize;
+  std::vector<void*> blocks;
+  for (int i = 0; i < 100; i++) {
+    blocks.push_back(SlicePool::allocate(block_size));
+  }
+  const SlicePool::ThreadStats before = SlicePool::threadStats();
+
+  std::thread thread([&blocks]() {
+    for (void* block : blocks) {
+      SlicePool::free(block);
+    }
+  });
+  thread.join();
+
+  // Blocks freed on another thread are queued rather than added to the local free lists.
+  EXPECT_EQ(before.remote_frees_ + blocks.size(), SlicePool::threadStats().remote_frees_);
+  EXPECT_EQ(before.free_blocks_, SlicePool::threadStats().free_blocks_);
+
+  // Returned blocks are picked up once the local free list runs dry, before any new slab is
+  // carved.
+  std::vector<void*> reused;
+  for (size_t i = 0; i < blocks.size(); i++) {
+    reused.push_back(SlicePool::allocate(block_size));
+  }
+  EXPECT_EQ(before.slab_bytes_, SlicePool::threadStats().slab_bytes_);
+  for (void* block : reused) {
+    SlicePool::free(block);
+  }
+}
+
+TEST(SlicePoolTest, FreeAfterOwnerExit) {
+  std::vector<void*> blocks;
+  std::thread thread([&blocks]() {
+    for (int i = 0; i < 100; i++) {
+      blocks.push_back(SlicePool::allocate(2 * SlicePool::PageSize));
+    }
+  });
+  thread.join();
+
+  // The owning pool is orphaned but must stay alive until its last block comes back.
+  for (void* block : blocks) {
+    memset(block, 'a', 2 * SlicePool::PageSize - SlicePool::BlockOverhead);
+    SlicePool::free(block);
+  }
+}
+
+TEST(SlicePoolTest, ConcurrentRemoteFree) {
+  const int num_threads = 4;
+  const int blocks_per_thread = 1000;
+  std::vector<std::vector<void*>> blocks(num_threads);
+  for (auto& thread_blocks : blocks) {
+    for (int i = 0; i < blocks_per_thread; i++) {
+      thread_blocks.push_back(SlicePool::allocate(SlicePool::PageSize));
+    }
+  }
+
+  std::vector<std::thread> threads;
+  for (auto& thread_blocks : blocks) {
+    threads.emplace_back([&thread_blocks]() {
+      for (void* block : thread_blocks) {
+        SlicePool::free(block);
+        // Interleave local allocations with the remote frees.
+        SlicePool::free(SlicePool::allocate(SlicePool::PageSize));
+      }
+    });
+  }
+  // Allocate on the owning thread while returns are in flight.
+  for (int i = 0; i < blocks_per_thread; i++) {
+    SlicePool::free(SlicePool::allocate(SlicePool::PageSize));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+} // namespace
+} // namespace Buffer
+} // namespace Envoy
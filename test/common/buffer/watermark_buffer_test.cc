@@ -3,6 +3,8 @@
 #include "common/buffer/buffer_impl.h"
 #include "common/buffer/watermark_buffer.h"
 
+#include "test/test_common/environment.h"
+
 #include "gtest/gtest.h"
 
 namespace Envoy {
@@ -62,6 +64,16 @@ TEST_F(WatermarkBufferTest, AddBuffer) {
   EXPECT_EQ(11, buffer_.length());
 }
 
+TEST_F(WatermarkBufferTest, AddSharedBuffer) {
+  OwnedImpl first(TEN_BYTES);
+  buffer_.addShared(first);
+  EXPECT_EQ(0, times_high_watermark_called_);
+  OwnedImpl second("a");
+  buffer_.addShared(second);
+  EXPECT_EQ(1, times_high_watermark_called_);
+  EXPECT_EQ(11, buffer_.length());
+}
+
 TEST_F(WatermarkBufferTest, Prepend) {
   std::string suffix = "World!", prefix = "Hello, ";
 
@@ -270,6 +282,41 @@ TEST_F(WatermarkBufferTest, MoveBackWithWatermarks) {
   EXPECT_EQ(1, low_watermark_buffer1);
 }
 
+// Content past the spill threshold is copied to slices mapping a file, and reads back unchanged.
+TEST_F(WatermarkBufferTest, SpillToFile) {
+  Buffer::WatermarkBuffer buffer{[]() -> void {}, []() -> void {}};
+  buffer.setSpillThreshold(16384, TestEnvironment::temporaryDirectory());
+  Buffer::OwnedImpl unspilled;
+  std::string content;
+  for (uint32_t i = 0; content.size() < 3 * OwnedImpl::SpillSliceSize; i++) {
+    const std::string chunk(4096, 'a' + i % 26);
+    content += chunk;
+    buffer.add(chunk);
+    unspilled.add(chunk);
+  }
+  EXPECT_EQ(content.size(), buffer.length());
+  EXPECT_EQ(content, buffer.toString());
+  EXPECT_LT(buffer.getRawSlices(nullptr, 0), unspilled.getRawSlices(nullptr, 0) / 2);
+
+  // Mapped slices can be drained and moved like any other.
+  buffer.drain(20000);
+  Buffer::OwnedImpl moved;
+  moved.move(buffer, OwnedImpl::SpillSliceSize);
+  EXPECT_EQ(content.substr(20000, OwnedImpl::SpillSliceSize), moved.toString());
+  EXPECT_EQ(content.substr(20000 + OwnedImpl::SpillSliceSize), buffer.toString());
+}
+
+// Content stays in memory if the spill file can't be created.
+TEST_F(WatermarkBufferTest, SpillToMissingDirectory) {
+  Buffer::WatermarkBuffer buffer{[]() -> void {}, []() -> void {}};
+  buffer.setSpillThreshold(16384, TestEnvironment::temporaryPath("missing/directory"));
+  const std::string content(2 * OwnedImpl::SpillSliceSize, 'a');
+  buffer.add(content);
+  buffer.add(content);
+  EXPECT_EQ(2 * content.size(), buffer.length());
+  EXPECT_EQ(content + content, buffer.toString());
+}
+
 } // namespace
 } // namespace Buffer
 } // namespace Envoy
@@ -0,0 +1,83 @@
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "common/common/arena_impl.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+
+TEST(ArenaImplTest, NoAllocationUntilUsed) {
+  ArenaImpl arena;
+  EXPECT_EQ(0, arena.bytesReserved());
+}
+
+TEST(ArenaImplTest, BumpsWithinBlock) {
+  ArenaImpl arena(128);
+  uint8_t* first = static_cast<uint8_t*>(arena.allocate(8, 8));
+  uint8_t* second = static_cast<uint8_t*>(arena.allocate(8, 8));
+  EXPECT_EQ(first + 8, second);
+  EXPECT_EQ(128, arena.bytesReserved());
+}
+
+TEST(ArenaImplTest, Alignment) {
+  ArenaImpl arena(256);
+  arena.allocate(1, 1);
+  void* aligned = arena.allocate(16, 64);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(aligned) % 64);
+}
+
+TEST(ArenaImplTest, NewBlockWhenFull) {
+  ArenaImpl arena(64);
+  arena.allocate(48, 8);
+  arena.allocate(48, 8);
+  EXPECT_EQ(128, arena.bytesReserved());
+}
+
+TEST(ArenaImplTest, LargeAllocationKeepsCurrentBlock) {
+  ArenaImpl arena(64);
+  uint8_t* first = static_cast<uint8_t*>(arena.allocate(8, 8));
+  arena.allocate(1024, 8);
+  uint8_t* second = static_cast<uint8_t*>(arena.allocate(8, 8));
+  EXPECT_EQ(first + 8, second);
+  EXPECT_EQ(64 + 1024 + 7, arena.bytesReserved());
+}
+
+TEST(ArenaImplTest, StlContainer) {
+  ArenaImpl arena;
+  std::vector<uint64_t, ArenaAllocator<uint64_t>> values{ArenaAllocator<uint64_t>(arena)};
+  for (uint64_t i = 0; i < 100; i++) {
+    values.push_back(i);
+  }
+  EXPECT_EQ(99, values.back());
+  EXPECT_GT(arena.bytesReserved(), 0);
+}
+
+class Counted {
+public:
+  Counted(int& destroyed) : destroyed_(destroyed) {}
+  ~Counted() { destroyed_++; }
+
+private:
+  int& destroyed_;
+};
+
+TEST(ArenaImplTest, MakeSharedInArena) {
+  int destroyed = 0;
+  ArenaImpl arena;
+  {
+    std::shared_ptr<Counted> object = makeSharedInArena<Counted>(&arena, destroyed);
+    EXPECT_GT(arena.bytesReserved(), 0);
+  }
+  // The destructor still runs when the last reference goes away.
+  EXPECT_EQ(1, destroyed);
+}
+
+TEST(ArenaImplTest, MakeSharedWithoutArena) {
+  int destroyed = 0;
+  makeSharedInArena<Counted>(nullptr, destroyed).reset();
+  EXPECT_EQ(1, destroyed);
+}
+
+} // namespace Envoy
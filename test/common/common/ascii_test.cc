@@ -0,0 +1,49 @@
+#include <string>
+
+#include "common/common/ascii.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+
+// Every byte value, at every position of a word and in the tail after the last full word, is
+// converted like absl::ascii_tolower() does.
+TEST(AsciiUtilTest, ToLowerCaseAllBytes) {
+  for (size_t size = 1; size <= 2 * sizeof(uint64_t) + 1; size++) {
+    for (size_t position = 0; position < size; position++) {
+      for (int c = 0; c < 256; c++) {
+        std::string input(size, 'X');
+        input[position] = static_cast<char>(c);
+        std::string expected(size, 'x');
+        expected[position] = absl::ascii_tolower(static_cast<char>(c));
+        AsciiUtil::toLowerCase(input);
+        ASSERT_EQ(expected, input) << "size " << size << " position " << position << " byte " << c;
+      }
+    }
+  }
+}
+
+TEST(AsciiUtilTest, ToLowerCase) {
+  std::string input("Content-Type: X-ENVOY-UPSTREAM-SERVICE-TIME\x90\xC1");
+  AsciiUtil::toLowerCase(input);
+  EXPECT_EQ("content-type: x-envoy-upstream-service-time\x90\xC1", input);
+
+  std::string empty;
+  AsciiUtil::toLowerCase(empty);
+  EXPECT_EQ("", empty);
+}
+
+TEST(AsciiUtilTest, CaseEqual) {
+  EXPECT_TRUE(AsciiUtil::caseEqual("", ""));
+  EXPECT_TRUE(AsciiUtil::caseEqual("upgrade", "UpGrAdE"));
+  EXPECT_TRUE(AsciiUtil::caseEqual("transfer-encoding", "Transfer-Encoding"));
+  EXPECT_FALSE(AsciiUtil::caseEqual("upgrade", "upgrades"));
+  EXPECT_FALSE(AsciiUtil::caseEqual("transfer-encoding", "transfer-encodinG2"));
+  EXPECT_FALSE(AsciiUtil::caseEqual("transfer-encoding", "transfer_encoding"));
+  EXPECT_FALSE(AsciiUtil::caseEqual("transfer-encodinh", "transfer-encoding"));
+  // Only ASCII letters fold: '@' and '`' differ by 0x20 like 'A' and 'a' do.
+  EXPECT_FALSE(AsciiUtil::caseEqual("@@@@@@@@@", "`````````"));
+  EXPECT_FALSE(AsciiUtil::caseEqual(std::string(9, '\xC1'), std::string(9, '\xE1')));
+}
+
+} // namespace Envoy
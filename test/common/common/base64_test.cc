@@ -109,6 +109,62 @@ TEST(Base64Test, BinaryBufferEncode) {
   EXPECT_EQ("AAECAwgKCQCqvN4=", Base64::encode(buffer, 30));
 }
 
+TEST(Base64Test, EncodeToBuffer) {
+  Buffer::OwnedImpl buffer;
+  buffer.add("\0\1\2\3", 4);
+  buffer.add("\b\n\t", 4);
+  buffer.add("\xaa\xbc\xde", 3);
+  for (uint64_t length = 0; length <= 12; length++) {
+    Buffer::OwnedImpl output("prefix");
+    Base64::encode(buffer, length, output);
+    EXPECT_EQ("prefix" + Base64::encode(buffer, length), output.toString());
+  }
+  EXPECT_EQ(11, buffer.length());
+}
+
+TEST(Base64Test, DecodeBuffer) {
+  {
+    Buffer::OwnedImpl input;
+    Buffer::OwnedImpl output;
+    EXPECT_TRUE(Base64::decode(input, output));
+    EXPECT_EQ(0, output.length());
+  }
+
+  {
+    // Groups split across slices are decoded, and an incomplete group is left in the input.
+    Buffer::OwnedImpl input;
+    input.add("Zm");
+    input.add("9vY");
+    input.add("mFyZ");
+    Buffer::OwnedImpl output;
+    EXPECT_TRUE(Base64::decode(input, output));
+    EXPECT_EQ("foobar", output.toString());
+    EXPECT_EQ("Z", input.toString());
+
+    input.add("g==");
+    EXPECT_TRUE(Base64::decode(input, output));
+    EXPECT_EQ("foobarf", output.toString());
+    EXPECT_EQ(0, input.length());
+  }
+
+  {
+    // Concatenated padded encodings.
+    Buffer::OwnedImpl input("Zg==Zm8=Zm9v");
+    Buffer::OwnedImpl output;
+    EXPECT_TRUE(Base64::decode(input, output));
+    EXPECT_EQ("ffofoo", output.toString());
+  }
+
+  for (const std::string& invalid : {"==Zg", "=Zm8", "Zm=8", "Zg=A", "Zh==", "Zm9=", "Zg..",
+                                     "..Zg", "A===", "Zm9vZg.."}) {
+    Buffer::OwnedImpl input(invalid);
+    Buffer::OwnedImpl output;
+    EXPECT_FALSE(Base64::decode(input, output)) << invalid;
+    EXPECT_EQ(invalid, input.toString());
+    EXPECT_EQ(0, output.length());
+  }
+}
+
 TEST(Base64UrlTest, EncodeString) {
   EXPECT_EQ("", Base64Url::encode("", 0));
   EXPECT_EQ("AAA", Base64Url::encode("\0\0", 2));
@@ -0,0 +1,92 @@
+#include <string>
+#include <vector>
+
+#include "common/common/fmt.h"
+#include "common/common/logger_delegates.h"
+#include "common/common/thread.h"
+
+#include "test/test_common/logging.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Logger {
+
+TEST(AsyncSinkDelegateTest, FlushWritesBufferedMessages) {
+  LogRecordingSink recorder(Registry::getSink());
+  AsyncSinkDelegate async_sink(1024, Registry::getSink());
+
+  async_sink.log("one\n");
+  async_sink.log("two\n");
+  async_sink.log("three\n");
+  async_sink.flush();
+  EXPECT_EQ((std::vector<std::string>{"one\n", "two\n", "three\n"}), recorder.messages());
+  EXPECT_EQ(0U, async_sink.droppedMessages());
+}
+
+// Messages that do not fit in the ring buffer are counted and reported in the log.
+TEST(AsyncSinkDelegateTest, DropsWhenFull) {
+  LogRecordingSink recorder(Registry::getSink());
+  AsyncSinkDelegate async_sink(16, Registry::getSink());
+
+  async_sink.log("short\n");
+  async_sink.log("a message longer than the buffer\n");
+  async_sink.log("another message longer than the buffer\n");
+  async_sink.flush();
+  EXPECT_EQ((std::vector<std::string>{"short\n", "[2 log messages dropped by async logging]\n"}),
+            recorder.messages());
+  EXPECT_EQ(2U, async_sink.droppedMessages());
+
+  // Drops are only reported once.
+  async_sink.log("short\n");
+  async_sink.flush();
+  EXPECT_EQ(3U, recorder.messages().size());
+  EXPECT_EQ(2U, async_sink.droppedMessages());
+}
+
+// Messages wrap around the end of the ring buffer as it is drained.
+TEST(AsyncSinkDelegateTest, Wraparound) {
+  LogRecordingSink recorder(Registry::getSink());
+  AsyncSinkDelegate async_sink(32, Registry::getSink());
+
+  std::vector<std::string> expected;
+  for (uint32_t i = 0; i < 100; i++) {
+    expected.push_back(fmt::format("message {}\n", i));
+    async_sink.log(expected.back());
+    async_sink.flush();
+  }
+  EXPECT_EQ(expected, recorder.messages());
+}
+
+// Every thread's messages are written in the order it logged them, and the delegate writes out
+// what is still buffered when it is destroyed.
+TEST(AsyncSinkDelegateTest, MultipleThreads) {
+  const uint32_t thread_count = 4;
+  const uint32_t message_count = 1000;
+  LogRecordingSink recorder(Registry::getSink());
+  {
+    AsyncSinkDelegate async_sink(1024 * 1024, Registry::getSink());
+    std::vector<Thread::ThreadPtr> threads;
+    for (uint32_t t = 0; t < thread_count; t++) {
+      threads.emplace_back(new Thread::Thread([&async_sink, t]() -> void {
+        for (uint32_t i = 0; i < message_count; i++) {
+          async_sink.log(fmt::format("{} {}\n", t, i));
+        }
+      }));
+    }
+    for (Thread::ThreadPtr& thread : threads) {
+      thread->join();
+    }
+  }
+
+  ASSERT_EQ(thread_count * message_count, recorder.messages().size());
+  std::vector<uint32_t> next(thread_count);
+  for (const std::string& message : recorder.messages()) {
+    const uint32_t t = std::stoul(message.substr(0, message.find(' ')));
+    EXPECT_EQ(fmt::format("{} {}\n", t, next[t]), message);
+    next[t]++;
+  }
+}
+
+} // namespace Logger
+} // namespace Envoy
@@ -0,0 +1,108 @@
+#include <memory>
+#include <vector>
+
+#include "common/common/mpsc_queue.h"
+#include "common/common/thread.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+
+struct TestNode : public MpscQueueNode {
+  TestNode(uint32_t producer, uint32_t sequence) : producer_(producer), sequence_(sequence) {}
+
+  uint32_t producer_;
+  uint32_t sequence_;
+};
+
+TEST(MpscQueueTest, Empty) {
+  MpscQueue<TestNode> queue;
+  EXPECT_EQ(nullptr, queue.pop());
+  EXPECT_EQ(nullptr, queue.pop());
+}
+
+TEST(MpscQueueTest, Fifo) {
+  MpscQueue<TestNode> queue;
+  TestNode a(0, 0);
+  TestNode b(0, 1);
+  TestNode c(0, 2);
+
+  queue.push(&a);
+  EXPECT_EQ(&a, queue.pop());
+  EXPECT_EQ(nullptr, queue.pop());
+
+  queue.push(&a);
+  queue.push(&b);
+  EXPECT_EQ(&a, queue.pop());
+  queue.push(&c);
+  EXPECT_EQ(&b, queue.pop());
+  EXPECT_EQ(&c, queue.pop());
+  EXPECT_EQ(nullptr, queue.pop());
+}
+
+TEST(MpscQueueTest, PushChain) {
+  MpscQueue<TestNode> queue;
+  TestNode a(0, 0);
+  TestNode b(0, 1);
+  TestNode c(0, 2);
+  TestNode d(0, 3);
+
+  queue.push(&a);
+  MpscQueue<TestNode>::link(&b, &c);
+  MpscQueue<TestNode>::link(&c, &d);
+  queue.pushChain(&b, &d);
+
+  EXPECT_EQ(&a, queue.pop());
+  EXPECT_EQ(&b, queue.pop());
+  EXPECT_EQ(&c, queue.pop());
+  EXPECT_EQ(&d, queue.pop());
+  EXPECT_EQ(nullptr, queue.pop());
+}
+
+// Several producers push concurrently with a single consumer. Each producer's nodes must come out
+// in the order they were pushed, and no node may be lost or duplicated.
+TEST(MpscQueueTest, ConcurrentProducers) {
+  const uint32_t num_producers = 4;
+  const uint32_t per_producer = 10000;
+  MpscQueue<TestNode> queue;
+
+  std::vector<Thread::ThreadPtr> producers;
+  for (uint32_t p = 0; p < num_producers; p++) {
+    producers.emplace_back(new Thread::Thread([&queue, p]() -> void {
+      for (uint32_t i = 0; i < per_producer; i++) {
+        if (i % 3 == 0 && i + 1 < per_producer) {
+          TestNode* first = new TestNode(p, i);
+          TestNode* second = new TestNode(p, i + 1);
+          MpscQueue<TestNode>::link(first, second);
+          queue.pushChain(first, second);
+          i++;
+        } else {
+          queue.push(new TestNode(p, i));
+        }
+      }
+    }));
+  }
+
+  std::vector<uint32_t> next_sequence(num_producers, 0);
+  uint32_t received = 0;
+  while (received < num_producers * per_producer) {
+    std::unique_ptr<TestNode> node(queue.pop());
+    if (node == nullptr) {
+      continue;
+    }
+    ASSERT_LT(node->producer_, num_producers);
+    EXPECT_EQ(next_sequence[node->producer_], node->sequence_);
+    next_sequence[node->producer_] = node->sequence_ + 1;
+    received++;
+  }
+
+  for (Thread::ThreadPtr& producer : producers) {
+    producer->join();
+  }
+  EXPECT_EQ(nullptr, queue.pop());
+  for (uint32_t p = 0; p < num_producers; p++) {
+    EXPECT_EQ(per_producer, next_sequence[p]);
+  }
+}
+
+} // namespace Envoy
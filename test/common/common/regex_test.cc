@@ -0,0 +1,89 @@
+#include <string>
+#include <vector>
+
+#include "envoy/common/exception.h"
+
+#include "common/common/regex.h"
+
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::ElementsAre;
+using testing::IsEmpty;
+
+namespace Envoy {
+namespace Regex {
+namespace {
+
+envoy::type::matcher::RegexMatcher googleRe2(const std::string& regex) {
+  envoy::type::matcher::RegexMatcher matcher;
+  matcher.mutable_google_re2();
+  matcher.set_regex(regex);
+  return matcher;
+}
+
+TEST(RegexTest, GoogleRe2) {
+  CompiledMatcherPtr matcher = Utility::parseRegex(googleRe2("/rides/\\d+"));
+  EXPECT_TRUE(matcher->match("/rides/0"));
+  EXPECT_TRUE(matcher->match("/rides/123"));
+  EXPECT_FALSE(matcher->match("/rides/123/456"));
+  EXPECT_FALSE(matcher->match("/x/rides/123"));
+  EXPECT_FALSE(matcher->match(""));
+}
+
+TEST(RegexTest, GoogleRe2Invalid) {
+  EXPECT_THROW_WITH_REGEX(Utility::parseRegex(googleRe2("(+invalid)")), EnvoyException,
+                          "Invalid regex '\\(\\+invalid\\)': .*");
+}
+
+TEST(RegexTest, GoogleRe2MaxProgramSize) {
+  EXPECT_THROW_WITH_REGEX(Utility::parseRegex(googleRe2("/asdf/.{50}")), EnvoyException,
+                          "RE2 program size of [0-9]+ > max program size of 100");
+
+  envoy::type::matcher::RegexMatcher matcher = googleRe2("/asdf/.{50}");
+  matcher.mutable_google_re2()->mutable_max_program_size()->set_value(1000);
+  EXPECT_TRUE(Utility::parseRegex(matcher)->match("/asdf/" + std::string(50, 'x')));
+}
+
+// Validate that a long input is matched without exhausting the stack.
+TEST(RegexTest, GoogleRe2LongInput) {
+  CompiledMatcherPtr matcher = Utility::parseRegex(googleRe2("(a|b)*"));
+  EXPECT_TRUE(matcher->match(std::string(1 << 20, 'a')));
+}
+
+TEST(RegexTest, StdRegex) {
+  CompiledMatcherPtr matcher = Utility::parseStdRegexAsCompiledMatcher("/b[io]t");
+  EXPECT_TRUE(matcher->match("/bit"));
+  EXPECT_TRUE(matcher->match(absl::string_view("/bot?x", 4)));
+  EXPECT_FALSE(matcher->match("/bite"));
+
+  EXPECT_THROW_WITH_REGEX(Utility::parseStdRegexAsCompiledMatcher("(+invalid)"), EnvoyException,
+                          "Invalid regex '\\(\\+invalid\\)': .*");
+}
+
+TEST(RegexTest, GoogleReMatcherSet) {
+  GoogleReMatcherSet set;
+  set.add(googleRe2("/rides/\\d+"));
+  set.add(googleRe2("/rides/.*"));
+  set.add(googleRe2("/users"));
+  set.compile();
+
+  std::vector<int> matches;
+  set.match("/rides/123", matches);
+  EXPECT_THAT(matches, ElementsAre(0, 1));
+  set.match("/rides/123?x", matches);
+  EXPECT_THAT(matches, ElementsAre(1));
+  set.match("/users", matches);
+  EXPECT_THAT(matches, ElementsAre(2));
+  set.match("/users/1", matches);
+  EXPECT_THAT(matches, IsEmpty());
+
+  GoogleReMatcherSet invalid_set;
+  EXPECT_THROW(invalid_set.add(googleRe2("(+invalid)")), EnvoyException);
+}
+
+} // namespace
+} // namespace Regex
+} // namespace Envoy
@@ -0,0 +1,252 @@
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/common/fmt.h"
+#include "common/common/hash.h"
+#include "common/common/segmented_memory_hash_set.h"
+#include "common/stats/stats_options_impl.h"
+
+#include "absl/strings/string_view.h"
+#include "gtest/gtest.h"
+
+namespace Envoy {
+
+// Tests SegmentedMemoryHashSet.
+class SegmentedMemoryHashSetTest : public testing::Test {
+protected:
+  // TestValue holding a variable-length key, like RawStatData.
+  struct TestValue {
+    absl::string_view key() const { return name; }
+    void initialize(absl::string_view key, const Stats::StatsOptions& stats_options) {
+      ASSERT(key.size() <= stats_options.maxNameLength());
+      memcpy(name, key.data(), key.size());
+      name[key.size()] = '\0';
+    }
+    static uint64_t structSize(uint64_t key_size) { return sizeof(TestValue) + key_size + 1; }
+    static uint64_t structSizeWithOptions(const Stats::StatsOptions& stats_options) {
+      return structSize(stats_options.maxNameLength());
+    }
+    static uint64_t hash(absl::string_view key) { return HashUtil::xxHash64(key); }
+
+    int64_t number;
+    char name[];
+  };
+
+  typedef SegmentedMemoryHashSet<TestValue> TestHashSet;
+
+  // Hands out zeroed heap blocks as segments, shared by all the sets using the mapper, the way
+  // processes share named shared memory regions.
+  class TestMapper : public MemorySegmentMapper {
+  public:
+    uint8_t* mapSegment(uint32_t index, uint64_t size, bool create) override {
+      if (fail_) {
+        return nullptr;
+      }
+      std::unique_ptr<uint8_t[]>& segment = segments_[index];
+      EXPECT_EQ(create, segment == nullptr);
+      if (create) {
+        segment.reset(new uint8_t[size]);
+        memset(segment.get(), 0, size);
+      }
+      return segment.get();
+    }
+
+    std::map<uint32_t, std::unique_ptr<uint8_t[]>> segments_;
+    bool fail_{};
+  };
+
+  SegmentedMemoryHashSetTest() {
+    hash_set_options_.capacity = 1000;
+    hash_set_options_.initial_segment_bytes = 4096;
+    hash_set_options_.max_segment_bytes = 16384;
+    hash_set_options_.max_segments = 8;
+    const uint64_t mem_size = TestHashSet::numBytes(stats_options_);
+    memory_.reset(new uint8_t[mem_size]);
+    memset(memory_.get(), 0, mem_size);
+  }
+
+  std::unique_ptr<TestHashSet> makeSet(bool init) {
+    return std::make_unique<TestHashSet>(hash_set_options_, init, memory_.get(), mapper_,
+                                         stats_options_);
+  }
+
+  // Returns the number of bytes carved into cells across all segments.
+  uint64_t carvedBytes(TestHashSet& hs) {
+    uint64_t bytes = 0;
+    for (auto* segment : hs.segments_) {
+      bytes += segment->end - TestHashSet::segmentHeaderBytes(segment->num_bytes);
+    }
+    return bytes;
+  }
+
+  SegmentedMemoryHashSetOptions hash_set_options_;
+  Stats::StatsOptionsImpl stats_options_;
+  TestMapper mapper_;
+  std::unique_ptr<uint8_t[]> memory_;
+};
+
+TEST_F(SegmentedMemoryHashSetTest, initAndAttach) {
+  {
+    auto hash_set1 = makeSet(true);  // init
+    auto hash_set2 = makeSet(false); // attach
+  }
+
+  // Nothing is mapped until a value is inserted.
+  EXPECT_TRUE(mapper_.segments_.empty());
+
+  // If we tweak an option, we can no longer attach it.
+  hash_set_options_.initial_segment_bytes = 8192;
+  EXPECT_THROW(makeSet(false), EnvoyException);
+}
+
+TEST_F(SegmentedMemoryHashSetTest, putRemove) {
+  auto hash_set = makeSet(true);
+  hash_set->sanityCheck();
+  EXPECT_EQ(0, hash_set->size());
+  EXPECT_EQ(nullptr, hash_set->get("no such key"));
+  TestHashSet::ValueCreatedPair vc = hash_set->insert("good key");
+  EXPECT_TRUE(vc.second);
+  vc.first->number = 12345;
+  hash_set->sanityCheck();
+  EXPECT_EQ(1, hash_set->size());
+  EXPECT_EQ(1, hash_set->numSegments());
+  EXPECT_EQ(12345, hash_set->get("good key")->number);
+
+  vc = hash_set->insert("good key");
+  EXPECT_FALSE(vc.second);
+  EXPECT_EQ(12345, vc.first->number);
+
+  EXPECT_TRUE(hash_set->remove("good key"));
+  EXPECT_FALSE(hash_set->remove("good key"));
+  hash_set->sanityCheck();
+  EXPECT_EQ(0, hash_set->size());
+  EXPECT_EQ(nullptr, hash_set->get("good key"));
+
+  // Keys that are too long are rejected.
+  EXPECT_EQ(nullptr, hash_set->insert(std::string(stats_options_.maxNameLength() + 1, 'x')).first);
+}
+
+TEST_F(SegmentedMemoryHashSetTest, cellsAreSizedToKeys) {
+  auto hash_set = makeSet(true);
+  hash_set->insert("a");
+  const uint64_t short_bytes = carvedBytes(*hash_set);
+  hash_set->insert(std::string(100, 'b'));
+  EXPECT_GE(carvedBytes(*hash_set) - short_bytes, 100);
+  EXPECT_LT(short_bytes, TestValue::structSizeWithOptions(stats_options_));
+
+  // A removed cell is reused by a key of the same size, without carving more memory.
+  const uint64_t bytes = carvedBytes(*hash_set);
+  EXPECT_TRUE(hash_set->remove("a"));
+  EXPECT_TRUE(hash_set->insert("c").second);
+  EXPECT_EQ(bytes, carvedBytes(*hash_set));
+  hash_set->sanityCheck();
+
+  // But not by a key of a different size.
+  EXPECT_TRUE(hash_set->remove("c"));
+  EXPECT_TRUE(hash_set->insert(std::string(50, 'd')).second);
+  EXPECT_LT(bytes, carvedBytes(*hash_set));
+  hash_set->sanityCheck();
+}
+
+TEST_F(SegmentedMemoryHashSetTest, growsIntoNewSegments) {
+  auto hash_set = makeSet(true);
+  for (uint32_t i = 0; i < 500; ++i) {
+    TestHashSet::ValueCreatedPair vc = hash_set->insert(fmt::format("key-{}", i));
+    ASSERT_TRUE(vc.second);
+    vc.first->number = i;
+  }
+  hash_set->sanityCheck();
+  EXPECT_EQ(500, hash_set->size());
+  EXPECT_LT(1, hash_set->numSegments());
+  EXPECT_EQ(hash_set->numSegments(), mapper_.segments_.size());
+  for (uint32_t i = 0; i < 500; ++i) {
+    EXPECT_EQ(i, hash_set->get(fmt::format("key-{}", i))->number);
+  }
+
+  // Segments double in size up to the maximum.
+  EXPECT_EQ(4096, TestHashSet::segmentBytes(hash_set_options_, 0));
+  EXPECT_EQ(8192, TestHashSet::segmentBytes(hash_set_options_, 1));
+  EXPECT_EQ(16384, TestHashSet::segmentBytes(hash_set_options_, 2));
+  EXPECT_EQ(16384, TestHashSet::segmentBytes(hash_set_options_, 3));
+}
+
+TEST_F(SegmentedMemoryHashSetTest, attachedSetsSeeNewSegments) {
+  auto hash_set1 = makeSet(true);
+  hash_set1->insert("first").first->number = 1;
+  auto hash_set2 = makeSet(false);
+  EXPECT_EQ(1, hash_set2->get("first")->number);
+
+  // Segments added through one set are mapped by the other on its next access.
+  uint32_t i = 0;
+  while (hash_set1->numSegments() < 3) {
+    hash_set1->insert(fmt::format("key-{}", i++));
+  }
+  EXPECT_EQ(i + 1, hash_set2->size());
+  EXPECT_NE(nullptr, hash_set2->get(fmt::format("key-{}", i - 1)));
+  EXPECT_TRUE(hash_set2->insert("second").second);
+  EXPECT_NE(nullptr, hash_set1->get("second"));
+  hash_set1->sanityCheck();
+  hash_set2->sanityCheck();
+}
+
+TEST_F(SegmentedMemoryHashSetTest, getUnlocked) {
+  auto hash_set1 = makeSet(true);
+  EXPECT_EQ(nullptr, hash_set1->getUnlocked("first"));
+  hash_set1->insert("first").first->number = 1;
+  EXPECT_EQ(1, hash_set1->getUnlocked("first")->number);
+  EXPECT_EQ(nullptr, hash_set1->getUnlocked("no such key"));
+
+  // Only the segments already mapped are searched.
+  auto hash_set2 = makeSet(false);
+  uint32_t i = 0;
+  while (hash_set1->numSegments() < 2) {
+    hash_set1->insert(fmt::format("key-{}", i++));
+  }
+  const std::string last_key = fmt::format("key-{}", i - 1);
+  EXPECT_NE(nullptr, hash_set1->getUnlocked(last_key));
+  EXPECT_EQ(1, hash_set2->getUnlocked("first")->number);
+  EXPECT_EQ(nullptr, hash_set2->getUnlocked(last_key));
+  EXPECT_NE(nullptr, hash_set2->get(last_key));
+  EXPECT_NE(nullptr, hash_set2->getUnlocked(last_key));
+
+  EXPECT_TRUE(hash_set2->remove("first"));
+  EXPECT_EQ(nullptr, hash_set1->getUnlocked("first"));
+}
+
+TEST_F(SegmentedMemoryHashSetTest, capacityAndSegmentLimits) {
+  hash_set_options_.capacity = 3;
+  auto hash_set = makeSet(true);
+  EXPECT_TRUE(hash_set->insert("a").second);
+  EXPECT_TRUE(hash_set->insert("b").second);
+  EXPECT_TRUE(hash_set->insert("c").second);
+  EXPECT_EQ(nullptr, hash_set->insert("d").first);
+  EXPECT_FALSE(hash_set->insert("a").second);
+  EXPECT_NE(nullptr, hash_set->insert("a").first);
+
+  // A set that cannot map another segment is full, even below capacity.
+  hash_set_options_.capacity = 1000;
+  hash_set_options_.max_segments = 1;
+  memset(memory_.get(), 0, TestHashSet::numBytes(stats_options_));
+  mapper_.segments_.clear();
+  hash_set = makeSet(true);
+  uint32_t i = 0;
+  while (hash_set->insert(fmt::format("key-{}", i)).first != nullptr) {
+    ++i;
+  }
+  EXPECT_LT(0, i);
+  EXPECT_EQ(1, hash_set->numSegments());
+  hash_set->sanityCheck();
+
+  mapper_.fail_ = true;
+  memset(memory_.get(), 0, TestHashSet::numBytes(stats_options_));
+  hash_set_options_.max_segments = 8;
+  hash_set = makeSet(true);
+  EXPECT_EQ(nullptr, hash_set->insert("a").first);
+  EXPECT_EQ(0, hash_set->numSegments());
+}
+
+} // namespace Envoy
@@ -0,0 +1,48 @@
+#include <atomic>
+#include <vector>
+
+#include "envoy/common/exception.h"
+
+#include "common/common/thread.h"
+
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Thread {
+
+TEST(ParallelForTest, Empty) {
+  bool called = false;
+  parallelFor(0, 1, [&](size_t) { called = true; });
+  EXPECT_FALSE(called);
+}
+
+TEST(ParallelForTest, RunsEachIndexOnce) {
+  std::vector<std::atomic<uint32_t>> calls(1000);
+  parallelFor(calls.size(), 1, [&](size_t i) { calls[i]++; });
+  for (const auto& count : calls) {
+    EXPECT_EQ(1U, count.load());
+  }
+}
+
+TEST(ParallelForTest, SmallBatchRunsInline) {
+  const ThreadId caller = Thread::currentThreadId();
+  parallelFor(10, 16, [&](size_t) { EXPECT_EQ(caller, Thread::currentThreadId()); });
+}
+
+TEST(ParallelForTest, RethrowsLowestIndexException) {
+  std::atomic<uint32_t> calls{0};
+  EXPECT_THROW_WITH_MESSAGE(parallelFor(1000, 1,
+                                        [&](size_t i) {
+                                          calls++;
+                                          if (i == 10 || i == 900) {
+                                            throw EnvoyException(std::to_string(i));
+                                          }
+                                        }),
+                            EnvoyException, "10");
+  EXPECT_LT(0U, calls.load());
+}
+
+} // namespace Thread
+} // namespace Envoy
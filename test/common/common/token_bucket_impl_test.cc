@@ -36,7 +36,7 @@ TEST_F(TokenBucketImplTest, MaxBucketSize) {
 
   EXPECT_TRUE(token_bucket.consume(3));
   EXPECT_CALL(mock_time_source_, monotonicTime())
-      .WillOnce(Return(time_point(std::chrono::seconds(10))));
+      .WillRepeatedly(Return(time_point(std::chrono::seconds(10))));
 
   EXPECT_FALSE(token_bucket.consume(4));
   EXPECT_TRUE(token_bucket.consume(3));
@@ -87,4 +87,17 @@ TEST_F(TokenBucketImplTest, ConsumeAndRefill) {
   }
 }
 
+// Verifies that the time a bucket spent full doesn't refill it once consumed.
+TEST_F(TokenBucketImplTest, ConsumeAfterFull) {
+  TokenBucketImpl token_bucket{1, mock_time_source_, 1};
+
+  EXPECT_CALL(mock_time_source_, monotonicTime())
+      .WillOnce(Return(time_point(std::chrono::seconds(100))))
+      .WillOnce(Return(time_point(std::chrono::milliseconds(100001))))
+      .WillOnce(Return(time_point(std::chrono::seconds(102))));
+  EXPECT_TRUE(token_bucket.consume());
+  EXPECT_FALSE(token_bucket.consume());
+  EXPECT_TRUE(token_bucket.consume());
+}
+
 } // namespace Envoy
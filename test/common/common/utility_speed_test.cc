@@ -1,11 +1,16 @@
 // Note: this should be run with --compilation_mode=opt, and would benefit from a
 // quiescent system with disabled cstate power management.
 
+#include <algorithm>
 #include <random>
+#include <string>
 
+#include "common/common/ascii.h"
 #include "common/common/assert.h"
 #include "common/common/utility.h"
 
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
 #include "absl/strings/string_view.h"
 #include "testing/base/public/benchmark.h"
 
@@ -18,6 +23,8 @@ static size_t AlreadyTrimmedLength = sizeof(AlreadyTrimmed) - 1;
 static const char CacheControl[] = "private, max-age=300, no-transform";
 static size_t CacheControlLength = sizeof(CacheControl) - 1;
 
+static const char HeaderName[] = "X-Envoy-Upstream-Service-Time";
+
 // NOLINT(namespace-envoy)
 
 static void BM_AccessLogDateTimeFormatter(benchmark::State& state) {
@@ -204,6 +211,51 @@ static void BM_FindTokenValueNoSplit(benchmark::State& state) {
 }
 BENCHMARK(BM_FindTokenValueNoSplit);
 
+// Byte at a time lower casing, as ToLowerTable and LowerCaseString used to do.
+static void BM_ToLowerCaseBytes(benchmark::State& state) {
+  std::string name(HeaderName);
+  for (auto _ : state) {
+    std::transform(name.begin(), name.end(), name.begin(), absl::ascii_tolower);
+    benchmark::DoNotOptimize(name);
+    name[0] = 'X';
+  }
+}
+BENCHMARK(BM_ToLowerCaseBytes);
+
+static void BM_ToLowerCaseWords(benchmark::State& state) {
+  std::string name(HeaderName);
+  for (auto _ : state) {
+    Envoy::AsciiUtil::toLowerCase(name);
+    benchmark::DoNotOptimize(name);
+    name[0] = 'X';
+  }
+}
+BENCHMARK(BM_ToLowerCaseWords);
+
+static void BM_CaseEqualBytes(benchmark::State& state) {
+  const std::string lower_name = absl::AsciiStrToLower(HeaderName);
+  for (auto _ : state) {
+    RELEASE_ASSERT(absl::EqualsIgnoreCase(HeaderName, lower_name), "");
+  }
+}
+BENCHMARK(BM_CaseEqualBytes);
+
+static void BM_CaseEqualWords(benchmark::State& state) {
+  const std::string lower_name = absl::AsciiStrToLower(HeaderName);
+  for (auto _ : state) {
+    RELEASE_ASSERT(Envoy::AsciiUtil::caseEqual(HeaderName, lower_name), "");
+  }
+}
+BENCHMARK(BM_CaseEqualWords);
+
+static void BM_CaseFindToken(benchmark::State& state) {
+  const absl::string_view cache_control(CacheControl, CacheControlLength);
+  for (auto _ : state) {
+    RELEASE_ASSERT(Envoy::StringUtil::caseFindToken(cache_control, ",", "No-Transform"), "");
+  }
+}
+BENCHMARK(BM_CaseFindToken);
+
 static void BM_IntervalSetInsert17(benchmark::State& state) {
   for (auto _ : state) {
     Envoy::IntervalSetImpl<size_t> interval_set;
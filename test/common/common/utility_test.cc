@@ -441,6 +441,13 @@ TEST(AccessLogDateTimeFormatter, fromTime) {
   EXPECT_EQ("2018-04-03T23:06:08.999Z", AccessLogDateTimeFormatter::fromTime(time4));
 }
 
+TEST(AccessLogDateTimeFormatter, appendTime) {
+  std::string output = "[";
+  AccessLogDateTimeFormatter::appendTime(SystemTime(std::chrono::milliseconds(1522796769123)),
+                                         output);
+  EXPECT_EQ("[2018-04-03T23:06:09.123Z", output);
+}
+
 TEST(Primes, isPrime) {
   EXPECT_TRUE(Primes::isPrime(67));
   EXPECT_FALSE(Primes::isPrime(49));
@@ -818,4 +825,38 @@ TEST(DateFormatter, FromTime) {
   EXPECT_EQ("", DateFormatter(std::string(1022, 'a') + "%H").fromTime(time2));
 }
 
+TEST(DateFormatter, AppendTime) {
+  const SystemTime time(std::chrono::microseconds(1522796769123456));
+  const DateFormatter formatter("%s.%3f|%Y");
+  std::string output = "[";
+  formatter.appendTime(time, output);
+  EXPECT_EQ("[1522796769.123|2018", output);
+  // The formatted second is cached.
+  formatter.appendTime(time + std::chrono::milliseconds(1), output);
+  EXPECT_EQ("[1522796769.123|20181522796769.124|2018", output);
+}
+
+TEST(DateFormatter, AppendTimeInterleavedFormats) {
+  const SystemTime time(std::chrono::microseconds(1522796769000456));
+  const DateFormatter formatter1("%H:%M:%S.%6f");
+  const DateFormatter formatter2("%f %Y");
+  const DateFormatter copy(formatter1);
+  std::string output;
+  formatter1.appendTime(time, output);
+  formatter2.appendTime(time, output);
+  copy.appendTime(time, output);
+  EXPECT_EQ("23:06:09.000456000456000 201823:06:09.000456", output);
+
+  // Each format is formatted again at the next second.
+  output.clear();
+  formatter2.appendTime(time + std::chrono::seconds(1), output);
+  formatter1.appendTime(time + std::chrono::seconds(1), output);
+  EXPECT_EQ("000456000 201823:06:10.000456", output);
+
+  // A formatter created after others were destroyed doesn't pick up their cached strings.
+  output.clear();
+  DateFormatter("%M").appendTime(time, output);
+  EXPECT_EQ("06", output);
+}
+
 } // namespace Envoy
@@ -203,6 +203,28 @@ TEST_F(ZlibCompressorImplTest, CompressWithNotCommonParams) {
   expectValidFinishedBuffer(accumulation_buffer, input_size);
 }
 
+// Exercises compression of a new stream by a compressor reset, at a different level.
+TEST_F(ZlibCompressorImplTest, CompressAfterReset) {
+  Buffer::OwnedImpl buffer;
+
+  ZlibCompressorImplTester compressor;
+  compressor.init(ZlibCompressorImpl::CompressionLevel::Best,
+                  ZlibCompressorImpl::CompressionStrategy::Standard, gzip_window_bits,
+                  memory_level);
+
+  // The first stream is left unfinished.
+  TestUtility::feedBufferWithRandomCharacters(buffer, default_input_size);
+  compressor.compressThenFlush(buffer);
+  drainBuffer(buffer);
+
+  compressor.reset();
+  compressor.setCompressionLevel(ZlibCompressorImpl::CompressionLevel::Speed);
+  EXPECT_EQ(0, compressor.checksum());
+  TestUtility::feedBufferWithRandomCharacters(buffer, default_input_size);
+  compressor.finish(buffer);
+  expectValidFinishedBuffer(buffer, default_input_size);
+}
+
 } // namespace
 } // namespace Compressor
 } // namespace Envoy
\ No newline at end of file
@@ -1,3 +1,5 @@
+#include <unistd.h>
+
 #include "envoy/api/v2/discovery.pb.h"
 #include "envoy/api/v2/eds.pb.h"
 
@@ -12,6 +14,7 @@
 #include "test/mocks/grpc/mocks.h"
 #include "test/mocks/local_info/mocks.h"
 #include "test/mocks/runtime/mocks.h"
+#include "test/test_common/environment.h"
 #include "test/test_common/logging.h"
 #include "test/test_common/utility.h"
 
@@ -43,7 +46,7 @@ public:
         local_info_, std::unique_ptr<Grpc::MockAsyncClient>(async_client_), dispatcher_,
         *Protobuf::DescriptorPool::generated_pool()->FindMethodByName(
             "envoy.service.discovery.v2.AggregatedDiscoveryService.StreamAggregatedResources"),
-        random_));
+        random_, snapshot_path_));
   }
 
   void expectSendMessage(const std::string& type_url,
@@ -77,6 +80,7 @@ public:
   NiceMock<MockGrpcMuxCallbacks> callbacks_;
   NiceMock<MockTimeSystem> mock_time_system_;
   NiceMock<LocalInfo::MockLocalInfo> local_info_;
+  std::string snapshot_path_;
 };
 
 // Validate behavior when multiple type URL watches are maintained, watches are created/destroyed
@@ -465,6 +469,121 @@ TEST_F(GrpcMuxImplTest, UnwatchedTypeRejectsResources) {
                       grpc_mux_->onReceiveMessage(std::move(response)));
 }
 
+std::unique_ptr<envoy::api::v2::DiscoveryResponse>
+loadAssignmentResponse(const std::string& version_info, const std::vector<std::string>& names) {
+  std::unique_ptr<envoy::api::v2::DiscoveryResponse> response(
+      new envoy::api::v2::DiscoveryResponse());
+  response->set_type_url(Config::TypeUrl::get().ClusterLoadAssignment);
+  response->set_version_info(version_info);
+  for (const std::string& name : names) {
+    envoy::api::v2::ClusterLoadAssignment load_assignment;
+    load_assignment.set_cluster_name(name);
+    response->add_resources()->PackFrom(load_assignment);
+  }
+  return response;
+}
+
+std::vector<std::string> loadAssignmentNames(
+    const Protobuf::RepeatedPtrField<ProtobufWkt::Any>& resources) {
+  std::vector<std::string> names;
+  for (const auto& resource : resources) {
+    names.push_back(
+        MessageUtil::anyConvert<envoy::api::v2::ClusterLoadAssignment>(resource).cluster_name());
+  }
+  return names;
+}
+
+// Validate that accepted resources are saved to the snapshot, and that a new mux replays them to
+// its watches until the server sends them.
+TEST_F(GrpcMuxImplTest, SnapshotReplay) {
+  snapshot_path_ = TestEnvironment::temporaryPath("grpc_mux_snapshot");
+  ::unlink(snapshot_path_.c_str());
+  const std::string& type_url = Config::TypeUrl::get().ClusterLoadAssignment;
+
+  // The mux creates its retry, snapshot replay and snapshot write timers in this order, and the
+  // most recently created mock timer is returned first.
+  Event::MockTimer* write_timer = new Event::MockTimer(&dispatcher_);
+  Event::MockTimer* replay_timer = new Event::MockTimer(&dispatcher_);
+  new NiceMock<Event::MockTimer>(&dispatcher_);
+  setup();
+  {
+    NiceMock<MockGrpcMuxCallbacks> foo_callbacks;
+    auto foo_sub = grpc_mux_->subscribe(type_url, {"x", "y", "z"}, foo_callbacks);
+    EXPECT_CALL(*write_timer, enableTimer(std::chrono::milliseconds(1000)));
+    grpc_mux_->onReceiveMessage(loadAssignmentResponse("1", {"x", "y", "z"}));
+    // Resources missing from a response are kept, unless they are no longer watched.
+    grpc_mux_->onReceiveMessage(loadAssignmentResponse("2", {"y"}));
+    foo_sub = grpc_mux_->subscribe(type_url, {"x", "y"}, foo_callbacks);
+    grpc_mux_->onReceiveMessage(loadAssignmentResponse("3", {"y"}));
+    write_timer->callback_();
+  }
+
+  grpc_mux_.reset();
+  async_client_ = new Grpc::MockAsyncClient();
+  new NiceMock<Event::MockTimer>(&dispatcher_);
+  replay_timer = new Event::MockTimer(&dispatcher_);
+  new NiceMock<Event::MockTimer>(&dispatcher_);
+  setup();
+
+  NiceMock<MockGrpcMuxCallbacks> foo_callbacks;
+  EXPECT_CALL(*replay_timer, enableTimer(std::chrono::milliseconds(0))).Times(2);
+  auto foo_sub = grpc_mux_->subscribe(type_url, {"x"}, foo_callbacks);
+  EXPECT_CALL(foo_callbacks, onConfigUpdate(_, "3"))
+      .WillOnce(Invoke([](const Protobuf::RepeatedPtrField<ProtobufWkt::Any>& resources,
+                          const std::string&) {
+        EXPECT_EQ(std::vector<std::string>({"x"}), loadAssignmentNames(resources));
+      }));
+  replay_timer->callback_();
+
+  // Only the new watch is given the snapshot.
+  NiceMock<MockGrpcMuxCallbacks> bar_callbacks;
+  auto bar_sub = grpc_mux_->subscribe(type_url, {"y", "z"}, bar_callbacks);
+  EXPECT_CALL(bar_callbacks, onConfigUpdate(_, "3"))
+      .WillOnce(Invoke([](const Protobuf::RepeatedPtrField<ProtobufWkt::Any>& resources,
+                          const std::string&) {
+        EXPECT_EQ(std::vector<std::string>({"y"}), loadAssignmentNames(resources));
+      }));
+  replay_timer->callback_();
+
+  // Once the server sends the resources, the snapshot is no longer replayed.
+  EXPECT_CALL(foo_callbacks, onConfigUpdate(_, "4"));
+  grpc_mux_->onReceiveMessage(loadAssignmentResponse("4", {"x"}));
+  NiceMock<MockGrpcMuxCallbacks> baz_callbacks;
+  EXPECT_CALL(baz_callbacks, onConfigUpdate(_, _)).Times(0);
+  auto baz_sub = grpc_mux_->subscribe(type_url, {"x"}, baz_callbacks);
+}
+
+// Validate that a snapshot written for another node is ignored.
+TEST_F(GrpcMuxImplTest, SnapshotOfAnotherNode) {
+  snapshot_path_ = TestEnvironment::temporaryPath("grpc_mux_snapshot_other_node");
+  ::unlink(snapshot_path_.c_str());
+  const std::string& type_url = Config::TypeUrl::get().ClusterLoadAssignment;
+
+  Event::MockTimer* write_timer = new Event::MockTimer(&dispatcher_);
+  new NiceMock<Event::MockTimer>(&dispatcher_);
+  new NiceMock<Event::MockTimer>(&dispatcher_);
+  setup();
+  {
+    NiceMock<MockGrpcMuxCallbacks> foo_callbacks;
+    auto foo_sub = grpc_mux_->subscribe(type_url, {"x"}, foo_callbacks);
+    EXPECT_CALL(*write_timer, enableTimer(_));
+    grpc_mux_->onReceiveMessage(loadAssignmentResponse("1", {"x"}));
+    write_timer->callback_();
+  }
+
+  grpc_mux_.reset();
+  async_client_ = new Grpc::MockAsyncClient();
+  local_info_.node_.set_id("other_node_name");
+  new NiceMock<Event::MockTimer>(&dispatcher_);
+  Event::MockTimer* replay_timer = new Event::MockTimer(&dispatcher_);
+  new NiceMock<Event::MockTimer>(&dispatcher_);
+  EXPECT_LOG_CONTAINS("info", "of node node_name in cluster cluster_name", setup());
+
+  NiceMock<MockGrpcMuxCallbacks> foo_callbacks;
+  EXPECT_CALL(*replay_timer, enableTimer(_)).Times(0);
+  auto foo_sub = grpc_mux_->subscribe(type_url, {"x"}, foo_callbacks);
+}
+
 TEST_F(GrpcMuxImplTest, BadLocalInfoEmptyClusterName) {
   EXPECT_CALL(local_info_, clusterName()).WillOnce(Return(""));
   EXPECT_THROW_WITH_MESSAGE(
@@ -472,7 +591,7 @@ TEST_F(GrpcMuxImplTest, BadLocalInfoEmptyClusterName) {
           local_info_, std::unique_ptr<Grpc::MockAsyncClient>(async_client_), dispatcher_,
           *Protobuf::DescriptorPool::generated_pool()->FindMethodByName(
               "envoy.service.discovery.v2.AggregatedDiscoveryService.StreamAggregatedResources"),
-          random_),
+          random_, ""),
       EnvoyException,
       "ads: node 'id' and 'cluster' are required. Set it either in 'node' config or via "
       "--service-node and --service-cluster options.");
@@ -485,7 +604,7 @@ TEST_F(GrpcMuxImplTest, BadLocalInfoEmptyNodeName) {
           local_info_, std::unique_ptr<Grpc::MockAsyncClient>(async_client_), dispatcher_,
           *Protobuf::DescriptorPool::generated_pool()->FindMethodByName(
               "envoy.service.discovery.v2.AggregatedDiscoveryService.StreamAggregatedResources"),
-          random_),
+          random_, ""),
       EnvoyException,
       "ads: node 'id' and 'cluster' are required. Set it either in 'node' config or via "
       "--service-node and --service-cluster options.");
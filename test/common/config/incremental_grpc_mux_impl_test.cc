@@ -0,0 +1,313 @@
+#include "envoy/api/v2/discovery.pb.h"
+#include "envoy/api/v2/eds.pb.h"
+
+#include "common/config/incremental_grpc_mux_impl.h"
+#include "common/config/protobuf_link_hacks.h"
+#include "common/config/resources.h"
+#include "common/protobuf/protobuf.h"
+
+#include "test/mocks/common.h"
+#include "test/mocks/config/mocks.h"
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/grpc/mocks.h"
+#include "test/mocks/local_info/mocks.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::InSequence;
+using testing::Invoke;
+using testing::IsSubstring;
+using testing::NiceMock;
+using testing::Return;
+
+namespace Envoy {
+namespace Config {
+namespace {
+
+typedef Protobuf::RepeatedPtrField<ProtobufWkt::Any> AddedResources;
+typedef Protobuf::RepeatedPtrField<ProtobufTypes::String> RemovedResources;
+
+class IncrementalGrpcMuxImplTest : public testing::Test {
+public:
+  IncrementalGrpcMuxImplTest() : async_client_(new Grpc::MockAsyncClient()) {
+    dispatcher_.setTimeSystem(mock_time_system_);
+  }
+
+  void setup() {
+    grpc_mux_.reset(new IncrementalGrpcMuxImpl(
+        local_info_, std::unique_ptr<Grpc::MockAsyncClient>(async_client_), dispatcher_,
+        *Protobuf::DescriptorPool::generated_pool()->FindMethodByName(
+            "envoy.api.v2.EndpointDiscoveryService.IncrementalEndpoints"),
+        random_));
+  }
+
+  void expectSendMessage(const std::vector<std::string>& subscribe,
+                         const std::vector<std::string>& unsubscribe,
+                         const std::string& nonce = "",
+                         const std::map<std::string, std::string>& initial_resource_versions = {},
+                         const Protobuf::int32 error_code = Grpc::Status::GrpcStatus::Ok,
+                         const std::string& error_message = "") {
+    envoy::api::v2::IncrementalDiscoveryRequest expected_request;
+    expected_request.mutable_node()->CopyFrom(local_info_.node());
+    expected_request.set_type_url(type_url_);
+    for (const auto& resource : subscribe) {
+      expected_request.add_resource_names_subscribe(resource);
+    }
+    for (const auto& resource : unsubscribe) {
+      expected_request.add_resource_names_unsubscribe(resource);
+    }
+    for (const auto& resource_version : initial_resource_versions) {
+      (*expected_request.mutable_initial_resource_versions())[resource_version.first] =
+          resource_version.second;
+    }
+    expected_request.set_response_nonce(nonce);
+    if (error_code != Grpc::Status::GrpcStatus::Ok) {
+      ::google::rpc::Status* error_detail = expected_request.mutable_error_detail();
+      error_detail->set_code(error_code);
+      error_detail->set_message(error_message);
+    }
+    EXPECT_CALL(async_stream_, sendMessage(ProtoEq(expected_request), false));
+  }
+
+  void addResource(envoy::api::v2::IncrementalDiscoveryResponse& response,
+                   const std::string& cluster_name, const std::string& version) {
+    envoy::api::v2::ClusterLoadAssignment load_assignment;
+    load_assignment.set_cluster_name(cluster_name);
+    auto* resource = response.add_resources();
+    resource->set_version(version);
+    resource->mutable_resource()->PackFrom(load_assignment);
+  }
+
+  const std::string type_url_{Config::TypeUrl::get().ClusterLoadAssignment};
+  NiceMock<Event::MockDispatcher> dispatcher_;
+  Runtime::MockRandomGenerator random_;
+  Grpc::MockAsyncClient* async_client_;
+  Grpc::MockAsyncStream async_stream_;
+  std::unique_ptr<IncrementalGrpcMuxImpl> grpc_mux_;
+  NiceMock<MockGrpcMuxCallbacks> callbacks_;
+  NiceMock<MockTimeSystem> mock_time_system_;
+  NiceMock<LocalInfo::MockLocalInfo> local_info_;
+};
+
+// Validate that only the changes to the set of watched resources are sent as watches are
+// created/destroyed (via RAII).
+TEST_F(IncrementalGrpcMuxImplTest, SubscriptionChanges) {
+  setup();
+  InSequence s;
+  auto foo_sub = grpc_mux_->subscribe(type_url_, {"x", "y"}, callbacks_);
+  EXPECT_CALL(*async_client_, start(_, _)).WillOnce(Return(&async_stream_));
+  expectSendMessage({"x", "y"}, {});
+  grpc_mux_->start();
+
+  expectSendMessage({"z"}, {});
+  auto bar_sub = grpc_mux_->subscribe(type_url_, {"y", "z"}, callbacks_);
+  expectSendMessage({}, {"x"});
+  foo_sub.reset();
+  expectSendMessage({}, {"y", "z"});
+}
+
+// Validate that a new stream subscribes to all the watched resources again, along with the versions
+// of the ones that were received.
+TEST_F(IncrementalGrpcMuxImplTest, ResetStream) {
+  Event::MockTimer* timer = nullptr;
+  Event::TimerCb timer_cb;
+  EXPECT_CALL(dispatcher_, createTimer_(_)).WillOnce(Invoke([&timer, &timer_cb](Event::TimerCb cb) {
+    timer_cb = cb;
+    EXPECT_EQ(nullptr, timer);
+    timer = new Event::MockTimer();
+    return timer;
+  }));
+  setup();
+  InSequence s;
+  auto foo_sub = grpc_mux_->subscribe(type_url_, {"x", "y"}, callbacks_);
+  EXPECT_CALL(*async_client_, start(_, _)).WillOnce(Return(&async_stream_));
+  expectSendMessage({"x", "y"}, {});
+  grpc_mux_->start();
+
+  std::unique_ptr<envoy::api::v2::IncrementalDiscoveryResponse> response(
+      new envoy::api::v2::IncrementalDiscoveryResponse());
+  response->set_system_version_info("1");
+  response->set_nonce("a");
+  addResource(*response, "x", "1");
+  EXPECT_CALL(callbacks_, onIncrementalConfigUpdate(_, _, "1"));
+  expectSendMessage({}, {}, "a");
+  grpc_mux_->onReceiveMessage(std::move(response));
+
+  EXPECT_CALL(random_, random());
+  ASSERT_TRUE(timer != nullptr); // initialized from dispatcher mock.
+  EXPECT_CALL(*timer, enableTimer(_));
+  grpc_mux_->onRemoteClose(Grpc::Status::GrpcStatus::Canceled, "");
+  EXPECT_CALL(*async_client_, start(_, _)).WillOnce(Return(&async_stream_));
+  expectSendMessage({"x", "y"}, {}, "", {{"x", "1"}});
+  timer_cb();
+
+  expectSendMessage({}, {"x", "y"});
+}
+
+// Validate pause-resume behavior.
+TEST_F(IncrementalGrpcMuxImplTest, PauseResume) {
+  setup();
+  InSequence s;
+  auto foo_x_sub = grpc_mux_->subscribe(type_url_, {"x"}, callbacks_);
+  grpc_mux_->pause(type_url_);
+  EXPECT_CALL(*async_client_, start(_, _)).WillOnce(Return(&async_stream_));
+  grpc_mux_->start();
+  expectSendMessage({"x"}, {});
+  grpc_mux_->resume(type_url_);
+  // Pausing another resource type has no effect.
+  grpc_mux_->pause("bar");
+  expectSendMessage({"y"}, {});
+  auto foo_y_sub = grpc_mux_->subscribe(type_url_, {"y"}, callbacks_);
+  grpc_mux_->resume("bar");
+  grpc_mux_->pause(type_url_);
+  auto foo_z_sub = grpc_mux_->subscribe(type_url_, {"z"}, callbacks_);
+  expectSendMessage({"z"}, {});
+  grpc_mux_->resume(type_url_);
+
+  expectSendMessage({}, {"z"});
+  expectSendMessage({}, {"y"});
+  expectSendMessage({}, {"x"});
+}
+
+// Validate behavior when type URL mismatches occur.
+TEST_F(IncrementalGrpcMuxImplTest, TypeUrlMismatch) {
+  setup();
+  InSequence s;
+  auto foo_sub = grpc_mux_->subscribe(type_url_, {"x"}, callbacks_);
+  EXPECT_CALL(*async_client_, start(_, _)).WillOnce(Return(&async_stream_));
+  expectSendMessage({"x"}, {});
+  grpc_mux_->start();
+
+  EXPECT_THROW_WITH_MESSAGE(
+      grpc_mux_->subscribe("bar", {}, callbacks_), EnvoyException,
+      fmt::format("Incremental xDS stream for {} cannot subscribe to bar", type_url_));
+
+  std::unique_ptr<envoy::api::v2::IncrementalDiscoveryResponse> invalid_response(
+      new envoy::api::v2::IncrementalDiscoveryResponse());
+  invalid_response->set_nonce("a");
+  invalid_response->add_resources()->mutable_resource()->set_type_url("bar");
+  const std::string error_prefix =
+      fmt::format("bar does not match {} type URL is IncrementalDiscoveryResponse", type_url_);
+  EXPECT_CALL(callbacks_, onConfigUpdateFailed(_))
+      .WillOnce(Invoke([&error_prefix](const EnvoyException* e) {
+        EXPECT_TRUE(IsSubstring("", "", error_prefix, e->what()));
+      }));
+  expectSendMessage({}, {}, "a", {}, Grpc::Status::GrpcStatus::Internal,
+                    fmt::format("bar does not match {} type URL is IncrementalDiscoveryResponse {}",
+                                type_url_, invalid_response->DebugString()));
+  grpc_mux_->onReceiveMessage(std::move(invalid_response));
+
+  expectSendMessage({}, {"x"});
+}
+
+// Validate that a watch of all the resources gets all the changes, and is called even when there
+// are none.
+TEST_F(IncrementalGrpcMuxImplTest, WildcardWatch) {
+  setup();
+  InSequence s;
+  auto foo_sub = grpc_mux_->subscribe(type_url_, {}, callbacks_);
+  EXPECT_CALL(*async_client_, start(_, _)).WillOnce(Return(&async_stream_));
+  expectSendMessage({}, {});
+  grpc_mux_->start();
+
+  {
+    std::unique_ptr<envoy::api::v2::IncrementalDiscoveryResponse> response(
+        new envoy::api::v2::IncrementalDiscoveryResponse());
+    response->set_system_version_info("1");
+    response->set_nonce("a");
+    addResource(*response, "x", "1");
+    response->add_removed_resources("y");
+    EXPECT_CALL(callbacks_, onIncrementalConfigUpdate(_, _, "1"))
+        .WillOnce(Invoke([](const AddedResources& added_resources,
+                            const RemovedResources& removed_resources, const std::string&) {
+          EXPECT_EQ(1, added_resources.size());
+          EXPECT_EQ("x", MessageUtil::anyConvert<envoy::api::v2::ClusterLoadAssignment>(
+                             added_resources[0])
+                             .cluster_name());
+          EXPECT_EQ(1, removed_resources.size());
+          EXPECT_EQ("y", removed_resources[0]);
+        }));
+    expectSendMessage({}, {}, "a");
+    grpc_mux_->onReceiveMessage(std::move(response));
+  }
+
+  {
+    std::unique_ptr<envoy::api::v2::IncrementalDiscoveryResponse> response(
+        new envoy::api::v2::IncrementalDiscoveryResponse());
+    response->set_system_version_info("2");
+    response->set_nonce("b");
+    EXPECT_CALL(callbacks_, onIncrementalConfigUpdate(_, _, "2"))
+        .WillOnce(Invoke([](const AddedResources& added_resources,
+                            const RemovedResources& removed_resources, const std::string&) {
+          EXPECT_TRUE(added_resources.empty());
+          EXPECT_TRUE(removed_resources.empty());
+        }));
+    expectSendMessage({}, {}, "b");
+    grpc_mux_->onReceiveMessage(std::move(response));
+  }
+}
+
+// Validate that watches of specific resources only get the changes to those resources.
+TEST_F(IncrementalGrpcMuxImplTest, WatchDemux) {
+  setup();
+  InSequence s;
+  NiceMock<MockGrpcMuxCallbacks> foo_callbacks;
+  auto foo_sub = grpc_mux_->subscribe(type_url_, {"x", "y"}, foo_callbacks);
+  NiceMock<MockGrpcMuxCallbacks> bar_callbacks;
+  auto bar_sub = grpc_mux_->subscribe(type_url_, {"y", "z"}, bar_callbacks);
+  EXPECT_CALL(*async_client_, start(_, _)).WillOnce(Return(&async_stream_));
+  expectSendMessage({"x", "y", "z"}, {});
+  grpc_mux_->start();
+
+  {
+    std::unique_ptr<envoy::api::v2::IncrementalDiscoveryResponse> response(
+        new envoy::api::v2::IncrementalDiscoveryResponse());
+    response->set_system_version_info("1");
+    response->set_nonce("a");
+    addResource(*response, "x", "1");
+    response->add_removed_resources("y");
+    EXPECT_CALL(bar_callbacks, onIncrementalConfigUpdate(_, _, "1"))
+        .WillOnce(Invoke([](const AddedResources& added_resources,
+                            const RemovedResources& removed_resources, const std::string&) {
+          EXPECT_TRUE(added_resources.empty());
+          EXPECT_EQ(1, removed_resources.size());
+          EXPECT_EQ("y", removed_resources[0]);
+        }));
+    EXPECT_CALL(foo_callbacks, onIncrementalConfigUpdate(_, _, "1"))
+        .WillOnce(Invoke([](const AddedResources& added_resources,
+                            const RemovedResources& removed_resources, const std::string&) {
+          EXPECT_EQ(1, added_resources.size());
+          EXPECT_EQ("x", MessageUtil::anyConvert<envoy::api::v2::ClusterLoadAssignment>(
+                             added_resources[0])
+                             .cluster_name());
+          EXPECT_EQ(1, removed_resources.size());
+          EXPECT_EQ("y", removed_resources[0]);
+        }));
+    expectSendMessage({}, {}, "a");
+    grpc_mux_->onReceiveMessage(std::move(response));
+  }
+
+  {
+    // Watches without changes are not called.
+    std::unique_ptr<envoy::api::v2::IncrementalDiscoveryResponse> response(
+        new envoy::api::v2::IncrementalDiscoveryResponse());
+    response->set_system_version_info("2");
+    response->set_nonce("b");
+    addResource(*response, "z", "2");
+    EXPECT_CALL(bar_callbacks, onIncrementalConfigUpdate(_, _, "2"));
+    EXPECT_CALL(foo_callbacks, onIncrementalConfigUpdate(_, _, _)).Times(0);
+    expectSendMessage({}, {}, "b");
+    grpc_mux_->onReceiveMessage(std::move(response));
+  }
+
+  expectSendMessage({}, {"z"});
+  expectSendMessage({}, {"x", "y"});
+}
+
+} // namespace
+} // namespace Config
+} // namespace Envoy
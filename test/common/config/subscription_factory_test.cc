@@ -38,7 +38,8 @@ public:
           return legacy_subscription_.release();
         },
         "envoy.api.v2.EndpointDiscoveryService.FetchEndpoints",
-        "envoy.api.v2.EndpointDiscoveryService.StreamEndpoints");
+        "envoy.api.v2.EndpointDiscoveryService.StreamEndpoints",
+        "envoy.api.v2.EndpointDiscoveryService.IncrementalEndpoints");
   }
 
   Upstream::MockClusterManager cm_;
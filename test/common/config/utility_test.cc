@@ -56,6 +56,32 @@ TEST(UtilityTest, GetTypedResourcesWrongType) {
                           EnvoyException, "Unable to unpack .*");
 }
 
+TEST(UtilityTest, UnpackResourcesKeepsOrder) {
+  Protobuf::RepeatedPtrField<ProtobufWkt::Any> resources;
+  for (int i = 0; i < 1000; ++i) {
+    envoy::api::v2::ClusterLoadAssignment load_assignment;
+    load_assignment.set_cluster_name(std::to_string(i));
+    resources.Add()->PackFrom(load_assignment);
+  }
+
+  auto typed_resources =
+      Utility::unpackResources<envoy::api::v2::ClusterLoadAssignment>(resources);
+  ASSERT_EQ(1000, typed_resources.size());
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(std::to_string(i), typed_resources[i].cluster_name());
+  }
+
+  // The error is the one of the first invalid resource.
+  envoy::api::v2::Listener listener;
+  listener.set_name("first");
+  resources.Mutable(500)->PackFrom(listener);
+  listener.set_name("second");
+  resources.Mutable(900)->PackFrom(listener);
+  EXPECT_THROW_WITH_REGEX(
+      Utility::unpackResources<envoy::api::v2::ClusterLoadAssignment>(resources), EnvoyException,
+      "first");
+}
+
 TEST(UtilityTest, ComputeHashedVersion) {
   EXPECT_EQ("hash_2e1472b57af294d1", Utility::computeHashedVersion("{}").first);
   EXPECT_EQ("hash_33bf00a859c4ba3f", Utility::computeHashedVersion("foo").first);
@@ -279,7 +305,8 @@ TEST(UtilityTest, FactoryForGrpcApiConfigSource) {
     api_config_source.add_cluster_names("foo");
     EXPECT_THROW_WITH_REGEX(
         Utility::factoryForGrpcApiConfigSource(async_client_manager, api_config_source, scope),
-        EnvoyException, "envoy::api::v2::core::ConfigSource type must be GRPC:");
+        EnvoyException,
+        "envoy::api::v2::core::ConfigSource type must be GRPC or INCREMENTAL_GRPC:");
   }
 
   {
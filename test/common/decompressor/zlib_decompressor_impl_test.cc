@@ -251,6 +251,52 @@ TEST_F(ZlibDecompressorImplTest, CompressDecompressOfMultipleSlices) {
   EXPECT_EQ(original_text, decompressed_text);
 }
 
+// Exercises decompression of data received in several buffers, as by a stream, and the reuse of
+// the decompressor for a new stream after a reset.
+TEST_F(ZlibDecompressorImplTest, DecompressInSeveralCallsAndReset) {
+  ZlibDecompressorImpl decompressor;
+  decompressor.init(gzip_window_bits);
+
+  for (uint64_t stream = 0; stream < 2; ++stream) {
+    Buffer::OwnedImpl buffer;
+    TestUtility::feedBufferWithRandomCharacters(buffer, default_input_size * 4, stream);
+    const std::string original_text{buffer.toString()};
+
+    Envoy::Compressor::ZlibCompressorImpl compressor;
+    compressor.init(Envoy::Compressor::ZlibCompressorImpl::CompressionLevel::Standard,
+                    Envoy::Compressor::ZlibCompressorImpl::CompressionStrategy::Standard,
+                    gzip_window_bits, memory_level);
+    compressor.compress(buffer, Compressor::State::Finish);
+
+    Buffer::OwnedImpl output_buffer;
+    while (buffer.length() > 0) {
+      Buffer::OwnedImpl input_buffer;
+      input_buffer.move(buffer, std::min<uint64_t>(buffer.length(), 100));
+      decompressor.decompress(input_buffer, output_buffer);
+    }
+
+    EXPECT_FALSE(decompressor.decompressionError());
+    EXPECT_EQ(compressor.checksum(), decompressor.checksum());
+    EXPECT_EQ(original_text, output_buffer.toString());
+    decompressor.reset();
+  }
+}
+
+// Exercises decompression of data which is not valid compressed data.
+TEST_F(ZlibDecompressorImplTest, DecompressInvalidData) {
+  Buffer::OwnedImpl input_buffer("this is not gzip data");
+  Buffer::OwnedImpl output_buffer;
+
+  ZlibDecompressorImpl decompressor;
+  decompressor.init(gzip_window_bits);
+  decompressor.decompress(input_buffer, output_buffer);
+  EXPECT_TRUE(decompressor.decompressionError());
+  EXPECT_EQ(0, output_buffer.length());
+
+  decompressor.reset();
+  EXPECT_FALSE(decompressor.decompressionError());
+}
+
 } // namespace
 } // namespace Decompressor
 } // namespace Envoy
@@ -1,16 +1,24 @@
+#include <chrono>
 #include <functional>
+#include <thread>
+#include <vector>
 
 #include "common/common/lock_guard.h"
 #include "common/common/thread.h"
 #include "common/event/dispatcher_impl.h"
 
 #include "test/mocks/common.h"
+#include "test/mocks/stats/mocks.h"
 #include "test/test_common/test_time.h"
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+using testing::_;
+using testing::Ge;
 using testing::InSequence;
+using testing::NiceMock;
+using testing::Property;
 
 namespace Envoy {
 namespace Event {
@@ -55,6 +63,76 @@ TEST(DeferredDeleteTest, DeferredDelete) {
   dispatcher.clearDeferredDeleteList();
 }
 
+TEST(TimerWheelTest, CoarseTimersUseWheel) {
+  DangerousDeprecatedTestTime test_time;
+  DispatcherImpl dispatcher(test_time.timeSystem());
+  dispatcher.enableTimerWheel(std::chrono::milliseconds(5));
+  ReadyWatcher precise_watcher;
+  ReadyWatcher coarse_watcher;
+
+  TimerPtr precise_timer = dispatcher.createTimer([&]() -> void { precise_watcher.ready(); });
+  TimerPtr coarse_timer = dispatcher.createTimer([&]() -> void { coarse_watcher.ready(); },
+                                                 TimerPrecision::Coarse);
+  precise_timer->enableTimer(std::chrono::milliseconds(1));
+  coarse_timer->enableTimer(std::chrono::milliseconds(20));
+
+  const MonotonicTime start = test_time.timeSystem().monotonicTime();
+  EXPECT_CALL(precise_watcher, ready());
+  EXPECT_CALL(coarse_watcher, ready());
+  // The loop exits once no timers are pending.
+  dispatcher.run(Dispatcher::RunType::Block);
+  EXPECT_LE(std::chrono::milliseconds(20), test_time.timeSystem().monotonicTime() - start);
+}
+
+TEST(DispatcherStatsTest, SlowIterationIsAttributed) {
+  DangerousDeprecatedTestTime test_time;
+  DispatcherImpl dispatcher(test_time.timeSystem());
+  NiceMock<Stats::MockIsolatedStatsStore> store;
+  dispatcher.initializeStats(store, "test.", std::chrono::milliseconds(5));
+
+  TimerPtr timer = dispatcher.createTimer(
+      []() -> void { std::this_thread::sleep_for(std::chrono::milliseconds(10)); });
+  timer->enableTimer(std::chrono::milliseconds(0));
+  ReadyWatcher watcher;
+  dispatcher.post([&]() -> void { watcher.ready(); });
+
+  EXPECT_CALL(watcher, ready());
+  EXPECT_CALL(store, deliverHistogramToSinks(_, _)).Times(testing::AnyNumber());
+  EXPECT_CALL(store,
+              deliverHistogramToSinks(
+                  Property(&Stats::Metric::name, "test.dispatcher.loop_duration_us"), Ge(10000)));
+  EXPECT_CALL(store, deliverHistogramToSinks(
+                         Property(&Stats::Metric::name, "test.dispatcher.timers_us"), Ge(10000)));
+  EXPECT_CALL(store, deliverHistogramToSinks(
+                         Property(&Stats::Metric::name, "test.dispatcher.post_callbacks_us"), _));
+  dispatcher.run(Dispatcher::RunType::NonBlock);
+  EXPECT_EQ(1U, store.counter("test.dispatcher.loop_stalls").value());
+
+  // Nothing ran, so there is no iteration to account for.
+  EXPECT_CALL(store, deliverHistogramToSinks(_, _)).Times(0);
+  dispatcher.run(Dispatcher::RunType::NonBlock);
+  EXPECT_EQ(1U, store.counter("test.dispatcher.loop_stalls").value());
+}
+
+TEST(DispatcherStatsTest, DeferredDeleteQueueDepth) {
+  DangerousDeprecatedTestTime test_time;
+  DispatcherImpl dispatcher(test_time.timeSystem());
+  NiceMock<Stats::MockIsolatedStatsStore> store;
+  dispatcher.initializeStats(store, "test.", std::chrono::milliseconds(0));
+
+  for (int i = 0; i < 3; i++) {
+    dispatcher.deferredDelete(DeferredDeletablePtr{new TestDeferredDeletable([]() -> void {})});
+  }
+
+  EXPECT_CALL(store, deliverHistogramToSinks(_, _)).Times(testing::AnyNumber());
+  const std::string depth_name = "test.dispatcher.deferred_delete_queue_depth";
+  EXPECT_CALL(store, deliverHistogramToSinks(Property(&Stats::Metric::name, depth_name), 3));
+  EXPECT_CALL(store, deliverHistogramToSinks(
+                         Property(&Stats::Metric::name, "test.dispatcher.deferred_delete_us"), _));
+  dispatcher.run(Dispatcher::RunType::NonBlock);
+  EXPECT_EQ(0U, store.counter("test.dispatcher.loop_stalls").value());
+}
+
 class DispatcherImplTest : public ::testing::Test {
 protected:
   DispatcherImplTest()
@@ -102,6 +180,32 @@ TEST_F(DispatcherImplTest, Post) {
   }
 }
 
+TEST_F(DispatcherImplTest, PostBatch) {
+  std::vector<int> order;
+  std::vector<PostCb> callbacks;
+  for (int i = 0; i < 3; i++) {
+    callbacks.push_back([this, &order, i]() {
+      Thread::LockGuard lock(mu_);
+      order.push_back(i);
+    });
+  }
+  callbacks.push_back([this]() {
+    {
+      Thread::LockGuard lock(mu_);
+      work_finished_ = true;
+    }
+    cv_.notifyOne();
+  });
+  dispatcher_->postBatch(std::move(callbacks));
+  EXPECT_TRUE(callbacks.empty());
+
+  Thread::LockGuard lock(mu_);
+  while (!work_finished_) {
+    cv_.wait(mu_);
+  }
+  EXPECT_EQ((std::vector<int>{0, 1, 2}), order);
+}
+
 // Ensure that there is no deadlock related to calling a posted callback, or
 // destructing a closure when finished calling it.
 TEST_F(DispatcherImplTest, RunPostCallbacksLocking) {
@@ -119,7 +223,7 @@ TEST_F(DispatcherImplTest, RunPostCallbacksLocking) {
     // Block dispatcher first to ensure that both posted events below are handled
     // by a single call to runPostCallbacks().
     //
-    // This also ensures that the post_lock_ is not held while callbacks are called,
+    // This also ensures that no dispatcher lock is held while callbacks are called,
     // or else this would deadlock.
     Thread::LockGuard lock(mu_);
     dispatcher_->post([this]() { Thread::LockGuard lock(mu_); });
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "envoy/network/address.h"
+
+#include "common/common/assert.h"
+#include "common/event/io_uring_impl.h"
+
+namespace Envoy {
+namespace Event {
+
+/**
+ * IoUringImpl without a kernel ring, so that the delivery of completions and the requests using
+ * the ring can be tested on any kernel. Submitted operations stay in flight until the test
+ * completes them. Cancellations complete like the kernel's: the operation in flight for the
+ * request completes with -ECANCELED, and the cancellation itself with 0, or with -ENOENT if nothing
+ * was in flight.
+ */
+class FakeIoUring : public IoUringImpl {
+public:
+  enum class OperationType { Accept, Poll, Cancel };
+
+  struct Operation {
+    OperationType type_;
+    int fd_;
+    IoUringRequest* request_;
+    sockaddr_storage* remote_addr_;
+    socklen_t* remote_addr_len_;
+  };
+
+  // Event::IoUringImpl
+  void prepareAccept(int fd, sockaddr_storage& remote_addr, socklen_t& remote_addr_len,
+                     IoUringRequest& request) override {
+    queued_.push_back({OperationType::Accept, fd, &request, &remote_addr, &remote_addr_len});
+  }
+  void preparePoll(int fd, uint32_t, IoUringRequest& request) override {
+    queued_.push_back({OperationType::Poll, fd, &request, nullptr, nullptr});
+  }
+  void submit() override {
+    for (const Operation& operation : queued_) {
+      if (operation.type_ != OperationType::Cancel) {
+        in_flight_.push_back(operation);
+        continue;
+      }
+      const size_t index = find(operation.request_);
+      if (index == in_flight_.size()) {
+        completions_.push_back({nullptr, -ENOENT});
+        continue;
+      }
+      in_flight_.erase(in_flight_.begin() + index);
+      completions_.push_back({operation.request_, -ECANCELED});
+      completions_.push_back({nullptr, 0});
+      cancels_++;
+    }
+    queued_.clear();
+  }
+
+  /**
+   * @param request supplies a request.
+   * @return const Operation* the operation in flight for the request, or nullptr if none is.
+   */
+  const Operation* inFlight(const IoUringRequest* request) const {
+    const size_t index = find(request);
+    return index == in_flight_.size() ? nullptr : &in_flight_[index];
+  }
+
+  /**
+   * @return const Operation& the operation submitted last among those in flight.
+   */
+  const Operation& lastInFlight() const {
+    RELEASE_ASSERT(!in_flight_.empty(), "nothing in flight");
+    return in_flight_.back();
+  }
+
+  /**
+   * Complete the operation in flight for a request. The completion is delivered by the next
+   * processCompletions().
+   * @param request supplies the request.
+   * @param result supplies the result of the operation.
+   */
+  void complete(IoUringRequest* request, int32_t result) {
+    const size_t index = find(request);
+    RELEASE_ASSERT(index < in_flight_.size(), "no operation in flight");
+    in_flight_.erase(in_flight_.begin() + index);
+    completions_.push_back({request, result});
+  }
+
+  /**
+   * Complete the accept in flight for a request with an accepted socket.
+   * @param request supplies the request.
+   * @param fd supplies the accepted socket.
+   * @param remote_address supplies the peer address reported for the socket.
+   */
+  void completeAccept(IoUringRequest* request, int fd,
+                      const Network::Address::Instance& remote_address) {
+    const Operation* operation = inFlight(request);
+    RELEASE_ASSERT(operation != nullptr && operation->type_ == OperationType::Accept, "");
+    memcpy(operation->remote_addr_, remote_address.sockAddr(), remote_address.sockAddrLen());
+    *operation->remote_addr_len_ = remote_address.sockAddrLen();
+    complete(request, fd);
+  }
+
+  // The number of cancellations which found an operation in flight.
+  uint32_t cancels_{};
+
+protected:
+  void prepareCancel(IoUringRequest& request) override {
+    queued_.push_back({OperationType::Cancel, -1, &request, nullptr, nullptr});
+  }
+  bool popCompletion(IoUringRequest*& request, int32_t& result) override {
+    if (completions_.empty()) {
+      return false;
+    }
+    request = completions_.front().first;
+    result = completions_.front().second;
+    completions_.pop_front();
+    return true;
+  }
+
+private:
+  size_t find(const IoUringRequest* request) const {
+    for (size_t i = 0; i < in_flight_.size(); i++) {
+      if (in_flight_[i].request_ == request) {
+        return i;
+      }
+    }
+    return in_flight_.size();
+  }
+
+  std::vector<Operation> queued_;
+  std::vector<Operation> in_flight_;
+  std::deque<std::pair<IoUringRequest*, int32_t>> completions_;
+};
+
+} // namespace Event
+} // namespace Envoy
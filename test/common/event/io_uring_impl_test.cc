@@ -0,0 +1,205 @@
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <iostream>
+
+#include "common/event/io_uring_impl.h"
+
+#include "test/common/event/fake_io_uring.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::InSequence;
+using testing::Invoke;
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Event {
+namespace {
+
+class MockIoUringRequest : public IoUringRequest {
+public:
+  ~MockIoUringRequest() { die(); }
+
+  MOCK_METHOD1(onCompletion, void(int32_t result));
+  MOCK_METHOD0(onCompletionBatchDone, void());
+  MOCK_METHOD0(die, void());
+};
+
+typedef NiceMock<MockIoUringRequest> Request;
+
+class IoUringImplTest : public testing::Test {
+protected:
+  FakeIoUring ring_;
+};
+
+// Test that every completion is delivered, and that a request hears about the end of the batch
+// once however many completions it received.
+TEST_F(IoUringImplTest, CompletionsAndBatch) {
+  Request request1;
+  Request request2;
+  sockaddr_storage remote_addr;
+  socklen_t remote_addr_len;
+  ring_.prepareAccept(10, remote_addr, remote_addr_len, request1);
+  ring_.preparePoll(11, POLLIN, request2);
+  ring_.submit();
+
+  ring_.complete(&request1, 20);
+  ring_.complete(&request2, POLLIN);
+  {
+    InSequence s;
+    // Operations queued by a callback are submitted and their completions delivered in the same
+    // batch.
+    EXPECT_CALL(request1, onCompletion(20)).WillOnce(Invoke([&](int32_t) -> void {
+      ring_.prepareAccept(10, remote_addr, remote_addr_len, request1);
+    }));
+    EXPECT_CALL(request2, onCompletion(POLLIN)).WillOnce(Invoke([&](int32_t) -> void {
+      // Complete the accept queued above once it has been submitted.
+      ring_.submit();
+      ring_.complete(&request1, 21);
+    }));
+    EXPECT_CALL(request1, onCompletion(21));
+    EXPECT_CALL(request1, onCompletionBatchDone());
+    EXPECT_CALL(request2, onCompletionBatchDone());
+  }
+  ring_.processCompletions();
+
+  // Nothing is delivered without completions.
+  ring_.processCompletions();
+}
+
+// Test that a request canceled with an operation in flight is owned by the ring until its final
+// completion, and is not told about the end of that batch.
+TEST_F(IoUringImplTest, CancelInFlight) {
+  auto request = std::make_unique<Request>();
+  Request* raw_request = request.get();
+  ring_.preparePoll(10, POLLIN, *request);
+  ring_.submit();
+
+  ring_.cancel(std::move(request));
+  EXPECT_EQ(1U, ring_.cancels_);
+  EXPECT_EQ(nullptr, ring_.inFlight(raw_request));
+
+  {
+    InSequence s;
+    EXPECT_CALL(*raw_request, onCompletion(-ECANCELED));
+    EXPECT_CALL(*raw_request, die());
+  }
+  EXPECT_CALL(*raw_request, onCompletionBatchDone()).Times(0);
+  ring_.processCompletions();
+}
+
+// Test that a request canceled from within its own completion is destroyed once the completion
+// returns, and is not told about the end of the batch.
+TEST_F(IoUringImplTest, CancelFromOwnCompletion) {
+  auto request = std::make_unique<Request>();
+  Request* raw_request = request.get();
+  Request other;
+  ring_.preparePoll(10, POLLIN, *request);
+  ring_.preparePoll(11, POLLIN, other);
+  ring_.submit();
+  ring_.complete(raw_request, POLLIN);
+  ring_.complete(&other, POLLIN);
+
+  {
+    InSequence s;
+    EXPECT_CALL(*raw_request, onCompletion(POLLIN)).WillOnce(Invoke([&](int32_t) -> void {
+      ring_.cancel(std::move(request));
+    }));
+    EXPECT_CALL(*raw_request, die());
+    EXPECT_CALL(other, onCompletion(POLLIN));
+    EXPECT_CALL(other, onCompletionBatchDone());
+  }
+  ring_.processCompletions();
+  EXPECT_EQ(0U, ring_.cancels_);
+}
+
+// Test that a request canceled by another request's completion, after receiving a completion of
+// its own in the same batch, stays alive until the completion of its operation in flight, and is
+// then dropped from the batch.
+TEST_F(IoUringImplTest, CancelAfterCompletionInBatch) {
+  auto request = std::make_unique<Request>();
+  Request* raw_request = request.get();
+  Request other;
+  ring_.preparePoll(10, POLLIN, *request);
+  ring_.preparePoll(11, POLLIN, other);
+  ring_.submit();
+  ring_.complete(raw_request, POLLIN);
+  ring_.complete(&other, POLLIN);
+
+  {
+    InSequence s;
+    EXPECT_CALL(*raw_request, onCompletion(POLLIN)).WillOnce(Invoke([&](int32_t) -> void {
+      ring_.preparePoll(10, POLLIN, *raw_request);
+    }));
+    EXPECT_CALL(other, onCompletion(POLLIN)).WillOnce(Invoke([&](int32_t) -> void {
+      ring_.cancel(std::move(request));
+    }));
+    // The cancellation lands within the same batch.
+    EXPECT_CALL(*raw_request, onCompletion(-ECANCELED));
+    EXPECT_CALL(*raw_request, die());
+    EXPECT_CALL(other, onCompletionBatchDone());
+  }
+  ring_.processCompletions();
+  EXPECT_EQ(1U, ring_.cancels_);
+}
+
+// Test that a request released by the end of batch callback of another request is not told about
+// the end of the batch, since its owner destroys it.
+TEST_F(IoUringImplTest, ReleaseDuringBatchDone) {
+  Request first;
+  auto released = std::make_unique<Request>();
+  Request last;
+  ring_.preparePoll(10, POLLIN, first);
+  ring_.preparePoll(11, POLLIN, *released);
+  ring_.preparePoll(12, POLLIN, last);
+  ring_.submit();
+  ring_.complete(&first, POLLIN);
+  ring_.complete(released.get(), POLLIN);
+  ring_.complete(&last, POLLIN);
+
+  EXPECT_CALL(first, onCompletion(POLLIN));
+  EXPECT_CALL(*released, onCompletion(POLLIN));
+  EXPECT_CALL(last, onCompletion(POLLIN));
+  EXPECT_CALL(*released, onCompletionBatchDone()).Times(0);
+  {
+    InSequence s;
+    EXPECT_CALL(first, onCompletionBatchDone()).WillOnce(Invoke([&]() -> void {
+      ring_.release(*released);
+      released.reset();
+    }));
+    EXPECT_CALL(last, onCompletionBatchDone());
+  }
+  ring_.processCompletions();
+}
+
+// Test a poll through a kernel ring, when the kernel running the test supports io_uring.
+TEST(IoUringImplKernelTest, Poll) {
+  IoUringImplPtr ring = IoUringImpl::create(8);
+  if (ring == nullptr) {
+    std::cout << "io_uring is not supported by the kernel running the test, skipping" << std::endl;
+    return;
+  }
+
+  int fds[2];
+  ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  Request request;
+  ring->preparePoll(fds[0], POLLIN, request);
+  ring->submit();
+  ASSERT_EQ(1, ::write(fds[1], "a", 1));
+
+  EXPECT_CALL(request, onCompletion(POLLIN));
+  EXPECT_CALL(request, onCompletionBatchDone());
+  pollfd event_fd{ring->eventFd(), POLLIN, 0};
+  ASSERT_EQ(1, ::poll(&event_fd, 1, 5000));
+  ring->processCompletions();
+
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+} // namespace
+} // namespace Event
+} // namespace Envoy
@@ -0,0 +1,211 @@
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "common/event/timer_wheel_impl.h"
+
+#include "test/mocks/common.h"
+#include "test/mocks/event/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::Invoke;
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Event {
+namespace {
+
+// Hands out the timer driving the wheel, so that tests can fire it by hand.
+class TestScheduler : public Scheduler {
+public:
+  TimerPtr createTimer(const TimerCb& cb) override {
+    cb_ = cb;
+    auto timer = std::make_unique<NiceMock<MockTimer>>();
+    timer_ = timer.get();
+    return std::move(timer);
+  }
+
+  TimerCb cb_;
+  MockTimer* timer_{};
+};
+
+class TimerWheelImplTest : public testing::Test {
+protected:
+  TimerWheelImplTest() {
+    ON_CALL(time_source_, monotonicTime()).WillByDefault(Invoke([this]() { return now_; }));
+    wheel_ = std::make_unique<TimerWheelImpl>(scheduler_, time_source_,
+                                              std::chrono::milliseconds(10));
+  }
+
+  // Move the clock forward and run the tick timer, as the dispatcher would once it fires.
+  void advance(std::chrono::milliseconds d) {
+    now_ += d;
+    scheduler_.cb_();
+  }
+
+  MonotonicTime now_;
+  NiceMock<MockTimeSource> time_source_;
+  TestScheduler scheduler_;
+  std::unique_ptr<TimerWheelImpl> wheel_;
+};
+
+TEST_F(TimerWheelImplTest, FiresOnTickAfterTimeout) {
+  ReadyWatcher watcher;
+  TimerPtr timer = wheel_->createTimer([&]() -> void { watcher.ready(); });
+
+  EXPECT_CALL(*scheduler_.timer_, enableTimer(std::chrono::milliseconds(10)));
+  timer->enableTimer(std::chrono::milliseconds(25));
+  EXPECT_EQ(1U, wheel_->armedTimers());
+
+  EXPECT_CALL(watcher, ready()).Times(0);
+  EXPECT_CALL(*scheduler_.timer_, enableTimer(std::chrono::milliseconds(10))).Times(2);
+  advance(std::chrono::milliseconds(10));
+  advance(std::chrono::milliseconds(10));
+
+  testing::Mock::VerifyAndClearExpectations(&watcher);
+  testing::Mock::VerifyAndClearExpectations(scheduler_.timer_);
+  EXPECT_CALL(watcher, ready());
+  // Nothing is left on the wheel, so the tick timer is not re-armed.
+  EXPECT_CALL(*scheduler_.timer_, enableTimer(_)).Times(0);
+  advance(std::chrono::milliseconds(10));
+  EXPECT_EQ(0U, wheel_->armedTimers());
+}
+
+TEST_F(TimerWheelImplTest, NeverFiresEarly) {
+  ReadyWatcher watcher;
+  TimerPtr timer = wheel_->createTimer([&]() -> void { watcher.ready(); });
+
+  // Armed part way through a tick, the deadline falls in the middle of the next one.
+  now_ += std::chrono::milliseconds(5);
+  EXPECT_CALL(*scheduler_.timer_, enableTimer(std::chrono::milliseconds(5)));
+  timer->enableTimer(std::chrono::milliseconds(10));
+
+  EXPECT_CALL(watcher, ready()).Times(0);
+  advance(std::chrono::milliseconds(5));
+  testing::Mock::VerifyAndClearExpectations(&watcher);
+
+  EXPECT_CALL(watcher, ready());
+  advance(std::chrono::milliseconds(10));
+}
+
+TEST_F(TimerWheelImplTest, DisableAndRearm) {
+  ReadyWatcher watcher;
+  TimerPtr timer = wheel_->createTimer([&]() -> void { watcher.ready(); });
+
+  timer->enableTimer(std::chrono::milliseconds(10));
+  timer->disableTimer();
+  EXPECT_EQ(0U, wheel_->armedTimers());
+  EXPECT_CALL(watcher, ready()).Times(0);
+  advance(std::chrono::milliseconds(20));
+  testing::Mock::VerifyAndClearExpectations(&watcher);
+
+  // Re-arming pushes the deadline back rather than adding a second one.
+  timer->enableTimer(std::chrono::milliseconds(10));
+  timer->enableTimer(std::chrono::milliseconds(30));
+  EXPECT_EQ(1U, wheel_->armedTimers());
+  EXPECT_CALL(watcher, ready()).Times(0);
+  advance(std::chrono::milliseconds(10));
+  advance(std::chrono::milliseconds(10));
+  testing::Mock::VerifyAndClearExpectations(&watcher);
+
+  EXPECT_CALL(watcher, ready());
+  advance(std::chrono::milliseconds(10));
+
+  // Destroying an armed timer takes it off the wheel.
+  timer->enableTimer(std::chrono::milliseconds(10));
+  timer.reset();
+  EXPECT_EQ(0U, wheel_->armedTimers());
+  advance(std::chrono::milliseconds(10));
+}
+
+TEST_F(TimerWheelImplTest, ZeroTimeoutRunsOnNextIteration) {
+  ReadyWatcher watcher;
+  TimerPtr timer;
+  timer = wheel_->createTimer([&]() -> void {
+    watcher.ready();
+    // Re-arming from the callback waits for the next iteration instead of looping.
+    timer->enableTimer(std::chrono::milliseconds(0));
+  });
+
+  EXPECT_CALL(*scheduler_.timer_, enableTimer(std::chrono::milliseconds(0)));
+  timer->enableTimer(std::chrono::milliseconds(0));
+
+  EXPECT_CALL(watcher, ready());
+  EXPECT_CALL(*scheduler_.timer_, enableTimer(std::chrono::milliseconds(0)));
+  scheduler_.cb_();
+}
+
+TEST_F(TimerWheelImplTest, ManyTimersInOneSlot) {
+  ReadyWatcher watcher;
+  std::vector<TimerPtr> timers;
+  for (int i = 0; i < 3; i++) {
+    timers.push_back(wheel_->createTimer([&]() -> void {
+      watcher.ready();
+      // Callbacks may tear down timers that are due in the same tick. The most recently armed
+      // timer runs first.
+      timers[0].reset();
+    }));
+    timers.back()->enableTimer(std::chrono::milliseconds(10));
+  }
+
+  EXPECT_CALL(watcher, ready()).Times(2);
+  advance(std::chrono::milliseconds(10));
+  EXPECT_EQ(0U, wheel_->armedTimers());
+}
+
+TEST_F(TimerWheelImplTest, LongTimeoutsCascade) {
+  ReadyWatcher watcher1;
+  ReadyWatcher watcher2;
+  TimerPtr timer1 = wheel_->createTimer([&]() -> void { watcher1.ready(); });
+  TimerPtr timer2 = wheel_->createTimer([&]() -> void { watcher2.ready(); });
+
+  // These land in the third and fourth levels of the wheel.
+  timer1->enableTimer(std::chrono::minutes(10));
+  timer2->enableTimer(std::chrono::hours(1));
+
+  EXPECT_CALL(watcher1, ready()).Times(0);
+  advance(std::chrono::minutes(10) - std::chrono::milliseconds(10));
+  testing::Mock::VerifyAndClearExpectations(&watcher1);
+  EXPECT_CALL(watcher1, ready());
+  advance(std::chrono::milliseconds(10));
+
+  EXPECT_CALL(watcher2, ready()).Times(0);
+  advance(std::chrono::minutes(50) - std::chrono::milliseconds(10));
+  testing::Mock::VerifyAndClearExpectations(&watcher2);
+  EXPECT_CALL(watcher2, ready());
+  advance(std::chrono::milliseconds(10));
+}
+
+TEST_F(TimerWheelImplTest, TimeoutBeyondWheelRange) {
+  ReadyWatcher watcher;
+  TimerPtr timer = wheel_->createTimer([&]() -> void { watcher.ready(); });
+
+  // 2^24 ticks of 10ms is a little over 46 hours.
+  timer->enableTimer(std::chrono::hours(50));
+
+  EXPECT_CALL(watcher, ready()).Times(0);
+  advance(std::chrono::hours(50) - std::chrono::milliseconds(10));
+  testing::Mock::VerifyAndClearExpectations(&watcher);
+  EXPECT_CALL(watcher, ready());
+  advance(std::chrono::milliseconds(10));
+}
+
+TEST_F(TimerWheelImplTest, IdleWheelCatchesUpWithClock) {
+  ReadyWatcher watcher;
+  TimerPtr timer = wheel_->createTimer([&]() -> void { watcher.ready(); });
+
+  // Nothing was armed while the clock moved, so the next tick is relative to the current time.
+  now_ += std::chrono::hours(1);
+  EXPECT_CALL(*scheduler_.timer_, enableTimer(std::chrono::milliseconds(10)));
+  timer->enableTimer(std::chrono::milliseconds(10));
+
+  EXPECT_CALL(watcher, ready());
+  advance(std::chrono::milliseconds(10));
+}
+
+} // namespace
+} // namespace Event
+} // namespace Envoy
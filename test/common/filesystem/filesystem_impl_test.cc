@@ -1,5 +1,7 @@
+#include <algorithm>
 #include <chrono>
 #include <string>
+#include <vector>
 
 #include "common/api/os_sys_calls_impl.h"
 #include "common/common/lock_guard.h"
@@ -390,5 +392,64 @@ TEST(FilesystemImpl, bigDataChunkShouldBeFlushedWithoutTimer) {
       os_sys_calls.write_event_.wait(os_sys_calls.write_mutex_);
     }
   }
+  EXPECT_EQ(1, stats_store.counter("filesystem.flushed_by_size").value());
+}
+
+// Writes from different threads are buffered in different shards, which are flushed by a single
+// writev().
+TEST(FilesystemImpl, writesFromThreadsFlushedWithWritev) {
+  NiceMock<Event::MockDispatcher> dispatcher;
+  Thread::MutexBasicLockable mutex;
+  Stats::IsolatedStoreImpl stats_store;
+  NiceMock<Api::MockOsSysCalls> os_sys_calls;
+  TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls(&os_sys_calls);
+
+  EXPECT_CALL(os_sys_calls, open_(_, _, _)).WillOnce(Return(5));
+  Filesystem::FileImpl file("", dispatcher, mutex, stats_store, std::chrono::milliseconds(40));
+
+  // The first write is flushed right away.
+  EXPECT_CALL(os_sys_calls, write_(_, _, _))
+      .WillOnce(Invoke([](int, const void*, size_t num_bytes) -> ssize_t { return num_bytes; }));
+  file.write("prime-it");
+  file.flush();
+
+  Thread::Thread thread([&file]() -> void { file.write("thread"); });
+  thread.join();
+  file.write("main");
+
+  EXPECT_CALL(os_sys_calls, writev(5, _, 2))
+      .WillOnce(Invoke([](int, const iovec* iov, int num_iov) -> Api::SysCallSizeResult {
+        std::vector<std::string> written;
+        ssize_t num_bytes = 0;
+        for (int i = 0; i < num_iov; i++) {
+          written.emplace_back(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+          num_bytes += iov[i].iov_len;
+        }
+        std::sort(written.begin(), written.end());
+        EXPECT_EQ((std::vector<std::string>{"main", "thread"}), written);
+        return {num_bytes, 0};
+      }));
+  file.flush();
+  EXPECT_EQ(0, stats_store.gauge("filesystem.write_total_buffered").value());
+}
+
+// Data which can't be written is dropped.
+TEST(FilesystemImpl, writeFailed) {
+  NiceMock<Event::MockDispatcher> dispatcher;
+  Thread::MutexBasicLockable mutex;
+  Stats::IsolatedStoreImpl stats_store;
+  NiceMock<Api::MockOsSysCalls> os_sys_calls;
+  TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls(&os_sys_calls);
+
+  EXPECT_CALL(os_sys_calls, open_(_, _, _)).WillOnce(Return(5));
+  Filesystem::FileImpl file("", dispatcher, mutex, stats_store, std::chrono::milliseconds(40));
+
+  EXPECT_CALL(os_sys_calls, write_(_, _, _))
+      .WillRepeatedly(Invoke([](int, const void*, size_t) -> ssize_t { return -1; }));
+  file.write("test");
+  file.flush();
+  EXPECT_EQ(1, stats_store.counter("filesystem.write_failed").value());
+  EXPECT_EQ(0, stats_store.counter("filesystem.write_completed").value());
+  EXPECT_EQ(0, stats_store.gauge("filesystem.write_total_buffered").value());
 }
 } // namespace Envoy
@@ -168,5 +168,57 @@ TEST(GrpcCodecTest, decodeMultipleFrame) {
   }
 }
 
+// The frames decoded before an invalid frame are drained from the input.
+TEST(GrpcCodecTest, decodeInvalidFrameAfterValidFrame) {
+  helloworld::HelloRequest request;
+  request.set_name("hello");
+
+  Buffer::OwnedImpl buffer;
+  std::array<uint8_t, 5> header;
+  Encoder encoder;
+  encoder.newFrame(GRPC_FH_DEFAULT, request.ByteSize(), header);
+  buffer.add(header.data(), 5);
+  buffer.add(request.SerializeAsString());
+  encoder.newFrame(0b10u, request.ByteSize(), header);
+  buffer.add(header.data(), 5);
+  buffer.add(request.SerializeAsString());
+  const size_t invalid_frame_size = 5 + request.ByteSize();
+
+  std::vector<Frame> frames;
+  Decoder decoder;
+  EXPECT_FALSE(decoder.decode(buffer, frames));
+  EXPECT_EQ(1, frames.size());
+  EXPECT_EQ(invalid_frame_size, buffer.length());
+}
+
+// The header and the payload of a frame may be split across any number of decode() calls.
+TEST(GrpcCodecTest, decodeByteByByte) {
+  helloworld::HelloRequest request;
+  request.set_name("hello");
+
+  Buffer::OwnedImpl frame_buffer;
+  std::array<uint8_t, 5> header;
+  Encoder encoder;
+  encoder.newFrame(GRPC_FH_DEFAULT, request.ByteSize(), header);
+  frame_buffer.add(header.data(), 5);
+  frame_buffer.add(request.SerializeAsString());
+  const std::string frame = frame_buffer.toString();
+
+  std::vector<Frame> frames;
+  Decoder decoder;
+  for (const char c : frame) {
+    Buffer::OwnedImpl buffer(&c, 1);
+    EXPECT_TRUE(decoder.decode(buffer, frames));
+    EXPECT_EQ(0, buffer.length());
+  }
+  ASSERT_EQ(1, frames.size());
+  EXPECT_FALSE(decoder.hasBufferedData());
+
+  helloworld::HelloRequest result;
+  result.ParseFromArray(frames[0].data_->linearize(frames[0].data_->length()),
+                        frames[0].data_->length());
+  EXPECT_EQ("hello", result.name());
+}
+
 } // namespace Grpc
 } // namespace Envoy
@@ -65,6 +65,37 @@ public:
   std::unique_ptr<GoogleAsyncClientImpl> grpc_client_;
 };
 
+// Validate that the channels are shared by the configurations which only differ by their stat
+// prefix.
+TEST(GoogleChannelCacheTest, SharedChannels) {
+  envoy::api::v2::core::GrpcService config;
+  config.mutable_google_grpc()->set_target_uri("fake_address");
+  config.mutable_google_grpc()->set_stat_prefix("foo");
+  envoy::api::v2::core::GrpcService other_prefix_config = config;
+  other_prefix_config.mutable_google_grpc()->set_stat_prefix("bar");
+  envoy::api::v2::core::GrpcService other_target_config = config;
+  other_target_config.mutable_google_grpc()->set_target_uri("other_fake_address");
+
+  GoogleChannelCache cache;
+  std::shared_ptr<grpc::Channel> channel = cache.channel(config);
+  EXPECT_EQ(channel, cache.channel(other_prefix_config));
+  EXPECT_NE(channel, cache.channel(other_target_config));
+
+  // Channels are not kept alive by the cache, which creates them again once released.
+  channel.reset();
+  EXPECT_NE(nullptr, cache.channel(config));
+}
+
+// Validate that the silos share the completion queues of a pool.
+TEST(GoogleCompletionQueuePoolTest, SharedCompletionQueues) {
+  auto cq_pool = std::make_shared<GoogleCompletionQueuePool>(2);
+  GoogleAsyncClientThreadLocal tls1(nullptr, cq_pool);
+  GoogleAsyncClientThreadLocal tls2(nullptr, cq_pool);
+  GoogleAsyncClientThreadLocal tls3(nullptr, cq_pool);
+  EXPECT_NE(&tls1.completionQueue(), &tls2.completionQueue());
+  EXPECT_EQ(&tls1.completionQueue(), &tls3.completionQueue());
+}
+
 // Validate that a failure in gRPC stub call creation returns immediately with
 // status UNAVAILABLE.
 TEST_F(EnvoyGoogleAsyncClientImplTest, StreamHttpStartFail) {
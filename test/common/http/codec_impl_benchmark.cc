@@ -0,0 +1,410 @@
+// Usage: bazel run //test/common/http:codec_impl_benchmark
+//
+// Drives request and response corpora through the HTTP/1 and HTTP/2 codecs with callbacks that do
+// no work of their own. Each benchmark reports ns_per_request and, in tcmalloc builds,
+// allocs_per_request. A codec is created per iteration, so per connection costs are amortized over
+// the requests of one iteration.
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/common/fmt.h"
+#include "common/common/thread.h"
+#include "common/http/header_map_impl.h"
+#include "common/http/headers.h"
+#include "common/http/http1/codec_impl.h"
+#include "common/http/http2/codec_impl.h"
+#include "common/stats/isolated_store_impl.h"
+
+#include "test/mocks/network/mocks.h"
+#include "test/test_common/malloc_counter.h"
+
+#include "testing/base/public/benchmark.h"
+
+using testing::_;
+using testing::Invoke;
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Http {
+namespace {
+
+/**
+ * Reports per request numbers for a benchmark once its loop is done.
+ */
+class RequestReporter {
+public:
+  RequestReporter(benchmark::State& state, uint64_t requests_per_iteration)
+      : state_(state), requests_per_iteration_(requests_per_iteration),
+        start_(std::chrono::steady_clock::now()) {}
+
+  void report() {
+    const std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start_;
+    const double requests = static_cast<double>(state_.iterations() * requests_per_iteration_);
+    state_.SetItemsProcessed(state_.iterations() * requests_per_iteration_);
+    state_.counters["ns_per_request"] = elapsed.count() / requests;
+    if (MallocCounter::supported()) {
+      state_.counters["allocs_per_request"] = malloc_counter_.count() / requests;
+    }
+  }
+
+private:
+  benchmark::State& state_;
+  const uint64_t requests_per_iteration_;
+  MallocCounter malloc_counter_;
+  const std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * Connection that discards everything the codec writes, or appends it to a capture buffer.
+ */
+class BenchmarkConnection {
+public:
+  BenchmarkConnection() {
+    ON_CALL(connection_, write(_, _)).WillByDefault(Invoke([this](Buffer::Instance& data, bool) {
+      if (capture_ != nullptr) {
+        capture_->move(data);
+      } else {
+        data.drain(data.length());
+      }
+    }));
+  }
+
+  // Runs the deferred deletion of closed streams, as the dispatcher would after each event.
+  void clearDeferredDeleteList() { connection_.dispatcher_.to_delete_.clear(); }
+
+  NiceMock<Network::MockConnection> connection_;
+  Buffer::Instance* capture_{};
+};
+
+/**
+ * Decoder that responds to its request as soon as the request is complete.
+ */
+class RespondingDecoder : public StreamDecoder {
+public:
+  RespondingDecoder(const HeaderMap& response_headers, const std::string& response_body)
+      : response_headers_(response_headers), response_body_(response_body) {}
+
+  // Http::StreamDecoder
+  void decode100ContinueHeaders(HeaderMapPtr&&) override {}
+  void decodeHeaders(HeaderMapPtr&&, bool end_stream) override {
+    if (end_stream) {
+      respond();
+    }
+  }
+  void decodeData(Buffer::Instance&, bool end_stream) override {
+    if (end_stream) {
+      respond();
+    }
+  }
+  void decodeTrailers(HeaderMapPtr&&) override { respond(); }
+
+  StreamEncoder* encoder_{};
+
+private:
+  void respond() {
+    if (response_body_.empty()) {
+      encoder_->encodeHeaders(response_headers_, true);
+    } else {
+      encoder_->encodeHeaders(response_headers_, false);
+      Buffer::OwnedImpl body(response_body_);
+      encoder_->encodeData(body, true);
+    }
+  }
+
+  const HeaderMap& response_headers_;
+  const std::string& response_body_;
+};
+
+/**
+ * Server callbacks handing out preallocated RespondingDecoders so that the benchmark itself does
+ * not allocate per request.
+ */
+class RespondingServerCallbacks : public ServerConnectionCallbacks {
+public:
+  RespondingServerCallbacks(uint64_t max_streams, const HeaderMap& response_headers,
+                            const std::string& response_body)
+      : decoders_(max_streams, RespondingDecoder(response_headers, response_body)) {}
+
+  void reset() { next_decoder_ = 0; }
+
+  // Http::ConnectionCallbacks
+  void onGoAway() override {}
+
+  // Http::ServerConnectionCallbacks
+  StreamDecoder& newStream(StreamEncoder& response_encoder) override {
+    RespondingDecoder& decoder = decoders_.at(next_decoder_++);
+    decoder.encoder_ = &response_encoder;
+    return decoder;
+  }
+
+private:
+  std::vector<RespondingDecoder> decoders_;
+  uint64_t next_decoder_{};
+};
+
+class NullDecoder : public StreamDecoder {
+public:
+  // Http::StreamDecoder
+  void decode100ContinueHeaders(HeaderMapPtr&&) override {}
+  void decodeHeaders(HeaderMapPtr&&, bool) override {}
+  void decodeData(Buffer::Instance&, bool) override {}
+  void decodeTrailers(HeaderMapPtr&&) override {}
+};
+
+class NullConnectionCallbacks : public ConnectionCallbacks {
+public:
+  // Http::ConnectionCallbacks
+  void onGoAway() override {}
+};
+
+void addCustomHeaders(HeaderMap& headers, uint64_t count) {
+  for (uint64_t i = 0; i < count; i++) {
+    headers.addCopy(LowerCaseString(fmt::format("x-custom-header-{}", i)),
+                    fmt::format("custom-value-{}", i));
+  }
+}
+
+HeaderMapImplPtr requestHeaders(uint64_t custom_headers) {
+  HeaderMapImplPtr headers{new HeaderMapImpl{{Headers::get().Method, "GET"},
+                                             {Headers::get().Path, "/some/resource?query=value"},
+                                             {Headers::get().Host, "www.example.com"},
+                                             {Headers::get().Scheme, "http"},
+                                             {Headers::get().UserAgent, "codec-benchmark/1.0"}}};
+  addCustomHeaders(*headers, custom_headers);
+  return headers;
+}
+
+HeaderMapImplPtr responseHeaders(uint64_t custom_headers) {
+  HeaderMapImplPtr headers{new HeaderMapImpl{{Headers::get().Status, "200"},
+                                             {Headers::get().ContentType, "application/json"},
+                                             {Headers::get().Date, "Mon, 01 Jan 2018 GMT"}}};
+  addCustomHeaders(*headers, custom_headers);
+  return headers;
+}
+
+std::string http1CustomHeaders(uint64_t custom_headers) {
+  std::string headers;
+  for (uint64_t i = 0; i < custom_headers; i++) {
+    headers += fmt::format("x-custom-header-{}: custom-value-{}\r\n", i, i);
+  }
+  return headers;
+}
+
+// HTTP/1.1 GET requests, pipelined on one connection.
+void BM_Http1ServerGet(benchmark::State& state) {
+  const uint64_t custom_headers = state.range(0);
+  const uint64_t requests = state.range(1);
+  std::string corpus;
+  for (uint64_t i = 0; i < requests; i++) {
+    corpus += "GET /some/resource?query=value HTTP/1.1\r\nhost: www.example.com\r\n"
+              "user-agent: codec-benchmark/1.0\r\n" +
+              http1CustomHeaders(custom_headers) + "\r\n";
+  }
+
+  BenchmarkConnection connection;
+  const HeaderMapImplPtr response_headers = responseHeaders(0);
+  const std::string response_body;
+  RespondingServerCallbacks callbacks(requests, *response_headers, response_body);
+  Http1Settings settings;
+  RequestReporter reporter(state, requests);
+  for (auto _ : state) {
+    callbacks.reset();
+    Http1::ServerConnectionImpl codec(connection.connection_, callbacks, settings);
+    Buffer::OwnedImpl data(corpus);
+    codec.dispatch(data);
+  }
+  reporter.report();
+}
+BENCHMARK(BM_Http1ServerGet)->Args({0, 1})->Args({10, 1})->Args({50, 1})->Args({10, 16});
+
+// HTTP/1.1 POST requests with a chunked body.
+void BM_Http1ServerChunkedPost(benchmark::State& state) {
+  const uint64_t chunks = state.range(0);
+  const uint64_t chunk_size = state.range(1);
+  std::string corpus = "POST /upload HTTP/1.1\r\nhost: www.example.com\r\n"
+                       "transfer-encoding: chunked\r\n" +
+                       http1CustomHeaders(10) + "\r\n";
+  const std::string chunk = fmt::format("{:x}\r\n{}\r\n", chunk_size, std::string(chunk_size, 'a'));
+  for (uint64_t i = 0; i < chunks; i++) {
+    corpus += chunk;
+  }
+  corpus += "0\r\n\r\n";
+
+  BenchmarkConnection connection;
+  const HeaderMapImplPtr response_headers = responseHeaders(0);
+  const std::string response_body;
+  RespondingServerCallbacks callbacks(1, *response_headers, response_body);
+  Http1Settings settings;
+  RequestReporter reporter(state, 1);
+  for (auto _ : state) {
+    callbacks.reset();
+    Http1::ServerConnectionImpl codec(connection.connection_, callbacks, settings);
+    Buffer::OwnedImpl data(corpus);
+    codec.dispatch(data);
+  }
+  reporter.report();
+}
+BENCHMARK(BM_Http1ServerChunkedPost)->Args({1, 1024})->Args({16, 1024})->Args({16, 16384});
+
+// HTTP/1.1 requests encoded by the client codec and their pipelined responses decoded.
+void BM_Http1Client(benchmark::State& state) {
+  const uint64_t custom_headers = state.range(0);
+  const uint64_t requests = state.range(1);
+  const uint64_t body_size = state.range(2);
+  std::string corpus;
+  for (uint64_t i = 0; i < requests; i++) {
+    corpus += fmt::format("HTTP/1.1 200 OK\r\ncontent-type: application/json\r\n"
+                          "content-length: {}\r\n{}\r\n{}",
+                          body_size, http1CustomHeaders(custom_headers),
+                          std::string(body_size, 'a'));
+  }
+
+  BenchmarkConnection connection;
+  NullConnectionCallbacks callbacks;
+  NullDecoder decoder;
+  const HeaderMapImplPtr request_headers = requestHeaders(custom_headers);
+  RequestReporter reporter(state, requests);
+  for (auto _ : state) {
+    Http1::ClientConnectionImpl codec(connection.connection_, callbacks);
+    for (uint64_t i = 0; i < requests; i++) {
+      codec.newStream(decoder).encodeHeaders(*request_headers, true);
+    }
+    Buffer::OwnedImpl data(corpus);
+    codec.dispatch(data);
+  }
+  reporter.report();
+}
+BENCHMARK(BM_Http1Client)->Args({0, 1, 0})->Args({10, 1, 1024})->Args({10, 16, 1024});
+
+// Captures what an HTTP/2 client codec writes when it sends the given requests on a new
+// connection. Request bodies must fit in the initial 64KiB connection window.
+std::string http2ClientCorpus(const HeaderMap& request_headers, uint64_t streams,
+                              uint64_t body_size) {
+  BenchmarkConnection connection;
+  Buffer::OwnedImpl captured;
+  connection.capture_ = &captured;
+  NullConnectionCallbacks callbacks;
+  NullDecoder decoder;
+  Stats::IsolatedStoreImpl stats;
+  Http2Settings settings;
+  Http2::ClientConnectionImpl client(connection.connection_, callbacks, stats, settings);
+  for (uint64_t i = 0; i < streams; i++) {
+    StreamEncoder& encoder = client.newStream(decoder);
+    if (body_size == 0) {
+      encoder.encodeHeaders(*request_headers, true);
+    } else {
+      encoder.encodeHeaders(request_headers, false);
+      Buffer::OwnedImpl body(std::string(body_size, 'a'));
+      encoder.encodeData(body, true);
+    }
+  }
+  return captured.toString();
+}
+
+// Concurrent HTTP/2 streams decoded and responded to by the server codec.
+void BM_Http2Server(benchmark::State& state) {
+  const uint64_t custom_headers = state.range(0);
+  const uint64_t streams = state.range(1);
+  const uint64_t body_size = state.range(2);
+  const HeaderMapImplPtr request_headers = requestHeaders(custom_headers);
+  const std::string corpus = http2ClientCorpus(*request_headers, streams, body_size);
+
+  BenchmarkConnection connection;
+  const HeaderMapImplPtr response_headers = responseHeaders(0);
+  const std::string response_body;
+  RespondingServerCallbacks callbacks(streams, *response_headers, response_body);
+  Stats::IsolatedStoreImpl stats;
+  Http2Settings settings;
+  RequestReporter reporter(state, streams);
+  for (auto _ : state) {
+    callbacks.reset();
+    Http2::ServerConnectionImpl codec(connection.connection_, callbacks, stats, settings);
+    Buffer::OwnedImpl data(corpus);
+    codec.dispatch(data);
+    connection.clearDeferredDeleteList();
+  }
+  reporter.report();
+}
+BENCHMARK(BM_Http2Server)
+    ->Args({0, 1, 0})
+    ->Args({10, 1, 0})
+    ->Args({50, 1, 0})
+    ->Args({10, 100, 0})
+    ->Args({10, 100, 512});
+
+// HTTP/2 requests encoded by the client codec and the server's responses decoded.
+void BM_Http2Client(benchmark::State& state) {
+  const uint64_t custom_headers = state.range(0);
+  const uint64_t streams = state.range(1);
+  const uint64_t body_size = state.range(2);
+  const HeaderMapImplPtr request_headers = requestHeaders(custom_headers);
+  const HeaderMapImplPtr response_headers = responseHeaders(custom_headers);
+  const std::string response_body(body_size, 'a');
+
+  // Capture the server's side of a connection that served the requests.
+  std::string corpus;
+  {
+    BenchmarkConnection client_connection;
+    BenchmarkConnection server_connection;
+    Buffer::OwnedImpl captured;
+    server_connection.capture_ = &captured;
+    RespondingServerCallbacks server_callbacks(streams, *response_headers, response_body);
+    Stats::IsolatedStoreImpl stats;
+    Http2Settings settings;
+    Http2::ServerConnectionImpl server(server_connection.connection_, server_callbacks, stats,
+                                       settings);
+    ON_CALL(client_connection.connection_, write(_, _))
+        .WillByDefault(Invoke([&server](Buffer::Instance& data, bool) { server.dispatch(data); }));
+    NullConnectionCallbacks client_callbacks;
+    NullDecoder decoder;
+    Http2::ClientConnectionImpl client(client_connection.connection_, client_callbacks, stats,
+                                       settings);
+    for (uint64_t i = 0; i < streams; i++) {
+      client.newStream(decoder).encodeHeaders(*request_headers, true);
+    }
+    corpus = captured.toString();
+    server_connection.clearDeferredDeleteList();
+  }
+
+  BenchmarkConnection connection;
+  NullConnectionCallbacks callbacks;
+  NullDecoder decoder;
+  Stats::IsolatedStoreImpl stats;
+  Http2Settings settings;
+  RequestReporter reporter(state, streams);
+  for (auto _ : state) {
+    Http2::ClientConnectionImpl codec(connection.connection_, callbacks, stats, settings);
+    for (uint64_t i = 0; i < streams; i++) {
+      codec.newStream(decoder).encodeHeaders(*request_headers, true);
+    }
+    Buffer::OwnedImpl data(corpus);
+    codec.dispatch(data);
+    connection.clearDeferredDeleteList();
+  }
+  reporter.report();
+}
+BENCHMARK(BM_Http2Client)
+    ->Args({0, 1, 0})
+    ->Args({10, 1, 1024})
+    ->Args({10, 100, 0})
+    ->Args({10, 100, 1024});
+
+} // namespace
+} // namespace Http
+} // namespace Envoy
+
+// Boilerplate main(), which discovers benchmarks in the same file and runs them.
+int main(int argc, char** argv) {
+  Envoy::Thread::MutexBasicLockable lock;
+  Envoy::Logger::Registry::initialize(spdlog::level::warn,
+                                      Envoy::Logger::Logger::DEFAULT_LOG_FORMAT, lock);
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+}
@@ -276,6 +276,7 @@ public:
   ConnectionManagerListenerStats& listenerStats() override { return listener_stats_; }
   bool proxy100Continue() const override { return proxy_100_continue_; }
   const Http::Http1Settings& http1Settings() const override { return http1_settings_; }
+  bool perStreamArena() const override { return per_stream_arena_; }
 
   DangerousDeprecatedTestTime test_time_;
   RouteConfigProvider route_config_provider_;
@@ -315,6 +316,7 @@ public:
   ConnectionManagerListenerStats listener_stats_;
   bool proxy_100_continue_ = false;
   Http::Http1Settings http1_settings_;
+  bool per_stream_arena_ = false;
   NiceMock<Network::MockClientConnection> upstream_conn_; // for websocket tests
   NiceMock<Tcp::ConnectionPool::MockInstance> conn_pool_; // for websocket tests
 
@@ -389,6 +391,44 @@ TEST_F(HttpConnectionManagerImplTest, HeaderOnlyRequestAndResponse) {
   EXPECT_EQ(1U, listener_stats_.downstream_rq_completed_.value());
 }
 
+TEST_F(HttpConnectionManagerImplTest, IdleForTransfer) {
+  setup(false, "envoy-custom-server", false);
+
+  // No codec has been created before any data arrives.
+  EXPECT_TRUE(conn_manager_->idleForTransfer());
+
+  std::shared_ptr<MockStreamDecoderFilter> filter(new NiceMock<MockStreamDecoderFilter>());
+  EXPECT_CALL(filter_factory_, createFilterChain(_))
+      .WillOnce(Invoke([&](FilterChainFactoryCallbacks& callbacks) -> void {
+        callbacks.addStreamDecoderFilter(filter);
+      }));
+  EXPECT_CALL(*filter, decodeHeaders(_, true)).WillOnce(Return(FilterHeadersStatus::StopIteration));
+
+  NiceMock<MockStreamEncoder> encoder;
+  EXPECT_CALL(*codec_, dispatch(_)).WillOnce(Invoke([&](Buffer::Instance& data) -> void {
+    StreamDecoder* decoder = &conn_manager_->newStream(encoder);
+    HeaderMapPtr headers{
+        new TestHeaderMapImpl{{":authority", "host"}, {":path", "/"}, {":method", "GET"}}};
+    decoder->decodeHeaders(std::move(headers), true);
+    data.drain(data.length());
+  }));
+  Buffer::OwnedImpl fake_input("1234");
+  conn_manager_->onData(fake_input, false);
+
+  // A request in progress keeps the connection.
+  EXPECT_FALSE(conn_manager_->idleForTransfer());
+
+  HeaderMapPtr response_headers{new TestHeaderMapImpl{{":status", "200"}}};
+  filter->callbacks_->encodeHeaders(std::move(response_headers), true);
+  EXPECT_TRUE(conn_manager_->idleForTransfer());
+
+  EXPECT_CALL(*codec_, wantsToWrite()).WillOnce(Return(true));
+  EXPECT_FALSE(conn_manager_->idleForTransfer());
+
+  EXPECT_CALL(*codec_, protocol()).WillRepeatedly(Return(Protocol::Http2));
+  EXPECT_FALSE(conn_manager_->idleForTransfer());
+}
+
 TEST_F(HttpConnectionManagerImplTest, 100ContinueResponse) {
   proxy_100_continue_ = true;
   setup(false, "envoy-custom-server", false);
@@ -621,6 +661,61 @@ TEST_F(HttpConnectionManagerImplTest, StartAndFinishSpanNormalFlow) {
   EXPECT_EQ(0UL, tracing_stats_.random_sampling_.value());
 }
 
+TEST_F(HttpConnectionManagerImplTest, TailSampleFailedRequest) {
+  setup(false, "");
+  tracing_config_.reset(new TracingConnectionManagerConfig(
+      {Tracing::OperationName::Ingress,
+       {LowerCaseString(":method")},
+       100,
+       10000,
+       100,
+       TailSamplingConfig{absl::nullopt, true, 0}}));
+
+  NiceMock<Tracing::MockSpan>* span = new NiceMock<Tracing::MockSpan>();
+  EXPECT_CALL(tracer_, startSpan_(_, _, _, _))
+      .WillOnce(
+          Invoke([&](const Tracing::Config&, const HeaderMap&, const RequestInfo::RequestInfo&,
+                     const Tracing::Decision decision) -> Tracing::Span* {
+            EXPECT_FALSE(decision.traced);
+            return span;
+          }));
+  EXPECT_CALL(*route_config_provider_.route_config_->route_, decorator())
+      .WillRepeatedly(Return(nullptr));
+  // The request completes with a 5xx response code, so that its span is reported.
+  EXPECT_CALL(*span, setSampled(true));
+  EXPECT_CALL(*span, finishSpan());
+
+  std::shared_ptr<MockStreamDecoderFilter> filter(new NiceMock<MockStreamDecoderFilter>());
+  EXPECT_CALL(filter_factory_, createFilterChain(_))
+      .WillRepeatedly(Invoke([&](FilterChainFactoryCallbacks& callbacks) -> void {
+        callbacks.addStreamDecoderFilter(filter);
+      }));
+
+  use_remote_address_ = false;
+  StreamDecoder* decoder = nullptr;
+  NiceMock<MockStreamEncoder> encoder;
+  EXPECT_CALL(*codec_, dispatch(_)).WillRepeatedly(Invoke([&](Buffer::Instance& data) -> void {
+    decoder = &conn_manager_->newStream(encoder);
+
+    HeaderMapPtr headers{
+        new TestHeaderMapImpl{{":method", "GET"},
+                              {":authority", "host"},
+                              {":path", "/"},
+                              {"x-request-id", "125a4afb-6f55-44ba-ad80-413f09f48a28"}}};
+    decoder->decodeHeaders(std::move(headers), true);
+
+    HeaderMapPtr response_headers{new TestHeaderMapImpl{{":status", "503"}}};
+    filter->callbacks_->encodeHeaders(std::move(response_headers), true);
+    data.drain(4);
+  }));
+
+  Buffer::OwnedImpl fake_input("1234");
+  conn_manager_->onData(fake_input, false);
+
+  EXPECT_EQ(1UL, tracing_stats_.not_traceable_.value());
+  EXPECT_EQ(1UL, tracing_stats_.tail_sampled_.value());
+}
+
 TEST_F(HttpConnectionManagerImplTest, StartAndFinishSpanNormalFlowIngressDecorator) {
   setup(false, "");
 
@@ -1106,6 +1201,58 @@ TEST_F(HttpConnectionManagerImplTest, NoPath) {
   conn_manager_->onData(fake_input, false);
 }
 
+// Filters may be allocated from the stream's arena when it is enabled.
+TEST_F(HttpConnectionManagerImplTest, PerStreamArena) {
+  per_stream_arena_ = true;
+  setup(false, "");
+
+  MockStreamDecoderFilter* filter = nullptr;
+  EXPECT_CALL(filter_factory_, createFilterChain(_))
+      .WillOnce(Invoke([&](FilterChainFactoryCallbacks& callbacks) -> void {
+        ASSERT_NE(nullptr, callbacks.arena());
+        auto arena_filter = makeSharedInArena<NiceMock<MockStreamDecoderFilter>>(callbacks.arena());
+        filter = arena_filter.get();
+        callbacks.addStreamDecoderFilter(arena_filter);
+      }));
+
+  EXPECT_CALL(*codec_, dispatch(_)).WillOnce(Invoke([&](Buffer::Instance& data) -> void {
+    StreamDecoder* decoder = &conn_manager_->newStream(response_encoder_);
+    HeaderMapPtr headers{
+        new TestHeaderMapImpl{{":authority", "host"}, {":path", "/"}, {":method", "GET"}}};
+    EXPECT_CALL(*filter, decodeHeaders(_, true))
+        .WillOnce(Return(FilterHeadersStatus::StopIteration));
+    decoder->decodeHeaders(std::move(headers), true);
+    data.drain(4);
+  }));
+
+  Buffer::OwnedImpl fake_input("1234");
+  conn_manager_->onData(fake_input, false);
+
+  EXPECT_CALL(response_encoder_, encodeHeaders(_, true));
+  HeaderMapPtr response_headers{new TestHeaderMapImpl{{":status", "200"}}};
+  filter->callbacks_->encodeHeaders(std::move(response_headers), true);
+}
+
+TEST_F(HttpConnectionManagerImplTest, PerStreamArenaDisabled) {
+  setup(false, "");
+
+  EXPECT_CALL(filter_factory_, createFilterChain(_))
+      .WillOnce(Invoke([&](FilterChainFactoryCallbacks& callbacks) -> void {
+        EXPECT_EQ(nullptr, callbacks.arena());
+      }));
+
+  EXPECT_CALL(*codec_, dispatch(_)).WillOnce(Invoke([&](Buffer::Instance& data) -> void {
+    StreamDecoder* decoder = &conn_manager_->newStream(response_encoder_);
+    HeaderMapPtr headers{
+        new TestHeaderMapImpl{{":authority", "host"}, {":path", "/"}, {":method", "GET"}}};
+    decoder->decodeHeaders(std::move(headers), true);
+    data.drain(4);
+  }));
+
+  Buffer::OwnedImpl fake_input("1234");
+  conn_manager_->onData(fake_input, false);
+}
+
 // No idle timeout when route idle timeout is implied at both global and
 // per-route level. The connection manager config is responsible for managing
 // the default configuration aspects.
@@ -1848,6 +1995,54 @@ TEST_F(HttpConnectionManagerImplTest, WebSocketEarlyEndStream) {
   conn_manager_.reset();
 }
 
+// Once the upstream connection is established, the codec is released and connection events no
+// longer reach it.
+TEST_F(HttpConnectionManagerImplTest, WebSocketTunnelReleasesCodec) {
+  setup(false, "");
+
+  EXPECT_CALL(cluster_manager_, tcpConnPoolForCluster("fake_cluster", _, _))
+      .WillOnce(Return(&conn_pool_));
+
+  StreamDecoder* decoder = nullptr;
+  NiceMock<MockStreamEncoder> encoder;
+
+  configureRouteForWebsocket(route_config_provider_.route_config_->route_->route_entry_);
+
+  EXPECT_CALL(*codec_, dispatch(_)).WillOnce(Invoke([&](Buffer::Instance& data) -> void {
+    decoder = &conn_manager_->newStream(encoder);
+    HeaderMapPtr headers{new TestHeaderMapImpl{{":authority", "host"},
+                                               {":method", "GET"},
+                                               {":path", "/"},
+                                               {"connection", "Upgrade"},
+                                               {"upgrade", "websocket"}}};
+    decoder->decodeHeaders(std::move(headers), false);
+    data.drain(4);
+  }));
+
+  Buffer::OwnedImpl fake_input("1234");
+  conn_manager_->onData(fake_input, false);
+
+  // The codec is destroyed, which verifies this, when the tunnel is established.
+  EXPECT_CALL(*codec_, onUnderlyingConnectionAboveWriteBufferHighWatermark()).Times(0);
+  Tcp::ConnectionPool::UpstreamCallbacks* upstream_callbacks = nullptr;
+  EXPECT_CALL(*conn_pool_.connection_data_, addUpstreamCallbacks(_))
+      .WillOnce(
+          Invoke([&](Tcp::ConnectionPool::UpstreamCallbacks& cb) { upstream_callbacks = &cb; }));
+  conn_pool_.poolReady(upstream_conn_);
+  conn_manager_->onAboveWriteBufferHighWatermark();
+
+  // Data is still proxied, and the stats still account for the WebSocket.
+  EXPECT_CALL(upstream_conn_, write(BufferStringEqual("message"), false));
+  Buffer::OwnedImpl message("message");
+  conn_manager_->onData(message, false);
+  EXPECT_EQ(1U, stats_.named_.downstream_cx_websocket_active_.value());
+
+  upstream_callbacks->onEvent(Network::ConnectionEvent::RemoteClose);
+  filter_callbacks_.connection_.dispatcher_.clearDeferredDeleteList();
+  conn_manager_.reset();
+  EXPECT_EQ(0U, stats_.named_.downstream_cx_websocket_active_.value());
+}
+
 // Make sure for upgrades, we do not append Connection: Close when draining.
 TEST_F(HttpConnectionManagerImplTest, FooUpgradeDrainClose) {
   setup(false, "envoy-custom-server", false);
@@ -1986,6 +2181,37 @@ TEST_F(HttpConnectionManagerImplTest, ResponseBeforeRequestComplete) {
   decoder_filters_[0]->callbacks_->encodeHeaders(std::move(response_headers), true);
 }
 
+TEST_F(HttpConnectionManagerImplTest, PipelinedRequests) {
+  http1_settings_.max_pipelined_requests_ = 2;
+  setup(false, "");
+
+  EXPECT_CALL(filter_factory_, createFilterChain(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([&](FilterChainFactoryCallbacks& callbacks) -> void {
+        auto filter = std::make_shared<NiceMock<MockStreamDecoderFilter>>();
+        ON_CALL(*filter, decodeHeaders(_, true))
+            .WillByDefault(Return(FilterHeadersStatus::StopIteration));
+        callbacks.addStreamDecoderFilter(filter);
+      }));
+
+  // Each dispatch decodes a single complete request, as the HTTP/1 codec does.
+  EXPECT_CALL(*codec_, dispatch(_)).Times(2).WillRepeatedly(Invoke([&](Buffer::Instance& data) {
+    StreamDecoder* decoder = &conn_manager_->newStream(response_encoder_);
+    HeaderMapPtr headers{
+        new TestHeaderMapImpl{{":authority", "host"}, {":path", "/"}, {":method", "GET"}}};
+    decoder->decodeHeaders(std::move(headers), true);
+    data.drain(1);
+  }));
+
+  // The second request is decoded without waiting for the first response, and reading stops
+  // once both are outstanding.
+  EXPECT_CALL(filter_callbacks_.connection_, readDisable(true));
+
+  Buffer::OwnedImpl fake_input("12");
+  conn_manager_->onData(fake_input, false);
+  EXPECT_EQ(0U, fake_input.length());
+}
+
 TEST_F(HttpConnectionManagerImplTest, ResponseStartBeforeRequestComplete) {
   setup(false, "");
 
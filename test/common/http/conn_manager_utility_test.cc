@@ -10,6 +10,7 @@
 #include "test/mocks/http/mocks.h"
 #include "test/mocks/local_info/mocks.h"
 #include "test/mocks/network/mocks.h"
+#include "test/mocks/request_info/mocks.h"
 #include "test/mocks/runtime/mocks.h"
 #include "test/mocks/ssl/mocks.h"
 #include "test/test_common/printers.h"
@@ -63,6 +64,7 @@ public:
   MOCK_METHOD0(listenerStats, ConnectionManagerListenerStats&());
   MOCK_CONST_METHOD0(proxy100Continue, bool());
   MOCK_CONST_METHOD0(http1Settings, const Http::Http1Settings&());
+  MOCK_CONST_METHOD0(perStreamArena, bool());
 };
 
 class ConnectionManagerUtilityTest : public testing::Test {
@@ -908,6 +910,19 @@ TEST_F(ConnectionManagerUtilityTest, SamplingMustNotBeDoneOnClientTraced) {
             UuidUtils::isTraceableUuid(request_headers.get_("x-request-id")));
 }
 
+// A traced request id is reset when global is off, leaving the rest of the id untouched.
+TEST_F(ConnectionManagerUtilityTest, TracedRequestIdResetWhenGlobalNotSet) {
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled("tracing.random_sampling", 10000, _, 10000))
+      .Times(0);
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled("tracing.global_enabled", 100, _))
+      .WillOnce(Return(false));
+
+  Http::TestHeaderMapImpl request_headers{{"x-request-id", "125a4afb-6f55-a4ba-ad80-413f09f48a28"}};
+  callMutateRequestHeaders(request_headers, Protocol::Http2);
+
+  EXPECT_EQ("125a4afb-6f55-44ba-ad80-413f09f48a28", request_headers.get_("x-request-id"));
+}
+
 // Sampling, global off.
 TEST_F(ConnectionManagerUtilityTest, NoTraceWhenSamplingSetButGlobalNotSet) {
   EXPECT_CALL(runtime_.snapshot_, featureEnabled("tracing.random_sampling", 10000, _, 10000))
@@ -1008,5 +1023,44 @@ TEST_F(ConnectionManagerUtilityTest, RemovesProxyResponseHeaders) {
   EXPECT_FALSE(response_headers.has("proxy-connection"));
 }
 
+// Failed requests, and the ones slower than the latency threshold, are tail sampled.
+TEST_F(ConnectionManagerUtilityTest, TailSampling) {
+  NiceMock<RequestInfo::MockRequestInfo> request_info;
+  TailSamplingConfig config{std::chrono::milliseconds(100), true, 0};
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled("tracing.tail_random_sampling", 0, _, 10000))
+      .WillRepeatedly(Return(false));
+
+  // No response.
+  EXPECT_TRUE(ConnectionManagerUtility::isTailSampled(request_info, config, runtime_, random_));
+
+  request_info.response_code_ = 503;
+  EXPECT_TRUE(ConnectionManagerUtility::isTailSampled(request_info, config, runtime_, random_));
+
+  request_info.response_code_ = 200;
+  request_info.end_time_ = std::chrono::milliseconds(50);
+  EXPECT_FALSE(ConnectionManagerUtility::isTailSampled(request_info, config, runtime_, random_));
+
+  request_info.end_time_ = std::chrono::milliseconds(150);
+  EXPECT_TRUE(ConnectionManagerUtility::isTailSampled(request_info, config, runtime_, random_));
+
+  config.latency_threshold_ = absl::nullopt;
+  EXPECT_FALSE(ConnectionManagerUtility::isTailSampled(request_info, config, runtime_, random_));
+
+  config.errors_ = false;
+  request_info.response_code_ = 503;
+  EXPECT_FALSE(ConnectionManagerUtility::isTailSampled(request_info, config, runtime_, random_));
+}
+
+// The other requests are tail sampled randomly.
+TEST_F(ConnectionManagerUtilityTest, TailRandomSampling) {
+  NiceMock<RequestInfo::MockRequestInfo> request_info;
+  request_info.response_code_ = 200;
+  TailSamplingConfig config{absl::nullopt, true, 500};
+  EXPECT_CALL(random_, random()).WillOnce(Return(42));
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled("tracing.tail_random_sampling", 500, 42, 10000))
+      .WillOnce(Return(true));
+  EXPECT_TRUE(ConnectionManagerUtility::isTailSampled(request_info, config, runtime_, random_));
+}
+
 } // namespace Http
 } // namespace Envoy
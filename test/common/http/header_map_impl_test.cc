@@ -275,6 +275,92 @@ TEST(HeaderStringTest, All) {
   }
 }
 
+TEST(HeaderStringTest, Pinned) {
+  const std::string data("hello world");
+  const absl::string_view hello(data.c_str() + 6, 5);
+
+  // The owner is held until the string is destroyed.
+  {
+    auto owner = std::make_shared<int>(0);
+    {
+      HeaderString string(hello, owner);
+      EXPECT_EQ(hello.data(), string.c_str());
+      EXPECT_EQ(5U, string.size());
+      EXPECT_EQ(HeaderString::Type::Pinned, string.type());
+      EXPECT_EQ(2, owner.use_count());
+    }
+    EXPECT_EQ(1, owner.use_count());
+  }
+
+  // Moving transfers the owner and resets the moved string.
+  {
+    auto owner = std::make_shared<int>(0);
+    HeaderString string(hello, owner);
+    HeaderString string2(std::move(string));
+    EXPECT_EQ(hello.data(), string2.c_str());
+    EXPECT_EQ(HeaderString::Type::Pinned, string2.type());
+    EXPECT_EQ(HeaderString::Type::Inline, string.type());
+    EXPECT_EQ(0U, string.size());
+    EXPECT_EQ(2, owner.use_count());
+  }
+
+  // Append copies the pinned data and releases the owner.
+  {
+    auto owner = std::make_shared<int>(0);
+    HeaderString string(hello, owner);
+    string.append("!", 1);
+    EXPECT_STREQ("world!", string.c_str());
+    EXPECT_EQ(HeaderString::Type::Dynamic, string.type());
+    EXPECT_EQ(1, owner.use_count());
+  }
+
+  // setCopy from the pinned data itself.
+  {
+    auto owner = std::make_shared<int>(0);
+    HeaderString string(hello, owner);
+    owner.reset();
+    string.setCopy(string.c_str() + 1, 4);
+    EXPECT_STREQ("orld", string.c_str());
+    EXPECT_EQ(HeaderString::Type::Inline, string.type());
+  }
+
+  // setInteger, setReference and setPinned release the owner.
+  {
+    auto owner = std::make_shared<int>(0);
+    HeaderString string(hello, owner);
+    string.setInteger(5);
+    EXPECT_STREQ("5", string.c_str());
+    EXPECT_EQ(HeaderString::Type::Inline, string.type());
+    EXPECT_EQ(1, owner.use_count());
+
+    string.setPinned(hello, owner);
+    string.setReference(data);
+    EXPECT_EQ(data.c_str(), string.c_str());
+    EXPECT_EQ(HeaderString::Type::Reference, string.type());
+    EXPECT_EQ(1, owner.use_count());
+
+    auto owner2 = std::make_shared<int>(0);
+    string.setPinned(hello, owner);
+    string.setPinned(absl::string_view(data), owner2);
+    EXPECT_EQ(data.c_str(), string.c_str());
+    EXPECT_EQ(1, owner.use_count());
+    EXPECT_EQ(2, owner2.use_count());
+  }
+
+  // Pinned values keep working once added to a header map.
+  {
+    auto owner = std::make_shared<int>(0);
+    HeaderMapImpl headers;
+    HeaderString key;
+    key.setCopy("hello", 5);
+    headers.addViaMove(std::move(key), HeaderString(hello, owner));
+    EXPECT_STREQ("world", headers.get(LowerCaseString("hello"))->value().c_str());
+    EXPECT_EQ(2, owner.use_count());
+    headers.remove(LowerCaseString("hello"));
+    EXPECT_EQ(1, owner.use_count());
+  }
+}
+
 TEST(HeaderMapImplTest, InlineInsert) {
   HeaderMapImpl headers;
   EXPECT_EQ(nullptr, headers.Host());
@@ -669,6 +755,59 @@ TEST(HeaderMapImplTest, Get) {
   }
 }
 
+// Maps with many headers are looked up through the hash index; check it stays consistent with the
+// list through adds, duplicates and every removal path.
+TEST(HeaderMapImplTest, IndexedLargeMap) {
+  HeaderMapImpl headers;
+  std::vector<LowerCaseString> keys;
+  for (int i = 0; i < 64; i++) {
+    keys.emplace_back("x-header-" + std::to_string(i));
+  }
+  for (const LowerCaseString& key : keys) {
+    headers.addCopy(key, key.get());
+  }
+  headers.insertPath().value(std::string("/"));
+  EXPECT_EQ(65UL, headers.size());
+
+  for (const LowerCaseString& key : keys) {
+    ASSERT_NE(nullptr, headers.get(key));
+    EXPECT_EQ(key.get(), headers.get(key)->value().c_str());
+  }
+  EXPECT_STREQ("/", headers.get(LowerCaseString(":path"))->value().c_str());
+  EXPECT_EQ(nullptr, headers.get(LowerCaseString("x-header-64")));
+
+  // get() returns the first of several entries with the same name, and remove() removes them all.
+  headers.addCopy(keys[3], "second");
+  EXPECT_STREQ("x-header-3", headers.get(keys[3])->value().c_str());
+  headers.remove(keys[3]);
+  EXPECT_EQ(nullptr, headers.get(keys[3]));
+  EXPECT_EQ(64UL, headers.size());
+  headers.addCopy(keys[3], "again");
+  EXPECT_STREQ("again", headers.get(keys[3])->value().c_str());
+
+  // Removing absent headers is a no-op.
+  headers.remove(LowerCaseString("x-absent"));
+  EXPECT_EQ(65UL, headers.size());
+
+  headers.removePath();
+  EXPECT_EQ(nullptr, headers.get(LowerCaseString(":path")));
+
+  headers.removePrefix(LowerCaseString("x-header-1"));
+  for (size_t i = 0; i < keys.size(); i++) {
+    const bool removed = keys[i].get().compare(0, 10, "x-header-1") == 0;
+    EXPECT_EQ(removed, headers.get(keys[i]) == nullptr) << keys[i].get();
+  }
+
+  for (const LowerCaseString& key : keys) {
+    headers.remove(key);
+    EXPECT_EQ(nullptr, headers.get(key));
+  }
+  EXPECT_EQ(0UL, headers.size());
+
+  headers.addCopy(keys[0], "value");
+  EXPECT_STREQ("value", headers.get(keys[0])->value().c_str());
+}
+
 TEST(HeaderMapImplTest, TestAppendHeader) {
   // Test appending to a string with a value.
   {
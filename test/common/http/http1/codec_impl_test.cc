@@ -1,4 +1,5 @@
 #include <string>
+#include <vector>
 
 #include "envoy/buffer/buffer.h"
 #include "envoy/event/dispatcher.h"
@@ -9,6 +10,7 @@
 #include "common/http/http1/codec_impl.h"
 
 #include "test/mocks/buffer/mocks.h"
+#include "test/mocks/event/mocks.h"
 #include "test/mocks/http/mocks.h"
 #include "test/mocks/network/mocks.h"
 #include "test/test_common/printers.h"
@@ -471,6 +473,69 @@ TEST_F(Http1ServerConnectionImplTest, DoubleRequest) {
   EXPECT_EQ(0U, buffer.length());
 }
 
+TEST_F(Http1ServerConnectionImplTest, PipelinedResponsesInOrder) {
+  initialize();
+
+  NiceMock<Http::MockStreamDecoder> decoder;
+  std::vector<Http::StreamEncoder*> response_encoders;
+  EXPECT_CALL(callbacks_, newStream(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([&](Http::StreamEncoder& encoder) -> Http::StreamDecoder& {
+        response_encoders.push_back(&encoder);
+        return decoder;
+      }));
+
+  std::string output;
+  ON_CALL(connection_, write(_, _)).WillByDefault(AddBufferToString(&output));
+
+  Buffer::OwnedImpl buffer("GET /a HTTP/1.1\r\n\r\nGET /b HTTP/1.1\r\n\r\n");
+  codec_->dispatch(buffer);
+  codec_->dispatch(buffer);
+  EXPECT_EQ(0U, buffer.length());
+  ASSERT_EQ(2U, response_encoders.size());
+
+  // The response to the second request is held back until the first response is complete.
+  response_encoders[1]->encodeHeaders(TestHeaderMapImpl{{":status", "404"}}, true);
+  EXPECT_EQ("", output);
+
+  response_encoders[0]->encodeHeaders(TestHeaderMapImpl{{":status", "200"}}, false);
+  EXPECT_EQ("HTTP/1.1 200 OK\r\ntransfer-encoding: chunked\r\n\r\n", output);
+  output.clear();
+
+  Buffer::OwnedImpl data("hello");
+  response_encoders[0]->encodeData(data, true);
+  EXPECT_EQ("5\r\nhello\r\n0\r\n\r\n"
+            "HTTP/1.1 404 Not Found\r\ncontent-length: 0\r\n\r\n",
+            output);
+}
+
+TEST_F(Http1ServerConnectionImplTest, PipelinedRequestsReset) {
+  initialize();
+
+  NiceMock<Http::MockStreamDecoder> decoder;
+  std::vector<Http::StreamEncoder*> response_encoders;
+  EXPECT_CALL(callbacks_, newStream(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([&](Http::StreamEncoder& encoder) -> Http::StreamDecoder& {
+        response_encoders.push_back(&encoder);
+        return decoder;
+      }));
+
+  Buffer::OwnedImpl buffer("GET /a HTTP/1.1\r\n\r\nGET /b HTTP/1.1\r\n\r\n");
+  codec_->dispatch(buffer);
+  codec_->dispatch(buffer);
+  ASSERT_EQ(2U, response_encoders.size());
+
+  // Resetting the first request resets the pipelined one behind it.
+  Http::MockStreamCallbacks callbacks1;
+  Http::MockStreamCallbacks callbacks2;
+  response_encoders[0]->getStream().addCallbacks(callbacks1);
+  response_encoders[1]->getStream().addCallbacks(callbacks2);
+  EXPECT_CALL(callbacks1, onResetStream(StreamResetReason::LocalReset));
+  EXPECT_CALL(callbacks2, onResetStream(StreamResetReason::LocalReset));
+  response_encoders[0]->getStream().resetStream(StreamResetReason::LocalReset);
+}
+
 TEST_F(Http1ServerConnectionImplTest, RequestWithTrailers) {
   initialize();
 
@@ -560,6 +625,48 @@ TEST_F(Http1ServerConnectionImplTest, UpgradeRequestWithNoBody) {
   codec_->dispatch(buffer);
 }
 
+// With coalesced writes, the headers of a response go out with its body, or at the end of the event
+// loop iteration if the body is not encoded by then.
+TEST_F(Http1ServerConnectionImplTest, CoalesceResponseWrites) {
+  codec_settings_.coalesce_response_writes_ = true;
+  initialize();
+
+  NiceMock<Http::MockStreamDecoder> decoder;
+  Http::StreamEncoder* response_encoder = nullptr;
+  EXPECT_CALL(callbacks_, newStream(_))
+      .WillRepeatedly(Invoke([&](Http::StreamEncoder& encoder) -> Http::StreamDecoder& {
+        response_encoder = &encoder;
+        return decoder;
+      }));
+
+  Buffer::OwnedImpl buffer("GET / HTTP/1.1\r\n\r\n");
+  codec_->dispatch(buffer);
+
+  std::string output;
+  EXPECT_CALL(connection_, write(_, _)).WillOnce(AddBufferToString(&output));
+  Event::MockTimer* flush_timer = new NiceMock<Event::MockTimer>(&connection_.dispatcher_);
+  EXPECT_CALL(*flush_timer, enableTimer(std::chrono::milliseconds(0)));
+  TestHeaderMapImpl headers{{":status", "200"}};
+  response_encoder->encodeHeaders(headers, false);
+  EXPECT_EQ("", output);
+
+  EXPECT_CALL(*flush_timer, disableTimer());
+  Buffer::OwnedImpl data("Hello World");
+  response_encoder->encodeData(data, true);
+  EXPECT_EQ("HTTP/1.1 200 OK\r\ntransfer-encoding: chunked\r\n\r\nb\r\nHello World\r\n0\r\n\r\n",
+            output);
+
+  output.clear();
+  buffer.add("GET / HTTP/1.1\r\n\r\n");
+  codec_->dispatch(buffer);
+  EXPECT_CALL(connection_, write(_, _)).WillOnce(AddBufferToString(&output));
+  EXPECT_CALL(*flush_timer, enableTimer(std::chrono::milliseconds(0)));
+  response_encoder->encodeHeaders(headers, false);
+  EXPECT_EQ("", output);
+  flush_timer->callback_();
+  EXPECT_EQ("HTTP/1.1 200 OK\r\ntransfer-encoding: chunked\r\n\r\n", output);
+}
+
 TEST_F(Http1ServerConnectionImplTest, WatermarkTest) {
   EXPECT_CALL(connection_, bufferLimit()).Times(1).WillOnce(Return(10));
   initialize();
@@ -594,6 +701,185 @@ TEST_F(Http1ServerConnectionImplTest, WatermarkTest) {
       ->onUnderlyingConnectionBelowWriteBufferLowWatermark();
 }
 
+class Http1ServerConnectionImplFastParsingTest : public Http1ServerConnectionImplTest {
+public:
+  Http1ServerConnectionImplFastParsingTest() { codec_settings_.fast_header_parsing_ = true; }
+};
+
+TEST_F(Http1ServerConnectionImplFastParsingTest, SimpleGet) {
+  initialize();
+
+  InSequence sequence;
+
+  Http::MockStreamDecoder decoder;
+  EXPECT_CALL(callbacks_, newStream(_)).WillOnce(ReturnRef(decoder));
+
+  TestHeaderMapImpl expected_headers{{":authority", "host"},
+                                     {"x-b", "2"},
+                                     {"x-a", "1"},
+                                     {"x-b", "3"},
+                                     {":path", "/foo"},
+                                     {":method", "GET"}};
+  EXPECT_CALL(decoder, decodeHeaders_(HeaderMapEqual(&expected_headers), true)).Times(1);
+
+  Buffer::OwnedImpl buffer(
+      "GET /foo HTTP/1.1\r\nHost: host\r\nX-B: 2\r\nx-a:  1\r\nX-B: 3\r\n\r\n");
+  codec_->dispatch(buffer);
+  EXPECT_EQ(0U, buffer.length());
+}
+
+TEST_F(Http1ServerConnectionImplFastParsingTest, PostWithContentLength) {
+  initialize();
+
+  InSequence sequence;
+
+  Http::MockStreamDecoder decoder;
+  EXPECT_CALL(callbacks_, newStream(_)).WillOnce(ReturnRef(decoder));
+
+  TestHeaderMapImpl expected_headers{
+      {"x-foo", "bar"}, {"content-length", "5"}, {":path", "/"}, {":method", "POST"}};
+  EXPECT_CALL(decoder, decodeHeaders_(HeaderMapEqual(&expected_headers), false)).Times(1);
+
+  Buffer::OwnedImpl expected_data1("12345");
+  EXPECT_CALL(decoder, decodeData(BufferEqual(&expected_data1), false)).Times(1);
+
+  Buffer::OwnedImpl expected_data2;
+  EXPECT_CALL(decoder, decodeData(BufferEqual(&expected_data2), true)).Times(1);
+
+  Buffer::OwnedImpl buffer("POST / HTTP/1.1\r\nx-foo: bar\r\ncontent-length: 5\r\n\r\n12345");
+  codec_->dispatch(buffer);
+  EXPECT_EQ(0U, buffer.length());
+}
+
+TEST_F(Http1ServerConnectionImplFastParsingTest, ChunkedPost) {
+  initialize();
+
+  InSequence sequence;
+
+  Http::MockStreamDecoder decoder;
+  EXPECT_CALL(callbacks_, newStream(_)).WillOnce(ReturnRef(decoder));
+
+  TestHeaderMapImpl expected_headers{
+      {"transfer-encoding", "chunked"}, {"x-foo", "bar"}, {":path", "/"}, {":method", "POST"}};
+  EXPECT_CALL(decoder, decodeHeaders_(HeaderMapEqual(&expected_headers), false)).Times(1);
+
+  Buffer::OwnedImpl expected_data1("Hello World");
+  EXPECT_CALL(decoder, decodeData(BufferEqual(&expected_data1), false)).Times(1);
+
+  Buffer::OwnedImpl expected_data2;
+  EXPECT_CALL(decoder, decodeData(BufferEqual(&expected_data2), true)).Times(1);
+
+  Buffer::OwnedImpl buffer("POST / HTTP/1.1\r\ntransfer-encoding: chunked\r\nx-foo: bar\r\n\r\n"
+                           "b\r\nHello World\r\n0\r\n\r\n");
+  codec_->dispatch(buffer);
+  EXPECT_EQ(0U, buffer.length());
+}
+
+// Pipelined requests each start on the fast path, one dispatch at a time like on the slow path.
+TEST_F(Http1ServerConnectionImplFastParsingTest, PipelinedRequests) {
+  initialize();
+
+  InSequence sequence;
+
+  Http::MockStreamDecoder decoder1;
+  Http::MockStreamDecoder decoder2;
+  TestHeaderMapImpl expected_headers1{{"x-id", "1"}, {":path", "/a"}, {":method", "GET"}};
+  TestHeaderMapImpl expected_headers2{{"x-id", "2"}, {":path", "/b"}, {":method", "GET"}};
+  EXPECT_CALL(callbacks_, newStream(_)).WillOnce(ReturnRef(decoder1));
+  EXPECT_CALL(decoder1, decodeHeaders_(HeaderMapEqual(&expected_headers1), true)).Times(1);
+  EXPECT_CALL(callbacks_, newStream(_)).WillOnce(ReturnRef(decoder2));
+  EXPECT_CALL(decoder2, decodeHeaders_(HeaderMapEqual(&expected_headers2), true)).Times(1);
+
+  Buffer::OwnedImpl buffer("GET /a HTTP/1.1\r\nx-id: 1\r\n\r\nGET /b HTTP/1.1\r\nx-id: 2\r\n\r\n");
+  codec_->dispatch(buffer);
+  EXPECT_EQ("GET /b HTTP/1.1\r\nx-id: 2\r\n\r\n", buffer.toString());
+  codec_->dispatch(buffer);
+  EXPECT_EQ(0U, buffer.length());
+}
+
+TEST_F(Http1ServerConnectionImplFastParsingTest, UpgradeRequestWithEarlyData) {
+  initialize();
+
+  InSequence sequence;
+  NiceMock<Http::MockStreamDecoder> decoder;
+  EXPECT_CALL(callbacks_, newStream(_)).WillOnce(ReturnRef(decoder));
+
+  Buffer::OwnedImpl expected_data("12345abcd");
+  EXPECT_CALL(decoder, decodeHeaders_(_, false)).Times(1);
+  EXPECT_CALL(decoder, decodeData(BufferEqual(&expected_data), false)).Times(1);
+  Buffer::OwnedImpl buffer("POST / HTTP/1.1\r\nConnection: upgrade\r\nUpgrade: "
+                           "foo\r\ncontent-length:5\r\n\r\n12345abcd");
+  codec_->dispatch(buffer);
+}
+
+// Header blocks split across dispatches are parsed by http_parser.
+TEST_F(Http1ServerConnectionImplFastParsingTest, Fallback) {
+  initialize();
+
+  InSequence sequence;
+
+  Http::MockStreamDecoder decoder;
+  EXPECT_CALL(callbacks_, newStream(_)).WillOnce(ReturnRef(decoder));
+
+  TestHeaderMapImpl expected_headers{{"x-foo", "bar"}, {":path", "/"}, {":method", "GET"}};
+  EXPECT_CALL(decoder, decodeHeaders_(HeaderMapEqual(&expected_headers), true)).Times(1);
+
+  Buffer::OwnedImpl buffer("GET / HTTP/1.1\r\nx-foo: bar\r\n");
+  codec_->dispatch(buffer);
+  Buffer::OwnedImpl buffer2("\r\n");
+  codec_->dispatch(buffer2);
+  EXPECT_EQ(0U, buffer2.length());
+}
+
+// Large header values reference the read buffer instead of being copied.
+TEST_F(Http1ServerConnectionImplFastParsingTest, PinnedHeaderValues) {
+  initialize();
+
+  Http::MockStreamDecoder decoder;
+  EXPECT_CALL(callbacks_, newStream(_)).WillOnce(ReturnRef(decoder));
+
+  const std::string cookie(4096, 'c');
+  HeaderMapPtr headers;
+  EXPECT_CALL(decoder, decodeHeaders_(_, true)).WillOnce(Invoke([&](HeaderMapPtr& h, bool) {
+    headers = std::move(h);
+  }));
+
+  Buffer::OwnedImpl buffer("GET / HTTP/1.1\r\nx-short: foo\r\ncookie: " + cookie + "\r\n\r\n");
+  codec_->dispatch(buffer);
+  EXPECT_EQ(0U, buffer.length());
+
+  const HeaderEntry* short_header = headers->get(LowerCaseString("x-short"));
+  ASSERT_NE(nullptr, short_header);
+  EXPECT_STREQ("foo", short_header->value().c_str());
+  EXPECT_EQ(HeaderString::Type::Inline, short_header->value().type());
+
+  // The value stays valid after the buffer it was parsed from is gone.
+  buffer = Buffer::OwnedImpl();
+  const HeaderEntry* cookie_header = headers->get(LowerCaseString("cookie"));
+  ASSERT_NE(nullptr, cookie_header);
+  EXPECT_EQ(HeaderString::Type::Pinned, cookie_header->value().type());
+  EXPECT_EQ(cookie, cookie_header->value().c_str());
+
+  // Modifying the value copies it.
+  headers->get(LowerCaseString("cookie"))->value(std::string("bar"));
+  EXPECT_STREQ("bar", cookie_header->value().c_str());
+  EXPECT_EQ(HeaderString::Type::Inline, cookie_header->value().type());
+}
+
+TEST_F(Http1ServerConnectionImplFastParsingTest, BadContentLength) {
+  initialize();
+
+  std::string output;
+  ON_CALL(connection_, write(_, _)).WillByDefault(AddBufferToString(&output));
+
+  NiceMock<Http::MockStreamDecoder> decoder;
+  EXPECT_CALL(callbacks_, newStream(_)).WillOnce(ReturnRef(decoder));
+
+  Buffer::OwnedImpl buffer("POST / HTTP/1.1\r\ncontent-length: abc\r\n\r\n");
+  EXPECT_THROW(codec_->dispatch(buffer), CodecProtocolException);
+  EXPECT_EQ("HTTP/1.1 400 Bad Request\r\ncontent-length: 0\r\nconnection: close\r\n\r\n", output);
+}
+
 class Http1ClientConnectionImplTest : public testing::Test {
 public:
   void initialize() { codec_.reset(new ClientConnectionImpl(connection_, callbacks_)); }
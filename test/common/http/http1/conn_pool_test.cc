@@ -479,6 +479,39 @@ TEST_F(Http1ConnPoolImplTest, MaxConnections) {
   dispatcher_.clearDeferredDeleteList();
 }
 
+/**
+ * Test that spare connections are opened ahead of demand according to the prefetch ratio.
+ */
+TEST_F(Http1ConnPoolImplTest, PrefetchRatio) {
+  InSequence s;
+  cluster_->prefetch_ratio_ = 2;
+
+  // The first request opens its own connection plus a spare one.
+  NiceMock<Http::MockStreamDecoder> outer_decoder;
+  ConnPoolCallbacks callbacks;
+  conn_pool_.expectClientCreate();
+  conn_pool_.expectClientCreate();
+  EXPECT_NE(nullptr, conn_pool_.newStream(outer_decoder, callbacks));
+  EXPECT_EQ(2U, cluster_->stats_.upstream_cx_total_.value());
+
+  // The first connection to come up serves the request and the other one stays ready.
+  NiceMock<Http::MockStreamEncoder> request_encoder;
+  Http::StreamDecoder* inner_decoder;
+  EXPECT_CALL(*conn_pool_.test_clients_[0].connect_timer_, disableTimer());
+  EXPECT_CALL(*conn_pool_.test_clients_[0].codec_, newStream(_))
+      .WillOnce(DoAll(SaveArgAddress(&inner_decoder), ReturnRef(request_encoder)));
+  EXPECT_CALL(callbacks.pool_ready_, ready());
+  conn_pool_.test_clients_[0].connection_->raiseEvent(Network::ConnectionEvent::Connected);
+  EXPECT_CALL(*conn_pool_.test_clients_[1].connect_timer_, disableTimer());
+  conn_pool_.test_clients_[1].connection_->raiseEvent(Network::ConnectionEvent::Connected);
+
+  // Cause the connections to go away.
+  EXPECT_CALL(conn_pool_, onClientDestroy()).Times(2);
+  conn_pool_.test_clients_[1].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  conn_pool_.test_clients_[0].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  dispatcher_.clearDeferredDeleteList();
+}
+
 /**
  * Test when upstream closes connection without 'connection: close' like
  * https://github.com/envoyproxy/envoy/pull/2715
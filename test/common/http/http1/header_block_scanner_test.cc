@@ -0,0 +1,104 @@
+#include <string>
+#include <vector>
+
+#include "common/http/http1/header_block_scanner.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+
+class HeaderBlockScannerTest : public testing::Test {
+public:
+  size_t scan(const std::string& data) {
+    return HeaderBlockScanner::scan(data, request_line_length_, headers_);
+  }
+
+  size_t request_line_length_{};
+  std::vector<HeaderBlockScanner::Header> headers_;
+};
+
+TEST_F(HeaderBlockScannerTest, Complete) {
+  const std::string block = "GET / HTTP/1.1\r\nHost: h\r\nx-empty:\r\nx-ws: \t v \r\n\r\n";
+  EXPECT_EQ(block.size(), scan(block + "body"));
+  EXPECT_EQ(16, request_line_length_);
+  ASSERT_EQ(3, headers_.size());
+  EXPECT_EQ("Host", headers_[0].name_);
+  EXPECT_EQ("h", headers_[0].value_);
+  EXPECT_EQ("Host: h\r\n", headers_[0].line_);
+  EXPECT_EQ("x-empty", headers_[1].name_);
+  EXPECT_EQ("", headers_[1].value_);
+  EXPECT_EQ("x-ws", headers_[2].name_);
+  // Trailing whitespace is kept, as http_parser does.
+  EXPECT_EQ("v ", headers_[2].value_);
+}
+
+TEST_F(HeaderBlockScannerTest, NoHeaders) {
+  EXPECT_EQ(18, scan("GET / HTTP/1.1\r\n\r\n"));
+  EXPECT_TRUE(headers_.empty());
+}
+
+TEST_F(HeaderBlockScannerTest, Incomplete) {
+  EXPECT_EQ(0, scan(""));
+  EXPECT_EQ(0, scan("GET / HTTP/1.1"));
+  EXPECT_EQ(0, scan("GET / HTTP/1.1\r\nhost: h\r\n"));
+  EXPECT_EQ(0, scan("GET / HTTP/1.1\r\nhost: h\r\n\r"));
+}
+
+TEST_F(HeaderBlockScannerTest, LeftToHttpParser) {
+  // Leading empty line.
+  EXPECT_EQ(0, scan("\r\nGET / HTTP/1.1\r\n\r\n"));
+  // Bare LF.
+  EXPECT_EQ(0, scan("GET / HTTP/1.1\nhost: h\r\n\r\n"));
+  EXPECT_EQ(0, scan("GET / HTTP/1.1\r\nhost: h\n\r\n"));
+  // obs-fold.
+  EXPECT_EQ(0, scan("GET / HTTP/1.1\r\nhost: h\r\n folded\r\n\r\n"));
+  // Invalid names.
+  EXPECT_EQ(0, scan("GET / HTTP/1.1\r\n: h\r\n\r\n"));
+  EXPECT_EQ(0, scan("GET / HTTP/1.1\r\nhost : h\r\n\r\n"));
+  EXPECT_EQ(0, scan("GET / HTTP/1.1\r\nho\"st: h\r\n\r\n"));
+  EXPECT_EQ(0, scan("GET / HTTP/1.1\r\nhost\r\n\r\n"));
+  // Control characters in values.
+  EXPECT_EQ(0, scan("GET / HTTP/1.1\r\nhost: a\rb\r\n\r\n"));
+  EXPECT_EQ(0, scan(std::string("GET / HTTP/1.1\r\nhost: a\0b\r\n\r\n", 28)));
+  EXPECT_EQ(0, scan("GET / HTTP/1.1\r\nhost: a\x7f\r\n\r\n"));
+}
+
+TEST_F(HeaderBlockScannerTest, LongLines) {
+  // Exercise the vector loops and their scalar tails.
+  for (size_t length : {15, 16, 17, 31, 32, 33, 100, 1000}) {
+    const std::string value(length, 'v');
+    const std::string block = "GET / HTTP/1.1\r\nx-long: " + value + "\r\nx-tab: a\tb\r\n\r\n";
+    ASSERT_EQ(block.size(), scan(block)) << length;
+    ASSERT_EQ(2, headers_.size());
+    EXPECT_EQ(value, headers_[0].value_);
+    EXPECT_EQ("a\tb", headers_[1].value_);
+
+    for (size_t i : {size_t(0), length / 2, length - 1}) {
+      std::string invalid = value;
+      invalid[i] = 0x01;
+      EXPECT_EQ(0, scan("GET / HTTP/1.1\r\nx-long: " + invalid + "\r\n\r\n")) << length << " " << i;
+      invalid[i] = '\xff';
+      EXPECT_NE(0, scan("GET / HTTP/1.1\r\nx-long: " + invalid + "\r\n\r\n")) << length << " " << i;
+    }
+  }
+}
+
+TEST(HeaderBlockScannerFindTest, FindLineFeed) {
+  for (size_t length = 0; length < 80; length++) {
+    const std::string data(length, 'a');
+    EXPECT_EQ(data.data() + length,
+              HeaderBlockScanner::findLineFeed(data.data(), data.data() + length));
+    for (size_t i = 0; i < length; i++) {
+      std::string with_lf = data;
+      with_lf[i] = '\n';
+      EXPECT_EQ(with_lf.data() + i,
+                HeaderBlockScanner::findLineFeed(with_lf.data(), with_lf.data() + length));
+    }
+  }
+}
+
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
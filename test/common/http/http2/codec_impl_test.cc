@@ -290,6 +290,36 @@ TEST_P(Http2CodecImplTest, RefusedStreamReset) {
   response_encoder_->getStream().resetStream(StreamResetReason::LocalRefusedStreamReset);
 }
 
+TEST_P(Http2CodecImplTest, BatchedFrameWrites) {
+  initialize();
+
+  // Buffer client data so that the server's writes can be counted.
+  uint32_t server_writes = 0;
+  ON_CALL(server_connection_, write(_, _))
+      .WillByDefault(Invoke([&](Buffer::Instance& data, bool) -> void {
+        server_writes++;
+        client_wrapper_.buffer_.add(data);
+      }));
+
+  TestHeaderMapImpl request_headers;
+  HttpTestUtility::addDefaultHeaders(request_headers);
+  TestHeaderMapImpl response_headers{{":status", "200"}};
+  EXPECT_CALL(request_decoder_, decodeHeaders_(_, true)).WillOnce(InvokeWithoutArgs([&]() -> void {
+    response_encoder_->encodeHeaders(response_headers, false);
+    Buffer::OwnedImpl body("hello");
+    response_encoder_->encodeData(body, true);
+  }));
+  request_encoder_->encodeHeaders(request_headers, true);
+
+  // The SETTINGS, HEADERS and DATA frames produced while dispatching go out in a single write.
+  EXPECT_EQ(1U, server_writes);
+
+  EXPECT_CALL(response_decoder_, decodeHeaders_(_, false));
+  EXPECT_CALL(response_decoder_, decodeData(_, true));
+  setupDefaultConnectionMocks();
+  client_wrapper_.dispatch(Buffer::OwnedImpl(), client_);
+}
+
 TEST_P(Http2CodecImplTest, InvalidFrame) {
   initialize();
 
@@ -361,6 +391,173 @@ TEST_P(Http2CodecImplTest, TrailingHeadersLargeBody) {
   response_encoder_->encodeTrailers(TestHeaderMapImpl{{"trailing", "header"}});
 }
 
+TEST(Http2CodecImplWriteCoalescingTest, EnableWriteCoalescing) {
+  Stats::IsolatedStoreImpl stats_store;
+  NiceMock<Network::MockConnection> connection;
+  MockServerConnectionCallbacks callbacks;
+  Http2Settings http2_settings;
+  http2_settings.max_coalesced_write_bytes_ = 16384;
+  http2_settings.max_coalesced_write_delay_ = std::chrono::milliseconds(1);
+  EXPECT_CALL(connection, setWriteCoalescing(16384, std::chrono::milliseconds(1)));
+  ServerConnectionImpl server(connection, callbacks, stats_store, http2_settings);
+}
+
+// Never indexed headers are encoded without being added to the HPACK dynamic table.
+TEST(Http2CodecImplHpackTest, NeverIndexHeaders) {
+  const std::string request_id(100, 'a');
+  auto dynamic_table_size = [&request_id](const std::vector<std::string>& never_index) -> size_t {
+    Stats::IsolatedStoreImpl stats_store;
+    NiceMock<Network::MockConnection> connection;
+    MockConnectionCallbacks callbacks;
+    MockStreamDecoder response_decoder;
+    Http2Settings http2_settings;
+    http2_settings.hpack_never_index_headers_ = never_index;
+    TestClientConnectionImpl client(connection, callbacks, stats_store, http2_settings);
+
+    TestHeaderMapImpl request_headers{{"x-request-id", request_id}};
+    HttpTestUtility::addDefaultHeaders(request_headers);
+    client.newStream(response_decoder).encodeHeaders(request_headers, true);
+    return nghttp2_session_get_hd_deflate_dynamic_table_size(client.session());
+  };
+
+  // An entry takes its name and value plus 32 octets of the table.
+  EXPECT_EQ(dynamic_table_size({}) - request_id.size() - std::string("x-request-id").size() - 32,
+            dynamic_table_size({"x-request-id"}));
+}
+
+const uint64_t MaxOutboundDataBytes = 16 * 1024;
+
+// Responses on a downstream connection with stream scheduling, whose budget the server's writes
+// count against until the test drains them.
+class Http2CodecImplStreamSchedulingTest : public testing::Test {
+public:
+  // The response to a request, as received by the client.
+  struct Response {
+    NiceMock<MockStreamDecoder> decoder_;
+    StreamEncoder* encoder_{};
+    uint64_t bytes_received_{};
+    bool complete_{};
+  };
+
+  void initialize(Http2Settings::StreamSchedulingPolicy policy,
+                  uint32_t max_outbound_data_bytes = MaxOutboundDataBytes) {
+    server_http2settings_.max_outbound_data_bytes_ = max_outbound_data_bytes;
+    server_http2settings_.stream_scheduling_policy_ = policy;
+    client_ = std::make_unique<TestClientConnectionImpl>(client_connection_, client_callbacks_,
+                                                         stats_store_, Http2Settings());
+    server_ = std::make_unique<TestServerConnectionImpl>(server_connection_, server_callbacks_,
+                                                         stats_store_, server_http2settings_);
+    ON_CALL(client_connection_, write(_, _))
+        .WillByDefault(Invoke([&](Buffer::Instance& data, bool) -> void {
+          server_wrapper_.dispatch(data, *server_);
+        }));
+    ON_CALL(server_connection_, write(_, _))
+        .WillByDefault(Invoke([&](Buffer::Instance& data, bool) -> void {
+          server_bytes_written_ += data.length();
+          client_wrapper_.dispatch(data, *client_);
+        }));
+  }
+
+  // Sends a request and the headers of its response.
+  void sendRequest(Response& response) {
+    ON_CALL(response.decoder_, decodeData(_, _))
+        .WillByDefault(Invoke([&response, this](Buffer::Instance& data, bool end_stream) -> void {
+          response.bytes_received_ += data.length();
+          if (end_stream) {
+            response.complete_ = true;
+            completion_order_.push_back(&response);
+          }
+        }));
+    EXPECT_CALL(server_callbacks_, newStream(_))
+        .WillOnce(Invoke([&](StreamEncoder& encoder) -> StreamDecoder& {
+          response.encoder_ = &encoder;
+          return request_decoder_;
+        }));
+    TestHeaderMapImpl request_headers;
+    HttpTestUtility::addDefaultHeaders(request_headers);
+    client_->newStream(response.decoder_).encodeHeaders(request_headers, true);
+    response.encoder_->encodeHeaders(TestHeaderMapImpl{{":status", "200"}}, false);
+  }
+
+  void sendBody(Response& response, uint64_t length) {
+    Buffer::OwnedImpl body(std::string(length, 'a'));
+    response.encoder_->encodeData(body, true);
+  }
+
+  // Simulates the socket taking everything the server wrote.
+  void drainServerConnection() {
+    const uint64_t bytes = server_bytes_written_;
+    server_bytes_written_ = 0;
+    server_connection_.raiseBytesSentCallbacks(bytes);
+  }
+
+  Stats::IsolatedStoreImpl stats_store_;
+  NiceMock<Network::MockConnection> client_connection_;
+  MockConnectionCallbacks client_callbacks_;
+  std::unique_ptr<TestClientConnectionImpl> client_;
+  Http2CodecImplTest::ConnectionWrapper client_wrapper_;
+  Http2Settings server_http2settings_;
+  NiceMock<Network::MockConnection> server_connection_;
+  MockServerConnectionCallbacks server_callbacks_;
+  std::unique_ptr<TestServerConnectionImpl> server_;
+  Http2CodecImplTest::ConnectionWrapper server_wrapper_;
+  NiceMock<MockStreamDecoder> request_decoder_;
+  uint64_t server_bytes_written_{};
+  std::vector<Response*> completion_order_;
+};
+
+// A response only sends more data once the connection drains below the budget, and a small
+// response does not wait behind a large one.
+TEST_F(Http2CodecImplStreamSchedulingTest, SmallestFirst) {
+  initialize(Http2Settings::StreamSchedulingPolicy::SmallestFirst);
+  Response large;
+  Response small;
+  sendRequest(large);
+  sendRequest(small);
+
+  sendBody(large, 3 * MaxOutboundDataBytes);
+  EXPECT_EQ(MaxOutboundDataBytes, large.bytes_received_);
+  sendBody(small, 1024);
+  EXPECT_EQ(0U, small.bytes_received_);
+
+  drainServerConnection();
+  EXPECT_TRUE(small.complete_);
+  EXPECT_EQ(2 * MaxOutboundDataBytes, large.bytes_received_);
+
+  drainServerConnection();
+  EXPECT_TRUE(large.complete_);
+  EXPECT_EQ(std::vector<Response*>({&small, &large}), completion_order_);
+}
+
+// Responses take turns in the order they ran out of turns, whatever their size.
+TEST_F(Http2CodecImplStreamSchedulingTest, RoundRobin) {
+  initialize(Http2Settings::StreamSchedulingPolicy::RoundRobin);
+  Response first;
+  Response second;
+  sendRequest(first);
+  sendRequest(second);
+
+  sendBody(first, 2 * MaxOutboundDataBytes);
+  sendBody(second, 1024);
+  EXPECT_EQ(MaxOutboundDataBytes, first.bytes_received_);
+  EXPECT_EQ(0U, second.bytes_received_);
+
+  // The first response ran out of its turn before the second got data, so it goes first again.
+  drainServerConnection();
+  EXPECT_EQ(std::vector<Response*>({&first}), completion_order_);
+  drainServerConnection();
+  EXPECT_EQ(std::vector<Response*>({&first, &second}), completion_order_);
+}
+
+// Without a budget, responses are sent as soon as flow control allows.
+TEST_F(Http2CodecImplStreamSchedulingTest, Disabled) {
+  initialize(Http2Settings::StreamSchedulingPolicy::Weighted, 0);
+  Response response;
+  sendRequest(response);
+  sendBody(response, 3 * MaxOutboundDataBytes);
+  EXPECT_TRUE(response.complete_);
+}
+
 class Http2CodecImplDeferredResetTest : public Http2CodecImplTest {};
 
 TEST_P(Http2CodecImplDeferredResetTest, DeferredResetClient) {
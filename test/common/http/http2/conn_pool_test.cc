@@ -88,10 +88,7 @@ public:
         Upstream::makeTestHost(cluster, "tcp://127.0.0.1:9000"), *test_client.client_dispatcher_);
     EXPECT_CALL(dispatcher_, createClientConnection_(_, _, _, _))
         .WillOnce(Return(test_client.connection_));
-    EXPECT_CALL(pool_, createCodecClient_(_))
-        .WillOnce(Invoke([this](Upstream::Host::CreateConnectionData&) -> CodecClient* {
-          return test_clients_.back().codec_client_;
-        }));
+    EXPECT_CALL(pool_, createCodecClient_(_)).WillOnce(Return(test_client.codec_client_));
     EXPECT_CALL(*test_client.connect_timer_, enableTimer(_));
   }
 
@@ -148,14 +145,15 @@ TEST_F(Http2ConnPoolImplTest, DrainConnections) {
   r2.callbacks_.outer_encoder_->encodeHeaders(HeaderMapImpl{}, true);
   expectClientConnect(1);
 
-  // This will move primary to draining and destroy draining.
+  // This will move the ready client to draining alongside the already draining one.
   pool_.drainConnections();
-  EXPECT_CALL(*this, onClientDestroy());
+  EXPECT_CALL(*this, onClientDestroy()).Times(0);
   dispatcher_.clearDeferredDeleteList();
 
-  // This will destroy draining.
+  // This will destroy both draining clients.
   test_clients_[1].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
-  EXPECT_CALL(*this, onClientDestroy());
+  test_clients_[0].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  EXPECT_CALL(*this, onClientDestroy()).Times(2);
   dispatcher_.clearDeferredDeleteList();
 }
 
@@ -370,6 +368,116 @@ TEST_F(Http2ConnPoolImplTest, DrainPrimaryNoActiveRequest) {
   dispatcher_.clearDeferredDeleteList();
 }
 
+/**
+ * Verify that another connection is opened once every ready connection has reached the max
+ * concurrent streams per connection, and that new streams go to the least loaded connection.
+ */
+TEST_F(Http2ConnPoolImplTest, MaxConcurrentStreamsPerConnection) {
+  InSequence s;
+  cluster_->max_concurrent_streams_per_connection_ = 2;
+
+  expectClientCreate();
+  ActiveTestRequest r1(*this, 0);
+  EXPECT_CALL(r1.inner_encoder_, encodeHeaders(_, true));
+  r1.callbacks_.outer_encoder_->encodeHeaders(HeaderMapImpl{}, true);
+  expectClientConnect(0);
+  ActiveTestRequest r2(*this, 0);
+  EXPECT_CALL(r2.inner_encoder_, encodeHeaders(_, true));
+  r2.callbacks_.outer_encoder_->encodeHeaders(HeaderMapImpl{}, true);
+
+  // The first connection is full so a second one is opened.
+  expectClientCreate();
+  ActiveTestRequest r3(*this, 1);
+  EXPECT_CALL(r3.inner_encoder_, encodeHeaders(_, true));
+  r3.callbacks_.outer_encoder_->encodeHeaders(HeaderMapImpl{}, true);
+  expectClientConnect(1);
+
+  // The second connection still has room and fewer active streams.
+  ActiveTestRequest r4(*this, 1);
+  EXPECT_CALL(r4.inner_encoder_, encodeHeaders(_, true));
+  r4.callbacks_.outer_encoder_->encodeHeaders(HeaderMapImpl{}, true);
+
+  // Once a stream on the first connection completes it is the least loaded again.
+  EXPECT_CALL(r1.decoder_, decodeHeaders_(_, true));
+  r1.inner_decoder_->decodeHeaders(HeaderMapPtr{new HeaderMapImpl{}}, true);
+  ActiveTestRequest r5(*this, 0);
+  EXPECT_CALL(r5.inner_encoder_, encodeHeaders(_, true));
+  r5.callbacks_.outer_encoder_->encodeHeaders(HeaderMapImpl{}, true);
+
+  EXPECT_EQ(2U, cluster_->stats_.upstream_cx_total_.value());
+  EXPECT_EQ(4U, cluster_->stats_.upstream_rq_active_.value());
+
+  test_clients_[0].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  test_clients_[1].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  EXPECT_CALL(*this, onClientDestroy()).Times(2);
+  dispatcher_.clearDeferredDeleteList();
+}
+
+/**
+ * Verify that draining moves every ready connection to draining and that the drained callback
+ * fires once the last of them closes.
+ */
+TEST_F(Http2ConnPoolImplTest, DrainMultipleReadyConnections) {
+  InSequence s;
+  cluster_->max_concurrent_streams_per_connection_ = 1;
+
+  expectClientCreate();
+  ActiveTestRequest r1(*this, 0);
+  EXPECT_CALL(r1.inner_encoder_, encodeHeaders(_, true));
+  r1.callbacks_.outer_encoder_->encodeHeaders(HeaderMapImpl{}, true);
+  expectClientConnect(0);
+
+  expectClientCreate();
+  ActiveTestRequest r2(*this, 1);
+  EXPECT_CALL(r2.inner_encoder_, encodeHeaders(_, true));
+  r2.callbacks_.outer_encoder_->encodeHeaders(HeaderMapImpl{}, true);
+  expectClientConnect(1);
+
+  pool_.drainConnections();
+  ReadyWatcher drained;
+  pool_.addDrainedCallback([&]() -> void { drained.ready(); });
+
+  EXPECT_CALL(dispatcher_, deferredDelete_(_));
+  EXPECT_CALL(r1.decoder_, decodeHeaders_(_, true));
+  r1.inner_decoder_->decodeHeaders(HeaderMapPtr{new HeaderMapImpl{}}, true);
+
+  EXPECT_CALL(dispatcher_, deferredDelete_(_));
+  EXPECT_CALL(drained, ready());
+  EXPECT_CALL(r2.decoder_, decodeHeaders_(_, true));
+  r2.inner_decoder_->decodeHeaders(HeaderMapPtr{new HeaderMapImpl{}}, true);
+
+  EXPECT_CALL(*this, onClientDestroy()).Times(2);
+  dispatcher_.clearDeferredDeleteList();
+}
+
+/**
+ * Verify that prefetching opens the minimum number of connections ahead of the first stream.
+ */
+TEST_F(Http2ConnPoolImplTest, PrefetchMinConnections) {
+  InSequence s;
+  cluster_->prefetch_min_connections_ = 2;
+
+  expectClientCreate();
+  expectClientCreate();
+  pool_.prefetch();
+  expectClientConnect(0);
+  expectClientConnect(1);
+
+  // Streams are spread over the warm connections without opening another one.
+  ActiveTestRequest r1(*this, 0);
+  EXPECT_CALL(r1.inner_encoder_, encodeHeaders(_, true));
+  r1.callbacks_.outer_encoder_->encodeHeaders(HeaderMapImpl{}, true);
+  ActiveTestRequest r2(*this, 1);
+  EXPECT_CALL(r2.inner_encoder_, encodeHeaders(_, true));
+  r2.callbacks_.outer_encoder_->encodeHeaders(HeaderMapImpl{}, true);
+  EXPECT_EQ(2U, cluster_->stats_.upstream_cx_total_.value());
+
+  test_clients_[0].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  test_clients_[1].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  EXPECT_CALL(*this, onClientDestroy()).Times(2);
+  dispatcher_.clearDeferredDeleteList();
+}
+
 TEST_F(Http2ConnPoolImplTest, ConnectTimeout) {
   InSequence s;
 
@@ -442,8 +550,8 @@ TEST_F(Http2ConnPoolImplTest, GoAway) {
   EXPECT_CALL(r2.decoder_, decodeHeaders_(_, true));
   r2.inner_decoder_->decodeHeaders(HeaderMapPtr{new HeaderMapImpl{}}, true);
 
+  // The first client was closed as soon as it received the GOAWAY since it was idle.
   test_clients_[1].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
-  test_clients_[0].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
   EXPECT_CALL(*this, onClientDestroy()).Times(2);
   dispatcher_.clearDeferredDeleteList();
 
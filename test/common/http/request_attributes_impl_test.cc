@@ -0,0 +1,50 @@
+#include "common/http/request_attributes_impl.h"
+
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Http {
+
+TEST(RequestAttributesImplTest, PathWithoutQuery) {
+  RequestAttributesImpl attributes;
+  EXPECT_EQ("", attributes.pathWithoutQuery(TestHeaderMapImpl{}));
+  EXPECT_EQ("/foo", attributes.pathWithoutQuery(TestHeaderMapImpl{{":path", "/foo"}}));
+  EXPECT_EQ("/foo", attributes.pathWithoutQuery(TestHeaderMapImpl{{":path", "/foo?a=b"}}));
+}
+
+TEST(RequestAttributesImplTest, QueryParams) {
+  RequestAttributesImpl attributes;
+  TestHeaderMapImpl headers{{":path", "/foo?a=1&b"}};
+  const Utility::QueryParams expected{{"a", "1"}, {"b", ""}};
+  EXPECT_EQ(expected, attributes.queryParams(headers));
+  // The parsed parameters are reused while the path does not change.
+  EXPECT_EQ(&attributes.queryParams(headers), &attributes.queryParams(headers));
+
+  headers.Path()->value(std::string("/foo?c=2"));
+  EXPECT_EQ((Utility::QueryParams{{"c", "2"}}), attributes.queryParams(headers));
+  headers.removePath();
+  EXPECT_TRUE(attributes.queryParams(headers).empty());
+}
+
+TEST(RequestAttributesImplTest, CookieValue) {
+  RequestAttributesImpl attributes;
+  TestHeaderMapImpl headers{{"cookie", "a=1; b=2"}, {"cookie", "a=3"}};
+  EXPECT_EQ("3", attributes.cookieValue(headers, "a"));
+  EXPECT_EQ("2", attributes.cookieValue(headers, "b"));
+  EXPECT_EQ("", attributes.cookieValue(headers, "c"));
+
+  // The cookies are parsed again when a cookie header is added, changed or removed.
+  headers.addCopy("cookie", "c=4");
+  EXPECT_EQ("4", attributes.cookieValue(headers, "c"));
+  headers.remove(LowerCaseString("cookie"));
+  headers.addCopy("cookie", "a=5");
+  EXPECT_EQ("5", attributes.cookieValue(headers, "a"));
+  EXPECT_EQ("", attributes.cookieValue(headers, "c"));
+  headers.remove(LowerCaseString("cookie"));
+  EXPECT_EQ("", attributes.cookieValue(headers, "a"));
+}
+
+} // namespace Http
+} // namespace Envoy
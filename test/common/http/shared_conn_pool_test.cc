@@ -0,0 +1,235 @@
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <vector>
+
+#include "common/http/shared_conn_pool.h"
+
+#include "test/common/http/common.h"
+#include "test/mocks/buffer/mocks.h"
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/upstream/mocks.h"
+#include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+
+namespace Envoy {
+namespace Http {
+
+class SharedConnPoolTest : public testing::Test {
+public:
+  SharedConnPoolTest() {
+    ON_CALL(owner_dispatcher_, post(_)).WillByDefault(Invoke([this](Event::PostCb cb) -> void {
+      owner_posted_.push_back(cb);
+    }));
+    ON_CALL(worker_dispatcher_, post(_)).WillByDefault(Invoke([this](Event::PostCb cb) -> void {
+      worker_posted_.push_back(cb);
+    }));
+
+    owner_pool_ =
+        registry_->pool(host_, key_, owner_dispatcher_, [this]() { return createPool(); });
+    worker_pool_ =
+        registry_->pool(host_, key_, worker_dispatcher_, [this]() { return createPool(); });
+    EXPECT_EQ(1U, pools_created_);
+  }
+
+  ConnectionPool::InstancePtr createPool() {
+    pool_ = new NiceMock<ConnectionPool::MockInstance>();
+    ON_CALL(*pool_, protocol()).WillByDefault(Return(Protocol::Http2));
+    pools_created_++;
+    return ConnectionPool::InstancePtr{pool_};
+  }
+
+  static void runPosted(std::list<Event::PostCb>& posted) {
+    while (!posted.empty()) {
+      Event::PostCb cb = posted.front();
+      posted.pop_front();
+      cb();
+    }
+  }
+
+  // Starts a stream on the worker pool and hands it to the owner's pool.
+  void startStream() {
+    EXPECT_NE(nullptr, worker_pool_->newStream(decoder_, callbacks_));
+    EXPECT_CALL(*pool_, newStream(_, _))
+        .WillOnce(Invoke([this](StreamDecoder& decoder, ConnectionPool::Callbacks& callbacks)
+                             -> ConnectionPool::Cancellable* {
+          owner_decoder_ = &decoder;
+          owner_callbacks_ = &callbacks;
+          return &cancellable_;
+        }));
+    runPosted(owner_posted_);
+  }
+
+  // Makes the stream ready on the owner and delivers the ready event to the worker.
+  void readyStream() {
+    startStream();
+    ON_CALL(encoder_.stream_, bufferLimit()).WillByDefault(Return(1024));
+    owner_callbacks_->onPoolReady(encoder_, pool_->host_);
+    EXPECT_CALL(callbacks_.pool_ready_, ready());
+    runPosted(worker_posted_);
+    EXPECT_EQ(1024U, callbacks_.outer_encoder_->getStream().bufferLimit());
+  }
+
+  std::shared_ptr<SharedConnPoolRegistry> registry_{std::make_shared<SharedConnPoolRegistry>()};
+  NiceMock<Upstream::MockHostDescription> host_;
+  const std::vector<uint8_t> key_{uint8_t(Protocol::Http2), 0};
+  NiceMock<Event::MockDispatcher> owner_dispatcher_;
+  NiceMock<Event::MockDispatcher> worker_dispatcher_;
+  std::list<Event::PostCb> owner_posted_;
+  std::list<Event::PostCb> worker_posted_;
+  NiceMock<ConnectionPool::MockInstance>* pool_{};
+  uint32_t pools_created_{};
+  ConnectionPool::InstancePtr owner_pool_;
+  ConnectionPool::InstancePtr worker_pool_;
+
+  NiceMock<MockStreamDecoder> decoder_;
+  ConnPoolCallbacks callbacks_;
+  StreamDecoder* owner_decoder_{};
+  ConnectionPool::Callbacks* owner_callbacks_{};
+  ConnectionPool::MockCancellable cancellable_;
+  NiceMock<MockStreamEncoder> encoder_;
+  ReadyWatcher drained_;
+};
+
+/**
+ * Test that the owner's pool is the real pool and other workers get a proxy to it.
+ */
+TEST_F(SharedConnPoolTest, OwnerUsesPoolDirectly) {
+  EXPECT_EQ(Protocol::Http2, worker_pool_->protocol());
+
+  EXPECT_CALL(*pool_, newStream(_, _)).WillOnce(Return(&cancellable_));
+  EXPECT_EQ(&cancellable_, owner_pool_->newStream(decoder_, callbacks_));
+  EXPECT_TRUE(owner_posted_.empty());
+}
+
+/**
+ * Test a complete request and response on a stream started on another worker.
+ */
+TEST_F(SharedConnPoolTest, StreamOnOtherWorker) {
+  readyStream();
+
+  TestHeaderMapImpl request{{":method", "GET"}, {":path", "/"}};
+  callbacks_.outer_encoder_->encodeHeaders(request, true);
+  EXPECT_CALL(encoder_, encodeHeaders(HeaderMapEqualRef(&request), true));
+  runPosted(owner_posted_);
+
+  worker_pool_->addDrainedCallback([&]() -> void { drained_.ready(); });
+
+  owner_decoder_->decodeHeaders(HeaderMapPtr{new TestHeaderMapImpl{{":status", "200"}}}, false);
+  Buffer::OwnedImpl body("hello");
+  owner_decoder_->decodeData(body, true);
+  EXPECT_EQ(0U, body.length());
+
+  EXPECT_CALL(decoder_, decodeHeaders_(_, false));
+  EXPECT_CALL(decoder_, decodeData(BufferStringEqual("hello"), true));
+  EXPECT_CALL(drained_, ready());
+  runPosted(worker_posted_);
+}
+
+/**
+ * Test that a reset of the owner's stream is delivered to the worker.
+ */
+TEST_F(SharedConnPoolTest, RemoteReset) {
+  readyStream();
+
+  NiceMock<MockStreamCallbacks> stream_callbacks;
+  callbacks_.outer_encoder_->getStream().addCallbacks(stream_callbacks);
+  encoder_.stream_.resetStream(StreamResetReason::RemoteReset);
+
+  worker_pool_->addDrainedCallback([&]() -> void { drained_.ready(); });
+  EXPECT_CALL(stream_callbacks, onResetStream(StreamResetReason::RemoteReset));
+  EXPECT_CALL(drained_, ready());
+  runPosted(worker_posted_);
+}
+
+/**
+ * Test that a reset on the worker resets the owner's stream.
+ */
+TEST_F(SharedConnPoolTest, LocalReset) {
+  readyStream();
+
+  NiceMock<MockStreamCallbacks> stream_callbacks;
+  callbacks_.outer_encoder_->getStream().addCallbacks(stream_callbacks);
+  worker_pool_->addDrainedCallback([&]() -> void { drained_.ready(); });
+  EXPECT_CALL(stream_callbacks, onResetStream(StreamResetReason::LocalReset));
+  EXPECT_CALL(drained_, ready());
+  callbacks_.outer_encoder_->getStream().resetStream(StreamResetReason::LocalReset);
+
+  EXPECT_CALL(encoder_.stream_, resetStream(StreamResetReason::LocalReset));
+  runPosted(owner_posted_);
+
+  // The reset raised by the owner's stream is not delivered again.
+  runPosted(worker_posted_);
+}
+
+/**
+ * Test cancelling a stream before the owner's pool has a connection for it.
+ */
+TEST_F(SharedConnPoolTest, CancelPending) {
+  EXPECT_CALL(*pool_, newStream(_, _)).WillOnce(Return(&cancellable_));
+  ConnectionPool::Cancellable* handle = worker_pool_->newStream(decoder_, callbacks_);
+  runPosted(owner_posted_);
+
+  worker_pool_->addDrainedCallback([&]() -> void { drained_.ready(); });
+  EXPECT_CALL(drained_, ready());
+  handle->cancel();
+
+  EXPECT_CALL(cancellable_, cancel());
+  runPosted(owner_posted_);
+}
+
+/**
+ * Test that streams handed to a draining owner fail.
+ */
+TEST_F(SharedConnPoolTest, OwnerDraining) {
+  EXPECT_CALL(*pool_, addDrainedCallback(_));
+  owner_pool_->addDrainedCallback([]() -> void {});
+
+  EXPECT_CALL(*pool_, newStream(_, _)).Times(0);
+  worker_pool_->newStream(decoder_, callbacks_);
+  runPosted(owner_posted_);
+
+  EXPECT_CALL(callbacks_.pool_failure_, ready());
+  runPosted(worker_posted_);
+}
+
+/**
+ * Test that a new owner is chosen once the previous one destroyed its pool.
+ */
+TEST_F(SharedConnPoolTest, NewOwnerAfterOwnerDestroyed) {
+  owner_pool_.reset();
+
+  worker_pool_->newStream(decoder_, callbacks_);
+  runPosted(owner_posted_);
+  EXPECT_CALL(callbacks_.pool_failure_, ready());
+  runPosted(worker_posted_);
+
+  ConnectionPool::InstancePtr new_owner_pool =
+      registry_->pool(host_, key_, worker_dispatcher_, [this]() { return createPool(); });
+  EXPECT_EQ(2U, pools_created_);
+  EXPECT_CALL(*pool_, newStream(_, _)).WillOnce(Return(&cancellable_));
+  EXPECT_EQ(&cancellable_, new_owner_pool->newStream(decoder_, callbacks_));
+}
+
+/**
+ * Test that destroying the worker pool cancels its streams on the owner.
+ */
+TEST_F(SharedConnPoolTest, DestroyWorkerPoolWithPendingStream) {
+  startStream();
+  worker_pool_.reset();
+
+  EXPECT_CALL(cancellable_, cancel());
+  runPosted(owner_posted_);
+}
+
+} // namespace Http
+} // namespace Envoy
@@ -245,6 +245,22 @@ TEST(HttpUtility, parseHttp2Settings) {
   }
 }
 
+TEST(HttpUtility, parseHttp2StreamScheduling) {
+  envoy::api::v2::core::Http2ProtocolOptions http2_protocol_options;
+  Http2Settings http2_settings = Utility::parseHttp2Settings(http2_protocol_options);
+  EXPECT_EQ(0U, http2_settings.max_outbound_data_bytes_);
+  EXPECT_EQ(Http2Settings::StreamSchedulingPolicy::Weighted,
+            http2_settings.stream_scheduling_policy_);
+
+  http2_protocol_options.mutable_max_outbound_data_bytes()->set_value(65536);
+  http2_protocol_options.set_stream_scheduling_policy(
+      envoy::api::v2::core::Http2ProtocolOptions::SMALLEST_FIRST);
+  http2_settings = Utility::parseHttp2Settings(http2_protocol_options);
+  EXPECT_EQ(65536U, http2_settings.max_outbound_data_bytes_);
+  EXPECT_EQ(Http2Settings::StreamSchedulingPolicy::SmallestFirst,
+            http2_settings.stream_scheduling_policy_);
+}
+
 TEST(HttpUtility, getLastAddressFromXFF) {
   {
     const std::string first_address = "192.0.2.10";
@@ -373,6 +389,23 @@ TEST(HttpUtility, TestParseCookieWithQuotes) {
   EXPECT_EQ(Utility::parseCookieValue(headers, "leadingdquote"), "\"foobar");
 }
 
+// Validate that every cookie gets the value parseCookieValue() would return for it.
+TEST(HttpUtility, TestParseCookies) {
+  TestHeaderMapImpl headers{{"someheader", "10.0.0.1"},
+                            {"cookie", "a=1; b=\"2\"; a=3; malformed"},
+                            {"cookie", "c=4"},
+                            {"cookie", "b=5; d="}};
+
+  const std::unordered_map<std::string, std::string> cookies = Utility::parseCookies(headers);
+  EXPECT_EQ(4U, cookies.size());
+  for (const std::string name : {"a", "b", "c", "d"}) {
+    EXPECT_EQ(Utility::parseCookieValue(headers, name), cookies.at(name)) << name;
+  }
+  EXPECT_EQ("1", cookies.at("a"));
+  EXPECT_EQ("5", cookies.at("b"));
+  EXPECT_TRUE(Utility::parseCookies(TestHeaderMapImpl{}).empty());
+}
+
 TEST(HttpUtility, TestHasSetCookie) {
   TestHeaderMapImpl headers{{"someheader", "10.0.0.1"},
                             {"set-cookie", "somekey=somevalue"},
@@ -460,6 +493,25 @@ TEST(HttpUtility, SendLocalReplyHeadRequest) {
   Utility::sendLocalReply(false, callbacks, is_reset, Http::Code::PayloadTooLarge, "large", true);
 }
 
+// The body of a local reply may be added to the response by the caller instead of copied.
+TEST(HttpUtility, SendLocalReplyAddBody) {
+  bool is_reset = false;
+  std::string body;
+  Utility::sendLocalReply(
+      false,
+      [&](HeaderMapPtr&& headers, bool end_stream) -> void {
+        EXPECT_STREQ("5", headers->ContentLength()->value().c_str());
+        EXPECT_FALSE(end_stream);
+      },
+      [&](Buffer::Instance& data, bool end_stream) -> void {
+        body = data.toString();
+        EXPECT_TRUE(end_stream);
+      },
+      is_reset, Http::Code::Forbidden, "large",
+      [](Buffer::Instance& buffer) -> void { buffer.add("added"); }, false);
+  EXPECT_EQ("added", body);
+}
+
 TEST(HttpUtility, TestExtractHostPathFromUri) {
   absl::string_view host, path;
 
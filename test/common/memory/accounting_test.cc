@@ -0,0 +1,86 @@
+#include <cstring>
+#include <memory>
+#include <thread>
+
+#include "common/memory/accounting.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Memory {
+namespace {
+
+class Host : public Accounted<Tag::Hosts> {
+public:
+  virtual ~Host() {}
+
+  char data_[100];
+};
+
+class LargeHost : public Host {
+public:
+  char more_data_[1000];
+};
+
+TEST(AccountingTest, Names) {
+  EXPECT_EQ("buffers", Accounting::name(Tag::Buffers));
+  EXPECT_EQ("http2_sessions", Accounting::name(Tag::Http2Sessions));
+  EXPECT_EQ("hosts", Accounting::name(Tag::Hosts));
+  EXPECT_EQ("route_tables", Accounting::name(Tag::RouteTables));
+  EXPECT_EQ("stats", Accounting::name(Tag::Stats));
+}
+
+TEST(AccountingTest, AllocatedAndFreed) {
+  const uint64_t start = Accounting::bytes(Tag::Stats);
+  Accounting::allocated(Tag::Stats, 1000);
+  EXPECT_EQ(start + 1000, Accounting::bytes(Tag::Stats));
+  Accounting::freed(Tag::Stats, 1000);
+  EXPECT_EQ(start, Accounting::bytes(Tag::Stats));
+}
+
+// The counts of a thread are kept once it exits, and frees are matched with the allocations of
+// other threads.
+TEST(AccountingTest, Threads) {
+  const uint64_t start = Accounting::bytes(Tag::RouteTables);
+  std::thread thread([]() -> void { Accounting::allocated(Tag::RouteTables, 500); });
+  thread.join();
+  EXPECT_EQ(start + 500, Accounting::bytes(Tag::RouteTables));
+  Accounting::freed(Tag::RouteTables, 500);
+  EXPECT_EQ(start, Accounting::bytes(Tag::RouteTables));
+}
+
+TEST(AccountingTest, Malloc) {
+  const uint64_t start = Accounting::bytes(Tag::Buffers);
+  EXPECT_EQ(nullptr, Accounting::realloc(Tag::Buffers, nullptr, SIZE_MAX));
+  Accounting::free(Tag::Buffers, nullptr);
+
+  void* memory = Accounting::malloc(Tag::Buffers, 100);
+  EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(memory) % alignof(std::max_align_t));
+  memset(memory, 1, 100);
+  EXPECT_EQ(start + 100, Accounting::bytes(Tag::Buffers));
+
+  memory = Accounting::realloc(Tag::Buffers, memory, 4000);
+  EXPECT_EQ(1, static_cast<char*>(memory)[99]);
+  EXPECT_EQ(start + 4000, Accounting::bytes(Tag::Buffers));
+
+  Accounting::free(Tag::Buffers, memory);
+  EXPECT_EQ(start, Accounting::bytes(Tag::Buffers));
+}
+
+TEST(AccountingTest, Accounted) {
+  const uint64_t start = Accounting::bytes(Tag::Hosts);
+  auto host = std::make_unique<Host>();
+  EXPECT_EQ(start + sizeof(Host), Accounting::bytes(Tag::Hosts));
+  std::unique_ptr<Host> large_host = std::make_unique<LargeHost>();
+  EXPECT_EQ(start + sizeof(Host) + sizeof(LargeHost), Accounting::bytes(Tag::Hosts));
+
+  // Instances destroyed through a base class free the size of the derived class.
+  large_host.reset();
+  EXPECT_EQ(start + sizeof(Host), Accounting::bytes(Tag::Hosts));
+  host.reset();
+  EXPECT_EQ(start, Accounting::bytes(Tag::Hosts));
+}
+
+} // namespace
+} // namespace Memory
+} // namespace Envoy
@@ -0,0 +1,75 @@
+#include <cstdint>
+#include <cstring>
+
+#include "common/memory/huge_page_arena.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Memory {
+namespace {
+
+// The arena is process wide and cannot be disabled, so the tests run in one test, in order.
+TEST(HugePageArenaTest, All) {
+  // Until the arena is enabled, blocks come from the heap.
+  EXPECT_FALSE(HugePageArena::enabled());
+  void* heap_block = HugePageArena::allocate(100);
+  void* large_heap_block = HugePageArena::allocate(3 * HugePageArena::ChunkSize);
+  EXPECT_EQ(0U, HugePageArena::bytesMapped());
+  EXPECT_EQ(0U, HugePageArena::bytesAllocated());
+
+  // Enabling the arena maps the prefaulted chunks, rounded up to whole chunks.
+  HugePageArena::enable(HugePageArena::ChunkSize + 1);
+  EXPECT_TRUE(HugePageArena::enabled());
+  EXPECT_EQ(2 * HugePageArena::ChunkSize, HugePageArena::bytesMapped());
+  EXPECT_LE(HugePageArena::bytesMappedHugeTlb(), HugePageArena::bytesMapped());
+  EXPECT_EQ(0U, HugePageArena::bytesAllocated());
+
+  // Blocks allocated from the heap before go back to the heap.
+  HugePageArena::deallocate(heap_block, 100);
+  HugePageArena::deallocate(large_heap_block, 3 * HugePageArena::ChunkSize);
+  EXPECT_EQ(0U, HugePageArena::bytesAllocated());
+
+  // Small blocks are rounded up to a power of two and aligned to it.
+  void* small_block = HugePageArena::allocate(100);
+  EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(small_block) % 128);
+  EXPECT_EQ(128U, HugePageArena::bytesAllocated());
+  void* page_block = HugePageArena::allocate(4000);
+  EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(page_block) % 4096);
+  EXPECT_EQ(128U + 4096U, HugePageArena::bytesAllocated());
+  memset(small_block, 1, 100);
+  memset(page_block, 1, 4000);
+  // They are carved out of the prefaulted chunks.
+  EXPECT_EQ(2 * HugePageArena::ChunkSize, HugePageArena::bytesMapped());
+
+  // Freed blocks are reused by blocks of the same size.
+  HugePageArena::deallocate(small_block, 100);
+  EXPECT_EQ(4096U, HugePageArena::bytesAllocated());
+  EXPECT_EQ(small_block, HugePageArena::allocate(120));
+  HugePageArena::deallocate(small_block, 120);
+  HugePageArena::deallocate(page_block, 4000);
+  EXPECT_EQ(0U, HugePageArena::bytesAllocated());
+
+  // Large blocks get chunks of their own, which are unmapped when they are freed.
+  const uint64_t large_size = 2 * HugePageArena::ChunkSize + 1;
+  void* large_block = HugePageArena::allocate(large_size);
+  EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(large_block) % HugePageArena::ChunkSize);
+  EXPECT_EQ(3 * HugePageArena::ChunkSize, HugePageArena::bytesAllocated());
+  EXPECT_EQ(5 * HugePageArena::ChunkSize, HugePageArena::bytesMapped());
+  memset(large_block, 1, large_size);
+  HugePageArena::deallocate(large_block, large_size);
+  EXPECT_EQ(0U, HugePageArena::bytesAllocated());
+  EXPECT_EQ(2 * HugePageArena::ChunkSize, HugePageArena::bytesMapped());
+
+  // Containers allocate from the arena through HugePageAllocator.
+  {
+    HugePageVector<uint32_t> table(1000, 7);
+    EXPECT_EQ(4096U, HugePageArena::bytesAllocated());
+    EXPECT_EQ(7U, table[999]);
+  }
+  EXPECT_EQ(0U, HugePageArena::bytesAllocated());
+}
+
+} // namespace
+} // namespace Memory
+} // namespace Envoy
@@ -0,0 +1,74 @@
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#include "common/memory/recycler.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Memory {
+namespace {
+
+// Each test uses its own type, so that it starts with an empty free list.
+template <int Id> class Recycled : public Recyclable<Recycled<Id>, 2> {
+public:
+  virtual ~Recycled() {}
+
+  uint64_t value_[4]{};
+};
+
+template <int Id> class LargerRecycled : public Recycled<Id> {
+public:
+  uint64_t more_[4]{};
+};
+
+TEST(RecyclableTest, ReusesFreedBlocks) {
+  typedef Recycled<0> Object;
+  std::unique_ptr<Object> first = std::make_unique<Object>();
+  Object* const first_address = first.get();
+  first->value_[0] = 1;
+  first.reset();
+  EXPECT_EQ(1U, Object::threadFreeBlocks());
+
+  std::unique_ptr<Object> second = std::make_unique<Object>();
+  EXPECT_EQ(first_address, second.get());
+  EXPECT_EQ(0U, Object::threadFreeBlocks());
+  // The constructor runs as usual on a recycled block.
+  EXPECT_EQ(0U, second->value_[0]);
+}
+
+TEST(RecyclableTest, FreeListIsBounded) {
+  typedef Recycled<1> Object;
+  std::unique_ptr<Object> objects[3];
+  for (auto& object : objects) {
+    object = std::make_unique<Object>();
+  }
+  for (auto& object : objects) {
+    object.reset();
+  }
+  EXPECT_EQ(2U, Object::threadFreeBlocks());
+}
+
+TEST(RecyclableTest, LargerSubclassesUseTheHeap) {
+  typedef Recycled<2> Object;
+  std::unique_ptr<Object> object = std::make_unique<LargerRecycled<2>>();
+  object.reset();
+  EXPECT_EQ(0U, Object::threadFreeBlocks());
+}
+
+TEST(RecyclableTest, FreeListsArePerThread) {
+  typedef Recycled<3> Object;
+  std::unique_ptr<Object> object = std::make_unique<Object>();
+  std::thread thread([&object]() -> void {
+    object.reset();
+    EXPECT_EQ(1U, Object::threadFreeBlocks());
+  });
+  thread.join();
+  // The block stayed with the thread that destroyed the object, and was freed when it exited.
+  EXPECT_EQ(0U, Object::threadFreeBlocks());
+}
+
+} // namespace
+} // namespace Memory
+} // namespace Envoy
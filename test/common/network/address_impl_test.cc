@@ -7,6 +7,8 @@
 
 #include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "envoy/common/exception.h"
 
@@ -367,6 +369,40 @@ TEST(AddressFromSockAddr, IPv6) {
             addressFromSockAddr(ss, sizeof(sockaddr_in6), true)->asString());
 }
 
+// The friendly names are formatted on first use, whichever accessor comes first and from however
+// many threads.
+TEST(AddressFromSockAddr, FriendlyNamesFormattedOnFirstUse) {
+  sockaddr_storage ss;
+  auto& sin = reinterpret_cast<sockaddr_in&>(ss);
+  sin.sin_family = AF_INET;
+  EXPECT_EQ(1, inet_pton(AF_INET, "1.2.3.4", &sin.sin_addr));
+  sin.sin_port = htons(6502);
+
+  InstanceConstSharedPtr address = addressFromSockAddr(ss, sizeof(sockaddr_in));
+  EXPECT_EQ("1.2.3.4", address->ip()->addressAsString());
+  EXPECT_EQ("1.2.3.4:6502", address->asString());
+  EXPECT_EQ("1.2.3.4:6502", address->logicalName());
+
+  auto& sin6 = reinterpret_cast<sockaddr_in6&>(ss);
+  sin6.sin6_family = AF_INET6;
+  EXPECT_EQ(1, inet_pton(AF_INET6, "1::2", &sin6.sin6_addr));
+  sin6.sin6_port = htons(32000);
+  address = addressFromSockAddr(ss, sizeof(sockaddr_in6));
+
+  std::vector<std::thread> threads;
+  std::vector<std::string> names(4);
+  for (std::string& name : names) {
+    threads.emplace_back([&address, &name]() { name = address->asString(); });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  for (const std::string& name : names) {
+    EXPECT_EQ("[1::2]:32000", name);
+  }
+  EXPECT_EQ("1::2", address->ip()->addressAsString());
+}
+
 TEST(AddressFromSockAddr, Pipe) {
   sockaddr_storage ss;
   auto& sun = reinterpret_cast<sockaddr_un&>(ss);
@@ -0,0 +1,69 @@
+#include "common/network/connection_balancer_impl.h"
+
+#include "test/mocks/network/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::Return;
+
+namespace Envoy {
+namespace Network {
+
+TEST(NopConnectionBalancerImplTest, PicksCurrentHandler) {
+  NopConnectionBalancerImpl balancer;
+  NiceMock<MockBalancedConnectionHandler> handler1;
+  NiceMock<MockBalancedConnectionHandler> handler2;
+  balancer.registerHandler(handler1);
+  balancer.registerHandler(handler2);
+
+  EXPECT_CALL(handler2, incNumConnections()).Times(0);
+  EXPECT_EQ(&handler1, &balancer.pickTargetHandler(handler1));
+}
+
+TEST(ExactConnectionBalancerImplTest, PicksHandlerWithFewestConnections) {
+  ExactConnectionBalancerImpl balancer;
+  NiceMock<MockBalancedConnectionHandler> handler1;
+  NiceMock<MockBalancedConnectionHandler> handler2;
+  NiceMock<MockBalancedConnectionHandler> handler3;
+  balancer.registerHandler(handler1);
+  balancer.registerHandler(handler2);
+  balancer.registerHandler(handler3);
+
+  ON_CALL(handler1, numConnections()).WillByDefault(Return(5));
+  ON_CALL(handler2, numConnections()).WillByDefault(Return(1));
+  ON_CALL(handler3, numConnections()).WillByDefault(Return(3));
+  EXPECT_CALL(handler2, incNumConnections());
+  EXPECT_EQ(&handler2, &balancer.pickTargetHandler(handler1));
+
+  // Once handler2 is gone, handler3 has the fewest connections.
+  balancer.unregisterHandler(handler2);
+  EXPECT_CALL(handler3, incNumConnections());
+  EXPECT_EQ(&handler3, &balancer.pickTargetHandler(handler1));
+}
+
+TEST(ExactConnectionBalancerImplTest, CurrentHandlerWinsTies) {
+  ExactConnectionBalancerImpl balancer;
+  NiceMock<MockBalancedConnectionHandler> handler1;
+  NiceMock<MockBalancedConnectionHandler> handler2;
+  balancer.registerHandler(handler1);
+  balancer.registerHandler(handler2);
+
+  ON_CALL(handler1, numConnections()).WillByDefault(Return(2));
+  ON_CALL(handler2, numConnections()).WillByDefault(Return(2));
+  EXPECT_CALL(handler1, incNumConnections()).Times(0);
+  EXPECT_CALL(handler2, incNumConnections()).Times(0);
+  EXPECT_EQ(&handler2, &balancer.pickTargetHandler(handler2));
+}
+
+TEST(ExactConnectionBalancerImplTest, NoRegisteredHandlers) {
+  ExactConnectionBalancerImpl balancer;
+  NiceMock<MockBalancedConnectionHandler> handler;
+
+  EXPECT_CALL(handler, incNumConnections()).Times(0);
+  EXPECT_EQ(&handler, &balancer.pickTargetHandler(handler));
+}
+
+} // namespace Network
+} // namespace Envoy
@@ -1019,6 +1019,36 @@ TEST_F(MockTransportConnectionImplTest, HalfCloseWrite) {
   connection_->write(buffer, true);
 }
 
+// Test that small writes are held back until the coalescing timer fires or enough data is pending.
+TEST_F(MockTransportConnectionImplTest, WriteCoalescing) {
+  Event::MockTimer* timer = new Event::MockTimer(&dispatcher_);
+  connection_->setWriteCoalescing(10, std::chrono::milliseconds(1));
+
+  // Only the first write arms the timer.
+  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(1)));
+  EXPECT_CALL(*file_event_, activate(_)).Times(0);
+  Buffer::OwnedImpl buffer1("abc");
+  connection_->write(buffer1, false);
+  Buffer::OwnedImpl buffer2("def");
+  connection_->write(buffer2, false);
+
+  EXPECT_CALL(*file_event_, activate(Event::FileReadyType::Write)).WillOnce(Invoke(file_ready_cb_));
+  EXPECT_CALL(*transport_socket_, doWrite(BufferStringEqual("abcdef"), false))
+      .WillOnce(Invoke(SimulateSuccessfulWrite));
+  timer->callback_();
+
+  // Reaching the byte limit flushes immediately.
+  EXPECT_CALL(*timer, enableTimer(_));
+  Buffer::OwnedImpl buffer3("abc");
+  connection_->write(buffer3, false);
+  EXPECT_CALL(*file_event_, activate(Event::FileReadyType::Write)).WillOnce(Invoke(file_ready_cb_));
+  EXPECT_CALL(*timer, disableTimer());
+  EXPECT_CALL(*transport_socket_, doWrite(BufferStringEqual("abcdefghijkl"), false))
+      .WillOnce(Invoke(SimulateSuccessfulWrite));
+  Buffer::OwnedImpl buffer4("defghijkl");
+  connection_->write(buffer4, false);
+}
+
 TEST_F(MockTransportConnectionImplTest, ReadMultipleEndStream) {
   std::shared_ptr<MockReadFilter> read_filter(new NiceMock<MockReadFilter>());
   connection_->enableHalfClose(true);
@@ -1197,7 +1227,8 @@ TEST_F(MockTransportConnectionImplTest, WriteReadyOnConnected) {
 
 class ReadBufferLimitTest : public ConnectionImplTest {
 public:
-  void readBufferLimitTest(uint32_t read_buffer_limit, uint32_t expected_chunk_size) {
+  void readBufferLimitTest(uint32_t read_buffer_limit, uint32_t expected_chunk_size,
+                           uint32_t read_budget = 0) {
     const uint32_t buffer_size = 256 * 1024;
     dispatcher_.reset(new Event::DispatcherImpl(time_system_));
     listener_ = dispatcher_->createListener(socket_, listener_callbacks_, true, false);
@@ -1214,6 +1245,9 @@ public:
           Network::ConnectionPtr new_connection = dispatcher_->createServerConnection(
               std::move(socket), Network::Test::createRawBufferSocket());
           new_connection->setBufferLimits(read_buffer_limit);
+          if (read_budget > 0) {
+            new_connection->setReadBudget(read_budget, stats_store_.counter("read_yield"));
+          }
           listener_callbacks_.onNewConnection(std::move(new_connection));
         }));
     EXPECT_CALL(listener_callbacks_, onNewConnection_(_))
@@ -1268,6 +1302,14 @@ TEST_P(ReadBufferLimitTest, SomeLimit) {
   readBufferLimitTest(read_buffer_limit, read_buffer_limit - 1 + 16384);
 }
 
+// A read budget bounds each read like a buffer limit, even when the filters drain the buffer, and
+// every read it stops is counted.
+TEST_P(ReadBufferLimitTest, ReadBudget) {
+  const uint32_t read_budget = 32 * 1024;
+  readBufferLimitTest(0, read_budget - 1 + 16384, read_budget);
+  EXPECT_LT(0U, stats_store_.counter("read_yield").value());
+}
+
 class TcpClientConnectionImplTest : public testing::TestWithParam<Address::IpVersion> {
 protected:
   TcpClientConnectionImplTest() : dispatcher_(time_system_) {}
@@ -0,0 +1,175 @@
+#include <chrono>
+#include <list>
+#include <string>
+
+#include "common/network/dns_cache_impl.h"
+#include "common/network/utility.h"
+#include "common/stats/isolated_store_impl.h"
+
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/network/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::DoAll;
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+using testing::SaveArg;
+
+namespace Envoy {
+namespace Network {
+
+class DnsCacheImplTest : public testing::Test {
+public:
+  DnsCacheImplTest()
+      : resolver_(std::make_shared<NiceMock<MockDnsResolver>>()),
+        cache_(resolver_, dispatcher_, stats_store_, std::chrono::seconds(5),
+               std::chrono::seconds(60)) {}
+
+  // Resolves a name through the cache and returns the handle.
+  ActiveDnsQuery* resolve(const std::string& name) {
+    return cache_.resolve(
+        name, DnsLookupFamily::V4Only,
+        [this](const std::list<Address::InstanceConstSharedPtr>&& results) -> void {
+          results_.push_back(results);
+        });
+  }
+
+  // Expects a resolution of the name by the underlying resolver and saves its callback.
+  void expectResolve(const std::string& name) {
+    EXPECT_CALL(*resolver_, resolveWithTtl(name, DnsLookupFamily::V4Only, _))
+        .WillOnce(DoAll(SaveArg<2>(&callback_), Return(&resolver_->active_query_)));
+  }
+
+  static std::list<Address::InstanceConstSharedPtr> addresses(const std::string& address) {
+    return {Utility::parseInternetAddress(address)};
+  }
+
+  uint64_t counter(const std::string& name) {
+    return stats_store_.counter("dns_cache." + name).value();
+  }
+
+  NiceMock<Event::MockDispatcher> dispatcher_;
+  Stats::IsolatedStoreImpl stats_store_;
+  std::shared_ptr<NiceMock<MockDnsResolver>> resolver_;
+  DnsCacheImpl cache_;
+  DnsResolver::ResolveWithTtlCb callback_;
+  std::list<std::list<Address::InstanceConstSharedPtr>> results_;
+};
+
+// Validate that concurrent resolutions share a query and that the result is cached.
+TEST_F(DnsCacheImplTest, CoalesceAndCache) {
+  Event::MockTimer* timer = new NiceMock<Event::MockTimer>(&dispatcher_);
+  expectResolve("foo.com");
+  EXPECT_NE(nullptr, resolve("foo.com"));
+  EXPECT_NE(nullptr, resolve("foo.com"));
+  EXPECT_EQ(1UL, counter("cache_miss"));
+  EXPECT_EQ(1UL, counter("query_coalesced"));
+
+  // The TTL of the records is bounded by the minimum TTL.
+  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(5000)));
+  callback_(addresses("1.2.3.4"), std::chrono::seconds(1));
+  ASSERT_EQ(2UL, results_.size());
+  EXPECT_EQ("1.2.3.4:0", results_.back().front()->asString());
+
+  EXPECT_EQ(nullptr, resolve("foo.com"));
+  EXPECT_EQ(3UL, results_.size());
+  EXPECT_EQ("1.2.3.4:0", results_.back().front()->asString());
+  EXPECT_EQ(1UL, counter("cache_hit"));
+  EXPECT_EQ(1UL, stats_store_.gauge("dns_cache.entries").value());
+}
+
+// Validate that a cancelled resolution is not called back.
+TEST_F(DnsCacheImplTest, Cancel) {
+  Event::MockTimer* timer = new NiceMock<Event::MockTimer>(&dispatcher_);
+  expectResolve("foo.com");
+  resolve("foo.com")->cancel();
+  EXPECT_NE(nullptr, resolve("foo.com"));
+
+  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(30000)));
+  callback_(addresses("1.2.3.4"), std::chrono::seconds(30));
+  EXPECT_EQ(1UL, results_.size());
+}
+
+// Validate that a used entry is refreshed once it expires, and that the expired result is served
+// meanwhile.
+TEST_F(DnsCacheImplTest, RefreshUsedEntry) {
+  Event::MockTimer* timer = new NiceMock<Event::MockTimer>(&dispatcher_);
+  expectResolve("foo.com");
+  resolve("foo.com");
+  // The TTL of the records is bounded by the maximum TTL.
+  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(60000)));
+  callback_(addresses("1.2.3.4"), std::chrono::seconds(3600));
+  EXPECT_EQ(nullptr, resolve("foo.com"));
+
+  expectResolve("foo.com");
+  timer->callback_();
+  EXPECT_EQ(1UL, counter("refresh"));
+  EXPECT_EQ(nullptr, resolve("foo.com"));
+  EXPECT_EQ("1.2.3.4:0", results_.back().front()->asString());
+
+  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(10000)));
+  callback_(addresses("5.6.7.8"), std::chrono::seconds(10));
+  EXPECT_EQ(nullptr, resolve("foo.com"));
+  EXPECT_EQ("5.6.7.8:0", results_.back().front()->asString());
+}
+
+// Validate that an unused entry is evicted once it expires.
+TEST_F(DnsCacheImplTest, EvictUnusedEntry) {
+  Event::MockTimer* timer = new NiceMock<Event::MockTimer>(&dispatcher_);
+  expectResolve("foo.com");
+  resolve("foo.com");
+  callback_(addresses("1.2.3.4"), std::chrono::seconds(30));
+
+  EXPECT_CALL(*resolver_, resolveWithTtl(_, _, _)).Times(0);
+  timer->callback_();
+  EXPECT_EQ(1UL, counter("eviction"));
+  EXPECT_EQ(0UL, stats_store_.gauge("dns_cache.entries").value());
+
+  new NiceMock<Event::MockTimer>(&dispatcher_);
+  expectResolve("foo.com");
+  EXPECT_NE(nullptr, resolve("foo.com"));
+  EXPECT_EQ(2UL, counter("cache_miss"));
+}
+
+// Validate that failed resolutions are not cached.
+TEST_F(DnsCacheImplTest, FailureNotCached) {
+  new NiceMock<Event::MockTimer>(&dispatcher_);
+  expectResolve("foo.com");
+  resolve("foo.com");
+  callback_({}, std::chrono::seconds(0));
+  ASSERT_EQ(1UL, results_.size());
+  EXPECT_TRUE(results_.back().empty());
+
+  new NiceMock<Event::MockTimer>(&dispatcher_);
+  expectResolve("foo.com");
+  EXPECT_NE(nullptr, resolve("foo.com"));
+}
+
+// Validate that a resolution completed synchronously by the resolver returns no handle.
+TEST_F(DnsCacheImplTest, SynchronousResolution) {
+  new NiceMock<Event::MockTimer>(&dispatcher_);
+  EXPECT_CALL(*resolver_, resolveWithTtl("localhost", DnsLookupFamily::V4Only, _))
+      .WillOnce(Invoke([](const std::string&, DnsLookupFamily,
+                          DnsResolver::ResolveWithTtlCb callback) -> ActiveDnsQuery* {
+        callback(addresses("127.0.0.1"), std::chrono::seconds::max());
+        return nullptr;
+      }));
+  EXPECT_EQ(nullptr, resolve("localhost"));
+  ASSERT_EQ(1UL, results_.size());
+  EXPECT_EQ("127.0.0.1:0", results_.back().front()->asString());
+}
+
+// Validate that destroying the cache cancels the queries in flight.
+TEST_F(DnsCacheImplTest, DestroyWithPendingQuery) {
+  new NiceMock<Event::MockTimer>(&dispatcher_);
+  expectResolve("foo.com");
+  resolve("foo.com");
+  EXPECT_CALL(resolver_->active_query_, cancel());
+}
+
+} // namespace Network
+} // namespace Envoy
@@ -56,9 +56,9 @@ enum record_type { A, AAAA };
 class TestDnsServerQuery {
 public:
   TestDnsServerQuery(ConnectionPtr connection, const HostMap& hosts_A, const HostMap& hosts_AAAA,
-                     const CNameMap& cnames)
+                     const CNameMap& cnames, const uint32_t& ttl)
       : connection_(std::move(connection)), hosts_A_(hosts_A), hosts_AAAA_(hosts_AAAA),
-        cnames_(cnames) {
+        cnames_(cnames), ttl_(ttl) {
     connection_->addReadFilter(Network::ReadFilterSharedPtr{new ReadFilter(*this)});
   }
 
@@ -199,7 +199,7 @@ private:
           DNS_RR_SET_TYPE(cname_rr_fixed, T_CNAME);
           DNS_RR_SET_LEN(cname_rr_fixed, encodedCname.size() + 1);
           DNS_RR_SET_CLASS(cname_rr_fixed, C_IN);
-          DNS_RR_SET_TTL(cname_rr_fixed, 0);
+          DNS_RR_SET_TTL(cname_rr_fixed, parent_.ttl_);
           write_buffer.add(question, name_len);
           write_buffer.add(cname_rr_fixed, RRFIXEDSZ);
           write_buffer.add(encodedCname.c_str(), encodedCname.size() + 1);
@@ -215,7 +215,7 @@ private:
           DNS_RR_SET_LEN(response_rr_fixed, sizeof(in6_addr));
         }
         DNS_RR_SET_CLASS(response_rr_fixed, C_IN);
-        DNS_RR_SET_TTL(response_rr_fixed, 0);
+        DNS_RR_SET_TTL(response_rr_fixed, parent_.ttl_);
         if (ips != nullptr) {
           for (const auto& it : *ips) {
             write_buffer.add(ip_question, ip_name_len);
@@ -253,6 +253,7 @@ private:
   const HostMap& hosts_A_;
   const HostMap& hosts_AAAA_;
   const CNameMap& cnames_;
+  const uint32_t& ttl_;
 };
 
 class TestDnsServer : public ListenerCallbacks {
@@ -267,10 +268,12 @@ public:
 
   void onNewConnection(ConnectionPtr&& new_connection) override {
     TestDnsServerQuery* query =
-        new TestDnsServerQuery(std::move(new_connection), hosts_A_, hosts_AAAA_, cnames_);
+        new TestDnsServerQuery(std::move(new_connection), hosts_A_, hosts_AAAA_, cnames_, ttl_);
     queries_.emplace_back(query);
   }
 
+  void onAcceptBatch(uint32_t, bool) override {}
+
   void addHosts(const std::string& hostname, const IpList& ip, const record_type& type) {
     if (type == A) {
       hosts_A_[hostname] = ip;
@@ -283,12 +286,15 @@ public:
     cnames_[hostname] = cname;
   }
 
+  void setTtl(uint32_t ttl) { ttl_ = ttl; }
+
 private:
   Event::DispatcherImpl& dispatcher_;
 
   HostMap hosts_A_;
   HostMap hosts_AAAA_;
   CNameMap cnames_;
+  uint32_t ttl_{};
   // All queries are tracked so we can do resource reclamation when the test is
   // over.
   std::vector<std::unique_ptr<TestDnsServerQuery>> queries_;
@@ -368,6 +374,8 @@ public:
   Api::SysCallIntResult bind(int fd) const override { return instance_.bind(fd); }
   Api::SysCallIntResult connect(int fd) const override { return instance_.connect(fd); }
   const Address::Ip* ip() const override { return instance_.ip(); }
+  const sockaddr* sockAddr() const override { return instance_.sockAddr(); }
+  socklen_t sockAddrLen() const override { return instance_.sockAddrLen(); }
   int socket(Address::SocketType type) const override { return instance_.socket(type); }
   Address::Type type() const override { return instance_.type(); }
 
@@ -554,6 +562,38 @@ TEST_P(DnsImplTest, DnsIpAddressVersionV6) {
   EXPECT_TRUE(hasAddress(address_list, "1::2"));
 }
 
+// Validate that the TTL of the answers is reported, and that names in the hosts file have no TTL.
+TEST_P(DnsImplTest, ResolveWithTtl) {
+  std::list<Address::InstanceConstSharedPtr> address_list;
+  std::chrono::seconds ttl;
+  server_->addHosts("some.good.domain", {"201.134.56.7"}, A);
+  server_->setTtl(30);
+  EXPECT_NE(nullptr, resolver_->resolveWithTtl(
+                         "some.good.domain", DnsLookupFamily::V4Only,
+                         [&](std::list<Address::InstanceConstSharedPtr>&& results,
+                             std::chrono::seconds result_ttl) -> void {
+                           address_list = results;
+                           ttl = result_ttl;
+                           dispatcher_.exit();
+                         }));
+
+  dispatcher_.run(Event::Dispatcher::RunType::Block);
+  EXPECT_TRUE(hasAddress(address_list, "201.134.56.7"));
+  EXPECT_EQ(std::chrono::seconds(30), ttl);
+
+  if (GetParam() == Address::IpVersion::v4) {
+    EXPECT_EQ(nullptr, resolver_->resolveWithTtl(
+                           "localhost", DnsLookupFamily::V4Only,
+                           [&](std::list<Address::InstanceConstSharedPtr>&& results,
+                               std::chrono::seconds result_ttl) -> void {
+                             address_list = results;
+                             ttl = result_ttl;
+                           }));
+    EXPECT_TRUE(hasAddress(address_list, "127.0.0.1"));
+    EXPECT_EQ(std::chrono::seconds::max(), ttl);
+  }
+}
+
 // Validate exception behavior during c-ares callbacks.
 TEST_P(DnsImplTest, CallbackException) {
   // Force immediate resolution, which will trigger a c-ares exception unsafe
@@ -15,12 +15,17 @@ std::vector<std::pair<std::string, std::vector<Envoy::Network::Address::CidrRang
 std::vector<std::pair<std::string, std::vector<Envoy::Network::Address::CidrRange>>>
     tag_data_minimal;
 
+std::vector<std::pair<std::string, std::vector<Envoy::Network::Address::CidrRange>>>
+    tag_data_large;
+
 std::unique_ptr<Envoy::Network::LcTrie::LcTrie<std::string>> lc_trie;
 
 std::unique_ptr<Envoy::Network::LcTrie::LcTrie<std::string>> lc_trie_nested_prefixes;
 
 std::unique_ptr<Envoy::Network::LcTrie::LcTrie<std::string>> lc_trie_minimal;
 
+std::unique_ptr<Envoy::Network::LcTrie::LcTrie<std::string>> lc_trie_large;
+
 } // namespace
 
 namespace Envoy {
@@ -56,6 +61,16 @@ static void BM_LcTrieConstructMinimal(benchmark::State& state) {
 
 BENCHMARK(BM_LcTrieConstructMinimal);
 
+static void BM_LcTrieConstructLarge(benchmark::State& state) {
+  std::unique_ptr<Envoy::Network::LcTrie::LcTrie<std::string>> trie;
+  for (auto _ : state) {
+    trie = std::make_unique<Envoy::Network::LcTrie::LcTrie<std::string>>(tag_data_large);
+  }
+  benchmark::DoNotOptimize(trie);
+}
+
+BENCHMARK(BM_LcTrieConstructLarge)->Unit(benchmark::kMillisecond);
+
 static void BM_LcTrieLookup(benchmark::State& state) {
   static size_t i = 0;
   size_t output_tags = 0;
@@ -95,6 +110,19 @@ static void BM_LcTrieLookupMinimal(benchmark::State& state) {
 
 BENCHMARK(BM_LcTrieLookupMinimal);
 
+static void BM_LcTrieLookupLarge(benchmark::State& state) {
+  static size_t i = 0;
+  size_t output_tags = 0;
+  for (auto _ : state) {
+    i++;
+    i %= addresses.size();
+    output_tags += lc_trie_large->getData(addresses[i]).size();
+  }
+  benchmark::DoNotOptimize(output_tags);
+}
+
+BENCHMARK(BM_LcTrieLookupLarge);
+
 } // namespace Envoy
 
 // Boilerplate main(), which discovers benchmarks in the same file and runs them.
@@ -108,10 +136,11 @@ int main(int argc, char** argv) {
     addresses.push_back(Envoy::Network::Utility::parseInternetAddress(address));
   }
 
-  // Construct three sets of prefixes: one consisting of 1,024 addresses in an
+  // Construct four sets of prefixes: one consisting of 1,024 addresses in an
   // RFC 5737 netblock, another consisting of those same addresses plus
   // 0.0.0.0/0 (to exercise the LC Trie's support for nested prefixes),
-  // and finally a set containing only 0.0.0.0/0.
+  // a set containing only 0.0.0.0/0, and finally a set of 2^20 /24 prefixes,
+  // which needs more trie nodes than a 20-bit node address can index.
   for (int i = 0; i < 32; i++) {
     for (int j = 0; j < 32; j++) {
       tag_data.emplace_back(std::pair<std::string, std::vector<Envoy::Network::Address::CidrRange>>(
@@ -126,11 +155,24 @@ int main(int argc, char** argv) {
   tag_data_minimal.emplace_back(
       std::pair<std::string, std::vector<Envoy::Network::Address::CidrRange>>(
           {"tag_1", {Envoy::Network::Address::CidrRange::create("0.0.0.0/0")}}));
+  std::vector<Envoy::Network::Address::CidrRange> large_prefixes;
+  for (int i = 0; i < 16; i++) {
+    for (int j = 0; j < 256; j++) {
+      for (int k = 0; k < 256; k++) {
+        large_prefixes.emplace_back(Envoy::Network::Address::CidrRange::create(
+            fmt::format("{}.{}.{}.0/24", i + 192, j, k)));
+      }
+    }
+  }
+  tag_data_large.emplace_back(
+      std::pair<std::string, std::vector<Envoy::Network::Address::CidrRange>>(
+          {"tag_1", std::move(large_prefixes)}));
 
   lc_trie = std::make_unique<Envoy::Network::LcTrie::LcTrie<std::string>>(tag_data);
   lc_trie_nested_prefixes =
       std::make_unique<Envoy::Network::LcTrie::LcTrie<std::string>>(tag_data_nested_prefixes);
   lc_trie_minimal = std::make_unique<Envoy::Network::LcTrie::LcTrie<std::string>>(tag_data_minimal);
+  lc_trie_large = std::make_unique<Envoy::Network::LcTrie::LcTrie<std::string>>(tag_data_large);
 
   benchmark::Initialize(&argc, argv);
   if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
@@ -322,28 +322,31 @@ TEST_F(LcTrieTest, ExclusiveNestedPrefixesWithCatchAll) {
   expectIPAndTags(test_case);
 }
 
-// Ensure the trie will reject inputs that would cause it to exceed the maximum 2^20 nodes
-// when using the default fill factor.
-TEST_F(LcTrieTest, MaximumEntriesExceptionDefault) {
-  static const size_t num_prefixes = 1 << 19;
-  Address::CidrRange address = Address::CidrRange::create("10.0.0.1/8");
+// Ensure the trie accepts more entries than the 2^20 nodes it used to be limited to.
+TEST_F(LcTrieTest, MoreThanAMillionNodes) {
   std::vector<Address::CidrRange> prefixes;
-  prefixes.reserve(num_prefixes);
-  for (size_t i = 0; i < num_prefixes; i++) {
-    prefixes.push_back(address);
+  prefixes.reserve(1 << 20);
+  for (size_t i = 0; i < 16; i++) {
+    for (size_t j = 0; j < 256; j++) {
+      for (size_t k = 0; k < 256; k++) {
+        prefixes.emplace_back(Address::CidrRange::create(fmt::format("10.{}.{}.{}/32", i, j, k)));
+      }
+    }
   }
-  EXPECT_EQ(num_prefixes, prefixes.size());
+  std::vector<std::pair<std::string, std::vector<Address::CidrRange>>> ip_tags_input{
+      std::make_pair("tag_1", prefixes)};
+  trie_.reset(new LcTrie<std::string>(ip_tags_input));
 
-  std::pair<std::string, std::vector<Address::CidrRange>> ip_tag =
-      std::make_pair("bad_tag", prefixes);
-  std::vector<std::pair<std::string, std::vector<Address::CidrRange>>> ip_tags_input{ip_tag};
-  EXPECT_THROW_WITH_MESSAGE(new LcTrie<std::string>(ip_tags_input), EnvoyException,
-                            "The input vector has '524288' CIDR range entries. "
-                            "LC-Trie can only support '262144' CIDR ranges with "
-                            "the specified fill factor.");
+  const std::vector<std::pair<std::string, std::vector<std::string>>> test_case = {
+      {"10.0.0.0", {"tag_1"}},
+      {"10.7.128.3", {"tag_1"}},
+      {"10.15.255.255", {"tag_1"}},
+      {"10.16.0.0", {}},
+      {"11.0.0.0", {}}};
+  expectIPAndTags(test_case);
 }
 
-// Ensure the trie will reject inputs that would cause it to exceed the maximum 2^20 nodes
+// Ensure the trie will reject inputs that would cause it to exceed the maximum 2^30 nodes
 // when using a fill factor override.
 TEST_F(LcTrieTest, MaximumEntriesExceptionOverride) {
   static const size_t num_prefixes = 8192;
@@ -361,9 +364,10 @@ TEST_F(LcTrieTest, MaximumEntriesExceptionOverride) {
   std::pair<std::string, std::vector<Address::CidrRange>> ip_tag =
       std::make_pair("bad_tag", prefixes);
   std::vector<std::pair<std::string, std::vector<Address::CidrRange>>> ip_tags_input{ip_tag};
-  EXPECT_THROW_WITH_MESSAGE(new LcTrie<std::string>(ip_tags_input, false, 0.01), EnvoyException,
+  EXPECT_THROW_WITH_MESSAGE(new LcTrie<std::string>(ip_tags_input, false, 0.00001),
+                            EnvoyException,
                             "The input vector has '8192' CIDR range entries. "
-                            "LC-Trie can only support '5242' CIDR ranges with "
+                            "LC-Trie can only support '5368' CIDR ranges with "
                             "the specified fill factor.");
 }
 
@@ -1,7 +1,16 @@
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <limits>
+
 #include "common/network/address_impl.h"
 #include "common/network/listener_impl.h"
 #include "common/network/utility.h"
 
+#include "test/common/event/fake_io_uring.h"
 #include "test/mocks/network/mocks.h"
 #include "test/mocks/server/mocks.h"
 #include "test/test_common/environment.h"
@@ -66,9 +75,10 @@ TEST_P(ListenerImplDeathTest, ErrorCallback) {
 class TestListenerImpl : public ListenerImpl {
 public:
   TestListenerImpl(Event::DispatcherImpl& dispatcher, Socket& socket, ListenerCallbacks& cb,
-                   bool bind_to_port, bool hand_off_restored_destination_connections)
+                   bool bind_to_port, bool hand_off_restored_destination_connections,
+                   uint32_t max_accepts_per_wakeup = std::numeric_limits<uint32_t>::max())
       : ListenerImpl(dispatcher, socket, cb, bind_to_port,
-                     hand_off_restored_destination_connections) {}
+                     hand_off_restored_destination_connections, max_accepts_per_wakeup) {}
 
   MOCK_METHOD1(getLocalAddress, Address::InstanceConstSharedPtr(int fd));
 };
@@ -244,5 +254,282 @@ TEST_P(ListenerImplTest, WildcardListenerIpv4Compat) {
   dispatcher_.run(Event::Dispatcher::RunType::Block);
 }
 
+// Test that the listener stops accepting once the per wakeup limit is reached and picks up the
+// remaining connections on the next wakeup.
+TEST_P(ListenerImplTest, MaxAcceptsPerWakeup) {
+  Network::TcpListenSocket socket(Network::Test::getCanonicalLoopbackAddress(version_), nullptr,
+                                  true);
+  Network::MockListenerCallbacks listener_callbacks;
+  Network::TestListenerImpl listener(dispatcher_, socket, listener_callbacks, true, false, 1);
+
+  std::vector<Network::ClientConnectionPtr> client_connections;
+  for (int i = 0; i < 2; i++) {
+    client_connections.emplace_back(dispatcher_.createClientConnection(
+        socket.localAddress(), Network::Address::InstanceConstSharedPtr(),
+        Network::Test::createRawBufferSocket(), nullptr));
+    client_connections.back()->connect();
+  }
+
+  EXPECT_CALL(listener, getLocalAddress(_)).Times(0);
+  EXPECT_CALL(listener_callbacks, onAccept_(_, _)).Times(2);
+  EXPECT_CALL(listener_callbacks, onAcceptBatch(1, true))
+      .WillOnce(Return())
+      .WillOnce(Invoke([&](uint32_t, bool) -> void { dispatcher_.exit(); }));
+
+  dispatcher_.run(Event::Dispatcher::RunType::Block);
+
+  for (auto& client_connection : client_connections) {
+    client_connection->close(ConnectionCloseType::NoFlush);
+  }
+}
+
+// Test that a listener without a per wakeup limit reports that it drained the accept queue.
+TEST_P(ListenerImplTest, AcceptUntilDrained) {
+  Network::TcpListenSocket socket(Network::Test::getCanonicalLoopbackAddress(version_), nullptr,
+                                  true);
+  Network::MockListenerCallbacks listener_callbacks;
+  Network::TestListenerImpl listener(dispatcher_, socket, listener_callbacks, true, false);
+
+  Network::ClientConnectionPtr client_connection = dispatcher_.createClientConnection(
+      socket.localAddress(), Network::Address::InstanceConstSharedPtr(),
+      Network::Test::createRawBufferSocket(), nullptr);
+  client_connection->connect();
+
+  EXPECT_CALL(listener, getLocalAddress(_)).Times(0);
+  EXPECT_CALL(listener_callbacks, onAccept_(_, _));
+  EXPECT_CALL(listener_callbacks, onAcceptBatch(1, false))
+      .WillOnce(Invoke([&](uint32_t, bool) -> void { dispatcher_.exit(); }));
+
+  dispatcher_.run(Event::Dispatcher::RunType::Block);
+
+  client_connection->close(ConnectionCloseType::NoFlush);
+}
+
+// Test that connections are accepted through the dispatcher's io_uring when one is available.
+TEST_P(ListenerImplTest, IoUringAccept) {
+  Event::DispatcherImpl dispatcher(test_time_.timeSystem());
+  if (!dispatcher.enableIoUring()) {
+    std::cout << "io_uring is not supported by the kernel running the test, skipping" << std::endl;
+    return;
+  }
+
+  Network::TcpListenSocket socket(Network::Test::getCanonicalLoopbackAddress(version_), nullptr,
+                                  true);
+  Network::MockListenerCallbacks listener_callbacks;
+  Network::TestListenerImpl listener(dispatcher, socket, listener_callbacks, true, false);
+
+  Network::ClientConnectionPtr client_connection = dispatcher.createClientConnection(
+      socket.localAddress(), Network::Address::InstanceConstSharedPtr(),
+      Network::Test::createRawBufferSocket(), nullptr);
+  client_connection->connect();
+
+  EXPECT_CALL(listener, getLocalAddress(_)).Times(0);
+  EXPECT_CALL(listener_callbacks, onAccept_(_, _))
+      .WillOnce(Invoke([&](Network::ConnectionSocketPtr& accepted_socket, bool) -> void {
+        EXPECT_EQ(*accepted_socket->localAddress(), *socket.localAddress());
+      }));
+  EXPECT_CALL(listener_callbacks, onAcceptBatch(1, false))
+      .WillOnce(Invoke([&](uint32_t, bool) -> void { dispatcher.exit(); }));
+
+  dispatcher.run(Event::Dispatcher::RunType::Block);
+
+  client_connection->close(ConnectionCloseType::NoFlush);
+}
+
+// Accepts through a fake ring, whose operations the tests complete, so that every path of the
+// io_uring acceptor runs on any kernel.
+class ListenerImplIoUringTest : public ListenerImplTest {
+protected:
+  ListenerImplIoUringTest()
+      : ring_(new Event::FakeIoUring()),
+        socket_(Network::Test::getCanonicalLoopbackAddress(version_), nullptr, true) {
+    EXPECT_TRUE(dispatcher_.enableIoUring(Event::IoUringImplPtr{ring_}));
+  }
+
+  // The request of the listener created last, which has an operation in flight.
+  Event::IoUringRequest* lastAcceptor() { return ring_->lastInFlight().request_; }
+
+  // Complete the accept of a request with a new socket, and return the socket.
+  int completeAccept(Event::IoUringRequest* acceptor) {
+    const int fd =
+        ::socket(version_ == Address::IpVersion::v4 ? AF_INET : AF_INET6, SOCK_STREAM, 0);
+    RELEASE_ASSERT(fd >= 0, "");
+    ring_->completeAccept(acceptor, fd, *socket_.localAddress());
+    return fd;
+  }
+
+  Event::FakeIoUring* ring_;
+  Network::TcpListenSocket socket_;
+  Network::MockListenerCallbacks listener_callbacks_;
+};
+INSTANTIATE_TEST_CASE_P(IpVersions, ListenerImplIoUringTest,
+                        testing::ValuesIn(TestEnvironment::getIpVersionsForTest()),
+                        TestUtility::ipTestParamsToString);
+
+// Test that an accepted socket is handed to the callbacks with the peer address reported by the
+// ring, and that the next accept is queued.
+TEST_P(ListenerImplIoUringTest, AcceptAndRequeue) {
+  TestListenerImpl listener(dispatcher_, socket_, listener_callbacks_, true, false);
+  Event::IoUringRequest* acceptor = lastAcceptor();
+  EXPECT_EQ(Event::FakeIoUring::OperationType::Accept, ring_->inFlight(acceptor)->type_);
+  EXPECT_EQ(socket_.fd(), ring_->inFlight(acceptor)->fd_);
+
+  completeAccept(acceptor);
+  EXPECT_CALL(listener, getLocalAddress(_)).Times(0);
+  EXPECT_CALL(listener_callbacks_, onAccept_(_, _))
+      .WillOnce(Invoke([&](Network::ConnectionSocketPtr& accepted_socket, bool) -> void {
+        EXPECT_EQ(*accepted_socket->remoteAddress(), *socket_.localAddress());
+      }));
+  EXPECT_CALL(listener_callbacks_, onAcceptBatch(1, false));
+  ring_->processCompletions();
+
+  ASSERT_NE(nullptr, ring_->inFlight(acceptor));
+  EXPECT_EQ(Event::FakeIoUring::OperationType::Accept, ring_->inFlight(acceptor)->type_);
+}
+
+// Test that reaching max_accepts_per_wakeup stops accepting until the resume timer fires.
+TEST_P(ListenerImplIoUringTest, MaxAcceptsPerWakeup) {
+  TestListenerImpl listener(dispatcher_, socket_, listener_callbacks_, true, false, 1);
+  Event::IoUringRequest* acceptor = lastAcceptor();
+
+  completeAccept(acceptor);
+  EXPECT_CALL(listener_callbacks_, onAccept_(_, _));
+  EXPECT_CALL(listener_callbacks_, onAcceptBatch(1, true));
+  ring_->processCompletions();
+  EXPECT_EQ(nullptr, ring_->inFlight(acceptor));
+
+  dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
+  ASSERT_NE(nullptr, ring_->inFlight(acceptor));
+  EXPECT_EQ(Event::FakeIoUring::OperationType::Accept, ring_->inFlight(acceptor)->type_);
+}
+
+// Test that an accept finding no pending connection falls back to polling the listen socket, and
+// that readiness resumes accepting.
+TEST_P(ListenerImplIoUringTest, EagainFallsBackToPoll) {
+  TestListenerImpl listener(dispatcher_, socket_, listener_callbacks_, true, false);
+  Event::IoUringRequest* acceptor = lastAcceptor();
+  EXPECT_CALL(listener_callbacks_, onAccept_(_, _)).Times(0);
+  EXPECT_CALL(listener_callbacks_, onAcceptBatch(_, _)).Times(0);
+
+  ring_->complete(acceptor, -EAGAIN);
+  ring_->processCompletions();
+  ASSERT_NE(nullptr, ring_->inFlight(acceptor));
+  EXPECT_EQ(Event::FakeIoUring::OperationType::Poll, ring_->inFlight(acceptor)->type_);
+  EXPECT_EQ(socket_.fd(), ring_->inFlight(acceptor)->fd_);
+
+  ring_->complete(acceptor, POLLIN);
+  ring_->processCompletions();
+  ASSERT_NE(nullptr, ring_->inFlight(acceptor));
+  EXPECT_EQ(Event::FakeIoUring::OperationType::Accept, ring_->inFlight(acceptor)->type_);
+}
+
+// Test that accepts failing with a transient error are retried.
+TEST_P(ListenerImplIoUringTest, RetriableErrors) {
+  TestListenerImpl listener(dispatcher_, socket_, listener_callbacks_, true, false);
+  Event::IoUringRequest* acceptor = lastAcceptor();
+  EXPECT_CALL(listener_callbacks_, onAccept_(_, _)).Times(0);
+  EXPECT_CALL(listener_callbacks_, onAcceptBatch(_, _)).Times(0);
+
+  for (const int32_t error : {-ECONNABORTED, -EINTR}) {
+    ring_->complete(acceptor, error);
+    ring_->processCompletions();
+    ASSERT_NE(nullptr, ring_->inFlight(acceptor));
+    EXPECT_EQ(Event::FakeIoUring::OperationType::Accept, ring_->inFlight(acceptor)->type_);
+  }
+}
+
+// Test that any other accept failure goes to the error callback.
+TEST_P(ListenerImplIoUringTest, AcceptError) {
+  TestListenerImpl listener(dispatcher_, socket_, listener_callbacks_, true, false);
+  Event::IoUringRequest* acceptor = lastAcceptor();
+  ring_->complete(acceptor, -EMFILE);
+  EXPECT_DEATH_LOG_TO_STDERR(ring_->processCompletions(), ".*listener accept failure.*");
+}
+
+// Test that destroying the listener cancels its accept in flight, and that the cancellation is
+// not delivered to the callbacks.
+TEST_P(ListenerImplIoUringTest, DestroyWithAcceptInFlight) {
+  auto listener = std::make_unique<TestListenerImpl>(dispatcher_, socket_, listener_callbacks_,
+                                                     true, false);
+  listener.reset();
+  EXPECT_EQ(1U, ring_->cancels_);
+
+  EXPECT_CALL(listener_callbacks_, onAccept_(_, _)).Times(0);
+  EXPECT_CALL(listener_callbacks_, onAcceptBatch(_, _)).Times(0);
+  ring_->processCompletions();
+}
+
+// Test that a socket accepted but not yet delivered when the listener is destroyed is closed.
+TEST_P(ListenerImplIoUringTest, DestroyWithAcceptCompleted) {
+  auto listener = std::make_unique<TestListenerImpl>(dispatcher_, socket_, listener_callbacks_,
+                                                     true, false);
+  const int fd = completeAccept(lastAcceptor());
+  listener.reset();
+  EXPECT_EQ(0U, ring_->cancels_);
+
+  EXPECT_CALL(listener_callbacks_, onAccept_(_, _)).Times(0);
+  EXPECT_CALL(listener_callbacks_, onAcceptBatch(_, _)).Times(0);
+  ring_->processCompletions();
+  EXPECT_EQ(-1, ::fcntl(fd, F_GETFD));
+  EXPECT_EQ(EBADF, errno);
+}
+
+// Test that destroying a listener waiting for its resume timer neither cancels nor resumes.
+TEST_P(ListenerImplIoUringTest, DestroyWhileWaitingForResume) {
+  auto listener = std::make_unique<TestListenerImpl>(dispatcher_, socket_, listener_callbacks_,
+                                                     true, false, 1);
+  Event::IoUringRequest* acceptor = lastAcceptor();
+  completeAccept(acceptor);
+  EXPECT_CALL(listener_callbacks_, onAccept_(_, _));
+  EXPECT_CALL(listener_callbacks_, onAcceptBatch(1, true));
+  ring_->processCompletions();
+
+  listener.reset();
+  EXPECT_EQ(0U, ring_->cancels_);
+  dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
+  ring_->processCompletions();
+}
+
+// Test that the listener may be destroyed by the callback reporting that the limit was reached.
+TEST_P(ListenerImplIoUringTest, DestroyFromLimitReached) {
+  auto listener = std::make_unique<TestListenerImpl>(dispatcher_, socket_, listener_callbacks_,
+                                                     true, false, 1);
+  completeAccept(lastAcceptor());
+  EXPECT_CALL(listener_callbacks_, onAccept_(_, _));
+  EXPECT_CALL(listener_callbacks_, onAcceptBatch(1, true))
+      .WillOnce(Invoke([&](uint32_t, bool) -> void { listener.reset(); }));
+  ring_->processCompletions();
+
+  EXPECT_EQ(0U, ring_->cancels_);
+  dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
+  ring_->processCompletions();
+}
+
+// Test that a listener waiting for its resume timer may be destroyed by the end of batch callback
+// of another listener, before its own end of batch.
+TEST_P(ListenerImplIoUringTest, DestroyWaitingListenerFromOtherBatch) {
+  Network::TcpListenSocket other_socket(Network::Test::getCanonicalLoopbackAddress(version_),
+                                        nullptr, true);
+  Network::MockListenerCallbacks other_callbacks;
+  TestListenerImpl other(dispatcher_, other_socket, other_callbacks, true, false);
+  Event::IoUringRequest* other_acceptor = lastAcceptor();
+  auto listener = std::make_unique<TestListenerImpl>(dispatcher_, socket_, listener_callbacks_,
+                                                     true, false, 1);
+  Event::IoUringRequest* acceptor = lastAcceptor();
+
+  // The other listener's accept completes first, so that its end of batch comes first.
+  completeAccept(other_acceptor);
+  completeAccept(acceptor);
+  EXPECT_CALL(other_callbacks, onAccept_(_, _));
+  EXPECT_CALL(listener_callbacks_, onAccept_(_, _));
+  EXPECT_CALL(listener_callbacks_, onAcceptBatch(1, true));
+  EXPECT_CALL(other_callbacks, onAcceptBatch(1, false))
+      .WillOnce(Invoke([&](uint32_t, bool) -> void { listener.reset(); }));
+  ring_->processCompletions();
+
+  EXPECT_EQ(0U, ring_->cancels_);
+  ASSERT_NE(nullptr, ring_->inFlight(other_acceptor));
+}
+
 } // namespace Network
 } // namespace Envoy
@@ -0,0 +1,121 @@
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/network/address_impl.h"
+#include "common/network/listen_socket_impl.h"
+#include "common/network/quic_connection_id_routing_socket_option_impl.h"
+#include "common/network/socket_option_factory.h"
+
+#include "test/test_common/environment.h"
+#include "test/test_common/network_utility.h"
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Network {
+namespace {
+
+class QuicConnectionIdRoutingSocketOptionImplTest
+    : public testing::TestWithParam<Address::IpVersion> {
+protected:
+  QuicConnectionIdRoutingSocketOptionImplTest()
+      : client_address_(Network::Test::getCanonicalLoopbackAddress(GetParam())),
+        client_fd_(client_address_->socket(Address::SocketType::Datagram)) {}
+
+  ~QuicConnectionIdRoutingSocketOptionImplTest() { ::close(client_fd_); }
+
+  // Binds sockets of a SO_REUSEPORT group to the same address, routed by connection ID.
+  void bindSockets(uint32_t count) {
+    Socket::OptionsSharedPtr options = std::make_shared<Socket::Options>();
+    Socket::appendOptions(options, SocketOptionFactory::buildReusePortOptions());
+    Socket::appendOptions(options, SocketOptionFactory::buildQuicConnectionIdRoutingOptions(count));
+    Address::InstanceConstSharedPtr address =
+        Network::Test::getCanonicalLoopbackAddress(GetParam());
+    for (uint32_t i = 0; i < count; i++) {
+      sockets_.emplace_back(std::make_unique<UdpListenSocket>(address, options, true));
+      address = sockets_[0]->localAddress();
+      EXPECT_TRUE(Socket::applyOptions(options, *sockets_.back(),
+                                       envoy::api::v2::core::SocketOption::STATE_BOUND));
+    }
+  }
+
+  void send(const std::string& datagram) {
+    const Address::InstanceConstSharedPtr& address = sockets_[0]->localAddress();
+    EXPECT_EQ(static_cast<ssize_t>(datagram.size()),
+              ::sendto(client_fd_, datagram.data(), datagram.size(), 0, address->sockAddr(),
+                       address->sockAddrLen()));
+  }
+
+  // @return the index of the socket which received the datagram, or -1 if none did.
+  int receivingSocket() {
+    std::vector<pollfd> fds;
+    for (const auto& socket : sockets_) {
+      fds.push_back({socket->fd(), POLLIN, 0});
+    }
+    if (::poll(fds.data(), fds.size(), 1000) != 1) {
+      return -1;
+    }
+    for (uint32_t i = 0; i < fds.size(); i++) {
+      if (fds[i].revents & POLLIN) {
+        char data[64];
+        EXPECT_LT(0, ::recv(fds[i].fd, data, sizeof(data), 0));
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  Address::InstanceConstSharedPtr client_address_;
+  int client_fd_;
+  std::vector<std::unique_ptr<UdpListenSocket>> sockets_;
+};
+
+INSTANTIATE_TEST_CASE_P(IpVersions, QuicConnectionIdRoutingSocketOptionImplTest,
+                        testing::ValuesIn(TestEnvironment::getIpVersionsForTest()),
+                        TestUtility::ipTestParamsToString);
+
+// The option only applies once the socket is bound.
+TEST_P(QuicConnectionIdRoutingSocketOptionImplTest, OnlyBound) {
+  QuicConnectionIdRoutingSocketOptionImpl option(2);
+  UdpListenSocket socket(Network::Test::getCanonicalLoopbackAddress(GetParam()), nullptr, false);
+  EXPECT_TRUE(option.setOption(socket, envoy::api::v2::core::SocketOption::STATE_PREBIND));
+  EXPECT_TRUE(option.setOption(socket, envoy::api::v2::core::SocketOption::STATE_LISTENING));
+}
+
+// Datagrams go to the socket selected by their connection ID, in short and long header packets.
+TEST_P(QuicConnectionIdRoutingSocketOptionImplTest, RoutesByConnectionId) {
+  if (!QuicConnectionIdRoutingSocketOptionImpl(1).isSupported()) {
+    return;
+  }
+  bindSockets(3);
+
+  // Short header: flags, then the connection ID.
+  send(std::string("\x40\x00\x00\x00\x01\xff\xff\xff\xff", 9));
+  EXPECT_EQ(1, receivingSocket());
+  send(std::string("\x40\x00\x00\x01\x02\xff\xff\xff\xff", 9));
+  EXPECT_EQ(0x0102 % 3, receivingSocket());
+
+  // Long header: flags, version and connection ID length, then the connection ID.
+  send(std::string("\xc0\xff\x00\x00\x17\x08\x00\x00\x00\x02\xff\xff\xff\xff", 14));
+  EXPECT_EQ(2, receivingSocket());
+
+  // The same connection ID from another peer address goes to the same socket.
+  ::close(client_fd_);
+  client_fd_ = client_address_->socket(Address::SocketType::Datagram);
+  send(std::string("\x40\x00\x00\x00\x01\xff\xff\xff\xff", 9));
+  EXPECT_EQ(1, receivingSocket());
+
+  // Datagrams too short for a connection ID go to the first socket.
+  send(std::string("\x40\x00", 2));
+  EXPECT_EQ(0, receivingSocket());
+}
+
+} // namespace
+} // namespace Network
+} // namespace Envoy
@@ -0,0 +1,118 @@
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/network/raw_buffer_socket.h"
+
+#include "test/mocks/network/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::Return;
+
+namespace Envoy {
+namespace Network {
+namespace {
+
+class RawBufferSocketTest : public testing::Test {
+public:
+  RawBufferSocketTest() {
+    RELEASE_ASSERT(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds_) == 0, "");
+    // Make sure the peer can queue a whole test payload without blocking.
+    const int buffer_size = 1024 * 1024;
+    setsockopt(fds_[1], SOL_SOCKET, SO_SNDBUF, &buffer_size, sizeof(buffer_size));
+    setsockopt(fds_[0], SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+    ON_CALL(callbacks_, fd()).WillByDefault(Return(fds_[0]));
+    ON_CALL(callbacks_, connection()).WillByDefault(testing::ReturnRef(callbacks_.connection_));
+  }
+
+  ~RawBufferSocketTest() {
+    close(fds_[0]);
+    close(fds_[1]);
+  }
+
+  void writePeer(uint64_t size) {
+    const std::string data(size, 'a');
+    ASSERT_EQ(static_cast<ssize_t>(size), ::write(fds_[1], data.data(), data.size()));
+  }
+
+  int fds_[2];
+  testing::NiceMock<MockTransportSocketCallbacks> callbacks_;
+};
+
+TEST_F(RawBufferSocketTest, FixedReadSizeByDefault) {
+  RawBufferSocket socket;
+  socket.setTransportSocketCallbacks(callbacks_);
+  EXPECT_EQ(ReadSizing::DefaultReadSize, socket.readSize());
+
+  writePeer(64 * 1024);
+  Buffer::OwnedImpl buffer;
+  IoResult result = socket.doRead(buffer);
+  EXPECT_EQ(PostIoAction::KeepOpen, result.action_);
+  EXPECT_EQ(64 * 1024, result.bytes_processed_);
+  EXPECT_EQ(ReadSizing::DefaultReadSize, socket.readSize());
+
+  writePeer(10);
+  buffer.drain(buffer.length());
+  socket.doRead(buffer);
+  EXPECT_EQ(ReadSizing::DefaultReadSize, socket.readSize());
+}
+
+TEST_F(RawBufferSocketTest, GrowsForBulkReads) {
+  RawBufferSocket socket({4096, 128 * 1024});
+  socket.setTransportSocketCallbacks(callbacks_);
+
+  // Each read fills the requested size, so the read size doubles up to the maximum.
+  writePeer(200 * 1024);
+  Buffer::OwnedImpl buffer;
+  IoResult result = socket.doRead(buffer);
+  EXPECT_EQ(200 * 1024, result.bytes_processed_);
+  EXPECT_EQ(200 * 1024, buffer.length());
+  EXPECT_EQ(128 * 1024, socket.readSize());
+}
+
+TEST_F(RawBufferSocketTest, ShrinksForSmallReads) {
+  RawBufferSocket socket({4096, 128 * 1024});
+  socket.setTransportSocketCallbacks(callbacks_);
+
+  Buffer::OwnedImpl buffer;
+  writePeer(100);
+  socket.doRead(buffer);
+  EXPECT_EQ(8192, socket.readSize());
+  writePeer(100);
+  socket.doRead(buffer);
+  EXPECT_EQ(4096, socket.readSize());
+  writePeer(100);
+  socket.doRead(buffer);
+  EXPECT_EQ(4096, socket.readSize());
+  EXPECT_EQ(300, buffer.length());
+}
+
+TEST_F(RawBufferSocketTest, InitialReadSizeClamped) {
+  RawBufferSocket small({1024, 2048});
+  EXPECT_EQ(2048, small.readSize());
+  RawBufferSocket large({32 * 1024, 64 * 1024});
+  EXPECT_EQ(32 * 1024, large.readSize());
+}
+
+TEST_F(RawBufferSocketTest, FactoryPassesReadSizing) {
+  RawBufferSocketFactory factory({1024, 2048});
+  TransportSocketPtr socket = factory.createTransportSocket();
+  EXPECT_EQ(2048, dynamic_cast<RawBufferSocket&>(*socket).readSize());
+}
+
+TEST_F(RawBufferSocketTest, RemoteClose) {
+  RawBufferSocket socket;
+  socket.setTransportSocketCallbacks(callbacks_);
+  writePeer(10);
+  shutdown(fds_[1], SHUT_WR);
+  Buffer::OwnedImpl buffer;
+  IoResult result = socket.doRead(buffer);
+  EXPECT_EQ(10, result.bytes_processed_);
+  EXPECT_TRUE(result.end_stream_read_);
+}
+
+} // namespace
+} // namespace Network
+} // namespace Envoy
@@ -0,0 +1,104 @@
+// Usage: bazel run //test/common/network:server_name_trie_speed_test
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/common/fmt.h"
+#include "common/network/server_name_trie.h"
+
+#include "testing/base/public/benchmark.h"
+
+namespace Envoy {
+namespace Network {
+namespace {
+
+// num_names server names of tenants, a quarter of which are wildcard domains.
+std::vector<std::string> makeServerNames(int64_t num_names) {
+  std::vector<std::string> names;
+  for (int64_t i = 0; i < num_names; i++) {
+    names.push_back(
+        fmt::format(i % 4 == 0 ? "*.tenant-{}.example.com" : "www.tenant-{}.example.com", i));
+  }
+  return names;
+}
+
+// Requested names alternating between exact and wildcard matches.
+std::vector<std::string> makeRequestedNames(int64_t num_names) {
+  std::vector<std::string> names;
+  for (int64_t i = 0; i < 64; i++) {
+    const int64_t tenant = (i * 7919) % num_names;
+    names.push_back(fmt::format(tenant % 4 == 0 ? "api.tenant-{}.example.com"
+                                                : "www.tenant-{}.example.com",
+                                tenant));
+  }
+  return names;
+}
+
+// Baseline: a map holding both exact names and wildcard domains without the leading "*", in which
+// the wildcard domains are looked up by building every suffix of the requested name.
+void BM_ServerNameMapLookup(benchmark::State& state) {
+  std::unordered_map<std::string, uint64_t> map;
+  const std::vector<std::string> names = makeServerNames(state.range(0));
+  for (uint64_t i = 0; i < names.size(); i++) {
+    map[names[i][0] == '*' ? names[i].substr(1) : names[i]] = i;
+  }
+  const std::vector<std::string> requested_names = makeRequestedNames(state.range(0));
+
+  size_t i = 0;
+  uint64_t matches = 0;
+  for (auto _ : state) {
+    const std::string server_name(requested_names[i++ % requested_names.size()]);
+    auto match = map.find(server_name);
+    size_t pos = server_name.find('.', 1);
+    while (match == map.end() && pos < server_name.size() - 1 && pos != std::string::npos) {
+      match = map.find(server_name.substr(pos));
+      pos = server_name.find('.', pos + 1);
+    }
+    matches += match != map.end();
+  }
+  benchmark::DoNotOptimize(matches);
+}
+BENCHMARK(BM_ServerNameMapLookup)->Arg(10)->Arg(1000)->Arg(10000)->Arg(40000);
+
+void BM_ServerNameTrieLookup(benchmark::State& state) {
+  ServerNameTrie<uint64_t> trie;
+  const std::vector<std::string> names = makeServerNames(state.range(0));
+  for (uint64_t i = 0; i < names.size(); i++) {
+    trie.emplace(names[i]) = i;
+  }
+  const std::vector<std::string> requested_names = makeRequestedNames(state.range(0));
+
+  size_t i = 0;
+  uint64_t matches = 0;
+  for (auto _ : state) {
+    matches += trie.find(requested_names[i++ % requested_names.size()]) != nullptr;
+  }
+  benchmark::DoNotOptimize(matches);
+}
+BENCHMARK(BM_ServerNameTrieLookup)->Arg(10)->Arg(1000)->Arg(10000)->Arg(40000);
+
+void BM_ServerNameTrieConstruct(benchmark::State& state) {
+  const std::vector<std::string> names = makeServerNames(state.range(0));
+  for (auto _ : state) {
+    ServerNameTrie<uint64_t> trie;
+    for (uint64_t i = 0; i < names.size(); i++) {
+      trie.emplace(names[i]) = i;
+    }
+    benchmark::DoNotOptimize(trie.find(names.back()));
+  }
+}
+BENCHMARK(BM_ServerNameTrieConstruct)->Arg(10)->Arg(1000)->Arg(40000);
+
+} // namespace
+} // namespace Network
+} // namespace Envoy
+
+// Boilerplate main(), which discovers benchmarks in the same file and runs them.
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+}
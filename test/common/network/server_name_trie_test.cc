@@ -0,0 +1,90 @@
+#include <string>
+
+#include "common/network/server_name_trie.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Network {
+
+class ServerNameTrieTest : public testing::Test {
+public:
+  void add(const std::string& name) { trie_.emplace(name) = name; }
+
+  std::string find(const std::string& name) const {
+    const std::string* match = trie_.find(name);
+    return match != nullptr ? *match : "";
+  }
+
+  ServerNameTrie<std::string> trie_;
+};
+
+TEST_F(ServerNameTrieTest, Empty) {
+  EXPECT_EQ("", find(""));
+  EXPECT_EQ("", find("www.example.com"));
+}
+
+TEST_F(ServerNameTrieTest, ExactMatch) {
+  add("www.example.com");
+  add("example.com");
+
+  EXPECT_EQ("www.example.com", find("www.example.com"));
+  EXPECT_EQ("example.com", find("example.com"));
+  EXPECT_EQ("", find("com"));
+  EXPECT_EQ("", find("api.example.com"));
+  EXPECT_EQ("", find("www.example.org"));
+  EXPECT_EQ("", find(""));
+}
+
+TEST_F(ServerNameTrieTest, CaseInsensitive) {
+  add("www.Example.com");
+  add("*.EXAMPLE.org");
+
+  EXPECT_EQ("www.Example.com", find("WWW.example.COM"));
+  EXPECT_EQ("*.EXAMPLE.org", find("www.example.ORG"));
+}
+
+TEST_F(ServerNameTrieTest, WildcardMatch) {
+  add("*.example.com");
+  add("*.com");
+
+  EXPECT_EQ("*.example.com", find("www.example.com"));
+  EXPECT_EQ("*.example.com", find("www.eu.example.com"));
+  // A wildcard domain requires at least one more label.
+  EXPECT_EQ("*.com", find("example.com"));
+  EXPECT_EQ("", find("com"));
+  EXPECT_EQ("*.com", find("www.example2.com"));
+  EXPECT_EQ("", find("www.example.org"));
+}
+
+TEST_F(ServerNameTrieTest, ExactMatchPreferredToWildcardMatch) {
+  add("*.example.com");
+  add("www.example.com");
+  add("example.com");
+
+  EXPECT_EQ("www.example.com", find("www.example.com"));
+  EXPECT_EQ("example.com", find("example.com"));
+  EXPECT_EQ("*.example.com", find("api.example.com"));
+  EXPECT_EQ("*.example.com", find("api.www.example.com"));
+}
+
+TEST_F(ServerNameTrieTest, EmptyLabels) {
+  add("*.example.com");
+
+  EXPECT_EQ("*.example.com", find(".example.com"));
+  EXPECT_EQ("", find("example.com."));
+  EXPECT_EQ("", find("www.example..com"));
+  EXPECT_EQ("", find("."));
+}
+
+TEST_F(ServerNameTrieTest, StableData) {
+  std::string& data = trie_.emplace("www.example.com");
+  for (int i = 0; i < 1000; i++) {
+    add(std::to_string(i) + ".example.com");
+  }
+  EXPECT_EQ(&data, &trie_.emplace("www.example.com"));
+  EXPECT_EQ(&data, trie_.find("www.example.com"));
+}
+
+} // namespace Network
+} // namespace Envoy
@@ -0,0 +1,134 @@
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/network/address_impl.h"
+#include "common/network/listen_socket_impl.h"
+#include "common/network/udp_listener_impl.h"
+
+#include "test/mocks/network/mocks.h"
+#include "test/test_common/environment.h"
+#include "test/test_common/network_utility.h"
+#include "test/test_common/test_time.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::Invoke;
+
+namespace Envoy {
+namespace Network {
+
+class UdpListenerImplTest : public testing::TestWithParam<Address::IpVersion> {
+protected:
+  UdpListenerImplTest()
+      : version_(GetParam()), dispatcher_(test_time_.timeSystem()),
+        socket_(Network::Test::getCanonicalLoopbackAddress(version_), nullptr, true),
+        listener_(dispatcher_, socket_, listener_callbacks_),
+        client_address_(Network::Test::getCanonicalLoopbackAddress(version_)),
+        client_fd_(client_address_->socket(Address::SocketType::Datagram)) {
+    EXPECT_EQ(0, client_address_->bind(client_fd_).rc_);
+    client_address_ = Address::addressFromFd(client_fd_);
+  }
+
+  ~UdpListenerImplTest() { ::close(client_fd_); }
+
+  void clientSend(const std::string& payload) {
+    EXPECT_EQ(static_cast<ssize_t>(payload.size()),
+              ::sendto(client_fd_, payload.data(), payload.size(), 0,
+                       socket_.localAddress()->sockAddr(), socket_.localAddress()->sockAddrLen()));
+  }
+
+  std::string clientReceive() {
+    char data[UdpListenerImpl::MaxDatagramSize];
+    ssize_t rc;
+    do {
+      dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
+      rc = ::recv(client_fd_, data, sizeof(data), MSG_DONTWAIT);
+    } while (rc < 0 && errno == EAGAIN);
+    EXPECT_LE(0, rc);
+    return std::string(data, rc);
+  }
+
+  const Address::IpVersion version_;
+  DangerousDeprecatedTestTime test_time_;
+  Event::DispatcherImpl dispatcher_;
+  UdpListenSocket socket_;
+  MockUdpListenerCallbacks listener_callbacks_;
+  UdpListenerImpl listener_;
+  Address::InstanceConstSharedPtr client_address_;
+  const int client_fd_;
+};
+
+INSTANTIATE_TEST_CASE_P(IpVersions, UdpListenerImplTest,
+                        testing::ValuesIn(TestEnvironment::getIpVersionsForTest()),
+                        TestUtility::ipTestParamsToString);
+
+// Datagrams are passed to the callbacks with their peer and local addresses, and replies sent from
+// the callbacks reach the peer.
+TEST_P(UdpListenerImplTest, ReceiveAndReply) {
+  EXPECT_CALL(listener_callbacks_, onData(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([&](UdpRecvData& data) -> void {
+        EXPECT_EQ(*client_address_, *data.peer_address_);
+        EXPECT_EQ(*socket_.localAddress(), *data.local_address_);
+        Buffer::OwnedImpl reply("re:" + data.buffer_->toString());
+        listener_.send({*data.peer_address_, reply});
+        EXPECT_EQ(0, reply.length());
+      }));
+  EXPECT_CALL(listener_callbacks_, onReceiveError(_)).Times(0);
+  EXPECT_CALL(listener_callbacks_, onSendError(_)).Times(0);
+
+  clientSend("hello");
+  clientSend("world");
+  EXPECT_EQ("re:hello", clientReceive());
+  EXPECT_EQ("re:world", clientReceive());
+}
+
+// More datagrams than fit in a batch are all delivered, in order.
+TEST_P(UdpListenerImplTest, MultipleBatches) {
+  const uint32_t count = UdpListenerImpl::BatchSize * 2 + 3;
+  uint32_t received = 0;
+  EXPECT_CALL(listener_callbacks_, onData(_))
+      .Times(count)
+      .WillRepeatedly(Invoke([&](UdpRecvData& data) -> void {
+        EXPECT_EQ(std::to_string(received++), data.buffer_->toString());
+        listener_.send({*data.peer_address_, *data.buffer_});
+      }));
+
+  for (uint32_t i = 0; i < count; i++) {
+    clientSend(std::to_string(i));
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    EXPECT_EQ(std::to_string(i), clientReceive());
+  }
+  EXPECT_EQ(count, received);
+}
+
+// Datagrams sent outside of a socket wakeup are written on the next event loop iteration.
+TEST_P(UdpListenerImplTest, SendOutsideOfWakeup) {
+  Buffer::OwnedImpl payload("unsolicited");
+  listener_.send({*client_address_, payload});
+  EXPECT_EQ(0, payload.length());
+  EXPECT_EQ("unsolicited", clientReceive());
+}
+
+// Datagrams larger than the receive buffer are reported as errors instead of being truncated.
+TEST_P(UdpListenerImplTest, OversizedDatagram) {
+  EXPECT_CALL(listener_callbacks_, onReceiveError(EMSGSIZE));
+  EXPECT_CALL(listener_callbacks_, onData(_)).WillOnce(Invoke([&](UdpRecvData& data) -> void {
+    EXPECT_EQ("small", data.buffer_->toString());
+    listener_.send({*data.peer_address_, *data.buffer_});
+  }));
+
+  clientSend(std::string(UdpListenerImpl::MaxDatagramSize + 1, 'a'));
+  clientSend("small");
+  EXPECT_EQ("small", clientReceive());
+}
+
+} // namespace Network
+} // namespace Envoy
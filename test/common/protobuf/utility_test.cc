@@ -183,6 +183,31 @@ TEST(UtilityTest, ValueUtilEqual_ListValues) {
   EXPECT_FALSE(ValueUtil::equal(v1, v4));
 }
 
+// The hash is computed over the serialized message without building the serialization, and must
+// match the hash of the serialization itself, including when it spans several buffers.
+TEST(UtilityTest, MessageUtilHash) {
+  ProtobufWkt::Struct s;
+  EXPECT_EQ(HashUtil::xxHash64(""), MessageUtil::hash(s));
+
+  for (int i = 0; i < 1000; ++i) {
+    (*s.mutable_fields())[fmt::format("key{}", i)].set_string_value(std::string(i % 32, 'v'));
+  }
+  std::string text;
+  {
+    Protobuf::io::StringOutputStream string_stream(&text);
+    Protobuf::io::CodedOutputStream coded_stream(&string_stream);
+    coded_stream.SetSerializationDeterministic(true);
+    s.SerializeToCodedStream(&coded_stream);
+  }
+  EXPECT_GT(text.size(), 4096);
+  EXPECT_EQ(HashUtil::xxHash64(text), MessageUtil::hash(s));
+
+  ProtobufWkt::Struct other(s);
+  EXPECT_EQ(MessageUtil::hash(s), MessageUtil::hash(other));
+  (*other.mutable_fields())["key0"].set_string_value("changed");
+  EXPECT_NE(MessageUtil::hash(s), MessageUtil::hash(other));
+}
+
 TEST(UtilityTest, ValueUtilHash) {
   ProtobufWkt::Value v;
   v.set_string_value("s1");
@@ -73,7 +73,7 @@ TEST_P(RateLimitGrpcClientTest, Basic) {
     setClient(use_data_plane_proto);
     envoy::service::ratelimit::v2::RateLimitRequest request;
     Http::HeaderMapImpl headers;
-    GrpcClientImpl::createRequest(request, "foo", {{{{"foo", "bar"}}}});
+    GrpcClientImpl::createRequest(request, "foo", {{{{"foo", "bar"}}}}, 1);
     EXPECT_CALL(*async_client_, send(_, ProtoEq(request), Ref(*client_), _, _))
         .WillOnce(
             Invoke([this, use_data_plane_proto](
@@ -89,7 +89,8 @@ TEST_P(RateLimitGrpcClientTest, Basic) {
               return &async_request_;
             }));
 
-    client_->limit(request_callbacks_, "foo", {{{{"foo", "bar"}}}}, Tracing::NullSpan::instance());
+    client_->limit(request_callbacks_, "foo", {{{{"foo", "bar"}}}}, Tracing::NullSpan::instance(),
+                   1);
 
     client_->onCreateInitialMetadata(headers);
     EXPECT_EQ(nullptr, headers.RequestId());
@@ -104,12 +105,12 @@ TEST_P(RateLimitGrpcClientTest, Basic) {
   {
     envoy::service::ratelimit::v2::RateLimitRequest request;
     Http::HeaderMapImpl headers;
-    GrpcClientImpl::createRequest(request, "foo", {{{{"foo", "bar"}, {"bar", "baz"}}}});
+    GrpcClientImpl::createRequest(request, "foo", {{{{"foo", "bar"}, {"bar", "baz"}}}}, 1);
     EXPECT_CALL(*async_client_, send(_, ProtoEq(request), _, _, _))
         .WillOnce(Return(&async_request_));
 
     client_->limit(request_callbacks_, "foo", {{{{"foo", "bar"}, {"bar", "baz"}}}},
-                   Tracing::NullSpan::instance());
+                   Tracing::NullSpan::instance(), 1);
 
     client_->onCreateInitialMetadata(headers);
 
@@ -124,13 +125,14 @@ TEST_P(RateLimitGrpcClientTest, Basic) {
     envoy::service::ratelimit::v2::RateLimitRequest request;
     GrpcClientImpl::createRequest(
         request, "foo",
-        {{{{"foo", "bar"}, {"bar", "baz"}}}, {{{"foo2", "bar2"}, {"bar2", "baz2"}}}});
+        {{{{"foo", "bar"}, {"bar", "baz"}}}, {{{"foo2", "bar2"}, {"bar2", "baz2"}}}}, 10);
+    EXPECT_EQ(10, request.hits_addend());
     EXPECT_CALL(*async_client_, send(_, ProtoEq(request), _, _, _))
         .WillOnce(Return(&async_request_));
 
     client_->limit(request_callbacks_, "foo",
                    {{{{"foo", "bar"}, {"bar", "baz"}}}, {{{"foo2", "bar2"}, {"bar2", "baz2"}}}},
-                   Tracing::NullSpan::instance());
+                   Tracing::NullSpan::instance(), 10);
 
     response.reset(new envoy::service::ratelimit::v2::RateLimitResponse());
     EXPECT_CALL(request_callbacks_, complete_(LimitStatus::Error, _));
@@ -144,7 +146,7 @@ TEST_P(RateLimitGrpcClientTest, Cancel) {
 
   EXPECT_CALL(*async_client_, send(_, _, _, _, _)).WillOnce(Return(&async_request_));
 
-  client_->limit(request_callbacks_, "foo", {{{{"foo", "bar"}}}}, Tracing::NullSpan::instance());
+  client_->limit(request_callbacks_, "foo", {{{{"foo", "bar"}}}}, Tracing::NullSpan::instance(), 1);
 
   EXPECT_CALL(async_request_, cancel());
   client_->cancel();
@@ -186,7 +188,7 @@ TEST(RateLimitNullFactoryTest, Basic) {
   ClientPtr client = factory.create(absl::optional<std::chrono::milliseconds>());
   MockRequestCallbacks request_callbacks;
   EXPECT_CALL(request_callbacks, complete_(LimitStatus::OK, _));
-  client->limit(request_callbacks, "foo", {{{{"foo", "bar"}}}}, Tracing::NullSpan::instance());
+  client->limit(request_callbacks, "foo", {{{{"foo", "bar"}}}}, Tracing::NullSpan::instance(), 1);
   client->cancel();
 }
 
@@ -155,6 +155,8 @@ TEST(RequestInfoImplTest, MiscSettersAndGetters) {
 
 TEST(RequestInfoImplTest, DynamicMetadataTest) {
   RequestInfoImpl request_info(Http::Protocol::Http2);
+  // Nothing is allocated until metadata is set.
+  EXPECT_EQ(&envoy::api::v2::core::Metadata::default_instance(), &request_info.dynamicMetadata());
   EXPECT_EQ(0, request_info.dynamicMetadata().filter_metadata_size());
   request_info.setDynamicMetadata("com.test",
                                   MessageUtil::keyValueStruct("test_key", "test_value"));
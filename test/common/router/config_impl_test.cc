@@ -7,11 +7,13 @@
 
 #include "envoy/server/filter_config.h"
 
+#include "common/buffer/buffer_impl.h"
 #include "common/config/metadata.h"
 #include "common/config/rds_json.h"
 #include "common/config/well_known_names.h"
 #include "common/http/header_map_impl.h"
 #include "common/http/headers.h"
+#include "common/http/request_attributes_impl.h"
 #include "common/json/json_loader.h"
 #include "common/network/address_impl.h"
 #include "common/router/config_impl.h"
@@ -560,6 +562,115 @@ virtual_hosts:
             config.route(genHeaders("example.com", "/", "GET"), 0)->routeEntry()->clusterName());
 }
 
+// Validate that the first route to match wins regardless of how its path matcher is indexed.
+TEST(RouteMatcherTest, TestRouteOrderAcrossMatchers) {
+  std::string yaml = R"EOF(
+virtual_hosts:
+  - name: default
+    domains: ["*"]
+    routes:
+      - match:
+          prefix: "/api"
+          headers:
+            - name: x-canary
+        route: { cluster: "canary" }
+      - match: { regex: "/api/v[0-9]+/.*" }
+        route: { cluster: "versioned" }
+      - match: { path: "/API/V1/STATUS", case_sensitive: false }
+        route: { cluster: "status" }
+      - match: { prefix: "/api/", case_sensitive: false }
+        route: { cluster: "api" }
+      - match: { path: "/api/v1/status" }
+        route: { cluster: "unreachable" }
+      - match: { prefix: "/" }
+        route: { cluster: "default" }
+  )EOF";
+
+  NiceMock<Server::Configuration::MockFactoryContext> factory_context;
+  TestConfigImpl config(parseRouteConfigurationFromV2Yaml(yaml), factory_context, false);
+
+  auto cluster = [&config](const std::string& path) -> std::string {
+    return config.route(genHeaders("example.com", path, "GET"), 0)->routeEntry()->clusterName();
+  };
+  EXPECT_EQ("versioned", cluster("/api/v1/status"));
+  EXPECT_EQ("status", cluster("/Api/v1/Status?verbose"));
+  EXPECT_EQ("api", cluster("/API/users"));
+  EXPECT_EQ("default", cluster("/apis"));
+  EXPECT_EQ("default", cluster("/"));
+
+  Http::TestHeaderMapImpl headers = genHeaders("example.com", "/api/v1/status", "GET");
+  headers.addCopy("x-canary", "true");
+  EXPECT_EQ("canary", config.route(headers, 0)->routeEntry()->clusterName());
+}
+
+TEST(RouteMatcherTest, TestSafeRegexRoutesAndVirtualClusters) {
+  std::string yaml = R"EOF(
+virtual_hosts:
+  - name: regex
+    domains: ["*"]
+    routes:
+      - match:
+          safe_regex:
+            google_re2: {}
+            regex: "/rides/\\d+"
+        route: { cluster: "rides" }
+      - match: { prefix: "/" }
+        route: { cluster: "default" }
+    virtual_clusters:
+      - safe_pattern:
+          google_re2: {}
+          regex: "/rides/\\d+"
+        method: POST
+        name: ride_create
+      - safe_pattern:
+          google_re2: {}
+          regex: "/rides/.*"
+        name: rides
+      - safe_pattern:
+          google_re2: {}
+          regex: "/users/\\d+\\?.*"
+        name: users
+  )EOF";
+
+  NiceMock<Server::Configuration::MockFactoryContext> factory_context;
+  TestConfigImpl config(parseRouteConfigurationFromV2Yaml(yaml), factory_context, false);
+
+  EXPECT_EQ("rides", config.route(genHeaders("example.com", "/rides/123?x=1", "GET"), 0)
+                         ->routeEntry()
+                         ->clusterName());
+  EXPECT_EQ("default", config.route(genHeaders("example.com", "/rides/123/456", "GET"), 0)
+                           ->routeEntry()
+                           ->clusterName());
+
+  auto virtual_cluster = [&config](const std::string& path, const std::string& method) {
+    Http::TestHeaderMapImpl headers = genHeaders("example.com", path, method);
+    return config.route(headers, 0)->routeEntry()->virtualCluster(headers)->name();
+  };
+  EXPECT_EQ("ride_create", virtual_cluster("/rides/123", "POST"));
+  EXPECT_EQ("rides", virtual_cluster("/rides/123", "GET"));
+  EXPECT_EQ("rides", virtual_cluster("/rides/123?x=1", "POST"));
+  EXPECT_EQ("users", virtual_cluster("/users/1?x=1", "GET"));
+  EXPECT_EQ("other", virtual_cluster("/users/1", "GET"));
+}
+
+TEST(RouteMatcherTest, TestVirtualClusterWithoutPattern) {
+  std::string yaml = R"EOF(
+virtual_hosts:
+  - name: regex
+    domains: ["*"]
+    routes:
+      - match: { prefix: "/" }
+        route: { cluster: "default" }
+    virtual_clusters:
+      - name: missing
+  )EOF";
+
+  NiceMock<Server::Configuration::MockFactoryContext> factory_context;
+  EXPECT_THROW_WITH_MESSAGE(
+      TestConfigImpl(parseRouteConfigurationFromV2Yaml(yaml), factory_context, false),
+      EnvoyException, "virtual cluster 'missing' must specify a pattern or safe_pattern");
+}
+
 TEST(RouteMatcherTest, TestRoutesWithInvalidRegex) {
   std::string invalid_route = R"EOF(
 virtual_hosts:
@@ -1396,6 +1507,7 @@ public:
   NiceMock<Server::Configuration::MockFactoryContext> factory_context_;
   envoy::api::v2::RouteConfiguration route_config_;
   HashPolicy::AddCookieCallback add_cookie_nop_;
+  Http::RequestAttributesImpl request_attributes_;
 
 private:
   std::unique_ptr<TestConfigImpl> config_;
@@ -1406,14 +1518,15 @@ TEST_F(RouterMatcherHashPolicyTest, HashHeaders) {
   {
     Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/foo", "GET");
     Router::RouteConstSharedPtr route = config().route(headers, 0);
-    EXPECT_FALSE(
-        route->routeEntry()->hashPolicy()->generateHash(nullptr, headers, add_cookie_nop_));
+    EXPECT_FALSE(route->routeEntry()->hashPolicy()->generateHash(
+        nullptr, headers, request_attributes_, add_cookie_nop_));
   }
   {
     Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/foo", "GET");
     headers.addCopy("foo_header", "bar");
     Router::RouteConstSharedPtr route = config().route(headers, 0);
-    EXPECT_TRUE(route->routeEntry()->hashPolicy()->generateHash(nullptr, headers, add_cookie_nop_));
+    EXPECT_TRUE(route->routeEntry()->hashPolicy()->generateHash(
+        nullptr, headers, request_attributes_, add_cookie_nop_));
   }
   {
     Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/bar", "GET");
@@ -1434,23 +1547,24 @@ TEST_F(RouterMatcherCookieHashPolicyTest, NoTtl) {
     // With no cookie, no hash is generated.
     Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/foo", "GET");
     Router::RouteConstSharedPtr route = config().route(headers, 0);
-    EXPECT_FALSE(
-        route->routeEntry()->hashPolicy()->generateHash(nullptr, headers, add_cookie_nop_));
+    EXPECT_FALSE(route->routeEntry()->hashPolicy()->generateHash(
+        nullptr, headers, request_attributes_, add_cookie_nop_));
   }
   {
     // With no matching cookie, no hash is generated.
     Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/foo", "GET");
     headers.addCopy("Cookie", "choco=late; su=gar");
     Router::RouteConstSharedPtr route = config().route(headers, 0);
-    EXPECT_FALSE(
-        route->routeEntry()->hashPolicy()->generateHash(nullptr, headers, add_cookie_nop_));
+    EXPECT_FALSE(route->routeEntry()->hashPolicy()->generateHash(
+        nullptr, headers, request_attributes_, add_cookie_nop_));
   }
   {
     // Matching cookie produces a valid hash.
     Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/foo", "GET");
     headers.addCopy("Cookie", "choco=late; hash=brown");
     Router::RouteConstSharedPtr route = config().route(headers, 0);
-    EXPECT_TRUE(route->routeEntry()->hashPolicy()->generateHash(nullptr, headers, add_cookie_nop_));
+    EXPECT_TRUE(route->routeEntry()->hashPolicy()->generateHash(
+        nullptr, headers, request_attributes_, add_cookie_nop_));
   }
   {
     // The hash policy is per-route.
@@ -1467,15 +1581,19 @@ TEST_F(RouterMatcherCookieHashPolicyTest, DifferentCookies) {
     Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/foo", "GET");
     headers.addCopy("Cookie", "hash=brown");
     Router::RouteConstSharedPtr route = config().route(headers, 0);
-    hash_1 =
-        route->routeEntry()->hashPolicy()->generateHash(nullptr, headers, add_cookie_nop_).value();
+    hash_1 = route->routeEntry()
+                 ->hashPolicy()
+                 ->generateHash(nullptr, headers, request_attributes_, add_cookie_nop_)
+                 .value();
   }
   {
     Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/foo", "GET");
     headers.addCopy("Cookie", "hash=green");
     Router::RouteConstSharedPtr route = config().route(headers, 0);
-    hash_2 =
-        route->routeEntry()->hashPolicy()->generateHash(nullptr, headers, add_cookie_nop_).value();
+    hash_2 = route->routeEntry()
+                 ->hashPolicy()
+                 ->generateHash(nullptr, headers, request_attributes_, add_cookie_nop_)
+                 .value();
   }
   EXPECT_NE(hash_1, hash_2);
 }
@@ -1493,20 +1611,23 @@ TEST_F(RouterMatcherCookieHashPolicyTest, TtlSet) {
     Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/foo", "GET");
     Router::RouteConstSharedPtr route = config().route(headers, 0);
     EXPECT_CALL(mock_cookie_cb, Call("hash", "", 42));
-    EXPECT_TRUE(route->routeEntry()->hashPolicy()->generateHash(nullptr, headers, add_cookie));
+    EXPECT_TRUE(route->routeEntry()->hashPolicy()->generateHash(
+        nullptr, headers, request_attributes_, add_cookie));
   }
   {
     Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/foo", "GET");
     headers.addCopy("Cookie", "choco=late; su=gar");
     Router::RouteConstSharedPtr route = config().route(headers, 0);
     EXPECT_CALL(mock_cookie_cb, Call("hash", "", 42));
-    EXPECT_TRUE(route->routeEntry()->hashPolicy()->generateHash(nullptr, headers, add_cookie));
+    EXPECT_TRUE(route->routeEntry()->hashPolicy()->generateHash(
+        nullptr, headers, request_attributes_, add_cookie));
   }
   {
     Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/foo", "GET");
     headers.addCopy("Cookie", "choco=late; hash=brown");
     Router::RouteConstSharedPtr route = config().route(headers, 0);
-    EXPECT_TRUE(route->routeEntry()->hashPolicy()->generateHash(nullptr, headers, add_cookie));
+    EXPECT_TRUE(route->routeEntry()->hashPolicy()->generateHash(
+        nullptr, headers, request_attributes_, add_cookie));
   }
   {
     uint64_t hash_1, hash_2;
@@ -1514,15 +1635,19 @@ TEST_F(RouterMatcherCookieHashPolicyTest, TtlSet) {
       Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/foo", "GET");
       Router::RouteConstSharedPtr route = config().route(headers, 0);
       EXPECT_CALL(mock_cookie_cb, Call("hash", "", 42)).WillOnce(Return("AAAAAAA"));
-      hash_1 =
-          route->routeEntry()->hashPolicy()->generateHash(nullptr, headers, add_cookie).value();
+      hash_1 = route->routeEntry()
+                   ->hashPolicy()
+                   ->generateHash(nullptr, headers, request_attributes_, add_cookie)
+                   .value();
     }
     {
       Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/foo", "GET");
       Router::RouteConstSharedPtr route = config().route(headers, 0);
       EXPECT_CALL(mock_cookie_cb, Call("hash", "", 42)).WillOnce(Return("BBBBBBB"));
-      hash_2 =
-          route->routeEntry()->hashPolicy()->generateHash(nullptr, headers, add_cookie).value();
+      hash_2 = route->routeEntry()
+                   ->hashPolicy()
+                   ->generateHash(nullptr, headers, request_attributes_, add_cookie)
+                   .value();
     }
     EXPECT_NE(hash_1, hash_2);
   }
@@ -1546,7 +1671,8 @@ TEST_F(RouterMatcherCookieHashPolicyTest, SetSessionCookie) {
     Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/foo", "GET");
     Router::RouteConstSharedPtr route = config().route(headers, 0);
     EXPECT_CALL(mock_cookie_cb, Call("hash", "", 0));
-    EXPECT_TRUE(route->routeEntry()->hashPolicy()->generateHash(nullptr, headers, add_cookie));
+    EXPECT_TRUE(route->routeEntry()->hashPolicy()->generateHash(
+        nullptr, headers, request_attributes_, add_cookie));
   }
 }
 
@@ -1564,7 +1690,8 @@ TEST_F(RouterMatcherCookieHashPolicyTest, SetCookiePath) {
     Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/foo", "GET");
     Router::RouteConstSharedPtr route = config().route(headers, 0);
     EXPECT_CALL(mock_cookie_cb, Call("hash", "/", 0));
-    EXPECT_TRUE(route->routeEntry()->hashPolicy()->generateHash(nullptr, headers, add_cookie));
+    EXPECT_TRUE(route->routeEntry()->hashPolicy()->generateHash(
+        nullptr, headers, request_attributes_, add_cookie));
   }
 }
 
@@ -1574,14 +1701,14 @@ TEST_F(RouterMatcherHashPolicyTest, HashIp) {
   {
     Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/foo", "GET");
     Router::RouteConstSharedPtr route = config().route(headers, 0);
-    EXPECT_FALSE(
-        route->routeEntry()->hashPolicy()->generateHash(nullptr, headers, add_cookie_nop_));
+    EXPECT_FALSE(route->routeEntry()->hashPolicy()->generateHash(
+        nullptr, headers, request_attributes_, add_cookie_nop_));
   }
   {
     Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/foo", "GET");
     Router::RouteConstSharedPtr route = config().route(headers, 0);
-    EXPECT_TRUE(
-        route->routeEntry()->hashPolicy()->generateHash(&valid_address, headers, add_cookie_nop_));
+    EXPECT_TRUE(route->routeEntry()->hashPolicy()->generateHash(
+        &valid_address, headers, request_attributes_, add_cookie_nop_));
   }
   {
     Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/foo", "GET");
@@ -1589,14 +1716,16 @@ TEST_F(RouterMatcherHashPolicyTest, HashIp) {
                             .route(headers, 0)
                             ->routeEntry()
                             ->hashPolicy()
-                            ->generateHash(&valid_address, headers, add_cookie_nop_)
+                            ->generateHash(&valid_address, headers, request_attributes_,
+                                           add_cookie_nop_)
                             .value();
     headers.addCopy("foo_header", "bar");
     EXPECT_EQ(old_hash, config()
                             .route(headers, 0)
                             ->routeEntry()
                             ->hashPolicy()
-                            ->generateHash(&valid_address, headers, add_cookie_nop_)
+                            ->generateHash(&valid_address, headers, request_attributes_,
+                                           add_cookie_nop_)
                             .value());
   }
   {
@@ -1614,8 +1743,8 @@ TEST_F(RouterMatcherHashPolicyTest, HashIpNonIpAddress) {
     ON_CALL(bad_ip_address, ip()).WillByDefault(Return(nullptr));
     Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/foo", "GET");
     Router::RouteConstSharedPtr route = config().route(headers, 0);
-    EXPECT_FALSE(
-        route->routeEntry()->hashPolicy()->generateHash(&bad_ip_address, headers, add_cookie_nop_));
+    EXPECT_FALSE(route->routeEntry()->hashPolicy()->generateHash(
+        &bad_ip_address, headers, request_attributes_, add_cookie_nop_));
   }
   {
     const std::string empty;
@@ -1623,8 +1752,8 @@ TEST_F(RouterMatcherHashPolicyTest, HashIpNonIpAddress) {
     ON_CALL(bad_ip, addressAsString()).WillByDefault(ReturnRef(empty));
     Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/foo", "GET");
     Router::RouteConstSharedPtr route = config().route(headers, 0);
-    EXPECT_FALSE(
-        route->routeEntry()->hashPolicy()->generateHash(&bad_ip_address, headers, add_cookie_nop_));
+    EXPECT_FALSE(route->routeEntry()->hashPolicy()->generateHash(
+        &bad_ip_address, headers, request_attributes_, add_cookie_nop_));
   }
 }
 
@@ -1636,8 +1765,11 @@ TEST_F(RouterMatcherHashPolicyTest, HashIpv4DifferentAddresses) {
     Network::Address::Ipv4Instance second_ip("4.3.2.1");
     Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/foo", "GET");
     const auto hash_policy = config().route(headers, 0)->routeEntry()->hashPolicy();
-    const uint64_t hash_1 = hash_policy->generateHash(&first_ip, headers, add_cookie_nop_).value();
-    const uint64_t hash_2 = hash_policy->generateHash(&second_ip, headers, add_cookie_nop_).value();
+    const uint64_t hash_1 =
+        hash_policy->generateHash(&first_ip, headers, request_attributes_, add_cookie_nop_).value();
+    const uint64_t hash_2 =
+        hash_policy->generateHash(&second_ip, headers, request_attributes_, add_cookie_nop_)
+            .value();
     EXPECT_NE(hash_1, hash_2);
   }
   {
@@ -1646,8 +1778,11 @@ TEST_F(RouterMatcherHashPolicyTest, HashIpv4DifferentAddresses) {
     Network::Address::Ipv4Instance second_ip("1.2.3.4", 1331);
     Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/foo", "GET");
     const auto hash_policy = config().route(headers, 0)->routeEntry()->hashPolicy();
-    const uint64_t hash_1 = hash_policy->generateHash(&first_ip, headers, add_cookie_nop_).value();
-    const uint64_t hash_2 = hash_policy->generateHash(&second_ip, headers, add_cookie_nop_).value();
+    const uint64_t hash_1 =
+        hash_policy->generateHash(&first_ip, headers, request_attributes_, add_cookie_nop_).value();
+    const uint64_t hash_2 =
+        hash_policy->generateHash(&second_ip, headers, request_attributes_, add_cookie_nop_)
+            .value();
     EXPECT_EQ(hash_1, hash_2);
   }
 }
@@ -1660,8 +1795,11 @@ TEST_F(RouterMatcherHashPolicyTest, HashIpv6DifferentAddresses) {
     Network::Address::Ipv6Instance second_ip("::1");
     Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/foo", "GET");
     const auto hash_policy = config().route(headers, 0)->routeEntry()->hashPolicy();
-    const uint64_t hash_1 = hash_policy->generateHash(&first_ip, headers, add_cookie_nop_).value();
-    const uint64_t hash_2 = hash_policy->generateHash(&second_ip, headers, add_cookie_nop_).value();
+    const uint64_t hash_1 =
+        hash_policy->generateHash(&first_ip, headers, request_attributes_, add_cookie_nop_).value();
+    const uint64_t hash_2 =
+        hash_policy->generateHash(&second_ip, headers, request_attributes_, add_cookie_nop_)
+            .value();
     EXPECT_NE(hash_1, hash_2);
   }
   {
@@ -1670,8 +1808,11 @@ TEST_F(RouterMatcherHashPolicyTest, HashIpv6DifferentAddresses) {
     Network::Address::Ipv6Instance second_ip("1:2:3:4:5::", 1331);
     Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/foo", "GET");
     const auto hash_policy = config().route(headers, 0)->routeEntry()->hashPolicy();
-    const uint64_t hash_1 = hash_policy->generateHash(&first_ip, headers, add_cookie_nop_).value();
-    const uint64_t hash_2 = hash_policy->generateHash(&second_ip, headers, add_cookie_nop_).value();
+    const uint64_t hash_1 =
+        hash_policy->generateHash(&first_ip, headers, request_attributes_, add_cookie_nop_).value();
+    const uint64_t hash_2 =
+        hash_policy->generateHash(&second_ip, headers, request_attributes_, add_cookie_nop_)
+            .value();
     EXPECT_EQ(hash_1, hash_2);
   }
 }
@@ -1686,28 +1827,34 @@ TEST_F(RouterMatcherHashPolicyTest, HashMultiple) {
   {
     Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/foo", "GET");
     Router::RouteConstSharedPtr route = config().route(headers, 0);
-    EXPECT_FALSE(
-        route->routeEntry()->hashPolicy()->generateHash(nullptr, headers, add_cookie_nop_));
+    EXPECT_FALSE(route->routeEntry()->hashPolicy()->generateHash(
+        nullptr, headers, request_attributes_, add_cookie_nop_));
   }
   {
     Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/foo", "GET");
     headers.addCopy("foo_header", "bar");
     Router::RouteConstSharedPtr route = config().route(headers, 0);
-    hash_h =
-        route->routeEntry()->hashPolicy()->generateHash(nullptr, headers, add_cookie_nop_).value();
+    hash_h = route->routeEntry()
+                 ->hashPolicy()
+                 ->generateHash(nullptr, headers, request_attributes_, add_cookie_nop_)
+                 .value();
   }
   {
     Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/foo", "GET");
     Router::RouteConstSharedPtr route = config().route(headers, 0);
-    hash_ip =
-        route->routeEntry()->hashPolicy()->generateHash(&address, headers, add_cookie_nop_).value();
+    hash_ip = route->routeEntry()
+                  ->hashPolicy()
+                  ->generateHash(&address, headers, request_attributes_, add_cookie_nop_)
+                  .value();
   }
   {
     Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/foo", "GET");
     Router::RouteConstSharedPtr route = config().route(headers, 0);
     headers.addCopy("foo_header", "bar");
-    hash_both =
-        route->routeEntry()->hashPolicy()->generateHash(&address, headers, add_cookie_nop_).value();
+    hash_both = route->routeEntry()
+                    ->hashPolicy()
+                    ->generateHash(&address, headers, request_attributes_, add_cookie_nop_)
+                    .value();
   }
   {
     Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/foo", "GET");
@@ -1716,7 +1863,7 @@ TEST_F(RouterMatcherHashPolicyTest, HashMultiple) {
     // stability
     EXPECT_EQ(hash_both, route->routeEntry()
                              ->hashPolicy()
-                             ->generateHash(&address, headers, add_cookie_nop_)
+                             ->generateHash(&address, headers, request_attributes_, add_cookie_nop_)
                              .value());
   }
   EXPECT_NE(hash_ip, hash_h);
@@ -1745,7 +1892,7 @@ TEST_F(RouterMatcherHashPolicyTest, HashTerminal) {
     Router::RouteConstSharedPtr route = config().route(headers, 0);
     hash_1 = route->routeEntry()
                  ->hashPolicy()
-                 ->generateHash(&address1, headers, add_cookie_nop_)
+                 ->generateHash(&address1, headers, request_attributes_, add_cookie_nop_)
                  .value();
   }
   {
@@ -1755,7 +1902,7 @@ TEST_F(RouterMatcherHashPolicyTest, HashTerminal) {
     Router::RouteConstSharedPtr route = config().route(headers, 0);
     hash_2 = route->routeEntry()
                  ->hashPolicy()
-                 ->generateHash(&address2, headers, add_cookie_nop_)
+                 ->generateHash(&address2, headers, request_attributes_, add_cookie_nop_)
                  .value();
   }
   EXPECT_EQ(hash_1, hash_2);
@@ -1768,7 +1915,7 @@ TEST_F(RouterMatcherHashPolicyTest, HashTerminal) {
     Router::RouteConstSharedPtr route = config().route(headers, 0);
     hash_1 = route->routeEntry()
                  ->hashPolicy()
-                 ->generateHash(&address1, headers, add_cookie_nop_)
+                 ->generateHash(&address1, headers, request_attributes_, add_cookie_nop_)
                  .value();
   }
   {
@@ -1777,7 +1924,7 @@ TEST_F(RouterMatcherHashPolicyTest, HashTerminal) {
     Router::RouteConstSharedPtr route = config().route(headers, 0);
     hash_2 = route->routeEntry()
                  ->hashPolicy()
-                 ->generateHash(&address2, headers, add_cookie_nop_)
+                 ->generateHash(&address2, headers, request_attributes_, add_cookie_nop_)
                  .value();
   }
   EXPECT_NE(hash_1, hash_2);
@@ -3890,6 +4037,37 @@ TEST(MetadataMatchCriteriaImpl, Merge) {
   EXPECT_EQ((*it)->value().value().string_value(), "override3");
 }
 
+TEST(MetadataMatchCriteriaImpl, Hash) {
+  auto v1 = ProtobufWkt::Value();
+  v1.set_string_value("v1");
+  auto v2 = ProtobufWkt::Value();
+  v2.set_string_value("v2");
+
+  auto parent_struct = ProtobufWkt::Struct();
+  (*parent_struct.mutable_fields())["a"] = v1;
+  auto parent_matches = MetadataMatchCriteriaImpl(parent_struct);
+
+  auto metadata_struct = ProtobufWkt::Struct();
+  (*metadata_struct.mutable_fields())["a"] = v1;
+  (*metadata_struct.mutable_fields())["b"] = v2;
+  auto matches = MetadataMatchCriteriaImpl(metadata_struct);
+  EXPECT_NE(parent_matches.hash(), matches.hash());
+
+  // Criteria built by merging hash the same as criteria built directly.
+  auto child_struct = ProtobufWkt::Struct();
+  (*child_struct.mutable_fields())["b"] = v2;
+  MetadataMatchCriteriaConstPtr merged = parent_matches.mergeMatchCriteria(child_struct);
+  EXPECT_EQ(matches.hash(), merged->hash());
+
+  // Values are part of the hash, as well as names.
+  (*child_struct.mutable_fields())["b"] = v1;
+  EXPECT_NE(matches.hash(), parent_matches.mergeMatchCriteria(child_struct)->hash());
+  auto swapped_struct = ProtobufWkt::Struct();
+  (*swapped_struct.mutable_fields())["a"] = v2;
+  (*swapped_struct.mutable_fields())["b"] = v1;
+  EXPECT_NE(matches.hash(), MetadataMatchCriteriaImpl(swapped_struct).hash());
+}
+
 TEST(RouteEntryMetadataMatchTest, ParsesMetadata) {
   auto route_config = envoy::api::v2::RouteConfiguration();
   auto* vhost = route_config.add_virtual_hosts();
@@ -4083,6 +4261,38 @@ virtual_hosts:
   EXPECT_STREQ("content", direct_response->responseBody().c_str());
 }
 
+// The body of a direct response is added to response buffers by reference, and outlives the
+// route configuration for as long as a buffer references it.
+TEST(RouteConfigurationV2, DirectResponseBodyReference) {
+  std::string yaml = R"EOF(
+name: foo
+virtual_hosts:
+  - name: direct
+    domains: [example.com]
+    routes:
+      - match: { prefix: "/"}
+        direct_response: { status: 200, body: { inline_string: "content" } }
+  )EOF";
+
+  NiceMock<Server::Configuration::MockFactoryContext> factory_context;
+  auto config = std::make_unique<TestConfigImpl>(parseRouteConfigurationFromV2Yaml(yaml),
+                                                 factory_context, true);
+  const auto* direct_response =
+      config->route(genHeaders("example.com", "/", "GET"), 0)->directResponseEntry();
+  Buffer::OwnedImpl buffer1;
+  Buffer::OwnedImpl buffer2;
+  direct_response->addResponseBody(buffer1);
+  direct_response->addResponseBody(buffer2);
+  EXPECT_EQ(buffer1.linearize(7), buffer2.linearize(7));
+  EXPECT_EQ(static_cast<const void*>(direct_response->responseBody().data()),
+            buffer1.linearize(7));
+
+  config.reset();
+  EXPECT_EQ("content", buffer1.toString());
+  buffer1.drain(buffer1.length());
+  EXPECT_EQ("content", buffer2.toString());
+}
+
 // Test the parsing of a direct response configuration where the response body is too large.
 TEST(RouteConfigurationV2, DirectResponseTooLarge) {
   std::string response_body(4097, 'A');
@@ -4150,6 +4360,70 @@ virtual_hosts:
   EXPECT_EQ("foo", route_entry->virtualHost().routeConfig().name());
 }
 
+// Validate that the virtual hosts whose configuration did not change are shared with the previous
+// version of the route configuration.
+TEST(RouteConfigurationV2, ReuseUnchangedVirtualHosts) {
+  const std::string yaml = R"EOF(
+name: foo
+virtual_hosts:
+  - name: foo
+    domains: [foo.com]
+    routes:
+      - match: { prefix: "/"}
+        route: { cluster: foo }
+  - name: bar
+    domains: [bar.com]
+    routes:
+      - match: { prefix: "/"}
+        route: { cluster: bar }
+  )EOF";
+
+  NiceMock<Server::Configuration::MockFactoryContext> factory_context;
+  envoy::api::v2::RouteConfiguration proto_config = parseRouteConfigurationFromV2Yaml(yaml);
+  const ConfigImpl config(proto_config, factory_context, true);
+  const auto foo_route = config.route(genHeaders("foo.com", "/", "GET"), 0);
+  const auto bar_route = config.route(genHeaders("bar.com", "/", "GET"), 0);
+
+  proto_config.mutable_virtual_hosts(1)->mutable_routes(0)->mutable_route()->set_cluster("baz");
+  const ConfigImpl new_config(proto_config, factory_context, true, &config);
+  const auto new_foo_route = new_config.route(genHeaders("foo.com", "/", "GET"), 0);
+  const auto new_bar_route = new_config.route(genHeaders("bar.com", "/", "GET"), 0);
+  EXPECT_EQ(foo_route, new_foo_route);
+  EXPECT_EQ(&foo_route->routeEntry()->virtualHost(), &new_foo_route->routeEntry()->virtualHost());
+  EXPECT_NE(&bar_route->routeEntry()->virtualHost(), &new_bar_route->routeEntry()->virtualHost());
+  EXPECT_EQ("baz", new_bar_route->routeEntry()->clusterName());
+
+  // Virtual hosts are not reused once the rest of the route configuration changes.
+  proto_config.add_internal_only_headers("x-internal");
+  const ConfigImpl newer_config(proto_config, factory_context, true, &new_config);
+  const auto newer_foo_route = newer_config.route(genHeaders("foo.com", "/", "GET"), 0);
+  EXPECT_NE(&foo_route->routeEntry()->virtualHost(),
+            &newer_foo_route->routeEntry()->virtualHost());
+  EXPECT_EQ(
+      1, newer_foo_route->routeEntry()->virtualHost().routeConfig().internalOnlyHeaders().size());
+}
+
+// Validate that the clusters of reused virtual hosts are validated again.
+TEST(RouteConfigurationV2, ReusedVirtualHostsValidateClusters) {
+  const std::string yaml = R"EOF(
+name: foo
+virtual_hosts:
+  - name: foo
+    domains: ["*"]
+    routes:
+      - match: { prefix: "/"}
+        route: { cluster: foo }
+  )EOF";
+
+  NiceMock<Server::Configuration::MockFactoryContext> factory_context;
+  const envoy::api::v2::RouteConfiguration proto_config = parseRouteConfigurationFromV2Yaml(yaml);
+  const ConfigImpl config(proto_config, factory_context, true);
+
+  EXPECT_CALL(factory_context.cluster_manager_, get("foo")).WillOnce(Return(nullptr));
+  EXPECT_THROW_WITH_MESSAGE(ConfigImpl(proto_config, factory_context, true, &config),
+                            EnvoyException, "route: unknown cluster 'foo'");
+}
+
 // Test to check Prefix Rewrite for redirects
 TEST(RouteConfigurationV2, RedirectPrefixRewrite) {
   std::string RedirectPrefixRewrite = R"EOF(
@@ -4608,6 +4882,46 @@ virtual_hosts:
   EXPECT_EQ(7 * 1000, route_entry->idleTimeout().value().count());
 }
 
+TEST(RouteConfigurationV2, HedgePolicy) {
+  const std::string yaml = R"EOF(
+name: HedgePolicy
+virtual_hosts:
+  - name: hedge
+    domains: [hedge.lyft.com]
+    routes:
+      - match: { prefix: "/default"}
+        route:
+          cluster: some-cluster
+          hedge_policy: { delay: 0.05s }
+      - match: { prefix: "/budget"}
+        route:
+          cluster: some-cluster
+          hedge_policy: { delay: 1s, budget: { value: 5 } }
+      - match: { prefix: "/"}
+        route:
+          cluster: some-cluster
+  )EOF";
+
+  NiceMock<Server::Configuration::MockFactoryContext> factory_context;
+  TestConfigImpl config(parseRouteConfigurationFromV2Yaml(yaml), factory_context, true);
+
+  const HedgePolicy& default_policy =
+      config.route(genHeaders("hedge.lyft.com", "/default", "GET"), 0)->routeEntry()->hedgePolicy();
+  EXPECT_EQ(std::chrono::milliseconds(50), default_policy.delay());
+  EXPECT_EQ(10U, default_policy.budgetPercent());
+
+  const HedgePolicy& budget_policy =
+      config.route(genHeaders("hedge.lyft.com", "/budget", "GET"), 0)->routeEntry()->hedgePolicy();
+  EXPECT_EQ(std::chrono::milliseconds(1000), budget_policy.delay());
+  EXPECT_EQ(5U, budget_policy.budgetPercent());
+
+  EXPECT_EQ(std::chrono::milliseconds(0),
+            config.route(genHeaders("hedge.lyft.com", "/", "GET"), 0)
+                ->routeEntry()
+                ->hedgePolicy()
+                .delay());
+}
+
 class PerFilterConfigsTest : public testing::Test {
 public:
   PerFilterConfigsTest()
@@ -0,0 +1,79 @@
+#include <string>
+
+#include "common/router/domain_index.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Router {
+namespace {
+
+TEST(DomainIndexTest, Empty) {
+  DomainIndex index;
+  EXPECT_TRUE(index.empty());
+  EXPECT_FALSE(index.find("foo.com"));
+  EXPECT_FALSE(index.find(""));
+}
+
+TEST(DomainIndexTest, Exact) {
+  DomainIndex index;
+  EXPECT_TRUE(index.addExact("foo.com", 0));
+  EXPECT_TRUE(index.addExact("bar.foo.com", 1));
+  EXPECT_TRUE(index.addExact("oo.com", 2));
+  EXPECT_FALSE(index.addExact("Foo.COM", 3));
+  EXPECT_FALSE(index.empty());
+
+  EXPECT_EQ(0, index.find("foo.com").value());
+  EXPECT_EQ(0, index.find("FOO.com").value());
+  EXPECT_EQ(1, index.find("bar.foo.com").value());
+  EXPECT_EQ(2, index.find("oo.com").value());
+  EXPECT_FALSE(index.find("o.com"));
+  EXPECT_FALSE(index.find("afoo.com"));
+  EXPECT_FALSE(index.find("foo.co"));
+  EXPECT_FALSE(index.find(""));
+}
+
+// Validate that the longest wildcard suffix that is a proper suffix of the host wins.
+TEST(DomainIndexTest, Wildcard) {
+  DomainIndex index;
+  index.addWildcardSuffix(".foo.com", 0);
+  index.addWildcardSuffix("-bar.foo.com", 1);
+  index.addWildcardSuffix(".com", 2);
+  index.addWildcardSuffix(".FOO.com", 3);
+
+  EXPECT_EQ(0, index.find("bar.foo.com").value());
+  EXPECT_EQ(0, index.find("a.b.FOO.COM").value());
+  EXPECT_EQ(1, index.find("baz-bar.foo.com").value());
+  EXPECT_EQ(0, index.find("-bar.foo.com").value());
+  EXPECT_EQ(2, index.find(".foo.com").value());
+  EXPECT_EQ(2, index.find("foo.com").value());
+  EXPECT_FALSE(index.find(".com"));
+  EXPECT_FALSE(index.find("foo.org"));
+}
+
+// Validate that exact domains take precedence over wildcard suffixes.
+TEST(DomainIndexTest, ExactAndWildcard) {
+  DomainIndex index;
+  index.addWildcardSuffix(".foo.com", 0);
+  EXPECT_TRUE(index.addExact("bar.foo.com", 1));
+  EXPECT_TRUE(index.addExact(".foo.com", 2));
+  index.addWildcardSuffix("foo.com", 3);
+
+  EXPECT_EQ(1, index.find("bar.foo.com").value());
+  EXPECT_EQ(0, index.find("baz.foo.com").value());
+  EXPECT_EQ(0, index.find("ar.foo.com").value());
+  EXPECT_EQ(2, index.find(".foo.com").value());
+  EXPECT_EQ(3, index.find("afoo.com").value());
+  EXPECT_FALSE(index.find("foo.com"));
+}
+
+TEST(DomainIndexTest, EmptyExactDomain) {
+  DomainIndex index;
+  EXPECT_TRUE(index.addExact("", 0));
+  EXPECT_EQ(0, index.find("").value());
+  EXPECT_FALSE(index.find("a"));
+}
+
+} // namespace
+} // namespace Router
+} // namespace Envoy
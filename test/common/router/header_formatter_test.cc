@@ -527,6 +527,9 @@ TEST(HeaderParserTest, EvaluateStaticHeaders) {
   req_header_parser->evaluateHeaders(header_map, request_info);
   EXPECT_TRUE(header_map.has("static-header"));
   EXPECT_EQ("static-value", header_map.get_("static-header"));
+  // Static values are added without being copied.
+  EXPECT_EQ(Http::HeaderString::Type::Reference,
+            header_map.get(Http::LowerCaseString("static-header"))->value().type());
 }
 
 TEST(HeaderParserTest, EvaluateCompoundHeaders) {
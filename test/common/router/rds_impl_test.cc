@@ -244,9 +244,10 @@ TEST_F(RdsImplTest, Basic) {
   expectRequest();
   interval_timer_->callback_();
 
-  // Load the config and verified shared count.
+  // Load the config and verified shared count. The provider also keeps the config to reuse its
+  // virtual hosts in the next update.
   ConfigConstSharedPtr config = rds_->config();
-  EXPECT_EQ(2, config.use_count());
+  EXPECT_EQ(3, config.use_count());
 
   // Third request.
   const std::string response2_json = R"EOF(
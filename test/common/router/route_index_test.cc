@@ -0,0 +1,121 @@
+#include <string>
+#include <vector>
+
+#include "common/router/route_index.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::ElementsAre;
+using testing::IsEmpty;
+
+namespace Envoy {
+namespace Router {
+namespace {
+
+class RouteIndexTest : public testing::Test {
+public:
+  std::vector<uint32_t> candidates(const std::string& path) {
+    const size_t query_start = path.find('?');
+    RouteIndex::Candidates candidates =
+        index_.candidates(path, query_start != std::string::npos ? query_start : path.size());
+    std::vector<uint32_t> ordinals;
+    for (absl::optional<uint32_t> ordinal = candidates.next(); ordinal;
+         ordinal = candidates.next()) {
+      ordinals.push_back(ordinal.value());
+    }
+    return ordinals;
+  }
+
+  RouteIndex index_;
+};
+
+TEST_F(RouteIndexTest, Empty) {
+  index_.finalize();
+  EXPECT_THAT(candidates("/"), IsEmpty());
+  EXPECT_THAT(candidates(""), IsEmpty());
+}
+
+// Validate that all the prefixes of a path are candidates, in ordinal order.
+TEST_F(RouteIndexTest, Prefix) {
+  index_.addPrefix("/foo/bar", true, 0);
+  index_.addPrefix("/foo", true, 1);
+  index_.addPrefix("/fob", true, 2);
+  index_.addPrefix("/", true, 3);
+  index_.addPrefix("/foo", true, 4);
+  index_.finalize();
+
+  EXPECT_THAT(candidates("/foo/bar/baz"), ElementsAre(0, 1, 3, 4));
+  EXPECT_THAT(candidates("/foo/ba"), ElementsAre(1, 3, 4));
+  EXPECT_THAT(candidates("/foobar"), ElementsAre(1, 3, 4));
+  EXPECT_THAT(candidates("/fob"), ElementsAre(2, 3));
+  EXPECT_THAT(candidates("/fo"), ElementsAre(3));
+  EXPECT_THAT(candidates("/FOO"), ElementsAre(3));
+  EXPECT_THAT(candidates("foo"), IsEmpty());
+  // Prefixes match the query string too, as with a linear scan.
+  EXPECT_THAT(candidates("/f?oo/bar"), ElementsAre(3));
+  EXPECT_THAT(candidates("/?"), ElementsAre(3));
+}
+
+// Validate that exact paths ignore the query string.
+TEST_F(RouteIndexTest, Path) {
+  index_.addPath("/foo", true, 0);
+  index_.addPath("/foo/bar", true, 1);
+  index_.addPath("/foo", true, 2);
+  index_.finalize();
+
+  EXPECT_THAT(candidates("/foo"), ElementsAre(0, 2));
+  EXPECT_THAT(candidates("/foo?bar"), ElementsAre(0, 2));
+  EXPECT_THAT(candidates("/foo/bar"), ElementsAre(1));
+  EXPECT_THAT(candidates("/foo/"), IsEmpty());
+  EXPECT_THAT(candidates("/fo"), IsEmpty());
+  EXPECT_THAT(candidates("/FOO"), IsEmpty());
+}
+
+TEST_F(RouteIndexTest, CaseInsensitive) {
+  index_.addPrefix("/Foo", false, 0);
+  index_.addPath("/BAR", false, 1);
+  index_.addPrefix("/foo", true, 2);
+  index_.finalize();
+
+  EXPECT_THAT(candidates("/foo"), ElementsAre(0, 2));
+  EXPECT_THAT(candidates("/FOO/bar"), ElementsAre(0));
+  EXPECT_THAT(candidates("/bar?Q"), ElementsAre(1));
+  EXPECT_THAT(candidates("/bAr"), ElementsAre(1));
+  EXPECT_THAT(candidates("/bar/"), IsEmpty());
+}
+
+// Validate that unindexed routes are candidates for every path, in ordinal order with the others.
+TEST_F(RouteIndexTest, Unindexed) {
+  index_.addPrefix("/foo", true, 0);
+  index_.addUnindexed(1);
+  index_.addPath("/foo", false, 2);
+  index_.addUnindexed(3);
+  index_.addPrefix("/", true, 4);
+  index_.finalize();
+
+  EXPECT_THAT(candidates("/foo"), ElementsAre(0, 1, 2, 3, 4));
+  EXPECT_THAT(candidates("/bar"), ElementsAre(1, 3, 4));
+  EXPECT_THAT(candidates(""), ElementsAre(1, 3));
+}
+
+// Validate that the edges of the tree are split when keys diverge within an edge.
+TEST_F(RouteIndexTest, EdgeSplit) {
+  index_.addPrefix("/abcdef", true, 0);
+  index_.addPrefix("/abcxyz", true, 1);
+  index_.addPath("/abc", true, 2);
+  index_.addPrefix("/ab", true, 3);
+  index_.addPath("", true, 4);
+  index_.finalize();
+
+  EXPECT_THAT(candidates("/abcdefg"), ElementsAre(0, 3));
+  EXPECT_THAT(candidates("/abcxyz"), ElementsAre(1, 3));
+  EXPECT_THAT(candidates("/abc"), ElementsAre(2, 3));
+  EXPECT_THAT(candidates("/abcd"), ElementsAre(3));
+  EXPECT_THAT(candidates("/a"), IsEmpty());
+  EXPECT_THAT(candidates("?abc"), ElementsAre(4));
+}
+
+} // namespace
+} // namespace Router
+} // namespace Envoy
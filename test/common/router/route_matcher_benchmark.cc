@@ -0,0 +1,135 @@
+// Usage: bazel run //test/common/router:route_matcher_benchmark
+
+#include <string>
+#include <vector>
+
+#include "common/common/fmt.h"
+#include "common/common/utility.h"
+#include "common/http/header_map_impl.h"
+#include "common/router/config_impl.h"
+#include "common/router/route_index.h"
+
+#include "test/mocks/server/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "testing/base/public/benchmark.h"
+
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Router {
+namespace {
+
+// Prefixes of num_routes routes, such that only the last one matches the request path.
+std::vector<std::string> makePrefixes(uint64_t num_routes) {
+  std::vector<std::string> prefixes;
+  for (uint64_t i = 0; i < num_routes - 1; i++) {
+    prefixes.push_back(fmt::format("/service_{}/method_{}", i / 16, i % 16));
+  }
+  prefixes.push_back("/");
+  return prefixes;
+}
+
+const std::string& requestPath() {
+  static const std::string* path = new std::string("/unknown_service/method?x=1");
+  return *path;
+}
+
+// Baseline: compare the request path with every prefix in order.
+void BM_LinearPrefixMatch(benchmark::State& state) {
+  const std::vector<std::string> prefixes = makePrefixes(state.range(0));
+  const std::string& path = requestPath();
+  for (auto _ : state) {
+    size_t match = 0;
+    while (!StringUtil::startsWith(path.c_str(), prefixes[match], true)) {
+      match++;
+    }
+    benchmark::DoNotOptimize(match);
+  }
+}
+BENCHMARK(BM_LinearPrefixMatch)->Arg(1)->Arg(100)->Arg(1000)->Arg(8000);
+
+void BM_RouteIndexPrefixMatch(benchmark::State& state) {
+  const std::vector<std::string> prefixes = makePrefixes(state.range(0));
+  RouteIndex index;
+  for (uint32_t i = 0; i < prefixes.size(); i++) {
+    index.addPrefix(prefixes[i], true, i);
+  }
+  index.finalize();
+
+  const std::string& path = requestPath();
+  const size_t path_length = path.find('?');
+  for (auto _ : state) {
+    RouteIndex::Candidates candidates = index.candidates(path, path_length);
+    benchmark::DoNotOptimize(candidates.next());
+  }
+}
+BENCHMARK(BM_RouteIndexPrefixMatch)->Arg(1)->Arg(100)->Arg(1000)->Arg(8000);
+
+// End to end route selection by a virtual host with a mix of prefix and exact path routes.
+void BM_ConfigRouteMatch(benchmark::State& state) {
+  const std::vector<std::string> prefixes = makePrefixes(state.range(0));
+  envoy::api::v2::RouteConfiguration config;
+  auto* virtual_host = config.add_virtual_hosts();
+  virtual_host->set_name("service");
+  virtual_host->add_domains("*");
+  for (uint32_t i = 0; i < prefixes.size(); i++) {
+    auto* route = virtual_host->add_routes();
+    if (i % 2 == 0 || i == prefixes.size() - 1) {
+      route->mutable_match()->set_prefix(prefixes[i]);
+    } else {
+      route->mutable_match()->set_path(prefixes[i]);
+    }
+    route->mutable_route()->set_cluster("cluster");
+  }
+
+  NiceMock<Server::Configuration::MockFactoryContext> factory_context;
+  ConfigImpl route_config(config, factory_context, false);
+  Http::TestHeaderMapImpl headers{
+      {":authority", "example.com"}, {":path", requestPath()}, {":method", "GET"}};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(route_config.route(headers, 0));
+  }
+}
+BENCHMARK(BM_ConfigRouteMatch)->Arg(1)->Arg(100)->Arg(1000)->Arg(8000);
+
+// Virtual host selection among wildcard domains of as many distinct lengths as virtual hosts.
+void BM_ConfigWildcardDomainMatch(benchmark::State& state) {
+  envoy::api::v2::RouteConfiguration config;
+  for (int64_t i = 0; i < state.range(0); i++) {
+    auto* virtual_host = config.add_virtual_hosts();
+    virtual_host->set_name(fmt::format("tenant_{}", i));
+    virtual_host->add_domains(fmt::format("*.{}.tenant.example.com", std::string(i + 1, 'x')));
+    auto* route = virtual_host->add_routes();
+    route->mutable_match()->set_prefix("/");
+    route->mutable_route()->set_cluster("cluster");
+  }
+
+  NiceMock<Server::Configuration::MockFactoryContext> factory_context;
+  ConfigImpl route_config(config, factory_context, false);
+  Http::TestHeaderMapImpl headers{
+      {":authority", "Host.X.tenant.example.com"}, {":path", "/"}, {":method", "GET"}};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(route_config.route(headers, 0));
+  }
+}
+BENCHMARK(BM_ConfigWildcardDomainMatch)->Arg(1)->Arg(100)->Arg(1000);
+
+} // namespace
+} // namespace Router
+} // namespace Envoy
+
+// Boilerplate main(), which discovers benchmarks in the same file and runs them.
+int main(int argc, char** argv) {
+  // TODO(mattklein123): Provide a common bazel benchmark wrapper much like we do for normal tests,
+  // fuzz, etc.
+  Envoy::Thread::MutexBasicLockable lock;
+  Envoy::Logger::Registry::initialize(spdlog::level::warn,
+                                      Envoy::Logger::Logger::DEFAULT_LOG_FORMAT, lock);
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+}
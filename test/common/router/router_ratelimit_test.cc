@@ -678,6 +678,61 @@ TEST_F(RateLimitPolicyEntryTest, CompoundActionsNoDescriptor) {
   EXPECT_TRUE(descriptors_.empty());
 }
 
+// The descriptors populated before an entry which doesn't populate one are kept.
+TEST_F(RateLimitPolicyEntryTest, NoDescriptorKeepsPreviousDescriptors) {
+  std::string json = R"EOF(
+  {
+    "actions": [
+      {
+        "type": "destination_cluster"
+      },
+      {
+        "type": "request_headers",
+        "header_name": "x-header-name",
+        "descriptor_key": "my_header_name"
+      }
+    ]
+  }
+  )EOF";
+
+  SetUpTest(json);
+
+  descriptors_.push_back({{{"generic_key", "fake_key"}}});
+  rate_limit_entry_->populateDescriptors(route_, descriptors_, "service_cluster", header_,
+                                         default_remote_address_);
+  EXPECT_THAT(std::vector<Envoy::RateLimit::Descriptor>({{{{"generic_key", "fake_key"}}}}),
+              testing::ContainerEq(descriptors_));
+}
+
+// Entries whose actions don't depend on the request always populate the same descriptor.
+TEST_F(RateLimitPolicyEntryTest, CompoundGenericKeys) {
+  std::string json = R"EOF(
+  {
+    "actions": [
+      {
+        "type": "generic_key",
+        "descriptor_value": "fake_key"
+      },
+      {
+        "type": "generic_key",
+        "descriptor_value": "other_key"
+      }
+    ]
+  }
+  )EOF";
+
+  SetUpTest(json);
+
+  for (int i = 0; i < 2; i++) {
+    rate_limit_entry_->populateDescriptors(route_, descriptors_, "", header_,
+                                           default_remote_address_);
+  }
+  const Envoy::RateLimit::Descriptor descriptor{
+      {{"generic_key", "fake_key"}, {"generic_key", "other_key"}}};
+  EXPECT_THAT(std::vector<Envoy::RateLimit::Descriptor>({descriptor, descriptor}),
+              testing::ContainerEq(descriptors_));
+}
+
 } // namespace
 } // namespace Router
 } // namespace Envoy
@@ -13,6 +13,7 @@
 #include "common/upstream/upstream_impl.h"
 
 #include "test/common/http/common.h"
+#include "test/mocks/buffer/mocks.h"
 #include "test/mocks/http/mocks.h"
 #include "test/mocks/local_info/mocks.h"
 #include "test/mocks/network/mocks.h"
@@ -95,6 +96,30 @@ public:
     EXPECT_CALL(*per_try_timeout_, disableTimer());
   }
 
+  // The hedge timer is created after the response timer, so this must be called first.
+  void expectHedgeTimerCreate() {
+    callbacks_.route_->route_entry_.hedge_policy_.delay_ = std::chrono::milliseconds(10);
+    hedge_timeout_ = new Event::MockTimer(&callbacks_.dispatcher_);
+    EXPECT_CALL(*hedge_timeout_, enableTimer(std::chrono::milliseconds(10)));
+    EXPECT_CALL(*hedge_timeout_, disableTimer());
+  }
+
+  // Expects a new upstream stream and saves its response decoder.
+  void expectNewStream(Http::MockStreamEncoder& encoder, Http::StreamDecoder*& response_decoder) {
+    EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+        .WillOnce(Invoke([&](Http::StreamDecoder& decoder,
+                             Http::ConnectionPool::Callbacks& callbacks)
+                             -> Http::ConnectionPool::Cancellable* {
+          response_decoder = &decoder;
+          callbacks.onPoolReady(encoder, cm_.conn_pool_.host_);
+          return nullptr;
+        }));
+  }
+
+  uint64_t clusterCounter(const std::string& name) {
+    return cm_.thread_local_cluster_.cluster_.info_->stats_store_.counter(name).value();
+  }
+
   AssertionResult verifyHostUpstreamStats(uint64_t success, uint64_t error) {
     if (success != cm_.conn_pool_.host_->stats_store_.counter("rq_success").value()) {
       return AssertionFailure() << fmt::format(
@@ -190,6 +215,7 @@ public:
   TestFilter router_;
   Event::MockTimer* response_timeout_{};
   Event::MockTimer* per_try_timeout_{};
+  Event::MockTimer* hedge_timeout_{};
   Network::Address::InstanceConstSharedPtr host_address_{
       Network::Utility::resolveUrl("tcp://10.0.0.5:9211")};
 };
@@ -360,7 +386,7 @@ TEST_F(RouterTest, UseDownstreamProtocol2) {
 TEST_F(RouterTest, HashPolicy) {
   ON_CALL(callbacks_.route_->route_entry_, hashPolicy())
       .WillByDefault(Return(&callbacks_.route_->route_entry_.hash_policy_));
-  EXPECT_CALL(callbacks_.route_->route_entry_.hash_policy_, generateHash(_, _, _))
+  EXPECT_CALL(callbacks_.route_->route_entry_.hash_policy_, generateHash(_, _, _, _))
       .WillOnce(Return(absl::optional<uint64_t>(10)));
   EXPECT_CALL(cm_, httpConnPoolForCluster(_, _, _, _))
       .WillOnce(
@@ -385,7 +411,7 @@ TEST_F(RouterTest, HashPolicy) {
 TEST_F(RouterTest, HashPolicyNoHash) {
   ON_CALL(callbacks_.route_->route_entry_, hashPolicy())
       .WillByDefault(Return(&callbacks_.route_->route_entry_.hash_policy_));
-  EXPECT_CALL(callbacks_.route_->route_entry_.hash_policy_, generateHash(_, _, _))
+  EXPECT_CALL(callbacks_.route_->route_entry_.hash_policy_, generateHash(_, _, _, _))
       .WillOnce(Return(absl::optional<uint64_t>()));
   EXPECT_CALL(cm_, httpConnPoolForCluster(_, _, _, &router_))
       .WillOnce(
@@ -435,8 +461,9 @@ TEST_F(RouterTest, AddCookie) {
           }));
 
   std::string cookie_value;
-  EXPECT_CALL(callbacks_.route_->route_entry_.hash_policy_, generateHash(_, _, _))
+  EXPECT_CALL(callbacks_.route_->route_entry_.hash_policy_, generateHash(_, _, _, _))
       .WillOnce(Invoke([&](const Network::Address::Instance*, const Http::HeaderMap&,
+                           Http::RequestAttributes&,
                            const HashPolicy::AddCookieCallback add_cookie) {
         cookie_value = add_cookie("foo", "", std::chrono::seconds(1337));
         return absl::optional<uint64_t>(10);
@@ -481,8 +508,9 @@ TEST_F(RouterTest, AddCookieNoDuplicate) {
             return &cm_.conn_pool_;
           }));
 
-  EXPECT_CALL(callbacks_.route_->route_entry_.hash_policy_, generateHash(_, _, _))
+  EXPECT_CALL(callbacks_.route_->route_entry_.hash_policy_, generateHash(_, _, _, _))
       .WillOnce(Invoke([&](const Network::Address::Instance*, const Http::HeaderMap&,
+                           Http::RequestAttributes&,
                            const HashPolicy::AddCookieCallback add_cookie) {
         // this should be ignored
         add_cookie("foo", "", std::chrono::seconds(1337));
@@ -529,8 +557,9 @@ TEST_F(RouterTest, AddMultipleCookies) {
           }));
 
   std::string choco_c, foo_c;
-  EXPECT_CALL(callbacks_.route_->route_entry_.hash_policy_, generateHash(_, _, _))
+  EXPECT_CALL(callbacks_.route_->route_entry_.hash_policy_, generateHash(_, _, _, _))
       .WillOnce(Invoke([&](const Network::Address::Instance*, const Http::HeaderMap&,
+                           Http::RequestAttributes&,
                            const HashPolicy::AddCookieCallback add_cookie) {
         choco_c = add_cookie("choco", "", std::chrono::seconds(15));
         foo_c = add_cookie("foo", "/path", std::chrono::seconds(1337));
@@ -1045,6 +1074,55 @@ TEST_F(RouterTest, GrpcInternal) {
   EXPECT_TRUE(verifyHostUpstreamStats(0, 1));
 }
 
+// Validate that response times are reported to the latency estimator of the host with the peak
+// EWMA load balancer.
+TEST_F(RouterTest, PeakEwmaResponseTime) {
+  cm_.thread_local_cluster_.cluster_.info_->lb_type_ = Upstream::LoadBalancerType::PeakEwma;
+  NiceMock<Http::MockStreamEncoder> encoder1;
+  Http::StreamDecoder* response_decoder = nullptr;
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+      .WillOnce(Invoke([&](Http::StreamDecoder& decoder, Http::ConnectionPool::Callbacks& callbacks)
+                           -> Http::ConnectionPool::Cancellable* {
+        response_decoder = &decoder;
+        callbacks.onPoolReady(encoder1, cm_.conn_pool_.host_);
+        return nullptr;
+      }));
+  expectResponseTimerCreate();
+
+  Http::TestHeaderMapImpl headers;
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+
+  EXPECT_CALL(cm_.conn_pool_.host_->latency_estimator_, putResponseTime(_, _));
+  Http::HeaderMapPtr response_headers(new Http::TestHeaderMapImpl{{":status", "200"}});
+  response_decoder->decodeHeaders(std::move(response_headers), true);
+  EXPECT_TRUE(verifyHostUpstreamStats(1, 0));
+}
+
+// Validate that response times are not reported to the latency estimator of the host with the
+// other load balancers.
+TEST_F(RouterTest, NoPeakEwmaResponseTime) {
+  NiceMock<Http::MockStreamEncoder> encoder1;
+  Http::StreamDecoder* response_decoder = nullptr;
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+      .WillOnce(Invoke([&](Http::StreamDecoder& decoder, Http::ConnectionPool::Callbacks& callbacks)
+                           -> Http::ConnectionPool::Cancellable* {
+        response_decoder = &decoder;
+        callbacks.onPoolReady(encoder1, cm_.conn_pool_.host_);
+        return nullptr;
+      }));
+  expectResponseTimerCreate();
+
+  Http::TestHeaderMapImpl headers;
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+
+  EXPECT_CALL(cm_.conn_pool_.host_->latency_estimator_, putResponseTime(_, _)).Times(0);
+  Http::HeaderMapPtr response_headers(new Http::TestHeaderMapImpl{{":status", "200"}});
+  response_decoder->decodeHeaders(std::move(response_headers), true);
+  EXPECT_TRUE(verifyHostUpstreamStats(1, 0));
+}
+
 TEST_F(RouterTest, UpstreamTimeoutWithAltResponse) {
   NiceMock<Http::MockStreamEncoder> encoder;
   Http::StreamDecoder* response_decoder = nullptr;
@@ -1692,6 +1770,98 @@ TEST_F(RouterTest, RetryUpstreamGrpcCancelled) {
   EXPECT_TRUE(verifyHostUpstreamStats(1, 1));
 }
 
+// Validate that a hedged attempt that responds first wins and cancels the initial attempt.
+TEST_F(RouterTest, HedgeWins) {
+  NiceMock<Http::MockStreamEncoder> encoder1;
+  Http::StreamDecoder* response_decoder1 = nullptr;
+  expectNewStream(encoder1, response_decoder1);
+  expectHedgeTimerCreate();
+  expectResponseTimerCreate();
+
+  Http::TestHeaderMapImpl headers{{"x-envoy-internal", "true"}};
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+
+  NiceMock<Http::MockStreamEncoder> encoder2;
+  Http::StreamDecoder* response_decoder2 = nullptr;
+  expectNewStream(encoder2, response_decoder2);
+  hedge_timeout_->callback_();
+  EXPECT_EQ(1U, clusterCounter("upstream_rq_hedged"));
+  Upstream::MockClusterInfo& cluster = *cm_.thread_local_cluster_.cluster_.info_;
+  EXPECT_EQ(1U, cluster.stats_store_.gauge("upstream_rq_hedge_active").value());
+  EXPECT_FALSE(cluster.resource_manager_->retries().canCreate());
+
+  EXPECT_CALL(encoder1.stream_, resetStream(Http::StreamResetReason::LocalReset));
+  EXPECT_CALL(encoder2.stream_, resetStream(_)).Times(0);
+  EXPECT_CALL(cm_.conn_pool_.host_->outlier_detector_, putHttpResponseCode(200));
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, true));
+  Http::HeaderMapPtr response_headers(new Http::TestHeaderMapImpl{{":status", "200"}});
+  response_decoder2->decodeHeaders(std::move(response_headers), true);
+  EXPECT_TRUE(verifyHostUpstreamStats(1, 0));
+  EXPECT_EQ(1U, clusterCounter("upstream_rq_hedge_won"));
+  EXPECT_EQ(0U, cluster.stats_store_.gauge("upstream_rq_hedge_active").value());
+  EXPECT_TRUE(cluster.resource_manager_->retries().canCreate());
+}
+
+// Validate that the failure of one attempt of a hedged request does not fail the request while
+// the other attempt is in flight.
+TEST_F(RouterTest, HedgeInitialAttemptFailure) {
+  NiceMock<Http::MockStreamEncoder> encoder1;
+  Http::StreamDecoder* response_decoder1 = nullptr;
+  expectNewStream(encoder1, response_decoder1);
+  expectHedgeTimerCreate();
+  expectResponseTimerCreate();
+
+  Http::TestHeaderMapImpl headers{{"x-envoy-internal", "true"}};
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+
+  NiceMock<Http::MockStreamEncoder> encoder2;
+  Http::StreamDecoder* response_decoder2 = nullptr;
+  expectNewStream(encoder2, response_decoder2);
+  hedge_timeout_->callback_();
+
+  // A 5xx response to the initial attempt is discarded.
+  EXPECT_CALL(callbacks_, encodeHeaders_(HeaderHasValueRef(":status", "200"), true));
+  EXPECT_CALL(cm_.conn_pool_.host_->outlier_detector_, putHttpResponseCode(503));
+  Http::HeaderMapPtr response_headers1(new Http::TestHeaderMapImpl{{":status", "503"}});
+  response_decoder1->decodeHeaders(std::move(response_headers1), true);
+  EXPECT_TRUE(verifyHostUpstreamStats(0, 1));
+
+  EXPECT_CALL(cm_.conn_pool_.host_->outlier_detector_, putHttpResponseCode(200));
+  Http::HeaderMapPtr response_headers2(new Http::TestHeaderMapImpl{{":status", "200"}});
+  response_decoder2->decodeHeaders(std::move(response_headers2), true);
+  EXPECT_TRUE(verifyHostUpstreamStats(1, 1));
+  EXPECT_EQ(0U, clusterCounter("upstream_rq_hedge_won"));
+}
+
+// Validate that requests are not hedged once the retry circuit breaker is open.
+TEST_F(RouterTest, HedgeOverflow) {
+  NiceMock<Http::MockStreamEncoder> encoder;
+  Http::StreamDecoder* response_decoder = nullptr;
+  expectNewStream(encoder, response_decoder);
+  expectHedgeTimerCreate();
+  expectResponseTimerCreate();
+
+  Http::TestHeaderMapImpl headers{{"x-envoy-internal", "true"}};
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+
+  Upstream::ResourceManager& resource_manager =
+      *cm_.thread_local_cluster_.cluster_.info_->resource_manager_;
+  resource_manager.retries().inc();
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _)).Times(0);
+  hedge_timeout_->callback_();
+  resource_manager.retries().dec();
+  EXPECT_EQ(1U, clusterCounter("upstream_rq_hedge_overflow"));
+  EXPECT_EQ(0U, clusterCounter("upstream_rq_hedged"));
+
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, true));
+  Http::HeaderMapPtr response_headers(new Http::TestHeaderMapImpl{{":status", "200"}});
+  response_decoder->decodeHeaders(std::move(response_headers), true);
+  EXPECT_TRUE(verifyHostUpstreamStats(1, 0));
+}
+
 TEST_F(RouterTest, Shadow) {
   callbacks_.route_->route_entry_.shadow_policy_.cluster_ = "foo";
   callbacks_.route_->route_entry_.shadow_policy_.runtime_key_ = "bar";
@@ -1721,12 +1891,19 @@ TEST_F(RouterTest, Shadow) {
   EXPECT_CALL(callbacks_, decodingBuffer())
       .Times(AtLeast(1))
       .WillRepeatedly(Return(body_data.get()));
+  Buffer::RawSlice body_slice;
+  EXPECT_EQ(1, body_data->getRawSlices(&body_slice, 1));
   EXPECT_CALL(*shadow_writer_, shadow_("foo", _, std::chrono::milliseconds(10)))
-      .WillOnce(Invoke(
-          [](const std::string&, Http::MessagePtr& request, std::chrono::milliseconds) -> void {
-            EXPECT_NE(nullptr, request->body());
-            EXPECT_NE(nullptr, request->trailers());
-          }));
+      .WillOnce(Invoke([&](const std::string&, Http::MessagePtr& request,
+                           std::chrono::milliseconds) -> void {
+        ASSERT_NE(nullptr, request->body());
+        EXPECT_EQ("hello", request->body()->toString());
+        // The shadow shares the buffered body rather than copying it.
+        Buffer::RawSlice shadow_slice;
+        EXPECT_EQ(1, request->body()->getRawSlices(&shadow_slice, 1));
+        EXPECT_EQ(body_slice.mem_, shadow_slice.mem_);
+        EXPECT_NE(nullptr, request->trailers());
+      }));
   router_.decodeTrailers(trailers);
 
   Http::HeaderMapPtr response_headers(new Http::TestHeaderMapImpl{{":status", "200"}});
@@ -1836,12 +2013,14 @@ TEST_F(RouterTest, DirectResponseWithBody) {
   EXPECT_CALL(direct_response, responseCode()).WillRepeatedly(Return(Http::Code::OK));
   const std::string response_body("static response");
   EXPECT_CALL(direct_response, responseBody()).WillRepeatedly(ReturnRef(response_body));
+  EXPECT_CALL(direct_response, addResponseBody(_))
+      .WillOnce(Invoke([&](Buffer::Instance& buffer) -> void { buffer.add(response_body); }));
   EXPECT_CALL(*callbacks_.route_, directResponseEntry()).WillRepeatedly(Return(&direct_response));
 
   Http::TestHeaderMapImpl response_headers{
       {":status", "200"}, {"content-length", "15"}, {"content-type", "text/plain"}};
   EXPECT_CALL(callbacks_, encodeHeaders_(HeaderMapEqualRef(&response_headers), false));
-  EXPECT_CALL(callbacks_, encodeData(_, true));
+  EXPECT_CALL(callbacks_, encodeData(BufferStringEqual("static response"), true));
   Http::TestHeaderMapImpl headers;
   HttpTestUtility::addDefaultHeaders(headers);
   router_.decodeHeaders(headers, true);
@@ -2129,6 +2308,19 @@ TEST(RouterFilterUtilityTest, ShouldShadow) {
   }
 }
 
+TEST(RouterFilterUtilityTest, ShouldHedge) {
+  TestHedgePolicy policy;
+  Http::TestHeaderMapImpl get_headers{{":method", "GET"}};
+  Http::TestHeaderMapImpl delete_headers{{":method", "DELETE"}};
+  Http::TestHeaderMapImpl post_headers{{":method", "POST"}};
+  EXPECT_FALSE(FilterUtility::shouldHedge(policy, get_headers));
+
+  policy.delay_ = std::chrono::milliseconds(10);
+  EXPECT_TRUE(FilterUtility::shouldHedge(policy, get_headers));
+  EXPECT_TRUE(FilterUtility::shouldHedge(policy, delete_headers));
+  EXPECT_FALSE(FilterUtility::shouldHedge(policy, post_headers));
+}
+
 TEST_F(RouterTest, CanaryStatusTrue) {
   EXPECT_CALL(callbacks_.route_->route_entry_, timeout())
       .WillOnce(Return(std::chrono::milliseconds(0)));
@@ -1,6 +1,7 @@
 #include <memory>
 #include <string>
 
+#include "common/runtime/key_registry.h"
 #include "common/runtime/runtime_impl.h"
 #include "common/stats/isolated_store_impl.h"
 
@@ -18,7 +19,7 @@ using testing::_;
 using testing::Invoke;
 using testing::NiceMock;
 using testing::Return;
-using testing::ReturnNew;
+using testing::SaveArg;
 
 namespace Envoy {
 namespace Runtime {
@@ -73,7 +74,12 @@ public:
 
   void setup() {
     EXPECT_CALL(dispatcher, createFilesystemWatcher_())
-        .WillOnce(ReturnNew<NiceMock<Filesystem::MockWatcher>>());
+        .WillOnce(Invoke([this]() -> Filesystem::Watcher* {
+          Filesystem::MockWatcher* watcher = new NiceMock<Filesystem::MockWatcher>();
+          EXPECT_CALL(*watcher, addWatch(_, Filesystem::Watcher::Events::MovedTo, _))
+              .WillOnce(SaveArg<2>(&on_changed_cb_));
+          return watcher;
+        }));
 
     os_sys_calls_ = new NiceMock<Api::MockOsSysCalls>;
     ON_CALL(*os_sys_calls_, stat(_, _))
@@ -97,6 +103,7 @@ public:
   Stats::IsolatedStoreImpl store;
   MockRandomGenerator generator;
   std::unique_ptr<LoaderImpl> loader;
+  Filesystem::Watcher::OnChangedCb on_changed_cb_;
 };
 
 TEST_F(DiskBackedLoaderImplTest, All) {
@@ -154,6 +161,37 @@ TEST_F(DiskBackedLoaderImplTest, GetLayers) {
   EXPECT_EQ("bar", new_layers[2]->values().find("foo")->second.string_value_);
 }
 
+TEST_F(DiskBackedLoaderImplTest, ReloadSharesUnchangedLayers) {
+  setup();
+  run("test/common/runtime/test_data/current", "envoy_override");
+  const Snapshot::OverrideLayerConstSharedPtr root = loader->snapshot().getLayers()[0];
+  const Snapshot::OverrideLayerConstSharedPtr override_layer = loader->snapshot().getLayers()[1];
+  const Snapshot::OverrideLayerConstSharedPtr admin = loader->snapshot().getLayers()[2];
+
+  // Nothing changed, so all the layers are shared with the new snapshot.
+  on_changed_cb_(Filesystem::Watcher::Events::MovedTo);
+  EXPECT_EQ(root, loader->snapshot().getLayers()[0]);
+  EXPECT_EQ(override_layer, loader->snapshot().getLayers()[1]);
+  EXPECT_EQ(admin, loader->snapshot().getLayers()[2]);
+
+  // Only the layer holding the modified file is replaced.
+  const std::string file2 = "test/common/runtime/test_data/root/envoy/file2";
+  const std::string original =
+      TestEnvironment::readFileToStringForTest(TestEnvironment::temporaryPath(file2));
+  TestEnvironment::writeStringToFileForTest(file2, "new world");
+  on_changed_cb_(Filesystem::Watcher::Events::MovedTo);
+  EXPECT_NE(root, loader->snapshot().getLayers()[0]);
+  EXPECT_EQ(override_layer, loader->snapshot().getLayers()[1]);
+  EXPECT_EQ("new world", loader->snapshot().get("file2"));
+  EXPECT_EQ("hello\nworld", loader->snapshot().get("subdir.file3"));
+  EXPECT_EQ(123UL, loader->snapshot().getInteger("file4", 1));
+  EXPECT_EQ("hello override", loader->snapshot().get("file1"));
+
+  TestEnvironment::writeStringToFileForTest(file2, original);
+  on_changed_cb_(Filesystem::Watcher::Events::MovedTo);
+  EXPECT_EQ("world", loader->snapshot().get("file2"));
+}
+
 TEST_F(DiskBackedLoaderImplTest, BadDirectory) {
   setup();
   run("/baddir", "/baddir");
@@ -247,6 +285,36 @@ TEST(LoaderImplTest, All) {
   testNewOverrides(loader, store);
 }
 
+TEST(LoaderImplTest, KeyHandles) {
+  MockRandomGenerator generator;
+  NiceMock<ThreadLocal::MockInstance> tls;
+  Stats::IsolatedStoreImpl store;
+  LoaderImpl loader(generator, store, tls);
+
+  const KeyHandle registered = KeyRegistry::registerKey("key_handles.registered");
+  EXPECT_EQ("key_handles.registered", registered.key());
+  EXPECT_EQ(registered.index(), KeyRegistry::registerKey("key_handles.registered").index());
+  EXPECT_EQ(1UL, loader.snapshot().getInteger(registered, 1));
+
+  loader.mergeValues({{"key_handles.registered", "2"}, {"key_handles.merged", "0"}});
+  EXPECT_EQ(2UL, loader.snapshot().getInteger(registered, 1));
+  EXPECT_TRUE(loader.snapshot().featureEnabled(registered, 0, 1));
+  EXPECT_FALSE(loader.snapshot().featureEnabled(registered, 0, 2));
+
+  // Keys interned by the snapshot resolve through handles registered afterwards.
+  const KeyHandle merged = KeyRegistry::registerKey("key_handles.merged");
+  EXPECT_FALSE(loader.snapshot().featureEnabled(merged, 100));
+
+  // A key registered after the snapshot was built is absent from it.
+  const KeyHandle unknown = KeyRegistry::registerKey("key_handles.unknown");
+  EXPECT_EQ(3UL, loader.snapshot().getInteger(unknown, 3));
+
+  loader.mergeValues({{"key_handles.registered", ""}, {"key_handles.unknown", "foo"}});
+  EXPECT_EQ(1UL, loader.snapshot().getInteger(registered, 1));
+  EXPECT_EQ(3UL, loader.snapshot().getInteger(unknown, 3));
+  EXPECT_EQ("foo", loader.snapshot().get("key_handles.unknown"));
+}
+
 TEST(DiskLayer, IllegalPath) {
   Api::MockOsSysCalls mock_os_syscalls;
   EXPECT_THROW_WITH_MESSAGE(DiskLayer("test", "/dev", mock_os_syscalls), EnvoyException,
@@ -41,8 +41,9 @@ TEST_F(SdsApiTest, BasicTest) {
   auto google_grpc = grpc_service->mutable_google_grpc();
   google_grpc->set_target_uri("fake_address");
   google_grpc->set_stat_prefix("test");
-  SdsApi sds_api(server.localInfo(), server.dispatcher(), server.random(), server.stats(),
-                 server.clusterManager(), init_manager, config_source, "abc.com", []() {});
+  TlsCertificateSdsApi sds_api(server.localInfo(), server.dispatcher(), server.random(),
+                               server.stats(), server.clusterManager(), init_manager,
+                               config_source, "abc.com", []() {});
 
   NiceMock<Grpc::MockAsyncClient>* grpc_client{new NiceMock<Grpc::MockAsyncClient>()};
   NiceMock<Grpc::MockAsyncClientFactory>* factory{new NiceMock<Grpc::MockAsyncClientFactory>()};
@@ -62,8 +63,9 @@ TEST_F(SdsApiTest, SecretUpdateSuccess) {
   NiceMock<Server::MockInstance> server;
   NiceMock<Init::MockManager> init_manager;
   envoy::api::v2::core::ConfigSource config_source;
-  SdsApi sds_api(server.localInfo(), server.dispatcher(), server.random(), server.stats(),
-                 server.clusterManager(), init_manager, config_source, "abc.com", []() {});
+  TlsCertificateSdsApi sds_api(server.localInfo(), server.dispatcher(), server.random(),
+                               server.stats(), server.clusterManager(), init_manager,
+                               config_source, "abc.com", []() {});
 
   NiceMock<Secret::MockSecretCallbacks> secret_callback;
   auto handle =
@@ -101,8 +103,9 @@ TEST_F(SdsApiTest, EmptyResource) {
   NiceMock<Server::MockInstance> server;
   NiceMock<Init::MockManager> init_manager;
   envoy::api::v2::core::ConfigSource config_source;
-  SdsApi sds_api(server.localInfo(), server.dispatcher(), server.random(), server.stats(),
-                 server.clusterManager(), init_manager, config_source, "abc.com", []() {});
+  TlsCertificateSdsApi sds_api(server.localInfo(), server.dispatcher(), server.random(),
+                               server.stats(), server.clusterManager(), init_manager,
+                               config_source, "abc.com", []() {});
 
   Protobuf::RepeatedPtrField<envoy::api::v2::auth::Secret> secret_resources;
 
@@ -115,8 +118,9 @@ TEST_F(SdsApiTest, SecretUpdateWrongSize) {
   NiceMock<Server::MockInstance> server;
   NiceMock<Init::MockManager> init_manager;
   envoy::api::v2::core::ConfigSource config_source;
-  SdsApi sds_api(server.localInfo(), server.dispatcher(), server.random(), server.stats(),
-                 server.clusterManager(), init_manager, config_source, "abc.com", []() {});
+  TlsCertificateSdsApi sds_api(server.localInfo(), server.dispatcher(), server.random(),
+                               server.stats(), server.clusterManager(), init_manager,
+                               config_source, "abc.com", []() {});
 
   std::string yaml =
       R"EOF(
@@ -144,8 +148,9 @@ TEST_F(SdsApiTest, SecretUpdateWrongSecretName) {
   NiceMock<Server::MockInstance> server;
   NiceMock<Init::MockManager> init_manager;
   envoy::api::v2::core::ConfigSource config_source;
-  SdsApi sds_api(server.localInfo(), server.dispatcher(), server.random(), server.stats(),
-                 server.clusterManager(), init_manager, config_source, "abc.com", []() {});
+  TlsCertificateSdsApi sds_api(server.localInfo(), server.dispatcher(), server.random(),
+                               server.stats(), server.clusterManager(), init_manager,
+                               config_source, "abc.com", []() {});
 
   std::string yaml =
       R"EOF(
@@ -165,6 +170,54 @@ TEST_F(SdsApiTest, SecretUpdateWrongSecretName) {
                             "Unexpected SDS secret (expecting abc.com): wrong.name.com");
 }
 
+// Validate that TlsSessionTicketKeysSdsApi updates the session ticket keys successfully, and
+// ignores secrets of another type.
+TEST_F(SdsApiTest, SessionTicketKeysUpdateSuccess) {
+  NiceMock<Server::MockInstance> server;
+  NiceMock<Init::MockManager> init_manager;
+  envoy::api::v2::core::ConfigSource config_source;
+  TlsSessionTicketKeysSdsApi sds_api(server.localInfo(), server.dispatcher(), server.random(),
+                                     server.stats(), server.clusterManager(), init_manager,
+                                     config_source, "ticket_keys", []() {});
+
+  NiceMock<Secret::MockSecretCallbacks> secret_callback;
+  auto handle =
+      sds_api.addUpdateCallback([&secret_callback]() { secret_callback.onAddOrUpdateSecret(); });
+
+  std::string yaml =
+      R"EOF(
+  name: "ticket_keys"
+  tls_certificate:
+    certificate_chain:
+      filename: "{{ test_rundir }}/test/common/ssl/test_data/selfsigned_cert.pem"
+    private_key:
+      filename: "{{ test_rundir }}/test/common/ssl/test_data/selfsigned_key.pem"
+    )EOF";
+
+  Protobuf::RepeatedPtrField<envoy::api::v2::auth::Secret> secret_resources;
+  MessageUtil::loadFromYaml(TestEnvironment::substitute(yaml), *secret_resources.Add());
+  EXPECT_CALL(secret_callback, onAddOrUpdateSecret()).Times(0);
+  sds_api.onConfigUpdate(secret_resources, "");
+  EXPECT_EQ(nullptr, sds_api.secret());
+
+  yaml =
+      R"EOF(
+  name: "ticket_keys"
+  session_ticket_keys:
+    keys:
+      - filename: "{{ test_rundir }}/test/common/ssl/test_data/ticket_key_a"
+      - filename: "{{ test_rundir }}/test/common/ssl/test_data/ticket_key_b"
+    )EOF";
+
+  MessageUtil::loadFromYaml(TestEnvironment::substitute(yaml), *secret_resources.Mutable(0));
+  EXPECT_CALL(secret_callback, onAddOrUpdateSecret());
+  sds_api.onConfigUpdate(secret_resources, "");
+  ASSERT_NE(nullptr, sds_api.secret());
+  EXPECT_EQ(2, sds_api.secret()->keys().size());
+
+  handle->remove();
+}
+
 } // namespace
 } // namespace Secret
 } // namespace Envoy
@@ -51,6 +51,28 @@ tls_certificate:
             secret_manager->findStaticTlsCertificateProvider("abc.com")->secret()->privateKey());
 }
 
+// Validate that secret manager adds static session ticket keys secret successfully.
+TEST_F(SecretManagerImplTest, SessionTicketKeysSecretLoadSuccess) {
+  envoy::api::v2::auth::Secret secret_config;
+  const std::string yaml =
+      R"EOF(
+name: "ticket_keys"
+session_ticket_keys:
+  keys:
+    - filename: "{{ test_rundir }}/test/common/ssl/test_data/ticket_key_a"
+)EOF";
+  MessageUtil::loadFromYaml(TestEnvironment::substitute(yaml), secret_config);
+  std::unique_ptr<SecretManager> secret_manager(new SecretManagerImpl());
+  secret_manager->addStaticSecret(secret_config);
+
+  ASSERT_EQ(secret_manager->findStaticTlsSessionTicketKeysProvider("undefined"), nullptr);
+  auto secret_provider = secret_manager->findStaticTlsSessionTicketKeysProvider("ticket_keys");
+  ASSERT_NE(secret_provider, nullptr);
+  EXPECT_EQ(1, secret_provider->secret()->keys().size());
+  EXPECT_THROW_WITH_MESSAGE(secret_manager->addStaticSecret(secret_config), EnvoyException,
+                            "Duplicate static TlsSessionTicketKeys secret name ticket_keys");
+}
+
 // Validate that secret manager throws an exception when adding duplicated static TLS certificate
 // secret.
 TEST_F(SecretManagerImplTest, DuplicateStaticTlsCertificateSecret) {
@@ -124,9 +146,6 @@ TEST_F(SecretManagerImplTest, NotImplementedException) {
   const std::string yaml =
       R"EOF(
 name: "abc.com"
-session_ticket_keys:
-  keys:
-    - filename: "{{ test_rundir }}/test/common/ssl/test_data/selfsigned_cert.pem"
 )EOF";
 
   MessageUtil::loadFromYaml(TestEnvironment::substitute(yaml), secret_config);
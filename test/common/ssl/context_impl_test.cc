@@ -167,6 +167,187 @@ TEST_F(SslContextImplTest, TestGetCertInformation) {
               std::string::npos);
 }
 
+// Contexts trusting the same CA bundle share its parse, whether prepared ahead or not.
+TEST_F(SslContextImplTest, TestSharedTrustedCa) {
+  std::string json = R"EOF(
+  {
+    "ca_cert_file": "{{ test_rundir }}/test/common/ssl/test_data/ca_cert.pem"
+  }
+  )EOF";
+
+  Json::ObjectSharedPtr loader = TestEnvironment::jsonLoadFromString(json);
+  ClientContextConfigImpl cfg(*loader, factory_context_);
+  Runtime::MockLoader runtime;
+  ContextManagerImpl manager(runtime);
+  Stats::IsolatedStoreImpl store;
+
+  TrustedCaConstSharedPtr trusted_ca =
+      manager.prepareTrustedCa(cfg.certificateValidationContext()->caCert());
+  EXPECT_EQ(trusted_ca, manager.prepareTrustedCa(cfg.certificateValidationContext()->caCert()));
+
+  ClientContextSharedPtr context(manager.createSslClientContext(store, cfg));
+  std::weak_ptr<const TrustedCa> weak_trusted_ca = trusted_ca;
+  trusted_ca.reset();
+  // The context keeps the parse alive for the contexts created after it.
+  EXPECT_FALSE(weak_trusted_ca.expired());
+  EXPECT_EQ(weak_trusted_ca.lock(),
+            manager.prepareTrustedCa(cfg.certificateValidationContext()->caCert()));
+
+  context.reset();
+  EXPECT_TRUE(weak_trusted_ca.expired());
+}
+
+// Client contexts with the same SSL_CTX config share their SSL_CTX, and all the contexts trusting
+// the same CA bundle share its store.
+TEST_F(SslContextImplTest, TestSharedSslCtx) {
+  const std::string base_json = R"EOF(
+    "cert_chain_file": "{{ test_tmpdir }}/unittestcert.pem",
+    "private_key_file": "{{ test_tmpdir }}/unittestkey.pem",
+    "ca_cert_file": "{{ test_rundir }}/test/common/ssl/test_data/ca_cert.pem"
+  )EOF";
+
+  Json::ObjectSharedPtr loader1 =
+      TestEnvironment::jsonLoadFromString("{" + base_json + ", \"sni\": \"a.example.com\"}");
+  ClientContextConfigImpl cfg1(*loader1, factory_context_);
+  Json::ObjectSharedPtr loader2 =
+      TestEnvironment::jsonLoadFromString("{" + base_json + ", \"sni\": \"b.example.com\"}");
+  ClientContextConfigImpl cfg2(*loader2, factory_context_);
+  Json::ObjectSharedPtr loader3 = TestEnvironment::jsonLoadFromString(
+      "{" + base_json + ", \"cipher_suites\": \"ECDHE-RSA-AES128-GCM-SHA256\"}");
+  ClientContextConfigImpl cfg3(*loader3, factory_context_);
+  Runtime::MockLoader runtime;
+  ContextManagerImpl manager(runtime);
+  Stats::IsolatedStoreImpl store1;
+  Stats::IsolatedStoreImpl store2;
+
+  ContextImplSharedPtr context1 =
+      std::dynamic_pointer_cast<ContextImpl>(manager.createSslClientContext(store1, cfg1));
+  ContextImplSharedPtr context2 =
+      std::dynamic_pointer_cast<ContextImpl>(manager.createSslClientContext(store2, cfg2));
+  ContextImplSharedPtr context3 =
+      std::dynamic_pointer_cast<ContextImpl>(manager.createSslClientContext(store1, cfg3));
+
+  bssl::UniquePtr<SSL_CTX> ctx1 = context1->sslCtx();
+  bssl::UniquePtr<SSL_CTX> ctx2 = context2->sslCtx();
+  bssl::UniquePtr<SSL_CTX> ctx3 = context3->sslCtx();
+  EXPECT_EQ(ctx1.get(), ctx2.get());
+  EXPECT_NE(ctx1.get(), ctx3.get());
+  EXPECT_EQ(SSL_CTX_get_cert_store(ctx1.get()), SSL_CTX_get_cert_store(ctx3.get()));
+
+  // The per connection settings and the certificate information are still per context.
+  bssl::UniquePtr<SSL> ssl1 = context1->newSsl();
+  bssl::UniquePtr<SSL> ssl2 = context2->newSsl();
+  EXPECT_STREQ("a.example.com", SSL_get_servername(ssl1.get(), TLSEXT_NAMETYPE_host_name));
+  EXPECT_STREQ("b.example.com", SSL_get_servername(ssl2.get(), TLSEXT_NAMETYPE_host_name));
+  EXPECT_EQ(context1->getCertChainInformation(), context2->getCertChainInformation());
+  EXPECT_EQ(context1->getCaCertInformation(), context2->getCaCertInformation());
+
+  // The SSL_CTX outlives the context which built it.
+  context1.reset();
+  ContextImplSharedPtr context4 =
+      std::dynamic_pointer_cast<ContextImpl>(manager.createSslClientContext(store2, cfg1));
+  EXPECT_EQ(ctx2.get(), context4->sslCtx().get());
+}
+
+// Server contexts with the same SSL_CTX config and server names share their SSL_CTX, so that a
+// certificate rotated by SDS is loaded once for all the listeners using it.
+TEST_F(SslContextImplTest, TestSharedServerSslCtx) {
+  const auto json = [](const std::string& name) -> std::string {
+    return "{\"cert_chain_file\": \"{{ test_rundir }}/test/common/ssl/test_data/" + name +
+           "_cert.pem\", \"private_key_file\": \"{{ test_rundir }}/test/common/ssl/test_data/" +
+           name + "_key.pem\", \"alpn_protocols\": \"h2,http/1.1\"}";
+  };
+
+  Json::ObjectSharedPtr loader1 = TestEnvironment::jsonLoadFromString(json("san_dns"));
+  ServerContextConfigImpl cfg1(*loader1, factory_context_);
+  Json::ObjectSharedPtr loader2 = TestEnvironment::jsonLoadFromString(json("san_uri"));
+  ServerContextConfigImpl cfg2(*loader2, factory_context_);
+  Runtime::MockLoader runtime;
+  ContextManagerImpl manager(runtime);
+  Stats::IsolatedStoreImpl store1;
+  Stats::IsolatedStoreImpl store2;
+
+  ContextImplSharedPtr context1 = std::dynamic_pointer_cast<ContextImpl>(
+      manager.createSslServerContext(store1, cfg1, std::vector<std::string>{}));
+  ContextImplSharedPtr context2 = std::dynamic_pointer_cast<ContextImpl>(
+      manager.createSslServerContext(store2, cfg1, std::vector<std::string>{}));
+  ContextImplSharedPtr context3 = std::dynamic_pointer_cast<ContextImpl>(
+      manager.createSslServerContext(store1, cfg1, std::vector<std::string>{"example.com"}));
+  ContextImplSharedPtr context4 = std::dynamic_pointer_cast<ContextImpl>(
+      manager.createSslServerContext(store1, cfg2, std::vector<std::string>{}));
+
+  bssl::UniquePtr<SSL_CTX> ctx1 = context1->sslCtx();
+  EXPECT_EQ(ctx1.get(), context2->sslCtx().get());
+  EXPECT_NE(ctx1.get(), context3->sslCtx().get());
+  EXPECT_NE(ctx1.get(), context4->sslCtx().get());
+  EXPECT_EQ(context1->getCertChainInformation(), context2->getCertChainInformation());
+  EXPECT_NE(context1->getCertChainInformation(), context4->getCertChainInformation());
+}
+
+// Parse errors are reported when creating the context, with the path of the bundle.
+TEST_F(SslContextImplTest, TestPreparedInvalidTrustedCa) {
+  std::string json = R"EOF(
+  {
+    "ca_cert_file": "{{ test_rundir }}/test/common/ssl/test_data/not_a_crl.crl"
+  }
+  )EOF";
+
+  Json::ObjectSharedPtr loader = TestEnvironment::jsonLoadFromString(json);
+  ClientContextConfigImpl cfg(*loader, factory_context_);
+  Runtime::MockLoader runtime;
+  ContextManagerImpl manager(runtime);
+  Stats::IsolatedStoreImpl store;
+
+  TrustedCaConstSharedPtr trusted_ca =
+      manager.prepareTrustedCa(cfg.certificateValidationContext()->caCert());
+  EXPECT_NE(nullptr, trusted_ca);
+  EXPECT_THROW_WITH_REGEX(manager.createSslClientContext(store, cfg), EnvoyException,
+                          "^Failed to load trusted CA certificates from .*not_a_crl.crl$");
+}
+
+// Verified chains are cached by fingerprint until the first of their certificates expires, and the
+// least recently used chain is evicted.
+TEST_F(SslContextImplTest, TestCertificateVerificationCache) {
+  const auto read_cert = [](const std::string& name) {
+    const std::string pem = TestEnvironment::readFileToStringForTest(
+        TestEnvironment::runfilesPath("test/common/ssl/test_data/" + name));
+    bssl::UniquePtr<BIO> bio(BIO_new_mem_buf(pem.data(), pem.size()));
+    bssl::UniquePtr<X509> cert(PEM_read_bio_X509(bio.get(), nullptr, nullptr, nullptr));
+    EXPECT_NE(nullptr, cert);
+    return cert;
+  };
+  bssl::UniquePtr<X509> dns_cert = read_cert("san_dns_cert.pem");
+  bssl::UniquePtr<X509> uri_cert = read_cert("san_uri_cert.pem");
+  bssl::UniquePtr<X509> expired_cert = read_cert("expired_cert.pem");
+
+  const std::string dns_fingerprint =
+      CertificateVerificationCache::fingerprint(dns_cert.get(), nullptr);
+  const std::string uri_fingerprint =
+      CertificateVerificationCache::fingerprint(uri_cert.get(), nullptr);
+  const std::string expired_fingerprint =
+      CertificateVerificationCache::fingerprint(expired_cert.get(), nullptr);
+  EXPECT_NE(dns_fingerprint, uri_fingerprint);
+
+  CertificateVerificationCache cache(1);
+  EXPECT_FALSE(cache.lookup(dns_fingerprint));
+  cache.insert(dns_fingerprint, dns_cert.get(), nullptr);
+  EXPECT_TRUE(cache.lookup(dns_fingerprint));
+
+  // Expired certificates, including the ones of the verified chain, are not cached.
+  cache.insert(expired_fingerprint, expired_cert.get(), nullptr);
+  EXPECT_FALSE(cache.lookup(expired_fingerprint));
+  bssl::UniquePtr<STACK_OF(X509)> chain(sk_X509_new_null());
+  X509_up_ref(expired_cert.get());
+  sk_X509_push(chain.get(), expired_cert.get());
+  cache.insert(uri_fingerprint, uri_cert.get(), chain.get());
+  EXPECT_FALSE(cache.lookup(uri_fingerprint));
+  EXPECT_TRUE(cache.lookup(dns_fingerprint));
+
+  cache.insert(uri_fingerprint, uri_cert.get(), nullptr);
+  EXPECT_TRUE(cache.lookup(uri_fingerprint));
+  EXPECT_FALSE(cache.lookup(dns_fingerprint));
+}
+
 TEST_F(SslContextImplTest, TestNoCert) {
   Json::ObjectSharedPtr loader = TestEnvironment::jsonLoadFromString("{}");
   ClientContextConfigImpl cfg(*loader, factory_context_);
@@ -297,10 +478,11 @@ TEST_F(SslServerContextImplTicketTest, TicketKeyInlineStringFailTooSmall) {
   EXPECT_THROW(loadConfigV2(cfg), EnvoyException);
 }
 
-TEST_F(SslServerContextImplTicketTest, TicketKeySdsFail) {
+TEST_F(SslServerContextImplTicketTest, TicketKeyUnknownStaticSecret) {
   envoy::api::v2::auth::DownstreamTlsContext cfg;
-  cfg.mutable_session_ticket_keys_sds_secret_config();
-  EXPECT_THROW_WITH_MESSAGE(loadConfigV2(cfg), EnvoyException, "SDS not supported yet");
+  cfg.mutable_session_ticket_keys_sds_secret_config()->set_name("ticket_keys");
+  EXPECT_THROW_WITH_MESSAGE(loadConfigV2(cfg), EnvoyException,
+                            "Unknown static session ticket keys: ticket_keys");
 }
 
 TEST_F(SslServerContextImplTicketTest, CRLSuccess) {
@@ -602,6 +784,24 @@ TEST(ClientContextConfigImplTest, MissingStaticCertificateValidationContext) {
       "Unknown static certificate validation context: missing");
 }
 
+// Validate that the private key provider of a certificate must be registered.
+TEST(ServerContextConfigImplTest, UnknownPrivateKeyProvider) {
+  envoy::api::v2::auth::DownstreamTlsContext tls_context;
+  const std::string tls_context_yaml = R"EOF(
+  common_tls_context:
+    tls_certificates:
+      certificate_chain:
+        filename: "{{ test_rundir }}/test/common/ssl/test_data/selfsigned_cert.pem"
+      private_key_provider:
+        provider_name: "unknown"
+  )EOF";
+  MessageUtil::loadFromYaml(TestEnvironment::substitute(tls_context_yaml), tls_context);
+  NiceMock<Server::Configuration::MockTransportSocketFactoryContext> factory_context;
+  EXPECT_THROW_WITH_MESSAGE(
+      ServerContextConfigImpl server_context_config(tls_context, factory_context), EnvoyException,
+      "Didn't find a registered implementation for name: 'unknown'");
+}
+
 // Multiple TLS certificates are not yet supported, but one is expected for
 // server.
 // TODO(PiotrSikora): Support multiple TLS certificates.
@@ -655,6 +855,79 @@ TEST(ServerContextConfigImplTest, SecretNotReady) {
   EXPECT_FALSE(server_context_config.isReady());
 }
 
+// Validate that server context config with static session ticket keys is created successfully.
+TEST(ServerContextConfigImplTest, StaticSessionTicketKeys) {
+  envoy::api::v2::auth::Secret secret_config;
+  const std::string yaml = R"EOF(
+name: "ticket_keys"
+session_ticket_keys:
+  keys:
+    - filename: "{{ test_rundir }}/test/common/ssl/test_data/ticket_key_a"
+    - filename: "{{ test_rundir }}/test/common/ssl/test_data/ticket_key_b"
+)EOF";
+  MessageUtil::loadFromYaml(TestEnvironment::substitute(yaml), secret_config);
+
+  envoy::api::v2::auth::DownstreamTlsContext tls_context;
+  tls_context.mutable_common_tls_context()->add_tls_certificates();
+  tls_context.mutable_session_ticket_keys_sds_secret_config()->set_name("ticket_keys");
+
+  NiceMock<Server::Configuration::MockTransportSocketFactoryContext> factory_context;
+  factory_context.secretManager().addStaticSecret(secret_config);
+  ServerContextConfigImpl server_context_config(tls_context, factory_context);
+
+  EXPECT_TRUE(server_context_config.isReady());
+  EXPECT_EQ(2, server_context_config.sessionTicketKeys().size());
+}
+
+// Validate that server context config is not ready until the session ticket keys are delivered by
+// SDS, and that the keys are updated along with the secret.
+TEST(ServerContextConfigImplTest, SdsSessionTicketKeys) {
+  NiceMock<LocalInfo::MockLocalInfo> local_info;
+  NiceMock<Event::MockDispatcher> dispatcher;
+  NiceMock<Runtime::MockRandomGenerator> random;
+  Stats::IsolatedStoreImpl stats;
+  NiceMock<Upstream::MockClusterManager> cluster_manager;
+  NiceMock<Init::MockManager> init_manager;
+  NiceMock<Server::Configuration::MockTransportSocketFactoryContext> factory_context;
+  EXPECT_CALL(factory_context, localInfo()).WillOnce(ReturnRef(local_info));
+  EXPECT_CALL(factory_context, dispatcher()).WillOnce(ReturnRef(dispatcher));
+  EXPECT_CALL(factory_context, random()).WillOnce(ReturnRef(random));
+  EXPECT_CALL(factory_context, stats()).WillOnce(ReturnRef(stats));
+  EXPECT_CALL(factory_context, clusterManager()).WillOnce(ReturnRef(cluster_manager));
+  EXPECT_CALL(factory_context, initManager()).WillRepeatedly(Return(&init_manager));
+
+  envoy::api::v2::auth::DownstreamTlsContext tls_context;
+  tls_context.mutable_common_tls_context()->add_tls_certificates();
+  auto* sds_secret_config = tls_context.mutable_session_ticket_keys_sds_secret_config();
+  sds_secret_config->set_name("ticket_keys");
+  sds_secret_config->mutable_sds_config();
+  ServerContextConfigImpl server_context_config(tls_context, factory_context);
+  // When sds secret is not downloaded, config is not ready.
+  EXPECT_FALSE(server_context_config.isReady());
+
+  uint32_t update_count = 0;
+  server_context_config.setSecretUpdateCallback([&]() {
+    update_count++;
+    EXPECT_EQ(1, server_context_config.sessionTicketKeys().size());
+  });
+
+  const std::string yaml = R"EOF(
+name: "ticket_keys"
+session_ticket_keys:
+  keys:
+    - filename: "{{ test_rundir }}/test/common/ssl/test_data/ticket_key_a"
+)EOF";
+  Protobuf::RepeatedPtrField<envoy::api::v2::auth::Secret> secret_resources;
+  MessageUtil::loadFromYaml(TestEnvironment::substitute(yaml), *secret_resources.Add());
+  auto& sds_api = dynamic_cast<Secret::TlsSessionTicketKeysSdsApi&>(
+      *factory_context.secretManager().findOrCreateTlsSessionTicketKeysProvider(
+          sds_secret_config->sds_config(), "ticket_keys", factory_context));
+  sds_api.onConfigUpdate(secret_resources, "");
+
+  EXPECT_TRUE(server_context_config.isReady());
+  EXPECT_EQ(1, update_count);
+}
+
 // TlsCertificate messages must have a cert for servers.
 TEST(ServerContextImplTest, TlsCertificateNonEmpty) {
   envoy::api::v2::auth::DownstreamTlsContext tls_context;
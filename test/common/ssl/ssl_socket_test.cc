@@ -1,10 +1,17 @@
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "envoy/network/transport_socket.h"
 
 #include "common/buffer/buffer_impl.h"
+#include "common/buffer/watermark_buffer.h"
 #include "common/common/empty_string.h"
 #include "common/event/dispatcher_impl.h"
 #include "common/json/json_loader.h"
@@ -31,6 +38,7 @@
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "openssl/err.h"
 #include "openssl/ssl.h"
 
 using testing::_;
@@ -773,6 +781,26 @@ TEST_P(SslSocketTest, ClientCertificateExpirationAllowedVerification) {
              "ssl.handshake", 2, GetParam());
 }
 
+// Validate that the handshake completes when the server signs on the thread pool of a private
+// key provider.
+TEST_P(SslSocketTest, ThreadPoolPrivateKeyProvider) {
+  envoy::api::v2::Listener listener;
+  envoy::api::v2::auth::UpstreamTlsContext client;
+
+  configureServerAndExpiredClientCertificate(listener, client);
+
+  auto* common_tls_context =
+      listener.mutable_filter_chains(0)->mutable_tls_context()->mutable_common_tls_context();
+  common_tls_context->mutable_validation_context()->set_allow_expired_certificate(true);
+  auto* private_key_provider =
+      common_tls_context->mutable_tls_certificates(0)->mutable_private_key_provider();
+  private_key_provider->set_provider_name("envoy.private_key_providers.thread_pool");
+  (*private_key_provider->mutable_config()->mutable_fields())["threads"].set_number_value(2);
+
+  testUtilV2(listener, client, "", true, "", "", "spiffe://lyft.com/test-team", "", "",
+             "ssl.handshake", 2, GetParam());
+}
+
 // Allow expired certificates, but add a certificate hash requirement so it still fails.
 TEST_P(SslSocketTest, FailedClientCertAllowExpiredBadHashVerification) {
   envoy::api::v2::Listener listener;
@@ -2871,6 +2899,12 @@ TEST_P(SslReadBufferLimitTest, NoLimitSmallWrites) {
   readBufferLimitTest(0, 256 * 1024, 1, 256 * 1024, false);
 }
 
+// Writes whose records span slices of the write buffer, and which are large enough for the records
+// to grow to full size.
+TEST_P(SslReadBufferLimitTest, NoLimitWritesSpanningSlices) {
+  readBufferLimitTest(0, 512 * 1024, 1000, 300, false);
+}
+
 TEST_P(SslReadBufferLimitTest, SomeLimit) {
   readBufferLimitTest(32 * 1024, 32 * 1024, 256 * 1024, 1, false);
 }
@@ -2916,5 +2950,247 @@ TEST_P(SslReadBufferLimitTest, TestBind) {
   disconnect();
 }
 
+// Drives a server SslSocket directly over a socket pair, against a client SSL whose input and
+// output the test moves by hand, so that the records written by the socket can be inspected.
+class SslSocketRecordTest : public SslCertsTest {
+protected:
+  SslSocketRecordTest() {
+    int fds[2];
+    RELEASE_ASSERT(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0, "");
+    fd_ = fds[0];
+    peer_fd_ = fds[1];
+    RELEASE_ASSERT(::fcntl(fd_, F_SETFL, O_NONBLOCK) == 0, "");
+    RELEASE_ASSERT(::fcntl(peer_fd_, F_SETFL, O_NONBLOCK) == 0, "");
+    // Keep the socket small, so that large writes fill it part way through the records.
+    const int send_buffer_size = 16 * 1024;
+    RELEASE_ASSERT(::setsockopt(fd_, SOL_SOCKET, SO_SNDBUF, &send_buffer_size,
+                                sizeof(send_buffer_size)) == 0,
+                   "");
+
+    const std::string server_ctx_json = R"EOF(
+    {
+      "cert_chain_file": "{{ test_tmpdir }}/unittestcert.pem",
+      "private_key_file": "{{ test_tmpdir }}/unittestkey.pem"
+    }
+    )EOF";
+    Json::ObjectSharedPtr server_ctx_loader = TestEnvironment::jsonLoadFromString(server_ctx_json);
+    server_ssl_socket_factory_ = std::make_unique<ServerSslSocketFactory>(
+        std::make_unique<ServerContextConfigImpl>(*server_ctx_loader, factory_context_), manager_,
+        stats_store_, std::vector<std::string>{});
+    socket_ = server_ssl_socket_factory_->createTransportSocket();
+    ssl_socket_ = dynamic_cast<SslSocket*>(socket_.get());
+    RELEASE_ASSERT(ssl_socket_ != nullptr, "");
+    ON_CALL(callbacks_, fd()).WillByDefault(Return(fd_));
+    socket_->setTransportSocketCallbacks(callbacks_);
+
+    client_ctx_.reset(SSL_CTX_new(TLS_method()));
+    client_.reset(SSL_new(client_ctx_.get()));
+    SSL_set_connect_state(client_.get());
+    SSL_set_bio(client_.get(), BIO_new(BIO_s_mem()), BIO_new(BIO_s_mem()));
+  }
+
+  ~SslSocketRecordTest() {
+    socket_.reset();
+    ::close(fd_);
+    ::close(peer_fd_);
+  }
+
+  // Move everything the server socket wrote to the client, and return its length.
+  uint64_t toClient() {
+    uint64_t length = 0;
+    char data[16384];
+    ssize_t rc;
+    while ((rc = ::read(peer_fd_, data, sizeof(data))) > 0) {
+      RELEASE_ASSERT(BIO_write(SSL_get_rbio(client_.get()), data, rc) == rc, "");
+      length += rc;
+    }
+    return length;
+  }
+
+  // Move everything the client wrote to the server socket.
+  void toServer() {
+    BIO* bio = SSL_get_wbio(client_.get());
+    const uint8_t* data;
+    size_t length;
+    RELEASE_ASSERT(BIO_mem_contents(bio, &data, &length) == 1, "");
+    RELEASE_ASSERT(::write(peer_fd_, data, length) == static_cast<ssize_t>(length), "");
+    BIO_reset(bio);
+  }
+
+  void handshake() {
+    EXPECT_CALL(callbacks_, raiseEvent(Network::ConnectionEvent::Connected));
+    Buffer::OwnedImpl buffer;
+    for (int i = 0; i < 10 && (!ssl_socket_->handshakeComplete() || SSL_in_init(client_.get()));
+         i++) {
+      SSL_do_handshake(client_.get());
+      toServer();
+      EXPECT_EQ(Network::PostIoAction::KeepOpen, socket_->doRead(buffer).action_);
+      // Each flight of the server is written to the socket as soon as it is produced.
+      EXPECT_FALSE(ssl_socket_->hasPendingOutput());
+      toClient();
+    }
+    ASSERT_TRUE(ssl_socket_->handshakeComplete());
+    ASSERT_FALSE(SSL_in_init(client_.get()));
+    EXPECT_EQ(0U, buffer.length());
+  }
+
+  // Decrypt the records the client received in full. SSL_read() returns the plaintext of one record
+  // at a time, whose lengths are appended to record_lengths.
+  // @return int the SSL error of the last SSL_read().
+  int readRecords(std::vector<int>& record_lengths, std::string& plaintext) {
+    char data[SSL3_RT_MAX_PLAIN_LENGTH];
+    int rc;
+    while ((rc = SSL_read(client_.get(), data, sizeof(data))) > 0) {
+      record_lengths.push_back(rc);
+      plaintext.append(data, rc);
+    }
+    return SSL_get_error(client_.get(), rc);
+  }
+
+  static std::string testData(uint64_t length) {
+    std::string data(length, 0);
+    for (uint64_t i = 0; i < length; i++) {
+      data[i] = 'a' + i % 26;
+    }
+    return data;
+  }
+
+  Stats::IsolatedStoreImpl stats_store_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  ContextManagerImpl manager_{runtime_};
+  std::unique_ptr<ServerSslSocketFactory> server_ssl_socket_factory_;
+  NiceMock<Network::MockTransportSocketCallbacks> callbacks_;
+  Network::TransportSocketPtr socket_;
+  SslSocket* ssl_socket_;
+  int fd_;
+  int peer_fd_;
+  bssl::UniquePtr<SSL_CTX> client_ctx_;
+  bssl::UniquePtr<SSL> client_;
+};
+
+// Test that the handshake is written to the socket through the write BIO of the socket.
+TEST_F(SslSocketRecordTest, HandshakeOutput) {
+  handshake();
+  EXPECT_NE(nullptr, SSL_get_current_cipher(client_.get()));
+}
+
+// Test that records fit in a TCP segment for the first 128 KiB written on a connection, and are
+// full sized afterwards.
+TEST_F(SslSocketRecordTest, DynamicRecordSizing) {
+  handshake();
+  const std::string data = testData(512 * 1024);
+  Buffer::OwnedImpl buffer(data);
+  std::vector<int> record_lengths;
+  std::string received;
+  while (buffer.length() > 0) {
+    EXPECT_EQ(Network::PostIoAction::KeepOpen, socket_->doWrite(buffer, false).action_);
+    toClient();
+    readRecords(record_lengths, received);
+  }
+  EXPECT_EQ(data, received);
+
+  std::vector<int> expected_record_lengths;
+  for (uint64_t offset = 0; offset < data.size(); offset += expected_record_lengths.back()) {
+    const uint64_t record_length = offset < 128 * 1024 ? 1300 : SSL3_RT_MAX_PLAIN_LENGTH;
+    expected_record_lengths.push_back(std::min(record_length, data.size() - offset));
+  }
+  EXPECT_EQ(expected_record_lengths, record_lengths);
+}
+
+// Test that when the socket fills up part way through the records, only the plaintext of the
+// records written in full is drained from the write buffer, so that its watermarks are accurate.
+TEST_F(SslSocketRecordTest, PartialWrites) {
+  handshake();
+  uint32_t below_low_watermark = 0;
+  uint32_t above_high_watermark = 0;
+  Buffer::WatermarkBuffer buffer([&]() -> void { below_low_watermark++; },
+                                 [&]() -> void { above_high_watermark++; });
+  buffer.setWatermarks(64 * 1024, 128 * 1024);
+  const std::string data = testData(512 * 1024);
+  buffer.add(data);
+  EXPECT_EQ(1U, above_high_watermark);
+
+  std::vector<int> record_lengths;
+  std::string received;
+  uint64_t written = 0;
+  uint32_t writes = 0;
+  uint32_t partial_records = 0;
+  while (buffer.length() > 0) {
+    const Network::IoResult result = socket_->doWrite(buffer, false);
+    EXPECT_EQ(Network::PostIoAction::KeepOpen, result.action_);
+    written += result.bytes_processed_;
+    writes++;
+    EXPECT_EQ(data.size() - written, buffer.length());
+    EXPECT_EQ(buffer.length() < 64 * 1024 ? 1U : 0U, below_low_watermark);
+
+    toClient();
+    readRecords(record_lengths, received);
+    // The plaintext drained is exactly that of the records the client can decrypt.
+    EXPECT_EQ(written, received.size());
+    if (BIO_pending(SSL_get_rbio(client_.get())) > 0) {
+      partial_records++;
+    }
+  }
+  EXPECT_EQ(data, received);
+  EXPECT_EQ(1U, above_high_watermark);
+  EXPECT_GT(writes, 1U);
+  EXPECT_GT(partial_records, 0U);
+}
+
+// Test that an alert sent by the socket when it fails to read a record reaches the peer.
+TEST_F(SslSocketRecordTest, AlertOutput) {
+  handshake();
+  ASSERT_EQ(5, SSL_write(client_.get(), "hello", 5));
+  // Corrupt the authentication tag of the record.
+  BIO* bio = SSL_get_wbio(client_.get());
+  const uint8_t* data;
+  size_t length;
+  ASSERT_EQ(1, BIO_mem_contents(bio, &data, &length));
+  std::string record(reinterpret_cast<const char*>(data), length);
+  record.back() ^= 1;
+  ASSERT_EQ(static_cast<ssize_t>(record.size()), ::write(peer_fd_, record.data(), record.size()));
+  BIO_reset(bio);
+
+  Buffer::OwnedImpl buffer;
+  EXPECT_EQ(Network::PostIoAction::Close, socket_->doRead(buffer).action_);
+  EXPECT_FALSE(ssl_socket_->hasPendingOutput());
+  EXPECT_GT(toClient(), 0U);
+
+  char plaintext[16];
+  EXPECT_GT(0, SSL_read(client_.get(), plaintext, sizeof(plaintext)));
+  EXPECT_EQ(SSL_R_SSLV3_ALERT_BAD_RECORD_MAC, ERR_GET_REASON(ERR_peek_error()));
+  ERR_clear_error();
+}
+
+// Test that close_notify follows the records which were pending when the socket was closed, and
+// that the plaintext of the records written by the shutdown is drained by the next write.
+TEST_F(SslSocketRecordTest, ShutdownWithPendingRecords) {
+  handshake();
+  const std::string data = testData(256 * 1024);
+  Buffer::OwnedImpl buffer(data);
+  uint64_t written = socket_->doWrite(buffer, true).bytes_processed_;
+  ASSERT_GT(buffer.length(), 0U);
+
+  // Make room on the socket for some of the pending records.
+  std::vector<int> record_lengths;
+  std::string received;
+  toClient();
+  readRecords(record_lengths, received);
+  socket_->closeSocket(Network::ConnectionEvent::LocalClose);
+  EXPECT_TRUE(ssl_socket_->hasPendingOutput());
+  EXPECT_EQ(data.size() - written, buffer.length());
+
+  while (buffer.length() > 0 || ssl_socket_->hasPendingOutput()) {
+    toClient();
+    const Network::IoResult result = socket_->doWrite(buffer, true);
+    EXPECT_EQ(Network::PostIoAction::KeepOpen, result.action_);
+    written += result.bytes_processed_;
+    EXPECT_EQ(data.size() - written, buffer.length());
+  }
+  toClient();
+  EXPECT_EQ(SSL_ERROR_ZERO_RETURN, readRecords(record_lengths, received));
+  EXPECT_EQ(data, received);
+}
+
 } // namespace Ssl
 } // namespace Envoy
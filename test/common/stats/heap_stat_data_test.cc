@@ -17,7 +17,7 @@ TEST(HeapStatDataTest, HeapNoTruncate) {
   const std::string long_string(stats_options.maxNameLength() + 1, 'A');
   HeapStatData* stat{};
   EXPECT_NO_LOGS(stat = alloc.alloc(long_string));
-  EXPECT_EQ(stat->key(), long_string);
+  EXPECT_EQ(stat->name(), long_string);
   alloc.free(*stat);
 }
 
@@ -38,5 +38,24 @@ TEST(HeapStatDataTest, HeapAlloc) {
   alloc.free(*stat_3);
 }
 
+// Stats allocated one after another are laid out next to each other, looking a name up doesn't
+// take a slot, and the slots of freed stats are reused.
+TEST(HeapStatDataTest, HeapSlabs) {
+  HeapStatDataAllocator alloc;
+  HeapStatData* stat_1 = alloc.alloc("stat_1");
+  HeapStatData* stat_1_ref = alloc.alloc("stat_1");
+  HeapStatData* stat_2 = alloc.alloc("stat_2");
+  EXPECT_EQ(stat_1, stat_1_ref);
+  EXPECT_EQ(stat_1 + 1, stat_2);
+
+  alloc.free(*stat_1);
+  alloc.free(*stat_1_ref);
+  HeapStatData* stat_3 = alloc.alloc("stat_3");
+  EXPECT_EQ(stat_1, stat_3);
+  EXPECT_EQ("stat_3", stat_3->name());
+  alloc.free(*stat_2);
+  alloc.free(*stat_3);
+}
+
 } // namespace Stats
 } // namespace Envoy
@@ -1,5 +1,6 @@
 #include <vector>
 
+#include "common/stats/isolated_store_impl.h"
 #include "common/stats/source_impl.h"
 
 #include "test/mocks/stats/mocks.h"
@@ -47,5 +48,49 @@ TEST(SourceImplTest, Caching) {
   EXPECT_EQ(source.cachedHistograms(), stored_histograms);
 }
 
+TEST(SourceImplTest, ChangedSinceLastFlush) {
+  IsolatedStoreImpl store;
+  Counter& idle_counter = store.counter("idle_counter");
+  Counter& busy_counter = store.counter("busy_counter");
+  Gauge& idle_gauge = store.gauge("idle_gauge");
+  Gauge& busy_gauge = store.gauge("busy_gauge");
+  idle_counter.inc();
+  idle_gauge.set(1);
+
+  // Stats that were never updated are not reported.
+  SourceImpl source(store);
+  ASSERT_EQ(1UL, source.cachedChangedCounters().size());
+  EXPECT_EQ("idle_counter", source.cachedChangedCounters()[0]->name());
+  ASSERT_EQ(1UL, source.cachedChangedGauges().size());
+  EXPECT_EQ("idle_gauge", source.cachedChangedGauges()[0]->name());
+  source.clearCache();
+
+  // Only the stats updated since the previous flush are reported, even if the value is the same.
+  busy_counter.inc();
+  busy_gauge.set(0);
+  ASSERT_EQ(1UL, source.cachedChangedCounters().size());
+  EXPECT_EQ("busy_counter", source.cachedChangedCounters()[0]->name());
+  ASSERT_EQ(1UL, source.cachedChangedGauges().size());
+  EXPECT_EQ("busy_gauge", source.cachedChangedGauges()[0]->name());
+
+  // The changed set is computed once per flush, so every sink sees the same one.
+  idle_counter.inc();
+  idle_gauge.dec();
+  EXPECT_EQ(1UL, source.cachedChangedCounters().size());
+  EXPECT_EQ(1UL, source.cachedChangedGauges().size());
+  EXPECT_EQ(2UL, source.cachedCounters().size());
+  EXPECT_EQ(2UL, source.cachedGauges().size());
+  source.clearCache();
+
+  ASSERT_EQ(1UL, source.cachedChangedCounters().size());
+  EXPECT_EQ("idle_counter", source.cachedChangedCounters()[0]->name());
+  ASSERT_EQ(1UL, source.cachedChangedGauges().size());
+  EXPECT_EQ("idle_gauge", source.cachedChangedGauges()[0]->name());
+  source.clearCache();
+
+  EXPECT_TRUE(source.cachedChangedCounters().empty());
+  EXPECT_TRUE(source.cachedChangedGauges().empty());
+}
+
 } // namespace Stats
 } // namespace Envoy
@@ -0,0 +1,262 @@
+// Usage: bazel run //test/common/stats:stats_benchmark -c opt
+//
+// Measures the stats hot path, i.e. counter increments and histogram records from one thread and
+// from several, as well as stat and scope creation with the default tag extractors, histogram
+// merges and the memory of a stat. Stores are set up like the server's, with the heap allocator
+// and the default tag producer, but with mock thread local storage, so histograms are recorded and
+// merged as if on a single worker.
+
+#include <string>
+#include <vector>
+
+#include "envoy/config/metrics/v2/stats.pb.h"
+
+#include "common/common/fmt.h"
+#include "common/common/logger.h"
+#include "common/common/thread.h"
+#include "common/memory/stats.h"
+#include "common/stats/heap_stat_data.h"
+#include "common/stats/stats_options_impl.h"
+#include "common/stats/symbol_table_impl.h"
+#include "common/stats/tag_producer_impl.h"
+#include "common/stats/thread_local_store.h"
+
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/malloc_counter.h"
+
+#include "testing/base/public/benchmark.h"
+
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Stats {
+namespace {
+
+// The maximum number of threads of the contended benchmarks.
+const int MaxThreads = 16;
+
+// The names of the stats of a cluster, after its scope, as created by ClusterStats.
+const std::vector<std::string>& clusterStatNames() {
+  static const std::vector<std::string>* names = new std::vector<std::string>(
+      {"upstream_cx_total", "upstream_cx_active", "upstream_cx_http1_total",
+       "upstream_cx_http2_total", "upstream_cx_connect_fail", "upstream_cx_connect_timeout",
+       "upstream_cx_destroy", "upstream_cx_rx_bytes_total", "upstream_cx_tx_bytes_total",
+       "upstream_rq_total", "upstream_rq_active", "upstream_rq_pending_total",
+       "upstream_rq_pending_active", "upstream_rq_timeout", "upstream_rq_retry", "upstream_rq_200",
+       "upstream_rq_2xx", "upstream_rq_503", "upstream_rq_5xx", "membership_healthy",
+       "membership_total", "lb_healthy_panic", "update_attempt", "update_success"});
+  return *names;
+}
+
+/**
+ * A ThreadLocalStoreImpl set up like the server's, threading included.
+ */
+class BenchmarkStore {
+public:
+  BenchmarkStore(bool tag_extraction = true) : store_(options_, allocator_) {
+    if (tag_extraction) {
+      store_.setTagProducer(
+          std::make_unique<TagProducerImpl>(envoy::config::metrics::v2::StatsConfig()));
+    }
+    store_.initializeThreading(main_thread_dispatcher_, tls_);
+  }
+
+  ~BenchmarkStore() {
+    store_.shutdownThreading();
+    tls_.shutdownThread();
+  }
+
+  ThreadLocalStoreImpl& store() { return store_; }
+
+private:
+  StatsOptionsImpl options_;
+  HeapStatDataAllocator allocator_;
+  NiceMock<Event::MockDispatcher> main_thread_dispatcher_;
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  ThreadLocalStoreImpl store_;
+};
+
+void BM_CounterInc(benchmark::State& state) {
+  BenchmarkStore store;
+  Counter& counter = store.store().counter("cluster.service.upstream_rq_total");
+  for (auto _ : state) {
+    counter.inc();
+  }
+  benchmark::DoNotOptimize(counter.value());
+}
+BENCHMARK(BM_CounterInc);
+
+// Looks a counter up by name on every increment, like stats whose names depend on the request.
+void BM_CounterLookupAndInc(benchmark::State& state) {
+  BenchmarkStore store;
+  ScopePtr scope = store.store().createScope("cluster.service.");
+  scope->counter("upstream_rq_200");
+  for (auto _ : state) {
+    scope->counter("upstream_rq_200").inc();
+  }
+}
+BENCHMARK(BM_CounterLookupAndInc);
+
+// Increments from several threads of one shared counter, with argument 0, or of a counter per
+// thread, with argument 1. Counters created one after another share cache lines, so the latter
+// shows the cost of false sharing.
+void BM_CounterIncContended(benchmark::State& state) {
+  // Shared by the threads of a run, and never destroyed since the threads may outlive a run.
+  static std::vector<Counter*>* counters = []() {
+    BenchmarkStore* store = new BenchmarkStore();
+    auto* counters = new std::vector<Counter*>();
+    for (int i = 0; i < MaxThreads; i++) {
+      counters->push_back(
+          &store->store().counter(fmt::format("cluster.service_{}.upstream_rq_total", i)));
+    }
+    return counters;
+  }();
+  Counter& counter = *(*counters)[state.range(0) == 0 ? 0 : state.thread_index];
+  for (auto _ : state) {
+    counter.inc();
+  }
+}
+BENCHMARK(BM_CounterIncContended)->Arg(0)->Arg(1)->ThreadRange(1, MaxThreads)->UseRealTime();
+
+void BM_HistogramRecord(benchmark::State& state) {
+  BenchmarkStore store;
+  Histogram& histogram = store.store().histogram("cluster.service.upstream_rq_time");
+  uint64_t value = 0;
+  for (auto _ : state) {
+    // Latencies in ms are mostly small, with some repetition.
+    histogram.recordValue(value++ % 97);
+  }
+}
+BENCHMARK(BM_HistogramRecord);
+
+// Merges as many histograms as the first argument, each with as many distinct values recorded
+// since the last merge as the second argument.
+void BM_HistogramMerge(benchmark::State& state) {
+  BenchmarkStore store;
+  std::vector<Histogram*> histograms;
+  for (int64_t i = 0; i < state.range(0); i++) {
+    histograms.push_back(
+        &store.store().histogram(fmt::format("cluster.service_{}.upstream_rq_time", i)));
+  }
+  for (auto _ : state) {
+    state.PauseTiming();
+    for (Histogram* histogram : histograms) {
+      for (int64_t value = 0; value < state.range(1); value++) {
+        histogram->recordValue(value * 7);
+      }
+    }
+    state.ResumeTiming();
+    store.store().mergeHistograms([]() -> void {});
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_HistogramMerge)
+    ->Args({10, 10})
+    ->Args({1000, 10})
+    ->Args({1000, 1000})
+    ->Args({10000, 10})
+    ->Unit(benchmark::kMicrosecond);
+
+// Creates the stats of a new cluster and destroys them with its scope, with tag extraction when
+// the argument is 1.
+void BM_ClusterStatsCreate(benchmark::State& state) {
+  BenchmarkStore store(state.range(0) == 1);
+  uint64_t cluster = 0;
+  for (auto _ : state) {
+    ScopePtr scope = store.store().createScope(fmt::format("cluster.service_{}.", cluster++));
+    for (const std::string& name : clusterStatNames()) {
+      scope->counter(name);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * clusterStatNames().size());
+}
+BENCHMARK(BM_ClusterStatsCreate)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+// Creates and destroys a scope with one stat while as many other scopes as the argument are alive.
+void BM_ScopeCreateDestroy(benchmark::State& state) {
+  BenchmarkStore store;
+  std::vector<ScopePtr> scopes;
+  for (int64_t i = 0; i < state.range(0); i++) {
+    scopes.push_back(store.store().createScope(fmt::format("cluster.service_{}.", i)));
+    scopes.back()->counter("upstream_rq_total");
+  }
+  for (auto _ : state) {
+    ScopePtr scope = store.store().createScope("cluster.service.");
+    scope->counter("upstream_rq_total");
+  }
+}
+BENCHMARK(BM_ScopeCreateDestroy)->Arg(0)->Arg(100)->Arg(10000);
+
+void BM_TagExtraction(benchmark::State& state) {
+  TagProducerImpl tag_producer{envoy::config::metrics::v2::StatsConfig()};
+  const std::string name = "http.ingress_http.downstream_rq_2xx";
+  for (auto _ : state) {
+    std::vector<Tag> tags;
+    benchmark::DoNotOptimize(tag_producer.produceTags(name, tags));
+  }
+}
+BENCHMARK(BM_TagExtraction);
+
+void BM_SymbolTableEncode(benchmark::State& state) {
+  SymbolTableImpl symbol_table;
+  // Keeps the symbols alive, as the stats of a running server do.
+  const StatNameImpl existing = symbol_table.encodeInline("cluster.service.upstream_rq_total");
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(symbol_table.encodeInline("cluster.service.upstream_rq_total"));
+  }
+}
+BENCHMARK(BM_SymbolTableEncode);
+
+void BM_SymbolTableDecode(benchmark::State& state) {
+  SymbolTableImpl symbol_table;
+  const StatNameImpl name = symbol_table.encodeInline("cluster.service.upstream_rq_total");
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(name.toString());
+  }
+}
+BENCHMARK(BM_SymbolTableDecode);
+
+// Creates as many cluster stats as the argument in a new store. Reports the allocations and, in
+// tcmalloc builds, the bytes of a stat, store overhead included.
+void BM_MemoryPerStat(benchmark::State& state) {
+  const uint64_t clusters = state.range(0) / clusterStatNames().size();
+  const uint64_t stats = clusters * clusterStatNames().size();
+  double bytes = 0;
+  MallocCounter malloc_counter;
+  for (auto _ : state) {
+    const uint64_t start = Memory::Stats::totalCurrentlyAllocated();
+    BenchmarkStore store;
+    for (uint64_t cluster = 0; cluster < clusters; cluster++) {
+      const std::string prefix = fmt::format("cluster.service_{}.", cluster);
+      for (const std::string& name : clusterStatNames()) {
+        store.store().counter(prefix + name);
+      }
+    }
+    bytes += static_cast<double>(Memory::Stats::totalCurrentlyAllocated()) - start;
+  }
+  const double total_stats = static_cast<double>(state.iterations() * stats);
+  state.SetItemsProcessed(state.iterations() * stats);
+  if (MallocCounter::supported()) {
+    state.counters["allocs_per_stat"] = malloc_counter.count() / total_stats;
+    state.counters["bytes_per_stat"] = bytes / total_stats;
+  }
+}
+BENCHMARK(BM_MemoryPerStat)->Arg(1000)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+} // namespace
+} // namespace Stats
+} // namespace Envoy
+
+// Boilerplate main(), which discovers benchmarks in the same file and runs them.
+int main(int argc, char** argv) {
+  Envoy::Thread::MutexBasicLockable lock;
+  Envoy::Logger::Registry::initialize(spdlog::level::warn,
+                                      Envoy::Logger::Logger::DEFAULT_LOG_FORMAT, lock);
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+}
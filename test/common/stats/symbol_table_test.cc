@@ -1,5 +1,6 @@
 #include <string>
 
+#include "common/common/fmt.h"
 #include "common/stats/symbol_table_impl.h"
 
 #include "test/test_common/logging.h"
@@ -136,6 +137,35 @@ TEST_F(StatNameTest, FreePoolTest) {
   EXPECT_EQ(table_.size(), 6);
 }
 
+TEST_F(StatNameTest, TestEncodingIdentifiesName) {
+  StatNameImpl stat_name_1 = table_.encodeInline("cluster.foo.upstream_rq_total");
+  StatNameImpl stat_name_2 = table_.encodeInline("cluster.foo.upstream_rq_total");
+  StatNameImpl stat_name_3 = table_.encodeInline("cluster.bar.upstream_rq_total");
+  EXPECT_EQ(stat_name_1.encoding(), stat_name_2.encoding());
+  EXPECT_NE(stat_name_1.encoding(), stat_name_3.encoding());
+  // Each of the few symbols in use fits in a single byte.
+  EXPECT_EQ(3, stat_name_1.encoding().size());
+}
+
+TEST_F(StatNameTest, TestMultiByteSymbolsRoundtrip) {
+  // Enough symbols that the later ones need more than one byte each.
+  std::vector<StatNamePtr> stat_names;
+  for (int i = 0; i < 1000; ++i) {
+    stat_names.push_back(table_.encode(fmt::format("foo.{}.bar", i)));
+  }
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(fmt::format("foo.{}.bar", i), stat_names[i]->toString());
+  }
+  EXPECT_EQ(1002, table_.size());
+
+  // Moving a name transfers the references to its symbols.
+  StatNameImpl moved(table_.encodeInline("foo.999.bar"));
+  StatNameImpl stat_name(std::move(moved));
+  stat_names.clear();
+  EXPECT_EQ("foo.999.bar", stat_name.toString());
+  EXPECT_EQ(3, table_.size());
+}
+
 TEST_F(StatNameTest, TestShrinkingExpectation) {
   // We expect that as we free stat names, the memory used to store those underlying symbols will
   // be freed.
@@ -351,5 +351,81 @@ TEST(TagExtractorTest, CreateTagExtractorNoRegex) {
                           EnvoyException, "^No regex specified for tag specifier and no default");
 }
 
+TEST(TagExtractorTokensTest, Basic) {
+  TagExtractorTokensImpl tag_extractor("prefix", "listener.**.http.$.**");
+  EXPECT_EQ("prefix", tag_extractor.name());
+  EXPECT_EQ("listener", tag_extractor.prefixToken());
+
+  std::string name = "listener.127.0.0.1_80.http.ingress.http.downstream_cx_total";
+  std::vector<Tag> tags;
+  IntervalSetImpl<size_t> remove_characters;
+  ASSERT_TRUE(tag_extractor.extractTag(name, tags, remove_characters));
+  EXPECT_EQ("listener.127.0.0.1_80.http.http.downstream_cx_total",
+            StringUtil::removeCharacters(name, remove_characters));
+  ASSERT_EQ(1, tags.size());
+  EXPECT_EQ("prefix", tags.at(0).name_);
+  EXPECT_EQ("ingress", tags.at(0).value_);
+
+  // The tag value cannot be the last token.
+  EXPECT_FALSE(tag_extractor.extractTag("listener.http.ingress", tags, remove_characters));
+  EXPECT_FALSE(tag_extractor.extractTag("listenerx.http.a.b", tags, remove_characters));
+  EXPECT_EQ(1, tags.size());
+
+  TagExtractorTokensImpl single_token("value", "*.$.last");
+  EXPECT_EQ("", single_token.prefixToken());
+  EXPECT_TRUE(single_token.extractTag("a.b.last", tags, remove_characters));
+  EXPECT_FALSE(single_token.extractTag("a.b.c.last", tags, remove_characters));
+}
+
+// Every default tag with a token pattern must extract exactly what its regex does.
+TEST(TagExtractorTokensTest, DefaultTokensMatchRegexes) {
+  const std::vector<std::string> names = {
+      "cluster",
+      "cluster.foo",
+      "cluster.foo.",
+      "cluster..upstream_rq_200",
+      "cluster.foo.upstream_rq_200",
+      "cluster.foo.grpc.svc.method.success",
+      "clusters.foo.bar",
+      "http.ingress.downstream_rq_2xx",
+      "http.ingress.user_agent.ios.downstream_cx_total",
+      "http.ingress",
+      "listener.http.ingress.downstream_cx_total",
+      "listener.127.0.0.1_80.http.ingress.downstream_cx_total",
+      "listener.[__1]_80.http.http.http.x",
+      "listener.0.0.0.0_80.http.ingress",
+      "listener.0.0.0.0_80.downstream_cx_total",
+      "listener.http",
+      "vhost.service.vcluster.other.upstream_rq_time",
+      "vhost.",
+      "mongo.mongo_filter.cmd.insert.total",
+      "mongo.x",
+  };
+
+  for (const auto& desc : Config::TagNames::get().descriptorVec()) {
+    if (desc.tokens_.empty()) {
+      continue;
+    }
+    TagExtractorImpl regex_extractor(desc.name_, desc.regex_, desc.substr_);
+    TagExtractorTokensImpl tokens_extractor(desc.name_, desc.tokens_);
+    EXPECT_EQ(regex_extractor.prefixToken(), tokens_extractor.prefixToken()) << desc.tokens_;
+    for (const std::string& name : names) {
+      std::vector<Tag> regex_tags;
+      IntervalSetImpl<size_t> regex_remove;
+      std::vector<Tag> tokens_tags;
+      IntervalSetImpl<size_t> tokens_remove;
+      const bool regex_match = regex_extractor.extractTag(name, regex_tags, regex_remove);
+      EXPECT_EQ(regex_match, tokens_extractor.extractTag(name, tokens_tags, tokens_remove))
+          << desc.tokens_ << " " << name;
+      if (regex_match && tokens_tags.size() == 1) {
+        EXPECT_EQ(regex_tags.at(0).value_, tokens_tags.at(0).value_) << desc.tokens_ << " " << name;
+        EXPECT_EQ(StringUtil::removeCharacters(name, regex_remove),
+                  StringUtil::removeCharacters(name, tokens_remove))
+            << desc.tokens_ << " " << name;
+      }
+    }
+  }
+}
+
 } // namespace Stats
 } // namespace Envoy
@@ -1,6 +1,7 @@
 #include <chrono>
 #include <memory>
 #include <string>
+#include <thread>
 #include <unordered_map>
 
 #include "common/common/c_smart_ptr.h"
@@ -492,6 +493,34 @@ TEST_F(HeapStatsThreadLocalStoreTest, NonHotRestartNoTruncation) {
   tls_.shutdownThread();
 }
 
+// Threads racing to create the same stats all end up with the one in the central cache.
+TEST_F(HeapStatsThreadLocalStoreTest, ConcurrentStatCreation) {
+  ScopePtr scope = store_->createScope("scope.");
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&scope]() -> void {
+      for (int j = 0; j < 1000; j++) {
+        scope->counter(fmt::format("c{}", j)).inc();
+        scope->histogram(fmt::format("h{}", j));
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  // Includes overflow stat.
+  EXPECT_EQ(1001UL, store_->counters().size());
+  EXPECT_EQ(1000UL, store_->histograms().size());
+  for (int j = 0; j < 1000; j++) {
+    EXPECT_EQ(4UL, TestUtility::findCounter(*store_, fmt::format("scope.c{}", j))->value());
+  }
+  EXPECT_EQ(0UL, store_->counter("stats.overflow").value());
+
+  scope.reset();
+  store_->shutdownThreading();
+}
+
 TEST_F(StatsThreadLocalStoreTest, ShuttingDown) {
   InSequence s;
   store_->initializeThreading(main_thread_dispatcher_, tls_);
@@ -597,6 +626,38 @@ TEST_F(HistogramTest, MultiHistogramMultipleMerges) {
   EXPECT_EQ(2, validateMerge());
 }
 
+// Enough histograms for the merge to be split between helper threads.
+TEST_F(HistogramTest, ParallelMerge) {
+  const int count = 10000;
+  EXPECT_CALL(sink_, onHistogramComplete(_, _)).Times(count);
+  for (int i = 0; i < count; i++) {
+    store_->histogram(fmt::format("h{}", i)).recordValue(i);
+  }
+  store_->mergeHistograms([]() -> void {});
+
+  for (const ParentHistogramSharedPtr& histogram : store_->histograms()) {
+    HistogramWrapper expected;
+    expected.setHistogramValues({std::stoul(histogram->name().substr(1))});
+    HistogramStatisticsImpl expected_statistics(expected.getHistogram());
+    EXPECT_EQ(expected_statistics.summary(), histogram->cumulativeStatistics().summary());
+    EXPECT_EQ(expected_statistics.summary(), histogram->intervalStatistics().summary());
+  }
+}
+
+TEST_F(HistogramTest, MergeWithoutNewValues) {
+  Histogram& h1 = store_->histogram("h1");
+  expectCallAndAccumulate(h1, 5);
+  EXPECT_EQ(1, validateMerge());
+
+  // The interval is emptied while the cumulative histogram keeps its values, over as many merges
+  // without new values as there are.
+  EXPECT_EQ(1, validateMerge());
+  EXPECT_EQ(1, validateMerge());
+
+  expectCallAndAccumulate(h1, 7);
+  EXPECT_EQ(1, validateMerge());
+}
+
 TEST_F(HistogramTest, BasicScopeHistogramMerge) {
   ScopePtr scope1 = store_->createScope("scope1.");
 
@@ -656,6 +717,23 @@ TEST_F(HistogramTest, BasicHistogramMergeSummary) {
   EXPECT_EQ(expected_summary, name_histogram_map["h1"]->cumulativeStatistics().summary());
 }
 
+// Values are buffered per thread and folded into the histogram in bulk, which must not lose any
+// of them, whether or not the buffer filled up before the merge.
+TEST_F(HistogramTest, BufferedValuesMerge) {
+  Histogram& h1 = store_->histogram("h1");
+
+  for (size_t i = 0; i < 100; ++i) {
+    expectCallAndAccumulate(h1, i % 7);
+  }
+  EXPECT_EQ(1, validateMerge());
+
+  for (size_t i = 0; i < 5; ++i) {
+    expectCallAndAccumulate(h1, 1000 + i % 2);
+  }
+  EXPECT_EQ(1, validateMerge());
+  EXPECT_EQ(1, validateMerge());
+}
+
 TEST_F(HistogramTest, BasicHistogramUsed) {
   ScopePtr scope1 = store_->createScope("scope1.");
 
@@ -757,6 +757,70 @@ TEST_F(TcpConnPoolImplTest, ConcurrentConnections) {
   dispatcher_.clearDeferredDeleteList();
 }
 
+/**
+ * Test that spare connections are opened ahead of demand according to the prefetch ratio.
+ */
+TEST_F(TcpConnPoolImplTest, PrefetchRatio) {
+  InSequence s;
+  cluster_->prefetch_ratio_ = 2;
+
+  // The first request opens its own connection plus a spare one.
+  ConnPoolCallbacks callbacks;
+  conn_pool_.expectConnCreate();
+  conn_pool_.expectConnCreate();
+  EXPECT_NE(nullptr, conn_pool_.newConnection(callbacks));
+  EXPECT_EQ(2U, cluster_->stats_.upstream_cx_total_.value());
+
+  // The first connection to come up is handed out and the other one stays ready.
+  EXPECT_CALL(*conn_pool_.test_conns_[0].connect_timer_, disableTimer());
+  EXPECT_CALL(callbacks.pool_ready_, ready());
+  conn_pool_.test_conns_[0].connection_->raiseEvent(Network::ConnectionEvent::Connected);
+  EXPECT_CALL(*conn_pool_.test_conns_[1].connect_timer_, disableTimer());
+  conn_pool_.test_conns_[1].connection_->raiseEvent(Network::ConnectionEvent::Connected);
+
+  // The next request takes the spare connection immediately and the pool is topped back up.
+  ConnPoolCallbacks callbacks2;
+  EXPECT_CALL(callbacks2.pool_ready_, ready());
+  conn_pool_.expectConnCreate();
+  conn_pool_.expectConnCreate();
+  EXPECT_EQ(nullptr, conn_pool_.newConnection(callbacks2));
+  EXPECT_EQ(&callbacks2.conn_data_->connection(), conn_pool_.test_conns_[1].connection_);
+  EXPECT_EQ(4U, cluster_->stats_.upstream_cx_total_.value());
+
+  EXPECT_CALL(conn_pool_, onConnReleasedForTest()).Times(2);
+  callbacks.conn_data_.reset();
+  callbacks2.conn_data_.reset();
+
+  // Disconnect all connections.
+  EXPECT_CALL(conn_pool_, onConnDestroyedForTest()).Times(4);
+  conn_pool_.test_conns_[3].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  conn_pool_.test_conns_[2].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  conn_pool_.test_conns_[1].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  conn_pool_.test_conns_[0].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  dispatcher_.clearDeferredDeleteList();
+}
+
+/**
+ * Test that prefetching warms the pool up to the minimum number of connections.
+ */
+TEST_F(TcpConnPoolImplTest, PrefetchMinConnections) {
+  InSequence s;
+  cluster_->prefetch_min_connections_ = 2;
+
+  conn_pool_.expectConnCreate();
+  conn_pool_.expectConnCreate();
+  conn_pool_.prefetch();
+
+  // Prefetching again does nothing while the pool is at its minimum size.
+  conn_pool_.prefetch();
+  EXPECT_EQ(2U, cluster_->stats_.upstream_cx_total_.value());
+
+  EXPECT_CALL(conn_pool_, onConnDestroyedForTest()).Times(2);
+  conn_pool_.test_conns_[1].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  conn_pool_.test_conns_[0].connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  dispatcher_.clearDeferredDeleteList();
+}
+
 /**
  * Tests ConnectionState lifecycle with multiple concurrent connections.
  */
@@ -0,0 +1,133 @@
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "common/event/dispatcher_impl.h"
+#include "common/tcp_proxy/splice_pump.h"
+
+#include "test/test_common/test_time.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::InSequence;
+using testing::Invoke;
+
+namespace Envoy {
+namespace TcpProxy {
+namespace {
+
+class MockSplicePumpCallbacks : public SplicePumpCallbacks {
+public:
+  MOCK_METHOD2(onSpliced, void(bool to_upstream, uint64_t bytes));
+  MOCK_METHOD1(onSpliceEndStream, void(bool to_upstream));
+  MOCK_METHOD1(onSpliceError, void(int error));
+};
+
+class SplicePumpTest : public testing::Test {
+public:
+  SplicePumpTest() : dispatcher_(test_time_.timeSystem()) {
+    RELEASE_ASSERT(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, downstream_) == 0, "");
+    RELEASE_ASSERT(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, upstream_) == 0, "");
+    // The pump owns downstream_[1] and upstream_[0]; the test plays the peers.
+    pump_ = SplicePump::create(dispatcher_, downstream_[1], upstream_[0], callbacks_);
+  }
+
+  ~SplicePumpTest() {
+    pump_.reset();
+    for (int fd : {downstream_[0], downstream_[1], upstream_[0], upstream_[1]}) {
+      if (fd != -1) {
+        close(fd);
+      }
+    }
+  }
+
+  std::string readAll(int fd) {
+    std::string data;
+    char buf[4096];
+    ssize_t rc;
+    while ((rc = ::read(fd, buf, sizeof(buf))) > 0) {
+      data.append(buf, rc);
+    }
+    return data;
+  }
+
+  void run() { dispatcher_.run(Event::Dispatcher::RunType::NonBlock); }
+
+  int downstream_[2];
+  int upstream_[2];
+  DangerousDeprecatedTestTime test_time_;
+  Event::DispatcherImpl dispatcher_;
+  MockSplicePumpCallbacks callbacks_;
+  SplicePumpPtr pump_;
+};
+
+TEST_F(SplicePumpTest, BothDirections) {
+  ASSERT_NE(nullptr, pump_);
+
+  EXPECT_CALL(callbacks_, onSpliced(true, 5));
+  ASSERT_EQ(5, ::write(downstream_[0], "hello", 5));
+  run();
+  EXPECT_EQ("hello", readAll(upstream_[1]));
+
+  EXPECT_CALL(callbacks_, onSpliced(false, 5));
+  ASSERT_EQ(5, ::write(upstream_[1], "world", 5));
+  run();
+  EXPECT_EQ("world", readAll(downstream_[0]));
+}
+
+TEST_F(SplicePumpTest, EndStream) {
+  ASSERT_NE(nullptr, pump_);
+
+  {
+    InSequence s;
+    EXPECT_CALL(callbacks_, onSpliced(true, 5));
+    EXPECT_CALL(callbacks_, onSpliceEndStream(true));
+  }
+  ASSERT_EQ(5, ::write(downstream_[0], "hello", 5));
+  shutdown(downstream_[0], SHUT_WR);
+  run();
+  EXPECT_EQ("hello", readAll(upstream_[1]));
+  EXPECT_FALSE(pump_->endStreamBothDirections());
+
+  // The other direction keeps flowing after one side half-closes.
+  EXPECT_CALL(callbacks_, onSpliced(false, 5));
+  EXPECT_CALL(callbacks_, onSpliceEndStream(false));
+  ASSERT_EQ(5, ::write(upstream_[1], "world", 5));
+  shutdown(upstream_[1], SHUT_WR);
+  run();
+  EXPECT_EQ("world", readAll(downstream_[0]));
+  EXPECT_TRUE(pump_->endStreamBothDirections());
+}
+
+TEST_F(SplicePumpTest, WriteError) {
+  ASSERT_NE(nullptr, pump_);
+
+  close(upstream_[1]);
+  upstream_[1] = -1;
+  EXPECT_CALL(callbacks_, onSpliced(_, _)).Times(0);
+  EXPECT_CALL(callbacks_, onSpliceError(EPIPE));
+  ASSERT_EQ(5, ::write(downstream_[0], "hello", 5));
+  run();
+}
+
+TEST_F(SplicePumpTest, StopFromCallback) {
+  ASSERT_NE(nullptr, pump_);
+
+  EXPECT_CALL(callbacks_, onSpliced(true, 5)).WillOnce(Invoke([this](bool, uint64_t) {
+    pump_->stop();
+  }));
+  ASSERT_EQ(5, ::write(downstream_[0], "hello", 5));
+  run();
+
+  // A stopped pump leaves data in the sockets.
+  ASSERT_EQ(5, ::write(downstream_[0], "again", 5));
+  run();
+  EXPECT_EQ("hello", readAll(upstream_[1]));
+}
+
+} // namespace
+} // namespace TcpProxy
+} // namespace Envoy
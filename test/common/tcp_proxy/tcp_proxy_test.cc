@@ -5,6 +5,7 @@
 #include "envoy/config/accesslog/v2/file.pb.h"
 
 #include "common/buffer/buffer_impl.h"
+#include "common/common/hash.h"
 #include "common/config/filter_json.h"
 #include "common/network/address_impl.h"
 #include "common/router/metadatamatchcriteria_impl.h"
@@ -314,6 +315,100 @@ TEST(ConfigTest, EmptyRouteConfig) {
   EXPECT_EQ(std::string(""), config_obj.getRouteFromEntries(connection));
 }
 
+// Tests that connections are routed to the weighted clusters in proportion to their weights.
+TEST(ConfigTest, WeightedClusters) {
+  envoy::config::filter::network::tcp_proxy::v2::TcpProxy config;
+  config.set_stat_prefix("name");
+  auto* cluster = config.mutable_weighted_clusters()->add_clusters();
+  cluster->set_name("cluster1");
+  cluster->set_weight(1);
+  cluster = config.mutable_weighted_clusters()->add_clusters();
+  cluster->set_name("cluster2");
+  cluster->set_weight(3);
+
+  NiceMock<Server::Configuration::MockFactoryContext> factory_context;
+  Config config_obj(config, factory_context);
+  NiceMock<Network::MockConnection> connection;
+
+  EXPECT_CALL(factory_context.random_, random()).WillOnce(Return(0));
+  EXPECT_EQ(std::string("cluster1"), config_obj.getRouteFromEntries(connection));
+  EXPECT_CALL(factory_context.random_, random()).WillOnce(Return(1));
+  EXPECT_EQ(std::string("cluster2"), config_obj.getRouteFromEntries(connection));
+  EXPECT_CALL(factory_context.random_, random()).WillOnce(Return(3));
+  EXPECT_EQ(std::string("cluster2"), config_obj.getRouteFromEntries(connection));
+  EXPECT_CALL(factory_context.random_, random()).WillOnce(Return(4));
+  EXPECT_EQ(std::string("cluster1"), config_obj.getRouteFromEntries(connection));
+}
+
+// Tests that the deprecated v1 routes take precedence over the weighted clusters.
+TEST(ConfigTest, WeightedClustersAfterRoutes) {
+  envoy::config::filter::network::tcp_proxy::v2::TcpProxy config;
+  config.set_stat_prefix("name");
+  auto* route = config.mutable_deprecated_v1()->mutable_routes()->Add();
+  route->set_cluster("route_cluster");
+  route->set_destination_ports("1");
+  auto* cluster = config.mutable_weighted_clusters()->add_clusters();
+  cluster->set_name("weighted_cluster");
+  cluster->set_weight(1);
+
+  NiceMock<Server::Configuration::MockFactoryContext> factory_context;
+  Config config_obj(config, factory_context);
+
+  NiceMock<Network::MockConnection> connection;
+  connection.local_address_ = Network::Utility::resolveUrl("tcp://1.2.3.4:1");
+  EXPECT_EQ(std::string("route_cluster"), config_obj.getRouteFromEntries(connection));
+  connection.local_address_ = Network::Utility::resolveUrl("tcp://1.2.3.4:2");
+  EXPECT_EQ(std::string("weighted_cluster"), config_obj.getRouteFromEntries(connection));
+}
+
+TEST(ConfigTest, NoHashPolicy) {
+  envoy::config::filter::network::tcp_proxy::v2::TcpProxy config;
+  config.set_stat_prefix("name");
+  config.set_cluster("fake_cluster");
+  NiceMock<Server::Configuration::MockFactoryContext> factory_context;
+  Config config_obj(config, factory_context);
+
+  NiceMock<Network::MockConnection> connection;
+  connection.remote_address_ = Network::Utility::resolveUrl("tcp://1.2.3.4:1000");
+  EXPECT_EQ(absl::nullopt, config_obj.hashKey(connection));
+}
+
+TEST(ConfigTest, SourceIpHashPolicy) {
+  envoy::config::filter::network::tcp_proxy::v2::TcpProxy config;
+  config.set_stat_prefix("name");
+  config.set_cluster("fake_cluster");
+  config.mutable_hash_policy()->mutable_source_ip();
+  NiceMock<Server::Configuration::MockFactoryContext> factory_context;
+  Config config_obj(config, factory_context);
+
+  // The source port does not change the hash.
+  NiceMock<Network::MockConnection> connection;
+  connection.remote_address_ = Network::Utility::resolveUrl("tcp://1.2.3.4:1000");
+  EXPECT_EQ(HashUtil::xxHash64("1.2.3.4"), config_obj.hashKey(connection));
+  connection.remote_address_ = Network::Utility::resolveUrl("tcp://1.2.3.4:2000");
+  EXPECT_EQ(HashUtil::xxHash64("1.2.3.4"), config_obj.hashKey(connection));
+
+  connection.remote_address_ = std::make_shared<Network::Address::PipeInstance>("/pipe/path");
+  EXPECT_EQ(absl::nullopt, config_obj.hashKey(connection));
+}
+
+TEST(ConfigTest, RequestedServerNameHashPolicy) {
+  envoy::config::filter::network::tcp_proxy::v2::TcpProxy config;
+  config.set_stat_prefix("name");
+  config.set_cluster("fake_cluster");
+  config.mutable_hash_policy()->mutable_requested_server_name();
+  NiceMock<Server::Configuration::MockFactoryContext> factory_context;
+  Config config_obj(config, factory_context);
+
+  NiceMock<Network::MockConnection> connection;
+  EXPECT_CALL(connection, requestedServerName()).WillRepeatedly(Return("www.example.com"));
+  EXPECT_EQ(HashUtil::xxHash64("www.example.com"), config_obj.hashKey(connection));
+
+  NiceMock<Network::MockConnection> no_sni_connection;
+  EXPECT_CALL(no_sni_connection, requestedServerName()).WillRepeatedly(Return(""));
+  EXPECT_EQ(absl::nullopt, config_obj.hashKey(no_sni_connection));
+}
+
 TEST(ConfigTest, AccessLogConfig) {
   envoy::config::filter::network::tcp_proxy::v2::TcpProxy config;
   envoy::config::filter::accesslog::v2::AccessLog* log = config.mutable_access_log()->Add();
@@ -538,6 +633,102 @@ TEST_F(TcpProxyTest, UpstreamRemoteDisconnect) {
   upstream_callbacks_->onEvent(Network::ConnectionEvent::RemoteClose);
 }
 
+// Test that splice_passthrough falls back to proxying through buffers when a transport socket
+// does not pass data through unmodified.
+TEST_F(TcpProxyTest, SpliceFallbackWithoutPassthroughFd) {
+  envoy::config::filter::network::tcp_proxy::v2::TcpProxy config = defaultConfig();
+  config.set_splice_passthrough(true);
+  setup(1, config);
+
+  EXPECT_CALL(filter_callbacks_.connection_, passthroughFd()).WillRepeatedly(Return(5));
+  EXPECT_CALL(*upstream_connections_.at(0), passthroughFd()).WillRepeatedly(Return(-1));
+  raiseEventUpstreamConnected(0);
+  EXPECT_EQ(0U, config_->stats().downstream_cx_splice_total_.value());
+
+  Buffer::OwnedImpl buffer("hello");
+  EXPECT_CALL(*upstream_connections_.at(0), write(BufferEqual(&buffer), false));
+  filter_->onData(buffer, false);
+}
+
+// Test that splice_passthrough falls back to proxying through buffers when the downstream
+// connection already holds data when the upstream connects, e.g. read before a filter stopped
+// iteration, so that the data is not overtaken by spliced data.
+TEST_F(TcpProxyTest, SpliceFallbackWithBufferedDownstreamData) {
+  envoy::config::filter::network::tcp_proxy::v2::TcpProxy config = defaultConfig();
+  config.set_splice_passthrough(true);
+  setup(1, config);
+
+  EXPECT_CALL(filter_callbacks_.connection_, passthroughFd()).WillRepeatedly(Return(5));
+  EXPECT_CALL(*upstream_connections_.at(0), passthroughFd()).WillRepeatedly(Return(6));
+  EXPECT_CALL(filter_callbacks_.connection_, bufferedBytes()).WillRepeatedly(Return(5));
+  EXPECT_CALL(filter_callbacks_.connection_.dispatcher_, createFileEvent_(_, _, _, _)).Times(0);
+  // Reads are enabled again, which delivers the buffered data through the buffers.
+  raiseEventUpstreamConnected(0);
+  EXPECT_EQ(0U, config_->stats().downstream_cx_splice_total_.value());
+
+  Buffer::OwnedImpl buffer("hello");
+  EXPECT_CALL(*upstream_connections_.at(0), write(BufferEqual(&buffer), false));
+  filter_->onData(buffer, false);
+}
+
+// Test that splice_passthrough falls back to proxying through buffers when the upstream
+// connection has data buffered for writing when it connects.
+TEST_F(TcpProxyTest, SpliceFallbackWithBufferedUpstreamData) {
+  envoy::config::filter::network::tcp_proxy::v2::TcpProxy config = defaultConfig();
+  config.set_splice_passthrough(true);
+  setup(1, config);
+
+  EXPECT_CALL(filter_callbacks_.connection_, passthroughFd()).WillRepeatedly(Return(5));
+  EXPECT_CALL(*upstream_connections_.at(0), passthroughFd()).WillRepeatedly(Return(6));
+  EXPECT_CALL(*upstream_connections_.at(0), bufferedBytes()).WillRepeatedly(Return(10));
+  EXPECT_CALL(filter_callbacks_.connection_.dispatcher_, createFileEvent_(_, _, _, _)).Times(0);
+  EXPECT_CALL(*upstream_connections_.at(0), readDisable(true)).Times(0);
+  raiseEventUpstreamConnected(0);
+  EXPECT_EQ(0U, config_->stats().downstream_cx_splice_total_.value());
+}
+
+// Test that splice_passthrough keeps both connections read disabled and splices between their
+// sockets, closing both when the pump fails.
+TEST_F(TcpProxyTest, SplicePassthrough) {
+  envoy::config::filter::network::tcp_proxy::v2::TcpProxy config = defaultConfig();
+  config.set_splice_passthrough(true);
+  setup(1, config);
+
+  EXPECT_CALL(filter_callbacks_.connection_, passthroughFd()).WillRepeatedly(Return(5));
+  EXPECT_CALL(*upstream_connections_.at(0), passthroughFd()).WillRepeatedly(Return(6));
+  EXPECT_CALL(filter_callbacks_.connection_.dispatcher_, createFileEvent_(5, _, _, _));
+  EXPECT_CALL(filter_callbacks_.connection_.dispatcher_, createFileEvent_(6, _, _, _));
+  EXPECT_CALL(filter_callbacks_.connection_, readDisable(false)).Times(0);
+  EXPECT_CALL(*upstream_connections_.at(0), readDisable(true));
+  EXPECT_CALL(*upstream_connection_data_.at(0), addUpstreamCallbacks(_))
+      .WillOnce(Invoke([&](Tcp::ConnectionPool::UpstreamCallbacks& cb) -> void {
+        upstream_callbacks_ = &cb;
+        upstream_connections_.at(0)->addConnectionCallbacks(cb);
+      }));
+  conn_pool_callbacks_.at(0)->onPoolReady(std::move(upstream_connection_data_.at(0)),
+                                          upstream_hosts_.at(0));
+  EXPECT_EQ(1U, config_->stats().downstream_cx_splice_total_.value());
+
+  filter_->onSpliced(true, 10);
+  filter_->onSpliced(false, 20);
+  EXPECT_EQ(10U, config_->stats().downstream_cx_rx_bytes_total_.value());
+  EXPECT_EQ(20U, config_->stats().downstream_cx_tx_bytes_total_.value());
+  EXPECT_EQ(10U, factory_context_.cluster_manager_.thread_local_cluster_.cluster_.info_->stats_store_
+                     .counter("upstream_cx_tx_bytes_total")
+                     .value());
+  EXPECT_EQ(20U, factory_context_.cluster_manager_.thread_local_cluster_.cluster_.info_->stats_store_
+                     .counter("upstream_cx_rx_bytes_total")
+                     .value());
+
+  EXPECT_CALL(*upstream_connections_.at(0), write(_, true));
+  filter_->onSpliceEndStream(true);
+
+  EXPECT_CALL(filter_callbacks_.connection_.dispatcher_, deferredDelete_(_));
+  EXPECT_CALL(filter_callbacks_.connection_, close(Network::ConnectionCloseType::NoFlush));
+  EXPECT_CALL(*upstream_connections_.at(0), close(Network::ConnectionCloseType::NoFlush));
+  filter_->onSpliceError(ECONNRESET);
+}
+
 // Test that reconnect is attempted after a local connect failure
 TEST_F(TcpProxyTest, ConnectAttemptsUpstreamLocalFail) {
   envoy::config::filter::network::tcp_proxy::v2::TcpProxy config = defaultConfig();
@@ -842,6 +1033,60 @@ TEST_F(TcpProxyTest, IdleTimerDisabledUpstreamClose) {
   upstream_callbacks_->onEvent(Network::ConnectionEvent::RemoteClose);
 }
 
+// Tests that the buffers of both connections are released once they are idle for the buffer
+// release timeout, and that the timer gets updated when either connection has activity.
+TEST_F(TcpProxyTest, BufferReleaseTimeout) {
+  envoy::config::filter::network::tcp_proxy::v2::TcpProxy config = defaultConfig();
+  config.mutable_buffer_release_timeout()->set_seconds(1);
+  setup(1, config);
+
+  Event::MockTimer* release_timer =
+      new Event::MockTimer(&filter_callbacks_.connection_.dispatcher_);
+  EXPECT_CALL(*release_timer, enableTimer(std::chrono::milliseconds(1000)));
+  raiseEventUpstreamConnected(0);
+
+  Buffer::OwnedImpl buffer("hello");
+  EXPECT_CALL(*release_timer, enableTimer(std::chrono::milliseconds(1000)));
+  filter_->onData(buffer, false);
+
+  buffer.add("hello2");
+  EXPECT_CALL(*release_timer, enableTimer(std::chrono::milliseconds(1000)));
+  upstream_callbacks_->onUpstreamData(buffer, false);
+
+  EXPECT_CALL(filter_callbacks_.connection_, releaseBuffers());
+  EXPECT_CALL(*upstream_connections_.at(0), releaseBuffers());
+  release_timer->callback_();
+  EXPECT_EQ(1U, config_->stats().buffers_released_.value());
+
+  EXPECT_CALL(*release_timer, disableTimer());
+  upstream_callbacks_->onEvent(Network::ConnectionEvent::RemoteClose);
+}
+
+// Tests that the timeouts of the upstream cluster override those of the filter.
+TEST_F(TcpProxyTest, ClusterProtocolOptionsOverrideTimeouts) {
+  envoy::config::filter::network::tcp_proxy::v2::TcpProxy config = defaultConfig();
+  config.mutable_idle_timeout()->set_seconds(1);
+  setup(1, config);
+
+  envoy::config::filter::network::tcp_proxy::v2::TcpProxyProtocolOptions options;
+  options.mutable_idle_timeout()->set_seconds(2);
+  options.mutable_buffer_release_timeout()->set_seconds(3);
+  factory_context_.cluster_manager_.thread_local_cluster_.cluster_.info_
+      ->extension_protocol_options_ = std::make_shared<ProtocolOptionsConfig>(options);
+
+  // The release timer is created first, and mock timers are handed out newest first.
+  Event::MockTimer* idle_timer = new Event::MockTimer(&filter_callbacks_.connection_.dispatcher_);
+  Event::MockTimer* release_timer =
+      new Event::MockTimer(&filter_callbacks_.connection_.dispatcher_);
+  EXPECT_CALL(*idle_timer, enableTimer(std::chrono::milliseconds(2000)));
+  EXPECT_CALL(*release_timer, enableTimer(std::chrono::milliseconds(3000)));
+  raiseEventUpstreamConnected(0);
+
+  EXPECT_CALL(*idle_timer, disableTimer());
+  EXPECT_CALL(*release_timer, disableTimer());
+  upstream_callbacks_->onEvent(Network::ConnectionEvent::RemoteClose);
+}
+
 // Tests that flushing data during an idle timeout doesn't cause problems.
 TEST_F(TcpProxyTest, IdleTimeoutWithOutstandingDataFlushed) {
   envoy::config::filter::network::tcp_proxy::v2::TcpProxy config = defaultConfig();
@@ -0,0 +1,66 @@
+#include <memory>
+#include <string>
+
+#include "common/thread_local/snapshot_slot.h"
+
+#include "test/mocks/thread_local/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::NiceMock;
+
+namespace Envoy {
+namespace ThreadLocal {
+
+class SnapshotSlotTest : public testing::Test {
+public:
+  NiceMock<MockInstance> tls_;
+};
+
+TEST_F(SnapshotSlotTest, InitialObject) {
+  SnapshotSlot<const std::string> empty(tls_);
+  EXPECT_EQ(nullptr, empty.get());
+
+  SnapshotSlot<const std::string> slot(tls_, std::make_shared<const std::string>("a"));
+  EXPECT_EQ("a", *slot.get());
+}
+
+TEST_F(SnapshotSlotTest, PublishDoesNotPostToThreads) {
+  SnapshotSlot<const std::string> slot(tls_, std::make_shared<const std::string>("a"));
+  EXPECT_EQ("a", *slot.get());
+
+  EXPECT_CALL(tls_, runOnAllThreads(_)).Times(0);
+  EXPECT_CALL(tls_.dispatcher_, post(_)).Times(0);
+  slot.publish(std::make_shared<const std::string>("b"));
+  slot.publish(std::make_shared<const std::string>("c"));
+  EXPECT_EQ("c", *slot.get());
+}
+
+TEST_F(SnapshotSlotTest, RetiredObjectOutlivesIteration) {
+  SnapshotSlot<const std::string> slot(tls_, std::make_shared<const std::string>("a"));
+  const std::string& first = *slot.get();
+  std::weak_ptr<const std::string> first_weak = slot.get();
+
+  // The thread still caches the first object, so publishing does not free it.
+  slot.publish(std::make_shared<const std::string>("b"));
+  EXPECT_FALSE(first_weak.expired());
+
+  // Picking up the new object hands the old one to the dispatcher rather than freeing it, so the
+  // reference taken earlier in the iteration is still good.
+  EXPECT_CALL(tls_.dispatcher_, deferredDelete_(_));
+  EXPECT_EQ("b", *slot.get());
+  EXPECT_EQ("a", first);
+  EXPECT_FALSE(first_weak.expired());
+
+  tls_.dispatcher_.to_delete_.clear();
+  EXPECT_TRUE(first_weak.expired());
+
+  // Nothing changes until the next publish.
+  EXPECT_CALL(tls_.dispatcher_, deferredDelete_(_)).Times(0);
+  EXPECT_EQ("b", *slot.get());
+}
+
+} // namespace ThreadLocal
+} // namespace Envoy
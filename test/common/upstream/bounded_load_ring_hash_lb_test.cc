@@ -0,0 +1,102 @@
+#include "common/upstream/bounded_load_ring_hash_lb.h"
+
+#include "test/common/upstream/utility.h"
+#include "test/mocks/upstream/mocks.h"
+
+namespace Envoy {
+namespace Upstream {
+
+class TestLoadBalancerContext : public LoadBalancerContextBase {
+public:
+  TestLoadBalancerContext(uint64_t hash_key) : hash_key_(hash_key) {}
+
+  // Upstream::LoadBalancerContext
+  absl::optional<uint64_t> computeHashKey() override { return hash_key_; }
+
+  absl::optional<uint64_t> hash_key_;
+};
+
+// Note: ThreadAwareLoadBalancer base is heavily tested by RingHashLoadBalancerTest. Only basic
+//       functionality is covered here.
+class BoundedLoadRingHashLoadBalancerTest : public ::testing::Test {
+public:
+  BoundedLoadRingHashLoadBalancerTest() : stats_(ClusterInfoImpl::generateStats(stats_store_)) {}
+
+  void init() {
+    lb_.reset(new BoundedLoadRingHashLoadBalancer(priority_set_, stats_, runtime_, random_,
+                                                  config_, common_config_));
+    lb_->initialize();
+  }
+
+  NiceMock<MockPrioritySet> priority_set_;
+  MockHostSet& host_set_ = *priority_set_.getMockHostSet(0);
+  std::shared_ptr<MockClusterInfo> info_{new NiceMock<MockClusterInfo>()};
+  Stats::IsolatedStoreImpl stats_store_;
+  ClusterStats stats_;
+  absl::optional<envoy::api::v2::Cluster::BoundedLoadRingHashLbConfig> config_;
+  envoy::api::v2::Cluster::CommonLbConfig common_config_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<Runtime::MockRandomGenerator> random_;
+  std::unique_ptr<BoundedLoadRingHashLoadBalancer> lb_;
+};
+
+// Works correctly without any hosts.
+TEST_F(BoundedLoadRingHashLoadBalancerTest, NoHost) {
+  init();
+  EXPECT_EQ(nullptr, lb_->factory()->create()->chooseHost(nullptr));
+};
+
+// Hosts over the load bound are skipped in ring order.
+TEST_F(BoundedLoadRingHashLoadBalancerTest, Basic) {
+  host_set_.hosts_ = {
+      makeTestHost(info_, "tcp://127.0.0.1:90"), makeTestHost(info_, "tcp://127.0.0.1:91"),
+      makeTestHost(info_, "tcp://127.0.0.1:92"), makeTestHost(info_, "tcp://127.0.0.1:93"),
+      makeTestHost(info_, "tcp://127.0.0.1:94"), makeTestHost(info_, "tcp://127.0.0.1:95")};
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({}, {});
+
+  config_ = envoy::api::v2::Cluster::BoundedLoadRingHashLbConfig();
+  config_.value().mutable_minimum_ring_size()->set_value(12);
+  init();
+
+  // The ring is the one of RingHashLoadBalancerTest.Basic, which starts with:
+  // port | position
+  // ---------------------------
+  // :94  | 833437586790550860
+  // :92  | 928266305478181108
+  // :90  | 1033482794131418490
+  LoadBalancerPtr lb = lb_->factory()->create();
+  TestLoadBalancerContext context(0);
+  EXPECT_EQ(host_set_.hosts_[4], lb->chooseHost(&context));
+
+  // With 1 active request, the bound is ceil(1.25 * 2 / 6) = 1 active request per host.
+  host_set_.hosts_[4]->stats().rq_active_.set(1);
+  EXPECT_EQ(host_set_.hosts_[2], lb->chooseHost(&context));
+  host_set_.hosts_[2]->stats().rq_active_.set(1);
+  EXPECT_EQ(host_set_.hosts_[0], lb->chooseHost(&context));
+
+  // Keys owned by hosts below the bound don't move.
+  TestLoadBalancerContext other_context(3551244743356806947);
+  EXPECT_EQ(host_set_.hosts_[5], lb->chooseHost(&other_context));
+
+  // A higher balance factor allows more active requests per host.
+  config_.value().mutable_balance_factor()->set_value(300);
+  init();
+  lb = lb_->factory()->create();
+  EXPECT_EQ(host_set_.hosts_[4], lb->chooseHost(&context));
+}
+
+// The bound is above the average load, so a single host is never skipped.
+TEST_F(BoundedLoadRingHashLoadBalancerTest, SingleHost) {
+  host_set_.hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:90")};
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({}, {});
+  init();
+
+  host_set_.hosts_[0]->stats().rq_active_.set(100);
+  LoadBalancerPtr lb = lb_->factory()->create();
+  EXPECT_EQ(host_set_.hosts_[0], lb->chooseHost(nullptr));
+}
+
+} // namespace Upstream
+} // namespace Envoy
@@ -146,6 +146,77 @@ TEST_F(CdsApiImplTest, ValidateDuplicateClusters) {
   EXPECT_CALL(request_, cancel());
 }
 
+// Validate that incremental updates only add, update or remove the clusters they carry.
+TEST_F(CdsApiImplTest, IncrementalUpdate) {
+  InSequence s;
+
+  setup(true);
+
+  Protobuf::RepeatedPtrField<envoy::api::v2::Cluster> clusters;
+  clusters.Add()->set_name("cluster1");
+  Protobuf::RepeatedPtrField<ProtobufTypes::String> removed_clusters;
+  *removed_clusters.Add() = "cluster2";
+
+  EXPECT_CALL(cm_, clusters()).Times(0);
+  expectAdd("cluster1", "1");
+  EXPECT_CALL(cm_, removeCluster("cluster2"));
+  EXPECT_CALL(initialized_, ready());
+  dynamic_cast<CdsApiImpl*>(cds_.get())->onIncrementalConfigUpdate(clusters, removed_clusters, "1");
+  EXPECT_EQ("1", cds_->versionInfo());
+  EXPECT_CALL(request_, cancel());
+}
+
+// Clusters that the cluster manager doesn't report, e.g. on-demand clusters that aren't loaded, are
+// still removed when they are no longer in an update.
+TEST_F(CdsApiImplTest, RemoveUnreportedCluster) {
+  InSequence s;
+
+  setup(true);
+
+  Protobuf::RepeatedPtrField<envoy::api::v2::Cluster> clusters;
+  clusters.Add()->set_name("cluster1");
+  clusters.Add()->set_name("cluster2");
+
+  EXPECT_CALL(cm_, clusters()).WillOnce(Return(ClusterManager::ClusterInfoMap{}));
+  expectAdd("cluster1", "1");
+  expectAdd("cluster2", "1");
+  EXPECT_CALL(initialized_, ready());
+  dynamic_cast<CdsApiImpl*>(cds_.get())->onConfigUpdate(clusters, "1");
+
+  clusters.RemoveLast();
+  EXPECT_CALL(cm_, clusters()).WillOnce(Return(ClusterManager::ClusterInfoMap{}));
+  expectAdd("cluster1", "2");
+  EXPECT_CALL(cm_, removeCluster("cluster2"));
+  dynamic_cast<CdsApiImpl*>(cds_.get())->onConfigUpdate(clusters, "2");
+  EXPECT_CALL(request_, cancel());
+}
+
+// Only the clusters that weren't in the previous update are prepared ahead of being added.
+TEST_F(CdsApiImplTest, PrepareNewClusters) {
+  setup(true);
+
+  Protobuf::RepeatedPtrField<envoy::api::v2::Cluster> clusters;
+  clusters.Add()->set_name("cluster1");
+  clusters.Add()->set_name("cluster2");
+
+  EXPECT_CALL(cm_.cluster_manager_factory_, prepareCluster_(ProtoEq(clusters[0])));
+  EXPECT_CALL(cm_.cluster_manager_factory_, prepareCluster_(ProtoEq(clusters[1])));
+  EXPECT_CALL(cm_, clusters()).WillOnce(Return(ClusterManager::ClusterInfoMap{}));
+  expectAdd("cluster1", "1");
+  expectAdd("cluster2", "1");
+  EXPECT_CALL(initialized_, ready());
+  dynamic_cast<CdsApiImpl*>(cds_.get())->onConfigUpdate(clusters, "1");
+
+  clusters[1].set_name("cluster3");
+  EXPECT_CALL(cm_.cluster_manager_factory_, prepareCluster_(ProtoEq(clusters[1])));
+  EXPECT_CALL(cm_, clusters()).WillOnce(Return(ClusterManager::ClusterInfoMap{}));
+  expectAdd("cluster1", "2");
+  expectAdd("cluster3", "2");
+  EXPECT_CALL(cm_, removeCluster("cluster2"));
+  dynamic_cast<CdsApiImpl*>(cds_.get())->onConfigUpdate(clusters, "2");
+  EXPECT_CALL(request_, cancel());
+}
+
 TEST_F(CdsApiImplTest, InvalidOptions) {
   const std::string config_json = R"EOF(
   {
@@ -1,3 +1,4 @@
+#include <atomic>
 #include <memory>
 #include <string>
 
@@ -11,6 +12,7 @@
 #include "common/network/utility.h"
 #include "common/ssl/context_manager_impl.h"
 #include "common/upstream/cluster_manager_impl.h"
+#include "common/upstream/cluster_name_registry.h"
 
 #include "test/common/upstream/utility.h"
 #include "test/mocks/access_log/mocks.h"
@@ -81,6 +83,10 @@ public:
     return clusterFromProto_(cluster, cm, outlier_event_logger, log_manager, added_via_api);
   }
 
+  ClusterPreparationPtr prepareCluster(const envoy::api::v2::Cluster& cluster) override {
+    return ClusterPreparationPtr{prepareCluster_(cluster)};
+  }
+
   CdsApiPtr createCds(const envoy::api::v2::core::ConfigSource&,
                       const absl::optional<envoy::api::v2::core::ConfigSource>&,
                       ClusterManager&) override {
@@ -110,6 +116,7 @@ public:
                ClusterSharedPtr(const envoy::api::v2::Cluster& cluster, ClusterManager& cm,
                                 Outlier::EventLoggerSharedPtr outlier_event_logger,
                                 AccessLog::AccessLogManager& log_manager, bool added_via_api));
+  MOCK_METHOD1(prepareCluster_, ClusterPreparation*(const envoy::api::v2::Cluster& cluster));
   MOCK_METHOD0(createCds_, CdsApi*());
 
   Stats::IsolatedStoreImpl stats_;
@@ -633,6 +640,12 @@ TEST_F(ClusterManagerImplThreadAwareLbTest, MaglevLoadBalancerThreadAwareUpdate)
   doTest(LoadBalancerType::Maglev);
 }
 
+// Test that the cluster manager correctly re-creates the worker local LB when there is a host
+// set change.
+TEST_F(ClusterManagerImplThreadAwareLbTest, BoundedLoadRingHashLoadBalancerThreadAwareUpdate) {
+  doTest(LoadBalancerType::BoundedLoadRingHash);
+}
+
 TEST_F(ClusterManagerImplTest, TcpHealthChecker) {
   const std::string json = R"EOF(
   {
@@ -1133,6 +1146,267 @@ TEST_F(ClusterManagerImplTest, DynamicAddRemove) {
   EXPECT_TRUE(Mock::VerifyAndClearExpectations(callbacks.get()));
 }
 
+// Handles interned before or after their cluster is added resolve to it until it is removed.
+TEST_F(ClusterManagerImplTest, ClusterNameHandles) {
+  const std::string json = R"EOF(
+  {
+    "clusters": []
+  }
+  )EOF";
+
+  create(parseBootstrapFromJson(json));
+  const ClusterNameHandle early_handle = ClusterNameRegistry::registerName("handle_cluster");
+  const ClusterNameHandle unknown_handle = ClusterNameRegistry::registerName("unknown_cluster");
+  EXPECT_EQ(nullptr, cluster_manager_->get(early_handle));
+
+  std::shared_ptr<MockCluster> cluster1(new NiceMock<MockCluster>());
+  cluster1->prioritySet().getMockHostSet(0)->hosts_ = {
+      makeTestHost(cluster1->info_, "tcp://127.0.0.1:80")};
+  EXPECT_CALL(factory_, clusterFromProto_(_, _, _, _, _)).WillOnce(Return(cluster1));
+  EXPECT_CALL(*cluster1, initialize(_))
+      .WillOnce(Invoke([](std::function<void()> initialize_callback) { initialize_callback(); }));
+  EXPECT_TRUE(cluster_manager_->addOrUpdateCluster(defaultStaticCluster("handle_cluster"), ""));
+
+  const ClusterNameHandle late_handle = ClusterNameRegistry::registerName("handle_cluster");
+  EXPECT_EQ(early_handle.index(), late_handle.index());
+  EXPECT_EQ(cluster1->info_, cluster_manager_->get(early_handle)->info());
+  EXPECT_EQ(nullptr, cluster_manager_->get(unknown_handle));
+  EXPECT_EQ(nullptr,
+            cluster_manager_->httpConnPoolForCluster(unknown_handle, ResourcePriority::Default,
+                                                     Http::Protocol::Http11, nullptr));
+
+  Http::ConnectionPool::MockInstance* cp = new Http::ConnectionPool::MockInstance();
+  EXPECT_CALL(factory_, allocateConnPool_(_)).WillOnce(Return(cp));
+  EXPECT_EQ(cp, cluster_manager_->httpConnPoolForCluster(late_handle, ResourcePriority::Default,
+                                                         Http::Protocol::Http11, nullptr));
+
+  Http::ConnectionPool::Instance::DrainedCb drained_cb;
+  EXPECT_CALL(*cp, addDrainedCallback(_)).WillOnce(SaveArg<0>(&drained_cb));
+  EXPECT_TRUE(cluster_manager_->removeCluster("handle_cluster"));
+  EXPECT_EQ(nullptr, cluster_manager_->get(late_handle));
+  EXPECT_EQ(nullptr, cluster_manager_->httpConnPoolForCluster(
+                         late_handle, ResourcePriority::Default, Http::Protocol::Http11, nullptr));
+  drained_cb();
+
+  EXPECT_TRUE(Mock::VerifyAndClearExpectations(cluster1.get()));
+}
+
+class TestClusterPreparation : public ClusterPreparation {
+public:
+  TestClusterPreparation(std::atomic<uint32_t>& live) : live_(live) { live_++; }
+  ~TestClusterPreparation() { live_--; }
+
+  std::atomic<uint32_t>& live_;
+};
+
+// Static clusters are prepared, in parallel batches, before any of them is allocated, and the
+// preparations are kept until all of them are.
+TEST_F(ClusterManagerImplTest, PrepareStaticClusters) {
+  const uint32_t num_clusters = 40;
+  envoy::config::bootstrap::v2::Bootstrap bootstrap;
+  for (uint32_t i = 0; i < num_clusters; i++) {
+    envoy::api::v2::Cluster* cluster = bootstrap.mutable_static_resources()->add_clusters();
+    cluster->set_name(fmt::format("cluster_{}", i));
+    cluster->mutable_connect_timeout()->set_seconds(1);
+  }
+
+  std::atomic<uint32_t> live{0};
+  EXPECT_CALL(factory_, prepareCluster_(_))
+      .Times(num_clusters)
+      .WillRepeatedly(Invoke([&](const envoy::api::v2::Cluster&) -> ClusterPreparation* {
+        return new TestClusterPreparation(live);
+      }));
+  uint32_t allocated = 0;
+  ON_CALL(factory_, clusterFromProto_(_, _, _, _, _))
+      .WillByDefault(Invoke([&](const envoy::api::v2::Cluster& cluster, ClusterManager& cm,
+                                Outlier::EventLoggerSharedPtr outlier_event_logger,
+                                AccessLog::AccessLogManager& log_manager,
+                                bool added_via_api) -> ClusterSharedPtr {
+        EXPECT_EQ(num_clusters, live.load());
+        allocated++;
+        return ClusterImplBase::create(cluster, cm, factory_.stats_, factory_.tls_,
+                                       factory_.dns_resolver_, factory_.ssl_context_manager_,
+                                       factory_.runtime_, factory_.random_, factory_.dispatcher_,
+                                       log_manager, factory_.local_info_, outlier_event_logger,
+                                       added_via_api);
+      }));
+  create(bootstrap);
+
+  EXPECT_EQ(num_clusters, allocated);
+  EXPECT_EQ(0U, live.load());
+  EXPECT_EQ(num_clusters, cluster_manager_->clusters().size());
+}
+
+TEST_F(ClusterManagerImplTest, OnDemandClusterLoad) {
+  const std::string yaml = R"EOF(
+  static_resources:
+    clusters: []
+  cluster_manager:
+    on_demand_clusters: {}
+  )EOF";
+
+  create(parseBootstrapFromV2Yaml(yaml));
+
+  InSequence s;
+  ReadyWatcher initialized;
+  EXPECT_CALL(initialized, ready());
+  cluster_manager_->setInitializedCb([&]() -> void { initialized.ready(); });
+
+  // CDS clusters are only known by name until they are used.
+  EXPECT_CALL(factory_, clusterFromProto_(_, _, _, _, _)).Times(0);
+  EXPECT_TRUE(cluster_manager_->addOrUpdateCluster(defaultStaticCluster("fake_cluster"), ""));
+  EXPECT_FALSE(cluster_manager_->addOrUpdateCluster(defaultStaticCluster("fake_cluster"), ""));
+  checkStats(1 /*added*/, 0 /*modified*/, 0 /*removed*/, 0 /*active*/, 0 /*warming*/);
+  EXPECT_EQ(1UL, factory_.stats_.gauge("cluster_manager.on_demand_clusters").value());
+  EXPECT_EQ(nullptr, cluster_manager_->get("fake_cluster"));
+  EXPECT_EQ(0UL, cluster_manager_->clusters().size());
+
+  // Unknown clusters have nothing to wait for.
+  EXPECT_EQ(nullptr, cluster_manager_->loadOnDemandCluster("foo", []() -> void {}));
+
+  // The first request loads the cluster, and every request waits for it to warm.
+  ReadyWatcher loaded;
+  std::shared_ptr<MockCluster> cluster1(new NiceMock<MockCluster>());
+  EXPECT_CALL(factory_, clusterFromProto_(_, _, _, _, _)).WillOnce(Return(cluster1));
+  EXPECT_CALL(*cluster1, initialize(_));
+  OnDemandClusterHandlePtr handle1 =
+      cluster_manager_->loadOnDemandCluster("fake_cluster", [&]() -> void { loaded.ready(); });
+  EXPECT_NE(nullptr, handle1);
+  OnDemandClusterHandlePtr handle2 =
+      cluster_manager_->loadOnDemandCluster("fake_cluster", [&]() -> void { loaded.ready(); });
+  EXPECT_NE(nullptr, handle2);
+  checkStats(1 /*added*/, 0 /*modified*/, 0 /*removed*/, 0 /*active*/, 1 /*warming*/);
+  EXPECT_EQ(1UL, factory_.stats_.counter("cluster_manager.cluster_on_demand_loaded").value());
+
+  EXPECT_CALL(loaded, ready()).Times(2);
+  cluster1->initialize_callback_();
+  EXPECT_EQ(cluster1->info_, cluster_manager_->get("fake_cluster")->info());
+  checkStats(1 /*added*/, 0 /*modified*/, 0 /*removed*/, 1 /*active*/, 0 /*warming*/);
+
+  // Once loaded, there is nothing to wait for.
+  handle1.reset();
+  handle2.reset();
+  EXPECT_EQ(nullptr, cluster_manager_->loadOnDemandCluster("fake_cluster", []() -> void {}));
+
+  // Updates of loaded clusters apply right away.
+  auto update_cluster = defaultStaticCluster("fake_cluster");
+  update_cluster.mutable_per_connection_buffer_limit_bytes()->set_value(12345);
+  std::shared_ptr<MockCluster> cluster2(new NiceMock<MockCluster>());
+  EXPECT_CALL(factory_, clusterFromProto_(_, _, _, _, _)).WillOnce(Return(cluster2));
+  EXPECT_CALL(*cluster2, initialize(_));
+  EXPECT_TRUE(cluster_manager_->addOrUpdateCluster(update_cluster, ""));
+  cluster2->initialize_callback_();
+  EXPECT_EQ(cluster2->info_, cluster_manager_->get("fake_cluster")->info());
+
+  EXPECT_TRUE(cluster_manager_->removeCluster("fake_cluster"));
+  EXPECT_EQ(nullptr, cluster_manager_->get("fake_cluster"));
+  EXPECT_EQ(nullptr, cluster_manager_->loadOnDemandCluster("fake_cluster", []() -> void {}));
+  checkStats(1 /*added*/, 1 /*modified*/, 1 /*removed*/, 0 /*active*/, 0 /*warming*/);
+  EXPECT_EQ(0UL, factory_.stats_.gauge("cluster_manager.on_demand_clusters").value());
+}
+
+TEST_F(ClusterManagerImplTest, OnDemandClusterRemovedWhileLoading) {
+  const std::string yaml = R"EOF(
+  static_resources:
+    clusters: []
+  cluster_manager:
+    on_demand_clusters: {}
+  )EOF";
+
+  create(parseBootstrapFromV2Yaml(yaml));
+
+  InSequence s;
+  EXPECT_TRUE(cluster_manager_->addOrUpdateCluster(defaultStaticCluster("fake_cluster"), ""));
+
+  // Updates of clusters that aren't loaded only replace their config.
+  auto update_cluster = defaultStaticCluster("fake_cluster");
+  update_cluster.mutable_per_connection_buffer_limit_bytes()->set_value(12345);
+  EXPECT_CALL(factory_, clusterFromProto_(_, _, _, _, _)).Times(0);
+  EXPECT_TRUE(cluster_manager_->addOrUpdateCluster(update_cluster, ""));
+  checkStats(1 /*added*/, 1 /*modified*/, 0 /*removed*/, 0 /*active*/, 0 /*warming*/);
+
+  ReadyWatcher loaded;
+  std::shared_ptr<MockCluster> cluster1(new NiceMock<MockCluster>());
+  EXPECT_CALL(factory_, clusterFromProto_(_, _, _, _, _))
+      .WillOnce(Invoke([&](const envoy::api::v2::Cluster& cluster, ClusterManager&,
+                           Outlier::EventLoggerSharedPtr, AccessLog::AccessLogManager&,
+                           bool) -> ClusterSharedPtr {
+        EXPECT_EQ(12345, cluster.per_connection_buffer_limit_bytes().value());
+        return cluster1;
+      }));
+  EXPECT_CALL(*cluster1, initialize(_));
+  OnDemandClusterHandlePtr handle1 =
+      cluster_manager_->loadOnDemandCluster("fake_cluster", [&]() -> void { loaded.ready(); });
+  OnDemandClusterHandlePtr handle2 =
+      cluster_manager_->loadOnDemandCluster("fake_cluster", [&]() -> void { loaded.ready(); });
+
+  // Requests that stopped waiting aren't called back.
+  handle2.reset();
+  EXPECT_CALL(loaded, ready());
+  EXPECT_TRUE(cluster_manager_->removeCluster("fake_cluster"));
+  EXPECT_EQ(nullptr, cluster_manager_->get("fake_cluster"));
+  checkStats(1 /*added*/, 1 /*modified*/, 1 /*removed*/, 0 /*active*/, 0 /*warming*/);
+}
+
+TEST_F(ClusterManagerImplTest, OnDemandClusterIdleUnload) {
+  const std::string yaml = R"EOF(
+  static_resources:
+    clusters: []
+  cluster_manager:
+    on_demand_clusters:
+      idle_timeout: 60s
+  )EOF";
+
+  Event::MockTimer* idle_timer = new NiceMock<Event::MockTimer>(&factory_.dispatcher_);
+  EXPECT_CALL(*idle_timer, enableTimer(std::chrono::milliseconds(60000)));
+  create(parseBootstrapFromV2Yaml(yaml));
+
+  EXPECT_TRUE(cluster_manager_->addOrUpdateCluster(defaultStaticCluster("fake_cluster"), ""));
+  std::shared_ptr<MockCluster> cluster1(new NiceMock<MockCluster>());
+  EXPECT_CALL(factory_, clusterFromProto_(_, _, _, _, _)).WillOnce(Return(cluster1));
+  EXPECT_CALL(*cluster1, initialize(_));
+  OnDemandClusterHandlePtr handle =
+      cluster_manager_->loadOnDemandCluster("fake_cluster", []() -> void {});
+  cluster1->initialize_callback_();
+  handle.reset();
+  EXPECT_NE(nullptr, cluster_manager_->get("fake_cluster"));
+
+  // The first check only records the activity of the cluster.
+  EXPECT_CALL(*idle_timer, enableTimer(std::chrono::milliseconds(60000)));
+  idle_timer->callback_();
+  EXPECT_NE(nullptr, cluster_manager_->get("fake_cluster"));
+
+  // Clusters with new requests aren't idle.
+  cluster1->info_->stats_.upstream_rq_total_.inc();
+  EXPECT_CALL(*idle_timer, enableTimer(std::chrono::milliseconds(60000)));
+  idle_timer->callback_();
+  EXPECT_NE(nullptr, cluster_manager_->get("fake_cluster"));
+
+  // Nor are clusters with active requests.
+  cluster1->info_->stats_.upstream_rq_active_.inc();
+  EXPECT_CALL(*idle_timer, enableTimer(std::chrono::milliseconds(60000)));
+  idle_timer->callback_();
+  EXPECT_NE(nullptr, cluster_manager_->get("fake_cluster"));
+
+  cluster1->info_->stats_.upstream_rq_active_.dec();
+  EXPECT_CALL(*idle_timer, enableTimer(std::chrono::milliseconds(60000)));
+  idle_timer->callback_();
+  EXPECT_EQ(nullptr, cluster_manager_->get("fake_cluster"));
+  EXPECT_EQ(1UL, factory_.stats_.counter("cluster_manager.cluster_on_demand_unloaded").value());
+  checkStats(1 /*added*/, 0 /*modified*/, 0 /*removed*/, 0 /*active*/, 0 /*warming*/);
+  EXPECT_EQ(1UL, factory_.stats_.gauge("cluster_manager.on_demand_clusters").value());
+
+  // Unloaded clusters are loaded again when used.
+  std::shared_ptr<MockCluster> cluster2(new NiceMock<MockCluster>());
+  EXPECT_CALL(factory_, clusterFromProto_(_, _, _, _, _)).WillOnce(Return(cluster2));
+  EXPECT_CALL(*cluster2, initialize(_));
+  handle = cluster_manager_->loadOnDemandCluster("fake_cluster", []() -> void {});
+  EXPECT_NE(nullptr, handle);
+  cluster2->initialize_callback_();
+  EXPECT_EQ(cluster2->info_, cluster_manager_->get("fake_cluster")->info());
+  EXPECT_EQ(2UL, factory_.stats_.counter("cluster_manager.cluster_on_demand_loaded").value());
+}
+
 TEST_F(ClusterManagerImplTest, addOrUpdateClusterStaticExists) {
   const std::string json =
       fmt::sprintf("{%s}", clustersJson({defaultStaticClusterJson("some_cluster")}));
@@ -1410,6 +1684,70 @@ TEST_F(ClusterManagerImplTest, DoNotCloseTcpConnectionsOnHealthFailure) {
   EXPECT_TRUE(Mock::VerifyAndClearExpectations(cluster1.get()));
 }
 
+// Verify that the HTTP connection pools of a cluster's hosts are warmed when the cluster has a
+// minimum connection count, and that requests then use the warmed pool.
+TEST_F(ClusterManagerImplTest, PrefetchConnPoolsOnHostAdd) {
+  const std::string yaml = R"EOF(
+  static_resources:
+    clusters:
+    - name: cluster_1
+      connect_timeout: 0.250s
+      type: STATIC
+      lb_policy: ROUND_ROBIN
+      prefetch_policy:
+        min_connections_per_host: 2
+      hosts:
+      - socket_address:
+          address: "127.0.0.1"
+          port_value: 11001
+  )EOF";
+
+  Http::ConnectionPool::MockInstance* cp = new Http::ConnectionPool::MockInstance();
+  EXPECT_CALL(factory_, allocateConnPool_(_)).WillOnce(Return(cp));
+  EXPECT_CALL(*cp, prefetch());
+  create(parseBootstrapFromV2Yaml(yaml));
+
+  EXPECT_EQ(cp, cluster_manager_->httpConnPoolForCluster("cluster_1", ResourcePriority::Default,
+                                                         Http::Protocol::Http11, nullptr));
+}
+
+// Test that HTTP/2 pools of clusters that share them across workers go through the shared pool
+// registry, and that other pools of the cluster are allocated per worker.
+TEST_F(ClusterManagerImplTest, SharedHttp2ConnPool) {
+  const std::string yaml = R"EOF(
+  static_resources:
+    clusters:
+    - name: cluster_1
+      connect_timeout: 0.250s
+      type: STATIC
+      lb_policy: ROUND_ROBIN
+      http2_protocol_options: {}
+      share_http2_connections_across_workers: true
+      hosts:
+      - socket_address:
+          address: "127.0.0.1"
+          port_value: 11001
+  )EOF";
+
+  create(parseBootstrapFromV2Yaml(yaml));
+  EXPECT_TRUE(cluster_manager_->get("cluster_1")->info()->features() &
+              ClusterInfo::Features::SHARE_HTTP2_CONNECTIONS_ACROSS_WORKERS);
+
+  Http::ConnectionPool::MockInstance* cp = new NiceMock<Http::ConnectionPool::MockInstance>();
+  EXPECT_CALL(factory_, allocateConnPool_(_)).WillOnce(Return(cp));
+  Http::ConnectionPool::Instance* shared_cp = cluster_manager_->httpConnPoolForCluster(
+      "cluster_1", ResourcePriority::Default, Http::Protocol::Http2, nullptr);
+  EXPECT_NE(nullptr, dynamic_cast<Http::OwnerConnPool*>(shared_cp));
+
+  EXPECT_CALL(*cp, drainConnections());
+  shared_cp->drainConnections();
+
+  Http::ConnectionPool::MockInstance* cp2 = new Http::ConnectionPool::MockInstance();
+  EXPECT_CALL(factory_, allocateConnPool_(_)).WillOnce(Return(cp2));
+  EXPECT_EQ(cp2, cluster_manager_->httpConnPoolForCluster("cluster_1", ResourcePriority::Default,
+                                                          Http::Protocol::Http11, nullptr));
+}
+
 TEST_F(ClusterManagerImplTest, DynamicHostRemove) {
   const std::string json = R"EOF(
   {
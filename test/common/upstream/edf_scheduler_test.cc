@@ -65,12 +65,80 @@ TEST(EdfSchedulerTest, Expired) {
     sched.add(2, first_entry);
     sched.add(1, second_entry);
   }
+  // Expired entries are only discarded as they are reached.
+  EXPECT_EQ(2, sched.size());
 
   auto p = sched.pick();
   EXPECT_EQ(*second_entry, *p);
+  EXPECT_EQ(0, sched.size());
   EXPECT_EQ(nullptr, sched.pick());
 }
 
+TEST(IndexedEdfSchedulerTest, Empty) {
+  IndexedEdfScheduler sched;
+  EXPECT_TRUE(sched.empty());
+  EXPECT_FALSE(sched.pick().has_value());
+}
+
+// Validate that entries stay scheduled when picked, in FIFO order when they have the same weight.
+TEST(IndexedEdfSchedulerTest, Unweighted) {
+  IndexedEdfScheduler sched;
+  for (uint32_t i = 0; i < 3; ++i) {
+    sched.set(i, 1);
+  }
+  for (uint32_t i = 0; i < 6; ++i) {
+    EXPECT_EQ(i % 3, sched.pick().value());
+  }
+  EXPECT_EQ(3, sched.size());
+}
+
+// Validate that a weight update keeps the progress of the entry towards its next pick.
+TEST(IndexedEdfSchedulerTest, WeightUpdate) {
+  IndexedEdfScheduler sched;
+  sched.set(0, 2);
+  sched.set(1, 1);
+  EXPECT_EQ(0, sched.pick().value());
+  // Entry 1 was halfway to its deadline, it has a quarter of the time left now.
+  sched.set(1, 4);
+  EXPECT_DOUBLE_EQ(4, sched.weight(1));
+  EXPECT_EQ(1, sched.pick().value());
+  EXPECT_EQ(1, sched.pick().value());
+  EXPECT_EQ(0, sched.pick().value());
+  EXPECT_EQ(1, sched.pick().value());
+  EXPECT_EQ(1, sched.pick().value());
+  EXPECT_EQ(0, sched.pick().value());
+}
+
+// Validate that removed entries are never picked.
+TEST(IndexedEdfSchedulerTest, Remove) {
+  IndexedEdfScheduler sched;
+  for (uint32_t i = 0; i < 4; ++i) {
+    sched.set(i, i + 1);
+  }
+  sched.remove(3);
+  sched.remove(0);
+  // Entries that are not scheduled are ignored.
+  sched.remove(0);
+  sched.remove(42);
+  EXPECT_FALSE(sched.contains(0));
+  EXPECT_TRUE(sched.contains(1));
+  EXPECT_EQ(2, sched.size());
+
+  // Entries 1 and 2 have weights 2 and 3.
+  uint32_t picks[3] = {};
+  for (uint32_t i = 0; i < 50; ++i) {
+    ++picks[sched.pick().value()];
+  }
+  EXPECT_EQ(0, picks[0]);
+  EXPECT_EQ(20, picks[1]);
+  EXPECT_EQ(30, picks[2]);
+
+  sched.remove(1);
+  sched.remove(2);
+  EXPECT_TRUE(sched.empty());
+  EXPECT_FALSE(sched.pick().has_value());
+}
+
 } // namespace
 } // namespace Upstream
 } // namespace Envoy
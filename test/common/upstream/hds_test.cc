@@ -252,6 +252,96 @@ TEST_F(HdsTest, TestStreamConnectionFailure) {
   retry_timer_cb_();
 }
 
+// Tests that a HealthCheckSpecifier which leaves a cluster unchanged keeps its hosts, and that
+// the hosts of a changed cluster are replaced.
+TEST_F(HdsTest, TestProcessMessageKeepsUnchangedClusters) {
+  EXPECT_CALL(*async_client_, start(_, _)).WillOnce(Return(&async_stream_));
+  EXPECT_CALL(async_stream_, sendMessage(_, _));
+  createHdsDelegate();
+
+  auto create_message = [](uint32_t port) {
+    auto* message = new envoy::service::discovery::v2::HealthCheckSpecifier;
+    message->mutable_interval()->set_seconds(1);
+    for (int i = 0; i < 2; i++) {
+      auto* health_check = message->add_cluster_health_checks();
+      health_check->set_cluster_name("anna" + std::to_string(i));
+      auto* address = health_check->add_locality_endpoints()->add_endpoints()->mutable_address();
+      address->mutable_socket_address()->set_address("127.0.0." + std::to_string(i));
+      address->mutable_socket_address()->set_port_value(i == 0 ? 1234 : port);
+    }
+    return message;
+  };
+
+  EXPECT_CALL(test_factory_, createClusterInfo(_, _, _, _, _, _, _, _, _, _)).Times(3);
+  message.reset(create_message(1234));
+  hds_delegate_friend_.processPrivateMessage(*hds_delegate_, std::move(message));
+  const std::vector<HdsClusterPtr> clusters = hds_delegate_->hdsClusters();
+
+  message.reset(create_message(4321));
+  hds_delegate_friend_.processPrivateMessage(*hds_delegate_, std::move(message));
+  ASSERT_EQ(2, hds_delegate_->hdsClusters().size());
+  EXPECT_EQ(clusters[0], hds_delegate_->hdsClusters()[0]);
+  EXPECT_NE(clusters[1], hds_delegate_->hdsClusters()[1]);
+  EXPECT_EQ(4321, hds_delegate_->hdsClusters()[1]
+                      ->prioritySet()
+                      .hostSetsPerPriority()[0]
+                      ->hosts()[0]
+                      ->address()
+                      ->ip()
+                      ->port());
+}
+
+// Tests that with report_changes_only, responses only list the endpoints whose health changed
+// since the previous response.
+TEST_F(HdsTest, TestSendResponseChangesOnly) {
+  EXPECT_CALL(*async_client_, start(_, _)).WillOnce(Return(&async_stream_));
+  EXPECT_CALL(async_stream_, sendMessage(_, _));
+  createHdsDelegate();
+
+  // Create Message
+  // - Cluster "anna" with 2 endpoints and no health checks
+  message.reset(new envoy::service::discovery::v2::HealthCheckSpecifier);
+  message->mutable_interval()->set_seconds(1);
+  message->set_report_changes_only(true);
+  auto* health_check = message->add_cluster_health_checks();
+  health_check->set_cluster_name("anna");
+  for (int j = 0; j < 2; j++) {
+    auto* address = health_check->add_locality_endpoints()->add_endpoints()->mutable_address();
+    address->mutable_socket_address()->set_address("127.0.0.0");
+    address->mutable_socket_address()->set_port_value(1234 + j);
+  }
+
+  EXPECT_CALL(test_factory_, createClusterInfo(_, _, _, _, _, _, _, _, _, _))
+      .WillOnce(Return(cluster_info_));
+  hds_delegate_friend_.processPrivateMessage(*hds_delegate_, std::move(message));
+
+  EXPECT_CALL(*server_response_timer_, enableTimer(_)).Times(3);
+  EXPECT_CALL(async_stream_, sendMessage(_, false)).Times(3);
+
+  // Every endpoint is reported the first time.
+  auto msg = hds_delegate_->sendResponse();
+  EXPECT_EQ(2, msg.endpoint_health_response().endpoints_health_size());
+
+  // Nothing changed.
+  msg = hds_delegate_->sendResponse();
+  EXPECT_EQ(0, msg.endpoint_health_response().endpoints_health_size());
+
+  // The second endpoint turns healthy.
+  const HostSharedPtr host =
+      hds_delegate_->hdsClusters()[0]->prioritySet().hostSetsPerPriority()[0]->hosts()[1];
+  host->healthFlagClear(Host::HealthFlag::FAILED_ACTIVE_HC);
+  msg = hds_delegate_->sendResponse();
+  ASSERT_EQ(1, msg.endpoint_health_response().endpoints_health_size());
+  EXPECT_EQ(envoy::api::v2::core::HealthStatus::HEALTHY,
+            msg.endpoint_health_response().endpoints_health(0).health_status());
+  EXPECT_EQ(1235, msg.endpoint_health_response()
+                      .endpoints_health(0)
+                      .endpoint()
+                      .address()
+                      .socket_address()
+                      .port_value());
+}
+
 // TODO(lilika): Add unit tests for HdsDelegate::sendResponse() with healthy and
 // unhealthy endpoints.
 
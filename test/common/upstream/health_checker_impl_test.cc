@@ -2096,6 +2096,106 @@ TEST_F(TcpHealthCheckerImplTest, PassiveFailureCrossThreadRemoveClusterRace) {
   EXPECT_EQ(0UL, cluster_->info_->stats_store_.counter("health_check.passive_failure").value());
 }
 
+class SharedTcpHealthCheckerImplTest : public TcpHealthCheckerImplTest {
+public:
+  std::shared_ptr<TcpHealthCheckerImpl> createShared(MockCluster& cluster) {
+    const std::string yaml = R"EOF(
+    timeout: 1s
+    interval: 1s
+    unhealthy_threshold: 2
+    healthy_threshold: 2
+    share_across_clusters: true
+    tcp_health_check: {}
+    )EOF";
+
+    return std::make_shared<TcpHealthCheckerImpl>(cluster, parseHealthCheckFromV2Yaml(yaml),
+                                                  dispatcher_, runtime_, random_, nullptr);
+  }
+
+  std::shared_ptr<MockCluster> cluster2_{new NiceMock<MockCluster>()};
+};
+
+// A host in two clusters is only probed by one of them, and the results apply to both.
+TEST_F(SharedTcpHealthCheckerImplTest, ProbedOnceForAllClusters) {
+  InSequence s;
+
+  std::shared_ptr<TcpHealthCheckerImpl> health_checker1 = createShared(*cluster_);
+  std::shared_ptr<TcpHealthCheckerImpl> health_checker2 = createShared(*cluster2_);
+  cluster_->prioritySet().getMockHostSet(0)->hosts_ = {
+      makeTestHost(cluster_->info_, "tcp://127.0.0.1:80")};
+  cluster2_->prioritySet().getMockHostSet(0)->hosts_ = {
+      makeTestHost(cluster2_->info_, "tcp://127.0.0.1:80")};
+
+  expectSessionCreate();
+  expectClientCreate();
+  EXPECT_CALL(*timeout_timer_, enableTimer(_));
+  health_checker1->start();
+
+  // The second cluster's session doesn't probe.
+  new Event::MockTimer(&dispatcher_);
+  new Event::MockTimer(&dispatcher_);
+  health_checker2->start();
+
+  EXPECT_CALL(*connection_, close(_));
+  EXPECT_CALL(*timeout_timer_, disableTimer());
+  EXPECT_CALL(*interval_timer_, enableTimer(_));
+  connection_->raiseEvent(Network::ConnectionEvent::Connected);
+
+  EXPECT_EQ(1UL, cluster_->info_->stats_store_.counter("health_check.attempt").value());
+  EXPECT_EQ(1UL, cluster_->info_->stats_store_.counter("health_check.success").value());
+  EXPECT_EQ(0UL, cluster2_->info_->stats_store_.counter("health_check.attempt").value());
+  EXPECT_EQ(1UL, cluster2_->info_->stats_store_.counter("health_check.success").value());
+
+  // A network failure is applied to the hosts of both clusters, each with its own threshold.
+  EXPECT_CALL(*timeout_timer_, enableTimer(_));
+  interval_timer_->callback_();
+  EXPECT_CALL(*timeout_timer_, disableTimer());
+  EXPECT_CALL(*interval_timer_, enableTimer(_));
+  connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  EXPECT_EQ(1UL, cluster_->info_->stats_store_.counter("health_check.network_failure").value());
+  EXPECT_EQ(1UL, cluster2_->info_->stats_store_.counter("health_check.network_failure").value());
+  EXPECT_FALSE(cluster2_->prioritySet().getMockHostSet(0)->hosts_[0]->healthFlagGet(
+      Host::HealthFlag::FAILED_ACTIVE_HC));
+}
+
+// When the host is removed from the probing cluster, another cluster's session takes over.
+TEST_F(SharedTcpHealthCheckerImplTest, ProbingSessionRemoved) {
+  InSequence s;
+
+  std::shared_ptr<TcpHealthCheckerImpl> health_checker1 = createShared(*cluster_);
+  std::shared_ptr<TcpHealthCheckerImpl> health_checker2 = createShared(*cluster2_);
+  cluster_->prioritySet().getMockHostSet(0)->hosts_ = {
+      makeTestHost(cluster_->info_, "tcp://127.0.0.1:80")};
+  cluster2_->prioritySet().getMockHostSet(0)->hosts_ = {
+      makeTestHost(cluster2_->info_, "tcp://127.0.0.1:80")};
+
+  expectSessionCreate();
+  expectClientCreate();
+  EXPECT_CALL(*timeout_timer_, enableTimer(_));
+  health_checker1->start();
+
+  Event::MockTimer* interval_timer2 = new Event::MockTimer(&dispatcher_);
+  Event::MockTimer* timeout_timer2 = new Event::MockTimer(&dispatcher_);
+  health_checker2->start();
+
+  EXPECT_CALL(*connection_, close(_));
+  EXPECT_CALL(*interval_timer2, enableTimer(std::chrono::milliseconds(0)));
+  HostVector old_hosts = std::move(cluster_->prioritySet().getMockHostSet(0)->hosts_);
+  cluster_->prioritySet().getMockHostSet(0)->runCallbacks({}, old_hosts);
+
+  expectClientCreate();
+  EXPECT_CALL(*timeout_timer2, enableTimer(_));
+  interval_timer2->callback_();
+  EXPECT_EQ(1UL, cluster2_->info_->stats_store_.counter("health_check.attempt").value());
+
+  EXPECT_CALL(*connection_, close(_));
+  EXPECT_CALL(*timeout_timer2, disableTimer());
+  EXPECT_CALL(*interval_timer2, enableTimer(_));
+  connection_->raiseEvent(Network::ConnectionEvent::Connected);
+  EXPECT_EQ(1UL, cluster2_->info_->stats_store_.counter("health_check.success").value());
+  EXPECT_EQ(0UL, cluster_->info_->stats_store_.counter("health_check.success").value());
+}
+
 class TestGrpcHealthCheckerImpl : public GrpcHealthCheckerImpl {
 public:
   using GrpcHealthCheckerImpl::GrpcHealthCheckerImpl;
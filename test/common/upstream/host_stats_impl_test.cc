@@ -0,0 +1,88 @@
+#include <memory>
+
+#include "common/upstream/host_stats_impl.h"
+#include "common/upstream/locality_load_stats.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Upstream {
+
+class HostStatsStoreTest : public testing::Test {
+public:
+  LocalityLoadStatsSharedPtr locality_load_stats_{
+      std::make_shared<LocalityLoadStatsImpl>(envoy::api::v2::core::Locality())};
+  HostStatsStoreSharedPtr store_{std::make_shared<HostStatsStore>(locality_load_stats_)};
+  HostStats stats_{ALL_HOST_STATS(POOL_COUNTER(*store_), POOL_GAUGE(*store_))};
+};
+
+// Validate that the stats of the store behave as regular stats.
+TEST_F(HostStatsStoreTest, Stats) {
+  EXPECT_EQ("cx_total", stats_.cx_total_.name());
+  EXPECT_EQ("cx_total", stats_.cx_total_.tagExtractedName());
+  EXPECT_TRUE(stats_.cx_total_.tags().empty());
+  EXPECT_FALSE(stats_.cx_total_.used());
+
+  stats_.cx_total_.inc();
+  stats_.cx_total_.add(2);
+  EXPECT_TRUE(stats_.cx_total_.used());
+  EXPECT_EQ(3U, stats_.cx_total_.value());
+  EXPECT_EQ(3U, stats_.cx_total_.latch());
+  EXPECT_EQ(0U, stats_.cx_total_.latch());
+  EXPECT_TRUE(stats_.cx_total_.latchChanged());
+  EXPECT_FALSE(stats_.cx_total_.latchChanged());
+  stats_.cx_total_.reset();
+  EXPECT_EQ(0U, stats_.cx_total_.value());
+
+  stats_.cx_active_.inc();
+  stats_.cx_active_.add(2);
+  stats_.cx_active_.dec();
+  EXPECT_EQ(2U, stats_.cx_active_.value());
+  stats_.cx_active_.set(5);
+  EXPECT_EQ(5U, stats_.cx_active_.value());
+  EXPECT_TRUE(stats_.cx_active_.latchChanged());
+
+  // Stats that are not used for load reporting are not recorded in the locality load stats.
+  const LocalityLoadStats::Snapshot snapshot = locality_load_stats_->latch();
+  EXPECT_EQ(0U, snapshot.rq_success_);
+  EXPECT_EQ(0U, snapshot.rq_active_);
+}
+
+// Validate that the stats listed by the store share the ownership of the store.
+TEST_F(HostStatsStoreTest, List) {
+  stats_.rq_timeout_.inc();
+  std::vector<Stats::CounterSharedPtr> counters = store_->counters();
+  std::vector<Stats::GaugeSharedPtr> gauges = store_->gauges();
+  EXPECT_EQ(6U, counters.size());
+  EXPECT_EQ(2U, gauges.size());
+  store_.reset();
+
+  for (const Stats::CounterSharedPtr& counter : counters) {
+    EXPECT_EQ(counter->name() == "rq_timeout" ? 1U : 0U, counter->value());
+  }
+  EXPECT_EQ("cx_active", gauges[0]->name());
+  EXPECT_EQ("rq_active", gauges[1]->name());
+}
+
+// Validate that the request stats are added to the load stats of the locality.
+TEST_F(HostStatsStoreTest, LocalityLoadStats) {
+  stats_.rq_success_.inc();
+  stats_.rq_success_.add(2);
+  stats_.rq_error_.inc();
+  stats_.rq_total_.inc();
+  stats_.rq_active_.add(2);
+  stats_.rq_active_.dec();
+
+  LocalityLoadStats::Snapshot snapshot = locality_load_stats_->latch();
+  EXPECT_EQ(3U, snapshot.rq_success_);
+  EXPECT_EQ(1U, snapshot.rq_error_);
+  EXPECT_EQ(1U, snapshot.rq_active_);
+
+  stats_.rq_active_.set(4);
+  snapshot = locality_load_stats_->latch();
+  EXPECT_EQ(0U, snapshot.rq_success_);
+  EXPECT_EQ(4U, snapshot.rq_active_);
+}
+
+} // namespace Upstream
+} // namespace Envoy
@@ -0,0 +1,71 @@
+#include <chrono>
+#include <cmath>
+
+#include "common/upstream/latency_estimator_impl.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Upstream {
+
+class PeakEwmaLatencyEstimatorTest : public ::testing::Test {
+public:
+  PeakEwmaLatencyEstimatorTest() {
+    envoy::api::v2::Cluster::PeakEwmaLbConfig config;
+    config.mutable_decay_time()->set_seconds(1);
+    config_ = config;
+  }
+
+  MonotonicTime at(uint64_t ms) { return start_ + std::chrono::milliseconds(ms); }
+
+  absl::optional<envoy::api::v2::Cluster::PeakEwmaLbConfig> config_;
+  const MonotonicTime start_{std::chrono::hours(1)};
+};
+
+TEST_F(PeakEwmaLatencyEstimatorTest, NoResponse) {
+  PeakEwmaLatencyEstimator estimator(config_);
+  EXPECT_EQ(0, estimator.estimate(at(0)));
+  EXPECT_EQ(0, estimator.estimate(at(1000)));
+}
+
+// Response times above the estimate replace it.
+TEST_F(PeakEwmaLatencyEstimatorTest, Peak) {
+  PeakEwmaLatencyEstimator estimator(config_);
+  estimator.putResponseTime(std::chrono::microseconds(100), at(0));
+  EXPECT_DOUBLE_EQ(100, estimator.estimate(at(0)));
+  estimator.putResponseTime(std::chrono::microseconds(5000), at(0));
+  EXPECT_DOUBLE_EQ(5000, estimator.estimate(at(0)));
+}
+
+// Lower response times are averaged in with a weight growing with the time elapsed since the
+// last one.
+TEST_F(PeakEwmaLatencyEstimatorTest, Average) {
+  PeakEwmaLatencyEstimator estimator(config_);
+  estimator.putResponseTime(std::chrono::microseconds(1000), at(0));
+  estimator.putResponseTime(std::chrono::microseconds(0), at(0));
+  EXPECT_DOUBLE_EQ(1000, estimator.estimate(at(0)));
+
+  const double weight = std::exp(-0.5);
+  estimator.putResponseTime(std::chrono::microseconds(200), at(500));
+  EXPECT_DOUBLE_EQ(1000 * weight + 200 * (1 - weight), estimator.estimate(at(500)));
+}
+
+// The estimate decays while no response is received.
+TEST_F(PeakEwmaLatencyEstimatorTest, Decay) {
+  PeakEwmaLatencyEstimator estimator(config_);
+  estimator.putResponseTime(std::chrono::microseconds(1000), at(0));
+  EXPECT_DOUBLE_EQ(1000 * std::exp(-1), estimator.estimate(at(1000)));
+  EXPECT_DOUBLE_EQ(1000 * std::exp(-2), estimator.estimate(at(2000)));
+
+  // Times before the last update, e.g. read by another worker, don't increase the estimate.
+  EXPECT_DOUBLE_EQ(1000, estimator.estimate(start_ - std::chrono::milliseconds(1)));
+}
+
+TEST_F(PeakEwmaLatencyEstimatorTest, DefaultDecayTime) {
+  PeakEwmaLatencyEstimator estimator(absl::nullopt);
+  estimator.putResponseTime(std::chrono::microseconds(1000), at(0));
+  EXPECT_DOUBLE_EQ(1000 * std::exp(-0.1), estimator.estimate(at(1000)));
+}
+
+} // namespace Upstream
+} // namespace Envoy
@@ -1,6 +1,8 @@
 // Usage: bazel run //test/common/upstream:load_balancer_benchmark
 
 #include "common/runtime/runtime_impl.h"
+#include "common/upstream/edf_scheduler.h"
+#include "common/upstream/load_balancer_impl.h"
 #include "common/upstream/maglev_lb.h"
 #include "common/upstream/ring_hash_lb.h"
 #include "common/upstream/upstream_impl.h"
@@ -340,6 +342,108 @@ BENCHMARK(BM_MaglevLoadBalancerWeighted)
     ->Args({500, 95, 75, 25, 10000})
     ->Unit(benchmark::kMillisecond);
 
+void BM_IndexedEdfSchedulerPick(benchmark::State& state) {
+  const uint64_t num_entries = state.range(0);
+  IndexedEdfScheduler scheduler;
+  for (uint64_t i = 0; i < num_entries; i++) {
+    scheduler.set(i, 1 + i % 16);
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(scheduler.pick());
+  }
+}
+BENCHMARK(BM_IndexedEdfSchedulerPick)->Arg(10)->Arg(100)->Arg(1000)->Arg(10000);
+
+void BM_IndexedEdfSchedulerWeightUpdate(benchmark::State& state) {
+  const uint64_t num_entries = state.range(0);
+  IndexedEdfScheduler scheduler;
+  for (uint64_t i = 0; i < num_entries; i++) {
+    scheduler.set(i, 1 + i % 16);
+  }
+  uint64_t update = 0;
+  for (auto _ : state) {
+    const uint64_t index = hashInt(update) % num_entries;
+    scheduler.set(index, 1 + update++ % 17);
+  }
+}
+BENCHMARK(BM_IndexedEdfSchedulerWeightUpdate)->Arg(10)->Arg(100)->Arg(1000)->Arg(10000);
+
+// A host set split into weighted localities, picked from by a locality weighted round robin load
+// balancer, i.e. a pick of a locality and then of a host in the locality.
+class LocalityWeightedTester {
+public:
+  LocalityWeightedTester(uint64_t num_localities, uint64_t hosts_per_locality) {
+    for (uint64_t i = 0; i < num_localities; i++) {
+      HostVector hosts;
+      for (uint64_t j = 0; j < hosts_per_locality; j++) {
+        const uint64_t n = i * hosts_per_locality + j;
+        ASSERT(n < 65536);
+        hosts.push_back(
+            makeTestHost(info_, fmt::format("tcp://10.0.{}.{}:6379", n / 256, n % 256), 1 + j % 4));
+      }
+      locality_hosts_.push_back(std::move(hosts));
+      locality_weights_.push_back(1 + i % 8);
+    }
+    common_config_.mutable_locality_weighted_lb_config();
+    updateHosts();
+    lb_ = std::make_unique<RoundRobinLoadBalancer>(priority_set_, nullptr, stats_, runtime_,
+                                                   random_, common_config_);
+  }
+
+  // Updates the host set with the current locality weights.
+  void updateHosts() {
+    HostsPerLocalitySharedPtr hosts_per_locality =
+        makeHostsPerLocality(std::vector<HostVector>(locality_hosts_));
+    HostVectorSharedPtr hosts{new HostVector()};
+    for (const HostVector& locality_hosts : locality_hosts_) {
+      hosts->insert(hosts->end(), locality_hosts.begin(), locality_hosts.end());
+    }
+    priority_set_.getOrCreateHostSet(0).updateHosts(
+        hosts, hosts, hosts_per_locality, hosts_per_locality,
+        std::make_shared<const LocalityWeights>(locality_weights_), {}, {}, absl::nullopt);
+  }
+
+  PrioritySetImpl priority_set_;
+  std::shared_ptr<MockClusterInfo> info_{new NiceMock<MockClusterInfo>()};
+  std::vector<HostVector> locality_hosts_;
+  LocalityWeights locality_weights_;
+  Stats::IsolatedStoreImpl stats_store_;
+  ClusterStats stats_{ClusterInfoImpl::generateStats(stats_store_)};
+  NiceMock<Runtime::MockLoader> runtime_;
+  Runtime::RandomGeneratorImpl random_;
+  envoy::api::v2::Cluster::CommonLbConfig common_config_;
+  std::unique_ptr<RoundRobinLoadBalancer> lb_;
+};
+
+void BM_LocalityWeightedRoundRobinChooseHost(benchmark::State& state) {
+  LocalityWeightedTester tester(state.range(0), state.range(1));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(tester.lb_->chooseHost(nullptr));
+  }
+}
+BENCHMARK(BM_LocalityWeightedRoundRobinChooseHost)
+    ->Args({1, 100})
+    ->Args({10, 10})
+    ->Args({10, 100})
+    ->Args({100, 100});
+
+// Measures an update of the weight of a locality, as received from the control plane, including
+// the refresh of the schedules of the load balancer.
+void BM_LocalityWeightedRoundRobinWeightUpdate(benchmark::State& state) {
+  LocalityWeightedTester tester(state.range(0), state.range(1));
+  uint64_t update = 0;
+  for (auto _ : state) {
+    tester.locality_weights_[update % tester.locality_weights_.size()] = 1 + update % 7;
+    update++;
+    tester.updateHosts();
+  }
+}
+BENCHMARK(BM_LocalityWeightedRoundRobinWeightUpdate)
+    ->Args({10, 10})
+    ->Args({10, 100})
+    ->Args({100, 100})
+    ->Unit(benchmark::kMicrosecond);
+
 } // namespace
 } // namespace Upstream
 } // namespace Envoy
@@ -1,3 +1,4 @@
+#include <chrono>
 #include <memory>
 #include <set>
 #include <string>
@@ -9,6 +10,7 @@
 #include "common/upstream/upstream_impl.h"
 
 #include "test/common/upstream/utility.h"
+#include "test/mocks/common.h"
 #include "test/mocks/runtime/mocks.h"
 #include "test/mocks/upstream/mocks.h"
 
@@ -443,22 +445,23 @@ TEST_P(RoundRobinLoadBalancerTest, Weighted) {
   EXPECT_EQ(hostSet().healthy_hosts_[1], lb_->chooseHost(nullptr));
   EXPECT_EQ(hostSet().healthy_hosts_[0], lb_->chooseHost(nullptr));
   EXPECT_EQ(hostSet().healthy_hosts_[0], lb_->chooseHost(nullptr));
-  // Add a host, it should participate in next round of scheduling.
+  // Add a host, it should participate in next round of scheduling, which carries on from where it
+  // was for the other hosts.
   hostSet().healthy_hosts_.push_back(makeTestHost(info_, "tcp://127.0.0.1:82", 3));
   hostSet().hosts_.push_back(hostSet().healthy_hosts_.back());
   hostSet().runCallbacks({hostSet().healthy_hosts_.back()}, {});
   EXPECT_EQ(hostSet().healthy_hosts_[2], lb_->chooseHost(nullptr));
-  EXPECT_EQ(hostSet().healthy_hosts_[0], lb_->chooseHost(nullptr));
-  EXPECT_EQ(hostSet().healthy_hosts_[2], lb_->chooseHost(nullptr));
   EXPECT_EQ(hostSet().healthy_hosts_[1], lb_->chooseHost(nullptr));
   EXPECT_EQ(hostSet().healthy_hosts_[0], lb_->chooseHost(nullptr));
   EXPECT_EQ(hostSet().healthy_hosts_[2], lb_->chooseHost(nullptr));
   EXPECT_EQ(hostSet().healthy_hosts_[2], lb_->chooseHost(nullptr));
   EXPECT_EQ(hostSet().healthy_hosts_[0], lb_->chooseHost(nullptr));
   EXPECT_EQ(hostSet().healthy_hosts_[2], lb_->chooseHost(nullptr));
-  EXPECT_EQ(hostSet().healthy_hosts_[2], lb_->chooseHost(nullptr));
   EXPECT_EQ(hostSet().healthy_hosts_[1], lb_->chooseHost(nullptr));
   EXPECT_EQ(hostSet().healthy_hosts_[0], lb_->chooseHost(nullptr));
+  EXPECT_EQ(hostSet().healthy_hosts_[2], lb_->chooseHost(nullptr));
+  EXPECT_EQ(hostSet().healthy_hosts_[2], lb_->chooseHost(nullptr));
+  EXPECT_EQ(hostSet().healthy_hosts_[0], lb_->chooseHost(nullptr));
   // Remove last two hosts, add a new one with different weights.
   HostVector removed_hosts = {hostSet().hosts_[1], hostSet().hosts_[2]};
   hostSet().healthy_hosts_.pop_back();
@@ -469,6 +472,7 @@ TEST_P(RoundRobinLoadBalancerTest, Weighted) {
   hostSet().hosts_.push_back(hostSet().healthy_hosts_.back());
   hostSet().healthy_hosts_[0]->weight(1);
   hostSet().runCallbacks({hostSet().healthy_hosts_.back()}, removed_hosts);
+  // The new weight of the remaining host applies as of the refresh, rather than its next pick.
   EXPECT_EQ(hostSet().healthy_hosts_[1], lb_->chooseHost(nullptr));
   EXPECT_EQ(hostSet().healthy_hosts_[1], lb_->chooseHost(nullptr));
   EXPECT_EQ(hostSet().healthy_hosts_[1], lb_->chooseHost(nullptr));
@@ -481,6 +485,43 @@ TEST_P(RoundRobinLoadBalancerTest, Weighted) {
   EXPECT_EQ(hostSet().healthy_hosts_[1], lb_->chooseHost(nullptr));
 }
 
+// Validate that hosts leaving the healthy hosts are dropped from the weighted schedule, while the
+// others keep their place in it.
+TEST_P(RoundRobinLoadBalancerTest, WeightedHealthChange) {
+  hostSet().healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80", 1),
+                              makeTestHost(info_, "tcp://127.0.0.1:81", 2),
+                              makeTestHost(info_, "tcp://127.0.0.1:82", 2)};
+  hostSet().hosts_ = hostSet().healthy_hosts_;
+  init(false);
+  const HostVector hosts = hostSet().hosts_;
+  EXPECT_EQ(hosts[1], lb_->chooseHost(nullptr));
+  EXPECT_EQ(hosts[2], lb_->chooseHost(nullptr));
+
+  // The host leaving the healthy hosts is never picked, and the others carry on.
+  hostSet().healthy_hosts_ = {hosts[0], hosts[2]};
+  hostSet().runCallbacks({}, {});
+  EXPECT_EQ(hosts[0], lb_->chooseHost(nullptr));
+  EXPECT_EQ(hosts[2], lb_->chooseHost(nullptr));
+  EXPECT_EQ(hosts[2], lb_->chooseHost(nullptr));
+  EXPECT_EQ(hosts[0], lb_->chooseHost(nullptr));
+
+  // A host flapping while picks are unweighted is rescheduled each time it comes back.
+  stats_.max_host_weight_.set(1UL);
+  for (uint32_t i = 0; i < 10; ++i) {
+    hostSet().healthy_hosts_ = hosts;
+    hostSet().runCallbacks({}, {});
+    hostSet().healthy_hosts_ = {hosts[0], hosts[2]};
+    hostSet().runCallbacks({}, {});
+  }
+  stats_.max_host_weight_.set(2UL);
+  EXPECT_EQ(hosts[2], lb_->chooseHost(nullptr));
+  EXPECT_EQ(hosts[2], lb_->chooseHost(nullptr));
+  EXPECT_EQ(hosts[0], lb_->chooseHost(nullptr));
+  EXPECT_EQ(hosts[2], lb_->chooseHost(nullptr));
+  EXPECT_EQ(hosts[2], lb_->chooseHost(nullptr));
+  EXPECT_EQ(hosts[0], lb_->chooseHost(nullptr));
+}
+
 // Validate that the RNG seed influences pick order when weighted RR.
 TEST_P(RoundRobinLoadBalancerTest, WeightedSeed) {
   hostSet().healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80", 1),
@@ -732,6 +773,86 @@ TEST_P(RoundRobinLoadBalancerTest, ZoneAwareRoutingSmallZone) {
   EXPECT_EQ(1U, stats_.lb_zone_routing_cross_zone_.value());
 }
 
+// Load balancers sharing a locality routing table cache route like those which don't.
+TEST_P(RoundRobinLoadBalancerTest, ZoneAwareRoutingSharedTable) {
+  if (&hostSet() == &failover_host_set_) { // P = 1 does not support zone-aware routing.
+    return;
+  }
+  HostVectorSharedPtr upstream_hosts(new HostVector(
+      {makeTestHost(info_, "tcp://127.0.0.1:80"), makeTestHost(info_, "tcp://127.0.0.1:81"),
+       makeTestHost(info_, "tcp://127.0.0.1:82"), makeTestHost(info_, "tcp://127.0.0.1:83"),
+       makeTestHost(info_, "tcp://127.0.0.1:84")}));
+  HostVectorSharedPtr local_hosts(new HostVector({makeTestHost(info_, "tcp://127.0.0.1:0"),
+                                                  makeTestHost(info_, "tcp://127.0.0.1:1"),
+                                                  makeTestHost(info_, "tcp://127.0.0.1:2")}));
+
+  HostsPerLocalitySharedPtr upstream_hosts_per_locality = makeHostsPerLocality(
+      {{makeTestHost(info_, "tcp://127.0.0.1:81")},
+       {makeTestHost(info_, "tcp://127.0.0.1:80"), makeTestHost(info_, "tcp://127.0.0.1:82")},
+       {makeTestHost(info_, "tcp://127.0.0.1:83"), makeTestHost(info_, "tcp://127.0.0.1:84")}});
+
+  HostsPerLocalitySharedPtr local_hosts_per_locality =
+      makeHostsPerLocality({{makeTestHost(info_, "tcp://127.0.0.1:0")},
+                            {makeTestHost(info_, "tcp://127.0.0.1:1")},
+                            {makeTestHost(info_, "tcp://127.0.0.1:2")}});
+
+  EXPECT_CALL(runtime_.snapshot_, getInteger("upstream.healthy_panic_threshold", 50))
+      .WillRepeatedly(Return(50));
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled("upstream.zone_routing.enabled", 100))
+      .WillRepeatedly(Return(true));
+  EXPECT_CALL(runtime_.snapshot_, getInteger("upstream.zone_routing.min_cluster_size", 6))
+      .WillRepeatedly(Return(5));
+
+  hostSet().healthy_hosts_ = *upstream_hosts;
+  hostSet().hosts_ = *upstream_hosts;
+  hostSet().healthy_hosts_per_locality_ = upstream_hosts_per_locality;
+  init(true);
+  auto cache = std::make_shared<LocalityRoutingTableCache>();
+  RoundRobinLoadBalancer lb1(priority_set_, local_priority_set_.get(), stats_, runtime_, random_,
+                             common_config_, cache);
+  RoundRobinLoadBalancer lb2(priority_set_, local_priority_set_.get(), stats_, runtime_, random_,
+                             common_config_, cache);
+  local_host_set_->updateHosts(local_hosts, local_hosts, local_hosts_per_locality,
+                               local_hosts_per_locality, {}, empty_host_vector_, empty_host_vector_,
+                               absl::nullopt);
+
+  for (LoadBalancer* lb : std::vector<LoadBalancer*>{lb_.get(), &lb1, &lb2}) {
+    // There is only one host in the given zone for zone aware routing.
+    EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(100));
+    EXPECT_EQ(hostSet().healthy_hosts_per_locality_->get()[0][0], lb->chooseHost(nullptr));
+
+    // Force request out of small zone.
+    EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(9999)).WillOnce(Return(2));
+    EXPECT_EQ(hostSet().healthy_hosts_per_locality_->get()[1][0], lb->chooseHost(nullptr));
+  }
+  EXPECT_EQ(3U, stats_.lb_zone_routing_sampled_.value());
+  EXPECT_EQ(3U, stats_.lb_zone_routing_cross_zone_.value());
+}
+
+// The table is only computed again when either hosts per locality is replaced.
+TEST(LocalityRoutingTableCacheTest, ComputedOncePerUpdate) {
+  LocalityRoutingTableCache cache;
+  HostsPerLocalityConstSharedPtr upstream = std::make_shared<HostsPerLocalityImpl>();
+  HostsPerLocalityConstSharedPtr local = std::make_shared<HostsPerLocalityImpl>();
+  uint32_t computed = 0;
+  auto compute = [&computed]() -> LocalityRoutingTableConstSharedPtr {
+    computed++;
+    return std::make_shared<LocalityRoutingTable>();
+  };
+
+  const LocalityRoutingTableConstSharedPtr table = cache.get(upstream, local, compute);
+  EXPECT_EQ(table, cache.get(upstream, local, compute));
+  EXPECT_EQ(1U, computed);
+
+  upstream = std::make_shared<HostsPerLocalityImpl>();
+  EXPECT_NE(table, cache.get(upstream, local, compute));
+  EXPECT_EQ(2U, computed);
+  local = std::make_shared<HostsPerLocalityImpl>();
+  cache.get(upstream, local, compute);
+  cache.get(upstream, local, compute);
+  EXPECT_EQ(3U, computed);
+}
+
 TEST_P(RoundRobinLoadBalancerTest, LowPrecisionForDistribution) {
   if (&hostSet() == &failover_host_set_) { // P = 1 does not support zone-aware routing.
     return;
@@ -920,7 +1041,7 @@ TEST_P(LeastRequestLoadBalancerTest, SingleHost) {
 
   // Host weight is 100.
   {
-    EXPECT_CALL(random_, random()).WillOnce(Return(0));
+    EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(2)).WillOnce(Return(3));
     stats_.max_host_weight_.set(100UL);
     EXPECT_EQ(hostSet().healthy_hosts_[0], lb_.chooseHost(nullptr));
   }
@@ -928,7 +1049,7 @@ TEST_P(LeastRequestLoadBalancerTest, SingleHost) {
   HostVector empty;
   {
     hostSet().runCallbacks(empty, empty);
-    EXPECT_CALL(random_, random()).WillOnce(Return(0));
+    EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(2)).WillOnce(Return(3));
     EXPECT_EQ(hostSet().healthy_hosts_[0], lb_.chooseHost(nullptr));
   }
 
@@ -971,38 +1092,29 @@ TEST_P(LeastRequestLoadBalancerTest, WeightImbalance) {
   hostSet().hosts_ = hostSet().healthy_hosts_;
   hostSet().runCallbacks({}, {}); // Trigger callbacks. The added/removed lists are not relevant.
 
-  EXPECT_CALL(random_, random()).WillRepeatedly(Return(0));
-
-  // We should see 2:1 ratio for hosts[1] to hosts[0].
-  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_.chooseHost(nullptr));
-  EXPECT_EQ(hostSet().healthy_hosts_[0], lb_.chooseHost(nullptr));
-  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_.chooseHost(nullptr));
+  // Among idle hosts, the host with the highest weight is picked, whatever the order of the
+  // choices.
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(0)).WillOnce(Return(1));
   EXPECT_EQ(hostSet().healthy_hosts_[1], lb_.chooseHost(nullptr));
-  EXPECT_EQ(hostSet().healthy_hosts_[0], lb_.chooseHost(nullptr));
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(1)).WillOnce(Return(0));
   EXPECT_EQ(hostSet().healthy_hosts_[1], lb_.chooseHost(nullptr));
 
-  // Bringing hosts[1] to an active request should yield a 1:1 ratio.
+  // Active requests are divided by the weight: (1 + 1) / 2 ties with (0 + 1) / 1, and the last
+  // choice is picked.
   hostSet().healthy_hosts_[1]->stats().rq_active_.set(1);
-  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_.chooseHost(nullptr));
-  EXPECT_EQ(hostSet().healthy_hosts_[0], lb_.chooseHost(nullptr));
-  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_.chooseHost(nullptr));
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(1)).WillOnce(Return(0));
   EXPECT_EQ(hostSet().healthy_hosts_[0], lb_.chooseHost(nullptr));
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(0)).WillOnce(Return(1));
   EXPECT_EQ(hostSet().healthy_hosts_[1], lb_.chooseHost(nullptr));
 
-  // Settings hosts[0] to an active request and hosts[1] to no active requests should yield a 4:1
-  // ratio.
-  hostSet().healthy_hosts_[0]->stats().rq_active_.set(1);
-  hostSet().healthy_hosts_[1]->stats().rq_active_.set(0);
-  EXPECT_EQ(hostSet().healthy_hosts_[0], lb_.chooseHost(nullptr));
-  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_.chooseHost(nullptr));
-  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_.chooseHost(nullptr));
-  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_.chooseHost(nullptr));
+  // With 3 active requests, the weighted host is more loaded than the idle one: (3 + 1) / 2 >
+  // (0 + 1) / 1. It is still picked over a host with 2 active requests: (3 + 1) / 2 < (2 + 1) / 1.
+  hostSet().healthy_hosts_[1]->stats().rq_active_.set(3);
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(0)).WillOnce(Return(1));
   EXPECT_EQ(hostSet().healthy_hosts_[0], lb_.chooseHost(nullptr));
+  hostSet().healthy_hosts_[0]->stats().rq_active_.set(2);
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(1)).WillOnce(Return(0));
   EXPECT_EQ(hostSet().healthy_hosts_[1], lb_.chooseHost(nullptr));
-  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_.chooseHost(nullptr));
-  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_.chooseHost(nullptr));
-  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_.chooseHost(nullptr));
-  EXPECT_EQ(hostSet().healthy_hosts_[0], lb_.chooseHost(nullptr));
 }
 
 TEST_P(LeastRequestLoadBalancerTest, WeightImbalanceCallbacks) {
@@ -1013,10 +1125,8 @@ TEST_P(LeastRequestLoadBalancerTest, WeightImbalanceCallbacks) {
   hostSet().hosts_ = hostSet().healthy_hosts_;
   hostSet().runCallbacks({}, {}); // Trigger callbacks. The added/removed lists are not relevant.
 
-  EXPECT_CALL(random_, random()).WillRepeatedly(Return(0));
-
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(0)).WillOnce(Return(1));
   EXPECT_EQ(hostSet().healthy_hosts_[1], lb_.chooseHost(nullptr));
-  EXPECT_EQ(hostSet().healthy_hosts_[0], lb_.chooseHost(nullptr));
 
   // Remove and verify we get other host.
   HostVector empty;
@@ -1025,12 +1135,108 @@ TEST_P(LeastRequestLoadBalancerTest, WeightImbalanceCallbacks) {
   hostSet().hosts_.erase(hostSet().hosts_.begin() + 1);
   hostSet().healthy_hosts_.erase(hostSet().healthy_hosts_.begin() + 1);
   hostSet().runCallbacks(empty, hosts_removed);
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(0)).WillOnce(Return(1));
   EXPECT_EQ(hostSet().healthy_hosts_[0], lb_.chooseHost(nullptr));
 }
 
+// The number of choices is configurable.
+TEST_P(LeastRequestLoadBalancerTest, ChoiceCount) {
+  envoy::api::v2::Cluster::LeastRequestLbConfig config;
+  config.mutable_choice_count()->set_value(3);
+  LeastRequestLoadBalancer lb{priority_set_, nullptr, stats_, runtime_, random_, common_config_,
+                              config};
+
+  hostSet().healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80"),
+                              makeTestHost(info_, "tcp://127.0.0.1:81"),
+                              makeTestHost(info_, "tcp://127.0.0.1:82")};
+  hostSet().hosts_ = hostSet().healthy_hosts_;
+  hostSet().runCallbacks({}, {}); // Trigger callbacks. The added/removed lists are not relevant.
+  hostSet().healthy_hosts_[0]->stats().rq_active_.set(2);
+  hostSet().healthy_hosts_[1]->stats().rq_active_.set(3);
+  hostSet().healthy_hosts_[2]->stats().rq_active_.set(1);
+
+  EXPECT_CALL(random_, random())
+      .WillOnce(Return(0))
+      .WillOnce(Return(0))
+      .WillOnce(Return(1))
+      .WillOnce(Return(2));
+  EXPECT_EQ(hostSet().healthy_hosts_[2], lb.chooseHost(nullptr));
+  EXPECT_CALL(random_, random())
+      .WillOnce(Return(0))
+      .WillOnce(Return(1))
+      .WillOnce(Return(0))
+      .WillOnce(Return(1));
+  EXPECT_EQ(hostSet().healthy_hosts_[0], lb.chooseHost(nullptr));
+}
+
 INSTANTIATE_TEST_CASE_P(PrimaryOrFailover, LeastRequestLoadBalancerTest,
                         ::testing::Values(true, false));
 
+class PeakEwmaLoadBalancerTest : public LoadBalancerTestBase {
+public:
+  PeakEwmaLoadBalancerTest() {
+    ON_CALL(time_source_, monotonicTime()).WillByDefault(Return(now_));
+  }
+
+  void putResponseTime(const HostSharedPtr& host, uint64_t us) {
+    host->latencyEstimator().putResponseTime(std::chrono::microseconds(us), now_);
+  }
+
+  const MonotonicTime now_{std::chrono::hours(1)};
+  NiceMock<MockTimeSource> time_source_;
+  PeakEwmaLoadBalancer lb_{priority_set_, nullptr, stats_, runtime_, random_, common_config_,
+                           time_source_};
+};
+
+TEST_P(PeakEwmaLoadBalancerTest, NoHosts) { EXPECT_EQ(nullptr, lb_.chooseHost(nullptr)); }
+
+TEST_P(PeakEwmaLoadBalancerTest, Latency) {
+  hostSet().healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80"),
+                              makeTestHost(info_, "tcp://127.0.0.1:81")};
+  hostSet().hosts_ = hostSet().healthy_hosts_;
+  hostSet().runCallbacks({}, {}); // Trigger callbacks. The added/removed lists are not relevant.
+
+  // Without any estimate, idle hosts tie and the second choice is picked.
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(0)).WillOnce(Return(1));
+  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_.chooseHost(nullptr));
+
+  // The idle host with the lowest latency is picked, whatever the order of the choices.
+  putResponseTime(hostSet().healthy_hosts_[0], 100);
+  putResponseTime(hostSet().healthy_hosts_[1], 1000);
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(0)).WillOnce(Return(1));
+  EXPECT_EQ(hostSet().healthy_hosts_[0], lb_.chooseHost(nullptr));
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(1)).WillOnce(Return(0));
+  EXPECT_EQ(hostSet().healthy_hosts_[0], lb_.chooseHost(nullptr));
+
+  // The latency is multiplied by the number of active requests plus one: 100 * 11 > 1000 * 1.
+  hostSet().healthy_hosts_[0]->stats().rq_active_.set(10);
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(0)).WillOnce(Return(1));
+  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_.chooseHost(nullptr));
+  hostSet().healthy_hosts_[1]->stats().rq_active_.set(1);
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(0)).WillOnce(Return(1));
+  EXPECT_EQ(hostSet().healthy_hosts_[0], lb_.chooseHost(nullptr));
+}
+
+// Hosts with no estimate yet are picked when idle, and are otherwise picked last.
+TEST_P(PeakEwmaLoadBalancerTest, NoEstimate) {
+  hostSet().healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80"),
+                              makeTestHost(info_, "tcp://127.0.0.1:81")};
+  hostSet().hosts_ = hostSet().healthy_hosts_;
+  hostSet().runCallbacks({}, {}); // Trigger callbacks. The added/removed lists are not relevant.
+  putResponseTime(hostSet().healthy_hosts_[0], 1000000);
+
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(1)).WillOnce(Return(0));
+  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_.chooseHost(nullptr));
+
+  hostSet().healthy_hosts_[0]->stats().rq_active_.set(100);
+  hostSet().healthy_hosts_[1]->stats().rq_active_.set(1);
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(1)).WillOnce(Return(0));
+  EXPECT_EQ(hostSet().healthy_hosts_[0], lb_.chooseHost(nullptr));
+}
+
+INSTANTIATE_TEST_CASE_P(PrimaryOrFailover, PeakEwmaLoadBalancerTest,
+                        ::testing::Values(true, false));
+
 class RandomLoadBalancerTest : public LoadBalancerTestBase {
 public:
   RandomLoadBalancer lb_{priority_set_, nullptr, stats_, runtime_, random_, common_config_};
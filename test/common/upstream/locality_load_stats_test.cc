@@ -0,0 +1,75 @@
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/upstream/locality_load_stats.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Upstream {
+namespace {
+
+envoy::api::v2::core::Locality makeLocality(const std::string& sub_zone) {
+  envoy::api::v2::core::Locality locality;
+  locality.set_region("region");
+  locality.set_zone("zone");
+  locality.set_sub_zone(sub_zone);
+  return locality;
+}
+
+} // namespace
+
+// Validate that latching returns the requests completed since the previous latch.
+TEST(LocalityLoadStatsImplTest, Latch) {
+  LocalityLoadStatsImpl stats(makeLocality("sub_zone"));
+  stats.addSuccess(3);
+  stats.addError(1);
+  stats.addActive(2);
+
+  LocalityLoadStats::Snapshot snapshot = stats.latch();
+  EXPECT_EQ(3U, snapshot.rq_success_);
+  EXPECT_EQ(1U, snapshot.rq_error_);
+  EXPECT_EQ(2U, snapshot.rq_active_);
+
+  stats.addSuccess(1);
+  stats.addActive(-2);
+  snapshot = stats.latch();
+  EXPECT_EQ(1U, snapshot.rq_success_);
+  EXPECT_EQ(0U, snapshot.rq_error_);
+  EXPECT_EQ(0U, snapshot.rq_active_);
+}
+
+// Validate that counts from several threads are merged.
+TEST(LocalityLoadStatsImplTest, MultipleThreads) {
+  LocalityLoadStatsImpl stats(makeLocality("sub_zone"));
+  std::vector<std::thread> threads;
+  for (uint32_t i = 0; i < LocalityLoadStatsImpl::NumShards + 2; ++i) {
+    threads.emplace_back([&stats]() -> void {
+      for (uint32_t j = 0; j < 1000; ++j) {
+        stats.addActive(1);
+        stats.addSuccess(1);
+        stats.addActive(-1);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  const LocalityLoadStats::Snapshot snapshot = stats.latch();
+  EXPECT_EQ((LocalityLoadStatsImpl::NumShards + 2) * 1000, snapshot.rq_success_);
+  EXPECT_EQ(0U, snapshot.rq_active_);
+}
+
+// Validate that the map returns the same stats for a locality.
+TEST(LocalityLoadStatsMapTest, Get) {
+  LocalityLoadStatsMap map;
+  const auto locality = makeLocality("sub_zone");
+  EXPECT_EQ(map.get(locality), map.get(locality));
+  EXPECT_EQ("sub_zone", map.get(locality)->locality().sub_zone());
+  EXPECT_NE(map.get(locality), map.get(makeLocality("other")));
+}
+
+} // namespace Upstream
+} // namespace Envoy
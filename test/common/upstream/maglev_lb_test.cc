@@ -105,6 +105,34 @@ TEST_F(MaglevLoadBalancerTest, Weighted) {
   }
 }
 
+// A table is only reused while the hosts and their weights stay the same.
+TEST_F(MaglevLoadBalancerTest, TableReuse) {
+  host_set_.hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:90", 1),
+                      makeTestHost(info_, "tcp://127.0.0.1:91", 2)};
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  MaglevTable table(HostsPerLocalityImpl(host_set_.hosts_, false), nullptr, 17);
+  EXPECT_TRUE(table.sameHosts(HostsPerLocalityImpl(host_set_.hosts_, false), nullptr));
+  EXPECT_FALSE(table.sameHosts(HostsPerLocalityImpl(HostVector{host_set_.hosts_[1]}, false), nullptr));
+
+  init(17);
+  const auto count_first_host = [this]() -> uint32_t {
+    LoadBalancerPtr lb = lb_->factory()->create();
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < 17; ++i) {
+      TestLoadBalancerContext context(i);
+      count += lb->chooseHost(&context) == host_set_.hosts_[0];
+    }
+    return count;
+  };
+  EXPECT_EQ(6, count_first_host());
+
+  // Weights may change in place, which must rebuild the table.
+  host_set_.hosts_[0]->weight(2);
+  EXPECT_FALSE(table.sameHosts(HostsPerLocalityImpl(host_set_.hosts_, false), nullptr));
+  host_set_.runCallbacks({}, {});
+  EXPECT_LT(6, count_first_host());
+}
+
 // Locality weighted sanity test when localities have the same weights (no
 // different to Weighted above).
 TEST_F(MaglevLoadBalancerTest, LocalityWeightedSameLocalityWeights) {
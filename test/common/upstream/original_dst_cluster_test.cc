@@ -486,6 +486,93 @@ TEST_F(OriginalDstClusterTest, MultipleClusters) {
   EXPECT_EQ(host, second.hostSetsPerPriority()[0]->hosts()[0]);
 }
 
+// Load balancers of different threads share the hosts they add, and new hosts are added to the host
+// set in batches.
+TEST_F(OriginalDstClusterTest, SharedHostMap) {
+  std::string json = R"EOF(
+  {
+    "name": "name",
+    "connect_timeout_ms": 1250,
+    "type": "original_dst",
+    "lb_type": "original_dst_lb"
+  }
+  )EOF";
+
+  EXPECT_CALL(initialized_, ready());
+  EXPECT_CALL(*cleanup_timer_, enableTimer(_));
+  setupFromJson(json);
+
+  NiceMock<Network::MockConnection> connection1;
+  TestLoadBalancerContext lb_context1(&connection1);
+  connection1.local_address_ = std::make_shared<Network::Address::Ipv4Instance>("10.10.11.11");
+  EXPECT_CALL(connection1, localAddressRestored()).WillRepeatedly(Return(true));
+
+  NiceMock<Network::MockConnection> connection2;
+  TestLoadBalancerContext lb_context2(&connection2);
+  connection2.local_address_ = std::make_shared<Network::Address::Ipv4Instance>("10.10.11.12");
+  EXPECT_CALL(connection2, localAddressRestored()).WillRepeatedly(Return(true));
+
+  OriginalDstCluster::LoadBalancer lb1(cluster_->prioritySet(), cluster_,
+                                       cluster_->info()->lbOriginalDstConfig());
+  OriginalDstCluster::LoadBalancer lb2(cluster_->prioritySet(), cluster_,
+                                       cluster_->info()->lbOriginalDstConfig());
+
+  // Only the first new host posts to the main thread, which adds both.
+  Event::PostCb post_cb;
+  EXPECT_CALL(dispatcher_, post(_)).WillOnce(SaveArg<0>(&post_cb));
+  HostConstSharedPtr host1 = lb1.chooseHost(&lb_context1);
+  HostConstSharedPtr host2 = lb1.chooseHost(&lb_context2);
+  ASSERT_NE(host1, nullptr);
+  ASSERT_NE(host2, nullptr);
+
+  // The other load balancer uses the hosts before they are in the host set.
+  EXPECT_EQ(host1, lb2.chooseHost(&lb_context1));
+  EXPECT_EQ(host2, lb2.chooseHost(&lb_context2));
+  EXPECT_EQ(0UL, cluster_->prioritySet().hostSetsPerPriority()[0]->hosts().size());
+
+  EXPECT_CALL(membership_updated_, ready());
+  post_cb();
+  ASSERT_EQ(2UL, cluster_->prioritySet().hostSetsPerPriority()[0]->hosts().size());
+  EXPECT_EQ(host1, cluster_->prioritySet().hostSetsPerPriority()[0]->hosts()[0]);
+  EXPECT_EQ(host2, cluster_->prioritySet().hostSetsPerPriority()[0]->hosts()[1]);
+}
+
+// A host which is cleaned up before the main thread adds it to the host set is never added.
+TEST_F(OriginalDstClusterTest, HostCleanedUpBeforeAdded) {
+  std::string json = R"EOF(
+  {
+    "name": "name",
+    "connect_timeout_ms": 1250,
+    "type": "original_dst",
+    "lb_type": "original_dst_lb"
+  }
+  )EOF";
+
+  EXPECT_CALL(initialized_, ready());
+  EXPECT_CALL(*cleanup_timer_, enableTimer(_));
+  setupFromJson(json);
+
+  NiceMock<Network::MockConnection> connection;
+  TestLoadBalancerContext lb_context(&connection);
+  connection.local_address_ = std::make_shared<Network::Address::Ipv4Instance>("10.10.11.11");
+  EXPECT_CALL(connection, localAddressRestored()).WillRepeatedly(Return(true));
+
+  OriginalDstCluster::LoadBalancer lb(cluster_->prioritySet(), cluster_,
+                                      cluster_->info()->lbOriginalDstConfig());
+  Event::PostCb post_cb;
+  EXPECT_CALL(dispatcher_, post(_)).WillOnce(SaveArg<0>(&post_cb));
+  HostConstSharedPtr host = lb.chooseHost(&lb_context);
+  ASSERT_NE(host, nullptr);
+
+  EXPECT_CALL(*cleanup_timer_, enableTimer(_)).Times(2);
+  cleanup_timer_->callback_();
+  cleanup_timer_->callback_();
+
+  EXPECT_CALL(membership_updated_, ready()).Times(0);
+  post_cb();
+  EXPECT_EQ(0UL, cluster_->prioritySet().hostSetsPerPriority()[0]->hosts().size());
+}
+
 TEST_F(OriginalDstClusterTest, UseHttpHeaderEnabled) {
   std::string yaml = R"EOF(
     name: "name"
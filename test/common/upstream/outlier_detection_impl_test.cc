@@ -6,6 +6,7 @@
 
 #include "envoy/common/time.h"
 
+#include "common/common/hash.h"
 #include "common/network/utility.h"
 #include "common/upstream/outlier_detection_impl.h"
 #include "common/upstream/upstream_impl.h"
@@ -89,6 +90,12 @@ public:
     }
   }
 
+  void loadResponseTime(HostSharedPtr host, int num_rq, std::chrono::milliseconds response_time) {
+    for (int i = 0; i < num_rq; i++) {
+      host->outlierDetector().putResponseTime(response_time);
+    }
+  }
+
   NiceMock<MockCluster> cluster_;
   HostVector& hosts_ = cluster_.prioritySet().getMockHostSet(0)->hosts_;
   HostVector& failover_hosts_ = cluster_.prioritySet().getMockHostSet(1)->hosts_;
@@ -134,6 +141,24 @@ TEST_F(OutlierDetectorImplTest, DetectorStaticConfig) {
   EXPECT_EQ(50UL, detector->config().successRateMinimumHosts());
   EXPECT_EQ(200UL, detector->config().successRateRequestVolume());
   EXPECT_EQ(3000UL, detector->config().successRateStdevFactor());
+  EXPECT_FALSE(detector->config().staggerInterval());
+  EXPECT_EQ(1900UL, detector->config().latencyStdevFactor());
+  EXPECT_EQ(0UL, detector->config().enforcingLatency());
+}
+
+TEST_F(OutlierDetectorImplTest, StaggerInterval) {
+  envoy::api::v2::cluster::OutlierDetection outlier_detection;
+  outlier_detection.set_stagger_interval(true);
+
+  // Only the first sweep is delayed by the cluster's offset.
+  const uint64_t offset_ms = HashUtil::xxHash64(cluster_.info_->name()) % 10000;
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000 + offset_ms)));
+  std::shared_ptr<DetectorImpl> detector(DetectorImpl::create(
+      cluster_, outlier_detection, dispatcher_, runtime_, time_source_, event_logger_));
+
+  EXPECT_CALL(time_source_, monotonicTime());
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000)));
+  interval_timer_->callback_();
 }
 
 TEST_F(OutlierDetectorImplTest, DestroyWithActive) {
@@ -541,6 +566,59 @@ TEST_F(OutlierDetectorImplTest, BasicFlowSuccessRate) {
   EXPECT_EQ(-1, detector->successRateEjectionThreshold());
 }
 
+TEST_F(OutlierDetectorImplTest, BasicFlowLatency) {
+  EXPECT_CALL(cluster_.prioritySet(), addMemberUpdateCb(_));
+  addHosts({
+      "tcp://127.0.0.1:80",
+      "tcp://127.0.0.1:81",
+      "tcp://127.0.0.1:82",
+      "tcp://127.0.0.1:83",
+      "tcp://127.0.0.1:84",
+  });
+
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000)));
+  std::shared_ptr<DetectorImpl> detector(DetectorImpl::create(
+      cluster_, empty_outlier_detection_, dispatcher_, runtime_, time_source_, event_logger_));
+  detector->addChangedStateCb([&](HostSharedPtr host) -> void { checker_.check(host); });
+  ON_CALL(runtime_.snapshot_, featureEnabled("outlier_detection.enforcing_latency", 0))
+      .WillByDefault(Return(true));
+
+  // All hosts succeed, but one of them is much slower than the others.
+  loadRq(hosts_, 100, 200);
+  for (size_t i = 0; i < 4; i++) {
+    loadResponseTime(hosts_[i], 100, std::chrono::milliseconds(10));
+  }
+  loadResponseTime(hosts_[4], 100, std::chrono::milliseconds(60));
+
+  EXPECT_CALL(time_source_, monotonicTime())
+      .Times(2)
+      .WillRepeatedly(Return(MonotonicTime(std::chrono::milliseconds(10000))));
+  EXPECT_CALL(checker_, check(hosts_[4]));
+  EXPECT_CALL(*event_logger_, logEject(std::static_pointer_cast<const HostDescription>(hosts_[4]),
+                                       _, EjectionType::Latency, true));
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000)));
+  interval_timer_->callback_();
+  EXPECT_TRUE(hosts_[4]->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK));
+  EXPECT_EQ(100, hosts_[4]->outlierDetector().successRate());
+  EXPECT_EQ(1UL, cluster_.info_->stats_store_.gauge("outlier_detection.ejections_active").value());
+  EXPECT_EQ(1UL,
+            cluster_.info_->stats_store_.counter("outlier_detection.ejections_detected_latency")
+                .value());
+  EXPECT_EQ(1UL,
+            cluster_.info_->stats_store_.counter("outlier_detection.ejections_enforced_latency")
+                .value());
+
+  // Not enough response times in the next interval to detect latency outliers.
+  loadResponseTime(hosts_[0], 99, std::chrono::milliseconds(100));
+  EXPECT_CALL(time_source_, monotonicTime())
+      .WillOnce(Return(MonotonicTime(std::chrono::milliseconds(20000))));
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000)));
+  interval_timer_->callback_();
+  EXPECT_EQ(1UL,
+            cluster_.info_->stats_store_.counter("outlier_detection.ejections_detected_latency")
+                .value());
+}
+
 TEST_F(OutlierDetectorImplTest, RemoveWhileEjected) {
   EXPECT_CALL(cluster_.prioritySet(), addMemberUpdateCb(_));
   addHosts({"tcp://127.0.0.1:80"});
@@ -819,16 +897,19 @@ TEST(OutlierDetectionEventLoggerImplTest, All) {
 }
 
 TEST(OutlierUtility, SRThreshold) {
-  std::vector<HostSuccessRatePair> data = {
-      HostSuccessRatePair(nullptr, 50),  HostSuccessRatePair(nullptr, 100),
-      HostSuccessRatePair(nullptr, 100), HostSuccessRatePair(nullptr, 100),
-      HostSuccessRatePair(nullptr, 100),
-  };
-  double sum = 450;
-
-  Utility::EjectionPair ejection_pair = Utility::successRateEjectionThreshold(sum, data, 1.9);
+  std::vector<double> data = {50, 100, 100, 100, 100};
+
+  Utility::EjectionPair ejection_pair = Utility::successRateEjectionThreshold(data, 1.9);
   EXPECT_EQ(52.0, ejection_pair.ejection_threshold_);
-  EXPECT_EQ(90.0, ejection_pair.success_rate_average_);
+  EXPECT_EQ(90.0, ejection_pair.average_);
+}
+
+TEST(OutlierUtility, LatencyThreshold) {
+  std::vector<double> data = {10, 10, 10, 10, 60};
+
+  Utility::EjectionPair ejection_pair = Utility::latencyEjectionThreshold(data, 1.9);
+  EXPECT_EQ(58.0, ejection_pair.ejection_threshold_);
+  EXPECT_EQ(20.0, ejection_pair.average_);
 }
 
 TEST(DetectorHostMonitorImpl, resultToHttpCode) {
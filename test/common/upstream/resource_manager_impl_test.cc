@@ -1,3 +1,4 @@
+#include "common/stats/isolated_store_impl.h"
 #include "common/upstream/resource_manager_impl.h"
 
 #include "test/mocks/runtime/mocks.h"
@@ -47,5 +48,100 @@ TEST(ResourceManagerImplTest, RuntimeResourceManager) {
   EXPECT_FALSE(resource_manager.retries().canCreate());
 }
 
+// With lease_percent set, resources are leased from the shared count in batches, and released
+// ones are kept by the shard of the releasing thread until a whole lease of them can be returned.
+TEST(ResourceManagerImplTest, LeasedResources) {
+  NiceMock<Runtime::MockLoader> runtime;
+  ResourceManagerImpl resource_manager(runtime, "circuit_breakers.lease_test.default.", 0, 0, 32,
+                                       0);
+  // Leases of 32 * 100% / 16 shards = 2 requests.
+  ON_CALL(runtime.snapshot_, getInteger("circuit_breakers.lease_test.default.lease_percent", 0))
+      .WillByDefault(Return(100U));
+  Resource& requests = resource_manager.requests();
+
+  for (uint32_t i = 0; i < 32; i++) {
+    EXPECT_TRUE(requests.canCreate());
+    requests.inc();
+  }
+  EXPECT_FALSE(requests.canCreate());
+
+  // The released request is kept by this thread, which can create it again.
+  requests.dec();
+  EXPECT_TRUE(requests.canCreate());
+  requests.inc();
+  EXPECT_FALSE(requests.canCreate());
+
+  // A whole lease of released requests goes back to the shared count.
+  requests.dec();
+  requests.dec();
+  EXPECT_TRUE(requests.canCreate());
+  requests.inc();
+  requests.inc();
+  EXPECT_FALSE(requests.canCreate());
+
+  for (uint32_t i = 0; i < 32; i++) {
+    requests.dec();
+  }
+  EXPECT_TRUE(requests.canCreate());
+}
+
+// By default the count is exact, and nothing is kept for reuse.
+TEST(ResourceManagerImplTest, ExactResources) {
+  NiceMock<Runtime::MockLoader> runtime;
+  ResourceManagerImpl resource_manager(runtime, "circuit_breakers.exact_test.default.", 0, 0, 0,
+                                       2);
+  Resource& retries = resource_manager.retries();
+
+  retries.inc();
+  retries.inc();
+  EXPECT_FALSE(retries.canCreate());
+  retries.dec();
+  EXPECT_TRUE(retries.canCreate());
+  retries.dec();
+}
+
+// A retry budget bounds the retries by the active and pending requests, with a minimum, instead of
+// by the retries maximum.
+TEST(ResourceManagerImplTest, RetryBudget) {
+  NiceMock<Runtime::MockLoader> runtime;
+  Stats::IsolatedStoreImpl store;
+  Stats::Counter& exhausted = store.counter("retry_budget_exhausted");
+  ResourceManagerImpl resource_manager(runtime, "circuit_breakers.retry_budget_test.default.", 100,
+                                       100, 100, 0,
+                                       ResourceManagerImpl::RetryBudget{25.0, 1, exhausted});
+  Resource& retries = resource_manager.retries();
+
+  // With no requests, the minimum concurrency applies.
+  EXPECT_EQ(1U, retries.max());
+  EXPECT_TRUE(retries.canCreate());
+  retries.inc();
+  EXPECT_FALSE(retries.canCreate());
+  EXPECT_EQ(1U, exhausted.value());
+
+  // 25% of 4 pending and 8 active requests.
+  for (uint32_t i = 0; i < 4; i++) {
+    resource_manager.pendingRequests().inc();
+  }
+  for (uint32_t i = 0; i < 8; i++) {
+    resource_manager.requests().inc();
+  }
+  EXPECT_EQ(3U, retries.max());
+  retries.inc();
+  retries.inc();
+  EXPECT_FALSE(retries.canCreate());
+  EXPECT_EQ(2U, exhausted.value());
+
+  for (uint32_t i = 0; i < 4; i++) {
+    resource_manager.pendingRequests().dec();
+  }
+  for (uint32_t i = 0; i < 8; i++) {
+    resource_manager.requests().dec();
+  }
+  for (uint32_t i = 0; i < 3; i++) {
+    retries.dec();
+  }
+  EXPECT_TRUE(retries.canCreate());
+}
+
 } // namespace Upstream
 } // namespace Envoy
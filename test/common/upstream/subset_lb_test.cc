@@ -14,6 +14,7 @@
 
 #include "test/common/upstream/utility.h"
 #include "test/mocks/access_log/mocks.h"
+#include "test/mocks/common.h"
 #include "test/mocks/filesystem/mocks.h"
 #include "test/mocks/runtime/mocks.h"
 #include "test/mocks/upstream/mocks.h"
@@ -70,6 +71,7 @@ public:
 
       matches_.emplace_back(
           std::make_shared<const TestMetadataMatchCriterion>(it.first, HashedValue(v)));
+      hash_ = matches_.back()->value().hashWithName(it.first, hash_);
     }
   }
 
@@ -78,6 +80,8 @@ public:
     return matches_;
   }
 
+  uint64_t hash() const override { return hash_; }
+
   Router::MetadataMatchCriteriaConstPtr
   mergeMatchCriteria(const ProtobufWkt::Struct&) const override {
     return nullptr;
@@ -85,6 +89,7 @@ public:
 
 private:
   std::vector<Router::MetadataMatchCriterionConstSharedPtr> matches_;
+  uint64_t hash_{};
 };
 
 class TestLoadBalancerContext : public LoadBalancerContextBase {
@@ -174,7 +179,9 @@ public:
     }
 
     lb_.reset(new SubsetLoadBalancer(lb_type_, priority_set_, nullptr, stats_, runtime_, random_,
-                                     subset_info_, ring_hash_lb_config_, common_config_));
+                                     subset_info_, ring_hash_lb_config_, maglev_lb_config_,
+                                     bounded_load_ring_hash_lb_config_, least_request_lb_config_,
+                                     common_config_, time_source_));
   }
 
   void zoneAwareInit(const std::vector<HostURLMetadataMap>& host_metadata_per_locality,
@@ -218,7 +225,8 @@ public:
 
     lb_.reset(new SubsetLoadBalancer(lb_type_, priority_set_, &local_priority_set_, stats_,
                                      runtime_, random_, subset_info_, ring_hash_lb_config_,
-                                     common_config_));
+                                     maglev_lb_config_, bounded_load_ring_hash_lb_config_,
+                                     least_request_lb_config_, common_config_, time_source_));
   }
 
   HostSharedPtr makeHost(const std::string& url, const HostMetadata& metadata) {
@@ -373,9 +381,13 @@ public:
   NiceMock<MockLoadBalancerSubsetInfo> subset_info_;
   std::shared_ptr<MockClusterInfo> info_{new NiceMock<MockClusterInfo>()};
   envoy::api::v2::Cluster::RingHashLbConfig ring_hash_lb_config_;
+  envoy::api::v2::Cluster::MaglevLbConfig maglev_lb_config_;
+  envoy::api::v2::Cluster::BoundedLoadRingHashLbConfig bounded_load_ring_hash_lb_config_;
+  envoy::api::v2::Cluster::LeastRequestLbConfig least_request_lb_config_;
   envoy::api::v2::Cluster::CommonLbConfig common_config_;
   NiceMock<Runtime::MockLoader> runtime_;
   NiceMock<Runtime::MockRandomGenerator> random_;
+  NiceMock<MockTimeSource> time_source_;
   Stats::IsolatedStoreImpl stats_store_;
   ClusterStats stats_;
   PrioritySetImpl local_priority_set_;
@@ -992,7 +1004,9 @@ TEST_F(SubsetLoadBalancerTest, IgnoresHostsWithoutMetadata) {
   host_set_.healthy_hosts_per_locality_ = host_set_.hosts_per_locality_;
 
   lb_.reset(new SubsetLoadBalancer(lb_type_, priority_set_, nullptr, stats_, runtime_, random_,
-                                   subset_info_, ring_hash_lb_config_, common_config_));
+                                   subset_info_, ring_hash_lb_config_, maglev_lb_config_,
+                                   bounded_load_ring_hash_lb_config_, least_request_lb_config_,
+                                   common_config_, time_source_));
 
   TestLoadBalancerContext context_version({{"version", "1.0"}});
 
@@ -1000,7 +1014,7 @@ TEST_F(SubsetLoadBalancerTest, IgnoresHostsWithoutMetadata) {
   EXPECT_EQ(host_set_.hosts_[1], lb_->chooseHost(&context_version));
 }
 
-// TODO(mattklein123): The following 4 tests verify basic functionality with all sub-LB tests.
+// TODO(mattklein123): The following tests verify basic functionality with all sub-LB tests.
 // Optimally these would also be some type of TEST_P, but that is a little bit complicated as
 // modifyHosts() also needs params. Clean this up.
 TEST_P(SubsetLoadBalancerTest, LoadBalancerTypesRoundRobin) {
@@ -1019,6 +1033,14 @@ TEST_P(SubsetLoadBalancerTest, LoadBalancerTypesRingHash) {
 
 TEST_P(SubsetLoadBalancerTest, LoadBalancerTypesMaglev) { doLbTypeTest(LoadBalancerType::Maglev); }
 
+TEST_P(SubsetLoadBalancerTest, LoadBalancerTypesBoundedLoadRingHash) {
+  doLbTypeTest(LoadBalancerType::BoundedLoadRingHash);
+}
+
+TEST_P(SubsetLoadBalancerTest, LoadBalancerTypesPeakEwma) {
+  doLbTypeTest(LoadBalancerType::PeakEwma);
+}
+
 TEST_F(SubsetLoadBalancerTest, ZoneAwareFallback) {
   EXPECT_CALL(subset_info_, fallbackPolicy())
       .WillRepeatedly(Return(envoy::api::v2::Cluster::LbSubsetConfig::ANY_ENDPOINT));
@@ -1396,7 +1418,9 @@ TEST_F(SubsetLoadBalancerTest, DisabledLocalityWeightAwareness) {
       host_set_, {1, 100});
 
   lb_.reset(new SubsetLoadBalancer(lb_type_, priority_set_, nullptr, stats_, runtime_, random_,
-                                   subset_info_, ring_hash_lb_config_, common_config_));
+                                   subset_info_, ring_hash_lb_config_, maglev_lb_config_,
+                                   bounded_load_ring_hash_lb_config_, least_request_lb_config_,
+                                   common_config_, time_source_));
 
   TestLoadBalancerContext context({{"version", "1.1"}});
 
@@ -1424,7 +1448,9 @@ TEST_F(SubsetLoadBalancerTest, EnabledLocalityWeightAwareness) {
       host_set_, {1, 100});
 
   lb_.reset(new SubsetLoadBalancer(lb_type_, priority_set_, nullptr, stats_, runtime_, random_,
-                                   subset_info_, ring_hash_lb_config_, common_config_));
+                                   subset_info_, ring_hash_lb_config_, maglev_lb_config_,
+                                   bounded_load_ring_hash_lb_config_, least_request_lb_config_,
+                                   common_config_, time_source_));
 
   TestLoadBalancerContext context({{"version", "1.1"}});
 
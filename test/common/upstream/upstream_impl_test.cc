@@ -445,6 +445,10 @@ TEST(StrictDnsClusterImplTest, LoadAssignmentBasic) {
         max_retries: 4
 
     max_requests_per_connection: 3
+    max_concurrent_streams_per_connection: 100
+    prefetch_policy:
+      per_upstream_prefetch_ratio: 1.5
+      min_connections_per_host: 2
 
     http2_protocol_options:
       hpack_table_size: 0
@@ -497,6 +501,9 @@ TEST(StrictDnsClusterImplTest, LoadAssignmentBasic) {
   EXPECT_CALL(runtime.snapshot_, getInteger("circuit_breakers.name.high.max_retries", 4));
   EXPECT_EQ(4U, cluster.info()->resourceManager(ResourcePriority::High).retries().max());
   EXPECT_EQ(3U, cluster.info()->maxRequestsPerConnection());
+  EXPECT_EQ(100U, cluster.info()->maxConcurrentStreamsPerConnection());
+  EXPECT_EQ(1.5, cluster.info()->prefetchRatio());
+  EXPECT_EQ(2U, cluster.info()->prefetchMinConnections());
   EXPECT_EQ(0U, cluster.info()->http2Settings().hpack_table_size_);
 
   cluster.info()->stats().upstream_rq_total_.inc();
@@ -760,6 +767,38 @@ TEST(HostImplTest, HostnameCanaryAndLocality) {
   EXPECT_EQ("world", host.locality().sub_zone());
 }
 
+// Validate that hosts share their locality with the other hosts of the cluster in the locality,
+// and share empty metadata.
+TEST(HostImplTest, SharedLocalityAndMetadata) {
+  MockCluster cluster;
+  envoy::api::v2::core::Locality locality;
+  locality.set_zone("hello");
+  HostImpl host1(cluster.info_, "", Network::Utility::resolveUrl("tcp://10.0.0.1:1234"),
+                 envoy::api::v2::core::Metadata::default_instance(), 1, locality,
+                 envoy::api::v2::endpoint::Endpoint::HealthCheckConfig::default_instance());
+  HostImpl host2(cluster.info_, "", Network::Utility::resolveUrl("tcp://10.0.0.2:1234"),
+                 envoy::api::v2::core::Metadata::default_instance(), 1, locality,
+                 envoy::api::v2::endpoint::Endpoint::HealthCheckConfig::default_instance());
+  EXPECT_EQ(&host1.locality(), &host2.locality());
+  EXPECT_EQ("hello", host2.locality().zone());
+  EXPECT_EQ(host1.metadata(), host2.metadata());
+
+  envoy::api::v2::core::Metadata metadata;
+  Config::Metadata::mutableMetadataValue(metadata, "foo", "bar").set_string_value("baz");
+  host2.metadata(metadata);
+  EXPECT_NE(host1.metadata(), host2.metadata());
+  EXPECT_EQ("baz", Config::Metadata::metadataValue(*host2.metadata(), "foo", "bar").string_value());
+  host2.metadata(envoy::api::v2::core::Metadata::default_instance());
+  EXPECT_EQ(host1.metadata(), host2.metadata());
+
+  host1.stats().rq_total_.inc();
+  const std::vector<Stats::CounterSharedPtr> counters = host1.counters();
+  EXPECT_EQ(1, std::count_if(counters.begin(), counters.end(),
+                             [](const Stats::CounterSharedPtr& counter) {
+                               return counter->name() == "rq_total" && counter->value() == 1;
+                             }));
+}
+
 TEST(StaticClusterImplTest, InitialHosts) {
   Stats::IsolatedStoreImpl stats;
   Ssl::MockContextManager ssl_context_manager;
@@ -1233,6 +1272,9 @@ TEST(StaticClusterImplTest, UrlConfig) {
   EXPECT_EQ(1024U, cluster.info()->resourceManager(ResourcePriority::High).requests().max());
   EXPECT_EQ(3U, cluster.info()->resourceManager(ResourcePriority::High).retries().max());
   EXPECT_EQ(0U, cluster.info()->maxRequestsPerConnection());
+  EXPECT_EQ(0U, cluster.info()->maxConcurrentStreamsPerConnection());
+  EXPECT_EQ(1.0, cluster.info()->prefetchRatio());
+  EXPECT_EQ(0U, cluster.info()->prefetchMinConnections());
   EXPECT_EQ(Http::Http2Settings::DEFAULT_HPACK_TABLE_SIZE,
             cluster.info()->http2Settings().hpack_table_size_);
   EXPECT_EQ(LoadBalancerType::Random, cluster.info()->lbType());
@@ -1531,6 +1573,105 @@ TEST_F(ClusterInfoImplTest, Metadata) {
   EXPECT_EQ(LoadBalancerType::Maglev, cluster->info()->lbType());
 }
 
+// The Maglev table size must be prime.
+TEST_F(ClusterInfoImplTest, MaglevTableSize) {
+  const std::string yaml = R"EOF(
+    name: name
+    connect_timeout: 0.25s
+    type: STRICT_DNS
+    lb_policy: MAGLEV
+    hosts: [{ socket_address: { address: foo.bar.com, port_value: 443 }}]
+    maglev_lb_config: { table_size: 131071 }
+  )EOF";
+
+  auto cluster = makeCluster(yaml);
+  EXPECT_EQ(131071, cluster->info()->lbMaglevConfig()->table_size().value());
+
+  const std::string bad_yaml = R"EOF(
+    name: name
+    connect_timeout: 0.25s
+    type: STRICT_DNS
+    lb_policy: MAGLEV
+    hosts: [{ socket_address: { address: foo.bar.com, port_value: 443 }}]
+    maglev_lb_config: { table_size: 131072 }
+  )EOF";
+
+  EXPECT_THROW_WITH_MESSAGE(makeCluster(bad_yaml), EnvoyException,
+                            "cluster: Maglev table size 131072 is not a prime number");
+}
+
+TEST_F(ClusterInfoImplTest, BoundedLoadRingHashConfig) {
+  const std::string yaml = R"EOF(
+    name: name
+    connect_timeout: 0.25s
+    type: STRICT_DNS
+    lb_policy: BOUNDED_LOAD_RING_HASH
+    hosts: [{ socket_address: { address: foo.bar.com, port_value: 443 }}]
+    bounded_load_ring_hash_lb_config: { balance_factor: 150 }
+  )EOF";
+
+  auto cluster = makeCluster(yaml);
+  EXPECT_EQ(LoadBalancerType::BoundedLoadRingHash, cluster->info()->lbType());
+  EXPECT_EQ(150, cluster->info()->lbBoundedLoadRingHashConfig()->balance_factor().value());
+}
+
+TEST_F(ClusterInfoImplTest, PeakEwmaConfig) {
+  const std::string yaml = R"EOF(
+    name: name
+    connect_timeout: 0.25s
+    type: STRICT_DNS
+    lb_policy: PEAK_EWMA
+    hosts: [{ socket_address: { address: foo.bar.com, port_value: 443 }}]
+    peak_ewma_lb_config: { decay_time: 5s }
+  )EOF";
+
+  auto cluster = makeCluster(yaml);
+  EXPECT_EQ(LoadBalancerType::PeakEwma, cluster->info()->lbType());
+  EXPECT_EQ(5, cluster->info()->lbPeakEwmaConfig()->decay_time().seconds());
+}
+
+// A retry budget takes the place of the retries maximum of its priority only.
+TEST_F(ClusterInfoImplTest, RetryBudget) {
+  const std::string yaml = R"EOF(
+    name: name
+    connect_timeout: 0.25s
+    type: STRICT_DNS
+    lb_policy: ROUND_ROBIN
+    hosts: [{ socket_address: { address: foo.bar.com, port_value: 443 }}]
+    circuit_breakers:
+      thresholds:
+      - priority: DEFAULT
+        max_retries: 10
+        retry_budget:
+          budget_percent: { value: 50 }
+          min_retry_concurrency: 2
+      - priority: HIGH
+        max_retries: 4
+  )EOF";
+
+  auto cluster = makeCluster(yaml);
+  ResourceManager& resource_manager = cluster->info()->resourceManager(ResourcePriority::Default);
+  EXPECT_EQ(2U, resource_manager.retries().max());
+  for (uint32_t i = 0; i < 6; i++) {
+    resource_manager.requests().inc();
+  }
+  EXPECT_EQ(3U, resource_manager.retries().max());
+  for (uint32_t i = 0; i < 3; i++) {
+    resource_manager.retries().inc();
+  }
+  EXPECT_FALSE(resource_manager.retries().canCreate());
+  EXPECT_EQ(1UL, stats_.counter("cluster.name.upstream_rq_retry_budget_exhausted").value());
+  for (uint32_t i = 0; i < 3; i++) {
+    resource_manager.retries().dec();
+  }
+  for (uint32_t i = 0; i < 6; i++) {
+    resource_manager.requests().dec();
+  }
+
+  EXPECT_CALL(runtime_.snapshot_, getInteger("circuit_breakers.name.high.max_retries", 4));
+  EXPECT_EQ(4U, cluster->info()->resourceManager(ResourcePriority::High).retries().max());
+}
+
 // Cluster extension protocol options fails validation when configured for an unregistered filter.
 TEST_F(ClusterInfoImplTest, ExtensionProtocolOptionsForUnknownFilter) {
   const std::string yaml = R"EOF(
@@ -1897,8 +2038,10 @@ TEST_F(HostSetImplLocalityTest, UnhealthyFailover) {
 
   setHealthyHostCount(5);
   expectPicks(33, 67);
+  // The effective weight of locality 0 is capped by the overprovisioning factor, so the schedule
+  // is unchanged and carries on from the last pick.
   setHealthyHostCount(4);
-  expectPicks(33, 67);
+  expectPicks(34, 66);
   setHealthyHostCount(3);
   expectPicks(29, 71);
   setHealthyHostCount(2);
@@ -0,0 +1,103 @@
+#include <string>
+#include <vector>
+
+#include "envoy/data/accesslog/v2/accesslog.pb.h"
+
+#include "common/http/header_map_impl.h"
+#include "common/protobuf/protobuf.h"
+
+#include "extensions/access_loggers/binary_file/binary_file_access_log_impl.h"
+
+#include "test/mocks/access_log/mocks.h"
+#include "test/mocks/request_info/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using namespace std::chrono_literals;
+using testing::_;
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace BinaryFile {
+
+class BinaryFileAccessLogTest : public testing::Test {
+public:
+  BinaryFileAccessLogTest() {
+    config_.set_path("/dev/null");
+    config_.add_additional_request_headers_to_log("x-custom-request");
+    config_.add_additional_response_headers_to_log("x-custom-response");
+    ON_CALL(*log_manager_.file_, write(_)).WillByDefault(Invoke([this](absl::string_view data) {
+      written_.append(data.data(), data.size());
+    }));
+  }
+
+  // Parses the length delimited entries written to the file.
+  std::vector<envoy::data::accesslog::v2::HTTPAccessLogEntry> writtenEntries() {
+    std::vector<envoy::data::accesslog::v2::HTTPAccessLogEntry> entries;
+    Protobuf::io::ArrayInputStream stream(written_.data(), written_.size());
+    envoy::data::accesslog::v2::HTTPAccessLogEntry entry;
+    bool clean_eof = false;
+    while (ProtobufUtil::ParseDelimitedFromZeroCopyStream(&entry, &stream, &clean_eof)) {
+      entries.push_back(entry);
+    }
+    EXPECT_TRUE(clean_eof);
+    return entries;
+  }
+
+  envoy::config::accesslog::v2::BinaryFileAccessLog config_;
+  NiceMock<AccessLog::MockAccessLogManager> log_manager_;
+  std::string written_;
+};
+
+TEST_F(BinaryFileAccessLogTest, WritesDelimitedEntries) {
+  BinaryFileAccessLog access_log(config_, nullptr, log_manager_);
+
+  NiceMock<RequestInfo::MockRequestInfo> request_info;
+  request_info.host_ = nullptr;
+  request_info.start_time_ = SystemTime(1h);
+  request_info.response_code_ = 200;
+  Http::TestHeaderMapImpl request_headers{{":method", "GET"},
+                                          {":path", "/first"},
+                                          {"x-custom-request", "foo"},
+                                          {"x-other", "bar"}};
+  Http::TestHeaderMapImpl response_headers{{":status", "200"}, {"x-custom-response", "baz"}};
+  access_log.log(&request_headers, &response_headers, nullptr, request_info);
+
+  request_headers.insertPath().value(std::string("/second"));
+  access_log.log(&request_headers, nullptr, nullptr, request_info);
+
+  const auto entries = writtenEntries();
+  ASSERT_EQ(2, entries.size());
+  EXPECT_EQ(3600, entries[0].common_properties().start_time().seconds());
+  EXPECT_EQ(envoy::api::v2::core::RequestMethod::GET, entries[0].request().request_method());
+  EXPECT_EQ("/first", entries[0].request().path());
+  EXPECT_EQ(1, entries[0].request().request_headers().size());
+  EXPECT_EQ("foo", entries[0].request().request_headers().at("x-custom-request"));
+  EXPECT_EQ(200, entries[0].response().response_code().value());
+  EXPECT_EQ("baz", entries[0].response().response_headers().at("x-custom-response"));
+
+  // The entry reused by the thread doesn't keep the fields of the previous log.
+  EXPECT_EQ("/second", entries[1].request().path());
+  EXPECT_EQ(0, entries[1].response().response_headers().size());
+}
+
+TEST_F(BinaryFileAccessLogTest, Filtered) {
+  AccessLog::MockFilter* filter = new NiceMock<AccessLog::MockFilter>();
+  BinaryFileAccessLog access_log(config_, AccessLog::FilterPtr{filter}, log_manager_);
+
+  NiceMock<RequestInfo::MockRequestInfo> request_info;
+  EXPECT_CALL(*filter, evaluate(_, _)).WillOnce(Return(false));
+  EXPECT_CALL(*log_manager_.file_, write(_)).Times(0);
+  access_log.log(nullptr, nullptr, nullptr, request_info);
+}
+
+} // namespace BinaryFile
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,79 @@
+#include "envoy/config/accesslog/v2/binary_file.pb.h"
+#include "envoy/registry/registry.h"
+
+#include "common/access_log/access_log_impl.h"
+
+#include "extensions/access_loggers/binary_file/binary_file_access_log_impl.h"
+#include "extensions/access_loggers/binary_file/config.h"
+#include "extensions/access_loggers/well_known_names.h"
+
+#include "test/mocks/server/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace BinaryFile {
+
+TEST(BinaryFileAccessLogConfigTest, ValidateFail) {
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+
+  EXPECT_THROW(BinaryFileAccessLogFactory().createAccessLogInstance(
+                   envoy::config::accesslog::v2::BinaryFileAccessLog(), nullptr, context),
+               ProtoValidationException);
+}
+
+TEST(BinaryFileAccessLogConfigTest, ConfigureFromProto) {
+  envoy::config::filter::accesslog::v2::AccessLog config;
+
+  envoy::config::accesslog::v2::BinaryFileAccessLog bfal_config;
+  bfal_config.set_path("/dev/null");
+
+  MessageUtil::jsonConvert(bfal_config, *config.mutable_config());
+
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+  EXPECT_THROW_WITH_MESSAGE(AccessLog::AccessLogFactory::fromProto(config, context), EnvoyException,
+                            "Provided name for static registration lookup was empty.");
+
+  config.set_name(AccessLogNames::get().BinaryFile);
+
+  AccessLog::InstanceSharedPtr log = AccessLog::AccessLogFactory::fromProto(config, context);
+
+  EXPECT_NE(nullptr, log);
+  EXPECT_NE(nullptr, dynamic_cast<BinaryFileAccessLog*>(log.get()));
+
+  config.set_name("INVALID");
+
+  EXPECT_THROW_WITH_MESSAGE(AccessLog::AccessLogFactory::fromProto(config, context), EnvoyException,
+                            "Didn't find a registered implementation for name: 'INVALID'");
+}
+
+TEST(BinaryFileAccessLogConfigTest, BinaryFileAccessLogTest) {
+  auto factory =
+      Registry::FactoryRegistry<Server::Configuration::AccessLogInstanceFactory>::getFactory(
+          AccessLogNames::get().BinaryFile);
+  ASSERT_NE(nullptr, factory);
+
+  ProtobufTypes::MessagePtr message = factory->createEmptyConfigProto();
+  ASSERT_NE(nullptr, message);
+
+  envoy::config::accesslog::v2::BinaryFileAccessLog binary_file_access_log;
+  binary_file_access_log.set_path("/dev/null");
+  binary_file_access_log.add_additional_request_headers_to_log("x-request-id");
+  MessageUtil::jsonConvert(binary_file_access_log, *message);
+
+  AccessLog::FilterPtr filter;
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+
+  AccessLog::InstanceSharedPtr instance =
+      factory->createAccessLogInstance(*message, std::move(filter), context);
+  EXPECT_NE(nullptr, instance);
+  EXPECT_NE(nullptr, dynamic_cast<BinaryFileAccessLog*>(instance.get()));
+}
+
+} // namespace BinaryFile
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
@@ -1,8 +1,10 @@
 #include "common/network/address_impl.h"
+#include "common/stats/isolated_store_impl.h"
 
 #include "extensions/access_loggers/http_grpc/grpc_access_log_impl.h"
 
 #include "test/mocks/access_log/mocks.h"
+#include "test/mocks/event/mocks.h"
 #include "test/mocks/grpc/mocks.h"
 #include "test/mocks/local_info/mocks.h"
 #include "test/mocks/request_info/mocks.h"
@@ -61,7 +63,7 @@ TEST_F(GrpcAccessLogStreamerImplTest, BasicFlow) {
   EXPECT_CALL(local_info_, node());
   EXPECT_CALL(stream1, sendMessage(_, false));
   envoy::service::accesslog::v2::StreamAccessLogsMessage message_log1;
-  streamer_->send(message_log1, "log1");
+  EXPECT_TRUE(streamer_->send(message_log1, "log1"));
 
   message_log1.Clear();
   EXPECT_CALL(stream1, sendMessage(_, false));
@@ -100,13 +102,13 @@ TEST_F(GrpcAccessLogStreamerImplTest, StreamFailure) {
           }));
   EXPECT_CALL(local_info_, node());
   envoy::service::accesslog::v2::StreamAccessLogsMessage message_log1;
-  streamer_->send(message_log1, "log1");
+  EXPECT_FALSE(streamer_->send(message_log1, "log1"));
 }
 
 class MockGrpcAccessLogStreamer : public GrpcAccessLogStreamer {
 public:
   // GrpcAccessLogStreamer
-  MOCK_METHOD2(send, void(envoy::service::accesslog::v2::StreamAccessLogsMessage& message,
+  MOCK_METHOD2(send, bool(envoy::service::accesslog::v2::StreamAccessLogsMessage& message,
                           const std::string& log_name));
 };
 
@@ -115,7 +117,12 @@ public:
   void init() {
     ON_CALL(*filter_, evaluate(_, _)).WillByDefault(Return(true));
     config_.mutable_common_config()->set_log_name("hello_log");
-    access_log_.reset(new HttpGrpcAccessLog(AccessLog::FilterPtr{filter_}, config_, streamer_));
+    // Unless a test batches them, the entries are sent as soon as they are logged.
+    if (!config_.common_config().has_buffer_size_bytes()) {
+      config_.mutable_common_config()->mutable_buffer_size_bytes()->set_value(0);
+    }
+    access_log_.reset(new HttpGrpcAccessLog(AccessLog::FilterPtr{filter_}, config_, streamer_,
+                                            tls_, stats_store_));
   }
 
   void expectLog(const std::string& expected_request_msg_yaml) {
@@ -130,15 +137,69 @@ public:
             [expected_request_msg](envoy::service::accesslog::v2::StreamAccessLogsMessage& message,
                                    const std::string&) {
               EXPECT_EQ(message.DebugString(), expected_request_msg.DebugString());
+              return true;
             }));
   }
 
   AccessLog::MockFilter* filter_{new NiceMock<AccessLog::MockFilter>()};
   envoy::config::accesslog::v2::HttpGrpcAccessLogConfig config_;
   std::shared_ptr<MockGrpcAccessLogStreamer> streamer_{new MockGrpcAccessLogStreamer()};
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  Stats::IsolatedStoreImpl stats_store_;
   std::unique_ptr<HttpGrpcAccessLog> access_log_;
 };
 
+// Entries are buffered until their size reaches the limit, and sent in a single message.
+TEST_F(HttpGrpcAccessLogTest, BatchedBySize) {
+  config_.mutable_common_config()->mutable_buffer_size_bytes()->set_value(60);
+  init();
+
+  NiceMock<RequestInfo::MockRequestInfo> request_info;
+  request_info.host_ = nullptr;
+  request_info.start_time_ = SystemTime(1h);
+
+  EXPECT_CALL(*streamer_, send(_, _)).Times(0);
+  access_log_->log(nullptr, nullptr, nullptr, request_info);
+
+  EXPECT_CALL(*streamer_, send(_, "hello_log"))
+      .WillOnce(Invoke([](envoy::service::accesslog::v2::StreamAccessLogsMessage& message,
+                          const std::string&) {
+        EXPECT_EQ(2, message.http_logs().log_entry_size());
+        return true;
+      }));
+  access_log_->log(nullptr, nullptr, nullptr, request_info);
+  EXPECT_EQ(2, stats_store_.counter("access_logs.http_grpc_access_log.logs_written").value());
+}
+
+// Buffered entries are sent by the flush timer, and counted as dropped when they can't be sent.
+TEST_F(HttpGrpcAccessLogTest, FlushedByTimer) {
+  config_.mutable_common_config()->mutable_buffer_size_bytes()->set_value(16384);
+  config_.mutable_common_config()->mutable_buffer_flush_interval()->set_seconds(2);
+  Event::MockTimer* timer = new Event::MockTimer(&tls_.dispatcher_);
+  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(2000)));
+  init();
+
+  NiceMock<RequestInfo::MockRequestInfo> request_info;
+  request_info.host_ = nullptr;
+  access_log_->log(nullptr, nullptr, nullptr, request_info);
+  access_log_->log(nullptr, nullptr, nullptr, request_info);
+
+  EXPECT_CALL(*streamer_, send(_, "hello_log"))
+      .WillOnce(Invoke([](envoy::service::accesslog::v2::StreamAccessLogsMessage& message,
+                          const std::string&) {
+        EXPECT_EQ(2, message.http_logs().log_entry_size());
+        return false;
+      }));
+  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(2000)));
+  timer->callback_();
+  EXPECT_EQ(2, stats_store_.counter("access_logs.http_grpc_access_log.logs_dropped").value());
+
+  // Nothing is sent when no entry is buffered.
+  EXPECT_CALL(*streamer_, send(_, _)).Times(0);
+  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(2000)));
+  timer->callback_();
+}
+
 // Test HTTP log marshalling.
 TEST_F(HttpGrpcAccessLogTest, Marshalling) {
   InSequence s;
@@ -416,7 +477,8 @@ TEST(responseFlagsToAccessLogResponseFlagsTest, All) {
   NiceMock<RequestInfo::MockRequestInfo> request_info;
   ON_CALL(request_info, hasResponseFlag(_)).WillByDefault(Return(true));
   envoy::data::accesslog::v2::AccessLogCommon common_access_log;
-  HttpGrpcAccessLog::responseFlagsToAccessLogResponseFlags(common_access_log, request_info);
+  Common::HttpAccessLogEntryBuilder::responseFlagsToAccessLogResponseFlags(common_access_log,
+                                                                           request_info);
 
   envoy::data::accesslog::v2::AccessLogCommon common_access_log_expected;
   common_access_log_expected.mutable_response_flags()->set_failed_local_healthcheck(true);
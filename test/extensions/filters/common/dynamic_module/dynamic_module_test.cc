@@ -0,0 +1,103 @@
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+
+#include "extensions/filters/common/dynamic_module/dynamic_module.h"
+
+#include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/environment.h"
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Extensions {
+namespace Filters {
+namespace Common {
+namespace DynamicModule {
+namespace {
+
+std::string testModulePath() {
+  return TestEnvironment::runfilesPath(
+      "test/extensions/filters/common/dynamic_module/libtest_module.so");
+}
+
+class TestHostContext : public HostContext {
+public:
+  Http::HeaderMap* headers() override { return &headers_; }
+  Buffer::Instance* data() override { return &data_; }
+
+  Http::TestHeaderMapImpl headers_;
+  Buffer::OwnedImpl data_;
+};
+
+TEST(DynamicModuleTest, LoadError) {
+  NiceMock<ThreadLocal::MockInstance> tls;
+  EXPECT_THROW_WITH_REGEX(Module("/does/not/exist.so", "", tls), EnvoyException,
+                          "unable to load dynamic module /does/not/exist.so");
+}
+
+TEST(DynamicModuleTest, RejectedConfig) {
+  NiceMock<ThreadLocal::MockInstance> tls;
+  EXPECT_THROW_WITH_REGEX(Module(testModulePath(), "reject", tls), EnvoyException,
+                          "rejected its configuration");
+}
+
+// The callbacks which the module doesn't export are null, and each worker has its own context.
+TEST(DynamicModuleTest, Callbacks) {
+  NiceMock<ThreadLocal::MockInstance> tls;
+  Module module(testModulePath(), "config", tls);
+  EXPECT_NE(nullptr, module.callbacks().on_http_request_headers_);
+  EXPECT_NE(nullptr, module.callbacks().on_network_read_);
+  EXPECT_EQ(nullptr, module.callbacks().on_http_response_data_);
+  EXPECT_EQ(nullptr, module.callbacks().on_network_write_);
+  EXPECT_NE(nullptr, module.workerContext());
+}
+
+// The host API gives the module the headers and the data without copying them.
+TEST(DynamicModuleTest, HostApi) {
+  const envoy_dynamic_module_host_api& host_api = Library::hostApi();
+  TestHostContext context;
+  context.headers_.addCopy("x-foo", "bar");
+  context.data_.add("hello");
+
+  envoy_dynamic_module_buffer value;
+  EXPECT_EQ(0, host_api.get_header(context.handle(), "x-missing", 9, &value));
+  EXPECT_EQ(1, host_api.get_header(context.handle(), "X-Foo", 5, &value));
+  EXPECT_EQ(context.headers_.get(Http::LowerCaseString("x-foo"))->value().c_str(), value.data);
+  EXPECT_EQ("bar", std::string(value.data, value.length));
+
+  host_api.set_header(context.handle(), "x-foo", 5, "baz", 3);
+  EXPECT_EQ("baz", context.headers_.get_("x-foo"));
+  host_api.remove_header(context.handle(), "x-foo", 5);
+  EXPECT_FALSE(context.headers_.has("x-foo"));
+
+  envoy_dynamic_module_buffer slices[1];
+  ASSERT_EQ(1, host_api.get_data_slices(context.handle(), slices, 1));
+  Buffer::RawSlice raw_slice;
+  context.data_.getRawSlices(&raw_slice, 1);
+  EXPECT_EQ(raw_slice.mem_, slices[0].data);
+  EXPECT_EQ("hello", std::string(slices[0].data, slices[0].length));
+}
+
+// The contexts without headers or data don't give any to the module.
+TEST(DynamicModuleTest, HostApiWithoutHeadersOrData) {
+  const envoy_dynamic_module_host_api& host_api = Library::hostApi();
+  HostContext context;
+  envoy_dynamic_module_buffer value;
+  EXPECT_EQ(0, host_api.get_header(context.handle(), "x-foo", 5, &value));
+  host_api.set_header(context.handle(), "x-foo", 5, "bar", 3);
+  host_api.remove_header(context.handle(), "x-foo", 5);
+  EXPECT_EQ(0, host_api.get_data_slices(context.handle(), &value, 1));
+  host_api.send_local_reply(context.handle(), 403, "", 0);
+  host_api.close_connection(context.handle());
+}
+
+} // namespace
+} // namespace DynamicModule
+} // namespace Common
+} // namespace Filters
+} // namespace Extensions
+} // namespace Envoy
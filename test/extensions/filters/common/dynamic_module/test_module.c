@@ -0,0 +1,120 @@
+// Module used by the tests of the dynamic module filters:
+// - The configuration "reject" is rejected.
+// - The requests with a x-deny header are denied with a 403.
+// - The request headers get a x-module-config header with the configuration of the module.
+// - The response headers get a x-request-bytes header with the bytes of the request data.
+// - The connections whose read data starts with "close" are closed.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "extensions/filters/common/dynamic_module/abi.h"
+
+typedef struct {
+  const envoy_dynamic_module_host_api* host_api;
+  char* config;
+  size_t config_length;
+} module_context;
+
+typedef struct {
+  module_context* module;
+} worker_context;
+
+typedef struct {
+  worker_context* worker;
+  size_t bytes;
+} stream_context;
+
+static size_t data_length(const envoy_dynamic_module_host_api* host_api, void* host) {
+  envoy_dynamic_module_buffer slices[16];
+  const size_t num_slices = host_api->get_data_slices(host, slices, 16);
+  size_t length = 0;
+  for (size_t i = 0; i < num_slices && i < 16; i++) {
+    length += slices[i].length;
+  }
+  return length;
+}
+
+uint32_t envoy_dynamic_module_abi_version(void) { return ENVOY_DYNAMIC_MODULE_ABI_VERSION; }
+
+void* envoy_dynamic_module_on_init(const char* config, size_t config_length,
+                                   const envoy_dynamic_module_host_api* host_api) {
+  if (config_length == strlen("reject") && memcmp(config, "reject", config_length) == 0) {
+    return NULL;
+  }
+  module_context* module = malloc(sizeof(module_context));
+  module->host_api = host_api;
+  module->config = malloc(config_length);
+  memcpy(module->config, config, config_length);
+  module->config_length = config_length;
+  return module;
+}
+
+void envoy_dynamic_module_on_destroy(void* module) {
+  free(((module_context*)module)->config);
+  free(module);
+}
+
+void* envoy_dynamic_module_on_worker_init(void* module) {
+  worker_context* worker = malloc(sizeof(worker_context));
+  worker->module = module;
+  return worker;
+}
+
+void envoy_dynamic_module_on_worker_destroy(void* worker) { free(worker); }
+
+static void* create_stream(void* worker) {
+  stream_context* stream = malloc(sizeof(stream_context));
+  stream->worker = worker;
+  stream->bytes = 0;
+  return stream;
+}
+
+void* envoy_dynamic_module_on_http_stream_create(void* worker) { return create_stream(worker); }
+
+void envoy_dynamic_module_on_http_stream_destroy(void* stream) { free(stream); }
+
+void envoy_dynamic_module_on_http_request_headers(void* stream, void* host, int end_stream) {
+  (void)end_stream;
+  const module_context* module = ((stream_context*)stream)->worker->module;
+  envoy_dynamic_module_buffer value;
+  if (module->host_api->get_header(host, "x-deny", strlen("x-deny"), &value)) {
+    module->host_api->send_local_reply(host, 403, "denied", strlen("denied"));
+    return;
+  }
+  module->host_api->set_header(host, "x-module-config", strlen("x-module-config"),
+                               module->config, module->config_length);
+}
+
+void envoy_dynamic_module_on_http_request_data(void* stream, void* host, int end_stream) {
+  (void)end_stream;
+  stream_context* context = stream;
+  context->bytes += data_length(context->worker->module->host_api, host);
+}
+
+void envoy_dynamic_module_on_http_response_headers(void* stream, void* host, int end_stream) {
+  (void)end_stream;
+  const stream_context* context = stream;
+  char bytes[32];
+  const int length = snprintf(bytes, sizeof(bytes), "%zu", context->bytes);
+  context->worker->module->host_api->set_header(host, "x-request-bytes",
+                                                strlen("x-request-bytes"), bytes, length);
+}
+
+void* envoy_dynamic_module_on_network_connection_create(void* worker) {
+  return create_stream(worker);
+}
+
+void envoy_dynamic_module_on_network_connection_destroy(void* connection) { free(connection); }
+
+void envoy_dynamic_module_on_network_read(void* connection, void* host, int end_stream) {
+  (void)end_stream;
+  const envoy_dynamic_module_host_api* host_api =
+      ((stream_context*)connection)->worker->module->host_api;
+  envoy_dynamic_module_buffer slice;
+  if (host_api->get_data_slices(host, &slice, 1) > 0 && slice.length >= strlen("close") &&
+      memcmp(slice.data, "close", strlen("close")) == 0) {
+    host_api->close_connection(host);
+  }
+}
@@ -61,7 +61,8 @@ TEST_F(CheckRequestUtilsTest, BasicHttp) {
   EXPECT_CALL(callbacks_, requestInfo()).Times(3).WillRepeatedly(ReturnRef(req_info_));
   EXPECT_CALL(req_info_, protocol()).Times(2).WillRepeatedly(ReturnPointee(&protocol_));
 
-  CheckRequestUtils::createHttpCheck(&callbacks_, headers, request);
+  CheckRequestUtils::createHttpCheck(&callbacks_, headers, Http::LowerCaseStrUnorderedSet(),
+                                     request);
 }
 
 // Verify that createHttpCheck extract the proper attributes from the http request into CheckRequest
@@ -80,11 +81,39 @@ TEST_F(CheckRequestUtilsTest, CheckAttrContextPeer) {
   EXPECT_CALL(ssl_, uriSanPeerCertificate()).WillOnce(Return("source"));
   EXPECT_CALL(ssl_, uriSanLocalCertificate()).WillOnce(Return("destination"));
 
-  CheckRequestUtils::createHttpCheck(&callbacks_, request_headers, request);
+  CheckRequestUtils::createHttpCheck(&callbacks_, request_headers,
+                                     Http::LowerCaseStrUnorderedSet(), request);
 
   EXPECT_EQ("source", request.attributes().source().principal());
   EXPECT_EQ("destination", request.attributes().destination().principal());
   EXPECT_EQ("foo", request.attributes().source().service());
+  EXPECT_EQ(2, request.attributes().request().http().headers().size());
+}
+
+// Verify that createHttpCheck only copies the allowed headers into the CheckRequest, while the
+// path is still set.
+TEST_F(CheckRequestUtilsTest, AllowedHeaders) {
+  Http::TestHeaderMapImpl request_headers{
+      {":path", "/bar"}, {"cookie", "large"}, {"authorization", "Bearer foo"}};
+  envoy::service::auth::v2alpha::CheckRequest request;
+  EXPECT_CALL(callbacks_, connection()).WillRepeatedly(Return(&connection_));
+  EXPECT_CALL(connection_, remoteAddress()).WillRepeatedly(ReturnRef(addr_));
+  EXPECT_CALL(connection_, localAddress()).WillRepeatedly(ReturnRef(addr_));
+  EXPECT_CALL(Const(connection_), ssl()).WillRepeatedly(Return(nullptr));
+  EXPECT_CALL(callbacks_, streamId()).WillRepeatedly(Return(0));
+  EXPECT_CALL(callbacks_, requestInfo()).WillRepeatedly(ReturnRef(req_info_));
+  EXPECT_CALL(req_info_, protocol()).WillRepeatedly(ReturnPointee(&protocol_));
+
+  CheckRequestUtils::createHttpCheck(
+      &callbacks_, request_headers,
+      Http::LowerCaseStrUnorderedSet{Http::LowerCaseString("authorization"),
+                                     Http::LowerCaseString("x-missing")},
+      request);
+
+  const auto& http = request.attributes().request().http();
+  EXPECT_EQ("/bar", http.path());
+  EXPECT_EQ(1, http.headers().size());
+  EXPECT_EQ("Bearer foo", http.headers().at("authorization"));
 }
 
 } // namespace ExtAuthz
@@ -0,0 +1,85 @@
+#include <chrono>
+
+#include "extensions/filters/common/local_ratelimit/local_ratelimit.h"
+
+#include "test/mocks/common.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::ReturnPointee;
+
+namespace Envoy {
+namespace Extensions {
+namespace Filters {
+namespace Common {
+namespace LocalRateLimit {
+namespace {
+
+class SharedTokenBucketTest : public testing::Test {
+public:
+  SharedTokenBucketTest() {
+    ON_CALL(time_source_, monotonicTime()).WillByDefault(ReturnPointee(&now_));
+  }
+
+  SharedTokenBucketPtr makeBucket(const std::string& yaml) {
+    envoy::type::TokenBucket config;
+    MessageUtil::loadFromYaml(yaml, config);
+    return std::make_unique<SharedTokenBucket>(config, time_source_);
+  }
+
+  MonotonicTime now_{std::chrono::seconds(100)};
+  NiceMock<MockTimeSource> time_source_;
+};
+
+TEST_F(SharedTokenBucketTest, Consume) {
+  SharedTokenBucketPtr bucket = makeBucket(R"EOF(
+  max_tokens: 2
+  fill_interval: 1s
+  )EOF");
+
+  EXPECT_TRUE(bucket->consume());
+  EXPECT_TRUE(bucket->consume());
+  EXPECT_FALSE(bucket->consume());
+
+  now_ += std::chrono::milliseconds(500);
+  EXPECT_FALSE(bucket->consume());
+
+  now_ += std::chrono::milliseconds(500);
+  EXPECT_TRUE(bucket->consume());
+  EXPECT_FALSE(bucket->consume());
+}
+
+TEST_F(SharedTokenBucketTest, TokensPerFill) {
+  SharedTokenBucketPtr bucket = makeBucket(R"EOF(
+  max_tokens: 10
+  tokens_per_fill: 5
+  fill_interval: 10s
+  )EOF");
+
+  for (int i = 0; i < 10; i++) {
+    EXPECT_TRUE(bucket->consume());
+  }
+  EXPECT_FALSE(bucket->consume());
+
+  // Tokens are added continuously, at the rate of 5 per 10 seconds.
+  now_ += std::chrono::seconds(2);
+  EXPECT_TRUE(bucket->consume());
+  EXPECT_FALSE(bucket->consume());
+
+  // The bucket holds at most max_tokens.
+  now_ += std::chrono::seconds(60);
+  for (int i = 0; i < 10; i++) {
+    EXPECT_TRUE(bucket->consume());
+  }
+  EXPECT_FALSE(bucket->consume());
+}
+
+} // namespace
+} // namespace LocalRateLimit
+} // namespace Common
+} // namespace Filters
+} // namespace Extensions
+} // namespace Envoy
@@ -152,6 +152,66 @@ TEST_F(LuaTest, MarkDead) {
   lua_gc(cr1->luaState(), LUA_GCCOLLECT, 0);
 }
 
+// Coroutines which finished are reused once released, unlike the ones which failed or yielded.
+TEST_F(LuaTest, CoroutineReuse) {
+  const std::string SCRIPT{R"EOF(
+    function callMe(object)
+      object:testCall()
+    end
+
+    function yieldMe()
+      coroutine.yield()
+    end
+
+    function failMe()
+      error("failed")
+    end
+  )EOF"};
+
+  InSequence s;
+  setup(SCRIPT);
+  EXPECT_NE(LUA_REFNIL, state_->getGlobalRef(state_->registerGlobal("callMe")));
+  EXPECT_NE(LUA_REFNIL, state_->getGlobalRef(state_->registerGlobal("yieldMe")));
+  EXPECT_NE(LUA_REFNIL, state_->getGlobalRef(state_->registerGlobal("failMe")));
+
+  CoroutinePtr cr1(state_->createCoroutine());
+  lua_State* lua_state = cr1->luaState();
+  TestObject* object1 = TestObject::create(lua_state).first;
+  EXPECT_CALL(*object1, doTestCall(_));
+  cr1->start(state_->getGlobalRef(0), 1, yield_callback_);
+  EXPECT_TRUE(cr1->reusable());
+  state_->releaseCoroutine(std::move(cr1));
+
+  // The object left on the stack is no longer referenced once the coroutine is released.
+  EXPECT_CALL(*object1, onDestroy());
+  lua_gc(lua_state, LUA_GCCOLLECT, 0);
+
+  CoroutinePtr cr2(state_->createCoroutine());
+  EXPECT_EQ(lua_state, cr2->luaState());
+  EXPECT_EQ(cr2->state(), Coroutine::State::NotStarted);
+  LuaRef<TestObject> ref2(TestObject::create(cr2->luaState()), true);
+  EXPECT_CALL(*ref2.get(), doTestCall(_));
+  cr2->start(state_->getGlobalRef(0), 1, yield_callback_);
+  EXPECT_EQ(cr2->state(), Coroutine::State::Finished);
+  EXPECT_CALL(*ref2.get(), onDestroy());
+  ref2.reset();
+
+  EXPECT_CALL(on_yield_, ready());
+  cr2->reset();
+  cr2->start(state_->getGlobalRef(1), 0, yield_callback_);
+  EXPECT_FALSE(cr2->reusable());
+  state_->releaseCoroutine(std::move(cr2));
+  CoroutinePtr cr3(state_->createCoroutine());
+  EXPECT_NE(lua_state, cr3->luaState());
+
+  EXPECT_THROW(cr3->start(state_->getGlobalRef(2), 0, yield_callback_), LuaException);
+  EXPECT_FALSE(cr3->reusable());
+  lua_State* failed_state = cr3->luaState();
+  state_->releaseCoroutine(std::move(cr3));
+  CoroutinePtr cr4(state_->createCoroutine());
+  EXPECT_NE(failed_state, cr4->luaState());
+}
+
 } // namespace Lua
 } // namespace Common
 } // namespace Filters
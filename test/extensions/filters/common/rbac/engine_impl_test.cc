@@ -1,15 +1,18 @@
+#include "common/network/address_impl.h"
 #include "common/network/utility.h"
 
 #include "extensions/filters/common/rbac/engine_impl.h"
 
 #include "test/mocks/network/mocks.h"
 #include "test/mocks/ssl/mocks.h"
+#include "test/test_common/utility.h"
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
 using testing::_;
 using testing::Const;
+using testing::NiceMock;
 using testing::Return;
 using testing::ReturnRef;
 
@@ -79,6 +82,98 @@ TEST(RoleBasedAccessControlEngineImpl, DeniedBlacklist) {
   checkEngine(engine, true, conn);
 }
 
+// Policies indexed by source IP are evaluated in the order of their names.
+TEST(RoleBasedAccessControlEngineImpl, SourceIpPolicies) {
+  envoy::config::rbac::v2alpha::RBAC rbac;
+  rbac.set_action(envoy::config::rbac::v2alpha::RBAC_Action::RBAC_Action_ALLOW);
+  {
+    envoy::config::rbac::v2alpha::Policy policy;
+    policy.add_permissions()->set_any(true);
+    auto* range = policy.add_principals()->mutable_source_ip();
+    range->set_address_prefix("10.1.0.0");
+    range->mutable_prefix_len()->set_value(16);
+    (*rbac.mutable_policies())["b"] = policy;
+    range->set_address_prefix("10.0.0.0");
+    range->mutable_prefix_len()->set_value(8);
+    (*rbac.mutable_policies())["c"] = policy;
+    range->set_address_prefix("192.168.0.0");
+    (*rbac.mutable_policies())["a"] = policy;
+  }
+  RBAC::RoleBasedAccessControlEngineImpl engine(rbac);
+
+  NiceMock<Envoy::Network::MockConnection> conn;
+  std::string policy_id;
+  conn.remote_address_ = Envoy::Network::Utility::parseInternetAddress("10.1.2.3", 123, false);
+  checkEngine(engine, true, conn, Envoy::Http::TestHeaderMapImpl(),
+              envoy::api::v2::core::Metadata(), &policy_id);
+  EXPECT_EQ("b", policy_id);
+
+  conn.remote_address_ = Envoy::Network::Utility::parseInternetAddress("10.2.2.3", 123, false);
+  checkEngine(engine, true, conn, Envoy::Http::TestHeaderMapImpl(),
+              envoy::api::v2::core::Metadata(), &policy_id);
+  EXPECT_EQ("c", policy_id);
+
+  conn.remote_address_ = Envoy::Network::Utility::parseInternetAddress("11.1.2.3", 123, false);
+  checkEngine(engine, false, conn);
+
+  conn.remote_address_ = std::make_shared<Envoy::Network::Address::PipeInstance>("/foo");
+  checkEngine(engine, false, conn);
+}
+
+// Policies indexed by exact header values are evaluated along with the ones which can't be
+// indexed, in the order of their names.
+TEST(RoleBasedAccessControlEngineImpl, HeaderPolicies) {
+  envoy::config::rbac::v2alpha::RBAC rbac;
+  rbac.set_action(envoy::config::rbac::v2alpha::RBAC_Action::RBAC_Action_ALLOW);
+  {
+    envoy::config::rbac::v2alpha::Policy policy;
+    policy.add_principals()->set_any(true);
+    auto* header = policy.add_permissions()->mutable_header();
+    header->set_name(":path");
+    header->set_exact_match("/foo");
+    header = policy.add_permissions()->mutable_header();
+    header->set_name(":path");
+    header->set_exact_match("/bar");
+    (*rbac.mutable_policies())["b"] = policy;
+  }
+  {
+    envoy::config::rbac::v2alpha::Policy policy;
+    policy.add_principals()->set_any(true);
+    auto* header = policy.add_permissions()->mutable_header();
+    header->set_name(":path");
+    header->set_prefix_match("/ba");
+    (*rbac.mutable_policies())["a"] = policy;
+  }
+  {
+    envoy::config::rbac::v2alpha::Policy policy;
+    policy.add_permissions()->set_any(true);
+    auto* header = policy.add_principals()->mutable_header();
+    header->set_name("x-user");
+    header->set_exact_match("baz");
+    (*rbac.mutable_policies())["d"] = policy;
+  }
+  RBAC::RoleBasedAccessControlEngineImpl engine(rbac);
+
+  Envoy::Network::MockConnection conn;
+  std::string policy_id;
+  checkEngine(engine, true, conn, Envoy::Http::TestHeaderMapImpl{{":path", "/foo"}},
+              envoy::api::v2::core::Metadata(), &policy_id);
+  EXPECT_EQ("b", policy_id);
+
+  checkEngine(engine, true, conn, Envoy::Http::TestHeaderMapImpl{{":path", "/bar"}},
+              envoy::api::v2::core::Metadata(), &policy_id);
+  EXPECT_EQ("a", policy_id);
+
+  checkEngine(engine, true, conn,
+              Envoy::Http::TestHeaderMapImpl{{":path", "/qux"}, {"x-user", "baz"}},
+              envoy::api::v2::core::Metadata(), &policy_id);
+  EXPECT_EQ("d", policy_id);
+
+  checkEngine(engine, false, conn,
+              Envoy::Http::TestHeaderMapImpl{{":path", "/qux"}, {"x-user", "qux"}});
+  checkEngine(engine, false, conn);
+}
+
 } // namespace
 } // namespace RBAC
 } // namespace Common
@@ -0,0 +1,131 @@
+#include <chrono>
+
+#include "common/stats/isolated_store_impl.h"
+
+#include "extensions/filters/http/adaptive_concurrency/adaptive_concurrency_filter.h"
+
+#include "test/mocks/common.h"
+#include "test/mocks/http/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::NiceMock;
+using testing::Return;
+using testing::ReturnPointee;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace AdaptiveConcurrency {
+namespace {
+
+class AdaptiveConcurrencyFilterTest : public testing::Test {
+public:
+  AdaptiveConcurrencyFilterTest() {
+    ON_CALL(time_source_, monotonicTime()).WillByDefault(ReturnPointee(&now_));
+    envoy::config::filter::http::adaptive_concurrency::v2alpha::AdaptiveConcurrency proto_config;
+    MessageUtil::loadFromYaml(R"EOF(
+gradient_controller_config:
+  min_samples: 1
+  min_concurrency_limit: 1
+)EOF",
+                              proto_config);
+    config_ = std::make_shared<AdaptiveConcurrencyFilterConfig>(proto_config, "test.", store_,
+                                                                time_source_);
+  }
+
+  std::unique_ptr<AdaptiveConcurrencyFilter> createFilter() {
+    std::unique_ptr<AdaptiveConcurrencyFilter> filter(new AdaptiveConcurrencyFilter(config_));
+    filter->setDecoderFilterCallbacks(decoder_callbacks_);
+    filter->setEncoderFilterCallbacks(encoder_callbacks_);
+    return filter;
+  }
+
+  MonotonicTime now_{std::chrono::hours(1)};
+  NiceMock<MockTimeSource> time_source_;
+  Stats::IsolatedStoreImpl store_;
+  AdaptiveConcurrencyFilterConfigSharedPtr config_;
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> decoder_callbacks_;
+  NiceMock<Http::MockStreamEncoderFilterCallbacks> encoder_callbacks_;
+  Http::TestHeaderMapImpl request_headers_{{":path", "/"}};
+  Http::TestHeaderMapImpl response_headers_{{":status", "200"}};
+};
+
+TEST_F(AdaptiveConcurrencyFilterTest, NoRoute) {
+  EXPECT_CALL(decoder_callbacks_, route()).WillOnce(Return(nullptr));
+  std::unique_ptr<AdaptiveConcurrencyFilter> filter = createFilter();
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter->decodeHeaders(request_headers_, true));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter->encodeHeaders(response_headers_, true));
+  filter->onDestroy();
+}
+
+TEST_F(AdaptiveConcurrencyFilterTest, BlockAboveLimit) {
+  std::unique_ptr<AdaptiveConcurrencyFilter> first = createFilter();
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, first->decodeHeaders(request_headers_, true));
+
+  std::unique_ptr<AdaptiveConcurrencyFilter> second = createFilter();
+  EXPECT_CALL(decoder_callbacks_.request_info_,
+              setResponseFlag(RequestInfo::ResponseFlag::UpstreamOverflow));
+  Http::TestHeaderMapImpl expected_headers{{":status", "503"},
+                                           {"content-length", "25"},
+                                           {"content-type", "text/plain"}};
+  EXPECT_CALL(decoder_callbacks_, encodeHeaders_(HeaderMapEqualRef(&expected_headers), false));
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
+            second->decodeHeaders(request_headers_, true));
+  second->onDestroy();
+  EXPECT_EQ(1, store_.counter("test.adaptive_concurrency.fake_cluster.rq_blocked").value());
+
+  // Once the first request completes, the next one is admitted.
+  first->onDestroy();
+  std::unique_ptr<AdaptiveConcurrencyFilter> third = createFilter();
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, third->decodeHeaders(request_headers_, true));
+  third->onDestroy();
+}
+
+TEST_F(AdaptiveConcurrencyFilterTest, SampleLatency) {
+  std::unique_ptr<AdaptiveConcurrencyFilter> filter = createFilter();
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter->decodeHeaders(request_headers_, true));
+  now_ += std::chrono::milliseconds(100);
+  decoder_callbacks_.request_info_.first_upstream_rx_byte_received_ =
+      std::chrono::milliseconds(10);
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter->encodeHeaders(response_headers_, true));
+  filter->onDestroy();
+
+  EXPECT_EQ(10, store_.gauge("test.adaptive_concurrency.fake_cluster.sample_rtt_msecs").value());
+  // 1 + sqrt(1).
+  EXPECT_EQ(2, store_.gauge("test.adaptive_concurrency.fake_cluster.concurrency_limit").value());
+}
+
+TEST_F(AdaptiveConcurrencyFilterTest, SampleTimeout) {
+  std::unique_ptr<AdaptiveConcurrencyFilter> filter = createFilter();
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter->decodeHeaders(request_headers_, true));
+  decoder_callbacks_.request_info_.start_time_monotonic_ = now_;
+  now_ += std::chrono::milliseconds(150);
+  EXPECT_CALL(decoder_callbacks_.request_info_,
+              hasResponseFlag(RequestInfo::ResponseFlag::UpstreamRequestTimeout))
+      .WillOnce(Return(true));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter->encodeHeaders(response_headers_, true));
+  filter->onDestroy();
+
+  EXPECT_EQ(150, store_.gauge("test.adaptive_concurrency.fake_cluster.sample_rtt_msecs").value());
+}
+
+// Validate that local replies that aren't timeouts aren't sampled.
+TEST_F(AdaptiveConcurrencyFilterTest, NoUpstreamResponse) {
+  std::unique_ptr<AdaptiveConcurrencyFilter> filter = createFilter();
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter->decodeHeaders(request_headers_, true));
+  now_ += std::chrono::milliseconds(100);
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter->encodeHeaders(response_headers_, true));
+  filter->onDestroy();
+
+  EXPECT_EQ(1, store_.gauge("test.adaptive_concurrency.fake_cluster.concurrency_limit").value());
+}
+
+} // namespace
+} // namespace AdaptiveConcurrency
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
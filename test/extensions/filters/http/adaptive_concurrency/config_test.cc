@@ -0,0 +1,43 @@
+#include "extensions/filters/http/adaptive_concurrency/config.h"
+
+#include "test/mocks/server/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace AdaptiveConcurrency {
+
+TEST(AdaptiveConcurrencyFilterConfigTest, AdaptiveConcurrencyFilter) {
+  const std::string yaml = R"EOF(
+gradient_controller_config:
+  concurrency_update_interval: 0.1s
+  max_concurrency_limit: 100
+)EOF";
+
+  envoy::config::filter::http::adaptive_concurrency::v2alpha::AdaptiveConcurrency proto_config;
+  MessageUtil::loadFromYaml(yaml, proto_config);
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+  AdaptiveConcurrencyFilterFactory factory;
+  Http::FilterFactoryCb cb = factory.createFilterFactoryFromProto(proto_config, "stats", context);
+  Http::MockFilterChainFactoryCallbacks filter_callback;
+  EXPECT_CALL(filter_callback, addStreamFilter(_));
+  cb(filter_callback);
+}
+
+TEST(AdaptiveConcurrencyFilterConfigTest, MissingController) {
+  envoy::config::filter::http::adaptive_concurrency::v2alpha::AdaptiveConcurrency proto_config;
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+  AdaptiveConcurrencyFilterFactory factory;
+  EXPECT_THROW(factory.createFilterFactoryFromProto(proto_config, "stats", context),
+               ProtoValidationException);
+}
+
+} // namespace AdaptiveConcurrency
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,167 @@
+#include <chrono>
+
+#include "common/stats/isolated_store_impl.h"
+
+#include "extensions/filters/http/adaptive_concurrency/gradient_controller.h"
+
+#include "test/mocks/common.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::ReturnPointee;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace AdaptiveConcurrency {
+namespace {
+
+class GradientControllerTest : public testing::Test {
+public:
+  GradientControllerTest() {
+    ON_CALL(time_source_, monotonicTime()).WillByDefault(ReturnPointee(&now_));
+  }
+
+  void initialize(const std::string& yaml) {
+    envoy::config::filter::http::adaptive_concurrency::v2alpha::AdaptiveConcurrency::
+        GradientControllerConfig proto_config;
+    MessageUtil::loadFromYaml(yaml, proto_config);
+    config_ = std::make_unique<GradientControllerConfig>(proto_config);
+    controller_ = std::make_unique<GradientController>(
+        *config_, time_source_,
+        AdaptiveConcurrencyStats{ALL_ADAPTIVE_CONCURRENCY_STATS(
+            POOL_COUNTER_PREFIX(store_, "test."), POOL_GAUGE_PREFIX(store_, "test."))});
+  }
+
+  // Sample one round trip time per update interval.
+  void sample(std::chrono::milliseconds rtt, uint32_t updates) {
+    for (uint32_t i = 0; i < updates; i++) {
+      now_ += std::chrono::milliseconds(100);
+      controller_->recordLatency(rtt);
+    }
+  }
+
+  MonotonicTime now_{std::chrono::hours(1)};
+  NiceMock<MockTimeSource> time_source_;
+  Stats::IsolatedStoreImpl store_;
+  std::unique_ptr<GradientControllerConfig> config_;
+  std::unique_ptr<GradientController> controller_;
+};
+
+TEST_F(GradientControllerTest, Defaults) {
+  initialize("{}");
+  EXPECT_EQ(0.5, config_->sampleAggregatePercentile());
+  EXPECT_EQ(std::chrono::milliseconds(100), config_->concurrencyUpdateInterval());
+  EXPECT_EQ(10, config_->minSamples());
+  EXPECT_EQ(3, config_->minConcurrencyLimit());
+  EXPECT_EQ(1000, config_->maxConcurrencyLimit());
+  EXPECT_EQ(std::chrono::milliseconds(60000), config_->minRttCalcInterval());
+  EXPECT_EQ(0.25, config_->sampleRttBuffer());
+  EXPECT_EQ(3, controller_->concurrencyLimit());
+  EXPECT_EQ(3, store_.gauge("test.concurrency_limit").value());
+}
+
+TEST_F(GradientControllerTest, BlockAboveLimit) {
+  initialize("{}");
+  EXPECT_TRUE(controller_->tryAcquire());
+  EXPECT_TRUE(controller_->tryAcquire());
+  EXPECT_TRUE(controller_->tryAcquire());
+  EXPECT_FALSE(controller_->tryAcquire());
+  EXPECT_EQ(1, store_.counter("test.rq_blocked").value());
+
+  controller_->release();
+  EXPECT_TRUE(controller_->tryAcquire());
+  EXPECT_EQ(1, store_.counter("test.rq_blocked").value());
+}
+
+// Validate that the limit is only updated once enough samples were taken over an update interval.
+TEST_F(GradientControllerTest, UpdateInterval) {
+  initialize("min_samples: 2");
+  controller_->recordLatency(std::chrono::milliseconds(10));
+  controller_->recordLatency(std::chrono::milliseconds(10));
+  EXPECT_EQ(3, controller_->concurrencyLimit());
+
+  now_ += std::chrono::milliseconds(100);
+  EXPECT_EQ(3, controller_->concurrencyLimit());
+  controller_->recordLatency(std::chrono::milliseconds(10));
+  // 3 + sqrt(3).
+  EXPECT_EQ(5, controller_->concurrencyLimit());
+  EXPECT_EQ(10, store_.gauge("test.min_rtt_msecs").value());
+  EXPECT_EQ(10, store_.gauge("test.sample_rtt_msecs").value());
+
+  // The samples were consumed by the update.
+  now_ += std::chrono::milliseconds(100);
+  controller_->recordLatency(std::chrono::milliseconds(10));
+  EXPECT_EQ(5, controller_->concurrencyLimit());
+}
+
+TEST_F(GradientControllerTest, GrowAndShrink) {
+  initialize(R"EOF(
+min_samples: 1
+max_concurrency_limit: 100
+)EOF");
+
+  // The limit grows while requests take no longer than the minimum plus the buffer.
+  sample(std::chrono::milliseconds(10), 1);
+  EXPECT_EQ(5, controller_->concurrencyLimit());
+  sample(std::chrono::milliseconds(12), 1);
+  EXPECT_EQ(7, controller_->concurrencyLimit());
+  sample(std::chrono::milliseconds(10), 100);
+  EXPECT_EQ(100, controller_->concurrencyLimit());
+
+  // 100 * 25 / 40 + 10.
+  sample(std::chrono::milliseconds(20), 1);
+  EXPECT_EQ(73, controller_->concurrencyLimit());
+  // The limit shrinks by at most half per update.
+  sample(std::chrono::milliseconds(1000), 1);
+  EXPECT_EQ(45, controller_->concurrencyLimit());
+  // Until the limit settles where halving it is offset by its square root.
+  sample(std::chrono::milliseconds(1000), 100);
+  EXPECT_EQ(4, controller_->concurrencyLimit());
+  EXPECT_EQ(1000, store_.gauge("test.sample_rtt_msecs").value());
+  EXPECT_EQ(10, store_.gauge("test.min_rtt_msecs").value());
+}
+
+TEST_F(GradientControllerTest, SampleAggregatePercentile) {
+  initialize(R"EOF(
+min_samples: 4
+sample_aggregate_percentile:
+  value: 75
+)EOF");
+  now_ += std::chrono::milliseconds(100);
+  controller_->recordLatency(std::chrono::milliseconds(40));
+  controller_->recordLatency(std::chrono::milliseconds(10));
+  controller_->recordLatency(std::chrono::milliseconds(30));
+  controller_->recordLatency(std::chrono::milliseconds(20));
+  EXPECT_EQ(40, store_.gauge("test.sample_rtt_msecs").value());
+}
+
+// Validate that the minimum round trip time follows the latency of the cluster over two periods.
+TEST_F(GradientControllerTest, MinRttPeriods) {
+  initialize(R"EOF(
+min_samples: 1
+min_rtt_calc_interval: 1s
+)EOF");
+
+  sample(std::chrono::milliseconds(10), 1);
+  EXPECT_EQ(10, store_.gauge("test.min_rtt_msecs").value());
+
+  // The previous period still has the smallest round trip time.
+  sample(std::chrono::milliseconds(50), 10);
+  EXPECT_EQ(10, store_.gauge("test.min_rtt_msecs").value());
+  sample(std::chrono::milliseconds(50), 8);
+  EXPECT_EQ(10, store_.gauge("test.min_rtt_msecs").value());
+
+  // Two periods later, the minimum reflects the new latency.
+  sample(std::chrono::milliseconds(50), 1);
+  EXPECT_EQ(50, store_.gauge("test.min_rtt_msecs").value());
+}
+
+} // namespace
+} // namespace AdaptiveConcurrency
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
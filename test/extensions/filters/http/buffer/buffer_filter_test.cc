@@ -67,6 +67,7 @@ TEST_F(BufferFilterTest, HeaderOnlyRequest) {
 TEST_F(BufferFilterTest, RequestWithData) {
   InSequence s;
 
+  EXPECT_CALL(callbacks_, setDecoderBufferSpillThreshold(_, _)).Times(0);
   expectTimerCreate();
 
   Http::TestHeaderMapImpl headers;
@@ -136,6 +137,25 @@ TEST_F(BufferFilterTest, RouteConfigOverride) {
   filter_.onDestroy();
 }
 
+TEST_F(BufferFilterTest, RouteConfigSpillThreshold) {
+  envoy::config::filter::http::buffer::v2::BufferPerRoute route_cfg;
+  auto* buf = route_cfg.mutable_buffer();
+  buf->mutable_max_request_bytes()->set_value(1024 * 1024 * 1024);
+  buf->mutable_max_request_time()->set_seconds(456);
+  buf->mutable_spill_threshold_bytes()->set_value(65536);
+  BufferFilterSettings route_settings(route_cfg);
+  routeLocalConfig(&route_settings, nullptr);
+
+  EXPECT_CALL(callbacks_, setDecoderBufferLimit(1024ULL * 1024 * 1024));
+  EXPECT_CALL(callbacks_, setDecoderBufferSpillThreshold(65536, "/tmp"));
+  expectTimerCreate();
+
+  Http::TestHeaderMapImpl headers;
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration, filter_.decodeHeaders(headers, false));
+
+  filter_.onDestroy();
+}
+
 TEST_F(BufferFilterTest, VHostConfigOverride) {
   envoy::config::filter::http::buffer::v2::BufferPerRoute vhost_cfg;
   auto* buf = vhost_cfg.mutable_buffer();
@@ -0,0 +1,261 @@
+#include <memory>
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/stats/isolated_store_impl.h"
+
+#include "extensions/filters/http/cache/cache_filter.h"
+
+#include "test/mocks/common.h"
+#include "test/mocks/http/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::Invoke;
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+namespace {
+
+class CacheFilterTest : public testing::Test {
+public:
+  CacheFilterTest() {
+    ON_CALL(time_source_, monotonicTime()).WillByDefault(Invoke([this]() { return now_; }));
+  }
+
+  void setup(const std::string& yaml = "{}") {
+    envoy::config::filter::http::cache::v2alpha::Cache proto_config;
+    MessageUtil::loadFromYaml(yaml, proto_config);
+    config_ = std::make_shared<CacheFilterConfig>(proto_config, "test.", store_, time_source_);
+  }
+
+  std::unique_ptr<CacheFilter> createFilter() {
+    std::unique_ptr<CacheFilter> filter = std::make_unique<CacheFilter>(config_);
+    filter->setDecoderFilterCallbacks(decoder_callbacks_);
+    return filter;
+  }
+
+  // Send a request that misses the cache, and its response upstream.
+  void populate(Http::HeaderMap& request_headers, Http::HeaderMap& response_headers,
+                const std::string& body) {
+    std::unique_ptr<CacheFilter> filter = createFilter();
+    EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter->decodeHeaders(request_headers, true));
+    EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+              filter->encodeHeaders(response_headers, body.empty()));
+    if (!body.empty()) {
+      Buffer::OwnedImpl data(body);
+      EXPECT_EQ(Http::FilterDataStatus::Continue, filter->encodeData(data, true));
+    }
+    filter->onDestroy();
+  }
+
+  // @return true if the request was served from the cache, with the body it got if any.
+  bool served(Http::HeaderMap& request_headers, std::string* body = nullptr) {
+    std::unique_ptr<CacheFilter> filter = createFilter();
+    EXPECT_CALL(decoder_callbacks_, encodeHeaders_(_, _))
+        .WillRepeatedly(Invoke([this](Http::HeaderMap& headers, bool) {
+          served_headers_ = Http::TestHeaderMapImpl(headers);
+        }));
+    EXPECT_CALL(decoder_callbacks_, encodeData(_, true))
+        .WillRepeatedly(Invoke([body](Buffer::Instance& data, bool) {
+          if (body != nullptr) {
+            *body = data.toString();
+          }
+        }));
+    const bool hit =
+        filter->decodeHeaders(request_headers, true) == Http::FilterHeadersStatus::StopIteration;
+    filter->onDestroy();
+    testing::Mock::VerifyAndClearExpectations(&decoder_callbacks_);
+    return hit;
+  }
+
+  uint64_t counter(const std::string& name) { return store_.counter("test.cache." + name).value(); }
+
+  Stats::IsolatedStoreImpl store_;
+  NiceMock<MockTimeSource> time_source_;
+  MonotonicTime now_;
+  CacheFilterConfigSharedPtr config_;
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> decoder_callbacks_;
+  Http::TestHeaderMapImpl request_headers_{
+      {":method", "GET"}, {":authority", "host"}, {":path", "/foo"}};
+  Http::TestHeaderMapImpl response_headers_{{":status", "200"},
+                                            {"cache-control", "public, max-age=60"}};
+  Http::TestHeaderMapImpl served_headers_;
+};
+
+TEST_F(CacheFilterTest, HitAndExpiry) {
+  setup();
+  EXPECT_FALSE(served(request_headers_));
+  populate(request_headers_, response_headers_, "hello");
+
+  now_ += std::chrono::seconds(10);
+  std::string body;
+  EXPECT_TRUE(served(request_headers_, &body));
+  EXPECT_EQ("hello", body);
+  EXPECT_EQ("200", served_headers_.get_(":status"));
+  EXPECT_EQ("10", served_headers_.get_("age"));
+  EXPECT_EQ(1U, counter("rq_hit"));
+
+  now_ += std::chrono::seconds(50);
+  EXPECT_FALSE(served(request_headers_));
+  EXPECT_EQ(3U, counter("rq_miss"));
+}
+
+// Validate that the age a response had when it was received counts towards its freshness.
+TEST_F(CacheFilterTest, InitialAge) {
+  setup();
+  response_headers_.addCopy("age", "55");
+  populate(request_headers_, response_headers_, "");
+
+  now_ += std::chrono::seconds(1);
+  EXPECT_TRUE(served(request_headers_));
+  EXPECT_EQ("56", served_headers_.get_("age"));
+  now_ += std::chrono::seconds(4);
+  EXPECT_FALSE(served(request_headers_));
+}
+
+TEST_F(CacheFilterTest, SharedMaxAgeOverridesMaxAge) {
+  setup();
+  Http::TestHeaderMapImpl response_headers{{":status", "200"},
+                                           {"cache-control", "max-age=1, s-maxage=60"}};
+  populate(request_headers_, response_headers, "");
+  now_ += std::chrono::seconds(30);
+  EXPECT_TRUE(served(request_headers_));
+}
+
+TEST_F(CacheFilterTest, UncacheableResponses) {
+  setup("{max_body_bytes: 4}");
+  std::vector<Http::TestHeaderMapImpl> responses{
+      {{":status", "200"}},
+      {{":status", "500"}, {"cache-control", "max-age=60"}},
+      {{":status", "200"}, {"cache-control", "no-store, max-age=60"}},
+      {{":status", "200"}, {"cache-control", "no-cache, max-age=60"}},
+      {{":status", "200"}, {"cache-control", "private, max-age=60"}},
+      {{":status", "200"}, {"cache-control", "max-age=0"}},
+      {{":status", "200"}, {"cache-control", "max-age=60"}, {"set-cookie", "a=b"}},
+      {{":status", "200"}, {"cache-control", "max-age=60"}, {"vary", "*"}},
+      {{":status", "200"}, {"cache-control", "max-age=60"}, {"content-length", "5"}},
+  };
+  for (Http::TestHeaderMapImpl& response_headers : responses) {
+    populate(request_headers_, response_headers, "");
+    EXPECT_FALSE(served(request_headers_));
+  }
+
+  // A body larger than the maximum without a content-length.
+  populate(request_headers_, response_headers_, "hello");
+  EXPECT_FALSE(served(request_headers_));
+}
+
+TEST_F(CacheFilterTest, UncacheableRequests) {
+  setup();
+  populate(request_headers_, response_headers_, "");
+
+  Http::TestHeaderMapImpl head_headers{
+      {":method", "HEAD"}, {":authority", "host"}, {":path", "/foo"}};
+  EXPECT_FALSE(served(head_headers));
+  Http::TestHeaderMapImpl authorization_headers{request_headers_};
+  authorization_headers.addCopy("authorization", "secret");
+  EXPECT_FALSE(served(authorization_headers));
+  Http::TestHeaderMapImpl no_store_headers{request_headers_};
+  no_store_headers.addCopy("cache-control", "no-store");
+  EXPECT_FALSE(served(no_store_headers));
+
+  // The request with a body is not served, nor is its response cached.
+  std::unique_ptr<CacheFilter> filter = createFilter();
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter->decodeHeaders(request_headers_, false));
+  EXPECT_EQ(0U, counter("rq_hit"));
+  EXPECT_EQ(1U, counter("rq_miss"));
+}
+
+// Validate that a request with no-cache is sent upstream, and that its response replaces the
+// cached one.
+TEST_F(CacheFilterTest, RequestNoCache) {
+  setup();
+  populate(request_headers_, response_headers_, "old");
+
+  Http::TestHeaderMapImpl no_cache_headers{request_headers_};
+  no_cache_headers.addCopy("cache-control", "no-cache");
+  EXPECT_FALSE(served(no_cache_headers));
+  populate(no_cache_headers, response_headers_, "new");
+
+  std::string body;
+  EXPECT_TRUE(served(request_headers_, &body));
+  EXPECT_EQ("new", body);
+}
+
+TEST_F(CacheFilterTest, Vary) {
+  setup();
+  Http::TestHeaderMapImpl response_headers{
+      {":status", "200"}, {"cache-control", "max-age=60"}, {"vary", "Accept-Encoding"}};
+  Http::TestHeaderMapImpl gzip_headers{request_headers_};
+  gzip_headers.addCopy("accept-encoding", "gzip");
+  populate(gzip_headers, response_headers, "gzipped");
+
+  EXPECT_TRUE(served(gzip_headers));
+  EXPECT_FALSE(served(request_headers_));
+  Http::TestHeaderMapImpl identity_headers{request_headers_};
+  identity_headers.addCopy("accept-encoding", "identity");
+  EXPECT_FALSE(served(identity_headers));
+}
+
+TEST_F(CacheFilterTest, NotModified) {
+  setup();
+  Http::TestHeaderMapImpl response_headers{
+      {":status", "200"}, {"cache-control", "max-age=60"}, {"etag", "\"v1\""}};
+  populate(request_headers_, response_headers, "hello");
+
+  Http::TestHeaderMapImpl if_none_match_headers{request_headers_};
+  if_none_match_headers.addCopy("if-none-match", "W/\"v1\"");
+  std::string body;
+  EXPECT_TRUE(served(if_none_match_headers, &body));
+  EXPECT_EQ("", body);
+  EXPECT_EQ("304", served_headers_.get_(":status"));
+  EXPECT_EQ("\"v1\"", served_headers_.get_("etag"));
+  EXPECT_EQ("max-age=60", served_headers_.get_("cache-control"));
+  EXPECT_EQ(1U, counter("rq_not_modified"));
+
+  Http::TestHeaderMapImpl other_etag_headers{request_headers_};
+  other_etag_headers.addCopy("if-none-match", "\"v2\"");
+  EXPECT_TRUE(served(other_etag_headers, &body));
+  EXPECT_EQ("hello", body);
+  EXPECT_EQ("200", served_headers_.get_(":status"));
+}
+
+// Validate that the body is not sent once encoding the cached headers destroyed the stream.
+TEST_F(CacheFilterTest, DestroyedWhileServing) {
+  setup();
+  populate(request_headers_, response_headers_, "hello");
+
+  std::unique_ptr<CacheFilter> filter = createFilter();
+  EXPECT_CALL(decoder_callbacks_, encodeHeaders_(_, false))
+      .WillOnce(Invoke([&filter](Http::HeaderMap&, bool) { filter->onDestroy(); }));
+  EXPECT_CALL(decoder_callbacks_, encodeData(_, _)).Times(0);
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
+            filter->decodeHeaders(request_headers_, true));
+}
+
+TEST_F(CacheFilterTest, TrailersNotCached) {
+  setup();
+  std::unique_ptr<CacheFilter> filter = createFilter();
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter->decodeHeaders(request_headers_, true));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter->encodeHeaders(response_headers_, false));
+  Buffer::OwnedImpl data("hello");
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter->encodeData(data, false));
+  Http::TestHeaderMapImpl trailers{{"grpc-status", "0"}};
+  EXPECT_EQ(Http::FilterTrailersStatus::Continue, filter->encodeTrailers(trailers));
+  filter->onDestroy();
+
+  EXPECT_FALSE(served(request_headers_));
+}
+
+} // namespace
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,64 @@
+#include "extensions/filters/http/cache/cache_utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::ElementsAre;
+using testing::IsEmpty;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+namespace Utility {
+namespace {
+
+TEST(CacheUtilityTest, ParseCacheControl) {
+  {
+    const CacheControl cache_control = parseCacheControl("");
+    EXPECT_FALSE(cache_control.no_store_);
+    EXPECT_FALSE(cache_control.no_cache_);
+    EXPECT_FALSE(cache_control.private_);
+    EXPECT_FALSE(cache_control.max_age_);
+    EXPECT_FALSE(cache_control.s_maxage_);
+  }
+  {
+    const CacheControl cache_control = parseCacheControl("public, max-age=60, S-MAXAGE=\"120\"");
+    EXPECT_FALSE(cache_control.no_store_);
+    EXPECT_EQ(std::chrono::seconds(60), cache_control.max_age_.value());
+    EXPECT_EQ(std::chrono::seconds(120), cache_control.s_maxage_.value());
+  }
+  {
+    const CacheControl cache_control =
+        parseCacheControl("no-store,no-cache=\"set-cookie\", private ,max-age=soon");
+    EXPECT_TRUE(cache_control.no_store_);
+    EXPECT_TRUE(cache_control.no_cache_);
+    EXPECT_TRUE(cache_control.private_);
+    // An invalid max-age makes the response stale.
+    EXPECT_EQ(std::chrono::seconds(0), cache_control.max_age_.value());
+  }
+}
+
+TEST(CacheUtilityTest, ParseVary) {
+  EXPECT_THAT(parseVary(""), IsEmpty());
+  EXPECT_THAT(parseVary("Accept-Encoding"), ElementsAre("accept-encoding"));
+  EXPECT_THAT(parseVary(" Accept-Encoding ,, User-Agent"),
+              ElementsAre("accept-encoding", "user-agent"));
+  EXPECT_THAT(parseVary("*"), ElementsAre("*"));
+}
+
+TEST(CacheUtilityTest, IfNoneMatch) {
+  EXPECT_TRUE(ifNoneMatch("\"foo\"", "\"foo\""));
+  EXPECT_TRUE(ifNoneMatch(" * ", "\"foo\""));
+  EXPECT_TRUE(ifNoneMatch("\"bar\", W/\"foo\"", "\"foo\""));
+  EXPECT_TRUE(ifNoneMatch("\"foo\"", "W/\"foo\""));
+  EXPECT_FALSE(ifNoneMatch("\"bar\"", "\"foo\""));
+  EXPECT_FALSE(ifNoneMatch("", "\"foo\""));
+}
+
+} // namespace
+} // namespace Utility
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
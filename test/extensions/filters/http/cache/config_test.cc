@@ -0,0 +1,35 @@
+#include "extensions/filters/http/cache/config.h"
+
+#include "test/mocks/server/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+
+TEST(CacheFilterConfigTest, CacheFilter) {
+  const std::string yaml = R"EOF(
+max_size_bytes: 1048576
+max_body_bytes: 65536
+shards: 4
+)EOF";
+
+  envoy::config::filter::http::cache::v2alpha::Cache proto_config;
+  MessageUtil::loadFromYaml(yaml, proto_config);
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+  CacheFilterFactory factory;
+  Http::FilterFactoryCb cb = factory.createFilterFactoryFromProto(proto_config, "stats", context);
+  Http::MockFilterChainFactoryCallbacks filter_callback;
+  EXPECT_CALL(filter_callback, addStreamFilter(_));
+  cb(filter_callback);
+}
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
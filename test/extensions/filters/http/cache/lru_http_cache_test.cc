@@ -0,0 +1,103 @@
+#include <memory>
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/stats/isolated_store_impl.h"
+
+#include "extensions/filters/http/cache/lru_http_cache.h"
+
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+namespace {
+
+class LruHttpCacheTest : public testing::Test {
+public:
+  void setup(uint32_t num_shards, uint64_t max_size_bytes) {
+    cache_ = std::make_unique<LruHttpCache>(
+        num_shards, max_size_bytes,
+        LruHttpCacheStats{ALL_LRU_HTTP_CACHE_STATS(POOL_COUNTER_PREFIX(store_, "cache."),
+                                                   POOL_GAUGE_PREFIX(store_, "cache."))});
+  }
+
+  CachedResponseConstSharedPtr response(const std::string& body) {
+    Buffer::OwnedImpl buffer(body);
+    return std::make_shared<const CachedResponse>(headers_, buffer, MonotonicTime(),
+                                                  std::chrono::seconds(60),
+                                                  CachedResponse::VaryValues());
+  }
+
+  Stats::IsolatedStoreImpl store_;
+  std::unique_ptr<LruHttpCache> cache_;
+  Http::TestHeaderMapImpl headers_{{":status", "200"}};
+};
+
+TEST_F(LruHttpCacheTest, InsertAndLookup) {
+  setup(4, 1024 * 1024);
+  EXPECT_EQ(nullptr, cache_->lookup("a"));
+
+  CachedResponseConstSharedPtr a = response("a");
+  cache_->insert("a", CachedResponseConstSharedPtr(a));
+  EXPECT_EQ(a, cache_->lookup("a"));
+  EXPECT_EQ(nullptr, cache_->lookup("b"));
+
+  // Inserting under the same key replaces the response.
+  CachedResponseConstSharedPtr a2 = response("a2");
+  cache_->insert("a", CachedResponseConstSharedPtr(a2));
+  EXPECT_EQ(a2, cache_->lookup("a"));
+  EXPECT_EQ(2U, store_.counter("cache.insert").value());
+  EXPECT_EQ(1U, store_.gauge("cache.entries").value());
+  EXPECT_EQ(1 + a2->byteSize(), store_.gauge("cache.size_bytes").value());
+}
+
+// Validate that the least recently used responses are evicted first.
+TEST_F(LruHttpCacheTest, Eviction) {
+  const uint64_t entry_size = 1 + response(std::string(100, 'x'))->byteSize();
+  setup(1, 3 * entry_size);
+
+  cache_->insert("a", response(std::string(100, 'a')));
+  cache_->insert("b", response(std::string(100, 'b')));
+  cache_->insert("c", response(std::string(100, 'c')));
+  EXPECT_NE(nullptr, cache_->lookup("a"));
+
+  cache_->insert("d", response(std::string(100, 'd')));
+  EXPECT_NE(nullptr, cache_->lookup("a"));
+  EXPECT_EQ(nullptr, cache_->lookup("b"));
+  EXPECT_NE(nullptr, cache_->lookup("c"));
+  EXPECT_NE(nullptr, cache_->lookup("d"));
+  EXPECT_EQ(1U, store_.counter("cache.eviction").value());
+  EXPECT_EQ(3U, store_.gauge("cache.entries").value());
+  EXPECT_EQ(3 * entry_size, store_.gauge("cache.size_bytes").value());
+}
+
+TEST_F(LruHttpCacheTest, TooLarge) {
+  setup(1, 100);
+  cache_->insert("a", response(std::string(100, 'a')));
+  EXPECT_EQ(nullptr, cache_->lookup("a"));
+  EXPECT_EQ(0U, store_.counter("cache.insert").value());
+}
+
+// Validate that the body is shared by the cached response and the buffers it is copied to.
+TEST_F(LruHttpCacheTest, SharedBody) {
+  setup(1, 1024 * 1024);
+  cache_->insert("a", response("hello"));
+  CachedResponseConstSharedPtr cached = cache_->lookup("a");
+  Buffer::OwnedImpl first;
+  cached->copyBody(first);
+  Buffer::OwnedImpl second;
+  cached->copyBody(second);
+  EXPECT_EQ("hello", first.toString());
+  EXPECT_EQ("hello", second.toString());
+  EXPECT_EQ(5U, cached->bodyLength());
+}
+
+} // namespace
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,34 @@
+#include "extensions/filters/http/decompressor/config.h"
+
+#include "test/mocks/server/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Decompressor {
+
+TEST(DecompressorFilterConfigTest, DecompressorFilter) {
+  const std::string yaml = R"EOF(
+decompress_responses: true
+window_bits: 12
+)EOF";
+
+  envoy::config::filter::http::decompressor::v2alpha::Decompressor proto_config;
+  MessageUtil::loadFromYaml(yaml, proto_config);
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+  DecompressorFilterFactory factory;
+  Http::FilterFactoryCb cb = factory.createFilterFactoryFromProto(proto_config, "stats", context);
+  Http::MockFilterChainFactoryCallbacks filter_callback;
+  EXPECT_CALL(filter_callback, addStreamFilter(_));
+  cb(filter_callback);
+}
+
+} // namespace Decompressor
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,203 @@
+#include <memory>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/compressor/zlib_compressor_impl.h"
+#include "common/stats/isolated_store_impl.h"
+
+#include "extensions/filters/http/decompressor/decompressor_filter.h"
+
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::Return;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Decompressor {
+namespace {
+
+class DecompressorFilterTest : public testing::Test {
+public:
+  DecompressorFilterTest() {
+    ON_CALL(runtime_.snapshot_, featureEnabled("decompressor.filter_enabled", 100))
+        .WillByDefault(Return(true));
+  }
+
+  void setup(const std::string& yaml = "{}") {
+    envoy::config::filter::http::decompressor::v2alpha::Decompressor proto_config;
+    MessageUtil::loadFromYaml(yaml, proto_config);
+    config_ = std::make_shared<DecompressorFilterConfig>(proto_config, "test.", store_, runtime_,
+                                                         tls_);
+    createFilter();
+  }
+
+  void createFilter() {
+    filter_ = std::make_unique<DecompressorFilter>(config_);
+    filter_->setDecoderFilterCallbacks(decoder_callbacks_);
+    filter_->setEncoderFilterCallbacks(encoder_callbacks_);
+  }
+
+  // Compresses the text with a gzip header for window bits 31, or a zlib header for 15.
+  static std::string compress(const std::string& text, int64_t window_bits) {
+    Compressor::ZlibCompressorImpl compressor;
+    compressor.init(Compressor::ZlibCompressorImpl::CompressionLevel::Standard,
+                    Compressor::ZlibCompressorImpl::CompressionStrategy::Standard, window_bits, 8);
+    Buffer::OwnedImpl buffer(text);
+    compressor.compress(buffer, Compressor::State::Finish);
+    return buffer.toString();
+  }
+
+  // Feeds the compressed body to the request path in two data frames.
+  std::string decodeBody(const std::string& compressed) {
+    const size_t half = compressed.size() / 2;
+    Buffer::OwnedImpl first(compressed.substr(0, half));
+    Buffer::OwnedImpl second(compressed.substr(half));
+    EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->decodeData(first, false));
+    EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->decodeData(second, true));
+    return first.toString() + second.toString();
+  }
+
+  uint64_t counter(const std::string& name) {
+    return store_.counter("test.decompressor." + name).value();
+  }
+
+  Stats::IsolatedStoreImpl store_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  DecompressorFilterConfigSharedPtr config_;
+  std::unique_ptr<DecompressorFilter> filter_;
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> decoder_callbacks_;
+  NiceMock<Http::MockStreamEncoderFilterCallbacks> encoder_callbacks_;
+  const std::string text_{std::string(1000, 'a') + "envoy" + std::string(1000, 'b')};
+};
+
+TEST_F(DecompressorFilterTest, DefaultConfig) {
+  setup();
+  EXPECT_TRUE(config_->decompressRequests());
+  EXPECT_FALSE(config_->decompressResponses());
+  EXPECT_EQ(15, config_->windowBits());
+}
+
+TEST_F(DecompressorFilterTest, RequestGzipDecompressed) {
+  setup();
+  const std::string compressed = compress(text_, 31);
+  Http::TestHeaderMapImpl headers{{":method", "POST"},
+                                  {"content-encoding", "gzip"},
+                                  {"content-length", std::to_string(compressed.size())}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, false));
+  EXPECT_EQ(nullptr, headers.ContentEncoding());
+  EXPECT_EQ(nullptr, headers.ContentLength());
+
+  EXPECT_EQ(text_, decodeBody(compressed));
+  filter_->onDestroy();
+  EXPECT_EQ(1U, counter("request_decompressed"));
+  EXPECT_EQ(compressed.size(), counter("total_compressed_bytes"));
+  EXPECT_EQ(text_.size(), counter("total_decompressed_bytes"));
+}
+
+TEST_F(DecompressorFilterTest, RequestDeflateDecompressed) {
+  setup();
+  Http::TestHeaderMapImpl headers{{":method", "POST"}, {"content-encoding", "Deflate"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, false));
+  EXPECT_EQ(nullptr, headers.ContentEncoding());
+  EXPECT_EQ(text_, decodeBody(compress(text_, 15)));
+  filter_->onDestroy();
+}
+
+TEST_F(DecompressorFilterTest, NotDecompressed) {
+  setup();
+  const std::string compressed = compress(text_, 31);
+
+  // Without a body.
+  Http::TestHeaderMapImpl no_body_headers{{":method", "POST"}, {"content-encoding", "gzip"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(no_body_headers, true));
+  EXPECT_EQ("gzip", no_body_headers.get_("content-encoding"));
+
+  // With several encodings.
+  createFilter();
+  Http::TestHeaderMapImpl headers{{":method", "POST"}, {"content-encoding", "gzip, br"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, false));
+  EXPECT_EQ("gzip, br", headers.get_("content-encoding"));
+  Buffer::OwnedImpl data(compressed);
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->decodeData(data, true));
+  EXPECT_EQ(compressed, data.toString());
+
+  // Responses are not decompressed by default.
+  Http::TestHeaderMapImpl response_headers{{":status", "200"}, {"content-encoding", "gzip"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->encodeHeaders(response_headers, false));
+  EXPECT_EQ("gzip", response_headers.get_("content-encoding"));
+  filter_->onDestroy();
+  EXPECT_EQ(0U, counter("request_decompressed"));
+}
+
+TEST_F(DecompressorFilterTest, RuntimeDisabled) {
+  setup();
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled("decompressor.filter_enabled", 100))
+      .WillOnce(Return(false));
+  Http::TestHeaderMapImpl headers{{":method", "POST"}, {"content-encoding", "gzip"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, false));
+  EXPECT_EQ("gzip", headers.get_("content-encoding"));
+}
+
+TEST_F(DecompressorFilterTest, ResponseDecompressed) {
+  setup("{ decompress_requests: false, decompress_responses: true }");
+  Http::TestHeaderMapImpl request_headers{{":method", "POST"}, {"content-encoding", "gzip"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, false));
+  EXPECT_EQ("gzip", request_headers.get_("content-encoding"));
+
+  Http::TestHeaderMapImpl headers{{":status", "200"}, {"content-encoding", "gzip"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->encodeHeaders(headers, false));
+  EXPECT_EQ(nullptr, headers.ContentEncoding());
+  Buffer::OwnedImpl data(compress(text_, 31));
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->encodeData(data, true));
+  EXPECT_EQ(text_, data.toString());
+  filter_->onDestroy();
+  EXPECT_EQ(1U, counter("response_decompressed"));
+}
+
+// The stream is reset when its body is not valid compressed data.
+TEST_F(DecompressorFilterTest, InvalidData) {
+  setup();
+  Http::TestHeaderMapImpl headers{{":method", "POST"}, {"content-encoding", "gzip"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, false));
+  EXPECT_CALL(decoder_callbacks_, resetStream());
+  Buffer::OwnedImpl data("not gzip");
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, filter_->decodeData(data, true));
+  filter_->onDestroy();
+  EXPECT_EQ(1U, counter("decompression_error"));
+
+  // The decompressor is reused once reset.
+  createFilter();
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, false));
+  EXPECT_EQ(text_, decodeBody(compress(text_, 31)));
+  filter_->onDestroy();
+}
+
+// The decompressor of a destroyed filter is reused by the next stream of the worker, whatever the
+// encoding of its body.
+TEST_F(DecompressorFilterTest, DecompressorReused) {
+  setup();
+  for (const int64_t window_bits : {31, 15, 31}) {
+    createFilter();
+    Http::TestHeaderMapImpl headers{{":method", "POST"},
+                                    {"content-encoding", window_bits == 31 ? "gzip" : "deflate"}};
+    EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, false));
+    EXPECT_EQ(text_, decodeBody(compress(text_, window_bits)));
+    filter_->onDestroy();
+  }
+  EXPECT_EQ(3U, counter("request_decompressed"));
+  EXPECT_EQ(0U, counter("decompression_error"));
+}
+
+} // namespace
+} // namespace Decompressor
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,33 @@
+#include "extensions/filters/http/dynamic_forward_proxy/config.h"
+
+#include "test/mocks/server/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace DynamicForwardProxy {
+
+TEST(DynamicForwardProxyFilterConfigTest, DynamicForwardProxyFilter) {
+  const std::string yaml = R"EOF(
+dns_lookup_family: V4_ONLY
+)EOF";
+
+  envoy::config::filter::http::dynamic_forward_proxy::v2alpha::DynamicForwardProxy proto_config;
+  MessageUtil::loadFromYaml(yaml, proto_config);
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+  DynamicForwardProxyFilterFactory factory;
+  Http::FilterFactoryCb cb = factory.createFilterFactoryFromProto(proto_config, "stats", context);
+  Http::MockFilterChainFactoryCallbacks filter_callback;
+  EXPECT_CALL(filter_callback, addStreamDecoderFilter(_));
+  cb(filter_callback);
+}
+
+} // namespace DynamicForwardProxy
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
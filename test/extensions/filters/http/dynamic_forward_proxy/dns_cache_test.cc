@@ -0,0 +1,179 @@
+#include <chrono>
+#include <list>
+#include <memory>
+#include <string>
+
+#include "common/network/utility.h"
+#include "common/stats/isolated_store_impl.h"
+
+#include "extensions/filters/http/dynamic_forward_proxy/dns_cache.h"
+
+#include "test/mocks/common.h"
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/network/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::DoAll;
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+using testing::SaveArg;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace DynamicForwardProxy {
+
+class DnsCacheTest : public testing::Test {
+public:
+  DnsCacheTest() : resolver_(std::make_shared<NiceMock<Network::MockDnsResolver>>()) {
+    dispatcher_.setTimeSystem(time_system_);
+    ON_CALL(time_system_, monotonicTime()).WillByDefault(Invoke([this] { return now_; }));
+    cache_ = std::make_shared<DnsCache>(resolver_, dispatcher_, tls_, stats_store_);
+  }
+
+  // Resolves a name through the cache, recording its result.
+  DnsCache::HandlePtr resolve(const std::string& name) {
+    return cache_->resolve(name, Network::DnsLookupFamily::V4Only,
+                           [this](const DnsCache::AddressList& address_list) -> void {
+                             results_.push_back(address_list);
+                           });
+  }
+
+  // Expects a resolution of the name by the resolver and saves its callback.
+  void expectResolve(const std::string& name) {
+    EXPECT_CALL(*resolver_, resolveWithTtl(name, Network::DnsLookupFamily::V4Only, _))
+        .WillOnce(DoAll(SaveArg<2>(&callback_), Return(&resolver_->active_query_)));
+  }
+
+  const DnsCache::AddressList* find(const std::string& name) {
+    return cache_->find(name, Network::DnsLookupFamily::V4Only);
+  }
+
+  static DnsCache::AddressList addresses(const std::string& address) {
+    return {Network::Utility::parseInternetAddress(address)};
+  }
+
+  NiceMock<MockTimeSystem> time_system_;
+  MonotonicTime now_;
+  NiceMock<Event::MockDispatcher> dispatcher_;
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  Stats::IsolatedStoreImpl stats_store_;
+  std::shared_ptr<NiceMock<Network::MockDnsResolver>> resolver_;
+  DnsCacheSharedPtr cache_;
+  Network::DnsResolver::ResolveWithTtlCb callback_;
+  std::list<DnsCache::AddressList> results_;
+};
+
+// A resolved name is cached on the worker until its TTL expires.
+TEST_F(DnsCacheTest, ResolveAndCache) {
+  EXPECT_EQ(nullptr, find("foo.com"));
+
+  expectResolve("foo.com");
+  DnsCache::HandlePtr handle = resolve("foo.com");
+  EXPECT_TRUE(results_.empty());
+
+  callback_(addresses("1.2.3.4"), std::chrono::seconds(10));
+  ASSERT_EQ(1UL, results_.size());
+  EXPECT_EQ("1.2.3.4:0", results_.front().front()->asString());
+  EXPECT_EQ(1UL, stats_store_.counter("dynamic_forward_proxy.dns_cache.cache_miss").value());
+
+  const DnsCache::AddressList* address_list = find("foo.com");
+  ASSERT_NE(nullptr, address_list);
+  EXPECT_EQ("1.2.3.4:0", address_list->front()->asString());
+  EXPECT_EQ(nullptr, cache_->find("foo.com", Network::DnsLookupFamily::V6Only));
+
+  now_ += std::chrono::seconds(9);
+  EXPECT_NE(nullptr, find("foo.com"));
+  now_ += std::chrono::seconds(1);
+  EXPECT_EQ(nullptr, find("foo.com"));
+}
+
+// Only the first of the concurrent resolutions of a name on a worker asks the main thread, and
+// all of them get the result.
+TEST_F(DnsCacheTest, CoalescePerWorker) {
+  expectResolve("foo.com");
+  EXPECT_CALL(dispatcher_, post(_)).Times(1);
+  DnsCache::HandlePtr handle1 = resolve("foo.com");
+  DnsCache::HandlePtr handle2 = resolve("foo.com");
+
+  callback_(addresses("1.2.3.4"), std::chrono::seconds(10));
+  EXPECT_EQ(2UL, results_.size());
+}
+
+// A destroyed handle is not called back, and the other resolutions of the name still are.
+TEST_F(DnsCacheTest, CancelResolve) {
+  expectResolve("foo.com");
+  DnsCache::HandlePtr handle1 = resolve("foo.com");
+  DnsCache::HandlePtr handle2 = resolve("foo.com");
+  handle1.reset();
+
+  callback_(addresses("1.2.3.4"), std::chrono::seconds(10));
+  EXPECT_EQ(1UL, results_.size());
+}
+
+// A callback may destroy the handle of another resolution of the same name.
+TEST_F(DnsCacheTest, CancelFromCallback) {
+  expectResolve("foo.com");
+  DnsCache::HandlePtr handle2;
+  DnsCache::HandlePtr handle1 =
+      cache_->resolve("foo.com", Network::DnsLookupFamily::V4Only,
+                      [&](const DnsCache::AddressList&) -> void { handle2.reset(); });
+  handle2 = resolve("foo.com");
+
+  callback_(addresses("1.2.3.4"), std::chrono::seconds(10));
+  EXPECT_TRUE(results_.empty());
+}
+
+// Failed resolutions are reported with no addresses and are not cached.
+TEST_F(DnsCacheTest, ResolveFailure) {
+  expectResolve("foo.com");
+  DnsCache::HandlePtr handle = resolve("foo.com");
+  callback_({}, std::chrono::seconds(0));
+  ASSERT_EQ(1UL, results_.size());
+  EXPECT_TRUE(results_.front().empty());
+  EXPECT_EQ(nullptr, find("foo.com"));
+
+  expectResolve("foo.com");
+  handle = resolve("foo.com");
+}
+
+// A name past its TTL on the worker but still served by the main thread while it is refreshed
+// is kept on the worker for the minimum worker TTL.
+TEST_F(DnsCacheTest, MinWorkerTtl) {
+  expectResolve("foo.com");
+  DnsCache::HandlePtr handle = resolve("foo.com");
+  callback_(addresses("1.2.3.4"), std::chrono::seconds(10));
+
+  now_ += std::chrono::seconds(10);
+  EXPECT_EQ(nullptr, find("foo.com"));
+
+  EXPECT_CALL(*resolver_, resolveWithTtl(_, _, _)).Times(0);
+  handle = resolve("foo.com");
+  EXPECT_EQ(2UL, results_.size());
+  EXPECT_EQ(1UL, stats_store_.counter("dynamic_forward_proxy.dns_cache.cache_hit").value());
+  EXPECT_NE(nullptr, find("foo.com"));
+  now_ += std::chrono::seconds(1);
+  EXPECT_EQ(nullptr, find("foo.com"));
+}
+
+// A resolution which completes once the cache is gone is dropped.
+TEST_F(DnsCacheTest, CacheDestroyedBeforePost) {
+  Event::PostCb post_cb;
+  EXPECT_CALL(dispatcher_, post(_)).WillOnce(SaveArg<0>(&post_cb));
+  DnsCache::HandlePtr handle = resolve("foo.com");
+  handle.reset();
+  cache_.reset();
+
+  EXPECT_CALL(*resolver_, resolveWithTtl(_, _, _)).Times(0);
+  post_cb();
+}
+
+} // namespace DynamicForwardProxy
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,195 @@
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/network/utility.h"
+#include "common/stats/isolated_store_impl.h"
+
+#include "extensions/filters/http/dynamic_forward_proxy/proxy_filter.h"
+
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/network/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/mocks/upstream/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::DoAll;
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+using testing::ReturnRef;
+using testing::SaveArg;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace DynamicForwardProxy {
+
+class ProxyFilterTest : public testing::Test {
+public:
+  ProxyFilterTest()
+      : resolver_(std::make_shared<NiceMock<Network::MockDnsResolver>>()),
+        dns_cache_(std::make_shared<DnsCache>(resolver_, dispatcher_, tls_, stats_store_)) {
+    cluster_info_.lb_type_ = Upstream::LoadBalancerType::OriginalDst;
+    cluster_info_.lb_original_dst_config_ = envoy::api::v2::Cluster::OriginalDstLbConfig();
+    cluster_info_.lb_original_dst_config_.value().set_use_http_header(true);
+    config_ = std::make_shared<ProxyFilterConfig>(
+        envoy::config::filter::http::dynamic_forward_proxy::v2alpha::DynamicForwardProxy(),
+        dns_cache_, cm_, "http.foo.", stats_store_);
+    filter_ = std::make_unique<ProxyFilter>(config_);
+    filter_->setDecoderFilterCallbacks(callbacks_);
+  }
+
+  ~ProxyFilterTest() { filter_->onDestroy(); }
+
+  // Expects a resolution of the name by the resolver and saves its callback.
+  void expectResolve(const std::string& name) {
+    EXPECT_CALL(*resolver_, resolveWithTtl(name, Network::DnsLookupFamily::Auto, _))
+        .WillOnce(DoAll(SaveArg<2>(&callback_), Return(&resolver_->active_query_)));
+  }
+
+  // Expects a local reply with the given status.
+  void expectLocalReply(const std::string& status) {
+    EXPECT_CALL(callbacks_, encodeHeaders_(_, _))
+        .WillOnce(Invoke([status](Http::HeaderMap& headers, bool) -> void {
+          EXPECT_EQ(status, headers.Status()->value().getStringView());
+        }));
+  }
+
+  std::string originalDstHost() {
+    return request_headers_.get_(Http::Headers::get().EnvoyOriginalDstHost);
+  }
+
+  uint64_t counter(const std::string& name) {
+    return stats_store_.counter("http.foo.dynamic_forward_proxy." + name).value();
+  }
+
+  NiceMock<Upstream::MockClusterManager> cm_;
+  Upstream::MockClusterInfo& cluster_info_{*cm_.thread_local_cluster_.cluster_.info_};
+  NiceMock<Event::MockDispatcher> dispatcher_;
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  Stats::IsolatedStoreImpl stats_store_;
+  std::shared_ptr<NiceMock<Network::MockDnsResolver>> resolver_;
+  DnsCacheSharedPtr dns_cache_;
+  ProxyFilterConfigSharedPtr config_;
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> callbacks_;
+  std::unique_ptr<ProxyFilter> filter_;
+  Network::DnsResolver::ResolveWithTtlCb callback_;
+  Http::TestHeaderMapImpl request_headers_{{":authority", "foo.com"}, {":path", "/"}};
+  Http::TestHeaderMapImpl request_trailers_;
+  Buffer::OwnedImpl data_;
+};
+
+// Requests routed to other clusters are left alone.
+TEST_F(ProxyFilterTest, NotProxiedCluster) {
+  cluster_info_.lb_original_dst_config_.value().set_use_http_header(false);
+  EXPECT_CALL(*resolver_, resolveWithTtl(_, _, _)).Times(0);
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, false));
+  EXPECT_EQ("", originalDstHost());
+
+  cluster_info_.lb_type_ = Upstream::LoadBalancerType::RoundRobin;
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, false));
+
+  EXPECT_CALL(cm_, get("fake_cluster")).WillOnce(Return(nullptr));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, false));
+
+  EXPECT_CALL(callbacks_, route()).WillOnce(Return(nullptr));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, false));
+  EXPECT_EQ("", originalDstHost());
+}
+
+// A request waits for the resolution of its host, and the next request for the host is sent at
+// once.
+TEST_F(ProxyFilterTest, ResolveAndCache) {
+  expectResolve("foo.com");
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
+            filter_->decodeHeaders(request_headers_, false));
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationAndWatermark, filter_->decodeData(data_, false));
+  EXPECT_EQ(Http::FilterTrailersStatus::StopIteration, filter_->decodeTrailers(request_trailers_));
+  EXPECT_EQ(1UL, counter("dns_cache_miss"));
+
+  EXPECT_CALL(callbacks_, continueDecoding());
+  callback_({Network::Utility::parseInternetAddress("1.2.3.4")}, std::chrono::seconds(60));
+  EXPECT_EQ("1.2.3.4:80", originalDstHost());
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->decodeData(data_, false));
+  EXPECT_EQ(Http::FilterTrailersStatus::Continue, filter_->decodeTrailers(request_trailers_));
+
+  ProxyFilter filter(config_);
+  filter.setDecoderFilterCallbacks(callbacks_);
+  Http::TestHeaderMapImpl request_headers{{":authority", "foo.com:8080"}, {":path", "/"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter.decodeHeaders(request_headers, false));
+  EXPECT_EQ("1.2.3.4:8080", request_headers.get_(Http::Headers::get().EnvoyOriginalDstHost));
+  EXPECT_EQ(1UL, counter("dns_cache_hit"));
+}
+
+// Requests whose host can't be resolved get a 503.
+TEST_F(ProxyFilterTest, ResolveFailure) {
+  expectResolve("foo.com");
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
+            filter_->decodeHeaders(request_headers_, true));
+
+  expectLocalReply("503");
+  EXPECT_CALL(callbacks_, continueDecoding()).Times(0);
+  callback_({}, std::chrono::seconds(0));
+  EXPECT_EQ(1UL, counter("dns_resolution_failure"));
+}
+
+// A request destroyed while it waits is not resumed.
+TEST_F(ProxyFilterTest, DestroyWhileResolving) {
+  expectResolve("foo.com");
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
+            filter_->decodeHeaders(request_headers_, true));
+  filter_->onDestroy();
+
+  EXPECT_CALL(callbacks_, continueDecoding()).Times(0);
+  callback_({Network::Utility::parseInternetAddress("1.2.3.4")}, std::chrono::seconds(60));
+}
+
+// IP addresses are not resolved.
+TEST_F(ProxyFilterTest, IpAddress) {
+  EXPECT_CALL(*resolver_, resolveWithTtl(_, _, _)).Times(0);
+  request_headers_.Host()->value(std::string("10.0.0.1:8080"));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, true));
+  EXPECT_EQ("10.0.0.1:8080", originalDstHost());
+
+  request_headers_.Host()->value(std::string("[::1]"));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, true));
+  EXPECT_EQ("[::1]:80", originalDstHost());
+}
+
+// The default port is that of TLS if the cluster uses it.
+TEST_F(ProxyFilterTest, SecureDefaultPort) {
+  NiceMock<Network::MockTransportSocketFactory> transport_socket_factory;
+  ON_CALL(cluster_info_, transportSocketFactory())
+      .WillByDefault(ReturnRef(transport_socket_factory));
+  ON_CALL(transport_socket_factory, implementsSecureTransport()).WillByDefault(Return(true));
+  request_headers_.Host()->value(std::string("10.0.0.1"));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, true));
+  EXPECT_EQ("10.0.0.1:443", originalDstHost());
+}
+
+TEST_F(ProxyFilterTest, InvalidPort) {
+  EXPECT_CALL(*resolver_, resolveWithTtl(_, _, _)).Times(0);
+  request_headers_.Host()->value(std::string("foo.com:bar"));
+  expectLocalReply("400");
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
+            filter_->decodeHeaders(request_headers_, true));
+  EXPECT_EQ(1UL, counter("invalid_host"));
+
+  request_headers_.Host()->value(std::string("foo.com:65536"));
+  expectLocalReply("400");
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
+            filter_->decodeHeaders(request_headers_, true));
+  EXPECT_EQ(2UL, counter("invalid_host"));
+}
+
+} // namespace DynamicForwardProxy
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
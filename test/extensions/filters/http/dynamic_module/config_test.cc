@@ -0,0 +1,54 @@
+#include "envoy/config/filter/http/dynamic_module/v2alpha/dynamic_module.pb.validate.h"
+
+#include "extensions/filters/http/dynamic_module/config.h"
+
+#include "test/mocks/server/mocks.h"
+#include "test/test_common/environment.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace DynamicModuleFilter {
+
+TEST(DynamicModuleFilterConfigTest, ValidateFail) {
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+  EXPECT_THROW(DynamicModuleFilterConfig().createFilterFactoryFromProto(
+                   envoy::config::filter::http::dynamic_module::v2alpha::DynamicModule(), "stats",
+                   context),
+               ProtoValidationException);
+}
+
+TEST(DynamicModuleFilterConfigTest, RejectedConfig) {
+  envoy::config::filter::http::dynamic_module::v2alpha::DynamicModule proto_config;
+  proto_config.set_path(TestEnvironment::runfilesPath(
+      "test/extensions/filters/common/dynamic_module/libtest_module.so"));
+  proto_config.set_config("reject");
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+  EXPECT_THROW_WITH_REGEX(
+      DynamicModuleFilterConfig().createFilterFactoryFromProto(proto_config, "stats", context),
+      EnvoyException, "rejected its configuration");
+}
+
+TEST(DynamicModuleFilterConfigTest, DynamicModuleFilterCorrectProto) {
+  envoy::config::filter::http::dynamic_module::v2alpha::DynamicModule proto_config;
+  proto_config.set_path(TestEnvironment::runfilesPath(
+      "test/extensions/filters/common/dynamic_module/libtest_module.so"));
+  proto_config.set_config("tenant");
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+  DynamicModuleFilterConfig factory;
+  Http::FilterFactoryCb cb = factory.createFilterFactoryFromProto(proto_config, "stats", context);
+  Http::MockFilterChainFactoryCallbacks filter_callback;
+  EXPECT_CALL(filter_callback, addStreamFilter(_));
+  cb(filter_callback);
+}
+
+} // namespace DynamicModuleFilter
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,92 @@
+#include <memory>
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+
+#include "extensions/filters/http/dynamic_module/dynamic_module_filter.h"
+
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/environment.h"
+#include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace DynamicModuleFilter {
+
+class DynamicModuleFilterTest : public testing::Test {
+public:
+  DynamicModuleFilterTest()
+      : module_(std::make_shared<Filters::Common::DynamicModule::Module>(
+            TestEnvironment::runfilesPath(
+                "test/extensions/filters/common/dynamic_module/libtest_module.so"),
+            "tenant", tls_)),
+        filter_(std::make_unique<Filter>(module_)) {
+    filter_->setDecoderFilterCallbacks(decoder_callbacks_);
+    filter_->setEncoderFilterCallbacks(encoder_callbacks_);
+  }
+
+  ~DynamicModuleFilterTest() { filter_->onDestroy(); }
+
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  Filters::Common::DynamicModule::ModuleSharedPtr module_;
+  std::unique_ptr<Filter> filter_;
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> decoder_callbacks_;
+  NiceMock<Http::MockStreamEncoderFilterCallbacks> encoder_callbacks_;
+};
+
+// The module modifies the request and response headers and reads the request data.
+TEST_F(DynamicModuleFilterTest, Continue) {
+  Http::TestHeaderMapImpl request_headers{{":path", "/"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, false));
+  EXPECT_EQ("tenant", request_headers.get_("x-module-config"));
+
+  Buffer::OwnedImpl data1("hello");
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->decodeData(data1, false));
+  Buffer::OwnedImpl data2("world!");
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->decodeData(data2, true));
+
+  Http::TestHeaderMapImpl response_headers{{":status", "200"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->encodeHeaders(response_headers, false));
+  EXPECT_EQ("11", response_headers.get_("x-request-bytes"));
+
+  // The module doesn't export the callback of the response data.
+  Buffer::OwnedImpl response_data("response");
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->encodeData(response_data, true));
+}
+
+// The module stops the request with a local reply, and doesn't see the rest of the stream.
+TEST_F(DynamicModuleFilterTest, LocalReply) {
+  Http::TestHeaderMapImpl request_headers{{":path", "/"}, {"x-deny", "true"}};
+  Http::TestHeaderMapImpl response_headers{
+      {":status", "403"}, {"content-length", "6"}, {"content-type", "text/plain"}};
+  EXPECT_CALL(decoder_callbacks_, encodeHeaders_(HeaderMapEqualRef(&response_headers), false));
+  EXPECT_CALL(decoder_callbacks_, encodeData(_, true));
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
+            filter_->decodeHeaders(request_headers, false));
+  EXPECT_FALSE(request_headers.has("x-module-config"));
+
+  Buffer::OwnedImpl data("hello");
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, filter_->decodeData(data, true));
+}
+
+// The module can't send a local reply once the response started.
+TEST_F(DynamicModuleFilterTest, LocalReplyInResponse) {
+  filter_->sendLocalReply(Http::Code::Forbidden, "denied");
+  Http::TestHeaderMapImpl response_headers{{":status", "200"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->encodeHeaders(response_headers, true));
+  EXPECT_EQ("0", response_headers.get_("x-request-bytes"));
+}
+
+} // namespace DynamicModuleFilter
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
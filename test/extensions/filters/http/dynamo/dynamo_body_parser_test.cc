@@ -0,0 +1,111 @@
+#include <string>
+#include <vector>
+
+#include "common/buffer/buffer_impl.h"
+
+#include "extensions/filters/http/dynamo/dynamo_body_parser.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Dynamo {
+
+// Feeds a body one byte at a time, as it may be split anywhere across the data frames.
+template <class Parser> bool parseByteByByte(Parser& parser, const std::string& body) {
+  for (char c : body) {
+    Buffer::OwnedImpl data(&c, 1);
+    if (!parser.parse(data)) {
+      return false;
+    }
+  }
+  return parser.finish();
+}
+
+TEST(DynamoRequestBodyParser, SingleTable) {
+  RequestBodyParser parser("GetItem");
+  EXPECT_TRUE(parseByteByByte(
+      parser, R"({"Key": {"TableName": "key"}, "TableName": "locations", "Items": [1, 2]})"));
+  EXPECT_EQ("locations", parser.table().table_name);
+  EXPECT_TRUE(parser.table().is_single_table);
+}
+
+TEST(DynamoRequestBodyParser, TableNameOfUnexpectedType) {
+  RequestBodyParser parser("GetItem");
+  EXPECT_TRUE(parseByteByByte(parser, R"({"TableName": ["locations"]})"));
+  EXPECT_EQ("", parser.table().table_name);
+}
+
+TEST(DynamoRequestBodyParser, BatchSingleTable) {
+  RequestBodyParser parser("BatchWriteItem");
+  EXPECT_TRUE(parseByteByByte(
+      parser, R"({"RequestItems": {"table_1": {"test1": "something"}, "table_1": {}}})"));
+  EXPECT_EQ("table_1", parser.table().table_name);
+  EXPECT_TRUE(parser.table().is_single_table);
+}
+
+TEST(DynamoRequestBodyParser, BatchMultipleTables) {
+  RequestBodyParser parser("BatchGetItem");
+  EXPECT_TRUE(parseByteByByte(
+      parser, R"({"RequestItems": {"table_1": {"TableName": "x"}, "table_2": {}}})"));
+  EXPECT_EQ("", parser.table().table_name);
+  EXPECT_FALSE(parser.table().is_single_table);
+}
+
+TEST(DynamoRequestBodyParser, UnsupportedOperation) {
+  RequestBodyParser parser("ListTables");
+  EXPECT_TRUE(parseByteByByte(parser, R"({"TableName": "locations"})"));
+  EXPECT_EQ("", parser.table().table_name);
+}
+
+TEST(DynamoRequestBodyParser, InvalidBody) {
+  RequestBodyParser parser("GetItem");
+  EXPECT_TRUE(parser.empty());
+  EXPECT_FALSE(parseByteByByte(parser, R"({"TableName": "locations")"));
+  EXPECT_FALSE(parser.empty());
+}
+
+TEST(DynamoResponseBodyParser, ErrorType) {
+  ResponseBodyParser parser;
+  EXPECT_TRUE(parseByteByByte(
+      parser, R"({"__type": "com.amazonaws.dynamodb.v20120810#ValidationException"})"));
+  EXPECT_EQ("ValidationException", parser.errorType());
+}
+
+TEST(DynamoResponseBodyParser, UnsupportedErrorType) {
+  ResponseBodyParser parser;
+  EXPECT_TRUE(parseByteByByte(parser, R"({"__type": "com.amazonaws.dynamodb.v20120810#Unknown"})"));
+  EXPECT_EQ("", parser.errorType());
+}
+
+TEST(DynamoResponseBodyParser, UnprocessedKeysAndPartitions) {
+  ResponseBodyParser parser;
+  EXPECT_TRUE(parseByteByByte(parser, R"EOF(
+{
+  "UnprocessedKeys": {
+    "table_1": { "Keys": [{ "a": 1 }] },
+    "table_2": {}
+  },
+  "ConsumedCapacity": {
+    "Partitions": {
+      "partition_1": 0.5,
+      "partition_2": 3.0,
+      "partition_3": "ignored"
+    }
+  }
+}
+)EOF"));
+
+  EXPECT_EQ((std::vector<std::string>{"table_1", "table_2"}), parser.unprocessedTables());
+  ASSERT_EQ(2, parser.partitions().size());
+  EXPECT_EQ("partition_1", parser.partitions()[0].partition_id_);
+  EXPECT_EQ(1, parser.partitions()[0].capacity_);
+  EXPECT_EQ("partition_2", parser.partitions()[1].partition_id_);
+  EXPECT_EQ(3, parser.partitions()[1].capacity_);
+}
+
+} // namespace Dynamo
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,109 @@
+#include <string>
+#include <vector>
+
+#include "common/buffer/buffer_impl.h"
+
+#include "extensions/filters/http/dynamo/json_stream_parser.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Dynamo {
+
+// Records the reported values as "path=type" and the scalars as "path:value".
+class RecordingCallbacks : public JsonStreamParser::Callbacks {
+public:
+  bool onValue(const std::vector<std::string>& path, JsonStreamParser::ValueType type) override {
+    values_.push_back(join(path) + "=" + std::to_string(static_cast<int>(type)));
+    return true;
+  }
+  void onScalar(const std::vector<std::string>& path, JsonStreamParser::ValueType,
+                const std::string& value) override {
+    scalars_.push_back(join(path) + ":" + value);
+  }
+
+  static std::string join(const std::vector<std::string>& path) {
+    std::string joined;
+    for (const std::string& key : path) {
+      joined += "/" + key;
+    }
+    return joined;
+  }
+
+  std::vector<std::string> values_;
+  std::vector<std::string> scalars_;
+};
+
+// Parses a body either at once or one byte at a time.
+bool parse(JsonStreamParser& parser, const std::string& body, bool byte_by_byte) {
+  if (!byte_by_byte) {
+    Buffer::OwnedImpl data(body);
+    return parser.parse(data) && parser.finish();
+  }
+  for (char c : body) {
+    Buffer::OwnedImpl data(&c, 1);
+    if (!parser.parse(data)) {
+      return false;
+    }
+  }
+  return parser.finish();
+}
+
+class JsonStreamParserTest : public testing::TestWithParam<bool> {};
+
+INSTANTIATE_TEST_CASE_P(ByteByByte, JsonStreamParserTest, testing::Bool());
+
+TEST_P(JsonStreamParserTest, ReportsValuesUpToMaxDepth) {
+  RecordingCallbacks callbacks;
+  JsonStreamParser parser(callbacks, 2);
+  EXPECT_TRUE(parse(parser,
+                    R"({"a" : "x\"\u0041\n", "b": {"c": -1.5e3, "d": {"e": 1}},)"
+                    R"( "f": [{"g": 1}, "h"], "i": true})",
+                    GetParam()));
+
+  EXPECT_EQ((std::vector<std::string>{"=0", "/a=2", "/b=0", "/b/c=3", "/b/d=0", "/f=1", "/i=4"}),
+            callbacks.values_);
+  EXPECT_EQ((std::vector<std::string>{"/a:x\"A\n", "/b/c:-1.5e3"}), callbacks.scalars_);
+}
+
+TEST_P(JsonStreamParserTest, ValidDocuments) {
+  for (const std::string body : {"{}", "[]", " 0 ", "-0.5E-2", "\"\"", "null", "[[], {}, false]",
+                                 "{\"a\": {\"b\": {\"c\": [{\"d\": 1}]}}}"}) {
+    RecordingCallbacks callbacks;
+    JsonStreamParser parser(callbacks, 1);
+    EXPECT_TRUE(parse(parser, body, GetParam())) << body;
+  }
+}
+
+TEST_P(JsonStreamParserTest, InvalidDocuments) {
+  for (const std::string body :
+       {"", "{", "{\"a\":}", "{\"a\" 1}", "{\"a\":01}", "{\"a\":1.}", "{\"a\":tru}", "{}}",
+        "[1,]", "[1 2]", "{\"a\":1,}", "{1:1}", "\"\\x\"", "\"\\u12g4\"", "\"a\nb\"", "-",
+        "{\"a\":[}"}) {
+    RecordingCallbacks callbacks;
+    JsonStreamParser parser(callbacks, 1);
+    EXPECT_FALSE(parse(parser, body, GetParam())) << body;
+  }
+}
+
+TEST(JsonStreamParserErrorTest, IgnoresDataAfterError) {
+  RecordingCallbacks callbacks;
+  JsonStreamParser parser(callbacks, 1);
+  EXPECT_TRUE(parser.empty());
+
+  Buffer::OwnedImpl invalid("}");
+  EXPECT_FALSE(parser.parse(invalid));
+  EXPECT_FALSE(parser.empty());
+
+  Buffer::OwnedImpl valid("{\"a\": 1}");
+  EXPECT_FALSE(parser.parse(valid));
+  EXPECT_FALSE(parser.finish());
+  EXPECT_TRUE(callbacks.values_.empty());
+}
+
+} // namespace Dynamo
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
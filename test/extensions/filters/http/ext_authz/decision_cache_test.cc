@@ -0,0 +1,63 @@
+#include "extensions/filters/http/ext_authz/decision_cache.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace ExtAuthz {
+namespace {
+
+Filters::Common::ExtAuthz::Response makeResponse(Filters::Common::ExtAuthz::CheckStatus status) {
+  Filters::Common::ExtAuthz::Response response{};
+  response.status = status;
+  return response;
+}
+
+TEST(DecisionCacheTest, FindAndExpire) {
+  DecisionCache cache(10);
+  const MonotonicTime now;
+  EXPECT_EQ(nullptr, cache.find("foo", now));
+
+  cache.insert("foo", makeResponse(Filters::Common::ExtAuthz::CheckStatus::Denied),
+               now + std::chrono::seconds(1));
+  const auto* response = cache.find("foo", now);
+  ASSERT_NE(nullptr, response);
+  EXPECT_EQ(Filters::Common::ExtAuthz::CheckStatus::Denied, response->status);
+
+  EXPECT_EQ(nullptr, cache.find("foo", now + std::chrono::seconds(1)));
+  EXPECT_EQ(0, cache.size());
+}
+
+TEST(DecisionCacheTest, Replace) {
+  DecisionCache cache(10);
+  const MonotonicTime now;
+  cache.insert("foo", makeResponse(Filters::Common::ExtAuthz::CheckStatus::Denied),
+               now + std::chrono::seconds(1));
+  cache.insert("foo", makeResponse(Filters::Common::ExtAuthz::CheckStatus::OK),
+               now + std::chrono::seconds(1));
+  EXPECT_EQ(1, cache.size());
+  EXPECT_EQ(Filters::Common::ExtAuthz::CheckStatus::OK, cache.find("foo", now)->status);
+}
+
+// The least recently used decision is evicted when the cache is full.
+TEST(DecisionCacheTest, EvictLeastRecentlyUsed) {
+  DecisionCache cache(2);
+  const MonotonicTime now;
+  const MonotonicTime expiration = now + std::chrono::seconds(1);
+  cache.insert("foo", makeResponse(Filters::Common::ExtAuthz::CheckStatus::OK), expiration);
+  cache.insert("bar", makeResponse(Filters::Common::ExtAuthz::CheckStatus::OK), expiration);
+  EXPECT_NE(nullptr, cache.find("foo", now));
+
+  cache.insert("baz", makeResponse(Filters::Common::ExtAuthz::CheckStatus::OK), expiration);
+  EXPECT_EQ(2, cache.size());
+  EXPECT_NE(nullptr, cache.find("foo", now));
+  EXPECT_EQ(nullptr, cache.find("bar", now));
+  EXPECT_NE(nullptr, cache.find("baz", now));
+}
+
+} // namespace
+} // namespace ExtAuthz
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
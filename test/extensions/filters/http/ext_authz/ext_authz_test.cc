@@ -16,10 +16,12 @@
 #include "extensions/filters/http/ext_authz/ext_authz.h"
 
 #include "test/extensions/filters/common/ext_authz/mocks.h"
+#include "test/mocks/common.h"
 #include "test/mocks/http/mocks.h"
 #include "test/mocks/local_info/mocks.h"
 #include "test/mocks/network/mocks.h"
 #include "test/mocks/runtime/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
 #include "test/mocks/tracing/mocks.h"
 #include "test/mocks/upstream/mocks.h"
 #include "test/test_common/printers.h"
@@ -33,6 +35,7 @@ using testing::InSequence;
 using testing::Invoke;
 using testing::NiceMock;
 using testing::Return;
+using testing::ReturnPointee;
 using testing::ReturnRef;
 using testing::TestWithParam;
 using testing::Values;
@@ -47,6 +50,8 @@ class HttpExtAuthzFilterTestBase {
 public:
   HttpExtAuthzFilterTestBase() {}
 
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  NiceMock<MockTimeSource> time_source_;
   FilterConfigSharedPtr config_;
   Filters::Common::ExtAuthz::MockClient* client_;
   std::unique_ptr<Filter> filter_;
@@ -69,12 +74,30 @@ public:
   void initialize(const std::string yaml) {
     envoy::config::filter::http::ext_authz::v2alpha::ExtAuthz proto_config{};
     MessageUtil::loadFromYaml(yaml, proto_config);
-    config_.reset(new FilterConfig(proto_config, local_info_, stats_store_, runtime_, cm_));
+    config_.reset(new FilterConfig(proto_config, local_info_, stats_store_, runtime_, cm_, tls_,
+                                   time_source_));
+    createFilter();
+    addr_ = std::make_shared<Network::Address::Ipv4Instance>("1.2.3.4", 1111);
+  }
 
+  // Creates a new filter for the next request, sharing the configuration.
+  void createFilter() {
     client_ = new Filters::Common::ExtAuthz::MockClient();
     filter_.reset(new Filter(config_, Filters::Common::ExtAuthz::ClientPtr{client_}));
     filter_->setDecoderFilterCallbacks(filter_callbacks_);
-    addr_ = std::make_shared<Network::Address::Ipv4Instance>("1.2.3.4", 1111);
+  }
+
+  // Expects a check whose response is immediately returned.
+  void expectCheck(const Filters::Common::ExtAuthz::Response& response) {
+    EXPECT_CALL(*client_, check(_, _, _))
+        .WillOnce(
+            WithArgs<0>(Invoke([response](Filters::Common::ExtAuthz::RequestCallbacks& callbacks) {
+              callbacks.onComplete(std::make_unique<Filters::Common::ExtAuthz::Response>(response));
+            })));
+  }
+
+  uint64_t counter(const std::string& name) {
+    return cm_.thread_local_cluster_.cluster_.info_->stats_store_.counter(name).value();
   }
 
   const std::string filter_config_ = R"EOF(
@@ -92,7 +115,8 @@ class HttpExtAuthzFilterParamTest : public TestWithParam<CreateFilterConfigFunc*
 public:
   virtual void SetUp() override {
     envoy::config::filter::http::ext_authz::v2alpha::ExtAuthz proto_config = (*GetParam())();
-    config_.reset(new FilterConfig(proto_config, local_info_, stats_store_, runtime_, cm_));
+    config_.reset(new FilterConfig(proto_config, local_info_, stats_store_, runtime_, cm_, tls_,
+                                   time_source_));
 
     client_ = new Filters::Common::ExtAuthz::MockClient();
     filter_.reset(new Filter(config_, Filters::Common::ExtAuthz::ClientPtr{client_}));
@@ -644,6 +668,166 @@ TEST_F(HttpExtAuthzFilterTest, ImmediateErrorOpen) {
                     .value());
 }
 
+// Test that only the allowed headers are sent to the gRPC authorization service.
+TEST_F(HttpExtAuthzFilterTest, AllowedHeaders) {
+  initialize(R"EOF(
+  grpc_service:
+    envoy_grpc:
+      cluster_name: "ext_authz_server"
+  allowed_headers:
+    - Authorization
+  )EOF");
+
+  ON_CALL(filter_callbacks_, connection()).WillByDefault(Return(&connection_));
+  Http::TestHeaderMapImpl headers{
+      {":method", "GET"}, {":path", "/foo"}, {"authorization", "foo"}, {"cookie", "bar"}};
+  EXPECT_CALL(*client_, check(_, _, _))
+      .WillOnce(Invoke([](Filters::Common::ExtAuthz::RequestCallbacks&,
+                          const envoy::service::auth::v2alpha::CheckRequest& request,
+                          Tracing::Span&) -> void {
+        const auto& http = request.attributes().request().http();
+        EXPECT_EQ("/foo", http.path());
+        EXPECT_EQ(1, http.headers().size());
+        EXPECT_EQ("foo", http.headers().at("authorization"));
+      }));
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration, filter_->decodeHeaders(headers, false));
+}
+
+// Test that the decisions are cached by attributes, and that the cached ones are applied without
+// checking the requests again until they expire.
+TEST_F(HttpExtAuthzFilterTest, DecisionCache) {
+  initialize(R"EOF(
+  grpc_service:
+    envoy_grpc:
+      cluster_name: "ext_authz_server"
+  decision_cache:
+    ttl: 10s
+    key_headers:
+      - authorization
+  )EOF");
+
+  MonotonicTime now;
+  ON_CALL(time_source_, monotonicTime()).WillByDefault(ReturnPointee(&now));
+  ON_CALL(filter_callbacks_, connection()).WillByDefault(Return(&connection_));
+
+  Filters::Common::ExtAuthz::Response ok_response{};
+  ok_response.status = Filters::Common::ExtAuthz::CheckStatus::OK;
+  ok_response.headers_to_add.emplace_back(Http::LowerCaseString("x-user"), "alice");
+  expectCheck(ok_response);
+  {
+    Http::TestHeaderMapImpl headers{{":method", "GET"}, {":path", "/foo"}, {"authorization", "a"}};
+    EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, false));
+    EXPECT_EQ("alice", headers.get_("x-user"));
+  }
+
+  // The same attributes hit the cache.
+  createFilter();
+  EXPECT_CALL(*client_, check(_, _, _)).Times(0);
+  {
+    Http::TestHeaderMapImpl headers{{":method", "GET"}, {":path", "/foo"}, {"authorization", "a"}};
+    EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, false));
+    EXPECT_EQ("alice", headers.get_("x-user"));
+  }
+  EXPECT_EQ(1U, counter("ext_authz.cache_hit"));
+  EXPECT_EQ(2U, counter("ext_authz.ok"));
+
+  // Other attributes are checked, and a denied decision is cached as well.
+  Filters::Common::ExtAuthz::Response denied_response{};
+  denied_response.status = Filters::Common::ExtAuthz::CheckStatus::Denied;
+  denied_response.status_code = Http::Code::Forbidden;
+  createFilter();
+  expectCheck(denied_response);
+  Http::TestHeaderMapImpl other_headers{
+      {":method", "GET"}, {":path", "/foo"}, {"authorization", "b"}};
+  EXPECT_CALL(filter_callbacks_, sendLocalReply(Http::Code::Forbidden, _, _)).Times(2);
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
+            filter_->decodeHeaders(other_headers, false));
+  createFilter();
+  EXPECT_CALL(*client_, check(_, _, _)).Times(0);
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
+            filter_->decodeHeaders(other_headers, false));
+  EXPECT_EQ(2U, counter("ext_authz.cache_hit"));
+
+  // The decisions expire after the TTL.
+  now += std::chrono::seconds(10);
+  createFilter();
+  expectCheck(ok_response);
+  Http::TestHeaderMapImpl headers{{":method", "GET"}, {":path", "/foo"}, {"authorization", "a"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, false));
+  EXPECT_EQ(2U, counter("ext_authz.cache_hit"));
+}
+
+// Test that the errors aren't cached.
+TEST_F(HttpExtAuthzFilterTest, DecisionCacheError) {
+  initialize(R"EOF(
+  grpc_service:
+    envoy_grpc:
+      cluster_name: "ext_authz_server"
+  failure_mode_allow: true
+  decision_cache:
+    ttl: 10s
+  )EOF");
+
+  ON_CALL(filter_callbacks_, connection()).WillByDefault(Return(&connection_));
+  Filters::Common::ExtAuthz::Response response{};
+  response.status = Filters::Common::ExtAuthz::CheckStatus::Error;
+  for (int i = 0; i < 2; i++) {
+    createFilter();
+    expectCheck(response);
+    EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, false));
+  }
+  EXPECT_EQ(0U, counter("ext_authz.cache_hit"));
+}
+
+// Test that the decisions are only cached as directed by the TTL header of the responses, which
+// isn't added to the request.
+TEST_F(HttpExtAuthzFilterTest, DecisionCacheTtlHeader) {
+  initialize(R"EOF(
+  grpc_service:
+    envoy_grpc:
+      cluster_name: "ext_authz_server"
+  decision_cache:
+    ttl: 10s
+    ttl_header: x-authz-ttl
+  )EOF");
+
+  MonotonicTime now;
+  ON_CALL(time_source_, monotonicTime()).WillByDefault(ReturnPointee(&now));
+  ON_CALL(filter_callbacks_, connection()).WillByDefault(Return(&connection_));
+
+  // Without the header, the decision isn't cached.
+  Filters::Common::ExtAuthz::Response response{};
+  response.status = Filters::Common::ExtAuthz::CheckStatus::OK;
+  expectCheck(response);
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, false));
+
+  // A TTL of 0 doesn't cache the decision.
+  response.headers_to_add.emplace_back(Http::LowerCaseString("x-authz-ttl"), "0");
+  createFilter();
+  expectCheck(response);
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, false));
+  EXPECT_FALSE(request_headers_.has("x-authz-ttl"));
+
+  // The TTL of the header is used when shorter than the configured one.
+  response.headers_to_add.back().second = "2";
+  createFilter();
+  expectCheck(response);
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, false));
+  EXPECT_FALSE(request_headers_.has("x-authz-ttl"));
+
+  now += std::chrono::seconds(1);
+  createFilter();
+  EXPECT_CALL(*client_, check(_, _, _)).Times(0);
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, false));
+  EXPECT_EQ(1U, counter("ext_authz.cache_hit"));
+
+  now += std::chrono::seconds(1);
+  createFilter();
+  expectCheck(response);
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, false));
+  EXPECT_EQ(1U, counter("ext_authz.cache_hit"));
+}
+
 } // namespace ExtAuthz
 } // namespace HttpFilters
 } // namespace Extensions
@@ -208,20 +208,23 @@ TEST_F(GrpcJsonTranscoderConfigTest, InvalidVariableBinding) {
 
 class GrpcJsonTranscoderFilterTest : public testing::Test {
 public:
-  GrpcJsonTranscoderFilterTest(const bool match_incoming_request_route = false)
-      : config_(bookstoreProtoConfig(match_incoming_request_route)), filter_(config_) {
+  GrpcJsonTranscoderFilterTest(const bool match_incoming_request_route = false,
+                               const bool stream_unary_responses = false)
+      : config_(bookstoreProtoConfig(match_incoming_request_route, stream_unary_responses)),
+        filter_(config_) {
     filter_.setDecoderFilterCallbacks(decoder_callbacks_);
     filter_.setEncoderFilterCallbacks(encoder_callbacks_);
   }
 
   const envoy::config::filter::http::transcoder::v2::GrpcJsonTranscoder
-  bookstoreProtoConfig(const bool match_incoming_request_route) {
+  bookstoreProtoConfig(const bool match_incoming_request_route, const bool stream_unary_responses) {
     std::string json_string = "{\"proto_descriptor\": \"" + bookstoreDescriptorPath() +
                               "\",\"services\": [\"bookstore.Bookstore\"]}";
     auto json_config = Json::Factory::loadFromString(json_string);
     envoy::config::filter::http::transcoder::v2::GrpcJsonTranscoder proto_config{};
     Envoy::Config::FilterJson::translateGrpcJsonTranscoder(*json_config, proto_config);
     proto_config.set_match_incoming_request_route(match_incoming_request_route);
+    proto_config.set_stream_unary_responses(stream_unary_responses);
     return proto_config;
   }
 
@@ -490,6 +493,65 @@ TEST_F(GrpcJsonTranscoderFilterSkipRecalculatingTest, TranscodingUnaryPostSkipRe
   EXPECT_EQ(Http::FilterDataStatus::Continue, filter_.decodeData(request_data, true));
 }
 
+class GrpcJsonTranscoderFilterStreamUnaryTest : public GrpcJsonTranscoderFilterTest {
+public:
+  GrpcJsonTranscoderFilterStreamUnaryTest() : GrpcJsonTranscoderFilterTest(false, true) {}
+};
+
+TEST_F(GrpcJsonTranscoderFilterStreamUnaryTest, TranscodingUnaryPostStreamResponse) {
+  Http::TestHeaderMapImpl request_headers{
+      {"content-type", "application/json"}, {":method", "POST"}, {":path", "/shelf"}};
+
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_.decodeHeaders(request_headers, false));
+
+  Buffer::OwnedImpl request_data{"{\"theme\": \"Children\"}"};
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_.decodeData(request_data, true));
+
+  Http::TestHeaderMapImpl response_headers{
+      {"content-type", "application/grpc"}, {":status", "200"}, {"content-length", "30"}};
+
+  // The headers are sent right away, without the content length of the gRPC response.
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_.encodeHeaders(response_headers, false));
+  EXPECT_EQ("application/json", response_headers.get_("content-type"));
+  EXPECT_FALSE(response_headers.has("content-length"));
+
+  bookstore::Shelf response;
+  response.set_id(20);
+  response.set_theme("Children");
+
+  // The JSON is sent as soon as the message is complete, without waiting for the end of stream.
+  auto response_data = Grpc::Common::serializeBody(response);
+  Buffer::OwnedImpl partial_data;
+  partial_data.move(*response_data, 10);
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_.encodeData(partial_data, false));
+  EXPECT_EQ(0, partial_data.length());
+
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_.encodeData(*response_data, false));
+  EXPECT_EQ("{\"id\":\"20\",\"theme\":\"Children\"}", response_data->toString());
+
+  // The status of the headers already sent is left alone.
+  Http::TestHeaderMapImpl response_trailers{{"grpc-status", "5"}, {"grpc-message", "not found"}};
+  EXPECT_EQ(Http::FilterTrailersStatus::Continue, filter_.encodeTrailers(response_trailers));
+  EXPECT_EQ("200", response_headers.get_(":status"));
+  EXPECT_FALSE(response_headers.has("grpc-status"));
+}
+
+// Trailers-only responses still have their gRPC status converted to an HTTP status.
+TEST_F(GrpcJsonTranscoderFilterStreamUnaryTest, TranscodingUnaryTrailersOnlyResponse) {
+  Http::TestHeaderMapImpl request_headers{
+      {"content-type", "application/json"}, {":method", "POST"}, {":path", "/shelf"}};
+
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_.decodeHeaders(request_headers, false));
+
+  Buffer::OwnedImpl request_data{"{\"theme\": \"Children\"}"};
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_.decodeData(request_data, true));
+
+  Http::TestHeaderMapImpl response_headers{
+      {"content-type", "application/grpc"}, {":status", "200"}, {"grpc-status", "5"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_.encodeHeaders(response_headers, true));
+  EXPECT_EQ("404", response_headers.get_(":status"));
+}
+
 TEST_F(GrpcJsonTranscoderFilterTest, TranscodingUnaryError) {
   Http::TestHeaderMapImpl request_headers{
       {"content-type", "application/json"}, {":method", "POST"}, {":path", "/shelf"}};
@@ -7,6 +7,7 @@
 #include "test/mocks/http/mocks.h"
 #include "test/mocks/runtime/mocks.h"
 #include "test/mocks/stats/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
 #include "test/test_common/utility.h"
 
 #include "gtest/gtest.h"
@@ -62,7 +63,7 @@ protected:
     Json::ObjectSharedPtr config = Json::Factory::loadFromString(json);
     envoy::config::filter::http::gzip::v2::Gzip gzip;
     MessageUtil::loadFromJson(json, gzip);
-    config_.reset(new GzipFilterConfig(gzip, "test.", stats_, runtime_));
+    config_.reset(new GzipFilterConfig(gzip, "test.", stats_, runtime_, tls_));
     filter_.reset(new GzipFilter(config_));
   }
 
@@ -117,6 +118,7 @@ protected:
     EXPECT_EQ(1, stats_.counter("test.gzip.not_compressed").value());
   }
 
+  NiceMock<ThreadLocal::MockInstance> tls_;
   GzipFilterConfigSharedPtr config_;
   std::unique_ptr<GzipFilter> filter_;
   Buffer::OwnedImpl data_;
@@ -190,6 +192,39 @@ TEST_F(GzipFilterTest, hasCacheControlNoTransformCompression) {
       {{":method", "get"}, {"content-length", "256"}, {"cache-control", "no-cache"}});
 }
 
+// The compressor of a destroyed filter is reused by the next stream of the worker.
+TEST_F(GzipFilterTest, CompressorReused) {
+  doRequest({{":method", "get"}, {"accept-encoding", "gzip"}}, false);
+  doResponseCompression({{":method", "get"}, {"content-length", "256"}});
+  filter_->onDestroy();
+
+  filter_.reset(new GzipFilter(config_));
+  doRequest({{":method", "get"}, {"accept-encoding", "gzip"}}, false);
+  Buffer::OwnedImpl data;
+  TestUtility::feedBufferWithRandomCharacters(data, 128);
+  const std::string expected_str = data.toString();
+  Http::TestHeaderMapImpl headers{{":method", "get"}, {"content-length", "128"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->encodeHeaders(headers, false));
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->encodeData(data, true));
+  filter_->onDestroy();
+
+  Decompressor::ZlibDecompressorImpl decompressor;
+  decompressor.init(31);
+  Buffer::OwnedImpl decompressed_data;
+  decompressor.decompress(data, decompressed_data);
+  EXPECT_EQ(expected_str, decompressed_data.toString());
+  EXPECT_EQ(2U, stats_.counter("test.gzip.compressed").value());
+}
+
+// The compression level is lowered to the fastest one when enabled by runtime.
+TEST_F(GzipFilterTest, ReducedCompressionLevel) {
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled("gzip.reduce_compression_level", 0))
+      .WillOnce(Return(true));
+  doRequest({{":method", "get"}, {"accept-encoding", "gzip"}}, false);
+  doResponseCompression({{":method", "get"}, {"content-length", "256"}});
+  EXPECT_EQ(1U, stats_.counter("test.gzip.reduced_compression_level").value());
+}
+
 // Verifies isAcceptEncodingAllowed function.
 TEST_F(GzipFilterTest, isAcceptEncodingAllowed) {
   {
@@ -15,6 +15,7 @@
 #include "gtest/gtest.h"
 
 using testing::_;
+using testing::Invoke;
 using testing::Return;
 using testing::ReturnRef;
 
@@ -42,12 +43,55 @@ ip_tags:
   void initializeFilter(const std::string& yaml) {
     envoy::config::filter::http::ip_tagging::v2::IPTagging config;
     MessageUtil::loadFromYaml(yaml, config);
+    initializeFilter(config);
+  }
+
+  void initializeFilter(const envoy::config::filter::http::ip_tagging::v2::IPTagging& config) {
     config_.reset(new IpTaggingFilterConfig(config, "prefix.", stats_, runtime_));
     filter_.reset(new IpTaggingFilter(config_));
     filter_->setDecoderFilterCallbacks(filter_callbacks_);
   }
 
-  ~IpTaggingFilterTest() { filter_->onDestroy(); }
+  ~IpTaggingFilterTest() {
+    if (filter_) {
+      filter_->onDestroy();
+    }
+  }
+
+  static void appendInteger(std::string& database, uint64_t value, size_t size) {
+    for (size_t i = size; i > 0; i--) {
+      database.push_back(static_cast<char>(value >> (8 * (i - 1))));
+    }
+  }
+
+  // Builds an IP tags database from tag names and (tag index, prefix length, address bytes)
+  // entries.
+  static std::string
+  makeDatabase(const std::vector<std::string>& tags,
+               const std::vector<std::tuple<uint32_t, uint8_t, std::string>>& prefixes) {
+    std::string database = "ENVOYIPT";
+    appendInteger(database, 1, 4);
+    appendInteger(database, tags.size(), 4);
+    for (const std::string& tag : tags) {
+      appendInteger(database, tag.size(), 2);
+      database += tag;
+    }
+    appendInteger(database, prefixes.size(), 4);
+    for (const auto& prefix : prefixes) {
+      appendInteger(database, std::get<0>(prefix), 4);
+      appendInteger(database, std::get<1>(prefix), 1);
+      appendInteger(database, std::get<2>(prefix).size(), 1);
+      database += std::get<2>(prefix);
+    }
+    return database;
+  }
+
+  static envoy::config::filter::http::ip_tagging::v2::IPTagging
+  databaseConfig(const std::string& database) {
+    envoy::config::filter::http::ip_tagging::v2::IPTagging config;
+    config.mutable_ip_tags_database()->set_inline_bytes(database);
+    return config;
+  }
 
   IpTaggingFilterConfigSharedPtr config_;
   std::unique_ptr<IpTaggingFilter> filter_;
@@ -69,6 +113,12 @@ TEST_F(IpTaggingFilterTest, InternalRequest) {
 
   EXPECT_CALL(stats_, counter("prefix.ip_tagging.internal_request.hit")).Times(1);
   EXPECT_CALL(stats_, counter("prefix.ip_tagging.total")).Times(1);
+  EXPECT_CALL(filter_callbacks_.request_info_, setDynamicMetadata("envoy.ip_tagging", _))
+      .WillOnce(Invoke([](const std::string&, const ProtobufWkt::Struct& metadata) {
+        const auto& tags = metadata.fields().at("tags").list_value();
+        ASSERT_EQ(1, tags.values_size());
+        EXPECT_EQ("internal_request", tags.values(0).string_value());
+      }));
 
   EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, false));
   EXPECT_EQ("internal_request", request_headers.get_(Http::Headers::get().EnvoyIpTags));
@@ -278,6 +328,81 @@ TEST_F(IpTaggingFilterTest, ClearRouteCache) {
   EXPECT_FALSE(request_headers.has(Http::Headers::get().EnvoyIpTags));
 }
 
+TEST_F(IpTaggingFilterTest, Database) {
+  envoy::config::filter::http::ip_tagging::v2::IPTagging config = databaseConfig(
+      makeDatabase({"country_us", "asn_64496"},
+                   {std::make_tuple(0, 8, std::string("\x0a\x00\x00\x00", 4)),
+                    std::make_tuple(1, 16, std::string("\x0a\x01\x00\x00", 4)),
+                    std::make_tuple(1, 32, std::string("\x20\x01\x0d\xb8", 4) +
+                                               std::string(12, '\0'))}));
+  // Inline tags with the same name as a database tag share its id.
+  auto* ip_tag = config.add_ip_tags();
+  ip_tag->set_ip_tag_name("country_us");
+  auto* cidr = ip_tag->add_ip_list();
+  cidr->set_address_prefix("192.0.2.0");
+  cidr->mutable_prefix_len()->set_value(24);
+  initializeFilter(config);
+
+  const std::vector<std::pair<std::string, std::string>> test_cases = {
+      {"10.2.3.4", "country_us"},
+      {"192.0.2.1", "country_us"},
+      {"2001:db8::1", "asn_64496"},
+      {"11.0.0.1", ""}};
+  for (const auto& test_case : test_cases) {
+    Http::TestHeaderMapImpl request_headers;
+    Network::Address::InstanceConstSharedPtr remote_address =
+        Network::Utility::parseInternetAddress(test_case.first);
+    EXPECT_CALL(filter_callbacks_.request_info_, downstreamRemoteAddress())
+        .WillOnce(ReturnRef(remote_address));
+    EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, false));
+    EXPECT_EQ(test_case.second, request_headers.get_(Http::Headers::get().EnvoyIpTags));
+  }
+
+  // There is no guarantee for the order tags are returned by the LC-Trie.
+  Http::TestHeaderMapImpl request_headers;
+  Network::Address::InstanceConstSharedPtr remote_address =
+      Network::Utility::parseInternetAddress("10.1.2.3");
+  EXPECT_CALL(filter_callbacks_.request_info_, downstreamRemoteAddress())
+      .WillOnce(ReturnRef(remote_address));
+  EXPECT_CALL(stats_, counter("prefix.ip_tagging.country_us.hit"));
+  EXPECT_CALL(stats_, counter("prefix.ip_tagging.asn_64496.hit"));
+  EXPECT_CALL(stats_, counter("prefix.ip_tagging.total"));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, false));
+  const std::string header_tag_data = request_headers.get_(Http::Headers::get().EnvoyIpTags);
+  EXPECT_NE(std::string::npos, header_tag_data.find("country_us"));
+  EXPECT_NE(std::string::npos, header_tag_data.find("asn_64496"));
+}
+
+TEST_F(IpTaggingFilterTest, InvalidDatabase) {
+  const std::string valid_tag = makeDatabase({"tag"}, {});
+  EXPECT_THROW_WITH_MESSAGE(initializeFilter(databaseConfig("")), EnvoyException,
+                            "ip_tags_database is truncated");
+  EXPECT_THROW_WITH_MESSAGE(initializeFilter(databaseConfig("NOTIPTAGS")), EnvoyException,
+                            "ip_tags_database is not an IP tags database");
+  EXPECT_THROW_WITH_MESSAGE(initializeFilter(databaseConfig(valid_tag + "x")), EnvoyException,
+                            "ip_tags_database has trailing data");
+  EXPECT_THROW_WITH_MESSAGE(
+      initializeFilter(databaseConfig(makeDatabase({"tag"}, {std::make_tuple(1, 8, "abcd")}))),
+      EnvoyException, "ip_tags_database has an invalid tag index 1");
+  EXPECT_THROW_WITH_MESSAGE(
+      initializeFilter(databaseConfig(makeDatabase({"tag"}, {std::make_tuple(0, 8, "abc")}))),
+      EnvoyException, "ip_tags_database has an invalid address length 3");
+  EXPECT_THROW_WITH_MESSAGE(initializeFilter(databaseConfig(makeDatabase(
+                                {"tag"}, {std::make_tuple(0, 33, std::string(4, '\0'))}))),
+                            EnvoyException, "ip_tags_database has an invalid prefix '0.0.0.0/33'");
+
+  std::string future_version = valid_tag;
+  future_version[11] = 2;
+  EXPECT_THROW_WITH_MESSAGE(initializeFilter(databaseConfig(future_version)), EnvoyException,
+                            "ip_tags_database has unsupported version 2");
+}
+
+TEST_F(IpTaggingFilterTest, NoTags) {
+  EXPECT_THROW_WITH_MESSAGE(
+      initializeFilter("request_type: both"), EnvoyException,
+      "HTTP IP Tagging Filter requires ip_tags or ip_tags_database to be specified.");
+}
+
 } // namespace IpTagging
 } // namespace HttpFilters
 } // namespace Extensions
@@ -68,7 +68,8 @@ private:
 };
 
 // This test validates a good JWT authentication with a remote Jwks.
-// It also verifies Jwks cache with 10 JWT authentications, but only one Jwks fetch.
+// It also verifies Jwks cache with 10 JWT authentications, but only one Jwks fetch, and the token
+// cache with only one signature verification.
 TEST_F(AuthenticatorTest, TestOkJWTandCache) {
   MockUpstream mock_pubkey(mock_factory_ctx_.cluster_manager_, PublicKey);
 
@@ -89,6 +90,68 @@ TEST_F(AuthenticatorTest, TestOkJWTandCache) {
   }
 
   EXPECT_EQ(mock_pubkey.called_count(), 1);
+  EXPECT_EQ(9U, filter_config_->stats().token_cache_hit_.value());
+}
+
+// This test verifies that a Jwks fetched in the background is used by the workers, which don't
+// fetch it themselves.
+TEST_F(AuthenticatorTest, TestAsyncFetchedJwks) {
+  (*proto_config_.mutable_providers())[std::string(ProviderName)]
+      .mutable_remote_jwks()
+      ->set_async_fetch(true);
+  auto* timer = new NiceMock<Event::MockTimer>(&mock_factory_ctx_.dispatcher_);
+  CreateAuthenticator();
+
+  MockUpstream mock_pubkey(mock_factory_ctx_.cluster_manager_, PublicKey);
+  timer->callback_();
+  EXPECT_EQ(mock_pubkey.called_count(), 1);
+  EXPECT_EQ(1U, filter_config_->stats().jwks_fetch_success_.value());
+
+  auto headers = Http::TestHeaderMapImpl{{"Authorization", "Bearer " + std::string(GoodToken)}};
+  MockAuthenticatorCallbacks mock_cb;
+  EXPECT_CALL(mock_cb, onComplete(_)).WillOnce(Invoke([](const Status& status) {
+    ASSERT_EQ(status, Status::Ok);
+  }));
+  auth_->verify(headers, &mock_cb);
+  EXPECT_EQ(mock_pubkey.called_count(), 1);
+}
+
+// This test verifies that no token is cached when the token cache is disabled.
+TEST_F(AuthenticatorTest, TestTokenCacheDisabled) {
+  proto_config_.mutable_token_cache_size()->set_value(0);
+  CreateAuthenticator();
+  MockUpstream mock_pubkey(mock_factory_ctx_.cluster_manager_, PublicKey);
+
+  for (int i = 0; i < 2; i++) {
+    auto headers = Http::TestHeaderMapImpl{{"Authorization", "Bearer " + std::string(GoodToken)}};
+    MockAuthenticatorCallbacks mock_cb;
+    EXPECT_CALL(mock_cb, onComplete(_)).WillOnce(Invoke([](const Status& status) {
+      ASSERT_EQ(status, Status::Ok);
+    }));
+    auth_->verify(headers, &mock_cb);
+    EXPECT_EQ(headers.get_("sec-istio-auth-userinfo"), ExpectedPayloadValue);
+  }
+
+  EXPECT_EQ(0U, filter_config_->stats().token_cache_hit_.value());
+  EXPECT_EQ(0U, filter_config_->getCache().getTokenCache().size());
+}
+
+// This test verifies that a token failing verification is not cached.
+TEST_F(AuthenticatorTest, TestFailedTokenNotCached) {
+  MockUpstream mock_pubkey(mock_factory_ctx_.cluster_manager_, PublicKey);
+
+  for (int i = 0; i < 2; i++) {
+    auto headers =
+        Http::TestHeaderMapImpl{{"Authorization", "Bearer " + std::string(NonExistKidToken)}};
+    MockAuthenticatorCallbacks mock_cb;
+    EXPECT_CALL(mock_cb, onComplete(_)).WillOnce(Invoke([](const Status& status) {
+      ASSERT_EQ(status, Status::JwtVerificationFail);
+    }));
+    auth_->verify(headers, &mock_cb);
+  }
+
+  EXPECT_EQ(0U, filter_config_->stats().token_cache_hit_.value());
+  EXPECT_EQ(0U, filter_config_->getCache().getTokenCache().size());
 }
 
 // This test verifies the Jwt is forwarded if "forward" flag is set.
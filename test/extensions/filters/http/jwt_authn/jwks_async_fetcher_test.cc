@@ -0,0 +1,110 @@
+#include "common/http/message_impl.h"
+#include "common/protobuf/utility.h"
+
+#include "extensions/filters/http/jwt_authn/jwks_async_fetcher.h"
+
+#include "test/extensions/filters/http/jwt_authn/test_common.h"
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/upstream/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+using ::envoy::config::filter::http::jwt_authn::v2alpha::JwtAuthentication;
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::NiceMock;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace JwtAuthn {
+namespace {
+
+class JwksAsyncFetcherTest : public ::testing::Test {
+public:
+  void SetUp() {
+    MessageUtil::loadFromYaml(ExampleConfig, proto_config_);
+    timer_ = new NiceMock<Event::MockTimer>(&dispatcher_);
+    EXPECT_CALL(*timer_, enableTimer(std::chrono::milliseconds(0)));
+    fetcher_ = std::make_unique<JwksAsyncFetcher>(
+        proto_config_.providers().at(ProviderName).remote_jwks(), cm_, dispatcher_,
+        [this](JwksConstSharedPtr jwks) -> void { fetched_.push_back(jwks); });
+
+    EXPECT_CALL(cm_.async_client_, send_(_, _, _))
+        .WillOnce(Invoke(
+            [&](Http::MessagePtr& message, Http::AsyncClient::Callbacks& cb,
+                const absl::optional<std::chrono::milliseconds>&) -> Http::AsyncClient::Request* {
+              EXPECT_EQ((Http::TestHeaderMapImpl{
+                            {":path", "/pubkey_path"},
+                            {":authority", "pubkey_server"},
+                            {":method", "GET"},
+                        }),
+                        message->headers());
+              callbacks_ = &cb;
+              return &request_;
+            }));
+    timer_->callback_();
+  }
+
+  void respond(const std::string& status, const std::string& body) {
+    Http::MessagePtr response_message(new Http::ResponseMessageImpl(
+        Http::HeaderMapPtr{new Http::TestHeaderMapImpl{{":status", status}}}));
+    response_message->body().reset(new Buffer::OwnedImpl(body));
+    callbacks_->onSuccess(std::move(response_message));
+  }
+
+  JwtAuthentication proto_config_;
+  NiceMock<Event::MockDispatcher> dispatcher_;
+  NiceMock<Upstream::MockClusterManager> cm_;
+  Event::MockTimer* timer_;
+  Http::MockAsyncClientRequest request_{&cm_.async_client_};
+  Http::AsyncClient::Callbacks* callbacks_{};
+  std::vector<JwksConstSharedPtr> fetched_;
+  std::unique_ptr<JwksAsyncFetcher> fetcher_;
+};
+
+// The JWKS is fetched again every cache duration.
+TEST_F(JwksAsyncFetcherTest, Fetched) {
+  EXPECT_CALL(*timer_, enableTimer(std::chrono::milliseconds(600000)));
+  respond("200", PublicKey);
+  ASSERT_EQ(1, fetched_.size());
+  EXPECT_NE(nullptr, fetched_[0]);
+}
+
+// A failed fetch is retried after a second.
+TEST_F(JwksAsyncFetcherTest, Failed) {
+  EXPECT_CALL(*timer_, enableTimer(std::chrono::milliseconds(1000)));
+  callbacks_->onFailure(Http::AsyncClient::FailureReason::Reset);
+  ASSERT_EQ(1, fetched_.size());
+  EXPECT_EQ(nullptr, fetched_[0]);
+}
+
+TEST_F(JwksAsyncFetcherTest, BadResponse) {
+  EXPECT_CALL(*timer_, enableTimer(std::chrono::milliseconds(1000))).Times(2);
+  respond("503", PublicKey);
+
+  EXPECT_CALL(cm_.async_client_, send_(_, _, _))
+      .WillOnce(Invoke([this](Http::MessagePtr&, Http::AsyncClient::Callbacks& cb,
+                              const absl::optional<std::chrono::milliseconds>&)
+                           -> Http::AsyncClient::Request* {
+        callbacks_ = &cb;
+        return &request_;
+      }));
+  timer_->callback_();
+  respond("200", "invalid jwks");
+  EXPECT_EQ((std::vector<JwksConstSharedPtr>{nullptr, nullptr}), fetched_);
+}
+
+// A pending fetch is canceled when the fetcher is destroyed.
+TEST_F(JwksAsyncFetcherTest, Destroyed) {
+  EXPECT_CALL(request_, cancel());
+  fetcher_.reset();
+  EXPECT_TRUE(fetched_.empty());
+}
+
+} // namespace
+} // namespace JwtAuthn
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
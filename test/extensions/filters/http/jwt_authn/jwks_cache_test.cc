@@ -9,6 +9,7 @@
 #include "test/test_common/utility.h"
 
 using ::envoy::config::filter::http::jwt_authn::v2alpha::JwtAuthentication;
+using ::google::jwt_verify::Jwks;
 using ::google::jwt_verify::Status;
 
 namespace Envoy {
@@ -53,6 +54,19 @@ TEST_F(JwksCacheTest, TestSetRemoteJwks) {
   EXPECT_TRUE(jwks->isExpired());
 }
 
+// Test setRemoteJwks with a Jwks fetched in the background, which never expires.
+TEST_F(JwksCacheTest, TestSetRemoteJwksObject) {
+  auto& provider0 = (*config_.mutable_providers())[std::string(ProviderName)];
+  provider0.mutable_remote_jwks()->mutable_cache_duration()->set_seconds(0);
+  cache_ = JwksCache::create(config_);
+
+  auto jwks = cache_->findByIssuer("https://example.com");
+  JwksConstSharedPtr jwks_obj = Jwks::createFrom(PublicKey, Jwks::JWKS);
+  jwks->setRemoteJwks(jwks_obj);
+  EXPECT_EQ(jwks->getJwksObj(), jwks_obj.get());
+  EXPECT_FALSE(jwks->isExpired());
+}
+
 // Test setRemoteJwks and use default cache duration.
 TEST_F(JwksCacheTest, TestSetRemoteJwksWithDefaultCacheDuration) {
   auto& provider0 = (*config_.mutable_providers())[std::string(ProviderName)];
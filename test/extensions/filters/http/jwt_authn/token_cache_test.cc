@@ -0,0 +1,62 @@
+#include "extensions/filters/http/jwt_authn/token_cache.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace JwtAuthn {
+namespace {
+
+JwtConstSharedPtr makeJwt(int64_t exp) {
+  auto jwt = std::make_shared<::google::jwt_verify::Jwt>();
+  jwt->exp_ = exp;
+  return jwt;
+}
+
+TEST(TokenCacheTest, FindAndExpire) {
+  TokenCache cache(10);
+  const JwtConstSharedPtr jwt = makeJwt(1000);
+  cache.insert("token", jwt);
+  EXPECT_EQ(jwt, cache.find("token", 999));
+  EXPECT_EQ(nullptr, cache.find("other", 999));
+  // A prefix of a cached token doesn't match it.
+  EXPECT_EQ(nullptr, cache.find("toke", 999));
+
+  // Expired tokens are evicted.
+  EXPECT_EQ(nullptr, cache.find("token", 1001));
+  EXPECT_EQ(0, cache.size());
+
+  // Tokens without an expiration time don't expire.
+  cache.insert("forever", makeJwt(0));
+  EXPECT_NE(nullptr, cache.find("forever", 1001));
+}
+
+TEST(TokenCacheTest, EvictLeastRecentlyUsed) {
+  TokenCache cache(2);
+  cache.insert("a", makeJwt(0));
+  cache.insert("b", makeJwt(0));
+  // "a" becomes the most recently used token.
+  EXPECT_NE(nullptr, cache.find("a", 0));
+  cache.insert("c", makeJwt(0));
+  EXPECT_EQ(2, cache.size());
+  EXPECT_NE(nullptr, cache.find("a", 0));
+  EXPECT_EQ(nullptr, cache.find("b", 0));
+  EXPECT_NE(nullptr, cache.find("c", 0));
+
+  cache.clear();
+  EXPECT_EQ(0, cache.size());
+  EXPECT_EQ(nullptr, cache.find("a", 0));
+}
+
+TEST(TokenCacheTest, Disabled) {
+  TokenCache cache(0);
+  cache.insert("token", makeJwt(0));
+  EXPECT_EQ(nullptr, cache.find("token", 0));
+}
+
+} // namespace
+} // namespace JwtAuthn
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,64 @@
+#include "envoy/config/filter/http/local_rate_limit/v2alpha/local_rate_limit.pb.validate.h"
+
+#include "extensions/filters/http/local_ratelimit/config.h"
+
+#include "test/mocks/server/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace LocalRateLimitFilter {
+
+TEST(LocalRateLimitFilterConfigTest, LocalRateLimitFilter) {
+  const std::string yaml = R"EOF(
+  token_bucket:
+    max_tokens: 100
+    fill_interval: 1s
+  descriptors:
+  - descriptor:
+      entries:
+      - key: remote_address
+        value: 10.0.0.1
+    token_bucket:
+      max_tokens: 10
+      tokens_per_fill: 5
+      fill_interval: 1s
+  )EOF";
+
+  envoy::config::filter::http::local_rate_limit::v2alpha::LocalRateLimit proto_config;
+  MessageUtil::loadFromYaml(yaml, proto_config);
+
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+  LocalRateLimitFilterConfig factory;
+  Http::FilterFactoryCb cb = factory.createFilterFactoryFromProto(proto_config, "stats", context);
+  Http::MockFilterChainFactoryCallbacks filter_callback;
+  EXPECT_CALL(filter_callback, addStreamDecoderFilter(_));
+  cb(filter_callback);
+}
+
+TEST(LocalRateLimitFilterConfigTest, InvalidTokenBucket) {
+  const std::string yaml = R"EOF(
+  token_bucket:
+    max_tokens: 0
+    fill_interval: 1s
+  )EOF";
+
+  envoy::config::filter::http::local_rate_limit::v2alpha::LocalRateLimit proto_config;
+  MessageUtil::loadFromYaml(yaml, proto_config);
+
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+  LocalRateLimitFilterConfig factory;
+  EXPECT_THROW(factory.createFilterFactoryFromProto(proto_config, "stats", context),
+               ProtoValidationException);
+}
+
+} // namespace LocalRateLimitFilter
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
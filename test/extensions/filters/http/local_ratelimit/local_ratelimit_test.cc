@@ -0,0 +1,180 @@
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/stats/isolated_store_impl.h"
+
+#include "extensions/filters/http/local_ratelimit/local_ratelimit.h"
+
+#include "test/mocks/common.h"
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/local_info/mocks.h"
+#include "test/mocks/router/mocks.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::NiceMock;
+using testing::Return;
+using testing::ReturnPointee;
+using testing::SetArgReferee;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace LocalRateLimitFilter {
+
+class LocalRateLimitFilterTest : public testing::Test {
+public:
+  LocalRateLimitFilterTest() {
+    ON_CALL(runtime_.snapshot_, featureEnabled("local_ratelimit.http_filter_enabled", 100))
+        .WillByDefault(Return(true));
+    ON_CALL(runtime_.snapshot_, featureEnabled("local_ratelimit.http_filter_enforcing", 100))
+        .WillByDefault(Return(true));
+    ON_CALL(time_source_, monotonicTime()).WillByDefault(ReturnPointee(&now_));
+  }
+
+  void setUpTest(const std::string& yaml) {
+    envoy::config::filter::http::local_rate_limit::v2alpha::LocalRateLimit proto_config;
+    MessageUtil::loadFromYaml(yaml, proto_config);
+    config_ = std::make_shared<FilterConfig>(proto_config, "test.", stats_store_, local_info_,
+                                             runtime_, time_source_);
+
+    filter_callbacks_.route_->route_entry_.rate_limit_policy_.rate_limit_policy_entry_.clear();
+    filter_callbacks_.route_->route_entry_.rate_limit_policy_.rate_limit_policy_entry_.emplace_back(
+        route_rate_limit_);
+    filter_callbacks_.route_->route_entry_.virtual_host_.rate_limit_policy_.rate_limit_policy_entry_
+        .clear();
+  }
+
+  Http::FilterHeadersStatus decodeHeaders() {
+    Filter filter(config_);
+    filter.setDecoderFilterCallbacks(filter_callbacks_);
+    return filter.decodeHeaders(request_headers_, false);
+  }
+
+  uint64_t counter(const std::string& name) {
+    return stats_store_.counter("test.local_ratelimit." + name).value();
+  }
+
+  MonotonicTime now_{std::chrono::seconds(100)};
+  NiceMock<MockTimeSource> time_source_;
+  Stats::IsolatedStoreImpl stats_store_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<LocalInfo::MockLocalInfo> local_info_;
+  NiceMock<Router::MockRateLimitPolicyEntry> route_rate_limit_;
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> filter_callbacks_;
+  Http::TestHeaderMapImpl request_headers_;
+  FilterConfigSharedPtr config_;
+};
+
+TEST_F(LocalRateLimitFilterTest, TokenBucket) {
+  setUpTest(R"EOF(
+  token_bucket:
+    max_tokens: 1
+    fill_interval: 1s
+  )EOF");
+
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, decodeHeaders());
+  EXPECT_EQ(1U, counter("ok"));
+
+  Http::TestHeaderMapImpl response_headers{{":status", "429"}};
+  EXPECT_CALL(filter_callbacks_, encodeHeaders_(HeaderMapEqualRef(&response_headers), true));
+  EXPECT_CALL(filter_callbacks_.request_info_,
+              setResponseFlag(RequestInfo::ResponseFlag::RateLimited));
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration, decodeHeaders());
+  EXPECT_EQ(1U, counter("rate_limited"));
+
+  now_ += std::chrono::seconds(1);
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, decodeHeaders());
+  EXPECT_EQ(2U, counter("ok"));
+}
+
+TEST_F(LocalRateLimitFilterTest, Descriptors) {
+  setUpTest(R"EOF(
+  descriptors:
+  - descriptor:
+      entries:
+      - key: descriptor_key
+        value: limited
+    token_bucket:
+      max_tokens: 1
+      fill_interval: 1s
+  )EOF");
+
+  const std::vector<RateLimit::Descriptor> limited{{{{"descriptor_key", "limited"}}}};
+  const std::vector<RateLimit::Descriptor> other{{{{"descriptor_key", "other"}}}};
+
+  EXPECT_CALL(route_rate_limit_, populateDescriptors(_, _, _, _, _))
+      .WillOnce(SetArgReferee<1>(limited))
+      .WillOnce(SetArgReferee<1>(other))
+      .WillOnce(SetArgReferee<1>(limited));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, decodeHeaders());
+
+  // The requests whose descriptors have no bucket are not rate limited.
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, decodeHeaders());
+  EXPECT_EQ(2U, counter("ok"));
+
+  Http::TestHeaderMapImpl response_headers{{":status", "429"}};
+  EXPECT_CALL(filter_callbacks_, encodeHeaders_(HeaderMapEqualRef(&response_headers), true));
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration, decodeHeaders());
+  EXPECT_EQ(1U, counter("rate_limited"));
+}
+
+TEST_F(LocalRateLimitFilterTest, NoRoute) {
+  setUpTest(R"EOF(
+  descriptors:
+  - descriptor:
+      entries:
+      - key: descriptor_key
+        value: limited
+    token_bucket:
+      max_tokens: 1
+      fill_interval: 1s
+  )EOF");
+
+  EXPECT_CALL(*filter_callbacks_.route_, routeEntry()).WillRepeatedly(Return(nullptr));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, decodeHeaders());
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, decodeHeaders());
+  EXPECT_EQ(2U, counter("ok"));
+}
+
+TEST_F(LocalRateLimitFilterTest, NotEnforcing) {
+  setUpTest(R"EOF(
+  token_bucket:
+    max_tokens: 1
+    fill_interval: 1s
+  )EOF");
+
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled("local_ratelimit.http_filter_enforcing", 100))
+      .WillOnce(Return(false));
+  EXPECT_CALL(filter_callbacks_, encodeHeaders_(_, _)).Times(0);
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, decodeHeaders());
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, decodeHeaders());
+  EXPECT_EQ(1U, counter("rate_limited"));
+}
+
+TEST_F(LocalRateLimitFilterTest, RuntimeDisabled) {
+  setUpTest(R"EOF(
+  token_bucket:
+    max_tokens: 1
+    fill_interval: 1s
+  )EOF");
+
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled("local_ratelimit.http_filter_enabled", 100))
+      .WillRepeatedly(Return(false));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, decodeHeaders());
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, decodeHeaders());
+  EXPECT_EQ(0U, counter("ok"));
+  EXPECT_EQ(0U, counter("rate_limited"));
+}
+
+} // namespace LocalRateLimitFilter
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,28 @@
+#include "extensions/filters/http/on_demand_cluster/config.h"
+
+#include "test/mocks/server/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace OnDemandCluster {
+
+TEST(OnDemandClusterFilterConfigTest, OnDemandClusterFilter) {
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+  OnDemandClusterFilterConfig factory;
+  Http::FilterFactoryCb cb =
+      factory.createFilterFactoryFromProto(*factory.createEmptyConfigProto(), "stats", context);
+  Http::MockFilterChainFactoryCallbacks filter_callback;
+  EXPECT_CALL(filter_callback, addStreamDecoderFilter(_));
+  cb(filter_callback);
+}
+
+} // namespace OnDemandCluster
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,113 @@
+#include "common/buffer/buffer_impl.h"
+
+#include "extensions/filters/http/on_demand_cluster/on_demand_cluster_filter.h"
+
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/upstream/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::InSequence;
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace OnDemandCluster {
+
+class MockOnDemandClusterHandle : public Upstream::OnDemandClusterHandle {
+public:
+  ~MockOnDemandClusterHandle() { onDestroy(); }
+
+  MOCK_METHOD0(onDestroy, void());
+};
+
+class OnDemandClusterFilterTest : public testing::Test {
+public:
+  OnDemandClusterFilterTest() : filter_(cm_) { filter_.setDecoderFilterCallbacks(callbacks_); }
+
+  MockOnDemandClusterHandle* expectLoad() {
+    MockOnDemandClusterHandle* handle = new MockOnDemandClusterHandle();
+    EXPECT_CALL(cm_, loadOnDemandCluster_("fake_cluster", _))
+        .WillOnce(Invoke([this, handle](const std::string&, std::function<void()> callback) {
+          callback_ = callback;
+          return handle;
+        }));
+    return handle;
+  }
+
+  NiceMock<Upstream::MockClusterManager> cm_;
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> callbacks_;
+  OnDemandClusterFilter filter_;
+  std::function<void()> callback_;
+  Http::TestHeaderMapImpl request_headers_{{":path", "/"}};
+  Http::TestHeaderMapImpl request_trailers_;
+  Buffer::OwnedImpl data_;
+};
+
+TEST_F(OnDemandClusterFilterTest, NoRoute) {
+  EXPECT_CALL(callbacks_, route()).WillOnce(Return(nullptr));
+  EXPECT_CALL(cm_, loadOnDemandCluster_(_, _)).Times(0);
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_.decodeHeaders(request_headers_, false));
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_.decodeData(data_, false));
+  EXPECT_EQ(Http::FilterTrailersStatus::Continue, filter_.decodeTrailers(request_trailers_));
+}
+
+TEST_F(OnDemandClusterFilterTest, NothingToLoad) {
+  EXPECT_CALL(cm_, loadOnDemandCluster_("fake_cluster", _)).WillOnce(Return(nullptr));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_.decodeHeaders(request_headers_, false));
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_.decodeData(data_, false));
+  EXPECT_EQ(Http::FilterTrailersStatus::Continue, filter_.decodeTrailers(request_trailers_));
+  filter_.onDestroy();
+}
+
+TEST_F(OnDemandClusterFilterTest, WaitForCluster) {
+  InSequence s;
+
+  MockOnDemandClusterHandle* handle = expectLoad();
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
+            filter_.decodeHeaders(request_headers_, false));
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationAndWatermark, filter_.decodeData(data_, false));
+  EXPECT_EQ(Http::FilterTrailersStatus::StopIteration, filter_.decodeTrailers(request_trailers_));
+
+  EXPECT_CALL(*handle, onDestroy());
+  EXPECT_CALL(callbacks_, continueDecoding());
+  callback_();
+  filter_.onDestroy();
+}
+
+TEST_F(OnDemandClusterFilterTest, ContinueAfterLoad) {
+  InSequence s;
+
+  MockOnDemandClusterHandle* handle = expectLoad();
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
+            filter_.decodeHeaders(request_headers_, false));
+
+  EXPECT_CALL(*handle, onDestroy());
+  EXPECT_CALL(callbacks_, continueDecoding());
+  callback_();
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_.decodeData(data_, false));
+  EXPECT_EQ(Http::FilterTrailersStatus::Continue, filter_.decodeTrailers(request_trailers_));
+}
+
+TEST_F(OnDemandClusterFilterTest, DestroyWhileLoading) {
+  InSequence s;
+
+  MockOnDemandClusterHandle* handle = expectLoad();
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
+            filter_.decodeHeaders(request_headers_, true));
+
+  EXPECT_CALL(*handle, onDestroy());
+  EXPECT_CALL(callbacks_, continueDecoding()).Times(0);
+  filter_.onDestroy();
+}
+
+} // namespace OnDemandCluster
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
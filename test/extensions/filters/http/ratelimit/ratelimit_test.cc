@@ -9,10 +9,12 @@
 
 #include "extensions/filters/http/ratelimit/ratelimit.h"
 
+#include "test/mocks/common.h"
 #include "test/mocks/http/mocks.h"
 #include "test/mocks/local_info/mocks.h"
 #include "test/mocks/ratelimit/mocks.h"
 #include "test/mocks/runtime/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
 #include "test/mocks/tracing/mocks.h"
 #include "test/mocks/upstream/mocks.h"
 #include "test/test_common/printers.h"
@@ -26,6 +28,7 @@ using testing::InSequence;
 using testing::Invoke;
 using testing::NiceMock;
 using testing::Return;
+using testing::ReturnPointee;
 using testing::ReturnRef;
 using testing::SetArgReferee;
 using testing::WithArgs;
@@ -44,17 +47,17 @@ public:
         .WillByDefault(Return(true));
     ON_CALL(runtime_.snapshot_, featureEnabled("ratelimit.test_key.http_filter_enabled", 100))
         .WillByDefault(Return(true));
+    ON_CALL(time_source_, monotonicTime()).WillByDefault(ReturnPointee(&now_));
   }
 
   void SetUpTest(const std::string& yaml) {
     envoy::config::filter::http::rate_limit::v2::RateLimit proto_config{};
     MessageUtil::loadFromYaml(yaml, proto_config);
 
-    config_.reset(new FilterConfig(proto_config, local_info_, stats_store_, runtime_, cm_));
+    config_.reset(new FilterConfig(proto_config, local_info_, stats_store_, runtime_, cm_, tls_,
+                                   time_source_));
 
-    client_ = new RateLimit::MockClient();
-    filter_.reset(new Filter(config_, RateLimit::ClientPtr{client_}));
-    filter_->setDecoderFilterCallbacks(filter_callbacks_);
+    newFilter();
     filter_callbacks_.route_->route_entry_.rate_limit_policy_.rate_limit_policy_entry_.clear();
     filter_callbacks_.route_->route_entry_.rate_limit_policy_.rate_limit_policy_entry_.emplace_back(
         route_rate_limit_);
@@ -64,6 +67,12 @@ public:
         .emplace_back(vh_rate_limit_);
   }
 
+  void newFilter() {
+    client_ = new RateLimit::MockClient();
+    filter_.reset(new Filter(config_, RateLimit::ClientPtr{client_}));
+    filter_->setDecoderFilterCallbacks(filter_callbacks_);
+  }
+
   const std::string fail_close_config_ = R"EOF(
   domain: foo
   failure_mode_deny: true
@@ -73,6 +82,9 @@ public:
   domain: foo
   )EOF";
 
+  MonotonicTime now_{std::chrono::seconds(100)};
+  NiceMock<MockTimeSource> time_source_;
+  NiceMock<ThreadLocal::MockInstance> tls_;
   FilterConfigSharedPtr config_;
   RateLimit::MockClient* client_;
   std::unique_ptr<Filter> filter_;
@@ -770,6 +782,68 @@ TEST_F(HttpRateLimitFilterTest, DefaultConfigValueTest) {
   EXPECT_EQ(FilterRequestType::Both, config_->requestType());
 }
 
+// The requests with the same descriptors use the hits of the lease obtained by the first one,
+// until they are all used or the lease expires.
+TEST_F(HttpRateLimitFilterTest, QuotaLease) {
+  SetUpTest(R"EOF(
+  domain: foo
+  quota_lease:
+    hits: 3
+    ttl: 1s
+  )EOF");
+
+  ON_CALL(route_rate_limit_, populateDescriptors(_, _, _, _, _))
+      .WillByDefault(SetArgReferee<1>(descriptor_));
+  const auto decode_request = [this](bool calls_service) {
+    newFilter();
+    EXPECT_CALL(*client_, limit(_, "foo", _, _))
+        .Times(calls_service ? 1 : 0)
+        .WillRepeatedly(WithArgs<0>(Invoke([](RateLimit::RequestCallbacks& callbacks) -> void {
+          callbacks.complete(RateLimit::LimitStatus::OK, nullptr);
+        })));
+    EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+              filter_->decodeHeaders(request_headers_, false));
+  };
+
+  decode_request(true);
+  EXPECT_EQ(3U, client_->hits_addend_);
+  decode_request(false);
+  decode_request(false);
+  decode_request(true);
+
+  // The hits remaining from the second lease expire.
+  now_ += std::chrono::seconds(1);
+  decode_request(true);
+
+  Stats::Store& stats = cm_.thread_local_cluster_.cluster_.info_->stats_store_;
+  EXPECT_EQ(5U, stats.counter("ratelimit.ok").value());
+  EXPECT_EQ(2U, stats.counter("ratelimit.leased_hit").value());
+}
+
+// No lease is kept when the request is over the limit.
+TEST_F(HttpRateLimitFilterTest, QuotaLeaseOverLimit) {
+  SetUpTest(R"EOF(
+  domain: foo
+  quota_lease:
+    hits: 3
+    ttl: 1s
+  )EOF");
+
+  ON_CALL(route_rate_limit_, populateDescriptors(_, _, _, _, _))
+      .WillByDefault(SetArgReferee<1>(descriptor_));
+  EXPECT_CALL(*client_, limit(_, "foo", _, _))
+      .WillOnce(WithArgs<0>(Invoke([](RateLimit::RequestCallbacks& callbacks) -> void {
+        callbacks.complete(RateLimit::LimitStatus::OverLimit, nullptr);
+      })));
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
+            filter_->decodeHeaders(request_headers_, false));
+
+  newFilter();
+  EXPECT_CALL(*client_, limit(_, "foo", _, _));
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
+            filter_->decodeHeaders(request_headers_, false));
+}
+
 } // namespace RateLimitFilter
 } // namespace HttpFilters
 } // namespace Extensions
@@ -0,0 +1,33 @@
+#include "extensions/filters/http/request_coalescing/config.h"
+
+#include "test/mocks/server/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace RequestCoalescing {
+
+TEST(RequestCoalescingFilterConfigTest, RequestCoalescingFilter) {
+  const std::string yaml = R"EOF(
+key_headers: [accept-encoding]
+)EOF";
+
+  envoy::config::filter::http::request_coalescing::v2alpha::RequestCoalescing proto_config;
+  MessageUtil::loadFromYaml(yaml, proto_config);
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+  RequestCoalescingFilterFactory factory;
+  Http::FilterFactoryCb cb = factory.createFilterFactoryFromProto(proto_config, "stats", context);
+  Http::MockFilterChainFactoryCallbacks filter_callback;
+  EXPECT_CALL(filter_callback, addStreamFilter(_));
+  cb(filter_callback);
+}
+
+} // namespace RequestCoalescing
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
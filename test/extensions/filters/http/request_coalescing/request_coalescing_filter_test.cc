@@ -0,0 +1,206 @@
+#include <functional>
+#include <memory>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/stats/isolated_store_impl.h"
+
+#include "extensions/filters/http/request_coalescing/request_coalescing_filter.h"
+
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::Invoke;
+using testing::NiceMock;
+using testing::SaveArg;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace RequestCoalescing {
+namespace {
+
+class RequestCoalescingFilterTest : public testing::Test {
+public:
+  struct Stream {
+    Stream(RequestCoalescingFilterConfigSharedPtr config) : filter_(config) {
+      filter_.setDecoderFilterCallbacks(decoder_callbacks_);
+    }
+
+    NiceMock<Http::MockStreamDecoderFilterCallbacks> decoder_callbacks_;
+    RequestCoalescingFilter filter_;
+  };
+
+  void setup(const std::string& yaml = "{}") {
+    envoy::config::filter::http::request_coalescing::v2alpha::RequestCoalescing proto_config;
+    MessageUtil::loadFromYaml(yaml, proto_config);
+    config_ = std::make_shared<RequestCoalescingFilterConfig>(proto_config, "test.", store_, tls_);
+  }
+
+  std::unique_ptr<Stream> createStream() { return std::make_unique<Stream>(config_); }
+
+  uint64_t counter(const std::string& name) {
+    return store_.counter("test.request_coalescing." + name).value();
+  }
+
+  Stats::IsolatedStoreImpl store_;
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  RequestCoalescingFilterConfigSharedPtr config_;
+  Http::TestHeaderMapImpl request_headers_{
+      {":method", "GET"}, {":authority", "host"}, {":path", "/foo"}};
+  Http::TestHeaderMapImpl response_headers_{{":status", "200"}};
+};
+
+TEST_F(RequestCoalescingFilterTest, NotCoalesced) {
+  setup();
+  std::unique_ptr<Stream> stream = createStream();
+
+  Http::TestHeaderMapImpl post_headers{{":method", "POST"}, {":authority", "host"}, {":path", "/"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, stream->filter_.decodeHeaders(post_headers, true));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            stream->filter_.decodeHeaders(request_headers_, false));
+  Http::TestHeaderMapImpl authorization_headers{request_headers_};
+  authorization_headers.addCopy("authorization", "secret");
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            stream->filter_.decodeHeaders(authorization_headers, true));
+  Http::TestHeaderMapImpl cookie_headers{request_headers_};
+  cookie_headers.addCopy("cookie", "session=1");
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            stream->filter_.decodeHeaders(cookie_headers, true));
+  EXPECT_EQ(0U, counter("rq_leader"));
+}
+
+// Validate that the response to the leader is sent to the waiters as it arrives.
+TEST_F(RequestCoalescingFilterTest, Coalesced) {
+  setup();
+  std::unique_ptr<Stream> leader = createStream();
+  std::unique_ptr<Stream> waiter = createStream();
+  std::unique_ptr<Stream> other = createStream();
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            leader->filter_.decodeHeaders(request_headers_, true));
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
+            waiter->filter_.decodeHeaders(request_headers_, true));
+  Http::TestHeaderMapImpl other_headers{
+      {":method", "GET"}, {":authority", "host"}, {":path", "/bar"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            other->filter_.decodeHeaders(other_headers, true));
+  EXPECT_EQ(2U, counter("rq_leader"));
+  EXPECT_EQ(1U, counter("rq_coalesced"));
+
+  EXPECT_CALL(waiter->decoder_callbacks_,
+              encodeHeaders_(HeaderMapEqualRef(&response_headers_), false));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            leader->filter_.encodeHeaders(response_headers_, false));
+
+  // Requests that arrive once the leader got its response headers start a new group.
+  std::unique_ptr<Stream> late = createStream();
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            late->filter_.decodeHeaders(request_headers_, true));
+
+  Buffer::OwnedImpl data("hello");
+  EXPECT_CALL(waiter->decoder_callbacks_, encodeData(_, false))
+      .WillOnce(Invoke([](Buffer::Instance& data, bool) { EXPECT_EQ("hello", data.toString()); }));
+  EXPECT_EQ(Http::FilterDataStatus::Continue, leader->filter_.encodeData(data, false));
+  EXPECT_EQ("hello", data.toString());
+
+  Http::TestHeaderMapImpl response_trailers{{"grpc-status", "0"}};
+  EXPECT_CALL(waiter->decoder_callbacks_,
+              encodeTrailers_(HeaderMapEqualRef(&response_trailers)));
+  EXPECT_EQ(Http::FilterTrailersStatus::Continue,
+            leader->filter_.encodeTrailers(response_trailers));
+
+  EXPECT_CALL(leader->decoder_callbacks_.dispatcher_, post(_)).Times(0);
+  leader->filter_.onDestroy();
+  waiter->filter_.onDestroy();
+  EXPECT_EQ(0U, counter("rq_released"));
+}
+
+TEST_F(RequestCoalescingFilterTest, KeyHeaders) {
+  setup("key_headers: [accept-encoding, authorization]");
+  std::unique_ptr<Stream> leader = createStream();
+  std::unique_ptr<Stream> waiter = createStream();
+  std::unique_ptr<Stream> other = createStream();
+  std::unique_ptr<Stream> empty = createStream();
+
+  Http::TestHeaderMapImpl headers{request_headers_};
+  headers.addCopy("accept-encoding", "gzip");
+  headers.addCopy("authorization", "secret");
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, leader->filter_.decodeHeaders(headers, true));
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration,
+            waiter->filter_.decodeHeaders(headers, true));
+  headers.remove(Http::LowerCaseString("accept-encoding"));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, other->filter_.decodeHeaders(headers, true));
+  headers.addCopy("accept-encoding", "");
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, empty->filter_.decodeHeaders(headers, true));
+  EXPECT_EQ(3U, counter("rq_leader"));
+  EXPECT_EQ(1U, counter("rq_coalesced"));
+}
+
+// Validate that the waiters are sent upstream on their own when the response sets a cookie.
+TEST_F(RequestCoalescingFilterTest, SetCookie) {
+  setup();
+  std::unique_ptr<Stream> leader = createStream();
+  std::unique_ptr<Stream> waiter = createStream();
+  leader->filter_.decodeHeaders(request_headers_, true);
+  waiter->filter_.decodeHeaders(request_headers_, true);
+
+  Event::PostCb post_cb;
+  EXPECT_CALL(leader->decoder_callbacks_.dispatcher_, post(_)).WillOnce(SaveArg<0>(&post_cb));
+  EXPECT_CALL(waiter->decoder_callbacks_, encodeHeaders_(_, _)).Times(0);
+  Http::TestHeaderMapImpl response_headers{{":status", "200"}, {"set-cookie", "session=1"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            leader->filter_.encodeHeaders(response_headers, true));
+
+  EXPECT_CALL(waiter->decoder_callbacks_, continueDecoding());
+  post_cb();
+  EXPECT_EQ(1U, counter("rq_released"));
+}
+
+// Validate that when the leader is destroyed early, the waiters that got part of the response are
+// reset and the others are sent upstream on their own.
+TEST_F(RequestCoalescingFilterTest, LeaderDestroyed) {
+  setup();
+  std::unique_ptr<Stream> leader = createStream();
+  std::unique_ptr<Stream> waiter = createStream();
+  leader->filter_.decodeHeaders(request_headers_, true);
+  waiter->filter_.decodeHeaders(request_headers_, true);
+
+  Event::PostCb post_cb;
+  EXPECT_CALL(leader->decoder_callbacks_.dispatcher_, post(_)).WillOnce(SaveArg<0>(&post_cb));
+  leader->filter_.onDestroy();
+
+  // A new leader is elected once the group is closed.
+  std::unique_ptr<Stream> next_leader = createStream();
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            next_leader->filter_.decodeHeaders(request_headers_, true));
+  std::unique_ptr<Stream> next_waiter = createStream();
+  std::unique_ptr<Stream> destroyed_waiter = createStream();
+  next_waiter->filter_.decodeHeaders(request_headers_, true);
+  destroyed_waiter->filter_.decodeHeaders(request_headers_, true);
+  destroyed_waiter->filter_.onDestroy();
+
+  EXPECT_CALL(waiter->decoder_callbacks_, continueDecoding());
+  post_cb();
+  EXPECT_EQ(1U, counter("rq_released"));
+
+  EXPECT_CALL(next_waiter->decoder_callbacks_, encodeHeaders_(_, false));
+  EXPECT_CALL(destroyed_waiter->decoder_callbacks_, encodeHeaders_(_, _)).Times(0);
+  next_leader->filter_.encodeHeaders(response_headers_, false);
+
+  EXPECT_CALL(next_leader->decoder_callbacks_.dispatcher_, post(_))
+      .WillOnce(SaveArg<0>(&post_cb));
+  next_leader->filter_.onDestroy();
+  EXPECT_CALL(next_waiter->decoder_callbacks_, resetStream());
+  post_cb();
+  EXPECT_EQ(1U, counter("rq_reset"));
+}
+
+} // namespace
+} // namespace RequestCoalescing
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
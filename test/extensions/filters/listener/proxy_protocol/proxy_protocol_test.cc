@@ -1,4 +1,5 @@
 #include <functional>
+#include <limits>
 #include <memory>
 #include <string>
 
@@ -6,6 +7,7 @@
 
 #include "common/buffer/buffer_impl.h"
 #include "common/event/dispatcher_impl.h"
+#include "common/network/connection_balancer_impl.h"
 #include "common/network/listen_socket_impl.h"
 #include "common/network/listener_impl.h"
 #include "common/network/raw_buffer_socket.h"
@@ -14,6 +16,7 @@
 #include "server/connection_handler_impl.h"
 
 #include "extensions/filters/listener/proxy_protocol/proxy_protocol.h"
+#include "extensions/filters/listener/well_known_names.h"
 
 #include "test/mocks/api/mocks.h"
 #include "test/mocks/buffer/mocks.h"
@@ -72,6 +75,12 @@ public:
   Stats::Scope& listenerScope() override { return stats_store_; }
   uint64_t listenerTag() const override { return 1; }
   const std::string& name() const override { return name_; }
+  Network::ConnectionBalancer& connectionBalancer() override { return connection_balancer_; }
+  uint32_t maxAcceptsPerWakeup() const override { return std::numeric_limits<uint32_t>::max(); }
+  uint32_t perConnectionReadBudgetBytes() const override { return 0; }
+  Network::Address::SocketType socketType() const override {
+    return Network::Address::SocketType::Stream;
+  }
 
   // Network::FilterChainManager
   const Network::FilterChain* findFilterChain(const Network::ConnectionSocket&) const override {
@@ -157,6 +166,7 @@ public:
   std::shared_ptr<Network::MockReadFilter> read_filter_;
   std::string name_;
   const Network::FilterChainSharedPtr filter_chain_;
+  Network::NopConnectionBalancerImpl connection_balancer_;
 };
 
 // Parameterize the listener socket address version.
@@ -480,6 +490,45 @@ TEST_P(ProxyProtocolTest, v2ParseExtensions) {
   disconnect();
 }
 
+TEST_P(ProxyProtocolTest, v2ExtensionsAsMetadata) {
+  // A well-formed ipv4/tcp header with authority, AWS VPC endpoint id and NOOP TLVs
+  constexpr uint8_t buffer[] = {0x0d, 0x0a, 0x0d, 0x0a, 0x00, 0x0d, 0x0a, 0x51, 0x55, 0x49,
+                                0x54, 0x0a, 0x21, 0x11, 0x00, 0x23, 0x01, 0x02, 0x03, 0x04,
+                                0x00, 0x01, 0x01, 0x02, 0x03, 0x05, 0x00, 0x02, 0x02, 0x00,
+                                0x07, 'f',  'o',  'o',  '.',  'c',  'o',  'm',  0xea, 0x00,
+                                0x05, 0x01, 'v',  'p',  'c',  'e',  0x04, 0x00, 0x02, 0x00,
+                                0x00, 'D',  'A',  'T',  'A'};
+  connect();
+  write(buffer, sizeof(buffer));
+  expectData("DATA");
+
+  const auto& filter_metadata = server_connection_->dynamicMetadata().filter_metadata();
+  const auto metadata = filter_metadata.find(ListenerFilterNames::get().ProxyProtocol);
+  ASSERT_NE(filter_metadata.end(), metadata);
+  const auto& fields = metadata->second.fields();
+  EXPECT_EQ(2, fields.size());
+  EXPECT_EQ("foo.com", fields.at("authority").string_value());
+  EXPECT_EQ("vpce", fields.at("aws_vpce_id").string_value());
+  EXPECT_EQ(server_connection_->remoteAddress()->ip()->addressAsString(), "1.2.3.4");
+
+  disconnect();
+}
+
+TEST_P(ProxyProtocolTest, v2NoMetadataWithoutKnownExtensions) {
+  // The TLVs of v2ParseExtensions are all unknown, so no metadata is set.
+  constexpr uint8_t buffer[] = {0x0d, 0x0a, 0x0d, 0x0a, 0x00, 0x0d, 0x0a, 0x51, 0x55, 0x49,
+                                0x54, 0x0a, 0x21, 0x11, 0x00, 0x14, 0x01, 0x02, 0x03, 0x04,
+                                0x00, 0x01, 0x01, 0x02, 0x03, 0x05, 0x00, 0x02, 0x0,  0x0,
+                                0x1,  0xff, 0x0,  0x0,  0x1,  0xff, 'D',  'A',  'T',  'A'};
+  connect();
+  write(buffer, sizeof(buffer));
+  expectData("DATA");
+
+  EXPECT_EQ(0, server_connection_->dynamicMetadata().filter_metadata_size());
+
+  disconnect();
+}
+
 TEST_P(ProxyProtocolTest, v2ParseExtensionsIoctlError) {
   // A well-formed ipv4/tcp with a TLV extension. An error is created in the ioctl(...FIONREAD...)
   constexpr uint8_t buffer[] = {0x0d, 0x0a, 0x0d, 0x0a, 0x00, 0x0d, 0x0a, 0x51, 0x55, 0x49,
@@ -894,6 +943,12 @@ public:
   Stats::Scope& listenerScope() override { return stats_store_; }
   uint64_t listenerTag() const override { return 1; }
   const std::string& name() const override { return name_; }
+  Network::ConnectionBalancer& connectionBalancer() override { return connection_balancer_; }
+  uint32_t maxAcceptsPerWakeup() const override { return std::numeric_limits<uint32_t>::max(); }
+  uint32_t perConnectionReadBudgetBytes() const override { return 0; }
+  Network::Address::SocketType socketType() const override {
+    return Network::Address::SocketType::Stream;
+  }
 
   // Network::FilterChainManager
   const Network::FilterChain* findFilterChain(const Network::ConnectionSocket&) const override {
@@ -957,6 +1012,7 @@ public:
   std::shared_ptr<Network::MockReadFilter> read_filter_;
   std::string name_;
   const Network::FilterChainSharedPtr filter_chain_;
+  Network::NopConnectionBalancerImpl connection_balancer_;
 };
 
 // Parameterize the listener socket address version.
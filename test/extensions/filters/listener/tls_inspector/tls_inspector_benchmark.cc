@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <vector>
 
 #include "common/network/listen_socket_impl.h"
@@ -98,6 +99,34 @@ static void BM_TlsInspector(benchmark::State& state) {
 
 BENCHMARK(BM_TlsInspector)->Unit(benchmark::kMicrosecond);
 
+// The ClientHello parser alone, fed the whole ClientHello at once (argument 0), or as received by
+// reads of the given number of bytes from a slow client.
+static void BM_ClientHelloParser(benchmark::State& state) {
+  const std::vector<uint8_t> client_hello =
+      Tls::Test::generateClientHello("example.com", "\x02h2\x08http/1.1");
+  const size_t read_size = state.range(0) == 0 ? client_hello.size() : state.range(0);
+  uint64_t bytes_parsed = 0;
+
+  for (auto _ : state) {
+    ClientHelloParser parser;
+    size_t len = 0;
+    ClientHelloParser::Result result;
+    do {
+      len = std::min(len + read_size, client_hello.size());
+      result = parser.parse(client_hello.data(), len);
+    } while (result == ClientHelloParser::Result::NeedMoreData);
+    RELEASE_ASSERT(result == ClientHelloParser::Result::ClientHello, "");
+    RELEASE_ASSERT(parser.serverName() == "example.com", "");
+    bytes_parsed += parser.bytesParsed();
+  }
+
+  // The parser stops once it has found both extensions, before the end of the ClientHello.
+  state.counters["client_hello_bytes"] = client_hello.size();
+  state.counters["bytes_parsed"] = bytes_parsed / state.iterations();
+}
+
+BENCHMARK(BM_ClientHelloParser)->Arg(0)->Arg(64)->Arg(1)->Unit(benchmark::kMicrosecond);
+
 } // namespace TlsInspector
 } // namespace ListenerFilters
 } // namespace Extensions
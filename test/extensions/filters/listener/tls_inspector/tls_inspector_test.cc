@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "extensions/filters/listener/tls_inspector/tls_inspector.h"
 
 #include "test/mocks/api/mocks.h"
@@ -6,11 +8,13 @@
 #include "test/test_common/threadsafe_singleton_injector.h"
 #include "test/test_common/tls_utility.h"
 
+#include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "openssl/ssl.h"
 
 using testing::_;
 using testing::AtLeast;
+using testing::ElementsAre;
 using testing::Eq;
 using testing::InSequence;
 using testing::Invoke;
@@ -233,6 +237,94 @@ TEST_F(TlsInspectorTest, NotSsl) {
   EXPECT_EQ(1, cfg_->stats().tls_not_found_.value());
 }
 
+// Splits the handshake message of a single record ClientHello into records of at most
+// fragment_size bytes.
+std::vector<uint8_t> fragmentClientHello(const std::vector<uint8_t>& client_hello,
+                                         size_t fragment_size) {
+  const size_t header_size = ClientHelloParser::RecordHeaderSize;
+  std::vector<uint8_t> records;
+  for (size_t begin = header_size; begin < client_hello.size(); begin += fragment_size) {
+    const size_t length = std::min(fragment_size, client_hello.size() - begin);
+    records.insert(records.end(), client_hello.begin(), client_hello.begin() + 3);
+    records.push_back(length >> 8);
+    records.push_back(length & 0xff);
+    records.insert(records.end(), client_hello.begin() + begin,
+                   client_hello.begin() + begin + length);
+  }
+  return records;
+}
+
+// Test that the parser resumes where it stopped when fed a ClientHello a byte at a time.
+TEST(ClientHelloParserTest, Incremental) {
+  std::vector<uint8_t> client_hello =
+      Tls::Test::generateClientHello("example.com", "\x02h2\x08http/1.1");
+  ClientHelloParser parser;
+  size_t len = 0;
+  while (parser.parse(client_hello.data(), len) == ClientHelloParser::Result::NeedMoreData) {
+    ASSERT_LT(len, client_hello.size());
+    len++;
+  }
+  EXPECT_EQ(ClientHelloParser::Result::ClientHello, parser.parse(client_hello.data(), len));
+  EXPECT_EQ("example.com", parser.serverName());
+  EXPECT_TRUE(parser.alpnFound());
+  EXPECT_THAT(parser.applicationProtocols(), ElementsAre("h2", "http/1.1"));
+}
+
+// Test that the parser stops as soon as it has found both the SNI and ALPN extensions.
+TEST(ClientHelloParserTest, EarlyExit) {
+  std::vector<uint8_t> client_hello = Tls::Test::generateClientHello("example.com", "\x02h2");
+  ClientHelloParser parser;
+  EXPECT_EQ(ClientHelloParser::Result::ClientHello,
+            parser.parse(client_hello.data(), client_hello.size()));
+  EXPECT_LT(parser.bytesParsed() + ClientHelloParser::RecordHeaderSize, client_hello.size());
+}
+
+// Test a ClientHello fragmented over several records, fed a byte at a time.
+TEST(ClientHelloParserTest, Fragmented) {
+  std::vector<uint8_t> client_hello = fragmentClientHello(
+      Tls::Test::generateClientHello("example.com", "\x02h2\x08http/1.1"), 7);
+  ClientHelloParser parser;
+  for (size_t len = 0; len < client_hello.size(); len++) {
+    if (parser.parse(client_hello.data(), len) != ClientHelloParser::Result::NeedMoreData) {
+      break;
+    }
+  }
+  EXPECT_EQ(ClientHelloParser::Result::ClientHello,
+            parser.parse(client_hello.data(), client_hello.size()));
+  EXPECT_EQ("example.com", parser.serverName());
+  EXPECT_THAT(parser.applicationProtocols(), ElementsAre("h2", "http/1.1"));
+}
+
+// Test that a truncated handshake message and a malformed SNI extension are not a ClientHello.
+TEST(ClientHelloParserTest, Malformed) {
+  std::vector<uint8_t> client_hello = Tls::Test::generateClientHello("example.com", "");
+  {
+    // Shrink the handshake message so that its extensions overflow it.
+    std::vector<uint8_t> truncated = client_hello;
+    const size_t length_offset = ClientHelloParser::RecordHeaderSize + 1;
+    const uint32_t length = ((truncated[length_offset] << 16) |
+                             (truncated[length_offset + 1] << 8) | truncated[length_offset + 2]) -
+                            1;
+    truncated[length_offset] = length >> 16;
+    truncated[length_offset + 1] = (length >> 8) & 0xff;
+    truncated[length_offset + 2] = length & 0xff;
+    ClientHelloParser parser;
+    EXPECT_EQ(ClientHelloParser::Result::NotClientHello,
+              parser.parse(truncated.data(), truncated.size()));
+  }
+  {
+    // Replace the name type of the SNI extension.
+    std::vector<uint8_t> malformed = client_hello;
+    const std::string name("example.com");
+    auto it = std::search(malformed.begin(), malformed.end(), name.begin(), name.end());
+    ASSERT_NE(it, malformed.end());
+    *(it - 3) = 1;
+    ClientHelloParser parser;
+    EXPECT_EQ(ClientHelloParser::Result::NotClientHello,
+              parser.parse(malformed.data(), malformed.size()));
+  }
+}
+
 } // namespace TlsInspector
 } // namespace ListenerFilters
 } // namespace Extensions
@@ -0,0 +1,42 @@
+#include "envoy/config/filter/network/dynamic_module/v2alpha/dynamic_module.pb.validate.h"
+
+#include "extensions/filters/network/dynamic_module/config.h"
+
+#include "test/mocks/server/mocks.h"
+#include "test/test_common/environment.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Extensions {
+namespace NetworkFilters {
+namespace DynamicModuleFilter {
+
+TEST(DynamicModuleConfigTest, ValidateFail) {
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+  EXPECT_THROW(DynamicModuleConfigFactory().createFilterFactoryFromProto(
+                   envoy::config::filter::network::dynamic_module::v2alpha::DynamicModule(),
+                   context),
+               ProtoValidationException);
+}
+
+TEST(DynamicModuleConfigTest, DynamicModuleCorrectProto) {
+  envoy::config::filter::network::dynamic_module::v2alpha::DynamicModule proto_config;
+  proto_config.set_path(TestEnvironment::runfilesPath(
+      "test/extensions/filters/common/dynamic_module/libtest_module.so"));
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+  DynamicModuleConfigFactory factory;
+  Network::FilterFactoryCb cb = factory.createFilterFactoryFromProto(proto_config, context);
+  Network::MockConnection connection;
+  EXPECT_CALL(connection, addFilter(_));
+  cb(connection);
+}
+
+} // namespace DynamicModuleFilter
+} // namespace NetworkFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,62 @@
+#include <memory>
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+
+#include "extensions/filters/network/dynamic_module/dynamic_module_filter.h"
+
+#include "test/mocks/network/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/environment.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Extensions {
+namespace NetworkFilters {
+namespace DynamicModuleFilter {
+
+class DynamicModuleFilterTest : public testing::Test {
+public:
+  DynamicModuleFilterTest()
+      : module_(std::make_shared<Filters::Common::DynamicModule::Module>(
+            TestEnvironment::runfilesPath(
+                "test/extensions/filters/common/dynamic_module/libtest_module.so"),
+            "", tls_)),
+        filter_(module_) {
+    filter_.initializeReadFilterCallbacks(read_callbacks_);
+  }
+
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  Filters::Common::DynamicModule::ModuleSharedPtr module_;
+  Filter filter_;
+  NiceMock<Network::MockReadFilterCallbacks> read_callbacks_;
+};
+
+TEST_F(DynamicModuleFilterTest, Continue) {
+  EXPECT_EQ(Network::FilterStatus::Continue, filter_.onNewConnection());
+  Buffer::OwnedImpl data("hello");
+  EXPECT_EQ(Network::FilterStatus::Continue, filter_.onData(data, false));
+  // The module doesn't export the callback of the data written.
+  EXPECT_EQ(Network::FilterStatus::Continue, filter_.onWrite(data, false));
+}
+
+// The module closes the connection, and doesn't see the data anymore.
+TEST_F(DynamicModuleFilterTest, CloseConnection) {
+  EXPECT_CALL(read_callbacks_.connection_, close(Network::ConnectionCloseType::NoFlush));
+  Buffer::OwnedImpl data("close now");
+  EXPECT_EQ(Network::FilterStatus::StopIteration, filter_.onData(data, false));
+
+  Buffer::OwnedImpl more_data("close again");
+  EXPECT_EQ(Network::FilterStatus::StopIteration, filter_.onData(more_data, true));
+  EXPECT_EQ(Network::FilterStatus::StopIteration, filter_.onWrite(more_data, false));
+}
+
+} // namespace DynamicModuleFilter
+} // namespace NetworkFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -17,6 +17,7 @@
 
 using testing::_;
 using testing::ContainerEq;
+using testing::Invoke;
 using testing::Return;
 
 namespace Envoy {
@@ -427,6 +428,30 @@ TEST_F(FilterChainTest, createFilterChain) {
   config.createFilterChain(callbacks);
 }
 
+// The filters of the streams sampled for filter timing are wrapped in timed filters.
+TEST_F(FilterChainTest, createTimedFilterChain) {
+  auto hcm_config = parseHttpConnectionManagerFromJson(basic_config_);
+  hcm_config.mutable_filter_timing_sampling()->set_value(1);
+  HttpConnectionManagerConfig config(hcm_config, context_, date_provider_,
+                                     route_config_provider_manager_);
+
+  for (const bool sampled : {true, false}) {
+    EXPECT_CALL(context_.runtime_loader_.snapshot_,
+                featureEnabled("http_connection_manager.filter_timing_sampling", 100, _, 10000))
+        .WillOnce(Return(sampled));
+    Http::MockFilterChainFactoryCallbacks callbacks;
+    EXPECT_CALL(callbacks, addStreamFilter(_))
+        .WillOnce(Invoke([sampled](Http::StreamFilterSharedPtr filter) -> void {
+          EXPECT_EQ(sampled, dynamic_cast<TimedStreamFilter*>(filter.get()) != nullptr);
+        }));
+    EXPECT_CALL(callbacks, addStreamDecoderFilter(_))
+        .WillOnce(Invoke([sampled](Http::StreamDecoderFilterSharedPtr filter) -> void {
+          EXPECT_EQ(sampled, dynamic_cast<TimedStreamFilter*>(filter.get()) != nullptr);
+        }));
+    config.createFilterChain(callbacks);
+  }
+}
+
 TEST_F(FilterChainTest, createUpgradeFilterChain) {
   auto hcm_config = parseHttpConnectionManagerFromJson(basic_config_);
   hcm_config.add_upgrade_configs()->set_upgrade_type("websocket");
@@ -0,0 +1,135 @@
+#include "common/buffer/buffer_impl.h"
+
+#include "extensions/filters/network/http_connection_manager/filter_timing.h"
+
+#include "test/mocks/common.h"
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/stats/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+using testing::SaveArg;
+
+namespace Envoy {
+namespace Extensions {
+namespace NetworkFilters {
+namespace HttpConnectionManager {
+namespace {
+
+class FilterTimingTest : public testing::Test {
+public:
+  FilterTimingTest() : stats_{decode_time_us_, encode_time_us_} {}
+
+  // Each call to the time source moves the time forward by 5us.
+  void expectTimedCall(Stats::MockHistogram& histogram) {
+    EXPECT_CALL(time_source_, monotonicTime())
+        .WillOnce(Return(MonotonicTime(std::chrono::microseconds(10))))
+        .WillOnce(Return(MonotonicTime(std::chrono::microseconds(15))));
+    EXPECT_CALL(histogram, recordValue(5));
+  }
+
+  NiceMock<Stats::MockHistogram> decode_time_us_;
+  NiceMock<Stats::MockHistogram> encode_time_us_;
+  FilterTimingStats stats_;
+  MockTimeSource time_source_;
+};
+
+TEST_F(FilterTimingTest, DecoderFilter) {
+  auto filter = std::make_shared<NiceMock<Http::MockStreamDecoderFilter>>();
+  TimedStreamFilter timed_filter(filter, nullptr, stats_, time_source_);
+
+  Http::TestHeaderMapImpl headers;
+  expectTimedCall(decode_time_us_);
+  EXPECT_CALL(*filter, decodeHeaders(_, true))
+      .WillOnce(Return(Http::FilterHeadersStatus::StopIteration));
+  EXPECT_EQ(Http::FilterHeadersStatus::StopIteration, timed_filter.decodeHeaders(headers, true));
+
+  Buffer::OwnedImpl data;
+  expectTimedCall(decode_time_us_);
+  EXPECT_CALL(*filter, decodeData(_, false))
+      .WillOnce(Return(Http::FilterDataStatus::StopIterationAndBuffer));
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationAndBuffer, timed_filter.decodeData(data, false));
+
+  expectTimedCall(decode_time_us_);
+  EXPECT_CALL(*filter, decodeTrailers(_)).WillOnce(Return(Http::FilterTrailersStatus::Continue));
+  EXPECT_EQ(Http::FilterTrailersStatus::Continue, timed_filter.decodeTrailers(headers));
+
+  // The filter is given the callbacks of the stream itself.
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> callbacks;
+  EXPECT_CALL(*filter, setDecoderFilterCallbacks(_))
+      .WillOnce(Invoke([&](Http::StreamDecoderFilterCallbacks& filter_callbacks) -> void {
+        EXPECT_EQ(&callbacks, &filter_callbacks);
+      }));
+  timed_filter.setDecoderFilterCallbacks(callbacks);
+
+  EXPECT_CALL(*filter, onDestroy());
+  timed_filter.onDestroy();
+}
+
+TEST_F(FilterTimingTest, EncoderFilter) {
+  auto filter = std::make_shared<NiceMock<Http::MockStreamEncoderFilter>>();
+  TimedStreamFilter timed_filter(nullptr, filter, stats_, time_source_);
+
+  Http::TestHeaderMapImpl headers;
+  expectTimedCall(encode_time_us_);
+  EXPECT_CALL(*filter, encode100ContinueHeaders(_))
+      .WillOnce(Return(Http::FilterHeadersStatus::Continue));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, timed_filter.encode100ContinueHeaders(headers));
+
+  expectTimedCall(encode_time_us_);
+  EXPECT_CALL(*filter, encodeHeaders(_, false))
+      .WillOnce(Return(Http::FilterHeadersStatus::Continue));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, timed_filter.encodeHeaders(headers, false));
+
+  Buffer::OwnedImpl data;
+  expectTimedCall(encode_time_us_);
+  EXPECT_CALL(*filter, encodeData(_, true)).WillOnce(Return(Http::FilterDataStatus::Continue));
+  EXPECT_EQ(Http::FilterDataStatus::Continue, timed_filter.encodeData(data, true));
+
+  expectTimedCall(encode_time_us_);
+  EXPECT_CALL(*filter, encodeTrailers(_)).WillOnce(Return(Http::FilterTrailersStatus::Continue));
+  EXPECT_EQ(Http::FilterTrailersStatus::Continue, timed_filter.encodeTrailers(headers));
+
+  EXPECT_CALL(*filter, onDestroy());
+  timed_filter.onDestroy();
+}
+
+// The filters added through the timed callbacks are wrapped and timed with the stats set last.
+TEST_F(FilterTimingTest, FilterChainFactoryCallbacks) {
+  Http::MockFilterChainFactoryCallbacks callbacks;
+  TimedFilterChainFactoryCallbacks timed_callbacks(callbacks, time_source_);
+  timed_callbacks.setStats(stats_);
+
+  auto filter = std::make_shared<NiceMock<Http::MockStreamFilter>>();
+  Http::StreamFilterSharedPtr added_filter;
+  EXPECT_CALL(callbacks, addStreamFilter(_)).WillOnce(SaveArg<0>(&added_filter));
+  timed_callbacks.addStreamFilter(filter);
+  ASSERT_NE(nullptr, dynamic_cast<TimedStreamFilter*>(added_filter.get()));
+
+  Http::TestHeaderMapImpl headers;
+  expectTimedCall(decode_time_us_);
+  EXPECT_CALL(*filter, decodeHeaders(_, false));
+  added_filter->decodeHeaders(headers, false);
+  expectTimedCall(encode_time_us_);
+  EXPECT_CALL(*filter, encodeHeaders(_, false));
+  added_filter->encodeHeaders(headers, false);
+
+  // A dual filter is destroyed once.
+  EXPECT_CALL(*filter, onDestroy());
+  added_filter->onDestroy();
+
+  EXPECT_CALL(callbacks, arena()).WillOnce(Return(nullptr));
+  EXPECT_EQ(nullptr, timed_callbacks.arena());
+}
+
+} // namespace
+} // namespace HttpConnectionManager
+} // namespace NetworkFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,99 @@
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "common/stats/isolated_store_impl.h"
+
+#include "extensions/filters/network/local_ratelimit/local_ratelimit.h"
+
+#include "test/mocks/common.h"
+#include "test/mocks/network/mocks.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::NiceMock;
+using testing::Return;
+using testing::ReturnPointee;
+
+namespace Envoy {
+namespace Extensions {
+namespace NetworkFilters {
+namespace LocalRateLimitFilter {
+
+class LocalRateLimitFilterTest : public testing::Test {
+public:
+  LocalRateLimitFilterTest() {
+    ON_CALL(runtime_.snapshot_, featureEnabled("local_ratelimit.tcp_filter_enabled", 100))
+        .WillByDefault(Return(true));
+    ON_CALL(runtime_.snapshot_, featureEnabled("local_ratelimit.tcp_filter_enforcing", 100))
+        .WillByDefault(Return(true));
+    ON_CALL(time_source_, monotonicTime()).WillByDefault(ReturnPointee(&now_));
+
+    const std::string yaml = R"EOF(
+    stat_prefix: name
+    token_bucket:
+      max_tokens: 1
+      fill_interval: 1s
+    )EOF";
+    envoy::config::filter::network::local_rate_limit::v2alpha::LocalRateLimit proto_config;
+    MessageUtil::loadFromYaml(yaml, proto_config);
+    config_ = std::make_shared<Config>(proto_config, stats_store_, runtime_, time_source_);
+  }
+
+  Network::FilterStatus onNewConnection() {
+    Filter filter(config_);
+    filter.initializeReadFilterCallbacks(read_callbacks_);
+    return filter.onNewConnection();
+  }
+
+  uint64_t counter(const std::string& name) {
+    return stats_store_.counter("local_ratelimit.name." + name).value();
+  }
+
+  MonotonicTime now_{std::chrono::seconds(100)};
+  NiceMock<MockTimeSource> time_source_;
+  Stats::IsolatedStoreImpl stats_store_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<Network::MockReadFilterCallbacks> read_callbacks_;
+  ConfigSharedPtr config_;
+};
+
+TEST_F(LocalRateLimitFilterTest, RateLimited) {
+  EXPECT_EQ(Network::FilterStatus::Continue, onNewConnection());
+  EXPECT_EQ(1U, counter("ok"));
+
+  EXPECT_CALL(read_callbacks_.connection_, close(Network::ConnectionCloseType::NoFlush));
+  EXPECT_EQ(Network::FilterStatus::StopIteration, onNewConnection());
+  EXPECT_EQ(1U, counter("rate_limited"));
+
+  now_ += std::chrono::seconds(1);
+  EXPECT_EQ(Network::FilterStatus::Continue, onNewConnection());
+  EXPECT_EQ(2U, counter("ok"));
+}
+
+TEST_F(LocalRateLimitFilterTest, NotEnforcing) {
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled("local_ratelimit.tcp_filter_enforcing", 100))
+      .WillOnce(Return(false));
+  EXPECT_CALL(read_callbacks_.connection_, close(_)).Times(0);
+  EXPECT_EQ(Network::FilterStatus::Continue, onNewConnection());
+  EXPECT_EQ(Network::FilterStatus::Continue, onNewConnection());
+  EXPECT_EQ(1U, counter("rate_limited"));
+}
+
+TEST_F(LocalRateLimitFilterTest, RuntimeDisabled) {
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled("local_ratelimit.tcp_filter_enabled", 100))
+      .WillRepeatedly(Return(false));
+  EXPECT_EQ(Network::FilterStatus::Continue, onNewConnection());
+  EXPECT_EQ(Network::FilterStatus::Continue, onNewConnection());
+  EXPECT_EQ(0U, counter("ok"));
+  EXPECT_EQ(0U, counter("rate_limited"));
+}
+
+} // namespace LocalRateLimitFilter
+} // namespace NetworkFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -11,7 +11,9 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+using testing::_;
 using testing::Eq;
+using testing::Invoke;
 using testing::NiceMock;
 using testing::Pointee;
 
@@ -165,6 +167,48 @@ TEST_F(MongoCodecImplTest, Reply) {
   decoder_.onData(output_);
 }
 
+TEST_F(MongoCodecImplTest, ReplySkipDocuments) {
+  ReplyMessageImpl reply(2, 2);
+  reply.cursorId(20000);
+  reply.numberReturned(2);
+  reply.documents().push_back(Bson::DocumentImpl::create()->addString("hello", "world"));
+  reply.documents().push_back(Bson::DocumentImpl::create());
+  EXPECT_EQ(2U, reply.documentCount());
+  EXPECT_EQ(27U, reply.documentsByteSize());
+
+  DecoderImpl decoder(callbacks_, true);
+  encoder_.encodeReply(reply);
+  encoder_.encodeReply(reply);
+  EXPECT_CALL(callbacks_, decodeReply_(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([](ReplyMessagePtr& message) {
+        EXPECT_EQ(20000, message->cursorId());
+        EXPECT_EQ(2, message->numberReturned());
+        EXPECT_TRUE(message->documents().empty());
+        EXPECT_EQ(2U, message->documentCount());
+        EXPECT_EQ(27U, message->documentsByteSize());
+        EXPECT_NO_THROW(Json::Factory::loadFromString(message->toString(true)));
+      }));
+  decoder.onData(output_);
+  EXPECT_EQ(0U, output_.length());
+}
+
+TEST_F(MongoCodecImplTest, ReplySkipDocumentsInvalidLength) {
+  DecoderImpl decoder(callbacks_, true);
+  ReplyMessageImpl reply(2, 2);
+  reply.numberReturned(1);
+  reply.documents().push_back(Bson::DocumentImpl::create());
+  encoder_.encodeReply(reply);
+
+  // Make the document claim to extend past the end of the message.
+  Buffer::OwnedImpl data;
+  data.move(output_, output_.length() - 5);
+  Bson::BufferHelper::writeInt32(data, 6);
+  output_.drain(sizeof(int32_t));
+  data.move(output_);
+  EXPECT_THROW(decoder.onData(data), EnvoyException);
+}
+
 TEST_F(MongoCodecImplTest, GetMoreEqual) {
   {
     GetMoreMessageImpl g1(0, 0);
@@ -0,0 +1,128 @@
+#include <string>
+#include <vector>
+
+#include "extensions/filters/network/redis_proxy/cluster_slots.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace NetworkFilters {
+namespace RedisProxy {
+
+namespace {
+
+RespValue makeInteger(int64_t integer) {
+  RespValue value;
+  value.type(RespType::Integer);
+  value.asInteger() = integer;
+  return value;
+}
+
+RespValue makeBulkString(const std::string& string) {
+  RespValue value;
+  value.type(RespType::BulkString);
+  value.asString() = string;
+  return value;
+}
+
+RespValue makeArray(std::vector<RespValue>&& values) {
+  RespValue value;
+  value.type(RespType::Array);
+  value.asArray().swap(values);
+  return value;
+}
+
+RespValue makeRange(int64_t start, int64_t end, const std::string& ip, int64_t port) {
+  return makeArray({makeInteger(start), makeInteger(end),
+                    makeArray({makeBulkString(ip), makeInteger(port), makeBulkString("id")}),
+                    makeArray({makeBulkString("10.0.0.9"), makeInteger(7000)})});
+}
+
+} // namespace
+
+TEST(ClusterSlotMapTest, KeySlot) {
+  EXPECT_EQ(12739, ClusterSlotMap::keySlot("123456789"));
+  EXPECT_EQ(12182, ClusterSlotMap::keySlot("foo"));
+  EXPECT_EQ(5061, ClusterSlotMap::keySlot("bar"));
+  EXPECT_EQ(0, ClusterSlotMap::keySlot(""));
+}
+
+TEST(ClusterSlotMapTest, KeySlotHashTag) {
+  EXPECT_EQ(ClusterSlotMap::keySlot("user1000"),
+            ClusterSlotMap::keySlot("{user1000}.following"));
+  EXPECT_EQ(ClusterSlotMap::keySlot("user1000"), ClusterSlotMap::keySlot("a{user1000}{b}"));
+  EXPECT_EQ(ClusterSlotMap::keySlot("{bar"), ClusterSlotMap::keySlot("foo{{bar}}zap"));
+  // Empty or unterminated hash tags are part of the hashed key.
+  EXPECT_NE(ClusterSlotMap::keySlot("bar"), ClusterSlotMap::keySlot("foo{}{bar}"));
+  EXPECT_NE(ClusterSlotMap::keySlot("bar"), ClusterSlotMap::keySlot("foo{bar"));
+}
+
+TEST(ClusterSlotMapTest, ParseRedirection) {
+  ClusterRedirection redirection;
+  EXPECT_TRUE(ClusterSlotMap::parseRedirection("MOVED 3999 127.0.0.1:6381", redirection));
+  EXPECT_FALSE(redirection.ask_);
+  EXPECT_EQ(3999, redirection.slot_);
+  EXPECT_EQ("127.0.0.1:6381", redirection.address_);
+
+  EXPECT_TRUE(ClusterSlotMap::parseRedirection("ASK 1 ::1:6379", redirection));
+  EXPECT_TRUE(redirection.ask_);
+  EXPECT_EQ(1, redirection.slot_);
+  EXPECT_EQ("[::1]:6379", redirection.address_);
+
+  EXPECT_FALSE(ClusterSlotMap::parseRedirection("ERR unknown command", redirection));
+  EXPECT_FALSE(ClusterSlotMap::parseRedirection("MOVED 16384 127.0.0.1:6381", redirection));
+  EXPECT_FALSE(ClusterSlotMap::parseRedirection("MOVED 1 127.0.0.1", redirection));
+  EXPECT_FALSE(ClusterSlotMap::parseRedirection("MOVED a 127.0.0.1:6381", redirection));
+  EXPECT_FALSE(ClusterSlotMap::parseRedirection("MOVED 1 127.0.0.1:6381 x", redirection));
+}
+
+TEST(ClusterSlotMapTest, Update) {
+  ClusterSlotMap map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(nullptr, map.address(0));
+
+  EXPECT_TRUE(map.update(makeArray({makeRange(0, 5460, "10.0.0.1", 7000),
+                                    makeRange(5461, 10922, "10.0.0.2", 7001),
+                                    makeRange(10923, 16383, "", 7002)})));
+  EXPECT_FALSE(map.empty());
+  EXPECT_EQ("10.0.0.1:7000", *map.address(0));
+  EXPECT_EQ("10.0.0.1:7000", *map.address(5460));
+  EXPECT_EQ("10.0.0.2:7001", *map.address(5461));
+  EXPECT_EQ("10.0.0.2:7001", *map.address(10922));
+  // The primary of the last range doesn't report its IP.
+  EXPECT_EQ(nullptr, map.address(10923));
+
+  map.update(10923, "10.0.0.3:7002");
+  EXPECT_EQ("10.0.0.3:7002", *map.address(10923));
+  map.update(0, "10.0.0.2:7001");
+  EXPECT_EQ("10.0.0.2:7001", *map.address(0));
+  EXPECT_EQ("10.0.0.1:7000", *map.address(1));
+
+  // A full update replaces the whole map.
+  EXPECT_TRUE(map.update(makeArray({makeRange(0, 16383, "::1", 7000)})));
+  EXPECT_EQ("[::1]:7000", *map.address(0));
+  EXPECT_EQ("[::1]:7000", *map.address(16383));
+}
+
+TEST(ClusterSlotMapTest, UpdateInvalid) {
+  ClusterSlotMap map;
+  EXPECT_TRUE(map.update(makeArray({makeRange(0, 16383, "10.0.0.1", 7000)})));
+
+  EXPECT_FALSE(map.update(makeBulkString("slots")));
+  EXPECT_FALSE(map.update(makeArray({makeRange(0, 16384, "10.0.0.2", 7000)})));
+  EXPECT_FALSE(map.update(makeArray({makeRange(10, 9, "10.0.0.2", 7000)})));
+  EXPECT_FALSE(map.update(makeArray({makeRange(0, 1, "10.0.0.2", -1)})));
+  EXPECT_FALSE(map.update(makeArray({makeRange(0, 1, "10.0.0.2", 7000), makeInteger(1)})));
+  EXPECT_FALSE(map.update(
+      makeArray({makeArray({makeInteger(0), makeInteger(1), makeBulkString("10.0.0.2")})})));
+
+  // The map is left unchanged.
+  EXPECT_EQ("10.0.0.1:7000", *map.address(0));
+  EXPECT_EQ("10.0.0.1:7000", *map.address(16383));
+}
+
+} // namespace RedisProxy
+} // namespace NetworkFilters
+} // namespace Extensions
+} // namespace Envoy
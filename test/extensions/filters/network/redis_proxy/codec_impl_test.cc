@@ -2,6 +2,7 @@
 
 #include "common/buffer/buffer_impl.h"
 #include "common/common/assert.h"
+#include "common/common/fmt.h"
 
 #include "extensions/filters/network/redis_proxy/codec_impl.h"
 
@@ -128,6 +129,82 @@ TEST_F(RedisEncoderDecoderImplTest, Array) {
   EXPECT_EQ(0UL, buffer_.length());
 }
 
+TEST_F(RedisEncoderDecoderImplTest, SimpleStringAcrossSlices) {
+  buffer_.add("+simple ");
+  decoder_.decode(buffer_);
+  EXPECT_TRUE(decoded_values_.empty());
+  buffer_.add("string\r");
+  decoder_.decode(buffer_);
+  EXPECT_TRUE(decoded_values_.empty());
+  buffer_.add("\n");
+  decoder_.decode(buffer_);
+  EXPECT_EQ("simple string", decoded_values_[0]->asString());
+}
+
+TEST_F(RedisEncoderDecoderImplTest, SmallBulkStringCopied) {
+  buffer_.add("$5\r\nhello\r\n");
+  decoder_.decode(buffer_);
+  EXPECT_EQ(nullptr, decoded_values_[0]->pinnedOwner());
+  EXPECT_EQ("hello", decoded_values_[0]->asStringView());
+}
+
+TEST_F(RedisEncoderDecoderImplTest, LargeBulkStringPinned) {
+  const std::string large(2048, 'a');
+  buffer_.add(fmt::format("*2\r\n${}\r\n{}\r\n$5\r\nhello\r\n", large.size(), large));
+  decoder_.decode(buffer_);
+  EXPECT_EQ(0UL, buffer_.length());
+
+  // The value stays valid after the decoded buffer is drained and reused.
+  buffer_.add(std::string(4096, 'b'));
+  buffer_.drain(buffer_.length());
+  const RespValue& pinned = decoded_values_[0]->asArray()[0];
+  EXPECT_NE(nullptr, pinned.pinnedOwner());
+  EXPECT_EQ(large, pinned.asStringView());
+  EXPECT_EQ("hello", decoded_values_[0]->asArray()[1].asStringView());
+
+  // The pinned value is referenced by the encoded buffer rather than copied.
+  encoder_.encode(*decoded_values_[0], buffer_);
+  EXPECT_EQ(fmt::format("*2\r\n${}\r\n{}\r\n$5\r\nhello\r\n", large.size(), large),
+            buffer_.toString());
+  decoded_values_.clear();
+  decoder_.decode(buffer_);
+  EXPECT_EQ(large, decoded_values_[0]->asArray()[0].asStringView());
+
+  // Accessing the string for modification copies it and unpins it.
+  RespValue& value = decoded_values_[0]->asArray()[0];
+  value.asString().push_back('c');
+  EXPECT_EQ(nullptr, value.pinnedOwner());
+  EXPECT_EQ(large + "c", value.asStringView());
+}
+
+TEST_F(RedisEncoderDecoderImplTest, Copy) {
+  const std::string large(2048, 'a');
+  buffer_.add(fmt::format("*3\r\n${}\r\n{}\r\n:5\r\n+OK\r\n", large.size(), large));
+  decoder_.decode(buffer_);
+
+  RespValue copy(*decoded_values_[0]);
+  EXPECT_EQ(*decoded_values_[0], copy);
+  // The pinned string shares the pinned memory.
+  EXPECT_EQ(decoded_values_[0]->asArray()[0].pinnedOwner(), copy.asArray()[0].pinnedOwner());
+  EXPECT_EQ(decoded_values_[0]->asArray()[0].asStringView().data(),
+            copy.asArray()[0].asStringView().data());
+
+  copy.asArray()[2].asString() = "KO";
+  EXPECT_EQ("OK", decoded_values_[0]->asArray()[2].asString());
+  copy = copy.asArray()[1];
+  EXPECT_EQ(5, copy.asInteger());
+}
+
+TEST_F(RedisEncoderDecoderImplTest, LargeBulkStringAcrossSlices) {
+  const std::string large(2048, 'a');
+  buffer_.add(fmt::format("${}\r\n{}", large.size(), large.substr(0, 100)));
+  decoder_.decode(buffer_);
+  buffer_.add(fmt::format("{}\r\n", large.substr(100)));
+  decoder_.decode(buffer_);
+  EXPECT_EQ(nullptr, decoded_values_[0]->pinnedOwner());
+  EXPECT_EQ(large, decoded_values_[0]->asStringView());
+}
+
 TEST_F(RedisEncoderDecoderImplTest, NestedArray) {
   std::vector<RespValue> nested_values(3);
   nested_values[0].type(RespType::BulkString);
@@ -1,6 +1,7 @@
 #include <memory>
 #include <string>
 
+#include "common/common/fmt.h"
 #include "common/network/utility.h"
 #include "common/upstream/upstream_impl.h"
 
@@ -19,6 +20,7 @@ using testing::_;
 using testing::Eq;
 using testing::InSequence;
 using testing::Invoke;
+using testing::NiceMock;
 using testing::Ref;
 using testing::Return;
 using testing::ReturnRef;
@@ -175,7 +177,6 @@ TEST_F(RedisClientImplTest, Cancel) {
   Buffer::OwnedImpl fake_data;
   EXPECT_CALL(*decoder_, decode(Ref(fake_data))).WillOnce(Invoke([&](Buffer::Instance&) -> void {
     InSequence s;
-
     RespValuePtr response1(new RespValue());
     EXPECT_CALL(callbacks1, onResponse_(_)).Times(0);
     EXPECT_CALL(*connect_or_op_timer_, enableTimer(_));
@@ -300,6 +301,10 @@ TEST_F(RedisClientImplTest, ConnectFail) {
 class ConfigOutlierDisabled : public Config {
   bool disableOutlierEvents() const override { return true; }
   std::chrono::milliseconds opTimeout() const override { return std::chrono::milliseconds(25); }
+  uint32_t maxBufferSizeBeforeFlush() const override { return 0; }
+  std::chrono::milliseconds bufferFlushTimeoutInMs() const override {
+    return std::chrono::milliseconds(0);
+  }
 };
 
 TEST_F(RedisClientImplTest, OutlierDisabled) {
@@ -366,6 +371,62 @@ TEST_F(RedisClientImplTest, OpTimeout) {
   EXPECT_EQ(1UL, host_->stats_.rq_timeout_.value());
 }
 
+class ConfigBufferCommands : public Config {
+  bool disableOutlierEvents() const override { return false; }
+  std::chrono::milliseconds opTimeout() const override { return std::chrono::milliseconds(25); }
+  uint32_t maxBufferSizeBeforeFlush() const override { return 10; }
+  std::chrono::milliseconds bufferFlushTimeoutInMs() const override {
+    return std::chrono::milliseconds(3);
+  }
+};
+
+TEST_F(RedisClientImplTest, BatchedRequests) {
+  Event::MockTimer* flush_timer = new Event::MockTimer(&dispatcher_);
+  InSequence s;
+
+  setup(std::make_unique<ConfigBufferCommands>());
+
+  // A null value is encoded in 5 bytes, so every other request fills the buffer.
+  RespValue request1;
+  MockPoolCallbacks callbacks1;
+  EXPECT_CALL(*encoder_, encode(Ref(request1), _));
+  EXPECT_CALL(*flush_timer, enableTimer(std::chrono::milliseconds(3)));
+  EXPECT_CALL(*upstream_connection_, write(_, _)).Times(0);
+  EXPECT_NE(nullptr, client_->makeRequest(request1, callbacks1));
+
+  RespValue request2;
+  MockPoolCallbacks callbacks2;
+  EXPECT_CALL(*encoder_, encode(Ref(request2), _));
+  EXPECT_CALL(*flush_timer, disableTimer());
+  EXPECT_CALL(*upstream_connection_, write(_, false))
+      .WillOnce(Invoke([](Buffer::Instance& data, bool) -> void {
+        EXPECT_EQ("$-1\r\n$-1\r\n", data.toString());
+        data.drain(data.length());
+      }));
+  EXPECT_NE(nullptr, client_->makeRequest(request2, callbacks2));
+
+  RespValue request3;
+  MockPoolCallbacks callbacks3;
+  EXPECT_CALL(*encoder_, encode(Ref(request3), _));
+  EXPECT_CALL(*flush_timer, enableTimer(std::chrono::milliseconds(3)));
+  EXPECT_NE(nullptr, client_->makeRequest(request3, callbacks3));
+
+  EXPECT_CALL(*flush_timer, disableTimer());
+  EXPECT_CALL(*upstream_connection_, write(_, false))
+      .WillOnce(Invoke([](Buffer::Instance& data, bool) -> void {
+        EXPECT_EQ("$-1\r\n", data.toString());
+        data.drain(data.length());
+      }));
+  flush_timer->callback_();
+
+  EXPECT_CALL(*upstream_connection_, close(Network::ConnectionCloseType::NoFlush));
+  EXPECT_CALL(callbacks1, onFailure());
+  EXPECT_CALL(callbacks2, onFailure());
+  EXPECT_CALL(callbacks3, onFailure());
+  EXPECT_CALL(*connect_or_op_timer_, disableTimer());
+  client_->close();
+}
+
 TEST(RedisClientFactoryImplTest, Basic) {
   ClientFactoryImpl factory;
   Upstream::MockHost::MockCreateConnectionData conn_info;
@@ -391,7 +452,70 @@ public:
 
   MOCK_METHOD1(create_, Client*(Upstream::HostConstSharedPtr host));
 
+  void setupClusterMode() {
+    host1_ = makeHost("10.0.0.1:7000");
+    host2_ = makeHost("10.0.0.2:7000");
+    cm_.thread_local_cluster_.cluster_.prioritySet().getMockHostSet(0)->hosts_ = {host1_, host2_};
+
+    envoy::config::filter::network::redis_proxy::v2::RedisProxy::ConnPoolSettings settings =
+        createConnPoolSettings();
+    settings.set_enable_cluster_mode(true);
+    conn_pool_.reset(new InstanceImpl(cluster_name_, cm_, *this, tls_, settings));
+  }
+
+  std::shared_ptr<Upstream::MockHost> makeHost(const std::string& address) {
+    std::shared_ptr<Upstream::MockHost> host(new NiceMock<Upstream::MockHost>());
+    ON_CALL(*host, address())
+        .WillByDefault(Return(Network::Utility::resolveUrl("tcp://" + address)));
+    return host;
+  }
+
+  // Expects a request on a client, whose callbacks are saved.
+  void expectRequest(MockClient& client, const std::string& request, PoolRequest& active_request,
+                     PoolCallbacks*& callbacks) {
+    EXPECT_CALL(client, makeRequest(_, _))
+        .WillOnce(Invoke([&, request](const RespValue& value,
+                                      PoolCallbacks& request_callbacks) -> PoolRequest* {
+          EXPECT_EQ(request, value.toString());
+          callbacks = &request_callbacks;
+          return &active_request;
+        }));
+  }
+
+  // Maps the slots of foo (12182) to host2 and those of bar (5061) to host1.
+  RespValuePtr makeClusterSlots() {
+    std::vector<RespValue> ranges(2);
+    for (uint32_t i = 0; i < ranges.size(); i++) {
+      std::vector<RespValue> range(3);
+      range[0].type(RespType::Integer);
+      range[0].asInteger() = i * 8192;
+      range[1].type(RespType::Integer);
+      range[1].asInteger() = i * 8192 + 8191;
+      range[2].type(RespType::Array);
+      range[2].asArray().resize(2);
+      range[2].asArray()[0].type(RespType::BulkString);
+      range[2].asArray()[0].asString() = fmt::format("10.0.0.{}", i + 1);
+      range[2].asArray()[1].type(RespType::Integer);
+      range[2].asArray()[1].asInteger() = 7000;
+      ranges[i].type(RespType::Array);
+      ranges[i].asArray().swap(range);
+    }
+    RespValuePtr response(new RespValue());
+    response->type(RespType::Array);
+    response->asArray().swap(ranges);
+    return response;
+  }
+
+  RespValuePtr makeError(const std::string& error) {
+    RespValuePtr response(new RespValue());
+    response->type(RespType::Error);
+    response->asString() = error;
+    return response;
+  }
+
   const std::string cluster_name_{"foo"};
+  std::shared_ptr<Upstream::MockHost> host1_;
+  std::shared_ptr<Upstream::MockHost> host2_;
   NiceMock<Upstream::MockClusterManager> cm_;
   NiceMock<ThreadLocal::MockInstance> tls_;
   InstancePtr conn_pool_;
@@ -454,6 +578,49 @@ TEST_F(RedisConnPoolImplTest, HostRemove) {
   tls_.shutdownThread();
 }
 
+TEST_F(RedisConnPoolImplTest, MultipleConnectionsPerHost) {
+  envoy::config::filter::network::redis_proxy::v2::RedisProxy::ConnPoolSettings settings =
+      createConnPoolSettings();
+  settings.mutable_max_connections_per_host()->set_value(2);
+  conn_pool_.reset(new InstanceImpl(cluster_name_, cm_, *this, tls_, settings));
+
+  // Find a key for each of the connections.
+  std::string keys[2];
+  for (uint32_t i = 0; keys[0].empty() || keys[1].empty(); i++) {
+    const std::string key = std::to_string(i);
+    keys[std::hash<std::string>()(key) % 2] = key;
+  }
+
+  InSequence s;
+  RespValue value;
+  MockPoolCallbacks callbacks;
+  MockClient* client1 = new NiceMock<MockClient>();
+  MockClient* client2 = new NiceMock<MockClient>();
+  MockPoolRequest active_request;
+
+  EXPECT_CALL(*this, create_(_)).WillOnce(Return(client1));
+  EXPECT_CALL(*client1, makeRequest(Ref(value), Ref(callbacks))).WillOnce(Return(&active_request));
+  conn_pool_->makeRequest(keys[0], value, callbacks);
+
+  EXPECT_CALL(*this, create_(_)).WillOnce(Return(client2));
+  EXPECT_CALL(*client2, makeRequest(Ref(value), Ref(callbacks))).WillOnce(Return(&active_request));
+  conn_pool_->makeRequest(keys[1], value, callbacks);
+
+  // The requests for a key keep using the same connection.
+  EXPECT_CALL(*client1, makeRequest(Ref(value), Ref(callbacks))).WillOnce(Return(&active_request));
+  conn_pool_->makeRequest(keys[0], value, callbacks);
+
+  // Closing one of the connections leaves the other one in use.
+  EXPECT_CALL(tls_.dispatcher_, deferredDelete_(_));
+  client1->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  EXPECT_CALL(*client2, makeRequest(Ref(value), Ref(callbacks))).WillOnce(Return(&active_request));
+  conn_pool_->makeRequest(keys[1], value, callbacks);
+
+  EXPECT_CALL(*client2, close());
+  EXPECT_CALL(tls_.dispatcher_, deferredDelete_(_));
+  tls_.shutdownThread();
+}
+
 TEST_F(RedisConnPoolImplTest, DeleteFollowedByClusterUpdateCallback) {
   conn_pool_.reset();
 
@@ -494,6 +661,157 @@ TEST_F(RedisConnPoolImplTest, RemoteClose) {
   tls_.shutdownThread();
 }
 
+TEST_F(RedisConnPoolImplTest, ClusterModeSlots) {
+  setupClusterMode();
+
+  RespValue value;
+  value.type(RespType::BulkString);
+  value.asString() = "get";
+  MockPoolCallbacks callbacks;
+  MockClient* client1 = new NiceMock<MockClient>();
+  MockClient* client2 = new NiceMock<MockClient>();
+  MockPoolRequest slots_request;
+  MockPoolRequest active_request1;
+  MockPoolRequest active_request2;
+  PoolCallbacks* slots_callbacks;
+  PoolCallbacks* request_callbacks1;
+  PoolCallbacks* request_callbacks2;
+
+  {
+    InSequence s;
+    // The first request discovers the slots, and is sent to the host chosen by the load balancer
+    // until they are known.
+    EXPECT_CALL(cm_.thread_local_cluster_.lb_, chooseHost(nullptr)).WillOnce(Return(host1_));
+    EXPECT_CALL(*this, create_(Eq(host1_))).WillOnce(Return(client1));
+    expectRequest(*client1, "[\"cluster\", \"slots\"]", slots_request, slots_callbacks);
+    EXPECT_CALL(cm_.thread_local_cluster_.lb_, chooseHost(_)).WillOnce(Return(host1_));
+    expectRequest(*client1, "\"get\"", active_request1, request_callbacks1);
+    PoolRequest* request1 = conn_pool_->makeRequest("foo", value, callbacks);
+    EXPECT_NE(nullptr, request1);
+
+    // The requests are then sent to the node serving the slot of their key.
+    slots_callbacks->onResponse(makeClusterSlots());
+    EXPECT_CALL(*this, create_(Eq(host2_))).WillOnce(Return(client2));
+    expectRequest(*client2, "\"get\"", active_request2, request_callbacks2);
+    PoolRequest* request2 = conn_pool_->makeRequest("foo", value, callbacks);
+    EXPECT_NE(nullptr, request2);
+
+    EXPECT_CALL(callbacks, onResponse_(_));
+    request_callbacks2->onResponse(makeError("ERR wrong type"));
+
+    EXPECT_CALL(active_request1, cancel());
+    request1->cancel();
+  }
+
+  EXPECT_CALL(*client1, close());
+  EXPECT_CALL(*client2, close());
+  tls_.shutdownThread();
+}
+
+TEST_F(RedisConnPoolImplTest, ClusterModeRedirections) {
+  setupClusterMode();
+
+  RespValue value;
+  value.type(RespType::BulkString);
+  value.asString() = "get";
+  MockPoolCallbacks callbacks;
+  MockClient* client1 = new NiceMock<MockClient>();
+  MockClient* client2 = new NiceMock<MockClient>();
+  MockPoolRequest slots_request;
+  MockPoolRequest active_request;
+  PoolCallbacks* slots_callbacks;
+  PoolCallbacks* request_callbacks;
+
+  {
+    InSequence s;
+    EXPECT_CALL(cm_.thread_local_cluster_.lb_, chooseHost(nullptr)).WillOnce(Return(host1_));
+    EXPECT_CALL(*this, create_(Eq(host1_))).WillOnce(Return(client1));
+    expectRequest(*client1, "[\"cluster\", \"slots\"]", slots_request, slots_callbacks);
+    EXPECT_CALL(cm_.thread_local_cluster_.lb_, chooseHost(_)).WillOnce(Return(host1_));
+    expectRequest(*client1, "\"get\"", active_request, request_callbacks);
+    conn_pool_->makeRequest("foo", value, callbacks);
+    slots_callbacks->onResponse(makeClusterSlots());
+
+    // A MOVED redirection moves the slot, refreshes the slots and sends the request again.
+    EXPECT_CALL(cm_.thread_local_cluster_.lb_, chooseHost(nullptr)).WillOnce(Return(host1_));
+    expectRequest(*client1, "[\"cluster\", \"slots\"]", slots_request, slots_callbacks);
+    EXPECT_CALL(*this, create_(Eq(host2_))).WillOnce(Return(client2));
+    expectRequest(*client2, "\"get\"", active_request, request_callbacks);
+    request_callbacks->onResponse(makeError("MOVED 12182 10.0.0.2:7000"));
+
+    // An ASK redirection sends ASKING ahead of the request, without changing the slots.
+    PoolCallbacks* asking_callbacks;
+    expectRequest(*client1, "[\"asking\"]", active_request, asking_callbacks);
+    expectRequest(*client1, "\"get\"", active_request, request_callbacks);
+    request_callbacks->onResponse(makeError("ASK 12182 10.0.0.1:7000"));
+    asking_callbacks->onResponse(makeError("OK"));
+
+    // The redirections stop being followed after a couple of them.
+    EXPECT_CALL(callbacks, onResponse_(_)).WillOnce(Invoke([](RespValuePtr& response) -> void {
+      EXPECT_EQ("\"ASK 12182 10.0.0.2:7000\"", response->toString());
+    }));
+    request_callbacks->onResponse(makeError("ASK 12182 10.0.0.2:7000"));
+
+    // A redirection to a node which isn't a host of the cluster is returned.
+    expectRequest(*client2, "\"get\"", active_request, request_callbacks);
+    conn_pool_->makeRequest("foo", value, callbacks);
+    EXPECT_CALL(callbacks, onResponse_(_));
+    request_callbacks->onResponse(makeError("MOVED 12182 10.0.0.3:7000"));
+
+    // The slot moved to the unknown node goes back to the load balancer.
+    EXPECT_CALL(cm_.thread_local_cluster_.lb_, chooseHost(_)).WillOnce(Return(host1_));
+    expectRequest(*client1, "\"get\"", active_request, request_callbacks);
+    conn_pool_->makeRequest("foo", value, callbacks);
+    EXPECT_CALL(callbacks, onFailure());
+    request_callbacks->onFailure();
+
+    EXPECT_CALL(slots_request, cancel());
+  }
+
+  EXPECT_CALL(*client1, close());
+  EXPECT_CALL(*client2, close());
+  tls_.shutdownThread();
+}
+
+TEST_F(RedisConnPoolImplTest, ClusterModeHostsChanged) {
+  setupClusterMode();
+
+  RespValue value;
+  MockPoolCallbacks callbacks;
+  MockClient* client1 = new NiceMock<MockClient>();
+  MockClient* client2 = new NiceMock<MockClient>();
+  MockPoolRequest slots_request;
+  MockPoolRequest active_request;
+  PoolCallbacks* slots_callbacks;
+  PoolCallbacks* request_callbacks;
+
+  {
+    InSequence s;
+    EXPECT_CALL(cm_.thread_local_cluster_.lb_, chooseHost(nullptr)).WillOnce(Return(host1_));
+    EXPECT_CALL(*this, create_(Eq(host1_))).WillOnce(Return(client1));
+    expectRequest(*client1, "[\"cluster\", \"slots\"]", slots_request, slots_callbacks);
+    EXPECT_CALL(cm_.thread_local_cluster_.lb_, chooseHost(_)).WillOnce(Return(host1_));
+    expectRequest(*client1, "null", active_request, request_callbacks);
+    conn_pool_->makeRequest("bar", value, callbacks);
+    slots_callbacks->onResponse(makeClusterSlots());
+
+    // The slots of a removed host go back to the load balancer, until the host is added again.
+    cm_.thread_local_cluster_.cluster_.prioritySet().getMockHostSet(0)->runCallbacks({}, {host2_});
+    EXPECT_CALL(cm_.thread_local_cluster_.lb_, chooseHost(_)).WillOnce(Return(host1_));
+    expectRequest(*client1, "null", active_request, request_callbacks);
+    conn_pool_->makeRequest("foo", value, callbacks);
+
+    cm_.thread_local_cluster_.cluster_.prioritySet().getMockHostSet(0)->runCallbacks({host2_}, {});
+    EXPECT_CALL(*this, create_(Eq(host2_))).WillOnce(Return(client2));
+    expectRequest(*client2, "null", active_request, request_callbacks);
+    conn_pool_->makeRequest("foo", value, callbacks);
+  }
+
+  EXPECT_CALL(*client1, close());
+  EXPECT_CALL(*client2, close());
+  tls_.shutdownThread();
+}
+
 } // namespace ConnPool
 } // namespace RedisProxy
 } // namespace NetworkFilters
@@ -40,7 +40,7 @@ bool operator==(const RespValue& lhs, const RespValue& rhs) {
   case RespType::SimpleString:
   case RespType::BulkString:
   case RespType::Error: {
-    return lhs.asString() == rhs.asString();
+    return lhs.asStringView() == rhs.asStringView();
   }
   case RespType::Null: {
     return true;
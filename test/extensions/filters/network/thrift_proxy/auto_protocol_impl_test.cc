@@ -138,6 +138,11 @@ TEST_F(AutoProtocolTest, ReadDelegation) {
   EXPECT_CALL(*proto, readMessageEnd(Ref(buffer))).WillOnce(Return(true));
   EXPECT_TRUE(auto_proto.readMessageEnd(buffer));
 
+  // peekReplyPayload
+  ReplyType reply_type;
+  EXPECT_CALL(*proto, peekReplyPayload(Ref(buffer), Ref(reply_type))).WillOnce(Return(true));
+  EXPECT_TRUE(auto_proto.peekReplyPayload(buffer, reply_type));
+
   // readStructBegin
   std::string name;
   EXPECT_CALL(*proto, readStructBegin(Ref(buffer), Ref(name))).WillOnce(Return(true));
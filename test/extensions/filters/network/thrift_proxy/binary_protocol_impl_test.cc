@@ -154,6 +154,52 @@ TEST_F(BinaryProtocolTest, ReadMessageEnd) {
   EXPECT_TRUE(proto.readMessageEnd(buffer));
 }
 
+TEST_F(BinaryProtocolTest, PeekReplyPayload) {
+  BinaryProtocolImpl proto;
+  ReplyType reply_type;
+
+  // Insufficient data
+  {
+    Buffer::OwnedImpl buffer;
+    EXPECT_FALSE(proto.peekReplyPayload(buffer, reply_type));
+
+    addInt8(buffer, FieldType::String);
+    addInt8(buffer, 0);
+    EXPECT_FALSE(proto.peekReplyPayload(buffer, reply_type));
+  }
+
+  // Result field
+  {
+    Buffer::OwnedImpl buffer;
+    addInt8(buffer, FieldType::String);
+    addInt16(buffer, 0);
+
+    EXPECT_TRUE(proto.peekReplyPayload(buffer, reply_type));
+    EXPECT_EQ(ReplyType::Success, reply_type);
+    EXPECT_EQ(3, buffer.length());
+  }
+
+  // IDL exception field
+  {
+    Buffer::OwnedImpl buffer;
+    addInt8(buffer, FieldType::Struct);
+    addInt16(buffer, 2);
+
+    EXPECT_TRUE(proto.peekReplyPayload(buffer, reply_type));
+    EXPECT_EQ(ReplyType::Error, reply_type);
+  }
+
+  // Stop field
+  {
+    Buffer::OwnedImpl buffer;
+    addInt8(buffer, FieldType::Stop);
+
+    EXPECT_TRUE(proto.peekReplyPayload(buffer, reply_type));
+    EXPECT_EQ(ReplyType::Error, reply_type);
+    EXPECT_EQ(1, buffer.length());
+  }
+}
+
 TEST_F(BinaryProtocolTest, ReadStructBegin) {
   Buffer::OwnedImpl buffer;
   BinaryProtocolImpl proto;
@@ -222,6 +222,59 @@ TEST_F(CompactProtocolTest, ReadMessageEnd) {
   EXPECT_TRUE(proto.readMessageEnd(buffer));
 }
 
+TEST_F(CompactProtocolTest, PeekReplyPayload) {
+  CompactProtocolImpl proto;
+  ReplyType reply_type;
+
+  // Insufficient data
+  {
+    Buffer::OwnedImpl buffer;
+    EXPECT_FALSE(proto.peekReplyPayload(buffer, reply_type));
+
+    addInt8(buffer, 0x0C);
+    EXPECT_FALSE(proto.peekReplyPayload(buffer, reply_type));
+  }
+
+  // Long-form result field
+  {
+    Buffer::OwnedImpl buffer;
+    addInt8(buffer, 0x0C);
+    addInt8(buffer, 0);
+
+    EXPECT_TRUE(proto.peekReplyPayload(buffer, reply_type));
+    EXPECT_EQ(ReplyType::Success, reply_type);
+    EXPECT_EQ(2, buffer.length());
+  }
+
+  // Long-form IDL exception field
+  {
+    Buffer::OwnedImpl buffer;
+    addInt8(buffer, 0x0C);
+    addInt8(buffer, 0x04);
+
+    EXPECT_TRUE(proto.peekReplyPayload(buffer, reply_type));
+    EXPECT_EQ(ReplyType::Error, reply_type);
+  }
+
+  // Short-form IDL exception field
+  {
+    Buffer::OwnedImpl buffer;
+    addInt8(buffer, 0x1C);
+
+    EXPECT_TRUE(proto.peekReplyPayload(buffer, reply_type));
+    EXPECT_EQ(ReplyType::Error, reply_type);
+  }
+
+  // Stop field
+  {
+    Buffer::OwnedImpl buffer;
+    addInt8(buffer, 0x00);
+
+    EXPECT_TRUE(proto.peekReplyPayload(buffer, reply_type));
+    EXPECT_EQ(ReplyType::Error, reply_type);
+  }
+}
+
 TEST_F(CompactProtocolTest, ReadStruct) {
   Buffer::OwnedImpl buffer;
   CompactProtocolImpl proto;
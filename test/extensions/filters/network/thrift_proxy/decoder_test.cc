@@ -165,6 +165,7 @@ public:
   NiceMock<MockProtocol> proto_;
   MessageMetadataSharedPtr metadata_;
   NiceMock<MockDecoderEventHandler> handler_;
+  NiceMock<MockDecoderCallbacks> callbacks_;
 };
 
 class DecoderStateMachineNonValueTest : public DecoderStateMachineTestBase,
@@ -217,7 +218,7 @@ TEST_P(DecoderStateMachineNonValueTest, NoData) {
   ProtocolState state = GetParam();
   Buffer::OwnedImpl buffer;
 
-  DecoderStateMachine dsm(proto_, metadata_, handler_);
+  DecoderStateMachine dsm(proto_, metadata_, handler_, callbacks_);
   dsm.setCurrentState(state);
   EXPECT_EQ(dsm.run(buffer), ProtocolState::WaitForData);
   EXPECT_EQ(dsm.currentState(), state);
@@ -237,7 +238,7 @@ TEST_P(DecoderStateMachineValueTest, NoFieldValueData) {
   EXPECT_CALL(proto_, readFieldEnd(Ref(buffer))).WillOnce(Return(true));
   EXPECT_CALL(proto_, readFieldBegin(Ref(buffer), _, _, _)).WillOnce(Return(false));
 
-  DecoderStateMachine dsm(proto_, metadata_, handler_);
+  DecoderStateMachine dsm(proto_, metadata_, handler_, callbacks_);
 
   dsm.setCurrentState(ProtocolState::FieldBegin);
   EXPECT_EQ(dsm.run(buffer), ProtocolState::WaitForData);
@@ -261,7 +262,7 @@ TEST_P(DecoderStateMachineValueTest, FieldValue) {
   EXPECT_CALL(proto_, readFieldEnd(Ref(buffer))).WillOnce(Return(true));
   EXPECT_CALL(proto_, readFieldBegin(Ref(buffer), _, _, _)).WillOnce(Return(false));
 
-  DecoderStateMachine dsm(proto_, metadata_, handler_);
+  DecoderStateMachine dsm(proto_, metadata_, handler_, callbacks_);
 
   dsm.setCurrentState(ProtocolState::FieldBegin);
   EXPECT_EQ(dsm.run(buffer), ProtocolState::WaitForData);
@@ -276,7 +277,7 @@ TEST_F(DecoderStateMachineTest, NoListValueData) {
       .WillOnce(DoAll(SetArgReferee<1>(FieldType::I32), SetArgReferee<2>(1), Return(true)));
   EXPECT_CALL(proto_, readInt32(Ref(buffer), _)).WillOnce(Return(false));
 
-  DecoderStateMachine dsm(proto_, metadata_, handler_);
+  DecoderStateMachine dsm(proto_, metadata_, handler_, callbacks_);
 
   dsm.setCurrentState(ProtocolState::ListBegin);
   EXPECT_EQ(dsm.run(buffer), ProtocolState::WaitForData);
@@ -291,7 +292,7 @@ TEST_F(DecoderStateMachineTest, EmptyList) {
       .WillOnce(DoAll(SetArgReferee<1>(FieldType::I32), SetArgReferee<2>(0), Return(true)));
   EXPECT_CALL(proto_, readListEnd(Ref(buffer))).WillOnce(Return(false));
 
-  DecoderStateMachine dsm(proto_, metadata_, handler_);
+  DecoderStateMachine dsm(proto_, metadata_, handler_, callbacks_);
 
   dsm.setCurrentState(ProtocolState::ListBegin);
   EXPECT_EQ(dsm.run(buffer), ProtocolState::WaitForData);
@@ -310,7 +311,7 @@ TEST_P(DecoderStateMachineValueTest, ListValue) {
 
   EXPECT_CALL(proto_, readListEnd(Ref(buffer))).WillOnce(Return(false));
 
-  DecoderStateMachine dsm(proto_, metadata_, handler_);
+  DecoderStateMachine dsm(proto_, metadata_, handler_, callbacks_);
 
   dsm.setCurrentState(ProtocolState::ListBegin);
   EXPECT_EQ(dsm.run(buffer), ProtocolState::WaitForData);
@@ -331,7 +332,7 @@ TEST_P(DecoderStateMachineValueTest, MultipleListValues) {
 
   EXPECT_CALL(proto_, readListEnd(Ref(buffer))).WillOnce(Return(false));
 
-  DecoderStateMachine dsm(proto_, metadata_, handler_);
+  DecoderStateMachine dsm(proto_, metadata_, handler_, callbacks_);
 
   dsm.setCurrentState(ProtocolState::ListBegin);
   EXPECT_EQ(dsm.run(buffer), ProtocolState::WaitForData);
@@ -347,7 +348,7 @@ TEST_F(DecoderStateMachineTest, NoMapKeyData) {
                       SetArgReferee<3>(1), Return(true)));
   EXPECT_CALL(proto_, readInt32(Ref(buffer), _)).WillOnce(Return(false));
 
-  DecoderStateMachine dsm(proto_, metadata_, handler_);
+  DecoderStateMachine dsm(proto_, metadata_, handler_, callbacks_);
 
   dsm.setCurrentState(ProtocolState::MapBegin);
   EXPECT_EQ(dsm.run(buffer), ProtocolState::WaitForData);
@@ -364,7 +365,7 @@ TEST_F(DecoderStateMachineTest, NoMapValueData) {
   EXPECT_CALL(proto_, readInt32(Ref(buffer), _)).WillOnce(Return(true));
   EXPECT_CALL(proto_, readString(Ref(buffer), _)).WillOnce(Return(false));
 
-  DecoderStateMachine dsm(proto_, metadata_, handler_);
+  DecoderStateMachine dsm(proto_, metadata_, handler_, callbacks_);
 
   dsm.setCurrentState(ProtocolState::MapBegin);
   EXPECT_EQ(dsm.run(buffer), ProtocolState::WaitForData);
@@ -380,7 +381,7 @@ TEST_F(DecoderStateMachineTest, EmptyMap) {
                       SetArgReferee<3>(0), Return(true)));
   EXPECT_CALL(proto_, readMapEnd(Ref(buffer))).WillOnce(Return(false));
 
-  DecoderStateMachine dsm(proto_, metadata_, handler_);
+  DecoderStateMachine dsm(proto_, metadata_, handler_, callbacks_);
 
   dsm.setCurrentState(ProtocolState::MapBegin);
   EXPECT_EQ(dsm.run(buffer), ProtocolState::WaitForData);
@@ -401,7 +402,7 @@ TEST_P(DecoderStateMachineValueTest, MapKeyValue) {
 
   EXPECT_CALL(proto_, readMapEnd(Ref(buffer))).WillOnce(Return(false));
 
-  DecoderStateMachine dsm(proto_, metadata_, handler_);
+  DecoderStateMachine dsm(proto_, metadata_, handler_, callbacks_);
 
   dsm.setCurrentState(ProtocolState::MapBegin);
   EXPECT_EQ(dsm.run(buffer), ProtocolState::WaitForData);
@@ -422,7 +423,7 @@ TEST_P(DecoderStateMachineValueTest, MapValueValue) {
 
   EXPECT_CALL(proto_, readMapEnd(Ref(buffer))).WillOnce(Return(false));
 
-  DecoderStateMachine dsm(proto_, metadata_, handler_);
+  DecoderStateMachine dsm(proto_, metadata_, handler_, callbacks_);
 
   dsm.setCurrentState(ProtocolState::MapBegin);
   EXPECT_EQ(dsm.run(buffer), ProtocolState::WaitForData);
@@ -445,7 +446,7 @@ TEST_P(DecoderStateMachineValueTest, MultipleMapKeyValues) {
 
   EXPECT_CALL(proto_, readMapEnd(Ref(buffer))).WillOnce(Return(false));
 
-  DecoderStateMachine dsm(proto_, metadata_, handler_);
+  DecoderStateMachine dsm(proto_, metadata_, handler_, callbacks_);
 
   dsm.setCurrentState(ProtocolState::MapBegin);
   EXPECT_EQ(dsm.run(buffer), ProtocolState::WaitForData);
@@ -460,7 +461,7 @@ TEST_F(DecoderStateMachineTest, NoSetValueData) {
       .WillOnce(DoAll(SetArgReferee<1>(FieldType::I32), SetArgReferee<2>(1), Return(true)));
   EXPECT_CALL(proto_, readInt32(Ref(buffer), _)).WillOnce(Return(false));
 
-  DecoderStateMachine dsm(proto_, metadata_, handler_);
+  DecoderStateMachine dsm(proto_, metadata_, handler_, callbacks_);
 
   dsm.setCurrentState(ProtocolState::SetBegin);
   EXPECT_EQ(dsm.run(buffer), ProtocolState::WaitForData);
@@ -475,7 +476,7 @@ TEST_F(DecoderStateMachineTest, EmptySet) {
       .WillOnce(DoAll(SetArgReferee<1>(FieldType::I32), SetArgReferee<2>(0), Return(true)));
   EXPECT_CALL(proto_, readSetEnd(Ref(buffer))).WillOnce(Return(false));
 
-  DecoderStateMachine dsm(proto_, metadata_, handler_);
+  DecoderStateMachine dsm(proto_, metadata_, handler_, callbacks_);
 
   dsm.setCurrentState(ProtocolState::SetBegin);
   EXPECT_EQ(dsm.run(buffer), ProtocolState::WaitForData);
@@ -494,7 +495,7 @@ TEST_P(DecoderStateMachineValueTest, SetValue) {
 
   EXPECT_CALL(proto_, readSetEnd(Ref(buffer))).WillOnce(Return(false));
 
-  DecoderStateMachine dsm(proto_, metadata_, handler_);
+  DecoderStateMachine dsm(proto_, metadata_, handler_, callbacks_);
 
   dsm.setCurrentState(ProtocolState::SetBegin);
   EXPECT_EQ(dsm.run(buffer), ProtocolState::WaitForData);
@@ -515,7 +516,7 @@ TEST_P(DecoderStateMachineValueTest, MultipleSetValues) {
 
   EXPECT_CALL(proto_, readSetEnd(Ref(buffer))).WillOnce(Return(false));
 
-  DecoderStateMachine dsm(proto_, metadata_, handler_);
+  DecoderStateMachine dsm(proto_, metadata_, handler_, callbacks_);
 
   dsm.setCurrentState(ProtocolState::SetBegin);
   EXPECT_EQ(dsm.run(buffer), ProtocolState::WaitForData);
@@ -539,7 +540,7 @@ TEST_F(DecoderStateMachineTest, EmptyStruct) {
   EXPECT_CALL(proto_, readStructEnd(Ref(buffer))).WillOnce(Return(true));
   EXPECT_CALL(proto_, readMessageEnd(Ref(buffer))).WillOnce(Return(true));
 
-  DecoderStateMachine dsm(proto_, metadata_, handler_);
+  DecoderStateMachine dsm(proto_, metadata_, handler_, callbacks_);
 
   EXPECT_EQ(dsm.run(buffer), ProtocolState::Done);
   EXPECT_EQ(dsm.currentState(), ProtocolState::Done);
@@ -590,7 +591,7 @@ TEST_P(DecoderStateMachineValueTest, SingleFieldStruct) {
   EXPECT_CALL(proto_, readMessageEnd(Ref(buffer))).WillOnce(Return(true));
   EXPECT_CALL(handler_, messageEnd()).WillOnce(Return(FilterStatus::Continue));
 
-  DecoderStateMachine dsm(proto_, metadata_, handler_);
+  DecoderStateMachine dsm(proto_, metadata_, handler_, callbacks_);
 
   EXPECT_EQ(dsm.run(buffer), ProtocolState::Done);
   EXPECT_EQ(dsm.currentState(), ProtocolState::Done);
@@ -647,12 +648,106 @@ TEST_F(DecoderStateMachineTest, MultiFieldStruct) {
   EXPECT_CALL(proto_, readMessageEnd(Ref(buffer))).WillOnce(Return(true));
   EXPECT_CALL(handler_, messageEnd()).WillOnce(Return(FilterStatus::Continue));
 
-  DecoderStateMachine dsm(proto_, metadata_, handler_);
+  DecoderStateMachine dsm(proto_, metadata_, handler_, callbacks_);
 
   EXPECT_EQ(dsm.run(buffer), ProtocolState::Done);
   EXPECT_EQ(dsm.currentState(), ProtocolState::Done);
 }
 
+TEST_F(DecoderStateMachineTest, PassthroughData) {
+  Buffer::OwnedImpl buffer;
+  buffer.add("headerbodyXnext");
+  InSequence dummy;
+
+  metadata_->setFrameSize(11);
+  EXPECT_CALL(proto_, readMessageBegin(Ref(buffer), _))
+      .WillOnce(Invoke([&](Buffer::Instance& data, MessageMetadata& metadata) -> bool {
+        data.drain(6);
+        metadata.setMethodName("name");
+        metadata.setMessageType(MessageType::Call);
+        metadata.setSequenceId(100);
+        return true;
+      }));
+  EXPECT_CALL(handler_, messageBegin(_)).WillOnce(Return(FilterStatus::Continue));
+  EXPECT_CALL(callbacks_, passthroughEnabled()).WillOnce(Return(true));
+  EXPECT_CALL(handler_, passthroughData(_))
+      .WillOnce(Invoke([&](Buffer::Instance& data) -> FilterStatus {
+        EXPECT_EQ("bodyX", data.toString());
+        return FilterStatus::Continue;
+      }));
+  EXPECT_CALL(proto_, readMessageEnd(Ref(buffer))).WillOnce(Return(true));
+  EXPECT_CALL(handler_, messageEnd()).WillOnce(Return(FilterStatus::Continue));
+
+  DecoderStateMachine dsm(proto_, metadata_, handler_, callbacks_);
+
+  EXPECT_EQ(dsm.run(buffer), ProtocolState::Done);
+  EXPECT_EQ(dsm.currentState(), ProtocolState::Done);
+  EXPECT_EQ("next", buffer.toString());
+}
+
+TEST_F(DecoderStateMachineTest, PassthroughDataWaitsForBody) {
+  Buffer::OwnedImpl buffer;
+  buffer.add("headerbo");
+  InSequence dummy;
+
+  metadata_->setFrameSize(11);
+  EXPECT_CALL(proto_, readMessageBegin(Ref(buffer), _))
+      .WillOnce(Invoke([&](Buffer::Instance& data, MessageMetadata&) -> bool {
+        data.drain(6);
+        return true;
+      }));
+  EXPECT_CALL(callbacks_, passthroughEnabled()).WillOnce(Return(true));
+
+  DecoderStateMachine dsm(proto_, metadata_, handler_, callbacks_);
+
+  EXPECT_EQ(dsm.run(buffer), ProtocolState::WaitForData);
+  EXPECT_EQ(dsm.currentState(), ProtocolState::PassthroughData);
+  EXPECT_EQ("bo", buffer.toString());
+
+  buffer.add("dyX");
+  EXPECT_CALL(handler_, passthroughData(_))
+      .WillOnce(Invoke([&](Buffer::Instance& data) -> FilterStatus {
+        EXPECT_EQ("bodyX", data.toString());
+        return FilterStatus::Continue;
+      }));
+  EXPECT_CALL(proto_, readMessageEnd(Ref(buffer))).WillOnce(Return(true));
+
+  EXPECT_EQ(dsm.run(buffer), ProtocolState::Done);
+  EXPECT_EQ(0U, buffer.length());
+}
+
+TEST_F(DecoderStateMachineTest, PassthroughDataRequiresFrameSize) {
+  Buffer::OwnedImpl buffer;
+  InSequence dummy;
+
+  EXPECT_CALL(proto_, readMessageBegin(Ref(buffer), _)).WillOnce(Return(true));
+  EXPECT_CALL(callbacks_, passthroughEnabled()).Times(0);
+  EXPECT_CALL(proto_, readStructBegin(Ref(buffer), _)).WillOnce(Return(false));
+
+  DecoderStateMachine dsm(proto_, metadata_, handler_, callbacks_);
+
+  EXPECT_EQ(dsm.run(buffer), ProtocolState::WaitForData);
+  EXPECT_EQ(dsm.currentState(), ProtocolState::StructBegin);
+}
+
+TEST_F(DecoderStateMachineTest, PassthroughDataHeaderExceedsFrameSize) {
+  Buffer::OwnedImpl buffer;
+  buffer.add("header");
+
+  metadata_->setFrameSize(5);
+  EXPECT_CALL(proto_, readMessageBegin(Ref(buffer), _))
+      .WillOnce(Invoke([&](Buffer::Instance& data, MessageMetadata&) -> bool {
+        data.drain(6);
+        return true;
+      }));
+  EXPECT_CALL(callbacks_, passthroughEnabled()).WillOnce(Return(true));
+
+  DecoderStateMachine dsm(proto_, metadata_, handler_, callbacks_);
+
+  EXPECT_THROW_WITH_MESSAGE(dsm.run(buffer), EnvoyException,
+                            "message header size 6 exceeds frame size 5");
+}
+
 TEST_P(DecoderStateMachineNestingTest, NestedTypes) {
   FieldType outer_field_type, inner_type, value_type;
   std::tie(outer_field_type, inner_type, value_type) = GetParam();
@@ -703,7 +798,7 @@ TEST_P(DecoderStateMachineNestingTest, NestedTypes) {
   EXPECT_CALL(proto_, readMessageEnd(Ref(buffer))).WillOnce(Return(true));
   EXPECT_CALL(handler_, messageEnd()).WillOnce(Return(FilterStatus::Continue));
 
-  DecoderStateMachine dsm(proto_, metadata_, handler_);
+  DecoderStateMachine dsm(proto_, metadata_, handler_, callbacks_);
 
   EXPECT_EQ(dsm.run(buffer), ProtocolState::Done);
   EXPECT_EQ(dsm.currentState(), ProtocolState::Done);
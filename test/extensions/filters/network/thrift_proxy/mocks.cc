@@ -50,6 +50,7 @@ MockDecoderFilter::MockDecoderFilter() {
   ON_CALL(*this, transportEnd()).WillByDefault(Return(FilterStatus::Continue));
   ON_CALL(*this, messageBegin(_)).WillByDefault(Return(FilterStatus::Continue));
   ON_CALL(*this, messageEnd()).WillByDefault(Return(FilterStatus::Continue));
+  ON_CALL(*this, passthroughData(_)).WillByDefault(Return(FilterStatus::Continue));
   ON_CALL(*this, structBegin(_)).WillByDefault(Return(FilterStatus::Continue));
   ON_CALL(*this, structEnd()).WillByDefault(Return(FilterStatus::Continue));
   ON_CALL(*this, fieldBegin(_, _, _)).WillByDefault(Return(FilterStatus::Continue));
@@ -86,6 +87,19 @@ MockRouteEntry::~MockRouteEntry() {}
 MockRoute::MockRoute() {}
 MockRoute::~MockRoute() {}
 
+MockMultiplexedRequest::MockMultiplexedRequest() {}
+MockMultiplexedRequest::~MockMultiplexedRequest() {
+  if (release_callback_) {
+    release_callback_();
+  }
+}
+
+MockMultiplexedConnPoolCallbacks::MockMultiplexedConnPoolCallbacks() {}
+MockMultiplexedConnPoolCallbacks::~MockMultiplexedConnPoolCallbacks() {}
+
+MockMultiplexedConnPool::MockMultiplexedConnPool() {}
+MockMultiplexedConnPool::~MockMultiplexedConnPool() {}
+
 } // namespace Router
 } // namespace ThriftProxy
 } // namespace NetworkFilters
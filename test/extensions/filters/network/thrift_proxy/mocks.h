@@ -5,6 +5,7 @@
 #include "extensions/filters/network/thrift_proxy/filters/filter.h"
 #include "extensions/filters/network/thrift_proxy/metadata.h"
 #include "extensions/filters/network/thrift_proxy/protocol.h"
+#include "extensions/filters/network/thrift_proxy/router/multiplexed_conn_pool.h"
 #include "extensions/filters/network/thrift_proxy/router/router.h"
 #include "extensions/filters/network/thrift_proxy/transport.h"
 
@@ -30,6 +31,7 @@ public:
   MOCK_METHOD0(stats, ThriftFilterStats&());
   MOCK_METHOD1(createDecoder, DecoderPtr(DecoderCallbacks&));
   MOCK_METHOD0(routerConfig, Router::Config&());
+  MOCK_CONST_METHOD0(payloadPassthrough, bool());
 };
 
 class MockTransport : public Transport {
@@ -59,6 +61,7 @@ public:
   MOCK_METHOD1(setType, void(ProtocolType));
   MOCK_METHOD2(readMessageBegin, bool(Buffer::Instance& buffer, MessageMetadata& metadata));
   MOCK_METHOD1(readMessageEnd, bool(Buffer::Instance& buffer));
+  MOCK_METHOD2(peekReplyPayload, bool(Buffer::Instance& buffer, ReplyType& reply_type));
   MOCK_METHOD2(readStructBegin, bool(Buffer::Instance& buffer, std::string& name));
   MOCK_METHOD1(readStructEnd, bool(Buffer::Instance& buffer));
   MOCK_METHOD4(readFieldBegin, bool(Buffer::Instance& buffer, std::string& name,
@@ -120,6 +123,7 @@ public:
 
   // ThriftProxy::DecoderCallbacks
   MOCK_METHOD0(newDecoderEventHandler, DecoderEventHandler&());
+  MOCK_CONST_METHOD0(passthroughEnabled, bool());
 };
 
 class MockDecoderEventHandler : public DecoderEventHandler {
@@ -132,6 +136,7 @@ public:
   MOCK_METHOD0(transportEnd, FilterStatus());
   MOCK_METHOD1(messageBegin, FilterStatus(MessageMetadataSharedPtr metadata));
   MOCK_METHOD0(messageEnd, FilterStatus());
+  MOCK_METHOD1(passthroughData, FilterStatus(Buffer::Instance& data));
   MOCK_METHOD1(structBegin, FilterStatus(const absl::string_view name));
   MOCK_METHOD0(structEnd, FilterStatus());
   MOCK_METHOD3(fieldBegin,
@@ -181,12 +186,14 @@ public:
   MOCK_METHOD0(onDestroy, void());
   MOCK_METHOD1(setDecoderFilterCallbacks, void(DecoderFilterCallbacks& callbacks));
   MOCK_METHOD0(resetUpstreamConnection, void());
+  MOCK_CONST_METHOD0(passthroughSupported, bool());
 
   // ThriftProxy::DecoderEventHandler
   MOCK_METHOD1(transportBegin, FilterStatus(MessageMetadataSharedPtr metadata));
   MOCK_METHOD0(transportEnd, FilterStatus());
   MOCK_METHOD1(messageBegin, FilterStatus(MessageMetadataSharedPtr metadata));
   MOCK_METHOD0(messageEnd, FilterStatus());
+  MOCK_METHOD1(passthroughData, FilterStatus(Buffer::Instance& data));
   MOCK_METHOD1(structBegin, FilterStatus(const absl::string_view name));
   MOCK_METHOD0(structEnd, FilterStatus());
   MOCK_METHOD3(fieldBegin,
@@ -250,6 +257,53 @@ public:
   MOCK_CONST_METHOD0(routeEntry, const RouteEntry*());
 };
 
+class MockMultiplexedRequest : public MultiplexedRequest {
+public:
+  MockMultiplexedRequest();
+  ~MockMultiplexedRequest();
+
+  // ThriftProxy::Router::MultiplexedRequest
+  MOCK_CONST_METHOD0(sequenceId, int32_t());
+  MOCK_METHOD0(connection, Network::ClientConnection&());
+  MOCK_METHOD1(addUpstreamCallbacks, void(Tcp::ConnectionPool::UpstreamCallbacks& callbacks));
+  MOCK_METHOD0(setOneway, void());
+
+  // Invoked in ~MockMultiplexedRequest, which indicates that the request was released.
+  std::function<void()> release_callback_;
+};
+
+class MockMultiplexedConnPoolCallbacks : public MultiplexedConnPoolCallbacks {
+public:
+  MockMultiplexedConnPoolCallbacks();
+  ~MockMultiplexedConnPoolCallbacks();
+
+  // ThriftProxy::Router::MultiplexedConnPoolCallbacks
+  MOCK_METHOD2(onPoolFailure, void(Tcp::ConnectionPool::PoolFailureReason reason,
+                                   Upstream::HostDescriptionConstSharedPtr host));
+  void onPoolReady(MultiplexedRequestPtr&& request,
+                   Upstream::HostDescriptionConstSharedPtr host) override {
+    onPoolReady_(*request, host);
+    request_ = std::move(request);
+  }
+
+  MOCK_METHOD2(onPoolReady_,
+               void(MultiplexedRequest& request, Upstream::HostDescriptionConstSharedPtr host));
+
+  MultiplexedRequestPtr request_;
+};
+
+class MockMultiplexedConnPool : public MultiplexedConnPool {
+public:
+  MockMultiplexedConnPool();
+  ~MockMultiplexedConnPool();
+
+  // ThriftProxy::Router::MultiplexedConnPool
+  MOCK_METHOD4(newRequest,
+               Tcp::ConnectionPool::Cancellable*(Tcp::ConnectionPool::Instance& conn_pool,
+                                                 TransportType transport, ProtocolType protocol,
+                                                 MultiplexedConnPoolCallbacks& callbacks));
+};
+
 } // namespace Router
 } // namespace ThriftProxy
 } // namespace NetworkFilters
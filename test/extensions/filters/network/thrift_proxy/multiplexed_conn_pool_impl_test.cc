@@ -0,0 +1,327 @@
+#include "common/buffer/buffer_impl.h"
+
+#include "extensions/filters/network/thrift_proxy/binary_protocol_impl.h"
+#include "extensions/filters/network/thrift_proxy/framed_transport_impl.h"
+#include "extensions/filters/network/thrift_proxy/header_transport_impl.h"
+#include "extensions/filters/network/thrift_proxy/router/multiplexed_conn_pool_impl.h"
+
+#include "test/extensions/filters/network/thrift_proxy/mocks.h"
+#include "test/mocks/network/mocks.h"
+#include "test/mocks/tcp/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Ref;
+using testing::SaveArg;
+
+namespace Envoy {
+namespace Extensions {
+namespace NetworkFilters {
+namespace ThriftProxy {
+namespace Router {
+
+class ThriftMultiplexedConnPoolTest : public testing::Test {
+public:
+  ThriftMultiplexedConnPoolTest() : pool_(tls_) {}
+
+  Tcp::ConnectionPool::Cancellable* newRequest(MockMultiplexedConnPoolCallbacks& callbacks,
+                                               TransportType transport = TransportType::Framed) {
+    return pool_.newRequest(conn_pool_, transport, ProtocolType::Binary, callbacks);
+  }
+
+  void connect() {
+    EXPECT_CALL(*conn_pool_.connection_data_, addUpstreamCallbacks(_))
+        .WillOnce(SaveArg<0>(&upstream_callbacks_));
+    conn_pool_.poolReady(connection_);
+  }
+
+  void writeResponse(Buffer::Instance& buffer, TransportType transport, int32_t sequence_id) {
+    MessageMetadata metadata;
+    metadata.setMethodName("method");
+    metadata.setMessageType(MessageType::Reply);
+    metadata.setSequenceId(sequence_id);
+    metadata.setProtocol(ProtocolType::Binary);
+
+    Buffer::OwnedImpl message;
+    BinaryProtocolImpl protocol;
+    protocol.writeMessageBegin(message, metadata);
+    protocol.writeStructBegin(message, "");
+    protocol.writeFieldBegin(message, "", FieldType::Stop, 0);
+    protocol.writeStructEnd(message);
+    protocol.writeMessageEnd(message);
+
+    if (transport == TransportType::Header) {
+      HeaderTransportImpl().encodeFrame(buffer, metadata, message);
+    } else {
+      FramedTransportImpl().encodeFrame(buffer, metadata, message);
+    }
+  }
+
+  // Expect the response with the given sequence id to be delivered to callbacks.
+  void expectResponse(Tcp::ConnectionPool::MockUpstreamCallbacks& callbacks,
+                      TransportType transport, int32_t sequence_id) {
+    Buffer::OwnedImpl expected;
+    writeResponse(expected, transport, sequence_id);
+    const std::string expected_data = expected.toString();
+
+    EXPECT_CALL(callbacks, onUpstreamData(_, true))
+        .WillOnce(Invoke([expected_data](Buffer::Instance& data, bool) -> void {
+          EXPECT_EQ(expected_data, data.toString());
+        }));
+  }
+
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  MultiplexedConnPoolImpl pool_;
+  NiceMock<Tcp::ConnectionPool::MockInstance> conn_pool_;
+  NiceMock<Network::MockClientConnection> connection_;
+  Tcp::ConnectionPool::UpstreamCallbacks* upstream_callbacks_{};
+};
+
+TEST_F(ThriftMultiplexedConnPoolTest, RequestsShareConnection) {
+  MockMultiplexedConnPoolCallbacks callbacks1;
+  MockMultiplexedConnPoolCallbacks callbacks2;
+  MockMultiplexedConnPoolCallbacks callbacks3;
+
+  // Requests wait for a single connection.
+  EXPECT_CALL(conn_pool_, newConnection(_));
+  EXPECT_NE(nullptr, newRequest(callbacks1));
+  EXPECT_NE(nullptr, newRequest(callbacks2));
+
+  EXPECT_CALL(callbacks1, onPoolReady_(_, _))
+      .WillOnce(Invoke([&](MultiplexedRequest& request, Upstream::HostDescriptionConstSharedPtr) {
+        EXPECT_EQ(0, request.sequenceId());
+        EXPECT_EQ(&connection_, &request.connection());
+      }));
+  EXPECT_CALL(callbacks2, onPoolReady_(_, _))
+      .WillOnce(Invoke([&](MultiplexedRequest& request, Upstream::HostDescriptionConstSharedPtr) {
+        EXPECT_EQ(1, request.sequenceId());
+        EXPECT_EQ(&connection_, &request.connection());
+      }));
+  connect();
+
+  // Later requests are assigned the connection immediately.
+  EXPECT_CALL(conn_pool_, newConnection(_)).Times(0);
+  EXPECT_CALL(callbacks3, onPoolReady_(_, _))
+      .WillOnce(Invoke([&](MultiplexedRequest& request, Upstream::HostDescriptionConstSharedPtr) {
+        EXPECT_EQ(2, request.sequenceId());
+      }));
+  EXPECT_EQ(nullptr, newRequest(callbacks3));
+
+  Tcp::ConnectionPool::MockUpstreamCallbacks upstream_callbacks1;
+  Tcp::ConnectionPool::MockUpstreamCallbacks upstream_callbacks2;
+  Tcp::ConnectionPool::MockUpstreamCallbacks upstream_callbacks3;
+  callbacks1.request_->addUpstreamCallbacks(upstream_callbacks1);
+  callbacks2.request_->addUpstreamCallbacks(upstream_callbacks2);
+  callbacks3.request_->addUpstreamCallbacks(upstream_callbacks3);
+
+  // Responses are matched by sequence id, whatever their order and however they are read.
+  Buffer::OwnedImpl responses;
+  writeResponse(responses, TransportType::Framed, 2);
+  writeResponse(responses, TransportType::Framed, 0);
+  Buffer::OwnedImpl partial;
+  partial.move(responses, responses.length() - 1);
+
+  expectResponse(upstream_callbacks3, TransportType::Framed, 2);
+  upstream_callbacks_->onUpstreamData(partial, false);
+  callbacks3.request_.reset();
+
+  expectResponse(upstream_callbacks1, TransportType::Framed, 0);
+  upstream_callbacks_->onUpstreamData(responses, false);
+  callbacks1.request_.reset();
+
+  // The connection is returned to the pool once no request is outstanding.
+  expectResponse(upstream_callbacks2, TransportType::Framed, 1);
+  Buffer::OwnedImpl response;
+  writeResponse(response, TransportType::Framed, 1);
+  upstream_callbacks_->onUpstreamData(response, false);
+  EXPECT_CALL(conn_pool_, released(Ref(connection_)));
+  callbacks2.request_.reset();
+}
+
+TEST_F(ThriftMultiplexedConnPoolTest, HeaderTransport) {
+  MockMultiplexedConnPoolCallbacks callbacks1;
+  MockMultiplexedConnPoolCallbacks callbacks2;
+  EXPECT_NE(nullptr, newRequest(callbacks1, TransportType::Header));
+  EXPECT_NE(nullptr, newRequest(callbacks2, TransportType::Header));
+  EXPECT_CALL(callbacks1, onPoolReady_(_, _));
+  EXPECT_CALL(callbacks2, onPoolReady_(_, _));
+  connect();
+
+  Tcp::ConnectionPool::MockUpstreamCallbacks upstream_callbacks1;
+  Tcp::ConnectionPool::MockUpstreamCallbacks upstream_callbacks2;
+  callbacks1.request_->addUpstreamCallbacks(upstream_callbacks1);
+  callbacks2.request_->addUpstreamCallbacks(upstream_callbacks2);
+
+  Buffer::OwnedImpl responses;
+  writeResponse(responses, TransportType::Header, 1);
+  writeResponse(responses, TransportType::Header, 0);
+  expectResponse(upstream_callbacks2, TransportType::Header, 1);
+  expectResponse(upstream_callbacks1, TransportType::Header, 0);
+  upstream_callbacks_->onUpstreamData(responses, false);
+
+  EXPECT_CALL(conn_pool_, released(Ref(connection_)));
+  callbacks1.request_.reset();
+  callbacks2.request_.reset();
+}
+
+TEST_F(ThriftMultiplexedConnPoolTest, ConnectionsPerTransport) {
+  MockMultiplexedConnPoolCallbacks callbacks1;
+  MockMultiplexedConnPoolCallbacks callbacks2;
+
+  EXPECT_CALL(conn_pool_, newConnection(_)).Times(2);
+  EXPECT_NE(nullptr, newRequest(callbacks1, TransportType::Framed));
+  EXPECT_NE(nullptr, newRequest(callbacks2, TransportType::Header));
+
+  EXPECT_CALL(callbacks1, onPoolFailure(_, _));
+  EXPECT_CALL(callbacks2, onPoolFailure(_, _));
+  conn_pool_.poolFailure(Tcp::ConnectionPool::PoolFailureReason::Timeout);
+  conn_pool_.poolFailure(Tcp::ConnectionPool::PoolFailureReason::Timeout);
+}
+
+TEST_F(ThriftMultiplexedConnPoolTest, PoolFailure) {
+  MockMultiplexedConnPoolCallbacks callbacks1;
+  MockMultiplexedConnPoolCallbacks callbacks2;
+  EXPECT_NE(nullptr, newRequest(callbacks1));
+  EXPECT_NE(nullptr, newRequest(callbacks2));
+
+  EXPECT_CALL(callbacks1,
+              onPoolFailure(Tcp::ConnectionPool::PoolFailureReason::RemoteConnectionFailure, _));
+  EXPECT_CALL(callbacks2,
+              onPoolFailure(Tcp::ConnectionPool::PoolFailureReason::RemoteConnectionFailure, _));
+  conn_pool_.poolFailure(Tcp::ConnectionPool::PoolFailureReason::RemoteConnectionFailure);
+
+  // The next request connects again.
+  MockMultiplexedConnPoolCallbacks callbacks3;
+  EXPECT_CALL(conn_pool_, newConnection(_));
+  EXPECT_NE(nullptr, newRequest(callbacks3));
+  EXPECT_CALL(callbacks3, onPoolReady_(_, _));
+  connect();
+
+  EXPECT_CALL(conn_pool_, released(Ref(connection_)));
+  callbacks3.request_->setOneway();
+  callbacks3.request_.reset();
+}
+
+TEST_F(ThriftMultiplexedConnPoolTest, CancelPendingRequests) {
+  MockMultiplexedConnPoolCallbacks callbacks1;
+  MockMultiplexedConnPoolCallbacks callbacks2;
+  Tcp::ConnectionPool::Cancellable* handle1 = newRequest(callbacks1);
+  Tcp::ConnectionPool::Cancellable* handle2 = newRequest(callbacks2);
+
+  // The connection is cancelled with the last pending request.
+  EXPECT_CALL(conn_pool_.handles_.front(), cancel()).Times(0);
+  handle1->cancel();
+  EXPECT_CALL(conn_pool_.handles_.front(), cancel());
+  handle2->cancel();
+}
+
+TEST_F(ThriftMultiplexedConnPoolTest, ConnectionClosed) {
+  MockMultiplexedConnPoolCallbacks callbacks1;
+  MockMultiplexedConnPoolCallbacks callbacks2;
+  EXPECT_NE(nullptr, newRequest(callbacks1));
+  EXPECT_NE(nullptr, newRequest(callbacks2));
+  EXPECT_CALL(callbacks1, onPoolReady_(_, _));
+  EXPECT_CALL(callbacks2, onPoolReady_(_, _));
+  connect();
+
+  Tcp::ConnectionPool::MockUpstreamCallbacks upstream_callbacks1;
+  Tcp::ConnectionPool::MockUpstreamCallbacks upstream_callbacks2;
+  callbacks1.request_->addUpstreamCallbacks(upstream_callbacks1);
+  callbacks2.request_->addUpstreamCallbacks(upstream_callbacks2);
+
+  // The first request is released when notified, the second one later.
+  EXPECT_CALL(upstream_callbacks1, onEvent(Network::ConnectionEvent::RemoteClose))
+      .WillOnce(Invoke([&](Network::ConnectionEvent) -> void { callbacks1.request_.reset(); }));
+  EXPECT_CALL(upstream_callbacks2, onEvent(Network::ConnectionEvent::RemoteClose));
+  EXPECT_CALL(conn_pool_, released(Ref(connection_)));
+  upstream_callbacks_->onEvent(Network::ConnectionEvent::RemoteClose);
+
+  // A new request doesn't reuse the sequence id of the outstanding one.
+  MockMultiplexedConnPoolCallbacks callbacks3;
+  conn_pool_.connection_data_ =
+      std::make_unique<NiceMock<Tcp::ConnectionPool::MockConnectionData>>();
+  EXPECT_CALL(conn_pool_, newConnection(_));
+  EXPECT_NE(nullptr, newRequest(callbacks3));
+  EXPECT_CALL(callbacks3, onPoolReady_(_, _))
+      .WillOnce(Invoke([&](MultiplexedRequest& request, Upstream::HostDescriptionConstSharedPtr) {
+        EXPECT_EQ(2, request.sequenceId());
+      }));
+  connect();
+
+  // Releasing the request of the closed connection doesn't affect the new one.
+  EXPECT_CALL(connection_, close(_)).Times(0);
+  callbacks2.request_.reset();
+
+  EXPECT_CALL(conn_pool_, released(Ref(connection_)));
+  callbacks3.request_->setOneway();
+  callbacks3.request_.reset();
+}
+
+TEST_F(ThriftMultiplexedConnPoolTest, ReleasedRequestClosesIdleConnection) {
+  MockMultiplexedConnPoolCallbacks callbacks1;
+  MockMultiplexedConnPoolCallbacks callbacks2;
+  EXPECT_NE(nullptr, newRequest(callbacks1));
+  EXPECT_NE(nullptr, newRequest(callbacks2));
+  EXPECT_CALL(callbacks1, onPoolReady_(_, _));
+  EXPECT_CALL(callbacks2, onPoolReady_(_, _));
+  connect();
+
+  // The response to the released request would be read by the next user of the connection.
+  EXPECT_CALL(connection_, close(_)).Times(0);
+  callbacks1.request_.reset();
+
+  EXPECT_CALL(connection_, close(Network::ConnectionCloseType::NoFlush));
+  callbacks2.request_->setOneway();
+  callbacks2.request_.reset();
+}
+
+TEST_F(ThriftMultiplexedConnPoolTest, UnknownSequenceId) {
+  MockMultiplexedConnPoolCallbacks callbacks;
+  EXPECT_NE(nullptr, newRequest(callbacks));
+  EXPECT_CALL(callbacks, onPoolReady_(_, _));
+  connect();
+
+  Tcp::ConnectionPool::MockUpstreamCallbacks upstream_callbacks;
+  callbacks.request_->addUpstreamCallbacks(upstream_callbacks);
+
+  Buffer::OwnedImpl responses;
+  writeResponse(responses, TransportType::Framed, 5);
+  writeResponse(responses, TransportType::Framed, 0);
+  expectResponse(upstream_callbacks, TransportType::Framed, 0);
+  upstream_callbacks_->onUpstreamData(responses, false);
+
+  EXPECT_CALL(conn_pool_, released(Ref(connection_)));
+  callbacks.request_.reset();
+}
+
+TEST_F(ThriftMultiplexedConnPoolTest, InvalidResponse) {
+  MockMultiplexedConnPoolCallbacks callbacks;
+  EXPECT_NE(nullptr, newRequest(callbacks));
+  EXPECT_CALL(callbacks, onPoolReady_(_, _));
+  connect();
+
+  Tcp::ConnectionPool::MockUpstreamCallbacks upstream_callbacks;
+  callbacks.request_->addUpstreamCallbacks(upstream_callbacks);
+
+  EXPECT_CALL(connection_, close(Network::ConnectionCloseType::NoFlush))
+      .WillOnce(Invoke([&](Network::ConnectionCloseType) -> void {
+        upstream_callbacks_->onEvent(Network::ConnectionEvent::LocalClose);
+      }));
+  EXPECT_CALL(upstream_callbacks, onEvent(Network::ConnectionEvent::LocalClose))
+      .WillOnce(Invoke([&](Network::ConnectionEvent) -> void { callbacks.request_.reset(); }));
+
+  Buffer::OwnedImpl response;
+  response.add("\xff\xff\xff\xff", 4);
+  upstream_callbacks_->onUpstreamData(response, false);
+}
+
+} // namespace Router
+} // namespace ThriftProxy
+} // namespace NetworkFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -722,6 +722,31 @@ TEST_F(ThriftRouterTest, CallWithExistingConnection) {
   destroyRouter();
 }
 
+TEST_F(ThriftRouterTest, PassthroughData) {
+  initializeRouter();
+  startRequest(MessageType::Call);
+  EXPECT_TRUE(router_->passthroughSupported());
+  connectUpstream();
+
+  Buffer::OwnedImpl body("body");
+  EXPECT_EQ(FilterStatus::Continue, router_->passthroughData(body));
+  EXPECT_EQ(0U, body.length());
+
+  EXPECT_CALL(*protocol_, writeMessageEnd(_));
+  EXPECT_CALL(*transport_, encodeFrame(_, _, _))
+      .WillOnce(Invoke(
+          [&](Buffer::Instance&, const MessageMetadata&, Buffer::Instance& message) -> void {
+            EXPECT_EQ("body", message.toString());
+          }));
+  EXPECT_CALL(upstream_connection_, write(_, false));
+
+  EXPECT_EQ(FilterStatus::Continue, router_->messageEnd());
+  EXPECT_EQ(FilterStatus::Continue, router_->transportEnd());
+
+  returnResponse();
+  destroyRouter();
+}
+
 TEST_P(ThriftRouterContainerTest, DecoderFilterCallbacks) {
   FieldType field_type = GetParam();
 
@@ -0,0 +1,224 @@
+#include <sys/socket.h>
+
+#include <string>
+#include <vector>
+
+#include "envoy/config/filter/udp/udp_proxy/v2alpha/udp_proxy.pb.validate.h"
+
+#include "common/buffer/buffer_impl.h"
+#include "common/network/listen_socket_impl.h"
+#include "common/network/utility.h"
+
+#include "extensions/filters/udp/udp_proxy/udp_proxy_filter.h"
+
+#include "test/mocks/network/mocks.h"
+#include "test/mocks/upstream/mocks.h"
+#include "test/test_common/environment.h"
+#include "test/test_common/network_utility.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::DoAll;
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+using testing::SaveArg;
+
+namespace Envoy {
+namespace Extensions {
+namespace UdpFilters {
+namespace UdpProxy {
+
+class UdpProxyFilterTest : public testing::TestWithParam<Network::Address::IpVersion> {
+public:
+  UdpProxyFilterTest()
+      : upstream_socket_(Network::Test::getCanonicalLoopbackAddress(GetParam()), nullptr, true) {
+    ON_CALL(*cluster_manager_.thread_local_cluster_.lb_.host_, address())
+        .WillByDefault(Return(upstream_socket_.localAddress()));
+  }
+
+  void setup(const std::string& yaml) {
+    envoy::config::filter::udp::udp_proxy::v2alpha::UdpProxyConfig proto_config;
+    MessageUtil::loadFromYaml(yaml, proto_config);
+    config_ = std::make_shared<const UdpProxyFilterConfig>(proto_config, cluster_manager_,
+                                                           stats_store_);
+    filter_ = std::make_unique<UdpProxyFilter>(callbacks_, config_);
+  }
+
+  void setup() {
+    setup(R"EOF(
+stat_prefix: foo
+cluster: fake_cluster
+idle_timeout: 10s
+)EOF");
+  }
+
+  // Passes a datagram from the given downstream peer to the filter.
+  void recvDataFromDownstream(const std::string& peer_address, const std::string& payload) {
+    Network::UdpRecvData data{Network::Utility::parseInternetAddressAndPort("10.0.0.2:80"),
+                              Network::Utility::parseInternetAddressAndPort(peer_address),
+                              std::make_unique<Buffer::OwnedImpl>(payload)};
+    EXPECT_EQ(Network::FilterStatus::StopIteration, filter_->onData(data));
+  }
+
+  // Expects a session to be created, returning its idle timer and saving its read callback.
+  Event::MockTimer* expectSessionCreate() {
+    EXPECT_CALL(callbacks_.dispatcher_, createFileEvent_(_, _, _, _))
+        .WillOnce(DoAll(SaveArg<1>(&upstream_read_cb_),
+                        Return(new NiceMock<Event::MockFileEvent>())));
+    Event::MockTimer* idle_timer = new NiceMock<Event::MockTimer>(&callbacks_.dispatcher_);
+    EXPECT_CALL(*idle_timer, enableTimer(std::chrono::milliseconds(10000)));
+    return idle_timer;
+  }
+
+  // Reads a datagram from the upstream socket, returning its payload and saving its source.
+  std::string recvDataFromSession() {
+    char data[1024];
+    sockaddr_storage session_address;
+    socklen_t session_address_len = sizeof(session_address);
+    const ssize_t rc = ::recvfrom(upstream_socket_.fd(), data, sizeof(data), 0,
+                                  reinterpret_cast<sockaddr*>(&session_address),
+                                  &session_address_len);
+    EXPECT_LE(0, rc);
+    const bool v6only = GetParam() == Network::Address::IpVersion::v6;
+    session_address_ =
+        Network::Address::addressFromSockAddr(session_address, session_address_len, v6only);
+    return std::string(data, rc);
+  }
+
+  void sendDataToSession(const std::string& payload) {
+    EXPECT_EQ(static_cast<ssize_t>(payload.size()),
+              ::sendto(upstream_socket_.fd(), payload.data(), payload.size(), 0,
+                       session_address_->sockAddr(), session_address_->sockAddrLen()));
+  }
+
+  uint64_t counter(const std::string& name) {
+    return stats_store_.counter("udp.foo." + name).value();
+  }
+
+  Stats::IsolatedStoreImpl stats_store_;
+  NiceMock<Upstream::MockClusterManager> cluster_manager_;
+  NiceMock<Network::MockUdpReadFilterCallbacks> callbacks_;
+  Network::UdpListenSocket upstream_socket_;
+  UdpProxyFilterConfigSharedPtr config_;
+  std::unique_ptr<UdpProxyFilter> filter_;
+  Event::FileReadyCb upstream_read_cb_;
+  Network::Address::InstanceConstSharedPtr session_address_;
+};
+
+INSTANTIATE_TEST_CASE_P(IpVersions, UdpProxyFilterTest,
+                        testing::ValuesIn(TestEnvironment::getIpVersionsForTest()),
+                        TestUtility::ipTestParamsToString);
+
+// Datagrams of a peer go through one session to the upstream host, and the host's datagrams are
+// sent back to the peer through the listener.
+TEST_P(UdpProxyFilterTest, BasicFlow) {
+  setup();
+
+  Event::MockTimer* idle_timer = expectSessionCreate();
+  recvDataFromDownstream("10.0.0.1:1000", "hello");
+  EXPECT_EQ("hello", recvDataFromSession());
+  EXPECT_EQ(1UL, counter("downstream_sess_total"));
+  EXPECT_EQ(1UL, stats_store_.gauge("udp.foo.downstream_sess_active").value());
+  EXPECT_EQ(1UL, cluster_manager_.thread_local_cluster_.cluster_.info_->stats_.upstream_cx_total_
+                     .value());
+
+  EXPECT_CALL(*idle_timer, enableTimer(std::chrono::milliseconds(10000)));
+  recvDataFromDownstream("10.0.0.1:1000", "world");
+  EXPECT_EQ("world", recvDataFromSession());
+  EXPECT_EQ(1UL, counter("downstream_sess_total"));
+  EXPECT_EQ(2UL, counter("downstream_sess_rx_datagrams"));
+
+  sendDataToSession("reply1");
+  sendDataToSession("reply2");
+  std::vector<std::string> replies;
+  EXPECT_CALL(callbacks_.udp_listener_, send(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([&](const Network::UdpSendData& data) -> void {
+        EXPECT_EQ("10.0.0.1:1000", data.peer_address_.asString());
+        replies.push_back(data.buffer_.toString());
+      }));
+  EXPECT_CALL(*idle_timer, enableTimer(std::chrono::milliseconds(10000)));
+  upstream_read_cb_(Event::FileReadyType::Read);
+  EXPECT_EQ((std::vector<std::string>{"reply1", "reply2"}), replies);
+  EXPECT_EQ(2UL, counter("downstream_sess_tx_datagrams"));
+}
+
+// A session ends after the idle timeout and the next datagram of the peer starts a new one.
+TEST_P(UdpProxyFilterTest, IdleTimeout) {
+  setup();
+
+  Event::MockTimer* idle_timer = expectSessionCreate();
+  recvDataFromDownstream("10.0.0.1:1000", "hello");
+  EXPECT_EQ("hello", recvDataFromSession());
+
+  EXPECT_CALL(callbacks_.dispatcher_, deferredDelete_(_));
+  idle_timer->callback_();
+  EXPECT_EQ(1UL, counter("idle_timeout"));
+  EXPECT_EQ(0UL, stats_store_.gauge("udp.foo.downstream_sess_active").value());
+  EXPECT_EQ(0UL, cluster_manager_.thread_local_cluster_.cluster_.info_->stats_.upstream_cx_active_
+                     .value());
+
+  expectSessionCreate();
+  recvDataFromDownstream("10.0.0.1:1000", "hello");
+  EXPECT_EQ("hello", recvDataFromSession());
+  EXPECT_EQ(2UL, counter("downstream_sess_total"));
+}
+
+TEST_P(UdpProxyFilterTest, NoRoute) {
+  setup();
+
+  EXPECT_CALL(cluster_manager_, get("fake_cluster")).WillOnce(Return(nullptr));
+  EXPECT_CALL(callbacks_.dispatcher_, createFileEvent_(_, _, _, _)).Times(0);
+  recvDataFromDownstream("10.0.0.1:1000", "hello");
+  EXPECT_EQ(1UL, counter("downstream_sess_no_route"));
+  EXPECT_EQ(0UL, counter("downstream_sess_total"));
+}
+
+TEST_P(UdpProxyFilterTest, NoHealthyHost) {
+  setup();
+
+  EXPECT_CALL(cluster_manager_.thread_local_cluster_.lb_, chooseHost(_)).WillOnce(Return(nullptr));
+  EXPECT_CALL(callbacks_.dispatcher_, createFileEvent_(_, _, _, _)).Times(0);
+  recvDataFromDownstream("10.0.0.1:1000", "hello");
+  EXPECT_EQ(1UL, cluster_manager_.thread_local_cluster_.cluster_.info_->stats_
+                     .upstream_cx_none_healthy_.value());
+  EXPECT_EQ(0UL, counter("downstream_sess_total"));
+}
+
+// Sessions are bounded by the cluster's connection circuit breaker, which is 1 in the mock.
+TEST_P(UdpProxyFilterTest, CircuitBreaker) {
+  setup();
+
+  expectSessionCreate();
+  recvDataFromDownstream("10.0.0.1:1000", "hello");
+  EXPECT_EQ("hello", recvDataFromSession());
+
+  EXPECT_CALL(callbacks_.dispatcher_, createFileEvent_(_, _, _, _)).Times(0);
+  recvDataFromDownstream("10.0.0.3:1000", "hello");
+  EXPECT_EQ(1UL, cluster_manager_.thread_local_cluster_.cluster_.info_->stats_
+                     .upstream_cx_overflow_.value());
+  EXPECT_EQ(1UL, counter("downstream_sess_total"));
+}
+
+// The peer address is the hash key of the host selection.
+TEST_P(UdpProxyFilterTest, HashKey) {
+  setup();
+
+  absl::optional<uint64_t> hash;
+  EXPECT_CALL(cluster_manager_.thread_local_cluster_.lb_, chooseHost(_))
+      .WillOnce(Invoke([&](Upstream::LoadBalancerContext* context) -> Upstream::HostConstSharedPtr {
+        hash = context->computeHashKey();
+        return nullptr;
+      }));
+  recvDataFromDownstream("10.0.0.1:1000", "hello");
+  EXPECT_EQ(HashUtil::xxHash64("10.0.0.1:1000"), hash);
+}
+
+} // namespace UdpProxy
+} // namespace UdpFilters
+} // namespace Extensions
+} // namespace Envoy
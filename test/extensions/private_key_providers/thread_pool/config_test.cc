@@ -0,0 +1,58 @@
+#include "envoy/registry/registry.h"
+#include "envoy/ssl/private_key/private_key_config.h"
+
+#include "extensions/private_key_providers/thread_pool/config.h"
+
+#include "test/test_common/environment.h"
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace PrivateKeyProviders {
+namespace ThreadPool {
+namespace {
+
+Ssl::PrivateKeyMethodProviderInstanceFactory& factory() {
+  auto* factory =
+      Registry::FactoryRegistry<Ssl::PrivateKeyMethodProviderInstanceFactory>::getFactory(
+          "envoy.private_key_providers.thread_pool");
+  EXPECT_NE(nullptr, factory);
+  return *factory;
+}
+
+ProtobufWkt::Struct threads(uint32_t count) {
+  ProtobufWkt::Struct config;
+  (*config.mutable_fields())["threads"].set_number_value(count);
+  return config;
+}
+
+TEST(ThreadPoolPrivateKeyMethodFactoryTest, CreateProvider) {
+  const std::string private_key = TestEnvironment::readFileToStringForTest(
+      TestEnvironment::substitute("{{ test_rundir }}/test/common/ssl/test_data/san_uri_key.pem"));
+  Ssl::PrivateKeyMethodProviderSharedPtr provider =
+      factory().createPrivateKeyMethodProviderInstance(threads(4), private_key);
+  ASSERT_NE(nullptr, provider);
+  EXPECT_NE(nullptr, provider->getBoringSslPrivateKeyMethod());
+
+  // The number of threads defaults to 1.
+  EXPECT_NE(nullptr,
+            factory().createPrivateKeyMethodProviderInstance(ProtobufWkt::Struct(), private_key));
+}
+
+TEST(ThreadPoolPrivateKeyMethodFactoryTest, InvalidConfig) {
+  const std::string private_key = TestEnvironment::readFileToStringForTest(
+      TestEnvironment::substitute("{{ test_rundir }}/test/common/ssl/test_data/san_uri_key.pem"));
+  EXPECT_THROW(factory().createPrivateKeyMethodProviderInstance(threads(0), private_key),
+               ProtoValidationException);
+  EXPECT_THROW_WITH_MESSAGE(
+      factory().createPrivateKeyMethodProviderInstance(threads(1), "not a key"), EnvoyException,
+      "Failed to load private key for the thread pool private key provider");
+}
+
+} // namespace
+} // namespace ThreadPool
+} // namespace PrivateKeyProviders
+} // namespace Extensions
+} // namespace Envoy
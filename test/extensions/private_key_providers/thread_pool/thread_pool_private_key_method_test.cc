@@ -0,0 +1,168 @@
+#include <string>
+#include <vector>
+
+#include "extensions/private_key_providers/thread_pool/thread_pool_private_key_method.h"
+
+#include "test/mocks/event/mocks.h"
+#include "test/test_common/environment.h"
+
+#include "absl/synchronization/notification.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "openssl/evp.h"
+#include "openssl/pem.h"
+#include "openssl/rsa.h"
+
+using testing::_;
+using testing::Invoke;
+
+namespace Envoy {
+namespace Extensions {
+namespace PrivateKeyProviders {
+namespace ThreadPool {
+namespace {
+
+class MockPrivateKeyConnectionCallbacks : public Ssl::PrivateKeyConnectionCallbacks {
+public:
+  MOCK_METHOD0(onPrivateKeyMethodComplete, void());
+};
+
+bssl::UniquePtr<EVP_PKEY> loadKey() {
+  const std::string pem = TestEnvironment::readFileToStringForTest(
+      TestEnvironment::substitute("{{ test_rundir }}/test/common/ssl/test_data/san_uri_key.pem"));
+  bssl::UniquePtr<BIO> bio(BIO_new_mem_buf(pem.data(), pem.size()));
+  return bssl::UniquePtr<EVP_PKEY>(PEM_read_bio_PrivateKey(bio.get(), nullptr, nullptr, nullptr));
+}
+
+class ThreadPoolPrivateKeyMethodTest : public testing::Test {
+public:
+  ThreadPoolPrivateKeyMethodTest() : pkey_(loadKey()) { EXPECT_NE(nullptr, pkey_); }
+
+  PrivateKeyOperation makeOperation(PrivateKeyOperation::Type type,
+                                    const std::vector<uint8_t>& input) {
+    PrivateKeyOperation operation(type, callbacks_, dispatcher_);
+    operation.input_ = input;
+    return operation;
+  }
+
+  bool verify(uint16_t signature_algorithm, const std::vector<uint8_t>& input,
+              const std::vector<uint8_t>& signature) {
+    bssl::ScopedEVP_MD_CTX ctx;
+    EVP_PKEY_CTX* pctx;
+    EXPECT_EQ(1, EVP_DigestVerifyInit(ctx.get(), &pctx,
+                                      SSL_get_signature_algorithm_digest(signature_algorithm),
+                                      nullptr, pkey_.get()));
+    EXPECT_EQ(1, EVP_PKEY_CTX_set_rsa_padding(pctx, RSA_PKCS1_PSS_PADDING));
+    EXPECT_EQ(1, EVP_PKEY_CTX_set_rsa_pss_saltlen(pctx, -1));
+    return EVP_DigestVerify(ctx.get(), signature.data(), signature.size(), input.data(),
+                            input.size()) == 1;
+  }
+
+  bssl::UniquePtr<EVP_PKEY> pkey_;
+  MockPrivateKeyConnectionCallbacks callbacks_;
+  Event::MockDispatcher dispatcher_;
+  const std::vector<uint8_t> input_{'h', 'a', 'n', 'd', 's', 'h', 'a', 'k', 'e'};
+};
+
+TEST_F(ThreadPoolPrivateKeyMethodTest, Sign) {
+  PrivateKeyOperation operation = makeOperation(PrivateKeyOperation::Type::Sign, input_);
+  operation.signature_algorithm_ = SSL_SIGN_RSA_PSS_SHA256;
+  ThreadPoolPrivateKeyMethodProvider::perform(pkey_.get(), operation);
+  EXPECT_TRUE(operation.success_);
+  EXPECT_TRUE(verify(SSL_SIGN_RSA_PSS_SHA256, input_, operation.output_));
+}
+
+// Validate that the signature algorithm must match the type of the key.
+TEST_F(ThreadPoolPrivateKeyMethodTest, SignWrongKeyType) {
+  PrivateKeyOperation operation = makeOperation(PrivateKeyOperation::Type::Sign, input_);
+  operation.signature_algorithm_ = SSL_SIGN_ECDSA_SECP256R1_SHA256;
+  ThreadPoolPrivateKeyMethodProvider::perform(pkey_.get(), operation);
+  EXPECT_FALSE(operation.success_);
+}
+
+TEST_F(ThreadPoolPrivateKeyMethodTest, Decrypt) {
+  RSA* rsa = EVP_PKEY_get0_RSA(pkey_.get());
+  std::vector<uint8_t> encrypted(RSA_size(rsa));
+  size_t encrypted_len;
+  ASSERT_EQ(1, RSA_encrypt(rsa, &encrypted_len, encrypted.data(), encrypted.size(), input_.data(),
+                           input_.size(), RSA_PKCS1_PADDING));
+  encrypted.resize(encrypted_len);
+
+  PrivateKeyOperation operation = makeOperation(PrivateKeyOperation::Type::Decrypt, encrypted);
+  ThreadPoolPrivateKeyMethodProvider::perform(pkey_.get(), operation);
+  EXPECT_TRUE(operation.success_);
+  // The output is still padded.
+  ASSERT_EQ(static_cast<size_t>(RSA_size(rsa)), operation.output_.size());
+  EXPECT_EQ(input_, std::vector<uint8_t>(operation.output_.end() - input_.size(),
+                                         operation.output_.end()));
+}
+
+// Validate that an operation is completed on the pool and its result posted to the connection.
+TEST_F(ThreadPoolPrivateKeyMethodTest, AsyncSign) {
+  ThreadPoolPrivateKeyMethodProvider provider(loadKey(), 2);
+  const SSL_PRIVATE_KEY_METHOD* method = provider.getBoringSslPrivateKeyMethod();
+  bssl::UniquePtr<SSL_CTX> ctx(SSL_CTX_new(TLS_method()));
+  bssl::UniquePtr<SSL> ssl(SSL_new(ctx.get()));
+  provider.registerPrivateKeyMethod(ssl.get(), callbacks_, dispatcher_);
+
+  absl::Notification posted;
+  std::function<void()> completion;
+  EXPECT_CALL(dispatcher_, post(_)).WillOnce(Invoke([&](std::function<void()> callback) -> void {
+    completion = callback;
+    posted.Notify();
+  }));
+
+  std::vector<uint8_t> signature(EVP_PKEY_size(pkey_.get()));
+  size_t signature_len;
+  EXPECT_EQ(ssl_private_key_retry,
+            method->sign(ssl.get(), signature.data(), &signature_len, signature.size(),
+                         SSL_SIGN_RSA_PSS_SHA256, input_.data(), input_.size()));
+  posted.WaitForNotification();
+  EXPECT_EQ(ssl_private_key_retry,
+            method->complete(ssl.get(), signature.data(), &signature_len, signature.size()));
+
+  EXPECT_CALL(callbacks_, onPrivateKeyMethodComplete());
+  completion();
+  EXPECT_EQ(ssl_private_key_success,
+            method->complete(ssl.get(), signature.data(), &signature_len, signature.size()));
+  signature.resize(signature_len);
+  EXPECT_TRUE(verify(SSL_SIGN_RSA_PSS_SHA256, input_, signature));
+
+  provider.unregisterPrivateKeyMethod(ssl.get());
+}
+
+// Validate that the completion of an operation is not delivered once the connection is gone.
+TEST_F(ThreadPoolPrivateKeyMethodTest, UnregisterDuringOperation) {
+  ThreadPoolPrivateKeyMethodProvider provider(loadKey(), 1);
+  const SSL_PRIVATE_KEY_METHOD* method = provider.getBoringSslPrivateKeyMethod();
+  bssl::UniquePtr<SSL_CTX> ctx(SSL_CTX_new(TLS_method()));
+  bssl::UniquePtr<SSL> ssl(SSL_new(ctx.get()));
+  provider.registerPrivateKeyMethod(ssl.get(), callbacks_, dispatcher_);
+
+  absl::Notification posted;
+  std::function<void()> completion;
+  EXPECT_CALL(dispatcher_, post(_)).WillOnce(Invoke([&](std::function<void()> callback) -> void {
+    completion = callback;
+    posted.Notify();
+  }));
+
+  std::vector<uint8_t> signature(EVP_PKEY_size(pkey_.get()));
+  size_t signature_len;
+  EXPECT_EQ(ssl_private_key_retry,
+            method->sign(ssl.get(), signature.data(), &signature_len, signature.size(),
+                         SSL_SIGN_RSA_PSS_SHA256, input_.data(), input_.size()));
+  provider.unregisterPrivateKeyMethod(ssl.get());
+  provider.unregisterPrivateKeyMethod(ssl.get());
+  posted.WaitForNotification();
+
+  EXPECT_CALL(callbacks_, onPrivateKeyMethodComplete()).Times(0);
+  completion();
+  EXPECT_EQ(ssl_private_key_failure,
+            method->complete(ssl.get(), signature.data(), &signature_len, signature.size()));
+}
+
+} // namespace
+} // namespace ThreadPool
+} // namespace PrivateKeyProviders
+} // namespace Extensions
+} // namespace Envoy
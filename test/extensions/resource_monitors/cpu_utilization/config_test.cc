@@ -0,0 +1,34 @@
+#include "envoy/config/resource_monitor/cpu_utilization/v2alpha/cpu_utilization.pb.validate.h"
+#include "envoy/registry/registry.h"
+
+#include "server/resource_monitor_config_impl.h"
+
+#include "extensions/resource_monitors/cpu_utilization/config.h"
+
+#include "test/mocks/event/mocks.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace ResourceMonitors {
+namespace CpuUtilizationMonitor {
+
+TEST(CpuUtilizationMonitorFactoryTest, CreateMonitor) {
+  auto factory =
+      Registry::FactoryRegistry<Server::Configuration::ResourceMonitorFactory>::getFactory(
+          "envoy.resource_monitors.cpu_utilization");
+  EXPECT_NE(factory, nullptr);
+
+  envoy::config::resource_monitor::cpu_utilization::v2alpha::CpuUtilizationConfig config;
+  config.set_cpu_count(2);
+  Event::MockDispatcher dispatcher;
+  Server::Configuration::ResourceMonitorFactoryContextImpl context(dispatcher);
+  auto monitor = factory->createResourceMonitor(config, context);
+  EXPECT_NE(monitor, nullptr);
+}
+
+} // namespace CpuUtilizationMonitor
+} // namespace ResourceMonitors
+} // namespace Extensions
+} // namespace Envoy
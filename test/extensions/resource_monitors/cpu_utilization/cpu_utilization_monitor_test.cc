@@ -0,0 +1,100 @@
+#include "extensions/resource_monitors/cpu_utilization/cpu_utilization_monitor.h"
+
+#include "absl/types/optional.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::Return;
+
+namespace Envoy {
+namespace Extensions {
+namespace ResourceMonitors {
+namespace CpuUtilizationMonitor {
+
+class MockCpuStatsReader : public CpuStatsReader {
+public:
+  MockCpuStatsReader() {}
+
+  MOCK_METHOD0(processCpuTime, std::chrono::microseconds());
+  MOCK_METHOD0(monotonicTime, MonotonicTime());
+};
+
+class ResourcePressure : public Server::ResourceMonitor::Callbacks {
+public:
+  void onSuccess(const Server::ResourceUsage& usage) override {
+    pressure_ = usage.resource_pressure_;
+  }
+
+  void onFailure(const EnvoyException& error) override { error_ = error; }
+
+  bool hasPressure() const { return pressure_.has_value(); }
+  bool hasError() const { return error_.has_value(); }
+
+  double pressure() const { return *pressure_; }
+
+private:
+  absl::optional<double> pressure_;
+  absl::optional<EnvoyException> error_;
+};
+
+TEST(CpuUtilizationMonitorTest, ComputesCorrectUsage) {
+  envoy::config::resource_monitor::cpu_utilization::v2alpha::CpuUtilizationConfig config;
+  config.set_cpu_count(4);
+  auto stats_reader = std::make_unique<MockCpuStatsReader>();
+  MockCpuStatsReader& stats = *stats_reader;
+  const MonotonicTime start;
+  EXPECT_CALL(stats, processCpuTime()).WillOnce(Return(std::chrono::seconds(10)));
+  EXPECT_CALL(stats, monotonicTime()).WillOnce(Return(start));
+  std::unique_ptr<CpuUtilizationMonitor> monitor(
+      new CpuUtilizationMonitor(config, std::move(stats_reader)));
+
+  // 3 of the 4 CPUs were busy during the last second.
+  EXPECT_CALL(stats, processCpuTime()).WillOnce(Return(std::chrono::seconds(13)));
+  EXPECT_CALL(stats, monotonicTime()).WillOnce(Return(start + std::chrono::seconds(1)));
+  ResourcePressure resource;
+  monitor->updateResourceUsage(resource);
+  EXPECT_TRUE(resource.hasPressure());
+  EXPECT_FALSE(resource.hasError());
+  EXPECT_EQ(resource.pressure(), 0.75);
+
+  // The pressure only covers the time since the previous update.
+  EXPECT_CALL(stats, processCpuTime()).WillOnce(Return(std::chrono::seconds(14)));
+  EXPECT_CALL(stats, monotonicTime()).WillOnce(Return(start + std::chrono::seconds(2)));
+  monitor->updateResourceUsage(resource);
+  EXPECT_EQ(resource.pressure(), 0.25);
+
+  // Without elapsed time, the previous pressure is reported again.
+  EXPECT_CALL(stats, processCpuTime()).WillOnce(Return(std::chrono::seconds(14)));
+  EXPECT_CALL(stats, monotonicTime()).WillOnce(Return(start + std::chrono::seconds(2)));
+  monitor->updateResourceUsage(resource);
+  EXPECT_EQ(resource.pressure(), 0.25);
+}
+
+TEST(CpuUtilizationMonitorTest, ReportsFailure) {
+  envoy::config::resource_monitor::cpu_utilization::v2alpha::CpuUtilizationConfig config;
+  config.set_cpu_count(1);
+  auto stats_reader = std::make_unique<MockCpuStatsReader>();
+  MockCpuStatsReader& stats = *stats_reader;
+  EXPECT_CALL(stats, processCpuTime()).WillOnce(Return(std::chrono::seconds(0)));
+  EXPECT_CALL(stats, monotonicTime()).WillOnce(Return(MonotonicTime()));
+  CpuUtilizationMonitor monitor(config, std::move(stats_reader));
+
+  EXPECT_CALL(stats, processCpuTime())
+      .WillOnce(testing::Throw(EnvoyException("unable to get the CPU time of the process")));
+  ResourcePressure resource;
+  monitor.updateResourceUsage(resource);
+  EXPECT_FALSE(resource.hasPressure());
+  EXPECT_TRUE(resource.hasError());
+}
+
+TEST(CpuUtilizationMonitorTest, ReadsProcessCpuTime) {
+  CpuStatsReader stats;
+  const std::chrono::microseconds before = stats.processCpuTime();
+  EXPECT_LT(0, before.count());
+  EXPECT_LE(before, stats.processCpuTime());
+}
+
+} // namespace CpuUtilizationMonitor
+} // namespace ResourceMonitors
+} // namespace Extensions
+} // namespace Envoy
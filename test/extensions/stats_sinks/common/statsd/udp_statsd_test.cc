@@ -1,5 +1,6 @@
 #include <chrono>
 
+#include "common/common/utility.h"
 #include "common/network/address_impl.h"
 #include "common/network/utility.h"
 
@@ -15,7 +16,9 @@
 #include "gtest/gtest.h"
 #include "spdlog/spdlog.h"
 
+using testing::_;
 using testing::NiceMock;
+using testing::Return;
 
 namespace Envoy {
 namespace Extensions {
@@ -26,6 +29,23 @@ namespace Statsd {
 class MockWriter : public Writer {
 public:
   MOCK_METHOD1(write, void(const std::string& message));
+
+  // Each datagram of a batch shows up as a write().
+  void writeBatch(const std::vector<std::string>& datagrams, size_t count) override {
+    for (size_t i = 0; i < count; i++) {
+      write(datagrams[i]);
+    }
+  }
+};
+
+// Records the datagrams of each batch.
+class CapturingWriter : public Writer {
+public:
+  void writeBatch(const std::vector<std::string>& datagrams, size_t count) override {
+    batches_.emplace_back(datagrams.begin(), datagrams.begin() + count);
+  }
+
+  std::vector<std::vector<std::string>> batches_;
 };
 
 class UdpStatsdSinkTest : public testing::TestWithParam<Network::Address::IpVersion> {};
@@ -157,6 +177,132 @@ TEST(UdpStatsdSinkTest, CheckActualStats) {
   tls_.shutdownThread();
 }
 
+TEST(UdpStatsdSinkTest, SkipsUnchangedStats) {
+  NiceMock<Stats::MockSource> source;
+  auto writer_ptr = std::make_shared<NiceMock<MockWriter>>();
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  UdpStatsdSink sink(tls_, writer_ptr, false);
+
+  auto counter = std::make_shared<NiceMock<Stats::MockCounter>>();
+  counter->name_ = "test_counter";
+  counter->used_ = true;
+  source.counters_.push_back(counter);
+  auto gauge = std::make_shared<NiceMock<Stats::MockGauge>>();
+  gauge->name_ = "test_gauge";
+  gauge->value_ = 1;
+  gauge->used_ = true;
+  source.gauges_.push_back(gauge);
+
+  // Neither stat was updated since the previous flush, so there is nothing to send.
+  EXPECT_CALL(*counter, latchChanged()).WillOnce(Return(false));
+  EXPECT_CALL(*counter, latch()).Times(0);
+  EXPECT_CALL(*gauge, latchChanged()).WillOnce(Return(false));
+  EXPECT_CALL(*std::dynamic_pointer_cast<NiceMock<MockWriter>>(writer_ptr), write(_)).Times(0);
+  sink.flush(source);
+
+  tls_.shutdownThread();
+}
+
+TEST(UdpStatsdSinkTest, BatchesLinesIntoDatagrams) {
+  NiceMock<Stats::MockSource> source;
+  auto writer_ptr = std::make_shared<CapturingWriter>();
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  UdpStatsdSink sink(tls_, writer_ptr, false);
+
+  // Each line is 26 bytes, so 53 of them with their separators fit in a 1432 byte datagram.
+  std::vector<std::string> expected_lines;
+  for (int i = 0; i < 100; i++) {
+    auto counter = std::make_shared<NiceMock<Stats::MockCounter>>();
+    counter->name_ = fmt::format("test_counter_{:03}", i);
+    counter->used_ = true;
+    counter->latch_ = 1;
+    source.counters_.push_back(counter);
+    expected_lines.push_back(fmt::format("envoy.test_counter_{:03}:1|c", i));
+  }
+  auto gauge = std::make_shared<NiceMock<Stats::MockGauge>>();
+  gauge->name_ = "test_gauge";
+  gauge->value_ = 12345;
+  gauge->used_ = true;
+  source.gauges_.push_back(gauge);
+  expected_lines.push_back("envoy.test_gauge:12345|g");
+
+  sink.flush(source);
+
+  ASSERT_EQ(1U, writer_ptr->batches_.size());
+  const std::vector<std::string>& datagrams = writer_ptr->batches_[0];
+  ASSERT_EQ(2U, datagrams.size());
+  std::vector<std::string> lines;
+  for (const std::string& datagram : datagrams) {
+    EXPECT_LE(datagram.size(), 1432U);
+    for (absl::string_view line : StringUtil::splitToken(datagram, "\n")) {
+      lines.emplace_back(line);
+    }
+  }
+  EXPECT_EQ(53U, StringUtil::splitToken(datagrams[0], "\n").size());
+  EXPECT_EQ(expected_lines, lines);
+
+  tls_.shutdownThread();
+}
+
+TEST(UdpStatsdSinkTest, CachesFormattedNames) {
+  NiceMock<Stats::MockSource> source;
+  auto writer_ptr = std::make_shared<NiceMock<MockWriter>>();
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  UdpStatsdSink sink(tls_, writer_ptr, true);
+
+  std::vector<Stats::Tag> tags = {Stats::Tag{"key1", "value1"}};
+  auto counter = std::make_shared<NiceMock<Stats::MockCounter>>();
+  counter->name_ = "test_counter";
+  counter->used_ = true;
+  counter->latch_ = 1;
+  counter->tags_ = tags;
+  source.counters_.push_back(counter);
+
+  // The name and tags of a stat are only formatted the first time it is flushed.
+  EXPECT_CALL(*counter, tagExtractedName()).Times(1);
+  EXPECT_CALL(*counter, tags()).Times(1);
+  EXPECT_CALL(*writer_ptr, write("envoy.test_counter:1|c|#key1:value1")).Times(2);
+  sink.flush(source);
+  counter->latch_ = 2;
+  EXPECT_CALL(*writer_ptr, write("envoy.test_counter:2|c|#key1:value1"));
+  sink.flush(source);
+  counter->latch_ = 1;
+  sink.flush(source);
+
+  tls_.shutdownThread();
+}
+
+TEST(DatagramBatcherTest, LongLinesAndFullBatches) {
+  CapturingWriter writer;
+  DatagramBatcher batcher(writer, 16);
+
+  // A line that does not fit in a datagram is sent on its own.
+  batcher.add("a:", 1, "|c");
+  batcher.add("a_very_long_name:", 1, "|c");
+  batcher.add("b:", 2, "|c");
+  batcher.add("c:", 3, "|c");
+  batcher.flush();
+  ASSERT_EQ(1U, writer.batches_.size());
+  EXPECT_EQ((std::vector<std::string>{"a:1|c", "a_very_long_name:1|c", "b:2|c\nc:3|c"}),
+            writer.batches_[0]);
+
+  // Once a batch is full it is sent before the next datagram is started.
+  writer.batches_.clear();
+  for (int i = 0; i < 65; i++) {
+    batcher.add("a_very_long_name:", i, "|c");
+  }
+  batcher.flush();
+  ASSERT_EQ(2U, writer.batches_.size());
+  EXPECT_EQ(64U, writer.batches_[0].size());
+  ASSERT_EQ(1U, writer.batches_[1].size());
+  EXPECT_EQ("a_very_long_name:64|c", writer.batches_[1][0]);
+
+  // Nothing is sent when nothing was added.
+  writer.batches_.clear();
+  batcher.flush();
+  EXPECT_TRUE(writer.batches_.empty());
+}
+
 TEST(UdpStatsdSinkWithTagsTest, CheckActualStats) {
   NiceMock<Stats::MockSource> source;
   auto writer_ptr = std::make_shared<NiceMock<MockWriter>>();
@@ -328,6 +328,39 @@ TEST_F(HystrixSinkTest, BasicFlow) {
   validateResults(cluster_message_map[cluster1_name_], 0, 0, 0, 0, 0, window_size_);
 }
 
+// All the connected dashboards get the same event stream, which follows the counters as they
+// change between flushes.
+TEST_F(HystrixSinkTest, MultipleDashboards) {
+  Buffer::OwnedImpl buffer = createClusterAndCallbacks();
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> callbacks2;
+  Buffer::OwnedImpl buffer2;
+  ON_CALL(callbacks2, encodeData(_, _))
+      .WillByDefault(Invoke([&buffer2](Buffer::Instance& data, bool) { buffer2.add(data); }));
+  sink_->registerConnection(&callbacks_);
+  sink_->registerConnection(&callbacks2);
+
+  sink_->flush(source_);
+  for (uint64_t i = 0; i < window_size_; i++) {
+    buffer.drain(buffer.length());
+    buffer2.drain(buffer2.length());
+    ON_CALL(cluster1_.success_counter_, value()).WillByDefault(Return(i + 1));
+    sink_->flush(source_);
+    EXPECT_EQ(buffer.toString(), buffer2.toString());
+  }
+
+  Json::ObjectSharedPtr json_buffer =
+      Json::Factory::loadFromString(buildClusterMap(buffer2.toString())[cluster1_name_]);
+  EXPECT_EQ(window_size_, json_buffer->getInteger("rollingCountSuccess"));
+
+  // Once the traffic stops, the window empties out.
+  for (uint64_t i = 0; i < window_size_; i++) {
+    buffer2.drain(buffer2.length());
+    sink_->flush(source_);
+  }
+  json_buffer = Json::Factory::loadFromString(buildClusterMap(buffer2.toString())[cluster1_name_]);
+  EXPECT_EQ(0, json_buffer->getInteger("rollingCountSuccess"));
+}
+
 //
 TEST_F(HystrixSinkTest, Disconnect) {
   InSequence s;
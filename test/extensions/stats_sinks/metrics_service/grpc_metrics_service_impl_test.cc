@@ -1,3 +1,7 @@
+#include <limits>
+
+#include "common/common/fmt.h"
+
 #include "extensions/stat_sinks/metrics_service/grpc_metrics_service_impl.h"
 
 #include "test/mocks/common.h"
@@ -89,9 +93,11 @@ public:
 class TestGrpcMetricsStreamer : public GrpcMetricsStreamer {
 public:
   int metric_count;
+  std::vector<envoy::service::metrics::v2::StreamMetricsMessage> messages_;
   // GrpcMetricsStreamer
   void send(envoy::service::metrics::v2::StreamMetricsMessage& message) {
     metric_count = message.envoy_metrics_size();
+    messages_.push_back(message);
   }
 };
 
@@ -153,6 +159,91 @@ TEST(MetricsServiceSinkTest, CheckStatsCount) {
   EXPECT_EQ(1, (*streamer_).metric_count);
 }
 
+TEST(MetricsServiceSinkTest, MaxMetricsPerMessage) {
+  NiceMock<Stats::MockSource> source;
+  NiceMock<MockTimeSystem> mock_time;
+  std::shared_ptr<TestGrpcMetricsStreamer> streamer_{new TestGrpcMetricsStreamer()};
+
+  MetricsServiceSink sink(streamer_, mock_time, 2);
+
+  for (int i = 0; i < 3; i++) {
+    auto counter = std::make_shared<NiceMock<Stats::MockCounter>>();
+    counter->name_ = fmt::format("test_counter_{}", i);
+    counter->value_ = i;
+    counter->used_ = true;
+    source.counters_.push_back(counter);
+  }
+  for (int i = 0; i < 2; i++) {
+    auto gauge = std::make_shared<NiceMock<Stats::MockGauge>>();
+    gauge->name_ = fmt::format("test_gauge_{}", i);
+    gauge->value_ = i;
+    gauge->used_ = true;
+    source.gauges_.push_back(gauge);
+  }
+
+  // The metrics are split across messages of at most two metric families.
+  sink.flush(source);
+  ASSERT_EQ(3U, streamer_->messages_.size());
+  EXPECT_EQ(2, streamer_->messages_[0].envoy_metrics_size());
+  EXPECT_EQ(2, streamer_->messages_[1].envoy_metrics_size());
+  EXPECT_EQ(1, streamer_->messages_[2].envoy_metrics_size());
+  EXPECT_EQ("test_counter_0", streamer_->messages_[0].envoy_metrics(0).name());
+  EXPECT_EQ("test_counter_2", streamer_->messages_[1].envoy_metrics(0).name());
+  EXPECT_EQ(io::prometheus::client::MetricType::GAUGE,
+            streamer_->messages_[1].envoy_metrics(1).type());
+  EXPECT_EQ("test_gauge_1", streamer_->messages_[2].envoy_metrics(0).name());
+  EXPECT_EQ(1, streamer_->messages_[2].envoy_metrics(0).metric(0).gauge().value());
+
+  // The same number of metrics is sent the same way on the next flush.
+  streamer_->messages_.clear();
+  sink.flush(source);
+  ASSERT_EQ(3U, streamer_->messages_.size());
+  EXPECT_EQ(1, streamer_->messages_[2].envoy_metrics_size());
+  EXPECT_EQ(1, streamer_->messages_[2].envoy_metrics(0).metric_size());
+
+  // Even when there is nothing to report, a message is sent.
+  source.counters_.clear();
+  source.gauges_.clear();
+  streamer_->messages_.clear();
+  sink.flush(source);
+  ASSERT_EQ(1U, streamer_->messages_.size());
+  EXPECT_EQ(0, streamer_->messages_[0].envoy_metrics_size());
+}
+
+TEST(MetricsServiceSinkTest, ReportCountersAsDeltas) {
+  NiceMock<Stats::MockSource> source;
+  NiceMock<MockTimeSystem> mock_time;
+  std::shared_ptr<TestGrpcMetricsStreamer> streamer_{new TestGrpcMetricsStreamer()};
+
+  MetricsServiceSink sink(streamer_, mock_time, std::numeric_limits<uint32_t>::max(), true);
+
+  auto counter = std::make_shared<NiceMock<Stats::MockCounter>>();
+  counter->name_ = "test_counter";
+  counter->value_ = 5;
+  counter->used_ = true;
+  source.counters_.push_back(counter);
+
+  sink.flush(source);
+  ASSERT_EQ(1, streamer_->messages_.back().envoy_metrics_size());
+  EXPECT_EQ(5, streamer_->messages_.back().envoy_metrics(0).metric(0).counter().value());
+
+  counter->value_ = 8;
+  sink.flush(source);
+  ASSERT_EQ(1, streamer_->messages_.back().envoy_metrics_size());
+  EXPECT_EQ(3, streamer_->messages_.back().envoy_metrics(0).metric(0).counter().value());
+
+  // A counter that did not change since the previous flush is not reported.
+  EXPECT_CALL(*counter, latchChanged()).WillOnce(Return(false));
+  sink.flush(source);
+  EXPECT_EQ(0, streamer_->messages_.back().envoy_metrics_size());
+
+  // After a reset, the value since the reset is reported.
+  counter->value_ = 2;
+  sink.flush(source);
+  ASSERT_EQ(1, streamer_->messages_.back().envoy_metrics_size());
+  EXPECT_EQ(2, streamer_->messages_.back().envoy_metrics(0).metric(0).counter().value());
+}
+
 } // namespace MetricsService
 } // namespace StatSinks
 } // namespace Extensions
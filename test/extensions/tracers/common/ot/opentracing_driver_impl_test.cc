@@ -183,6 +183,40 @@ TEST_F(OpenTracingDriverTest, ExtractWithUnindexedHeader) {
   EXPECT_EQ(spans.at(1).span_context.span_id, spans.at(0).references.at(0).span_id);
 }
 
+// Injecting a context into headers which already carry one overwrites it.
+TEST_F(OpenTracingDriverTest, InjectOverwritesContext) {
+  opentracing::mocktracer::PropagationOptions propagation_options;
+  propagation_options.propagation_key = "unindexed-header";
+  setupValidDriver(OpenTracingDriver::PropagationMode::TracerNative, propagation_options);
+
+  Tracing::SpanPtr first_span = driver_->startSpan(config_, request_headers_, operation_name_,
+                                                   start_time_, {Tracing::Reason::Sampling, true});
+  first_span->injectContext(request_headers_);
+  Tracing::SpanPtr second_span = driver_->startSpan(config_, request_headers_, operation_name_,
+                                                    start_time_, {Tracing::Reason::Sampling, true});
+  second_span->injectContext(request_headers_);
+
+  int num_contexts = 0;
+  request_headers_.iterate(
+      [](const Http::HeaderEntry& header, void* context) -> Http::HeaderMap::Iterate {
+        if (header.key() == "unindexed-header") {
+          ++*static_cast<int*>(context);
+        }
+        return Http::HeaderMap::Iterate::Continue;
+      },
+      &num_contexts);
+  EXPECT_EQ(1, num_contexts);
+
+  Tracing::SpanPtr third_span = driver_->startSpan(config_, request_headers_, operation_name_,
+                                                   start_time_, {Tracing::Reason::Sampling, true});
+  third_span->finishSpan();
+  second_span->finishSpan();
+  first_span->finishSpan();
+
+  auto spans = driver_->recorder().spans();
+  EXPECT_EQ(spans.at(1).span_context.span_id, spans.at(0).references.at(0).span_id);
+}
+
 } // namespace Ot
 } // namespace Common
 } // namespace Tracers
@@ -26,7 +26,7 @@ namespace Zipkin {
 class TestReporterImpl : public Reporter {
 public:
   TestReporterImpl(int value) : value_(value) {}
-  void reportSpan(const Span& span) { reported_spans_.push_back(span); }
+  void reportSpan(Span&& span) { reported_spans_.push_back(std::move(span)); }
   int getValue() { return value_; }
   std::vector<Span>& reportedSpans() { return reported_spans_; }
 
@@ -285,13 +285,15 @@ TEST_F(ZipkinTracerTest, finishSpan) {
 
   // Finishing a server-side span with an SR annotation must add an SS annotation
   server_side->finish();
-  EXPECT_EQ(2ULL, server_side->annotations().size());
 
-  // Test if the reporter's reportSpan method was actually called upon finishing the span
+  // Test if the reporter's reportSpan method was actually called upon finishing the span, which
+  // moves the span to the reporter
   EXPECT_EQ(1ULL, reporter_object->reportedSpans().size());
+  const Span& reported_span = reporter_object->reportedSpans()[0];
+  EXPECT_EQ(2ULL, reported_span.annotations().size());
 
   // Check the SR annotation added at span-creation time
-  ann = server_side->annotations()[0];
+  ann = reported_span.annotations()[0];
   EXPECT_EQ(ZipkinCoreConstants::get().SERVER_RECV, ann.value());
   // Annotation's timestamp must be set
   EXPECT_EQ(
@@ -302,7 +304,7 @@ TEST_F(ZipkinTracerTest, finishSpan) {
   EXPECT_EQ("my_service_name", endpoint.serviceName());
 
   // Check the SS annotation added when ending the span
-  ann = server_side->annotations()[1];
+  ann = reported_span.annotations()[1];
   EXPECT_EQ(ZipkinCoreConstants::get().SERVER_SEND, ann.value());
   EXPECT_NE(0ULL, ann.timestamp()); // annotation's timestamp must be set
   EXPECT_TRUE(ann.isSetEndpoint());
@@ -363,6 +363,48 @@ TEST_F(TsiSocketTest, HandshakeWithInternalError) {
   raw_handshaker->vtable = vtable;
 }
 
+// Handshake data received while the handshaker is busy is handed over as soon as it is done.
+TEST_F(TsiSocketTest, HandshakeDataReceivedDuringNext) {
+  initialize(nullptr, nullptr);
+
+  // Defer the handshaker callbacks, as an asynchronous handshaker would.
+  std::vector<Event::PostCb> posted;
+  ON_CALL(dispatcher_, post(_)).WillByDefault(Invoke([&](Event::PostCb cb) {
+    posted.push_back(cb);
+  }));
+  auto run_posted = [&posted]() {
+    std::vector<Event::PostCb> callbacks;
+    callbacks.swap(posted);
+    for (const auto& cb : callbacks) {
+      cb();
+    }
+  };
+
+  client_.tsi_socket_->doWrite(client_.write_buffer_, false);
+  run_posted();
+  const std::string client_init = client_to_server_.toString();
+  EXPECT_EQ(makeFakeTsiFrame("CLIENT_INIT"), client_init);
+
+  // The server receives the first half of the ClientInit and passes it to the handshaker.
+  client_to_server_.drain(client_to_server_.length());
+  client_to_server_.add(client_init.substr(0, 5));
+  expectIoResult({Network::PostIoAction::KeepOpen, 0UL, false},
+                 server_.tsi_socket_->doRead(server_.read_buffer_));
+
+  // The rest is received before the handshaker is done.
+  client_to_server_.add(client_init.substr(5));
+  expectIoResult({Network::PostIoAction::KeepOpen, 0UL, false},
+                 server_.tsi_socket_->doRead(server_.read_buffer_));
+  EXPECT_EQ(0L, client_to_server_.length());
+
+  // Once done, the handshaker is called again with the rest without waiting for a read event.
+  EXPECT_CALL(server_.callbacks_, setReadBufferReady()).Times(0);
+  run_posted();
+  EXPECT_EQ(1U, posted.size());
+  run_posted();
+  EXPECT_EQ(makeFakeTsiFrame("SERVER_INIT"), server_to_client_.toString());
+}
+
 class TsiSocketFactoryTest : public testing::Test {
 protected:
   void SetUp() override {
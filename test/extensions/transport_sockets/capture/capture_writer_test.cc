@@ -0,0 +1,101 @@
+#include <fstream>
+#include <vector>
+
+#include "common/protobuf/protobuf.h"
+#include "common/stats/isolated_store_impl.h"
+
+#include "extensions/transport_sockets/capture/capture_writer.h"
+
+#include "test/test_common/environment.h"
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Capture {
+namespace {
+
+using envoy::config::transport_socket::capture::v2alpha::FileSink;
+
+class CaptureWriterTest : public testing::Test {
+public:
+  CaptureWriterTest() : stats_{ALL_CAPTURE_STATS(POOL_COUNTER_PREFIX(store_, "capture."))} {}
+
+  static TracePtr makeTrace(uint64_t id, const std::string& data) {
+    TracePtr trace = std::make_unique<envoy::data::tap::v2alpha::Trace>();
+    trace->mutable_connection()->set_id(id);
+    trace->add_events()->mutable_read()->set_data(data);
+    return trace;
+  }
+
+  Stats::IsolatedStoreImpl store_;
+  CaptureStats stats_;
+};
+
+TEST_F(CaptureWriterTest, BinaryProto) {
+  const std::string path = TestEnvironment::temporaryPath("capture_writer_binary.pb");
+  CaptureWriter writer(1024, stats_);
+  EXPECT_TRUE(writer.write(path, FileSink::PROTO_BINARY, makeTrace(1, "hello"), 5, true));
+  writer.flush();
+  EXPECT_EQ(1, stats_.traces_written_.value());
+
+  envoy::data::tap::v2alpha::Trace trace;
+  MessageUtil::loadFromFile(path, trace);
+  EXPECT_EQ(1, trace.connection().id());
+  EXPECT_EQ("hello", trace.events(0).read().data());
+}
+
+TEST_F(CaptureWriterTest, LengthDelimitedProto) {
+  const std::string path = TestEnvironment::temporaryPath("capture_writer_delimited.pb_length");
+  CaptureWriter writer(1024, stats_);
+  EXPECT_TRUE(
+      writer.write(path, FileSink::PROTO_BINARY_LENGTH_DELIMITED, makeTrace(2, "foo"), 3, false));
+  EXPECT_TRUE(
+      writer.write(path, FileSink::PROTO_BINARY_LENGTH_DELIMITED, makeTrace(2, "bar"), 3, true));
+  writer.flush();
+  EXPECT_EQ(2, stats_.traces_written_.value());
+
+  std::ifstream stream(path, std::ios::binary);
+  Protobuf::io::IstreamInputStream input_stream(&stream);
+  std::vector<std::string> data;
+  envoy::data::tap::v2alpha::Trace trace;
+  bool clean_eof = false;
+  while (ProtobufUtil::ParseDelimitedFromZeroCopyStream(&trace, &input_stream, &clean_eof)) {
+    EXPECT_EQ(2, trace.connection().id());
+    data.push_back(trace.events(0).read().data());
+  }
+  EXPECT_TRUE(clean_eof);
+  EXPECT_EQ((std::vector<std::string>{"foo", "bar"}), data);
+}
+
+// Traces which don't fit in the pending bytes are dropped.
+TEST_F(CaptureWriterTest, MaxPendingBytes) {
+  CaptureWriter writer(0, stats_);
+  EXPECT_FALSE(writer.write(TestEnvironment::temporaryPath("capture_writer_dropped.pb"),
+                            FileSink::PROTO_BINARY, makeTrace(3, "hello"), 5, true));
+  writer.flush();
+  EXPECT_EQ(1, stats_.traces_dropped_.value());
+  EXPECT_EQ(0, stats_.traces_written_.value());
+}
+
+// The traces queued are written before the writer is destroyed.
+TEST_F(CaptureWriterTest, WriteOnDestruction) {
+  const std::string path = TestEnvironment::temporaryPath("capture_writer_destruction.pb_text");
+  {
+    CaptureWriter writer(1024, stats_);
+    EXPECT_TRUE(writer.write(path, FileSink::PROTO_TEXT, makeTrace(4, "hello"), 5, true));
+  }
+  EXPECT_EQ(1, stats_.traces_written_.value());
+
+  envoy::data::tap::v2alpha::Trace trace;
+  MessageUtil::loadFromFile(path, trace);
+  EXPECT_EQ(4, trace.connection().id());
+}
+
+} // namespace
+} // namespace Capture
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
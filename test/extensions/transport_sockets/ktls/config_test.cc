@@ -0,0 +1,41 @@
+#include "envoy/config/transport_socket/ktls/v2alpha/ktls.pb.validate.h"
+
+#include "extensions/transport_sockets/ktls/config.h"
+
+#include "test/mocks/server/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Ktls {
+namespace {
+
+TEST(KtlsConfigTest, NotTlsTransportSocket) {
+  NiceMock<Server::Configuration::MockTransportSocketFactoryContext> context;
+  envoy::config::transport_socket::ktls::v2alpha::Ktls config;
+  config.mutable_transport_socket()->set_name("raw_buffer");
+
+  UpstreamKtlsSocketConfigFactory factory;
+  EXPECT_THROW_WITH_MESSAGE(factory.createTransportSocketFactory(config, context), EnvoyException,
+                            "kTLS transport socket must wrap a 'tls' transport socket, not "
+                            "'raw_buffer'");
+}
+
+TEST(KtlsConfigTest, MissingTransportSocket) {
+  NiceMock<Server::Configuration::MockTransportSocketFactoryContext> context;
+  envoy::config::transport_socket::ktls::v2alpha::Ktls config;
+
+  DownstreamKtlsSocketConfigFactory factory;
+  EXPECT_THROW(factory.createTransportSocketFactory(config, context, {}), ProtoValidationException);
+}
+
+} // namespace
+} // namespace Ktls
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,69 @@
+#include "common/buffer/buffer_impl.h"
+#include "common/stats/isolated_store_impl.h"
+
+#include "extensions/transport_sockets/ktls/ktls.h"
+
+#include "test/mocks/network/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::NiceMock;
+using testing::Return;
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Ktls {
+namespace {
+
+class KtlsSocketTest : public testing::Test {
+public:
+  KtlsSocketTest()
+      : stats_{ALL_KTLS_STATS(POOL_COUNTER_PREFIX(store_, "ktls."))},
+        inner_socket_(new NiceMock<Network::MockTransportSocket>()),
+        socket_(Network::TransportSocketPtr{inner_socket_}, stats_) {
+    EXPECT_CALL(*inner_socket_, setTransportSocketCallbacks(_));
+    socket_.setTransportSocketCallbacks(callbacks_);
+  }
+
+  Stats::IsolatedStoreImpl store_;
+  KtlsStats stats_;
+  NiceMock<Network::MockTransportSocketCallbacks> callbacks_;
+  NiceMock<Network::MockTransportSocket>* inner_socket_;
+  KtlsSocket socket_;
+};
+
+// Validate that a socket which does not wrap a TLS socket is never offloaded, and passes all the
+// I/O through to the wrapped socket.
+TEST_F(KtlsSocketTest, NotTlsPassthrough) {
+  Buffer::OwnedImpl buffer("data");
+
+  EXPECT_CALL(*inner_socket_, doRead(_))
+      .WillOnce(Return(Network::IoResult{Network::PostIoAction::KeepOpen, 4, false}));
+  Network::IoResult result = socket_.doRead(buffer);
+  EXPECT_EQ(4, result.bytes_processed_);
+
+  EXPECT_CALL(*inner_socket_, doWrite(_, true))
+      .WillOnce(Return(Network::IoResult{Network::PostIoAction::KeepOpen, 4, false}));
+  result = socket_.doWrite(buffer, true);
+  EXPECT_EQ(4, result.bytes_processed_);
+
+  EXPECT_CALL(*inner_socket_, protocol()).WillOnce(Return("h2"));
+  EXPECT_EQ("h2", socket_.protocol());
+
+  EXPECT_CALL(*inner_socket_, closeSocket(Network::ConnectionEvent::LocalClose));
+  socket_.closeSocket(Network::ConnectionEvent::LocalClose);
+
+  EXPECT_FALSE(socket_.offloaded());
+  EXPECT_FALSE(socket_.passthrough());
+  EXPECT_EQ(0, store_.counter("ktls.offloaded").value());
+  EXPECT_EQ(0, store_.counter("ktls.not_offloaded").value());
+}
+
+} // namespace
+} // namespace Ktls
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
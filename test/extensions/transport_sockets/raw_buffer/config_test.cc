@@ -0,0 +1,61 @@
+#include "envoy/config/transport_socket/raw_buffer/v2alpha/raw_buffer.pb.validate.h"
+
+#include "common/network/raw_buffer_socket.h"
+
+#include "extensions/transport_sockets/raw_buffer/config.h"
+
+#include "test/mocks/server/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace RawBuffer {
+namespace {
+
+uint64_t initialReadSize(Network::TransportSocketFactory& factory) {
+  Network::TransportSocketPtr socket = factory.createTransportSocket();
+  return dynamic_cast<Network::RawBufferSocket&>(*socket).readSize();
+}
+
+TEST(RawBufferConfigTest, EmptyConfig) {
+  NiceMock<Server::Configuration::MockTransportSocketFactoryContext> context;
+  UpstreamRawBufferSocketFactory factory;
+  Network::TransportSocketFactoryPtr socket_factory =
+      factory.createTransportSocketFactory(*factory.createEmptyConfigProto(), context);
+  EXPECT_FALSE(socket_factory->implementsSecureTransport());
+  EXPECT_EQ(Network::ReadSizing::DefaultReadSize, initialReadSize(*socket_factory));
+}
+
+TEST(RawBufferConfigTest, ReadSizing) {
+  NiceMock<Server::Configuration::MockTransportSocketFactoryContext> context;
+  envoy::config::transport_socket::raw_buffer::v2alpha::RawBuffer config;
+  config.mutable_read_sizing()->mutable_min_read_size()->set_value(1024);
+  config.mutable_read_sizing()->mutable_max_read_size()->set_value(4096);
+
+  DownstreamRawBufferSocketFactory factory;
+  Network::TransportSocketFactoryPtr socket_factory =
+      factory.createTransportSocketFactory(config, context, {});
+  EXPECT_EQ(4096, initialReadSize(*socket_factory));
+}
+
+TEST(RawBufferConfigTest, MinExceedsMax) {
+  NiceMock<Server::Configuration::MockTransportSocketFactoryContext> context;
+  envoy::config::transport_socket::raw_buffer::v2alpha::RawBuffer config;
+  config.mutable_read_sizing()->mutable_min_read_size()->set_value(8192);
+  config.mutable_read_sizing()->mutable_max_read_size()->set_value(4096);
+
+  UpstreamRawBufferSocketFactory factory;
+  EXPECT_THROW_WITH_MESSAGE(factory.createTransportSocketFactory(config, context), EnvoyException,
+                            "raw_buffer: min_read_size (8192) exceeds max_read_size (4096)");
+}
+
+} // namespace
+} // namespace RawBuffer
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
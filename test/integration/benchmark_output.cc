@@ -0,0 +1,25 @@
+#include "test/integration/benchmark_output.h"
+
+#include <fstream>
+#include <iostream>
+
+#include "test/test_common/environment.h"
+
+namespace Envoy {
+
+void BenchmarkOutput::write(const std::string& name, const std::string& json) {
+  std::cout << json << std::endl;
+  absl::optional<std::string> path = TestEnvironment::getOptionalEnvVar("ENVOY_BENCHMARK_OUTPUT");
+  if (!path.has_value()) {
+    const absl::optional<std::string> outputs_dir =
+        TestEnvironment::getOptionalEnvVar("TEST_UNDECLARED_OUTPUTS_DIR");
+    if (!outputs_dir.has_value()) {
+      return;
+    }
+    path = outputs_dir.value() + "/" + name + ".json";
+  }
+  std::ofstream output(path.value(), std::ios_base::app);
+  output << json << std::endl;
+}
+
+} // namespace Envoy
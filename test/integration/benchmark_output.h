@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+
+namespace Envoy {
+
+/**
+ * Output of the integration benchmarks, which report each case as one line of JSON.
+ */
+class BenchmarkOutput {
+public:
+  /**
+   * Prints a result to stdout and appends it to $ENVOY_BENCHMARK_OUTPUT when set, or else to
+   * <name>.json in the test's undeclared outputs directory when Bazel provides one.
+   * @param name the benchmark, naming its output file.
+   * @param json the result as a single line JSON object.
+   */
+  static void write(const std::string& name, const std::string& json);
+};
+
+} // namespace Envoy
@@ -269,6 +269,10 @@ void BaseIntegrationTest::createEnvoy() {
       ports.push_back(upstream->localAddress()->ip()->port());
     }
   }
+  createEnvoyWithUpstreamPorts(ports);
+}
+
+void BaseIntegrationTest::createEnvoyWithUpstreamPorts(const std::vector<uint32_t>& ports) {
   config_helper_.finalize(ports);
 
   ENVOY_LOG_MISC(debug, "Running Envoy with configuration {}",
@@ -130,6 +130,9 @@ public:
   virtual void createUpstreams();
   // Finalize the config and spin up an Envoy instance.
   virtual void createEnvoy();
+  // Finalize the config with the given ports for the static cluster hosts, in the order the hosts
+  // appear in the config, and spin up an Envoy instance.
+  void createEnvoyWithUpstreamPorts(const std::vector<uint32_t>& ports);
   // Sets upstream_protocol_ and alters the upstream protocol in the config_helper_
   void setUpstreamProtocol(FakeHttpConnection::Type protocol);
   // Sets fake_upstreams_count_ and alters the upstream protocol in the config_helper_
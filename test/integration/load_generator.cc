@@ -0,0 +1,454 @@
+#include "test/integration/load_generator.h"
+
+#include <pthread.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#include "envoy/network/connection.h"
+
+#include "common/buffer/buffer_impl.h"
+#include "common/common/assert.h"
+#include "common/common/fmt.h"
+#include "common/common/macros.h"
+#include "common/http/codec_client.h"
+#include "common/network/filter_impl.h"
+
+#include "test/common/upstream/utility.h"
+#include "test/integration/autonomous_upstream.h"
+#include "test/mocks/upstream/mocks.h"
+#include "test/test_common/malloc_counter.h"
+#include "test/test_common/network_utility.h"
+#include "test/test_common/utility.h"
+
+namespace Envoy {
+namespace {
+
+std::chrono::nanoseconds timevalToDuration(const timeval& tv) {
+  return std::chrono::seconds(tv.tv_sec) + std::chrono::microseconds(tv.tv_usec);
+}
+
+std::chrono::nanoseconds processCpuTime() {
+  rusage usage;
+  RELEASE_ASSERT(getrusage(RUSAGE_SELF, &usage) == 0, "");
+  return timevalToDuration(usage.ru_utime) + timevalToDuration(usage.ru_stime);
+}
+
+std::chrono::nanoseconds threadCpuTime(clockid_t clock) {
+  timespec ts;
+  RELEASE_ASSERT(clock_gettime(clock, &ts) == 0, "");
+  return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+} // namespace
+
+/**
+ * A load generator thread with its own dispatcher and share of the connections.
+ */
+class LoadGenerator::Worker {
+public:
+  Worker(LoadGenerator& parent, uint32_t connections)
+      : parent_(parent), options_(parent.options_), connections_(connections) {
+    const uint64_t payload_bytes = std::max<uint64_t>(1, options_.request_body_bytes_);
+    payload_ = std::string(options_.protocol_ == LoadProtocol::Tcp ? payload_bytes
+                                                                   : options_.request_body_bytes_,
+                           'a');
+    // Sized for a few seconds of load at a high rate, so that measuring rarely allocates.
+    latencies_.reserve(1 << 20);
+  }
+
+  // Starts the thread and waits until its connections have been created.
+  void start() {
+    thread_ = std::make_unique<Thread::Thread>([this]() -> void { threadRoutine(); });
+    Thread::LockGuard lock(lock_);
+    while (!started_) {
+      started_cond_.wait(lock_);
+    }
+  }
+
+  void stop() {
+    dispatcher_->exit();
+    thread_->join();
+  }
+
+  std::chrono::nanoseconds cpuTime() const { return threadCpuTime(cpu_clock_); }
+
+  // Only touched by the worker thread, and read once it has been joined.
+  uint64_t requests_{};
+  uint64_t errors_{};
+  std::vector<uint64_t> latencies_;
+
+private:
+  class Client {
+  public:
+    virtual ~Client() {}
+    virtual void connect() PURE;
+    virtual void close() PURE;
+  };
+
+  typedef std::unique_ptr<Client> ClientPtr;
+
+  /**
+   * An HTTP connection keeping requests_per_connection_ streams in flight.
+   */
+  class HttpClient : public Client, public Network::ConnectionCallbacks {
+  public:
+    HttpClient(Worker& worker) : worker_(worker) {}
+
+    // Client
+    void connect() override {
+      codec_ = std::make_unique<Http::CodecClientProd>(
+          worker_.options_.protocol_ == LoadProtocol::Http2 ? Http::CodecClient::Type::HTTP2
+                                                            : Http::CodecClient::Type::HTTP1,
+          worker_.createConnection(), worker_.host_description_, *worker_.dispatcher_);
+      codec_->addConnectionCallbacks(*this);
+      const uint32_t streams = worker_.options_.protocol_ == LoadProtocol::Http2
+                                   ? std::max(1U, worker_.options_.requests_per_connection_)
+                                   : 1;
+      while (streams_.size() < streams) {
+        streams_.emplace_back(new Stream(*this));
+      }
+      for (auto& stream : streams_) {
+        stream->send();
+      }
+    }
+    void close() override {
+      if (codec_ != nullptr) {
+        codec_->close();
+      }
+    }
+
+    // Network::ConnectionCallbacks
+    void onEvent(Network::ConnectionEvent event) override {
+      if (event != Network::ConnectionEvent::RemoteClose &&
+          event != Network::ConnectionEvent::LocalClose) {
+        return;
+      }
+      // The codec resets the streams of the connection before this is called.
+      worker_.dispatcher_->deferredDelete(std::move(codec_));
+      if (!worker_.stopping_) {
+        connect();
+      }
+    }
+    void onAboveWriteBufferHighWatermark() override {}
+    void onBelowWriteBufferLowWatermark() override {}
+
+  private:
+    class Stream : public Http::StreamDecoder, public Http::StreamCallbacks {
+    public:
+      Stream(HttpClient& parent) : parent_(parent) {}
+
+      void send() {
+        Worker& worker = parent_.worker_;
+        start_ = std::chrono::steady_clock::now();
+        failed_ = false;
+        Http::StreamEncoder& encoder = parent_.codec_->newStream(*this);
+        encoder.getStream().addCallbacks(*this);
+        encoder.encodeHeaders(worker.request_headers_, worker.payload_.empty());
+        if (!worker.payload_.empty()) {
+          Buffer::OwnedImpl body(worker.payload_);
+          encoder.encodeData(body, true);
+        }
+      }
+
+      // Http::StreamDecoder
+      void decode100ContinueHeaders(Http::HeaderMapPtr&&) override {}
+      void decodeHeaders(Http::HeaderMapPtr&& headers, bool end_stream) override {
+        failed_ = headers->Status() == nullptr || headers->Status()->value() != "200";
+        if (end_stream) {
+          onComplete();
+        }
+      }
+      void decodeData(Buffer::Instance&, bool end_stream) override {
+        if (end_stream) {
+          onComplete();
+        }
+      }
+      void decodeTrailers(Http::HeaderMapPtr&&) override { onComplete(); }
+
+      // Http::StreamCallbacks
+      void onResetStream(Http::StreamResetReason reason) override {
+        Worker& worker = parent_.worker_;
+        if (worker.stopping_) {
+          return;
+        }
+        worker.onRequestComplete(start_, false);
+        // Streams of a closed connection are started again once it is replaced, so a stream reset
+        // on its own replaces the whole connection.
+        if (reason != Http::StreamResetReason::ConnectionFailure &&
+            reason != Http::StreamResetReason::ConnectionTermination) {
+          worker.dispatcher_->post([&parent = parent_]() -> void {
+            if (!parent.worker_.stopping_) {
+              parent.close();
+            }
+          });
+        }
+      }
+      void onAboveWriteBufferHighWatermark() override {}
+      void onBelowWriteBufferLowWatermark() override {}
+
+    private:
+      void onComplete() {
+        parent_.worker_.onRequestComplete(start_, !failed_);
+        if (!parent_.worker_.stopping_) {
+          send();
+        }
+      }
+
+      HttpClient& parent_;
+      std::chrono::steady_clock::time_point start_;
+      bool failed_{};
+    };
+
+    Worker& worker_;
+    std::unique_ptr<Http::CodecClient> codec_;
+    std::vector<std::unique_ptr<Stream>> streams_;
+  };
+
+  /**
+   * A TCP connection sending one payload at a time and waiting for the same number of bytes back.
+   */
+  class TcpClient : public Client, public Network::ConnectionCallbacks {
+  public:
+    TcpClient(Worker& worker) : worker_(worker) {}
+
+    // Client
+    void connect() override {
+      connection_ = worker_.createConnection();
+      connection_->addConnectionCallbacks(*this);
+      connection_->addReadFilter(Network::ReadFilterSharedPtr{new ReadFilterAdapter(*this)});
+      connection_->connect();
+      send();
+    }
+    void close() override {
+      if (connection_ != nullptr) {
+        connection_->close(Network::ConnectionCloseType::NoFlush);
+      }
+    }
+
+    // Network::ConnectionCallbacks
+    void onEvent(Network::ConnectionEvent event) override {
+      if (event != Network::ConnectionEvent::RemoteClose &&
+          event != Network::ConnectionEvent::LocalClose) {
+        return;
+      }
+      worker_.dispatcher_->deferredDelete(std::move(connection_));
+      if (!worker_.stopping_) {
+        worker_.onRequestComplete(start_, false);
+        connect();
+      }
+    }
+    void onAboveWriteBufferHighWatermark() override {}
+    void onBelowWriteBufferLowWatermark() override {}
+
+  private:
+    // The connection owns its read filters, while the client outlives its connections.
+    class ReadFilterAdapter : public Network::ReadFilterBaseImpl {
+    public:
+      ReadFilterAdapter(TcpClient& parent) : parent_(parent) {}
+
+      // Network::ReadFilter
+      Network::FilterStatus onData(Buffer::Instance& data, bool) override {
+        parent_.onData(data);
+        return Network::FilterStatus::StopIteration;
+      }
+
+    private:
+      TcpClient& parent_;
+    };
+
+    void onData(Buffer::Instance& data) {
+      received_ += data.length();
+      data.drain(data.length());
+      if (received_ >= worker_.payload_.size()) {
+        worker_.onRequestComplete(start_, true);
+        if (!worker_.stopping_) {
+          send();
+        }
+      }
+    }
+
+    void send() {
+      start_ = std::chrono::steady_clock::now();
+      received_ = 0;
+      Buffer::OwnedImpl payload(worker_.payload_);
+      connection_->write(payload, false);
+    }
+
+    Worker& worker_;
+    Network::ClientConnectionPtr connection_;
+    std::chrono::steady_clock::time_point start_;
+    uint64_t received_{};
+  };
+
+  void threadRoutine() {
+    dispatcher_ = parent_.api_.allocateDispatcher(parent_.time_system_);
+    RELEASE_ASSERT(pthread_getcpuclockid(pthread_self(), &cpu_clock_) == 0, "");
+    if (options_.protocol_ != LoadProtocol::Tcp) {
+      cluster_ = std::make_shared<testing::NiceMock<Upstream::MockClusterInfo>>();
+      host_description_ = Upstream::makeTestHostDescription(
+          cluster_, fmt::format("tcp://{}", parent_.address_->asString()));
+      request_headers_.addCopy(":method", payload_.empty() ? "GET" : "POST");
+      request_headers_.addCopy(":path", "/");
+      request_headers_.addCopy(":scheme", "http");
+      request_headers_.addCopy(":authority", "host");
+      request_headers_.addCopy(AutonomousStream::RESPONSE_SIZE_BYTES,
+                               std::to_string(options_.response_body_bytes_));
+      if (!payload_.empty()) {
+        request_headers_.addCopy("content-length", std::to_string(payload_.size()));
+      }
+    }
+
+    for (uint32_t i = 0; i < connections_; i++) {
+      if (options_.protocol_ == LoadProtocol::Tcp) {
+        clients_.emplace_back(new TcpClient(*this));
+      } else {
+        clients_.emplace_back(new HttpClient(*this));
+      }
+      clients_.back()->connect();
+    }
+
+    {
+      Thread::LockGuard lock(lock_);
+      started_ = true;
+      started_cond_.notifyOne();
+    }
+    dispatcher_->run(Event::Dispatcher::RunType::RunUntilExit);
+
+    stopping_ = true;
+    for (ClientPtr& client : clients_) {
+      client->close();
+    }
+    dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+    dispatcher_->clearDeferredDeleteList();
+    clients_.clear();
+    dispatcher_.reset();
+  }
+
+  Network::ClientConnectionPtr createConnection() {
+    return dispatcher_->createClientConnection(parent_.address_, nullptr,
+                                               Network::Test::createRawBufferSocket(), nullptr);
+  }
+
+  void onRequestComplete(std::chrono::steady_clock::time_point start, bool success) {
+    if (!parent_.measuring_.load(std::memory_order_relaxed)) {
+      return;
+    }
+    if (!success) {
+      errors_++;
+      return;
+    }
+    requests_++;
+    latencies_.push_back(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                             start)
+            .count());
+  }
+
+  LoadGenerator& parent_;
+  const LoadGeneratorOptions& options_;
+  const uint32_t connections_;
+  std::string payload_;
+  std::unique_ptr<Thread::Thread> thread_;
+  Thread::MutexBasicLockable lock_;
+  Thread::CondVar started_cond_;
+  bool started_ GUARDED_BY(lock_){};
+  clockid_t cpu_clock_{};
+  Event::DispatcherPtr dispatcher_;
+  std::shared_ptr<Upstream::MockClusterInfo> cluster_;
+  Upstream::HostDescriptionConstSharedPtr host_description_;
+  Http::TestHeaderMapImpl request_headers_;
+  std::vector<ClientPtr> clients_;
+  bool stopping_{};
+};
+
+LoadGenerator::LoadGenerator(Api::Api& api, Event::TimeSystem& time_system,
+                             Network::Address::InstanceConstSharedPtr address,
+                             const LoadGeneratorOptions& options)
+    : api_(api), time_system_(time_system), address_(std::move(address)), options_(options) {}
+
+LoadGenerator::~LoadGenerator() {}
+
+const std::vector<double>& LoadGenerator::percentiles() {
+  CONSTRUCT_ON_FIRST_USE(std::vector<double>, {50, 90, 99, 99.9, 100});
+}
+
+LoadGeneratorResult LoadGenerator::run() {
+  ASSERT(workers_.empty());
+  const uint32_t threads = std::max(1U, options_.threads_);
+  for (uint32_t i = 0; i < threads; i++) {
+    const uint32_t connections =
+        options_.connections_ / threads + (i < options_.connections_ % threads ? 1 : 0);
+    workers_.emplace_back(new Worker(*this, connections));
+    workers_.back()->start();
+  }
+  std::this_thread::sleep_for(options_.warmup_);
+
+  LoadGeneratorResult result;
+  MallocCounter malloc_counter;
+  std::chrono::nanoseconds worker_cpu_start{};
+  for (const WorkerPtr& worker : workers_) {
+    worker_cpu_start += worker->cpuTime();
+  }
+  const std::chrono::nanoseconds process_cpu_start = processCpuTime();
+  const auto start = std::chrono::steady_clock::now();
+  measuring_ = true;
+
+  std::this_thread::sleep_for(options_.duration_);
+
+  measuring_ = false;
+  result.elapsed_ = std::chrono::steady_clock::now() - start;
+  result.process_cpu_ = processCpuTime() - process_cpu_start;
+  result.allocations_counted_ = MallocCounter::supported();
+  result.allocations_ = malloc_counter.count();
+  for (const WorkerPtr& worker : workers_) {
+    result.load_generator_cpu_ += worker->cpuTime();
+  }
+  result.load_generator_cpu_ -= worker_cpu_start;
+
+  std::vector<uint64_t> latencies;
+  for (const WorkerPtr& worker : workers_) {
+    worker->stop();
+    result.requests_ += worker->requests_;
+    result.errors_ += worker->errors_;
+    latencies.insert(latencies.end(), worker->latencies_.begin(), worker->latencies_.end());
+  }
+  workers_.clear();
+
+  std::sort(latencies.begin(), latencies.end());
+  for (const double percentile : percentiles()) {
+    uint64_t latency = 0;
+    if (!latencies.empty()) {
+      const size_t rank = static_cast<size_t>(std::ceil(percentile / 100 * latencies.size()));
+      latency = latencies[std::min(latencies.size(), std::max<size_t>(rank, 1)) - 1];
+    }
+    result.latencies_.emplace_back(percentile, std::chrono::nanoseconds(latency));
+  }
+  return result;
+}
+
+double LoadGeneratorResult::requestsPerSecond() const {
+  return elapsed_.count() > 0 ? requests_ * 1e9 / elapsed_.count() : 0;
+}
+
+std::string LoadGeneratorResult::toJson(const std::string& name) const {
+  const double requests = std::max<uint64_t>(1, requests_);
+  std::string latencies;
+  for (const auto& latency : latencies_) {
+    latencies += fmt::format("{}\"p{:g}\":{:.1f}", latencies.empty() ? "" : ",", latency.first,
+                             latency.second.count() / 1e3);
+  }
+  return fmt::format("{{\"name\":\"{}\",\"requests\":{},\"errors\":{},\"duration_s\":{:.3f},"
+                     "\"rps\":{:.1f},\"latency_us\":{{{}}},\"cpu_us_per_request\":{:.3f},"
+                     "\"load_generator_cpu_us_per_request\":{:.3f},\"allocs_per_request\":{}}}",
+                     name, requests_, errors_, elapsed_.count() / 1e9, requestsPerSecond(),
+                     latencies, process_cpu_.count() / 1e3 / requests,
+                     load_generator_cpu_.count() / 1e3 / requests,
+                     allocations_counted_ ? fmt::format("{:.2f}", allocations_ / requests)
+                                          : "null");
+}
+
+} // namespace Envoy
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/api/api.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/event/timer.h"
+#include "envoy/network/address.h"
+
+#include "common/common/thread.h"
+
+namespace Envoy {
+
+/**
+ * The protocol a LoadGenerator speaks to the proxy. TCP load is a request/response exchange of
+ * fixed size payloads, which expects an echoing upstream behind the proxy.
+ */
+enum class LoadProtocol { Http1, Http2, Tcp };
+
+struct LoadGeneratorOptions {
+  LoadProtocol protocol_{LoadProtocol::Http1};
+  // The number of load generator threads, each with its own dispatcher.
+  uint32_t threads_{1};
+  // The number of connections, spread evenly over the threads.
+  uint32_t connections_{16};
+  // The number of requests each connection keeps in flight. Only HTTP/2 supports more than one.
+  uint32_t requests_per_connection_{1};
+  // The request body size of HTTP requests and the payload size of TCP requests.
+  uint64_t request_body_bytes_{0};
+  // The response body size asked of the AutonomousUpstream by HTTP requests.
+  uint64_t response_body_bytes_{10};
+  // Load is generated for warmup_ before measuring starts, then measured for duration_.
+  std::chrono::milliseconds warmup_{1000};
+  std::chrono::milliseconds duration_{5000};
+};
+
+/**
+ * The outcome of the measured part of a run. CPU and allocations are those of the whole process,
+ * which includes the proxy, the upstreams and the load generator when they all run in process.
+ */
+struct LoadGeneratorResult {
+  // Latency percentiles, as pairs of percentile and latency.
+  typedef std::vector<std::pair<double, std::chrono::nanoseconds>> Percentiles;
+
+  /**
+   * @return std::string the result as a single line JSON object, with the given name.
+   */
+  std::string toJson(const std::string& name) const;
+
+  double requestsPerSecond() const;
+
+  uint64_t requests_{};
+  uint64_t errors_{};
+  std::chrono::nanoseconds elapsed_{};
+  Percentiles latencies_;
+  std::chrono::nanoseconds process_cpu_{};
+  std::chrono::nanoseconds load_generator_cpu_{};
+  // Only set in builds where allocations can be counted. @see MallocCounter.
+  bool allocations_counted_{};
+  uint64_t allocations_{};
+};
+
+/**
+ * Drives closed loop load against a proxy listener: every connection issues its next request as
+ * soon as a response completes, so throughput is bounded by the proxy and not by a request rate.
+ * Latencies are measured from the start of a request to the end of its response.
+ */
+class LoadGenerator {
+public:
+  LoadGenerator(Api::Api& api, Event::TimeSystem& time_system,
+                Network::Address::InstanceConstSharedPtr address,
+                const LoadGeneratorOptions& options);
+  ~LoadGenerator();
+
+  /**
+   * Runs the load generator threads for the warmup and the measured duration, blocking until they
+   * are done.
+   * @return LoadGeneratorResult the numbers of the measured duration.
+   */
+  LoadGeneratorResult run();
+
+  // The percentiles reported by run().
+  static const std::vector<double>& percentiles();
+
+private:
+  class Worker;
+  typedef std::unique_ptr<Worker> WorkerPtr;
+
+  Api::Api& api_;
+  Event::TimeSystem& time_system_;
+  const Network::Address::InstanceConstSharedPtr address_;
+  const LoadGeneratorOptions options_;
+  // Set by run() for the measured duration. Workers only count requests completed while it is set.
+  std::atomic<bool> measuring_{};
+  std::vector<WorkerPtr> workers_;
+};
+
+} // namespace Envoy
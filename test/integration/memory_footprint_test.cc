@@ -0,0 +1,267 @@
+// Usage: bazel test //test/integration:memory_footprint_test -c opt --test_output=streamed
+//
+// Measures the heap memory Envoy spends per cluster, host, listener and route. Each measurement
+// brings Envoy up twice in process, with a base number of objects and with
+// $ENVOY_BENCHMARK_OBJECTS (default 100) more, and divides the difference in bytes allocated once
+// the server is up by the number of added objects. Clusters are also measured with TLS, health
+// checks, outlier detection and a ring hash load balancer, each reported on its own and over a
+// plain cluster, so the cost of every subsystem can be read off. Every measurement also reports
+// the stats created per object and an estimate of their bytes.
+//
+// Results are printed as one JSON line per case, and written like those of proxy_benchmark_test.
+// Memory can only be measured in tcmalloc builds; elsewhere the cases do nothing.
+
+#include <unistd.h>
+
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/api/v2/cds.pb.h"
+#include "envoy/config/bootstrap/v2/bootstrap.pb.h"
+#include "envoy/config/filter/network/http_connection_manager/v2/http_connection_manager.pb.h"
+#include "envoy/config/metrics/v2/stats.pb.h"
+
+#include "common/common/fmt.h"
+#include "common/memory/stats.h"
+#include "common/stats/heap_stat_data.h"
+#include "common/stats/stats_options_impl.h"
+#include "common/stats/tag_producer_impl.h"
+#include "common/stats/thread_local_store.h"
+
+#include "test/integration/benchmark_output.h"
+#include "test/integration/integration.h"
+#include "test/test_common/environment.h"
+#include "test/test_common/logging.h"
+#include "test/test_common/network_utility.h"
+
+#include "absl/types/optional.h"
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace {
+
+typedef std::function<void(envoy::config::bootstrap::v2::Bootstrap&, uint32_t)> AddObjectsFunction;
+typedef std::function<void(envoy::api::v2::Cluster&)> ClusterModifierFunction;
+
+// What an Envoy brought up with some objects holds in memory.
+struct Footprint {
+  uint64_t bytes_;
+  // Counters and gauges.
+  uint64_t stats_;
+};
+
+/**
+ * Brings Envoy up with the default HTTP proxy config plus the objects added by a function. Every
+ * static host points at a port which is bound but not listening, so health checks fail at once
+ * instead of holding connections in process.
+ */
+class FootprintServer : public BaseIntegrationTest {
+public:
+  FootprintServer(const AddObjectsFunction& add_objects, uint32_t objects)
+      : BaseIntegrationTest(TestEnvironment::getIpVersionsForTest()[0]),
+        closed_port_(Network::Test::bindFreeLoopbackPort(version_,
+                                                         Network::Address::SocketType::Stream)),
+        objects_(objects) {
+    config_helper_.addConfigModifier(
+        [add_objects, objects](envoy::config::bootstrap::v2::Bootstrap& bootstrap) -> void {
+          add_objects(bootstrap, objects);
+        });
+  }
+
+  ~FootprintServer() {
+    test_server_.reset();
+    ::close(closed_port_.second);
+  }
+
+  Footprint measure() {
+    initialize();
+    return {Memory::Stats::totalCurrentlyAllocated(),
+            test_server_->counters().size() + test_server_->gauges().size()};
+  }
+
+  void createUpstreams() override {}
+
+  void createEnvoy() override {
+    // Enough ports for the default cluster plus any cluster or host added per object.
+    createEnvoyWithUpstreamPorts(
+        std::vector<uint32_t>(2 * objects_ + 2, closed_port_.first->ip()->port()));
+  }
+
+private:
+  const std::pair<Network::Address::InstanceConstSharedPtr, int> closed_port_;
+  const uint32_t objects_;
+};
+
+class MemoryFootprintTest : public testing::Test {
+public:
+  MemoryFootprintTest()
+      : objects_(std::stoul(
+            TestEnvironment::getOptionalEnvVar("ENVOY_BENCHMARK_OBJECTS").value_or("100"))) {}
+
+  static bool supported() {
+    if (Memory::Stats::totalCurrentlyAllocated() == 0) {
+      std::cout << "memory can only be measured in tcmalloc builds" << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Measures the bytes and stats per object added by add_objects, over base_objects objects, and
+   * reports them as the case named name.
+   * @return double the bytes per object.
+   */
+  double measure(const std::string& name, const AddObjectsFunction& add_objects,
+                 uint32_t base_objects = 0, absl::optional<double> baseline = absl::nullopt) {
+    const Footprint base = FootprintServer(add_objects, base_objects).measure();
+    const Footprint added = FootprintServer(add_objects, base_objects + objects_).measure();
+    const double bytes_per_object = (static_cast<double>(added.bytes_) - base.bytes_) / objects_;
+    const double stats_per_object = (static_cast<double>(added.stats_) - base.stats_) / objects_;
+    static const double bytes_per_stat = bytesPerStat();
+    const std::string bytes_over_baseline =
+        baseline.has_value() ? fmt::format("{:.0f}", bytes_per_object - baseline.value()) : "null";
+
+    BenchmarkOutput::write(
+        "memory_footprint",
+        fmt::format("{{\"name\":\"{}\",\"objects\":{},\"bytes_per_object\":{:.0f},"
+                    "\"bytes_over_baseline\":{},\"stats_per_object\":{:.1f},"
+                    "\"stats_bytes_per_object\":{:.0f}}}",
+                    name, objects_, bytes_per_object, bytes_over_baseline, stats_per_object,
+                    stats_per_object * bytes_per_stat));
+    EXPECT_LT(0, bytes_per_object);
+    return bytes_per_object;
+  }
+
+  // Adds clusters like the default one, altered by modifier.
+  static AddObjectsFunction addClusters(const ClusterModifierFunction& modifier) {
+    return [modifier](envoy::config::bootstrap::v2::Bootstrap& bootstrap, uint32_t count) -> void {
+      auto* static_resources = bootstrap.mutable_static_resources();
+      const envoy::api::v2::Cluster base_cluster = static_resources->clusters(0);
+      for (uint32_t i = 0; i < count; i++) {
+        auto* cluster = static_resources->add_clusters();
+        cluster->MergeFrom(base_cluster);
+        cluster->set_name(fmt::format("cluster_{}", i + 1));
+        modifier(*cluster);
+      }
+    };
+  }
+
+  const uint32_t objects_;
+
+private:
+  // Estimates the bytes of a stat, by creating counters named like cluster stats in a store set up
+  // like the server's.
+  static double bytesPerStat() {
+    static const uint32_t StatCount = 10000;
+    Stats::HeapStatDataAllocator allocator;
+    Stats::StatsOptionsImpl options;
+    Stats::ThreadLocalStoreImpl store(options, allocator);
+    store.setTagProducer(
+        std::make_unique<Stats::TagProducerImpl>(envoy::config::metrics::v2::StatsConfig()));
+
+    const uint64_t start = Memory::Stats::totalCurrentlyAllocated();
+    for (uint32_t i = 0; i < StatCount; i++) {
+      store.counter(fmt::format("cluster.cluster_{}.upstream_rq_total", i));
+    }
+    return (static_cast<double>(Memory::Stats::totalCurrentlyAllocated()) - start) / StatCount;
+  }
+
+  // Logging at the test default level would be measured along with the server.
+  LogLevelSetter log_level_{spdlog::level::err};
+};
+
+// Static clusters with one host each, and the cost of the subsystems they can enable.
+TEST_F(MemoryFootprintTest, Clusters) {
+  if (!supported()) {
+    return;
+  }
+
+  const double baseline = measure("cluster", addClusters([](envoy::api::v2::Cluster&) -> void {}));
+  measure("cluster_tls", addClusters([](envoy::api::v2::Cluster& cluster) -> void {
+            cluster.mutable_tls_context()->set_sni("example.com");
+          }),
+          0, baseline);
+  measure("cluster_health_check", addClusters([](envoy::api::v2::Cluster& cluster) -> void {
+            auto* health_check = cluster.add_health_checks();
+            health_check->mutable_timeout()->set_seconds(1);
+            health_check->mutable_interval()->set_seconds(60);
+            health_check->mutable_unhealthy_threshold()->set_value(1);
+            health_check->mutable_healthy_threshold()->set_value(1);
+            health_check->mutable_http_health_check()->set_path("/healthcheck");
+          }),
+          0, baseline);
+  measure("cluster_outlier_detection", addClusters([](envoy::api::v2::Cluster& cluster) -> void {
+            cluster.mutable_outlier_detection();
+          }),
+          0, baseline);
+  measure("cluster_ring_hash", addClusters([](envoy::api::v2::Cluster& cluster) -> void {
+            cluster.set_lb_policy(envoy::api::v2::Cluster::RING_HASH);
+          }),
+          0, baseline);
+}
+
+// Hosts of a single static cluster.
+TEST_F(MemoryFootprintTest, Hosts) {
+  if (!supported()) {
+    return;
+  }
+
+  measure("host",
+          [](envoy::config::bootstrap::v2::Bootstrap& bootstrap, uint32_t count) -> void {
+            auto* static_resources = bootstrap.mutable_static_resources();
+            auto* cluster = static_resources->add_clusters();
+            cluster->MergeFrom(static_resources->clusters(0));
+            cluster->set_name("cluster_1");
+            for (uint32_t i = 1; i < count; i++) {
+              cluster->add_hosts()->MergeFrom(cluster->hosts(0));
+            }
+          },
+          1);
+}
+
+// Listeners like the default one, each with its own HTTP connection manager.
+TEST_F(MemoryFootprintTest, Listeners) {
+  if (!supported()) {
+    return;
+  }
+
+  measure("listener", [](envoy::config::bootstrap::v2::Bootstrap& bootstrap,
+                         uint32_t count) -> void {
+    auto* static_resources = bootstrap.mutable_static_resources();
+    const envoy::api::v2::Listener base_listener = static_resources->listeners(0);
+    for (uint32_t i = 0; i < count; i++) {
+      auto* listener = static_resources->add_listeners();
+      listener->MergeFrom(base_listener);
+      listener->set_name(fmt::format("listener_{}", i + 1));
+    }
+  });
+}
+
+// Prefix routes in the virtual host of the default listener.
+TEST_F(MemoryFootprintTest, Routes) {
+  if (!supported()) {
+    return;
+  }
+
+  measure("route", [](envoy::config::bootstrap::v2::Bootstrap& bootstrap, uint32_t count) -> void {
+    auto* filter = bootstrap.mutable_static_resources()
+                       ->mutable_listeners(0)
+                       ->mutable_filter_chains(0)
+                       ->mutable_filters(0);
+    envoy::config::filter::network::http_connection_manager::v2::HttpConnectionManager hcm;
+    MessageUtil::jsonConvert(filter->config(), hcm);
+    auto* virtual_host = hcm.mutable_route_config()->mutable_virtual_hosts(0);
+    for (uint32_t i = 0; i < count; i++) {
+      auto* route = virtual_host->add_routes();
+      route->mutable_match()->set_prefix(fmt::format("/route_{}", i));
+      route->mutable_route()->set_cluster("cluster_0");
+    }
+    MessageUtil::jsonConvert(hcm, *filter->mutable_config());
+  });
+}
+
+} // namespace
+} // namespace Envoy
@@ -0,0 +1,180 @@
+// Usage: bazel test //test/integration:proxy_benchmark_test -c opt --test_output=streamed
+//
+// Boots Envoy in process against an AutonomousUpstream, or an echoing upstream for TCP, and drives
+// closed loop HTTP/1, HTTP/2 and TCP load through it from the LoadGenerator. Every case prints one
+// JSON line with its RPS, latency percentiles, CPU per request and, in tcmalloc builds, allocations
+// per request. The lines are also appended to $ENVOY_BENCHMARK_OUTPUT when set, or else to
+// proxy_benchmark.json in the test's undeclared outputs directory.
+//
+// CPU and allocations are those of the whole process, so they include the upstream and the load
+// generator. The load generator's own CPU is reported separately. Compare numbers between builds
+// on the same machine rather than as absolute figures.
+//
+// The load is shaped with environment variables, e.g. --test_env=ENVOY_BENCHMARK_CONNECTIONS=64:
+//   ENVOY_BENCHMARK_THREADS                   load generator threads (default 1)
+//   ENVOY_BENCHMARK_CONNECTIONS               connections over all threads (default 16)
+//   ENVOY_BENCHMARK_REQUESTS_PER_CONNECTION   HTTP/2 streams in flight per connection (default 1)
+//   ENVOY_BENCHMARK_REQUEST_BODY_BYTES        request body or TCP payload size (default 0)
+//   ENVOY_BENCHMARK_RESPONSE_BODY_BYTES       HTTP response body size (default 10)
+//   ENVOY_BENCHMARK_WARMUP_MS                 unmeasured load before measuring (default 1000)
+//   ENVOY_BENCHMARK_DURATION_MS               measured load (default 5000)
+
+#include <string>
+
+#include "envoy/config/bootstrap/v2/bootstrap.pb.h"
+
+#include "common/common/fmt.h"
+#include "common/network/utility.h"
+
+#include "extensions/filters/network/echo/echo.h"
+
+#include "test/integration/benchmark_output.h"
+#include "test/integration/integration.h"
+#include "test/integration/load_generator.h"
+#include "test/test_common/environment.h"
+#include "test/test_common/logging.h"
+#include "test/test_common/network_utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace {
+
+uint64_t envVarOrDefault(const std::string& name, uint64_t default_value) {
+  const absl::optional<std::string> value = TestEnvironment::getOptionalEnvVar(name);
+  return value.has_value() ? std::stoull(value.value()) : default_value;
+}
+
+std::string protocolName(LoadProtocol protocol) {
+  switch (protocol) {
+  case LoadProtocol::Http1:
+    return "http1";
+  case LoadProtocol::Http2:
+    return "http2";
+  case LoadProtocol::Tcp:
+    return "tcp";
+  }
+  NOT_REACHED_GCOVR_EXCL_LINE;
+}
+
+/**
+ * An upstream which echoes the data of every connection back, for TCP load.
+ */
+class EchoUpstream : public FakeUpstream {
+public:
+  EchoUpstream(Network::Address::IpVersion version)
+      : FakeUpstream(0, FakeHttpConnection::Type::HTTP1, version) {}
+
+  // Network::FilterChainFactory
+  bool createNetworkFilterChain(Network::Connection& connection,
+                                const std::vector<Network::FilterFactoryCb>&) override {
+    connection.addReadFilter(std::make_shared<Extensions::NetworkFilters::Echo::EchoFilter>());
+    return true;
+  }
+};
+
+class ProxyBenchmarkTest : public BaseIntegrationTest,
+                           public testing::TestWithParam<LoadProtocol> {
+public:
+  ProxyBenchmarkTest()
+      : BaseIntegrationTest(TestEnvironment::getIpVersionsForTest()[0],
+                            GetParam() == LoadProtocol::Tcp ? ConfigHelper::TCP_PROXY_CONFIG
+                                                            : ConfigHelper::HTTP_PROXY_CONFIG) {
+    options_.protocol_ = GetParam();
+    options_.threads_ = envVarOrDefault("ENVOY_BENCHMARK_THREADS", options_.threads_);
+    options_.connections_ = envVarOrDefault("ENVOY_BENCHMARK_CONNECTIONS", options_.connections_);
+    options_.requests_per_connection_ = envVarOrDefault("ENVOY_BENCHMARK_REQUESTS_PER_CONNECTION",
+                                                        options_.requests_per_connection_);
+    options_.request_body_bytes_ =
+        envVarOrDefault("ENVOY_BENCHMARK_REQUEST_BODY_BYTES", options_.request_body_bytes_);
+    options_.response_body_bytes_ =
+        envVarOrDefault("ENVOY_BENCHMARK_RESPONSE_BODY_BYTES", options_.response_body_bytes_);
+    options_.warmup_ = std::chrono::milliseconds(
+        envVarOrDefault("ENVOY_BENCHMARK_WARMUP_MS", options_.warmup_.count()));
+    options_.duration_ = std::chrono::milliseconds(
+        envVarOrDefault("ENVOY_BENCHMARK_DURATION_MS", options_.duration_.count()));
+
+    // The circuit breakers must not be what limits the load.
+    config_helper_.addConfigModifier([](envoy::config::bootstrap::v2::Bootstrap& bootstrap) {
+      auto* thresholds = bootstrap.mutable_static_resources()
+                             ->mutable_clusters(0)
+                             ->mutable_circuit_breakers()
+                             ->add_thresholds();
+      thresholds->mutable_max_connections()->set_value(1000000);
+      thresholds->mutable_max_pending_requests()->set_value(1000000);
+      thresholds->mutable_max_requests()->set_value(1000000);
+    });
+  }
+
+  ~ProxyBenchmarkTest() {
+    test_server_.reset();
+    fake_upstreams_.clear();
+  }
+
+  void createUpstreams() override {
+    if (GetParam() == LoadProtocol::Tcp) {
+      fake_upstreams_.emplace_back(new EchoUpstream(version_));
+    } else {
+      BaseIntegrationTest::createUpstreams();
+    }
+  }
+
+  void initialize() override {
+    if (GetParam() == LoadProtocol::Http2) {
+      config_helper_.setClientCodec(envoy::config::filter::network::http_connection_manager::v2::
+                                        HttpConnectionManager::HTTP2);
+      setUpstreamProtocol(FakeHttpConnection::Type::HTTP2);
+    }
+    autonomous_upstream_ = true;
+    BaseIntegrationTest::initialize();
+  }
+
+  // Runs the load against the listener and reports the result as the case named name.
+  void runBenchmark(const std::string& name) {
+    initialize();
+    const Network::Address::InstanceConstSharedPtr address = Network::Utility::resolveUrl(
+        fmt::format("tcp://{}:{}", Network::Test::getLoopbackAddressUrlString(version_),
+                    lookupPort("listener_0")));
+    LoadGenerator load_generator(*api_, test_time_.timeSystem(), address, options_);
+    const LoadGeneratorResult result = load_generator.run();
+    BenchmarkOutput::write("proxy_benchmark",
+                           result.toJson(fmt::format("{}_{}", name, protocolName(GetParam()))));
+
+    EXPECT_LT(0U, result.requests_);
+    EXPECT_EQ(0U, result.errors_);
+  }
+
+  LoadGeneratorOptions options_;
+
+private:
+  // Logging at the test default level would dominate the numbers.
+  LogLevelSetter log_level_{spdlog::level::err};
+};
+
+INSTANTIATE_TEST_CASE_P(Protocols, ProxyBenchmarkTest,
+                        testing::Values(LoadProtocol::Http1, LoadProtocol::Http2,
+                                        LoadProtocol::Tcp),
+                        [](const testing::TestParamInfo<LoadProtocol>& info) -> std::string {
+                          return protocolName(info.param);
+                        });
+
+// The default configuration: the HTTP connection manager with the router, or the TCP proxy.
+TEST_P(ProxyBenchmarkTest, Baseline) { runBenchmark("baseline"); }
+
+// Many connections with few requests each in flight, as seen at the edge.
+TEST_P(ProxyBenchmarkTest, ManyConnections) {
+  options_.connections_ = envVarOrDefault("ENVOY_BENCHMARK_CONNECTIONS", 512);
+  runBenchmark("many_connections");
+}
+
+// An HTTP filter chain with a filter in front of the router.
+TEST_P(ProxyBenchmarkTest, BufferFilter) {
+  if (GetParam() == LoadProtocol::Tcp) {
+    return;
+  }
+  config_helper_.addFilter(ConfigHelper::DEFAULT_BUFFER_FILTER);
+  runBenchmark("buffer_filter");
+}
+
+} // namespace
+} // namespace Envoy
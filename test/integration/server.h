@@ -5,6 +5,7 @@
 #include <list>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "envoy/server/options.h"
 #include "envoy/stats/stats.h"
@@ -55,6 +56,7 @@ public:
   const std::string& logFormat() const override { NOT_IMPLEMENTED_GCOVR_EXCL_LINE; }
   std::chrono::seconds parentShutdownTime() const override { return std::chrono::seconds(2); }
   const std::string& logPath() const override { return log_path_; }
+  uint32_t logAsyncBufferSize() const override { return 0; }
   uint64_t restartEpoch() const override { return 0; }
   std::chrono::milliseconds fileFlushIntervalMsec() const override {
     return std::chrono::milliseconds(50);
@@ -66,6 +68,19 @@ public:
   uint64_t maxStats() const override { return 16384; }
   const Stats::StatsOptions& statsOptions() const override { return stats_options_; }
   bool hotRestartDisabled() const override { return false; }
+  bool hotRestartTransferConnections() const override { return false; }
+  bool ioUringEnabled() const override { return false; }
+  std::chrono::milliseconds coarseTimerResolution() const override {
+    return std::chrono::milliseconds(0);
+  }
+  const std::vector<uint32_t>& workerCpus() const override { return worker_cpus_; }
+  bool workerNumaLocalMemory() const override { return false; }
+  bool reusePortIncomingCpu() const override { return false; }
+  bool dispatcherStatsEnabled() const override { return false; }
+  std::chrono::milliseconds dispatcherStallThreshold() const override {
+    return std::chrono::milliseconds(0);
+  }
+  uint32_t hugePageArenaSizeMb() const override { return 0; }
 
   // asConfigYaml returns a new config that empties the configPath() and populates configYaml()
   Server::TestOptionsImpl asConfigYaml();
@@ -80,6 +95,7 @@ private:
   const std::string service_zone_;
   Stats::StatsOptionsImpl stats_options_;
   const std::string log_path_;
+  const std::vector<uint32_t> worker_cpus_;
 };
 
 class TestDrainManager : public DrainManager {
@@ -1,7 +1,9 @@
 #include "ssl_integration_test.h"
 
+#include <fstream>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "envoy/config/transport_socket/capture/v2alpha/capture.pb.h"
 #include "envoy/data/tap/v2alpha/capture.pb.h"
@@ -207,9 +209,11 @@ public:
       envoy::config::transport_socket::capture::v2alpha::Capture capture_config;
       auto* file_sink = capture_config.mutable_file_sink();
       file_sink->set_path_prefix(path_prefix_);
-      file_sink->set_format(
-          text_format_ ? envoy::config::transport_socket::capture::v2alpha::FileSink::PROTO_TEXT
-                       : envoy::config::transport_socket::capture::v2alpha::FileSink::PROTO_BINARY);
+      file_sink->set_format(format_);
+      capture_config.set_max_bytes_per_connection(max_bytes_per_connection_);
+      if (sampled_percent_ < 100) {
+        capture_config.mutable_sampling()->set_numerator(sampled_percent_);
+      }
       capture_config.mutable_transport_socket()->MergeFrom(ssl_transport_socket);
       MessageUtil::jsonConvert(capture_config, *transport_socket->mutable_config());
       // Nuke TLS context from legacy location.
@@ -219,8 +223,28 @@ public:
     SslIntegrationTest::initialize();
   }
 
+  // Returns the value of a capture counter of the listener.
+  uint64_t captureCounter(const std::string& name) {
+    for (const auto& counter : test_server_->counters()) {
+      if (absl::EndsWith(counter->name(), ".capture." + name)) {
+        return counter->value();
+      }
+    }
+    return 0;
+  }
+
+  // Traces are written by a background thread once the connections are closed.
+  void waitForTracesWritten(uint64_t value) {
+    while (captureCounter("traces_written") < value) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+
   std::string path_prefix_ = TestEnvironment::temporaryPath("ssl_trace");
-  bool text_format_{};
+  envoy::config::transport_socket::capture::v2alpha::FileSink::Format format_{
+      envoy::config::transport_socket::capture::v2alpha::FileSink::PROTO_BINARY};
+  uint64_t max_bytes_per_connection_{};
+  uint32_t sampled_percent_{100};
 };
 
 INSTANTIATE_TEST_CASE_P(IpVersions, SslCaptureIntegrationTest,
@@ -256,6 +280,7 @@ TEST_P(SslCaptureIntegrationTest, TwoRequestsWithBinaryProto) {
                                              expected_remote_address);
   codec_client_->close();
   test_server_->waitForCounterGe("http.config_test.downstream_cx_destroy", 1);
+  waitForTracesWritten(1);
   envoy::data::tap::v2alpha::Trace trace;
   MessageUtil::loadFromFile(fmt::format("{}_{}.pb", path_prefix_, first_id), trace);
   // Validate general expected properties in the trace.
@@ -282,6 +307,7 @@ TEST_P(SslCaptureIntegrationTest, TwoRequestsWithBinaryProto) {
   checkStats();
   codec_client_->close();
   test_server_->waitForCounterGe("http.config_test.downstream_cx_destroy", 2);
+  waitForTracesWritten(2);
   MessageUtil::loadFromFile(fmt::format("{}_{}.pb", path_prefix_, second_id), trace);
   // Validate second connection ID.
   EXPECT_EQ(second_id, trace.connection().id());
@@ -292,7 +318,7 @@ TEST_P(SslCaptureIntegrationTest, TwoRequestsWithBinaryProto) {
 
 // Validate a single request with text proto output.
 TEST_P(SslCaptureIntegrationTest, RequestWithTextProto) {
-  text_format_ = true;
+  format_ = envoy::config::transport_socket::capture::v2alpha::FileSink::PROTO_TEXT;
   ConnectionCreationFunction creator = [&]() -> Network::ClientConnectionPtr {
     return makeSslClientConnection(false, false);
   };
@@ -301,6 +327,7 @@ TEST_P(SslCaptureIntegrationTest, RequestWithTextProto) {
   checkStats();
   codec_client_->close();
   test_server_->waitForCounterGe("http.config_test.downstream_cx_destroy", 1);
+  waitForTracesWritten(1);
   envoy::data::tap::v2alpha::Trace trace;
   MessageUtil::loadFromFile(fmt::format("{}_{}.pb_text", path_prefix_, id), trace);
   // Test some obvious properties.
@@ -308,5 +335,69 @@ TEST_P(SslCaptureIntegrationTest, RequestWithTextProto) {
   EXPECT_TRUE(absl::StartsWith(trace.events(1).write().data(), "HTTP/1.1 200 OK"));
 }
 
+// Validate a single request with length delimited binary proto output.
+TEST_P(SslCaptureIntegrationTest, RequestWithLengthDelimitedProto) {
+  format_ = envoy::config::transport_socket::capture::v2alpha::FileSink::
+      PROTO_BINARY_LENGTH_DELIMITED;
+  ConnectionCreationFunction creator = [&]() -> Network::ClientConnectionPtr {
+    return makeSslClientConnection(false, false);
+  };
+  const uint64_t id = Network::ConnectionImpl::nextGlobalIdForTest() + 1;
+  testRouterRequestAndResponseWithBody(1024, 512, false, &creator);
+  checkStats();
+  codec_client_->close();
+  test_server_->waitForCounterGe("http.config_test.downstream_cx_destroy", 1);
+  waitForTracesWritten(1);
+  std::ifstream stream(fmt::format("{}_{}.pb_length", path_prefix_, id), std::ios::binary);
+  Protobuf::io::IstreamInputStream input_stream(&stream);
+  std::vector<envoy::data::tap::v2alpha::Trace> traces;
+  envoy::data::tap::v2alpha::Trace trace;
+  bool clean_eof = false;
+  while (ProtobufUtil::ParseDelimitedFromZeroCopyStream(&trace, &input_stream, &clean_eof)) {
+    traces.push_back(trace);
+  }
+  EXPECT_TRUE(clean_eof);
+  // The trace is small enough to be written as a single message.
+  ASSERT_EQ(1, traces.size());
+  EXPECT_EQ(id, traces[0].connection().id());
+  EXPECT_TRUE(absl::StartsWith(traces[0].events(0).read().data(), "POST /test/long/url HTTP/1.1"));
+  EXPECT_TRUE(absl::StartsWith(traces[0].events(1).write().data(), "HTTP/1.1 200 OK"));
+}
+
+// Validate that the data captured is capped per connection.
+TEST_P(SslCaptureIntegrationTest, RequestWithMaxBytesPerConnection) {
+  max_bytes_per_connection_ = 16;
+  ConnectionCreationFunction creator = [&]() -> Network::ClientConnectionPtr {
+    return makeSslClientConnection(false, false);
+  };
+  const uint64_t id = Network::ConnectionImpl::nextGlobalIdForTest() + 1;
+  testRouterRequestAndResponseWithBody(1024, 512, false, &creator);
+  checkStats();
+  codec_client_->close();
+  test_server_->waitForCounterGe("http.config_test.downstream_cx_destroy", 1);
+  waitForTracesWritten(1);
+  envoy::data::tap::v2alpha::Trace trace;
+  MessageUtil::loadFromFile(fmt::format("{}_{}.pb", path_prefix_, id), trace);
+  ASSERT_EQ(1, trace.events().size());
+  EXPECT_EQ("POST /test/long/", trace.events(0).read().data());
+  EXPECT_TRUE(trace.events(0).read().truncated());
+  EXPECT_EQ(1, captureCounter("truncated"));
+}
+
+// Validate that sockets which aren't sampled aren't captured.
+TEST_P(SslCaptureIntegrationTest, RequestNotSampled) {
+  sampled_percent_ = 0;
+  ConnectionCreationFunction creator = [&]() -> Network::ClientConnectionPtr {
+    return makeSslClientConnection(false, false);
+  };
+  testRouterRequestAndResponseWithBody(1024, 512, false, &creator);
+  checkStats();
+  codec_client_->close();
+  test_server_->waitForCounterGe("http.config_test.downstream_cx_destroy", 1);
+  EXPECT_EQ(0, captureCounter("sampled"));
+  EXPECT_LE(1, captureCounter("not_sampled"));
+  EXPECT_EQ(0, captureCounter("traces_written"));
+}
+
 } // namespace Ssl
 } // namespace Envoy
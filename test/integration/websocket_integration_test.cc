@@ -336,6 +336,26 @@ TEST_P(WebsocketIntegrationTest, WebSocketConnectionIdleTimeout) {
   ASSERT_TRUE(waitForUpstreamDisconnectOrReset());
 }
 
+TEST_P(WebsocketIntegrationTest, WebSocketBufferRelease) {
+  if (!old_style_websockets_)
+    return;
+  envoy::api::v2::route::RouteAction::WebSocketProxyConfig ws_config;
+  ws_config.mutable_buffer_release_timeout()->set_nanos(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::milliseconds(100)).count());
+  config_helper_.addConfigModifier(setRouteUsingWebsocket(&ws_config, old_style_websockets_));
+  initialize();
+
+  performUpgrade(upgradeRequestHeaders(), upgradeResponseHeaders());
+  sendBidirectionalData();
+
+  // The WebSocket keeps working once the buffers of its idle connections are released.
+  test_server_->waitForCounterGe("tcp.websocket.buffers_released", 1);
+  codec_client_->sendData(*request_encoder_, "bye!", false);
+  ASSERT_TRUE(upstream_request_->waitForData(*dispatcher_, "hellobye!"));
+  codec_client_->close();
+  ASSERT_TRUE(waitForUpstreamDisconnectOrReset());
+}
+
 TEST_P(WebsocketIntegrationTest, WebSocketLogging) {
   if (!old_style_websockets_)
     return;
@@ -71,6 +71,8 @@ public:
   MOCK_METHOD5(getsockopt_,
                int(int sockfd, int level, int optname, void* optval, socklen_t* optlen));
   MOCK_METHOD3(socket, SysCallIntResult(int domain, int type, int protocol));
+  MOCK_METHOD2(pipe2, SysCallIntResult(int pipefd[2], int flags));
+  MOCK_METHOD4(splice, SysCallSizeResult(int fd_in, int fd_out, size_t len, unsigned int flags));
 
   size_t num_writes_;
   size_t num_open_;
@@ -29,6 +29,11 @@ public:
   MOCK_METHOD2_T(onConfigUpdate,
                  void(const typename SubscriptionCallbacks<ResourceType>::ResourceVector& resources,
                       const std::string& version_info));
+  MOCK_METHOD3_T(
+      onIncrementalConfigUpdate,
+      void(const typename SubscriptionCallbacks<ResourceType>::ResourceVector& added_resources,
+           const Protobuf::RepeatedPtrField<ProtobufTypes::String>& removed_resources,
+           const std::string& system_version_info));
   MOCK_METHOD1_T(onConfigUpdateFailed, void(const EnvoyException* e));
   MOCK_METHOD1_T(resourceName, std::string(const ProtobufWkt::Any& resource));
 };
@@ -70,6 +75,10 @@ public:
 
   MOCK_METHOD2(onConfigUpdate, void(const Protobuf::RepeatedPtrField<ProtobufWkt::Any>& resources,
                                     const std::string& version_info));
+  MOCK_METHOD3(onIncrementalConfigUpdate,
+               void(const Protobuf::RepeatedPtrField<ProtobufWkt::Any>& added_resources,
+                    const Protobuf::RepeatedPtrField<ProtobufTypes::String>& removed_resources,
+                    const std::string& system_version_info));
   MOCK_METHOD1(onConfigUpdateFailed, void(const EnvoyException* e));
   MOCK_METHOD1(resourceName, std::string(const ProtobufWkt::Any& resource));
 };
@@ -60,12 +60,20 @@ public:
 
   Network::ListenerPtr createListener(Network::Socket& socket, Network::ListenerCallbacks& cb,
                                       bool bind_to_port,
-                                      bool hand_off_restored_destination_connections) override {
-    return Network::ListenerPtr{
-        createListener_(socket, cb, bind_to_port, hand_off_restored_destination_connections)};
+                                      bool hand_off_restored_destination_connections,
+                                      uint32_t max_accepts_per_wakeup) override {
+    return Network::ListenerPtr{createListener_(socket, cb, bind_to_port,
+                                                hand_off_restored_destination_connections,
+                                                max_accepts_per_wakeup)};
   }
 
-  Event::TimerPtr createTimer(Event::TimerCb cb) override {
+  Network::UdpListenerPtr createUdpListener(Network::Socket& socket,
+                                            Network::UdpListenerCallbacks& cb) override {
+    return Network::UdpListenerPtr{createUdpListener_(socket, cb)};
+  }
+
+  Event::TimerPtr createTimer(Event::TimerCb cb,
+                              Event::TimerPrecision = Event::TimerPrecision::Precise) override {
     return Event::TimerPtr{createTimer_(cb)};
   }
 
@@ -80,7 +88,16 @@ public:
     return SignalEventPtr{listenForSignal_(signal_num, cb)};
   }
 
+  void postBatch(std::vector<PostCb>&& callbacks) override {
+    for (PostCb& callback : callbacks) {
+      post(std::move(callback));
+    }
+    callbacks.clear();
+  }
+
   // Event::Dispatcher
+  MOCK_METHOD3(initializeStats, void(Stats::Scope& scope, const std::string& prefix,
+                                     std::chrono::milliseconds stall_threshold));
   MOCK_METHOD0(clearDeferredDeleteList, void());
   MOCK_METHOD2(createServerConnection_,
                Network::Connection*(Network::ConnectionSocket* socket,
@@ -97,10 +114,12 @@ public:
   MOCK_METHOD4(createFileEvent_,
                FileEvent*(int fd, FileReadyCb cb, FileTriggerType trigger, uint32_t events));
   MOCK_METHOD0(createFilesystemWatcher_, Filesystem::Watcher*());
-  MOCK_METHOD4(createListener_,
+  MOCK_METHOD5(createListener_,
                Network::Listener*(Network::Socket& socket, Network::ListenerCallbacks& cb,
-                                  bool bind_to_port,
-                                  bool hand_off_restored_destination_connections));
+                                  bool bind_to_port, bool hand_off_restored_destination_connections,
+                                  uint32_t max_accepts_per_wakeup));
+  MOCK_METHOD2(createUdpListener_,
+               Network::UdpListener*(Network::Socket& socket, Network::UdpListenerCallbacks& cb));
   MOCK_METHOD1(createTimer_, Timer*(Event::TimerCb cb));
   MOCK_METHOD1(deferredDelete_, void(DeferredDeletable* to_delete));
   MOCK_METHOD0(exit, void());
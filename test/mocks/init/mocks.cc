@@ -7,6 +7,7 @@
 
 using testing::_;
 using testing::Invoke;
+using testing::Return;
 
 namespace Envoy {
 namespace Init {
@@ -17,6 +18,7 @@ MockTarget::MockTarget() {
         EXPECT_EQ(nullptr, callback_);
         callback_ = callback;
       }));
+  ON_CALL(*this, name()).WillByDefault(Return("mock"));
 }
 
 MockTarget::~MockTarget() {}
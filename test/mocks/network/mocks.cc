@@ -1,6 +1,7 @@
 #include "mocks.h"
 
 #include <cstdint>
+#include <limits>
 
 #include "envoy/buffer/buffer.h"
 #include "envoy/server/listener_manager.h"
@@ -28,6 +29,10 @@ MockListenerConfig::MockListenerConfig() {
   ON_CALL(*this, socket()).WillByDefault(ReturnRef(socket_));
   ON_CALL(*this, listenerScope()).WillByDefault(ReturnRef(scope_));
   ON_CALL(*this, name()).WillByDefault(ReturnRef(name_));
+  ON_CALL(*this, connectionBalancer()).WillByDefault(ReturnRef(connection_balancer_));
+  ON_CALL(*this, maxAcceptsPerWakeup())
+      .WillByDefault(Return(std::numeric_limits<uint32_t>::max()));
+  ON_CALL(*this, socketType()).WillByDefault(Return(Address::SocketType::Stream));
 }
 MockListenerConfig::~MockListenerConfig() {}
 
@@ -87,6 +92,8 @@ template <class T> static void initializeMockConnection(T& connection) {
   ON_CALL(connection, localAddress()).WillByDefault(ReturnRef(connection.local_address_));
   ON_CALL(connection, id()).WillByDefault(Return(connection.next_id_));
   ON_CALL(connection, state()).WillByDefault(ReturnPointee(&connection.state_));
+  ON_CALL(connection, passthroughFd()).WillByDefault(Return(-1));
+  ON_CALL(connection, dynamicMetadata()).WillByDefault(ReturnRef(connection.dynamic_metadata_));
 
   // The real implementation will move the buffer data into the socket.
   ON_CALL(connection, write(_, _)).WillByDefault(Invoke([](Buffer::Instance& buffer, bool) -> void {
@@ -113,6 +120,7 @@ MockActiveDnsQuery::~MockActiveDnsQuery() {}
 
 MockDnsResolver::MockDnsResolver() {
   ON_CALL(*this, resolve(_, _, _)).WillByDefault(Return(&active_query_));
+  ON_CALL(*this, resolveWithTtl(_, _, _)).WillByDefault(Return(&active_query_));
 }
 
 MockDnsResolver::~MockDnsResolver() {}
@@ -154,6 +162,9 @@ MockFilter::~MockFilter() {}
 MockListenerCallbacks::MockListenerCallbacks() {}
 MockListenerCallbacks::~MockListenerCallbacks() {}
 
+MockUdpListenerCallbacks::MockUdpListenerCallbacks() {}
+MockUdpListenerCallbacks::~MockUdpListenerCallbacks() {}
+
 MockDrainDecision::MockDrainDecision() {}
 MockDrainDecision::~MockDrainDecision() {}
 
@@ -174,6 +185,7 @@ MockFilterChainManager::~MockFilterChainManager() {}
 
 MockFilterChainFactory::MockFilterChainFactory() {
   ON_CALL(*this, createListenerFilterChain(_)).WillByDefault(Return(true));
+  ON_CALL(*this, createUdpListenerFilterChain(_, _)).WillByDefault(Return(true));
 }
 MockFilterChainFactory::~MockFilterChainFactory() {}
 
@@ -193,6 +205,7 @@ MockSocketOption::~MockSocketOption() {}
 
 MockConnectionSocket::MockConnectionSocket() : local_address_(new Address::Ipv4Instance(80)) {
   ON_CALL(*this, localAddress()).WillByDefault(ReturnRef(local_address_));
+  ON_CALL(*this, dynamicMetadata()).WillByDefault(ReturnRef(dynamic_metadata_));
 }
 
 MockConnectionSocket::~MockConnectionSocket() {}
@@ -200,9 +213,27 @@ MockConnectionSocket::~MockConnectionSocket() {}
 MockListener::MockListener() {}
 MockListener::~MockListener() { onDestroy(); }
 
+MockUdpListener::MockUdpListener()
+    : local_address_(new Address::Ipv4Instance("127.0.0.1", 10000)) {
+  ON_CALL(*this, localAddress()).WillByDefault(ReturnRef(local_address_));
+}
+MockUdpListener::~MockUdpListener() { onDestroy(); }
+
+MockUdpListenerReadFilter::MockUdpListenerReadFilter() {}
+MockUdpListenerReadFilter::~MockUdpListenerReadFilter() {}
+
+MockUdpReadFilterCallbacks::MockUdpReadFilterCallbacks() {
+  ON_CALL(*this, udpListener()).WillByDefault(ReturnRef(udp_listener_));
+  ON_CALL(*this, dispatcher()).WillByDefault(ReturnRef(dispatcher_));
+}
+MockUdpReadFilterCallbacks::~MockUdpReadFilterCallbacks() {}
+
 MockConnectionHandler::MockConnectionHandler() {}
 MockConnectionHandler::~MockConnectionHandler() {}
 
+MockBalancedConnectionHandler::MockBalancedConnectionHandler() {}
+MockBalancedConnectionHandler::~MockBalancedConnectionHandler() {}
+
 MockTransportSocket::MockTransportSocket() {
   ON_CALL(*this, setTransportSocketCallbacks(_))
       .WillByDefault(Invoke([&](TransportSocketCallbacks& callbacks) { callbacks_ = &callbacks; }));
@@ -13,6 +13,7 @@
 #include "envoy/network/transport_socket.h"
 #include "envoy/stats/scope.h"
 
+#include "common/network/connection_balancer_impl.h"
 #include "common/stats/isolated_store_impl.h"
 
 #include "test/mocks/event/mocks.h"
@@ -49,6 +50,7 @@ public:
   uint64_t id_{next_id_++};
   Address::InstanceConstSharedPtr remote_address_;
   Address::InstanceConstSharedPtr local_address_;
+  envoy::api::v2::core::Metadata dynamic_metadata_;
   bool read_enabled_{true};
   Connection::State state_{Connection::State::Open};
 };
@@ -78,11 +80,19 @@ public:
   MOCK_CONST_METHOD0(localAddress, const Address::InstanceConstSharedPtr&());
   MOCK_METHOD1(setConnectionStats, void(const ConnectionStats& stats));
   MOCK_CONST_METHOD0(ssl, const Ssl::Connection*());
+  MOCK_CONST_METHOD0(passthroughFd, int());
+  MOCK_CONST_METHOD0(bufferedBytes, uint64_t());
+  MOCK_METHOD0(idle, bool());
+  MOCK_METHOD0(idleForTransfer, bool());
+  MOCK_METHOD0(releaseBuffers, void());
   MOCK_CONST_METHOD0(requestedServerName, absl::string_view());
+  MOCK_CONST_METHOD0(dynamicMetadata, const envoy::api::v2::core::Metadata&());
   MOCK_CONST_METHOD0(state, State());
   MOCK_METHOD2(write, void(Buffer::Instance& data, bool end_stream));
   MOCK_METHOD1(setBufferLimits, void(uint32_t limit));
   MOCK_CONST_METHOD0(bufferLimit, uint32_t());
+  MOCK_METHOD2(setWriteCoalescing, void(uint64_t max_bytes, std::chrono::milliseconds max_delay));
+  MOCK_METHOD2(setReadBudget, void(uint32_t bytes, Stats::Counter& yields));
   MOCK_CONST_METHOD0(localAddressRestored, bool());
   MOCK_CONST_METHOD0(aboveHighWatermark, bool());
   MOCK_CONST_METHOD0(socketOptions, const Network::ConnectionSocket::OptionsSharedPtr&());
@@ -117,11 +127,19 @@ public:
   MOCK_CONST_METHOD0(localAddress, const Address::InstanceConstSharedPtr&());
   MOCK_METHOD1(setConnectionStats, void(const ConnectionStats& stats));
   MOCK_CONST_METHOD0(ssl, const Ssl::Connection*());
+  MOCK_CONST_METHOD0(passthroughFd, int());
+  MOCK_CONST_METHOD0(bufferedBytes, uint64_t());
+  MOCK_METHOD0(idle, bool());
+  MOCK_METHOD0(idleForTransfer, bool());
+  MOCK_METHOD0(releaseBuffers, void());
   MOCK_CONST_METHOD0(requestedServerName, absl::string_view());
+  MOCK_CONST_METHOD0(dynamicMetadata, const envoy::api::v2::core::Metadata&());
   MOCK_CONST_METHOD0(state, State());
   MOCK_METHOD2(write, void(Buffer::Instance& data, bool end_stream));
   MOCK_METHOD1(setBufferLimits, void(uint32_t limit));
   MOCK_CONST_METHOD0(bufferLimit, uint32_t());
+  MOCK_METHOD2(setWriteCoalescing, void(uint64_t max_bytes, std::chrono::milliseconds max_delay));
+  MOCK_METHOD2(setReadBudget, void(uint32_t bytes, Stats::Counter& yields));
   MOCK_CONST_METHOD0(localAddressRestored, bool());
   MOCK_CONST_METHOD0(aboveHighWatermark, bool());
   MOCK_CONST_METHOD0(socketOptions, const Network::ConnectionSocket::OptionsSharedPtr&());
@@ -147,6 +165,9 @@ public:
   // Network::DnsResolver
   MOCK_METHOD3(resolve, ActiveDnsQuery*(const std::string& dns_name,
                                         DnsLookupFamily dns_lookup_family, ResolveCb callback));
+  MOCK_METHOD3(resolveWithTtl,
+               ActiveDnsQuery*(const std::string& dns_name, DnsLookupFamily dns_lookup_family,
+                               ResolveWithTtlCb callback));
 
   testing::NiceMock<MockActiveDnsQuery> active_query_;
 };
@@ -220,6 +241,17 @@ public:
 
   MOCK_METHOD2(onAccept_, void(ConnectionSocketPtr& socket, bool redirected));
   MOCK_METHOD1(onNewConnection_, void(ConnectionPtr& conn));
+  MOCK_METHOD2(onAcceptBatch, void(uint32_t accepted, bool limit_reached));
+};
+
+class MockUdpListenerCallbacks : public UdpListenerCallbacks {
+public:
+  MockUdpListenerCallbacks();
+  ~MockUdpListenerCallbacks();
+
+  MOCK_METHOD1(onData, void(UdpRecvData& data));
+  MOCK_METHOD1(onReceiveError, void(int error));
+  MOCK_METHOD1(onSendError, void(int error));
 };
 
 class MockDrainDecision : public DrainDecision {
@@ -286,6 +318,8 @@ public:
                bool(Connection& connection,
                     const std::vector<Network::FilterFactoryCb>& filter_factories));
   MOCK_METHOD1(createListenerFilterChain, bool(ListenerFilterManager& listener));
+  MOCK_METHOD2(createUdpListenerFilterChain,
+               bool(UdpListenerFilterManager& udp_listener, UdpReadFilterCallbacks& callbacks));
 };
 
 class MockListenSocket : public Socket {
@@ -336,6 +370,8 @@ public:
   MOCK_CONST_METHOD0(requestedApplicationProtocols, const std::vector<std::string>&());
   MOCK_METHOD1(setRequestedServerName, void(absl::string_view));
   MOCK_CONST_METHOD0(requestedServerName, absl::string_view());
+  MOCK_METHOD2(setDynamicMetadata, void(const std::string&, const ProtobufWkt::Struct&));
+  MOCK_CONST_METHOD0(dynamicMetadata, const envoy::api::v2::core::Metadata&());
   MOCK_METHOD1(addOption_, void(const Socket::OptionConstSharedPtr&));
   MOCK_METHOD1(addOptions_, void(const Socket::OptionsSharedPtr&));
   MOCK_CONST_METHOD0(options, const Network::ConnectionSocket::OptionsSharedPtr&());
@@ -359,11 +395,16 @@ public:
   MOCK_METHOD0(listenerScope, Stats::Scope&());
   MOCK_CONST_METHOD0(listenerTag, uint64_t());
   MOCK_CONST_METHOD0(name, const std::string&());
+  MOCK_METHOD0(connectionBalancer, ConnectionBalancer&());
+  MOCK_CONST_METHOD0(maxAcceptsPerWakeup, uint32_t());
+  MOCK_CONST_METHOD0(perConnectionReadBudgetBytes, uint32_t());
+  MOCK_CONST_METHOD0(socketType, Address::SocketType());
 
   testing::NiceMock<MockFilterChainFactory> filter_chain_factory_;
   testing::NiceMock<MockListenSocket> socket_;
   Stats::IsolatedStoreImpl scope_;
   std::string name_;
+  NopConnectionBalancerImpl connection_balancer_;
 };
 
 class MockListener : public Listener {
@@ -374,6 +415,38 @@ public:
   MOCK_METHOD0(onDestroy, void());
 };
 
+class MockUdpListener : public UdpListener {
+public:
+  MockUdpListener();
+  ~MockUdpListener();
+
+  MOCK_METHOD0(onDestroy, void());
+  MOCK_CONST_METHOD0(localAddress, const Address::InstanceConstSharedPtr&());
+  MOCK_METHOD1(send, void(const UdpSendData& data));
+
+  Address::InstanceConstSharedPtr local_address_;
+};
+
+class MockUdpListenerReadFilter : public UdpListenerReadFilter {
+public:
+  MockUdpListenerReadFilter();
+  ~MockUdpListenerReadFilter();
+
+  MOCK_METHOD1(onData, FilterStatus(UdpRecvData& data));
+};
+
+class MockUdpReadFilterCallbacks : public UdpReadFilterCallbacks {
+public:
+  MockUdpReadFilterCallbacks();
+  ~MockUdpReadFilterCallbacks();
+
+  MOCK_METHOD0(udpListener, UdpListener&());
+  MOCK_METHOD0(dispatcher, Event::Dispatcher&());
+
+  testing::NiceMock<MockUdpListener> udp_listener_;
+  testing::NiceMock<Event::MockDispatcher> dispatcher_;
+};
+
 class MockConnectionHandler : public ConnectionHandler {
 public:
   MockConnectionHandler();
@@ -384,8 +457,29 @@ public:
   MOCK_METHOD1(findListenerByAddress,
                Network::Listener*(const Network::Address::Instance& address));
   MOCK_METHOD1(removeListeners, void(uint64_t listener_tag));
+  MOCK_METHOD3(removeFilterChains,
+               void(uint64_t listener_tag, const std::list<const FilterChain*>& filter_chains,
+                    std::function<void()> completion));
   MOCK_METHOD1(stopListeners, void(uint64_t listener_tag));
   MOCK_METHOD0(stopListeners, void());
+  MOCK_METHOD0(releaseIdleConnections, std::vector<int>());
+  MOCK_METHOD1(setBufferLimitScale, void(double scale));
+  MOCK_METHOD1(closeIdleConnections, uint64_t(double share));
+  void adoptConnection(ConnectionSocketPtr&& socket) override { adoptConnection_(socket); }
+
+  MOCK_METHOD1(adoptConnection_, void(ConnectionSocketPtr& socket));
+};
+
+class MockBalancedConnectionHandler : public BalancedConnectionHandler {
+public:
+  MockBalancedConnectionHandler();
+  ~MockBalancedConnectionHandler();
+
+  void post(ConnectionSocketPtr&& socket) override { post_(socket); }
+
+  MOCK_CONST_METHOD0(numConnections, uint64_t());
+  MOCK_METHOD0(incNumConnections, void());
+  MOCK_METHOD1(post_, void(ConnectionSocketPtr& socket));
 };
 
 class MockIp : public Address::Ip {
@@ -411,6 +505,8 @@ public:
   MOCK_CONST_METHOD1(bind, Api::SysCallIntResult(int));
   MOCK_CONST_METHOD1(connect, Api::SysCallIntResult(int));
   MOCK_CONST_METHOD0(ip, Address::Ip*());
+  MOCK_CONST_METHOD0(sockAddr, const sockaddr*());
+  MOCK_CONST_METHOD0(sockAddrLen, socklen_t());
   MOCK_CONST_METHOD1(socket, int(Address::SocketType));
   MOCK_CONST_METHOD0(type, Address::Type());
 
@@ -434,6 +530,7 @@ public:
   MOCK_METHOD2(doWrite, IoResult(Buffer::Instance& buffer, bool end_stream));
   MOCK_METHOD0(onConnected, void());
   MOCK_CONST_METHOD0(ssl, const Ssl::Connection*());
+  MOCK_CONST_METHOD0(passthrough, bool());
 
   TransportSocketCallbacks* callbacks_{};
 };
@@ -17,8 +17,17 @@ public:
 
   // RateLimit::Client
   MOCK_METHOD0(cancel, void());
+  void limit(RequestCallbacks& callbacks, const std::string& domain,
+             const std::vector<Descriptor>& descriptors, Tracing::Span& parent_span,
+             uint32_t hits_addend) override {
+    hits_addend_ = hits_addend;
+    limit(callbacks, domain, descriptors, parent_span);
+  }
+
   MOCK_METHOD4(limit, void(RequestCallbacks& callbacks, const std::string& domain,
                            const std::vector<Descriptor>& descriptors, Tracing::Span& parent_span));
+
+  uint32_t hits_addend_{};
 };
 
 inline bool operator==(const DescriptorEntry& lhs, const DescriptorEntry& rhs) {
@@ -69,6 +69,7 @@ MockRequestInfo::MockRequestInfo()
         requested_server_name_ = std::string(requested_server_name);
       }));
   ON_CALL(*this, requestedServerName()).WillByDefault(ReturnRef(requested_server_name_));
+  ON_CALL(*this, requestAttributes()).WillByDefault(ReturnRef(request_attributes_));
 }
 
 MockRequestInfo::~MockRequestInfo() {}
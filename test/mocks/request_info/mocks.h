@@ -2,6 +2,8 @@
 
 #include "envoy/request_info/request_info.h"
 
+#include "common/http/request_attributes_impl.h"
+
 #include "test/mocks/upstream/host.h"
 
 #include "gmock/gmock.h"
@@ -62,6 +64,7 @@ public:
                void(const std::string&, const std::string&, const std::string&));
   MOCK_METHOD0(perRequestState, FilterState&());
   MOCK_CONST_METHOD0(perRequestState, const FilterState&());
+  MOCK_METHOD0(requestAttributes, Http::RequestAttributes&());
   MOCK_METHOD1(setRequestedServerName, void(const absl::string_view));
   MOCK_CONST_METHOD0(requestedServerName, const std::string&());
 
@@ -86,6 +89,7 @@ public:
   Network::Address::InstanceConstSharedPtr downstream_local_address_;
   Network::Address::InstanceConstSharedPtr downstream_remote_address_;
   std::string requested_server_name_;
+  Http::RequestAttributesImpl request_attributes_;
 };
 
 } // namespace RequestInfo
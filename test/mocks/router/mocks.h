@@ -39,13 +39,16 @@ public:
                      void(Http::HeaderMap& headers, bool insert_envoy_original_path));
   MOCK_CONST_METHOD0(responseCode, Http::Code());
   MOCK_CONST_METHOD0(responseBody, const std::string&());
+  MOCK_CONST_METHOD1(addResponseBody, void(Buffer::Instance& buffer));
 };
 
 class TestCorsPolicy : public CorsPolicy {
 public:
   // Router::CorsPolicy
   const std::list<std::string>& allowOrigins() const override { return allow_origin_; };
-  const std::list<std::regex>& allowOriginRegexes() const override { return allow_origin_regex_; };
+  const std::list<Regex::CompiledMatcherPtr>& allowOriginRegexes() const override {
+    return allow_origin_regex_;
+  };
   const std::string& allowMethods() const override { return allow_methods_; };
   const std::string& allowHeaders() const override { return allow_headers_; };
   const std::string& exposeHeaders() const override { return expose_headers_; };
@@ -54,7 +57,7 @@ public:
   bool enabled() const override { return enabled_; };
 
   std::list<std::string> allow_origin_{};
-  std::list<std::regex> allow_origin_regex_{};
+  std::list<Regex::CompiledMatcherPtr> allow_origin_regex_;
   std::string allow_methods_{};
   std::string allow_headers_{};
   std::string expose_headers_{};
@@ -75,6 +78,16 @@ public:
   uint32_t retry_on_{};
 };
 
+class TestHedgePolicy : public HedgePolicy {
+public:
+  // Router::HedgePolicy
+  std::chrono::milliseconds delay() const override { return delay_; }
+  uint32_t budgetPercent() const override { return budget_percent_; }
+
+  std::chrono::milliseconds delay_{0};
+  uint32_t budget_percent_{10};
+};
+
 class MockRetryState : public RetryState {
 public:
   MockRetryState();
@@ -178,9 +191,10 @@ public:
   ~MockHashPolicy();
 
   // Router::HashPolicy
-  MOCK_CONST_METHOD3(generateHash,
+  MOCK_CONST_METHOD4(generateHash,
                      absl::optional<uint64_t>(const Network::Address::Instance* downstream_address,
                                               const Http::HeaderMap& headers,
+                                              Http::RequestAttributes& request_attributes,
                                               const AddCookieCallback add_cookie));
 };
 
@@ -193,6 +207,7 @@ public:
   MOCK_CONST_METHOD0(metadataMatchCriteria,
                      const std::vector<MetadataMatchCriterionConstSharedPtr>&());
   MOCK_CONST_METHOD1(mergeMatchCriteria, MetadataMatchCriteriaConstPtr(const ProtobufWkt::Struct&));
+  MOCK_CONST_METHOD0(hash, uint64_t());
 };
 
 class MockPathMatchCriterion : public PathMatchCriterion {
@@ -226,6 +241,7 @@ public:
   MOCK_CONST_METHOD0(priority, Upstream::ResourcePriority());
   MOCK_CONST_METHOD0(rateLimitPolicy, const RateLimitPolicy&());
   MOCK_CONST_METHOD0(retryPolicy, const RetryPolicy&());
+  MOCK_CONST_METHOD0(hedgePolicy, const HedgePolicy&());
   MOCK_CONST_METHOD0(shadowPolicy, const ShadowPolicy&());
   MOCK_CONST_METHOD0(timeout, std::chrono::milliseconds());
   MOCK_CONST_METHOD0(idleTimeout, absl::optional<std::chrono::milliseconds>());
@@ -252,6 +268,7 @@ public:
   std::multimap<std::string, std::string> opaque_config_;
   TestVirtualCluster virtual_cluster_;
   TestRetryPolicy retry_policy_;
+  TestHedgePolicy hedge_policy_;
   testing::NiceMock<MockRateLimitPolicy> rate_limit_policy_;
   TestShadowPolicy shadow_policy_;
   testing::NiceMock<MockVirtualHost> virtual_host_;
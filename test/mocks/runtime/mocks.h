@@ -27,6 +27,10 @@ public:
   MockSnapshot();
   ~MockSnapshot();
 
+  // Reads through key handles are forwarded to the string key mocks below.
+  using Snapshot::featureEnabled;
+  using Snapshot::getInteger;
+
   MOCK_CONST_METHOD2(featureEnabled, bool(const std::string& key, uint64_t default_value));
   MOCK_CONST_METHOD3(featureEnabled,
                      bool(const std::string& key, uint64_t default_value, uint64_t random_value));
@@ -34,7 +38,7 @@ public:
                                           uint64_t random_value, uint64_t num_buckets));
   MOCK_CONST_METHOD1(get, const std::string&(const std::string& key));
   MOCK_CONST_METHOD2(getInteger, uint64_t(const std::string& key, uint64_t default_value));
-  MOCK_CONST_METHOD0(getLayers, const std::vector<OverrideLayerConstPtr>&());
+  MOCK_CONST_METHOD0(getLayers, const std::vector<OverrideLayerConstSharedPtr>&());
 };
 
 class MockLoader : public Loader {
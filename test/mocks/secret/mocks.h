@@ -21,6 +21,8 @@ public:
                      TlsCertificateConfigProviderSharedPtr(const std::string& name));
   MOCK_CONST_METHOD1(findStaticCertificateValidationContextProvider,
                      CertificateValidationContextConfigProviderSharedPtr(const std::string& name));
+  MOCK_CONST_METHOD1(findStaticTlsSessionTicketKeysProvider,
+                     TlsSessionTicketKeysConfigProviderSharedPtr(const std::string& name));
   MOCK_METHOD1(createInlineTlsCertificateProvider,
                TlsCertificateConfigProviderSharedPtr(
                    const envoy::api::v2::auth::TlsCertificate& tls_certificate));
@@ -32,6 +34,10 @@ public:
                TlsCertificateConfigProviderSharedPtr(
                    const envoy::api::v2::core::ConfigSource&, const std::string&,
                    Server::Configuration::TransportSocketFactoryContext&));
+  MOCK_METHOD3(findOrCreateTlsSessionTicketKeysProvider,
+               TlsSessionTicketKeysConfigProviderSharedPtr(
+                   const envoy::api::v2::core::ConfigSource&, const std::string&,
+                   Server::Configuration::TransportSocketFactoryContext&));
 };
 
 class MockSecretCallbacks : public SecretCallbacks {
@@ -33,6 +33,10 @@ MockOptions::MockOptions(const std::string& config_path) : config_path_(config_p
   ON_CALL(*this, statsOptions()).WillByDefault(ReturnRef(stats_options_));
   ON_CALL(*this, restartEpoch()).WillByDefault(ReturnPointee(&hot_restart_epoch_));
   ON_CALL(*this, hotRestartDisabled()).WillByDefault(ReturnPointee(&hot_restart_disabled_));
+  ON_CALL(*this, hotRestartTransferConnections())
+      .WillByDefault(ReturnPointee(&hot_restart_transfer_connections_));
+  ON_CALL(*this, workerCpus()).WillByDefault(ReturnRef(worker_cpus_));
+  ON_CALL(*this, reusePortIncomingCpu()).WillByDefault(ReturnPointee(&reuse_port_incoming_cpu_));
 }
 MockOptions::~MockOptions() {}
 
@@ -83,6 +87,28 @@ MockListenerComponentFactory::MockListenerComponentFactory()
         }
         return socket_;
       }));
+  ON_CALL(*this, createReusePortListenSocket(_, _, _))
+      .WillByDefault(Invoke([](Network::Address::InstanceConstSharedPtr,
+                               const Network::Socket::OptionsSharedPtr& options,
+                               uint32_t) -> Network::SocketSharedPtr {
+        auto socket = std::make_shared<NiceMock<Network::MockListenSocket>>();
+        if (!Network::Socket::applyOptions(options, *socket,
+                                           envoy::api::v2::core::SocketOption::STATE_PREBIND)) {
+          throw EnvoyException("MockListenerComponentFactory: Setting socket options failed");
+        }
+        return socket;
+      }));
+  ON_CALL(*this, createUdpListenSocket(_, _, _))
+      .WillByDefault(Invoke([](Network::Address::InstanceConstSharedPtr,
+                               const Network::Socket::OptionsSharedPtr& options,
+                               uint32_t) -> Network::SocketSharedPtr {
+        auto socket = std::make_shared<NiceMock<Network::MockListenSocket>>();
+        if (!Network::Socket::applyOptions(options, *socket,
+                                           envoy::api::v2::core::SocketOption::STATE_PREBIND)) {
+          throw EnvoyException("MockListenerComponentFactory: Setting socket options failed");
+        }
+        return socket;
+      }));
 }
 MockListenerComponentFactory::~MockListenerComponentFactory() {}
 
@@ -107,6 +133,14 @@ MockWorker::MockWorker() {
             EXPECT_EQ(nullptr, remove_listener_completion_);
             remove_listener_completion_ = completion;
           }));
+
+  ON_CALL(*this, removeFilterChains(_, _, _))
+      .WillByDefault(Invoke([this](Network::ListenerConfig&,
+                                   const std::list<const Network::FilterChain*>&,
+                                   std::function<void()> completion) -> void {
+        EXPECT_EQ(nullptr, remove_listener_completion_);
+        remove_listener_completion_ = completion;
+      }));
 }
 MockWorker::~MockWorker() {}
 
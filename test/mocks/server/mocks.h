@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <list>
 #include <string>
+#include <vector>
 
 #include "envoy/server/admin.h"
 #include "envoy/server/configuration.h"
@@ -62,6 +63,7 @@ public:
   MOCK_CONST_METHOD0(logLevel, spdlog::level::level_enum());
   MOCK_CONST_METHOD0(logFormat, const std::string&());
   MOCK_CONST_METHOD0(logPath, const std::string&());
+  MOCK_CONST_METHOD0(logAsyncBufferSize, uint32_t());
   MOCK_CONST_METHOD0(parentShutdownTime, std::chrono::seconds());
   MOCK_CONST_METHOD0(restartEpoch, uint64_t());
   MOCK_CONST_METHOD0(fileFlushIntervalMsec, std::chrono::milliseconds());
@@ -72,6 +74,15 @@ public:
   MOCK_CONST_METHOD0(maxStats, uint64_t());
   MOCK_CONST_METHOD0(statsOptions, const Stats::StatsOptions&());
   MOCK_CONST_METHOD0(hotRestartDisabled, bool());
+  MOCK_CONST_METHOD0(hotRestartTransferConnections, bool());
+  MOCK_CONST_METHOD0(ioUringEnabled, bool());
+  MOCK_CONST_METHOD0(coarseTimerResolution, std::chrono::milliseconds());
+  MOCK_CONST_METHOD0(workerCpus, const std::vector<uint32_t>&());
+  MOCK_CONST_METHOD0(workerNumaLocalMemory, bool());
+  MOCK_CONST_METHOD0(reusePortIncomingCpu, bool());
+  MOCK_CONST_METHOD0(dispatcherStatsEnabled, bool());
+  MOCK_CONST_METHOD0(dispatcherStallThreshold, std::chrono::milliseconds());
+  MOCK_CONST_METHOD0(hugePageArenaSizeMb, uint32_t());
 
   std::string config_path_;
   std::string config_yaml_;
@@ -86,6 +97,9 @@ public:
   uint32_t concurrency_{1};
   uint64_t hot_restart_epoch_{};
   bool hot_restart_disabled_{};
+  bool hot_restart_transfer_connections_{};
+  std::vector<uint32_t> worker_cpus_;
+  bool reuse_port_incoming_cpu_{};
 };
 
 class MockConfigTracker : public ConfigTracker {
@@ -167,7 +181,9 @@ public:
 
   // Server::HotRestart
   MOCK_METHOD0(drainParentListeners, void());
-  MOCK_METHOD1(duplicateParentListenSocket, int(const std::string& address));
+  MOCK_METHOD2(duplicateParentListenSocket,
+               int(const std::string& address, uint32_t worker_index));
+  MOCK_METHOD0(transferParentConnections, void());
   MOCK_METHOD1(getParentStats, void(GetParentStatsInfo& info));
   MOCK_METHOD2(initialize, void(Event::Dispatcher& dispatcher, Server::Instance& server));
   MOCK_METHOD1(shutdownParentAdmin, void(ShutdownParentAdminInfo& info));
@@ -205,10 +221,22 @@ public:
                std::vector<Network::ListenerFilterFactoryCb>(
                    const Protobuf::RepeatedPtrField<envoy::api::v2::listener::ListenerFilter>&,
                    Configuration::ListenerFactoryContext& context));
+  MOCK_METHOD2(createUdpListenerFilterFactoryList,
+               std::vector<Network::UdpListenerFilterFactoryCb>(
+                   const Protobuf::RepeatedPtrField<envoy::api::v2::listener::ListenerFilter>&,
+                   Configuration::ListenerFactoryContext& context));
   MOCK_METHOD3(createListenSocket,
                Network::SocketSharedPtr(Network::Address::InstanceConstSharedPtr address,
                                         const Network::Socket::OptionsSharedPtr& options,
                                         bool bind_to_port));
+  MOCK_METHOD3(createReusePortListenSocket,
+               Network::SocketSharedPtr(Network::Address::InstanceConstSharedPtr address,
+                                        const Network::Socket::OptionsSharedPtr& options,
+                                        uint32_t worker_index));
+  MOCK_METHOD3(createUdpListenSocket,
+               Network::SocketSharedPtr(Network::Address::InstanceConstSharedPtr address,
+                                        const Network::Socket::OptionsSharedPtr& options,
+                                        uint32_t worker_index));
   MOCK_METHOD1(createDrainManager_, DrainManager*(envoy::api::v2::Listener::DrainType drain_type));
   MOCK_METHOD0(nextListenerTag, uint64_t());
 
@@ -224,7 +252,14 @@ public:
                                          const std::string& version_info, bool modifiable));
   MOCK_METHOD1(createLdsApi, void(const envoy::api::v2::core::ConfigSource& lds_config));
   MOCK_METHOD0(listeners, std::vector<std::reference_wrapper<Network::ListenerConfig>>());
+  MOCK_METHOD2(listenSocketFd,
+               int(const Network::Address::Instance& address, uint32_t worker_index));
   MOCK_METHOD0(numConnections, uint64_t());
+  MOCK_METHOD0(releaseIdleConnections, std::vector<int>());
+  void adoptConnection(Network::ConnectionSocketPtr&& socket) override {
+    adoptConnection_(socket);
+  }
+  MOCK_METHOD1(adoptConnection_, void(Network::ConnectionSocketPtr& socket));
   MOCK_METHOD1(removeListener, bool(const std::string& listener_name));
   MOCK_METHOD1(startWorkers, void(GuardDog& guard_dog));
   MOCK_METHOD0(stopListeners, void());
@@ -237,7 +272,7 @@ public:
   ~MockWorkerFactory();
 
   // Server::WorkerFactory
-  WorkerPtr createWorker() override { return WorkerPtr{createWorker_()}; }
+  WorkerPtr createWorker(OverloadManager&) override { return WorkerPtr{createWorker_()}; }
 
   MOCK_METHOD0(createWorker_, Worker*());
 };
@@ -265,10 +300,21 @@ public:
   MOCK_METHOD0(numConnections, uint64_t());
   MOCK_METHOD2(removeListener,
                void(Network::ListenerConfig& listener, std::function<void()> completion));
+  MOCK_METHOD3(removeFilterChains,
+               void(Network::ListenerConfig& listener,
+                    const std::list<const Network::FilterChain*>& filter_chains,
+                    std::function<void()> completion));
   MOCK_METHOD1(start, void(GuardDog& guard_dog));
   MOCK_METHOD0(stop, void());
   MOCK_METHOD1(stopListener, void(Network::ListenerConfig& listener));
   MOCK_METHOD0(stopListeners, void());
+  MOCK_METHOD1(releaseIdleConnections,
+               void(std::function<void(std::vector<int>&&)> completion));
+  void adoptConnection(Network::ConnectionSocketPtr&& socket) override {
+    adoptConnection_(socket);
+  }
+
+  MOCK_METHOD1(adoptConnection_, void(Network::ConnectionSocketPtr& socket));
 
   AddListenerCompletion add_listener_completion_;
   std::function<void()> remove_listener_completion_;
@@ -283,7 +329,11 @@ public:
   MOCK_METHOD0(start, void());
   MOCK_METHOD3(registerForAction, void(const std::string& action, Event::Dispatcher& dispatcher,
                                        OverloadActionCb callback));
+  MOCK_METHOD3(registerForActionValue,
+               void(const std::string& action, Event::Dispatcher& dispatcher,
+                    OverloadActionValueCb callback));
   MOCK_METHOD0(getThreadLocalOverloadState, ThreadLocalOverloadState&());
+  MOCK_METHOD1(getActionValue, const OverloadActionValue&(const std::string& action));
 };
 
 class MockInstance : public Instance {
@@ -491,6 +541,8 @@ public:
   MOCK_CONST_METHOD0(getRequestHeaders, Http::HeaderMap&());
   MOCK_CONST_METHOD0(getDecoderFilterCallbacks,
                      NiceMock<Http::MockStreamDecoderFilterCallbacks>&());
+  MOCK_METHOD1(streamResponse, void(ChunkCb));
+  MOCK_METHOD1(streamResponseOffThread, void(ChunkCb));
 };
 
 } // namespace Configuration
@@ -28,6 +28,7 @@ public:
                                       const std::vector<std::string>& server_names));
   MOCK_CONST_METHOD0(daysUntilFirstCertExpires, size_t());
   MOCK_METHOD1(iterateContexts, void(std::function<void(const Context&)> callback));
+  MOCK_METHOD1(prepareTrustedCa, TrustedCaConstSharedPtr(const std::string& ca_cert));
 };
 
 class MockConnection : public Connection {
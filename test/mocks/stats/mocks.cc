@@ -19,6 +19,7 @@ MockCounter::MockCounter() {
   ON_CALL(*this, used()).WillByDefault(ReturnPointee(&used_));
   ON_CALL(*this, value()).WillByDefault(ReturnPointee(&value_));
   ON_CALL(*this, latch()).WillByDefault(ReturnPointee(&latch_));
+  ON_CALL(*this, latchChanged()).WillByDefault(ReturnPointee(&used_));
 }
 MockCounter::~MockCounter() {}
 
@@ -27,6 +28,7 @@ MockGauge::MockGauge() {
   ON_CALL(*this, tags()).WillByDefault(ReturnRef(tags_));
   ON_CALL(*this, used()).WillByDefault(ReturnPointee(&used_));
   ON_CALL(*this, value()).WillByDefault(ReturnPointee(&value_));
+  ON_CALL(*this, latchChanged()).WillByDefault(ReturnPointee(&used_));
 }
 MockGauge::~MockGauge() {}
 
@@ -61,6 +63,27 @@ MockSource::MockSource() {
   ON_CALL(*this, cachedCounters()).WillByDefault(ReturnRef(counters_));
   ON_CALL(*this, cachedGauges()).WillByDefault(ReturnRef(gauges_));
   ON_CALL(*this, cachedHistograms()).WillByDefault(ReturnRef(histograms_));
+  // Like SourceImpl, filter the full lists by whether each stat reports a change.
+  ON_CALL(*this, cachedChangedCounters())
+      .WillByDefault(Invoke([this]() -> const std::vector<CounterSharedPtr>& {
+        changed_counters_.clear();
+        for (const CounterSharedPtr& counter : counters_) {
+          if (counter->latchChanged()) {
+            changed_counters_.push_back(counter);
+          }
+        }
+        return changed_counters_;
+      }));
+  ON_CALL(*this, cachedChangedGauges())
+      .WillByDefault(Invoke([this]() -> const std::vector<GaugeSharedPtr>& {
+        changed_gauges_.clear();
+        for (const GaugeSharedPtr& gauge : gauges_) {
+          if (gauge->latchChanged()) {
+            changed_gauges_.push_back(gauge);
+          }
+        }
+        return changed_gauges_;
+      }));
 }
 
 MockSource::~MockSource() {}
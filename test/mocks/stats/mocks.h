@@ -34,6 +34,7 @@ public:
   MOCK_METHOD1(add, void(uint64_t amount));
   MOCK_METHOD0(inc, void());
   MOCK_METHOD0(latch, uint64_t());
+  MOCK_METHOD0(latchChanged, bool());
   MOCK_CONST_METHOD0(tagExtractedName, const std::string&());
   MOCK_CONST_METHOD0(tags, const std::vector<Tag>&());
   MOCK_METHOD0(reset, void());
@@ -59,6 +60,7 @@ public:
   MOCK_METHOD1(add, void(uint64_t amount));
   MOCK_METHOD0(dec, void());
   MOCK_METHOD0(inc, void());
+  MOCK_METHOD0(latchChanged, bool());
   MOCK_CONST_METHOD0(tagExtractedName, const std::string&());
   MOCK_CONST_METHOD0(tags, const std::vector<Tag>&());
   MOCK_METHOD1(set, void(uint64_t value));
@@ -125,11 +127,15 @@ public:
   MOCK_METHOD0(cachedCounters, const std::vector<CounterSharedPtr>&());
   MOCK_METHOD0(cachedGauges, const std::vector<GaugeSharedPtr>&());
   MOCK_METHOD0(cachedHistograms, const std::vector<ParentHistogramSharedPtr>&());
+  MOCK_METHOD0(cachedChangedCounters, const std::vector<CounterSharedPtr>&());
+  MOCK_METHOD0(cachedChangedGauges, const std::vector<GaugeSharedPtr>&());
   MOCK_METHOD0(clearCache, void());
 
   std::vector<CounterSharedPtr> counters_;
   std::vector<GaugeSharedPtr> gauges_;
   std::vector<ParentHistogramSharedPtr> histograms_;
+  std::vector<CounterSharedPtr> changed_counters_;
+  std::vector<GaugeSharedPtr> changed_gauges_;
 };
 
 class MockSink : public Sink {
@@ -9,6 +9,8 @@
 #include "envoy/upstream/cluster_manager.h"
 #include "envoy/upstream/upstream.h"
 
+#include "common/upstream/locality_load_stats.h"
+
 #include "test/mocks/runtime/mocks.h"
 #include "test/mocks/stats/mocks.h"
 
@@ -57,14 +59,28 @@ public:
                      const absl::optional<envoy::api::v2::Cluster::RingHashLbConfig>&());
   MOCK_CONST_METHOD0(lbOriginalDstConfig,
                      const absl::optional<envoy::api::v2::Cluster::OriginalDstLbConfig>&());
+  MOCK_CONST_METHOD0(lbMaglevConfig,
+                     const absl::optional<envoy::api::v2::Cluster::MaglevLbConfig>&());
+  MOCK_CONST_METHOD0(
+      lbBoundedLoadRingHashConfig,
+      const absl::optional<envoy::api::v2::Cluster::BoundedLoadRingHashLbConfig>&());
+  MOCK_CONST_METHOD0(lbLeastRequestConfig,
+                     const absl::optional<envoy::api::v2::Cluster::LeastRequestLbConfig>&());
+  MOCK_CONST_METHOD0(lbPeakEwmaConfig,
+                     const absl::optional<envoy::api::v2::Cluster::PeakEwmaLbConfig>&());
   MOCK_CONST_METHOD0(maintenanceMode, bool());
   MOCK_CONST_METHOD0(maxRequestsPerConnection, uint64_t());
+  MOCK_CONST_METHOD0(maxConcurrentStreamsPerConnection, uint64_t());
+  MOCK_CONST_METHOD0(prefetchRatio, double());
+  MOCK_CONST_METHOD0(prefetchMinConnections, uint32_t());
   MOCK_CONST_METHOD0(name, const std::string&());
   MOCK_CONST_METHOD1(resourceManager, ResourceManager&(ResourcePriority priority));
   MOCK_CONST_METHOD0(transportSocketFactory, Network::TransportSocketFactory&());
   MOCK_CONST_METHOD0(stats, ClusterStats&());
   MOCK_CONST_METHOD0(statsScope, Stats::Scope&());
   MOCK_CONST_METHOD0(loadReportStats, ClusterLoadReportStats&());
+  MOCK_CONST_METHOD1(localityLoadStats,
+                     LocalityLoadStatsSharedPtr(const envoy::api::v2::core::Locality& locality));
   MOCK_CONST_METHOD0(sourceAddress, const Network::Address::InstanceConstSharedPtr&());
   MOCK_CONST_METHOD0(lbSubsetInfo, const LoadBalancerSubsetInfo&());
   MOCK_CONST_METHOD0(metadata, const envoy::api::v2::core::Metadata&());
@@ -75,11 +91,15 @@ public:
   Http::Http2Settings http2_settings_{};
   ProtocolOptionsConfigConstSharedPtr extension_protocol_options_;
   uint64_t max_requests_per_connection_{};
+  uint64_t max_concurrent_streams_per_connection_{};
+  double prefetch_ratio_{1.0};
+  uint32_t prefetch_min_connections_{};
   NiceMock<Stats::MockIsolatedStatsStore> stats_store_;
   ClusterStats stats_;
   Network::TransportSocketFactoryPtr transport_socket_factory_;
   NiceMock<Stats::MockIsolatedStatsStore> load_report_stats_store_;
   ClusterLoadReportStats load_report_stats_;
+  LocalityLoadStatsMap locality_load_stats_;
   NiceMock<Runtime::MockLoader> runtime_;
   std::unique_ptr<Upstream::ResourceManager> resource_manager_;
   Network::Address::InstanceConstSharedPtr source_address_;
@@ -88,6 +108,11 @@ public:
   NiceMock<MockLoadBalancerSubsetInfo> lb_subset_;
   absl::optional<envoy::api::v2::Cluster::RingHashLbConfig> lb_ring_hash_config_;
   absl::optional<envoy::api::v2::Cluster::OriginalDstLbConfig> lb_original_dst_config_;
+  absl::optional<envoy::api::v2::Cluster::MaglevLbConfig> lb_maglev_config_;
+  absl::optional<envoy::api::v2::Cluster::BoundedLoadRingHashLbConfig>
+      lb_bounded_load_ring_hash_config_;
+  absl::optional<envoy::api::v2::Cluster::LeastRequestLbConfig> lb_least_request_config_;
+  absl::optional<envoy::api::v2::Cluster::PeakEwmaLbConfig> lb_peak_ewma_config_;
   Network::ConnectionSocket::OptionsSharedPtr cluster_socket_options_;
   envoy::api::v2::Cluster::CommonLbConfig lb_config_;
 };
@@ -30,6 +30,9 @@ MockDetector::~MockDetector() {}
 MockHealthCheckHostMonitor::MockHealthCheckHostMonitor() {}
 MockHealthCheckHostMonitor::~MockHealthCheckHostMonitor() {}
 
+MockLatencyEstimator::MockLatencyEstimator() {}
+MockLatencyEstimator::~MockLatencyEstimator() {}
+
 MockHostDescription::MockHostDescription()
     : address_(Network::Utility::resolveUrl("tcp://10.0.0.1:443")) {
   ON_CALL(*this, hostname()).WillByDefault(ReturnRef(hostname_));
@@ -38,6 +41,7 @@ MockHostDescription::MockHostDescription()
   ON_CALL(*this, stats()).WillByDefault(ReturnRef(stats_));
   ON_CALL(*this, cluster()).WillByDefault(ReturnRef(cluster_));
   ON_CALL(*this, healthChecker()).WillByDefault(ReturnRef(health_checker_));
+  ON_CALL(*this, latencyEstimator()).WillByDefault(ReturnRef(latency_estimator_));
 }
 
 MockHostDescription::~MockHostDescription() {}
@@ -46,6 +50,7 @@ MockHost::MockHost() {
   ON_CALL(*this, cluster()).WillByDefault(ReturnRef(cluster_));
   ON_CALL(*this, outlierDetector()).WillByDefault(ReturnRef(outlier_detector_));
   ON_CALL(*this, stats()).WillByDefault(ReturnRef(stats_));
+  ON_CALL(*this, latencyEstimator()).WillByDefault(ReturnRef(latency_estimator_));
 }
 
 MockHost::~MockHost() {}
@@ -51,6 +51,7 @@ public:
   MOCK_CONST_METHOD0(healthyHosts, const HostVector&());
   MOCK_CONST_METHOD0(hostsPerLocality, const HostsPerLocality&());
   MOCK_CONST_METHOD0(healthyHostsPerLocality, const HostsPerLocality&());
+  MOCK_CONST_METHOD0(healthyHostsPerLocalityPtr, HostsPerLocalityConstSharedPtr());
   MOCK_CONST_METHOD0(localityWeights, LocalityWeightsConstSharedPtr());
   MOCK_METHOD0(chooseLocality, absl::optional<uint32_t>());
   MOCK_METHOD8(updateHosts, void(std::shared_ptr<const HostVector> hosts,
@@ -186,6 +187,11 @@ public:
                                 Outlier::EventLoggerSharedPtr outlier_event_logger,
                                 AccessLog::AccessLogManager& log_manager, bool added_via_api));
 
+  ClusterPreparationPtr prepareCluster(const envoy::api::v2::Cluster& cluster) override {
+    return ClusterPreparationPtr{prepareCluster_(cluster)};
+  }
+  MOCK_METHOD1(prepareCluster_, ClusterPreparation*(const envoy::api::v2::Cluster& cluster));
+
   MOCK_METHOD3(createCds,
                CdsApiPtr(const envoy::api::v2::core::ConfigSource& cds_config,
                          const absl::optional<envoy::api::v2::core::ConfigSource>& eds_config,
@@ -206,15 +212,24 @@ public:
     return {Network::ClientConnectionPtr{data.connection_}, data.host_description_};
   }
 
+  OnDemandClusterHandlePtr loadOnDemandCluster(const std::string& cluster,
+                                               std::function<void()> callback) override {
+    return OnDemandClusterHandlePtr{loadOnDemandCluster_(cluster, callback)};
+  }
+
   ClusterManagerFactory& clusterManagerFactory() override { return cluster_manager_factory_; }
   TimeSource& timeSource() override { return time_source_; }
 
   // Upstream::ClusterManager
+  using ClusterManager::get;
+  using ClusterManager::httpConnPoolForCluster;
   MOCK_METHOD2(addOrUpdateCluster,
                bool(const envoy::api::v2::Cluster& cluster, const std::string& version_info));
   MOCK_METHOD1(setInitializedCb, void(std::function<void()>));
   MOCK_METHOD0(clusters, ClusterInfoMap());
   MOCK_METHOD1(get, ThreadLocalCluster*(const std::string& cluster));
+  MOCK_METHOD2(loadOnDemandCluster_, OnDemandClusterHandle*(const std::string& cluster,
+                                                            std::function<void()> callback));
   MOCK_METHOD4(httpConnPoolForCluster,
                Http::ConnectionPool::Instance*(const std::string& cluster,
                                                ResourcePriority priority, Http::Protocol protocol,
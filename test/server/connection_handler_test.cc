@@ -1,7 +1,15 @@
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <limits>
+#include <vector>
+
 #include "envoy/stats/scope.h"
 
+#include "common/buffer/buffer_impl.h"
 #include "common/common/utility.h"
 #include "common/network/address_impl.h"
+#include "common/network/connection_balancer_impl.h"
 #include "common/network/raw_buffer_socket.h"
 #include "common/network/utility.h"
 
@@ -47,10 +55,14 @@ public:
     bool handOffRestoredDestinationConnections() const override {
       return hand_off_restored_destination_connections_;
     }
-    uint32_t perConnectionBufferLimitBytes() override { return 0; }
+    uint32_t perConnectionBufferLimitBytes() override { return per_connection_buffer_limit_bytes_; }
     Stats::Scope& listenerScope() override { return parent_.stats_store_; }
     uint64_t listenerTag() const override { return tag_; }
     const std::string& name() const override { return name_; }
+    Network::ConnectionBalancer& connectionBalancer() override { return *connection_balancer_; }
+    uint32_t maxAcceptsPerWakeup() const override { return std::numeric_limits<uint32_t>::max(); }
+    uint32_t perConnectionReadBudgetBytes() const override { return 0; }
+    Network::Address::SocketType socketType() const override { return socket_type_; }
 
     ConnectionHandlerTest& parent_;
     Network::MockListenSocket socket_;
@@ -58,6 +70,10 @@ public:
     bool bind_to_port_;
     const bool hand_off_restored_destination_connections_;
     const std::string name_;
+    uint32_t per_connection_buffer_limit_bytes_{};
+    Network::Address::SocketType socket_type_{Network::Address::SocketType::Stream};
+    Network::ConnectionBalancerPtr connection_balancer_{
+        std::make_unique<Network::NopConnectionBalancerImpl>()};
   };
 
   typedef std::unique_ptr<TestListener> TestListenerPtr;
@@ -85,12 +101,12 @@ TEST_F(ConnectionHandlerTest, RemoveListener) {
 
   Network::MockListener* listener = new NiceMock<Network::MockListener>();
   Network::ListenerCallbacks* listener_callbacks;
-  EXPECT_CALL(dispatcher_, createListener_(_, _, _, false))
-      .WillOnce(Invoke(
-          [&](Network::Socket&, Network::ListenerCallbacks& cb, bool, bool) -> Network::Listener* {
-            listener_callbacks = &cb;
-            return listener;
-          }));
+  EXPECT_CALL(dispatcher_, createListener_(_, _, _, false, _))
+      .WillOnce(Invoke([&](Network::Socket&, Network::ListenerCallbacks& cb, bool, bool,
+                           uint32_t) -> Network::Listener* {
+        listener_callbacks = &cb;
+        return listener;
+      }));
   TestListener* test_listener = addListener(1, true, false, "test_listener");
   EXPECT_CALL(test_listener->socket_, localAddress());
   handler_->addListener(*test_listener);
@@ -121,12 +137,12 @@ TEST_F(ConnectionHandlerTest, DestroyCloseConnections) {
 
   Network::MockListener* listener = new NiceMock<Network::MockListener>();
   Network::ListenerCallbacks* listener_callbacks;
-  EXPECT_CALL(dispatcher_, createListener_(_, _, _, _))
-      .WillOnce(Invoke(
-          [&](Network::Socket&, Network::ListenerCallbacks& cb, bool, bool) -> Network::Listener* {
-            listener_callbacks = &cb;
-            return listener;
-          }));
+  EXPECT_CALL(dispatcher_, createListener_(_, _, _, _, _))
+      .WillOnce(Invoke([&](Network::Socket&, Network::ListenerCallbacks& cb, bool, bool,
+                           uint32_t) -> Network::Listener* {
+        listener_callbacks = &cb;
+        return listener;
+      }));
   TestListener* test_listener = addListener(1, true, false, "test_listener");
   EXPECT_CALL(test_listener->socket_, localAddress());
   handler_->addListener(*test_listener);
@@ -146,12 +162,12 @@ TEST_F(ConnectionHandlerTest, CloseDuringFilterChainCreate) {
 
   Network::MockListener* listener = new Network::MockListener();
   Network::ListenerCallbacks* listener_callbacks;
-  EXPECT_CALL(dispatcher_, createListener_(_, _, _, _))
-      .WillOnce(Invoke(
-          [&](Network::Socket&, Network::ListenerCallbacks& cb, bool, bool) -> Network::Listener* {
-            listener_callbacks = &cb;
-            return listener;
-          }));
+  EXPECT_CALL(dispatcher_, createListener_(_, _, _, _, _))
+      .WillOnce(Invoke([&](Network::Socket&, Network::ListenerCallbacks& cb, bool, bool,
+                           uint32_t) -> Network::Listener* {
+        listener_callbacks = &cb;
+        return listener;
+      }));
   TestListener* test_listener = addListener(1, true, false, "test_listener");
   EXPECT_CALL(test_listener->socket_, localAddress());
   handler_->addListener(*test_listener);
@@ -174,12 +190,12 @@ TEST_F(ConnectionHandlerTest, CloseConnectionOnEmptyFilterChain) {
 
   Network::MockListener* listener = new Network::MockListener();
   Network::ListenerCallbacks* listener_callbacks;
-  EXPECT_CALL(dispatcher_, createListener_(_, _, _, _))
-      .WillOnce(Invoke(
-          [&](Network::Socket&, Network::ListenerCallbacks& cb, bool, bool) -> Network::Listener* {
-            listener_callbacks = &cb;
-            return listener;
-          }));
+  EXPECT_CALL(dispatcher_, createListener_(_, _, _, _, _))
+      .WillOnce(Invoke([&](Network::Socket&, Network::ListenerCallbacks& cb, bool, bool,
+                           uint32_t) -> Network::Listener* {
+        listener_callbacks = &cb;
+        return listener;
+      }));
   TestListener* test_listener = addListener(1, true, false, "test_listener");
   EXPECT_CALL(test_listener->socket_, localAddress());
   handler_->addListener(*test_listener);
@@ -203,9 +219,9 @@ TEST_F(ConnectionHandlerTest, FindListenerByAddress) {
       new Network::Address::Ipv4Instance("127.0.0.1", 10001));
 
   Network::MockListener* listener = new Network::MockListener();
-  EXPECT_CALL(dispatcher_, createListener_(_, _, _, true))
-      .WillOnce(Invoke([&](Network::Socket&, Network::ListenerCallbacks&, bool,
-                           bool) -> Network::Listener* { return listener; }));
+  EXPECT_CALL(dispatcher_, createListener_(_, _, _, true, _))
+      .WillOnce(Invoke([&](Network::Socket&, Network::ListenerCallbacks&, bool, bool,
+                           uint32_t) -> Network::Listener* { return listener; }));
   EXPECT_CALL(test_listener1->socket_, localAddress()).WillRepeatedly(ReturnRef(alt_address));
   handler_->addListener(*test_listener1);
 
@@ -218,9 +234,9 @@ TEST_F(ConnectionHandlerTest, FindListenerByAddress) {
       new Network::Address::Ipv4Instance("127.0.0.2", 10001));
 
   Network::MockListener* listener2 = new Network::MockListener();
-  EXPECT_CALL(dispatcher_, createListener_(_, _, _, false))
-      .WillOnce(Invoke([&](Network::Socket&, Network::ListenerCallbacks&, bool,
-                           bool) -> Network::Listener* { return listener2; }));
+  EXPECT_CALL(dispatcher_, createListener_(_, _, _, false, _))
+      .WillOnce(Invoke([&](Network::Socket&, Network::ListenerCallbacks&, bool, bool,
+                           uint32_t) -> Network::Listener* { return listener2; }));
   EXPECT_CALL(test_listener2->socket_, localAddress()).WillRepeatedly(ReturnRef(alt_address2));
   handler_->addListener(*test_listener2);
 
@@ -236,9 +252,9 @@ TEST_F(ConnectionHandlerTest, FindListenerByAddress) {
   handler_->stopListeners(2);
 
   Network::MockListener* listener3 = new Network::MockListener();
-  EXPECT_CALL(dispatcher_, createListener_(_, _, _, _))
-      .WillOnce(Invoke([&](Network::Socket&, Network::ListenerCallbacks&, bool,
-                           bool) -> Network::Listener* { return listener3; }));
+  EXPECT_CALL(dispatcher_, createListener_(_, _, _, _, _))
+      .WillOnce(Invoke([&](Network::Socket&, Network::ListenerCallbacks&, bool, bool,
+                           uint32_t) -> Network::Listener* { return listener3; }));
   handler_->addListener(*test_listener2);
 
   EXPECT_EQ(listener3, handler_->findListenerByAddress(ByRef(*alt_address2)));
@@ -251,12 +267,12 @@ TEST_F(ConnectionHandlerTest, NormalRedirect) {
   TestListener* test_listener1 = addListener(1, true, true, "test_listener1");
   Network::MockListener* listener1 = new Network::MockListener();
   Network::ListenerCallbacks* listener_callbacks1;
-  EXPECT_CALL(dispatcher_, createListener_(_, _, _, true))
-      .WillOnce(Invoke(
-          [&](Network::Socket&, Network::ListenerCallbacks& cb, bool, bool) -> Network::Listener* {
-            listener_callbacks1 = &cb;
-            return listener1;
-          }));
+  EXPECT_CALL(dispatcher_, createListener_(_, _, _, true, _))
+      .WillOnce(Invoke([&](Network::Socket&, Network::ListenerCallbacks& cb, bool, bool,
+                           uint32_t) -> Network::Listener* {
+        listener_callbacks1 = &cb;
+        return listener1;
+      }));
   Network::Address::InstanceConstSharedPtr normal_address(
       new Network::Address::Ipv4Instance("127.0.0.1", 10001));
   EXPECT_CALL(test_listener1->socket_, localAddress()).WillRepeatedly(ReturnRef(normal_address));
@@ -265,12 +281,12 @@ TEST_F(ConnectionHandlerTest, NormalRedirect) {
   TestListener* test_listener2 = addListener(1, false, false, "test_listener2");
   Network::MockListener* listener2 = new Network::MockListener();
   Network::ListenerCallbacks* listener_callbacks2;
-  EXPECT_CALL(dispatcher_, createListener_(_, _, _, false))
-      .WillOnce(Invoke(
-          [&](Network::Socket&, Network::ListenerCallbacks& cb, bool, bool) -> Network::Listener* {
-            listener_callbacks2 = &cb;
-            return listener2;
-          }));
+  EXPECT_CALL(dispatcher_, createListener_(_, _, _, false, _))
+      .WillOnce(Invoke([&](Network::Socket&, Network::ListenerCallbacks& cb, bool, bool,
+                           uint32_t) -> Network::Listener* {
+        listener_callbacks2 = &cb;
+        return listener2;
+      }));
   Network::Address::InstanceConstSharedPtr alt_address(
       new Network::Address::Ipv4Instance("127.0.0.2", 20002));
   EXPECT_CALL(test_listener2->socket_, localAddress()).WillRepeatedly(ReturnRef(alt_address));
@@ -311,12 +327,12 @@ TEST_F(ConnectionHandlerTest, FallbackToWildcardListener) {
   TestListener* test_listener1 = addListener(1, true, true, "test_listener1");
   Network::MockListener* listener1 = new Network::MockListener();
   Network::ListenerCallbacks* listener_callbacks1;
-  EXPECT_CALL(dispatcher_, createListener_(_, _, _, true))
-      .WillOnce(Invoke(
-          [&](Network::Socket&, Network::ListenerCallbacks& cb, bool, bool) -> Network::Listener* {
-            listener_callbacks1 = &cb;
-            return listener1;
-          }));
+  EXPECT_CALL(dispatcher_, createListener_(_, _, _, true, _))
+      .WillOnce(Invoke([&](Network::Socket&, Network::ListenerCallbacks& cb, bool, bool,
+                           uint32_t) -> Network::Listener* {
+        listener_callbacks1 = &cb;
+        return listener1;
+      }));
   Network::Address::InstanceConstSharedPtr normal_address(
       new Network::Address::Ipv4Instance("127.0.0.1", 10001));
   EXPECT_CALL(test_listener1->socket_, localAddress()).WillRepeatedly(ReturnRef(normal_address));
@@ -325,12 +341,12 @@ TEST_F(ConnectionHandlerTest, FallbackToWildcardListener) {
   TestListener* test_listener2 = addListener(1, false, false, "test_listener2");
   Network::MockListener* listener2 = new Network::MockListener();
   Network::ListenerCallbacks* listener_callbacks2;
-  EXPECT_CALL(dispatcher_, createListener_(_, _, _, false))
-      .WillOnce(Invoke(
-          [&](Network::Socket&, Network::ListenerCallbacks& cb, bool, bool) -> Network::Listener* {
-            listener_callbacks2 = &cb;
-            return listener2;
-          }));
+  EXPECT_CALL(dispatcher_, createListener_(_, _, _, false, _))
+      .WillOnce(Invoke([&](Network::Socket&, Network::ListenerCallbacks& cb, bool, bool,
+                           uint32_t) -> Network::Listener* {
+        listener_callbacks2 = &cb;
+        return listener2;
+      }));
   Network::Address::InstanceConstSharedPtr any_address = Network::Utility::getIpv4AnyAddress();
   EXPECT_CALL(test_listener2->socket_, localAddress()).WillRepeatedly(ReturnRef(any_address));
   handler_->addListener(*test_listener2);
@@ -373,12 +389,12 @@ TEST_F(ConnectionHandlerTest, WildcardListenerWithOriginalDst) {
   TestListener* test_listener1 = addListener(1, true, true, "test_listener1");
   Network::MockListener* listener1 = new Network::MockListener();
   Network::ListenerCallbacks* listener_callbacks1;
-  EXPECT_CALL(dispatcher_, createListener_(_, _, _, true))
-      .WillOnce(Invoke(
-          [&](Network::Socket&, Network::ListenerCallbacks& cb, bool, bool) -> Network::Listener* {
-            listener_callbacks1 = &cb;
-            return listener1;
-          }));
+  EXPECT_CALL(dispatcher_, createListener_(_, _, _, true, _))
+      .WillOnce(Invoke([&](Network::Socket&, Network::ListenerCallbacks& cb, bool, bool,
+                           uint32_t) -> Network::Listener* {
+        listener_callbacks1 = &cb;
+        return listener1;
+      }));
   Network::Address::InstanceConstSharedPtr normal_address(
       new Network::Address::Ipv4Instance("127.0.0.1", 80));
   // Original dst address nor port number match that of the listener's address.
@@ -419,12 +435,12 @@ TEST_F(ConnectionHandlerTest, WildcardListenerWithNoOriginalDst) {
   TestListener* test_listener1 = addListener(1, true, true, "test_listener1");
   Network::MockListener* listener1 = new Network::MockListener();
   Network::ListenerCallbacks* listener_callbacks1;
-  EXPECT_CALL(dispatcher_, createListener_(_, _, _, true))
-      .WillOnce(Invoke(
-          [&](Network::Socket&, Network::ListenerCallbacks& cb, bool, bool) -> Network::Listener* {
-            listener_callbacks1 = &cb;
-            return listener1;
-          }));
+  EXPECT_CALL(dispatcher_, createListener_(_, _, _, true, _))
+      .WillOnce(Invoke([&](Network::Socket&, Network::ListenerCallbacks& cb, bool, bool,
+                           uint32_t) -> Network::Listener* {
+        listener_callbacks1 = &cb;
+        return listener1;
+      }));
   Network::Address::InstanceConstSharedPtr normal_address(
       new Network::Address::Ipv4Instance("127.0.0.1", 80));
   Network::Address::InstanceConstSharedPtr any_address = Network::Utility::getAddressWithPort(
@@ -457,12 +473,12 @@ TEST_F(ConnectionHandlerTest, TransportProtocolDefault) {
   TestListener* test_listener = addListener(1, true, false, "test_listener");
   Network::MockListener* listener = new Network::MockListener();
   Network::ListenerCallbacks* listener_callbacks;
-  EXPECT_CALL(dispatcher_, createListener_(_, _, _, false))
-      .WillOnce(Invoke(
-          [&](Network::Socket&, Network::ListenerCallbacks& cb, bool, bool) -> Network::Listener* {
-            listener_callbacks = &cb;
-            return listener;
-          }));
+  EXPECT_CALL(dispatcher_, createListener_(_, _, _, false, _))
+      .WillOnce(Invoke([&](Network::Socket&, Network::ListenerCallbacks& cb, bool, bool,
+                           uint32_t) -> Network::Listener* {
+        listener_callbacks = &cb;
+        return listener;
+      }));
   EXPECT_CALL(test_listener->socket_, localAddress());
   handler_->addListener(*test_listener);
 
@@ -480,12 +496,12 @@ TEST_F(ConnectionHandlerTest, TransportProtocolCustom) {
   TestListener* test_listener = addListener(1, true, false, "test_listener");
   Network::MockListener* listener = new Network::MockListener();
   Network::ListenerCallbacks* listener_callbacks;
-  EXPECT_CALL(dispatcher_, createListener_(_, _, _, false))
-      .WillOnce(Invoke(
-          [&](Network::Socket&, Network::ListenerCallbacks& cb, bool, bool) -> Network::Listener* {
-            listener_callbacks = &cb;
-            return listener;
-          }));
+  EXPECT_CALL(dispatcher_, createListener_(_, _, _, false, _))
+      .WillOnce(Invoke([&](Network::Socket&, Network::ListenerCallbacks& cb, bool, bool,
+                           uint32_t) -> Network::Listener* {
+        listener_callbacks = &cb;
+        return listener;
+      }));
   EXPECT_CALL(test_listener->socket_, localAddress());
   handler_->addListener(*test_listener);
 
@@ -510,5 +526,248 @@ TEST_F(ConnectionHandlerTest, TransportProtocolCustom) {
   EXPECT_CALL(*listener, onDestroy());
 }
 
+TEST_F(ConnectionHandlerTest, ExactBalancerHandsOffToLeastLoadedWorker) {
+  TestListener* test_listener = addListener(1, true, false, "test_listener");
+  test_listener->connection_balancer_ = std::make_unique<Network::ExactConnectionBalancerImpl>();
+
+  Network::MockListener* listener1 = new NiceMock<Network::MockListener>();
+  Network::ListenerCallbacks* listener_callbacks1;
+  EXPECT_CALL(dispatcher_, createListener_(_, _, _, _, _))
+      .WillOnce(Invoke([&](Network::Socket&, Network::ListenerCallbacks& cb, bool, bool,
+                           uint32_t) -> Network::Listener* {
+        listener_callbacks1 = &cb;
+        return listener1;
+      }));
+  handler_->addListener(*test_listener);
+
+  NiceMock<Event::MockDispatcher> dispatcher2;
+  Network::ConnectionHandlerPtr handler2(new ConnectionHandlerImpl(ENVOY_LOGGER(), dispatcher2));
+  Network::MockListener* listener2 = new NiceMock<Network::MockListener>();
+  EXPECT_CALL(dispatcher2, createListener_(_, _, _, _, _)).WillOnce(Return(listener2));
+  handler2->addListener(*test_listener);
+
+  // The first worker already owns a connection, so a socket it accepts is posted to the second.
+  listener_callbacks1->onNewConnection(
+      Network::ConnectionPtr{new NiceMock<Network::MockConnection>()});
+  EXPECT_EQ(1UL, handler_->numConnections());
+
+  EXPECT_CALL(dispatcher_, post(_)).Times(0);
+  EXPECT_CALL(dispatcher2, post(_));
+  EXPECT_CALL(manager_, findFilterChain(_)).WillOnce(Return(filter_chain_.get()));
+  EXPECT_CALL(dispatcher_, createServerConnection_(_, _)).Times(0);
+  EXPECT_CALL(dispatcher2, createServerConnection_(_, _))
+      .WillOnce(Return(new NiceMock<Network::MockConnection>()));
+  EXPECT_CALL(factory_, createNetworkFilterChain(_, _)).WillOnce(Return(true));
+  listener_callbacks1->onAccept(
+      Network::ConnectionSocketPtr{new NiceMock<Network::MockConnectionSocket>()}, true);
+  EXPECT_EQ(1UL, handler_->numConnections());
+  EXPECT_EQ(1UL, handler2->numConnections());
+
+  // With the load even, the accepting worker keeps the socket.
+  EXPECT_CALL(dispatcher2, post(_)).Times(0);
+  EXPECT_CALL(manager_, findFilterChain(_)).WillOnce(Return(filter_chain_.get()));
+  EXPECT_CALL(dispatcher_, createServerConnection_(_, _))
+      .WillOnce(Return(new NiceMock<Network::MockConnection>()));
+  EXPECT_CALL(factory_, createNetworkFilterChain(_, _)).WillOnce(Return(true));
+  listener_callbacks1->onAccept(
+      Network::ConnectionSocketPtr{new NiceMock<Network::MockConnectionSocket>()}, true);
+  EXPECT_EQ(2UL, handler_->numConnections());
+  EXPECT_EQ(1UL, handler2->numConnections());
+
+  EXPECT_CALL(*listener1, onDestroy());
+  EXPECT_CALL(*listener2, onDestroy());
+  handler2.reset();
+}
+
+TEST_F(ConnectionHandlerTest, ReleaseAndAdoptIdleConnections) {
+  TestListener* test_listener = addListener(1, true, false, "test_listener");
+  Network::Address::InstanceConstSharedPtr listener_address(new Network::Address::Ipv4Instance(80));
+  EXPECT_CALL(test_listener->socket_, localAddress())
+      .WillRepeatedly(ReturnRef(listener_address));
+  Network::MockListener* listener = new NiceMock<Network::MockListener>();
+  Network::ListenerCallbacks* listener_callbacks;
+  EXPECT_CALL(dispatcher_, createListener_(_, _, _, _, _))
+      .WillOnce(Invoke([&](Network::Socket&, Network::ListenerCallbacks& cb, bool, bool,
+                           uint32_t) -> Network::Listener* {
+        listener_callbacks = &cb;
+        return listener;
+      }));
+  handler_->addListener(*test_listener);
+
+  const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_NE(-1, fd);
+  Network::MockConnection* idle_connection = new NiceMock<Network::MockConnection>();
+  EXPECT_CALL(*idle_connection, idleForTransfer()).WillOnce(Return(true));
+  EXPECT_CALL(*idle_connection, passthroughFd()).WillOnce(Return(fd));
+  listener_callbacks->onNewConnection(Network::ConnectionPtr{idle_connection});
+  Network::MockConnection* busy_connection = new NiceMock<Network::MockConnection>();
+  EXPECT_CALL(*busy_connection, idleForTransfer()).WillOnce(Return(false));
+  listener_callbacks->onNewConnection(Network::ConnectionPtr{busy_connection});
+  EXPECT_EQ(2UL, handler_->numConnections());
+
+  // Only the idle connection is closed, and its socket stays open through the duplicate.
+  EXPECT_CALL(*idle_connection, close(Network::ConnectionCloseType::NoFlush));
+  std::vector<int> released = handler_->releaseIdleConnections();
+  ASSERT_EQ(1UL, released.size());
+  EXPECT_NE(fd, released[0]);
+  EXPECT_EQ(1UL, handler_->numConnections());
+  EXPECT_EQ(1UL, stats_store_.counter("downstream_cx_transferred").value());
+  ::close(released[0]);
+  ::close(fd);
+
+  // An adopted socket skips the listener filters and gets a connection on its listener.
+  Network::MockConnectionSocket* adopted_socket = new NiceMock<Network::MockConnectionSocket>();
+  EXPECT_CALL(*adopted_socket, setDetectedTransportProtocol(absl::string_view("raw_buffer")));
+  EXPECT_CALL(factory_, createListenerFilterChain(_)).Times(0);
+  EXPECT_CALL(manager_, findFilterChain(_)).WillOnce(Return(filter_chain_.get()));
+  EXPECT_CALL(dispatcher_, createServerConnection_(_, _))
+      .WillOnce(Return(new NiceMock<Network::MockConnection>()));
+  EXPECT_CALL(factory_, createNetworkFilterChain(_, _)).WillOnce(Return(true));
+  handler_->adoptConnection(Network::ConnectionSocketPtr{adopted_socket});
+  EXPECT_EQ(2UL, handler_->numConnections());
+
+  // A socket without a listener for its address is closed.
+  Network::MockConnectionSocket* orphan_socket = new NiceMock<Network::MockConnectionSocket>();
+  orphan_socket->local_address_.reset(new Network::Address::Ipv4Instance(81));
+  EXPECT_CALL(*orphan_socket, close());
+  handler_->adoptConnection(Network::ConnectionSocketPtr{orphan_socket});
+  EXPECT_EQ(2UL, handler_->numConnections());
+
+  EXPECT_CALL(*listener, onDestroy());
+}
+
+TEST_F(ConnectionHandlerTest, ScaleBufferLimits) {
+  TestListener* test_listener = addListener(1, true, false, "test_listener");
+  test_listener->per_connection_buffer_limit_bytes_ = 1024 * 1024;
+  Network::MockListener* listener = new NiceMock<Network::MockListener>();
+  Network::ListenerCallbacks* listener_callbacks;
+  EXPECT_CALL(dispatcher_, createListener_(_, _, _, _, _))
+      .WillOnce(Invoke([&](Network::Socket&, Network::ListenerCallbacks& cb, bool, bool,
+                           uint32_t) -> Network::Listener* {
+        listener_callbacks = &cb;
+        return listener;
+      }));
+  EXPECT_CALL(test_listener->socket_, localAddress());
+  handler_->addListener(*test_listener);
+
+  Network::MockConnection* connection = new NiceMock<Network::MockConnection>();
+  listener_callbacks->onNewConnection(Network::ConnectionPtr{connection});
+
+  EXPECT_CALL(*connection, setBufferLimits(512 * 1024));
+  handler_->setBufferLimitScale(0.5);
+
+  // The limit doesn't go below the floor once the scale reaches 0.
+  EXPECT_CALL(*connection, setBufferLimits(16 * 1024));
+  handler_->setBufferLimitScale(0);
+
+  // New connections get the scaled limit as well.
+  Network::MockConnection* new_connection = new NiceMock<Network::MockConnection>();
+  EXPECT_CALL(*new_connection, setBufferLimits(16 * 1024));
+  EXPECT_CALL(manager_, findFilterChain(_)).WillOnce(Return(filter_chain_.get()));
+  EXPECT_CALL(dispatcher_, createServerConnection_(_, _)).WillOnce(Return(new_connection));
+  EXPECT_CALL(factory_, createNetworkFilterChain(_, _)).WillOnce(Return(true));
+  listener_callbacks->onAccept(
+      Network::ConnectionSocketPtr{new NiceMock<Network::MockConnectionSocket>()}, true);
+
+  EXPECT_CALL(*connection, setBufferLimits(1024 * 1024));
+  EXPECT_CALL(*new_connection, setBufferLimits(1024 * 1024));
+  handler_->setBufferLimitScale(1);
+
+  EXPECT_CALL(*listener, onDestroy());
+}
+
+TEST_F(ConnectionHandlerTest, CloseIdleConnections) {
+  TestListener* test_listener = addListener(1, true, false, "test_listener");
+  Network::MockListener* listener = new NiceMock<Network::MockListener>();
+  Network::ListenerCallbacks* listener_callbacks;
+  EXPECT_CALL(dispatcher_, createListener_(_, _, _, _, _))
+      .WillOnce(Invoke([&](Network::Socket&, Network::ListenerCallbacks& cb, bool, bool,
+                           uint32_t) -> Network::Listener* {
+        listener_callbacks = &cb;
+        return listener;
+      }));
+  EXPECT_CALL(test_listener->socket_, localAddress());
+  handler_->addListener(*test_listener);
+
+  std::vector<Network::MockConnection*> idle_connections;
+  for (int i = 0; i < 3; i++) {
+    Network::MockConnection* connection = new NiceMock<Network::MockConnection>();
+    ON_CALL(*connection, idle()).WillByDefault(Return(true));
+    listener_callbacks->onNewConnection(Network::ConnectionPtr{connection});
+    idle_connections.push_back(connection);
+  }
+  Network::MockConnection* busy_connection = new NiceMock<Network::MockConnection>();
+  ON_CALL(*busy_connection, idle()).WillByDefault(Return(false));
+  listener_callbacks->onNewConnection(Network::ConnectionPtr{busy_connection});
+  EXPECT_EQ(4UL, handler_->numConnections());
+
+  EXPECT_EQ(0UL, handler_->closeIdleConnections(0));
+
+  // Half of the idle connections, rounded up, are closed oldest first.
+  EXPECT_CALL(*idle_connections[0], close(Network::ConnectionCloseType::NoFlush));
+  EXPECT_CALL(*idle_connections[1], close(Network::ConnectionCloseType::NoFlush));
+  EXPECT_CALL(*idle_connections[2], close(_)).Times(0);
+  EXPECT_CALL(*busy_connection, close(_)).Times(0);
+  EXPECT_EQ(2UL, handler_->closeIdleConnections(0.5));
+  EXPECT_EQ(2UL, handler_->numConnections());
+  EXPECT_EQ(2UL, stats_store_.counter("downstream_cx_overload_idle_close").value());
+
+  // At least one idle connection is closed for any non-zero share.
+  testing::Mock::VerifyAndClearExpectations(idle_connections[2]);
+  EXPECT_CALL(*idle_connections[2], close(Network::ConnectionCloseType::NoFlush));
+  EXPECT_EQ(1UL, handler_->closeIdleConnections(0.01));
+  EXPECT_EQ(1UL, handler_->numConnections());
+  testing::Mock::VerifyAndClearExpectations(busy_connection);
+
+  EXPECT_CALL(*listener, onDestroy());
+}
+
+// Datagrams of a UDP listener go through its filters until one stops the iteration.
+TEST_F(ConnectionHandlerTest, UdpListener) {
+  Network::MockUdpListener* listener = new NiceMock<Network::MockUdpListener>();
+  Network::UdpListenerCallbacks* listener_callbacks;
+  EXPECT_CALL(dispatcher_, createUdpListener_(_, _))
+      .WillOnce(Invoke([&](Network::Socket&, Network::UdpListenerCallbacks& cb)
+                           -> Network::UdpListener* {
+        listener_callbacks = &cb;
+        return listener;
+      }));
+  Network::MockUdpListenerReadFilter* filter1 = new Network::MockUdpListenerReadFilter();
+  Network::MockUdpListenerReadFilter* filter2 = new Network::MockUdpListenerReadFilter();
+  Network::MockUdpListenerReadFilter* filter3 = new Network::MockUdpListenerReadFilter();
+  EXPECT_CALL(factory_, createUdpListenerFilterChain(_, _))
+      .WillOnce(Invoke([&](Network::UdpListenerFilterManager& manager,
+                           Network::UdpReadFilterCallbacks& callbacks) -> bool {
+        EXPECT_EQ(listener, &callbacks.udpListener());
+        EXPECT_EQ(&dispatcher_, &callbacks.dispatcher());
+        manager.addReadFilter(Network::UdpListenerReadFilterPtr{filter1});
+        manager.addReadFilter(Network::UdpListenerReadFilterPtr{filter2});
+        manager.addReadFilter(Network::UdpListenerReadFilterPtr{filter3});
+        return true;
+      }));
+  TestListener* test_listener = addListener(1, true, false, "test_listener");
+  test_listener->socket_type_ = Network::Address::SocketType::Datagram;
+  handler_->addListener(*test_listener);
+
+  Network::UdpRecvData data{nullptr, nullptr, std::make_unique<Buffer::OwnedImpl>("hello")};
+  EXPECT_CALL(*filter1, onData(_)).WillOnce(Return(Network::FilterStatus::Continue));
+  EXPECT_CALL(*filter2, onData(_)).WillOnce(Return(Network::FilterStatus::StopIteration));
+  EXPECT_CALL(*filter3, onData(_)).Times(0);
+  listener_callbacks->onData(data);
+  EXPECT_EQ(1UL, stats_store_.counter("downstream_rx_datagram_total").value());
+
+  listener_callbacks->onReceiveError(EMSGSIZE);
+  EXPECT_EQ(1UL, stats_store_.counter("downstream_rx_datagram_error").value());
+  listener_callbacks->onSendError(EAGAIN);
+  EXPECT_EQ(1UL, stats_store_.counter("downstream_tx_datagram_error").value());
+
+  // UDP listeners have no connections.
+  EXPECT_EQ(0UL, handler_->numConnections());
+
+  EXPECT_CALL(*listener, onDestroy());
+  handler_->stopListeners(1);
+  handler_->removeListeners(1);
+}
+
 } // namespace Server
 } // namespace Envoy
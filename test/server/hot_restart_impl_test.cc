@@ -14,7 +14,6 @@
 
 using testing::_;
 using testing::Invoke;
-using testing::InvokeWithoutArgs;
 using testing::Return;
 using testing::ReturnRef;
 using testing::WithArg;
@@ -24,16 +23,31 @@ namespace Server {
 
 class HotRestartImplTest : public testing::Test {
 public:
-  void setup() {
-    EXPECT_CALL(os_sys_calls_, shmUnlink(_));
-    EXPECT_CALL(os_sys_calls_, shmOpen(_, _, _));
-    EXPECT_CALL(os_sys_calls_, ftruncate(_, _)).WillOnce(WithArg<1>(Invoke([this](off_t size) {
-      buffer_.resize(size);
+  HotRestartImplTest() {
+    // Shared memory regions are backed by buffers keyed by region name, so that the stats segments
+    // created as the stats set grows are found again by a hot restarted instance.
+    EXPECT_CALL(os_sys_calls_, shmUnlink(_))
+        .WillRepeatedly(Return(Api::SysCallIntResult{-1, ENOENT}));
+    EXPECT_CALL(os_sys_calls_, shmOpen(_, _, _))
+        .WillRepeatedly(Invoke([this](const char* name, int flags, mode_t) {
+          if (!(flags & O_CREAT) && buffers_.count(name) == 0) {
+            return Api::SysCallIntResult{-1, ENOENT};
+          }
+          fds_.push_back(name);
+          return Api::SysCallIntResult{static_cast<int>(fds_.size() - 1), 0};
+        }));
+    EXPECT_CALL(os_sys_calls_, ftruncate(_, _)).WillRepeatedly(Invoke([this](int fd, off_t size) {
+      buffers_[fds_[fd]].resize(size);
       return Api::SysCallIntResult{0, 0};
-    })));
-    EXPECT_CALL(os_sys_calls_, mmap(_, _, _, _, _, _)).WillOnce(InvokeWithoutArgs([this]() {
-      return Api::SysCallPtrResult{buffer_.data(), 0};
     }));
+    EXPECT_CALL(os_sys_calls_, mmap(_, _, _, _, _, _))
+        .WillRepeatedly(WithArg<4>(Invoke([this](int fd) {
+          return Api::SysCallPtrResult{buffers_[fds_[fd]].data(), 0};
+        })));
+    EXPECT_CALL(os_sys_calls_, close(_)).WillRepeatedly(Return(Api::SysCallIntResult{0, 0}));
+  }
+
+  void setup() {
     EXPECT_CALL(os_sys_calls_, bind(_, _, _));
     EXPECT_CALL(options_, statsOptions()).WillRepeatedly(ReturnRef(stats_options_));
 
@@ -46,7 +60,8 @@ public:
   TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls{&os_sys_calls_};
   NiceMock<MockOptions> options_;
   Stats::StatsOptionsImpl stats_options_;
-  std::vector<uint8_t> buffer_;
+  std::map<std::string, std::vector<uint8_t>> buffers_;
+  std::vector<std::string> fds_;
   std::unique_ptr<HotRestartImpl> hot_restart_;
 };
 
@@ -127,6 +142,25 @@ TEST_F(HotRestartImplTest, RawAlloc) {
   hot_restart_->free(*stat_3);
 }
 
+TEST_F(HotRestartImplTest, RefCounts) {
+  setup();
+
+  Stats::RawStatData* stat = hot_restart_->alloc("ref_name");
+  EXPECT_EQ(stat, hot_restart_->alloc("ref_name"));
+  EXPECT_EQ(2, stat->ref_count_);
+  hot_restart_->free(*stat);
+  EXPECT_EQ(1, stat->ref_count_);
+  EXPECT_TRUE(stat->initialized());
+
+  // An entry whose last reference was dropped, but which is not removed yet, can only be revived
+  // under the lock.
+  stat->ref_count_ = 0;
+  EXPECT_EQ(stat, hot_restart_->alloc("ref_name"));
+  EXPECT_EQ(1, stat->ref_count_);
+  hot_restart_->free(*stat);
+  EXPECT_FALSE(stat->initialized());
+}
+
 TEST_F(HotRestartImplTest, crossAlloc) {
   setup();
 
@@ -141,9 +175,6 @@ TEST_F(HotRestartImplTest, crossAlloc) {
   stat4 = nullptr;
 
   EXPECT_CALL(options_, restartEpoch()).WillRepeatedly(Return(1));
-  EXPECT_CALL(os_sys_calls_, shmOpen(_, _, _));
-  EXPECT_CALL(os_sys_calls_, mmap(_, _, _, _, _, _))
-      .WillOnce(Return(Api::SysCallPtrResult{buffer_.data(), 0}));
   EXPECT_CALL(os_sys_calls_, bind(_, _, _));
   HotRestartImpl hot_restart2(options_);
   Stats::RawStatData* stat1_prime = hot_restart2.alloc("stat1");
@@ -154,6 +185,35 @@ TEST_F(HotRestartImplTest, crossAlloc) {
   EXPECT_EQ(stat5, stat5_prime);
 }
 
+TEST_F(HotRestartImplTest, growsAcrossRestart) {
+  EXPECT_CALL(options_, maxStats()).WillRepeatedly(Return(100000));
+  setup();
+
+  // Stats are only given shared memory as they are created.
+  EXPECT_EQ(1, buffers_.size());
+  std::vector<Stats::RawStatData*> stats;
+  for (uint64_t i = 0; i < 10000; i++) {
+    stats.push_back(hot_restart_->alloc(fmt::format("stat{}", i)));
+    ASSERT_NE(stats.back(), nullptr);
+  }
+  EXPECT_LT(2, buffers_.size());
+
+  EXPECT_CALL(options_, restartEpoch()).WillRepeatedly(Return(1));
+  EXPECT_CALL(os_sys_calls_, bind(_, _, _));
+  HotRestartImpl hot_restart2(options_);
+  for (uint64_t i = 0; i < 10000; i++) {
+    EXPECT_EQ(stats[i], hot_restart2.alloc(fmt::format("stat{}", i)));
+  }
+
+  // Segments added by the new instance are seen by the old one.
+  const size_t num_segments = buffers_.size();
+  uint64_t i = 10000;
+  while (buffers_.size() == num_segments) {
+    ASSERT_NE(hot_restart2.alloc(fmt::format("stat{}", i++)), nullptr);
+  }
+  EXPECT_NE(hot_restart_->alloc(fmt::format("stat{}", i - 1)), nullptr);
+}
+
 TEST_F(HotRestartImplTest, allocFail) {
   EXPECT_CALL(options_, maxStats()).WillRepeatedly(Return(2));
   setup();
@@ -15,6 +15,7 @@
 
 #include "server/http/admin.h"
 
+#include "test/mocks/event/mocks.h"
 #include "test/mocks/runtime/mocks.h"
 #include "test/mocks/server/mocks.h"
 #include "test/test_common/environment.h"
@@ -359,6 +360,111 @@ TEST_P(AdminFilterTest, Trailers) {
   filter_.decodeTrailers(request_headers_);
 }
 
+TEST_P(AdminFilterTest, StreamedStats) {
+  for (int i = 0; i < 2500; i++) {
+    server_.stats().counter(fmt::format("test.c{}", i)).inc();
+  }
+  Http::TestHeaderMapImpl request_headers{{":path", "/stats?filter=^test\\."}};
+  Event::MockTimer* timer = new Event::MockTimer(&callbacks_.dispatcher_);
+  std::string body;
+  auto append_body = [&body](Buffer::Instance& data, bool) -> void { body += data.toString(); };
+
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, false));
+  EXPECT_CALL(callbacks_, addDownstreamWatermarkCallbacks(_));
+  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(0)));
+  filter_.decodeHeaders(request_headers, true);
+
+  EXPECT_CALL(callbacks_, encodeData(_, false)).WillOnce(Invoke(append_body));
+  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(0)));
+  timer->callback_();
+
+  // Nothing more is produced until the connection drains.
+  filter_.onAboveWriteBufferHighWatermark();
+  EXPECT_CALL(callbacks_, encodeData(_, false)).WillOnce(Invoke(append_body));
+  EXPECT_CALL(*timer, enableTimer(_)).Times(0);
+  timer->callback_();
+  testing::Mock::VerifyAndClearExpectations(timer);
+
+  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(0)));
+  filter_.onBelowWriteBufferLowWatermark();
+
+  EXPECT_CALL(callbacks_, removeDownstreamWatermarkCallbacks(_));
+  EXPECT_CALL(callbacks_, encodeData(_, true)).WillOnce(Invoke(append_body));
+  timer->callback_();
+
+  EXPECT_EQ(2500, std::count(body.begin(), body.end(), '\n'));
+  EXPECT_TRUE(absl::StartsWith(body, "test.c0: 1\ntest.c1: 1\ntest.c10: 1\n")) << body;
+}
+
+class AdminFilterRenderThreadTest : public AdminFilterTest {
+public:
+  AdminFilterRenderThreadTest() {
+    admin_.startRenderThread();
+    // Rendered chunks are posted back from the render thread. Hold on to them so that the test
+    // can deliver them on its own thread.
+    ON_CALL(callbacks_.dispatcher_, post(_)).WillByDefault(Invoke([this](Event::PostCb cb) -> void {
+      posted_ = cb;
+      chunk_posted_.setReady();
+    }));
+  }
+
+  void runPosted() {
+    chunk_posted_.waitReady();
+    Event::PostCb cb = std::move(posted_);
+    cb();
+  }
+
+  ConditionalInitializer chunk_posted_;
+  Event::PostCb posted_;
+};
+
+INSTANTIATE_TEST_CASE_P(IpVersions, AdminFilterRenderThreadTest,
+                        testing::ValuesIn(TestEnvironment::getIpVersionsForTest()),
+                        TestUtility::ipTestParamsToString);
+
+TEST_P(AdminFilterRenderThreadTest, StreamedStats) {
+  for (int i = 0; i < 2500; i++) {
+    server_.stats().counter(fmt::format("test.c{}", i)).inc();
+  }
+  Http::TestHeaderMapImpl request_headers{{":path", "/stats?filter=^test\\."}};
+  std::string body;
+  auto append_body = [&body](Buffer::Instance& data, bool) -> void { body += data.toString(); };
+
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, false));
+  EXPECT_CALL(callbacks_, addDownstreamWatermarkCallbacks(_));
+  filter_.decodeHeaders(request_headers, true);
+
+  EXPECT_CALL(callbacks_, encodeData(_, false)).WillOnce(Invoke(append_body));
+  runPosted();
+
+  // Nothing more is rendered until the connection drains.
+  filter_.onAboveWriteBufferHighWatermark();
+  EXPECT_CALL(callbacks_, encodeData(_, false)).WillOnce(Invoke(append_body));
+  runPosted();
+
+  filter_.onBelowWriteBufferLowWatermark();
+  EXPECT_CALL(callbacks_, removeDownstreamWatermarkCallbacks(_));
+  EXPECT_CALL(callbacks_, encodeData(_, true)).WillOnce(Invoke(append_body));
+  runPosted();
+
+  EXPECT_EQ(2500, std::count(body.begin(), body.end(), '\n'));
+  EXPECT_TRUE(absl::StartsWith(body, "test.c0: 1\ntest.c1: 1\ntest.c10: 1\n")) << body;
+}
+
+TEST_P(AdminFilterRenderThreadTest, StreamResetWhileRendering) {
+  server_.stats().counter("test.c").inc();
+  Http::TestHeaderMapImpl request_headers{{":path", "/stats/prometheus"}};
+
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, false));
+  filter_.decodeHeaders(request_headers, true);
+
+  // The chunk rendered for a stream that went away is dropped.
+  EXPECT_CALL(callbacks_, removeDownstreamWatermarkCallbacks(_));
+  filter_.onDestroy();
+  EXPECT_CALL(callbacks_, encodeData(_, _)).Times(0);
+  runPosted();
+}
+
 class AdminInstanceTest : public testing::TestWithParam<Network::Address::IpVersion> {
 public:
   AdminInstanceTest()
@@ -378,7 +484,9 @@ public:
                          Buffer::Instance& response, absl::string_view method) {
     request_headers_.insertMethod().value(method.data(), method.size());
     admin_filter_.decodeHeaders(request_headers_, false);
-    return admin_.runCallback(path_and_query, response_headers, response, admin_filter_);
+    Http::Code code = admin_.runCallback(path_and_query, response_headers, response, admin_filter_);
+    admin_filter_.finishResponse(response);
+    return code;
   }
 
   Http::Code getCallback(absl::string_view path_and_query, Http::HeaderMap& response_headers,
@@ -616,6 +724,60 @@ TEST_P(AdminInstanceTest, ConfigDumpMaintainsOrder) {
   }
 }
 
+TEST_P(AdminInstanceTest, ConfigDumpFiltered) {
+  auto foo_entry = admin_.getConfigTracker().add("foo", [] {
+    auto msg = std::make_unique<ProtobufWkt::StringValue>();
+    msg->set_value("foo_config");
+    return msg;
+  });
+  bool clusters_dumped = false;
+  auto clusters_entry = admin_.getConfigTracker().add("clusters", [&clusters_dumped] {
+    clusters_dumped = true;
+    auto msg = std::make_unique<envoy::admin::v2alpha::Clusters>();
+    for (const std::string name : {"a", "b"}) {
+      auto& cluster_status = *msg->add_cluster_statuses();
+      cluster_status.set_name(name);
+      cluster_status.set_added_via_api(true);
+    }
+    return msg;
+  });
+
+  auto config_dump = [this](absl::string_view path_and_query) -> envoy::admin::v2alpha::ConfigDump {
+    Buffer::OwnedImpl response;
+    Http::HeaderMapImpl header_map;
+    EXPECT_EQ(Http::Code::OK, getCallback(path_and_query, header_map, response));
+    EXPECT_EQ("application/x-protobuf", header_map.ContentType()->value().getStringView());
+    envoy::admin::v2alpha::ConfigDump dump;
+    EXPECT_TRUE(dump.ParseFromString(response.toString()));
+    return dump;
+  };
+
+  // Only the selected dumps are produced.
+  envoy::admin::v2alpha::ConfigDump dump = config_dump("/config_dump?resource=foo&format=proto");
+  EXPECT_FALSE(clusters_dumped);
+  ASSERT_EQ(1, dump.configs_size());
+  ProtobufWkt::StringValue foo;
+  ASSERT_TRUE(dump.configs(0).UnpackTo(&foo));
+  EXPECT_EQ("foo_config", foo.value());
+
+  // Masks apply to each element of repeated fields.
+  dump = config_dump("/config_dump?resource=clusters&mask=cluster_statuses.name&format=proto");
+  ASSERT_EQ(1, dump.configs_size());
+  envoy::admin::v2alpha::Clusters clusters;
+  ASSERT_TRUE(dump.configs(0).UnpackTo(&clusters));
+  ASSERT_EQ(2, clusters.cluster_statuses_size());
+  EXPECT_EQ("b", clusters.cluster_statuses(1).name());
+  EXPECT_FALSE(clusters.cluster_statuses(0).added_via_api());
+  EXPECT_FALSE(clusters.cluster_statuses(1).added_via_api());
+
+  EXPECT_EQ(2, config_dump("/config_dump?resource=foo,clusters&format=proto").configs_size());
+
+  Buffer::OwnedImpl response;
+  Http::HeaderMapImpl header_map;
+  EXPECT_EQ(Http::Code::NotFound, getCallback("/config_dump?resource=bar", header_map, response));
+  EXPECT_EQ("unknown resource: bar\n", response.toString());
+}
+
 TEST_P(AdminInstanceTest, Memory) {
   Http::HeaderMapImpl header_map;
   Buffer::OwnedImpl response;
@@ -625,6 +787,9 @@ TEST_P(AdminInstanceTest, Memory) {
   MessageUtil::loadFromJson(output_json, output_proto);
   EXPECT_THAT(output_proto, AllOf(Property(&envoy::admin::v2alpha::Memory::allocated, Ge(0)),
                                   Property(&envoy::admin::v2alpha::Memory::heap_size, Ge(0))));
+  for (const std::string name : {"buffers", "http2_sessions", "hosts", "route_tables", "stats"}) {
+    EXPECT_EQ(1, output_proto.accounted().count(name)) << name;
+  }
 }
 
 TEST_P(AdminInstanceTest, Runtime) {
@@ -645,7 +810,7 @@ TEST_P(AdminInstanceTest, Runtime) {
   ON_CALL(*layer2, name()).WillByDefault(testing::ReturnRefOfCopy(std::string{"layer2"}));
   ON_CALL(*layer2, values()).WillByDefault(testing::ReturnRef(entries2));
 
-  std::vector<Runtime::Snapshot::OverrideLayerConstPtr> layers;
+  std::vector<Runtime::Snapshot::OverrideLayerConstSharedPtr> layers;
   layers.push_back(std::move(layer1));
   layers.push_back(std::move(layer2));
   EXPECT_CALL(snapshot, getLayers()).WillRepeatedly(testing::ReturnRef(layers));
@@ -850,6 +1015,47 @@ TEST_P(AdminInstanceTest, ClustersJson) {
   EXPECT_THROW(MessageUtil::loadFromJson(text_output, failed_conversion_proto), EnvoyException);
 }
 
+TEST_P(AdminInstanceTest, ClustersFilteredAndPaged) {
+  Upstream::ClusterManager::ClusterInfoMap cluster_map;
+  ON_CALL(server_.cluster_manager_, clusters()).WillByDefault(ReturnPointee(&cluster_map));
+  NiceMock<Upstream::MockCluster> cluster_a, cluster_b, cluster_c, other;
+  cluster_a.info_->name_ = "svc_a";
+  cluster_b.info_->name_ = "svc_b";
+  cluster_c.info_->name_ = "svc_c";
+  other.info_->name_ = "other";
+  for (const Upstream::Cluster* cluster : {&cluster_c, &cluster_a, &other, &cluster_b}) {
+    cluster_map.emplace(cluster->info()->name(), *cluster);
+  }
+
+  auto cluster_names = [this](absl::string_view path_and_query) -> std::vector<std::string> {
+    Buffer::OwnedImpl response;
+    Http::HeaderMapImpl header_map;
+    EXPECT_EQ(Http::Code::OK, getCallback(path_and_query, header_map, response));
+    envoy::admin::v2alpha::Clusters clusters;
+    EXPECT_TRUE(clusters.ParseFromString(response.toString()));
+    std::vector<std::string> names;
+    for (const auto& cluster_status : clusters.cluster_statuses()) {
+      names.push_back(cluster_status.name());
+    }
+    return names;
+  };
+
+  EXPECT_EQ((std::vector<std::string>{"other", "svc_a", "svc_b", "svc_c"}),
+            cluster_names("/clusters?format=proto"));
+  EXPECT_EQ((std::vector<std::string>{"svc_a", "svc_b", "svc_c"}),
+            cluster_names("/clusters?format=proto&filter=^svc_"));
+  EXPECT_EQ((std::vector<std::string>{"svc_a", "svc_b"}),
+            cluster_names("/clusters?format=proto&filter=^svc_&limit=2"));
+  EXPECT_EQ((std::vector<std::string>{"svc_c"}),
+            cluster_names("/clusters?format=proto&filter=^svc_&offset=2&limit=2"));
+  EXPECT_EQ(std::vector<std::string>{}, cluster_names("/clusters?format=proto&offset=10"));
+
+  Buffer::OwnedImpl response;
+  Http::HeaderMapImpl header_map;
+  EXPECT_EQ(Http::Code::BadRequest, getCallback("/clusters?limit=x", header_map, response));
+  EXPECT_EQ("invalid limit: x\n", response.toString());
+}
+
 TEST_P(AdminInstanceTest, GetRequest) {
   Http::HeaderMapImpl response_headers;
   std::string body;
@@ -868,6 +1074,35 @@ TEST_P(AdminInstanceTest, GetRequestJson) {
               HasSubstr("application/json"));
 }
 
+TEST_P(AdminInstanceTest, StatsFilter) {
+  server_.stats().counter("foo.bar").inc();
+  server_.stats().counter("foo_bar").inc();
+  server_.stats().gauge("baz.foo.bar").set(2);
+  server_.stats().counter("unused.bar");
+
+  auto stats = [this](absl::string_view path_and_query) -> std::string {
+    Http::HeaderMapImpl header_map;
+    Buffer::OwnedImpl response;
+    EXPECT_EQ(Http::Code::OK, getCallback(path_and_query, header_map, response));
+    return response.toString();
+  };
+  EXPECT_EQ("foo.bar: 1\n", stats("/stats?filter=^foo\\."));
+  EXPECT_EQ("baz.foo.bar: 2\nfoo.bar: 1\n", stats("/stats?filter=foo\\.b.r"));
+  EXPECT_EQ("baz.foo.bar: 2\nfoo.bar: 1\nfoo_bar: 1\n", stats("/stats?filter=foo"));
+  EXPECT_EQ("baz.foo.bar: 2\n", stats("/stats?filter=^baz&unsorted"));
+  EXPECT_EQ("unused.bar: 0\n", stats("/stats?filter=^unused"));
+  EXPECT_EQ("", stats("/stats?filter=^unused&usedonly"));
+  EXPECT_THAT(stats("/stats?filter=foo&format=json"), HasSubstr("{\"name\":\"foo_bar\""));
+
+  EXPECT_EQ("# TYPE envoy_foo_bar counter\nenvoy_foo_bar{} 1\n",
+            stats("/stats/prometheus?filter=^foo_"));
+
+  Http::HeaderMapImpl header_map;
+  Buffer::OwnedImpl response;
+  EXPECT_EQ(Http::Code::BadRequest, getCallback("/stats?filter=(", header_map, response));
+  EXPECT_THAT(response.toString(), HasSubstr("Invalid regex"));
+}
+
 TEST_P(AdminInstanceTest, PostRequest) {
   Http::HeaderMapImpl response_headers;
   std::string body;
@@ -2,12 +2,14 @@
 
 #include "test/mocks/common.h"
 #include "test/mocks/init/mocks.h"
+#include "test/test_common/test_time.h"
 
 #include "gmock/gmock.h"
 
 using testing::_;
 using testing::InSequence;
 using testing::Invoke;
+using testing::Return;
 
 namespace Envoy {
 namespace Server {
@@ -63,5 +65,32 @@ TEST_F(InitManagerImplTest, TargetAfterInitializing) {
   target1.callback_();
 }
 
+TEST_F(InitManagerImplTest, StartupTimeline) {
+  DangerousDeprecatedTestTime test_time;
+  StartupTimeline timeline(test_time.timeSystem());
+  manager_.setStartupTimeline(timeline);
+  Init::MockTarget target1;
+  Init::MockTarget target2;
+  EXPECT_CALL(target2, name()).WillRepeatedly(Return("rds foo"));
+
+  manager_.registerTarget(target1);
+  manager_.registerTarget(target2);
+  EXPECT_CALL(target1, initialize(_));
+  EXPECT_CALL(target2, initialize(_));
+  manager_.initialize([&]() -> void { initialized_.ready(); });
+
+  target2.callback_();
+  envoy::admin::v2alpha::StartupTimeline proto = timeline.toProto();
+  ASSERT_EQ(2, proto.phases_size());
+  EXPECT_EQ("init_target.mock", proto.phases(0).name());
+  EXPECT_FALSE(proto.phases(0).has_duration());
+  EXPECT_EQ("init_target.rds foo", proto.phases(1).name());
+  EXPECT_TRUE(proto.phases(1).has_duration());
+
+  EXPECT_CALL(initialized_, ready());
+  target1.callback_();
+  EXPECT_TRUE(timeline.toProto().phases(0).has_duration());
+}
+
 } // namespace Server
 } // namespace Envoy
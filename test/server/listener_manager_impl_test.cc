@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "envoy/admin/v2alpha/config_dump.pb.h"
 #include "envoy/registry/registry.h"
 #include "envoy/server/filter_config.h"
@@ -6,6 +8,7 @@
 #include "common/config/metadata.h"
 #include "common/network/address_impl.h"
 #include "common/network/listen_socket_impl.h"
+#include "common/network/quic_connection_id_routing_socket_option_impl.h"
 #include "common/network/socket_option_impl.h"
 #include "common/network/utility.h"
 #include "common/ssl/ssl_socket.h"
@@ -27,11 +30,13 @@
 #include "gtest/gtest.h"
 
 using testing::_;
+using testing::DoAll;
 using testing::InSequence;
 using testing::Invoke;
 using testing::NiceMock;
 using testing::Return;
 using testing::ReturnRef;
+using testing::SaveArg;
 using testing::Throw;
 
 namespace Envoy {
@@ -927,6 +932,141 @@ TEST_F(ListenerManagerImplTest, ListenerDraining) {
   checkStats(1, 0, 1, 0, 0, 0);
 }
 
+// An update that only changes some filter chains keeps the connections of the others: they don't
+// drain with the listener, and the workers only close the connections of the changed ones.
+TEST_F(ListenerManagerImplTest, UpdateKeepsUnchangedFilterChains) {
+  InSequence s;
+
+  EXPECT_CALL(*worker_, start(_));
+  manager_->startWorkers(guard_dog_);
+
+  const std::string listener_foo_yaml = R"EOF(
+    name: foo
+    address:
+      socket_address: { address: 127.0.0.1, port_value: 1234 }
+    filter_chains:
+    - filter_chain_match: { destination_port: 8080 }
+      filters: []
+    - filter_chain_match: { destination_port: 8081 }
+      filters: []
+  )EOF";
+
+  // Each filter chain has its own factory context.
+  std::vector<Configuration::FactoryContext*> foo_contexts;
+  auto save_context = [](std::vector<Configuration::FactoryContext*>& contexts) {
+    return [&contexts](const Protobuf::RepeatedPtrField<envoy::api::v2::listener::Filter>&,
+                       Configuration::FactoryContext& context)
+               -> std::vector<Network::FilterFactoryCb> {
+      contexts.push_back(&context);
+      return {[](Network::FilterManager&) -> void {}};
+    };
+  };
+  MockDrainManager* foo_drain_manager = new MockDrainManager();
+  EXPECT_CALL(listener_factory_, createDrainManager_(_)).WillOnce(Return(foo_drain_manager));
+  EXPECT_CALL(listener_factory_, createNetworkFilterFactoryList(_, _))
+      .Times(2)
+      .WillRepeatedly(Invoke(save_context(foo_contexts)));
+  EXPECT_CALL(listener_factory_, createListenSocket(_, _, true));
+  EXPECT_CALL(*worker_, addListener(_, _));
+  EXPECT_TRUE(manager_->addOrUpdateListener(parseListenerFromV2Yaml(listener_foo_yaml), "", true));
+  worker_->callAddCompletion(true);
+  ASSERT_EQ(2, foo_contexts.size());
+  EXPECT_NE(foo_contexts[0], foo_contexts[1]);
+
+  // Replace the second filter chain.
+  const std::string listener_foo_update_yaml = R"EOF(
+    name: foo
+    address:
+      socket_address: { address: 127.0.0.1, port_value: 1234 }
+    filter_chains:
+    - filter_chain_match: { destination_port: 8080 }
+      filters: []
+    - filter_chain_match: { destination_port: 8082 }
+      filters: []
+  )EOF";
+
+  std::vector<Configuration::FactoryContext*> foo_update_contexts;
+  EXPECT_CALL(listener_factory_, createDrainManager_(_)).WillOnce(Return(new MockDrainManager()));
+  EXPECT_CALL(listener_factory_, createNetworkFilterFactoryList(_, _))
+      .Times(2)
+      .WillRepeatedly(Invoke(save_context(foo_update_contexts)));
+  EXPECT_CALL(*worker_, addListener(_, _));
+  EXPECT_CALL(*worker_, stopListener(_));
+  EXPECT_CALL(*foo_drain_manager, startDrainSequence(_));
+  EXPECT_TRUE(
+      manager_->addOrUpdateListener(parseListenerFromV2Yaml(listener_foo_update_yaml), "", true));
+  worker_->callAddCompletion(true);
+  checkStats(1, 1, 0, 0, 1, 1);
+
+  // The connections of the kept filter chain only drain with the server.
+  EXPECT_CALL(server_.drain_manager_, drainClose()).WillOnce(Return(false));
+  EXPECT_FALSE(foo_contexts[0]->drainDecision().drainClose());
+  EXPECT_CALL(*foo_drain_manager, drainClose()).WillOnce(Return(true));
+  EXPECT_TRUE(foo_contexts[1]->drainDecision().drainClose());
+
+  // Only the connections of the replaced filter chain are closed once the drain time is over.
+  EXPECT_CALL(*worker_, removeFilterChains(_, _, _))
+      .WillOnce(Invoke([&](Network::ListenerConfig&,
+                           const std::list<const Network::FilterChain*>& filter_chains,
+                           std::function<void()> completion) -> void {
+        EXPECT_EQ(1, filter_chains.size());
+        worker_->remove_listener_completion_ = completion;
+      }));
+  foo_drain_manager->drain_sequence_completion_();
+  worker_->callRemovalCompletion();
+  checkStats(1, 1, 0, 0, 1, 0);
+}
+
+// A listener is drained as a whole when something else than its filter chains changed.
+TEST_F(ListenerManagerImplTest, UpdateDrainsAllFilterChainsOnListenerChange) {
+  InSequence s;
+
+  EXPECT_CALL(*worker_, start(_));
+  manager_->startWorkers(guard_dog_);
+
+  const std::string listener_foo_yaml = R"EOF(
+    name: foo
+    address:
+      socket_address: { address: 127.0.0.1, port_value: 1234 }
+    filter_chains:
+    - filters: []
+  )EOF";
+
+  ListenerHandle* listener_foo = expectListenerCreate(false);
+  EXPECT_CALL(listener_factory_, createListenSocket(_, _, true));
+  EXPECT_CALL(*worker_, addListener(_, _));
+  EXPECT_TRUE(manager_->addOrUpdateListener(parseListenerFromV2Yaml(listener_foo_yaml), "", true));
+  worker_->callAddCompletion(true);
+
+  const std::string listener_foo_update_yaml = R"EOF(
+    name: foo
+    address:
+      socket_address: { address: 127.0.0.1, port_value: 1234 }
+    filter_chains:
+    - filters: []
+    per_connection_buffer_limit_bytes: 10
+  )EOF";
+
+  ListenerHandle* listener_foo_update = expectListenerCreate(false);
+  EXPECT_CALL(*worker_, addListener(_, _));
+  EXPECT_CALL(*worker_, stopListener(_));
+  EXPECT_CALL(*listener_foo->drain_manager_, startDrainSequence(_));
+  EXPECT_TRUE(
+      manager_->addOrUpdateListener(parseListenerFromV2Yaml(listener_foo_update_yaml), "", true));
+  worker_->callAddCompletion(true);
+
+  EXPECT_CALL(*listener_foo->drain_manager_, drainClose()).WillOnce(Return(true));
+  EXPECT_TRUE(listener_foo->context_->drainDecision().drainClose());
+
+  EXPECT_CALL(*worker_, removeListener(_, _));
+  listener_foo->drain_manager_->drain_sequence_completion_();
+  EXPECT_CALL(*listener_foo, onDestroy());
+  worker_->callRemovalCompletion();
+  checkStats(1, 1, 0, 0, 1, 0);
+
+  EXPECT_CALL(*listener_foo_update, onDestroy());
+}
+
 TEST_F(ListenerManagerImplTest, RemoveListener) {
   InSequence s;
 
@@ -1112,6 +1252,238 @@ TEST_F(ListenerManagerImplTest, EarlyShutdown) {
   manager_->stopWorkers();
 }
 
+TEST_F(ListenerManagerImplTest, TransferIdleConnections) {
+  // Nothing is released before the workers are started.
+  EXPECT_CALL(*worker_, releaseIdleConnections(_)).Times(0);
+  EXPECT_TRUE(manager_->releaseIdleConnections().empty());
+
+  EXPECT_CALL(*worker_, start(_));
+  manager_->startWorkers(guard_dog_);
+
+  EXPECT_CALL(*worker_, releaseIdleConnections(_))
+      .WillOnce(Invoke([](std::function<void(std::vector<int>&&)> completion) -> void {
+        completion({7, 8});
+      }));
+  EXPECT_EQ(std::vector<int>({7, 8}), manager_->releaseIdleConnections());
+
+  EXPECT_CALL(*worker_, adoptConnection_(_)).Times(2);
+  manager_->adoptConnection(std::make_unique<NiceMock<Network::MockConnectionSocket>>());
+  manager_->adoptConnection(std::make_unique<NiceMock<Network::MockConnectionSocket>>());
+}
+
+TEST_F(ListenerManagerImplTest, ReusePortListenerUsesWorkerSocket) {
+  InSequence s;
+
+  EXPECT_CALL(*worker_, start(_));
+  manager_->startWorkers(guard_dog_);
+
+  const std::string listener_foo_yaml = R"EOF(
+    name: foo
+    address:
+      socket_address: { address: 127.0.0.1, port_value: 1234 }
+    filter_chains:
+    - filters: []
+    reuse_port: true
+  )EOF";
+
+  auto worker_socket = std::make_shared<NiceMock<Network::MockListenSocket>>();
+  ON_CALL(*worker_socket, fd()).WillByDefault(Return(42));
+  ListenerHandle* listener_foo = expectListenerCreate(false);
+  EXPECT_CALL(listener_factory_, createReusePortListenSocket(_, _, 0))
+      .WillOnce(Return(worker_socket));
+  EXPECT_CALL(*worker_, addListener(_, _))
+      .WillOnce(Invoke([&](Network::ListenerConfig& config, Worker::AddListenerCompletion) -> void {
+        EXPECT_EQ(worker_socket.get(), &config.socket());
+        EXPECT_EQ("foo", config.name());
+      }));
+  EXPECT_TRUE(manager_->addOrUpdateListener(parseListenerFromV2Yaml(listener_foo_yaml), "", true));
+  checkStats(1, 0, 0, 0, 1, 0);
+
+  EXPECT_EQ(42, manager_->listenSocketFd(*worker_socket->localAddress(), 0));
+  EXPECT_EQ(-1, manager_->listenSocketFd(*worker_socket->localAddress(), 1));
+
+  EXPECT_CALL(*listener_foo, onDestroy());
+}
+
+TEST_F(ListenerManagerImplTest, ReusePortCannotBeChangedOnUpdate) {
+  InSequence s;
+
+  const std::string listener_foo_yaml = R"EOF(
+    name: foo
+    address:
+      socket_address: { address: 127.0.0.1, port_value: 1234 }
+    filter_chains:
+    - filters: []
+  )EOF";
+
+  ListenerHandle* listener_foo = expectListenerCreate(false);
+  EXPECT_CALL(listener_factory_, createListenSocket(_, _, true));
+  EXPECT_TRUE(manager_->addOrUpdateListener(parseListenerFromV2Yaml(listener_foo_yaml), "", true));
+  checkStats(1, 0, 0, 0, 1, 0);
+
+  // Update foo listener, but with reuse_port set. Should throw.
+  const std::string listener_foo_reuse_port_yaml = R"EOF(
+    name: foo
+    address:
+      socket_address: { address: 127.0.0.1, port_value: 1234 }
+    filter_chains:
+    - filters: []
+    reuse_port: true
+  )EOF";
+
+  ListenerHandle* listener_foo_reuse_port = expectListenerCreate(false);
+  EXPECT_CALL(*listener_foo_reuse_port, onDestroy());
+  EXPECT_THROW_WITH_MESSAGE(
+      manager_->addOrUpdateListener(parseListenerFromV2Yaml(listener_foo_reuse_port_yaml), "",
+                                    true),
+      EnvoyException,
+      "error updating listener: 'foo' has a different reuse_port setting from existing listener");
+
+  EXPECT_CALL(*listener_foo, onDestroy());
+}
+
+TEST_F(ListenerManagerImplTest, UdpListenerUsesWorkerSocket) {
+  InSequence s;
+
+  EXPECT_CALL(*worker_, start(_));
+  manager_->startWorkers(guard_dog_);
+
+  const std::string listener_foo_yaml = R"EOF(
+    name: foo
+    address:
+      socket_address: { protocol: UDP, address: 127.0.0.1, port_value: 1234 }
+    listener_filters:
+    - name: udp_filter
+  )EOF";
+
+  // The listener's destruction is tracked through its UDP listener filter factory.
+  ListenerHandle* listener_foo = new ListenerHandle();
+  EXPECT_CALL(listener_factory_, createDrainManager_(_))
+      .WillOnce(Return(listener_foo->drain_manager_));
+  EXPECT_CALL(listener_factory_, createUdpListenerFilterFactoryList(_, _))
+      .WillOnce(Invoke(
+          [listener_foo](const Protobuf::RepeatedPtrField<envoy::api::v2::listener::ListenerFilter>&
+                             filters,
+                         Configuration::ListenerFactoryContext&)
+              -> std::vector<Network::UdpListenerFilterFactoryCb> {
+            EXPECT_EQ(1, filters.size());
+            std::shared_ptr<ListenerHandle> notifier(listener_foo);
+            return {[notifier](Network::UdpListenerFilterManager&,
+                               Network::UdpReadFilterCallbacks&) -> void {}};
+          }));
+  auto worker_socket = std::make_shared<NiceMock<Network::MockListenSocket>>();
+  EXPECT_CALL(listener_factory_, createUdpListenSocket(_, _, 0)).WillOnce(Return(worker_socket));
+  EXPECT_CALL(*worker_, addListener(_, _))
+      .WillOnce(Invoke([&](Network::ListenerConfig& config, Worker::AddListenerCompletion) -> void {
+        EXPECT_EQ(worker_socket.get(), &config.socket());
+        EXPECT_EQ(Network::Address::SocketType::Datagram, config.socketType());
+      }));
+  EXPECT_TRUE(manager_->addOrUpdateListener(parseListenerFromV2Yaml(listener_foo_yaml), "", true));
+  checkStats(1, 0, 0, 0, 1, 0);
+
+  // UDP sockets are never passed to a hot restarted process.
+  EXPECT_EQ(-1, manager_->listenSocketFd(*worker_socket->localAddress(), 0));
+
+  EXPECT_CALL(*listener_foo, onDestroy());
+}
+
+TEST_F(ListenerManagerImplTest, UdpListenerQuicConnectionIdRouting) {
+  // The routing program is attached to the mock worker socket once it is bound.
+  NiceMock<Api::MockOsSysCalls> os_sys_calls;
+  TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls(&os_sys_calls);
+
+  const std::string listener_foo_yaml = R"EOF(
+    name: foo
+    address:
+      socket_address: { protocol: UDP, address: 127.0.0.1, port_value: 1234 }
+    udp_worker_routing: QUIC_CONNECTION_ID
+  )EOF";
+
+  EXPECT_CALL(listener_factory_, createDrainManager_(_))
+      .WillOnce(Return(new NiceMock<MockDrainManager>()));
+  EXPECT_CALL(listener_factory_, createUdpListenerFilterFactoryList(_, _));
+  Network::Socket::OptionsSharedPtr options;
+  EXPECT_CALL(listener_factory_, createUdpListenSocket(_, _, 0))
+      .WillOnce(DoAll(SaveArg<1>(&options),
+                      Return(std::make_shared<NiceMock<Network::MockListenSocket>>())));
+  EXPECT_TRUE(manager_->addOrUpdateListener(parseListenerFromV2Yaml(listener_foo_yaml), "", true));
+
+  // The routing program is attached to the worker's socket along with SO_REUSEPORT.
+  ASSERT_NE(nullptr, options);
+  EXPECT_EQ(1, std::count_if(options->begin(), options->end(),
+                             [](const Network::Socket::OptionConstSharedPtr& option) {
+                               return dynamic_cast<
+                                          const Network::QuicConnectionIdRoutingSocketOptionImpl*>(
+                                          option.get()) != nullptr;
+                             }));
+
+  // The routing cannot be changed by an update.
+  const std::string listener_foo_update_yaml = R"EOF(
+    name: foo
+    address:
+      socket_address: { protocol: UDP, address: 127.0.0.1, port_value: 1234 }
+  )EOF";
+
+  EXPECT_CALL(listener_factory_, createDrainManager_(_))
+      .WillOnce(Return(new NiceMock<MockDrainManager>()));
+  EXPECT_CALL(listener_factory_, createUdpListenerFilterFactoryList(_, _));
+  EXPECT_THROW_WITH_MESSAGE(
+      manager_->addOrUpdateListener(parseListenerFromV2Yaml(listener_foo_update_yaml), "", true),
+      EnvoyException,
+      "error updating listener: 'foo' has a different udp_worker_routing setting from existing "
+      "listener");
+}
+
+TEST_F(ListenerManagerImplTest, TcpListenerWithUdpWorkerRouting) {
+  const std::string listener_foo_yaml = R"EOF(
+    name: foo
+    address:
+      socket_address: { address: 127.0.0.1, port_value: 1234 }
+    filter_chains:
+    - filters: []
+    udp_worker_routing: QUIC_CONNECTION_ID
+  )EOF";
+
+  EXPECT_CALL(listener_factory_, createDrainManager_(_))
+      .WillOnce(Return(new NiceMock<MockDrainManager>()));
+  EXPECT_THROW_WITH_MESSAGE(
+      manager_->addOrUpdateListener(parseListenerFromV2Yaml(listener_foo_yaml), "", true),
+      EnvoyException,
+      "error adding listener '127.0.0.1:1234': udp_worker_routing only applies to UDP listeners");
+}
+
+TEST_F(ListenerManagerImplTest, UdpListenerWithFilterChains) {
+  const std::string listener_foo_yaml = R"EOF(
+    name: foo
+    address:
+      socket_address: { protocol: UDP, address: 127.0.0.1, port_value: 1234 }
+    filter_chains:
+    - filters: []
+  )EOF";
+
+  EXPECT_CALL(listener_factory_, createDrainManager_(_))
+      .WillOnce(Return(new NiceMock<MockDrainManager>()));
+  EXPECT_THROW_WITH_MESSAGE(
+      manager_->addOrUpdateListener(parseListenerFromV2Yaml(listener_foo_yaml), "", true),
+      EnvoyException,
+      "error adding listener '127.0.0.1:1234': UDP listeners do not support filter chains, "
+      "configure UDP listener filters instead");
+}
+
+TEST_F(ListenerManagerImplTest, TcpListenerWithoutFilterChains) {
+  const std::string listener_foo_yaml = R"EOF(
+    name: foo
+    address:
+      socket_address: { address: 127.0.0.1, port_value: 1234 }
+  )EOF";
+
+  EXPECT_CALL(listener_factory_, createDrainManager_(_))
+      .WillOnce(Return(new NiceMock<MockDrainManager>()));
+  EXPECT_THROW_WITH_MESSAGE(
+      manager_->addOrUpdateListener(parseListenerFromV2Yaml(listener_foo_yaml), "", true),
+      EnvoyException, "error adding listener '127.0.0.1:1234': no filter chains specified");
+}
+
 TEST_F(ListenerManagerImplWithRealFiltersTest, SingleFilterChainWithDestinationPortMatch) {
   const std::string yaml = TestEnvironment::substitute(R"EOF(
     address:
@@ -1536,6 +1908,16 @@ TEST_F(ListenerManagerImplWithRealFiltersTest, MultipleFilterChainsWithServerNam
   EXPECT_EQ(server_names.size(), 1);
   EXPECT_EQ(server_names.front(), "server1.example.com");
 
+  // TLS client with exact SNI match ignoring case - using 2nd filter chain.
+  filter_chain =
+      findFilterChain(1234, true, "127.0.0.1", true, "Server1.EXAMPLE.com", true, "tls", true, {});
+  ASSERT_NE(filter_chain, nullptr);
+  transport_socket = filter_chain->transportSocketFactory().createTransportSocket();
+  ssl_socket = dynamic_cast<Ssl::SslSocket*>(transport_socket.get());
+  server_names = ssl_socket->dnsSansLocalCertificate();
+  EXPECT_EQ(server_names.size(), 1);
+  EXPECT_EQ(server_names.front(), "server1.example.com");
+
   // TLS client with wildcard SNI match - using 3nd filter chain.
   filter_chain =
       findFilterChain(1234, true, "127.0.0.1", true, "server2.example.com", true, "tls", true, {});
@@ -2568,6 +2950,91 @@ TEST_F(ListenerManagerImplWithRealFiltersTest, LiteralSockoptListenerEnabled) {
   EXPECT_EQ(1U, manager_->listeners().size());
 }
 
+TEST_F(ListenerManagerImplWithRealFiltersTest, ReusePortListenerEnabled) {
+  NiceMock<Api::MockOsSysCalls> os_sys_calls;
+  TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls(&os_sys_calls);
+
+  const std::string yaml = TestEnvironment::substitute(R"EOF(
+    name: ReusePortListener
+    address:
+      socket_address: { address: 127.0.0.1, port_value: 1111 }
+    filter_chains:
+    - filters:
+    reuse_port: true
+  )EOF",
+                                                       Network::Address::IpVersion::v4);
+  if (ENVOY_SOCKET_SO_REUSEPORT.has_value()) {
+    EXPECT_CALL(listener_factory_, createReusePortListenSocket(_, _, 0))
+        .WillOnce(Invoke([this](Network::Address::InstanceConstSharedPtr,
+                                const Network::Socket::OptionsSharedPtr& options,
+                                uint32_t) -> Network::SocketSharedPtr {
+          EXPECT_NE(options.get(), nullptr);
+          EXPECT_EQ(options->size(), 1);
+          EXPECT_TRUE(
+              Network::Socket::applyOptions(options, *listener_factory_.socket_,
+                                            envoy::api::v2::core::SocketOption::STATE_PREBIND));
+          return listener_factory_.socket_;
+        }));
+    EXPECT_CALL(os_sys_calls, setsockopt_(_, ENVOY_SOCKET_SO_REUSEPORT.value().first,
+                                          ENVOY_SOCKET_SO_REUSEPORT.value().second, _,
+                                          sizeof(int)))
+        .WillOnce(Invoke([](int, int, int, const void* optval, socklen_t) -> int {
+          EXPECT_EQ(1, *static_cast<const int*>(optval));
+          return 0;
+        }));
+    manager_->addOrUpdateListener(parseListenerFromV2Yaml(yaml), "", true);
+    EXPECT_EQ(1U, manager_->listeners().size());
+  } else {
+    // MockListenerSocket is not a real socket, so this always fails in testing.
+    EXPECT_THROW_WITH_MESSAGE(
+        manager_->addOrUpdateListener(parseListenerFromV2Yaml(yaml), "", true), EnvoyException,
+        "MockListenerComponentFactory: Setting socket options failed");
+    EXPECT_EQ(0U, manager_->listeners().size());
+  }
+}
+
+TEST_F(ListenerManagerImplWithRealFiltersTest, ReusePortIncomingCpu) {
+  NiceMock<Api::MockOsSysCalls> os_sys_calls;
+  TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls(&os_sys_calls);
+  server_.options_.worker_cpus_ = {7};
+  server_.options_.reuse_port_incoming_cpu_ = true;
+
+  const std::string yaml = TestEnvironment::substitute(R"EOF(
+    name: ReusePortListener
+    address:
+      socket_address: { address: 127.0.0.1, port_value: 1111 }
+    filter_chains:
+    - filters:
+    reuse_port: true
+  )EOF",
+                                                       Network::Address::IpVersion::v4);
+  if (ENVOY_SOCKET_SO_REUSEPORT.has_value() && ENVOY_SOCKET_SO_INCOMING_CPU.has_value()) {
+    EXPECT_CALL(listener_factory_, createReusePortListenSocket(_, _, 0))
+        .WillOnce(Invoke([this](Network::Address::InstanceConstSharedPtr,
+                                const Network::Socket::OptionsSharedPtr& options,
+                                uint32_t) -> Network::SocketSharedPtr {
+          EXPECT_EQ(options->size(), 2);
+          EXPECT_TRUE(
+              Network::Socket::applyOptions(options, *listener_factory_.socket_,
+                                            envoy::api::v2::core::SocketOption::STATE_PREBIND));
+          return listener_factory_.socket_;
+        }));
+    EXPECT_CALL(os_sys_calls, setsockopt_(_, ENVOY_SOCKET_SO_REUSEPORT.value().first,
+                                          ENVOY_SOCKET_SO_REUSEPORT.value().second, _,
+                                          sizeof(int)))
+        .WillOnce(Return(0));
+    EXPECT_CALL(os_sys_calls, setsockopt_(_, ENVOY_SOCKET_SO_INCOMING_CPU.value().first,
+                                          ENVOY_SOCKET_SO_INCOMING_CPU.value().second, _,
+                                          sizeof(int)))
+        .WillOnce(Invoke([](int, int, int, const void* optval, socklen_t) -> int {
+          EXPECT_EQ(7, *static_cast<const int*>(optval));
+          return 0;
+        }));
+    manager_->addOrUpdateListener(parseListenerFromV2Yaml(yaml), "", true);
+    EXPECT_EQ(1U, manager_->listeners().size());
+  }
+}
+
 // Set the resolver to the default IP resolver. The address resolver logic is unit tested in
 // resolver_impl_test.cc.
 TEST_F(ListenerManagerImplWithRealFiltersTest, AddressResolver) {
@@ -5,6 +5,7 @@
 
 #include "envoy/common/exception.h"
 
+#include "common/common/thread.h"
 #include "common/common/utility.h"
 
 #include "server/options_impl.h"
@@ -75,7 +76,11 @@ TEST(OptionsImplTest, All) {
       "envoy --mode validate --concurrency 2 -c hello --admin-address-path path --restart-epoch 1 "
       "--local-address-ip-version v6 -l info --service-cluster cluster --service-node node "
       "--service-zone zone --file-flush-interval-msec 9000 --drain-time-s 60 --log-format [%v] "
-      "--parent-shutdown-time-s 90 --log-path /foo/bar --v2-config-only --disable-hot-restart");
+      "--parent-shutdown-time-s 90 --log-path /foo/bar --log-async-buffer-bytes 4096 "
+      "--v2-config-only --disable-hot-restart --hot-restart-transfer-connections "
+      "--experimental-io-uring --coarse-timer-resolution-ms 16 --worker-cpu-affinity 0-2,5 "
+      "--worker-numa-local-memory --reuse-port-incoming-cpu --dispatcher-stats "
+      "--dispatcher-stall-threshold-ms 25 --huge-page-arena-mb 64");
   EXPECT_EQ(Server::Mode::Validate, options->mode());
   EXPECT_EQ(2U, options->concurrency());
   EXPECT_EQ("hello", options->configPath());
@@ -86,6 +91,7 @@ TEST(OptionsImplTest, All) {
   EXPECT_EQ(spdlog::level::info, options->logLevel());
   EXPECT_EQ("[%v]", options->logFormat());
   EXPECT_EQ("/foo/bar", options->logPath());
+  EXPECT_EQ(4096U, options->logAsyncBufferSize());
   EXPECT_EQ("cluster", options->serviceClusterName());
   EXPECT_EQ("node", options->serviceNodeName());
   EXPECT_EQ("zone", options->serviceZone());
@@ -93,6 +99,15 @@ TEST(OptionsImplTest, All) {
   EXPECT_EQ(std::chrono::seconds(60), options->drainTime());
   EXPECT_EQ(std::chrono::seconds(90), options->parentShutdownTime());
   EXPECT_EQ(true, options->hotRestartDisabled());
+  EXPECT_EQ(true, options->hotRestartTransferConnections());
+  EXPECT_EQ(true, options->ioUringEnabled());
+  EXPECT_EQ(std::chrono::milliseconds(16), options->coarseTimerResolution());
+  EXPECT_EQ(std::vector<uint32_t>({0, 1, 2, 5}), options->workerCpus());
+  EXPECT_EQ(true, options->workerNumaLocalMemory());
+  EXPECT_EQ(true, options->reusePortIncomingCpu());
+  EXPECT_EQ(true, options->dispatcherStatsEnabled());
+  EXPECT_EQ(std::chrono::milliseconds(25), options->dispatcherStallThreshold());
+  EXPECT_EQ(64U, options->hugePageArenaSizeMb());
 
   options = createOptionsImpl("envoy --mode init_only");
   EXPECT_EQ(Server::Mode::InitOnly, options->mode());
@@ -102,6 +117,7 @@ TEST(OptionsImplTest, SetAll) {
   std::unique_ptr<OptionsImpl> options = createOptionsImpl("envoy -c hello");
   bool v2_config_only = options->v2ConfigOnly();
   bool hot_restart_disabled = options->hotRestartDisabled();
+  bool io_uring_enabled = options->ioUringEnabled();
   Stats::StatsOptionsImpl stats_options;
   stats_options.max_obj_name_length_ = 54321;
   stats_options.max_stat_suffix_length_ = 1234;
@@ -117,6 +133,7 @@ TEST(OptionsImplTest, SetAll) {
   options->setLogLevel(spdlog::level::trace);
   options->setLogFormat("%L %n %v");
   options->setLogPath("/foo/bar");
+  options->setLogAsyncBufferSize(8192);
   options->setParentShutdownTime(std::chrono::seconds(43));
   options->setRestartEpoch(44);
   options->setFileFlushIntervalMsec(std::chrono::milliseconds(45));
@@ -127,6 +144,15 @@ TEST(OptionsImplTest, SetAll) {
   options->setMaxStats(12345);
   options->setStatsOptions(stats_options);
   options->setHotRestartDisabled(!options->hotRestartDisabled());
+  options->setHotRestartTransferConnections(true);
+  options->setIoUringEnabled(!options->ioUringEnabled());
+  options->setCoarseTimerResolution(std::chrono::milliseconds(46));
+  options->setWorkerCpus({3, 4});
+  options->setWorkerNumaLocalMemory(true);
+  options->setReusePortIncomingCpu(true);
+  options->setDispatcherStatsEnabled(true);
+  options->setDispatcherStallThreshold(std::chrono::milliseconds(75));
+  options->setHugePageArenaSizeMb(128);
 
   EXPECT_EQ(109876, options->baseId());
   EXPECT_EQ(42U, options->concurrency());
@@ -139,6 +165,7 @@ TEST(OptionsImplTest, SetAll) {
   EXPECT_EQ(spdlog::level::trace, options->logLevel());
   EXPECT_EQ("%L %n %v", options->logFormat());
   EXPECT_EQ("/foo/bar", options->logPath());
+  EXPECT_EQ(8192U, options->logAsyncBufferSize());
   EXPECT_EQ(std::chrono::seconds(43), options->parentShutdownTime());
   EXPECT_EQ(44, options->restartEpoch());
   EXPECT_EQ(std::chrono::milliseconds(45), options->fileFlushIntervalMsec());
@@ -150,6 +177,15 @@ TEST(OptionsImplTest, SetAll) {
   EXPECT_EQ(stats_options.max_obj_name_length_, options->statsOptions().maxObjNameLength());
   EXPECT_EQ(stats_options.max_stat_suffix_length_, options->statsOptions().maxStatSuffixLength());
   EXPECT_EQ(!hot_restart_disabled, options->hotRestartDisabled());
+  EXPECT_EQ(true, options->hotRestartTransferConnections());
+  EXPECT_EQ(!io_uring_enabled, options->ioUringEnabled());
+  EXPECT_EQ(std::chrono::milliseconds(46), options->coarseTimerResolution());
+  EXPECT_EQ(std::vector<uint32_t>({3, 4}), options->workerCpus());
+  EXPECT_EQ(true, options->workerNumaLocalMemory());
+  EXPECT_EQ(true, options->reusePortIncomingCpu());
+  EXPECT_EQ(true, options->dispatcherStatsEnabled());
+  EXPECT_EQ(std::chrono::milliseconds(75), options->dispatcherStallThreshold());
+  EXPECT_EQ(128U, options->hugePageArenaSizeMb());
 }
 
 TEST(OptionsImplTest, DefaultParams) {
@@ -159,7 +195,17 @@ TEST(OptionsImplTest, DefaultParams) {
   EXPECT_EQ("", options->adminAddressPath());
   EXPECT_EQ(Network::Address::IpVersion::v4, options->localAddressIpVersion());
   EXPECT_EQ(Server::Mode::Serve, options->mode());
+  EXPECT_EQ(0U, options->logAsyncBufferSize());
   EXPECT_EQ(false, options->hotRestartDisabled());
+  EXPECT_EQ(false, options->hotRestartTransferConnections());
+  EXPECT_EQ(false, options->ioUringEnabled());
+  EXPECT_EQ(std::chrono::milliseconds(0), options->coarseTimerResolution());
+  EXPECT_TRUE(options->workerCpus().empty());
+  EXPECT_EQ(false, options->workerNumaLocalMemory());
+  EXPECT_EQ(false, options->reusePortIncomingCpu());
+  EXPECT_EQ(false, options->dispatcherStatsEnabled());
+  EXPECT_EQ(std::chrono::milliseconds(0), options->dispatcherStallThreshold());
+  EXPECT_EQ(0U, options->hugePageArenaSizeMb());
 }
 
 TEST(OptionsImplTest, BadCliOption) {
@@ -177,4 +223,18 @@ TEST(OptionsImplTest, BadMaxStatsOption) {
                           "'max-stats' value specified");
 }
 
+TEST(OptionsImplTest, BadWorkerCpuAffinityOption) {
+  EXPECT_THROW_WITH_REGEX(createOptionsImpl("envoy --worker-cpu-affinity 0-"),
+                          MalformedArgvException, "invalid CPU list");
+  EXPECT_THROW_WITH_REGEX(createOptionsImpl("envoy --worker-cpu-affinity 3-1"),
+                          MalformedArgvException, "invalid CPU list");
+  EXPECT_THROW_WITH_REGEX(createOptionsImpl("envoy --worker-cpu-affinity 0,,1"),
+                          MalformedArgvException, "invalid CPU list");
+}
+
+TEST(OptionsImplTest, AutoWorkerCpuAffinity) {
+  std::unique_ptr<OptionsImpl> options = createOptionsImpl("envoy --worker-cpu-affinity auto");
+  EXPECT_EQ(Thread::Thread::allowedCpus(), options->workerCpus());
+}
+
 } // namespace Envoy
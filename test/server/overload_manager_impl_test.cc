@@ -200,6 +200,121 @@ TEST_F(OverloadManagerImplTest, CallbackOnlyFiresWhenStateChanges) {
   EXPECT_EQ(40, pressure_gauge2.value());
 }
 
+TEST_F(OverloadManagerImplTest, ScaledTrigger) {
+  setDispatcherExpectation();
+
+  const std::string config = R"EOF(
+    resource_monitors {
+      name: "envoy.resource_monitors.fake_resource1"
+    }
+    resource_monitors {
+      name: "envoy.resource_monitors.fake_resource2"
+    }
+    actions {
+      name: "envoy.overload_actions.dummy_action"
+      triggers {
+        name: "envoy.resource_monitors.fake_resource1"
+        scaled {
+          scaling_threshold: 0.5
+          saturation_threshold: 0.75
+        }
+      }
+      triggers {
+        name: "envoy.resource_monitors.fake_resource2"
+        threshold {
+          value: 0.8
+        }
+      }
+    }
+  )EOF";
+  auto manager(createOverloadManager(config));
+  int cb_count = 0;
+  manager->registerForAction("envoy.overload_actions.dummy_action", dispatcher_,
+                             [&](OverloadActionState) { cb_count++; });
+  std::vector<double> posted_values;
+  manager->registerForActionValue("envoy.overload_actions.dummy_action", dispatcher_,
+                                  [&](double value) { posted_values.push_back(value); });
+  manager->registerForActionValue("envoy.overload_actions.unknown_action", dispatcher_,
+                                  [&](double) { EXPECT_TRUE(false); });
+  manager->start();
+
+  const OverloadActionValue& value =
+      manager->getActionValue("envoy.overload_actions.dummy_action");
+  EXPECT_EQ(0, manager->getActionValue("envoy.overload_actions.unknown_action").value());
+  Stats::Gauge& active_gauge = stats_.gauge("overload.envoy.overload_actions.dummy_action.active");
+  Stats::Gauge& scale_percent_gauge =
+      stats_.gauge("overload.envoy.overload_actions.dummy_action.scale_percent");
+  const OverloadActionState& action_state =
+      manager->getThreadLocalOverloadState().getState("envoy.overload_actions.dummy_action");
+
+  factory1_.monitor_->setPressure(0.4);
+  timer_cb_();
+  EXPECT_EQ(0, value.value());
+  EXPECT_EQ(0, scale_percent_gauge.value());
+  EXPECT_TRUE(posted_values.empty());
+
+  // Between the thresholds, the value scales without activating the action.
+  factory1_.monitor_->setPressure(0.625);
+  timer_cb_();
+  EXPECT_EQ(0.5, value.value());
+  EXPECT_EQ(0.5, posted_values.back());
+  EXPECT_EQ(50, scale_percent_gauge.value());
+  EXPECT_EQ(0, active_gauge.value());
+  EXPECT_EQ(action_state, OverloadActionState::Inactive);
+  EXPECT_EQ(0, cb_count);
+
+  factory1_.monitor_->setPressure(0.95);
+  timer_cb_();
+  EXPECT_EQ(1, value.value());
+  EXPECT_EQ(1, active_gauge.value());
+  EXPECT_EQ(action_state, OverloadActionState::Active);
+  EXPECT_EQ(1, cb_count);
+
+  // The highest value of the triggers wins.
+  factory1_.monitor_->setPressure(0.6875);
+  factory2_.monitor_->setPressure(0.85);
+  timer_cb_();
+  EXPECT_EQ(1, value.value());
+  EXPECT_EQ(1, cb_count);
+
+  factory2_.monitor_->setPressure(0.1);
+  timer_cb_();
+  EXPECT_EQ(0.75, value.value());
+  EXPECT_EQ(0.75, posted_values.back());
+  EXPECT_EQ(0, active_gauge.value());
+  EXPECT_EQ(action_state, OverloadActionState::Inactive);
+  EXPECT_EQ(2, cb_count);
+
+  // The value is posted once more when it drops to 0, and then no more.
+  factory1_.monitor_->setPressure(0.4);
+  timer_cb_();
+  EXPECT_EQ(0, posted_values.back());
+  const size_t num_posted_values = posted_values.size();
+  timer_cb_();
+  EXPECT_EQ(num_posted_values, posted_values.size());
+}
+
+TEST_F(OverloadManagerImplTest, InvalidScaledTrigger) {
+  const std::string config = R"EOF(
+    resource_monitors {
+      name: "envoy.resource_monitors.fake_resource1"
+    }
+    actions {
+      name: "envoy.overload_actions.dummy_action"
+      triggers {
+        name: "envoy.resource_monitors.fake_resource1"
+        scaled {
+          scaling_threshold: 0.9
+          saturation_threshold: 0.9
+        }
+      }
+    }
+  )EOF";
+
+  EXPECT_THROW_WITH_MESSAGE(createOverloadManager(config), EnvoyException,
+                            "scaling_threshold must be less than saturation_threshold");
+}
+
 TEST_F(OverloadManagerImplTest, FailedUpdates) {
   setDispatcherExpectation();
   auto manager(createOverloadManager(getConfig()));
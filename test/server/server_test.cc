@@ -61,7 +61,8 @@ public:
     EXPECT_CALL(overload_manager_, start());
 
     helper_.reset(new RunHelper(dispatcher_, cm_, hot_restart_, access_log_manager_, init_manager_,
-                                overload_manager_, [this] { start_workers_.ready(); }));
+                                overload_manager_, startup_timeline_,
+                                [this] { start_workers_.ready(); }));
   }
 
   NiceMock<Event::MockDispatcher> dispatcher_;
@@ -70,6 +71,8 @@ public:
   NiceMock<AccessLog::MockAccessLogManager> access_log_manager_;
   NiceMock<MockOverloadManager> overload_manager_;
   InitManagerImpl init_manager_;
+  DangerousDeprecatedTestTime test_time_;
+  StartupTimeline startup_timeline_{test_time_.timeSystem()};
   ReadyWatcher start_workers_;
   std::unique_ptr<RunHelper> helper_;
   std::function<void()> cm_init_callback_;
@@ -81,6 +84,13 @@ public:
 TEST_F(RunHelperTest, Normal) {
   EXPECT_CALL(start_workers_, ready());
   cm_init_callback_();
+
+  const auto timeline = startup_timeline_.toProto();
+  ASSERT_EQ(2, timeline.phases_size());
+  EXPECT_EQ("cluster_manager_init", timeline.phases(0).name());
+  EXPECT_TRUE(timeline.phases(0).has_duration());
+  EXPECT_EQ("init_manager", timeline.phases(1).name());
+  EXPECT_TRUE(timeline.phases(1).has_duration());
 }
 
 TEST_F(RunHelperTest, ShutdownBeforeCmInitialize) {
@@ -0,0 +1,98 @@
+#include "server/startup_timeline.h"
+
+#include "test/mocks/common.h"
+#include "test/mocks/stats/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::NiceMock;
+using testing::Property;
+using testing::ReturnPointee;
+
+namespace Envoy {
+namespace Server {
+
+class StartupTimelineTest : public testing::Test {
+public:
+  StartupTimelineTest() {
+    ON_CALL(time_source_, monotonicTime()).WillByDefault(ReturnPointee(&now_));
+    timeline_ = std::make_unique<StartupTimeline>(time_source_);
+  }
+
+  void advance(uint64_t ms) { now_ += std::chrono::milliseconds(ms); }
+
+  void expectRecord(const std::string& name, uint64_t ms) {
+    EXPECT_CALL(store_, deliverHistogramToSinks(
+                            Property(&Stats::Metric::name, "server.startup." + name), ms));
+  }
+
+  NiceMock<MockTimeSource> time_source_;
+  MonotonicTime now_;
+  NiceMock<Stats::MockIsolatedStatsStore> store_;
+  std::unique_ptr<StartupTimeline> timeline_;
+};
+
+TEST_F(StartupTimelineTest, PhasesBeforeAndAfterStats) {
+  advance(5);
+  const uint64_t bootstrap = timeline_->startPhase("bootstrap_load");
+  advance(10);
+  timeline_->endPhase(bootstrap);
+  const uint64_t runtime = timeline_->startPhase("runtime_init");
+  advance(3);
+
+  // Phases which ended before the stats existed are recorded once they do.
+  expectRecord("bootstrap_load_ms", 10);
+  timeline_->initializeStats(store_);
+
+  expectRecord("runtime_init_ms", 3);
+  timeline_->endPhase(runtime);
+
+  // Targets of the init manager are recorded to one histogram, and overlap.
+  const uint64_t lds = timeline_->startPhase("init_target.lds");
+  advance(1);
+  const uint64_t rds = timeline_->startPhase("init_target.rds foo");
+  advance(20);
+  expectRecord("init_target_ms", 21);
+  timeline_->endPhase(lds);
+  advance(4);
+  expectRecord("init_target_ms", 24);
+  timeline_->endPhase(rds);
+
+  // Phases without a histogram are only in the timeline.
+  EXPECT_CALL(store_, deliverHistogramToSinks(_, _)).Times(0);
+  timeline_->endPhase(timeline_->startPhase("other"));
+  testing::Mock::VerifyAndClearExpectations(&store_);
+
+  const uint64_t pending = timeline_->startPhase("workers_start");
+  EXPECT_FALSE(timeline_->completed());
+  expectRecord("total_ms", 43);
+  timeline_->complete();
+  EXPECT_TRUE(timeline_->completed());
+
+  const envoy::admin::v2alpha::StartupTimeline timeline = timeline_->toProto();
+  ASSERT_EQ(6, timeline.phases_size());
+  EXPECT_EQ("bootstrap_load", timeline.phases(0).name());
+  EXPECT_EQ(5, Protobuf::util::TimeUtil::DurationToMilliseconds(timeline.phases(0).start()));
+  EXPECT_EQ(10, Protobuf::util::TimeUtil::DurationToMilliseconds(timeline.phases(0).duration()));
+  EXPECT_EQ("init_target.rds foo", timeline.phases(3).name());
+  EXPECT_EQ(19, Protobuf::util::TimeUtil::DurationToMilliseconds(timeline.phases(3).start()));
+  EXPECT_EQ(24, Protobuf::util::TimeUtil::DurationToMilliseconds(timeline.phases(3).duration()));
+  EXPECT_EQ("workers_start", timeline.phases(5).name());
+  EXPECT_FALSE(timeline.phases(5).has_duration());
+  EXPECT_EQ(43, Protobuf::util::TimeUtil::DurationToMilliseconds(timeline.total()));
+
+  expectRecord("workers_start_ms", 0);
+  timeline_->endPhase(pending);
+}
+
+TEST_F(StartupTimelineTest, CompleteBeforeStats) {
+  advance(7);
+  timeline_->complete();
+  expectRecord("total_ms", 7);
+  timeline_->initializeStats(store_);
+}
+
+} // namespace Server
+} // namespace Envoy
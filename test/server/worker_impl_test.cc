@@ -1,3 +1,8 @@
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/common/thread.h"
 #include "common/event/dispatcher_impl.h"
 
 #include "server/worker_impl.h"
@@ -35,8 +40,9 @@ public:
   Network::MockConnectionHandler* handler_ = new Network::MockConnectionHandler();
   NiceMock<MockGuardDog> guard_dog_;
   DefaultTestHooks hooks_;
+  NiceMock<MockOverloadManager> overload_manager_;
   WorkerImpl worker_{tls_, hooks_, Event::DispatcherPtr{dispatcher_},
-                     Network::ConnectionHandlerPtr{handler_}};
+                     Network::ConnectionHandlerPtr{handler_}, overload_manager_};
   Event::TimerPtr no_exit_timer_ = dispatcher_->createTimer([]() -> void {});
 };
 
@@ -132,5 +138,62 @@ TEST_F(WorkerImplTest, ListenerException) {
   worker_.stop();
 }
 
+TEST(WorkerImplOverloadTest, OverloadActions) {
+  NiceMock<ThreadLocal::MockInstance> tls;
+  DangerousDeprecatedTestTime test_time;
+  Network::MockConnectionHandler* handler = new Network::MockConnectionHandler();
+  DefaultTestHooks hooks;
+  NiceMock<MockOverloadManager> overload_manager;
+  std::unordered_map<std::string, OverloadActionValueCb> callbacks;
+  EXPECT_CALL(overload_manager, registerForActionValue(_, _, _))
+      .Times(2)
+      .WillRepeatedly(Invoke([&callbacks](const std::string& action, Event::Dispatcher&,
+                                          OverloadActionValueCb callback) -> void {
+        callbacks[action] = callback;
+      }));
+  Event::DispatcherPtr dispatcher(new Event::DispatcherImpl(test_time.timeSystem()));
+  WorkerImpl worker(tls, hooks, std::move(dispatcher), Network::ConnectionHandlerPtr{handler},
+                    overload_manager);
+
+  EXPECT_CALL(*handler, setBufferLimitScale(0.75));
+  callbacks[OverloadActionNames::get().ReduceBufferLimits](0.25);
+
+  EXPECT_CALL(*handler, closeIdleConnections(0.5));
+  callbacks[OverloadActionNames::get().CloseIdleConnections](0.5);
+}
+
+TEST(WorkerImplPlacementTest, PinnedToCpu) {
+  const std::vector<uint32_t> allowed_cpus = Thread::Thread::allowedCpus();
+  if (allowed_cpus.empty()) {
+    // CPU affinity is only supported on Linux.
+    return;
+  }
+
+  NiceMock<ThreadLocal::MockInstance> tls;
+  DangerousDeprecatedTestTime test_time;
+  Event::DispatcherImpl* dispatcher = new Event::DispatcherImpl(test_time.timeSystem());
+  NiceMock<MockGuardDog> guard_dog;
+  DefaultTestHooks hooks;
+  NiceMock<MockOverloadManager> overload_manager;
+  WorkerImpl worker(tls, hooks, Event::DispatcherPtr{dispatcher},
+                    Network::ConnectionHandlerPtr{new NiceMock<Network::MockConnectionHandler>()},
+                    overload_manager, allowed_cpus.back());
+  Event::TimerPtr no_exit_timer = dispatcher->createTimer([]() -> void {});
+  no_exit_timer->enableTimer(std::chrono::hours(1));
+
+  ConditionalInitializer ci;
+  std::vector<uint32_t> worker_cpus;
+  NiceMock<Network::MockListenerConfig> listener;
+  worker.addListener(listener, [&ci, &worker_cpus](bool) -> void {
+    worker_cpus = Thread::Thread::allowedCpus();
+    ci.setReady();
+  });
+  worker.start(guard_dog);
+  ci.waitReady();
+  worker.stop();
+
+  EXPECT_EQ(std::vector<uint32_t>({allowed_cpus.back()}), worker_cpus);
+}
+
 } // namespace Server
 } // namespace Envoy
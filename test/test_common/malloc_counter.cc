@@ -0,0 +1,49 @@
+#include "test/test_common/malloc_counter.h"
+
+#include <atomic>
+
+#include "common/common/assert.h"
+
+#ifdef TCMALLOC
+#include "gperftools/malloc_hook.h"
+#endif
+
+namespace Envoy {
+
+namespace {
+std::atomic<uint64_t> allocations{};
+std::atomic<bool> installed{};
+
+#ifdef TCMALLOC
+void onNew(const void*, size_t) { allocations.fetch_add(1, std::memory_order_relaxed); }
+#endif
+} // namespace
+
+MallocCounter::MallocCounter() {
+  RELEASE_ASSERT(!installed.exchange(true), "only one MallocCounter may exist at a time");
+  reset();
+#ifdef TCMALLOC
+  RELEASE_ASSERT(MallocHook::AddNewHook(&onNew), "");
+#endif
+}
+
+MallocCounter::~MallocCounter() {
+#ifdef TCMALLOC
+  MallocHook::RemoveNewHook(&onNew);
+#endif
+  installed = false;
+}
+
+uint64_t MallocCounter::count() const { return allocations.load(std::memory_order_relaxed); }
+
+void MallocCounter::reset() { allocations = 0; }
+
+bool MallocCounter::supported() {
+#ifdef TCMALLOC
+  return true;
+#else
+  return false;
+#endif
+}
+
+} // namespace Envoy
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Envoy {
+
+/**
+ * Counts the heap allocations made by the process while an instance is alive, for reporting
+ * allocations per operation in benchmarks. Counting uses tcmalloc's new hook; in builds without
+ * tcmalloc supported() is false and count() is always 0. Only one instance may exist at a time.
+ */
+class MallocCounter {
+public:
+  MallocCounter();
+  ~MallocCounter();
+
+  /**
+   * @return uint64_t the number of allocations made since construction or the last reset().
+   */
+  uint64_t count() const;
+
+  void reset();
+
+  /**
+   * @return bool whether allocations can be counted in this build.
+   */
+  static bool supported();
+};
+
+} // namespace Envoy